@@ -4,6 +4,8 @@
 
 #include "minorGems/util/SimpleVector.h"
 
+#include <stdint.h>
+
 
 
 // Interface for game states that can be fed into functions in minMax.h
@@ -28,6 +30,17 @@ class GameState {
 
         virtual void printState() = 0;
         
+
+        // hash of this state for the transposition table in
+        // minMaxPickMoveIterative, or 0 (the default) if states
+        // can't be hashed, which leaves the table unused
+        //
+        // Equal states must hash equally, including whose turn it is.
+        // See ZobristKeys.h for building one incrementally.
+        virtual uint64_t hash() {
+            return 0;
+            }
+        
     };
 
 
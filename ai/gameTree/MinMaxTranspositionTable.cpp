@@ -0,0 +1,80 @@
+#include "MinMaxTranspositionTable.h"
+
+#include <string.h>
+
+
+
+MinMaxTranspositionTable::MinMaxTranspositionTable( int inLog2NumEntries )
+        : mSlotMask( ( (uint64_t)1 << inLog2NumEntries ) - 1 ),
+          mAge( 0 ) {
+    
+    mEntries = new MinMaxTableEntry[ mSlotMask + 1 ];
+    
+    clear();
+    }
+
+
+
+MinMaxTranspositionTable::~MinMaxTranspositionTable() {
+    delete [] mEntries;
+    }
+
+
+
+void MinMaxTranspositionTable::clear() {
+    // hash of 0 is never stored (GameState::hash uses it for "none")
+    memset( mEntries, 0, ( mSlotMask + 1 ) * sizeof( MinMaxTableEntry ) );
+    }
+
+
+
+void MinMaxTranspositionTable::newSearch() {
+    mAge++;
+    }
+
+
+
+char MinMaxTranspositionTable::probe( uint64_t inHash, 
+                                      MinMaxTableEntry *outEntry ) {
+    uint64_t slot = inHash & mSlotMask;
+    MutexLock *lock = &( mLocks[ slot % MIN_MAX_TABLE_LOCKS ] );
+    
+    lock->lock();
+    *outEntry = mEntries[ slot ];
+    lock->unlock();
+
+    return ( outEntry->hash == inHash );
+    }
+
+
+
+void MinMaxTranspositionTable::store( uint64_t inHash, int inScore, 
+                                      int inDepth,
+                                      MinMaxBound inBound, 
+                                      int inBestMove ) {
+    uint64_t slot = inHash & mSlotMask;
+    MutexLock *lock = &( mLocks[ slot % MIN_MAX_TABLE_LOCKS ] );
+    
+    lock->lock();
+
+    MinMaxTableEntry *entry = &( mEntries[ slot ] );
+    
+    if( entry->hash == 0 || 
+        entry->age != mAge || 
+        inDepth >= entry->depth ) {
+        
+        if( inBestMove == -1 && entry->hash == inHash ) {
+            // keep the move from an earlier search of this state
+            inBestMove = entry->bestMove;
+            }
+        
+        entry->hash = inHash;
+        entry->score = inScore;
+        entry->depth = (short)inDepth;
+        entry->bestMove = (short)inBestMove;
+        entry->bound = (char)inBound;
+        entry->age = mAge;
+        }
+    
+    lock->unlock();
+    }
@@ -0,0 +1,93 @@
+#ifndef MIN_MAX_TRANSPOSITION_TABLE_INCLUDED
+#define MIN_MAX_TRANSPOSITION_TABLE_INCLUDED
+
+
+#include "minorGems/system/MutexLock.h"
+
+#include <stdint.h>
+
+
+
+// what a stored score says about the true score of a state
+enum MinMaxBound {
+    minMaxExact,
+    // true score is at least the stored score
+    minMaxLowerBound,
+    // true score is at most the stored score
+    minMaxUpperBound };
+
+
+
+typedef struct MinMaxTableEntry {
+        uint64_t hash;
+        
+        int score;
+        
+        // remaining search depth when score was found
+        short depth;
+        
+        // index into getPossibleMoves of the best move found, or -1
+        short bestMove;
+        
+        char bound;
+        
+        // search that stored this entry, see newSearch
+        unsigned char age;
+    } MinMaxTableEntry;
+
+
+
+// number of locks that table slots are spread across
+#define MIN_MAX_TABLE_LOCKS 64
+
+
+
+// Fixed-size table of search results keyed by GameState::hash, so that
+// positions reached by different move orders are only searched once,
+// and the best move from a shallower search is tried first in a
+// deeper one.
+//
+// Keeps one entry per slot, preferring deeper results from the current
+// search over older or shallower ones.
+//
+// Thread-safe, so root moves can be searched in parallel against one
+// table.
+class MinMaxTranspositionTable {
+    public:
+        
+        // inLog2NumEntries of 20 gives about a million entries (24 MiB)
+        MinMaxTranspositionTable( int inLog2NumEntries = 20 );
+        
+        ~MinMaxTranspositionTable();
+        
+        
+        // empties the table
+        void clear();
+        
+        
+        // marks entries stored so far as belonging to an older search,
+        // so new results replace them first
+        //
+        // Called by minMaxPickMoveIterative at the start of each search.
+        void newSearch();
+        
+
+        // gets the entry for inHash, returning true if there was one
+        char probe( uint64_t inHash, MinMaxTableEntry *outEntry );
+        
+
+        void store( uint64_t inHash, int inScore, int inDepth,
+                    MinMaxBound inBound, int inBestMove );
+        
+
+    protected:
+        MinMaxTableEntry *mEntries;
+        uint64_t mSlotMask;
+        
+        unsigned char mAge;
+
+        MutexLock mLocks[ MIN_MAX_TABLE_LOCKS ];
+    };
+
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef ZOBRIST_KEYS_INCLUDED
+#define ZOBRIST_KEYS_INCLUDED
+
+
+#include <stdint.h>
+
+
+
+// Random 64-bit keys for Zobrist hashing of game states.
+//
+// Number the features a state can have (for example,
+// square * numPieceTypes + piece, plus one for "player 2 to move"), and
+// the hash of a state is the XOR of the keys of the features it has.
+// A move then updates the hash by XORing out the features it removes and
+// XORing in the ones it adds.
+//
+// Keys come from a fixed seed, so hashes are the same from run to run.
+class ZobristKeys {
+    public:
+        
+        ZobristKeys( int inNumFeatures, uint64_t inSeed = 0x5eedULL )
+                : mNumFeatures( inNumFeatures ),
+                  mKeys( new uint64_t[ inNumFeatures ] ) {
+            
+            // splitmix64
+            uint64_t state = inSeed;
+            
+            for( int i=0; i<inNumFeatures; i++ ) {
+                state += 0x9E3779B97F4A7C15ULL;
+                
+                uint64_t z = state;
+                z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+                z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBULL;
+                z = z ^ ( z >> 31 );
+                
+                // 0 is reserved for "not hashable" in GameState::hash
+                if( z == 0 ) {
+                    z = 1;
+                    }
+                mKeys[i] = z;
+                }
+            }
+        
+        
+        ~ZobristKeys() {
+            delete [] mKeys;
+            }
+        
+        
+        uint64_t getKey( int inFeature ) {
+            return mKeys[ inFeature ];
+            }
+        
+
+        int getNumFeatures() {
+            return mNumFeatures;
+            }
+        
+
+    protected:
+        int mNumFeatures;
+        uint64_t *mKeys;
+    };
+
+
+#endif
@@ -1,6 +1,9 @@
 
 #include "minMax.h"
 
+#include "minorGems/system/MutexLock.h"
+#include "minorGems/system/Time.h"
+
 
 static MinOrMax switchSide( MinOrMax inSide ) {
     if( inSide == min ) {
@@ -272,3 +275,430 @@ int minMax( GameState *inCurrentState, MinOrMax inSide,
     }
 
 
+
+
+
+
+
+// alpha-beta with transposition table, for minMaxPickMoveIterative
+
+
+// how often searches check the clock
+#define MIN_MAX_NODES_PER_TIME_CHECK 256
+
+// remaining depth at which moves are worth ordering by their scores
+// (below it, scoring each move costs about as much as searching it)
+#define MIN_MAX_MIN_ORDERING_DEPTH 2
+
+
+// XORed into hashes of states with min to move, so that the same
+// position with different players to move doesn't share an entry
+#define MIN_MAX_MIN_TO_MOVE_KEY 0x2545F4914F6CDD1DULL
+
+
+
+// state of one thread's search
+typedef struct MinMaxSearch {
+        MinMaxTranspositionTable *table;
+        
+        // -1 for none
+        double deadline;
+        
+        // set by any thread that sees the deadline pass
+        volatile char *aborted;
+        
+        int nodesSinceTimeCheck;
+    } MinMaxSearch;
+
+
+
+// fills outOrder with the indices of inMoves in the order to search them:
+// inFirstMove first (if not -1), then best-scoring for inSide
+static void orderMoves( SimpleVector<GameState *> *inMoves, MinOrMax inSide,
+                        int inDepthLimit, int inFirstMove, int *outOrder ) {
+    
+    int numMoves = inMoves->size();
+    
+    for( int i=0; i<numMoves; i++ ) {
+        outOrder[i] = i;
+        }
+
+    if( inDepthLimit >= MIN_MAX_MIN_ORDERING_DEPTH ) {
+        int *scores = new int[ numMoves ];
+        
+        for( int i=0; i<numMoves; i++ ) {
+            scores[i] = ( *( inMoves->getElement( i ) ) )->getScore();
+            }
+        
+        // insertion sort, stable so that equal moves stay in
+        // getPossibleMoves order
+        for( int i=1; i<numMoves; i++ ) {
+            int index = outOrder[i];
+            int score = scores[ index ];
+            
+            int j = i - 1;
+            while( j >= 0 && 
+                   ( ( inSide == max && scores[ outOrder[j] ] < score ) ||
+                     ( inSide == min && scores[ outOrder[j] ] > score ) ) ) {
+                outOrder[ j + 1 ] = outOrder[j];
+                j--;
+                }
+            outOrder[ j + 1 ] = index;
+            }
+        
+        delete [] scores;
+        }
+
+    if( inFirstMove >= 0 && inFirstMove < numMoves ) {
+        // move it to the front, keeping the rest in order
+        int j = 0;
+        while( outOrder[j] != inFirstMove ) {
+            j++;
+            }
+        for( ; j>0; j-- ) {
+            outOrder[j] = outOrder[ j - 1 ];
+            }
+        outOrder[0] = inFirstMove;
+        }
+    }
+
+
+
+// fail-soft alpha-beta, storing results in the table
+//
+// inMin and inMax are the alpha and beta bounds:  scores outside of them
+// are only bounds themselves.
+static int alphaBeta( MinMaxSearch *inSearch, GameState *inCurrentState, 
+                      MinOrMax inSide, int inDepthLimit,
+                      int inMin, int inMax ) {
+    
+    if( *( inSearch->aborted ) ) {
+        return 0;
+        }
+    
+    if( inSearch->deadline >= 0 ) {
+        inSearch->nodesSinceTimeCheck++;
+        
+        if( inSearch->nodesSinceTimeCheck >= MIN_MAX_NODES_PER_TIME_CHECK ) {
+            inSearch->nodesSinceTimeCheck = 0;
+            
+            if( Time::getCurrentTime() > inSearch->deadline ) {
+                *( inSearch->aborted ) = true;
+                return 0;
+                }
+            }
+        }
+    
+    if( inDepthLimit == 0 || inCurrentState->getGameOver() ) {
+        return inCurrentState->getScore();
+        }
+    
+
+    uint64_t hash = 0;
+    int tableMove = -1;
+    
+    if( inSearch->table != NULL ) {
+        hash = inCurrentState->hash();
+        
+        if( hash != 0 ) {
+            if( inSide == min ) {
+                hash ^= MIN_MAX_MIN_TO_MOVE_KEY;
+                }
+            
+            MinMaxTableEntry entry;
+            
+            if( inSearch->table->probe( hash, &entry ) ) {
+                tableMove = entry.bestMove;
+                
+                if( entry.depth >= inDepthLimit ) {
+                    if( entry.bound == minMaxExact ||
+                        ( entry.bound == minMaxLowerBound &&
+                          entry.score >= inMax ) ||
+                        ( entry.bound == minMaxUpperBound &&
+                          entry.score <= inMin ) ) {
+                        return entry.score;
+                        }
+                    }
+                }
+            }
+        }
+    
+
+    SimpleVector<GameState *> possibleMoves = 
+        inCurrentState->getPossibleMoves();
+    
+    int numMoves = possibleMoves.size();
+
+    if( numMoves == 0 ) {
+        // leaf
+        return inCurrentState->getScore();
+        }
+    
+    int *order = new int[ numMoves ];
+    orderMoves( &possibleMoves, inSide, inDepthLimit, tableMove, order );
+
+    int originalMin = inMin;
+    int originalMax = inMax;
+    
+    int bestScoreSeen = INT_MAX;
+    if( inSide == max ) {
+        bestScoreSeen = INT_MIN;
+        }
+    int bestMove = -1;
+    
+    for( int i=0; i<numMoves; i++ ) {
+        int m = order[i];
+        
+        int score = alphaBeta( inSearch, 
+                               *( possibleMoves.getElement( m ) ),
+                               switchSide( inSide ),
+                               inDepthLimit - 1, inMin, inMax );
+        
+        if( inSide == max ) {
+            if( bestMove == -1 || score > bestScoreSeen ) {
+                bestScoreSeen = score;
+                bestMove = m;
+                }
+            if( bestScoreSeen > inMin ) {
+                inMin = bestScoreSeen;
+                }
+            }
+        else {
+            if( bestMove == -1 || score < bestScoreSeen ) {
+                bestScoreSeen = score;
+                bestMove = m;
+                }
+            if( bestScoreSeen < inMax ) {
+                inMax = bestScoreSeen;
+                }
+            }
+        
+        if( inMin >= inMax ) {
+            break;
+            }
+        }
+    
+    for( int i=0; i<numMoves; i++ ) {
+        delete *( possibleMoves.getElement( i ) );
+        }
+    delete [] order;
+    
+    
+    if( hash != 0 && ! *( inSearch->aborted ) ) {
+        MinMaxBound bound = minMaxExact;
+        
+        if( bestScoreSeen <= originalMin ) {
+            bound = minMaxUpperBound;
+            }
+        else if( bestScoreSeen >= originalMax ) {
+            bound = minMaxLowerBound;
+            }
+        
+        inSearch->table->store( hash, bestScoreSeen, inDepthLimit, bound,
+                                bestMove );
+        }
+
+    return bestScoreSeen;
+    }
+
+
+
+// one depth of the search over the root's moves
+typedef struct MinMaxRootJob {
+        MinMaxSearch search;
+        
+        SimpleVector<GameState *> *moves;
+        
+        // order to search moves in
+        int *order;
+        
+        MinOrMax side;
+        int depthLimit;
+        
+        // guards the fields below, when searching in parallel
+        MutexLock lock;
+        
+        int bestScore;
+        // -1 until a move is searched
+        int bestMove;
+        
+        // score of each move, exact for the best one and bounds for the
+        // rest
+        int *scores;
+    } MinMaxRootJob;
+
+
+
+static void searchRootMove( MinMaxRootJob *inJob, int inOrderIndex ) {
+    
+    // own copy, for the node counter
+    MinMaxSearch search = inJob->search;
+    
+    int m = inJob->order[ inOrderIndex ];
+    
+    inJob->lock.lock();
+    int bound = inJob->bestScore;
+    char first = ( inJob->bestMove == -1 );
+    inJob->lock.unlock();
+    
+    // only a move better than the best so far matters
+    int lowBound = INT_MIN;
+    int highBound = INT_MAX;
+    if( ! first ) {
+        if( inJob->side == max ) {
+            lowBound = bound;
+            }
+        else {
+            highBound = bound;
+            }
+        }
+    
+    int score = alphaBeta( &search, *( inJob->moves->getElement( m ) ),
+                           switchSide( inJob->side ), 
+                           inJob->depthLimit - 1, lowBound, highBound );
+    
+    inJob->lock.lock();
+    
+    inJob->scores[m] = score;
+    
+    // ties keep the earlier best, whose score is exact (a tied later
+    // score is only a bound)
+    if( inJob->bestMove == -1 ||
+        ( inJob->side == max && score > inJob->bestScore ) ||
+        ( inJob->side == min && score < inJob->bestScore ) ) {
+        
+        inJob->bestScore = score;
+        inJob->bestMove = m;
+        }
+    
+    inJob->lock.unlock();
+    }
+
+
+
+// ThreadPoolRangeFunction over root moves after the first
+static void searchRootMoveRange( void *inJob, int inStart, int inEnd ) {
+    for( int i=inStart; i<inEnd; i++ ) {
+        searchRootMove( (MinMaxRootJob *)inJob, i + 1 );
+        }
+    }
+
+
+
+GameState *minMaxPickMoveIterative( GameState *inCurrentState, 
+                                    MinOrMax inSide,
+                                    int inMaxDepth,
+                                    double inTimeLimitSeconds,
+                                    MinMaxTranspositionTable *inTable,
+                                    ThreadPool *inRootPool,
+                                    int *outDepthReached ) {
+    double startTime = Time::getCurrentTime();
+    
+    SimpleVector<GameState *> possibleMoves = 
+        inCurrentState->getPossibleMoves();
+    
+    int numMoves = possibleMoves.size();
+
+    if( numMoves == 0 ) {
+        // no moves left, game over?
+        return NULL;
+        }
+
+    if( inTable != NULL ) {
+        inTable->newSearch();
+        }
+    
+    volatile char aborted = false;
+    
+    int *order = new int[ numMoves ];
+    int *scores = new int[ numMoves ];
+    
+    // start with the best moves by score
+    orderMoves( &possibleMoves, inSide, MIN_MAX_MIN_ORDERING_DEPTH, -1,
+                order );
+    
+    int bestMove = order[0];
+    int depthReached = 0;
+    
+    for( int depth=1; depth<=inMaxDepth; depth++ ) {
+        
+        MinMaxRootJob job;
+        job.search.table = inTable;
+        job.search.deadline = -1;
+        job.search.aborted = &aborted;
+        job.search.nodesSinceTimeCheck = 0;
+        
+        // depth 1 always finishes, so there is a move to return
+        if( inTimeLimitSeconds >= 0 && depth > 1 ) {
+            job.search.deadline = startTime + inTimeLimitSeconds;
+            }
+        
+        job.moves = &possibleMoves;
+        job.order = order;
+        job.side = inSide;
+        job.depthLimit = depth;
+        job.bestScore = 0;
+        job.bestMove = -1;
+        job.scores = scores;
+        
+        // first move sets the bound that the rest are searched against
+        searchRootMove( &job, 0 );
+        
+        if( inRootPool != NULL && numMoves > 1 ) {
+            inRootPool->parallelFor( searchRootMoveRange, &job,
+                                     numMoves - 1 );
+            }
+        else {
+            searchRootMoveRange( &job, 0, numMoves - 1 );
+            }
+        
+        if( aborted ) {
+            break;
+            }
+        
+        bestMove = job.bestMove;
+        depthReached = depth;
+
+        // best first next time, then the rest by their scores
+        scores[ bestMove ] = ( inSide == max ) ? INT_MAX : INT_MIN;
+        
+        for( int i=1; i<numMoves; i++ ) {
+            int index = order[i];
+            int j = i - 1;
+            while( j >= 0 && 
+                   ( ( inSide == max && 
+                       scores[ order[j] ] < scores[ index ] ) ||
+                     ( inSide == min && 
+                       scores[ order[j] ] > scores[ index ] ) ) ) {
+                order[ j + 1 ] = order[j];
+                j--;
+                }
+            order[ j + 1 ] = index;
+            }
+        
+        if( inTimeLimitSeconds >= 0 ) {
+            double elapsed = Time::getCurrentTime() - startTime;
+            
+            // each depth takes several times longer than the one
+            // before, so the next is unlikely to finish
+            if( elapsed > inTimeLimitSeconds / 2 ) {
+                break;
+                }
+            }
+        }
+    
+    delete [] order;
+    delete [] scores;
+    
+    for( int i=0; i<numMoves; i++ ) {
+        if( i != bestMove ) {
+            delete *( possibleMoves.getElement( i ) );
+            }
+        }
+    
+    if( outDepthReached != NULL ) {
+        *outDepthReached = depthReached;
+        }
+    
+    return *( possibleMoves.getElement( bestMove ) );
+    }
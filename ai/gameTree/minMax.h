@@ -1,5 +1,8 @@
 
 #include "GameState.h"
+#include "MinMaxTranspositionTable.h"
+
+#include "minorGems/system/ThreadPool.h"
 
 #include <limits.h>
 
@@ -28,3 +31,42 @@ int minMax( GameState *inCurrentState, MinOrMax inSide,
             int inMin = INT_MIN,
             int inMax = INT_MAX );
 
+
+
+// Picks a move with iterative deepening alpha-beta search:  searches to
+// depth 1, then 2, and so on, trying the best moves from the previous
+// depth first, until inMaxDepth is done or time runs out.
+//
+// Much deeper than minMaxPickMove in the same time, but picks the same
+// move only up to ties between equally scored moves.
+//
+// inMaxDepth is in plies, counting the move picked (1 looks only at the
+// states the possible moves lead to).
+//
+// inTimeLimitSeconds stops the search once it runs out, returning the
+// move from the deepest depth finished.  Depth 1 is always finished.
+// -1 (the default) for no limit.
+//
+// inTable, if not NULL, is used to skip positions already searched, and
+// to order moves.  Only used for states whose hash() is not 0, and
+// moves are recorded by getPossibleMoves index, so getPossibleMoves must
+// return moves in the same order each time for a state.  Can be kept
+// between calls.
+//
+// inRootPool, if not NULL, searches the picked-from state's moves in
+// parallel on the pool (after the first, which sets the bound for the
+// rest).  GameState implementations must then allow different states to
+// be used from different threads at once.  Moves that tie may be picked
+// differently from run to run.
+//
+// outDepthReached, if not NULL, is set to the deepest depth finished.
+//
+// Returns the picked move, destroyed by caller, or NULL if there are no
+// moves.
+GameState *minMaxPickMoveIterative( GameState *inCurrentState, 
+                                    MinOrMax inSide,
+                                    int inMaxDepth,
+                                    double inTimeLimitSeconds = -1,
+                                    MinMaxTranspositionTable *inTable = NULL,
+                                    ThreadPool *inRootPool = NULL,
+                                    int *outDepthReached = NULL );
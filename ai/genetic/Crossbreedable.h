@@ -3,6 +3,9 @@
  *
  * 2000-September-9		Jason Rohrer
  * Created.
+ *
+ * 2026-October-15		Jason Rohrer
+ * Added crossbreedInto for refilling an existing population member.
  */
 
 #ifndef CROSSBREEDABLE_INCLUDED
@@ -49,6 +52,28 @@ class Crossbreedable {
 		virtual void *crossbreed( Crossbreedable *inOther, 
 			float inFractionOther, float inMutationProb,
 			float inMaxMutationMagnitude ) = 0;
+		
+		/**
+		 * Crossbreeds this Crossbreedable with another, overwriting
+		 * an existing Crossbreedable with the offspring instead of
+		 * allocating a new one.  Draws the same random numbers as
+		 * crossbreed, so results match.
+		 *
+		 * Default implementation does nothing and returns false, so callers
+		 * should fall back to crossbreed.
+		 *
+		 * @param inOther the other Crossbreedable to cross this one with.
+		 * @param inOffspring the Crossbreedable to replace with the
+		 *   offspring.  Must not be this or inOther.
+		 * @param inFractionOther, inMutationProb, inMaxMutationMagnitude
+		 *   as in crossbreed.
+		 * @return true if inOffspring now holds the offspring, or false
+		 *   if it was left unchanged.
+		 */
+		virtual char crossbreedInto( Crossbreedable *inOther,
+			Crossbreedable *inOffspring,
+			float inFractionOther, float inMutationProb,
+			float inMaxMutationMagnitude );
 			
 		/**
 		 * Mutates this Crossbreedable.
@@ -102,6 +127,14 @@ inline Crossbreedable::Crossbreedable( FILE *inInputFile ) {
 	fscanf( inInputFile, "%d", &mGeneration );
 	}
 
+inline char Crossbreedable::crossbreedInto( Crossbreedable *inOther,
+	Crossbreedable *inOffspring,
+	float inFractionOther, float inMutationProb,
+	float inMaxMutationMagnitude ) {
+	
+	return false;
+	}
+
 inline int Crossbreedable::getGeneration() {
 	return mGeneration;
 	}
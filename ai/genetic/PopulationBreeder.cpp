@@ -3,6 +3,10 @@
  *
  * 2000-October-23		Jason Rohrer
  * Created.
+ *
+ * 2026-October-15		Jason Rohrer
+ * Offspring overwrite the members they replace when the members support
+ * crossbreedInto, instead of being deleted and reallocated.
  */
  
 #include "PopulationBreeder.h"
@@ -51,18 +55,26 @@ void PopulationBreeder::breedPopulation( Crossbreedable** inPopulation,
 			//printf( "deleting %d\n", indNextReplace );
 			// delete member in bottom segment of population
 			//inDeleter->deleteCrossbreedable( inPopulation[indNextReplace] );
-			inDeleter->deleteCrossbreedable( indNextReplace );
 			
-			void *offspring = 
-				inPopulation[a]->crossbreed( inPopulation[b], 
-					0.5f, inMutationProb,
-					inMaxMutationMagnitude );	
+			// reuse the replaced member's storage if possible
+			char reused = inPopulation[a]->crossbreedInto( 
+				inPopulation[b], inPopulation[indNextReplace],
+				0.5f, inMutationProb, inMaxMutationMagnitude );
 			
-			//int generation = inPopulation[a]->getGeneration();
-			//printf( "generation = %d\n", generation );
-			// insert offspring into population
-			//inPopulation[indNextReplace] = (Crossbreedable *)offspring;
-			inDeleter->addCrossbreedable( indNextReplace, offspring );
+			if( !reused ) {
+				inDeleter->deleteCrossbreedable( indNextReplace );
+				
+				void *offspring = 
+					inPopulation[a]->crossbreed( inPopulation[b], 
+						0.5f, inMutationProb,
+						inMaxMutationMagnitude );	
+				
+				//int generation = inPopulation[a]->getGeneration();
+				//printf( "generation = %d\n", generation );
+				// insert offspring into population
+				//inPopulation[indNextReplace] = (Crossbreedable *)offspring;
+				inDeleter->addCrossbreedable( indNextReplace, offspring );
+				}
 			
 			indNextReplace++;
 			}
@@ -7,10 +7,30 @@
  * 2000-November-5		Jason Rohrer
  * Added support for sorting in two different orders (increasing
  * and decreasing order).
+ *
+ * 2026-October-15		Jason Rohrer
+ * Added selectTopMembers.
+ * Both sorts share one score comparison.
  */
 
 #include "PopulationSorter.h"
 
+
+
+// true if inScore belongs in front of inOtherScore
+static inline char isBetter( double inScore, double inOtherScore,
+	char inDecreasingOrder ) {
+
+	if( inDecreasingOrder ) {
+		return inScore > inOtherScore;
+		}
+	else {
+		return inScore < inOtherScore;
+		}
+	}
+
+
+
 void PopulationSorter::sortPopulation( PopulationMember** inPopulation, 
 	double* inScores, int inPopulationSize, char inDecreasingOrder ) {
 
@@ -25,8 +45,7 @@ void PopulationSorter::sortPopulation( PopulationMember** inPopulation,
 		int bestInd = t;
 		
 		for( int u=t+1; u<inPopulationSize; u++ ) {
-			if( !inDecreasingOrder && inScores[u] < best
-				|| inDecreasingOrder && inScores[u] > best ) {
+			if( isBetter( inScores[u], best, inDecreasingOrder ) ) {
 				best = inScores[u];
 				bestInd = u;
 				}
@@ -42,3 +61,82 @@ void PopulationSorter::sortPopulation( PopulationMember** inPopulation,
 			}
 		}
 	}
+
+
+
+// swaps two members and their scores
+static inline void swapMembers( PopulationMember** inPopulation, 
+	double* inScores, int inA, int inB ) {
+	
+	PopulationMember *tempMember = inPopulation[inA];
+	inPopulation[inA] = inPopulation[inB];
+	inPopulation[inB] = tempMember;
+	
+	double tempScore = inScores[inA];
+	inScores[inA] = inScores[inB];
+	inScores[inB] = tempScore;
+	}
+
+
+
+void PopulationSorter::selectTopMembers( PopulationMember** inPopulation, 
+	double* inScores, int inPopulationSize, int inNumTop,
+	char inDecreasingOrder ) {
+
+	if( inNumTop >= inPopulationSize ) {
+		sortPopulation( inPopulation, inScores, inPopulationSize,
+			inDecreasingOrder );
+		return;
+		}
+	if( inNumTop <= 0 ) {
+		return;
+		}
+	
+	// quickselect:  partition until the member at inNumTop - 1 is
+	// in its sorted position, with everything better in front of it
+	int low = 0;
+	int high = inPopulationSize - 1;
+	int target = inNumTop - 1;
+	
+	while( low < high ) {
+		// median of three pivot, moved to high
+		int mid = low + ( high - low ) / 2;
+		
+		double a = inScores[low];
+		double b = inScores[mid];
+		double c = inScores[high];
+		
+		int pivotInd;
+		if( a < b ) {
+			pivotInd = ( b < c ) ? mid : ( ( a < c ) ? high : low );
+			}
+		else {
+			pivotInd = ( a < c ) ? low : ( ( b < c ) ? high : mid );
+			}
+		swapMembers( inPopulation, inScores, pivotInd, high );
+		
+		double pivot = inScores[high];
+		
+		int store = low;
+		for( int i=low; i<high; i++ ) {
+			if( isBetter( inScores[i], pivot, inDecreasingOrder ) ) {
+				swapMembers( inPopulation, inScores, i, store );
+				store++;
+				}
+			}
+		swapMembers( inPopulation, inScores, store, high );
+		
+		if( store == target ) {
+			break;
+			}
+		else if( store < target ) {
+			low = store + 1;
+			}
+		else {
+			high = store - 1;
+			}
+		}
+	
+	// top members are all at the front, now put them in order
+	sortPopulation( inPopulation, inScores, inNumTop, inDecreasingOrder );
+	}
@@ -7,6 +7,9 @@
  * 2000-November-5		Jason Rohrer
  * Added support for sorting in two different orders (increasing
  * and decreasing order).
+ *
+ * 2026-October-15		Jason Rohrer
+ * Added selectTopMembers for when only the best few need to be in order.
  */
  
 #ifndef POPULATION_SORTER_INCLUDED
@@ -30,6 +33,25 @@ class PopulationSorter {
 		void sortPopulation( PopulationMember** inPopulation, 
 			double* inScores, int inPopulationSize, 
 			char inDecreasingOrder=false );
+		
+		/**
+		 * Moves the best inNumTop members of a population to the front
+		 * in sorted order, leaving the rest behind them in no particular
+		 * order.  Runs in linear time plus the cost of sorting
+		 * inNumTop members, so it is much cheaper than sortPopulation
+		 * when only the top of the population is used.
+		 *
+		 * @param inPopulation array of population members.
+		 * @param inScores array of scores associated with each population
+		 *   member (rearranged along with the members).
+		 * @param inPopulationSize size of population.
+		 * @param inNumTop number of members to select.
+		 * @param inDecreasingOrder set to true if higher scores are
+		 *   better (default is false).
+		 */ 
+		void selectTopMembers( PopulationMember** inPopulation, 
+			double* inScores, int inPopulationSize, int inNumTop,
+			char inDecreasingOrder=false );
 	};
 
 #endif
@@ -18,6 +18,10 @@
  * 2000-December-11		Jason Rohrer
  * Fixed a major bug that prevented crossbreeding type from being passed
  * down to offspring.  
+ *
+ * 2026-October-15		Jason Rohrer
+ * Added crossbreedInto, which refills an existing network with the
+ * offspring.  crossbreed now allocates a network and calls it.
  */
 
 
@@ -252,26 +256,84 @@ void *BreedableFeedForwardNeuralNet::crossbreed( Crossbreedable *inOther,
 	float inFractionOther, float inMutationProb,
 	float inMaxMutationMagnitude ) {
 	
+	BreedableFeedForwardNeuralNet *offspring =
+		new BreedableFeedForwardNeuralNet( mNumInputs, mNumHiddenLayers,
+			&( mNeuronsPerLayer[1] ), mNumOutputs, mRandSource );
+	
+	if( !crossbreedInto( inOther, offspring, inFractionOther,
+						 inMutationProb, inMaxMutationMagnitude ) ) {
+		delete offspring;
+		return NULL;
+		}
+	
+	return (void *)offspring;
+	}
+
+
+
+char BreedableFeedForwardNeuralNet::isSameShape( 
+	BreedableFeedForwardNeuralNet *inOther ) {
+	
+	if( mNumHiddenLayers != inOther->getNumHiddenLayers() ) {
+		return false;
+		}
+
+	int totalNumLayers = mNumHiddenLayers + 2;
+	for( int i=0; i<totalNumLayers; i++ ) {
+		if( mNeuronsPerLayer[i] != inOther->getNumInLayer( i ) ) {
+			return false;
+			}
+		}
+	return true;
+	}
+
+
+
+void BreedableFeedForwardNeuralNet::clearToConstructedState() {
+	int totalNumLayers = mNumHiddenLayers + 2;
+	
+	for( int i=0; i<totalNumLayers; i++ ) {
+		if( i<totalNumLayers - 1 ) {
+			memset( mWeightMatrices[i], 0, 
+					mNeuronsPerLayer[i] * mNeuronsPerLayer[i+1] * 
+					sizeof( double ) );
+			}
+		for( int j=0; j<mNeuronsPerLayer[i]; j++ ) {
+			mNeuronThresholds[i][j] = StepThreshold::getInstance();
+			mNeuronThresholdValues[i][j] = 0.0;
+			}
+		}
+	
+	mGeneration = 0;
+	}
+
+
+
+char BreedableFeedForwardNeuralNet::crossbreedInto( Crossbreedable *inOther,
+	Crossbreedable *inOffspring,
+	float inFractionOther, float inMutationProb,
+	float inMaxMutationMagnitude ) {
+	
 	BreedableFeedForwardNeuralNet *otherNet =
 			dynamic_cast< BreedableFeedForwardNeuralNet* >( inOther );
+	BreedableFeedForwardNeuralNet *offspring =
+			dynamic_cast< BreedableFeedForwardNeuralNet* >( inOffspring );
 	
 	// make sure we can crossbreed with this Crossbreedable
-	if( otherNet == 0 ) {
-		return NULL;
+	if( otherNet == 0 || offspring == 0 ) {
+		return false;
+		}
+	if( offspring == this || offspring == otherNet ) {
+		return false;
 		}
 		
-	// make sure the other network is the same size as us
-	if( mNumHiddenLayers != otherNet->getNumHiddenLayers() ) {
-		return NULL;
+	// make sure the other network and offspring are the same size as us
+	if( !isSameShape( otherNet ) || !isSameShape( offspring ) ) {
+		return false;
 		}
 
 	int totalNumLayers = mNumHiddenLayers + 2;
 	int i;
-	for( i=0; i<totalNumLayers; i++ ) {
-		if( mNeuronsPerLayer[i] != otherNet->getNumInLayer( i ) ) {
-			return NULL;
-			}
-		}
 
 	// other network is correct size
 	
@@ -286,9 +348,10 @@ void *BreedableFeedForwardNeuralNet::crossbreed( Crossbreedable *inOther,
 	// this selection, an mark all selected neurons.
 	// When a neuron is selected, add it to offspring network
 	// along with all of its outbound weights.	
-	BreedableFeedForwardNeuralNet *offspring =
-		new BreedableFeedForwardNeuralNet( mNumInputs, mNumHiddenLayers,
-			&( mNeuronsPerLayer[1] ), mNumOutputs, mRandSource );
+	// start from a freshly constructed network, whatever the
+	// offspring held before
+	offspring->clearToConstructedState();
+	offspring->mRandSource = mRandSource;
 	
 	// offspring uses same crossbreeding proceedure as parents
 	offspring->setCrossbreedingMethod( mCrossbreedingMethod );
@@ -898,7 +961,7 @@ void *BreedableFeedForwardNeuralNet::crossbreed( Crossbreedable *inOther,
 		}
 		
 	//printf( "Offspring generation = %d\n", offspring->getGeneration() );
-	return (void *)offspring;
+	return true;
 	}
 			
 
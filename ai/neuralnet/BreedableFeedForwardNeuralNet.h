@@ -21,6 +21,9 @@
  *
  * 2000-December-13		Jason Rohrer  
  * Moved into minorGems.   
+ *
+ * 2026-October-15		Jason Rohrer
+ * Added crossbreedInto.
  */
 
 #ifndef BREEDABLE_FEED_FORWARD_NEURAL_NET_INCLUDED
@@ -117,6 +120,18 @@ class BreedableFeedForwardNeuralNet
 		void *crossbreed( Crossbreedable *inOther, 
 			float inFractionOther, float inMutationProb,
 			float inMaxMutationMagnitude );
+		
+		/**
+		 * Implements the Crossbredable::crossbreedInto interface.
+		 *
+		 * inOffspring must be a BreedableFeedForwardNeuralNet of the
+		 * same shape as this network.  Its weights, thresholds, ranges,
+		 * crossbreeding method and random source are all replaced.
+		 */	
+		char crossbreedInto( Crossbreedable *inOther, 
+			Crossbreedable *inOffspring,
+			float inFractionOther, float inMutationProb,
+			float inMaxMutationMagnitude );
 			
 		/**
 		 * Implements the Crossbredable::mutate interface.
@@ -194,6 +209,14 @@ class BreedableFeedForwardNeuralNet
 		void setCrossbreedingMethod( int inCrossbreedingMethod );
 		
 	private:
+		
+		// true if inOther has the same layers as this network
+		char isSameShape( BreedableFeedForwardNeuralNet *inOther );
+		
+		// resets weights, thresholds and generation to what the
+		// constructor sets
+		void clearToConstructedState();
+		
 		RandomSource *mRandSource;
 		
 		// range of possible threshold for each layer of the network
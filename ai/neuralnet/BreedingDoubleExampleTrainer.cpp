@@ -24,14 +24,81 @@
  *
  * 2000-December-13		Jason Rohrer  
  * Moved into minorGems.
+ *
+ * 2026-October-15		Jason Rohrer
+ * Each network runs all examples with one runBatch, and networks are
+ * evaluated in parallel on the shared ThreadPool.
+ * Only the members that survive a round are put in order, and offspring
+ * overwrite the networks they replace with crossbreedInto.
+ * Fixed the remainder in the numToBreed calculation, which counted
+ * numToBreed twice and replaced members that were still breeding.
  */
  
 #include "BreedingDoubleExampleTrainer.h"
 
 #include "minorGems/math/stats/L1ErrorEvaluator.h"
+
+#include "minorGems/system/ThreadPool.h"
  
 #include <math.h>
 #include <stdio.h>
+#include <string.h>
+
+
+
+typedef struct PopulationEvaluationJob {
+		BreedableFeedForwardNeuralNet **networks;
+		
+		// mExampleSetSize rows of example inputs
+		double *exampleInputs;
+		int numExamples;
+		
+		double *correctOutputs;
+		
+		ErrorEvaluator *errorEvaluator;
+		
+		double *populationError;
+	} PopulationEvaluationJob;
+
+
+
+// ThreadPoolRangeFunction over population members
+static void evaluateNetworks( void *inJob, int inStart, int inEnd ) {
+	PopulationEvaluationJob *job = (PopulationEvaluationJob *)inJob;
+	
+	int numExamples = job->numExamples;
+	
+	// output from a network on each example
+	// note that this only works for single output networks
+	double *individualOutput = new double[ numExamples ];
+	
+	for( int n=inStart; n<inEnd; n++ ) {
+		BreedableFeedForwardNeuralNet *network = job->networks[n];
+		
+		int numOutputs = network->getNumOutputs();
+		
+		double *networkOutputs = new double[ numExamples * numOutputs ];
+		
+		network->runBatch( numExamples, job->exampleInputs, 
+						   networkOutputs );
+		
+		// only take first output, since we're only supposed
+		// to work with single-output networks anyway
+		for( int e=0; e<numExamples; e++ ) {
+			individualOutput[e] = networkOutputs[ e * numOutputs ];
+			}
+		
+		delete [] networkOutputs;
+		
+		// now use ErrorEvaluator function to compute the error value
+		// over all training examples for this network in the population
+		// (evaluators are stateless, so they can be shared by threads)
+		job->populationError[n] = job->errorEvaluator->evaluate( 
+			job->correctOutputs, individualOutput, numExamples );
+		}
+	
+	delete [] individualOutput;
+	}
  
  
 BreedingDoubleExampleTrainer::BreedingDoubleExampleTrainer()
@@ -63,6 +130,30 @@ int BreedingDoubleExampleTrainer::train( int inMaxNumRounds,
 	int n;
 	int e;
 	
+	// each round, crossbreed top portion of the population to replace
+	// the bottom portion.
+	
+	// INCORRECT:
+	// Pick if there are n members of population, pick m to breed such that
+	// m + m + m-1 + m-2 + m-3 + ... + 1 = n
+	// m + (m(m+1))/2 = n
+	// 2m + m(m+1) = 2n
+	// m^2 + 3m - 2n = 0
+	// m = ( -3 +/- ( 9 + 8n )^(1/2) ) / 2
+	//int numToBreed = (int)( (-3 + sqrt( 9 + 8 * mPopulationSize ) ) * 0.5 );
+	
+	// CORRECT:
+	// Pick if there are n members of population, pick m to breed such that
+	// m + m-1 + m-2 + m-3 + ... + 1 = n
+	// (m(m+1))/2 = n
+	// m(m+1) = 2n
+	// m^2 + m - 2n = 0
+	// m = ( -1 +/- ( 1 + 8n )^(1/2) ) / 2
+	int numToBreed = (int)( (-1 + sqrt( 1 + 8 * mPopulationSize ) ) * 0.5 );
+	int remainder = mPopulationSize - 
+		(numToBreed * ( numToBreed + 1 ) ) / 2;
+	int startIndReplace = numToBreed + remainder;
+	
 	// for each round
 	for( r=0; r<inMaxNumRounds; r++ ) {
 		
@@ -72,6 +163,10 @@ int BreedingDoubleExampleTrainer::train( int inMaxNumRounds,
 		// correct output values from each training example
 		double *correctOutputs = new double[ mExampleSetSize ];
 		
+		// inputs from every training example, one row each, for runBatch
+		double *exampleInputs = NULL;
+		int numInputs = 0;
+		
 		// for each training example
 		for( e=0; e<mExampleSetSize; e++ ) { 
 			DoubleTrainingExample *example =
@@ -83,110 +178,58 @@ int BreedingDoubleExampleTrainer::train( int inMaxNumRounds,
 				}
 			
 			correctOutputs[e] = example->getOutput(0);
+			
+			if( exampleInputs == NULL ) {
+				numInputs = example->getNumInputs();
+				exampleInputs = new double[ mExampleSetSize * numInputs ];
+				}
+			memcpy( &( exampleInputs[ e * numInputs ] ), 
+					example->getInputs(), numInputs * sizeof( double ) );
 			}
 		
+		// note that this repeated casting is inefficient,
+		// but it preserves the abstraction, since we want to always
+		// be working with the array provided by PopulationTrainer
+		BreedableFeedForwardNeuralNet **networks = 
+			new BreedableFeedForwardNeuralNet*[ mPopulationSize ];
+		
 		// for each network in the population
 		for( n=0; n<mPopulationSize; n++ ) {
 			
-			populationError[n] = 0.0;
-			
-			// note that this repeated casting is inefficient,
-			// but it preserves the abstraction, since we want to always
-			// be working with the array provided by PopulationTrainer
-			
 			// cast the network to a BreedableFeedForwardNeuralNet
-			BreedableFeedForwardNeuralNet *network = 
+			networks[n] = 
 				dynamic_cast
 				< BreedableFeedForwardNeuralNet* >( mPopulation[n] );
-			if( network == 0 ) {
+			if( networks[n] == 0 ) {
 				// cast failed.
 				printf( "Casting a network in population to a ");
 				printf( "BreedableFeedForwardNeuralNet failed.\n" );
 				return errorReturn;
 				}
-			
-			// output from this network on each example
-			// note that this only works for single output networks
-			double *individualOutput = new double[ mExampleSetSize ];
-			
-			// for each training example
-			for( e=0; e<mExampleSetSize; e++ ) {
-				DoubleTrainingExample *example =
-					dynamic_cast < DoubleTrainingExample* >( mExamples[e] );
-				if( example == 0 ) {
-					printf( "Casting a training example to a ");
-					printf( "DoubleTrainingExample failed.\n" );
-					return errorReturn;
-					}
-				
-				int numOutputs = example->getNumOutputs();
-				
-				double *networkOutputs = new double[numOutputs];
-				
-				network->run( example->getInputs(), networkOutputs );
-				
-				// only take first output, since we're only supposed
-				// to work with single-output networks anyway
-				individualOutput[e] = networkOutputs[0];
-				
-			/*	double sumCorrectOutputs = 0;
-				double error = 0;
-				for( int o=0; o<numOutputs; o++ ) {
-					double thisOutput = example->getOutput(o);
-					double thisError = thisOutput - networkOutputs[o];
-					/*if( n== mPopulationSize -1 ) {
-						printf( "Correct output = %f, good network output ",
-							thisOutput );
-						printf( "= %f\n", networkOutputs[o] );
-						}
-					*/
-			/*		if( thisOutput < 0 ) {
-						thisOutput = -thisOutput;
-						}
-					sumCorrectOutputs += thisOutput;
-					
-					if( thisError < 0 ) {
-						thisError = -thisError;
-						}
-					error += thisError;
-			
-					}
-			*/
-				//printf( "error=%f   ", error );
-				//populationError[n] += error;// / sumCorrectOutputs);
-				
-				delete [] networkOutputs;
-				}
-			
-			// now use ErrorEvaluator function to compute the error value
-			// over all training examples for this network in the population
-			populationError[n] = mErrorEvaluator->evaluate( 
-									correctOutputs, individualOutput, mExampleSetSize );
-			/*
-			if( n == mPopulationSize-1 ) {
-				printf( "best network score output:\n" );
-				for( e=0; e<mExampleSetSize; e++ ) {
-					printf( "%f  ", individualOutput[e] );
-					}
-				printf( "\n" );
-				
-				printf( "correct score output:\n" );
-				for( e=0; e<mExampleSetSize; e++ ) {
-					printf( "%f  ", correctOutputs[e] );
-					}
-				printf( "\n" );
-				}
-			*/		
-			delete [] individualOutput;
-				
-			// take average error;
-			// skip for now... total error may be more useful
-			//populationError[n] = populationError[n] / mExampleSetSize;
+			}
+		
+		PopulationEvaluationJob job;
+		job.networks = networks;
+		job.exampleInputs = exampleInputs;
+		job.numExamples = mExampleSetSize;
+		job.correctOutputs = correctOutputs;
+		job.errorEvaluator = mErrorEvaluator;
+		job.populationError = populationError;
+		
+		// returns once every network has been evaluated
+		ThreadPool::getSharedPool()->parallelFor( evaluateNetworks, &job,
+												  mPopulationSize );
+		
+		delete [] networks;
+		if( exampleInputs != NULL ) {
+			delete [] exampleInputs;
 			}
 		
 		// now have total error computed for each member of the population
 		
-		sortPopulation( populationError ); 
+		// members past startIndReplace are all replaced below, so only
+		// the survivors need to be in order
+		selectTopOfPopulation( populationError, startIndReplace ); 
 		
 		Crossbreedable *crossbreedableTopNetwork =
 			dynamic_cast<Crossbreedable *>( mPopulation[0] );
@@ -238,30 +281,6 @@ int BreedingDoubleExampleTrainer::train( int inMaxNumRounds,
 			return r;
 			}
 		
-		// crossbreed top portion of the population to replace the bottom
-		// portion.
-		
-		// INCORRECT:
-		// Pick if there are n members of population, pick m to breed such that
-		// m + m + m-1 + m-2 + m-3 + ... + 1 = n
-		// m + (m(m+1))/2 = n
-		// 2m + m(m+1) = 2n
-		// m^2 + 3m - 2n = 0
-		// m = ( -3 +/- ( 9 + 8n )^(1/2) ) / 2
-		//int numToBreed = (int)( (-3 + sqrt( 9 + 8 * mPopulationSize ) ) * 0.5 );
-		
-		// CORRECT:
-		// Pick if there are n members of population, pick m to breed such that
-		// m + m-1 + m-2 + m-3 + ... + 1 = n
-		// (m(m+1))/2 = n
-		// m(m+1) = 2n
-		// m^2 + m - 2n = 0
-		// m = ( -1 +/- ( 1 + 8n )^(1/2) ) / 2
-		int numToBreed = (int)( (-1 + sqrt( 1 + 8 * mPopulationSize ) ) * 0.5 );
-		int remainder = mPopulationSize - 
-			( numToBreed + (numToBreed * ( numToBreed + 1 ) ) / 2 );
-		int startIndReplace = numToBreed + remainder;
-		
 		int indNextReplace = startIndReplace;
 		
 		//printf( "Population size = %d, numToBreed = %d\n", mPopulationSize,
@@ -269,18 +288,12 @@ int BreedingDoubleExampleTrainer::train( int inMaxNumRounds,
 		
 		for( int a=0; a<numToBreed; a++ ) {
 			for( int b=a+1; b<numToBreed; b++ ) {
-				// delete network in bottom segment of population
-				BreedableFeedForwardNeuralNet *networkToDelete = 
+				// offspring overwrites network in bottom segment of
+				// population
+				BreedableFeedForwardNeuralNet *networkToReplace = 
 					dynamic_cast
 					< BreedableFeedForwardNeuralNet* >( mPopulation[indNextReplace] );
-				if( networkToDelete == 0 ) {
-					// cast failed.
-					printf( "Casting a network in population to a ");
-					printf( "BreedableFeedForwardNeuralNet failed.\n" );
-					return errorReturn;
-					}
-				delete networkToDelete;
-
+				
 				BreedableFeedForwardNeuralNet *network =
 					dynamic_cast
 					< BreedableFeedForwardNeuralNet* >( mPopulation[a] );
@@ -288,23 +301,17 @@ int BreedingDoubleExampleTrainer::train( int inMaxNumRounds,
 					dynamic_cast
 					< BreedableFeedForwardNeuralNet* >( mPopulation[b] );
 				
-				if( network == 0 || otherNetwork == 0 ) {
+				if( networkToReplace == 0 || 
+					network == 0 || otherNetwork == 0 ) {
 					// cast failed.
 					printf( "Casting a network in population to a ");
 					printf( "BreedableFeedForwardNeuralNet failed.\n" );
 					return errorReturn;
 					}
 				
-				int neuronsPerLayer = 1;
-				void *offspring = 
-					//new	BreedableFeedForwardNeuralNet( 10, 
-					//	1, &neuronsPerLayer, 1, network->getRandSource() );
-					network->crossbreed( otherNetwork, 
-						0.5f, inMutationProb,
-						inMaxMutationMagnitude );	
-				
-				// insert offspring into population
-				mPopulation[indNextReplace] = (NeuralNet *)offspring;
+				network->crossbreedInto( otherNetwork, networkToReplace,
+					0.5f, inMutationProb,
+					inMaxMutationMagnitude );
 				
 				/*
 				//Sanity check:
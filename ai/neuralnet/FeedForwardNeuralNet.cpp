@@ -7,10 +7,15 @@
  * 2000-September-17		Jason Rohrer
  * Fixed small memory leak in constructor that involved a temp weight array.
  * Added functions for writing to file and reading back in from file. 
+ *
+ * 2026-October-15		Jason Rohrer
+ * Weights for each layer in one contiguous block.  Added runBatch, with
+ * templated threshold loops, and made run a batch of one.
  */
 
 
 #include "FeedForwardNeuralNet.h"
+#include "IdentityThreshold.h"
 
 #include <string.h>
 
@@ -44,6 +49,7 @@ FeedForwardNeuralNet::FeedForwardNeuralNet( int inNumInputs,
 	mNeuronThresholds = new Threshold**[totalNumLayers];
 	mNeuronThresholdValues = new double*[totalNumLayers];
 	mWeights = new double**[totalNumLayers];
+	mWeightMatrices = new double*[totalNumLayers];
 	
 	// fill in all arrays
 	for( i=0; i<totalNumLayers; i++ ) {
@@ -54,35 +60,31 @@ FeedForwardNeuralNet::FeedForwardNeuralNet( int inNumInputs,
 		//  Note that a hot spot in the weight initialization
 		//  was located (setting every weight to 0 in the
 		//  inner-most loop).
-		//  The following code attempts to allocate these
-		//  weights in an efficient manner.
-		
-		// This optimization reduced the execution time of this
-		// constructor from 200ms per call down to 1.43ms per call.
-		// Definitely worth it!
+		//  Weights for a layer are now one block, zeroed at once,
+		//  which runBatch also reads straight through.
 		
 		int neuronsNextLayer = 0;
 		if( i<totalNumLayers - 1 ) {
 			neuronsNextLayer = mNeuronsPerLayer[i+1];
 			}
-		// these init values should be copied into the
-		// weight arrays for every neuron in this layer
-		double *tempWeights = new double[ neuronsNextLayer ];
-		for( int k=0; k<neuronsNextLayer; k++ ) {
-			tempWeights[k] = 0.0;
+		
+		// don't create weight arrays that leave the output neurons
+		mWeightMatrices[i] = NULL;
+		if( i<totalNumLayers - 1 ) {
+			int numWeights = mNeuronsPerLayer[i] * neuronsNextLayer;
+			
+			mWeightMatrices[i] = new double[ numWeights ];
+			memset( mWeightMatrices[i], 0, numWeights * sizeof( double ) );
 			}
 			
 		for( int j=0; j<mNeuronsPerLayer[i]; j++ ) {
 			mNeuronThresholds[i][j] = StepThreshold::getInstance();
 			mNeuronThresholdValues[i][j] = 0.0;
-			// don't create weight arrays that leave the output neurons
 			if( i<totalNumLayers - 1 ) {
-				mWeights[i][j] = new double[ neuronsNextLayer ];
-				memcpy( mWeights[i][j], tempWeights, 
-					neuronsNextLayer * sizeof( double ) );
+				mWeights[i][j] = 
+					&( mWeightMatrices[i][ j * neuronsNextLayer ] );
 				}
 			}
-		delete [] tempWeights;
 		}
 	}
 
@@ -100,6 +102,7 @@ FeedForwardNeuralNet::FeedForwardNeuralNet( FILE *inInputFile ) {
 	mNeuronThresholdValues = new double*[totalNumLayers];
 	mNeuronThresholds = new Threshold**[totalNumLayers];
 	mWeights = new double**[totalNumLayers];
+	mWeightMatrices = new double*[totalNumLayers];
 	
 	int i;
 	int j;
@@ -127,10 +130,15 @@ FeedForwardNeuralNet::FeedForwardNeuralNet( FILE *inInputFile ) {
 		}
 	
 	// read weights in from file
+	mWeightMatrices[ totalNumLayers-1 ] = NULL;
 	for( i=0; i<totalNumLayers-1; i++ ) {
+		mWeightMatrices[i] = 
+			new double[ mNeuronsPerLayer[i] * mNeuronsPerLayer[i+1] ];
+		
 		for( j=0; j<mNeuronsPerLayer[i]; j++ ) {
 			// setup last tier of weights array
-			mWeights[i][j] = new double[mNeuronsPerLayer[i+1]];
+			mWeights[i][j] = 
+				&( mWeightMatrices[i][ j * mNeuronsPerLayer[i+1] ] );
 			for( k=0; k<mNeuronsPerLayer[i+1]; k++ ) {
 				fscanf( inFile, "%lf", &( mWeights[i][j][k] ) );
 				}
@@ -145,10 +153,8 @@ FeedForwardNeuralNet::~FeedForwardNeuralNet() {
 	int totalNumLayers = mNumHiddenLayers + 2;
 	for( int i=0; i<totalNumLayers; i++ ) {
 		// singleton, no need to delete Thresholds		
-		if( i<totalNumLayers - 1 ) {
-			for( int j=0; j<mNeuronsPerLayer[i]; j++ ) {			
-				delete [] mWeights[i][j];
-				}
+		if( mWeightMatrices[i] != NULL ) {
+			delete [] mWeightMatrices[i];
 			}
 		delete [] mNeuronThresholds[i];
 		delete [] mNeuronThresholdValues[i];
@@ -158,101 +164,201 @@ FeedForwardNeuralNet::~FeedForwardNeuralNet() {
 	delete [] mNeuronThresholds;
 	delete [] mNeuronThresholdValues;
 	delete [] mWeights;
+	delete [] mWeightMatrices;
 		
 	delete [] mNeuronsPerLayer;	
 	}
 	
 	
 		
+// examples that share each pass over a layer's weights in runBatch
+// (runBatch keeps one sum per example in a register, so changing this
+// means changing the kernel too)
+#define FFNN_EXAMPLE_TILE 4
+
+
+
+// applies a threshold to inNumRows rows of values, calling
+// ThresholdType::apply directly so that it can be inlined
+template <class ThresholdType>
+static void applyThresholdToRows( ThresholdType *inThreshold,
+								  double *ioValues, int inNumRows,
+								  double *inThresholdValues,
+								  int inNumNeurons ) {
+	for( int e=0; e<inNumRows; e++ ) {
+		double *row = &( ioValues[ e * inNumNeurons ] );
+		
+		for( int j=0; j<inNumNeurons; j++ ) {
+			row[j] = inThreshold->ThresholdType::apply( 
+				row[j], inThresholdValues[j] );
+			}
+		}
+	}
+
+
+
+// returns the threshold of every neuron in inThresholds as
+// ThresholdType, or NULL if any has another type
+template <class ThresholdType>
+static ThresholdType *getSharedThresholdType( Threshold **inThresholds,
+											  int inNumNeurons ) {
+	ThresholdType *first = NULL;
+	
+	for( int j=0; j<inNumNeurons; j++ ) {
+		ThresholdType *t = dynamic_cast<ThresholdType *>( inThresholds[j] );
+		if( t == NULL ) {
+			return NULL;
+			}
+		if( first == NULL ) {
+			first = t;
+			}
+		}
+	return first;
+	}
+	
+	
+
 void FeedForwardNeuralNet::run( double *inInputs, double *outOutputs ) {
+	runBatch( 1, inInputs, outOutputs );
+	}
+
+
+
+void FeedForwardNeuralNet::runBatch( int inNumExamples, double *inInputs,
+									 double *outOutputs ) {
+	
+	int totalNumLayers = mNumHiddenLayers + 2;
+	
+	int maxLayerSize = 0;
+	int i;
+	for( i=1; i<totalNumLayers - 1; i++ ) {
+		if( mNeuronsPerLayer[i] > maxLayerSize ) {
+			maxLayerSize = mNeuronsPerLayer[i];
+			}
+		}
+	
+	// hidden layer values for whole batch, alternating between buffers
+	double *buffers[2];
+	buffers[0] = new double[ inNumExamples * maxLayerSize ];
+	buffers[1] = new double[ inNumExamples * maxLayerSize ];
+	
 	// values at our current layer in the network
-	double *currentValues = new double[ mNeuronsPerLayer[0] ];
-	register int i;
-	memcpy( (void *)currentValues, 
-		(void *)inInputs, mNeuronsPerLayer[0] * sizeof( double ) );
+	double *currentValues = inInputs;
 	
-	for( i=1; i<mNumHiddenLayers + 2; i++ ) {
-		// values at neurons in next layer
-		double *newValues = new double[ mNeuronsPerLayer[i] ];
+	for( i=1; i<totalNumLayers; i++ ) {
+		int numPrevious = mNeuronsPerLayer[i-1];
+		int numThisLayer = mNeuronsPerLayer[i];
 		
-		register int numNeuronsThisLayer = mNeuronsPerLayer[i];
+		double *weights = mWeightMatrices[i-1];
 		
-		register int j;
-		// first, zero values at all neurons in next layer for base of sum
-		for( j=0; j<numNeuronsThisLayer; j++ ) {
-			newValues[j] = 0.0;
+		// values at neurons in next layer
+		double *newValues;
+		if( i == totalNumLayers - 1 ) {
+			newValues = outOutputs;
+			}
+		else {
+			newValues = buffers[ i % 2 ];
 			}
 		
-		// for each neuron in the previous layer
-		for( int k=0; k<mNeuronsPerLayer[i-1]; k++ ) {
-			
-			register double currentValuePrevious = currentValues[k];
-			double *weightsLeavingPrevious = mWeights[i-1][k];
-			
-			//
+		// each sum adds previous neurons in order, from 0.0, as run
+		// always has, so batch and single results match exactly
+		
+		// a group of examples at a time, with each weight loaded once
+		// for the whole group and sums kept in registers
+		int e = 0;
+		for( ; e + FFNN_EXAMPLE_TILE <= inNumExamples; 
+			 e += FFNN_EXAMPLE_TILE ) {
 			
-			// OPTIMIZE:
-			// Rolling the loop reduced total running time of this
-			// function from 288ms per call to 174ms per call
+			double *in0 = &( currentValues[ e * numPrevious ] );
+			double *in1 = in0 + numPrevious;
+			double *in2 = in1 + numPrevious;
+			double *in3 = in2 + numPrevious;
 			
-			// for each neuron in next layer
+			double *out0 = &( newValues[ e * numThisLayer ] );
 			
-			/*
-			for( j=0; j!=numNeuronsThisLayer; j++ ) {
-				newValues[j] += weightsLeavingPrevious[j] *
-					currentValuePrevious;
+			for( int j=0; j<numThisLayer; j++ ) {
+				double sum0 = 0.0;
+				double sum1 = 0.0;
+				double sum2 = 0.0;
+				double sum3 = 0.0;
+				
+				double *weightsToThis = &( weights[j] );
+				
+				// for each neuron in the previous layer
+				for( int k=0; k<numPrevious; k++ ) {
+					double w = weightsToThis[ k * numThisLayer ];
+					sum0 += w * in0[k];
+					sum1 += w * in1[k];
+					sum2 += w * in2[k];
+					sum3 += w * in3[k];
+					}
+				
+				out0[j] = sum0;
+				out0[ numThisLayer + j ] = sum1;
+				out0[ 2 * numThisLayer + j ] = sum2;
+				out0[ 3 * numThisLayer + j ] = sum3;
 				}
-			*/
+			}
+		
+		// remaining examples one at a time
+		for( ; e<inNumExamples; e++ ) {
+			double *in = &( currentValues[ e * numPrevious ] );
+			double *out = &( newValues[ e * numThisLayer ] );
 			
-			// roll loop
-			for( j=5; j<numNeuronsThisLayer; j+=6 ) {
-				register int backj = j-5;
-				newValues[backj] += weightsLeavingPrevious[backj] *
-					currentValuePrevious;
-				backj++;
-				newValues[backj] += weightsLeavingPrevious[backj] *
-					currentValuePrevious;
-				backj++;
-				newValues[backj] += weightsLeavingPrevious[backj] *
-					currentValuePrevious;
-				backj++;
-				newValues[backj] += weightsLeavingPrevious[backj] *
-					currentValuePrevious;
-				backj++;
-				newValues[backj] += weightsLeavingPrevious[backj] *
-					currentValuePrevious;
-				newValues[j] += weightsLeavingPrevious[j] *
-					currentValuePrevious;
-				}
-			// finish remainder
-			int startRemainder = j-6;
-			if( startRemainder < 0 ) {
-				startRemainder = 0;
-				}
-			for( j=startRemainder; j<numNeuronsThisLayer; j++ ) {
-				newValues[j] += weightsLeavingPrevious[j] *
-					currentValuePrevious;
-				}
-			// end rolled loop
+			for( int j=0; j<numThisLayer; j++ ) {
+				double sum = 0.0;
 				
+				for( int k=0; k<numPrevious; k++ ) {
+					sum += weights[ k * numThisLayer + j ] * in[k];
+					}
+				out[j] = sum;
+				}
 			}
 		
 		// now we have weighted sum at each neuron in this layer...
 		// need to threshold the sum
-		for( j=0; j<mNeuronsPerLayer[i]; j++ ) {
-			newValues[j] = mNeuronThresholds[i][j]->
-				apply( newValues[j], mNeuronThresholdValues[i][j] ); 
+		Threshold **thresholds = mNeuronThresholds[i];
+		double *thresholdValues = mNeuronThresholdValues[i];
+		
+		// checking types costs about as much as one example's virtual
+		// calls, so only worth it for a batch
+		StepThreshold *step = NULL;
+		IdentityThreshold *identity = NULL;
+		
+		if( inNumExamples > 1 ) {
+			step = getSharedThresholdType<StepThreshold>( thresholds, 
+														  numThisLayer );
+			if( step == NULL ) {
+				identity = getSharedThresholdType<IdentityThreshold>( 
+					thresholds, numThisLayer );
+				}
 			}
 		
-		delete [] currentValues;
+		if( step != NULL ) {
+			applyThresholdToRows( step, newValues, inNumExamples,
+								  thresholdValues, numThisLayer );
+			}
+		else if( identity != NULL ) {
+			applyThresholdToRows( identity, newValues, inNumExamples,
+								  thresholdValues, numThisLayer );
+			}
+		else {
+			// mixed thresholds, or a single example
+			for( int e=0; e<inNumExamples; e++ ) {
+				double *row = &( newValues[ e * numThisLayer ] );
+				
+				for( int j=0; j<numThisLayer; j++ ) {
+					row[j] = thresholds[j]->apply( row[j], 
+												   thresholdValues[j] ); 
+					}
+				}
+			}
 		
 		currentValues = newValues;	
 		}
-		
-	// now copy last set of current values int output array	
-	memcpy( (void *)outOutputs, (void *)currentValues,
-		mNumOutputs * sizeof( double ) );
-	delete [] currentValues;
+	
+	delete [] buffers[0];
+	delete [] buffers[1];
 	}
 
 
@@ -6,6 +6,9 @@
  *
  * 2000-September-17		Jason Rohrer
  * Added functions for writing to file and reading back in from file.
+ *
+ * 2026-October-15		Jason Rohrer
+ * Weights for each layer in one contiguous block.  Added runBatch.
  */
 
 #ifndef FEED_FORWARD_NEURAL_NET_INCLUDED
@@ -142,6 +145,29 @@ class FeedForwardNeuralNet : public DoubleNeuralNet {
 		 * Implements the DoubleNeuralNet:run interface.
 		 */
 		void run( double *inInputs, double *outOutputs );
+		
+		
+		/**
+		 * Runs the network on a batch of examples.
+		 *
+		 * Outputs are the same as calling run on each example, but each
+		 * layer is computed as one matrix product over the batch, so
+		 * weights are read once per group of examples instead of once
+		 * per example.
+		 *
+		 * Layers where every neuron has a StepThreshold or every neuron
+		 * has an IdentityThreshold apply it without virtual calls.
+		 *
+		 * Thread-safe, as long as the network is not being changed.
+		 *
+		 * @param inNumExamples the number of examples.
+		 * @param inInputs inNumExamples rows of getNumInputs() values,
+		 *   one after another.
+		 * @param outOutputs pre-allocated space where inNumExamples rows
+		 *   of getNumOutputs() values will be returned.
+		 */
+		void runBatch( int inNumExamples, double *inInputs, 
+					   double *outOutputs );
 	
 		
 		/**
@@ -177,8 +203,13 @@ class FeedForwardNeuralNet : public DoubleNeuralNet {
 		double **mNeuronThresholdValues;
 		
 		// indexed by [layerA][neuronA][neuronB]
+		// rows point into mWeightMatrices
 		double ***mWeights;
 		
+		// indexed by [layerA], each a row-major 
+		// [neuronA][neuronB] matrix
+		double **mWeightMatrices;
+		
 	}; 
 
 
@@ -6,6 +6,9 @@
  *
  * 2000-October-12		Jason Rohrer
  * Changed to use PopulationSorter's sort routine.
+ *
+ * 2026-October-15		Jason Rohrer
+ * Added selectTopOfPopulation.
  */
 
 #include "PopulationTrainer.h"
@@ -41,3 +44,12 @@ void PopulationTrainer::sortPopulation( double *inScores ) {
 		}
 	*/
 	}
+
+
+
+void PopulationTrainer::selectTopOfPopulation( double *inScores, 
+	int inNumTop ) {
+	
+	PopulationSorter::selectTopMembers( (PopulationMember**)mPopulation, 
+		inScores, mPopulationSize, inNumTop );
+	}
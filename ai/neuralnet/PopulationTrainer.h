@@ -6,6 +6,10 @@
  *
  * 2000-October-12		Jason Rohrer
  * Changed to subclass PopulationSorter to abstract away sorting routine.
+ *
+ * 2026-October-15		Jason Rohrer
+ * Added missing include for memcpy.
+ * Added selectTopOfPopulation.
  */
 
 #ifndef POPULATION_TRAINER_INCLUDED
@@ -15,6 +19,8 @@
 
 #include "minorGems/ai/genetic/PopulationSorter.h"
 
+#include <string.h>
+
 /**
  * Abstract superclass for classes that train a population of NeuralNets.
  *
@@ -88,6 +94,17 @@ class PopulationTrainer : public PopulationSorter {
 		 *   population.
 		 */
 		void sortPopulation( double *inScores );
+		
+		/**
+		 * Like sortPopulation, but only the best inNumTop members are
+		 * put in order at the front.  The rest follow in no particular
+		 * order.
+		 *
+		 * @param inScores an array of scores, one for each member of
+		 *   population.
+		 * @param inNumTop the number of members to put in order.
+		 */
+		void selectTopOfPopulation( double *inScores, int inNumTop );
 	};
 
 
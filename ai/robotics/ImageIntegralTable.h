@@ -0,0 +1,332 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15		Jason Rohrer
+ * Created.
+ */
+
+
+#ifndef IMAGE_INTEGRAL_TABLE_INCLUDED
+#define IMAGE_INTEGRAL_TABLE_INCLUDED
+
+
+#include "ImageRectangle.h"
+#include "minorGems/graphics/Image.h"
+
+
+
+/**
+ * Summed-area tables of one image channel, built once so that the sum,
+ * mean, and variance over any rectangle take four lookups each.
+ *
+ * Worth it when an image gets more than a few rectangle queries, or
+ * overlapping ones.  See ImageStatistics for functions that take a table.
+ *
+ * @author Jason Rohrer
+ */
+class ImageIntegralTable {
+
+	public:
+
+		/**
+		 * Builds tables for a channel.
+		 *
+		 * @param inImage the image.  Must be destroyed by caller, and
+		 *   can be destroyed right after construction.
+		 * @param inChannel the channel to build tables for.
+		 * @param inMask mask of pixels to include (those with values
+		 *   > 0.5 in channel 0), the same size as inImage, or NULL to
+		 *   include all pixels.  Defaults to NULL.
+		 *   Must be destroyed by caller.
+		 */
+		ImageIntegralTable( Image *inImage, int inChannel,
+							Image *inMask = NULL );
+
+		~ImageIntegralTable();
+
+
+		int getWidth();
+		int getHeight();
+
+
+		/**
+		 * Converts a rectangle to pixel bounds, rounding the same way
+		 * as ImageStatistics, and clamped to the image.
+		 *
+		 * @return true if the bounds contain at least one pixel.
+		 */
+		char getPixelBounds( ImageRectangle *inRectangle,
+							 int *outXStart, int *outXEnd,
+							 int *outYStart, int *outYEnd );
+
+
+		// sums over pixels [inXStart,inXEnd] x [inYStart,inYEnd],
+		// inclusive, which must be inside the image.
+		// Masked-out pixels aren't counted.
+		double getSum( int inXStart, int inXEnd, int inYStart, int inYEnd );
+		double getSumOfSquares( int inXStart, int inXEnd,
+								int inYStart, int inYEnd );
+		long getCount( int inXStart, int inXEnd, int inYStart, int inYEnd );
+
+
+		// mean and variance of unmasked pixels in a rectangle,
+		// or 0 if it has none
+		double getMean( ImageRectangle *inRectangle );
+		double getVariance( ImageRectangle *inRectangle );
+
+
+	private:
+		int mWidth;
+		int mHeight;
+
+		// ( mWidth + 1 ) x ( mHeight + 1 ), with a row and column of
+		// zeros before the first pixel, so that entry ( x, y ) covers
+		// pixels [0,x) x [0,y)
+		double *mSums;
+		double *mSquareSums;
+
+		// NULL if no mask
+		double *mCounts;
+
+
+		double lookup( double *inTable,
+					   int inXStart, int inXEnd, int inYStart, int inYEnd );
+
+		// builds one table from per-pixel values
+		void buildTable( double *inValues, double *outTable );
+	};
+
+
+
+inline ImageIntegralTable::ImageIntegralTable( Image *inImage,
+	int inChannel, Image *inMask )
+	: mWidth( inImage->getWidth() ), mHeight( inImage->getHeight() ),
+	  mCounts( NULL ) {
+
+	int numPixels = mWidth * mHeight;
+	int tableSize = ( mWidth + 1 ) * ( mHeight + 1 );
+
+	mSums = new double[ tableSize ];
+	mSquareSums = new double[ tableSize ];
+
+	double *channel = inImage->getChannel( inChannel );
+
+	double *values = new double[ numPixels ];
+
+	if( inMask != NULL ) {
+		mCounts = new double[ tableSize ];
+
+		double *maskChannel = inMask->getChannel( 0 );
+
+		// 1 for included pixels, 0 otherwise
+		for( int i=0; i<numPixels; i++ ) {
+			values[i] = ( maskChannel[i] > 0.5 ) ? 1 : 0;
+			}
+		buildTable( values, mCounts );
+
+		for( int i=0; i<numPixels; i++ ) {
+			values[i] *= channel[i];
+			}
+		}
+	else {
+		for( int i=0; i<numPixels; i++ ) {
+			values[i] = channel[i];
+			}
+		}
+
+	buildTable( values, mSums );
+
+	for( int i=0; i<numPixels; i++ ) {
+		values[i] *= values[i];
+		}
+
+	buildTable( values, mSquareSums );
+
+	delete [] values;
+	}
+
+
+
+inline ImageIntegralTable::~ImageIntegralTable() {
+	delete [] mSums;
+	delete [] mSquareSums;
+
+	if( mCounts != NULL ) {
+		delete [] mCounts;
+		}
+	}
+
+
+
+inline int ImageIntegralTable::getWidth() {
+	return mWidth;
+	}
+
+
+
+inline int ImageIntegralTable::getHeight() {
+	return mHeight;
+	}
+
+
+
+inline void ImageIntegralTable::buildTable( double *inValues,
+	double *outTable ) {
+
+	int tableWidth = mWidth + 1;
+
+	for( int x=0; x<tableWidth; x++ ) {
+		outTable[x] = 0;
+		}
+
+	for( int y=0; y<mHeight; y++ ) {
+		double *row = &( inValues[ y * mWidth ] );
+		double *above = &( outTable[ y * tableWidth ] );
+		double *out = &( outTable[ ( y + 1 ) * tableWidth ] );
+
+		// running sum along the row is serial...
+		double rowSum = 0;
+		out[0] = 0;
+		for( int x=0; x<mWidth; x++ ) {
+			rowSum += row[x];
+			out[ x + 1 ] = rowSum;
+			}
+
+		// ...but adding the row above has no dependencies between
+		// columns, so it vectorizes (at -O3)
+		for( int x=1; x<tableWidth; x++ ) {
+			out[x] += above[x];
+			}
+		}
+	}
+
+
+
+inline double ImageIntegralTable::lookup( double *inTable,
+	int inXStart, int inXEnd, int inYStart, int inYEnd ) {
+
+	int tableWidth = mWidth + 1;
+
+	int top = inYStart * tableWidth;
+	int bottom = ( inYEnd + 1 ) * tableWidth;
+	int left = inXStart;
+	int right = inXEnd + 1;
+
+	return inTable[ bottom + right ] - inTable[ bottom + left ]
+		- inTable[ top + right ] + inTable[ top + left ];
+	}
+
+
+
+inline double ImageIntegralTable::getSum( int inXStart, int inXEnd,
+	int inYStart, int inYEnd ) {
+
+	return lookup( mSums, inXStart, inXEnd, inYStart, inYEnd );
+	}
+
+
+
+inline double ImageIntegralTable::getSumOfSquares( int inXStart,
+	int inXEnd, int inYStart, int inYEnd ) {
+
+	return lookup( mSquareSums, inXStart, inXEnd, inYStart, inYEnd );
+	}
+
+
+
+inline long ImageIntegralTable::getCount( int inXStart, int inXEnd,
+	int inYStart, int inYEnd ) {
+
+	if( mCounts == NULL ) {
+		return (long)( inXEnd - inXStart + 1 ) * ( inYEnd - inYStart + 1 );
+		}
+
+	// counts are whole numbers, so sums of them are exact
+	return (long)lookup( mCounts, inXStart, inXEnd, inYStart, inYEnd );
+	}
+
+
+
+inline char ImageIntegralTable::getPixelBounds( ImageRectangle *inRectangle,
+	int *outXStart, int *outXEnd, int *outYStart, int *outYEnd ) {
+
+	int xStart = (int)( mWidth * inRectangle->mXStart );
+	int xEnd = (int)( ( mWidth * inRectangle->mXEnd ) - 1 );
+
+	int yStart = (int)( mHeight * inRectangle->mYStart );
+	int yEnd = (int)( ( mHeight * inRectangle->mYEnd ) - 1 );
+
+	if( xStart < 0 ) {
+		xStart = 0;
+		}
+	if( yStart < 0 ) {
+		yStart = 0;
+		}
+	if( xEnd > mWidth - 1 ) {
+		xEnd = mWidth - 1;
+		}
+	if( yEnd > mHeight - 1 ) {
+		yEnd = mHeight - 1;
+		}
+
+	*outXStart = xStart;
+	*outXEnd = xEnd;
+	*outYStart = yStart;
+	*outYEnd = yEnd;
+
+	return ( xStart <= xEnd && yStart <= yEnd );
+	}
+
+
+
+inline double ImageIntegralTable::getMean( ImageRectangle *inRectangle ) {
+
+	int xStart, xEnd, yStart, yEnd;
+
+	if( ! getPixelBounds( inRectangle, &xStart, &xEnd, &yStart, &yEnd ) ) {
+		return 0;
+		}
+
+	long count = getCount( xStart, xEnd, yStart, yEnd );
+
+	if( count == 0 ) {
+		return 0;
+		}
+
+	return getSum( xStart, xEnd, yStart, yEnd ) / count;
+	}
+
+
+
+inline double ImageIntegralTable::getVariance(
+	ImageRectangle *inRectangle ) {
+
+	int xStart, xEnd, yStart, yEnd;
+
+	if( ! getPixelBounds( inRectangle, &xStart, &xEnd, &yStart, &yEnd ) ) {
+		return 0;
+		}
+
+	long count = getCount( xStart, xEnd, yStart, yEnd );
+
+	if( count == 0 ) {
+		return 0;
+		}
+
+	double mean = getSum( xStart, xEnd, yStart, yEnd ) / count;
+	double meanOfSquares =
+		getSumOfSquares( xStart, xEnd, yStart, yEnd ) / count;
+
+	double variance = meanOfSquares - mean * mean;
+
+	// rounding can leave a tiny negative value for flat regions
+	if( variance < 0 ) {
+		variance = 0;
+		}
+
+	return variance;
+	}
+
+
+
+#endif
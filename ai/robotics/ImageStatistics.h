@@ -25,6 +25,11 @@
  * Added threshold map function and modified 
  * centerOfValue and averageValue to use it.
  * Also modified fractionNearValue similarly.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Added variance, and versions of averageValue and variance that use
+ * an ImageIntegralTable.
+ * Removed extra qualification on RGBtoHSB declaration.
  */
  
  
@@ -32,6 +37,7 @@
 #define IMAGE_STATISTICS_INCLUDED 
 
 #include "ImageRectangle.h"
+#include "ImageIntegralTable.h"
 #include "ImageUtilities.h"
 #include "minorGems/graphics/Image.h"
 #include "minorGems/graphics/Color.h"
@@ -268,6 +274,55 @@ class ImageStatistics {
 			      int inChannel,
 			      ImageRectangle *inRectangle,
 			      Image *ignoreMask);
+
+
+  /**
+   * Same as averageValue, but takes a constant number of steps,
+   * using tables built once for the image.
+   *
+   * @param inTable the tables for the image, channel, and mask
+   *   to analyze.  Must be destroyed by caller.
+   * @param inRectangle the region to analyze.
+   *   Must be destroyed by caller.
+   *
+   * @return the average value, or 0 if no pixels are included.
+   */
+  static double averageValue( ImageIntegralTable *inTable,
+			      ImageRectangle *inRectangle );
+
+
+  /**
+   * Computes the variance of values in an image region.
+   *
+   * @param inImage the image to analyze.
+   *   Must be destroyed by caller.
+   * @param inChannel the channel to analyze.
+   * @param inRectangle the region to analyze.
+   *   Must be destroyed by caller.
+   * @param ignoreMask mask of points to include
+   *   in calculations
+   *
+   * @return the variance, or 0 if no pixels are included.
+   */
+  static double variance( Image *inImage,
+			  int inChannel,
+			  ImageRectangle *inRectangle,
+			  Image *ignoreMask );
+
+
+  /**
+   * Same as variance, but takes a constant number of steps,
+   * using tables built once for the image.
+   *
+   * @param inTable the tables for the image, channel, and mask
+   *   to analyze.  Must be destroyed by caller.
+   * @param inRectangle the region to analyze.
+   *   Must be destroyed by caller.
+   *
+   * @return the variance, or 0 if no pixels are included.
+   */
+  static double variance( ImageIntegralTable *inTable,
+			  ImageRectangle *inRectangle );
 								
 
   /**
@@ -279,7 +334,7 @@ class ImageStatistics {
    * @return a new image that is the HSB conversion of the
    *   RGB image.  Must be destroyed by caller.
    */
-  static Image *ImageStatistics::RGBtoHSB( Image *inRGBImage );
+  static Image *RGBtoHSB( Image *inRGBImage );
 								
 };
 				
@@ -707,6 +762,79 @@ inline double ImageStatistics::averageValue(
 
 
 
+inline double ImageStatistics::averageValue(
+					    ImageIntegralTable *inTable,
+					    ImageRectangle *inRectangle ) {
+
+  return inTable->getMean( inRectangle );
+}
+
+
+
+inline double ImageStatistics::variance(
+					Image *inImage,
+					int inChannel,
+					ImageRectangle *inRectangle,
+					Image *ignoreMask ) {
+
+  int w = inImage->getWidth();
+  int h = inImage->getHeight();
+
+  int xStart = (int)( w * inRectangle->mXStart );
+  int xEnd = (int)( ( w * inRectangle->mXEnd ) - 1 );
+
+  int yStart = (int)( h * inRectangle->mYStart );
+  int yEnd = (int)( ( h * inRectangle->mYEnd ) - 1 );
+
+  double *channel = inImage->getChannel( inChannel );
+  double *ignoreChannel = ignoreMask->getChannel( 0 );
+
+  // two passes, mean first, to avoid cancellation
+  long numPixels = 0;
+  double sum = 0;
+
+  for( int y=yStart; y<=yEnd; y++ ) {
+    for( int x=xStart; x<=xEnd; x++ ) {
+      int index = y * w + x;
+      if( ignoreChannel[index] > 0.5 ) {
+	numPixels++;
+	sum += channel[index];
+      }
+    }
+  }
+
+  if( numPixels == 0 ) {
+    return 0;
+  }
+
+  double mean = sum / (double)numPixels;
+
+  double squareSum = 0;
+
+  for( int y=yStart; y<=yEnd; y++ ) {
+    for( int x=xStart; x<=xEnd; x++ ) {
+      int index = y * w + x;
+      if( ignoreChannel[index] > 0.5 ) {
+	double diff = channel[index] - mean;
+	squareSum += diff * diff;
+      }
+    }
+  }
+
+  return squareSum / (double)numPixels;
+}
+
+
+
+inline double ImageStatistics::variance(
+					ImageIntegralTable *inTable,
+					ImageRectangle *inRectangle ) {
+
+  return inTable->getVariance( inRectangle );
+}
+
+
+
 inline Image *ImageStatistics::RGBtoHSB( Image *inRGBImage ) {
 				// idea modeled after Java Color class.
 				
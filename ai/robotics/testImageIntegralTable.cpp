@@ -0,0 +1,163 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15		Jason Rohrer
+ * Created.
+ */
+
+/**
+ * Checks ImageIntegralTable means and variances against ImageStatistics
+ * pixel loops over random rectangles, with and without a mask, and times
+ * many overlapping rectangle queries both ways.
+ *
+ * Compile from above the minorGems directory with:
+ *   g++ -O2 -I. minorGems/ai/robotics/testImageIntegralTable.cpp
+ *     minorGems/system/unix/TimeUnix.cpp
+ *     minorGems/io/file/linux/PathLinux.cpp
+ *     -o testImageIntegralTable
+ */
+
+#include "ImageStatistics.h"
+#include "ImageIntegralTable.h"
+
+#include "minorGems/graphics/Image.h"
+#include "minorGems/system/Time.h"
+#include "minorGems/util/random/StdRandomSource.h"
+
+#include <stdio.h>
+#include <math.h>
+
+
+
+static int numBad = 0;
+
+
+
+static void check( double inExpected, double inGot, const char *inWhat ) {
+	if( fabs( inExpected - inGot ) > 1e-9 ) {
+		printf( "%s: got %.12f, expected %.12f\n",
+				inWhat, inGot, inExpected );
+		numBad++;
+		}
+	}
+
+
+
+// inside the image, since ImageStatistics pixel loops don't clamp,
+// and at least a few pixels wide, since they divide by the pixel count
+static ImageRectangle randomRectangle( StdRandomSource *inRandSource ) {
+	double x0 = 0.97 * inRandSource->getRandomDouble();
+	double y0 = 0.97 * inRandSource->getRandomDouble();
+
+	double x1 = x0 + 0.02 + inRandSource->getRandomDouble() * ( 0.98 - x0 );
+	double y1 = y0 + 0.02 + inRandSource->getRandomDouble() * ( 0.98 - y0 );
+
+	return ImageRectangle( x0, x1, y0, y1 );
+	}
+
+
+
+int main() {
+	StdRandomSource randSource( 3 );
+
+	int w = 640;
+	int h = 480;
+	int numPixels = w * h;
+
+	Image image( w, h, 2 );
+	Image mask( w, h, 1 );
+	Image allOnes( w, h, 1 );
+
+	double *channel = image.getChannel( 1 );
+	double *maskChannel = mask.getChannel( 0 );
+	double *onesChannel = allOnes.getChannel( 0 );
+
+	for( int i=0; i<numPixels; i++ ) {
+		// bright offset, where one-pass variance would lose digits
+		channel[i] = 0.9 + 0.1 * randSource.getRandomDouble();
+		maskChannel[i] = randSource.getRandomDouble();
+		onesChannel[i] = 1;
+		}
+
+
+	ImageIntegralTable table( &image, 1 );
+	ImageIntegralTable maskedTable( &image, 1, &mask );
+
+	for( int r=0; r<300; r++ ) {
+		ImageRectangle rect = randomRectangle( &randSource );
+
+		check( ImageStatistics::averageValue( &image, 1, &rect, &allOnes ),
+			   ImageStatistics::averageValue( &table, &rect ),
+			   "Mean" );
+		check( ImageStatistics::variance( &image, 1, &rect, &allOnes ),
+			   ImageStatistics::variance( &table, &rect ),
+			   "Variance" );
+		check( ImageStatistics::averageValue( &image, 1, &rect, &mask ),
+			   ImageStatistics::averageValue( &maskedTable, &rect ),
+			   "Masked mean" );
+		check( ImageStatistics::variance( &image, 1, &rect, &mask ),
+			   ImageStatistics::variance( &maskedTable, &rect ),
+			   "Masked variance" );
+		}
+
+	// whole image, and one pixel
+	ImageRectangle whole( 0, 1, 0, 1 );
+	check( ImageStatistics::averageValue( &image, 1, &whole, &allOnes ),
+		   ImageStatistics::averageValue( &table, &whole ), "Whole mean" );
+
+	ImageRectangle onePixel( 0.5, 0.5 + 1.0 / w, 0.5, 0.5 + 1.0 / h );
+	check( channel[ ( h / 2 ) * w + w / 2 ],
+		   ImageStatistics::averageValue( &table, &onePixel ),
+		   "One pixel mean" );
+	check( 0, ImageStatistics::variance( &table, &onePixel ),
+		   "One pixel variance" );
+
+	// outside the image
+	ImageRectangle outside( 1.5, 2, 0, 1 );
+	check( 0, ImageStatistics::averageValue( &table, &outside ),
+		   "Outside mean" );
+
+
+	// timing, with overlapping windows like a move generator's scan
+	int numQueries = 2000;
+
+	double startTime = Time::getMonotonicTime();
+	double loopSum = 0;
+	for( int q=0; q<numQueries; q++ ) {
+		double x = ( q % 50 ) / 100.0;
+		double y = ( q / 50 ) / 100.0;
+		ImageRectangle rect( x, x + 0.5, y, y + 0.5 );
+		loopSum += ImageStatistics::averageValue( &image, 1, &rect, &mask );
+		loopSum += ImageStatistics::variance( &image, 1, &rect, &mask );
+		}
+	double loopTime = Time::getMonotonicTime() - startTime;
+
+	startTime = Time::getMonotonicTime();
+	ImageIntegralTable timedTable( &image, 1, &mask );
+	double buildTime = Time::getMonotonicTime() - startTime;
+
+	double tableSum = 0;
+	for( int q=0; q<numQueries; q++ ) {
+		double x = ( q % 50 ) / 100.0;
+		double y = ( q / 50 ) / 100.0;
+		ImageRectangle rect( x, x + 0.5, y, y + 0.5 );
+		tableSum += ImageStatistics::averageValue( &timedTable, &rect );
+		tableSum += ImageStatistics::variance( &timedTable, &rect );
+		}
+	double tableTime = Time::getMonotonicTime() - startTime;
+
+	check( loopSum, tableSum, "Timed sums" );
+
+	printf( "%d masked mean and variance queries on %dx%d:\n"
+			"  pixel loops %.3f s, tables %.4f s (%.4f s of that "
+			"building them)\n",
+			numQueries, w, h, loopTime, tableTime, buildTime );
+
+
+	if( numBad == 0 ) {
+		printf( "All tests passed\n" );
+		return 0;
+		}
+	printf( "%d failures\n", numBad );
+	return 1;
+	}
@@ -19,6 +19,10 @@
  *
  * 2001-May-10   Jason Rohrer
  * Removed many debugging print statements.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Changed to capture from the camera's MJPEG stream in a background
+ * thread, keeping a small ring of decoded frames ready.
  */
  
  
@@ -35,21 +39,48 @@
 
 #include "minorGems/network/HostAddress.h"
 
+#include "minorGems/system/StopSignalThread.h"
+#include "minorGems/system/MutexLock.h"
+#include "minorGems/system/Semaphore.h"
+
+#include "minorGems/util/SimpleVector.h"
+
 #include <string.h>
 #include <stdio.h>
 
+
+
+// decoded frames kept ready, beyond which the oldest is dropped
+#define AXIS_IMAGE_SOURCE_RING_SIZE 3
+
+// connect and read timeout, so the capture thread notices a stop or a
+// stalled camera
+#define AXIS_IMAGE_SOURCE_TIMEOUT 2000
+
+// wait before reconnecting after a failure
+#define AXIS_IMAGE_SOURCE_RETRY_DELAY 1000
+
+#define AXIS_IMAGE_SOURCE_READ_BUFFER_SIZE 4096
+
+
+
 /**
  * Implementaion of ImageSource that retrieves images from a
  * networked Axis webcam.
  *
+ * A capture thread holds one connection to the camera's MJPEG stream
+ * open, decoding frames as they arrive, so capture and decode overlap
+ * with whatever the caller does between getNextImage calls.  Cameras
+ * without a stream are polled for single images instead.
+ *
  * @author Jason Rohrer
  */
-class AxisImageSource : public ImageSource {
+class AxisImageSource : public ImageSource, public StopSignalThread {
 	
 	public:
 
 		/**
-		 * Constructs an AxisImageSource.
+		 * Constructs an AxisImageSource, and starts capturing.
 		 *
 		 * @param inServerAddress the address of the axis camera server.
 		 *   Is NOT destroyed when this class is destroyed.
@@ -68,24 +99,82 @@ class AxisImageSource : public ImageSource {
 						 int inCompression );
 
 
+		// stops capture thread, waiting for it to notice (up to
+		// AXIS_IMAGE_SOURCE_TIMEOUT)
 		~AxisImageSource();
 		
 		
-		// implements ImageSource interface
+		/**
+		 * Implements ImageSource interface.
+		 *
+		 * Returns the newest captured frame, dropping any older ones
+		 * still waiting.  Blocks only if no frame has arrived since the
+		 * last call.
+		 *
+		 * Returns NULL if the camera can't be reached.
+		 */
 		virtual Image *getNextImage();
 
 
+		// number of frames dropped so far, either because the ring
+		// was full or because a newer frame was taken
+		int getNumDroppedFrames();
+		
+		
+		// implements Thread interface
+		void run();
+
+
 		
 	private:
-		Socket *mServerSocket;
 		HostAddress *mServerAddress;
-		SocketStream *mSocketStream;
-		
-		JPEGImageConverter *mConverter;
 
 		int mImageWidth;
 		int mImageHeight;
 		int mCompression;
+
+		// false once the camera has turned down a stream request
+		char mStreamSupported;
+
+		
+		MutexLock *mLock;
+
+		// signaled whenever a frame arrives or a connect fails
+		Semaphore *mFrameSemaphore;
+
+		// oldest first, protected by mLock
+		SimpleVector<Image *> mFrames;
+
+		// protected by mLock
+		char mConnectFailed;
+		int mNumDropped;
+
+		
+		// capture thread's buffered view of current connection
+		unsigned char mReadBuffer[ AXIS_IMAGE_SOURCE_READ_BUFFER_SIZE ];
+		int mReadPosition;
+		int mReadLength;
+
+		
+		// these run in the capture thread only
+		
+		// -1 on error or timeout
+		int readByte( SocketStream *inStream );
+
+		// reads a line, returning true if it contains inText
+		char readLineContaining( SocketStream *inStream,
+								 const char *inText );
+
+		// skips to the next JPEG start marker and decodes through
+		// the end marker
+		// returns NULL on read error or decode failure
+		Image *readNextJPEG( SocketStream *inStream );
+		
+		void addFrame( Image *inImage );
+
+		int getNumFramesWaiting();
+
+		void setConnectFailed( char inFailed );
 	};
 
 
@@ -95,9 +184,14 @@ inline AxisImageSource::AxisImageSource( HostAddress *inServerAddress,
 										 int inImageHeight,
 										 int inCompression )
 	: mServerAddress( inServerAddress ),
-	  mConverter( new JPEGImageConverter( 50 ) ),
 	  mImageWidth( inImageWidth ), mImageHeight( inImageHeight ),
-	  mCompression( inCompression ) {
+	  mCompression( inCompression ),
+	  mStreamSupported( true ),
+	  mLock( new MutexLock() ),
+	  mFrameSemaphore( new Semaphore() ),
+	  mConnectFailed( false ),
+	  mNumDropped( 0 ),
+	  mReadPosition( 0 ), mReadLength( 0 ) {
 
 	if( mCompression > 100 || mCompression < 0 ) {
 		// do it this way to avoid having the same print statement in
@@ -110,110 +204,308 @@ inline AxisImageSource::AxisImageSource( HostAddress *inServerAddress,
 			}
 		printf( "Compression value must be in range [0,100]\n" );
 		}
+
+	start();
 	}
 
 
 
 inline AxisImageSource::~AxisImageSource() {
-	delete mConverter;
+	stop();
+	join();
+
+	for( int i=0; i<mFrames.size(); i++ ) {
+		delete *( mFrames.getElement( i ) );
+		}
+	
+	delete mLock;
+	delete mFrameSemaphore;
 	}
 
 
 
 inline Image *AxisImageSource::getNextImage() {
 
-	// connect to the camera
-	Socket *mServerSocket =
-		SocketClient::connectToServer( mServerAddress );
+	while( true ) {
+		mLock->lock();
 
-	if( mServerSocket == NULL ) {
-		printf( "connection to camera " );
-		mServerAddress->print();
-		printf( " failed\n" );
+		int numFrames = mFrames.size();
+		
+		if( numFrames > 0 ) {
+			Image *newest = *( mFrames.getElement( numFrames - 1 ) );
+
+			// older frames are stale now
+			for( int i=0; i<numFrames - 1; i++ ) {
+				delete *( mFrames.getElement( i ) );
+				}
+			mNumDropped += numFrames - 1;
+			
+			mFrames.deleteAll();
+			
+			mLock->unlock();
+			
+			return newest;
+			}
 
-		return NULL;
+		char failed = mConnectFailed;
+		
+		mLock->unlock();
+
+		if( failed ) {
+			printf( "connection to camera " );
+			mServerAddress->print();
+			printf( " failed\n" );
+			
+			return NULL;
+			}
+		
+		mFrameSemaphore->wait();
 		}
+	}
 
-	// else we connected successfully
-	
-	mSocketStream = new SocketStream( mServerSocket );
 
-	
-	// buffer for the request string
-	char *requestBuffer = new char[99];
 
-	// compose the request string
+inline int AxisImageSource::getNumDroppedFrames() {
+	mLock->lock();
+	int numDropped = mNumDropped;
+	mLock->unlock();
 
+	return numDropped;
+	}
 
-	/*
-	  FIXME:  specifying any parameters to
-	  image.cgi cause libjpeg to segfault.
-	  
-	sprintf( requestBuffer,
-	"GET /axis-cgi/jpg/image.cgi?resolution=%dx%d&compression=%d HTTP/1.0 \r\nConnection: Keep-Alive \r\nAccept: image/jpeg \r\n\r\n",
-		 mImageWidth, mImageHeight, mCompression );
-	*/
 
-	// for now, just use the camera's default image settings
-	sprintf( requestBuffer,
-			 "GET /jpg/image.jpg HTTP/1.0 \r\nAccept: image/jpeg \r\n\r\n" );
-	
-	// printf( "Sending URL:\n" );
-	// printf( "%s", requestBuffer );
-	
-	// send our request buffer through the socket
-	mSocketStream->write( (unsigned char *)requestBuffer,
-						  strlen( requestBuffer ) );
 
-	
-	unsigned char *buffer = new unsigned char[1];
-	buffer[0] = 0;
-
-	// printf( "Reading response:\n" );
-	// read past 3 newlines
-	// our model of camera doesn't send the image size in its response
-	for( int i=0; i<3; i++ ) {
-		// look for the ascii code for \n
-		while( buffer[0] != 10 ) {
-			mSocketStream->read( buffer, 1 );
-			// printf( "%c", buffer[0] );
+inline void AxisImageSource::run() {
+
+	while( ! isStopped() ) {
+		
+		char timedOut;
+		Socket *serverSocket =
+			SocketClient::connectToServer( mServerAddress,
+										   AXIS_IMAGE_SOURCE_TIMEOUT,
+										   &timedOut );
+
+		if( serverSocket == NULL ) {
+			setConnectFailed( true );
+			
+			sleep( AXIS_IMAGE_SOURCE_RETRY_DELAY );
+			continue;
+			}
+
+		SocketStream *stream = new SocketStream( serverSocket );
+		stream->setReadTimeout( AXIS_IMAGE_SOURCE_TIMEOUT );
+
+		mReadPosition = 0;
+		mReadLength = 0;
+		
+		char requestBuffer[200];
+
+		if( mStreamSupported ) {
+			sprintf( requestBuffer,
+					 "GET /axis-cgi/mjpg/video.cgi?"
+					 "resolution=%dx%d&compression=%d HTTP/1.0\r\n"
+					 "Accept: multipart/x-mixed-replace\r\n\r\n",
+					 mImageWidth, mImageHeight, mCompression );
+			}
+		else {
+			// camera's default image settings
+			sprintf( requestBuffer,
+					 "GET /jpg/image.jpg HTTP/1.0\r\n"
+					 "Accept: image/jpeg\r\n\r\n" );
+			}
+
+		int requestLength = strlen( requestBuffer );
+		
+		if( stream->write( (unsigned char *)requestBuffer,
+						   requestLength ) != requestLength ) {
+			delete stream;
+			delete serverSocket;
+
+			setConnectFailed( true );
+			sleep( AXIS_IMAGE_SOURCE_RETRY_DELAY );
+			continue;
+			}
+
+		if( mStreamSupported ) {
+			
+			if( ! readLineContaining( stream, " 200" ) ) {
+				// no stream from this camera, poll for images instead
+				mStreamSupported = false;
+				}
+			else {
+				// multipart headers have no 0xFF bytes, so
+				// readNextJPEG skips them while looking for the
+				// start marker
+				Image *image = readNextJPEG( stream );
+
+				while( image != NULL ) {
+					addFrame( image );
+
+					if( isStopped() ) {
+						break;
+						}
+					image = readNextJPEG( stream );
+					}
+				}
+			}
+		else {
+			// camera doesn't keep connection alive between images,
+			// so this is one image per connection
+			Image *image = readNextJPEG( stream );
+
+			if( image != NULL ) {
+				addFrame( image );
+				}
+			}
+		
+		delete stream;
+		delete serverSocket;
+
+		if( ! mStreamSupported ) {
+			// stay just one image ahead, rather than hammering the
+			// camera with requests that will only be dropped
+			while( ! isStopped() && getNumFramesWaiting() > 0 ) {
+				sleep( 5 );
+				}
 			}
-		buffer[0] = 0;
 		}
 
-	// printf( "read 3 newlines\n" );
-	
-	// the next thing in the stream is our jpeg data
-	Image *returnImage = mConverter->deformatImage( mSocketStream );
+	// wake up any getNextImage still waiting
+	setConnectFailed( true );
+	}
+
+
 
-	// printf( "read and converted jpeg image\n" );
+inline int AxisImageSource::readByte( SocketStream *inStream ) {
+	if( mReadPosition >= mReadLength ) {
+		long numRead = 
+			inStream->readAvailable( mReadBuffer,
+									 AXIS_IMAGE_SOURCE_READ_BUFFER_SIZE );
+		
+		if( numRead <= 0 ) {
+			return -1;
+			}
+
+		mReadPosition = 0;
+		mReadLength = numRead;
+		}
+
+	return mReadBuffer[ mReadPosition++ ];
+	}
+
+
+
+inline char AxisImageSource::readLineContaining( SocketStream *inStream,
+												 const char *inText ) {
+	char line[200];
+	int length = 0;
+
+	int c = readByte( inStream );
 	
-	// finally, read the last two line end characters
-	mSocketStream->read( buffer, 1 );
-	mSocketStream->read( buffer, 1 );
+	while( c != -1 && c != '\n' ) {
+		if( length < 199 ) {
+			line[ length ] = (char)c;
+			length++;
+			}
+		c = readByte( inStream );
+		}
+	line[ length ] = '\0';
+
+	return ( strstr( line, inText ) != NULL );
+	}
+
 
-	delete [] buffer;
 
+inline Image *AxisImageSource::readNextJPEG( SocketStream *inStream ) {
+
+	// find start marker (0xFFD8)
+	int previous = -1;
+	int c = readByte( inStream );
+
+	while( c != -1 && ! ( previous == 0xFF && c == 0xD8 ) ) {
+		previous = c;
+		c = readByte( inStream );
+		}
+
+	if( c == -1 ) {
+		return NULL;
+		}
+
+	SimpleVector<unsigned char> data;
+	data.push_back( 0xFF );
+	data.push_back( 0xD8 );
+
+	// gather through end marker (0xFFD9)
+	previous = c;
+	c = readByte( inStream );
 	
-	delete [] requestBuffer;
+	while( c != -1 ) {
+		data.push_back( (unsigned char)c );
+
+		if( previous == 0xFF && c == 0xD9 ) {
+			break;
+			}
+		previous = c;
+		c = readByte( inStream );
+		}
+
+	if( c == -1 ) {
+		// cut off mid-image
+		return NULL;
+		}
+
+	unsigned char *dataBytes = data.getElementArray();
 
-	// close the socket, since the camera doesn't seem
-	// to keep it alive anyway
-	delete mSocketStream;
-	delete mServerSocket;
+	Image *image = JPEGImageConverter::decodeToImage( dataBytes,
+													   data.size() );
 
+	delete [] dataBytes;
 
-	// return image will be NULL if JPEG decompression failed.
-	return returnImage;
+	return image;
 	}
 
 
 
-#endif
+inline void AxisImageSource::addFrame( Image *inImage ) {
+	mLock->lock();
+
+	if( mFrames.size() >= AXIS_IMAGE_SOURCE_RING_SIZE ) {
+		// caller is falling behind, drop oldest
+		delete *( mFrames.getElement( 0 ) );
+		mFrames.deleteElement( 0 );
+		mNumDropped++;
+		}
+	
+	mFrames.push_back( inImage );
+	mConnectFailed = false;
+	
+	mLock->unlock();
+
+	mFrameSemaphore->signal();
+	}
 
 
 
+inline int AxisImageSource::getNumFramesWaiting() {
+	mLock->lock();
+	int numFrames = mFrames.size();
+	mLock->unlock();
 
+	return numFrames;
+	}
 
 
 
+inline void AxisImageSource::setConnectFailed( char inFailed ) {
+	mLock->lock();
+	mConnectFailed = inFailed;
+	mLock->unlock();
+
+	if( inFailed ) {
+		mFrameSemaphore->signal();
+		}
+	}
+
+
+
+#endif
@@ -9,6 +9,9 @@
  *
  * 2001-February-21		Jason Rohrer
  * Added a constructor for setting defaults.
+ *
+ * 2026-October-15		Jason Rohrer
+ * Added a virtual destructor.
  */
  
  
@@ -27,6 +30,10 @@ class EdgeDetector {
 	
 	public:
 		
+		virtual ~EdgeDetector() {
+			}
+		
+		
 		/**
 		 * Sets the image channel to be processed.
 		 * Note that if this channel is out of range for an image pair,
@@ -6,6 +6,11 @@
  *
  * 2001-February-26		Jason Rohrer
  * Optimized.     
+ *
+ * 2026-October-15		Jason Rohrer
+ * Window costs from running sums instead of re-summing each window.
+ * SIMD squared differences.
+ * Added computeDepthRows, which writes a band straight into a shared map.
  */
  
  
@@ -18,10 +23,9 @@
 
 #include "minorGems/util/random/RandomSource.h"
 
-#include "minorGems/graphics/ImageColorConverter.h"
-
 #include <float.h>
 #include <limits.h>
+#include <math.h>
 #include <stdio.h>
 
 /**
@@ -50,6 +54,10 @@ class LocalWindowStereo : public PartialStereo {
 		virtual Image *computeDepthMap( Image *inLeft, Image *inRight );
 		virtual Stereo *copy();
 		
+		// implements the PartialStereo interface
+		virtual char computeDepthRows( Image *inLeft, Image *inRight,
+			int inYStart, int inYEnd, Image *inDepthMap );
+		
 	private:
 		int mWindowSize;
 		
@@ -78,20 +86,87 @@ inline Stereo *LocalWindowStereo::copy() {
 
 
 
-// note that this code is a little messy, because it was copied
-// from	localStereo.cpp without much modification.
+#if defined( __SSE2__ ) || defined( _M_X64 ) || \
+    ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+	#define LOCAL_WINDOW_STEREO_SSE2
+	#include <emmintrin.h>
+#elif defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+	#define LOCAL_WINDOW_STEREO_NEON
+	#include <arm_neon.h>
+#endif
+
+
+
+/**
+ * Squared differences of two byte arrays.
+ *
+ * Squares of byte differences fit in 16 bits, so this is an absolute
+ * difference and a widening multiply, 16 pixels at a time with SSE2 or NEON.
+ *
+ * @param inA, inB the arrays to compare.
+ * @param outDiffs where ( inA[i] - inB[i] )^2 should be returned.
+ * @param inCount the number of bytes in each array.
+ */
+inline void localWindowSquaredDiffs( const unsigned char *inA,
+									 const unsigned char *inB,
+									 unsigned short *outDiffs,
+									 int inCount ) {
+	int i = 0;
+
+#if defined( LOCAL_WINDOW_STEREO_SSE2 )
+	__m128i zero = _mm_setzero_si128();
+
+	for( ; i + 16 <= inCount; i += 16 ) {
+		__m128i a = _mm_loadu_si128( (const __m128i *)&( inA[i] ) );
+		__m128i b = _mm_loadu_si128( (const __m128i *)&( inB[i] ) );
+
+		// saturating subtract both ways, one of which is 0
+		__m128i absDiff = _mm_or_si128( _mm_subs_epu8( a, b ),
+										_mm_subs_epu8( b, a ) );
+
+		__m128i low = _mm_unpacklo_epi8( absDiff, zero );
+		__m128i high = _mm_unpackhi_epi8( absDiff, zero );
+
+		// at most 255^2, so low 16 bits of product are exact
+		_mm_storeu_si128( (__m128i *)&( outDiffs[i] ),
+						  _mm_mullo_epi16( low, low ) );
+		_mm_storeu_si128( (__m128i *)&( outDiffs[ i + 8 ] ),
+						  _mm_mullo_epi16( high, high ) );
+		}
+#elif defined( LOCAL_WINDOW_STEREO_NEON )
+	for( ; i + 16 <= inCount; i += 16 ) {
+		uint8x16_t absDiff = vabdq_u8( vld1q_u8( &( inA[i] ) ),
+									   vld1q_u8( &( inB[i] ) ) );
+
+		uint8x8_t low = vget_low_u8( absDiff );
+		uint8x8_t high = vget_high_u8( absDiff );
+
+		vst1q_u16( &( outDiffs[i] ), vmull_u8( low, low ) );
+		vst1q_u16( &( outDiffs[ i + 8 ] ), vmull_u8( high, high ) );
+		}
+#endif
+
+	for( ; i < inCount; i++ ) {
+		int diff = inA[i] - inB[i];
+		outDiffs[i] = (unsigned short)( diff * diff );
+		}
+	}
+
+
+
+// Window costs (sum of squared differences) are box-filtered with running
+// sums, one disparity at a time:  squared differences for every pixel,
+// then column sums slid down the image, then window sums slid across each
+// row.  Each pixel costs the same for any window size.
 inline Image *LocalWindowStereo::computeDepthMap( Image *inLeft, 
 	Image *inRight ) {
 
-	char *functionName = "localStereo";
+	const char *functionName = "localStereo";
 	
 	
 	int w = inLeft->getWidth();
 	int h = inLeft->getHeight();
 
-	//printf( "%s: Computing stereo.\n", 
-	//		functionName );
-
 	if( h != inRight->getHeight() || w != inRight->getWidth() ) {
 		// image sizes don't match
 		printf( "%s: Left and right images must be the same size.\n", 
@@ -99,9 +174,28 @@ inline Image *LocalWindowStereo::computeDepthMap( Image *inLeft,
 		return NULL;
 		}
 
+	// singled channeled stereo map
+	Image *outImage = new Image( w, h, 1 );
+	
+	computeDepthRows( inLeft, inRight, 0, h - 1, outImage );
+	
+	return outImage;
+	}
+
+
 
-	int numPixels = w*h;
+inline char LocalWindowStereo::computeDepthRows( Image *inLeft, 
+	Image *inRight, int inYStart, int inYEnd, Image *inDepthMap ) {
 	
+	int w = inLeft->getWidth();
+	int h = inLeft->getHeight();
+
+	if( h != inRight->getHeight() || w != inRight->getWidth() ||
+		h != inDepthMap->getHeight() || w != inDepthMap->getWidth() ) {
+		return false;
+		}
+
+
 	int boxRad = ( mWindowSize / 2 );		// radius of window
 	
 	int extra;
@@ -115,27 +209,9 @@ inline Image *LocalWindowStereo::computeDepthMap( Image *inLeft,
 		}
 
 
-	// singled channeled stereo map
-	Image *outImage = new Image( w, h, 1 );
-	
-	
 	// output channel
-	double *outChannel = outImage->getChannel( 0 );
-
-	// convert incoming double channels to byte arrays
-	// this should improve running time
-	unsigned char *leftChannel = 
-		ImageColorConverter::grayscaleToByteArray( inLeft, mChannelNumber );
-	unsigned char *rightChannel = 
-		ImageColorConverter::grayscaleToByteArray( inRight, mChannelNumber );
+	double *outChannel = inDepthMap->getChannel( 0 );
 
-
-	// y offsets for fast array access
-	int *yOffset = new int[h];
-	for( int i=0; i<h; i++ ) {
-		yOffset[i] = i * w;
-		}
-	
 	
 	int yStart = (int)( mYStart * h );
 	int yEnd = (int)( mYEnd * h ) - 1;
@@ -158,79 +234,170 @@ inline Image *LocalWindowStereo::computeDepthMap( Image *inLeft,
 		xEnd = w - boxRad - 1;
 		}
 	
+	// only our band
+	if( yStart < inYStart ) {
+		yStart = inYStart;
+		}
+	if( yEnd > inYEnd ) {
+		yEnd = inYEnd;
+		}
+
+	if( yStart > yEnd || xStart > xEnd ) {
+		return true;
+		}
+
+
+	// window covers startBox pixels before center and boxRad after
+	int windowSize = startBox + 1 + boxRad;
+	
+	// pixels touched by some window
+	int rowStart = yStart - startBox;
+	int numRows = ( yEnd + boxRad ) - rowStart + 1;
 	
-	for( int y=yStart; y<=yEnd; y++ ) {		// for each pixel in image
-		//printf( "row %d\n", y);
-		for( int x=xStart; x<=xEnd; x++ ) {
-			
-			int bestDispL2 = 0;
-			long costOfBestL2 = LONG_MAX;
+	int colStart = xStart - startBox;
+	int numCols = ( xEnd + boxRad ) - colStart + 1;
+
+	int regionWidth = xEnd - xStart + 1;
+	int numRegionPixels = regionWidth * ( yEnd - yStart + 1 );
+
+
+	// convert rows that windows touch to bytes, as in
+	// ImageColorConverter::grayscaleToByteArray
+	unsigned char *leftChannel = new unsigned char[ numRows * w ];
+	unsigned char *rightChannel = new unsigned char[ numRows * w ];
+	
+	double *leftGray = 
+		&( inLeft->getChannel( mChannelNumber )[ rowStart * w ] );
+	double *rightGray = 
+		&( inRight->getChannel( mChannelNumber )[ rowStart * w ] );
+	
+	for( int i=0; i<numRows * w; i++ ) {
+		leftChannel[i] = (unsigned char)( lrint( 255 * leftGray[i] ) );
+		rightChannel[i] = (unsigned char)( lrint( 255 * rightGray[i] ) );
+		}
+
+	
+	// squared differences at current disparity
+	unsigned short *diffs = new unsigned short[ numRows * numCols ];
+
+	// sums down each column of current window row span
+	unsigned int *columnSums = new unsigned int[ numCols ];
+	
+	long *costOfBest = new long[ numRegionPixels ];
+	int *bestDisp = new int[ numRegionPixels ];
+
+	for( int i=0; i<numRegionPixels; i++ ) {
+		costOfBest[i] = LONG_MAX;
+		bestDisp[i] = 0;
+		}
+
+	
+	// d towards left, where pixel should land in R image
+	for( int d=0; d<=mMaxDisparity; d++ ) {
+
+		// columns at or left of this land outside R image when moved by d
+		int numOutside = d + 1 - colStart;
+		if( numOutside < 0 ) {
+			numOutside = 0;
+			}
+		if( numOutside > numCols ) {
+			numOutside = numCols;
+			}
+		
+		for( int r=0; r<numRows; r++ ) {
+			// byte rows start at rowStart
+			int imageIndex = r * w + colStart;
 			
+			unsigned char *leftRow = &( leftChannel[ imageIndex ] );
+			unsigned short *diffRow = &( diffs[ r * numCols ] );
 			
-			// look at each possible displacement for this pixel and it's window
+			// shouldn't let these slip through with no cost, or pixels
+			// will prefer to be displaced outside the image
+			// compare them to random intensity values
+			for( int c=0; c<numOutside; c++ ) {
+				int diff = leftRow[c] - 
+					mRandSource->getRandomBoundedInt( 0, 255 );
+				diffRow[c] = (unsigned short)( diff * diff );
+				}
+
+			localWindowSquaredDiffs(
+				&( leftRow[ numOutside ] ),
+				&( rightChannel[ imageIndex + numOutside - d ] ),
+				&( diffRow[ numOutside ] ),
+				numCols - numOutside );
+			}
+		
+
+		// column sums for first row of windows
+		for( int c=0; c<numCols; c++ ) {
+			columnSums[c] = 0;
+			}
+		for( int r=0; r<windowSize; r++ ) {
+			unsigned short *diffRow = &( diffs[ r * numCols ] );
 			
-				// (d towards left, where pixel should land in R image)
-			for( int d=0; d<=mMaxDisparity; d++ ) {
+			for( int c=0; c<numCols; c++ ) {
+				columnSums[c] += diffRow[c];
+				}
+			}
+		
+		for( int y=yStart; y<=yEnd; y++ ) {
+			int r = y - yStart;
 			
-				long thisCostL2 = 0;
+			if( r > 0 ) {
+				// slide down one row
+				unsigned short *enterRow = 
+					&( diffs[ ( r + windowSize - 1 ) * numCols ] );
+				unsigned short *leaveRow = &( diffs[ ( r - 1 ) * numCols ] );
 				
-				// for each pixel in window
-				for( int delY = -startBox; delY<=boxRad; delY++ ) {
-					int thisYOffset = yOffset[  y + delY ];
-					
-					for( int delX = -startBox; delX<=boxRad; delX++ ) {
-						
-						// optimization
-						register int xPlusDelX = x + delX;
-						
-						int windowPixInd = thisYOffset + xPlusDelX;
-					
-						long valLeft = leftChannel[ windowPixInd ];
-						
-						long valRight;
-						
-					
-						if( xPlusDelX - d > 0 ) {		// pixel lands in right image when moved by d
-							valRight = rightChannel[ windowPixInd - d ];
-							}
-						else {		// pixel lands outside R-image when displaced by d
-							// shouldn't let this slip through with no cost, or pixels
-							// will prefer to be displaced outside the image
-							// give them random intensity value.
-							
-							valRight = 
-								mRandSource->getRandomBoundedInt( 
-									0, 255 );
-							}	
-						
-						// calculate L1 for this landing place in right image
-						register long diff = valLeft - valRight;
-						
-						// calculate L2 for this landing place in right image
-						// add to total L2 cost for this displacement of this window
-						thisCostL2 += diff * diff;
-						}
+				for( int c=0; c<numCols; c++ ) {
+					columnSums[c] += enterRow[c];
+					columnSums[c] -= leaveRow[c];
 					}
-				
-				if( thisCostL2 < costOfBestL2 ) {		// check if new better L2 displ. found
-					bestDispL2 = d;
-					costOfBestL2 = thisCostL2;
+				}
+
+			long windowSum = 0;
+			for( int c=0; c<windowSize; c++ ) {
+				windowSum += columnSums[c];
+				}
+			
+			long *rowCosts = &( costOfBest[ r * regionWidth ] );
+			int *rowDisps = &( bestDisp[ r * regionWidth ] );
+
+			for( int i=0; i<regionWidth; i++ ) {
+				if( i > 0 ) {
+					// slide right one column
+					windowSum += columnSums[ i + windowSize - 1 ];
+					windowSum -= columnSums[ i - 1 ];
 					}
-				}	// end loop over all displacements
 				
-			
-			// found best displacement, write it into L1 and L2 image buffers
-			outChannel[ yOffset[y] + x ] = 
-				(double)bestDispL2 / (double)mMaxDisparity;
-			
-			}	// end loop over all x coords
-		}	// end loop over all y coords
+				// strictly better, so ties go to smallest disparity
+				if( windowSum < rowCosts[i] ) {
+					rowCosts[i] = windowSum;
+					rowDisps[i] = d;
+					}
+				}
+			}
+		}	// end loop over all displacements
+		
 
-	delete [] yOffset;
+	for( int y=yStart; y<=yEnd; y++ ) {
+		int *rowDisps = &( bestDisp[ ( y - yStart ) * regionWidth ] );
+		
+		for( int x=xStart; x<=xEnd; x++ ) {
+			outChannel[ y * w + x ] = 
+				(double)rowDisps[ x - xStart ] / (double)mMaxDisparity;
+			}
+		}
+	
+
+	delete [] diffs;
+	delete [] columnSums;
+	delete [] costOfBest;
+	delete [] bestDisp;
 	delete [] leftChannel;
 	delete [] rightChannel;
 	
-	return outImage;
+	return true;
 	}
 		
 		
@@ -2,69 +2,142 @@
  * Modification History
  *
  * 2001-February-26		Jason Rohrer
- * Created.     
+ * Created.
+ *
+ * 2026-October-15		Jason Rohrer
+ * Sends only the rows a band needs, as compressed bytes, instead of both
+ * whole images as doubles.  Bands can be sent ahead of receiving earlier
+ * results.
  */
- 
- 
+
+
 #ifndef NETWORKED_PARTIAL_STEREO_INCLUDED
-#define NETWORKED_PARTIAL_STEREO_INCLUDED 
+#define NETWORKED_PARTIAL_STEREO_INCLUDED
 
 
 #include "PartialStereo.h"
-#include "EdgeDetector.h"
+#include "StereoBandTransport.h"
 
 #include "minorGems/network/SocketStream.h"
 
-#include "minorGems/graphics/ImageColorConverter.h"
-
 #include <float.h>
 #include <limits.h>
 #include <stdio.h>
 
 /**
  * Partial stereo implementation that sends data over the network
- * to be processed.
+ * to be processed, by a server running serveStereoBands (see
+ * partialStereoServer).
+ *
+ * Bands can be pipelined:  several sendBand calls can go out before the
+ * matching receiveBand calls, and the server works on them in order.
  *
  * @author Jason Rohrer
  */
 class NetworkedPartialStereo : public PartialStereo {
-	
+
 	public:
-		
+
 		/**
-		 * Constructs a local window stereo object.
+		 * Constructs a networked stereo object.
 		 *
 		 * @param inStream the network stream to send source
 		 *   images and received produced images on.  Must be
 		 *   destroyed by caller.
 		 */
 		NetworkedPartialStereo( SocketStream *inStream );
-		
-		
+
+
 		// implements the stereo interface
 		virtual Image *computeDepthMap( Image *inLeft, Image *inRight );
-		
+
 		// this is provided to fully implement Stereo, but
-		// note that because of the underlying SocketStream, 
+		// note that because of the underlying SocketStream,
 		// making a copy of an instance of this class doesn't
 		// make sense.
 		// Currently returns NULL.
 		virtual Stereo *copy();
-		
+
+
+		// implements the PartialStereo interface
+		// (sendBand followed by receiveBand)
+		virtual char computeDepthRows( Image *inLeft, Image *inRight,
+			int inYStart, int inYEnd, Image *inDepthMap );
+
+
+		/**
+		 * Sends a band of rows to the server, along with the rows
+		 * around it that the server needs.
+		 *
+		 * Uses the x range set by setRange, but not the y range.
+		 *
+		 * @param inLeft the left image.  Destroyed by caller.
+		 * @param inRight the right image.  Destroyed by caller.
+		 * @param inYStart the first row of the band.
+		 * @param inYEnd the last row of the band, inclusive.
+		 *
+		 * @return true on success, or false on a network error or if
+		 *   the images aren't the same size.
+		 */
+		char sendBand( Image *inLeft, Image *inRight,
+			int inYStart, int inYEnd );
+
+
+		/**
+		 * Receives the depth rows for the oldest band sent.
+		 *
+		 * @param inDepthMap the depth map to write the band's rows into.
+		 *   Must be the size of the images sent.  Destroyed by caller.
+		 * @param outComputeSeconds pointer to where the time the server
+		 *   spent on the band should be returned, or NULL.
+		 *
+		 * @return true on success, or false on a network error or bad
+		 *   data.
+		 */
+		char receiveBand( Image *inDepthMap,
+			double *outComputeSeconds = NULL );
+
+
+		// bytes sent and received so far
+		long getNumBytesSent();
+		long getNumBytesReceived();
+
+
 	private:
 		SocketStream *mStream;
+
+		// -1 until hello received from server
+		int mRowMargin;
+
+		int mNextSendSequence;
+		int mNextReceiveSequence;
+
+		long mNumBytesSent;
+		long mNumBytesReceived;
+
+		ZipCompressor mCompressor;
+		ZipDecompressor mDecompressor;
+
+		SimpleVector<unsigned char> mMessage;
+
+
+		// returns false on error
+		char receiveHello();
 	};
 
 
 
-inline NetworkedPartialStereo::NetworkedPartialStereo( 
+inline NetworkedPartialStereo::NetworkedPartialStereo(
 	SocketStream *inStream )
-	: PartialStereo( 1 ), mStream( inStream ) {
-	
+	: PartialStereo( 1 ), mStream( inStream ), mRowMargin( -1 ),
+	  mNextSendSequence( 0 ), mNextReceiveSequence( 0 ),
+	  mNumBytesSent( 0 ), mNumBytesReceived( 0 ),
+	  mCompressor( STEREO_BAND_ZIP_LEVEL ) {
+
 	// note the "dummy" inMaxDisparity value passed into
 	// the PartialStereo constructor, since disparity
 	// is not used on this end of the stream
-	
+
 	}
 
 
@@ -76,30 +149,192 @@ inline Stereo *NetworkedPartialStereo::copy() {
 
 
 
-// note that this code is a little messy, because it was copied
-// from	localStereo.cpp without much modification.
-inline Image *NetworkedPartialStereo::computeDepthMap( Image *inLeft, 
+inline Image *NetworkedPartialStereo::computeDepthMap( Image *inLeft,
 	Image *inRight ) {
-	
-	// first, send ranges, x and then y
-	mStream->writeDouble( mXStart );
-	mStream->writeDouble( mXEnd );
-	mStream->writeDouble( mYStart );
-	mStream->writeDouble( mYEnd );
-	
-	
-	// send left, then right images
-	inLeft->serialize( mStream );
-	inRight->serialize( mStream );
-	
-	// the receive the result
-	Image *outImage = new Image( 1, 1, 1 );
-	outImage->deserialize( mStream );
-	
-	
+
+	int w = inLeft->getWidth();
+	int h = inLeft->getHeight();
+
+	Image *outImage = new Image( w, h, 1 );
+
+	int yStart = (int)( mYStart * h );
+	int yEnd = (int)( mYEnd * h ) - 1;
+
+	if( yStart <= yEnd &&
+		! computeDepthRows( inLeft, inRight, yStart, yEnd, outImage ) ) {
+		delete outImage;
+		return NULL;
+		}
+
 	return outImage;
 	}
-		
-		
-		
+
+
+
+inline char NetworkedPartialStereo::computeDepthRows( Image *inLeft,
+	Image *inRight, int inYStart, int inYEnd, Image *inDepthMap ) {
+
+	return sendBand( inLeft, inRight, inYStart, inYEnd ) &&
+		receiveBand( inDepthMap );
+	}
+
+
+
+inline char NetworkedPartialStereo::receiveHello() {
+	int hello[ STEREO_BAND_HELLO_INTS ];
+
+	if( ! stereoBandReadInts( mStream, hello, STEREO_BAND_HELLO_INTS ) ||
+		hello[0] != STEREO_BAND_MAGIC || hello[1] < 0 ) {
+		printf( "NetworkedPartialStereo:  bad hello from server\n" );
+		return false;
+		}
+
+	mNumBytesReceived += 4 * STEREO_BAND_HELLO_INTS;
+
+	mRowMargin = hello[1];
+	setMaxDisparity( hello[2] );
+
+	return true;
+	}
+
+
+
+inline char NetworkedPartialStereo::sendBand( Image *inLeft, Image *inRight,
+	int inYStart, int inYEnd ) {
+
+	int w = inLeft->getWidth();
+	int h = inLeft->getHeight();
+
+	if( h != inRight->getHeight() || w != inRight->getWidth() ||
+		inYStart < 0 || inYEnd >= h || inYStart > inYEnd ) {
+		return false;
+		}
+
+	if( mRowMargin == -1 && ! receiveHello() ) {
+		return false;
+		}
+
+	int rowStart = inYStart - mRowMargin;
+	int rowEnd = inYEnd + mRowMargin;
+
+	if( rowStart < 0 ) {
+		rowStart = 0;
+		}
+	if( rowEnd > h - 1 ) {
+		rowEnd = h - 1;
+		}
+
+	int numRows = rowEnd - rowStart + 1;
+	int numPixels = w * numRows;
+
+	unsigned char *bytes = new unsigned char[ 2 * numPixels ];
+
+	stereoBandPackRows(
+		&( inLeft->getChannel( mChannelNumber )[ rowStart * w ] ),
+		w, numRows, 255, bytes );
+	stereoBandPackRows(
+		&( inRight->getChannel( mChannelNumber )[ rowStart * w ] ),
+		w, numRows, 255, &( bytes[ numPixels ] ) );
+
+	SimpleVector<unsigned char> compressed;
+	mCompressor.compress( bytes, 2 * numPixels, &compressed, ZIP_FINISH );
+
+	delete [] bytes;
+
+	// header and data in one write
+	mMessage.deleteAll();
+	stereoBandPushInt( &mMessage, mNextSendSequence );
+	stereoBandPushInt( &mMessage, w );
+	stereoBandPushInt( &mMessage, h );
+	stereoBandPushInt( &mMessage, inYStart );
+	stereoBandPushInt( &mMessage, inYEnd );
+	stereoBandPushInt( &mMessage, rowStart );
+	stereoBandPushInt( &mMessage, numRows );
+	stereoBandPushInt( &mMessage, compressed.size() );
+	mMessage.push_back( compressed.getElementFast( 0 ), compressed.size() );
+
+	if( mStream->write( mMessage.getElementFast( 0 ), mMessage.size() ) !=
+		mMessage.size() ) {
+		return false;
+		}
+
+	mNumBytesSent += mMessage.size();
+	mNextSendSequence++;
+
+	return true;
+	}
+
+
+
+inline char NetworkedPartialStereo::receiveBand( Image *inDepthMap,
+	double *outComputeSeconds ) {
+
+	if( mNextReceiveSequence == mNextSendSequence ) {
+		printf( "NetworkedPartialStereo:  no band waiting to be "
+				"received\n" );
+		return false;
+		}
+
+	int w = inDepthMap->getWidth();
+	int h = inDepthMap->getHeight();
+
+	int header[ STEREO_BAND_RESULT_INTS ];
+
+	if( ! stereoBandReadInts( mStream, header, STEREO_BAND_RESULT_INTS ) ) {
+		return false;
+		}
+
+	int sequence = header[0];
+	int bandStart = header[1];
+	int numBandRows = header[2];
+	int scale = header[3];
+	int computeMicroseconds = header[4];
+	int compressedLength = header[5];
+
+	if( sequence != mNextReceiveSequence ||
+		bandStart < 0 || numBandRows <= 0 || bandStart + numBandRows > h ||
+		scale <= 0 ) {
+		printf( "NetworkedPartialStereo:  bad band result header\n" );
+		return false;
+		}
+
+	mNextReceiveSequence++;
+
+	unsigned char *bytes = stereoBandReadCompressed(
+		mStream, compressedLength, w * numBandRows, &mDecompressor );
+
+	if( bytes == NULL ) {
+		printf( "NetworkedPartialStereo:  bad band result data\n" );
+		return false;
+		}
+
+	mNumBytesReceived += 4 * STEREO_BAND_RESULT_INTS + compressedLength;
+
+	stereoBandUnpackRows(
+		bytes, w, numBandRows, scale,
+		&( inDepthMap->getChannel( 0 )[ bandStart * w ] ) );
+
+	delete [] bytes;
+
+	if( outComputeSeconds != NULL ) {
+		*outComputeSeconds = computeMicroseconds / 1000000.0;
+		}
+
+	return true;
+	}
+
+
+
+inline long NetworkedPartialStereo::getNumBytesSent() {
+	return mNumBytesSent;
+	}
+
+
+
+inline long NetworkedPartialStereo::getNumBytesReceived() {
+	return mNumBytesReceived;
+	}
+
+
+
 #endif
@@ -2,34 +2,52 @@
  * Modification History
  *
  * 2001-February-26		Jason Rohrer
- * Created.     
+ * Created.
+ *
+ * 2026-October-15		Jason Rohrer
+ * Frames can be pipelined with sendFrame and receiveDepthMap.  Bands are
+ * sized by each server's measured speed.  Parts run on a persistent
+ * ThreadPool instead of a thread per part per frame.
  */
- 
- 
+
+
 #ifndef NETWORKED_STEREO_INCLUDED
-#define NETWORKED_STEREO_INCLUDED 
+#define NETWORKED_STEREO_INCLUDED
 
 #include "Stereo.h"
 #include "NetworkedPartialStereo.h"
-#include "StereoThread.h"
 
 #include "minorGems/network/SocketStream.h"
+#include "minorGems/system/ThreadPool.h"
+#include "minorGems/util/SimpleVector.h"
 
 #include <float.h>
 #include <stdio.h>
 
+
+
+// weight of the newest measurement in a server's rows-per-second rate
+#define NETWORKED_STEREO_RATE_WEIGHT 0.3
+
+
+
 /**
- * Stereo implementation that runs several non-overlapping networked partial
- * stereos in separate threads.
+ * Stereo implementation that splits images into non-overlapping bands,
+ * one per networked partial stereo, and sends them out in parallel.
+ *
+ * Each server's band is sized by how many rows per second it has been
+ * computing, so a slow server doesn't hold up every frame.
+ *
+ * Frames can be pipelined:  call sendFrame for the next frame before
+ * calling receiveDepthMap for the last one, so servers aren't idle while
+ * results travel back and the next frame travels out.
  *
  * @author Jason Rohrer
  */
 class NetworkedStereo : public Stereo {
-	
+
 	public:
-		
-		public:
-		
+
 		/**
 		 * Constructs a multi-threaded, networked stereo object.
 		 *
@@ -40,54 +58,144 @@ class NetworkedStereo : public Stereo {
 		 *   the image into (one section per socket stream connection).
 		 */
 		NetworkedStereo( SocketStream **inStreams, int inNumParts );
-	
+
 		~NetworkedStereo();
-		
+
 		// implements the stereo interface
+		// (sendFrame followed by receiveDepthMap, so any frames already
+		// sent must be received first)
 		virtual Image *computeDepthMap( Image *inLeft, Image *inRight );
-		
+
 		// implementation provided, but actually invoking copy()
 		// does not make sense for this class.
 		// Currently returns NULL.
 		virtual Stereo *copy();
-	
+
+
+		/**
+		 * Sends a frame out to the servers, without waiting for results.
+		 *
+		 * @param inLeft the left image.  Destroyed by caller, and can be
+		 *   destroyed as soon as this call returns.
+		 * @param inRight the right image.  Destroyed by caller.
+		 *
+		 * @return true on success, or false on a network error (after
+		 *   which this stereo can't be used) or if the images aren't the
+		 *   same size.
+		 */
+		char sendFrame( Image *inLeft, Image *inRight );
+
+
+		/**
+		 * Receives the depth map for the oldest frame sent.
+		 *
+		 * @return the depth map, or NULL on a network error or if no
+		 *   frames are waiting.
+		 *   Destroyed by caller.
+		 */
+		Image *receiveDepthMap();
+
+
+		// number of frames sent but not yet received
+		int getNumPendingFrames();
+
+
+		// the number of rows that a part was given in the last frame sent
+		int getNumRows( int inPart );
+
+
+		// bytes sent and received so far, over all streams
+		long getNumBytesSent();
+		long getNumBytesReceived();
+
+
 	private:
 		int mNumParts;
 		SocketStream **mStreams;
-		NetworkedPartialStereo **mStereoComputers;	
+		NetworkedPartialStereo **mStereoComputers;
+
+		ThreadPool *mPool;
+
+		// smoothed rows per second for each part, or 0 if not yet
+		// measured
+		double *mRowsPerSecond;
+
+		// rows each part got in the last frame sent
+		int *mLastNumRows;
+
+
+		typedef struct PendingFrame {
+				int width;
+				int height;
+				// mNumParts + 1 entries, with part i getting rows
+				// [ bandStarts[i], bandStarts[i+1] )
+				int *bandStarts;
+			} PendingFrame;
+
+		// oldest first
+		SimpleVector<PendingFrame> mPendingFrames;
+
+
+		typedef struct PartJob {
+				NetworkedPartialStereo **stereos;
+				int *bandStarts;
+				Image *left;
+				Image *right;
+				Image *depthMap;
+				double *computeSeconds;
+				// set by any part that fails
+				volatile int failed;
+			} PartJob;
+
+		// ThreadPoolRangeFunction over parts
+		static void sendParts( void *inJob, int inStart, int inEnd );
+		static void receiveParts( void *inJob, int inStart, int inEnd );
+
+
+		// fills mNumParts + 1 band starts for an image of inHeight rows
+		void splitRows( int inHeight, int *outBandStarts );
 	};
 
 
 
-inline NetworkedStereo::NetworkedStereo( 
+inline NetworkedStereo::NetworkedStereo(
 	SocketStream **inStreams, int inNumParts )
-	: Stereo( 1 ), mStreams( inStreams ), mNumParts( inNumParts ),
-	mStereoComputers( new NetworkedPartialStereo*[ mNumParts ] ) {
-	
+	: Stereo( 1 ), mNumParts( inNumParts ), mStreams( inStreams ),
+	mStereoComputers( new NetworkedPartialStereo*[ inNumParts ] ),
+	mPool( new ThreadPool( inNumParts ) ),
+	mRowsPerSecond( new double[ inNumParts ] ),
+	mLastNumRows( new int[ inNumParts ] ) {
+
 	// note that we pass a "dummy" inMaxDisparity value into the Stereo
 	// constructor, since disparity is not used on this end of the
 	// streams.
-	
+
 	// setup stereo computers
 	for( int i=0; i<mNumParts; i++ ) {
 		mStereoComputers[i] = new NetworkedPartialStereo( mStreams[i] );
-		
-		double yStart = i / (double)mNumParts;
-		double yEnd =  (i+1) / (double)mNumParts;
-		mStereoComputers[i]->setRange( 0.0, 1.0, yStart, yEnd );
+		mRowsPerSecond[i] = 0;
+		mLastNumRows[i] = 0;
 		}
-		
+
 	}
 
 
 
 inline NetworkedStereo::~NetworkedStereo() {
+	delete mPool;
+
 	for( int i=0; i<mNumParts; i++ ) {
 		delete mStreams[i];
 		delete mStereoComputers[i];
 		}
 	delete [] mStreams;
 	delete [] mStereoComputers;
+	delete [] mRowsPerSecond;
+	delete [] mLastNumRows;
+
+	for( int i=0; i<mPendingFrames.size(); i++ ) {
+		delete [] mPendingFrames.getElementDirect( i ).bandStarts;
+		}
 	}
 
 
@@ -99,111 +207,251 @@ inline Stereo *NetworkedStereo::copy() {
 
 
 
-inline Image *NetworkedStereo::computeDepthMap( 
+inline Image *NetworkedStereo::computeDepthMap(
 	Image *inLeft, Image *inRight ) {
-	
-	
-	// where threads will put pointers to their output images
-	Image **outImages = new Image*[ mNumParts ];
-	
-	StereoThread **threads = new StereoThread*[ mNumParts ];
-	
-	int i;
-	
-	// for each part
-	for( i=0; i<mNumParts; i++ ) {
-		// spawn a thread to wait on each stereo computation
-	
-		
-		// create the thread
-		// don't copy input images since stereo object shouldn't
-		// modify them (so they are accessed in a thread-safe manner)
-		threads[i] = new StereoThread( mStereoComputers[i], 
-			inLeft, inRight, &( outImages[i] ) );
-		
-		// start the thread
-		threads[i]->start();
-		}
-	
-	// now join each thread to wait for them to finish
-	for( i=0; i<mNumParts; i++ ) {
-		threads[i]->join();
-		}
-	
-	// delete the threads and the stereo copies
-	for( i=0; i<mNumParts; i++ ) {
-	
-		delete threads[i];
-		}
-	delete [] threads;
-	
-	// now our out images should be filled.
-	
-	// combine their parts to make a final image
-	
-	// first, make sure they are not NULL
-	char imagesOK = true;
-	for( i=0; i<mNumParts; i++ ) {
-	
-		if( outImages[i] == NULL ) {
-			imagesOK = false;
+
+	if( ! sendFrame( inLeft, inRight ) ) {
+		return NULL;
+		}
+
+	return receiveDepthMap();
+	}
+
+
+
+inline void NetworkedStereo::splitRows( int inHeight,
+	int *outBandStarts ) {
+
+	// unmeasured parts get the average rate of measured ones,
+	// or all parts get equal bands if none are measured yet
+	double measuredSum = 0;
+	int numMeasured = 0;
+
+	for( int i=0; i<mNumParts; i++ ) {
+		if( mRowsPerSecond[i] > 0 ) {
+			measuredSum += mRowsPerSecond[i];
+			numMeasured++;
 			}
 		}
-	if( !imagesOK ) {
-		// delete any ok images and return NULL
-		for( i=0; i<mNumParts; i++ ) {
-			if( outImages[i] != NULL ) {
-				delete outImages[i];
-				}
+
+	double defaultRate = 1;
+	if( numMeasured > 0 ) {
+		defaultRate = measuredSum / numMeasured;
+		}
+
+	double *rates = new double[ mNumParts ];
+	double rateSum = 0;
+
+	for( int i=0; i<mNumParts; i++ ) {
+		rates[i] = mRowsPerSecond[i];
+		if( rates[i] <= 0 ) {
+			rates[i] = defaultRate;
+			}
+		rateSum += rates[i];
+		}
+
+	// cumulative, so rounding never loses or duplicates rows
+	double cumulativeRate = 0;
+	outBandStarts[0] = 0;
+
+	for( int i=0; i<mNumParts; i++ ) {
+		cumulativeRate += rates[i];
+
+		int end = (int)( inHeight * cumulativeRate / rateSum + 0.5 );
+
+		// every part gets at least a row while there are rows left,
+		// so that it keeps being measured
+		if( end <= outBandStarts[i] ) {
+			end = outBandStarts[i] + 1;
+			}
+		if( end > inHeight || i == mNumParts - 1 ) {
+			end = inHeight;
+			}
+
+		outBandStarts[ i + 1 ] = end;
+		}
+
+	delete [] rates;
+	}
+
+
+
+inline void NetworkedStereo::sendParts( void *inJob,
+	int inStart, int inEnd ) {
+
+	PartJob *job = (PartJob *)inJob;
+
+	for( int i=inStart; i<inEnd; i++ ) {
+		int bandStart = job->bandStarts[i];
+		int bandEnd = job->bandStarts[ i + 1 ] - 1;
+
+		if( bandEnd >= bandStart &&
+			! job->stereos[i]->sendBand( job->left, job->right,
+										 bandStart, bandEnd ) ) {
+			job->failed = true;
 			}
-		
-		delete [] outImages;
-		
+		}
+	}
+
+
+
+inline void NetworkedStereo::receiveParts( void *inJob,
+	int inStart, int inEnd ) {
+
+	PartJob *job = (PartJob *)inJob;
+
+	for( int i=inStart; i<inEnd; i++ ) {
+		job->computeSeconds[i] = -1;
+
+		if( job->bandStarts[ i + 1 ] > job->bandStarts[i] &&
+			! job->stereos[i]->receiveBand(
+				job->depthMap, &( job->computeSeconds[i] ) ) ) {
+			job->failed = true;
+			}
+		}
+	}
+
+
+
+inline char NetworkedStereo::sendFrame( Image *inLeft, Image *inRight ) {
+
+	int w = inLeft->getWidth();
+	int h = inLeft->getHeight();
+
+	if( h != inRight->getHeight() || w != inRight->getWidth() ) {
+		return false;
+		}
+
+	PendingFrame frame;
+	frame.width = w;
+	frame.height = h;
+	frame.bandStarts = new int[ mNumParts + 1 ];
+
+	splitRows( h, frame.bandStarts );
+
+	for( int i=0; i<mNumParts; i++ ) {
+		mLastNumRows[i] = frame.bandStarts[ i + 1 ] - frame.bandStarts[i];
+		}
+
+	PartJob job;
+	job.stereos = mStereoComputers;
+	job.bandStarts = frame.bandStarts;
+	job.left = inLeft;
+	job.right = inRight;
+	job.depthMap = NULL;
+	job.computeSeconds = NULL;
+	job.failed = false;
+
+	// parts compress and send at the same time
+	mPool->parallelFor( sendParts, &job, mNumParts );
+
+	if( job.failed ) {
+		delete [] frame.bandStarts;
+		return false;
+		}
+
+	mPendingFrames.push_back( frame );
+
+	return true;
+	}
+
+
+
+inline Image *NetworkedStereo::receiveDepthMap() {
+
+	if( mPendingFrames.size() == 0 ) {
+		printf( "NetworkedStereo:  no frame waiting to be received\n" );
 		return NULL;
 		}
-	else {
-		// the images are ok...
-		
-		// average them together to make our output
-		
-		int w = outImages[0]->getWidth();
-		int h = outImages[0]->getHeight();
-		int numPixels = w * h;
-		
-		Image *finalImage = new Image( w, h, 1 );
-		double *finalChannel = finalImage->getChannel( 0 );
-		
-		int p;
-		
-		// combine all of the output images into the final image
-		for( i=0; i<mNumParts; i++ ) {
-			// y range of this part
-			double yStart = i / (double)mNumParts;
-			double yEnd =  (i+1) / (double)mNumParts;
-			int yIntStart = (int)( h * yStart );
-			int yIntEnd = (int)( h * yEnd - 1 );
-			
-			double *channel = outImages[i]->getChannel( 0 );
-			
-			for( int y=yIntStart; y<=yIntEnd; y++ ) {
-				for( int x=0; x<w; x++ ) {
-					int index = y * w + x;
-					finalChannel[ index ] = channel[ index ];
-					}
+
+	PendingFrame frame = mPendingFrames.getElementDirect( 0 );
+	mPendingFrames.deleteElement( 0 );
+
+	Image *depthMap = new Image( frame.width, frame.height, 1 );
+
+	double *computeSeconds = new double[ mNumParts ];
+
+	PartJob job;
+	job.stereos = mStereoComputers;
+	job.bandStarts = frame.bandStarts;
+	job.left = NULL;
+	job.right = NULL;
+	job.depthMap = depthMap;
+	job.computeSeconds = computeSeconds;
+	job.failed = false;
+
+	// parts write to separate rows of the depth map
+	mPool->parallelFor( receiveParts, &job, mNumParts );
+
+	if( ! job.failed ) {
+		for( int i=0; i<mNumParts; i++ ) {
+			int numRows = frame.bandStarts[ i + 1 ] - frame.bandStarts[i];
+
+			if( computeSeconds[i] < 0 || numRows == 0 ) {
+				continue;
+				}
+
+			// timer resolution
+			if( computeSeconds[i] < 0.000001 ) {
+				computeSeconds[i] = 0.000001;
+				}
+
+			double rate = numRows / computeSeconds[i];
+
+			if( mRowsPerSecond[i] <= 0 ) {
+				mRowsPerSecond[i] = rate;
+				}
+			else {
+				mRowsPerSecond[i] =
+					( 1 - NETWORKED_STEREO_RATE_WEIGHT ) * mRowsPerSecond[i] +
+					NETWORKED_STEREO_RATE_WEIGHT * rate;
 				}
 			}
-		
-		// now delete the temp images
-		for( i=0; i<mNumParts; i++ ) {
-			delete outImages[i];
-			}
-		
-		delete [] outImages;
-			
-		return finalImage;			
 		}
+
+	delete [] computeSeconds;
+	delete [] frame.bandStarts;
+
+	if( job.failed ) {
+		delete depthMap;
+		return NULL;
+		}
+
+	return depthMap;
+	}
+
+
+
+inline int NetworkedStereo::getNumPendingFrames() {
+	return mPendingFrames.size();
+	}
+
+
+
+inline int NetworkedStereo::getNumRows( int inPart ) {
+	return mLastNumRows[ inPart ];
+	}
+
+
+
+inline long NetworkedStereo::getNumBytesSent() {
+	long sum = 0;
+	for( int i=0; i<mNumParts; i++ ) {
+		sum += mStereoComputers[i]->getNumBytesSent();
+		}
+	return sum;
+	}
+
+
+
+inline long NetworkedStereo::getNumBytesReceived() {
+	long sum = 0;
+	for( int i=0; i<mNumParts; i++ ) {
+		sum += mStereoComputers[i]->getNumBytesReceived();
+		}
+	return sum;
 	}
-	
-		
-		
+
+
+
 #endif
@@ -6,6 +6,9 @@
  *
  * 2001-February-26		Jason Rohrer
  * Added a missing include.   
+ *
+ * 2026-October-15		Jason Rohrer
+ * Added computeDepthRows for filling bands of a shared depth map.
  */
  
  
@@ -17,6 +20,8 @@
 
 #include "Stereo.h"
 
+#include <string.h>
+
 /**
  * Extension of Stereo for a class that can compute 
  * depth maps from stereo pairs
@@ -41,6 +46,32 @@ class PartialStereo : public Stereo {
 		void setRange( double inXStart, double inXEnd, 
 			double inYStart, double inYEnd );
 		
+		
+		/**
+		 * Computes depth for a band of rows, writing into an existing
+		 * depth map.
+		 *
+		 * Rows of the band outside the range set by setRange are left
+		 * alone.  Safe to call from several threads at once for bands
+		 * that don't overlap.
+		 *
+		 * The default implementation computes a depth map for the band
+		 * with a copy of this stereo and copies it in.  Subclasses should
+		 * override to write directly.
+		 *
+		 * @param inLeft the left image.
+		 * @param inRight the right image.
+		 * @param inYStart the first row of the band, in pixels.
+		 * @param inYEnd the last row of the band, in pixels, inclusive.
+		 * @param inDepthMap the single channel depth map to write into.
+		 *   Must be the same size as the input images.
+		 *
+		 * @return true on success, or false if images are not the
+		 *   same size or the band could not be computed.
+		 */
+		virtual char computeDepthRows( Image *inLeft, Image *inRight,
+			int inYStart, int inYEnd, Image *inDepthMap );
+		
 	
 	protected:
 		
@@ -73,5 +104,62 @@ inline void PartialStereo::setRange( double inXStart, double inXEnd,
 	}
 
 
+
+inline char PartialStereo::computeDepthRows( Image *inLeft, Image *inRight,
+	int inYStart, int inYEnd, Image *inDepthMap ) {
+	
+	int w = inLeft->getWidth();
+	int h = inLeft->getHeight();
+	
+	if( h != inRight->getHeight() || w != inRight->getWidth() ||
+		h != inDepthMap->getHeight() || w != inDepthMap->getWidth() ) {
+		return false;
+		}
+	
+	PartialStereo *part = (PartialStereo *)( copy() );
+	
+	if( part == NULL ) {
+		return false;
+		}
+	
+	// half-row offsets so that truncation back to pixels lands on
+	// the band's rows
+	double yStart = ( inYStart + 0.5 ) / h;
+	double yEnd = ( inYEnd + 1.5 ) / h;
+	
+	if( yStart < mYStart ) {
+		yStart = mYStart;
+		}
+	if( yEnd > mYEnd ) {
+		yEnd = mYEnd;
+		}
+	
+	part->setRange( mXStart, mXEnd, yStart, yEnd );
+	
+	Image *partMap = part->computeDepthMap( inLeft, inRight );
+	
+	delete part;
+	
+	if( partMap == NULL ) {
+		return false;
+		}
+	
+	double *partChannel = partMap->getChannel( 0 );
+	double *outChannel = inDepthMap->getChannel( 0 );
+	
+	int firstRow = (int)( yStart * h );
+	int lastRow = (int)( yEnd * h ) - 1;
+	
+	for( int y=firstRow; y<=lastRow; y++ ) {
+		memcpy( &( outChannel[ y * w ] ), &( partChannel[ y * w ] ),
+				w * sizeof( double ) );
+		}
+	
+	delete partMap;
+	
+	return true;
+	}
+
+
 	
 #endif
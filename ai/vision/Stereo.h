@@ -9,6 +9,10 @@
  *
  * 2001-February-21		Jason Rohrer
  * Added a default for the channel number.   
+ *
+ * 2026-October-15		Jason Rohrer
+ * Added a virtual destructor, since stereos are destroyed through base
+ * pointers.
  */
  
  
@@ -27,6 +31,10 @@ class Stereo {
 	
 	public:
 		
+		virtual ~Stereo() {
+			}
+		
+		
 		/**
 		 * Creates a stereo object identical to this one.
 		 *
@@ -0,0 +1,324 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15		Jason Rohrer
+ * Created.
+ */
+
+
+#ifndef STEREO_BAND_TRANSPORT_INCLUDED
+#define STEREO_BAND_TRANSPORT_INCLUDED
+
+
+#include "PartialStereo.h"
+
+#include "minorGems/graphics/Image.h"
+#include "minorGems/network/SocketStream.h"
+#include "minorGems/formats/ZipStream.h"
+#include "minorGems/util/SimpleVector.h"
+#include "minorGems/system/Time.h"
+
+#include <math.h>
+#include <stdio.h>
+
+
+
+/*
+ * Binary messages between NetworkedPartialStereo and a stereo server.
+ * All ints are 4 bytes, big-endian.
+ *
+ * On connect, server sends hello:
+ *   magic, rows of margin it needs around a band, max disparity
+ *
+ * Client sends a band request:
+ *   sequence number, image width, image height,
+ *   first and last band row (inclusive),
+ *   first row sent, number of rows sent, compressed length,
+ *   compressed pixel rows (left rows, then right rows)
+ *
+ * Server sends back, in the same order as requests:
+ *   sequence number, first band row, number of band rows,
+ *   depth scale, compute time in microseconds, compressed length,
+ *   compressed depth rows
+ *
+ * Pixel rows are bytes (gray * 255, depth * scale), each stored as its
+ * difference from the byte to its left, and then zipped.  Stereo works
+ * on the same bytes internally, so nothing is lost.
+ *
+ * Requests can be sent before earlier results come back, so a server
+ * starts on the next band as soon as it finishes one.
+ */
+
+#define STEREO_BAND_MAGIC 0x53544231
+
+#define STEREO_BAND_HELLO_INTS 3
+#define STEREO_BAND_REQUEST_INTS 8
+#define STEREO_BAND_RESULT_INTS 6
+
+// fast, since stereo bands are compressed for every frame
+#define STEREO_BAND_ZIP_LEVEL 1
+
+// guards against a corrupt length
+#define STEREO_BAND_MAX_COMPRESSED_LENGTH ( 1 << 28 )
+
+
+
+inline void stereoBandPushInt( SimpleVector<unsigned char> *inVector,
+	int inValue ) {
+
+	unsigned int value = (unsigned int)inValue;
+
+	inVector->push_back( (unsigned char)( value >> 24 ) );
+	inVector->push_back( (unsigned char)( value >> 16 ) );
+	inVector->push_back( (unsigned char)( value >> 8 ) );
+	inVector->push_back( (unsigned char)( value ) );
+	}
+
+
+
+// returns false on a stream error
+inline char stereoBandReadInts( InputStream *inStream, int *outValues,
+	int inNumValues ) {
+
+	unsigned char buffer[ 4 * 16 ];
+
+	if( inNumValues > 16 ||
+		inStream->read( buffer, 4 * inNumValues ) != 4 * inNumValues ) {
+		return false;
+		}
+
+	for( int i=0; i<inNumValues; i++ ) {
+		unsigned char *b = &( buffer[ 4 * i ] );
+
+		outValues[i] = (int)( (unsigned int)b[0] << 24 |
+							  (unsigned int)b[1] << 16 |
+							  (unsigned int)b[2] << 8 |
+							  (unsigned int)b[3] );
+		}
+	return true;
+	}
+
+
+
+// rows of a channel as bytes, lrint( inScale * value ) clamped to [0,255],
+// each stored as its difference from the byte to its left
+inline void stereoBandPackRows( double *inChannel, int inWidth,
+	int inNumRows, double inScale, unsigned char *outBytes ) {
+
+	for( int y=0; y<inNumRows; y++ ) {
+		double *row = &( inChannel[ y * inWidth ] );
+		unsigned char *outRow = &( outBytes[ y * inWidth ] );
+
+		unsigned char last = 0;
+
+		for( int x=0; x<inWidth; x++ ) {
+			long value = lrint( inScale * row[x] );
+
+			if( value < 0 ) {
+				value = 0;
+				}
+			else if( value > 255 ) {
+				value = 255;
+				}
+
+			outRow[x] = (unsigned char)( value - last );
+			last = (unsigned char)value;
+			}
+		}
+	}
+
+
+
+// reverses stereoBandPackRows, with value = byte / inScale
+inline void stereoBandUnpackRows( unsigned char *inBytes, int inWidth,
+	int inNumRows, double inScale, double *outChannel ) {
+
+	double invScale = 1.0 / inScale;
+
+	for( int y=0; y<inNumRows; y++ ) {
+		unsigned char *row = &( inBytes[ y * inWidth ] );
+		double *outRow = &( outChannel[ y * inWidth ] );
+
+		unsigned char last = 0;
+
+		for( int x=0; x<inWidth; x++ ) {
+			last = (unsigned char)( last + row[x] );
+			outRow[x] = last * invScale;
+			}
+		}
+	}
+
+
+
+/**
+ * Reads a compressed block of exactly inExpectedLength bytes.
+ *
+ * @return the bytes, destroyed by caller, or NULL on a stream error or
+ *   bad data.
+ */
+inline unsigned char *stereoBandReadCompressed( InputStream *inStream,
+	int inCompressedLength, int inExpectedLength,
+	ZipDecompressor *inDecompressor ) {
+
+	if( inCompressedLength <= 0 ||
+		inCompressedLength > STEREO_BAND_MAX_COMPRESSED_LENGTH ||
+		inExpectedLength < 0 ) {
+		return NULL;
+		}
+
+	unsigned char *compressed = new unsigned char[ inCompressedLength ];
+
+	if( inStream->read( compressed, inCompressedLength ) !=
+		inCompressedLength ) {
+		delete [] compressed;
+		return NULL;
+		}
+
+	SimpleVector<unsigned char> raw( inExpectedLength );
+
+	inDecompressor->reset();
+
+	char ok = inDecompressor->decompress( compressed, inCompressedLength,
+										  &raw, inExpectedLength );
+	delete [] compressed;
+
+	if( ! ok || ! inDecompressor->isFinished() ||
+		raw.size() != inExpectedLength ) {
+		return NULL;
+		}
+
+	return raw.getElementArray();
+	}
+
+
+
+/**
+ * Serves band requests from one NetworkedPartialStereo connection until
+ * it breaks.
+ *
+ * @param inStream the connection.  Destroyed by caller.
+ * @param inStereo the stereo to compute bands with.  Destroyed by caller.
+ * @param inRowMargin rows above and below a band that inStereo reads
+ *   (half its window size, for a window stereo).
+ * @param inVerbose true to print a line for each band.
+ */
+inline void serveStereoBands( SocketStream *inStream,
+	PartialStereo *inStereo, int inRowMargin, char inVerbose ) {
+
+	ZipCompressor compressor( STEREO_BAND_ZIP_LEVEL );
+	ZipDecompressor decompressor;
+
+	SimpleVector<unsigned char> message;
+
+	int maxDisparity = inStereo->getMaxDisparity();
+
+	stereoBandPushInt( &message, STEREO_BAND_MAGIC );
+	stereoBandPushInt( &message, inRowMargin );
+	stereoBandPushInt( &message, maxDisparity );
+
+	if( inStream->write( message.getElementFast( 0 ), message.size() ) !=
+		message.size() ) {
+		return;
+		}
+
+	// depth values are disparity / maxDisparity, so scaling by
+	// maxDisparity makes them exact bytes
+	double depthScale = maxDisparity;
+	if( depthScale < 1 || depthScale > 255 ) {
+		depthScale = 255;
+		}
+
+	int header[ STEREO_BAND_REQUEST_INTS ];
+
+	while( stereoBandReadInts( inStream, header,
+							   STEREO_BAND_REQUEST_INTS ) ) {
+
+		int sequence = header[0];
+		int w = header[1];
+		int h = header[2];
+		int bandStart = header[3];
+		int bandEnd = header[4];
+		int rowStart = header[5];
+		int numRows = header[6];
+		int compressedLength = header[7];
+
+		if( w <= 0 || h <= 0 || numRows <= 0 ||
+			rowStart < 0 || rowStart + numRows > h ||
+			bandStart < rowStart || bandEnd < bandStart ||
+			bandEnd >= rowStart + numRows ||
+			(long)w * numRows > STEREO_BAND_MAX_COMPRESSED_LENGTH ) {
+			printf( "Bad band request\n" );
+			return;
+			}
+
+		int numPixels = w * numRows;
+
+		unsigned char *bytes = stereoBandReadCompressed(
+			inStream, compressedLength, 2 * numPixels, &decompressor );
+
+		if( bytes == NULL ) {
+			printf( "Bad band request data\n" );
+			return;
+			}
+
+		double startTime = Time::getMonotonicTime();
+
+		// only the rows sent, which the stereo treats as a whole image
+		Image left( w, numRows, 1 );
+		Image right( w, numRows, 1 );
+		Image depth( w, numRows, 1 );
+
+		stereoBandUnpackRows( bytes, w, numRows, 255, left.getChannel( 0 ) );
+		stereoBandUnpackRows( &( bytes[ numPixels ] ), w, numRows, 255,
+							  right.getChannel( 0 ) );
+		delete [] bytes;
+
+		inStereo->setRange( 0, 1, 0, 1 );
+		inStereo->computeDepthRows( &left, &right,
+									bandStart - rowStart,
+									bandEnd - rowStart, &depth );
+
+		int numBandRows = bandEnd - bandStart + 1;
+		int numBandPixels = w * numBandRows;
+
+		unsigned char *depthBytes = new unsigned char[ numBandPixels ];
+
+		stereoBandPackRows(
+			&( depth.getChannel( 0 )[ ( bandStart - rowStart ) * w ] ),
+			w, numBandRows, depthScale, depthBytes );
+
+		SimpleVector<unsigned char> compressed;
+		compressor.compress( depthBytes, numBandPixels, &compressed,
+							 ZIP_FINISH );
+		delete [] depthBytes;
+
+		int computeMicroseconds =
+			(int)( ( Time::getMonotonicTime() - startTime ) * 1000000 );
+
+		message.deleteAll();
+		stereoBandPushInt( &message, sequence );
+		stereoBandPushInt( &message, bandStart );
+		stereoBandPushInt( &message, numBandRows );
+		stereoBandPushInt( &message, (int)depthScale );
+		stereoBandPushInt( &message, computeMicroseconds );
+		stereoBandPushInt( &message, compressed.size() );
+		message.push_back( compressed.getElementFast( 0 ),
+						   compressed.size() );
+
+		if( inStream->write( message.getElementFast( 0 ),
+							 message.size() ) != message.size() ) {
+			return;
+			}
+
+		if( inVerbose ) {
+			printf( "Rows %d to %d of frame %d: %d bytes in, %d out, "
+					"%.3f s\n", bandStart, bandEnd, sequence,
+					compressedLength, compressed.size(),
+					computeMicroseconds / 1000000.0 );
+			}
+		}
+	}
+
+
+
+#endif
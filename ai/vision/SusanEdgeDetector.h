@@ -8,6 +8,11 @@
  * Figured out how to compile so that it will link to susan.c.
  * Still haven't tested it. 
  * Implemented the copy() function that was added to the EdgeDetector interface.  
+ *
+ * 2026-October-15		Jason Rohrer
+ * Reads and returns compact 8-bit images without converting to doubles.
+ * Keeps the brightness LUT between frames.  Splits rows into bands
+ * across the shared ThreadPool.
  */
  
  
@@ -19,15 +24,19 @@
 
 #include "EdgeDetector.h"
 
+#include "minorGems/system/ThreadPool.h"
+
+#include <string.h>
+
+
+// import the C susan functions
+extern "C" {
+	#include "susan.h"
+	}
 
-// the following prototypes must be defined here
-// to import the C susan functions
-extern "C" void susan_find_edges_thresh( uchar *in, 
-	int x_size, int y_size, uchar *binEdges, EDGE_ORIENTATION *orient, 
-	int thresh );
 
-extern "C" void susan_find_edges( uchar *in, 
-	int x_size, int y_size, uchar *binEdges, EDGE_ORIENTATION *orient );
+// smallest band of rows handed to a pool thread
+#define SUSAN_MIN_BAND_ROWS 16
 
 
 
@@ -50,7 +59,12 @@ extern "C" void susan_find_edges( uchar *in,
  *
  * g++ -o myProject myfile.cpp susan.o 
  *
- * The susan.o object file will be linked into your project.
+ * The susan.o object file will be linked into your project, along with
+ * minorGems/system/ThreadPool.cpp.
+ *
+ * Compact 8-bit images (see Image::isCompact) are read directly, and the
+ * edge map is returned as a compact image, so a frame that stays in bytes
+ * is never converted to doubles.
  *
  * @author Jason Rohrer
  */
@@ -66,6 +80,8 @@ class SusanEdgeDetector : public EdgeDetector {
 		 */
 		SusanEdgeDetector( int inThreshold );
 		
+		~SusanEdgeDetector();
+		
 		/**
 		 * Sets the edge-detection threshold.
 		 *
@@ -91,20 +107,49 @@ class SusanEdgeDetector : public EdgeDetector {
 		
 	private:
 		int mThreshold;
-	
+		
+		// for mThreshold, or NULL if not made yet
+		uchar *mBrightnessLUT;
+		
+		
+		typedef struct SusanBandJob {
+				uchar *in;
+				int *response;
+				uchar *mid;
+				EDGE_ORIENTATION *orient;
+				uchar *lut;
+				int wide;
+				int high;
+			} SusanBandJob;
+		
+		// ThreadPoolRangeFunctions over rows
+		static void responseBand( void *inJob, int inStart, int inEnd );
+		static void directionBand( void *inJob, int inStart, int inEnd );
 	
 	};
 
 
 
 inline SusanEdgeDetector::SusanEdgeDetector( int inThreshold )
-	: mThreshold( inThreshold ) {
+	: mThreshold( inThreshold ), mBrightnessLUT( NULL ) {
 	
 	}
 
 
 
+inline SusanEdgeDetector::~SusanEdgeDetector() {
+	if( mBrightnessLUT != NULL ) {
+		susan_free_brightness_lut( mBrightnessLUT );
+		}
+	}
+
+
+
 inline void SusanEdgeDetector::setThreshold( int inThreshold ) {
+	if( inThreshold != mThreshold && mBrightnessLUT != NULL ) {
+		susan_free_brightness_lut( mBrightnessLUT );
+		mBrightnessLUT = NULL;
+		}
 	mThreshold = inThreshold;
 	}
 
@@ -113,6 +158,31 @@ inline void SusanEdgeDetector::setThreshold( int inThreshold ) {
 inline int SusanEdgeDetector::getThreshold() {
 	return mThreshold;
 	}
+
+
+
+inline void SusanEdgeDetector::responseBand( void *inJob, 
+	int inStart, int inEnd ) {
+	
+	SusanBandJob *job = (SusanBandJob *)inJob;
+	
+	susan_edge_response_rows( job->in, job->response, job->lut,
+							  SUSAN_MAX_NO_EDGES, job->wide, job->high,
+							  inStart, inEnd );
+	}
+
+
+
+inline void SusanEdgeDetector::directionBand( void *inJob, 
+	int inStart, int inEnd ) {
+	
+	SusanBandJob *job = (SusanBandJob *)inJob;
+	
+	susan_edge_direction_rows( job->in, job->response, job->mid, 
+							   job->orient, job->lut,
+							   SUSAN_MAX_NO_EDGES, job->wide, job->high,
+							   inStart, inEnd );
+	}
 	
 	
 	
@@ -129,41 +199,97 @@ inline Image *SusanEdgeDetector::findEdges( Image *inImage ) {
 	
 	long wide = inImage->getWidth();
 	long high = inImage->getHeight();
+	long numChannels = inImage->getNumChannels();
 	
 	long numPixels = wide * high;
 	
-	double *doubleChannel = inImage->getChannel( channelNumber );
+	int i;
 	
-	uchar *charChannel = new uchar[ numPixels ];
-	uchar *charEdges = new uchar[ numPixels ];
+	// NULL unless we had to make our own byte channel
+	uchar *charChannel = NULL;
+	uchar *in;
 	
-	EDGE_ORIENTATION *orientations = new EDGE_ORIENTATION[ numPixels ];
+	if( inImage->isCompact() ) {
+		unsigned char *bytes = inImage->getCompactBytes();
+		
+		if( numChannels == 1 ) {
+			in = bytes;
+			}
+		else {
+			// pull channel out of interleaved bytes
+			charChannel = new uchar[ numPixels ];
+			
+			for( i=0; i<numPixels; i++ ) {
+				charChannel[i] = bytes[ i * numChannels + channelNumber ];
+				}
+			in = charChannel;
+			}
+		}
+	else {
+		double *doubleChannel = inImage->getChannel( channelNumber );
+		
+		charChannel = new uchar[ numPixels ];
+		
+		// copy double channel into chars
+		for( i=0; i<numPixels; i++ ) {
+			charChannel[i] = (uchar)( 255 * doubleChannel[i] );
+			}
+		in = charChannel;
+		}
 	
-	int i;
-	// copy double channel into chars
-	for( i=0; i<numPixels; i++ ) {
-		charChannel[i] = (uchar)( 255 * doubleChannel[i] );
+	if( mBrightnessLUT == NULL ) {
+		setup_brightness_lut( &mBrightnessLUT, mThreshold, 6 );
 		}
 	
-	susan_find_edges_thresh( charChannel, 
-		wide, high, charEdges, orientations, 
-		mThreshold );
+	int *response = new int[ numPixels ];
+	uchar *mid = new uchar[ numPixels ];
+	EDGE_ORIENTATION *orientations = new EDGE_ORIENTATION[ numPixels ];
+	
+	// note not set to zero
+	memset( mid, 100, numPixels );
 	
-	Image *edges = new Image( wide, high, 1 );
-	double *doubleEdges = edges->getChannel( channelNumber );	
+	SusanBandJob job;
+	job.in = in;
+	job.response = response;
+	job.mid = mid;
+	job.orient = orientations;
+	job.lut = mBrightnessLUT;
+	job.wide = wide;
+	job.high = high;
+	
+	ThreadPool *pool = ThreadPool::getSharedPool();
+	
+	// direction pass reads responses from neighboring bands, so all
+	// responses must be done first
+	pool->parallelFor( responseBand, &job, high, SUSAN_MIN_BAND_ROWS );
+	pool->parallelFor( directionBand, &job, high, SUSAN_MIN_BAND_ROWS );
+	
+	// thinning walks back over pixels it has already changed,
+	// so it runs on the whole image at once
+	susan_thin( response, mid, wide, high );
+	
+	
+	// edges are binary, 255 in a compact image reads back as 1.0
+	unsigned char *edgeBytes = new unsigned char[ numPixels ];
 	
 	for( i=0; i<numPixels; i++ ) {
-		// edges produced are in binary, so we can convert directly 
-		// to doubles
-		doubleEdges[i] = (double)( charEdges[i] );
+		if( mid[i] < 8 ) {
+			edgeBytes[i] = 255;
+			}
+		else {
+			edgeBytes[i] = 0;
+			}
 		}
 	
-	delete [] charChannel;
-	delete [] charEdges;
+	if( charChannel != NULL ) {
+		delete [] charChannel;
+		}
+	delete [] response;
+	delete [] mid;
 	delete [] orientations;
 	
 	
-	return edges;	
+	return new Image( edgeBytes, wide, high, 1 );	
 	}
 	
 
@@ -7,6 +7,11 @@
  * 2001-February-26		Jason Rohrer
  * Finished and tested.  Seems to be working, but
  * performance is poor on linux machines with multiple processors.     
+ *
+ * 2026-October-15		Jason Rohrer
+ * Runs row tiles on a persistent ThreadPool, writing straight into one
+ * output map, instead of copying the stereo and starting threads for each
+ * part of each frame.
  */
  
  
@@ -15,16 +20,27 @@
 
 #include "Stereo.h"
 #include "PartialStereo.h"
-#include "StereoThread.h"
+
+#include "minorGems/system/ThreadPool.h"
 
 #include "minorGems/util/random/RandomSource.h"
 
 #include <float.h>
 #include <stdio.h>
 
+
+// smallest band of rows handed to a pool thread, since each band also
+// covers window rows above and below it
+#define THREADED_PARTIAL_STEREO_MIN_TILE_ROWS 32
+
+
+
 /**
- * Stereo implementation that runs several non-overlapping partial
- * stereos in separate threads.
+ * Stereo implementation that splits the image into bands of rows and
+ * computes them on a thread pool, all writing into the same depth map.
+ *
+ * Bands are handed out as threads become free, so bands that take longer
+ * don't hold up the others.
  *
  * @author Jason Rohrer
  */
@@ -32,22 +48,20 @@ class ThreadedPartialStereo : public Stereo {
 	
 	public:
 		
-		public:
-		
 		/**
-		 * Constructs a multi-threaded multi-channel stereo object.
+		 * Constructs a multi-threaded partial stereo object.
 		 *
-		 * @param inStereo the stereo object to be used
-		 *   on each channel individually.  For the sake of 
-		 *   efficiency, inStereo should be an implementation
-		 *   that only processes the channel specified by
-		 *   a call to its getImageChannel() function.
+		 * @param inStereo the stereo object to run on each band.  Its
+		 *   computeDepthRows must be thread-safe (the default, built on
+		 *   copy, is).
 		 *   Is destroyed when the class is destroyed.
-		 * @param inNumParts the number of sections to split
-		 *   the image into (one section per thread).
+		 * @param inNumParts the number of threads to run bands in.
+		 *   The calling thread also computes bands while waiting.
 		 */
 		ThreadedPartialStereo( PartialStereo *inStereo, int inNumParts );
 
+		~ThreadedPartialStereo();
+		
 		
 		// implements the stereo interface
 		virtual Image *computeDepthMap( Image *inLeft, Image *inRight );
@@ -56,6 +70,22 @@ class ThreadedPartialStereo : public Stereo {
 	private:
 		int mNumParts;
 		PartialStereo *mStereo;
+		
+		// started once, and reused for every frame
+		ThreadPool *mPool;
+		
+		
+		typedef struct BandJob {
+				PartialStereo *stereo;
+				Image *left;
+				Image *right;
+				Image *depthMap;
+				// set by any band that fails
+				volatile int failed;
+			} BandJob;
+		
+		// ThreadPoolRangeFunction over rows
+		static void computeBand( void *inJob, int inStart, int inEnd );
 				
 	};
 
@@ -64,12 +94,20 @@ class ThreadedPartialStereo : public Stereo {
 inline ThreadedPartialStereo::ThreadedPartialStereo( 
 	PartialStereo *inStereo, int inNumParts  )
 	: Stereo( inStereo->getMaxDisparity() ),
-	mStereo( inStereo ), mNumParts( inNumParts ) {
+	mNumParts( inNumParts ), mStereo( inStereo ),
+	mPool( new ThreadPool( inNumParts ) ) {
 	
 	}
 
 
 
+inline ThreadedPartialStereo::~ThreadedPartialStereo() {
+	delete mPool;
+	delete mStereo;
+	}
+
+
+
 inline Stereo *ThreadedPartialStereo::copy() {
 
 	ThreadedPartialStereo *returnValue =
@@ -81,123 +119,49 @@ inline Stereo *ThreadedPartialStereo::copy() {
 
 
 
-inline Image *ThreadedPartialStereo::computeDepthMap( 
-	Image *inLeft, Image *inRight ) {
+inline void ThreadedPartialStereo::computeBand( void *inJob, 
+	int inStart, int inEnd ) {
 	
+	BandJob *job = (BandJob *)inJob;
 	
-	// where threads will put pointers to their output images
-	Image **outImages = new Image*[ mNumParts ];
-	
-	StereoThread **threads = new StereoThread*[ mNumParts ];
-	
-	// copies of stereo objects
-	PartialStereo **stereoCopies = new PartialStereo*[ mNumParts ];
-	
-	int i;
-	
-	// for each part
-	for( i=0; i<mNumParts; i++ ) {
-		// copy stereo object and spawn a thread
-		
-		stereoCopies[i] = (PartialStereo *)( mStereo->copy() );
-		
-		// assign stereo object to process its specific image part
-		// split image horizontally:
-		double yStart = i / (double)mNumParts;
-		double yEnd =  (i+1) / (double)mNumParts;
-		stereoCopies[i]->setRange( 0.0, 1.0, yStart, yEnd );
-		
-		
-		
-		// create the thread
-		// don't copy input images since stereo object shouldn't
-		// modify them (so they are accessed in a thread-safe manner)
-		threads[i] = new StereoThread( stereoCopies[i], inLeft, inRight,
-			&( outImages[i] ) );
-		
-		// start the thread
-		threads[i]->start();
-		}
-	
-	// now join each thread to wait for them to finish
-	for( i=0; i<mNumParts; i++ ) {
-		threads[i]->join();
+	if( ! job->stereo->computeDepthRows( job->left, job->right, 
+										 inStart, inEnd - 1, 
+										 job->depthMap ) ) {
+		job->failed = true;
 		}
+	}
+
+
+
+inline Image *ThreadedPartialStereo::computeDepthMap( 
+	Image *inLeft, Image *inRight ) {
 	
-	// delete the threads and the stereo copies
-	for( i=0; i<mNumParts; i++ ) {
+	int w = inLeft->getWidth();
+	int h = inLeft->getHeight();
 	
-		delete threads[i];
-		delete stereoCopies[i];
+	if( h != inRight->getHeight() || w != inRight->getWidth() ) {
+		return NULL;
 		}
-	delete [] stereoCopies;
-	delete [] threads;
 	
-	// now our out images should be filled.
+	Image *depthMap = new Image( w, h, 1 );
 	
-	// combine their parts to make a final image
+	BandJob job;
+	job.stereo = mStereo;
+	job.left = inLeft;
+	job.right = inRight;
+	job.depthMap = depthMap;
+	job.failed = false;
 	
-	// first, make sure they are not NULL
-	char imagesOK = true;
-	for( i=0; i<mNumParts; i++ ) {
+	// returns once all bands are done
+	mPool->parallelFor( computeBand, &job, h, 
+						THREADED_PARTIAL_STEREO_MIN_TILE_ROWS );
 	
-		if( outImages[i] == NULL ) {
-			imagesOK = false;
-			}
-		}
-	if( !imagesOK ) {
-		// delete any ok images and return NULL
-		for( i=0; i<mNumParts; i++ ) {
-			if( outImages[i] != NULL ) {
-				delete outImages[i];
-				}
-			}
-		
-		delete [] outImages;
-		
+	if( job.failed ) {
+		delete depthMap;
 		return NULL;
 		}
-	else {
-		// the images are ok...
-		
-		// average them together to make our output
-		
-		int w = outImages[0]->getWidth();
-		int h = outImages[0]->getHeight();
-		int numPixels = w * h;
-		
-		Image *finalImage = new Image( w, h, 1 );
-		double *finalChannel = finalImage->getChannel( 0 );
-		
-		int p;
-		
-		// combine all of the output images into the final image
-		for( i=0; i<mNumParts; i++ ) {
-			// y range of this part
-			double yStart = i / (double)mNumParts;
-			double yEnd =  (i+1) / (double)mNumParts;
-			int yIntStart = (int)( h * yStart );
-			int yIntEnd = (int)( h * yEnd - 1 );
-			
-			double *channel = outImages[i]->getChannel( 0 );
-			
-			for( int y=yIntStart; y<=yIntEnd; y++ ) {
-				for( int x=0; x<w; x++ ) {
-					int index = y * w + x;
-					finalChannel[ index ] = channel[ index ];
-					}
-				}
-			}
-		
-		// now delete the temp images
-		for( i=0; i<mNumParts; i++ ) {
-			delete outImages[i];
-			}
-		
-		delete [] outImages;
-			
-		return finalImage;			
-		}
+	
+	return depthMap;
 	}
 	
 		
@@ -5,10 +5,15 @@
  * Created.
  *
  * 2001-February-28		Jason Rohrer
- * Fixed some memory leaks. 
+ * Fixed some memory leaks.
+ *
+ * 2026-October-15		Jason Rohrer
+ * Switched to the compressed band protocol in StereoBandTransport.h.
+ * Accepts a new connection when one breaks.
  */
 
 #include "LocalWindowStereo.h"
+#include "StereoBandTransport.h"
 
 #include "minorGems/graphics/Image.h"
 
@@ -19,102 +24,76 @@
 
 #include <time.h>
 #include <string.h>
+#include <stdlib.h>
 
 // prototypes:
 void usage( char *inAppName );
 
 // test function for stereo
 int main( int inNumArgs, char **inArgs ) {
-	
+
 	if( inNumArgs < 3 ) {
 		usage( inArgs[0] );
-		} 
-	
+		}
+
 	int port;
     int windowSize;
 
     if( sscanf( inArgs[1], "%d", &port ) != 1 ) {
-        printf( "port_number must be a number.  Bad argument:  %s\n", 
+        printf( "port_number must be a number.  Bad argument:  %s\n",
                 inArgs[1] );
         usage( inArgs[0] );
-        }   
+        }
 	if( sscanf( inArgs[2], "%d", &windowSize ) != 1 ) {
-        printf( "window_size must be a number.  Bad argument:  %s\n", 
+        printf( "window_size must be a number.  Bad argument:  %s\n",
                 inArgs[2] );
         usage( inArgs[0] );
-        }  
-	
+        }
+
 	StdRandomSource *randSource = new StdRandomSource();
-	
+
 	LocalWindowStereo *stereo = new LocalWindowStereo( 30,
 		windowSize, randSource );
-	
-	
+
+
 	SocketServer *server = new SocketServer( port, 50 );
-	
-	printf( "waiting for a connection\n" );
-	Socket *sock = server->acceptConnection();
-	printf( "connection received.\n" );
-	
-	SocketStream *stream = new SocketStream( sock );
-	
-	// while there are no errors
-	while( stream->InputStream::getLastError() == NULL
-			&& stream->OutputStream::getLastError() == NULL ) {
-		// first, receive ranges, x and then y
-		double xStart;
-		double xEnd;
-		double yStart;
-		double yEnd;
-		stream->readDouble( &xStart );
-		stream->readDouble( &xEnd );
-		stream->readDouble( &yStart );
-		stream->readDouble( &yEnd );
-		
-		stereo->setRange( xStart, xEnd, yStart, yEnd );
-		
-		Image *left = new Image( 1, 1, 1 );
-		Image *right = new Image( 1, 1, 1 );
-		
-		printf( "received image pair\n" );
-			
-		// receive left, then right images
-		left->deserialize( stream );
-		right->deserialize( stream );
-
-		// compute the result
-		printf( "computing the stereo result...\n" );
-		Image *outImage = stereo->computeDepthMap( left, right );
-		
-		// send the result
-		outImage->serialize( stream );
-		
-		printf( "sent back result\n" );
-		
-		delete left;
-		delete right;
-		delete outImage;
+
+	while( true ) {
+		printf( "waiting for a connection\n" );
+		Socket *sock = server->acceptConnection();
+
+		if( sock == NULL ) {
+			break;
+			}
+		printf( "connection received.\n" );
+
+		SocketStream *stream = new SocketStream( sock );
+
+		// returns when the connection breaks
+		serveStereoBands( stream, stereo, windowSize / 2, true );
+
+		printf( "connection broken\n" );
+
+		delete stream;
+		delete sock;
 		}
-	// a socket error occured
-	printf( "connection broken\n" );
-	
+
 	delete stereo;
 	delete randSource;
 	delete server;
-	delete stream;
-	
+
 	return 0;
 	}
 
 
 
 void usage( char *inAppName ) {
-	
+
 	printf( "usage:\n" );
 	printf( "%s port_number window_size\n", inAppName );
 
 	printf( "example:\n\t" );
 	printf( "%s 3003 15\n", inAppName );
-	
-	std::exit( 1 );
+
+	exit( 1 );
 	}
@@ -1082,18 +1082,29 @@ uchar *mp;
 /* }}} */
 /* {{{ susan_edges(in,r,sf,max_no,out) */
 
-susan_edges(in,r,mid, orient, bp,max_no,x_size,y_size)
-  uchar *in, *bp, *mid;
-  int   *r, max_no, x_size, y_size;
-  EDGE_ORIENTATION *orient;
+/* USAN area response for rows [y_start,y_end), which can be run on separate
+   bands at once.  Rows of r outside the 3 pixel border are zeroed.
+   split out of susan_edges by Jason Rohrer */
+
+void susan_edge_response_rows( uchar *in, int *r, uchar *bp, int max_no,
+                               int x_size, int y_size,
+                               int y_start, int y_end )
 {
-float z;
-int   do_symmetry, i, j, m, n, a, b, x, y, w;
-uchar c,*p,*cp;
+int   i, j, n;
+uchar *p,*cp;
 
-  memset (r,0,x_size * y_size * sizeof(int));
+  if (y_end > y_size)
+    y_end = y_size;
 
-  for (i=3;i<y_size-3;i++)
+  if (y_start < y_end)
+    memset (r + y_start*x_size, 0, (y_end - y_start) * x_size * sizeof(int));
+
+  if (y_start < 3)
+    y_start = 3;
+  if (y_end > y_size-3)
+    y_end = y_size-3;
+
+  for (i=y_start;i<y_end;i++)
     for (j=3;j<x_size-3;j++)
     {
       n=100;
@@ -1153,8 +1164,28 @@ uchar c,*p,*cp;
       if (n<=max_no)
         r[i*x_size+j] = max_no - n;
     }
+}
 
-  for (i=4;i<y_size-4;i++)
+/* Edge direction and non-max suppression for rows [y_start,y_end), marking
+   edges in mid.  Reads r two rows above and below, so r must be complete
+   for those rows before this runs.
+   split out of susan_edges by Jason Rohrer */
+
+void susan_edge_direction_rows( uchar *in, int *r, uchar *mid,
+                                EDGE_ORIENTATION *orient, uchar *bp,
+                                int max_no, int x_size, int y_size,
+                                int y_start, int y_end )
+{
+float z;
+int   do_symmetry, i, j, m, n, a, b, x, y, w;
+uchar c,*p,*cp;
+
+  if (y_start < 4)
+    y_start = 4;
+  if (y_end > y_size-4)
+    y_end = y_size-4;
+
+  for (i=y_start;i<y_end;i++)
     for (j=4;j<x_size-4;j++)
     {
       if (r[i*x_size+j]>0)
@@ -1339,6 +1370,16 @@ uchar c,*p,*cp;
     }
 }
 
+susan_edges(in,r,mid, orient, bp,max_no,x_size,y_size)
+  uchar *in, *bp, *mid;
+  int   *r, max_no, x_size, y_size;
+  EDGE_ORIENTATION *orient;
+{
+  susan_edge_response_rows(in, r, bp, max_no, x_size, y_size, 0, y_size);
+  susan_edge_direction_rows(in, r, mid, orient, bp, max_no, x_size, y_size,
+                            0, y_size);
+}
+
 /* }}} */
 /* {{{ susan_edges_small(in,r,sf,max_no,out) */
 
@@ -2003,6 +2044,16 @@ corner_list[n].info=7;
 
 
 
+/*	Frees a LUT made by setup_brightness_lut, whose pointer is offset to
+ *	the middle of its block
+ */
+void susan_free_brightness_lut( uchar *bp ) {
+	free( bp - 258 );
+	}
+
+
+
+
 /* 	Find susan edges and orientations, provide a brightness threshold for USAN
  *	in			input grayscale image
  *  x_size		width of image
@@ -2022,7 +2073,7 @@ void susan_find_edges_thresh( uchar *in, int x_size, int y_size, uchar *binEdges
 	uchar *mid;	/* (seems to be) used for edge detection and thinking */
 	uchar *brightnessLUT;	/* lookup table for brighness thresholding function */
 	
-	int max_no_edges = 2650 ;
+	int max_no_edges = SUSAN_MAX_NO_EDGES;
 	
 	int i;
 	
@@ -2051,7 +2102,7 @@ void susan_find_edges_thresh( uchar *in, int x_size, int y_size, uchar *binEdges
 	/* free the memory malloc'ed earlier */
 	free( response );
 	free( mid );
-	free( brightnessLUT ); 
+	susan_free_brightness_lut( brightnessLUT ); 
 	
 		
 	}	/* end susan_find_edges()
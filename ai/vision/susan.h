@@ -10,6 +10,8 @@
 *
 *	Created 5-16-2000
 *	Mods:
+*		2026-10-15  Added the pieces of susan_find_edges_thresh, so
+*		            callers can keep the LUT and split rows across threads.
 */
 
 #ifndef SUSAN_FIND_EDGES_INCLUDED
@@ -52,4 +54,38 @@ void susan_find_edges( uchar *in, int x_size, int y_size, uchar *binEdges, EDGE_
 
 
 
+
+
+/*	Pieces of susan_find_edges_thresh, for callers that keep a LUT between
+ *	frames and split the image into bands of rows (see SusanEdgeDetector.h).
+ *
+ *	Run susan_edge_response_rows on all bands, then
+ *	susan_edge_direction_rows on all bands (it reads r two rows past the
+ *	band), then susan_thin on the whole image.  Edges are where mid < 8,
+ *	with mid set to 100 beforehand.
+ *
+ *	bp			LUT from setup_brightness_lut( &bp, thresh, 6 )
+ *	max_no		SUSAN_MAX_NO_EDGES
+ *	y_start		first row of band
+ *	y_end		one past last row of band
+ */
+#define SUSAN_MAX_NO_EDGES 2650
+
+void setup_brightness_lut( uchar **bp, int thresh, int form );
+
+void susan_free_brightness_lut( uchar *bp );
+
+void susan_edge_response_rows( uchar *in, int *r, uchar *bp, int max_no,
+                               int x_size, int y_size,
+                               int y_start, int y_end );
+
+void susan_edge_direction_rows( uchar *in, int *r, uchar *mid,
+                                EDGE_ORIENTATION *orient, uchar *bp,
+                                int max_no, int x_size, int y_size,
+                                int y_start, int y_end );
+
+int susan_thin( int *r, uchar *mid, int x_size, int y_size );
+
+
+
 #endif
\ No newline at end of file
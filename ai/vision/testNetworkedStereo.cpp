@@ -0,0 +1,350 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15		Jason Rohrer
+ * Created.
+ */
+
+/**
+ * Runs stereo servers on loopback threads and checks that NetworkedStereo
+ * gives the same depth map as a local LocalWindowStereo, with frames
+ * pipelined, that bands shift toward a faster server, and prints bytes
+ * sent compared to the old protocol (whole images as doubles).
+ *
+ * Compile from above the minorGems directory with:
+ *   g++ -O2 -I. minorGems/ai/vision/testNetworkedStereo.cpp
+ *     minorGems/network/linux/[A-Z]*.cpp minorGems/network/NetworkFunctionLocks.cpp
+ *     minorGems/network/HostLookupPool.cpp minorGems/network/LookupThread.cpp
+ *     minorGems/util/stringUtils.cpp minorGems/io/linux/TypeIOLinux.cpp
+ *     minorGems/system/linux/[A-Z]*.cpp minorGems/system/unix/TimeUnix.cpp
+ *     minorGems/system/ThreadPool.cpp minorGems/formats/ZipStream.cpp
+ *     minorGems/formats/encodingUtils.cpp -lpthread -o testNetworkedStereo
+ */
+
+#include "NetworkedStereo.h"
+#include "LocalWindowStereo.h"
+#include "StereoBandTransport.h"
+
+#include "minorGems/graphics/Image.h"
+
+#include "minorGems/network/SocketServer.h"
+#include "minorGems/network/SocketClient.h"
+#include "minorGems/network/SocketStream.h"
+
+#include "minorGems/system/Thread.h"
+#include "minorGems/system/Time.h"
+
+#include "minorGems/util/random/StdRandomSource.h"
+#include "minorGems/util/stringUtils.h"
+
+#include <stdio.h>
+
+
+
+#define MAX_DISPARITY 16
+#define WINDOW_SIZE 7
+
+#define BASE_PORT 9731
+
+
+static int numBad = 0;
+
+
+
+// computes every band inSlowdown times, to act like a slower machine
+class SlowStereo : public LocalWindowStereo {
+	public:
+
+		SlowStereo( RandomSource *inRandSource, int inSlowdown )
+			: LocalWindowStereo( MAX_DISPARITY, WINDOW_SIZE, inRandSource ),
+			  mSlowdown( inSlowdown ) {
+			}
+
+		virtual char computeDepthRows( Image *inLeft, Image *inRight,
+			int inYStart, int inYEnd, Image *inDepthMap ) {
+
+			char ok = true;
+			for( int i=0; i<mSlowdown; i++ ) {
+				ok = LocalWindowStereo::computeDepthRows(
+					inLeft, inRight, inYStart, inYEnd, inDepthMap );
+				}
+			return ok;
+			}
+
+	private:
+		int mSlowdown;
+	};
+
+
+
+// serves one connection
+class ServerThread : public Thread {
+	public:
+
+		ServerThread( SocketServer *inServer, int inSlowdown )
+			: mServer( inServer ), mRandSource( 7 ),
+			  mStereo( &mRandSource, inSlowdown ) {
+			start();
+			}
+
+		~ServerThread() {
+			join();
+			}
+
+		virtual void run() {
+			Socket *sock = mServer->acceptConnection();
+			if( sock == NULL ) {
+				return;
+				}
+
+			SocketStream stream( sock );
+			serveStereoBands( &stream, &mStereo, WINDOW_SIZE / 2, false );
+
+			delete sock;
+			}
+
+	private:
+		SocketServer *mServer;
+		StdRandomSource mRandSource;
+		SlowStereo mStereo;
+	};
+
+
+
+// random texture, with the right image shifted by a disparity that
+// changes across the image
+static void makeImages( int inW, int inH, int inSeed,
+						Image **outLeft, Image **outRight ) {
+	StdRandomSource randSource( inSeed );
+
+	Image *left = new Image( inW, inH, 1 );
+	Image *right = new Image( inW, inH, 1 );
+
+	double *l = left->getChannel( 0 );
+	double *r = right->getChannel( 0 );
+
+	for( int i=0; i<inW * inH; i++ ) {
+		l[i] = randSource.getRandomBoundedInt( 0, 255 ) / 255.0;
+		}
+
+	for( int y=0; y<inH; y++ ) {
+		for( int x=0; x<inW; x++ ) {
+			int d = 4;
+			if( x > inW / 3 && y > inH / 4 && y < ( 3 * inH ) / 4 ) {
+				d = 11;
+				}
+			int sourceX = x + d;
+			if( sourceX >= inW ) {
+				sourceX = inW - 1;
+				}
+			r[ y * inW + x ] = l[ y * inW + sourceX ];
+			}
+		}
+
+	*outLeft = left;
+	*outRight = right;
+	}
+
+
+
+// compares where neither map depends on random outside costs
+static void compareMaps( Image *inExpected, Image *inGot,
+						 const char *inWhat ) {
+	if( inGot == NULL ) {
+		printf( "%s: no depth map\n", inWhat );
+		numBad++;
+		return;
+		}
+
+	int w = inExpected->getWidth();
+	int h = inExpected->getHeight();
+
+	double *e = inExpected->getChannel( 0 );
+	double *g = inGot->getChannel( 0 );
+
+	for( int y=0; y<h; y++ ) {
+		for( int x=MAX_DISPARITY + WINDOW_SIZE; x<w; x++ ) {
+			int i = y * w + x;
+			if( e[i] != g[i] ) {
+				printf( "%s: depth at (%d,%d) is %f, expected %f\n",
+						inWhat, x, y, g[i], e[i] );
+				numBad++;
+				return;
+				}
+			}
+		}
+	}
+
+
+
+// connects inNumServers streams to servers on ports from inPort,
+// returning sockets in outSockets
+static SocketStream **connect( int inPort, int inNumServers,
+							   Socket **outSockets ) {
+	SocketStream **streams = new SocketStream*[ inNumServers ];
+
+	for( int i=0; i<inNumServers; i++ ) {
+		HostAddress address( stringDuplicate( "127.0.0.1" ), inPort + i );
+		Socket *sock = SocketClient::connectToServer( &address );
+		if( sock == NULL ) {
+			printf( "Failed to connect to port %d\n", inPort + i );
+			return NULL;
+			}
+		outSockets[i] = sock;
+		streams[i] = new SocketStream( sock );
+		}
+	return streams;
+	}
+
+
+
+int main() {
+	int w = 320;
+	int h = 240;
+
+	int numFrames = 4;
+
+	Image *lefts[ 4 ];
+	Image *rights[ 4 ];
+	Image *expected[ 4 ];
+
+	StdRandomSource localRandSource( 7 );
+	LocalWindowStereo local( MAX_DISPARITY, WINDOW_SIZE, &localRandSource );
+
+	for( int f=0; f<numFrames; f++ ) {
+		makeImages( w, h, f + 1, &( lefts[f] ), &( rights[f] ) );
+		expected[f] = local.computeDepthMap( lefts[f], rights[f] );
+		}
+
+
+	// three equal servers, frames pipelined two deep
+	int numServers = 3;
+	SocketServer *servers[ 3 ];
+	ServerThread *threads[ 3 ];
+
+	for( int i=0; i<numServers; i++ ) {
+		servers[i] = new SocketServer( BASE_PORT + i, 5 );
+		threads[i] = new ServerThread( servers[i], 1 );
+		}
+
+	Socket *sockets[ 3 ];
+	SocketStream **streams = connect( BASE_PORT, numServers, sockets );
+	if( streams == NULL ) {
+		return 1;
+		}
+
+	NetworkedStereo *stereo = new NetworkedStereo( streams, numServers );
+
+	double startTime = Time::getMonotonicTime();
+
+	Image *single = stereo->computeDepthMap( lefts[0], rights[0] );
+	compareMaps( expected[0], single, "Single frame" );
+	if( single != NULL ) {
+		delete single;
+		}
+
+	stereo->sendFrame( lefts[0], rights[0] );
+	for( int f=1; f<numFrames; f++ ) {
+		stereo->sendFrame( lefts[f], rights[f] );
+
+		Image *result = stereo->receiveDepthMap();
+		compareMaps( expected[ f - 1 ], result, "Pipelined frame" );
+		if( result != NULL ) {
+			delete result;
+			}
+		}
+	Image *result = stereo->receiveDepthMap();
+	compareMaps( expected[ numFrames - 1 ], result, "Last pipelined frame" );
+	if( result != NULL ) {
+		delete result;
+		}
+
+	if( stereo->getNumPendingFrames() != 0 ) {
+		printf( "Frames left pending\n" );
+		numBad++;
+		}
+
+	double netTime = Time::getMonotonicTime() - startTime;
+
+	int numFramesSent = numFrames + 1;
+
+	// old protocol sent 4 doubles, then both whole images and got back
+	// a whole depth map, all serialized as doubles (plus 3 ints each)
+	long oldBytes = (long)numFramesSent * numServers *
+		( 4 * 8 + 3 * ( 3 * 4 + w * h * 8 ) );
+
+	printf( "%d frames of %dx%d on %d servers in %.3f s:\n"
+			"  %ld bytes sent, %ld received (old protocol: %ld total)\n",
+			numFramesSent, w, h, numServers, netTime,
+			stereo->getNumBytesSent(), stereo->getNumBytesReceived(),
+			oldBytes );
+
+	delete stereo;
+
+	// closing sockets makes servers return
+	for( int i=0; i<numServers; i++ ) {
+		delete sockets[i];
+		}
+	for( int i=0; i<numServers; i++ ) {
+		delete threads[i];
+		delete servers[i];
+		}
+
+
+	// one server three times slower than the other
+	servers[0] = new SocketServer( BASE_PORT + 10, 5 );
+	threads[0] = new ServerThread( servers[0], 1 );
+	servers[1] = new SocketServer( BASE_PORT + 11, 5 );
+	threads[1] = new ServerThread( servers[1], 3 );
+
+	streams = connect( BASE_PORT + 10, 2, sockets );
+	if( streams == NULL ) {
+		return 1;
+		}
+
+	stereo = new NetworkedStereo( streams, 2 );
+
+	for( int f=0; f<8; f++ ) {
+		result = stereo->computeDepthMap( lefts[ f % numFrames ],
+										  rights[ f % numFrames ] );
+		compareMaps( expected[ f % numFrames ], result, "Uneven servers" );
+		if( result != NULL ) {
+			delete result;
+			}
+		}
+
+	int fastRows = stereo->getNumRows( 0 );
+	int slowRows = stereo->getNumRows( 1 );
+
+	printf( "Rows given to fast server: %d, to 3x slower server: %d\n",
+			fastRows, slowRows );
+
+	if( fastRows + slowRows != h || fastRows < 2 * slowRows ) {
+		printf( "Bands not balanced by server speed\n" );
+		numBad++;
+		}
+
+	delete stereo;
+
+	for( int i=0; i<2; i++ ) {
+		delete sockets[i];
+		}
+	for( int i=0; i<2; i++ ) {
+		delete threads[i];
+		delete servers[i];
+		}
+
+	for( int f=0; f<numFrames; f++ ) {
+		delete lefts[f];
+		delete rights[f];
+		delete expected[f];
+		}
+
+
+	if( numBad == 0 ) {
+		printf( "All tests passed\n" );
+		return 0;
+		}
+	printf( "%d failures\n", numBad );
+	return 1;
+	}
@@ -0,0 +1,398 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+#include "minorGems/common.h"
+
+
+
+#include "benchHarness.h"
+
+#include "minorGems/util/SimpleVector.h"
+#include "minorGems/util/stringUtils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <time.h>
+#endif
+
+
+
+#define DEFAULT_REPS 31
+#define DEFAULT_BATCH_MS 5
+#define DEFAULT_THRESHOLD_PERCENT 10
+#define WARMUP_BATCHES 3
+
+// stop calibrating even if batches are still too fast
+#define MAX_ITERATIONS 1000000000
+
+
+
+typedef struct Benchmark {
+        const char *name;
+        BenchFunction function;
+    } Benchmark;
+
+
+typedef struct BenchResult {
+        const char *name;
+        int iterations;
+        int reps;
+        double medianNS;
+        double p99NS;
+        double minNS;
+    } BenchResult;
+
+
+typedef struct BaselineEntry {
+        char *name;
+        double medianNS;
+    } BaselineEntry;
+
+
+
+static SimpleVector<Benchmark> benchmarks;
+
+
+static volatile unsigned int sink = 0;
+
+static const void * volatile pointerSink = NULL;
+
+
+
+void addBenchmark( const char *inName, BenchFunction inFunction ) {
+    Benchmark b = { inName, inFunction };
+    benchmarks.push_back( b );
+    }
+
+
+
+void benchKeep( unsigned int inValue ) {
+    sink += inValue;
+    }
+
+
+
+void benchKeep( const void *inPointer ) {
+    pointerSink = inPointer;
+    }
+
+
+
+// monotonic, as in ZoneProfiler
+static double getAbsoluteTime() {
+    #ifdef _WIN32
+        static double secondsPerCount = 0;
+
+        LARGE_INTEGER count;
+
+        if( secondsPerCount == 0 ) {
+            LARGE_INTEGER frequency;
+            QueryPerformanceFrequency( &frequency );
+
+            secondsPerCount = 1.0 / (double)( frequency.QuadPart );
+            }
+
+        QueryPerformanceCounter( &count );
+
+        return (double)( count.QuadPart ) * secondsPerCount;
+    #else
+        struct timespec now;
+        clock_gettime( CLOCK_MONOTONIC, &now );
+
+        return now.tv_sec + now.tv_nsec / 1000000000.0;
+    #endif
+    }
+
+
+
+static double timeBatch( BenchFunction inFunction, int inIterations ) {
+    double startTime = getAbsoluteTime();
+
+    inFunction( inIterations );
+
+    return getAbsoluteTime() - startTime;
+    }
+
+
+
+static int compareDoubles( const void *inA, const void *inB ) {
+    double a = *( (const double *)inA );
+    double b = *( (const double *)inB );
+
+    if( a < b ) {
+        return -1;
+        }
+    if( a > b ) {
+        return 1;
+        }
+    return 0;
+    }
+
+
+
+static BenchResult runBenchmark( Benchmark *inBenchmark, int inReps,
+                                 double inBatchSeconds ) {
+
+    // calibrate
+    int iterations = 1;
+
+    while( iterations < MAX_ITERATIONS &&
+           timeBatch( inBenchmark->function, iterations ) < inBatchSeconds ) {
+        iterations *= 2;
+        }
+
+    for( int i=0; i<WARMUP_BATCHES; i++ ) {
+        timeBatch( inBenchmark->function, iterations );
+        }
+
+
+    double *nsPerIteration = new double[ inReps ];
+
+    for( int i=0; i<inReps; i++ ) {
+        nsPerIteration[i] =
+            1000000000 * timeBatch( inBenchmark->function, iterations ) /
+            iterations;
+        }
+
+    qsort( nsPerIteration, inReps, sizeof( double ), compareDoubles );
+
+    BenchResult r;
+    r.name = inBenchmark->name;
+    r.iterations = iterations;
+    r.reps = inReps;
+    r.medianNS = nsPerIteration[ inReps / 2 ];
+    r.minNS = nsPerIteration[0];
+
+    // nearest-rank
+    int p99Index = (int)ceil( 0.99 * inReps ) - 1;
+    if( p99Index < 0 ) {
+        p99Index = 0;
+        }
+    r.p99NS = nsPerIteration[ p99Index ];
+
+    delete [] nsPerIteration;
+
+    return r;
+    }
+
+
+
+// reads CSV as written by writeCSV
+static char readBaseline( const char *inFileName,
+                          SimpleVector<BaselineEntry> *outEntries ) {
+    FILE *f = fopen( inFileName, "r" );
+
+    if( f == NULL ) {
+        return false;
+        }
+
+    char line[1024];
+
+    while( fgets( line, sizeof( line ), f ) != NULL ) {
+        char *comma = strchr( line, ',' );
+
+        if( comma == NULL ) {
+            continue;
+            }
+
+        *comma = '\0';
+
+        int iterations, reps;
+        double medianNS;
+
+        if( sscanf( &( comma[1] ), "%d,%d,%lf",
+                    &iterations, &reps, &medianNS ) != 3 ) {
+            // header
+            continue;
+            }
+
+        BaselineEntry e = { stringDuplicate( line ), medianNS };
+        outEntries->push_back( e );
+        }
+
+    fclose( f );
+
+    return true;
+    }
+
+
+
+static char writeCSV( const char *inFileName,
+                      SimpleVector<BenchResult> *inResults ) {
+    FILE *f = fopen( inFileName, "w" );
+
+    if( f == NULL ) {
+        return false;
+        }
+
+    fprintf( f, "name,iterations,reps,median_ns,p99_ns,min_ns\n" );
+
+    for( int i=0; i<inResults->size(); i++ ) {
+        BenchResult *r = inResults->getElement( i );
+
+        fprintf( f, "%s,%d,%d,%.3f,%.3f,%.3f\n",
+                 r->name, r->iterations, r->reps,
+                 r->medianNS, r->p99NS, r->minNS );
+        }
+
+    fclose( f );
+
+    return true;
+    }
+
+
+
+static void usage( const char *inAppName ) {
+    printf( "Usage:\n" );
+    printf( "  %s [-filter text] [-reps n] [-batchMS ms] [-csv file]\n",
+            inAppName );
+    printf( "      [-baseline file] [-threshold percent] [-list]\n" );
+    }
+
+
+
+int runBenchmarks( int inNumArgs, char **inArgs ) {
+
+    const char *filter = NULL;
+    const char *csvFileName = NULL;
+    const char *baselineFileName = NULL;
+    int reps = DEFAULT_REPS;
+    double batchMS = DEFAULT_BATCH_MS;
+    double thresholdPercent = DEFAULT_THRESHOLD_PERCENT;
+    char listOnly = false;
+
+    for( int i=1; i<inNumArgs; i++ ) {
+        const char *arg = inArgs[i];
+
+        if( strcmp( arg, "-list" ) == 0 ) {
+            listOnly = true;
+            continue;
+            }
+
+        if( i + 1 >= inNumArgs ) {
+            usage( inArgs[0] );
+            return 1;
+            }
+
+        const char *value = inArgs[ ++i ];
+
+        if( strcmp( arg, "-filter" ) == 0 ) {
+            filter = value;
+            }
+        else if( strcmp( arg, "-reps" ) == 0 ) {
+            reps = atoi( value );
+            }
+        else if( strcmp( arg, "-batchMS" ) == 0 ) {
+            batchMS = atof( value );
+            }
+        else if( strcmp( arg, "-csv" ) == 0 ) {
+            csvFileName = value;
+            }
+        else if( strcmp( arg, "-baseline" ) == 0 ) {
+            baselineFileName = value;
+            }
+        else if( strcmp( arg, "-threshold" ) == 0 ) {
+            thresholdPercent = atof( value );
+            }
+        else {
+            usage( inArgs[0] );
+            return 1;
+            }
+        }
+
+    if( reps < 1 ) {
+        reps = 1;
+        }
+
+
+    if( listOnly ) {
+        for( int i=0; i<benchmarks.size(); i++ ) {
+            printf( "%s\n", benchmarks.getElement( i )->name );
+            }
+        return 0;
+        }
+
+
+    SimpleVector<BaselineEntry> baseline;
+
+    if( baselineFileName != NULL &&
+        ! readBaseline( baselineFileName, &baseline ) ) {
+        printf( "Failed to read baseline file %s\n", baselineFileName );
+        return 1;
+        }
+
+
+    SimpleVector<BenchResult> results;
+    int numRegressed = 0;
+
+    printf( "%-32s %12s %12s %12s", "benchmark", "median ns", "p99 ns",
+            "min ns" );
+    if( baseline.size() > 0 ) {
+        printf( " %10s", "vs base" );
+        }
+    printf( "\n" );
+
+    for( int i=0; i<benchmarks.size(); i++ ) {
+        Benchmark *b = benchmarks.getElement( i );
+
+        if( filter != NULL && strstr( b->name, filter ) == NULL ) {
+            continue;
+            }
+
+        BenchResult r = runBenchmark( b, reps, batchMS / 1000 );
+        results.push_back( r );
+
+        printf( "%-32s %12.2f %12.2f %12.2f",
+                r.name, r.medianNS, r.p99NS, r.minNS );
+
+        for( int j=0; j<baseline.size(); j++ ) {
+            BaselineEntry *e = baseline.getElement( j );
+
+            if( strcmp( e->name, r.name ) == 0 && e->medianNS > 0 ) {
+                double changePercent =
+                    100 * ( r.medianNS - e->medianNS ) / e->medianNS;
+
+                printf( " %+9.1f%%", changePercent );
+
+                if( changePercent > thresholdPercent ) {
+                    printf( "  REGRESSED" );
+                    numRegressed++;
+                    }
+                break;
+                }
+            }
+
+        printf( "\n" );
+        fflush( stdout );
+        }
+
+
+    for( int j=0; j<baseline.size(); j++ ) {
+        delete [] baseline.getElement( j )->name;
+        }
+
+
+    if( csvFileName != NULL && ! writeCSV( csvFileName, &results ) ) {
+        printf( "Failed to write CSV file %s\n", csvFileName );
+        return 1;
+        }
+
+    if( numRegressed > 0 ) {
+        printf( "%d benchmarks regressed more than %.0f%% vs baseline\n",
+                numRegressed, thresholdPercent );
+        return 1;
+        }
+
+    return 0;
+    }
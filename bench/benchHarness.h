@@ -0,0 +1,80 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+#include "minorGems/common.h"
+
+
+
+#ifndef BENCH_HARNESS_INCLUDED
+#define BENCH_HARNESS_INCLUDED
+
+
+
+/**
+ * Micro-benchmark harness.
+ *
+ * Each benchmark is a function that performs its operation a given number
+ * of times.  For each benchmark, the harness:
+ *   -- Doubles the iteration count until one batch takes at least the
+ *      target batch time (also warming caches and branch predictors).
+ *   -- Runs a few more untimed warmup batches.
+ *   -- Times a number of batches, and reports the median, 99th percentile,
+ *      and minimum time per iteration across them.
+ *
+ * Command line options, all optional:
+ *   -filter text     only run benchmarks whose names contain text
+ *   -reps n          timed batches per benchmark (default 31)
+ *   -batchMS ms      target batch time (default 5)
+ *   -csv file        write results as CSV
+ *   -baseline file   compare against CSV from an earlier run
+ *   -threshold pct   median slowdown vs baseline that counts as a
+ *                    regression (default 10)
+ *   -list            print benchmark names and exit
+ *
+ * runBenchmarks returns 1 if any benchmark regressed against the baseline,
+ * so a build script can fail on it.
+ *
+ * Usage:
+ *   static void benchThing( int inIterations ) {
+ *       for( int i=0; i<inIterations; i++ ) {
+ *           benchKeep( doThing() );
+ *           }
+ *       }
+ *
+ *   int main( int inNumArgs, char **inArgs ) {
+ *       addBenchmark( "thing", benchThing );
+ *       return runBenchmarks( inNumArgs, inArgs );
+ *       }
+ */
+
+
+
+// performs the benchmarked operation inIterations times
+typedef void (*BenchFunction)( int inIterations );
+
+
+
+// inName must stay valid until runBenchmarks returns (string constants)
+void addBenchmark( const char *inName, BenchFunction inFunction );
+
+
+
+// runs all added benchmarks, as configured by command line
+// returns exit code for main
+int runBenchmarks( int inNumArgs, char **inArgs );
+
+
+
+// feeds a result to a sink the optimizer can't see through, so that work
+// whose result is otherwise unused isn't removed
+void benchKeep( unsigned int inValue );
+
+void benchKeep( const void *inPointer );
+
+
+
+#endif
@@ -0,0 +1,360 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+/**
+ * Micro-benchmarks for commonly used library code, run through
+ * benchHarness (see benchHarness.h for options).
+ *
+ * Build with the Makefile in this directory, then save a baseline and
+ * compare later runs against it:
+ *   ./libraryBenchmarks -csv baseline.csv
+ *   ./libraryBenchmarks -baseline baseline.csv
+ */
+
+#include "benchHarness.h"
+
+#include "minorGems/util/SimpleVector.h"
+#include "minorGems/util/stringUtils.h"
+#include "minorGems/util/crc32.h"
+#include "minorGems/util/SettingsManager.h"
+#include "minorGems/crypto/hashes/sha1.h"
+#include "minorGems/formats/encodingUtils.h"
+#include "minorGems/graphics/Image.h"
+#include "minorGems/graphics/filters/BoxBlurFilter.h"
+#include "minorGems/graphics/filters/FastBlurFilter.h"
+#include "minorGems/sound/soundSpriteMixer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+
+// big enough to spill out of L1, small enough for L2
+#define DATA_SIZE 65536
+
+#define IMAGE_SIZE 128
+
+// one audio callback's worth
+#define MIX_SAMPLES 512
+
+#define SOUND_SAMPLES 44100
+
+
+
+static unsigned char data[ DATA_SIZE ];
+
+// compressible data, like saved game state
+static unsigned char textData[ DATA_SIZE ];
+
+static char *base64Data;
+
+static int16_t soundSamples[ SOUND_SAMPLES ];
+
+static float mixL[ MIX_SAMPLES ];
+static float mixR[ MIX_SAMPLES ];
+
+static const char *sentence =
+    "The quick brown fox jumps over the lazy dog 12 times, "
+    "then naps for 3.5 hours";
+
+
+
+static void benchVectorPushBack( int inIterations ) {
+    for( int i=0; i<inIterations; i++ ) {
+        SimpleVector<int> v;
+        for( int j=0; j<100; j++ ) {
+            v.push_back( j );
+            }
+        benchKeep( (unsigned int)v.size() );
+        }
+    }
+
+
+
+static void benchVectorIterate( int inIterations ) {
+    SimpleVector<int> v;
+    for( int j=0; j<1000; j++ ) {
+        v.push_back( j );
+        }
+
+    for( int i=0; i<inIterations; i++ ) {
+        unsigned int sum = 0;
+        int size = v.size();
+        for( int j=0; j<size; j++ ) {
+            sum += v.getElementDirect( j );
+            }
+        benchKeep( sum );
+        }
+    }
+
+
+
+static void benchVectorDeleteFront( int inIterations ) {
+    SimpleVector<int> v;
+
+    for( int i=0; i<inIterations; i++ ) {
+        if( v.size() == 0 ) {
+            for( int j=0; j<1000; j++ ) {
+                v.push_back( j );
+                }
+            }
+        v.deleteElement( 0 );
+        }
+    benchKeep( (unsigned int)v.size() );
+    }
+
+
+
+static void benchAutoSprintf( int inIterations ) {
+    for( int i=0; i<inIterations; i++ ) {
+        char *s = autoSprintf( "%s %d %f", "score", i, 0.5 );
+        benchKeep( (unsigned int)s[0] );
+        delete [] s;
+        }
+    }
+
+
+
+static void benchToLowerCase( int inIterations ) {
+    for( int i=0; i<inIterations; i++ ) {
+        char *s = stringToLowerCase( sentence );
+        benchKeep( (unsigned int)s[0] );
+        delete [] s;
+        }
+    }
+
+
+
+static void benchReplaceAll( int inIterations ) {
+    char found;
+
+    for( int i=0; i<inIterations; i++ ) {
+        char *s = replaceAll( sentence, "o", "00", &found );
+        benchKeep( (unsigned int)s[0] );
+        delete [] s;
+        }
+    }
+
+
+
+static void benchTokenize( int inIterations ) {
+    for( int i=0; i<inIterations; i++ ) {
+        SimpleVector<char *> *tokens = tokenizeString( sentence );
+        benchKeep( (unsigned int)tokens->size() );
+        tokens->deallocateStringElements();
+        delete tokens;
+        }
+    }
+
+
+
+static void benchTokenizeViews( int inIterations ) {
+    SimpleVector<StringView> views;
+
+    for( int i=0; i<inIterations; i++ ) {
+        views.deleteAll();
+        benchKeep( (unsigned int)tokenizeStringViews( sentence, &views ) );
+        }
+    }
+
+
+
+static void benchCRC32( int inIterations ) {
+    for( int i=0; i<inIterations; i++ ) {
+        benchKeep( crc32( data, DATA_SIZE ) );
+        }
+    }
+
+
+
+static void benchSHA1( int inIterations ) {
+    for( int i=0; i<inIterations; i++ ) {
+        unsigned char *digest = computeRawSHA1Digest( data, DATA_SIZE );
+        benchKeep( (unsigned int)digest[0] );
+        delete [] digest;
+        }
+    }
+
+
+
+static void benchBase64Encode( int inIterations ) {
+    for( int i=0; i<inIterations; i++ ) {
+        char *s = base64Encode( data, DATA_SIZE, false );
+        benchKeep( (unsigned int)s[0] );
+        delete [] s;
+        }
+    }
+
+
+
+static void benchBase64Decode( int inIterations ) {
+    int length;
+
+    for( int i=0; i<inIterations; i++ ) {
+        unsigned char *d = base64Decode( base64Data, &length );
+        benchKeep( (unsigned int)d[0] );
+        delete [] d;
+        }
+    }
+
+
+
+static void benchZipCompress( int inIterations ) {
+    int length;
+
+    for( int i=0; i<inIterations; i++ ) {
+        unsigned char *z = zipCompress( textData, DATA_SIZE, &length );
+        benchKeep( (unsigned int)length );
+        delete [] z;
+        }
+    }
+
+
+
+static void benchBoxBlur( int inIterations ) {
+    Image image( IMAGE_SIZE, IMAGE_SIZE, 4, false );
+
+    for( int c=0; c<4; c++ ) {
+        double *channel = image.getChannel( c );
+        for( int p=0; p<IMAGE_SIZE * IMAGE_SIZE; p++ ) {
+            channel[p] = data[p + c] / 255.0;
+            }
+        }
+
+    BoxBlurFilter filter( 3 );
+
+    for( int i=0; i<inIterations; i++ ) {
+        image.filter( &filter );
+        }
+    benchKeep( (unsigned int)( 255 * image.getChannel( 0 )[0] ) );
+    }
+
+
+
+static void benchFastBlur( int inIterations ) {
+    Image image( IMAGE_SIZE, IMAGE_SIZE, 4, false );
+
+    for( int c=0; c<4; c++ ) {
+        double *channel = image.getChannel( c );
+        for( int p=0; p<IMAGE_SIZE * IMAGE_SIZE; p++ ) {
+            channel[p] = data[p + c] / 255.0;
+            }
+        }
+
+    FastBlurFilter filter;
+
+    for( int i=0; i<inIterations; i++ ) {
+        image.filter( &filter );
+        }
+    benchKeep( (unsigned int)( 255 * image.getChannel( 0 )[0] ) );
+    }
+
+
+
+static void benchMix( int inIterations ) {
+    int played = 0;
+
+    for( int i=0; i<inIterations; i++ ) {
+        if( played + MIX_SAMPLES > SOUND_SAMPLES ) {
+            played = 0;
+            }
+        mixSoundSpriteSamples( soundSamples, SOUND_SAMPLES, &played,
+                               0.5f, 0.7f, mixL, mixR, MIX_SAMPLES );
+        }
+    benchKeep( (unsigned int)mixL[0] );
+    }
+
+
+
+static void benchMixResampled( int inIterations ) {
+    uint64_t phase = 0;
+    uint64_t step = getSoundSpritePhaseStep( 1.1 );
+
+    for( int i=0; i<inIterations; i++ ) {
+        if( getSoundSpritePhaseIndex( phase ) + 2 * MIX_SAMPLES >=
+            SOUND_SAMPLES ) {
+            phase = 0;
+            }
+        mixSoundSpriteSamplesResampled( soundSamples, SOUND_SAMPLES,
+                                        &phase, step,
+                                        0.5f, 0.7f, mixL, mixR,
+                                        MIX_SAMPLES );
+        }
+    benchKeep( (unsigned int)mixR[0] );
+    }
+
+
+
+static void benchSettingsRead( int inIterations ) {
+    for( int i=0; i<inIterations; i++ ) {
+        benchKeep( (unsigned int)
+                   SettingsManager::getIntSetting( "benchValue", 0 ) );
+        }
+    }
+
+
+
+static void benchSettingsReadUncached( int inIterations ) {
+    for( int i=0; i<inIterations; i++ ) {
+        SettingsManager::clearCache();
+        benchKeep( (unsigned int)
+                   SettingsManager::getIntSetting( "benchValue", 0 ) );
+        }
+    }
+
+
+
+int main( int inNumArgs, char **inArgs ) {
+
+    // fixed seed, so every run measures the same data
+    srand( 1234 );
+
+    for( int i=0; i<DATA_SIZE; i++ ) {
+        data[i] = (unsigned char)( rand() & 0xFF );
+        }
+
+    for( int i=0; i<DATA_SIZE; i++ ) {
+        textData[i] = (unsigned char)sentence[ ( i * 7 + i / 97 ) %
+                                               strlen( sentence ) ];
+        }
+
+    base64Data = base64Encode( data, DATA_SIZE, false );
+
+    for( int i=0; i<SOUND_SAMPLES; i++ ) {
+        soundSamples[i] = (int16_t)( ( rand() & 0xFFFF ) - 32768 );
+        }
+
+    SettingsManager::setDirectoryName( "benchSettings" );
+    SettingsManager::setSetting( "benchValue", 42 );
+
+
+    addBenchmark( "vector_push_back_100", benchVectorPushBack );
+    addBenchmark( "vector_iterate_1000", benchVectorIterate );
+    addBenchmark( "vector_delete_front", benchVectorDeleteFront );
+    addBenchmark( "autoSprintf", benchAutoSprintf );
+    addBenchmark( "stringToLowerCase", benchToLowerCase );
+    addBenchmark( "replaceAll", benchReplaceAll );
+    addBenchmark( "tokenizeString", benchTokenize );
+    addBenchmark( "tokenizeStringViews", benchTokenizeViews );
+    addBenchmark( "crc32_64KiB", benchCRC32 );
+    addBenchmark( "sha1_64KiB", benchSHA1 );
+    addBenchmark( "base64Encode_64KiB", benchBase64Encode );
+    addBenchmark( "base64Decode_64KiB", benchBase64Decode );
+    addBenchmark( "zipCompress_64KiB", benchZipCompress );
+    addBenchmark( "boxBlur_128x128x4", benchBoxBlur );
+    addBenchmark( "fastBlur_128x128x4", benchFastBlur );
+    addBenchmark( "mix_512", benchMix );
+    addBenchmark( "mixResampled_512", benchMixResampled );
+    addBenchmark( "settings_read", benchSettingsRead );
+    addBenchmark( "settings_read_uncached", benchSettingsReadUncached );
+
+    int result = runBenchmarks( inNumArgs, inArgs );
+
+    delete [] base64Data;
+
+    return result;
+    }
@@ -0,0 +1,262 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+/**
+ * Compares allocate/release throughput of new/delete, PoolAllocator, and
+ * ObjectPool (with and without thread caches) for a small node type, from
+ * one thread and from several sharing one pool.  Also checks that objects
+ * made on one thread can be released on another.
+ *
+ * Compile from above the minorGems directory with:
+ *   g++ -O2 -I. minorGems/bench/objectPoolBenchmark.cpp
+ *     minorGems/util/ObjectPool.cpp
+ *     minorGems/system/linux/ThreadLinux.cpp
+ *     minorGems/system/linux/MutexLockLinux.cpp
+ *     minorGems/system/unix/TimeUnix.cpp -lpthread -o objectPoolBenchmark
+ */
+
+#include "minorGems/util/ObjectPool.h"
+#include "minorGems/util/PoolAllocator.h"
+#include "minorGems/system/Thread.h"
+#include "minorGems/system/Time.h"
+
+#include <stdio.h>
+
+
+
+#define NUM_OPERATIONS 10000000
+#define LIVE_PER_THREAD 256
+#define NUM_THREADS 4
+#define NUM_HANDED_OFF 100000
+
+
+
+// about the size of a StringTree node
+typedef struct Node {
+        char c;
+        Node *parent;
+        Node *left;
+        Node *down;
+        Node *right;
+    } Node;
+
+
+
+// how a benchmark gets and returns storage
+typedef enum AllocatorType {
+    useNewDelete,
+    usePoolAllocator,
+    useObjectPool
+    } AllocatorType;
+
+
+
+static PoolAllocator<Node> singleThreadPool;
+
+static ObjectPool<Node> cachedPool;
+
+static ObjectPool<Node> lockedPool( 256, false );
+
+
+
+// replaces oldest of a set of live nodes, inNumOperations times
+static void churn( AllocatorType inType, ObjectPool<Node> *inPool,
+                   int inNumOperations ) {
+    Node *live[ LIVE_PER_THREAD ];
+
+    for( int i=0; i<inNumOperations + LIVE_PER_THREAD; i++ ) {
+        int n = i % LIVE_PER_THREAD;
+
+        if( i >= LIVE_PER_THREAD ) {
+            switch( inType ) {
+                case useNewDelete:
+                    delete live[n];
+                    break;
+                case usePoolAllocator:
+                    singleThreadPool.destroy( live[n] );
+                    break;
+                case useObjectPool:
+                    inPool->destroy( live[n] );
+                    break;
+                }
+            }
+
+        if( i < inNumOperations ) {
+            Node *node;
+
+            switch( inType ) {
+                case useNewDelete:
+                    node = new Node;
+                    break;
+                case usePoolAllocator:
+                    node = new( singleThreadPool.allocate() ) Node;
+                    break;
+                default:
+                    node = new( inPool->allocate() ) Node;
+                    break;
+                }
+
+            node->c = (char)i;
+            live[n] = node;
+            }
+        }
+    }
+
+
+
+class ChurnThread : public Thread {
+    public:
+        AllocatorType mType;
+        ObjectPool<Node> *mPool;
+
+        virtual void run() {
+            churn( mType, mPool, NUM_OPERATIONS );
+            }
+    };
+
+
+
+static double timeThreads( AllocatorType inType, ObjectPool<Node> *inPool ) {
+    ChurnThread threads[ NUM_THREADS ];
+
+    double startTime = Time::getCurrentTime();
+
+    for( int i=0; i<NUM_THREADS; i++ ) {
+        threads[i].mType = inType;
+        threads[i].mPool = inPool;
+        threads[i].start();
+        }
+    for( int i=0; i<NUM_THREADS; i++ ) {
+        threads[i].join();
+        }
+
+    return 1000000000 * ( Time::getCurrentTime() - startTime ) /
+        ( (double)NUM_THREADS * NUM_OPERATIONS );
+    }
+
+
+
+static Node *handedOff[ NUM_HANDED_OFF ];
+
+
+class MakeThread : public Thread {
+    public:
+        virtual void run() {
+            for( int i=0; i<NUM_HANDED_OFF; i++ ) {
+                handedOff[i] = new( cachedPool.allocate() ) Node;
+                handedOff[i]->c = (char)i;
+                }
+            }
+    };
+
+
+class ReleaseThread : public Thread {
+    public:
+        virtual void run() {
+            for( int i=0; i<NUM_HANDED_OFF; i++ ) {
+                cachedPool.destroy( handedOff[i] );
+                }
+            }
+    };
+
+
+
+int main() {
+
+    double startTime = Time::getCurrentTime();
+    churn( useNewDelete, NULL, NUM_OPERATIONS );
+    double newTime = Time::getCurrentTime() - startTime;
+
+    startTime = Time::getCurrentTime();
+    churn( usePoolAllocator, NULL, NUM_OPERATIONS );
+    double poolAllocatorTime = Time::getCurrentTime() - startTime;
+
+    startTime = Time::getCurrentTime();
+    churn( useObjectPool, &lockedPool, NUM_OPERATIONS );
+    double lockedTime = Time::getCurrentTime() - startTime;
+
+    startTime = Time::getCurrentTime();
+    churn( useObjectPool, &cachedPool, NUM_OPERATIONS );
+    double cachedTime = Time::getCurrentTime() - startTime;
+
+    printf( "1 thread, ns per allocate/release pair:\n" );
+    printf( "  new/delete               %.1f\n",
+            1000000000 * newTime / NUM_OPERATIONS );
+    printf( "  PoolAllocator            %.1f\n",
+            1000000000 * poolAllocatorTime / NUM_OPERATIONS );
+    printf( "  ObjectPool, no caches    %.1f\n",
+            1000000000 * lockedTime / NUM_OPERATIONS );
+    printf( "  ObjectPool, caches       %.1f\n",
+            1000000000 * cachedTime / NUM_OPERATIONS );
+
+    printf( "%d threads on one pool, wall-clock ns per pair:\n",
+            NUM_THREADS );
+    printf( "  new/delete               %.1f\n",
+            timeThreads( useNewDelete, NULL ) );
+    printf( "  ObjectPool, no caches    %.1f\n",
+            timeThreads( useObjectPool, &lockedPool ) );
+    printf( "  ObjectPool, caches       %.1f\n",
+            timeThreads( useObjectPool, &cachedPool ) );
+
+
+    int numFailed = 0;
+
+    if( cachedPool.getNumLive() != 0 || lockedPool.getNumLive() != 0 ) {
+        printf( "FAILED:  live count not zero after churn\n" );
+        numFailed++;
+        }
+
+    // steady state shouldn't grow pool past what's live at once,
+    // plus what thread caches hold
+    int maxSlots =
+        NUM_THREADS * ( LIVE_PER_THREAD + OBJECT_POOL_CACHE_SIZE ) + 256;
+
+    if( cachedPool.getNumSlots() > maxSlots ) {
+        printf( "FAILED:  pool grew to %d slots\n",
+                cachedPool.getNumSlots() );
+        numFailed++;
+        }
+
+
+    MakeThread maker;
+    maker.start();
+    maker.join();
+
+    if( cachedPool.getNumLive() != NUM_HANDED_OFF ) {
+        printf( "FAILED:  %d live after making %d\n",
+                cachedPool.getNumLive(), NUM_HANDED_OFF );
+        numFailed++;
+        }
+
+    char allDistinct = true;
+    for( int i=0; i<NUM_HANDED_OFF; i++ ) {
+        if( handedOff[i]->c != (char)i ) {
+            allDistinct = false;
+            }
+        }
+    if( ! allDistinct ) {
+        printf( "FAILED:  same slot handed out twice\n" );
+        numFailed++;
+        }
+
+    ReleaseThread releaser;
+    releaser.start();
+    releaser.join();
+
+    if( cachedPool.getNumLive() != 0 ) {
+        printf( "FAILED:  %d live after releasing on other thread\n",
+                cachedPool.getNumLive() );
+        numFailed++;
+        }
+
+
+    if( numFailed == 0 ) {
+        printf( "All checks passed\n" );
+        return 0;
+        }
+    return 1;
+    }
@@ -1,58 +1,516 @@
 #include "cryptoRandom.h"
 
+#include <string.h>
 
 
 
+// Bytes come from a per-thread ChaCha20 keystream, seeded (and reseeded
+// every so often) from the operating system, so most calls are a copy
+// out of a buffer instead of a system call.
+//
+// The generator uses fast key erasure:  each refill of the buffer
+// replaces the key with the refill's first 32 bytes, and bytes are wiped
+// from the buffer as they are handed out, so state captured later can't
+// reproduce earlier output.
+//
+// A forked child would otherwise repeat its parent's output.  On Linux,
+// the generator's state lives on a page that the kernel zeroes in the
+// child (MADV_WIPEONFORK), which makes the child reseed.  Where that
+// isn't available, the process id is checked on each call.
+//
+// A thread's state is wiped and freed when the thread exits, so threads
+// that come and go (one per request, say) don't leave state (and key
+// material) behind.
+//
+// Systems with arc4random_buf (MacOSX, BSDs) already do all of this in
+// their C library, so it is used directly there.
+
+
+
+// output between reseeds from operating system
+#define CRYPTO_RANDOM_RESEED_INTERVAL ( 1024 * 1024 )
+
+// ChaCha20 blocks per buffer refill
+#define CRYPTO_RANDOM_BLOCKS_PER_REFILL 16
+
+#define CRYPTO_RANDOM_BUFFER_SIZE ( 64 * CRYPTO_RANDOM_BLOCKS_PER_REFILL )
+
+// first part of each refill becomes next key
+#define CRYPTO_RANDOM_KEY_SIZE 32
+
+
+
+#ifdef _MSC_VER
+    #define CRYPTO_RANDOM_THREAD_LOCAL __declspec( thread )
+#else
+    #define CRYPTO_RANDOM_THREAD_LOCAL __thread
+#endif
+
+
+
+#if defined( __APPLE__ ) || defined( __OpenBSD__ ) || \
+    defined( __FreeBSD__ ) || defined( __NetBSD__ )
+    #define CRYPTO_RANDOM_USE_ARC4RANDOM
+#endif
+
+
+
+
+// operating system's random source, used for seeding
+// returns true on success
+
 #ifdef WIN_32
 // special case for Windows which has no /dev/urandom
 
 #include <windows.h>
-#include <wincrypt.h>
 
-char getCryptoRandomBytes( unsigned char *outBytes, int inNumBytes ) {
-    
-    HCRYPTPROV hCryptProv;
-    
-    char result =
-        CryptAcquireContext( &hCryptProv, NULL, NULL, PROV_RSA_FULL, 
-                             CRYPT_VERIFYCONTEXT );
-    
-    if( !result ) {
-        return false;
-        }
-    
+// RtlGenRandom (from advapi32, like CryptGenRandom) needs no provider
+// handle
+#include <ntsecapi.h>
 
-    result = CryptGenRandom( hCryptProv, inNumBytes, outBytes );
+static char getOSRandomBytes( unsigned char *outBytes, int inNumBytes ) {
+    return RtlGenRandom( outBytes, inNumBytes );
+    }
 
 
-    CryptReleaseContext( hCryptProv, 0 );
 
-    return result;
-    }
+#elif defined( CRYPTO_RANDOM_USE_ARC4RANDOM )
+
+#include <stdlib.h>
 
 
 
 #else
-// general case:  most unix-like systems, including GNU/Linux and MacOSX,
-// provide /dev/urandom
+// general case:  most unix-like systems, including GNU/Linux, provide
+// /dev/urandom, and newer Linux kernels provide getrandom, which can't
+// fail for lack of file descriptors
 
 #include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <pthread.h>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+static char getOSRandomBytes( unsigned char *outBytes, int inNumBytes ) {
+
+    #ifdef SYS_getrandom
+    int numDone = 0;
+
+    while( numDone < inNumBytes ) {
+        long result = syscall( SYS_getrandom, &( outBytes[ numDone ] ),
+                               inNumBytes - numDone, 0 );
+        if( result > 0 ) {
+            numDone += result;
+            }
+        else if( result < 0 && errno == EINTR ) {
+            continue;
+            }
+        else {
+            // ENOSYS on kernels older than 3.17
+            break;
+            }
+        }
+
+    if( numDone == inNumBytes ) {
+        return true;
+        }
+    #endif
 
-char getCryptoRandomBytes( unsigned char *outBytes, int inNumBytes ) {
 
     FILE *urandomFile = fopen( "/dev/urandom", "rb" );
-    
+
     if( urandomFile == NULL ) {
         return false;
         }
-    
+
     int numRead = fread( outBytes, 1, inNumBytes, urandomFile );
 
     fclose( urandomFile );
-    
+
 
     return (numRead == inNumBytes );
     }
 
+#endif
+
+
+
+
+#ifdef CRYPTO_RANDOM_USE_ARC4RANDOM
+
+
+char getCryptoRandomBytes( unsigned char *outBytes, int inNumBytes ) {
+    arc4random_buf( outBytes, inNumBytes );
+    return true;
+    }
+
+
+#else
+
+
+
+typedef unsigned int CryptoRandomWord;
+
+
+typedef struct CryptoRandomState {
+        // false until seeded
+        // also false in a forked child, if state page is wiped on fork
+        char seeded;
+
+        #ifndef WIN_32
+        pid_t pid;
+        #endif
+
+        int outputSinceReseed;
+
+        CryptoRandomWord key[8];
+
+        // unused output is at end of buffer
+        int numAvailable;
+        unsigned char buffer[ CRYPTO_RANDOM_BUFFER_SIZE ];
+    } CryptoRandomState;
+
+
+static CRYPTO_RANDOM_THREAD_LOCAL CryptoRandomState *threadState = NULL;
+
+// true if threadState's page is wiped on fork, false if pid must be
+// checked
+// not on the page itself, so it survives the wipe
+static CRYPTO_RANDOM_THREAD_LOCAL char threadStateWipedOnFork = false;
+
+
+
+static CryptoRandomWord rotateLeft( CryptoRandomWord inX, int inBits ) {
+    return ( inX << inBits ) | ( inX >> ( 32 - inBits ) );
+    }
+
+
+#define CHACHA_QUARTER_ROUND( a, b, c, d ) \
+    a += b; d ^= a; d = rotateLeft( d, 16 ); \
+    c += d; b ^= c; b = rotateLeft( b, 12 ); \
+    a += b; d ^= a; d = rotateLeft( d, 8 ); \
+    c += d; b ^= c; b = rotateLeft( b, 7 );
+
+
+
+// one 64-byte ChaCha20 block (RFC 8439), with zero nonce
+static void chachaBlock( CryptoRandomWord *inKey,
+                         CryptoRandomWord inCounter,
+                         unsigned char *outBlock ) {
+    CryptoRandomWord input[16] = {
+        // "expand 32-byte k"
+        0x61707865, 0x3320646e, 0x79622d32, 0x6b206574,
+        inKey[0], inKey[1], inKey[2], inKey[3],
+        inKey[4], inKey[5], inKey[6], inKey[7],
+        inCounter, 0, 0, 0 };
+
+    CryptoRandomWord x[16];
+    memcpy( x, input, sizeof( x ) );
+
+    for( int i=0; i<10; i++ ) {
+        // columns
+        CHACHA_QUARTER_ROUND( x[0], x[4], x[8], x[12] );
+        CHACHA_QUARTER_ROUND( x[1], x[5], x[9], x[13] );
+        CHACHA_QUARTER_ROUND( x[2], x[6], x[10], x[14] );
+        CHACHA_QUARTER_ROUND( x[3], x[7], x[11], x[15] );
+
+        // diagonals
+        CHACHA_QUARTER_ROUND( x[0], x[5], x[10], x[15] );
+        CHACHA_QUARTER_ROUND( x[1], x[6], x[11], x[12] );
+        CHACHA_QUARTER_ROUND( x[2], x[7], x[8], x[13] );
+        CHACHA_QUARTER_ROUND( x[3], x[4], x[9], x[14] );
+        }
+
+    // little-endian output, on any platform
+    for( int i=0; i<16; i++ ) {
+        CryptoRandomWord w = x[i] + input[i];
+
+        outBlock[ 4 * i ] = w & 0xFF;
+        outBlock[ 4 * i + 1 ] = ( w >> 8 ) & 0xFF;
+        outBlock[ 4 * i + 2 ] = ( w >> 16 ) & 0xFF;
+        outBlock[ 4 * i + 3 ] = ( w >> 24 ) & 0xFF;
+        }
+    }
+
+
+
+static void setKey( CryptoRandomState *inState, unsigned char *inKeyBytes ) {
+    for( int i=0; i<8; i++ ) {
+        inState->key[i] =
+            (CryptoRandomWord)inKeyBytes[ 4 * i ] |
+            (CryptoRandomWord)inKeyBytes[ 4 * i + 1 ] << 8 |
+            (CryptoRandomWord)inKeyBytes[ 4 * i + 2 ] << 16 |
+            (CryptoRandomWord)inKeyBytes[ 4 * i + 3 ] << 24;
+        }
+    }
+
+
+
+static void refill( CryptoRandomState *inState ) {
+    for( int b=0; b<CRYPTO_RANDOM_BLOCKS_PER_REFILL; b++ ) {
+        chachaBlock( inState->key, b, &( inState->buffer[ 64 * b ] ) );
+        }
+
+    // fast key erasure
+    setKey( inState, inState->buffer );
+    memset( inState->buffer, 0, CRYPTO_RANDOM_KEY_SIZE );
+
+    inState->numAvailable =
+        CRYPTO_RANDOM_BUFFER_SIZE - CRYPTO_RANDOM_KEY_SIZE;
+    }
+
+
+
+// mixes fresh OS randomness into key, and discards buffered output
+static char reseed( CryptoRandomState *inState ) {
+    unsigned char seed[ CRYPTO_RANDOM_KEY_SIZE ];
+
+    if( ! getOSRandomBytes( seed, CRYPTO_RANDOM_KEY_SIZE ) ) {
+        return false;
+        }
+
+    if( inState->seeded ) {
+        // keep old key's entropy too
+        unsigned char oldKey[ CRYPTO_RANDOM_KEY_SIZE ];
+        chachaBlock( inState->key, 0xFFFFFFFF, inState->buffer );
+        memcpy( oldKey, inState->buffer, CRYPTO_RANDOM_KEY_SIZE );
+
+        for( int i=0; i<CRYPTO_RANDOM_KEY_SIZE; i++ ) {
+            seed[i] ^= oldKey[i];
+            }
+        memset( oldKey, 0, CRYPTO_RANDOM_KEY_SIZE );
+        }
+
+    setKey( inState, seed );
+    memset( seed, 0, CRYPTO_RANDOM_KEY_SIZE );
+
+    #ifndef WIN_32
+    inState->pid = getpid();
+    #endif
+
+    inState->seeded = true;
+    inState->outputSinceReseed = 0;
+
+    refill( inState );
+
+    return true;
+    }
+
+
+
+// wipes through a volatile pointer, so that the compiler can't skip the
+// wipe because the memory is freed right after
+static void wipeState( CryptoRandomState *inState ) {
+    volatile unsigned char *bytes = (volatile unsigned char *)inState;
+
+    for( unsigned int i=0; i<sizeof( CryptoRandomState ); i++ ) {
+        bytes[i] = 0;
+        }
+    }
+
+
+
+// called as a thread that made a state exits
+#ifdef WIN_32
+static void WINAPI freeState( void *inState ) {
+#else
+static void freeState( void *inState ) {
+#endif
+    if( inState == NULL ) {
+        return;
+        }
+
+    CryptoRandomState *state = (CryptoRandomState *)inState;
+
+    wipeState( state );
+
+    #ifdef WIN_32
+    delete state;
+    #else
+    munmap( state, sizeof( CryptoRandomState ) );
+    #endif
+
+    // in case something later in thread exit asks for more bytes
+    threadState = NULL;
+    }
+
+
+
+#ifdef WIN_32
+
+// fiber local storage, whose callback runs at thread exit (thread local
+// storage has none)
+static volatile LONG stateFlsIndex = (LONG)FLS_OUT_OF_INDEXES;
+
+
+// has inState freed when this thread exits
+static void registerState( CryptoRandomState *inState ) {
+    DWORD index = (DWORD)stateFlsIndex;
+
+    if( index == FLS_OUT_OF_INDEXES ) {
+        DWORD newIndex = FlsAlloc( freeState );
+
+        if( newIndex == FLS_OUT_OF_INDEXES ) {
+            // state is never freed
+            return;
+            }
+
+        // threads racing to allocate keep the first index
+        LONG oldIndex =
+            InterlockedCompareExchange( &stateFlsIndex, (LONG)newIndex,
+                                        (LONG)FLS_OUT_OF_INDEXES );
+
+        if( oldIndex == (LONG)FLS_OUT_OF_INDEXES ) {
+            index = newIndex;
+            }
+        else {
+            FlsFree( newIndex );
+            index = (DWORD)oldIndex;
+            }
+        }
+
+    FlsSetValue( index, inState );
+    }
+
+
+#else
+
+
+static pthread_key_t stateKey;
+static char stateKeyReady = false;
+
+static pthread_once_t stateKeyOnce = PTHREAD_ONCE_INIT;
+
+
+static void makeStateKey() {
+    stateKeyReady = ( pthread_key_create( &stateKey, freeState ) == 0 );
+    }
+
+
+// has inState freed when this thread exits
+static void registerState( CryptoRandomState *inState ) {
+    pthread_once( &stateKeyOnce, makeStateKey );
+
+    if( stateKeyReady ) {
+        pthread_setspecific( stateKey, inState );
+        }
+    // else state is never freed
+    }
+
+#endif
+
+
+
+// returns NULL on failure
+static CryptoRandomState *makeState( char *outWipedOnFork ) {
+    CryptoRandomState *state = NULL;
+
+    char wipedOnFork = false;
+
+    #ifdef WIN_32
+    state = new CryptoRandomState;
+    memset( state, 0, sizeof( CryptoRandomState ) );
+    #else
+    // a page of its own, so it can be wiped on fork
+    void *page = mmap( NULL, sizeof( CryptoRandomState ),
+                       PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                       -1, 0 );
+
+    if( page == MAP_FAILED ) {
+        return NULL;
+        }
+
+    // zeroed by mmap
+    state = (CryptoRandomState *)page;
+
+    #ifdef MADV_WIPEONFORK
+    if( madvise( page, sizeof( CryptoRandomState ),
+                 MADV_WIPEONFORK ) == 0 ) {
+        wipedOnFork = true;
+        }
+    #endif
+    #endif
+
+    registerState( state );
+
+    *outWipedOnFork = wipedOnFork;
+
+    return state;
+    }
+
+
+
+char getCryptoRandomBytes( unsigned char *outBytes, int inNumBytes ) {
+
+    // one per thread that asks for random bytes, freed as thread exits
+    CryptoRandomState *state = threadState;
+
+    if( state == NULL ) {
+        state = makeState( &threadStateWipedOnFork );
+
+        if( state == NULL ) {
+            return false;
+            }
+
+        threadState = state;
+        }
+
+
+    #ifndef WIN_32
+    if( state->seeded && ! threadStateWipedOnFork &&
+        state->pid != getpid() ) {
+        // forked child, don't repeat parent's output
+        state->seeded = false;
+        }
+    #endif
+
+    if( ! state->seeded ||
+        state->outputSinceReseed >= CRYPTO_RANDOM_RESEED_INTERVAL ) {
+
+        if( ! reseed( state ) ) {
+            if( ! state->seeded ) {
+                return false;
+                }
+            // else keep using old key until OS source works again
+            state->outputSinceReseed = 0;
+            }
+        }
+
+
+    while( inNumBytes > 0 ) {
+        if( state->numAvailable == 0 ) {
+            refill( state );
+            }
+
+        int numToCopy = inNumBytes;
+
+        if( numToCopy > state->numAvailable ) {
+            numToCopy = state->numAvailable;
+            }
+
+        unsigned char *source =
+            &( state->buffer[ CRYPTO_RANDOM_BUFFER_SIZE -
+                              state->numAvailable ] );
+
+        memcpy( outBytes, source, numToCopy );
+
+        // bytes handed out never stay in memory
+        memset( source, 0, numToCopy );
+
+        state->numAvailable -= numToCopy;
+        state->outputSinceReseed += numToCopy;
+
+        outBytes += numToCopy;
+        inNumBytes -= numToCopy;
+        }
+
+    return true;
+    }
+
 
 #endif
@@ -4,4 +4,6 @@
 
 // outBytes allocated by caller
 // returns true on success, or false if random bytes couldn't be acquired
+// thread-safe, and safe across fork
+// after first call in a thread, usually just copies from a buffer
 char getCryptoRandomBytes( unsigned char *outBytes, int inNumBytes );
@@ -0,0 +1,101 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14   Jason Rohrer
+ * Created.
+ */
+
+
+
+#include "fileSHA1.h"
+#include "sha1.h"
+
+#include "minorGems/io/file/MappedFileContents.h"
+#include "minorGems/formats/encodingUtils.h"
+
+
+#include <stdio.h>
+
+
+
+// big enough that per-read overhead vanishes, and a multiple of the
+// SHA1 block size so SHA1_Update never has to buffer a partial block
+#define FILE_SHA1_READ_SIZE  ( 1 << 20 )
+
+
+
+unsigned char *computeRawSHA1Digest( File *inFile ) {
+    
+    SHA_CTX context;
+    
+    SHA1_Init( &context );
+
+
+    MappedFileContents *contents = inFile->mapContents();
+    
+    if( contents != NULL ) {
+        SHA1_Update( &context, contents->getData(), contents->getLength() );
+        
+        delete contents;
+        }
+    else {
+        // can't map (too big, or not a regular file), stream it instead
+        char *fileName = inFile->getFullFileName();
+        
+        FILE *file = fopen( fileName, "rb" );
+        
+        delete [] fileName;
+        
+        if( file == NULL ) {
+            return NULL;
+            }
+
+        unsigned char *buffer = new unsigned char[ FILE_SHA1_READ_SIZE ];
+        
+        char error = false;
+        
+        while( true ) {
+            int numRead = fread( buffer, 1, FILE_SHA1_READ_SIZE, file );
+            
+            if( numRead > 0 ) {
+                SHA1_Update( &context, buffer, numRead );
+                }
+            
+            if( numRead < FILE_SHA1_READ_SIZE ) {
+                error = ferror( file );
+                break;
+                }
+            }
+        
+        delete [] buffer;
+        fclose( file );
+        
+        if( error ) {
+            return NULL;
+            }
+        }
+    
+
+    unsigned char *digest = new unsigned char[ SHA1_DIGEST_LENGTH ];
+
+    SHA1_Final( digest, &context );
+
+    return digest;
+    }
+
+
+
+char *computeSHA1Digest( File *inFile ) {
+    
+    unsigned char *digest = computeRawSHA1Digest( inFile );
+
+    if( digest == NULL ) {
+        return NULL;
+        }
+    
+    char *digestHexString = hexEncode( digest, SHA1_DIGEST_LENGTH );
+    
+    delete [] digest;
+    
+    return digestHexString;
+    }
@@ -0,0 +1,57 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14   Jason Rohrer
+ * Created.
+ */
+
+
+
+#include "minorGems/common.h"
+
+
+
+#ifndef FILE_SHA1_INCLUDED
+#define FILE_SHA1_INCLUDED
+
+
+#include "minorGems/io/file/File.h"
+
+
+
+/**
+ * Computes a unencoded 20-byte digest of a file's contents, without
+ * reading the whole file into memory.
+ *
+ * The file is mapped where possible, and otherwise streamed through in
+ * large blocks.
+ *
+ * Using these means linking against sha1, File's Path, and
+ * MappedFileContents.
+ *
+ * @param inFile the file to hash.
+ *   Must be destroyed by caller.
+ *
+ * @return the digest as a byte array of length 20, or NULL if the file
+ *   can't be read.
+ *   Must be destroyed by caller.
+ */
+unsigned char *computeRawSHA1Digest( File *inFile );
+
+
+
+/**
+ * Computes a hex-encoded string digest of a file's contents.
+ *
+ * @param inFile the file to hash.
+ *   Must be destroyed by caller.
+ *
+ * @return the digest as a \0-terminated string, or NULL if the file
+ *   can't be read.
+ *   Must be destroyed by caller.
+ */
+char *computeSHA1Digest( File *inFile );
+
+
+
+#endif
@@ -21,6 +21,11 @@
  *
  * 2013-January-7   Jason Rohrer
  * Added HMAC-SHA1 implementation.
+ *
+ * 2026-October-14   Jason Rohrer
+ * SHA1_Update no longer overwrites data, so digest functions don't copy it.
+ * Added SHA-NI and ARMv8 block functions, picked at run time.
+ * Added HMAC-SHA1 contexts, and switched hmac_sha1 to use them.
  */
 
 
@@ -54,6 +59,20 @@
 #include <string.h>
 #include <stdio.h>
 
+
+#if ( defined( __GNUC__ ) || defined( __clang__ ) ) && \
+    ( defined( __x86_64__ ) || defined( __i386__ ) )
+    // compiled in with a target attribute, used only if cpuid has SHA
+    #define SHA1_NI
+    #include <cpuid.h>
+    #include <immintrin.h>
+#elif defined( __aarch64__ ) && \
+    ( defined( __ARM_FEATURE_CRYPTO ) || defined( __ARM_FEATURE_SHA2 ) )
+    // build targets CPUs with crypto extensions, so no check needed
+    #define SHA1_ARM
+    #include <arm_neon.h>
+#endif
+
 // for hex encoding
 #include "minorGems/formats/encodingUtils.h"
 
@@ -87,11 +106,14 @@ typedef union _BYTE64QUAD16 {
 } BYTE64QUAD16;
 
 /* Hash a single 512-bit block. This is the core of the algorithm. */
-void SHA1_Transform(sha1_quadbyte state[5], sha1_byte buffer[64]) {
+void SHA1_Transform(sha1_quadbyte state[5], const sha1_byte buffer[64]) {
 	sha1_quadbyte	a, b, c, d, e;
+	BYTE64QUAD16	blockCopy;
 	BYTE64QUAD16	*block;
 
-	block = (BYTE64QUAD16*)buffer;
+	/* expansion happens in place, so work on a copy of the caller's data */
+	memcpy(blockCopy.c, buffer, 64);
+	block = &blockCopy;
 	/* Copy context->state[] to working vars */
 	a = state[0];
 	b = state[1];
@@ -130,6 +152,248 @@ void SHA1_Transform(sha1_quadbyte state[5], sha1_byte buffer[64]) {
 }
 
 
+
+// hashes inNumBlocks consecutive 64-byte blocks
+typedef void (*SHA1BlockFunction)( sha1_quadbyte *inOutState,
+                                   const sha1_byte *inData,
+                                   unsigned int inNumBlocks );
+
+
+static void portableSHA1Blocks( sha1_quadbyte *inOutState,
+                                const sha1_byte *inData,
+                                unsigned int inNumBlocks ) {
+    for( unsigned int i=0; i<inNumBlocks; i++ ) {
+        SHA1_Transform( inOutState, &( inData[ i * 64 ] ) );
+        }
+    }
+
+
+
+#ifdef SHA1_NI
+
+/**
+ * The SHA extensions (Goldmont and later, Zen and later), four rounds
+ * per sha1rnds4, with the message schedule done by sha1msg1/sha1msg2.
+ *
+ * This follows Intel's reference sequence:  each QUAD step finishes
+ * rounds for message block MG while advancing the schedule for the three
+ * blocks after it.
+ */
+
+#define SHA1_NI_QUAD( eThis, eNext, MG, MG1, MG2, MG3, func ) \
+    eThis = _mm_sha1nexte_epu32( eThis, MG ); \
+    eNext = abcd; \
+    MG1 = _mm_sha1msg2_epu32( MG1, MG ); \
+    abcd = _mm_sha1rnds4_epu32( abcd, eThis, func ); \
+    MG3 = _mm_sha1msg1_epu32( MG3, MG ); \
+    MG2 = _mm_xor_si128( MG2, MG );
+
+
+__attribute__(( target( "sha,sse4.1,ssse3" ) ))
+static void niSHA1Blocks( sha1_quadbyte *inOutState,
+                          const sha1_byte *inData,
+                          unsigned int inNumBlocks ) {
+
+    // reverses all 16 bytes:  big-endian words, in reverse word order
+    const __m128i byteMask = 
+        _mm_set_epi64x( 0x0001020304050607LL, 0x08090a0b0c0d0e0fLL );
+
+    __m128i abcd = _mm_loadu_si128( (const __m128i *)inOutState );
+    abcd = _mm_shuffle_epi32( abcd, 0x1B );
+    
+    __m128i e0 = _mm_set_epi32( (int)inOutState[4], 0, 0, 0 );
+    __m128i e1;
+
+    __m128i msg0, msg1, msg2, msg3;
+
+    for( unsigned int b=0; b<inNumBlocks; b++ ) {
+        __m128i abcdSave = abcd;
+        __m128i e0Save = e0;
+        
+        // rounds 0-3
+        msg0 = _mm_loadu_si128( (const __m128i *)( inData ) );
+        msg0 = _mm_shuffle_epi8( msg0, byteMask );
+        e0 = _mm_add_epi32( e0, msg0 );
+        e1 = abcd;
+        abcd = _mm_sha1rnds4_epu32( abcd, e0, 0 );
+
+        // rounds 4-7
+        msg1 = _mm_loadu_si128( (const __m128i *)( inData + 16 ) );
+        msg1 = _mm_shuffle_epi8( msg1, byteMask );
+        e1 = _mm_sha1nexte_epu32( e1, msg1 );
+        e0 = abcd;
+        abcd = _mm_sha1rnds4_epu32( abcd, e1, 0 );
+        msg0 = _mm_sha1msg1_epu32( msg0, msg1 );
+
+        // rounds 8-11
+        msg2 = _mm_loadu_si128( (const __m128i *)( inData + 32 ) );
+        msg2 = _mm_shuffle_epi8( msg2, byteMask );
+        e0 = _mm_sha1nexte_epu32( e0, msg2 );
+        e1 = abcd;
+        abcd = _mm_sha1rnds4_epu32( abcd, e0, 0 );
+        msg1 = _mm_sha1msg1_epu32( msg1, msg2 );
+        msg0 = _mm_xor_si128( msg0, msg2 );
+
+        // rounds 12-15
+        msg3 = _mm_loadu_si128( (const __m128i *)( inData + 48 ) );
+        msg3 = _mm_shuffle_epi8( msg3, byteMask );
+        SHA1_NI_QUAD( e1, e0, msg3, msg0, msg1, msg2, 0 )
+
+        // rounds 16-67
+        SHA1_NI_QUAD( e0, e1, msg0, msg1, msg2, msg3, 0 )
+        SHA1_NI_QUAD( e1, e0, msg1, msg2, msg3, msg0, 1 )
+        SHA1_NI_QUAD( e0, e1, msg2, msg3, msg0, msg1, 1 )
+        SHA1_NI_QUAD( e1, e0, msg3, msg0, msg1, msg2, 1 )
+        SHA1_NI_QUAD( e0, e1, msg0, msg1, msg2, msg3, 1 )
+        SHA1_NI_QUAD( e1, e0, msg1, msg2, msg3, msg0, 1 )
+        SHA1_NI_QUAD( e0, e1, msg2, msg3, msg0, msg1, 2 )
+        SHA1_NI_QUAD( e1, e0, msg3, msg0, msg1, msg2, 2 )
+        SHA1_NI_QUAD( e0, e1, msg0, msg1, msg2, msg3, 2 )
+        SHA1_NI_QUAD( e1, e0, msg1, msg2, msg3, msg0, 2 )
+        SHA1_NI_QUAD( e0, e1, msg2, msg3, msg0, msg1, 2 )
+        SHA1_NI_QUAD( e1, e0, msg3, msg0, msg1, msg2, 3 )
+        SHA1_NI_QUAD( e0, e1, msg0, msg1, msg2, msg3, 3 )
+
+        // rounds 68-79, schedule winding down
+        e1 = _mm_sha1nexte_epu32( e1, msg1 );
+        e0 = abcd;
+        msg2 = _mm_sha1msg2_epu32( msg2, msg1 );
+        abcd = _mm_sha1rnds4_epu32( abcd, e1, 3 );
+        msg3 = _mm_xor_si128( msg3, msg1 );
+
+        e0 = _mm_sha1nexte_epu32( e0, msg2 );
+        e1 = abcd;
+        msg3 = _mm_sha1msg2_epu32( msg3, msg2 );
+        abcd = _mm_sha1rnds4_epu32( abcd, e0, 3 );
+
+        e1 = _mm_sha1nexte_epu32( e1, msg3 );
+        e0 = abcd;
+        abcd = _mm_sha1rnds4_epu32( abcd, e1, 3 );
+
+        // add this block's result into state
+        e0 = _mm_sha1nexte_epu32( e0, e0Save );
+        abcd = _mm_add_epi32( abcd, abcdSave );
+
+        inData += 64;
+        }
+
+    abcd = _mm_shuffle_epi32( abcd, 0x1B );
+    _mm_storeu_si128( (__m128i *)inOutState, abcd );
+    inOutState[4] = (sha1_quadbyte)_mm_extract_epi32( e0, 3 );
+    }
+
+
+static char cpuHasSHA() {
+    unsigned int eax, ebx, ecx, edx;
+
+    if( ! __get_cpuid( 1, &eax, &ebx, &ecx, &edx ) ) {
+        return false;
+        }
+
+    // SSSE3 and SSE4.1
+    if( ! ( ecx & ( 1 << 9 ) ) || ! ( ecx & ( 1 << 19 ) ) ) {
+        return false;
+        }
+    
+    if( __get_cpuid_max( 0, NULL ) < 7 ) {
+        return false;
+        }
+
+    __cpuid_count( 7, 0, eax, ebx, ecx, edx );
+
+    return ( ebx & ( 1 << 29 ) ) != 0;
+    }
+
+#endif
+
+
+
+#ifdef SHA1_ARM
+
+// crypto extension instructions, also four rounds per instruction
+static void armSHA1Blocks( sha1_quadbyte *inOutState,
+                           const sha1_byte *inData,
+                           unsigned int inNumBlocks ) {
+    
+    const uint32x4_t k[4] = { vdupq_n_u32( 0x5A827999 ),
+                              vdupq_n_u32( 0x6ED9EBA1 ),
+                              vdupq_n_u32( 0x8F1BBCDC ),
+                              vdupq_n_u32( 0xCA62C1D6 ) };
+    
+    uint32x4_t abcd = vld1q_u32( inOutState );
+    uint32_t e = inOutState[4];
+
+    for( unsigned int b=0; b<inNumBlocks; b++ ) {
+        uint32x4_t abcdSave = abcd;
+        uint32_t eSave = e;
+
+        uint32x4_t msg[4];
+        
+        for( int i=0; i<4; i++ ) {
+            // big-endian words
+            msg[i] = vreinterpretq_u32_u8( 
+                vrev32q_u8( vld1q_u8( &( inData[ i * 16 ] ) ) ) );
+            }
+        
+        // 20 groups of 4 rounds
+        for( int g=0; g<20; g++ ) {
+            uint32x4_t w = vaddq_u32( msg[ g % 4 ], k[ g / 5 ] );
+
+            uint32_t nextE = vsha1h_u32( vgetq_lane_u32( abcd, 0 ) );
+
+            if( g < 5 ) {
+                abcd = vsha1cq_u32( abcd, e, w );
+                }
+            else if( g >= 10 && g < 15 ) {
+                abcd = vsha1mq_u32( abcd, e, w );
+                }
+            else {
+                abcd = vsha1pq_u32( abcd, e, w );
+                }
+            e = nextE;
+            
+            if( g < 16 ) {
+                // next words for group g + 4, replacing the ones just used
+                msg[ g % 4 ] = 
+                    vsha1su1q_u32( 
+                        vsha1su0q_u32( msg[ g % 4 ], 
+                                       msg[ ( g + 1 ) % 4 ],
+                                       msg[ ( g + 2 ) % 4 ] ),
+                        msg[ ( g + 3 ) % 4 ] );
+                }
+            }
+        
+        abcd = vaddq_u32( abcd, abcdSave );
+        e += eSave;
+
+        inData += 64;
+        }
+
+    vst1q_u32( inOutState, abcd );
+    inOutState[4] = e;
+    }
+
+#endif
+
+
+
+static SHA1BlockFunction pickSHA1BlockFunction() {
+#if defined( SHA1_NI )
+    if( cpuHasSHA() ) {
+        return niSHA1Blocks;
+        }
+#elif defined( SHA1_ARM )
+    return armSHA1Blocks;
+#endif
+    return portableSHA1Blocks;
+    }
+
+
+// picked on first use
+// (racing threads pick the same one, so this needs no lock)
+static SHA1BlockFunction sha1Blocks = NULL;
+
+
 /* SHA1_Init - Initialize new context */
 void SHA1_Init(SHA_CTX* context) {
 	/* SHA1 initialization constants */
@@ -142,17 +406,21 @@ void SHA1_Init(SHA_CTX* context) {
 }
 
 /* Run your data through this. */
-void SHA1_Update(SHA_CTX *context, sha1_byte *data, unsigned int len) {
+void SHA1_Update(SHA_CTX *context, const sha1_byte *data, unsigned int len) {
 	unsigned int	i, j;
 
+	if (sha1Blocks == NULL) sha1Blocks = pickSHA1BlockFunction();
+
 	j = (context->count[0] >> 3) & 63;
 	if ((context->count[0] += len << 3) < (len << 3)) context->count[1]++;
 	context->count[1] += (len >> 29);
 	if ((j + len) > 63) {
 	    memcpy(&context->buffer[j], data, (i = 64-j));
-	    SHA1_Transform(context->state, context->buffer);
-	    for ( ; i + 63 < len; i += 64) {
-	        SHA1_Transform(context->state, &data[i]);
+	    sha1Blocks(context->state, context->buffer, 1);
+	    /* whole blocks straight from caller's data */
+	    if (len - i >= 64) {
+	        sha1Blocks(context->state, &data[i], (len - i) / 64);
+	        i += ((len - i) / 64) * 64;
 	    }
 	    j = 0;
 	}
@@ -197,14 +465,7 @@ unsigned char *computeRawSHA1Digest( unsigned char *inData,
 
     SHA1_Init( &context );
 
-    // copy into buffer, since this SHA1 implementation seems to overwrite
-    // parts of the data buffer.
-    unsigned char *buffer = new unsigned char[ inDataLength ];
-    memcpy( (void *)buffer, (void *)inData, inDataLength ); 
-
-    SHA1_Update( &context, buffer, inDataLength );
-
-    delete [] buffer;
+    SHA1_Update( &context, inData, inDataLength );
     
     unsigned char *digest = new unsigned char[ SHA1_DIGEST_LENGTH ];
 
@@ -221,15 +482,7 @@ unsigned char *computeRawSHA1Digest( char *inString ) {
 
     SHA1_Init( &context );
 
-    // copy into buffer, since this SHA1 implementation seems to overwrite
-    // parts of the data buffer.
-    int dataLength = strlen( inString );
-    unsigned char *buffer = new unsigned char[ dataLength ];
-    memcpy( (void *)buffer, (void *)inString, dataLength ); 
-    
-    SHA1_Update( &context, buffer, strlen( inString ) );
-
-    delete [] buffer;
+    SHA1_Update( &context, (unsigned char *)inString, strlen( inString ) );
     
     unsigned char *digest = new unsigned char[ SHA1_DIGEST_LENGTH ];
 
@@ -268,104 +521,114 @@ char *computeSHA1Digest( unsigned char *inData, int inDataLength ) {
 
 
 
-// returns new data buffer of length inALength + inBLength
-static unsigned char *dataConcat( unsigned char *inA, int inALength,
-                                  unsigned char *inB, int inBLength ) {
-    int netLength = inALength + inBLength;
+void HMAC_SHA1_Init( HMAC_SHA1_CTX *outContext, 
+                     const unsigned char *inKey, int inKeyLength ) {
     
-    unsigned char *netData = new unsigned char[ netLength ];
-    int i=0;
-    for( int j=0; j<inALength; j++ ) {
-        netData[i] = inA[j];
-        i++;
+    unsigned char keyBlock[ SHA1_BLOCK_LENGTH ];
+
+    // key padded out to blocksize with zeros
+    memset( keyBlock, 0, SHA1_BLOCK_LENGTH );
+    
+    if( inKeyLength > SHA1_BLOCK_LENGTH ) {
+        // shorten long keys down to 20 byte hash of key
+        SHA_CTX keyContext;
+        SHA1_Init( &keyContext );
+        SHA1_Update( &keyContext, inKey, inKeyLength );
+        SHA1_Final( keyBlock, &keyContext );
         }
-    for( int j=0; j<inBLength; j++ ) {
-        netData[i] = inB[j];
-        i++;
+    else {
+        memcpy( keyBlock, inKey, inKeyLength );
         }
+
+    unsigned char innerPad[ SHA1_BLOCK_LENGTH ];
+    unsigned char outerPad[ SHA1_BLOCK_LENGTH ];
     
-    return netData;
+    for( int i=0; i<SHA1_BLOCK_LENGTH; i++ ) {
+        innerPad[i] = 0x36 ^ keyBlock[i];
+        outerPad[i] = 0x5c ^ keyBlock[i];
+        }
+
+    SHA1_Init( &( outContext->inner ) );
+    SHA1_Update( &( outContext->inner ), innerPad, SHA1_BLOCK_LENGTH );
+    
+    SHA1_Init( &( outContext->outer ) );
+    SHA1_Update( &( outContext->outer ), outerPad, SHA1_BLOCK_LENGTH );
+
+    // don't leave key material on the stack
+    memset( keyBlock, 0, SHA1_BLOCK_LENGTH );
+    memset( innerPad, 0, SHA1_BLOCK_LENGTH );
+    memset( outerPad, 0, SHA1_BLOCK_LENGTH );
     }
 
 
 
+void HMAC_SHA1_Compute( const HMAC_SHA1_CTX *inContext,
+                        const unsigned char *inData, int inDataLength,
+                        unsigned char outDigest[ SHA1_DIGEST_LENGTH ] ) {
 
-#include "minorGems/util/stringUtils.h"
- 
-char *hmac_sha1( const char *inKey, const char *inData ) {
-    unsigned char *keyRaw = (unsigned char*)stringDuplicate( inKey );
-    int keyLength = strlen( inKey );
+    // copies, so context can be reused
+    SHA_CTX context = inContext->inner;
     
+    SHA1_Update( &context, inData, inDataLength );
     
-    //unsigned char *computeRawSHA1Digest( unsigned char *inData, int inDataLength 
+    unsigned char innerHash[ SHA1_DIGEST_LENGTH ];
     
-    // shorten long keys down to 20 byte hash of key, if needed
-    if( keyLength > SHA1_BLOCK_LENGTH ) {
-        unsigned char *newKey = computeRawSHA1Digest( keyRaw, keyLength );
-        delete [] keyRaw;
-        keyRaw = newKey;
-        keyLength = SHA1_DIGEST_LENGTH;
-        }
+    SHA1_Final( innerHash, &context );
 
-    // pad key out to blocksize with zeros 
-    if( keyLength < SHA1_BLOCK_LENGTH ) {
-        unsigned char *newKey = new unsigned char[ SHA1_BLOCK_LENGTH ];
-        memset( newKey, 0, SHA1_BLOCK_LENGTH );
-        
-        memcpy( newKey, keyRaw, keyLength );
+    context = inContext->outer;
+    
+    SHA1_Update( &context, innerHash, SHA1_DIGEST_LENGTH );
+    SHA1_Final( outDigest, &context );
+    }
 
-        delete [] keyRaw;
 
-        keyRaw = newKey;
-        keyLength = SHA1_BLOCK_LENGTH;
-        }
-    
-    // computer inner and outer keys by XORing with data block
 
-    unsigned char *outerKey = new unsigned char[ keyLength ];
-    unsigned char *innerKey = new unsigned char[ keyLength ];
-    
-    for( int i=0; i<keyLength; i++ ) {
-        outerKey[i] = 0x5c ^ keyRaw[i];
-        innerKey[i] = 0x36 ^ keyRaw[i];
-        }
-    delete [] keyRaw;
+int HMAC_SHA1_VerifyBatch( const HMAC_SHA1_CTX *inContext,
+                           int inNumMessages,
+                           const unsigned char **inMessages,
+                           const int *inMessageLengths,
+                           const unsigned char **inExpectedDigests,
+                           char *outResults ) {
+    int numMatched = 0;
 
+    unsigned char digest[ SHA1_DIGEST_LENGTH ];
 
-    int dataLength = strlen( inData );
+    for( int m=0; m<inNumMessages; m++ ) {
+        HMAC_SHA1_Compute( inContext, inMessages[m], inMessageLengths[m],
+                           digest );
+        
+        // no early exit, so timing doesn't reveal how much matched
+        unsigned char difference = 0;
+        
+        for( int i=0; i<SHA1_DIGEST_LENGTH; i++ ) {
+            difference |= digest[i] ^ inExpectedDigests[m][i];
+            }
+        
+        char match = ( difference == 0 );
+        
+        if( outResults != NULL ) {
+            outResults[m] = match;
+            }
+        if( match ) {
+            numMatched++;
+            }
+        }
 
-    int innerDataLength = keyLength +dataLength;
-    
-    unsigned char *innerData = dataConcat( innerKey, keyLength,
-                                           (unsigned char*)inData, 
-                                           dataLength );
-    
-    delete [] innerKey;
+    return numMatched;
+    }
 
 
-    unsigned char *innerHash = computeRawSHA1Digest( innerData, 
-                                                     innerDataLength );
-    
-    delete [] innerData;
-    
 
-    int outerDataLength = keyLength + SHA1_DIGEST_LENGTH;
-    
-    unsigned char *outerData = dataConcat( outerKey, keyLength,
-                                           innerHash, SHA1_DIGEST_LENGTH );
-    
-    delete [] outerKey;
-    delete [] innerHash;
+char *hmac_sha1( const char *inKey, const char *inData ) {
+    HMAC_SHA1_CTX context;
     
+    HMAC_SHA1_Init( &context, (const unsigned char *)inKey, strlen( inKey ) );
     
+    unsigned char digest[ SHA1_DIGEST_LENGTH ];
 
-    char *digest = computeSHA1Digest( outerData, outerDataLength );
-    
-    delete [] outerData;
-    
+    HMAC_SHA1_Compute( &context, 
+                       (const unsigned char *)inData, strlen( inData ),
+                       digest );
 
-    return digest;
+    return hexEncode( digest, SHA1_DIGEST_LENGTH );
     }
-
-
-
@@ -3,16 +3,23 @@
  *
  * 2004-May-20   Jason Rohrer
  * Created.
+ *
+ * 2026-October-14   Jason Rohrer
+ * Hashes through fileSHA1 instead of a small read loop.
+ * Added a throughput mode for comparing against other tools.
  */
 
 
 
 #include "sha1.h"
+#include "fileSHA1.h"
 #include "minorGems/formats/encodingUtils.h"
+#include "minorGems/system/Time.h"
 
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 
 /**
@@ -26,65 +33,77 @@ void usage( char *inAppName );
 
 int main( int inNumArgs, char **inArgs ) {
 
+    char throughputMode = false;
+    
+    char *fileName;
+    
 
-    if( inNumArgs != 2 ) {
-        usage( inArgs[0] );
+    if( inNumArgs == 3 && strcmp( inArgs[1], "-t" ) == 0 ) {
+        throughputMode = true;
+        fileName = inArgs[2];
         }
-
-
-    FILE *file = fopen( inArgs[1], "rb" );
-
-    if( file == NULL ) {
-        printf( "Failed to open file %s for reading\n\n", inArgs[1] );
-
+    else if( inNumArgs == 2 ) {
+        fileName = inArgs[1];
+        }
+    else {
         usage( inArgs[0] );
         }
 
     
-    SHA_CTX shaContext;
+    File file( NULL, fileName );
 
-    SHA1_Init( &shaContext );
+    if( ! file.exists() ) {
+        printf( "File %s does not exist\n\n", fileName );
 
-               
-    int bufferSize = 5000;
-    unsigned char *buffer = new unsigned char[ bufferSize ];
+        usage( inArgs[0] );
+        }
 
-    int numRead = bufferSize;
 
-    char error = false;
+    double startTime = 0;
     
-    // read bytes from file until we run out
-    while( numRead == bufferSize && !error ) {
-
-        numRead = fread( buffer, 1, bufferSize, file );
+    if( throughputMode ) {
+        startTime = Time::getCurrentTime();
+        }
 
-        if( numRead > 0 ) {
-            SHA1_Update( &shaContext, buffer, numRead );
-            }
-        else{
-            error = true;
-            }
+    char *digestHexString = computeSHA1Digest( &file );
+    
+    if( digestHexString == NULL ) {
+        printf( "Error reading from file %s\n", fileName );
+        return 1;
         }
+    
+    printf( "%s  %s\n", digestHexString, fileName );
+    
+    delete [] digestHexString;
+    
 
-    fclose( file ); 
-    delete [] buffer;
+    if( throughputMode ) {
+        // first pass above measured cold cache, now repeat for at least
+        // a second to get a warm cache figure
 
+        double coldSeconds = Time::getCurrentTime() - startTime;
 
-    if( error ) {
-        printf( "Error reading from file %s\n", inArgs[1] );
-        }
-    else {
-        unsigned char *rawDigest = new unsigned char[ SHA1_DIGEST_LENGTH ];
+        double numBytes = (double)file.getLength();
         
-        SHA1_Final( rawDigest, &shaContext );
+        printf( "First pass:  %.3f GB/s (%.3f s)\n", 
+                numBytes / coldSeconds / 1e9, coldSeconds );
         
-        // else hash is correct
-        char *digestHexString = hexEncode( rawDigest, SHA1_DIGEST_LENGTH );
+        int numPasses = 0;
         
-        printf( "%s  %s\n", digestHexString, inArgs[1] );
+        startTime = Time::getCurrentTime();
+        
+        double seconds = 0;
+        
+        while( seconds < 1.0 ) {
+            unsigned char *rawDigest = computeRawSHA1Digest( &file );
+            delete [] rawDigest;
+            
+            numPasses ++;
+            seconds = Time::getCurrentTime() - startTime;
+            }
 
-        delete [] rawDigest;
-        delete [] digestHexString;
+        printf( "Warm cache:  %.3f GB/s (%d passes in %.3f s)\n", 
+                numBytes * numPasses / seconds / 1e9, numPasses, seconds );
         }
     
     return 0;
@@ -96,6 +115,8 @@ void usage( char *inAppName ) {
 
     printf( "Usage:\n\n" );
     printf( "\t%s file_to_sum\n", inAppName );
+    printf( "\t%s -t file_to_sum      (also report throughput)\n", 
+            inAppName );
 
     printf( "example:\n" );
 
@@ -0,0 +1,131 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+/**
+ * Measures shared secret key generation throughput, one key per call and
+ * in batches, after checking both against each other.
+ *
+ * Compile from above the minorGems directory with:
+ *   g++ -O2 -I.
+ *     minorGems/crypto/keyExchange/benchCurve.cpp
+ *     minorGems/crypto/keyExchange/curve25519.cpp
+ *     minorGems/crypto/cryptoRandom.cpp
+ *     minorGems/system/unix/TimeUnix.cpp -lpthread -o benchCurve
+ *
+ * Add -DCURVE25519_32BIT_LIMBS to measure the 32-bit field arithmetic
+ * instead of the 64-bit version.
+ */
+
+#include "minorGems/crypto/keyExchange/curve25519.h"
+#include "minorGems/crypto/cryptoRandom.h"
+
+#include "minorGems/system/Time.h"
+
+#include <stdio.h>
+#include <string.h>
+
+
+
+#define NUM_KEYS 4096
+
+// batch sizes to try
+static int batchSizes[] = { 1, 8, 64, 512 };
+
+
+
+int main() {
+
+    #ifdef CURVE25519_32BIT_LIMBS
+    printf( "32-bit limbs\n" );
+    #else
+    printf( "64-bit limbs (if compiler has 128-bit integers)\n" );
+    #endif
+
+    unsigned char *secrets = new unsigned char[ 32 * NUM_KEYS ];
+    unsigned char *publics = new unsigned char[ 32 * NUM_KEYS ];
+    unsigned char *shared = new unsigned char[ 32 * NUM_KEYS ];
+    unsigned char *batchShared = new unsigned char[ 32 * NUM_KEYS ];
+
+    getCryptoRandomBytes( secrets, 32 * NUM_KEYS );
+
+    unsigned char otherSecret[32];
+    getCryptoRandomBytes( otherSecret, 32 );
+
+
+    double startTime = Time::getCurrentTime();
+
+    for( int i=0; i<NUM_KEYS; i++ ) {
+        curve25519_genPublicKey( &( publics[ 32 * i ] ),
+                                 &( secrets[ 32 * i ] ) );
+        }
+
+    double publicTime = Time::getCurrentTime() - startTime;
+
+    printf( "genPublicKey:            %6.0f keys/sec\n",
+            NUM_KEYS / publicTime );
+
+
+    startTime = Time::getCurrentTime();
+
+    for( int i=0; i<NUM_KEYS; i++ ) {
+        curve25519_genSharedSecretKey( &( shared[ 32 * i ] ),
+                                       otherSecret,
+                                       &( publics[ 32 * i ] ) );
+        }
+
+    double singleTime = Time::getCurrentTime() - startTime;
+
+    printf( "genSharedSecretKey:      %6.0f keys/sec\n",
+            NUM_KEYS / singleTime );
+
+
+    // batch is always for one secret per key
+    unsigned char *otherSecrets = new unsigned char[ 32 * NUM_KEYS ];
+    for( int i=0; i<NUM_KEYS; i++ ) {
+        memcpy( &( otherSecrets[ 32 * i ] ), otherSecret, 32 );
+        }
+
+    int numBatchSizes = sizeof( batchSizes ) / sizeof( int );
+
+    int numFailed = 0;
+
+    for( int b=0; b<numBatchSizes; b++ ) {
+        int batchSize = batchSizes[b];
+
+        memset( batchShared, 0, 32 * NUM_KEYS );
+
+        startTime = Time::getCurrentTime();
+
+        for( int i=0; i<NUM_KEYS; i+= batchSize ) {
+            curve25519_genSharedSecretKeys( batchSize,
+                                            &( batchShared[ 32 * i ] ),
+                                            &( otherSecrets[ 32 * i ] ),
+                                            &( publics[ 32 * i ] ) );
+            }
+
+        double batchTime = Time::getCurrentTime() - startTime;
+
+        printf( "genSharedSecretKeys %3d: %6.0f keys/sec\n",
+                batchSize, NUM_KEYS / batchTime );
+
+        if( memcmp( batchShared, shared, 32 * NUM_KEYS ) != 0 ) {
+            printf( "  Batch results don't match single results\n" );
+            numFailed++;
+            }
+        }
+
+    delete [] secrets;
+    delete [] publics;
+    delete [] shared;
+    delete [] batchShared;
+    delete [] otherSecrets;
+
+    if( numFailed > 0 ) {
+        return 1;
+        }
+    return 0;
+    }
@@ -53,10 +53,453 @@
 #define inline __inline
 #endif
 
+#if defined( __SIZEOF_INT128__ ) && !defined( CURVE25519_32BIT_LIMBS )
+#define CURVE25519_64BIT_LIMBS
+#endif
+
+
+#ifdef CURVE25519_64BIT_LIMBS
+
+/* 64-bit version, after curve25519-donna-c64.c (also by agl), for
+ * compilers that provide a 128-bit integer type (GCC and clang on 64-bit
+ * targets).  Each multiply of two limbs is one 64x64->128 instruction,
+ * and a field element is 5 limbs instead of 10, so this is several times
+ * faster than the 32-bit version below.
+ *
+ * Define CURVE25519_32BIT_LIMBS to force the 32-bit version.
+ */
+
+typedef uint8_t u8;
+typedef uint64_t limb;
+typedef unsigned __int128 uint128_t;
+
+#define FELEM_LIMBS 5
+
+/* Field element representation:
+ *
+ * Field elements are written as an array of unsigned, 64-bit limbs, least
+ * significant first. The value of the field element is:
+ *   x[0] + 2^51*x[1] + 2^102*x[2] + 2^153*x[3] + 2^204*x[4]
+ *
+ * i.e. the limbs are 51 bits wide.
+ */
+
+#define LIMB_MASK 0x7ffffffffffffULL
+
+/* Sum two numbers: output += in */
+static inline void fsum(limb *output, const limb *in) {
+  output[0] += in[0];
+  output[1] += in[1];
+  output[2] += in[2];
+  output[3] += in[3];
+  output[4] += in[4];
+}
+
+/* Find the difference of two numbers: output = in - output
+ * (note the order of the arguments!)
+ *
+ * Assumes that out[i] < 2^52
+ * On return, out[i] < 2^55
+ */
+static inline void fdifference_backwards(limb *out, const limb *in) {
+  /* 152 is 19 << 3 */
+  static const limb two54m152 = (((limb)1) << 54) - 152;
+  static const limb two54m8 = (((limb)1) << 54) - 8;
+
+  out[0] = in[0] + two54m152 - out[0];
+  out[1] = in[1] + two54m8 - out[1];
+  out[2] = in[2] + two54m8 - out[2];
+  out[3] = in[3] + two54m8 - out[3];
+  out[4] = in[4] + two54m8 - out[4];
+}
+
+/* Multiply a number by a scalar: output = in * scalar */
+static inline void fscalar_product(limb *output, const limb *in,
+                                   const limb scalar) {
+  uint128_t a;
+
+  a = in[0] * (uint128_t) scalar;
+  output[0] = ((limb)a) & LIMB_MASK;
+
+  a = in[1] * (uint128_t) scalar + ((limb) (a >> 51));
+  output[1] = ((limb)a) & LIMB_MASK;
+
+  a = in[2] * (uint128_t) scalar + ((limb) (a >> 51));
+  output[2] = ((limb)a) & LIMB_MASK;
+
+  a = in[3] * (uint128_t) scalar + ((limb) (a >> 51));
+  output[3] = ((limb)a) & LIMB_MASK;
+
+  a = in[4] * (uint128_t) scalar + ((limb) (a >> 51));
+  output[4] = ((limb)a) & LIMB_MASK;
+
+  output[0] += (limb)(a >> 51) * 19;
+}
+
+/* Multiply two numbers: output = in2 * in
+ *
+ * output may alias either input, since inputs are read before output is
+ * written.
+ *
+ * Assumes that in[i] < 2^55 and likewise for in2.
+ * On return, output[i] < 2^52
+ */
+static inline void fmul(limb *output, const limb *in2, const limb *in) {
+  uint128_t t[5];
+  limb r0, r1, r2, r3, r4, s0, s1, s2, s3, s4, c;
+
+  r0 = in[0];
+  r1 = in[1];
+  r2 = in[2];
+  r3 = in[3];
+  r4 = in[4];
+
+  s0 = in2[0];
+  s1 = in2[1];
+  s2 = in2[2];
+  s3 = in2[3];
+  s4 = in2[4];
+
+  t[0] = ((uint128_t) r0) * s0;
+  t[1] = ((uint128_t) r0) * s1 + ((uint128_t) r1) * s0;
+  t[2] = ((uint128_t) r0) * s2 + ((uint128_t) r2) * s0 +
+         ((uint128_t) r1) * s1;
+  t[3] = ((uint128_t) r0) * s3 + ((uint128_t) r3) * s0 +
+         ((uint128_t) r1) * s2 + ((uint128_t) r2) * s1;
+  t[4] = ((uint128_t) r0) * s4 + ((uint128_t) r4) * s0 +
+         ((uint128_t) r3) * s1 + ((uint128_t) r1) * s3 +
+         ((uint128_t) r2) * s2;
+
+  r4 *= 19;
+  r1 *= 19;
+  r2 *= 19;
+  r3 *= 19;
+
+  t[0] += ((uint128_t) r4) * s1 + ((uint128_t) r1) * s4 +
+          ((uint128_t) r2) * s3 + ((uint128_t) r3) * s2;
+  t[1] += ((uint128_t) r4) * s2 + ((uint128_t) r2) * s4 +
+          ((uint128_t) r3) * s3;
+  t[2] += ((uint128_t) r4) * s3 + ((uint128_t) r3) * s4;
+  t[3] += ((uint128_t) r4) * s4;
+
+              r0 = (limb)t[0] & LIMB_MASK; c = (limb)(t[0] >> 51);
+  t[1] += c;  r1 = (limb)t[1] & LIMB_MASK; c = (limb)(t[1] >> 51);
+  t[2] += c;  r2 = (limb)t[2] & LIMB_MASK; c = (limb)(t[2] >> 51);
+  t[3] += c;  r3 = (limb)t[3] & LIMB_MASK; c = (limb)(t[3] >> 51);
+  t[4] += c;  r4 = (limb)t[4] & LIMB_MASK; c = (limb)(t[4] >> 51);
+  r0 += c * 19; c = r0 >> 51; r0 = r0 & LIMB_MASK;
+  r1 += c;      c = r1 >> 51; r1 = r1 & LIMB_MASK;
+  r2 += c;
+
+  output[0] = r0;
+  output[1] = r1;
+  output[2] = r2;
+  output[3] = r3;
+  output[4] = r4;
+}
+
+/* Square a number count times: output = in^(2^count)
+ *
+ * count must be at least 1.  output may alias in.
+ */
+static inline void fsquare_times(limb *output, const limb *in, limb count) {
+  uint128_t t[5];
+  limb r0, r1, r2, r3, r4, c;
+  limb d0, d1, d2, d4, d419;
+
+  r0 = in[0];
+  r1 = in[1];
+  r2 = in[2];
+  r3 = in[3];
+  r4 = in[4];
+
+  do {
+    d0 = r0 * 2;
+    d1 = r1 * 2;
+    d2 = r2 * 2 * 19;
+    d419 = r4 * 19;
+    d4 = d419 * 2;
+
+    t[0] = ((uint128_t) r0) * r0 + ((uint128_t) d4) * r1 +
+           (((uint128_t) d2) * (r3));
+    t[1] = ((uint128_t) d0) * r1 + ((uint128_t) d4) * r2 +
+           (((uint128_t) r3) * (r3 * 19));
+    t[2] = ((uint128_t) d0) * r2 + ((uint128_t) r1) * r1 +
+           (((uint128_t) d4) * (r3));
+    t[3] = ((uint128_t) d0) * r3 + ((uint128_t) d1) * r2 +
+           (((uint128_t) r4) * (d419));
+    t[4] = ((uint128_t) d0) * r4 + ((uint128_t) d1) * r3 +
+           (((uint128_t) r2) * (r2));
+
+                r0 = (limb)t[0] & LIMB_MASK; c = (limb)(t[0] >> 51);
+    t[1] += c;  r1 = (limb)t[1] & LIMB_MASK; c = (limb)(t[1] >> 51);
+    t[2] += c;  r2 = (limb)t[2] & LIMB_MASK; c = (limb)(t[2] >> 51);
+    t[3] += c;  r3 = (limb)t[3] & LIMB_MASK; c = (limb)(t[3] >> 51);
+    t[4] += c;  r4 = (limb)t[4] & LIMB_MASK; c = (limb)(t[4] >> 51);
+    r0 += c * 19; c = r0 >> 51; r0 = r0 & LIMB_MASK;
+    r1 += c;      c = r1 >> 51; r1 = r1 & LIMB_MASK;
+    r2 += c;
+  } while (--count);
+
+  output[0] = r0;
+  output[1] = r1;
+  output[2] = r2;
+  output[3] = r3;
+  output[4] = r4;
+}
+
+/* Load a little-endian 64-bit number */
+static limb load_limb(const u8 *in) {
+  return
+    ((limb)in[0]) |
+    (((limb)in[1]) << 8) |
+    (((limb)in[2]) << 16) |
+    (((limb)in[3]) << 24) |
+    (((limb)in[4]) << 32) |
+    (((limb)in[5]) << 40) |
+    (((limb)in[6]) << 48) |
+    (((limb)in[7]) << 56);
+}
+
+static void store_limb(u8 *out, limb in) {
+  out[0] = in & 0xff;
+  out[1] = (in >> 8) & 0xff;
+  out[2] = (in >> 16) & 0xff;
+  out[3] = (in >> 24) & 0xff;
+  out[4] = (in >> 32) & 0xff;
+  out[5] = (in >> 40) & 0xff;
+  out[6] = (in >> 48) & 0xff;
+  out[7] = (in >> 56) & 0xff;
+}
+
+/* Take a little-endian, 32-byte number and expand it into polynomial form.
+ * The top bit is ignored, as RFC 7748 requires.
+ */
+static void fexpand(limb *output, const u8 *in) {
+  output[0] = load_limb(in) & LIMB_MASK;
+  output[1] = (load_limb(in + 6) >> 3) & LIMB_MASK;
+  output[2] = (load_limb(in + 12) >> 6) & LIMB_MASK;
+  output[3] = (load_limb(in + 19) >> 1) & LIMB_MASK;
+  output[4] = (load_limb(in + 24) >> 12) & LIMB_MASK;
+}
+
+/* Take a reduced polynomial form number and contract it into a
+ * little-endian, 32-byte array.  input is not modified.
+ */
+static void fcontract(u8 *output, const limb *input) {
+  uint128_t t[5];
+
+  t[0] = input[0];
+  t[1] = input[1];
+  t[2] = input[2];
+  t[3] = input[3];
+  t[4] = input[4];
+
+  t[1] += t[0] >> 51; t[0] &= LIMB_MASK;
+  t[2] += t[1] >> 51; t[1] &= LIMB_MASK;
+  t[3] += t[2] >> 51; t[2] &= LIMB_MASK;
+  t[4] += t[3] >> 51; t[3] &= LIMB_MASK;
+  t[0] += 19 * (t[4] >> 51); t[4] &= LIMB_MASK;
+
+  t[1] += t[0] >> 51; t[0] &= LIMB_MASK;
+  t[2] += t[1] >> 51; t[1] &= LIMB_MASK;
+  t[3] += t[2] >> 51; t[2] &= LIMB_MASK;
+  t[4] += t[3] >> 51; t[3] &= LIMB_MASK;
+  t[0] += 19 * (t[4] >> 51); t[4] &= LIMB_MASK;
+
+  /* now t is between 0 and 2^255-1, properly carried. */
+  /* case 1: between 0 and 2^255-20. case 2: between 2^255-19 and
+   * 2^255-1. */
+
+  t[0] += 19;
+
+  t[1] += t[0] >> 51; t[0] &= LIMB_MASK;
+  t[2] += t[1] >> 51; t[1] &= LIMB_MASK;
+  t[3] += t[2] >> 51; t[2] &= LIMB_MASK;
+  t[4] += t[3] >> 51; t[3] &= LIMB_MASK;
+  t[0] += 19 * (t[4] >> 51); t[4] &= LIMB_MASK;
+
+  /* now between 19 and 2^255-1 in both cases, and offset by 19. */
+
+  t[0] += 0x8000000000000ULL - 19;
+  t[1] += 0x8000000000000ULL - 1;
+  t[2] += 0x8000000000000ULL - 1;
+  t[3] += 0x8000000000000ULL - 1;
+  t[4] += 0x8000000000000ULL - 1;
+
+  /* now between 2^255 and 2^256-20, and offset by 2^255. */
+
+  t[1] += t[0] >> 51; t[0] &= LIMB_MASK;
+  t[2] += t[1] >> 51; t[1] &= LIMB_MASK;
+  t[3] += t[2] >> 51; t[2] &= LIMB_MASK;
+  t[4] += t[3] >> 51; t[3] &= LIMB_MASK;
+  t[4] &= LIMB_MASK;
+
+  store_limb(output, (limb)(t[0] | (t[1] << 51)));
+  store_limb(output + 8, (limb)((t[1] >> 13) | (t[2] << 38)));
+  store_limb(output + 16, (limb)((t[2] >> 26) | (t[3] << 25)));
+  store_limb(output + 24, (limb)((t[3] >> 39) | (t[4] << 12)));
+}
+
+/* Input: Q, Q', Q-Q'
+ * Output: 2Q, Q+Q'
+ *
+ *   x2 z2: long form
+ *   x3 z3: long form
+ *   x z: short form, destroyed
+ *   xprime zprime: short form, destroyed
+ *   qmqp: short form, preserved
+ */
+static void fmonty(limb *x2, limb *z2, /* output 2Q */
+                   limb *x3, limb *z3, /* output Q + Q' */
+                   limb *x, limb *z,   /* input Q */
+                   limb *xprime, limb *zprime, /* input Q' */
+                   const limb *qmqp /* input Q - Q' */) {
+  limb origx[5], origxprime[5], zzz[5], xx[5], zz[5], xxprime[5],
+       zzprime[5], zzzprime[5];
+
+  memcpy(origx, x, 5 * sizeof(limb));
+  fsum(x, z);
+  fdifference_backwards(z, origx);  /* does x - z */
+
+  memcpy(origxprime, xprime, sizeof(limb) * 5);
+  fsum(xprime, zprime);
+  fdifference_backwards(zprime, origxprime);
+  fmul(xxprime, xprime, z);
+  fmul(zzprime, x, zprime);
+  memcpy(origxprime, xxprime, sizeof(limb) * 5);
+  fsum(xxprime, zzprime);
+  fdifference_backwards(zzprime, origxprime);
+  fsquare_times(x3, xxprime, 1);
+  fsquare_times(zzzprime, zzprime, 1);
+  fmul(z3, zzzprime, qmqp);
+
+  fsquare_times(xx, x, 1);
+  fsquare_times(zz, z, 1);
+  fmul(x2, xx, zz);
+  fdifference_backwards(zz, xx);  /* does zz = xx - zz */
+  fscalar_product(zzz, zz, 121665);
+  fsum(zzz, xx);
+  fmul(z2, zz, zzz);
+}
+
+/* Conditionally swap two reduced-form limb arrays if 'iswap' is 1, but leave
+ * them unchanged if 'iswap' is 0.  Runs in data-invariant time to avoid
+ * side-channel attacks.
+ */
+static void swap_conditional(limb *a, limb *b, limb iswap) {
+  unsigned i;
+  const limb swap = -iswap;
+
+  for (i = 0; i < 5; ++i) {
+    const limb x = swap & (a[i] ^ b[i]);
+    a[i] ^= x;
+    b[i] ^= x;
+  }
+}
+
+/* Calculates nQ where Q is the x-coordinate of a point on the curve
+ *
+ *   resultx/resultz: the x coordinate of the resulting curve point (short
+ *                    form)
+ *   n: a little endian, 32-byte number
+ *   q: a point of the curve (short form)
+ */
+static void cmult(limb *resultx, limb *resultz, const u8 *n, const limb *q) {
+  limb a[5] = {0}, b[5] = {1}, c[5] = {1}, d[5] = {0};
+  limb *nqpqx = a, *nqpqz = b, *nqx = c, *nqz = d, *t;
+  limb e[5] = {0}, f[5] = {1}, g[5] = {0}, h[5] = {1};
+  limb *nqpqx2 = e, *nqpqz2 = f, *nqx2 = g, *nqz2 = h;
+
+  unsigned i, j;
+
+  memcpy(nqpqx, q, sizeof(limb) * 5);
+
+  for (i = 0; i < 32; ++i) {
+    u8 byte = n[31 - i];
+    for (j = 0; j < 8; ++j) {
+      const limb bit = byte >> 7;
+
+      swap_conditional(nqx, nqpqx, bit);
+      swap_conditional(nqz, nqpqz, bit);
+      fmonty(nqx2, nqz2,
+             nqpqx2, nqpqz2,
+             nqx, nqz,
+             nqpqx, nqpqz,
+             q);
+      swap_conditional(nqx2, nqpqx2, bit);
+      swap_conditional(nqz2, nqpqz2, bit);
+
+      t = nqx;
+      nqx = nqx2;
+      nqx2 = t;
+      t = nqz;
+      nqz = nqz2;
+      nqz2 = t;
+      t = nqpqx;
+      nqpqx = nqpqx2;
+      nqpqx2 = t;
+      t = nqpqz;
+      nqpqz = nqpqz2;
+      nqpqz2 = t;
+
+      byte <<= 1;
+    }
+  }
+
+  memcpy(resultx, nqx, sizeof(limb) * 5);
+  memcpy(resultz, nqz, sizeof(limb) * 5);
+}
+
+/* Shamelessly copied from djb's code, tightened a little */
+static void
+crecip(limb *out, const limb *z) {
+  limb a[5], t0[5], b[5], c[5];
+
+  /* 2 */ fsquare_times(a, z, 1); /* a = 2 */
+  /* 8 */ fsquare_times(t0, a, 2);
+  /* 9 */ fmul(b, t0, z); /* b = 9 */
+  /* 11 */ fmul(a, b, a); /* a = 11 */
+  /* 22 */ fsquare_times(t0, a, 1);
+  /* 2^5 - 2^0 = 31 */ fmul(b, t0, b);
+  /* 2^10 - 2^5 */ fsquare_times(t0, b, 5);
+  /* 2^10 - 2^0 */ fmul(b, t0, b);
+  /* 2^20 - 2^10 */ fsquare_times(t0, b, 10);
+  /* 2^20 - 2^0 */ fmul(c, t0, b);
+  /* 2^40 - 2^20 */ fsquare_times(t0, c, 20);
+  /* 2^40 - 2^0 */ fmul(t0, t0, c);
+  /* 2^50 - 2^10 */ fsquare_times(t0, t0, 10);
+  /* 2^50 - 2^0 */ fmul(b, t0, b);
+  /* 2^100 - 2^50 */ fsquare_times(t0, b, 50);
+  /* 2^100 - 2^0 */ fmul(c, t0, b);
+  /* 2^200 - 2^100 */ fsquare_times(t0, c, 100);
+  /* 2^200 - 2^0 */ fmul(t0, t0, c);
+  /* 2^250 - 2^50 */ fsquare_times(t0, t0, 50);
+  /* 2^250 - 2^0 */ fmul(t0, t0, b);
+  /* 2^255 - 2^5 */ fsquare_times(t0, t0, 5);
+  /* 2^255 - 21 */ fmul(out, t0, a);
+}
+
+/* x * z^-1, contracted into 32 bytes */
+static void
+fcontract_quotient(u8 *output, const limb *x, const limb *zinverse) {
+  limb q[5];
+
+  fmul(q, x, zinverse);
+  fcontract(output, q);
+}
+
+
+#else
+
+/* 32-bit version, for compilers without a 128-bit integer type */
+
 typedef uint8_t u8;
 typedef int32_t s32;
 typedef int64_t limb;
 
+#define FELEM_LIMBS 10
+
 /* Field element representation:
  *
  * Field elements are written as an array of signed, 64-bit limbs, least
@@ -400,7 +843,9 @@ fsquare(limb *output, const limb *in) {
   memcpy(output, t, sizeof(limb) * 10);
 }
 
-/* Take a little-endian, 32-byte number and expand it into polynomial form */
+/* Take a little-endian, 32-byte number and expand it into polynomial form.
+ * The top bit is ignored, as RFC 7748 requires.
+ */
 static void
 fexpand(limb *output, const u8 *input) {
 #define F(n,start,shift,mask) \
@@ -417,7 +862,7 @@ fexpand(limb *output, const u8 *input) {
   F(6, 19, 1, 0x3ffffff);
   F(7, 22, 3, 0x1ffffff);
   F(8, 25, 4, 0x3ffffff);
-  F(9, 28, 6, 0x3ffffff);
+  F(9, 28, 6, 0x1ffffff);
 #undef F
 }
 
@@ -711,11 +1156,26 @@ crecip(limb *out, const limb *z) {
   /* 2^255 - 21 */ fmul(out,t1,z11);
 }
 
+/* x * z^-1, contracted into 32 bytes */
+static void
+fcontract_quotient(u8 *output, const limb *x, const limb *zinverse) {
+  /* freduce_coefficients zeroes an 11th limb */
+  limb q[11];
+
+  fmul(q, x, zinverse);
+  freduce_coefficients(q);
+  fcontract(output, q);
+}
+
+#endif
+
 int curve25519_donna(u8 *, const u8 *, const u8 *);
 
-int
-curve25519_donna(u8 *mypublic, const u8 *secret, const u8 *basepoint) {
-  limb bp[10], x[10], z[11], zmone[10];
+/* Runs the ladder for secret on basepoint, leaving the result in
+ * projective (x/z) form */
+static void
+ladder(limb *x, limb *z, const u8 *secret, const u8 *basepoint) {
+  limb bp[FELEM_LIMBS];
   uint8_t e[32];
   int i;
 
@@ -726,10 +1186,15 @@ curve25519_donna(u8 *mypublic, const u8 *secret, const u8 *basepoint) {
 
   fexpand(bp, basepoint);
   cmult(x, z, e, bp);
+}
+
+int
+curve25519_donna(u8 *mypublic, const u8 *secret, const u8 *basepoint) {
+  limb x[FELEM_LIMBS], z[FELEM_LIMBS], zmone[FELEM_LIMBS];
+
+  ladder(x, z, secret, basepoint);
   crecip(zmone, z);
-  fmul(z, x, zmone);
-  freduce_coefficients(z);
-  fcontract(mypublic, z);
+  fcontract_quotient(mypublic, x, zmone);
   return 0;
 }
 
@@ -795,3 +1260,116 @@ void curve25519_genSharedSecretKey(
 
 
 
+
+
+
+void curve25519_genSharedSecretKeys( 
+    int inNumKeys,
+    unsigned char *outSharedSecretKeys,
+    unsigned char *inSecretKeys,
+    unsigned char *inOtherPublicKeys ) {
+
+    if( inNumKeys <= 0 ) {
+        return;
+        }
+    
+    // each key's ladder leaves it as x/z, and the divisions by z are
+    // what's shared:
+    // invert product of all z with one crecip, then peel each z^-1 off
+    // of it with two multiplies (Montgomery's trick)
+    
+    limb *x = new limb[ inNumKeys * FELEM_LIMBS ];
+    limb *z = new limb[ inNumKeys * FELEM_LIMBS ];
+    
+    // product of z for keys 0 through i
+    limb *zProducts = new limb[ inNumKeys * FELEM_LIMBS ];
+
+    // z is 0 when other public key is a low-order point, and
+    // curve25519_donna gives all zeros for those
+    // a 0 can't be in product, so 1 is used in its place
+    char *zIsZero = new char[ inNumKeys ];
+    
+
+    for( int i=0; i<inNumKeys; i++ ) {
+        unsigned char workingSecret[32];
+    
+        memcpy( workingSecret, &( inSecretKeys[ 32 * i ] ), 32 );
+
+        modifySecretKey( workingSecret );
+
+        limb *xi = &( x[ i * FELEM_LIMBS ] );
+        limb *zi = &( z[ i * FELEM_LIMBS ] );
+        
+        ladder( xi, zi, workingSecret, &( inOtherPublicKeys[ 32 * i ] ) );
+
+        
+        // depends only on other public key, not secret
+        limb zCopy[ FELEM_LIMBS ];
+        memcpy( zCopy, zi, sizeof( zCopy ) );
+        
+        unsigned char zBytes[32];
+        fcontract( zBytes, zCopy );
+        
+        unsigned char zBits = 0;
+        for( int b=0; b<32; b++ ) {
+            zBits |= zBytes[b];
+            }
+        
+        zIsZero[i] = ( zBits == 0 );
+
+        if( zIsZero[i] ) {
+            memset( zi, 0, sizeof( limb ) * FELEM_LIMBS );
+            zi[0] = 1;
+            }
+
+        limb *product = &( zProducts[ i * FELEM_LIMBS ] );
+        
+        if( i == 0 ) {
+            memcpy( product, zi, sizeof( limb ) * FELEM_LIMBS );
+            }
+        else {
+            fmul( product, &( zProducts[ ( i - 1 ) * FELEM_LIMBS ] ), zi );
+            }
+        }
+    
+
+    // inverse of product of z for keys 0 through i, walking i down
+    limb inverse[ FELEM_LIMBS ];
+    crecip( inverse, &( zProducts[ ( inNumKeys - 1 ) * FELEM_LIMBS ] ) );
+    
+    for( int i=inNumKeys - 1; i>=0; i-- ) {
+        limb *zi = &( z[ i * FELEM_LIMBS ] );
+        
+        limb zInverse[ FELEM_LIMBS ];
+        
+        if( i > 0 ) {
+            fmul( zInverse, inverse, &( zProducts[ ( i - 1 ) * FELEM_LIMBS ] ) );
+            
+            limb nextInverse[ FELEM_LIMBS ];
+            fmul( nextInverse, inverse, zi );
+            memcpy( inverse, nextInverse, sizeof( inverse ) );
+            }
+        else {
+            memcpy( zInverse, inverse, sizeof( zInverse ) );
+            }
+
+        unsigned char *out = &( outSharedSecretKeys[ 32 * i ] );
+        
+        if( zIsZero[i] ) {
+            memset( out, 0, 32 );
+            }
+        else {
+            fcontract_quotient( out, &( x[ i * FELEM_LIMBS ] ), zInverse );
+            }
+        }
+    
+    
+    // secrets can be recovered from ladder output
+    memset( x, 0, sizeof( limb ) * inNumKeys * FELEM_LIMBS );
+    memset( zProducts, 0, sizeof( limb ) * inNumKeys * FELEM_LIMBS );
+    
+    delete [] x;
+    delete [] z;
+    delete [] zProducts;
+    delete [] zIsZero;
+    }
@@ -19,3 +19,16 @@ void curve25519_genSharedSecretKey(
 
 
 
+
+
+// Generates inNumKeys shared secret keys at once, same as calling
+// curve25519_genSharedSecretKey for each, but faster for a server
+// handling many key exchanges:  the final field inversion is done once
+// for the whole batch instead of once per key.
+//
+// Keys are packed 32 bytes each, so each array holds 32 * inNumKeys bytes.
+void curve25519_genSharedSecretKeys( 
+    int inNumKeys,
+    unsigned char *outSharedSecretKeys,
+    unsigned char *inSecretKeys,
+    unsigned char *inOtherPublicKeys );
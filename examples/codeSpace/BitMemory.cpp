@@ -3,6 +3,10 @@
  *
  * 2000-November-19		Jason Rohrer
  * Created.
+ *
+ * 2026-October-15		Jason Rohrer
+ * Ranges copied 32 bits at a time instead of bit by bit.  Added range
+ * operations.
  */
  
 #include "BitMemory.h"
@@ -17,7 +21,7 @@ unsigned char *BitMemory::getMemoryRange( unsigned long inRangeStart,
 		printf( "Bad memory range: [%d, %d]\n", inRangeStart, inRangeEnd );
 		return NULL;
 		}
-	// wrapping is handled automatically by getBit()
+	// wrapping is handled automatically by getBits()
 	
 	
 	unsigned long numBlocks = ( ( inRangeEnd - inRangeStart + 1 ) >> 3 );
@@ -32,20 +36,7 @@ unsigned char *BitMemory::getMemoryRange( unsigned long inRangeStart,
 		output[b] = 0;
 		}
 	
-	// bit index in output
-	int i = 0;
-	
-	for( int m=inRangeStart; m<=inRangeEnd; m++ ) {
-		unsigned char memBit = getBit( m );
-		
-		unsigned long block = i >> 3;	// index of block containing bit
-		int bit = i - ( block << 3 );	// index of bit in block
-		int shiftAmount = 7 - bit;
-		
-		output[block] = output[block] | ( memBit << shiftAmount );
-		
-		i++;
-		}
+	getRangeInto( inRangeStart, inRangeEnd - inRangeStart + 1, output );
 		
 	*outNumCharsReturned = numBlocks;
 	return output;
@@ -62,26 +53,10 @@ void BitMemory::setMemoryRange( unsigned long inRangeStart,
 		printf( "Bad memory range: [%d, %d]\n", inRangeStart, inRangeEnd );
 		return;
 		}
-	// wrapping is handled automatically by setBit()
-	
-	// bit index in input
-	int i = 0;
+	// wrapping is handled automatically by setBits()
 	
-	for( int m=inRangeStart; m<=inRangeEnd; m++ ) {
-		char inputBit;
-		
-		unsigned long block = i >> 3;	// index of block containing bit
-		int bit = i - ( block << 3 );	// index of bit in block
-		int shiftAmount = 7 - bit;
-		
-		// shift and clear to extract bit from block
-		inputBit = 
-			(char)( ( inRangeContents[block] >> shiftAmount ) & 0x01 );
-		
-		setBit( m, inputBit );
-		i++;
-		}
-		
+	setRangeFrom( inRangeStart, inRangeEnd - inRangeStart + 1, 
+		inRangeContents );
 	}	
 	
 	
@@ -107,3 +82,143 @@ void BitMemory::clearMemoryRange( unsigned long inRangeStart,
 void BitMemory::clearMemory() {
 	clearMemoryRange( 0, mNumBits - 1 );
 	}
+	
+	
+	
+void BitMemory::copyRange( unsigned long inSrc, unsigned long inDest,
+	unsigned long inLength ) {
+	
+	ensureScratch( inLength );
+	
+	getRangeInto( inSrc, inLength, mScratchA );
+	setRangeFrom( inDest, inLength, mScratchA );
+	}
+	
+	
+	
+void BitMemory::xorRange( unsigned long inSrc1, unsigned long inSrc2,
+	unsigned long inDest, unsigned long inLength ) {
+	
+	ensureScratch( inLength );
+	
+	getRangeInto( inSrc1, inLength, mScratchA );
+	getRangeInto( inSrc2, inLength, mScratchB );
+	
+	unsigned long numBytes = ( inLength + 7 ) >> 3;
+	
+	for( unsigned long b=0; b<numBytes; b++ ) {
+		mScratchB[b] = mScratchB[b] ^ mScratchA[b];
+		}
+	
+	setRangeFrom( inDest, inLength, mScratchB );
+	}
+	
+	
+	
+void BitMemory::notRange( unsigned long inSrc, unsigned long inDest,
+	unsigned long inLength ) {
+	
+	ensureScratch( inLength );
+	
+	getRangeInto( inSrc, inLength, mScratchA );
+	
+	unsigned long numBytes = ( inLength + 7 ) >> 3;
+	
+	for( unsigned long b=0; b<numBytes; b++ ) {
+		mScratchA[b] = ~( mScratchA[b] );
+		}
+	
+	setRangeFrom( inDest, inLength, mScratchA );
+	}
+	
+	
+	
+void BitMemory::ensureScratch( unsigned long inLength ) {
+	unsigned long numBytes = ( inLength + 7 ) >> 3;
+	
+	if( numBytes > mScratchBytes ) {
+		if( mScratchA != NULL ) {
+			delete [] mScratchA;
+			delete [] mScratchB;
+			}
+		
+		// at least as big as memory, so this only happens once for
+		// instruction sets, whose lengths never exceed memory size
+		unsigned long memoryBytes = ( mNumBits + 7 ) >> 3;
+		if( numBytes < memoryBytes ) {
+			numBytes = memoryBytes;
+			}
+		
+		mScratchA = new unsigned char[ numBytes ];
+		mScratchB = new unsigned char[ numBytes ];
+		mScratchBytes = numBytes;
+		}
+	}
+	
+	
+	
+void BitMemory::getRangeInto( unsigned long inStart, unsigned long inLength,
+	unsigned char *outBuffer ) {
+	
+	unsigned char *out = outBuffer;
+	unsigned long i = 0;
+	
+	while( inLength - i >= 32 ) {
+		unsigned long word = getBits( inStart + i, 32 );
+		
+		out[0] = (unsigned char)( word >> 24 );
+		out[1] = (unsigned char)( word >> 16 );
+		out[2] = (unsigned char)( word >> 8 );
+		out[3] = (unsigned char)( word );
+		
+		out += 4;
+		i += 32;
+		}
+	
+	int restBits = (int)( inLength - i );
+	
+	if( restBits > 0 ) {
+		// move to top of 32 bits
+		unsigned long word = 
+			getBits( inStart + i, restBits ) << ( 32 - restBits );
+		
+		int numBytes = ( restBits + 7 ) >> 3;
+		
+		for( int b=0; b<numBytes; b++ ) {
+			out[b] = (unsigned char)( word >> ( 24 - 8 * b ) );
+			}
+		}
+	}
+	
+	
+	
+void BitMemory::setRangeFrom( unsigned long inStart, unsigned long inLength,
+	unsigned char *inBuffer ) {
+	
+	unsigned char *in = inBuffer;
+	unsigned long i = 0;
+	
+	while( inLength - i >= 32 ) {
+		unsigned long word = 
+			(unsigned long)in[0] << 24 | (unsigned long)in[1] << 16 |
+			(unsigned long)in[2] << 8 | (unsigned long)in[3];
+		
+		setBits( inStart + i, 32, word );
+		
+		in += 4;
+		i += 32;
+		}
+	
+	int restBits = (int)( inLength - i );
+	
+	if( restBits > 0 ) {
+		int numBytes = ( restBits + 7 ) >> 3;
+		
+		unsigned long word = 0;
+		for( int b=0; b<numBytes; b++ ) {
+			word = word | ( (unsigned long)in[b] << ( 24 - 8 * b ) );
+			}
+		
+		setBits( inStart + i, restBits, word >> ( 32 - restBits ) );
+		}
+	}
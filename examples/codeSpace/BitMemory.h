@@ -6,6 +6,10 @@
  *
  * 2001-November-30		Jason Rohrer
  * Added a missing include.
+ *
+ * 2026-October-15		Jason Rohrer
+ * Added word-level bit field access, and range operations built on it,
+ * in place of bit-by-bit loops.
  */
  
 #ifndef MEMORY_INCLUDED
@@ -13,6 +17,7 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <stdint.h>
 
 
 /**
@@ -109,11 +114,80 @@ class BitMemory {
 		void printMemory();
 		
 		
+		/**
+		 * Gets a bit field.  Memory wraps upward, as for getMemoryRange.
+		 *
+		 * @param inStart index of first bit of field.
+		 * @param inNumBits the number of bits in the field, at most 32.
+		 *
+		 * @return the field as a number, with the first bit as its
+		 *   most significant bit.
+		 */
+		unsigned long getBits( unsigned long inStart, int inNumBits );
+		
+		
+		/**
+		 * Sets a bit field.  Memory wraps upward, as for setMemoryRange.
+		 *
+		 * @param inStart index of first bit of field.
+		 * @param inNumBits the number of bits in the field, at most 32.
+		 * @param inValue the value, with the first bit of the field as its
+		 *   most significant bit.
+		 */
+		void setBits( unsigned long inStart, int inNumBits,
+			unsigned long inValue );
+		
+		
+		/**
+		 * Range operations.  Each reads all of its source ranges before
+		 * writing its destination range, so ranges can overlap.  Memory
+		 * wraps upward.
+		 *
+		 * @param inSrc, inSrc1, inSrc2 start of source ranges, in bits.
+		 * @param inDest start of destination range, in bits.
+		 * @param inLength length of ranges, in bits.
+		 */
+		void copyRange( unsigned long inSrc, unsigned long inDest,
+			unsigned long inLength );
+		
+		void xorRange( unsigned long inSrc1, unsigned long inSrc2,
+			unsigned long inDest, unsigned long inLength );
+		
+		void notRange( unsigned long inSrc, unsigned long inDest,
+			unsigned long inLength );
+		
+		
 	private:
-		// memory packed into a char array
+		// memory packed into a char array, with 8 extra bytes at end so
+		// that fields can be loaded 8 bytes at a time
 		unsigned char *mMemoryArray;
 		unsigned long mNumBits;
 		
+		// mNumBits - 1 if mNumBits is a power of 2, or 0 if not
+		unsigned long mWrapMask;
+		
+		// space for copies of ranges
+		unsigned char *mScratchA;
+		unsigned char *mScratchB;
+		unsigned long mScratchBytes;
+		
+		
+		unsigned long wrapIndex( unsigned long inIndex );
+		
+		// makes sure scratch buffers can hold inLength bits
+		void ensureScratch( unsigned long inLength );
+		
+		/**
+		 * Copies a range out of memory, or into memory, 32 bits at a time.
+		 * Buffers are packed as for getMemoryRange and must hold
+		 * inLength bits rounded up to a byte.
+		 */
+		void getRangeInto( unsigned long inStart, unsigned long inLength,
+			unsigned char *outBuffer );
+		
+		void setRangeFrom( unsigned long inStart, unsigned long inLength,
+			unsigned char *inBuffer );
+		
 		
 		/**
 		 * Gets a bit.  Note that no out-of-range test is performed, and
@@ -137,15 +211,112 @@ class BitMemory {
 
 
 inline BitMemory::BitMemory( unsigned long inNumBits )
-	: mNumBits( inNumBits ),
-	mMemoryArray( new unsigned char[ inNumBits >> 3 ] ) {	// divide by 8
+	: mMemoryArray( new unsigned char[ ( ( inNumBits + 7 ) >> 3 ) + 8 ] ),
+	mNumBits( inNumBits ),
+	mWrapMask( 0 ),
+	mScratchA( NULL ), mScratchB( NULL ), mScratchBytes( 0 ) {
+	
+	memset( mMemoryArray, 0, ( ( inNumBits + 7 ) >> 3 ) + 8 );
 	
+	if( ( inNumBits & ( inNumBits - 1 ) ) == 0 ) {
+		mWrapMask = inNumBits - 1;
+		}
 	}
 
 
 
 inline BitMemory::~BitMemory() {
 	delete [] mMemoryArray;
+	
+	if( mScratchA != NULL ) {
+		delete [] mScratchA;
+		delete [] mScratchB;
+		}
+	}
+
+
+
+inline unsigned long BitMemory::wrapIndex( unsigned long inIndex ) {
+	if( mWrapMask != 0 ) {
+		return inIndex & mWrapMask;
+		}
+	return inIndex % mNumBits;
+	}
+
+
+
+inline unsigned long BitMemory::getBits( unsigned long inStart, 
+	int inNumBits ) {
+	
+	if( inNumBits <= 0 ) {
+		return 0;
+		}
+	
+	inStart = wrapIndex( inStart );
+	
+	if( inStart + inNumBits > mNumBits ) {
+		// wraps, so get in two parts
+		int firstBits = (int)( mNumBits - inStart );
+		int secondBits = inNumBits - firstBits;
+		
+		return ( getBits( inStart, firstBits ) << secondBits ) |
+			getBits( 0, secondBits );
+		}
+	
+	// load 8 bytes in big endian order (array is padded at end)
+	unsigned char *bytes = &( mMemoryArray[ inStart >> 3 ] );
+	
+	uint64_t word = 
+		(uint64_t)bytes[0] << 56 | (uint64_t)bytes[1] << 48 |
+		(uint64_t)bytes[2] << 40 | (uint64_t)bytes[3] << 32 |
+		(uint64_t)bytes[4] << 24 | (uint64_t)bytes[5] << 16 |
+		(uint64_t)bytes[6] << 8 | (uint64_t)bytes[7];
+	
+	// at most 7 bits before field, so a 32-bit field always fits
+	int bitOffset = (int)( inStart & 7 );
+	
+	return (unsigned long)( ( word << bitOffset ) >> ( 64 - inNumBits ) );
+	}
+
+
+
+inline void BitMemory::setBits( unsigned long inStart, int inNumBits,
+	unsigned long inValue ) {
+	
+	if( inNumBits <= 0 ) {
+		return;
+		}
+	
+	inStart = wrapIndex( inStart );
+	
+	if( inStart + inNumBits > mNumBits ) {
+		int firstBits = (int)( mNumBits - inStart );
+		int secondBits = inNumBits - firstBits;
+		
+		setBits( inStart, firstBits, inValue >> secondBits );
+		setBits( 0, secondBits, inValue );
+		return;
+		}
+	
+	unsigned char *bytes = &( mMemoryArray[ inStart >> 3 ] );
+	
+	int bitOffset = (int)( inStart & 7 );
+	int shiftAmount = 64 - inNumBits - bitOffset;
+	
+	uint64_t mask = ( ~(uint64_t)0 >> ( 64 - inNumBits ) ) << shiftAmount;
+	uint64_t value = ( (uint64_t)inValue << shiftAmount ) & mask;
+	
+	// only touch the bytes that hold the field
+	int lastByte = ( bitOffset + inNumBits - 1 ) >> 3;
+	
+	for( int b=0; b<=lastByte; b++ ) {
+		int byteShift = 56 - 8 * b;
+		
+		unsigned char byteMask = (unsigned char)( mask >> byteShift );
+		
+		bytes[b] = (unsigned char)( ( bytes[b] & ~byteMask ) | 
+									( value >> byteShift ) );
+		}
 	}
 
 
@@ -6,6 +6,10 @@
  *
  * 2001-November-30		Jason Rohrer
  * Changed names of functions to avoid keyword collisions.
+ *
+ * 2026-October-15		Jason Rohrer
+ * Switched to BitMemory range operations, which work a word at a time and
+ * don't allocate.
  */
  
 #include "CommonInstructionSet.h" 
@@ -21,13 +25,7 @@ void CommonInstructionSet::copyi( BitMemory *inMemory, unsigned long inSrc,
 		return;
 		}
 	
-	unsigned long numChars;
-	unsigned char *srcValues = inMemory->getMemoryRange( inSrc, 
-		inSrc + inLength - 1, &numChars );
-	
-	inMemory->setMemoryRange( inDest, inDest + inLength - 1, srcValues );
-	delete [] srcValues;	
-	
+	inMemory->copyRange( inSrc, inDest, inLength );
 	}
 
 
@@ -43,21 +41,9 @@ void CommonInstructionSet::andi( BitMemory *inMemory, unsigned long inSrc1,
 		return;
 		}
 	
-	unsigned long numChars;
-	unsigned char *src1Values = inMemory->getMemoryRange( inSrc1, 
-		inSrc1 + inLength - 1, &numChars );
-	unsigned char *src2Values = inMemory->getMemoryRange( inSrc2, 
-		inSrc2 + inLength - 1, &numChars );
-	
-	// store result directly in src2Values
-	for( int i=0; i<numChars; i++ ) {
-		src2Values[i] = src2Values[i] ^ src1Values[i];
-		}
-	
-	inMemory->setMemoryRange( inDest, inDest + inLength - 1, src2Values );
-	delete [] src1Values;
-	delete [] src2Values;
-	
+	// this has always computed xor, and is kept that way so that programs
+	// run the same as before
+	inMemory->xorRange( inSrc1, inSrc2, inDest, inLength );
 	}
 
 
@@ -72,17 +58,5 @@ void CommonInstructionSet::noti( BitMemory *inMemory, unsigned long inSrc,
 		return;
 		}
 	
-	unsigned long numChars;
-	unsigned char *srcValues = inMemory->getMemoryRange( inSrc, 
-		inSrc + inLength - 1, &numChars );
-	unsigned char *destValues = new unsigned char[numChars];
-	
-	// store result directly in src2Values
-	for( int i=0; i<numChars; i++ ) {
-		destValues[i] = ~( srcValues[i] );
-		}
-	
-	inMemory->setMemoryRange( inDest, inDest + inLength - 1, destValues );
-	delete [] srcValues;
-	delete [] destValues;
+	inMemory->notRange( inSrc, inDest, inLength );
 	}
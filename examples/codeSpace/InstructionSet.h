@@ -3,6 +3,10 @@
  *
  * 2000-November-19		Jason Rohrer
  * Created.
+ *
+ * 2026-October-15		Jason Rohrer
+ * Added runProgram, for running many steps per call, and runPrograms, for
+ * running independent programs across a ThreadPool.
  */
  
 #ifndef INSTRUCTION_SET_INCLUDED
@@ -10,6 +14,8 @@
 
 #include "BitMemory.h"
 
+#include "minorGems/system/ThreadPool.h"
+
 #include <stdio.h>
 
 /**
@@ -54,6 +60,39 @@ class InstructionSet {
 			unsigned long inProgramCounter ) = 0;
 		
 		
+		/**
+		 * Runs several steps of the program.
+		 *
+		 * Default implementation calls stepProgram for each step.
+		 * Subclasses can override with a faster loop.
+		 *
+		 * @param inMemory memory object containing program.
+		 * @param inProgramCounter index (in bits) of first instruction.
+		 * @param inNumSteps the number of steps to run.
+		 *
+		 * @return program counter index (in bits) after last step.
+		 */
+		virtual unsigned long runProgram( BitMemory *inMemory, 
+			unsigned long inProgramCounter, unsigned long inNumSteps );
+		
+		
+		/**
+		 * Runs independent programs in parallel, each in its own memory,
+		 * spread across the threads of a pool.
+		 *
+		 * @param inMemories memory object for each program.
+		 *   Must be distinct.
+		 * @param inOutProgramCounters program counter for each program,
+		 *   replaced with program counter after last step.
+		 * @param inNumPrograms the number of programs.
+		 * @param inNumSteps the number of steps to run each program.
+		 * @param inPool the pool to run on.
+		 */
+		void runPrograms( BitMemory **inMemories, 
+			unsigned long *inOutProgramCounters, int inNumPrograms,
+			unsigned long inNumSteps, ThreadPool *inPool );
+		
+		
 	protected:
 		int mBitsInAddress;
 		
@@ -98,4 +137,54 @@ inline unsigned long InstructionSet::getMemorySize() {
 
 
 
+inline unsigned long InstructionSet::runProgram( BitMemory *inMemory, 
+	unsigned long inProgramCounter, unsigned long inNumSteps ) {
+	
+	for( unsigned long s=0; s<inNumSteps; s++ ) {
+		inProgramCounter = stepProgram( inMemory, inProgramCounter );
+		}
+	return inProgramCounter;
+	}
+
+
+
+typedef struct InstructionSetRunContext {
+	InstructionSet *set;
+	BitMemory **memories;
+	unsigned long *programCounters;
+	unsigned long numSteps;
+	} InstructionSetRunContext;
+
+
+
+inline void instructionSetRunRange( void *inContext, int inStart, 
+	int inEnd ) {
+	
+	InstructionSetRunContext *context = 
+		(InstructionSetRunContext *)inContext;
+	
+	for( int p=inStart; p<inEnd; p++ ) {
+		context->programCounters[p] = context->set->runProgram( 
+			context->memories[p], context->programCounters[p], 
+			context->numSteps );
+		}
+	}
+
+
+
+inline void InstructionSet::runPrograms( BitMemory **inMemories, 
+	unsigned long *inOutProgramCounters, int inNumPrograms,
+	unsigned long inNumSteps, ThreadPool *inPool ) {
+	
+	InstructionSetRunContext context;
+	context.set = this;
+	context.memories = inMemories;
+	context.programCounters = inOutProgramCounters;
+	context.numSteps = inNumSteps;
+	
+	inPool->parallelFor( instructionSetRunRange, &context, inNumPrograms );
+	}
+
+
+
 #endif
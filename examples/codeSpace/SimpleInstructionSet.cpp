@@ -6,173 +6,124 @@
  *
  * 2001-November-30		Jason Rohrer
  * Changed names of functions to avoid keyword collisions.
+ *
+ * 2026-October-15		Jason Rohrer
+ * Replaced per-step range fetches with a runProgram loop that reads
+ * instructions and operands as bit fields, and dispatches with computed
+ * goto on gcc and clang.
  */
  
 #include "SimpleInstructionSet.h" 
 
-// prototypes:
-unsigned long charArrayToLong( unsigned char *inArray, int inLength,
-	int numBits );
+
+// labels as values are a gcc extension, also supported by clang
+#if defined( __GNUC__ )
+#define USE_COMPUTED_GOTO
+#endif
 
 
 
 unsigned long SimpleInstructionSet::stepProgram( BitMemory *inMemory, 
 	unsigned long inProgramCounter ) {
 	
+	return runProgram( inMemory, inProgramCounter, 1 );
+	}
+
+
+
+unsigned long SimpleInstructionSet::runProgram( BitMemory *inMemory, 
+	unsigned long inProgramCounter, unsigned long inNumSteps ) {
 	
-	unsigned long numChars;
-	// fetch 2-bit instruction
-	unsigned char *instruction = 
-		inMemory->getMemoryRange( inProgramCounter, inProgramCounter + 1, 
-			&numChars );
+	// operands are addresses, and bit fields are at most 32 bits
+	int a = mBitsInAddress;
+	if( a > 32 ) {
+		a = 32;
+		}
 	
-	unsigned char instructionValue = instruction[0];
-	delete [] instruction;
+	unsigned long pc = inProgramCounter;
+	unsigned long stepsLeft = inNumSteps;
 	
-	inProgramCounter += 2;
+	unsigned long src1, src2, dest, length;
 	
-	instructionValue = instructionValue >> 6;
 	
-	unsigned char *address;
-	unsigned long jumpAddress;
+#ifdef USE_COMPUTED_GOTO
 	
-	unsigned char *src1;
-	unsigned char *src2;
-	unsigned char *dest;
-	unsigned char *length;
+	static void *instructionLabels[4] = 
+		{ &&jumpInstruction, &&copyInstruction, 
+		  &&andInstruction, &&notInstruction };
 	
-	switch( instructionValue ) {
+	// each instruction jumps straight to the next one's code, so
+	// each has its own (better predicted) indirect branch
+	#define NEXT_INSTRUCTION \
+		if( stepsLeft == 0 ) { \
+			return pc; \
+			} \
+		stepsLeft--; \
+		pc += 2; \
+		goto *instructionLabels[ inMemory->getBits( pc - 2, 2 ) ]
+	
+#else
+	
+	#define NEXT_INSTRUCTION goto fetch
+	
+	fetch:
+	if( stepsLeft == 0 ) {
+		return pc;
+		}
+	stepsLeft--;
+	pc += 2;
+	
+	switch( inMemory->getBits( pc - 2, 2 ) ) {
 		case 0:
-			// jump
-			// simply return new program counter
-			
-			address =  
-				inMemory->getMemoryRange( inProgramCounter, 
-					inProgramCounter + mBitsInAddress - 1, 
-					&numChars );
-			jumpAddress = charArrayToLong( address, numChars, mBitsInAddress );
-			delete [] address;
-			
-			//printf( "jumping to %d\n", jumpAddress );
-			return jumpAddress;
-			break;
+			goto jumpInstruction;
 		case 1:
-			// copy
-			src1 = inMemory->getMemoryRange( inProgramCounter, 
-				inProgramCounter + mBitsInAddress - 1, 
-				&numChars );
-			inProgramCounter += mBitsInAddress;
-			dest = inMemory->getMemoryRange( inProgramCounter, 
-				inProgramCounter + mBitsInAddress - 1, 
-				&numChars );
-			inProgramCounter += mBitsInAddress;
-			length = inMemory->getMemoryRange( inProgramCounter, 
-				inProgramCounter + mBitsInAddress - 1, 
-				&numChars );
-			inProgramCounter += mBitsInAddress;
-			
-			copyi( inMemory,
-				   charArrayToLong( src1, numChars, mBitsInAddress ), 
-				   charArrayToLong( dest, numChars, mBitsInAddress ), 
-				   charArrayToLong( length, numChars, mBitsInAddress ) );
-			
-			delete [] src1;
-			delete [] dest;
-			delete [] length;
-			
-			return inProgramCounter;
-			break;
+			goto copyInstruction;
 		case 2:
-			// and
-			src1 = inMemory->getMemoryRange( inProgramCounter, 
-				inProgramCounter + mBitsInAddress - 1, 
-				&numChars );
-			inProgramCounter += mBitsInAddress;	
-			src2 = inMemory->getMemoryRange( inProgramCounter, 
-				inProgramCounter + mBitsInAddress - 1, 
-				&numChars );	
-			inProgramCounter += mBitsInAddress;
-			dest = inMemory->getMemoryRange( inProgramCounter, 
-				inProgramCounter + mBitsInAddress - 1, 
-				&numChars );
-			inProgramCounter += mBitsInAddress;
-			length = inMemory->getMemoryRange( inProgramCounter, 
-				inProgramCounter + mBitsInAddress - 1, 
-				&numChars );
-			inProgramCounter += mBitsInAddress;
-			
-			andi( inMemory,
-				  charArrayToLong( src1, numChars, mBitsInAddress ), 
-				  charArrayToLong( src2, numChars, mBitsInAddress ),
-				  charArrayToLong( dest, numChars, mBitsInAddress ), 
-				  charArrayToLong( length, numChars, mBitsInAddress ) );
-			
-			delete [] src1;
-			delete [] src2;
-			delete [] dest;
-			delete [] length;
-			
-			return inProgramCounter;
-			break;
-		case 3:
-			// not
-			src1 = inMemory->getMemoryRange( inProgramCounter, 
-				inProgramCounter + mBitsInAddress - 1, 
-				&numChars );
-			inProgramCounter += mBitsInAddress;
-			dest = inMemory->getMemoryRange( inProgramCounter, 
-				inProgramCounter + mBitsInAddress - 1, 
-				&numChars );
-			inProgramCounter += mBitsInAddress;
-			length = inMemory->getMemoryRange( inProgramCounter, 
-				inProgramCounter + mBitsInAddress - 1, 
-				&numChars );
-			inProgramCounter += mBitsInAddress;
-			
-			noti( inMemory,
-				  charArrayToLong( src1, numChars, mBitsInAddress ), 
-				  charArrayToLong( dest, numChars, mBitsInAddress ), 
-				  charArrayToLong( length, numChars, mBitsInAddress ) );
-			
-			delete [] src1;
-			delete [] dest;
-			delete [] length;
-			
-			return inProgramCounter;
-			break;
+			goto andInstruction;
 		default:
-			break;	
-		}	
+			goto notInstruction;
+		}
+	
+#endif
 	
-	}
-
-unsigned long charArrayToLong( unsigned char *inArray, int inLength,
-	int inNumBits ) {
 	
-	unsigned long output = 0;
+	NEXT_INSTRUCTION;
 	
-	int outputShiftAmount = inNumBits - 1;
-	for( int i=0; i<inNumBits; i++ ) {
-		// get i'th bit
-		int block = i >> 3;		// index of block containing bit
-		int bit = i - ( block << 3 );	// index of bit in block
-		int shiftAmount = 7 - bit;
+	
+	jumpInstruction:
+		// simply set new program counter
+		pc = inMemory->getBits( pc, a );
 		
-		// shift and clear to extract bit from block
-		unsigned long bitValue = 
-			(inArray[block] >> shiftAmount ) & 0x01; 
+		//printf( "jumping to %d\n", pc );
+		NEXT_INSTRUCTION;
+	
+	copyInstruction:
+		src1 = inMemory->getBits( pc, a );
+		dest = inMemory->getBits( pc + a, a );
+		length = inMemory->getBits( pc + 2 * a, a );
+		pc += 3 * a;
 		
-		output = output | ( bitValue << outputShiftAmount ); 
-		outputShiftAmount--;
-		}
-	return output;
-	/*
-	unsigned long output = 0;
-	int shiftAmount = 0;
-	for( int i=inLength-1; i>=0; i-- ) {
-		output = output | ( (long)( inArray[i] ) << shiftAmount );
-		shiftAmount += 8;
-		}
-	return output;
-	*/
+		copyi( inMemory, src1, dest, length );
+		NEXT_INSTRUCTION;
+	
+	andInstruction:
+		src1 = inMemory->getBits( pc, a );
+		src2 = inMemory->getBits( pc + a, a );
+		dest = inMemory->getBits( pc + 2 * a, a );
+		length = inMemory->getBits( pc + 3 * a, a );
+		pc += 4 * a;
+		
+		andi( inMemory, src1, src2, dest, length );
+		NEXT_INSTRUCTION;
+	
+	notInstruction:
+		src1 = inMemory->getBits( pc, a );
+		dest = inMemory->getBits( pc + a, a );
+		length = inMemory->getBits( pc + 2 * a, a );
+		pc += 3 * a;
+		
+		noti( inMemory, src1, dest, length );
+		NEXT_INSTRUCTION;
+	
+	#undef NEXT_INSTRUCTION
 	}
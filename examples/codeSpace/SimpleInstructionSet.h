@@ -6,6 +6,9 @@
  *
  * 2001-November-29		Jason Rohrer
  * Fixed some typos.
+ *
+ * 2026-October-15		Jason Rohrer
+ * Added a runProgram loop with threaded dispatch.
  */
  
 #ifndef SIMPLE_INSTRUCTION_SET_INCLUDED
@@ -36,6 +39,12 @@ class SimpleInstructionSet : public InstructionSet,
 		// implements the InstructionSet interface
 		unsigned long stepProgram( BitMemory *inMemory, 
 			unsigned long inProgramCounter );
+		
+		// overrides InstructionSet::runProgram
+		// fetches operands as bit fields, and dispatches with computed
+		// goto where the compiler supports it
+		unsigned long runProgram( BitMemory *inMemory, 
+			unsigned long inProgramCounter, unsigned long inNumSteps );
 	
 	};
 
@@ -0,0 +1,311 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15		Jason Rohrer
+ * Created.
+ */
+
+/**
+ * Checks BitMemory bit fields and range operations against a simple
+ * bit-per-char model (including memory sizes that aren't a power of 2),
+ * checks SimpleInstructionSet::runProgram against a bit-by-bit model
+ * interpreter, checks that runPrograms on a ThreadPool matches running
+ * programs one at a time, and times each.
+ *
+ * Compile from above the minorGems directory with:
+ *   g++ -O2 -I. minorGems/examples/codeSpace/interpreterTest.cpp
+ *     minorGems/examples/codeSpace/BitMemory.cpp
+ *     minorGems/examples/codeSpace/CommonInstructionSet.cpp
+ *     minorGems/examples/codeSpace/SimpleInstructionSet.cpp
+ *     minorGems/system/ThreadPool.cpp minorGems/system/linux/[A-Z]*.cpp
+ *     minorGems/system/unix/TimeUnix.cpp -lpthread -o interpreterTest
+ */
+
+
+#include "SimpleInstructionSet.h"
+#include "BitMemory.h"
+
+#include "minorGems/system/Time.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+
+int numBad = 0;
+
+
+
+// one char per bit, for checking against
+class ModelMemory {
+	public:
+		ModelMemory( unsigned long inNumBits )
+			: mNumBits( inNumBits ), mBits( new char[ inNumBits ] ) {
+			}
+
+		~ModelMemory() {
+			delete [] mBits;
+			}
+
+		unsigned long get( unsigned long inStart, int inNumBits ) {
+			unsigned long value = 0;
+			for( int i=0; i<inNumBits; i++ ) {
+				value = ( value << 1 ) |
+					mBits[ ( inStart + i ) % mNumBits ];
+				}
+			return value;
+			}
+
+		void set( unsigned long inStart, int inNumBits,
+			unsigned long inValue ) {
+			for( int i=0; i<inNumBits; i++ ) {
+				mBits[ ( inStart + i ) % mNumBits ] =
+					( inValue >> ( inNumBits - 1 - i ) ) & 0x01;
+				}
+			}
+
+		// op 0 is copy, 1 is xor, 2 is not
+		void rangeOp( int inOp, unsigned long inSrc1, unsigned long inSrc2,
+			unsigned long inDest, unsigned long inLength ) {
+			char *a = new char[ inLength ];
+			char *b = new char[ inLength ];
+
+			for( unsigned long i=0; i<inLength; i++ ) {
+				a[i] = mBits[ ( inSrc1 + i ) % mNumBits ];
+				b[i] = mBits[ ( inSrc2 + i ) % mNumBits ];
+				}
+			for( unsigned long i=0; i<inLength; i++ ) {
+				char value = a[i];
+				if( inOp == 1 ) {
+					value = a[i] ^ b[i];
+					}
+				else if( inOp == 2 ) {
+					value = ! a[i];
+					}
+				mBits[ ( inDest + i ) % mNumBits ] = value;
+				}
+
+			delete [] a;
+			delete [] b;
+			}
+
+		// same instructions as SimpleInstructionSet
+		unsigned long step( unsigned long inPC, int inAddressBits ) {
+			int a = inAddressBits;
+			int op = (int)get( inPC, 2 );
+			inPC += 2;
+
+			if( op == 0 ) {
+				return get( inPC, a );
+				}
+
+			int numOperands = ( op == 2 ) ? 4 : 3;
+			unsigned long operands[4];
+			for( int o=0; o<numOperands; o++ ) {
+				operands[o] = get( inPC, a );
+				inPC += a;
+				}
+
+			if( op == 1 ) {
+				rangeOp( 0, operands[0], 0, operands[1], operands[2] );
+				}
+			else if( op == 2 ) {
+				rangeOp( 1, operands[0], operands[1],
+					operands[2], operands[3] );
+				}
+			else {
+				rangeOp( 2, operands[0], 0, operands[1], operands[2] );
+				}
+			return inPC;
+			}
+
+		unsigned long mNumBits;
+		char *mBits;
+	};
+
+
+
+void checkSame( BitMemory *inMemory, ModelMemory *inModel,
+	const char *inWhat ) {
+
+	for( unsigned long i=0; i<inModel->mNumBits; i++ ) {
+		if( inMemory->getBits( i, 1 ) != (unsigned long)inModel->mBits[i] ) {
+			printf( "%s: bit %lu differs\n", inWhat, i );
+			numBad++;
+			return;
+			}
+		}
+	}
+
+
+
+void fillRandom( BitMemory *inMemory, ModelMemory *inModel ) {
+	for( unsigned long i=0; i<inModel->mNumBits; i++ ) {
+		char bit = rand() & 0x01;
+		inModel->mBits[i] = bit;
+		inMemory->setBits( i, 1, bit );
+		}
+	}
+
+
+
+int main() {
+
+	srand( 1 );
+
+	// bit fields and range operations, with sizes that aren't powers
+	// of 2 or multiples of 8 too
+	unsigned long sizes[4] = { 61, 64, 1000, 4096 };
+
+	for( int z=0; z<4; z++ ) {
+		unsigned long size = sizes[z];
+
+		BitMemory memory( size );
+		ModelMemory model( size );
+
+		fillRandom( &memory, &model );
+
+		for( int t=0; t<20000; t++ ) {
+			unsigned long start = rand() % ( 3 * size );
+			int numBits = 1 + rand() % 32;
+
+			if( memory.getBits( start, numBits ) !=
+				model.get( start, numBits ) ) {
+				printf( "getBits( %lu, %d ) differs, size %lu\n",
+						start, numBits, size );
+				numBad++;
+				break;
+				}
+
+			unsigned long value = ( (unsigned long)rand() << 16 ) ^ rand();
+			memory.setBits( start, numBits, value );
+			model.set( start, numBits, value );
+
+			if( t % 10 == 0 ) {
+				int op = rand() % 3;
+				unsigned long src1 = rand() % size;
+				unsigned long src2 = rand() % size;
+				unsigned long dest = rand() % size;
+				unsigned long length = rand() % size;
+
+				model.rangeOp( op, src1, src2, dest, length );
+
+				if( op == 0 ) {
+					memory.copyRange( src1, dest, length );
+					}
+				else if( op == 1 ) {
+					memory.xorRange( src1, src2, dest, length );
+					}
+				else {
+					memory.notRange( src1, dest, length );
+					}
+				}
+			}
+		checkSame( &memory, &model, "Range operations" );
+		}
+
+
+	// interpreter against model, and timing
+	SimpleInstructionSet set;
+	unsigned long memorySize = set.setMemorySize( 1 << 16 );
+	int addressBits = 16;
+
+	BitMemory memory( memorySize );
+	ModelMemory model( memorySize );
+
+	int numSteps = 20000;
+
+	fillRandom( &memory, &model );
+
+	double startTime = Time::getMonotonicTime();
+
+	unsigned long modelPC = 0;
+	for( int s=0; s<numSteps; s++ ) {
+		modelPC = model.step( modelPC, addressBits );
+		}
+	double modelTime = Time::getMonotonicTime() - startTime;
+
+	startTime = Time::getMonotonicTime();
+	unsigned long pc = set.runProgram( &memory, 0, numSteps );
+	double runTime = Time::getMonotonicTime() - startTime;
+
+	if( pc % memorySize != modelPC % memorySize ) {
+		printf( "Program counter %lu, expected %lu\n",
+				pc % memorySize, modelPC % memorySize );
+		numBad++;
+		}
+	checkSame( &memory, &model, "Program" );
+
+	printf( "%d steps:  %.3f s bit by bit, %.3f s with runProgram\n",
+			numSteps, modelTime, runTime );
+
+
+	// parallel programs
+	int numPrograms = 16;
+	int numParallelSteps = 5000;
+
+	BitMemory **memories = new BitMemory*[ numPrograms ];
+	BitMemory **checkMemories = new BitMemory*[ numPrograms ];
+	unsigned long *pcs = new unsigned long[ numPrograms ];
+
+	for( int p=0; p<numPrograms; p++ ) {
+		memories[p] = new BitMemory( memorySize );
+		checkMemories[p] = new BitMemory( memorySize );
+
+		for( unsigned long i=0; i<memorySize; i+=16 ) {
+			unsigned long value = rand() & 0xFFFF;
+			memories[p]->setBits( i, 16, value );
+			checkMemories[p]->setBits( i, 16, value );
+			}
+		pcs[p] = 0;
+		}
+
+	startTime = Time::getMonotonicTime();
+
+	unsigned long *checkPCs = new unsigned long[ numPrograms ];
+	for( int p=0; p<numPrograms; p++ ) {
+		checkPCs[p] = set.runProgram( checkMemories[p], 0,
+									  numParallelSteps );
+		}
+	double oneTime = Time::getMonotonicTime() - startTime;
+
+	ThreadPool pool;
+
+	startTime = Time::getMonotonicTime();
+	set.runPrograms( memories, pcs, numPrograms, numParallelSteps, &pool );
+	double poolTime = Time::getMonotonicTime() - startTime;
+
+	for( int p=0; p<numPrograms; p++ ) {
+		unsigned long numBytes;
+		unsigned char *bytes = memories[p]->getAllMemory( &numBytes );
+		unsigned char *checkBytes = 
+			checkMemories[p]->getAllMemory( &numBytes );
+
+		if( pcs[p] != checkPCs[p] ||
+			memcmp( bytes, checkBytes, numBytes ) != 0 ) {
+			printf( "Parallel program %d differs\n", p );
+			numBad++;
+			}
+		delete [] bytes;
+		delete [] checkBytes;
+
+		delete memories[p];
+		delete checkMemories[p];
+		}
+	delete [] memories;
+	delete [] checkMemories;
+	delete [] pcs;
+	delete [] checkPCs;
+
+	printf( "%d programs:  %.3f s one at a time, %.3f s on %d threads\n",
+			numPrograms, oneTime, poolTime, pool.getNumThreads() );
+
+
+	if( numBad == 0 ) {
+		printf( "All tests passed\n" );
+		return 0;
+		}
+	printf( "%d failures\n", numBad );
+	return 1;
+	}
@@ -3,12 +3,18 @@
  *
  * 2000-November-30		Jason Rohrer
  * Created.
+ *
+ * 2026-October-15		Jason Rohrer
+ * Steps with ColorAutomaton, several generations per display.
  */
 
 
+#include "ColorAutomaton.h"
+
 #include "minorGems/graphics/ScreenGraphics.h"
 #include "minorGems/graphics/GraphicBuffer.h"
 #include "minorGems/system/Thread.h"
+#include "minorGems/system/Time.h"
 
 #include "minorGems/util/random/StdRandomSource.h"
 
@@ -36,6 +42,9 @@ int height = 50;
 
 int pixelSize = 10;
 
+// generations to advance between displays
+int generationsPerDisplay = 1;
+
 int screenWidth = pixelSize * width;
 int screenHeight = pixelSize * height;
 
@@ -209,103 +218,28 @@ int main() {
 		}
 	
 
+	// steps whole rows at once, on all cores, when it can
+	ColorAutomaton *automaton = NULL;
+
+	if( ColorAutomaton::isIntegerMatrix( matrix, matrixRadius ) ) {
+		automaton = new ColorAutomaton( width, height, matrixRadius,
+										matrix );
+		automaton->setGrid( grid );
+		}
+
 	while( running ) {
-		int x,y;
 		
-		unsigned long *newGrid = new unsigned long[ numGridSpaces ];
-		memcpy( newGrid, grid, sizeof( unsigned long ) * numGridSpaces );
-
-		for( x=0; x<width; x++ ) {
-			for( y=0; y<height; y++ ) {
-
-				int p = y * width + x;
-				
-
-				double newGridRed = 0;
-				double newGridGreen = 0;
-				double newGridBlue = 0;
-				
-				// sum of matrix times corresponding grid spaces
-				for( i=0; i<matrixSize; i++ ) {
-					for( j=0; j<matrixSize; j++ ) {
-
-						int gridX = x + i - matrixRadius;
-						int gridY = y + j - matrixRadius;
-
-						gridX = gridX % width;
-						gridY = gridY % height;
-
-						// handle negative wrap around
-						if( gridX < 0 ) {
-							gridX = width + gridX;
-							}
-						if( gridY < 0 ) {
-							gridY = height + gridY;
-							}
-						
-						unsigned long gridVal =
-							grid[ gridY * width + gridX ];
-						unsigned long gridRed =
-							gridVal >> 16 & 0xFF;
-						unsigned long gridGreen =
-							gridVal >> 8 & 0xFF;
-						unsigned long gridBlue =
-							gridVal & 0xFF;
-
-						double matrixVal = matrix[i][j];
-						
-						newGridRed += gridRed * matrixVal;
-						newGridGreen += gridGreen * matrixVal;
-						newGridBlue += gridBlue * matrixVal;				
-						}
-					}
-				// threshold colors at 0 and 255
-				/*
-				if( newGridRed < 0 ) {
-					newGridRed = 0;
-					}
-				if( newGridRed > 255 ) {
-					newGridRed = 255;
-					}
-				if( newGridGreen < 0 ) {
-					newGridGreen = 0;
-					}
-				if( newGridGreen > 255 ) {
-					newGridGreen = 255;
-					}
-				if( newGridBlue < 0 ) {
-					newGridBlue = 0;
-					}
-				if( newGridBlue > 255 ) {
-					newGridBlue = 255;
-					}
-				*/
-				int newRedInt = ( (int)newGridRed ) % 256;
-				int newGreenInt = ( (int)newGridGreen ) % 256;
-				int newBlueInt = ( (int)newGridBlue ) % 256;
-
-				if( newRedInt < 0 ) {
-					newRedInt += 256;
-					}
-				if( newGreenInt < 0 ) {
-					newGreenInt += 256;
-					}
-				if( newBlueInt < 0 ) {
-					newBlueInt += 256;
-					}
-				
-				newGrid[ p ] =
-					newRedInt << 16 |
-					newGreenInt << 8 |
-					newBlueInt;
-				
+		if( automaton != NULL ) {
+			automaton->step( generationsPerDisplay );
+			automaton->getGrid( grid );
+			}
+		else {
+			for( i=0; i<generationsPerDisplay; i++ ) {
+				ColorAutomaton::stepReference( grid, width, height,
+											   matrixRadius, matrix );
 				}
 			}
 
-		memcpy( grid, newGrid, sizeof( unsigned long ) * numGridSpaces );
-
-		delete [] newGrid;
-
 		setPixelsFromGrid();
 		
 		screen->swapBuffers( screenBuffer );
@@ -314,6 +248,10 @@ int main() {
 		}
 
 
+	if( automaton != NULL ) {
+		delete automaton;
+		}
+
 	delete screenBuffer;
 	delete screen;
 
@@ -0,0 +1,465 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15		Jason Rohrer
+ * Created.
+ */
+
+
+#ifndef COLOR_AUTOMATON_INCLUDED
+#define COLOR_AUTOMATON_INCLUDED
+
+
+#include "minorGems/system/ThreadPool.h"
+
+#include <string.h>
+#include <math.h>
+
+
+
+/**
+ * Color cellular automaton on a wrapping grid.  Each generation, every
+ * color channel of a cell becomes the sum of its neighborhood's values
+ * in that channel times a matrix, mod 256.
+ *
+ * Channels are kept in separate byte planes, and since values are mod
+ * 256, they are summed in byte arithmetic, which the compiler spreads
+ * across vector lanes.  Rows are stepped in bands across a ThreadPool.
+ *
+ * Each plane row has copies of the cells from the other side of the
+ * grid (a halo) at both ends, so inner loops never check for wrapping.
+ * Bands only read the last generation and write their own rows and
+ * halos, so neighboring bands need no locking, just one parallelFor
+ * per generation.
+ *
+ * Matrices must have integer entries, as with the zero-sum magic square
+ * in AutomataTest.  See stepReference for other matrices.
+ *
+ * @author Jason Rohrer
+ */
+class ColorAutomaton {
+
+	public:
+
+		/**
+		 * Constructs an automaton with all cells black.
+		 *
+		 * @param inWidth, inHeight the grid size.
+		 * @param inRadius the neighborhood radius, at most half the
+		 *   smaller grid dimension.
+		 * @param inMatrix ( 2 * inRadius + 1 ) square matrix, indexed as
+		 *   [x offset + inRadius][y offset + inRadius].  Entries are
+		 *   rounded to integers.
+		 *   Must be destroyed by caller.
+		 * @param inPool the pool to step bands on, or NULL to use
+		 *   ThreadPool::getSharedPool.  Defaults to NULL.
+		 *   Must be destroyed by caller after this class is destroyed.
+		 */
+		ColorAutomaton( int inWidth, int inHeight, int inRadius,
+						double **inMatrix, ThreadPool *inPool = NULL );
+
+		~ColorAutomaton();
+
+
+		int getWidth();
+		int getHeight();
+
+
+		// cells are 0x00RRGGBB
+		void setCell( int inX, int inY, unsigned long inColor );
+		unsigned long getCell( int inX, int inY );
+
+		// inGrid and outGrid are width * height cells, row by row
+		void setGrid( unsigned long *inGrid );
+		void getGrid( unsigned long *outGrid );
+
+
+		/**
+		 * Advances the automaton.
+		 *
+		 * @param inNumGenerations the number of generations to advance.
+		 *   Defaults to 1.
+		 */
+		void step( int inNumGenerations = 1 );
+
+
+		/**
+		 * Steps a grid one generation cell by cell, the way AutomataTest
+		 * always has, with a double matrix of any values.
+		 *
+		 * @param inGrid the grid, replaced by the next generation.
+		 *   Must be destroyed by caller.
+		 * @param inWidth, inHeight the grid size.
+		 * @param inRadius the neighborhood radius.
+		 * @param inMatrix the matrix, as in the constructor.
+		 *   Must be destroyed by caller.
+		 */
+		static void stepReference( unsigned long *inGrid,
+								   int inWidth, int inHeight, int inRadius,
+								   double **inMatrix );
+
+
+		/**
+		 * Checks whether a matrix can be used by this class.
+		 *
+		 * @return true if all entries are integers.
+		 */
+		static char isIntegerMatrix( double **inMatrix, int inRadius );
+
+
+	private:
+		int mWidth;
+		int mHeight;
+		int mRadius;
+		int mMatrixSize;
+
+		// row length including halos
+		int mStride;
+
+		// matrix entries mod 256, [y offset][x offset]
+		unsigned char *mMatrix;
+
+		// current and next generation, each with 3 planes of
+		// mHeight rows of mStride bytes
+		unsigned char *mCells;
+		unsigned char *mNextCells;
+
+		ThreadPool *mPool;
+
+
+		unsigned char *getRow( unsigned char *inCells, int inChannel,
+							   int inY );
+
+		// copies cells from the far ends of a row into its halos
+		void fillHalo( unsigned char *inRow );
+
+
+		typedef struct StepJob {
+				ColorAutomaton *automaton;
+			} StepJob;
+
+		// ThreadPoolRangeFunction over rows
+		static void stepRows( void *inJob, int inStart, int inEnd );
+	};
+
+
+
+// rows per band, to keep band hand-off overhead small next to row work
+#define COLOR_AUTOMATON_MIN_BAND_ROWS 16
+
+
+
+inline ColorAutomaton::ColorAutomaton( int inWidth, int inHeight,
+	int inRadius, double **inMatrix, ThreadPool *inPool )
+	: mWidth( inWidth ), mHeight( inHeight ), mRadius( inRadius ),
+	  mMatrixSize( 2 * inRadius + 1 ),
+	  mStride( inWidth + 2 * inRadius ),
+	  mPool( inPool ) {
+
+	if( mPool == NULL ) {
+		mPool = ThreadPool::getSharedPool();
+		}
+
+	mMatrix = new unsigned char[ mMatrixSize * mMatrixSize ];
+
+	for( int i=0; i<mMatrixSize; i++ ) {
+		for( int j=0; j<mMatrixSize; j++ ) {
+			long value = lrint( inMatrix[i][j] );
+
+			// two's complement wraps negative entries to their
+			// value mod 256
+			mMatrix[ j * mMatrixSize + i ] = (unsigned char)value;
+			}
+		}
+
+	int numBytes = 3 * mHeight * mStride;
+
+	mCells = new unsigned char[ numBytes ];
+	mNextCells = new unsigned char[ numBytes ];
+
+	memset( mCells, 0, numBytes );
+	memset( mNextCells, 0, numBytes );
+	}
+
+
+
+inline ColorAutomaton::~ColorAutomaton() {
+	delete [] mMatrix;
+	delete [] mCells;
+	delete [] mNextCells;
+	}
+
+
+
+inline int ColorAutomaton::getWidth() {
+	return mWidth;
+	}
+
+
+
+inline int ColorAutomaton::getHeight() {
+	return mHeight;
+	}
+
+
+
+inline unsigned char *ColorAutomaton::getRow( unsigned char *inCells,
+	int inChannel, int inY ) {
+
+	return &( inCells[ ( inChannel * mHeight + inY ) * mStride ] );
+	}
+
+
+
+inline void ColorAutomaton::fillHalo( unsigned char *inRow ) {
+	unsigned char *cells = &( inRow[ mRadius ] );
+
+	for( int k=0; k<mRadius; k++ ) {
+		// left halo holds the last cells, right halo the first
+		inRow[k] = cells[ mWidth - mRadius + k ];
+		cells[ mWidth + k ] = cells[k];
+		}
+	}
+
+
+
+inline void ColorAutomaton::setCell( int inX, int inY,
+	unsigned long inColor ) {
+
+	for( int c=0; c<3; c++ ) {
+		unsigned char *row = getRow( mCells, c, inY );
+
+		row[ mRadius + inX ] =
+			(unsigned char)( inColor >> ( 8 * ( 2 - c ) ) & 0xFF );
+
+		fillHalo( row );
+		}
+	}
+
+
+
+inline unsigned long ColorAutomaton::getCell( int inX, int inY ) {
+	unsigned long color = 0;
+
+	for( int c=0; c<3; c++ ) {
+		color = color << 8 | getRow( mCells, c, inY )[ mRadius + inX ];
+		}
+	return color;
+	}
+
+
+
+inline void ColorAutomaton::setGrid( unsigned long *inGrid ) {
+	for( int c=0; c<3; c++ ) {
+		int shift = 8 * ( 2 - c );
+
+		for( int y=0; y<mHeight; y++ ) {
+			unsigned char *row = getRow( mCells, c, y );
+			unsigned long *gridRow = &( inGrid[ y * mWidth ] );
+
+			for( int x=0; x<mWidth; x++ ) {
+				row[ mRadius + x ] =
+					(unsigned char)( gridRow[x] >> shift & 0xFF );
+				}
+			fillHalo( row );
+			}
+		}
+	}
+
+
+
+inline void ColorAutomaton::getGrid( unsigned long *outGrid ) {
+	for( int y=0; y<mHeight; y++ ) {
+		unsigned char *red = &( getRow( mCells, 0, y )[ mRadius ] );
+		unsigned char *green = &( getRow( mCells, 1, y )[ mRadius ] );
+		unsigned char *blue = &( getRow( mCells, 2, y )[ mRadius ] );
+
+		unsigned long *gridRow = &( outGrid[ y * mWidth ] );
+
+		for( int x=0; x<mWidth; x++ ) {
+			gridRow[x] =
+				(unsigned long)red[x] << 16 |
+				(unsigned long)green[x] << 8 |
+				(unsigned long)blue[x];
+			}
+		}
+	}
+
+
+
+inline void ColorAutomaton::stepRows( void *inJob, int inStart,
+	int inEnd ) {
+
+	ColorAutomaton *a = ( (StepJob *)inJob )->automaton;
+
+	int w = a->mWidth;
+	int size = a->mMatrixSize;
+
+	for( int c=0; c<3; c++ ) {
+		for( int y=inStart; y<inEnd; y++ ) {
+			unsigned char *outRow = a->getRow( a->mNextCells, c, y );
+			unsigned char *out = &( outRow[ a->mRadius ] );
+
+			memset( out, 0, w );
+
+			for( int j=0; j<size; j++ ) {
+				int sourceY = y + j - a->mRadius;
+
+				if( sourceY < 0 ) {
+					sourceY += a->mHeight;
+					}
+				else if( sourceY >= a->mHeight ) {
+					sourceY -= a->mHeight;
+					}
+
+				// starts at the left halo, so source[ x + i ] is the
+				// cell at x offset i - radius
+				unsigned char *source = a->getRow( a->mCells, c, sourceY );
+
+				unsigned char *matrixRow = &( a->mMatrix[ j * size ] );
+
+				for( int i=0; i<size; i++ ) {
+					unsigned char m = matrixRow[i];
+
+					if( m == 0 ) {
+						continue;
+						}
+
+					unsigned char *shifted = &( source[i] );
+
+					// wraps mod 256, like the cell values
+					for( int x=0; x<w; x++ ) {
+						out[x] = (unsigned char)( out[x] + m * shifted[x] );
+						}
+					}
+				}
+
+			a->fillHalo( outRow );
+			}
+		}
+	}
+
+
+
+inline void ColorAutomaton::step( int inNumGenerations ) {
+	StepJob job;
+	job.automaton = this;
+
+	for( int g=0; g<inNumGenerations; g++ ) {
+		// returns once all bands are done, so the next generation
+		// sees complete rows and halos
+		mPool->parallelFor( stepRows, &job, mHeight,
+							COLOR_AUTOMATON_MIN_BAND_ROWS );
+
+		unsigned char *temp = mCells;
+		mCells = mNextCells;
+		mNextCells = temp;
+		}
+	}
+
+
+
+inline char ColorAutomaton::isIntegerMatrix( double **inMatrix,
+	int inRadius ) {
+
+	int size = 2 * inRadius + 1;
+
+	for( int i=0; i<size; i++ ) {
+		for( int j=0; j<size; j++ ) {
+			if( inMatrix[i][j] != floor( inMatrix[i][j] ) ) {
+				return false;
+				}
+			}
+		}
+	return true;
+	}
+
+
+
+inline void ColorAutomaton::stepReference( unsigned long *inGrid,
+	int inWidth, int inHeight, int inRadius, double **inMatrix ) {
+
+	int width = inWidth;
+	int height = inHeight;
+	int matrixRadius = inRadius;
+	int matrixSize = 2 * inRadius + 1;
+
+	int numGridSpaces = width * height;
+
+	unsigned long *grid = inGrid;
+
+	unsigned long *newGrid = new unsigned long[ numGridSpaces ];
+
+	for( int x=0; x<width; x++ ) {
+		for( int y=0; y<height; y++ ) {
+
+			int p = y * width + x;
+
+			double newGridRed = 0;
+			double newGridGreen = 0;
+			double newGridBlue = 0;
+
+			// sum of matrix times corresponding grid spaces
+			for( int i=0; i<matrixSize; i++ ) {
+				for( int j=0; j<matrixSize; j++ ) {
+
+					int gridX = x + i - matrixRadius;
+					int gridY = y + j - matrixRadius;
+
+					gridX = gridX % width;
+					gridY = gridY % height;
+
+					// handle negative wrap around
+					if( gridX < 0 ) {
+						gridX = width + gridX;
+						}
+					if( gridY < 0 ) {
+						gridY = height + gridY;
+						}
+
+					unsigned long gridVal =
+						grid[ gridY * width + gridX ];
+					unsigned long gridRed =
+						gridVal >> 16 & 0xFF;
+					unsigned long gridGreen =
+						gridVal >> 8 & 0xFF;
+					unsigned long gridBlue =
+						gridVal & 0xFF;
+
+					double matrixVal = inMatrix[i][j];
+
+					newGridRed += gridRed * matrixVal;
+					newGridGreen += gridGreen * matrixVal;
+					newGridBlue += gridBlue * matrixVal;
+					}
+				}
+
+			int newRedInt = ( (int)newGridRed ) % 256;
+			int newGreenInt = ( (int)newGridGreen ) % 256;
+			int newBlueInt = ( (int)newGridBlue ) % 256;
+
+			if( newRedInt < 0 ) {
+				newRedInt += 256;
+				}
+			if( newGreenInt < 0 ) {
+				newGreenInt += 256;
+				}
+			if( newBlueInt < 0 ) {
+				newBlueInt += 256;
+				}
+
+			newGrid[ p ] =
+				newRedInt << 16 |
+				newGreenInt << 8 |
+				newBlueInt;
+			}
+		}
+
+	memcpy( grid, newGrid, sizeof( unsigned long ) * numGridSpaces );
+
+	delete [] newGrid;
+	}
+
+
+
+#endif
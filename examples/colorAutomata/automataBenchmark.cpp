@@ -0,0 +1,205 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15		Jason Rohrer
+ * Created.
+ */
+
+/**
+ * Checks that ColorAutomaton matches the cell-by-cell stepping in
+ * AutomataTest, and measures generations per second on a large grid.
+ *
+ * Usage:  automataBenchmark [grid_size [generations]]
+ * Defaults to a 4096 x 4096 grid and 20 generations.
+ *
+ * Compile from above the minorGems directory with:
+ *   g++ -O3 -I. minorGems/examples/colorAutomata/automataBenchmark.cpp
+ *     minorGems/system/ThreadPool.cpp minorGems/system/linux/[A-Z]*.cpp
+ *     minorGems/system/unix/TimeUnix.cpp -lpthread -o automataBenchmark
+ */
+
+#include "ColorAutomaton.h"
+
+#include "minorGems/system/ThreadPool.h"
+#include "minorGems/system/Time.h"
+#include "minorGems/util/random/StdRandomSource.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+
+
+static int numBad = 0;
+
+
+
+static double **makeMatrix( int inRadius ) {
+	int size = 2 * inRadius + 1;
+
+	double **matrix = new double*[ size ];
+	for( int i=0; i<size; i++ ) {
+		matrix[i] = new double[ size ];
+		}
+	return matrix;
+	}
+
+
+
+static void deleteMatrix( double **inMatrix, int inRadius ) {
+	for( int i=0; i<2 * inRadius + 1; i++ ) {
+		delete [] inMatrix[i];
+		}
+	delete [] inMatrix;
+	}
+
+
+
+static void randomGrid( unsigned long *outGrid, int inNumCells,
+						StdRandomSource *inRandSource ) {
+	for( int i=0; i<inNumCells; i++ ) {
+		outGrid[i] = (unsigned long)inRandSource->getRandomInt() & 0xFFFFFF;
+		}
+	}
+
+
+
+static void checkAgainstReference( int inWidth, int inHeight, int inRadius,
+								   double **inMatrix, ThreadPool *inPool,
+								   int inNumGenerations,
+								   StdRandomSource *inRandSource ) {
+	int numCells = inWidth * inHeight;
+
+	unsigned long *grid = new unsigned long[ numCells ];
+	unsigned long *result = new unsigned long[ numCells ];
+
+	randomGrid( grid, numCells, inRandSource );
+
+	ColorAutomaton automaton( inWidth, inHeight, inRadius, inMatrix,
+							  inPool );
+	automaton.setGrid( grid );
+
+	for( int g=0; g<inNumGenerations; g++ ) {
+		ColorAutomaton::stepReference( grid, inWidth, inHeight, inRadius,
+									   inMatrix );
+		}
+	automaton.step( inNumGenerations );
+	automaton.getGrid( result );
+
+	for( int i=0; i<numCells; i++ ) {
+		if( grid[i] != result[i] ) {
+			printf( "%dx%d radius %d: cell %d is %06lX after %d "
+					"generations, expected %06lX\n",
+					inWidth, inHeight, inRadius, i, result[i],
+					inNumGenerations, grid[i] );
+			numBad++;
+			break;
+			}
+		}
+
+	delete [] grid;
+	delete [] result;
+	}
+
+
+
+int main( int inNumArgs, char **inArgs ) {
+	int gridSize = 4096;
+	int numGenerations = 20;
+
+	if( inNumArgs > 1 ) {
+		gridSize = atoi( inArgs[1] );
+		}
+	if( inNumArgs > 2 ) {
+		numGenerations = atoi( inArgs[2] );
+		}
+
+	StdRandomSource randSource( 5 );
+
+	ThreadPool singlePool( 1 );
+	ThreadPool *sharedPool = ThreadPool::getSharedPool();
+
+
+	// zero-sum magic square from AutomataTest
+	double **magic = makeMatrix( 1 );
+	magic[0][0] = -1;
+	magic[0][1] = -2;
+	magic[0][2] = 3;
+	magic[1][0] = 4;
+	magic[1][1] = 0;
+	magic[1][2] = -4;
+	magic[2][0] = -3;
+	magic[2][1] = 2;
+	magic[2][2] = 1;
+
+	// random integers, radius 2, with entries beyond a byte
+	double **wide = makeMatrix( 2 );
+	for( int i=0; i<5; i++ ) {
+		for( int j=0; j<5; j++ ) {
+			wide[i][j] = randSource.getRandomBoundedInt( -300, 300 );
+			}
+		}
+
+	checkAgainstReference( 50, 50, 1, magic, &singlePool, 30, &randSource );
+	checkAgainstReference( 97, 61, 1, magic, sharedPool, 30, &randSource );
+	checkAgainstReference( 5, 3, 1, magic, sharedPool, 10, &randSource );
+	checkAgainstReference( 83, 40, 2, wide, sharedPool, 12, &randSource );
+	checkAgainstReference( 4, 4, 2, wide, &singlePool, 12, &randSource );
+
+	double **fraction = makeMatrix( 1 );
+	fraction[0][0] = 0.5;
+	if( ColorAutomaton::isIntegerMatrix( magic, 1 ) != true ||
+		ColorAutomaton::isIntegerMatrix( fraction, 1 ) != false ) {
+		printf( "isIntegerMatrix wrong\n" );
+		numBad++;
+		}
+	deleteMatrix( fraction, 1 );
+
+
+	// timing on a big grid
+	int numCells = gridSize * gridSize;
+	unsigned long *grid = new unsigned long[ numCells ];
+	randomGrid( grid, numCells, &randSource );
+
+	double startTime = Time::getMonotonicTime();
+	ColorAutomaton::stepReference( grid, gridSize, gridSize, 1, magic );
+	double referenceRate = 1 / ( Time::getMonotonicTime() - startTime );
+
+	ColorAutomaton singleAutomaton( gridSize, gridSize, 1, magic,
+									&singlePool );
+	singleAutomaton.setGrid( grid );
+
+	startTime = Time::getMonotonicTime();
+	singleAutomaton.step( numGenerations );
+	double singleRate =
+		numGenerations / ( Time::getMonotonicTime() - startTime );
+
+	ColorAutomaton sharedAutomaton( gridSize, gridSize, 1, magic,
+									sharedPool );
+	sharedAutomaton.setGrid( grid );
+
+	startTime = Time::getMonotonicTime();
+	sharedAutomaton.step( numGenerations );
+	double sharedRate =
+		numGenerations / ( Time::getMonotonicTime() - startTime );
+
+	printf( "Generations per second on %dx%d:\n"
+			"  cell by cell %.3f, rows on 1 thread %.2f, "
+			"rows on %d threads %.2f\n",
+			gridSize, gridSize, referenceRate, singleRate,
+			sharedPool->getNumThreads(), sharedRate );
+
+	delete [] grid;
+
+	deleteMatrix( magic, 1 );
+	deleteMatrix( wide, 2 );
+
+	ThreadPool::shutdownSharedPool();
+
+
+	if( numBad == 0 ) {
+		printf( "All tests passed\n" );
+		return 0;
+		}
+	printf( "%d failures\n", numBad );
+	return 1;
+	}
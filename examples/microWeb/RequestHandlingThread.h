@@ -3,6 +3,10 @@
  *
  * 2001-May-11   Jason Rohrer
  * Created.  
+ *
+ * 2026-October-15   Jason Rohrer
+ * Reads request through a BufferedInputStream instead of byte-by-byte.
+ * Fixed hang when client closes connection mid-request.
  */
  
  
@@ -15,6 +19,8 @@
 #include "minorGems/network/Socket.h"
 #include "minorGems/network/SocketStream.h"
 
+#include "minorGems/io/BufferedInputStream.h"
+
 #include "minorGems/system/Thread.h"
 #include "minorGems/system/MutexLock.h"
 
@@ -158,49 +164,34 @@ inline void RequestHandlingThread::run() {
 
 	int requestBufferLength = 200;
 	char *requestBuffer = new char[requestBufferLength];
-	int requestBufferIndex = 0;
-		
-	// read until we see two \r\n 's in a row
-	unsigned char *charRead = new unsigned char[1];
-	charRead[0] = 0;
-	char requestDone = false;
+	requestBuffer[0] = '\0';
 
 	// _we_ actually only care about the first line of
 	// the request, but we need to read the entire request
 	// to make the other host happy
-	char firstLineDone = false;
-
-	while( !requestDone ) {
-		while( charRead[0] != 13 ) {
-			sockStream->read( charRead, 1 );
-			if( !firstLineDone ) {
-				// read data into our buffer
-				if( requestBufferIndex < requestBufferLength ) {
-					requestBuffer[ requestBufferIndex ] =
-						charRead[0];
-					requestBufferIndex++;
-					}
-				}
-			}
-		// look for rest of double \r\n
-		sockStream->read( charRead, 1 );
-		if( charRead[0] == 10 ) {
-			sockStream->read( charRead, 1 );
-			if( charRead[0] == 13 ) {
-				sockStream->read( charRead, 1 );
-				if( charRead[0] == 10 ) {
-					requestDone = true;
-					}
-				}
+	// read it all, up to the blank line, in buffered blocks
+	BufferedInputStream *bufferedStream =
+		new BufferedInputStream( sockStream, 4096 );
+	
+	char *request = bufferedStream->readUntil( "\r\n\r\n", 8192 );
+
+	delete bufferedStream;
+
+	if( request != NULL ) {
+		int firstLineLength = strcspn( request, "\r" );
+		if( firstLineLength > requestBufferLength - 1 ) {
+			firstLineLength = requestBufferLength - 1;
 			}
+		memcpy( requestBuffer, request, firstLineLength );
+		requestBuffer[ firstLineLength ] = '\0';
+
+		delete [] request;
 		}
 
 	// at this point, we have received the entire
 	// request, and stored the most important part in
 	// requestBuffer
-
-		// \0 terminate the request buffer
-	requestBuffer[ requestBufferLength - 1 ] = '\0';
+	// (empty if the request was cut off or too long)
 
 	char error = false;
 		
@@ -237,7 +228,6 @@ inline void RequestHandlingThread::run() {
 		}
 		
 	delete [] requestBuffer;
-	delete [] charRead;
 
 	File *file;
 	
@@ -6,28 +6,198 @@
  *
  * 2001-December-12		Jason Rohrer
  * Changed to use new HostAddress constructor.
+ *
+ * 2026-October-14   Jason Rohrer
+ * Changed to measure throughput of many requests from several threads,
+ * optionally over kept-alive connections.
  */
 
 #include "minorGems/network/Socket.h"
-#include "minorGems/network/SocketStream.h"
 #include "minorGems/network/SocketClient.h"
 #include "minorGems/network/HostAddress.h"
+#include "minorGems/system/Thread.h"
+#include "minorGems/system/Time.h"
+#include "minorGems/util/SimpleVector.h"
+#include "minorGems/util/stringUtils.h"
 
 
 #include <string.h>
 #include <stdio.h>
-#include <time.h>
-
+#include <stdlib.h>
 
-#define DEFAULT_CONFIG_FILE "microWeb.config"
 
 void usage( char *inAppName );
 
 // a test client for benchmarking web servers
 
-int main( char inNumArgs, char **inArgs ) {
 
-	if( inNumArgs != 4 ) {
+
+// how long to wait for server before counting a request as failed
+#define READ_TIMEOUT_MS 10000
+
+
+
+class ClientThread : public Thread {
+
+	public:
+
+		ClientThread( HostAddress *inAddress, char *inRequest,
+					  int inNumRequests, char inKeepAlive )
+				: mAddress( inAddress ), mRequest( inRequest ),
+				  mNumRequests( inNumRequests ), mKeepAlive( inKeepAlive ),
+				  mNumOK( 0 ), mNumFailed( 0 ), mNumConnections( 0 ),
+				  mBytesRead( 0 ) {
+			start();
+			}
+
+
+		void run() {
+			Socket *sock = NULL;
+
+			for( int i=0; i<mNumRequests; i++ ) {
+				
+				if( sock == NULL ) {
+					sock = SocketClient::connectToServer( mAddress );
+					
+					if( sock == NULL ) {
+						mNumFailed++;
+						continue;
+						}
+					mNumConnections++;
+					}
+
+				char serverClosing;
+				
+				if( doRequest( sock, &serverClosing ) ) {
+					mNumOK++;
+					}
+				else {
+					mNumFailed++;
+					serverClosing = true;
+					}
+
+				if( serverClosing || ! mKeepAlive ) {
+					delete sock;
+					sock = NULL;
+					}
+				}
+
+			if( sock != NULL ) {
+				delete sock;
+				}
+			}
+
+		
+		HostAddress *mAddress;
+		char *mRequest;
+		int mNumRequests;
+		char mKeepAlive;
+
+		// results
+		int mNumOK;
+		int mNumFailed;
+		int mNumConnections;
+		double mBytesRead;
+
+
+	protected:
+
+
+		// returns true if a whole response received
+		char doRequest( Socket *inSock, char *outServerClosing ) {
+			*outServerClosing = false;
+			
+			int requestLength = strlen( mRequest );
+			
+			if( inSock->send( (unsigned char*)mRequest, requestLength,
+							  true, false ) != requestLength ) {
+				return false;
+				}
+			
+			unsigned char buffer[ 4096 ];
+			
+			// read header
+			SimpleVector<char> header;
+			char *headerEnd = NULL;
+			int bodyBytesRead = 0;
+			
+			while( headerEnd == NULL ) {
+				int numRead = inSock->receive( buffer, sizeof( buffer ), 
+											   READ_TIMEOUT_MS );
+				if( numRead <= 0 ) {
+					return false;
+					}
+				
+				header.appendArray( (char*)buffer, numRead );
+
+				char *headerString = header.getElementString();
+				
+				headerEnd = strstr( headerString, "\r\n\r\n" );
+				
+				if( headerEnd != NULL ) {
+					int headerLength = headerEnd - headerString + 4;
+					bodyBytesRead = header.size() - headerLength;
+					}
+				
+				delete [] headerString;
+				}
+			
+			mBytesRead += header.size();
+
+			
+			char *headerString = header.getElementString();
+			
+			int status = 0;
+			sscanf( headerString, "%*s %d", &status );
+			
+			long contentLength = -1;
+			
+			char *lengthString = 
+				stringLocateIgnoreCase( headerString, "Content-Length:" );
+			if( lengthString != NULL ) {
+				sscanf( &( lengthString[ 15 ] ), "%ld", &contentLength );
+				}
+			
+			char *closeString = 
+				stringLocateIgnoreCase( headerString, "Connection: close" );
+			if( closeString != NULL ) {
+				*outServerClosing = true;
+				}
+			
+			delete [] headerString;
+			
+			if( status == 304 ) {
+				contentLength = 0;
+				}
+			
+			if( contentLength == -1 ) {
+				// body ends when server closes
+				*outServerClosing = true;
+				}
+			
+
+			// read rest of body
+			while( contentLength == -1 || bodyBytesRead < contentLength ) {
+				int numRead = inSock->receive( buffer, sizeof( buffer ), 
+											   READ_TIMEOUT_MS );
+				if( numRead <= 0 ) {
+					return ( contentLength == -1 && numRead == -1 );
+					}
+				
+				bodyBytesRead += numRead;
+				mBytesRead += numRead;
+				}
+			
+			return ( status == 200 || status == 304 );
+			}
+
+	};
+
+
+
+int main( int inNumArgs, char **inArgs ) {
+
+	if( inNumArgs < 4 || inNumArgs > 7 ) {
 		usage( inArgs[0] );
 		}
 
@@ -39,68 +209,87 @@ int main( char inNumArgs, char **inArgs ) {
 		usage( inArgs[0] );
 		}
 
-	
-	int addressLength = strlen( inArgs[1] );
-	char *copiedArg = new char[ addressLength + 1 ];
-	strcpy( copiedArg, inArgs[1] );
-	
-	HostAddress *address = new HostAddress( copiedArg, portNumber );
+	int numThreads = 1;
+	int numRequests = 1;
+	int keepAlive = 0;
 
+	if( inNumArgs > 4 ) {
+		numThreads = atoi( inArgs[4] );
+		}
+	if( inNumArgs > 5 ) {
+		numRequests = atoi( inArgs[5] );
+		}
+	if( inNumArgs > 6 ) {
+		keepAlive = atoi( inArgs[6] );
+		}
 	
-	printf( "trying to connect to host " );
-	address->print();
-	printf( "\n" );
+	if( numThreads < 1 || numRequests < 1 ) {
+		usage( inArgs[0] );
+		}
 
-	Socket *sock = SocketClient::connectToServer( address );
+	
+	HostAddress *address = 
+		new HostAddress( stringDuplicate( inArgs[1] ), portNumber );
 
-	if( sock == NULL ) {
-		printf( "connection failed\n" );
+	char *request;
+	
+	if( keepAlive ) {
+		request = autoSprintf( "GET /%s HTTP/1.1\r\nHost: %s\r\n"
+							   "Accept: */*\r\n\r\n",
+							   inArgs[3], inArgs[1] );
 		}
 	else {
-		// connection established
-		printf( "connection established\n" );
-
-		SocketStream *stream = new SocketStream( sock );
-
-		char *requestBuffer = new char[200];
-
-		sprintf( requestBuffer, "GET /%s HTTP/1.0\r\nAccept: */*\r\n\r\n",
-				 inArgs[3] );
-
-		printf( "sending HTTP request:\n" );
-		printf( "%s", requestBuffer );
-
-		stream->write( (unsigned char*)requestBuffer,
-					   strlen( requestBuffer ) );
-
-		delete [] requestBuffer;
-
-		int bufferSize = 4096;
-		unsigned char *responseBuffer = new unsigned char[ bufferSize ];
-		int bytesRead = bufferSize;
-		int totalNumBytesRead = 0;
-
-		printf( "reading response\n" );
-		
-		unsigned long startTime = time( NULL );
-		
-		while( bytesRead == bufferSize ) {
-			bytesRead = stream->read( responseBuffer, bufferSize ); 
-
-			totalNumBytesRead += bytesRead;
-			}
+		request = autoSprintf( "GET /%s HTTP/1.1\r\nHost: %s\r\n"
+							   "Accept: */*\r\nConnection: close\r\n\r\n",
+							   inArgs[3], inArgs[1] );
+		}
+	
 
-		unsigned long netTime = time( NULL ) - startTime;
+	printf( "%d threads sending %d requests each to ", 
+			numThreads, numRequests );
+	address->print();
+	if( keepAlive ) {
+		printf( " over kept-alive connections\n" );
+		}
+	else {
+		printf( " with a connection per request\n" );
+		}
+	
+	double startTime = Time::getCurrentTime();
+	
+	ClientThread **threads = new ClientThread*[ numThreads ];
+	
+	for( int i=0; i<numThreads; i++ ) {
+		threads[i] = new ClientThread( address, request, numRequests,
+									   (char)keepAlive );
+		}
 
-		printf( "Read %d bytes in %d seconds (at %f bytes/sec)\n",
-				totalNumBytesRead, netTime,
-				(double) totalNumBytesRead / (double)netTime );
+	int numOK = 0;
+	int numFailed = 0;
+	int numConnections = 0;
+	double bytesRead = 0;
+	
+	for( int i=0; i<numThreads; i++ ) {
+		threads[i]->join();
 		
-		delete [] responseBuffer;
+		numOK += threads[i]->mNumOK;
+		numFailed += threads[i]->mNumFailed;
+		numConnections += threads[i]->mNumConnections;
+		bytesRead += threads[i]->mBytesRead;
 
-		delete stream;
-		delete sock;
+		delete threads[i];
 		}
+	
+	double netTime = Time::getCurrentTime() - startTime;
+
+	printf( "%d ok, %d failed, %d connections, %.0f bytes "
+			"in %.3f seconds\n",
+			numOK, numFailed, numConnections, bytesRead, netTime );
+	printf( "%.1f requests/sec, %.2f MiB/sec\n",
+			numOK / netTime, bytesRead / ( netTime * 1048576 ) );
+	
+	delete [] threads;
+	delete [] request;
 	delete address;
 
 
@@ -112,10 +301,13 @@ int main( char inNumArgs, char **inArgs ) {
 void usage( char *inAppName ) {
 
 	printf( "Usage:\n" );
-	printf( "\t%s server_address server_port file_name\n", inAppName );
+	printf( "\t%s server_address server_port file_name "
+			"[num_threads [requests_per_thread [keep_alive]]]\n", 
+			inAppName );
 
-	printf( "Example:\n" );
+	printf( "Examples:\n" );
 	printf( "\t%s 192.168.1.2 80 test.mp3\n", inAppName );
+	printf( "\t%s 192.168.1.2 80 index.html 16 1000 1\n", inAppName );
 	
 	exit( 1 );
 	}
@@ -0,0 +1,215 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+#include "minorGems/common.h"
+
+
+
+#ifndef NET_BENCH_COMMON_INCLUDED
+#define NET_BENCH_COMMON_INCLUDED
+
+
+#include <stdio.h>
+#include <math.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <time.h>
+#endif
+
+
+
+// monotonic seconds, as in ZoneProfiler
+inline double getBenchTime() {
+    #ifdef _WIN32
+        static double secondsPerCount = 0;
+
+        LARGE_INTEGER count;
+
+        if( secondsPerCount == 0 ) {
+            LARGE_INTEGER frequency;
+            QueryPerformanceFrequency( &frequency );
+
+            secondsPerCount = 1.0 / (double)( frequency.QuadPart );
+            }
+
+        QueryPerformanceCounter( &count );
+
+        return (double)( count.QuadPart ) * secondsPerCount;
+    #else
+        struct timespec now;
+        clock_gettime( CLOCK_MONOTONIC, &now );
+
+        return now.tv_sec + now.tv_nsec / 1000000000.0;
+    #endif
+    }
+
+
+
+// buckets per doubling of latency
+#define LATENCY_SUB_BUCKETS 16
+
+// 1 us up to about 70 minutes
+#define LATENCY_OCTAVES 32
+
+
+
+/**
+ * Latency histogram with logarithmic buckets, 16 per doubling, so
+ * percentiles are within about 6% of exact no matter how many samples
+ * are added.
+ */
+class LatencyHistogram {
+
+    public:
+
+        LatencyHistogram()
+                : mNumSamples( 0 ), mMaxMicroseconds( 0 ) {
+            for( int i=0; i<LATENCY_SUB_BUCKETS * LATENCY_OCTAVES; i++ ) {
+                mCounts[i] = 0;
+                }
+            }
+
+
+        void add( double inSeconds ) {
+            double micro = inSeconds * 1000000;
+
+            if( micro > mMaxMicroseconds ) {
+                mMaxMicroseconds = micro;
+                }
+
+            mCounts[ getBucket( micro ) ]++;
+            mNumSamples++;
+            }
+
+
+        int getNumSamples() {
+            return mNumSamples;
+            }
+
+
+        // upper edge of bucket holding inFraction of samples (0.5 for
+        // median), in microseconds
+        double getPercentile( double inFraction ) {
+            if( mNumSamples == 0 ) {
+                return 0;
+                }
+
+            // nearest rank
+            long long rank = (long long)ceil( inFraction * mNumSamples );
+            if( rank < 1 ) {
+                rank = 1;
+                }
+
+            long long seen = 0;
+
+            for( int i=0; i<LATENCY_SUB_BUCKETS * LATENCY_OCTAVES; i++ ) {
+                seen += mCounts[i];
+
+                if( seen >= rank ) {
+                    double edge = getBucketTop( i );
+
+                    if( edge > mMaxMicroseconds ) {
+                        return mMaxMicroseconds;
+                        }
+                    return edge;
+                    }
+                }
+
+            return mMaxMicroseconds;
+            }
+
+
+        void printSummary() {
+            printf( "RTT us:  p50 %.1f  p90 %.1f  p99 %.1f  p999 %.1f  "
+                    "max %.1f  (%d samples)\n",
+                    getPercentile( 0.5 ), getPercentile( 0.9 ),
+                    getPercentile( 0.99 ), getPercentile( 0.999 ),
+                    mMaxMicroseconds, mNumSamples );
+            }
+
+
+        // one row per doubling that has samples, with a bar scaled to
+        // the fullest row
+        void printHistogram() {
+            int octaveCounts[ LATENCY_OCTAVES ];
+            int maxCount = 0;
+
+            for( int o=0; o<LATENCY_OCTAVES; o++ ) {
+                octaveCounts[o] = 0;
+
+                for( int s=0; s<LATENCY_SUB_BUCKETS; s++ ) {
+                    octaveCounts[o] += mCounts[ o * LATENCY_SUB_BUCKETS + s ];
+                    }
+
+                if( octaveCounts[o] > maxCount ) {
+                    maxCount = octaveCounts[o];
+                    }
+                }
+
+            for( int o=0; o<LATENCY_OCTAVES; o++ ) {
+                if( octaveCounts[o] == 0 ) {
+                    continue;
+                    }
+
+                int barLength = ( 50 * octaveCounts[o] ) / maxCount;
+
+                printf( "  %8.0f - %8.0f us %9d  ",
+                        ldexp( 1.0, o ), ldexp( 1.0, o + 1 ),
+                        octaveCounts[o] );
+
+                for( int b=0; b<barLength; b++ ) {
+                    printf( "#" );
+                    }
+                printf( "\n" );
+                }
+            }
+
+
+    protected:
+
+        int mCounts[ LATENCY_SUB_BUCKETS * LATENCY_OCTAVES ];
+
+        int mNumSamples;
+
+        double mMaxMicroseconds;
+
+
+        static int getBucket( double inMicroseconds ) {
+            if( inMicroseconds < 1 ) {
+                return 0;
+                }
+
+            // frexp mantissa is in [0.5,1)
+            int exponent;
+            double mantissa = frexp( inMicroseconds, &exponent );
+
+            int octave = exponent - 1;
+
+            if( octave >= LATENCY_OCTAVES ) {
+                return LATENCY_SUB_BUCKETS * LATENCY_OCTAVES - 1;
+                }
+
+            int sub = (int)( ( mantissa * 2 - 1 ) * LATENCY_SUB_BUCKETS );
+
+            return octave * LATENCY_SUB_BUCKETS + sub;
+            }
+
+
+        static double getBucketTop( int inBucket ) {
+            int octave = inBucket / LATENCY_SUB_BUCKETS;
+            int sub = inBucket % LATENCY_SUB_BUCKETS;
+
+            return ldexp( 1.0 + (double)( sub + 1 ) / LATENCY_SUB_BUCKETS,
+                          octave );
+            }
+    };
+
+
+
+#endif
@@ -2,13 +2,20 @@
  * Modification History
  *
  * 2002-June-3   Jason Rohrer
- * Created.  
+ * Created.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Many connections at once through SocketPoll, echo mode for
+ * request/response, UDP mode, and socket call counts.
  */
 
 
 #include "minorGems/network/SocketServer.h"
 #include "minorGems/network/Socket.h"
-#include "minorGems/network/SocketStream.h"
+#include "minorGems/network/SocketPoll.h"
+#include "minorGems/network/SocketUDP.h"
+
+#include "netBenchCommon.h"
 
 
 #include <string.h>
@@ -16,69 +23,262 @@
 #include <stdlib.h>
 
 
-#define BUFFER_SIZE 5000
+#define BUFFER_SIZE 65536
+
+// sockets handled per SocketPoll wait
+#define MAX_READY 64
+
+// datagrams per receiveBatch
+#define UDP_BATCH 64
+
+#define UDP_MAX_DATAGRAM 65536
+
+// UDP has no end of run, so report after this long without datagrams
+#define UDP_IDLE_REPORT_MS 1000
+
+
+
+// counted as in netBenchSender
+static long long numSocketCalls = 0;
+static long long numReceiveCalls = 0;
+static long long bytesReceived = 0;
+static long long datagramsReceived = 0;
+
+static double firstReceiveTime = 0;
+static double lastReceiveTime = 0;
 
 
 void usage( char *inAppName );
 
 
-int main( char inNumArgs, char **inArgs ) {
 
-	if( inNumArgs != 2 ) {
-		usage( inArgs[0] );
-		}
+static void countReceived( int inNumBytes ) {
+    lastReceiveTime = getBenchTime();
 
-	long port;
-	int numRead = sscanf( inArgs[1], "%d", &port );
+    if( firstReceiveTime == 0 ) {
+        firstReceiveTime = lastReceiveTime;
+        }
 
-	if( numRead != 1 ) {
-		printf( "port number must be a valid integer:  %s\n", inArgs[1] );
-		usage( inArgs[0] );
-		}
+    bytesReceived += inNumBytes;
+    }
 
-   
-	SocketServer *server = new SocketServer( port, 1 );
-	
-	printf( "listening for a connection on port %d\n", port );
-	Socket *sock = server->acceptConnection();
 
-	if( sock == NULL ) {
-		printf( "socket connection failed\n" );
-		return( 1 );
-		}
-	printf( "connection received\n" );
-	
-	
-	SocketStream *inStream = new SocketStream( sock );
 
-	
-	unsigned long checksum = 0;
+static void printAndResetResults() {
+    double seconds = lastReceiveTime - firstReceiveTime;
+
+    printf( "%lld bytes received", bytesReceived );
+    if( datagramsReceived > 0 ) {
+        printf( " in %lld datagrams", datagramsReceived );
+        }
+    printf( "\n" );
+
+    if( seconds > 0 ) {
+        printf( "%.2f MiB per second over %.2f seconds\n",
+                bytesReceived / ( 1024 * 1024 * seconds ), seconds );
+        }
+
+    if( numReceiveCalls > 0 ) {
+        printf( "%lld socket calls (system calls), %.0f bytes per "
+                "receive call\n",
+                numSocketCalls, (double)bytesReceived / numReceiveCalls );
+        }
+    if( datagramsReceived > 0 ) {
+        printf( "%.2f socket calls per datagram\n",
+                (double)numSocketCalls / datagramsReceived );
+        }
+
+    fflush( stdout );
+
+    numSocketCalls = 0;
+    numReceiveCalls = 0;
+    bytesReceived = 0;
+    datagramsReceived = 0;
+    firstReceiveTime = 0;
+    lastReceiveTime = 0;
+    }
+
+
+
+static void runTCP( int inPort, char inEcho ) {
+    SocketServer *server = new SocketServer( inPort, 100 );
+
+    SocketPoll poll;
+    poll.addSocketServer( server );
+
+    printf( "listening for connections on port %d\n", inPort );
+
+    unsigned char *buffer = new unsigned char[ BUFFER_SIZE ];
+
+    SocketOrServer *ready[ MAX_READY ];
+
+    int numConnected = 0;
+
+    while( true ) {
+        int numReady = poll.wait( ready, MAX_READY, -1 );
+        numSocketCalls++;
+
+        for( int r=0; r<numReady; r++ ) {
+
+            if( ! ready[r]->isSocket ) {
+                Socket *sock = server->acceptConnection();
+                numSocketCalls++;
+
+                if( sock != NULL ) {
+                    poll.addSocket( sock );
+                    numConnected++;
+                    }
+                continue;
+                }
 
-	unsigned char *buffer = new unsigned char[ BUFFER_SIZE ];
-	
+            Socket *sock = ready[r]->sock;
 
-	numRead = BUFFER_SIZE;
+            int numRead = sock->receive( buffer, BUFFER_SIZE, 0 );
+            numSocketCalls++;
+            numReceiveCalls++;
 
-    int bytesReceived = 0;
-    
-	while( numRead == BUFFER_SIZE ) {
+            if( numRead == -2 ) {
+                continue;
+                }
 
-		// read a buffer full of data from standard in
-		numRead = inStream->read( buffer, BUFFER_SIZE );
+            if( numRead > 0 ) {
+                countReceived( numRead );
 
-        bytesReceived += numRead;
+                if( inEcho ) {
+                    // blocking, no delay
+                    int numSent = sock->send( buffer, numRead, true, false );
+                    numSocketCalls++;
+
+                    if( numSent == numRead ) {
+                        continue;
+                        }
+                    }
+                else {
+                    continue;
+                    }
+                }
+
+            // closed or failed
+            poll.removeSocket( sock );
+            delete sock;
+            numConnected--;
+
+            if( numConnected == 0 ) {
+                printf( "all connections closed.\n" );
+                printAndResetResults();
+                }
+            }
+        }
+    }
+
+
+
+static void runUDP( int inPort, char inEcho ) {
+    SocketUDP sock( (unsigned short)inPort );
+
+    printf( "receiving datagrams on port %d\n", inPort );
+
+    struct UDPPacket *packets = new struct UDPPacket[ UDP_BATCH ];
+    unsigned char *data = new unsigned char[ UDP_BATCH * UDP_MAX_DATAGRAM ];
+
+    for( int i=0; i<UDP_BATCH; i++ ) {
+        packets[i].mData = &( data[ i * UDP_MAX_DATAGRAM ] );
+        packets[i].mCapacity = UDP_MAX_DATAGRAM;
+        }
+
+    while( true ) {
+        int numReceived = sock.receiveBatch( packets, UDP_BATCH,
+                                             UDP_IDLE_REPORT_MS );
+        // wait, then receive
+        numSocketCalls += 2;
+        numReceiveCalls++;
+
+        if( numReceived == -2 ) {
+            numSocketCalls -= 2;
+            numReceiveCalls--;
+
+            if( datagramsReceived > 0 ) {
+                printf( "idle.\n" );
+                printAndResetResults();
+                }
+            continue;
+            }
+
+        if( numReceived < 0 ) {
+            printf( "socket error while receiving\n" );
+            break;
+            }
+
+        for( int i=0; i<numReceived; i++ ) {
+            countReceived( packets[i].mLength );
+            }
+        datagramsReceived += numReceived;
+
+        if( inEcho ) {
+            // mLength and mAddress already say what came from where
+            int sent = 0;
+
+            while( sent < numReceived ) {
+                int result = sock.sendBatch( &( packets[ sent ] ),
+                                             numReceived - sent );
+                numSocketCalls++;
+
+                if( result <= 0 ) {
+                    break;
+                    }
+                sent += result;
+                }
+            }
+        }
+
+    delete [] packets;
+    delete [] data;
+    }
+
+
+
+int main( int inNumArgs, char **inArgs ) {
+
+    char udp = false;
+    char echo = false;
+
+    int argIndex = 1;
+
+    while( argIndex < inNumArgs && inArgs[ argIndex ][0] == '-' ) {
+        if( strcmp( inArgs[ argIndex ], "-udp" ) == 0 ) {
+            udp = true;
+            }
+        else if( strcmp( inArgs[ argIndex ], "-echo" ) == 0 ) {
+            echo = true;
+            }
+        else {
+            usage( inArgs[0] );
+            }
+        argIndex++;
+        }
+
+	if( inNumArgs - argIndex != 1 ) {
+		usage( inArgs[0] );
+		}
+
+	int port;
+	int numRead = sscanf( inArgs[ argIndex ], "%d", &port );
+
+	if( numRead != 1 ) {
+		printf( "port number must be a valid integer:  %s\n",
+                inArgs[ argIndex ] );
+		usage( inArgs[0] );
 		}
 
-	
-	printf( "connection broken.  %d bytes received.\n", bytesReceived );
+    Socket::initSocketFramework();
 
+    if( udp ) {
+        runUDP( port, echo );
+        }
+    else {
+        runTCP( port, echo );
+        }
 
-	delete sock;
-	delete server;
-	delete inStream;
-	
-	delete [] buffer;
-	
 	return 0;
 	}
 
@@ -87,10 +287,15 @@ int main( char inNumArgs, char **inArgs ) {
 void usage( char *inAppName ) {
 
 	printf( "Usage:\n" );
-	printf( "\t%s receiver_port\n", inAppName );
+	printf( "\t%s [-udp] [-echo] receiver_port\n", inAppName );
+
+    printf( "Options:\n" );
+    printf( "\t-udp   receive datagrams instead of connections\n" );
+    printf( "\t-echo  send everything back (for sender's rr and udp "
+            "modes)\n" );
 
 	printf( "Example:\n" );
-    printf( "\t%s 5888 \n", inAppName );
-	
+    printf( "\t%s -echo 5888 \n", inAppName );
+
 	exit( 1 );
 	}
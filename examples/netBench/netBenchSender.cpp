@@ -2,130 +2,580 @@
  * Modification History
  *
  * 2002-June-3   Jason Rohrer
- * Created.  
+ * Created.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Rewritten as a load generator:  parallel connections, message sizes,
+ * request/response and UDP modes, RTT histograms, and socket calls per
+ * message.
  */
 
 #include "minorGems/network/SocketClient.h"
 #include "minorGems/network/Socket.h"
-#include "minorGems/network/SocketStream.h"
+#include "minorGems/network/SocketPoll.h"
+#include "minorGems/network/SocketUDP.h"
 #include "minorGems/network/HostAddress.h"
-#include "minorGems/system/Time.h"
 
 #include "minorGems/util/stringUtils.h"
 
+#include "netBenchCommon.h"
+
 
 
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
+
+
+
+// how long a UDP request waits for its reply before counting as lost
+#define UDP_LOSS_TIMEOUT 0.2
+
+
+
+typedef enum BenchMode {
+    modeStream,
+    modeRequestResponse,
+    modeUDP
+    } BenchMode;
+
+
+
+typedef struct BenchConnection {
+        Socket *sock;
+
+        // progress through current message
+        int bytesSent;
+        int bytesReceived;
+
+        double sendTime;
+
+        // UDP only, to match replies to requests
+        unsigned int sequenceNumber;
+    } BenchConnection;
+
+
+
+// options
+static BenchMode mode = modeStream;
+static int numConnections = 1;
+static int messageSize = 5000;
+static double secondsToRun = 5;
 
 
-#define BUFFER_SIZE 5000
+// every call into the socket library that makes system calls
+// counted at call sites:  each send, receive with a 0 timeout, and
+// SocketPoll wait is one system call, and a receiveBatch with a timeout
+// is two (wait, then receive)
+static long long numSocketCalls = 0;
+
+static long long numMessages = 0;
+
+static LatencyHistogram rtt;
+
+static unsigned char *messageBuffer;
+static unsigned char *receiveBuffer;
+
 
 
 void usage( char *inAppName );
 
 
-int main( char inNumArgs, char **inArgs ) {
 
-	if( inNumArgs != 4 ) {
-		usage( inArgs[0] );
-		}
+static void printResults( double inElapsedSeconds ) {
+    printf( "%.2f seconds elapsed\n", inElapsedSeconds );
+    printf( "%lld messages of %d bytes over %d %s\n", numMessages,
+            messageSize, numConnections,
+            mode == modeUDP ? "outstanding datagrams" : "connections" );
+    printf( "%.0f messages per second, %.2f MiB per second\n",
+            numMessages / inElapsedSeconds,
+            numMessages * (double)messageSize /
+            ( 1024 * 1024 * inElapsedSeconds ) );
+
+    if( numMessages > 0 ) {
+        printf( "%.2f socket calls (system calls) per message\n",
+                (double)numSocketCalls / numMessages );
+        }
+
+    if( rtt.getNumSamples() > 0 ) {
+        rtt.printSummary();
+        rtt.printHistogram();
+        }
+    }
+
+
+
+// returns false on failure
+static char connectAll( HostAddress *inAddress, BenchConnection *inConns,
+                        SocketPoll *inPoll, int inPollFlags ) {
+
+    for( int i=0; i<numConnections; i++ ) {
+        inConns[i].sock = SocketClient::connectToServer( inAddress );
 
-	long port;
-	int numRead = sscanf( inArgs[2], "%d", &port );
+        if( inConns[i].sock == NULL ) {
+            printf( "connection %d to host failed\n", i );
+            return false;
+            }
 
-	if( numRead != 1 ) {
-		printf( "port number must be a valid integer:  %s\n", inArgs[2] );
-		usage( inArgs[0] );
-		}
+        inConns[i].bytesSent = 0;
+        inConns[i].bytesReceived = 0;
+        inConns[i].sendTime = 0;
 
-    long kiBToSend;
+        inPoll->addSocket( inConns[i].sock, &( inConns[i] ), inPollFlags );
+        }
+
+    printf( "%d connections successful\n", numConnections );
 
-    numRead = sscanf( inArgs[3], "%d", &kiBToSend );
+    return true;
+    }
 
-	if( numRead != 1 ) {
-		printf( "kiB to send must be a valid integer:  %s\n", inArgs[3] );
-		usage( inArgs[0] );
-		}
-    
-	char *copiedArg = stringDuplicate( inArgs[1] );
-	
-	HostAddress *receiverAddress =
-		new HostAddress( copiedArg, port ); 
 
-	printf( "connecting to host:  " );
-	receiverAddress->print();
-	printf( "\n" );
-	Socket *sock = SocketClient::connectToServer( receiverAddress );
 
-	
-	if( sock == NULL ) {
-		printf( "connection to host failed\n" );
-		return( 1 );
-		}
+// sends rest of current message without blocking
+// returns false on socket error
+static char continueSend( BenchConnection *inConn ) {
+    while( inConn->bytesSent < messageSize ) {
+        int numSent = inConn->sock->send(
+            &( messageBuffer[ inConn->bytesSent ] ),
+            messageSize - inConn->bytesSent, false, false );
+        numSocketCalls++;
 
-	printf( "connection successful\n" );
-	
-	SocketStream *outStream = new SocketStream( sock );
+        if( numSent == -2 ) {
+            // full, wait for write-ready
+            return true;
+            }
+        if( numSent < 0 ) {
+            return false;
+            }
 
-	
-	unsigned long checksum = 0;
+        inConn->bytesSent += numSent;
+        }
 
-	unsigned char *buffer = new unsigned char[ BUFFER_SIZE ];
-	
+    return true;
+    }
 
-	int numWritten = BUFFER_SIZE;
-    
-    int bytesSent = 0;
 
-    unsigned long seconds;
-    unsigned long milliseconds;
 
-    Time::getCurrentTime( &seconds, &milliseconds );
+// as many messages as the connections will take, back to back
+static void runStream( HostAddress *inAddress ) {
+    BenchConnection *conns = new BenchConnection[ numConnections ];
+    SocketOrServer **ready = new SocketOrServer*[ numConnections ];
 
-    long blocksToSend = ( kiBToSend * 1024 ) / BUFFER_SIZE;
-    
-    for( int i=0; i<blocksToSend && numWritten == BUFFER_SIZE; i++ ) {
-        numWritten = outStream->write( buffer, BUFFER_SIZE );
+    SocketPoll poll;
 
-        bytesSent += numWritten;
+    if( ! connectAll( inAddress, conns, &poll, SOCKET_POLL_WRITE ) ) {
+        return;
         }
 
-    unsigned long elapsedMilliseconds =
-        Time::getMillisecondsSince(
-            seconds,
-            milliseconds );
+    double startTime = getBenchTime();
+    double endTime = startTime + secondsToRun;
 
-    float elapsedSeconds = ( (float)elapsedMilliseconds ) / 1000;
-    
-    float bytesPerSec = (float)bytesSent / elapsedSeconds;
+    char failed = false;
 
-    printf( "%.2f second elapsed\n", elapsedSeconds );
-    printf( "%.2f bytes per second\n", bytesPerSec );
+    while( ! failed && getBenchTime() < endTime ) {
+        int numReady = poll.wait( ready, numConnections, 100 );
+        numSocketCalls++;
 
-	if( BUFFER_SIZE != numWritten ) {
-		printf( "network connection failed during transmission\n" );
-		}	
+        for( int r=0; r<numReady; r++ ) {
+            BenchConnection *c = (BenchConnection *)( ready[r]->otherData );
+
+            while( true ) {
+                if( ! continueSend( c ) ) {
+                    printf( "network connection failed during "
+                            "transmission\n" );
+                    failed = true;
+                    break;
+                    }
+
+                if( c->bytesSent < messageSize ) {
+                    break;
+                    }
+
+                numMessages++;
+                c->bytesSent = 0;
+                }
+
+            if( failed ) {
+                break;
+                }
+            }
+        }
+
+    printResults( getBenchTime() - startTime );
+
+    for( int i=0; i<numConnections; i++ ) {
+        poll.removeSocket( conns[i].sock );
+        delete conns[i].sock;
+        }
+    delete [] conns;
+    delete [] ready;
+    }
+
+
+
+// one message in flight per connection, timed until whole reply is back
+static void runRequestResponse( HostAddress *inAddress ) {
+    BenchConnection *conns = new BenchConnection[ numConnections ];
+    SocketOrServer **ready = new SocketOrServer*[ numConnections ];
+
+    SocketPoll poll;
+
+    if( ! connectAll( inAddress, conns, &poll, 0 ) ) {
+        return;
+        }
+
+    double startTime = getBenchTime();
+    double endTime = startTime + secondsToRun;
+
+    char failed = false;
+
+    for( int i=0; i<numConnections && ! failed; i++ ) {
+        conns[i].sendTime = getBenchTime();
+
+        // requests are small next to socket buffers, so this finishes
+        // unless the receiver isn't echoing
+        if( ! continueSend( &( conns[i] ) ) ) {
+            failed = true;
+            }
+        }
+
+    while( ! failed && getBenchTime() < endTime ) {
+        int numReady = poll.wait( ready, numConnections, 100 );
+        numSocketCalls++;
+
+        for( int r=0; r<numReady && ! failed; r++ ) {
+            BenchConnection *c = (BenchConnection *)( ready[r]->otherData );
+
+            int numRead = c->sock->receive(
+                receiveBuffer, messageSize - c->bytesReceived, 0 );
+            numSocketCalls++;
+
+            if( numRead == -2 ) {
+                continue;
+                }
+            if( numRead < 0 ) {
+                printf( "network connection failed during "
+                        "transmission\n" );
+                failed = true;
+                break;
+                }
+
+            c->bytesReceived += numRead;
+
+            if( c->bytesReceived < messageSize ) {
+                continue;
+                }
+
+            double now = getBenchTime();
+
+            rtt.add( now - c->sendTime );
+            numMessages++;
+
+            c->bytesReceived = 0;
+            c->bytesSent = 0;
+            c->sendTime = now;
+
+            if( ! continueSend( c ) ) {
+                failed = true;
+                }
+            }
+        }
+
+    printResults( getBenchTime() - startTime );
+
+    for( int i=0; i<numConnections; i++ ) {
+        poll.removeSocket( conns[i].sock );
+        delete conns[i].sock;
+        }
+    delete [] conns;
+    delete [] ready;
+    }
 
-	delete receiverAddress;
-	delete sock;
-	delete outStream;
-	
-	delete [] buffer;
-	
-	return 0;
-	}
+
+
+// numConnections datagrams in flight, each re-sent as soon as its echo
+// comes back (or it is given up on as lost)
+static void runUDP( HostAddress *inAddress ) {
+    HostAddress *numerical = inAddress->getNumericalAddress();
+
+    if( numerical == NULL ) {
+        printf( "looking up host failed\n" );
+        return;
+        }
+
+    // any free local port
+    SocketUDP sock( 0 );
+
+    struct UDPAddress *receiverAddress =
+        SocketUDP::makeAddress( numerical->mAddressString,
+                                (unsigned short)( numerical->mPort ) );
+    delete numerical;
+
+    if( receiverAddress == NULL ) {
+        printf( "bad receiver address\n" );
+        return;
+        }
+
+    BenchConnection *slots = new BenchConnection[ numConnections ];
+
+    struct UDPPacket *outPackets = new struct UDPPacket[ numConnections ];
+    struct UDPPacket *inPackets = new struct UDPPacket[ numConnections ];
+
+    // each outgoing packet carries its slot and sequence number first
+    unsigned char *outData =
+        new unsigned char[ numConnections * messageSize ];
+
+    unsigned char *inData = new unsigned char[ numConnections * messageSize ];
+
+    for( int i=0; i<numConnections; i++ ) {
+        inPackets[i].mData = &( inData[ i * messageSize ] );
+        inPackets[i].mCapacity = messageSize;
+
+        slots[i].sock = NULL;
+        slots[i].sequenceNumber = 0;
+        }
+
+    long long numLost = 0;
+    unsigned int nextSequenceNumber = 1;
+
+    double startTime = getBenchTime();
+    double endTime = startTime + secondsToRun;
+
+    // all slots start empty, so all are sent first time through
+    for( int i=0; i<numConnections; i++ ) {
+        slots[i].sendTime = 0;
+        }
+
+    while( true ) {
+        double now = getBenchTime();
+
+        if( now >= endTime ) {
+            break;
+            }
+
+        int numToSend = 0;
+
+        for( int i=0; i<numConnections; i++ ) {
+            BenchConnection *s = &( slots[i] );
+
+            if( s->sendTime != 0 &&
+                now - s->sendTime < UDP_LOSS_TIMEOUT ) {
+                // still waiting
+                continue;
+                }
+
+            if( s->sendTime != 0 ) {
+                numLost++;
+                }
+
+            s->sequenceNumber = nextSequenceNumber++;
+            s->sendTime = now;
+
+            unsigned char *d = &( outData[ numToSend * messageSize ] );
+
+            memcpy( d, messageBuffer, messageSize );
+            memcpy( d, &i, sizeof( int ) );
+            memcpy( &( d[ sizeof( int ) ] ), &( s->sequenceNumber ),
+                    sizeof( unsigned int ) );
+
+            outPackets[ numToSend ].mAddress = *receiverAddress;
+            outPackets[ numToSend ].mData = d;
+            outPackets[ numToSend ].mLength = messageSize;
+            numToSend++;
+            }
+
+        int sent = 0;
+        while( sent < numToSend ) {
+            int result = sock.sendBatch( &( outPackets[ sent ] ),
+                                         numToSend - sent );
+            numSocketCalls++;
+
+            if( result <= 0 ) {
+                break;
+                }
+            sent += result;
+            }
+
+
+        int numReceived = sock.receiveBatch( inPackets, numConnections, 10 );
+        numSocketCalls += 2;
+
+        if( numReceived == -1 ) {
+            printf( "socket error while receiving\n" );
+            break;
+            }
+
+        now = getBenchTime();
+
+        for( int p=0; p<numReceived; p++ ) {
+            if( inPackets[p].mLength < (int)( 2 * sizeof( int ) ) ) {
+                continue;
+                }
+
+            int slot;
+            unsigned int sequenceNumber;
+
+            memcpy( &slot, inPackets[p].mData, sizeof( int ) );
+            memcpy( &sequenceNumber,
+                    &( inPackets[p].mData[ sizeof( int ) ] ),
+                    sizeof( unsigned int ) );
+
+            if( slot < 0 || slot >= numConnections ||
+                slots[slot].sequenceNumber != sequenceNumber ||
+                slots[slot].sendTime == 0 ) {
+                // late reply to a request already counted as lost
+                continue;
+                }
+
+            rtt.add( now - slots[slot].sendTime );
+            numMessages++;
+
+            // ready to send again
+            slots[slot].sendTime = 0;
+            }
+        }
+
+    printResults( getBenchTime() - startTime );
+
+    printf( "%lld datagrams lost (no echo within %.0f ms)\n",
+            numLost, UDP_LOSS_TIMEOUT * 1000 );
+
+    delete receiverAddress;
+    delete [] slots;
+    delete [] outPackets;
+    delete [] inPackets;
+    delete [] outData;
+    delete [] inData;
+    }
+
+
+
+int main( int inNumArgs, char **inArgs ) {
+
+    int argIndex = 1;
+
+    while( argIndex < inNumArgs && inArgs[ argIndex ][0] == '-' ) {
+        const char *option = inArgs[ argIndex ];
+
+        if( argIndex + 1 >= inNumArgs ) {
+            usage( inArgs[0] );
+            }
+
+        const char *value = inArgs[ argIndex + 1 ];
+
+        if( strcmp( option, "-mode" ) == 0 ) {
+            if( strcmp( value, "stream" ) == 0 ) {
+                mode = modeStream;
+                }
+            else if( strcmp( value, "rr" ) == 0 ) {
+                mode = modeRequestResponse;
+                }
+            else if( strcmp( value, "udp" ) == 0 ) {
+                mode = modeUDP;
+                }
+            else {
+                usage( inArgs[0] );
+                }
+            }
+        else if( strcmp( option, "-conns" ) == 0 ) {
+            numConnections = atoi( value );
+            }
+        else if( strcmp( option, "-size" ) == 0 ) {
+            messageSize = atoi( value );
+            }
+        else if( strcmp( option, "-seconds" ) == 0 ) {
+            secondsToRun = atof( value );
+            }
+        else {
+            usage( inArgs[0] );
+            }
+
+        argIndex += 2;
+        }
+
+    if( inNumArgs - argIndex != 2 ) {
+        usage( inArgs[0] );
+        }
+
+    int port;
+    int numRead = sscanf( inArgs[ argIndex + 1 ], "%d", &port );
+
+    if( numRead != 1 ) {
+        printf( "port number must be a valid integer:  %s\n",
+                inArgs[ argIndex + 1 ] );
+        usage( inArgs[0] );
+        }
+
+    if( numConnections < 1 ) {
+        numConnections = 1;
+        }
+
+    // room for UDP slot and sequence number
+    if( messageSize < (int)( 2 * sizeof( int ) ) ) {
+        messageSize = 2 * sizeof( int );
+        }
+
+    Socket::initSocketFramework();
+
+    messageBuffer = new unsigned char[ messageSize ];
+    receiveBuffer = new unsigned char[ messageSize ];
+
+    memset( messageBuffer, 'x', messageSize );
+
+
+    char *copiedArg = stringDuplicate( inArgs[ argIndex ] );
+
+    HostAddress *receiverAddress = new HostAddress( copiedArg, port );
+
+    printf( "sending to host:  " );
+    receiverAddress->print();
+    printf( "\n" );
+
+    switch( mode ) {
+        case modeStream:
+            runStream( receiverAddress );
+            break;
+        case modeRequestResponse:
+            runRequestResponse( receiverAddress );
+            break;
+        case modeUDP:
+            runUDP( receiverAddress );
+            break;
+        }
+
+    delete receiverAddress;
+
+    delete [] messageBuffer;
+    delete [] receiveBuffer;
+
+    return 0;
+    }
 
 
 
 void usage( char *inAppName ) {
 
 	printf( "Usage:\n" );
-	printf( "\t%s receiver_address receiver_port kiB_to_send\n", inAppName );
+	printf( "\t%s [options] receiver_address receiver_port\n", inAppName );
+
+    printf( "Options:\n" );
+    printf( "\t-mode stream|rr|udp  stream:  send as fast as possible\n" );
+    printf( "\t                     rr:  request/response, timing each "
+            "echo\n" );
+    printf( "\t                     udp:  datagram request/response\n" );
+    printf( "\t                     (rr and udp need receiver's -echo)\n" );
+    printf( "\t                     Defaults to stream.\n" );
+    printf( "\t-conns n             parallel connections (or datagrams in "
+            "flight).  Defaults to 1.\n" );
+    printf( "\t-size bytes          message size.  Defaults to 5000.\n" );
+    printf( "\t-seconds s           how long to run.  Defaults to 5.\n" );
 
 	printf( "Examples:\n" );
-	printf( "\t%s 192.168.1.2 5888 5000\n", inAppName );
-	printf( "\t%s myhost.mydomain.com 5888 10\n", inAppName );
-	
+	printf( "\t%s 192.168.1.2 5888\n", inAppName );
+	printf( "\t%s -mode rr -conns 64 -size 200 myhost.mydomain.com 5888\n",
+            inAppName );
+	printf( "\t%s -mode udp -conns 16 -size 512 127.0.0.1 5888\n",
+            inAppName );
+
 	exit( 1 );
 	}
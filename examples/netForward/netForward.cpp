@@ -7,6 +7,12 @@
  * 2002-April-7   Jason Rohrer
  * Fixed a busy-waiting bug in ThreadManager.
  * Replaced use of strdup.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Replaced two threads per connection, moving one byte at a time, with one
+ * SocketPoll loop for all connections that moves whole buffers.
+ * Bytes pass through a pipe with splice on Linux, without being copied.
+ * Logging is now optional, and no longer flushed after every byte.
  */
 
 
@@ -14,276 +20,577 @@
 #include "minorGems/network/Socket.h"
 #include "minorGems/network/SocketClient.h"
 #include "minorGems/network/SocketServer.h"
+#include "minorGems/network/SocketPoll.h"
 #include "minorGems/network/HostAddress.h"
 
-#include "minorGems/system/Thread.h"
-#include "minorGems/system/MutexLock.h"
 #include "minorGems/util/SimpleVector.h"
 #include "minorGems/util/stringUtils.h"
 
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+
+#ifdef __linux__
+#define NET_FORWARD_USE_SPLICE
+#endif
+
+
+
+// most bytes held for one direction of a connection, in its pipe or buffer
+#define RELAY_BUFFER_SIZE 65536
+
+// most read/write rounds for one direction before going on to other
+// connections, so that one fast transfer can't starve the rest
+#define RELAY_MAX_ROUNDS 16
+
+#define CONNECT_TIMEOUT_MS 5000
+
+// most sockets handled per SocketPoll::wait call
+#define MAX_READY 64
+
+
+
+// set by command line options
+static char logTraffic = false;
+static char useSplice = true;
+
+
+
+// both sides of a relay never block
+static char setNonBlocking( Socket *inSocket ) {
+    int fd = inSocket->mNativeSocketID;
+
+    int flags = fcntl( fd, F_GETFL, 0 );
+
+    if( flags == -1 ) {
+        return false;
+        }
+    return ( fcntl( fd, F_SETFL, flags | O_NONBLOCK ) != -1 );
+    }
+
+
+
+static char wouldBlock( int inError ) {
+    return ( inError == EAGAIN || inError == EWOULDBLOCK ||
+             inError == EINTR );
+    }
 
 
 
 /**
- * Thread that handles piping received bytes from our forwarding socket back
- * through our listening socket.
+ * Moves bytes one way between two non-blocking sockets.
+ *
+ * On Linux, bytes go from one socket into a pipe and from the pipe into
+ * the other socket with splice, so they are never copied into user space.
+ * Otherwise, or when traffic is logged (which needs to see the bytes),
+ * they go through a buffer.
  */
-class ReceiveThread : public Thread {
+class RelayDirection {
 
     public:
-        ReceiveThread( Socket *inListenSocket,
-                       Socket *inForwardSocket,
-                       int inID );
 
-        void run();
+        /**
+         * @param inFrom, inTo the sockets to move bytes between.
+         *   Destroyed by caller.
+         * @param inLogFile file to log bytes to, or NULL.
+         *   Closed by caller.
+         */
+        RelayDirection( Socket *inFrom, Socket *inTo, FILE *inLogFile );
 
-    private:
-        char mStopped;
-        Socket *mListenSocket;
-        Socket *mForwardSocket;
-        int mID;
-        
-    };
+        ~RelayDirection();
 
 
+        // reads and writes until the sockets would block
+        // returns false on a socket error
+        char pump();
+
+
+        // true if there is room for more bytes from inFrom
+        char wantsRead() {
+            return ! mEndOfInput && ! mReadBlocked && getReadRoom() > 0;
+            }
+
+        // true if bytes are waiting to go out to inTo
+        char wantsWrite() {
+            return mNumPending > 0;
+            }
+
+        // true if inFrom has closed, and all of its bytes have gone out
+        char isDone() {
+            return mEndOfInput && mNumPending == 0;
+            }
+
+
+        long long mNumTransmitted;
+
+
+    protected:
+
+        Socket *mFrom;
+        Socket *mTo;
+
+        FILE *mLogFile;
+
+        // -1 if not splicing
+        int mPipe[2];
+
+        // NULL if splicing
+        // pending bytes start at mBufferStart
+        unsigned char *mBuffer;
+        int mBufferStart;
+
+        // in pipe or buffer
+        int mNumPending;
+
+        char mEndOfInput;
+
+        // a splice into the pipe would block even though there was room,
+        // so the pipe may be out of slots until some of it is written
+        char mReadBlocked;
+
+        char mOutputShutDown;
+
+
+        int getReadRoom();
+
+        void useBuffer();
+
+        // these return number of bytes moved, 0 if the socket would block,
+        // or -1 on error
+        int readSome();
+        int writeSome();
+    };
+
 
-ReceiveThread::ReceiveThread( Socket *inListenSocket,
-                              Socket *inForwardSocket,
-                              int inID )
-    : mListenSocket( inListenSocket ), mForwardSocket( inForwardSocket ),
-      mID( inID ) {
-    
-    }
 
+RelayDirection::RelayDirection( Socket *inFrom, Socket *inTo,
+                                FILE *inLogFile )
+    : mNumTransmitted( 0 ),
+      mFrom( inFrom ), mTo( inTo ), mLogFile( inLogFile ),
+      mBuffer( NULL ), mBufferStart( 0 ), mNumPending( 0 ),
+      mEndOfInput( false ), mReadBlocked( false ),
+      mOutputShutDown( false ) {
 
+    mPipe[0] = -1;
+    mPipe[1] = -1;
 
-void ReceiveThread::run() {
-    unsigned char receivedByte;
-    int numReceived = 1;
-    int numSent = 1;
-    
-    int numTransmitted = 0;
-    
-    char *fileName = new char[99];
-    sprintf( fileName, "r%d.txt", mID );
-    
-    FILE *logFile = fopen( fileName, "w" );
-    delete [] fileName;
-
-    while( numReceived == 1 && numSent == 1) {
-        
-        numReceived = mForwardSocket->receive( &receivedByte, 1, -1 );
-        if( numReceived == 1 ) {
-            numSent = mListenSocket->send( &receivedByte, 1 );
-            numTransmitted++;
-
-            fputc( receivedByte, logFile );
-            fflush( logFile );
+    #ifdef NET_FORWARD_USE_SPLICE
+    if( useSplice && mLogFile == NULL ) {
+        if( pipe( mPipe ) == 0 ) {
+            // ask for a pipe big enough to hold a whole buffer
+            // (often the default size already)
+            fcntl( mPipe[1], F_SETPIPE_SZ, RELAY_BUFFER_SIZE );
             }
         else {
-            numSent = 0;
-            }                
+            mPipe[0] = -1;
+            mPipe[1] = -1;
+            }
         }
+    #endif
 
-    fclose( logFile );
-    
-    printf( "Connection broken, %d total bytes received.\n",
-            numTransmitted );
-    
+    if( mPipe[0] == -1 ) {
+        useBuffer();
+        }
     }
 
 
 
-/**
- * Class that handles piping bytes from our listening
- * socket out through the forwarding socket.
- */
-class SendThread : public Thread {
+RelayDirection::~RelayDirection() {
+    if( mPipe[0] != -1 ) {
+        close( mPipe[0] );
+        close( mPipe[1] );
+        }
+    if( mBuffer != NULL ) {
+        delete [] mBuffer;
+        }
+    }
 
-    public:
-        SendThread( Socket *inListenSocket,
-                    char *inForwardAddress,
-                    int inForwardPort,
-                    int inID );
 
-        void run();
 
-    private:
-        Socket *mListenSocket;
-        char *mForwardAddress;
-        int mForwardPort;
-        int mID;
-        
+void RelayDirection::useBuffer() {
+    if( mPipe[0] != -1 ) {
+        close( mPipe[0] );
+        close( mPipe[1] );
+        mPipe[0] = -1;
+        mPipe[1] = -1;
+        }
 
-    };
+    mBuffer = new unsigned char[ RELAY_BUFFER_SIZE ];
+    mBufferStart = 0;
+    }
 
 
 
-SendThread::SendThread( Socket *inListenSocket,
-                        char *inForwardAddress,
-                        int inForwardPort,
-                        int inID )
-    : mListenSocket( inListenSocket ),
-      mForwardAddress( inForwardAddress ), mForwardPort( inForwardPort ),
-      mID( inID ) {
-    
+int RelayDirection::getReadRoom() {
+    if( mBuffer != NULL ) {
+        // only reads into space after pending bytes
+        return RELAY_BUFFER_SIZE - mBufferStart - mNumPending;
+        }
+    return RELAY_BUFFER_SIZE - mNumPending;
     }
 
 
 
-void SendThread::run() {
-
-    printf( "Establishing a connection to %s:%d\n",
-            mForwardAddress,
-            mForwardPort );
-
-    HostAddress *address = new HostAddress(
-        stringDuplicate( mForwardAddress ),
-        mForwardPort );
-    
-    Socket *forwardSocket = SocketClient::connectToServer( address );
-        
-    if( forwardSocket != NULL ) {
-        printf( "Connected to %s:%d\n",
-                mForwardAddress,
-                mForwardPort );
-
-        ReceiveThread *thread =
-            new ReceiveThread( mListenSocket, forwardSocket, mID );
-        
-        thread->start();
-        
-        char *fileName = new char[99];
-        sprintf( fileName, "s%d.txt", mID );
-        
-        FILE *logFile = fopen( fileName, "w" );
-        delete [] fileName;
-        
-
-        unsigned char receivedByte;
-        int numReceived = 1;
-        int numSent = 1;
-        
-        int numTransmitted = 0;
-        
-        while( numReceived == 1 && numSent == 1) {
-
-            numReceived = mListenSocket->receive( &receivedByte, 1, -1 );
-            if( numReceived == 1 ) {
-                numSent = forwardSocket->send( &receivedByte, 1 );
-                numTransmitted++;
-                //printf( "Received byte = %d\n", receivedByte );
-                
-                fputc( receivedByte, logFile );
-                fflush( logFile );
+int RelayDirection::readSome() {
+    int fd = mFrom->mNativeSocketID;
+
+    int numRead;
+
+    #ifdef NET_FORWARD_USE_SPLICE
+    if( mBuffer == NULL ) {
+        numRead = splice( fd, NULL, mPipe[1], NULL, getReadRoom(),
+                          SPLICE_F_MOVE | SPLICE_F_NONBLOCK );
+
+        if( numRead == -1 ) {
+            if( wouldBlock( errno ) ) {
+                if( mNumPending > 0 ) {
+                    // can't tell an empty socket from a pipe that is out
+                    // of slots (each takes a page, however few bytes it
+                    // holds), so stop reading until pipe drains some
+                    mReadBlocked = true;
+                    }
+                return 0;
                 }
-            else {
-                numSent = 0;
-                }                
+            if( errno == EINVAL && mNumPending == 0 ) {
+                // splice not supported for this socket
+                useBuffer();
+                return readSome();
+                }
+            return -1;
+            }
+
+        if( numRead == 0 ) {
+            mEndOfInput = true;
             }
-        delete forwardSocket;
-        
-        fclose( logFile );
-        
-        printf( "Connection broken, %d total bytes sent.\n",
-                numTransmitted );
-        
-        // thread should notice broken socket soon
-        thread->join();
-        delete thread;
-            
+        mNumPending += numRead;
+        return numRead;
+        }
+    #endif
+
+    numRead = recv( fd, &( mBuffer[ mBufferStart + mNumPending ] ),
+                    getReadRoom(), 0 );
+
+    if( numRead == -1 ) {
+        if( wouldBlock( errno ) ) {
+            return 0;
+            }
+        return -1;
+        }
+
+    if( numRead == 0 ) {
+        mEndOfInput = true;
+        return 0;
+        }
+
+    if( mLogFile != NULL ) {
+        fwrite( &( mBuffer[ mBufferStart + mNumPending ] ), 1, numRead,
+                mLogFile );
+        }
+
+    mNumPending += numRead;
+    return numRead;
+    }
+
+
+
+int RelayDirection::writeSome() {
+    int fd = mTo->mNativeSocketID;
+
+    int numWritten;
+
+    #ifdef NET_FORWARD_USE_SPLICE
+    if( mBuffer == NULL ) {
+        numWritten = splice( mPipe[0], NULL, fd, NULL, mNumPending,
+                             SPLICE_F_MOVE | SPLICE_F_NONBLOCK );
         }
     else {
-        printf( "Connecting to %s:%d failed\n",
-                mForwardAddress,
-                mForwardPort );
+        numWritten = send( fd, &( mBuffer[ mBufferStart ] ), mNumPending,
+                           0 );
+        }
+    #else
+    numWritten = send( fd, &( mBuffer[ mBufferStart ] ), mNumPending, 0 );
+    #endif
+
+    if( numWritten == -1 ) {
+        if( wouldBlock( errno ) ) {
+            return 0;
+            }
+        return -1;
         }
 
-    delete address;
+    mNumPending -= numWritten;
+    mNumTransmitted += numWritten;
 
-    delete mListenSocket;
+    if( mBuffer != NULL ) {
+        mBufferStart += numWritten;
+
+        if( mNumPending == 0 ) {
+            mBufferStart = 0;
+            }
+        }
+
+    if( numWritten > 0 ) {
+        mReadBlocked = false;
+        }
+
+    return numWritten;
+    }
+
+
+
+char RelayDirection::pump() {
+
+    char progress = true;
+
+    for( int r=0; r<RELAY_MAX_ROUNDS && progress; r++ ) {
+        progress = false;
+
+        if( wantsRead() ) {
+            int numRead = readSome();
+
+            if( numRead == -1 ) {
+                return false;
+                }
+            if( numRead > 0 ) {
+                progress = true;
+                }
+            }
+
+        if( wantsWrite() ) {
+            int numWritten = writeSome();
+
+            if( numWritten == -1 ) {
+                return false;
+                }
+            if( numWritten > 0 ) {
+                progress = true;
+                }
+            }
+        }
+
+    if( isDone() && ! mOutputShutDown ) {
+        // pass end of input along, other direction may still be open
+        shutdown( mTo->mNativeSocketID, SHUT_WR );
+        mOutputShutDown = true;
+        }
+
+    return true;
+    }
+
+
+
+// true if a socket has a pending error
+static char hasSocketError( Socket *inSocket ) {
+    int error = 0;
+    socklen_t length = sizeof( error );
+
+    if( getsockopt( inSocket->mNativeSocketID, SOL_SOCKET, SO_ERROR,
+                    &error, &length ) == -1 ) {
+        return true;
+        }
+    return ( error != 0 );
     }
 
 
 
 /**
- * Class that handles joining and destroying spawned threads.
+ * A client connection and its forwarded connection, relayed both ways.
  */
-class ThreadManager : public Thread {
+class Connection {
 
     public:
-        ThreadManager();
-        ~ThreadManager();
 
-        void addThread( Thread *inThread );
+        /**
+         * @param inClient, inServer the connected sockets.
+         *   Destroyed when this class is destroyed.
+         * @param inID number for log file names.
+         */
+        Connection( Socket *inClient, Socket *inServer, int inID );
+
+        ~Connection();
+
+
+        // adds both sockets to inPoll, with this as their other data
+        char addToPoll( SocketPoll *inPoll );
+
+        void removeFromPoll( SocketPoll *inPoll );
+
+
+        // handles one of this connection's sockets being ready
+        // returns false if connection should be closed
+        char handle( SocketOrServer *inReady );
 
-        void run();
 
-    private:
-        MutexLock *mLock;
-        SimpleVector< Thread* > *mThreads;
+        // sets what inPoll watches for on each socket, to match what
+        // each direction wants
+        // returns false on failure
+        char updateFlags( SocketPoll *inPoll );
+
+
+        char isDone() {
+            return mToServer->isDone() && mToClient->isDone();
+            }
+
+
+        Socket *mClient;
+        Socket *mServer;
+
+        // set once connection is on list to be destroyed
+        char mClosed;
+
+
+    protected:
+
+        int mID;
+
+        FILE *mSendLogFile;
+        FILE *mReceiveLogFile;
+
+        RelayDirection *mToServer;
+        RelayDirection *mToClient;
+
+        // flags currently set in poll for each socket
+        int mClientFlags;
+        int mServerFlags;
     };
 
 
 
-ThreadManager::ThreadManager()
-    : mLock( new MutexLock() ),
-      mThreads( new SimpleVector< Thread* >() ) {
+Connection::Connection( Socket *inClient, Socket *inServer, int inID )
+    : mClient( inClient ), mServer( inServer ), mClosed( false ),
+      mID( inID ),
+      mSendLogFile( NULL ), mReceiveLogFile( NULL ),
+      mClientFlags( 0 ), mServerFlags( 0 ) {
 
+    if( logTraffic ) {
+        char *fileName = autoSprintf( "s%d.txt", mID );
+        mSendLogFile = fopen( fileName, "wb" );
+        delete [] fileName;
+
+        fileName = autoSprintf( "r%d.txt", mID );
+        mReceiveLogFile = fopen( fileName, "wb" );
+        delete [] fileName;
+        }
+
+    mToServer = new RelayDirection( mClient, mServer, mSendLogFile );
+    mToClient = new RelayDirection( mServer, mClient, mReceiveLogFile );
     }
 
 
-ThreadManager::~ThreadManager() {
 
-    delete mLock;
+Connection::~Connection() {
+    printf( "Connection %d closed, %lld bytes sent, %lld bytes received.\n",
+            mID, mToServer->mNumTransmitted, mToClient->mNumTransmitted );
+
+    delete mToServer;
+    delete mToClient;
 
-    for( int i=0; i<mThreads->size(); i++ ) {
-        Thread *thread = *( mThreads->getElement( mThreads->size() - 1 ) );
-        delete thread;
+    if( mSendLogFile != NULL ) {
+        fclose( mSendLogFile );
         }
-    delete mThreads;
+    if( mReceiveLogFile != NULL ) {
+        fclose( mReceiveLogFile );
+        }
+
+    delete mClient;
+    delete mServer;
     }
 
 
 
-void ThreadManager::addThread( Thread *inThread ) {
-    mLock->lock();
+char Connection::addToPoll( SocketPoll *inPoll ) {
+    if( ! inPoll->addSocket( mClient, (void *)this, mClientFlags ) ) {
+        return false;
+        }
+    if( ! inPoll->addSocket( mServer, (void *)this, mServerFlags ) ) {
+        inPoll->removeSocket( mClient );
+        return false;
+        }
+    return true;
+    }
+
 
-    mThreads->push_back( inThread );
 
-    mLock->unlock();
+void Connection::removeFromPoll( SocketPoll *inPoll ) {
+    inPoll->removeSocket( mClient );
+    inPoll->removeSocket( mServer );
     }
 
 
 
-void ThreadManager::run() {
+char Connection::handle( SocketOrServer *inReady ) {
+    char isClient = ( inReady->sock == mClient );
 
-    while( true ) {
+    // bytes read from ready socket, and bytes written to it
+    RelayDirection *in = mToClient;
+    RelayDirection *out = mToServer;
 
-        Thread *thread = NULL;
-        
-        mLock->lock();
+    if( isClient ) {
+        in = mToServer;
+        out = mToClient;
+        }
 
-        if( mThreads->size() != 0 ) {
-            thread = *( mThreads->getElement( mThreads->size() - 1 ) );
-            mThreads->deleteElement( mThreads->size() - 1 );            
+    if( inReady->readReady ) {
+        if( ! in->wantsRead() && hasSocketError( inReady->sock ) ) {
+            // error reported while not watching for reading
+            return false;
             }
-        mLock->unlock();
+        if( ! in->pump() ) {
+            return false;
+            }
+        }
+
+    if( inReady->writeReady ) {
+        if( ! out->pump() ) {
+            return false;
+            }
+        }
+
+    return true;
+    }
+
+
+
+static int getPollFlags( RelayDirection *inIn, RelayDirection *inOut ) {
+    int flags = 0;
+
+    if( ! inIn->wantsRead() ) {
+        // would just be reported ready over and over until there is room
+        flags |= SOCKET_POLL_NO_READ;
+        }
+    if( inOut->wantsWrite() ) {
+        flags |= SOCKET_POLL_WRITE;
+        }
+    return flags;
+    }
+
 
-        if( thread != NULL ) {
 
-            thread->join();
-            delete thread;
+char Connection::updateFlags( SocketPoll *inPoll ) {
+    int clientFlags = getPollFlags( mToServer, mToClient );
+    int serverFlags = getPollFlags( mToClient, mToServer );
+
+    // only a system call when something changes
+    if( clientFlags != mClientFlags ) {
+        if( ! inPoll->setSocketFlags( mClient, clientFlags ) ) {
+            return false;
             }
-        else {
-            // sleep for 5 seconds if no threads availabel to join
-            sleep( 5000 );
+        mClientFlags = clientFlags;
+        }
+    if( serverFlags != mServerFlags ) {
+        if( ! inPoll->setSocketFlags( mServer, serverFlags ) ) {
+            return false;
             }
+        mServerFlags = serverFlags;
         }
-    
+    return true;
     }
 
 
@@ -293,9 +600,24 @@ void usage( char *inAppName );
 
 
 
-int main( char inNumArgs, char **inArgs ) {
+int main( int inNumArgs, char **inArgs ) {
 
-    if( inNumArgs != 4 ) {
+    int firstArg = 1;
+
+    while( firstArg < inNumArgs && inArgs[ firstArg ][0] == '-' ) {
+        if( strcmp( inArgs[ firstArg ], "-log" ) == 0 ) {
+            logTraffic = true;
+            }
+        else if( strcmp( inArgs[ firstArg ], "-copy" ) == 0 ) {
+            useSplice = false;
+            }
+        else {
+            usage( inArgs[0] );
+            }
+        firstArg++;
+        }
+
+    if( inNumArgs - firstArg != 3 ) {
         usage( inArgs[0] );
         }
 
@@ -303,50 +625,125 @@ int main( char inNumArgs, char **inArgs ) {
     int forwardPort;
     int numRead;
 
-    numRead = sscanf( inArgs[1], "%d", &listenPort );
+    numRead = sscanf( inArgs[ firstArg ], "%d", &listenPort );
     if( numRead != 1 ) {
         usage( inArgs[0] );
         }
 
-    char *forwardAddress = inArgs[2];
-    
-    numRead = sscanf( inArgs[3], "%d", &forwardPort );
+    char *forwardAddressString = inArgs[ firstArg + 1 ];
+
+    numRead = sscanf( inArgs[ firstArg + 2 ], "%d", &forwardPort );
     if( numRead != 1 ) {
         usage( inArgs[0] );
         }
 
-    
-    ThreadManager *manager = new ThreadManager();
-    manager->start();
-    
-    SocketServer *server = new SocketServer( listenPort, 1 );
+    HostAddress *forwardAddress = new HostAddress(
+        stringDuplicate( forwardAddressString ), forwardPort );
+
+
+    SocketServer *server = new SocketServer( listenPort, 100 );
+
+    SocketPoll poll;
+
+    if( ! poll.addSocketServer( server ) ) {
+        printf( "Failed to watch port %d\n", listenPort );
+        return 1;
+        }
+
+    printf( "Waiting for connections on port %d\n", listenPort );
+
+
+    SocketOrServer *ready[ MAX_READY ];
+
+    // destroyed after each batch of ready sockets is handled, since later
+    // ones in the batch may belong to them
+    SimpleVector<Connection *> closedConnections;
 
     int nextID = 1;
-    
+
     while( true ) {
-        printf( "Waiting for connection on port %d\n", listenPort );
-        Socket *listenSocket = server->acceptConnection();
 
-        if( listenSocket != NULL ) {
-            printf( "Connection received.\n" );
-            
-            SendThread *thread = new SendThread( listenSocket,
-                                                 forwardAddress,
-                                                 forwardPort,
-                                                 nextID );
-            nextID++;
+        int numReady = poll.wait( ready, MAX_READY, -1 );
+
+        for( int i=0; i<numReady; i++ ) {
+            SocketOrServer *s = ready[i];
+
+            if( ! s->isSocket ) {
+                // take all waiting connections
+                char timedOut = false;
+
+                Socket *clientSocket = server->acceptConnection( 0,
+                                                                 &timedOut );
+
+                while( clientSocket != NULL ) {
+                    printf( "Connection %d received, connecting to %s:%d\n",
+                            nextID, forwardAddressString, forwardPort );
+
+                    // blocks other connections while connecting
+                    Socket *forwardSocket = SocketClient::connectToServer(
+                        forwardAddress, CONNECT_TIMEOUT_MS );
+
+                    if( forwardSocket == NULL ) {
+                        printf( "Connecting to %s:%d failed\n",
+                                forwardAddressString, forwardPort );
+                        delete clientSocket;
+                        }
+                    else if( ! setNonBlocking( clientSocket ) ||
+                             ! setNonBlocking( forwardSocket ) ) {
+                        printf( "Failed to make sockets non-blocking\n" );
+                        delete clientSocket;
+                        delete forwardSocket;
+                        }
+                    else {
+                        Connection *c = new Connection( clientSocket,
+                                                        forwardSocket,
+                                                        nextID );
+                        if( ! c->addToPoll( &poll ) ) {
+                            printf( "Failed to watch connection %d\n",
+                                    nextID );
+                            delete c;
+                            }
+                        }
+                    nextID++;
+
+                    clientSocket = server->acceptConnection( 0, &timedOut );
+                    }
+
+                if( ! timedOut ) {
+                    printf( "Accepting connection failed.\n" );
+                    }
+                continue;
+                }
 
-            thread->start();
 
-            manager->addThread( thread );
+            Connection *c = (Connection *)( s->otherData );
+
+            if( c->mClosed ) {
+                continue;
+                }
+
+            if( ! c->handle( s ) || c->isDone() ||
+                ! c->updateFlags( &poll ) ) {
+
+                c->mClosed = true;
+                closedConnections.push_back( c );
+                }
             }
-        else {
-            printf( "Accepting connection failed.\n" );
+
+
+        for( int i=0; i<closedConnections.size(); i++ ) {
+            Connection *c = closedConnections.getElementDirect( i );
+
+            c->removeFromPoll( &poll );
+            delete c;
             }
+        closedConnections.deleteAll();
         }
 
+    delete forwardAddress;
     delete server;
-    delete manager;
+
+    return 0;
     }
 
 
@@ -354,10 +751,16 @@ int main( char inNumArgs, char **inArgs ) {
 void usage( char *inAppName ) {
 
 	printf( "Usage:\n" );
-	printf( "\t%s listent_port forward_address forward_port\n", inAppName );
+	printf( "\t%s [-log] [-copy] listen_port forward_address forward_port\n",
+            inAppName );
+
+    printf( "\t-log   save bytes sent and received on each connection in\n"
+            "\t       sN.txt and rN.txt\n" );
+    printf( "\t-copy  move bytes through a buffer, even where they could be\n"
+            "\t       spliced through a pipe without copying\n" );
 
 	printf( "Example:\n" );
 	printf( "\t%s 5888 ftp.domain.com 21\n", inAppName );
-	
+
 	exit( 1 );
 	}
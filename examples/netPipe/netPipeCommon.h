@@ -0,0 +1,277 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+
+// shared by netPipeSender and netPipeReceiver
+
+
+#ifndef NET_PIPE_COMMON_INCLUDED
+#define NET_PIPE_COMMON_INCLUDED
+
+
+#include "minorGems/system/Semaphore.h"
+#include "minorGems/system/Time.h"
+#include "minorGems/util/SimpleVector.h"
+
+
+#include <stdio.h>
+#include <stdlib.h>
+
+
+
+// in KiB
+#define DEFAULT_BUFFER_SIZE 1024
+
+// one being filled while the other is emptied
+#define NUM_PIPE_BUFFERS 2
+
+// seconds between live progress lines
+#define PROGRESS_INTERVAL 0.5
+
+// compressed data is fed to the decompressor in slices this big, which
+// limits how much output one slice can expand into
+#define DECOMPRESS_SLICE_SIZE 16384
+
+
+
+typedef struct PipeBuffer {
+        unsigned char *bytes;
+
+        // bytes used
+        int length;
+
+        // when compressing, the data to send instead of bytes
+        SimpleVector<unsigned char> compressed;
+
+        // uncompressed bytes this buffer stands for
+        int rawLength;
+
+        // last buffer of the stream (may still hold data)
+        char endOfStream;
+    } PipeBuffer;
+
+
+
+/**
+ * Fixed set of buffers handed back and forth between a thread that fills
+ * them and a thread that empties them, in the same order both ways.
+ *
+ * Each side only ever blocks when all buffers are on the other side.
+ */
+class PipeBufferQueue {
+
+    public:
+
+        /**
+         * @param inNumBuffers the number of buffers.
+         * @param inBufferSize the size of each buffer in bytes.
+         */
+        PipeBufferQueue( int inNumBuffers, int inBufferSize );
+
+        ~PipeBufferQueue();
+
+
+        // for the filling thread:
+        // waits for a buffer to fill, and then passes it on when full
+        PipeBuffer *getEmpty();
+        void putFull( PipeBuffer *inBuffer );
+
+        // for the emptying thread
+        PipeBuffer *getFull();
+        void putEmpty( PipeBuffer *inBuffer );
+
+
+    protected:
+
+        PipeBuffer *mBuffers;
+        int mNumBuffers;
+
+        // each only touched by one of the threads
+        int mNextEmpty;
+        int mNextFull;
+
+        Semaphore mNumEmpty;
+        Semaphore mNumFull;
+    };
+
+
+
+inline PipeBufferQueue::PipeBufferQueue( int inNumBuffers, int inBufferSize )
+    : mBuffers( new PipeBuffer[ inNumBuffers ] ),
+      mNumBuffers( inNumBuffers ),
+      mNextEmpty( 0 ), mNextFull( 0 ),
+      mNumEmpty( inNumBuffers ), mNumFull( 0 ) {
+
+    for( int i=0; i<mNumBuffers; i++ ) {
+        mBuffers[i].bytes = new unsigned char[ inBufferSize ];
+        mBuffers[i].length = 0;
+        mBuffers[i].rawLength = 0;
+        mBuffers[i].endOfStream = false;
+        }
+    }
+
+
+
+inline PipeBufferQueue::~PipeBufferQueue() {
+    for( int i=0; i<mNumBuffers; i++ ) {
+        delete [] mBuffers[i].bytes;
+        }
+    delete [] mBuffers;
+    }
+
+
+
+inline PipeBuffer *PipeBufferQueue::getEmpty() {
+    mNumEmpty.wait();
+
+    PipeBuffer *b = &( mBuffers[ mNextEmpty ] );
+    mNextEmpty = ( mNextEmpty + 1 ) % mNumBuffers;
+
+    b->length = 0;
+    b->rawLength = 0;
+    b->endOfStream = false;
+    b->compressed.deleteAll();
+
+    return b;
+    }
+
+
+
+inline void PipeBufferQueue::putFull( PipeBuffer *inBuffer ) {
+    mNumFull.signal();
+    }
+
+
+
+inline PipeBuffer *PipeBufferQueue::getFull() {
+    mNumFull.wait();
+
+    PipeBuffer *b = &( mBuffers[ mNextFull ] );
+    mNextFull = ( mNextFull + 1 ) % mNumBuffers;
+
+    return b;
+    }
+
+
+
+inline void PipeBufferQueue::putEmpty( PipeBuffer *inBuffer ) {
+    mNumEmpty.signal();
+    }
+
+
+
+
+/**
+ * Prints live progress and throughput to stderr, like pv does, and a
+ * summary at the end.
+ */
+class ProgressMeter {
+
+    public:
+
+        // inShowLive false to only print summary
+        ProgressMeter( char inShowLive );
+
+
+        // adds bytes moved since last call
+        // inRawBytes is uncompressed data, inWireBytes is what went over
+        // the network
+        void add( int inRawBytes, int inWireBytes );
+
+
+        void printSummary();
+
+
+    protected:
+
+        char mShowLive;
+
+        double mStartTime;
+
+        double mLastPrintTime;
+        double mRawBytesAtLastPrint;
+
+        double mRawBytes;
+        double mWireBytes;
+    };
+
+
+
+inline ProgressMeter::ProgressMeter( char inShowLive )
+    : mShowLive( inShowLive ),
+      mStartTime( Time::getMonotonicTime() ),
+      mLastPrintTime( mStartTime ),
+      mRawBytesAtLastPrint( 0 ),
+      mRawBytes( 0 ), mWireBytes( 0 ) {
+    }
+
+
+
+inline void ProgressMeter::add( int inRawBytes, int inWireBytes ) {
+    mRawBytes += inRawBytes;
+    mWireBytes += inWireBytes;
+
+    if( ! mShowLive ) {
+        return;
+        }
+
+    double time = Time::getMonotonicTime();
+
+    double sinceLastPrint = time - mLastPrintTime;
+
+    if( sinceLastPrint < PROGRESS_INTERVAL ) {
+        return;
+        }
+
+    double rate = ( mRawBytes - mRawBytesAtLastPrint ) / sinceLastPrint;
+
+    fprintf( stderr, "\r%10.1f MB  %8.1f MB/s  ",
+             mRawBytes / 1000000, rate / 1000000 );
+
+    mLastPrintTime = time;
+    mRawBytesAtLastPrint = mRawBytes;
+    }
+
+
+
+inline void ProgressMeter::printSummary() {
+    double elapsed = Time::getMonotonicTime() - mStartTime;
+
+    if( elapsed <= 0 ) {
+        elapsed = 0.001;
+        }
+
+    if( mShowLive ) {
+        // end live line
+        fprintf( stderr, "\n" );
+        }
+
+    fprintf( stderr, "%.0f bytes in %.2f seconds, %.1f MB/s\n",
+             mRawBytes, elapsed, mRawBytes / elapsed / 1000000 );
+
+    if( mWireBytes != mRawBytes && mRawBytes > 0 ) {
+        fprintf( stderr, "%.0f bytes over network (%.1f%%)\n",
+                 mWireBytes, 100 * mWireBytes / mRawBytes );
+        }
+    }
+
+
+
+// parses a buffer size in KiB
+// returns size in bytes, or -1 if invalid
+inline int parseBufferSize( char *inArg ) {
+    int kib;
+
+    if( sscanf( inArg, "%d", &kib ) != 1 || kib < 1 || kib > 1024 * 1024 ) {
+        return -1;
+        }
+    return kib * 1024;
+    }
+
+
+
+#endif
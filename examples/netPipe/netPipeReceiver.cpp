@@ -2,18 +2,25 @@
  * Modification History
  *
  * 2001-August-02   Jason Rohrer
- * Created.  
+ * Created.
  *
  * 2002-June-1    Jason Rohrer
- * Added a missing include.  
+ * Added a missing include.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Large buffers (set with -b), received while the previous buffer is
+ * written out on a separate thread.
+ * Decompression with -z, for a sender using -z.
+ * Messages now go to stderr, so they don't end up in piped output.
+ * Live progress and throughput on stderr.
  */
 
+#include "netPipeCommon.h"
+
 #include "minorGems/network/SocketServer.h"
 #include "minorGems/network/Socket.h"
-#include "minorGems/network/SocketStream.h"
-
-#include "minorGems/io/file/File.h"
-#include "minorGems/io/file/FileOutputStream.h"
+#include "minorGems/system/Thread.h"
+#include "minorGems/formats/ZipStream.h"
 
 
 #include <string.h>
@@ -21,108 +28,265 @@
 #include <stdlib.h>
 
 
-#define BUFFER_SIZE 5000
-
 
 void usage( char *inAppName );
 
 
-int main( char inNumArgs, char **inArgs ) {
 
-	if( inNumArgs < 2 ) {
-		usage( inArgs[0] );
-		}
-	if( inNumArgs > 3 ) {
+/**
+ * Writes out buffers, decompressing them if asked to, while the main
+ * thread receives the next ones.
+ */
+class OutputWriter : public Thread {
+
+    public:
+
+        // inDecompressor is NULL to write data as-is
+        // inQueue, inOutput, and inDecompressor destroyed by caller
+        OutputWriter( PipeBufferQueue *inQueue, FILE *inOutput,
+                      ZipDecompressor *inDecompressor, char inShowProgress );
+
+        void run();
+
+        unsigned long mChecksum;
+
+        char mFailed;
+
+
+    protected:
+
+        PipeBufferQueue *mQueue;
+        FILE *mOutput;
+        ZipDecompressor *mDecompressor;
+
+        ProgressMeter mMeter;
+
+        // returns false on failure
+        char write( unsigned char *inBytes, int inLength );
+    };
+
+
+
+OutputWriter::OutputWriter( PipeBufferQueue *inQueue, FILE *inOutput,
+                            ZipDecompressor *inDecompressor,
+                            char inShowProgress )
+    : mChecksum( 0 ), mFailed( false ),
+      mQueue( inQueue ), mOutput( inOutput ),
+      mDecompressor( inDecompressor ),
+      mMeter( inShowProgress ) {
+    }
+
+
+
+char OutputWriter::write( unsigned char *inBytes, int inLength ) {
+    for( int i=0; i<inLength; i++ ) {
+        mChecksum += inBytes[i];
+        }
+
+    return ( (int)fwrite( inBytes, 1, inLength, mOutput ) == inLength );
+    }
+
+
+
+void OutputWriter::run() {
+    SimpleVector<unsigned char> decompressed;
+
+    char done = false;
+
+    while( ! done ) {
+        PipeBuffer *b = mQueue->getFull();
+
+        done = b->endOfStream;
+
+        // keep taking buffers after a failure, so receiving isn't stuck
+        // waiting for an empty one
+        if( ! mFailed ) {
+            int rawLength = b->length;
+
+            if( mDecompressor == NULL ) {
+                mFailed = ! write( b->bytes, b->length );
+                }
+            else {
+                rawLength = 0;
+
+                for( int i=0; i<b->length && ! mFailed;
+                     i += DECOMPRESS_SLICE_SIZE ) {
+
+                    int sliceLength = b->length - i;
+                    if( sliceLength > DECOMPRESS_SLICE_SIZE ) {
+                        sliceLength = DECOMPRESS_SLICE_SIZE;
+                        }
+
+                    if( ! mDecompressor->decompress( &( b->bytes[i] ),
+                                                     sliceLength,
+                                                     &decompressed ) ) {
+                        fprintf( stderr, "\ncorrupt compressed data (does "
+                                 "sender use -z?)\n" );
+                        mFailed = true;
+                        }
+                    else if( decompressed.size() > 0 ) {
+                        rawLength += decompressed.size();
+
+                        mFailed = ! write( decompressed.getElement( 0 ),
+                                           decompressed.size() );
+                        decompressed.deleteAll();
+                        }
+                    }
+
+                if( done && ! mFailed && ! mDecompressor->isFinished() ) {
+                    fprintf( stderr, "\ncompressed data cut off\n" );
+                    mFailed = true;
+                    }
+                }
+
+            mMeter.add( rawLength, b->length );
+            }
+
+        mQueue->putEmpty( b );
+        }
+
+    fflush( mOutput );
+
+    mMeter.printSummary();
+    }
+
+
+
+int main( int inNumArgs, char **inArgs ) {
+
+    int bufferSize = DEFAULT_BUFFER_SIZE * 1024;
+    char decompress = false;
+    char showProgress = true;
+
+    int firstArg = 1;
+
+    while( firstArg < inNumArgs && inArgs[ firstArg ][0] == '-' ) {
+        char *option = inArgs[ firstArg ];
+
+        if( strcmp( option, "-q" ) == 0 ) {
+            showProgress = false;
+            }
+        else if( strcmp( option, "-z" ) == 0 ) {
+            decompress = true;
+            }
+        else if( strcmp( option, "-b" ) == 0 && firstArg + 1 < inNumArgs ) {
+            firstArg++;
+            bufferSize = parseBufferSize( inArgs[ firstArg ] );
+
+            if( bufferSize == -1 ) {
+                usage( inArgs[0] );
+                }
+            }
+        else {
+            usage( inArgs[0] );
+            }
+        firstArg++;
+        }
+
+    int numArgsLeft = inNumArgs - firstArg;
+
+	if( numArgsLeft < 1 || numArgsLeft > 2 ) {
 		usage( inArgs[0] );
 		}
-	char useFile = true;
-	if( inNumArgs != 3 ) {
-		useFile = false;
-		}
 
-	long port;
-	int numRead = sscanf( inArgs[1], "%d", &port );
+	int port;
+	int numRead = sscanf( inArgs[ firstArg ], "%d", &port );
 
 	if( numRead != 1 ) {
-		printf( "port number must be a valid integer:  %s\n", inArgs[2] );
+		fprintf( stderr, "port number must be a valid integer:  %s\n",
+                 inArgs[ firstArg ] );
 		usage( inArgs[0] );
 		}
 
-	File *outFile;
-	FileOutputStream *outStream;
+	FILE *output = stdout;
+
+	if( numArgsLeft == 2 ) {
+		output = fopen( inArgs[ firstArg + 1 ], "wb" );
 
-	if( useFile ) {
-		outFile = new File( NULL, inArgs[2],
-							strlen( inArgs[2] ) );
-		
-		outStream = new FileOutputStream( outFile );
+        if( output == NULL ) {
+            fprintf( stderr, "failed to open %s\n", inArgs[ firstArg + 1 ] );
+            return 1;
+            }
 		}
-   
+
 	SocketServer *server = new SocketServer( port, 1 );
-	
-	printf( "listening for a connection on port %d\n", port );
+
+	fprintf( stderr, "listening for a connection on port %d\n", port );
 	Socket *sock = server->acceptConnection();
 
 	if( sock == NULL ) {
-		printf( "socket connection failed\n" );
+		fprintf( stderr, "socket connection failed\n" );
 		return( 1 );
 		}
-	printf( "connection received\n" );
-	
-	
-	SocketStream *inStream = new SocketStream( sock );
-
-	
-	unsigned long checksum = 0;
-
-	unsigned char *buffer = new unsigned char[ BUFFER_SIZE ];
-	
-
-	numRead = BUFFER_SIZE;
-	int numWritten = BUFFER_SIZE;
-	
-	while( numWritten == numRead && numRead == BUFFER_SIZE ) {
-
-		// read a buffer full of data from standard in
-		numRead = inStream->read( buffer, BUFFER_SIZE );
-
-		// add the buffer to our checksum
-		for( int i=0; i<numRead; i++ ) {
-			checksum += buffer[i];
-			}
-
-
-		if( useFile ) {
-			// write the buffer out to our file stream
-			numWritten = outStream->write( buffer, numRead );
-			}
-		else {
-			// write to std out
-			numWritten = fwrite( buffer, 1, numRead, stdout );
-			}
-		}
+	fprintf( stderr, "connection received\n" );
+
 
-	
+    ZipDecompressor *decompressor = NULL;
 
-	if( numRead != numWritten ) {
-		printf( "file output failed\n" );
+    if( decompress ) {
+        decompressor = new ZipDecompressor();
+        }
+
+    PipeBufferQueue queue( NUM_PIPE_BUFFERS, bufferSize );
+
+    OutputWriter *writer = new OutputWriter( &queue, output, decompressor,
+                                             showProgress );
+    writer->start();
+
+
+    char receiveFailed = false;
+    char done = false;
+
+    while( ! done ) {
+        PipeBuffer *b = queue.getEmpty();
+
+        // blocks until buffer is full, or connection closes
+        int numReceived = sock->receive( b->bytes, bufferSize, -1 );
+
+        if( numReceived < bufferSize ) {
+            if( numReceived < 0 ) {
+                receiveFailed = true;
+                numReceived = 0;
+                }
+            b->endOfStream = true;
+            done = true;
+            }
+
+        b->length = numReceived;
+
+        queue.putFull( b );
+        }
+
+    writer->join();
+
+    if( receiveFailed ) {
+		fprintf( stderr, "network connection failed during transmission\n" );
+        }
+
+	if( writer->mFailed ) {
+		fprintf( stderr, "output failed\n" );
 		}
-	
 
-	
-	printf( "checksum = %d\n", checksum );
+	fprintf( stderr, "checksum = %lu\n", writer->mChecksum );
+
+    char failed = receiveFailed || writer->mFailed;
+
+    delete writer;
 
+    if( decompressor != NULL ) {
+        delete decompressor;
+        }
 
 	delete sock;
 	delete server;
-	delete inStream;
-	if( useFile ) {
-		delete outStream;
-		delete outFile;
+
+	if( output != stdout ) {
+		fclose( output );
 		}
-	
-	delete [] buffer;
-	
+
+    if( failed ) {
+        return 1;
+        }
 	return 0;
 	}
 
@@ -130,12 +294,18 @@ int main( char inNumArgs, char **inArgs ) {
 
 void usage( char *inAppName ) {
 
-	printf( "Usage:\n" );
-	printf( "\t%s receiver_port [output_file_name]\n", inAppName );
+	fprintf( stderr, "Usage:\n" );
+	fprintf( stderr, "\t%s [-b buffer_kib] [-z] [-q] "
+             "receiver_port [output_file_name]\n", inAppName );
+
+    fprintf( stderr, "\t-b  size of each of two buffers, in KiB "
+             "(default %d)\n", DEFAULT_BUFFER_SIZE );
+    fprintf( stderr, "\t-z  decompress (sender needs -z too)\n" );
+    fprintf( stderr, "\t-q  no live progress\n" );
+
+	fprintf( stderr, "Examples:\n" );
+	fprintf( stderr, "\t%s 5888 myarchive.tar\n", inAppName );
+	fprintf( stderr, "\t%s -z 5888 | psql mydb\n", inAppName );
 
-	printf( "Examples:\n" );
-	printf( "\t%s 5888 myarchive.tar\n", inAppName );
-	printf( "\t%s 5888 \n", inAppName );
-	
 	exit( 1 );
 	}
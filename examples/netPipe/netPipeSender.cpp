@@ -2,130 +2,278 @@
  * Modification History
  *
  * 2001-August-02   Jason Rohrer
- * Created.  
+ * Created.
  *
  * 2001-December-12		Jason Rohrer
  * Changed to use new HostAddress constructor.
  *
  * 2002-June-1   Jason Rohrer
  * Added support for timing the transmission.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Large buffers (set with -b), read from stdin on a separate thread while
+ * the previous buffer is sent.
+ * Optional compression with -z.
+ * Live progress and throughput on stderr.
  */
 
+#include "netPipeCommon.h"
+
 #include "minorGems/network/SocketClient.h"
 #include "minorGems/network/Socket.h"
-#include "minorGems/network/SocketStream.h"
 #include "minorGems/network/HostAddress.h"
-#include "minorGems/system/Time.h"
+#include "minorGems/system/Thread.h"
+#include "minorGems/formats/ZipStream.h"
 
 
 
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 
-#define BUFFER_SIZE 5000
-
 
 void usage( char *inAppName );
 
 
-int main( char inNumArgs, char **inArgs ) {
 
-	if( inNumArgs != 3 ) {
+/**
+ * Fills buffers from stdin, compressing them if asked to, while the main
+ * thread sends the ones filled before.
+ */
+class StdinReader : public Thread {
+
+    public:
+
+        // inCompressor is NULL to send data as-is
+        // inCompressor and inQueue destroyed by caller
+        StdinReader( PipeBufferQueue *inQueue, int inBufferSize,
+                     ZipCompressor *inCompressor );
+
+        void run();
+
+        unsigned long mChecksum;
+
+        char mFailed;
+
+
+    protected:
+
+        PipeBufferQueue *mQueue;
+        int mBufferSize;
+        ZipCompressor *mCompressor;
+    };
+
+
+
+StdinReader::StdinReader( PipeBufferQueue *inQueue, int inBufferSize,
+                          ZipCompressor *inCompressor )
+    : mChecksum( 0 ), mFailed( false ),
+      mQueue( inQueue ), mBufferSize( inBufferSize ),
+      mCompressor( inCompressor ) {
+    }
+
+
+
+void StdinReader::run() {
+    char done = false;
+
+    while( ! done ) {
+        PipeBuffer *b = mQueue->getEmpty();
+
+        // only short at end of input
+        int numRead = fread( b->bytes, 1, mBufferSize, stdin );
+
+        if( numRead < mBufferSize ) {
+            if( ferror( stdin ) ) {
+                mFailed = true;
+                }
+            b->endOfStream = true;
+            done = true;
+            }
+
+        unsigned char *bytes = b->bytes;
+        for( int i=0; i<numRead; i++ ) {
+            mChecksum += bytes[i];
+            }
+
+        b->length = numRead;
+        b->rawLength = numRead;
+
+        if( mCompressor != NULL ) {
+            ZipFlush flush = ZIP_NO_FLUSH;
+            if( done ) {
+                flush = ZIP_FINISH;
+                }
+
+            if( ! mCompressor->compress( bytes, numRead, &( b->compressed ),
+                                         flush ) ) {
+                mFailed = true;
+                b->endOfStream = true;
+                done = true;
+                }
+            }
+
+        mQueue->putFull( b );
+        }
+    }
+
+
+
+int main( int inNumArgs, char **inArgs ) {
+
+    int bufferSize = DEFAULT_BUFFER_SIZE * 1024;
+    int compressionLevel = -1;
+    char showProgress = true;
+
+    int firstArg = 1;
+
+    while( firstArg < inNumArgs && inArgs[ firstArg ][0] == '-' ) {
+        char *option = inArgs[ firstArg ];
+
+        if( strcmp( option, "-q" ) == 0 ) {
+            showProgress = false;
+            }
+        else if( strcmp( option, "-b" ) == 0 && firstArg + 1 < inNumArgs ) {
+            firstArg++;
+            bufferSize = parseBufferSize( inArgs[ firstArg ] );
+
+            if( bufferSize == -1 ) {
+                usage( inArgs[0] );
+                }
+            }
+        else if( strcmp( option, "-z" ) == 0 && firstArg + 1 < inNumArgs ) {
+            firstArg++;
+            if( sscanf( inArgs[ firstArg ], "%d", &compressionLevel ) != 1 ||
+                compressionLevel < 0 || compressionLevel > 10 ) {
+                usage( inArgs[0] );
+                }
+            }
+        else {
+            usage( inArgs[0] );
+            }
+        firstArg++;
+        }
+
+	if( inNumArgs - firstArg != 2 ) {
 		usage( inArgs[0] );
 		}
 
-	long port;
-	int numRead = sscanf( inArgs[2], "%d", &port );
+	int port;
+	int numRead = sscanf( inArgs[ firstArg + 1 ], "%d", &port );
 
 	if( numRead != 1 ) {
-		printf( "port number must be a valid integer:  %s\n", inArgs[2] );
+		fprintf( stderr, "port number must be a valid integer:  %s\n",
+                 inArgs[ firstArg + 1 ] );
 		usage( inArgs[0] );
 		}
 
-	int addressLength = strlen( inArgs[1] );
+	int addressLength = strlen( inArgs[ firstArg ] );
 	char *copiedArg = new char[ addressLength + 1 ];
-	strcpy( copiedArg, inArgs[1] );
-	
+	strcpy( copiedArg, inArgs[ firstArg ] );
+
 	HostAddress *receiverAddress =
-		new HostAddress( copiedArg, port ); 
+		new HostAddress( copiedArg, port );
+
+	fprintf( stderr, "connecting to host:  %s:%d\n", copiedArg, port );
 
-	printf( "connecting to host:  " );
-	receiverAddress->print();
-	printf( "\n" );
 	Socket *sock = SocketClient::connectToServer( receiverAddress );
 
-	
+
 	if( sock == NULL ) {
-		printf( "connection to host failed\n" );
+		fprintf( stderr, "connection to host failed\n" );
 		return( 1 );
 		}
 
-	printf( "connection successful\n" );
-	
-	SocketStream *outStream = new SocketStream( sock );
+	fprintf( stderr, "connection successful\n" );
 
-	
-	unsigned long checksum = 0;
 
-	unsigned char *buffer = new unsigned char[ BUFFER_SIZE ];
-	
+    ZipCompressor *compressor = NULL;
 
-	numRead = BUFFER_SIZE;
-	int numWritten = BUFFER_SIZE;
+    if( compressionLevel != -1 ) {
+        compressor = new ZipCompressor( compressionLevel );
+        }
 
-    int bytesSent = 0;
+    PipeBufferQueue queue( NUM_PIPE_BUFFERS, bufferSize );
 
-    unsigned long seconds;
-    unsigned long milliseconds;
+    StdinReader *reader = new StdinReader( &queue, bufferSize, compressor );
 
-    Time::getCurrentTime( &seconds, &milliseconds );
-    
-    
-	while( numWritten == numRead && numRead == BUFFER_SIZE ) {
+    ProgressMeter meter( showProgress );
 
-		// read a buffer full of data from standard in
-		numRead = fread( buffer, 1, BUFFER_SIZE, stdin ); 
+    reader->start();
 
-		// add the buffer to our checksum
-		for( int i=0; i<numRead; i++ ) {
-			checksum += buffer[i];
-			}
 
-		
-		// write the buffer out to our network stream
-		numWritten = outStream->write( buffer, numRead );
+    char sendFailed = false;
+    char done = false;
 
-        bytesSent += numWritten;
-		}
+    while( ! done ) {
+        PipeBuffer *b = queue.getFull();
 
-    unsigned long elapsedMilliseconds =
-        Time::getMillisecondsSince(
-            seconds,
-            milliseconds );
+        unsigned char *data = b->bytes;
+        int length = b->length;
 
-    float elapsedSeconds = ( (float)elapsedMilliseconds ) / 1000;
-    
-    float bytesPerSec = (float)bytesSent / elapsedSeconds;
+        if( compressor != NULL ) {
+            length = b->compressed.size();
+            if( length > 0 ) {
+                data = b->compressed.getElement( 0 );
+                }
+            }
 
-    printf( "%.2f second elapsed\n", elapsedSeconds );
-    printf( "%.2f bytes per second\n", bytesPerSec );
+        int numSent = 0;
 
-	if( numRead != numWritten ) {
-		printf( "network connection failed during transmission\n" );
-		}
-	
+        while( numSent < length ) {
+            int result = sock->send( &( data[ numSent ] ),
+                                     length - numSent );
+            if( result <= 0 ) {
+                break;
+                }
+            numSent += result;
+            }
+
+        meter.add( b->rawLength, numSent );
 
-	
-	printf( "checksum = %d\n", checksum );
+        done = b->endOfStream;
 
+        queue.putEmpty( b );
+
+        if( numSent < length ) {
+            sendFailed = true;
+            break;
+            }
+        }
+
+    meter.printSummary();
+
+    if( sendFailed ) {
+		fprintf( stderr, "network connection failed during transmission\n" );
+
+        // reader may be blocked on stdin or on a buffer, and can't be
+        // joined
+        return 1;
+        }
+
+    reader->join();
+
+    char failed = reader->mFailed;
+
+    if( failed ) {
+        fprintf( stderr, "reading or compressing input failed\n" );
+        }
+
+	fprintf( stderr, "checksum = %lu\n", reader->mChecksum );
+
+    delete reader;
+
+    if( compressor != NULL ) {
+        delete compressor;
+        }
 
 	delete receiverAddress;
 	delete sock;
-	delete outStream;
-	
-	delete [] buffer;
-	
+
+    if( failed ) {
+        return 1;
+        }
 	return 0;
 	}
 
@@ -133,12 +281,20 @@ int main( char inNumArgs, char **inArgs ) {
 
 void usage( char *inAppName ) {
 
-	printf( "Usage:\n" );
-	printf( "\t%s receiver_address receiver_port\n", inAppName );
+	fprintf( stderr, "Usage:\n" );
+	fprintf( stderr, "\t%s [-b buffer_kib] [-z level] [-q] "
+             "receiver_address receiver_port\n", inAppName );
+
+    fprintf( stderr, "\t-b  size of each of two buffers, in KiB "
+             "(default %d)\n", DEFAULT_BUFFER_SIZE );
+    fprintf( stderr, "\t-z  compress at a level from 0 to 10 "
+             "(receiver needs -z too)\n" );
+    fprintf( stderr, "\t-q  no live progress\n" );
+
+	fprintf( stderr, "Examples:\n" );
+	fprintf( stderr, "\t%s 192.168.1.2 5888\n", inAppName );
+	fprintf( stderr, "\t%s -z 1 myhost.mydomain.com 5888 < dump.sql\n",
+             inAppName );
 
-	printf( "Examples:\n" );
-	printf( "\t%s 192.168.1.2 5888\n", inAppName );
-	printf( "\t%s myhost.mydomain.com 5888\n", inAppName );
-	
 	exit( 1 );
 	}
@@ -0,0 +1,276 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14   Jason Rohrer
+ * Created.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Added raw deflate streams without a dictionary.
+ */
+
+
+
+#include "ZipStream.h"
+
+
+// miniz's zlib names are macros (compress, uncompress, ...) that would
+// clash with our method names
+#define MINIZ_NO_ZLIB_COMPATIBLE_NAMES
+
+// only the declarations, miniz.c itself is compiled into encodingUtils
+#include "minorGems/formats/miniz.h"
+
+
+#include <string.h>
+
+
+
+// window that both the deflate dictionary and the inflate output wrap in
+#define ZIP_WINDOW_SIZE TINFL_LZ_DICT_SIZE
+
+
+
+ZipCompressor::ZipCompressor( int inLevel, ZipStrategy inStrategy,
+                              const unsigned char *inDictionary,
+                              int inDictionaryLength,
+                              char inRawDeflate )
+        : mPrimedState( NULL ), mOutput( NULL ) {
+
+    mState = (void *)( new tdefl_compressor );
+
+    char useDictionary = ( inDictionary != NULL && inDictionaryLength > 0 );
+
+    // positive window bits ask for zlib header, negative for raw deflate
+    // (preset dictionaries only work on raw deflate, since tinfl doesn't
+    //  handle zlib's FDICT flag)
+    int windowBits = 15;
+    if( useDictionary || inRawDeflate ) {
+        windowBits = -15;
+        }
+
+    mFlags = (int)tdefl_create_comp_flags_from_zip_params( inLevel,
+                                                           windowBits,
+                                                           inStrategy );
+
+    reset();
+
+    if( useDictionary ) {
+        // anything before the last window can never be matched
+        if( inDictionaryLength > ZIP_WINDOW_SIZE ) {
+            inDictionary =
+                &( inDictionary[ inDictionaryLength - ZIP_WINDOW_SIZE ] );
+            inDictionaryLength = ZIP_WINDOW_SIZE;
+            }
+
+        // compress dictionary and throw output away, leaving its data
+        // in tdefl's window and hash chains
+        // sync flush ends on a byte boundary between blocks, so what
+        // follows is a valid raw deflate stream on its own
+        mOutput = NULL;
+        tdefl_compress_buffer( (tdefl_compressor *)mState,
+                               inDictionary, inDictionaryLength,
+                               TDEFL_SYNC_FLUSH );
+
+        // tdefl's internal pointers point into mState itself, so this
+        // snapshot is only valid when copied back over mState
+        mPrimedState = (void *)( new tdefl_compressor );
+        memcpy( mPrimedState, mState, sizeof( tdefl_compressor ) );
+        }
+    }
+
+
+
+ZipCompressor::~ZipCompressor() {
+    delete (tdefl_compressor *)mState;
+
+    if( mPrimedState != NULL ) {
+        delete (tdefl_compressor *)mPrimedState;
+        }
+    }
+
+
+
+int ZipCompressor::putBuffer( const void *inBuffer, int inLength,
+                              void *inCompressor ) {
+    ZipCompressor *c = (ZipCompressor *)inCompressor;
+
+    if( c->mOutput != NULL ) {
+        c->mOutput->push_back( (unsigned char *)inBuffer, inLength );
+        }
+    return true;
+    }
+
+
+
+void ZipCompressor::reset() {
+    if( mPrimedState != NULL ) {
+        memcpy( mState, mPrimedState, sizeof( tdefl_compressor ) );
+        }
+    else {
+        tdefl_init( (tdefl_compressor *)mState, putBuffer, (void *)this,
+                    mFlags );
+        }
+    }
+
+
+
+char ZipCompressor::compress( const unsigned char *inData, int inLength,
+                              SimpleVector<unsigned char> *outCompressed,
+                              ZipFlush inFlush ) {
+    mOutput = outCompressed;
+
+    tdefl_status status =
+        tdefl_compress_buffer( (tdefl_compressor *)mState,
+                               inData, inLength, (tdefl_flush)inFlush );
+
+    mOutput = NULL;
+
+    if( status < TDEFL_STATUS_OKAY ) {
+        reset();
+        return false;
+        }
+
+    if( inFlush == ZIP_FINISH ) {
+        reset();
+        }
+
+    return true;
+    }
+
+
+
+char ZipCompressor::finish( SimpleVector<unsigned char> *outCompressed ) {
+    return compress( NULL, 0, outCompressed, ZIP_FINISH );
+    }
+
+
+
+
+ZipDecompressor::ZipDecompressor( const unsigned char *inDictionary,
+                                  int inDictionaryLength )
+        : mPrimedWindow( NULL ) {
+
+    mState = (void *)( new tinfl_decompressor );
+
+    mWindow = new unsigned char[ ZIP_WINDOW_SIZE ];
+
+    if( inDictionary != NULL && inDictionaryLength > 0 ) {
+        // decoding starts at window position 0, so the dictionary goes
+        // at the end, where back-references wrap around to find it
+        mPrimedWindow = new unsigned char[ ZIP_WINDOW_SIZE ];
+        memset( mPrimedWindow, 0, ZIP_WINDOW_SIZE );
+
+        if( inDictionaryLength > ZIP_WINDOW_SIZE ) {
+            inDictionary =
+                &( inDictionary[ inDictionaryLength - ZIP_WINDOW_SIZE ] );
+            inDictionaryLength = ZIP_WINDOW_SIZE;
+            }
+
+        memcpy( &( mPrimedWindow[ ZIP_WINDOW_SIZE - inDictionaryLength ] ),
+                inDictionary, inDictionaryLength );
+        }
+
+    reset();
+    }
+
+
+
+ZipDecompressor::~ZipDecompressor() {
+    delete (tinfl_decompressor *)mState;
+
+    delete [] mWindow;
+
+    if( mPrimedWindow != NULL ) {
+        delete [] mPrimedWindow;
+        }
+    }
+
+
+
+void ZipDecompressor::reset() {
+    tinfl_init( (tinfl_decompressor *)mState );
+
+    if( mPrimedWindow != NULL ) {
+        memcpy( mWindow, mPrimedWindow, ZIP_WINDOW_SIZE );
+        }
+
+    mWindowPos = 0;
+    mFinished = false;
+    mFailed = false;
+    }
+
+
+
+char ZipDecompressor::isFinished() {
+    return mFinished;
+    }
+
+
+
+char ZipDecompressor::decompress( const unsigned char *inCompressed,
+                                  int inLength,
+                                  SimpleVector<unsigned char> *outData,
+                                  int inMaxOutputLength ) {
+    if( mFailed ) {
+        return false;
+        }
+    if( mFinished ) {
+        return true;
+        }
+
+    // no window wrapping flag, so tinfl treats mWindow as circular
+    // we never know whether more chunks are coming, so end of stream
+    // comes from the stream itself
+    mz_uint32 flags = TINFL_FLAG_HAS_MORE_INPUT;
+
+    if( mPrimedWindow == NULL ) {
+        flags |= TINFL_FLAG_PARSE_ZLIB_HEADER;
+        }
+
+    int numAppended = 0;
+
+    while( true ) {
+        size_t inSize = inLength;
+        size_t outSize = ZIP_WINDOW_SIZE - mWindowPos;
+
+        tinfl_status status =
+            tinfl_decompress( (tinfl_decompressor *)mState,
+                              inCompressed, &inSize,
+                              mWindow, &( mWindow[ mWindowPos ] ), &outSize,
+                              flags );
+
+        inCompressed = &( inCompressed[ inSize ] );
+        inLength -= inSize;
+
+        if( outSize > 0 ) {
+            numAppended += outSize;
+
+            if( inMaxOutputLength >= 0 && numAppended > inMaxOutputLength ) {
+                mFailed = true;
+                return false;
+                }
+
+            outData->push_back( &( mWindow[ mWindowPos ] ), outSize );
+
+            mWindowPos = ( mWindowPos + outSize ) & ( ZIP_WINDOW_SIZE - 1 );
+            }
+
+        if( status < TINFL_STATUS_DONE ) {
+            mFailed = true;
+            return false;
+            }
+
+        if( status == TINFL_STATUS_DONE ) {
+            mFinished = true;
+            return true;
+            }
+
+        if( status == TINFL_STATUS_NEEDS_MORE_INPUT ) {
+            // all of this chunk consumed
+            return true;
+            }
+
+        // else TINFL_STATUS_HAS_MORE_OUTPUT, go around again with room
+        // at the start of the window
+        }
+    }
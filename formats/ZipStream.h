@@ -0,0 +1,257 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14   Jason Rohrer
+ * Created.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Added raw deflate streams without a dictionary (for gzip wrappers).
+ */
+
+#include "minorGems/common.h"
+
+
+
+#ifndef ZIP_STREAM_INCLUDED
+#define ZIP_STREAM_INCLUDED
+
+
+#include "minorGems/util/SimpleVector.h"
+
+
+
+// values match zlib's (and miniz's) strategy constants
+enum ZipStrategy {
+    ZIP_DEFAULT_STRATEGY = 0,
+    // for data produced by a filter/predictor (small values, few repeats)
+    ZIP_FILTERED = 1,
+    // no string matching at all, just Huffman coding
+    ZIP_HUFFMAN_ONLY = 2,
+    // matches only at distance 1 (runs of the same byte)
+    ZIP_RLE = 3,
+    // never build dynamic Huffman tables (cheaper for tiny inputs)
+    ZIP_FIXED = 4
+    };
+
+
+enum ZipFlush {
+    // buffer input for better compression, output may lag behind
+    ZIP_NO_FLUSH = 0,
+    // output everything so far, so receiver can decompress it
+    // all, but keep stream open
+    ZIP_SYNC_FLUSH = 2,
+    // end the stream
+    ZIP_FINISH = 4
+    };
+
+
+
+/**
+ * Deflate compressor that keeps its state (about 300 KiB) between streams,
+ * so lots of streams can be compressed without re-allocating it.
+ *
+ * Input can be fed in chunks of any size, and output is appended to
+ * a caller's vector as it is produced.
+ *
+ * Without a dictionary, each stream is a zlib stream (same format as
+ * zipCompress, readable by zipDecompress).
+ *
+ * Streams can also be raw deflate without a dictionary, for wrapping in
+ * another format (like gzip) that has its own header and checksum.
+ *
+ * With a preset dictionary, streams are raw deflate, with matches that may
+ * reach back into the dictionary.  This saves a lot on small messages that
+ * resemble each other (and the dictionary), but they can only be read by
+ * a ZipDecompressor given the same dictionary.
+ *
+ * Not thread-safe.
+ *
+ * Usage:
+ *   ZipCompressor c( 6, ZIP_DEFAULT_STRATEGY );
+ *   SimpleVector<unsigned char> out;
+ *   c.compress( chunkA, lengthA, &out );
+ *   c.compress( chunkB, lengthB, &out, ZIP_FINISH );
+ *   // ready for next stream
+ *
+ * @author Jason Rohrer
+ */
+class ZipCompressor {
+
+    public:
+
+        /**
+         * Constructs a compressor.
+         *
+         * @param inLevel compression level in [0,10], where 0 stores
+         *   without compressing and 10 is slowest.
+         *   Defaults to 6 (zlib default).
+         * @param inStrategy the match-finding strategy.
+         * @param inDictionary data to preset the dictionary with, or
+         *   NULL for none.  Only the last 32 KiB matter.
+         *   Copied internally, destroyed by caller.
+         * @param inDictionaryLength the length of inDictionary.
+         * @param inRawDeflate true to produce raw deflate streams, without
+         *   zlib's header and checksum, even without a dictionary.
+         *   Defaults to false.
+         */
+        ZipCompressor( int inLevel = 6,
+                       ZipStrategy inStrategy = ZIP_DEFAULT_STRATEGY,
+                       const unsigned char *inDictionary = NULL,
+                       int inDictionaryLength = 0,
+                       char inRawDeflate = false );
+
+        ~ZipCompressor();
+
+
+        /**
+         * Compresses more data for the current stream.
+         *
+         * @param inData the data to compress.
+         *   Can be NULL if inLength is 0 (to just flush or finish).
+         *   Destroyed by caller.
+         * @param inLength the length of inData.
+         * @param outCompressed vector to append compressed data to.
+         *   Destroyed by caller.
+         * @param inFlush how much output to force out.  After ZIP_FINISH,
+         *   the next call starts a new stream.
+         *
+         * @return true on success, or false if miniz reports failure
+         *   (stream is then reset).
+         */
+        char compress( const unsigned char *inData, int inLength,
+                       SimpleVector<unsigned char> *outCompressed,
+                       ZipFlush inFlush = ZIP_NO_FLUSH );
+
+
+        // same as compress( NULL, 0, outCompressed, ZIP_FINISH )
+        char finish( SimpleVector<unsigned char> *outCompressed );
+
+
+        // abandons the current stream, if any, and starts a new one
+        void reset();
+
+
+
+    protected:
+
+        // holds a tdefl_compressor
+        // (not exposed here to keep miniz's zlib names out of headers)
+        void *mState;
+
+        // state right after dictionary was fed in, or NULL if there's
+        // no dictionary
+        void *mPrimedState;
+
+        int mFlags;
+
+        // where tdefl output currently goes, NULL to discard it
+        SimpleVector<unsigned char> *mOutput;
+
+
+        static int putBuffer( const void *inBuffer, int inLength,
+                              void *inCompressor );
+
+
+    private:
+
+        // not copyable
+        ZipCompressor( const ZipCompressor &inCopy );
+        ZipCompressor & operator = ( const ZipCompressor &inOther );
+
+    };
+
+
+
+
+/**
+ * Inflate decompressor for streams from ZipCompressor (or zipCompress),
+ * keeping a 32 KiB window and its state between streams.
+ *
+ * Compressed data can be fed in chunks of any size, even one byte at a
+ * time, and doesn't need to come with the length of the result.
+ *
+ * Not thread-safe.
+ *
+ * @author Jason Rohrer
+ */
+class ZipDecompressor {
+
+    public:
+
+        /**
+         * Constructs a decompressor.
+         *
+         * @param inDictionary the same dictionary that the compressor was
+         *   given, or NULL to read zlib streams.
+         *   Copied internally, destroyed by caller.
+         * @param inDictionaryLength the length of inDictionary.
+         */
+        ZipDecompressor( const unsigned char *inDictionary = NULL,
+                         int inDictionaryLength = 0 );
+
+        ~ZipDecompressor();
+
+
+        /**
+         * Decompresses more data from the current stream.
+         *
+         * @param inCompressed the compressed data.
+         *   Destroyed by caller.
+         * @param inLength the length of inCompressed.
+         * @param outData vector to append decompressed data to.
+         *   Destroyed by caller.
+         * @param inMaxOutputLength the most data that this call may
+         *   append before it fails, guarding against corrupt or hostile
+         *   streams that expand without end.
+         *   Defaults to -1 (no limit).
+         *
+         * @return true on success, or false on corrupt data or if more
+         *   than inMaxOutputLength would be appended (stream must then
+         *   be reset).
+         *   Any bytes of inCompressed past the end of the stream are
+         *   ignored.
+         */
+        char decompress( const unsigned char *inCompressed, int inLength,
+                         SimpleVector<unsigned char> *outData,
+                         int inMaxOutputLength = -1 );
+
+
+        // true once the end of the current stream has been decompressed
+        char isFinished();
+
+
+        // starts a new stream
+        void reset();
+
+
+
+    protected:
+
+        // holds a tinfl_decompressor
+        void *mState;
+
+        // wrapping window that tinfl decompresses into
+        unsigned char *mWindow;
+
+        // dictionary as it should sit at the end of the window, or NULL
+        unsigned char *mPrimedWindow;
+
+        // where next output byte goes in window
+        int mWindowPos;
+
+        char mFinished;
+
+        char mFailed;
+
+
+    private:
+
+        // not copyable
+        ZipDecompressor( const ZipDecompressor &inCopy );
+        ZipDecompressor & operator = ( const ZipDecompressor &inOther );
+
+    };
+
+
+
+#endif
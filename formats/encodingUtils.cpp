@@ -9,12 +9,20 @@
  *
  * 2004-March-21   Jason Rohrer
  * Fixed a variable scoping and redefinition bug pointed out by Benjamin Meyer.
+ *
+ * 2026-October-14   Jason Rohrer
+ * Table-driven and vectorized (AVX2, NEON) hex and base64, with versions
+ * that write into caller buffers.  Old functions allocate exactly once.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Added binary deltas.
+ * Hex decoding table is constant, instead of built on first use, where
+ * a thread building it could race with one already decoding.
  */
 
 
 #include "encodingUtils.h"
 
-
 #include "minorGems/util/SimpleVector.h"
 
 
@@ -22,6 +30,19 @@
 #include <string.h>
 
 
+#if ( defined( __GNUC__ ) || defined( __clang__ ) ) && \
+    ( defined( __x86_64__ ) || defined( __i386__ ) )
+    // compiled in with a target attribute, used only if cpuid has AVX2
+    #define ENCODING_AVX2
+    #include <cpuid.h>
+    #include <immintrin.h>
+#elif defined( __aarch64__ )
+    // NEON is always there on 64-bit ARM
+    #define ENCODING_NEON
+    #include <arm_neon.h>
+#endif
+
+
 
 char fourBitIntToHex( int inInt ) {
     char outChar[2];
@@ -129,28 +150,211 @@ int hexToFourBitInt( char inHex ) {
 
 
 
+static const char *hexDigits = "0123456789ABCDEF";
+
+
+
+#ifdef ENCODING_AVX2
+
+// -1 until checked
+static int hasAVX2 = -1;
+
+
+static char checkAVX2() {
+    unsigned int eax, ebx, ecx, edx;
+    
+    hasAVX2 = 0;
+
+    if( ! __get_cpuid( 1, &eax, &ebx, &ecx, &edx ) ) {
+        return false;
+        }
+    
+    // AVX, and OS saves YMM registers (OSXSAVE, then XCR0 bits 1 and 2)
+    if( ! ( ecx & ( 1 << 27 ) ) || ! ( ecx & ( 1 << 28 ) ) ) {
+        return false;
+        }
+    
+    unsigned int xcrLow, xcrHigh;
+    __asm__( "xgetbv" : "=a"( xcrLow ), "=d"( xcrHigh ) : "c"( 0 ) );
+
+    if( ( xcrLow & 6 ) != 6 ) {
+        return false;
+        }
+
+    if( __get_cpuid_max( 0, NULL ) < 7 ) {
+        return false;
+        }
+    
+    __cpuid_count( 7, 0, eax, ebx, ecx, edx );
+
+    if( ebx & ( 1 << 5 ) ) {
+        hasAVX2 = 1;
+        }
+    return hasAVX2;
+    }
+
+
+static inline char useAVX2() {
+    return hasAVX2 == 1 || ( hasAVX2 == -1 && checkAVX2() );
+    }
+
+
+
+// 32 bytes to 64 hex digits per step, returns number of bytes done
+__attribute__(( target( "avx2" ) ))
+static int avx2HexEncode( const unsigned char *inData, int inDataLength,
+                          char *outHex ) {
+    
+    const __m256i lut = _mm256_setr_epi8( 
+        '0', '1', '2', '3', '4', '5', '6', '7', 
+        '8', '9', 'A', 'B', 'C', 'D', 'E', 'F',
+        '0', '1', '2', '3', '4', '5', '6', '7', 
+        '8', '9', 'A', 'B', 'C', 'D', 'E', 'F' );
+    
+    const __m256i lowMask = _mm256_set1_epi8( 0x0F );
+    
+    int i = 0;
+    
+    for( ; i + 32 <= inDataLength; i += 32 ) {
+        __m256i bytes = _mm256_loadu_si256( (const __m256i *)&( inData[i] ) );
+        
+        __m256i high = _mm256_shuffle_epi8( 
+            lut, _mm256_and_si256( _mm256_srli_epi16( bytes, 4 ), lowMask ) );
+        __m256i low = _mm256_shuffle_epi8( 
+            lut, _mm256_and_si256( bytes, lowMask ) );
+        
+        // interleave, high digit first (unpack works within 128-bit lanes)
+        __m256i first = _mm256_unpacklo_epi8( high, low );
+        __m256i second = _mm256_unpackhi_epi8( high, low );
+        
+        _mm256_storeu_si256( (__m256i *)&( outHex[ 2 * i ] ),
+                             _mm256_permute2x128_si256( first, second, 
+                                                        0x20 ) );
+        _mm256_storeu_si256( (__m256i *)&( outHex[ 2 * i + 32 ] ),
+                             _mm256_permute2x128_si256( first, second, 
+                                                        0x31 ) );
+        }
+    
+    return i;
+    }
+
+#endif
+
+
+
+#ifdef ENCODING_NEON
+
+// 16 bytes to 32 hex digits per step, returns number of bytes done
+static int neonHexEncode( const unsigned char *inData, int inDataLength,
+                          char *outHex ) {
+    
+    const uint8x16_t lut = vld1q_u8( (const uint8_t *)hexDigits );
+
+    int i = 0;
+    
+    for( ; i + 16 <= inDataLength; i += 16 ) {
+        uint8x16_t bytes = vld1q_u8( &( inData[i] ) );
+        
+        uint8x16x2_t digits;
+        digits.val[0] = vqtbl1q_u8( lut, vshrq_n_u8( bytes, 4 ) );
+        digits.val[1] = vqtbl1q_u8( lut, vandq_u8( bytes, 
+                                                   vdupq_n_u8( 0x0F ) ) );
+        
+        // stores interleaved, high digit first
+        vst2q_u8( (uint8_t *)&( outHex[ 2 * i ] ), digits );
+        }
+    
+    return i;
+    }
+
+#endif
+
+
+
+void hexEncodeInto( const unsigned char *inData, int inDataLength,
+                    char *outHex ) {
+    int i = 0;
+
+#if defined( ENCODING_AVX2 )
+    if( inDataLength >= 32 && useAVX2() ) {
+        i = avx2HexEncode( inData, inDataLength, outHex );
+        }
+#elif defined( ENCODING_NEON )
+    i = neonHexEncode( inData, inDataLength, outHex );
+#endif
+
+    for( ; i<inDataLength; i++ ) {
+        outHex[ 2 * i ] = hexDigits[ inData[i] >> 4 ];
+        outHex[ 2 * i + 1 ] = hexDigits[ inData[i] & 0x0F ];
+        }
+
+    outHex[ 2 * inDataLength ] = '\0';
+    }
+
+
+
 char *hexEncode( unsigned char *inData, int inDataLength ) {
 
     char *resultHexString = new char[ inDataLength * 2 + 1 ];
-    int hexStringIndex = 0;
     
-    for( int i=0; i<inDataLength; i++ ) {
+    hexEncodeInto( inData, inDataLength, resultHexString );
+    
+    return resultHexString;
+    }
+
 
-        unsigned char currentByte = inData[ i ];
 
-        int highBits = 0xF & ( currentByte >> 4 );
-        int lowBits = 0xF & ( currentByte );
+// maps hex digit characters to values, 0xFF for non-hex characters
+static const unsigned char hexValues[256] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff };
 
-        resultHexString[ hexStringIndex ] = fourBitIntToHex( highBits );
-        hexStringIndex++;
 
-        resultHexString[ hexStringIndex ] = fourBitIntToHex( lowBits );
-        hexStringIndex++;
+
+int hexDecodeInto( const char *inHex, int inHexLength, 
+                   unsigned char *outData ) {
+    
+    if( inHexLength % 2 != 0 ) {
+        // hex strings must be even in length
+        return -1;
         }
+    
+    int dataLength = inHexLength / 2;
 
-    resultHexString[ hexStringIndex ] = '\0';
+    const unsigned char *hex = (const unsigned char *)inHex;
     
-    return resultHexString;
+    for( int i=0; i<dataLength; i++ ) {
+        unsigned char highBits = hexValues[ hex[ 2 * i ] ];
+        unsigned char lowBits = hexValues[ hex[ 2 * i + 1 ] ];
+
+        if( ( highBits | lowBits ) == 0xFF ) {
+            return -1;
+            }
+        
+        outData[i] = (unsigned char)( highBits << 4 | lowBits );
+        }
+    
+    return dataLength;
     }
 
 
@@ -164,22 +368,11 @@ unsigned char *hexDecode( char *inHexString ) {
         return NULL;
         }
 
-    int dataLength = hexLength / 2;
-    
-    unsigned char *rawData = new unsigned char[ dataLength ];
+    unsigned char *rawData = new unsigned char[ hexLength / 2 ];
 
-
-    for( int i=0; i<dataLength; i++ ) {
-
-        int highBits = hexToFourBitInt( inHexString[ 2 * i ] );
-        int lowBits = hexToFourBitInt( inHexString[ 2 * i + 1 ] );
-
-        if( highBits == -1 || lowBits == -1 ) {
-            delete [] rawData;
-            return NULL;
-            }
-        
-        rawData[i] = (unsigned char)( highBits << 4 | lowBits );
+    if( hexDecodeInto( inHexString, hexLength, rawData ) == -1 ) {
+        delete [] rawData;
+        return NULL;
         }
 
     return rawData;
@@ -230,221 +423,793 @@ static unsigned char asciiToBinary[256] = {
     0xff, 0xff, 0xff, 0xff };
 
 
-char *base64Encode( unsigned char *inData, int inDataLength,
-                    char inBreakLines ) {
+// data bytes per encoded line, and characters per line when broken
+#define BASE64_LINE_GROUPS  19
+#define BASE64_LINE_BYTES   ( 3 * BASE64_LINE_GROUPS )
+
 
-    SimpleVector<char> *encodingVector = new SimpleVector<char>();
 
-    int numInLine = 0;
+#ifdef ENCODING_AVX2
+
+/**
+ * Vector base64, after Wojciech Mula and Daniel Lemire, "Faster Base64
+ * Encoding and Decoding Using AVX2 Instructions" (2018), and Alfred
+ * Klomp's base64 library.
+ */
+
+
+
+// 24 bytes to 32 characters per step
+// reads 4 bytes past what it encodes, so inAvailable must allow for that
+// returns number of bytes done (a multiple of 24)
+__attribute__(( target( "avx2" ) ))
+static int avx2Base64Encode( const unsigned char *inData, int inLength,
+                             int inAvailable, char *outChars ) {
+
+    // spreads each 3 bytes into 4, in the order the 6-bit fields are taken
+    const __m256i spread = _mm256_setr_epi8( 
+        1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+        1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10 );
+
+    // offsets from 6-bit value to ASCII, indexed by value range
+    const __m256i offsets = _mm256_setr_epi8(
+        65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0,
+        65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0 );
+
+    int i = 0;
     
-    // take groups of 3 data bytes and map them to 4 base64 digits
-    for( int i=0; i<inDataLength; i=i+3 ) {
+    while( i + 24 <= inLength && i + 28 <= inAvailable ) {
+        // 12 bytes in the bottom of each 128-bit lane
+        __m256i in = _mm256_inserti128_si256( 
+            _mm256_castsi128_si256( 
+                _mm_loadu_si128( (const __m128i *)&( inData[i] ) ) ),
+            _mm_loadu_si128( (const __m128i *)&( inData[ i + 12 ] ) ), 1 );
+        
+        in = _mm256_shuffle_epi8( in, spread );
+
+        // shift each 6-bit field down into its own byte
+        __m256i t0 = _mm256_and_si256( in, _mm256_set1_epi32( 0x0FC0FC00 ) );
+        __m256i t1 = _mm256_mulhi_epu16( t0, 
+                                         _mm256_set1_epi32( 0x04000040 ) );
+        __m256i t2 = _mm256_and_si256( in, _mm256_set1_epi32( 0x003F03F0 ) );
+        __m256i t3 = _mm256_mullo_epi16( t2, 
+                                         _mm256_set1_epi32( 0x01000010 ) );
+        __m256i values = _mm256_or_si256( t1, t3 );
+
+        // 0-25 -> 0, 26-51 -> 1, 52-61 -> 2-11, 62 -> 12, 63 -> 13
+        __m256i ranges = _mm256_subs_epu8( values, _mm256_set1_epi8( 51 ) );
+        ranges = _mm256_sub_epi8( 
+            ranges, _mm256_cmpgt_epi8( values, _mm256_set1_epi8( 25 ) ) );
+
+        __m256i chars = _mm256_add_epi8( 
+            values, _mm256_shuffle_epi8( offsets, ranges ) );
+        
+        _mm256_storeu_si256( (__m256i *)outChars, chars );
+
+        i += 24;
+        outChars += 32;
+        }
 
-        if( i+2 < inDataLength ) {
-            // not at end yet
+    return i;
+    }
 
-            unsigned int block =
-                inData[i]   << 16 |
-                inData[i+1] << 8 |
-                inData[i+2];
 
-            // base64 digits, with digitA at left
-            unsigned int digitA = 0x3F & ( block >> 18 );
-            unsigned int digitB = 0x3F & ( block >> 12 );
-            unsigned int digitC = 0x3F & ( block >> 6 );
-            unsigned int digitD = 0x3F & ( block );
 
-            encodingVector->push_back( binaryToAscii[ digitA ] );
-            encodingVector->push_back( binaryToAscii[ digitB ] );
-            encodingVector->push_back( binaryToAscii[ digitC ] );
-            encodingVector->push_back( binaryToAscii[ digitD ] );
-            numInLine += 4;
+// 32 characters to 24 bytes per step, stopping at the first chunk that
+// has any non-base64 characters (line breaks, padding)
+// returns number of characters done (a multiple of 32)
+__attribute__(( target( "avx2" ) ))
+static int avx2Base64Decode( const unsigned char *inChars, int inLength,
+                             unsigned char *outData ) {
+    
+    // bit sets from low and high nibbles that overlap only for
+    // invalid characters
+    const __m256i lowNibbleBits = _mm256_setr_epi8(
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A );
+    
+    const __m256i highNibbleBits = _mm256_setr_epi8(
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10 );
+
+    // offsets from ASCII to 6-bit value, by high nibble ('/' at 1)
+    const __m256i offsets = _mm256_setr_epi8(
+        0, 16, 19, 4, -65, -65, -71, -71,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 16, 19, 4, -65, -65, -71, -71,
+        0, 0, 0, 0, 0, 0, 0, 0 );
+
+    const __m256i mask2F = _mm256_set1_epi8( 0x2F );
+
+    // packs each 4 values into 3 bytes and gathers them at the bottom
+    const __m256i gather = _mm256_setr_epi8(
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1 );
+    
+    const __m256i gatherLanes = _mm256_setr_epi32( 0, 1, 2, 4, 5, 6, 0, 0 );
 
-            if( inBreakLines && numInLine == 76 ) {
-                // break the line
-                encodingVector->push_back( '\r' );
-                encodingVector->push_back( '\n' );
-                numInLine = 0;
-                }
+    int i = 0;
+    
+    while( i + 32 <= inLength ) {
+        __m256i chars = 
+            _mm256_loadu_si256( (const __m256i *)&( inChars[i] ) );
+        
+        __m256i highNibbles = 
+            _mm256_and_si256( _mm256_srli_epi32( chars, 4 ), mask2F );
+        __m256i lowNibbles = _mm256_and_si256( chars, mask2F );
+
+        if( ! _mm256_testz_si256( 
+                _mm256_shuffle_epi8( lowNibbleBits, lowNibbles ),
+                _mm256_shuffle_epi8( highNibbleBits, highNibbles ) ) ) {
+            // leave this chunk for the scalar decoder
+            break;
+            }
+        
+        __m256i isSlash = _mm256_cmpeq_epi8( chars, mask2F );
+        
+        __m256i values = _mm256_add_epi8( 
+            chars, 
+            _mm256_shuffle_epi8( offsets, 
+                                 _mm256_add_epi8( isSlash, highNibbles ) ) );
+
+        __m256i merged = _mm256_maddubs_epi16( 
+            values, _mm256_set1_epi32( 0x01400140 ) );
+        merged = _mm256_madd_epi16( merged, _mm256_set1_epi32( 0x00011000 ) );
+        
+        merged = _mm256_shuffle_epi8( merged, gather );
+        merged = _mm256_permutevar8x32_epi32( merged, gatherLanes );
+
+        // exactly 24 bytes, caller's buffer has no slack
+        _mm_storeu_si128( (__m128i *)outData, 
+                          _mm256_castsi256_si128( merged ) );
+        _mm_storel_epi64( (__m128i *)&( outData[16] ), 
+                          _mm256_extracti128_si256( merged, 1 ) );
+        
+        i += 32;
+        outData += 24;
+        }
+
+    return i;
+    }
+
+#endif
+
+
+
+#ifdef ENCODING_NEON
+
+// 48 bytes to 64 characters per step
+// returns number of bytes done
+static int neonBase64Encode( const unsigned char *inData, int inLength,
+                             int inAvailable, char *outChars ) {
+    
+    uint8x16x4_t lut = vld1q_u8_x4( (const uint8_t *)binaryToAscii );
+
+    const uint8x16_t mask3F = vdupq_n_u8( 0x3F );
+    
+    int i = 0;
+    
+    for( ; i + 48 <= inLength; i += 48 ) {
+        // de-interleaves bytes 0, 1, and 2 of each group
+        uint8x16x3_t in = vld3q_u8( &( inData[i] ) );
+        
+        uint8x16x4_t values;
+        values.val[0] = vshrq_n_u8( in.val[0], 2 );
+        values.val[1] = vandq_u8( vorrq_u8( vshlq_n_u8( in.val[0], 4 ),
+                                            vshrq_n_u8( in.val[1], 4 ) ),
+                                  mask3F );
+        values.val[2] = vandq_u8( vorrq_u8( vshlq_n_u8( in.val[1], 2 ),
+                                            vshrq_n_u8( in.val[2], 6 ) ),
+                                  mask3F );
+        values.val[3] = vandq_u8( in.val[2], mask3F );
+
+        for( int v=0; v<4; v++ ) {
+            values.val[v] = vqtbl4q_u8( lut, values.val[v] );
+            }
+        
+        vst4q_u8( (uint8_t *)outChars, values );
+        outChars += 64;
+        }
+    
+    return i;
+    }
+
+
+
+// 64 characters to 48 bytes per step, stopping at the first chunk that
+// has any non-base64 characters
+// returns number of characters done
+static int neonBase64Decode( const unsigned char *inChars, int inLength,
+                             unsigned char *outData ) {
+
+    // reverse table, in two halves for characters 0-63 and 64-127
+    uint8x16x4_t lowLut = vld1q_u8_x4( asciiToBinary );
+    uint8x16x4_t highLut = vld1q_u8_x4( &( asciiToBinary[64] ) );
+
+    const uint8x16_t offset40 = vdupq_n_u8( 0x40 );
+    
+    int i = 0;
+    
+    for( ; i + 64 <= inLength; i += 64 ) {
+        uint8x16x4_t chars = vld4q_u8( &( inChars[i] ) );
+        
+        uint8x16_t bad = vdupq_n_u8( 0 );
+        
+        for( int v=0; v<4; v++ ) {
+            uint8x16_t c = chars.val[v];
             
+            // out-of-range indices give 0 from tbl, and are left alone
+            // by tbx
+            uint8x16_t value = vqtbl4q_u8( lowLut, c );
+            value = vqtbx4q_u8( value, highLut, vsubq_u8( c, offset40 ) );
+
+            // 0xFF marks invalid, and everything from 128 up is invalid
+            bad = vorrq_u8( bad, vorrq_u8( vcgtq_u8( value, 
+                                                     vdupq_n_u8( 63 ) ),
+                                           vcgeq_u8( c, 
+                                                     vdupq_n_u8( 128 ) ) ) );
+            chars.val[v] = value;
+            }
+        
+        if( vmaxvq_u8( bad ) != 0 ) {
+            break;
             }
-        else {
-            // at end
-            int numLeft = inDataLength - i;
-
-            switch( numLeft ) {
-                case 0:
-                    // no padding
-                    break;
-                case 1: {
-                    // two digits, two pads
-                    unsigned int block =
-                        inData[i]   << 16 |
-                        0;
-                    unsigned int digitA = 0x3F & ( block >> 18 );
-                    unsigned int digitB = 0x3F & ( block >> 12 );
+
+        uint8x16x3_t out;
+        out.val[0] = vorrq_u8( vshlq_n_u8( chars.val[0], 2 ),
+                               vshrq_n_u8( chars.val[1], 4 ) );
+        out.val[1] = vorrq_u8( vshlq_n_u8( chars.val[1], 4 ),
+                               vshrq_n_u8( chars.val[2], 2 ) );
+        out.val[2] = vorrq_u8( vshlq_n_u8( chars.val[2], 6 ),
+                               chars.val[3] );
+        
+        vst3q_u8( outData, out );
+        outData += 48;
+        }
+    
+    return i;
+    }
+
+#endif
+
+
+
+// encodes whole 3-byte groups
+// inAvailable is how many bytes can be read from inData (for vector
+// loads that run past the end of what they encode)
+// returns pointer just past last character written
+static char *encodeBase64Groups( const unsigned char *inData, int inNumGroups,
+                                 int inAvailable, char *outChars ) {
+    int length = inNumGroups * 3;
+    
+    int i = 0;
+
+#if defined( ENCODING_AVX2 )
+    if( length >= 24 && useAVX2() ) {
+        i = avx2Base64Encode( inData, length, inAvailable, outChars );
+        outChars += ( i / 3 ) * 4;
+        }
+#elif defined( ENCODING_NEON )
+    i = neonBase64Encode( inData, length, inAvailable, outChars );
+    outChars += ( i / 3 ) * 4;
+#endif
+    
+    for( ; i<length; i += 3 ) {
+        unsigned int block =
+            inData[i]   << 16 |
+            inData[i+1] << 8 |
+            inData[i+2];
+        
+        outChars[0] = binaryToAscii[ 0x3F & ( block >> 18 ) ];
+        outChars[1] = binaryToAscii[ 0x3F & ( block >> 12 ) ];
+        outChars[2] = binaryToAscii[ 0x3F & ( block >> 6 ) ];
+        outChars[3] = binaryToAscii[ 0x3F & ( block ) ];
+        outChars += 4;
+        }
+    
+    return outChars;
+    }
+
+
+
+int getBase64EncodedLength( int inDataLength, char inBreakLines ) {
+    int length = ( ( inDataLength + 2 ) / 3 ) * 4;
+
+    if( inBreakLines ) {
+        // \r\n after each full line of whole groups
+        length += 2 * ( ( inDataLength / 3 ) / BASE64_LINE_GROUPS );
+        }
+    
+    return length;
+    }
+
+
+
+int base64EncodeInto( const unsigned char *inData, int inDataLength,
+                      char *outBase64, char inBreakLines ) {
+    
+    char *out = outBase64;
+    
+    int numGroups = inDataLength / 3;
+
+    int i = 0;
+    
+    if( inBreakLines ) {
+        for( ; numGroups - i / 3 >= BASE64_LINE_GROUPS; 
+             i += BASE64_LINE_BYTES ) {
             
-                    encodingVector->push_back( binaryToAscii[ digitA ] );
-                    encodingVector->push_back( binaryToAscii[ digitB ] );
-
-                    encodingVector->push_back( '=' );
-                    encodingVector->push_back( '=' );
-                    break;
-                    }
-                case 2: {
-                    // three digits, one pad
-                    unsigned int block =
-                        inData[i]   << 16 |
-                        inData[i+1] << 8 |
-                        0;
-
-                    // base64 digits, with digitA at left
-                    unsigned int digitA = 0x3F & ( block >> 18 );
-                    unsigned int digitB = 0x3F & ( block >> 12 );
-                    unsigned int digitC = 0x3F & ( block >> 6 );
-                    
-                    encodingVector->push_back( binaryToAscii[ digitA ] );
-                    encodingVector->push_back( binaryToAscii[ digitB ] );
-                    encodingVector->push_back( binaryToAscii[ digitC ] );
-                    encodingVector->push_back( '=' );
-                    break;
-                    }
-                default:
-                    break;
-                }
-            // done with all data
-            i = inDataLength;
+            out = encodeBase64Groups( &( inData[i] ), BASE64_LINE_GROUPS,
+                                      inDataLength - i, out );
+            *out++ = '\r';
+            *out++ = '\n';
             }
         }
+    
+    int groupsLeft = numGroups - i / 3;
+    
+    out = encodeBase64Groups( &( inData[i] ), groupsLeft, 
+                              inDataLength - i, out );
+    i += 3 * groupsLeft;
 
-    char *returnString = encodingVector->getElementString();
+    int numLeft = inDataLength - i;
 
-    delete encodingVector;
+    if( numLeft == 1 ) {
+        // two digits, two pads
+        unsigned int block = inData[i] << 16;
 
+        *out++ = binaryToAscii[ 0x3F & ( block >> 18 ) ];
+        *out++ = binaryToAscii[ 0x3F & ( block >> 12 ) ];
+        *out++ = '=';
+        *out++ = '=';
+        }
+    else if( numLeft == 2 ) {
+        // three digits, one pad
+        unsigned int block =
+            inData[i]   << 16 |
+            inData[i+1] << 8;
+
+        *out++ = binaryToAscii[ 0x3F & ( block >> 18 ) ];
+        *out++ = binaryToAscii[ 0x3F & ( block >> 12 ) ];
+        *out++ = binaryToAscii[ 0x3F & ( block >> 6 ) ];
+        *out++ = '=';
+        }
+    
+    *out = '\0';
+
+    return out - outBase64;
+    }
+
+
+
+char *base64Encode( unsigned char *inData, int inDataLength,
+                    char inBreakLines ) {
+
+    char *returnString = 
+        new char[ getBase64EncodedLength( inDataLength, inBreakLines ) + 1 ];
+    
+    base64EncodeInto( inData, inDataLength, returnString, inBreakLines );
+    
     return returnString;
     }
 
 
 
+int getBase64DecodedLength( const char *inBase64, int inBase64Length ) {
+    const unsigned char *chars = (const unsigned char *)inBase64;
+
+    int numDigits = 0;
+    
+    for( int i=0; i<inBase64Length; i++ ) {
+        if( asciiToBinary[ chars[i] ] != 0xFF ) {
+            numDigits++;
+            }
+        }
+    
+    // a single left-over digit can't make a byte, and is dropped
+    int numBytes = ( numDigits / 4 ) * 3;
+    
+    int digitsLeft = numDigits % 4;
+    
+    if( digitsLeft > 1 ) {
+        numBytes += digitsLeft - 1;
+        }
+    return numBytes;
+    }
+
+
+
+int base64DecodeInto( const char *inBase64, int inBase64Length,
+                      unsigned char *outData ) {
+    
+    const unsigned char *chars = (const unsigned char *)inBase64;
+    
+    unsigned char *out = outData;
+
+    // digits of the partial group so far
+    unsigned int block = 0;
+    int numDigits = 0;
+
+    int i = 0;
+
+    // vector decoders stop at a chunk with non-digits in it, so after a
+    // stop, they're only worth trying again once past a non-digit
+    char tryVector = true;
+    
+    while( i < inBase64Length ) {
+
+#if defined( ENCODING_AVX2 ) || defined( ENCODING_NEON )
+        if( tryVector && numDigits == 0 && inBase64Length - i >= 64 ) {
+            // on a group boundary
+    #if defined( ENCODING_AVX2 )
+            int numDone = 0;
+            if( useAVX2() ) {
+                numDone = avx2Base64Decode( &( chars[i] ), 
+                                            inBase64Length - i, out );
+                }
+    #else
+            int numDone = neonBase64Decode( &( chars[i] ), 
+                                            inBase64Length - i, out );
+    #endif
+            i += numDone;
+            out += ( numDone / 4 ) * 3;
+            
+            tryVector = false;
+            continue;
+            }
+#endif
+        
+        // skip anything that isn't a base64 digit (line breaks, padding)
+        unsigned char value = asciiToBinary[ chars[i] ];
+        i++;
+
+        if( value == 0xFF ) {
+            tryVector = true;
+            continue;
+            }
+        
+        block = block << 6 | value;
+        numDigits++;
+        
+        if( numDigits == 4 ) {
+            *out++ = (unsigned char)( block >> 16 );
+            *out++ = (unsigned char)( block >> 8 );
+            *out++ = (unsigned char)( block );
+            block = 0;
+            numDigits = 0;
+            }
+        }
+    
+    // partial group at end
+    if( numDigits == 2 ) {
+        // two base64 digits, one data byte
+        *out++ = (unsigned char)( block >> 4 );
+        }
+    else if( numDigits == 3 ) {
+        // three base64 digits, two data bytes
+        *out++ = (unsigned char)( block >> 10 );
+        *out++ = (unsigned char)( block >> 2 );
+        }
+    
+    return out - outData;
+    }
+
+
+
 unsigned char *base64Decode( char *inBase64String,
                              int *outDataLength ) {
 
-    SimpleVector<unsigned char> *decodedVector =
-        new SimpleVector<unsigned char>();
+    int encodingLength = strlen( inBase64String );
 
+    unsigned char *returnData = 
+        new unsigned char[ 
+            getBase64DecodedLength( inBase64String, encodingLength ) ];
 
+    *outDataLength = 
+        base64DecodeInto( inBase64String, encodingLength, returnData );
     
-    int encodingLength = strlen( inBase64String );
+    return returnData;
+    }
 
-    SimpleVector<unsigned char> *binaryEncodingVector =
-        new SimpleVector<unsigned char>();
 
-    int i;
-    for( i=0; i<encodingLength; i++ ) {
-        unsigned char currentChar = (unsigned char)( inBase64String[i] );
 
-        unsigned char currentBinary = asciiToBinary[ currentChar ]; 
-        
-        if( currentBinary != 0xFF ) {
-            // in range
-            binaryEncodingVector->push_back( currentBinary );
+
+// Delta layout, with all numbers as little-endian base-128 varints:
+//   new length
+//   then, until new length is reached, repeated:
+//     literal length, literal bytes,
+//     copy length, then (if copy length > 0) copy start in old data,
+//       zig-zag encoded relative to where the last copy ended
+//
+// Old data is indexed at every DELTA_BLOCK_SIZE boundary, so any match of
+// at least 2 * DELTA_BLOCK_SIZE - 1 bytes is found, then extended in both
+// directions byte by byte.
+
+#define DELTA_BLOCK_SIZE 16
+
+// odd multiplier for rolling hash (mod 2^32)
+#define DELTA_HASH_MULTIPLIER 0x01000193
+
+
+
+static void pushVarint( SimpleVector<unsigned char> *inVector,
+                        unsigned int inValue ) {
+    while( inValue >= 0x80 ) {
+        inVector->push_back( (unsigned char)( inValue | 0x80 ) );
+        inValue >>= 7;
+        }
+    inVector->push_back( (unsigned char)inValue );
+    }
+
+
+
+// returns false if varint runs past inEnd or is too long
+static char readVarint( unsigned char **inOutPointer, unsigned char *inEnd,
+                        unsigned int *outValue ) {
+    unsigned int value = 0;
+
+    for( int shift = 0; shift < 35; shift += 7 ) {
+        if( *inOutPointer >= inEnd ) {
+            return false;
             }
+        unsigned char b = **inOutPointer;
+        (*inOutPointer)++;
+
+        value |= (unsigned int)( b & 0x7F ) << shift;
+
+        if( ( b & 0x80 ) == 0 ) {
+            *outValue = value;
+            return true;
+            }
+        }
+    return false;
+    }
+
+
+
+static unsigned int deltaBlockHash( unsigned char *inData ) {
+    unsigned int hash = 0;
+    for( int i=0; i<DELTA_BLOCK_SIZE; i++ ) {
+        hash = hash * DELTA_HASH_MULTIPLIER + inData[i];
         }
+    return hash;
+    }
 
-    int binaryEncodingLength = binaryEncodingVector->size();
 
-    unsigned char *binaryEncoding = binaryEncodingVector->getElementArray();
-    delete binaryEncodingVector;
 
-    int blockCount = binaryEncodingLength / 4;
+static void pushDeltaLiteral( SimpleVector<unsigned char> *inDelta,
+                              unsigned char *inData, int inLength ) {
+    pushVarint( inDelta, inLength );
+    inDelta->push_back( inData, inLength );
+    }
+
+
 
-    if( binaryEncodingLength % 4 != 0 ) {
-        // extra, 0-padded block
-        blockCount += 1;
+unsigned char *makeBinaryDelta( unsigned char *inOldData, int inOldLength,
+                                unsigned char *inNewData, int inNewLength,
+                                int *outDeltaLength ) {
+
+    SimpleVector<unsigned char> delta( inNewLength / 8 + 64 );
+
+    pushVarint( &delta, inNewLength );
+
+
+    int numBlocks = inOldLength / DELTA_BLOCK_SIZE;
+
+    // at most half full, and a power of 2
+    int tableBits = 4;
+    while( ( 1 << tableBits ) < 2 * numBlocks ) {
+        tableBits++;
         }
+    int tableSize = 1 << tableBits;
 
+    // 1 + block start, or 0 for empty
+    // keeps first block with a given hash
+    int *table = new int[ tableSize ];
+    memset( table, 0, tableSize * sizeof( int ) );
 
+    for( int b=0; b<numBlocks; b++ ) {
+        int start = b * DELTA_BLOCK_SIZE;
 
-    // take groups of 4 encoded digits and map them to 3 data bytes
-    for( i=0; i<binaryEncodingLength; i=i+4 ) {
+        unsigned int slot =
+            ( deltaBlockHash( &( inOldData[ start ] ) ) * 0x9E3779B1U )
+            >> ( 32 - tableBits );
 
-        if( i+3 < binaryEncodingLength ) {
-            // not at end yet
+        while( table[ slot ] != 0 ) {
+            slot = ( slot + 1 ) & ( tableSize - 1 );
+            }
+        table[ slot ] = start + 1;
+        }
 
-            unsigned int block =
-                binaryEncoding[i]   << 18 |
-                binaryEncoding[i+1] << 12 |
-                binaryEncoding[i+2] << 6 |
-                binaryEncoding[i+3];
 
-            // data byte digits, with digitA at left
-            unsigned int digitA = 0xFF & ( block >> 16 );
-            unsigned int digitB = 0xFF & ( block >> 8 );
-            unsigned int digitC = 0xFF & ( block );
-            
-            decodedVector->push_back( digitA );
-            decodedVector->push_back( digitB );
-            decodedVector->push_back( digitC );            
+    // multiplier^DELTA_BLOCK_SIZE, for rolling oldest byte out
+    unsigned int outFactor = 1;
+    for( int i=0; i<DELTA_BLOCK_SIZE; i++ ) {
+        outFactor *= DELTA_HASH_MULTIPLIER;
+        }
+
+
+    int literalStart = 0;
+    int lastCopyEnd = 0;
+
+    int i = 0;
+    unsigned int hash = 0;
+    char hashValid = false;
+
+    while( numBlocks > 0 && i + DELTA_BLOCK_SIZE <= inNewLength ) {
+
+        if( ! hashValid ) {
+            hash = deltaBlockHash( &( inNewData[i] ) );
+            hashValid = true;
             }
-        else {
-            // at end
-            int numLeft = binaryEncodingLength - i;
-
-            switch( numLeft ) {
-                case 0:
-                    // no padding
-                    break;
-                case 1: {
-                    // impossible
-                    break;
-                    }
-                case 2: {
-                    // two base64 digits, one data byte
-                    unsigned int block =
-                        binaryEncoding[i]   << 18 |
-                        binaryEncoding[i+1] << 12 |
-                        0;
-                    
-                    // data byte digits, with digitA at left
-                    unsigned int digitA = 0xFF & ( block >> 16 );
-                    
-                    decodedVector->push_back( digitA );
-                    break;
-                    }
-                case 3: {
-                    // three base64 digits, two data bytes
-                    unsigned int block =
-                        binaryEncoding[i]   << 18 |
-                        binaryEncoding[i+1] << 12 |
-                        binaryEncoding[i+2] << 6 |
-                        0;
-
-                    // data byte digits, with digitA at left
-                    unsigned int digitA = 0xFF & ( block >> 16 );
-                    unsigned int digitB = 0xFF & ( block >> 8 );
-                    
-            
-                    decodedVector->push_back( digitA );
-                    decodedVector->push_back( digitB );
-                    break;
-                    }
-                default:
-                    break;
+
+        int matchOld = -1;
+
+        unsigned int slot =
+            ( hash * 0x9E3779B1U ) >> ( 32 - tableBits );
+
+        while( table[ slot ] != 0 ) {
+            int candidate = table[ slot ] - 1;
+
+            if( memcmp( &( inOldData[ candidate ] ), &( inNewData[i] ),
+                        DELTA_BLOCK_SIZE ) == 0 ) {
+                matchOld = candidate;
+                break;
                 }
-            // done with all data
-            i = binaryEncodingLength;
+            slot = ( slot + 1 ) & ( tableSize - 1 );
             }
-        }    
 
-    delete [] binaryEncoding;
-    
+        if( matchOld == -1 ) {
+            if( i + DELTA_BLOCK_SIZE < inNewLength ) {
+                hash = hash * DELTA_HASH_MULTIPLIER
+                    - outFactor * inNewData[i]
+                    + inNewData[ i + DELTA_BLOCK_SIZE ];
+                }
+            i++;
+            continue;
+            }
 
-    *outDataLength = decodedVector->size();
-    unsigned char* returnData = decodedVector->getElementArray();
 
-    delete decodedVector;
+        // extend back into pending literal, and forward
+        int newStart = i;
+        int oldStart = matchOld;
 
-    return returnData;
+        while( newStart > literalStart && oldStart > 0 &&
+               inNewData[ newStart - 1 ] == inOldData[ oldStart - 1 ] ) {
+            newStart--;
+            oldStart--;
+            }
+
+        int newEnd = i + DELTA_BLOCK_SIZE;
+        int oldEnd = matchOld + DELTA_BLOCK_SIZE;
+
+        while( newEnd < inNewLength && oldEnd < inOldLength &&
+               inNewData[ newEnd ] == inOldData[ oldEnd ] ) {
+            newEnd++;
+            oldEnd++;
+            }
+
+        pushDeltaLiteral( &delta, &( inNewData[ literalStart ] ),
+                          newStart - literalStart );
+
+        pushVarint( &delta, newEnd - newStart );
+
+        // zig-zag, so small backward jumps stay small too
+        int offset = oldStart - lastCopyEnd;
+        unsigned int zigZag = (unsigned int)offset << 1;
+        if( offset < 0 ) {
+            zigZag = ~zigZag;
+            }
+        pushVarint( &delta, zigZag );
+
+        lastCopyEnd = oldEnd;
+
+        literalStart = newEnd;
+        i = newEnd;
+        hashValid = false;
+        }
+
+    delete [] table;
+
+
+    if( literalStart < inNewLength || inNewLength == 0 ) {
+        pushDeltaLiteral( &delta, &( inNewData[ literalStart ] ),
+                          inNewLength - literalStart );
+        pushVarint( &delta, 0 );
+        }
+
+    *outDeltaLength = delta.size();
+
+    return delta.getElementArray();
+    }
+
+
+
+unsigned char *applyBinaryDelta( unsigned char *inOldData, int inOldLength,
+                                 unsigned char *inDelta, int inDeltaLength,
+                                 int *outNewLength ) {
+
+    unsigned char *next = inDelta;
+    unsigned char *end = &( inDelta[ inDeltaLength ] );
+
+    unsigned int newLength;
+
+    if( ! readVarint( &next, end, &newLength ) ||
+        newLength > 0x7FFFFFFF ) {
+        return NULL;
+        }
+
+    unsigned char *newData = new unsigned char[ newLength ];
+
+    unsigned int numDone = 0;
+    long long lastCopyEnd = 0;
+
+    // at least one (possibly empty) literal and copy pair, even for
+    // 0-length new data
+    char first = true;
+
+    while( numDone < newLength || first ) {
+        first = false;
+
+        unsigned int literalLength;
+        unsigned int copyLength;
+
+        if( ! readVarint( &next, end, &literalLength ) ||
+            literalLength > newLength - numDone ||
+            literalLength > (unsigned int)( end - next ) ) {
+            delete [] newData;
+            return NULL;
+            }
+
+        memcpy( &( newData[ numDone ] ), next, literalLength );
+        next = &( next[ literalLength ] );
+        numDone += literalLength;
+
+        if( ! readVarint( &next, end, &copyLength ) ||
+            copyLength > newLength - numDone ) {
+            delete [] newData;
+            return NULL;
+            }
+
+        if( copyLength > 0 ) {
+            unsigned int zigZag;
+            if( ! readVarint( &next, end, &zigZag ) ) {
+                delete [] newData;
+                return NULL;
+                }
+
+            long long offset = (long long)( zigZag >> 1 );
+            if( zigZag & 1 ) {
+                offset = - offset - 1;
+                }
+
+            long long copyStart = lastCopyEnd + offset;
+
+            if( copyStart < 0 ||
+                copyStart + copyLength > (long long)inOldLength ) {
+                delete [] newData;
+                return NULL;
+                }
+
+            memcpy( &( newData[ numDone ] ), &( inOldData[ copyStart ] ),
+                    copyLength );
+            numDone += copyLength;
+
+            lastCopyEnd = copyStart + copyLength;
+            }
+        }
+
+    if( next != end ) {
+        // trailing garbage
+        delete [] newData;
+        return NULL;
+        }
+
+    *outNewLength = newLength;
+    return newData;
     }
 
 
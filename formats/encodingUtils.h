@@ -6,6 +6,12 @@
  *
  * 2003-September-22   Jason Rohrer
  * Added base64 encoding.
+ *
+ * 2026-October-14   Jason Rohrer
+ * Added versions that encode and decode into caller-supplied buffers.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Added binary deltas.
  */
 
 
@@ -53,6 +59,30 @@ unsigned char *hexDecode( char *inHexString );
 
 
 
+/**
+ * Same as hexEncode, but writes into a caller-supplied buffer.
+ *
+ * @param outHex where the \0-terminated hex string should be written.
+ *   Must have room for 2 * inDataLength + 1 characters.
+ */
+void hexEncodeInto( const unsigned char *inData, int inDataLength,
+                    char *outHex );
+
+
+/**
+ * Same as hexDecode, but reads inHexLength characters (no \0 needed),
+ * and writes into a caller-supplied buffer.
+ *
+ * @param outData where the data should be written.
+ *   Must have room for inHexLength / 2 bytes.
+ *
+ * @return the number of bytes written, or -1 if decoding fails.
+ */
+int hexDecodeInto( const char *inHex, int inHexLength, 
+                   unsigned char *outData );
+
+
+
 
 /**
  * Encodes data as a ASCII base64 string.
@@ -89,9 +119,116 @@ unsigned char *base64Decode( char *inBase64String,
 
 
 
+// The following work with caller-supplied buffers, and produce exactly
+// the same results as base64Encode and base64Decode.
+// They use vector instructions (AVX2 or NEON) where available.
+
+
+// exact length of base64Encode's result, not counting the \0
+int getBase64EncodedLength( int inDataLength, char inBreakLines = true );
+
+
+/**
+ * Encodes data as base64 into a buffer.
+ *
+ * @param outBase64 where the \0-terminated string should be written.
+ *   Must have room for getBase64EncodedLength() + 1 characters.
+ *
+ * @return the number of characters written, not counting the \0.
+ */
+int base64EncodeInto( const unsigned char *inData, int inDataLength,
+                      char *outBase64, char inBreakLines = true );
+
+
+/**
+ * Gets the exact length that decoding base64 will produce.
+ *
+ * Scans the string, since line breaks and other ignored characters can
+ * appear anywhere.
+ *
+ * @param inBase64 the base64 characters (no \0 needed).
+ * @param inBase64Length the number of characters.
+ */
+int getBase64DecodedLength( const char *inBase64, int inBase64Length );
+
+
+/**
+ * Decodes base64 into a buffer.
+ *
+ * Like base64Decode, skips any characters that aren't base64 digits.
+ *
+ * @param inBase64 the base64 characters (no \0 needed).
+ * @param inBase64Length the number of characters.
+ * @param outData where decoded data should be written.
+ *   Must have room for getBase64DecodedLength() bytes, or for
+ *   ( inBase64Length / 4 ) * 3 + 2 bytes without scanning first.
+ *
+ * @return the number of bytes written.
+ */
+int base64DecodeInto( const char *inBase64, int inBase64Length,
+                      unsigned char *outData );
+
+
+
+
+
+/**
+ * Makes a binary delta that turns old data into new data.
+ *
+ * Matches runs of at least 16 bytes anywhere in the old data (with a
+ * rolling hash over the new data), so inserted, removed, or moved
+ * sections cost little more than their own size.  Unmatched bytes are
+ * stored literally, so a delta is never much bigger than the new data.
+ *
+ * Deltas aren't compressed, but copy and literal runs are laid out
+ * to zip well.
+ *
+ * @param inOldData the data that the delta will be applied to.
+ *   Destroyed by caller.
+ * @param inOldLength the length of inOldData.
+ * @param inNewData the data that applying the delta produces.
+ *   Destroyed by caller.
+ * @param inNewLength the length of inNewData.
+ * @param outDeltaLength pointer to where the length of the delta
+ *   should be returned.
+ *
+ * @return the delta.
+ *   Destroyed by caller.
+ */
+unsigned char *makeBinaryDelta( unsigned char *inOldData, int inOldLength,
+                                unsigned char *inNewData, int inNewLength,
+                                int *outDeltaLength );
+
+
+
+/**
+ * Applies a delta from makeBinaryDelta.
+ *
+ * @param inOldData the same old data that the delta was made from.
+ *   Destroyed by caller.
+ * @param inOldLength the length of inOldData.
+ * @param inDelta the delta.
+ *   Destroyed by caller.
+ * @param inDeltaLength the length of inDelta.
+ * @param outNewLength pointer to where the length of the new data
+ *   should be returned.
+ *
+ * @return the new data, or NULL if the delta is corrupt or reaches
+ *   outside of inOldData.
+ *   Applying a delta to different old data of sufficient length won't
+ *   fail, so callers should check a hash of the old data first.
+ *   Destroyed by caller.
+ */
+unsigned char *applyBinaryDelta( unsigned char *inOldData, int inOldLength,
+                                 unsigned char *inDelta, int inDeltaLength,
+                                 int *outNewLength );
+
+
+
 
 
 // implements zlib-compatible compression and decompression
+// (see ZipStream.h for streaming, reusable compressors)
 
 // return NULL on failure, caller destroys result
 
@@ -3,11 +3,16 @@
  *
  * 2003-September-22   Jason Rohrer
  * Created.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Added binary delta test.
  */
 
 
 #include "encodingUtils.h"
 
+#include "minorGems/util/SimpleVector.h"
+
 #include <stdio.h>
 #include <string.h>
 
@@ -85,5 +90,74 @@ int main() {
         delete [] compressed;
         }
 
+
+
+    // new version with a section inserted, one removed, and bytes changed
+    int oldLength = 100000;
+    unsigned char *oldData = new unsigned char[ oldLength ];
+    
+    unsigned int seed = 1;
+    for( int i=0; i<oldLength; i++ ) {
+        seed = seed * 1103515245 + 12345;
+        oldData[i] = (unsigned char)( seed >> 16 );
+        }
+    
+    SimpleVector<unsigned char> newVersion;
+    newVersion.push_back( oldData, 30000 );
+    newVersion.push_back( (unsigned char *)dataString, strlen( dataString ) );
+    newVersion.push_back( &( oldData[ 30000 ] ), 40000 );
+    newVersion.push_back( &( oldData[ 80000 ] ), 20000 );
+    
+    unsigned char *newData = newVersion.getElementArray();
+    int newLength = newVersion.size();
+    
+    newData[ 50000 ] ^= 0xFF;
+    newData[ 90000 ] ^= 0xFF;
+    
+    printf( "Making delta between %d and %d bytes\n", oldLength, newLength );
+    
+    int deltaLength;
+    unsigned char *delta = makeBinaryDelta( oldData, oldLength,
+                                            newData, newLength,
+                                            &deltaLength );
+    
+    printf( "Delta is %d bytes\n", deltaLength );
+    
+    int patchedLength;
+    unsigned char *patched = applyBinaryDelta( oldData, oldLength,
+                                               delta, deltaLength,
+                                               &patchedLength );
+    
+    if( patched != NULL && 
+        patchedLength == newLength &&
+        memcmp( patched, newData, newLength ) == 0 &&
+        deltaLength < 1000 ) {
+        printf( "Test passed\n" );
+        }
+    else {
+        printf( "Test failed\n" );
+        }
+    
+    if( patched != NULL ) {
+        delete [] patched;
+        }
+    
+    // truncated delta must be caught
+    patched = applyBinaryDelta( oldData, oldLength,
+                                delta, deltaLength - 1,
+                                &patchedLength );
+    
+    if( patched == NULL ) {
+        printf( "Test passed\n" );
+        }
+    else {
+        printf( "Test failed\n" );
+        delete [] patched;
+        }
+    
+    delete [] delta;
+    delete [] oldData;
+    delete [] newData;
+
     return 0;
     }
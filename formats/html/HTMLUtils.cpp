@@ -3,55 +3,110 @@
  *
  * 2002-September-12    Jason Rohrer
  * Created.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Text between tags copied in runs found with memchr, instead of one
+ * character at a time.  Versions that write into caller buffers and
+ * output streams.
  */
 
 
 
 #include "HTMLUtils.h"
 
-#include "minorGems/util/stringUtils.h"
-#include "minorGems/util/SimpleVector.h"
-
 #include <string.h>
 
 
 
-char *HTMLUtils::removeAllTags( char *inString ) {
-
-    SimpleVector<char> *returnStringVector = new SimpleVector<char>();
-
-
-    int stringLength = strlen( inString );
-
-    int i = 0;
-
-    while( i < stringLength ) {
+// finds next run of text outside of tags, starting at inPosition
+// returns false if there is none
+// tag without closing > runs to end of string
+static char nextTextRun( const char *inString, int inLength, 
+                         int *ioPosition, int *outRunStart, 
+                         int *outRunLength ) {
+    int i = *ioPosition;
+    
+    while( i < inLength ) {
         if( inString[i] == '<' ) {
             // the start of a tag
-
             // skip all until (and including) close of tag
-            while( i < stringLength && inString[i] != '>' ) {
-                // do nothing
-                i++;
+            const char *tagEnd = 
+                (const char *)memchr( &( inString[i] ), '>', 
+                                      inLength - i );
+            if( tagEnd == NULL ) {
+                break;
                 }
+            i = (int)( tagEnd - inString ) + 1;
             }
         else {
-            returnStringVector->push_back( inString[i] );
+            const char *tagStart = 
+                (const char *)memchr( &( inString[i] ), '<', 
+                                      inLength - i );
+            int runEnd = inLength;
+            
+            if( tagStart != NULL ) {
+                runEnd = (int)( tagStart - inString );
+                }
+            
+            *outRunStart = i;
+            *outRunLength = runEnd - i;
+            *ioPosition = runEnd;
+            return true;
             }
-        i++;
         }
-    
 
-    int numChars = returnStringVector->size();
-    char *returnString = new char[ numChars + 1 ];
+    *ioPosition = inLength;
+    return false;
+    }
+
+
+
+int HTMLUtils::removeAllTagsInto( const char *inString, int inLength,
+                                  char *outBuffer ) {
+    int outLength = 0;
+    int position = 0;
+    int runStart, runLength;
 
-    for( i=0; i<numChars; i++ ) {
-        returnString[i] = *( returnStringVector->getElement( i ) );
+    while( nextTextRun( inString, inLength, &position, 
+                        &runStart, &runLength ) ) {
+        memcpy( &( outBuffer[ outLength ] ), &( inString[ runStart ] ),
+                runLength );
+        outLength += runLength;
         }
 
-    returnString[ numChars ] = '\0';
+    outBuffer[ outLength ] = '\0';
 
-    delete returnStringVector;
+    return outLength;
+    }
+
+
+
+char *HTMLUtils::removeAllTags( char *inString ) {
+
+    int stringLength = strlen( inString );
+
+    // removing tags never lengthens
+    char *returnString = new char[ stringLength + 1 ];
+
+    removeAllTagsInto( inString, stringLength, returnString );
 
     return returnString;
     }
+
+
+
+char HTMLUtils::removeAllTags( const char *inString, int inLength,
+                               OutputStream *inStream ) {
+    int position = 0;
+    int runStart, runLength;
+
+    while( nextTextRun( inString, inLength, &position, 
+                        &runStart, &runLength ) ) {
+        if( inStream->write( (unsigned char *)&( inString[ runStart ] ),
+                             runLength ) != runLength ) {
+            return false;
+            }
+        }
+
+    return true;
+    }
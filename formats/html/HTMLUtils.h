@@ -3,6 +3,9 @@
  *
  * 2002-September-12    Jason Rohrer
  * Created.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Added versions that write into caller buffers and output streams.
  */
 
 
@@ -11,6 +14,9 @@
 #define HTML_UTILS_INCLUDED
 
 
+#include "minorGems/io/OutputStream.h"
+
+
 
 /**
  * Utilities for processing HTML.
@@ -37,6 +43,29 @@ class HTMLUtils {
          */
         static char *removeAllTags( char *inString );
 
+
+        
+        /**
+         * Removes all HTML tags from inLength characters of inString,
+         * writing result into a caller buffer, which needs room for
+         * inLength + 1 characters.
+         *
+         * @return the result length.  Result is \0-terminated.
+         */
+        static int removeAllTagsInto( const char *inString, int inLength,
+                                      char *outBuffer );
+
+
+        
+        /**
+         * Removes all HTML tags from inLength characters of inString,
+         * writing result into a stream.
+         *
+         * @return true on success, or false if stream write fails.
+         */
+        static char removeAllTags( const char *inString, int inLength,
+                                   OutputStream *inStream );
+
         
         
     };
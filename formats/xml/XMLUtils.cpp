@@ -3,81 +3,175 @@
  *
  * 2002-September-12    Jason Rohrer
  * Created.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Table-driven escaping, with output length computed first so that the
+ * result is allocated once.  Versions that write into caller buffers and
+ * output streams.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Escape tables are constant, instead of built on first use, where a
+ * thread building them could race with one already escaping.
  */
 
 
 
 #include "XMLUtils.h"
 
-#include "minorGems/util/stringUtils.h"
-#include "minorGems/util/SimpleVector.h"
-
 #include <string.h>
 
 
 
-char *XMLUtils::escapeDisallowedCharacters( char *inString ) {
+// entity for each character, or NULL for characters that pass through
+static const char * const xmlEscapes[256] = {
+    NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL, "&quot;", NULL, NULL, NULL, "&amp;", "&apos;",
+    NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL, NULL, NULL, "&lt;", NULL, "&gt;", NULL,
+    NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL };
+
+// length of each character once escaped
+static const unsigned char xmlEscapedLengths[256] = {
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 6, 1, 1, 1, 5, 6, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 4, 1, 4, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 };
+
+
+
+int XMLUtils::getEscapedLength( const char *inString, int inLength ) {
+    const unsigned char *in = (const unsigned char *)inString;
+
+    int length = 0;
+
+    for( int i=0; i<inLength; i++ ) {
+        length += xmlEscapedLengths[ in[i] ];
+        }
 
-    SimpleVector<char> *returnStringVector = new SimpleVector<char>();
+    return length;
+    }
 
 
-    int stringLength = strlen( inString );
 
-    int i;
-    for( i=0; i<stringLength; i++ ) {
-
-        switch( inString[i] ) {
-            case '&':
-                returnStringVector->push_back( '&' );
-                returnStringVector->push_back( 'a' );
-                returnStringVector->push_back( 'm' );
-                returnStringVector->push_back( 'p' );
-                returnStringVector->push_back( ';' );
-                break;
-            case '<':
-                returnStringVector->push_back( '&' );
-                returnStringVector->push_back( 'l' );
-                returnStringVector->push_back( 't' );
-                returnStringVector->push_back( ';' );
-                break;
-            case '>':
-                returnStringVector->push_back( '&' );
-                returnStringVector->push_back( 'g' );
-                returnStringVector->push_back( 't' );
-                returnStringVector->push_back( ';' );
-                break;
-            case '\"':
-                returnStringVector->push_back( '&' );
-                returnStringVector->push_back( 'q' );
-                returnStringVector->push_back( 'u' );
-                returnStringVector->push_back( 'o' );
-                returnStringVector->push_back( 't' );
-                returnStringVector->push_back( ';' );
-                break;
-            case '\'':
-                returnStringVector->push_back( '&' );
-                returnStringVector->push_back( 'a' );
-                returnStringVector->push_back( 'p' );
-                returnStringVector->push_back( 'o' );
-                returnStringVector->push_back( 's' );
-                returnStringVector->push_back( ';' );
-                break;
-            default:
-                returnStringVector->push_back( inString[i] );
-                break;
+int XMLUtils::escapeDisallowedCharactersInto( const char *inString,
+                                              int inLength,
+                                              char *outBuffer ) {
+    const unsigned char *in = (const unsigned char *)inString;
+
+    int outLength = 0;
+
+    for( int i=0; i<inLength; i++ ) {
+        const char *escape = xmlEscapes[ in[i] ];
+
+        if( escape == NULL ) {
+            outBuffer[ outLength++ ] = (char)( in[i] );
+            }
+        else {
+            int escapeLength = xmlEscapedLengths[ in[i] ];
+
+            memcpy( &( outBuffer[ outLength ] ), escape, escapeLength );
+            outLength += escapeLength;
             }
         }
 
-    int numChars = returnStringVector->size();
-    char *returnString = new char[ numChars + 1 ];
+    outBuffer[ outLength ] = '\0';
+
+    return outLength;
+    }
 
-    for( i=0; i<numChars; i++ ) {
-        returnString[i] = *( returnStringVector->getElement( i ) );
-        }
 
-    returnString[ numChars ] = '\0';
 
-    delete returnStringVector;
+char *XMLUtils::escapeDisallowedCharacters( char *inString ) {
+
+    int stringLength = strlen( inString );
+
+    char *returnString = 
+        new char[ getEscapedLength( inString, stringLength ) + 1 ];
+
+    escapeDisallowedCharactersInto( inString, stringLength, returnString );
 
     return returnString;
     }
+
+
+
+char XMLUtils::escapeDisallowedCharacters( const char *inString,
+                                           int inLength,
+                                           OutputStream *inStream ) {
+    const unsigned char *in = (const unsigned char *)inString;
+
+    // start of characters that pass through, written as one run
+    int runStart = 0;
+
+    for( int i=0; i<inLength; i++ ) {
+        const char *escape = xmlEscapes[ in[i] ];
+
+        if( escape != NULL ) {
+            int runLength = i - runStart;
+
+            if( runLength > 0 &&
+                inStream->write( (unsigned char *)&( in[ runStart ] ),
+                                 runLength ) != runLength ) {
+                return false;
+                }
+
+            int escapeLength = xmlEscapedLengths[ in[i] ];
+
+            if( inStream->write( (unsigned char *)escape, escapeLength )
+                != escapeLength ) {
+                return false;
+                }
+
+            runStart = i + 1;
+            }
+        }
+
+    int runLength = inLength - runStart;
+
+    if( runLength > 0 &&
+        inStream->write( (unsigned char *)&( in[ runStart ] ),
+                         runLength ) != runLength ) {
+        return false;
+        }
+
+    return true;
+    }
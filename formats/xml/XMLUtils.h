@@ -3,6 +3,9 @@
  *
  * 2002-September-12    Jason Rohrer
  * Created.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Added versions that write into caller buffers and output streams.
  */
 
 
@@ -11,6 +14,9 @@
 #define XML_UTILS_INCLUDED
 
 
+#include "minorGems/io/OutputStream.h"
+
+
 
 /**
  * Utilities for processing XML.
@@ -37,6 +43,39 @@ class XMLUtils {
          */
         static char *escapeDisallowedCharacters( char *inString );
 
+
+        
+        /**
+         * Gets the length that inLength characters of inString will have
+         * once escaped.
+         */
+        static int getEscapedLength( const char *inString, int inLength );
+
+
+        
+        /**
+         * Escapes inLength characters of inString into a caller buffer,
+         * which needs room for getEscapedLength( inString, inLength ) + 1
+         * characters.
+         *
+         * @return the escaped length.  Result is \0-terminated.
+         */
+        static int escapeDisallowedCharactersInto( const char *inString,
+                                                   int inLength,
+                                                   char *outBuffer );
+
+
+        
+        /**
+         * Escapes inLength characters of inString into a stream, without
+         * making an escaped copy.
+         *
+         * @return true on success, or false if stream write fails.
+         */
+        static char escapeDisallowedCharacters( const char *inString,
+                                                int inLength,
+                                                OutputStream *inStream );
+
         
         
     };
@@ -1,6 +1,9 @@
 #include "Font.h"
 
 #include "minorGems/graphics/RGBAImage.h"
+#include "minorGems/graphics/DistanceField.h"
+#include "minorGems/io/file/File.h"
+#include "minorGems/util/stringUtils.h"
 
 #include <string.h>
 #include <iostream>
@@ -96,14 +99,167 @@ size_t strlen(const unicode *u)
     return i;
 }
 
+
+
+// U+FFFF is a noncharacter, so this pair never comes up
+#define KERNING_EMPTY_KEY 0xFFFFFFFF
+
+
+static unsigned int kerningKey( unicode inFirst, unicode inSecond ) {
+    return (unsigned int)inFirst << 16 | inSecond;
+    }
+
+
+static int kerningSlot( unsigned int inKey, int inNumSlots ) {
+    // Fibonacci hashing, so pairs differing only in first character
+    // still spread out
+    return (int)( ( inKey * 2654435769U ) >> 7 ) & ( inNumSlots - 1 );
+    }
+
+
+
+KerningPairTable::KerningPairTable()
+        : mEntries( NULL ), mNumSlots( 0 ), mNumEntries( 0 ) {
+    }
+
+
+
+KerningPairTable::~KerningPairTable() {
+    clear();
+    }
+
+
+
+void KerningPairTable::clear() {
+    if( mEntries != NULL ) {
+        delete [] mEntries;
+        }
+    mEntries = NULL;
+    mNumSlots = 0;
+    mNumEntries = 0;
+    }
+
+
+
+void KerningPairTable::grow() {
+    KerningPair *oldEntries = mEntries;
+    int oldNumSlots = mNumSlots;
+    
+    mNumSlots = ( oldNumSlots == 0 ) ? 64 : oldNumSlots * 2;
+    mEntries = new KerningPair[ mNumSlots ];
+    
+    for( int i=0; i<mNumSlots; i++ ) {
+        mEntries[i].key = KERNING_EMPTY_KEY;
+        }
+    
+    for( int i=0; i<oldNumSlots; i++ ) {
+        if( oldEntries[i].key != KERNING_EMPTY_KEY ) {
+            int slot = kerningSlot( oldEntries[i].key, mNumSlots );
+            
+            while( mEntries[slot].key != KERNING_EMPTY_KEY ) {
+                slot = ( slot + 1 ) & ( mNumSlots - 1 );
+                }
+            mEntries[slot] = oldEntries[i];
+            }
+        }
+    
+    if( oldEntries != NULL ) {
+        delete [] oldEntries;
+        }
+    }
+
+
+
+void KerningPairTable::set( unicode inFirst, unicode inSecond, 
+                            short inOffset ) {
+    if( 2 * ( mNumEntries + 1 ) > mNumSlots ) {
+        grow();
+        }
+    
+    unsigned int key = kerningKey( inFirst, inSecond );
+    
+    int slot = kerningSlot( key, mNumSlots );
+    
+    while( mEntries[slot].key != KERNING_EMPTY_KEY ) {
+        if( mEntries[slot].key == key ) {
+            mEntries[slot].offset = inOffset;
+            return;
+            }
+        slot = ( slot + 1 ) & ( mNumSlots - 1 );
+        }
+    
+    mEntries[slot].key = key;
+    mEntries[slot].offset = inOffset;
+    mNumEntries++;
+    }
+
+
+
+char KerningPairTable::get( unicode inFirst, unicode inSecond, 
+                            short *outOffset ) {
+    if( mNumEntries == 0 ) {
+        return false;
+        }
+    
+    unsigned int key = kerningKey( inFirst, inSecond );
+    
+    int slot = kerningSlot( key, mNumSlots );
+    
+    // never full, so always reaches an empty slot for a missing pair
+    while( mEntries[slot].key != KERNING_EMPTY_KEY ) {
+        if( mEntries[slot].key == key ) {
+            *outOffset = mEntries[slot].offset;
+            return true;
+            }
+        slot = ( slot + 1 ) & ( mNumSlots - 1 );
+        }
+    
+    return false;
+    }
+
+
+
+void KerningPairTable::copyFrom( KerningPairTable *inOther ) {
+    clear();
+    
+    if( inOther->mEntries == NULL ) {
+        return;
+        }
+    
+    mNumSlots = inOther->mNumSlots;
+    mNumEntries = inOther->mNumEntries;
+    
+    mEntries = new KerningPair[ mNumSlots ];
+    memcpy( mEntries, inOther->mEntries, mNumSlots * sizeof( KerningPair ) );
+    }
+
+
 static int unicodeWide = 22;
 static double unicodeScale = 1.4;
 static int unicodeOffset = -5;
 static xCharTexture unicodeTex[65536];
 static SimpleVector<unicode> loadedUnicode; 
 
+// FreeType kerning for each unicode pair asked about so far, including
+// pairs with none, so each pair is only looked up once
+static KerningPairTable unicodeKerning;
+
+
+// see Font::toggleDistanceFields
+static char distanceFieldsOn = false;
+
+// set when FreeType face is loaded
+static char unicodeDistanceFields = false;
+
+// unicode glyphs are rendered at this many times their size to make their
+// distance fields, which get this many texels of padding for their outer
+// ramp and filtering
+#define GLYPH_FIELD_OVERSAMPLE 4
+#define GLYPH_FIELD_PADDING 2
+
  
-void xFreeTypeLib::load(const char* font_file , int _w , int _h)  
+void xFreeTypeLib::load(const char* font_file , int _w , int _h,
+                        char inDistanceFields)  
 {  
     FT_Library library;  
     if (FT_Init_FreeType( &library) )
@@ -119,41 +275,73 @@ void xFreeTypeLib::load(const char* font_file , int _w , int _h)
     }
     // select charmap  
     FT_Select_Charmap(mFTFace, FT_ENCODING_UNICODE);  
+    mOversample = inDistanceFields ? GLYPH_FIELD_OVERSAMPLE : 1;
+
     // set font width and height 
-    FT_Set_Pixel_Sizes(mFTFace, _w, _h);  
+    FT_Set_Pixel_Sizes(mFTFace, _w * mOversample, _h * mOversample);  
 }  
   
 char xFreeTypeLib::loadChar(unicode ch)  
 {  
-    if(unicodeTex[ch].mTex)  
-        return true;  
-    // load char image(will replace old char image)
-    if(FT_Load_Char(mFTFace, ch, FT_LOAD_DEFAULT))
+    xCharTexture *t = &unicodeTex[ch];
+
+    if(t->mLoaded)  
+        return t->mWidth > 0;  
+
+    t->mLoaded = true;
+    loadedUnicode.push_back(ch);
+
+    // load and render in one call
+    if(FT_Load_Char(mFTFace, ch, FT_LOAD_RENDER))
     {  
         return false;  
     }
   
-   
-    FT_Glyph glyph;  
-    // copy from glyph slot to glyph, this function return error code and set glyph
-    if(FT_Get_Glyph( mFTFace->glyph, &glyph ))  
-        return false;  
-  
-    // change to bitmap
-    FT_Glyph_To_Bitmap( &glyph, ft_render_mode_normal, 0, 1 );  
-  
-    // get bitmap  
-    FT_Bitmap& bitmap = ((FT_BitmapGlyph)glyph)->bitmap;  
+    FT_Bitmap& bitmap = mFTFace->glyph->bitmap;  
   
     int width = bitmap.width;  
     int height = bitmap.rows;  
 
+    if(width <= 0 || height <= 0)
+        return false;
+
+    if(mOversample > 1)
+    {
+        // bottom row first
+        unsigned char* mask = new unsigned char[width * height];
+        for(int j=0; j < height; j++)
+            memcpy(&mask[(height - j - 1) * width],
+                   &bitmap.buffer[bitmap.pitch*j], width);
+
+        int fieldW, fieldH;
+        unsigned char* field = makeDistanceField(mask, 1, width, height,
+                                                 mOversample,
+                                                 GLYPH_FIELD_PADDING,
+                                                 &fieldW, &fieldH);
+        delete [] mask;
+
+        unsigned char* pBuf = new unsigned char[fieldW * fieldH * 4];
+        for(int i=0; i < fieldW * fieldH; i++)
+        {
+            pBuf[4*i  ] = 0xFF;
+            pBuf[4*i+1] = 0xFF;
+            pBuf[4*i+2] = 0xFF;
+            pBuf[4*i+3] = field[i];
+        }
+        delete [] field;
+
+        t->mRGBA = pBuf;
+        t->mWidth = fieldW;
+        t->mHeight = fieldH;
+        return true;
+    }
+
     unsigned char* pBuf = new unsigned char[width * height * 4];  
     for(int j=0; j < height; j++)  
     {  
         for(int i=0; i < width; i++)  
         {  
-            unsigned char _vl = bitmap.buffer[i + bitmap.width*j];  
+            unsigned char _vl = bitmap.buffer[i + bitmap.pitch*j];  
             pBuf[(4*i + (height - j - 1) * width * 4)  ] = 0xFF;  
             pBuf[(4*i + (height - j - 1) * width * 4)+1] = 0xFF;  
             pBuf[(4*i + (height - j - 1) * width * 4)+2] = 0xFF;  
@@ -161,16 +349,47 @@ char xFreeTypeLib::loadChar(unicode ch)
         }  
     }  
 
-    unicodeTex[ch].mTex = new SingleTextureGL(pBuf, width, height, false, false);
-    unicodeTex[ch].mWidth = width;
-    unicodeTex[ch].mHeight = height;
-    loadedUnicode.push_back(ch);
-    delete[] pBuf;  
-    FT_Done_Glyph(glyph);
+    t->mRGBA = pBuf;
+    t->mWidth = width;
+    t->mHeight = height;
     return true;  
 }  
 
 
+int xFreeTypeLib::getKerning(unicode left, unicode right)
+{
+    if(!FT_HAS_KERNING(mFTFace))
+        return 0;
+
+    FT_Vector kerning;
+
+    if(FT_Get_Kerning(mFTFace,
+                      FT_Get_Char_Index(mFTFace, left),
+                      FT_Get_Char_Index(mFTFace, right),
+                      FT_KERNING_DEFAULT, &kerning))
+        return 0;
+
+    return kerning.x / mOversample;
+}
+
+
+int xFreeTypeLib::getCellSize()
+{
+    int h = mFTFace->size->metrics.height >> 6;
+    int w = mFTFace->size->metrics.max_advance >> 6;
+
+    int size = h > w ? h : w;
+
+    if(mOversample > 1)
+        size = (size + mOversample - 1) / mOversample +
+            2 * GLYPH_FIELD_PADDING;
+
+    // one pixel border on each side, so linear filtering doesn't pull
+    // in neighboring glyphs
+    return size + 2;
+}
+
+
 xFreeTypeLib g_FreeTypeLib;  
 
 
@@ -179,6 +398,269 @@ xCharTexture* getTextChar(unicode ch)
     char result = g_FreeTypeLib.loadChar(ch);  
     return result ? &unicodeTex[ch] : NULL;  
 }
+
+
+
+// Glyph atlas
+// Pages are divided into a grid of equal slots, one glyph per slot.
+// Once all pages are full, the least-recently-drawn glyph is evicted.
+
+#define GLYPH_PAGE_SIZE 512
+#define GLYPH_MAX_PAGES 4
+
+
+typedef struct GlyphSlot {
+        // 0 if free
+        unicode ch;
+        unsigned int lastUsed;
+    } GlyphSlot;
+
+
+static SingleTextureGL *glyphPages[ GLYPH_MAX_PAGES ];
+static int numGlyphPages = 0;
+
+static int glyphCellSize = 0;
+static int glyphCellsPerRow = 0;
+static int glyphCellsPerPage = 0;
+
+static SimpleVector<GlyphSlot> glyphSlots;
+
+// bumped for each string drawn
+// glyphs used by current string are never evicted
+static unsigned int glyphUseStamp = 0;
+
+// one cell of RGBA, reused for each upload
+static unsigned char *glyphCellBytes = NULL;
+
+
+// x, y, u, v for each corner of each queued glyph quad, per page
+static SimpleVector<float> glyphQuads[ GLYPH_MAX_PAGES ];
+static int numQueuedGlyphs = 0;
+
+// fade multiplier for queued glyphs (erased font is drawn faint)
+static float glyphQuadFade = 1.0f;
+
+
+// distance field sharpness (see toggleDistanceFieldTextures) for the
+// drawing font's sprites and for unicode glyphs, picked by beginGlyphs
+// 0 for glyphs that aren't distance fields
+static int spriteSharpness = 0;
+static int unicodeSharpness = 0;
+
+// what's set now
+static int glyphSharpness = 0;
+
+static char savedLinearMagFilter = false;
+
+
+static void setGlyphSharpness( int inSharpness ) {
+    if( inSharpness != glyphSharpness ) {
+        toggleDistanceFieldTextures( inSharpness > 0, inSharpness );
+        glyphSharpness = inSharpness;
+        }
+    }
+
+
+
+// keeps edge ramp of a distance field with texels inTexelPixels wide on
+// screen at about one pixel
+static int getFieldSharpness( double inTexelPixels, float inAlpha ) {
+    if( inAlpha < 1 ) {
+        // sharpening ignores draw alpha
+        return 1;
+        }
+    
+    double rampPixels = 2 * DISTANCE_FIELD_SPREAD * inTexelPixels;
+    
+    if( rampPixels >= 4 ) {
+        return 4;
+        }
+    if( rampPixels >= 2 ) {
+        return 2;
+        }
+    return 1;
+    }
+
+
+
+static void drawGlyphQuads() {
+    if( numQueuedGlyphs == 0 ) {
+        return;
+        }
+    
+    // direct GL drawing below
+    flushSpriteBatch();
+    
+    setGlyphSharpness( unicodeSharpness );
+    
+    float alpha = getDrawColor().a;
+    if( glyphQuadFade != 1.0f ) {
+        setDrawFade( alpha * glyphQuadFade );
+        }
+    
+    for( int p=0; p<numGlyphPages; p++ ) {
+        int numFloats = glyphQuads[p].size();
+        
+        if( numFloats == 0 ) {
+            continue;
+            }
+        
+        SingleTextureGL *page = glyphPages[p];
+        page->enable();
+        
+        if( page->mLastSetMinFilter != 1 ) {
+            glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+            page->mLastSetMinFilter = 1;
+            }
+        if( page->mLastSetMagFilter != 1 ) {
+            glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+            page->mLastSetMagFilter = 1;
+            }
+        
+        float *q = glyphQuads[p].getElementFast( 0 );
+        
+        glBegin( GL_QUADS );
+        for( int i=0; i<numFloats; i+=4 ) {
+            glTexCoord2f( q[i+2], q[i+3] );
+            glVertex2f( q[i], q[i+1] );
+            }
+        glEnd();
+        
+        glyphQuads[p].shrink( 0 );
+        }
+    
+    if( glyphQuadFade != 1.0f ) {
+        setDrawFade( alpha );
+        }
+    
+    numQueuedGlyphs = 0;
+    }
+
+
+
+static void freeGlyphAtlas() {
+    for( int i=0; i<numGlyphPages; i++ ) {
+        delete glyphPages[i];
+        glyphPages[i] = NULL;
+        glyphQuads[i].deleteAll();
+        }
+    numGlyphPages = 0;
+    numQueuedGlyphs = 0;
+    
+    glyphSlots.deleteAll();
+    
+    if( glyphCellBytes != NULL ) {
+        delete [] glyphCellBytes;
+        glyphCellBytes = NULL;
+        }
+    glyphCellSize = 0;
+    }
+
+
+
+// returns false if glyph must be drawn from its own texture
+static char placeGlyph( xCharTexture *inTex, unicode inCh ) {
+    if( inTex->mSlot >= 0 ) {
+        glyphSlots.getElementFast( inTex->mSlot )->lastUsed = glyphUseStamp;
+        return true;
+        }
+    
+    if( glyphCellSize == 0 ) {
+        glyphCellSize = g_FreeTypeLib.getCellSize();
+        glyphCellsPerRow = GLYPH_PAGE_SIZE / glyphCellSize;
+        glyphCellsPerPage = glyphCellsPerRow * glyphCellsPerRow;
+        glyphCellBytes = new unsigned char[ glyphCellSize * glyphCellSize * 4 ];
+        }
+    
+    if( inTex->mWidth > glyphCellSize - 2 || 
+        inTex->mHeight > glyphCellSize - 2 ||
+        glyphCellsPerPage == 0 ) {
+        return false;
+        }
+    
+
+    int slot = -1;
+    
+    if( glyphSlots.size() < numGlyphPages * glyphCellsPerPage ) {
+        GlyphSlot s = { 0, 0 };
+        glyphSlots.push_back( s );
+        slot = glyphSlots.size() - 1;
+        }
+    else if( numGlyphPages < GLYPH_MAX_PAGES ) {
+        int numBytes = GLYPH_PAGE_SIZE * GLYPH_PAGE_SIZE * 4;
+        unsigned char *blank = new unsigned char[ numBytes ];
+        memset( blank, 0, numBytes );
+        
+        glyphPages[ numGlyphPages ] = 
+            new SingleTextureGL( blank, GLYPH_PAGE_SIZE, GLYPH_PAGE_SIZE,
+                                 false, false );
+        numGlyphPages++;
+        
+        delete [] blank;
+
+        GlyphSlot s = { 0, 0 };
+        glyphSlots.push_back( s );
+        slot = glyphSlots.size() - 1;
+        }
+    else {
+        // evict least recently used
+        unsigned int oldest = glyphUseStamp;
+        
+        int numSlots = glyphSlots.size();
+        for( int i=0; i<numSlots; i++ ) {
+            GlyphSlot *s = glyphSlots.getElementFast( i );
+            
+            if( slot == -1 || s->lastUsed < oldest ) {
+                slot = i;
+                oldest = s->lastUsed;
+                }
+            }
+        
+        if( oldest == glyphUseStamp ) {
+            // every slot used by current string
+            // draw what's queued before slot is overwritten
+            drawGlyphQuads();
+            }
+        
+        unicode oldCh = glyphSlots.getElementFast( slot )->ch;
+        if( oldCh != 0 ) {
+            unicodeTex[ oldCh ].mSlot = -1;
+            }
+        }
+    
+
+    GlyphSlot *s = glyphSlots.getElementFast( slot );
+    s->ch = inCh;
+    s->lastUsed = glyphUseStamp;
+    
+    inTex->mSlot = slot;
+    
+    
+    // white, transparent border and background around glyph
+    int cellBytes = glyphCellSize * glyphCellSize * 4;
+    for( int i=0; i<cellBytes; i+=4 ) {
+        glyphCellBytes[i] = 0xFF;
+        glyphCellBytes[i+1] = 0xFF;
+        glyphCellBytes[i+2] = 0xFF;
+        glyphCellBytes[i+3] = 0;
+        }
+    for( int y=0; y<inTex->mHeight; y++ ) {
+        memcpy( &( glyphCellBytes[ ( ( y + 1 ) * glyphCellSize + 1 ) * 4 ] ),
+                &( inTex->mRGBA[ y * inTex->mWidth * 4 ] ),
+                inTex->mWidth * 4 );
+        }
+    
+    int pageSlot = slot % glyphCellsPerPage;
+    
+    glyphPages[ slot / glyphCellsPerPage ]->replaceTextureSubData(
+        glyphCellBytes,
+        ( pageSlot % glyphCellsPerRow ) * glyphCellSize,
+        ( pageSlot / glyphCellsPerRow ) * glyphCellSize,
+        glyphCellSize, glyphCellSize );
+    
+    return true;
+    }
+
   
 void init(int size)  
 {  
@@ -187,7 +669,9 @@ void init(int size)
     unicodeOffset = SettingsManager::getIntSetting( "unicodeOffset", -5 );
 
     size *= unicodeScale;
-    g_FreeTypeLib.load("graphics/font.ttf", size, size);  
+    unicodeDistanceFields = distanceFieldsOn;
+    g_FreeTypeLib.load("graphics/font.ttf", size, size, 
+                       unicodeDistanceFields);  
 }  
   
 static int fontCount = 0;
@@ -197,6 +681,7 @@ Font::Font( const char *inFileName, int inCharSpacing, int inSpaceWidth,
         : mScaleFactor( inScaleFactor ),
           mCharSpacing( inCharSpacing ), mSpaceWidth( inSpaceWidth ),
           mFixedWidth( inFixedWidth ), mEnableKerning( true ),
+          mDistanceField( false ),
           mMinimumPositionPrecision( 0 ) {
 
     if(strcmp(inFileName, "font_pencil_erased_32_32.tga") == 0)
@@ -209,12 +694,36 @@ Font::Font( const char *inFileName, int inCharSpacing, int inSpaceWidth,
 
     for( int i=0; i<256; i++ ) {
         mSpriteMap[i] = NULL;
-        mKerningTable[i] = NULL;
     }
 
 
 
-    Image *spriteImage = readTGAFile( inFileName );
+    Image *spriteImage = NULL;
+    
+    if( distanceFieldsOn ) {
+        char *baseName = stringDuplicate( inFileName );
+        
+        char *dotPos = strrchr( baseName, '.' );
+        if( dotPos != NULL ) {
+            dotPos[0] = '\0';
+            }
+        
+        char *fieldName = autoSprintf( "%s.sdf.tga", baseName );
+        delete [] baseName;
+        
+        File fieldFile( new Path( "graphics" ), fieldName );
+        
+        if( fieldFile.exists() ) {
+            spriteImage = readTGAFile( fieldName );
+            
+            mDistanceField = ( spriteImage != NULL );
+            }
+        delete [] fieldName;
+        }
+    
+    if( spriteImage == NULL ) {
+        spriteImage = readTGAFile( inFileName );
+        }
     
     if( spriteImage != NULL ) {
         
@@ -451,14 +960,9 @@ Font::Font( const char *inFileName, int inCharSpacing, int inSpaceWidth,
             for( int i=0; i<256; i++ ) {
                 if( savedCharacterRGBA[i] != NULL ) {
                 
-                    mKerningTable[i] = new KerningTable;
-
-
                     // for each character that could come after this character
                     for( int j=0; j<256; j++ ) {
 
-                        mKerningTable[i]->offset[j] = 0;
-
                         // not a blank character
                         if( savedCharacterRGBA[j] != NULL ) {
                         
@@ -505,7 +1009,7 @@ Font::Font( const char *inFileName, int inCharSpacing, int inSpaceWidth,
                                 // horizontally at all
                                 && minDistance < mCharWidth[i] ) {
                             
-                                mKerningTable[i]->offset[j] = - minDistance;
+                                mKerningPairs.set( i, j, - minDistance );
                                 }
                             }
                         }
@@ -533,13 +1037,12 @@ Font::Font( const char *inFileName, int inCharSpacing, int inSpaceWidth,
 
 
 Font::~Font() {
+    clearLayoutCache( this );
+    
     for( int i=0; i<256; i++ ) {
         if( mSpriteMap[i] != NULL ) {
             freeSprite( mSpriteMap[i] );
             }
-        if( mKerningTable[i] != NULL ) {
-            delete mKerningTable[i];
-            }
         }
 
     fontCount--;
@@ -547,36 +1050,32 @@ Font::~Font() {
         int numTextures = loadedUnicode.size();
         for(int i = 0; i < numTextures; ++i) {
             unicode u = loadedUnicode.getElementDirect(i);
-            delete unicodeTex[u].mTex;
-            unicodeTex[u].mTex = NULL;
+            xCharTexture *t = &unicodeTex[u];
+            if(t->mTex != NULL)
+                delete t->mTex;
+            if(t->mRGBA != NULL)
+                delete [] t->mRGBA;
+            *t = xCharTexture();
         }
         loadedUnicode.deleteAll();
+        unicodeKerning.clear();
+        freeGlyphAtlas();
     }
     }
 
 
 
 void Font::copySpacing( Font *inOtherFont ) {
+    // cached layouts use old spacing
+    clearLayoutCache( this );
+    
     memcpy( mCharLeftEdgeOffset, inOtherFont->mCharLeftEdgeOffset,
             256 * sizeof( int ) );
 
     memcpy( mCharWidth, inOtherFont->mCharWidth,
             256 * sizeof( int ) );
     
-
-    for( int i=0; i<256; i++ ) {
-        if( mKerningTable[i] != NULL ) {
-            delete mKerningTable[i];
-            mKerningTable[i] = NULL;
-            }
-
-        if( inOtherFont->mKerningTable[i] != NULL ) {
-            mKerningTable[i] = new KerningTable;
-            memcpy( mKerningTable[i]->offset,
-                    inOtherFont->mKerningTable[i]->offset,
-                    256 * sizeof( short ) );
-            }
-        }
+    mKerningPairs.copyFrom( &( inOtherFont->mKerningPairs ) );
 
     mScaleFactor = inOtherFont->mScaleFactor;
         
@@ -602,42 +1101,146 @@ static double scaleFactor = 1.0 / 16;
 //static double scaleFactor = 1.0 / 8;
 
 
-void Font::drawChar(unicode c, doublePair inCenter) {
+void Font::queueChar(unicode c, doublePair inCenter) {
     double scale = scaleFactor * mScaleFactor;
     if(c < 128) {
-        if(mSpriteMap[c] != NULL)
+        if(mSpriteMap[c] != NULL) {
+            setGlyphSharpness( spriteSharpness );
             drawSprite( mSpriteMap[c], inCenter, scale );
+        }
         return;
     }
 
     xCharTexture* pCharTex = getTextChar(c);  
     if(pCharTex == NULL)
         return;
-    float alpha = getDrawColor().a;
-    if(isErased)
-        setDrawFade(alpha * 0.1);
-    
-    pCharTex->mTex->enable();
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);  
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);  
 
     int w = pCharTex->mWidth; 
     int h = pCharTex->mHeight;
     int ch_x = inCenter.x - w / 2 + unicodeOffset;
     int ch_y = inCenter.y - h / 2;
-    glBegin ( GL_QUADS );
-    {  
-        glTexCoord2f(0.0f, 1.0f); glVertex2f(ch_x, ch_y + h);  
-        glTexCoord2f(1.0f, 1.0f); glVertex2f(ch_x + w, ch_y + h);  
-        glTexCoord2f(1.0f, 0.0f); glVertex2f(ch_x + w, ch_y);  
-        glTexCoord2f(0.0f, 0.0f); glVertex2f(ch_x, ch_y);  
-    }  
-    glEnd();  
 
-    if(isErased)
-        setDrawFade(alpha);
+    if(!placeGlyph(pCharTex, c)) {
+        // too big for atlas slot, draw from own texture now
+        if(pCharTex->mTex == NULL)
+            pCharTex->mTex = new SingleTextureGL(pCharTex->mRGBA, w, h,
+                                                 false, false);
+
+        float alpha = getDrawColor().a;
+        if(isErased)
+            setDrawFade(alpha * 0.1);
+    
+        // direct GL drawing below
+        flushSpriteBatch();
+
+        setGlyphSharpness( unicodeSharpness );
+
+        pCharTex->mTex->enable();
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);  
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);  
+
+        glBegin ( GL_QUADS );
+        {  
+            glTexCoord2f(0.0f, 1.0f); glVertex2f(ch_x, ch_y + h);  
+            glTexCoord2f(1.0f, 1.0f); glVertex2f(ch_x + w, ch_y + h);  
+            glTexCoord2f(1.0f, 0.0f); glVertex2f(ch_x + w, ch_y);  
+            glTexCoord2f(0.0f, 0.0f); glVertex2f(ch_x, ch_y);  
+        }  
+        glEnd();  
+
+        if(isErased)
+            setDrawFade(alpha);
+        return;
+    }
+
+    glyphQuadFade = isErased ? 0.1f : 1.0f;
+
+    // glyph sits inside one-pixel border of its slot
+    int pageSlot = pCharTex->mSlot % glyphCellsPerPage;
+    int slotX = ( pageSlot % glyphCellsPerRow ) * glyphCellSize + 1;
+    int slotY = ( pageSlot / glyphCellsPerRow ) * glyphCellSize + 1;
+
+    float u0 = slotX / (float)GLYPH_PAGE_SIZE;
+    float v0 = slotY / (float)GLYPH_PAGE_SIZE;
+    float u1 = ( slotX + w ) / (float)GLYPH_PAGE_SIZE;
+    float v1 = ( slotY + h ) / (float)GLYPH_PAGE_SIZE;
+
+    float quad[16] = {
+        (float)ch_x, (float)( ch_y + h ), u0, v1,
+        (float)( ch_x + w ), (float)( ch_y + h ), u1, v1,
+        (float)( ch_x + w ), (float)ch_y, u1, v0,
+        (float)ch_x, (float)ch_y, u0, v0 };
+
+    glyphQuads[ pCharTex->mSlot / glyphCellsPerPage ].push_back( quad, 16 );
+    numQueuedGlyphs++;
+}
+
+
+void Font::drawChar(unicode c, doublePair inCenter) {
+    glyphUseStamp++;
+    beginGlyphs();
+    queueChar(c, inCenter);
+    drawGlyphQuads();
+    endGlyphs();
 }
 
+
+
+void Font::beginGlyphs() {
+    spriteSharpness = 0;
+    unicodeSharpness = 0;
+
+    savedLinearMagFilter = getLinearMagFilterOn();
+    
+    if( ! mDistanceField && ! unicodeDistanceFields ) {
+        return;
+        }
+    
+    double pixelsPerUnit = 1;
+    
+    double minX, minY, maxX, maxY;
+    getVisibleWorldRect( &minX, &minY, &maxX, &maxY );
+    
+    if( maxX > minX ) {
+        GLint viewport[4];
+        glGetIntegerv( GL_VIEWPORT, viewport );
+        
+        pixelsPerUnit = viewport[2] / ( maxX - minX );
+        }
+    
+    float alpha = getDrawColor().a * getTotalGlobalFade();
+    
+    if( mDistanceField ) {
+        // shaded sprite batches sharpen before applying draw alpha
+        spriteSharpness = 
+            getFieldSharpness( scaleFactor * mScaleFactor * pixelsPerUnit,
+                               isSpriteShadingOn() ? 1 : alpha );
+        
+        // fields must be interpolated
+        toggleLinearMagFilter( true );
+        }
+    
+    if( unicodeDistanceFields ) {
+        // unicode glyphs are drawn one texel per world unit
+        unicodeSharpness = 
+            getFieldSharpness( pixelsPerUnit, 
+                               isErased ? alpha * 0.1f : alpha );
+        }
+    }
+
+
+
+void Font::endGlyphs() {
+    setGlyphSharpness( 0 );
+    toggleLinearMagFilter( savedLinearMagFilter );
+    }
+
+
+
+void Font::toggleDistanceFields( char inOn ) {
+    distanceFieldsOn = inOn;
+    }
+
 double Font::getCharSpacing() {
     double scale = scaleFactor * mScaleFactor;
     
@@ -645,21 +1248,198 @@ double Font::getCharSpacing() {
     }
 
 
+// Layout cache
+// Set-associative, keyed by (string hash, font, kerning flag).
+// Holds decoded string, per-character positions relative to string start,
+// and width, which are all independent of where string is drawn.
+
+#define LAYOUT_CACHE_NUM_SETS 256
+#define LAYOUT_CACHE_WAYS 4
+
+// longer strings aren't cached
+#define LAYOUT_CACHE_MAX_LENGTH 1024
+
+
+static StringLayout layoutCache[ LAYOUT_CACHE_NUM_SETS * LAYOUT_CACHE_WAYS ];
+
+static unsigned int layoutCacheStamp = 0;
+
+static int layoutCacheHits = 0;
+static int layoutCacheMisses = 0;
+
+
+
+static unsigned int hashString( const char *inString, int *outLength ) {
+    // FNV-1a
+    unsigned int hash = 2166136261U;
+    
+    int i = 0;
+    while( inString[i] != '\0' ) {
+        hash ^= (unsigned char)inString[i];
+        hash *= 16777619U;
+        i++;
+        }
+    *outLength = i;
+    return hash;
+    }
+
+
+
+static void clearLayout( StringLayout *inLayout ) {
+    if( inLayout->string != NULL ) {
+        delete [] inLayout->string;
+        delete [] inLayout->codes;
+        delete [] inLayout->offsets;
+        }
+    inLayout->font = NULL;
+    inLayout->string = NULL;
+    inLayout->codes = NULL;
+    inLayout->offsets = NULL;
+    inLayout->numChars = 0;
+    }
+
+
+
+void Font::clearLayoutCache( Font *inFont ) {
+    for( int i=0; i<LAYOUT_CACHE_NUM_SETS * LAYOUT_CACHE_WAYS; i++ ) {
+        if( inFont == NULL || layoutCache[i].font == inFont ) {
+            clearLayout( &( layoutCache[i] ) );
+            }
+        }
+    }
+
+
+
+StringLayout *Font::getLayout( const char *inString ) {
+    int length;
+    unsigned int hash = hashString( inString, &length );
+    
+    if( length > LAYOUT_CACHE_MAX_LENGTH ) {
+        return NULL;
+        }
+    
+    layoutCacheStamp++;
+
+    StringLayout *set = 
+        &( layoutCache[ ( hash % LAYOUT_CACHE_NUM_SETS ) * 
+                        LAYOUT_CACHE_WAYS ] );
+    
+    StringLayout *victim = NULL;
+    
+    for( int w=0; w<LAYOUT_CACHE_WAYS; w++ ) {
+        StringLayout *l = &( set[w] );
+        
+        if( l->font == this && 
+            l->hash == hash &&
+            l->kerning == mEnableKerning &&
+            strcmp( l->string, inString ) == 0 ) {
+            
+            l->lastUsed = layoutCacheStamp;
+            layoutCacheHits++;
+            return l;
+            }
+
+        if( victim == NULL || 
+            ( victim->font != NULL && 
+              ( l->font == NULL || l->lastUsed < victim->lastUsed ) ) ) {
+            victim = l;
+            }
+        }
+    
+    layoutCacheMisses++;
+
+    clearLayout( victim );
+    
+    victim->font = this;
+    victim->hash = hash;
+    victim->kerning = mEnableKerning;
+    victim->lastUsed = layoutCacheStamp;
+    
+    victim->string = new char[ length + 1 ];
+    memcpy( victim->string, inString, length + 1 );
+    
+    // never more code points than bytes
+    victim->codes = new unicode[ length + 1 ];
+    utf8ToUnicode( inString, victim->codes );
+    
+    victim->numChars = strlen( victim->codes );
+
+    victim->width = measureString( victim->codes );
+    
+    SimpleVector<doublePair> offsets( victim->numChars );
+    
+    doublePair origin = { 0, 0 };
+    victim->endOffset = layoutChars( &offsets, victim->codes, 
+                                     victim->numChars, origin );
+    
+    victim->offsets = new doublePair[ victim->numChars ];
+    for( int i=0; i<victim->numChars; i++ ) {
+        victim->offsets[i] = offsets.getElementDirect( i );
+        }
+    
+    return victim;
+    }
+
+
+
+int Font::getLayoutCacheHits() {
+    return layoutCacheHits;
+    }
+
+
+int Font::getLayoutCacheMisses() {
+    return layoutCacheMisses;
+    }
+
+
+void Font::resetLayoutCacheCounts() {
+    layoutCacheHits = 0;
+    layoutCacheMisses = 0;
+    }
+
+
+
 double Font::getCharPos( SimpleVector<doublePair> *outPositions,
                          const char *inString, doublePair inPosition,
                          TextAlignment inAlign ) {
-    unicode unicodeString[strlen(inString)];
+    StringLayout *layout = getLayout( inString );
+    
+    if( layout != NULL ) {
+        doublePair start = getStringStart( layout->width, inPosition, 
+                                           inAlign );
+        
+        for( int i=0; i<layout->numChars; i++ ) {
+            outPositions->push_back( add( start, layout->offsets[i] ) );
+            }
+        return start.x + layout->endOffset;
+        }
+    
+    unicode unicodeString[strlen(inString) + 1];
     utf8ToUnicode(inString, unicodeString);
     return getCharPos(outPositions, unicodeString, inPosition, inAlign);
 }
 double Font::getCharPos( SimpleVector<doublePair> *outPositions,
                          const unicode *inString, doublePair inPosition,
                          TextAlignment inAlign ) {
+    
+    double stringWidth = 0;
+    
+    if( inAlign != alignLeft ) {
+        stringWidth = measureString( inString );
+        }
+    
+    doublePair start = getStringStart( stringWidth, inPosition, inAlign );
+    
+    return layoutChars( outPositions, inString, strlen( inString ), start );
+    }
+
+
+
+doublePair Font::getStringStart( double inStringWidth, doublePair inPosition,
+                                 TextAlignment inAlign ) {
 
     double scale = scaleFactor * mScaleFactor;
     
-    unsigned int numChars = strlen( inString );
-    
     double x = inPosition.x;
     
     
@@ -671,18 +1451,12 @@ double Font::getCharPos( SimpleVector<doublePair> *outPositions,
         }
 
     
-    double stringWidth = 0;
-    
-    if( inAlign != alignLeft ) {
-        stringWidth = measureString( inString );
-        }
-    
     switch( inAlign ) {
         case alignCenter:
-            x -= stringWidth / 2;
+            x -= inStringWidth / 2;
             break;
         case alignRight:
-            x -= stringWidth;
+            x -= inStringWidth;
             break;
         default:
             // left?  do nothing
@@ -702,6 +1476,22 @@ double Font::getCharPos( SimpleVector<doublePair> *outPositions,
         x *= mMinimumPositionPrecision;
         }
     
+    doublePair start = { x, y };
+    return start;
+    }
+
+
+
+double Font::layoutChars( SimpleVector<doublePair> *outPositions,
+                          const unicode *inString, unsigned int inNumChars,
+                          doublePair inStart ) {
+    
+    double scale = scaleFactor * mScaleFactor;
+    
+    unsigned int numChars = inNumChars;
+    
+    double x = inStart.x;
+    double y = inStart.y;
 
     for( unsigned int i=0; i<numChars; i++ ) {
         doublePair charPos = { x, y };
@@ -714,16 +1504,10 @@ double Font::getCharPos( SimpleVector<doublePair> *outPositions,
         
         x += charWidth + mCharSpacing * scale;
         
-        if( !mFixedWidth && mEnableKerning 
-            && i < numChars - 1 
-            && inString[i] < 128
-            && inString[i+1] < 128
-            && mKerningTable[ inString[i] ] != NULL ) {
+        if( !mFixedWidth && i < numChars - 1 ) {
             // there's another character after this
             // apply true kerning adjustment to the pair
-            int offset = mKerningTable[ inString[i] ]->
-                offset[ inString[i+1] ];
-            x += offset * scale;
+            x += getKerning( inString[i], inString[i+1] );
             }
         }
     // no spacing after last character
@@ -735,16 +1519,42 @@ double Font::getCharPos( SimpleVector<doublePair> *outPositions,
 
 double Font::drawString( const char *inString, doublePair inPosition,
                          TextAlignment inAlign ) {
-    unicode unicodeString[strlen(inString)];
+    
+    // one batch per glyph atlas page for whole string
+    glyphUseStamp++;
+
+    StringLayout *layout = getLayout( inString );
+    
+    beginGlyphs();
+    
+    if( layout != NULL ) {
+        doublePair start = getStringStart( layout->width, inPosition, 
+                                           inAlign );
+        
+        for( int i=0; i<layout->numChars; i++ ) {
+            queueChar( layout->codes[i], add( start, layout->offsets[i] ) );
+            }
+        
+        drawGlyphQuads();
+        endGlyphs();
+        
+        return start.x + layout->endOffset;
+        }
+    
+
+    unicode unicodeString[strlen(inString) + 1];
     utf8ToUnicode(inString, unicodeString);
     SimpleVector<doublePair> pos( strlen( unicodeString ) );
 
     double returnVal = getCharPos( &pos, unicodeString, inPosition, inAlign );
     
     for( int i=0; i<pos.size(); i++ ) {
-        drawChar(unicodeString[i], pos.getElementDirect(i));
+        queueChar(unicodeString[i], pos.getElementDirect(i));
         }
     
+    drawGlyphQuads();
+    endGlyphs();
+    
     return returnVal;
     }
 
@@ -797,7 +1607,16 @@ void Font::drawCharacterSprite( unicode inC, doublePair inPosition ) {
     }
 
 double Font::measureString( const char *inString, int inCharLimit ) {
-    unicode unicodeString[strlen(inString)];
+    StringLayout *layout = getLayout( inString );
+    
+    if( layout != NULL ) {
+        if( inCharLimit == -1 ) {
+            return layout->width;
+            }
+        return measureString( layout->codes, inCharLimit );
+        }
+
+    unicode unicodeString[strlen(inString) + 1];
     utf8ToUnicode(inString, unicodeString);
     return measureString(unicodeString, inCharLimit);
 }
@@ -825,16 +1644,10 @@ double Font::measureString( const unicode *inString, int inCharLimit ) {
         else {
             width += ( c < 128 ? mCharWidth[ c ] : unicodeWide ) * scale;
 
-            if( mEnableKerning
-                && i < numChars - 1
-                && inString[i] < 128
-                && inString[i+1] < 128
-                && mKerningTable[ inString[i] ] != NULL ) {
+            if( i < numChars - 1 ) {
                 // there's another character after this
                 // apply true kerning adjustment to the pair
-                int offset = mKerningTable[ inString[i] ]->
-                    offset[ inString[i+1] ];
-                width += offset * scale;
+                width += getKerning( inString[i], inString[i+1] );
                 }
             }
     
@@ -852,6 +1665,38 @@ double Font::measureString( const unicode *inString, int inCharLimit ) {
 
 
 
+double Font::getKerning( unicode inFirst, unicode inSecond ) {
+    if( ! mEnableKerning ) {
+        return 0;
+        }
+    
+    short offset;
+
+    if( inFirst < 128 && inSecond < 128 ) {
+        if( mKerningPairs.get( inFirst, inSecond, &offset ) ) {
+            return offset * scaleFactor * mScaleFactor;
+            }
+        return 0;
+        }
+    
+    if( inFirst < 128 || inSecond < 128 ) {
+        // different fonts, nothing to kern between
+        return 0;
+        }
+    
+    if( ! unicodeKerning.get( inFirst, inSecond, &offset ) ) {
+        // 26.6 fixed point is small enough for a short at any sane
+        // pixel size
+        offset = (short)g_FreeTypeLib.getKerning( inFirst, inSecond );
+        unicodeKerning.set( inFirst, inSecond, offset );
+        }
+
+    // unicode glyphs are drawn one pixel per world unit
+    return offset / 64.0;
+    }
+
+
+
 double Font::getFontHeight() {
     double accentFactor = 1.0f;
     
@@ -18,40 +18,136 @@ enum TextAlignment {
 
 
 
-// a table for a given character
-// extra kerning offsets for each character that could follow
-// this character
-typedef struct KerningTable {
-        short offset[256];
-    } KerningTable;
+typedef unsigned short unicode;
 
 
-typedef unsigned short unicode;
+
+// extra kerning offsets for character pairs, hashed by pair
+// (open addressing, so a lookup is usually one probe into one array)
+// pairs that aren't in the table have no entry, which callers can treat
+// as an offset of 0
+class KerningPairTable {
+    public:
+        
+        KerningPairTable();
+        ~KerningPairTable();
+        
+        // adds pair, or replaces its offset
+        void set( unicode inFirst, unicode inSecond, short inOffset );
+        
+        // returns false if pair has no entry
+        char get( unicode inFirst, unicode inSecond, short *outOffset );
+        
+        int size() {
+            return mNumEntries;
+            }
+        
+        void clear();
+        
+        void copyFrom( KerningPairTable *inOther );
+        
+    private:
+        
+        typedef struct KerningPair {
+                // first character in high 16 bits, second in low
+                unsigned int key;
+                short offset;
+            } KerningPair;
+        
+        // power of 2, kept at most half full
+        // NULL until first pair added
+        KerningPair *mEntries;
+        int mNumSlots;
+        int mNumEntries;
+        
+        void grow();
+    };
 
 
 struct xCharTexture  
 {  
-    SingleTextureGL  *mTex;  
+    // rasterized glyph, white with coverage in alpha, bottom row first
+    // kept after upload, so that a glyph evicted from the atlas can be
+    // packed again without another FT_Load_Char
+    unsigned char *mRGBA;
     int     mWidth;  
     int     mHeight;  
+
+    // true once FreeType has been asked for this glyph
+    // (even if it failed or glyph is empty)
+    char    mLoaded;
+
+    // index of atlas slot holding glyph, or -1 if not resident
+    int     mSlot;
+
+    // own texture, only for glyphs too big for an atlas slot
+    SingleTextureGL  *mTex;  
 public:  
     xCharTexture()  
     {  
-        mTex  = NULL;  
+        mRGBA = NULL;
         mWidth  = 0;  
         mHeight = 0;  
+        mLoaded = false;
+        mSlot = -1;
+        mTex  = NULL;  
     }  
 };  
 
 class xFreeTypeLib  
 {  
     FT_Face    mFTFace;  
+
+    // when making distance fields, glyphs are rendered this many times
+    // bigger and shrunk while making their fields, 1 otherwise
+    int mOversample;
   
 public:  
-    void load(const char* fontFile , int _w , int _h);  
+    xFreeTypeLib() : mOversample( 1 ) {}
+
+    // if inDistanceFields is set, glyphs are loaded as distance fields
+    // with the same size (plus padding)
+    void load(const char* fontFile , int _w , int _h,
+              char inDistanceFields = false);  
     char loadChar(unicode ch);  
+
+    // kerning between two glyphs of loaded face, in 26.6 fixed-point
+    // pixels, 0 if face has no kerning
+    int getKerning(unicode left, unicode right);
+
+    // atlas slot size needed for glyphs of loaded face, including border
+    int getCellSize();
 };  
 
+class Font;
+
+
+// cached result of laying out a string with a given font
+typedef struct StringLayout {
+        // NULL if unused
+        Font *font;
+        unsigned int hash;
+        char kerning;
+        
+        unsigned int lastUsed;
+        
+        char *string;
+
+        unicode *codes;
+        int numChars;
+        
+        // draw position of each character relative to string start
+        doublePair *offsets;
+        
+        // end of string relative to start, as returned by getCharPos
+        double endOffset;
+        
+        // as returned by measureString
+        double width;
+    } StringLayout;
+
+
+
 class Font {
         
     public:
@@ -123,11 +219,64 @@ class Font {
 
         void drawChar(unicode c, doublePair inCenter);
 
+
+        // drawString, measureString, and getCharPos calls on utf8 strings 
+        // use a shared, bounded cache of string layouts
+        // these count cache lookups since last reset
+        static int getLayoutCacheHits();
+        static int getLayoutCacheMisses();
+        static void resetLayoutCacheCounts();
+        
+
+        // distance field mode, off by default, set before making fonts
+        // when on, glyphs stay sharp when drawn bigger than their pixels:
+        //   TGA fonts are read from name.sdf.tga instead when that file
+        //   exists (see the distanceFieldFont tool)
+        //   unicode glyphs are made into distance fields as they load
+        static void toggleDistanceFields( char inOn );
+        
+
     private:        
         
+        // NULL if string too long to cache
+        // result only valid until next call
+        StringLayout *getLayout( const char *inString );
+        
+        // NULL to clear all
+        static void clearLayoutCache( Font *inFont );
+        
+        // finds start of string from alignment and precision settings
+        doublePair getStringStart( double inStringWidth, 
+                                   doublePair inPosition,
+                                   TextAlignment inAlign );
+        
+        // returns x coordinate of string end
+        double layoutChars( SimpleVector<doublePair> *outPositions,
+                            const unicode *inString, 
+                            unsigned int inNumChars,
+                            doublePair inStart );
+        
+        
+        // picks how distance field glyphs are sharpened for the current
+        // view and draw color, before queueChar calls
+        // endGlyphs goes back to normal drawing after
+        void beginGlyphs();
+        static void endGlyphs();
+        
+        // queues non-ascii glyphs for drawing with one batch per atlas
+        // page (ascii sprites are drawn right away)
+        // queued glyphs are drawn by drawString/drawChar before returning
+        void queueChar( unicode c, doublePair inCenter );
+        
         // returns x coordinate to right of drawn character
         double positionCharacter( unicode inC, doublePair inTargetPos,
                                   doublePair *outActualPos );
+        
+        // extra offset between a pair of characters, in world units
+        // ascii pairs use kerning found from the bitmap font, and
+        // unicode pairs use the FreeType face's kerning (cached per pair)
+        // 0 for mixed pairs, or if kerning off
+        double getKerning( unicode inFirst, unicode inSecond );
 
         
         double mScaleFactor;
@@ -155,13 +304,15 @@ class Font {
         int mCharWidth[ 256 ];
         
         
-        // sparse
-        // contains NULL for every blank character
-        KerningTable *mKerningTable[256];
+        // only pairs with a non-zero offset
+        KerningPairTable mKerningPairs;
         
 
         char mEnableKerning;
 
+        // true if sprites were made from a distance field sheet
+        char mDistanceField;
+
         double mMinimumPositionPrecision;
 
         char isErased = false;
@@ -0,0 +1,246 @@
+#include "SpatialGrid.h"
+
+#include "minorGems/game/gameGraphics.h"
+
+#include <math.h>
+
+
+
+SpatialGrid::SpatialGrid( double inCellSize )
+        : mCellSize( inCellSize ),
+          mNumItems( 0 ),
+          mQueryStamp( 0 ),
+          mCells( 64 ) {
+    }
+
+
+
+SpatialGrid::~SpatialGrid() {
+    removeAll();
+    }
+
+
+
+int SpatialGrid::getCellCoord( double inWorldCoord ) {
+    return (int)floor( inWorldCoord / mCellSize );
+    }
+
+
+
+int SpatialGrid::getCellKey( int inCX, int inCY ) {
+    // 16 bits each, wrapping for far-off cells
+    return (int)( ( (unsigned int)inCX << 16 ) ^
+                  ( (unsigned int)inCY & 0xFFFF ) );
+    }
+
+
+
+void SpatialGrid::addToCells( int inHandle ) {
+    GridItem *g = mItems.getElement( inHandle );
+
+    for( int cy = g->minCY; cy <= g->maxCY; cy++ ) {
+        for( int cx = g->minCX; cx <= g->maxCX; cx++ ) {
+            int key = getCellKey( cx, cy );
+
+            SimpleVector<int> *cell = NULL;
+
+            if( ! mCells.lookup( key, &cell ) ) {
+                cell = new SimpleVector<int>();
+                mCells.insert( key, cell );
+                }
+
+            // wrapped cells within one item's range can share a key
+            if( cell->size() == 0 ||
+                cell->getLastElementDirect() != inHandle ) {
+                cell->push_back( inHandle );
+                }
+            }
+        }
+    }
+
+
+
+void SpatialGrid::removeFromCells( int inHandle ) {
+    GridItem *g = mItems.getElement( inHandle );
+
+    for( int cy = g->minCY; cy <= g->maxCY; cy++ ) {
+        for( int cx = g->minCX; cx <= g->maxCX; cx++ ) {
+            SimpleVector<int> *cell = NULL;
+
+            if( mCells.lookup( getCellKey( cx, cy ), &cell ) ) {
+                // order within cell doesn't matter
+                for( int i=0; i<cell->size(); i++ ) {
+                    if( cell->getElementDirect( i ) == inHandle ) {
+                        *( cell->getElement( i ) ) =
+                            cell->getLastElementDirect();
+                        cell->deleteLastElement();
+                        break;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+
+
+int SpatialGrid::insert( void *inItem,
+                         double inMinX, double inMinY,
+                         double inMaxX, double inMaxY ) {
+    int handle;
+
+    if( mFreeHandles.size() > 0 ) {
+        handle = mFreeHandles.getLastElementDirect();
+        mFreeHandles.deleteLastElement();
+        }
+    else {
+        GridItem blank = GridItem();
+        blank.used = false;
+        mItems.push_back( blank );
+        handle = mItems.size() - 1;
+        }
+
+    GridItem *g = mItems.getElement( handle );
+
+    g->item = inItem;
+    g->queryStamp = mQueryStamp;
+    g->used = true;
+
+    mNumItems ++;
+
+    // sets box and adds to cells
+    g->minCX = 0;
+    g->maxCX = -1;
+    g->minCY = 0;
+    g->maxCY = -1;
+
+    move( handle, inMinX, inMinY, inMaxX, inMaxY );
+
+    return handle;
+    }
+
+
+
+void SpatialGrid::move( int inHandle,
+                        double inMinX, double inMinY,
+                        double inMaxX, double inMaxY ) {
+    GridItem *g = mItems.getElement( inHandle );
+
+    g->minX = inMinX;
+    g->minY = inMinY;
+    g->maxX = inMaxX;
+    g->maxY = inMaxY;
+
+    int minCX = getCellCoord( inMinX );
+    int minCY = getCellCoord( inMinY );
+    int maxCX = getCellCoord( inMaxX );
+    int maxCY = getCellCoord( inMaxY );
+
+    if( minCX == g->minCX && minCY == g->minCY &&
+        maxCX == g->maxCX && maxCY == g->maxCY ) {
+        // same cells, most moves
+        return;
+        }
+
+    removeFromCells( inHandle );
+
+    // removeFromCells can't have moved mItems
+    g->minCX = minCX;
+    g->minCY = minCY;
+    g->maxCX = maxCX;
+    g->maxCY = maxCY;
+
+    addToCells( inHandle );
+    }
+
+
+
+void SpatialGrid::remove( int inHandle ) {
+    GridItem *g = mItems.getElement( inHandle );
+
+    if( ! g->used ) {
+        return;
+        }
+
+    removeFromCells( inHandle );
+
+    g->used = false;
+    g->item = NULL;
+
+    mFreeHandles.push_back( inHandle );
+    mNumItems --;
+    }
+
+
+
+void SpatialGrid::removeAll() {
+    for( int i=0; i<mCells.getNumSlots(); i++ ) {
+        if( mCells.isSlotFilled( i ) ) {
+            delete *( mCells.getSlotValue( i ) );
+            }
+        }
+    mCells.deleteAll();
+
+    mItems.deleteAll();
+    mFreeHandles.deleteAll();
+    mNumItems = 0;
+    }
+
+
+
+int SpatialGrid::size() {
+    return mNumItems;
+    }
+
+
+
+void SpatialGrid::query( double inMinX, double inMinY,
+                         double inMaxX, double inMaxY,
+                         SimpleVector<void*> *outItems ) {
+    mQueryStamp ++;
+
+    int minCX = getCellCoord( inMinX );
+    int minCY = getCellCoord( inMinY );
+    int maxCX = getCellCoord( inMaxX );
+    int maxCY = getCellCoord( inMaxY );
+
+    for( int cy = minCY; cy <= maxCY; cy++ ) {
+        for( int cx = minCX; cx <= maxCX; cx++ ) {
+            SimpleVector<int> *cell = NULL;
+
+            if( ! mCells.lookup( getCellKey( cx, cy ), &cell ) ) {
+                continue;
+                }
+
+            int numInCell = cell->size();
+
+            for( int i=0; i<numInCell; i++ ) {
+                GridItem *g =
+                    mItems.getElement( cell->getElementDirect( i ) );
+
+                if( g->queryStamp == mQueryStamp ) {
+                    // already checked through another cell
+                    continue;
+                    }
+                g->queryStamp = mQueryStamp;
+
+                if( g->maxX >= inMinX && g->minX <= inMaxX &&
+                    g->maxY >= inMinY && g->minY <= inMaxY ) {
+                    outItems->push_back( g->item );
+                    }
+                }
+            }
+        }
+    }
+
+
+
+void SpatialGrid::queryView( SimpleVector<void*> *outItems,
+                             double inMargin ) {
+    double minX, minY, maxX, maxY;
+
+    getVisibleWorldRect( &minX, &minY, &maxX, &maxY );
+
+    query( minX - inMargin, minY - inMargin,
+           maxX + inMargin, maxY + inMargin, outItems );
+    }
@@ -0,0 +1,102 @@
+#ifndef SPATIAL_GRID_INCLUDED
+#define SPATIAL_GRID_INCLUDED
+
+
+#include "minorGems/util/SimpleVector.h"
+#include "minorGems/util/HashMap.h"
+
+
+
+// Uniform grid over world space, for finding the drawables near a
+// rectangle (usually the view) without looking at every one of them.
+//
+// Items are caller pointers registered with a world-space bounding box.
+// An item is listed in every cell its box touches, so cell size should be
+// around the size of a typical item.  Only cells that hold items take up
+// space, so the grid has no bounds.
+//
+// Items are not destroyed by the grid.
+class SpatialGrid {
+
+    public:
+
+        SpatialGrid( double inCellSize );
+
+        ~SpatialGrid();
+
+
+        // returns a handle for moving or removing the item
+        int insert( void *inItem,
+                    double inMinX, double inMinY,
+                    double inMaxX, double inMaxY );
+
+        void move( int inHandle,
+                   double inMinX, double inMinY,
+                   double inMaxX, double inMaxY );
+
+        void remove( int inHandle );
+
+        void removeAll();
+
+        int size();
+
+
+        // appends each item whose box overlaps a rectangle to outItems,
+        // once, in no particular order
+        void query( double inMinX, double inMinY,
+                    double inMaxX, double inMaxY,
+                    SimpleVector<void*> *outItems );
+
+        // same, for rectangle visible with current view, grown by
+        // inMargin on each side
+        // (see getVisibleWorldRect in gameGraphics.h)
+        void queryView( SimpleVector<void*> *outItems, double inMargin = 0 );
+
+
+    protected:
+
+        typedef struct GridItem {
+                void *item;
+
+                double minX, minY, maxX, maxY;
+
+                // cell range
+                int minCX, minCY, maxCX, maxCY;
+
+                // last query that returned this item
+                unsigned int queryStamp;
+
+                char used;
+            } GridItem;
+
+
+        double mCellSize;
+
+        SimpleVector<GridItem> mItems;
+
+        // handles of unused slots in mItems
+        SimpleVector<int> mFreeHandles;
+
+        int mNumItems;
+
+        unsigned int mQueryStamp;
+
+        // handles of items in each cell, by cell key
+        // far-apart cells may share a key, so items found through a
+        // cell are still checked against the query rectangle
+        HashMap<int, SimpleVector<int>*> mCells;
+
+
+        int getCellCoord( double inWorldCoord );
+
+        static int getCellKey( int inCX, int inCY );
+
+        void addToCells( int inHandle );
+
+        void removeFromCells( int inHandle );
+
+    };
+
+
+
+#endif
@@ -11,6 +11,7 @@
 
 
 #include "minorGems/util/random/JenkinsRandomSource.h"
+#include "minorGems/network/web/WebResponseSink.h"
 
 
 
@@ -91,6 +92,604 @@ static const char *platformCode = "";
 
 static char writeError = false;
 
+
+
+// takes a diff bundle as it downloads, hashing and decompressing it on
+// the way, so the compressed bundle is never held in memory whole
+// bundle is raw and compressed sizes as text, followed by zlib data
+class BundleResponseSink : public WebResponseSink {
+    public:
+        
+        BundleResponseSink() {
+            reset();
+            }
+
+
+        void reset() {
+            mPrefix.deleteAll();
+            mRawSize = -1;
+            mCompSize = -1;
+            mCompReceived = 0;
+            mFailed = false;
+            
+            SHA1_Init( &mHashContext );
+            
+            mDecompressor.reset();
+            mRawData.deleteAll();
+            }
+
+        
+        virtual char write( const unsigned char *inData, int inLength ) {
+            if( mFailed ) {
+                return false;
+                }
+            
+            while( mCompSize == -1 && inLength > 0 ) {
+                // still reading sizes, a byte at a time
+                
+                if( ! parsePrefix( inData[0] ) ) {
+                    mFailed = true;
+                    return false;
+                    }
+                inData = &( inData[1] );
+                inLength --;
+                }
+            
+            if( inLength > mCompSize - mCompReceived ) {
+                // ignore anything past end of compressed data
+                inLength = mCompSize - mCompReceived;
+                }
+            
+            if( inLength <= 0 ) {
+                return true;
+                }
+
+            SHA1_Update( &mHashContext, inData, inLength );
+            mCompReceived += inLength;
+
+            if( ! mDecompressor.decompress( 
+                    inData, inLength, &mRawData,
+                    mRawSize - mRawData.size() ) ) {
+                mFailed = true;
+                return false;
+                }
+            return true;
+            }
+
+
+        // true once all compressed data received
+        char isComplete() {
+            return ( mCompSize != -1 && mCompReceived == mCompSize );
+            }
+
+
+        // returns raw bundle data, destroyed by caller, or NULL on failure
+        // outRawSize set to -1 if bundle sizes couldn't be parsed
+        unsigned char *getRawData( int *outRawSize ) {
+            if( mRawSize <= 0 || mCompSize <= 0 ) {
+                *outRawSize = -1;
+                return NULL;
+                }
+            
+            *outRawSize = mRawSize;
+            
+            if( mFailed || 
+                mCompReceived != mCompSize ||
+                ! mDecompressor.isFinished() ||
+                mRawData.size() != mRawSize ) {
+                
+                printf( "zipDecompress expecting %d result bytes, got %d\n",
+                        mRawSize, mRawData.size() );
+                return NULL;
+                }
+            
+            unsigned char digest[ SHA1_DIGEST_LENGTH ];
+            SHA1_Final( digest, &mHashContext );
+            
+            char *hash = hexEncode( digest, SHA1_DIGEST_LENGTH );
+            
+            AppLog::infoF( "Received compressed data with SHA1 = %s\n",
+                           hash );
+            delete [] hash;
+            
+            unsigned char *rawData = mRawData.getElementArray();
+
+            // free our copy right away
+            mRawData.deleteAll();
+            
+            return rawData;
+            }
+        
+
+    protected:
+        
+        // returns false on badly formed sizes
+        char parsePrefix( unsigned char inByte ) {
+            mPrefix.push_back( inByte );
+
+            if( mPrefix.size() > 64 ) {
+                return false;
+                }
+            
+            char *prefix = mPrefix.getElementString();
+            
+            // each int followed by one separator character, as read by
+            // scanIntAndSkip
+            char *end;
+            int rawSize = strtol( prefix, &end, 10 );
+            
+            if( end != prefix && end[0] != '\0' ) {
+                char *compStart = &( end[1] );
+                
+                int compSize = strtol( compStart, &end, 10 );
+                
+                if( end != compStart && end[0] != '\0' ) {
+                    mRawSize = rawSize;
+                    mCompSize = compSize;
+                    }
+                }
+            
+            delete [] prefix;
+            
+            if( mCompSize != -1 && ( mRawSize <= 0 || mCompSize <= 0 ) ) {
+                return false;
+                }
+            
+            return true;
+            }
+
+        
+        SimpleVector<char> mPrefix;
+        
+        int mRawSize;
+        int mCompSize;
+        int mCompReceived;
+
+        char mFailed;
+
+        SHA_CTX mHashContext;
+        
+        ZipDecompressor mDecompressor;
+        
+        SimpleVector<unsigned char> mRawData;
+    };
+
+
+// outlives any request it is given to
+static BundleResponseSink bundleSink;
+
+
+
+// A bundle is downloaded in segments, several at a time over parallel
+// connections with HTTP Range requests, and from several mirrors when
+// there are more than one.  A segment that fails resumes from where it
+// left off, on the next mirror.
+//
+// Segments must reach bundleSink in order, so later segments are held
+// in memory until earlier ones are done, and only a window of segments
+// ahead of the earliest unfinished one is fetched at a time.
+//
+// The first segment is fetched alone, to find out whether ranges are
+// supported.  If the server sends the whole bundle instead, it becomes
+// a single-connection download (still resumable without ranges, by
+// skipping what was already received).
+
+#define BUNDLE_SEGMENT_SIZE 524288
+#define BUNDLE_MAX_CONNECTIONS 4
+#define BUNDLE_SEGMENT_WINDOW 8
+
+// failures in a row, without getting any data, before a mirror is
+// given up on
+#define BUNDLE_MAX_SOURCE_FAILURES 3
+
+
+class BundleSegment : public WebResponseSink {
+    public:
+        
+        BundleSegment( int inStart, int inLength )
+                : mStart( inStart ), mLength( inLength ),
+                  mReceived( 0 ), mFed( 0 ),
+                  mWebHandle( -1 ), mSource( -1 ),
+                  mRequestStartReceived( 0 ), mSkip( 0 ),
+                  mAllowWholeBody( false ) {
+            }
+
+
+        virtual char write( const unsigned char *inData, int inLength ) {
+            if( mSkip == -1 ) {
+                // first body data for this request
+                
+                int status = getWebStatusCode( mWebHandle );
+                
+                if( status == 206 ) {
+                    mSkip = 0;
+                    }
+                else if( status == 200 && mAllowWholeBody ) {
+                    // whole body, skip what we already have
+                    mSkip = mReceived;
+                    mLength = mWholeLength;
+                    }
+                else {
+                    return false;
+                    }
+                }
+            
+            if( mSkip > 0 ) {
+                int numSkipped = inLength;
+                if( numSkipped > mSkip ) {
+                    numSkipped = mSkip;
+                    }
+                inData = &( inData[ numSkipped ] );
+                inLength -= numSkipped;
+                mSkip -= numSkipped;
+                }
+
+            if( inLength > mLength - mReceived ) {
+                // ignore anything past end of segment
+                inLength = mLength - mReceived;
+                }
+            
+            if( inLength > 0 ) {
+                mData.appendArray( (unsigned char*)inData, inLength );
+                mReceived += inLength;
+                }
+            
+            return true;
+            }
+        
+
+        // offset in bundle
+        int mStart;
+        int mLength;
+        
+        int mReceived;
+        
+        // bytes passed on to bundleSink (and dropped from mData)
+        int mFed;
+        
+        // received bytes past mFed
+        SimpleVector<unsigned char> mData;
+        
+        // -1 if no request running
+        int mWebHandle;
+        
+        // index into bundleSources of current or last request
+        int mSource;
+        
+        // mReceived when current or last request started
+        int mRequestStartReceived;
+        
+        // body bytes left to skip in current request, or -1 if there
+        // hasn't been any body yet
+        int mSkip;
+        
+        // true if a 200 response (no range support) can be taken
+        // for this segment, which must then start at 0
+        char mAllowWholeBody;
+        
+        // length of bundle, for a whole-body response
+        int mWholeLength;
+    };
+
+
+
+static SimpleVector<BundleSegment*> bundleSegments;
+
+// not destroyed here
+static SimpleVector<char*> bundleSources;
+
+static SimpleVector<int> bundleSourceFailures;
+
+static int bundleSize = -1;
+
+// -1 until first segment response, then true or false
+static int bundleRangesSupported = -1;
+
+// index of first segment not yet passed on completely
+static int bundleFeedSegment = 0;
+
+static int bundleNextSource = 0;
+
+static char bundleDownloading = false;
+
+// source of direct (non-mirror) download
+static char *directUpdateURL = NULL;
+
+
+
+static void clearBundleDownload() {
+    for( int i=0; i<bundleSegments.size(); i++ ) {
+        BundleSegment *seg = bundleSegments.getElementDirect( i );
+    
+        if( seg->mWebHandle != -1 ) {
+            clearWebRequest( seg->mWebHandle );
+            }
+        delete seg;
+        }
+    bundleSegments.deleteAll();
+    bundleSources.deleteAll();
+    bundleSourceFailures.deleteAll();
+    
+    bundleDownloading = false;
+    }
+
+
+
+// inURLs destroyed by caller after download is cleared
+// inSize is download size, or -1 if not known
+static void startBundleDownload( char **inURLs, int inNumURLs, int inSize ) {
+    clearBundleDownload();
+    
+    bundleSink.reset();
+    
+    for( int i=0; i<inNumURLs; i++ ) {
+        bundleSources.push_back( inURLs[i] );
+        bundleSourceFailures.push_back( 0 );
+        }
+    
+    bundleSize = inSize;
+    bundleRangesSupported = -1;
+    bundleFeedSegment = 0;
+    bundleNextSource = 0;
+
+    if( bundleSize <= BUNDLE_SEGMENT_SIZE ) {
+        // one request, no ranges
+        // (length of unknown size limited by bundleSink)
+        BundleSegment *seg = new BundleSegment( 0, bundleSize );
+        
+        if( bundleSize <= 0 ) {
+            seg->mLength = 0x7FFFFFFF;
+            }
+        seg->mWholeLength = seg->mLength;
+        bundleSegments.push_back( seg );
+        bundleRangesSupported = false;
+        }
+    else {
+        for( int start=0; start < bundleSize; 
+             start += BUNDLE_SEGMENT_SIZE ) {
+            
+            int length = bundleSize - start;
+            if( length > BUNDLE_SEGMENT_SIZE ) {
+                length = BUNDLE_SEGMENT_SIZE;
+                }
+            bundleSegments.push_back( new BundleSegment( start, length ) );
+            }
+        bundleSegments.getElementDirect( 0 )->mWholeLength = bundleSize;
+        }
+    
+    bundleDownloading = true;
+    }
+
+
+
+// returns false if out of sources
+static char startSegmentRequest( BundleSegment *inSegment ) {
+    int numSources = bundleSources.size();
+    
+    // next source with failures to spare, taking turns
+    int source = -1;
+    
+    for( int i=0; i<numSources; i++ ) {
+        int s = ( bundleNextSource + i ) % numSources;
+        
+        if( bundleSourceFailures.getElementDirect( s ) < 
+            BUNDLE_MAX_SOURCE_FAILURES ) {
+            source = s;
+            break;
+            }
+        }
+    
+    if( source == -1 ) {
+        return false;
+        }
+    
+    bundleNextSource = source + 1;
+    
+    
+    inSegment->mSource = source;
+    inSegment->mRequestStartReceived = inSegment->mReceived;
+    inSegment->mSkip = -1;
+    inSegment->mAllowWholeBody = 
+        ( inSegment->mStart == 0 && bundleRangesSupported != true );
+    
+    inSegment->mWebHandle = 
+        startWebRequest( "GET", bundleSources.getElementDirect( source ),
+                         NULL );
+    
+    setWebResponseSink( inSegment->mWebHandle, inSegment );
+    
+    if( bundleRangesSupported != false ) {
+        setWebRequestRange( 
+            inSegment->mWebHandle,
+            inSegment->mStart + inSegment->mReceived,
+            inSegment->mStart + inSegment->mLength - 1 );
+        }
+    else if( inSegment->mReceived > 0 ) {
+        printf( "Resuming update download at byte %d "
+                "(server doesn't support ranges, re-fetching start)\n",
+                inSegment->mReceived );
+        }
+    
+    return true;
+    }
+
+
+
+// returns 1 when bundle received, -1 on error, 0 if still downloading
+static int stepBundleDownload() {
+    
+    for( int i=bundleFeedSegment; i<bundleSegments.size(); i++ ) {
+        BundleSegment *seg = bundleSegments.getElementDirect( i );
+        
+        if( seg->mWebHandle == -1 ) {
+            continue;
+            }
+        
+        int result = stepWebRequest( seg->mWebHandle );
+        
+        if( bundleRangesSupported == -1 && seg->mSkip != -1 ) {
+            // first segment has its answer
+            
+            if( getWebStatusCode( seg->mWebHandle ) == 206 ) {
+                bundleRangesSupported = true;
+                }
+            else {
+                bundleRangesSupported = false;
+                
+                // it has taken over whole bundle
+                while( bundleSegments.size() > 1 ) {
+                    delete bundleSegments.getElementDirect( 1 );
+                    bundleSegments.deleteElement( 1 );
+                    }
+                }
+            }
+        
+        if( result == 0 ) {
+            continue;
+            }
+
+        clearWebRequest( seg->mWebHandle );
+        seg->mWebHandle = -1;
+        
+        if( result == 1 && bundleSize <= 0 ) {
+            // size wasn't known, whatever we got is the whole thing
+            // (checked by bundleSink)
+            seg->mLength = seg->mReceived;
+            }
+
+        if( result == 1 && 
+            ( seg->mReceived == seg->mLength || bundleSink.isComplete() ) ) {
+            // done
+            *( bundleSourceFailures.getElement( seg->mSource ) ) = 0;
+            continue;
+            }
+        
+        // failed or came up short, resume on next turn
+        
+        if( seg->mReceived == seg->mRequestStartReceived ) {
+            // only count failures that got nowhere, so a connection
+            // that keeps dropping still finishes eventually
+            (*( bundleSourceFailures.getElement( seg->mSource ) ) )++;
+            }
+        
+        printf( "Update segment at byte %d failed after %d of %d bytes "
+                "from %s\n",
+                seg->mStart, seg->mReceived, seg->mLength,
+                bundleSources.getElementDirect( seg->mSource ) );
+        }
+    
+
+    // pass on everything that's in order
+    while( bundleFeedSegment < bundleSegments.size() ) {
+        BundleSegment *seg = 
+            bundleSegments.getElementDirect( bundleFeedSegment );
+        
+        int numNew = seg->mReceived - seg->mFed;
+        
+        if( numNew > 0 ) {
+            if( ! bundleSink.write( seg->mData.getElementFast( 0 ), 
+                                    numNew ) ) {
+                printf( "Update download corrupt\n" );
+                return -1;
+                }
+            seg->mFed += numNew;
+            seg->mData.deleteAll();
+            }
+        
+        if( bundleSink.isComplete() ) {
+            // anything past is extra
+            bundleFeedSegment = bundleSegments.size();
+            }
+        else if( seg->mFed == seg->mLength && seg->mWebHandle == -1 ) {
+            bundleFeedSegment ++;
+            }
+        else {
+            break;
+            }
+        }
+    
+    if( bundleFeedSegment == bundleSegments.size() ) {
+        // stop any requests for extra segments
+        for( int i=0; i<bundleSegments.size(); i++ ) {
+            BundleSegment *seg = bundleSegments.getElementDirect( i );
+            
+            if( seg->mWebHandle != -1 ) {
+                clearWebRequest( seg->mWebHandle );
+                seg->mWebHandle = -1;
+                }
+            seg->mData.deleteAll();
+            }
+        return 1;
+        }
+    
+    
+    // keep connections busy
+    int maxRunning = 1;
+    if( bundleRangesSupported == true ) {
+        maxRunning = BUNDLE_MAX_CONNECTIONS;
+        }
+
+    int numRunning = 0;
+    
+    int windowEnd = bundleFeedSegment + BUNDLE_SEGMENT_WINDOW;
+    
+    if( windowEnd > bundleSegments.size() ) {
+        windowEnd = bundleSegments.size();
+        }
+    
+    for( int i=bundleFeedSegment; i<windowEnd; i++ ) {
+        if( bundleSegments.getElementDirect( i )->mWebHandle != -1 ) {
+            numRunning++;
+            }
+        }
+    
+    for( int i=bundleFeedSegment; 
+         i<windowEnd && numRunning < maxRunning; i++ ) {
+        
+        BundleSegment *seg = bundleSegments.getElementDirect( i );
+        
+        if( seg->mWebHandle == -1 && seg->mReceived < seg->mLength ) {
+            
+            if( ! startSegmentRequest( seg ) ) {
+                printf( "Update download failed on all mirrors\n" );
+                return -1;
+                }
+            numRunning++;
+            }
+        }
+    
+    return 0;
+    }
+
+
+
+// fraction of bundle received
+static float getBundleProgress() {
+    if( bundleSegments.size() > 0 &&
+        bundleFeedSegment == bundleSegments.size() ) {
+        return 1;
+        }
+    
+    if( bundleSize <= 0 ) {
+        return 0;
+        }
+    
+    int received = 0;
+    
+    for( int i=0; i<bundleSegments.size(); i++ ) {
+        received += bundleSegments.getElementDirect( i )->mReceived;
+        }
+    
+    float progress = received / (float)bundleSize;
+    
+    if( progress > 1 ) {
+        progress = 1;
+        }
+    return progress;
+    }
+
+
+
 char wasUpdateWriteError() {
     return writeError;
     }
@@ -199,37 +798,105 @@ static void dumpRawDataToFile( unsigned char *inRawBundleData,
 
 
 
-// returns 1 on success, -1 on failure
-static int applyUpdateFromWebResult() {
-    // process it, unzip, apply file changes, etc.
-            
-    int size;
-    unsigned char *result = getWebResult( webHandle, &size );
+// length of a hex SHA1 digest, as it appears in delta entries
+#define HASH_HEX_LENGTH ( 2 * SHA1_DIGEST_LENGTH )
+
+
+// applies a delta from a bundle to the current version of inFileName
+// returns the new contents, destroyed by caller, or NULL if the file isn't
+// the version that the delta was made from
+static unsigned char *patchFile( char *inFileName, 
+                                 char *inOldHash, char *inNewHash,
+                                 unsigned char *inDelta, int inDeltaLength,
+                                 int *outLength ) {
+    
+    File oldFile( NULL, inFileName );
+    
+    int oldLength;
+    unsigned char *oldContents = NULL;
+    
+    if( oldFile.exists() && ! oldFile.isDirectory() ) {
+        oldContents = oldFile.readFileContents( &oldLength );
+        }
+    
+    if( oldContents == NULL ) {
+        printf( "Failed to read %s to apply delta to\n", inFileName );
+        return NULL;
+        }
+    
 
-    char *nextRawScanPointer = (char*)result;
+    char *oldHash = computeSHA1Digest( oldContents, oldLength );
+    
+    if( strcmp( oldHash, inOldHash ) != 0 &&
+        WINDOWS_LINE_ENDS &&
+        strstr( inFileName, ".txt" ) != NULL ) {
+        
+        // an earlier universal update may have converted its line ends
+        // after writing it, so try undoing that
+        int newLength = 0;
+        for( int i=0; i<oldLength; i++ ) {
+            if( oldContents[i] != '\r' || 
+                i + 1 >= oldLength || 
+                oldContents[ i + 1 ] != '\n' ) {
+                oldContents[ newLength ] = oldContents[i];
+                newLength++;
+                }
+            }
+        
+        if( newLength != oldLength ) {
+            oldLength = newLength;
             
-    // don't use sscanf here because it scans the entire buffer
-    // (and this buffer has binary data at end)
-    int rawSize = scanIntAndSkip( &nextRawScanPointer );
-    int compSize = scanIntAndSkip( &nextRawScanPointer );
+            delete [] oldHash;
+            oldHash = computeSHA1Digest( oldContents, oldLength );
+            }
+        }
 
-    if( rawSize > 0 && compSize > 0 ) {
-                
-        unsigned char *compData = (unsigned char*)nextRawScanPointer;
-                
-        char *hash = computeSHA1Digest( compData, compSize );
+    if( strcmp( oldHash, inOldHash ) != 0 ) {
+        printf( "%s has SHA1 %s, but delta expects %s\n",
+                inFileName, oldHash, inOldHash );
+        delete [] oldHash;
+        delete [] oldContents;
+        return NULL;
+        }
+    delete [] oldHash;
+    
+
+    unsigned char *newContents = applyBinaryDelta( oldContents, oldLength,
+                                                   inDelta, inDeltaLength,
+                                                   outLength );
+    delete [] oldContents;
+    
+    if( newContents == NULL ) {
+        printf( "Delta for %s is corrupt\n", inFileName );
+        return NULL;
+        }
+    
+    char *newHash = computeSHA1Digest( newContents, *outLength );
+    
+    char hashMatches = ( strcmp( newHash, inNewHash ) == 0 );
+    
+    delete [] newHash;
+    
+    if( ! hashMatches ) {
+        printf( "Applying delta to %s gave wrong SHA1\n", inFileName );
+        delete [] newContents;
+        return NULL;
+        }
+    
+    return newContents;
+    }
 
-        AppLog::infoF( "Received compressed data with SHA1 = %s\n",
-                       hash );
-        delete [] hash;
 
-        unsigned char *rawData = 
-            zipDecompress( compData,
-                           compSize,
-                           rawSize );
 
-        delete [] result;
-                
+// returns 1 on success, -1 on failure
+static int applyUpdateFromWebResult() {
+    // process it, unzip, apply file changes, etc.
+    
+    // already hashed and decompressed as it arrived
+    int rawSize;
+    unsigned char *rawData = bundleSink.getRawData( &rawSize );
+    
+    if( rawSize > 0 ) {
 
         if( rawData == NULL ) {
             printf( "Failed to decompress diff bundle\n" );
@@ -427,6 +1094,9 @@ static int applyUpdateFromWebResult() {
         
         char fileCreationFailed = false;
         
+        // a delta that doesn't fit the file that's here
+        char deltaFailed = false;
+        
         SimpleVector<char*> backupList;
 
         for( int f=0; f<numFiles; f++ ) {
@@ -468,7 +1138,61 @@ static int applyUpdateFromWebResult() {
                 delete [] rawData;
                 return -1;
                 }
-                    
+
+            // usually, bundle holds file data itself
+            unsigned char *fileData = (unsigned char *)nextScanPointer;
+            int fileDataSize = fileSize;
+            
+            // bytes of bundle that this file's data takes
+            int entrySize = fileSize;
+            
+            unsigned char *patchedData = NULL;
+            
+            // ! instead of # means a delta, following old and new hashes
+            // that are each followed by a space
+            if( nextScanPointer[-1] == '!' ) {
+                entrySize = 2 * ( HASH_HEX_LENGTH + 1 ) + fileSize;
+                }
+            
+            if( fileSize < 0 || 
+                entrySize > 
+                rawSize - (int)( (unsigned char*)nextScanPointer - rawData ) ) {
+                printf( "File data runs past end of diff bundle\n" );
+                delete [] fileName;
+                        
+                dumpRawDataToFile( rawData, rawSize );
+                delete [] rawData;
+                return -1;
+                }
+            
+            if( nextScanPointer[-1] == '!' ) {
+                char oldHash[ HASH_HEX_LENGTH + 1 ];
+                char newHash[ HASH_HEX_LENGTH + 1 ];
+                
+                memcpy( oldHash, nextScanPointer, HASH_HEX_LENGTH );
+                oldHash[ HASH_HEX_LENGTH ] = '\0';
+                
+                memcpy( newHash, &( nextScanPointer[ HASH_HEX_LENGTH + 1 ] ),
+                        HASH_HEX_LENGTH );
+                newHash[ HASH_HEX_LENGTH ] = '\0';
+                
+                patchedData = patchFile( 
+                    fileName, oldHash, newHash,
+                    (unsigned char *)
+                    &( nextScanPointer[ 2 * ( HASH_HEX_LENGTH + 1 ) ] ),
+                    fileSize, &fileDataSize );
+                
+                if( patchedData == NULL ) {
+                    fileCreationFailed = true;
+                    deltaFailed = true;
+                    delete [] fileName;
+                    printf( "Ending update process\n" );
+                    break;
+                    }
+                
+                fileData = patchedData;
+                }
+            
 
             File targetFile( NULL, fileName );
 
@@ -495,6 +1219,9 @@ static int applyUpdateFromWebResult() {
                         fileCreationFailed = true;
                         delete [] fileName;
                         delete [] backupName;
+                        if( patchedData != NULL ) {
+                            delete [] patchedData;
+                            }
                         printf( "Ending update process\n" );
                         break;
                         }
@@ -554,16 +1281,18 @@ static int applyUpdateFromWebResult() {
                 if( backupName != NULL ) {
                     delete [] backupName;
                     }
+                if( patchedData != NULL ) {
+                    delete [] patchedData;
+                    }
                 printf( "Ending update process\n" );
                 break;
                 }
             else {
                 int numWritten = 
-                    fwrite( (unsigned char *)nextScanPointer, 
-                            1, fileSize, file );
-                if( numWritten != fileSize ) {
+                    fwrite( fileData, 1, fileDataSize, file );
+                if( numWritten != fileDataSize ) {
                     printf( "Failed to write %d bytes to file  %s\n",
-                            fileSize, fileName );
+                            fileDataSize, fileName );
                     }
                         
                 fclose( file );
@@ -629,13 +1358,17 @@ static int applyUpdateFromWebResult() {
                 }
 
             delete [] fileName;
-
+            
+            if( patchedData != NULL ) {
+                delete [] patchedData;
+                }
                 
-            nextScanPointer = &( nextScanPointer[ fileSize ] );
+            nextScanPointer = &( nextScanPointer[ entrySize ] );
             }
         
         if( fileCreationFailed ) {
-            writeError = true;
+            // files here not matching a delta isn't a permissions problem
+            writeError = ! deltaFailed;
             
             // restore from backups if possible
             
@@ -665,6 +1398,7 @@ static int applyUpdateFromWebResult() {
 
             backupList.deallocateStringElements();
             
+            delete [] rawData;
             return -1;
             }
         
@@ -699,7 +1433,6 @@ static int applyUpdateFromWebResult() {
         }
     else {
         printf( "Failed to parse diff bundle\n" );
-        delete [] result;
         return -1;
         }
 
@@ -712,15 +1445,14 @@ static int batchMirrorStep() {
 
     if( batchStepsDone < mirrors.size() ) {
         
-        if( webHandle != -1 ) {
+        if( bundleDownloading ) {
             
-            int result = stepWebRequest( webHandle );
+            int result = stepBundleDownload();
 
             if( result == 1 ) {
                 result = applyUpdateFromWebResult();
                 
-                clearWebRequest( webHandle );
-                webHandle = -1;
+                clearBundleDownload();
             
                 if( result == 1 ) {
                     // start next step on next step() call
@@ -730,10 +1462,10 @@ static int batchMirrorStep() {
                 }
             
             if( result == -1 ) {
+                clearBundleDownload();
+                
                 if( writeError ) {
                     // stop immediately, don't try another mirror
-                    clearWebRequest( webHandle );
-                    webHandle = -1;
                     return -1;
                     }
                 MirrorList *list = mirrors.getElement( batchStepsDone );
@@ -742,9 +1474,7 @@ static int batchMirrorStep() {
                     
                     list->currentMirror ++;
                     
-                    clearWebRequest( webHandle );
-                    webHandle = -1;
-                    // start request next step
+                    // start download next step
                     return 0;
                     }
                 else {
@@ -768,19 +1498,36 @@ static int batchMirrorStep() {
                 else {
                     currentUpdateUniversal = false;
                     }
+                
+                // fetch segments from all the mirrors of same kind,
+                // starting with this one
+                SimpleVector<char*> sources;
+                
+                int numMirrors = list->mirrorURLS.size();
+                
+                for( int i=0; i<numMirrors; i++ ) {
+                    char *url = list->mirrorURLS.getElementDirect(
+                        ( list->currentMirror + i ) % numMirrors );
+                    
+                    char universal = ( strstr( url, "_all.dbz" ) != NULL );
+                    
+                    if( universal == currentUpdateUniversal ) {
+                        sources.push_back( url );
+                        }
+                    }
                          
 
-                // start a request
-                printf( "Trying to fetch:  %s\n", 
+                // start a download
+                printf( "Trying to fetch:  %s", 
                         list->mirrorURLS.getElementDirect( 
                             list->currentMirror ) );
+                if( sources.size() > 1 ) {
+                    printf( " (and %d other mirrors)", sources.size() - 1 );
+                    }
+                printf( "\n" );
                 
-                webHandle = 
-                    startWebRequest( 
-                        "GET", 
-                        list->mirrorURLS.getElementDirect( 
-                        list->currentMirror ), 
-                        NULL );
+                startBundleDownload( sources.getElementFast( 0 ),
+                                     sources.size(), list->size );
                 
                 updateSize = list->size;
                 return 0;
@@ -809,6 +1556,28 @@ int stepUpdate() {
     if( batchMirrorUpdate ) {
         return batchMirrorStep();
         }
+    
+    if( bundleDownloading ) {
+        int result = stepBundleDownload();
+        
+        if( result == 1 ) {
+            if( updateProgressCompleteSteps < 1 ) {
+                // don't process data this step, wait until next step
+                updateProgressCompleteSteps++;
+                return 0;
+                }
+            
+            // have update itself AND we've let one step go
+            // by for our final update progress to post
+            
+            printf( "Update download complete\n" );
+            
+            return applyUpdateFromWebResult();
+            }
+        
+        return result;
+        }
+    
 
     int result = stepWebRequest( webHandle );
 
@@ -920,8 +1689,9 @@ int stepUpdate() {
                 printf( "Found an update with %d bytes\n",
                         updateSize );
 
-                // start next request for update itself
+                // start download of update itself
                 clearWebRequest( webHandle );
+                webHandle = -1;
                 
                 char *fullURL = autoSprintf( "%s?action=get_update"
                                              "&platform=%s&old_version=%d",
@@ -931,27 +1701,17 @@ int stepUpdate() {
                 
                 printf( "Downloading update from %s\n", fullURL );
                 
-                webHandle = startWebRequest( "GET", fullURL, NULL );
+                // kept until bundle download cleared
+                if( directUpdateURL != NULL ) {
+                    delete [] directUpdateURL;
+                    }
+                directUpdateURL = fullURL;
                 
-                delete [] fullURL;
+                startBundleDownload( &directUpdateURL, 1, updateSize );
             
                 return 0;
                 }
             }
-        else if( updateProgressCompleteSteps < 1 ) {
-            // don't process data this step, wait until next step
-            updateProgressCompleteSteps++;
-            return 0;
-            }
-        else {
-            // have update itself AND we've let one step go
-            // by for our final update progress to post
-
-            
-            printf( "Update download complete\n" );
-            
-            return applyUpdateFromWebResult();
-            }
         }
     
     return result;
@@ -964,40 +1724,14 @@ float getUpdateProgress() {
         
         float globalProgress = batchStepsDone / (float)mirrors.size();
         
-
-        if( updateSize > 0 ) {
-            float progress = 0;
-            
-            if( webHandle != -1 ) {
-                progress = getWebProgressSize( webHandle ) / (float)updateSize;
-                }
-            
-            if( progress > 1 ) {
-                // getWebProgressSize includes headers
-                progress = 1;
-                }
-            
-            globalProgress += progress * 1.0f / mirrors.size();
+        if( bundleDownloading ) {
+            globalProgress += getBundleProgress() / mirrors.size();
             }
         
         return globalProgress;
         }
     else {
-        
-        if( updateSize > 0 ) {
-            float progress = 
-                getWebProgressSize( webHandle ) / (float)updateSize;
-        
-            if( progress > 1 ) {
-                // getWebProgressSize includes headers
-                progress = 1;
-                }
-            
-            return progress;
-            }
-        else {
-            return 0;
-            }
+        return getBundleProgress();
         }
     }
 
@@ -1005,7 +1739,17 @@ float getUpdateProgress() {
 
 
 void clearUpdate() {
-    clearWebRequest( webHandle );
+    if( webHandle != -1 ) {
+        clearWebRequest( webHandle );
+        webHandle = -1;
+        }
+    
+    clearBundleDownload();
+    
+    if( directUpdateURL != NULL ) {
+        delete [] directUpdateURL;
+        directUpdateURL = NULL;
+        }
 
     if( updateServerURL != NULL ) {
         delete [] updateServerURL;
@@ -2,6 +2,7 @@
 
 #include "minorGems/io/file/File.h"
 #include "minorGems/formats/encodingUtils.h"
+#include "minorGems/formats/ZipStream.h"
 #include "minorGems/crypto/hashes/sha1.h"
 
 #include <stdlib.h>
@@ -38,12 +39,73 @@ static char *getSubdirPath( char *inFullFilePath ) {
 
 
 
+// bundle data is compressed as it's made, into a temporary file, because
+// the sizes that go at the start of a .dbz aren't known until the end
+typedef struct BundleWriter {
+        ZipCompressor compressor;
+        
+        SimpleVector<unsigned char> compBuffer;
+        
+        FILE *tempFile;
+        
+        int totalSize;
+        int compSize;
+        
+        SHA_CTX compHash;
+    } BundleWriter;
+
+
+
+static void flushCompBuffer( BundleWriter *inWriter ) {
+    int numComp = inWriter->compBuffer.size();
+    
+    if( numComp == 0 ) {
+        return;
+        }
+    
+    unsigned char *compData = inWriter->compBuffer.getElementFast( 0 );
+    
+    SHA1_Update( &( inWriter->compHash ), compData, numComp );
+    
+    int numWritten = fwrite( compData, 1, numComp, inWriter->tempFile );
+    
+    if( numWritten != numComp ) {
+        printf( "Tried to write %d compressed bytes, but wrote %d instead\n",
+                numComp, numWritten );
+        }
+    
+    inWriter->compSize += numComp;
+    
+    // keep buffer's space for next time
+    inWriter->compBuffer.shrink( 0 );
+    }
+
+
+
+static void bundleAppend( BundleWriter *inWriter, 
+                          const unsigned char *inData, int inLength ) {
+    inWriter->compressor.compress( inData, inLength, 
+                                   &( inWriter->compBuffer ) );
+    inWriter->totalSize += inLength;
+    
+    flushCompBuffer( inWriter );
+    }
+
+
+
+static void bundleAppendString( BundleWriter *inWriter, 
+                                const char *inString ) {
+    bundleAppend( inWriter, (const unsigned char*)inString, 
+                  strlen( inString ) );
+    }
+
+
+
 static void bundleFileList( File **inFiles, int inNumFiles,
-                            SimpleVector<unsigned char> *inFileDataBuffer ) {
+                            BundleWriter *inWriter ) {
 
     char *fileCount = autoSprintf( "%d ", inNumFiles );
-    inFileDataBuffer->appendArray( (unsigned char*)fileCount, 
-                                strlen( fileCount ) );
+    bundleAppendString( inWriter, fileCount );
     
     delete [] fileCount;
     
@@ -56,8 +118,7 @@ static void bundleFileList( File **inFiles, int inNumFiles,
         char *header = autoSprintf( "%d %s ",
                                     strlen( fileSubdirName ),
                                     fileSubdirName );
-        inFileDataBuffer->appendArray( (unsigned char*)header, 
-                                       strlen( header ) );
+        bundleAppendString( inWriter, header );
         delete [] header;
 
         delete [] fileName;
@@ -68,35 +129,131 @@ static void bundleFileList( File **inFiles, int inNumFiles,
 
 
 
+// appends a file's contents, a block at a time
+// returns number of bytes appended
+static int bundleFileContents( File *inFile, BundleWriter *inWriter ) {
+    char *fileName = inFile->getFullFileName();
+    
+    FILE *file = fopen( fileName, "rb" );
+    
+    delete [] fileName;
+    
+    if( file == NULL ) {
+        return 0;
+        }
+    
+    int numAppended = 0;
+    
+    unsigned char buffer[ 65536 ];
+    
+    int numRead = fread( buffer, 1, sizeof( buffer ), file );
+    
+    while( numRead > 0 ) {
+        bundleAppend( inWriter, buffer, numRead );
+        numAppended += numRead;
+        
+        numRead = fread( buffer, 1, sizeof( buffer ), file );
+        }
+    
+    fclose( file );
+    
+    return numAppended;
+    }
+
 
+
+// makes delta from inOldFile to inNewFile, if worth it
+// returns delta and fills in hashes, or returns NULL
+static unsigned char *makeFileDelta( File *inOldFile, File *inNewFile,
+                                     int *outDeltaLength,
+                                     char **outOldHash, char **outNewHash ) {
+    
+    int oldLength;
+    unsigned char *oldContents = inOldFile->readFileContents( &oldLength );
+    
+    if( oldContents == NULL ) {
+        return NULL;
+        }
+    
+    int newLength;
+    unsigned char *newContents = inNewFile->readFileContents( &newLength );
+
+    if( newContents == NULL ) {
+        delete [] oldContents;
+        return NULL;
+        }
+    
+    unsigned char *delta = makeBinaryDelta( oldContents, oldLength,
+                                            newContents, newLength,
+                                            outDeltaLength );
+    
+    // patching needs old file to be right on client, so only worth
+    // the risk if it saves a lot
+    if( *outDeltaLength > newLength / 2 ) {
+        delete [] delta;
+        delta = NULL;
+        }
+    else {
+        *outOldHash = computeSHA1Digest( oldContents, oldLength );
+        *outNewHash = computeSHA1Digest( newContents, newLength );
+        }
+    
+    delete [] oldContents;
+    delete [] newContents;
+    
+    return delta;
+    }
+
+
+
+// inOldFiles has, for each of inFiles, the old version to make a delta
+// against, or NULL to include the whole file
+// inOldFiles can be NULL to include all files whole
 static void bundleFiles( File **inFilesToRemove, int inNumFilesToRemove,
                          File **inDirsToRemove, int inNumDirsToRemove,
                          File **inDirs, int inNumDirs,
                          File **inFiles, int inNumFiles,
+                         File **inOldFiles,
                          char *inDBZTargetFile ) {
 
-    SimpleVector<unsigned char> fileDataBuffer;
+    char *tempFileName = autoSprintf( "%s.part", inDBZTargetFile );
+    
+    BundleWriter writer;
+    
+    writer.tempFile = fopen( tempFileName, "wb" );
+    
+    if( writer.tempFile == NULL ) {
+        printf( "Failed to open %s for writing\n", tempFileName );
+        delete [] tempFileName;
+        return;
+        }
+    
+    writer.totalSize = 0;
+    writer.compSize = 0;
+    SHA1_Init( &( writer.compHash ) );
+    
     
 
     printf( "Bundling file removals...\n" );
-    bundleFileList( inFilesToRemove, inNumFilesToRemove, &fileDataBuffer );
+    bundleFileList( inFilesToRemove, inNumFilesToRemove, &writer );
 
     printf( "Bundling dir removals...\n" );
-    bundleFileList( inDirsToRemove, inNumDirsToRemove, &fileDataBuffer );
+    bundleFileList( inDirsToRemove, inNumDirsToRemove, &writer );
 
     printf( "Bundling dirs...\n" );
-    bundleFileList( inDirs, inNumDirs, &fileDataBuffer );
+    bundleFileList( inDirs, inNumDirs, &writer );
     
 
 
     printf( "Bundling files...\n" );
     
     char *fileCount = autoSprintf( "%d ", inNumFiles );
-    fileDataBuffer.appendArray( (unsigned char*)fileCount, 
-                                strlen( fileCount ) );
+    bundleAppendString( &writer, fileCount );
     
     delete [] fileCount;
     
+    int numDeltas = 0;
+    int deltaSavings = 0;
 
     for( int i=0; i<inNumFiles; i++ ) {
         char *fileName = inFiles[i]->getFullFileName();
@@ -104,106 +261,138 @@ static void bundleFiles( File **inFilesToRemove, int inNumFilesToRemove,
         char *fileSubdirName = getSubdirPath( fileName );
         int size = inFiles[i]->getLength();
         
+
+        unsigned char *delta = NULL;
+        int deltaLength = 0;
+        char *oldHash = NULL;
+        char *newHash = NULL;
         
-        // use # as separator before file data instead of space
-        // because when parsing later, sscanf will scan multiple spaces
-        // (for example, spaces at the start of the file data itself) as 
-        // a single space, thus potentially eating part of the file data.
-        // But even if the file data starts with '#', we'll be okay here,
-        // because we can sscanf just a single # after the file size number.
-        char *header = autoSprintf( "%d %s %d#",
-                                    strlen( fileSubdirName ),
-                                    fileSubdirName,
-                                    size );
-        fileDataBuffer.appendArray( (unsigned char*)header, strlen( header ) );
-        delete [] header;
-        
-        int contentLength;
-        unsigned char *contents = 
-            inFiles[i]->readFileContents( &contentLength );
+        if( inOldFiles != NULL && inOldFiles[i] != NULL ) {
+            delta = makeFileDelta( inOldFiles[i], inFiles[i], &deltaLength,
+                                   &oldHash, &newHash );
+            }
         
-        if( contents != NULL && contentLength == size ) {
-            fileDataBuffer.appendArray( contents, contentLength );
+        if( delta != NULL ) {
+            // ! instead of # marks a delta against the client's
+            // current version, whose hash comes first, followed by
+            // the hash of the result
+            char *header = autoSprintf( "%d %s %d!%s %s ",
+                                        strlen( fileSubdirName ),
+                                        fileSubdirName,
+                                        deltaLength, oldHash, newHash );
+            bundleAppendString( &writer, header );
+            delete [] header;
+            
+            bundleAppend( &writer, delta, deltaLength );
+            
+            printf( "  %s as delta, %d bytes instead of %d\n",
+                    fileSubdirName, deltaLength, size );
+            
+            numDeltas++;
+            deltaSavings += size - deltaLength;
+
+            delete [] delta;
+            delete [] oldHash;
+            delete [] newHash;
             }
         else {
-            printf( "Reading file contents of %s failed, or expected size "
-                    "%d did not match actual size %d\n",
-                    fileName, size, contentLength );
-            }
+            // use # as separator before file data instead of space
+            // because when parsing later, sscanf will scan multiple spaces
+            // (for example, spaces at the start of the file data itself) 
+            // as a single space, thus potentially eating part of the 
+            // file data.
+            // But even if the file data starts with '#', we'll be okay 
+            // here, because we can sscanf just a single # after the file 
+            // size number.
+            char *header = autoSprintf( "%d %s %d#",
+                                        strlen( fileSubdirName ),
+                                        fileSubdirName,
+                                        size );
+            bundleAppendString( &writer, header );
+            delete [] header;
         
-        if( contents != NULL ) {
-            delete [] contents;
+            int contentLength = bundleFileContents( inFiles[i], &writer );
+            
+            if( contentLength != size ) {
+                printf( "Reading file contents of %s failed, or expected "
+                        "size %d did not match actual size %d\n",
+                        fileName, size, contentLength );
+                }
             }
-        
-
                 
         delete [] fileName;
         
         delete [] fileSubdirName;
         }
     
-    int totalSize = fileDataBuffer.size();
-    
-    unsigned char *data = fileDataBuffer.getElementArray();
+    if( numDeltas > 0 ) {
+        printf( "%d files sent as deltas, saving %d bytes before "
+                "compression\n", numDeltas, deltaSavings );
+        }
     
 
-    /*
-    // for testing, output uncompressed data too
-    char *rawFileName = autoSprintf( "%s.raw", inDBZTargetFile );
-    
-    FILE *outFile = fopen( rawFileName, "wb" );
+    printf( "Compressing bundle...\n" );
 
-    delete [] rawFileName;
+    writer.compressor.finish( &( writer.compBuffer ) );
+    flushCompBuffer( &writer );
     
-    int numWritten = fwrite( data, 1, totalSize, outFile );
-
-    fclose( outFile );
-    */
-
+    fclose( writer.tempFile );
     
 
-    printf( "Compressing bundle...\n" );
-
-    int compSize;
-    unsigned char *compData = zipCompress( data, totalSize, &compSize );
+    unsigned char digest[ SHA1_DIGEST_LENGTH ];
+    SHA1_Final( digest, &( writer.compHash ) );
     
-
-    char *hash = computeSHA1Digest( compData, compSize );
+    char *hash = hexEncode( digest, SHA1_DIGEST_LENGTH );
     
     printf( "Compressed data has SHA1 = %s\n", hash );
     
     delete [] hash;
 
+    
 
-    if( compData != NULL ) {
-        
-        FILE *outFile = fopen( inDBZTargetFile, "wb" );
+    FILE *tempFile = fopen( tempFileName, "rb" );
+    FILE *outFile = fopen( inDBZTargetFile, "wb" );
         
-        if( outFile != NULL ) {
+    if( tempFile != NULL && outFile != NULL ) {
             
-            printf( "Writing file %s\n", inDBZTargetFile );
+        printf( "Writing file %s\n", inDBZTargetFile );
             
-            fprintf( outFile, "%d %d ", totalSize, compSize );
+        fprintf( outFile, "%d %d ", writer.totalSize, writer.compSize );
+        
+        int numCopied = 0;
+        
+        unsigned char buffer[ 65536 ];
+    
+        int numRead = fread( buffer, 1, sizeof( buffer ), tempFile );
+    
+        while( numRead > 0 ) {
+            numCopied += fwrite( buffer, 1, numRead, outFile );
             
-            int numWritten = fwrite( compData, 1, compSize, outFile );
-            if( numWritten != compSize ) {
-                printf( "Tried to write %d to file %s, "
-                        "but wrote %d instead\n",
-                        compSize, inDBZTargetFile, numWritten );
-                }
-            printf( "Wrote %d bytes to file %s\n", (int)ftell( outFile ),
-                    inDBZTargetFile );
-            fclose( outFile );
+            numRead = fread( buffer, 1, sizeof( buffer ), tempFile );
             }
-        else {
-            printf( "Failed to open %s for writing\n", inDBZTargetFile );
+        
+        if( numCopied != writer.compSize ) {
+            printf( "Tried to write %d to file %s, "
+                    "but wrote %d instead\n",
+                    writer.compSize, inDBZTargetFile, numCopied );
             }
-
-        delete [] compData;
+        printf( "Wrote %d bytes to file %s\n", (int)ftell( outFile ),
+                inDBZTargetFile );
+        }
+    else {
+        printf( "Failed to open %s for writing\n", inDBZTargetFile );
         }
     
-
-    delete [] data;
+    if( tempFile != NULL ) {
+        fclose( tempFile );
+        }
+    if( outFile != NULL ) {
+        fclose( outFile );
+        }
+    
+    remove( tempFileName );
+    
+    delete [] tempFileName;
     }
 
 
@@ -240,11 +429,27 @@ static void printFileList( const char *inDescription,
 // sub directories
 int main( int inNumArgs, char **inArgs ) {
     
+    char useDeltas = false;
+    
+    if( inNumArgs > 1 && strcmp( inArgs[1], "-delta" ) == 0 ) {
+        useDeltas = true;
+        
+        // skip it
+        inArgs = &( inArgs[1] );
+        inNumArgs--;
+        }
+    
+
     if( inNumArgs != 5 && inNumArgs != 4 ) {        
-		printf( "\nUsage:  diffBundle  dirOld dirNew "
+		printf( "\nUsage:  diffBundle  [-delta] dirOld dirNew "
                 "outIncremental.dbz [outFull.dbz]\n\n" );
         printf( "If outFull.dbz not supplied, only the incremental bundle is "
                 "generated.\n\n" );
+        printf( "With -delta, changed files in the incremental bundle are "
+                "sent as binary\n"
+                "deltas against their old versions where that saves space.  "
+                "Only clients\n"
+                "built with delta support can apply such bundles.\n\n" );
 		return 1;
 		}
     
@@ -308,7 +513,7 @@ int main( int inNumArgs, char **inArgs ) {
         bundleFiles( NULL, 0,
                      NULL, 0, 
                      newDirsArray, numNewDirs,
-                     newNonDirsArray, numNewNonDirs, inArgs[4] );
+                     newNonDirsArray, numNewNonDirs, NULL, inArgs[4] );
         
         delete [] newDirsArray;
         delete [] newNonDirsArray;
@@ -372,6 +577,9 @@ int main( int inNumArgs, char **inArgs ) {
 
     SimpleVector<File*> changedFiles;
     
+    // old version of each changed file, or NULL for new files
+    SimpleVector<File*> changedOldFiles;
+    
     for( int i=0; i<numNewChild; i++ ) {        
         
         char *newFileName = newChild[i]->getFullFileName();
@@ -421,11 +629,13 @@ int main( int inNumArgs, char **inArgs ) {
                 
                     if( oldFileLength != newFileLength ) {
                         changedFiles.push_back( newChild[i] );
+                        changedOldFiles.push_back( oldChild[j] );
                         }
                     else {
                         for( int b=0; b<newFileLength; b++ ) {
                             if( oldFileContents[b] != newFileContents[b] ) {
                                 changedFiles.push_back( newChild[i] );
+                                changedOldFiles.push_back( oldChild[j] );
                                 break;
                                 }
                             }
@@ -445,6 +655,7 @@ int main( int inNumArgs, char **inArgs ) {
                 }
             else {
                 changedFiles.push_back( newChild[i] );
+                changedOldFiles.push_back( NULL );
                 }
             }
 
@@ -472,17 +683,26 @@ int main( int inNumArgs, char **inArgs ) {
     int numChanged = changedFiles.size();
     File **changedFilesArray = changedFiles.getElementArray();
     
+    File **changedOldFilesArray = NULL;
+    if( useDeltas ) {
+        changedOldFilesArray = changedOldFiles.getElementArray();
+        }
+    
     int numNewDirs = newDirs.size();
     File **newDirsArray = newDirs.getElementArray();
 
     bundleFiles( removedFilesArray, numRemovedFiles,
                  removedDirsArray, numRemovedDirs, 
                  newDirsArray, numNewDirs,
-                 changedFilesArray, numChanged, inArgs[3] );
+                 changedFilesArray, numChanged, changedOldFilesArray,
+                 inArgs[3] );
 
     delete [] removedFilesArray;
     delete [] removedDirsArray;
     delete [] changedFilesArray;
+    if( changedOldFilesArray != NULL ) {
+        delete [] changedOldFilesArray;
+        }
     delete [] newDirsArray;
     
     
@@ -309,14 +309,48 @@ function dbs_send_file( $path ) {
     header("Cache-Control: ");
     header("Pragma: ");
     header("Content-Type: application/octet-stream");
-    header("Content-Length: " .(string)(filesize($path)) );
     header('Content-Disposition: attachment; filename="'.$name.'"');
     header("Content-Transfer-Encoding: binary\n");
+    header("Accept-Ranges: bytes");
+
+
+    // clients fetch parts of large bundles in parallel, and resume
+    // broken downloads, with single byte ranges
+    $size = filesize( $path );
+    $start = 0;
+    $end = $size - 1;
+    
+    if( isset( $_SERVER['HTTP_RANGE'] ) &&
+        preg_match( "/^bytes=(\d+)-(\d*)$/",
+                    $_SERVER['HTTP_RANGE'], $matches ) ) {
+
+        $start = $matches[1];
+        if( $matches[2] != "" && $matches[2] < $end ) {
+            $end = $matches[2];
+            }
+
+        if( $start > $end ) {
+            header( "HTTP/1.1 416 Requested Range Not Satisfiable" );
+            header( "Content-Range: bytes */$size" );
+            return TRUE;
+            }
+        
+        header( "HTTP/1.1 206 Partial Content" );
+        header( "Content-Range: bytes $start-$end/$size" );
+        }
+
+    $length = $end - $start + 1;
+    
+    header("Content-Length: " .(string)$length );
 
     if( $file = fopen( $path, 'rb' ) ) {
-        while( ( !feof( $file ) )
+        fseek( $file, $start );
+        
+        while( ( !feof( $file ) ) && $length > 0
                && ( connection_status() == 0 ) ) {
-            print( fread( $file, 1024*8 ) );
+            $data = fread( $file, min( 1024*8, $length ) );
+            $length -= strlen( $data );
+            print( $data );
             flush();
             }
         fclose($file);
@@ -0,0 +1,163 @@
+// Makes a distance field font sheet, name.sdf.tga, next to a TGA font sheet
+// of 16x16 characters, for Font to use when toggleDistanceFields is on.
+//
+// A sheet drawn at several times the game's size, shrunk with -downsample,
+// gives much cleaner edges than a field made from the game-sized sheet.
+
+
+#include "minorGems/io/file/File.h"
+#include "minorGems/io/file/FileOutputStream.h"
+#include "minorGems/util/stringUtils.h"
+#include "minorGems/graphics/Image.h"
+#include "minorGems/graphics/DistanceField.h"
+#include "minorGems/graphics/converters/tgaDecode.h"
+#include "minorGems/graphics/converters/TGAImageConverter.h"
+
+#include <stdlib.h>
+
+
+
+int main( int inNumArgs, char **inArgs ) {
+
+    int downsample = 1;
+    char *fileName = NULL;
+
+    for( int i=1; i<inNumArgs; i++ ) {
+        if( strcmp( inArgs[i], "-downsample" ) == 0 && i + 1 < inNumArgs ) {
+            downsample = atoi( inArgs[ i + 1 ] );
+            i++;
+            }
+        else if( fileName == NULL ) {
+            fileName = inArgs[i];
+            }
+        else {
+            fileName = NULL;
+            break;
+            }
+        }
+
+    if( fileName == NULL || downsample < 1 ) {
+        printf( "\nUsage:  distanceFieldFont [-downsample N] font.tga\n\n" );
+        printf( "Writes font.sdf.tga, with the field of each character in "
+                "the red channel\n(as Font reads coverage).\n" );
+        printf( "-downsample N  font.tga is drawn N times bigger than "
+                "the game uses\n\n" );
+        return 1;
+        }
+
+
+    File inFile( NULL, fileName );
+
+    int length;
+    unsigned char *data = inFile.readFileContents( &length );
+
+    TGAInfo info;
+
+    if( data == NULL || ! readTGAInfo( data, length, &info ) ) {
+        printf( "Failed to read TGA file %s\n", fileName );
+
+        if( data != NULL ) {
+            delete [] data;
+            }
+        return 1;
+        }
+
+    unsigned char *rgba = new unsigned char[ info.width * info.height * 4 ];
+
+    char decoded = decodeTGAToRGBA( data, length, rgba );
+
+    delete [] data;
+
+    if( ! decoded ) {
+        printf( "Failed to decode TGA file %s\n", fileName );
+        delete [] rgba;
+        return 1;
+        }
+
+    if( info.width % ( 16 * downsample ) != 0 ||
+        info.height % ( 16 * downsample ) != 0 ) {
+        printf( "%dx%d sheet doesn't split into 16x16 characters that "
+                "shrink by %d\n", info.width, info.height, downsample );
+        delete [] rgba;
+        return 1;
+        }
+
+
+    int cellW = info.width / 16;
+    int cellH = info.height / 16;
+
+    int fieldCellW = cellW / downsample;
+    int fieldCellH = cellH / downsample;
+
+    int outW = fieldCellW * 16;
+    int outH = fieldCellH * 16;
+
+    unsigned char *mask = new unsigned char[ cellW * cellH ];
+    unsigned char *outRGB = new unsigned char[ outW * outH * 3 ];
+
+    // each character on its own, so fields don't run into neighbors
+    for( int cy=0; cy<16; cy++ ) {
+        for( int cx=0; cx<16; cx++ ) {
+
+            for( int y=0; y<cellH; y++ ) {
+                unsigned char *row =
+                    &( rgba[ ( ( cy * cellH + y ) * info.width +
+                               cx * cellW ) * 4 ] );
+
+                for( int x=0; x<cellW; x++ ) {
+                    mask[ y * cellW + x ] = row[ x * 4 ];
+                    }
+                }
+
+            int fieldW, fieldH;
+            unsigned char *field = makeDistanceField( mask, 1, cellW, cellH,
+                                                      downsample, 0,
+                                                      &fieldW, &fieldH );
+
+            for( int y=0; y<fieldH; y++ ) {
+                unsigned char *row =
+                    &( outRGB[ ( ( cy * fieldCellH + y ) * outW +
+                                 cx * fieldCellW ) * 3 ] );
+
+                for( int x=0; x<fieldW; x++ ) {
+                    unsigned char v = field[ y * fieldW + x ];
+                    row[ x * 3 ] = v;
+                    row[ x * 3 + 1 ] = v;
+                    row[ x * 3 + 2 ] = v;
+                    }
+                }
+
+            delete [] field;
+            }
+        }
+
+    delete [] mask;
+    delete [] rgba;
+
+
+    char *baseName = stringDuplicate( fileName );
+
+    char *dotPos = strrchr( baseName, '.' );
+    if( dotPos != NULL ) {
+        dotPos[0] = '\0';
+        }
+
+    char *outName = autoSprintf( "%s.sdf.tga", baseName );
+    delete [] baseName;
+
+    // takes outRGB
+    Image outImage( outRGB, outW, outH, 3 );
+
+    File outFile( NULL, outName );
+    FileOutputStream outStream( &outFile );
+
+    TGAImageConverter converter;
+    converter.formatImage( &outImage, &outStream );
+
+    printf( "%s:  %dx%d, %dx%d per character\n",
+            outName, outW, outH, fieldCellW, fieldCellH );
+
+    delete [] outName;
+
+    return 0;
+    }
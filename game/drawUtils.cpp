@@ -1,36 +1,74 @@
 #include "drawUtils.h"
 
 #include "minorGems/game/gameGraphics.h"
+#include "minorGems/util/FrameArena.h"
 
 #include <math.h>
 #include <string.h>
 
 
-// pre-compute unit circle centered on 0,0 as a triangle fan
-// num verts is 2 + num triangles
-#define NUM_UNIT_CIRCLE_TRIS 16
-#define NUM_UNIT_CRICLE_VERTS 18
-static double unitCircleVerts[ NUM_UNIT_CRICLE_VERTS * 2 ];
-static double workingCircleVerts[ NUM_UNIT_CRICLE_VERTS * 2 ];
-// change for each unit circle drawn
-static float unitCircleColors[ NUM_UNIT_CRICLE_VERTS * 4 ];
+// pre-compute unit circles centered on 0,0, one table per segment count
+// each table has an x,y point for each segment boundary, with the first
+// point repeated at the end to close the circle
+#define MIN_CIRCLE_SEGMENTS 3
+#define MAX_CIRCLE_SEGMENTS 256
 
+// NULL until first used
+static float *unitCircles[ MAX_CIRCLE_SEGMENTS + 1 ];
 
-void initDrawUtils() {
-    // center
-    unitCircleVerts[0] = 0;
-    unitCircleVerts[1] = 0;
-    
-    for( int v=1; v<NUM_UNIT_CRICLE_VERTS; v++ ) {
-        double angle = 2 * M_PI * (v - 1.0)/(NUM_UNIT_CRICLE_VERTS - 2.0);
-        
-        unitCircleVerts[ v * 2 ] = cos( angle );
-        unitCircleVerts[ v * 2 + 1 ] = sin( angle );
+
+
+static int clampSegments( int inNumSegments ) {
+    if( inNumSegments < MIN_CIRCLE_SEGMENTS ) {
+        return MIN_CIRCLE_SEGMENTS;
+        }
+    if( inNumSegments > MAX_CIRCLE_SEGMENTS ) {
+        return MAX_CIRCLE_SEGMENTS;
         }
+    return inNumSegments;
+    }
+
+
+
+// inNumSegments must already be clamped
+static float *getUnitCircle( int inNumSegments ) {
+    float *table = unitCircles[ inNumSegments ];
+
+    if( table == NULL ) {
+        table = new float[ ( inNumSegments + 1 ) * 2 ];
+
+        for( int v=0; v<inNumSegments; v++ ) {
+            double angle = 2 * M_PI * v / inNumSegments;
+
+            table[ v * 2 ] = cos( angle );
+            table[ v * 2 + 1 ] = sin( angle );
+            }
+
+        // exactly closed
+        table[ inNumSegments * 2 ] = table[0];
+        table[ inNumSegments * 2 + 1 ] = table[1];
+
+        unitCircles[ inNumSegments ] = table;
+        }
+
+    return table;
+    }
+
+
+
+void initDrawUtils() {
+    // default size, so that the first frame doesn't pay for it
+    getUnitCircle( 16 );
     }
 
 
 void freeDrawUtils() {
+    for( int i=0; i<=MAX_CIRCLE_SEGMENTS; i++ ) {
+        if( unitCircles[i] != NULL ) {
+            delete [] unitCircles[i];
+            unitCircles[i] = NULL;
+            }
+        }
     }
 
 
@@ -69,73 +107,242 @@ void drawRect( doublePair inCenter,
 
 
 
-void drawCircle( doublePair inCenter, double inRadius ) {
+// fills inNumSegments + 2 fan vertices, center first
+static void makeCircleFan( doublePair inCenter, double inRadius,
+                           int inNumSegments, float *outVerts ) {
+    float *unit = getUnitCircle( inNumSegments );
 
-    memcpy( workingCircleVerts, unitCircleVerts,
-            sizeof( double ) * NUM_UNIT_CRICLE_VERTS * 2 );
-                    
-    double cX = inCenter.x;
-    double cY = inCenter.y;
-    
+    float cX = inCenter.x;
+    float cY = inCenter.y;
+    float r = inRadius;
+
+    outVerts[0] = cX;
+    outVerts[1] = cY;
 
     // scale it and move it
-    for( int v=0; v<NUM_UNIT_CRICLE_VERTS; v++ ) {
+    for( int v=0; v<=inNumSegments; v++ ) {
         int i = v * 2;
-                    
-        workingCircleVerts[i] *= inRadius;
-        workingCircleVerts[i] += cX; 
-        
-        workingCircleVerts[i+1] *= inRadius;
-        workingCircleVerts[i+1] += cY;
+
+        outVerts[ i + 2 ] = unit[i] * r + cX;
+        outVerts[ i + 3 ] = unit[i + 1] * r + cY;
         }
-    
+    }
+
+
+
+void drawCircle( doublePair inCenter, double inRadius, int inNumSegments ) {
+
+    int numSegments = clampSegments( inNumSegments );
+
+    float *verts = FrameArena::getThreadArena()->
+        allocateArray<float>( ( numSegments + 2 ) * 2 );
+
+    makeCircleFan( inCenter, inRadius, numSegments, verts );
+
     // draw as fan
-    drawTriangles( NUM_UNIT_CIRCLE_TRIS, workingCircleVerts,
-                   false, true );
+    drawTriangles( numSegments, verts, false, true );
     }
 
 
 
 void drawCircle( doublePair inCenter, double inRadius,
-    Color inCenterColor, Color inOuterColor ) {
+                 Color inCenterColor, Color inOuterColor,
+                 int inNumSegments ) {
 
-    memcpy( workingCircleVerts, unitCircleVerts,
-            sizeof( double ) * NUM_UNIT_CRICLE_VERTS * 2 );
-                    
-    double cX = inCenter.x;
-    double cY = inCenter.y;
-    
+    int numSegments = clampSegments( inNumSegments );
+    int numVerts = numSegments + 2;
 
-    // scale it and move it
-    for( int v=0; v<NUM_UNIT_CRICLE_VERTS; v++ ) {
-        int i = v * 2;
-                    
-        workingCircleVerts[i] *= inRadius;
-        workingCircleVerts[i] += cX; 
-        
-        workingCircleVerts[i+1] *= inRadius;
-        workingCircleVerts[i+1] += cY;
-      
+    FrameArena *arena = FrameArena::getThreadArena();
+
+    float *verts = arena->allocateArray<float>( numVerts * 2 );
+    float *colors = arena->allocateArray<float>( numVerts * 4 );
+
+    makeCircleFan( inCenter, inRadius, numSegments, verts );
+
+    // inside
+    colors[0] = inCenterColor.r;
+    colors[1] = inCenterColor.g;
+    colors[2] = inCenterColor.b;
+    colors[3] = inCenterColor.a;
+
+    // outside
+    for( int v=1; v<numVerts; v++ ) {
         int c = v * 4;
-                    
-        // outside
-        unitCircleColors[c++] = inOuterColor.r;
-        unitCircleColors[c++] = inOuterColor.g;
-        unitCircleColors[c++] = inOuterColor.b; 
-        unitCircleColors[c++] = inOuterColor.a;
-        }
-
-    // inside 
-    int c = 0;
-    unitCircleColors[c++] = inCenterColor.r;
-    unitCircleColors[c++] = inCenterColor.g;
-    unitCircleColors[c++] = inCenterColor.b; 
-    unitCircleColors[c++] = inCenterColor.a;
-                
+
+        colors[c] = inOuterColor.r;
+        colors[c + 1] = inOuterColor.g;
+        colors[c + 2] = inOuterColor.b;
+        colors[c + 3] = inOuterColor.a;
+        }
+
     // draw as fan
-    drawTrianglesColor( NUM_UNIT_CIRCLE_TRIS, workingCircleVerts,
-                        unitCircleColors, false, true );
+    drawTrianglesColor( numSegments, verts, colors, false, true );
+    }
+
+
+
+// copies r,g,b,a into each of inNumVerts vertex colors
+static void fillColors( float *inColor, int inNumVerts, float *outColors ) {
+    for( int v=0; v<inNumVerts; v++ ) {
+        memcpy( &( outColors[ v * 4 ] ), inColor, 4 * sizeof( float ) );
+        }
+    }
+
+
+
+// Batches are plain triangle lists, since separate fans can't share
+// one draw call.
+
+void drawCircles( int inNumCircles, doublePair inCenters[],
+                  double inRadii[], int inNumSegments,
+                  float inCircleColors[] ) {
+
+    if( inNumCircles <= 0 ) {
+        return;
+        }
+
+    int numSegments = clampSegments( inNumSegments );
+    float *unit = getUnitCircle( numSegments );
+
+    int vertsPerCircle = numSegments * 3;
+    int numVerts = inNumCircles * vertsPerCircle;
+
+    FrameArena *arena = FrameArena::getThreadArena();
+
+    float *verts = arena->allocateArray<float>( numVerts * 2 );
+    float *colors = NULL;
+
+    if( inCircleColors != NULL ) {
+        colors = arena->allocateArray<float>( numVerts * 4 );
+        }
+
+    float *v = verts;
+
+    for( int c=0; c<inNumCircles; c++ ) {
+        float cX = inCenters[c].x;
+        float cY = inCenters[c].y;
+        float r = inRadii[c];
+
+        float lastX = unit[0] * r + cX;
+        float lastY = unit[1] * r + cY;
+
+        for( int s=1; s<=numSegments; s++ ) {
+            float x = unit[ s * 2 ] * r + cX;
+            float y = unit[ s * 2 + 1 ] * r + cY;
+
+            v[0] = cX;
+            v[1] = cY;
+            v[2] = lastX;
+            v[3] = lastY;
+            v[4] = x;
+            v[5] = y;
+            v += 6;
+
+            lastX = x;
+            lastY = y;
+            }
+
+        if( colors != NULL ) {
+            fillColors( &( inCircleColors[ c * 4 ] ), vertsPerCircle,
+                        &( colors[ c * vertsPerCircle * 4 ] ) );
+            }
+        }
+
+    if( colors != NULL ) {
+        drawTrianglesColor( inNumCircles * numSegments, verts, colors );
+        }
+    else {
+        drawTriangles( inNumCircles * numSegments, verts );
+        }
+    }
+
+
+
+void drawRing( doublePair inCenter, double inInnerRadius,
+               double inOuterRadius, int inNumSegments ) {
+    drawRings( 1, &inCenter, &inInnerRadius, &inOuterRadius,
+               inNumSegments );
     }
 
-          
 
+
+void drawRings( int inNumRings, doublePair inCenters[],
+                double inInnerRadii[], double inOuterRadii[],
+                int inNumSegments, float inRingColors[] ) {
+
+    if( inNumRings <= 0 ) {
+        return;
+        }
+
+    int numSegments = clampSegments( inNumSegments );
+    float *unit = getUnitCircle( numSegments );
+
+    // two triangles for each segment
+    int vertsPerRing = numSegments * 6;
+    int numVerts = inNumRings * vertsPerRing;
+
+    FrameArena *arena = FrameArena::getThreadArena();
+
+    float *verts = arena->allocateArray<float>( numVerts * 2 );
+    float *colors = NULL;
+
+    if( inRingColors != NULL ) {
+        colors = arena->allocateArray<float>( numVerts * 4 );
+        }
+
+    float *v = verts;
+
+    for( int r=0; r<inNumRings; r++ ) {
+        float cX = inCenters[r].x;
+        float cY = inCenters[r].y;
+        float rIn = inInnerRadii[r];
+        float rOut = inOuterRadii[r];
+
+        float lastInX = unit[0] * rIn + cX;
+        float lastInY = unit[1] * rIn + cY;
+        float lastOutX = unit[0] * rOut + cX;
+        float lastOutY = unit[1] * rOut + cY;
+
+        for( int s=1; s<=numSegments; s++ ) {
+            float uX = unit[ s * 2 ];
+            float uY = unit[ s * 2 + 1 ];
+
+            float inX = uX * rIn + cX;
+            float inY = uY * rIn + cY;
+            float outX = uX * rOut + cX;
+            float outY = uY * rOut + cY;
+
+            v[0] = lastInX;
+            v[1] = lastInY;
+            v[2] = lastOutX;
+            v[3] = lastOutY;
+            v[4] = outX;
+            v[5] = outY;
+
+            v[6] = lastInX;
+            v[7] = lastInY;
+            v[8] = outX;
+            v[9] = outY;
+            v[10] = inX;
+            v[11] = inY;
+            v += 12;
+
+            lastInX = inX;
+            lastInY = inY;
+            lastOutX = outX;
+            lastOutY = outY;
+            }
+
+        if( colors != NULL ) {
+            fillColors( &( inRingColors[ r * 4 ] ), vertsPerRing,
+                        &( colors[ r * vertsPerRing * 4 ] ) );
+            }
+        }
+
+    if( colors != NULL ) {
+        drawTrianglesColor( inNumRings * numSegments * 2, verts, colors );
+        }
+    else {
+        drawTriangles( inNumRings * numSegments * 2, verts );
+        }
+    }
@@ -17,7 +17,34 @@ void drawRect( doublePair inCenter,
                double inHorizontalRadius, double inVerticalRadius );
 
 
-void drawCircle( doublePair inCenter, double inRadius );
+
+// circles and rings are built from unit circle tables, computed once
+// for each segment count that is used (3 to 256 segments)
+
+void drawCircle( doublePair inCenter, double inRadius,
+                 int inNumSegments = 16 );
 
 void drawCircle( doublePair inCenter, double inRadius,
-                 Color inCenterColor, Color inOuterColor );
+                 Color inCenterColor, Color inOuterColor,
+                 int inNumSegments = 16 );
+
+
+// draws many circles with one draw call
+// inCircleColors has r,g,b,a for each circle, or NULL to use last set
+// color
+void drawCircles( int inNumCircles, doublePair inCenters[],
+                  double inRadii[],
+                  int inNumSegments = 16,
+                  float inCircleColors[] = NULL );
+
+
+// filled band between two radii
+void drawRing( doublePair inCenter, double inInnerRadius,
+               double inOuterRadius,
+               int inNumSegments = 16 );
+
+// many rings with one draw call, colors as in drawCircles
+void drawRings( int inNumRings, doublePair inCenters[],
+                double inInnerRadii[], double inOuterRadii[],
+                int inNumSegments = 16,
+                float inRingColors[] = NULL );
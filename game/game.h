@@ -266,6 +266,34 @@ double getRecentFrameRate();
 
 
 
+// Optionally runs game logic at a fixed rate, independent of frame rate.
+//
+// By default (0), each drawFrame( true ) call should update game logic
+// once.  With a fixed rate set, drawFrame( true ) should instead update
+// game logic getNumUpdatesThisFrame() times (possibly 0), each by
+// 1 / inUpdatesPerSecond seconds, and then draw.
+//
+// Update counts come from game_getCurrentTime, so recorded games play
+// back with the same updates on the same frames.
+// Best called from initFrameDrawer.
+void setFixedUpdateRate( int inUpdatesPerSecond );
+
+int getFixedUpdateRate();
+
+
+// updates that the current drawFrame call should do
+// always 0 when drawFrame( false ) is called
+int getNumUpdatesThisFrame();
+
+
+// fraction of an update period, in [0,1), that has passed since the last 
+// update, for drawing moving things between their previous and current 
+// positions
+// 1 when no fixed rate is set (draw current positions)
+double getUpdateInterpolation();
+
+
+
 // when inFromKey is pressed, an event for inToKey will be generated
 // (and no event for inFromKey will be generated)
 void mapKey( unsigned char inFromKey, unsigned char inToKey );
@@ -330,6 +358,30 @@ int getSampleRate();
 void setSoundPlaying( char inPlaying );
 
 
+// Optional alternative to getSoundSamples, for games that synthesize in
+// float.
+//
+// Once a game passes a function to setGetSoundSamplesFloat, the platform
+// calls it instead of getSoundSamples, handing it the platform's own
+// left and right mixing buffers to fill with inNumSamples samples each,
+// in [-1,1].  Sound sprites are mixed into the same buffers, and the
+// result is converted to the device's format once, with no 16-bit
+// round trip.
+//
+// Called at the same times, and from the same thread, as getSoundSamples.
+// Pass NULL to go back to getSoundSamples.
+//
+// The device is opened with float samples, where the platform supports
+// that, only if this is set before sound starts (getUsesSound is called
+// just before).  Set later, samples are converted to 16-bit once instead.
+typedef void (*GetSoundSamplesFloatFunction)( float *outSamplesL,
+                                              float *outSamplesR,
+                                              int inNumSamples );
+
+void setGetSoundSamplesFloat( GetSoundSamplesFloatFunction inFunction );
+
+
+
 // for platforms where audio runs in separate thread
 // Lock when manipulating data that is touched by getSoundSamples
 void lockAudio();
@@ -351,8 +403,9 @@ void setSoundLoudness( float inLoudness );
 
 // sound sprites are mixed with whatever getSoundSamples is producing
 
-// currently only supports mono 16-bit files at the same
-// sample rate as settings/soundSampleRate.ini
+// currently only supports mono 16-bit files
+// files at a sample rate other than settings/soundSampleRate.ini are
+// resampled when loaded
 
 // opens file from "sounds" folder
 
@@ -422,6 +475,70 @@ void playSoundSprite( int inNumSprites, SoundSpriteHandle *inHandles,
 void freeSoundSprite( SoundSpriteHandle inHandle );
 
 
+
+// defaults to -1, no limit, and sound sprites loaded from files are
+// decoded by loadSoundSprite and stay resident until freed.
+//
+// With a limit set, loadSoundSprite only checks that the file exists,
+// and the file is decoded the first time the sprite is played (or
+// prefetched).  When the decoded samples of sprites loaded from files
+// add up to more than inMaxBytes, the samples of those played least
+// recently (that aren't playing) are dropped, to be decoded again if
+// they are played again.
+//
+// Sprites made by setSoundSprite always stay resident, and don't count
+// toward the limit.
+void setSoundSpriteMemoryBudget( int inMaxBytes );
+
+
+// bytes of decoded samples resident for sprites loaded from files
+int getSoundSpriteResidentBytes();
+
+
+// hint that a sound sprite will be played soon
+// If it isn't resident, its file is read in the background and decoded
+// during a later frame, so playing it doesn't have to wait for the disk.
+void prefetchSoundSprite( SoundSpriteHandle inHandle );
+
+
+
+
+// Sound streams play long tracks (music, ambience) from disk a chunk
+// at a time, read ahead on a background thread, so only a small part
+// of each track is in memory at once.
+//
+// Supports mono 16-bit AIFF files at the same sample rate as
+// settings/soundSampleRate.ini.
+//
+// Streams are mixed along with sound sprites, under the same total
+// volume cap, and are faded by fadeSoundSprites.
+typedef void* SoundStreamHandle;
+
+
+// opens file from inFolderName folder
+// returns NULL on failure
+SoundStreamHandle openSoundStream( const char *inFolderName, 
+                                   const char *inAIFFFileName,
+                                   char inLoop = false );
+
+
+// plays stream from the beginning, restarting it if it is playing
+// volume in [0,1]
+// stereo position in [0,1] for [left,right], with 0.5 centered
+void playSoundStream( SoundStreamHandle inHandle, double inVolume = 1.0,
+                      double inStereoPosition = 0.5 );
+
+
+void stopSoundStream( SoundStreamHandle inHandle );
+
+
+// false once stopped, or once played through if not looping
+char isSoundStreamPlaying( SoundStreamHandle inHandle );
+
+
+void closeSoundStream( SoundStreamHandle inHandle );
+
+
 // fades all sound sprites down to zero loudness over the next inFadeSeconds
 // after fade is complete, playSoundSprite calls have no effect until
 // resumePlayingSoundSprites is called
@@ -534,6 +651,13 @@ void getLastMouseScreenPos( int *outX, int *outY );
 // returns translation of key using current language
 const char *translate( const char *inTranslationKey );
 
+// for keys translated every frame:  get a handle once, then translate
+// through it without hashing the key string each time
+// handles stay valid across language changes
+int getTranslationHandle( const char *inTranslationKey );
+
+const char *translateHandle( int inTranslationHandle );
+
 
 
 // pause and resume the game
@@ -591,6 +715,12 @@ void stopOutputAllFrames();
 // inURL the url to retrieve
 // inBody the body of the request, can be NULL
 // request body must be in application/x-www-form-urlencoded format
+//
+// GET requests with no body are cached on disk (following the server's
+// Cache-Control and ETag headers), up to the webCacheSizeMB setting
+// (default 50, 0 disables).  Cached results are read in the background,
+// and report status 200.  Requests with a response sink or range are
+// never cached.
 
 // returns unique int handle for web request, always > -1 
 int startWebRequest( const char *inMethod, const char *inURL,
@@ -614,6 +744,31 @@ char *getWebResult( int inHandle );
 unsigned char *getWebResult( int inHandle, int *outSize );
 
 
+class WebResponseSink;
+
+// streams response body into inSink during stepWebRequest, as it arrives,
+// instead of saving it for getWebResult
+// (for downloads too large to hold in memory at once)
+// must be called right after startWebRequest
+// inSink destroyed by caller after clearWebRequest
+// streamed bodies are not saved in recorded games, so only use for
+// requests that don't affect game playback
+void setWebResponseSink( int inHandle, WebResponseSink *inSink );
+
+
+// asks for only bytes inFirstByte through inLastByte (inclusive) of the
+// response body, with an HTTP Range header
+// must be called right after startWebRequest
+// servers that don't support ranges send the whole body instead
+// (with status 200 rather than 206, see getWebStatusCode)
+void setWebRequestRange( int inHandle, int inFirstByte, int inLastByte );
+
+
+// HTTP status code of response, or 0 if response header not received yet
+// not saved in recorded games (returns 0 during playback)
+int getWebStatusCode( int inHandle );
+
+
 // frees resources associated with a web request
 // if request is not complete, this cancels it
 // if hostname lookup is not complete, this call might block.
@@ -624,6 +779,25 @@ void clearWebRequest( int inHandle );
 // returns unique int handle for socket connection, -1 on error
 int openSocketConnection( const char *inNumericalAddress, int inPort );
 
+
+// like openSocketConnection, but races connection attempts to several
+// addresses for the same server (for example, all results of a lookup)
+// attempts are started 250ms apart (or sooner if one fails), and the
+// first to connect is used, with the rest dropped
+//
+// sends and reads before the connection is made send and read nothing
+//
+// inNumericalAddresses destroyed by caller
+//
+// returns unique int handle for socket connection, -1 on error
+int openSocketConnectionToAny( const char **inNumericalAddresses,
+                               int inNumAddresses, int inPort );
+
+
+// polls whether a socket connection is ready, without blocking
+// returns 1 if connected, 0 if still connecting, -1 if connection failed
+int getSocketConnectionState( int inHandle );
+
 // non-blocking send
 // returns number sent (maybe 0) on success, -1 on error
 int sendToSocket( int inHandle, unsigned char *inData, int inDataLength );
@@ -648,8 +822,22 @@ int startAsyncFileRead( const char *inFilePath );
 char checkAsyncFileReadDone( int inHandle );
 
 
+// drains the queue of finished reads, in handle order, so that callers
+// with many reads in flight don't need to check each one
+// Puts up to inMaxHandles handles that have finished since the last call
+// in outHandles, and returns how many.  Any beyond inMaxHandles are 
+// returned by the next call.
+// Handles already cleared with getAsyncFileData are skipped.
+//
+// Reads run on several threads but are reported done in handle order
+// (by both this and checkAsyncFileReadDone), so one slow read holds
+// back reports of later ones.
+int getAsyncFileReadsDone( int *outHandles, int inMaxHandles );
+
+
 // this clears the handle
 // return array destroyed by caller
+// returns NULL (and abandons read) if read not done yet
 unsigned char *getAsyncFileData( int inHandle, int *outDataLength );
 
 
@@ -687,6 +875,28 @@ char startRecording16BitMonoSound( int inSampleRate );
 int16_t *stopRecording16BitMonoSound( int *outNumSamples );
 
 
+// Starts recording for streaming (voice chat, say).
+// Instead of being kept until stopRecording16BitMonoSound, samples go
+// into a ring that holds up to inMaxBufferedSamples, and are taken out
+// as they arrive with readRecordedSamples.  If the ring fills up
+// because the game isn't reading, newer samples are dropped.
+// Stop with stopRecording16BitMonoSound, which returns the samples that
+// were never read.
+// returns false if streaming is not supported on this platform
+char startStreamingRecording16BitMonoSound( int inSampleRate,
+                                            int inMaxBufferedSamples );
+
+// Copies up to inMaxSamples of the oldest unread samples of a streaming
+// recording into outSamples.  Never blocks.
+// Must be called from the thread that starts and stops recording.
+// returns the number of samples copied (0 if none are waiting yet)
+int readRecordedSamples( int16_t *outSamples, int inMaxSamples );
+
+// samples dropped from the current streaming recording because
+// the ring was full
+int getNumRecordedSamplesDropped();
+
+
 // even if sound recording is not supported, we can read
 // in a .wav file from a standard location
 // inputSoundTemp.wav
@@ -80,6 +80,17 @@ void toggleInvertedBlend( char inInverted );
 void toggleAdditiveTextureColoring( char inAdditive );
 
 
+
+// for textures that hold distance fields in alpha instead of coverage
+// (see minorGems/graphics/DistanceField.h)
+// turning on makes the alpha ramp around each edge inSharpness (1, 2, or 4)
+// times steeper, so that the ramp can be kept about one screen pixel wide
+// at any scale (it starts 2 * DISTANCE_FIELD_SPREAD texels wide)
+// draw color alpha is ignored when inSharpness is above 1
+// turning off goes back to multiplicative (or additive) texture coloring
+void toggleDistanceFieldTextures( char inOn, int inSharpness = 1 );
+
+
 // defautls to nearest-neighbor texture magnification
 void toggleLinearMagFilter( char inLinearFilterOn );
 
@@ -112,6 +123,53 @@ void drawTrianglesColor( int inNumTriangles, double inVertices[],
                          char inStrip=false, char inFan=false );
 
 
+// float versions of the above, which GL takes without conversion
+void drawQuads( int inNumQuads, float inVertices[] );
+
+void drawQuads( int inNumQuads, float inVertices[], float inVertexColors[] );
+
+void drawTriangles( int inNumTriangles, float inVertices[], 
+                    char inStrip=false, char inFan=false );
+
+void drawTrianglesColor( int inNumTriangles, float inVertices[], 
+                         float inVertexColors[],
+                         char inStrip=false, char inFan=false );
+
+
+// if on, the float versions above copy vertices through a ring of
+// GPU vertex buffer space instead of having GL read them from the
+// caller's arrays during the draw call
+// Helps on drivers that are slow with client-side arrays.
+// Defaults to off.
+void toggleVertexStreaming( char inStream );
+
+
+
+// Geometry that is drawn many times, like a map grid, kept in GPU memory
+// between draws where supported, so it doesn't have to be sent each frame.
+//
+// Vertices and colors are laid out as in the float drawQuads and 
+// drawTriangles functions, and are copied.  inVertexColors can be NULL
+// to draw with the current color.
+typedef void * GeometryHandle;
+
+GeometryHandle makeQuadGeometry( int inNumQuads, float inVertices[],
+                                 float inVertexColors[] = NULL );
+
+GeometryHandle makeTriangleGeometry( int inNumTriangles, float inVertices[],
+                                     float inVertexColors[] = NULL,
+                                     char inStrip=false, char inFan=false );
+
+// replaces all vertices (and colors, if geometry was made with colors)
+void replaceGeometry( GeometryHandle inGeometry, float inVertices[],
+                      float inVertexColors[] = NULL );
+
+void drawGeometry( GeometryHandle inGeometry );
+
+void freeGeometry( GeometryHandle inGeometry );
+
+
+
 // trims drawing operations to a rectangular region
 // values in view space
 void enableScissor( double inX, double inY, double inWidth, double inHeight );
@@ -150,6 +208,63 @@ typedef void * SpriteHandle;
 // toggles mipmap generation for subsequent sprite loading/filling calls
 void toggleMipMapGeneration( char inGenerateMipMaps );
 
+
+// toggles texture atlas packing for subsequent sprite loading/filling calls
+// when on, small sprites share a few large textures, so that batched
+// drawing (see toggleSpriteBatching) can draw many different sprites with
+// one draw call
+// sprites loaded while mipmap generation is on always get their own texture
+// Defaults to off.
+void toggleSpriteAtlas( char inUseAtlas );
+
+
+// toggles texture sharing for subsequent sprite loading/filling calls
+// when on, a sprite whose RGBA bytes are identical to a sprite already
+// loaded (recolors reused under other names, placeholder art) uses that
+// sprite's texture instead of uploading its own copy, and the texture is
+// freed when the last sprite using it is freed
+// only sprites filled from RGBA bytes (including loadSprite without
+// transparent corner, and loadSpriteAsync) are checked
+// Defaults to on.
+void toggleSpriteTextureSharing( char inShare );
+
+// since startup:  number of sprites checked for an identical texture, and
+// number that found one
+// outSharedBytes is texture memory saved by sprites still loaded
+void getSpriteTextureSharingStats( int *outNumChecked, int *outNumShared,
+                                   int *outSharedBytes );
+
+// Texture memory budget for sprites.
+//
+// Sprite textures normally stay in texture memory until freeSprite.  With
+// a budget set, at the end of each frame, textures of sprites that weren't
+// drawn that frame are dropped from texture memory, least-recently-drawn
+// first, until the rest fit in inMaxBytes.  A dropped sprite is uploaded
+// again from its CPU-side copy the next time it is drawn.
+//
+// At most inMaxReloadsPerFrame dropped sprites are uploaded again per
+// frame (0 for no limit).  Past that, dropped sprites draw nothing until
+// a later frame.
+//
+// Sprites in an atlas (see toggleSpriteAtlas) are dropped and reloaded a
+// whole atlas page at a time.
+//
+// inMaxBytes of 0 turns this off.  Defaults to off.
+void setSpriteTextureBudget( int inMaxBytes, int inMaxReloadsPerFrame = 16 );
+
+// bytes of sprite textures in texture memory, as of the end of the last
+// frame, or 0 if no budget is set
+int getResidentSpriteTextureBytes();
+
+// since startup
+int getNumSpriteTextureEvictions();
+int getNumSpriteTextureReloads();
+
+// called by platform at the end of each frame, after all drawing
+void stepSpriteTextureResidency();
+
+
+
 // if off, entire sprite rectangle is drawn
 // if on, sprite is cropped to remove fully-transparent rows and columns
 // at the left, right, top, and bottom
@@ -167,6 +282,54 @@ SpriteHandle loadSprite( const char *inTGAFileName,
 SpriteHandle loadSpriteBase( const char *inTGAFileName, 
                              char inTransparentLowerLeftCorner = true );
 
+
+// if on, loadSprite loads a compressed texture made by texturePacker
+// (file.ctex next to file.tga) instead of the TGA file, when one is
+// present that was packed with the same inTransparentLowerLeftCorner
+// setting.  Compressed sprites use 4-8x less texture memory.
+// Defaults to off.
+void toggleCompressedSprites( char inUseCompressed );
+
+
+
+// starts loading a sprite from the graphics directory in the background
+//
+// File is read with startAsyncFileRead, decoded on worker threads (one 
+// per core), and then uploaded to GL on the main thread between frames,
+// within the per-frame upload budget.
+//
+// Returned handle can be drawn, queried, and freed right away, but draws
+// nothing (and has 0 width and height) until isSpriteReady returns true.
+// If the file can't be loaded, an error is logged and the sprite never 
+// becomes ready.
+//
+// Ready times depend on machine speed, so game logic that must play back
+// the same from a recording should not branch on isSpriteReady.
+SpriteHandle loadSpriteAsync( const char *inTGAFileName, 
+                              char inTransparentLowerLeftCorner = true );
+
+
+char isSpriteReady( SpriteHandle inSprite );
+
+
+// number of sprites from loadSpriteAsync still being read, decoded,
+// or uploaded
+int getNumSpritesLoading();
+
+
+// max time spent uploading finished async sprites to GL each frame
+// (at least one is uploaded every frame regardless)
+// defaults to 4 ms
+void setSpriteUploadBudget( double inMilliseconds );
+
+
+// called by platform once per frame to move async sprites along
+void stepAsyncSpriteLoading();
+
+// called by platform at exit
+void freeAsyncSpriteLoading();
+
+
 SpriteHandle fillSprite( Image *inImage, 
                          char inTransparentLowerLeftCorner = true );
 
@@ -177,6 +340,13 @@ SpriteHandle fillSprite( unsigned char *inRGBA,
 SpriteHandle fillSprite( RawRGBAImage *inRawImage );
 
 
+// from a texture made by texturePacker, which is uploaded without
+// decompressing it if the GPU supports its format
+// inTexture destroyed by sprite
+class CompressedTexture;
+SpriteHandle fillSprite( CompressedTexture *inTexture );
+
+
 
 // fill a one-channel (alpha-only) sprite
 // other channels will be set to black.
@@ -208,6 +378,31 @@ RawRGBAImage *readTGAFileRawFromBuffer( unsigned char *inBuffer,
 
 
 
+// reads a TGA file (uncompressed or RLE) from the graphics directory,
+// decoding straight into 4-channel RGBA, ready for 
+// fillSprite( unsigned char*, ... )
+// 24-bit files get an alpha of 255.
+//
+// Decodes into inBuffer, which has room for inMaxPixels pixels 
+// (inMaxPixels * 4 bytes).  
+// Returns false on failure, or if the image is bigger than inMaxPixels.
+// In the latter case, outWidth and outHeight are still set, so
+// caller can grow buffer and try again.
+//
+// Doesn't touch GL, so can be called from a background thread, with
+// fillSprite called later from the main thread.
+char readTGAFileRGBA( const char *inTGAFileName,
+                      unsigned char *inBuffer, int inMaxPixels,
+                      int *outWidth, int *outHeight );
+
+
+// same, but allocates the buffer, which is destroyed by caller
+// returns NULL on failure
+unsigned char *readTGAFileRGBA( const char *inTGAFileName,
+                                int *outWidth, int *outHeight );
+
+
+
 // write a TGA file into main directory
 // Image destroyed by caller
 void writeTGAFile( const char *inTGAFileName, Image *inImage );
@@ -235,12 +430,97 @@ double endCountingSpritePixelsDrawn();
 
 
 
+// also resets batch and flush counts (below)
 void startCountingSpritesDrawn();
 
 // returns the number of sprites drawn since we started counting
 double endCountingSpritesDrawn();
 
 
+// number of draw calls issued for batched sprites, and number of times
+// the sprite batch was flushed, since startCountingSpritesDrawn
+int getNumSpriteBatchesDrawn();
+
+int getNumSpriteBatchFlushes();
+
+
+// totals since startup, unaffected by startCountingSpritesDrawn, so that
+// platform statistics don't disturb the game's own counting
+double getTotalSpritesDrawn();
+
+int getTotalSpriteBatchesDrawn();
+
+
+// When on, drawSprite calls (not drawSpriteInstances) for sprites that
+// would be entirely outside the visible world rectangle, grown by inMargin
+// on each side, are skipped.
+// Sprite bounds come from the sprite's non-transparent area, and are
+// conservative for rotated sprites.
+// Off by default.
+void toggleSpriteCulling( char inCull, double inMargin = 0 );
+
+// sprites skipped by culling since startCountingSpritesDrawn
+double getNumSpritesCulled();
+
+// since startup
+double getTotalSpritesCulled();
+
+
+// world rectangle shown by the current view
+// set by the platform whenever setViewCenterPosition or setLetterbox
+// (in game.h) changes the view
+void setVisibleWorldRect( double inMinX, double inMinY,
+                          double inMaxX, double inMaxY );
+
+void getVisibleWorldRect( double *outMinX, double *outMinY,
+                          double *outMaxX, double *outMaxY );
+
+
+// GL state calls (blend, color, scissor, stencil, texture binds) issued
+// by functions in this header, and skipped because they wouldn't have 
+// changed anything, since startup
+double getTotalGLStateCallsIssued();
+
+double getTotalGLStateCallsSkipped();
+
+
+// GL state set by functions in this header is tracked, so redundant
+// calls can be skipped.  Any direct GL calls that change blending, color,
+// scissor, stencil, color mask, alpha test or texture environment must be
+// followed by a call to this.
+void invalidateGLStateCache();
+
+
+
+// When on, drawSprite calls are queued and drawn together, with one draw
+// call per texture where drawing order allows.
+// Defaults to off.
+//
+// Drawing through the functions in this header flushes the batch when
+// needed, but any direct GL calls must be preceded by flushSpriteBatch
+void toggleSpriteBatching( char inBatch );
+
+// draws all queued sprites now
+void flushSpriteBatch();
+
+
+
+// When on, batched sprites are drawn by a GLSL shader that takes texture
+// coloring (toggleAdditiveTextureColoring, drawSpriteAlphaOnly), distance
+// field sharpness (toggleDistanceFieldTextures), and normal vs. additive
+// blending from each sprite, so switching these doesn't break up
+// batches.  Draw color and fades are per sprite either way.
+// Multiplicative and inverted blends still break batches.
+//
+// Falls back to fixed-function drawing where GLSL isn't available.
+// Only matters when batching (see toggleSpriteBatching).
+// Defaults to off.
+void toggleSpriteShading( char inShade );
+
+// true if batched sprites are currently drawn by the shader
+char isSpriteShadingOn();
+
+
 
 // draw with current draw color
 // mag filter defaults to off (nearest neighbor, big pixels)
@@ -267,6 +547,21 @@ void drawSprite( SpriteHandle inSprite, doublePair inCornerPos[4],
                  FloatColor inCornerColors[4] );
 
 
+// draws inNumInstances copies of a sprite, such as map tiles or
+// particles, much faster than the same number of drawSprite calls
+//
+// inCenters has one center per copy.
+// inScales, inRotations, and inColors are per-copy too, and each can be
+// NULL for a zoom of 1, no rotation, and the current draw color.
+// Rotation is in fractions of a full clockwise rotation, as in drawSprite.
+// Colors are used as given, like corner colors in drawSprite.
+void drawSpriteInstances( SpriteHandle inSprite, int inNumInstances,
+                          const doublePair *inCenters,
+                          const float *inScales = NULL,
+                          const float *inRotations = NULL,
+                          const FloatColor *inColors = NULL );
+
+
 // draw with current draw color, but ignore sprite's colors and use
 // only it's alpha.
 void drawSpriteAlphaOnly( SpriteHandle inSprite, doublePair inCenter, 
@@ -290,6 +585,31 @@ Image *getScreenRegionRaw( int inStartX, int inStartY,
 
 
 
+// Versions of the above that don't stall waiting for the GPU to finish
+// drawing.  The region is read back into a pixel buffer (where supported),
+// and converted to an Image on a background thread.
+//
+// Returns a handle right away.  The region holds what has been drawn so
+// far this frame, as with the blocking versions.
+int requestScreenRegionAsync( double inX, double inY, 
+                              double inWidth, double inHeight );
+
+int requestScreenRegionRawAsync( int inStartX, int inStartY, 
+                                 int inWidth, int inHeight );
+
+
+// Reads are done two frames after they were requested (the same
+// frame every time, so recorded games play back the same way)
+char checkScreenRegionAsyncDone( int inHandle );
+
+
+// this clears the handle
+// returns NULL (and abandons read) if read not done yet
+// result destroyed by caller
+Image *getScreenRegionAsyncImage( int inHandle );
+
+
+
 char isPrintingSupported();
 
 void printImage( Image *inImage, char inFullColor=false );
@@ -10,6 +10,7 @@
 #include <unistd.h>
 #include <stdlib.h>
 #include <math.h>
+#include <stddef.h>
 
 
 // let SDL override our main function with SDLMain
@@ -34,6 +35,8 @@ int main( int inArgCount, char **inArgs ) {
 
 #include "minorGems/graphics/openGL/gui/GUIComponentGL.h"
 #include "minorGems/network/web/WebRequest.h"
+#include "minorGems/network/web/WebCache.h"
+#include "minorGems/network/HostLookupPool.h"
 
 #include "minorGems/graphics/openGL/glInclude.h"
 
@@ -59,19 +62,30 @@ int main( int inArgCount, char **inArgs ) {
 #include "minorGems/util/TranslationManager.h"
 #include "minorGems/util/stringUtils.h"
 #include "minorGems/util/SimpleVector.h"
+#include "minorGems/util/HashMap.h"
+#include "minorGems/util/LockFreeRingBuffer.h"
+#include "minorGems/util/FrameArena.h"
+#include "minorGems/util/ObjectPool.h"
 
 
 #include "minorGems/util/log/AppLog.h"
 #include "minorGems/util/log/FileLog.h"
+#include "minorGems/util/log/AsyncFileLog.h"
+#include "minorGems/util/log/BinaryTraceLog.h"
 
 #include "minorGems/graphics/converters/TGAImageConverter.h"
+#include "minorGems/graphics/converters/tgaDecode.h"
+#include "minorGems/graphics/openGL/CompressedTexture.h"
 
 #include "minorGems/io/file/FileInputStream.h"
+#include "minorGems/io/file/ResourceArchive.h"
 #include "minorGems/util/ByteBufferInputStream.h"
 
 
 #include "minorGems/sound/formats/aiff.h"
 #include "minorGems/sound/audioNoClip.h"
+#include "minorGems/sound/soundSpriteMixer.h"
+#include "minorGems/sound/SoundStream.h"
 
 
 
@@ -116,10 +130,12 @@ void freeWriteFailedPanel() {
 #endif
 
 
-static int nextAsyncFileHandle = 0;
+// reads go to several threads, so that many small files can be in 
+// flight at once
+#define NUM_ASYNC_FILE_THREADS 4
+
 
 typedef struct AsyncFileRecord {
-        int handle;
         char *filePath;
         
         int dataLength;
@@ -127,20 +143,122 @@ typedef struct AsyncFileRecord {
         
         char doneReading;
         
+        // caller gave up on handle before read finished
+        // reader destroys record when done
+        char abandoned;
+        
     } AsyncFileRecord;
 
 
 
 #include "minorGems/system/StopSignalThread.h"
 #include "minorGems/system/MutexLock.h"
+#include "minorGems/system/ReadWriteLock.h"
 #include "minorGems/system/BinarySemaphore.h"
+#include "minorGems/system/ZoneProfiler.h"
+#include "minorGems/system/StartupTimeline.h"
+
+// protects everything below except where noted
+// main thread polls for done reads every frame, a read-only check, so
+// those polls only take it for reading
+static ReadWriteLock asyncLock;
+
+// indexed by handle, NULL once handle cleared
+// records are on heap, so pointers stay valid as table grows
+static SimpleVector<AsyncFileRecord*> asyncFileTable;
+
+// next handle for a reader thread to pick up
+static int nextAsyncFileToRead = 0;
+
+// all handles up to and including this one are done reading
+// reads finish out of order across threads, but are reported done in 
+// handle order, which keeps the single-number playback record 
+// (registerAsyncFileDone / getAsyncFileDone) valid
+static int asyncFilesDoneThrough = -1;
+
+static char asyncFileThreadsStopped = false;
+
+
+// main thread only
+// last handle passed to registerAsyncFileDone
+static int lastAsyncFileDoneRegistered = -1;
+// next handle for getAsyncFileReadsDone to report
+static int nextAsyncFileDoneToReport = 0;
+
 
-static MutexLock asyncLock;
 static BinarySemaphore newFileToReadSem;
 
 static BinarySemaphore newFileDoneReadingSem;
 
-static SimpleVector<AsyncFileRecord> asyncFiles;
+
+
+// resources.pack from game folder, if there is one, consulted before 
+// loose files (see minorGems/game/resourcePacker)
+// declared before asyncFileReaders, so that it outlives their threads
+class ResourceArchiveHolder {
+    public:
+        ResourceArchiveHolder()
+                : archive( NULL ) {
+            }
+        
+        ~ResourceArchiveHolder() {
+            if( archive != NULL ) {
+                delete archive;
+                }
+            }
+        
+        ResourceArchive *archive;
+    };
+
+static ResourceArchiveHolder resourceArchive;
+
+
+
+static void openResourceArchive() {
+    ResourceArchive *archive = new ResourceArchive( "resources.pack" );
+    
+    if( ! archive->isOpen() ) {
+        delete archive;
+        return;
+        }
+    
+    AppLog::infoF( "Using resources.pack, with %d resources",
+                   archive->getNumEntries() );
+
+    resourceArchive.archive = archive;
+    
+    SettingsManager::setDefaultsSource( archive );
+    }
+
+
+
+// reads a file from resources.pack
+// returns NULL if there's no archive or it doesn't contain file
+// thread-safe
+static unsigned char *readArchivedFile( const char *inFilePath,
+                                        int *outLength ) {
+    if( resourceArchive.archive == NULL ) {
+        return NULL;
+        }
+    return resourceArchive.archive->readResource( inFilePath, outLength );
+    }
+
+
+
+// must hold asyncLock
+static void advanceAsyncFilesDone() {
+    while( asyncFilesDoneThrough + 1 < asyncFileTable.size() ) {
+        AsyncFileRecord *r = 
+            asyncFileTable.getElementDirect( asyncFilesDoneThrough + 1 );
+        
+        // NULL means cleared, which can only happen after done
+        if( r != NULL && ! r->doneReading ) {
+            break;
+            }
+        asyncFilesDoneThrough ++;
+        }
+    }
+
 
 
 class AsyncFileThread : public StopSignalThread {
@@ -155,72 +273,92 @@ class AsyncFileThread : public StopSignalThread {
             stop();
             newFileToReadSem.signal();
             join();
-
-            for( int i=0; i<asyncFiles.size(); i++ ) {
-        
-                AsyncFileRecord *r = asyncFiles.getElement( i );
-                
-                if( r->filePath != NULL ) {
-                    delete [] r->filePath;
-                    }
-                
-                if( r->data != NULL ) {
-                    delete [] r->data;
-                    }
-                }
-            asyncFiles.deleteAll();
             }
         
 
         virtual void run() {
+            PROFILE_THREAD_NAME( "asyncFile" );
+
             while( ! isStopped() ) {
                 
                 int handleToRead = -1;
                 char *pathToRead = NULL;
+                char moreToRead = false;
+                
+                asyncLock.lockWrite();
                 
-                asyncLock.lock();
+                char allStopped = asyncFileThreadsStopped;
                 
-                for( int i=0; i<asyncFiles.size(); i++ ) {
-                    AsyncFileRecord *r = asyncFiles.getElement( i );
+                if( ! allStopped &&
+                    nextAsyncFileToRead < asyncFileTable.size() ) {
                     
-                    if( ! r->doneReading ) {
-                        // can't trust pointer to record in vector
-                        // outside of lock, because vector storage may
-                        // change
-                        handleToRead = r->handle;
-                        pathToRead = r->filePath;
-                        break;
-                        }
+                    handleToRead = nextAsyncFileToRead;
+                    nextAsyncFileToRead ++;
+                    
+                    pathToRead = 
+                        asyncFileTable.getElementDirect( handleToRead )->
+                        filePath;
+                    
+                    moreToRead = 
+                        ( nextAsyncFileToRead < asyncFileTable.size() );
                     }
 
-                asyncLock.unlock();
+                asyncLock.unlockWrite();
 
+                if( allStopped ) {
+                    // pass stop signal along to other threads
+                    newFileToReadSem.signal();
+                    return;
+                    }
+                
                 if( handleToRead != -1 ) {
-                    // read file data
 
-                    File f( NULL, pathToRead );
+                    if( moreToRead ) {
+                        // semaphore is binary, so signals that came while
+                        // all threads were busy may have been merged
+                        // wake another thread to help
+                        newFileToReadSem.signal();
+                        }
                     
-                    int dataLength;
-                    unsigned char *data = f.readFileContents( &dataLength );
+                    // read file data
+                    // record (and path) can't be destroyed until we 
+                    // mark it done
 
-                    // re-lock vector, search for handle, and add it
-                    // cannot count on vector order or pointers to records
-                    // when we don't have it locked
+                    int dataLength;
+                    unsigned char *data;
+                    {
+                        PROFILE_ZONE( "asyncFileRead" );
+                        data = readArchivedFile( pathToRead, &dataLength );
+                        
+                        if( data == NULL ) {
+                            File f( NULL, pathToRead );
+                            data = f.readFileContents( &dataLength );
+                            }
+                        }
 
-                    asyncLock.lock();
+                    asyncLock.lockWrite();
                     
-                    for( int i=0; i<asyncFiles.size(); i++ ) {
-                        AsyncFileRecord *r = asyncFiles.getElement( i );
+                    AsyncFileRecord *r = 
+                        asyncFileTable.getElementDirect( handleToRead );
                     
-                        if( r->handle == handleToRead ) {
-                            r->dataLength = dataLength;
-                            r->data = data;
-                            r->doneReading = true;
-                            break;
+                    if( r->abandoned ) {
+                        if( data != NULL ) {
+                            delete [] data;
                             }
+                        delete [] r->filePath;
+                        delete r;
+                        *( asyncFileTable.getElement( handleToRead ) ) = 
+                            NULL;
                         }
-
-                    asyncLock.unlock();
+                    else {
+                        r->dataLength = dataLength;
+                        r->data = data;
+                        r->doneReading = true;
+                        }
+                    
+                    advanceAsyncFilesDone();
+                    
+                    asyncLock.unlockWrite();
 
                     // let anyone waiting for a new file to finish
                     // reading (only matters in the case of playback, where
@@ -237,7 +375,46 @@ class AsyncFileThread : public StopSignalThread {
     };
 
 
-static AsyncFileThread fileReadThread;
+
+class AsyncFileReaders {
+    public:
+        
+        AsyncFileReaders() {
+            for( int i=0; i<NUM_ASYNC_FILE_THREADS; i++ ) {
+                mThreads[i] = new AsyncFileThread();
+                }
+            }
+        
+        ~AsyncFileReaders() {
+            asyncLock.lockWrite();
+            asyncFileThreadsStopped = true;
+            asyncLock.unlockWrite();
+
+            for( int i=0; i<NUM_ASYNC_FILE_THREADS; i++ ) {
+                delete mThreads[i];
+                }
+            
+            for( int i=0; i<asyncFileTable.size(); i++ ) {
+                AsyncFileRecord *r = asyncFileTable.getElementDirect( i );
+                
+                if( r != NULL ) {
+                    delete [] r->filePath;
+                    
+                    if( r->data != NULL ) {
+                        delete [] r->data;
+                        }
+                    delete r;
+                    }
+                }
+            asyncFileTable.deleteAll();
+            }
+        
+    protected:
+        AsyncFileThread *mThreads[ NUM_ASYNC_FILE_THREADS ];
+    };
+
+
+static AsyncFileReaders asyncFileReaders;
 
 
 
@@ -266,6 +443,21 @@ SimpleVector<int> possibleFrameRates;
 char countingOnVsync = false;
 
 
+// fixed-timestep game logic updates, 0 for one update per frame
+static int fixedUpdateRate = 0;
+
+// game time not yet consumed by updates
+static double updateTimeAccumulator = 0;
+static double lastUpdateClockTime = -1;
+
+static int numUpdatesThisFrame = 0;
+static double updateInterpolation = 1;
+
+// if we fall further behind than this, game logic slows down instead of
+// spending ever more of each frame catching up
+#define MAX_UPDATES_PER_FRAME 8
+
+
 int soundSampleRate = 22050;
 //int soundSampleRate = 44100;
 
@@ -296,6 +488,10 @@ char frameDrawerInited = false;
 // read from settings folder
 char enableSpeedControlKeys = false;
 
+// F3 toggles stats overlay
+// read from settings folder
+char enableStatsOverlayKey = false;
+
 // should each and every frame be saved to disk?
 // useful for making videos
 char outputAllFrames = false;
@@ -316,6 +512,14 @@ static unsigned char *lastFrame_rgbaBytes = NULL;
 static unsigned int frameNumber = 0;
 
 
+#ifdef DEBUG_MEMORY
+// allocation churn is written to memoryChurn.csv every this many frames
+#define MEMORY_CHURN_FRAMES 600
+
+static int lastMemorySnapshot = -1;
+#endif
+
+
 static char recordAudio = false;
 
 static FILE *aiffOutFile = NULL;
@@ -362,7 +566,9 @@ char mouseWorldCoordinates = true;
     static const char *screenShotExtension = "jpg";
 #elif defined(USE_PNG)
     #include "minorGems/graphics/converters/PNGImageConverter.h"
-    static PNGImageConverter screenShotConverter;
+    // built-in fast encoder, since screenshots and captured frames are
+    // written while the game keeps running
+    static PNGImageConverter screenShotConverter( 5, PNG_ENCODE_FAST );
     static const char *screenShotExtension = "png";
 #else
     static TGAImageConverter screenShotConverter;
@@ -492,22 +698,69 @@ int pixelZoomFactor;
 
 
 
-typedef struct WebRequestRecord {
-        int handle;
-        WebRequest *request;
-    } WebRequestRecord;
+// requests and sockets by handle
+HashMap<int, WebRequest*> webRequestRecords;
 
-SimpleVector<WebRequestRecord> webRequestRecords;
+HashMap<int, Socket*> socketConnectionRecords;
 
 
+// a connection racing several addresses, until one attempt connects and
+// its socket moves to socketConnectionRecords
+typedef struct PendingSocketConnect {
+        SimpleVector<char*> addresses;
+        int port;
 
+        // index in addresses of next attempt to start
+        int nextAddress;
+        
+        SimpleVector<Socket*> attempts;
 
-typedef struct SocketConnectionRecord {
-        int handle;
-        Socket *sock;
-    } SocketConnectionRecord;
+        double nextAttemptTime;
+        
+        // true once an attempt has connected (and moved over)
+        char connected;
+        
+        // true once every attempt has failed
+        char failed;
+    } PendingSocketConnect;
 
-SimpleVector<SocketConnectionRecord> socketConnectionRecords;
+HashMap<int, PendingSocketConnect*> pendingSocketConnects;
+
+
+// NULL if disabled
+static WebCache *webCache = NULL;
+
+// a GET request that may be served from, or saved to, webCache
+// a request served from cache has no WebRequest
+typedef struct WebCacheRecord {
+        char *url;
+
+        // true if request asks server whether cached body is current
+        char revalidating;
+
+        // handle of read of body from cache, or -1
+        int fileReadHandle;
+        
+        // body read from cache, or NULL
+        unsigned char *body;
+        int bodySize;
+    } WebCacheRecord;
+
+// by web request handle
+HashMap<int, WebCacheRecord*> webCacheRecords;
+
+static int numWebCacheHits = 0;
+static int numWebCacheRevalidations = 0;
+static int numWebCacheMisses = 0;
+
+static void freeWebCacheRecord( WebCacheRecord *inRecord );
+
+
+static void flushSocketSendQueues();
+
+static void stepPendingSocketConnects();
+
+static void freeStatsOverlay();
 
 
 
@@ -521,18 +774,24 @@ void getScreenDimensions( int *outWidth, int *outHeight ) {
 typedef struct SoundSprite {
         int handle;
         int numSamples;
-        int samplesPlayed;
 
         // true for sound sprites that are marked to never use
         // pitch and volume variance
         char noVariance;
+        
+        // NULL if not resident (see setSoundSpriteMemoryBudget)
+        Sint16 *samples;
 
-        // floating point position of next interpolated sameple to play
-        // (for variable rate playback)
-        double samplesPlayedF;
+        // file to decode samples from again after they are dropped,
+        // or NULL for sprites made by setSoundSprite, which always stay
+        // resident
+        char *filePath;
         
+        // -1 unless a prefetch read is in flight
+        int prefetchReadHandle;
         
-        Sint16 *samples;
+        // soundSpritePlayTick when last played or loaded
+        unsigned int lastUsedTick;
     } SoundSprite;
 
 
@@ -543,26 +802,217 @@ typedef struct SoundSprite {
 //  without accessing this vector).
 static SimpleVector<SoundSprite*> soundSprites;
 
-// audio thread is locked every time we touch this vector
-// So, we want to avoid mallocs here
+// SoundSprite records, recycled as games load and free sprites
+static ObjectPool<SoundSprite> soundSpritePool;
+
+// Fixed-capacity, structure-of-arrays table of playing voices.
+//
+// Audio thread is locked every time we touch this table, so we want
+// removal to be cheap:  finished voices are swap-removed in O(1) by moving
+// the last voice into their slot, keeping the table dense so the mixer
+// can stream straight through each array.
+//
+// Capacity only grows if more voices are playing than ever before (or when
+// setMaxSimultaneousSoundSprites raises the cap), so steady-state playback
+// never allocates.
+typedef struct SoundSpriteVoiceTable {
+        int capacity;
+        int numVoices;
+        
+        int *handle;
+        Sint16 **samples;
+        int *numSamples;
+        
+        // 32.32 fixed-point position of next sample to play
+        uint64_t *phase;
+        
+        // SOUND_SPRITE_PHASE_ONE for normal-rate playback
+        uint64_t *phaseStep;
+        
+        float *volumeL;
+        float *volumeR;
+    } SoundSpriteVoiceTable;
+
+
+static SoundSpriteVoiceTable playingVoices = 
+    { 0, 0, NULL, NULL, NULL, NULL, NULL, NULL, NULL };
+
+
 // Can we imagine more than 100 sound sprites ever playing at the same time?
-static SimpleVector<SoundSprite> playingSoundSprites( 100 );
+static const int defaultVoiceTableCapacity = 100;
+
+
+
+// streams playing, touched only by audio thread (or while audio locked)
+typedef struct StreamVoice {
+        SoundStream *stream;
+        float volumeL;
+        float volumeR;
+    } StreamVoice;
+
+// music and ambience tracks, not a crowd of effects
+#define MAX_STREAM_VOICES 16
+
+static StreamVoice streamVoices[ MAX_STREAM_VOICES ];
+static int numStreamVoices = 0;
+
+
+
+
+typedef struct SoundStreamRecord {
+        SoundStream *stream;
+        
+        // set by play, cleared by stop
+        char playing;
+    } SoundStreamRecord;
+
+
+// created when first stream opened
+static SoundStreamReader *soundStreamReader = NULL;
+
+static SimpleVector<SoundStreamRecord*> soundStreamRecords;
+
+
+
+template <class Type>
+static void resizeVoiceArray( Type **ioArray, int inOldSize, int inNewSize ) {
+    Type *newArray = new Type[ inNewSize ];
+    
+    if( *ioArray != NULL ) {
+        memcpy( newArray, *ioArray, inOldSize * sizeof( Type ) );
+        delete [] *ioArray;
+        }
+    *ioArray = newArray;
+    }
+
+
+
+// audio must be locked, or audio thread not running
+static void setVoiceTableCapacity( SoundSpriteVoiceTable *inTable, 
+                                   int inCapacity ) {
+    if( inCapacity <= inTable->capacity ) {
+        return;
+        }
+    
+    int n = inTable->numVoices;
+    
+    resizeVoiceArray( &( inTable->handle ), n, inCapacity );
+    resizeVoiceArray( &( inTable->samples ), n, inCapacity );
+    resizeVoiceArray( &( inTable->numSamples ), n, inCapacity );
+    resizeVoiceArray( &( inTable->phase ), n, inCapacity );
+    resizeVoiceArray( &( inTable->phaseStep ), n, inCapacity );
+    resizeVoiceArray( &( inTable->volumeL ), n, inCapacity );
+    resizeVoiceArray( &( inTable->volumeR ), n, inCapacity );
+    
+    inTable->capacity = inCapacity;
+    }
+
+
+
+static void freeVoiceTable( SoundSpriteVoiceTable *inTable ) {
+    if( inTable->capacity > 0 ) {
+        delete [] inTable->handle;
+        delete [] inTable->samples;
+        delete [] inTable->numSamples;
+        delete [] inTable->phase;
+        delete [] inTable->phaseStep;
+        delete [] inTable->volumeL;
+        delete [] inTable->volumeR;
+        }
+    SoundSpriteVoiceTable empty = 
+        { 0, 0, NULL, NULL, NULL, NULL, NULL, NULL, NULL };
+    
+    *inTable = empty;
+    }
+
+
+
+// audio must be locked
+static void addVoice( SoundSpriteVoiceTable *inTable, SoundSprite *inSprite,
+                      double inRate, float inVolumeL, float inVolumeR ) {
+    
+    if( inTable->numVoices == inTable->capacity ) {
+        int newCapacity = inTable->capacity * 2;
+        
+        if( newCapacity < defaultVoiceTableCapacity ) {
+            newCapacity = defaultVoiceTableCapacity;
+            }
+        setVoiceTableCapacity( inTable, newCapacity );
+        }
+    
+    int i = inTable->numVoices;
+    
+    inTable->handle[i] = inSprite->handle;
+    inTable->samples[i] = inSprite->samples;
+    inTable->numSamples[i] = inSprite->numSamples;
+    inTable->phase[i] = 0;
+    inTable->phaseStep[i] = getSoundSpritePhaseStep( inRate );
+    inTable->volumeL[i] = inVolumeL;
+    inTable->volumeR[i] = inVolumeR;
+    
+    inTable->numVoices ++;
+    }
+
+
+
+// audio must be locked
+// O(1), moves last voice into this slot (so voice order is not preserved)
+static void removeVoice( SoundSpriteVoiceTable *inTable, int inIndex ) {
+    int last = inTable->numVoices - 1;
+    
+    if( inIndex != last ) {
+        inTable->handle[ inIndex ] = inTable->handle[ last ];
+        inTable->samples[ inIndex ] = inTable->samples[ last ];
+        inTable->numSamples[ inIndex ] = inTable->numSamples[ last ];
+        inTable->phase[ inIndex ] = inTable->phase[ last ];
+        inTable->phaseStep[ inIndex ] = inTable->phaseStep[ last ];
+        inTable->volumeL[ inIndex ] = inTable->volumeL[ last ];
+        inTable->volumeR[ inIndex ] = inTable->volumeR[ last ];
+        }
+    
+    inTable->numVoices --;
+    }
 
-static double *soundSpriteMixingBufferL = NULL;
-static double *soundSpriteMixingBufferR = NULL;
 
 
-// variable rate per sprite
-// these are also touched with audio thread locked, so avoid mallocs
-// we won't see more than 100 of these simultaneously either
-static SimpleVector<double> playingSoundSpriteRates( 100 );
-static SimpleVector<double> playingSoundSpriteVolumesR( 100 );
-static SimpleVector<double> playingSoundSpriteVolumesL( 100 );
+static char isVoiceDone( SoundSpriteVoiceTable *inTable, int inIndex ) {
+    int index = getSoundSpritePhaseIndex( inTable->phase[ inIndex ] );
+    
+    if( inTable->phaseStep[ inIndex ] == SOUND_SPRITE_PHASE_ONE ) {
+        return ( index >= inTable->numSamples[ inIndex ] );
+        }
+    else {
+        // interpolated playback can never reach the last sample
+        return ( index >= inTable->numSamples[ inIndex ] - 1 );
+        }
+    }
+
+
+
+// float accumulators, so the mixer can run 4 or 8 samples wide
+static float *soundSpriteMixingBufferL = NULL;
+static float *soundSpriteMixingBufferR = NULL;
+
+// final mix, in [-1,1], when game makes float samples
+static float *soundMixingBufferL = NULL;
+static float *soundMixingBufferR = NULL;
+
+static GetSoundSamplesFloatFunction getSoundSamplesFloatFunction = NULL;
+
+// true if audio device takes float samples instead of 16-bit
+static char soundOutputFloat = false;
 
 
 static SDL_Cursor *ourCursor = NULL;
 
 
+static void freeFrameCapture();
+static void flushFrameCapture();
+static void saveNextShotNumber();
+static void stepScreenRegionReads();
+static void freeScreenRegionReads();
+
+
 // function that destroys object when exit is called.
 // exit is the only way to stop the loop in  ScreenGL
 void cleanUpAtExit() {
@@ -580,6 +1030,16 @@ void cleanUpAtExit() {
     soundOpen = false;
 
 
+    AppLog::info( "exiting: stopping async sprite loading\n" );
+    freeAsyncSpriteLoading();
+
+    AppLog::info( "exiting: writing out captured frames\n" );
+    freeFrameCapture();
+    saveNextShotNumber();
+    
+    // after frame capture threads, which convert them, are done
+    freeScreenRegionReads();
+
     AppLog::info( "exiting: Deleting sceneHandler\n" );
     delete sceneHandler;
 
@@ -588,14 +1048,39 @@ void cleanUpAtExit() {
     AppLog::info( "Freeing sound sprites\n" );
     for( int i=0; i<soundSprites.size(); i++ ) {
         SoundSprite *s = soundSprites.getElementDirect( i );
-        delete [] s->samples;
-        delete s;
+        
+        if( s->prefetchReadHandle != -1 ) {
+            // abandon read, or take data it left behind
+            int length;
+            unsigned char *data = getAsyncFileData( s->prefetchReadHandle,
+                                                    &length );
+            if( data != NULL ) {
+                delete [] data;
+                }
+            }
+        if( s->samples != NULL ) {
+            delete [] s->samples;
+            }
+        if( s->filePath != NULL ) {
+            delete [] s->filePath;
+            }
+        soundSpritePool.destroy( s );
         }
     soundSprites.deleteAll();
-    playingSoundSprites.deleteAll();
-    playingSoundSpriteRates.deleteAll();
-    playingSoundSpriteVolumesL.deleteAll();
-    playingSoundSpriteVolumesR.deleteAll();
+    freeVoiceTable( &playingVoices );
+    
+    AppLog::info( "Closing sound streams\n" );
+    if( soundStreamReader != NULL ) {
+        delete soundStreamReader;
+        soundStreamReader = NULL;
+        }
+    for( int i=0; i<soundStreamRecords.size(); i++ ) {
+        SoundStreamRecord *r = soundStreamRecords.getElementDirect( i );
+        delete r->stream;
+        delete r;
+        }
+    soundStreamRecords.deleteAll();
+    numStreamVoices = 0;
     
     if( bufferSizeHinted ) {
         freeHintedBuffers();
@@ -608,10 +1093,16 @@ void cleanUpAtExit() {
         freeFrameDrawer();
         }
     
+    freeStatsOverlay();
+    
     
     AppLog::info( "exiting: Deleting screen\n" );
     delete screen;
 
+    // after everything that might save a setting
+    AppLog::info( "exiting: writing pending settings\n" );
+    SettingsManager::flushAll();
+
 
     AppLog::info( "exiting: freeing drawString\n" );
     freeDrawString();
@@ -646,14 +1137,55 @@ void cleanUpAtExit() {
         aiffOutFile = NULL;
         }
     
-    for( int i=0; i<webRequestRecords.size(); i++ ) {
-        AppLog::infoF( "exiting: Deleting lingering web request %d\n", i ); 
-                
-        WebRequestRecord *r = webRequestRecords.getElement( i );
+    for( int i=0; i<webRequestRecords.getNumSlots(); i++ ) {
+        if( ! webRequestRecords.isSlotFilled( i ) ) {
+            continue;
+            }
+        AppLog::infoF( "exiting: Deleting lingering web request %d\n", 
+                       webRequestRecords.getSlotKey( i ) ); 
+        
+        delete *( webRequestRecords.getSlotValue( i ) );
+        }
+    webRequestRecords.deleteAll();
+
+    for( int i=0; i<webCacheRecords.getNumSlots(); i++ ) {
+        if( webCacheRecords.isSlotFilled( i ) ) {
+            freeWebCacheRecord( *( webCacheRecords.getSlotValue( i ) ) );
+            }
+        }
+    webCacheRecords.deleteAll();
+
+    if( webCache != NULL ) {
+        if( numWebCacheHits + numWebCacheRevalidations + 
+            numWebCacheMisses > 0 ) {
+            
+            AppLog::infoF( "exiting: web cache %d hits, "
+                           "%d revalidated, %d misses, "
+                           "%d bodies (%d bytes) cached\n",
+                           numWebCacheHits, numWebCacheRevalidations,
+                           numWebCacheMisses, webCache->getNumEntries(),
+                           webCache->getTotalBytes() );
+            }
+        delete webCache;
+        webCache = NULL;
+        }
+
+    if( WebRequest::getLatencyPercentile( 0.5 ) >= 0 ) {
+        int numReused, numNew;
+        WebRequest::getConnectionCounts( &numReused, &numNew );
         
-        delete r->request;
+        AppLog::infoF( "exiting: web request latency p50=%.0fms "
+                       "p90=%.0fms p99=%.0fms "
+                       "(%d reused connections, %d new)\n",
+                       1000 * WebRequest::getLatencyPercentile( 0.5 ),
+                       1000 * WebRequest::getLatencyPercentile( 0.9 ),
+                       1000 * WebRequest::getLatencyPercentile( 0.99 ),
+                       numReused, numNew );
         }
 
+    WebRequest::closeIdleConnections();
+    HostLookupPool::shutdown();
+
     if( webProxy != NULL ) {
         delete [] webProxy;
         webProxy = NULL;
@@ -667,7 +1199,27 @@ void cleanUpAtExit() {
         delete [] soundSpriteMixingBufferR;
         }
     
+    if( soundMixingBufferL != NULL ) {
+        delete [] soundMixingBufferL;
+        }
+    
+    if( soundMixingBufferR != NULL ) {
+        delete [] soundMixingBufferR;
+        }
+    
     
+    // does nothing unless built with MUTEX_LOCK_PROFILING
+    MutexLock::logProfile();
+
+    // does nothing unless built with ZONE_PROFILING
+    ZoneProfiler::logProfile();
+    ZoneProfiler::writeChromeTrace( "profile.json" );
+
+    // if quit before first frame
+    StartupTimeline::finish( "startupTimeline.json" );
+
+    FrameArena::destroyThreadArenas();
+
     AppLog::info( "exiting: Done.\n" );
     }
 
@@ -710,3750 +1262,5976 @@ static char soundSpritesFading = false;
 static float soundSpriteFadeIncrementPerSample = 0.0f;
 
 
-void setSoundLoudness( float inLoudness ) {
-    lockAudio();
-    soundLoudness = inLoudness;
-    currentSoundLoudness = inLoudness;
-    unlockAudio();
-    }
+static int maxSimultaneousSoundSprites = -1;
 
 
-void fadeSoundSprites( double inFadeSeconds ) {
-    lockAudio();
-    soundSpritesFading = true;
-    
-    soundSpriteFadeIncrementPerSample = 
-        1.0f / ( inFadeSeconds * soundSampleRate );
-    
-    unlockAudio();
-    }
 
+// Commands from game thread to audio thread.
+//
+// The game thread pushes these into a lock-free queue, and audioCallback
+// drains the queue at the start of each buffer, so playing sounds and
+// changing volumes never contends with the audio thread for the SDL
+// audio lock.
+typedef enum AudioCommandType {
+    audioCommandPlay,
+    audioCommandStop,
+    audioCommandFade,
+    audioCommandResume,
+    audioCommandLoudness,
+    audioCommandPlayStream,
+    audioCommandStopStream
+    } AudioCommandType;
 
 
-void resumePlayingSoundSprites() {
-    lockAudio();
-    soundSpritesFading = false;
-    soundSpriteGlobalLoudness = 1.0f;
-    unlockAudio();
-    }
-
-    
-
+typedef struct AudioCommand {
+        AudioCommandType type;
+        
+        // for play and stop
+        SoundSprite *sprite;
+        
+        // for play stream and stop stream
+        SoundStream *stream;
+        
+        // for play and play stream
+        double rate;
+        float volumeL;
+        float volumeR;
+        
+        // fade increment per sample, or loudness
+        float value;
+    } AudioCommand;
 
 
-SoundSpriteHandle loadSoundSprite( const char *inAIFFFileName ) {
-    return loadSoundSprite( "sounds", inAIFFFileName );
-    }
+// plenty for a burst of sounds triggered in one frame
+static LockFreeRingBuffer<AudioCommand> audioCommands( 1024 );
 
 
-SoundSpriteHandle loadSoundSprite( const char *inFolderName,
-                                   const char *inAIFFFileName ) {
-    
-    File aiffFile( new Path( inFolderName ), inAIFFFileName );
 
-    if( ! aiffFile.exists() ) {
-        printf( "File does not exist in sounds folder: %s\n", 
-                inAIFFFileName );
-        return NULL;
+// audio thread (or any thread while audio locked)
+static void applyAudioCommand( AudioCommand *inC ) {
+    switch( inC->type ) {
+        case audioCommandPlay: {
+            if( soundSpritesFading && soundSpriteGlobalLoudness == 0.0f ) {
+                // don't play any new sound sprites
+                return;
+                }
+            
+            if( maxSimultaneousSoundSprites != -1 &&
+                playingVoices.numVoices >= maxSimultaneousSoundSprites ) {
+                // cap would be exceeded
+                // don't play this sound sprite at all
+                return;
+                }
+            
+            SoundSprite *s = inC->sprite;
+
+            if( s->numSamples / soundSampleRate > 5 ) {
+                // a long sound, longer than 5 seconds total
+                // perhaps a bit of music or some other structured sound
+                // instead of an instant "hit" type sound
+                // Don't ever play more than one instance of a longer sound
+                // simultaneously.
+                
+                for( int i=0; i<playingVoices.numVoices; i++ ) {
+                    if( playingVoices.handle[i] == s->handle ) {
+                        // already playing this sound sprite
+                        return;
+                        }
+                    }
+                }
+            
+            addVoice( &playingVoices, s, inC->rate, 
+                      inC->volumeL, inC->volumeR );
+            break;
+            }
+        case audioCommandStop:
+            for( int i=playingVoices.numVoices-1; i>=0; i-- ) {
+                if( playingVoices.handle[i] == inC->sprite->handle ) {
+                    // stop it abruptly
+                    removeVoice( &playingVoices, i );
+                    }
+                }
+            break;
+        case audioCommandFade:
+            soundSpritesFading = true;
+            soundSpriteFadeIncrementPerSample = inC->value;
+            break;
+        case audioCommandResume:
+            soundSpritesFading = false;
+            soundSpriteGlobalLoudness = 1.0f;
+            break;
+        case audioCommandLoudness:
+            soundLoudness = inC->value;
+            currentSoundLoudness = inC->value;
+            break;
+        case audioCommandPlayStream:
+            if( soundSpritesFading && soundSpriteGlobalLoudness == 0.0f ) {
+                return;
+                }
+            if( numStreamVoices < MAX_STREAM_VOICES ) {
+                StreamVoice *v = &( streamVoices[ numStreamVoices ] );
+                v->stream = inC->stream;
+                v->volumeL = inC->volumeL;
+                v->volumeR = inC->volumeR;
+                numStreamVoices++;
+                }
+            break;
+        case audioCommandStopStream:
+            for( int i=numStreamVoices-1; i>=0; i-- ) {
+                if( streamVoices[i].stream == inC->stream ) {
+                    streamVoices[i] = streamVoices[ numStreamVoices - 1 ];
+                    numStreamVoices--;
+                    }
+                }
+            break;
         }
-    
-    int numBytes;
-    unsigned char *data = aiffFile.readFileContents( &numBytes );
-    
+    }
 
-    if( data == NULL ) {
-        printf( "Failed to read sound file: %s\n", inAIFFFileName );
-        return NULL;
-        }
 
 
-    int numSamples;
-    int16_t *samples = readMono16AIFFData( data, numBytes, &numSamples );
-    
-    delete [] data;
+// audio thread (or any thread while audio locked)
+static void drainAudioCommands() {
+    AudioCommand c;
     
-    if( samples == NULL ) {
-        printf( "Failed to parse AIFF sound file: %s\n", inAIFFFileName );
-        return NULL;
+    while( audioCommands.pop( &c ) ) {
+        applyAudioCommand( &c );
         }
-
-    SoundSpriteHandle s = setSoundSprite( samples, numSamples );
-    
-    delete [] samples;
-    
-    return s;
     }
 
 
 
-SoundSpriteHandle setSoundSprite( int16_t *inSamples, int inNumSamples ) {
-    SoundSprite *s = new SoundSprite;
-    
-    s->handle = nextSoundSpriteHandle ++;
-    s->numSamples = inNumSamples;
-    
-    s->noVariance = false;
-
-    s->samplesPlayed = 0;
-    s->samplesPlayedF = 0;
-    
-    s->samples = new Sint16[ s->numSamples ];
-    
-    memcpy( s->samples, inSamples, inNumSamples * sizeof( int16_t ) );
-
-    soundSprites.push_back( s );
-    
-    return (SoundSpriteHandle)s;
+// game thread
+static void pushAudioCommand( AudioCommand inC ) {
+    if( ! audioCommands.push( inC ) ) {
+        // queue full (audio thread stalled, or sound not running)
+        // fall back to draining it ourselves under the lock
+        lockAudio();
+        drainAudioCommands();
+        applyAudioCommand( &inC );
+        unlockAudio();
+        }
     }
 
 
 
-void toggleVariance( SoundSpriteHandle inHandle, char inNoVariance ) {
-    SoundSprite *s = (SoundSprite*)inHandle;
-    s->noVariance = inNoVariance;
+static AudioCommand makeAudioCommand( AudioCommandType inType ) {
+    AudioCommand c;
+    c.type = inType;
+    c.sprite = NULL;
+    c.stream = NULL;
+    c.rate = 1.0;
+    c.volumeL = 0;
+    c.volumeR = 0;
+    c.value = 0;
+    return c;
     }
 
 
 
+void setSoundLoudness( float inLoudness ) {
+    AudioCommand c = makeAudioCommand( audioCommandLoudness );
+    c.value = inLoudness;
+    pushAudioCommand( c );
+    }
 
-static double maxTotalSoundSpriteVolume = 1.0;
-
-static double soundSpriteCompressionFraction = 0.0;
-
-static double totalSoundSpriteNormalizeFactor = 1.0;
-
-static NoClip soundSpriteNoClip;
-
-static NoClip totalAudioMixNoClip;
-                                                   
-
-void setMaxTotalSoundSpriteVolume( double inMaxTotal, 
-                                   double inCompressionFraction ) {
-    lockAudio();
-
-    maxTotalSoundSpriteVolume = inMaxTotal;
-    soundSpriteCompressionFraction = inCompressionFraction;
 
-    totalSoundSpriteNormalizeFactor = 
-        1.0 / ( 1.0 - soundSpriteCompressionFraction );
-    
-    soundSpriteNoClip =
-        resetAudioNoClip( ( 1.0 - soundSpriteCompressionFraction ) *
-                          maxTotalSoundSpriteVolume * 32767, 
-                          // half second hold and release
-                          soundSampleRate / 2, soundSampleRate / 2 );
-    
-    unlockAudio();
+void fadeSoundSprites( double inFadeSeconds ) {
+    AudioCommand c = makeAudioCommand( audioCommandFade );
+    c.value = 1.0f / ( inFadeSeconds * soundSampleRate );
+    pushAudioCommand( c );
     }
 
 
-static int maxSimultaneousSoundSprites = -1;
-
 
-void setMaxSimultaneousSoundSprites( int inMaxCount ) {
-    maxSimultaneousSoundSprites = inMaxCount;
+void resumePlayingSoundSprites() {
+    pushAudioCommand( makeAudioCommand( audioCommandResume ) );
     }
 
+    
 
 
 
-static double pickRandomRate() {
-    if( soundSpriteRateMax != 1.0 ||
-        soundSpriteRateMin != 1.0 ) { 
-        
-        return randSource.getRandomBoundedDouble( soundSpriteRateMin, 
-                                                  soundSpriteRateMax );
-        }
-    else {
-        return 1.0;
-        }
+SoundSpriteHandle loadSoundSprite( const char *inAIFFFileName ) {
+    return loadSoundSprite( "sounds", inAIFFFileName );
     }
 
 
+// -1 for no limit
+static int soundSpriteMemoryBudget = -1;
 
-static double pickRandomVolume() {
-    if( soundSpriteVolumeMax != 1.0 ||
-        soundSpriteVolumeMin != 1.0 ) { 
-        
-        return randSource.getRandomBoundedDouble( soundSpriteVolumeMin, 
-                                                  soundSpriteVolumeMax );
-        }
-    else {
-        return 1.0;
-        }
-    }
-
+// bytes of samples resident for sprites loaded from files
+static int soundSpriteResidentBytes = 0;
 
+// counts plays, for finding least recently used sprites
+static unsigned int soundSpritePlayTick = 0;
 
+// sprites with prefetch reads in flight, in order started
+static SimpleVector<SoundSprite*> soundSpritePrefetches;
 
-// no locking
-static void playSoundSpriteInternal( 
-    SoundSpriteHandle inHandle, double inVolumeTweak,
-    double inStereoPosition, 
-    double inForceVolume = -1,
-    double inForceRate = -1 ) {    
 
 
-    if( soundSpritesFading && soundSpriteGlobalLoudness == 0.0f ) {
-        // don't play any new sound sprites
-        return;
+// decodes AIFF data, resampling to soundSampleRate if needed
+// returns NULL on failure
+static Sint16 *decodeSoundSpriteFile( unsigned char *inData, int inNumBytes,
+                                      const char *inFilePath,
+                                      int *outNumSamples ) {
+    int numSamples;
+    int fileRate;
+    int16_t *samples = readMono16AIFFData( inData, inNumBytes, &numSamples,
+                                           &fileRate );
+    
+    if( samples == NULL ) {
+        printf( "Failed to parse AIFF sound file: %s\n", inFilePath );
+        return NULL;
         }
-
-    if( maxSimultaneousSoundSprites != -1 &&
-        playingSoundSpriteVolumesR.size() >= maxSimultaneousSoundSprites ) {
-        // cap would be exceeded
-        // don't play this sound sprite at all
-        return;
+    
+    if( fileRate <= 0 || fileRate == soundSampleRate || numSamples < 2 ) {
+        *outNumSamples = numSamples;
+        return samples;
         }
-
-
-    double volume = inVolumeTweak;
     
-    SoundSprite *s = (SoundSprite*)inHandle;
+    // resample once here (linear), so playback doesn't have to
+    int newNumSamples = 
+        (int)( (double)numSamples * soundSampleRate / fileRate );
     
-
-    if( s->numSamples / soundSampleRate > 5 ) {
-        // a long sound, longer than 5 seconds total
-        // perhaps a bit of music or some other structured sound
-        // instead of an instant "hit" type sound
-        // Don't ever play more than one instance of a longer sound
-        // simultaneously.
-        
-        for( int i=0; i<playingSoundSprites.size(); i++ ) {
-            if( playingSoundSprites.getElement(i)->handle ==
-                s->handle ) {
-                // already playing this sound sprite
-                return;
-                }
-            }
+    if( newNumSamples < 1 ) {
+        newNumSamples = 1;
         }
-    
-
 
-    if( ! s->noVariance ) {
+    Sint16 *resampled = new Sint16[ newNumSamples ];
+    
+    double step = (double)fileRate / soundSampleRate;
+    
+    for( int i=0; i<newNumSamples; i++ ) {
+        double position = i * step;
+        int index = (int)position;
         
-        if( inForceVolume == -1 ) {
-            volume *= pickRandomVolume();
+        if( index >= numSamples - 1 ) {
+            resampled[i] = samples[ numSamples - 1 ];
             }
         else {
-            volume *= inForceVolume;
+            double f = position - index;
+            resampled[i] = (Sint16)lrint( 
+                samples[index] + f * ( samples[index + 1] - samples[index] ) );
             }
         }
     
-
-    
-    
-    
-    
-    // constant power rule
-    double p = M_PI * inStereoPosition * 0.5;
+    delete [] samples;
     
-    double rightVolume = volume * sin( p );
-    double leftVolume = volume * cos( p );
-
-
-    s->samplesPlayed = 0;
-    s->samplesPlayedF = 0;
+    *outNumSamples = newNumSamples;
+    return resampled;
+    }
 
 
 
+// reads and decodes a sprite's file right now
+// returns NULL on failure
+static Sint16 *readSoundSpriteFile( const char *inFilePath, 
+                                    int *outNumSamples ) {
+    int archivedLength;
+    unsigned char *archivedData = readArchivedFile( inFilePath, 
+                                                    &archivedLength );
     
-    playingSoundSprites.push_back( *s );
+    if( archivedData != NULL ) {
+        Sint16 *samples = decodeSoundSpriteFile( archivedData, archivedLength,
+                                                 inFilePath, outNumSamples );
+        delete [] archivedData;
+        
+        return samples;
+        }
 
-    if( s->noVariance ) {
-        playingSoundSpriteRates.push_back( 1.0 );
+    
+    FILE *f = fopen( inFilePath, "rb" );
+    
+    if( f == NULL ) {
+        printf( "Failed to open sound file: %s\n", inFilePath );
+        return NULL;
         }
-    else {
+    
+    fseek( f, 0, SEEK_END );
+    int numBytes = (int)ftell( f );
+    fseek( f, 0, SEEK_SET );
+    
+    unsigned char *data = NULL;
+    
+    if( numBytes > 0 ) {
+        data = new unsigned char[ numBytes ];
         
-        if( inForceRate != -1 ) {
-            playingSoundSpriteRates.push_back( inForceRate );
-            }
-        else { 
-            playingSoundSpriteRates.push_back(  pickRandomRate() );
+        if( (int)fread( data, 1, numBytes, f ) != numBytes ) {
+            delete [] data;
+            data = NULL;
             }
         }
+    fclose( f );
     
+    if( data == NULL ) {
+        printf( "Failed to read sound file: %s\n", inFilePath );
+        return NULL;
+        }
     
+    Sint16 *samples = decodeSoundSpriteFile( data, numBytes, inFilePath,
+                                             outNumSamples );
+    delete [] data;
     
-    playingSoundSpriteVolumesR.push_back( rightVolume );
-    playingSoundSpriteVolumesL.push_back( leftVolume );
-    }
-
-
-// locking
-void playSoundSprite( SoundSpriteHandle inHandle, double inVolumeTweak,
-                      double inStereoPosition ) {
-    
-    lockAudio();
-    playSoundSpriteInternal( inHandle, inVolumeTweak, inStereoPosition );
-    unlockAudio();
+    return samples;
     }
 
 
 
-// multiple with single lock
-void playSoundSprite( int inNumSprites, SoundSpriteHandle *inHandles, 
-                      double *inVolumeTweaks,
-                      double *inStereoPositions ) {
-    lockAudio();
-
-    // one random volume and rate for whole batch
-    double volume = pickRandomVolume();
-    double rate = pickRandomRate();
-
-    for( int i=0; i<inNumSprites; i++ ) {
-        playSoundSpriteInternal( inHandles[i], inVolumeTweaks[i], 
-                                 inStereoPositions[i], volume, rate );
+static char isSoundSpritePlaying( SoundSprite *inSprite ) {
+    for( int i=0; i<playingVoices.numVoices; i++ ) {
+        if( playingVoices.handle[i] == inSprite->handle ) {
+            return true;
+            }
         }
-    unlockAudio();
+    return false;
     }
 
 
 
+struct SoundSpriteLastUsedLess {
+        bool operator()( SoundSprite *inA, SoundSprite *inB ) const {
+            return inA->lastUsedTick < inB->lastUsedTick;
+            }
+    };
 
 
-void freeSoundSprite( SoundSpriteHandle inHandle ) {
-    // make sure this sprite isn't playing
-    lockAudio();
-    
-    SoundSprite *s = (SoundSprite*)inHandle;
 
-    // find it in vector to remove it
-    for( int i=playingSoundSprites.size()-1; i>=0; i-- ) {
-        SoundSprite *s2 = playingSoundSprites.getElement( i );
-        if( s2->handle == s->handle ) {
-            // stop it abruptly
-            playingSoundSprites.deleteElement( i );
-            playingSoundSpriteRates.deleteElement( i );
-            playingSoundSpriteVolumesL.deleteElement( i );
-            playingSoundSpriteVolumesR.deleteElement( i );
+// drops samples of least recently used file sprites, other than
+// inKeep, until resident bytes are within budget
+// sprites that are playing (or about to) are skipped
+static void trimSoundSpriteCache( SoundSprite *inKeep ) {
+    if( soundSpriteMemoryBudget == -1 ||
+        soundSpriteResidentBytes <= soundSpriteMemoryBudget ) {
+        return;
+        }
+    
+    SimpleVector<SoundSprite*> candidates;
+    
+    for( int i=0; i<soundSprites.size(); i++ ) {
+        SoundSprite *s = soundSprites.getElementDirect( i );
+        
+        if( s != inKeep && s->filePath != NULL && s->samples != NULL ) {
+            candidates.push_back( s );
             }
         }
     
-    unlockAudio();
-
+    candidates.sort( SoundSpriteLastUsedLess() );
+    
+    SoundSprite **c = candidates.getElementArray();
+    int numCandidates = candidates.size();
+    
 
-    for( int i=0; i<soundSprites.size(); i++ ) {
-        SoundSprite *s2 = soundSprites.getElementDirect( i );
-        if( s2->handle == s->handle ) {
-            delete [] s2->samples;
-            soundSprites.deleteElement( i );
-            delete s2;
+    // apply queued plays, so they show up as playing voices
+    lockAudio();
+    drainAudioCommands();
+    
+    for( int i=0; i<numCandidates && 
+             soundSpriteResidentBytes > soundSpriteMemoryBudget; i++ ) {
+        SoundSprite *s = c[i];
+        
+        if( isSoundSpritePlaying( s ) ) {
+            continue;
             }
+        
+        soundSpriteResidentBytes -= s->numSamples * (int)sizeof( Sint16 );
+        
+        delete [] s->samples;
+        s->samples = NULL;
+        s->numSamples = 0;
         }
+    
+    unlockAudio();
+    
+    delete [] c;
     }
 
 
 
+// sprite must not have samples yet
+static void adoptSoundSpriteSamples( SoundSprite *inSprite, 
+                                     Sint16 *inSamples, int inNumSamples ) {
+    inSprite->samples = inSamples;
+    inSprite->numSamples = inNumSamples;
+    inSprite->lastUsedTick = soundSpritePlayTick;
 
-void audioCallback( void *inUserData, Uint8 *inStream, int inLengthToFill ) {
-    getSoundSamples( inStream, inLengthToFill );
+    soundSpriteResidentBytes += inNumSamples * (int)sizeof( Sint16 );
     
-    int numSamples = inLengthToFill / 4;
-
-    
-    if( playingSoundSprites.size() > 0 ) {
-        
-        for( int i=0; i<numSamples; i++ ) {
-            soundSpriteMixingBufferL[ i ] = 0.0;
-            soundSpriteMixingBufferR[ i ] = 0.0;
-            }
-
-        for( int i=0; i<playingSoundSprites.size(); i++ ) {
-            SoundSprite *s = playingSoundSprites.getElement( i );
+    trimSoundSpriteCache( inSprite );
+    }
 
-            double rate = playingSoundSpriteRates.getElementDirect( i );
-            double volumeL = playingSoundSpriteVolumesL.getElementDirect( i );
-            double volumeR = playingSoundSpriteVolumesR.getElementDirect( i );
-            
-            int filled = 0;
-            
-            //int filledBytes = 0;
 
-            if( rate == 1 ) {
-                
-                int samplesPlayed = s->samplesPlayed;
-                int spriteNumSamples = s->numSamples;
-                
-                while( filled < numSamples &&
-                       samplesPlayed < spriteNumSamples  ) {
-                    
-                    Sint16 sample = s->samples[ samplesPlayed ];
-                    
-                    soundSpriteMixingBufferL[ filled ] 
-                        += volumeL * sample;
-                    
-                    soundSpriteMixingBufferR[ filled ]
-                        += volumeR * sample;
 
-                    filled ++;
-                    samplesPlayed ++;
-                    }
-                s->samplesPlayed = samplesPlayed;
-                }
-            else {
-                double samplesPlayedF = s->samplesPlayedF;
-                int spriteNumSamples = s->numSamples;
-                
-                while( filled < numSamples &&
-                       samplesPlayedF < spriteNumSamples - 1  ) {
-                    
-                    int aIndex = (int)floor( samplesPlayedF );
-                    int bIndex = (int)ceil( samplesPlayedF );
-                    
-                    Sint16 sampleA = s->samples[ aIndex ];
-                    Sint16 sampleB = s->samples[ bIndex ];
-                    
-                    double bWeight = samplesPlayedF - aIndex;
-                    double aWeight = 1 - bWeight;
+static void forgetSoundSpritePrefetch( SoundSprite *inSprite ) {
+    if( inSprite->prefetchReadHandle == -1 ) {
+        return;
+        }
+    
+    // abandons read if not done
+    int length;
+    unsigned char *data = getAsyncFileData( inSprite->prefetchReadHandle,
+                                            &length );
+    if( data != NULL ) {
+        delete [] data;
+        }
+    inSprite->prefetchReadHandle = -1;
+    
+    soundSpritePrefetches.deleteElementEqualTo( inSprite );
+    }
 
-                    double sampleBlend = sampleA * aWeight + sampleB * bWeight;
 
-                    soundSpriteMixingBufferL[ filled ] 
-                        += volumeL * sampleBlend;
-                    
-                    soundSpriteMixingBufferR[ filled ]
-                        += volumeR * sampleBlend;
 
-                    filled ++;
-                    samplesPlayedF += rate;
-                    }
-                s->samplesPlayedF = samplesPlayedF;
-                }
-            }
+// decodes sprite's samples now if they aren't resident
+// returns false if sprite has no samples
+static char makeSoundSpriteResident( SoundSprite *inSprite ) {
+    if( inSprite->samples != NULL ) {
+        return true;
+        }
+    if( inSprite->filePath == NULL ) {
+        return false;
+        }
+    
+    // don't wait behind other reads in flight, just read it ourselves
+    forgetSoundSpritePrefetch( inSprite );
+    
+    int numSamples;
+    Sint16 *samples = readSoundSpriteFile( inSprite->filePath, &numSamples );
+    
+    if( samples == NULL ) {
+        // don't try again on every play
+        delete [] inSprite->filePath;
+        inSprite->filePath = NULL;
+        return false;
+        }
+    
+    adoptSoundSpriteSamples( inSprite, samples, numSamples );
+    return true;
+    }
 
 
-        // respect their collective volume cap
-        audioNoClip( &soundSpriteNoClip,
-                     soundSpriteMixingBufferL, soundSpriteMixingBufferR,
-                     numSamples );
 
-        // and normalize to compensate for any compression below that cap
-        if( totalSoundSpriteNormalizeFactor != 1.0 ) {
-            for( int i=0; i<numSamples; i++ ) {
-                soundSpriteMixingBufferL[i] *= totalSoundSpriteNormalizeFactor;
-                soundSpriteMixingBufferR[i] *= totalSoundSpriteNormalizeFactor;
-                }
+// decodes sprites whose prefetch reads have finished
+static void stepSoundSpritePrefetches() {
+    while( soundSpritePrefetches.size() > 0 ) {
+        SoundSprite *s = soundSpritePrefetches.getElementDirect( 0 );
+        
+        // reads are reported done in the order they were started
+        if( ! checkAsyncFileReadDone( s->prefetchReadHandle ) ) {
+            return;
             }
         
+        int numBytes;
+        unsigned char *data = getAsyncFileData( s->prefetchReadHandle,
+                                                &numBytes );
+        s->prefetchReadHandle = -1;
+        soundSpritePrefetches.deleteElement( 0 );
 
-        // now mix them in
-        int filledBytes = 0;
+        if( data == NULL ) {
+            // leave it to be read when played
+            continue;
+            }
         
-
-        // next, do final mix, then
-        //  apply global no-clip, for mix of sound sprites and
-        // music or other sounds created by getSoundSamples
+        int numSamples;
+        Sint16 *samples = decodeSoundSpriteFile( data, numBytes, 
+                                                 s->filePath, &numSamples );
+        delete [] data;
         
-        for( int i=0; i<numSamples; i++ ) {
-            Sint16 lSample = 
-                (Sint16)( (inStream[filledBytes+1] << 8) | 
-                          inStream[filledBytes] );
-            Sint16 rSample = 
-                (Sint16)( (inStream[filledBytes+3] << 8) | 
-                          inStream[filledBytes+2] );
-            
-            filledBytes += 4;
-            
-            // apply global loudness to sound sprites as part of this mx
-            soundSpriteMixingBufferL[i] *= soundSpriteGlobalLoudness;
-            soundSpriteMixingBufferR[i] *= soundSpriteGlobalLoudness;
-            
-            if( soundSpritesFading ) {
-                soundSpriteGlobalLoudness -= soundSpriteFadeIncrementPerSample;
-                
-                if( soundSpriteGlobalLoudness < 0.0f ) {
-                    soundSpriteGlobalLoudness = 0.0f;
-                    }
-                }
+        if( samples != NULL ) {
+            adoptSoundSpriteSamples( s, samples, numSamples );
+            }
+        }
+    }
 
 
-            soundSpriteMixingBufferL[i] += lSample;
-            soundSpriteMixingBufferR[i] += rSample;
-            }
 
+void setSoundSpriteMemoryBudget( int inMaxBytes ) {
+    soundSpriteMemoryBudget = inMaxBytes;
+    
+    trimSoundSpriteCache( NULL );
+    }
 
-        
-        // we have our final mix, make sure it never clips
-        audioNoClip( &totalAudioMixNoClip,
-                     soundSpriteMixingBufferL, soundSpriteMixingBufferR,
-                     numSamples );
 
-        
-        // now convert back to integers
-        filledBytes = 0;
-        for( int i=0; i<numSamples; i++ ) {
-            Sint16 lSample = lrint( soundSpriteMixingBufferL[i] );
-            Sint16 rSample = lrint( soundSpriteMixingBufferR[i] );
 
+int getSoundSpriteResidentBytes() {
+    return soundSpriteResidentBytes;
+    }
 
-            inStream[filledBytes++] = (Uint8)( lSample & 0xFF );
-            inStream[filledBytes++] = 
-                (Uint8)( ( lSample >> 8 ) & 0xFF );
-            inStream[filledBytes++] = (Uint8)( rSample & 0xFF );
-            inStream[filledBytes++] = 
-                (Uint8)( ( rSample >> 8 ) & 0xFF );
-            }
 
-        // walk backward, removing any that are done
-        // OR remove all if sound sprites are completely faded out
-        for( int i=playingSoundSprites.size()-1; i>=0; i-- ) {
-            SoundSprite *s = playingSoundSprites.getElement( i );
-            
-            if( soundSpriteGlobalLoudness == 0 ||
-                s->samplesPlayed >= s->numSamples ||
-                s->samplesPlayedF >= s->numSamples - 1 ) {
-                
-                playingSoundSprites.deleteElement( i );
-                playingSoundSpriteRates.deleteElement( i );
-                playingSoundSpriteVolumesL.deleteElement( i );
-                playingSoundSpriteVolumesR.deleteElement( i );
-                }
-            }
+
+void prefetchSoundSprite( SoundSpriteHandle inHandle ) {
+    SoundSprite *s = (SoundSprite*)inHandle;
+    
+    if( s->samples != NULL || s->filePath == NULL ||
+        s->prefetchReadHandle != -1 ) {
+        return;
         }
     
-    // now apply global loudness fade for pause
-    if( ( currentSoundLoudness != soundLoudness && ! sceneHandler->mPaused ) 
-        ||
-        ( currentSoundLoudness != 0.0f && sceneHandler->mPaused ) 
-        ||
-        currentSoundLoudness != 1.0f ) {
-        
-        
-        int nextByte = 0;
-        for( int i=0; i<numSamples; i++ ) {
-            Sint16 lSample = 
-                inStream[nextByte] | 
-                ( inStream[nextByte + 1] << 8 );
-            
-            Sint16 rSample = 
-                inStream[nextByte + 2] | 
-                ( inStream[nextByte + 3] << 8 );
-            
-            lSample = (Sint16)( lSample * currentSoundLoudness );
-            rSample = (Sint16)( rSample * currentSoundLoudness );
-            
+    s->prefetchReadHandle = startAsyncFileRead( s->filePath );
+    soundSpritePrefetches.push_back( s );
+    }
 
-            inStream[nextByte++] = (Uint8)( lSample & 0xFF );
-            inStream[nextByte++] = (Uint8)( ( lSample >> 8 ) & 0xFF );
-            inStream[nextByte++] = (Uint8)( rSample & 0xFF );
-            inStream[nextByte++] = (Uint8)( ( rSample >> 8 ) & 0xFF );
-            
-            if( currentSoundLoudness != soundLoudness && 
-                ! sceneHandler->mPaused ) {
-                currentSoundLoudness += soundLoudnessIncrementPerSample;
-                
-                if( currentSoundLoudness > soundLoudness ) {
-                    currentSoundLoudness = soundLoudness;
-                    }
-                }
-            else if( currentSoundLoudness != 0 && 
-                     sceneHandler->mPaused ) {
-                
-                currentSoundLoudness -= soundLoudnessIncrementPerSample;
-                
-                if( currentSoundLoudness < 0 ) {
-                    currentSoundLoudness = 0;
-                    }
-                }
-            
-            }
-        }
+
+
+static SoundSprite *newSoundSprite() {
+    SoundSprite *s = new( soundSpritePool.allocate() ) SoundSprite;
     
+    s->handle = nextSoundSpriteHandle ++;
+    s->numSamples = 0;
+    s->noVariance = false;
+    s->samples = NULL;
+    s->filePath = NULL;
+    s->prefetchReadHandle = -1;
+    s->lastUsedTick = soundSpritePlayTick;
     
-    if( recordAudio ) {    
-        
-        
-        if( numSamples > samplesLeftToRecord ) {
-            numSamples = samplesLeftToRecord;
-            }
+    soundSprites.push_back( s );
+    
+    return s;
+    }
 
-        // reverse byte order
-        int nextByte = 0;
-        for( int i=0; i<numSamples; i++ ) {
-                    
-            fwrite( &( inStream[ nextByte + 1 ] ), 1, 1, aiffOutFile );
-            fwrite( &( inStream[ nextByte ] ), 1, 1, aiffOutFile );
+
+
+SoundSpriteHandle loadSoundSprite( const char *inFolderName,
+                                   const char *inAIFFFileName ) {
     
-            fwrite( &( inStream[ nextByte + 3 ] ), 1, 1, aiffOutFile );
-            fwrite( &( inStream[ nextByte + 2 ] ), 1, 1, aiffOutFile );
-            nextByte += 4;
-            }
-        
+    File aiffFile( new Path( inFolderName ), inAIFFFileName );
 
-        samplesLeftToRecord -= numSamples;
+    char *filePath = aiffFile.getFullFileName();
+    
+    if( ( resourceArchive.archive == NULL ||
+          ! resourceArchive.archive->hasEntry( filePath ) ) &&
+        ! aiffFile.exists() ) {
+        printf( "File does not exist in sounds folder: %s\n", 
+                inAIFFFileName );
+        delete [] filePath;
+        return NULL;
+        }
+    
+    if( soundSpriteMemoryBudget != -1 ) {
+        // decoded when first played or prefetched
+        SoundSprite *s = newSoundSprite();
+        s->filePath = filePath;
         
+        return (SoundSpriteHandle)s;
+        }
     
-        if( samplesLeftToRecord <= 0 ) {
-            recordAudio = false;
-            fclose( aiffOutFile );
-            aiffOutFile = NULL;
-            }            
+
+    int numSamples;
+    Sint16 *samples = readSoundSpriteFile( filePath, &numSamples );
+    
+    if( samples == NULL ) {
+        delete [] filePath;
+        return NULL;
         }
     
+    SoundSprite *s = newSoundSprite();
+    s->filePath = filePath;
+
+    adoptSoundSpriteSamples( s, samples, numSamples );
+    
+    return (SoundSpriteHandle)s;
     }
 
 
-int getSampleRate() {
-    return soundSampleRate;
-    }
 
+SoundSpriteHandle setSoundSprite( int16_t *inSamples, int inNumSamples ) {
+    SoundSprite *s = newSoundSprite();
+    
+    s->numSamples = inNumSamples;
 
-void setSoundPlaying( char inPlaying ) {
-    SDL_PauseAudio( !inPlaying );
+    s->samples = new Sint16[ s->numSamples ];
+    
+    memcpy( s->samples, inSamples, inNumSamples * sizeof( int16_t ) );
+    
+    return (SoundSpriteHandle)s;
     }
 
 
 
-void lockAudio() {
-    SDL_LockAudio();
+void toggleVariance( SoundSpriteHandle inHandle, char inNoVariance ) {
+    SoundSprite *s = (SoundSprite*)inHandle;
+    s->noVariance = inNoVariance;
     }
 
 
 
-void unlockAudio() {
-    SDL_UnlockAudio();
-    }
 
+static double maxTotalSoundSpriteVolume = 1.0;
 
+static double soundSpriteCompressionFraction = 0.0;
 
-char isSoundRunning() {
-    return soundRunning;
-    }
+static double totalSoundSpriteNormalizeFactor = 1.0;
 
+static NoClip soundSpriteNoClip;
 
+static NoClip totalAudioMixNoClip;
 
-void handleTooWide() {
-    if( isNonIntegerScalingAllowed() ) {
-        
-        double screenRatio = (double)screenWidth / (double)screenHeight;
-        double gameRatio = (double)gameWidth / (double)gameHeight;
-        
-        if( screenRatio > gameRatio ) {
-            // screen too wide
+// same, for float final mix
+static NoClip totalAudioMixNoClipFloat;
+                                                   
 
-            // tell game about this by making game image wider than requested}
-            
-            int newGameWidth = (int)( screenRatio * gameHeight );
-            
-            AppLog::infoF( 
-                "Screen has wider aspect ratio than desired game image, " 
-                "fixing by making game image wider (old %dx%d, new %dx%d)",
-                gameWidth, gameHeight, newGameWidth, gameHeight );
+void setMaxTotalSoundSpriteVolume( double inMaxTotal, 
+                                   double inCompressionFraction ) {
+    lockAudio();
 
-            gameWidth = newGameWidth;
+    maxTotalSoundSpriteVolume = inMaxTotal;
+    soundSpriteCompressionFraction = inCompressionFraction;
 
-            // if screen too narrow, this is already handled elsewhere
-            }
-        }
+    totalSoundSpriteNormalizeFactor = 
+        1.0 / ( 1.0 - soundSpriteCompressionFraction );
+    
+    soundSpriteNoClip =
+        resetAudioNoClip( ( 1.0 - soundSpriteCompressionFraction ) *
+                          maxTotalSoundSpriteVolume * 32767, 
+                          // half second hold and release
+                          soundSampleRate / 2, soundSampleRate / 2 );
+    
+    unlockAudio();
     }
 
 
+void setMaxSimultaneousSoundSprites( int inMaxCount ) {
+    // grow table up front, so we never allocate while playing up to the cap
+    lockAudio();
+    setVoiceTableCapacity( &playingVoices, inMaxCount );
+    maxSimultaneousSoundSprites = inMaxCount;
+    unlockAudio();
+    }
 
-#ifdef __mac__
 
-#include <unistd.h>
-#include <stdarg.h>
 
 
-// returns path to folder
-static char *pickFolder( const char *inPrompt ) {
-    
-    const char *commandFormat = 
-        "osascript -e 'tell application \"Finder\" to activate' "
-        "-e 'tell app \"Finder\" to return POSIX path of "
-        "(choose folder with prompt \"%s\")'";
+static double pickRandomRate() {
+    if( soundSpriteRateMax != 1.0 ||
+        soundSpriteRateMin != 1.0 ) { 
+        
+        return randSource.getRandomBoundedDouble( soundSpriteRateMin, 
+                                                  soundSpriteRateMax );
+        }
+    else {
+        return 1.0;
+        }
+    }
 
-    char *command = autoSprintf( commandFormat, inPrompt );
 
-    printf( "Running osascript command:\n\n%s\n\n", command );
-    
-    FILE *osascriptPipe = popen( command, "r" );
+
+static double pickRandomVolume() {
+    if( soundSpriteVolumeMax != 1.0 ||
+        soundSpriteVolumeMin != 1.0 ) { 
+        
+        return randSource.getRandomBoundedDouble( soundSpriteVolumeMin, 
+                                                  soundSpriteVolumeMax );
+        }
+    else {
+        return 1.0;
+        }
+    }
+
+
+
+
+// no locking, pushes command to audio thread
+static void playSoundSpriteInternal( 
+    SoundSpriteHandle inHandle, double inVolumeTweak,
+    double inStereoPosition, 
+    double inForceVolume = -1,
+    double inForceRate = -1 ) {    
+
+    // fading and simultaneous-sprite caps are checked on the audio thread,
+    // when the command is applied
+
+    double volume = inVolumeTweak;
     
-    delete [] command;
+    SoundSprite *s = (SoundSprite*)inHandle;
     
-    if( osascriptPipe == NULL ) {
-        AppLog::error( 
-            "Failed to open pipe to osascript for picking a folder." );
+    if( ! makeSoundSpriteResident( s ) ) {
+        return;
         }
-    else {
-        char buffer[200];
-        
-        int numRead = fscanf( osascriptPipe, "%199s", buffer );
+    
+    soundSpritePlayTick ++;
+    s->lastUsedTick = soundSpritePlayTick;
+
+
+    if( ! s->noVariance ) {
         
-        if( numRead == 1 ) {
-            return stringDuplicate( buffer );
+        if( inForceVolume == -1 ) {
+            volume *= pickRandomVolume();
+            }
+        else {
+            volume *= inForceVolume;
             }
+        }
+    
+
+    
+    
+    
+    
+    // constant power rule
+    double p = M_PI * inStereoPosition * 0.5;
+    
+    double rightVolume = volume * sin( p );
+    double leftVolume = volume * cos( p );
+
+
+    double rate = 1.0;
+    
+    if( ! s->noVariance ) {
         
-        pclose( osascriptPipe );
+        if( inForceRate != -1 ) {
+            rate = inForceRate;
+            }
+        else { 
+            rate = pickRandomRate();
+            }
         }
-    return NULL;
+    
+    AudioCommand c = makeAudioCommand( audioCommandPlay );
+    c.sprite = s;
+    c.rate = rate;
+    c.volumeL = leftVolume;
+    c.volumeR = rightVolume;
+    
+    pushAudioCommand( c );
+    }
+
+
+// lock-free
+void playSoundSprite( SoundSpriteHandle inHandle, double inVolumeTweak,
+                      double inStereoPosition ) {
+    
+    playSoundSpriteInternal( inHandle, inVolumeTweak, inStereoPosition );
     }
 
 
 
-static void showMessage( const char *inAppName,
-                         const char *inTitle, const char *inMessage,
-                         char inError = false ) {
-    const char *iconName = "note";
-    if( inError ) {
-        // stop icon is broken in OS 10.12
-        // always use note
-        // iconName = "stop";
+// multiple, all with same variance
+void playSoundSprite( int inNumSprites, SoundSpriteHandle *inHandles, 
+                      double *inVolumeTweaks,
+                      double *inStereoPositions ) {
+
+    // one random volume and rate for whole batch
+    double volume = pickRandomVolume();
+    double rate = pickRandomRate();
+
+    for( int i=0; i<inNumSprites; i++ ) {
+        playSoundSpriteInternal( inHandles[i], inVolumeTweaks[i], 
+                                 inStereoPositions[i], volume, rate );
         }
+    }
 
-    const char *commandFormat =
-        "osascript -e 'tell app \"Finder\" to activate' "
-        "-e 'tell app \"Finder\" to display dialog \"%s\" "
-        "with title \"%s:  %s\" buttons \"Ok\" "
-        "with icon %s default button \"Ok\"' ";
+
+
+
+
+void freeSoundSprite( SoundSpriteHandle inHandle ) {
+    SoundSprite *s = (SoundSprite*)inHandle;
+
+    // make sure this sprite isn't playing, and that no queued play command
+    // still points to it, before we destroy its samples
+    AudioCommand c = makeAudioCommand( audioCommandStop );
+    c.sprite = s;
     
-    char *command = autoSprintf( commandFormat, inMessage, inAppName, inTitle, 
-                                 iconName );
+    lockAudio();
+    drainAudioCommands();
+    applyAudioCommand( &c );
+    unlockAudio();
 
-    printf( "Running osascript command:\n\n%s\n\n", command );
+
+    forgetSoundSpritePrefetch( s );
+
+    for( int i=0; i<soundSprites.size(); i++ ) {
+        SoundSprite *s2 = soundSprites.getElementDirect( i );
+        if( s2->handle == s->handle ) {
+            if( s2->samples != NULL ) {
+                if( s2->filePath != NULL ) {
+                    soundSpriteResidentBytes -= 
+                        s2->numSamples * (int)sizeof( Sint16 );
+                    }
+                delete [] s2->samples;
+                }
+            if( s2->filePath != NULL ) {
+                delete [] s2->filePath;
+                }
+            soundSprites.deleteElement( i );
+            soundSpritePool.destroy( s2 );
+            }
+        }
+    }
+
+
+
+SoundStreamHandle openSoundStream( const char *inFolderName,
+                                   const char *inAIFFFileName,
+                                   char inLoop ) {
     
-    FILE *osascriptPipe = popen( command, "r" );
+    File aiffFile( new Path( inFolderName ), inAIFFFileName );
     
-    delete [] command;
+    char *filePath = aiffFile.getFullFileName();
     
-    if( osascriptPipe == NULL ) {
-        AppLog::error( 
-            "Failed to open pipe to osascript for displaying GUI messages." );
+    SoundStream *stream = new SoundStream( filePath, inLoop );
+    
+    delete [] filePath;
+    
+    if( ! stream->isOpen() ) {
+        delete stream;
+        return NULL;
         }
-    else {
-        pclose( osascriptPipe );
+    
+    if( stream->getSampleRate() != soundSampleRate ) {
+        AppLog::warningF( "Sound stream %s has sample rate %d, not %d, "
+                          "and will play at the wrong pitch",
+                          inAIFFFileName, stream->getSampleRate(),
+                          soundSampleRate );
         }
+    
+    if( soundStreamReader == NULL ) {
+        soundStreamReader = new SoundStreamReader();
+        }
+    
+    soundStreamReader->addStream( stream );
+    
+    SoundStreamRecord *r = new SoundStreamRecord;
+    r->stream = stream;
+    r->playing = false;
+    
+    soundStreamRecords.push_back( r );
+    
+    return (SoundStreamHandle)r;
     }
 
 
-static char *getPrefFilePath() {
-    return autoSprintf( "%s/Library/Preferences/%s_prefs.txt",
-                        getenv( "HOME" ),
-                        getAppName() );
-    }
 
+// returns once audio thread is no longer mixing stream
+static void stopSoundStreamNow( SoundStreamRecord *inRecord ) {
+    AudioCommand c = makeAudioCommand( audioCommandStopStream );
+    c.stream = inRecord->stream;
+    
+    lockAudio();
+    drainAudioCommands();
+    applyAudioCommand( &c );
+    unlockAudio();
+    
+    inRecord->playing = false;
+    }
 
-static char isSettingsFolderFound() {
 
-    File settingsFolder( NULL, "settings" );
-     
-    if( settingsFolder.exists() && settingsFolder.isDirectory() ) {
-        return true;
-        }
 
-    return false;
+void playSoundStream( SoundStreamHandle inHandle, double inVolume,
+                      double inStereoPosition ) {
+    SoundStreamRecord *r = (SoundStreamRecord*)inHandle;
+    
+    stopSoundStreamNow( r );
+    
+    // start of track ready to mix before play command is sent
+    soundStreamReader->rewindStream( r->stream );
+    
+    // constant power rule
+    double p = M_PI * inStereoPosition * 0.5;
+    
+    AudioCommand c = makeAudioCommand( audioCommandPlayStream );
+    c.stream = r->stream;
+    c.volumeL = inVolume * cos( p );
+    c.volumeR = inVolume * sin( p );
+    
+    r->playing = true;
+    
+    pushAudioCommand( c );
     }
 
 
-#endif
 
+void stopSoundStream( SoundStreamHandle inHandle ) {
+    stopSoundStreamNow( (SoundStreamRecord*)inHandle );
+    }
 
 
-#ifdef WIN32
 
-#include <windows.h>
-#include <tchar.h>
+char isSoundStreamPlaying( SoundStreamHandle inHandle ) {
+    SoundStreamRecord *r = (SoundStreamRecord*)inHandle;
+    
+    return r->playing && ! r->stream->isFinished();
+    }
 
-#endif
+
+
+void closeSoundStream( SoundStreamHandle inHandle ) {
+    SoundStreamRecord *r = (SoundStreamRecord*)inHandle;
+    
+    stopSoundStreamNow( r );
+    
+    soundStreamReader->removeStream( r->stream );
+    
+    delete r->stream;
+    
+    soundStreamRecords.deleteElementEqualTo( r );
+    delete r;
+    }
 
 
 
-int mainFunction( int inNumArgs, char **inArgs ) {
 
-#ifdef WIN32
+// for stats overlay
+// read by audio thread, which can miss a toggle for a callback or two
+static volatile char statsOverlayShowing = false;
 
+// audio thread only writes these
+// microseconds, of latest callback and of slowest since the main thread
+// last took it
+static volatile int audioCallbackMicros = 0;
+static volatile int audioCallbackMaxMicros = 0;
 
-    HMODULE hShcore = LoadLibrary( _T( "shcore.dll" ) );
 
-    if( hShcore != NULL ) {
-        printf( "shcore.dll loaded successfully\n" );
+// times audioCallback while stats overlay showing
+class AudioCallbackTimer {
+    public:
         
-        typedef enum _PROCESS_DPI_AWARENESS { 
-            PROCESS_DPI_UNAWARE            = 0,
-            PROCESS_SYSTEM_DPI_AWARE       = 1,
-            PROCESS_PER_MONITOR_DPI_AWARE  = 2
-            } PROCESS_DPI_AWARENESS;
+        AudioCallbackTimer()
+                : mStartTime( -1 ) {
+            if( statsOverlayShowing ) {
+                mStartTime = Time::getCurrentTime();
+                }
+            }
         
-        typedef HRESULT (WINAPI *SetProcessDpiAwarenessFunc)( PROCESS_DPI_AWARENESS );
+        ~AudioCallbackTimer() {
+            if( mStartTime != -1 ) {
+                int micros = 
+                    (int)( 1000000 * ( Time::getCurrentTime() - mStartTime ) );
+                
+                audioCallbackMicros = micros;
+                
+                // main thread may reset max in between, in which case
+                // this callback is only counted in the next one's max
+                if( micros > audioCallbackMaxMicros ) {
+                    audioCallbackMaxMicros = micros;
+                    }
+                }
+            }
         
-        SetProcessDpiAwarenessFunc setAwareness = 
-            (SetProcessDpiAwarenessFunc)GetProcAddress(
-                hShcore, 
-                "SetProcessDpiAwareness" );
+    protected:
+        double mStartTime;
+    };
+
+
+
+// next step of pause and setSoundLoudness fade, for one sample
+static inline void stepSoundLoudness() {
+    if( currentSoundLoudness != soundLoudness && 
+        ! sceneHandler->mPaused ) {
+        currentSoundLoudness += soundLoudnessIncrementPerSample;
         
-        if( setAwareness ) {
-            printf( "Found SetProcessDpiAwareness function in shcore.dll\n" );
-            setAwareness( PROCESS_PER_MONITOR_DPI_AWARE );
+        if( currentSoundLoudness > soundLoudness ) {
+            currentSoundLoudness = soundLoudness;
             }
-        else {
-            printf( "Could NOT find SetProcessDpiAwareness function in "
-                    "Shcore.dll\n" );
+        }
+    else if( currentSoundLoudness != 0 && 
+             sceneHandler->mPaused ) {
+        
+        currentSoundLoudness -= soundLoudnessIncrementPerSample;
+        
+        if( currentSoundLoudness < 0 ) {
+            currentSoundLoudness = 0;
             }
-        FreeLibrary( hShcore );
         }
-    else {
-        printf( "shcore.dll NOT loaded successfully... pre Win 8.1 ?\n" );
+    }
 
 
-        printf( "   Trying to load user32.dll instead\n" );
-        
 
-        // backwards compatible code
-        // on vista and higher, this will tell Windows that we are DPI aware
-        // and that we should not be artificially scaled.
-        //
-        // Found here:  http://www.rw-designer.com/DPI-aware
-        HMODULE hUser32 = LoadLibrary( _T( "user32.dll" ) );
+static char isSoundLoudnessScaling() {
+    return 
+        ( currentSoundLoudness != soundLoudness && ! sceneHandler->mPaused ) 
+        ||
+        ( currentSoundLoudness != 0.0f && sceneHandler->mPaused ) 
+        ||
+        currentSoundLoudness != 1.0f;
+    }
+
+
+
+// mixes playing sound sprites and streams into sound sprite mixing
+// buffers, in 16-bit sample scale, with their volume cap applied
+static void mixSoundSprites( int inNumSamples ) {
+    memset( soundSpriteMixingBufferL, 0, inNumSamples * sizeof( float ) );
+    memset( soundSpriteMixingBufferR, 0, inNumSamples * sizeof( float ) );
+
+    for( int i=0; i<playingVoices.numVoices; i++ ) {
+        uint64_t step = playingVoices.phaseStep[i];
         
-        if( hUser32 != NULL ) {
+        if( step == SOUND_SPRITE_PHASE_ONE ) {
+            int samplesPlayed = 
+                getSoundSpritePhaseIndex( playingVoices.phase[i] );
             
-            typedef BOOL (WINAPI *SetProcessDPIAwareFunc)();
+            mixSoundSpriteSamples( playingVoices.samples[i], 
+                                   playingVoices.numSamples[i],
+                                   &samplesPlayed,
+                                   playingVoices.volumeL[i], 
+                                   playingVoices.volumeR[i],
+                                   soundSpriteMixingBufferL,
+                                   soundSpriteMixingBufferR,
+                                   inNumSamples );
             
-            SetProcessDPIAwareFunc setDPIAware = 
-                (SetProcessDPIAwareFunc)GetProcAddress( hUser32, 
-                                                        "SetProcessDPIAware" );
-            if( setDPIAware ) {
-                printf( "Found SetProcessDPIAware function in user32.dll\n" );
-                setDPIAware();
-                }
-            else {
-                printf( "Could NOT find SetProcessDPIAware function in "
-                        "user32.dll\n" );
-                }
-            FreeLibrary( hUser32 );
+            playingVoices.phase[i] = 
+                (uint64_t)samplesPlayed << SOUND_SPRITE_PHASE_BITS;
             }
         else {
-            printf( "Failed to load user32.dll\n" );
+            // fixed-point phase accumulator, no floor/ceil per sample
+            mixSoundSpriteSamplesResampled( 
+                playingVoices.samples[i], 
+                playingVoices.numSamples[i],
+                &( playingVoices.phase[i] ),
+                step,
+                playingVoices.volumeL[i], 
+                playingVoices.volumeR[i],
+                soundSpriteMixingBufferL,
+                soundSpriteMixingBufferR,
+                inNumSamples );
             }
         }
-#endif
+    
+    // streams that fall behind are quiet until they catch up
+    for( int i=0; i<numStreamVoices; i++ ) {
+        StreamVoice *v = &( streamVoices[i] );
+        
+        v->stream->mix( v->volumeL, v->volumeR,
+                        soundSpriteMixingBufferL,
+                        soundSpriteMixingBufferR,
+                        inNumSamples );
+        }
 
 
-    // check result below, after opening log, so we can log failure
-    Uint32 flags = SDL_INIT_VIDEO | SDL_INIT_NOPARACHUTE;
-    if( getUsesSound() ) {
-        flags |= SDL_INIT_AUDIO;
+    // respect their collective volume cap
+    audioNoClipBlock( &soundSpriteNoClip,
+                      soundSpriteMixingBufferL, soundSpriteMixingBufferR,
+                      inNumSamples );
+
+    // and normalize to compensate for any compression below that cap
+    if( totalSoundSpriteNormalizeFactor != 1.0 ) {
+        scaleSoundSpriteMix( soundSpriteMixingBufferL, 
+                             soundSpriteMixingBufferR,
+                             inNumSamples, 
+                             (float)totalSoundSpriteNormalizeFactor );
         }
-    
-    int sdlResult = SDL_Init( flags );
-    AppLog::setLog( new FileLog( "log.txt" ) );
-    AppLog::setLoggingLevel( Log::DETAIL_LEVEL );
+    }
 
 
-    // do this mac check after initing SDL,
-    // since it causes various Mac frameworks to be loaded (which can
-    // change the current working directory out from under us)
-    #ifdef __mac__
-        // make sure working directory is the same as the directory
-        // that the app resides in
-        // this is especially important on the mac platform, which
-        // doesn't set a proper working directory for double-clicked
-        // app bundles
 
-        // arg 0 is the path to the app executable
-        char *appDirectoryPath = stringDuplicate( inArgs[0] );
+// walk backward, removing any that are done
+// OR remove all if sound sprites are completely faded out
+// (swap-remove pulls in voices from the end, which we've already
+//  checked)
+static void removeFinishedSoundSprites() {
+    if( soundSpriteGlobalLoudness == 0 ) {
+        playingVoices.numVoices = 0;
+        numStreamVoices = 0;
+        }
     
-        char *bundleName = autoSprintf( "%s_v%d.app", 
-                                        getAppName(), getAppVersion() );
-
-        char *appNamePointer = strstr( appDirectoryPath, bundleName );
-        AppLog::info( appDirectoryPath );
-        AppLog::info( bundleName );
+    for( int i=playingVoices.numVoices-1; i>=0; i-- ) {
+        if( isVoiceDone( &playingVoices, i ) ) {
+            removeVoice( &playingVoices, i );
+            }
+        }
 
-        if( appNamePointer != NULL ) {
-            // terminate full app path to get parent directory
-            appNamePointer[0] = '\0';
-            AppLog::info( "chdir" );
-            chdir( appDirectoryPath );
+    for( int i=numStreamVoices-1; i>=0; i-- ) {
+        if( streamVoices[i].stream->isFinished() ) {
+            streamVoices[i] = streamVoices[ numStreamVoices - 1 ];
+            numStreamVoices--;
             }
-        AppLog::info( appDirectoryPath );
-                
+        }
+    }
+
+
+
+// game's float samples and sound sprites share one float mix, which
+// is converted to the device's format once, at the end
+static void audioCallbackFloat( Uint8 *inStream, int inNumSamples ) {
+    float *mixL = soundMixingBufferL;
+    float *mixR = soundMixingBufferR;
+    
+    getSoundSamplesFloatFunction( mixL, mixR, inNumSamples );
+    
+    if( playingVoices.numVoices > 0 || numStreamVoices > 0 ) {
         
-        if( ! isSettingsFolderFound() ) {
-            // first, try setting dir based on preferences file
-            char *prefFilePath = getPrefFilePath();
+        mixSoundSprites( inNumSamples );
         
-            FILE *prefFile = fopen( prefFilePath, "r" );
+        for( int i=0; i<inNumSamples; i++ ) {
+            // sprites are mixed in 16-bit scale
+            float spriteGain = soundSpriteGlobalLoudness / 32767.0f;
             
-            if( prefFile != NULL ) {
-
-                char path[200];
-                
-                int numRead = fscanf( prefFile, "%199s", path );
+            mixL[i] += soundSpriteMixingBufferL[i] * spriteGain;
+            mixR[i] += soundSpriteMixingBufferR[i] * spriteGain;
+            
+            if( soundSpritesFading ) {
+                soundSpriteGlobalLoudness -= soundSpriteFadeIncrementPerSample;
                 
-                if( numRead == 1 ) {
-                    chdir( path );
+                if( soundSpriteGlobalLoudness < 0.0f ) {
+                    soundSpriteGlobalLoudness = 0.0f;
                     }
-                fclose( prefFile );
                 }
-            
-            delete [] prefFilePath;
             }
-        
 
-        if( ! isSettingsFolderFound() ) {
-            
-            showMessage( getAppName(), "First Start Up Error",
-                         "Cannot find game data.\n\n"
-                         "Newer versions of MacOS have strict sandboxing, "
-                         "so we have to work around this issue by asking "
-                         "you a question.\n\n"
-                         //"There will also be some info presented along the "
-                         //"way for debugging purposes.\n\n"
-                         "Hopefully, you will only have to do this once.", 
-                         true );
-            
+        removeFinishedSoundSprites();
+        }
+    
+    // global loudness fade for pause
+    if( isSoundLoudnessScaling() ) {
+        for( int i=0; i<inNumSamples; i++ ) {
+            mixL[i] *= currentSoundLoudness;
+            mixR[i] *= currentSoundLoudness;
             
-            //showMessage( getAppName(), "Debug Info, Executable path =",
-            //             inArgs[0], false );
+            stepSoundLoudness();
+            }
+        }
+    
+    // make sure final mix never clips, while converting
+    if( soundOutputFloat ) {
+        audioNoClipBlockToF32( &totalAudioMixNoClipFloat,
+                               mixL, mixR, (float *)inStream, 
+                               inNumSamples );
+        }
+    else {
+        audioNoClipBlockToS16LE( &totalAudioMixNoClipFloat,
+                                 mixL, mixR, inStream, 
+                                 inNumSamples, 32767.0f );
+        }
+    }
 
 
-            //showMessage( getAppName(), "Debug Info, Home dir =", 
-            //             getenv( "HOME" ), false );
-            
 
-            showMessage( getAppName(), "First Start Up",
-                         "Please locate the game folder "
-                         "in the next dialog box.",
-                         false );
-            
-            char *prompt = autoSprintf( 
-                "Find the game folder (where the %s App is located):",
-                getAppName() );
-            
-            char *path = pickFolder( prompt );
+void audioCallback( void *inUserData, Uint8 *inStream, int inLengthToFill ) {
+    PROFILE_ZONE( "audioCallback" );
+    AudioCallbackTimer timer;
 
-            delete [] prompt;
-            
-            if( path != NULL ) {
-                //showMessage( getAppName(), "Debug Info, Chosen path =",
-                //             path, false );
+    drainAudioCommands();
+    
+    if( getSoundSamplesFloatFunction != NULL ) {
+        int numFloatSamples = inLengthToFill / 4;
+        
+        if( soundOutputFloat ) {
+            numFloatSamples = inLengthToFill / 8;
+            }
+        
+        audioCallbackFloat( inStream, numFloatSamples );
+        }
+    else {
+        getSoundSamples( inStream, inLengthToFill );
+        }
+    
+    int numSamples = inLengthToFill / 4;
+
+    
+    if( getSoundSamplesFloatFunction == NULL &&
+        ( playingVoices.numVoices > 0 || numStreamVoices > 0 ) ) {
+        
+        mixSoundSprites( numSamples );
+        
 
+        // now mix them in
+        int filledBytes = 0;
+        
 
-                char *prefFilePath = getPrefFilePath();
-                
-                FILE *prefFile = fopen( prefFilePath, "w" );
+        // next, do final mix, then
+        //  apply global no-clip, for mix of sound sprites and
+        // music or other sounds created by getSoundSamples
+        
+        for( int i=0; i<numSamples; i++ ) {
+            Sint16 lSample = 
+                (Sint16)( (inStream[filledBytes+1] << 8) | 
+                          inStream[filledBytes] );
+            Sint16 rSample = 
+                (Sint16)( (inStream[filledBytes+3] << 8) | 
+                          inStream[filledBytes+2] );
+            
+            filledBytes += 4;
+            
+            // apply global loudness to sound sprites as part of this mx
+            soundSpriteMixingBufferL[i] *= soundSpriteGlobalLoudness;
+            soundSpriteMixingBufferR[i] *= soundSpriteGlobalLoudness;
+            
+            if( soundSpritesFading ) {
+                soundSpriteGlobalLoudness -= soundSpriteFadeIncrementPerSample;
                 
-                if( prefFilePath == NULL ) {
-                    char *message = 
-                        autoSprintf( "Failed to open this preferences file "
-                                     "for writing:\n\n%s\n\n"
-                                     "You will have to find the game folder "
-                                     "again at next startup.",
-                                     prefFilePath );
-                    
-                    showMessage( getAppName(), "First Start Up Error",
-                                 message,
-                                 true );
-                    delete [] message;
-                    }
-                else {
-                    fprintf( prefFile, path );
-                    fclose( prefFile );
+                if( soundSpriteGlobalLoudness < 0.0f ) {
+                    soundSpriteGlobalLoudness = 0.0f;
                     }
-                
-                delete [] prefFilePath;
-                
-
-                chdir( path );
+                }
 
-                delete [] path;
 
-                if( !isSettingsFolderFound() ) {
-                    showMessage( getAppName(), "First Start Up Error",
-                                 "Still cannot find game data, exiting.",
-                                 true );
-                    return 1;
-                    }
-                }
-            else {
-                showMessage( getAppName(), "First Start Up Error",
-                             "Picking a folder failed, exiting.",
-                             true );
-                return 1;
-                }
-            
+            soundSpriteMixingBufferL[i] += lSample;
+            soundSpriteMixingBufferR[i] += rSample;
             }
-        
 
-        delete [] bundleName;
-        delete [] appDirectoryPath;
-    #endif
 
         
+        // we have our final mix, make sure it never clips, and
+        // convert back to integers
+        audioNoClipBlockToS16LE( &totalAudioMixNoClip,
+                                 soundSpriteMixingBufferL, 
+                                 soundSpriteMixingBufferR,
+                                 inStream,
+                                 numSamples );
 
-    
-    AppLog::info( "New game starting up" );
-    
-
-    if( sdlResult < 0 ) {
-        AppLog::getLog()->logPrintf( 
-            Log::CRITICAL_ERROR_LEVEL,
-            "Couldn't initialize SDL: %s\n", SDL_GetError() );
-        return 0;
+        removeFinishedSoundSprites();
         }
+    
+    // now apply global loudness fade for pause
+    // (float mix has had it applied already)
+    if( getSoundSamplesFloatFunction == NULL && isSoundLoudnessScaling() ) {
+        
+        int nextByte = 0;
+        for( int i=0; i<numSamples; i++ ) {
+            Sint16 lSample = 
+                inStream[nextByte] | 
+                ( inStream[nextByte + 1] << 8 );
+            
+            Sint16 rSample = 
+                inStream[nextByte + 2] | 
+                ( inStream[nextByte + 3] << 8 );
+            
+            lSample = (Sint16)( lSample * currentSoundLoudness );
+            rSample = (Sint16)( rSample * currentSoundLoudness );
+            
 
-
-    if( doesOverrideGameImageSize() ) {
-        getGameImageSize( &gameWidth, &gameHeight );
+            inStream[nextByte++] = (Uint8)( lSample & 0xFF );
+            inStream[nextByte++] = (Uint8)( ( lSample >> 8 ) & 0xFF );
+            inStream[nextByte++] = (Uint8)( rSample & 0xFF );
+            inStream[nextByte++] = (Uint8)( ( rSample >> 8 ) & 0xFF );
+            
+            stepSoundLoudness();
+            }
         }
     
-    AppLog::getLog()->logPrintf( 
-        Log::INFO_LEVEL,
-        "Target game image size:  %dx%d\n",
-        gameWidth, gameHeight );
+    
+    if( recordAudio ) {    
+        
+        
+        if( numSamples > samplesLeftToRecord ) {
+            numSamples = samplesLeftToRecord;
+            }
 
+        // reverse byte order
+        int nextByte = 0;
+        for( int i=0; i<numSamples; i++ ) {
+                    
+            fwrite( &( inStream[ nextByte + 1 ] ), 1, 1, aiffOutFile );
+            fwrite( &( inStream[ nextByte ] ), 1, 1, aiffOutFile );
+    
+            fwrite( &( inStream[ nextByte + 3 ] ), 1, 1, aiffOutFile );
+            fwrite( &( inStream[ nextByte + 2 ] ), 1, 1, aiffOutFile );
+            nextByte += 4;
+            }
+        
 
-    // read screen size from settings
-    char widthFound = false;
-    int readWidth = SettingsManager::getIntSetting( "screenWidth", 
-                                                    &widthFound );
-    char heightFound = false;
-    int readHeight = SettingsManager::getIntSetting( "screenHeight", 
-                                                    &heightFound );
+        samplesLeftToRecord -= numSamples;
+        
     
-    if( widthFound && heightFound ) {
-        // override hard-coded defaults
-        screenWidth = readWidth;
-        screenHeight = readHeight;
+        if( samplesLeftToRecord <= 0 ) {
+            recordAudio = false;
+            fclose( aiffOutFile );
+            aiffOutFile = NULL;
+            }            
         }
     
-    AppLog::getLog()->logPrintf( 
-        Log::INFO_LEVEL,
-        "Ideal window dimensions:  %dx%d\n",
-        screenWidth, screenHeight );
+    }
 
 
-    if( ! isNonIntegerScalingAllowed() && 
-        screenWidth < gameWidth ) {
-        
-        AppLog::info( 
-            "Screen width smaller than target game width, fixing" );
-        screenWidth = gameWidth;
-        }
-    if( ! isNonIntegerScalingAllowed() && 
-        screenHeight < gameHeight ) {
-        AppLog::info( 
-            "Screen height smaller than target game height, fixing" );
-        screenHeight = gameHeight;
-        }
-    
+int getSampleRate() {
+    return soundSampleRate;
+    }
 
-    handleTooWide();
-    
 
-    char fullscreenFound = false;
-    int readFullscreen = SettingsManager::getIntSetting( "fullscreen", 
-                                                         &fullscreenFound );
-    
-    char fullscreen = true;
-    
-    if( fullscreenFound && readFullscreen == 0 ) {
-        fullscreen = false;
-        }
+void setSoundPlaying( char inPlaying ) {
+    SDL_PauseAudio( !inPlaying );
+    }
 
-    if( fullscreen ) {
-        AppLog::info( "Trying to start in fullscreen mode." );
-        }
-    else {
-        AppLog::info( "Trying to start in window mode." );
-        }
-    
 
-    char useLargestWindowFound = false;
-    int readUseLargestWindow = 
-        SettingsManager::getIntSetting( "useLargestWindow", 
-                                        &useLargestWindowFound );
-    
-    char useLargestWindow = true;
-    
-    if( useLargestWindowFound && readUseLargestWindow == 0 ) {
-        useLargestWindow = false;
-        }
 
+void setGetSoundSamplesFloat( GetSoundSamplesFloatFunction inFunction ) {
+    lockAudio();
+    getSoundSamplesFloatFunction = inFunction;
+    unlockAudio();
+    }
 
-    if( !fullscreen && useLargestWindow ) {
-        AppLog::info( "Want to use largest window that fits on screen." );
 
-        const SDL_VideoInfo* currentScreenInfo = SDL_GetVideoInfo();
-        
-        int currentW = currentScreenInfo->current_w;
-        int currentH = currentScreenInfo->current_h;
-        
-        if( isNonIntegerScalingAllowed() ) {            
-            double aspectRatio = screenHeight / (double) screenWidth;
 
-            int tryW = currentW;
-            int tryH = lrint( aspectRatio * currentW );
-            
-            // never fill more than 85% of screen vertically, because
-            // this large of a window is a pain to manage
-            if( tryH >= 0.85 * currentH ) {
-                tryH = lrint( 0.84 * currentH );
-                tryW = lrint( tryH / aspectRatio );
-                }
-            if( tryW < screenWidth ) {
-                // largest window is smaller than requested screen size, 
-                // that's okay.
-                screenWidth = tryW;
-                screenHeight = tryH;
-                }
-            else if( tryW > screenWidth ) {
-                // we're attempting a blow-up
-                // but this is not worth it if the blow-up is too small
-                // we loose pixel accuracy without giving the user a much
-                // larger image.
-                // make sure it's at least 25% wider to be worth it,
-                // otherwise, keep the requested window size
-                if( tryW >= 1.25 * screenWidth ) {
-                    screenWidth = tryW;
-                    screenHeight = tryH;
-                    }
-                else {
-                    AppLog::getLog()->logPrintf( 
-                        Log::INFO_LEVEL,
-                        "Largest-window mode would offer a <25% width "
-                        "increase, using requested window size instead." );
-                    }
-                }
-            }
-        else {
-            
-            int blowUpFactor = 1;
-        
-            while( gameWidth * blowUpFactor < currentW &&
-                   gameHeight * blowUpFactor < currentH ) {
-                
-                blowUpFactor++;
-                }
-            
-            while( blowUpFactor > 1 &&
-                   ( gameWidth * blowUpFactor >= currentW * 0.85 ||
-                     gameHeight * blowUpFactor >= currentH * 0.85 ) ) {
-                
-                // scale back, because we don't want to totally
-                // fill the screen (annoying to manage such a big window)
-                
-                // stop at a window that fills < 85% of screen in 
-                // either direction
-                blowUpFactor --;
-                }
-            
-            screenWidth = blowUpFactor * gameWidth;
-            screenHeight = blowUpFactor * gameHeight;
-            }
-        
+void lockAudio() {
+    SDL_LockAudio();
+    }
 
-        AppLog::getLog()->logPrintf( 
-            Log::INFO_LEVEL,
-            "Screen dimensions for largest-window mode:  %dx%d\n",
-            screenWidth, screenHeight );
-        }
-    else if( !fullscreen && !useLargestWindow ) {
-        // make sure window isn't too big for screen
 
-        const SDL_VideoInfo* currentScreenInfo = SDL_GetVideoInfo();
+
+void unlockAudio() {
+    SDL_UnlockAudio();
+    }
+
+
+
+char isSoundRunning() {
+    return soundRunning;
+    }
+
+
+
+void handleTooWide() {
+    if( isNonIntegerScalingAllowed() ) {
         
-        int currentW = currentScreenInfo->current_w;
-        int currentH = currentScreenInfo->current_h;
+        double screenRatio = (double)screenWidth / (double)screenHeight;
+        double gameRatio = (double)gameWidth / (double)gameHeight;
         
-        if( isNonIntegerScalingAllowed() && 
-            ( screenWidth > currentW || screenHeight > currentH ) ) {
-            double aspectRatio = screenHeight / (double) screenWidth;
-            
-            // make window as wide as screen, preserving game aspect ratio
-            screenWidth = currentW;
-            
-            int testScreenHeight = lrint( aspectRatio * screenWidth );
-            
-            if( testScreenHeight <= currentH ) {    
-                screenHeight = testScreenHeight;
-                }
-            else {
-                screenHeight = currentH;
-                
-                screenWidth = lrint( screenHeight / aspectRatio );
-                }
+        if( screenRatio > gameRatio ) {
+            // screen too wide
 
-            AppLog::infoF( "Requested window too large for screen, "
-                           "non-integer scaling it to %dx%d",
-                           screenWidth, screenHeight );
-            }
-        else {
+            // tell game about this by making game image wider than requested}
             
-
-            int blowDownFactor = 1;
-
-            while( screenWidth / blowDownFactor > currentW
-                   ||
-                   screenHeight / blowDownFactor > currentH ) {
-                blowDownFactor += 1;
-                }
+            int newGameWidth = (int)( screenRatio * gameHeight );
             
-            if( blowDownFactor > 1 ) {
-                screenWidth /= blowDownFactor;
-                screenHeight /= blowDownFactor;
-                }
+            AppLog::infoF( 
+                "Screen has wider aspect ratio than desired game image, " 
+                "fixing by making game image wider (old %dx%d, new %dx%d)",
+                gameWidth, gameHeight, newGameWidth, gameHeight );
 
-            AppLog::infoF( "Requested window too large for screen, "
-                           "integer scaling it to %dx%d",
-                           screenWidth, screenHeight );
+            gameWidth = newGameWidth;
+
+            // if screen too narrow, this is already handled elsewhere
             }
         }
-    
-    
+    }
 
 
 
-    char frameRateFound = false;
-    int readFrameRate = SettingsManager::getIntSetting( "halfFrameRate", 
-                                                         &frameRateFound );
+#ifdef __mac__
 
-    if( frameRateFound && readFrameRate >= 1 ) {
-        // cut frame rate in half N times
-        targetFrameRate /= (int)pow( 2, readFrameRate );
-        }
-    
-    // can't draw less than 1 frame per second
-    if( targetFrameRate < 1 ) {
-        targetFrameRate = 1;
-        }
+#include <unistd.h>
+#include <stdarg.h>
+
+
+// returns path to folder
+static char *pickFolder( const char *inPrompt ) {
     
-    SimpleVector<char*> *possibleFrameRatesSetting = 
-        SettingsManager::getSetting( "possibleFrameRates" );
+    const char *commandFormat = 
+        "osascript -e 'tell application \"Finder\" to activate' "
+        "-e 'tell app \"Finder\" to return POSIX path of "
+        "(choose folder with prompt \"%s\")'";
+
+    char *command = autoSprintf( commandFormat, inPrompt );
+
+    printf( "Running osascript command:\n\n%s\n\n", command );
     
-    for( int i=0; i<possibleFrameRatesSetting->size(); i++ ) {
-        char *f = possibleFrameRatesSetting->getElementDirect( i );
+    FILE *osascriptPipe = popen( command, "r" );
     
-        int v;
+    delete [] command;
+    
+    if( osascriptPipe == NULL ) {
+        AppLog::error( 
+            "Failed to open pipe to osascript for picking a folder." );
+        }
+    else {
+        char buffer[200];
         
-        int numRead = sscanf( f, "%d", &v );
+        int numRead = fscanf( osascriptPipe, "%199s", buffer );
         
         if( numRead == 1 ) {
-            possibleFrameRates.push_back( v );
+            return stringDuplicate( buffer );
             }
-
-        delete [] f;
+        
+        pclose( osascriptPipe );
         }
+    return NULL;
+    }
 
-    delete possibleFrameRatesSetting;
 
 
-    if( possibleFrameRates.size() == 0 ) {
-        possibleFrameRates.push_back( 60 );
-        possibleFrameRates.push_back( 120 );
-        possibleFrameRates.push_back( 144 );
-        }
-    
-    AppLog::info( "The following frame rates are considered possible:" );
-    
-    for( int i=0; i<possibleFrameRates.size(); i++ ) {
-        AppLog::infoF( "%d fps", possibleFrameRates.getElementDirect( i ) );
+static void showMessage( const char *inAppName,
+                         const char *inTitle, const char *inMessage,
+                         char inError = false ) {
+    const char *iconName = "note";
+    if( inError ) {
+        // stop icon is broken in OS 10.12
+        // always use note
+        // iconName = "stop";
         }
+
+    const char *commandFormat =
+        "osascript -e 'tell app \"Finder\" to activate' "
+        "-e 'tell app \"Finder\" to display dialog \"%s\" "
+        "with title \"%s:  %s\" buttons \"Ok\" "
+        "with icon %s default button \"Ok\"' ";
     
-        
+    char *command = autoSprintf( commandFormat, inMessage, inAppName, inTitle, 
+                                 iconName );
+
+    printf( "Running osascript command:\n\n%s\n\n", command );
     
-    char recordFound = false;
-    int readRecordFlag = SettingsManager::getIntSetting( "recordGame", 
-                                                         &recordFound );
+    FILE *osascriptPipe = popen( command, "r" );
     
-    char recordGame = false;
+    delete [] command;
     
-    if( recordFound && readRecordFlag == 1 ) {
-        recordGame = true;
+    if( osascriptPipe == NULL ) {
+        AppLog::error( 
+            "Failed to open pipe to osascript for displaying GUI messages." );
+        }
+    else {
+        pclose( osascriptPipe );
         }
+    }
 
 
-    int speedControlKeysFlag = 
-        SettingsManager::getIntSetting( "enableSpeedControlKeys", 0 );
-    
-    if( speedControlKeysFlag == 1 ) {
-        enableSpeedControlKeys = true;
-        }
-    
+static char *getPrefFilePath() {
+    return autoSprintf( "%s/Library/Preferences/%s_prefs.txt",
+                        getenv( "HOME" ),
+                        getAppName() );
+    }
 
 
-    int outputAllFramesFlag = 
-        SettingsManager::getIntSetting( "outputAllFrames", 0 );
-    
-    if( outputAllFramesFlag == 1 ) {
-        outputAllFrames = true;
-        // start with very first frame
-        shouldTakeScreenshot = true;
+static char isSettingsFolderFound() {
 
-        screenShotPrefix = stringDuplicate( "frame" );
+    File settingsFolder( NULL, "settings" );
+     
+    if( settingsFolder.exists() && settingsFolder.isDirectory() ) {
+        return true;
         }
 
-    int blendOutputFramePairsFlag = 
-        SettingsManager::getIntSetting( "blendOutputFramePairs", 0 );
-    
-    if( blendOutputFramePairsFlag == 1 ) {
-        blendOutputFramePairs = true;
-        }
+    return false;
+    }
 
-    blendOutputFrameFraction = 
-        SettingsManager::getFloatSetting( "blendOutputFrameFraction", 0.0f );
 
-    webProxy = SettingsManager::getStringSetting( "webProxy" );
-    
-    if( webProxy != NULL && 
-        strcmp( webProxy, "" ) == 0 ) {
-        
-        delete [] webProxy;
-        webProxy = NULL;
-        }
-    
+#endif
 
-    // make sure dir is writeable
-    FILE *testFile = fopen( "testWrite.txt", "w" );
-    
-    if( testFile == NULL ) {
-        writeFailed = true;
-        }
-    else {
-        fclose( testFile );
-        
-        remove( "testWrite.txt" );
-        
-        writeFailed = false;
-        }
 
 
-    // don't try to record games if we can't write to dir
-    // can cause a crash.
-    if( writeFailed ) {
-        recordGame = false;
-        }
-    
+#ifdef WIN32
 
+#include <windows.h>
+#include <tchar.h>
 
+#endif
 
 
 
-    char *customData = getCustomRecordedGameData();
+int mainFunction( int inNumArgs, char **inArgs ) {
 
-    char *hashSalt = getHashSalt();
+#ifdef WIN32
 
 
-    AppLog::infoF( "Constructing ScreenGL with requested %dx%d, %d fps, "
-                   "fullscreen(%d)",
-                   screenWidth, screenHeight, targetFrameRate, fullscreen );
+    HMODULE hShcore = LoadLibrary( _T( "shcore.dll" ) );
 
-    screen =
-        new ScreenGL( screenWidth, screenHeight, fullscreen, 
-                      shouldNativeScreenResolutionBeUsed(),
-                      targetFrameRate,
-                      recordGame,
-                      customData,
-                      hashSalt,
-                      getWindowTitle(), NULL, NULL, NULL );
+    if( hShcore != NULL ) {
+        printf( "shcore.dll loaded successfully\n" );
+        
+        typedef enum _PROCESS_DPI_AWARENESS { 
+            PROCESS_DPI_UNAWARE            = 0,
+            PROCESS_SYSTEM_DPI_AWARE       = 1,
+            PROCESS_PER_MONITOR_DPI_AWARE  = 2
+            } PROCESS_DPI_AWARENESS;
+        
+        typedef HRESULT (WINAPI *SetProcessDpiAwarenessFunc)( PROCESS_DPI_AWARENESS );
+        
+        SetProcessDpiAwarenessFunc setAwareness = 
+            (SetProcessDpiAwarenessFunc)GetProcAddress(
+                hShcore, 
+                "SetProcessDpiAwareness" );
+        
+        if( setAwareness ) {
+            printf( "Found SetProcessDpiAwareness function in shcore.dll\n" );
+            setAwareness( PROCESS_PER_MONITOR_DPI_AWARE );
+            }
+        else {
+            printf( "Could NOT find SetProcessDpiAwareness function in "
+                    "Shcore.dll\n" );
+            }
+        FreeLibrary( hShcore );
+        }
+    else {
+        printf( "shcore.dll NOT loaded successfully... pre Win 8.1 ?\n" );
 
-    delete [] customData;
-    delete [] hashSalt;
-    
 
-    // may change if specified resolution is not supported
-    // or for event playback mode
-    screenWidth = screen->getWidth();
-    screenHeight = screen->getHeight();
-    targetFrameRate = screen->getMaxFramerate();
+        printf( "   Trying to load user32.dll instead\n" );
+        
 
-    AppLog::infoF( "ScreenGL gave us %dx%d, %d fps",
-                   screenWidth, screenHeight, targetFrameRate );
+        // backwards compatible code
+        // on vista and higher, this will tell Windows that we are DPI aware
+        // and that we should not be artificially scaled.
+        //
+        // Found here:  http://www.rw-designer.com/DPI-aware
+        HMODULE hUser32 = LoadLibrary( _T( "user32.dll" ) );
+        
+        if( hUser32 != NULL ) {
+            
+            typedef BOOL (WINAPI *SetProcessDPIAwareFunc)();
+            
+            SetProcessDPIAwareFunc setDPIAware = 
+                (SetProcessDPIAwareFunc)GetProcAddress( hUser32, 
+                                                        "SetProcessDPIAware" );
+            if( setDPIAware ) {
+                printf( "Found SetProcessDPIAware function in user32.dll\n" );
+                setDPIAware();
+                }
+            else {
+                printf( "Could NOT find SetProcessDPIAware function in "
+                        "user32.dll\n" );
+                }
+            FreeLibrary( hUser32 );
+            }
+        else {
+            printf( "Failed to load user32.dll\n" );
+            }
+        }
+#endif
 
 
-    // call this again here, because screenWidth or screenHeight might
-    // have changed from what we requested
-    handleTooWide();
+    // startup phases are reported once first frame is ready
+    // see StartupTimeline.h
+    StartupTimeline::beginPhase( "resourceArchive" );
+    
+    // before anything reads settings, which it may hold defaults for
+    openResourceArchive();
+
+    StartupTimeline::endPhase();
+    
     
+    StartupTimeline::beginPhase( "sdlInit" );
     
+    // settings saved during play (volume drags, window moves) are
+    // written by a background thread, not mid-frame
+    SettingsManager::setWriteDelay( 
+        SettingsManager::getFloatSetting( "settingsWriteDelay", 0.5f ) );
     
 
+    // for verifying recordings (on servers, with no display):
+    // no window, no GL, no sound
+    // see ScreenGL::isHeadless
+    char headlessPlayback = 
+        ( SettingsManager::getIntSetting( "headlessPlayback", 0 ) == 1 );
 
+    if( headlessPlayback ) {
+        SDL_putenv( (char*)"SDL_VIDEODRIVER=dummy" );
+        }
+    
 
+    // check result below, after opening log, so we can log failure
+    Uint32 flags = SDL_INIT_VIDEO | SDL_INIT_NOPARACHUTE;
+    if( getUsesSound() && ! headlessPlayback ) {
+        flags |= SDL_INIT_AUDIO;
+        }
+    
+    int sdlResult = SDL_Init( flags );
 
+    // written from a background thread, so render and audio threads
+    // never wait on disk to log (except for errors, which are written
+    // before the call returns, so they survive a crash)
+    Log *textLog = new AsyncFileLog( "log.txt" );
 
+    if( SettingsManager::getIntSetting( "traceLog", 0 ) == 1 ) {
+        // trace messages recorded in binary, cheaply enough to leave on
+        // under load, and rendered later with traceFormatter
+        AppLog::setLog( new BinaryTraceLog( textLog, "trace.bin" ) );
+        AppLog::setLoggingLevel( Log::TRACE_LEVEL );
+        }
+    else {
+        AppLog::setLog( textLog );
+        AppLog::setLoggingLevel( Log::DETAIL_LEVEL );
+        }
 
-    // watch out for huge resolutions that make default SDL cursor
-    // too small
+    StartupTimeline::endPhase();
+    
+    PROFILE_THREAD_NAME( "main" );
 
-    int forceBigPointer = SettingsManager::getIntSetting( "forceBigPointer",
-                                                          0 );
-    if( forceBigPointer ||
-        screenWidth > 1920 || screenHeight > 1080 ) {
-        // big cursor
-        
-        AppLog::info( "Trying to load pointer from graphics/bigPointer.tga" );
 
+    // do this mac check after initing SDL,
+    // since it causes various Mac frameworks to be loaded (which can
+    // change the current working directory out from under us)
+    #ifdef __mac__
+        // make sure working directory is the same as the directory
+        // that the app resides in
+        // this is especially important on the mac platform, which
+        // doesn't set a proper working directory for double-clicked
+        // app bundles
 
-        Image *cursorImage = readTGAFile( "bigPointer.tga" );
+        // arg 0 is the path to the app executable
+        char *appDirectoryPath = stringDuplicate( inArgs[0] );
+    
+        char *bundleName = autoSprintf( "%s_v%d.app", 
+                                        getAppName(), getAppVersion() );
 
-        if( cursorImage != NULL ) {
+        char *appNamePointer = strstr( appDirectoryPath, bundleName );
+        AppLog::info( appDirectoryPath );
+        AppLog::info( bundleName );
 
-            if( cursorImage->getWidth() == 32 &&
-                cursorImage->getHeight() == 32 &&
-                cursorImage->getNumChannels() == 4 ) {
-                
-                double *r = cursorImage->getChannel( 0 );
-                double *a = cursorImage->getChannel( 3 );
+        if( appNamePointer != NULL ) {
+            // terminate full app path to get parent directory
+            appNamePointer[0] = '\0';
+            AppLog::info( "chdir" );
+            chdir( appDirectoryPath );
+            }
+        AppLog::info( appDirectoryPath );
                 
+        
+        if( ! isSettingsFolderFound() ) {
+            // first, try setting dir based on preferences file
+            char *prefFilePath = getPrefFilePath();
+        
+            FILE *prefFile = fopen( prefFilePath, "r" );
+            
+            if( prefFile != NULL ) {
 
-                Uint8 data[4*32];
-                Uint8 mask[4*32];
-                int i = -1;
+                char path[200];
                 
-                for( int y=0; y<32; y++ ) {
-                    for( int x=0; x<32; x++ ) {
-                        int p = y * 32 + x;
-                        
-                        if ( x % 8 ) {
-                            data[i] <<= 1;
-                            mask[i] <<= 1;
-                            } 
-                        else {
-                            i++;
-                            data[i] = mask[i] = 0;
-                            }
-                        
-                        if( a[p] == 1 ) {
-                            if( r[p] == 0 ) {
-                                data[i] |= 0x01;
-                                }
-                            mask[i] |= 0x01;
-                            }
-                        }
-                    }
+                int numRead = fscanf( prefFile, "%199s", path );
                 
-                // hot in upper left corner, (0,0)
-                ourCursor = 
-                    SDL_CreateCursor( data, mask, 32, 32, 0, 0 );
-    
-                SDL_SetCursor( ourCursor );
-                }
-            else {
-                AppLog::error( 
-                    "bigPointer.tga is not a 32x32 4-channel image." );
-
+                if( numRead == 1 ) {
+                    chdir( path );
+                    }
+                fclose( prefFile );
                 }
             
-            delete cursorImage;
+            delete [] prefFilePath;
             }
-        else {
+        
+
+        if( ! isSettingsFolderFound() ) {
             
-            AppLog::error( "Failed to read bigPointer.tga" );
-            }
-        }
+            showMessage( getAppName(), "First Start Up Error",
+                         "Cannot find game data.\n\n"
+                         "Newer versions of MacOS have strict sandboxing, "
+                         "so we have to work around this issue by asking "
+                         "you a question.\n\n"
+                         //"There will also be some info presented along the "
+                         //"way for debugging purposes.\n\n"
+                         "Hopefully, you will only have to do this once.", 
+                         true );
+            
+            
+            //showMessage( getAppName(), "Debug Info, Executable path =",
+            //             inArgs[0], false );
+
 
+            //showMessage( getAppName(), "Debug Info, Home dir =", 
+            //             getenv( "HOME" ), false );
+            
 
+            showMessage( getAppName(), "First Start Up",
+                         "Please locate the game folder "
+                         "in the next dialog box.",
+                         false );
+            
+            char *prompt = autoSprintf( 
+                "Find the game folder (where the %s App is located):",
+                getAppName() );
+            
+            char *path = pickFolder( prompt );
 
+            delete [] prompt;
+            
+            if( path != NULL ) {
+                //showMessage( getAppName(), "Debug Info, Chosen path =",
+                //             path, false );
 
 
+                char *prefFilePath = getPrefFilePath();
+                
+                FILE *prefFile = fopen( prefFilePath, "w" );
+                
+                if( prefFilePath == NULL ) {
+                    char *message = 
+                        autoSprintf( "Failed to open this preferences file "
+                                     "for writing:\n\n%s\n\n"
+                                     "You will have to find the game folder "
+                                     "again at next startup.",
+                                     prefFilePath );
+                    
+                    showMessage( getAppName(), "First Start Up Error",
+                                 message,
+                                 true );
+                    delete [] message;
+                    }
+                else {
+                    fprintf( prefFile, path );
+                    fclose( prefFile );
+                    }
+                
+                delete [] prefFilePath;
+                
 
+                chdir( path );
 
+                delete [] path;
 
+                if( !isSettingsFolderFound() ) {
+                    showMessage( getAppName(), "First Start Up Error",
+                                 "Still cannot find game data, exiting.",
+                                 true );
+                    return 1;
+                    }
+                }
+            else {
+                showMessage( getAppName(), "First Start Up Error",
+                             "Picking a folder failed, exiting.",
+                             true );
+                return 1;
+                }
+            
+            }
+        
 
+        delete [] bundleName;
+        delete [] appDirectoryPath;
+    #endif
 
+        
 
     
+    AppLog::info( "New game starting up" );
     
-    // adjust gameWidth to match available screen space
-    // keep gameHeight constant
 
+    if( sdlResult < 0 ) {
+        AppLog::getLog()->logPrintf( 
+            Log::CRITICAL_ERROR_LEVEL,
+            "Couldn't initialize SDL: %s\n", SDL_GetError() );
+        return 0;
+        }
 
-    /*
-    SDL_EnableKeyRepeat( SDL_DEFAULT_REPEAT_DELAY,
-                         SDL_DEFAULT_REPEAT_INTERVAL );
-    */
+
+    if( doesOverrideGameImageSize() ) {
+        getGameImageSize( &gameWidth, &gameHeight );
+        }
     
-    // never cut off top/bottom of image, and always try to use largest
-    // whole multiples of screen pixels per game pixel to fill
-    // the screen vertically as well as we can
-    pixelZoomFactor = screenHeight / gameHeight;
+    AppLog::getLog()->logPrintf( 
+        Log::INFO_LEVEL,
+        "Target game image size:  %dx%d\n",
+        gameWidth, gameHeight );
+
+
+    StartupTimeline::beginPhase( "settings" );
     
-    if( pixelZoomFactor < 1 ) {
-        pixelZoomFactor = 1;
+    // read screen size from settings
+    char widthFound = false;
+    int readWidth = SettingsManager::getIntSetting( "screenWidth", 
+                                                    &widthFound );
+    char heightFound = false;
+    int readHeight = SettingsManager::getIntSetting( "screenHeight", 
+                                                    &heightFound );
+    
+    if( widthFound && heightFound ) {
+        // override hard-coded defaults
+        screenWidth = readWidth;
+        screenHeight = readHeight;
         }
     
+    AppLog::getLog()->logPrintf( 
+        Log::INFO_LEVEL,
+        "Ideal window dimensions:  %dx%d\n",
+        screenWidth, screenHeight );
 
-    if( ! isNonIntegerScalingAllowed() ) {
+
+    if( ! isNonIntegerScalingAllowed() && 
+        screenWidth < gameWidth ) {
         
-        // make sure game width fills the screen at this pixel zoom, 
-        // even if game
-        // height does not (letterbox on top/bottom, but never on left/rigtht)
+        AppLog::info( 
+            "Screen width smaller than target game width, fixing" );
+        screenWidth = gameWidth;
+        }
+    if( ! isNonIntegerScalingAllowed() && 
+        screenHeight < gameHeight ) {
+        AppLog::info( 
+            "Screen height smaller than target game height, fixing" );
+        screenHeight = gameHeight;
+        }
+    
 
-        // closest number of whole pixels
-        // may be *slight* black bars on left/right
-        gameWidth = screenWidth / pixelZoomFactor;
+    handleTooWide();
     
-        screen->setImageSize( pixelZoomFactor * gameWidth,
-                              pixelZoomFactor * gameHeight );
 
-        AppLog::infoF( "Setting integer-scaled screen image size of %dx%d",
-                       pixelZoomFactor * gameWidth,
-                       pixelZoomFactor * gameHeight );
+    char fullscreenFound = false;
+    int readFullscreen = SettingsManager::getIntSetting( "fullscreen", 
+                                                         &fullscreenFound );
+    
+    char fullscreen = true;
+    
+    if( fullscreenFound && readFullscreen == 0 ) {
+        fullscreen = false;
         }
-    else {
-        
-        pixelZoomFactor = 1;
-        
-        double targetAspectRatio = (double)gameWidth / (double)gameHeight;
-        
-        double screenAspectRatio = (double)screenWidth / (double)screenHeight;
-        
-        int imageW = screenWidth;
-        int imageH = screenHeight;
-        
-        if( screenAspectRatio > targetAspectRatio ) {
-            // screen too wide
-            
-            imageW = (int)( targetAspectRatio * imageH );
-            }
-        else if( screenAspectRatio < targetAspectRatio ) {
-            // too tall
 
-            imageH = (int)( imageW / targetAspectRatio );
-            }
-
-        screen->setImageSize( imageH,
-                              imageW );
-
-        AppLog::infoF( "Setting non-integer-scaled screen image size of %dx%d",
-                       imageW, imageH );
+    if( fullscreen ) {
+        AppLog::info( "Trying to start in fullscreen mode." );
+        }
+    else {
+        AppLog::info( "Trying to start in window mode." );
         }
     
 
-    screen->allowSlowdownKeysDuringPlayback( enableSpeedControlKeys );
-
-    //SDL_ShowCursor( SDL_DISABLE );
-
-
-    sceneHandler = new GameSceneHandler( screen );
-
-    
-
-    // also do file-dependent part of init for GameSceneHandler here
-    // actually, constructor is file dependent anyway.
-    sceneHandler->initFromFiles();
+    char useLargestWindowFound = false;
+    int readUseLargestWindow = 
+        SettingsManager::getIntSetting( "useLargestWindow", 
+                                        &useLargestWindowFound );
     
-
-    // hard to quit mode?
-    char hardToQuitFound = false;
-    int readHardToQuit = SettingsManager::getIntSetting( "hardToQuitMode", 
-                                                         &hardToQuitFound );
+    char useLargestWindow = true;
     
-    if( readHardToQuit == 1 ) {
-        hardToQuitMode = true;
+    if( useLargestWindowFound && readUseLargestWindow == 0 ) {
+        useLargestWindow = false;
         }
 
-    pauseOnMinimize = SettingsManager::getIntSetting( "pauseOnMinimize", 1 );
-    
-
-    
-    // translation language
-    File *languageNameFile = new File( NULL, "language.txt" );
-
-    if( languageNameFile->exists() ) {
-        char *languageNameText = languageNameFile->readFileContents();
 
-        SimpleVector<char *> *tokens = tokenizeString( languageNameText );
+    if( !fullscreen && useLargestWindow ) {
+        AppLog::info( "Want to use largest window that fits on screen." );
 
-        int numTokens = tokens->size();
+        const SDL_VideoInfo* currentScreenInfo = SDL_GetVideoInfo();
         
-        // first token is name
-        if( numTokens > 0 ) {
-            char *languageName = *( tokens->getElement( 0 ) );
+        int currentW = currentScreenInfo->current_w;
+        int currentH = currentScreenInfo->current_h;
         
-            TranslationManager::setLanguage( languageName, true );
+        if( isNonIntegerScalingAllowed() ) {            
+            double aspectRatio = screenHeight / (double) screenWidth;
 
-            // augment translation by adding other languages listed
-            // to fill in missing keys in top-line language
+            int tryW = currentW;
+            int tryH = lrint( aspectRatio * currentW );
             
-            for( int i=1; i<numTokens; i++ ) {
-                languageName = *( tokens->getElement( i ) );
-        
-                TranslationManager::setLanguage( languageName, false );
+            // never fill more than 85% of screen vertically, because
+            // this large of a window is a pain to manage
+            if( tryH >= 0.85 * currentH ) {
+                tryH = lrint( 0.84 * currentH );
+                tryW = lrint( tryH / aspectRatio );
+                }
+            if( tryW < screenWidth ) {
+                // largest window is smaller than requested screen size, 
+                // that's okay.
+                screenWidth = tryW;
+                screenHeight = tryH;
+                }
+            else if( tryW > screenWidth ) {
+                // we're attempting a blow-up
+                // but this is not worth it if the blow-up is too small
+                // we loose pixel accuracy without giving the user a much
+                // larger image.
+                // make sure it's at least 25% wider to be worth it,
+                // otherwise, keep the requested window size
+                if( tryW >= 1.25 * screenWidth ) {
+                    screenWidth = tryW;
+                    screenHeight = tryH;
+                    }
+                else {
+                    AppLog::getLog()->logPrintf( 
+                        Log::INFO_LEVEL,
+                        "Largest-window mode would offer a <25% width "
+                        "increase, using requested window size instead." );
+                    }
                 }
             }
         else {
-            // default
-
-            // TranslationManager already defaults to English, but
-            // it looks for the language files at runtime before we have set
-            // the current working directory.
             
-            // Thus, we specify the default again here so that it looks
-            // for its language files again.
-            TranslationManager::setLanguage( "English", true );
+            int blowUpFactor = 1;
+        
+            while( gameWidth * blowUpFactor < currentW &&
+                   gameHeight * blowUpFactor < currentH ) {
+                
+                blowUpFactor++;
+                }
+            
+            while( blowUpFactor > 1 &&
+                   ( gameWidth * blowUpFactor >= currentW * 0.85 ||
+                     gameHeight * blowUpFactor >= currentH * 0.85 ) ) {
+                
+                // scale back, because we don't want to totally
+                // fill the screen (annoying to manage such a big window)
+                
+                // stop at a window that fills < 85% of screen in 
+                // either direction
+                blowUpFactor --;
+                }
+            
+            screenWidth = blowUpFactor * gameWidth;
+            screenHeight = blowUpFactor * gameHeight;
             }
         
-        delete [] languageNameText;
 
-        for( int t=0; t<numTokens; t++ ) {
-            delete [] *( tokens->getElement( t ) );
-            }
-        delete tokens;
+        AppLog::getLog()->logPrintf( 
+            Log::INFO_LEVEL,
+            "Screen dimensions for largest-window mode:  %dx%d\n",
+            screenWidth, screenHeight );
         }
-    
-    delete languageNameFile;
-    
+    else if( !fullscreen && !useLargestWindow ) {
+        // make sure window isn't too big for screen
 
-    
+        const SDL_VideoInfo* currentScreenInfo = SDL_GetVideoInfo();
         
-    // register cleanup function, since screen->start() will never return
-    atexit( cleanUpAtExit );
+        int currentW = currentScreenInfo->current_w;
+        int currentH = currentScreenInfo->current_h;
+        
+        if( isNonIntegerScalingAllowed() && 
+            ( screenWidth > currentW || screenHeight > currentH ) ) {
+            double aspectRatio = screenHeight / (double) screenWidth;
+            
+            // make window as wide as screen, preserving game aspect ratio
+            screenWidth = currentW;
+            
+            int testScreenHeight = lrint( aspectRatio * screenWidth );
+            
+            if( testScreenHeight <= currentH ) {    
+                screenHeight = testScreenHeight;
+                }
+            else {
+                screenHeight = currentH;
+                
+                screenWidth = lrint( screenHeight / aspectRatio );
+                }
+
+            AppLog::infoF( "Requested window too large for screen, "
+                           "non-integer scaling it to %dx%d",
+                           screenWidth, screenHeight );
+            }
+        else {
+            
 
+            int blowDownFactor = 1;
 
+            while( screenWidth / blowDownFactor > currentW
+                   ||
+                   screenHeight / blowDownFactor > currentH ) {
+                blowDownFactor += 1;
+                }
+            
+            if( blowDownFactor > 1 ) {
+                screenWidth /= blowDownFactor;
+                screenHeight /= blowDownFactor;
+                }
 
+            AppLog::infoF( "Requested window too large for screen, "
+                           "integer scaling it to %dx%d",
+                           screenWidth, screenHeight );
+            }
+        }
+    
+    
 
-    screen->switchTo2DMode();
 
 
+    char frameRateFound = false;
+    int readFrameRate = SettingsManager::getIntSetting( "halfFrameRate", 
+                                                         &frameRateFound );
 
-    if( getUsesSound() ) {
+    if( frameRateFound && readFrameRate >= 1 ) {
+        // cut frame rate in half N times
+        targetFrameRate /= (int)pow( 2, readFrameRate );
+        }
+    
+    // can't draw less than 1 frame per second
+    if( targetFrameRate < 1 ) {
+        targetFrameRate = 1;
+        }
+    
+    SimpleVector<char*> *possibleFrameRatesSetting = 
+        SettingsManager::getSetting( "possibleFrameRates" );
+    
+    for( int i=0; i<possibleFrameRatesSetting->size(); i++ ) {
+        char *f = possibleFrameRatesSetting->getElementDirect( i );
+    
+        int v;
         
-        soundSampleRate = 
-            SettingsManager::getIntSetting( "soundSampleRate", 22050 );
-
-        int requestedBufferSize = 
-            SettingsManager::getIntSetting( "soundBufferSize", 512 );
+        int numRead = sscanf( f, "%d", &v );
         
-        // 1 second fade in/out
-        soundLoudnessIncrementPerSample = 1.0f / soundSampleRate;
-
-        // force user-specified value to closest (round up) power of 2
-        int bufferSize = 2;
-        while( bufferSize < requestedBufferSize ) {
-            bufferSize *= 2;
+        if( numRead == 1 ) {
+            possibleFrameRates.push_back( v );
             }
-        
 
-        SDL_AudioSpec audioFormat;
-
-        /* Set 16-bit stereo audio at 22Khz */
-        audioFormat.freq = soundSampleRate;
-        audioFormat.format = AUDIO_S16;
-        audioFormat.channels = 2;
-        //audioFormat.samples = 512;        /* A good value for games */
-        audioFormat.samples = bufferSize;     
-        audioFormat.callback = audioCallback;
-        audioFormat.userdata = NULL;
-        
-        SDL_AudioSpec actualFormat;
-        
-
-        int recordAudioFlag = 
-            SettingsManager::getIntSetting( "recordAudio", 0 );
-        int recordAudioLengthInSeconds = 
-            SettingsManager::getIntSetting( "recordAudioLengthInSeconds", 0 );
+        delete [] f;
+        }
 
+    delete possibleFrameRatesSetting;
 
 
-        SDL_LockAudio();
-        
-        int openResult = 0;
-        
-        if( ! recordAudioFlag ) {
-            openResult = SDL_OpenAudio( &audioFormat, &actualFormat );
-            }
+    if( possibleFrameRates.size() == 0 ) {
+        possibleFrameRates.push_back( 60 );
+        possibleFrameRates.push_back( 120 );
+        possibleFrameRates.push_back( 144 );
+        }
+    
+    AppLog::info( "The following frame rates are considered possible:" );
+    
+    for( int i=0; i<possibleFrameRates.size(); i++ ) {
+        AppLog::infoF( "%d fps", possibleFrameRates.getElementDirect( i ) );
+        }
+    
         
+    
+    char recordFound = false;
+    int readRecordFlag = SettingsManager::getIntSetting( "recordGame", 
+                                                         &recordFound );
+    
+    char recordGame = false;
+    
+    if( recordFound && readRecordFlag == 1 ) {
+        recordGame = true;
+        }
 
 
-        /* Open the audio device and start playing sound! */
-        if( openResult < 0 ) {
-            AppLog::getLog()->logPrintf( 
-                Log::ERROR_LEVEL,
-                "Unable to open audio: %s\n", SDL_GetError() );
-            soundRunning = false;
-            soundOpen = false;
-            }
-        else {
-
-            if( !recordAudioFlag && 
-                ( actualFormat.format != AUDIO_S16 ||
-                  actualFormat.channels != 2 ) ) {
-                
-                
-                AppLog::getLog()->logPrintf( 
-                    Log::ERROR_LEVEL,
-                    "Able to open audio, "
-                    "but stereo S16 samples not availabl\n");
-                
-                SDL_CloseAudio();
-                soundRunning = false;
-                soundOpen = false;
-                }
-            else {
-                
-                int desiredRate = soundSampleRate;
-                
-                if( !recordAudioFlag ) {    
-                    AppLog::getLog()->logPrintf( 
-                        Log::INFO_LEVEL,
-                        "Successfully opened audio: %dHz (requested %dHz), "
-                        "sample buffer size=%d (requested %d)\n", 
-                        actualFormat.freq, desiredRate, actualFormat.samples,
-                        bufferSize );
-                    
-                    // tell game what their buffer size will be
-                    // so they can allocate it outside the callback
-                    hintBufferSize( actualFormat.samples * 4 );
-                    bufferSizeHinted = true;
-                    }
-                else {
-                    AppLog::getLog()->logPrintf( 
-                        Log::INFO_LEVEL,
-                        "Successfully faked opening of audio for "
-                        "recording to file: %dHz\n", desiredRate );
-                    // don't hint buffer size yet
-                    bufferSizeHinted = false;
-                    }
-                
-
-
-                
-                soundSpriteNoClip =
-                    resetAudioNoClip( 
-                        ( 1.0 - soundSpriteCompressionFraction ) *
-                        maxTotalSoundSpriteVolume * 32767, 
-                        // half second hold and release
-                        soundSampleRate / 2, soundSampleRate / 2 );
+    int speedControlKeysFlag = 
+        SettingsManager::getIntSetting( "enableSpeedControlKeys", 0 );
+    
+    if( speedControlKeysFlag == 1 ) {
+        enableSpeedControlKeys = true;
+        }
+    
+    
+    int statsOverlayKeyFlag =
+        SettingsManager::getIntSetting( "enableStatsOverlayKey", 0 );
+    
+    if( statsOverlayKeyFlag == 1 ) {
+        enableStatsOverlayKey = true;
+        }
+    
 
-                totalAudioMixNoClip = 
-                    resetAudioNoClip( 32767.0,
-                                      // 10x faster hold and release
-                                      // for master mix
-                                      // pull music and sound effects down
-                                      // to prevent clipping, but bring
-                                      // it right back up again quickly
-                                      // after the transient passes to
-                                      // avoid audible pumping in music
-                                      soundSampleRate / 20, 
-                                      soundSampleRate / 20 );
 
+    int outputAllFramesFlag = 
+        SettingsManager::getIntSetting( "outputAllFrames", 0 );
+    
+    if( outputAllFramesFlag == 1 ) {
+        outputAllFrames = true;
+        // start with very first frame
+        shouldTakeScreenshot = true;
 
+        screenShotPrefix = stringDuplicate( "frame" );
+        }
 
-                if( !recordAudioFlag ) {
-                    soundSampleRate = actualFormat.freq;
-                    
-                    soundSpriteMixingBufferL = 
-                        new double[ actualFormat.samples ];
-                    soundSpriteMixingBufferR = 
-                        new double[ actualFormat.samples ];
-                    }
-                
-                
-                soundRunning = true;
-                soundOpen = true;
-                
-                if( recordAudioFlag ) {
-                    soundOpen = false;
-                    }
+    int blendOutputFramePairsFlag = 
+        SettingsManager::getIntSetting( "blendOutputFramePairs", 0 );
+    
+    if( blendOutputFramePairsFlag == 1 ) {
+        blendOutputFramePairs = true;
+        }
 
-                if( recordAudioFlag == 1 && recordAudioLengthInSeconds > 0 ) {
-                    recordAudio = true;
-                    
-                    samplesLeftToRecord = 
-                        recordAudioLengthInSeconds * soundSampleRate;
+    blendOutputFrameFraction = 
+        SettingsManager::getFloatSetting( "blendOutputFrameFraction", 0.0f );
 
-                    aiffOutFile = fopen( "recordedAudio.aiff", "wb" );
+    webProxy = SettingsManager::getStringSetting( "webProxy" );
+    
+    if( webProxy != NULL && 
+        strcmp( webProxy, "" ) == 0 ) {
         
-                    int headerLength;
-                    
-                    unsigned char *header =
-                        getAIFFHeader( 2, 16,
-                                       soundSampleRate,
-                                       samplesLeftToRecord, 
-                                       &headerLength );
-
-                    fwrite( header, 1, headerLength, aiffOutFile );
-
-                    delete [] header;
-                    }
-
-
-
-                }
-            }
-
-        SDL_UnlockAudio();        
+        delete [] webProxy;
+        webProxy = NULL;
         }
     
 
-
+    int webCacheSizeMB = 
+        SettingsManager::getIntSetting( "webCacheSizeMB", 50 );
     
+    if( webCacheSizeMB > 2047 ) {
+        webCacheSizeMB = 2047;
+        }
 
+    if( webCacheSizeMB > 0 ) {
+        char *settingsDir = SettingsManager::getDirectoryName();
+        char *webCacheDir = autoSprintf( "%s/webCache", settingsDir );
+        
+        webCache = new WebCache( webCacheDir, webCacheSizeMB * 1048576 );
 
-    if( ! writeFailed ) {    
-        demoMode = isDemoMode();
+        delete [] settingsDir;
+        delete [] webCacheDir;
         }
     
 
+    // make sure dir is writeable
+    FILE *testFile = fopen( "testWrite.txt", "w" );
     
-    initDrawString( pixelZoomFactor * gameWidth, 
-                    pixelZoomFactor * gameHeight );
+    if( testFile == NULL ) {
+        writeFailed = true;
+        }
+    else {
+        fclose( testFile );
         
-
-    
-    //glLineWidth( pixelZoomFactor );
-    
-    
-    if( demoMode ) {    
-        showDemoCodePanel( screen, getFontTGAFileName(), gameWidth,
-                           gameHeight );
+        remove( "testWrite.txt" );
         
-        // wait to start handling events
-        // wait to start recording/playback
-        }
-    else if( writeFailed ) {
-        // handle key events right away to listen for ESC
-        screen->addKeyboardHandler( sceneHandler );
+        writeFailed = false;
         }
-    else {
-        // handle events right away
-        screen->addMouseHandler( sceneHandler );
-        screen->addKeyboardHandler( sceneHandler );
 
-        if( screen->isPlayingBack() ) {
-            
-            // start playback right away
-            screen->startRecordingOrPlayback();
-            
-            AppLog::infoF( "Using frame rate from recording file:  %d fps\n", 
-                           screen->getMaxFramerate() );
-            }
-        // else wait to start recording until after we've measured
-        // frame rate
+
+    // don't try to record games if we can't write to dir
+    // can cause a crash.
+    if( writeFailed ) {
+        recordGame = false;
         }
     
 
-    int readTarget = SettingsManager::getIntSetting( "targetFrameRate", -1 );
-    int readCounting = SettingsManager::getIntSetting( "countingOnVsync", -1 );
-    
-    if( readTarget != -1 && readCounting != -1 ) {
-        targetFrameRate = readTarget;
-        countingOnVsync = readCounting;
 
-        screen->setFullFrameRate( targetFrameRate );
-        screen->useFrameSleep( !countingOnVsync );
-        screen->startRecordingOrPlayback();
-        
-        if( screen->isPlayingBack() ) {
-            screen->useFrameSleep( true );
-            }
-        measureFrameRate = false;
-        }
-    
 
-    // default texture mode
-    glTexEnvf( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE );
 
+
+    StartupTimeline::endPhase();
     
-    screen->start();
 
+    StartupTimeline::beginPhase( "window" );
     
-    return 0;
-    }
+    char *customData = getCustomRecordedGameData();
 
+    char *hashSalt = getHashSalt();
 
 
+    AppLog::infoF( "Constructing ScreenGL with requested %dx%d, %d fps, "
+                   "fullscreen(%d)",
+                   screenWidth, screenHeight, targetFrameRate, fullscreen );
 
-GameSceneHandler::GameSceneHandler( ScreenGL *inScreen )
-    : mScreen( inScreen ),
-      mPaused( false ),
-      mPausedDuringFrameBatch( true ),
-      mLoadingDuringFrameBatch( true ),
-      mPausedSleepTime( 0 ),
-      mBlockQuitting( false ),
-      mLastFrameRate( targetFrameRate ),
-      mStartTimeSeconds( Time::timeSec() ),
-      mPrintFrameRate( true ),
-      mNumFrames( 0 ), mFrameBatchSize( 100 ),
-      mFrameBatchStartTimeSeconds( -1 ),
-      mBackgroundColor( 0, 0, 0, 1 ) { 
-    
-    
-    glClearColor( mBackgroundColor.r,
-                  mBackgroundColor.g,
-                  mBackgroundColor.b,
-                  mBackgroundColor.a );
-    
-
-    // set external pointer so it can be used in calls below
-    sceneHandler = this;
-
-        
-    mScreen->addSceneHandler( sceneHandler );
-    mScreen->addRedrawListener( sceneHandler );
-    }
+    screen =
+        new ScreenGL( screenWidth, screenHeight, fullscreen, 
+                      shouldNativeScreenResolutionBeUsed(),
+                      targetFrameRate,
+                      recordGame,
+                      customData,
+                      hashSalt,
+                      getWindowTitle(), NULL, NULL, NULL );
 
+    delete [] customData;
+    delete [] hashSalt;
+    
+    if( headlessPlayback && ! screen->isHeadless() ) {
+        // nothing to verify
+        printf( "Headless playback requested, but no valid recording found "
+                "in playbackGame\n" );
+        return 1;
+        }
 
+    // may change if specified resolution is not supported
+    // or for event playback mode
+    screenWidth = screen->getWidth();
+    screenHeight = screen->getHeight();
+    targetFrameRate = screen->getMaxFramerate();
 
-GameSceneHandler::~GameSceneHandler() {
-    mScreen->removeMouseHandler( this );
-    mScreen->removeSceneHandler( this );
-    mScreen->removeRedrawListener( this );
+    AppLog::infoF( "ScreenGL gave us %dx%d, %d fps",
+                   screenWidth, screenHeight, targetFrameRate );
 
-    if( demoMode ) {
-        // panel has not freed itself yet
-        freeDemoCodePanel();
-        
-        demoMode = false;
-        }
+    StartupTimeline::endPhase();
 
 
-    if( loadingFailedMessage != NULL ) {
-        delete [] loadingFailedMessage;
-        loadingFailedMessage = NULL;
-        }
+    // call this again here, because screenWidth or screenHeight might
+    // have changed from what we requested
+    handleTooWide();
+    
     
     
-    }
 
 
 
 
-void GameSceneHandler::initFromFiles() {
-    
-    }
 
 
+    // watch out for huge resolutions that make default SDL cursor
+    // too small
 
+    int forceBigPointer = SettingsManager::getIntSetting( "forceBigPointer",
+                                                          0 );
+    if( forceBigPointer ||
+        screenWidth > 1920 || screenHeight > 1080 ) {
+        // big cursor
+        
+        AppLog::info( "Trying to load pointer from graphics/bigPointer.tga" );
 
-static float viewCenterX = 0;
-static float viewCenterY = 0;
-// default -1 to +1
-static float viewSize = 2;
 
-static float visibleWidth = -1;
-static float visibleHeight = -1;
+        Image *cursorImage = readTGAFile( "bigPointer.tga" );
 
+        if( cursorImage != NULL ) {
 
-static void redoDrawMatrix() {
-    // viewport square centered on screen (even if screen is rectangle)
-    float hRadius = viewSize / 2;
-    
-    float wRadius = hRadius;
-    
-    if( visibleHeight > 0 ) {
-        wRadius = visibleWidth / 2;
-        hRadius = visibleHeight / 2;
-        }
-    
+            if( cursorImage->getWidth() == 32 &&
+                cursorImage->getHeight() == 32 &&
+                cursorImage->getNumChannels() == 4 ) {
+                
+                double *r = cursorImage->getChannel( 0 );
+                double *a = cursorImage->getChannel( 3 );
+                
 
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
-    glOrtho( viewCenterX - wRadius, viewCenterX + wRadius, 
-             viewCenterY - hRadius, viewCenterY + hRadius, -1.0f, 1.0f);
+                Uint8 data[4*32];
+                Uint8 mask[4*32];
+                int i = -1;
+                
+                for( int y=0; y<32; y++ ) {
+                    for( int x=0; x<32; x++ ) {
+                        int p = y * 32 + x;
+                        
+                        if ( x % 8 ) {
+                            data[i] <<= 1;
+                            mask[i] <<= 1;
+                            } 
+                        else {
+                            i++;
+                            data[i] = mask[i] = 0;
+                            }
+                        
+                        if( a[p] == 1 ) {
+                            if( r[p] == 0 ) {
+                                data[i] |= 0x01;
+                                }
+                            mask[i] |= 0x01;
+                            }
+                        }
+                    }
+                
+                // hot in upper left corner, (0,0)
+                ourCursor = 
+                    SDL_CreateCursor( data, mask, 32, 32, 0, 0 );
     
-    if( visibleHeight > 0 ) {
-        
-        float portWide = screenWidth;
-        float portHigh = ( visibleHeight / visibleWidth ) * portWide;
-        
-        float screenHeightFraction = (float) screenHeight / (float) screenWidth;
-        
-        if( screenHeightFraction < 9.0 / 16.0 ) {
-            // wider than 16:9
+                SDL_SetCursor( ourCursor );
+                }
+            else {
+                AppLog::error( 
+                    "bigPointer.tga is not a 32x32 4-channel image." );
 
-            // fill vertically instead
-            portHigh = screenHeight;
+                }
             
-            portWide = ( visibleWidth / visibleHeight ) * portHigh;
+            delete cursorImage;
+            }
+        else {
+            
+            AppLog::error( "Failed to read bigPointer.tga" );
             }
-        
-        float excessW = screenWidth - portWide;
-        float excessH = screenHeight - portHigh;
-    
-        glViewport( excessW / 2,
-                    excessH / 2, 
-                    portWide,
-                    portHigh );    
         }
-    
-    glMatrixMode(GL_MODELVIEW);
-    }
 
 
 
-unsigned int getRandSeed() {
-    return screen->getRandSeed();
-    }
 
 
 
-void pauseGame() {
-    sceneHandler->mPaused = !( sceneHandler->mPaused );
-    }
 
 
-char isPaused() {
-    return sceneHandler->mPaused;
-    }
 
 
 
-void blockQuitting( char inNoQuitting ) {
-    sceneHandler->mBlockQuitting = inNoQuitting;
-    }
+    
+    
+    // adjust gameWidth to match available screen space
+    // keep gameHeight constant
 
 
+    /*
+    SDL_EnableKeyRepeat( SDL_DEFAULT_REPEAT_DELAY,
+                         SDL_DEFAULT_REPEAT_INTERVAL );
+    */
+    
+    // never cut off top/bottom of image, and always try to use largest
+    // whole multiples of screen pixels per game pixel to fill
+    // the screen vertically as well as we can
+    pixelZoomFactor = screenHeight / gameHeight;
+    
+    if( pixelZoomFactor < 1 ) {
+        pixelZoomFactor = 1;
+        }
+    
 
-char isQuittingBlocked() {
-    return sceneHandler->mBlockQuitting;
-    }
+    if( ! isNonIntegerScalingAllowed() ) {
+        
+        // make sure game width fills the screen at this pixel zoom, 
+        // even if game
+        // height does not (letterbox on top/bottom, but never on left/rigtht)
 
+        // closest number of whole pixels
+        // may be *slight* black bars on left/right
+        gameWidth = screenWidth / pixelZoomFactor;
+    
+        screen->setImageSize( pixelZoomFactor * gameWidth,
+                              pixelZoomFactor * gameHeight );
 
+        AppLog::infoF( "Setting integer-scaled screen image size of %dx%d",
+                       pixelZoomFactor * gameWidth,
+                       pixelZoomFactor * gameHeight );
+        }
+    else {
+        
+        pixelZoomFactor = 1;
+        
+        double targetAspectRatio = (double)gameWidth / (double)gameHeight;
+        
+        double screenAspectRatio = (double)screenWidth / (double)screenHeight;
+        
+        int imageW = screenWidth;
+        int imageH = screenHeight;
+        
+        if( screenAspectRatio > targetAspectRatio ) {
+            // screen too wide
+            
+            imageW = (int)( targetAspectRatio * imageH );
+            }
+        else if( screenAspectRatio < targetAspectRatio ) {
+            // too tall
 
-void wakeUpPauseFrameRate() {
-    sceneHandler->mPausedSleepTime = 0;
-    }
+            imageH = (int)( imageW / targetAspectRatio );
+            }
 
+        screen->setImageSize( imageH,
+                              imageW );
 
-// returns true if we're currently executing a recorded game
-char isGamePlayingBack() {
-    return screen->isPlayingBack();
-    }
-
+        AppLog::infoF( "Setting non-integer-scaled screen image size of %dx%d",
+                       imageW, imageH );
+        }
+    
 
+    screen->allowSlowdownKeysDuringPlayback( enableSpeedControlKeys );
 
+    //SDL_ShowCursor( SDL_DISABLE );
 
 
+    StartupTimeline::beginPhase( "sceneHandler" );
+    
+    sceneHandler = new GameSceneHandler( screen );
 
+    
 
-void mapKey( unsigned char inFromKey, unsigned char inToKey ) {
-    screen->setKeyMapping( inFromKey, inToKey );
-    }
+    // also do file-dependent part of init for GameSceneHandler here
+    // actually, constructor is file dependent anyway.
+    sceneHandler->initFromFiles();
+    
+    StartupTimeline::endPhase();
+    
 
+    // hard to quit mode?
+    char hardToQuitFound = false;
+    int readHardToQuit = SettingsManager::getIntSetting( "hardToQuitMode", 
+                                                         &hardToQuitFound );
+    
+    if( readHardToQuit == 1 ) {
+        hardToQuitMode = true;
+        }
 
-void toggleKeyMapping( char inMappingOn ) {
-    screen->toggleKeyMapping( inMappingOn );
-    }
+    pauseOnMinimize = SettingsManager::getIntSetting( "pauseOnMinimize", 1 );
+    
 
+    
+    StartupTimeline::beginPhase( "language" );
+    
+    // translation language
+    File *languageNameFile = new File( NULL, "language.txt" );
 
+    if( languageNameFile->exists() ) {
+        char *languageNameText = languageNameFile->readFileContents();
 
+        SimpleVector<char *> *tokens = tokenizeString( languageNameText );
 
+        int numTokens = tokens->size();
+        
+        // first token is name
+        if( numTokens > 0 ) {
+            char *languageName = *( tokens->getElement( 0 ) );
+        
+            TranslationManager::setLanguage( languageName, true );
 
-void setViewCenterPosition( float inX, float inY ) {
-    viewCenterX = inX;
-    viewCenterY = inY;
-    redoDrawMatrix();
-    }
+            // augment translation by adding other languages listed
+            // to fill in missing keys in top-line language
+            
+            for( int i=1; i<numTokens; i++ ) {
+                languageName = *( tokens->getElement( i ) );
+        
+                TranslationManager::setLanguage( languageName, false );
+                }
+            }
+        else {
+            // default
 
+            // TranslationManager already defaults to English, but
+            // it looks for the language files at runtime before we have set
+            // the current working directory.
+            
+            // Thus, we specify the default again here so that it looks
+            // for its language files again.
+            TranslationManager::setLanguage( "English", true );
+            }
+        
+        delete [] languageNameText;
 
+        for( int t=0; t<numTokens; t++ ) {
+            delete [] *( tokens->getElement( t ) );
+            }
+        delete tokens;
+        }
     
-doublePair getViewCenterPosition() {
-    doublePair p = { viewCenterX, viewCenterY };
+    delete languageNameFile;
     
-    return p;
-    }
-
-
-
-void setViewSize( float inSize ) {
-    AppLog::infoF( "setViewSize called with %f", inSize );
+    StartupTimeline::endPhase();
     
-    viewSize = inSize;
-    }
 
+    
+        
+    // register cleanup function, since screen->start() will never return
+    atexit( cleanUpAtExit );
 
-void setLetterbox( float inVisibleWidth, float inVisibleHeight ) {
-    visibleWidth = inVisibleWidth;
-    visibleHeight = inVisibleHeight;
 
-    AppLog::infoF( "setLetterbox called with %fx%f", 
-                   inVisibleWidth, inVisibleHeight );
-    redoDrawMatrix();
-    }
 
 
-void setCursorVisible( char inIsVisible ) {
-    if( inIsVisible ) {
-        SDL_ShowCursor( SDL_ENABLE );
-        }
-    else {
-        SDL_ShowCursor( SDL_DISABLE );
-        }
-    }
+    screen->switchTo2DMode();
 
 
 
-void setCursorMode( int inMode ) {
-    SettingsManager::setSetting( "cursorMode", inMode );
-    cursorMode = inMode;
+    StartupTimeline::beginPhase( "sound" );
     
-    switch( cursorMode ) {
-        case 0:
-        case 2:
-            setCursorVisible( true );
-            break;
-        case 1:
-            setCursorVisible( false );
-            break;
-        default:
-            setCursorVisible( true );
-            break;
-        }
-    }
+    if( getUsesSound() && ! headlessPlayback ) {
+        
+        soundSampleRate = 
+            SettingsManager::getIntSetting( "soundSampleRate", 22050 );
 
+        int requestedBufferSize = 
+            SettingsManager::getIntSetting( "soundBufferSize", 512 );
+        
+        // 1 second fade in/out
+        soundLoudnessIncrementPerSample = 1.0f / soundSampleRate;
 
-int getCursorMode() {
-    return cursorMode;
-    }
+        // force user-specified value to closest (round up) power of 2
+        int bufferSize = 2;
+        while( bufferSize < requestedBufferSize ) {
+            bufferSize *= 2;
+            }
+        
 
+        SDL_AudioSpec audioFormat;
 
+        /* Set 16-bit stereo audio at 22Khz */
+        audioFormat.freq = soundSampleRate;
+        audioFormat.format = AUDIO_S16;
+        
+#ifdef AUDIO_F32SYS
+        // SDL 2 can take float samples directly, which saves a conversion
+        // for games that make float samples
+        if( getSoundSamplesFloatFunction != NULL ) {
+            audioFormat.format = AUDIO_F32SYS;
+            }
+#endif
 
-void setEmulatedCursorScale( double inScale ) {
-    SettingsManager::setDoubleSetting( "emulatedCursorScale", inScale );
-    emulatedCursorScale = inScale;
-    }
+        audioFormat.channels = 2;
+        //audioFormat.samples = 512;        /* A good value for games */
+        audioFormat.samples = bufferSize;     
+        audioFormat.callback = audioCallback;
+        audioFormat.userdata = NULL;
+        
+        SDL_AudioSpec actualFormat;
+        
 
+        int recordAudioFlag = 
+            SettingsManager::getIntSetting( "recordAudio", 0 );
+        int recordAudioLengthInSeconds = 
+            SettingsManager::getIntSetting( "recordAudioLengthInSeconds", 0 );
 
-    
-double getEmulatedCursorScale() {
-    return emulatedCursorScale;
-    }
 
 
+        SDL_LockAudio();
+        
+        int openResult = 0;
+        
+        if( ! recordAudioFlag ) {
+            openResult = SDL_OpenAudio( &audioFormat, &actualFormat );
+            }
+        
 
 
-void grabInput( char inGrabOn ) {
-    if( inGrabOn ) {
-        SDL_WM_GrabInput( SDL_GRAB_ON );
-        }
-    else {
-        SDL_WM_GrabInput( SDL_GRAB_OFF );
-        }
-    }
+        /* Open the audio device and start playing sound! */
+        if( openResult < 0 ) {
+            AppLog::getLog()->logPrintf( 
+                Log::ERROR_LEVEL,
+                "Unable to open audio: %s\n", SDL_GetError() );
+            soundRunning = false;
+            soundOpen = false;
+            }
+        else {
 
+            char floatFormat = false;
+            
+#ifdef AUDIO_F32SYS
+            floatFormat = ( actualFormat.format == AUDIO_F32SYS );
+#endif
 
+            if( !recordAudioFlag && 
+                ( ( actualFormat.format != AUDIO_S16 && ! floatFormat ) ||
+                  actualFormat.channels != 2 ) ) {
+                
+                
+                AppLog::getLog()->logPrintf( 
+                    Log::ERROR_LEVEL,
+                    "Able to open audio, "
+                    "but stereo S16 samples not availabl\n");
+                
+                SDL_CloseAudio();
+                soundRunning = false;
+                soundOpen = false;
+                }
+            else {
+                
+                int desiredRate = soundSampleRate;
+                
+                if( !recordAudioFlag ) {    
+                    AppLog::getLog()->logPrintf( 
+                        Log::INFO_LEVEL,
+                        "Successfully opened audio: %dHz (requested %dHz), "
+                        "sample buffer size=%d (requested %d)\n", 
+                        actualFormat.freq, desiredRate, actualFormat.samples,
+                        bufferSize );
+                    
+                    soundOutputFloat = floatFormat;
+                    
+                    // tell game what their buffer size will be
+                    // so they can allocate it outside the callback
+                    // (in 16-bit bytes, even if device takes floats)
+                    hintBufferSize( actualFormat.samples * 4 );
+                    bufferSizeHinted = true;
+                    }
+                else {
+                    AppLog::getLog()->logPrintf( 
+                        Log::INFO_LEVEL,
+                        "Successfully faked opening of audio for "
+                        "recording to file: %dHz\n", desiredRate );
+                    // don't hint buffer size yet
+                    bufferSizeHinted = false;
+                    }
+                
 
-void setMouseReportingMode( char inWorldCoordinates ) {
-    mouseWorldCoordinates = inWorldCoordinates;
-    }
 
+                
+                soundSpriteNoClip =
+                    resetAudioNoClip( 
+                        ( 1.0 - soundSpriteCompressionFraction ) *
+                        maxTotalSoundSpriteVolume * 32767, 
+                        // half second hold and release
+                        soundSampleRate / 2, soundSampleRate / 2 );
 
+                totalAudioMixNoClip = 
+                    resetAudioNoClip( 32767.0,
+                                      // 10x faster hold and release
+                                      // for master mix
+                                      // pull music and sound effects down
+                                      // to prevent clipping, but bring
+                                      // it right back up again quickly
+                                      // after the transient passes to
+                                      // avoid audible pumping in music
+                                      soundSampleRate / 20, 
+                                      soundSampleRate / 20 );
 
-static int lastMouseX = 0;
-static int lastMouseY = 0;
-static int lastMouseDownX = 0;
-static int lastMouseDownY = 0;
+                totalAudioMixNoClipFloat = 
+                    resetAudioNoClip( 1.0,
+                                      soundSampleRate / 20, 
+                                      soundSampleRate / 20 );
 
-static char mouseDown = false;
-static char mouseRightDown = false;
-// start with last click expired
-static int mouseDownSteps = 1000;
-
-
-static char ignoreNextMouseEvent = false;
-static int xCoordToIgnore, yCoordToIgnore;
 
 
+                if( !recordAudioFlag ) {
+                    soundSampleRate = actualFormat.freq;
+                    
+                    soundSpriteMixingBufferL = 
+                        new float[ actualFormat.samples ];
+                    soundSpriteMixingBufferR = 
+                        new float[ actualFormat.samples ];
+                    
+                    soundMixingBufferL = new float[ actualFormat.samples ];
+                    soundMixingBufferR = new float[ actualFormat.samples ];
+                    }
+                
+                
+                soundRunning = true;
+                soundOpen = true;
+                
+                if( recordAudioFlag ) {
+                    soundOpen = false;
+                    }
 
-static void warpMouseToScreenPos( int inX, int inY ) {
-    if( inX == lastMouseX && inY == lastMouseY ) {
-        // mouse already there, no need to warp
-        // (and warping when already there may or may not generate
-        //  an event on some platforms, which causes trouble when we
-        //  try to ignore the event)
-        return;
-        }
+                if( recordAudioFlag == 1 && recordAudioLengthInSeconds > 0 ) {
+                    recordAudio = true;
+                    
+                    samplesLeftToRecord = 
+                        recordAudioLengthInSeconds * soundSampleRate;
 
-    if( SDL_GetAppState() & SDL_APPINPUTFOCUS ) {
+                    aiffOutFile = fopen( "recordedAudio.aiff", "wb" );
         
-        if( frameDrawerInited ) {
-            // not ignoring mouse events currently due to demo code panel
-            // or loading message... frame drawer not inited yet
-            ignoreNextMouseEvent = true;
-            xCoordToIgnore = inX;
-            yCoordToIgnore = inY;
-            }    
-
-        SDL_WarpMouse( inX, inY );
-        }
-    }
+                    int headerLength;
+                    
+                    unsigned char *header =
+                        getAIFFHeader( 2, 16,
+                                       soundSampleRate,
+                                       samplesLeftToRecord, 
+                                       &headerLength );
 
-    
+                    fwrite( header, 1, headerLength, aiffOutFile );
 
+                    delete [] header;
+                    }
 
-void warpMouseToCenter( int *outNewMouseX, int *outNewMouseY ) {
-    *outNewMouseX = screenWidth / 2;
-    *outNewMouseY = screenHeight / 2;
 
-    warpMouseToScreenPos( *outNewMouseX, *outNewMouseY );
-    }
 
+                }
+            }
 
+        SDL_UnlockAudio();        
+        }
+    
+    StartupTimeline::endPhase();
+    
 
-void warpMouseToWorldPos( float inX, float inY ) {
-    int worldX, worldY;
-    worldToScreen( inX, inY, &worldX, &worldY );
-    warpMouseToScreenPos( worldX, worldY );
-    }
 
+    
+    // may run steamGateClient
+    StartupTimeline::beginPhase( "demoCheck" );
 
+    if( ! writeFailed ) {    
+        demoMode = isDemoMode();
+        }
+    
+    StartupTimeline::endPhase();
+    
 
+    StartupTimeline::beginPhase( "fonts" );
+    
+    initDrawString( pixelZoomFactor * gameWidth, 
+                    pixelZoomFactor * gameHeight );
 
+    StartupTimeline::endPhase();
+        
 
-int numPixelsDrawn = 0;
-extern int totalLoadedTextureBytes;
+    
+    //glLineWidth( pixelZoomFactor );
+    
+    
+    if( demoMode ) {    
+        showDemoCodePanel( screen, getFontTGAFileName(), gameWidth,
+                           gameHeight );
+        
+        // wait to start handling events
+        // wait to start recording/playback
+        }
+    else if( writeFailed ) {
+        // handle key events right away to listen for ESC
+        screen->addKeyboardHandler( sceneHandler );
+        }
+    else {
+        // handle events right away
+        screen->addMouseHandler( sceneHandler );
+        screen->addKeyboardHandler( sceneHandler );
 
+        if( screen->isPlayingBack() ) {
+            
+            // start playback right away
+            screen->startRecordingOrPlayback();
+            
+            AppLog::infoF( "Using frame rate from recording file:  %d fps\n", 
+                           screen->getMaxFramerate() );
+            }
+        // else wait to start recording until after we've measured
+        // frame rate
+        }
+    
 
+    int readTarget = SettingsManager::getIntSetting( "targetFrameRate", -1 );
+    int readCounting = SettingsManager::getIntSetting( "countingOnVsync", -1 );
+    
+    if( readTarget != -1 && readCounting != -1 ) {
+        targetFrameRate = readTarget;
+        countingOnVsync = readCounting;
 
+        screen->setFullFrameRate( targetFrameRate );
+        screen->useFrameSleep( !countingOnVsync );
+        screen->startRecordingOrPlayback();
+        
+        if( screen->isPlayingBack() ) {
+            screen->useFrameSleep( true );
+            }
+        measureFrameRate = false;
+        }
+    
 
+    // default texture mode
+    glTexEnvf( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE );
 
-void saveFrameRateSettings() {
-    SettingsManager::setSetting( "targetFrameRate", targetFrameRate );
     
-    int settingValue = 0;
-    if( countingOnVsync ) {
-        settingValue = 1;
-        }
+    screen->start();
+
     
-    SettingsManager::setSetting( "countingOnVsync", settingValue );
+    return 0;
     }
 
 
 
 
-void GameSceneHandler::drawScene() {
-    numPixelsDrawn = 0;
-    /*
-    glClearColor( mBackgroundColor->r,
-                  mBackgroundColor->g,
-                  mBackgroundColor->b,
-                  mBackgroundColor->a );
-    */
+GameSceneHandler::GameSceneHandler( ScreenGL *inScreen )
+    : mScreen( inScreen ),
+      mPaused( false ),
+      mPausedDuringFrameBatch( true ),
+      mLoadingDuringFrameBatch( true ),
+      mPausedSleepTime( 0 ),
+      mBlockQuitting( false ),
+      mLastFrameRate( targetFrameRate ),
+      mStartTimeSeconds( Time::timeSec() ),
+      mPrintFrameRate( true ),
+      mNumFrames( 0 ), mFrameBatchSize( 100 ),
+      mFrameBatchStartTimeSeconds( -1 ),
+      mBackgroundColor( 0, 0, 0, 1 ) { 
+    
+    
+    glClearColor( mBackgroundColor.r,
+                  mBackgroundColor.g,
+                  mBackgroundColor.b,
+                  mBackgroundColor.a );
+    
+
+    // set external pointer so it can be used in calls below
+    sceneHandler = this;
 
+        
+    mScreen->addSceneHandler( sceneHandler );
+    mScreen->addRedrawListener( sceneHandler );
+    }
 
 
 
-    // do this here, because it involves game_getCurrentTime() calls
-    // which are recorded, and aren't available for playback in fireRedraw
-    mNumFrames ++;
+GameSceneHandler::~GameSceneHandler() {
+    mScreen->removeMouseHandler( this );
+    mScreen->removeSceneHandler( this );
+    mScreen->removeRedrawListener( this );
 
-    if( mPrintFrameRate ) {
+    if( demoMode ) {
+        // panel has not freed itself yet
+        freeDemoCodePanel();
         
-        if( mFrameBatchStartTimeSeconds == -1 ) {
-            mFrameBatchStartTimeSeconds = game_getCurrentTime();
-            }
+        demoMode = false;
+        }
 
-        if( mNumFrames % mFrameBatchSize == 0 ) {
-            // finished a batch
-            
-            double timeDelta = 
-                game_getCurrentTime() - mFrameBatchStartTimeSeconds;
-            
-            double actualFrameRate =
-                (double)mFrameBatchSize / (double)timeDelta;
-            
-            //AppLog::getLog()->logPrintf( 
-            //    Log::DETAIL_LEVEL,
-            printf(
-                "Frame rate = %f frames/second\n", actualFrameRate );
-            
-            mFrameBatchStartTimeSeconds = game_getCurrentTime();
 
-            // don't update reported framerate if this batch involved a pause
-            // or if still loading
-            if( !mPausedDuringFrameBatch && !mLoadingDuringFrameBatch ) {
-                mLastFrameRate = actualFrameRate;
-                }
-            else {
-                // consider measuring next frame batch
-                // (unless a pause or loading occurs there too)
-                mPausedDuringFrameBatch = false;
-                mLoadingDuringFrameBatch = false;
-                }
-            }
+    if( loadingFailedMessage != NULL ) {
+        delete [] loadingFailedMessage;
+        loadingFailedMessage = NULL;
         }
     
+    
+    }
 
 
-	
 
-    redoDrawMatrix();
 
+void GameSceneHandler::initFromFiles() {
+    
+    }
 
-	glDisable( GL_CULL_FACE );
-    glDisable( GL_DEPTH_TEST );
 
 
-    if( demoMode ) {
-        
-        if( ! isDemoCodePanelShowing() ) {
-            
-            // stop demo mode when panel done
-            demoMode = false;
 
-            mScreen->addMouseHandler( this );
-            mScreen->addKeyboardHandler( this );
+static float viewCenterX = 0;
+static float viewCenterY = 0;
+// default -1 to +1
+static float viewSize = 2;
 
-            screen->startRecordingOrPlayback();
-            }
-        }
-    else if( writeFailed ) {
-        drawString( translate( "writeFailed" ), true );
-        }
-    else if( !screen->isPlayingBack() && measureFrameRate ) {
-        if( !measureRecorded ) {
-            screen->useFrameSleep( false );
+static float visibleWidth = -1;
+static float visibleHeight = -1;
+
+
+static void redoDrawMatrix() {
+    // viewport square centered on screen (even if screen is rectangle)
+    float hRadius = viewSize / 2;
+    
+    float wRadius = hRadius;
+    
+    if( visibleHeight > 0 ) {
+        wRadius = visibleWidth / 2;
+        hRadius = visibleHeight / 2;
+        }
+    
+
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    glOrtho( viewCenterX - wRadius, viewCenterX + wRadius, 
+             viewCenterY - hRadius, viewCenterY + hRadius, -1.0f, 1.0f);
+    
+    setVisibleWorldRect( viewCenterX - wRadius, viewCenterY - hRadius,
+                         viewCenterX + wRadius, viewCenterY + hRadius );
+    
+    if( visibleHeight > 0 ) {
+        
+        float portWide = screenWidth;
+        float portHigh = ( visibleHeight / visibleWidth ) * portWide;
+        
+        float screenHeightFraction = (float) screenHeight / (float) screenWidth;
+        
+        if( screenHeightFraction < 9.0 / 16.0 ) {
+            // wider than 16:9
+
+            // fill vertically instead
+            portHigh = screenHeight;
+            
+            portWide = ( visibleWidth / visibleHeight ) * portHigh;
+            }
+        
+        float excessW = screenWidth - portWide;
+        float excessH = screenHeight - portHigh;
+    
+        glViewport( excessW / 2,
+                    excessH / 2, 
+                    portWide,
+                    portHigh );    
+        }
+    
+    glMatrixMode(GL_MODELVIEW);
+    }
+
+
+
+unsigned int getRandSeed() {
+    return screen->getRandSeed();
+    }
+
+
+
+void pauseGame() {
+    sceneHandler->mPaused = !( sceneHandler->mPaused );
+    }
+
+
+char isPaused() {
+    return sceneHandler->mPaused;
+    }
+
+
+
+void blockQuitting( char inNoQuitting ) {
+    sceneHandler->mBlockQuitting = inNoQuitting;
+    }
+
+
+
+char isQuittingBlocked() {
+    return sceneHandler->mBlockQuitting;
+    }
+
+
+
+void wakeUpPauseFrameRate() {
+    sceneHandler->mPausedSleepTime = 0;
+    }
+
+
+// returns true if we're currently executing a recorded game
+char isGamePlayingBack() {
+    return screen->isPlayingBack();
+    }
+
+
+
+
+
+
+
+void mapKey( unsigned char inFromKey, unsigned char inToKey ) {
+    screen->setKeyMapping( inFromKey, inToKey );
+    }
+
+
+void toggleKeyMapping( char inMappingOn ) {
+    screen->toggleKeyMapping( inMappingOn );
+    }
+
+
+
+
+
+void setViewCenterPosition( float inX, float inY ) {
+    viewCenterX = inX;
+    viewCenterY = inY;
+    redoDrawMatrix();
+    }
+
+
+    
+doublePair getViewCenterPosition() {
+    doublePair p = { viewCenterX, viewCenterY };
+    
+    return p;
+    }
+
+
+
+void setViewSize( float inSize ) {
+    AppLog::infoF( "setViewSize called with %f", inSize );
+    
+    viewSize = inSize;
+    }
+
+
+void setLetterbox( float inVisibleWidth, float inVisibleHeight ) {
+    visibleWidth = inVisibleWidth;
+    visibleHeight = inVisibleHeight;
+
+    AppLog::infoF( "setLetterbox called with %fx%f", 
+                   inVisibleWidth, inVisibleHeight );
+    redoDrawMatrix();
+    }
+
+
+void setCursorVisible( char inIsVisible ) {
+    if( inIsVisible ) {
+        SDL_ShowCursor( SDL_ENABLE );
+        }
+    else {
+        SDL_ShowCursor( SDL_DISABLE );
+        }
+    }
+
+
+
+void setCursorMode( int inMode ) {
+    SettingsManager::setSetting( "cursorMode", inMode );
+    cursorMode = inMode;
+    
+    switch( cursorMode ) {
+        case 0:
+        case 2:
+            setCursorVisible( true );
+            break;
+        case 1:
+            setCursorVisible( false );
+            break;
+        default:
+            setCursorVisible( true );
+            break;
+        }
+    }
+
+
+int getCursorMode() {
+    return cursorMode;
+    }
+
+
+
+void setEmulatedCursorScale( double inScale ) {
+    SettingsManager::setDoubleSetting( "emulatedCursorScale", inScale );
+    emulatedCursorScale = inScale;
+    }
+
+
+    
+double getEmulatedCursorScale() {
+    return emulatedCursorScale;
+    }
+
+
+
+
+void grabInput( char inGrabOn ) {
+    if( inGrabOn ) {
+        SDL_WM_GrabInput( SDL_GRAB_ON );
+        }
+    else {
+        SDL_WM_GrabInput( SDL_GRAB_OFF );
+        }
+    }
+
+
+
+void setMouseReportingMode( char inWorldCoordinates ) {
+    mouseWorldCoordinates = inWorldCoordinates;
+    }
+
+
+
+static int lastMouseX = 0;
+static int lastMouseY = 0;
+static int lastMouseDownX = 0;
+static int lastMouseDownY = 0;
+
+static char mouseDown = false;
+static char mouseRightDown = false;
+// start with last click expired
+static int mouseDownSteps = 1000;
+
+
+static char ignoreNextMouseEvent = false;
+static int xCoordToIgnore, yCoordToIgnore;
+
+
+
+static void warpMouseToScreenPos( int inX, int inY ) {
+    if( inX == lastMouseX && inY == lastMouseY ) {
+        // mouse already there, no need to warp
+        // (and warping when already there may or may not generate
+        //  an event on some platforms, which causes trouble when we
+        //  try to ignore the event)
+        return;
+        }
+
+    if( SDL_GetAppState() & SDL_APPINPUTFOCUS ) {
+        
+        if( frameDrawerInited ) {
+            // not ignoring mouse events currently due to demo code panel
+            // or loading message... frame drawer not inited yet
+            ignoreNextMouseEvent = true;
+            xCoordToIgnore = inX;
+            yCoordToIgnore = inY;
+            }    
+
+        SDL_WarpMouse( inX, inY );
+        }
+    }
+
+    
+
+
+void warpMouseToCenter( int *outNewMouseX, int *outNewMouseY ) {
+    *outNewMouseX = screenWidth / 2;
+    *outNewMouseY = screenHeight / 2;
+
+    warpMouseToScreenPos( *outNewMouseX, *outNewMouseY );
+    }
+
+
+
+void warpMouseToWorldPos( float inX, float inY ) {
+    int worldX, worldY;
+    worldToScreen( inX, inY, &worldX, &worldY );
+    warpMouseToScreenPos( worldX, worldY );
+    }
+
+
+
+
+
+int numPixelsDrawn = 0;
+extern int totalLoadedTextureBytes;
+
+
+
+// stats overlay, drawn over everything when toggled by F3
+// main thread only, except where noted near audioCallback
+
+// window for frame time graph and percentiles
+#define STATS_OVERLAY_FRAMES 240
+
+// graph is this many pixels high, and goes to this many ms
+#define STATS_OVERLAY_GRAPH_HEIGHT 64
+#define STATS_OVERLAY_GRAPH_MS 50.0
+
+// text line height and fixed character width in pixels
+#define STATS_OVERLAY_LINE_HEIGHT 14
+#define STATS_OVERLAY_CHAR_WIDTH 9
+
+// ms between start of frame and start of next
+static float statsOverlayFrameTimes[ STATS_OVERLAY_FRAMES ];
+// slowest audio callback in each frame, in ms
+static float statsOverlayAudioTimes[ STATS_OVERLAY_FRAMES ];
+
+static int statsOverlayNumFrames = 0;
+static int statsOverlayNextFrame = 0;
+
+static double statsOverlayLastFrameStartTime = -1;
+
+// totals at start of last frame
+static double statsOverlayLastSpritesTotal = 0;
+static double statsOverlayLastCulledTotal = 0;
+static int statsOverlayLastBatchesTotal = 0;
+static double statsOverlayLastStateCallsTotal = 0;
+static double statsOverlayLastStateSkipsTotal = 0;
+
+// for last full frame
+static int statsOverlayFrameSprites = 0;
+static int statsOverlayFrameCulled = 0;
+static int statsOverlayFrameBatches = 0;
+static int statsOverlayFrameStateCalls = 0;
+static int statsOverlayFrameStateSkips = 0;
+
+// ms, main thread time spent drawing overlay in previous frame
+static double statsOverlayDrawTime = 0;
+
+// loaded first time overlay shown
+// TextGL, as in demo code panel, since Font can't be used here (it
+// collides with X11's Font type)
+// no text on Raspbian, where TextGL isn't available
+#ifndef RASPBIAN
+static TextGL *statsOverlayText = NULL;
+#endif
+
+
+
+static void freeStatsOverlay() {
+    #ifndef RASPBIAN
+    if( statsOverlayText != NULL ) {
+        delete statsOverlayText;
+        statsOverlayText = NULL;
+        }
+    #endif
+    }
+
+
+
+static void toggleStatsOverlay() {
+    statsOverlayShowing = ! statsOverlayShowing;
+
+    // start fresh, so window never spans time spent hidden
+    statsOverlayNumFrames = 0;
+    statsOverlayNextFrame = 0;
+    statsOverlayLastFrameStartTime = -1;
+    statsOverlayDrawTime = 0;
+    }
+
+
+
+// decides how many fixed updates the coming drawFrame should do
+// time comes from game_getCurrentTime, which is recorded, so the same
+// updates happen on the same frames during playback
+static void stepFixedUpdates( char inUpdate ) {
+    if( fixedUpdateRate <= 0 ) {
+        numUpdatesThisFrame = inUpdate ? 1 : 0;
+        updateInterpolation = 1;
+        return;
+        }
+    
+    // always fetch, so recorded time values line up on playback
+    double now = game_getCurrentTime();
+    
+    if( ! inUpdate || lastUpdateClockTime == -1 ) {
+        // paused time doesn't count toward updates
+        lastUpdateClockTime = now;
+        numUpdatesThisFrame = 0;
+        return;
+        }
+    
+    double delta = now - lastUpdateClockTime;
+    lastUpdateClockTime = now;
+    
+    // system clock can jump backwards
+    if( delta < 0 ) {
+        delta = 0;
+        }
+    
+    double updatePeriod = 1.0 / fixedUpdateRate;
+    
+    updateTimeAccumulator += delta;
+    
+    numUpdatesThisFrame = (int)( updateTimeAccumulator / updatePeriod );
+    
+    if( numUpdatesThisFrame > MAX_UPDATES_PER_FRAME ) {
+        numUpdatesThisFrame = MAX_UPDATES_PER_FRAME;
+        // drop the rest
+        updateTimeAccumulator = numUpdatesThisFrame * updatePeriod;
+        }
+    
+    updateTimeAccumulator -= numUpdatesThisFrame * updatePeriod;
+    
+    updateInterpolation = updateTimeAccumulator / updatePeriod;
+    
+    if( updateInterpolation >= 1 ) {
+        // rounding
+        updateInterpolation = 0.999999;
+        }
+    }
+
+
+
+// called at start of each frame while showing
+static void sampleStatsOverlayFrame() {
+    double now = Time::getCurrentTime();
+    
+    double spritesTotal = getTotalSpritesDrawn();
+    double culledTotal = getTotalSpritesCulled();
+    int batchesTotal = getTotalSpriteBatchesDrawn();
+    double stateCallsTotal = getTotalGLStateCallsIssued();
+    double stateSkipsTotal = getTotalGLStateCallsSkipped();
+    
+    if( statsOverlayLastFrameStartTime != -1 ) {
+        
+        statsOverlayFrameTimes[ statsOverlayNextFrame ] =
+            (float)( 1000 * ( now - statsOverlayLastFrameStartTime ) );
+        
+        int audioMaxMicros = audioCallbackMaxMicros;
+        audioCallbackMaxMicros = 0;
+        
+        statsOverlayAudioTimes[ statsOverlayNextFrame ] =
+            audioMaxMicros / 1000.0f;
+        
+        statsOverlayNextFrame = 
+            ( statsOverlayNextFrame + 1 ) % STATS_OVERLAY_FRAMES;
+        
+        if( statsOverlayNumFrames < STATS_OVERLAY_FRAMES ) {
+            statsOverlayNumFrames++;
+            }
+
+        statsOverlayFrameSprites = 
+            (int)( spritesTotal - statsOverlayLastSpritesTotal );
+        statsOverlayFrameCulled = 
+            (int)( culledTotal - statsOverlayLastCulledTotal );
+        statsOverlayFrameBatches = 
+            batchesTotal - statsOverlayLastBatchesTotal;
+        statsOverlayFrameStateCalls =
+            (int)( stateCallsTotal - statsOverlayLastStateCallsTotal );
+        statsOverlayFrameStateSkips =
+            (int)( stateSkipsTotal - statsOverlayLastStateSkipsTotal );
+        }
+    
+    else {
+        // drop any callbacks timed before this window
+        audioCallbackMaxMicros = 0;
+        }
+    
+    statsOverlayLastFrameStartTime = now;
+    statsOverlayLastSpritesTotal = spritesTotal;
+    statsOverlayLastCulledTotal = culledTotal;
+    statsOverlayLastBatchesTotal = batchesTotal;
+    statsOverlayLastStateCallsTotal = stateCallsTotal;
+    statsOverlayLastStateSkipsTotal = stateSkipsTotal;
+    }
+
+
+
+// inValues sorted in place
+static float getPercentile( float *inValues, int inNumValues, 
+                            double inFraction ) {
+    // insertion sort, fine for a few hundred mostly similar values
+    for( int i=1; i<inNumValues; i++ ) {
+        float v = inValues[i];
+        
+        int j = i - 1;
+        while( j >= 0 && inValues[j] > v ) {
+            inValues[ j + 1 ] = inValues[j];
+            j--;
+            }
+        inValues[ j + 1 ] = v;
+        }
+    
+    int index = (int)( inFraction * ( inNumValues - 1 ) + 0.5 );
+    
+    return inValues[ index ];
+    }
+
+
+
+static int countOutstandingAsyncFiles() {
+    asyncLock.lockRead();
+    
+    int count = asyncFileTable.size() - ( asyncFilesDoneThrough + 1 );
+    
+    asyncLock.unlockRead();
+    
+    return count;
+    }
+
+
+
+// draws in screen pixels, with origin at lower left
+// leaves projection as it found it
+static void drawStatsOverlay() {
+    PROFILE_ZONE( "statsOverlay" );
+
+    double startTime = Time::getCurrentTime();
+    
+    #ifndef RASPBIAN
+    if( statsOverlayText == NULL ) {
+        Image *fontImage = readTGAFile( getFontTGAFileName() );
+        
+        if( fontImage == NULL ) {
+            // blank font
+            fontImage = new Image( 256, 512, 4, true );
+            }
+        
+        statsOverlayText = new TextGL( fontImage, true, true, 0, 1.0 );
+        
+        delete fontImage;
+        }
+    #endif
+    
+
+    // direct GL calls below
+    flushSpriteBatch();
+    
+    GLint oldViewport[4];
+    glGetIntegerv( GL_VIEWPORT, oldViewport );
+    
+    glMatrixMode( GL_PROJECTION );
+    glPushMatrix();
+    glLoadIdentity();
+    glOrtho( 0, screenWidth, 0, screenHeight, -1.0f, 1.0f );
+    
+    glViewport( 0, 0, screenWidth, screenHeight );
+
+    glMatrixMode( GL_MODELVIEW );
+    glPushMatrix();
+    glLoadIdentity();
+    
+
+    int numFrames = statsOverlayNumFrames;
+
+    float sorted[ STATS_OVERLAY_FRAMES ];
+    
+    float p50 = 0;
+    float p99 = 0;
+    float audioMax = 0;
+    
+    for( int i=0; i<numFrames; i++ ) {
+        sorted[i] = statsOverlayFrameTimes[i];
+        
+        if( statsOverlayAudioTimes[i] > audioMax ) {
+            audioMax = statsOverlayAudioTimes[i];
+            }
+        }
+    
+    if( numFrames > 0 ) {
+        p50 = getPercentile( sorted, numFrames, 0.5 );
+        p99 = getPercentile( sorted, numFrames, 0.99 );
+        }
+    
+
+    int numLines = 6;
+
+    double top = screenHeight - 8;
+    double left = 8;
+    // wide enough for graph and longest line
+    double width = 2 * STATS_OVERLAY_FRAMES;
+    double textBottom = top - numLines * STATS_OVERLAY_LINE_HEIGHT;
+    double graphBottom = textBottom - 4 - STATS_OVERLAY_GRAPH_HEIGHT;
+    
+
+    // backing panel
+    setDrawColor( 0, 0, 0, 0.6 );
+    drawRect( left - 4, graphBottom - 4, left + width + 4, top + 4 );
+    
+
+    // frame time bars, oldest on left, all in two draw calls
+    double msScale = STATS_OVERLAY_GRAPH_HEIGHT / STATS_OVERLAY_GRAPH_MS;
+    double targetMS = 1000.0 / targetFrameRate;
+
+    double overVerts[ STATS_OVERLAY_FRAMES * 8 ];
+    double underVerts[ STATS_OVERLAY_FRAMES * 8 ];
+    int numOver = 0;
+    int numUnder = 0;
+
+    int oldest = statsOverlayNextFrame - numFrames;
+    if( oldest < 0 ) {
+        oldest += STATS_OVERLAY_FRAMES;
+        }
+    
+    for( int i=0; i<numFrames; i++ ) {
+        float ms = 
+            statsOverlayFrameTimes[ ( oldest + i ) % STATS_OVERLAY_FRAMES ];
+        
+        double barTop = graphBottom + msScale * ms;
+        if( barTop > textBottom - 4 ) {
+            barTop = textBottom - 4;
+            }
+        
+        double x = left + width - 2 * ( numFrames - i );
+        
+        double *v;
+        // 10% grace, since frame times jitter around target
+        if( ms > targetMS * 1.1 ) {
+            v = &( overVerts[ 8 * numOver ] );
+            numOver++;
+            }
+        else {
+            v = &( underVerts[ 8 * numUnder ] );
+            numUnder++;
+            }
+        
+        v[0] = x;     v[1] = graphBottom;
+        v[2] = x;     v[3] = barTop;
+        v[4] = x + 2; v[5] = barTop;
+        v[6] = x + 2; v[7] = graphBottom;
+        }
+    
+    setDrawColor( 0, 1, 0, 0.8 );
+    if( numUnder > 0 ) {
+        drawQuads( numUnder, underVerts );
+        }
+    setDrawColor( 1, 0, 0, 0.8 );
+    if( numOver > 0 ) {
+        drawQuads( numOver, overVerts );
+        }
+    
+    // target frame time line
+    double targetY = graphBottom + msScale * targetMS;
+    setDrawColor( 1, 1, 1, 0.5 );
+    drawRect( left, targetY, left + width, targetY + 1 );
+    
+
+    // text
+    // frame arena strings, not destroyed here
+    char *lines[6];
+    
+    // spread of present-to-present times, as paced by screen
+    double presentMean, presentStdDev;
+    screen->getFrameTimeStats( &presentMean, &presentStdDev );
+    
+    // time blocked in swap, waiting on vsync or queued frames
+    double swapMean, swapMax;
+    screen->getSwapTimeStats( &swapMean, &swapMax );
+    
+    lines[0] = frameSprintf( "frame p50 %.1f ms  p99 %.1f ms  sd %.2f ms  "
+                             "swap %.1f ms  max %.1f ms",
+                            p50, p99, 1000 * presentStdDev,
+                            1000 * swapMean, 1000 * swapMax );
+    lines[1] = frameSprintf( 
+        "sprites %d  culled %d  batches %d  overlay %.2f ms",
+        statsOverlayFrameSprites, 
+        statsOverlayFrameCulled,
+        statsOverlayFrameBatches,
+        statsOverlayDrawTime );
+    int residentBytes = getResidentSpriteTextureBytes();
+    
+    int numSharingChecks, numShared, sharedBytes;
+    getSpriteTextureSharingStats( &numSharingChecks, &numShared,
+                                  &sharedBytes );
+    
+    if( residentBytes > 0 ) {
+        // budget set
+        lines[2] = frameSprintf( 
+            "textures %.1f MiB  resident %.1f MiB  evicted %d  "
+            "shared %d/%d",
+            totalLoadedTextureBytes / ( 1024.0 * 1024.0 ),
+            residentBytes / ( 1024.0 * 1024.0 ),
+            getNumSpriteTextureEvictions(),
+            numShared, numSharingChecks );
+        }
+    else {
+        lines[2] = frameSprintf( "textures %.1f MiB  shared %d/%d "
+                                 "(%.1f MiB saved)",
+                                 totalLoadedTextureBytes / 
+                                 ( 1024.0 * 1024.0 ),
+                                 numShared, numSharingChecks,
+                                 sharedBytes / ( 1024.0 * 1024.0 ) );
+        }
+    lines[3] = frameSprintf( "audio %.2f ms  max %.2f ms",
+                            audioCallbackMicros / 1000.0, audioMax );
+    lines[4] = frameSprintf( "web %d  sockets %d  async files %d",
+                            webRequestRecords.size(),
+                            socketConnectionRecords.size() +
+                            pendingSocketConnects.size(),
+                            countOutstandingAsyncFiles() );
+    lines[5] = frameSprintf( "gl state calls %d  skipped %d",
+                            statsOverlayFrameStateCalls,
+                            statsOverlayFrameStateSkips );
+    
+    for( int i=0; i<numLines; i++ ) {
+        #ifndef RASPBIAN
+        int numChars = strlen( lines[i] );
+        
+        statsOverlayText->drawText( 
+            lines[i],
+            left, top - ( i + 1 ) * STATS_OVERLAY_LINE_HEIGHT,
+            numChars * STATS_OVERLAY_CHAR_WIDTH,
+            STATS_OVERLAY_LINE_HEIGHT - 2 );
+        #endif
+        }
+    
+    // TextGL leaves its own color and blend set
+    invalidateGLStateCache();
+    setDrawColor( 1, 1, 1, 1 );
+    
+
+    glPopMatrix();
+
+    glMatrixMode( GL_PROJECTION );
+    glPopMatrix();
+
+    glViewport( oldViewport[0], oldViewport[1], 
+                oldViewport[2], oldViewport[3] );
+    
+    glMatrixMode( GL_MODELVIEW );
+    
+    statsOverlayDrawTime = 1000 * ( Time::getCurrentTime() - startTime );
+    }
+
+
+
+
+
+void saveFrameRateSettings() {
+    SettingsManager::setSetting( "targetFrameRate", targetFrameRate );
+    
+    int settingValue = 0;
+    if( countingOnVsync ) {
+        settingValue = 1;
+        }
+    
+    SettingsManager::setSetting( "countingOnVsync", settingValue );
+    }
+
+
+
+
+void GameSceneHandler::drawScene() {
+    PROFILE_FRAME();
+    PROFILE_ZONE( "drawScene" );
+
+    if( statsOverlayShowing ) {
+        sampleStatsOverlayFrame();
+        }
+
+    numPixelsDrawn = 0;
+
+    // upload any sprites that finished loading in the background
+    stepAsyncSpriteLoading();
+    
+    // and decode any sound sprites prefetched in the background
+    stepSoundSpritePrefetches();
+    /*
+    glClearColor( mBackgroundColor->r,
+                  mBackgroundColor->g,
+                  mBackgroundColor->b,
+                  mBackgroundColor->a );
+    */
+
+
+
+
+    // do this here, because it involves game_getCurrentTime() calls
+    // which are recorded, and aren't available for playback in fireRedraw
+    mNumFrames ++;
+
+    if( mPrintFrameRate ) {
+        
+        if( mFrameBatchStartTimeSeconds == -1 ) {
+            mFrameBatchStartTimeSeconds = game_getCurrentTime();
+            }
+
+        if( mNumFrames % mFrameBatchSize == 0 ) {
+            // finished a batch
+            
+            double timeDelta = 
+                game_getCurrentTime() - mFrameBatchStartTimeSeconds;
+            
+            double actualFrameRate =
+                (double)mFrameBatchSize / (double)timeDelta;
+            
+            //AppLog::getLog()->logPrintf( 
+            //    Log::DETAIL_LEVEL,
+            printf(
+                "Frame rate = %f frames/second\n", actualFrameRate );
+            
+            mFrameBatchStartTimeSeconds = game_getCurrentTime();
+
+            // don't update reported framerate if this batch involved a pause
+            // or if still loading
+            if( !mPausedDuringFrameBatch && !mLoadingDuringFrameBatch ) {
+                mLastFrameRate = actualFrameRate;
+                }
+            else {
+                // consider measuring next frame batch
+                // (unless a pause or loading occurs there too)
+                mPausedDuringFrameBatch = false;
+                mLoadingDuringFrameBatch = false;
+                }
+            }
+        }
+    
+
+
+	
+
+    redoDrawMatrix();
+
+
+	glDisable( GL_CULL_FACE );
+    glDisable( GL_DEPTH_TEST );
+
+
+    if( demoMode ) {
+        
+        if( ! isDemoCodePanelShowing() ) {
+            
+            // stop demo mode when panel done
+            demoMode = false;
+
+            mScreen->addMouseHandler( this );
+            mScreen->addKeyboardHandler( this );
+
+            screen->startRecordingOrPlayback();
+            }
+        }
+    else if( writeFailed ) {
+        drawString( translate( "writeFailed" ), true );
+        }
+    else if( !screen->isPlayingBack() && measureFrameRate ) {
+        if( !measureRecorded ) {
+            screen->useFrameSleep( false );
+            }
+        
+
+        if( numFramesSkippedBeforeMeasure < numFramesToSkipBeforeMeasure ) {
+            numFramesSkippedBeforeMeasure++;
+            
+            drawString( translate( "measuringFPS" ), true );
+            }
+        else if( ! startMeasureTimeRecorded ) {
+            startMeasureTime = Time::getCurrentTime();
+            startMeasureTimeRecorded = true;
+
+            drawString( translate( "measuringFPS" ), true );
+            }
+        else {
+
+            numFramesMeasured++;
+            
+            double totalTime = Time::getCurrentTime() - startMeasureTime;
+
+            double timePerFrame = totalTime / ( numFramesMeasured );
+            
+            double frameRate = 1 / timePerFrame;
+
+
+            int closestTargetFrameRate = 0;
+            double closestFPSDiff = 9999999;
+            
+            for( int i=0; i<possibleFrameRates.size(); i++ ) {
+                
+                int v = possibleFrameRates.getElementDirect( i );
+                
+                double diff = fabs( frameRate - v );
+                
+                if( diff < closestFPSDiff ) {
+                    closestTargetFrameRate = v;
+                    closestFPSDiff = diff;
+                    }
+                }
+                
+            double overAllowFactor = 1.05;
+            
+
+
+            if( numFramesMeasured > 10 && 
+                frameRate > overAllowFactor * closestTargetFrameRate ) {
+
+                secondsToMeasure = warningSecondsToMeasure;
+                }
+            else {
+                secondsToMeasure = noWarningSecondsToMeasure;
+                }
+            
+            if( totalTime <= secondsToMeasure ) {    
+                char *message = frameSprintf( "%s\n%0.2f\nFPS",
+                                              translate( "measuringFPS" ),
+                                              frameRate );
+                
+                
+                drawString( message, true );
+                }
+            
+            if( totalTime > secondsToMeasure ) {
+                
+                if( ! measureRecorded ) {
+                    
+                    if( targetFrameRate == idealTargetFrameRate ) {
+                        // not invoking halfFrameRate
+
+                        AppLog::infoF( "Measured frame rate = %f fps\n", 
+                                       frameRate );
+                        AppLog::infoF( 
+                            "Closest possible frame rate = %d fps\n", 
+                            closestTargetFrameRate );                
+                        
+                        if( frameRate > 
+                            overAllowFactor * closestTargetFrameRate ) {
+                            
+                            AppLog::infoF( 
+                                "Vsync to enforce closested frame rate of "
+                                "%d fps doesn't seem to be in effect.\n", 
+                                closestTargetFrameRate );
+                    
+                            AppLog::infoF( 
+                                "Will sleep each frame to enforce desired "
+                                "frame rate of %d fps\n",
+                                idealTargetFrameRate );
+                            
+                            targetFrameRate = idealTargetFrameRate;
+                            
+                            screen->useFrameSleep( true );
+                            countingOnVsync = false;
+                            }
+                        else {
+                            AppLog::infoF( 
+                                "Vsync seems to be enforcing an allowed frame "
+                                "rate of %d fps.\n", closestTargetFrameRate );
+                            
+                            targetFrameRate = closestTargetFrameRate;
+                            
+                            screen->useFrameSleep( false );
+                            countingOnVsync = true;
+                            }
+                        }
+                    else {
+                        // half frame rate must be set
+                        
+                        AppLog::infoF( 
+                            "User has halfFrameRate set, so we're going "
+                        "to manually sleep to enforce a target "
+                            "frame rate of %d fps.\n", targetFrameRate );
+                        screen->useFrameSleep( true );
+                        countingOnVsync = false;
+                        }
+                
+                
+                    screen->setFullFrameRate( targetFrameRate );
+                    measureRecorded = true;
+                    }
+                
+                if( !countingOnVsync ) {
+                    // show warning message
+                    char *message = 
+                        autoSprintf( "%s\n%s\n\n%s\n\n\n%s",
+                                     translate( "vsyncWarning" ),
+                                     translate( "vsyncWarning2" ),
+                                     translate( "vsyncWarning3" ),
+                                     translate( "vsyncContinueMessage" ) );
+                    drawString( message, true );
+                
+                    delete [] message;
+                    }
+                else {
+                    // auto-save it now
+                    saveFrameRateSettings();
+                    screen->startRecordingOrPlayback();
+                    measureFrameRate = false;
+                    }
+                }
+            }
+
+        FrameArena::getThreadArena()->reset();
+        return;
+        }
+    else if( !loadingMessageShown ) {
+        drawString( translate( "loading" ), true );
+
+        loadingMessageShown = true;
+        }
+    else if( loadingFailedFlag ) {
+        drawString( loadingFailedMessage, true );
+        }
+    else if( !writeFailed && !loadingFailedFlag && !frameDrawerInited ) {
+        drawString( translate( "loading" ), true );
+
+        // where game loads its fonts and sprites
+        StartupTimeline::beginPhase( "initFrameDrawer" );
+        
+        initFrameDrawer( pixelZoomFactor * gameWidth, 
+                         pixelZoomFactor * gameHeight, 
+                         targetFrameRate,
+                         screen->getCustomRecordedGameData(),
+                         screen->isPlayingBack() );
+        
+        StartupTimeline::endPhase();
+        
+        int readCursorMode = SettingsManager::getIntSetting( "cursorMode", -1 );
+        
+
+        if( readCursorMode < 0 ) {
+            // never set before
+
+            // check if we are ultrawidescreen
+            char ultraWide = false;
+            
+            const SDL_VideoInfo* currentScreenInfo = SDL_GetVideoInfo();
+        
+            int currentW = currentScreenInfo->current_w;
+            int currentH = currentScreenInfo->current_h;
+
+            double aspectRatio = (double)currentW / (double)currentH;
+            
+            // give a little wiggle room above 16:9
+            // ultrawide starts at 21:9
+            if( aspectRatio > 18.0 / 9.0 ) {
+                ultraWide = true;
+                }
+
+            // we no longer do this, because ultrawide cursor placement
+            // issues have been fixed, allowing ultrawide monitors to use
+            // native cursor by default
+            if( false && ultraWide ) {
+                // drawn cursor, because system native cursor
+                // is off-target on ultrawide displays
+                
+                setCursorMode( 1 );
+                
+                double startingScale = 1.0;
+                
+                int forceBigPointer = 
+                    SettingsManager::getIntSetting( "forceBigPointer", 0 );
+                if( forceBigPointer ||
+                    screenWidth > 1920 || screenHeight > 1080 ) {
+                    
+                    startingScale *= 2;
+                    }
+                setEmulatedCursorScale( startingScale );
+                }
+            }
+        else {
+            setCursorMode( readCursorMode );
+
+            double readCursorScale = 
+                SettingsManager::
+                getDoubleSetting( "emulatedCursorScale", -1.0 );
+            
+            if( readCursorScale >= 1 ) {
+                setEmulatedCursorScale( readCursorScale );
+                }
+            }
+        
+
+
+        frameDrawerInited = true;
+        
+        // this is a good time, a while after launch, to do the post
+        // update step
+        postUpdate();
+
+        // first game frame is next
+        // (time spent in demo code panel, if any, is outside phases)
+        StartupTimeline::finish( "startupTimeline.json" );
+        }
+    else if( !writeFailed && !loadingFailedFlag  ) {
+        // demo mode done or was never enabled
+
+        // carry on with game
+        
+
+        // auto-pause when minimized
+        if( pauseOnMinimize && screen->isMinimized() ) {
+            mPaused = true;
+            }
+
+
+        // don't update while paused
+        char update = !mPaused;
+        
+        screen->setIdle( mPaused );
+        
+        stepFixedUpdates( update );
+        
+        {
+            PROFILE_ZONE( "drawFrame" );
+            drawFrame( update );
+            }
+        
+        // game may have left sprites queued
+        flushSpriteBatch();
+
+        // and bytes that sockets couldn't take yet
+        flushSocketSendQueues();
+
+        stepPendingSocketConnects();
+        
+        if( cursorMode > 0 ) {
+            // draw emulated cursor
+
+            // draw using same projection used to drawFrame
+            // so that emulated cursor lines up with screen position of buttons
+            
+            float xf, yf;
+            screenToWorld( lastMouseX, lastMouseY, &xf, &yf );
+            
+            double x = xf;
+            double y = yf;
+            
+            double sizeFactor = 25 * emulatedCursorScale;
+
+            // white border of pointer 
+
+            setDrawColor( 1, 1, 1, 1 );
+
+            double vertsA[18] = 
+                { // body of pointer
+                    x, y,
+                    x, y - sizeFactor * 0.8918,
+                    x + sizeFactor * 0.6306, y - sizeFactor * 0.6306,
+                    // left collar of pointer
+                    x, y,
+                    x, y - sizeFactor * 1.0,
+                    x + sizeFactor * 0.2229, y - sizeFactor * 0.7994,
+                    // right collar of pointer
+                    x + sizeFactor * 0.4077, y - sizeFactor * 0.7229,
+                    x + sizeFactor * 0.7071, y - sizeFactor * 0.7071,
+                    x, y };
+
+            drawTriangles( 3, vertsA );
+            
+            // neck of pointer
+            double vertsB[8] = { 
+                x + sizeFactor * 0.2076, y - sizeFactor * 0.7625,
+                x + sizeFactor * 0.376, y - sizeFactor * 1.169,
+                x + sizeFactor * 0.5607, y - sizeFactor * 1.0924,
+                x + sizeFactor * 0.3924, y - sizeFactor * 0.6859 };
+                                
+            drawQuads( 1, vertsB );
+
+           
+            // black fill of pointer
+            setDrawColor( 0, 0, 0, 1 );
+            
+            double vertsC[18] = 
+                { // body of pointer
+                    x + sizeFactor * 0.04, y - sizeFactor * 0.0966,
+                    x + sizeFactor * 0.04, y - sizeFactor * 0.814,
+                    x + sizeFactor * 0.5473, y - sizeFactor * 0.6038,
+                    // left collar of pointer
+                    x + sizeFactor * 0.04, y - sizeFactor * 0.0966,
+                    x + sizeFactor * 0.04, y - sizeFactor * 0.9102,
+                    x + sizeFactor * 0.2382, y - sizeFactor * 0.7319,
+                    // right collar of pointer
+                    x + sizeFactor * 0.3491, y - sizeFactor * 0.6859,
+                    x + sizeFactor * 0.6153, y - sizeFactor * 0.6719,
+                    x + sizeFactor * 0.04, y - sizeFactor * 0.0966 };
+
+            drawTriangles( 3, vertsC );
+            
+            // neck of pointer
+            double vertsD[8] = { 
+                x + sizeFactor * 0.2229, y - sizeFactor * 0.6949,
+                x + sizeFactor * 0.3976, y - sizeFactor * 1.1167,
+                x + sizeFactor * 0.5086, y - sizeFactor * 1.0708,
+                x + sizeFactor * 0.3338, y - sizeFactor * 0.649 };
+                                
+            drawQuads( 1, vertsD );
+            }
+        
+
+        if( recordAudio ) {
+            // frame-accurate audio recording
+            int samplesPerFrame = soundSampleRate / targetFrameRate;
+            
+            // stereo 16-bit
+            int bytesPerSample = 4;
+            
+            int numSampleBytes = bytesPerSample * samplesPerFrame;
+
+            Uint8 *bytes = new Uint8[ numSampleBytes ];
+
+            if( !bufferSizeHinted ) {
+                hintBufferSize( numSampleBytes );
+
+                soundSpriteMixingBufferL = new float[ samplesPerFrame ];
+                soundSpriteMixingBufferR = new float[ samplesPerFrame ];
+                
+                soundMixingBufferL = new float[ samplesPerFrame ];
+                soundMixingBufferR = new float[ samplesPerFrame ];
+
+                bufferSizeHinted = true;
+                }
+
+            audioCallback( NULL, bytes, numSampleBytes );
+            
+            delete [] bytes;
+            }
+        
+
+        if( screen->isPlayingBack() && screen->shouldShowPlaybackDisplay() ) {
+
+            char *progressString = frameSprintf( 
+                "%s %.1f\n%s\n%s",
+                translate( "playbackTag" ),
+                screen->getPlaybackDoneFraction() * 100,
+                translate( "playbackToggleMessage" ),
+                translate( "playbackEndMessage" ) );
+            
+            drawString( progressString );
+            
+            }
+        
+
+        if( screen->isPlayingBack() && 
+            screen->shouldShowPlaybackDisplay() &&
+            showMouseDuringPlayback() ) {
+
+
+            // draw mouse position info
+            
+            if( mouseDown ) {
+                if( isLastMouseButtonRight() ) {
+                    mouseRightDown = true;
+                    setDrawColor( 1, 0, 1, 0.5 );
+                    }
+                else {
+                    mouseRightDown = false;
+                    setDrawColor( 1, 0, 0, 0.5 );
+                    }
+                }
+            else {
+                setDrawColor( 1, 1, 1, 0.5 );
+                }
+            
+            // step mouse click animation even after mouse released
+            // (too hard to see it otherwise for fast clicks)
+            mouseDownSteps ++;
+
+
+            float sizeFactor = 5.0f;
+            float clickSizeFactor = 5.0f;
+            char showClick = false;
+            float clickFade = 1.0f;
+            
+            int mouseClickDisplayDuration = 20 * targetFrameRate / 60.0;
+
+            if( mouseDownSteps < mouseClickDisplayDuration ) {
+                
+                float mouseClickProgress = 
+                    mouseDownSteps / (float)mouseClickDisplayDuration;
+
+                clickSizeFactor *= 5 * mouseClickProgress;
+                showClick = true;
+
+                clickFade *= 1.0f - mouseClickProgress;
+                }
+            
+            
+            // mouse coordinates in screen space
+            glMatrixMode(GL_PROJECTION);
+            glLoadIdentity();
+            
+            
+            // viewport is square of largest dimension, centered on screen
+
+            int bigDimension = screenWidth;
+            
+            if( screenHeight > bigDimension ) {
+                bigDimension = screenHeight;
+                }
+
+            float excessX = ( bigDimension - screenWidth ) / 2;
+            float excessY = ( bigDimension - screenHeight ) / 2;
+
+            glOrtho( -excessX, -excessX + bigDimension, 
+                     -excessY + bigDimension, -excessY, 
+                     -1.0f, 1.0f );
+            
+            glViewport( -excessX,
+                        -excessY, 
+                        bigDimension,
+                        bigDimension );
+
+            glMatrixMode(GL_MODELVIEW);
+
+
+            double verts[8] = 
+                {lastMouseX - sizeFactor, lastMouseY - sizeFactor,
+                 lastMouseX - sizeFactor, lastMouseY + sizeFactor,
+                 lastMouseX + sizeFactor, lastMouseY + sizeFactor,
+                 lastMouseX + sizeFactor, lastMouseY - sizeFactor};
+
+            drawQuads( 1, verts );
+
+
+            double centerSize = 2;
+
+
+            if( showClick ) {
+                double clickVerts[8] = 
+                    {lastMouseDownX - clickSizeFactor, 
+                     lastMouseDownY - clickSizeFactor,
+                     lastMouseDownX - clickSizeFactor, 
+                     lastMouseDownY + clickSizeFactor,
+                     lastMouseDownX + clickSizeFactor, 
+                     lastMouseDownY + clickSizeFactor,
+                     lastMouseDownX + clickSizeFactor, 
+                     lastMouseDownY - clickSizeFactor};
+
+                if( mouseDown ) {
+                    if( isLastMouseButtonRight() ) {
+                        setDrawColor( 1, 0, 1, clickFade );
+                        }
+                    else {
+                        setDrawColor( 1, 0, 0, clickFade );
+                        }
+                    }
+                else {
+                    if( mouseRightDown ) {
+                        setDrawColor( 1, 1, 0, clickFade );
+                        }
+                    else {
+                        setDrawColor( 0, 1, 0, clickFade );
+                        }
+                    }
+
+                drawQuads( 1, clickVerts );
+
+                // draw pin-point at center of click
+                double clickCenterVerts[8] = 
+                    {lastMouseDownX - centerSize, 
+                     lastMouseDownY - centerSize,
+                     lastMouseDownX - centerSize, 
+                     lastMouseDownY + centerSize,
+                     lastMouseDownX + centerSize, 
+                     lastMouseDownY + centerSize,
+                     lastMouseDownX + centerSize, 
+                     lastMouseDownY - centerSize};
+                
+                drawQuads( 1, clickCenterVerts );
+                }
+            
+
+            // finally, darker black center over whole thing
+            double centerVerts[8] = 
+                {lastMouseX - centerSize, lastMouseY - centerSize,
+                 lastMouseX - centerSize, lastMouseY + centerSize,
+                 lastMouseX + centerSize, lastMouseY + centerSize,
+                 lastMouseX + centerSize, lastMouseY - centerSize};
+
+            setDrawColor( 0, 0, 0, 0.5 );
+            drawQuads( 1, centerVerts );
+                
+            }
+        
+        }
+    
+
+    if( visibleWidth != -1 && visibleHeight != -1 ) {        
+        // draw letterbox
+    
+        // On most platforms, glViewport will clip image for us.
+        // glScissor is also supposed to do this, but it is buggy on some 
+        // platforms
+        // thus, to be safe, we keep glScissor off and manually draw letterboxes
+        // just in case glViewport doesn't clip the image.
+    
+        glMatrixMode(GL_PROJECTION);
+        glLoadIdentity();
+            
+            
+        // viewport is square of largest dimension, centered on screen
+    
+        int bigDimension = screenWidth;
+            
+        if( screenHeight > bigDimension ) {
+            bigDimension = screenHeight;
+            }
+    
+        float excessX = ( bigDimension - screenWidth ) / 2;
+        float excessY = ( bigDimension - screenHeight ) / 2;
+
+        glOrtho( -excessX, -excessX + bigDimension, 
+                 -excessY + bigDimension, -excessY, 
+                 -1.0f, 1.0f );
+    
+        glViewport( -excessX,
+                    -excessY, 
+                    bigDimension,
+                    bigDimension );
+    
+        glMatrixMode(GL_MODELVIEW);
+
+        setDrawColor( 0, 0, 0, 1.00 );
+
+        int extraWidth = 
+            lrint( 
+                screenWidth -
+                ( (double)visibleWidth / (double)visibleHeight ) * 
+                screenHeight );
+
+        if( extraWidth > 0 ) {
+        
+
+            // left/right bars
+            drawRect( 0,
+                      0,
+                      extraWidth / 2, 
+                      screenHeight );
+        
+            drawRect( screenWidth - extraWidth / 2, 
+                      0,
+                      screenWidth, 
+                      screenHeight );    
+            }
+        else {
+        
+            int extraHeight = 
+                lrint( 
+                    screenHeight -
+                    ( (double)visibleHeight / (double)visibleWidth ) * 
+                    screenWidth );
+
+            if( extraHeight > 0 ) {
+            
+                // top/bottom bars
+            
+                drawRect( 0, 
+                          0,
+                          screenWidth, 
+                          extraHeight / 2 );
+        
+                drawRect( 0, 
+                          screenHeight - extraHeight / 2,
+                          screenWidth, 
+                          screenHeight );
+                }
             }
-        
+        }
+    
 
-        if( numFramesSkippedBeforeMeasure < numFramesToSkipBeforeMeasure ) {
-            numFramesSkippedBeforeMeasure++;
-            
-            drawString( translate( "measuringFPS" ), true );
+    flushSpriteBatch();
+
+    if( shouldTakeScreenshot ) {
+        takeScreenShot();
+
+        if( !outputAllFrames ) {
+            // just one
+            shouldTakeScreenshot = false;
             }
-        else if( ! startMeasureTimeRecorded ) {
-            startMeasureTime = Time::getCurrentTime();
-            startMeasureTimeRecorded = true;
+        manualScreenShot = false;
+        }
 
-            drawString( translate( "measuringFPS" ), true );
+    // after screen shot, so that it never shows up in captured frames
+    if( statsOverlayShowing ) {
+        drawStatsOverlay();
+        }
+
+    // drop sprite textures over budget, now that drawing is done
+    stepSpriteTextureResidency();
+
+    stepScreenRegionReads();
+
+    frameNumber ++;
+
+    // all of this frame's temporaries on the main thread
+    FrameArena::getThreadArena()->reset();
+
+    #ifdef DEBUG_MEMORY
+    if( frameNumber % MEMORY_CHURN_FRAMES == 0 ) {
+        // divide counts by MEMORY_CHURN_FRAMES for per-frame churn
+        int snapshot = MemoryTrack::takeSnapshot();
+
+        if( lastMemorySnapshot != -1 ) {
+            MemoryTrack::writeSnapshotDiff( lastMemorySnapshot, snapshot,
+                                            "memoryChurn.csv" );
             }
-        else {
+        lastMemorySnapshot = snapshot;
+        }
+    #endif
 
-            numFramesMeasured++;
-            
-            double totalTime = Time::getCurrentTime() - startMeasureTime;
+    //printf( "%d pixels drawn (%.2F MB textures resident)\n", 
+    //        numPixelsDrawn, totalLoadedTextureBytes / ( 1024.0 * 1024.0 ) );
+    }
 
-            double timePerFrame = totalTime / ( numFramesMeasured );
-            
-            double frameRate = 1 / timePerFrame;
 
+void screenToWorld( int inX, int inY, float *outX, float *outY ) {
 
-            int closestTargetFrameRate = 0;
-            double closestFPSDiff = 9999999;
-            
-            for( int i=0; i<possibleFrameRates.size(); i++ ) {
-                
-                int v = possibleFrameRates.getElementDirect( i );
-                
-                double diff = fabs( frameRate - v );
-                
-                if( diff < closestFPSDiff ) {
-                    closestTargetFrameRate = v;
-                    closestFPSDiff = diff;
-                    }
-                }
-                
-            double overAllowFactor = 1.05;
-            
+    if( mouseWorldCoordinates ) {
+        
+        // relative to center,
+        // viewSize spreads out across screenWidth only (a square on screen)
+        float x = (float)( inX - (screenWidth/2) ) / (float)screenWidth;
+        float y = -(float)( inY - (screenHeight/2) ) / (float)screenWidth;
+        
+        *outX = x * viewSize + viewCenterX;
+        *outY = y * viewSize + viewCenterY;
+        }
+    else {
+        // raw screen coordinates
+        *outX = inX;
+        *outY = inY;
+        }
+    
+    }
 
 
-            if( numFramesMeasured > 10 && 
-                frameRate > overAllowFactor * closestTargetFrameRate ) {
+void worldToScreen( float inX, float inY, int *outX, int *outY ) {
+    if( mouseWorldCoordinates ) {
+        // inverse of screenToWorld
+        inX -= viewCenterX;
+        inX /= viewSize;
+        
+        inX *= screenWidth;
+        inX += screenWidth/2;
+        
+        *outX = round( inX );
+        
 
-                secondsToMeasure = warningSecondsToMeasure;
-                }
-            else {
-                secondsToMeasure = noWarningSecondsToMeasure;
-                }
-            
-            if( totalTime <= secondsToMeasure ) {    
-                char *message = autoSprintf( "%s\n%0.2f\nFPS",
-                                             translate( "measuringFPS" ),
-                                             frameRate );
-                
-                
-                drawString( message, true );
-                
-                delete [] message;
-                }
-            
-            if( totalTime > secondsToMeasure ) {
-                
-                if( ! measureRecorded ) {
-                    
-                    if( targetFrameRate == idealTargetFrameRate ) {
-                        // not invoking halfFrameRate
+        inY -= viewCenterY;
+        inY /= viewSize;
+        
+        inY *= -screenWidth;
+        inY += screenHeight/2;
+        
+        *outY = round( inY );
+        }
+    else {
+        // raw screen coordinates
+        *outX = inX;
+        *outY = inY;
+        }
+    }
 
-                        AppLog::infoF( "Measured frame rate = %f fps\n", 
-                                       frameRate );
-                        AppLog::infoF( 
-                            "Closest possible frame rate = %d fps\n", 
-                            closestTargetFrameRate );                
-                        
-                        if( frameRate > 
-                            overAllowFactor * closestTargetFrameRate ) {
-                            
-                            AppLog::infoF( 
-                                "Vsync to enforce closested frame rate of "
-                                "%d fps doesn't seem to be in effect.\n", 
-                                closestTargetFrameRate );
-                    
-                            AppLog::infoF( 
-                                "Will sleep each frame to enforce desired "
-                                "frame rate of %d fps\n",
-                                idealTargetFrameRate );
-                            
-                            targetFrameRate = idealTargetFrameRate;
-                            
-                            screen->useFrameSleep( true );
-                            countingOnVsync = false;
-                            }
-                        else {
-                            AppLog::infoF( 
-                                "Vsync seems to be enforcing an allowed frame "
-                                "rate of %d fps.\n", closestTargetFrameRate );
-                            
-                            targetFrameRate = closestTargetFrameRate;
-                            
-                            screen->useFrameSleep( false );
-                            countingOnVsync = true;
-                            }
-                        }
-                    else {
-                        // half frame rate must be set
-                        
-                        AppLog::infoF( 
-                            "User has halfFrameRate set, so we're going "
-                        "to manually sleep to enforce a target "
-                            "frame rate of %d fps.\n", targetFrameRate );
-                        screen->useFrameSleep( true );
-                        countingOnVsync = false;
-                        }
-                
-                
-                    screen->setFullFrameRate( targetFrameRate );
-                    measureRecorded = true;
-                    }
-                
-                if( !countingOnVsync ) {
-                    // show warning message
-                    char *message = 
-                        autoSprintf( "%s\n%s\n\n%s\n\n\n%s",
-                                     translate( "vsyncWarning" ),
-                                     translate( "vsyncWarning2" ),
-                                     translate( "vsyncWarning3" ),
-                                     translate( "vsyncContinueMessage" ) );
-                    drawString( message, true );
-                
-                    delete [] message;
-                    }
-                else {
-                    // auto-save it now
-                    saveFrameRateSettings();
-                    screen->startRecordingOrPlayback();
-                    measureFrameRate = false;
-                    }
-                }
+
+
+
+
+
+void getLastMouseScreenPos( int *outX, int *outY ) {
+    *outX = lastMouseX;
+    *outY = lastMouseY;
+    }
+
+
+
+void GameSceneHandler::mouseMoved( int inX, int inY ) {
+    if( ignoreNextMouseEvent ) {
+        if( inX == xCoordToIgnore && inY == yCoordToIgnore ) {
+            // seeing the event that triggered the ignore
+            ignoreNextMouseEvent = false;
+            return;
+            }
+        else {
+            // stale pending event before the ignore
+            // skip it too
+            return;
+            }
+        }
+    
+    float x, y;
+    screenToWorld( inX, inY, &x, &y );
+    pointerMove( x, y );
+    
+    lastMouseX = inX;
+    lastMouseY = inY;
+    }
+
+
+
+void GameSceneHandler::mouseDragged( int inX, int inY ) {
+    if( ignoreNextMouseEvent ) {
+        if( inX == xCoordToIgnore && inY == yCoordToIgnore ) {
+            // seeing the event that triggered the ignore
+            ignoreNextMouseEvent = false;
+            return;
+            }
+        else {
+            // stale pending event before the ignore
+            // skip it too
+            return;
             }
+        }
+    
+    float x, y;
+    screenToWorld( inX, inY, &x, &y );
+    pointerDrag( x, y );
+
+    lastMouseX = inX;
+    lastMouseY = inY;
+    }
+
+
+
+
+void GameSceneHandler::mousePressed( int inX, int inY ) {
+    float x, y;
+    screenToWorld( inX, inY, &x, &y );
+    pointerDown( x, y );
 
-        return;
-        }
-    else if( !loadingMessageShown ) {
-        drawString( translate( "loading" ), true );
+    lastMouseX = inX;
+    lastMouseY = inY;
 
-        loadingMessageShown = true;
-        }
-    else if( loadingFailedFlag ) {
-        drawString( loadingFailedMessage, true );
-        }
-    else if( !writeFailed && !loadingFailedFlag && !frameDrawerInited ) {
-        drawString( translate( "loading" ), true );
+    mouseDown = true;
+    mouseDownSteps = 0;
+    lastMouseDownX = inX;
+    lastMouseDownY = inY;
+    }
 
-        initFrameDrawer( pixelZoomFactor * gameWidth, 
-                         pixelZoomFactor * gameHeight, 
-                         targetFrameRate,
-                         screen->getCustomRecordedGameData(),
-                         screen->isPlayingBack() );
-        
-        int readCursorMode = SettingsManager::getIntSetting( "cursorMode", -1 );
-        
 
-        if( readCursorMode < 0 ) {
-            // never set before
 
-            // check if we are ultrawidescreen
-            char ultraWide = false;
-            
-            const SDL_VideoInfo* currentScreenInfo = SDL_GetVideoInfo();
-        
-            int currentW = currentScreenInfo->current_w;
-            int currentH = currentScreenInfo->current_h;
+void GameSceneHandler::mouseReleased( int inX, int inY ) {
+    float x, y;
+    screenToWorld( inX, inY, &x, &y );
+    pointerUp( x, y );
 
-            double aspectRatio = (double)currentW / (double)currentH;
-            
-            // give a little wiggle room above 16:9
-            // ultrawide starts at 21:9
-            if( aspectRatio > 18.0 / 9.0 ) {
-                ultraWide = true;
-                }
+    lastMouseX = inX;
+    lastMouseY = inY;
+    mouseDown = false;
 
-            // we no longer do this, because ultrawide cursor placement
-            // issues have been fixed, allowing ultrawide monitors to use
-            // native cursor by default
-            if( false && ultraWide ) {
-                // drawn cursor, because system native cursor
-                // is off-target on ultrawide displays
-                
-                setCursorMode( 1 );
-                
-                double startingScale = 1.0;
-                
-                int forceBigPointer = 
-                    SettingsManager::getIntSetting( "forceBigPointer", 0 );
-                if( forceBigPointer ||
-                    screenWidth > 1920 || screenHeight > 1080 ) {
-                    
-                    startingScale *= 2;
-                    }
-                setEmulatedCursorScale( startingScale );
-                }
-            }
-        else {
-            setCursorMode( readCursorMode );
+    // start new animation for release
+    mouseDownSteps = 0;
+    lastMouseDownX = inX;
+    lastMouseDownY = inY;
+    }
 
-            double readCursorScale = 
-                SettingsManager::
-                getDoubleSetting( "emulatedCursorScale", -1.0 );
-            
-            if( readCursorScale >= 1 ) {
-                setEmulatedCursorScale( readCursorScale );
-                }
-            }
-        
 
 
-        frameDrawerInited = true;
-        
-        // this is a good time, a while after launch, to do the post
-        // update step
-        postUpdate();
-        }
-    else if( !writeFailed && !loadingFailedFlag  ) {
-        // demo mode done or was never enabled
+void GameSceneHandler::fireRedraw() {
 
-        // carry on with game
+    if( !loadingDone ) {
+        mLoadingDuringFrameBatch = true;
+        }
+    
+    if( mPaused ) {
+        // ignore redraw event
         
+        mPausedDuringFrameBatch = true;
 
-        // auto-pause when minimized
-        if( pauseOnMinimize && screen->isMinimized() ) {
-            mPaused = true;
+        // screen paces paused frames at a low rate to avoid wasting
+        // CPU cycles
+        if( mPausedSleepTime > (unsigned int)( 5 * targetFrameRate ) ) {
+            // user has touched nothing for a while, slow down further
+            screen->setIdleFrameRate( 2 );
+            }
+        else {
+            screen->setIdleFrameRate( SCREEN_GL_DEFAULT_IDLE_FRAME_RATE );
             }
-
-
-        // don't update while paused
-        char update = !mPaused;
         
-        drawFrame( update );
+        mPausedSleepTime++;
         
-        if( cursorMode > 0 ) {
-            // draw emulated cursor
-
-            // draw using same projection used to drawFrame
-            // so that emulated cursor lines up with screen position of buttons
-            
-            float xf, yf;
-            screenToWorld( lastMouseX, lastMouseY, &xf, &yf );
-            
-            double x = xf;
-            double y = yf;
-            
-            double sizeFactor = 25 * emulatedCursorScale;
+        return;
+        }
 
-            // white border of pointer 
 
-            setDrawColor( 1, 1, 1, 1 );
+    }
 
-            double vertsA[18] = 
-                { // body of pointer
-                    x, y,
-                    x, y - sizeFactor * 0.8918,
-                    x + sizeFactor * 0.6306, y - sizeFactor * 0.6306,
-                    // left collar of pointer
-                    x, y,
-                    x, y - sizeFactor * 1.0,
-                    x + sizeFactor * 0.2229, y - sizeFactor * 0.7994,
-                    // right collar of pointer
-                    x + sizeFactor * 0.4077, y - sizeFactor * 0.7229,
-                    x + sizeFactor * 0.7071, y - sizeFactor * 0.7071,
-                    x, y };
 
-            drawTriangles( 3, vertsA );
-            
-            // neck of pointer
-            double vertsB[8] = { 
-                x + sizeFactor * 0.2076, y - sizeFactor * 0.7625,
-                x + sizeFactor * 0.376, y - sizeFactor * 1.169,
-                x + sizeFactor * 0.5607, y - sizeFactor * 1.0924,
-                x + sizeFactor * 0.3924, y - sizeFactor * 0.6859 };
-                                
-            drawQuads( 1, vertsB );
 
-           
-            // black fill of pointer
-            setDrawColor( 0, 0, 0, 1 );
-            
-            double vertsC[18] = 
-                { // body of pointer
-                    x + sizeFactor * 0.04, y - sizeFactor * 0.0966,
-                    x + sizeFactor * 0.04, y - sizeFactor * 0.814,
-                    x + sizeFactor * 0.5473, y - sizeFactor * 0.6038,
-                    // left collar of pointer
-                    x + sizeFactor * 0.04, y - sizeFactor * 0.0966,
-                    x + sizeFactor * 0.04, y - sizeFactor * 0.9102,
-                    x + sizeFactor * 0.2382, y - sizeFactor * 0.7319,
-                    // right collar of pointer
-                    x + sizeFactor * 0.3491, y - sizeFactor * 0.6859,
-                    x + sizeFactor * 0.6153, y - sizeFactor * 0.6719,
-                    x + sizeFactor * 0.04, y - sizeFactor * 0.0966 };
+static unsigned char lastKeyPressed = '\0';
 
-            drawTriangles( 3, vertsC );
-            
-            // neck of pointer
-            double vertsD[8] = { 
-                x + sizeFactor * 0.2229, y - sizeFactor * 0.6949,
-                x + sizeFactor * 0.3976, y - sizeFactor * 1.1167,
-                x + sizeFactor * 0.5086, y - sizeFactor * 1.0708,
-                x + sizeFactor * 0.3338, y - sizeFactor * 0.649 };
-                                
-            drawQuads( 1, vertsD );
-            }
-        
 
-        if( recordAudio ) {
-            // frame-accurate audio recording
-            int samplesPerFrame = soundSampleRate / targetFrameRate;
-            
-            // stereo 16-bit
-            int bytesPerSample = 4;
-            
-            int numSampleBytes = bytesPerSample * samplesPerFrame;
+void GameSceneHandler::keyPressed(
+	unsigned char inKey, int inX, int inY ) {
 
-            Uint8 *bytes = new Uint8[ numSampleBytes ];
+    if( writeFailed || loadingFailedFlag ) {
+        exit( 0 );
+        }
 
-            if( !bufferSizeHinted ) {
-                hintBufferSize( numSampleBytes );
+    if( measureFrameRate && measureRecorded ) {
+        if( inKey == 'y' || inKey == 'Y' ) {
+            saveFrameRateSettings();
+            screen->startRecordingOrPlayback();
+            measureFrameRate = false;
+            }
+        else if( inKey == 27 ) {
+            exit( 0 );
+            }
+        }
+    
+    
 
-                soundSpriteMixingBufferL = new double[ samplesPerFrame ];
-                soundSpriteMixingBufferR = new double[ samplesPerFrame ];
+    // reset to become responsive while paused
+    mPausedSleepTime = 0;
+    
 
-                bufferSizeHinted = true;
-                }
+    if( mPaused && inKey == '%' && ! mBlockQuitting ) {
+        // % to quit from pause
+        exit( 0 );
+        }
+    
 
-            audioCallback( NULL, bytes, numSampleBytes );
-            
-            delete [] bytes;
-            }
+    if( inKey == 9 && isCommandKeyDown() &&
+        screen->isPlayingBack() ) {
         
+        printf( "Caught alt-tab during playback, pausing\n" );
+        
+        // alt-tab pressed during playback
+        // but we aren't actually being minimized during playback
+        // (because there's nothing to bring us back)
+        // Still, force a pause, so that user's unpause action after
+        // tabbing back in replays correctly
+        mPaused = true;
+        }
+    
 
-        if( screen->isPlayingBack() && screen->shouldShowPlaybackDisplay() ) {
-
-            char *progressString = autoSprintf( 
-                "%s %.1f\n%s\n%s",
-                translate( "playbackTag" ),
-                screen->getPlaybackDoneFraction() * 100,
-                translate( "playbackToggleMessage" ),
-                translate( "playbackEndMessage" ) );
+    if( enableSpeedControlKeys ) {
+        
+        if( inKey == '^' ) {
+            // slow
+            mScreen->setMaxFrameRate( 2 );
+            mScreen->useFrameSleep( true );
+            }
+        if( inKey == '&' ) {
+            // half
+            mScreen->setMaxFrameRate( targetFrameRate / 2 );
+            mScreen->useFrameSleep( true );
+            }
+        if( inKey == '*' ) {
+            // normal
+            mScreen->setMaxFrameRate( targetFrameRate );
             
-            drawString( progressString );
+            if( countingOnVsync ) {
+                mScreen->useFrameSleep( false );
+                }
+            else {
+                mScreen->useFrameSleep( true );
+                }
+            }            
+        if( inKey == '(' ) {
+            // fast forward
+            mScreen->setMaxFrameRate( targetFrameRate * 2 );
+            mScreen->useFrameSleep( true );
+            }            
+        if( inKey == ')' ) {
+            // fast fast forward
+            mScreen->setMaxFrameRate( targetFrameRate * 4 );
+            mScreen->useFrameSleep( true );
+            }            
+        if( inKey == '-' ) {
+            // fast fast fast forward
+            mScreen->setMaxFrameRate( targetFrameRate * 8 );
+            mScreen->useFrameSleep( true );
+            }            
+        }
+    
+    if( !hardToQuitMode ) {
+        // escape only
 
-            delete [] progressString;
-            
+        if( inKey == 27 ) {
+            // escape always toggles pause
+            mPaused = !mPaused;
             }
-        
+        }
+    else {
+        // # followed by ESC
+        if( lastKeyPressed == '#' && inKey == 27 ) {
+            exit( 0 );
+            }
+        lastKeyPressed = inKey;
+        }
 
-        if( screen->isPlayingBack() && 
-            screen->shouldShowPlaybackDisplay() &&
-            showMouseDuringPlayback() ) {
+    keyDown( inKey );
+    }
 
 
-            // draw mouse position info
-            
-            if( mouseDown ) {
-                if( isLastMouseButtonRight() ) {
-                    mouseRightDown = true;
-                    setDrawColor( 1, 0, 1, 0.5 );
-                    }
-                else {
-                    mouseRightDown = false;
-                    setDrawColor( 1, 0, 0, 0.5 );
-                    }
-                }
-            else {
-                setDrawColor( 1, 1, 1, 0.5 );
-                }
-            
-            // step mouse click animation even after mouse released
-            // (too hard to see it otherwise for fast clicks)
-            mouseDownSteps ++;
 
+void GameSceneHandler::keyReleased(
+	unsigned char inKey, int inX, int inY ) {
 
-            float sizeFactor = 5.0f;
-            float clickSizeFactor = 5.0f;
-            char showClick = false;
-            float clickFade = 1.0f;
-            
-            int mouseClickDisplayDuration = 20 * targetFrameRate / 60.0;
+    keyUp( inKey );
+    }
 
-            if( mouseDownSteps < mouseClickDisplayDuration ) {
-                
-                float mouseClickProgress = 
-                    mouseDownSteps / (float)mouseClickDisplayDuration;
 
-                clickSizeFactor *= 5 * mouseClickProgress;
-                showClick = true;
 
-                clickFade *= 1.0f - mouseClickProgress;
-                }
-            
-            
-            // mouse coordinates in screen space
-            glMatrixMode(GL_PROJECTION);
-            glLoadIdentity();
-            
-            
-            // viewport is square of largest dimension, centered on screen
+// need to track these separately from SDL_GetModState so that
+// we replay isCommandKeyDown properly during recorded game playback
+static char rCtrlDown = false;
+static char lCtrlDown = false;
 
-            int bigDimension = screenWidth;
-            
-            if( screenHeight > bigDimension ) {
-                bigDimension = screenHeight;
-                }
+static char rAltDown = false;
+static char lAltDown = false;
 
-            float excessX = ( bigDimension - screenWidth ) / 2;
-            float excessY = ( bigDimension - screenHeight ) / 2;
+static char rMetaDown = false;
+static char lMetaDown = false;
 
-            glOrtho( -excessX, -excessX + bigDimension, 
-                     -excessY + bigDimension, -excessY, 
-                     -1.0f, 1.0f );
-            
-            glViewport( -excessX,
-                        -excessY, 
-                        bigDimension,
-                        bigDimension );
+static char lShiftDown = false;
+static char rShiftDown = false;
 
-            glMatrixMode(GL_MODELVIEW);
 
 
-            double verts[8] = 
-                {lastMouseX - sizeFactor, lastMouseY - sizeFactor,
-                 lastMouseX - sizeFactor, lastMouseY + sizeFactor,
-                 lastMouseX + sizeFactor, lastMouseY + sizeFactor,
-                 lastMouseX + sizeFactor, lastMouseY - sizeFactor};
+void GameSceneHandler::specialKeyPressed(
+	int inKey, int inX, int inY ) {
+    
+    if( writeFailed || loadingFailedFlag ) {
+        exit( 0 );
+        }
+    
+    switch( inKey ) {
+        case MG_KEY_RCTRL:
+            rCtrlDown = true;
+            break;
+        case MG_KEY_LCTRL:
+            lCtrlDown = true;
+            break;
+        case MG_KEY_RALT:
+            rAltDown = true;
+            break;
+        case MG_KEY_LALT:
+            lAltDown = true;
+            break;
+        case MG_KEY_RMETA:
+            rMetaDown = true;
+            break;
+        case MG_KEY_LMETA:
+            lMetaDown = true;
+            break;
+        case MG_KEY_RSHIFT:
+            rShiftDown = true;
+            break;
+        case MG_KEY_LSHIFT:
+            lShiftDown = true;
+            break;
+        }
+    
+    if( inKey == MG_KEY_F3 && enableStatsOverlayKey ) {
+        toggleStatsOverlay();
+        }
+    
+    
+    specialKeyDown( inKey );
+	}
 
-            drawQuads( 1, verts );
 
 
-            double centerSize = 2;
+void GameSceneHandler::specialKeyReleased(
+	int inKey, int inX, int inY ) {
+    
 
+    switch( inKey ) {
+        case MG_KEY_RCTRL:
+            rCtrlDown = false;
+            break;
+        case MG_KEY_LCTRL:
+            lCtrlDown = false;
+            break;
+        case MG_KEY_RALT:
+            rAltDown = false;
+            break;
+        case MG_KEY_LALT:
+            lAltDown = false;
+            break;
+        case MG_KEY_RMETA:
+            rMetaDown = false;
+            break;
+        case MG_KEY_LMETA:
+            lMetaDown = false;
+            break;
+        case MG_KEY_RSHIFT:
+            rShiftDown = false;
+            break;
+        case MG_KEY_LSHIFT:
+            lShiftDown = false;
+            break;
+        }
 
-            if( showClick ) {
-                double clickVerts[8] = 
-                    {lastMouseDownX - clickSizeFactor, 
-                     lastMouseDownY - clickSizeFactor,
-                     lastMouseDownX - clickSizeFactor, 
-                     lastMouseDownY + clickSizeFactor,
-                     lastMouseDownX + clickSizeFactor, 
-                     lastMouseDownY + clickSizeFactor,
-                     lastMouseDownX + clickSizeFactor, 
-                     lastMouseDownY - clickSizeFactor};
 
-                if( mouseDown ) {
-                    if( isLastMouseButtonRight() ) {
-                        setDrawColor( 1, 0, 1, clickFade );
-                        }
-                    else {
-                        setDrawColor( 1, 0, 0, clickFade );
-                        }
-                    }
-                else {
-                    if( mouseRightDown ) {
-                        setDrawColor( 1, 1, 0, clickFade );
-                        }
-                    else {
-                        setDrawColor( 0, 1, 0, clickFade );
-                        }
-                    }
+    specialKeyUp( inKey );
+    } 
 
-                drawQuads( 1, clickVerts );
 
-                // draw pin-point at center of click
-                double clickCenterVerts[8] = 
-                    {lastMouseDownX - centerSize, 
-                     lastMouseDownY - centerSize,
-                     lastMouseDownX - centerSize, 
-                     lastMouseDownY + centerSize,
-                     lastMouseDownX + centerSize, 
-                     lastMouseDownY + centerSize,
-                     lastMouseDownX + centerSize, 
-                     lastMouseDownY - centerSize};
-                
-                drawQuads( 1, clickCenterVerts );
-                }
-            
 
-            // finally, darker black center over whole thing
-            double centerVerts[8] = 
-                {lastMouseX - centerSize, lastMouseY - centerSize,
-                 lastMouseX - centerSize, lastMouseY + centerSize,
-                 lastMouseX + centerSize, lastMouseY + centerSize,
-                 lastMouseX + centerSize, lastMouseY - centerSize};
+char isCommandKeyDown() {
+    SDLMod modState = SDL_GetModState();
+    
 
-            setDrawColor( 0, 0, 0, 0.5 );
-            drawQuads( 1, centerVerts );
-                
-            }
+    if( ( modState & KMOD_CTRL )
+        ||
+        ( modState & KMOD_ALT )
+        ||
+        ( modState & KMOD_META ) ) {
         
+        return true;
         }
     
-
-    if( visibleWidth != -1 && visibleHeight != -1 ) {        
-        // draw letterbox
+    if( screen->isPlayingBack() ) {
+        // ignore these, saved internally, unless we're playing back
+        // they can fall out of sync with keyboard reality as the user
+        // alt-tabs between windows and release events are lost.
+        if( rCtrlDown || lCtrlDown ||
+            rAltDown || lAltDown ||
+            rMetaDown || lMetaDown ) {
+            return true;
+            }
+        }    
     
-        // On most platforms, glViewport will clip image for us.
-        // glScissor is also supposed to do this, but it is buggy on some 
-        // platforms
-        // thus, to be safe, we keep glScissor off and manually draw letterboxes
-        // just in case glViewport doesn't clip the image.
+    return false;
+    }
+
+
+
+char isShiftKeyDown() {
+    SDLMod modState = SDL_GetModState();
     
-        glMatrixMode(GL_PROJECTION);
-        glLoadIdentity();
-            
-            
-        // viewport is square of largest dimension, centered on screen
+
+    if( ( modState & KMOD_SHIFT ) ) {
+        
+        return true;
+        }
     
-        int bigDimension = screenWidth;
-            
-        if( screenHeight > bigDimension ) {
-            bigDimension = screenHeight;
+    if( screen->isPlayingBack() ) {
+        // ignore these, saved internally, unless we're playing back
+        // they can fall out of sync with keyboard reality as the user
+        // alt-tabs between windows and release events are lost.
+        if( rShiftDown || lShiftDown ) {
+            return true;
             }
+        }
     
-        float excessX = ( bigDimension - screenWidth ) / 2;
-        float excessY = ( bigDimension - screenHeight ) / 2;
+    return false;
+    }
 
-        glOrtho( -excessX, -excessX + bigDimension, 
-                 -excessY + bigDimension, -excessY, 
-                 -1.0f, 1.0f );
-    
-        glViewport( -excessX,
-                    -excessY, 
-                    bigDimension,
-                    bigDimension );
+
+
+char isLastMouseButtonRight() {
+    return screen->isLastMouseButtonRight();
+    }
+
+
+
+void obscureRecordedNumericTyping( char inObscure, 
+                                   char inCharToRecordInstead ) {
     
-        glMatrixMode(GL_MODELVIEW);
+    screen->obscureRecordedNumericTyping( inObscure, inCharToRecordInstead );
+    }
 
-        setDrawColor( 0, 0, 0, 1.00 );
 
-        int extraWidth = 
-            lrint( 
-                screenWidth -
-                ( (double)visibleWidth / (double)visibleHeight ) * 
-                screenHeight );
 
-        if( extraWidth > 0 ) {
-        
 
-            // left/right bars
-            drawRect( 0,
-                      0,
-                      extraWidth / 2, 
-                      screenHeight );
+void GameSceneHandler::actionPerformed( GUIComponent *inTarget ) {
+    }
+
+
+
+static Image *readTGAFile( File *inFile ) {
+    
+    if( resourceArchive.archive != NULL ) {
+        char *fileName = inFile->getFullFileName();
         
-            drawRect( screenWidth - extraWidth / 2, 
-                      0,
-                      screenWidth, 
-                      screenHeight );    
+        // stored entries are read in place, without a copy
+        int length;
+        unsigned char *data = (unsigned char *)
+            resourceArchive.archive->getStoredResource( fileName, &length );
+        unsigned char *dataToDelete = NULL;
+        
+        if( data == NULL ) {
+            data = resourceArchive.archive->readResource( fileName, 
+                                                          &length );
+            dataToDelete = data;
             }
-        else {
         
-            int extraHeight = 
-                lrint( 
-                    screenHeight -
-                    ( (double)visibleHeight / (double)visibleWidth ) * 
-                    screenWidth );
-
-            if( extraHeight > 0 ) {
+        delete [] fileName;
+        
+        if( data != NULL ) {
+            ByteBufferInputStream tgaStream( data, length );
             
-                // top/bottom bars
+            TGAImageConverter converter;
             
-                drawRect( 0, 
-                          0,
-                          screenWidth, 
-                          extraHeight / 2 );
-        
-                drawRect( 0, 
-                          screenHeight - extraHeight / 2,
-                          screenWidth, 
-                          screenHeight );
+            Image *result = converter.deformatImage( &tgaStream );
+            
+            if( dataToDelete != NULL ) {
+                delete [] dataToDelete;
+                }
+            
+            if( result != NULL ) {
+                return result;
                 }
+            // else fall back on loose file
             }
         }
     
 
-    if( shouldTakeScreenshot ) {
-        takeScreenShot();
+    if( !inFile->exists() ) {
+        char *fileName = inFile->getFullFileName();
+        
+        char *logString = autoSprintf( 
+            "CRITICAL ERROR:  TGA file %s does not exist",
+            fileName );
+        delete [] fileName;
+        
+        AppLog::criticalError( logString );
+        delete [] logString;
+    
+        return NULL;
+        }    
 
-        if( !outputAllFrames ) {
-            // just one
-            shouldTakeScreenshot = false;
-            }
-        manualScreenShot = false;
+
+    FileInputStream tgaStream( inFile );
+    
+    TGAImageConverter converter;
+    
+    Image *result = converter.deformatImage( &tgaStream );
+
+    if( result == NULL ) {        
+        char *fileName = inFile->getFullFileName();
+        
+        char *logString = autoSprintf( 
+            "CRITICAL ERROR:  could not read TGA file %s, wrong format?",
+            fileName );
+        delete [] fileName;
+        
+        AppLog::criticalError( logString );
+        delete [] logString;
         }
+    
+    return result;
+    }
 
-    frameNumber ++;
-    //printf( "%d pixels drawn (%.2F MB textures resident)\n", 
-    //        numPixelsDrawn, totalLoadedTextureBytes / ( 1024.0 * 1024.0 ) );
+
+
+Image *readTGAFile( const char *inTGAFileName ) {
+
+    File tgaFile( new Path( "graphics" ), inTGAFileName );
+    
+    return readTGAFile( &tgaFile );
     }
 
 
-void screenToWorld( int inX, int inY, float *outX, float *outY ) {
 
-    if( mouseWorldCoordinates ) {
-        
-        // relative to center,
-        // viewSize spreads out across screenWidth only (a square on screen)
-        float x = (float)( inX - (screenWidth/2) ) / (float)screenWidth;
-        float y = -(float)( inY - (screenHeight/2) ) / (float)screenWidth;
-        
-        *outX = x * viewSize + viewCenterX;
-        *outY = y * viewSize + viewCenterY;
-        }
-    else {
-        // raw screen coordinates
-        *outX = inX;
-        *outY = inY;
-        }
+Image *readTGAFileBase( const char *inTGAFileName ) {
+
+    File tgaFile( NULL, inTGAFileName );
     
+    return readTGAFile( &tgaFile );
     }
 
 
-void worldToScreen( float inX, float inY, int *outX, int *outY ) {
-    if( mouseWorldCoordinates ) {
-        // inverse of screenToWorld
-        inX -= viewCenterX;
-        inX /= viewSize;
-        
-        inX *= screenWidth;
-        inX += screenWidth/2;
+
+
+static RawRGBAImage *readTGAFileRaw( InputStream *inStream ) {
+    TGAImageConverter converter;
+    
+    RawRGBAImage *result = converter.deformatImageRaw( inStream );
+
+    
+    return result;
+    }
+
+
+
+
+static RawRGBAImage *readTGAFileRaw( File *inFile ) {
+    
+    if( !inFile->exists() ) {
+        char *fileName = inFile->getFullFileName();
         
-        *outX = round( inX );
+        char *logString = autoSprintf( 
+            "CRITICAL ERROR:  TGA file %s does not exist",
+            fileName );
+        delete [] fileName;
         
+        AppLog::criticalError( logString );
+        delete [] logString;
+    
+        return NULL;
+        }    
 
-        inY -= viewCenterY;
-        inY /= viewSize;
+
+    FileInputStream tgaStream( inFile );
+    
+
+    RawRGBAImage *result = readTGAFileRaw( &tgaStream );
+
+    if( result == NULL ) {        
+        char *fileName = inFile->getFullFileName();
         
-        inY *= -screenWidth;
-        inY += screenHeight/2;
+        char *logString = autoSprintf( 
+            "CRITICAL ERROR:  could not read TGA file %s, wrong format?",
+            fileName );
+        delete [] fileName;
         
-        *outY = round( inY );
-        }
-    else {
-        // raw screen coordinates
-        *outX = inX;
-        *outY = inY;
+        AppLog::criticalError( logString );
+        delete [] logString;
         }
+    
+    return result;
     }
 
 
 
+RawRGBAImage *readTGAFileRaw( const char *inTGAFileName ) {
 
+    File tgaFile( new Path( "graphics" ), inTGAFileName );
+    
+    return readTGAFileRaw( &tgaFile );
+    }
 
 
-void getLastMouseScreenPos( int *outX, int *outY ) {
-    *outX = lastMouseX;
-    *outY = lastMouseY;
+
+RawRGBAImage *readTGAFileRawBase( const char *inTGAFileName ) {
+
+    File tgaFile( NULL, inTGAFileName );
+    
+    return readTGAFileRaw( &tgaFile );
     }
 
 
 
-void GameSceneHandler::mouseMoved( int inX, int inY ) {
-    if( ignoreNextMouseEvent ) {
-        if( inX == xCoordToIgnore && inY == yCoordToIgnore ) {
-            // seeing the event that triggered the ignore
-            ignoreNextMouseEvent = false;
-            return;
-            }
-        else {
-            // stale pending event before the ignore
-            // skip it too
-            return;
-            }
-        }
+
+RawRGBAImage *readTGAFileRawFromBuffer( unsigned char *inBuffer, 
+                                        int inLength ) {
     
-    float x, y;
-    screenToWorld( inX, inY, &x, &y );
-    pointerMove( x, y );
+    ByteBufferInputStream tgaStream( inBuffer, inLength );
     
-    lastMouseX = inX;
-    lastMouseY = inY;
+    return readTGAFileRaw( &tgaStream );
     }
 
 
 
-void GameSceneHandler::mouseDragged( int inX, int inY ) {
-    if( ignoreNextMouseEvent ) {
-        if( inX == xCoordToIgnore && inY == yCoordToIgnore ) {
-            // seeing the event that triggered the ignore
-            ignoreNextMouseEvent = false;
-            return;
-            }
-        else {
-            // stale pending event before the ignore
-            // skip it too
-            return;
-            }
+
+
+// reads file contents and header
+// logs errors
+// returns NULL on failure, or file contents, destroyed by caller
+static unsigned char *readTGAFileContents( const char *inTGAFileName,
+                                           int *outLength,
+                                           TGAInfo *outInfo ) {
+    File tgaFile( new Path( "graphics" ), inTGAFileName );
+
+    unsigned char *data = NULL;
+    
+    if( tgaFile.exists() ) {
+        data = tgaFile.readFileContents( outLength );
         }
     
-    float x, y;
-    screenToWorld( inX, inY, &x, &y );
-    pointerDrag( x, y );
+    if( data == NULL ) {
+        AppLog::criticalErrorF( 
+            "CRITICAL ERROR:  could not read TGA file graphics/%s",
+            inTGAFileName );
+        return NULL;
+        }
 
-    lastMouseX = inX;
-    lastMouseY = inY;
+    if( ! readTGAInfo( data, *outLength, outInfo ) ) {
+        AppLog::criticalErrorF( 
+            "CRITICAL ERROR:  could not read TGA file graphics/%s, "
+            "wrong format?",
+            inTGAFileName );
+        delete [] data;
+        return NULL;
+        }
+    
+    return data;
     }
 
 
 
+static char decodeTGAFileContents( const char *inTGAFileName,
+                                   unsigned char *inData, int inLength,
+                                   unsigned char *outRGBA ) {
+    if( ! decodeTGAToRGBA( inData, inLength, outRGBA ) ) {
+        AppLog::criticalErrorF( 
+            "CRITICAL ERROR:  TGA file graphics/%s is truncated",
+            inTGAFileName );
+        return false;
+        }
+    return true;
+    }
 
-void GameSceneHandler::mousePressed( int inX, int inY ) {
-    float x, y;
-    screenToWorld( inX, inY, &x, &y );
-    pointerDown( x, y );
 
-    lastMouseX = inX;
-    lastMouseY = inY;
 
-    mouseDown = true;
-    mouseDownSteps = 0;
-    lastMouseDownX = inX;
-    lastMouseDownY = inY;
+char readTGAFileRGBA( const char *inTGAFileName,
+                      unsigned char *inBuffer, int inMaxPixels,
+                      int *outWidth, int *outHeight ) {
+    int length;
+    TGAInfo info;
+    
+    unsigned char *data = 
+        readTGAFileContents( inTGAFileName, &length, &info );
+    
+    if( data == NULL ) {
+        return false;
+        }
+    
+    *outWidth = info.width;
+    *outHeight = info.height;
+    
+    char result = false;
+    
+    if( info.width * info.height <= inMaxPixels ) {
+        result = decodeTGAFileContents( inTGAFileName, data, length,
+                                        inBuffer );
+        }
+    
+    delete [] data;
+    
+    return result;
     }
 
 
 
-void GameSceneHandler::mouseReleased( int inX, int inY ) {
-    float x, y;
-    screenToWorld( inX, inY, &x, &y );
-    pointerUp( x, y );
+unsigned char *readTGAFileRGBA( const char *inTGAFileName,
+                                int *outWidth, int *outHeight ) {
+    int length;
+    TGAInfo info;
+    
+    unsigned char *data = 
+        readTGAFileContents( inTGAFileName, &length, &info );
+    
+    if( data == NULL ) {
+        return NULL;
+        }
+    
+    unsigned char *rgba = new unsigned char[ info.width * info.height * 4 ];
+    
+    if( ! decodeTGAFileContents( inTGAFileName, data, length, rgba ) ) {
+        delete [] rgba;
+        rgba = NULL;
+        }
+    
+    delete [] data;
 
-    lastMouseX = inX;
-    lastMouseY = inY;
-    mouseDown = false;
+    *outWidth = info.width;
+    *outHeight = info.height;
 
-    // start new animation for release
-    mouseDownSteps = 0;
-    lastMouseDownX = inX;
-    lastMouseDownY = inY;
+    return rgba;
     }
 
 
 
-void GameSceneHandler::fireRedraw() {
-
-    if( !loadingDone ) {
-        mLoadingDuringFrameBatch = true;
-        }
+void writeTGAFile( const char *inTGAFileName, Image *inImage ) {
+    File tgaFile( NULL, inTGAFileName );
+    FileOutputStream tgaStream( &tgaFile );
     
-    if( mPaused ) {
-        // ignore redraw event
-        
-        mPausedDuringFrameBatch = true;
+    TGAImageConverter converter;
+    
+    return converter.formatImage( inImage, &tgaStream );
+    }
 
-        if( mPausedSleepTime > (unsigned int)( 5 * targetFrameRate ) ) {
-            // user has touched nothing for 5 seconds
-            
-            // sleep to avoid wasting CPU cycles
-            Thread::staticSleep( 500 );
-            }
-        
-        mPausedSleepTime++;
-        
-        return;
-        }
 
 
+SpriteHandle fillSprite( RawRGBAImage *inRawImage ) {
+    if( inRawImage->mNumChannels != 4 ) {
+        printf( "Sprite not a 4-channel image, "
+                "failed to load.\n" );
+    
+        return NULL;
+        }
+            
+    return fillSprite( inRawImage->mRGBABytes, 
+                       inRawImage->mWidth,
+                       inRawImage->mHeight );
     }
 
 
 
-static unsigned char lastKeyPressed = '\0';
+static char compressedSpritesOn = false;
 
 
-void GameSceneHandler::keyPressed(
-	unsigned char inKey, int inX, int inY ) {
+void toggleCompressedSprites( char inUseCompressed ) {
+    compressedSpritesOn = inUseCompressed;
+    }
 
-    if( writeFailed || loadingFailedFlag ) {
-        exit( 0 );
-        }
 
-    if( measureFrameRate && measureRecorded ) {
-        if( inKey == 'y' || inKey == 'Y' ) {
-            saveFrameRateSettings();
-            screen->startRecordingOrPlayback();
-            measureFrameRate = false;
-            }
-        else if( inKey == 27 ) {
-            exit( 0 );
-            }
+
+// returns NULL if there's no usable .ctex file next to the TGA file
+static SpriteHandle loadCompressedSprite( 
+    const char *inTGAFileName,
+    char inTransparentLowerLeftCorner ) {
+
+    char *baseName = stringDuplicate( inTGAFileName );
+    
+    char *dotPos = strrchr( baseName, '.' );
+    if( dotPos != NULL ) {
+        dotPos[0] = '\0';
         }
     
+    char *ctexName = autoSprintf( "%s.ctex", baseName );
+    delete [] baseName;
     
-
-    // reset to become responsive while paused
-    mPausedSleepTime = 0;
+    File ctexFile( new Path( "graphics" ), ctexName );
+    
+    delete [] ctexName;
+    
+    if( ! ctexFile.exists() ) {
+        return NULL;
+        }
     
+    int length;
+    unsigned char *data = ctexFile.readFileContents( &length );
+    
+    if( data == NULL ) {
+        return NULL;
+        }
+    
+    CompressedTexture *texture = 
+        CompressedTexture::readFromBytes( data, length );
+    
+    delete [] data;
+    
+    if( texture == NULL ) {
+        AppLog::errorF( "Compressed texture for graphics/%s damaged, "
+                        "using TGA file instead",
+                        inTGAFileName );
+        return NULL;
+        }
+    
+    char packedWithCorner = 
+        ( texture->getFlags() & 
+          COMPRESSED_TEXTURE_FLAG_TRANSPARENT_CORNER ) != 0;
+    
+    if( packedWithCorner != ( inTransparentLowerLeftCorner != 0 ) ) {
+        // packed for a different use, stale
+        delete texture;
+        return NULL;
+        }
+    
+    return fillSprite( texture );
+    }
 
-    if( mPaused && inKey == '%' && ! mBlockQuitting ) {
-        // % to quit from pause
-        exit( 0 );
+
+
+SpriteHandle loadSprite( const char *inTGAFileName,
+                         char inTransparentLowerLeftCorner ) {
+    
+    if( compressedSpritesOn ) {
+        SpriteHandle result = 
+            loadCompressedSprite( inTGAFileName, 
+                                  inTransparentLowerLeftCorner );
+        if( result != NULL ) {
+            return result;
+            }
         }
     
+    if( !inTransparentLowerLeftCorner ) {
+        // fastest to decode straight to RGBA, avoid double conversion
+        int w, h;
+        unsigned char *rgba = readTGAFileRGBA( inTGAFileName, &w, &h );
+        
+        if( rgba != NULL ) {
+            
+            SpriteHandle result = fillSprite( rgba, w, h );
+            
+            delete [] rgba;
+            
+            return result;
+            }
+        else {
+            printf( "Failed to load sprite from graphics/%s\n",
+                    inTGAFileName );
+            return NULL;
+            }
+        }
 
-    if( inKey == 9 && isCommandKeyDown() &&
-        screen->isPlayingBack() ) {
+    // or if trans corner, load converted to doubles for processing
+
+    Image *result = readTGAFile( inTGAFileName );
         
-        printf( "Caught alt-tab during playback, pausing\n" );
+    if( result == NULL ) {
+        return NULL;
+        }
+    else {
         
-        // alt-tab pressed during playback
-        // but we aren't actually being minimized during playback
-        // (because there's nothing to bring us back)
-        // Still, force a pause, so that user's unpause action after
-        // tabbing back in replays correctly
-        mPaused = true;
+        SpriteHandle sprite = fillSprite( result, 
+                                          inTransparentLowerLeftCorner );
+
+        delete result;
+        return sprite;
         }
-    
+    }
 
-    if( enableSpeedControlKeys ) {
+
+
+SpriteHandle loadSpriteBase( const char *inTGAFileName,
+                             char inTransparentLowerLeftCorner ) {
+    if( !inTransparentLowerLeftCorner ) {
+        // faster to load raw, avoid double conversion
+        RawRGBAImage *spriteImage = readTGAFileRawBase( inTGAFileName );
         
-        if( inKey == '^' ) {
-            // slow
-            mScreen->setMaxFrameRate( 2 );
-            mScreen->useFrameSleep( true );
+        if( spriteImage != NULL ) {
+            
+            SpriteHandle result = fillSprite( spriteImage );
+            
+            delete spriteImage;
+            
+            return result;
             }
-        if( inKey == '&' ) {
-            // half
-            mScreen->setMaxFrameRate( targetFrameRate / 2 );
-            mScreen->useFrameSleep( true );
+        else {
+            printf( "Failed to load sprite from %s\n",
+                    inTGAFileName );
+            return NULL;
             }
-        if( inKey == '*' ) {
-            // normal
-            mScreen->setMaxFrameRate( targetFrameRate );
-            
-            if( countingOnVsync ) {
-                mScreen->useFrameSleep( false );
-                }
-            else {
-                mScreen->useFrameSleep( true );
-                }
-            }            
-        if( inKey == '(' ) {
-            // fast forward
-            mScreen->setMaxFrameRate( targetFrameRate * 2 );
-            mScreen->useFrameSleep( true );
-            }            
-        if( inKey == ')' ) {
-            // fast fast forward
-            mScreen->setMaxFrameRate( targetFrameRate * 4 );
-            mScreen->useFrameSleep( true );
-            }            
-        if( inKey == '-' ) {
-            // fast fast fast forward
-            mScreen->setMaxFrameRate( targetFrameRate * 8 );
-            mScreen->useFrameSleep( true );
-            }            
         }
     
-    if( !hardToQuitMode ) {
-        // escape only
+    // or if trans corner, load converted to doubles for processing
 
-        if( inKey == 27 ) {
-            // escape always toggles pause
-            mPaused = !mPaused;
-            }
+    Image *result = readTGAFileBase( inTGAFileName );
+        
+    if( result == NULL ) {
+        return NULL;
         }
     else {
-        // # followed by ESC
-        if( lastKeyPressed == '#' && inKey == 27 ) {
-            exit( 0 );
-            }
-        lastKeyPressed = inKey;
-        }
+        
+        SpriteHandle sprite = fillSprite( result, 
+                                          inTransparentLowerLeftCorner );
 
-    keyDown( inKey );
+        delete result;
+        return sprite;
+        }
     }
 
 
 
-void GameSceneHandler::keyReleased(
-	unsigned char inKey, int inX, int inY ) {
 
-    keyUp( inKey );
+const char *translate( const char *inTranslationKey ) {
+    return TranslationManager::translate( inTranslationKey );
     }
 
 
 
-// need to track these separately from SDL_GetModState so that
-// we replay isCommandKeyDown properly during recorded game playback
-static char rCtrlDown = false;
-static char lCtrlDown = false;
+int getTranslationHandle( const char *inTranslationKey ) {
+    return TranslationManager::getKeyHandle( inTranslationKey );
+    }
 
-static char rAltDown = false;
-static char lAltDown = false;
 
-static char rMetaDown = false;
-static char lMetaDown = false;
 
-static char lShiftDown = false;
-static char rShiftDown = false;
+const char *translateHandle( int inTranslationHandle ) {
+    return TranslationManager::translateHandle( inTranslationHandle );
+    }
 
 
 
-void GameSceneHandler::specialKeyPressed(
-	int inKey, int inX, int inY ) {
-    
-    if( writeFailed || loadingFailedFlag ) {
-        exit( 0 );
+static Image **screenShotImageDest = NULL;
+
+
+void saveScreenShot( const char *inPrefix, Image **outImage ) {
+    if( screenShotPrefix != NULL ) {
+        delete [] screenShotPrefix;
         }
-    
-    switch( inKey ) {
-        case MG_KEY_RCTRL:
-            rCtrlDown = true;
-            break;
-        case MG_KEY_LCTRL:
-            lCtrlDown = true;
-            break;
-        case MG_KEY_RALT:
-            rAltDown = true;
-            break;
-        case MG_KEY_LALT:
-            lAltDown = true;
-            break;
-        case MG_KEY_RMETA:
-            rMetaDown = true;
-            break;
-        case MG_KEY_LMETA:
-            lMetaDown = true;
-            break;
-        case MG_KEY_RSHIFT:
-            rShiftDown = true;
-            break;
-        case MG_KEY_LSHIFT:
-            lShiftDown = true;
-            break;
+    screenShotPrefix = stringDuplicate( inPrefix );
+    shouldTakeScreenshot = true;
+    manualScreenShot = true;
+
+    screenShotImageDest = outImage;
+    }
+
+
+
+void startOutputAllFrames() {
+    if( screenShotPrefix != NULL ) {
+        delete [] screenShotPrefix;
         }
+    screenShotPrefix = stringDuplicate( "frame" );
     
-    
-    specialKeyDown( inKey );
-	}
+    outputAllFrames = true;
+    shouldTakeScreenshot = true;
+    }
 
 
+void stopOutputAllFrames() {
+    outputAllFrames = false;
+    shouldTakeScreenshot = false;
 
-void GameSceneHandler::specialKeyReleased(
-	int inKey, int inX, int inY ) {
-    
+    // frames still being read back
+    flushFrameCapture();
 
-    switch( inKey ) {
-        case MG_KEY_RCTRL:
-            rCtrlDown = false;
-            break;
-        case MG_KEY_LCTRL:
-            lCtrlDown = false;
-            break;
-        case MG_KEY_RALT:
-            rAltDown = false;
-            break;
-        case MG_KEY_LALT:
-            lAltDown = false;
-            break;
-        case MG_KEY_RMETA:
-            rMetaDown = false;
-            break;
-        case MG_KEY_LMETA:
-            lMetaDown = false;
-            break;
-        case MG_KEY_RSHIFT:
-            rShiftDown = false;
-            break;
-        case MG_KEY_LSHIFT:
-            lShiftDown = false;
-            break;
-        }
+    saveNextShotNumber();
+    }
 
 
-    specialKeyUp( inKey );
-    } 
 
 
 
-char isCommandKeyDown() {
-    SDLMod modState = SDL_GetModState();
+// if manualScreenShot false, then any blend settings (for saving blended 
+// double-frames) are applied
+// can return NULL in this case (when this frame should not be output
+// according to blending settings)
+//
+// Region in screen pixels
+static Image *getScreenRegionInternal( 
+    int inStartX, int inStartY, int inWidth, int inHeight,
+    char inForceManual = false ) {    
     
-
-    if( ( modState & KMOD_CTRL )
-        ||
-        ( modState & KMOD_ALT )
-        ||
-        ( modState & KMOD_META ) ) {
+    // make sure everything drawn so far is in the frame buffer
+    flushSpriteBatch();
         
-        return true;
-        }
-    
-    if( screen->isPlayingBack() ) {
-        // ignore these, saved internally, unless we're playing back
-        // they can fall out of sync with keyboard reality as the user
-        // alt-tabs between windows and release events are lost.
-        if( rCtrlDown || lCtrlDown ||
-            rAltDown || lAltDown ||
-            rMetaDown || lMetaDown ) {
-            return true;
-            }
-        }    
+    int numBytes = inWidth * inHeight * 3;
     
-    return false;
-    }
-
-
+    unsigned char *rgbBytes = 
+        new unsigned char[ numBytes ];
 
-char isShiftKeyDown() {
-    SDLMod modState = SDL_GetModState();
+    // w and h might not be multiples of 4
+    GLint oldAlignment;
+    glGetIntegerv( GL_PACK_ALIGNMENT, &oldAlignment );
+                
+    glPixelStorei( GL_PACK_ALIGNMENT, 1 );
+    
+    glReadPixels( inStartX, inStartY, inWidth, inHeight, 
+                  GL_RGB, GL_UNSIGNED_BYTE, rgbBytes );
     
+    glPixelStorei( GL_PACK_ALIGNMENT, oldAlignment );
 
-    if( ( modState & KMOD_SHIFT ) ) {
+
+    if( ! inForceManual &&
+        ! manualScreenShot && 
+        blendOutputFramePairs && 
+        frameNumber % 2 != 0 && 
+        lastFrame_rgbaBytes != NULL ) {
+        
+        // save blended frames on odd frames
+        if( blendOutputFrameFraction > 0 ) {
+            float blendA = 1 - blendOutputFrameFraction;
+            float blendB = blendOutputFrameFraction;
+            
+            for( int i=0; i<numBytes; i++ ) {
+                rgbBytes[i] = 
+                    (unsigned char)(
+                        blendA * rgbBytes[i] + 
+                        blendB * lastFrame_rgbaBytes[i] );
+                }
+            }
         
-        return true;
         }
-    
-    if( screen->isPlayingBack() ) {
-        // ignore these, saved internally, unless we're playing back
-        // they can fall out of sync with keyboard reality as the user
-        // alt-tabs between windows and release events are lost.
-        if( rShiftDown || lShiftDown ) {
-            return true;
+    else if( ! inForceManual &&
+             ! manualScreenShot &&
+             blendOutputFramePairs &&
+             frameNumber % 2 == 0 ) {
+        
+        // skip even frames, but save them for next blending
+        
+        if( lastFrame_rgbaBytes != NULL ) {
+            delete [] lastFrame_rgbaBytes;
+            lastFrame_rgbaBytes = NULL;
             }
+
+        lastFrame_rgbaBytes = rgbBytes;
+        
+        return NULL;
         }
     
-    return false;
-    }
 
+    Image *screenImage = new Image( inWidth, inHeight, 3, false );
 
+    double *channelOne = screenImage->getChannel( 0 );
+    double *channelTwo = screenImage->getChannel( 1 );
+    double *channelThree = screenImage->getChannel( 2 );
+        
+    // image of screen is upside down
+    int outputRow = 0;
+    for( int y=inHeight - 1; y>=0; y-- ) {
+        for( int x=0; x<inWidth; x++ ) {
+                        
+            int outputPixelIndex = outputRow * inWidth + x;
+            
+            
+            int regionPixelIndex = y * inWidth + x;
+            int byteIndex = regionPixelIndex * 3;
+                
+            // optimization found:  should unroll this loop over 3 channels
+            // divide by 255, with a multiply
+            channelOne[outputPixelIndex] = 
+                rgbBytes[ byteIndex++ ] * 0.003921569;
+            channelTwo[outputPixelIndex] = 
+                rgbBytes[ byteIndex++ ] * 0.003921569;
+            channelThree[outputPixelIndex] = 
+                rgbBytes[ byteIndex++ ] * 0.003921569;
+            }
+        outputRow++;
+        }
+    
+    delete [] rgbBytes;
 
-char isLastMouseButtonRight() {
-    return screen->isLastMouseButtonRight();
+    return screenImage;
     }
 
 
+Image *getScreenRegionRaw( 
+    int inStartX, int inStartY, int inWidth, int inHeight ) {
 
-void obscureRecordedNumericTyping( char inObscure, 
-                                   char inCharToRecordInstead ) {
-    
-    screen->obscureRecordedNumericTyping( inObscure, inCharToRecordInstead );
+    return getScreenRegionInternal( inStartX, inStartY, inWidth, inHeight,
+                                    true );
     }
 
 
 
 
-void GameSceneHandler::actionPerformed( GUIComponent *inTarget ) {
-    }
+// Background frame capture for outputAllFrames
+//
+// Frames are read back through a ring of pixel pack buffers, so
+// glReadPixels returns right away, and each buffer is only mapped once
+// it comes around again (by then, the GPU is long done with it).
+// Encoding and file writing happen on a pool of threads.
+//
+// File names are picked at capture time, in frame order, so frames can
+// finish encoding in any order without changing the output.
 
+#define NUM_FRAME_CAPTURE_BUFFERS 2
+#define NUM_FRAME_CAPTURE_THREADS 4
 
+// capture waits for encoders when this many frames are waiting, to
+// bound memory use (frames are never dropped)
+#define MAX_FRAME_CAPTURE_JOBS ( NUM_FRAME_CAPTURE_THREADS * 3 )
 
-static Image *readTGAFile( File *inFile ) {
-    
-    if( !inFile->exists() ) {
-        char *fileName = inFile->getFullFileName();
+
+// screen region read started by requestScreenRegionAsync
+typedef struct ScreenRegionRead {
+        int width;
+        int height;
         
-        char *logString = autoSprintf( 
-            "CRITICAL ERROR:  TGA file %s does not exist",
-            fileName );
-        delete [] fileName;
+        // reported done SCREEN_REGION_READ_FRAMES after this frame
+        unsigned int requestFrame;
         
-        AppLog::criticalError( logString );
-        delete [] logString;
-    
-        return NULL;
-        }    
-
-
-    FileInputStream tgaStream( inFile );
-    
-    TGAImageConverter converter;
-    
-    Image *result = converter.deformatImage( &tgaStream );
-
-    if( result == NULL ) {        
-        char *fileName = inFile->getFullFileName();
+        // pixel buffer being read into, 0 once mapped (or if read
+        // without pixel buffers)
+        GLuint buffer;
         
-        char *logString = autoSprintf( 
-            "CRITICAL ERROR:  could not read TGA file %s, wrong format?",
-            fileName );
-        delete [] fileName;
+        // set by encoder thread, under frameCaptureLock
+        Image *image;
+        char converted;
         
-        AppLog::criticalError( logString );
-        delete [] logString;
-        }
-    
-    return result;
-    }
-
-
-
-Image *readTGAFile( const char *inTGAFileName ) {
+        // handle cleared before conversion finished, so encoder thread
+        // destroys this record
+        char abandoned;
+    } ScreenRegionRead;
 
-    File tgaFile( new Path( "graphics" ), inTGAFileName );
-    
-    return readTGAFile( &tgaFile );
-    }
 
 
+typedef struct FrameCaptureJob {
+        // NULL for screen region reads
+        char *filePath;
+        
+        // rows bottom to top, as returned by glReadPixels
+        unsigned char *rgbBytes;
+        int width;
+        int height;
 
-Image *readTGAFileBase( const char *inTGAFileName ) {
+        // if not NULL, previous frame to blend in, with blendFraction
+        unsigned char *blendBytes;
+        float blendFraction;
+        
+        // if not NULL, rgbBytes are converted into an Image for this
+        // read instead of encoded into a file
+        ScreenRegionRead *regionRead;
+    } FrameCaptureJob;
 
-    File tgaFile( NULL, inTGAFileName );
-    
-    return readTGAFile( &tgaFile );
-    }
 
 
+// protects everything that encoder threads touch
+static MutexLock frameCaptureLock( "frameCaptureLock" );
 
+static SimpleVector<FrameCaptureJob> frameCaptureQueue;
 
-static RawRGBAImage *readTGAFileRaw( InputStream *inStream ) {
-    TGAImageConverter converter;
-    
-    RawRGBAImage *result = converter.deformatImageRaw( inStream );
+// queued or being encoded
+static int numFrameCaptureJobsPending = 0;
 
-    
-    return result;
-    }
+static char frameCaptureThreadsStopped = false;
 
+static BinarySemaphore frameCaptureJobSem;
+static BinarySemaphore frameCaptureJobDoneSem;
 
 
 
-static RawRGBAImage *readTGAFileRaw( File *inFile ) {
+// does not touch GL, safe on any thread
+static void encodeFrameCaptureJob( FrameCaptureJob *inJob ) {
+    int w = inJob->width;
+    int h = inJob->height;
+    int rowBytes = w * 3;
     
-    if( !inFile->exists() ) {
-        char *fileName = inFile->getFullFileName();
+    unsigned char *source = inJob->rgbBytes;
+
+    if( inJob->blendBytes != NULL ) {
+        float blendA = 1 - inJob->blendFraction;
+        float blendB = inJob->blendFraction;
         
-        char *logString = autoSprintf( 
-            "CRITICAL ERROR:  TGA file %s does not exist",
-            fileName );
-        delete [] fileName;
+        int numBytes = rowBytes * h;
         
-        AppLog::criticalError( logString );
-        delete [] logString;
+        for( int i=0; i<numBytes; i++ ) {
+            source[i] = 
+                (unsigned char)( blendA * source[i] + 
+                                 blendB * inJob->blendBytes[i] );
+            }
+        }
     
-        return NULL;
-        }    
-
-
-    FileInputStream tgaStream( inFile );
+    // image of screen is upside down
+    unsigned char *flipped = new unsigned char[ rowBytes * h ];
     
-
-    RawRGBAImage *result = readTGAFileRaw( &tgaStream );
-
-    if( result == NULL ) {        
-        char *fileName = inFile->getFullFileName();
-        
-        char *logString = autoSprintf( 
-            "CRITICAL ERROR:  could not read TGA file %s, wrong format?",
-            fileName );
-        delete [] fileName;
-        
-        AppLog::criticalError( logString );
-        delete [] logString;
+    for( int y=0; y<h; y++ ) {
+        memcpy( &( flipped[ y * rowBytes ] ),
+                &( source[ ( h - 1 - y ) * rowBytes ] ),
+                rowBytes );
         }
     
-    return result;
-    }
-
-
-
-RawRGBAImage *readTGAFileRaw( const char *inTGAFileName ) {
-
-    File tgaFile( new Path( "graphics" ), inTGAFileName );
+    // takes over flipped
+    Image frameImage( flipped, w, h, 3 );
     
-    return readTGAFileRaw( &tgaFile );
-    }
-
-
-
-RawRGBAImage *readTGAFileRawBase( const char *inTGAFileName ) {
-
-    File tgaFile( NULL, inTGAFileName );
+    File file( NULL, inJob->filePath );
     
-    return readTGAFileRaw( &tgaFile );
+    FileOutputStream stream( &file );
+    
+    // converters keep no per-image state, so sharing one across 
+    // threads is fine
+    screenShotConverter.formatImage( &frameImage, &stream );
     }
 
 
 
+// does not touch GL, safe on any thread
+static void convertScreenRegionJob( FrameCaptureJob *inJob ) {
+    int w = inJob->width;
+    int h = inJob->height;
+    
+    Image *image = new Image( w, h, 3, false );
 
-RawRGBAImage *readTGAFileRawFromBuffer( unsigned char *inBuffer, 
-                                        int inLength ) {
+    double *channelOne = image->getChannel( 0 );
+    double *channelTwo = image->getChannel( 1 );
+    double *channelThree = image->getChannel( 2 );
     
-    ByteBufferInputStream tgaStream( inBuffer, inLength );
+    // image of screen is upside down
+    for( int y=0; y<h; y++ ) {
+        unsigned char *row = &( inJob->rgbBytes[ ( h - 1 - y ) * w * 3 ] );
+        
+        int outputPixelIndex = y * w;
+        
+        for( int x=0; x<w; x++ ) {
+            // divide by 255, with a multiply
+            channelOne[outputPixelIndex] = row[0] * 0.003921569;
+            channelTwo[outputPixelIndex] = row[1] * 0.003921569;
+            channelThree[outputPixelIndex] = row[2] * 0.003921569;
+            
+            row += 3;
+            outputPixelIndex ++;
+            }
+        }
     
-    return readTGAFileRaw( &tgaStream );
+    ScreenRegionRead *r = inJob->regionRead;
+    
+    frameCaptureLock.lock();
+    
+    if( r->abandoned ) {
+        delete image;
+        delete r;
+        }
+    else {
+        r->image = image;
+        r->converted = true;
+        }
+    
+    frameCaptureLock.unlock();
     }
 
 
 
+class FrameCaptureThread : public Thread {
+    public:
+        
+        FrameCaptureThread() {
+            start();
+            }
+        
+        ~FrameCaptureThread() {
+            join();
+            }
 
+        
+        virtual void run() {
+            while( true ) {
+                
+                FrameCaptureJob job;
+                char gotJob = false;
+                
+                frameCaptureLock.lock();
+                
+                if( frameCaptureQueue.size() > 0 ) {
+                    job = frameCaptureQueue.getElementDirect( 0 );
+                    frameCaptureQueue.deleteElement( 0 );
+                    gotJob = true;
+                    }
+                
+                char moreJobs = ( frameCaptureQueue.size() > 0 );
+                
+                // only stop once queue is drained, so all frames get
+                // written out
+                char stop = frameCaptureThreadsStopped && ! gotJob;
+                
+                frameCaptureLock.unlock();
 
-void writeTGAFile( const char *inTGAFileName, Image *inImage ) {
-    File tgaFile( NULL, inTGAFileName );
-    FileOutputStream tgaStream( &tgaFile );
-    
-    TGAImageConverter converter;
-    
-    return converter.formatImage( inImage, &tgaStream );
-    }
-
+                if( stop ) {
+                    // pass stop signal along to other threads
+                    frameCaptureJobSem.signal();
+                    return;
+                    }
+                
+                if( ! gotJob ) {
+                    frameCaptureJobSem.wait();
+                    continue;
+                    }
 
+                if( moreJobs ) {
+                    // binary semaphore may have merged signals
+                    frameCaptureJobSem.signal();
+                    }
 
-SpriteHandle fillSprite( RawRGBAImage *inRawImage ) {
-    if( inRawImage->mNumChannels != 4 ) {
-        printf( "Sprite not a 4-channel image, "
-                "failed to load.\n" );
-    
-        return NULL;
-        }
-            
-    return fillSprite( inRawImage->mRGBABytes, 
-                       inRawImage->mWidth,
-                       inRawImage->mHeight );
-    }
+                if( job.regionRead != NULL ) {
+                    convertScreenRegionJob( &job );
+                    }
+                else {
+                    encodeFrameCaptureJob( &job );
+                    }
+                
+                if( job.filePath != NULL ) {
+                    delete [] job.filePath;
+                    }
+                delete [] job.rgbBytes;
+                if( job.blendBytes != NULL ) {
+                    delete [] job.blendBytes;
+                    }
+                
+                frameCaptureLock.lock();
+                numFrameCaptureJobsPending --;
+                frameCaptureLock.unlock();
+                
+                frameCaptureJobDoneSem.signal();
+                }
+            }
+    };
 
 
+static FrameCaptureThread *frameCaptureThreads[ NUM_FRAME_CAPTURE_THREADS ];
+static char frameCaptureThreadsStarted = false;
 
-SpriteHandle loadSprite( const char *inTGAFileName,
-                         char inTransparentLowerLeftCorner ) {
-    
-    if( !inTransparentLowerLeftCorner ) {
-        // faster to load raw, avoid double conversion
-        RawRGBAImage *spriteImage = readTGAFileRaw( inTGAFileName );
-        
-        if( spriteImage != NULL ) {
-            
-            SpriteHandle result = fillSprite( spriteImage );
-            
-            delete spriteImage;
-            
-            return result;
-            }
-        else {
-            printf( "Failed to load sprite from graphics/%s\n",
-                    inTGAFileName );
-            return NULL;
-            }
-        }
 
-    // or if trans corner, load converted to doubles for processing
 
-    Image *result = readTGAFile( inTGAFileName );
-        
-    if( result == NULL ) {
-        return NULL;
+// main thread only
+static void queueFrameCaptureJob( FrameCaptureJob inJob ) {
+    if( ! frameCaptureThreadsStarted ) {
+        for( int i=0; i<NUM_FRAME_CAPTURE_THREADS; i++ ) {
+            frameCaptureThreads[i] = new FrameCaptureThread();
+            }
+        frameCaptureThreadsStarted = true;
         }
-    else {
-        
-        SpriteHandle sprite = fillSprite( result, 
-                                          inTransparentLowerLeftCorner );
 
-        delete result;
-        return sprite;
+    frameCaptureLock.lock();
+    
+    while( numFrameCaptureJobsPending >= MAX_FRAME_CAPTURE_JOBS ) {
+        frameCaptureLock.unlock();
+        frameCaptureJobDoneSem.wait();
+        frameCaptureLock.lock();
         }
+    
+    frameCaptureQueue.push_back( inJob );
+    numFrameCaptureJobsPending ++;
+    
+    frameCaptureLock.unlock();
+
+    frameCaptureJobSem.signal();
     }
 
 
 
-SpriteHandle loadSpriteBase( const char *inTGAFileName,
-                             char inTransparentLowerLeftCorner ) {
-    if( !inTransparentLowerLeftCorner ) {
-        // faster to load raw, avoid double conversion
-        RawRGBAImage *spriteImage = readTGAFileRawBase( inTGAFileName );
-        
-        if( spriteImage != NULL ) {
-            
-            SpriteHandle result = fillSprite( spriteImage );
-            
-            delete spriteImage;
-            
-            return result;
+// frame held back to be blended into next one (blendOutputFramePairs)
+static unsigned char *frameCaptureBlendBytes = NULL;
+
+
+// main thread only
+// inRGBBytes destroyed by this call
+// inFilePath NULL for frames that are only held for blending
+static void finishFrameCapture( char *inFilePath, unsigned char *inRGBBytes,
+                                int inWidth, int inHeight ) {
+    if( inFilePath == NULL ) {
+        if( frameCaptureBlendBytes != NULL ) {
+            delete [] frameCaptureBlendBytes;
+            }
+        frameCaptureBlendBytes = inRGBBytes;
+        return;
+        }
+    
+    FrameCaptureJob job;
+    job.filePath = inFilePath;
+    job.rgbBytes = inRGBBytes;
+    job.width = inWidth;
+    job.height = inHeight;
+    job.blendBytes = NULL;
+    job.blendFraction = 0;
+    job.regionRead = NULL;
+    
+    if( frameCaptureBlendBytes != NULL ) {
+        if( blendOutputFramePairs && blendOutputFrameFraction > 0 ) {
+            job.blendBytes = frameCaptureBlendBytes;
+            job.blendFraction = blendOutputFrameFraction;
             }
         else {
-            printf( "Failed to load sprite from %s\n",
-                    inTGAFileName );
-            return NULL;
+            delete [] frameCaptureBlendBytes;
             }
+        frameCaptureBlendBytes = NULL;
         }
     
-    // or if trans corner, load converted to doubles for processing
+    queueFrameCaptureJob( job );
+    }
 
-    Image *result = readTGAFileBase( inTGAFileName );
+
+
+#ifndef RASPBIAN
+
+// pixel buffer objects (GL 2.1, or ARB_pixel_buffer_object), looked up
+// at runtime
+
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+#define FRAME_CAPTURE_PIXEL_PACK_BUFFER 0x88EB
+#define FRAME_CAPTURE_STREAM_READ 0x88E1
+#define FRAME_CAPTURE_READ_ONLY 0x88B8
+
+typedef void (APIENTRY *GenBuffersFunc)( GLsizei inN, GLuint *outBuffers );
+typedef void (APIENTRY *DeleteBuffersFunc)( GLsizei inN,
+                                            const GLuint *inBuffers );
+typedef void (APIENTRY *BindBufferFunc)( GLenum inTarget, GLuint inBuffer );
+typedef void (APIENTRY *BufferDataFunc)( GLenum inTarget, ptrdiff_t inSize,
+                                         const void *inData, GLenum inUsage );
+typedef void *(APIENTRY *MapBufferFunc)( GLenum inTarget, GLenum inAccess );
+typedef GLboolean (APIENTRY *UnmapBufferFunc)( GLenum inTarget );
+
+static GenBuffersFunc frameCaptureGenBuffers = NULL;
+static DeleteBuffersFunc frameCaptureDeleteBuffers = NULL;
+static BindBufferFunc frameCaptureBindBuffer = NULL;
+static BufferDataFunc frameCaptureBufferData = NULL;
+static MapBufferFunc frameCaptureMapBuffer = NULL;
+static UnmapBufferFunc frameCaptureUnmapBuffer = NULL;
+
+#endif
+
+
+static char frameCaptureInited = false;
+static char frameCaptureUsePBOs = false;
+
+
+typedef struct FrameCaptureSlot {
+        GLuint buffer;
+        int bufferBytes;
         
-    if( result == NULL ) {
-        return NULL;
+        char inUse;
+        char *filePath;
+        int width;
+        int height;
+    } FrameCaptureSlot;
+
+static FrameCaptureSlot frameCaptureSlots[ NUM_FRAME_CAPTURE_BUFFERS ];
+static int nextFrameCaptureSlot = 0;
+
+
+
+static char pixelBuffersChecked = false;
+static char pixelBuffersSupported = false;
+
+
+// main thread only
+// looks up pixel buffer object functions the first time
+// (also used by screen region reads)
+static char arePixelBuffersSupported() {
+    if( pixelBuffersChecked ) {
+        return pixelBuffersSupported;
         }
-    else {
-        
-        SpriteHandle sprite = fillSprite( result, 
-                                          inTransparentLowerLeftCorner );
+    pixelBuffersChecked = true;
+    
+#ifndef RASPBIAN
+    frameCaptureGenBuffers = 
+        (GenBuffersFunc)SDL_GL_GetProcAddress( "glGenBuffersARB" );
+    frameCaptureDeleteBuffers = 
+        (DeleteBuffersFunc)SDL_GL_GetProcAddress( "glDeleteBuffersARB" );
+    frameCaptureBindBuffer = 
+        (BindBufferFunc)SDL_GL_GetProcAddress( "glBindBufferARB" );
+    frameCaptureBufferData = 
+        (BufferDataFunc)SDL_GL_GetProcAddress( "glBufferDataARB" );
+    frameCaptureMapBuffer = 
+        (MapBufferFunc)SDL_GL_GetProcAddress( "glMapBufferARB" );
+    frameCaptureUnmapBuffer = 
+        (UnmapBufferFunc)SDL_GL_GetProcAddress( "glUnmapBufferARB" );
 
-        delete result;
-        return sprite;
+    const char *extensions = (const char*)glGetString( GL_EXTENSIONS );
+    
+    if( extensions != NULL &&
+        strstr( extensions, "GL_ARB_pixel_buffer_object" ) != NULL &&
+        frameCaptureGenBuffers != NULL &&
+        frameCaptureDeleteBuffers != NULL &&
+        frameCaptureBindBuffer != NULL &&
+        frameCaptureBufferData != NULL &&
+        frameCaptureMapBuffer != NULL &&
+        frameCaptureUnmapBuffer != NULL ) {
+        
+        pixelBuffersSupported = true;
         }
+#endif
+
+    return pixelBuffersSupported;
     }
 
 
 
+static void initFrameCapture() {
+    frameCaptureInited = true;
+    frameCaptureUsePBOs = false;
+    
+    for( int i=0; i<NUM_FRAME_CAPTURE_BUFFERS; i++ ) {
+        frameCaptureSlots[i].buffer = 0;
+        frameCaptureSlots[i].bufferBytes = 0;
+        frameCaptureSlots[i].inUse = false;
+        frameCaptureSlots[i].filePath = NULL;
+        }
 
-const char *translate( const char *inTranslationKey ) {
-    return TranslationManager::translate( inTranslationKey );
-    }
+    if( arePixelBuffersSupported() ) {
+        frameCaptureUsePBOs = true;
 
+#ifndef RASPBIAN
+        for( int i=0; i<NUM_FRAME_CAPTURE_BUFFERS; i++ ) {
+            frameCaptureGenBuffers( 1, &( frameCaptureSlots[i].buffer ) );
+            }
+#endif
+        }
 
+    if( frameCaptureUsePBOs ) {
+        AppLog::info( "Capturing frames through pixel buffer objects" );
+        }
+    else {
+        AppLog::info( "Pixel buffer objects not supported, capturing frames "
+                      "with blocking glReadPixels" );
+        }
+    }
 
-static Image **screenShotImageDest = NULL;
 
 
-void saveScreenShot( const char *inPrefix, Image **outImage ) {
-    if( screenShotPrefix != NULL ) {
-        delete [] screenShotPrefix;
+// main thread only
+// maps a slot's buffer and passes frame on to encoders
+static void finishFrameCaptureSlot( FrameCaptureSlot *inSlot ) {
+    if( ! inSlot->inUse ) {
+        return;
         }
-    screenShotPrefix = stringDuplicate( inPrefix );
-    shouldTakeScreenshot = true;
-    manualScreenShot = true;
+    inSlot->inUse = false;
+    
+    int numBytes = inSlot->width * inSlot->height * 3;
+    
+    unsigned char *rgbBytes = new unsigned char[ numBytes ];
+    
+#ifndef RASPBIAN
+    frameCaptureBindBuffer( FRAME_CAPTURE_PIXEL_PACK_BUFFER, inSlot->buffer );
+    
+    void *mapped = frameCaptureMapBuffer( FRAME_CAPTURE_PIXEL_PACK_BUFFER,
+                                          FRAME_CAPTURE_READ_ONLY );
+    if( mapped != NULL ) {
+        memcpy( rgbBytes, mapped, numBytes );
+        frameCaptureUnmapBuffer( FRAME_CAPTURE_PIXEL_PACK_BUFFER );
+        }
+    else {
+        AppLog::error( "Failed to map frame capture pixel buffer" );
+        memset( rgbBytes, 0, numBytes );
+        }
+    
+    frameCaptureBindBuffer( FRAME_CAPTURE_PIXEL_PACK_BUFFER, 0 );
+#endif
 
-    screenShotImageDest = outImage;
+    finishFrameCapture( inSlot->filePath, rgbBytes, 
+                        inSlot->width, inSlot->height );
+    
+    inSlot->filePath = NULL;
     }
 
 
 
-void startOutputAllFrames() {
-    if( screenShotPrefix != NULL ) {
-        delete [] screenShotPrefix;
+// main thread only
+// starts capture of whole screen
+// inFilePath destroyed internally, NULL to only hold frame for blending
+static void captureFrameAsync( char *inFilePath ) {
+    if( ! frameCaptureInited ) {
+        initFrameCapture();
         }
-    screenShotPrefix = stringDuplicate( "frame" );
     
-    outputAllFrames = true;
-    shouldTakeScreenshot = true;
-    }
+    // make sure everything drawn so far is in the frame buffer
+    flushSpriteBatch();
+    
+    int w = screenWidth;
+    int h = screenHeight;
+    int numBytes = w * h * 3;
+    
+    // w and h might not be multiples of 4
+    GLint oldAlignment;
+    glGetIntegerv( GL_PACK_ALIGNMENT, &oldAlignment );
+                
+    glPixelStorei( GL_PACK_ALIGNMENT, 1 );
 
+    if( ! frameCaptureUsePBOs ) {
+        unsigned char *rgbBytes = new unsigned char[ numBytes ];
+        
+        glReadPixels( 0, 0, w, h, GL_RGB, GL_UNSIGNED_BYTE, rgbBytes );
 
-void stopOutputAllFrames() {
-    outputAllFrames = false;
-    shouldTakeScreenshot = false;
-    }
+        glPixelStorei( GL_PACK_ALIGNMENT, oldAlignment );
+        
+        finishFrameCapture( inFilePath, rgbBytes, w, h );
+        return;
+        }
 
+#ifndef RASPBIAN
+    FrameCaptureSlot *slot = &( frameCaptureSlots[ nextFrameCaptureSlot ] );
+    
+    nextFrameCaptureSlot = 
+        ( nextFrameCaptureSlot + 1 ) % NUM_FRAME_CAPTURE_BUFFERS;
+    
+    // oldest frame in ring, read back long ago
+    finishFrameCaptureSlot( slot );
+    
+    frameCaptureBindBuffer( FRAME_CAPTURE_PIXEL_PACK_BUFFER, slot->buffer );
+    
+    if( slot->bufferBytes != numBytes ) {
+        frameCaptureBufferData( FRAME_CAPTURE_PIXEL_PACK_BUFFER, numBytes, 
+                                NULL, FRAME_CAPTURE_STREAM_READ );
+        slot->bufferBytes = numBytes;
+        }
+    
+    // into bound buffer, returns without waiting for GPU
+    glReadPixels( 0, 0, w, h, GL_RGB, GL_UNSIGNED_BYTE, 0 );
+    
+    frameCaptureBindBuffer( FRAME_CAPTURE_PIXEL_PACK_BUFFER, 0 );
 
+    glPixelStorei( GL_PACK_ALIGNMENT, oldAlignment );
 
+    slot->inUse = true;
+    slot->filePath = inFilePath;
+    slot->width = w;
+    slot->height = h;
+#endif
+    }
 
 
-// if manualScreenShot false, then any blend settings (for saving blended 
-// double-frames) are applied
-// can return NULL in this case (when this frame should not be output
-// according to blending settings)
-//
-// Region in screen pixels
-static Image *getScreenRegionInternal( 
-    int inStartX, int inStartY, int inWidth, int inHeight,
-    char inForceManual = false ) {    
-        
-    int numBytes = inWidth * inHeight * 3;
+
+// main thread only
+// for one-off shots that shouldn't wait in the read-back ring or be
+// blended:  reads screen right away, but still writes it in background
+// inFilePath destroyed internally
+static void captureScreenShotAsync( char *inFilePath ) {
+    flushSpriteBatch();
     
-    unsigned char *rgbBytes = 
-        new unsigned char[ numBytes ];
+    int w = screenWidth;
+    int h = screenHeight;
 
-    // w and h might not be multiples of 4
+    unsigned char *rgbBytes = new unsigned char[ w * h * 3 ];
+    
     GLint oldAlignment;
     glGetIntegerv( GL_PACK_ALIGNMENT, &oldAlignment );
                 
     glPixelStorei( GL_PACK_ALIGNMENT, 1 );
-    
-    glReadPixels( inStartX, inStartY, inWidth, inHeight, 
-                  GL_RGB, GL_UNSIGNED_BYTE, rgbBytes );
-    
+
+    glReadPixels( 0, 0, w, h, GL_RGB, GL_UNSIGNED_BYTE, rgbBytes );
+
     glPixelStorei( GL_PACK_ALIGNMENT, oldAlignment );
+    
+    FrameCaptureJob job;
+    job.filePath = inFilePath;
+    job.rgbBytes = rgbBytes;
+    job.width = w;
+    job.height = h;
+    job.blendBytes = NULL;
+    job.blendFraction = 0;
+    job.regionRead = NULL;
 
+    queueFrameCaptureJob( job );
+    }
 
-    if( ! inForceManual &&
-        ! manualScreenShot && 
-        blendOutputFramePairs && 
-        frameNumber % 2 != 0 && 
-        lastFrame_rgbaBytes != NULL ) {
-        
-        // save blended frames on odd frames
-        if( blendOutputFrameFraction > 0 ) {
-            float blendA = 1 - blendOutputFrameFraction;
-            float blendB = blendOutputFrameFraction;
-            
-            for( int i=0; i<numBytes; i++ ) {
-                rgbBytes[i] = 
-                    (unsigned char)(
-                        blendA * rgbBytes[i] + 
-                        blendB * lastFrame_rgbaBytes[i] );
-                }
-            }
-        
+
+
+// main thread only
+// passes frames still in read-back ring on to encoders
+static void flushFrameCapture() {
+    if( ! frameCaptureInited ) {
+        return;
         }
-    else if( ! inForceManual &&
-             ! manualScreenShot &&
-             blendOutputFramePairs &&
-             frameNumber % 2 == 0 ) {
-        
-        // skip even frames, but save them for next blending
-        
-        if( lastFrame_rgbaBytes != NULL ) {
-            delete [] lastFrame_rgbaBytes;
-            lastFrame_rgbaBytes = NULL;
-            }
 
-        lastFrame_rgbaBytes = rgbBytes;
-        
-        return NULL;
+    for( int i=0; i<NUM_FRAME_CAPTURE_BUFFERS; i++ ) {
+        finishFrameCaptureSlot( 
+            &( frameCaptureSlots[ nextFrameCaptureSlot ] ) );
+
+        nextFrameCaptureSlot = 
+            ( nextFrameCaptureSlot + 1 ) % NUM_FRAME_CAPTURE_BUFFERS;
         }
-    
+    }
 
-    Image *screenImage = new Image( inWidth, inHeight, 3, false );
 
-    double *channelOne = screenImage->getChannel( 0 );
-    double *channelTwo = screenImage->getChannel( 1 );
-    double *channelThree = screenImage->getChannel( 2 );
+
+// waits for all captured frames to be written
+static void freeFrameCapture() {
+    flushFrameCapture();
+    
+    if( frameCaptureThreadsStarted ) {
+        frameCaptureLock.lock();
+        frameCaptureThreadsStopped = true;
+        frameCaptureLock.unlock();
         
-    // image of screen is upside down
-    int outputRow = 0;
-    for( int y=inHeight - 1; y>=0; y-- ) {
-        for( int x=0; x<inWidth; x++ ) {
-                        
-            int outputPixelIndex = outputRow * inWidth + x;
-            
-            
-            int regionPixelIndex = y * inWidth + x;
-            int byteIndex = regionPixelIndex * 3;
-                
-            // optimization found:  should unroll this loop over 3 channels
-            // divide by 255, with a multiply
-            channelOne[outputPixelIndex] = 
-                rgbBytes[ byteIndex++ ] * 0.003921569;
-            channelTwo[outputPixelIndex] = 
-                rgbBytes[ byteIndex++ ] * 0.003921569;
-            channelThree[outputPixelIndex] = 
-                rgbBytes[ byteIndex++ ] * 0.003921569;
+        frameCaptureJobSem.signal();
+        
+        for( int i=0; i<NUM_FRAME_CAPTURE_THREADS; i++ ) {
+            delete frameCaptureThreads[i];
             }
-        outputRow++;
+        frameCaptureThreadsStarted = false;
         }
-    
-    delete [] rgbBytes;
 
-    return screenImage;
+#ifndef RASPBIAN
+    if( frameCaptureUsePBOs ) {
+        for( int i=0; i<NUM_FRAME_CAPTURE_BUFFERS; i++ ) {
+            frameCaptureDeleteBuffers( 1, &( frameCaptureSlots[i].buffer ) );
+            }
+        }
+#endif
+    
+    if( frameCaptureBlendBytes != NULL ) {
+        delete [] frameCaptureBlendBytes;
+        frameCaptureBlendBytes = NULL;
+        }
+    
+    frameCaptureInited = false;
     }
 
 
-Image *getScreenRegionRaw( 
-    int inStartX, int inStartY, int inWidth, int inHeight ) {
-
-    return getScreenRegionInternal( inStartX, inStartY, inWidth, inHeight,
-                                    true );
-    }
 
 
 
+static int nextShotNumber = -1;
 
 
-static int nextShotNumber = -1;
+// not saved for every frame of outputAllFrames, only when frames stop
+static void saveNextShotNumber() {
+    if( nextShotNumber >= 1 ) {
+        SettingsManager::setSetting( "nextScreenShotNumber", nextShotNumber );
+        }
+    }
 static char shotDirExists = false;
 
 static int outputFrameCount = 0;
@@ -4469,6 +7247,26 @@ void takeScreenShot() {
         shotDirExists = shotDir.exists();
         }
     
+    if( nextShotNumber < 1 ) {
+        // number saved last time saves us a scan of what could be a
+        // huge directory, as long as nothing has been put there since
+        int savedNumber = 
+            SettingsManager::getIntSetting( "nextScreenShotNumber", 0 );
+        
+        if( savedNumber >= 1 ) {
+            char *savedName = autoSprintf( "%s%05d.%s", 
+                                           screenShotPrefix, savedNumber,
+                                           screenShotExtension );
+            File *savedFile = shotDir.getChildFile( savedName );
+            delete [] savedName;
+            
+            if( ! savedFile->exists() ) {
+                nextShotNumber = savedNumber;
+                }
+            delete savedFile;
+            }
+        }
+    
     if( nextShotNumber < 1 ) {
         if( shotDir.exists() && shotDir.isDirectory() ) {
         
@@ -4528,6 +7326,37 @@ void takeScreenShot() {
         }
     
 
+    if( outputAllFrames && ! manualScreenShot && 
+        screenShotImageDest == NULL ) {
+        
+        // read back and write out in background
+        
+        // first of each blended pair is only held for blending
+        char *filePath = NULL;
+        
+        if( ! blendOutputFramePairs || frameNumber % 2 != 0 ) {
+            filePath = file->getFullFileName();
+            nextShotNumber++;
+            }
+        
+        captureFrameAsync( filePath );
+        
+        delete file;
+        return;
+        }
+    
+    if( screenShotImageDest == NULL ) {
+        // encode and write in background
+        captureScreenShotAsync( file->getFullFileName() );
+        
+        delete file;
+        
+        nextShotNumber++;
+        saveNextShotNumber();
+        return;
+        }
+    
+
     Image *screenImage = 
         getScreenRegionInternal( 0, 0, screenWidth, screenHeight );
 
@@ -4555,13 +7384,20 @@ void takeScreenShot() {
     delete file;
 
     nextShotNumber++;
+
+    if( ! outputAllFrames ) {
+        saveNextShotNumber();
+        }
     }
 
 
 
 
-Image *getScreenRegion( double inX, double inY, 
-                        double inWidth, double inHeight ) {
+// region in view space to region in screen pixels
+static void projectScreenRegion( double inX, double inY, 
+                                 double inWidth, double inHeight,
+                                 int *outStartX, int *outStartY,
+                                 int *outWidth, int *outHeight ) {
     
     double endX = inX + inWidth;
     double endY = inY + inHeight;
@@ -4587,17 +7423,25 @@ Image *getScreenRegion( double inX, double inY,
                 modelview, projection, viewport, 
                 &winEndX, &winEndY, &winEndZ );
 
+    *outStartX = lrint( winStartX );
+    *outStartY = lrint( winStartY );
+    *outWidth = lrint( winEndX - winStartX );
+    *outHeight = lrint( winEndY - winStartY );
+    }
+
 
 
+Image *getScreenRegion( double inX, double inY, 
+                        double inWidth, double inHeight ) {
+    
+    int x, y, w, h;
+    projectScreenRegion( inX, inY, inWidth, inHeight, &x, &y, &w, &h );
 
     char oldManual = manualScreenShot;
     manualScreenShot = true;
 
     
-    Image *result = 
-            getScreenRegionInternal( 
-                lrint( winStartX ), lrint( winStartY ), 
-                lrint( winEndX - winStartX ), lrint( winEndY - winStartY ) );
+    Image *result = getScreenRegionInternal( x, y, w, h );
 
     manualScreenShot = oldManual;
     
@@ -4606,6 +7450,280 @@ Image *getScreenRegion( double inX, double inY,
 
 
 
+// Async screen region reads
+//
+// Region is read into its own pixel buffer, so glReadPixels returns right
+// away.  The buffer is mapped a frame later (by then, the GPU is long done
+// with it), and its bytes are converted to an Image on the frame capture
+// threads.
+//
+// Reads are reported done a fixed number of frames after they start, 
+// waiting for conversion if it's somehow still going, so that recorded
+// games play back the same way.
+
+#define SCREEN_REGION_READ_FRAMES 2
+
+
+// indexed by handle, NULL once cleared
+static SimpleVector<ScreenRegionRead *> screenRegionReads;
+
+// handles of reads with pixel buffers not mapped yet
+static SimpleVector<int> screenRegionReadsToMap;
+
+
+
+// main thread only
+// inRGBBytes destroyed by this call
+static void queueScreenRegionConversion( ScreenRegionRead *inRead,
+                                         unsigned char *inRGBBytes ) {
+    FrameCaptureJob job;
+    job.filePath = NULL;
+    job.rgbBytes = inRGBBytes;
+    job.width = inRead->width;
+    job.height = inRead->height;
+    job.blendBytes = NULL;
+    job.blendFraction = 0;
+    job.regionRead = inRead;
+    
+    queueFrameCaptureJob( job );
+    }
+
+
+
+// main thread only
+static void mapScreenRegionRead( ScreenRegionRead *inRead ) {
+    if( inRead->buffer == 0 ) {
+        return;
+        }
+    
+    int numBytes = inRead->width * inRead->height * 3;
+    
+    unsigned char *rgbBytes = new unsigned char[ numBytes ];
+    
+#ifndef RASPBIAN
+    frameCaptureBindBuffer( FRAME_CAPTURE_PIXEL_PACK_BUFFER, 
+                            inRead->buffer );
+    
+    void *mapped = frameCaptureMapBuffer( FRAME_CAPTURE_PIXEL_PACK_BUFFER,
+                                          FRAME_CAPTURE_READ_ONLY );
+    if( mapped != NULL ) {
+        memcpy( rgbBytes, mapped, numBytes );
+        frameCaptureUnmapBuffer( FRAME_CAPTURE_PIXEL_PACK_BUFFER );
+        }
+    else {
+        AppLog::error( "Failed to map screen region pixel buffer" );
+        memset( rgbBytes, 0, numBytes );
+        }
+    
+    frameCaptureBindBuffer( FRAME_CAPTURE_PIXEL_PACK_BUFFER, 0 );
+    
+    frameCaptureDeleteBuffers( 1, &( inRead->buffer ) );
+#endif
+    
+    inRead->buffer = 0;
+    
+    queueScreenRegionConversion( inRead, rgbBytes );
+    }
+
+
+
+// main thread only, once per frame
+// maps buffers of reads started last frame
+static void stepScreenRegionReads() {
+    for( int i=0; i<screenRegionReadsToMap.size(); i++ ) {
+        int handle = screenRegionReadsToMap.getElementDirect( i );
+        
+        ScreenRegionRead *r = screenRegionReads.getElementDirect( handle );
+        
+        if( r == NULL || r->buffer == 0 ) {
+            // cleared, or mapped by an early check
+            screenRegionReadsToMap.deleteElement( i );
+            i--;
+            }
+        else if( frameNumber > r->requestFrame ) {
+            mapScreenRegionRead( r );
+            
+            screenRegionReadsToMap.deleteElement( i );
+            i--;
+            }
+        }
+    }
+
+
+
+int requestScreenRegionRawAsync( int inStartX, int inStartY, 
+                                 int inWidth, int inHeight ) {
+    
+    // make sure everything drawn so far is in the frame buffer
+    flushSpriteBatch();
+    
+    ScreenRegionRead *r = new ScreenRegionRead;
+    r->width = inWidth;
+    r->height = inHeight;
+    r->requestFrame = frameNumber;
+    r->buffer = 0;
+    r->image = NULL;
+    r->converted = false;
+    r->abandoned = false;
+    
+    int handle = screenRegionReads.size();
+    screenRegionReads.push_back( r );
+    
+    int numBytes = inWidth * inHeight * 3;
+    
+    // w and h might not be multiples of 4
+    GLint oldAlignment;
+    glGetIntegerv( GL_PACK_ALIGNMENT, &oldAlignment );
+                
+    glPixelStorei( GL_PACK_ALIGNMENT, 1 );
+    
+    if( arePixelBuffersSupported() ) {
+#ifndef RASPBIAN
+        frameCaptureGenBuffers( 1, &( r->buffer ) );
+        
+        frameCaptureBindBuffer( FRAME_CAPTURE_PIXEL_PACK_BUFFER, r->buffer );
+        frameCaptureBufferData( FRAME_CAPTURE_PIXEL_PACK_BUFFER, numBytes, 
+                                NULL, FRAME_CAPTURE_STREAM_READ );
+        
+        // into bound buffer, returns without waiting for GPU
+        glReadPixels( inStartX, inStartY, inWidth, inHeight, 
+                      GL_RGB, GL_UNSIGNED_BYTE, 0 );
+        
+        frameCaptureBindBuffer( FRAME_CAPTURE_PIXEL_PACK_BUFFER, 0 );
+#endif
+        screenRegionReadsToMap.push_back( handle );
+        }
+    else {
+        unsigned char *rgbBytes = new unsigned char[ numBytes ];
+
+        glReadPixels( inStartX, inStartY, inWidth, inHeight, 
+                      GL_RGB, GL_UNSIGNED_BYTE, rgbBytes );
+        
+        queueScreenRegionConversion( r, rgbBytes );
+        }
+    
+    glPixelStorei( GL_PACK_ALIGNMENT, oldAlignment );
+    
+    return handle;
+    }
+
+
+
+int requestScreenRegionAsync( double inX, double inY, 
+                              double inWidth, double inHeight ) {
+    int x, y, w, h;
+    projectScreenRegion( inX, inY, inWidth, inHeight, &x, &y, &w, &h );
+    
+    return requestScreenRegionRawAsync( x, y, w, h );
+    }
+
+
+
+char checkScreenRegionAsyncDone( int inHandle ) {
+    if( inHandle < 0 || inHandle >= screenRegionReads.size() ) {
+        return false;
+        }
+    
+    ScreenRegionRead *r = screenRegionReads.getElementDirect( inHandle );
+    
+    if( r == NULL ||
+        frameNumber < r->requestFrame + SCREEN_REGION_READ_FRAMES ) {
+        return false;
+        }
+    
+    // in case frame stepping hasn't reached it
+    mapScreenRegionRead( r );
+    
+    frameCaptureLock.lock();
+    
+    while( ! r->converted ) {
+        frameCaptureLock.unlock();
+        frameCaptureJobDoneSem.wait();
+        frameCaptureLock.lock();
+        }
+    
+    frameCaptureLock.unlock();
+    
+    return true;
+    }
+
+
+
+// frame capture threads must be stopped first
+static void freeScreenRegionReads() {
+    for( int i=0; i<screenRegionReads.size(); i++ ) {
+        ScreenRegionRead *r = screenRegionReads.getElementDirect( i );
+        
+        if( r == NULL ) {
+            continue;
+            }
+        
+#ifndef RASPBIAN
+        if( r->buffer != 0 ) {
+            frameCaptureDeleteBuffers( 1, &( r->buffer ) );
+            }
+#endif
+        if( r->image != NULL ) {
+            delete r->image;
+            }
+        delete r;
+        }
+    
+    screenRegionReads.deleteAll();
+    screenRegionReadsToMap.deleteAll();
+    }
+
+
+
+Image *getScreenRegionAsyncImage( int inHandle ) {
+    if( inHandle < 0 || inHandle >= screenRegionReads.size() ) {
+        return NULL;
+        }
+    
+    ScreenRegionRead *r = screenRegionReads.getElementDirect( inHandle );
+    
+    if( r == NULL ) {
+        return NULL;
+        }
+    
+    char done = checkScreenRegionAsyncDone( inHandle );
+    
+    *( screenRegionReads.getElement( inHandle ) ) = NULL;
+    
+    if( done ) {
+        Image *result = r->image;
+        delete r;
+        return result;
+        }
+    
+    // abandon
+    if( r->buffer != 0 ) {
+        // never queued for conversion
+#ifndef RASPBIAN
+        frameCaptureDeleteBuffers( 1, &( r->buffer ) );
+#endif
+        delete r;
+        return NULL;
+        }
+    
+    frameCaptureLock.lock();
+    
+    if( r->converted ) {
+        delete r->image;
+        delete r;
+        }
+    else {
+        // encoder thread destroys it
+        r->abandoned = true;
+        }
+    
+    frameCaptureLock.unlock();
+    
+    return NULL;
+    }
+
+
+
 
 
 
@@ -4613,44 +7731,303 @@ int nextWebRequestHandle = 0;
 
 
 
+static void freeWebCacheRecord( WebCacheRecord *inRecord ) {
+    if( inRecord->fileReadHandle != -1 ) {
+        int length;
+        // abandons read if not done
+        unsigned char *data = 
+            getAsyncFileData( inRecord->fileReadHandle, &length );
+        
+        if( data != NULL ) {
+            delete [] data;
+            }
+        }
+    
+    if( inRecord->body != NULL ) {
+        delete [] inRecord->body;
+        }
+    
+    delete [] inRecord->url;
+    delete inRecord;
+    }
+
+
+
+static void startCachedWebRequest( int inHandle, const char *inURL ) {
+    WebCacheRecord *c = new WebCacheRecord;
+    
+    c->url = stringDuplicate( inURL );
+    c->revalidating = false;
+    c->fileReadHandle = -1;
+    c->body = NULL;
+    c->bodySize = 0;
+    
+    webCacheRecords.insert( inHandle, c );
+    
+    char fresh;
+    char *eTag;
+    char *path = webCache->lookup( inURL, &fresh, &eTag );
+    
+    if( path != NULL && fresh ) {
+        // no need to ask server
+        c->fileReadHandle = startAsyncFileRead( path );
+        numWebCacheHits ++;
+        }
+    else {
+        WebRequest *r = new WebRequest( "GET", inURL, NULL, webProxy );
+        
+        if( eTag != NULL ) {
+            // 304 if our copy is still current
+            r->addHeader( "If-None-Match", eTag );
+            c->revalidating = true;
+            }
+        
+        webRequestRecords.insert( inHandle, r );
+        }
+    
+    if( path != NULL ) {
+        delete [] path;
+        }
+    if( eTag != NULL ) {
+        delete [] eTag;
+        }
+    }
+
+
+
+// replaces cached body or conditional request for handle with a
+// plain request for URL
+static void restartCachedWebRequest( int inHandle, 
+                                     WebCacheRecord *inRecord ) {
+    
+    WebCacheRecord *c = inRecord;
+    
+    if( c->fileReadHandle != -1 ) {
+        int length;
+        unsigned char *data = getAsyncFileData( c->fileReadHandle, &length );
+        
+        if( data != NULL ) {
+            delete [] data;
+            }
+        c->fileReadHandle = -1;
+        }
+
+    if( c->body != NULL ) {
+        delete [] c->body;
+        c->body = NULL;
+        c->bodySize = 0;
+        }
+
+    WebRequest *r;
+    
+    if( webRequestRecords.lookup( inHandle, &r ) ) {
+        delete r;
+        }
+    
+    webRequestRecords.insert( 
+        inHandle, new WebRequest( "GET", c->url, NULL, webProxy ) );
+
+    c->revalidating = false;
+    }
+
+
+
+// for requests whose bodies are streamed or partial, which aren't cached
+// must be called before first step
+static void stopCachingWebRequest( int inHandle ) {
+    WebCacheRecord *c;
+    
+    if( ! webCacheRecords.lookup( inHandle, &c ) ) {
+        return;
+        }
+    
+    if( c->revalidating || ! webRequestRecords.contains( inHandle ) ) {
+        // caller expects a body from the server
+        restartCachedWebRequest( inHandle, c );
+        }
+    
+    freeWebCacheRecord( c );
+    webCacheRecords.remove( inHandle );
+    }
+
+
+
+// record for handle, if its body is coming from cache rather than from
+// a WebRequest
+static WebCacheRecord *getCacheHitByHandle( int inHandle ) {
+    WebCacheRecord *c;
+    
+    if( webCacheRecords.lookup( inHandle, &c ) &&
+        ( c->fileReadHandle != -1 || c->body != NULL ) ) {
+        return c;
+        }
+    return NULL;
+    }
+
+
+
+static void storeWebResult( const char *inURL, WebRequest *inRequest ) {
+    int maxAge = inRequest->getCacheMaxAge();
+    char *eTag = inRequest->getETag();
+    
+    // without either, we'd never be able to use it
+    if( ! inRequest->isNoStore() && 
+        ( maxAge > 0 || eTag != NULL ) ) {
+        
+        if( maxAge < 0 ) {
+            maxAge = 0;
+            }
+        
+        int size;
+        unsigned char *body = inRequest->getResult( &size );
+        
+        webCache->store( inURL, body, size, eTag, maxAge );
+        
+        delete [] body;
+        }
+    else {
+        // any older copy is out of date
+        webCache->remove( inURL );
+        }
+    
+    if( eTag != NULL ) {
+        delete [] eTag;
+        }
+    }
+
+
+
+
 
 int startWebRequest( const char *inMethod, const char *inURL,
                      const char *inBody ) {
     
-    WebRequestRecord r;
+    int handle = nextWebRequestHandle;
+    nextWebRequestHandle ++;
+    
+
+    if( screen->isPlayingBack() ) {
+        // stop here, don't actually start a real web request
+        return handle;
+        }
+
+
+    if( webCache != NULL && ! screen->isRecording() &&
+        inBody == NULL && strcmp( inMethod, "GET" ) == 0 ) {
+        // cache reads would shift async file handles during playback,
+        // so recordings don't use cache
+        startCachedWebRequest( handle, inURL );
+        return handle;
+        }
+    
+
+    webRequestRecords.insert( 
+        handle, new WebRequest( inMethod, inURL, inBody, webProxy ) );
+    
+    return handle;
+    }
+
+
+
+static WebRequest *getRequestByHandle( int inHandle ) {
+    WebRequest *request;
+    
+    if( webRequestRecords.lookup( inHandle, &request ) ) {
+        return request;
+        }
+
+    // else not found?
+    AppLog::error( "gameSDL - getRequestByHandle:  "
+                   "Requested WebRequest handle not found\n" );
+    return NULL;
+    }
+
+
+
+static int stepCachedWebRequest( int inHandle, 
+                                 WebCacheRecord *inRecord ) {
+    WebCacheRecord *c = inRecord;
+    
+    if( c->body != NULL ) {
+        return 1;
+        }
+    
+    if( c->fileReadHandle != -1 ) {
+        if( ! checkAsyncFileReadDone( c->fileReadHandle ) ) {
+            return 0;
+            }
+        
+        c->body = getAsyncFileData( c->fileReadHandle, &( c->bodySize ) );
+        c->fileReadHandle = -1;
+        
+        if( c->body == NULL ) {
+            AppLog::errorF( "gameSDL - Failed to read cached web result "
+                            "for %s, requesting it again\n", c->url );
+            
+            webCache->remove( c->url );
+            restartCachedWebRequest( inHandle, c );
+            return 0;
+            }
+        return 1;
+        }
+    
     
-    r.handle = nextWebRequestHandle;
-    nextWebRequestHandle ++;
+    WebRequest *r = getRequestByHandle( inHandle );
     
-
-    if( screen->isPlayingBack() ) {
-        // stop here, don't actually start a real web request
-        return r.handle;
+    if( r == NULL ) {
+        return -1;
         }
-
-
-    r.request = new WebRequest( inMethod, inURL, inBody, webProxy );
     
-    webRequestRecords.push_back( r );
+    int stepResult = r->step();
     
-    return r.handle;
-    }
-
-
-
-static WebRequest *getRequestByHandle( int inHandle ) {
-    for( int i=0; i<webRequestRecords.size(); i++ ) {
-        WebRequestRecord *r = webRequestRecords.getElement( i );
+    if( stepResult != 1 ) {
+        return stepResult;
+        }
+    
+    
+    int status = r->getStatusCode();
+    
+    if( c->revalidating && status == 304 ) {
+        int maxAge = r->getCacheMaxAge();
         
-        if( r->handle == inHandle ) {
-            return r->request;
+        if( maxAge < 0 ) {
+            maxAge = 0;
             }
-        }
+        
+        webCache->refresh( c->url, maxAge );
+        
+        char fresh;
+        char *eTag;
+        char *path = webCache->lookup( c->url, &fresh, &eTag );
+        
+        if( eTag != NULL ) {
+            delete [] eTag;
+            }
+        
+        if( path == NULL ) {
+            // entry dropped while we were asking
+            restartCachedWebRequest( inHandle, c );
+            return 0;
+            }
+        
+        delete r;
+        webRequestRecords.remove( inHandle );
+        
+        c->revalidating = false;
+        c->fileReadHandle = startAsyncFileRead( path );
+        
+        delete [] path;
 
-    // else not found?
-    AppLog::error( "gameSDL - getRequestByHandle:  "
-                   "Requested WebRequest handle not found\n" );
-    return NULL;
+        numWebCacheRevalidations ++;
+        return 0;
+        }
+    
+    if( status == 200 ) {
+        numWebCacheMisses ++;
+        storeWebResult( c->url, r );
+        }
+    
+    return 1;
     }
 
 
@@ -4678,9 +8055,23 @@ int stepWebRequest( int inHandle ) {
         }
     
 
+    WebCacheRecord *c;
+    
+    if( webCacheRecords.lookup( inHandle, &c ) ) {
+        PROFILE_ZONE( "stepWebRequest" );
+        
+        int stepResult = stepCachedWebRequest( inHandle, c );
+        
+        screen->registerWebEvent( inHandle, stepResult );
+        
+        return stepResult;
+        }
+    
+
     WebRequest *r = getRequestByHandle( inHandle );
     
     if( r != NULL ) {
+        PROFILE_ZONE( "stepWebRequest" );
         
         int stepResult = r->step();
         
@@ -4714,6 +8105,23 @@ char *getWebResult( int inHandle ) {
 
 
 
+    WebCacheRecord *c = getCacheHitByHandle( inHandle );
+    
+    if( c != NULL ) {
+        if( c->body == NULL ) {
+            return NULL;
+            }
+        
+        char *result = new char[ c->bodySize + 1 ];
+        memcpy( result, c->body, c->bodySize );
+        result[ c->bodySize ] = '\0';
+        
+        screen->registerWebEvent( inHandle, 2, result );
+        
+        return result;
+        }
+    
+
     WebRequest *r = getRequestByHandle( inHandle );
     
     if( r != NULL ) {
@@ -4755,6 +8163,23 @@ unsigned char *getWebResult( int inHandle, int *outSize ) {
 
 
 
+    WebCacheRecord *c = getCacheHitByHandle( inHandle );
+    
+    if( c != NULL ) {
+        if( c->body == NULL ) {
+            return NULL;
+            }
+        
+        unsigned char *result = new unsigned char[ c->bodySize ];
+        memcpy( result, c->body, c->bodySize );
+        *outSize = c->bodySize;
+        
+        screen->registerWebEvent( inHandle, 2, (char*)result, *outSize );
+        
+        return result;
+        }
+    
+
     WebRequest *r = getRequestByHandle( inHandle );
     
     if( r != NULL ) {
@@ -4776,6 +8201,66 @@ unsigned char *getWebResult( int inHandle, int *outSize ) {
 
 
 
+void setWebResponseSink( int inHandle, WebResponseSink *inSink ) {
+    if( screen->isPlayingBack() ) {
+        // not a real request, no body to stream
+        return;
+        }
+    
+    stopCachingWebRequest( inHandle );
+
+    WebRequest *r = getRequestByHandle( inHandle );
+    
+    if( r != NULL ) {
+        r->setResponseSink( inSink );
+        }
+    }
+
+
+
+void setWebRequestRange( int inHandle, int inFirstByte, int inLastByte ) {
+    if( screen->isPlayingBack() ) {
+        // not a real request
+        return;
+        }
+    
+    stopCachingWebRequest( inHandle );
+
+    WebRequest *r = getRequestByHandle( inHandle );
+    
+    if( r != NULL ) {
+        r->setRange( inFirstByte, inLastByte );
+        }
+    }
+
+
+
+int getWebStatusCode( int inHandle ) {
+    if( screen->isPlayingBack() ) {
+        return 0;
+        }
+    
+    WebCacheRecord *c = getCacheHitByHandle( inHandle );
+    
+    if( c != NULL ) {
+        // body from cache, or server said ours was still current
+        if( c->body != NULL ) {
+            return 200;
+            }
+        return 0;
+        }
+    
+    WebRequest *r = getRequestByHandle( inHandle );
+    
+    if( r != NULL ) {
+        return r->getStatusCode();
+        }
+    
+    return 0;
+    }
+
+
+
 int getWebProgressSize( int inHandle ) {
     if( screen->isPlayingBack() ) {
         // return a recorded server result
@@ -4796,25 +8281,38 @@ int getWebProgressSize( int inHandle ) {
     
 
 
-    WebRequest *r = getRequestByHandle( inHandle );
+    int progress;
     
-    if( r != NULL ) {
-        int progress = r->getProgressSize();
-        if( progress > 2 ) {    
-            screen->registerWebEvent( inHandle,
-                                      // the type for "progress" is 
-                                      // the actual size
-                                      progress );
-            return progress;
+    WebCacheRecord *c = getCacheHitByHandle( inHandle );
+    
+    if( c != NULL ) {
+        progress = 0;
+        
+        if( c->body != NULL ) {
+            progress = c->bodySize;
             }
-        else {
-            // progress of 2 or less is returned as 0, to keep consistency
-            // for recording and playback
+        }
+    else {
+        WebRequest *r = getRequestByHandle( inHandle );
+        
+        if( r == NULL ) {
             return 0;
             }
+        progress = r->getProgressSize();
         }
     
-    return 0;
+    if( progress > 2 ) {    
+        screen->registerWebEvent( inHandle,
+                                  // the type for "progress" is 
+                                  // the actual size
+                                  progress );
+        return progress;
+        }
+    else {
+        // progress of 2 or less is returned as 0, to keep consistency
+        // for recording and playback
+        return 0;
+        }
     }
 
     
@@ -4831,17 +8329,32 @@ void clearWebRequest( int inHandle ) {
         }
         
 
-    for( int i=0; i<webRequestRecords.size(); i++ ) {
-        WebRequestRecord *r = webRequestRecords.getElement( i );
+    char found = false;
+    
+    WebCacheRecord *c;
+    
+    if( webCacheRecords.lookup( inHandle, &c ) ) {
+        freeWebCacheRecord( c );
         
-        if( r->handle == inHandle ) {
-            delete r->request;
-            
-            webRequestRecords.deleteElement( i );
-            
-            // found, done
-            return;
-            }
+        webCacheRecords.remove( inHandle );
+
+        // cache hits have no WebRequest
+        found = true;
+        }
+    
+
+    WebRequest *request;
+    
+    if( webRequestRecords.lookup( inHandle, &request ) ) {
+        delete request;
+        
+        webRequestRecords.remove( inHandle );
+        
+        found = true;
+        }
+
+    if( found ) {
+        return;
         }
 
     // else not found?
@@ -4858,15 +8371,13 @@ int nextSocketConnectionHandle = 0;
 
 
 int openSocketConnection( const char *inNumericalAddress, int inPort ) {
-    SocketConnectionRecord r;
-    
-    r.handle = nextSocketConnectionHandle;
+    int handle = nextSocketConnectionHandle;
     nextSocketConnectionHandle++;
 
 
     if( screen->isPlayingBack() ) {
         // stop here, don't actually open a real socket
-        return r.handle;
+        return handle;
         }
 
     HostAddress address( stringDuplicate( inNumericalAddress ), inPort );
@@ -4874,28 +8385,250 @@ int openSocketConnection( const char *inNumericalAddress, int inPort ) {
 
     char timedOut;
     
-    // non-blocking connet
-    r.sock = SocketClient::connectToServer( &address, 0, &timedOut );
+    // non-blocking connet
+    Socket *sock = SocketClient::connectToServer( &address, 0, &timedOut );
+    
+    if( sock != NULL ) {
+        socketConnectionRecords.insert( handle, sock );
+        
+        return handle;
+        }
+    else {
+        return -1;
+        }
+    }
+
+
+
+// how long an attempt gets to connect before the next address is tried
+// alongside it (the "connection attempt delay" of RFC 8305)
+static double socketConnectAttemptDelay = 0.25;
+
+
+
+static Socket *startConnectAttempt( const char *inNumericalAddress,
+                                    int inPort ) {
+    HostAddress address( stringDuplicate( inNumericalAddress ), inPort );
+
+    char timedOut;
+    
+    // non-blocking connect
+    return SocketClient::connectToServer( &address, 0, &timedOut );
+    }
+
+
+
+int openSocketConnectionToAny( const char **inNumericalAddresses,
+                               int inNumAddresses, int inPort ) {
+    if( inNumAddresses < 1 ) {
+        return -1;
+        }
+    
+    int handle = nextSocketConnectionHandle;
+    nextSocketConnectionHandle++;
+
+
+    if( screen->isPlayingBack() ) {
+        // stop here, don't actually open a real socket
+        return handle;
+        }
+
+    PendingSocketConnect *p = new PendingSocketConnect;
+    
+    for( int i=0; i<inNumAddresses; i++ ) {
+        p->addresses.push_back( stringDuplicate( inNumericalAddresses[i] ) );
+        }
+    p->port = inPort;
+    p->nextAddress = 0;
+    p->nextAttemptTime = 0;
+    p->connected = false;
+    p->failed = false;
+    
+    pendingSocketConnects.insert( handle, p );
+    
+    // start first attempt now
+    stepPendingSocketConnects();
+    
+    return handle;
+    }
+
+
+
+static void freePendingSocketConnect( PendingSocketConnect *inConnect ) {
+    inConnect->addresses.deallocateStringElements();
+
+    for( int i=0; i<inConnect->attempts.size(); i++ ) {
+        delete inConnect->attempts.getElementDirect( i );
+        }
+    delete inConnect;
+    }
+
+
+
+// true if connect done (either connected or failed)
+static char stepPendingSocketConnect( int inHandle, 
+                                      PendingSocketConnect *inConnect ) {
+    if( inConnect->connected || inConnect->failed ) {
+        return true;
+        }
+    
+    for( int i=0; i<inConnect->attempts.size(); i++ ) {
+        Socket *sock = inConnect->attempts.getElementDirect( i );
+        
+        int connected = sock->isConnected();
+        
+        if( connected == 1 ) {
+            // first to connect wins, rest are dropped
+            inConnect->attempts.deleteElement( i );
+            
+            socketConnectionRecords.insert( inHandle, sock );
+            inConnect->connected = true;
+            return true;
+            }
+        else if( connected == -1 ) {
+            delete sock;
+            inConnect->attempts.deleteElement( i );
+            i--;
+
+            // don't wait out the delay for a failed attempt
+            inConnect->nextAttemptTime = 0;
+            }
+        }
+
+    double now = Time::getCurrentTime();
+    
+    while( inConnect->nextAddress < inConnect->addresses.size() &&
+           now >= inConnect->nextAttemptTime ) {
+        
+        Socket *sock = startConnectAttempt( 
+            inConnect->addresses.getElementDirect( inConnect->nextAddress ),
+            inConnect->port );
+        
+        inConnect->nextAddress++;
+        
+        if( sock != NULL ) {
+            inConnect->attempts.push_back( sock );
+            inConnect->nextAttemptTime = now + socketConnectAttemptDelay;
+            }
+        }
+    
+    if( inConnect->attempts.size() == 0 && 
+        inConnect->nextAddress >= inConnect->addresses.size() ) {
+        inConnect->failed = true;
+        return true;
+        }
+
+    return false;
+    }
+
+
+
+// called once per frame
+static void stepPendingSocketConnects() {
+    SimpleVector<int> connectedHandles;
+
+    int numSlots = pendingSocketConnects.getNumSlots();
+    
+    for( int i=0; i<numSlots; i++ ) {
+        if( pendingSocketConnects.isSlotFilled( i ) ) {
+            int handle = pendingSocketConnects.getSlotKey( i );
+            PendingSocketConnect *p = 
+                *( pendingSocketConnects.getSlotValue( i ) );
+            
+            stepPendingSocketConnect( handle, p );
+            
+            if( p->connected ) {
+                connectedHandles.push_back( handle );
+                }
+            }
+        }
+    
+    // remove after walking, so slots don't shift under us
+    for( int i=0; i<connectedHandles.size(); i++ ) {
+        int handle = connectedHandles.getElementDirect( i );
+        
+        PendingSocketConnect *p;
+        if( pendingSocketConnects.lookup( handle, &p ) ) {
+            freePendingSocketConnect( p );
+            pendingSocketConnects.remove( handle );
+            }
+        }
+    }
+
+
+
+static PendingSocketConnect *getPendingSocketConnect( int inHandle ) {
+    PendingSocketConnect *p;
+    
+    if( pendingSocketConnects.lookup( inHandle, &p ) ) {
+        return p;
+        }
+    return NULL;
+    }
+
+
+
+int getSocketConnectionState( int inHandle ) {
+    if( screen->isPlayingBack() ) {
+        int nextType, nextNumBodyBytes;
+        screen->getSocketEventTypeAndSize( inHandle, 
+                                           &nextType, &nextNumBodyBytes );
+        
+        if( nextType == 4 ) {
+            return nextNumBodyBytes;
+            }
+        return -1;
+        }
+    
+    int state = -1;
     
-    if( r.sock != NULL ) {
-        socketConnectionRecords.push_back( r );
-        
-        return r.handle;
+    PendingSocketConnect *p = getPendingSocketConnect( inHandle );
+
+    if( p != NULL ) {
+        stepPendingSocketConnect( inHandle, p );
+
+        if( p->connected ) {
+            // socket moved over, done with pending record
+            freePendingSocketConnect( p );
+            pendingSocketConnects.remove( inHandle );
+            state = 1;
+            }
+        else if( p->failed ) {
+            state = -1;
+            }
+        else {
+            state = 0;
+            }
         }
     else {
-        return -1;
+        Socket *sock;
+        
+        if( socketConnectionRecords.lookup( inHandle, &sock ) ) {
+            state = sock->isConnected();
+            }
+        else {
+            AppLog::error( "gameSDL - getSocketConnectionState:  "
+                           "Requested Socket handle not found\n" );
+            }
         }
+
+    screen->registerSocketEvent( inHandle, 4, state, NULL );
+
+    return state;
     }
 
 
 
 static Socket *getSocketByHandle( int inHandle ) {
-    for( int i=0; i<socketConnectionRecords.size(); i++ ) {
-        SocketConnectionRecord *r = socketConnectionRecords.getElement( i );
-        
-        if( r->handle == inHandle ) {
-            return r->sock;
-            }
+    Socket *sock;
+    
+    if( socketConnectionRecords.lookup( inHandle, &sock ) ) {
+        return sock;
+        }
+
+    if( getPendingSocketConnect( inHandle ) != NULL ) {
+        // no winning attempt yet
+        return NULL;
         }
 
     // else not found?
@@ -4908,8 +8641,37 @@ static Socket *getSocketByHandle( int inHandle ) {
 
 
 
+// bytes that sendToSocket will hold for a connection that can't take
+// them yet
+// beyond this, it reports partial sends, and the game must retry as
+// before (back-pressure for a stalled connection)
+static int socketSendQueueLimit = 1048576;
+
+
+
+// sends what it can from each socket's queue, without blocking
+// called once per frame
+static void flushSocketSendQueues() {
+    int numSlots = socketConnectionRecords.getNumSlots();
+    
+    for( int i=0; i<numSlots; i++ ) {
+        if( socketConnectionRecords.isSlotFilled( i ) ) {
+            Socket *sock = *( socketConnectionRecords.getSlotValue( i ) );
+            
+            if( sock->getSendQueueSize() > 0 ) {
+                // errors show up on next send or read for this socket
+                sock->flushSendQueue( false, false );
+                }
+            }
+        }
+    }
+
+
+
 // non-blocking send
 // returns number sent (maybe 0) on success, -1 on error
+//
+// bytes that the socket can't take right away are queued and count as sent
 int sendToSocket( int inHandle, unsigned char *inData, int inDataLength ) {
     if( screen->isPlayingBack() ) {
         // play back result of this send
@@ -4945,11 +8707,31 @@ int sendToSocket( int inHandle, unsigned char *inData, int inDataLength ) {
 
         if( sock->isConnected() ) {
             
-            numSent = sock->send( inData, inDataLength, false, false );
+            // anything still queued from earlier must go first
+            int numQueued = sock->flushSendQueue( false, false );
             
-            if( numSent == -2 ) {
-                // would block
-                numSent = 0;
+            if( numQueued == -1 ) {
+                numSent = -1;
+                }
+            else {
+                // take as much as fits in queue, sending what we can now
+                // the rest goes out from flushSocketSendQueues each frame
+                // so the game never has to hold on to it and retry
+                int numToTake = socketSendQueueLimit - numQueued;
+                
+                if( numToTake > inDataLength ) {
+                    numToTake = inDataLength;
+                    }
+
+                if( numToTake > 0 ) {
+                    if( sock->sendOrQueue( inData, numToTake, 
+                                           false ) == -1 ) {
+                        numSent = -1;
+                        }
+                    else {
+                        numSent = numToTake;
+                        }
+                    }
                 }
             }
         
@@ -4964,6 +8746,18 @@ int sendToSocket( int inHandle, unsigned char *inData, int inDataLength ) {
         
         return numSent;
         }
+
+    PendingSocketConnect *p = getPendingSocketConnect( inHandle );
+    
+    if( p != NULL ) {
+        // nothing can go out until an attempt connects
+        if( p->failed ) {
+            screen->registerSocketEvent( inHandle, 1, 0, NULL );
+            return -1;
+            }
+        screen->registerSocketEvent( inHandle, 0, 0, NULL );
+        return 0;
+        }
     
     return -1;
     }
@@ -5042,6 +8836,18 @@ int readFromSocket( int inHandle,
         
         return numRead;
         }
+
+    PendingSocketConnect *p = getPendingSocketConnect( inHandle );
+    
+    if( p != NULL ) {
+        // nothing to read until an attempt connects
+        if( p->failed ) {
+            screen->registerSocketEvent( inHandle, 3, -1, NULL );
+            return -1;
+            }
+        screen->registerSocketEvent( inHandle, 2, 0, NULL );
+        return 0;
+        }
     
     return -1;
     }
@@ -5055,17 +8861,33 @@ void closeSocket( int inHandle ) {
         return;
         }
     
-    for( int i=0; i<socketConnectionRecords.size(); i++ ) {
-        SocketConnectionRecord *r = socketConnectionRecords.getElement( i );
+    PendingSocketConnect *p = getPendingSocketConnect( inHandle );
+    
+    if( p != NULL ) {
+        char connected = p->connected;
         
-        if( r->handle == inHandle ) {
-            delete r->sock;
-            
-            socketConnectionRecords.deleteElement( i );
-            
-            // found, done
+        // drops any attempts still in progress
+        freePendingSocketConnect( p );
+        pendingSocketConnects.remove( inHandle );
+        
+        if( ! connected ) {
             return;
             }
+        // else winning socket in socketConnectionRecords too
+        }
+    
+    Socket *sock;
+    
+    if( socketConnectionRecords.lookup( inHandle, &sock ) ) {
+        // last chance for queued bytes, without blocking
+        sock->flushSendQueue( false, false );
+        
+        delete sock;
+        
+        socketConnectionRecords.remove( inHandle );
+        
+        // found, done
+        return;
         }
 
     // else not found?
@@ -5083,19 +8905,18 @@ void closeSocket( int inHandle ) {
 
 int startAsyncFileRead( const char *inFilePath ) {
     
-    int handle = nextAsyncFileHandle;
-    nextAsyncFileHandle ++;
+    AsyncFileRecord *r = new AsyncFileRecord;
     
-    AsyncFileRecord r = {
-        handle,
-        stringDuplicate( inFilePath ),
-        -1,
-        NULL,
-        false };
+    r->filePath = stringDuplicate( inFilePath );
+    r->dataLength = -1;
+    r->data = NULL;
+    r->doneReading = false;
+    r->abandoned = false;
 
-    asyncLock.lock();
-    asyncFiles.push_back( r );
-    asyncLock.unlock();
+    asyncLock.lockWrite();
+    int handle = asyncFileTable.size();
+    asyncFileTable.push_back( r );
+    asyncLock.unlockWrite();
     
     newFileToReadSem.signal();
     
@@ -5104,68 +8925,111 @@ int startAsyncFileRead( const char *inFilePath ) {
 
 
 
-char checkAsyncFileReadDone( int inHandle ) {
-
+// during playback, blocks until handle is actually done reading
+static void waitForAsyncFileDone( int inHandle ) {
     char ready = false;
+    
+    while( true ) {
+        asyncLock.lockRead();
+        ready = ( inHandle <= asyncFilesDoneThrough );
+        asyncLock.unlockRead();
 
-    asyncLock.lock();
-
-    for( int i=0; i<asyncFiles.size(); i++ ) {
-        AsyncFileRecord *r = asyncFiles.getElement( i );
-                    
-        if( r->handle == inHandle &&
-            r->doneReading ) {
-            
-            ready = true;
-            break;
+        if( ready ) {
+            return;
             }
+        newFileDoneReadingSem.wait();
         }
-    asyncLock.unlock();
+    }
 
 
-    if( screen->isPlayingBack() ) {
-        char playbackSaysReady = screen->getAsyncFileDone( inHandle );
 
-        if( ready && playbackSaysReady ) {
-            return true;
-            }
-        else if( ready && !playbackSaysReady ) {
+// records that inHandle has been reported done to the game
+static void noteAsyncFileDoneReported( int inHandle ) {
+    if( inHandle > lastAsyncFileDoneRegistered ) {
+        screen->registerAsyncFileDone( inHandle );
+        lastAsyncFileDoneRegistered = inHandle;
+        }
+    }
+
+
+
+char checkAsyncFileReadDone( int inHandle ) {
+
+    if( screen->isPlayingBack() ) {
+        if( ! screen->getAsyncFileDone( inHandle ) ) {
+            // even if it's actually done, it wasn't yet when recorded
             return false;
             }
-        else if( ! ready && playbackSaysReady ) {
-            // need to return ready before end of this frame
-            // so behavior matches recording behavior
+        
+        // need to return ready before end of this frame
+        // so behavior matches recording behavior
             
-            // wait for read to finish, synchronously
-            while( !ready ) {                
-                newFileDoneReadingSem.wait();
+        // wait for read to finish, synchronously
+        waitForAsyncFileDone( inHandle );
+        
+        return true;
+        }
+    
 
-                asyncLock.lock();
-                
-                for( int i=0; i<asyncFiles.size(); i++ ) {
-                    AsyncFileRecord *r = asyncFiles.getElement( i );
-                    
-                    if( r->handle == inHandle &&
-                        r->doneReading ) {
-                        
-                        ready = true;
-                        break;
-                        }
-                    }
-                asyncLock.unlock();
-                }
-            
-            return true;
+    asyncLock.lockRead();
+    char ready = ( inHandle <= asyncFilesDoneThrough );
+    asyncLock.unlockRead();
+    
+    if( ready ) {
+        noteAsyncFileDoneReported( inHandle );
+        }
+
+    return ready;
+    }
+
+
+
+int getAsyncFileReadsDone( int *outHandles, int inMaxHandles ) {
+    
+    int lastToReport;
+    
+    if( screen->isPlayingBack() ) {
+        // report only what had been reported by this frame when recorded
+        lastToReport = nextAsyncFileDoneToReport - 1;
+        
+        while( screen->getAsyncFileDone( lastToReport + 1 ) ) {
+            lastToReport ++;
             }
+        
+        waitForAsyncFileDone( lastToReport );
         }
     else {
-        if( ready ) {    
-            screen->registerAsyncFileDone( inHandle );
+        asyncLock.lockRead();
+        lastToReport = asyncFilesDoneThrough;
+        asyncLock.unlockRead();
+        }
+        
+    
+    int numReported = 0;
+    
+    asyncLock.lockRead();
+    
+    while( numReported < inMaxHandles && 
+           nextAsyncFileDoneToReport <= lastToReport ) {
+        
+        int handle = nextAsyncFileDoneToReport;
+        nextAsyncFileDoneToReport ++;
+        
+        if( asyncFileTable.getElementDirect( handle ) != NULL ) {
+            // not cleared already through checkAsyncFileReadDone
+            outHandles[ numReported ] = handle;
+            numReported ++;
             }
         }
     
+    asyncLock.unlockRead();
 
-    return ready;
+    
+    if( numReported > 0 && ! screen->isPlayingBack() ) {
+        noteAsyncFileDoneReported( outHandles[ numReported - 1 ] );
+        }
+
+    return numReported;
     }
 
 
@@ -5174,25 +9038,29 @@ unsigned char *getAsyncFileData( int inHandle, int *outDataLength ) {
 
     unsigned char *data = NULL;
     
-    asyncLock.lock();
+    asyncLock.lockWrite();
 
-    for( int i=0; i<asyncFiles.size(); i++ ) {
-        AsyncFileRecord *r = asyncFiles.getElement( i );
-                    
-        if( r->handle == inHandle ) {
-            
-            data = r->data;
-            *outDataLength = r->dataLength;
+    if( inHandle >= 0 && inHandle < asyncFileTable.size() ) {
+        AsyncFileRecord *r = asyncFileTable.getElementDirect( inHandle );
+        
+        if( r != NULL ) {
+            if( r->doneReading ) {
+                data = r->data;
+                *outDataLength = r->dataLength;
             
-            if( r->filePath != NULL ) {
                 delete [] r->filePath;
+                delete r;
+                
+                *( asyncFileTable.getElement( inHandle ) ) = NULL;
+                }
+            else {
+                // reader will clean up when done
+                r->abandoned = true;
                 }
-
-            asyncFiles.deleteElement( i );
-            break;
             }
         }
-    asyncLock.unlock();
+    
+    asyncLock.unlockWrite();
 
     return data;
     }
@@ -5215,6 +9083,38 @@ double game_getCurrentTime() {
 
 
 
+void setFixedUpdateRate( int inUpdatesPerSecond ) {
+    if( inUpdatesPerSecond < 0 ) {
+        inUpdatesPerSecond = 0;
+        }
+    fixedUpdateRate = inUpdatesPerSecond;
+    
+    updateTimeAccumulator = 0;
+    lastUpdateClockTime = -1;
+    numUpdatesThisFrame = 0;
+    updateInterpolation = 1;
+    }
+
+
+
+int getFixedUpdateRate() {
+    return fixedUpdateRate;
+    }
+
+
+
+int getNumUpdatesThisFrame() {
+    return numUpdatesThisFrame;
+    }
+
+
+
+double getUpdateInterpolation() {
+    return updateInterpolation;
+    }
+
+
+
 double getRecentFrameRate() {
     if( screen->isPlayingBack() ) {
 
@@ -5706,15 +9606,131 @@ char isSoundRecordingSupported() {
 
 
 
+// captured samples waiting for readRecordedSamples, when streaming
+static LockFreeRingBuffer<int16_t> *recordedSampleRing = NULL;
+
+static volatile int numRecordedSamplesDropped = 0;
+
+
+
+int readRecordedSamples( int16_t *outSamples, int inMaxSamples ) {
+    if( recordedSampleRing == NULL ) {
+        return 0;
+        }
+    return recordedSampleRing->popMany( outSamples, inMaxSamples );
+    }
+
+
+
+int getNumRecordedSamplesDropped() {
+    return atomicLoad( &numRecordedSamplesDropped );
+    }
+
+
+
 #ifdef LINUX
 
 static FILE *arecordPipe = NULL;
 const char *arecordFileName = "inputSoundTemp.wav";
 static int arecordSampleRate = 0;
 
+
+// once capture has stopped, returns samples left in ring and frees it
+static int16_t *takeRecordedSampleRing( int *outNumSamples ) {
+    *outNumSamples = 0;
+    
+    if( recordedSampleRing == NULL ) {
+        return NULL;
+        }
+    
+    SimpleVector<int16_t> samples;
+    
+    int16_t block[ 1024 ];
+    int numRead;
+    
+    while( ( numRead = recordedSampleRing->popMany( block, 1024 ) ) > 0 ) {
+        samples.appendArray( block, numRead );
+        }
+    
+    delete recordedSampleRing;
+    recordedSampleRing = NULL;
+    
+    *outNumSamples = samples.size();
+    
+    return samples.getElementArray();
+    }
+
+
+
+// for streaming recording, arecord writes raw samples to its stdout,
+// which this thread moves into the ring as they arrive
+class SoundCaptureThread : public Thread {
+    public:
+        
+        SoundCaptureThread( FILE *inPipe, 
+                            LockFreeRingBuffer<int16_t> *inRing )
+                : mPipe( inPipe ), mRing( inRing ) {
+            start();
+            }
+        
+        ~SoundCaptureThread() {
+            join();
+            }
+        
+        
+        virtual void run() {
+            // small reads, so samples reach the ring with little delay
+            // (256 samples is 16ms at 16KHz)
+            unsigned char bytes[ 512 ];
+            int16_t samples[ 256 ];
+            
+            while( true ) {
+                int numRead = fread( bytes, 2, 256, mPipe );
+                
+                if( numRead <= 0 ) {
+                    // arecord killed
+                    return;
+                    }
+                
+                // S16_LE
+                for( int i=0; i<numRead; i++ ) {
+                    samples[i] = 
+                        (int16_t)( bytes[ 2 * i ] | 
+                                   ( bytes[ 2 * i + 1 ] << 8 ) );
+                    }
+                
+                int numPushed = mRing->pushMany( samples, numRead );
+                
+                if( numPushed < numRead ) {
+                    // game not reading fast enough, newest samples lost
+                    atomicFetchAdd( &numRecordedSamplesDropped, 
+                                    numRead - numPushed );
+                    }
+                }
+            }
+        
+    protected:
+        FILE *mPipe;
+        LockFreeRingBuffer<int16_t> *mRing;
+    };
+
+
+static SoundCaptureThread *soundCaptureThread = NULL;
+
+
+
 // starts recording asynchronously
 // keeps recording until stop called
 char startRecording16BitMonoSound( int inSampleRate ) {
+    if( soundCaptureThread != NULL ) {
+        int numSamples;
+        int16_t *samples = stopRecording16BitMonoSound( &numSamples );
+        
+        if( samples != NULL ) {
+            delete [] samples;
+            }
+        }
+
     if( arecordPipe != NULL ) {
         pclose( arecordPipe );
         arecordPipe = NULL;
@@ -5740,6 +9756,47 @@ char startRecording16BitMonoSound( int inSampleRate ) {
 
 
 
+char startStreamingRecording16BitMonoSound( int inSampleRate,
+                                            int inMaxBufferedSamples ) {
+    if( arecordPipe != NULL ) {
+        int numSamples;
+        int16_t *samples = stopRecording16BitMonoSound( &numSamples );
+        
+        if( samples != NULL ) {
+            delete [] samples;
+            }
+        }
+    
+    arecordSampleRate = inSampleRate;
+    
+    // raw samples to stdout, no status messages
+    char *arecordLine =
+        autoSprintf( "arecord -q -t raw -f S16_LE -c1 -r%d",
+                     inSampleRate );
+
+    arecordPipe = popen( arecordLine, "r" );
+
+    delete [] arecordLine;
+    
+    if( arecordPipe == NULL ) {
+        return false;
+        }
+    
+    // no stdio buffering, so reads return as soon as samples arrive
+    setvbuf( arecordPipe, NULL, _IONBF, 0 );
+
+    recordedSampleRing = 
+        new LockFreeRingBuffer<int16_t>( inMaxBufferedSamples );
+    numRecordedSamplesDropped = 0;
+
+    soundCaptureThread = 
+        new SoundCaptureThread( arecordPipe, recordedSampleRing );
+    
+    return true;
+    }
+
+
+
 // returns array of samples destroyed by caller
 int16_t *stopRecording16BitMonoSound( int *outNumSamples ) {
     if( arecordPipe == NULL ) {
@@ -5751,6 +9808,18 @@ int16_t *stopRecording16BitMonoSound( int *outNumSamples ) {
     // where more than one arecord is running
     system( "pkill arecord" );
     
+    if( soundCaptureThread != NULL ) {
+        // sees end of stream once arecord is gone
+        delete soundCaptureThread;
+        soundCaptureThread = NULL;
+        
+        pclose( arecordPipe );
+        arecordPipe = NULL;
+        
+        // samples never read
+        return takeRecordedSampleRing( outNumSamples );
+        }
+
     pclose( arecordPipe );
     arecordPipe = NULL;
     
@@ -5788,6 +9857,11 @@ int16_t *stopRecording16BitMonoSound( int *outNumSamples ) {
     return NULL;
     }
 
+char startStreamingRecording16BitMonoSound( int inSampleRate,
+                                            int inMaxBufferedSamples ) {
+    return false;
+    }
+
 #elif defined(WIN_32)
 
 #include <mmsystem.h>
@@ -5823,6 +9897,12 @@ char startRecording16BitMonoSound( int inSampleRate ) {
     return false;
     }
 
+// MCI can only save whole recordings
+char startStreamingRecording16BitMonoSound( int inSampleRate,
+                                            int inMaxBufferedSamples ) {
+    return false;
+    }
+
 int16_t *stopRecording16BitMonoSound( int *outNumSamples ) {
     mciSendString( "stop my_sound", NULL, 0, 0 );
     
@@ -5863,6 +9943,11 @@ int16_t *stopRecording16BitMonoSound( int *outNumSamples ) {
     return NULL;
     }
 
+char startStreamingRecording16BitMonoSound( int inSampleRate,
+                                            int inMaxBufferedSamples ) {
+    return false;
+    }
+
 #endif
 
 
@@ -0,0 +1,274 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14   Jason Rohrer
+ * Created.
+ */
+
+
+#include "SpriteAtlasGL.h"
+
+
+
+SpriteAtlasGL::SpriteAtlasGL( char inAlphaOnly, int inPageSize )
+        : mAlphaOnly( inAlphaOnly ), mPageSize( inPageSize ) {
+    }
+
+
+
+SpriteAtlasGL::~SpriteAtlasGL() {
+    for( int i=0; i<mPages.size(); i++ ) {
+        SpriteAtlasPage *page = mPages.getElement( i );
+
+        delete page->texture;
+        delete page->skyline;
+        }
+    }
+
+
+
+void SpriteAtlasGL::addPage() {
+    int numBytesPerPixel = 4;
+    if( mAlphaOnly ) {
+        numBytesPerPixel = 1;
+        }
+
+    int numBytes = mPageSize * mPageSize * numBytesPerPixel;
+
+    unsigned char *blank = new unsigned char[ numBytes ];
+    memset( blank, 0, numBytes );
+
+    SpriteAtlasPage page;
+
+    if( mAlphaOnly ) {
+        page.texture = new SingleTextureGL( true,
+                                            blank, mPageSize, mPageSize,
+                                            // no wrap, no mipmap
+                                            false, false );
+        }
+    else {
+        page.texture = new SingleTextureGL( blank, mPageSize, mPageSize,
+                                            false, false );
+        }
+
+    delete [] blank;
+
+    page.skyline = new SimpleVector<SkylineSegment>();
+
+    SkylineSegment floor = { 0, 0, mPageSize };
+    page.skyline->push_back( floor );
+
+    page.numSprites = 0;
+
+    mPages.push_back( page );
+    }
+
+
+
+char SpriteAtlasGL::findPosition( SpriteAtlasPage *inPage,
+                                  int inWidth, int inHeight,
+                                  int *outSegment, int *outX, int *outY ) {
+
+    SimpleVector<SkylineSegment> *skyline = inPage->skyline;
+    int numSegments = skyline->size();
+
+    int bestTop = mPageSize + 1;
+
+    for( int i=0; i<numSegments; i++ ) {
+        int x = skyline->getElementFast( i )->x;
+
+        if( x + inWidth > mPageSize ) {
+            // later segments are further right
+            break;
+            }
+
+        // rectangle rests on highest segment under it
+        int y = 0;
+        int widthLeft = inWidth;
+
+        for( int j=i; widthLeft > 0 && j<numSegments; j++ ) {
+            SkylineSegment *s = skyline->getElementFast( j );
+
+            if( s->y > y ) {
+                y = s->y;
+                }
+            widthLeft -= s->width;
+            }
+
+        int top = y + inHeight;
+
+        if( top <= mPageSize && top < bestTop ) {
+            bestTop = top;
+            *outSegment = i;
+            *outX = x;
+            *outY = y;
+            }
+        }
+
+    return ( bestTop <= mPageSize );
+    }
+
+
+
+void SpriteAtlasGL::addToSkyline( SpriteAtlasPage *inPage, int inSegment,
+                                  int inX, int inY,
+                                  int inWidth, int inHeight ) {
+
+    SimpleVector<SkylineSegment> *skyline = inPage->skyline;
+
+    SkylineSegment top = { inX, inY + inHeight, inWidth };
+    skyline->push_middle( top, inSegment );
+
+
+    // trim or remove segments now covered by new one
+    int right = inX + inWidth;
+
+    int i = inSegment + 1;
+    while( i < skyline->size() ) {
+        SkylineSegment *s = skyline->getElementFast( i );
+
+        if( s->x >= right ) {
+            break;
+            }
+
+        int overlap = right - s->x;
+
+        if( overlap >= s->width ) {
+            skyline->deleteElement( i );
+            }
+        else {
+            s->x += overlap;
+            s->width -= overlap;
+            break;
+            }
+        }
+
+
+    // merge neighbors at same height
+    i = 0;
+    while( i < skyline->size() - 1 ) {
+        SkylineSegment *s = skyline->getElementFast( i );
+        SkylineSegment *next = skyline->getElementFast( i + 1 );
+
+        if( s->y == next->y ) {
+            s->width += next->width;
+            skyline->deleteElement( i + 1 );
+            }
+        else {
+            i++;
+            }
+        }
+    }
+
+
+
+SingleTextureGL *SpriteAtlasGL::addImage( unsigned char *inBytes,
+                                          int inWidth, int inHeight,
+                                          double *outU0, double *outV0,
+                                          double *outU1, double *outV1 ) {
+
+    int maxSize = getMaxImageSize();
+
+    if( inWidth > maxSize || inHeight > maxSize ) {
+        return NULL;
+        }
+
+    // one pixel border all around
+    int paddedW = inWidth + 2;
+    int paddedH = inHeight + 2;
+
+
+    SpriteAtlasPage *page = NULL;
+    int segment = 0;
+    int x = 0;
+    int y = 0;
+
+    for( int i=0; i<mPages.size(); i++ ) {
+        SpriteAtlasPage *p = mPages.getElementFast( i );
+
+        if( findPosition( p, paddedW, paddedH, &segment, &x, &y ) ) {
+            page = p;
+            break;
+            }
+        }
+
+    if( page == NULL ) {
+        addPage();
+
+        page = mPages.getElementFast( mPages.size() - 1 );
+
+        // always fits on empty page
+        findPosition( page, paddedW, paddedH, &segment, &x, &y );
+        }
+
+    addToSkyline( page, segment, x, y, paddedW, paddedH );
+
+
+    // copy in, repeating outermost rows and columns into border
+    int numBytesPerPixel = 4;
+    if( mAlphaOnly ) {
+        numBytesPerPixel = 1;
+        }
+
+    unsigned char *padded =
+        new unsigned char[ paddedW * paddedH * numBytesPerPixel ];
+
+    for( int py=0; py<paddedH; py++ ) {
+        int sy = py - 1;
+        if( sy < 0 ) {
+            sy = 0;
+            }
+        else if( sy >= inHeight ) {
+            sy = inHeight - 1;
+            }
+
+        for( int px=0; px<paddedW; px++ ) {
+            int sx = px - 1;
+            if( sx < 0 ) {
+                sx = 0;
+                }
+            else if( sx >= inWidth ) {
+                sx = inWidth - 1;
+                }
+
+            memcpy( &( padded[ ( py * paddedW + px ) * numBytesPerPixel ] ),
+                    &( inBytes[ ( sy * inWidth + sx ) * numBytesPerPixel ] ),
+                    numBytesPerPixel );
+            }
+        }
+
+    page->texture->replaceTextureSubData( padded, x, y, paddedW, paddedH );
+
+    delete [] padded;
+
+    page->numSprites ++;
+
+
+    double pageSize = mPageSize;
+
+    *outU0 = ( x + 1 ) / pageSize;
+    *outV0 = ( y + 1 ) / pageSize;
+    *outU1 = ( x + 1 + inWidth ) / pageSize;
+    *outV1 = ( y + 1 + inHeight ) / pageSize;
+
+    return page->texture;
+    }
+
+
+
+void SpriteAtlasGL::removeImage( SingleTextureGL *inPage ) {
+    for( int i=0; i<mPages.size(); i++ ) {
+        SpriteAtlasPage *page = mPages.getElementFast( i );
+
+        if( page->texture == inPage ) {
+            page->numSprites --;
+
+            if( page->numSprites <= 0 ) {
+                delete page->texture;
+                delete page->skyline;
+                mPages.deleteElement( i );
+                }
+            return;
+            }
+        }
+    }
@@ -0,0 +1,127 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14   Jason Rohrer
+ * Created.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Added getPageSize.
+ */
+
+
+#ifndef SPRITE_ATLAS_GL_INCLUDED
+#define SPRITE_ATLAS_GL_INCLUDED
+
+
+#include "minorGems/graphics/openGL/SingleTextureGL.h"
+#include "minorGems/util/SimpleVector.h"
+
+
+
+// one horizontal span of the skyline (top edge of packed area)
+typedef struct SkylineSegment {
+        int x;
+        int y;
+        int width;
+    } SkylineSegment;
+
+
+
+typedef struct SpriteAtlasPage {
+        SingleTextureGL *texture;
+
+        // sorted by x, covering full page width
+        SimpleVector<SkylineSegment> *skyline;
+
+        // sprites still using this page
+        int numSprites;
+    } SpriteAtlasPage;
+
+
+
+/**
+ * Packs many small sprite images into a few large shared textures.
+ *
+ * Uses a bottom-left skyline packer.  Space is not reused as individual
+ * sprites are removed, but a page is destroyed once all of its sprites
+ * are gone.
+ *
+ * Each image gets a one-pixel border of repeated edge pixels, so that
+ * linear filtering doesn't pull in neighbors.
+ *
+ * Pages are never mipmapped (neighbors would bleed together at
+ * smaller mip levels).
+ *
+ * @author Jason Rohrer
+ */
+class SpriteAtlasGL {
+    public:
+
+        // inPageSize must be a power of 2
+        SpriteAtlasGL( char inAlphaOnly, int inPageSize = 1024 );
+
+        ~SpriteAtlasGL();
+
+
+        // images with a side larger than this should get their own texture
+        int getMaxImageSize() {
+            return mPageSize / 4;
+            }
+
+
+        int getPageSize() {
+            return mPageSize;
+            }
+
+
+        /**
+         * Packs an image into a page.
+         *
+         * @param inBytes RGBA bytes, or single-channel bytes if this is
+         *   an alpha-only atlas.  Destroyed by caller.
+         * @param inWidth, inHeight the image size.
+         * @param outU0, outV0, outU1, outV1 pointers to where the
+         *   image's rectangle in page texture coordinates should be
+         *   returned.
+         *
+         * @return the page texture, or NULL if image is larger than
+         *   getMaxImageSize.  Not destroyed by caller.
+         */
+        SingleTextureGL *addImage( unsigned char *inBytes,
+                                   int inWidth, int inHeight,
+                                   double *outU0, double *outV0,
+                                   double *outU1, double *outV1 );
+
+
+        // called when a sprite added to inPage is destroyed
+        void removeImage( SingleTextureGL *inPage );
+
+
+        int getNumPages() {
+            return mPages.size();
+            }
+
+
+    protected:
+
+        char mAlphaOnly;
+        int mPageSize;
+
+        SimpleVector<SpriteAtlasPage> mPages;
+
+
+        // finds lowest position for a rectangle on a page
+        // returns false if it doesn't fit
+        char findPosition( SpriteAtlasPage *inPage, int inWidth, int inHeight,
+                           int *outSegment, int *outX, int *outY );
+
+        void addToSkyline( SpriteAtlasPage *inPage, int inSegment,
+                           int inX, int inY, int inWidth, int inHeight );
+
+        void addPage();
+
+    };
+
+
+
+#endif
@@ -1,9 +1,24 @@
 #include "SpriteGL.h"
+#include "SpriteAtlasGL.h"
+
+#include "minorGems/graphics/openGL/ShaderProgramGL.h"
 
 
 #include "minorGems/math/geometry/Angle3D.h"
 
 #include "minorGems/util/log/AppLog.h"
+#include "minorGems/util/HashMap.h"
+#include "minorGems/util/crc32.h"
+
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || \
+    ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+    #define SPRITE_GL_SSE2
+    #include <emmintrin.h>
+#elif defined( __aarch64__ )
+    #define SPRITE_GL_NEON
+    #include <arm_neon.h>
+#endif
 
 
 
@@ -12,10 +27,432 @@ char SpriteGL::sStateSet = false;
 
 
 char SpriteGL::sGenerateMipMaps = false;
+char SpriteGL::sUseAtlas = false;
+
+char SpriteGL::sShareTextures = true;
+int SpriteGL::sNumSharingChecks = 0;
+int SpriteGL::sNumSharingHits = 0;
+int SpriteGL::sNumSharedTextureBytes = 0;
 
 char SpriteGL::sCountingPixels = false;
 double SpriteGL::sPixelsDrawn = 0;
 
+char SpriteGL::sBatching = false;
+char SpriteGL::sShading = false;
+int SpriteGL::sNumBatchQuads = 0;
+int SpriteGL::sNumBatchDrawCalls = 0;
+int SpriteGL::sNumBatchDrawCallsBeforeReset = 0;
+int SpriteGL::sNumBatchFlushes = 0;
+
+
+static float batchColor[4] = { 1, 1, 1, 1 };
+
+
+void SpriteGL::setBatchColor( float inR, float inG, float inB, float inA ) {
+    batchColor[0] = inR;
+    batchColor[1] = inG;
+    batchColor[2] = inB;
+    batchColor[3] = inA;
+    }
+
+
+
+// per-vertex modes for shaded batches:
+// additive coloring, alpha only, additive blend, field sharpness
+static float batchMode[4] = { 0, 0, 0, 1 };
+
+// blend function set in GL, restored after premultiplied batches
+static int batchBlendSrc = -1;
+static int batchBlendDst = -1;
+
+// true if queued quads are normal or additive, and drawn together
+// premultiplied
+static char batchBlendMixable = false;
+
+
+
+// Vertex color and texture as in GL_MODULATE, GL_ADD, or alpha only,
+// with texture alpha sharpened for distance fields.
+// Premultiplied output lets normal and additive quads share the blend
+// function ONE, ONE_MINUS_SRC_ALPHA (additive quads have no alpha).
+// Otherwise, output is for whatever blend function is set.
+static const char *batchVertexShader =
+    "attribute vec4 mode;\n"
+    "varying vec4 spriteMode;\n"
+    "void main() {\n"
+    "    gl_Position = gl_ModelViewProjectionMatrix * gl_Vertex;\n"
+    "    gl_TexCoord[0] = gl_TextureMatrix[0] * gl_MultiTexCoord0;\n"
+    "    gl_FrontColor = gl_Color;\n"
+    "    spriteMode = mode;\n"
+    "    }\n";
+
+static const char *batchFragmentShader =
+    "uniform sampler2D spriteTexture;\n"
+    "uniform float premultiplied;\n"
+    "uniform float alphaTexture;\n"
+    "varying vec4 spriteMode;\n"
+    "void main() {\n"
+    "    vec4 t = texture2D( spriteTexture, gl_TexCoord[0].st );\n"
+    "    float a = gl_Color.a *\n"
+    "        clamp( ( t.a - 0.5 ) * spriteMode.w + 0.5, 0.0, 1.0 );\n"
+    "    vec3 rgb = mix( t.rgb * gl_Color.rgb,\n"
+    "                    min( t.rgb + gl_Color.rgb, 1.0 ), spriteMode.x );\n"
+    // GL_ALPHA textures color like alpha only in both texture env modes
+    "    rgb = mix( rgb, gl_Color.rgb,\n"
+    "               max( spriteMode.y, alphaTexture ) );\n"
+    "    gl_FragColor = mix( vec4( rgb, a ),\n"
+    "                        vec4( rgb * a, a * ( 1.0 - spriteMode.z ) ),\n"
+    "                        premultiplied );\n"
+    "    }\n";
+
+static const char *batchAttributeNames[1] = { "mode" };
+
+// mode is at location 1
+#define BATCH_MODE_ATTRIBUTE 1
+
+
+static ShaderProgramGL *batchProgram = NULL;
+static int batchPremultipliedUniform = -1;
+static int batchAlphaTextureUniform = -1;
+
+// context change count when building program last failed
+static int batchProgramFailedContext = -1;
+
+
+
+// NULL if shader can't be used in current context
+static ShaderProgramGL *getBatchProgram() {
+    if( batchProgram != NULL && batchProgram->isValid() ) {
+        return batchProgram;
+        }
+
+    int context = SingleTextureGL::getContextChangeCount();
+
+    if( batchProgramFailedContext == context ||
+        ! ShaderProgramGL::isSupported() ) {
+        return NULL;
+        }
+
+    if( batchProgram != NULL ) {
+        // from an old context
+        delete batchProgram;
+        }
+
+    batchProgram = new ShaderProgramGL( batchVertexShader,
+                                        batchFragmentShader,
+                                        1, batchAttributeNames );
+
+    if( ! batchProgram->isValid() ) {
+        delete batchProgram;
+        batchProgram = NULL;
+        batchProgramFailedContext = context;
+
+        AppLog::warning( "Sprite shader not available, drawing "
+                         "batches with fixed-function state" );
+        return NULL;
+        }
+
+    batchPremultipliedUniform =
+        batchProgram->getUniformLocation( "premultiplied" );
+    batchAlphaTextureUniform =
+        batchProgram->getUniformLocation( "alphaTexture" );
+
+    AppLog::info( "Drawing sprite batches with shader" );
+
+    return batchProgram;
+    }
+
+
+
+void SpriteGL::toggleShading( char inShade ) {
+    // queued quads may have been queued without flushes that they need
+    // when not shaded
+    flushBatch();
+
+    sShading = inShade;
+    }
+
+
+
+char SpriteGL::isShadingBatch() {
+    return sShading && sBatching && getBatchProgram() != NULL;
+    }
+
+
+
+void SpriteGL::setBatchColoring( int inColoring ) {
+    batchMode[0] = ( inColoring == SPRITE_COLORING_ADD ) ? 1 : 0;
+    batchMode[1] = ( inColoring == SPRITE_COLORING_ALPHA_ONLY ) ? 1 : 0;
+    }
+
+
+
+void SpriteGL::setBatchFieldSharpness( float inSharpness ) {
+    batchMode[3] = inSharpness;
+    }
+
+
+
+void SpriteGL::setBatchBlend( int inSrc, int inDst, char inAlphaTest ) {
+    batchBlendSrc = inSrc;
+    batchBlendDst = inDst;
+
+    batchBlendMixable = ! inAlphaTest &&
+        inSrc == GL_SRC_ALPHA &&
+        ( inDst == GL_ONE || inDst == GL_ONE_MINUS_SRC_ALPHA );
+
+    batchMode[2] = ( inDst == GL_ONE ) ? 1 : 0;
+    }
+
+
+
+void SpriteGL::applyTextureFilters( SingleTextureGL *inTexture,
+                                    int inMinFilter, int inMagFilter ) {
+    if( inTexture->mLastSetMinFilter != inMinFilter ) {
+        GLint filter = GL_NEAREST;
+        
+        if( inMinFilter == 2 ) {
+            filter = GL_LINEAR_MIPMAP_LINEAR;
+            }
+        else if( inMinFilter == 1 ) {
+            filter = GL_LINEAR;
+            }
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter );
+        inTexture->mLastSetMinFilter = inMinFilter;
+        }
+    
+    if( inTexture->mLastSetMagFilter != inMagFilter ) {
+        GLint filter = GL_NEAREST;
+        
+        if( inMagFilter == 1 ) {
+            filter = GL_LINEAR;
+            }
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter );
+        inTexture->mLastSetMagFilter = inMagFilter;
+        }
+    }
+
+
+
+// min filter code for applyTextureFilters
+static int getMinFilterCode( char inLinearMagFilter, char inMipMapFilter ) {
+    if( inMipMapFilter ) {
+        return 2;
+        }
+    else if( inLinearMagFilter ) {
+        return 1;
+        }
+    return 0;
+    }
+
+
+
+// colored-box scans test 32 bytes at a time (8 RGBA pixels, or 32 alpha
+// pixels), for 4-channel data with alpha last, and for alpha-only data
+// other layouts, and leftover pixels at ends of rows, are tested one
+// at a time
+
+#if defined( SPRITE_GL_SSE2 ) || defined( SPRITE_GL_NEON )
+    #define SPRITE_GL_SIMD_SCAN
+#endif
+
+
+#ifdef SPRITE_GL_SIMD_SCAN
+
+// pixels per 32-byte chunk, or 0 if layout not handled
+static int getScanChunkPixels( int inNumChannels, int inAlphaChannel ) {
+    if( inNumChannels == 4 && inAlphaChannel == 3 ) {
+        return 8;
+        }
+    if( inNumChannels == 1 ) {
+        return 32;
+        }
+    return 0;
+    }
+
+
+#ifdef SPRITE_GL_SSE2
+
+typedef __m128i ScanMask;
+
+static ScanMask getScanMask( int inNumChannels ) {
+    if( inNumChannels == 1 ) {
+        return _mm_set1_epi8( (char)0xFF );
+        }
+    // alpha is high byte of each little-endian pixel
+    return _mm_set1_epi32( (int)0xFF000000 );
+    }
+
+// true if any masked byte in the 32 at inBytes is non-zero
+static inline char chunkHasColor( const unsigned char *inBytes, 
+                                  ScanMask inMask ) {
+    __m128i a = _mm_loadu_si128( (const __m128i *)inBytes );
+    __m128i b = _mm_loadu_si128( (const __m128i *)( inBytes + 16 ) );
+    
+    __m128i v = _mm_and_si128( _mm_or_si128( a, b ), inMask );
+    
+    return _mm_movemask_epi8( 
+        _mm_cmpeq_epi8( v, _mm_setzero_si128() ) ) != 0xFFFF;
+    }
+
+#else
+
+typedef uint8x16_t ScanMask;
+
+static ScanMask getScanMask( int inNumChannels ) {
+    if( inNumChannels == 1 ) {
+        return vdupq_n_u8( 0xFF );
+        }
+    return vreinterpretq_u8_u32( vdupq_n_u32( 0xFF000000 ) );
+    }
+
+static inline char chunkHasColor( const unsigned char *inBytes, 
+                                  ScanMask inMask ) {
+    uint8x16_t v = vandq_u8( vorrq_u8( vld1q_u8( inBytes ),
+                                       vld1q_u8( inBytes + 16 ) ),
+                             inMask );
+    return vmaxvq_u8( v ) != 0;
+    }
+
+#endif
+
+#endif
+
+
+
+// first x in [inStartX, inEndX) with non-zero alpha, or inEndX if none
+static int firstColoredX( unsigned char *inRow, 
+                          int inNumChannels, int inAlphaChannel,
+                          int inStartX, int inEndX ) {
+    int x = inStartX;
+    
+    #ifdef SPRITE_GL_SIMD_SCAN
+    int chunk = getScanChunkPixels( inNumChannels, inAlphaChannel );
+    
+    if( chunk > 0 ) {
+        ScanMask mask = getScanMask( inNumChannels );
+        
+        // stop at first chunk with color, and find pixel in it below
+        while( x + chunk <= inEndX &&
+               ! chunkHasColor( &( inRow[ x * inNumChannels ] ), mask ) ) {
+            x += chunk;
+            }
+        }
+    #endif
+
+    unsigned char *alpha = &( inRow[ inAlphaChannel ] );
+    
+    for( ; x < inEndX; x++ ) {
+        if( alpha[ x * inNumChannels ] > 0 ) {
+            return x;
+            }
+        }
+    return inEndX;
+    }
+
+
+
+// last x in [inStartX, inEndX) with non-zero alpha, or inStartX - 1 if
+// none
+static int lastColoredX( unsigned char *inRow, 
+                         int inNumChannels, int inAlphaChannel,
+                         int inStartX, int inEndX ) {
+    int x = inEndX;
+    
+    #ifdef SPRITE_GL_SIMD_SCAN
+    int chunk = getScanChunkPixels( inNumChannels, inAlphaChannel );
+    
+    if( chunk > 0 ) {
+        ScanMask mask = getScanMask( inNumChannels );
+        
+        while( x - chunk >= inStartX &&
+               ! chunkHasColor( &( inRow[ ( x - chunk ) * inNumChannels ] ),
+                                mask ) ) {
+            x -= chunk;
+            }
+        }
+    #endif
+
+    unsigned char *alpha = &( inRow[ inAlphaChannel ] );
+    
+    for( x = x - 1; x >= inStartX; x-- ) {
+        if( alpha[ x * inNumChannels ] > 0 ) {
+            return x;
+            }
+        }
+    return inStartX - 1;
+    }
+
+
+
+void SpriteGL::findColoredBox( unsigned char *inPixels,
+                               int inWidth, int inHeight,
+                               int inNumChannels, int inAlphaChannel,
+                               ColoredBox *outBox ) {
+    int w = inWidth;
+    int h = inHeight;
+    
+    int rowBytes = w * inNumChannels;
+    
+    // fully transparent until we find otherwise
+    outBox->minX = w;
+    outBox->maxX = 0;
+    outBox->minY = h;
+    outBox->maxY = 0;
+    
+    // top edge, first row with any color
+    int minY = 0;
+    int minX = w;
+    
+    for( ; minY < h; minY++ ) {
+        minX = firstColoredX( &( inPixels[ minY * rowBytes ] ),
+                              inNumChannels, inAlphaChannel, 0, w );
+        if( minX < w ) {
+            break;
+            }
+        }
+    
+    if( minY == h ) {
+        return;
+        }
+    
+    int maxX = lastColoredX( &( inPixels[ minY * rowBytes ] ),
+                             inNumChannels, inAlphaChannel, minX, w );
+    
+    // bottom edge, stops at top row at the latest
+    int maxY = h - 1;
+    
+    for( ; maxY > minY; maxY-- ) {
+        if( firstColoredX( &( inPixels[ maxY * rowBytes ] ),
+                           inNumChannels, inAlphaChannel, 0, w ) < w ) {
+            break;
+            }
+        }
+    
+    // left and right edges, only looking outside of the columns already
+    // known to be colored
+    for( int y=minY + 1; y<=maxY; y++ ) {
+        unsigned char *row = &( inPixels[ y * rowBytes ] );
+        
+        if( minX > 0 ) {
+            minX = firstColoredX( row, inNumChannels, inAlphaChannel, 
+                                  0, minX );
+            }
+        if( maxX < w - 1 ) {
+            int x = lastColoredX( row, inNumChannels, inAlphaChannel, 
+                                  maxX + 1, w );
+            if( x > maxX ) {
+                maxX = x;
+                }
+            }
+        }
+    
+    outBox->minX = minX;
+    outBox->maxX = maxX;
+    outBox->minY = minY;
+    outBox->maxY = maxY;
+    }
+
 
 
 void SpriteGL::findColoredRadii( Image *inImage ) {
@@ -23,157 +460,310 @@ void SpriteGL::findColoredRadii( Image *inImage ) {
     if( inImage->getNumChannels() < 4 ) {
         return;
         }
-    
-    double *alpha = inImage->getChannel( 3 );
 
     int w = inImage->getWidth();
     int h = inImage->getHeight();
     
-    int minX = w;
-    int maxX = 0;
-    int minY = h;
-    int maxY = 0;
+    ColoredBox box;
     
-    for( int y=0; y<h; y++ ) {
-        for( int x=0; x<w; x++ ) {
-            int index = y * w + x;
-            
-            if( alpha[index] > 0 ) {
+    // read compact images without expanding them
+    if( inImage->isCompact() ) {
+        findColoredBox( inImage->getCompactBytes(), w, h,
+                        inImage->getNumChannels(), 3, &box );
+        }
+    else {
+        double *alpha = inImage->getChannel( 3 );
+        
+        box.minX = w;
+        box.maxX = 0;
+        box.minY = h;
+        box.maxY = 0;
+        
+        for( int y=0; y<h; y++ ) {
+            for( int x=0; x<w; x++ ) {
                 
-                if( x < minX ) {
-                    minX = x;
-                    }
-                if( x > maxX ) {
-                    maxX = x;
-                    }
-                if( y < minY ) {
-                    minY = y;
-                    }
-                if( y > maxY ) {
-                    maxY = y;
-                    }
-                }    
+                if( alpha[ y * w + x ] > 0 ) {
+                    
+                    if( x < box.minX ) {
+                        box.minX = x;
+                        }
+                    if( x > box.maxX ) {
+                        box.maxX = x;
+                        }
+                    if( y < box.minY ) {
+                        box.minY = y;
+                        }
+                    if( y > box.maxY ) {
+                        box.maxY = y;
+                        }
+                    }    
+                }
             }
         }
     
+    setColoredRadii( &box, w, h );
+    }
 
-    if( minX > 0 ) {
-        mColoredRadiusLeftX = 0.5 - minX / (double)w;
+
+
+void SpriteGL::setColoredRadii( ColoredBox *inBox, 
+                                int inWidth, int inHeight ) {
+    int w = inWidth;
+    int h = inHeight;
+    
+    if( inBox->minX > 0 ) {
+        mColoredRadiusLeftX = 0.5 - inBox->minX / (double)w;
         }
-    if( maxX < w - 1 ) {
-        mColoredRadiusRightX = ( maxX + 1 ) / (double)w - 0.5;
+    if( inBox->maxX < w - 1 ) {
+        mColoredRadiusRightX = ( inBox->maxX + 1 ) / (double)w - 0.5;
         }
     
-    if( minY > 0 ) {
-        mColoredRadiusTopY = 0.5 - minY / (double)h;
+    if( inBox->minY > 0 ) {
+        mColoredRadiusTopY = 0.5 - inBox->minY / (double)h;
         }
-    if( maxY < h - 1 ) {
-        mColoredRadiusBottomY = ( maxY + 1 ) / (double)h - 0.5;
+    if( inBox->maxY < h - 1 ) {
+        mColoredRadiusBottomY = ( inBox->maxY + 1 ) / (double)h - 0.5;
         }
     }
 
 
 
-
-
-void SpriteGL::findColoredRadii( unsigned char *inRGBA, 
-                                 int inWidth, int inHeight ) {
-    
-    int w = inWidth;
-    int h = inHeight;
+char SpriteGL::isOutside( Vector3D *inPosition, double inScale,
+                          double inRotation,
+                          double inMinX, double inMinY,
+                          double inMaxX, double inMaxY ) {
     
-    int minX = w;
-    int maxX = 0;
-    int minY = h;
-    int maxY = 0;
+    // colored radii are a tight box, so transparent borders are culled
+    // early too
+    double xRadius = mColoredRadiusLeftX;
+    if( mColoredRadiusRightX > xRadius ) {
+        xRadius = mColoredRadiusRightX;
+        }
+    double yRadius = mColoredRadiusTopY;
+    if( mColoredRadiusBottomY > yRadius ) {
+        yRadius = mColoredRadiusBottomY;
+        }
     
-    for( int y=0; y<h; y++ ) {
-        for( int x=0; x<w; x++ ) {
-            int index = y * w + x;
-            
-            if( inRGBA[ index * 4 + 3 ] > 0 ) {
-                
-                if( x < minX ) {
-                    minX = x;
-                    }
-                if( x > maxX ) {
-                    maxX = x;
-                    }
-                if( y < minY ) {
-                    minY = y;
-                    }
-                if( y > maxY ) {
-                    maxY = y;
-                    }
-                }    
-            }
+    // offset moves sprite away from inPosition in any direction, 
+    // depending on flip and rotation
+    double xExtent = 
+        fabs( inScale ) * ( mBaseScaleX * xRadius + fabs( mCenterOffset.x ) );
+    double yExtent = 
+        fabs( inScale ) * ( mBaseScaleY * yRadius + fabs( mCenterOffset.y ) );
+    
+    if( inRotation != 0 ) {
+        double r = sqrt( xExtent * xExtent + yExtent * yExtent );
+        xExtent = r;
+        yExtent = r;
         }
+    
+    return ( inPosition->mX + xExtent < inMinX ||
+             inPosition->mX - xExtent > inMaxX ||
+             inPosition->mY + yExtent < inMinY ||
+             inPosition->mY - yExtent > inMaxY );
+    }
+
+
+
 
+static SpriteAtlasGL *rgbaAtlas = NULL;
+static SpriteAtlasGL *alphaAtlas = NULL;
 
-    if( minX > 0 ) {
-        mColoredRadiusLeftX = 0.5 - minX / (double)w;
+
+
+SpriteAtlasGL *SpriteGL::getAtlas( char inAlphaOnly,
+                                   unsigned int inWidth, 
+                                   unsigned int inHeight ) {
+    if( ! sUseAtlas || sGenerateMipMaps ) {
+        return NULL;
         }
-    if( maxX < w - 1 ) {
-        mColoredRadiusRightX = ( maxX + 1 ) / (double)w - 0.5;
+    
+    SpriteAtlasGL **atlas = &rgbaAtlas;
+    
+    if( inAlphaOnly ) {
+        atlas = &alphaAtlas;
         }
     
-    if( minY > 0 ) {
-        mColoredRadiusTopY = 0.5 - minY / (double)h;
+    if( *atlas == NULL ) {
+        *atlas = new SpriteAtlasGL( inAlphaOnly );
         }
-    if( maxY < h - 1 ) {
-        mColoredRadiusBottomY = ( maxY + 1 ) / (double)h - 0.5;
+    
+    unsigned int maxSize = (unsigned int)( (*atlas)->getMaxImageSize() );
+    
+    if( inWidth > maxSize || inHeight > maxSize ) {
+        return NULL;
         }
+    
+    return *atlas;
     }
 
 
 
-void SpriteGL::findColoredRadiiAlpha( unsigned char *inA, 
-                                      int inWidth, int inHeight ) {
+void SpriteGL::packIntoAtlas( SpriteAtlasGL *inAtlas,
+                              unsigned char *inBytes, char inAlphaOnly,
+                              unsigned int inWidth, unsigned int inHeight ) {
     
-    int w = inWidth;
-    int h = inHeight;
+    if( ! inAlphaOnly ) {
+        // same seam reduction that SingleTextureGL does for its own 
+        // RGBA textures
+        SingleTextureGL::expandEdges( inBytes, inWidth, inHeight );
+        }
     
-    int minX = w;
-    int maxX = 0;
-    int minY = h;
-    int maxY = 0;
+    double u0, v0, u1, v1;
+    
+    mTexture = inAtlas->addImage( inBytes, inWidth, inHeight,
+                                  &u0, &v0, &u1, &v1 );
+    // page reloads as a whole if evicted
+    mTexture->setEvictable( true );
+    mAtlas = inAtlas;
     
-    for( int y=0; y<h; y++ ) {
-        for( int x=0; x<w; x++ ) {
-            int index = y * w + x;
+    mTexU0 = u0;
+    mTexV0 = v0;
+    mTexUScale = u1 - u0;
+    mTexVScale = v1 - v0;
+    }
+
+
+
+
+// shared textures by crc, chained through next
+static HashMap<unsigned int, SpriteSharedTexture*> sharedTextures( 1024 );
+
+
+
+char SpriteGL::useSharedTexture( unsigned int inCRC,
+                                 unsigned char *inRGBA, 
+                                 unsigned int inWidth, 
+                                 unsigned int inHeight,
+                                 char inMipMap ) {
+    SpriteSharedTexture *shared = NULL;
+    
+    if( ! sharedTextures.lookup( inCRC, &shared ) ) {
+        return false;
+        }
+    
+    // texture's bytes had their edges expanded, so compare against
+    // expanded copy of ours
+    unsigned char *expanded = NULL;
+    
+    for( ; shared != NULL; shared = shared->next ) {
+        if( shared->width != inWidth || shared->height != inHeight ||
+            shared->mipMap != inMipMap ) {
+            continue;
+            }
+        
+        if( expanded == NULL ) {
+            int numBytes = inWidth * inHeight * 4;
+            expanded = new unsigned char[ numBytes ];
+            memcpy( expanded, inRGBA, numBytes );
             
-            if( inA[ index ] > 0 ) {
-                
-                if( x < minX ) {
-                    minX = x;
-                    }
-                if( x > maxX ) {
-                    maxX = x;
-                    }
-                if( y < minY ) {
-                    minY = y;
-                    }
-                if( y > maxY ) {
-                    maxY = y;
-                    }
-                }    
+            SingleTextureGL::expandEdges( expanded, inWidth, inHeight );
+            }
+        
+        unsigned int x = 0;
+        unsigned int y = 0;
+        
+        if( shared->atlas != NULL ) {
+            double pageSize = shared->atlas->getPageSize();
+            
+            x = (unsigned int)( shared->texU0 * pageSize + 0.5 );
+            y = (unsigned int)( shared->texV0 * pageSize + 0.5 );
+            }
+        
+        if( shared->texture->backupMatches( expanded, false, x, y,
+                                            inWidth, inHeight ) ) {
+            break;
             }
         }
+    
+    if( expanded != NULL ) {
+        delete [] expanded;
+        }
 
-
-    if( minX > 0 ) {
-        mColoredRadiusLeftX = 0.5 - minX / (double)w;
+    if( shared == NULL ) {
+        // crc collision, or different size or mipmapping
+        return false;
         }
-    if( maxX < w - 1 ) {
-        mColoredRadiusRightX = ( maxX + 1 ) / (double)w - 0.5;
+    
+    mTexture = shared->texture;
+    mAtlas = shared->atlas;
+    mTexU0 = shared->texU0;
+    mTexV0 = shared->texV0;
+    mTexUScale = shared->texUScale;
+    mTexVScale = shared->texVScale;
+    
+    shared->refCount ++;
+    mShared = shared;
+    
+    sNumSharingHits ++;
+    sNumSharedTextureBytes += inWidth * inHeight * 4;
+    
+    return true;
+    }
+
+
+
+void SpriteGL::addSharedTexture( unsigned int inCRC,
+                                 unsigned int inWidth, 
+                                 unsigned int inHeight,
+                                 char inMipMap ) {
+    SpriteSharedTexture *shared = new SpriteSharedTexture;
+    
+    shared->crc = inCRC;
+    shared->width = inWidth;
+    shared->height = inHeight;
+    shared->mipMap = inMipMap;
+    shared->texture = mTexture;
+    shared->atlas = mAtlas;
+    shared->texU0 = mTexU0;
+    shared->texV0 = mTexV0;
+    shared->texUScale = mTexUScale;
+    shared->texVScale = mTexVScale;
+    shared->refCount = 1;
+    
+    shared->next = NULL;
+    sharedTextures.lookup( inCRC, &( shared->next ) );
+    
+    sharedTextures.insert( inCRC, shared );
+    
+    mShared = shared;
+    }
+
+
+
+// returns true if texture is no longer used by any sprite
+static char releaseSharedTexture( SpriteSharedTexture *inShared ) {
+    inShared->refCount --;
+    
+    if( inShared->refCount > 0 ) {
+        return false;
         }
     
-    if( minY > 0 ) {
-        mColoredRadiusTopY = 0.5 - minY / (double)h;
+    // unlink from chain
+    SpriteSharedTexture *first = NULL;
+    sharedTextures.lookup( inShared->crc, &first );
+    
+    if( first == inShared ) {
+        if( inShared->next != NULL ) {
+            sharedTextures.insert( inShared->crc, inShared->next );
+            }
+        else {
+            sharedTextures.remove( inShared->crc );
+            }
         }
-    if( maxY < h - 1 ) {
-        mColoredRadiusBottomY = ( maxY + 1 ) / (double)h - 0.5;
+    else {
+        SpriteSharedTexture *s = first;
+        while( s != NULL && s->next != inShared ) {
+            s = s->next;
+            }
+        if( s != NULL ) {
+            s->next = inShared->next;
+            }
         }
+    
+    delete inShared;
+    
+    return true;
     }
 
 
@@ -195,8 +785,12 @@ void SpriteGL::initTexture( Image *inImage,
                             int inNumFrames,
                             int inNumPages, char inSetColoredRadii ) {
     
-    mLastSetMinFilter = -1;
-    mLastSetMagFilter = -1;
+    mAtlas = NULL;
+    mShared = NULL;
+    mTexU0 = 0;
+    mTexV0 = 0;
+    mTexUScale = 1;
+    mTexVScale = 1;
     
     mColoredRadiusLeftX = 0.5;
     mColoredRadiusRightX = 0.5;
@@ -228,12 +822,26 @@ void SpriteGL::initTexture( Image *inImage,
             int numPixels = 
                 spriteImage->getWidth() * spriteImage->getHeight();
             
-            double *alpha = spriteImage->getChannel( 3 );
+            if( spriteImage->isCompact() ) {
+                int numChannels = spriteImage->getNumChannels();
+                unsigned char *alpha = 
+                    &( spriteImage->getCompactBytes()[3] );
+                
+                for( int i=0; i<numPixels; i++ ) {
+                    if( alpha[ i * numChannels ] != 255 ) {
+                        generateAlpha = false;
+                        break;
+                        }
+                    }
+                }
+            else {
+                double *alpha = spriteImage->getChannel( 3 );
             
-            for( int i=0; i<numPixels; i++ ) {
-                if( alpha[i] != 1.0 ) {
-                    generateAlpha = false;
-                    break;
+                for( int i=0; i<numPixels; i++ ) {
+                    if( alpha[i] != 1.0 ) {
+                        generateAlpha = false;
+                        break;
+                        }
                     }
                 }
             }
@@ -251,10 +859,24 @@ void SpriteGL::initTexture( Image *inImage,
         }
     
 
-    mTexture = new SingleTextureGL( spriteImage,
-                                    // no wrap
-                                    false,
-                                    sGenerateMipMaps );
+    SpriteAtlasGL *atlas = getAtlas( false, spriteImage->getWidth(),
+                                     spriteImage->getHeight() );
+    
+    if( atlas != NULL ) {
+        unsigned char *rgba = RGBAImage::getRGBABytes( spriteImage );
+        
+        packIntoAtlas( atlas, rgba, false, 
+                       spriteImage->getWidth(), spriteImage->getHeight() );
+        
+        delete [] rgba;
+        }
+    else {
+        mTexture = new SingleTextureGL( spriteImage,
+                                        // no wrap
+                                        false,
+                                        sGenerateMipMaps );
+        mTexture->setEvictable( true );
+        }
 
 
     mWidth = spriteImage->getWidth();
@@ -281,9 +903,69 @@ SpriteGL::SpriteGL( unsigned char *inRGBA,
                     int inNumFrames,
                     int inNumPages,
                     char inSetColoredRadii ) {
+    initRGBA( inRGBA, inWidth, inHeight, inNumFrames, inNumPages,
+              inSetColoredRadii );
+    }
+
+
+
+SpriteGL::SpriteGL() {
+    mTexture = NULL;
+    mAtlas = NULL;
+    mShared = NULL;
+    mTexU0 = 0;
+    mTexV0 = 0;
+    mTexUScale = 1;
+    mTexVScale = 1;
+    
+    mColoredRadiusLeftX = 0.5;
+    mColoredRadiusRightX = 0.5;
+    mColoredRadiusTopY = 0.5;
+    mColoredRadiusBottomY = 0.5;
+    
+    mNumFrames = 1;
+    mNumPages = 1;
+
+    mWidth = 0;
+    mHeight = 0;
+    
+    mBaseScaleX = 0;
+    mBaseScaleY = 0;
+    
+    mFlipHorizontal = false;
+    mCurrentPage = 0;
+
+    mCenterOffset.x = 0;
+    mCenterOffset.y = 0;
+    }
+
+
+
+void SpriteGL::fill( unsigned char *inRGBA, 
+                     unsigned int inWidth, unsigned int inHeight,
+                     char inSetColoredRadii,
+                     ColoredBox *inColoredBox,
+                     MipChain *inMipLevels ) {
+    initRGBA( inRGBA, inWidth, inHeight, 1, 1, inSetColoredRadii,
+              inColoredBox, inMipLevels );
+    }
+
+
 
-    mLastSetMinFilter = -1;
-    mLastSetMagFilter = -1;
+void SpriteGL::initRGBA( unsigned char *inRGBA, 
+                         unsigned int inWidth, unsigned int inHeight,
+                         int inNumFrames,
+                         int inNumPages,
+                         char inSetColoredRadii,
+                         ColoredBox *inColoredBox,
+                         MipChain *inMipLevels ) {
+
+    mAtlas = NULL;
+    mShared = NULL;
+    mTexU0 = 0;
+    mTexV0 = 0;
+    mTexUScale = 1;
+    mTexVScale = 1;
     
     mColoredRadiusLeftX = 0.5;
     mColoredRadiusRightX = 0.5;
@@ -294,13 +976,57 @@ SpriteGL::SpriteGL( unsigned char *inRGBA,
     mNumPages = inNumPages;
 
     if( inSetColoredRadii ) {
-        findColoredRadii( inRGBA, inWidth, inHeight );
+        ColoredBox box;
+        
+        if( inColoredBox == NULL ) {
+            findColoredBox( inRGBA, inWidth, inHeight, 4, 3, &box );
+            inColoredBox = &box;
+            }
+        setColoredRadii( inColoredBox, inWidth, inHeight );
         }
     
-    mTexture = new SingleTextureGL( inRGBA, inWidth, inHeight,
-                                    // no wrap
-                                    false,
-                                    sGenerateMipMaps );    
+    unsigned int crc = 0;
+    
+    if( sShareTextures ) {
+        // hash before packing or texture creation expands edges in place
+        crc = crc32( inRGBA, inWidth * inHeight * 4 );
+        
+        sNumSharingChecks ++;
+        }
+    
+    char mipMap = sGenerateMipMaps || inMipLevels != NULL;
+    
+    if( ! sShareTextures || 
+        ! useSharedTexture( crc, inRGBA, inWidth, inHeight, mipMap ) ) {
+        
+        SpriteAtlasGL *atlas = NULL;
+        
+        if( inMipLevels == NULL ) {
+            atlas = getAtlas( false, inWidth, inHeight );
+            }
+        
+        if( atlas != NULL ) {
+            packIntoAtlas( atlas, inRGBA, false, inWidth, inHeight );
+            }
+        else if( inMipLevels != NULL ) {
+            mTexture = new SingleTextureGL( inRGBA, inWidth, inHeight,
+                                            // no wrap
+                                            false,
+                                            inMipLevels );
+            mTexture->setEvictable( true );
+            }
+        else {
+            mTexture = new SingleTextureGL( inRGBA, inWidth, inHeight,
+                                            // no wrap
+                                            false,
+                                            sGenerateMipMaps );
+            mTexture->setEvictable( true );
+            }
+        
+        if( sShareTextures ) {
+            addSharedTexture( crc, inWidth, inHeight, mipMap );
+            }
+        }
 
     mWidth = inWidth;
     mHeight = inHeight;
@@ -325,8 +1051,12 @@ SpriteGL::SpriteGL( char inAlphaOnly,
                     int inNumPages,
                     char inSetColoredRadii ) {
 
-    mLastSetMinFilter = -1;
-    mLastSetMagFilter = -1;
+    mAtlas = NULL;
+    mShared = NULL;
+    mTexU0 = 0;
+    mTexV0 = 0;
+    mTexUScale = 1;
+    mTexVScale = 1;
     
     mColoredRadiusLeftX = 0.5;
     mColoredRadiusRightX = 0.5;
@@ -337,14 +1067,24 @@ SpriteGL::SpriteGL( char inAlphaOnly,
     mNumPages = inNumPages;
 
     if( inSetColoredRadii ) {
-        findColoredRadiiAlpha( inA, inWidth, inHeight );
+        ColoredBox box;
+        findColoredBox( inA, inWidth, inHeight, 1, 0, &box );
+        setColoredRadii( &box, inWidth, inHeight );
         }
 
-    mTexture = new SingleTextureGL( inAlphaOnly,
-                                    inA, inWidth, inHeight,
-                                    // no wrap
-                                    false,
-                                    sGenerateMipMaps );
+    SpriteAtlasGL *atlas = getAtlas( true, inWidth, inHeight );
+    
+    if( atlas != NULL ) {
+        packIntoAtlas( atlas, inA, true, inWidth, inHeight );
+        }
+    else {
+        mTexture = new SingleTextureGL( inAlphaOnly,
+                                        inA, inWidth, inHeight,
+                                        // no wrap
+                                        false,
+                                        sGenerateMipMaps );
+        mTexture->setEvictable( true );
+        }
 
     mWidth = inWidth;
     mHeight = inHeight;
@@ -363,8 +1103,90 @@ SpriteGL::SpriteGL( char inAlphaOnly,
 
 
 
+SpriteGL::SpriteGL( CompressedTexture *inTexture,
+                    int inNumFrames,
+                    int inNumPages,
+                    char inSetColoredRadii ) {
+
+    mAtlas = NULL;
+    mShared = NULL;
+    mTexU0 = 0;
+    mTexV0 = 0;
+    mTexUScale = 1;
+    mTexVScale = 1;
+    
+    mColoredRadiusLeftX = 0.5;
+    mColoredRadiusRightX = 0.5;
+    mColoredRadiusTopY = 0.5;
+    mColoredRadiusBottomY = 0.5;
+    
+    mNumFrames = inNumFrames;
+    mNumPages = inNumPages;
+
+    unsigned int w = inTexture->getWidth();
+    unsigned int h = inTexture->getHeight();
+
+    if( inSetColoredRadii ) {
+        unsigned char *rgba = inTexture->decodeLevel( 0 );
+        
+        ColoredBox box;
+        findColoredBox( rgba, w, h, 4, 3, &box );
+        setColoredRadii( &box, w, h );
+        
+        delete [] rgba;
+        }
+
+    mTexture = new SingleTextureGL( inTexture,
+                                    // no wrap
+                                    false );
+    mTexture->setEvictable( true );
+    
+    mWidth = w;
+    mHeight = h;
+    
+    mBaseScaleX = w / mNumPages;
+    mBaseScaleY = h / mNumFrames;
+    
+    
+    mFlipHorizontal = false;
+    mCurrentPage = 0;
+
+    mCenterOffset.x = 0;
+    mCenterOffset.y = 0;
+    }
+
+
+
+
 SpriteGL::~SpriteGL() {
-    delete mTexture;
+    // batch may still reference our texture
+    flushBatch();
+    
+    if( mShared != NULL ) {
+        if( ! releaseSharedTexture( mShared ) ) {
+            // other sprites still drawing with it
+            sNumSharedTextureBytes -= mWidth * mHeight * 4;
+            return;
+            }
+        }
+    
+    if( mAtlas != NULL ) {
+        mAtlas->removeImage( mTexture );
+        
+        if( mAtlas->getNumPages() == 0 ) {
+            // last sprite in atlas gone
+            if( mAtlas == rgbaAtlas ) {
+                rgbaAtlas = NULL;
+                }
+            else if( mAtlas == alphaAtlas ) {
+                alphaAtlas = NULL;
+                }
+            delete mAtlas;
+            }
+        }
+    else if( mTexture != NULL ) {
+        delete mTexture;
+        }
     }
 
 
@@ -376,6 +1198,16 @@ SpriteGL::~SpriteGL() {
 #ifdef GLES
 
 
+// batching not supported on GLES (no GL_QUADS), always draw directly
+
+void SpriteGL::toggleBatching( char inBatch ) {
+    }
+
+
+void SpriteGL::flushBatchInternal() {
+    }
+
+
 // opt (found with profiler)
 // only construct these once, not every draw call
 GLfloat squareVertices[4*2];
@@ -467,45 +1299,12 @@ void SpriteGL::prepareDraw( int inFrame,
         }
 
 
-    mTexture->enable();
-    
-    if( inMipMapFilter ) {
-        if( mLastSetMinFilter != 2 ) {
-            glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, 
-                             GL_LINEAR_MIPMAP_LINEAR );
-            mLastSetMinFilter = 2;
-            }
-        }
-    else {
-        
-        if( inLinearMagFilter ) {
-            if( mLastSetMinFilter != 1 ) {
-                glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, 
-                                 GL_LINEAR );
-                mLastSetMinFilter = 1;
-                }
-            }
-        else {
-            if( mLastSetMinFilter != 0 ) {
-                glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, 
-                                 GL_NEAREST );
-                mLastSetMinFilter = 0;
-                }
-            }
-        }
-    
-    if( inLinearMagFilter ) {
-        if( mLastSetMagFilter != 1 ) {
-            glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
-            mLastSetMagFilter = 1;
-            }
-        }
-    else {
-        if( mLastSetMagFilter != 0 ) {
-            glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
-            mLastSetMagFilter = 0;
-            }
-        }
+    mTexture->enable();
+    
+    applyTextureFilters( mTexture,
+                         getMinFilterCode( inLinearMagFilter, 
+                                           inMipMapFilter ),
+                         inLinearMagFilter ? 1 : 0 );
     
 
 
@@ -524,6 +1323,13 @@ void SpriteGL::prepareDraw( int inFrame,
     textYA += (float)( 0.5 - mColoredRadiusTopY );
     textYB -= (float)( 0.5 - mColoredRadiusBottomY );
 
+    if( mAtlas != NULL ) {
+        // into our rectangle on atlas page
+        textXA = (float)( mTexU0 + textXA * mTexUScale );
+        textXB = (float)( mTexU0 + textXB * mTexUScale );
+        textYA = (float)( mTexV0 + textYA * mTexVScale );
+        textYB = (float)( mTexV0 + textYB * mTexVScale );
+        }
 
 
     squareTextureCoords[0] = textXA;
@@ -549,6 +1355,16 @@ void SpriteGL::draw( int inFrame,
                      char inMipMapFilter,
                      double inRotation,
                      char inFlipH ) {
+    if( mTexture == NULL ) {
+        // empty, not filled yet
+        return;
+        }
+
+    if( ! mTexture->makeResident() ) {
+        // evicted, and out of reloads for this frame
+        return;
+        }
+
     
     
     prepareDraw( inFrame, inPosition, inScale, inLinearMagFilter, 
@@ -580,6 +1396,16 @@ void SpriteGL::draw( int inFrame,
                      char inMipMapFilter,
                      double inRotation,
                      char inFlipH ) {
+    if( mTexture == NULL ) {
+        // empty, not filled yet
+        return;
+        }
+
+    if( ! mTexture->makeResident() ) {
+        // evicted, and out of reloads for this frame
+        return;
+        }
+
 
     prepareDraw( inFrame, inPosition, inScale, inLinearMagFilter,
                  inMipMapFilter,
@@ -622,6 +1448,44 @@ void SpriteGL::draw( int inFrame,
     }
 
 
+void SpriteGL::drawInstances( int inFrame, int inNumInstances,
+                              const doublePair *inCenters,
+                              const float *inScales,
+                              const float *inRotations,
+                              const FloatColor *inColors,
+                              char inLinearMagFilter,
+                              char inMipMapFilter ) {
+    // no GL_QUADS, draw one at a time
+    Vector3D pos( 0, 0, 0 );
+    
+    for( int n=0; n<inNumInstances; n++ ) {
+        pos.mX = inCenters[n].x;
+        pos.mY = inCenters[n].y;
+        
+        double scale = 1;
+        if( inScales != NULL ) {
+            scale = inScales[n];
+            }
+        double rotation = 0;
+        if( inRotations != NULL ) {
+            rotation = inRotations[n];
+            }
+        
+        if( inColors != NULL ) {
+            FloatColor corners[4] = 
+                { inColors[n], inColors[n], inColors[n], inColors[n] };
+            
+            draw( inFrame, &pos, corners, scale, 
+                  inLinearMagFilter, inMipMapFilter, rotation );
+            }
+        else {
+            draw( inFrame, &pos, scale, 
+                  inLinearMagFilter, inMipMapFilter, rotation );
+            }
+        }
+    }
+
+
 
 
 
@@ -643,6 +1507,314 @@ GLfloat squareColors[4*4];
 GLfloat squareTextureCoords[4*2];
 
 
+// filter codes computed by last prepareDraw
+static int preparedMinFilter = 0;
+static int preparedMagFilter = 0;
+
+
+
+typedef struct SpriteBatchVertex {
+        GLfloat x, y;
+        GLfloat u, v;
+        GLfloat r, g, b, a;
+        // batchMode when queued, only read by shaded batches
+        GLfloat mode[4];
+    } SpriteBatchVertex;
+
+
+typedef struct SpriteBatchQuad {
+        // BL, BR, TR, TL (GL_QUADS order)
+        SpriteBatchVertex v[4];
+        
+        // index into batchRuns
+        int run;
+    } SpriteBatchQuad;
+
+
+// quads that will be drawn together with one texture bind and draw call
+typedef struct SpriteBatchRun {
+        SingleTextureGL *texture;
+        int minFilter;
+        int magFilter;
+        
+        int numQuads;
+        
+        // bounding box of all quads, for checking whether later quads can
+        // be moved into this run without changing what's drawn on top
+        GLfloat minX, minY, maxX, maxY;
+        
+        // filled during flush
+        int outputStart;
+    } SpriteBatchRun;
+
+
+// storage stays allocated between frames (shrink instead of deleteAll)
+static SimpleVector<SpriteBatchQuad> batchQuads( 1024 );
+static SimpleVector<SpriteBatchRun> batchRuns( 64 );
+
+static SpriteBatchVertex *batchOutput = NULL;
+static int batchOutputNumQuads = 0;
+
+
+// how many runs back we look for one with the same texture
+static const int batchLookBack = 16;
+
+
+
+void SpriteGL::toggleBatching( char inBatch ) {
+    if( ! inBatch ) {
+        flushBatch();
+        }
+    sBatching = inBatch;
+    }
+
+
+
+static char boxesOverlap( SpriteBatchRun *inRun, 
+                          GLfloat inMinX, GLfloat inMinY, 
+                          GLfloat inMaxX, GLfloat inMaxY ) {
+    return ! ( inMaxX < inRun->minX || inMinX > inRun->maxX ||
+               inMaxY < inRun->minY || inMinY > inRun->maxY );
+    }
+
+
+
+// finds a run that inNumQuads quads with bounding box inMin/inMax can join,
+// or makes a new one, and adds them to its count and bounding box
+// returns index of run
+static int findBatchRun( SingleTextureGL *inTexture,
+                         int inMinFilter, int inMagFilter,
+                         GLfloat inMinX, GLfloat inMinY, 
+                         GLfloat inMaxX, GLfloat inMaxY,
+                         int inNumQuads ) {
+    // find a run to join
+    // walk back from newest run, stopping at first run we'd have to 
+    // jump over that overlaps these quads
+    int runIndex = -1;
+    
+    int numRuns = batchRuns.size();
+    int oldestToCheck = numRuns - batchLookBack;
+    if( oldestToCheck < 0 ) {
+        oldestToCheck = 0;
+        }
+    
+    for( int r=numRuns-1; r>=oldestToCheck; r-- ) {
+        SpriteBatchRun *run = batchRuns.getElementFast( r );
+        
+        if( run->texture == inTexture &&
+            run->minFilter == inMinFilter &&
+            run->magFilter == inMagFilter ) {
+            runIndex = r;
+            break;
+            }
+        
+        if( boxesOverlap( run, inMinX, inMinY, inMaxX, inMaxY ) ) {
+            // these quads must be drawn after this run
+            break;
+            }
+        }
+    
+    if( runIndex == -1 ) {
+        SpriteBatchRun run;
+        run.texture = inTexture;
+        run.minFilter = inMinFilter;
+        run.magFilter = inMagFilter;
+        run.numQuads = 0;
+        run.minX = inMinX;
+        run.minY = inMinY;
+        run.maxX = inMaxX;
+        run.maxY = inMaxY;
+        run.outputStart = 0;
+        
+        batchRuns.push_back( run );
+        runIndex = batchRuns.size() - 1;
+        }
+    
+    SpriteBatchRun *run = batchRuns.getElementFast( runIndex );
+    
+    run->numQuads += inNumQuads;
+    if( inMinX < run->minX ) run->minX = inMinX;
+    if( inMinY < run->minY ) run->minY = inMinY;
+    if( inMaxX > run->maxX ) run->maxX = inMaxX;
+    if( inMaxY > run->maxY ) run->maxY = inMaxY;
+    
+    return runIndex;
+    }
+
+
+
+void SpriteGL::addToBatch( int inMinFilter, int inMagFilter,
+                           FloatColor *inCornerColors ) {
+    
+    SpriteBatchQuad q;
+    
+    // squareVertices are in strip order (BL, BR, TL, TR)
+    static const int stripIndex[4] = { 0, 1, 3, 2 };
+    
+    GLfloat minX = squareVertices[0];
+    GLfloat maxX = minX;
+    GLfloat minY = squareVertices[1];
+    GLfloat maxY = minY;
+    
+    for( int i=0; i<4; i++ ) {
+        int s = stripIndex[i];
+        
+        SpriteBatchVertex *v = &( q.v[i] );
+        
+        v->x = squareVertices[ 2 * s ];
+        v->y = squareVertices[ 2 * s + 1 ];
+        v->u = squareTextureCoords[ 2 * s ];
+        v->v = squareTextureCoords[ 2 * s + 1 ];
+        
+        if( inCornerColors != NULL ) {
+            // corner colors already in BL, BR, TR, TL order
+            v->r = inCornerColors[i].r;
+            v->g = inCornerColors[i].g;
+            v->b = inCornerColors[i].b;
+            v->a = inCornerColors[i].a;
+            }
+        else {
+            v->r = batchColor[0];
+            v->g = batchColor[1];
+            v->b = batchColor[2];
+            v->a = batchColor[3];
+            }
+        
+        memcpy( v->mode, batchMode, sizeof( batchMode ) );
+        
+        if( v->x < minX ) minX = v->x;
+        if( v->x > maxX ) maxX = v->x;
+        if( v->y < minY ) minY = v->y;
+        if( v->y > maxY ) maxY = v->y;
+        }
+    
+    
+    q.run = findBatchRun( mTexture, inMinFilter, inMagFilter,
+                          minX, minY, maxX, maxY, 1 );
+    batchQuads.push_back( q );
+    
+    sNumBatchQuads = batchQuads.size();
+    }
+
+
+
+void SpriteGL::flushBatchInternal() {
+    int numQuads = batchQuads.size();
+    int numRuns = batchRuns.size();
+    
+    if( numQuads > batchOutputNumQuads ) {
+        if( batchOutput != NULL ) {
+            delete [] batchOutput;
+            }
+        batchOutputNumQuads = numQuads * 2;
+        batchOutput = new SpriteBatchVertex[ 4 * batchOutputNumQuads ];
+        }
+    
+
+    // lay runs out contiguously, in run order
+    int next = 0;
+    for( int r=0; r<numRuns; r++ ) {
+        SpriteBatchRun *run = batchRuns.getElementFast( r );
+        run->outputStart = next;
+        next += run->numQuads;
+        }
+    
+
+    // scatter quads into their runs, preserving submission order within
+    // each run    
+    for( int i=0; i<numQuads; i++ ) {
+        SpriteBatchQuad *q = batchQuads.getElementFast( i );
+        SpriteBatchRun *run = batchRuns.getElementFast( q->run );
+        
+        memcpy( &( batchOutput[ 4 * run->outputStart ] ), q->v, 
+                sizeof( q->v ) );
+        run->outputStart ++;
+        }
+    
+
+    GLsizei stride = sizeof( SpriteBatchVertex );
+    
+    glVertexPointer( 2, GL_FLOAT, stride, &( batchOutput[0].x ) );
+    glTexCoordPointer( 2, GL_FLOAT, stride, &( batchOutput[0].u ) );
+    glColorPointer( 4, GL_FLOAT, stride, &( batchOutput[0].r ) );
+    
+    glEnableClientState( GL_VERTEX_ARRAY );
+    glEnableClientState( GL_TEXTURE_COORD_ARRAY );
+    glEnableClientState( GL_COLOR_ARRAY );
+    sStateSet = true;
+    
+
+    ShaderProgramGL *program = NULL;
+    char premultiplied = false;
+    
+    if( sShading ) {
+        program = getBatchProgram();
+        }
+    
+    if( program != NULL ) {
+        program->use();
+        
+        ShaderProgramGL::setAttributeArray( BATCH_MODE_ATTRIBUTE, 4, stride,
+                                            batchOutput[0].mode );
+        
+        premultiplied = batchBlendMixable;
+        
+        ShaderProgramGL::setUniform( batchPremultipliedUniform,
+                                     premultiplied ? 1.0f : 0.0f );
+        if( premultiplied ) {
+            glBlendFunc( GL_ONE, GL_ONE_MINUS_SRC_ALPHA );
+            }
+        }
+    
+    // -1 until set for first run
+    int alphaTexture = -1;
+    
+
+    for( int r=0; r<numRuns; r++ ) {
+        SpriteBatchRun *run = batchRuns.getElementFast( r );
+        
+        // outputStart has been advanced to end of run
+        int start = run->outputStart - run->numQuads;
+        
+        run->texture->enable();
+        applyTextureFilters( run->texture, run->minFilter, run->magFilter );
+        
+        if( program != NULL && 
+            alphaTexture != run->texture->isAlphaOnly() ) {
+            alphaTexture = run->texture->isAlphaOnly();
+            
+            ShaderProgramGL::setUniform( batchAlphaTextureUniform,
+                                         alphaTexture ? 1.0f : 0.0f );
+            }
+        
+        glDrawArrays( GL_QUADS, 4 * start, 4 * run->numQuads );
+
+        sNumBatchDrawCalls ++;
+        }
+    
+    if( program != NULL ) {
+        ShaderProgramGL::clearAttributeArray( BATCH_MODE_ATTRIBUTE );
+        ShaderProgramGL::stopUsing();
+        
+        if( premultiplied ) {
+            glBlendFunc( batchBlendSrc, batchBlendDst );
+            }
+        }
+    
+    glDisableClientState( GL_COLOR_ARRAY );
+    
+    // color array leaves current color undefined
+    glColor4fv( batchColor );
+    
+    
+    batchQuads.shrink( 0 );
+    batchRuns.shrink( 0 );
+    sNumBatchQuads = 0;
+    
+    sNumBatchFlushes ++;
+    }
+
+
 
 
 void SpriteGL::prepareDraw( int inFrame, 
@@ -777,45 +1949,15 @@ void SpriteGL::prepareDraw( int inFrame,
         glColor4f( 1, 1, 1, inFadeFactor );
         }
     */          
-    mTexture->enable();
+    preparedMinFilter = getMinFilterCode( inLinearMagFilter, inMipMapFilter );
+    preparedMagFilter = inLinearMagFilter ? 1 : 0;
     
-
-    if( inMipMapFilter ) {
-        if( mLastSetMinFilter != 2 ) {
-            glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, 
-                             GL_LINEAR_MIPMAP_LINEAR );
-            mLastSetMinFilter = 2;
-            }
-        }
-    else {
+    if( ! sBatching ) {
+        // batch binds texture and sets filters when it is flushed
+        mTexture->enable();
         
-        if( inLinearMagFilter ) {
-            if( mLastSetMinFilter != 1 ) {
-                glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, 
-                                 GL_LINEAR );
-                mLastSetMinFilter = 1;
-                }
-            }
-        else {
-            if( mLastSetMinFilter != 0 ) {
-                glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, 
-                                 GL_NEAREST );
-                mLastSetMinFilter = 0;
-                }
-            }
-        }
-    
-    if( inLinearMagFilter ) {
-        if( mLastSetMagFilter != 1 ) {
-            glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
-            mLastSetMagFilter = 1;
-            }
-        }
-    else {
-        if( mLastSetMagFilter != 0 ) {
-            glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
-            mLastSetMagFilter = 0;
-            }
+        applyTextureFilters( mTexture, 
+                             preparedMinFilter, preparedMagFilter );
         }
 
     
@@ -834,6 +1976,14 @@ void SpriteGL::prepareDraw( int inFrame,
     textYB += 0.5 - mColoredRadiusTopY;
     textYA -= 0.5 - mColoredRadiusBottomY;
 
+    if( mAtlas != NULL ) {
+        // into our rectangle on atlas page
+        textXA = mTexU0 + textXA * mTexUScale;
+        textXB = mTexU0 + textXB * mTexUScale;
+        textYA = mTexV0 + textYA * mTexVScale;
+        textYB = mTexV0 + textYB * mTexVScale;
+        }
+
     squareTextureCoords[0] = textXA;
     squareTextureCoords[1] = textYA;
 
@@ -859,6 +2009,16 @@ void SpriteGL::draw( int inFrame,
                      char inMipMapFilter,
                      double inRotation,
                      char inFlipH ) {
+    if( mTexture == NULL ) {
+        // empty, not filled yet
+        return;
+        }
+
+    if( ! mTexture->makeResident() ) {
+        // evicted, and out of reloads for this frame
+        return;
+        }
+
     // numPixelsDrawn += 
     //    ( mColoredRadiusRightX + mColoredRadiusLeftX ) * mWidth *
     //    ( mColoredRadiusTopY + mColoredRadiusBottomY ) * mHeight;
@@ -868,6 +2028,10 @@ void SpriteGL::draw( int inFrame,
                  inMipMapFilter,
                  inRotation, inFlipH );
 
+    if( sBatching ) {
+        addToBatch( preparedMinFilter, preparedMagFilter, NULL );
+        return;
+        }
 
     glVertexPointer( 2, GL_FLOAT, 0, squareVertices );
     
@@ -917,11 +2081,25 @@ void SpriteGL::draw( int inFrame,
                      char inMipMapFilter,
                      double inRotation,
                      char inFlipH ) {
+    if( mTexture == NULL ) {
+        // empty, not filled yet
+        return;
+        }
+
+    if( ! mTexture->makeResident() ) {
+        // evicted, and out of reloads for this frame
+        return;
+        }
+
 
     prepareDraw( inFrame, inPosition, inScale, inLinearMagFilter,
                  inMipMapFilter,
                  inRotation, inFlipH );
 
+    if( sBatching ) {
+        addToBatch( preparedMinFilter, preparedMagFilter, inCornerColors );
+        return;
+        }
 
     glVertexPointer( 2, GL_FLOAT, 0, squareVertices );
     glTexCoordPointer( 2, GL_FLOAT, 0, squareTextureCoords );
@@ -970,6 +2148,16 @@ void SpriteGL::draw( int inFrame,
                      FloatColor inCornerColors[4],
                      char inLinearMagFilter,
                      char inMipMapFilter ) {
+    if( mTexture == NULL ) {
+        // empty, not filled yet
+        return;
+        }
+
+    if( ! mTexture->makeResident() ) {
+        // evicted, and out of reloads for this frame
+        return;
+        }
+
 
     prepareDraw( inFrame, &dummyPosition, 1, inLinearMagFilter,
                  inMipMapFilter,
@@ -991,6 +2179,10 @@ void SpriteGL::draw( int inFrame,
     squareVertices[6] = inCornerPos[2].x;
     squareVertices[7] = inCornerPos[2].y;
     
+    if( sBatching ) {
+        addToBatch( preparedMinFilter, preparedMagFilter, inCornerColors );
+        return;
+        }
     
     glVertexPointer( 2, GL_FLOAT, 0, squareVertices );
     glTexCoordPointer( 2, GL_FLOAT, 0, squareTextureCoords );
@@ -1030,7 +2222,177 @@ void SpriteGL::draw( int inFrame,
     }
 
 
+// expanded quads for unbatched instance drawing
+static SpriteBatchVertex *instanceOutput = NULL;
+static int instanceOutputNumQuads = 0;
 
-#endif
+
+void SpriteGL::drawInstances( int inFrame, int inNumInstances,
+                              const doublePair *inCenters,
+                              const float *inScales,
+                              const float *inRotations,
+                              const FloatColor *inColors,
+                              char inLinearMagFilter,
+                              char inMipMapFilter ) {
+    if( mTexture == NULL || inNumInstances <= 0 ) {
+        return;
+        }
+
+    if( ! mTexture->makeResident() ) {
+        // evicted, and out of reloads for this frame
+        return;
+        }
+
+    // corners of an unscaled, unrotated instance centered on 0,0,
+    // and texture coordinates shared by all instances
+    prepareDraw( inFrame, &dummyPosition, 1, inLinearMagFilter,
+                 inMipMapFilter, 0, false );
+    
+    // squareVertices are in strip order (BL, BR, TL, TR)
+    static const int stripIndex[4] = { 0, 1, 3, 2 };
+    
+    GLfloat cornerX[4], cornerY[4], cornerU[4], cornerV[4];
+    
+    for( int i=0; i<4; i++ ) {
+        int s = stripIndex[i];
+        cornerX[i] = squareVertices[ 2 * s ];
+        cornerY[i] = squareVertices[ 2 * s + 1 ];
+        cornerU[i] = squareTextureCoords[ 2 * s ];
+        cornerV[i] = squareTextureCoords[ 2 * s + 1 ];
+        }
+    
+    
+    int firstBatchQuad = 0;
+    
+    if( sBatching ) {
+        firstBatchQuad = batchQuads.size();
+        
+        // filled in place below
+        SpriteBatchQuad blank;
+        for( int n=0; n<inNumInstances; n++ ) {
+            batchQuads.push_back( blank );
+            }
+        }
+    else if( inNumInstances > instanceOutputNumQuads ) {
+        if( instanceOutput != NULL ) {
+            delete [] instanceOutput;
+            }
+        instanceOutputNumQuads = inNumInstances * 2;
+        instanceOutput = new SpriteBatchVertex[ 4 * instanceOutputNumQuads ];
+        }
+    
+
+    double areaSum = 0;
+    
+    GLfloat minX = 0, minY = 0, maxX = 0, maxY = 0;
+    
+    for( int n=0; n<inNumInstances; n++ ) {
+        
+        GLfloat scale = 1;
+        if( inScales != NULL ) {
+            scale = inScales[n];
+            }
+        
+        // scale and rotation folded together
+        GLfloat xx = scale;
+        GLfloat xy = 0;
+        
+        if( inRotations != NULL && inRotations[n] != 0 ) {
+            double angle = - 2 * M_PI * inRotations[n];
+            xx = (GLfloat)( scale * cos( angle ) );
+            xy = (GLfloat)( scale * sin( angle ) );
+            }
+        
+        GLfloat posX = (GLfloat)inCenters[n].x;
+        GLfloat posY = (GLfloat)inCenters[n].y;
+        
+        const GLfloat *color = batchColor;
+        if( inColors != NULL ) {
+            color = &( inColors[n].r );
+            }
+        
+        SpriteBatchVertex *v;
+        if( sBatching ) {
+            SpriteBatchQuad *q = 
+                batchQuads.getElementFast( firstBatchQuad + n );
+            v = q->v;
+            }
+        else {
+            v = &( instanceOutput[ 4 * n ] );
+            }
+        
+        for( int i=0; i<4; i++ ) {
+            GLfloat x = cornerX[i];
+            GLfloat y = cornerY[i];
+            
+            v[i].x = x * xx - y * xy + posX;
+            v[i].y = x * xy + y * xx + posY;
+            v[i].u = cornerU[i];
+            v[i].v = cornerV[i];
+            v[i].r = color[0];
+            v[i].g = color[1];
+            v[i].b = color[2];
+            v[i].a = color[3];
+            memcpy( v[i].mode, batchMode, sizeof( batchMode ) );
+            
+            if( n == 0 && i == 0 ) {
+                minX = maxX = v[i].x;
+                minY = maxY = v[i].y;
+                }
+            else {
+                if( v[i].x < minX ) minX = v[i].x;
+                if( v[i].x > maxX ) maxX = v[i].x;
+                if( v[i].y < minY ) minY = v[i].y;
+                if( v[i].y > maxY ) maxY = v[i].y;
+                }
+            }
+        
+        areaSum += scale * scale;
+        }
+    
+    if( sCountingPixels ) {
+        // prepareDraw counted one unscaled instance
+        double unscaledArea = 
+            mBaseScaleX * ( mColoredRadiusLeftX + mColoredRadiusRightX ) *
+            mBaseScaleY * ( mColoredRadiusTopY + mColoredRadiusBottomY );
+        
+        sPixelsDrawn += unscaledArea * ( areaSum - 1 );
+        }
+    
+
+    if( sBatching ) {
+        int run = findBatchRun( mTexture, 
+                                preparedMinFilter, preparedMagFilter,
+                                minX, minY, maxX, maxY, inNumInstances );
+        
+        for( int n=0; n<inNumInstances; n++ ) {
+            batchQuads.getElementFast( firstBatchQuad + n )->run = run;
+            }
+        
+        sNumBatchQuads = batchQuads.size();
+        return;
+        }
+    
+
+    GLsizei stride = sizeof( SpriteBatchVertex );
+    
+    glVertexPointer( 2, GL_FLOAT, stride, &( instanceOutput[0].x ) );
+    glTexCoordPointer( 2, GL_FLOAT, stride, &( instanceOutput[0].u ) );
+    glColorPointer( 4, GL_FLOAT, stride, &( instanceOutput[0].r ) );
+    
+    glEnableClientState( GL_VERTEX_ARRAY );
+    glEnableClientState( GL_TEXTURE_COORD_ARRAY );
+    glEnableClientState( GL_COLOR_ARRAY );
+    sStateSet = true;
+    
+    glDrawArrays( GL_QUADS, 0, 4 * inNumInstances );
+    
+    glDisableClientState( GL_COLOR_ARRAY );
+    
+    // color array leaves current color undefined
+    glColor4fv( batchColor );
+    }
 
 
+
+#endif
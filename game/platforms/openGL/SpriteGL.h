@@ -12,6 +12,51 @@
 #include <stdlib.h>
 
 
+class SpriteAtlasGL;
+
+
+
+// texture coloring modes for shaded batches (see SpriteGL::toggleShading)
+// same as GL_MODULATE and GL_ADD texture environments
+#define SPRITE_COLORING_MODULATE 0
+#define SPRITE_COLORING_ADD 1
+// draw color with texture's alpha (see drawSpriteAlphaOnly)
+#define SPRITE_COLORING_ALPHA_ONLY 2
+
+
+
+// texture shared by sprites filled from identical RGBA bytes
+typedef struct SpriteSharedTexture {
+        // of RGBA bytes as passed in, before any edge expansion
+        unsigned int crc;
+        unsigned int width, height;
+        
+        char mipMap;
+        
+        // as in SpriteGL
+        SingleTextureGL *texture;
+        SpriteAtlasGL *atlas;
+        double texU0, texV0;
+        double texUScale, texVScale;
+        
+        // sprites using texture
+        int refCount;
+        
+        // next with same crc
+        struct SpriteSharedTexture *next;
+    } SpriteSharedTexture;
+
+
+
+// box around a sprite's pixels with non-zero alpha, in pixels, inclusive
+// for a fully-transparent image, minX = width, minY = height, and
+// maxX = maxY = 0
+typedef struct ColoredBox {
+        int minX, maxX;
+        int minY, maxY;
+    } ColoredBox;
+
+
 
 class SpriteGL{
     public:
@@ -20,6 +65,47 @@ class SpriteGL{
         static void toggleMipMapGeneration( char inGenerateMipMaps ) {
             sGenerateMipMaps = inGenerateMipMaps;
             }
+        
+        static char isMipMapGenerationOn() {
+            return sGenerateMipMaps;
+            }
+        
+        // packs small sprites into shared atlas textures
+        // (ignored for sprites made while mipmap generation is on)
+        static void toggleAtlas( char inUseAtlas ) {
+            sUseAtlas = inUseAtlas;
+            }
+        
+        // sprites made from RGBA bytes identical to an existing sprite's
+        // (same size, same crc32, then compared byte for byte) share its
+        // texture instead of uploading another copy
+        // each sprite still has its own frames, pages, center offset, and
+        // colored radii
+        // defaults to on
+        static void toggleTextureSharing( char inShare ) {
+            sShareTextures = inShare;
+            }
+        
+        // true if another sprite is using this sprite's texture too
+        char isTextureShared() {
+            return ( mShared != NULL && mShared->refCount > 1 );
+            }
+        
+        // since startup, sprites checked for an identical texture, and
+        // how many found one
+        static int getNumSharingChecks() {
+            return sNumSharingChecks;
+            }
+        
+        static int getNumSharingHits() {
+            return sNumSharingHits;
+            }
+        
+        // texture bytes not uploaded because sprites still alive are
+        // sharing
+        static int getNumSharedTextureBytes() {
+            return sNumSharedTextureBytes;
+            }
             
         
 
@@ -44,6 +130,30 @@ class SpriteGL{
                   int inNumPages = 1,
                   char inSetColoredRadii = false );
 
+
+        // empty sprite that draws nothing until filled
+        SpriteGL();
+        
+        // fills an empty sprite (single frame and page)
+        // inColoredBox, if not NULL, is used for colored radii instead of
+        // scanning inRGBA (it can be found ahead of time with
+        // findColoredBox)
+        // inMipLevels, if not NULL, are uploaded as the sprite's mipmaps
+        // (whether or not mipmap generation is on now), instead of having
+        // the driver build them.  They must be built from inRGBA with
+        // edges expanded (see SingleTextureGL).  Destroyed by caller.
+        void fill( unsigned char *inRGBA, 
+                   unsigned int inWidth, unsigned int inHeight,
+                   char inSetColoredRadii = false,
+                   ColoredBox *inColoredBox = NULL,
+                   MipChain *inMipLevels = NULL );
+        
+        // false for an empty sprite
+        char isFilled() {
+            return ( mTexture != NULL );
+            }
+        
+
         // one-channel, alpha-only, with other channels black
         // extra parameter just to differentiate function calls
         SpriteGL( char inAlphaOnly,
@@ -54,6 +164,15 @@ class SpriteGL{
                   char inSetColoredRadii = false );
 
 
+        // from a block-compressed texture, which always gets its own
+        // texture (never an atlas), with the texture's own mipmaps
+        // inTexture destroyed by this class
+        SpriteGL( CompressedTexture *inTexture,
+                  int inNumFrames = 1,
+                  int inNumPages = 1,
+                  char inSetColoredRadii = false );
+
+
         ~SpriteGL();
         
 
@@ -86,7 +205,32 @@ class SpriteGL{
                    FloatColor inCornerColors[4],
                    char inLinearMagFilter = false,
                    char inMipMapFilter = false );
+
+
+        // draws many copies of one frame, each with its own center,
+        // in one draw call (or as one batch run, if batching)
+        // inScales, inRotations, and inColors can each be NULL for
+        // 1, 0, and the batch color
+        void drawInstances( int inFrame, int inNumInstances,
+                            const doublePair *inCenters,
+                            const float *inScales,
+                            const float *inRotations,
+                            const FloatColor *inColors,
+                            char inLinearMagFilter = false,
+                            char inMipMapFilter = false );
+        
         
+
+        // finds box around pixels with non-zero alpha
+        // inPixels has inNumChannels interleaved channels, with alpha
+        // in channel inAlphaChannel
+        // scans in from each edge, testing 32 bytes at a time where
+        // SIMD is available
+        // doesn't touch GL, so can be called from any thread
+        static void findColoredBox( unsigned char *inPixels,
+                                    int inWidth, int inHeight,
+                                    int inNumChannels, int inAlphaChannel,
+                                    ColoredBox *outBox );
         
 
         int getNumFrames() {
@@ -132,6 +276,26 @@ class SpriteGL{
         int getHeight() {
             return mHeight;
             }
+
+
+        // texture memory used by sprite, as RGBA unless it has its own 
+        // compressed texture
+        int getNumTextureBytes() {
+            if( mAtlas == NULL && mTexture != NULL && 
+                mTexture->isCompressed() ) {
+                return mTexture->getNumTextureBytes();
+                }
+            return mWidth * mHeight * 4;
+            }
+        
+        
+        // true if sprite, drawn centered on inPosition with this scale
+        // and rotation, would be entirely outside a world rectangle
+        // conservative for rotated sprites (checks bounding circle)
+        char isOutside( Vector3D *inPosition, double inScale, 
+                        double inRotation,
+                        double inMinX, double inMinY,
+                        double inMaxX, double inMaxY );
         
         
         // sets the sprite's center offset, in pixels, 
@@ -156,34 +320,190 @@ class SpriteGL{
         
         
         static void setTexturingDisabled() {
+            // anything queued must go out before non-sprite drawing
+            flushBatch();
+            
             // need to renable client states later
             sStateSet = false;
             SingleTextureGL::disableTexturing();
             }
 
+
+        // Sprite batching.
+        //
+        // When on, draw calls append their quads to a shared interleaved
+        // vertex buffer (position, UV, color) instead of drawing 
+        // immediately.  Quads that share a texture and filter settings go
+        // out in a single draw call when the batch is flushed.
+        //
+        // A quad may be moved earlier, into an older batch with the same
+        // texture, if it doesn't overlap anything drawn since that batch.
+        //
+        // Batch must be flushed before any GL state that affects sprite
+        // drawing changes (blend mode, texture env, stencil, scissor) and
+        // before any non-sprite drawing.  gameGraphicsGL does this for
+        // its own state-changing calls.
+        //
+        // Defaults to off.
+        static void toggleBatching( char inBatch );
+        
+        static char isBatching() {
+            return sBatching;
+            }
+        
+        // draws everything queued so far
+        static void flushBatch() {
+            if( sNumBatchQuads > 0 ) {
+                flushBatchInternal();
+                }
+            }
+        
+        // color used for quads drawn without corner colors
+        // (tracks glColor, which batched drawing can't use directly)
+        static void setBatchColor( float inR, float inG, float inB, 
+                                   float inA );
+        
+        
+        static void resetBatchCounts() {
+            sNumBatchDrawCallsBeforeReset += sNumBatchDrawCalls;
+            sNumBatchDrawCalls = 0;
+            sNumBatchFlushes = 0;
+            }
+        
+        // draw calls issued by batch flushes
+        static int getNumBatchDrawCalls() {
+            return sNumBatchDrawCalls;
+            }
+        
+        // since startup, unaffected by resetBatchCounts
+        static int getTotalBatchDrawCalls() {
+            return sNumBatchDrawCallsBeforeReset + sNumBatchDrawCalls;
+            }
+        
+        static int getNumBatchFlushes() {
+            return sNumBatchFlushes;
+            }
+
+
+        // Shaded batching.
+        //
+        // When on, and GLSL is supported, batches are drawn by a shader
+        // that takes texture coloring, distance field sharpness, and
+        // normal vs. additive blending from each quad's vertices instead
+        // of from GL state, so quads drawn in different modes can share a
+        // batch.  gameGraphicsGL passes its modes in through the setBatch
+        // calls below and doesn't flush when only these change.
+        // Multiplicative and inverted blends still flush, as does anything
+        // else that flushes a fixed-function batch.
+        //
+        // Fixed-function drawing is used when off, when not batching, and
+        // when the shader can't be built.
+        //
+        // Defaults to off.
+        static void toggleShading( char inShade );
+        
+        // true if queued quads will be drawn by the shader
+        static char isShadingBatch();
+        
+        // texture coloring for quads queued from now on, one of the
+        // SPRITE_COLORING_ values
+        static void setBatchColoring( int inColoring );
+        
+        // for quads queued from now on, texture alpha is scaled around 0.5
+        // by this, for distance field textures
+        // 1 draws texture alpha as is
+        static void setBatchFieldSharpness( float inSharpness );
+        
+        // blend function, as set in GL, -1 if unknown, and whether alpha
+        // test might be on (it would discard additive quads, which have no
+        // alpha when drawn premultiplied)
+        static void setBatchBlend( int inSrc, int inDst, char inAlphaTest );
+        
+
         
         int mWidth, mHeight;
 
     protected:
 
         static char sGenerateMipMaps;
+        static char sUseAtlas;
+        
+        static char sShareTextures;
+        static int sNumSharingChecks;
+        static int sNumSharingHits;
+        static int sNumSharedTextureBytes;
         
         static char sCountingPixels;
         static double sPixelsDrawn;
 
-        // -1 for unset, 0 for nearest, 1 for linear, 2 for mipmap
-        int mLastSetMinFilter;
-        
-        // -1 for unset, 0 for nearest, 1 for linear
-        int mLastSetMagFilter;
-        
         static char sWrapSet;
 
         static char sStateSet;
         
 
+        static char sBatching;
+        static char sShading;
+        static int sNumBatchQuads;
+        static int sNumBatchDrawCalls;
+        static int sNumBatchDrawCallsBeforeReset;
+        static int sNumBatchFlushes;
+        
+        static void flushBatchInternal();
+        
+        // adds quad from squareVertices and squareTextureCoords to batch
+        // inCornerColors can be NULL to use batch color
+        void addToBatch( int inMinFilter, int inMagFilter,
+                         FloatColor *inCornerColors );
+        
+        // filter codes:
+        // -1 for unset, 0 for nearest, 1 for linear, 2 for mipmap (min only)
+        // cached in texture's mLastSetMinFilter and mLastSetMagFilter
+        // texture must be bound
+        static void applyTextureFilters( SingleTextureGL *inTexture,
+                                         int inMinFilter, int inMagFilter );
+        
+
+        // either our own texture, or an atlas page shared with other
+        // sprites
         SingleTextureGL *mTexture;
         
+        // NULL if we have our own texture
+        SpriteAtlasGL *mAtlas;
+        
+        // NULL if texture isn't shareable (not made from RGBA bytes, or
+        // made with sharing off)
+        SpriteSharedTexture *mShared;
+        
+        // sets mTexture and rectangle from an existing texture with
+        // identical bytes
+        // returns false if there isn't one
+        char useSharedTexture( unsigned int inCRC,
+                               unsigned char *inRGBA, 
+                               unsigned int inWidth, unsigned int inHeight,
+                               char inMipMap );
+        
+        // records mTexture and rectangle for sharing
+        void addSharedTexture( unsigned int inCRC,
+                               unsigned int inWidth, unsigned int inHeight,
+                               char inMipMap );
+        
+        // our rectangle in mTexture (0, 0, 1, 1 if not in atlas)
+        double mTexU0, mTexV0;
+        double mTexUScale, mTexVScale;
+        
+        
+        // returns atlas that an image should be packed into, or NULL
+        // if it should have its own texture
+        static SpriteAtlasGL *getAtlas( char inAlphaOnly,
+                                        unsigned int inWidth, 
+                                        unsigned int inHeight );
+        
+        // sets mTexture and rectangle from atlas
+        // expands edges of RGBA inBytes in place
+        void packIntoAtlas( SpriteAtlasGL *inAtlas,
+                            unsigned char *inBytes, char inAlphaOnly,
+                            unsigned int inWidth, unsigned int inHeight );
+        
         int mNumFrames;
         int mNumPages;
         
@@ -210,6 +530,13 @@ class SpriteGL{
         int mCurrentPage;
         
 
+        void initRGBA( unsigned char *inRGBA, 
+                       unsigned int inWidth, unsigned int inHeight,
+                       int inNumFrames, int inNumPages,
+                       char inSetColoredRadii,
+                       ColoredBox *inColoredBox = NULL,
+                       MipChain *inMipLevels = NULL );
+        
         void initTexture( Image *inImage,
                           char inTransparentLowerLeftCorner = false,
                           int inNumFrames = 1,
@@ -233,11 +560,7 @@ class SpriteGL{
 
         void findColoredRadii( Image *inImage );
         
-        void findColoredRadii( unsigned char *inRGBA, 
-                               int inWidth, int inHeight );
-        
-        void findColoredRadiiAlpha( unsigned char *inA, 
-                                    int inWidth, int inHeight );
+        void setColoredRadii( ColoredBox *inBox, int inWidth, int inHeight );
 
     };
 
@@ -2,14 +2,320 @@
 
 #include "SpriteGL.h"
 
+#include "minorGems/graphics/openGL/VertexBufferGL.h"
+#include "minorGems/graphics/openGL/MipChain.h"
+
 #include "minorGems/graphics/openGL/glInclude.h"
 
 #include "minorGems/util/SimpleVector.h"
+#include "minorGems/util/stringUtils.h"
+#include "minorGems/util/FrameArena.h"
+#include "minorGems/util/log/AppLog.h"
+
+#include "minorGems/game/game.h"
+
+#include "minorGems/graphics/converters/tgaDecode.h"
+
+#include "minorGems/system/Thread.h"
+#include "minorGems/system/MutexLock.h"
+#include "minorGems/system/BinarySemaphore.h"
+#include "minorGems/system/Time.h"
+#include "minorGems/system/ZoneProfiler.h"
+
+#ifdef WIN_32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
 
 
 static float lastR, lastG, lastB, lastA;
 
 
+
+// Copy of GL state set through the functions below, so that calls that
+// wouldn't change anything can be skipped, along with the sprite batch
+// flushes that would come before them.
+// -1 means unknown.  Everything becomes unknown on a GL context change,
+// or when invalidateGLStateCache is called after direct GL calls.
+typedef struct GLStateCache {
+        int contextChangeCount;
+        
+        int blendSrc;
+        int blendDst;
+
+        // color is unknown if colorKnown is false
+        char colorKnown;
+        float color[4];
+        
+        int texEnvMode;
+        // GL_ALPHA_SCALE, only above 1 for distance field textures
+        int texEnvAlphaScale;
+        
+        int scissorOn;
+        GLint scissorBox[4];
+        
+        int colorMaskOn;
+        int alphaTestOn;
+        float alphaRef;
+        
+        int stencilOn;
+        int stencilFunc;
+        int stencilRef;
+        int stencilOp;
+    } GLStateCache;
+
+
+static GLStateCache glState = { -1, -1, -1, false, { 0, 0, 0, 0 }, -1,
+                                -1, -1, { -1, -1, -1, -1 }, -1, -1, -1,
+                                -1, -1, -1, -1 };
+
+static double numGLStateCallsIssued = 0;
+static double numGLStateCallsSkipped = 0;
+
+
+
+void invalidateGLStateCache() {
+    glState.blendSrc = -1;
+    glState.blendDst = -1;
+    glState.colorKnown = false;
+    glState.texEnvMode = -1;
+    glState.texEnvAlphaScale = -1;
+    glState.scissorOn = -1;
+    glState.scissorBox[0] = -1;
+    glState.colorMaskOn = -1;
+    glState.alphaTestOn = -1;
+    glState.alphaRef = -1;
+    glState.stencilOn = -1;
+    glState.stencilFunc = -1;
+    glState.stencilRef = -1;
+    glState.stencilOp = -1;
+    
+    glState.contextChangeCount = SingleTextureGL::getContextChangeCount();
+
+    SpriteGL::setBatchBlend( -1, -1, true );
+    }
+
+
+
+// call at start of any function that uses glState
+static void checkGLStateContext() {
+    if( glState.contextChangeCount != 
+        SingleTextureGL::getContextChangeCount() ) {
+        invalidateGLStateCache();
+        }
+    }
+
+
+
+// counts call as issued or skipped, flushing sprite batch before
+// issued calls, unless queued sprites don't depend on what the call changes
+// returns true if call should be skipped
+static char skipStateCall( char inUnchanged, 
+                           char inBatchUnaffected = false ) {
+    if( inUnchanged ) {
+        numGLStateCallsSkipped ++;
+        return true;
+        }
+    
+    numGLStateCallsIssued ++;
+    
+    if( ! inBatchUnaffected ) {
+        SpriteGL::flushBatch();
+        }
+    return false;
+    }
+
+
+
+// shaded batches take normal and additive blending from each sprite
+static char isNormalOrAdditiveBlend( int inSrc, int inDst ) {
+    return inSrc == GL_SRC_ALPHA &&
+        ( inDst == GL_ONE || inDst == GL_ONE_MINUS_SRC_ALPHA );
+    }
+
+
+
+// alpha test state, read from GL if unknown
+static char isAlphaTestOn() {
+    if( glState.alphaTestOn == -1 ) {
+        glState.alphaTestOn = glIsEnabled( GL_ALPHA_TEST ) ? 1 : 0;
+        }
+    return glState.alphaTestOn;
+    }
+
+
+
+static void setBlendFunc( GLenum inSrc, GLenum inDst ) {
+    checkGLStateContext();
+    
+    char batchUnaffected = 
+        SpriteGL::isShadingBatch() &&
+        ! isAlphaTestOn() &&
+        isNormalOrAdditiveBlend( glState.blendSrc, glState.blendDst ) &&
+        isNormalOrAdditiveBlend( inSrc, inDst );
+
+    if( skipStateCall( glState.blendSrc == (int)inSrc && 
+                       glState.blendDst == (int)inDst,
+                       batchUnaffected ) ) {
+        return;
+        }
+    
+    glBlendFunc( inSrc, inDst );
+    glState.blendSrc = inSrc;
+    glState.blendDst = inDst;
+
+    SpriteGL::setBatchBlend( glState.blendSrc, glState.blendDst,
+                             glState.alphaTestOn != 0 );
+    }
+
+
+
+// shaded batches take texture coloring from each sprite, so only 
+// fixed-function batches are flushed
+static void setTexEnvMode( GLenum inMode ) {
+    checkGLStateContext();
+    
+    if( skipStateCall( glState.texEnvMode == (int)inMode,
+                       SpriteGL::isShadingBatch() ) ) {
+        return;
+        }
+    
+    glTexEnvf( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, inMode );
+    glState.texEnvMode = inMode;
+    }
+
+
+
+static void setCapability( GLenum inCap, int *inCachedOn, char inOn ) {
+    checkGLStateContext();
+    
+    if( skipStateCall( *inCachedOn == inOn ) ) {
+        return;
+        }
+    
+    if( inOn ) {
+        glEnable( inCap );
+        }
+    else {
+        glDisable( inCap );
+        }
+    *inCachedOn = inOn;
+
+    if( inCap == GL_ALPHA_TEST ) {
+        SpriteGL::setBatchBlend( glState.blendSrc, glState.blendDst,
+                                 glState.alphaTestOn != 0 );
+        }
+    }
+
+
+
+static void setColorMask( char inOn ) {
+    checkGLStateContext();
+    
+    if( skipStateCall( glState.colorMaskOn == inOn ) ) {
+        return;
+        }
+    
+    if( inOn ) {
+        glColorMask( GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE );
+        }
+    else {
+        glColorMask( GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE );
+        }
+    glState.colorMaskOn = inOn;
+    }
+
+
+
+// always GL_GREATER
+static void setAlphaFunc( float inRef ) {
+    checkGLStateContext();
+    
+    if( skipStateCall( glState.alphaRef == inRef ) ) {
+        return;
+        }
+    
+    glAlphaFunc( GL_GREATER, inRef );
+    glState.alphaRef = inRef;
+    }
+
+
+
+// mask always all 1s
+static void setStencilFunc( GLenum inFunc, int inRef ) {
+    checkGLStateContext();
+    
+    if( skipStateCall( glState.stencilFunc == (int)inFunc &&
+                       glState.stencilRef == inRef ) ) {
+        return;
+        }
+    
+    glStencilFunc( inFunc, inRef, 0xffffffff );
+    glState.stencilFunc = inFunc;
+    glState.stencilRef = inRef;
+    }
+
+
+
+// same op for all three cases
+static void setStencilOp( GLenum inOp ) {
+    checkGLStateContext();
+    
+    if( skipStateCall( glState.stencilOp == (int)inOp ) ) {
+        return;
+        }
+    
+    glStencilOp( inOp, inOp, inOp );
+    glState.stencilOp = inOp;
+    }
+
+
+
+// current color doesn't affect batched sprites, so no flush
+static void setColor( float inR, float inG, float inB, float inA ) {
+    checkGLStateContext();
+    
+    if( glState.colorKnown &&
+        glState.color[0] == inR &&
+        glState.color[1] == inG &&
+        glState.color[2] == inB &&
+        glState.color[3] == inA ) {
+        numGLStateCallsSkipped ++;
+        return;
+        }
+    
+    numGLStateCallsIssued ++;
+    glColor4f( inR, inG, inB, inA );
+    
+    glState.colorKnown = true;
+    glState.color[0] = inR;
+    glState.color[1] = inG;
+    glState.color[2] = inB;
+    glState.color[3] = inA;
+    }
+
+
+
+// drawing with a color array leaves the current color undefined
+static void colorArrayUsed() {
+    glState.colorKnown = false;
+    }
+
+
+
+double getTotalGLStateCallsIssued() {
+    return numGLStateCallsIssued + SingleTextureGL::getNumStateCallsIssued();
+    }
+
+
+
+double getTotalGLStateCallsSkipped() {
+    return numGLStateCallsSkipped + 
+        SingleTextureGL::getNumStateCallsSkipped();
+    }
+
+
 static char additiveTextureColorMode = false;
 
 
@@ -101,7 +407,8 @@ void setDrawColor( float inR, float inG, float inB, float inA ) {
         inA *= globalFadeTotal;
         }
         
-    glColor4f( inR, inG, inB, inA );
+    setColor( inR, inG, inB, inA );
+    SpriteGL::setBatchColor( inR, inG, inB, inA );
     }
 
 
@@ -126,7 +433,8 @@ FloatColor getDrawColor() {
 void setDrawFade( float inA ) {    
     lastA = inA;
     
-    glColor4f( lastR, lastG, lastB, inA * globalFadeTotal );
+    setColor( lastR, lastG, lastB, inA * globalFadeTotal );
+    SpriteGL::setBatchColor( lastR, lastG, lastB, inA * globalFadeTotal );
     }
 
 
@@ -156,14 +464,14 @@ FloatColor getFloatColor( const char *inHexString ) {
 
 
 static void setNormalBlend() {
-    glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+    setBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
     }
 
 
 
 void toggleAdditiveBlend( char inAdditive ) {
     if( inAdditive ) {
-        glBlendFunc( GL_SRC_ALPHA, GL_ONE );
+        setBlendFunc( GL_SRC_ALPHA, GL_ONE );
         }
     else {
         setNormalBlend();
@@ -174,7 +482,7 @@ void toggleAdditiveBlend( char inAdditive ) {
 
 void toggleMultiplicativeBlend( char inMultiplicative ) {
     if( inMultiplicative ) {
-        glBlendFunc( GL_DST_COLOR, GL_ZERO );
+        setBlendFunc( GL_DST_COLOR, GL_ZERO );
         }
     else {
         setNormalBlend();
@@ -184,7 +492,7 @@ void toggleMultiplicativeBlend( char inMultiplicative ) {
 
 void toggleInvertedBlend( char inInverted ) {
     if( inInverted ) {
-        glBlendFunc( GL_ONE_MINUS_DST_COLOR, GL_ZERO );
+        setBlendFunc( GL_ONE_MINUS_DST_COLOR, GL_ZERO );
         }
     else {
         setNormalBlend();
@@ -195,10 +503,12 @@ void toggleInvertedBlend( char inInverted ) {
 
 void toggleAdditiveTextureColoring( char inAdditive ) {
     if( inAdditive ) {
-        glTexEnvf( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_ADD );
+        setTexEnvMode( GL_ADD );
+        SpriteGL::setBatchColoring( SPRITE_COLORING_ADD );
         }
     else {
-        glTexEnvf( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE );
+        setTexEnvMode( GL_MODULATE );
+        SpriteGL::setBatchColoring( SPRITE_COLORING_MODULATE );
         }
     
     additiveTextureColorMode = inAdditive;
@@ -206,6 +516,63 @@ void toggleAdditiveTextureColoring( char inAdditive ) {
 
 
 
+void toggleDistanceFieldTextures( char inOn, int inSharpness ) {
+    checkGLStateContext();
+    
+    char shading = SpriteGL::isShadingBatch();
+    
+    if( ! inOn || inSharpness <= 1 ) {
+        SpriteGL::setBatchFieldSharpness( 1 );
+        
+        // scale only matters in GL_COMBINE mode, but drawSpriteAlphaOnly
+        // uses that mode too
+        if( glState.texEnvAlphaScale != 1 ) {
+            if( ! shading ) {
+                SpriteGL::flushBatch();
+                }
+            glTexEnvf( GL_TEXTURE_ENV, GL_ALPHA_SCALE, 1 );
+            glState.texEnvAlphaScale = 1;
+            }
+
+        // unsharpened distance field is drawn like coverage
+        toggleAdditiveTextureColoring( additiveTextureColorMode );
+        return;
+        }
+    
+    SpriteGL::setBatchFieldSharpness( inSharpness );
+    
+    if( skipStateCall( glState.texEnvMode == GL_COMBINE &&
+                       glState.texEnvAlphaScale == inSharpness,
+                       shading ) ) {
+        return;
+        }
+    
+    // color modulated as usual
+    glTexEnvi( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_COMBINE );
+    glTexEnvi( GL_TEXTURE_ENV, GL_COMBINE_RGB, GL_MODULATE );
+    glTexEnvi( GL_TEXTURE_ENV, GL_SOURCE0_RGB, GL_TEXTURE );
+    glTexEnvi( GL_TEXTURE_ENV, GL_OPERAND0_RGB, GL_SRC_COLOR );
+    glTexEnvi( GL_TEXTURE_ENV, GL_SOURCE1_RGB, GL_PRIMARY_COLOR );
+    glTexEnvi( GL_TEXTURE_ENV, GL_OPERAND1_RGB, GL_SRC_COLOR );
+    
+    // alpha is ( field - c ) * s, which is 0.5 on the edge when
+    // c = 0.5 - 0.5 / s
+    GLfloat constant[4] = { 0, 0, 0, 0.5f - 0.5f / inSharpness };
+    glTexEnvfv( GL_TEXTURE_ENV, GL_TEXTURE_ENV_COLOR, constant );
+    
+    glTexEnvi( GL_TEXTURE_ENV, GL_COMBINE_ALPHA, GL_SUBTRACT );
+    glTexEnvi( GL_TEXTURE_ENV, GL_SOURCE0_ALPHA, GL_TEXTURE );
+    glTexEnvi( GL_TEXTURE_ENV, GL_OPERAND0_ALPHA, GL_SRC_ALPHA );
+    glTexEnvi( GL_TEXTURE_ENV, GL_SOURCE1_ALPHA, GL_CONSTANT );
+    glTexEnvi( GL_TEXTURE_ENV, GL_OPERAND1_ALPHA, GL_SRC_ALPHA );
+    glTexEnvf( GL_TEXTURE_ENV, GL_ALPHA_SCALE, inSharpness );
+    
+    glState.texEnvMode = GL_COMBINE;
+    glState.texEnvAlphaScale = inSharpness;
+    }
+
+
+
 
 static char linearTextureFilterOn = false;
 
@@ -227,6 +594,60 @@ void toggleMipMapGeneration( char inGenerateMipMaps ) {
 
 
 
+void toggleSpriteAtlas( char inUseAtlas ) {
+    SpriteGL::toggleAtlas( inUseAtlas );
+    }
+
+
+
+void toggleSpriteTextureSharing( char inShare ) {
+    SpriteGL::toggleTextureSharing( inShare );
+    }
+
+
+
+void getSpriteTextureSharingStats( int *outNumChecked, int *outNumShared,
+                                   int *outSharedBytes ) {
+    *outNumChecked = SpriteGL::getNumSharingChecks();
+    *outNumShared = SpriteGL::getNumSharingHits();
+    *outSharedBytes = SpriteGL::getNumSharedTextureBytes();
+    }
+
+
+
+void setSpriteTextureBudget( int inMaxBytes, int inMaxReloadsPerFrame ) {
+    SingleTextureGL::setResidencyBudget( inMaxBytes, inMaxReloadsPerFrame );
+    }
+
+
+
+int getResidentSpriteTextureBytes() {
+    return SingleTextureGL::getResidentEvictableBytes();
+    }
+
+
+
+int getNumSpriteTextureEvictions() {
+    return SingleTextureGL::getNumEvictions();
+    }
+
+
+
+int getNumSpriteTextureReloads() {
+    return SingleTextureGL::getNumReloads();
+    }
+
+
+
+void stepSpriteTextureResidency() {
+    // queued quads may use textures that are about to be evicted
+    SpriteGL::flushBatch();
+    
+    SingleTextureGL::endFrame();
+    }
+
+
+
 static char mipMapTextureFilterOn = false;
 
 void toggleMipMapMinFilter( char inMipMapFilterOn ) {
@@ -245,8 +666,15 @@ void toggleTransparentCropping( char inCrop ) {
 // GL ES versions of these functions
 
 
-static double *quadVertsToTriangles( int inNumQuads, double inVertices[] ) {
-    double *triangleVertices = new double[ 2 * inNumQuads * 6 ];
+// temporary vertex arrays below come from the frame arena, since GL is
+// done with them once glDrawArrays returns
+
+// result NOT destroyed by caller
+template <class T>
+static T *quadVertsToTriangles( int inNumQuads, T inVertices[] ) {
+    T *triangleVertices = 
+        FrameArena::getThreadArena()->allocateArray<T>( 
+            2 * inNumQuads * 6 );
     
     for( int i=0; i<inNumQuads; i++ ) {
         
@@ -279,13 +707,39 @@ static double *quadVertsToTriangles( int inNumQuads, double inVertices[] ) {
     }
 
 
+// four r,g,b,a values per vertex
+// result NOT destroyed by caller
+static float *quadColorsToTriangles( int inNumQuads, 
+                                     float inVertexColors[] ) {
+    float *triangleVertexColors = 
+        FrameArena::getThreadArena()->allocateArray<float>( 
+            4 * inNumQuads * 6 );
+    
+    for( int i=0; i<inNumQuads; i++ ) {
+        
+        float *quadColors = &( inVertexColors[ 16 * i ] );
+        
+        float *triangleColors = &( triangleVertexColors[ 24 * i ] );
+        
+        // first 0, 1, 2
+        memcpy( triangleColors, quadColors, 12 * sizeof( float ) );
+        
+        // then 0, 2, 3
+        memcpy( &( triangleColors[12] ), quadColors, 4 * sizeof( float ) );
+        memcpy( &( triangleColors[16] ), &( quadColors[8] ), 
+                8 * sizeof( float ) );
+        }
+    
+    return triangleVertexColors;
+    }
+
+
 void drawQuads( int inNumQuads, double inVertices[] ) {
     SpriteGL::setTexturingDisabled();
     
     double *triangleVertices = quadVertsToTriangles( inNumQuads, inVertices );
         
     drawTriangles( inNumQuads * 2, triangleVertices );
-    delete [] triangleVertices;
     }
 
 
@@ -297,45 +751,11 @@ void drawQuads( int inNumQuads, double inVertices[],
 
     double *triangleVertices = quadVertsToTriangles( inNumQuads, inVertices );
     
-    float *triangleVertexColors = new float[ 3 * inNumQuads * 6 ];
-    
-    for( int i=0; i<inNumQuads; i++ ) {
-        
-        int skipQC = 12 * i;
-        
-        int skipTC = 18 * i;
-        
-        // first 0, 1, 2
-        triangleVertexColors[ skipTC++ ] = inVertexColors[skipQC];
-        triangleVertexColors[ skipTC++ ] = inVertexColors[skipQC + 1];
-        triangleVertexColors[ skipTC++ ] = inVertexColors[skipQC + 2];
-
-        triangleVertexColors[ skipTC++ ] = inVertexColors[skipQC + 3];
-        triangleVertexColors[ skipTC++ ] = inVertexColors[skipQC + 4];
-        triangleVertexColors[ skipTC++ ] = inVertexColors[skipQC + 5];
-
-        triangleVertexColors[ skipTC++ ] = inVertexColors[skipQC + 6];
-        triangleVertexColors[ skipTC++ ] = inVertexColors[skipQC + 7];
-        triangleVertexColors[ skipTC++ ] = inVertexColors[skipQC + 8];
-
-        // then 0, 2, 3
-        triangleVertexColors[ skipTC++ ] = inVertexColors[skipQC];
-        triangleVertexColors[ skipTC++ ] = inVertexColors[skipQC + 1];
-        triangleVertexColors[ skipTC++ ] = inVertexColors[skipQC + 2];
-
-        triangleVertexColors[ skipTC++ ] = inVertexColors[skipQC + 6];
-        triangleVertexColors[ skipTC++ ] = inVertexColors[skipQC + 7];
-        triangleVertexColors[ skipTC++ ] = inVertexColors[skipQC + 8];
-
-        triangleVertexColors[ skipTC++ ] = inVertexColors[skipQC + 9];
-        triangleVertexColors[ skipTC++ ] = inVertexColors[skipQC + 10];
-        triangleVertexColors[ skipTC++ ] = inVertexColors[skipQC + 11];
-        }
+    float *triangleVertexColors = 
+        quadColorsToTriangles( inNumQuads, inVertexColors );
     
     drawTrianglesColor( inNumQuads * 2, triangleVertices, 
                         triangleVertexColors );
-    delete [] triangleVertices;
-    delete [] triangleVertexColors;
     }
 
 
@@ -360,7 +780,8 @@ void drawTriangles( int inNumTriangles, double inVertices[],
     
     int numCoords = numVerts * 2;
     
-    float *verts = new float[numCoords];
+    float *verts = 
+        FrameArena::getThreadArena()->allocateArray<float>( numCoords );
     for( int i=0; i<numCoords; i++ ) {
         verts[i] = (float)( inVertices[i] );
         }
@@ -379,8 +800,6 @@ void drawTriangles( int inNumTriangles, double inVertices[],
     
     
     glDisableClientState( GL_VERTEX_ARRAY );
-
-    delete [] verts;
     }
 
 
@@ -405,7 +824,8 @@ void drawTrianglesColor( int inNumTriangles, double inVertices[],
     
     int numCoords = numVerts * 2;
     
-    float *verts = new float[numCoords];
+    float *verts = 
+        FrameArena::getThreadArena()->allocateArray<float>( numCoords );
     for( int i=0; i<numCoords; i++ ) {
         verts[i] = (float)( inVertices[i] );
         }
@@ -430,8 +850,7 @@ void drawTrianglesColor( int inNumTriangles, double inVertices[],
 
     glDisableClientState( GL_VERTEX_ARRAY );
     glDisableClientState( GL_COLOR_ARRAY );
-
-    delete [] verts;
+    colorArrayUsed();
     }
 
 
@@ -469,6 +888,7 @@ void drawQuads( int inNumQuads, double inVertices[],
 
     glDisableClientState( GL_VERTEX_ARRAY );
     glDisableClientState( GL_COLOR_ARRAY );
+    colorArrayUsed();
     }
 
 
@@ -522,79 +942,298 @@ void drawTrianglesColor( int inNumTriangles, double inVertices[],
 
     glDisableClientState( GL_VERTEX_ARRAY );
     glDisableClientState( GL_COLOR_ARRAY );
+    colorArrayUsed();
     }
 
 #endif
 
 
-void enableScissor( double inX, double inY, double inWidth, double inHeight ) {
-    
-    double endX = inX + inWidth;
-    double endY = inY + inHeight;
-    
-    // scissor rectangle specified in integer screen coordinates
-
-    GLint viewport[4];
-    GLdouble modelview[16];
-    GLdouble projection[16];
- 
-    glGetDoublev( GL_MODELVIEW_MATRIX, modelview );
-    glGetDoublev( GL_PROJECTION_MATRIX, projection );
-    glGetIntegerv( GL_VIEWPORT, viewport );
-
-    GLdouble winStartX, winStartY, winStartZ;
-    GLdouble winEndX, winEndY, winEndZ;
-
-    gluProject( inX, inY, 0, 
-                modelview, projection, viewport, 
-                &winStartX, &winStartY, &winStartZ );
 
-    gluProject( endX, endY, 0, 
-                modelview, projection, viewport, 
-                &winEndX, &winEndY, &winEndZ );
+// float versions, common to GL and GL ES
 
 
-    glScissor( lrint( winStartX ), lrint( winStartY ), 
-               lrint( winEndX - winStartX ), lrint( winEndY - winStartY ) );
-    glEnable( GL_SCISSOR_TEST );
+static GLenum getTriangleMode( char inStrip, char inFan ) {
+    if( inStrip ) {
+        return GL_TRIANGLE_STRIP;
+        }
+    else if( inFan ) {
+        return GL_TRIANGLE_FAN;
+        }
+    return GL_TRIANGLES;
     }
 
 
 
-void disableScissor() {
-    glDisable( GL_SCISSOR_TEST );
+static int getTriangleVertexCount( int inNumTriangles, 
+                                   char inStrip, char inFan ) {
+    if( inStrip || inFan ) {
+        return inNumTriangles + 2;
+        }
+    return inNumTriangles * 3;
     }
 
 
 
-void startAddingToStencil( char inDrawColorToo, char inAdd,
-                           float inMinAlpha ) {
-    if( !inDrawColorToo ) {
-        
-        // stop updating color
-        glColorMask( GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE );
-
-        // skip fully-transparent areas
-        glEnable( GL_ALPHA_TEST );
-        glAlphaFunc( GL_GREATER, inMinAlpha );
-        }
-    else {
-        // Re-enable update of color (in case stencil drawing was already
-        //  started)
-        glColorMask( GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE );
-        glDisable( GL_ALPHA_TEST );
-        }
+// inVertexColors can be NULL
+static void drawFloatArrays( GLenum inMode, int inNumVertices,
+                             float inVertices[], float inVertexColors[] ) {
+    SpriteGL::setTexturingDisabled();
     
-    glEnable( GL_STENCIL_TEST );
-    glStencilOp( GL_REPLACE, GL_REPLACE, GL_REPLACE );
-
-    if( inAdd ) {
-        // Draw 1 into the stencil buffer wherever a sprite is
-        glStencilFunc( GL_ALWAYS, 1, 0xffffffff );
-        }
-    else {
-        // draw 0
-        glStencilFunc( GL_ALWAYS, 0, 0xffffffff );
+    VertexBufferGL::streamArrays( inNumVertices, inVertices, 
+                                  inVertexColors );
+    
+    glDrawArrays( inMode, 0, inNumVertices );
+    
+    VertexBufferGL::clearArrays();
+    
+    if( inVertexColors != NULL ) {
+        colorArrayUsed();
+        }
+    }
+
+
+
+void drawQuads( int inNumQuads, float inVertices[] ) {
+    #ifdef GLES
+        drawFloatArrays( GL_TRIANGLES, inNumQuads * 6,
+                         quadVertsToTriangles( inNumQuads, inVertices ),
+                         NULL );
+    #else
+        drawFloatArrays( GL_QUADS, inNumQuads * 4, inVertices, NULL );
+    #endif
+    }
+
+
+
+void drawQuads( int inNumQuads, float inVertices[], 
+                float inVertexColors[] ) {
+    #ifdef GLES
+        drawFloatArrays( GL_TRIANGLES, inNumQuads * 6,
+                         quadVertsToTriangles( inNumQuads, inVertices ),
+                         quadColorsToTriangles( inNumQuads, 
+                                                inVertexColors ) );
+    #else
+        drawFloatArrays( GL_QUADS, inNumQuads * 4, 
+                         inVertices, inVertexColors );
+    #endif
+    }
+
+
+
+void drawTriangles( int inNumTriangles, float inVertices[], 
+                    char inStrip, char inFan ) {
+    drawFloatArrays( getTriangleMode( inStrip, inFan ),
+                     getTriangleVertexCount( inNumTriangles, 
+                                             inStrip, inFan ),
+                     inVertices, NULL );
+    }
+
+
+
+void drawTrianglesColor( int inNumTriangles, float inVertices[], 
+                         float inVertexColors[], char inStrip, char inFan ) {
+    drawFloatArrays( getTriangleMode( inStrip, inFan ),
+                     getTriangleVertexCount( inNumTriangles, 
+                                             inStrip, inFan ),
+                     inVertices, inVertexColors );
+    }
+
+
+
+void toggleVertexStreaming( char inStream ) {
+    VertexBufferGL::toggleStreaming( inStream );
+    }
+
+
+
+typedef struct Geometry {
+        VertexBufferGL *buffer;
+        GLenum mode;
+        // -1 unless quads converted to triangles for GL ES
+        int numQuads;
+    } Geometry;
+
+
+
+// inNumQuads -1 if not quads
+static GeometryHandle makeGeometry( GLenum inMode, int inNumVertices,
+                                    float inVertices[], 
+                                    float inVertexColors[],
+                                    int inNumQuads ) {
+    Geometry *g = new Geometry;
+    
+    g->mode = inMode;
+    g->numQuads = -1;
+    
+    #ifdef GLES
+    if( inNumQuads != -1 ) {
+        g->mode = GL_TRIANGLES;
+        g->numQuads = inNumQuads;
+        inNumVertices = inNumQuads * 6;
+        
+        inVertices = quadVertsToTriangles( inNumQuads, inVertices );
+        if( inVertexColors != NULL ) {
+            inVertexColors = 
+                quadColorsToTriangles( inNumQuads, inVertexColors );
+            }
+        }
+    #endif
+    
+    g->buffer = new VertexBufferGL( inNumVertices, inVertices, 
+                                    inVertexColors );
+    return g;
+    }
+
+
+
+GeometryHandle makeQuadGeometry( int inNumQuads, float inVertices[],
+                                 float inVertexColors[] ) {
+    #ifdef GLES
+        GLenum mode = GL_TRIANGLES;
+    #else
+        GLenum mode = GL_QUADS;
+    #endif
+
+    return makeGeometry( mode, inNumQuads * 4, inVertices, inVertexColors,
+                         inNumQuads );
+    }
+
+
+
+GeometryHandle makeTriangleGeometry( int inNumTriangles, float inVertices[],
+                                     float inVertexColors[],
+                                     char inStrip, char inFan ) {
+    return makeGeometry( getTriangleMode( inStrip, inFan ),
+                         getTriangleVertexCount( inNumTriangles, 
+                                                 inStrip, inFan ),
+                         inVertices, inVertexColors, -1 );
+    }
+
+
+
+void replaceGeometry( GeometryHandle inGeometry, float inVertices[],
+                      float inVertexColors[] ) {
+    Geometry *g = (Geometry *)inGeometry;
+    
+    #ifdef GLES
+    if( g->numQuads != -1 ) {
+        inVertices = quadVertsToTriangles( g->numQuads, inVertices );
+        if( inVertexColors != NULL ) {
+            inVertexColors = 
+                quadColorsToTriangles( g->numQuads, inVertexColors );
+            }
+        }
+    #endif
+
+    g->buffer->replaceData( inVertices, inVertexColors );
+    }
+
+
+
+void drawGeometry( GeometryHandle inGeometry ) {
+    Geometry *g = (Geometry *)inGeometry;
+    
+    SpriteGL::setTexturingDisabled();
+    
+    g->buffer->setArrays();
+    
+    glDrawArrays( g->mode, 0, g->buffer->getNumVertices() );
+    
+    VertexBufferGL::clearArrays();
+    
+    if( g->buffer->hasColors() ) {
+        colorArrayUsed();
+        }
+    }
+
+
+
+void freeGeometry( GeometryHandle inGeometry ) {
+    Geometry *g = (Geometry *)inGeometry;
+    
+    delete g->buffer;
+    delete g;
+    }
+
+
+
+void enableScissor( double inX, double inY, double inWidth, double inHeight ) {
+    double endX = inX + inWidth;
+    double endY = inY + inHeight;
+    
+    // scissor rectangle specified in integer screen coordinates
+
+    GLint viewport[4];
+    GLdouble modelview[16];
+    GLdouble projection[16];
+ 
+    glGetDoublev( GL_MODELVIEW_MATRIX, modelview );
+    glGetDoublev( GL_PROJECTION_MATRIX, projection );
+    glGetIntegerv( GL_VIEWPORT, viewport );
+
+    GLdouble winStartX, winStartY, winStartZ;
+    GLdouble winEndX, winEndY, winEndZ;
+
+    gluProject( inX, inY, 0, 
+                modelview, projection, viewport, 
+                &winStartX, &winStartY, &winStartZ );
+
+    gluProject( endX, endY, 0, 
+                modelview, projection, viewport, 
+                &winEndX, &winEndY, &winEndZ );
+
+
+    GLint box[4] = { (GLint)lrint( winStartX ), (GLint)lrint( winStartY ), 
+                     (GLint)lrint( winEndX - winStartX ), 
+                     (GLint)lrint( winEndY - winStartY ) };
+    
+    checkGLStateContext();
+    
+    if( ! skipStateCall( memcmp( box, glState.scissorBox, 
+                                 sizeof( box ) ) == 0 ) ) {
+        glScissor( box[0], box[1], box[2], box[3] );
+        memcpy( glState.scissorBox, box, sizeof( box ) );
+        }
+    
+    setCapability( GL_SCISSOR_TEST, &( glState.scissorOn ), true );
+    }
+
+
+
+void disableScissor() {
+    setCapability( GL_SCISSOR_TEST, &( glState.scissorOn ), false );
+    }
+
+
+
+void startAddingToStencil( char inDrawColorToo, char inAdd,
+                           float inMinAlpha ) {
+    if( !inDrawColorToo ) {
+        
+        // stop updating color
+        setColorMask( false );
+
+        // skip fully-transparent areas
+        setCapability( GL_ALPHA_TEST, &( glState.alphaTestOn ), true );
+        setAlphaFunc( inMinAlpha );
+        }
+    else {
+        // Re-enable update of color (in case stencil drawing was already
+        //  started)
+        setColorMask( true );
+        setCapability( GL_ALPHA_TEST, &( glState.alphaTestOn ), false );
+        }
+    
+    setCapability( GL_STENCIL_TEST, &( glState.stencilOn ), true );
+    setStencilOp( GL_REPLACE );
+
+    if( inAdd ) {
+        // Draw 1 into the stencil buffer wherever a sprite is
+        setStencilFunc( GL_ALWAYS, 1 );
+        }
+    else {
+        // draw 0
+        setStencilFunc( GL_ALWAYS, 0 );
         }
     }
 
@@ -602,20 +1241,20 @@ void startAddingToStencil( char inDrawColorToo, char inAdd,
 
 void startDrawingThroughStencil( char inInvertStencil ) {
     // Re-enable update of color
-    glColorMask( GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE );
-    glDisable( GL_ALPHA_TEST );
+    setColorMask( true );
+    setCapability( GL_ALPHA_TEST, &( glState.alphaTestOn ), false );
     
     // Now, only render where stencil is set to 1.
     // unless inverted
 
     if( inInvertStencil ) {
-        glStencilFunc( GL_EQUAL, 0, 0xffffffff );  // draw if == 0
+        setStencilFunc( GL_EQUAL, 0 );  // draw if == 0
         }
     else {        
-        glStencilFunc( GL_EQUAL, 1, 0xffffffff );  // draw if == 1
+        setStencilFunc( GL_EQUAL, 1 );  // draw if == 1
         }
     
-    glStencilOp( GL_KEEP, GL_KEEP, GL_KEEP );
+    setStencilOp( GL_KEEP );
     }
 
 
@@ -623,6 +1262,10 @@ void startDrawingThroughStencil( char inInvertStencil ) {
 void stopStencil() {
     disableStencil();
     
+    // sprites queued before stencil was started still need to be drawn
+    // before it is cleared, even if disableStencil had nothing to change
+    SpriteGL::flushBatch();
+    
     glClear( GL_STENCIL_BUFFER_BIT );
     }
 
@@ -630,11 +1273,11 @@ void stopStencil() {
 
 void disableStencil() {
     // Re-enable update of color (just in case stencil drawing was not started)
-    glColorMask( GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE );
-    glDisable( GL_ALPHA_TEST );
+    setColorMask( true );
+    setCapability( GL_ALPHA_TEST, &( glState.alphaTestOn ), false );
 
     // back to unstenciled drawing
-    glDisable( GL_STENCIL_TEST );
+    setCapability( GL_STENCIL_TEST, &( glState.stencilOn ), false );
     }
 
 
@@ -651,9 +1294,23 @@ SpriteHandle fillSprite( Image *inImage,
 
 SpriteHandle fillSprite( unsigned char *inRGBA, 
                          unsigned int inWidth, unsigned int inHeight ) {
-    totalLoadedTextureBytes += inWidth * inHeight * 4;
-    return new SpriteGL( inRGBA, inWidth, inHeight, 1, 1,
-                         transparentCroppingOn );
+    SpriteGL *sprite = new SpriteGL( inRGBA, inWidth, inHeight, 1, 1,
+                                     transparentCroppingOn );
+    
+    if( ! sprite->isTextureShared() ) {
+        totalLoadedTextureBytes += inWidth * inHeight * 4;
+        }
+    return sprite;
+    }
+
+
+
+SpriteHandle fillSprite( CompressedTexture *inTexture ) {
+    SpriteGL *sprite = new SpriteGL( inTexture, 1, 1, transparentCroppingOn );
+    
+    totalLoadedTextureBytes += sprite->getNumTextureBytes();
+    
+    return sprite;
     }
 
 
@@ -670,14 +1327,462 @@ SpriteHandle fillSpriteAlphaOnly( unsigned char *inA,
 
 
 
+static void forgetAsyncSprite( SpriteGL *inSprite );
+
+
 void freeSprite( SpriteHandle inSprite ) {
     SpriteGL *s = (SpriteGL *)inSprite;
-    totalLoadedTextureBytes -= s->mWidth * s->mHeight * 4;
+    if( ! s->isFilled() ) {
+        forgetAsyncSprite( s );
+        }
+    if( ! s->isTextureShared() ) {
+        // last sprite using texture
+        totalLoadedTextureBytes -= s->getNumTextureBytes();
+        }
     delete ( s );
     }
 
 
 
+char isSpriteReady( SpriteHandle inSprite ) {
+    SpriteGL *s = (SpriteGL *)inSprite;
+    return s->isFilled();
+    }
+
+
+
+
+// async sprite loading
+
+#define ASYNC_SPRITE_READING 0
+#define ASYNC_SPRITE_DECODING 1
+#define ASYNC_SPRITE_DECODED 2
+
+
+typedef struct AsyncSpriteJob {
+        // NULL if sprite freed before it was ready 
+        // main thread only
+        SpriteGL *sprite;
+        
+        char *fileName;
+        int fileReadHandle;
+        char transparentLowerLeftCorner;
+        
+        // cropping setting when load started
+        char setColoredRadii;
+        
+        // handed to decoder thread, and destroyed by it
+        unsigned char *fileData;
+        int fileLength;
+        
+        // decoder result, NULL on failure
+        unsigned char *rgba;
+        int width;
+        int height;
+        
+        // found by decoder if setColoredRadii, so main thread doesn't
+        // have to scan the pixels again while uploading
+        ColoredBox coloredBox;
+        
+        // mipmap setting when load started
+        char mipMap;
+        
+        // built by decoder if mipMap, so driver doesn't build them on
+        // main thread during upload
+        MipChain *mipLevels;
+        
+        // changed only while holding asyncSpriteLock
+        int state;
+    } AsyncSpriteJob;
+
+
+// all jobs, main thread only
+static SimpleVector<AsyncSpriteJob*> asyncSpriteJobs;
+
+static MutexLock asyncSpriteLock( "asyncSpriteLock" );
+
+// waiting for a decoder, protected by asyncSpriteLock
+static SimpleVector<AsyncSpriteJob*> spriteDecodeQueue;
+static char stopSpriteDecoders = false;
+
+static BinarySemaphore spriteDecodeSem;
+
+static double spriteUploadBudgetSeconds = 0.004;
+
+
+
+// uses lower-left corner color as transparent color, unless the image
+// already has non-opaque alpha
+// same as SpriteGL's handling of Images
+static void applyTransparentCorner( unsigned char *inRGBA, 
+                                    int inWidth, int inHeight ) {
+    int numPixels = inWidth * inHeight;
+    
+    for( int i=0; i<numPixels; i++ ) {
+        if( inRGBA[ i * 4 + 3 ] != 255 ) {
+            // keep existing alpha
+            return;
+            }
+        }
+    
+    unsigned char *corner = &( inRGBA[ inWidth * ( inHeight - 1 ) * 4 ] );
+    
+    unsigned char tR = corner[0];
+    unsigned char tG = corner[1];
+    unsigned char tB = corner[2];
+    
+    unsigned char *p = inRGBA;
+    for( int i=0; i<numPixels; i++ ) {
+        if( p[0] == tR && p[1] == tG && p[2] == tB ) {
+            p[3] = 0;
+            }
+        p += 4;
+        }
+    }
+
+
+
+static void decodeSpriteJob( AsyncSpriteJob *inJob ) {
+    PROFILE_ZONE( "decodeSprite" );
+
+    TGAInfo info;
+    
+    if( readTGAInfo( inJob->fileData, inJob->fileLength, &info ) ) {
+        
+        unsigned char *rgba = new unsigned char[ info.width * info.height * 4 ];
+        
+        if( decodeTGAToRGBA( inJob->fileData, inJob->fileLength, rgba ) ) {
+            
+            if( inJob->transparentLowerLeftCorner ) {
+                applyTransparentCorner( rgba, info.width, info.height );
+                }
+            
+            if( inJob->setColoredRadii ) {
+                SpriteGL::findColoredBox( rgba, info.width, info.height, 
+                                          4, 3, &( inJob->coloredBox ) );
+                }
+            
+            if( inJob->mipMap ) {
+                PROFILE_ZONE( "buildSpriteMipMaps" );
+
+                // levels come from level 0 as it will be uploaded, with
+                // edges expanded, but the upload expands rgba itself
+                int numBytes = info.width * info.height * 4;
+                
+                unsigned char *expanded = new unsigned char[ numBytes ];
+                memcpy( expanded, rgba, numBytes );
+                
+                SingleTextureGL::expandEdges( expanded, 
+                                              info.width, info.height );
+                
+                inJob->mipLevels = 
+                    new MipChain( expanded, info.width, info.height );
+                
+                delete [] expanded;
+                }
+            
+            inJob->rgba = rgba;
+            inJob->width = info.width;
+            inJob->height = info.height;
+            }
+        else {
+            delete [] rgba;
+            }
+        }
+
+    delete [] inJob->fileData;
+    inJob->fileData = NULL;
+    }
+
+
+
+class SpriteDecodeThread : public Thread {
+    public:
+
+        virtual void run() {
+            PROFILE_THREAD_NAME( "spriteDecode" );
+
+            while( true ) {
+                AsyncSpriteJob *job = NULL;
+                char stop;
+                char moreWaiting = false;
+                
+                asyncSpriteLock.lock();
+                
+                stop = stopSpriteDecoders;
+                
+                if( ! stop && spriteDecodeQueue.size() > 0 ) {
+                    job = spriteDecodeQueue.getElementDirect( 0 );
+                    spriteDecodeQueue.deleteElement( 0 );
+                    
+                    moreWaiting = ( spriteDecodeQueue.size() > 0 );
+                    }
+                asyncSpriteLock.unlock();
+
+                if( stop ) {
+                    // pass stop along to next thread
+                    spriteDecodeSem.signal();
+                    return;
+                    }
+                
+                if( job == NULL ) {
+                    spriteDecodeSem.wait();
+                    continue;
+                    }
+                
+                if( moreWaiting ) {
+                    // semaphore is binary, so signals while all threads
+                    // were busy may have been merged
+                    // wake another thread to help
+                    spriteDecodeSem.signal();
+                    }
+                
+                decodeSpriteJob( job );
+                
+                asyncSpriteLock.lock();
+                job->state = ASYNC_SPRITE_DECODED;
+                asyncSpriteLock.unlock();
+                }
+            }
+    };
+
+
+static SimpleVector<SpriteDecodeThread*> spriteDecodeThreads;
+
+
+
+static int getNumCores() {
+    int numCores;
+    
+    #ifdef WIN_32
+        SYSTEM_INFO info;
+        GetSystemInfo( &info );
+        numCores = info.dwNumberOfProcessors;
+    #else
+        numCores = (int)sysconf( _SC_NPROCESSORS_ONLN );
+    #endif
+
+    if( numCores < 1 ) {
+        numCores = 1;
+        }
+    return numCores;
+    }
+
+
+
+SpriteHandle loadSpriteAsync( const char *inTGAFileName, 
+                              char inTransparentLowerLeftCorner ) {
+    
+    if( spriteDecodeThreads.size() == 0 ) {
+        int numThreads = getNumCores();
+        
+        for( int i=0; i<numThreads; i++ ) {
+            SpriteDecodeThread *t = new SpriteDecodeThread();
+            t->start();
+            spriteDecodeThreads.push_back( t );
+            }
+        }
+    
+    
+    SpriteGL *sprite = new SpriteGL();
+    
+    char *path = autoSprintf( "graphics/%s", inTGAFileName );
+    
+    AsyncSpriteJob *job = new AsyncSpriteJob;
+    
+    job->sprite = sprite;
+    job->fileName = stringDuplicate( inTGAFileName );
+    job->fileReadHandle = startAsyncFileRead( path );
+    job->transparentLowerLeftCorner = inTransparentLowerLeftCorner;
+    job->setColoredRadii = transparentCroppingOn;
+    job->mipMap = SpriteGL::isMipMapGenerationOn();
+    job->mipLevels = NULL;
+    job->fileData = NULL;
+    job->fileLength = 0;
+    job->rgba = NULL;
+    job->width = 0;
+    job->height = 0;
+    job->state = ASYNC_SPRITE_READING;
+    
+    delete [] path;
+    
+    asyncSpriteJobs.push_back( job );
+    
+    return sprite;
+    }
+
+
+
+int getNumSpritesLoading() {
+    int num = 0;
+    
+    for( int i=0; i<asyncSpriteJobs.size(); i++ ) {
+        if( asyncSpriteJobs.getElementDirect( i )->sprite != NULL ) {
+            num++;
+            }
+        }
+    return num;
+    }
+
+
+
+void setSpriteUploadBudget( double inMilliseconds ) {
+    spriteUploadBudgetSeconds = inMilliseconds / 1000.0;
+    }
+
+
+
+static void forgetAsyncSprite( SpriteGL *inSprite ) {
+    for( int i=0; i<asyncSpriteJobs.size(); i++ ) {
+        AsyncSpriteJob *job = asyncSpriteJobs.getElementDirect( i );
+        
+        if( job->sprite == inSprite ) {
+            // job finishes on its own, and result is discarded
+            job->sprite = NULL;
+            return;
+            }
+        }
+    }
+
+
+
+static void deleteSpriteJob( AsyncSpriteJob *inJob ) {
+    delete [] inJob->fileName;
+    
+    if( inJob->fileData != NULL ) {
+        delete [] inJob->fileData;
+        }
+    if( inJob->rgba != NULL ) {
+        delete [] inJob->rgba;
+        }
+    if( inJob->mipLevels != NULL ) {
+        delete inJob->mipLevels;
+        }
+    delete inJob;
+    }
+
+
+
+void stepAsyncSpriteLoading() {
+    if( asyncSpriteJobs.size() == 0 ) {
+        return;
+        }
+
+    PROFILE_ZONE( "stepAsyncSpriteLoading" );
+    
+    double startTime = Time::getCurrentTime();
+    
+    char uploadedOne = false;
+    
+    int i = 0;
+    while( i < asyncSpriteJobs.size() ) {
+        AsyncSpriteJob *job = asyncSpriteJobs.getElementDirect( i );
+        
+        asyncSpriteLock.lock();
+        int state = job->state;
+        asyncSpriteLock.unlock();
+
+        char done = false;
+        
+        if( state == ASYNC_SPRITE_READING ) {
+            
+            if( checkAsyncFileReadDone( job->fileReadHandle ) ) {
+                job->fileData = getAsyncFileData( job->fileReadHandle,
+                                                  &( job->fileLength ) );
+                
+                if( job->fileData == NULL ) {
+                    AppLog::errorF( "Failed to read sprite file graphics/%s",
+                                    job->fileName );
+                    done = true;
+                    }
+                else if( job->sprite == NULL ) {
+                    // freed while reading, don't bother decoding
+                    done = true;
+                    }
+                else {
+                    asyncSpriteLock.lock();
+                    job->state = ASYNC_SPRITE_DECODING;
+                    spriteDecodeQueue.push_back( job );
+                    asyncSpriteLock.unlock();
+                    
+                    spriteDecodeSem.signal();
+                    }
+                }
+            }
+        else if( state == ASYNC_SPRITE_DECODED ) {
+            if( job->sprite == NULL ) {
+                done = true;
+                }
+            else if( job->rgba == NULL ) {
+                AppLog::errorF( "Failed to decode sprite file graphics/%s",
+                                job->fileName );
+                done = true;
+                }
+            else if( ! uploadedOne ||
+                     Time::getCurrentTime() - startTime < 
+                     spriteUploadBudgetSeconds ) {
+                
+                job->sprite->fill( job->rgba, job->width, job->height,
+                                   job->setColoredRadii,
+                                   &( job->coloredBox ),
+                                   job->mipLevels );
+                
+                if( ! job->sprite->isTextureShared() ) {
+                    totalLoadedTextureBytes += job->width * job->height * 4;
+                    }
+                
+                uploadedOne = true;
+                done = true;
+                }
+            }
+        
+        if( done ) {
+            deleteSpriteJob( job );
+            asyncSpriteJobs.deleteElement( i );
+            }
+        else {
+            i++;
+            }
+        }
+    }
+
+
+
+void freeAsyncSpriteLoading() {
+    asyncSpriteLock.lock();
+    stopSpriteDecoders = true;
+    asyncSpriteLock.unlock();
+    
+    spriteDecodeSem.signal();
+    
+    for( int i=0; i<spriteDecodeThreads.size(); i++ ) {
+        SpriteDecodeThread *t = spriteDecodeThreads.getElementDirect( i );
+        t->join();
+        delete t;
+        }
+    spriteDecodeThreads.deleteAll();
+    
+    spriteDecodeQueue.deleteAll();
+    
+    for( int i=0; i<asyncSpriteJobs.size(); i++ ) {
+        AsyncSpriteJob *job = asyncSpriteJobs.getElementDirect( i );
+        
+        if( job->state == ASYNC_SPRITE_READING ) {
+            // don't leave data sitting in async file list
+            int length;
+            unsigned char *data = getAsyncFileData( job->fileReadHandle,
+                                                    &length );
+            if( data != NULL ) {
+                delete [] data;
+                }
+            }
+        deleteSpriteJob( job );
+        }
+    asyncSpriteJobs.deleteAll();
+    }
+
+
+
 int getSpriteWidth( SpriteHandle inSprite ) {
     SpriteGL *sprite = (SpriteGL *)inSprite;
     return sprite->getWidth();
@@ -718,9 +1823,20 @@ double  endCountingSpritePixelsDrawn() {
 // just set this to zero whenever user asks to start counting
 static double numSpritesDrawn = 0;
 
+// sum of counts dropped by past startCountingSpritesDrawn calls
+static double numSpritesDrawnBeforeCount = 0;
+
+// skipped by sprite culling, counted the same way
+static double numSpritesCulled = 0;
+static double numSpritesCulledBeforeCount = 0;
+
 
 void startCountingSpritesDrawn() {
+    numSpritesDrawnBeforeCount += numSpritesDrawn;
     numSpritesDrawn = 0;
+    numSpritesCulledBeforeCount += numSpritesCulled;
+    numSpritesCulled = 0;
+    SpriteGL::resetBatchCounts();
     }
 
 
@@ -731,9 +1847,139 @@ double endCountingSpritesDrawn() {
 
 
 
+int getNumSpriteBatchesDrawn() {
+    return SpriteGL::getNumBatchDrawCalls();
+    }
+
+
+
+int getNumSpriteBatchFlushes() {
+    return SpriteGL::getNumBatchFlushes();
+    }
+
+
+
+double getTotalSpritesDrawn() {
+    return numSpritesDrawnBeforeCount + numSpritesDrawn;
+    }
+
+
+
+int getTotalSpriteBatchesDrawn() {
+    return SpriteGL::getTotalBatchDrawCalls();
+    }
+
+
+
+void toggleSpriteBatching( char inBatch ) {
+    SpriteGL::toggleBatching( inBatch );
+    }
+
+
+
+void flushSpriteBatch() {
+    SpriteGL::flushBatch();
+    }
+
+
+
+void toggleSpriteShading( char inShade ) {
+    SpriteGL::toggleShading( inShade );
+    }
+
+
+
+char isSpriteShadingOn() {
+    return SpriteGL::isShadingBatch();
+    }
+
+
+
 // profiler found constructor/deconstructor calls were using 1.8% of time
 static Vector3D spritePos( 0, 0, 0 );
 
+
+
+// matches platform's default view, -1 to +1
+static double visibleMinX = -1;
+static double visibleMinY = -1;
+static double visibleMaxX = 1;
+static double visibleMaxY = 1;
+
+static char spriteCullingOn = false;
+static double spriteCullingMargin = 0;
+
+// visible rect plus margin
+static double cullMinX = -1;
+static double cullMinY = -1;
+static double cullMaxX = 1;
+static double cullMaxY = 1;
+
+
+static void recomputeCullRect() {
+    cullMinX = visibleMinX - spriteCullingMargin;
+    cullMinY = visibleMinY - spriteCullingMargin;
+    cullMaxX = visibleMaxX + spriteCullingMargin;
+    cullMaxY = visibleMaxY + spriteCullingMargin;
+    }
+
+
+
+void setVisibleWorldRect( double inMinX, double inMinY,
+                          double inMaxX, double inMaxY ) {
+    visibleMinX = inMinX;
+    visibleMinY = inMinY;
+    visibleMaxX = inMaxX;
+    visibleMaxY = inMaxY;
+    
+    recomputeCullRect();
+    }
+
+
+
+void getVisibleWorldRect( double *outMinX, double *outMinY,
+                          double *outMaxX, double *outMaxY ) {
+    *outMinX = visibleMinX;
+    *outMinY = visibleMinY;
+    *outMaxX = visibleMaxX;
+    *outMaxY = visibleMaxY;
+    }
+
+
+
+void toggleSpriteCulling( char inCull, double inMargin ) {
+    spriteCullingOn = inCull;
+    spriteCullingMargin = inMargin;
+    
+    recomputeCullRect();
+    }
+
+
+
+double getNumSpritesCulled() {
+    return numSpritesCulled;
+    }
+
+
+
+double getTotalSpritesCulled() {
+    return numSpritesCulledBeforeCount + numSpritesCulled;
+    }
+
+
+
+// true if sprite at spritePos should be skipped
+static char cullSprite( SpriteGL *inSprite, double inZoom, 
+                        double inRotation ) {
+    if( spriteCullingOn &&
+        inSprite->isOutside( &spritePos, inZoom, inRotation,
+                             cullMinX, cullMinY, cullMaxX, cullMaxY ) ) {
+        numSpritesCulled++;
+        return true;
+        }
+    return false;
+    }
+
 // draw with current draw color
 void drawSprite( SpriteHandle inSprite, doublePair inCenter, 
                  double inZoom, double inRotation, char inFlipH ) {
@@ -742,6 +1988,10 @@ void drawSprite( SpriteHandle inSprite, doublePair inCenter,
     spritePos.mX = inCenter.x;
     spritePos.mY = inCenter.y;
     
+    if( cullSprite( sprite, inZoom, inRotation ) ) {
+        return;
+        }
+    
     sprite->draw( 0,
                   &spritePos,
                   inZoom,
@@ -761,12 +2011,17 @@ void drawSprite( SpriteHandle inSprite, doublePair inCenter,
     spritePos.mX = inCenter.x;
     spritePos.mY = inCenter.y;
 
+    if( cullSprite( sprite, inZoom, inRotation ) ) {
+        return;
+        }
+    
     sprite->draw( 0,
                   &spritePos,
                   inCornerColors,
                   inZoom,
                   linearTextureFilterOn, mipMapTextureFilterOn,
                   inRotation, inFlipH );
+    colorArrayUsed();
     
     numSpritesDrawn++;
     }
@@ -777,16 +2032,52 @@ void drawSprite( SpriteHandle inSprite, doublePair inCornerPos[4],
                  FloatColor inCornerColors[4] ) {
     SpriteGL *sprite = (SpriteGL *)inSprite;
     
+    if( spriteCullingOn ) {
+        char allLeft = true;
+        char allRight = true;
+        char allBelow = true;
+        char allAbove = true;
+        
+        for( int i=0; i<4; i++ ) {
+            allLeft = allLeft && ( inCornerPos[i].x < cullMinX );
+            allRight = allRight && ( inCornerPos[i].x > cullMaxX );
+            allBelow = allBelow && ( inCornerPos[i].y < cullMinY );
+            allAbove = allAbove && ( inCornerPos[i].y > cullMaxY );
+            }
+        
+        if( allLeft || allRight || allBelow || allAbove ) {
+            numSpritesCulled++;
+            return;
+            }
+        }
+    
     sprite->draw( 0,
                   inCornerPos,
                   inCornerColors,
                   linearTextureFilterOn, mipMapTextureFilterOn );
+    colorArrayUsed();
     
     numSpritesDrawn++;
     }
 
 
 
+void drawSpriteInstances( SpriteHandle inSprite, int inNumInstances,
+                          const doublePair *inCenters,
+                          const float *inScales,
+                          const float *inRotations,
+                          const FloatColor *inColors ) {
+    SpriteGL *sprite = (SpriteGL *)inSprite;
+    
+    sprite->drawInstances( 0, inNumInstances,
+                           inCenters, inScales, inRotations, inColors,
+                           linearTextureFilterOn, mipMapTextureFilterOn );
+    
+    numSpritesDrawn += inNumInstances;
+    }
+
+
+
 void drawSpriteAlphaOnly( SpriteHandle inSprite, doublePair inCenter, 
                           double inZoom, double inRotation, char inFlipH ) {
 
@@ -796,6 +2087,20 @@ void drawSpriteAlphaOnly( SpriteHandle inSprite, doublePair inCenter,
     // http://stackoverflow.com/questions/2485370/
     //      use-only-alpha-channel-of-texture-in-opengl
 
+    if( SpriteGL::isShadingBatch() ) {
+        // coloring is per sprite, no texture env changes needed
+        SpriteGL::setBatchColoring( SPRITE_COLORING_ALPHA_ONLY );
+        
+        drawSprite( inSprite, inCenter, inZoom, inRotation, inFlipH );
+        
+        toggleAdditiveTextureColoring( additiveTextureColorMode );
+        return;
+        }
+
+    // texture env changes apply to whole batch, so this sprite must be
+    // drawn separately
+    SpriteGL::flushBatch();
+    
     glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_COMBINE);
     glTexEnvi(GL_TEXTURE_ENV, GL_COMBINE_RGB, GL_REPLACE);
     glTexEnvi(GL_TEXTURE_ENV, GL_SOURCE0_RGB, GL_PREVIOUS);
@@ -803,12 +2108,17 @@ void drawSpriteAlphaOnly( SpriteHandle inSprite, doublePair inCenter,
     glTexEnvi(GL_TEXTURE_ENV, GL_COMBINE_ALPHA, GL_MODULATE);
     glTexEnvi(GL_TEXTURE_ENV, GL_SOURCE0_ALPHA, GL_TEXTURE);
     glTexEnvi(GL_TEXTURE_ENV, GL_OPERAND0_ALPHA, GL_SRC_ALPHA);
+    glTexEnvf(GL_TEXTURE_ENV, GL_ALPHA_SCALE, 1);
 
+    checkGLStateContext();
+    glState.texEnvMode = GL_COMBINE;
+    glState.texEnvAlphaScale = 1;
 
-    drawSprite( inSprite, inCenter, inZoom, inRotation, inFlipH );
 
-    // restore texture mode
-    glTexEnvf( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE );
+    drawSprite( inSprite, inCenter, inZoom, inRotation, inFlipH );
+    
+    // restore texture mode, flushing sprite
+    setTexEnvMode( GL_MODULATE );
     }
 
     
@@ -0,0 +1,111 @@
+// Packs directory trees of game resources into one ResourceArchive file,
+// which gameSDL reads resources from (before loose files) if it is found
+// as resources.pack in the game folder.
+
+
+#include "minorGems/io/file/File.h"
+#include "minorGems/io/file/ResourceArchive.h"
+
+#include <stdlib.h>
+
+
+
+int main( int inNumArgs, char **inArgs ) {
+
+    char compress = true;
+    char *archiveName = NULL;
+    SimpleVector<char *> dirNames;
+
+    for( int i=1; i<inNumArgs; i++ ) {
+        if( strcmp( inArgs[i], "-store" ) == 0 ) {
+            compress = false;
+            }
+        else if( archiveName == NULL ) {
+            archiveName = inArgs[i];
+            }
+        else {
+            dirNames.push_back( inArgs[i] );
+            }
+        }
+
+    if( archiveName == NULL || dirNames.size() == 0 ) {
+        printf( "\nUsage:  resourcePacker [-store] archive dir [dir ...]\n\n" );
+        printf( "Packs all files in each dir into archive, under paths "
+                "relative to\nthe current directory "
+                "(run from game folder, with dirs like graphics).\n" );
+        printf( "-store  don't compress any entries\n\n" );
+        return 1;
+        }
+
+    ResourceArchiveWriter writer( archiveName );
+
+    if( ! writer.isOK() ) {
+        printf( "Failed to open %s for writing\n", archiveName );
+        return 1;
+        }
+
+    int numPacked = 0;
+    int numFailed = 0;
+    double rawBytes = 0;
+
+    for( int d=0; d<dirNames.size(); d++ ) {
+        char *dirName = dirNames.getElementDirect( d );
+
+        File dir( NULL, dirName );
+
+        if( ! dir.exists() || ! dir.isDirectory() ) {
+            printf( "Directory %s not found\n", dirName );
+            numFailed ++;
+            continue;
+            }
+
+        int numChildren;
+        File **children = dir.getChildFilesRecursive( 100, &numChildren );
+
+        for( int i=0; i<numChildren; i++ ) {
+            File *child = children[i];
+
+            if( ! child->isDirectory() ) {
+                char *path = child->getFullFileName();
+
+                int length;
+                unsigned char *data = child->readFileContents( &length );
+
+                if( data != NULL &&
+                    writer.addEntry( path, data, length, compress ) ) {
+                    numPacked ++;
+                    rawBytes += length;
+                    }
+                else {
+                    printf( "Failed to pack %s\n", path );
+                    numFailed ++;
+                    }
+
+                if( data != NULL ) {
+                    delete [] data;
+                    }
+                delete [] path;
+                }
+
+            delete child;
+            }
+        if( children != NULL ) {
+            delete [] children;
+            }
+        }
+
+    if( ! writer.finish() ) {
+        printf( "Failed to finish writing %s\n", archiveName );
+        return 1;
+        }
+
+    File archiveFile( NULL, archiveName );
+
+    printf( "\nPacked %d files (%d failed), %.0f bytes into %ld\n",
+            numPacked, numFailed, rawBytes, archiveFile.getLength() );
+
+    if( numFailed > 0 ) {
+        return 1;
+        }
+    return 0;
+    }
@@ -0,0 +1,225 @@
+// Compresses every TGA file in a directory tree into a .ctex file next to
+// it, for loadSprite to use when toggleCompressedSprites is on.
+
+
+#include "minorGems/io/file/File.h"
+#include "minorGems/util/stringUtils.h"
+#include "minorGems/graphics/converters/tgaDecode.h"
+#include "minorGems/graphics/openGL/CompressedTexture.h"
+#include "minorGems/graphics/openGL/SingleTextureGL.h"
+
+#include <stdlib.h>
+
+
+
+static char hasTGAExtension( const char *inFileName ) {
+    int length = strlen( inFileName );
+
+    if( length < 4 ) {
+        return false;
+        }
+
+    char *lower = stringToLowerCase( &( inFileName[ length - 4 ] ) );
+
+    char result = ( strcmp( lower, ".tga" ) == 0 );
+
+    delete [] lower;
+
+    return result;
+    }
+
+
+
+// same rule as SpriteGL:  if image has no alpha information of its own,
+// pixels that match lower-left corner color become transparent
+static void makeCornerTransparent( unsigned char *inRGBA,
+                                   int inWidth, int inHeight ) {
+    int numPixels = inWidth * inHeight;
+
+    for( int i=0; i<numPixels; i++ ) {
+        if( inRGBA[ i * 4 + 3 ] != 255 ) {
+            // keep existing alpha
+            return;
+            }
+        }
+
+    unsigned char *t = &( inRGBA[ inWidth * ( inHeight - 1 ) * 4 ] );
+
+    unsigned char tR = t[0];
+    unsigned char tG = t[1];
+    unsigned char tB = t[2];
+
+    for( int i=0; i<numPixels; i++ ) {
+        unsigned char *p = &( inRGBA[ i * 4 ] );
+
+        if( p[0] == tR && p[1] == tG && p[2] == tB ) {
+            p[3] = 0;
+            }
+        }
+    }
+
+
+
+// returns true on success
+static char packFile( File *inFile, char inCorner, char inMipMaps,
+                      int *outRawBytes, int *outPackedBytes ) {
+
+    char *fileName = inFile->getFullFileName();
+
+    int length;
+    unsigned char *data = inFile->readFileContents( &length );
+
+    TGAInfo info;
+
+    if( data == NULL || ! readTGAInfo( data, length, &info ) ) {
+        printf( "Failed to read TGA file %s\n", fileName );
+
+        if( data != NULL ) {
+            delete [] data;
+            }
+        delete [] fileName;
+        return false;
+        }
+
+    unsigned char *rgba = new unsigned char[ info.width * info.height * 4 ];
+
+    char decoded = decodeTGAToRGBA( data, length, rgba );
+
+    delete [] data;
+
+    if( ! decoded ) {
+        printf( "Failed to decode TGA file %s\n", fileName );
+        delete [] rgba;
+        delete [] fileName;
+        return false;
+        }
+
+    int flags = 0;
+
+    if( inCorner ) {
+        makeCornerTransparent( rgba, info.width, info.height );
+        flags |= COMPRESSED_TEXTURE_FLAG_TRANSPARENT_CORNER;
+        }
+
+    // same bleed that SingleTextureGL does for uncompressed textures,
+    // so filtered edges look the same
+    SingleTextureGL::expandEdges( rgba, info.width, info.height );
+
+    int format = CompressedTexture::chooseFormat( rgba,
+                                                  info.width, info.height );
+
+    CompressedTexture texture( rgba, info.width, info.height, format,
+                               inMipMaps, flags );
+
+    delete [] rgba;
+
+
+    int packedLength;
+    unsigned char *packed = texture.writeToBytes( &packedLength );
+
+    // replace .tga with .ctex
+    fileName[ strlen( fileName ) - 4 ] = '\0';
+
+    char *outName = autoSprintf( "%s.ctex", fileName );
+
+    File outFile( NULL, outName );
+
+    char result = outFile.writeToFile( packed, packedLength );
+
+    delete [] packed;
+
+    if( result ) {
+        int rawBytes = info.width * info.height * 4;
+
+        printf( "%s:  %dx%d %s, %d bytes (%d as RGBA)\n",
+                outName, info.width, info.height,
+                ( format == COMPRESSED_TEXTURE_DXT1 ) ? "DXT1" : "DXT5",
+                texture.getTotalBytes(), rawBytes );
+
+        *outRawBytes += rawBytes;
+        *outPackedBytes += texture.getTotalBytes();
+        }
+    else {
+        printf( "Failed to write %s\n", outName );
+        }
+
+    delete [] outName;
+    delete [] fileName;
+
+    return result;
+    }
+
+
+
+int main( int inNumArgs, char **inArgs ) {
+
+    char corner = false;
+    char mipMaps = true;
+    char *dirName = NULL;
+
+    for( int i=1; i<inNumArgs; i++ ) {
+        if( strcmp( inArgs[i], "-corner" ) == 0 ) {
+            corner = true;
+            }
+        else if( strcmp( inArgs[i], "-noMipMaps" ) == 0 ) {
+            mipMaps = false;
+            }
+        else if( dirName == NULL ) {
+            dirName = inArgs[i];
+            }
+        else {
+            dirName = NULL;
+            break;
+            }
+        }
+
+    if( dirName == NULL ) {
+        printf( "\nUsage:  texturePacker [-corner] [-noMipMaps] dir\n\n" );
+        printf( "Writes file.ctex next to each file.tga in dir.\n" );
+        printf( "-corner  pack for loadSprite with "
+                "inTransparentLowerLeftCorner set\n" );
+        printf( "-noMipMaps  only pack full-size level\n\n" );
+        return 1;
+        }
+
+    File dir( NULL, dirName );
+
+    if( ! dir.exists() || ! dir.isDirectory() ) {
+        printf( "Directory %s not found\n", dirName );
+        return 1;
+        }
+
+    int numChildren;
+    File **children = dir.getChildFilesRecursive( 100, &numChildren );
+
+    int numPacked = 0;
+    int numFailed = 0;
+    int rawBytes = 0;
+    int packedBytes = 0;
+
+    for( int i=0; i<numChildren; i++ ) {
+        char *name = children[i]->getFileName();
+
+        if( ! children[i]->isDirectory() && hasTGAExtension( name ) ) {
+            if( packFile( children[i], corner, mipMaps,
+                          &rawBytes, &packedBytes ) ) {
+                numPacked ++;
+                }
+            else {
+                numFailed ++;
+                }
+            }
+
+        delete [] name;
+        delete children[i];
+        }
+    delete [] children;
+
+    printf( "\nPacked %d textures (%d failed), %d bytes (%d as RGBA)\n",
+            numPacked, numFailed, packedBytes, rawBytes );
+
+    if( numFailed > 0 ) {
+        return 1;
+        }
+    return 0;
+    }
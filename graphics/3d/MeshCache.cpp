@@ -0,0 +1,597 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+
+
+#include "MeshCache.h"
+
+#include "minorGems/io/file/MappedFileContents.h"
+#include "minorGems/util/stringUtils.h"
+
+#include <stdio.h>
+#include <string.h>
+
+
+
+#define HEADER_LENGTH 24
+#define MESH_HEADER_LENGTH ( 20 + 16 * 8 )
+
+#define FLAG_TRANSPARENT 1
+#define FLAG_BACK_VISIBLE 2
+
+
+
+/**
+ * A mapped cache file, shared by the primitives loaded from it and
+ * unmapped when the last of them is destroyed.
+ *
+ * Not thread-safe:  primitives from one file must be destroyed on one
+ * thread.
+ */
+class MeshCacheMapping {
+
+    public:
+
+        MeshCacheMapping( MappedFileContents *inContents )
+                : mContents( inContents ), mRefCount( 1 ) {
+            }
+
+
+        void addReference() {
+            mRefCount++;
+            }
+
+
+        void release() {
+            mRefCount--;
+
+            if( mRefCount == 0 ) {
+                delete mContents;
+                delete this;
+                }
+            }
+
+
+    protected:
+
+        MappedFileContents *mContents;
+        int mRefCount;
+
+    };
+
+
+
+MeshCacheKey::MeshCacheKey( const char *inKind )
+        // FNV-1a offset basis
+        : mHash( 14695981039346656037ULL ) {
+
+    add( inKind );
+    }
+
+
+
+void MeshCacheKey::addBytes( const unsigned char *inBytes,
+                             int inNumBytes ) {
+    // FNV-1a
+    for( int i=0; i<inNumBytes; i++ ) {
+        mHash ^= inBytes[i];
+        mHash *= 1099511628211ULL;
+        }
+    }
+
+
+
+void MeshCacheKey::add( int inValue ) {
+    addBytes( (unsigned char *)&inValue, sizeof( inValue ) );
+    }
+
+
+
+void MeshCacheKey::add( double inValue ) {
+    addBytes( (unsigned char *)&inValue, sizeof( inValue ) );
+    }
+
+
+
+void MeshCacheKey::add( const double *inValues, int inNumValues ) {
+    addBytes( (const unsigned char *)inValues,
+              inNumValues * sizeof( double ) );
+    }
+
+
+
+void MeshCacheKey::add( Vector3D *inValue ) {
+    add( inValue->mX );
+    add( inValue->mY );
+    add( inValue->mZ );
+    }
+
+
+
+void MeshCacheKey::add( const char *inValue ) {
+    // including terminator, so "ab","c" differs from "a","bc"
+    addBytes( (const unsigned char *)inValue, strlen( inValue ) + 1 );
+    }
+
+
+
+
+CachedPrimitive3D::CachedPrimitive3D( MeshCacheMapping *inMapping,
+                                      const float *inPackedVertexData,
+                                      const unsigned int *inPackedIndices,
+                                      int inNumIndices )
+        : mMapping( inMapping ),
+          mPackedVertexData( inPackedVertexData ),
+          mPackedIndices( inPackedIndices ),
+          mNumIndices( inNumIndices ),
+          mLoadedGeometryVersion( 0 ) {
+
+    mMapping->addReference();
+    }
+
+
+
+CachedPrimitive3D::~CachedPrimitive3D() {
+    mMapping->release();
+    }
+
+
+
+const float *CachedPrimitive3D::getPackedVertexData( int inNumLayers ) {
+    if( getGeometryVersion() != mLoadedGeometryVersion ||
+        inNumLayers > mNumTextures ) {
+        return NULL;
+        }
+    // anchors for fewer layers are a prefix of those for all layers
+    return mPackedVertexData;
+    }
+
+
+
+const unsigned int *CachedPrimitive3D::getPackedTriangleStripIndices(
+    int *outNumIndices ) {
+
+    if( getGeometryVersion() != mLoadedGeometryVersion ) {
+        return NULL;
+        }
+    *outNumIndices = mNumIndices;
+    return mPackedIndices;
+    }
+
+
+
+
+MeshCache::MeshCache( const char *inDirectoryName )
+        : mDirectoryName( stringDuplicate( inDirectoryName ) ) {
+    }
+
+
+
+MeshCache::~MeshCache() {
+    delete [] mDirectoryName;
+    }
+
+
+
+char *MeshCache::getFileName( MeshCacheKey *inKey ) {
+    uint64_t hash = inKey->getHash();
+
+    return autoSprintf( "%s/%08x%08x.mesh", mDirectoryName,
+                        (unsigned int)( hash >> 32 ),
+                        (unsigned int)( hash & 0xFFFFFFFF ) );
+    }
+
+
+
+static char writeBlock( FILE *inFile, const void *inData, int inLength ) {
+    return
+        (int)fwrite( inData, 1, inLength, inFile ) == inLength;
+    }
+
+
+
+static char writeUInt( FILE *inFile, unsigned int inValue ) {
+    return writeBlock( inFile, &inValue, sizeof( inValue ) );
+    }
+
+
+
+static unsigned int readUInt( const unsigned char *inBytes ) {
+    unsigned int value;
+    memcpy( &value, inBytes, sizeof( value ) );
+    return value;
+    }
+
+
+
+static char writeMesh( FILE *inFile, Primitive3D *inPrimitive,
+                       Transform3D *inTransform ) {
+    int numVertices = inPrimitive->mNumVertices;
+    int numLayers = inPrimitive->mNumTextures;
+
+    int numIndices;
+    unsigned int *indices =
+        inPrimitive->getTriangleStripIndices( &numIndices );
+
+    unsigned int flags = 0;
+    if( inPrimitive->isTransparent() ) {
+        flags |= FLAG_TRANSPARENT;
+        }
+    if( inPrimitive->isBackVisible() ) {
+        flags |= FLAG_BACK_VISIBLE;
+        }
+
+    Transform3D identity;
+    if( inTransform == NULL ) {
+        inTransform = &identity;
+        }
+
+    char ok =
+        writeUInt( inFile, inPrimitive->mWide ) &&
+        writeUInt( inFile, inPrimitive->mHigh ) &&
+        writeUInt( inFile, numLayers ) &&
+        writeUInt( inFile, flags ) &&
+        writeUInt( inFile, numIndices ) &&
+        writeBlock( inFile, inTransform->getMatrix(), 16 * sizeof( double ) );
+
+
+    // big enough for positions or normals, and reused for anchors
+    float *data = new float[ numVertices * 3 ];
+
+    int i;
+    for( i=0; i<numVertices; i++ ) {
+        Vector3D *v = inPrimitive->mVertices[i];
+        data[ 3 * i ] = (float)( v->mX );
+        data[ 3 * i + 1 ] = (float)( v->mY );
+        data[ 3 * i + 2 ] = (float)( v->mZ );
+        }
+    ok = ok && writeBlock( inFile, data, numVertices * 3 * sizeof( float ) );
+
+    for( int t=0; t<numLayers; t++ ) {
+        for( i=0; i<numVertices; i++ ) {
+            data[ 2 * i ] = (float)( inPrimitive->mAnchorX[t][i] );
+            data[ 2 * i + 1 ] = (float)( inPrimitive->mAnchorY[t][i] );
+            }
+        ok = ok &&
+            writeBlock( inFile, data, numVertices * 2 * sizeof( float ) );
+        }
+
+    for( i=0; i<numVertices; i++ ) {
+        Vector3D *n = inPrimitive->mNormals[i];
+        data[ 3 * i ] = (float)( n->mX );
+        data[ 3 * i + 1 ] = (float)( n->mY );
+        data[ 3 * i + 2 ] = (float)( n->mZ );
+        }
+    ok = ok && writeBlock( inFile, data, numVertices * 3 * sizeof( float ) );
+
+    ok = ok &&
+        writeBlock( inFile, indices, numIndices * sizeof( unsigned int ) );
+
+    delete [] data;
+    delete [] indices;
+
+    return ok;
+    }
+
+
+
+char MeshCache::putMeshes( MeshCacheKey *inKey, int inNumMeshes,
+                           Primitive3D **inPrimitives,
+                           Transform3D **inTransforms ) {
+    char *fileName = getFileName( inKey );
+    char *tempFileName = autoSprintf( "%s.temp", fileName );
+
+    FILE *file = fopen( tempFileName, "wb" );
+
+    if( file == NULL ) {
+        printf( "Failed to open mesh cache file for writing: %s\n",
+                tempFileName );
+        delete [] tempFileName;
+        delete [] fileName;
+        return false;
+        }
+
+    uint64_t hash = inKey->getHash();
+
+    char ok =
+        writeBlock( file, "MGMC", 4 ) &&
+        writeUInt( file, 1 ) &&
+        writeUInt( file, 0x01020304 ) &&
+        writeUInt( file, (unsigned int)( hash & 0xFFFFFFFF ) ) &&
+        writeUInt( file, (unsigned int)( hash >> 32 ) ) &&
+        writeUInt( file, inNumMeshes );
+
+    for( int m=0; m<inNumMeshes && ok; m++ ) {
+        Transform3D *transform = NULL;
+        if( inTransforms != NULL ) {
+            transform = inTransforms[m];
+            }
+        ok = writeMesh( file, inPrimitives[m], transform );
+        }
+
+    if( fclose( file ) != 0 ) {
+        ok = false;
+        }
+
+    if( ok ) {
+        if( rename( tempFileName, fileName ) != 0 ) {
+            // Win32 rename won't replace an existing file
+            remove( fileName );
+
+            if( rename( tempFileName, fileName ) != 0 ) {
+                ok = false;
+                }
+            }
+        }
+
+    if( ! ok ) {
+        printf( "Failed to write mesh cache file: %s\n", fileName );
+        remove( tempFileName );
+        }
+
+    delete [] tempFileName;
+    delete [] fileName;
+
+    return ok;
+    }
+
+
+
+char MeshCache::putPrimitive( MeshCacheKey *inKey,
+                              Primitive3D *inPrimitive ) {
+    return putMeshes( inKey, 1, &inPrimitive, NULL );
+    }
+
+
+
+char MeshCache::putObject( MeshCacheKey *inKey, Object3D *inObject ) {
+    return putMeshes( inKey, inObject->mNumPrimitives,
+                      inObject->mPrimitives, inObject->mTransform );
+    }
+
+
+
+// fills in a primitive's vertex arrays from packed floats
+static void unpackMesh( Primitive3D *inPrimitive,
+                        const float *inPositions,
+                        const float *inAnchors,
+                        const float *inNormals ) {
+    int numVertices = inPrimitive->mNumVertices;
+    int numLayers = inPrimitive->mNumTextures;
+
+    inPrimitive->mVertices = new Vector3D*[ numVertices ];
+    inPrimitive->mNormals = new Vector3D*[ numVertices ];
+
+    int i;
+    for( i=0; i<numVertices; i++ ) {
+        inPrimitive->mVertices[i] = new Vector3D( inPositions[ 3 * i ],
+                                                  inPositions[ 3 * i + 1 ],
+                                                  inPositions[ 3 * i + 2 ] );
+        inPrimitive->mNormals[i] = new Vector3D( inNormals[ 3 * i ],
+                                                 inNormals[ 3 * i + 1 ],
+                                                 inNormals[ 3 * i + 2 ] );
+        }
+
+    inPrimitive->mAnchorX = new double*[ numLayers ];
+    inPrimitive->mAnchorY = new double*[ numLayers ];
+
+    for( int t=0; t<numLayers; t++ ) {
+        const float *anchors = &( inAnchors[ numVertices * 2 * t ] );
+
+        double *anchorX = new double[ numVertices ];
+        double *anchorY = new double[ numVertices ];
+
+        for( i=0; i<numVertices; i++ ) {
+            anchorX[i] = anchors[ 2 * i ];
+            anchorY[i] = anchors[ 2 * i + 1 ];
+            }
+
+        inPrimitive->mAnchorX[t] = anchorX;
+        inPrimitive->mAnchorY[t] = anchorY;
+        }
+    }
+
+
+
+int MeshCache::getMeshes( MeshCacheKey *inKey,
+                          int inNumTextures, RGBAImage **inTextures,
+                          Primitive3D ***outPrimitives,
+                          Transform3D ***outTransforms ) {
+    char *fileName = getFileName( inKey );
+
+    MappedFileContents *contents = new MappedFileContents( fileName );
+
+    delete [] fileName;
+
+    const unsigned char *data = contents->getData();
+    unsigned int length = contents->getLength();
+
+    uint64_t hash = inKey->getHash();
+
+    if( ! contents->isMapped() ||
+        length < HEADER_LENGTH ||
+        memcmp( data, "MGMC", 4 ) != 0 ||
+        readUInt( &( data[4] ) ) != 1 ||
+        readUInt( &( data[8] ) ) != 0x01020304 ||
+        readUInt( &( data[12] ) ) != (unsigned int)( hash & 0xFFFFFFFF ) ||
+        readUInt( &( data[16] ) ) != (unsigned int)( hash >> 32 ) ) {
+
+        delete contents;
+        return -1;
+        }
+
+    unsigned int numMeshes = readUInt( &( data[20] ) );
+
+
+    // check sizes before building anything, so a truncated or
+    // mismatched file is a miss
+    unsigned int offset = HEADER_LENGTH;
+    unsigned int totalLayers = 0;
+
+    unsigned int m;
+    for( m=0; m<numMeshes; m++ ) {
+        if( length - offset < MESH_HEADER_LENGTH ) {
+            delete contents;
+            return -1;
+            }
+        const unsigned char *header = &( data[ offset ] );
+
+        uint64_t numVertices =
+            (uint64_t)readUInt( &( header[0] ) ) * readUInt( &( header[4] ) );
+        unsigned int numLayers = readUInt( &( header[8] ) );
+        unsigned int numIndices = readUInt( &( header[16] ) );
+
+        uint64_t meshLength =
+            MESH_HEADER_LENGTH +
+            numVertices * ( 3 + 2 * (uint64_t)numLayers + 3 ) *
+            sizeof( float ) +
+            (uint64_t)numIndices * sizeof( unsigned int );
+
+        if( meshLength > length - offset ) {
+            delete contents;
+            return -1;
+            }
+
+        offset += (unsigned int)meshLength;
+        totalLayers += numLayers;
+        }
+
+    if( totalLayers != (unsigned int)inNumTextures ) {
+        delete contents;
+        return -1;
+        }
+
+
+    MeshCacheMapping *mapping = new MeshCacheMapping( contents );
+
+    Primitive3D **primitives = new Primitive3D*[ numMeshes ];
+    Transform3D **transforms = new Transform3D*[ numMeshes ];
+
+    offset = HEADER_LENGTH;
+    int textureIndex = 0;
+
+    for( m=0; m<numMeshes; m++ ) {
+        const unsigned char *header = &( data[ offset ] );
+
+        int wide = readUInt( &( header[0] ) );
+        int high = readUInt( &( header[4] ) );
+        int numLayers = readUInt( &( header[8] ) );
+        unsigned int flags = readUInt( &( header[12] ) );
+        int numIndices = readUInt( &( header[16] ) );
+
+        Transform3D *transform = new Transform3D();
+        memcpy( transform->getMatrix(), &( header[20] ),
+                16 * sizeof( double ) );
+        transforms[m] = transform;
+
+        int numVertices = wide * high;
+
+        const float *positions =
+            (const float *)&( header[ MESH_HEADER_LENGTH ] );
+        const float *anchors = &( positions[ numVertices * 3 ] );
+        const float *normals = &( anchors[ numVertices * 2 * numLayers ] );
+        const unsigned int *indices =
+            (const unsigned int *)&( normals[ numVertices * 3 ] );
+
+        CachedPrimitive3D *primitive =
+            new CachedPrimitive3D( mapping, positions, indices, numIndices );
+
+        primitive->mWide = wide;
+        primitive->mHigh = high;
+        primitive->mNumVertices = numVertices;
+        primitive->mNumTextures = numLayers;
+
+        primitive->mTexture = new RGBAImage*[ numLayers ];
+        for( int t=0; t<numLayers; t++ ) {
+            primitive->mTexture[t] = inTextures[ textureIndex ];
+            textureIndex++;
+            }
+
+        unpackMesh( primitive, positions, anchors, normals );
+
+        primitive->mMembersAllocated = true;
+
+        primitive->setTransparent( ( flags & FLAG_TRANSPARENT ) != 0 );
+        primitive->setBackVisible( ( flags & FLAG_BACK_VISIBLE ) != 0 );
+
+        primitive->markGeometryChanged();
+        primitive->mLoadedGeometryVersion = primitive->getGeometryVersion();
+
+        primitives[m] = primitive;
+
+        offset = (unsigned int)(
+            (const unsigned char *)&( indices[ numIndices ] ) - data );
+        }
+
+    // primitives hold their own references
+    mapping->release();
+
+    *outPrimitives = primitives;
+
+    if( outTransforms != NULL ) {
+        *outTransforms = transforms;
+        }
+    else {
+        for( m=0; m<numMeshes; m++ ) {
+            delete transforms[m];
+            }
+        delete [] transforms;
+        }
+
+    return numMeshes;
+    }
+
+
+
+Primitive3D *MeshCache::getPrimitive( MeshCacheKey *inKey,
+                                      int inNumTextures,
+                                      RGBAImage **inTextures ) {
+    Primitive3D **primitives;
+
+    int numMeshes = getMeshes( inKey, inNumTextures, inTextures,
+                               &primitives, NULL );
+
+    if( numMeshes == -1 ) {
+        return NULL;
+        }
+
+    if( numMeshes != 1 ) {
+        // an object's file, can't stand in for a primitive, and
+        // textures are still caller's
+        for( int m=0; m<numMeshes; m++ ) {
+            for( int t=0; t<primitives[m]->mNumTextures; t++ ) {
+                primitives[m]->mTexture[t] = NULL;
+                }
+            delete primitives[m];
+            }
+        delete [] primitives;
+        return NULL;
+        }
+
+    Primitive3D *primitive = primitives[0];
+    delete [] primitives;
+
+    return primitive;
+    }
+
+
+
+Object3D *MeshCache::getObject( MeshCacheKey *inKey,
+                                int inNumTextures,
+                                RGBAImage **inTextures ) {
+    Primitive3D **primitives;
+    Transform3D **transforms;
+
+    int numMeshes = getMeshes( inKey, inNumTextures, inTextures,
+                               &primitives, &transforms );
+
+    if( numMeshes == -1 ) {
+        return NULL;
+        }
+
+    return new Object3D( numMeshes, primitives, transforms );
+    }
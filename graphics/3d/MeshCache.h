@@ -0,0 +1,257 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+
+
+#ifndef MESH_CACHE_INCLUDED
+#define MESH_CACHE_INCLUDED
+
+
+#include "Primitive3D.h"
+#include "Object3D.h"
+
+#include <stdint.h>
+
+
+
+/**
+ * Key for a cached mesh, built from the parameters that generated it.
+ *
+ * Feed it everything the mesh depends on (for a LathePrimitive3D, the
+ * curve points, number of steps, and lathe angle; for a
+ * LandscapePrimitive3D, the size, heights, and detail scale), in a fixed
+ * order.  Parameters are hashed (64-bit FNV-1a) as they are added.
+ *
+ * @author Jason Rohrer
+ */
+class MeshCacheKey {
+
+    public:
+
+        /**
+         * Starts a key.
+         *
+         * @param inKind the kind of mesh (like "lathe"), so that
+         *   different generators with the same parameters don't collide.
+         *   Destroyed by caller.
+         */
+        MeshCacheKey( const char *inKind );
+
+
+        void add( int inValue );
+
+        void add( double inValue );
+
+        void add( const double *inValues, int inNumValues );
+
+        // adds x, y, and z
+        void add( Vector3D *inValue );
+
+        void add( const char *inValue );
+
+        void addBytes( const unsigned char *inBytes, int inNumBytes );
+
+
+        uint64_t getHash() {
+            return mHash;
+            }
+
+
+    protected:
+
+        uint64_t mHash;
+
+    };
+
+
+
+class MeshCacheMapping;
+
+
+
+/**
+ * A Primitive3D loaded from a MeshCache.
+ *
+ * Its vertices, normals, and anchors are filled in like any other
+ * primitive's, but it also hands out the cache file's packed positions,
+ * anchors, and strip indices, so that PrimitiveGL can upload them to
+ * vertex buffers straight from the mapped file.  Once the geometry has
+ * been changed (see markGeometryChanged), packed data is no longer
+ * returned.
+ *
+ * Copies are plain Primitive3Ds.
+ *
+ * @author Jason Rohrer
+ */
+class CachedPrimitive3D : public Primitive3D {
+
+    public:
+
+        virtual ~CachedPrimitive3D();
+
+
+        virtual const float *getPackedVertexData( int inNumLayers );
+
+        virtual const unsigned int *getPackedTriangleStripIndices(
+            int *outNumIndices );
+
+
+    protected:
+
+        // only made by MeshCache
+        friend class MeshCache;
+
+        CachedPrimitive3D( MeshCacheMapping *inMapping,
+                           const float *inPackedVertexData,
+                           const unsigned int *inPackedIndices,
+                           int inNumIndices );
+
+
+        MeshCacheMapping *mMapping;
+
+        const float *mPackedVertexData;
+        const unsigned int *mPackedIndices;
+        int mNumIndices;
+
+        unsigned long mLoadedGeometryVersion;
+
+    };
+
+
+
+/**
+ * A directory of generated meshes, saved in a compact binary form so
+ * that they can be loaded instead of generated (or deserialized field by
+ * field) again.
+ *
+ * Cache files are memory-mapped on load.  Mesh data is stored as floats
+ * in the layout PrimitiveGL uploads to vertex buffers, so the loaded
+ * primitives can be uploaded without repacking.  Positions, normals, and
+ * anchors are float precision in loaded primitives.
+ *
+ * Textures are not cached:  callers supply them on load, and keep them
+ * on a miss.
+ *
+ *
+ * Format (native byte order, checked on load; all integers 32-bit):
+ *
+ *   header:    "MGMC", version (1), byte order mark (0x01020304),
+ *              key hash (low word, then high word), number of meshes
+ *   meshes:    for each mesh:  wide, high, number of texture layers,
+ *              flags (1 transparent, 2 back visible), number of strip
+ *              indices, 16 doubles of transform matrix, then float
+ *              positions (3 per vertex), float anchors (2 per vertex)
+ *              for each layer, float normals (3 per vertex), and strip
+ *              indices
+ *
+ * Files are written to a temporary name and renamed into place, so a
+ * half-written file is never loaded.
+ *
+ * @author Jason Rohrer
+ */
+class MeshCache {
+
+    public:
+
+        /**
+         * Constructs a cache.
+         *
+         * @param inDirectoryName directory to keep cache files in.
+         *   Must already exist.  Destroyed by caller.
+         */
+        MeshCache( const char *inDirectoryName );
+
+        ~MeshCache();
+
+
+        /**
+         * Loads a cached primitive.
+         *
+         * @param inKey the primitive's key.  Destroyed by caller.
+         * @param inNumTextures the number of texture layers.  Must
+         *   match the cached primitive's, or the lookup misses.
+         * @param inTextures the textures.  Destroyed by the returned
+         *   primitive on a hit, and by caller on a miss.
+         *
+         * @return the primitive, or NULL on a miss.
+         *   Must be destroyed by caller.
+         */
+        Primitive3D *getPrimitive( MeshCacheKey *inKey,
+                                   int inNumTextures,
+                                   RGBAImage **inTextures );
+
+
+        /**
+         * Saves a primitive to the cache, replacing any under the same
+         * key.
+         *
+         * @param inKey the primitive's key.  Destroyed by caller.
+         * @param inPrimitive the primitive.  Destroyed by caller.
+         *
+         * @return true on success.
+         */
+        char putPrimitive( MeshCacheKey *inKey, Primitive3D *inPrimitive );
+
+
+        /**
+         * Loads a cached object.
+         *
+         * @param inKey the object's key.  Destroyed by caller.
+         * @param inNumTextures the total number of texture layers over
+         *   all of the object's primitives.  Must match the cached
+         *   object's, or the lookup misses.
+         * @param inTextures the textures for each primitive in turn.
+         *   Destroyed by the returned object on a hit, and by caller on
+         *   a miss.
+         *
+         * @return the object, or NULL on a miss.
+         *   Must be destroyed by caller.
+         */
+        Object3D *getObject( MeshCacheKey *inKey,
+                             int inNumTextures, RGBAImage **inTextures );
+
+
+        /**
+         * Saves an object's primitives and transforms to the cache,
+         * replacing any under the same key.
+         *
+         * @param inKey the object's key.  Destroyed by caller.
+         * @param inObject the object.  Destroyed by caller.
+         *
+         * @return true on success.
+         */
+        char putObject( MeshCacheKey *inKey, Object3D *inObject );
+
+
+    protected:
+
+        char *mDirectoryName;
+
+
+        // result destroyed by caller
+        char *getFileName( MeshCacheKey *inKey );
+
+
+        // writes meshes, with NULL transforms saved as identity
+        char putMeshes( MeshCacheKey *inKey, int inNumMeshes,
+                        Primitive3D **inPrimitives,
+                        Transform3D **inTransforms );
+
+
+        // Loads meshes, returning the number loaded, or -1 on a miss.
+        // Primitives and transforms arrays are destroyed by caller.
+        // outTransforms may be NULL.
+        int getMeshes( MeshCacheKey *inKey,
+                       int inNumTextures, RGBAImage **inTextures,
+                       Primitive3D ***outPrimitives,
+                       Transform3D ***outTransforms );
+
+    };
+
+
+
+#endif
@@ -39,6 +39,9 @@
  * 2001-March-14   Jason Rohrer
  * Added use of Primitive3DFactory for typed subclass primitive
  * de/serialization.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Serialization buffers small writes.
  */
  
  
@@ -49,6 +52,7 @@
 #include "minorGems/math/geometry/Transform3D.h"  
 
 #include "minorGems/io/Serializable.h"
+#include "minorGems/io/SerialWriter.h"
 
 #include "Primitive3DFactory.h"
 
@@ -274,6 +278,10 @@ inline void Object3D::stopAnimation( int inAnimationIndex ) {
 
 	
 inline int Object3D::serialize( OutputStream *inOutputStream ) {
+	// collect the many small writes into large blocks
+	SerialWriter writer( inOutputStream );
+	inOutputStream = &writer;
+	
 	int i;
 	int numBytes = 0;
 	
@@ -296,6 +304,10 @@ inline int Object3D::serialize( OutputStream *inOutputStream ) {
 		numBytes += mTransform[i]->serialize( inOutputStream );
 		}
 	
+	if( ! writer.flush() ) {
+		return -1;
+		}
+	
 	return numBytes;
 	}
 	
@@ -35,6 +35,15 @@
  * 2001-April-1  Jason Rohrer
  * Made copy function virtual.  Added a getNewInstance function
  * to make derived-class-specific copying easier.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Added a geometry version for renderers that cache vertex data, and
+ * indices for drawing the mesh as a single triangle strip.
+ * Serialization buffers small writes, and anchor arrays are written and
+ * read in one call each.
+ * Added packed vertex data hooks, so renderers can upload meshes loaded
+ * from a MeshCache without repacking them.
+ * Constructor initializers follow member declaration order.
  */
  
  
@@ -50,6 +59,8 @@
 #include "minorGems/math/geometry/Angle3D.h" 
 
 #include "minorGems/io/Serializable.h"
+#include "minorGems/io/SerialWriter.h"
+#include "minorGems/io/SerialReader.h"
  
 /**
  * 3D primitive object.
@@ -234,6 +245,68 @@ class Primitive3D : public Serializable {
 		 */
 		virtual void stopAnimation( int inAnimationIndex );
 
+
+		/**
+		 * Marks the vertices, normals, or anchors as changed.
+		 *
+		 * Must be called after changing them directly, so that renderers
+		 * caching them (like PrimitiveGL's vertex buffers) re-upload.
+		 * generateNormals() and deserialize() call this.
+		 */
+		void markGeometryChanged();
+
+
+		/**
+		 * Gets the geometry version, which increases with each call
+		 * to markGeometryChanged().
+		 *
+		 * @return the version.
+		 */
+		unsigned long getGeometryVersion();
+
+
+		/**
+		 * Gets vertex indices that draw the whole mesh as one triangle
+		 * strip.  Each row is stripped as in separate row strips,
+		 * and rows are joined by degenerate triangles.
+		 *
+		 * @param outNumIndices pointer to where the number of indices
+		 *   should be returned.
+		 *
+		 * @return the indices.  Must be destroyed by caller.
+		 */
+		unsigned int *getTriangleStripIndices( int *outNumIndices );
+		
+		
+		/**
+		 * Gets vertex data already packed as float positions (x, y, z for
+		 * each vertex), followed by float anchors (x, y for each vertex)
+		 * for each texture layer in turn.
+		 *
+		 * The base class has no packed data.  Subclasses that have it
+		 * (like CachedPrimitive3D) must stop returning it once the
+		 * geometry has changed.
+		 *
+		 * @param inNumLayers the number of anchor layers needed.
+		 *
+		 * @return the packed data, or NULL if not available.
+		 *   Must NOT be destroyed by caller.
+		 */
+		virtual const float *getPackedVertexData( int inNumLayers );
+		
+		
+		/**
+		 * Gets packed indices matching getTriangleStripIndices.
+		 *
+		 * @param outNumIndices pointer to where the number of indices
+		 *   should be returned.
+		 *
+		 * @return the indices, or NULL if not available (the default).
+		 *   Must NOT be destroyed by caller.
+		 */
+		virtual const unsigned int *getPackedTriangleStripIndices( 
+			int *outNumIndices );
+		
 		
 		long mHigh, mWide;
 		long mNumVertices;
@@ -271,6 +344,8 @@ class Primitive3D : public Serializable {
 		char mTransparent;
 		char mBackVisible;
 		
+		unsigned long mGeometryVersion;
+		
 		
 		
 	};
@@ -280,11 +355,12 @@ class Primitive3D : public Serializable {
 inline Primitive3D::Primitive3D(  long inWide, long inHigh, 
 	Vector3D **inVertices, long inNumTextures, RGBAImage **inTexture, 
 	double **inAnchorX, double **inAnchorY ) 
-	: mHigh( inHigh ), mWide( inWide ), mNumVertices( inHigh * inWide ),
-	mNumTextures( inNumTextures ), mVertices( inVertices ),
+	: mMembersAllocated( true ),
+	mHigh( inHigh ), mWide( inWide ), mNumVertices( inHigh * inWide ),
+	mVertices( inVertices ), mNumTextures( inNumTextures ),
 	mTexture( inTexture ), mAnchorX( inAnchorX ), mAnchorY( inAnchorY ),
 	mTransparent( false ), mBackVisible( false ),
-	mMembersAllocated( true ) {
+	mGeometryVersion( 0 ) {
 	
 	generateNormals();	
 	}
@@ -292,8 +368,9 @@ inline Primitive3D::Primitive3D(  long inWide, long inHigh,
 
 
 inline Primitive3D::Primitive3D()
-	: mTransparent( false ), mBackVisible( false ),
-	mMembersAllocated( false ) {
+	: mMembersAllocated( false ),
+	mTransparent( false ), mBackVisible( false ),
+	mGeometryVersion( 0 ) {
 	
 	}
 
@@ -410,6 +487,77 @@ inline void Primitive3D::generateNormals() {
 			mNormals[index] = normalSum;	
 			}
 		}
+	
+	markGeometryChanged();
+	}
+
+
+
+inline void Primitive3D::markGeometryChanged() {
+	mGeometryVersion++;
+	}
+
+
+
+inline unsigned long Primitive3D::getGeometryVersion() {
+	return mGeometryVersion;
+	}
+
+
+
+inline unsigned int *Primitive3D::getTriangleStripIndices( 
+	int *outNumIndices ) {
+	
+	int numStrips = mHigh - 1;
+	
+	if( numStrips < 1 ) {
+		*outNumIndices = 0;
+		return new unsigned int[1];
+		}
+	
+	// each row strip has 2 indices per column, and each join between
+	// strips repeats the last index of one and the first of the next.
+	// Row strips have an even length, so every strip starts with
+	// the same winding.
+	int numIndices = numStrips * 2 * mWide + ( numStrips - 1 ) * 2;
+	
+	unsigned int *indices = new unsigned int[ numIndices ];
+	
+	int i = 0;
+	for( int y=0; y<numStrips; y++ ) {
+		unsigned int thisRow = y * mWide;
+		unsigned int nextRow = ( y + 1 ) * mWide;
+		
+		if( y > 0 ) {
+			// degenerate join to the first vertex of this strip
+			indices[i] = indices[ i - 1 ];
+			i++;
+			indices[i] = nextRow;
+			i++;
+			}
+		
+		for( int x=0; x<mWide; x++ ) {
+			indices[i++] = nextRow + x;
+			indices[i++] = thisRow + x;
+			}
+		}
+	
+	*outNumIndices = numIndices;
+	return indices;
+	}
+
+
+
+inline const float *Primitive3D::getPackedVertexData( int inNumLayers ) {
+	return NULL;
+	}
+
+
+
+inline const unsigned int *Primitive3D::getPackedTriangleStripIndices( 
+	int *outNumIndices ) {
+	
+	return NULL;
 	}
 
 
@@ -534,6 +682,10 @@ inline void Primitive3D::stopAnimation( int inAnimationIndex ) {
 
 
 inline int Primitive3D::serialize( OutputStream *inOutputStream ) {
+	// collect the many small vertex writes into large blocks
+	SerialWriter writer( inOutputStream );
+	inOutputStream = &writer;
+	
 	int numBytes = 0;
 	
 	numBytes += inOutputStream->writeLong( mWide );
@@ -559,15 +711,11 @@ inline int Primitive3D::serialize( OutputStream *inOutputStream ) {
 	
 	// output anchor arrays
 	for( i=0; i<mNumTextures; i++ ) {
-		for( int p=0; p<mNumVertices; p++ ) {
-			numBytes += inOutputStream->writeDouble( mAnchorX[i][p] );
-			}
+		numBytes += writer.writeDoubles( mAnchorX[i], mNumVertices );
 		}
 	
 	for( i=0; i<mNumTextures; i++ ) {
-		for( int p=0; p<mNumVertices; p++ ) {
-			numBytes += inOutputStream->writeDouble( mAnchorY[i][p] );
-			}
+		numBytes += writer.writeDoubles( mAnchorY[i], mNumVertices );
 		}
 	
 	numBytes += 
@@ -576,6 +724,10 @@ inline int Primitive3D::serialize( OutputStream *inOutputStream ) {
 	numBytes += 
 		inOutputStream->write( (unsigned char *)&mBackVisible, 1 );
 
+	if( ! writer.flush() ) {
+		return -1;
+		}
+	
 	return numBytes;
 	}
 
@@ -644,20 +796,18 @@ inline int Primitive3D::deserialize( InputStream *inInputStream ) {
 		}
 	
 	// input anchor arrays
+	SerialReader reader( inInputStream );
+	
 	for( i=0; i<mNumTextures; i++ ) {
 		mAnchorX[i] = new double[mNumVertices];
 		
-		for( int p=0; p<mNumVertices; p++ ) {
-			numBytes += inInputStream->readDouble( &( mAnchorX[i][p] ) );
-			}
+		numBytes += reader.readDoubles( mAnchorX[i], mNumVertices );
 		}
 	
 	for( i=0; i<mNumTextures; i++ ) {
 		mAnchorY[i] = new double[mNumVertices];
 		
-		for( int p=0; p<mNumVertices; p++ ) {
-			numBytes += inInputStream->readDouble( &( mAnchorY[i][p] ) );
-			}
+		numBytes += reader.readDoubles( mAnchorY[i], mNumVertices );
 		}
 	
 	numBytes += 
@@ -668,6 +818,8 @@ inline int Primitive3D::deserialize( InputStream *inInputStream ) {
 	
 	mMembersAllocated = true;
 	
+	markGeometryChanged();
+	
 	return numBytesRead;
 	}
 	
@@ -0,0 +1,387 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+/**
+ * Round-trips lathe, landscape, and object meshes through a MeshCache,
+ * checks misses and packed data, and times loading from the cache
+ * against generating.
+ *
+ * Compile from above the minorGems directory with:
+ *   g++ -O2 -I. minorGems/graphics/3d/meshCacheTest.cpp
+ *     minorGems/graphics/3d/MeshCache.cpp
+ *     minorGems/io/file/unix/MappedFileContentsUnix.cpp
+ *     minorGems/util/stringUtils.cpp minorGems/system/unix/TimeUnix.cpp
+ *     minorGems/io/linux/TypeIOLinux.cpp -o meshCacheTest
+ *
+ * Cache files are written to /tmp/meshCacheTest, which must exist.
+ */
+
+#include "MeshCache.h"
+#include "LathePrimitive3D.h"
+#include "LandscapePrimitive3D.h"
+
+#include "minorGems/system/Time.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+
+static int numBad = 0;
+
+
+static const char *cacheDirectory = "/tmp/meshCacheTest";
+
+
+
+static LathePrimitive3D *makeLathe( int inNumSteps, MeshCacheKey *outKey ) {
+    int numCurvePoints = 20;
+    Vector3D **curve = new Vector3D*[ numCurvePoints ];
+
+    for( int i=0; i<numCurvePoints; i++ ) {
+        curve[i] = new Vector3D( 0.5 + 0.3 * sin( i * 0.4 ), i * 0.1, 0 );
+        outKey->add( curve[i] );
+        }
+    outKey->add( inNumSteps );
+    outKey->add( 2 * M_PI );
+
+    return new LathePrimitive3D( numCurvePoints, curve, inNumSteps,
+                                 2 * M_PI, new RGBAImage( 4, 4 ) );
+    }
+
+
+
+static double *makeHeights( int inWide, int inHigh ) {
+    double *heights = new double[ inWide * inHigh ];
+
+    srand( 10 );
+    for( int i=0; i<inWide * inHigh; i++ ) {
+        heights[i] = rand() / (double)RAND_MAX;
+        }
+    return heights;
+    }
+
+
+
+static void checkVector( const char *inWhat, int inIndex,
+                         Vector3D *inA, Vector3D *inB, int *ioNumWrong ) {
+    if( fabs( inA->mX - inB->mX ) > 0.0001 ||
+        fabs( inA->mY - inB->mY ) > 0.0001 ||
+        fabs( inA->mZ - inB->mZ ) > 0.0001 ) {
+
+        if( *ioNumWrong == 0 ) {
+            printf( "%s %d:  (%f,%f,%f) loaded as (%f,%f,%f)\n",
+                    inWhat, inIndex, inA->mX, inA->mY, inA->mZ,
+                    inB->mX, inB->mY, inB->mZ );
+            }
+        (*ioNumWrong)++;
+        }
+    }
+
+
+
+static void checkSame( const char *inWhat,
+                       Primitive3D *inGenerated, Primitive3D *inLoaded ) {
+    if( inLoaded == NULL ) {
+        printf( "%s:  cache missed\n", inWhat );
+        numBad++;
+        return;
+        }
+
+    if( inGenerated->mWide != inLoaded->mWide ||
+        inGenerated->mHigh != inLoaded->mHigh ||
+        inGenerated->mNumTextures != inLoaded->mNumTextures ||
+        inGenerated->isBackVisible() != inLoaded->isBackVisible() ||
+        inGenerated->isTransparent() != inLoaded->isTransparent() ) {
+        printf( "%s:  sizes or flags differ\n", inWhat );
+        numBad++;
+        return;
+        }
+
+    int numWrong = 0;
+
+    int i;
+    for( i=0; i<inGenerated->mNumVertices; i++ ) {
+        checkVector( "vertex", i, inGenerated->mVertices[i],
+                     inLoaded->mVertices[i], &numWrong );
+        checkVector( "normal", i, inGenerated->mNormals[i],
+                     inLoaded->mNormals[i], &numWrong );
+
+        for( int t=0; t<inGenerated->mNumTextures; t++ ) {
+            if( fabs( inGenerated->mAnchorX[t][i] -
+                      inLoaded->mAnchorX[t][i] ) > 0.0001 ||
+                fabs( inGenerated->mAnchorY[t][i] -
+                      inLoaded->mAnchorY[t][i] ) > 0.0001 ) {
+                numWrong++;
+                }
+            }
+        }
+
+    int numIndices;
+    unsigned int *indices =
+        inGenerated->getTriangleStripIndices( &numIndices );
+
+    int numPackedIndices = 0;
+    const unsigned int *packedIndices =
+        inLoaded->getPackedTriangleStripIndices( &numPackedIndices );
+
+    if( packedIndices == NULL || numPackedIndices != numIndices ) {
+        printf( "%s:  packed indices missing\n", inWhat );
+        numWrong++;
+        }
+    else {
+        for( i=0; i<numIndices; i++ ) {
+            if( indices[i] != packedIndices[i] ) {
+                numWrong++;
+                }
+            }
+        }
+    delete [] indices;
+
+    const float *packed = inLoaded->getPackedVertexData(
+        inLoaded->mNumTextures );
+
+    if( packed == NULL ) {
+        printf( "%s:  packed vertex data missing\n", inWhat );
+        numWrong++;
+        }
+    else {
+        int n = inLoaded->mNumVertices;
+        for( i=0; i<n; i++ ) {
+            if( packed[ 3 * i ] != (float)( inLoaded->mVertices[i]->mX ) ||
+                packed[ 3 * n + 2 * i ] !=
+                (float)( inLoaded->mAnchorX[0][i] ) ) {
+                numWrong++;
+                }
+            }
+        }
+
+    if( numWrong > 0 ) {
+        printf( "%s:  %d values differ\n", inWhat, numWrong );
+        numBad++;
+        }
+    }
+
+
+
+int main() {
+
+    MeshCache cache( cacheDirectory );
+
+
+    // lathe
+    MeshCacheKey latheKey( "lathe" );
+    LathePrimitive3D *lathe = makeLathe( 31, &latheKey );
+    lathe->setBackVisible( true );
+
+    if( ! cache.putPrimitive( &latheKey, lathe ) ) {
+        printf( "Failed to save lathe\n" );
+        numBad++;
+        }
+
+    RGBAImage *texture = new RGBAImage( 4, 4 );
+    Primitive3D *loaded = cache.getPrimitive( &latheKey, 1, &texture );
+    checkSame( "lathe", lathe, loaded );
+
+    if( loaded != NULL ) {
+        // packed data must not outlive a geometry change
+        loaded->mVertices[0]->mX += 1;
+        loaded->markGeometryChanged();
+
+        int numIndices;
+        if( loaded->getPackedVertexData( 1 ) != NULL ||
+            loaded->getPackedTriangleStripIndices( &numIndices ) != NULL ) {
+            printf( "Packed data returned after geometry change\n" );
+            numBad++;
+            }
+
+        // copies are plain primitives
+        Primitive3D *copy = loaded->copy();
+        if( copy->getPackedVertexData( 1 ) != NULL ) {
+            printf( "Packed data returned by copy\n" );
+            numBad++;
+            }
+        delete copy;
+        delete loaded;
+        }
+
+
+    // misses
+    MeshCacheKey otherKey( "lathe" );
+    delete makeLathe( 15, &otherKey );
+
+    texture = new RGBAImage( 4, 4 );
+    if( cache.getPrimitive( &otherKey, 1, &texture ) != NULL ) {
+        printf( "Hit for a key never saved\n" );
+        numBad++;
+        }
+    if( cache.getPrimitive( &latheKey, 2, &texture ) != NULL ) {
+        printf( "Hit with wrong number of textures\n" );
+        numBad++;
+        }
+    // still ours after misses
+    delete texture;
+
+
+    // landscape, with a detail layer
+    int wide = 64;
+    int high = 64;
+    double *heights = makeHeights( wide, high );
+
+    MeshCacheKey landKey( "landscape" );
+    landKey.add( wide );
+    landKey.add( high );
+    landKey.add( heights, wide * high );
+    landKey.add( 0.25 );
+
+    LandscapePrimitive3D *land =
+        new LandscapePrimitive3D( wide, high, heights,
+                                  new RGBAImage( 4, 4 ),
+                                  new RGBAImage( 4, 4 ), 0.25 );
+    land->setTransparent( true );
+    cache.putPrimitive( &landKey, land );
+
+    RGBAImage *landTextures[2] = { new RGBAImage( 4, 4 ),
+                                   new RGBAImage( 4, 4 ) };
+    loaded = cache.getPrimitive( &landKey, 2, landTextures );
+    checkSame( "landscape", land, loaded );
+
+    if( loaded != NULL && loaded->getPackedVertexData( 3 ) != NULL ) {
+        printf( "Packed data returned for too many layers\n" );
+        numBad++;
+        }
+    delete loaded;
+
+
+    // object, made of both
+    MeshCacheKey objectKey( "object" );
+
+    Primitive3D **primitives = new Primitive3D*[2];
+    Transform3D **transforms = new Transform3D*[2];
+    primitives[0] = lathe;
+    primitives[1] = land;
+    transforms[0] = new Transform3D();
+    transforms[1] = new Transform3D();
+    transforms[1]->translate( new Vector3D( 1, 2, 3 ) );
+
+    Object3D *object = new Object3D( 2, primitives, transforms );
+    cache.putObject( &objectKey, object );
+
+    RGBAImage *objectTextures[3] = { new RGBAImage( 4, 4 ),
+                                     new RGBAImage( 4, 4 ),
+                                     new RGBAImage( 4, 4 ) };
+    Object3D *loadedObject = cache.getObject( &objectKey, 3,
+                                              objectTextures );
+
+    if( loadedObject == NULL || loadedObject->mNumPrimitives != 2 ) {
+        printf( "Object not loaded\n" );
+        numBad++;
+        }
+    else {
+        checkSame( "object lathe", lathe, loadedObject->mPrimitives[0] );
+        checkSame( "object landscape", land, loadedObject->mPrimitives[1] );
+
+        if( memcmp( transforms[1]->getMatrix(),
+                    loadedObject->mTransform[1]->getMatrix(),
+                    16 * sizeof( double ) ) != 0 ) {
+            printf( "Object transform differs\n" );
+            numBad++;
+            }
+        delete loadedObject;
+        }
+
+    // an object's file is not a primitive
+    RGBAImage *leftover[3] = { new RGBAImage( 4, 4 ),
+                               new RGBAImage( 4, 4 ),
+                               new RGBAImage( 4, 4 ) };
+    if( cache.getPrimitive( &objectKey, 3, leftover ) != NULL ) {
+        printf( "Object loaded as primitive\n" );
+        numBad++;
+        }
+    for( int i=0; i<3; i++ ) {
+        delete leftover[i];
+        }
+
+    delete object;
+    delete [] heights;
+
+
+    // timing, a scene of 200 lathes, and a 256x256 landscape
+    int numLathes = 200;
+
+    MeshCacheKey **keys = new MeshCacheKey*[ numLathes ];
+
+    int i;
+    for( i=0; i<numLathes; i++ ) {
+        keys[i] = new MeshCacheKey( "lathe" );
+        lathe = makeLathe( 16 + i, keys[i] );
+        cache.putPrimitive( keys[i], lathe );
+        delete lathe;
+        }
+
+    double startTime = Time::getCurrentTime();
+    for( i=0; i<numLathes; i++ ) {
+        MeshCacheKey key( "lathe" );
+        lathe = makeLathe( 16 + i, &key );
+        delete lathe;
+        }
+    double latheGenerateTime = Time::getCurrentTime() - startTime;
+
+    startTime = Time::getCurrentTime();
+    for( i=0; i<numLathes; i++ ) {
+        texture = new RGBAImage( 4, 4 );
+        loaded = cache.getPrimitive( keys[i], 1, &texture );
+        if( loaded == NULL ) {
+            numBad++;
+            delete texture;
+            }
+        delete loaded;
+        delete keys[i];
+        }
+    double latheLoadTime = Time::getCurrentTime() - startTime;
+    delete [] keys;
+
+    printf( "%d lathes:  generate %.2f ms, load %.2f ms\n",
+            numLathes, latheGenerateTime * 1000, latheLoadTime * 1000 );
+
+
+    wide = 256;
+    high = 256;
+    heights = makeHeights( wide, high );
+
+    landKey = MeshCacheKey( "landscape" );
+    landKey.add( wide );
+    landKey.add( high );
+    landKey.add( heights, wide * high );
+
+    startTime = Time::getCurrentTime();
+    land = new LandscapePrimitive3D( wide, high, heights,
+                                     new RGBAImage( 4, 4 ) );
+    double landGenerateTime = Time::getCurrentTime() - startTime;
+
+    cache.putPrimitive( &landKey, land );
+    delete land;
+
+    startTime = Time::getCurrentTime();
+    texture = new RGBAImage( 4, 4 );
+    loaded = cache.getPrimitive( &landKey, 1, &texture );
+    double landLoadTime = Time::getCurrentTime() - startTime;
+    delete loaded;
+    delete [] heights;
+
+    printf( "%dx%d landscape:  generate %.2f ms, load %.2f ms\n",
+            wide, high, landGenerateTime * 1000, landLoadTime * 1000 );
+
+
+    if( numBad == 0 ) {
+        printf( "All tests passed\n" );
+        return 0;
+        }
+    printf( "%d failures\n", numBad );
+    return 1;
+    }
@@ -6,6 +6,10 @@
  *
  * 2006-October-14   Jason Rohrer
  * Added virtual destructor.
+ *
+ * 2026-October-14   Jason Rohrer
+ * Added optional fast path for compact 8-bit images.
+ * Added applyToChannels for filtering several channels in one pass.
  */
  
  
@@ -24,6 +28,43 @@ class ChannelFilter {
 		virtual void apply( double *inChannel, int inWidth, int inHeight ) = 0;
 
 
+        /**
+         * Filters several same-sized channels.
+         *
+         * The default implementation calls apply on each channel in turn.
+         * Filters that can do better (by sharing passes or threads across
+         * channels) override this.
+         */
+        virtual void applyToChannels( double **inChannels, int inNumChannels,
+                                      int inWidth, int inHeight ) {
+            for( int c=0; c<inNumChannels; c++ ) {
+                apply( inChannels[c], inWidth, inHeight );
+                }
+            }
+
+
+        /**
+         * Filters a channel of a compact 8-bit image (see Image) in place,
+         * without expanding it to doubles.
+         *
+         * Optional.  The default implementation does nothing and returns
+         * false, in which case the image is expanded and apply is called.
+         *
+         * @param inChannel the first value of the channel, where 255
+         *   means 1.0.
+         * @param inPixelStride the distance between successive values
+         *   of the channel (the image's number of channels).
+         * @param inWidth, inHeight the size of the channel.
+         *
+         * @return true if the channel was filtered.
+         */
+        virtual char applyCompact( unsigned char *inChannel, 
+                                   int inPixelStride,
+                                   int inWidth, int inHeight ) {
+            return false;
+            }
+
+
         // ensure proper destruction of subclasses
         virtual ~ChannelFilter() {
             }
@@ -0,0 +1,322 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+
+
+#include "DistanceField.h"
+
+#include <math.h>
+#include <string.h>
+
+
+
+// squared distance for values with nothing to measure to
+#define FIELD_FAR 1e20
+
+
+
+// Felzenszwalb and Huttenlocher's exact squared distance transform, along
+// one row or column, carrying along the index of the nearest feature
+// inF, inI, inV, and inZ are scratch space, inN + 1 long
+static void transformLine( float *inLine, int *inIndex, int inN,
+                           int inStride,
+                           double *inF, int *inI, int *inV, double *inZ ) {
+
+    for( int q=0; q<inN; q++ ) {
+        inF[q] = inLine[ q * inStride ];
+        inI[q] = inIndex[ q * inStride ];
+        }
+
+    // lower envelope of parabolas rooted at each value
+    int k = 0;
+    inV[0] = 0;
+    inZ[0] = -FIELD_FAR;
+    inZ[1] = FIELD_FAR;
+
+    for( int q=1; q<inN; q++ ) {
+        int p = inV[k];
+        double s = ( ( inF[q] + q * q ) - ( inF[p] + p * p ) ) /
+            ( 2 * q - 2 * p );
+
+        while( s <= inZ[k] ) {
+            k--;
+            p = inV[k];
+            s = ( ( inF[q] + q * q ) - ( inF[p] + p * p ) ) /
+                ( 2 * q - 2 * p );
+            }
+
+        k++;
+        inV[k] = q;
+        inZ[k] = s;
+        inZ[k + 1] = FIELD_FAR;
+        }
+
+    k = 0;
+    for( int q=0; q<inN; q++ ) {
+        while( inZ[ k + 1 ] < q ) {
+            k++;
+            }
+        int p = inV[k];
+        inLine[ q * inStride ] = (float)( ( q - p ) * ( q - p ) + inF[p] );
+        inIndex[ q * inStride ] = inI[p];
+        }
+    }
+
+
+
+// Gustavson's distance from a partly covered value's center to the edge
+// crossing it, for an edge with gradient inGX, inGY, given coverage inA
+// positive if center is outside
+static double edgeDistance( double inGX, double inGY, double inA ) {
+    if( inGX == 0 || inGY == 0 ) {
+        return 0.5 - inA;
+        }
+
+    double length = sqrt( inGX * inGX + inGY * inGY );
+    double gx = fabs( inGX ) / length;
+    double gy = fabs( inGY ) / length;
+
+    if( gx < gy ) {
+        double temp = gx;
+        gx = gy;
+        gy = temp;
+        }
+
+    double a1 = 0.5 * gy / gx;
+
+    if( inA < a1 ) {
+        return 0.5 * ( gx + gy ) - sqrt( 2 * gx * gy * inA );
+        }
+    else if( inA < 1 - a1 ) {
+        return ( 0.5 - inA ) * gx;
+        }
+    return -0.5 * ( gx + gy ) + sqrt( 2 * gx * gy * ( 1 - inA ) );
+    }
+
+
+
+unsigned char *makeDistanceField( const unsigned char *inCoverage,
+                                  int inStride,
+                                  int inWidth, int inHeight,
+                                  int inDownsample, int inPadding,
+                                  int *outWidth, int *outHeight ) {
+
+    int d = inDownsample;
+
+    int fieldW = ( inWidth + d - 1 ) / d + 2 * inPadding;
+    int fieldH = ( inHeight + d - 1 ) / d + 2 * inPadding;
+
+    // mask with padding, full resolution
+    int w = fieldW * d;
+    int h = fieldH * d;
+    int numValues = w * h;
+    int offset = inPadding * d;
+
+    unsigned char *coverage = new unsigned char[ numValues ];
+    memset( coverage, 0, numValues );
+
+    for( int y=0; y<inHeight; y++ ) {
+        unsigned char *dest = &( coverage[ ( y + offset ) * w + offset ] );
+        const unsigned char *source =
+            &( inCoverage[ y * inWidth * inStride ] );
+
+        for( int x=0; x<inWidth; x++ ) {
+            dest[x] = source[ x * inStride ];
+            }
+        }
+
+
+    // the edge passes through values that are partly covered, or lies
+    // between empty and full values
+    // each one's nearest point on the edge is found from its coverage
+    // and the coverage gradient around it
+    float *edgeX = new float[ numValues ];
+    float *edgeY = new float[ numValues ];
+
+    float *toEdge = new float[ numValues ];
+    int *nearest = new int[ numValues ];
+
+    for( int y=0; y<h; y++ ) {
+        for( int x=0; x<w; x++ ) {
+            int i = y * w + x;
+
+            nearest[i] = i;
+            toEdge[i] = FIELD_FAR;
+
+            unsigned char c = coverage[i];
+
+            char onEdge = ( c > 0 && c < 255 );
+
+            // gradient of coverage, toward inside
+            double gx = 0;
+            double gy = 0;
+
+            for( int dy=-1; dy<=1; dy++ ) {
+                for( int dx=-1; dx<=1; dx++ ) {
+                    int nx = x + dx;
+                    int ny = y + dy;
+
+                    if( nx < 0 || nx >= w || ny < 0 || ny >= h ||
+                        ( dx == 0 && dy == 0 ) ) {
+                        continue;
+                        }
+
+                    unsigned char n = coverage[ ny * w + nx ];
+
+                    if( n == 255 - c && ( dx == 0 || dy == 0 ) ) {
+                        // hard edge, no partly covered values
+                        onEdge = true;
+                        }
+
+                    // Sobel weights
+                    double weight = ( dx == 0 || dy == 0 ) ? 2 : 1;
+                    gx += dx * weight * n;
+                    gy += dy * weight * n;
+                    }
+                }
+
+            if( ! onEdge ) {
+                continue;
+                }
+
+            toEdge[i] = 0;
+
+            double length = sqrt( gx * gx + gy * gy );
+
+            double offsetX = 0;
+            double offsetY = 0;
+
+            if( length > 0 ) {
+                double dist = edgeDistance( gx, gy, c / 255.0 );
+
+                offsetX = dist * gx / length;
+                offsetY = dist * gy / length;
+                }
+
+            edgeX[i] = (float)( x + offsetX );
+            edgeY[i] = (float)( y + offsetY );
+            }
+        }
+
+
+    // nearest edge value to each value
+    int n = ( w > h ? w : h ) + 1;
+
+    double *f = new double[ n ];
+    int *index = new int[ n ];
+    int *v = new int[ n ];
+    double *z = new double[ n ];
+
+    for( int x=0; x<w; x++ ) {
+        transformLine( &( toEdge[x] ), &( nearest[x] ), h, w,
+                       f, index, v, z );
+        }
+    for( int y=0; y<h; y++ ) {
+        transformLine( &( toEdge[ y * w ] ), &( nearest[ y * w ] ), w, 1,
+                       f, index, v, z );
+        }
+
+    delete [] f;
+    delete [] index;
+    delete [] v;
+    delete [] z;
+
+
+    // signed distance from each value's center to the nearest edge point
+    float *distance = toEdge;
+
+    for( int y=0; y<h; y++ ) {
+        for( int x=0; x<w; x++ ) {
+            int i = y * w + x;
+
+            double dist;
+
+            if( distance[i] >= FIELD_FAR ) {
+                // no edge anywhere
+                dist = FIELD_FAR;
+                }
+            else {
+                // the value with the nearest center isn't always the one
+                // with the nearest edge point, so try the ones nearest to
+                // neighbors too
+                double best = FIELD_FAR;
+
+                for( int ny=y-1; ny<=y+1; ny++ ) {
+                    for( int nx=x-1; nx<=x+1; nx++ ) {
+                        if( nx < 0 || nx >= w || ny < 0 || ny >= h ) {
+                            continue;
+                            }
+
+                        int e = nearest[ ny * w + nx ];
+                        double dx = edgeX[e] - x;
+                        double dy = edgeY[e] - y;
+
+                        double d2 = dx * dx + dy * dy;
+                        if( d2 < best ) {
+                            best = d2;
+                            }
+                        }
+                    }
+
+                dist = sqrt( best );
+                }
+
+            if( coverage[i] <= 127 ) {
+                dist = -dist;
+                }
+
+            distance[i] = (float)dist;
+            }
+        }
+
+    delete [] edgeX;
+    delete [] edgeY;
+    delete [] nearest;
+    delete [] coverage;
+
+
+    unsigned char *field = new unsigned char[ fieldW * fieldH ];
+    for( int fy=0; fy<fieldH; fy++ ) {
+        // texel center, in value centers
+        double y = ( fy + 0.5 ) * d - 0.5;
+        int y0 = (int)floor( y );
+        int y1 = ( y0 + 1 < h ) ? y0 + 1 : y0;
+        double wy = y - y0;
+
+        for( int fx=0; fx<fieldW; fx++ ) {
+            double x = ( fx + 0.5 ) * d - 0.5;
+            int x0 = (int)floor( x );
+            int x1 = ( x0 + 1 < w ) ? x0 + 1 : x0;
+            double wx = x - x0;
+
+            double top = distance[ y0 * w + x0 ] * ( 1 - wx ) +
+                distance[ y0 * w + x1 ] * wx;
+            double bottom = distance[ y1 * w + x0 ] * ( 1 - wx ) +
+                distance[ y1 * w + x1 ] * wx;
+
+            // in field texels
+            double dist = ( top * ( 1 - wy ) + bottom * wy ) / d;
+
+            double v = 127.5 + dist * 127.5 / DISTANCE_FIELD_SPREAD;
+
+            if( v < 0 ) {
+                v = 0;
+                }
+            else if( v > 255 ) {
+                v = 255;
+                }
+            field[ fy * fieldW + fx ] = (unsigned char)( v + 0.5 );
+            }
+        }
+
+    delete [] distance;
+
+    *outWidth = fieldW;
+    *outHeight = fieldH;
+
+    return field;
+    }
@@ -0,0 +1,65 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+
+
+#ifndef DISTANCE_FIELD_INCLUDED
+#define DISTANCE_FIELD_INCLUDED
+
+
+
+/**
+ * Signed distance fields of coverage masks (glyphs, mostly), so that one
+ * small texture can be drawn with clean edges at any scale (see
+ * toggleDistanceFieldTextures in gameGraphics.h).
+ *
+ * A field byte is 128 on the shape's edge, rising to 255 at
+ * DISTANCE_FIELD_SPREAD field texels inside, and falling to 0 at
+ * DISTANCE_FIELD_SPREAD texels outside.  As with coverage, bytes above 127
+ * are inside, so code that looks for ink in coverage works on fields too.
+ *
+ * A field made from a mask drawn at several times its final size (and
+ * downsampled here) holds edges much better than one made at final size.
+ *
+ * @author Jason Rohrer
+ */
+
+
+
+// in field texels
+// small, so that bilinear filtering between the texels on either side of
+// an edge still lands on the edge, and the drawn ramp can be sharpened to
+// a pixel with only 4x alpha scaling
+#define DISTANCE_FIELD_SPREAD 1.0
+
+
+
+/**
+ * Makes a distance field.
+ *
+ * @param inCoverage coverage bytes, rows in either order (field rows come
+ *   out in the same order).  Destroyed by caller.
+ * @param inStride bytes from one coverage value to the next, 1 for a
+ *   plain mask, 4 to read one channel of RGBA.
+ * @param inWidth, inHeight size of mask in values.
+ * @param inDownsample mask values per field texel in each direction.
+ *   Mask sizes that aren't a multiple are rounded up with empty values.
+ * @param inPadding empty field texels added on each side, so that the
+ *   outer ramp of shapes touching the mask's edge isn't cut off.
+ * @param outWidth, outHeight set to size of field.
+ *
+ * @return field bytes, one per texel.  Destroyed by caller.
+ */
+unsigned char *makeDistanceField( const unsigned char *inCoverage,
+                                  int inStride,
+                                  int inWidth, int inHeight,
+                                  int inDownsample, int inPadding,
+                                  int *outWidth, int *outHeight );
+
+
+
+#endif
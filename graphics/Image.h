@@ -47,6 +47,17 @@
  *
  * 2015-June-29     Jason Rohrer
  * Added image expansion function.  
+ *
+ * 2026-October-14     Jason Rohrer
+ * Added compact 8-bit storage mode that is expanded to doubles on demand.
+ * filter( ChannelFilter* ) now passes all channels to the filter at once.
+ *
+ * 2026-October-15     Jason Rohrer
+ * Serialization writes header in one call and reuses its channel buffer.
+ * Masked pastes blend with SSE2/NEON, and paste works through all channels
+ * a block of pixels at a time.  copyChannel, setSubImage, paste, and
+ * expandImage read compact images without expanding them, and
+ * expandImage only fills the border.
  */
  
  
@@ -62,12 +73,33 @@
 
 #include "minorGems/io/Serializable.h"
 
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || \
+    ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+	#define IMAGE_SSE2
+	#include <emmintrin.h>
+#elif defined( __aarch64__ )
+	#define IMAGE_NEON
+	#include <arm_neon.h>
+#endif
+
+
+// pixels pasted at a time, through all channels, so that a mask shared
+// by the channels is still in cache for each of them
+#define IMAGE_PASTE_BLOCK_PIXELS 2048
+
  
 /**
  * A multi-channel, double-valued image.
  *
  * Is Serializable.  Note that a serialized image doesn't have a selection.
  *
+ * An image can also be held in compact form, as interleaved 8-bit values
+ * (1/8 the memory).  A compact image is expanded to double channels the
+ * first time something needs them (getChannel, most editing functions),
+ * and stays expanded after that.  Functions that have compact fast paths
+ * are noted below.
+ *
  * @author Jason Rohrer 
  */
 class Image : public Serializable { 
@@ -88,6 +120,20 @@ class Image : public Serializable {
 		Image( int inWidth, int inHeight, int inNumChannels,
                char inStartPixelsAtZero = true );
 		
+
+        /**
+         * Constructs a compact image from 8-bit values.
+         *
+         * @param inBytes the pixel values, with channels interleaved
+         *   (for example, RGBARGBA...), where 255 means 1.0.
+         *   NOT copied internally, and destroyed when this image is
+         *   destroyed or expanded.
+         * @param inWidth, inHeight, inNumChannels the image dimensions.
+         */
+        Image( unsigned char *inBytes, int inWidth, int inHeight, 
+               int inNumChannels );
+        
+
 		
 		virtual ~Image();
 		
@@ -102,6 +148,8 @@ class Image : public Serializable {
 		 *
 		 * Values are not copied.
 		 *
+		 * Expands a compact image.
+		 *
 		 * @param inChannel the channel to get.
 		 * 
 		 * @return the values of the specified channel in row-major order.
@@ -109,11 +157,27 @@ class Image : public Serializable {
 		virtual double *getChannel( int inChannel );
         
 
+        // true if image is in compact 8-bit form
+        char isCompact() {
+            return ( mBytes != NULL );
+            }
+        
+        
+        // gets interleaved 8-bit values of a compact image, or NULL
+        // if image is not compact
+        // Values are not copied, and are only valid until image is expanded.
+        unsigned char *getCompactBytes() {
+            return mBytes;
+            }
+        
+
 
         /**
          * Gets the 3- or 4-channel color value at a given location in the 
          * image.
          *
+         * Does not expand a compact image.
+         *
          * @param inIndex the image index.
          *
          * @return a color object.
@@ -126,6 +190,8 @@ class Image : public Serializable {
          * Sets the 3- or 4-channel color value at a given location in the 
          * image.
          *
+         * Does not expand a compact image (color is rounded to 8 bits).
+         *
          * @param inIndex the image index.
          * @param inColor the new color to set.
          */
@@ -180,6 +246,9 @@ class Image : public Serializable {
 		 * Applies a filter to the selected region of 
 		 * a specified channel of this image.
 		 *
+		 * Does not expand a compact image with no selection if filter
+		 * supports ChannelFilter::applyCompact.
+		 *
 		 * @param inFilter the filter to apply.
 		 * @param inChannel the channel to filter.
 		 */
@@ -204,6 +273,7 @@ class Image : public Serializable {
 		 *   as this image, each containing the selected region
 		 *   from each corresponding channel of this image.  Unselected
 		 *   regions are set to black.  Returned image has no selection.
+		 *   A compact image with no selection gives a compact copy.
 		 */
 		Image *copy();
 		
@@ -212,6 +282,9 @@ class Image : public Serializable {
 		 * Pastes the selected region from another image into
 		 * the selected region of this image.
 		 *
+		 * Does not expand a compact inImage when neither image has a
+		 * selection, and keeps this image compact if both are compact.
+		 *
 		 * @param inImage the image to paste.  Let c be the number
 		 *   of channels in this image, and cp be the number
 		 *   of channels in the image being pasted.
@@ -225,6 +298,8 @@ class Image : public Serializable {
 		/**
 		 * Copies the data from the selected region of a channel.
 		 *
+		 * Does not expand a compact image.
+		 *
 		 * @param inChannel the channel to copy.
 		 *
 		 * @return a copy of the channel data.  Must be destroyed
@@ -264,6 +339,8 @@ class Image : public Serializable {
          *
          * Ignores current selection.
          *
+         * A compact image gives a compact sub-image.
+         *
          * @param inStartX, inStartY, inWidth, inHeight
          *   coordinates for the top left corner pixel of the sub-image
          *   and the width and height of the sub-image.
@@ -277,6 +354,8 @@ class Image : public Serializable {
         // copies region from source into this image, placing
         // upper left corner of source at inStartX, inStartY in this image
         // and copying inWidth by inHeight pixels
+        // Does not expand a compact source, and keeps this image compact
+        // if both are compact with the same number of channels.
         void setSubImage( int inStartX, int inStartY, 
                           int inWidth, int inHeight,
                           Image *inSourceImage );
@@ -285,6 +364,7 @@ class Image : public Serializable {
 
         // centers this image in a new, larger image with a black or white
         // border
+        // A compact image gives a compact result.
         Image *expandImage( int inExpandedWidth, int inExpandedHeight,
                             char inWhiteBorder = false );
 
@@ -299,6 +379,8 @@ class Image : public Serializable {
          * Note that if a 4-channel image is passed in, the existing alpha
          * channel will be replaced in the returned image.
          *
+         * A compact image gives a compact result.
+         *
          * @return a new 4-channel image.  Must be destoryed by caller.
          */
         Image *generateAlphaChannel();
@@ -310,14 +392,37 @@ class Image : public Serializable {
      
 		
 		// implement the Serializable interface
+        // serialize does not expand a compact image, and deserialize
+        // produces a compact image
 		virtual int serialize( OutputStream *inOutputStream );
 		virtual int deserialize( InputStream *inInputStream );
 	
 	protected:
 		long mWide, mHigh, mNumPixels, mNumChannels;
 		
+		// NULL if image is compact
 		double **mChannels;
 		
+        // interleaved 8-bit values if compact, NULL otherwise
+        unsigned char *mBytes;
+        
+
+        // switches compact image over to double channels
+        // does nothing if image is not compact
+        void expand() {
+            if( mBytes != NULL ) {
+                expandCompact();
+                }
+            }
+        
+        void expandCompact();
+        
+
+        // filters first inNumChannels channels, all in one pass if
+        // nothing is selected
+        void filterChannels( ChannelFilter *inFilter, int inNumChannels );
+        
+
 		// NULL if nothing selected.
 		Image *mSelection;
 		
@@ -338,6 +443,12 @@ class Image : public Serializable {
 		virtual void pasteChannel( double *inChannelData, double *inMask,
 			int inChannel );
 		
+		
+		// pastes pixels [inStart, inEnd) of masked channel data, as above
+		// image must not be compact
+		void pasteChannelRange( double *inChannelData, double *inMask,
+								int inChannel, int inStart, int inEnd );
+		
 	};
 
 
@@ -346,7 +457,7 @@ inline Image::Image( int inWidth, int inHeight, int inNumChannels,
                      char inStartPixelsAtZero ) 
 	: mWide( inWidth ), mHigh( inHeight ), mNumPixels( inWidth * inHeight ),
 	mNumChannels( inNumChannels ), mChannels( new double*[inNumChannels] ),
-	mSelection( NULL ) {
+	mBytes( NULL ), mSelection( NULL ) {
 	
 	// initialize all channels
 	for( int i=0; i<mNumChannels; i++ ) {
@@ -359,12 +470,49 @@ inline Image::Image( int inWidth, int inHeight, int inNumChannels,
 		
 		
 		
+inline Image::Image( unsigned char *inBytes, int inWidth, int inHeight,
+                     int inNumChannels )
+	: mWide( inWidth ), mHigh( inHeight ), mNumPixels( inWidth * inHeight ),
+	mNumChannels( inNumChannels ), mChannels( NULL ),
+	mBytes( inBytes ), mSelection( NULL ) {
+    }
+
+
+
 inline Image::~Image() {
-	for( int i=0; i<mNumChannels; i++ ) {
-		delete [] mChannels[i];
-		}
-	delete [] mChannels;	
+    if( mChannels != NULL ) {
+        for( int i=0; i<mNumChannels; i++ ) {
+            delete [] mChannels[i];
+            }
+        delete [] mChannels;
+        }
+    if( mBytes != NULL ) {
+        delete [] mBytes;
+        }
 	}
+
+
+
+inline void Image::expandCompact() {
+    mChannels = new double*[ mNumChannels ];
+    
+    double inv255 = 1.0 / 255.0;
+    
+	for( int c=0; c<mNumChannels; c++ ) {
+		double *channel = new double[ mNumPixels ];
+        
+        unsigned char *source = &( mBytes[c] );
+        
+        for( int p=0; p<mNumPixels; p++ ) {
+            channel[p] = inv255 * *source;
+            source += mNumChannels;
+            }
+        mChannels[c] = channel;
+        }
+    
+    delete [] mBytes;
+    mBytes = NULL;
+    }
 		
 
 
@@ -387,6 +535,7 @@ inline long Image::getNumChannels() {
 	
 		
 inline double *Image::getChannel( int inChannel ) {
+    expand();
 	return mChannels[ inChannel ];
 	}
 	
@@ -395,6 +544,15 @@ inline double *Image::getChannel( int inChannel ) {
 inline Color Image::getColor( int inIndex ) {
     Color c;
     
+    if( mBytes != NULL ) {
+        unsigned char *pixel = &( mBytes[ inIndex * mNumChannels ] );
+        
+        for( int i=0; i<mNumChannels && i < 4; i++ ) {
+            c[i] = pixel[i] / 255.0f;
+            }
+        return c;
+        }
+
     for( int i=0; i<mNumChannels && i < 4; i++ ) {
         c[i] = (float)( mChannels[i][inIndex] );
         }
@@ -405,6 +563,22 @@ inline Color Image::getColor( int inIndex ) {
 
 
 inline void Image::setColor( int inIndex, Color inColor ) {
+    if( mBytes != NULL ) {
+        unsigned char *pixel = &( mBytes[ inIndex * mNumChannels ] );
+        
+        for( int i=0; i<mNumChannels && i < 4; i++ ) {
+            long v = lrint( inColor[i] * 255 );
+            if( v < 0 ) {
+                v = 0;
+                }
+            else if( v > 255 ) {
+                v = 255;
+                }
+            pixel[i] = (unsigned char)v;
+            }
+        return;
+        }
+    
     for( int i=0; i<mNumChannels && i < 4; i++ ) {
         mChannels[i][inIndex] = (double)( inColor[i] );
         }
@@ -432,6 +606,15 @@ inline void Image::clearSelection() {
 		
 inline void Image::filter( ChannelFilter *inFilter, int inChannel ) {
 
+    if( mBytes != NULL && mSelection == NULL ) {
+        if( inFilter->applyCompact( &( mBytes[ inChannel ] ), mNumChannels,
+                                    mWide, mHigh ) ) {
+            return;
+            }
+        }
+    
+    expand();
+    
 	if( mSelection == NULL ) {
 		inFilter->apply( mChannels[ inChannel ], mWide, mHigh );
 		}
@@ -452,14 +635,47 @@ inline void Image::filter( ChannelFilter *inFilter, int inChannel ) {
 	
 		
 inline void Image::filter( ChannelFilter *inFilter ) {
-	for( int i=0; i<mNumChannels; i++ ) {
-		filter( inFilter, i );
-		}	
+	filterChannels( inFilter, mNumChannels );
+	}
+
+
+
+inline void Image::filterChannels( ChannelFilter *inFilter, 
+                                   int inNumChannels ) {
+    if( mSelection != NULL ) {
+        for( int i=0; i<inNumChannels; i++ ) {
+            filter( inFilter, i );
+            }
+        return;
+        }
+    
+    if( mBytes != NULL && inNumChannels > 0 &&
+        inFilter->applyCompact( mBytes, mNumChannels, mWide, mHigh ) ) {
+        // filter supports compact images, do the rest the same way
+        for( int i=1; i<inNumChannels; i++ ) {
+            filter( inFilter, i );
+            }
+        return;
+        }
+    
+    expand();
+    
+    // all channels in one pass
+    inFilter->applyToChannels( mChannels, inNumChannels, mWide, mHigh );
 	}
 
 
 
 inline Image *Image::copy() {
+    if( mBytes != NULL && mSelection == NULL ) {
+        int numBytes = mNumPixels * mNumChannels;
+        
+        unsigned char *bytes = new unsigned char[ numBytes ];
+        memcpy( bytes, mBytes, numBytes );
+        
+        return new Image( bytes, mWide, mHigh, mNumChannels );
+        }
+    
 	Image *copiedImage = new Image( mWide, mHigh, mNumChannels );
 	copiedImage->paste( this );
 	
@@ -475,30 +691,231 @@ inline void Image::paste( Image *inImage ) {
 		numChannelsToPaste = inImage->getNumChannels();
 		}
 	
+	if( numChannelsToPaste <= 0 ) {
+		return;
+		}
+	
+	int sourceNumChannels = inImage->getNumChannels();
+	
+	if( mSelection == NULL && inImage->getSelection() == NULL &&
+		inImage->isCompact() ) {
+		
+		unsigned char *sourceBytes = inImage->getCompactBytes();
+		
+		if( mBytes != NULL ) {
+			// both compact, copy bytes
+			if( sourceNumChannels == mNumChannels ) {
+				memcpy( mBytes, sourceBytes, mNumPixels * mNumChannels );
+				}
+			else {
+				unsigned char *source = sourceBytes;
+				unsigned char *dest = mBytes;
+				
+				for( int p=0; p<mNumPixels; p++ ) {
+					memcpy( dest, source, numChannelsToPaste );
+					source += sourceNumChannels;
+					dest += mNumChannels;
+					}
+				}
+			return;
+			}
+		
+		// convert source bytes straight into our channels, in one pass
+		double inv255 = 1.0 / 255.0;
+		unsigned char *source = sourceBytes;
+		
+		for( int p=0; p<mNumPixels; p++ ) {
+			for( int c=0; c<numChannelsToPaste; c++ ) {
+				mChannels[c][p] = inv255 * source[c];
+				}
+			source += sourceNumChannels;
+			}
+		return;
+		}
+	
+	expand();
+	
+	double **sourceChannels = new double*[ numChannelsToPaste ];
+	double **sourceMasks = new double*[ numChannelsToPaste ];
+	
 	for( int i=0; i<numChannelsToPaste; i++ ) {
-		pasteChannel( inImage->getChannel(i), 
-			inImage->getChannelSelection(i), i );
+		sourceChannels[i] = inImage->getChannel( i );
+		sourceMasks[i] = inImage->getChannelSelection( i );
 		}
+	
+	// all channels a block at a time, while masks are in cache
+	for( int start=0; start<mNumPixels; start += IMAGE_PASTE_BLOCK_PIXELS ) {
+		int end = start + IMAGE_PASTE_BLOCK_PIXELS;
+		if( end > mNumPixels ) {
+			end = mNumPixels;
+			}
+		
+		for( int i=0; i<numChannelsToPaste; i++ ) {
+			pasteChannelRange( sourceChannels[i], sourceMasks[i], i,
+							   start, end );
+			}
+		}
+	
+	delete [] sourceChannels;
+	delete [] sourceMasks;
 	}
 
 
 
-inline double *Image::copyChannel( int inChannel ) {
+// outA[i] = inA[i] * inB[i], for i in [inStart, inEnd)
+static inline void imageMultiplyRange( double *outA, double *inA,
+									   double *inB,
+									   int inStart, int inEnd ) {
+	int i = inStart;
+	
+#if defined( IMAGE_SSE2 )
+	for( ; i + 2 <= inEnd; i += 2 ) {
+		_mm_storeu_pd( &( outA[i] ),
+					   _mm_mul_pd( _mm_loadu_pd( &( inA[i] ) ),
+								   _mm_loadu_pd( &( inB[i] ) ) ) );
+		}
+#elif defined( IMAGE_NEON )
+	for( ; i + 2 <= inEnd; i += 2 ) {
+		vst1q_f64( &( outA[i] ),
+				   vmulq_f64( vld1q_f64( &( inA[i] ) ),
+							  vld1q_f64( &( inB[i] ) ) ) );
+		}
+#endif
+	
+	for( ; i<inEnd; i++ ) {
+		outA[i] = inA[i] * inB[i];
+		}
+	}
+
+
+
+// ioA[i] = ioA[i] * ( 1 - inMask[i] ) + inB[i] * inMask[i],
+// for i in [inStart, inEnd)
+static inline void imageBlendRange( double *ioA, double *inB,
+									double *inMask,
+									int inStart, int inEnd ) {
+	int i = inStart;
+	
+#if defined( IMAGE_SSE2 )
+	__m128d one = _mm_set1_pd( 1.0 );
+	
+	for( ; i + 2 <= inEnd; i += 2 ) {
+		__m128d a = _mm_loadu_pd( &( ioA[i] ) );
+		__m128d b = _mm_loadu_pd( &( inB[i] ) );
+		__m128d m = _mm_loadu_pd( &( inMask[i] ) );
+		
+		_mm_storeu_pd( &( ioA[i] ),
+					   _mm_add_pd( _mm_mul_pd( a, _mm_sub_pd( one, m ) ),
+								   _mm_mul_pd( b, m ) ) );
+		}
+#elif defined( IMAGE_NEON )
+	float64x2_t one = vdupq_n_f64( 1.0 );
+	
+	for( ; i + 2 <= inEnd; i += 2 ) {
+		float64x2_t a = vld1q_f64( &( ioA[i] ) );
+		float64x2_t b = vld1q_f64( &( inB[i] ) );
+		float64x2_t m = vld1q_f64( &( inMask[i] ) );
+		
+		vst1q_f64( &( ioA[i] ),
+				   vaddq_f64( vmulq_f64( a, vsubq_f64( one, m ) ),
+							  vmulq_f64( b, m ) ) );
+		}
+#endif
+	
+	for( ; i<inEnd; i++ ) {
+		ioA[i] = ioA[i] * ( 1 - inMask[i] ) + inB[i] * inMask[i];
+		}
+	}
+
+
+
+// blends inB into ioA with inMask, and that result into ioA with
+// inSelection:
+// ioA[i] = ioA[i] * ( 1 - inSelection[i] ) +
+//          ( ioA[i] * ( 1 - inMask[i] ) + inB[i] * inMask[i] ) *
+//          inSelection[i],
+// for i in [inStart, inEnd)
+static inline void imageBlendTwiceRange( double *ioA, double *inB,
+										 double *inMask, double *inSelection,
+										 int inStart, int inEnd ) {
+	int i = inStart;
 	
-	// first, copy the channel
+#if defined( IMAGE_SSE2 )
+	__m128d one = _mm_set1_pd( 1.0 );
+	
+	for( ; i + 2 <= inEnd; i += 2 ) {
+		__m128d a = _mm_loadu_pd( &( ioA[i] ) );
+		__m128d b = _mm_loadu_pd( &( inB[i] ) );
+		__m128d m = _mm_loadu_pd( &( inMask[i] ) );
+		__m128d s = _mm_loadu_pd( &( inSelection[i] ) );
+		
+		__m128d masked = 
+			_mm_add_pd( _mm_mul_pd( a, _mm_sub_pd( one, m ) ),
+						_mm_mul_pd( b, m ) );
+		
+		_mm_storeu_pd( &( ioA[i] ),
+					   _mm_add_pd( _mm_mul_pd( a, _mm_sub_pd( one, s ) ),
+								   _mm_mul_pd( masked, s ) ) );
+		}
+#elif defined( IMAGE_NEON )
+	float64x2_t one = vdupq_n_f64( 1.0 );
+	
+	for( ; i + 2 <= inEnd; i += 2 ) {
+		float64x2_t a = vld1q_f64( &( ioA[i] ) );
+		float64x2_t b = vld1q_f64( &( inB[i] ) );
+		float64x2_t m = vld1q_f64( &( inMask[i] ) );
+		float64x2_t s = vld1q_f64( &( inSelection[i] ) );
+		
+		float64x2_t masked = 
+			vaddq_f64( vmulq_f64( a, vsubq_f64( one, m ) ),
+					   vmulq_f64( b, m ) );
+		
+		vst1q_f64( &( ioA[i] ),
+				   vaddq_f64( vmulq_f64( a, vsubq_f64( one, s ) ),
+							  vmulq_f64( masked, s ) ) );
+		}
+#endif
+	
+	for( ; i<inEnd; i++ ) {
+		ioA[i] = ( ioA[i] * ( 1 - inSelection[i] )
+				   + 
+				   ( ioA[i] * ( 1 - inMask[i] ) 
+					 + inB[i] * inMask[i] ) * inSelection[i] );
+		}
+	}
+
+
+
+inline double *Image::copyChannel( int inChannel ) {
 	double *copiedChannel = new double[mNumPixels];
-	memcpy( copiedChannel, 
-		mChannels[inChannel], sizeof( double ) * mNumPixels );
 	
+	double *selection = getChannelSelection( inChannel );
 	
-	if( mSelection != NULL ) {
-		// apply selection to copied channel
-		double *selection = getChannelSelection( inChannel );	
+	if( mBytes != NULL ) {
+		// convert straight from bytes, without expanding
+		double inv255 = 1.0 / 255.0;
+		unsigned char *source = &( mBytes[ inChannel ] );
 		
-		// scale copied channel with selection
-		for( int i=0; i<mNumPixels; i++ ) {
-			copiedChannel[i] = copiedChannel[i] * selection[i];
+		for( int p=0; p<mNumPixels; p++ ) {
+			copiedChannel[p] = inv255 * *source;
+			source += mNumChannels;
+			}
+		
+		if( selection != NULL ) {
+			imageMultiplyRange( copiedChannel, copiedChannel, selection,
+								0, mNumPixels );
 			}
+		return copiedChannel;
+		}
+	
+	if( selection != NULL ) {
+		// copy and scale with selection in one pass
+		imageMultiplyRange( copiedChannel, mChannels[inChannel], selection,
+							0, mNumPixels );
+		}
+	else {
+		memcpy( copiedChannel, 
+				mChannels[inChannel], sizeof( double ) * mNumPixels );
 		}
 	
 	return copiedChannel;	
@@ -530,47 +947,46 @@ inline void Image::pasteChannel( double *inChannelData, int inChannel ) {
 
 
 
-// We've abstracted away the complexity in the other fuctions,
-// but it all seemed to filter down into this function, which
-// is very messy.
 inline void Image::pasteChannel( double *inChannelData, double *inMask,
 	int inChannel ) {
 	
+    expand();
+    
+	pasteChannelRange( inChannelData, inMask, inChannel, 0, mNumPixels );
+	}
+
+
+
+inline void Image::pasteChannelRange( double *inChannelData, double *inMask,
+									  int inChannel, int inStart, int inEnd ) {
+	
 	double *thisChannel = mChannels[inChannel];
-	if( mSelection != NULL ) {
-		// scale incoming data with this selection
-		double *selection = getChannelSelection(inChannel);
-		
+	
+	// NULL if no selection in this image
+	double *selection = getChannelSelection( inChannel );
+	
+	if( selection != NULL ) {
 		if( inMask != NULL ) {
 			// scale incoming data with both masks
-			for( int i=0; i<mNumPixels; i++ ) {
-				thisChannel[i] = ( thisChannel[i] * (1-selection[i])
-					+ 
-					( thisChannel[i] * (1-inMask[i]) 
-						+ inChannelData[i] * inMask[i] ) * selection[i] );
-				}
+			imageBlendTwiceRange( thisChannel, inChannelData, inMask,
+								  selection, inStart, inEnd );
 			}
 		else {	
 			// scale incomming data with this selecition only
-			for( int i=0; i<mNumPixels; i++ ) {
-				thisChannel[i] = ( thisChannel[i] * (1-selection[i])
-					+ inChannelData[i] * selection[i] );
-				}
+			imageBlendRange( thisChannel, inChannelData, selection,
+							 inStart, inEnd );
 			}
 		}
-	else {	// no selection in this image
-		if( inMask != NULL ) {
-			// scale incoming data with its masks
-			for( int i=0; i<mNumPixels; i++ ) {
-				thisChannel[i] = thisChannel[i] * (1-inMask[i]) 
-					+ inChannelData[i] * inMask[i];
-				}
-			}
-		else {
-			// copy channel directly, with no mask
-			memcpy( thisChannel, inChannelData, sizeof(double) * mNumPixels );
-			}
-		}	
+	else if( inMask != NULL ) {
+		// scale incoming data with its masks
+		imageBlendRange( thisChannel, inChannelData, inMask,
+						 inStart, inEnd );
+		}
+	else {
+		// copy channel directly, with no mask
+		memcpy( &( thisChannel[inStart] ), &( inChannelData[inStart] ),
+				sizeof(double) * ( inEnd - inStart ) );
+		}
 	}
 
 
@@ -580,12 +996,44 @@ inline Image *Image::getSubImage( int inStartX, int inStartY,
     
     int endY = inStartY + inHeight;
     
+    // full rows are one contiguous block
+    char fullRows = ( inStartX == 0 && inWidth == mWide );
+    
+    if( mBytes != NULL ) {
+        int rowBytes = inWidth * mNumChannels;
+        
+        unsigned char *bytes = new unsigned char[ inHeight * rowBytes ];
+        
+        if( fullRows ) {
+            memcpy( bytes, &( mBytes[ inStartY * rowBytes ] ),
+                    inHeight * rowBytes );
+            }
+        else {
+            int destY=0;
+            for( int y=inStartY; y<endY; y++ ) {
+                memcpy( &( bytes[ destY * rowBytes ] ),
+                        &( mBytes[ ( y * mWide + inStartX ) * 
+                                   mNumChannels ] ),
+                        rowBytes );
+                destY ++;
+                }
+            }
+        
+        return new Image( bytes, inWidth, inHeight, mNumChannels );
+        }
+
     Image *destImage = new Image( inWidth, inHeight, mNumChannels, false );
 
     for( int c=0; c<mNumChannels; c++ ) {
         double *destChannel = destImage->getChannel( c );
         double *sourceChannel = mChannels[c];
         
+        if( fullRows ) {
+            memcpy( destChannel, &( sourceChannel[ inStartY * mWide ] ),
+                    sizeof( double ) * inWidth * inHeight );
+            continue;
+            }
+        
         int destY=0;
         for( int y=inStartY; y<endY; y++ ) {
             
@@ -625,11 +1073,70 @@ inline void Image::setSubImage( int inStartX, int inStartY,
     
     
     int endY = inStartY + inHeight;
+    
+    int sourceNumChannels = inSourceImage->getNumChannels();
+    unsigned char *sourceBytes = inSourceImage->getCompactBytes();
+    
+    if( mBytes != NULL && sourceBytes != NULL &&
+        sourceNumChannels == mNumChannels ) {
+        // both compact, copy rows of interleaved bytes
+        int rowBytes = inWidth * mNumChannels;
+        
+        int sourceY=0;
+        for( int y=inStartY; y<endY; y++ ) {
+            memcpy( &( mBytes[ ( y * mWide + inStartX ) * mNumChannels ] ),
+                    &( sourceBytes[ sourceY * sourceWidth * 
+                                    mNumChannels ] ),
+                    rowBytes );
+            sourceY ++;
+            }
+        return;
+        }
+    
+    expand();
+    
+    // NULL now if source is this image
+    sourceBytes = inSourceImage->getCompactBytes();
+    
+    if( sourceBytes != NULL ) {
+        // convert source bytes straight into our channels, all channels
+        // in one pass over each row
+        int numChannels = mNumChannels;
+        if( numChannels > sourceNumChannels ) {
+            numChannels = sourceNumChannels;
+            }
+        
+        double inv255 = 1.0 / 255.0;
+        
+        int sourceY=0;
+        for( int y=inStartY; y<endY; y++ ) {
+            unsigned char *source = 
+                &( sourceBytes[ sourceY * sourceWidth * sourceNumChannels ] );
+            int destIndex = y * mWide + inStartX;
+            
+            for( int x=0; x<inWidth; x++ ) {
+                for( int c=0; c<numChannels; c++ ) {
+                    mChannels[c][ destIndex ] = inv255 * source[c];
+                    }
+                source += sourceNumChannels;
+                destIndex++;
+                }
+            sourceY ++;
+            }
+        return;
+        }
    
     for( int c=0; c<mNumChannels; c++ ) {
         double *destChannel = mChannels[c];
         double *sourceChannel = inSourceImage->getChannel(c);
         
+        if( inStartX == 0 && inWidth == mWide && sourceWidth == mWide ) {
+            // full rows are one contiguous block
+            memcpy( &( destChannel[ inStartY * mWide ] ), sourceChannel,
+                    sizeof( double ) * inWidth * inHeight );
+            continue;
+            }
+        
         int sourceY=0;
         for( int y=inStartY; y<endY; y++ ) {
             
@@ -646,40 +1153,107 @@ inline void Image::setSubImage( int inStartX, int inStartY,
 
 
 
+// fills inValues[i] for i in [inStart, inEnd) with inValue
+static inline void imageFillRange( double *inValues, int inStart, int inEnd,
+                                   double inValue ) {
+    if( inValue == 0 ) {
+        memset( &( inValues[inStart] ), 0, 
+                sizeof( double ) * ( inEnd - inStart ) );
+        return;
+        }
+    for( int i=inStart; i<inEnd; i++ ) {
+        inValues[i] = inValue;
+        }
+    }
+
+
+
 inline Image *Image::expandImage( int inExpandedWidth, int inExpandedHeight,
                                   char inWhiteBorder ) {
-    Image *destImage = new Image( inExpandedWidth, inExpandedHeight,
-                                  mNumChannels, ! inWhiteBorder );
 
-    if( inWhiteBorder ) {
-        int numPixels = inExpandedWidth * inExpandedHeight;
-        for( int c=0; c<mNumChannels; c++ ) {
-            double *chan = destImage->getChannel( c );
-            for( int i=0; i<numPixels; i++ ) {
-                chan[i] = 1.0;
-                }
+    int xOffset = ( inExpandedWidth - mWide ) / 2;
+    int yOffset = ( inExpandedHeight - mHigh ) / 2;
+    
+    // border to the right of each row
+    int rightWidth = inExpandedWidth - mWide - xOffset;
+    
+    int endY = yOffset + mHigh;
+    
+
+    if( mBytes != NULL ) {
+        // stay compact
+        unsigned char border = 0;
+        if( inWhiteBorder ) {
+            border = 255;
             }
+        
+        int destRowBytes = inExpandedWidth * mNumChannels;
+        int rowBytes = mWide * mNumChannels;
+        
+        unsigned char *bytes = 
+            new unsigned char[ inExpandedHeight * destRowBytes ];
+        
+        memset( bytes, border, yOffset * destRowBytes );
+        
+        for( int y=yOffset; y<endY; y++ ) {
+            unsigned char *dest = &( bytes[ y * destRowBytes ] );
+            
+            memset( dest, border, xOffset * mNumChannels );
+            dest += xOffset * mNumChannels;
+            
+            memcpy( dest, &( mBytes[ ( y - yOffset ) * rowBytes ] ), 
+                    rowBytes );
+            dest += rowBytes;
+            
+            memset( dest, border, rightWidth * mNumChannels );
+            }
+        
+        memset( &( bytes[ endY * destRowBytes ] ), border,
+                ( inExpandedHeight - endY ) * destRowBytes );
+        
+        return new Image( bytes, inExpandedWidth, inExpandedHeight,
+                          mNumChannels );
         }
     
-
-    int xOffset = ( inExpandedWidth - mWide ) / 2;
-    int yOffset = ( inExpandedHeight - mHigh ) / 2;
     
+    // fill only the border, not pixels about to be copied over
+    Image *destImage = new Image( inExpandedWidth, inExpandedHeight,
+                                  mNumChannels, false );
 
+    double border = 0;
+    if( inWhiteBorder ) {
+        border = 1.0;
+        }
+    
+    int numPixels = inExpandedWidth * inExpandedHeight;
+    
     for( int c=0; c<mNumChannels; c++ ) {
         double *destChannel = destImage->getChannel( c );
         double *sourceChannel = mChannels[c];
         
-        int destY = yOffset;
-        for( int y=0; y<mHigh; y++ ) {
+        imageFillRange( destChannel, 0, yOffset * inExpandedWidth, border );
+        
+        int sourceY = 0;
+        for( int y=yOffset; y<endY; y++ ) {
+            int rowStart = y * inExpandedWidth;
+            
+            imageFillRange( destChannel, rowStart, rowStart + xOffset,
+                            border );
             
             // copy row
-            memcpy( &( destChannel[ destY * inExpandedWidth + xOffset ] ),
-                    &( sourceChannel[ y * mWide ] ),
+            memcpy( &( destChannel[ rowStart + xOffset ] ),
+                    &( sourceChannel[ sourceY * mWide ] ),
                     sizeof( double ) * mWide );
             
-            destY ++;
+            imageFillRange( destChannel, 
+                            rowStart + xOffset + mWide,
+                            rowStart + inExpandedWidth, border );
+            
+            sourceY ++;
             }
+        
+        imageFillRange( destChannel, endY * inExpandedWidth, numPixels,
+                        border );
         }
     
     return destImage;
@@ -690,6 +1264,40 @@ inline Image *Image::expandImage( int inExpandedWidth, int inExpandedHeight,
 
 
 inline Image *Image::generateAlphaChannel() {
+    if( mBytes != NULL && mNumChannels >= 3 ) {
+        // stay compact
+        unsigned char *bytes = new unsigned char[ mNumPixels * 4 ];
+
+        // color of transparency, lower left corner
+        unsigned char *t = &( mBytes[ mWide * ( mHigh - 1 ) * mNumChannels ] );
+        
+        unsigned char tR = t[0];
+        unsigned char tG = t[1];
+        unsigned char tB = t[2];
+        
+        unsigned char *source = mBytes;
+        unsigned char *dest = bytes;
+        
+        for( int i=0; i<mNumPixels; i++ ) {
+            dest[0] = source[0];
+            dest[1] = source[1];
+            dest[2] = source[2];
+            
+            if( source[0] == tR &&
+                source[1] == tG &&
+                source[2] == tB ) {
+                dest[3] = 0;
+                }
+            else {
+                dest[3] = 255;
+                }
+            source += mNumChannels;
+            dest += 4;
+            }
+        
+        return new Image( bytes, mWide, mHigh, 4 );
+        }
+    
     Image *fourChannelImage = new Image( getWidth(),
                                          getHeight(),
                                          4, false );
@@ -740,29 +1348,44 @@ inline Image *Image::generateAlphaChannel() {
 inline int Image::serialize( OutputStream *inOutputStream ) {
 	// first output width and height
 	
-	int numBytes = 0;
+	// then number of channels, all in one write
+	unsigned char header[12];
+	TypeIO::longToBytes( mWide, header );
+	TypeIO::longToBytes( mHigh, &( header[4] ) );
+	TypeIO::longToBytes( mNumChannels, &( header[8] ) );
+
+	int numBytes = inOutputStream->write( header, 12 );
 	
-	numBytes += inOutputStream->writeLong( mWide );
-	numBytes += inOutputStream->writeLong( mHigh );
+	if( mBytes != NULL && mNumChannels == 1 ) {
+		// already one channel of bytes
+		numBytes += inOutputStream->write( mBytes, mNumPixels );
+		return numBytes;
+		}
 	
-	// then output number of channels
-	numBytes += inOutputStream->writeLong( mNumChannels );
+	unsigned char *byteArray = new unsigned char[mNumPixels];
 	
 	// now output each channel
 	for( int i=0; i<mNumChannels; i++ ) {
-		unsigned char *byteArray = new unsigned char[mNumPixels];
 		
+        if( mBytes != NULL ) {
+            // already bytes, just de-interleave
+            for( int p=0; p<mNumPixels; p++ ) {
+                byteArray[p] = mBytes[ p * mNumChannels + i ];
+                }
+            }
+        else {
 		// convert each 8-bit double pixel to one byte
 		for( int p=0; p<mNumPixels; p++ ) {
 			//numBytes += inOutputStream->writeDouble( mChannels[i][p] );
 			byteArray[p] = (unsigned char)( lrint( mChannels[i][p] * 255 ) );
 			}
+            }
 		
 		numBytes += inOutputStream->write( byteArray, mNumPixels );
-			
-		delete [] byteArray;	
 		}
 	
+	delete [] byteArray;
+	
 	return numBytes;
 	}
 	
@@ -771,41 +1394,59 @@ inline int Image::serialize( OutputStream *inOutputStream ) {
 inline int Image::deserialize( InputStream *inInputStream ) {
 	int i;
 	// first delete old image channels
-	for( i=0; i<mNumChannels; i++ ) {
-		delete [] mChannels[i];
-		}
-	delete [] mChannels;
+    if( mChannels != NULL ) {
+        for( i=0; i<mNumChannels; i++ ) {
+            delete [] mChannels[i];
+            }
+        delete [] mChannels;
+        mChannels = NULL;
+        }
+    if( mBytes != NULL ) {
+        delete [] mBytes;
+        mBytes = NULL;
+        }
 	
 	
 	// input width and height
 	
-	int numBytes = 0;
+	// and number of channels, all in one read
+	unsigned char header[12];
+	
+	int numBytes = inInputStream->read( header, 12 );
 	
-	numBytes += inInputStream->readLong( &mWide );
-	numBytes += inInputStream->readLong( &mHigh );
+	if( numBytes != 12 ) {
+		memset( header, 0, 12 );
+		}
+	
+	mWide = TypeIO::bytesToLong( header );
+	mHigh = TypeIO::bytesToLong( &( header[4] ) );
 	
 	mNumPixels = mWide * mHigh;
 	
-	// then input number of channels
-	numBytes += inInputStream->readLong( &mNumChannels );
+	mNumChannels = TypeIO::bytesToLong( &( header[8] ) );
 	
-	mChannels = new double*[mNumChannels];
+	// stay compact until channels are needed
+	mBytes = new unsigned char[ mNumPixels * mNumChannels ];
+	
+	if( mNumChannels == 1 ) {
+		// no interleaving needed
+		numBytes += inInputStream->read( mBytes, mNumPixels );
+		return numBytes;
+		}
 	
 	// now input each channel
+	unsigned char *byteArray = new unsigned char[mNumPixels];
+    
 	for( i=0; i<mNumChannels; i++ ) {
-		mChannels[i] = new double[mNumPixels];
-		
-		unsigned char *byteArray = new unsigned char[mNumPixels];
 		numBytes += inInputStream->read( byteArray, mNumPixels );
 		
-		// convert each byte to an 8-bit double pixel
+		// interleave
 		for( int p=0; p<mNumPixels; p++ ) {
-			//numBytes += inInputStream->readDouble( &( mChannels[i][p] ) );
-			mChannels[i][p] = (double)( byteArray[p] ) / 255.0;
+			mBytes[ p * mNumChannels + i ] = byteArray[p];
 			}
-		
-		delete [] byteArray;	
 		}
+    
+	delete [] byteArray;
 	
 	return numBytes;
 	}
@@ -932,6 +1573,8 @@ inline void Image::adjustSaturation( double inSaturation ) {
         return;
         }    
 
+    expand();
+
     for( int p=0; p<mNumPixels; p++ ) {
         double r = mChannels[0][p];
         double g = mChannels[1][p];
@@ -22,6 +22,14 @@
  *
  * 2011-April-5     Jason Rohrer
  * Fixed float-to-int conversion.  
+ *
+ * 2026-October-15     Jason Rohrer
+ * Added versions of the color space conversions that write into a given
+ * image (or back into the input image).  The 3x3 conversions run as one
+ * fused pass (SSE2 or NEON) with channel offsets and clipping built in,
+ * read and write compact 8-bit images directly, and split rows across
+ * the shared ThreadPool.  YCbCrToRGB no longer shifts the Cb and Cr
+ * channels of its input image.
  */
 
 #ifndef IMAGE_COLOR_CONVERTER_INCLUDED
@@ -32,11 +40,43 @@
 
 #include "Image.h"
 
+#include "minorGems/system/ThreadPool.h"
+
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || \
+    ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+	#define IMAGE_COLOR_CONVERTER_SSE2
+	#include <emmintrin.h>
+#elif defined( __aarch64__ )
+	#define IMAGE_COLOR_CONVERTER_NEON
+	#include <arm_neon.h>
+#endif
+
+
+// smallest band of pixels handed to a pool thread
+#define IMAGE_COLOR_CONVERTER_MIN_BAND_PIXELS 32768
+
+// pixels of a compact image converted at a time through double buffers
+#define IMAGE_COLOR_CONVERTER_CHUNK_PIXELS 256
+
 
 /**
  * A container class for static functions that convert
  * images between various color spaces.
  *
+ * The conversions between 3-channel color spaces come in two versions:
+ * one returns a new image, and the other writes into a destination image
+ * given by the caller, which can be the source image itself (converting
+ * it in place) so that a frame can be converted without allocating.
+ *
+ * A compact 8-bit source (see Image::isCompact) is read without being
+ * expanded.  A compact destination stays compact for conversions whose
+ * results always lie in [0,1] (RGB<->YCbCr, RGBToHSB), and is expanded
+ * for the others.
+ *
+ * Conversions split image rows across the shared ThreadPool, so callers
+ * must link minorGems/system/ThreadPool.cpp (and the thread sources).
+ *
  * @author Jason Rohrer
  */ 
 class ImageColorConverter {
@@ -113,6 +153,22 @@ class ImageColorConverter {
 		static Image *RGBToHSB( Image *inRGBImage );
 
 
+		/**
+		 * Same as above, but into an existing image.
+		 *
+		 * @param inRGBImage the image to convert.
+		 *   Must be destroyed by caller.
+		 * @param outHSBImage the image to write the HSB conversion into,
+		 *   which must have 3 channels and the same size as inRGBImage.
+		 *   Can be inRGBImage to convert in place.
+		 *   Must be destroyed by caller.
+		 *
+		 * @return true on success, or false if either image does not
+		 *   have 3 channels or sizes don't match.
+		 */
+		static char RGBToHSB( Image *inRGBImage, Image *outHSBImage );
+
+
 
 		/**
 		 * Converts an RGB image to YIQ.
@@ -129,6 +185,22 @@ class ImageColorConverter {
 		static Image *RGBToYIQ( Image *inRGBImage );
 
 
+		/**
+		 * Same as above, but into an existing image.
+		 *
+		 * @param inRGBImage the image to convert.
+		 *   Must be destroyed by caller.
+		 * @param outYIQImage the image to write the YIQ conversion into,
+		 *   which must have 3 channels and the same size as inRGBImage.
+		 *   Can be inRGBImage to convert in place.
+		 *   Must be destroyed by caller.
+		 *
+		 * @return true on success, or false if either image does not
+		 *   have 3 channels or sizes don't match.
+		 */
+		static char RGBToYIQ( Image *inRGBImage, Image *outYIQImage );
+
+
 
 		/**
 		 * Converts a YIQ image to RGB.
@@ -146,6 +218,22 @@ class ImageColorConverter {
 		static Image *YIQToRGB( Image *inYIQImage );
 
 
+		/**
+		 * Same as above, but into an existing image.
+		 *
+		 * @param inYIQImage the image to convert.
+		 *   Must be destroyed by caller.
+		 * @param outRGBImage the image to write the RGB conversion into,
+		 *   which must have 3 channels and the same size as inYIQImage.
+		 *   Can be inYIQImage to convert in place.
+		 *   Must be destroyed by caller.
+		 *
+		 * @return true on success, or false if either image does not
+		 *   have 3 channels or sizes don't match.
+		 */
+		static char YIQToRGB( Image *inYIQImage, Image *outRGBImage );
+
+
 
 		/**
 		 * Converts an RGB image to YCbCr.
@@ -164,6 +252,22 @@ class ImageColorConverter {
 		static Image *RGBToYCbCr( Image *inRGBImage );
 
 
+		/**
+		 * Same as above, but into an existing image.
+		 *
+		 * @param inRGBImage the image to convert.
+		 *   Must be destroyed by caller.
+		 * @param outYCbCrImage the image to write the YCbCr conversion into,
+		 *   which must have 3 channels and the same size as inRGBImage.
+		 *   Can be inRGBImage to convert in place.
+		 *   Must be destroyed by caller.
+		 *
+		 * @return true on success, or false if either image does not
+		 *   have 3 channels or sizes don't match.
+		 */
+		static char RGBToYCbCr( Image *inRGBImage, Image *outYCbCrImage );
+
+
 
 		/**
 		 * Converts a YCbCr image to RGB.
@@ -183,38 +287,93 @@ class ImageColorConverter {
 		static Image *YCbCrToRGB( Image *inYCbCrImage );
 
 
+		/**
+		 * Same as above, but into an existing image.
+		 *
+		 * @param inYCbCrImage the image to convert.
+		 *   Must be destroyed by caller.
+		 * @param outRGBImage the image to write the RGB conversion into,
+		 *   which must have 3 channels and the same size as inYCbCrImage.
+		 *   Can be inYCbCrImage to convert in place.
+		 *   Must be destroyed by caller.
+		 *
+		 * @return true on success, or false if either image does not
+		 *   have 3 channels or sizes don't match.
+		 */
+		static char YCbCrToRGB( Image *inYCbCrImage, Image *outRGBImage );
+
+
 		
 	protected:
 
 		/**
-		 * Converts an 3-channel image to another 3-channel
-		 * image using a matrix of conversion coefficients.
+		 * A conversion between 3-channel color spaces:
 		 *
-		 * The following formulae are used;
-		 * outChan0 = inC00 * inChan0 + inC01 * inChan1 + inC02 * inChan2
-		 * outChan1 = inC10 * inChan0 + inC11 * inChan1 + inC12 * inChan2
-		 * outChan2 = inC20 * inChan0 + inC21 * inChan1 + inC22 * inChan2
+		 * outChan0 = m[0] * inChan0 + m[1] * inChan1 + m[2] * inChan2 + offset[0]
+		 * outChan1 = m[3] * inChan0 + m[4] * inChan1 + m[5] * inChan2 + offset[1]
+		 * outChan2 = m[6] * inChan0 + m[7] * inChan1 + m[8] * inChan2 + offset[2]
 		 *
-		 * @param inImage the image to convert.
-		 *   Must be destroyed by caller.
+		 * with each result clipped to [0,1] if clip is true.
+		 */
+		typedef struct ColorMatrix {
+				double m[9];
+				double offset[3];
+				char clip;
+			} ColorMatrix;
+
+
+		// what a band of rows is converted from and to
+		// channel pointers are NULL for compact images
+		typedef struct ConvertJob {
+				ColorMatrix *matrix;
+				int width;
+				double *in[3];
+				double *out[3];
+				unsigned char *inBytes;
+				unsigned char *outBytes;
+			} ConvertJob;
+
+
+		/**
+		 * Converts inImage into outImage, which may be the same image.
 		 *
-		 * @return a new image that is inImage converted, or NULL if
-		 *   conversion failed (usually because inImage does not
-		 *   contain 3 channels).
-		 *   Must be destroyed by caller.
+		 * @return true on success, or false if either image does not
+		 *   have 3 channels or sizes don't match.
+		 */
+		static char coefficientConvert( Image *inImage, Image *outImage,
+										ColorMatrix *inMatrix );
+
+
+		/**
+		 * Converts pixels [inStart, inEnd) of double channels.
+		 *
+		 * Each out channel must either be the matching in channel or
+		 * not overlap any in channel.
 		 */
-		static Image *coefficientConvert( Image *inImage,
-										  double inC00,
-										  double inC01,
-										  double inC02,
-										  double inC10,
-										  double inC11,
-										  double inC12,
-										  double inC20,
-										  double inC21,
-										  double inC22 );
-											 
-	};		
+		static void convertPixels( ColorMatrix *inMatrix,
+								   double **inChannels,
+								   double **outChannels,
+								   int inStart, int inEnd );
+
+
+		// sets up channel and byte pointers of inJob
+		// returns false if images don't match
+		static char setupJob( ConvertJob *inJob, Image *inImage,
+							  Image *outImage, char inCompactOut );
+
+		// ThreadPoolRangeFunctions over rows
+		static void convertBand( void *inJob, int inStart, int inEnd );
+		static void hsbBand( void *inJob, int inStart, int inEnd );
+
+		// runs inFunction over all rows of inJob's images
+		static void runBands( ThreadPoolRangeFunction inFunction,
+							  ConvertJob *inJob, int inHeight );
+
+
+		// makes a 3-channel image with the size of inImage, to convert into
+		static Image *makeDestination( Image *inImage );
+
+	};
 
 
 
@@ -306,35 +465,69 @@ inline Image *ImageColorConverter::
 
 
 
+inline Image *ImageColorConverter::makeDestination( Image *inImage ) {
+	// every pixel overwritten by conversion
+	return new Image( inImage->getWidth(), inImage->getHeight(), 3, false );
+	}
+
+
+
 inline Image *ImageColorConverter::RGBToHSB( Image *inRGBImage ) {
-	// idea modeled after Java Color class.
-	
 	if( inRGBImage->getNumChannels() != 3 ) {
 		printf(
 			"RGBtoHSB requires a 3-channel image as input.\n" );
 		return NULL;
 		}
 
-	int w = inRGBImage->getWidth();
-	int h = inRGBImage->getHeight();
+	Image *hsbImage = makeDestination( inRGBImage );
 
-	int numPixels = w * h;
-				
-	Image *hsbImage = new Image( w, h, 3 );
+	RGBToHSB( inRGBImage, hsbImage );
 
-	double *redChannel = inRGBImage->getChannel( 0 );
-	double *greenChannel = inRGBImage->getChannel( 1 );
-	double *blueChannel = inRGBImage->getChannel( 2 );
+	return hsbImage;
+	}
 
-	double *hueChannel = hsbImage->getChannel( 0 );
-	double *satChannel = hsbImage->getChannel( 1 );
-	double *brightChannel = hsbImage->getChannel( 2 );
 
-				
-	for( int i=0; i<numPixels; i++ ) {
-		int r = (int)( lrint( 255 * redChannel[i] ) );
-		int g = (int)( lrint( 255 * greenChannel[i] ) );
-		int b = (int)( lrint( 255 * blueChannel[i] ) );
+
+inline char ImageColorConverter::RGBToHSB( Image *inRGBImage,
+										   Image *outHSBImage ) {
+	ConvertJob job;
+
+	if( ! setupJob( &job, inRGBImage, outHSBImage, true ) ) {
+		printf(
+			"RGBtoHSB requires matching 3-channel images.\n" );
+		return false;
+		}
+
+	runBands( hsbBand, &job, inRGBImage->getHeight() );
+
+	return true;
+	}
+
+
+
+inline void ImageColorConverter::hsbBand( void *inJob,
+										  int inStart, int inEnd ) {
+	// idea modeled after Java Color class.
+
+	ConvertJob *job = (ConvertJob *)inJob;
+
+	int start = inStart * job->width;
+	int end = inEnd * job->width;
+
+	for( int i=start; i<end; i++ ) {
+		int r, g, b;
+
+		if( job->inBytes != NULL ) {
+			unsigned char *pixel = &( job->inBytes[ 3 * i ] );
+			r = pixel[0];
+			g = pixel[1];
+			b = pixel[2];
+			}
+		else {
+			r = (int)( lrint( 255 * job->in[0][i] ) );
+			g = (int)( lrint( 255 * job->in[1][i] ) );
+			b = (int)( lrint( 255 * job->in[2][i] ) );
+			}
 
 		double hue, sat, bright;
 				
@@ -382,12 +575,18 @@ inline Image *ImageColorConverter::RGBToHSB( Image *inRGBImage ) {
 				}
 			}
 
-		hueChannel[i] = hue;
-		satChannel[i] = sat;
-		brightChannel[i] = bright;
+		if( job->outBytes != NULL ) {
+			unsigned char *pixel = &( job->outBytes[ 3 * i ] );
+			pixel[0] = (unsigned char)( lrint( 255 * hue ) );
+			pixel[1] = (unsigned char)( lrint( 255 * sat ) );
+			pixel[2] = (unsigned char)( lrint( 255 * bright ) );
+			}
+		else {
+			job->out[0][i] = hue;
+			job->out[1][i] = sat;
+			job->out[2][i] = bright;
+			}
 		}
-
-	return hsbImage;
 	}
 
 
@@ -399,16 +598,33 @@ inline Image *ImageColorConverter::RGBToYIQ( Image *inRGBImage ) {
 		return NULL;
 		}
 
-	Image *yiqImage = coefficientConvert( inRGBImage,
-										  0.299,  0.587,  0.114,
-										  0.596, -0.274, -0.322,
-										  0.212, -0.523,  0.311 );
+	Image *yiqImage = makeDestination( inRGBImage );
+
+	RGBToYIQ( inRGBImage, yiqImage );
 
 	return yiqImage;
 	}
 
 
 
+inline char ImageColorConverter::RGBToYIQ( Image *inRGBImage,
+										   Image *outYIQImage ) {
+	ColorMatrix matrix = { { 0.299,  0.587,  0.114,
+							 0.596, -0.274, -0.322,
+							 0.212, -0.523,  0.311 },
+						   { 0, 0, 0 },
+						   false };
+
+	if( ! coefficientConvert( inRGBImage, outYIQImage, &matrix ) ) {
+		printf(
+			"RGBtoYIQ requires matching 3-channel images.\n" );
+		return false;
+		}
+	return true;
+	}
+
+
+
 inline Image *ImageColorConverter::YIQToRGB( Image *inYIQImage ) {
 	if( inYIQImage->getNumChannels() != 3 ) {
 		printf(
@@ -416,15 +632,48 @@ inline Image *ImageColorConverter::YIQToRGB( Image *inYIQImage ) {
 		return NULL;
 		}
 
-	Image *rgbImage = coefficientConvert( inYIQImage,
-										  1.0,  0.956,  0.621,
-										  1.0, -0.272, -0.647,
-										  1.0, -1.105,  1.702 );
+	Image *rgbImage = makeDestination( inYIQImage );
+
+	YIQToRGB( inYIQImage, rgbImage );
+
 	return rgbImage;
 	}
 
 
 
+inline char ImageColorConverter::YIQToRGB( Image *inYIQImage,
+										   Image *outRGBImage ) {
+	ColorMatrix matrix = { { 1.0,  0.956,  0.621,
+							 1.0, -0.272, -0.647,
+							 1.0, -1.105,  1.702 },
+						   { 0, 0, 0 },
+						   false };
+
+	if( ! coefficientConvert( inYIQImage, outRGBImage, &matrix ) ) {
+		printf(
+			"YIQtoRGB requires matching 3-channel images.\n" );
+		return false;
+		}
+	return true;
+	}
+
+
+
+// coefficients taken from the color space faq
+/*
+  RGB -> YCbCr (with Rec 601-1 specs)
+  Y  =  0.2989 * Red + 0.5866 * Green + 0.1145 * Blue
+  Cb = -0.1687 * Red - 0.3312 * Green + 0.5000 * Blue
+  Cr =  0.5000 * Red - 0.4183 * Green - 0.0816 * Blue
+
+  YCbCr (with Rec 601-1 specs) -> RGB
+  Red   = Y + 0.0000 * Cb + 1.4022 * Cr
+  Green = Y - 0.3456 * Cb - 0.7145 * Cr
+  Blue  = Y + 1.7710 * Cb + 0.0000 * Cr
+*/
+
+
+
 inline Image *ImageColorConverter::RGBToYCbCr( Image *inRGBImage ) {
 	if( inRGBImage->getNumChannels() != 3 ) {
 		printf(
@@ -432,39 +681,36 @@ inline Image *ImageColorConverter::RGBToYCbCr( Image *inRGBImage ) {
 		return NULL;
 		}
 
-	// coefficients taken from the color space faq
-	/*
-	  RGB -> YCbCr (with Rec 601-1 specs)
-	  Y  =  0.2989 * Red + 0.5866 * Green + 0.1145 * Blue
-	  Cb = -0.1687 * Red - 0.3312 * Green + 0.5000 * Blue
-	  Cr =  0.5000 * Red - 0.4183 * Green - 0.0816 * Blue
-
-	  YCbCr (with Rec 601-1 specs) -> RGB
-	  Red   = Y + 0.0000 * Cb + 1.4022 * Cr
-	  Green = Y - 0.3456 * Cb - 0.7145 * Cr
-	  Blue  = Y + 1.7710 * Cb + 0.0000 * Cr
-	*/
+	Image *ycbcrImage = makeDestination( inRGBImage );
+
+	RGBToYCbCr( inRGBImage, ycbcrImage );
 	
-	Image *ycbcrImage = coefficientConvert( inRGBImage,
-											 0.2989,  0.5866,  0.1145,
-											-0.1687, -0.3312,  0.5000,
-											 0.5000, -0.4183, -0.0816 );
-
-	// adjust the Cb and Cr channels so they are in the range [0,1]
-	int numPixels = ycbcrImage->getWidth() * ycbcrImage->getHeight();
-	double *cbChannel = ycbcrImage->getChannel( 1 );
-	double *crChannel = ycbcrImage->getChannel( 2 );
-	for( int i=0; i<numPixels; i++ ) {
-		cbChannel[i] += 0.5;
-		crChannel[i] += 0.5;
-		}
+	return ycbcrImage;
+	}
+
+
 
+inline char ImageColorConverter::RGBToYCbCr( Image *inRGBImage,
+											 Image *outYCbCrImage ) {
+	// Cb and Cr shifted by 0.5 so they are in the range [0,1]
+	
 	// no need to clip pixels to the range [0,1], since
 	// all possible rgb pixel values are represented by in-range
 	// yCbCr pixel values
-
-	
-	return ycbcrImage;
+	// (but clipping lets a compact destination stay compact, and
+	// it catches rounding just outside the range)
+	ColorMatrix matrix = { {  0.2989,  0.5866,  0.1145,
+							 -0.1687, -0.3312,  0.5000,
+							  0.5000, -0.4183, -0.0816 },
+						   { 0, 0.5, 0.5 },
+						   true };
+
+	if( ! coefficientConvert( inRGBImage, outYCbCrImage, &matrix ) ) {
+		printf(
+			"RGBtoYCbCr requires matching 3-channel images.\n" );
+		return false;
+		}
+	return true;
 	}
 
 
@@ -476,102 +722,320 @@ inline Image *ImageColorConverter::YCbCrToRGB( Image *inYCbCrImage ) {
 		return NULL;
 		}
 
-	// adjust the normalized Cb and Cr channels
-	// so they are in the range [-0.5,0.5]
-	
-	int numPixels = inYCbCrImage->getWidth() * inYCbCrImage->getHeight();
-	double *cbChannel = inYCbCrImage->getChannel( 1 );
-	double *crChannel = inYCbCrImage->getChannel( 2 );
-	for( int i=0; i<numPixels; i++ ) {
-		cbChannel[i] -= 0.5;
-		crChannel[i] -= 0.5;
-		}
+	Image *rgbImage = makeDestination( inYCbCrImage );
 
-	// coefficients taken from the color space faq
-	/*
-	  RGB -> YCbCr (with Rec 601-1 specs)
-	  Y  =  0.2989 * Red + 0.5866 * Green + 0.1145 * Blue
-	  Cb = -0.1687 * Red - 0.3312 * Green + 0.5000 * Blue
-	  Cr =  0.5000 * Red - 0.4183 * Green - 0.0816 * Blue
-
-	  YCbCr (with Rec 601-1 specs) -> RGB
-	  Red   = Y + 0.0000 * Cb + 1.4022 * Cr
-	  Green = Y - 0.3456 * Cb - 0.7145 * Cr
-	  Blue  = Y + 1.7710 * Cb + 0.0000 * Cr
-	*/
+	YCbCrToRGB( inYCbCrImage, rgbImage );
 	
-	Image *rgbImage = coefficientConvert( inYCbCrImage,
-										  1.0,  0.0000,  1.4022,
-										  1.0, -0.3456, -0.7145,
-										  1.0,  1.7710,  0.0000 );
+	return rgbImage;
+	}
+
+
+
+inline char ImageColorConverter::YCbCrToRGB( Image *inYCbCrImage,
+											 Image *outRGBImage ) {
+	// input Cb and Cr are shifted by 0.5 into the range [0,1], so
+	// -0.5 times their coefficients is folded into the offsets
 
 	// clip r, g, and b channels to the range [0,1], since
 	// some YCbCr pixel values might map out of this range
 	// (in other words, some YCbCr values map outside of rgb space)
-	for( int c=0; c<3; c++ ) {
-		double *channel = rgbImage->getChannel( c );
-		
-		for( int p=0; p<numPixels; p++ ) {
-			if( channel[p] < 0 ) {
-				channel[p] = 0;
-				}
-			else if( channel[p] > 1 ) {
-				channel[p] = 1.0;
-				}
+	ColorMatrix matrix = { { 1.0,  0.0000,  1.4022,
+							 1.0, -0.3456, -0.7145,
+							 1.0,  1.7710,  0.0000 },
+						   { -0.5 * 1.4022,
+							 -0.5 * ( -0.3456 - 0.7145 ),
+							 -0.5 * 1.7710 },
+						   true };
+
+	if( ! coefficientConvert( inYCbCrImage, outRGBImage, &matrix ) ) {
+		printf(
+			"YCbCrtoRGB requires matching 3-channel images.\n" );
+		return false;
+		}
+	return true;
+	}
+
+
+
+inline char ImageColorConverter::setupJob( ConvertJob *inJob,
+										   Image *inImage,
+										   Image *outImage,
+										   char inCompactOut ) {
+	if( inImage->getNumChannels() != 3 ||
+		outImage->getNumChannels() != 3 ||
+		inImage->getWidth() != outImage->getWidth() ||
+		inImage->getHeight() != outImage->getHeight() ) {
+		return false;
+		}
+
+	inJob->width = inImage->getWidth();
+
+	// destination first, since expanding it expands source too if
+	// they are the same image
+	if( inCompactOut && outImage->isCompact() ) {
+		inJob->outBytes = outImage->getCompactBytes();
+		}
+	else {
+		inJob->outBytes = NULL;
+
+		for( int c=0; c<3; c++ ) {
+			inJob->out[c] = outImage->getChannel( c );
 			}
 		}
 	
-	return rgbImage;
+	inJob->inBytes = inImage->getCompactBytes();
+
+	if( inJob->inBytes == NULL ) {
+		for( int c=0; c<3; c++ ) {
+			inJob->in[c] = inImage->getChannel( c );
+			}
+		}
+
+	return true;
 	}
 
 
 
-inline Image *ImageColorConverter::coefficientConvert( Image *inImage,
-													   double inC00,
-													   double inC01,
-													   double inC02,
-													   double inC10,
-													   double inC11,
-													   double inC12,
-													   double inC20,
-													   double inC21,
-													   double inC22 ) {
-	if( inImage->getNumChannels() != 3 ) {
-		return NULL;
+inline void ImageColorConverter::runBands( ThreadPoolRangeFunction inFunction,
+										   ConvertJob *inJob, int inHeight ) {
+	int minRows = 
+		IMAGE_COLOR_CONVERTER_MIN_BAND_PIXELS / ( inJob->width + 1 ) + 1;
+	
+	if( inHeight <= minRows ) {
+		// not worth waking pool
+		inFunction( inJob, 0, inHeight );
 		}
+	else {
+		ThreadPool::getSharedPool()->parallelFor( inFunction, inJob,
+												  inHeight, minRows );
+		}
+	}
+
+
 
+inline char ImageColorConverter::coefficientConvert( Image *inImage,
+													 Image *outImage,
+													 ColorMatrix *inMatrix ) {
+	ConvertJob job;
 	
-	int w = inImage->getWidth();
-	int h = inImage->getHeight();
+	if( ! setupJob( &job, inImage, outImage, inMatrix->clip ) ) {
+		return false;
+		}
+	
+	job.matrix = inMatrix;
+
+	runBands( convertBand, &job, inImage->getHeight() );
+	
+	return true;
+	}
+
 
-	int numPixels = w * h;
-				
-	Image *outImage = new Image( w, h, 3 );
 
-	double *outChannel0 = outImage->getChannel( 0 );
-	double *outChannel1 = outImage->getChannel( 1 );
-	double *outChannel2 = outImage->getChannel( 2 );
+inline void ImageColorConverter::convertBand( void *inJob,
+											  int inStart, int inEnd ) {
+	ConvertJob *job = (ConvertJob *)inJob;
 
-	double *inChannel0 = inImage->getChannel( 0 );
-	double *inChannel1 = inImage->getChannel( 1 );
-	double *inChannel2 = inImage->getChannel( 2 );
+	int start = inStart * job->width;
+	int end = inEnd * job->width;
+
+	if( job->inBytes == NULL && job->outBytes == NULL ) {
+		convertPixels( job->matrix, job->in, job->out, start, end );
+		return;
+		}
+
+
+	// compact source or destination goes through double buffers,
+	// a chunk at a time
+	double buffers[2][3][ IMAGE_COLOR_CONVERTER_CHUNK_PIXELS ];
 	
-	for( int i=0; i<numPixels; i++ ) {
-		outChannel0[i] =
-			inC00 * inChannel0[i] +
-			inC01 * inChannel1[i] +
-			inC02 * inChannel2[i];
-		outChannel1[i] =
-			inC10 * inChannel0[i] +
-			inC11 * inChannel1[i] +
-			inC12 * inChannel2[i];
-		outChannel2[i] =
-			inC20 * inChannel0[i] +
-			inC21 * inChannel1[i] +
-			inC22 * inChannel2[i];
+	double inv255 = 1.0 / 255.0;
+
+	for( int chunk = start; chunk < end; 
+		 chunk += IMAGE_COLOR_CONVERTER_CHUNK_PIXELS ) {
+		
+		int chunkEnd = chunk + IMAGE_COLOR_CONVERTER_CHUNK_PIXELS;
+		if( chunkEnd > end ) {
+			chunkEnd = end;
+			}
+		int numPixels = chunkEnd - chunk;
+		
+		double *in[3];
+		double *out[3];
+		
+		for( int c=0; c<3; c++ ) {
+			if( job->inBytes != NULL ) {
+				in[c] = buffers[0][c];
+				}
+			else {
+				in[c] = &( job->in[c][ chunk ] );
+				}
+			if( job->outBytes != NULL ) {
+				out[c] = buffers[1][c];
+				}
+			else {
+				out[c] = &( job->out[c][ chunk ] );
+				}
+			}
+		
+		if( job->inBytes != NULL ) {
+			unsigned char *pixel = &( job->inBytes[ 3 * chunk ] );
+
+			for( int i=0; i<numPixels; i++ ) {
+				in[0][i] = inv255 * pixel[0];
+				in[1][i] = inv255 * pixel[1];
+				in[2][i] = inv255 * pixel[2];
+				pixel += 3;
+				}
+			}
+
+		convertPixels( job->matrix, in, out, 0, numPixels );
+
+		if( job->outBytes != NULL ) {
+			// only clipped conversions write bytes
+			unsigned char *pixel = &( job->outBytes[ 3 * chunk ] );
+
+			for( int i=0; i<numPixels; i++ ) {
+				pixel[0] = (unsigned char)( lrint( 255 * out[0][i] ) );
+				pixel[1] = (unsigned char)( lrint( 255 * out[1][i] ) );
+				pixel[2] = (unsigned char)( lrint( 255 * out[2][i] ) );
+				pixel += 3;
+				}
+			}
+		}
+	}
+
+
+
+inline void ImageColorConverter::convertPixels( ColorMatrix *inMatrix,
+												double **inChannels,
+												double **outChannels,
+												int inStart, int inEnd ) {
+	double *m = inMatrix->m;
+	double *offset = inMatrix->offset;
+	char clip = inMatrix->clip;
+	
+	double *in0 = inChannels[0];
+	double *in1 = inChannels[1];
+	double *in2 = inChannels[2];
+
+	double *out0 = outChannels[0];
+	double *out1 = outChannels[1];
+	double *out2 = outChannels[2];
+
+	int i = inStart;
+
+	// all three inputs of a pixel are loaded before any of its outputs
+	// are stored, so converting in place is safe
+
+#if defined( IMAGE_COLOR_CONVERTER_SSE2 )
+	__m128d m0 = _mm_set1_pd( m[0] );
+	__m128d m1 = _mm_set1_pd( m[1] );
+	__m128d m2 = _mm_set1_pd( m[2] );
+	__m128d m3 = _mm_set1_pd( m[3] );
+	__m128d m4 = _mm_set1_pd( m[4] );
+	__m128d m5 = _mm_set1_pd( m[5] );
+	__m128d m6 = _mm_set1_pd( m[6] );
+	__m128d m7 = _mm_set1_pd( m[7] );
+	__m128d m8 = _mm_set1_pd( m[8] );
+
+	__m128d offset0 = _mm_set1_pd( offset[0] );
+	__m128d offset1 = _mm_set1_pd( offset[1] );
+	__m128d offset2 = _mm_set1_pd( offset[2] );
+
+	__m128d zero = _mm_setzero_pd();
+	__m128d one = _mm_set1_pd( 1.0 );
+
+	for( ; i + 2 <= inEnd; i += 2 ) {
+		__m128d c0 = _mm_loadu_pd( &( in0[i] ) );
+		__m128d c1 = _mm_loadu_pd( &( in1[i] ) );
+		__m128d c2 = _mm_loadu_pd( &( in2[i] ) );
+
+		__m128d v0 = _mm_add_pd( 
+			_mm_add_pd( _mm_mul_pd( m0, c0 ), _mm_mul_pd( m1, c1 ) ),
+			_mm_add_pd( _mm_mul_pd( m2, c2 ), offset0 ) );
+		__m128d v1 = _mm_add_pd( 
+			_mm_add_pd( _mm_mul_pd( m3, c0 ), _mm_mul_pd( m4, c1 ) ),
+			_mm_add_pd( _mm_mul_pd( m5, c2 ), offset1 ) );
+		__m128d v2 = _mm_add_pd( 
+			_mm_add_pd( _mm_mul_pd( m6, c0 ), _mm_mul_pd( m7, c1 ) ),
+			_mm_add_pd( _mm_mul_pd( m8, c2 ), offset2 ) );
+
+		if( clip ) {
+			v0 = _mm_min_pd( _mm_max_pd( v0, zero ), one );
+			v1 = _mm_min_pd( _mm_max_pd( v1, zero ), one );
+			v2 = _mm_min_pd( _mm_max_pd( v2, zero ), one );
+			}
+
+		_mm_storeu_pd( &( out0[i] ), v0 );
+		_mm_storeu_pd( &( out1[i] ), v1 );
+		_mm_storeu_pd( &( out2[i] ), v2 );
+		}
+#elif defined( IMAGE_COLOR_CONVERTER_NEON )
+	float64x2_t m0 = vdupq_n_f64( m[0] );
+	float64x2_t m1 = vdupq_n_f64( m[1] );
+	float64x2_t m2 = vdupq_n_f64( m[2] );
+	float64x2_t m3 = vdupq_n_f64( m[3] );
+	float64x2_t m4 = vdupq_n_f64( m[4] );
+	float64x2_t m5 = vdupq_n_f64( m[5] );
+	float64x2_t m6 = vdupq_n_f64( m[6] );
+	float64x2_t m7 = vdupq_n_f64( m[7] );
+	float64x2_t m8 = vdupq_n_f64( m[8] );
+
+	float64x2_t offset0 = vdupq_n_f64( offset[0] );
+	float64x2_t offset1 = vdupq_n_f64( offset[1] );
+	float64x2_t offset2 = vdupq_n_f64( offset[2] );
+
+	float64x2_t zero = vdupq_n_f64( 0.0 );
+	float64x2_t one = vdupq_n_f64( 1.0 );
+
+	// separate multiplies and adds (not fused), to match scalar results
+	for( ; i + 2 <= inEnd; i += 2 ) {
+		float64x2_t c0 = vld1q_f64( &( in0[i] ) );
+		float64x2_t c1 = vld1q_f64( &( in1[i] ) );
+		float64x2_t c2 = vld1q_f64( &( in2[i] ) );
+
+		float64x2_t v0 = vaddq_f64( 
+			vaddq_f64( vmulq_f64( m0, c0 ), vmulq_f64( m1, c1 ) ),
+			vaddq_f64( vmulq_f64( m2, c2 ), offset0 ) );
+		float64x2_t v1 = vaddq_f64( 
+			vaddq_f64( vmulq_f64( m3, c0 ), vmulq_f64( m4, c1 ) ),
+			vaddq_f64( vmulq_f64( m5, c2 ), offset1 ) );
+		float64x2_t v2 = vaddq_f64( 
+			vaddq_f64( vmulq_f64( m6, c0 ), vmulq_f64( m7, c1 ) ),
+			vaddq_f64( vmulq_f64( m8, c2 ), offset2 ) );
+
+		if( clip ) {
+			v0 = vminq_f64( vmaxq_f64( v0, zero ), one );
+			v1 = vminq_f64( vmaxq_f64( v1, zero ), one );
+			v2 = vminq_f64( vmaxq_f64( v2, zero ), one );
+			}
+
+		vst1q_f64( &( out0[i] ), v0 );
+		vst1q_f64( &( out1[i] ), v1 );
+		vst1q_f64( &( out2[i] ), v2 );
 		}
+#endif
+
+	// remaining pixels, same arithmetic in same order
+	for( ; i < inEnd; i++ ) {
+		double c0 = in0[i];
+		double c1 = in1[i];
+		double c2 = in2[i];
+
+		double v0 = ( m[0] * c0 + m[1] * c1 ) + ( m[2] * c2 + offset[0] );
+		double v1 = ( m[3] * c0 + m[4] * c1 ) + ( m[5] * c2 + offset[1] );
+		double v2 = ( m[6] * c0 + m[7] * c1 ) + ( m[8] * c2 + offset[2] );
 
-	return outImage;
+		if( clip ) {
+			v0 = ( v0 < 0 ) ? 0 : ( ( v0 > 1 ) ? 1 : v0 );
+			v1 = ( v1 < 0 ) ? 0 : ( ( v1 > 1 ) ? 1 : v1 );
+			v2 = ( v2 < 0 ) ? 0 : ( ( v2 > 1 ) ? 1 : v2 );
+			}
+
+		out0[i] = v0;
+		out1[i] = v1;
+		out2[i] = v2;
+		}
 	}
 
 
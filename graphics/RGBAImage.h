@@ -32,6 +32,10 @@
  *
  * 2023-June-8     Jason Rohrer
  * Added a function for producing an Image from an 8-bit color byte array.
+ *
+ * 2026-October-14     Jason Rohrer
+ * getRGBABytes reads compact images directly without expanding them.
+ * filter( ChannelFilter* ) filters color channels in one pass.
  */
  
  
@@ -212,6 +216,28 @@ inline unsigned char *RGBAImage::getRGBABytes( Image *inImage ) {
     int numBytes = numPixels * 4; 
 	unsigned char *bytes = new unsigned char[ numBytes ];
 
+    if( inImage->isCompact() ) {
+        // already 8-bit, never widen to double
+        unsigned char *source = inImage->getCompactBytes();
+        
+        if( numChannels == 4 ) {
+            memcpy( bytes, source, numBytes );
+            return bytes;
+            }
+        else if( numChannels == 3 ) {
+            register int i = 0;
+            register int j = 0;
+            for( int p=0; p<numPixels; p++ ) {
+                bytes[i++] = source[j++];
+                bytes[i++] = source[j++];
+                bytes[i++] = source[j++];
+                bytes[i++] = 255;  // default alpha
+                }
+            return bytes;
+            }
+        // other channel counts take expanding path below
+        }
+    
     double *channelZero = inImage->getChannel( 0 );
     double *channelOne = inImage->getChannel( 1 );
     double *channelTwo = inImage->getChannel( 2 );
@@ -249,9 +275,7 @@ inline unsigned char *RGBAImage::getRGBABytes( Image *inImage ) {
 inline void RGBAImage::filter( ChannelFilter *inFilter ) {
 	// different from standard Image implementation in that we
 	// skip the alpha channel when filtering
-	for( int i=0; i<mNumChannels-1; i++ ) {
-		Image::filter( inFilter, i );
-		}	
+	filterChannels( inFilter, mNumChannels - 1 );
 	}
 
 
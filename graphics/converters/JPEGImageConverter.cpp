@@ -18,6 +18,11 @@
  *
  * 2019-July-1   Jason Rohrer
  * Fixed memory leaks and uninitialized value issue.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Decoding goes straight from memory to 8-bit pixels (RGB, RGBA, or
+ * grayscale), with optional DCT-domain downscaling.  deformatImage
+ * returns a compact image and no longer uses a temp file.
  */
 
  
@@ -29,11 +34,16 @@
  *
  * For now, it use libjpeg to write converted data out to
  * file, and then reads it back in.
+ *
+ * Decoding reads from memory.  Built against libjpeg-turbo (the libjpeg
+ * that most systems ship now), decoding runs its SIMD code, and RGBA
+ * is produced by its color converter instead of a separate pass.
  */
 
 
 #include "minorGems/graphics/converters/JPEGImageConverter.h"
 #include "minorGems/io/file/File.h"
+#include "minorGems/util/SimpleVector.h"
 
 
 #include <stdio.h>
@@ -46,6 +56,7 @@
 // (yuk... spent way too much time trying to figure this one out!)    
 extern "C" {
 #include<jpeglib.h>
+#include<jerror.h>
 	}
 
 /*
@@ -322,263 +333,278 @@ void JPEGImageConverter::formatImage( Image *inImage,
 
 
 
-Image *JPEGImageConverter::deformatImage( InputStream *inStream ) {
+// Source manager that reads JPEG data from memory, like libjpeg 8's
+// jpeg_mem_src (which older libjpeg versions lack).
 
-	// use a temp file with a random name to make this more
-	// thread-safe
-	char fileName[99];
-	sprintf( fileName, "temp%d.dat", rand() );
+static void memSourceInit( j_decompress_ptr cinfo ) {
+    }
 
-	FILE *tempFile = fopen( fileName, "wb" );
 
-	if( tempFile == NULL ) {
-		printf( "can't open jpeg conversion temp file %s\n", fileName );
-		return NULL;
-		}
+static boolean memSourceFill( j_decompress_ptr cinfo ) {
+    // out of data:  insert a fake EOI marker, as IJG's source managers
+    // do, so a truncated file gives a warning and a partial image
+    // instead of an error
+    static const JOCTET fakeEOI[2] = { 0xFF, JPEG_EOI };
 
-	// buffer for dumping stream to temp file
-	unsigned char *tempBuffer = new unsigned char[1]; 
-    tempBuffer[0] = 0;
-	unsigned char previousByte = 0;
+    WARNMS( cinfo, JWRN_JPEG_EOF );
+    
+    cinfo->src->next_input_byte = fakeEOI;
+    cinfo->src->bytes_in_buffer = 2;
 
-	// dump the JPEG stream from the input stream into tempFile
-	// so that we can pass this file to libjpeg
+    return TRUE;
+    }
 
-	/*
-	// optimization:  use a buffer to prevent too many fwrite calls
-	int bufferLength = 5000;
-	unsigned char *fileBuffer = new unsigned char[ bufferLength ];
-	int currentBufferPosition = 0;
-	
-	while( !( tempBuffer[0] == 0xD9 && previousByte == 0xFF ) ) {
-		previousByte = tempBuffer[0];
-		
-		inStream->read( tempBuffer, 1 );
 
-		fileBuffer[currentBufferPosition] = tempBuffer[0];
+static void memSourceSkip( j_decompress_ptr cinfo, long num_bytes ) {
+    if( num_bytes <= 0 ) {
+        return;
+        }
 
-		if( currentBufferPosition == bufferLength - 1 ) {
-			// at the end of the file buffer
-			fwrite( fileBuffer, 1, bufferLength, tempFile );
-			currentBufferPosition = 0;
-			}
-		else {
-			// keep filling the fileBuffer
-			currentBufferPosition++;
-			}
-		}
-	// now write remaining fileBuffer data to file
-	fwrite( fileBuffer, 1, currentBufferPosition + 1, tempFile );
+    if( (size_t)num_bytes > cinfo->src->bytes_in_buffer ) {
+        // skipping past end, fill will supply EOI
+        cinfo->src->next_input_byte += cinfo->src->bytes_in_buffer;
+        cinfo->src->bytes_in_buffer = 0;
+        }
+    else {
+        cinfo->src->next_input_byte += num_bytes;
+        cinfo->src->bytes_in_buffer -= num_bytes;
+        }
+    }
 
-	delete [] fileBuffer;
-	*/
-	
 
-    if( !mReadInputToEnd ) {
+static void memSourceTerm( j_decompress_ptr cinfo ) {
+    }
+
+
+
+// expands a row of inNumIn-channel pixels to inNumOut channels, in place
+// (row has room for the wider pixels)
+// 1 channel is copied to R, G, and B, and alpha is set to 255
+static void expandRow( JSAMPLE *inRow, int inWidth, 
+                       int inNumIn, int inNumOut ) {
+    // back to front, so no pixel is overwritten before it is read
+    for( int p=inWidth - 1; p>=0; p-- ) {
+        JSAMPLE *in = &( inRow[ p * inNumIn ] );
+        JSAMPLE *out = &( inRow[ p * inNumOut ] );
         
-        // read (and write to temp) until EOI sequence seen (0xFFD9)
-        while( !( tempBuffer[0] == 0xD9 && previousByte == 0xFF ) ) {
-            previousByte = tempBuffer[0];
-            
-            inStream->read( tempBuffer, 1 );
-            
-            fwrite( tempBuffer, 1, 1, tempFile );
+        JSAMPLE r, g, b;
+        if( inNumIn == 1 ) {
+            r = g = b = in[0];
             }
-        }
-    else {
-        int numRead = inStream->read( tempBuffer, 1 );
-        
-        while( numRead == 1 ) {
-            fwrite( tempBuffer, 1, 1, tempFile );
-            numRead = inStream->read( tempBuffer, 1 );
+        else {
+            r = in[0];
+            g = in[1];
+            b = in[2];
+            }
+
+        if( inNumOut == 4 ) {
+            out[3] = 255;
             }
+        out[2] = b;
+        out[1] = g;
+        out[0] = r;
         }
-    
-		
-	// end of jpeg stream reached.
-	fclose( tempFile );
-	delete [] tempBuffer;
-	
+    }
 
-	// the remainder of this method was mostly copied from
-	// IJG's example.c
 
 
+unsigned char *JPEGImageConverter::decodeToBytes( unsigned char *inData,
+                                                  int inLength,
+                                                  int inNumChannels,
+                                                  int inScaleDenominator,
+                                                  int *outWidth,
+                                                  int *outHeight ) {
+    
+    if( inNumChannels != 1 && inNumChannels != 3 && inNumChannels != 4 ) {
+        printf( "JPEG decoding only supports 1, 3, or 4 channels.\n" );
+        return NULL;
+        }
+    if( inScaleDenominator != 1 && inScaleDenominator != 2 &&
+        inScaleDenominator != 4 && inScaleDenominator != 8 ) {
+        printf( "JPEG decoding scale must be 1/1, 1/2, 1/4, or 1/8.\n" );
+        return NULL;
+        }
+    
 
-	/* This struct contains the JPEG decompression parameters and pointers to
-	 * working space (which is allocated as needed by the JPEG library).
-	 */
-	struct jpeg_decompress_struct cinfo;
-	/* We use our private extension JPEG error handler.
-	 * Note that this struct must live as long as the main JPEG parameter
-	 * struct, to avoid dangling-pointer problems.
-	 */
+    struct jpeg_decompress_struct cinfo;
 	struct my_error_mgr jerr;
-	/* More stuff */
-	FILE * infile;		/* source file */
-	JSAMPARRAY buffer;		/* Output row buffer */
-	int row_stride;		/* physical row width in output buffer */
-
-	/* In this example we want to open the input
-	 * file before doing anything else,
-	 * so that the setjmp() error recovery below can assume the file is open.
-	 * VERY IMPORTANT: use "b" option to fopen() if you are on a machine that
-	 * requires it in order to read binary files.
-	 */
-
-	if( ( infile = fopen( fileName, "rb" ) ) == NULL ) {
-		printf( "can't open jpeg conversion temp file %s\n", fileName );
-		return NULL;
-		}
+    struct jpeg_source_mgr source;
+    
+    // set after setjmp, so must be volatile to survive a longjmp
+    unsigned char * volatile pixels = NULL;
+    
 
-	/* Step 1: allocate and initialize JPEG decompression object */
-	
-	/* We set up the normal JPEG error routines, then override error_exit. */
-	cinfo.err = jpeg_std_error(&jerr.pub);
+	cinfo.err = jpeg_std_error( &jerr.pub );
 	jerr.pub.error_exit = my_error_exit;
-	/* Establish the setjmp return context for my_error_exit to use. */
+
 	if( setjmp( jerr.setjmp_buffer ) ) {
-		/* If we get here, the JPEG code has signaled an error.
-		 * We need to clean up the JPEG object,
-		 * close the input file, and return.
-		 */
 		jpeg_destroy_decompress( &cinfo );
-		fclose( infile );
-		printf( "error in decompressing jpeg from stream.\n" );
+
+        if( pixels != NULL ) {
+            delete [] pixels;
+            }
+		printf( "error in decompressing jpeg from memory.\n" );
 		return NULL;
 		}
-	/* Now we can initialize the JPEG decompression object. */
-	jpeg_create_decompress( &cinfo );
-
-	/* Step 2: specify data source (eg, a file) */
-
-	jpeg_stdio_src( &cinfo, infile );
-
-	/* Step 3: read file parameters with jpeg_read_header() */
 
-	(void) jpeg_read_header( &cinfo, TRUE );
-	/* We can ignore the return value from jpeg_read_header since
-	 *   (a) suspension is not possible with the stdio data source, and
-	 *   (b) we passed TRUE to reject a tables-only JPEG file as an error.
-	 * See libjpeg.doc for more info.
-	 */
+	jpeg_create_decompress( &cinfo );
 
-	/* Step 4: set parameters for decompression */
+    source.init_source = memSourceInit;
+    source.fill_input_buffer = memSourceFill;
+    source.skip_input_data = memSourceSkip;
+    source.resync_to_restart = jpeg_resync_to_restart;
+    source.term_source = memSourceTerm;
+    source.next_input_byte = inData;
+    source.bytes_in_buffer = inLength;
+    
+    cinfo.src = &source;
+    
+	jpeg_read_header( &cinfo, TRUE );
 
-	/* In this example, we don't need to change any of the defaults set by
-	 * jpeg_read_header(), so we do nothing here.
-	 */
+    
+    // have libjpeg produce exactly the pixels we want where it can,
+    // and expand rows ourselves where it can't
+    int numDecoded = inNumChannels;
+
+    if( inNumChannels == 1 ) {
+        // from a color image, this just takes Y (luma) without
+        // converting from YCbCr
+        cinfo.out_color_space = JCS_GRAYSCALE;
+        }
+    else if( cinfo.jpeg_color_space == JCS_GRAYSCALE ) {
+        // plain libjpeg can't convert grayscale to RGB
+        cinfo.out_color_space = JCS_GRAYSCALE;
+        numDecoded = 1;
+        }
+    else if( cinfo.jpeg_color_space == JCS_CMYK ||
+             cinfo.jpeg_color_space == JCS_YCCK ) {
+		jpeg_destroy_decompress( &cinfo );
+        printf( "CMYK JPEG images not supported.\n" );
+        return NULL;
+        }
+    else if( inNumChannels == 4 ) {
+        #ifdef JCS_EXTENSIONS
+        // libjpeg-turbo writes RGBA straight from its SIMD color
+        // converter
+        cinfo.out_color_space = JCS_EXT_RGBA;
+        #else
+        cinfo.out_color_space = JCS_RGB;
+        numDecoded = 3;
+        #endif
+        }
+    else {
+        cinfo.out_color_space = JCS_RGB;
+        }
+    
+    // scaled down during inverse DCT, which skips most of decoding
+    // work for thumbnails
+    cinfo.scale_num = 1;
+    cinfo.scale_denom = inScaleDenominator;
+    
 
-	/* Step 5: Start decompressor */
+	jpeg_start_decompress( &cinfo );
 
-	(void) jpeg_start_decompress( &cinfo );
-	/* We can ignore the return value since suspension is not possible
-	 * with the stdio data source.
-	 */
+	int w = cinfo.output_width;
+	int h = cinfo.output_height;
+    int rowBytes = w * inNumChannels;
+    
+    pixels = new unsigned char[ rowBytes * h ];
+    
+    // decoded straight into result, several rows per call where the
+    // decoder produces them (rec_outbuf_height)
+    JSAMPROW rows[4];
+    
+	while( cinfo.output_scanline < cinfo.output_height ) {
+        int firstRow = cinfo.output_scanline;
+        
+        int numRows = h - firstRow;
+        if( numRows > 4 ) {
+            numRows = 4;
+            }
+        for( int r=0; r<numRows; r++ ) {
+            rows[r] = &( pixels[ ( firstRow + r ) * rowBytes ] );
+            }
+        
+		int numRead = jpeg_read_scanlines( &cinfo, rows, numRows );
 
-	/* We may need to do some setup of our own at this point before reading
-	 * the data.  After jpeg_start_decompress() we have the correct scaled
-	 * output image dimensions available, as well as the output colormap
-	 * if we asked for color quantization.
-	 * In this example, we need to make an output work buffer of the right size.
-	 */ 
-	/* JSAMPLEs per row in output buffer */
-
-	int imageWidth = cinfo.output_width;
-	int imageHeight = cinfo.output_height;
-
-	// the return image with 3 channels
-	Image *returnImage = new Image( imageWidth, imageHeight, 3, false );
-
-	// channels of returnImage,
-	// which we will need to put pixel values into of
-	double *redChannel = returnImage->getChannel(0);
-	double *greenChannel = returnImage->getChannel(1);
-	double *blueChannel = returnImage->getChannel(2);
-	
+        if( numDecoded != inNumChannels ) {
+            for( int r=0; r<numRead; r++ ) {
+                expandRow( rows[r], w, numDecoded, inNumChannels );
+                }
+            }
+		}
 	
-	row_stride = cinfo.output_width * cinfo.output_components;
-	/* Make a one-row-high sample array that
-	 * will go away when done with image
-	 */
-	buffer = ( *cinfo.mem->alloc_sarray )
-		((j_common_ptr) &cinfo, JPOOL_IMAGE, row_stride, 1 );
+	jpeg_finish_decompress( &cinfo );
+	jpeg_destroy_decompress( &cinfo );
 
-	/* Step 6: while (scan lines remain to be read) */
-	/*           jpeg_read_scanlines(...); */
+    *outWidth = w;
+    *outHeight = h;
+    
+    return pixels;
+    }
 
-	/* Here we use the library's state variable cinfo.output_scanline as the
-	 * loop counter, so that we don't have to keep track ourselves.
-	 */
-	int rowNumber = 0;
-	double inv255 = 1.0 / 255.0;
-	
-	while( cinfo.output_scanline < cinfo.output_height ) {
-		/* jpeg_read_scanlines expects an array of pointers to scanlines.
-		 * Here the array is only one element long, but you could ask for
-		 * more than one scanline at a time if that's more convenient.
-		 */
-		(void) jpeg_read_scanlines( &cinfo, buffer, 1 );
 
-		// write the scanline into returnImage
-		
-		int yOffset = rowNumber * cinfo.output_width;
-		
-		// for each pixel in the row
-		// copy it into the return image channels
-		for( unsigned int p=0; p<cinfo.output_width; p++ ) {
 
-			// index into inImage
-			int pixelIndex = p + yOffset;
+Image *JPEGImageConverter::decodeToImage( unsigned char *inData,
+                                          int inLength,
+                                          int inNumChannels,
+                                          int inScaleDenominator ) {
+    int w, h;
+    unsigned char *pixels = decodeToBytes( inData, inLength, inNumChannels,
+                                           inScaleDenominator, &w, &h );
 
-			// index into this row
-			int startRowIndex = p * 3;
+    if( pixels == NULL ) {
+        return NULL;
+        }
+    
+    // compact image takes pixels over
+    return new Image( pixels, w, h, inNumChannels );
+    }
 
-			// red
-			redChannel[ pixelIndex ] =
-				buffer[0][ startRowIndex ] * inv255;
-			// green
-			greenChannel[ pixelIndex ] =
-				buffer[0][ startRowIndex + 1 ] * inv255;
-			// blue
-			blueChannel[ pixelIndex ] =
-				buffer[0][ startRowIndex + 2 ] * inv255;
-			}
-		
-		rowNumber++;
-		}
-	
-	/* Step 7: Finish decompression */
 
-	(void) jpeg_finish_decompress( &cinfo );
-	/* We can ignore the return value since suspension is not possible
-	 * with the stdio data source.
-	 */
 
-	/* Step 8: Release JPEG decompression object */
+Image *JPEGImageConverter::deformatImage( InputStream *inStream ) {
 
-	/* This is an important step since it will
-	 * release a good deal of memory.
-	 */
-	jpeg_destroy_decompress( &cinfo );
+    // gather JPEG stream from input stream, so we can decode it from
+    // memory
+    SimpleVector<unsigned char> data;
+    
+	unsigned char buffer[1];
+    buffer[0] = 0;
+	unsigned char previousByte = 0;
 
-	/* After finish_decompress, we can close the input file.
-	 * Here we postpone it until after no more JPEG errors are possible,
-	 * so as to simplify the setjmp error logic above.  (Actually, I don't
-	 * think that jpeg_destroy can do an error exit,
-	 * but why assume anything...)
-	 */
-	fclose( infile );
+    if( !mReadInputToEnd ) {
+        
+        // read until EOI sequence seen (0xFFD9)
+        while( !( buffer[0] == 0xD9 && previousByte == 0xFF ) ) {
+            previousByte = buffer[0];
+            
+            if( inStream->read( buffer, 1 ) != 1 ) {
+                // stream ended early, decode what we have
+                break;
+                }
+            
+            data.push_back( buffer[0] );
+            }
+        }
+    else {
+        // read in larger blocks
+        unsigned char block[4096];
+        
+        int numRead = inStream->read( block, 4096 );
+        
+        while( numRead > 0 ) {
+            data.push_back( block, numRead );
+            numRead = inStream->read( block, 4096 );
+            }
+        }
+    
 
-	/* At this point you may want to check to see whether any corrupt-data
-	 * warnings occurred (test whether jerr.pub.num_warnings is nonzero).
-	 */
+    unsigned char *dataBytes = data.getElementArray();
 
-	// delete this temporary file
-	remove( fileName );
-	
-	
-	/* And we're done! */
-	return returnImage;
-	}
+    Image *returnImage = decodeToImage( dataBytes, data.size(), 3, 1 );
 
+    delete [] dataBytes;
+    
+    return returnImage;
+	}
@@ -7,6 +7,9 @@
  * 2011-June-21   Jason Rohrer
  * Added flag for forcing input to read until end.  Some JPG files
  * contain more than one image and thus have FFD9 in the middle.   
+ *
+ * 2026-October-15   Jason Rohrer
+ * Added decoding from memory straight to 8-bit pixels, with downscaling.
  */
  
  
@@ -63,8 +66,46 @@ class JPEGImageConverter : public ImageConverter {
 		virtual void formatImage( Image *inImage, 
 			OutputStream *inStream );
 			
+		// returns a compact 3-channel image
 		virtual Image *deformatImage( InputStream *inStream );		
 
+
+		/**
+		 * Decodes JPEG data in memory straight to 8-bit pixels, without
+		 * going through double channels.
+		 *
+		 * Can be called from several threads at once.
+		 *
+		 * @param inData the JPEG file data.  Destroyed by caller.
+		 * @param inLength the length of inData.
+		 * @param inNumChannels 1 for grayscale, 3 for RGB, or 4 for RGBA
+		 *   (with alpha set to 255).
+		 * @param inScaleDenominator 1, 2, 4, or 8 to decode at that
+		 *   fraction of full size (rounded up), scaled during the inverse
+		 *   DCT, which skips most of the work of a full-size decode.
+		 *   Good for thumbnails.
+		 * @param outWidth, outHeight pointers to where the decoded
+		 *   dimensions should be returned.
+		 *
+		 * @return interleaved pixels (RGBRGB... for 3 channels), or NULL
+		 *   on failure.  Destroyed by caller.
+		 */
+		static unsigned char *decodeToBytes( unsigned char *inData,
+											 int inLength,
+											 int inNumChannels,
+											 int inScaleDenominator,
+											 int *outWidth,
+											 int *outHeight );
+
+
+		/**
+		 * Same as decodeToBytes, but returns a compact Image, or NULL
+		 * on failure.
+		 */
+		static Image *decodeToImage( unsigned char *inData, int inLength,
+									 int inNumChannels = 3,
+									 int inScaleDenominator = 1 );
+
 		
 	private:
 		int mQuality;
@@ -9,6 +9,10 @@
  *
  * 2011-April-5     Jason Rohrer
  * Fixed float-to-int conversion.  
+ *
+ * 2026-October-15    Jason Rohrer
+ * Built-in encoder modes with per-row filter choice and parallel deflate.
+ * Removed unreachable stored-block encoder.
  */
 
 
@@ -16,19 +20,23 @@
 
 #include "minorGems/util/SimpleVector.h"
 #include "minorGems/graphics/RGBAImage.h"
+#include "minorGems/system/ThreadPool.h"
+#include "minorGems/formats/ZipStream.h"
 
 #include <math.h>
+#include <stdlib.h>
 
-//#include "lodepng.h"
-
-//#include <zlib.h>
+// for crc32 and adler32, without names that clash with libpng's zlib.h
+#define MINIZ_NO_ZLIB_COMPATIBLE_NAMES
+#include "minorGems/formats/miniz.h"
 
 #include <png.h>
 
 
 
-PNGImageConverter::PNGImageConverter( int inCompressionLevel )
-        : mCompressionLevel( inCompressionLevel  ) {
+PNGImageConverter::PNGImageConverter( int inCompressionLevel,
+                                      PNGEncoderMode inMode )
+        : mCompressionLevel( inCompressionLevel  ), mMode( inMode ) {
 
     // set up the CRC table
     
@@ -72,35 +80,6 @@ unsigned long PNGImageConverter::updateCRC(
 
 
 
-#define ADLER_BASE 65521 /* largest prime smaller than 65536 */
-
-/**
- * Updates an adler32 checksum.
- * code found here  http://www.ietf.org/rfc/rfc1950.txt
- *
- * New adlers should start with inAdler set to 1.
- *
- * @param inAdler the current state of the checksum.
- * @param inData the data to add.  Destroyed by caller.
- * @param inLength the length of the data in bytes.
- *
- * @return the new checksum.
- */
-unsigned long updateAdler32( unsigned long inAdler,
-                             unsigned char *inData, int inLength ) {
-    unsigned long s1 = inAdler & 0xffff;
-    unsigned long s2 = (inAdler >> 16) & 0xffff;
-    int n;
-
-    for (n = 0; n < inLength; n++) {
-        s1 = (s1 + inData[n]) % ADLER_BASE;
-        s2 = (s2 + s1)     % ADLER_BASE;
-        }
-    return (s2 << 16) + s1;
-    }
-
-
-
 void PNGImageConverter::writeChunk(
     const char inChunkType[4], unsigned char *inData,
     unsigned long inNumBytes, OutputStream *inStream ) {
@@ -139,205 +118,358 @@ void PNGImageConverter::writeChunk(
 
 
 
-// callbacks for libpng io
-void libpngWriteCallback( png_structp png_ptr,
-                          png_bytep data, png_size_t length ) {
-    
-    // unpack our extra parameter
-    void *write_io_ptr = png_get_io_ptr( png_ptr );
-
-    OutputStream *inStream = (OutputStream *)write_io_ptr;    
-    
-    inStream->write( data, length );
-    }
-
-
-
-void libpngFlushCallback( png_structp png_ptr ) {
-    // do nothing?
-    }
+// Built-in encoder
+//
+// Rows are filtered in parallel, each with the filter type that gives
+// the smallest sum of absolute (signed) byte values, a heuristic from
+// the PNG spec that tracks compressed size well and costs one pass per
+// filter tried.
+//
+// The filtered bytes are then split into chunks that are deflated in
+// parallel (as pigz does).  The first chunk starts a zlib stream, and
+// each later chunk is a raw deflate stream with the chunk before it as
+// its preset dictionary, so matches across chunk boundaries aren't
+// lost.  Every chunk but the last ends with a sync flush (an empty
+// stored block that byte-aligns the stream), so the chunks concatenate
+// into one valid zlib stream.  Each chunk becomes an IDAT chunk, with
+// its CRC and its share of the zlib Adler-32 computed in the same task.
 
 
+// filtered bytes per deflate chunk
+#define PNG_DEFLATE_CHUNK_BYTES ( 256 * 1024 )
 
-void PNGImageConverter::formatImage( Image *inImage, 
-	OutputStream *inStream ) {
+// fewer rows than this are filtered on the calling thread
+#define PNG_MIN_FILTER_BAND_ROWS 32
 
-	int numChannels = inImage->getNumChannels();
-	
-	// make sure the image is in the right format
-	if( numChannels != 3 &&
-		numChannels != 4 ) {
-		printf( "Only 3- and 4-channel images can be converted to " );
-		printf( "the PNG format.\n" );
-		return;
-		}
 
-	int w = inImage->getWidth();
-	int h = inImage->getHeight();
-	
-    //RGBAImage rgbaImage( inImage );
-    
-    unsigned char *imageBytes = RGBAImage::getRGBABytes( inImage );
+typedef struct PNGEncodeJob {
+        // interleaved 8-bit pixels, bytesPerPixel per pixel
+        unsigned char *pixels;
+        int bytesPerPixel;
+        int rowBytes;
+        int height;
+        
+        // 3 tries None, Sub, and Up, 5 adds Average and Paeth
+        int numFiltersToTry;
 
-    
+        // rowBytes + 1 per row, starting with filter type byte
+        unsigned char *filtered;
+        int numFilteredBytes;
 
-    // libpng implementation
+        int deflateLevel;
+        int chunkBytes;
+        int numChunks;
+        
+        // one per chunk
+        SimpleVector<unsigned char> *chunkData;
+        unsigned long *chunkCRCs;
+        unsigned long *chunkAdlers;
+    } PNGEncodeJob;
 
-    // adapted from this:
-    //  http://zarb.org/~gc/html/libpng.html
 
 
-    // get pointers to rows
-    unsigned char **rows = new unsigned char *[h];
+static unsigned char paethPredictor( int inA, int inB, int inC ) {
+    int p = inA + inB - inC;
+    int pa = abs( p - inA );
+    int pb = abs( p - inB );
+    int pc = abs( p - inC );
     
-    for( int y=0; y<h; y++ ) {
-        rows[y] = &( imageBytes[ y * (w * 4) ] );
+    if( pa <= pb && pa <= pc ) {
+        return inA;
+        }
+    else if( pb <= pc ) {
+        return inB;
         }
+    return inC;
+    }
 
 
-    png_structp png_ptr;
-    png_infop info_ptr;
 
-	// initialize structures
-	png_ptr = png_create_write_struct( PNG_LIBPNG_VER_STRING, 
-                                       NULL, NULL, NULL );
-	if( !png_ptr ) {
-        delete [] imageBytes;
-        delete [] rows;
-        printf( "PNG Writing:  png_create_write_struct failed\n" );
-        return;
-        }
+// filters one row into outRow with a given filter type
+// returns sum of absolute values of filtered bytes, viewed as signed
+// inPrevRow is NULL for first row
+static unsigned long filterRow( int inFilterType,
+                                unsigned char *inRow,
+                                unsigned char *inPrevRow,
+                                int inRowBytes, int inBytesPerPixel,
+                                unsigned char *outRow ) {
+    unsigned long sum = 0;
+    int i;
     
-    png_set_compression_level( png_ptr, mCompressionLevel );
+    #define PNG_FILTER_OUT( value ) \
+        outRow[i] = (unsigned char)( value ); \
+        sum += abs( (signed char)outRow[i] );
 
+    switch( inFilterType ) {
+        case 0:
+            for( i=0; i<inRowBytes; i++ ) {
+                PNG_FILTER_OUT( inRow[i] );
+                }
+            break;
+        case 1:
+            for( i=0; i<inBytesPerPixel; i++ ) {
+                PNG_FILTER_OUT( inRow[i] );
+                }
+            for( ; i<inRowBytes; i++ ) {
+                PNG_FILTER_OUT( inRow[i] - inRow[ i - inBytesPerPixel ] );
+                }
+            break;
+        case 2:
+            if( inPrevRow == NULL ) {
+                return filterRow( 0, inRow, inPrevRow, inRowBytes,
+                                  inBytesPerPixel, outRow );
+                }
+            for( i=0; i<inRowBytes; i++ ) {
+                PNG_FILTER_OUT( inRow[i] - inPrevRow[i] );
+                }
+            break;
+        case 3:
+            if( inPrevRow == NULL ) {
+                for( i=0; i<inBytesPerPixel; i++ ) {
+                    PNG_FILTER_OUT( inRow[i] );
+                    }
+                for( ; i<inRowBytes; i++ ) {
+                    PNG_FILTER_OUT( inRow[i] - 
+                                    ( inRow[ i - inBytesPerPixel ] >> 1 ) );
+                    }
+                break;
+                }
+            for( i=0; i<inBytesPerPixel; i++ ) {
+                PNG_FILTER_OUT( inRow[i] - ( inPrevRow[i] >> 1 ) );
+                }
+            for( ; i<inRowBytes; i++ ) {
+                PNG_FILTER_OUT( inRow[i] - 
+                                ( ( inRow[ i - inBytesPerPixel ] +
+                                    inPrevRow[i] ) >> 1 ) );
+                }
+            break;
+        case 4:
+            if( inPrevRow == NULL ) {
+                // Paeth of first row is Sub
+                return filterRow( 1, inRow, inPrevRow, inRowBytes,
+                                  inBytesPerPixel, outRow );
+                }
+            for( i=0; i<inBytesPerPixel; i++ ) {
+                PNG_FILTER_OUT( inRow[i] - inPrevRow[i] );
+                }
+            for( ; i<inRowBytes; i++ ) {
+                PNG_FILTER_OUT( 
+                    inRow[i] - 
+                    paethPredictor( inRow[ i - inBytesPerPixel ],
+                                    inPrevRow[i],
+                                    inPrevRow[ i - inBytesPerPixel ] ) );
+                }
+            break;
+        }
 
-	info_ptr = png_create_info_struct( png_ptr );
-	
-    if( !info_ptr ) {
-        delete [] imageBytes;
-        delete [] rows;
-        png_destroy_write_struct( &png_ptr, NULL );
+    #undef PNG_FILTER_OUT
 
-        printf( "PNG Writing:  png_create_info_struct failed\n" );
-        return;
-        }
-    
-    // weird way that libpng handles errors with a jump
-	if( setjmp( png_jmpbuf( png_ptr ) ) ) {
-        delete [] imageBytes;
-        delete [] rows;
-        png_destroy_write_struct( &png_ptr, &info_ptr );
+    return sum;
+    }
 
-        printf( "PNG Writing: error when setting writing funciton\n" );
-        return;
-        }
-    
 
-	//png_init_io(png_ptr, fp);
 
+static void filterBand( void *inContext, int inStart, int inEnd ) {
+    PNGEncodeJob *job = (PNGEncodeJob *)inContext;
 
-    // set our write callback (since we're not writing directly to file)
-    // pass the stream as the extra void* parameter
-    png_set_write_fn( png_ptr,
-                      (void*)inStream, 
-                      libpngWriteCallback,
-                      libpngFlushCallback );
+    int rowBytes = job->rowBytes;
+    
+    // one scratch row per filter type
+    unsigned char *scratch = new unsigned char[ 5 * rowBytes ];
     
+    for( int y=inStart; y<inEnd; y++ ) {
+        unsigned char *row = &( job->pixels[ y * rowBytes ] );
+        unsigned char *prevRow = NULL;
+        if( y > 0 ) {
+            prevRow = &( job->pixels[ ( y - 1 ) * rowBytes ] );
+            }
 
-	// write header
-	if( setjmp( png_jmpbuf( png_ptr ) ) ) {
-        delete [] imageBytes;
-        delete [] rows;
-        png_destroy_write_struct( &png_ptr, &info_ptr );
+        int bestType = 0;
+        unsigned long bestSum = 0;
+        
+        for( int f=0; f<job->numFiltersToTry; f++ ) {
+            unsigned long sum = filterRow( f, row, prevRow, 
+                                           rowBytes, job->bytesPerPixel,
+                                           &( scratch[ f * rowBytes ] ) );
+            if( f == 0 || sum < bestSum ) {
+                bestType = f;
+                bestSum = sum;
+                }
+            }
 
-        printf( "PNG Writing: error writing header\n" );
-        return;
+        unsigned char *dest = &( job->filtered[ y * ( rowBytes + 1 ) ] );
+        
+        dest[0] = (unsigned char)bestType;
+        memcpy( &( dest[1] ), &( scratch[ bestType * rowBytes ] ), 
+                rowBytes );
         }
 
-	png_set_IHDR( png_ptr, info_ptr, w, h,
-                  8, PNG_COLOR_TYPE_RGB_ALPHA, PNG_INTERLACE_NONE,
-                  PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE );
+    delete [] scratch;
+    }
 
-	png_write_info( png_ptr, info_ptr );
 
 
-	// write bytes
-    // write header
-	if( setjmp( png_jmpbuf( png_ptr ) ) ) {
-        delete [] imageBytes;
-        delete [] rows;
-        png_destroy_write_struct( &png_ptr, &info_ptr );
+static void deflateBand( void *inContext, int inStart, int inEnd ) {
+    PNGEncodeJob *job = (PNGEncodeJob *)inContext;
 
-        printf( "PNG Writing: error writing image bytes\n" );
-        return;
+    for( int c=inStart; c<inEnd; c++ ) {
+        int start = c * job->chunkBytes;
+        int length = job->chunkBytes;
+        if( start + length > job->numFilteredBytes ) {
+            length = job->numFilteredBytes - start;
+            }
+        
+        SimpleVector<unsigned char> *out = &( job->chunkData[c] );
+        
+        // filtered strategy skips short matches, which don't pay for
+        // themselves in filtered image data
+        // compressor only keeps last 32 KiB of dictionary
+        ZipCompressor compressor( job->deflateLevel, ZIP_FILTERED,
+                                  job->filtered, start );
+
+        ZipFlush flush = ZIP_SYNC_FLUSH;
+        if( c == job->numChunks - 1 ) {
+            flush = ZIP_FINISH;
+            }
+        
+        compressor.compress( &( job->filtered[ start ] ), length, out,
+                             flush );
+
+        unsigned char *data = out->getElementArray();
+        
+        // CRC covers chunk type too
+        unsigned long crc = mz_crc32( MZ_CRC32_INIT, 
+                                      (unsigned char *)"IDAT", 4 );
+        job->chunkCRCs[c] = mz_crc32( crc, data, out->size() );
+        
+        delete [] data;
+        
+        job->chunkAdlers[c] = mz_adler32( MZ_ADLER32_INIT,
+                                          &( job->filtered[ start ] ),
+                                          length );
         }
+    }
 
-	png_write_image( png_ptr, rows );
 
 
-	// end write
-    if( setjmp( png_jmpbuf( png_ptr ) ) ) {
-        delete [] imageBytes;
-        delete [] rows;
-        png_destroy_write_struct( &png_ptr, &info_ptr );
+#define ADLER_BASE 65521 /* largest prime smaller than 65536 */
 
-        printf( "PNG Writing: error ending write\n" );
-        return;
+// Adler-32 of two blocks joined, from the Adler-32 of each and the
+// length of the second (like zlib's adler32_combine)
+static unsigned long combineAdler32( unsigned long inAdlerA,
+                                     unsigned long inAdlerB,
+                                     unsigned long inLengthB ) {
+    unsigned long rem = inLengthB % ADLER_BASE;
+    
+    unsigned long sumA = inAdlerA & 0xffff;
+    unsigned long sumB = ( rem * sumA ) % ADLER_BASE;
+    
+    sumA += ( inAdlerB & 0xffff ) + ADLER_BASE - 1;
+    sumB += ( ( inAdlerA >> 16 ) & 0xffff ) + 
+        ( ( inAdlerB >> 16 ) & 0xffff ) + ADLER_BASE - rem;
+    
+    if( sumA >= ADLER_BASE ) {
+        sumA -= ADLER_BASE;
+        }
+    if( sumA >= ADLER_BASE ) {
+        sumA -= ADLER_BASE;
+        }
+    if( sumB >= ( ADLER_BASE << 1 ) ) {
+        sumB -= ( ADLER_BASE << 1 );
         }
+    if( sumB >= ADLER_BASE ) {
+        sumB -= ADLER_BASE;
+        }
+    return ( sumB << 16 ) | sumA;
+    }
 
-	png_write_end( png_ptr, NULL );
 
 
-    png_destroy_write_struct( &png_ptr, &info_ptr );
+void PNGImageConverter::encodeImage( Image *inImage, 
+                                     OutputStream *inStream ) {
     
-    delete [] imageBytes;
-    delete [] rows;
+    int numChannels = inImage->getNumChannels();
+    int w = inImage->getWidth();
+    int h = inImage->getHeight();
+    int numPixels = w * h;
     
-
-    if( true ) {
-        return;
+    // RGB images stay RGB, without an alpha channel
+    // compact RGB bytes are used directly
+    unsigned char *pixelBytes;
+    char pixelBytesOwned = true;
+    
+    if( numChannels == 4 ) {
+        pixelBytes = RGBAImage::getRGBABytes( inImage );
+        }
+    else if( inImage->isCompact() ) {
+        pixelBytes = inImage->getCompactBytes();
+        pixelBytesOwned = false;
+        }
+    else {
+        pixelBytes = new unsigned char[ numPixels * 3 ];
+        
+        double *channels[3];
+        for( int c=0; c<3; c++ ) {
+            channels[c] = inImage->getChannel( c );
+            }
+        
+        int i = 0;
+        for( int p=0; p<numPixels; p++ ) {
+            for( int c=0; c<3; c++ ) {
+                pixelBytes[i++] = 
+                    (unsigned char)( lrint( 255 * channels[c][p] ) );
+                }
+            }
         }
     
 
+    PNGEncodeJob job;
 
+    job.pixels = pixelBytes;
+    job.bytesPerPixel = numChannels;
+    job.rowBytes = w * numChannels;
+    job.height = h;
 
+    job.numFilteredBytes = ( job.rowBytes + 1 ) * h;
+    job.filtered = new unsigned char[ job.numFilteredBytes ];
 
-
-
+    int level;
     
+    if( mMode == PNG_ENCODE_SMALL ) {
+        job.numFiltersToTry = 5;
+        level = 9;
+        }
+    else {
+        job.numFiltersToTry = 3;
+        level = 1;
+        }
 
-
-
-
-    /*
-
-    // LodePNG implementation
+    job.deflateLevel = level;
     
-    unsigned char *encodedBytes;
-    size_t encodedSize;
-
-    unsigned int error = LodePNG_encode32( &encodedBytes, &encodedSize, 
-                                           imageBytes, w, h );
+    int rowsPerChunk = PNG_DEFLATE_CHUNK_BYTES / ( job.rowBytes + 1 );
+    if( rowsPerChunk < 1 ) {
+        rowsPerChunk = 1;
+        }
+    job.chunkBytes = rowsPerChunk * ( job.rowBytes + 1 );
     
-    delete [] imageBytes;
+    int numChunks = ( h + rowsPerChunk - 1 ) / rowsPerChunk;
+    job.numChunks = numChunks;
     
-    if( error ) {
-        delete [] encodedBytes;
-        
-        printf( "Error encoding PNG image\n" );
-        return;
-        }
+    job.chunkData = new SimpleVector<unsigned char>[ numChunks ];
+    job.chunkCRCs = new unsigned long[ numChunks ];
+    job.chunkAdlers = new unsigned long[ numChunks ];
 
-    inStream->write( encodedBytes, encodedSize );
-
-    delete [] encodedBytes;
     
-    if( true ) {
-        return;
-        }
+    ThreadPool *pool = ThreadPool::getSharedPool();
+    
+    pool->parallelFor( filterBand, &job, h, PNG_MIN_FILTER_BAND_ROWS );
+    
+    pool->parallelFor( deflateBand, &job, numChunks, 1 );
     
-    */    
 
+    if( pixelBytesOwned ) {
+        delete [] pixelBytes;
+        }
 
 
     // same for all PNG images
@@ -367,8 +499,13 @@ void PNGImageConverter::formatImage( Image *inImage,
     headerData[8] = 8;
 
     // color type
-    // 2 = truecolor (RGB)
-    headerData[9] = 2;
+    // 2 = truecolor (RGB), 6 = truecolor with alpha (RGBA)
+    if( numChannels == 4 ) {
+        headerData[9] = 6;
+        }
+    else {
+        headerData[9] = 2;
+        }
 
     // compression method
     // method 0  (deflate)
@@ -383,258 +520,213 @@ void PNGImageConverter::formatImage( Image *inImage,
 
     writeChunk( "IHDR", headerData, 13, inStream );
 
+    
+    // one IDAT chunk per deflated chunk
+    
+    unsigned long adler = MZ_ADLER32_INIT;
+    
+    for( int c=0; c<numChunks; c++ ) {
+        unsigned char *data = job.chunkData[c].getElementArray();
+        int dataLength = job.chunkData[c].size();
 
-    int numRawBytes = w * h * 3;
-    // extra byte per scanline for filter type
-    numRawBytes += h;
-
-    unsigned char *rawScanlineBytes = new unsigned char[ numRawBytes ];
+        writeBigEndianLong( dataLength, inStream );
+        inStream->write( (unsigned char *)"IDAT", 4 );
+        inStream->write( data, dataLength );
+        writeBigEndianLong( job.chunkCRCs[c], inStream );
+        
+        delete [] data;
 
-    // ignore alpha channel
-    double *channels[3];
-    int i;
-    for( i=0; i<3; i++ ) {
-        channels[i] = inImage->getChannel( i );
+        int chunkLength = job.chunkBytes;
+        if( c == numChunks - 1 ) {
+            chunkLength = job.numFilteredBytes - c * job.chunkBytes;
+            }
+        adler = combineAdler32( adler, job.chunkAdlers[c], chunkLength );
         }
 
-    int pixelNumber = 0;
-    for( int y=0; y<h; y++ ) {
-        // each scanline starts with filter type byte
-        // using filter type 0 (no filtering)
-
-        int index = y * ( w * 3 + 1 );
-
-        // filter type
-        rawScanlineBytes[ index ] = 0;
-
-        index++;
-
-        for( int x=0; x<w; x++ ) {
-
-            for( i=0; i<3; i++ ) {
-                rawScanlineBytes[ index ] =
-                    (unsigned char)( lrint( 255 * channels[i][pixelNumber] ) );
-
-                index ++;
-                }
-
-            pixelNumber++;
-            }        
+    if( numChunks > 1 ) {
+        // last chunk was raw deflate, so zlib stream still needs its
+        // Adler-32 of all the uncompressed data
+        unsigned char adlerBytes[4] = { (unsigned char)( adler >> 24 ),
+                                        (unsigned char)( adler >> 16 ),
+                                        (unsigned char)( adler >> 8 ),
+                                        (unsigned char)adler };
+        
+        writeChunk( "IDAT", adlerBytes, 4, inStream );
         }
 
+    
+    // no data in end chunk
+    writeChunk( "IEND", NULL, 0, inStream );
 
-    // zlib block contains
-    // zlib compression method  (1 byte)
-    // flags  (1 byte)
-    // compressed data blocks
-    // check value (4 bytes) (not CRC)
 
-    SimpleVector<unsigned char> zlibBlock;
+    delete [] job.filtered;
+    delete [] job.chunkData;
+    delete [] job.chunkCRCs;
+    delete [] job.chunkAdlers;
+    }
 
-    // compression method 8 (deflate)
-    // with a LZ77 window size parameter of w=7
-    // LZ77 window size is then 2^( w + 8 ), or in this case 32768
-    zlibBlock.push_back( 0x78 );
 
-    // flags
-    // compression level 0  (2 bytes = 00b)
-    // no preset dictionary (1 byte = 0b)
-    // check bits for compression method (5 bits)
-    //   Should be such that if the 8-bit compression method, followed
-    //   by the 8-bit flags field, is viewed as a 16-bit number,
-    //   it is an even multiple of 31
-    //   For our settings, check bits of 00001 works
-    //zlibBlock.push_back( 0x01 );
-    // hack:  mimic zlib here
-    zlibBlock.push_back( 0xda );
 
+// callbacks for libpng io
+void libpngWriteCallback( png_structp png_ptr,
+                          png_bytep data, png_size_t length ) {
     
-    // now ready for compressed data blocks
-
-    int rawDataIndex = 0;
+    // unpack our extra parameter
+    void *write_io_ptr = png_get_io_ptr( png_ptr );
 
-    // length field is 16 bits
-    int maxUncompressedBlockLength = 65535;
+    OutputStream *inStream = (OutputStream *)write_io_ptr;    
     
-    while( rawDataIndex < numRawBytes ) {
-
-        // push another deflate block
-
-        // first bit BFINAL
-        //   only 1 for final block
-        // next two bits BTYPE
-        //   BTYPE=00 is an uncompressed block
-        // remaining 5 bits ignored
-        // Thus, we put 0x00 for uncompressed blocks that are not final
-        // and 0x80 for final uncompressed block
-
-        
-        int bytesLeft = numRawBytes - rawDataIndex;
+    inStream->write( data, length );
+    }
 
-        int bytesInBlock;
-        
-        if( bytesLeft <= maxUncompressedBlockLength ) {
-            // final
 
-            // hack:  when comparing output with zlib, noticed that it doesn't
-            // set 0x80 for the final block, instead it uses 0x01
-            // For some reason, this was making the PNG unreadable
-            // zlibBlock.push_back( 0x80 );
-            zlibBlock.push_back( 0x01 );
 
-            bytesInBlock = bytesLeft;
-            }
-        else {
-            // not final
-            zlibBlock.push_back( 0x00 );
-            
-            bytesInBlock = maxUncompressedBlockLength;
-            }
+void libpngFlushCallback( png_structp png_ptr ) {
+    // do nothing?
+    }
 
-        // length in least-significant-byte-first order
-        unsigned char firstLengthByte = bytesInBlock & 0xff;
-        unsigned char secondLengthByte = (bytesInBlock >> 8) & 0xff;
-        zlibBlock.push_back( firstLengthByte );
-        zlibBlock.push_back( secondLengthByte );
 
-        // those same length bytes inverted
-        // (called "one's compliment" in the spec
-        zlibBlock.push_back( firstLengthByte ^ 0xff);
-        zlibBlock.push_back( secondLengthByte ^ 0xff );
 
-        // now the uncompressed data
+void PNGImageConverter::formatImage( Image *inImage, 
+	OutputStream *inStream ) {
 
-        for( int b=0; b< bytesInBlock; b++ ) {
-            zlibBlock.push_back( rawScanlineBytes[ rawDataIndex ] );
+	int numChannels = inImage->getNumChannels();
+	
+	// make sure the image is in the right format
+	if( numChannels != 3 &&
+		numChannels != 4 ) {
+		printf( "Only 3- and 4-channel images can be converted to " );
+		printf( "the PNG format.\n" );
+		return;
+		}
 
-            rawDataIndex++;
-            }
+    if( mMode != PNG_ENCODE_LIBPNG ) {
+        encodeImage( inImage, inStream );
+        return;
         }
     
-
-    // finally, adler32 of original data
-    unsigned long adler = updateAdler32( 1L, rawScanlineBytes, numRawBytes );
-    
-    zlibBlock.push_back( (adler >> 24) & 0xff );
-    zlibBlock.push_back( (adler >> 16) & 0xff );
-    zlibBlock.push_back( (adler >> 8) & 0xff );
-    zlibBlock.push_back( adler & 0xff );
+	int w = inImage->getWidth();
+	int h = inImage->getHeight();
+	
+    //RGBAImage rgbaImage( inImage );
     
+    unsigned char *imageBytes = RGBAImage::getRGBABytes( inImage );
 
-    // the zlib block is now complete
+    
 
+    // libpng implementation
 
+    // adapted from this:
+    //  http://zarb.org/~gc/html/libpng.html
 
-    
-    /*
-    // check against real zlib implementation
-    z_stream zStream;
 
-    zStream.next_in = rawScanlineBytes;
-    zStream.avail_in = numRawBytes;
-    zStream.total_in = 0;
+    // get pointers to rows
+    unsigned char **rows = new unsigned char *[h];
     
-    int outSize = 2 * numRawBytes + 100;
-    unsigned char *zlibOutBuffer = new unsigned char[ outSize ]; 
-    zStream.next_out = zlibOutBuffer;
-    zStream.avail_out = outSize;
-    zStream.total_out = 0;
-
-    zStream.data_type = Z_BINARY;
+    for( int y=0; y<h; y++ ) {
+        rows[y] = &( imageBytes[ y * (w * 4) ] );
+        }
 
-    zStream.zalloc = Z_NULL;
-    zStream.zfree = Z_NULL;
 
-    // init the stream
-    // no compression
-    int result;
-    //result = deflateInit( &zStream, Z_DEFAULT_COMPRESSION);
-    result = deflateInit( &zStream, Z_NO_COMPRESSION);
+    png_structp png_ptr;
+    png_infop info_ptr;
 
-    if( result != Z_OK ) {
-        printf( "zlib deflateInit error: %s\n", zStream.msg );
+	// initialize structures
+	png_ptr = png_create_write_struct( PNG_LIBPNG_VER_STRING, 
+                                       NULL, NULL, NULL );
+	if( !png_ptr ) {
+        delete [] imageBytes;
+        delete [] rows;
+        printf( "PNG Writing:  png_create_write_struct failed\n" );
+        return;
         }
-
     
-    // deflate and flush
-    result = deflate( &zStream, Z_FINISH );
+    png_set_compression_level( png_ptr, mCompressionLevel );
 
-    if( result != Z_STREAM_END ) {
-        printf( "zlib deflate error (%d): %s\n", result, zStream.msg );
+
+	info_ptr = png_create_info_struct( png_ptr );
+	
+    if( !info_ptr ) {
+        delete [] imageBytes;
+        delete [] rows;
+        png_destroy_write_struct( &png_ptr, NULL );
+
+        printf( "PNG Writing:  png_create_info_struct failed\n" );
+        return;
         }
-    printf( "Total in = %d, total out = %d\n",
-            zStream.total_in, zStream.total_out );
-    
     
+    // weird way that libpng handles errors with a jump
+	if( setjmp( png_jmpbuf( png_ptr ) ) ) {
+        delete [] imageBytes;
+        delete [] rows;
+        png_destroy_write_struct( &png_ptr, &info_ptr );
 
-    
-    printf( "Our raw bytes (%d):\n", numRawBytes );
-    int b;
-    for( b=0; b<numRawBytes; b++ ) {
-        printf( "%02x ", rawScanlineBytes[ b ] );
+        printf( "PNG Writing: error when setting writing funciton\n" );
+        return;
         }
     
-    printf( "\n\nOur zlib bytes (%d) (adler = %d) :\n",
-            zlibBlock.size(), adler );
+
+	//png_init_io(png_ptr, fp);
+
+
+    // set our write callback (since we're not writing directly to file)
+    // pass the stream as the extra void* parameter
+    png_set_write_fn( png_ptr,
+                      (void*)inStream, 
+                      libpngWriteCallback,
+                      libpngFlushCallback );
     
-    for( b=0; b<zlibBlock.size(); b++ ) {
-        printf( "%02x ", *( zlibBlock.getElement( b ) ) );
-        }
 
+	// write header
+	if( setjmp( png_jmpbuf( png_ptr ) ) ) {
+        delete [] imageBytes;
+        delete [] rows;
+        png_destroy_write_struct( &png_ptr, &info_ptr );
 
-    printf( "\n\nTheir zlib bytes (%d) (adler = %d) :\n",
-            (int)( zStream.total_out ), zStream.adler );
-    for( b=0; b<zStream.total_out; b++ ) {
-        printf( "%02x ", zlibOutBuffer[ b ] );
+        printf( "PNG Writing: error writing header\n" );
+        return;
         }
 
-    int minBytes = zStream.total_out;
-    if( minBytes > zlibBlock.size() ) {
-        minBytes = zlibBlock.size();
-        }
+	png_set_IHDR( png_ptr, info_ptr, w, h,
+                  8, PNG_COLOR_TYPE_RGB_ALPHA, PNG_INTERLACE_NONE,
+                  PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE );
 
-    for( b=0; b<minBytes; b++ ) {
-        if( zlibOutBuffer[b] != *( zlibBlock.getElement( b ) ) ) {
-            printf( "mismatch at byte %d\n", b );
-            printf( "Theirs: %02x, ours: %02x\n", zlibOutBuffer[b],
-                    *( zlibBlock.getElement( b ) ) );
-            }
-        }
+	png_write_info( png_ptr, info_ptr );
 
-    
-    printf( "\n\n" );
-    
 
-    
-    
-    delete [] zlibOutBuffer;
-    result = deflateEnd( &zStream );
+	// write bytes
+    // write header
+	if( setjmp( png_jmpbuf( png_ptr ) ) ) {
+        delete [] imageBytes;
+        delete [] rows;
+        png_destroy_write_struct( &png_ptr, &info_ptr );
 
-    if( result != Z_OK ) {
-        printf( "zlib deflateEnd error (%d): %s\n", result, zStream.msg );
+        printf( "PNG Writing: error writing image bytes\n" );
+        return;
         }
 
-    */    
-    
+	png_write_image( png_ptr, rows );
 
-    
-    // the zlib block is the data of an IDAT chunk
 
-    unsigned char *zlibBytes = zlibBlock.getElementArray();
+	// end write
+    if( setjmp( png_jmpbuf( png_ptr ) ) ) {
+        delete [] imageBytes;
+        delete [] rows;
+        png_destroy_write_struct( &png_ptr, &info_ptr );
 
-    writeChunk( "IDAT", zlibBytes, zlibBlock.size(), inStream );
-    
-    
-    delete [] zlibBytes;
-    
-    // no data in end chunk
-    writeChunk( "IEND", NULL, 0, inStream );
+        printf( "PNG Writing: error ending write\n" );
+        return;
+        }
 
+	png_write_end( png_ptr, NULL );
 
-    delete [] rawScanlineBytes;
 
+    png_destroy_write_struct( &png_ptr, &info_ptr );
     
-    // done
+    delete [] imageBytes;
+    delete [] rows;
+    
+
 	}
 
 
@@ -6,6 +6,10 @@
  *
  * 2010-May-18    Jason Rohrer
  * String parameters as const to fix warnings.
+ *
+ * 2026-October-15    Jason Rohrer
+ * Added built-in encoder modes (fast and small) that choose a filter for
+ * each row and compress chunks of rows in parallel.
  */
  
  
@@ -17,11 +21,35 @@
 
 
 
+enum PNGEncoderMode {
+    // libpng, at the converter's compression level
+    PNG_ENCODE_LIBPNG = 0,
+    // built-in encoder, for screen capture:  quick filter choice and
+    // fastest deflate level
+    PNG_ENCODE_FAST,
+    // built-in encoder, for archiving:  tries every filter on every row
+    // and uses the slowest deflate level
+    PNG_ENCODE_SMALL
+    };
+
+
+
 /**
  * PNG implementation of the image conversion interface.
  *
  * Note that it only supports 32-bit PNG files
  * (3-channel Images are given a solid alpha channel).
+ * (The built-in encoder modes write 3-channel images as 24-bit PNG
+ *  files instead.)
+ *
+ * The built-in encoder splits the image into bands of rows that are
+ * filtered and deflated independently across the shared ThreadPool
+ * (each band's deflate stream primed with the end of the band before
+ * it, as pigz does), and stitched into one zlib stream.  Callers must
+ * link minorGems/system/ThreadPool.cpp, minorGems/formats/ZipStream.cpp,
+ * and miniz (via minorGems/formats/encodingUtils.cpp).
+ *
+ * formatImage can be called from several threads at once.
  *
  * @author Jason Rohrer
  */
@@ -37,7 +65,11 @@ class PNGImageConverter : public BigEndianImageConverter {
         // 3 to 6 are supposed to be "nearly as good" as 7-9, but "much faster"
         //
         // Defaults to 5.
-        PNGImageConverter( int inCompressionLevel=5 );
+        //
+        // Compression level only applies to PNG_ENCODE_LIBPNG mode,
+        // which is the default.
+        PNGImageConverter( int inCompressionLevel=5, 
+                           PNGEncoderMode inMode=PNG_ENCODE_LIBPNG );
         
         
         
@@ -51,8 +83,14 @@ class PNGImageConverter : public BigEndianImageConverter {
     protected:
         
         int mCompressionLevel;
+
+        PNGEncoderMode mMode;
         
 
+        // built-in encoder for PNG_ENCODE_FAST and PNG_ENCODE_SMALL
+        void encodeImage( Image *inImage, OutputStream *inStream );
+
+
         /**
          * Writes a chunk to a stream.
          *
@@ -13,6 +13,9 @@
  * 2011-April-5   Jason Rohrer
  * Fixed MAJOR bug causing double output size for 3-channel images.
  * Fixed float-to-int conversion.  
+ *
+ * 2026-October-14   Jason Rohrer
+ * deformatImage returns a compact 8-bit Image.
  */
  
  
@@ -341,50 +344,13 @@ inline Image *TGAImageConverter::deformatImage( InputStream *inStream ) {
         return NULL;
         }
     
-    unsigned char *raster = rawImage->mRGBABytes;
-    int width = rawImage->mWidth;
-    int height = rawImage->mHeight;
+    // compact image takes over raster directly, no conversion to double
+    // until (unless) caller needs the channels
+    Image *image = new Image( rawImage->mRGBABytes, 
+                              rawImage->mWidth, rawImage->mHeight,
+                              rawImage->mNumChannels );
     
-    int numChannels = rawImage->mNumChannels;
-
-    int numPixels = width * height;
-
-    // optimization:  don't init channels to black (found with profiler)
-	Image *image = new Image( width, height, numChannels, false );
-
-	double *red = image->getChannel( 0 );
-	double *green = image->getChannel( 1 );
-	double *blue = image->getChannel( 2 );
-	
-	long rasterIndex = 0;
-	double inv255 = 1.0 / 255.0;
-
-	if( numChannels == 3 ) {
-        for( int i=0; i<numPixels; i++ ) {
-            red[i] = inv255 * raster[ rasterIndex ];
-            green[i] = inv255 * raster[ rasterIndex + 1 ];
-            blue[i] = inv255 * raster[ rasterIndex + 2 ];
-			
-            rasterIndex += 3;
-            }
-        }
-	else {  // numChannels == 4
-		double *alpha = image->getChannel( 3 );
-        for( int i=0; i<numPixels; i++ ) {
-            // optimization:  use postfix increment operators in
-            // array index
-            // (found with profiler)
-            red[i] = inv255 * raster[ rasterIndex ++ ];
-            green[i] = inv255 * raster[ rasterIndex ++ ];
-            blue[i] = inv255 * raster[ rasterIndex ++ ];
-            alpha[i] = inv255 * raster[ rasterIndex ++ ];
-            
-            // optimization
-            // rasterIndex += 4;
-            }
-		}
-
-	
+    rawImage->mRGBABytes = NULL;
 	delete rawImage;
 	
 
@@ -5,6 +5,7 @@
 #include "minorGems/io/file/FileOutputStream.h"
 
 #include "minorGems/system/Time.h"
+#include "minorGems/system/ThreadPool.h"
 
 
 int main() {
@@ -26,19 +27,28 @@ int main() {
             }
         }
     
-    PNGImageConverter png;
+    PNGEncoderMode modes[3] = 
+        { PNG_ENCODE_LIBPNG, PNG_ENCODE_FAST, PNG_ENCODE_SMALL };
+    const char *fileNames[3] = 
+        { "test.png", "test_fast.png", "test_small.png" };
+    
+    for( int m=0; m<3; m++ ) {
+        PNGImageConverter png( 5, modes[m] );
 
 
-    File outFileB( NULL, "test.png" );
-    FileOutputStream outStreamB( &outFileB );
+        File outFileB( NULL, fileNames[m] );
+        FileOutputStream outStreamB( &outFileB );
 
 
-    double t = Time::getCurrentTime();
+        double t = Time::getCurrentTime();
                     
-    png.formatImage( &testImage, &outStreamB );
+        png.formatImage( &testImage, &outStreamB );
 
-    printf( "Converter took %f seconds\n", 
-            Time::getCurrentTime() - t );
+        printf( "Converter took %f seconds for %s\n", 
+                Time::getCurrentTime() - t, fileNames[m] );
+        }
 
+    ThreadPool::shutdownSharedPool();
+    
     return 0;
     }
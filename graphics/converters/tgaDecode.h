@@ -0,0 +1,231 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14   Jason Rohrer
+ * Created.
+ */
+
+
+#ifndef TGA_DECODE_INCLUDED
+#define TGA_DECODE_INCLUDED
+
+
+#include <string.h>
+
+
+
+/**
+ * Decodes TGA file data straight into 4-channel RGBA bytes, in one pass,
+ * with no intermediate buffers.
+ *
+ * Unlike TGAImageConverter, handles RLE-compressed files (type 10) as
+ * well as uncompressed ones (type 2), both 24- and 32-bit, with any
+ * origin corner.  Output rows always start at the top of the image,
+ * and 24-bit files get an alpha of 255.
+ *
+ * Touches no global state, so it's safe to call from any thread.
+ *
+ * @author Jason Rohrer
+ */
+
+
+
+typedef struct TGAInfo {
+        int width;
+        int height;
+
+        // 3 or 4 in the file (output is always 4)
+        int numChannels;
+
+        char rle;
+        char originAtTop;
+        char rightToLeft;
+
+        // where pixel data starts in file
+        int dataOffset;
+    } TGAInfo;
+
+
+
+// reads header from the start of a TGA file's contents
+// returns false if it's not a TGA that decodeTGAToRGBA can handle
+inline char readTGAInfo( const unsigned char *inData, int inLength,
+                         TGAInfo *outInfo ) {
+    if( inLength < 18 ) {
+        return false;
+        }
+
+    int idLength = inData[0];
+    int colorMapType = inData[1];
+    int imageType = inData[2];
+
+    if( imageType != 2 && imageType != 10 ) {
+        // only true color, raw or RLE
+        return false;
+        }
+
+    int colorMapBytes = 0;
+    if( colorMapType != 0 ) {
+        // true-color files can still carry an (unused) color map
+        int colorMapLength = inData[5] | ( inData[6] << 8 );
+        int colorMapEntryBits = inData[7];
+
+        colorMapBytes = colorMapLength * ( ( colorMapEntryBits + 7 ) / 8 );
+        }
+
+    int bitsPerPixel = inData[16];
+    if( bitsPerPixel != 24 && bitsPerPixel != 32 ) {
+        return false;
+        }
+
+    int descriptor = inData[17];
+
+    outInfo->width = inData[12] | ( inData[13] << 8 );
+    outInfo->height = inData[14] | ( inData[15] << 8 );
+    outInfo->numChannels = bitsPerPixel / 8;
+    outInfo->rle = ( imageType == 10 );
+    outInfo->originAtTop = ( ( descriptor & ( 1 << 5 ) ) != 0 );
+    outInfo->rightToLeft = ( ( descriptor & ( 1 << 4 ) ) != 0 );
+    outInfo->dataOffset = 18 + idLength + colorMapBytes;
+
+    if( outInfo->dataOffset > inLength ) {
+        return false;
+        }
+
+    return true;
+    }
+
+
+
+// first output pixel of file row inFileRow
+inline unsigned char *getTGARowStart( TGAInfo *inInfo,
+                                      unsigned char *inRGBA,
+                                      int inFileRow ) {
+    int y = inFileRow;
+    if( ! inInfo->originAtTop ) {
+        y = inInfo->height - 1 - inFileRow;
+        }
+
+    int x = 0;
+    if( inInfo->rightToLeft ) {
+        x = inInfo->width - 1;
+        }
+
+    return &( inRGBA[ ( y * inInfo->width + x ) * 4 ] );
+    }
+
+
+
+/**
+ * Decodes pixels.
+ *
+ * @param inData, inLength the full contents of a TGA file.
+ * @param outRGBA where the width * height * 4 output bytes should go.
+ *   Provided by caller.
+ *
+ * @return true on success, or false if the data is not a supported TGA
+ *   or is truncated (in which case outRGBA may be partly filled).
+ */
+inline char decodeTGAToRGBA( const unsigned char *inData, int inLength,
+                             unsigned char *outRGBA ) {
+    TGAInfo info;
+
+    if( ! readTGAInfo( inData, inLength, &info ) ) {
+        return false;
+        }
+
+    int w = info.width;
+    int h = info.height;
+    int numChannels = info.numChannels;
+
+    int numPixels = w * h;
+
+    if( numPixels == 0 ) {
+        return true;
+        }
+
+    int destStep = 4;
+    if( info.rightToLeft ) {
+        destStep = -4;
+        }
+
+    const unsigned char *source = &( inData[ info.dataOffset ] );
+    const unsigned char *sourceEnd = &( inData[ inLength ] );
+
+    // file position
+    int x = 0;
+    int y = 0;
+    unsigned char *dest = getTGARowStart( &info, outRGBA, 0 );
+
+    int numDone = 0;
+
+    while( numDone < numPixels ) {
+
+        // raw data is one long literal packet
+        int packetLength = numPixels;
+        char isRun = false;
+
+        if( info.rle ) {
+            if( source >= sourceEnd ) {
+                return false;
+                }
+            unsigned char packetHeader = *( source++ );
+
+            packetLength = ( packetHeader & 0x7F ) + 1;
+            isRun = ( ( packetHeader & 0x80 ) != 0 );
+            }
+
+        if( packetLength > numPixels - numDone ) {
+            packetLength = numPixels - numDone;
+            }
+
+        int sourceBytes = numChannels;
+        if( ! isRun ) {
+            sourceBytes *= packetLength;
+            }
+        if( sourceEnd - source < sourceBytes ) {
+            return false;
+            }
+
+        for( int i=0; i<packetLength; i++ ) {
+            // BGR(A) to RGBA
+            dest[0] = source[2];
+            dest[1] = source[1];
+            dest[2] = source[0];
+
+            if( numChannels == 4 ) {
+                dest[3] = source[3];
+                }
+            else {
+                dest[3] = 255;
+                }
+
+            if( ! isRun ) {
+                source += numChannels;
+                }
+
+            x++;
+            dest += destStep;
+
+            if( x == w ) {
+                x = 0;
+                y++;
+                if( y < h ) {
+                    dest = getTGARowStart( &info, outRGBA, y );
+                    }
+                }
+            }
+
+        if( isRun ) {
+            source += numChannels;
+            }
+
+        numDone += packetLength;
+        }
+
+    return true;
+    }
+
+
+
+#endif
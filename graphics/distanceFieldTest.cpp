@@ -0,0 +1,225 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+/**
+ * Checks makeDistanceField against exact distances for an antialiased
+ * disc drawn at 4x, edges of a hard-edged square at 1x, padding, empty
+ * masks, and strided reads, then times fields for glyph-sized masks.
+ *
+ * Compile from above the minorGems directory with:
+ *   g++ -O2 -I. minorGems/graphics/distanceFieldTest.cpp
+ *     minorGems/graphics/DistanceField.cpp
+ *     minorGems/system/unix/TimeUnix.cpp -o distanceFieldTest
+ */
+
+#include "DistanceField.h"
+#include "minorGems/system/Time.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+
+
+static int numBad = 0;
+
+
+
+static void checkValue( const char *inWhat, unsigned char *inField,
+                        int inFieldWidth, int inX, int inY,
+                        int inExpected, int inTolerance ) {
+    int v = inField[ inY * inFieldWidth + inX ];
+
+    if( abs( v - inExpected ) > inTolerance ) {
+        printf( "%s:  texel (%d,%d) is %d, expected %d\n",
+                inWhat, inX, inY, v, inExpected );
+        numBad++;
+        }
+    }
+
+
+
+// disc of radius inRadius centered in an inSize square, 4x4 supersampled
+static unsigned char *makeDisc( int inSize, double inRadius ) {
+    unsigned char *mask = new unsigned char[ inSize * inSize ];
+
+    double c = inSize / 2.0;
+
+    for( int y=0; y<inSize; y++ ) {
+        for( int x=0; x<inSize; x++ ) {
+            int numIn = 0;
+            for( int sy=0; sy<4; sy++ ) {
+                for( int sx=0; sx<4; sx++ ) {
+                    double dx = x + ( sx + 0.5 ) / 4 - c;
+                    double dy = y + ( sy + 0.5 ) / 4 - c;
+                    if( dx * dx + dy * dy < inRadius * inRadius ) {
+                        numIn++;
+                        }
+                    }
+                }
+            mask[ y * inSize + x ] = (unsigned char)( numIn * 255 / 16 );
+            }
+        }
+    return mask;
+    }
+
+
+
+int main() {
+
+    // disc at 4x, field texels near edge within 1/16 texel of exact
+    unsigned char *disc = makeDisc( 256, 80 );
+
+    int w, h;
+    unsigned char *field = makeDistanceField( disc, 1, 256, 256, 4, 2,
+                                              &w, &h );
+
+    if( w != 68 || h != 68 ) {
+        printf( "Disc field is %dx%d\n", w, h );
+        numBad++;
+        }
+    else {
+        int numChecked = 0;
+        double worst = 0;
+
+        for( int y=0; y<h; y++ ) {
+            for( int x=0; x<w; x++ ) {
+                // texel center in mask coordinates
+                double dx = ( x - 2 + 0.5 ) * 4 - 128;
+                double dy = ( y - 2 + 0.5 ) * 4 - 128;
+
+                double dist = ( 80 - sqrt( dx * dx + dy * dy ) ) / 4;
+
+                if( fabs( dist ) > DISTANCE_FIELD_SPREAD * 0.9 ) {
+                    // clamped
+                    continue;
+                    }
+
+                double expected =
+                    127.5 + dist * 127.5 / DISTANCE_FIELD_SPREAD;
+
+                double error = fabs( field[ y * w + x ] - expected );
+
+                if( error > worst ) {
+                    worst = error;
+                    }
+                numChecked++;
+                }
+            }
+
+        if( numChecked < 100 || worst > 128 / 16.0 / DISTANCE_FIELD_SPREAD ) {
+            printf( "Disc field off by up to %.1f (in %d texels)\n",
+                    worst, numChecked );
+            numBad++;
+            }
+
+        // center far inside, corner far outside
+        checkValue( "Disc", field, w, 34, 34, 255, 0 );
+        checkValue( "Disc", field, w, 0, 0, 0, 0 );
+        }
+
+    delete [] field;
+    delete [] disc;
+
+
+    // hard-edged square at 1x, edge halfway between texels
+    unsigned char square[ 32 * 32 ];
+    memset( square, 0, sizeof( square ) );
+    for( int y=10; y<20; y++ ) {
+        memset( &( square[ y * 32 + 10 ] ), 255, 10 );
+        }
+
+    field = makeDistanceField( square, 1, 32, 32, 1, 0, &w, &h );
+
+    checkValue( "Square", field, w, 15, 15, 255, 0 );
+    checkValue( "Square", field, w, 10, 15, 191, 1 );
+    checkValue( "Square", field, w, 9, 15, 64, 1 );
+    checkValue( "Square", field, w, 15, 19, 191, 1 );
+    checkValue( "Square", field, w, 15, 20, 64, 1 );
+    checkValue( "Square", field, w, 5, 15, 0, 0 );
+    delete [] field;
+
+
+    // full mask, padding is outside
+    unsigned char full[ 8 * 8 ];
+    memset( full, 255, sizeof( full ) );
+
+    field = makeDistanceField( full, 1, 8, 8, 1, 2, &w, &h );
+
+    if( w != 12 || h != 12 ) {
+        printf( "Padded field is %dx%d\n", w, h );
+        numBad++;
+        }
+    else {
+        checkValue( "Padded", field, w, 0, 6, 0, 0 );
+        checkValue( "Padded", field, w, 1, 6, 64, 1 );
+        checkValue( "Padded", field, w, 2, 6, 191, 1 );
+        checkValue( "Padded", field, w, 6, 6, 255, 0 );
+        }
+    delete [] field;
+
+
+    // empty mask, all outside
+    unsigned char empty[ 8 * 8 ];
+    memset( empty, 0, sizeof( empty ) );
+
+    field = makeDistanceField( empty, 1, 8, 8, 2, 0, &w, &h );
+
+    for( int i=0; i<w * h; i++ ) {
+        if( field[i] != 0 ) {
+            printf( "Empty field has %d at %d\n", field[i], i );
+            numBad++;
+            break;
+            }
+        }
+    delete [] field;
+
+
+    // alpha of RGBA gives same field as plain mask
+    unsigned char rgba[ 32 * 32 * 4 ];
+    memset( rgba, 0x7F, sizeof( rgba ) );
+    for( int i=0; i<32 * 32; i++ ) {
+        rgba[ i * 4 + 3 ] = square[i];
+        }
+
+    field = makeDistanceField( square, 1, 32, 32, 2, 1, &w, &h );
+    unsigned char *fieldRGBA = makeDistanceField( &( rgba[3] ), 4, 32, 32,
+                                                  2, 1, &w, &h );
+
+    if( memcmp( field, fieldRGBA, w * h ) != 0 ) {
+        printf( "Strided read gives different field\n" );
+        numBad++;
+        }
+    delete [] field;
+    delete [] fieldRGBA;
+
+
+    // timing, glyph drawn at 4x for a 32-texel field
+    disc = makeDisc( 128, 40 );
+
+    int numRuns = 200;
+
+    double startTime = Time::getCurrentTime();
+    for( int r=0; r<numRuns; r++ ) {
+        field = makeDistanceField( disc, 1, 128, 128, 4, 2, &w, &h );
+        delete [] field;
+        }
+    double fieldTime = ( Time::getCurrentTime() - startTime ) / numRuns;
+
+    delete [] disc;
+
+    printf( "128x128 mask to %dx%d field:  %.3f ms\n",
+            w, h, fieldTime * 1000 );
+
+
+    if( numBad == 0 ) {
+        printf( "All tests passed\n" );
+        return 0;
+        }
+    printf( "%d failures\n", numBad );
+    return 1;
+    }
@@ -16,6 +16,10 @@
  *
  * 2011-January-17   Jason Rohrer
  * Optimized with accumulation buffer pre-processing step, found on Gamasutra.
+ *
+ * 2026-October-14   Jason Rohrer
+ * Switched to separable sliding-window passes, split across threads, 
+ * with vectorized column pass.  Can blur all channels of an image at once.
  */
  
  
@@ -23,10 +27,17 @@
 #define BOX_BLUR_FILTER_INCLUDED
  
 #include "minorGems/graphics/ChannelFilter.h" 
+#include "minorGems/graphics/filters/separableBlur.h"
+
+#include <string.h>
  
 /**
  * Blur convolution filter that uses a box for averaging.
  *
+ * Near edges, the box is clipped to the image.
+ *
+ * Uses threads (see separableBlur.h).
+ *
  * @author Jason Rohrer 
  */
 class BoxBlurFilter : public ChannelFilter { 
@@ -60,6 +71,10 @@ class BoxBlurFilter : public ChannelFilter {
 		// implements the ChannelFilter interface
 		void apply( double *inChannel, int inWidth, int inHeight );
 
+		// blurs all channels in one threaded pass
+		void applyToChannels( double **inChannels, int inNumChannels,
+                              int inWidth, int inHeight );
+
 	private:
 		int mRadius;
 	};
@@ -85,124 +100,176 @@ inline int BoxBlurFilter::getRadius() {
 	
 	
 	
-inline void BoxBlurFilter::apply( double *inChannel, 
-                                  int inWidth, int inHeight ) {
+// state shared by threads during one blur
+typedef struct BoxBlurPass {
+        double **channels;
+        double **temp;
+        int numChannels;
+        int width;
+        int height;
+        int radius;
+    } BoxBlurPass;
 
-    // the basis for this method was found in this article:
-    // 
-    // http://www.gamasutra.com/view/feature/3102/
-    //        four_tricks_for_fast_blurring_in_.php?page=1
-    //
-    // however, the code provided seems to contain mistakes, which I have fixed
 
 
-    // sum of all pixels to left and above each position 
-    // (including that position)
-    double *accumTotals = new double[ inWidth * inHeight ];
+// horizontal pass from channels into temp
+// items are rows, counting through all rows of each channel in turn
+inline void boxBlurRows( void *inPass, int inStart, int inEnd ) {
+    BoxBlurPass *pass = (BoxBlurPass *)inPass;
     
+    int w = pass->width;
+    int h = pass->height;
+    int r = pass->radius;
+    
+    for( int k=inStart; k<inEnd; k++ ) {
+        int c = k / h;
+        int y = k % h;
+        
+        double *source = &( pass->channels[c][ y * w ] );
+        double *dest = &( pass->temp[c][ y * w ] );
 
-    double *accumPointer = accumTotals;
-    double *sourcePointer = inChannel;
-    for( int y=0; y<inHeight; y++ ) {
-        for( int x=0; x<inWidth; x++ ) {
-            double total = sourcePointer[0];
-
-            if( x>0 ) {    
-                total += accumPointer[-1];
-                }
+        // sliding window, clipped at row ends
+        double sum = 0;
+        
+        int firstEnd = r;
+        if( firstEnd >= w ) {
+            firstEnd = w - 1;
+            }
+        for( int x=0; x<=firstEnd; x++ ) {
+            sum += source[x];
+            }
+        
+        for( int x=0; x<w; x++ ) {
+            int boxStart = x - r;
+            int boxEnd = x + r;
             
-            if( y>0 ) {    
-                total += accumPointer[ -inWidth ];
+            if( boxStart < 0 ) {
+                boxStart = 0;
                 }
-            
-            if( x>0 && y>0 ) {
-                total -= accumPointer[ -inWidth - 1 ];
+            if( boxEnd >= w ) {
+                boxEnd = w - 1;
                 }
             
-            *accumPointer = total;
-            accumPointer++;
+            dest[x] = sum / ( boxEnd - boxStart + 1 );
             
-            sourcePointer++;
+            if( x + r + 1 < w ) {
+                sum += source[ x + r + 1 ];
+                }
+            if( x - r >= 0 ) {
+                sum -= source[ x - r ];
+                }
             }
         }
+    }
+
+
+
+// vertical pass from temp back into channels
+// items are columns, so that each thread slides a contiguous strip of
+// column sums down the image (vectorized along the strip)
+inline void boxBlurColumns( void *inPass, int inStart, int inEnd ) {
+    BoxBlurPass *pass = (BoxBlurPass *)inPass;
     
+    int w = pass->width;
+    int h = pass->height;
+    int r = pass->radius;
+
+    int stripWidth = inEnd - inStart;
+
+    double *sums = new double[ stripWidth ];
     
+    // stands in for rows that are off the top or bottom
+    double *zeros = new double[ stripWidth ];
+    memset( zeros, 0, stripWidth * sizeof( double ) );
     
     
-    
-    // sum boxes right into passed-in channel
-    for( int y=0; y<inHeight; y++ ) {
-        // seems like Gamasutra's code had a mistake
-        // need to extend start of box 1 past actual box, for this to work
-        // properly
-        int boxYStart = y - mRadius - 1;
-        int boxYEnd = y + mRadius;
-
-        double yOutsideFactor = 1;
+    for( int c=0; c<pass->numChannels; c++ ) {
+        double *source = &( pass->temp[c][ inStart ] );
+        double *dest = &( pass->channels[c][ inStart ] );
         
-        int yDimensionExtra = 0;
-
-        if( boxYStart < 0 ) {
-            boxYStart = 0;
-            yOutsideFactor = 0;
-            yDimensionExtra = 1;
+        memset( sums, 0, stripWidth * sizeof( double ) );
+        
+        int firstEnd = r;
+        if( firstEnd >= h ) {
+            firstEnd = h - 1;
             }
-        if( boxYEnd >= inHeight ) {
-            boxYEnd = inHeight - 1;
+        for( int y=0; y<=firstEnd; y++ ) {
+            blurAddRow( sums, &( source[ y * w ] ), stripWidth );
             }
-        int yDimension = boxYEnd - boxYStart + yDimensionExtra;
-
 
-        for( int x=0; x<inWidth; x++ ) {
+        for( int y=0; y<h; y++ ) {
+            int boxStart = y - r;
+            int boxEnd = y + r;
             
-            int boxXStart = x - mRadius - 1;
-            int boxXEnd = x + mRadius;
+            if( boxStart < 0 ) {
+                boxStart = 0;
+                }
+            if( boxEnd >= h ) {
+                boxEnd = h - 1;
+                }
             
-            double xOutsideFactor = 1;
+            blurScaleRow( &( dest[ y * w ] ), sums, 
+                          1.0 / ( boxEnd - boxStart + 1 ), stripWidth );
             
-            int xDimensionExtra = 0;
+            double *addRow = zeros;
+            double *subtractRow = zeros;
             
-            if( boxXStart < 0 ) {
-                boxXStart = 0;
-                xOutsideFactor = 0;
-                xDimensionExtra = 1;
+            if( y + r + 1 < h ) {
+                addRow = &( source[ ( y + r + 1 ) * w ] );
                 }
-            if( boxXEnd >= inWidth ) {
-                boxXEnd = inWidth - 1;
+            if( y - r >= 0 ) {
+                subtractRow = &( source[ ( y - r ) * w ] );
                 }
             
-            double outsideOverlapFactor = yOutsideFactor * xOutsideFactor;
-            
+            if( addRow != zeros || subtractRow != zeros ) {
+                blurSlideRow( sums, addRow, subtractRow, stripWidth );
+                }
+            }
+        }
+    
+    delete [] sums;
+    delete [] zeros;
+    }
 
-            int xDimension = boxXEnd - boxXStart + xDimensionExtra;
 
-            int numPixelsInBox = (yDimension) * (xDimension);
+
+inline void BoxBlurFilter::apply( double *inChannel, 
+                                  int inWidth, int inHeight ) {
+    applyToChannels( &inChannel, 1, inWidth, inHeight );
+    }
+
+
+
+inline void BoxBlurFilter::applyToChannels( double **inChannels, 
+                                            int inNumChannels,
+                                            int inWidth, int inHeight ) {
     
-            double boxValueMultiplier = 1.0 / numPixelsInBox;
+    // separable:  a (clipped) box average is a horizontal average
+    // followed by a vertical one, and each can be done as a sliding
+    // window sum, independent of radius
 
-            
-            inChannel[ y * inWidth + x ] = 
-                boxValueMultiplier * (
-                    // total sum of pixels in image from far corner
-                    // of box back to (0,0)
-                    accumTotals[ boxYEnd * inWidth + boxXEnd ]
-                    // subtract regions outside of box, if any
-                    -
-                    yOutsideFactor * 
-                    accumTotals[ boxYStart * inWidth + boxXEnd ]
-                    -
-                    xOutsideFactor * 
-                    accumTotals[ boxYEnd * inWidth + boxXStart ]
-                    // add back in region that was subtracted twice, if any
-                    +
-                    outsideOverlapFactor *
-                    accumTotals[ boxYStart * inWidth + boxXStart ]
-                    );
-            
-            }
+    int numPixels = inWidth * inHeight;
+    
+    BoxBlurPass pass;
+    pass.channels = inChannels;
+    pass.temp = new double*[ inNumChannels ];
+    pass.numChannels = inNumChannels;
+    pass.width = inWidth;
+    pass.height = inHeight;
+    pass.radius = mRadius;
+    
+    for( int c=0; c<inNumChannels; c++ ) {
+        pass.temp[c] = new double[ numPixels ];
         }
     
-    delete [] accumTotals;    
+    runBlurPass( boxBlurRows, &pass, inNumChannels * inHeight, 16 );
+    
+    runBlurPass( boxBlurColumns, &pass, inWidth, 32 );
+    
+    for( int c=0; c<inNumChannels; c++ ) {
+        delete [] pass.temp[c];
+        }
+    delete [] pass.temp;
     }
 
 
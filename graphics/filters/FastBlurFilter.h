@@ -3,6 +3,10 @@
  *
  * 2011-January-17   Jason Rohrer
  * Created.
+ *
+ * 2026-October-14   Jason Rohrer
+ * Switched to separable, vectorized passes split across threads.
+ * Can blur all channels of an image at once.
  */
  
  
@@ -10,12 +14,15 @@
 #define FAST_BLUR_FILTER_INCLUDED
  
 #include "minorGems/graphics/ChannelFilter.h" 
+#include "minorGems/graphics/filters/separableBlur.h"
  
 /**
  * Fast implementation of a radius-1 box filter.
  *
  * Completely skips edge pixels for speed.
  *
+ * Uses threads (see separableBlur.h).
+ *
  * @author Jason Rohrer 
  */
 class FastBlurFilter : public ChannelFilter { 
@@ -25,74 +32,113 @@ class FastBlurFilter : public ChannelFilter {
         // implements the ChannelFilter interface
         void apply( double *inChannel, int inWidth, int inHeight );
 
+        // blurs all channels in one threaded pass
+        void applyToChannels( double **inChannels, int inNumChannels,
+                              int inWidth, int inHeight );
+
     };
         
     
     
-inline void FastBlurFilter::apply( double *inChannel, 
-                                   int inWidth, int inHeight ) {
+// state shared by threads during one blur
+typedef struct FastBlurPass {
+        double **channels;
+        double **temp;
+        int numChannels;
+        int width;
+        int height;
+    } FastBlurPass;
 
 
-    // use pointer tricks to walk through neighbor box of each pixel
-
-    // four "corners" around box
-    int cornerOffsetA = inWidth + 1;
-    int cornerOffsetB = -inWidth + 1;
-    int cornerOffsetC = inWidth - 1;
-    int cornerOffsetD = -inWidth - 1;
-
-    // sides around box
-    int sideOffsetA = inWidth;
-    int sideOffsetB = -inWidth;
-    int sideOffsetC = 1;
-    int sideOffsetD = -1;
 
+// horizontal 3-sums of interior pixels from channels into temp
+// items are rows, counting through all rows of each channel in turn
+inline void fastBlurRows( void *inPass, int inStart, int inEnd ) {
+    FastBlurPass *pass = (FastBlurPass *)inPass;
     
-    int numPixels = inWidth * inHeight;
-
-
-    double *sourceData = new double[ numPixels ];
+    int w = pass->width;
+    int h = pass->height;
     
-    memcpy( sourceData, inChannel, numPixels * sizeof( double ) );
+    for( int k=inStart; k<inEnd; k++ ) {
+        int c = k / h;
+        int y = k % h;
         
+        double *source = &( pass->channels[c][ y * w ] );
+        double *dest = &( pass->temp[c][ y * w ] );
+        
+        // skip first and last pixel in row
+        blurSum3Row( &( dest[1] ), 
+                     &( source[0] ), &( source[1] ), &( source[2] ),
+                     1.0, w - 2 );
+        }
+    }
+
 
-    // avoid edges
-    int numPixelsInRow = inWidth - 2;
-    
-    double boxMultiplier = 1.0 / 9.0;
-    
 
+// vertical 3-sums of temp back into interior of channels
+// items are interior rows, counting through each channel in turn
+inline void fastBlurColumns( void *inPass, int inStart, int inEnd ) {
+    FastBlurPass *pass = (FastBlurPass *)inPass;
+    
+    int w = pass->width;
+    int numInteriorRows = pass->height - 2;
     
-    // sum boxes right into passed-in channel
+    double boxMultiplier = 1.0 / 9.0;
 
-    // avoid edges where box falls off edge
-    for( int y=1; y<inHeight-1; y++ ) {
+    for( int k=inStart; k<inEnd; k++ ) {
+        int c = k / numInteriorRows;
+        int y = k % numInteriorRows + 1;
+        
+        double *source = &( pass->temp[c][ y * w + 1 ] );
+        double *dest = &( pass->channels[c][ y * w + 1 ] );
         
-        // skip first pixel in row to avoid box falling off edge
-        int pixelIndex = y * inWidth + 1;
-
-        for( int i=0; i<numPixelsInRow; i++ ) {
-
-            double *sourcePointer = &( sourceData[ pixelIndex ] );
-
-            inChannel[ pixelIndex ] =
-                ( sourcePointer[ 0 ] +
-                  sourcePointer[ cornerOffsetA ] +
-                  sourcePointer[ cornerOffsetB ] +
-                  sourcePointer[ cornerOffsetC ] +
-                  sourcePointer[ cornerOffsetD ] +
-                  sourcePointer[ sideOffsetA ] +
-                  sourcePointer[ sideOffsetB ] +
-                  sourcePointer[ sideOffsetC ] +
-                  sourcePointer[ sideOffsetD ]
-                  ) * boxMultiplier;
-            
-            pixelIndex++;
-            }
+        blurSum3Row( dest, source - w, source, source + w,
+                     boxMultiplier, w - 2 );
+        }
+    }
+
+
+
+inline void FastBlurFilter::apply( double *inChannel, 
+                                   int inWidth, int inHeight ) {
+    applyToChannels( &inChannel, 1, inWidth, inHeight );
+    }
+
+
 
+inline void FastBlurFilter::applyToChannels( double **inChannels, 
+                                             int inNumChannels,
+                                             int inWidth, int inHeight ) {
+
+    if( inWidth < 3 || inHeight < 3 ) {
+        // no interior pixels
+        return;
         }
 
-    delete [] sourceData;
+    // separable:  sum of 3x3 box is sum of three horizontal 3-sums
+    
+    int numPixels = inWidth * inHeight;
+    
+    FastBlurPass pass;
+    pass.channels = inChannels;
+    pass.temp = new double*[ inNumChannels ];
+    pass.numChannels = inNumChannels;
+    pass.width = inWidth;
+    pass.height = inHeight;
+    
+    for( int c=0; c<inNumChannels; c++ ) {
+        pass.temp[c] = new double[ numPixels ];
+        }
+    
+    runBlurPass( fastBlurRows, &pass, inNumChannels * inHeight, 16 );
+    
+    runBlurPass( fastBlurColumns, &pass, inNumChannels * ( inHeight - 2 ),
+                 16 );
+    
+    for( int c=0; c<inNumChannels; c++ ) {
+        delete [] pass.temp[c];
+        }
+    delete [] pass.temp;
     }
 
 
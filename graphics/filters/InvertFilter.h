@@ -3,6 +3,9 @@
  *
  * 2000-December-21		Jason Rohrer
  * Created. 
+ *
+ * 2026-October-14   Jason Rohrer
+ * Added compact 8-bit fast path.
  */
  
  
@@ -22,6 +25,9 @@ class InvertFilter : public ChannelFilter {
 		
 		// implements the ChannelFilter interface
 		void apply( double *inChannel, int inWidth, int inHeight );
+
+		char applyCompact( unsigned char *inChannel, int inPixelStride,
+                           int inWidth, int inHeight );
 	};
 	
 	
@@ -34,5 +40,19 @@ inline void InvertFilter::apply( double *inChannel,
 		inChannel[i] = 1.0 - inChannel[i];
 		}
 	}
+
+
+
+inline char InvertFilter::applyCompact( unsigned char *inChannel, 
+                                        int inPixelStride,
+                                        int inWidth, int inHeight ) {
+
+	int numPixels = inWidth * inHeight;
+	for( int i=0; i<numPixels; i++ ) {
+		*inChannel = 255 - *inChannel;
+		inChannel += inPixelStride;
+		}
+	return true;
+	}
 	
 #endif
@@ -12,6 +12,10 @@
  * Tried to optimize by moving stuff out of the inner-inner loop.
  * It helped a bit, but not much.
  *
+ * 2026-October-14   Jason Rohrer
+ * Added constant-time histogram mode (Perreault and Hebert), run in
+ * threaded column strips.
+ *
  */
  
  
@@ -20,6 +24,9 @@
  
 #include "minorGems/graphics/ChannelFilter.h" 
 #include "quickselect.h"
+#include "minorGems/graphics/filters/separableBlur.h"
+
+#include <string.h>
 
 
 int medianFilterCompareInt( const void *x, const void *y );
@@ -27,6 +34,17 @@ int medianFilterCompareInt( const void *x, const void *y );
 /**
  * Median convolution filter.
  *
+ * Near edges, the box is clipped to the image.  Channel values are
+ * quantized to steps of 0.001 before taking the median.
+ *
+ * In histogram mode, uses the constant-time algorithm from:
+ *   Perreault and Hebert, "Median Filtering in Constant Time",
+ *   IEEE Transactions on Image Processing, 2007.
+ * Time per pixel doesn't depend on radius, so large radii are much faster.
+ * Results are the same as the default mode for values in [0, 1.023]
+ * (values outside that range are clamped).  Uses threads (see 
+ * separableBlur.h).
+ *
  * @author Jeremy Tavan 
  */
 class MedianFilter : public ChannelFilter { 
@@ -37,8 +55,10 @@ class MedianFilter : public ChannelFilter {
    * Constructs a median filter.
    *
    * @param inRadius the radius of the box in pixels.
+   * @param inUseHistograms true to use constant-time histogram mode.
+   *   Defaults to false.
    */
-  MedianFilter( int inRadius );
+  MedianFilter( int inRadius, char inUseHistograms = false );
 								
 								
   /**
@@ -57,17 +77,23 @@ class MedianFilter : public ChannelFilter {
   int getRadius();
 								
 								
+  void setUseHistograms( char inUseHistograms );
+								
+								
   // implements the ChannelFilter interface
   void apply( double *inChannel, int inWidth, int inHeight );
 
  private:
   int mRadius;
+  char mUseHistograms;
+
+  void applyHistograms( double *inChannel, int inWidth, int inHeight );
 };
 				
 				
 				
-inline MedianFilter::MedianFilter( int inRadius ) 
-  : mRadius( inRadius ) {				
+inline MedianFilter::MedianFilter( int inRadius, char inUseHistograms ) 
+  : mRadius( inRadius ), mUseHistograms( inUseHistograms ) {				
 				
 }
 
@@ -81,6 +107,12 @@ inline void MedianFilter::setRadius( int inRadius ) {
 
 inline int MedianFilter::getRadius() {
   return mRadius;
+}
+
+
+
+inline void MedianFilter::setUseHistograms( char inUseHistograms ) {
+  mUseHistograms = inUseHistograms;
 }				
 				
 				
@@ -88,6 +120,12 @@ inline int MedianFilter::getRadius() {
 inline void MedianFilter::apply( double *inChannel, 
 																 int inWidth, int inHeight ) {
 
+  // column histogram counts are 16-bit
+  if( mUseHistograms && inHeight < 65536 ) {
+    applyHistograms( inChannel, inWidth, inHeight );
+    return;
+  }
+
   // pre-compute an integer version of the channel for the
   // median alg to use
   int numPixels = inWidth * inHeight;
@@ -156,4 +194,274 @@ inline void MedianFilter::apply( double *inChannel,
   delete [] intChannel;
 }
 
+
+
+
+// histogram mode
+
+// 1024 levels, split into 32 coarse buckets of 32 fine bins each
+#define MEDIAN_COARSE_BITS 5
+#define MEDIAN_NUM_COARSE 32
+#define MEDIAN_NUM_BINS 1024
+
+
+// state shared by threads during one histogram median pass
+typedef struct MedianHistogramPass {
+    unsigned short *levels;
+    double *result;
+    int width;
+    int height;
+    int radius;
+} MedianHistogramPass;
+
+
+
+// adds column histogram (inSign = 1) or subtracts it (inSign = -1)
+// over coarse bucket inBucket of a kernel's fine histogram
+inline void medianAddColumnBucket( int *ioFine,
+                                   unsigned short *inColumnFine,
+                                   int inBucket, int inSign ) {
+  int start = inBucket << MEDIAN_COARSE_BITS;
+  int *fine = &( ioFine[ start ] );
+  unsigned short *column = &( inColumnFine[ start ] );
+  
+  for( int i=0; i<MEDIAN_NUM_COARSE; i++ ) {
+    fine[i] += inSign * column[i];
+  }
+}
+
+
+
+// filters column strip [inStart, inEnd) of image, all rows
+inline void medianHistogramStrip( void *inPass, int inStart, int inEnd ) {
+  MedianHistogramPass *pass = (MedianHistogramPass *)inPass;
+
+  int w = pass->width;
+  int h = pass->height;
+  int r = pass->radius;
+
+  // columns that kernels in this strip can touch
+  int colStart = inStart - r;
+  int colEnd = inEnd + r;
+  if( colStart < 0 ) {
+    colStart = 0;
+  }
+  if( colEnd > w ) {
+    colEnd = w;
+  }
+  int numCols = colEnd - colStart;
+
+  unsigned short *colCoarse = 
+    new unsigned short[ numCols * MEDIAN_NUM_COARSE ];
+  unsigned short *colFine = new unsigned short[ numCols * MEDIAN_NUM_BINS ];
+
+  memset( colCoarse, 0, 
+          numCols * MEDIAN_NUM_COARSE * sizeof( unsigned short ) );
+  memset( colFine, 0, numCols * MEDIAN_NUM_BINS * sizeof( unsigned short ) );
+
+  // kernel histogram
+  // coarse is kept current, fine buckets are brought up to date only
+  // when the median search needs them
+  int kernelCoarse[ MEDIAN_NUM_COARSE ];
+  int kernelFine[ MEDIAN_NUM_BINS ];
+  
+  // x position each fine bucket is current for
+  int bucketX[ MEDIAN_NUM_COARSE ];
+
+  
+  for( int y=0; y<h; y++ ) {
+
+    // update column histograms to cover rows [y-r, y+r]
+    int rowStart = y - r;
+    if( rowStart < 0 ) {
+      rowStart = 0;
+    }
+    int rowEnd = y + r;
+    if( rowEnd >= h ) {
+      rowEnd = h - 1;
+    }
+    
+    int firstToAdd = y + r;
+    if( y == 0 ) {
+      // start with full window
+      firstToAdd = 0;
+    }
+    for( int addY = firstToAdd; addY <= rowEnd; addY++ ) {
+      unsigned short *row = &( pass->levels[ addY * w + colStart ] );
+      for( int c=0; c<numCols; c++ ) {
+        int v = row[c];
+        colFine[ c * MEDIAN_NUM_BINS + v ] ++;
+        colCoarse[ c * MEDIAN_NUM_COARSE + ( v >> MEDIAN_COARSE_BITS ) ] ++;
+      }
+    }
+    int removeY = y - r - 1;
+    if( removeY >= 0 ) {
+      unsigned short *row = &( pass->levels[ removeY * w + colStart ] );
+      for( int c=0; c<numCols; c++ ) {
+        int v = row[c];
+        colFine[ c * MEDIAN_NUM_BINS + v ] --;
+        colCoarse[ c * MEDIAN_NUM_COARSE + ( v >> MEDIAN_COARSE_BITS ) ] --;
+      }
+    }
+
+    int numRows = rowEnd - rowStart + 1;
+
+
+    // kernel coarse histogram for first pixel in strip row
+    memset( kernelCoarse, 0, sizeof( kernelCoarse ) );
+
+    int kernelStart = inStart - r;
+    if( kernelStart < 0 ) {
+      kernelStart = 0;
+    }
+    int kernelEnd = inStart + r;
+    if( kernelEnd >= w ) {
+      kernelEnd = w - 1;
+    }
+    for( int kx = kernelStart; kx <= kernelEnd; kx++ ) {
+      unsigned short *cc = &( colCoarse[ ( kx - colStart ) * 
+                                         MEDIAN_NUM_COARSE ] );
+      for( int b=0; b<MEDIAN_NUM_COARSE; b++ ) {
+        kernelCoarse[b] += cc[b];
+      }
+    }
+
+    // all fine buckets out of date
+    for( int b=0; b<MEDIAN_NUM_COARSE; b++ ) {
+      bucketX[b] = inStart - 2 * r - 2;
+    }
+
+
+    for( int x=inStart; x<inEnd; x++ ) {
+      
+      int startX = x - r;
+      if( startX < 0 ) {
+        startX = 0;
+      }
+      int endX = x + r;
+      if( endX >= w ) {
+        endX = w - 1;
+      }
+      
+      int count = numRows * ( endX - startX + 1 );
+      
+      // lower median, same as quick_select
+      int rank = ( count - 1 ) / 2;
+
+      int b = 0;
+      int below = 0;
+      while( below + kernelCoarse[b] <= rank ) {
+        below += kernelCoarse[b];
+        b++;
+      }
+      
+      // bring bucket b's fine bins to window centered at x
+      if( x - bucketX[b] > 2 * r + 1 ) {
+        // faster to rebuild from scratch
+        memset( &( kernelFine[ b << MEDIAN_COARSE_BITS ] ), 0,
+                MEDIAN_NUM_COARSE * sizeof( int ) );
+        
+        for( int kx = startX; kx <= endX; kx++ ) {
+          medianAddColumnBucket( kernelFine, 
+                                 &( colFine[ ( kx - colStart ) *
+                                             MEDIAN_NUM_BINS ] ),
+                                 b, 1 );
+        }
+      }
+      else {
+        for( int px = bucketX[b] + 1; px <= x; px++ ) {
+          int addX = px + r;
+          int subX = px - r - 1;
+          if( addX < w ) {
+            medianAddColumnBucket( kernelFine, 
+                                   &( colFine[ ( addX - colStart ) * 
+                                               MEDIAN_NUM_BINS ] ),
+                                   b, 1 );
+          }
+          if( subX >= 0 ) {
+            medianAddColumnBucket( kernelFine, 
+                                   &( colFine[ ( subX - colStart ) * 
+                                               MEDIAN_NUM_BINS ] ),
+                                   b, -1 );
+          }
+        }
+      }
+      bucketX[b] = x;
+
+      int *fine = &( kernelFine[ b << MEDIAN_COARSE_BITS ] );
+      int f = 0;
+      while( below + fine[f] <= rank ) {
+        below += fine[f];
+        f++;
+      }
+      
+      pass->result[ y * w + x ] = 
+        ( ( b << MEDIAN_COARSE_BITS ) + f ) / 1000.0;
+
+      
+      // slide kernel coarse histogram right
+      int addX = x + r + 1;
+      int subX = x - r;
+      if( addX < w ) {
+        unsigned short *cc = &( colCoarse[ ( addX - colStart ) * 
+                                           MEDIAN_NUM_COARSE ] );
+        for( int k=0; k<MEDIAN_NUM_COARSE; k++ ) {
+          kernelCoarse[k] += cc[k];
+        }
+      }
+      if( subX >= 0 ) {
+        unsigned short *cc = &( colCoarse[ ( subX - colStart ) * 
+                                           MEDIAN_NUM_COARSE ] );
+        for( int k=0; k<MEDIAN_NUM_COARSE; k++ ) {
+          kernelCoarse[k] -= cc[k];
+        }
+      }
+    }
+  }
+
+  delete [] colCoarse;
+  delete [] colFine;
+}
+
+
+
+inline void MedianFilter::applyHistograms( double *inChannel, 
+                                           int inWidth, int inHeight ) {
+  int numPixels = inWidth * inHeight;
+
+  // same quantization as quick_select mode
+  unsigned short *levels = new unsigned short[ numPixels ];
+  for( int p=0; p<numPixels; p++ ) {
+    int v = (int)( 1000 * inChannel[p] );
+    if( v < 0 ) {
+      v = 0;
+    }
+    else if( v >= MEDIAN_NUM_BINS ) {
+      v = MEDIAN_NUM_BINS - 1;
+    }
+    levels[p] = (unsigned short)v;
+  }
+
+  MedianHistogramPass pass;
+  pass.levels = levels;
+  pass.result = new double[ numPixels ];
+  pass.width = inWidth;
+  pass.height = inHeight;
+  pass.radius = mRadius;
+
+  // strips overlap by the radius when building column histograms,
+  // so don't make them too narrow
+  int minStripWidth = 2 * mRadius + 1;
+  if( minStripWidth < 64 ) {
+    minStripWidth = 64;
+  }
+  
+  runBlurPass( medianHistogramStrip, &pass, inWidth, minStripWidth );
+
+  memcpy( inChannel, pass.result, sizeof( double ) * numPixels );
+  
+  delete [] pass.result;
+  delete [] levels;
+}
+
 #endif
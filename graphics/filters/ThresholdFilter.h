@@ -3,6 +3,9 @@
  *
  * 2000-December-21		Jason Rohrer
  * Created. 
+ *
+ * 2026-October-14   Jason Rohrer
+ * Added compact 8-bit fast path.
  */
  
  
@@ -43,6 +46,9 @@ class ThresholdFilter : public ChannelFilter {
 		// implements the ChannelFilter interface
 		void apply( double *inChannel, int inWidth, int inHeight );
 
+		char applyCompact( unsigned char *inChannel, int inPixelStride,
+                           int inWidth, int inHeight );
+
 	private:
 		double mThreshold;
 	};
@@ -75,5 +81,25 @@ inline void ThresholdFilter::apply( double *inChannel,
 			}
 		}
 	}
+
+
+
+inline char ThresholdFilter::applyCompact( unsigned char *inChannel, 
+                                           int inPixelStride,
+                                           int inWidth, int inHeight ) {
+
+	int numPixels = inWidth * inHeight;
+	for( int i=0; i<numPixels; i++ ) {
+		// compare the same way apply does for the expanded value
+		if( *inChannel / 255.0 >= mThreshold ) {
+			*inChannel = 255;
+			}
+		else {
+			*inChannel = 0;
+			}
+		inChannel += inPixelStride;
+		}
+	return true;
+	}
 	
 #endif
@@ -0,0 +1,247 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14   Jason Rohrer
+ * Created.  Shared by BoxBlurFilter and FastBlurFilter.
+ */
+
+
+#ifndef SEPARABLE_BLUR_INCLUDED
+#define SEPARABLE_BLUR_INCLUDED
+
+
+#include "minorGems/system/Thread.h"
+
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || \
+    ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+    #define SEPARABLE_BLUR_SSE2
+    #include <emmintrin.h>
+#elif defined( __aarch64__ )
+    // double-precision NEON is only available on 64-bit ARM
+    #define SEPARABLE_BLUR_NEON
+    #include <arm_neon.h>
+#endif
+
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <unistd.h>
+#endif
+
+
+
+/**
+ * Building blocks for separable blur filters:  row-wise vector kernels
+ * and a fork-join helper that splits a pass across threads.
+ *
+ * Using a filter built on these means linking against Thread.
+ *
+ * @author Jason Rohrer
+ */
+
+
+
+// number of threads blur passes split across (number of cores)
+inline int getNumBlurThreads() {
+    static int numThreads = 0;
+
+    if( numThreads == 0 ) {
+        #ifdef _WIN32
+            SYSTEM_INFO info;
+            GetSystemInfo( &info );
+            numThreads = info.dwNumberOfProcessors;
+        #else
+            numThreads = (int)sysconf( _SC_NPROCESSORS_ONLN );
+        #endif
+
+        if( numThreads < 1 ) {
+            numThreads = 1;
+            }
+        }
+    return numThreads;
+    }
+
+
+
+// processes items [inStart, inEnd) of a pass
+typedef void (*BlurRangeFunction)( void *inContext, int inStart, int inEnd );
+
+
+
+class BlurRangeThread : public Thread {
+    public:
+
+        BlurRangeThread( BlurRangeFunction inFunction, void *inContext,
+                         int inStart, int inEnd )
+                : mFunction( inFunction ), mContext( inContext ),
+                  mStart( inStart ), mEnd( inEnd ) {
+            }
+
+        virtual void run() {
+            mFunction( mContext, mStart, mEnd );
+            }
+
+    protected:
+        BlurRangeFunction mFunction;
+        void *mContext;
+        int mStart;
+        int mEnd;
+    };
+
+
+
+/**
+ * Runs inFunction over [0, inNumItems) split into contiguous ranges,
+ * one per thread, and returns once all ranges are done.
+ *
+ * The calling thread processes the last range itself.  Small passes
+ * (fewer than inMinItemsPerThread items per thread) use fewer threads,
+ * down to none at all.
+ */
+inline void runBlurPass( BlurRangeFunction inFunction, void *inContext,
+                         int inNumItems, int inMinItemsPerThread ) {
+
+    int numThreads = getNumBlurThreads();
+
+    if( numThreads > inNumItems / inMinItemsPerThread ) {
+        numThreads = inNumItems / inMinItemsPerThread;
+        }
+
+    if( numThreads <= 1 ) {
+        inFunction( inContext, 0, inNumItems );
+        return;
+        }
+
+    int numExtra = numThreads - 1;
+
+    BlurRangeThread **threads = new BlurRangeThread*[ numExtra ];
+
+    for( int t=0; t<numExtra; t++ ) {
+        threads[t] = new BlurRangeThread(
+            inFunction, inContext,
+            ( t * inNumItems ) / numThreads,
+            ( ( t + 1 ) * inNumItems ) / numThreads );
+
+        threads[t]->start();
+        }
+
+    inFunction( inContext, ( numExtra * inNumItems ) / numThreads,
+                inNumItems );
+
+    for( int t=0; t<numExtra; t++ ) {
+        threads[t]->join();
+        delete threads[t];
+        }
+    delete [] threads;
+    }
+
+
+
+// ioSum[i] += inAdd[i]
+inline void blurAddRow( double *ioSum, const double *inAdd, int inLength ) {
+    int i = 0;
+
+#if defined( SEPARABLE_BLUR_SSE2 )
+    for( ; i + 2 <= inLength; i += 2 ) {
+        _mm_storeu_pd( ioSum + i,
+                       _mm_add_pd( _mm_loadu_pd( ioSum + i ),
+                                   _mm_loadu_pd( inAdd + i ) ) );
+        }
+#elif defined( SEPARABLE_BLUR_NEON )
+    for( ; i + 2 <= inLength; i += 2 ) {
+        vst1q_f64( ioSum + i, vaddq_f64( vld1q_f64( ioSum + i ),
+                                         vld1q_f64( inAdd + i ) ) );
+        }
+#endif
+
+    for( ; i < inLength; i++ ) {
+        ioSum[i] += inAdd[i];
+        }
+    }
+
+
+
+// ioSum[i] += inAdd[i] - inSubtract[i]
+inline void blurSlideRow( double *ioSum, const double *inAdd,
+                          const double *inSubtract, int inLength ) {
+    int i = 0;
+
+#if defined( SEPARABLE_BLUR_SSE2 )
+    for( ; i + 2 <= inLength; i += 2 ) {
+        __m128d d = _mm_sub_pd( _mm_loadu_pd( inAdd + i ),
+                                _mm_loadu_pd( inSubtract + i ) );
+        _mm_storeu_pd( ioSum + i, _mm_add_pd( _mm_loadu_pd( ioSum + i ), d ) );
+        }
+#elif defined( SEPARABLE_BLUR_NEON )
+    for( ; i + 2 <= inLength; i += 2 ) {
+        float64x2_t d = vsubq_f64( vld1q_f64( inAdd + i ),
+                                   vld1q_f64( inSubtract + i ) );
+        vst1q_f64( ioSum + i, vaddq_f64( vld1q_f64( ioSum + i ), d ) );
+        }
+#endif
+
+    for( ; i < inLength; i++ ) {
+        ioSum[i] += inAdd[i] - inSubtract[i];
+        }
+    }
+
+
+
+// outDest[i] = inSource[i] * inFactor
+inline void blurScaleRow( double *outDest, const double *inSource,
+                          double inFactor, int inLength ) {
+    int i = 0;
+
+#if defined( SEPARABLE_BLUR_SSE2 )
+    __m128d f = _mm_set1_pd( inFactor );
+    for( ; i + 2 <= inLength; i += 2 ) {
+        _mm_storeu_pd( outDest + i,
+                       _mm_mul_pd( _mm_loadu_pd( inSource + i ), f ) );
+        }
+#elif defined( SEPARABLE_BLUR_NEON )
+    for( ; i + 2 <= inLength; i += 2 ) {
+        vst1q_f64( outDest + i,
+                   vmulq_n_f64( vld1q_f64( inSource + i ), inFactor ) );
+        }
+#endif
+
+    for( ; i < inLength; i++ ) {
+        outDest[i] = inSource[i] * inFactor;
+        }
+    }
+
+
+
+// outDest[i] = ( inA[i] + inB[i] + inC[i] ) * inFactor
+inline void blurSum3Row( double *outDest, const double *inA,
+                         const double *inB, const double *inC,
+                         double inFactor, int inLength ) {
+    int i = 0;
+
+#if defined( SEPARABLE_BLUR_SSE2 )
+    __m128d f = _mm_set1_pd( inFactor );
+    for( ; i + 2 <= inLength; i += 2 ) {
+        __m128d s = _mm_add_pd( _mm_add_pd( _mm_loadu_pd( inA + i ),
+                                            _mm_loadu_pd( inB + i ) ),
+                                _mm_loadu_pd( inC + i ) );
+        _mm_storeu_pd( outDest + i, _mm_mul_pd( s, f ) );
+        }
+#elif defined( SEPARABLE_BLUR_NEON )
+    for( ; i + 2 <= inLength; i += 2 ) {
+        float64x2_t s = vaddq_f64( vaddq_f64( vld1q_f64( inA + i ),
+                                              vld1q_f64( inB + i ) ),
+                                   vld1q_f64( inC + i ) );
+        vst1q_f64( outDest + i, vmulq_n_f64( s, inFactor ) );
+        }
+#endif
+
+    for( ; i < inLength; i++ ) {
+        outDest[i] = ( inA[i] + inB[i] + inC[i] ) * inFactor;
+        }
+    }
+
+
+
+#endif
@@ -5,6 +5,85 @@
 
 #define JRI_VERSION  1
 
+// tiled
+#define JRI_TILED_VERSION  2
+
+
+
+// run-length decodes palette indices into pixels
+// returns false if data is corrupt (runs past end of data or pixels, or
+// index past end of palette)
+static char decodeRuns( const unsigned char *inData, int inNumDataBytes,
+                        rgbaColor *inColors, int inNumColors,
+                        rgbaColor *outPixels, int inNumPixels ) {
+    int p = 0;
+    int b = 0;
+    
+    while( b < inNumDataBytes ) {
+    
+        // a new run or non-run
+
+        if( b + 2 > inNumDataBytes ) {
+            return false;
+            }
+
+        int runType = inData[b++];
+        int runLength = inData[b++];
+        
+        if( p + runLength > inNumPixels ) {
+            return false;
+            }
+
+        if( runType == 1 ) {
+            // run
+
+            if( b >= inNumDataBytes ) {
+                return false;
+                }
+            
+            int runByte = inData[b++];
+
+            if( runByte >= inNumColors ) {
+                return false;
+                }
+            
+            //printf( "Length %d run of byte %d\n", runLength, runByte );
+
+            rgbaColor color = inColors[ runByte ];
+            
+            for( int r=0; r<runLength; r++ ) {
+                outPixels[p++] = color;
+                }
+            }
+        else {
+            // non-run
+            
+            //printf( "Length %d non-run\n", runLength );
+
+            if( b + runLength > inNumDataBytes ) {
+                return false;
+                }
+            
+            for( int r=0; r<runLength; r++ ) {
+                int index = inData[b++];
+
+                if( index >= inNumColors ) {
+                    return false;
+                    }
+                outPixels[p++] = inColors[ index ];
+                }
+            }
+        }
+
+    return true;
+    }
+
+
+
+static rgbaColor *extractTiledJRI( unsigned char *inData, int inNumBytes,
+                                   int *outWidth, int *outHeight );
+
+
 
 rgbaColor *extractJRI( unsigned char *inData, int inNumBytes,
                        int *outWidth, int *outHeight ) {
@@ -20,6 +99,10 @@ rgbaColor *extractJRI( unsigned char *inData, int inNumBytes,
         return NULL;
         }
     
+    if( version == JRI_TILED_VERSION ) {
+        return extractTiledJRI( inData, inNumBytes, outWidth, outHeight );
+        }
+
     if( version != JRI_VERSION ) {
         return NULL;
         }
@@ -77,38 +160,12 @@ rgbaColor *extractJRI( unsigned char *inData, int inNumBytes,
     
 
     rgbaColor *pixels = new rgbaColor[ numPixels ];
-    int p = 0;
-
-    
-    b = 0;
-    while( b < numDataBytes ) {
-    
-        // a new run or non-run
-
-        int runType = inData[b++];
-        int runLength = inData[b++];
-        
-
-        if( runType == 1 ) {
-            // run
-
-            int runByte = inData[b++];
-
-            //printf( "Length %d run of byte %d\n", runLength, runByte );
-
-            for( int r=0; r<runLength; r++ ) {
-                pixels[p++] = colors[ runByte ];
-                }
-            }
-        else {
-            // non-run
-            
-            //printf( "Length %d non-run\n", runLength );
 
-            for( int r=0; r<runLength; r++ ) {
-                pixels[p++] = colors[ inData[b++] ];
-                }
-            }
+    if( ! decodeRuns( inData, numDataBytes, colors, numColors,
+                      pixels, numPixels ) ) {
+        delete [] colors;
+        delete [] pixels;
+        return NULL;
         }
     
 
@@ -149,6 +206,103 @@ static void outputNonRunBytes( SimpleVector<unsigned char> *dataVector,
 
 
 
+// run-length encodes palette indices onto end of dataVector
+static void encodeRuns( unsigned char *inIndices, int inNumPixels,
+                        SimpleVector<unsigned char> *dataVector ) {
+    SimpleVector<unsigned char> nonRunBytes;
+    
+    unsigned char currentRunByte = 0;
+    
+    unsigned char currentRunLength = 0;
+    
+    
+    for( int p=0; p<inNumPixels; p++ ) {
+        if( currentRunLength == 0 ) {
+            currentRunByte = inIndices[p];
+            currentRunLength ++;
+            }
+        else if( currentRunByte == inIndices[p] ) {
+            if( currentRunLength < 255 ) {
+                currentRunLength ++;
+                }
+            else {
+                // run full, output it
+
+                // first, output and clear any non-run bytes that preceded 
+                // the run
+                outputNonRunBytes( dataVector, &nonRunBytes );
+
+
+                dataVector->push_back( 1 );
+                dataVector->push_back( currentRunLength );
+                dataVector->push_back( currentRunByte );
+
+                //printf( "Outputting %d-length run of byte %d\n", 
+                //        currentRunLength, currentRunByte );
+
+                // start a fresh run
+                currentRunLength = 1;
+                // keep current byte
+                }
+            }
+        else if( currentRunLength < 3 ) {
+            // a non-run that seemed like a run
+
+            // add this non-run to our non-run byte vector
+            for( int r=0; r<currentRunLength; r++ ) {
+                
+                if( nonRunBytes.size() == 255 ) {
+                    // a full non-run
+                    // output it
+                    
+                    outputNonRunBytes( dataVector, &nonRunBytes );
+                    }
+                
+                nonRunBytes.push_back( currentRunByte );
+                }
+
+            // see if a fresh run is starting
+            currentRunByte = inIndices[p];
+            currentRunLength = 1;
+            }
+        else {
+            // current run of length 3 or greater
+            // AND current run broken
+
+
+            // first, output and clear any non-run bytes that preceded the run
+            outputNonRunBytes( dataVector, &nonRunBytes );
+            
+        
+            // now output the run
+
+            dataVector->push_back( 1 );
+            dataVector->push_back( currentRunLength );
+            dataVector->push_back( currentRunByte );
+            
+            //printf( "Outputting %d-length run of byte %d\n", 
+            //        currentRunLength, currentRunByte );
+
+            // start a fresh run with this new, run-breaking byte
+            currentRunLength = 1;
+            currentRunByte = inIndices[p];
+            }
+        }
+    
+
+    // final runs?
+    outputNonRunBytes( dataVector, &nonRunBytes );
+    
+    if( currentRunLength > 0 ) {
+        dataVector->push_back( 1 );
+        dataVector->push_back( currentRunLength );
+        dataVector->push_back( currentRunByte );
+        
+        //printf( "Outputting %d-length run of byte %d\n", 
+        //        currentRunLength, currentRunByte );
+        }
+    }
+
 
 
 
@@ -241,107 +395,482 @@ unsigned char *generateJRI( rgbaColor *inRGBA, int inWidth, int inHeight,
     
     
     // run-length encode pixel index bytes
+    encodeRuns( pixelIndices, numPixels, &dataVector );
 
-    SimpleVector<unsigned char> nonRunBytes;
     
-    unsigned char currentRunByte = 0;
+    delete [] pixelIndices;
+
+            
+    *outNumBytes = dataVector.size();
+        
+    return dataVector.getElementArray();
+    }
+
+
+
+
+// Tiled format (version 2)
+
+// big-endian, like other minorGems binary formats
+static void putInt( SimpleVector<unsigned char> *inVector, int inValue ) {
+    inVector->push_back( ( inValue >> 24 ) & 0xFF );
+    inVector->push_back( ( inValue >> 16 ) & 0xFF );
+    inVector->push_back( ( inValue >> 8 ) & 0xFF );
+    inVector->push_back( inValue & 0xFF );
+    }
+
+
+static int getInt( const unsigned char *inBytes ) {
+    return 
+        ( inBytes[0] << 24 ) | ( inBytes[1] << 16 ) | 
+        ( inBytes[2] << 8 ) | inBytes[3];
+    }
+
+
+
+JRITileWriter::JRITileWriter( OutputStream *inStream,
+                              int inWidth, int inHeight,
+                              int inTileWidth, int inTileHeight )
+        : mStream( inStream ),
+          mWidth( inWidth ), mHeight( inHeight ),
+          mTileWidth( inTileWidth ), mTileHeight( inTileHeight ),
+          mFailed( false ), mRowsAdded( 0 ), mBandIndices( NULL ),
+          mLastColorIndex( -1 ), mNumBytesWritten( 0 ) {
+
+    if( mWidth < 1 || mHeight < 1 || mTileWidth < 1 || mTileHeight < 1 ) {
+        mFailed = true;
+        mNumTilesX = 0;
+        return;
+        }
     
-    unsigned char currentRunLength = 0;
+    mNumTilesX = ( mWidth + mTileWidth - 1 ) / mTileWidth;
+
+    mBandIndices = new unsigned char[ mWidth * mTileHeight ];
     
+    char *header = autoSprintf( "%d\n%d %d\n%d %d\n#",
+                                JRI_TILED_VERSION, 
+                                mWidth, mHeight,
+                                mTileWidth, mTileHeight );
     
-    for( int p=0; p<numPixels; p++ ) {
-        if( currentRunLength == 0 ) {
-            currentRunByte = pixelIndices[p];
-            currentRunLength ++;
-            }
-        else if( currentRunByte == pixelIndices[p] ) {
-            if( currentRunLength < 255 ) {
-                currentRunLength ++;
-                }
-            else {
-                // run full, output it
+    write( (unsigned char*)header, strlen( header ) );
+    
+    delete [] header;
+    }
 
-                // first, output and clear any non-run bytes that preceded 
-                // the run
-                outputNonRunBytes( &dataVector, &nonRunBytes );
 
 
-                dataVector.push_back( 1 );
-                dataVector.push_back( currentRunLength );
-                dataVector.push_back( currentRunByte );
+JRITileWriter::~JRITileWriter() {
+    if( mBandIndices != NULL ) {
+        delete [] mBandIndices;
+        }
+    }
 
-                //printf( "Outputting %d-length run of byte %d\n", 
-                //        currentRunLength, currentRunByte );
 
-                // start a fresh run
-                currentRunLength = 1;
-                // keep current byte
-                }
-            }
-        else if( currentRunLength < 3 ) {
-            // a non-run that seemed like a run
 
-            // add this non-run to our non-run byte vector
-            for( int r=0; r<currentRunLength; r++ ) {
+char JRITileWriter::write( unsigned char *inBytes, int inNumBytes ) {
+    if( mFailed ) {
+        return false;
+        }
+    
+    if( mStream->write( inBytes, inNumBytes ) != inNumBytes ) {
+        mFailed = true;
+        return false;
+        }
+    
+    mNumBytesWritten += inNumBytes;
+    return true;
+    }
+
+
+
+char JRITileWriter::addRows( rgbaColor *inRows, int inNumRows ) {
+    if( mFailed ) {
+        return false;
+        }
+    
+    if( mRowsAdded + inNumRows > mHeight ) {
+        mFailed = true;
+        return false;
+        }
+    
+    for( int y=0; y<inNumRows; y++ ) {
+        rgbaColor *row = &( inRows[ y * mWidth ] );
+        
+        int bandRow = mRowsAdded % mTileHeight;
+        
+        unsigned char *indices = &( mBandIndices[ bandRow * mWidth ] );
+        
+        for( int x=0; x<mWidth; x++ ) {
+            rgbaColor color = row[x];
+
+            // neighboring pixels are often the same color, so check
+            // last color found first
+            if( mLastColorIndex != -1 ) {
+                rgbaColor last = mColors.getElementDirect( mLastColorIndex );
                 
-                if( nonRunBytes.size() == 255 ) {
-                    // a full non-run
-                    // output it
-                    
-                    outputNonRunBytes( &dataVector, &nonRunBytes );
+                if( last.r == color.r &&
+                    last.g == color.g &&
+                    last.b == color.b ) {
+                    indices[x] = (unsigned char)mLastColorIndex;
+                    continue;
                     }
+                }
+
+            int foundIndex = -1;
+            
+            int numColors = mColors.size();
+            for( int c=0; c<numColors; c++ ) {
+                rgbaColor *other = mColors.getElementFast( c );
                 
-                nonRunBytes.push_back( currentRunByte );
+                if( other->r == color.r &&
+                    other->g == color.g &&
+                    other->b == color.b ) {
+                    foundIndex = c;
+                    break;
+                    }
                 }
+            
+            if( foundIndex == -1 ) {
+                if( numColors == 256 ) {
+                    mFailed = true;
+                    return false;
+                    }
+                mColors.push_back( color );
+                foundIndex = numColors;
+                }
+            
+            indices[x] = (unsigned char)foundIndex;
+            mLastColorIndex = foundIndex;
+            }
 
-            // see if a fresh run is starting
-            currentRunByte = pixelIndices[p];
-            currentRunLength = 1;
+        mRowsAdded++;
+        
+        if( mRowsAdded % mTileHeight == 0 ) {
+            writeBand( mTileHeight );
+            }
+        else if( mRowsAdded == mHeight ) {
+            // last, short band
+            writeBand( mRowsAdded % mTileHeight );
             }
-        else {
-            // current run of length 3 or greater
-            // AND current run broken
 
+        if( mFailed ) {
+            return false;
+            }
+        }
 
-            // first, output and clear any non-run bytes that preceded the run
-            outputNonRunBytes( &dataVector, &nonRunBytes );
-            
-        
-            // now output the run
+    return true;
+    }
 
-            dataVector.push_back( 1 );
-            dataVector.push_back( currentRunLength );
-            dataVector.push_back( currentRunByte );
-            
-            //printf( "Outputting %d-length run of byte %d\n", 
-            //        currentRunLength, currentRunByte );
 
-            // start a fresh run with this new, run-breaking byte
-            currentRunLength = 1;
-            currentRunByte = pixelIndices[p];
+
+void JRITileWriter::writeBand( int inBandHeight ) {
+    
+    unsigned char *tileIndices = 
+        new unsigned char[ mTileWidth * inBandHeight ];
+    
+    SimpleVector<unsigned char> tileData;
+    
+    for( int t=0; t<mNumTilesX; t++ ) {
+        int startX = t * mTileWidth;
+        
+        int tileWidth = mTileWidth;
+        if( startX + tileWidth > mWidth ) {
+            tileWidth = mWidth - startX;
             }
+        
+        for( int y=0; y<inBandHeight; y++ ) {
+            memcpy( &( tileIndices[ y * tileWidth ] ),
+                    &( mBandIndices[ y * mWidth + startX ] ),
+                    tileWidth );
+            }
+        
+        tileData.deleteAll();
+        
+        encodeRuns( tileIndices, tileWidth * inBandHeight, &tileData );
+
+        mTileOffsets.push_back( mNumBytesWritten );
+
+        unsigned char *tileBytes = tileData.getElementArray();
+        
+        write( tileBytes, tileData.size() );
+
+        delete [] tileBytes;
         }
     
+    delete [] tileIndices;
+    }
 
-    // final runs?
-    outputNonRunBytes( &dataVector, &nonRunBytes );
+
+
+char JRITileWriter::finish() {
+    if( mFailed || mRowsAdded != mHeight ) {
+        return false;
+        }
     
-    if( currentRunLength > 0 ) {
-        dataVector.push_back( 1 );
-        dataVector.push_back( currentRunLength );
-        dataVector.push_back( currentRunByte );
+    // palette and index come after tiles, since palette isn't known
+    // until all rows are in
+
+    int footerOffset = mNumBytesWritten;
+    
+    SimpleVector<unsigned char> footer;
+
+    int numColors = mColors.size();
+    
+    footer.push_back( ( numColors >> 8 ) & 0xFF );
+    footer.push_back( numColors & 0xFF );
+    
+    for( int c=0; c<numColors; c++ ) {
+        rgbaColor color = mColors.getElementDirect( c );
         
-        //printf( "Outputting %d-length run of byte %d\n", 
-        //        currentRunLength, currentRunByte );
+        footer.push_back( color.r );
+        footer.push_back( color.g );
+        footer.push_back( color.b );
         }
+
+    int numTiles = mTileOffsets.size();
+    
+    for( int t=0; t<numTiles; t++ ) {
+        putInt( &footer, mTileOffsets.getElementDirect( t ) );
+        }
+    // end of last tile
+    putInt( &footer, footerOffset );
+    
+    // last 4 bytes of file locate footer
+    putInt( &footer, footerOffset );
+    
+    unsigned char *footerBytes = footer.getElementArray();
+    
+    char result = write( footerBytes, footer.size() );
     
+    delete [] footerBytes;
+    
+    return result;
+    }
+
+
+
+
+JRITileReader::JRITileReader( const unsigned char *inData, int inNumBytes )
+        : mData( inData ), mNumBytes( inNumBytes ), mValid( false ),
+          mWidth( 0 ), mHeight( 0 ), mTileWidth( 0 ), mTileHeight( 0 ),
+          mNumTilesX( 0 ), mNumTilesY( 0 ),
+          mColors( NULL ), mNumColors( 0 ), mTileIndex( NULL ) {
 
+    // header is short, and data isn't NULL-terminated, so copy it
+    // into a string before scanning it
+    char header[100];
     
-    delete [] pixelIndices;
+    int headerLength = 0;
+    while( headerLength < inNumBytes && headerLength < 99 &&
+           inData[ headerLength ] != '#' ) {
+        header[ headerLength ] = inData[ headerLength ];
+        headerLength++;
+        }
+    header[ headerLength ] = '\0';
 
-            
-    *outNumBytes = dataVector.size();
+    if( headerLength >= inNumBytes || inData[ headerLength ] != '#' ) {
+        return;
+        }
+    
+    int version;
+    
+    int numRead = sscanf( header, "%d %d %d %d %d", &version,
+                          &mWidth, &mHeight, &mTileWidth, &mTileHeight );
+    
+    if( numRead != 5 || version != JRI_TILED_VERSION ||
+        mWidth < 1 || mHeight < 1 || mTileWidth < 1 || mTileHeight < 1 ) {
+        return;
+        }
+    
+    mNumTilesX = ( mWidth + mTileWidth - 1 ) / mTileWidth;
+    mNumTilesY = ( mHeight + mTileHeight - 1 ) / mTileHeight;
+
+    // index needs 4 bytes per tile, so this also keeps tile count
+    // from overflowing
+    if( mNumTilesX > ( inNumBytes / 4 ) / mNumTilesY ) {
+        return;
+        }
+
+    int numTiles = mNumTilesX * mNumTilesY;
+
+    int tilesStart = headerLength + 1;
+    
+    if( inNumBytes < tilesStart + 6 ) {
+        return;
+        }
+    
+    int footerOffset = getInt( &( inData[ inNumBytes - 4 ] ) );
+
+    if( footerOffset < tilesStart || footerOffset + 2 > inNumBytes - 4 ) {
+        return;
+        }
+    
+    const unsigned char *footer = &( inData[ footerOffset ] );
+    
+    mNumColors = ( footer[0] << 8 ) | footer[1];
+    
+    if( mNumColors > 256 ||
+        footerOffset + 2 + 3 * mNumColors + 4 * ( numTiles + 1 ) + 4 
+        != inNumBytes ) {
+        return;
+        }
+
+    mColors = new rgbaColor[ mNumColors ];
+    
+    int b = 2;
+    for( int c=0; c<mNumColors; c++ ) {
+        mColors[c].r = footer[b++];
+        mColors[c].g = footer[b++];
+        mColors[c].b = footer[b++];
+        mColors[c].a = 255;
+        }
+    
+    mTileIndex = &( footer[b] );
+
+    // offsets must be in order, and inside tile data
+    int lastOffset = tilesStart;
+    for( int t=0; t<=numTiles; t++ ) {
+        int offset = getTileOffset( t );
         
-    return dataVector.getElementArray();
+        if( offset < lastOffset || offset > footerOffset ) {
+            return;
+            }
+        lastOffset = offset;
+        }
+    
+    mValid = true;
     }
 
+
+
+JRITileReader::~JRITileReader() {
+    if( mColors != NULL ) {
+        delete [] mColors;
+        }
+    }
+
+
+
+char JRITileReader::isValid() {
+    return mValid;
+    }
+
+
+int JRITileReader::getWidth() {
+    return mWidth;
+    }
+
+
+int JRITileReader::getHeight() {
+    return mHeight;
+    }
+
+
+int JRITileReader::getTileWidth() {
+    return mTileWidth;
+    }
+
+
+int JRITileReader::getTileHeight() {
+    return mTileHeight;
+    }
+
+
+int JRITileReader::getNumTilesX() {
+    return mNumTilesX;
+    }
+
+
+int JRITileReader::getNumTilesY() {
+    return mNumTilesY;
+    }
+
+
+
+int JRITileReader::getTileOffset( int inTileNumber ) {
+    return getInt( &( mTileIndex[ 4 * inTileNumber ] ) );
+    }
+
+
+
+rgbaColor *JRITileReader::decodeTile( int inTileX, int inTileY,
+                                      int *outWidth, int *outHeight ) {
+    if( ! mValid ||
+        inTileX < 0 || inTileX >= mNumTilesX ||
+        inTileY < 0 || inTileY >= mNumTilesY ) {
+        return NULL;
+        }
+
+    int w = mTileWidth;
+    if( ( inTileX + 1 ) * mTileWidth > mWidth ) {
+        w = mWidth - inTileX * mTileWidth;
+        }
+
+    int h = mTileHeight;
+    if( ( inTileY + 1 ) * mTileHeight > mHeight ) {
+        h = mHeight - inTileY * mTileHeight;
+        }
+    
+    int tileNumber = inTileY * mNumTilesX + inTileX;
+    
+    int start = getTileOffset( tileNumber );
+    int end = getTileOffset( tileNumber + 1 );
+    
+    rgbaColor *pixels = new rgbaColor[ w * h ];
+
+    if( ! decodeRuns( &( mData[ start ] ), end - start,
+                      mColors, mNumColors, pixels, w * h ) ) {
+        delete [] pixels;
+        return NULL;
+        }
+    
+    *outWidth = w;
+    *outHeight = h;
+    
+    return pixels;
+    }
+
+
+
+static rgbaColor *extractTiledJRI( unsigned char *inData, int inNumBytes,
+                                   int *outWidth, int *outHeight ) {
+    JRITileReader reader( inData, inNumBytes );
+    
+    if( ! reader.isValid() ) {
+        return NULL;
+        }
+    
+    int w = reader.getWidth();
+    int h = reader.getHeight();
+    
+    rgbaColor *pixels = new rgbaColor[ w * h ];
+    
+    for( int ty=0; ty<reader.getNumTilesY(); ty++ ) {
+        for( int tx=0; tx<reader.getNumTilesX(); tx++ ) {
+            int tileW, tileH;
+            
+            rgbaColor *tile = reader.decodeTile( tx, ty, &tileW, &tileH );
+            
+            if( tile == NULL ) {
+                delete [] pixels;
+                return NULL;
+                }
+            
+            int startX = tx * reader.getTileWidth();
+            int startY = ty * reader.getTileHeight();
+            
+            for( int y=0; y<tileH; y++ ) {
+                memcpy( &( pixels[ ( startY + y ) * w + startX ] ),
+                        &( tile[ y * tileW ] ),
+                        tileW * sizeof( rgbaColor ) );
+                }
+            
+            delete [] tile;
+            }
+        }
+
+    *outWidth = w;
+    *outHeight = h;
+    
+    return pixels;
+    }
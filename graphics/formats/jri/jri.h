@@ -1,6 +1,13 @@
+#ifndef JRI_INCLUDED
+#define JRI_INCLUDED
+
+
 #include "minorGems/graphics/rgbaColor.h"
+#include "minorGems/io/OutputStream.h"
+#include "minorGems/util/SimpleVector.h"
 
 
+// reads version 1 (whole image) or version 2 (tiled) data
 rgbaColor *extractJRI( unsigned char *inData, int inNumBytes,
                        int *outWidth, int *outHeight );
 
@@ -9,3 +16,160 @@ rgbaColor *extractJRI( unsigned char *inData, int inNumBytes,
 // returns NULL if inRGBA contains more than 256 colors
 unsigned char *generateJRI( rgbaColor *inRGBA, int inWidth, int inHeight,
                             int *outNumBytes );
+
+
+
+
+// Tiled JRI (version 2, see format.txt), for images too big to hold in
+// memory at once, like large map overviews.
+//
+// Encoding streams:  rows go in top to bottom, and each row of tiles is
+// written out as soon as its last row arrives, so the writer only holds
+// one row of tiles (as 8-bit palette indices).
+//
+// Decoding works one tile at a time from the file's bytes (which can be
+// a MappedFileContents, so only touched tiles are paged in).
+
+
+class JRITileWriter {
+
+    public:
+
+        /**
+         * Starts a tiled image, writing its header.
+         *
+         * @param inStream the stream to write to.  Destroyed by caller,
+         *   after finish is called.
+         * @param inWidth, inHeight the image size.
+         * @param inTileWidth, inTileHeight the tile size.  Tiles at right
+         *   and bottom edges are cut off by the image edge.
+         */
+        JRITileWriter( OutputStream *inStream,
+                       int inWidth, int inHeight,
+                       int inTileWidth = 256, int inTileHeight = 256 );
+
+        ~JRITileWriter();
+
+
+        /**
+         * Adds the next rows of the image.
+         *
+         * @param inRows inNumRows rows, each image width pixels.
+         *   Destroyed by caller.
+         * @param inNumRows the number of rows.
+         *
+         * @return false if writing failed, the image went past 256
+         *   colors, or more rows were added than the image has.
+         *   Nothing more can be added after a failure.
+         */
+        char addRows( rgbaColor *inRows, int inNumRows );
+
+
+        /**
+         * Ends the image, writing its palette and tile index.
+         *
+         * @return false if writing failed, or if not all rows were added.
+         */
+        char finish();
+
+
+    protected:
+
+        OutputStream *mStream;
+
+        int mWidth, mHeight;
+        int mTileWidth, mTileHeight;
+        int mNumTilesX;
+
+        char mFailed;
+
+        int mRowsAdded;
+
+        // one row of tiles, as palette indices
+        unsigned char *mBandIndices;
+
+        SimpleVector<rgbaColor> mColors;
+        int mLastColorIndex;
+
+        // start of each tile, from start of file
+        SimpleVector<int> mTileOffsets;
+
+        int mNumBytesWritten;
+
+
+        char write( unsigned char *inBytes, int inNumBytes );
+
+        // encodes and writes tiles in mBandIndices
+        void writeBand( int inBandHeight );
+    };
+
+
+
+class JRITileReader {
+
+    public:
+
+        /**
+         * Reads header, palette, and tile index of tiled data.
+         *
+         * @param inData the whole JRI file.  Not copied, and must
+         *   stay valid while this reader is used.
+         * @param inNumBytes the length of inData.
+         */
+        JRITileReader( const unsigned char *inData, int inNumBytes );
+
+        ~JRITileReader();
+
+
+        // false if data isn't valid tiled JRI data
+        char isValid();
+
+
+        int getWidth();
+        int getHeight();
+        int getTileWidth();
+        int getTileHeight();
+
+        // tiles across and down
+        int getNumTilesX();
+        int getNumTilesY();
+
+
+        /**
+         * Decodes one tile.
+         *
+         * @param inTileX, inTileY the tile's position, in tiles.
+         * @param outWidth, outHeight pointers to where the tile's size
+         *   should be returned (smaller than the tile size at right and
+         *   bottom edges).
+         *
+         * @return the tile's pixels, or NULL if tile data is corrupt.
+         *   Destroyed by caller.
+         */
+        rgbaColor *decodeTile( int inTileX, int inTileY,
+                               int *outWidth, int *outHeight );
+
+
+    protected:
+
+        const unsigned char *mData;
+        int mNumBytes;
+
+        char mValid;
+
+        int mWidth, mHeight;
+        int mTileWidth, mTileHeight;
+        int mNumTilesX, mNumTilesY;
+
+        rgbaColor *mColors;
+        int mNumColors;
+
+        // numTiles + 1 offsets, last one is end of last tile
+        const unsigned char *mTileIndex;
+
+        int getTileOffset( int inTileNumber );
+    };
+
+
+
+#endif
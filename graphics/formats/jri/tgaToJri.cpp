@@ -3,16 +3,29 @@
 #include "minorGems/graphics/RGBAImage.h"
 #include "minorGems/io/file/File.h"
 #include "minorGems/io/file/FileInputStream.h"
+#include "minorGems/io/file/FileOutputStream.h"
 
 
 int main( int inNumArgs, char**inArgs  ) {
     
 
-    if( inNumArgs != 3 ) {
-		printf( "Usage:  tgaToJri  in.tga out.jri\n" );
+    if( inNumArgs != 3 && inNumArgs != 4 ) {
+		printf( "Usage:  tgaToJri  in.tga out.jri [tile_size]\n" );
+		printf( "With tile_size, writes tiled (version 2) JRI\n" );
 		return 1;
 		}
 
+    int tileSize = 0;
+    
+    if( inNumArgs == 4 ) {
+        sscanf( inArgs[3], "%d", &tileSize );
+        
+        if( tileSize < 1 ) {
+            printf( "Bad tile size:  %s\n", inArgs[3] );
+            return 1;
+            }
+        }
+
 
     File f( NULL, inArgs[1] );
     
@@ -28,6 +41,26 @@ int main( int inNumArgs, char**inArgs  ) {
         
         unsigned char *rgbaBytes = RGBAImage::getRGBABytes( image );
 
+        if( tileSize > 0 ) {
+            File outFile( NULL, inArgs[2] );
+            FileOutputStream fOut( &outFile );
+
+            JRITileWriter writer( &fOut, 
+                                  image->getWidth(), image->getHeight(),
+                                  tileSize, tileSize );
+            
+            if( ! writer.addRows( (rgbaColor*)rgbaBytes, 
+                                  image->getHeight() ) ||
+                ! writer.finish() ) {
+                printf( "Converting image to tiled JRI failed.  "
+                        "More than 256 colors?\n" );
+                }
+            
+            delete [] rgbaBytes;
+            delete image;
+            return 0;
+            }
+        
         int jriSize;
         
         unsigned char *jriBytes = 
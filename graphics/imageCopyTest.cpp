@@ -0,0 +1,454 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+/**
+ * Checks Image's region and paste functions (getSubImage, setSubImage,
+ * expandImage, paste, copyChannel, and masked pasteChannel) against
+ * pixel-by-pixel results, for double and compact images, and times
+ * them on a large image.
+ *
+ * Compile from above the minorGems directory with:
+ *   g++ -O2 -I. minorGems/graphics/imageCopyTest.cpp
+ *     minorGems/io/linux/TypeIOLinux.cpp minorGems/system/unix/TimeUnix.cpp
+ *     -o imageCopyTest
+ */
+
+#include "Image.h"
+
+#include "minorGems/system/Time.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+
+static int numBad = 0;
+
+
+
+static unsigned char *makeBytes( int inNumBytes ) {
+    unsigned char *bytes = new unsigned char[ inNumBytes ];
+    for( int i=0; i<inNumBytes; i++ ) {
+        bytes[i] = (unsigned char)( rand() % 256 );
+        }
+    return bytes;
+    }
+
+
+
+// random values on the 8-bit grid, so compact and double images agree
+static Image *makeImage( int inWidth, int inHeight, int inNumChannels,
+                         char inCompact ) {
+    unsigned char *bytes = makeBytes( inWidth * inHeight * inNumChannels );
+
+    Image *image = new Image( bytes, inWidth, inHeight, inNumChannels );
+
+    if( ! inCompact ) {
+        // expand
+        image->getChannel( 0 );
+        }
+    return image;
+    }
+
+
+
+// values between 0 and 1 that aren't on the 8-bit grid
+static Image *makeMask( int inWidth, int inHeight, int inNumChannels ) {
+    Image *mask = new Image( inWidth, inHeight, inNumChannels );
+
+    for( int c=0; c<inNumChannels; c++ ) {
+        double *values = mask->getChannel( c );
+        for( int i=0; i<inWidth * inHeight; i++ ) {
+            values[i] = rand() / (double)RAND_MAX;
+            }
+        }
+    return mask;
+    }
+
+
+
+// value of a pixel, without expanding a compact image
+static double getValue( Image *inImage, int inChannel, int inIndex ) {
+    if( inImage->isCompact() ) {
+        return inImage->getCompactBytes()[
+            inIndex * inImage->getNumChannels() + inChannel ] / 255.0;
+        }
+    return inImage->getChannel( inChannel )[ inIndex ];
+    }
+
+
+
+static void checkClose( const char *inWhat, double inExpected,
+                        double inActual, int *ioNumWrong ) {
+    if( fabs( inExpected - inActual ) > 1e-12 ) {
+        if( *ioNumWrong == 0 ) {
+            printf( "%s:  expected %f, got %f\n",
+                    inWhat, inExpected, inActual );
+            }
+        (*ioNumWrong)++;
+        }
+    }
+
+
+
+static void checkSubImage( char inCompact ) {
+    Image *image = makeImage( 37, 23, 3, inCompact );
+
+    int numWrong = 0;
+
+    // partial rows, then full rows
+    int starts[2][4] = { { 5, 3, 20, 11 }, { 0, 4, 37, 9 } };
+
+    for( int s=0; s<2; s++ ) {
+        int *r = starts[s];
+
+        Image *sub = image->getSubImage( r[0], r[1], r[2], r[3] );
+
+        if( sub->isCompact() != inCompact ) {
+            printf( "getSubImage changed compactness\n" );
+            numWrong++;
+            }
+
+        for( int c=0; c<3; c++ ) {
+            for( int y=0; y<r[3]; y++ ) {
+                for( int x=0; x<r[2]; x++ ) {
+                    checkClose( "getSubImage",
+                                getValue( image, c,
+                                          ( y + r[1] ) * 37 + x + r[0] ),
+                                getValue( sub, c, y * r[2] + x ),
+                                &numWrong );
+                    }
+                }
+            }
+        delete sub;
+        }
+
+    if( image->isCompact() != inCompact ) {
+        printf( "getSubImage expanded its image\n" );
+        numWrong++;
+        }
+
+    delete image;
+
+    if( numWrong > 0 ) {
+        numBad++;
+        }
+    }
+
+
+
+static void checkSetSubImage( char inCompactDest, char inCompactSource,
+                              int inSourceChannels ) {
+    Image *dest = makeImage( 40, 30, 3, inCompactDest );
+    Image *source = makeImage( 25, 12, inSourceChannels, inCompactSource );
+
+    Image *before = dest->copy();
+
+    // runs off the right edge, so is clipped
+    int startX = 20;
+    int startY = 9;
+
+    dest->setSubImage( startX, startY, 25, 12, source );
+
+    int numWrong = 0;
+
+    if( source->isCompact() != inCompactSource ) {
+        printf( "setSubImage expanded its source\n" );
+        numWrong++;
+        }
+    if( inCompactDest && inCompactSource && inSourceChannels == 3 &&
+        ! dest->isCompact() ) {
+        printf( "setSubImage expanded compact into compact\n" );
+        numWrong++;
+        }
+
+    for( int c=0; c<3; c++ ) {
+        for( int y=0; y<30; y++ ) {
+            for( int x=0; x<40; x++ ) {
+                int i = y * 40 + x;
+
+                double expected = getValue( before, c, i );
+
+                if( x >= startX && y >= startY && y < startY + 12 ) {
+                    expected = getValue( source, c,
+                                         ( y - startY ) * 25 + x - startX );
+                    }
+
+                checkClose( "setSubImage", expected, getValue( dest, c, i ),
+                            &numWrong );
+                }
+            }
+        }
+
+    delete before;
+    delete dest;
+    delete source;
+
+    if( numWrong > 0 ) {
+        numBad++;
+        }
+    }
+
+
+
+static void checkExpandImage( char inCompact, char inWhiteBorder ) {
+    Image *image = makeImage( 17, 9, 4, inCompact );
+
+    Image *expanded = image->expandImage( 30, 20, inWhiteBorder );
+
+    int numWrong = 0;
+
+    if( expanded->isCompact() != inCompact ) {
+        printf( "expandImage changed compactness\n" );
+        numWrong++;
+        }
+
+    int xOffset = ( 30 - 17 ) / 2;
+    int yOffset = ( 20 - 9 ) / 2;
+
+    for( int c=0; c<4; c++ ) {
+        for( int y=0; y<20; y++ ) {
+            for( int x=0; x<30; x++ ) {
+                double expected = inWhiteBorder ? 1 : 0;
+
+                if( x >= xOffset && x < xOffset + 17 &&
+                    y >= yOffset && y < yOffset + 9 ) {
+                    expected = getValue( image, c,
+                                         ( y - yOffset ) * 17 +
+                                         x - xOffset );
+                    }
+
+                checkClose( "expandImage", expected,
+                            getValue( expanded, c, y * 30 + x ),
+                            &numWrong );
+                }
+            }
+        }
+
+    delete image;
+    delete expanded;
+
+    if( numWrong > 0 ) {
+        numBad++;
+        }
+    }
+
+
+
+// inDestSelectionChannels and inSourceSelectionChannels of 0 mean no
+// selection
+static void checkPaste( char inCompactDest, char inCompactSource,
+                        int inSourceChannels,
+                        int inDestSelectionChannels,
+                        int inSourceSelectionChannels ) {
+    // odd pixel count, more than one paste block
+    int w = 71;
+    int h = 53;
+
+    Image *dest = makeImage( w, h, 3, inCompactDest );
+    Image *source = makeImage( w, h, inSourceChannels, inCompactSource );
+
+    Image *destSelection = NULL;
+    Image *sourceSelection = NULL;
+
+    if( inDestSelectionChannels > 0 ) {
+        destSelection = makeMask( w, h, inDestSelectionChannels );
+        dest->setSelection( destSelection );
+        }
+    if( inSourceSelectionChannels > 0 ) {
+        sourceSelection = makeMask( w, h, inSourceSelectionChannels );
+        source->setSelection( sourceSelection );
+        }
+
+    // expected values, pixel by pixel, before pasting
+    int numChannels = 3;
+    if( inSourceChannels < numChannels ) {
+        numChannels = inSourceChannels;
+        }
+
+    double *expected = new double[ 3 * w * h ];
+
+    for( int c=0; c<3; c++ ) {
+        for( int i=0; i<w*h; i++ ) {
+            double t = getValue( dest, c, i );
+            double v = t;
+
+            if( c < numChannels ) {
+                double d = getValue( source, c, i );
+
+                double m = 1;
+                if( sourceSelection != NULL ) {
+                    m = sourceSelection->getChannel(
+                        inSourceSelectionChannels == inSourceChannels ?
+                        c : 0 )[i];
+                    }
+                double s = 1;
+                if( destSelection != NULL ) {
+                    s = destSelection->getChannel(
+                        inDestSelectionChannels == 3 ? c : 0 )[i];
+                    }
+
+                v = t * ( 1 - s ) + ( t * ( 1 - m ) + d * m ) * s;
+                }
+            expected[ c * w * h + i ] = v;
+            }
+        }
+
+    dest->paste( source );
+
+    int numWrong = 0;
+
+    if( inDestSelectionChannels == 0 && inSourceSelectionChannels == 0 ) {
+        if( source->isCompact() != inCompactSource ) {
+            printf( "paste expanded its source\n" );
+            numWrong++;
+            }
+        if( dest->isCompact() != ( inCompactDest && inCompactSource ) ) {
+            printf( "paste changed compactness\n" );
+            numWrong++;
+            }
+        }
+
+    for( int c=0; c<3; c++ ) {
+        for( int i=0; i<w*h; i++ ) {
+            checkClose( "paste", expected[ c * w * h + i ],
+                        getValue( dest, c, i ), &numWrong );
+            }
+        }
+
+
+    // and copyChannel, with the same selection
+    Image *copySource = makeImage( w, h, 3, inCompactSource );
+    copySource->setSelection( destSelection );
+
+    for( int c=0; c<3; c++ ) {
+        double *copied = copySource->copyChannel( c );
+
+        for( int i=0; i<w*h; i++ ) {
+            double s = 1;
+            if( destSelection != NULL ) {
+                s = destSelection->getChannel(
+                    inDestSelectionChannels == 3 ? c : 0 )[i];
+                }
+            checkClose( "copyChannel", getValue( copySource, c, i ) * s,
+                        copied[i], &numWrong );
+            }
+        delete [] copied;
+        }
+
+    if( copySource->isCompact() != inCompactSource ) {
+        printf( "copyChannel expanded its image\n" );
+        numWrong++;
+        }
+
+    delete copySource;
+
+
+    delete [] expected;
+    delete dest;
+    delete source;
+
+    if( destSelection != NULL ) {
+        delete destSelection;
+        }
+    if( sourceSelection != NULL ) {
+        delete sourceSelection;
+        }
+
+    if( numWrong > 0 ) {
+        printf( "  (dest compact %d, source compact %d, source channels %d, "
+                "dest selection %d, source selection %d)\n",
+                inCompactDest, inCompactSource, inSourceChannels,
+                inDestSelectionChannels, inSourceSelectionChannels );
+        numBad++;
+        }
+    }
+
+
+
+int main() {
+
+    srand( 10 );
+
+    for( int compact=0; compact<2; compact++ ) {
+        checkSubImage( compact );
+
+        for( int white=0; white<2; white++ ) {
+            checkExpandImage( compact, white );
+            }
+
+        for( int compactSource=0; compactSource<2; compactSource++ ) {
+            checkSetSubImage( compact, compactSource, 3 );
+            checkSetSubImage( compact, compactSource, 4 );
+
+            int selectionChannels[3] = { 0, 1, 3 };
+
+            for( int d=0; d<3; d++ ) {
+                for( int s=0; s<3; s++ ) {
+                    checkPaste( compact, compactSource, 3,
+                                selectionChannels[d], selectionChannels[s] );
+                    }
+                }
+            checkPaste( compact, compactSource, 4, 0, 0 );
+            checkPaste( compact, compactSource, 2, 0, 0 );
+            }
+        }
+
+
+    // timing, on an atlas-sized image
+    int w = 2048;
+    int h = 2048;
+    int numRuns = 10;
+
+    Image *big = makeImage( w, h, 4, false );
+    Image *other = makeImage( w, h, 4, false );
+    Image *mask = makeMask( w, h, 1 );
+
+    other->setSelection( mask );
+
+    double startTime = Time::getCurrentTime();
+    for( int r=0; r<numRuns; r++ ) {
+        big->paste( other );
+        }
+    double pasteTime = ( Time::getCurrentTime() - startTime ) / numRuns;
+
+    startTime = Time::getCurrentTime();
+    for( int r=0; r<numRuns; r++ ) {
+        Image *expanded = big->expandImage( w + 64, h + 64 );
+        delete expanded;
+        }
+    double expandTime = ( Time::getCurrentTime() - startTime ) / numRuns;
+
+    Image *compact = makeImage( w, h, 4, true );
+    Image *compactDest = makeImage( w, h, 4, false );
+
+    startTime = Time::getCurrentTime();
+    for( int r=0; r<numRuns; r++ ) {
+        compactDest->setSubImage( 0, 0, w, h, compact );
+        }
+    double setTime = ( Time::getCurrentTime() - startTime ) / numRuns;
+
+    printf( "%dx%d, 4 channels:  masked paste %.2f ms, "
+            "expandImage %.2f ms,\n"
+            "  setSubImage from compact %.2f ms\n",
+            w, h, pasteTime * 1000, expandTime * 1000, setTime * 1000 );
+
+    delete big;
+    delete other;
+    delete mask;
+    delete compact;
+    delete compactDest;
+
+
+    if( numBad == 0 ) {
+        printf( "All tests passed\n" );
+        return 0;
+        }
+    printf( "%d failures\n", numBad );
+    return 1;
+    }
@@ -3,6 +3,9 @@
  *
  * 2001-January-17		Jason Rohrer
  * Created. 
+ *
+ * 2026-October-15   Jason Rohrer
+ * Added getLightingBatch.
  */
  
  
@@ -40,6 +43,11 @@ class AmbientLightingGL : public LightingGL{
 		// implements LightingGL interface
 		void getLighting( Vector3D *inPoint, Vector3D *inNormal,
 			Color *outColor );
+		
+		void getLightingBatch( float *inX, float *inY, float *inZ,
+			float *inNormalX, float *inNormalY, float *inNormalZ,
+			int inNumPoints,
+			float *outR, float *outG, float *outB );
 	
 	private:
 		Color *mColor;
@@ -70,5 +78,23 @@ inline void AmbientLightingGL::getLighting( Vector3D *inPoint,
 	}
 
 
+
+inline void AmbientLightingGL::getLightingBatch( 
+	float *inX, float *inY, float *inZ,
+	float *inNormalX, float *inNormalY, float *inNormalZ,
+	int inNumPoints,
+	float *outR, float *outG, float *outB ) {
+	
+	float r = mColor->r;
+	float g = mColor->g;
+	float b = mColor->b;
 	
+	for( int i=0; i<inNumPoints; i++ ) {
+		outR[i] = r;
+		outG[i] = g;
+		outB[i] = b;
+		}
+	}
+
+
 #endif
@@ -0,0 +1,891 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+
+
+#include "CompressedTexture.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+
+
+CompressedTexture::CompressedTexture()
+        : mFormat( COMPRESSED_TEXTURE_DXT5 ), mFlags( 0 ),
+          mWidth( 0 ), mHeight( 0 ) {
+    }
+
+
+
+// averages 2x2 pixel squares, weighting color by alpha, so that the
+// color of transparent pixels doesn't bleed into the visible ones
+// result destroyed by caller
+static unsigned char *halveImage( unsigned char *inRGBA,
+                                  unsigned int inWidth, unsigned int inHeight,
+                                  unsigned int *outWidth,
+                                  unsigned int *outHeight ) {
+    unsigned int w = inWidth / 2;
+    unsigned int h = inHeight / 2;
+
+    if( w == 0 ) {
+        w = 1;
+        }
+    if( h == 0 ) {
+        h = 1;
+        }
+
+    unsigned char *result = new unsigned char[ w * h * 4 ];
+
+    for( unsigned int y=0; y<h; y++ ) {
+        for( unsigned int x=0; x<w; x++ ) {
+
+            unsigned int sum[4] = { 0, 0, 0, 0 };
+            unsigned int plainSum[3] = { 0, 0, 0 };
+
+            for( int dy=0; dy<2; dy++ ) {
+                unsigned int sy = y * 2 + dy;
+                if( sy >= inHeight ) {
+                    sy = inHeight - 1;
+                    }
+
+                for( int dx=0; dx<2; dx++ ) {
+                    unsigned int sx = x * 2 + dx;
+                    if( sx >= inWidth ) {
+                        sx = inWidth - 1;
+                        }
+
+                    unsigned char *p = &( inRGBA[ ( sy * inWidth + sx ) * 4 ] );
+
+                    for( int c=0; c<3; c++ ) {
+                        sum[c] += p[c] * p[3];
+                        plainSum[c] += p[c];
+                        }
+                    sum[3] += p[3];
+                    }
+                }
+
+            unsigned char *d = &( result[ ( y * w + x ) * 4 ] );
+
+            for( int c=0; c<3; c++ ) {
+                if( sum[3] > 0 ) {
+                    d[c] = (unsigned char)( ( sum[c] + sum[3] / 2 ) / sum[3] );
+                    }
+                else {
+                    d[c] = (unsigned char)( ( plainSum[c] + 2 ) / 4 );
+                    }
+                }
+            d[3] = (unsigned char)( ( sum[3] + 2 ) / 4 );
+            }
+        }
+
+    *outWidth = w;
+    *outHeight = h;
+
+    return result;
+    }
+
+
+
+CompressedTexture::CompressedTexture( unsigned char *inRGBA,
+                                      unsigned int inWidth,
+                                      unsigned int inHeight,
+                                      int inFormat, char inMipMaps,
+                                      int inFlags )
+        : mFormat( inFormat ), mFlags( inFlags ),
+          mWidth( inWidth ), mHeight( inHeight ) {
+
+    if( mFormat != COMPRESSED_TEXTURE_DXT1 ) {
+        mFormat = COMPRESSED_TEXTURE_DXT5;
+        }
+
+    unsigned char *level = inRGBA;
+    unsigned int w = inWidth;
+    unsigned int h = inHeight;
+
+    while( true ) {
+        mLevels.push_back( encodeLevel( level, w, h ) );
+        mLevelLengths.push_back( getLevelLength( w, h ) );
+
+        if( ! inMipMaps || ( w == 1 && h == 1 ) ) {
+            break;
+            }
+
+        unsigned char *next = halveImage( level, w, h, &w, &h );
+
+        if( level != inRGBA ) {
+            delete [] level;
+            }
+        level = next;
+        }
+
+    if( level != inRGBA ) {
+        delete [] level;
+        }
+    }
+
+
+
+CompressedTexture::~CompressedTexture() {
+    for( int i=0; i<mLevels.size(); i++ ) {
+        delete [] mLevels.getElementDirect( i );
+        }
+    }
+
+
+
+int CompressedTexture::chooseFormat( unsigned char *inRGBA,
+                                     unsigned int inWidth,
+                                     unsigned int inHeight ) {
+    unsigned int numPixels = inWidth * inHeight;
+
+    for( unsigned int i=0; i<numPixels; i++ ) {
+        if( inRGBA[ i * 4 + 3 ] != 255 ) {
+            return COMPRESSED_TEXTURE_DXT5;
+            }
+        }
+    return COMPRESSED_TEXTURE_DXT1;
+    }
+
+
+
+unsigned int CompressedTexture::getLevelWidth( int inLevel ) {
+    unsigned int w = mWidth >> inLevel;
+    if( w == 0 ) {
+        w = 1;
+        }
+    return w;
+    }
+
+
+
+unsigned int CompressedTexture::getLevelHeight( int inLevel ) {
+    unsigned int h = mHeight >> inLevel;
+    if( h == 0 ) {
+        h = 1;
+        }
+    return h;
+    }
+
+
+
+int CompressedTexture::getLevelLength( unsigned int inWidth,
+                                       unsigned int inHeight ) {
+    return ( ( inWidth + 3 ) / 4 ) * ( ( inHeight + 3 ) / 4 ) *
+        getBlockBytes();
+    }
+
+
+
+unsigned char *CompressedTexture::getLevelBytes( int inLevel,
+                                                 int *outLength ) {
+    *outLength = mLevelLengths.getElementDirect( inLevel );
+    return mLevels.getElementDirect( inLevel );
+    }
+
+
+
+int CompressedTexture::getTotalBytes() {
+    int total = 0;
+    for( int i=0; i<mLevelLengths.size(); i++ ) {
+        total += mLevelLengths.getElementDirect( i );
+        }
+    return total;
+    }
+
+
+
+
+// 565 color expanded to 8 bits per channel, the way GPUs do it
+static void unpack565( unsigned int inColor, int outRGB[3] ) {
+    int r = ( inColor >> 11 ) & 0x1F;
+    int g = ( inColor >> 5 ) & 0x3F;
+    int b = inColor & 0x1F;
+
+    outRGB[0] = ( r << 3 ) | ( r >> 2 );
+    outRGB[1] = ( g << 2 ) | ( g >> 4 );
+    outRGB[2] = ( b << 3 ) | ( b >> 2 );
+    }
+
+
+
+static unsigned int pack565( const float inRGB[3] ) {
+    int r = (int)( inRGB[0] * 31 / 255.0f + 0.5f );
+    int g = (int)( inRGB[1] * 63 / 255.0f + 0.5f );
+    int b = (int)( inRGB[2] * 31 / 255.0f + 0.5f );
+
+    if( r < 0 ) r = 0;
+    if( r > 31 ) r = 31;
+    if( g < 0 ) g = 0;
+    if( g > 63 ) g = 63;
+    if( b < 0 ) b = 0;
+    if( b > 31 ) b = 31;
+
+    return (unsigned int)( ( r << 11 ) | ( g << 5 ) | b );
+    }
+
+
+
+// palette for a color block, as decoders see it
+// returns number of colors (4, or 3 plus transparent black)
+static int getColorPalette( unsigned int inC0, unsigned int inC1,
+                            char inAllowThreeColor,
+                            int outPalette[4][4] ) {
+    unpack565( inC0, outPalette[0] );
+    unpack565( inC1, outPalette[1] );
+    outPalette[0][3] = 255;
+    outPalette[1][3] = 255;
+
+    if( inC0 > inC1 || ! inAllowThreeColor ) {
+        for( int c=0; c<3; c++ ) {
+            outPalette[2][c] =
+                ( 2 * outPalette[0][c] + outPalette[1][c] ) / 3;
+            outPalette[3][c] =
+                ( outPalette[0][c] + 2 * outPalette[1][c] ) / 3;
+            }
+        outPalette[2][3] = 255;
+        outPalette[3][3] = 255;
+        return 4;
+        }
+
+    for( int c=0; c<3; c++ ) {
+        outPalette[2][c] = ( outPalette[0][c] + outPalette[1][c] ) / 2;
+        outPalette[3][c] = 0;
+        }
+    outPalette[2][3] = 255;
+    outPalette[3][3] = 0;
+    return 3;
+    }
+
+
+
+// picks nearest palette entries for opaque pixels
+// returns total squared error
+static int pickColorIndices( int inPixels[16][4], char inTransparent[16],
+                             int inPalette[4][4], int inNumColors,
+                             int outIndices[16] ) {
+    int totalError = 0;
+
+    for( int i=0; i<16; i++ ) {
+        if( inTransparent[i] ) {
+            outIndices[i] = 3;
+            continue;
+            }
+
+        int best = 0;
+        int bestError = -1;
+
+        for( int p=0; p<inNumColors; p++ ) {
+            int error = 0;
+            for( int c=0; c<3; c++ ) {
+                int d = inPixels[i][c] - inPalette[p][c];
+                error += d * d;
+                }
+            if( bestError == -1 || error < bestError ) {
+                bestError = error;
+                best = p;
+                }
+            }
+        outIndices[i] = best;
+        totalError += bestError;
+        }
+
+    return totalError;
+    }
+
+
+
+// encodes endpoints and indices into 8 bytes
+// inIndices are for an ordered palette (0 = c0, 1 = c1)
+static void writeColorBlock( unsigned int inC0, unsigned int inC1,
+                             int inIndices[16], unsigned char *outBytes ) {
+    outBytes[0] = (unsigned char)( inC0 & 0xFF );
+    outBytes[1] = (unsigned char)( inC0 >> 8 );
+    outBytes[2] = (unsigned char)( inC1 & 0xFF );
+    outBytes[3] = (unsigned char)( inC1 >> 8 );
+
+    for( int row=0; row<4; row++ ) {
+        unsigned char b = 0;
+        for( int col=0; col<4; col++ ) {
+            b |= (unsigned char)( inIndices[ row * 4 + col ] << ( col * 2 ) );
+            }
+        outBytes[ 4 + row ] = b;
+        }
+    }
+
+
+
+// least-squares endpoints for fixed 4-color indices
+// returns false if indices don't constrain the endpoints
+static char fitEndpoints( int inPixels[16][4], char inTransparent[16],
+                          int inIndices[16],
+                          float outC0[3], float outC1[3] ) {
+    // weight of c0 for each index
+    static const float weights[4] = { 1.0f, 0.0f, 2.0f / 3, 1.0f / 3 };
+
+    float aa = 0, ab = 0, bb = 0;
+    float ax[3] = { 0, 0, 0 };
+    float bx[3] = { 0, 0, 0 };
+
+    for( int i=0; i<16; i++ ) {
+        if( inTransparent[i] ) {
+            continue;
+            }
+        float a = weights[ inIndices[i] ];
+        float b = 1 - a;
+
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+
+        for( int c=0; c<3; c++ ) {
+            ax[c] += a * inPixels[i][c];
+            bx[c] += b * inPixels[i][c];
+            }
+        }
+
+    float det = aa * bb - ab * ab;
+
+    if( fabs( det ) < 1e-6 ) {
+        return false;
+        }
+
+    for( int c=0; c<3; c++ ) {
+        outC0[c] = ( ax[c] * bb - bx[c] * ab ) / det;
+        outC1[c] = ( bx[c] * aa - ax[c] * ab ) / det;
+        }
+    return true;
+    }
+
+
+
+// inAllowThreeColor for DXT1, where blocks with transparent pixels
+// must use the 3-color mode
+static void encodeColorBlock( int inPixels[16][4], char inTransparent[16],
+                              char inAllowThreeColor,
+                              unsigned char *outBytes ) {
+
+    int numOpaque = 0;
+    float mean[3] = { 0, 0, 0 };
+
+    for( int i=0; i<16; i++ ) {
+        if( ! inTransparent[i] ) {
+            for( int c=0; c<3; c++ ) {
+                mean[c] += inPixels[i][c];
+                }
+            numOpaque++;
+            }
+        }
+
+    char needThreeColor = inAllowThreeColor && numOpaque < 16;
+
+    int indices[16];
+
+    if( numOpaque == 0 ) {
+        // all transparent:  3-color mode with equal endpoints
+        for( int i=0; i<16; i++ ) {
+            indices[i] = 3;
+            }
+        writeColorBlock( 0, 0, indices, outBytes );
+        return;
+        }
+
+    for( int c=0; c<3; c++ ) {
+        mean[c] /= numOpaque;
+        }
+
+    // principal axis of colors, by power iteration on covariance
+    float cov[6] = { 0, 0, 0, 0, 0, 0 };
+
+    for( int i=0; i<16; i++ ) {
+        if( inTransparent[i] ) {
+            continue;
+            }
+        float r = inPixels[i][0] - mean[0];
+        float g = inPixels[i][1] - mean[1];
+        float b = inPixels[i][2] - mean[2];
+
+        cov[0] += r * r;
+        cov[1] += r * g;
+        cov[2] += r * b;
+        cov[3] += g * g;
+        cov[4] += g * b;
+        cov[5] += b * b;
+        }
+
+    float axis[3] = { 1, 1, 1 };
+
+    for( int iter=0; iter<8; iter++ ) {
+        float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+        float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+        float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+
+        float length = sqrtf( x * x + y * y + z * z );
+
+        if( length < 1e-6f ) {
+            break;
+            }
+        axis[0] = x / length;
+        axis[1] = y / length;
+        axis[2] = z / length;
+        }
+
+    float minDot = 0, maxDot = 0;
+    char first = true;
+
+    for( int i=0; i<16; i++ ) {
+        if( inTransparent[i] ) {
+            continue;
+            }
+        float dot = 0;
+        for( int c=0; c<3; c++ ) {
+            dot += ( inPixels[i][c] - mean[c] ) * axis[c];
+            }
+        if( first || dot < minDot ) {
+            minDot = dot;
+            }
+        if( first || dot > maxDot ) {
+            maxDot = dot;
+            }
+        first = false;
+        }
+
+    // pull endpoints in a bit, since extremes are rarely hit exactly
+    float inset = ( maxDot - minDot ) / 16;
+    minDot += inset;
+    maxDot -= inset;
+
+    float end0[3], end1[3];
+    for( int c=0; c<3; c++ ) {
+        end0[c] = mean[c] + axis[c] * maxDot;
+        end1[c] = mean[c] + axis[c] * minDot;
+        }
+
+
+    unsigned int bestC0 = 0, bestC1 = 0;
+    int bestIndices[16];
+    int bestError = -1;
+
+    // first try, then a least-squares refinement of it
+    for( int pass=0; pass<2; pass++ ) {
+        unsigned int c0 = pack565( end0 );
+        unsigned int c1 = pack565( end1 );
+
+        if( needThreeColor ) {
+            // c0 <= c1 selects 3-color mode
+            if( c0 > c1 ) {
+                unsigned int temp = c0;
+                c0 = c1;
+                c1 = temp;
+                }
+            }
+        else {
+            if( c0 < c1 ) {
+                unsigned int temp = c0;
+                c0 = c1;
+                c1 = temp;
+                }
+            }
+
+        int palette[4][4];
+        int numColors;
+
+        if( c0 == c1 && ! needThreeColor ) {
+            // would be read as 3-color mode, but index 0 is right for
+            // every pixel anyway
+            numColors = 1;
+            getColorPalette( c0, c1, false, palette );
+            }
+        else {
+            numColors = getColorPalette( c0, c1, inAllowThreeColor,
+                                         palette );
+            }
+
+        int error = pickColorIndices( inPixels, inTransparent,
+                                      palette, numColors, indices );
+
+        if( bestError == -1 || error < bestError ) {
+            bestError = error;
+            bestC0 = c0;
+            bestC1 = c1;
+            memcpy( bestIndices, indices, sizeof( indices ) );
+            }
+
+        if( pass == 0 ) {
+            if( numColors != 4 ||
+                ! fitEndpoints( inPixels, inTransparent, indices,
+                                end0, end1 ) ) {
+                break;
+                }
+            }
+        }
+
+    writeColorBlock( bestC0, bestC1, bestIndices, outBytes );
+    }
+
+
+
+// alpha palette, as decoders see it
+static void getAlphaPalette( int inA0, int inA1, int outPalette[8] ) {
+    outPalette[0] = inA0;
+    outPalette[1] = inA1;
+
+    if( inA0 > inA1 ) {
+        for( int i=1; i<7; i++ ) {
+            outPalette[ i + 1 ] = ( ( 7 - i ) * inA0 + i * inA1 ) / 7;
+            }
+        }
+    else {
+        for( int i=1; i<5; i++ ) {
+            outPalette[ i + 1 ] = ( ( 5 - i ) * inA0 + i * inA1 ) / 5;
+            }
+        outPalette[6] = 0;
+        outPalette[7] = 255;
+        }
+    }
+
+
+
+// returns squared error
+static int encodeAlphaBlockWith( int inPixels[16][4], int inA0, int inA1,
+                                 unsigned char *outBytes ) {
+    int palette[8];
+    getAlphaPalette( inA0, inA1, palette );
+
+    outBytes[0] = (unsigned char)inA0;
+    outBytes[1] = (unsigned char)inA1;
+
+    int totalError = 0;
+
+    // 48 bits of 3-bit indices
+    unsigned long long bits = 0;
+
+    for( int i=0; i<16; i++ ) {
+        int best = 0;
+        int bestError = -1;
+
+        for( int p=0; p<8; p++ ) {
+            int d = inPixels[i][3] - palette[p];
+            int error = d * d;
+
+            if( bestError == -1 || error < bestError ) {
+                bestError = error;
+                best = p;
+                }
+            }
+
+        bits |= (unsigned long long)best << ( i * 3 );
+        totalError += bestError;
+        }
+
+    for( int b=0; b<6; b++ ) {
+        outBytes[ 2 + b ] = (unsigned char)( ( bits >> ( b * 8 ) ) & 0xFF );
+        }
+
+    return totalError;
+    }
+
+
+
+static void encodeAlphaBlock( int inPixels[16][4],
+                              unsigned char *outBytes ) {
+    int minA = 255, maxA = 0;
+
+    // range of values other than 0 and 255, for 6-value mode, which
+    // has 0 and 255 for free
+    int minInner = 255, maxInner = 0;
+
+    for( int i=0; i<16; i++ ) {
+        int a = inPixels[i][3];
+
+        if( a < minA ) minA = a;
+        if( a > maxA ) maxA = a;
+
+        if( a != 0 && a != 255 ) {
+            if( a < minInner ) minInner = a;
+            if( a > maxInner ) maxInner = a;
+            }
+        }
+
+    if( minA == maxA ) {
+        encodeAlphaBlockWith( inPixels, maxA, minA, outBytes );
+        return;
+        }
+
+    // 8-value mode
+    int error = encodeAlphaBlockWith( inPixels, maxA, minA, outBytes );
+
+    if( error > 0 ) {
+        if( minInner > maxInner ) {
+            // only 0 and 255 present
+            minInner = maxInner = 128;
+            }
+
+        unsigned char other[8];
+
+        int otherError =
+            encodeAlphaBlockWith( inPixels, minInner, maxInner, other );
+
+        if( otherError < error ) {
+            memcpy( outBytes, other, 8 );
+            }
+        }
+    }
+
+
+
+unsigned char *CompressedTexture::encodeLevel( unsigned char *inRGBA,
+                                               unsigned int inWidth,
+                                               unsigned int inHeight ) {
+
+    unsigned int blocksWide = ( inWidth + 3 ) / 4;
+    unsigned int blocksHigh = ( inHeight + 3 ) / 4;
+
+    int blockBytes = getBlockBytes();
+
+    unsigned char *result =
+        new unsigned char[ blocksWide * blocksHigh * blockBytes ];
+
+    unsigned char *nextBlock = result;
+
+    for( unsigned int by=0; by<blocksHigh; by++ ) {
+        for( unsigned int bx=0; bx<blocksWide; bx++ ) {
+
+            int pixels[16][4];
+            char transparent[16];
+
+            for( int i=0; i<16; i++ ) {
+                // repeat edge pixels into blocks that hang off the edge
+                unsigned int x = bx * 4 + i % 4;
+                unsigned int y = by * 4 + i / 4;
+
+                if( x >= inWidth ) {
+                    x = inWidth - 1;
+                    }
+                if( y >= inHeight ) {
+                    y = inHeight - 1;
+                    }
+
+                unsigned char *p = &( inRGBA[ ( y * inWidth + x ) * 4 ] );
+
+                for( int c=0; c<4; c++ ) {
+                    pixels[i][c] = p[c];
+                    }
+
+                transparent[i] =
+                    ( mFormat == COMPRESSED_TEXTURE_DXT1 && p[3] < 128 );
+                }
+
+            if( mFormat == COMPRESSED_TEXTURE_DXT1 ) {
+                encodeColorBlock( pixels, transparent, true, nextBlock );
+                }
+            else {
+                encodeAlphaBlock( pixels, nextBlock );
+                encodeColorBlock( pixels, transparent, false,
+                                  &( nextBlock[8] ) );
+                }
+
+            nextBlock += blockBytes;
+            }
+        }
+
+    return result;
+    }
+
+
+
+unsigned char *CompressedTexture::decodeLevel( int inLevel ) {
+    unsigned int w = getLevelWidth( inLevel );
+    unsigned int h = getLevelHeight( inLevel );
+
+    unsigned char *blocks = mLevels.getElementDirect( inLevel );
+
+    unsigned char *result = new unsigned char[ w * h * 4 ];
+
+    unsigned int blocksWide = ( w + 3 ) / 4;
+    unsigned int blocksHigh = ( h + 3 ) / 4;
+
+    int blockBytes = getBlockBytes();
+
+    for( unsigned int by=0; by<blocksHigh; by++ ) {
+        for( unsigned int bx=0; bx<blocksWide; bx++ ) {
+
+            unsigned char *block =
+                &( blocks[ ( by * blocksWide + bx ) * blockBytes ] );
+
+            int alphas[8];
+            unsigned long long alphaBits = 0;
+
+            unsigned char *colorBlock = block;
+
+            if( mFormat == COMPRESSED_TEXTURE_DXT5 ) {
+                getAlphaPalette( block[0], block[1], alphas );
+
+                for( int b=0; b<6; b++ ) {
+                    alphaBits |=
+                        (unsigned long long)block[ 2 + b ] << ( b * 8 );
+                    }
+                colorBlock = &( block[8] );
+                }
+
+            unsigned int c0 = colorBlock[0] | ( colorBlock[1] << 8 );
+            unsigned int c1 = colorBlock[2] | ( colorBlock[3] << 8 );
+
+            int palette[4][4];
+            getColorPalette( c0, c1,
+                             ( mFormat == COMPRESSED_TEXTURE_DXT1 ),
+                             palette );
+
+            for( int i=0; i<16; i++ ) {
+                unsigned int x = bx * 4 + i % 4;
+                unsigned int y = by * 4 + i / 4;
+
+                if( x >= w || y >= h ) {
+                    continue;
+                    }
+
+                int index =
+                    ( colorBlock[ 4 + i / 4 ] >> ( ( i % 4 ) * 2 ) ) & 0x3;
+
+                unsigned char *p = &( result[ ( y * w + x ) * 4 ] );
+
+                for( int c=0; c<4; c++ ) {
+                    p[c] = (unsigned char)palette[ index ][c];
+                    }
+
+                if( mFormat == COMPRESSED_TEXTURE_DXT5 ) {
+                    p[3] = (unsigned char)
+                        alphas[ ( alphaBits >> ( i * 3 ) ) & 0x7 ];
+                    }
+                }
+            }
+        }
+
+    return result;
+    }
+
+
+
+
+static void appendUInt32( SimpleVector<unsigned char> *ioBuffer,
+                          unsigned int inValue ) {
+    for( int b=0; b<4; b++ ) {
+        ioBuffer->push_back( (unsigned char)( ( inValue >> ( b * 8 ) )
+                                              & 0xFF ) );
+        }
+    }
+
+
+
+static unsigned int readUInt32( unsigned char *inBytes ) {
+    return
+        (unsigned int)inBytes[0] |
+        ( (unsigned int)inBytes[1] << 8 ) |
+        ( (unsigned int)inBytes[2] << 16 ) |
+        ( (unsigned int)inBytes[3] << 24 );
+    }
+
+
+
+unsigned char *CompressedTexture::writeToBytes( int *outLength ) {
+    SimpleVector<unsigned char> bytes;
+
+    int magicLength = strlen( COMPRESSED_TEXTURE_FILE_MAGIC );
+
+    bytes.appendArray( (unsigned char*)COMPRESSED_TEXTURE_FILE_MAGIC,
+                       magicLength );
+
+    bytes.push_back( (unsigned char)mFormat );
+    bytes.push_back( (unsigned char)mFlags );
+
+    appendUInt32( &bytes, mWidth );
+    appendUInt32( &bytes, mHeight );
+    appendUInt32( &bytes, mLevels.size() );
+
+    for( int i=0; i<mLevels.size(); i++ ) {
+        int length = mLevelLengths.getElementDirect( i );
+
+        appendUInt32( &bytes, length );
+        bytes.appendArray( mLevels.getElementDirect( i ), length );
+        }
+
+    *outLength = bytes.size();
+    return bytes.getElementArray();
+    }
+
+
+
+CompressedTexture *CompressedTexture::readFromBytes( unsigned char *inBytes,
+                                                     int inLength ) {
+    int magicLength = strlen( COMPRESSED_TEXTURE_FILE_MAGIC );
+
+    int headerLength = magicLength + 2 + 12;
+
+    if( inLength < headerLength ||
+        memcmp( inBytes, COMPRESSED_TEXTURE_FILE_MAGIC, magicLength ) != 0 ) {
+        printf( "Compressed texture has a bad header\n" );
+        return NULL;
+        }
+
+    unsigned char *next = &( inBytes[ magicLength ] );
+
+    CompressedTexture *t = new CompressedTexture();
+
+    t->mFormat = next[0];
+    t->mFlags = next[1];
+    next += 2;
+
+    t->mWidth = readUInt32( next );
+    t->mHeight = readUInt32( next + 4 );
+    unsigned int numLevels = readUInt32( next + 8 );
+    next += 12;
+
+    int remaining = inLength - headerLength;
+
+    if( ( t->mFormat != COMPRESSED_TEXTURE_DXT1 &&
+          t->mFormat != COMPRESSED_TEXTURE_DXT5 ) ||
+        t->mWidth == 0 || t->mHeight == 0 ||
+        t->mWidth > 65536 || t->mHeight > 65536 ||
+        numLevels == 0 || numLevels > 32 ) {
+        printf( "Compressed texture has an unsupported format or size\n" );
+        delete t;
+        return NULL;
+        }
+
+    for( unsigned int i=0; i<numLevels; i++ ) {
+        if( remaining < 4 ) {
+            printf( "Compressed texture is truncated\n" );
+            delete t;
+            return NULL;
+            }
+
+        int length = (int)readUInt32( next );
+        next += 4;
+        remaining -= 4;
+
+        int expectedLength = t->getLevelLength( t->getLevelWidth( i ),
+                                                t->getLevelHeight( i ) );
+
+        if( length != expectedLength || length > remaining ) {
+            printf( "Compressed texture level %d has the wrong length\n",
+                    i );
+            delete t;
+            return NULL;
+            }
+
+        unsigned char *level = new unsigned char[ length ];
+        memcpy( level, next, length );
+
+        t->mLevels.push_back( level );
+        t->mLevelLengths.push_back( length );
+
+        next += length;
+        remaining -= length;
+        }
+
+    return t;
+    }
@@ -0,0 +1,181 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+
+
+#ifndef COMPRESSED_TEXTURE_INCLUDED
+#define COMPRESSED_TEXTURE_INCLUDED
+
+
+#include "minorGems/util/SimpleVector.h"
+
+
+
+// block-compressed formats, as stored in files
+// 4x4 pixel blocks, 8 bytes each, RGB with 1-bit alpha
+#define COMPRESSED_TEXTURE_DXT1 1
+// 4x4 pixel blocks, 16 bytes each, RGB with interpolated 8-bit alpha
+#define COMPRESSED_TEXTURE_DXT5 5
+
+
+// flags stored in files
+// file was made from an image that had its lower-left corner color
+// turned transparent (see SpriteGL)
+#define COMPRESSED_TEXTURE_FLAG_TRANSPARENT_CORNER 1
+
+
+#define COMPRESSED_TEXTURE_FILE_MAGIC "ctex1\n"
+
+
+
+/**
+ * A texture in a GPU block-compressed format (DXT1 or DXT5, also known
+ * as BC1 and BC3), with all of its mipmap levels, ready to upload with
+ * glCompressedTexImage2D.
+ *
+ * Textures are compressed offline (see texturePacker), because good
+ * compression is too slow to do while loading.  Levels can also be
+ * decoded back to RGBA, for GL implementations that can't take them.
+ *
+ * Doesn't touch GL.
+ *
+ * File layout:
+ *   COMPRESSED_TEXTURE_FILE_MAGIC
+ *   1 byte format
+ *   1 byte flags
+ *   4 bytes width, little-endian
+ *   4 bytes height
+ *   4 bytes number of levels
+ *   levels, largest first, each:
+ *     4 bytes length
+ *     block bytes
+ *
+ * @author Jason Rohrer
+ */
+class CompressedTexture {
+
+    public:
+
+        /**
+         * Compresses an image.
+         *
+         * @param inRGBA the image pixels.  Destroyed by caller.
+         * @param inWidth, inHeight the image size.  Any size works, but
+         *   textures should still be powers of 2 for older GL
+         *   implementations.
+         * @param inFormat COMPRESSED_TEXTURE_DXT1 or _DXT5.
+         *   DXT1 throws away the color of transparent pixels, so it's only
+         *   suitable for opaque images.  See chooseFormat.
+         * @param inMipMaps true to also make every smaller level, down
+         *   to 1x1.
+         * @param inFlags stored with texture.
+         */
+        CompressedTexture( unsigned char *inRGBA,
+                           unsigned int inWidth, unsigned int inHeight,
+                           int inFormat, char inMipMaps,
+                           int inFlags = 0 );
+
+        ~CompressedTexture();
+
+
+        // DXT1 for fully opaque images, DXT5 for everything else
+        static int chooseFormat( unsigned char *inRGBA,
+                                 unsigned int inWidth,
+                                 unsigned int inHeight );
+
+
+        /**
+         * Reads a texture from the contents of a file.
+         *
+         * @param inBytes the file contents.  Destroyed by caller.
+         * @param inLength the number of bytes.
+         *
+         * @return the texture, or NULL if the bytes are damaged.
+         *   Destroyed by caller.
+         */
+        static CompressedTexture *readFromBytes( unsigned char *inBytes,
+                                                 int inLength );
+
+
+        // result destroyed by caller
+        unsigned char *writeToBytes( int *outLength );
+
+
+        int getFormat() {
+            return mFormat;
+            }
+
+        int getFlags() {
+            return mFlags;
+            }
+
+        unsigned int getWidth() {
+            return mWidth;
+            }
+
+        unsigned int getHeight() {
+            return mHeight;
+            }
+
+        int getNumLevels() {
+            return mLevels.size();
+            }
+
+
+        // size of a level, which halves for each level, down to 1
+        unsigned int getLevelWidth( int inLevel );
+        unsigned int getLevelHeight( int inLevel );
+
+
+        // bytes returned are owned by this class
+        unsigned char *getLevelBytes( int inLevel, int *outLength );
+
+
+        // total bytes in all levels, which is what the texture takes up
+        // on the GPU
+        int getTotalBytes();
+
+
+        // result destroyed by caller
+        unsigned char *decodeLevel( int inLevel );
+
+
+    protected:
+
+        // for readFromBytes
+        CompressedTexture();
+
+
+        int mFormat;
+        int mFlags;
+
+        unsigned int mWidth;
+        unsigned int mHeight;
+
+        SimpleVector<unsigned char *> mLevels;
+        SimpleVector<int> mLevelLengths;
+
+
+        int getBlockBytes() {
+            if( mFormat == COMPRESSED_TEXTURE_DXT1 ) {
+                return 8;
+                }
+            return 16;
+            }
+
+        int getLevelLength( unsigned int inWidth, unsigned int inHeight );
+
+
+        // compresses one level into a new array
+        unsigned char *encodeLevel( unsigned char *inRGBA,
+                                    unsigned int inWidth,
+                                    unsigned int inHeight );
+    };
+
+
+
+#endif
@@ -3,6 +3,9 @@
  *
  * 2000-December-20		Jason Rohrer
  * Created. 
+ *
+ * 2026-October-15   Jason Rohrer
+ * Added a vectorized getLightingBatch.
  */
  
  
@@ -12,6 +15,8 @@
 #include <stdio.h>
  
 #include "LightingGL.h"
+
+#include "minorGems/math/geometry/Vector3DBatch.h"
  
 /**
  * A LightingGL implementation with a single point light source
@@ -41,6 +46,11 @@ class DirectionLightingGL : public LightingGL {
 		// implements LightingGL interface
 		void getLighting( Vector3D *inPoint, Vector3D *inNormal,
 			Color *outColor );
+		
+		void getLightingBatch( float *inX, float *inY, float *inZ,
+			float *inNormalX, float *inNormalY, float *inNormalZ,
+			int inNumPoints,
+			float *outR, float *outG, float *outB );
 	
 	
 	private:
@@ -89,4 +99,61 @@ inline void DirectionLightingGL::getLighting( Vector3D *inPoint,
 
 
 	
+inline void DirectionLightingGL::getLightingBatch( 
+	float *inX, float *inY, float *inZ,
+	float *inNormalX, float *inNormalY, float *inNormalZ,
+	int inNumPoints,
+	float *outR, float *outG, float *outB ) {
+	
+	// dot products go in outR first, then get scaled into each channel
+	dotBatch( inNormalX, inNormalY, inNormalZ,
+			  (float)( mDirection->mX ), (float)( mDirection->mY ), 
+			  (float)( mDirection->mZ ),
+			  inNumPoints, outR );
+	
+	float r = mColor->r;
+	float g = mColor->g;
+	float b = mColor->b;
+	
+	int i = 0;
+	
+#if defined( VECTOR_3D_BATCH_SSE2 )
+	__m128 zero = _mm_setzero_ps();
+	__m128 r4 = _mm_set1_ps( r );
+	__m128 g4 = _mm_set1_ps( g );
+	__m128 b4 = _mm_set1_ps( b );
+	
+	for( ; i + 4 <= inNumPoints; i += 4 ) {
+		__m128 dot = _mm_max_ps( _mm_loadu_ps( outR + i ), zero );
+		
+		_mm_storeu_ps( outR + i, _mm_mul_ps( r4, dot ) );
+		_mm_storeu_ps( outG + i, _mm_mul_ps( g4, dot ) );
+		_mm_storeu_ps( outB + i, _mm_mul_ps( b4, dot ) );
+		}
+#elif defined( VECTOR_3D_BATCH_NEON )
+	float32x4_t zero = vdupq_n_f32( 0 );
+	
+	for( ; i + 4 <= inNumPoints; i += 4 ) {
+		float32x4_t dot = vmaxq_f32( vld1q_f32( outR + i ), zero );
+		
+		vst1q_f32( outR + i, vmulq_n_f32( dot, r ) );
+		vst1q_f32( outG + i, vmulq_n_f32( dot, g ) );
+		vst1q_f32( outB + i, vmulq_n_f32( dot, b ) );
+		}
+#endif
+	
+	// scalar tail (or all points if no vector unit)
+	for( ; i<inNumPoints; i++ ) {
+		float dot = outR[i];
+		if( dot < 0 ) {
+			dot = 0;
+			}
+		outR[i] = r * dot;
+		outG[i] = g * dot;
+		outB[i] = b * dot;
+		}
+	}
+
+
+
 #endif
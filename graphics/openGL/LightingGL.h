@@ -3,6 +3,10 @@
  *
  * 2000-December-20		Jason Rohrer
  * Created. 
+ *
+ * 2026-October-15   Jason Rohrer
+ * Added getLightingBatch for lighting many points at once, and a
+ * lighting version so that lit colors can be cached.
  */
  
  
@@ -21,6 +25,11 @@ class LightingGL {
 	
 	public:
 		
+		LightingGL();
+
+		virtual ~LightingGL();
+		
+		
 		/**
 		 * Gets the lighting color for a particular point on a surface
 		 * with a particular orientation.
@@ -33,7 +42,110 @@ class LightingGL {
 		 */
 		virtual void getLighting( Vector3D *inPoint, Vector3D *inNormal,
 			Color *outColor ) = 0;
+
 		
+		/**
+		 * Gets the lighting color for many points at once, with points,
+		 * normals, and colors each stored as separate component arrays.
+		 *
+		 * The default implementation calls getLighting for each point.
+		 * Subclasses can do better.
+		 *
+		 * @param inX, inY, inZ the surface points.
+		 * @param inNormalX, inNormalY, inNormalZ normals at the points.
+		 *   Must be normalized.
+		 * @param inNumPoints the number of points.
+		 * @param outR, outG, outB preallocated arrays where the
+		 *   lighting colors will be returned.
+		 */
+		virtual void getLightingBatch( float *inX, float *inY, float *inZ,
+			float *inNormalX, float *inNormalY, float *inNormalZ,
+			int inNumPoints,
+			float *outR, float *outG, float *outB );
+
+		
+		/**
+		 * Gets a version number for this lighting's results.
+		 *
+		 * Versions are unique across all lightings, so colors computed
+		 * with a lighting can be kept as long as the same version is
+		 * returned (and the points and normals are unchanged).
+		 *
+		 * @return the version number.
+		 */
+		virtual unsigned long getLightingVersion();
+
+		
+	protected:
+		
+		// subclasses call this when their results change
+		void lightingChanged();
+		
+		
+	private:
+		
+		unsigned long mLightingVersion;
+		
+		static unsigned long nextLightingVersion();
 	};
+
+
+
+inline LightingGL::LightingGL()
+	: mLightingVersion( nextLightingVersion() ) {
+	
+	}
+
+
+
+inline LightingGL::~LightingGL() {
+	}
+
+
+
+inline void LightingGL::getLightingBatch( float *inX, float *inY, float *inZ,
+	float *inNormalX, float *inNormalY, float *inNormalZ,
+	int inNumPoints,
+	float *outR, float *outG, float *outB ) {
+	
+	Vector3D point( 0, 0, 0 );
+	Vector3D normal( 0, 0, 0 );
+	Color color( 0, 0, 0 );
+	
+	for( int i=0; i<inNumPoints; i++ ) {
+		point.setCoordinates( inX[i], inY[i], inZ[i] );
+		normal.setCoordinates( inNormalX[i], inNormalY[i], inNormalZ[i] );
+		
+		getLighting( &point, &normal, &color );
+		
+		outR[i] = color.r;
+		outG[i] = color.g;
+		outB[i] = color.b;
+		}
+	}
+
+
+
+inline unsigned long LightingGL::getLightingVersion() {
+	return mLightingVersion;
+	}
+
+
+
+inline void LightingGL::lightingChanged() {
+	mLightingVersion = nextLightingVersion();
+	}
+
+
+
+inline unsigned long LightingGL::nextLightingVersion() {
+	// 0 is never used, so it can mean "no version"
+	static unsigned long lastVersion = 0;
+	
+	lastVersion++;
+	return lastVersion;
+	}
+
+
 	
 #endif
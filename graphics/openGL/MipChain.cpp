@@ -0,0 +1,346 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+
+
+#include "MipChain.h"
+
+#include <math.h>
+#include <string.h>
+
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || \
+    ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+    #define MIP_CHAIN_SSE2
+    #include <emmintrin.h>
+#elif defined( __aarch64__ )
+    #define MIP_CHAIN_NEON
+    #include <arm_neon.h>
+#endif
+
+
+
+MipChain::MipChain( unsigned char *inRGBA,
+                    unsigned int inWidth, unsigned int inHeight,
+                    char inGammaCorrect ) {
+
+    unsigned char *level = inRGBA;
+    unsigned int w = inWidth;
+    unsigned int h = inHeight;
+
+    while( w > 1 || h > 1 ) {
+        level = halve( level, w, h, &w, &h, inGammaCorrect );
+
+        mLevels.push_back( level );
+        mWidths.push_back( w );
+        mHeights.push_back( h );
+        }
+    }
+
+
+
+MipChain::~MipChain() {
+    for( int i=0; i<mLevels.size(); i++ ) {
+        delete [] mLevels.getElementDirect( i );
+        }
+    }
+
+
+
+unsigned char *MipChain::getLevel( int inLevel,
+                                   unsigned int *outWidth,
+                                   unsigned int *outHeight ) {
+    *outWidth = mWidths.getElementDirect( inLevel - 1 );
+    *outHeight = mHeights.getElementDirect( inLevel - 1 );
+
+    return mLevels.getElementDirect( inLevel - 1 );
+    }
+
+
+
+static void getHalfSize( unsigned int inWidth, unsigned int inHeight,
+                         unsigned int *outWidth, unsigned int *outHeight ) {
+    *outWidth = inWidth / 2;
+    *outHeight = inHeight / 2;
+
+    if( *outWidth == 0 ) {
+        *outWidth = 1;
+        }
+    if( *outHeight == 0 ) {
+        *outHeight = 1;
+        }
+    }
+
+
+
+// source pixel for a destination pixel, clamped for 1-wide or 1-high
+// sources
+static inline unsigned int clampSource( unsigned int inS,
+                                        unsigned int inSize ) {
+    if( inS >= inSize ) {
+        return inSize - 1;
+        }
+    return inS;
+    }
+
+
+
+// scalar box filter of destination pixels from inStartX to end of row y
+static void halveRowScalar( unsigned char *inRGBA,
+                            unsigned int inWidth, unsigned int inHeight,
+                            unsigned char *outRGBA, unsigned int inOutWidth,
+                            unsigned int inY, unsigned int inStartX ) {
+
+    unsigned int sy0 = clampSource( inY * 2, inHeight );
+    unsigned int sy1 = clampSource( inY * 2 + 1, inHeight );
+
+    unsigned char *row0 = &( inRGBA[ sy0 * inWidth * 4 ] );
+    unsigned char *row1 = &( inRGBA[ sy1 * inWidth * 4 ] );
+
+    for( unsigned int x=inStartX; x<inOutWidth; x++ ) {
+        unsigned int sx0 = clampSource( x * 2, inWidth ) * 4;
+        unsigned int sx1 = clampSource( x * 2 + 1, inWidth ) * 4;
+
+        unsigned char *d = &( outRGBA[ ( inY * inOutWidth + x ) * 4 ] );
+
+        for( int c=0; c<4; c++ ) {
+            d[c] = (unsigned char)( ( row0[ sx0 + c ] + row0[ sx1 + c ] +
+                                      row1[ sx0 + c ] + row1[ sx1 + c ] +
+                                      2 ) >> 2 );
+            }
+        }
+    }
+
+
+
+unsigned char *MipChain::halveScalar( unsigned char *inRGBA,
+                                      unsigned int inWidth,
+                                      unsigned int inHeight,
+                                      unsigned int *outWidth,
+                                      unsigned int *outHeight ) {
+    getHalfSize( inWidth, inHeight, outWidth, outHeight );
+
+    unsigned char *result = new unsigned char[ *outWidth * *outHeight * 4 ];
+
+    for( unsigned int y=0; y<*outHeight; y++ ) {
+        halveRowScalar( inRGBA, inWidth, inHeight, result, *outWidth, y, 0 );
+        }
+
+    return result;
+    }
+
+
+
+// sRGB to 16-bit linear, and back, built once on first use
+typedef struct MipGammaTables {
+        unsigned short toLinear[ 256 ];
+        unsigned char fromLinear[ 65536 ];
+    } MipGammaTables;
+
+
+static double srgbToLinear( double inV ) {
+    if( inV <= 0.04045 ) {
+        return inV / 12.92;
+        }
+    return pow( ( inV + 0.055 ) / 1.055, 2.4 );
+    }
+
+
+static double linearToSRGB( double inV ) {
+    if( inV <= 0.0031308 ) {
+        return inV * 12.92;
+        }
+    return 1.055 * pow( inV, 1 / 2.4 ) - 0.055;
+    }
+
+
+static MipGammaTables *makeGammaTables() {
+    MipGammaTables *t = new MipGammaTables;
+
+    for( int i=0; i<256; i++ ) {
+        t->toLinear[i] =
+            (unsigned short)( srgbToLinear( i / 255.0 ) * 65535 + 0.5 );
+        }
+    for( int i=0; i<65536; i++ ) {
+        t->fromLinear[i] =
+            (unsigned char)( linearToSRGB( i / 65535.0 ) * 255 + 0.5 );
+        }
+    return t;
+    }
+
+
+static MipGammaTables *getGammaTables() {
+    // initialization of function statics is thread-safe, and decoder
+    // threads may get here at the same time
+    static MipGammaTables *tables = makeGammaTables();
+
+    return tables;
+    }
+
+
+
+static unsigned char *halveGammaCorrect( unsigned char *inRGBA,
+                                         unsigned int inWidth,
+                                         unsigned int inHeight,
+                                         unsigned int *outWidth,
+                                         unsigned int *outHeight ) {
+    MipGammaTables *t = getGammaTables();
+
+    getHalfSize( inWidth, inHeight, outWidth, outHeight );
+
+    unsigned int w = *outWidth;
+    unsigned int h = *outHeight;
+
+    unsigned char *result = new unsigned char[ w * h * 4 ];
+
+    for( unsigned int y=0; y<h; y++ ) {
+        unsigned char *row0 =
+            &( inRGBA[ clampSource( y * 2, inHeight ) * inWidth * 4 ] );
+        unsigned char *row1 =
+            &( inRGBA[ clampSource( y * 2 + 1, inHeight ) * inWidth * 4 ] );
+
+        for( unsigned int x=0; x<w; x++ ) {
+            unsigned int sx0 = clampSource( x * 2, inWidth ) * 4;
+            unsigned int sx1 = clampSource( x * 2 + 1, inWidth ) * 4;
+
+            unsigned char *d = &( result[ ( y * w + x ) * 4 ] );
+
+            for( int c=0; c<3; c++ ) {
+                unsigned int sum =
+                    t->toLinear[ row0[ sx0 + c ] ] +
+                    t->toLinear[ row0[ sx1 + c ] ] +
+                    t->toLinear[ row1[ sx0 + c ] ] +
+                    t->toLinear[ row1[ sx1 + c ] ];
+
+                d[c] = t->fromLinear[ ( sum + 2 ) >> 2 ];
+                }
+
+            d[3] = (unsigned char)( ( row0[ sx0 + 3 ] + row0[ sx1 + 3 ] +
+                                      row1[ sx0 + 3 ] + row1[ sx1 + 3 ] +
+                                      2 ) >> 2 );
+            }
+        }
+
+    return result;
+    }
+
+
+
+unsigned char *MipChain::halve( unsigned char *inRGBA,
+                                unsigned int inWidth,
+                                unsigned int inHeight,
+                                unsigned int *outWidth,
+                                unsigned int *outHeight,
+                                char inGammaCorrect ) {
+    if( inGammaCorrect ) {
+        return halveGammaCorrect( inRGBA, inWidth, inHeight,
+                                  outWidth, outHeight );
+        }
+
+    #if !defined( MIP_CHAIN_SSE2 ) && !defined( MIP_CHAIN_NEON )
+
+    return halveScalar( inRGBA, inWidth, inHeight, outWidth, outHeight );
+
+    #else
+
+    if( inWidth < 2 || inHeight < 2 ) {
+        // clamped sampling, and tiny anyway
+        return halveScalar( inRGBA, inWidth, inHeight,
+                            outWidth, outHeight );
+        }
+
+    getHalfSize( inWidth, inHeight, outWidth, outHeight );
+
+    unsigned int w = *outWidth;
+    unsigned int h = *outHeight;
+
+    unsigned char *result = new unsigned char[ w * h * 4 ];
+
+    for( unsigned int y=0; y<h; y++ ) {
+        const unsigned char *row0 = &( inRGBA[ y * 2 * inWidth * 4 ] );
+        const unsigned char *row1 = row0 + inWidth * 4;
+
+        unsigned char *dest = &( result[ y * w * 4 ] );
+
+        unsigned int x = 0;
+
+        // 4 destination pixels from 8x2 source pixels at a time
+        #ifdef MIP_CHAIN_SSE2
+
+        __m128i zero = _mm_setzero_si128();
+        __m128i two = _mm_set1_epi16( 2 );
+
+        for( ; x + 4 <= w; x += 4 ) {
+            const unsigned char *a = row0 + x * 8;
+            const unsigned char *b = row1 + x * 8;
+
+            __m128i a0 = _mm_loadu_si128( (const __m128i *)a );
+            __m128i a1 = _mm_loadu_si128( (const __m128i *)( a + 16 ) );
+            __m128i b0 = _mm_loadu_si128( (const __m128i *)b );
+            __m128i b1 = _mm_loadu_si128( (const __m128i *)( b + 16 ) );
+
+            // column sums, two source pixels per register, 16 bits
+            // per channel
+            __m128i s0 = _mm_add_epi16( _mm_unpacklo_epi8( a0, zero ),
+                                        _mm_unpacklo_epi8( b0, zero ) );
+            __m128i s1 = _mm_add_epi16( _mm_unpackhi_epi8( a0, zero ),
+                                        _mm_unpackhi_epi8( b0, zero ) );
+            __m128i s2 = _mm_add_epi16( _mm_unpacklo_epi8( a1, zero ),
+                                        _mm_unpacklo_epi8( b1, zero ) );
+            __m128i s3 = _mm_add_epi16( _mm_unpackhi_epi8( a1, zero ),
+                                        _mm_unpackhi_epi8( b1, zero ) );
+
+            // add neighboring columns (64-bit halves)
+            __m128i q0 = _mm_add_epi16( _mm_unpacklo_epi64( s0, s1 ),
+                                        _mm_unpackhi_epi64( s0, s1 ) );
+            __m128i q1 = _mm_add_epi16( _mm_unpacklo_epi64( s2, s3 ),
+                                        _mm_unpackhi_epi64( s2, s3 ) );
+
+            q0 = _mm_srli_epi16( _mm_add_epi16( q0, two ), 2 );
+            q1 = _mm_srli_epi16( _mm_add_epi16( q1, two ), 2 );
+
+            _mm_storeu_si128( (__m128i *)( dest + x * 4 ),
+                              _mm_packus_epi16( q0, q1 ) );
+            }
+
+        #else
+
+        for( ; x + 4 <= w; x += 4 ) {
+            // even and odd source pixels split apart
+            uint32x4x2_t a = vld2q_u32( (const uint32_t *)( row0 + x * 8 ) );
+            uint32x4x2_t b = vld2q_u32( (const uint32_t *)( row1 + x * 8 ) );
+
+            uint8x16_t ae = vreinterpretq_u8_u32( a.val[0] );
+            uint8x16_t ao = vreinterpretq_u8_u32( a.val[1] );
+            uint8x16_t be = vreinterpretq_u8_u32( b.val[0] );
+            uint8x16_t bo = vreinterpretq_u8_u32( b.val[1] );
+
+            uint16x8_t lo =
+                vaddq_u16( vaddl_u8( vget_low_u8( ae ), vget_low_u8( ao ) ),
+                           vaddl_u8( vget_low_u8( be ), vget_low_u8( bo ) ) );
+            uint16x8_t hi =
+                vaddq_u16( vaddl_u8( vget_high_u8( ae ),
+                                     vget_high_u8( ao ) ),
+                           vaddl_u8( vget_high_u8( be ),
+                                     vget_high_u8( bo ) ) );
+
+            // rounding shift, ( sum + 2 ) >> 2
+            vst1q_u8( dest + x * 4,
+                      vcombine_u8( vrshrn_n_u16( lo, 2 ),
+                                   vrshrn_n_u16( hi, 2 ) ) );
+            }
+
+        #endif
+
+        // rest of row
+        halveRowScalar( inRGBA, inWidth, inHeight, result, w, y, x );
+        }
+
+    return result;
+
+    #endif
+    }
@@ -0,0 +1,106 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+
+
+#ifndef MIP_CHAIN_INCLUDED
+#define MIP_CHAIN_INCLUDED
+
+
+#include "minorGems/util/SimpleVector.h"
+
+
+
+/**
+ * The smaller mipmap levels of an RGBA image, built on the CPU.
+ *
+ * Doesn't touch GL, so it can be built on a worker thread and handed to
+ * SingleTextureGL for upload, instead of having the driver build the
+ * levels inside glTexImage2D on the main thread (which GL_GENERATE_MIPMAP
+ * and gluBuild2DMipmaps do on many drivers).
+ *
+ * Each level is a 2x2 box filter of the one above, with sizes halving
+ * (rounding down) to 1x1.  An odd last row or column is dropped, as
+ * most drivers do.
+ *
+ * The box filter uses SSE2 or NEON where available.  The gamma-correct
+ * option averages colors in linear light instead (so that fine light and
+ * dark detail doesn't darken as it shrinks), through lookup tables, with
+ * no SIMD.
+ *
+ * @author Jason Rohrer
+ */
+class MipChain {
+
+    public:
+
+        /**
+         * Builds levels 1 and smaller.
+         *
+         * @param inRGBA level 0.  Destroyed by caller.  Edges should
+         *   already be expanded if the texture's will be (see
+         *   SingleTextureGL::expandEdges).
+         * @param inWidth, inHeight level 0 size.
+         * @param inGammaCorrect true to average sRGB colors in linear
+         *   light.  Alpha is always averaged as is.
+         */
+        MipChain( unsigned char *inRGBA,
+                  unsigned int inWidth, unsigned int inHeight,
+                  char inGammaCorrect = false );
+
+        ~MipChain();
+
+
+        // not counting level 0
+        int getNumLevels() {
+            return mLevels.size();
+            }
+
+
+        /**
+         * @param inLevel from 1 to getNumLevels().
+         *
+         * @return the level's bytes.  Destroyed by this class.
+         */
+        unsigned char *getLevel( int inLevel,
+                                 unsigned int *outWidth,
+                                 unsigned int *outHeight );
+
+
+        /**
+         * Box filters one level down.
+         *
+         * @return the smaller image.  Destroyed by caller.
+         */
+        static unsigned char *halve( unsigned char *inRGBA,
+                                     unsigned int inWidth,
+                                     unsigned int inHeight,
+                                     unsigned int *outWidth,
+                                     unsigned int *outHeight,
+                                     char inGammaCorrect = false );
+
+
+        // plain C box filter, same result as halve, for checking and
+        // timing the SIMD version
+        static unsigned char *halveScalar( unsigned char *inRGBA,
+                                           unsigned int inWidth,
+                                           unsigned int inHeight,
+                                           unsigned int *outWidth,
+                                           unsigned int *outHeight );
+
+
+    protected:
+
+        SimpleVector<unsigned char *> mLevels;
+        SimpleVector<unsigned int> mWidths;
+        SimpleVector<unsigned int> mHeights;
+
+    };
+
+
+
+#endif
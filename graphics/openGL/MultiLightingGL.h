@@ -3,6 +3,11 @@
  *
  * 2000-December-20		Jason Rohrer
  * Created. 
+ *
+ * 2026-October-15   Jason Rohrer
+ * Added getLightingBatch, which sums whole batches from each lighting.
+ * No longer allocates a Color per lighting per point.  Lighting version
+ * follows the contained lightings.
  */
  
  
@@ -13,6 +18,7 @@
  
 #include "LightingGL.h"
 #include "minorGems/util/SimpleVector.h"
+#include "minorGems/math/geometry/Vector3DBatch.h"
  
 /**
  * A LightingGL implementation that contains a collection of
@@ -53,18 +59,36 @@ class MultiLightingGL : public LightingGL {
 		// implements LightingGL interface
 		void getLighting( Vector3D *inPoint, Vector3D *inNormal,
 			Color *outColor );
+		
+		void getLightingBatch( float *inX, float *inY, float *inZ,
+			float *inNormalX, float *inNormalY, float *inNormalZ,
+			int inNumPoints,
+			float *outR, float *outG, float *outB );
+		
+		// changes when lightings are added or removed, or when any
+		// contained lighting's version changes
+		unsigned long getLightingVersion();
 	
 	
 	private:
 	
 		SimpleVector<LightingGL*> *mLightingVector;
 		
+		// contained versions as of last getLightingVersion call,
+		// parallel to mLightingVector
+		SimpleVector<unsigned long> mContainedVersions;
+		
+		// space for one lighting's batch colors, kept between calls
+		float *mScratch;
+		int mScratchSize;
+		
 	};
 
 
 
 inline MultiLightingGL::MultiLightingGL() 
-	: mLightingVector( new SimpleVector<LightingGL*>() ) {
+	: mLightingVector( new SimpleVector<LightingGL*>() ),
+	  mScratch( NULL ), mScratchSize( 0 ) {
 
 	}
 
@@ -72,18 +96,32 @@ inline MultiLightingGL::MultiLightingGL()
 
 inline MultiLightingGL::~MultiLightingGL() {
 	delete mLightingVector;
+	
+	if( mScratch != NULL ) {
+		delete [] mScratch;
+		}
 	}
 
 
 
 inline void MultiLightingGL::addLighting( LightingGL *inLighting ) {
 	mLightingVector->push_back( inLighting );
+	mContainedVersions.push_back( inLighting->getLightingVersion() );
+	
+	lightingChanged();
 	}
 		
 		
 
 inline void MultiLightingGL::removeLighting( LightingGL *inLighting ) {
-	mLightingVector->deleteElement( inLighting );
+	int index = mLightingVector->getElementIndex( inLighting );
+	
+	if( index != -1 ) {
+		mLightingVector->deleteElement( index );
+		mContainedVersions.deleteElement( index );
+		
+		lightingChanged();
+		}
 	}
 
 
@@ -97,19 +135,17 @@ inline void MultiLightingGL::getLighting( Vector3D *inPoint,
 	outColor->g = 0;
 	outColor->b = 0;
 	
+	Color tempColor( 0, 0, 0 );
+	
 	// sum lighting contributions from each lighting
 	for( int i=0; i<numLightings; i++ ) {
-		Color *tempColor = new Color( 0, 0, 0 );	
-		
 		LightingGL *thisLighting = *( mLightingVector->getElement( i ) );
 		
-		thisLighting->getLighting( inPoint, inNormal, tempColor );
+		thisLighting->getLighting( inPoint, inNormal, &tempColor );
 		
-		outColor->r += tempColor->r;
-		outColor->g += tempColor->g;
-		outColor->b += tempColor->b;
-		
-		delete tempColor;
+		outColor->r += tempColor.r;
+		outColor->g += tempColor.g;
+		outColor->b += tempColor.b;
 		}
 	
 	
@@ -127,5 +163,125 @@ inline void MultiLightingGL::getLighting( Vector3D *inPoint,
 	}
 
 
+
+inline void MultiLightingGL::getLightingBatch( 
+	float *inX, float *inY, float *inZ,
+	float *inNormalX, float *inNormalY, float *inNormalZ,
+	int inNumPoints,
+	float *outR, float *outG, float *outB ) {
+	
+	int i;
+	for( i=0; i<inNumPoints; i++ ) {
+		outR[i] = 0;
+		outG[i] = 0;
+		outB[i] = 0;
+		}
+	
+	if( mScratchSize < inNumPoints ) {
+		if( mScratch != NULL ) {
+			delete [] mScratch;
+			}
+		mScratch = new float[ 3 * inNumPoints ];
+		mScratchSize = inNumPoints;
+		}
+	
+	float *r = mScratch;
+	float *g = &( mScratch[ inNumPoints ] );
+	float *b = &( mScratch[ 2 * inNumPoints ] );
 	
+	// one whole batch per lighting, instead of looping over lightings
+	// for each point
+	int numLightings = mLightingVector->size();
+	
+	for( int l=0; l<numLightings; l++ ) {
+		LightingGL *thisLighting = *( mLightingVector->getElement( l ) );
+		
+		thisLighting->getLightingBatch( inX, inY, inZ,
+			inNormalX, inNormalY, inNormalZ,
+			inNumPoints, r, g, b );
+		
+		i = 0;
+		
+#if defined( VECTOR_3D_BATCH_SSE2 )
+		for( ; i + 4 <= inNumPoints; i += 4 ) {
+			_mm_storeu_ps( outR + i, _mm_add_ps( _mm_loadu_ps( outR + i ),
+												 _mm_loadu_ps( r + i ) ) );
+			_mm_storeu_ps( outG + i, _mm_add_ps( _mm_loadu_ps( outG + i ),
+												 _mm_loadu_ps( g + i ) ) );
+			_mm_storeu_ps( outB + i, _mm_add_ps( _mm_loadu_ps( outB + i ),
+												 _mm_loadu_ps( b + i ) ) );
+			}
+#elif defined( VECTOR_3D_BATCH_NEON )
+		for( ; i + 4 <= inNumPoints; i += 4 ) {
+			vst1q_f32( outR + i, vaddq_f32( vld1q_f32( outR + i ),
+											vld1q_f32( r + i ) ) );
+			vst1q_f32( outG + i, vaddq_f32( vld1q_f32( outG + i ),
+											vld1q_f32( g + i ) ) );
+			vst1q_f32( outB + i, vaddq_f32( vld1q_f32( outB + i ),
+											vld1q_f32( b + i ) ) );
+			}
+#endif
+		
+		for( ; i<inNumPoints; i++ ) {
+			outR[i] += r[i];
+			outG[i] += g[i];
+			outB[i] += b[i];
+			}
+		}
+	
+	// clip color components
+	i = 0;
+	
+#if defined( VECTOR_3D_BATCH_SSE2 )
+	__m128 one = _mm_set1_ps( 1.0f );
+	
+	for( ; i + 4 <= inNumPoints; i += 4 ) {
+		_mm_storeu_ps( outR + i, _mm_min_ps( _mm_loadu_ps( outR + i ), one ) );
+		_mm_storeu_ps( outG + i, _mm_min_ps( _mm_loadu_ps( outG + i ), one ) );
+		_mm_storeu_ps( outB + i, _mm_min_ps( _mm_loadu_ps( outB + i ), one ) );
+		}
+#elif defined( VECTOR_3D_BATCH_NEON )
+	float32x4_t one = vdupq_n_f32( 1.0f );
+	
+	for( ; i + 4 <= inNumPoints; i += 4 ) {
+		vst1q_f32( outR + i, vminq_f32( vld1q_f32( outR + i ), one ) );
+		vst1q_f32( outG + i, vminq_f32( vld1q_f32( outG + i ), one ) );
+		vst1q_f32( outB + i, vminq_f32( vld1q_f32( outB + i ), one ) );
+		}
+#endif
+	
+	for( ; i<inNumPoints; i++ ) {
+		if( outR[i] > 1 ) {
+			outR[i] = 1;
+			}
+		if( outG[i] > 1 ) {
+			outG[i] = 1;
+			}
+		if( outB[i] > 1 ) {
+			outB[i] = 1;
+			}
+		}
+	}
+
+
+
+inline unsigned long MultiLightingGL::getLightingVersion() {
+	int numLightings = mLightingVector->size();
+	
+	for( int i=0; i<numLightings; i++ ) {
+		unsigned long version = 
+			( *( mLightingVector->getElement( i ) ) )->getLightingVersion();
+		
+		if( version != *( mContainedVersions.getElement( i ) ) ) {
+			*( mContainedVersions.getElement( i ) ) = version;
+			
+			lightingChanged();
+			}
+		}
+	
+	return LightingGL::getLightingVersion();
+	}
+
+
+
 #endif
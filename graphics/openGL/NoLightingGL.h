@@ -3,6 +3,9 @@
  *
  * 2000-December-20		Jason Rohrer
  * Created. 
+ *
+ * 2026-October-15   Jason Rohrer
+ * Added getLightingBatch.
  */
  
  
@@ -24,6 +27,11 @@ class NoLightingGL : public LightingGL{
 		void getLighting( Vector3D *inPoint, Vector3D *inNormal,
 			Color *outColor );
 		
+		void getLightingBatch( float *inX, float *inY, float *inZ,
+			float *inNormalX, float *inNormalY, float *inNormalZ,
+			int inNumPoints,
+			float *outR, float *outG, float *outB );
+		
 	};
 
 
@@ -37,5 +45,19 @@ inline void NoLightingGL::getLighting( Vector3D *inPoint,
 	}
 
 
+
+inline void NoLightingGL::getLightingBatch( 
+	float *inX, float *inY, float *inZ,
+	float *inNormalX, float *inNormalY, float *inNormalZ,
+	int inNumPoints,
+	float *outR, float *outG, float *outB ) {
 	
+	for( int i=0; i<inNumPoints; i++ ) {
+		outR[i] = 1;
+		outG[i] = 1;
+		outB[i] = 1;
+		}
+	}
+
+
 #endif
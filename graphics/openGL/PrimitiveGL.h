@@ -43,6 +43,18 @@
  *
  * 2001-September-15   Jason Rohrer
  * Fixed a memory leak in texture creation. 
+ *
+ * 2026-October-15   Jason Rohrer
+ * Vertices and normals are transformed as float arrays with
+ * Transform3D::applyBatch, instead of one allocated Vector3D at a time.
+ * Added a vertex buffer path that keeps positions, anchors, and strip
+ * indices on the card, re-uploading them only when the primitive's
+ * geometry version changes.
+ * Lighting computed for all vertices at once with getLightingBatch, and
+ * lit colors kept in the vertex buffer path until the lighting, transform,
+ * or geometry changes.
+ * Vertex buffers are filled straight from a primitive's packed data
+ * when it has some (as primitives loaded from a MeshCache do).
  */
  
  
@@ -51,11 +63,13 @@
 
 #include <GL/gl.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "TextureGL.h"
 #include "LightingGL.h"
 
 #include "minorGems/math/geometry/Transform3D.h" 
+#include "minorGems/math/geometry/Vector3DBatch.h" 
 
 #include "minorGems/graphics/RGBAImage.h"
 #include "minorGems/graphics/3d/Primitive3D.h"
@@ -68,7 +82,154 @@
 #include <GL/glext.h>
 #endif
 
+// vertex buffers are called directly, so they are only used where
+// the GL library exports them (not through opengl32 on Windows)
+#ifndef WIN_32
+#include <GL/glext.h>
+#ifdef GL_ARB_vertex_buffer_object
+#define PRIMITIVE_GL_VERTEX_BUFFERS
+
+// glext.h only declares these with GL_GLEXT_PROTOTYPES, which may
+// not have been defined where it was first included
+extern "C" {
+GLAPI void APIENTRY glBindBufferARB( GLenum, GLuint );
+GLAPI void APIENTRY glDeleteBuffersARB( GLsizei, const GLuint * );
+GLAPI void APIENTRY glGenBuffersARB( GLsizei, GLuint * );
+GLAPI void APIENTRY glBufferDataARB( GLenum, GLsizeiptrARB, 
+									 const void *, GLenum );
+GLAPI void APIENTRY glBufferSubDataARB( GLenum, GLintptrARB, 
+										GLsizeiptrARB, const void * );
+}
+
+#endif
+#endif
+
  
+/**
+ * A primitive's vertices and normals transformed into world space,
+ * for one draw.
+ *
+ * @author Jason Rohrer 
+ */
+class PrimitiveGLWorldSpace {
+	
+	public:
+		
+		PrimitiveGLWorldSpace( Primitive3D *inPrimitive, 
+			Transform3D *inTransform );
+		
+		~PrimitiveGLWorldSpace();
+		
+		
+		// computes lighting for every vertex
+		void light( LightingGL *inLighting );
+		
+		
+		// passes a vertex's lit color to glColor (after light)
+		void color( int inIndex );
+		
+		// packs lit colors as clamped RGBA bytes (after light)
+		void colorsToBytes( unsigned char *outRGBA );
+		
+		
+		// passes a vertex to glVertex
+		void vertex( int inIndex );
+		
+		
+	protected:
+		
+		int mNumVertices;
+		
+		// one block, split into x, y and z of vertices, then of normals,
+		// then r, g and b of lit colors
+		float *mCoordinates;
+		
+		float *mX, *mY, *mZ;
+		float *mNormalX, *mNormalY, *mNormalZ;
+		float *mR, *mG, *mB;
+	};
+
+
+
+inline PrimitiveGLWorldSpace::PrimitiveGLWorldSpace( 
+	Primitive3D *inPrimitive, Transform3D *inTransform ) {
+	
+	int numVertices = inPrimitive->mNumVertices;
+	mNumVertices = numVertices;
+	
+	mCoordinates = new float[ 9 * numVertices ];
+	mX = mCoordinates;
+	mY = &( mCoordinates[ numVertices ] );
+	mZ = &( mCoordinates[ 2 * numVertices ] );
+	mNormalX = &( mCoordinates[ 3 * numVertices ] );
+	mNormalY = &( mCoordinates[ 4 * numVertices ] );
+	mNormalZ = &( mCoordinates[ 5 * numVertices ] );
+	mR = &( mCoordinates[ 6 * numVertices ] );
+	mG = &( mCoordinates[ 7 * numVertices ] );
+	mB = &( mCoordinates[ 8 * numVertices ] );
+	
+	vector3DToBatch( inPrimitive->mVertices, numVertices, mX, mY, mZ );
+	vector3DToBatch( inPrimitive->mNormals, numVertices, 
+		mNormalX, mNormalY, mNormalZ );
+	
+	// translate/rotate/scale
+	inTransform->applyBatch( mX, mY, mZ, numVertices );
+	
+	// only rotate normals
+	inTransform->applyNoTranslationBatch( mNormalX, mNormalY, mNormalZ, 
+		numVertices );
+	// normalize to get rid of any scaling
+	normalizeBatch( mNormalX, mNormalY, mNormalZ, numVertices );
+	}
+
+
+
+inline PrimitiveGLWorldSpace::~PrimitiveGLWorldSpace() {
+	delete [] mCoordinates;
+	}
+
+
+
+inline void PrimitiveGLWorldSpace::light( LightingGL *inLighting ) {
+	inLighting->getLightingBatch( mX, mY, mZ, 
+		mNormalX, mNormalY, mNormalZ,
+		mNumVertices, mR, mG, mB );
+	}
+
+
+
+inline void PrimitiveGLWorldSpace::color( int inIndex ) {
+	glColor4f( mR[inIndex], mG[inIndex], mB[inIndex], 1.0 );
+	}
+
+
+
+inline void PrimitiveGLWorldSpace::colorsToBytes( unsigned char *outRGBA ) {
+	for( int i=0; i<mNumVertices; i++ ) {
+		float channels[3] = { mR[i], mG[i], mB[i] };
+		
+		for( int c=0; c<3; c++ ) {
+			float value = channels[c];
+			if( value < 0 ) {
+				value = 0;
+				}
+			else if( value > 1 ) {
+				value = 1;
+				}
+			outRGBA[ 4 * i + c ] = (unsigned char)( value * 255 + 0.5f );
+			}
+		outRGBA[ 4 * i + 3 ] = 255;
+		}
+	}
+
+
+
+inline void PrimitiveGLWorldSpace::vertex( int inIndex ) {
+	glVertex3f( mX[inIndex], mY[inIndex], mZ[inIndex] );
+	}
+
+
+
 /**
  * OpenGL primitive object.
  *
@@ -172,6 +333,16 @@ class PrimitiveGL {
 		 */
 		virtual void stopAnimation( int inAnimationIndex );
 
+
+		/**
+		 * Gets whether vertex buffers are supported by the loaded
+		 * GL implementation.  Must be called with an active openGL
+		 * screen.
+		 *
+		 * @return true if vertex buffers are supported.
+		 */
+		static char isVertexBufferSupported();
+
 		
 	protected:
 		
@@ -179,6 +350,39 @@ class PrimitiveGL {
 		
 		TextureGL *mTextureGL;
 		
+		// buffer names, 0 until first drawn with vertex buffers
+		GLuint mVertexBuffer;
+		GLuint mColorBuffer;
+		GLuint mIndexBuffer;
+		
+		int mNumIndices;
+		
+		// number of texture layers in mVertexBuffer
+		int mNumBufferedLayers;
+		
+		// geometry version in mVertexBuffer
+		unsigned long mBufferedGeometryVersion;
+		
+		// lit color of each vertex, re-uploaded when lighting changes
+		unsigned char *mColors;
+		
+		// lighting version and transform matrix that mColors (and
+		// mColorBuffer) were lit with, or version 0 if not lit yet
+		unsigned long mLitLightingVersion;
+		double mLitMatrix[16];
+		
+		
+		// Equivalent to the public draw(), but with positions, anchors,
+		// and indices kept in vertex buffers.  Only lit colors are
+		// sent each draw.
+		void drawVertexBuffer( Transform3D *inTransform, 
+			LightingGL *inLighting );
+		
+		
+		// uploads positions, anchors, and indices if the primitive's
+		// geometry has changed since the last upload
+		void updateVertexBuffer( int inNumLayers );
+		
 		
 		// Equivalent to the public draw(), but does manual multi-texturing
 		// by multi-pass rendering.  Does not depend on ARB calls.
@@ -190,7 +394,12 @@ class PrimitiveGL {
 
 
 inline PrimitiveGL::PrimitiveGL( Primitive3D *inPrimitive ) 
-	: mPrimitive( inPrimitive ) {
+	: mPrimitive( inPrimitive ),
+	  mVertexBuffer( 0 ), mColorBuffer( 0 ), mIndexBuffer( 0 ),
+	  mNumIndices( 0 ), mNumBufferedLayers( 0 ),
+	  mBufferedGeometryVersion( 0 ),
+	  mColors( NULL ),
+	  mLitLightingVersion( 0 ) {
 	
 	
 	int numTextures = mPrimitive->mNumTextures;	
@@ -209,16 +418,152 @@ inline PrimitiveGL::PrimitiveGL( Primitive3D *inPrimitive )
 
 
 inline PrimitiveGL::~PrimitiveGL() {
+	#ifdef PRIMITIVE_GL_VERTEX_BUFFERS
+	if( mVertexBuffer != 0 ) {
+		glDeleteBuffersARB( 1, &mVertexBuffer );
+		glDeleteBuffersARB( 1, &mColorBuffer );
+		glDeleteBuffersARB( 1, &mIndexBuffer );
+		}
+	#endif
+	
+	if( mColors != NULL ) {
+		delete [] mColors;
+		}
+	
 	delete mPrimitive;
 	delete mTextureGL;
 	}
 
 
 
+inline char PrimitiveGL::isVertexBufferSupported() {
+	#ifdef PRIMITIVE_GL_VERTEX_BUFFERS
+		static char checked = false;
+		static char supported = false;
+		
+		if( !checked ) {
+			const char *extensions = (const char *)glGetString( 
+				GL_EXTENSIONS );
+			
+			// NULL if there is no active screen yet, so check again later
+			if( extensions != NULL ) {
+				supported = 
+					( strstr( extensions, "GL_ARB_vertex_buffer_object" )
+					  != NULL );
+				checked = true;
+				}
+			}
+		
+		return supported;
+	#else
+		return false;
+	#endif
+	}
+
+
+
+inline void PrimitiveGL::updateVertexBuffer( int inNumLayers ) {
+	#ifdef PRIMITIVE_GL_VERTEX_BUFFERS
+	
+	int numVertices = mPrimitive->mNumVertices;
+	
+	if( mVertexBuffer == 0 ) {
+		glGenBuffersARB( 1, &mVertexBuffer );
+		glGenBuffersARB( 1, &mColorBuffer );
+		glGenBuffersARB( 1, &mIndexBuffer );
+		}
+	else if( mBufferedGeometryVersion == mPrimitive->getGeometryVersion() 
+			 && mNumBufferedLayers == inNumLayers ) {
+		// up to date
+		return;
+		}
+	
+	// positions, then 2d anchors for each layer
+	int numFloats = numVertices * ( 3 + 2 * inNumLayers );
+	
+	// already in this layout if loaded from a mesh cache
+	const float *packedData = 
+		mPrimitive->getPackedVertexData( inNumLayers );
+	
+	float *data = NULL;
+	
+	if( packedData == NULL ) {
+		data = new float[ numFloats ];
+		
+		int i;
+		for( i=0; i<numVertices; i++ ) {
+			Vector3D *v = mPrimitive->mVertices[i];
+			data[ 3 * i ] = (float)( v->mX );
+			data[ 3 * i + 1 ] = (float)( v->mY );
+			data[ 3 * i + 2 ] = (float)( v->mZ );
+			}
+		for( int t=0; t<inNumLayers; t++ ) {
+			float *anchors = &( data[ numVertices * ( 3 + 2 * t ) ] );
+			
+			for( i=0; i<numVertices; i++ ) {
+				anchors[ 2 * i ] = (float)( mPrimitive->mAnchorX[t][i] );
+				anchors[ 2 * i + 1 ] = 
+					(float)( mPrimitive->mAnchorY[t][i] );
+				}
+			}
+		packedData = data;
+		}
+	
+	glBindBufferARB( GL_ARRAY_BUFFER_ARB, mVertexBuffer );
+	glBufferDataARB( GL_ARRAY_BUFFER_ARB, numFloats * sizeof( float ),
+					 packedData, GL_STATIC_DRAW_ARB );
+	if( data != NULL ) {
+		delete [] data;
+		}
+	
+	// room for colors, filled in each draw
+	glBindBufferARB( GL_ARRAY_BUFFER_ARB, mColorBuffer );
+	glBufferDataARB( GL_ARRAY_BUFFER_ARB, numVertices * 4, NULL, 
+					 GL_STREAM_DRAW_ARB );
+	
+	if( mColors != NULL ) {
+		delete [] mColors;
+		}
+	mColors = new unsigned char[ numVertices * 4 ];
+	
+	// geometry changed, and color buffer is empty
+	mLitLightingVersion = 0;
+	
+	unsigned int *indices = NULL;
+	
+	const unsigned int *packedIndices = 
+		mPrimitive->getPackedTriangleStripIndices( &mNumIndices );
+	
+	if( packedIndices == NULL ) {
+		indices = mPrimitive->getTriangleStripIndices( &mNumIndices );
+		packedIndices = indices;
+		}
+	
+	glBindBufferARB( GL_ELEMENT_ARRAY_BUFFER_ARB, mIndexBuffer );
+	glBufferDataARB( GL_ELEMENT_ARRAY_BUFFER_ARB, 
+					 mNumIndices * sizeof( unsigned int ),
+					 packedIndices, GL_STATIC_DRAW_ARB );
+	if( indices != NULL ) {
+		delete [] indices;
+		}
+	
+	mBufferedGeometryVersion = mPrimitive->getGeometryVersion();
+	mNumBufferedLayers = inNumLayers;
+	
+	#endif
+	}
+
+
+
 // this is the ARB version of draw
 inline void PrimitiveGL::draw( Transform3D *inTransform, 
 	LightingGL *inLighting ) {
 	
+	if( isVertexBufferSupported() ) {
+		drawVertexBuffer( inTransform, inLighting );
+		return;
+		}
+	
 	// check for multi-texture availability before proceeding
 	if( !TextureGL::isMultiTexturingSupported() ) {
 		drawNoMultitexture( inTransform, inLighting );
@@ -226,21 +571,7 @@ inline void PrimitiveGL::draw( Transform3D *inTransform,
 		}
 	
 	// first, copy the vertices and translate/rotate/scale them
-	Vector3D **worldVertices = new Vector3D*[ mPrimitive->mNumVertices ];
-	Vector3D **worldNormals = new Vector3D*[ mPrimitive->mNumVertices ]; 
-	for( int i=0; i<mPrimitive->mNumVertices; i++ ) {
-		// copy
-		worldVertices[i] = new Vector3D( mPrimitive->mVertices[i] );
-		worldNormals[i] = new Vector3D( mPrimitive->mNormals[i] );
-		
-		// translate/rotate/scale
-		inTransform->apply( worldVertices[i] );
-		
-		// only rotate normals
-		inTransform->applyNoTranslation( worldNormals[i] );
-		// normalize to get rid of any scaling
-		worldNormals[i]->normalize();
-		} 
+	PrimitiveGLWorldSpace world( mPrimitive, inTransform );
 	
 	
 	// now draw vertices as triangle strips
@@ -267,7 +598,8 @@ inline void PrimitiveGL::draw( Transform3D *inTransform,
 		}	
 		
 	
-	Color *lightColor = new Color( 0, 0, 0, 1.0 );
+	// all vertices at once, rather than one at a time in the strips
+	world.light( inLighting );
 	
 	// for each strip of triangles
 	for( int y=0; y<mPrimitive->mHigh-1; y++ ) {
@@ -283,9 +615,7 @@ inline void PrimitiveGL::draw( Transform3D *inTransform,
 			// first vert in next row
 			int index = nextRow + 0;
 			
-			inLighting->getLighting( worldVertices[index],
-					worldNormals[index], lightColor );
-			glColor4f( lightColor->r, lightColor->g, lightColor->b, 1.0 );
+			world.color( index );
 			
 			// pass in each layer's anchor points
 			for(  t=0; t<numTextureLayers; t++ ) {
@@ -293,14 +623,11 @@ inline void PrimitiveGL::draw( Transform3D *inTransform,
 					mPrimitive->mAnchorX[t][ index ], 
 					mPrimitive->mAnchorY[t][ index ] );
 				}
-	    	glVertex3d( worldVertices[index]->mX, 
-				worldVertices[index]->mY, worldVertices[index]->mZ );
+	    	world.vertex( index );
 			
 			index = thisRow + 0;
 			
-			inLighting->getLighting( worldVertices[index],
-					worldNormals[index], lightColor );
-			glColor4f( lightColor->r, lightColor->g, lightColor->b, 1.0 );
+			world.color( index );
 			
 			// pass in each layer's anchor points
 			for(  t=0; t<numTextureLayers; t++ ) {
@@ -308,14 +635,11 @@ inline void PrimitiveGL::draw( Transform3D *inTransform,
 					mPrimitive->mAnchorX[t][ index ], 
 					mPrimitive->mAnchorY[t][ index ] );
 				}
-	    	glVertex3d( worldVertices[index]->mX, 
-				worldVertices[index]->mY, worldVertices[index]->mZ );
+	    	world.vertex( index );
 			
 			index = nextRow + 1;
 			
-			inLighting->getLighting( worldVertices[index],
-					worldNormals[index], lightColor );
-			glColor4f( lightColor->r, lightColor->g, lightColor->b, 1.0 );
+			world.color( index );
 			
 			// pass in each layer's anchor points
 			for(  t=0; t<numTextureLayers; t++ ) {
@@ -323,16 +647,13 @@ inline void PrimitiveGL::draw( Transform3D *inTransform,
 					mPrimitive->mAnchorX[t][ index ], 
 					mPrimitive->mAnchorY[t][ index ] );
 				}
-	    	glVertex3d( worldVertices[index]->mX, 
-				worldVertices[index]->mY, worldVertices[index]->mZ );
+	    	world.vertex( index );
 			
 			// draw next vertex to complete first "rectangle"
 			
 			index = thisRow + 1;
 			
-			inLighting->getLighting( worldVertices[index],
-					worldNormals[index], lightColor );
-			glColor4f( lightColor->r, lightColor->g, lightColor->b, 1.0 );
+			world.color( index );
 			
 			// pass in each layer's anchor points
 			for(  t=0; t<numTextureLayers; t++ ) {
@@ -340,8 +661,7 @@ inline void PrimitiveGL::draw( Transform3D *inTransform,
 					mPrimitive->mAnchorX[t][ index ], 
 					mPrimitive->mAnchorY[t][ index ] );
 				}
-	    	glVertex3d( worldVertices[index]->mX, 
-				worldVertices[index]->mY, worldVertices[index]->mZ );
+	    	world.vertex( index );
 			
 			
 			// then add rest of vertices as part of strip
@@ -351,10 +671,7 @@ inline void PrimitiveGL::draw( Transform3D *inTransform,
 				// another "rectangle"
 				index = nextRow + x;
 				
-				inLighting->getLighting( worldVertices[index],
-					worldNormals[index], lightColor );
-				glColor4f( lightColor->r, lightColor->g, 
-					lightColor->b, 1.0 );
+				world.color( index );
 			
 				// pass in each layer's anchor points
 				for(  t=0; t<numTextureLayers; t++ ) {
@@ -362,15 +679,11 @@ inline void PrimitiveGL::draw( Transform3D *inTransform,
 						mPrimitive->mAnchorX[t][ index ], 
 						mPrimitive->mAnchorY[t][ index ] );
 					}
-	    		glVertex3d( worldVertices[index]->mX, 
-					worldVertices[index]->mY, worldVertices[index]->mZ );
+	    		world.vertex( index );
 
 				index = thisRow + x;
 
-				inLighting->getLighting( worldVertices[index],
-					worldNormals[index], lightColor );
-				glColor4f( lightColor->r, lightColor->g, 
-					lightColor->b, 1.0 );
+				world.color( index );
 
 				// pass in each layer's anchor points
 				for(  t=0; t<numTextureLayers; t++ ) {
@@ -378,23 +691,13 @@ inline void PrimitiveGL::draw( Transform3D *inTransform,
 						mPrimitive->mAnchorX[t][ index ], 
 						mPrimitive->mAnchorY[t][ index ] );
 					}
-	    		glVertex3d( worldVertices[index]->mX, 
-					worldVertices[index]->mY, worldVertices[index]->mZ );
+	    		world.vertex( index );
 				}
 		glEnd();		
 		}
 	
 	
 	mTextureGL->disable();
-	
-	// cleanup
-	for( int i=0; i<mPrimitive->mNumVertices; i++ ) {
-		delete worldVertices[i];
-		delete worldNormals[i];
-		}
-	delete [] worldVertices;
-	delete [] worldNormals;
-	delete lightColor;
 	}	
 	
 
@@ -404,23 +707,9 @@ inline void PrimitiveGL::drawNoMultitexture( Transform3D *inTransform,
 	LightingGL *inLighting ) {
 	
 	// first, copy the vertices and translate/rotate/scale them
-	Vector3D **worldVertices = new Vector3D*[ mPrimitive->mNumVertices ];
-	Vector3D **worldNormals = new Vector3D*[ mPrimitive->mNumVertices ]; 
-	for( int i=0; i<mPrimitive->mNumVertices; i++ ) {
-		// copy
-		worldVertices[i] = new Vector3D( mPrimitive->mVertices[i] );
-		worldNormals[i] = new Vector3D( mPrimitive->mNormals[i] );
-		
-		// translate/rotate/scale
-		inTransform->apply( worldVertices[i] );
-		
-		// only rotate normals
-		inTransform->applyNoTranslation( worldNormals[i] );
-		// normalize to get rid of any scaling
-		worldNormals[i]->normalize();
-		} 
-		
-	Color *lightColor = new Color( 0, 0, 0, 1.0 );
+	PrimitiveGLWorldSpace world( mPrimitive, inTransform );
+	
+	world.light( inLighting );
 	
 	// now draw vertices as triangle strips
 		
@@ -458,53 +747,41 @@ inline void PrimitiveGL::drawNoMultitexture( Transform3D *inTransform,
 			// first vert in next row
 			int index = nextRow + 0;
 
-			inLighting->getLighting( worldVertices[index],
-					worldNormals[index], lightColor );
-			glColor4f( lightColor->r, lightColor->g, lightColor->b, 1.0 );
+			world.color( index );
 
 
 			glTexCoord2d( mPrimitive->mAnchorX[0][ index ], 
                 		mPrimitive->mAnchorY[0][ index ] );
-	    	glVertex3d( worldVertices[index]->mX, 
-				worldVertices[index]->mY, worldVertices[index]->mZ );
+	    	world.vertex( index );
 
 			index = thisRow + 0;
 
-			inLighting->getLighting( worldVertices[index],
-					worldNormals[index], lightColor );
-			glColor4f( lightColor->r, lightColor->g, lightColor->b, 1.0 );
+			world.color( index );
 
 
 			glTexCoord2d( mPrimitive->mAnchorX[0][ index ], 
                 		mPrimitive->mAnchorY[0][ index ] );
-	    	glVertex3d( worldVertices[index]->mX, 
-				worldVertices[index]->mY, worldVertices[index]->mZ );
+	    	world.vertex( index );
 
 			index = nextRow + 1;
 
-			inLighting->getLighting( worldVertices[index],
-					worldNormals[index], lightColor );
-			glColor4f( lightColor->r, lightColor->g, lightColor->b, 1.0 );
+			world.color( index );
 
 
 			glTexCoord2d( mPrimitive->mAnchorX[0][ index ], 
                 		mPrimitive->mAnchorY[0][ index ] );	
-	    	glVertex3d( worldVertices[index]->mX, 
-				worldVertices[index]->mY, worldVertices[index]->mZ );
+	    	world.vertex( index );
 
 			// draw next vertex to complete first "rectangle"
 
 			index = thisRow + 1;
 
-			inLighting->getLighting( worldVertices[index],
-					worldNormals[index], lightColor );
-			glColor4f( lightColor->r, lightColor->g, lightColor->b, 1.0 );
+			world.color( index );
 
 
 			glTexCoord2d( mPrimitive->mAnchorX[0][ index ], 
                 		mPrimitive->mAnchorY[0][ index ] );
-	    	glVertex3d( worldVertices[index]->mX, 
-				worldVertices[index]->mY, worldVertices[index]->mZ );
+	    	world.vertex( index );
 
 
 			// then add rest of vertices as part of strip
@@ -514,48 +791,153 @@ inline void PrimitiveGL::drawNoMultitexture( Transform3D *inTransform,
 				// another "rectangle"
 				index = nextRow + x;
 
-				inLighting->getLighting( worldVertices[index],
-					worldNormals[index], lightColor );
-				glColor4f( lightColor->r, lightColor->g, 
-					lightColor->b, 1.0 );
+				world.color( index );
 
 
 				glTexCoord2d( mPrimitive->mAnchorX[0][ index ], 
                 		mPrimitive->mAnchorY[0][ index ] );
-	    		glVertex3d( worldVertices[index]->mX, 
-					worldVertices[index]->mY, worldVertices[index]->mZ );
+	    		world.vertex( index );
 
 				index = thisRow + x;
 
-				inLighting->getLighting( worldVertices[index],
-					worldNormals[index], lightColor );
-				glColor4f( lightColor->r, lightColor->g, 
-					lightColor->b, 1.0 );
+				world.color( index );
 
 
 				glTexCoord2d( mPrimitive->mAnchorX[0][ index ], 
                 		mPrimitive->mAnchorY[0][ index ] );
-	    		glVertex3d( worldVertices[index]->mX, 
-					worldVertices[index]->mY, worldVertices[index]->mZ );
+	    		world.vertex( index );
 				}
 		glEnd();		
 		}
 
 
+	mTextureGL->disable();
+	}
+
+
+
+inline void PrimitiveGL::drawVertexBuffer( Transform3D *inTransform, 
+	LightingGL *inLighting ) {
+	
+	#ifdef PRIMITIVE_GL_VERTEX_BUFFERS
+	
+	int numVertices = mPrimitive->mNumVertices;
+	
+	// without multitexturing, only the first layer is drawn
+	int numTextureLayers = 1;
+	if( TextureGL::isMultiTexturingSupported() ) {
+		numTextureLayers = mTextureGL->getNumLayers();
+		}
+	
+	updateVertexBuffer( numTextureLayers );
+	
+	if( mNumIndices == 0 ) {
+		return;
+		}
+	
+	
+	// lighting is still computed here from world space, so only
+	// the colors cross the bus, and only when they change (static
+	// lighting of a static primitive is computed once)
+	unsigned long lightingVersion = inLighting->getLightingVersion();
+	double *matrix = inTransform->getMatrix();
+	
+	glBindBufferARB( GL_ARRAY_BUFFER_ARB, mColorBuffer );
+	
+	if( lightingVersion != mLitLightingVersion ||
+		memcmp( matrix, mLitMatrix, 16 * sizeof( double ) ) != 0 ) {
+		
+		PrimitiveGLWorldSpace world( mPrimitive, inTransform );
+		
+		world.light( inLighting );
+		world.colorsToBytes( mColors );
+		
+		glBufferSubDataARB( GL_ARRAY_BUFFER_ARB, 0, numVertices * 4, 
+							mColors );
+		
+		mLitLightingVersion = lightingVersion;
+		memcpy( mLitMatrix, matrix, 16 * sizeof( double ) );
+		}
+	
+	glColorPointer( 4, GL_UNSIGNED_BYTE, 0, (GLvoid *)0 );
+	glEnableClientState( GL_COLOR_ARRAY );
+	
+	glBindBufferARB( GL_ARRAY_BUFFER_ARB, mVertexBuffer );
+	glVertexPointer( 3, GL_FLOAT, 0, (GLvoid *)0 );
+	glEnableClientState( GL_VERTEX_ARRAY );
+	
+	int t;
+	for( t=0; t<numTextureLayers; t++ ) {
+		if( TextureGL::isMultiTexturingSupported() ) {
+			glClientActiveTextureARB( TextureGL::sMultiTextureEnum[t] );
+			}
+		
+		size_t offset = numVertices * ( 3 + 2 * t ) * sizeof( float );
+		glTexCoordPointer( 2, GL_FLOAT, 0, (GLvoid *)offset );
+		glEnableClientState( GL_TEXTURE_COORD_ARRAY );
+		}
+	
+	
+	mTextureGL->enable();
+	
+	if( mPrimitive->isTransparent() ) {
+		glEnable( GL_BLEND );
+		glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+		}
+	else {
+		glDisable( GL_BLEND );
+		}
+	
+	if( mPrimitive->isBackVisible() ) {
+		glDisable( GL_CULL_FACE );
+		}
+	else {
+		glEnable( GL_CULL_FACE );
+		glCullFace( GL_BACK );
+		glFrontFace( GL_CCW );
+		}	
+	
+	
+	// positions are transformed by GL, not re-sent.
+	// Transform3D is row-major, GL column-major.
+	GLdouble columnMajor[16];
+	for( int r=0; r<4; r++ ) {
+		for( int c=0; c<4; c++ ) {
+			columnMajor[ c * 4 + r ] = matrix[ r * 4 + c ];
+			}
+		}
+	
+	glMatrixMode( GL_MODELVIEW );
+	glPushMatrix();
+	glMultMatrixd( columnMajor );
+	
+	glBindBufferARB( GL_ELEMENT_ARRAY_BUFFER_ARB, mIndexBuffer );
+	glDrawElements( GL_TRIANGLE_STRIP, mNumIndices, GL_UNSIGNED_INT, 
+					(GLvoid *)0 );
+	
+	glPopMatrix();
+	
 	mTextureGL->disable();
 	
-	// cleanup
-	for( int i=0; i<mPrimitive->mNumVertices; i++ ) {
-		delete worldVertices[i];
-		delete worldNormals[i];
+	
+	// leave client state as we found it, for code using plain arrays
+	for( t=numTextureLayers-1; t>=0; t-- ) {
+		if( TextureGL::isMultiTexturingSupported() ) {
+			glClientActiveTextureARB( TextureGL::sMultiTextureEnum[t] );
+			}
+		glDisableClientState( GL_TEXTURE_COORD_ARRAY );
 		}
-	delete [] worldVertices;
-	delete [] worldNormals;
-	delete lightColor;
+	glDisableClientState( GL_VERTEX_ARRAY );
+	glDisableClientState( GL_COLOR_ARRAY );
+	
+	glBindBufferARB( GL_ARRAY_BUFFER_ARB, 0 );
+	glBindBufferARB( GL_ELEMENT_ARRAY_BUFFER_ARB, 0 );
 	
+	#endif
 	}
 
 
+
 // these all just wrap the functions of the underlying Primitive3D
 
 inline int PrimitiveGL::getNumParameters() {
@@ -16,8 +16,35 @@ static EGLContext context;
 static uint32_t screen_width;
 static uint32_t screen_height;
 
+// size of surface that we render into, which dispmanx scales up to
+// fill the screen
+static uint32_t render_width;
+static uint32_t render_height;
 
-static void raspbianCreateSurface() {
+static char surfaceCreated = false;
+
+
+// vsync intervals per swap, or 0 to swap without waiting
+static int swapInterval = 1;
+
+
+
+// can be called before or after surface is created
+static void raspbianSetSwapInterval( int inInterval ) {
+    swapInterval = inInterval;
+    
+    if( surfaceCreated ) {
+        eglSwapInterval( display, swapInterval );
+        }
+    }
+
+
+
+// renders at inRenderWidth x inRenderHeight, scaled up by the display
+// hardware to fill as much of the screen as it can without changing
+// aspect ratio
+// 0 (or anything bigger than the screen) renders at full screen size
+static void raspbianCreateSurface( int inRenderWidth, int inRenderHeight ) {
 
     int32_t success = 0;
     EGLBoolean result;
@@ -66,15 +93,33 @@ static void raspbianCreateSurface() {
                                          &screen_width, &screen_height );
     assert(  success >= 0 );
 
-    dst_rect.x = 0;
-    dst_rect.y = 0;
+    render_width = screen_width;
+    render_height = screen_height;
+    
+    if( inRenderWidth > 0 && inRenderHeight > 0 &&
+        (uint32_t)inRenderWidth <= screen_width &&
+        (uint32_t)inRenderHeight <= screen_height ) {
+        render_width = inRenderWidth;
+        render_height = inRenderHeight;
+        }
+
+    // largest scale-up that fits, bars on remaining sides
     dst_rect.width = screen_width;
-    dst_rect.height = screen_height;
-      
+    dst_rect.height = ( render_height * screen_width ) / render_width;
+    
+    if( (uint32_t)dst_rect.height > screen_height ) {
+        dst_rect.height = screen_height;
+        dst_rect.width = ( render_width * screen_height ) / render_height;
+        }
+    
+    dst_rect.x = ( screen_width - dst_rect.width ) / 2;
+    dst_rect.y = ( screen_height - dst_rect.height ) / 2;
+    
+    // source in 16.16 fixed point
     src_rect.x = 0;
     src_rect.y = 0;
-    src_rect.width = screen_width << 16;
-    src_rect.height = screen_height << 16;        
+    src_rect.width = render_width << 16;
+    src_rect.height = render_height << 16;        
 
     dispman_display = vc_dispmanx_display_open( 0 /* LCD */ );
     dispman_update = vc_dispmanx_update_start( 0 );
@@ -86,8 +131,8 @@ static void raspbianCreateSurface() {
         0/*clamp*/, (DISPMANX_TRANSFORM_T)0/*transform*/ );
    
     nativewindow.element = dispman_element;
-    nativewindow.width = screen_width;
-    nativewindow.height = screen_height;
+    nativewindow.width = render_width;
+    nativewindow.height = render_height;
     vc_dispmanx_update_submit_sync( dispman_update );
       
     surface = eglCreateWindowSurface( display, config, &nativewindow, NULL );
@@ -96,6 +141,10 @@ static void raspbianCreateSurface() {
     // connect the context to the surface
     result = eglMakeCurrent( display, surface, surface, context );
     assert( EGL_FALSE != result );
+    
+    surfaceCreated = true;
+
+    eglSwapInterval( display, swapInterval );
     }
 
 
@@ -117,4 +166,6 @@ static void raspbianReleaseSurface() {
     eglDestroySurface( display, surface );
     eglDestroyContext( display, context );
     eglTerminate( display );
+    
+    surfaceCreated = false;
     }
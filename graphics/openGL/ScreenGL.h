@@ -110,6 +110,21 @@
  *
  * 2014-November-25   Jason Rohrer
  * Added support for obscuring sensitive typing in recorded event file.
+ *
+ * 2026-October-14   Jason Rohrer
+ * Binary event recording format.  Socket event bodies kept decoded.
+ * Keyframe index written beside recordings, and skipping ahead in playback.
+ * Headless playback mode.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Frame pacing against high-resolution deadlines, with a short spin at the
+ * end of each sleep.  Lower frame rate while idle, and pacing while
+ * minimized even when counting on vsync.  Frame time statistics.
+ * Swap interval and frame queue settings, swap time statistics, and
+ * reduced-resolution rendering scaled up by the display on Raspbian.
+ * Socket read bodies recorded into a compressed side stream file, and read
+ * from it only when played back.
+ * Added isRecording.
  */
  
  
@@ -132,6 +147,16 @@
 #include "minorGems/system/Time.h"
 
 
+// default frame rate while game is idle
+#define SCREEN_GL_DEFAULT_IDLE_FRAME_RATE 20
+
+// how close to a frame deadline to stop sleeping and spin instead
+#define SCREEN_GL_SPIN_SECONDS 0.001
+
+// number of recent frames that frame time statistics cover
+#define SCREEN_GL_FRAME_STATS_WINDOW 120
+
+
 // prototypes
 void callbackResize( int inW, int inH );
 void callbackKeyboard( unsigned char  inKey, int inX, int inY );
@@ -146,6 +171,13 @@ void callbackDisplay();
 void callbackIdle();
 
 
+// see recordedEvents.h
+class RecordedEventReader;
+class BinaryRecordedEventWriter;
+class SocketBodyWriter;
+class SocketBodyReader;
+
+
 
 typedef struct WebEvent {
         int handle;
@@ -161,10 +193,26 @@ typedef struct SocketEvent {
         int numBodyBytes;
         // can be NULL even if numBodyBytes not 0 (in case of
         // recorded send, where we don't need to record what was sent)
-        char *bodyBytesHex;
+        unsigned char *bodyBytes;
+        // where body is in socket body side stream, if it wasn't
+        // in the event file (-1 if not)
+        int sideChunk;
+        int sideOffset;
     } SocketEvent;
 
 
+// one entry in an event recording's keyframe index
+typedef struct RecordingKeyframe {
+        // batch (frame) number
+        int batch;
+        // where batch starts in recording file (start of a block for
+        // binary recordings)
+        long fileOffset;
+        // wall clock time when batch was recorded
+        double time;
+    } RecordingKeyframe;
+
+
 
 
 /**
@@ -251,6 +299,12 @@ class ScreenGL {
          * True if currently in playback mode.
          */
         char isPlayingBack();
+
+
+        /**
+         * True if events are being recorded.
+         */
+        char isRecording();
         
 
         /**
@@ -264,6 +318,49 @@ class ScreenGL {
          */
         char shouldShowPlaybackDisplay();
         
+
+        /**
+         * Fast-forwards playback to a recorded frame.
+         *
+         * Game state can only be rebuilt by playing every event, so all
+         * frames up to inFrame are still played, but with no buffer swaps
+         * and no frame sleep.  Normal playback resumes at inFrame.
+         *
+         * Frames already played are ignored.
+         */
+        void skipPlaybackToFrame( int inFrame );
+
+
+        /**
+         * Like skipPlaybackToFrame, but with a target in seconds of
+         * recorded time since start of recording.
+         *
+         * Uses the keyframe index recorded beside the playback file,
+         * if there is one, rounding down to the nearest keyframe.
+         * Otherwise, frames are assumed to be evenly spaced at the
+         * recorded frame rate.
+         */
+        void skipPlaybackToSeconds( double inSeconds );
+
+
+        // true while skipping ahead during playback
+        char isSkippingPlayback();
+
+
+        /**
+         * True if playing back headless, for verifying recordings.
+         *
+         * Turned on by the headlessPlayback setting when there is a
+         * recording to play back.  There is no window and no GL context
+         * (GL calls do nothing), and frames are never swapped or slept.
+         * Playback FPS is printed as it goes, and the process exits when
+         * playback ends.
+         *
+         * The SDL video driver must be set to "dummy" before SDL is
+         * initialized.
+         */
+        char isHeadless();
+
         
 
 
@@ -303,6 +400,48 @@ class ScreenGL {
         // Otherwise, if false, no max is enforced (though we may be able
         // to depend on vsync to enforce it for us)
         void useFrameSleep( char inUse );
+
+
+        // frame rate to drop to while game is idle
+        // defaults to SCREEN_GL_DEFAULT_IDLE_FRAME_RATE
+        void setIdleFrameRate( unsigned int inIdleFrameRate );
+        
+        // tells screen whether game is idle (like when it is paused), 
+        // so frames can be slowed to the idle frame rate to save power
+        // Has no effect during playback.
+        void setIdle( char inIdle );
+        
+
+        /**
+         * Gets statistics about the time between recent frames, measured
+         * right after each frame is presented.
+         *
+         * @param outMeanSeconds pointer to where the mean time should
+         *   be returned.
+         * @param outStdDevSeconds pointer to where the standard deviation
+         *   should be returned.  Jitter shows up here.
+         */
+        void getFrameTimeStats( double *outMeanSeconds, 
+                                double *outStdDevSeconds );
+
+
+        /**
+         * Gets statistics about time spent inside the buffer swap call
+         * for recent frames.  Long swaps mean frames are waiting on
+         * vsync or on a full queue of earlier frames.
+         *
+         * Swap interval and frame queueing are controlled by the
+         * swapInterval (default 1) and maxQueuedFrames (default 0, driver
+         * decides, or 1 to finish each frame before swapping) settings,
+         * read when the screen is set up.
+         *
+         * @param outMeanSeconds pointer to where the mean time should
+         *   be returned.
+         * @param outMaxSeconds pointer to where the longest time should
+         *   be returned.
+         */
+        void getSwapTimeStats( double *outMeanSeconds, 
+                               double *outMaxSeconds );
         
 
 
@@ -384,6 +523,8 @@ class ScreenGL {
         //    1 = send resulting in error (NULL body)
         //    2 = read with number read (non-NULL body if inNumBodyBytes != 0)
         //    3 = read resulting in error (NULL body)
+        //    4 = connection state poll, with state as inNumBodyBytes
+        //        (NULL body)
         void registerSocketEvent( int inHandle,
                                   int inType,
                                   int inNumBodyBytes,
@@ -392,7 +533,7 @@ class ScreenGL {
         
         // gets the type of the next pending socket event (from playback)
         // if the event has no body bytes 
-        // (type 0, 1, or 3, OR type 2 with 0-length body), 
+        // (type 0, 1, 3, or 4, OR type 2 with 0-length body), 
         // this call removes the event from the list.
         //
         // In case of type 2 with outNumBodyBytes > 0, 
@@ -731,6 +872,33 @@ class ScreenGL {
         unsigned int mMaxFrameRate;
         
         char mUseFrameSleep;
+
+        unsigned int mIdleFrameRate;
+        char mIdle;
+        
+        // monotonic time when the next frame should start,
+        // or -1 when not pacing
+        double mNextFrameTime;
+        
+        // how much longer than asked for sleeps have been taking lately
+        double mSleepOvershoot;
+        
+        // sleeps, then spins for the rest of the time, until
+        // inMonotonicTime
+        void waitUntil( double inMonotonicTime );
+        
+
+        double mLastPresentTime;
+        
+        double mFrameIntervals[ SCREEN_GL_FRAME_STATS_WINDOW ];
+        int mNumFrameIntervals;
+        int mNextFrameIntervalIndex;
+        
+        double mSwapTimes[ SCREEN_GL_FRAME_STATS_WINDOW ];
+        int mNumSwapTimes;
+        int mNextSwapTimeIndex;
+        
+        int mMaxQueuedFrames;
         
 
         // full frame rate when not in slowdown mode
@@ -773,6 +941,33 @@ class ScreenGL {
         char mPlaybackEvents;
         FILE *mEventFile;
 
+        // for playback, reads from mEventFile in either format
+        RecordedEventReader *mEventReader;
+
+        // playback runs without swaps or frame sleep up to this batch
+        int mPlaybackSkipToBatch;
+
+        // index loaded from beside playback file (empty if none)
+        SimpleVector<RecordingKeyframe> mPlaybackKeyframes;
+
+        // for recording, an index entry is written every
+        // mEventIndexInterval batches
+        FILE *mEventIndexFile;
+        int mEventIndexInterval;
+        int mNumBatchesRecorded;
+
+        
+        // for recording in binary format (NULL when recording text)
+        BinaryRecordedEventWriter *mEventWriter;
+
+        // socket read bodies go here instead of into event file
+        // (in both formats)
+        // reader is NULL when playing back recordings from before side 
+        // streams
+        FILE *mSocketBodyFile;
+        SocketBodyWriter *mSocketBodyWriter;
+        SocketBodyReader *mSocketBodyReader;
+
         char mObscureRecordedNumericTyping;
         char mCharToRecordInstead;
         
@@ -796,6 +991,17 @@ class ScreenGL {
         void writeEventBatchToFile( SimpleVector<char*> *inBatch );
 
         void playNextEventBatch();
+
+        void loadPlaybackKeyframes( const char *inPlaybackFileName );
+
+        void openPlaybackSocketBodies( const char *inPlaybackFileName );
+
+        char mHeadless;
+        double mHeadlessStartTime;
+        double mHeadlessLastReportTime;
+        
+        // prints playback FPS every few seconds, or now if inFinished
+        void reportHeadlessProgress( char inFinished );
         
 
         // recording file may contain gaps between web event sequence
@@ -134,6 +134,21 @@
  *
  * 2014-November-25   Jason Rohrer
  * Added support for obscuring sensitive typing in recorded event file.
+ *
+ * 2026-October-14   Jason Rohrer
+ * Compressed binary event recording format, which is much smaller and much
+ * faster to play back.  Text recordings can still be played back.
+ * Keyframe index written beside recordings.  Skipping ahead in playback.
+ * Headless playback mode for verifying recordings at full CPU speed.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Frame pacing against high-resolution deadlines instead of millisecond
+ * sleeps, with a short spin at the end.  Idle frame rate, and pacing while
+ * minimized even when counting on vsync.  Frame time statistics.
+ * Socket read bodies recorded into a compressed side stream file, and read
+ * from it only when played back.
+ * Added isRecording.
+ * Cached time updated at the start of each frame.
  */
 
 
@@ -162,6 +177,8 @@
 #include "minorGems/crypto/hashes/sha1.h"
 #include "minorGems/formats/encodingUtils.h"
 
+#include "recordedEvents.h"
+
 #ifdef __mac__
 #include "minorGems/game/platforms/SDL/mac/SDLMain_Ext.h"
 #endif
@@ -214,6 +231,59 @@ void callbackDisplay();
 void callbackIdle();
 */
 
+// keyframe indices are written beside recordings with this extension
+static const char *recordingIndexExtension = ".idx";
+
+// and socket body side streams with this one
+static const char *recordingSocketBodyExtension = ".sock";
+
+
+static char hasExtension( const char *inFileName, const char *inExtension ) {
+    int nameLength = strlen( inFileName );
+    int extLength = strlen( inExtension );
+
+    return ( nameLength >= extLength &&
+             strcmp( &( inFileName[ nameLength - extLength ] ),
+                     inExtension ) == 0 );
+    }
+
+
+
+// true for files that are written beside recordings
+static char isRecordingIndexFileName( const char *inFileName ) {
+    return hasExtension( inFileName, recordingIndexExtension ) ||
+        hasExtension( inFileName, recordingSocketBodyExtension );
+    }
+
+
+
+// side file name for a recording file name, with extension replaced
+static char *getRecordingSideFileName( const char *inFileName,
+                                       const char *inExtension ) {
+    char *base = stringDuplicate( inFileName );
+
+    char *dot = strrchr( base, '.' );
+    char *slash = strrchr( base, '/' );
+    
+    if( dot != NULL && ( slash == NULL || dot > slash ) ) {
+        dot[0] = '\0';
+        }
+
+    char *sideName = autoSprintf( "%s%s", base, inExtension );
+    
+    delete [] base;
+
+    return sideName;
+    }
+
+
+
+static char *getRecordingIndexFileName( const char *inFileName ) {
+    return getRecordingSideFileName( inFileName, recordingIndexExtension );
+    }
+
+
+
 ScreenGL::ScreenGL( int inWide, int inHigh, char inFullScreen,
                     char inDoNotChangeNativeResolution,
                     unsigned int inMaxFrameRate,
@@ -232,6 +302,16 @@ ScreenGL::ScreenGL( int inWide, int inHigh, char inFullScreen,
       mFullScreen( inFullScreen ),
       mMaxFrameRate( inMaxFrameRate ),
       mUseFrameSleep( true ),
+      mIdleFrameRate( SCREEN_GL_DEFAULT_IDLE_FRAME_RATE ),
+      mIdle( false ),
+      mNextFrameTime( -1 ),
+      mSleepOvershoot( 0 ),
+      mLastPresentTime( -1 ),
+      mNumFrameIntervals( 0 ),
+      mNextFrameIntervalIndex( 0 ),
+      mNumSwapTimes( 0 ),
+      mNextSwapTimeIndex( 0 ),
+      mMaxQueuedFrames( 0 ),
       mFullFrameRate( inMaxFrameRate ),
       m2DMode( false ),
 	  mViewPosition( new Vector3D( 0, 0, 0 ) ),
@@ -296,11 +376,33 @@ ScreenGL::ScreenGL( int inWide, int inHigh, char inFullScreen,
 
 
     mRecordingOrPlaybackStarted = false;
+
+    // only takes effect below if there's a file to play back
+    char headlessRequested = 
+        ( SettingsManager::getIntSetting( "headlessPlayback", 0 ) == 1 );
+    mHeadless = false;
+    mHeadlessStartTime = 0;
+    mHeadlessLastReportTime = 0;
     
     mRecordingEvents = inRecordEvents;
     mPlaybackEvents = false;
     mEventFile = NULL;
+    mEventReader = NULL;
+    mEventWriter = NULL;
+    mSocketBodyFile = NULL;
+    mSocketBodyWriter = NULL;
+    mSocketBodyReader = NULL;
     mEventFileNumBatches = 0;
+    mPlaybackSkipToBatch = 0;
+
+    mEventIndexFile = NULL;
+    mEventIndexInterval = 
+        SettingsManager::getIntSetting( "recordingIndexInterval", 600 );
+    if( mEventIndexInterval < 1 ) {
+        mEventIndexInterval = 1;
+        }
+    mNumBatchesRecorded = 0;
+
     mNumBatchesPlayed = 0;
     
     mObscureRecordedNumericTyping = false;
@@ -323,10 +425,11 @@ ScreenGL::ScreenGL( int inWide, int inHigh, char inFullScreen,
         char *fullFileName = childFiles[0]->getFullFileName();
         char *partialFileName = childFiles[0]->getFileName();
         
-        // skip hidden files
+        // skip hidden files and keyframe indices
         int i = 0;
         while( partialFileName != NULL &&
-               partialFileName[i] == '.' ) {
+               ( partialFileName[0] == '.' ||
+                 isRecordingIndexFileName( partialFileName ) ) ) {
 
             delete [] fullFileName;
             fullFileName = NULL;
@@ -347,25 +450,56 @@ ScreenGL::ScreenGL( int inWide, int inHigh, char inFullScreen,
             
             
 
-            mEventFile = fopen( fullFileName, "r" );
+            // binary recordings start with a magic line
+            char binaryFile = false;
+            
+            mEventFile = fopen( fullFileName, "rb" );
+            
+            if( mEventFile != NULL ) {
+                int magicLength = strlen( BINARY_EVENT_FILE_MAGIC );
+                
+                char *magic = new char[ magicLength ];
+                
+                int numRead = fread( magic, 1, magicLength, mEventFile );
+                
+                if( numRead == magicLength &&
+                    memcmp( magic, BINARY_EVENT_FILE_MAGIC, 
+                            magicLength ) == 0 ) {
+                    binaryFile = true;
+                    }
+                delete [] magic;
+                
+                if( ! binaryFile ) {
+                    // old text format
+                    // reopen in text mode, which it was written in
+                    fclose( mEventFile );
+                    mEventFile = fopen( fullFileName, "r" );
+                    }
+                }
+            
 
             if( mEventFile == NULL ) {
                 AppLog::error( "Failed to open event playback file" );
                 }
             else {
-
-                // count number of newlines in file (close to the number
-                // of batches in the file)
-                char *fileContents = childFiles[i]->readFileContents();
                 
-                int fileLength = strlen( fileContents );
+                long headerStart = ftell( mEventFile );
                 
-                for( int j=0; j<fileLength; j++ ) {
-                    if( fileContents[j] == '\n' ) {
-                        mEventFileNumBatches ++;
+                if( ! binaryFile ) {
+                    // count number of newlines in file (close to the number
+                    // of batches in the file)
+                    // (binary files count batches from block headers below)
+                    char *fileContents = childFiles[i]->readFileContents();
+                    
+                    int fileLength = strlen( fileContents );
+                    
+                    for( int j=0; j<fileLength; j++ ) {
+                        if( fileContents[j] == '\n' ) {
+                            mEventFileNumBatches ++;
+                            }
                         }
+                    delete [] fileContents;
                     }
-                delete [] fileContents;
                 
 
                 AppLog::getLog()->logPrintf( 
@@ -383,8 +517,8 @@ ScreenGL::ScreenGL( int inWide, int inHigh, char inFullScreen,
                     readChar = fgetc( mEventFile );
                     }
                 
-                // back to start
-                rewind( mEventFile );
+                // back to start of header
+                fseek( mEventFile, headerStart, SEEK_SET );
                 
                 char *readCustomGameData = new char[ maxCustomLength ];
 
@@ -464,6 +598,44 @@ ScreenGL::ScreenGL( int inWide, int inHigh, char inFullScreen,
 
                     }
                 delete [] readCustomGameData;                
+
+
+                if( binaryFile ) {
+                    // fscanf may have skipped whitespace-valued bytes
+                    // past the end of the header line
+                    fseek( mEventFile, headerStart + maxCustomLength + 1,
+                           SEEK_SET );
+                    
+                    BinaryRecordedEventReader *reader = 
+                        new BinaryRecordedEventReader( mEventFile );
+                    
+                    mEventFileNumBatches = reader->countBatches();
+                    
+                    mEventReader = reader;
+                    }
+                else {
+                    mEventReader = new TextRecordedEventReader( mEventFile );
+                    }
+                
+                
+                if( mPlaybackEvents ) {
+                    loadPlaybackKeyframes( fullFileName );
+                    openPlaybackSocketBodies( fullFileName );
+                    
+                    int skipFrame = 
+                        SettingsManager::getIntSetting( "playbackSkipToFrame",
+                                                        0 );
+                    double skipSeconds = 
+                        SettingsManager::getDoubleSetting( 
+                            "playbackSkipToSeconds", 0.0 );
+                    
+                    if( skipFrame > 0 ) {
+                        skipPlaybackToFrame( skipFrame );
+                        }
+                    else if( skipSeconds > 0 ) {
+                        skipPlaybackToSeconds( skipSeconds );
+                        }
+                    }
                 }
             delete [] fullFileName;
             }
@@ -479,6 +651,21 @@ ScreenGL::ScreenGL( int inWide, int inHigh, char inFullScreen,
 
 
 
+    if( headlessRequested ) {
+        if( mPlaybackEvents ) {
+            AppLog::info( "Headless playback:  no window, GL, vsync, or "
+                          "frame sleep" );
+            mHeadless = true;
+            mFullScreen = false;
+            mShouldShowPlaybackDisplay = false;
+            }
+        else {
+            AppLog::error( "Headless playback requested, but there is no "
+                           "valid recording to play back" );
+            }
+        }
+
+
     mStartedFullScreen = mFullScreen;
 
     setupSurface();
@@ -522,6 +709,38 @@ ScreenGL::~ScreenGL() {
         writeEventBatchToFile();
         }
     
+    if( mEventWriter != NULL ) {
+        // writes last partial block
+        delete mEventWriter;
+        mEventWriter = NULL;
+        }
+
+    if( mEventReader != NULL ) {
+        delete mEventReader;
+        mEventReader = NULL;
+        }
+
+    if( mEventIndexFile != NULL ) {
+        fclose( mEventIndexFile );
+        mEventIndexFile = NULL;
+        }
+
+    if( mSocketBodyWriter != NULL ) {
+        // writes last partial chunk
+        delete mSocketBodyWriter;
+        mSocketBodyWriter = NULL;
+        }
+
+    if( mSocketBodyReader != NULL ) {
+        delete mSocketBodyReader;
+        mSocketBodyReader = NULL;
+        }
+
+    if( mSocketBodyFile != NULL ) {
+        fclose( mSocketBodyFile );
+        mSocketBodyFile = NULL;
+        }
+
     if( mEventFile != NULL ) {
         fclose( mEventFile );
         mEventFile = NULL;
@@ -546,11 +765,11 @@ ScreenGL::~ScreenGL() {
     for( int i=0; i<mPendingSocketEvents.size(); i++ ) {
         SocketEvent *e = mPendingSocketEvents.getElement( i );
         
-        if( e->bodyBytesHex != NULL ) {
+        if( e->bodyBytes != NULL ) {
             
-            delete [] e->bodyBytesHex;
+            delete [] e->bodyBytes;
         
-            e->bodyBytesHex = NULL;
+            e->bodyBytes = NULL;
             }
         
         }
@@ -593,15 +812,29 @@ void ScreenGL::startRecordingOrPlayback() {
         // next file number in sequence, after max found
         fileNumber++;
 
-        char *fileName = autoSprintf( "recordedGame%06d.txt", 
-                                      fileNumber );
+        // text recordings are bigger and slower to play back, but can be
+        // read and edited by hand
+        char recordText = 
+            ( SettingsManager::getIntSetting( "recordEventsAsText", 0 ) 
+              == 1 );
+
+        const char *extension = "bin";
+        const char *openMode = "wb";
+        
+        if( recordText ) {
+            extension = "txt";
+            openMode = "w";
+            }
+
+        char *fileName = autoSprintf( "recordedGame%06d.%s", 
+                                      fileNumber, extension );
         File *file = recordedGameDir.getChildFile( fileName );
         
         delete [] fileName;
             
         char *fullFileName = file->getFullFileName();
                 
-        mEventFile = fopen( fullFileName, "w" );
+        mEventFile = fopen( fullFileName, openMode );
         
         if( mEventFile == NULL ) {
             AppLog::error( "Failed to open event recording file" );
@@ -625,6 +858,10 @@ void ScreenGL::startRecordingOrPlayback() {
             delete [] stringToHash;
             
             
+            if( ! recordText ) {
+                fputs( BINARY_EVENT_FILE_MAGIC, mEventFile );
+                }
+
             fprintf( mEventFile, 
                      "%u seed, %u fps, %dx%d, fullScreen=%d, %s %s\n",
                      mRandSeed,
@@ -634,6 +871,37 @@ void ScreenGL::startRecordingOrPlayback() {
             
             delete [] correctHash;
             
+            if( ! recordText ) {
+                mEventWriter = new BinaryRecordedEventWriter( mEventFile );
+                }
+            
+            char *indexFileName = getRecordingIndexFileName( fullFileName );
+            
+            mEventIndexFile = fopen( indexFileName, "w" );
+            
+            if( mEventIndexFile == NULL ) {
+                AppLog::error( "Failed to open recording keyframe index "
+                               "file" );
+                }
+            delete [] indexFileName;
+
+
+            char *socketFileName = 
+                getRecordingSideFileName( fullFileName, 
+                                          recordingSocketBodyExtension );
+            
+            mSocketBodyFile = fopen( socketFileName, "wb" );
+            
+            if( mSocketBodyFile == NULL ) {
+                // socket bodies will go into event file instead
+                AppLog::error( "Failed to open recording socket body "
+                               "file" );
+                }
+            else {
+                fputs( SOCKET_BODY_FILE_MAGIC, mSocketBodyFile );
+                mSocketBodyWriter = new SocketBodyWriter( mSocketBodyFile );
+                }
+            delete [] socketFileName;
         
             delete [] fullFileName;                
             }
@@ -677,6 +945,40 @@ void ScreenGL::startRecordingOrPlayback() {
                     numRemoved++;
                     }
                 delete file;
+
+                fileName = autoSprintf( "recordedGame%06d.bin", f );
+                file = recordedGameDir.getChildFile( fileName );
+            
+                delete [] fileName;
+            
+                if( file->exists() ) {
+                    file->remove();
+                    numRemoved++;
+                    }
+                delete file;
+
+                // index goes along with recording, not counted
+                fileName = autoSprintf( "recordedGame%06d%s", f,
+                                        recordingIndexExtension );
+                file = recordedGameDir.getChildFile( fileName );
+            
+                delete [] fileName;
+            
+                if( file->exists() ) {
+                    file->remove();
+                    }
+                delete file;
+
+                fileName = autoSprintf( "recordedGame%06d%s", f,
+                                        recordingSocketBodyExtension );
+                file = recordedGameDir.getChildFile( fileName );
+            
+                delete [] fileName;
+            
+                if( file->exists() ) {
+                    file->remove();
+                    }
+                delete file;
                 }
             AppLog::getLog()->logPrintf( 
                 Log::INFO_LEVEL,
@@ -711,6 +1013,13 @@ int computeAspectRatio( int inW, int inH ) {
 
 
 void ScreenGL::setupSurface() {
+    if( mHeadless ) {
+        // plain surface, no GL context
+        // (GL calls made with no current context do nothing)
+        SDL_SetVideoMode( mWide, mHigh, 0, 0 );
+        return;
+        }
+
     SDL_GL_SetAttribute( SDL_GL_DOUBLEBUFFER, 1 );
 	
     int flags = 0;
@@ -1014,13 +1323,23 @@ void ScreenGL::setupSurface() {
     SDL_GL_SetAttribute( SDL_GL_STENCIL_SIZE, 1 );
 
     // vsync to avoid tearing
-    SDL_GL_SetAttribute( SDL_GL_SWAP_CONTROL, 1 );
+    // (0 trades tearing for lower latency, 2+ holds to a fraction of
+    //  the refresh rate)
+    int swapInterval = SettingsManager::getIntSetting( "swapInterval", 1 );
+    
+    SDL_GL_SetAttribute( SDL_GL_SWAP_CONTROL, swapInterval );
+    
+    mMaxQueuedFrames = SettingsManager::getIntSetting( "maxQueuedFrames", 0 );
 
     // current color depth
     SDL_Surface *screen = SDL_SetVideoMode( mWide, mHigh, 0, flags);
 
 #ifdef RASPBIAN
-    raspbianCreateSurface();
+    raspbianSetSwapInterval( swapInterval );
+    
+    // if mWide x mHigh is smaller than the display, display hardware
+    // scales it up for free
+    raspbianCreateSurface( mWide, mHigh );
 #endif
 
 
@@ -1163,7 +1482,16 @@ void ScreenGL::registerSocketEvent( int inHandle,
     char *eventString;
     
     // only event type 2 has a body byte payload
-    if( inType == 2 && inNumBodyBytes != 0 ) {
+    if( inType == 2 && inNumBodyBytes > 0 && mSocketBodyWriter != NULL ) {
+        // body goes into side stream, and event file just says where
+        int chunk, offset;
+        mSocketBodyWriter->addBody( inBodyBytes, inNumBodyBytes,
+                                    &chunk, &offset );
+        
+        eventString = autoSprintf( "xo %u %d %d %d %d", inHandle, 
+                                   inType, inNumBodyBytes, chunk, offset );
+        }
+    else if( inType == 2 && inNumBodyBytes != 0 ) {
 
         char *bodyHex = hexEncode( inBodyBytes, inNumBodyBytes );
 
@@ -1217,12 +1545,20 @@ unsigned char *ScreenGL::getSocketEventBodyBytes( int inHandle ) {
         if( e->handle == inHandle ) {
             
             
-            unsigned char *returnValue = NULL;
-
-            if( e->bodyBytesHex != NULL ) {
-                returnValue = hexDecode( e->bodyBytesHex );
+            unsigned char *returnValue = e->bodyBytes;
             
-                delete [] e->bodyBytesHex;
+            if( returnValue == NULL && e->sideChunk != -1 ) {
+                // read from side stream only now that it's needed
+                if( mSocketBodyReader != NULL ) {
+                    returnValue = mSocketBodyReader->getBody( 
+                        e->sideChunk, e->sideOffset, e->numBodyBytes );
+                    }
+                
+                if( returnValue == NULL ) {
+                    AppLog::error( 
+                        "Failed to read socket event body from "
+                        "socket body file" );
+                    }
                 }
             
             mPendingSocketEvents.deleteElement( i );
@@ -1263,8 +1599,13 @@ char ScreenGL::getAsyncFileDone( int inHandle ) {
 
 void ScreenGL::writeEventBatchToFile( SimpleVector<char*> *inBatch ) {
     int numInBatch = inBatch->size();
-        
-    if( mEventFile != NULL ) {
+    
+    if( mEventWriter != NULL ) {
+        for( int i=0; i<numInBatch; i++ ) {
+            mEventWriter->addEvent( inBatch->getElementDirect( i ) );
+            }
+        }
+    else if( mEventFile != NULL ) {
         if( numInBatch > 0 ) {
             
             char **allEvents = inBatch->getElementArray();
@@ -1297,6 +1638,37 @@ void ScreenGL::writeEventBatchToFile( SimpleVector<char*> *inBatch ) {
 
 
 void ScreenGL::writeEventBatchToFile() {
+    if( mEventFile != NULL && mEventIndexFile != NULL &&
+        mNumBatchesRecorded % mEventIndexInterval == 0 ) {
+        
+        if( mEventWriter != NULL ) {
+            // keyframes always start a new block, so that their offsets
+            // are usable
+            mEventWriter->flushBlock();
+            }
+        
+        if( mSocketBodyWriter != NULL ) {
+            // so a crash loses little more than one keyframe interval
+            // of socket bodies
+            mSocketBodyWriter->flushChunk();
+            }
+        
+        fprintf( mEventIndexFile, "%d %ld %f\n",
+                 mNumBatchesRecorded, ftell( mEventFile ),
+                 Time::getCurrentTime() );
+        fflush( mEventIndexFile );
+        }
+    mNumBatchesRecorded++;
+    
+
+    if( mEventWriter != NULL ) {
+        writeEventBatchToFile( &mEventBatch );
+        writeEventBatchToFile( &mUserEventBatch );
+        
+        mEventWriter->endBatch();
+        return;
+        }
+
     int num = mEventBatch.size() + mUserEventBatch.size();
     
     fprintf( mEventFile, "%d ", num );
@@ -1324,9 +1696,10 @@ void ScreenGL::playNextEventBatch() {
 
     // read and playback next batch
     int batchSize = 0;
-    int numRead = fscanf( mEventFile, "%d", &batchSize );
             
-    if( numRead == 0 || numRead == EOF ) {
+    if( ! mEventReader->readBatchSize( &batchSize ) ) {
+        batchSize = 0;
+        
         printf( "Reached end of recorded event file during playback\n" );
         // stop playback
         mPlaybackEvents = false;
@@ -1338,29 +1711,30 @@ void ScreenGL::playNextEventBatch() {
         char code[3];
         code[0] = '\0';
                 
-        fscanf( mEventFile, "%2s", code );
+        mEventReader->readCode( code );
                 
         switch( code[0] ) {
             case 'm':
                 switch( code[1] ) {
                     case 'm': {
-                        int x, y;
-                        fscanf( mEventFile, "%d %d", &x, &y );
+                        int x = mEventReader->readInt();
+                        int y = mEventReader->readInt();
                                 
                         callbackPassiveMotion( x, y );
                         }
                         break;
                     case 'd': {
-                        int x, y;
-                        fscanf( mEventFile, "%d %d", &x, &y );
+                        int x = mEventReader->readInt();
+                        int y = mEventReader->readInt();
                                 
                         callbackMotion( x, y );
                         }
                         break;
                     case 'b': {
-                        int button, state, x, y;
-                        fscanf( mEventFile, "%d %d %d %d", 
-                                &button, &state, &x, &y );
+                        int button = mEventReader->readInt();
+                        int state = mEventReader->readInt();
+                        int x = mEventReader->readInt();
+                        int y = mEventReader->readInt();
                                 
                         if( state == 1 ) {
                             state = SDL_PRESSED;
@@ -1375,8 +1749,9 @@ void ScreenGL::playNextEventBatch() {
                     }
                 break;
             case 'k': {
-                int c, x, y;
-                fscanf( mEventFile, "%d %d %d", &c, &x, &y );
+                int c = mEventReader->readInt();
+                int x = mEventReader->readInt();
+                int y = mEventReader->readInt();
 
                 switch( code[1] ) {
                     case 'd':          
@@ -1389,8 +1764,9 @@ void ScreenGL::playNextEventBatch() {
                 }
                 break;
             case 's': {
-                int c, x, y;
-                fscanf( mEventFile, "%d %d %d", &c, &x, &y );
+                int c = mEventReader->readInt();
+                int x = mEventReader->readInt();
+                int y = mEventReader->readInt();
 
                 switch( code[1] ) {
                     case 'd':          
@@ -1403,7 +1779,7 @@ void ScreenGL::playNextEventBatch() {
                 }
                 break;
             case 't': {
-                fscanf( mEventFile, "%lf", &mLastTimeValue );
+                mLastTimeValue = mEventReader->readDouble();
                 mLastTimeValueStack.push_back( mLastTimeValue );
                 mTimeValuePlayedBack = true;
                 }
@@ -1415,8 +1791,7 @@ void ScreenGL::playNextEventBatch() {
                 }
                 break;
             case 'T': {
-                double t;
-                fscanf( mEventFile, "%lf", &t );
+                double t = mEventReader->readDouble();
                 mLastCurrentTimeValue = t;
                 mLastCurrentTimeValueStack.push_back( mLastCurrentTimeValue );
                 mTimeValuePlayedBack = true;
@@ -1429,8 +1804,7 @@ void ScreenGL::playNextEventBatch() {
                 }
                 break;
             case 'F': {
-                double fps;
-                fscanf( mEventFile, "%lf", &fps );
+                double fps = mEventReader->readDouble();
                 mLastActualFrameRate = fps;
                 }
                 break;
@@ -1443,7 +1817,8 @@ void ScreenGL::playNextEventBatch() {
                 // (simulating response from a web server during playback)
                 
                 WebEvent e;
-                fscanf( mEventFile, "%d %d", &( e.handle ), &( e.type ) );
+                e.handle = mEventReader->readInt();
+                e.type = mEventReader->readInt();
                 
                 if( e.handle > mLastReadWebEventHandle ) {
                     mLastReadWebEventHandle = e.handle;
@@ -1462,63 +1837,33 @@ void ScreenGL::playNextEventBatch() {
                 if( e.type == 2 ) {
                     // includes a body payload
 
-                    unsigned int length;
+                    // for hex bodies, this is length of hex string
+                    int length = mEventReader->readInt();
                     
-                    fscanf( mEventFile, "%u", &length );
+                    char hex = ( code[1] == 'x' );
 
-                    // skip the space after length
-                    fgetc( mEventFile );
-                
-                
-                    if( code[1] == 'b' ) {
-                        // plain text body
+                    if( hex ) {
+                        length /= 2;
+                        }
+
+                    if( length >= 0 ) {
                         e.bodyLength = length;
                         e.bodyText = new char[ length + 1 ];
-                
-                        unsigned int numRead = 
-                            fread( e.bodyText, 1, length, mEventFile );
-                
-                        e.bodyText[ length ] = '\0';
-
-                        if( numRead != length ) {
-                            AppLog::error( 
-                                "Failed to read web event body text from "
-                                "playback file" );
-                            delete [] e.bodyText;
-                            e.bodyText = NULL;
-                            e.bodyLength = 0;
-                            }
-                        }
-                    else if( code[1] == 'x' ) {
-                        // hex-encoded body
-                        char *bodyHex = new char[ length + 1 ];
                         
-                        unsigned int numRead = 
-                            fread( bodyHex, 1, length, mEventFile );
-                
-                        bodyHex[ length ] = '\0';
-
-                        if( numRead != length ) {
+                        if( mEventReader->readBody( 
+                                (unsigned char*)( e.bodyText ), length, 
+                                hex ) ) {
+                            
+                            e.bodyText[ length ] = '\0';
+                            }
+                        else {
                             AppLog::error( 
-                                "Failed to read web event body hex from "
+                                "Failed to read web event body from "
                                 "playback file" );
+                            delete [] e.bodyText;
                             e.bodyText = NULL;
                             e.bodyLength = 0;
                             }
-                        else {
-                            unsigned char *bodyDecoded 
-                                = hexDecode( bodyHex );
-                            
-                            e.bodyLength = length / 2;
-                            e.bodyText = new char[ e.bodyLength + 1 ];
-                            
-                            memcpy( e.bodyText, bodyDecoded, e.bodyLength );
-                            
-                            e.bodyText[ e.bodyLength ] = '\0';
-                            
-                            delete [] bodyDecoded;
-                            }
-                        delete [] bodyHex;
                         }
                     }
                 
@@ -1530,33 +1875,30 @@ void ScreenGL::playNextEventBatch() {
                 // (simulating response from a socket server during playback)
                 
                 SocketEvent e;
-                fscanf( mEventFile, "%d %d %d", 
-                        &( e.handle ), &( e.type ), &( e.numBodyBytes ) );
-
-                e.bodyBytesHex = NULL;
-
-                if( e.type == 2 && e.numBodyBytes != 0 ) {
+                e.handle = mEventReader->readInt();
+                e.type = mEventReader->readInt();
+                e.numBodyBytes = mEventReader->readInt();
+
+                e.bodyBytes = NULL;
+                e.sideChunk = -1;
+                e.sideOffset = -1;
+
+                if( code[1] == 'o' ) {
+                    // body is in side stream, read when asked for
+                    e.sideChunk = mEventReader->readInt();
+                    e.sideOffset = mEventReader->readInt();
+                    }
+                else if( e.type == 2 && e.numBodyBytes > 0 ) {
                     // includes a body payload
-
-                    // skip the space after numBodyBytes
-                    fgetc( mEventFile );
+                    e.bodyBytes = new unsigned char[ e.numBodyBytes ];
                 
-                    unsigned int hexLength = e.numBodyBytes * 2;
-                    
-
-                    e.bodyBytesHex = new char[ hexLength + 1 ];
-                
-                    unsigned int numRead = 
-                        fread( e.bodyBytesHex, 1, hexLength, mEventFile );
-                
-                    e.bodyBytesHex[ hexLength ] = '\0';
-
-                    if( numRead != hexLength ) {
+                    if( ! mEventReader->readBody( e.bodyBytes, 
+                                                  e.numBodyBytes, true ) ) {
                         AppLog::error( 
-                            "Failed to read socket event body hex from "
+                            "Failed to read socket event body from "
                             "playback file" );
-                        delete [] e.bodyBytesHex;
-                        e.bodyBytesHex = NULL;
+                        delete [] e.bodyBytes;
+                        e.bodyBytes = NULL;
                         }
                     }
                 
@@ -1564,8 +1906,7 @@ void ScreenGL::playNextEventBatch() {
                 break;
                 }
             case 'a': {
-                int nextHandle;
-                fscanf( mEventFile, "%d", &nextHandle );
+                int nextHandle = mEventReader->readInt();
                 
                 if( nextHandle > mLastAsyncFileHandleDone ) {
                     // track the largest handle seen done so far
@@ -1585,6 +1926,176 @@ void ScreenGL::playNextEventBatch() {
 
 
     mNumBatchesPlayed++;
+    
+    if( mPlaybackSkipToBatch > 0 && 
+        mNumBatchesPlayed >= mPlaybackSkipToBatch ) {
+        
+        AppLog::getLog()->logPrintf( 
+            Log::INFO_LEVEL,
+            "Skipped playback ahead to frame %d", mNumBatchesPlayed );
+        
+        mPlaybackSkipToBatch = 0;
+        }
+    }
+
+
+
+void ScreenGL::openPlaybackSocketBodies( const char *inPlaybackFileName ) {
+    char *socketFileName = 
+        getRecordingSideFileName( inPlaybackFileName, 
+                                  recordingSocketBodyExtension );
+    
+    mSocketBodyFile = fopen( socketFileName, "rb" );
+    
+    delete [] socketFileName;
+    
+    if( mSocketBodyFile == NULL ) {
+        // older recording, with bodies in event file
+        return;
+        }
+    
+    int magicLength = strlen( SOCKET_BODY_FILE_MAGIC );
+    
+    char *magic = new char[ magicLength ];
+    
+    int numRead = fread( magic, 1, magicLength, mSocketBodyFile );
+    
+    if( numRead == magicLength &&
+        memcmp( magic, SOCKET_BODY_FILE_MAGIC, magicLength ) == 0 ) {
+        
+        mSocketBodyReader = new SocketBodyReader( mSocketBodyFile );
+        }
+    else {
+        AppLog::error( "Socket body file for playback is damaged" );
+        
+        fclose( mSocketBodyFile );
+        mSocketBodyFile = NULL;
+        }
+    
+    delete [] magic;
+    }
+
+
+
+void ScreenGL::loadPlaybackKeyframes( const char *inPlaybackFileName ) {
+    mPlaybackKeyframes.deleteAll();
+    
+    char *indexFileName = getRecordingIndexFileName( inPlaybackFileName );
+    
+    FILE *indexFile = fopen( indexFileName, "r" );
+    
+    delete [] indexFileName;
+    
+    if( indexFile == NULL ) {
+        return;
+        }
+
+    RecordingKeyframe k;
+    
+    while( fscanf( indexFile, "%d %ld %lf", 
+                   &( k.batch ), &( k.fileOffset ), &( k.time ) ) == 3 ) {
+        mPlaybackKeyframes.push_back( k );
+        }
+    
+    fclose( indexFile );
+
+    AppLog::getLog()->logPrintf( 
+        Log::INFO_LEVEL,
+        "Loaded %d keyframes for playback", mPlaybackKeyframes.size() );
+    }
+
+
+
+void ScreenGL::skipPlaybackToFrame( int inFrame ) {
+    if( ! mPlaybackEvents || inFrame <= mNumBatchesPlayed ) {
+        return;
+        }
+
+    AppLog::getLog()->logPrintf( 
+        Log::INFO_LEVEL,
+        "Skipping playback ahead from frame %d to frame %d", 
+        mNumBatchesPlayed, inFrame );
+
+    mPlaybackSkipToBatch = inFrame;
+    }
+
+
+
+void ScreenGL::skipPlaybackToSeconds( double inSeconds ) {
+    int numKeyframes = mPlaybackKeyframes.size();
+    
+    if( numKeyframes == 0 ) {
+        skipPlaybackToFrame( (int)( inSeconds * mFullFrameRate ) );
+        return;
+        }
+    
+    RecordingKeyframe *first = mPlaybackKeyframes.getElement( 0 );
+    
+    double targetTime = first->time + inSeconds;
+    
+    // last keyframe at or before target
+    int k = 0;
+    while( k < numKeyframes - 1 &&
+           mPlaybackKeyframes.getElement( k + 1 )->time <= targetTime ) {
+        k++;
+        }
+    
+    RecordingKeyframe *before = mPlaybackKeyframes.getElement( k );
+    
+    skipPlaybackToFrame( before->batch );
+    }
+
+
+
+char ScreenGL::isSkippingPlayback() {
+    return mPlaybackEvents && mNumBatchesPlayed < mPlaybackSkipToBatch;
+    }
+
+
+
+char ScreenGL::isHeadless() {
+    return mHeadless;
+    }
+
+
+
+void ScreenGL::reportHeadlessProgress( char inFinished ) {
+    double now = Time::getCurrentTime();
+    
+    if( mHeadlessStartTime == 0 ) {
+        mHeadlessStartTime = now;
+        mHeadlessLastReportTime = now;
+        }
+
+    if( ! inFinished && now - mHeadlessLastReportTime < 5 ) {
+        return;
+        }
+    mHeadlessLastReportTime = now;
+    
+    double elapsed = now - mHeadlessStartTime;
+    
+    double fps = 0;
+    if( elapsed > 0 ) {
+        fps = mNumBatchesPlayed / elapsed;
+        }
+
+    char *report;
+    
+    if( inFinished ) {
+        report = autoSprintf( "Headless playback finished:  %d frames in "
+                              "%.2f seconds (%.1f fps)",
+                              mNumBatchesPlayed, elapsed, fps );
+        }
+    else {
+        report = autoSprintf( "Headless playback:  frame %d of %d "
+                              "(%.1f fps)",
+                              mNumBatchesPlayed, mEventFileNumBatches, fps );
+        }
+    
+    printf( "%s\n", report );
+    AppLog::info( report );
+    
+    delete [] report;
     }
 
 
@@ -1601,6 +2112,12 @@ char ScreenGL::isPlayingBack() {
     }
 
 
+
+char ScreenGL::isRecording() {
+    return mRecordingEvents;
+    }
+
+
 float ScreenGL::getPlaybackDoneFraction() {
     if( mEventFileNumBatches == 0 || mEventFile == NULL ) {
         return 0;
@@ -1666,21 +2183,12 @@ void ScreenGL::start() {
     // window was created)
     callbackResize( mWide, mHigh );
 
-
-    // oversleep on last loop (discount it from next sleep)
-    // can be negative (add to next sleep)
-    int oversleepMSec = 0;
-
-
     
     // main loop
     while( true ) {
-        
-        timeSec_t frameStartSec;
-        unsigned long frameStartMSec;
-        
-        Time::getCurrentTime( &frameStartSec, &frameStartMSec );
 
+        // one clock read for code that just needs this frame's time
+        Time::updateCachedTime();
 
         // pre-display first, this might involve a sleep for frame timing
         // purposes
@@ -1983,6 +2491,10 @@ void ScreenGL::start() {
             // if this recorded frame involved a recorded time() call.
             playNextEventBatch();
 
+            if( mHeadless ) {
+                reportHeadlessProgress( false );
+                }
+
 
             // dump events, but responde to ESC to stop playback
             // let player take over from that point
@@ -2121,6 +2633,14 @@ void ScreenGL::start() {
         // now all events handled, actually draw the screen
         callbackDisplay();
 
+        
+        if( mHeadless && ! mPlaybackEvents ) {
+            // let game see end of playback for one frame first
+            reportHeadlessProgress( true );
+            
+            exit( 0 );
+            }
+
 
         // record them?
         // do this down here, AFTER display, since some events might be
@@ -2130,45 +2650,114 @@ void ScreenGL::start() {
             }
 
 
-        int frameTime =
-            Time::getMillisecondsSince( frameStartSec, frameStartMSec );
+        // frame has been presented (or at least handed off to the driver)
+        double presentTime = Time::getMonotonicTime();
         
-
-        // frame time should never be negative
-        // BUT it can be if system time changes while game is running
-        // (example:  automatic daylight savings time adjustment)
-        if( frameTime < 0 ) {
-            frameTime = 0;
+        if( mLastPresentTime >= 0 ) {
+            mFrameIntervals[ mNextFrameIntervalIndex ] = 
+                presentTime - mLastPresentTime;
+            
+            mNextFrameIntervalIndex = 
+                ( mNextFrameIntervalIndex + 1 ) % 
+                SCREEN_GL_FRAME_STATS_WINDOW;
+            
+            if( mNumFrameIntervals < SCREEN_GL_FRAME_STATS_WINDOW ) {
+                mNumFrameIntervals++;
+                }
             }
+        mLastPresentTime = presentTime;
         
+
+        unsigned int paceFrameRate = 0;
         
-        if( mUseFrameSleep ) {    
-            // lock down to mMaxFrameRate frames per second
-            int minFrameTime = 1000 / mMaxFrameRate;
-            if( ( frameTime + oversleepMSec ) < minFrameTime ) {
-                int timeToSleep = 
-                    minFrameTime - ( frameTime + oversleepMSec );
-                
-                //SDL_Delay( timeToSleep );
-                timeSec_t sleepStartSec;
-                unsigned long sleepStartMSec;
-                Time::getCurrentTime( &sleepStartSec, &sleepStartMSec );
-                
-                Thread::staticSleep( timeToSleep );
-                
-                int actualSleepTime = 
-                    Time::getMillisecondsSince( sleepStartSec, sleepStartMSec );
-                
-                oversleepMSec = actualSleepTime - timeToSleep;
+        if( ! mHeadless && ! isSkippingPlayback() ) {
+            char playingBack = mPlaybackEvents && mRecordingOrPlaybackStarted;
+            
+            if( mUseFrameSleep ) {
+                // lock down to mMaxFrameRate frames per second
+                paceFrameRate = mMaxFrameRate;
+                }
+            else if( ! playingBack && 
+                     ( SDL_GetAppState() & SDL_APPACTIVE ) == 0 ) {
+                // counting on vsync, but minimized windows aren't
+                // necessarily held to it
+                // (not isMinimized, which records events)
+                paceFrameRate = mMaxFrameRate;
+                }
+            
+            if( mIdle && ! playingBack &&
+                ( paceFrameRate == 0 || mIdleFrameRate < paceFrameRate ) ) {
+                paceFrameRate = mIdleFrameRate;
                 }
-            else { 
-                oversleepMSec = 0;
+            }
+        
+
+        if( paceFrameRate > 0 ) {
+            double framePeriod = 1.0 / paceFrameRate;
+            
+            if( mNextFrameTime < 0 || 
+                presentTime > mNextFrameTime + framePeriod ) {
+                // just started pacing, or fell more than a frame behind
+                // start schedule over from now, instead of rushing 
+                // frames to catch up
+                mNextFrameTime = presentTime;
                 }
+            
+            // frames start on a fixed schedule, so sleep errors don't
+            // accumulate
+            mNextFrameTime += framePeriod;
+            
+            waitUntil( mNextFrameTime );
+            }
+        else {
+            mNextFrameTime = -1;
+            }
+        }
+    
+    }
+
+
+
+void ScreenGL::waitUntil( double inMonotonicTime ) {
+    double now = Time::getMonotonicTime();
+    
+    // sleep for all but the end, leaving room for sleeps
+    // that take longer than asked
+    int sleepMSec = 
+        (int)( ( inMonotonicTime - now 
+                 - mSleepOvershoot - SCREEN_GL_SPIN_SECONDS ) * 1000 );
+    
+    if( sleepMSec > 0 ) {
+        Thread::staticSleep( sleepMSec );
+        
+        double after = Time::getMonotonicTime();
+        
+        double overshoot = ( after - now ) - sleepMSec / 1000.0;
+        
+        // react to longer sleeps right away, and recover slowly
+        if( overshoot > mSleepOvershoot ) {
+            mSleepOvershoot = overshoot;
+            }
+        else {
+            mSleepOvershoot += ( overshoot - mSleepOvershoot ) * 0.05;
             }
         
+        // one bad sleep (like when system is busy) shouldn't make
+        // us spin for a long time after
+        if( mSleepOvershoot > 0.004 ) {
+            mSleepOvershoot = 0.004;
+            }
+        if( mSleepOvershoot < 0 ) {
+            mSleepOvershoot = 0;
+            }
         
+        now = after;
         }
     
+    // spin for the rest, which sleeps can't hit precisely
+    while( now < inMonotonicTime ) {
+        now = Time::getMonotonicTime();
+        }
     }
 
 
@@ -2196,6 +2785,68 @@ void ScreenGL::useFrameSleep( char inUse ) {
     }
 
 
+
+void ScreenGL::setIdleFrameRate( unsigned int inIdleFrameRate ) {
+    mIdleFrameRate = inIdleFrameRate;
+    }
+
+
+
+void ScreenGL::setIdle( char inIdle ) {
+    mIdle = inIdle;
+    }
+
+
+
+void ScreenGL::getFrameTimeStats( double *outMeanSeconds, 
+                                  double *outStdDevSeconds ) {
+    if( mNumFrameIntervals == 0 ) {
+        *outMeanSeconds = 0;
+        *outStdDevSeconds = 0;
+        return;
+        }
+    
+    double sum = 0;
+    for( int i=0; i<mNumFrameIntervals; i++ ) {
+        sum += mFrameIntervals[i];
+        }
+    double mean = sum / mNumFrameIntervals;
+    
+    double sumSquares = 0;
+    for( int i=0; i<mNumFrameIntervals; i++ ) {
+        double d = mFrameIntervals[i] - mean;
+        sumSquares += d * d;
+        }
+    
+    *outMeanSeconds = mean;
+    *outStdDevSeconds = sqrt( sumSquares / mNumFrameIntervals );
+    }
+
+
+
+void ScreenGL::getSwapTimeStats( double *outMeanSeconds, 
+                                 double *outMaxSeconds ) {
+    if( mNumSwapTimes == 0 ) {
+        *outMeanSeconds = 0;
+        *outMaxSeconds = 0;
+        return;
+        }
+    
+    double sum = 0;
+    double max = 0;
+    for( int i=0; i<mNumSwapTimes; i++ ) {
+        sum += mSwapTimes[i];
+        
+        if( mSwapTimes[i] > max ) {
+            max = mSwapTimes[i];
+            }
+        }
+    
+    *outMeanSeconds = sum / mNumSwapTimes;
+    *outMaxSeconds = max;
+    }
+
+
 unsigned int ScreenGL::getRandSeed() {
     return mRandSeed;
     }
@@ -2912,11 +3563,33 @@ void callbackDisplay() {
 		listener->postRedraw();
 		}
 
+    // frames skipped over during playback are never shown
+    if( ! s->mHeadless && ! s->isSkippingPlayback() ) {
+        
+        if( s->mMaxQueuedFrames == 1 ) {
+            // don't let driver queue this frame behind another, so
+            // input shows up on screen a frame sooner
+            glFinish();
+            }
+        
+        double swapStartTime = Time::getMonotonicTime();
+        
 #ifdef RASPBIAN
-    raspbianSwapBuffers();
+        raspbianSwapBuffers();
 #else
-	SDL_GL_SwapBuffers();
+        SDL_GL_SwapBuffers();
 #endif
+        
+        s->mSwapTimes[ s->mNextSwapTimeIndex ] = 
+            Time::getMonotonicTime() - swapStartTime;
+        
+        s->mNextSwapTimeIndex = 
+            ( s->mNextSwapTimeIndex + 1 ) % SCREEN_GL_FRAME_STATS_WINDOW;
+        
+        if( s->mNumSwapTimes < SCREEN_GL_FRAME_STATS_WINDOW ) {
+            s->mNumSwapTimes++;
+            }
+        }
 
     // thanks to Andrew McClure for the idea of doing this AFTER
     // the next redraw (for pretty minimization)
@@ -0,0 +1,250 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+
+
+#include "ShaderProgramGL.h"
+#include "SingleTextureGL.h"
+
+#include "minorGems/util/log/AppLog.h"
+
+#include <stdio.h>
+
+
+
+#ifdef SHADER_PROGRAM_GL_SHADERS
+
+// glext.h only declares these with GL_GLEXT_PROTOTYPES, which may
+// not have been defined where it was first included
+extern "C" {
+GLAPI GLuint APIENTRY glCreateShader( GLenum );
+GLAPI void APIENTRY glShaderSource( GLuint, GLsizei, const GLchar *const *,
+                                    const GLint * );
+GLAPI void APIENTRY glCompileShader( GLuint );
+GLAPI void APIENTRY glGetShaderiv( GLuint, GLenum, GLint * );
+GLAPI void APIENTRY glGetShaderInfoLog( GLuint, GLsizei, GLsizei *,
+                                        GLchar * );
+GLAPI void APIENTRY glDeleteShader( GLuint );
+GLAPI GLuint APIENTRY glCreateProgram();
+GLAPI void APIENTRY glAttachShader( GLuint, GLuint );
+GLAPI void APIENTRY glBindAttribLocation( GLuint, GLuint, const GLchar * );
+GLAPI void APIENTRY glLinkProgram( GLuint );
+GLAPI void APIENTRY glGetProgramiv( GLuint, GLenum, GLint * );
+GLAPI void APIENTRY glGetProgramInfoLog( GLuint, GLsizei, GLsizei *,
+                                         GLchar * );
+GLAPI void APIENTRY glDeleteProgram( GLuint );
+GLAPI void APIENTRY glUseProgram( GLuint );
+GLAPI GLint APIENTRY glGetUniformLocation( GLuint, const GLchar * );
+GLAPI void APIENTRY glUniform1f( GLint, GLfloat );
+GLAPI void APIENTRY glUniform1i( GLint, GLint );
+GLAPI void APIENTRY glVertexAttribPointer( GLuint, GLint, GLenum,
+                                           GLboolean, GLsizei,
+                                           const void * );
+GLAPI void APIENTRY glEnableVertexAttribArray( GLuint );
+GLAPI void APIENTRY glDisableVertexAttribArray( GLuint );
+}
+
+
+
+// returns 0 on failure
+static GLuint compileShader( GLenum inType, const char *inSource ) {
+    GLuint shader = glCreateShader( inType );
+
+    glShaderSource( shader, 1, &inSource, NULL );
+    glCompileShader( shader );
+
+    GLint compiled = GL_FALSE;
+    glGetShaderiv( shader, GL_COMPILE_STATUS, &compiled );
+
+    if( compiled != GL_TRUE ) {
+        char log[1024];
+        glGetShaderInfoLog( shader, sizeof( log ), NULL, log );
+
+        AppLog::errorF( "Failed to compile %s shader:\n%s",
+                        ( inType == GL_VERTEX_SHADER ) ?
+                        "vertex" : "fragment",
+                        log );
+
+        glDeleteShader( shader );
+        return 0;
+        }
+
+    return shader;
+    }
+
+#endif
+
+
+
+// context change count when support was last checked
+static int supportCheckedContext = -1;
+static char supported = false;
+
+
+
+char ShaderProgramGL::isSupported() {
+    #ifdef SHADER_PROGRAM_GL_SHADERS
+        int context = SingleTextureGL::getContextChangeCount();
+
+        if( supportCheckedContext != context ) {
+            const char *version = (const char *)glGetString( GL_VERSION );
+
+            // NULL if there is no active screen yet, so check again later
+            if( version != NULL ) {
+                int major = 0;
+                sscanf( version, "%d", &major );
+
+                supported = ( major >= 2 );
+                supportCheckedContext = context;
+                }
+            }
+        return supported;
+    #else
+        return false;
+    #endif
+    }
+
+
+
+ShaderProgramGL::ShaderProgramGL( const char *inVertexSource,
+                                  const char *inFragmentSource,
+                                  int inNumAttributes,
+                                  const char **inAttributeNames )
+        : mProgram( 0 ),
+          mProgramContext( SingleTextureGL::getContextChangeCount() ),
+          mLinked( false ) {
+
+    #ifdef SHADER_PROGRAM_GL_SHADERS
+
+    if( ! isSupported() ) {
+        return;
+        }
+
+    GLuint vertexShader = compileShader( GL_VERTEX_SHADER, inVertexSource );
+    GLuint fragmentShader = compileShader( GL_FRAGMENT_SHADER,
+                                           inFragmentSource );
+
+    if( vertexShader == 0 || fragmentShader == 0 ) {
+        if( vertexShader != 0 ) {
+            glDeleteShader( vertexShader );
+            }
+        if( fragmentShader != 0 ) {
+            glDeleteShader( fragmentShader );
+            }
+        return;
+        }
+
+    mProgram = glCreateProgram();
+
+    glAttachShader( mProgram, vertexShader );
+    glAttachShader( mProgram, fragmentShader );
+
+    // program holds on to them until it is deleted
+    glDeleteShader( vertexShader );
+    glDeleteShader( fragmentShader );
+
+    for( int i=0; i<inNumAttributes; i++ ) {
+        glBindAttribLocation( mProgram, i + 1, inAttributeNames[i] );
+        }
+
+    glLinkProgram( mProgram );
+
+    GLint linked = GL_FALSE;
+    glGetProgramiv( mProgram, GL_LINK_STATUS, &linked );
+
+    if( linked != GL_TRUE ) {
+        char log[1024];
+        glGetProgramInfoLog( mProgram, sizeof( log ), NULL, log );
+
+        AppLog::errorF( "Failed to link shader program:\n%s", log );
+        return;
+        }
+
+    mLinked = true;
+
+    #endif
+    }
+
+
+
+ShaderProgramGL::~ShaderProgramGL() {
+    #ifdef SHADER_PROGRAM_GL_SHADERS
+    if( mProgram != 0 &&
+        mProgramContext == SingleTextureGL::getContextChangeCount() ) {
+        glDeleteProgram( mProgram );
+        }
+    #endif
+    }
+
+
+
+char ShaderProgramGL::isValid() {
+    return mLinked &&
+        mProgramContext == SingleTextureGL::getContextChangeCount();
+    }
+
+
+
+void ShaderProgramGL::use() {
+    #ifdef SHADER_PROGRAM_GL_SHADERS
+    glUseProgram( mProgram );
+    #endif
+    }
+
+
+
+void ShaderProgramGL::stopUsing() {
+    #ifdef SHADER_PROGRAM_GL_SHADERS
+    glUseProgram( 0 );
+    #endif
+    }
+
+
+
+int ShaderProgramGL::getUniformLocation( const char *inName ) {
+    #ifdef SHADER_PROGRAM_GL_SHADERS
+    return glGetUniformLocation( mProgram, inName );
+    #else
+    return -1;
+    #endif
+    }
+
+
+
+void ShaderProgramGL::setUniform( int inLocation, float inValue ) {
+    #ifdef SHADER_PROGRAM_GL_SHADERS
+    glUniform1f( inLocation, inValue );
+    #endif
+    }
+
+
+
+void ShaderProgramGL::setUniform( int inLocation, int inValue ) {
+    #ifdef SHADER_PROGRAM_GL_SHADERS
+    glUniform1i( inLocation, inValue );
+    #endif
+    }
+
+
+
+void ShaderProgramGL::setAttributeArray( int inLocation, int inSize,
+                                         int inStride,
+                                         const float *inArray ) {
+    #ifdef SHADER_PROGRAM_GL_SHADERS
+    glVertexAttribPointer( inLocation, inSize, GL_FLOAT, GL_FALSE,
+                           inStride, inArray );
+    glEnableVertexAttribArray( inLocation );
+    #endif
+    }
+
+
+
+void ShaderProgramGL::clearAttributeArray( int inLocation ) {
+    #ifdef SHADER_PROGRAM_GL_SHADERS
+    glDisableVertexAttribArray( inLocation );
+    #endif
+    }
@@ -0,0 +1,109 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+
+
+#ifndef SHADER_PROGRAM_GL_INCLUDED
+#define SHADER_PROGRAM_GL_INCLUDED
+
+
+#include "glInclude.h"
+
+
+
+// like vertex buffers, shader functions are called directly, so they are
+// only used where the GL library exports them (not through opengl32 on
+// Windows), and not on GL ES (different shading language) or Mac
+// (different headers)
+#if !defined(WIN_32) && !defined(GLES) && !defined(__mac__)
+#include <GL/glext.h>
+#ifdef GL_VERSION_2_0
+#define SHADER_PROGRAM_GL_SHADERS
+#endif
+#endif
+
+
+
+/**
+ * A GLSL vertex and fragment shader pair, linked into a program.
+ *
+ * Shaders can read the fixed-function client arrays (gl_Vertex,
+ * gl_Color, gl_MultiTexCoord0) set with glVertexPointer and friends,
+ * along with any extra per-vertex attributes named at construction.
+ *
+ * A program only lives as long as the GL context it was made in, so
+ * callers must check isValid before each use and make a new one
+ * after a context change.
+ *
+ * @author Jason Rohrer
+ */
+class ShaderProgramGL {
+
+    public:
+
+        /**
+         * Compiles and links a program.  Compile and link errors are
+         * logged, and leave the program invalid.
+         *
+         * @param inVertexSource, inFragmentSource GLSL source.
+         *   Destroyed by caller.
+         * @param inNumAttributes number of extra per-vertex attributes.
+         * @param inAttributeNames names of extra attributes, which are
+         *   given locations 1, 2, 3, ... in order (0 is gl_Vertex).
+         *   Destroyed by caller.
+         */
+        ShaderProgramGL( const char *inVertexSource,
+                         const char *inFragmentSource,
+                         int inNumAttributes,
+                         const char **inAttributeNames );
+
+        ~ShaderProgramGL();
+
+
+        // true if program linked, and its context is still current
+        char isValid();
+
+
+        // draws with this program until stopUsing is called
+        void use();
+
+        static void stopUsing();
+
+
+        // -1 if program has no such uniform
+        int getUniformLocation( const char *inName );
+
+        // program must be in use
+        static void setUniform( int inLocation, float inValue );
+        static void setUniform( int inLocation, int inValue );
+
+
+        // sets and enables the array for the extra attribute at
+        // inLocation
+        static void setAttributeArray( int inLocation, int inSize,
+                                       int inStride, const float *inArray );
+
+        static void clearAttributeArray( int inLocation );
+
+
+        // true if GLSL programs can be used in current context
+        static char isSupported();
+
+
+    private:
+
+        GLuint mProgram;
+
+        // context change count when mProgram was made
+        int mProgramContext;
+
+        char mLinked;
+    };
+
+
+
+#endif
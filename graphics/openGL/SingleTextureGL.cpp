@@ -21,12 +21,26 @@
  *
  * 2011-January-23   Jason Rohrer
  * Changed internal format of single-channel texture to RGBA for compatibility.
+ *
+ * 2026-October-14   Jason Rohrer
+ * Added sub-rectangle replacement and per-texture filter state, for atlases.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Option to skip edge expansion when constructing from RGBA bytes.
+ * Counts of texture deletions and context changes, for display lists.
+ * Construction from block-compressed textures, with RGBA fallback.
+ * Binding for uploads updates the bound texture cache.
+ * LRU eviction of evictable textures over a residency budget.
+ * Disabling texturing keeps bound texture cache, and counts skipped calls.
+ * Eviction candidates sorted in place with SimpleVector::sort.
  */
 
 
 
 #include "SingleTextureGL.h"
 
+#include <stdlib.h>
+
 
 SimpleVector<SingleTextureGL *> SingleTextureGL::sAllLoadedTextures;
 
@@ -34,12 +48,57 @@ char SingleTextureGL::sTexturingEnabled = false;
 
 GLuint SingleTextureGL::sLastBoundTextureID = 0;
 
+int SingleTextureGL::sContextChangeCount = 0;
+
+int SingleTextureGL::sTextureDeletionCount = 0;
+
+int SingleTextureGL::sS3TCSupported = -1;
+
+int SingleTextureGL::sResidencyBudget = 0;
+int SingleTextureGL::sMaxReloadsPerFrame = 0;
+int SingleTextureGL::sNumReloadsThisFrame = 0;
+unsigned int SingleTextureGL::sCurrentFrame = 0;
+int SingleTextureGL::sResidentEvictableBytes = 0;
+int SingleTextureGL::sNumEvictions = 0;
+double SingleTextureGL::sNumStateCallsIssued = 0;
+double SingleTextureGL::sNumStateCallsSkipped = 0;
+int SingleTextureGL::sNumReloads = 0;
+
+
+
+// not in every gl.h
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+#ifndef GL_TEXTURE_MAX_LEVEL
+#define GL_TEXTURE_MAX_LEVEL 0x813D
+#endif
+
+
+#ifdef WIN_32
+// opengl32.dll only has GL 1.1 functions
+#include <windows.h>
+
+static PFNGLCOMPRESSEDTEXIMAGE2DPROC glCompressedTexImage2DPointer = NULL;
+
+#define glCompressedTexImage2D glCompressedTexImage2DPointer
+#endif
+
 
 
 void SingleTextureGL::contextChanged() {
     // tell all textures to reload
 
     sLastBoundTextureID = 0;
+
+    sContextChangeCount++;
+
+    // new context might have different extensions
+    sS3TCSupported = -1;
     
     int numTextures = sAllLoadedTextures.size();
     
@@ -49,18 +108,199 @@ void SingleTextureGL::contextChanged() {
     for( int i=0; i<numTextures; i++ ) {
         SingleTextureGL *t = *( sAllLoadedTextures.getElement( i ) );
         
-        t->reloadFromBackup();
+        if( t->mResident ) {
+            t->reloadFromBackup();
+            }
+        // evicted textures stay evicted until used
+        }
+    }
+
+
+
+void SingleTextureGL::setResidencyBudget( int inMaxBytes, 
+                                          int inMaxReloadsPerFrame ) {
+    sResidencyBudget = inMaxBytes;
+    sMaxReloadsPerFrame = inMaxReloadsPerFrame;
+    
+    if( sResidencyBudget <= 0 ) {
+        sResidentEvictableBytes = 0;
+        }
+    }
+
+
+
+char SingleTextureGL::reloadEvicted( char inForce ) {
+    if( ! inForce && 
+        sMaxReloadsPerFrame > 0 &&
+        sNumReloadsThisFrame >= sMaxReloadsPerFrame ) {
+        return false;
+        }
+    
+    mResident = true;
+    mLastUsedFrame = sCurrentFrame;
+    
+    reloadFromBackup();
+
+    sNumReloadsThisFrame++;
+    sNumReloads++;
+    
+    return true;
+    }
+
+
+
+void SingleTextureGL::evict() {
+    glDeleteTextures( 1, &mTextureID );
+    
+    if( sLastBoundTextureID == mTextureID ) {
+        sLastBoundTextureID = 0;
+        }
+    
+    mTextureID = 0;
+    mResident = false;
+
+    // display lists that bind this texture are stale now
+    sTextureDeletionCount++;
+
+    sNumEvictions++;
+    }
+
+
+
+typedef struct EvictionCandidate {
+        unsigned int lastUsedFrame;
+        SingleTextureGL *texture;
+        int numBytes;
+    } EvictionCandidate;
+
+
+SIMPLE_VECTOR_TRIVIAL_TYPE( EvictionCandidate )
+
+
+struct LastUsedLess {
+        bool operator()( const EvictionCandidate &inA, 
+                         const EvictionCandidate &inB ) const {
+            return inA.lastUsedFrame < inB.lastUsedFrame;
+            }
+    };
+
+
+static SimpleVector<EvictionCandidate> evictionCandidates;
+
+
+
+void SingleTextureGL::endFrame() {
+    
+    if( sResidencyBudget > 0 ) {
+        
+        int residentBytes = 0;
+        
+        evictionCandidates.shrink( 0 );
+        
+        int numTextures = sAllLoadedTextures.size();
+        
+        for( int i=0; i<numTextures; i++ ) {
+            SingleTextureGL *t = sAllLoadedTextures.getElementDirect( i );
+            
+            if( ! t->mEvictable || ! t->mResident ) {
+                continue;
+                }
+            
+            int numBytes = t->getNumTextureBytes();
+            
+            residentBytes += numBytes;
+            
+            if( t->mLastUsedFrame != sCurrentFrame ) {
+                EvictionCandidate c = { t->mLastUsedFrame, t, numBytes };
+                evictionCandidates.push_back( c );
+                }
+            }
+        
+        if( residentBytes > sResidencyBudget ) {
+            
+            // least recently used first
+            evictionCandidates.sort( LastUsedLess() );
+            
+            int numCandidates = evictionCandidates.size();
+            
+            for( int i=0; i<numCandidates && 
+                     residentBytes > sResidencyBudget; i++ ) {
+                
+                EvictionCandidate *c = 
+                    evictionCandidates.getElementFast( i );
+                
+                c->texture->evict();
+                residentBytes -= c->numBytes;
+                }
+            }
+        
+        sResidentEvictableBytes = residentBytes;
         }
+    
+    sCurrentFrame++;
+    sNumReloadsThisFrame = 0;
+    }
+
+
+
+
+
+int SingleTextureGL::getContextChangeCount() {
+    return sContextChangeCount;
+    }
+
+
+
+int SingleTextureGL::getTextureDeletionCount() {
+    return sTextureDeletionCount;
     }
 
 
 
+char SingleTextureGL::isCompressedFormatSupported( int inFormat ) {
+    if( inFormat != COMPRESSED_TEXTURE_DXT1 &&
+        inFormat != COMPRESSED_TEXTURE_DXT5 ) {
+        return false;
+        }
+
+    if( sS3TCSupported == -1 ) {
+        sS3TCSupported = false;
+
+        const char *extensions = (const char*)glGetString( GL_EXTENSIONS );
+    
+        if( extensions != NULL &&
+            strstr( extensions, "GL_EXT_texture_compression_s3tc" ) 
+            != NULL ) {
+            
+            sS3TCSupported = true;
+            }
+        
+        #ifdef WIN_32
+        glCompressedTexImage2DPointer = 
+            (PFNGLCOMPRESSEDTEXIMAGE2DPROC)
+            wglGetProcAddress( "glCompressedTexImage2D" );
+        
+        if( glCompressedTexImage2DPointer == NULL ) {
+            sS3TCSupported = false;
+            }
+        #endif
+        }
 
+    return sS3TCSupported;
+    }
 
-void SingleTextureGL::disableTexturing() {    
+
+
+void SingleTextureGL::disableTexturing() {
+    // binding survives glDisable, so sLastBoundTextureID stays valid
+    if( !sTexturingEnabled ) {
+        sNumStateCallsSkipped ++;
+        return;
+        }
+    
     glDisable( GL_TEXTURE_2D );
 	sTexturingEnabled = false;
-    sLastBoundTextureID = 0;
+    sNumStateCallsIssued ++;
     }
 
 
@@ -68,7 +308,16 @@ void SingleTextureGL::disableTexturing() {
 
 void SingleTextureGL::reloadFromBackup() {
     
-    if( mBackupBytes != NULL ) {
+    // new texture ID has default filters
+    mLastSetMinFilter = -1;
+    mLastSetMagFilter = -1;
+
+    if( mCompressed != NULL ) {
+        glGenTextures( 1, &mTextureID );
+        
+        setCompressedTextureData();
+        }
+    else if( mBackupBytes != NULL ) {
         
         glGenTextures( 1, &mTextureID );
         
@@ -94,7 +343,15 @@ SingleTextureGL::SingleTextureGL( Image *inImage, char inRepeat,
     : mRepeat( inRepeat ), 
       mMipMap( inMipMap ),
       mAlphaOnly( false ),
-      mBackupBytes( NULL ) {
+      mBackupBytes( NULL ),
+      mCompressed( NULL ),
+      mMipLevels( NULL ),
+      mEvictable( false ),
+      mResident( true ),
+      mLastUsedFrame( sCurrentFrame ) {
+
+    mLastSetMinFilter = -1;
+    mLastSetMagFilter = -1;
 
     glGenTextures( 1, &mTextureID );
     
@@ -115,11 +372,54 @@ SingleTextureGL::SingleTextureGL( Image *inImage, char inRepeat,
 SingleTextureGL::SingleTextureGL( unsigned char *inRGBA, 
                                   unsigned int inWidth, 
                                   unsigned int inHeight,
-                                  char inRepeat, char inMipMap )
+                                  char inRepeat, char inMipMap,
+                                  char inExpandEdge )
     : mRepeat( inRepeat ),
       mMipMap( inMipMap ),
       mAlphaOnly( false ),
-      mBackupBytes( NULL ) {
+      mBackupBytes( NULL ),
+      mCompressed( NULL ),
+      mMipLevels( NULL ),
+      mEvictable( false ),
+      mResident( true ),
+      mLastUsedFrame( sCurrentFrame ) {
+
+    mLastSetMinFilter = -1;
+    mLastSetMagFilter = -1;
+
+    glGenTextures( 1, &mTextureID );
+    
+    int error = glGetError();
+	if( error != GL_NO_ERROR ) {		// error
+		printf( "Error generating new texture ID, error = %d, \"%s\"\n",
+                error, glGetString( error ) );
+        }
+
+
+	setTextureData( inRGBA, mAlphaOnly, inWidth, inHeight, inExpandEdge );
+    
+    sAllLoadedTextures.push_back( this );
+	}
+
+
+
+SingleTextureGL::SingleTextureGL( unsigned char *inRGBA, 
+                                  unsigned int inWidth, 
+                                  unsigned int inHeight,
+                                  char inRepeat, MipChain *inMipLevels,
+                                  char inExpandEdge )
+    : mRepeat( inRepeat ),
+      mMipMap( true ),
+      mAlphaOnly( false ),
+      mBackupBytes( NULL ),
+      mCompressed( NULL ),
+      mMipLevels( inMipLevels ),
+      mEvictable( false ),
+      mResident( true ),
+      mLastUsedFrame( sCurrentFrame ) {
+
+    mLastSetMinFilter = -1;
+    mLastSetMagFilter = -1;
 
     glGenTextures( 1, &mTextureID );
     
@@ -130,7 +430,43 @@ SingleTextureGL::SingleTextureGL( unsigned char *inRGBA,
         }
 
 
-	setTextureData( inRGBA, mAlphaOnly, inWidth, inHeight, true );
+	setTextureData( inRGBA, mAlphaOnly, inWidth, inHeight, inExpandEdge );
+    
+    // caller's, and not kept for reloads
+    mMipLevels = NULL;
+
+    sAllLoadedTextures.push_back( this );
+	}
+
+
+
+SingleTextureGL::SingleTextureGL( CompressedTexture *inTexture, 
+                                  char inRepeat )
+    : mRepeat( inRepeat ),
+      mMipMap( inTexture->getNumLevels() > 1 ),
+      mAlphaOnly( false ),
+      mBackupBytes( NULL ),
+      mCompressed( inTexture ),
+      mMipLevels( NULL ),
+      mEvictable( false ),
+      mResident( true ),
+      mLastUsedFrame( sCurrentFrame ) {
+
+    mLastSetMinFilter = -1;
+    mLastSetMagFilter = -1;
+
+    glGenTextures( 1, &mTextureID );
+    
+    int error = glGetError();
+	if( error != GL_NO_ERROR ) {		// error
+		printf( "Error generating new texture ID, error = %d, \"%s\"\n",
+                error, glGetString( error ) );
+        }
+
+    mWidthBackup = inTexture->getWidth();
+    mHeightBackup = inTexture->getHeight();
+
+    setCompressedTextureData();
     
     sAllLoadedTextures.push_back( this );
 	}
@@ -144,7 +480,15 @@ SingleTextureGL::SingleTextureGL( char inAlphaOnly,
     : mRepeat( inRepeat ),
       mMipMap( inMipMap ),
       mAlphaOnly( true ),
-      mBackupBytes( NULL ) {
+      mBackupBytes( NULL ),
+      mCompressed( NULL ),
+      mMipLevels( NULL ),
+      mEvictable( false ),
+      mResident( true ),
+      mLastUsedFrame( sCurrentFrame ) {
+
+    mLastSetMinFilter = -1;
+    mLastSetMagFilter = -1;
 
     glGenTextures( 1, &mTextureID );
     
@@ -170,12 +514,111 @@ SingleTextureGL::~SingleTextureGL() {
 	sAllLoadedTextures.deleteElementEqualTo( this );
     
     glDeleteTextures( 1, &mTextureID );
+
+    sTextureDeletionCount++;
 	
     if( mBackupBytes != NULL ) {
         delete [] mBackupBytes;
         mBackupBytes = NULL;
         }
     
+    if( mCompressed != NULL ) {
+        delete mCompressed;
+        mCompressed = NULL;
+        }
+    }
+
+
+
+int SingleTextureGL::getNumTextureBytes() {
+    if( mCompressed != NULL &&
+        isCompressedFormatSupported( mCompressed->getFormat() ) ) {
+        return mCompressed->getTotalBytes();
+        }
+    
+    // decoded compressed textures are RGBA too
+    int bytesPerPixel = 4;
+    
+    int numBytes = mWidthBackup * mHeightBackup * bytesPerPixel;
+    
+    if( mCompressed != NULL && mCompressed->getNumLevels() > 1 ) {
+        // smaller levels add a third
+        numBytes += numBytes / 3;
+        }
+    return numBytes;
+    }
+
+
+
+void SingleTextureGL::setCompressedTextureData() {
+    
+    char supported = isCompressedFormatSupported( mCompressed->getFormat() );
+    
+    GLenum internalTexFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    
+    if( mCompressed->getFormat() == COMPRESSED_TEXTURE_DXT1 ) {
+        internalTexFormat = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+        }
+    
+    
+    glBindTexture( GL_TEXTURE_2D, mTextureID );
+
+    // keep enable() from skipping a needed re-bind
+    sLastBoundTextureID = mTextureID;
+
+    int error = glGetError();
+	if( error != GL_NO_ERROR ) {		// error
+		printf( "Error binding to texture id %d, error = %d\n",
+                (int)mTextureID,
+                error );
+        sLastBoundTextureID = 0;
+		}
+    
+	glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+    if( mRepeat ) {
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT );
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT );
+        }
+    else {
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+        }
+
+    int numLevels = mCompressed->getNumLevels();
+
+    #ifndef RASPBIAN
+    // levels stop where file's levels stop
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, numLevels - 1 );
+    #endif
+
+    for( int i=0; i<numLevels; i++ ) {
+        unsigned int w = mCompressed->getLevelWidth( i );
+        unsigned int h = mCompressed->getLevelHeight( i );
+
+        if( supported ) {
+            int length;
+            unsigned char *bytes = mCompressed->getLevelBytes( i, &length );
+            
+            glCompressedTexImage2D( GL_TEXTURE_2D, i, internalTexFormat,
+                                    w, h, 0, length, bytes );
+            }
+        else {
+            unsigned char *rgba = mCompressed->decodeLevel( i );
+            
+            glTexImage2D( GL_TEXTURE_2D, i,
+                          GL_RGBA, w, h, 0,
+                          GL_RGBA, GL_UNSIGNED_BYTE, rgba );
+            
+            delete [] rgba;
+            }
+        }
+
+	error = glGetError();
+	if( error != GL_NO_ERROR ) {		// error
+		printf( "Error setting compressed texture data for id %d, "
+                "error = %d\n",
+                (int)mTextureID, error );
+		}
     }
 
 
@@ -228,155 +671,198 @@ void SingleTextureGL::replaceBackupData( unsigned char *inBytes,
 
 
 
-void SingleTextureGL::setTextureData( unsigned char *inBytes,
-                                      char inAlphaOnly,
-                                      unsigned int inWidth, 
-                                      unsigned int inHeight,
-                                      char inExpandEdge ) {
+char SingleTextureGL::backupMatches( unsigned char *inBytes, 
+                                     char inAlphaOnly,
+                                     unsigned int inX, unsigned int inY,
+                                     unsigned int inWidth, 
+                                     unsigned int inHeight ) {
+    if( mBackupBytes == NULL || inAlphaOnly != mAlphaOnly ||
+        inX + inWidth > mWidthBackup || inY + inHeight > mHeightBackup ) {
+        return false;
+        }
     
-    if( inExpandEdge && !inAlphaOnly ) {
-        
-        unsigned int maxY = 0;
-        unsigned int minY = inHeight - 1;
-        
-        unsigned int maxX = 0;
-        unsigned int minX = inWidth - 1;
-        
-        int aIndex = 3;
-        for( unsigned int y=0; y<inHeight; y++ ) {
-            for( unsigned int x=0; x<inWidth; x++ ) {
-                
-                if( inBytes[ aIndex ] > 0 ) {    
-                    if( x > maxX ) {
-                        maxX = x;
-                        }
-                    if( x < minX ) {
-                        minX = x;
-                        }
-                    if( y > maxY ) {
-                        maxY = y;
-                        }
-                    if( y < minY ) {
-                        minY = y;
-                        }
-                    }
+    int numBytesPerPixel = 4;
+    if( mAlphaOnly ) {
+        numBytesPerPixel = 1;
+        }
 
-                aIndex += 4;
-                }
+    int rowBytes = inWidth * numBytesPerPixel;
+    
+    for( unsigned int y=0; y<inHeight; y++ ) {
+        if( memcmp( &( mBackupBytes[ ( ( inY + y ) * mWidthBackup + inX ) *
+                                     numBytesPerPixel ] ),
+                    &( inBytes[ y * rowBytes ] ),
+                    rowBytes ) != 0 ) {
+            return false;
             }
+        }
+    
+    return true;
+    }
 
-        if( minY < maxY &&
-            minX < maxX &&
-            minY > 0 &&
-            maxY < inHeight - 1 &&  
-            minX > 0 &&
-            maxX < inWidth - 1 ) {
 
-            // found edges away from image edge
 
-            // duplicate them
+void SingleTextureGL::expandEdges( unsigned char *inBytes,
+                                   unsigned int inWidth, 
+                                   unsigned int inHeight ) {
+    
+    unsigned int maxY = 0;
+    unsigned int minY = inHeight - 1;
+    
+    unsigned int maxX = 0;
+    unsigned int minX = inWidth - 1;
+    
+    int aIndex = 3;
+    for( unsigned int y=0; y<inHeight; y++ ) {
+        for( unsigned int x=0; x<inWidth; x++ ) {
             
-            // row edges
+            if( inBytes[ aIndex ] > 0 ) {    
+                if( x > maxX ) {
+                    maxX = x;
+                    }
+                if( x < minX ) {
+                    minX = x;
+                    }
+                if( y > maxY ) {
+                    maxY = y;
+                    }
+                if( y < minY ) {
+                    minY = y;
+                    }
+                }
 
-            int rowBytes = inWidth * 4;
+            aIndex += 4;
+            }
+        }
 
-            int rowStart = minY * rowBytes;
-            int rowDestStart = rowStart - rowBytes;
+    if( minY < maxY &&
+        minX < maxX &&
+        minY > 0 &&
+        maxY < inHeight - 1 &&  
+        minX > 0 &&
+        maxX < inWidth - 1 ) {
 
-            // don't duplicate row unless it has some fully-opaque
-            // pixels in it (it's something of a hard edge)
-            // thus, we don't accidentally expand the soft edges
-            // of feathered sprites, fonts, etc
-            char solidPresent = false;
-            
-            for( int i=rowStart + 3; i<rowStart + rowBytes; i+=4 ) {
-                if( inBytes[i] == 255 ) {
-                    solidPresent = true;
-                    break;
-                    }
-                }
+        // found edges away from image edge
 
-            if( solidPresent ) {
-                memcpy( &( inBytes[ rowDestStart ] ), 
-                        &( inBytes[ rowStart ] ), 
-                        inWidth * 4 );
-                }
-            
-            rowStart = maxY * inWidth * 4;
-            rowDestStart = rowStart + inWidth * 4;
+        // duplicate them
+        
+        // row edges
 
-            solidPresent = false;
+        int rowBytes = inWidth * 4;
 
-            for( int i=rowStart + 3; i<rowStart + rowBytes; i+=4 ) {
-                if( inBytes[i] == 255 ) {
-                    solidPresent = true;
-                    break;
-                    }
+        int rowStart = minY * rowBytes;
+        int rowDestStart = rowStart - rowBytes;
+
+        // don't duplicate row unless it has some fully-opaque
+        // pixels in it (it's something of a hard edge)
+        // thus, we don't accidentally expand the soft edges
+        // of feathered sprites, fonts, etc
+        char solidPresent = false;
+        
+        for( int i=rowStart + 3; i<rowStart + rowBytes; i+=4 ) {
+            if( inBytes[i] == 255 ) {
+                solidPresent = true;
+                break;
                 }
+            }
+
+        if( solidPresent ) {
+            memcpy( &( inBytes[ rowDestStart ] ), 
+                    &( inBytes[ rowStart ] ), 
+                    inWidth * 4 );
+            }
+        
+        rowStart = maxY * inWidth * 4;
+        rowDestStart = rowStart + inWidth * 4;
 
-            if( solidPresent ) {
-                memcpy( &( inBytes[ rowDestStart ] ), 
-                        &( inBytes[ rowStart ] ), 
-                        inWidth * 4 );
+        solidPresent = false;
+
+        for( int i=rowStart + 3; i<rowStart + rowBytes; i+=4 ) {
+            if( inBytes[i] == 255 ) {
+                solidPresent = true;
+                break;
                 }
-            
+            }
+
+        if( solidPresent ) {
+            memcpy( &( inBytes[ rowDestStart ] ), 
+                    &( inBytes[ rowStart ] ), 
+                    inWidth * 4 );
+            }
+        
 
-            // now column edges
+        // now column edges
 
-            char solidPresentLeft = false;
-            char solidPresentRight = false;
-            
-            for( unsigned int y=minY; y<=maxY; y++ ) {
+        char solidPresentLeft = false;
+        char solidPresentRight = false;
+        
+        for( unsigned int y=minY; y<=maxY; y++ ) {
 
-                int iL = (y * inWidth + minX) * 4;
+            int iL = (y * inWidth + minX) * 4;
 
-                if( inBytes[ iL + 3 ] == 255 ) {
-                    solidPresentLeft = true;
-                    break;
-                    }
+            if( inBytes[ iL + 3 ] == 255 ) {
+                solidPresentLeft = true;
+                break;
                 }
-            
-            for( unsigned int y=minY; y<=maxY; y++ ) {
+            }
+        
+        for( unsigned int y=minY; y<=maxY; y++ ) {
 
-                int iR = (y * inWidth + maxX) * 4;
+            int iR = (y * inWidth + maxX) * 4;
 
-                if( inBytes[ iR + 3 ] == 255 ) {
-                    solidPresentRight = true;
-                    break;
-                    }
+            if( inBytes[ iR + 3 ] == 255 ) {
+                solidPresentRight = true;
+                break;
                 }
-            
+            }
+        
 
-            if( solidPresentLeft ) {    
-                for( unsigned int y=minY; y<=maxY; y++ ) {
-                    int iL = (y * inWidth + minX) * 4;
-                    
-                    inBytes[iL - 4] = inBytes[ iL ];
-                    inBytes[iL - 3] = inBytes[ iL + 1 ];
-                    inBytes[iL - 2] = inBytes[ iL + 2 ];
-                    inBytes[iL - 1] = inBytes[ iL + 3 ];
-                    }
+        if( solidPresentLeft ) {    
+            for( unsigned int y=minY; y<=maxY; y++ ) {
+                int iL = (y * inWidth + minX) * 4;
+                
+                inBytes[iL - 4] = inBytes[ iL ];
+                inBytes[iL - 3] = inBytes[ iL + 1 ];
+                inBytes[iL - 2] = inBytes[ iL + 2 ];
+                inBytes[iL - 1] = inBytes[ iL + 3 ];
                 }
+            }
+        
             
-                
 
-            if( solidPresentRight ) {
-                for( unsigned int y=minY; y<=maxY; y++ ) {
-                    int iR = (y * inWidth + maxX) * 4;
-                    inBytes[iR + 4] = inBytes[ iR ];
-                    inBytes[iR + 5] = inBytes[ iR + 1 ];
-                    inBytes[iR + 6] = inBytes[ iR + 2 ];
-                    inBytes[iR + 7] = inBytes[ iR + 3 ];
-                    }
+        if( solidPresentRight ) {
+            for( unsigned int y=minY; y<=maxY; y++ ) {
+                int iR = (y * inWidth + maxX) * 4;
+                inBytes[iR + 4] = inBytes[ iR ];
+                inBytes[iR + 5] = inBytes[ iR + 1 ];
+                inBytes[iR + 6] = inBytes[ iR + 2 ];
+                inBytes[iR + 7] = inBytes[ iR + 3 ];
                 }
-            
             }
         
         }
     
+    
+    }
+
+
+
+void SingleTextureGL::setTextureData( unsigned char *inBytes,
+                                      char inAlphaOnly,
+                                      unsigned int inWidth, 
+                                      unsigned int inHeight,
+                                      char inExpandEdge ) {
+    
+    if( inExpandEdge && !inAlphaOnly ) {
+        expandEdges( inBytes, inWidth, inHeight );
+        }
+    
 
     replaceBackupData( inBytes, inAlphaOnly, inWidth, inHeight );
     
+    if( ! mResident ) {
+        return;
+        }
     
 
     int error;
@@ -392,11 +878,15 @@ void SingleTextureGL::setTextureData( unsigned char *inBytes,
 
 	glBindTexture( GL_TEXTURE_2D, mTextureID );
 
+    // keep enable() from skipping a needed re-bind
+    sLastBoundTextureID = mTextureID;
+
     error = glGetError();
 	if( error != GL_NO_ERROR ) {		// error
 		printf( "Error binding to texture id %d, error = %d\n",
                 (int)mTextureID,
                 error );
+        sLastBoundTextureID = 0;
 		}
     
     
@@ -410,7 +900,28 @@ void SingleTextureGL::setTextureData( unsigned char *inBytes,
         glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
         }
     
-    if( mMipMap ) {
+    if( mMipMap && mMipLevels != NULL && ! inAlphaOnly ) {
+        glTexImage2D( GL_TEXTURE_2D, 0,
+                      internalTexFormat, inWidth,
+                      inHeight, 0,
+                      texDataFormat, GL_UNSIGNED_BYTE, inBytes );
+        
+        int numLevels = mMipLevels->getNumLevels();
+        
+        #ifndef RASPBIAN
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, numLevels );
+        #endif
+
+        for( int i=1; i<=numLevels; i++ ) {
+            unsigned int w, h;
+            unsigned char *level = mMipLevels->getLevel( i, &w, &h );
+            
+            glTexImage2D( GL_TEXTURE_2D, i,
+                          internalTexFormat, w, h, 0,
+                          texDataFormat, GL_UNSIGNED_BYTE, level );
+            }
+        }
+    else if( mMipMap ) {
         // GL_GENERATE_MIPMAP not available on some platforms,
         // like mingw
         // use gluBuild2DMipmaps in that case
@@ -451,8 +962,18 @@ void SingleTextureGL::replaceTextureData( unsigned char *inBytes,
                                           unsigned int inWidth, 
                                           unsigned int inHeight ) {
 
+    if( mCompressed != NULL ) {
+        printf( "Can't replace data in compressed texture id %d\n",
+                (int)mTextureID );
+        return;
+        }
+
     replaceBackupData( inBytes, inAlphaOnly, inWidth, inHeight );
     
+    if( ! mResident ) {
+        // uploaded from backup when used again
+        return;
+        }
 
 
     int error;
@@ -467,11 +988,15 @@ void SingleTextureGL::replaceTextureData( unsigned char *inBytes,
 
     glBindTexture( GL_TEXTURE_2D, mTextureID );
     
+    // keep enable() from skipping a needed re-bind
+    sLastBoundTextureID = mTextureID;
+
     error = glGetError();
 	if( error != GL_NO_ERROR ) {		// error
 		printf( "Error binding to texture id %d, error = %d\n",
                 (int)mTextureID,
                 error );
+        sLastBoundTextureID = 0;
 		}
 
     
@@ -494,3 +1019,73 @@ void SingleTextureGL::replaceTextureData( unsigned char *inBytes,
     }
 
         
+
+
+
+void SingleTextureGL::replaceTextureSubData( unsigned char *inBytes,
+                                             unsigned int inX, 
+                                             unsigned int inY,
+                                             unsigned int inWidth, 
+                                             unsigned int inHeight ) {
+    
+    if( mCompressed != NULL ) {
+        printf( "Can't replace data in compressed texture id %d\n",
+                (int)mTextureID );
+        return;
+        }
+
+    int numBytesPerPixel = 4;
+
+    GLenum texDataFormat = GL_RGBA;
+    
+    if( mAlphaOnly ) {
+        numBytesPerPixel = 1;
+        texDataFormat = GL_ALPHA;
+        }
+
+    if( mBackupBytes != NULL ) {
+        int rowBytes = inWidth * numBytesPerPixel;
+        
+        for( unsigned int y=0; y<inHeight; y++ ) {
+            memcpy( &( mBackupBytes[ ( ( inY + y ) * mWidthBackup + inX ) *
+                                     numBytesPerPixel ] ),
+                    &( inBytes[ y * rowBytes ] ),
+                    rowBytes );
+            }
+        }
+    
+    if( ! mResident ) {
+        return;
+        }
+    
+
+    int error;
+
+    glBindTexture( GL_TEXTURE_2D, mTextureID );
+    
+    // keep enable() from skipping a needed re-bind
+    sLastBoundTextureID = mTextureID;
+    
+    error = glGetError();
+	if( error != GL_NO_ERROR ) {		// error
+		printf( "Error binding to texture id %d, error = %d\n",
+                (int)mTextureID,
+                error );
+        sLastBoundTextureID = 0;
+		}
+
+    glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+    
+    glTexSubImage2D( GL_TEXTURE_2D, 0,
+                     inX, inY,
+                     inWidth, inHeight, 
+                     texDataFormat,
+                     GL_UNSIGNED_BYTE, inBytes );
+
+	error = glGetError();
+	if( error != GL_NO_ERROR ) {		// error
+		printf( "Error replacing texture sub data for id %d, "
+                "error = %d, \"%s\"\n",
+                (int)mTextureID, error, glGetString( error ) );
+		}
+    }
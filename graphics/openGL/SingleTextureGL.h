@@ -25,6 +25,17 @@
  *
  * 2011-January-17   Jason Rohrer
  * Support for single-channel textures for efficiency.
+ *
+ * 2026-October-14   Jason Rohrer
+ * Added sub-rectangle replacement and per-texture filter state, for atlases.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Option to skip edge expansion when constructing from RGBA bytes.
+ * Counts of texture deletions and context changes, for display lists.
+ * Construction from block-compressed textures, with RGBA fallback.
+ * LRU eviction of evictable textures over a residency budget.
+ * Comparison against backup bytes, for sharing identical textures.
+ * Construction with mipmap levels built ahead of time by MipChain.
  */
  
  
@@ -39,6 +50,9 @@
 #include "minorGems/graphics/RGBAImage.h"
 #include "minorGems/util/SimpleVector.h"
 
+#include "CompressedTexture.h"
+#include "MipChain.h"
+
 
  
 /**
@@ -83,11 +97,49 @@ class SingleTextureGL {
 
 		/**
 		 * Specifies texture data as rgba bytes.
+         *
+         * inExpandEdge is passed to setTextureData.  inRGBA may be
+         * modified if it is true.
 		 */
 		SingleTextureGL( unsigned char *inRGBA, 
                          unsigned int inWidth, unsigned int inHeight,
                          char inRepeat = true,
-                         char inMipMap = false );
+                         char inMipMap = false,
+                         char inExpandEdge = true );
+
+
+        /**
+         * Specifies texture data as rgba bytes, with its smaller mipmap
+         * levels built ahead of time (perhaps on another thread), so
+         * the driver doesn't build them in the upload call.
+         *
+         * inMipLevels must have been built from inRGBA after its edges
+         * were expanded, if inExpandEdge is true (expand a copy, since
+         * inRGBA is expanded here).  Destroyed by caller, and can be
+         * destroyed as soon as this constructor returns.
+         *
+         * Levels aren't kept.  Reloads after an eviction or context
+         * change have the driver build them.
+         */
+		SingleTextureGL( unsigned char *inRGBA, 
+                         unsigned int inWidth, unsigned int inHeight,
+                         char inRepeat,
+                         MipChain *inMipLevels,
+                         char inExpandEdge = true );
+
+        
+        /**
+         * Specifies texture data as a block-compressed texture with all
+         * of its mipmap levels (or just one level, for no mipmapping).
+         *
+         * Uploaded as-is if the GL implementation supports the format,
+         * or decoded to RGBA if not.
+         *
+         * @param inTexture the texture.  Destroyed when this class is
+         *   destroyed (kept for reloading after context changes).
+         */
+        SingleTextureGL( CompressedTexture *inTexture, 
+                         char inRepeat = true );
 
         
         /**
@@ -116,6 +168,8 @@ class SingleTextureGL {
          * Dimensions must match original dimensions.
          *
          * Data can contain either RGBA or Alpha-only bytes.
+         *
+         * Not supported for compressed textures.
          */
         void replaceTextureData( unsigned char *inBytes,
                                  char inAlphaOnly,
@@ -123,6 +177,45 @@ class SingleTextureGL {
                                  unsigned int inHeight );
         
 
+        /**
+         * Replaces a sub-rectangle of a texture that's already been set.
+         * 
+         * Data must be in the texture's own format (RGBA, or Alpha-only
+         * if texture was constructed as alpha-only), with inWidth pixels
+         * per row.  Rectangle must fit inside texture.
+         *
+         * Not supported for compressed textures.
+         */
+        void replaceTextureSubData( unsigned char *inBytes,
+                                    unsigned int inX, unsigned int inY,
+                                    unsigned int inWidth, 
+                                    unsigned int inHeight );
+        
+
+        /**
+         * Repeats edge pixels of non-zero alpha region of RGBA data out by
+         * one row/column, in place.  See setTextureData.
+         */
+        static void expandEdges( unsigned char *inBytes,
+                                 unsigned int inWidth, 
+                                 unsigned int inHeight );
+        
+
+        /**
+         * Checks whether a rectangle of this texture's backup bytes
+         * matches data exactly.
+         *
+         * Data is in the same format as replaceTextureSubData.  Edges
+         * of data should already be expanded if the texture's were.
+         *
+         * @return false if they differ, or if texture has no backup
+         *   bytes in that format (compressed textures never do).
+         */
+        char backupMatches( unsigned char *inBytes, char inAlphaOnly,
+                            unsigned int inX, unsigned int inY,
+                            unsigned int inWidth, unsigned int inHeight );
+        
+
 		
 		/**
 		 * Sets the data for this texture.
@@ -170,6 +263,106 @@ class SingleTextureGL {
         // tell all textures about a GL context change so they can reload
         // int texture memory
         static void contextChanged();
+
+
+        // true if compressed textures in inFormat (like 
+        // COMPRESSED_TEXTURE_DXT5) can be uploaded without decoding them
+        static char isCompressedFormatSupported( int inFormat );
+        
+
+        char isCompressed() {
+            return ( mCompressed != NULL );
+            }
+
+
+        char isAlphaOnly() {
+            return mAlphaOnly;
+            }
+        
+
+        // bytes this texture takes up in texture memory (not counting
+        // any mipmaps that GL generates)
+        int getNumTextureBytes();
+        
+
+        // Residency, for textures whose users can cope with them being
+        // missing for a frame, like sprites.
+        //
+        // Evictable textures that haven't been used (see makeResident)
+        // since the last endFrame can be deleted from texture memory
+        // there, least-recently-used first, until the evictable textures
+        // still resident fit in the budget.  Backup bytes are kept, and an
+        // evicted texture is uploaded again by its next makeResident call.
+        //
+        // inMaxBytes of 0 (the default) turns eviction off.
+        // inMaxReloadsPerFrame of 0 means no limit.
+        static void setResidencyBudget( int inMaxBytes, 
+                                        int inMaxReloadsPerFrame );
+        
+        // textures are not evictable unless set
+        void setEvictable( char inEvictable ) {
+            mEvictable = inEvictable;
+            }
+        
+
+        // marks texture as used this frame, uploading it again if it
+        // was evicted
+        // returns false if texture is evicted and this frame's reloads
+        // are used up, in which case it shouldn't be drawn this frame
+        char makeResident() {
+            mLastUsedFrame = sCurrentFrame;
+            
+            if( mResident ) {
+                return true;
+                }
+            return reloadEvicted( false );
+            }
+        
+
+        char isResident() {
+            return mResident;
+            }
+        
+
+        // evicts textures if over budget, then starts a new frame
+        // anything queued for drawing with textures must already be drawn
+        static void endFrame();
+        
+
+        // bytes in resident evictable textures as of last endFrame
+        // only counted while a budget is set
+        static int getResidentEvictableBytes() {
+            return sResidentEvictableBytes;
+            }
+        
+        // since startup
+        static int getNumEvictions() {
+            return sNumEvictions;
+            }
+        
+        static int getNumReloads() {
+            return sNumReloads;
+            }
+        
+
+        // texturing enable and bind calls issued, and skipped because
+        // they wouldn't change anything, since startup
+        static double getNumStateCallsIssued() {
+            return sNumStateCallsIssued;
+            }
+        
+        static double getNumStateCallsSkipped() {
+            return sNumStateCallsSkipped;
+            }
+        
+
+        // number of times contextChanged has been called, so holders of
+        // other GL objects, like display lists, can tell they were lost
+        static int getContextChangeCount();
+
+        // number of times a texture has been destroyed, so holders of
+        // display lists that bind textures can tell when to remake them
+        static int getTextureDeletionCount();
         
 
         // disable texturing globally
@@ -179,6 +372,13 @@ class SingleTextureGL {
         // is enabled.
         static void disableTexturing();
         
+
+        // filter state last set into this texture by its users 
+        // (like SpriteGL), so redundant glTexParameter calls can be skipped
+        // -1 means unset, and reset to -1 whenever texture is reloaded
+        int mLastSetMinFilter;
+        int mLastSetMagFilter;
+        
 		
 	private:
         char mRepeat;
@@ -193,9 +393,31 @@ class SingleTextureGL {
         unsigned char *mBackupBytes;
         unsigned int mWidthBackup;
         unsigned int mHeightBackup;
+
+        // instead of backup bytes, for compressed textures
+        CompressedTexture *mCompressed;
+        
+        // levels for setTextureData to upload instead of having the
+        // driver build them, only set during construction
+        MipChain *mMipLevels;
+        
+        char mEvictable;
+        
+        // false if evicted (mTextureID is 0)
+        char mResident;
+        
+        unsigned int mLastUsedFrame;
         
         void reloadFromBackup();
         
+        // makes an evicted texture resident again
+        // inForce ignores per-frame reload limit
+        char reloadEvicted( char inForce );
+        
+        void evict();
+        
+        void setCompressedTextureData();
+        
         void replaceBackupData( unsigned char *inBytes,
                                 char inAlphaOnly,
                                 unsigned int inWidth, 
@@ -207,6 +429,23 @@ class SingleTextureGL {
         static char sTexturingEnabled;
 
         static GLuint sLastBoundTextureID;
+
+        static int sContextChangeCount;
+        
+        static int sTextureDeletionCount;
+        
+        // -1 until checked in current context
+        static int sS3TCSupported;
+
+        static int sResidencyBudget;
+        static int sMaxReloadsPerFrame;
+        static int sNumReloadsThisFrame;
+        static unsigned int sCurrentFrame;
+        static int sResidentEvictableBytes;
+        static int sNumEvictions;
+        static int sNumReloads;
+        static double sNumStateCallsIssued;
+        static double sNumStateCallsSkipped;
 	};
 
 
@@ -221,12 +460,19 @@ inline void SingleTextureGL::enable() {
     if( !sTexturingEnabled ) {    
         glEnable( GL_TEXTURE_2D );
         sTexturingEnabled = true;
+        sNumStateCallsIssued ++;
+        }
+    
+    if( !mResident ) {
+        // enabled without makeResident, can't skip drawing
+        reloadEvicted( true );
         }
     
     if( sLastBoundTextureID != mTextureID ) {
         glBindTexture( GL_TEXTURE_2D, mTextureID ); 
         
         sLastBoundTextureID = mTextureID;
+        sNumStateCallsIssued ++;
         
         int error = glGetError();
         if( error != GL_NO_ERROR ) {		// error
@@ -235,6 +481,9 @@ inline void SingleTextureGL::enable() {
             sLastBoundTextureID = -1;
             }
         }
+    else {
+        sNumStateCallsSkipped ++;
+        }
     
 	}
 	
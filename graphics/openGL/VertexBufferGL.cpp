@@ -0,0 +1,283 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+
+
+#include "VertexBufferGL.h"
+#include "SingleTextureGL.h"
+
+#include <string.h>
+
+
+
+#ifdef VERTEX_BUFFER_GL_VBOS
+
+// glext.h only declares these with GL_GLEXT_PROTOTYPES, which may
+// not have been defined where it was first included
+extern "C" {
+GLAPI void APIENTRY glBindBufferARB( GLenum, GLuint );
+GLAPI void APIENTRY glDeleteBuffersARB( GLsizei, const GLuint * );
+GLAPI void APIENTRY glGenBuffersARB( GLsizei, GLuint * );
+GLAPI void APIENTRY glBufferDataARB( GLenum, GLsizeiptrARB,
+                                     const void *, GLenum );
+GLAPI void APIENTRY glBufferSubDataARB( GLenum, GLintptrARB,
+                                        GLsizeiptrARB, const void * );
+}
+
+#endif
+
+
+
+char VertexBufferGL::sStreaming = false;
+
+GLuint VertexBufferGL::sStreamBuffer = 0;
+int VertexBufferGL::sStreamContext = -1;
+int VertexBufferGL::sStreamOffset = 0;
+
+char VertexBufferGL::sBufferBound = false;
+char VertexBufferGL::sColorArraySet = false;
+
+
+// context change count when support was last checked
+static int supportCheckedContext = -1;
+static char supported = false;
+
+
+
+char VertexBufferGL::isSupported() {
+    #ifdef VERTEX_BUFFER_GL_VBOS
+        int context = SingleTextureGL::getContextChangeCount();
+
+        if( supportCheckedContext != context ) {
+            const char *extensions = (const char *)glGetString(
+                GL_EXTENSIONS );
+
+            // NULL if there is no active screen yet, so check again later
+            if( extensions != NULL ) {
+                supported =
+                    ( strstr( extensions, "GL_ARB_vertex_buffer_object" )
+                      != NULL );
+                supportCheckedContext = context;
+                }
+            }
+        return supported;
+    #else
+        return false;
+    #endif
+    }
+
+
+
+VertexBufferGL::VertexBufferGL( int inNumVertices, float *inVertices,
+                                float *inColors )
+        : mNumVertices( inNumVertices ),
+          mColorOffset( -1 ),
+          mBuffer( 0 ),
+          mBufferContext( -1 ) {
+
+    int numFloats = 2 * inNumVertices;
+
+    if( inColors != NULL ) {
+        mColorOffset = numFloats;
+        numFloats += 4 * inNumVertices;
+        }
+
+    mData = new float[ numFloats ];
+
+    replaceData( inVertices, inColors );
+    }
+
+
+
+VertexBufferGL::~VertexBufferGL() {
+    #ifdef VERTEX_BUFFER_GL_VBOS
+    if( mBuffer != 0 &&
+        mBufferContext == SingleTextureGL::getContextChangeCount() ) {
+        glDeleteBuffersARB( 1, &mBuffer );
+        }
+    #endif
+
+    delete [] mData;
+    }
+
+
+
+void VertexBufferGL::replaceData( float *inVertices, float *inColors ) {
+    memcpy( mData, inVertices, 2 * mNumVertices * sizeof( float ) );
+
+    if( mColorOffset != -1 && inColors != NULL ) {
+        memcpy( &( mData[ mColorOffset ] ), inColors,
+                4 * mNumVertices * sizeof( float ) );
+        }
+
+    if( isSupported() ) {
+        upload();
+        }
+    }
+
+
+
+void VertexBufferGL::upload() {
+    #ifdef VERTEX_BUFFER_GL_VBOS
+
+    int context = SingleTextureGL::getContextChangeCount();
+
+    if( mBuffer == 0 || mBufferContext != context ) {
+        // old buffer, if any, went away with old context
+        glGenBuffersARB( 1, &mBuffer );
+        mBufferContext = context;
+        }
+
+    int numFloats = 2 * mNumVertices;
+    if( mColorOffset != -1 ) {
+        numFloats += 4 * mNumVertices;
+        }
+
+    glBindBufferARB( GL_ARRAY_BUFFER_ARB, mBuffer );
+    glBufferDataARB( GL_ARRAY_BUFFER_ARB, numFloats * sizeof( float ),
+                     mData, GL_STATIC_DRAW_ARB );
+    glBindBufferARB( GL_ARRAY_BUFFER_ARB, 0 );
+
+    #endif
+    }
+
+
+
+void VertexBufferGL::setArrays() {
+
+    glEnableClientState( GL_VERTEX_ARRAY );
+
+    if( mColorOffset != -1 ) {
+        glEnableClientState( GL_COLOR_ARRAY );
+        sColorArraySet = true;
+        }
+
+    #ifdef VERTEX_BUFFER_GL_VBOS
+    if( isSupported() ) {
+
+        if( mBufferContext != SingleTextureGL::getContextChangeCount() ) {
+            upload();
+            }
+
+        glBindBufferARB( GL_ARRAY_BUFFER_ARB, mBuffer );
+        sBufferBound = true;
+
+        // pointers are offsets into bound buffer
+        glVertexPointer( 2, GL_FLOAT, 0, (void *)0 );
+
+        if( mColorOffset != -1 ) {
+            glColorPointer( 4, GL_FLOAT, 0,
+                            (void *)( mColorOffset * sizeof( float ) ) );
+            }
+        return;
+        }
+    #endif
+
+    glVertexPointer( 2, GL_FLOAT, 0, mData );
+
+    if( mColorOffset != -1 ) {
+        glColorPointer( 4, GL_FLOAT, 0, &( mData[ mColorOffset ] ) );
+        }
+    }
+
+
+
+void VertexBufferGL::clearArrays() {
+    #ifdef VERTEX_BUFFER_GL_VBOS
+    if( sBufferBound ) {
+        glBindBufferARB( GL_ARRAY_BUFFER_ARB, 0 );
+        sBufferBound = false;
+        }
+    #endif
+
+    glDisableClientState( GL_VERTEX_ARRAY );
+
+    if( sColorArraySet ) {
+        glDisableClientState( GL_COLOR_ARRAY );
+        sColorArraySet = false;
+        }
+    }
+
+
+
+void VertexBufferGL::toggleStreaming( char inStream ) {
+    sStreaming = inStream;
+    }
+
+
+
+void VertexBufferGL::streamArrays( int inNumVertices, float *inVertices,
+                                   float *inColors ) {
+
+    glEnableClientState( GL_VERTEX_ARRAY );
+
+    if( inColors != NULL ) {
+        glEnableClientState( GL_COLOR_ARRAY );
+        sColorArraySet = true;
+        }
+
+    #ifdef VERTEX_BUFFER_GL_VBOS
+
+    int vertexBytes = inNumVertices * 2 * sizeof( float );
+    int colorBytes = 0;
+    if( inColors != NULL ) {
+        colorBytes = inNumVertices * 4 * sizeof( float );
+        }
+
+    if( sStreaming && isSupported() &&
+        vertexBytes + colorBytes <= VERTEX_BUFFER_GL_STREAM_BYTES ) {
+
+        int context = SingleTextureGL::getContextChangeCount();
+
+        if( sStreamBuffer == 0 || sStreamContext != context ) {
+            glGenBuffersARB( 1, &sStreamBuffer );
+            sStreamContext = context;
+
+            glBindBufferARB( GL_ARRAY_BUFFER_ARB, sStreamBuffer );
+            glBufferDataARB( GL_ARRAY_BUFFER_ARB,
+                             VERTEX_BUFFER_GL_STREAM_BYTES,
+                             NULL, GL_STREAM_DRAW_ARB );
+            sStreamOffset = 0;
+            }
+        else {
+            glBindBufferARB( GL_ARRAY_BUFFER_ARB, sStreamBuffer );
+            }
+
+        if( sStreamOffset + vertexBytes + colorBytes >
+            VERTEX_BUFFER_GL_STREAM_BYTES ) {
+            // wrap around
+            // orphan old storage, so we don't wait for draws still
+            // reading from it
+            glBufferDataARB( GL_ARRAY_BUFFER_ARB,
+                             VERTEX_BUFFER_GL_STREAM_BYTES,
+                             NULL, GL_STREAM_DRAW_ARB );
+            sStreamOffset = 0;
+            }
+
+        glBufferSubDataARB( GL_ARRAY_BUFFER_ARB, sStreamOffset,
+                            vertexBytes, inVertices );
+        glVertexPointer( 2, GL_FLOAT, 0, (void *)(long)sStreamOffset );
+        sStreamOffset += vertexBytes;
+
+        if( inColors != NULL ) {
+            glBufferSubDataARB( GL_ARRAY_BUFFER_ARB, sStreamOffset,
+                                colorBytes, inColors );
+            glColorPointer( 4, GL_FLOAT, 0, (void *)(long)sStreamOffset );
+            sStreamOffset += colorBytes;
+            }
+
+        sBufferBound = true;
+        return;
+        }
+    #endif
+
+    glVertexPointer( 2, GL_FLOAT, 0, inVertices );
+
+    if( inColors != NULL ) {
+        glColorPointer( 4, GL_FLOAT, 0, inColors );
+        }
+    }
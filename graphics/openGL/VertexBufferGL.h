@@ -0,0 +1,139 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+
+
+#ifndef VERTEX_BUFFER_GL_INCLUDED
+#define VERTEX_BUFFER_GL_INCLUDED
+
+
+#include "glInclude.h"
+
+
+
+// vertex buffers are called directly, so they are only used where
+// the GL library exports them (not through opengl32 on Windows), and
+// not on GL ES (different names) or Mac (different headers)
+#if !defined(WIN_32) && !defined(GLES) && !defined(__mac__)
+#include <GL/glext.h>
+#ifdef GL_ARB_vertex_buffer_object
+#define VERTEX_BUFFER_GL_VBOS
+#endif
+#endif
+
+
+
+// size of ring that streamed vertices are copied through
+#define VERTEX_BUFFER_GL_STREAM_BYTES 1048576
+
+
+
+/**
+ * 2D float vertices, with optional RGBA float colors, for
+ * glDrawArrays with client-state arrays.
+ *
+ * A VertexBufferGL keeps its vertices in a vertex buffer object (in GPU
+ * memory), so that geometry drawn every frame isn't sent to the GPU every
+ * frame.  A copy is kept, for reloading after GL context changes and for
+ * GL implementations without vertex buffer objects.
+ *
+ * The static stream functions copy one draw's worth of caller-owned
+ * vertices into a shared ring of vertex buffer space, if streaming is on.
+ *
+ * Either way, arrays are set with setArrays and must be cleared with
+ * clearArrays after drawing, because client-state drawing done while a
+ * buffer is still bound would read from the buffer.
+ *
+ * @author Jason Rohrer
+ */
+class VertexBufferGL {
+
+    public:
+
+        /**
+         * @param inNumVertices the number of vertices.
+         * @param inVertices x,y pairs.  Copied internally.
+         * @param inColors r,g,b,a for each vertex, or NULL to draw with
+         *   the current color.  Copied internally.
+         */
+        VertexBufferGL( int inNumVertices, float *inVertices,
+                        float *inColors );
+
+        ~VertexBufferGL();
+
+
+        // replaces all vertices
+        // inColors ignored if buffer was made without colors
+        void replaceData( float *inVertices, float *inColors );
+
+
+        int getNumVertices() {
+            return mNumVertices;
+            }
+
+        char hasColors() {
+            return ( mColorOffset != -1 );
+            }
+
+
+        // enables client states and sets pointers for drawing
+        void setArrays();
+
+
+        // disables client states set by setArrays or streamArrays
+        static void clearArrays();
+
+
+
+        // streaming defaults to off (client arrays passed straight to GL)
+        static void toggleStreaming( char inStream );
+
+
+        // enables client states and sets pointers for one draw, copying
+        // vertices into the stream ring if streaming is on and supported
+        // inColors can be NULL
+        static void streamArrays( int inNumVertices, float *inVertices,
+                                  float *inColors );
+
+
+        // true if vertex buffer objects are in use
+        static char isSupported();
+
+
+    private:
+
+        int mNumVertices;
+
+        // vertices, then colors
+        float *mData;
+
+        // in floats, -1 if no colors
+        int mColorOffset;
+
+        GLuint mBuffer;
+
+        // context change count when mBuffer was made
+        int mBufferContext;
+
+        void upload();
+
+
+        static char sStreaming;
+
+        static GLuint sStreamBuffer;
+        static int sStreamContext;
+        static int sStreamOffset;
+
+        // true if last set arrays came from a buffer
+        static char sBufferBound;
+
+        static char sColorArraySet;
+    };
+
+
+
+#endif
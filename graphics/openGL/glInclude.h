@@ -18,6 +18,8 @@
 #define glGetDoublev glGetFloatv
 #define GL_SOURCE0_RGB GL_SRC0_RGB
 #define GL_SOURCE0_ALPHA GL_SRC0_ALPHA
+#define GL_SOURCE1_RGB GL_SRC1_RGB
+#define GL_SOURCE1_ALPHA GL_SRC1_ALPHA
 
 // regular mesa-supplied GLU should work
 #include <GL/glu.h>
@@ -18,6 +18,10 @@
  *
  * 2009-December-28    Jason Rohrer
  * Added support for locking focus.
+ *
+ * 2026-October-15    Jason Rohrer
+ * Added parent links, invalidation, and hit bounds, for containers that
+ * retain what they draw and sort components by position.
  */
  
  
@@ -33,6 +37,8 @@
 // for key codes
 #include "minorGems/graphics/openGL/KeyboardHandlerGL.h"
 
+#include <stddef.h>
+
 
 /**
  * A base class for all OpenGL GUI components.
@@ -114,6 +120,58 @@ class GUIComponentGL : public GUIComponent, public RedrawListenerGL {
 		 */
 		virtual char isInside( double inX, double inY );
 
+
+        
+        /**
+         * Gets the rectangle that isInside tests against.
+         *
+         * Subclasses that override isInside to cover a different area
+         * must override this too.
+         *
+         * @param outX, outY, outWidth, outHeight pointers to where the
+         *   upper left corner and size of the rectangle should be returned.
+         */
+        virtual void getHitBounds( double *outX, double *outY,
+                                   double *outWidth, double *outHeight );
+
+
+        
+        /**
+         * Marks this component as needing to be drawn again, for
+         * containers that retain what they draw (see
+         * GUIContainerGL::setRetainedRedraw).
+         *
+         * Components call this when their appearance changes outside of
+         * an input event, like when their text is set.  Input events
+         * passed down through a container already mark it.
+         *
+         * The default implementation passes the call up to this
+         * component's container, if any.
+         */
+        virtual void invalidate();
+
+
+        
+        /**
+         * Like invalidate, but also marks the positions of components as
+         * changed, for containers that sort components by position.
+         *
+         * Called by setPosition.  The default implementation passes the
+         * call up to this component's container, if any.
+         */
+        virtual void invalidateLayout();
+
+
+        
+        /**
+         * Sets the container of this component.
+         *
+         * Called by GUIContainerGL when adding and removing components.
+         *
+         * @param inParent the container, or NULL.
+         */
+        void setParent( GUIComponentGL *inParent );
+
 		
 
 		/**
@@ -198,6 +256,8 @@ class GUIComponentGL : public GUIComponent, public RedrawListenerGL {
         char mEnabled;
 
         char mFocusLocked;
+
+        GUIComponentGL *mParent;
         
 		
 	};
@@ -210,7 +270,8 @@ inline GUIComponentGL::GUIComponentGL(
 	: mAnchorX( inAnchorX ), mAnchorY( inAnchorY ), mWidth( inWidth ),
 	  mHeight( inHeight ),
       mEnabled( true ),
-      mFocusLocked( false ) {
+      mFocusLocked( false ),
+      mParent( NULL ) {
 
 	}
 
@@ -228,12 +289,17 @@ inline void GUIComponentGL::setPosition(
     mAnchorY = inAnchorY;
     mWidth = inWidth;
     mHeight = inHeight;
+
+    invalidateLayout();
     }
 
 
 
 inline void GUIComponentGL::setEnabled( char inEnabled ) {
-    mEnabled = inEnabled;
+    if( mEnabled != inEnabled ) {
+        mEnabled = inEnabled;
+        invalidate();
+        }
     }
 
 
@@ -255,6 +321,39 @@ inline char GUIComponentGL::isInside( double inX, double inY ) {
 		}
 	}
 
+
+
+inline void GUIComponentGL::getHitBounds( double *outX, double *outY,
+                                          double *outWidth,
+                                          double *outHeight ) {
+    *outX = mAnchorX;
+    *outY = mAnchorY;
+    *outWidth = mWidth;
+    *outHeight = mHeight;
+    }
+
+
+
+inline void GUIComponentGL::invalidate() {
+    if( mParent != NULL ) {
+        mParent->invalidate();
+        }
+    }
+
+
+
+inline void GUIComponentGL::invalidateLayout() {
+    if( mParent != NULL ) {
+        mParent->invalidateLayout();
+        }
+    }
+
+
+
+inline void GUIComponentGL::setParent( GUIComponentGL *inParent ) {
+    mParent = inParent;
+    }
+
 		
 
 inline void GUIComponentGL::mouseMoved( double inX, double inY ) {
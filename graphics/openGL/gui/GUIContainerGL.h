@@ -35,6 +35,10 @@
  *
  * 2010-April-9		Jason Rohrer
  * Fixed crash when components removed by a mouse event.
+ *
+ * 2026-October-15    Jason Rohrer
+ * Press events find components through a grid, by position.
+ * Optional retained redraw through a display list.
  */
  
  
@@ -44,6 +48,22 @@
 #include "GUIComponentGL.h"
 #include "minorGems/util/SimpleVector.h"
 
+#include "minorGems/graphics/openGL/glInclude.h"
+#include "minorGems/graphics/openGL/SingleTextureGL.h"
+
+#include <math.h>
+#include <string.h>
+
+
+// cells across and down in the grid used to find pressed components
+#define GUI_CONTAINER_GL_GRID_SIZE 16
+
+// with retained redraw, how many times components must draw the same thing
+// before it is recorded
+// gives components a chance to make anything they make lazily, like
+// TextGL string textures, outside of the recording
+#define GUI_CONTAINER_GL_REDRAWS_BEFORE_RECORD 2
+
 
 
 /**
@@ -114,6 +134,33 @@ class GUIContainerGL : public GUIComponentGL {
          */
         virtual char contains( GUIComponentGL *inComponent );
 
+
+        
+        /**
+         * Sets whether this container retains what its components draw,
+         * so it can draw it again without visiting them.
+         *
+         * Once components have drawn the same thing a few times in a row,
+         * they are recorded into a display list, and the list is replayed
+         * until this container is invalidated or passes on an input event.
+         * This saves the per-component cost of big, mostly static panels.
+         *
+         * Components must call invalidate when their appearance changes
+         * outside of input events, and must not draw anything that changes
+         * over time by itself (like animations).
+         *
+         * Ignored on platforms without display lists (OpenGL ES).
+         * Defaults to off.
+         *
+         * @param inRetained true to retain drawing.
+         */
+        void setRetainedRedraw( char inRetained );
+
+
+        // override functions in GUIComponentGL
+        virtual void invalidate();
+        virtual void invalidateLayout();
+
         
 		
 		// the implementations below delegate events to appropriate
@@ -139,7 +186,49 @@ class GUIContainerGL : public GUIComponentGL {
         
         // flags to track components in which a press started
         SimpleVector<char> *mPressStartedHereVector;
+
+
+        // grid of component indices, by the cells their hit bounds
+        // touch, rebuilt on the next press after a layout change
+        // indices for cell c are in mGridIndices, from
+        // mGridCellStarts[c] up to mGridCellStarts[c+1]
+        char mGridDirty;
+        int mGridCellStarts[ GUI_CONTAINER_GL_GRID_SIZE *
+                             GUI_CONTAINER_GL_GRID_SIZE + 1 ];
+        int *mGridIndices;
+        int mGridIndicesSize;
+
+        // where the grid was when it was built
+        double mGridX, mGridY;
+        double mGridCellWidth, mGridCellHeight;
+
+        // increases whenever a component is added or removed
+        int mComponentChangeCount;
+
+
+        char mRetainedRedraw;
+        char mRedrawDirty;
+        
+        // redraws since last marked dirty
+        int mUnchangedRedraws;
         
+        GLuint mDisplayList;
+        char mDisplayListRecorded;
+        
+        // SingleTextureGL counts when list was made
+        int mDisplayListContext;
+        int mDisplayListTextureDeletions;
+
+
+        void buildGrid();
+
+        // gets the range of grid cells covering a span
+        void getGridCellRange( double inStart, double inLength,
+                               double inGridStart, double inCellLength,
+                               int *outFirst, int *outLast );
+
+        // draws all components
+        void drawComponents();
 				
 
 	};
@@ -151,7 +240,19 @@ inline GUIContainerGL::GUIContainerGL(
 	double inHeight )
 	: GUIComponentGL( inAnchorX, inAnchorY, inWidth, inHeight ),
 	  mComponentVector( new SimpleVector<GUIComponentGL*>() ),
-      mPressStartedHereVector( new SimpleVector<char>() ) {
+      mPressStartedHereVector( new SimpleVector<char>() ),
+      mGridDirty( true ),
+      mGridIndices( NULL ), mGridIndicesSize( 0 ),
+      mGridX( 0 ), mGridY( 0 ),
+      mGridCellWidth( 1 ), mGridCellHeight( 1 ),
+      mComponentChangeCount( 0 ),
+      mRetainedRedraw( false ),
+      mRedrawDirty( true ),
+      mUnchangedRedraws( 0 ),
+      mDisplayList( 0 ),
+      mDisplayListRecorded( false ),
+      mDisplayListContext( 0 ),
+      mDisplayListTextureDeletions( 0 ) {
 
 	}
 
@@ -166,6 +267,12 @@ inline GUIContainerGL::~GUIContainerGL() {
 	
 	delete mComponentVector;
     delete mPressStartedHereVector;
+
+    if( mGridIndices != NULL ) {
+        delete [] mGridIndices;
+        }
+
+    setRetainedRedraw( false );
 	}
 
 
@@ -173,6 +280,10 @@ inline GUIContainerGL::~GUIContainerGL() {
 inline void GUIContainerGL::add( GUIComponentGL *inComponent ) {
 	mComponentVector->push_back( inComponent );
 	mPressStartedHereVector->push_back( false );
+
+    inComponent->setParent( this );
+    mComponentChangeCount++;
+    invalidateLayout();
     }
 
 
@@ -184,6 +295,10 @@ inline char GUIContainerGL::remove( GUIComponentGL *inComponent ) {
         
         mComponentVector->deleteElement( index );
         mPressStartedHereVector->deleteElement( index );
+
+        inComponent->setParent( NULL );
+        mComponentChangeCount++;
+        invalidateLayout();
         return true;
         }
     return false;
@@ -204,7 +319,166 @@ inline char GUIContainerGL::contains( GUIComponentGL *inComponent ) {
 
 
 
+inline void GUIContainerGL::setRetainedRedraw( char inRetained ) {
+    mRetainedRedraw = inRetained;
+    mRedrawDirty = true;
+
+    #ifdef GL_COMPILE_AND_EXECUTE
+    if( !mRetainedRedraw && mDisplayList != 0 ) {
+        if( mDisplayListContext == 
+            SingleTextureGL::getContextChangeCount() ) {
+            glDeleteLists( mDisplayList, 1 );
+            }
+        mDisplayList = 0;
+        mDisplayListRecorded = false;
+        }
+    #endif
+    }
+
+
+
+inline void GUIContainerGL::invalidate() {
+    mRedrawDirty = true;
+    
+    GUIComponentGL::invalidate();
+    }
+
+
+
+inline void GUIContainerGL::invalidateLayout() {
+    // our own position, or that of a component, changed
+    mGridDirty = true;
+    mRedrawDirty = true;
+    
+    GUIComponentGL::invalidateLayout();
+    }
+
+
+
+inline void GUIContainerGL::getGridCellRange( double inStart, 
+                                              double inLength,
+                                              double inGridStart, 
+                                              double inCellLength,
+                                              int *outFirst, int *outLast ) {
+    double first = floor( ( inStart - inGridStart ) / inCellLength );
+    double last = 
+        floor( ( inStart + inLength - inGridStart ) / inCellLength );
+
+    // anything off the edges of the grid goes in the edge cells,
+    // so components and presses outside our bounds are still found
+    if( first < 0 ) {
+        first = 0;
+        }
+    if( last > GUI_CONTAINER_GL_GRID_SIZE - 1 ) {
+        last = GUI_CONTAINER_GL_GRID_SIZE - 1;
+        }
+    if( ! ( first <= last ) ) {
+        // entirely off one edge
+        if( inStart + inLength < inGridStart ) {
+            first = 0;
+            }
+        else {
+            first = GUI_CONTAINER_GL_GRID_SIZE - 1;
+            }
+        last = first;
+        }
+
+    *outFirst = (int)first;
+    *outLast = (int)last;
+    }
+
+
+
+inline void GUIContainerGL::buildGrid() {
+    int numCells = GUI_CONTAINER_GL_GRID_SIZE * GUI_CONTAINER_GL_GRID_SIZE;
+    
+    mGridX = mAnchorX;
+    mGridY = mAnchorY;
+    mGridCellWidth = mWidth / GUI_CONTAINER_GL_GRID_SIZE;
+    mGridCellHeight = mHeight / GUI_CONTAINER_GL_GRID_SIZE;
+
+    if( ! ( mGridCellWidth > 0 ) ) {
+        mGridCellWidth = 1;
+        }
+    if( ! ( mGridCellHeight > 0 ) ) {
+        mGridCellHeight = 1;
+        }
+    
+    int numComponents = mComponentVector->size();
+
+    int *firstX = new int[ numComponents ];
+    int *lastX = new int[ numComponents ];
+    int *firstY = new int[ numComponents ];
+    int *lastY = new int[ numComponents ];
+    
+    
+    // count components in each cell
+    for( int c=0; c<=numCells; c++ ) {
+        mGridCellStarts[c] = 0;
+        }
+    
+    for( int i=0; i<numComponents; i++ ) {
+        GUIComponentGL *component = 
+            mComponentVector->getElementDirectFast( i );
+        
+        double x, y, w, h;
+        component->getHitBounds( &x, &y, &w, &h );
+        
+        getGridCellRange( x, w, mGridX, mGridCellWidth,
+                          &( firstX[i] ), &( lastX[i] ) );
+        getGridCellRange( y, h, mGridY, mGridCellHeight,
+                          &( firstY[i] ), &( lastY[i] ) );
+
+        for( int cy=firstY[i]; cy<=lastY[i]; cy++ ) {
+            for( int cx=firstX[i]; cx<=lastX[i]; cx++ ) {
+                mGridCellStarts[ cy * GUI_CONTAINER_GL_GRID_SIZE + cx + 1 ]++;
+                }
+            }
+        }
+    
+    for( int c=0; c<numCells; c++ ) {
+        mGridCellStarts[c+1] += mGridCellStarts[c];
+        }
+    
+    int total = mGridCellStarts[ numCells ];
+
+    if( total > mGridIndicesSize ) {
+        if( mGridIndices != NULL ) {
+            delete [] mGridIndices;
+            }
+        mGridIndices = new int[ total ];
+        mGridIndicesSize = total;
+        }
+    
+
+    // fill cells in index order, so presses are passed on in the 
+    // same order as before
+    int *nextInCell = new int[ numCells ];
+    memcpy( nextInCell, mGridCellStarts, numCells * sizeof( int ) );
+    
+    for( int i=0; i<numComponents; i++ ) {
+        for( int cy=firstY[i]; cy<=lastY[i]; cy++ ) {
+            for( int cx=firstX[i]; cx<=lastX[i]; cx++ ) {
+                int c = cy * GUI_CONTAINER_GL_GRID_SIZE + cx;
+                mGridIndices[ nextInCell[c]++ ] = i;
+                }
+            }
+        }
+    
+    delete [] nextInCell;
+    delete [] firstX;
+    delete [] lastX;
+    delete [] firstY;
+    delete [] lastY;
+    
+    mGridDirty = false;
+    }
+
+
+
 inline void GUIContainerGL::mouseMoved( double inX, double inY ) {
+    mRedrawDirty = true;
+    
 	for( int i=0; i<mComponentVector->size(); i++ ) {
 		GUIComponentGL *component = *( mComponentVector->getElement( i ) );
         component->mouseMoved( inX, inY );
@@ -214,6 +488,8 @@ inline void GUIContainerGL::mouseMoved( double inX, double inY ) {
 
 
 inline void GUIContainerGL::mouseDragged( double inX, double inY ) {
+    mRedrawDirty = true;
+    
 	// released events should be passed to all components
 	// so that a pressed component can react if the mouse
 	// is dragged elsewhere
@@ -226,9 +502,64 @@ inline void GUIContainerGL::mouseDragged( double inX, double inY ) {
 
 
 inline void GUIContainerGL::mousePressed( double inX, double inY ) {
-	// only pass pressed events to components
+    mRedrawDirty = true;
+    
+    if( mGridDirty ) {
+        buildGrid();
+        }
+    
+    int numComponents = mComponentVector->size();
+    
+    for( int i=0; i<numComponents; i++ ) {
+        // press started elsewhere, unless found below
+        *( mPressStartedHereVector->getElement( i ) ) = false;
+        }
+    
+    int cellX, cellY, lastCell;
+    getGridCellRange( inX, 0, mGridX, mGridCellWidth, &cellX, &lastCell );
+    getGridCellRange( inY, 0, mGridY, mGridCellHeight, &cellY, &lastCell );
+    
+    int c = cellY * GUI_CONTAINER_GL_GRID_SIZE + cellX;
+    
+
+    // copy, because the grid can be rebuilt during an event call
+    SimpleVector<int> candidates;
+    int numCandidates = mGridCellStarts[c+1] - mGridCellStarts[c];
+    if( numCandidates > 0 ) {
+        candidates.appendArray( &( mGridIndices[ mGridCellStarts[c] ] ),
+                                numCandidates );
+        }
+    
+    int changeCount = mComponentChangeCount;
+
+    int resumeIndex = numComponents;
+    
+    // only pass pressed events to components
 	// that contain the coordinate pressed
-	for( int i=0; i<mComponentVector->size(); i++ ) {
+    for( int k=0; k<candidates.size(); k++ ) {
+        int i = candidates.getElementDirectFast( k );
+        
+        GUIComponentGL *component = *( mComponentVector->getElement( i ) );
+		if( component->isInside( inX, inY ) ) {
+			component->mousePressed( inX, inY );
+
+            // components MIGHT get removed by the event call, thus, our
+            // vector might be too short for i now
+
+            if( i < mComponentVector->size() ) {  
+                *( mPressStartedHereVector->getElement( i ) ) = true;
+                }
+
+            if( mComponentChangeCount != changeCount || mGridDirty ) {
+                // components added, removed, or moved by event call
+                // grid out of date, so check the rest one by one
+                resumeIndex = i + 1;
+                break;
+                }
+			}
+        }
+    
+    for( int i=resumeIndex; i<mComponentVector->size(); i++ ) {
 		GUIComponentGL *component = *( mComponentVector->getElement( i ) );
 		if( component->isInside( inX, inY ) ) {
 			component->mousePressed( inX, inY );
@@ -250,6 +581,8 @@ inline void GUIContainerGL::mousePressed( double inX, double inY ) {
 
 
 inline void GUIContainerGL::mouseReleased( double inX, double inY ) {
+    mRedrawDirty = true;
+    
 	// first, unfocus all components, but skip those that are locked
 	for( int i=0; i<mComponentVector->size(); i++ ) {
 		GUIComponentGL *component = *( mComponentVector->getElement( i ) );
@@ -303,6 +636,8 @@ inline char GUIContainerGL::isFocused() {
 inline void GUIContainerGL::keyPressed(
 	unsigned char inKey, double inX, double inY ) {
 
+    mRedrawDirty = true;
+
 	for( int i=0; i<mComponentVector->size(); i++ ) {
 		GUIComponentGL *component = *( mComponentVector->getElement( i ) );
 		
@@ -318,6 +653,8 @@ inline void GUIContainerGL::keyPressed(
 inline void GUIContainerGL::specialKeyPressed(
 	int inKey, double inX, double inY ) {
 
+    mRedrawDirty = true;
+
 	for( int i=0; i<mComponentVector->size(); i++ ) {
 		GUIComponentGL *component = *( mComponentVector->getElement( i ) );
 
@@ -333,6 +670,8 @@ inline void GUIContainerGL::specialKeyPressed(
 inline void GUIContainerGL::keyReleased(
 	unsigned char inKey, double inX, double inY ) {
 
+    mRedrawDirty = true;
+
 	for( int i=0; i<mComponentVector->size(); i++ ) {
 		GUIComponentGL *component = *( mComponentVector->getElement( i ) );
 
@@ -348,6 +687,8 @@ inline void GUIContainerGL::keyReleased(
 inline void GUIContainerGL::specialKeyReleased(
 	int inKey, double inX, double inY ) {
 
+    mRedrawDirty = true;
+
 	for( int i=0; i<mComponentVector->size(); i++ ) {
 		GUIComponentGL *component = *( mComponentVector->getElement( i ) );
 
@@ -360,7 +701,7 @@ inline void GUIContainerGL::specialKeyReleased(
 
 
 		
-inline void GUIContainerGL::fireRedraw() {
+inline void GUIContainerGL::drawComponents() {
 	for( int i=0; i<mComponentVector->size(); i++ ) {
 		GUIComponentGL *component = *( mComponentVector->getElement( i ) );
 		component->fireRedraw();
@@ -369,6 +710,72 @@ inline void GUIContainerGL::fireRedraw() {
 
 
 
+inline void GUIContainerGL::fireRedraw() {
+    #ifdef GL_COMPILE_AND_EXECUTE
+    if( mRetainedRedraw ) {
+        GLint listBeingMade = 0;
+        glGetIntegerv( GL_LIST_INDEX, &listBeingMade );
+
+        // lists can't be made inside other lists, so if a containing
+        // container is recording, just draw into its list
+        if( listBeingMade == 0 ) {
+            
+            // SingleTextureGL skips enabling and binding when it thinks
+            // that has already been done, which may not be true when the
+            // list is replayed, or after it
+            SingleTextureGL::disableTexturing();
+            
+            int context = SingleTextureGL::getContextChangeCount();
+            int deletions = SingleTextureGL::getTextureDeletionCount();
+            
+            if( mDisplayList != 0 && mDisplayListContext != context ) {
+                // GL context changed, taking old list with it
+                mDisplayList = 0;
+                }
+            
+            if( mRedrawDirty || 
+                mDisplayListTextureDeletions != deletions ) {
+                // list may use a texture that is gone
+                mRedrawDirty = false;
+                mDisplayListRecorded = false;
+                mUnchangedRedraws = 0;
+                }
+
+            if( mDisplayListRecorded && mDisplayList != 0 ) {
+                glCallList( mDisplayList );
+                }
+            else if( mUnchangedRedraws < 
+                     GUI_CONTAINER_GL_REDRAWS_BEFORE_RECORD ) {
+                drawComponents();
+                mUnchangedRedraws++;
+                }
+            else {
+                if( mDisplayList == 0 ) {
+                    mDisplayList = glGenLists( 1 );
+                    mDisplayListContext = context;
+                    }
+                
+                glNewList( mDisplayList, GL_COMPILE_AND_EXECUTE );
+                drawComponents();
+                glEndList();
+
+                mDisplayListRecorded = true;
+                // components may have deleted textures while recording
+                mDisplayListTextureDeletions = 
+                    SingleTextureGL::getTextureDeletionCount();
+                }
+
+            SingleTextureGL::disableTexturing();
+            return;
+            }
+        }
+    #endif
+
+    drawComponents();
+	}
+
+
+
 #endif
 
 
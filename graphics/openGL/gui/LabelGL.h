@@ -15,6 +15,9 @@
  *
  * 2010-May-14    Jason Rohrer
  * String parameters as const to fix warnings.
+ *
+ * 2026-October-15    Jason Rohrer
+ * Invalidates when text is set.
  */
  
  
@@ -139,6 +142,8 @@ inline void LabelGL::setText( const char *inString ) {
 	mString = new char[ length ];
 
 	memcpy( mString, inString, length );
+
+    invalidate();
 	}
 
 
@@ -28,6 +28,9 @@
  *
  * 2010-April-15		Jason Rohrer
  * Distinguish release event.
+ *
+ * 2026-October-15    Jason Rohrer
+ * Invalidates when colors or thumb position are set.
  */
  
  
@@ -237,6 +240,8 @@ inline SliderGL::~SliderGL() {
 inline void SliderGL::setBarStartColor( Color *inColor ) {
     delete mBarStartColor;
     mBarStartColor = inColor;
+
+    invalidate();
     }
 
 
@@ -244,6 +249,8 @@ inline void SliderGL::setBarStartColor( Color *inColor ) {
 inline void SliderGL::setBarEndColor( Color *inColor ) {
     delete mBarEndColor;
     mBarEndColor = inColor;
+
+    invalidate();
     }
 
 
@@ -257,6 +264,7 @@ inline double SliderGL::getThumbPosition() {
 inline void SliderGL::setThumbPosition( double inPosition ) {
 	if( mThumbPosition != inPosition ) {
 		mThumbPosition = inPosition;
+        invalidate();
 		fireActionPerformed( this );
 		}
 	}
@@ -3,6 +3,9 @@
  *
  * 2001-September-16		Jason Rohrer
  * Created.
+ *
+ * 2026-October-15    Jason Rohrer
+ * Invalidates when pressed state is set.
  */
  
  
@@ -121,6 +124,7 @@ inline void StickyButtonGL::setPressed( char inPressed ) {
 
 	// check for state change
 	if( lastTexture != mCurrentTexture ) {
+        invalidate();
 		fireActionPerformed( this );
 		}
 	}
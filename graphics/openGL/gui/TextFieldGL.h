@@ -55,6 +55,14 @@
  *
  * 2010-May-25    Jason Rohrer
  * Based border offset on border width (instead of 1/8 height).
+ *
+ * 2026-October-15    Jason Rohrer
+ * Invalidates when text, cursor, or focus are set.
+ * Hit bounds that include the border.
+ * Text kept in a gap buffer along with each character's width, so edits
+ * in the middle don't copy the string, and the cursor is placed without
+ * measuring substrings.
+ * setText measures its string as a size_t.
  */
  
  
@@ -185,6 +193,10 @@ class TextFieldGL : public GUIComponentGL, public ActionListenerList {
         // override this to make click area slightly bigger
         // (so it includes the border)
         virtual char isInside( double inX, double inY );
+
+        // matches isInside
+        virtual void getHitBounds( double *outX, double *outY,
+                                   double *outWidth, double *outHeight );
 		
 	protected:
 
@@ -196,11 +208,43 @@ class TextFieldGL : public GUIComponentGL, public ActionListenerList {
 		 */
 		void fixCursorPosition();
 
+
+		int getLength();
+
+		// moves gap to a character position
+		void moveGap( int inPosition );
+
+		// makes room in gap for at least one more character
+		void growGap();
+
+		// width of text before a character position, in text height units
+		double getWidthBefore( int inPosition );
+
+		double getCharWidthAt( int inPosition );
 		
 		
 		TextGL *mText;
 
+		// text is a gap buffer, with the gap left where the last edit
+		// was, so typing in the middle moves nothing
+		// mChars[ 0, mGapStart ) and mChars[ mGapEnd, mCapacity ) hold
+		// the text
+		char *mChars;
+		// width of each character in mChars
+		double *mCharWidths;
+		int mCapacity;
+		int mGapStart;
+		int mGapEnd;
+
+		// total widths of characters before and after gap
+		double mWidthBeforeGap;
+		double mWidthAfterGap;
+
+		// contiguous copy of text, for getText and drawing, made
+		// again only after text changes
 		char *mString;
+		int mStringCapacity;
+		char mStringStale;
 
 		Color *mBorderColor;
 		Color *mFocusedBorderColor;
@@ -235,7 +279,11 @@ inline TextFieldGL::TextFieldGL(
     int inLengthLimit,
     char inForceUppercase )
 	: GUIComponentGL( inAnchorX, inAnchorY, inWidth, inHeight ),
-	  mText( inText ), mString( NULL ),
+	  mText( inText ),
+	  mChars( NULL ), mCharWidths( NULL ), mCapacity( 0 ),
+	  mGapStart( 0 ), mGapEnd( 0 ),
+	  mWidthBeforeGap( 0 ), mWidthAfterGap( 0 ),
+	  mString( NULL ), mStringCapacity( 0 ), mStringStale( true ),
 	  mBorderColor( inBorderColor ),
 	  mFocusedBorderColor( inFocusedBorderColor ),
 	  mBackgroundColor( inBackgroundColor ),
@@ -258,6 +306,10 @@ inline TextFieldGL::~TextFieldGL() {
 	if( mString != NULL ) {
 		delete [] mString;
 		}
+	if( mChars != NULL ) {
+		delete [] mChars;
+		delete [] mCharWidths;
+		}
 
 	delete mBorderColor;
 	delete mFocusedBorderColor;
@@ -268,24 +320,166 @@ inline TextFieldGL::~TextFieldGL() {
 
 
 inline void TextFieldGL::setText( const char *inString ) {
-	if( mString != NULL ) {
-		delete [] mString;
+	size_t length = strlen( inString );
+
+	if( (size_t)mCapacity < length + 1 ) {
+		if( mChars != NULL ) {
+			delete [] mChars;
+			delete [] mCharWidths;
+			}
+		mCapacity = (int)( 2 * length + 16 );
+
+		mChars = new char[ mCapacity ];
+		mCharWidths = new double[ mCapacity ];
 		}
-	int length = strlen( inString ) + 1;
-	
-	mString = new char[ length ];
 
-	memcpy( mString, inString, length );
+	memcpy( mChars, inString, length );
+
+	mWidthBeforeGap = 0;
+	for( size_t i=0; i<length; i++ ) {
+		mCharWidths[i] = mText->measureCharWidth( (unsigned char)mChars[i] );
+		mWidthBeforeGap += mCharWidths[i];
+		}
+	mWidthAfterGap = 0;
+
+	mGapStart = (int)length;
+	mGapEnd = mCapacity;
+
+	mStringStale = true;
+
+    invalidate();
     }
 
 
 
 inline char *TextFieldGL::getText() {
+	if( mStringStale ) {
+		int length = getLength();
+
+		if( mStringCapacity < length + 1 ) {
+			if( mString != NULL ) {
+				delete [] mString;
+				}
+			mStringCapacity = mCapacity + 1;
+			mString = new char[ mStringCapacity ];
+			}
+
+		memcpy( mString, mChars, mGapStart );
+		memcpy( &( mString[ mGapStart ] ), &( mChars[ mGapEnd ] ),
+				mCapacity - mGapEnd );
+		mString[ length ] = '\0';
+
+		mStringStale = false;
+		}
+
 	return mString;
 	}
 
 
 
+inline int TextFieldGL::getLength() {
+	return mCapacity - ( mGapEnd - mGapStart );
+	}
+
+
+
+inline void TextFieldGL::moveGap( int inPosition ) {
+	if( inPosition < mGapStart ) {
+		// characters between position and gap go after gap
+		int numToMove = mGapStart - inPosition;
+
+		for( int i=inPosition; i<mGapStart; i++ ) {
+			mWidthBeforeGap -= mCharWidths[i];
+			mWidthAfterGap += mCharWidths[i];
+			}
+
+		memmove( &( mChars[ mGapEnd - numToMove ] ),
+				 &( mChars[ inPosition ] ), numToMove );
+		memmove( &( mCharWidths[ mGapEnd - numToMove ] ),
+				 &( mCharWidths[ inPosition ] ),
+				 numToMove * sizeof( double ) );
+
+		mGapStart -= numToMove;
+		mGapEnd -= numToMove;
+		}
+	else if( inPosition > mGapStart ) {
+		// characters between gap and position go before gap
+		int numToMove = inPosition - mGapStart;
+
+		for( int i=mGapEnd; i<mGapEnd + numToMove; i++ ) {
+			mWidthBeforeGap += mCharWidths[i];
+			mWidthAfterGap -= mCharWidths[i];
+			}
+
+		memmove( &( mChars[ mGapStart ] ),
+				 &( mChars[ mGapEnd ] ), numToMove );
+		memmove( &( mCharWidths[ mGapStart ] ),
+				 &( mCharWidths[ mGapEnd ] ),
+				 numToMove * sizeof( double ) );
+
+		mGapStart += numToMove;
+		mGapEnd += numToMove;
+		}
+
+	// keep running sums from drifting
+	if( mGapStart == 0 ) {
+		mWidthBeforeGap = 0;
+		}
+	if( mGapEnd == mCapacity ) {
+		mWidthAfterGap = 0;
+		}
+	}
+
+
+
+inline void TextFieldGL::growGap() {
+	if( mGapEnd > mGapStart ) {
+		return;
+		}
+
+	int newCapacity = 2 * mCapacity + 16;
+	int numAfterGap = mCapacity - mGapEnd;
+	int newGapEnd = newCapacity - numAfterGap;
+
+	char *newChars = new char[ newCapacity ];
+	double *newCharWidths = new double[ newCapacity ];
+
+	memcpy( newChars, mChars, mGapStart );
+	memcpy( newCharWidths, mCharWidths, mGapStart * sizeof( double ) );
+
+	memcpy( &( newChars[ newGapEnd ] ), &( mChars[ mGapEnd ] ),
+			numAfterGap );
+	memcpy( &( newCharWidths[ newGapEnd ] ), &( mCharWidths[ mGapEnd ] ),
+			numAfterGap * sizeof( double ) );
+
+	delete [] mChars;
+	delete [] mCharWidths;
+
+	mChars = newChars;
+	mCharWidths = newCharWidths;
+	mCapacity = newCapacity;
+	mGapEnd = newGapEnd;
+	}
+
+
+
+inline double TextFieldGL::getWidthBefore( int inPosition ) {
+	moveGap( inPosition );
+
+	return mWidthBeforeGap;
+	}
+
+
+
+inline double TextFieldGL::getCharWidthAt( int inPosition ) {
+	if( inPosition < mGapStart ) {
+		return mCharWidths[ inPosition ];
+		}
+	return mCharWidths[ inPosition + mGapEnd - mGapStart ];
+	}
+
+
+
 inline void TextFieldGL::ignoreNextKey() {
     mIgnoreNextKey = true;
     }
@@ -293,16 +487,22 @@ inline void TextFieldGL::ignoreNextKey() {
 
 
 inline void TextFieldGL::setCursorPosition( int inCharPosition ) {
-    int maxPosition = strlen( mString );
+    int maxPosition = getLength();
     if( inCharPosition > maxPosition ) {
         inCharPosition = maxPosition;
         }
     mCursorPosition = inCharPosition;
+
+    invalidate();
     }
 
 
 
 inline void TextFieldGL::setFocus( char inFocus ) {
+    if( mFocused != inFocus ) {
+        invalidate();
+        }
+    
 	mFocused = inFocus;
 
 	if( mFocused ) {
@@ -334,29 +534,19 @@ inline void TextFieldGL::keyPressed(
 	
 	// backspace and delete
 	if( inKey == 127 || inKey == 8 ) {
-		if( mCursorPosition != 0 ) {
-			int length = strlen( mString );
+		if( mCursorPosition != 0 && getLength() != 0 ) {
+			moveGap( mCursorPosition );
 
-			if( length != 0 ) {
-				char *newString = new char[ length ];
+			// character before cursor joins gap
+			mGapStart--;
+			mWidthBeforeGap -= mCharWidths[ mGapStart ];
 
-				// copy mString up to the last char before the deleted char
-				memcpy( newString, mString, mCursorPosition-1 );
+			mStringStale = true;
+			invalidate();
 
-				// copy the portion of mString after the deleted char
-				// this will include the trailing \0
-				memcpy( &( newString[mCursorPosition-1] ),
-						&( mString[mCursorPosition] ),
-						length - mCursorPosition + 1 );
-			
-				setText( newString );
-                
-				delete [] newString;
-
-				mCursorPosition--;
+			mCursorPosition--;
 
-                fireActionPerformed( this );
-				}
+            fireActionPerformed( this );
 			}
 		}
 	// allowable character key, from space up to tilde, then extended ascii
@@ -365,36 +555,26 @@ inline void TextFieldGL::keyPressed(
                ||
                (inKey >= 160 ) )
              && 
-             ( mLengthLimit < 0 || (int)strlen( mString ) < mLengthLimit ) ) {
+             ( mLengthLimit < 0 || getLength() < mLengthLimit ) ) {
 		// add a character to our string
 
-		int oldStringLength = strlen( mString ); 
-		int length = oldStringLength + 2;
-		
-		char *newString = new char[ length ];
-
-		
-		if( mCursorPosition != 0 ) {
-			// copy chars up to cursor position
-			memcpy( newString, mString, mCursorPosition );
-			}
-		// copy chars after cursor position, including trailing \0
-		memcpy( &( newString[mCursorPosition+1] ),
-				&( mString[mCursorPosition] ),
-				oldStringLength - mCursorPosition + 1 );
-
-		
-
         if( mForceUppercase ) {
             inKey = toupper( inKey );
             }
 
-        // now stick in the inserted char
-		newString[ mCursorPosition ] = inKey;
-		
-		setText( newString );
-		
-		delete [] newString;
+		moveGap( mCursorPosition );
+		growGap();
+
+        // now stick in the inserted char, at start of gap
+		double charWidth = mText->measureCharWidth( inKey );
+
+		mChars[ mGapStart ] = inKey;
+		mCharWidths[ mGapStart ] = charWidth;
+		mGapStart++;
+		mWidthBeforeGap += charWidth;
+
+		mStringStale = true;
+		invalidate();
 
 		mCursorPosition++;
         
@@ -468,6 +648,19 @@ inline char TextFieldGL::isInside( double inX, double inY ) {
 
 
 
+inline void TextFieldGL::getHitBounds( double *outX, double *outY,
+                                       double *outWidth,
+                                       double *outHeight ) {
+    double borderOffset = 2 * mBorderWidth;
+
+    *outX = mAnchorX - borderOffset;
+    *outY = mAnchorY - borderOffset;
+    *outWidth = mWidth + 2 * borderOffset;
+    *outHeight = mHeight + 2 * borderOffset;
+    }
+
+
+
 inline void TextFieldGL::mousePressed( double inX, double inY ) {
     if( isEnabled() ) {
         // we'll only get pressed events if the mouse is pressed on us
@@ -485,30 +678,25 @@ inline void TextFieldGL::mouseReleased(
 
         double offset = mHeight * 0.1;
 
-        int numChars = strlen( mString );
+        int numChars = getLength();
+        
+        // add up character widths until we find place where mouse clicked
+        double prefixWidth = 0;
         
-        // measure longer substrings until we find place where mouse clicked
         char found = false;
         for( int i=0; i<numChars + 1 && !found; i++ ) {
             
-            // make a temp sub-string and measure its length
-            char *substring = stringDuplicate( mString );
-            substring[ i ] = '\0';
-            
-
-            double subWidth = mText->measureTextWidth( substring ) * mHeight 
-                + offset;
+            double subWidth = prefixWidth * mHeight + offset;
 			
             if( i < numChars ) {
                 // if click is halfway into next char, put cursor before
                 // next char
-                char nextChar[2] = { mString[i], '\0' };
-                subWidth += 
-                    mText->measureTextWidth( nextChar ) * mHeight * 0.5;
+                double charWidth = getCharWidthAt( i );
+                
+                subWidth += charWidth * mHeight * 0.5;
+                
+                prefixWidth += charWidth;
                 }
-            
-
-            delete [] substring;
 
             if( subWidth > inX - mAnchorX ) {
                 mCursorPosition = i;
@@ -539,7 +727,7 @@ inline void TextFieldGL::fixCursorPosition() {
 		mCursorPosition = 0;
 		}
 	else {
-		int stringLength = strlen( mString );
+		int stringLength = getLength();
 		if( mCursorPosition > stringLength ) {
 			mCursorPosition = stringLength;
 			}
@@ -587,11 +775,11 @@ inline void TextFieldGL::fireRedraw() {
 	glEnd();
 
     
-    double charWidth = mHeight * strlen( mString );
+    double charWidth = mHeight * getLength();
     
 	
 	// draw the text
-	mText->drawText( mString, mAnchorX, mAnchorY,
+	mText->drawText( getText(), mAnchorX, mAnchorY,
 					 charWidth, mHeight );
     
     if( mFocused ) {
@@ -619,16 +807,14 @@ inline void TextFieldGL::fireRedraw() {
 			}
 		glEnd();
         */
-        // make a temp sub-string and measure its length
-        char *substring = stringDuplicate( mString );
-        substring[ mCursorPosition ] = '\0';
-        
+        int cursorPosition = mCursorPosition;
+        if( cursorPosition > getLength() ) {
+            cursorPosition = getLength();
+            }
         
-        double subWidth = mText->measureTextWidth( substring ) * mHeight 
+        double subWidth = getWidthBefore( cursorPosition ) * mHeight 
             ;//+ offset;
         
-        delete [] substring;
-        
         
         double cursorViewX = mAnchorX + subWidth;
         
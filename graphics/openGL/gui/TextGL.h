@@ -32,6 +32,12 @@
  *
  * 2010-May-14    Jason Rohrer
  * String parameters as const to fix warnings.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Strings drawn repeatedly are cached as single textures, drawn as one quad.
+ * Integer power-of-2 padding instead of log and pow.
+ * String textures not made while display lists are being made.
+ * measureCharWidth, for callers that keep running widths.
  */
 
 
@@ -41,6 +47,7 @@
 
 #include <stdio.h>
 #include <stdarg.h>
+#include <string.h>
 #include <math.h>
 
 #include "minorGems/graphics/openGL/glInclude.h"
@@ -50,10 +57,62 @@
 
 #include "minorGems/graphics/openGL/SingleTextureGL.h"
 
+#include "minorGems/util/SimpleVector.h"
+#include "minorGems/util/stringUtils.h"
+
+
+
+// strings remembered per TextGL, drawn or waiting for a second draw
+#define TEXT_GL_STRING_CACHE_SIZE 64
+
+// wider strings are always drawn a character at a time
+#define TEXT_GL_MAX_STRING_TEXTURE_WIDTH 2048
+
+// most a string texture is stretched horizontally so that characters
+// land on whole texture pixels
+#define TEXT_GL_MAX_STRING_X_SCALE 8
+
+
+
+typedef struct TextGLCachedString {
+        char *text;
+        
+        // NULL until string is drawn a second time,
+        // so text that changes every frame never makes textures
+        SingleTextureGL *texture;
+        
+        // set if string can't be cached, so we don't try again
+        char cantCache;
+        
+        // how much texture is stretched horizontally
+        int xScale;
+        
+        // stretched textures are interpolated when smoothing, so they
+        // must be made again if smoothing changes
+        char smooth;
+        
+        // horizontal extent of texture's quad, in character widths
+        // from the start of the string
+        double startX;
+        double endX;
+        
+        // fraction of power-of-2 texture covered by string
+        double xFractionUsed;
+        double yFractionUsed;
+        
+        unsigned int lastUsed;
+    } TextGLCachedString;
+
+
 /**
  * A class for drawing text strings to an OpenGL context.
  * Fonts are texture maps.
  *
+ * For white alpha fonts, a string drawn more than once is rendered into
+ * its own texture and drawn as a single quad from then on.  Colors
+ * and smoothing are applied when drawing, so changing them does not
+ * require new textures.
+ *
  * @author Jason Rohrer
  */
 class TextGL {
@@ -220,6 +279,11 @@ class TextGL {
          */
         double measureTextWidth( const char *inString );
 
+
+        // width of one character, in the same units as measureTextWidth,
+        // which is the sum of these over a string's characters
+        double measureCharWidth( unsigned char inCharacter );
+
         /**
          * Measures the height of a string of text
          *
@@ -234,6 +298,14 @@ class TextGL {
          *  (measureTextHeight * inHeight).
          */
         double measureTextHeight( const char *inString );
+
+
+        
+        /**
+         * Destroys all cached string textures, which are made again as
+         * strings are drawn.
+         */
+        void clearStringCache();
         
 
 	protected:
@@ -264,6 +336,42 @@ class TextGL {
         double *mHeightFractionMetrics;
         
 
+        // alpha of font image, for rendering cached strings,
+        // or NULL if font can't be used for caching
+        unsigned char *mFontAlpha;
+        int mFontAlphaWidth;
+        
+        // size of one character cell in mFontAlpha
+        int mCellPixelWidth;
+        int mCellPixelHeight;
+        
+        SimpleVector<TextGLCachedString> mStringCache;
+        
+        unsigned int mStringCacheTick;
+        
+
+        // smallest power of 2 that is at least inValue
+        static int getNextPowerOf2( int inValue );
+        
+
+        /**
+         * Finds or adds a cache record for a string, making its texture
+         * if this is its second draw.
+         *
+         * @return the record, with texture set if string should be drawn
+         *   from its texture.
+         */
+        TextGLCachedString *getCachedString( const char *inString );
+        
+
+        // renders string into a texture, filling in its record
+        void makeStringTexture( TextGLCachedString *inRecord );
+
+        // true if a display list is being recorded, which texture uploads
+        // would end up in
+        char isListBeingMade();
+
+        
         
 		/**
 		 * Draws a character into a specified region of the
@@ -323,35 +431,23 @@ inline TextGL::TextGL( Image *inImage, char inUseAlpha,
       mStartWidthFractionMetrics( new double[ 256 ] ),
       mEndWidthFractionMetrics( new double[ 256 ] ),
       mCharacterSpacingFraction( inCharacterSpacingFraction ),
-      mHeightFractionMetrics( new double[ 256 ] ) {
+      mHeightFractionMetrics( new double[ 256 ] ),
+      mFontAlpha( NULL ),
+      mFontAlphaWidth( 0 ),
+      mCellPixelWidth( 0 ),
+      mCellPixelHeight( 0 ),
+      mStringCacheTick( 0 ) {
 
 
     // pad image to next power of 2 in each dimension
 
     int w = inImage->getWidth();
     int h = inImage->getHeight();
-    int paddedW = w;
-    int paddedH = h;
+    int paddedW = getNextPowerOf2( w );
+    int paddedH = getNextPowerOf2( h );
     
-
-    double log2w = log( w ) / log( 2 );
-    double log2h = log( h ) / log( 2 );
-    
-
-    int next2PowerW = (int)( ceil( log2w ) );
-    int next2PowerH = (int)( ceil( log2h ) );
-    
-    if( next2PowerW != log2w ) {
-        paddedW = (int)( pow( 2, next2PowerW ) );
-        
-        mXImageFractionUsed = (double)w / (double)paddedW;
-        }
-
-    if( next2PowerH != log2h ) {
-        paddedH = (int)( pow( 2, next2PowerH ) );
-        
-        mYImageFractionUsed = (double)h / (double)paddedH;
-        }
+    mXImageFractionUsed = (double)w / (double)paddedW;
+    mYImageFractionUsed = (double)h / (double)paddedH;
     
     mHWRatio = h / (double)w;
 
@@ -414,6 +510,55 @@ inline TextGL::TextGL( Image *inImage, char inUseAlpha,
                                  inCharacterSpacingFraction,
                                  inSpaceWidthFraction );
         }
+
+
+    // cached strings are white textures colored when drawn,
+    // so only alpha fonts that are white can be cached
+    char cacheable = inUseAlpha;
+    
+    if( cacheable && numChannels == 4 ) {
+        int numPixels = w * h;
+        
+        for( int c=0; c<3 && cacheable; c++ ) {
+            double *channel = inImage->getChannel( c );
+            double *alpha = inImage->getChannel( 3 );
+            
+            for( int p=0; p<numPixels; p++ ) {
+                if( alpha[p] > 0 && channel[p] < 1.0 ) {
+                    cacheable = false;
+                    break;
+                    }
+                }
+            }
+        }
+
+    if( cacheable ) {
+        // alpha is red channel, unless image has its own alpha
+        int alphaChannel = 0;
+        if( numChannels == 4 ) {
+            alphaChannel = 3;
+            }
+        
+        double *alpha = inImage->getChannel( alphaChannel );
+        
+        mFontAlphaWidth = w;
+        mCellPixelWidth = w / 16;
+        mCellPixelHeight = h / 16;
+        
+        mFontAlpha = new unsigned char[ w * h ];
+        
+        for( int p=0; p<w*h; p++ ) {
+            double a = alpha[p];
+            
+            if( a < 0 ) {
+                a = 0;
+                }
+            else if( a > 1 ) {
+                a = 1;
+                }
+            mFontAlpha[p] = (unsigned char)lrint( a * 255 );
+            }
+        }
 	}
 
 
@@ -430,6 +575,22 @@ inline TextGL::~TextGL() {
     delete [] mStartWidthFractionMetrics;
     delete [] mEndWidthFractionMetrics;
 	delete [] mHeightFractionMetrics;
+
+    clearStringCache();
+    
+    if( mFontAlpha != NULL ) {
+        delete [] mFontAlpha;
+        }
+    }
+
+
+
+inline int TextGL::getNextPowerOf2( int inValue ) {
+    int p = 1;
+    while( p < inValue ) {
+        p *= 2;
+        }
+    return p;
     }
 
 
@@ -481,6 +642,10 @@ inline void TextGL::drawText( const char *inString, double inX, double inY,
     
 	int numChars = strlen( inString );
 
+    if( numChars == 0 ) {
+        return;
+        }
+
 	double charWidth = inWidth / numChars;
 
 	double currentCharX = inX;
@@ -492,15 +657,82 @@ inline void TextGL::drawText( const char *inString, double inX, double inY,
 		glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
 		}
 	
-	for( int i=0; i<numChars; i++ ) {
-		unsigned char c = inString[i];
+    TextGLCachedString *cached = NULL;
+    
+    if( mFontAlpha != NULL ) {
+        cached = getCachedString( inString );
+        }
+    
+    if( cached != NULL && cached->texture != NULL ) {
+        
+        SingleTextureGL *texture = cached->texture;
+        
+        texture->enable();
 
-        double usedWidth;
-		drawCharacter( c, currentCharX, inY, charWidth, inHeight,
-                       &usedWidth );
-		
-		currentCharX += usedWidth;
-		}
+        int filter = 0;
+        GLint glFilter = GL_NEAREST;
+        if( mSmooth ) {
+            filter = 1;
+            glFilter = GL_LINEAR;
+            }
+        
+        if( texture->mLastSetMagFilter != filter ) {
+            glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, glFilter );
+            texture->mLastSetMagFilter = filter;
+            }
+        if( texture->mLastSetMinFilter != filter ) {
+            glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, glFilter );
+            texture->mLastSetMinFilter = filter;
+            }
+        
+        double startX = inX + cached->startX * charWidth;
+        double endX = inX + cached->endX * charWidth;
+        
+        double startY = inY;
+        double endY = inY + inHeight * mHWRatio;
+        
+        // rows of texture top-down
+        double textureEndX = cached->xFractionUsed;
+        double textureStartY = cached->yFractionUsed;
+        
+        glBegin( GL_QUADS ); {
+            if( mGradientColor != NULL ) {
+                glColor4f( mGradientColor->r, mGradientColor->g,
+                           mGradientColor->b, mGradientColor->a );
+                }
+            else {
+                glColor4f( mFontColor->r, mFontColor->g,
+                           mFontColor->b, mFontColor->a );
+                }
+            
+            glTexCoord2f( 0, textureStartY );
+            glVertex3d( startX, startY, mZ );
+            
+            glTexCoord2f( textureEndX, textureStartY );
+            glVertex3d( endX, startY, mZ ); 
+            
+            glColor4f( mFontColor->r, mFontColor->g,
+                       mFontColor->b, mFontColor->a );
+            
+            glTexCoord2f( textureEndX, 0 );
+            glVertex3d( endX, endY, mZ );
+            
+            glTexCoord2f( 0, 0 );
+            glVertex3d( startX, endY, mZ );
+            }
+        glEnd();
+        }
+    else {
+        for( int i=0; i<numChars; i++ ) {
+            unsigned char c = inString[i];
+            
+            double usedWidth;
+            drawCharacter( c, currentCharX, inY, charWidth, inHeight,
+                           &usedWidth );
+            
+            currentCharX += usedWidth;
+            }
+        }
 
 	if( mUseAlpha ) {
 		// restore blend state if necessary
@@ -730,6 +962,14 @@ inline double TextGL::measureTextWidth( const char *inString ) {
     }
 
 
+inline double TextGL::measureCharWidth( unsigned char inCharacter ) {
+    return 
+        mEndWidthFractionMetrics[ inCharacter ] -
+        mStartWidthFractionMetrics[ inCharacter ];
+    }
+
+
+
 inline double TextGL::measureTextHeight( const char *inString ) {
 
     double height = 0;
@@ -751,5 +991,246 @@ inline double TextGL::measureTextHeight( const char *inString ) {
 
 
 
+inline void TextGL::clearStringCache() {
+    for( int i=0; i<mStringCache.size(); i++ ) {
+        TextGLCachedString *r = mStringCache.getElement( i );
+        
+        delete [] r->text;
+        
+        if( r->texture != NULL ) {
+            delete r->texture;
+            }
+        }
+    mStringCache.deleteAll();
+    }
+
+
+
+inline char TextGL::isListBeingMade() {
+    #ifdef GL_LIST_INDEX
+    GLint listIndex = 0;
+    glGetIntegerv( GL_LIST_INDEX, &listIndex );
+    
+    return ( listIndex != 0 );
+    #else
+    return false;
+    #endif
+    }
+
+
+
+inline TextGLCachedString *TextGL::getCachedString( const char *inString ) {
+    mStringCacheTick++;
+    
+    int numRecords = mStringCache.size();
+    
+    for( int i=0; i<numRecords; i++ ) {
+        TextGLCachedString *r = mStringCache.getElement( i );
+        
+        if( strcmp( r->text, inString ) == 0 ) {
+            r->lastUsed = mStringCacheTick;
+            
+            if( r->texture != NULL && r->xScale > 1 && 
+                r->smooth != mSmooth ) {
+                delete r->texture;
+                r->texture = NULL;
+                }
+
+            if( r->texture == NULL && ! r->cantCache &&
+                ! isListBeingMade() ) {
+                makeStringTexture( r );
+                }
+            return r;
+            }
+        }
+    
+    
+    // new string, will get a texture if drawn again
+    TextGLCachedString newRecord;
+    newRecord.text = stringDuplicate( inString );
+    newRecord.texture = NULL;
+    newRecord.cantCache = false;
+    newRecord.xScale = 1;
+    newRecord.smooth = mSmooth;
+    newRecord.startX = 0;
+    newRecord.endX = 0;
+    newRecord.xFractionUsed = 0;
+    newRecord.yFractionUsed = 0;
+    newRecord.lastUsed = mStringCacheTick;
+
+    if( numRecords < TEXT_GL_STRING_CACHE_SIZE ) {
+        mStringCache.push_back( newRecord );
+        return mStringCache.getElement( numRecords );
+        }
+    
+    // replace least recently used
+    int oldestIndex = 0;
+    
+    for( int i=1; i<numRecords; i++ ) {
+        if( mStringCache.getElement( i )->lastUsed <
+            mStringCache.getElement( oldestIndex )->lastUsed ) {
+            oldestIndex = i;
+            }
+        }
+    
+    TextGLCachedString *oldest = mStringCache.getElement( oldestIndex );
+    
+    delete [] oldest->text;
+    if( oldest->texture != NULL ) {
+        delete oldest->texture;
+        }
+    
+    *oldest = newRecord;
+    
+    return oldest;
+    }
+
+
+
+inline void TextGL::makeStringTexture( TextGLCachedString *inRecord ) {
+    const char *text = inRecord->text;
+    int numChars = strlen( text );
+    
+    // each character's quad starts at its x offset, in character widths,
+    // and is one character width wide, as in drawText
+    double *charStartX = new double[ numChars ];
+    
+    double x = 0;
+    double minX = 0;
+    double maxX = 0;
+    
+    for( int i=0; i<numChars; i++ ) {
+        unsigned char c = text[i];
+        
+        charStartX[i] = x - mStartWidthFractionMetrics[c];
+        
+        if( i == 0 || charStartX[i] < minX ) {
+            minX = charStartX[i];
+            }
+        if( i == 0 || charStartX[i] + 1 > maxX ) {
+            maxX = charStartX[i] + 1;
+            }
+        
+        x += mEndWidthFractionMetrics[c] - mStartWidthFractionMetrics[c];
+        }
+    
+    // characters must start on whole texture pixels to look the same as
+    // when drawn one at a time, so stretch texture horizontally if
+    // spacing puts them between font pixels
+    int xScale = 0;
+    
+    for( int k=1; k<=TEXT_GL_MAX_STRING_X_SCALE && xScale == 0; k++ ) {
+        char aligned = true;
+        
+        for( int i=0; i<numChars; i++ ) {
+            double pixelX = ( charStartX[i] - minX ) * mCellPixelWidth * k;
+            
+            if( fabs( pixelX - floor( pixelX + 0.5 ) ) > 1.0 / 16 ) {
+                aligned = false;
+                break;
+                }
+            }
+        if( aligned ) {
+            xScale = k;
+            }
+        }
+
+    int cellW = mCellPixelWidth * xScale;
+    int cellH = mCellPixelHeight;
+
+    int w = (int)lrint( ( maxX - minX ) * cellW );
+    int h = cellH;
+    
+    int paddedW = getNextPowerOf2( w );
+    int paddedH = getNextPowerOf2( h );
+    
+    if( xScale == 0 || cellW == 0 || cellH == 0 || 
+        paddedW > TEXT_GL_MAX_STRING_TEXTURE_WIDTH ) {
+        inRecord->cantCache = true;
+        delete [] charStartX;
+        return;
+        }
+    
+    unsigned char *alpha = new unsigned char[ paddedW * paddedH ];
+    memset( alpha, 0, paddedW * paddedH );
+    
+    for( int i=0; i<numChars; i++ ) {
+        unsigned char c = text[i];
+        
+        int destX = (int)lrint( ( charStartX[i] - minX ) * cellW );
+        
+        int sourceX = ( c % 16 ) * mCellPixelWidth;
+        int sourceY = ( c / 16 ) * cellH;
+
+        for( int y=0; y<cellH; y++ ) {
+            unsigned char *source = 
+                &( mFontAlpha[ ( sourceY + y ) * mFontAlphaWidth + sourceX ] );
+            unsigned char *dest = &( alpha[ y * paddedW + destX ] );
+            
+            for( int p=0; p<cellW && destX + p < w; p++ ) {
+                int s;
+                
+                if( xScale > 1 && mSmooth ) {
+                    // stretched pixels blend between font pixels, like
+                    // the font texture does when drawn smoothed
+                    double sourceP = ( p + 0.5 ) / xScale - 0.5;
+                    int left = (int)floor( sourceP );
+                    double rightWeight = sourceP - left;
+                    
+                    double leftValue = 0;
+                    double rightValue = 0;
+                    
+                    if( left >= 0 ) {
+                        leftValue = source[ left ];
+                        }
+                    if( left + 1 < mCellPixelWidth ) {
+                        rightValue = source[ left + 1 ];
+                        }
+                    
+                    s = (int)lrint( leftValue + 
+                                    ( rightValue - leftValue ) * 
+                                    rightWeight );
+                    }
+                else {
+                    s = source[ p / xScale ];
+                    }
+                
+                // overlapping characters blend like they do when drawn
+                // one by one
+                int d = dest[p];
+                
+                dest[p] = 
+                    (unsigned char)( s + ( d * ( 255 - s ) + 127 ) / 255 );
+                }
+            }
+        }
+    
+    delete [] charStartX;
+    
+    // white, so vertex colors show through as they do for the font texture
+    int numPixels = paddedW * paddedH;
+    
+    unsigned char *rgba = new unsigned char[ numPixels * 4 ];
+    memset( rgba, 255, numPixels * 4 );
+    
+    for( int p=0; p<numPixels; p++ ) {
+        rgba[ p * 4 + 3 ] = alpha[p];
+        }
+    delete [] alpha;
+    
+    // expanding edges would thicken outermost strokes of the string
+    inRecord->texture = new SingleTextureGL( rgba, paddedW, paddedH, 
+                                             false, false, false );
+    delete [] rgba;
+    
+    inRecord->xScale = xScale;
+    inRecord->smooth = mSmooth;
+    inRecord->startX = minX;
+    inRecord->endX = minX + (double)w / cellW;
+    inRecord->xFractionUsed = (double)w / paddedW;
+    inRecord->yFractionUsed = (double)h / paddedH;
+    }
+
+
 
 #endif
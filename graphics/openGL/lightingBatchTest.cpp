@@ -0,0 +1,233 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+/**
+ * Checks getLightingBatch against per-point getLighting for each
+ * LightingGL implementation, checks that lighting versions change when
+ * a MultiLightingGL (or a lighting inside it) changes, and times both
+ * ways of lighting a landscape-sized batch.
+ *
+ * Compile from above the minorGems directory with:
+ *   g++ -O2 -I. minorGems/graphics/openGL/lightingBatchTest.cpp
+ *     minorGems/system/unix/TimeUnix.cpp minorGems/io/linux/TypeIOLinux.cpp
+ *     -o lightingBatchTest
+ */
+
+#include "AmbientLightingGL.h"
+#include "DirectionLightingGL.h"
+#include "MultiLightingGL.h"
+#include "NoLightingGL.h"
+
+#include "minorGems/system/Time.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+
+static int numBad = 0;
+
+
+
+// points and normals, as separate component arrays
+static float *x, *y, *z, *nx, *ny, *nz;
+static float *r, *g, *b;
+
+
+
+static void makePoints( int inNumPoints ) {
+    x = new float[ inNumPoints ];
+    y = new float[ inNumPoints ];
+    z = new float[ inNumPoints ];
+    nx = new float[ inNumPoints ];
+    ny = new float[ inNumPoints ];
+    nz = new float[ inNumPoints ];
+    r = new float[ inNumPoints ];
+    g = new float[ inNumPoints ];
+    b = new float[ inNumPoints ];
+
+    srand( 10 );
+
+    for( int i=0; i<inNumPoints; i++ ) {
+        x[i] = rand() % 100;
+        y[i] = rand() % 100;
+        z[i] = rand() % 100;
+
+        float vx = rand() / (float)RAND_MAX - 0.5f;
+        float vy = rand() / (float)RAND_MAX - 0.5f;
+        float vz = rand() / (float)RAND_MAX - 0.5f;
+        float length = sqrtf( vx * vx + vy * vy + vz * vz );
+
+        nx[i] = vx / length;
+        ny[i] = vy / length;
+        nz[i] = vz / length;
+        }
+    }
+
+
+
+static void freePoints() {
+    delete [] x;
+    delete [] y;
+    delete [] z;
+    delete [] nx;
+    delete [] ny;
+    delete [] nz;
+    delete [] r;
+    delete [] g;
+    delete [] b;
+    }
+
+
+
+static void checkBatch( const char *inWhat, LightingGL *inLighting,
+                        int inNumPoints ) {
+    inLighting->getLightingBatch( x, y, z, nx, ny, nz, inNumPoints,
+                                  r, g, b );
+
+    Vector3D point( 0, 0, 0 );
+    Vector3D normal( 0, 0, 0 );
+    Color color( 0, 0, 0 );
+
+    int numWrong = 0;
+
+    for( int i=0; i<inNumPoints; i++ ) {
+        point.setCoordinates( x[i], y[i], z[i] );
+        normal.setCoordinates( nx[i], ny[i], nz[i] );
+
+        inLighting->getLighting( &point, &normal, &color );
+
+        if( fabs( color.r - r[i] ) > 0.0001 ||
+            fabs( color.g - g[i] ) > 0.0001 ||
+            fabs( color.b - b[i] ) > 0.0001 ) {
+
+            if( numWrong == 0 ) {
+                printf( "%s:  point %d batch (%f,%f,%f), "
+                        "single (%f,%f,%f)\n",
+                        inWhat, i, r[i], g[i], b[i],
+                        color.r, color.g, color.b );
+                }
+            numWrong++;
+            }
+        }
+
+    if( numWrong > 0 ) {
+        numBad++;
+        }
+    }
+
+
+
+int main() {
+
+    // odd count, so vector tails are covered
+    int numPoints = 1001;
+    makePoints( numPoints );
+
+
+    NoLightingGL none;
+    checkBatch( "NoLightingGL", &none, numPoints );
+
+    AmbientLightingGL ambient( new Color( 0.2, 0.3, 0.4 ) );
+    checkBatch( "AmbientLightingGL", &ambient, numPoints );
+
+    DirectionLightingGL sun( new Color( 1, 0.9, 0.8 ),
+                             new Vector3D( 0.6, -0.8, 0 ) );
+    checkBatch( "DirectionLightingGL", &sun, numPoints );
+
+    DirectionLightingGL fill( new Color( 0.3, 0.3, 0.5 ),
+                              new Vector3D( 0, 0, -1 ) );
+
+    MultiLightingGL multi;
+    multi.addLighting( &ambient );
+    multi.addLighting( &sun );
+    multi.addLighting( &fill );
+    checkBatch( "MultiLightingGL", &multi, numPoints );
+
+
+    // nested, to check version tracking through inner lighting
+    MultiLightingGL inner;
+    inner.addLighting( &sun );
+
+    MultiLightingGL outer;
+    outer.addLighting( &inner );
+    checkBatch( "nested MultiLightingGL", &outer, numPoints );
+
+    unsigned long outerVersion = outer.getLightingVersion();
+
+    if( outer.getLightingVersion() != outerVersion ) {
+        printf( "Version changed without any change\n" );
+        numBad++;
+        }
+
+    inner.addLighting( &fill );
+
+    if( outer.getLightingVersion() == outerVersion ) {
+        printf( "Version unchanged after inner lighting added\n" );
+        numBad++;
+        }
+    outerVersion = outer.getLightingVersion();
+
+    outer.removeLighting( &inner );
+
+    if( outer.getLightingVersion() == outerVersion ) {
+        printf( "Version unchanged after lighting removed\n" );
+        numBad++;
+        }
+
+    if( sun.getLightingVersion() == fill.getLightingVersion() ) {
+        printf( "Two lightings share a version\n" );
+        numBad++;
+        }
+
+    freePoints();
+
+
+    // timing, 256x256 landscape lit by ambient, sun, and fill
+    numPoints = 256 * 256;
+    makePoints( numPoints );
+
+    int numRuns = 50;
+
+    Vector3D point( 0, 0, 0 );
+    Vector3D normal( 0, 0, 0 );
+    Color color( 0, 0, 0 );
+
+    double startTime = Time::getCurrentTime();
+    for( int run=0; run<numRuns; run++ ) {
+        for( int i=0; i<numPoints; i++ ) {
+            point.setCoordinates( x[i], y[i], z[i] );
+            normal.setCoordinates( nx[i], ny[i], nz[i] );
+
+            multi.getLighting( &point, &normal, &color );
+
+            r[i] = color.r;
+            }
+        }
+    double singleTime = ( Time::getCurrentTime() - startTime ) / numRuns;
+
+    startTime = Time::getCurrentTime();
+    for( int run=0; run<numRuns; run++ ) {
+        multi.getLightingBatch( x, y, z, nx, ny, nz, numPoints, r, g, b );
+        }
+    double batchTime = ( Time::getCurrentTime() - startTime ) / numRuns;
+
+    printf( "%d points, 3 lightings:  getLighting %.3f ms, "
+            "getLightingBatch %.3f ms\n",
+            numPoints, singleTime * 1000, batchTime * 1000 );
+
+    freePoints();
+
+
+    if( numBad == 0 ) {
+        printf( "All tests passed\n" );
+        return 0;
+        }
+    printf( "%d failures\n", numBad );
+    return 1;
+    }
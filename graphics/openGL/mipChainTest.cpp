@@ -0,0 +1,169 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+/**
+ * Checks MipChain's SIMD box filter against the scalar one at many
+ * sizes (odd, non-square, 1-wide), checks level sizes and the
+ * gamma-correct filter on a checkerboard, then times building a full
+ * chain for a 1024x1024 image.
+ *
+ * Compile from above the minorGems directory with:
+ *   g++ -O2 -I. minorGems/graphics/openGL/mipChainTest.cpp
+ *     minorGems/graphics/openGL/MipChain.cpp
+ *     minorGems/system/unix/TimeUnix.cpp -o mipChainTest
+ */
+
+#include "MipChain.h"
+#include "minorGems/system/Time.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+
+static int numBad = 0;
+
+
+
+static unsigned char *makeRandomImage( unsigned int inWidth,
+                                       unsigned int inHeight ) {
+    int numBytes = inWidth * inHeight * 4;
+
+    unsigned char *rgba = new unsigned char[ numBytes ];
+    for( int i=0; i<numBytes; i++ ) {
+        rgba[i] = (unsigned char)rand();
+        }
+    return rgba;
+    }
+
+
+
+int main() {
+
+    // SIMD matches scalar exactly
+    unsigned int sizes[] = { 1, 2, 3, 7, 8, 9, 15, 16, 17, 64, 100, 256 };
+    int numSizes = sizeof( sizes ) / sizeof( sizes[0] );
+
+    for( int i=0; i<numSizes; i++ ) {
+        for( int j=0; j<numSizes; j++ ) {
+            unsigned int w = sizes[i];
+            unsigned int h = sizes[j];
+
+            unsigned char *rgba = makeRandomImage( w, h );
+
+            unsigned int fastW, fastH, slowW, slowH;
+            unsigned char *fast = MipChain::halve( rgba, w, h,
+                                                   &fastW, &fastH );
+            unsigned char *slow = MipChain::halveScalar( rgba, w, h,
+                                                         &slowW, &slowH );
+
+            if( fastW != slowW || fastH != slowH ||
+                memcmp( fast, slow, fastW * fastH * 4 ) != 0 ) {
+                printf( "SIMD and scalar differ at %ux%u\n", w, h );
+                numBad++;
+                }
+
+            delete [] rgba;
+            delete [] fast;
+            delete [] slow;
+            }
+        }
+
+
+    // level sizes down to 1x1
+    unsigned char *rgba = makeRandomImage( 64, 8 );
+    MipChain chain( rgba, 64, 8 );
+
+    unsigned int expectedW[] = { 32, 16, 8, 4, 2, 1 };
+    unsigned int expectedH[] = { 4, 2, 1, 1, 1, 1 };
+
+    if( chain.getNumLevels() != 6 ) {
+        printf( "64x8 chain has %d levels\n", chain.getNumLevels() );
+        numBad++;
+        }
+    else {
+        for( int l=1; l<=6; l++ ) {
+            unsigned int w, h;
+            chain.getLevel( l, &w, &h );
+            if( w != expectedW[ l - 1 ] || h != expectedH[ l - 1 ] ) {
+                printf( "Level %d is %ux%u\n", l, w, h );
+                numBad++;
+                }
+            }
+        }
+    delete [] rgba;
+
+
+    // black and white checkerboard averages to 128 plainly, but to
+    // 188 (half the light) in linear light, alpha stays plain
+    unsigned char checker[ 4 * 4 * 4 ];
+    for( int p=0; p<16; p++ ) {
+        unsigned char v = ( ( p % 4 + p / 4 ) % 2 ) ? 255 : 0;
+        memset( &( checker[ p * 4 ] ), v, 4 );
+        }
+
+    unsigned int w, h;
+    unsigned char *plain = MipChain::halve( checker, 4, 4, &w, &h );
+    unsigned char *gamma = MipChain::halve( checker, 4, 4, &w, &h, true );
+
+    if( plain[0] != 128 || gamma[0] != 188 || gamma[3] != 128 ) {
+        printf( "Checkerboard halved to plain %d, gamma %d, alpha %d\n",
+                plain[0], gamma[0], gamma[3] );
+        numBad++;
+        }
+    delete [] plain;
+    delete [] gamma;
+
+
+    // timing, full chain of a 1024x1024 image
+    rgba = makeRandomImage( 1024, 1024 );
+
+    int numRuns = 50;
+
+    double startTime = Time::getCurrentTime();
+    for( int r=0; r<numRuns; r++ ) {
+        MipChain c( rgba, 1024, 1024 );
+        }
+    double simdTime = ( Time::getCurrentTime() - startTime ) / numRuns;
+
+    startTime = Time::getCurrentTime();
+    for( int r=0; r<numRuns; r++ ) {
+        unsigned char *level = rgba;
+        unsigned int lw = 1024, lh = 1024;
+        while( lw > 1 || lh > 1 ) {
+            unsigned char *next =
+                MipChain::halveScalar( level, lw, lh, &lw, &lh );
+            if( level != rgba ) {
+                delete [] level;
+                }
+            level = next;
+            }
+        delete [] level;
+        }
+    double scalarTime = ( Time::getCurrentTime() - startTime ) / numRuns;
+
+    startTime = Time::getCurrentTime();
+    for( int r=0; r<numRuns; r++ ) {
+        MipChain c( rgba, 1024, 1024, true );
+        }
+    double gammaTime = ( Time::getCurrentTime() - startTime ) / numRuns;
+
+    delete [] rgba;
+
+    printf( "1024x1024 chain:  box %.3f ms, scalar box %.3f ms, "
+            "gamma-correct %.3f ms\n",
+            simdTime * 1000, scalarTime * 1000, gammaTime * 1000 );
+
+
+    if( numBad == 0 ) {
+        printf( "All tests passed\n" );
+        return 0;
+        }
+    printf( "%d failures\n", numBad );
+    return 1;
+    }
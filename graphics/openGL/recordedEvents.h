@@ -0,0 +1,1025 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14   Jason Rohrer
+ * Created.  Binary event recording format, plus readers for it and for the
+ * old text format.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Socket body side stream, so socket payloads stay out of event files.
+ */
+
+
+
+#ifndef RECORDED_EVENTS_INCLUDED
+#define RECORDED_EVENTS_INCLUDED
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#include "minorGems/util/SimpleVector.h"
+#include "minorGems/util/log/AppLog.h"
+#include "minorGems/formats/encodingUtils.h"
+
+
+
+/**
+ * Event recording files used by ScreenGL.
+ *
+ * Events are still generated as text strings (like "mb 1 1 200 300"), and
+ * the old text format is just those strings written out, one batch per
+ * line.
+ *
+ * The binary format stores the same events as a one-byte code followed by
+ * zig-zag varint integers, raw 8-byte doubles, and raw body bytes (instead
+ * of hex).  Batches are collected into blocks that are zip-compressed.
+ *
+ * Binary file layout:
+ *   BINARY_EVENT_FILE_MAGIC
+ *   the same text header line as a text recording, ending with '\n'
+ *   blocks, each:
+ *     varint number of batches
+ *     varint raw length
+ *     varint compressed length
+ *     compressed bytes
+ *
+ * Raw block contents, per batch:
+ *     varint number of events
+ *     events
+ *
+ * Socket read bodies can instead go into a side stream file beside the
+ * recording (in either format), with only "xo" events that locate them
+ * in the event file.  Side stream layout:
+ *   SOCKET_BODY_FILE_MAGIC
+ *   chunks, each:
+ *     varint raw length
+ *     varint compressed length
+ *     compressed bytes
+ *
+ * Each body lies entirely in one chunk, and is found by chunk number and
+ * offset into that chunk's raw bytes.
+ *
+ * @author Jason Rohrer
+ */
+
+
+
+#define BINARY_EVENT_FILE_MAGIC "binaryEvents1\n"
+
+
+// a block is written once it holds this many batches or raw bytes
+// (a crash loses at most one block of recording)
+#define BINARY_EVENT_BLOCK_BATCHES 60
+#define BINARY_EVENT_BLOCK_BYTES 65536
+
+
+#define SOCKET_BODY_FILE_MAGIC "socketBodies1\n"
+
+// a side stream chunk is written once it holds this many raw bytes
+#define SOCKET_BODY_CHUNK_BYTES 262144
+
+
+
+// binary event codes are indices into this table
+static const char *recordedEventCodes[] = {
+    "mm", "md", "mb", "kd", "ku", "sd", "su",
+    "t", "r", "T", "R", "F", "v",
+    "wb", "wx", "xs", "af", "xo" };
+
+static const int numRecordedEventCodes =
+    sizeof( recordedEventCodes ) / sizeof( recordedEventCodes[0] );
+
+
+
+// returns -1 if not found
+inline int getRecordedEventCodeIndex( const char *inCode ) {
+    for( int i=0; i<numRecordedEventCodes; i++ ) {
+        if( strcmp( recordedEventCodes[i], inCode ) == 0 ) {
+            return i;
+            }
+        }
+    return -1;
+    }
+
+
+
+inline void appendVarUInt( SimpleVector<unsigned char> *ioBuffer,
+                           unsigned int inValue ) {
+    while( inValue >= 0x80 ) {
+        ioBuffer->push_back( (unsigned char)( ( inValue & 0x7F ) | 0x80 ) );
+        inValue >>= 7;
+        }
+    ioBuffer->push_back( (unsigned char)inValue );
+    }
+
+
+
+// zig-zag, so that small negative values stay short
+inline void appendVarInt( SimpleVector<unsigned char> *ioBuffer,
+                          int inValue ) {
+    unsigned int u = (unsigned int)inValue;
+
+    appendVarUInt( ioBuffer, ( u << 1 ) ^ ( 0 - ( u >> 31 ) ) );
+    }
+
+
+
+// bit pattern, little-endian
+inline void appendDouble( SimpleVector<unsigned char> *ioBuffer,
+                          double inValue ) {
+    unsigned char bytes[8];
+    memcpy( bytes, &inValue, 8 );
+
+    unsigned short endianTest = 1;
+    char littleEndian = ( *( (unsigned char *)&endianTest ) == 1 );
+
+    for( int i=0; i<8; i++ ) {
+        if( littleEndian ) {
+            ioBuffer->push_back( bytes[i] );
+            }
+        else {
+            ioBuffer->push_back( bytes[ 7 - i ] );
+            }
+        }
+    }
+
+
+
+inline unsigned int decodeVarUInt( const unsigned char *inData,
+                                   int inLength, int *ioPosition ) {
+    unsigned int value = 0;
+    int shift = 0;
+
+    while( *ioPosition < inLength && shift < 32 ) {
+        unsigned char b = inData[ *ioPosition ];
+        (*ioPosition)++;
+
+        value |= (unsigned int)( b & 0x7F ) << shift;
+
+        if( ( b & 0x80 ) == 0 ) {
+            break;
+            }
+        shift += 7;
+        }
+
+    return value;
+    }
+
+
+
+inline int decodeVarInt( const unsigned char *inData, int inLength,
+                         int *ioPosition ) {
+    unsigned int u = decodeVarUInt( inData, inLength, ioPosition );
+
+    return (int)( ( u >> 1 ) ^ ( 0 - ( u & 1 ) ) );
+    }
+
+
+
+inline double decodeDouble( const unsigned char *inData, int inLength,
+                            int *ioPosition ) {
+    if( inLength - *ioPosition < 8 ) {
+        *ioPosition = inLength;
+        return 0;
+        }
+
+    unsigned short endianTest = 1;
+    char littleEndian = ( *( (unsigned char *)&endianTest ) == 1 );
+
+    unsigned char bytes[8];
+    for( int i=0; i<8; i++ ) {
+        if( littleEndian ) {
+            bytes[i] = inData[ *ioPosition + i ];
+            }
+        else {
+            bytes[ 7 - i ] = inData[ *ioPosition + i ];
+            }
+        }
+    *ioPosition += 8;
+
+    double value;
+    memcpy( &value, bytes, 8 );
+    return value;
+    }
+
+
+
+// returns false on EOF
+inline char readVarUInt( FILE *inFile, unsigned int *outValue ) {
+    unsigned int value = 0;
+    int shift = 0;
+
+    while( shift < 32 ) {
+        int b = fgetc( inFile );
+
+        if( b == EOF ) {
+            return false;
+            }
+
+        value |= (unsigned int)( b & 0x7F ) << shift;
+
+        if( ( b & 0x80 ) == 0 ) {
+            *outValue = value;
+            return true;
+            }
+        shift += 7;
+        }
+
+    return false;
+    }
+
+
+
+// converts a hex digit string to raw bytes
+// returns false if string is too short or not hex
+inline char appendHexBytes( SimpleVector<unsigned char> *ioBuffer,
+                            const char *inHex, int inNumBytes ) {
+    for( int i=0; i<inNumBytes; i++ ) {
+        int digits[2];
+
+        for( int d=0; d<2; d++ ) {
+            char c = inHex[ i * 2 + d ];
+
+            if( c >= '0' && c <= '9' ) {
+                digits[d] = c - '0';
+                }
+            else if( c >= 'A' && c <= 'F' ) {
+                digits[d] = c - 'A' + 10;
+                }
+            else if( c >= 'a' && c <= 'f' ) {
+                digits[d] = c - 'a' + 10;
+                }
+            else {
+                return false;
+                }
+            }
+
+        ioBuffer->push_back( (unsigned char)( digits[0] << 4 | digits[1] ) );
+        }
+    return true;
+    }
+
+
+
+/**
+ * Converts one text event string into binary form.
+ *
+ * @param inEvent the event, as recorded in text files.
+ * @param ioBuffer where the binary event should be appended.
+ *
+ * @return true on success, or false (with nothing appended) if event
+ *   can't be parsed.
+ */
+inline char encodeRecordedEvent( const char *inEvent,
+                                 SimpleVector<unsigned char> *ioBuffer ) {
+
+    char code[3];
+    int codeLength = 0;
+
+    while( codeLength < 2 && inEvent[ codeLength ] != '\0' &&
+           inEvent[ codeLength ] != ' ' ) {
+        code[ codeLength ] = inEvent[ codeLength ];
+        codeLength++;
+        }
+    code[ codeLength ] = '\0';
+
+    int codeIndex = getRecordedEventCodeIndex( code );
+
+    if( codeIndex == -1 ) {
+        return false;
+        }
+
+
+    SimpleVector<unsigned char> event;
+    event.push_back( (unsigned char)codeIndex );
+
+    const char *next = &( inEvent[ codeLength ] );
+
+    // leading ints and doubles for each code
+    const char *fields = "";
+
+    switch( code[0] ) {
+        case 'm':
+            if( code[1] == 'b' ) {
+                fields = "iiii";
+                }
+            else {
+                fields = "ii";
+                }
+            break;
+        case 'k':
+        case 's':
+            fields = "iii";
+            break;
+        case 't':
+        case 'T':
+        case 'F':
+            fields = "d";
+            break;
+        case 'w':
+            fields = "ii";
+            break;
+        case 'x':
+            if( code[1] == 'o' ) {
+                // handle, type, length, side stream chunk, offset
+                fields = "iiiii";
+                }
+            else {
+                fields = "iii";
+                }
+            break;
+        case 'a':
+            fields = "i";
+            break;
+        }
+
+    int values[5];
+    int numFields = strlen( fields );
+
+    for( int f=0; f<numFields; f++ ) {
+        char *end;
+
+        if( fields[f] == 'd' ) {
+            double d = strtod( next, &end );
+            appendDouble( &event, d );
+            }
+        else {
+            // handles are recorded with %u
+            values[f] = (int)strtoll( next, &end, 10 );
+            appendVarInt( &event, values[f] );
+            }
+
+        if( end == next ) {
+            return false;
+            }
+        next = end;
+        }
+
+
+    // bodies
+    if( code[0] == 'w' && values[1] == 2 ) {
+        char *end;
+        int length = (int)strtol( next, &end, 10 );
+
+        if( end == next || *end != ' ' || length < 0 ) {
+            return false;
+            }
+        const char *body = &( end[1] );
+
+        if( (int)strlen( body ) < length ) {
+            return false;
+            }
+
+        appendVarInt( &event, length );
+
+        if( code[1] == 'b' ) {
+            for( int i=0; i<length; i++ ) {
+                event.push_back( (unsigned char)body[i] );
+                }
+            }
+        else {
+            // length is that of hex string
+            if( ! appendHexBytes( &event, body, length / 2 ) ) {
+                return false;
+                }
+            }
+        }
+    else if( code[0] == 'x' && code[1] == 's' && 
+             values[1] == 2 && values[2] > 0 ) {
+        if( *next != ' ' ||
+            (int)strlen( &( next[1] ) ) < values[2] * 2 ||
+            ! appendHexBytes( &event, &( next[1] ), values[2] ) ) {
+            return false;
+            }
+        }
+
+
+    for( int i=0; i<event.size(); i++ ) {
+        ioBuffer->push_back( event.getElementDirect( i ) );
+        }
+    return true;
+    }
+
+
+
+
+/**
+ * Writes event batches to a binary recording file, after its header.
+ */
+class BinaryRecordedEventWriter {
+    public:
+
+        // inFile must already contain the file header
+        // not closed when this writer is destroyed
+        BinaryRecordedEventWriter( FILE *inFile )
+                : mFile( inFile ), mNumBlockBatches( 0 ),
+                  mNumBatchEvents( 0 ) {
+            }
+
+
+        // writes out any partial block
+        ~BinaryRecordedEventWriter() {
+            flushBlock();
+            }
+
+
+        // event strings are not destroyed
+        void addEvent( const char *inEvent ) {
+            if( encodeRecordedEvent( inEvent, &mBatch ) ) {
+                mNumBatchEvents++;
+                }
+            else {
+                AppLog::getLog()->logPrintf(
+                    Log::ERROR_LEVEL,
+                    "Failed to encode recorded event '%s'", inEvent );
+                }
+            }
+
+
+        void endBatch() {
+            appendVarUInt( &mBlock, mNumBatchEvents );
+
+            for( int i=0; i<mBatch.size(); i++ ) {
+                mBlock.push_back( mBatch.getElementDirect( i ) );
+                }
+            mBatch.deleteAll();
+            mNumBatchEvents = 0;
+
+            mNumBlockBatches++;
+
+            if( mNumBlockBatches >= BINARY_EVENT_BLOCK_BATCHES ||
+                mBlock.size() >= BINARY_EVENT_BLOCK_BYTES ) {
+                flushBlock();
+                }
+            }
+
+
+        void flushBlock() {
+            if( mNumBlockBatches == 0 ) {
+                return;
+                }
+
+            unsigned char *raw = mBlock.getElementArray();
+            int rawLength = mBlock.size();
+
+            int compressedLength;
+            unsigned char *compressed =
+                zipCompress( raw, rawLength, &compressedLength );
+
+            delete [] raw;
+
+            if( compressed != NULL ) {
+                SimpleVector<unsigned char> header;
+
+                appendVarUInt( &header, mNumBlockBatches );
+                appendVarUInt( &header, rawLength );
+                appendVarUInt( &header, compressedLength );
+
+                unsigned char *headerBytes = header.getElementArray();
+                fwrite( headerBytes, 1, header.size(), mFile );
+                delete [] headerBytes;
+
+                int numWritten =
+                    fwrite( compressed, 1, compressedLength, mFile );
+
+                if( numWritten != compressedLength ) {
+                    AppLog::error( "Failed to write event block to "
+                                   "recording file" );
+                    }
+
+                delete [] compressed;
+
+                fflush( mFile );
+                }
+
+            mBlock.deleteAll();
+            mNumBlockBatches = 0;
+            }
+
+
+    protected:
+        FILE *mFile;
+
+        SimpleVector<unsigned char> mBlock;
+        int mNumBlockBatches;
+
+        SimpleVector<unsigned char> mBatch;
+        int mNumBatchEvents;
+    };
+
+
+
+
+/**
+ * Reads recorded event batches, one field at a time, from either format.
+ *
+ * Fields must be read in the order that they appear in the event's text
+ * form.  A field read past the end of the data returns 0.
+ */
+class RecordedEventReader {
+    public:
+
+        virtual ~RecordedEventReader() {
+            }
+
+
+        // starts the next batch
+        // returns false at the end of the recording
+        virtual char readBatchSize( int *outNumEvents ) = 0;
+
+        // two characters plus terminating \0
+        virtual void readCode( char outCode[3] ) = 0;
+
+        virtual int readInt() = 0;
+
+        virtual double readDouble() = 0;
+
+
+        /**
+         * Reads an event body that follows earlier fields.
+         *
+         * @param outBytes where inNumBytes bytes should be returned.
+         * @param inNumBytes the number of body bytes.
+         * @param inHex true if the body is hex-encoded in text form.
+         *
+         * @return true on success.
+         */
+        virtual char readBody( unsigned char *outBytes, int inNumBytes,
+                               char inHex ) = 0;
+    };
+
+
+
+
+// the original text format
+class TextRecordedEventReader : public RecordedEventReader {
+    public:
+
+        // inFile positioned after header line
+        // not closed when this reader is destroyed
+        TextRecordedEventReader( FILE *inFile )
+                : mFile( inFile ) {
+            }
+
+
+        virtual char readBatchSize( int *outNumEvents ) {
+            int numRead = fscanf( mFile, "%d", outNumEvents );
+
+            return ( numRead == 1 );
+            }
+
+
+        virtual void readCode( char outCode[3] ) {
+            outCode[0] = '\0';
+            fscanf( mFile, "%2s", outCode );
+            }
+
+
+        virtual int readInt() {
+            int value = 0;
+            fscanf( mFile, "%d", &value );
+            return value;
+            }
+
+
+        virtual double readDouble() {
+            double value = 0;
+            fscanf( mFile, "%lf", &value );
+            return value;
+            }
+
+
+        virtual char readBody( unsigned char *outBytes, int inNumBytes,
+                               char inHex ) {
+            // skip the space before body
+            fgetc( mFile );
+
+            if( ! inHex ) {
+                int numRead = fread( outBytes, 1, inNumBytes, mFile );
+
+                return ( numRead == inNumBytes );
+                }
+
+            int hexLength = inNumBytes * 2;
+
+            char *hex = new char[ hexLength + 1 ];
+
+            int numRead = fread( hex, 1, hexLength, mFile );
+            hex[ numRead ] = '\0';
+
+            char success = false;
+
+            if( numRead == hexLength ) {
+                unsigned char *decoded = hexDecode( hex );
+
+                if( decoded != NULL ) {
+                    memcpy( outBytes, decoded, inNumBytes );
+                    delete [] decoded;
+                    success = true;
+                    }
+                }
+
+            delete [] hex;
+
+            return success;
+            }
+
+
+    protected:
+        FILE *mFile;
+    };
+
+
+
+
+class BinaryRecordedEventReader : public RecordedEventReader {
+    public:
+
+        // inFile positioned at first block
+        // not closed when this reader is destroyed
+        BinaryRecordedEventReader( FILE *inFile )
+                : mFile( inFile ), mBlock( NULL ), mBlockLength( 0 ),
+                  mPosition( 0 ), mBlockBatchesLeft( 0 ) {
+            }
+
+
+        virtual ~BinaryRecordedEventReader() {
+            if( mBlock != NULL ) {
+                delete [] mBlock;
+                }
+            }
+
+
+        // total batches in file from current position on,
+        // found by skipping from block header to block header
+        int countBatches() {
+            long start = ftell( mFile );
+
+            int total = 0;
+
+            unsigned int numBatches, rawLength, compressedLength;
+
+            while( readVarUInt( mFile, &numBatches ) &&
+                   readVarUInt( mFile, &rawLength ) &&
+                   readVarUInt( mFile, &compressedLength ) ) {
+
+                if( fseek( mFile, compressedLength, SEEK_CUR ) != 0 ) {
+                    break;
+                    }
+                total += numBatches;
+                }
+
+            clearerr( mFile );
+            fseek( mFile, start, SEEK_SET );
+
+            return total;
+            }
+
+
+        virtual char readBatchSize( int *outNumEvents ) {
+            if( mBlockBatchesLeft == 0 && ! readBlock() ) {
+                return false;
+                }
+
+            mBlockBatchesLeft--;
+
+            *outNumEvents =
+                (int)decodeVarUInt( mBlock, mBlockLength, &mPosition );
+            return true;
+            }
+
+
+        virtual void readCode( char outCode[3] ) {
+            outCode[0] = '\0';
+
+            if( mPosition >= mBlockLength ) {
+                return;
+                }
+
+            int index = mBlock[ mPosition ];
+            mPosition++;
+
+            if( index < numRecordedEventCodes ) {
+                strcpy( outCode, recordedEventCodes[ index ] );
+                }
+            else {
+                // let caller flag it as unknown
+                outCode[0] = '?';
+                outCode[1] = '\0';
+                }
+            }
+
+
+        virtual int readInt() {
+            return decodeVarInt( mBlock, mBlockLength, &mPosition );
+            }
+
+
+        virtual double readDouble() {
+            return decodeDouble( mBlock, mBlockLength, &mPosition );
+            }
+
+
+        virtual char readBody( unsigned char *outBytes, int inNumBytes,
+                               char inHex ) {
+            if( inNumBytes < 0 || mBlockLength - mPosition < inNumBytes ) {
+                mPosition = mBlockLength;
+                return false;
+                }
+
+            memcpy( outBytes, &( mBlock[ mPosition ] ), inNumBytes );
+            mPosition += inNumBytes;
+
+            return true;
+            }
+
+
+    protected:
+        FILE *mFile;
+
+        unsigned char *mBlock;
+        int mBlockLength;
+        int mPosition;
+
+        int mBlockBatchesLeft;
+
+
+        // returns false at end of file or on a damaged block
+        char readBlock() {
+            if( mBlock != NULL ) {
+                delete [] mBlock;
+                mBlock = NULL;
+                }
+            mBlockLength = 0;
+            mPosition = 0;
+
+            unsigned int numBatches, rawLength, compressedLength;
+
+            if( ! readVarUInt( mFile, &numBatches ) ||
+                ! readVarUInt( mFile, &rawLength ) ||
+                ! readVarUInt( mFile, &compressedLength ) ||
+                numBatches == 0 ) {
+                return false;
+                }
+
+            unsigned char *compressed = new unsigned char[ compressedLength ];
+
+            unsigned int numRead =
+                fread( compressed, 1, compressedLength, mFile );
+
+            if( numRead != compressedLength ) {
+                AppLog::error( "Truncated event block in playback file" );
+                delete [] compressed;
+                return false;
+                }
+
+            mBlock = zipDecompress( compressed, compressedLength, rawLength );
+
+            delete [] compressed;
+
+            if( mBlock == NULL ) {
+                AppLog::error( "Failed to decompress event block in "
+                               "playback file" );
+                return false;
+                }
+
+            mBlockLength = rawLength;
+            mBlockBatchesLeft = numBatches;
+
+            return true;
+            }
+
+    };
+
+
+/**
+ * Writes socket bodies to a side stream file, after its magic.
+ */
+class SocketBodyWriter {
+    public:
+
+        // inFile must already contain SOCKET_BODY_FILE_MAGIC
+        // not closed when this writer is destroyed
+        SocketBodyWriter( FILE *inFile )
+                : mFile( inFile ), mNumChunksWritten( 0 ) {
+            }
+
+
+        // writes out any partial chunk
+        ~SocketBodyWriter() {
+            flushChunk();
+            }
+
+
+        // inBytes destroyed by caller
+        void addBody( unsigned char *inBytes, int inNumBytes,
+                      int *outChunk, int *outOffset ) {
+            *outChunk = mNumChunksWritten;
+            *outOffset = mChunk.size();
+
+            mChunk.appendArray( inBytes, inNumBytes );
+
+            if( mChunk.size() >= SOCKET_BODY_CHUNK_BYTES ) {
+                flushChunk();
+                }
+            }
+
+
+        void flushChunk() {
+            if( mChunk.size() == 0 ) {
+                return;
+                }
+
+            unsigned char *raw = mChunk.getElementArray();
+            int rawLength = mChunk.size();
+
+            int compressedLength;
+            unsigned char *compressed =
+                zipCompress( raw, rawLength, &compressedLength );
+
+            delete [] raw;
+
+            if( compressed != NULL ) {
+                SimpleVector<unsigned char> header;
+
+                appendVarUInt( &header, rawLength );
+                appendVarUInt( &header, compressedLength );
+
+                unsigned char *headerBytes = header.getElementArray();
+                fwrite( headerBytes, 1, header.size(), mFile );
+                delete [] headerBytes;
+
+                int numWritten =
+                    fwrite( compressed, 1, compressedLength, mFile );
+
+                if( numWritten != compressedLength ) {
+                    AppLog::error( "Failed to write socket body chunk to "
+                                   "side stream file" );
+                    }
+
+                delete [] compressed;
+
+                fflush( mFile );
+                }
+            else {
+                // keep chunk numbering in step with events that have 
+                // already been written, leaving an empty chunk
+                AppLog::error( "Failed to compress socket body chunk" );
+
+                unsigned char emptyHeader[2] = { 0, 0 };
+                fwrite( emptyHeader, 1, 2, mFile );
+                }
+
+            mChunk.deleteAll();
+            mNumChunksWritten++;
+            }
+
+
+    protected:
+        FILE *mFile;
+
+        SimpleVector<unsigned char> mChunk;
+        int mNumChunksWritten;
+    };
+
+
+
+
+/**
+ * Reads socket bodies from a side stream file on demand, holding only one
+ * decompressed chunk in memory at a time.
+ */
+class SocketBodyReader {
+    public:
+
+        // inFile positioned after SOCKET_BODY_FILE_MAGIC
+        // not closed when this reader is destroyed
+        //
+        // indexes chunk positions by skipping from chunk header to 
+        // chunk header
+        SocketBodyReader( FILE *inFile )
+                : mFile( inFile ), mChunkNumber( -1 ), mChunk( NULL ),
+                  mChunkLength( 0 ) {
+
+            long offset = ftell( mFile );
+
+            unsigned int rawLength, compressedLength;
+
+            while( readVarUInt( mFile, &rawLength ) &&
+                   readVarUInt( mFile, &compressedLength ) ) {
+
+                mChunkOffsets.push_back( offset );
+
+                if( fseek( mFile, compressedLength, SEEK_CUR ) != 0 ) {
+                    break;
+                    }
+                offset = ftell( mFile );
+                }
+
+            clearerr( mFile );
+            }
+
+
+        ~SocketBodyReader() {
+            if( mChunk != NULL ) {
+                delete [] mChunk;
+                }
+            }
+
+
+        int getNumChunks() {
+            return mChunkOffsets.size();
+            }
+
+
+        /**
+         * Gets a body.
+         *
+         * @return the body bytes, or NULL if it's missing or damaged.
+         *   Destroyed by caller.
+         */
+        unsigned char *getBody( int inChunk, int inOffset, int inNumBytes ) {
+            if( inChunk != mChunkNumber && ! readChunk( inChunk ) ) {
+                return NULL;
+                }
+
+            if( inOffset < 0 || inNumBytes < 0 ||
+                inOffset > mChunkLength - inNumBytes ) {
+                return NULL;
+                }
+
+            unsigned char *body = new unsigned char[ inNumBytes ];
+            memcpy( body, &( mChunk[ inOffset ] ), inNumBytes );
+
+            return body;
+            }
+
+
+    protected:
+        FILE *mFile;
+
+        SimpleVector<long> mChunkOffsets;
+
+        int mChunkNumber;
+        unsigned char *mChunk;
+        int mChunkLength;
+
+
+        // returns false if chunk is missing or damaged
+        char readChunk( int inChunk ) {
+            if( mChunk != NULL ) {
+                delete [] mChunk;
+                mChunk = NULL;
+                }
+            mChunkLength = 0;
+            mChunkNumber = -1;
+
+            if( inChunk < 0 || inChunk >= mChunkOffsets.size() ) {
+                return false;
+                }
+
+            fseek( mFile, mChunkOffsets.getElementDirect( inChunk ), 
+                   SEEK_SET );
+
+            unsigned int rawLength, compressedLength;
+
+            if( ! readVarUInt( mFile, &rawLength ) ||
+                ! readVarUInt( mFile, &compressedLength ) ) {
+                return false;
+                }
+
+            unsigned char *compressed = new unsigned char[ compressedLength ];
+
+            unsigned int numRead =
+                fread( compressed, 1, compressedLength, mFile );
+
+            if( numRead != compressedLength ) {
+                AppLog::error( "Truncated chunk in socket body file" );
+                delete [] compressed;
+                return false;
+                }
+
+            mChunk = zipDecompress( compressed, compressedLength, rawLength );
+
+            delete [] compressed;
+
+            if( mChunk == NULL ) {
+                AppLog::error( "Failed to decompress chunk in socket body "
+                               "file" );
+                return false;
+                }
+
+            mChunkLength = rawLength;
+            mChunkNumber = inChunk;
+
+            return true;
+            }
+
+    };
+
+
+
+#endif
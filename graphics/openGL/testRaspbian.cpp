@@ -38,7 +38,7 @@ static void drawStuff() {
 
 
 int main() {
-    raspbianCreateSurface();
+    raspbianCreateSurface( 0, 0 );
     
     while( true ) {
         drawStuff();
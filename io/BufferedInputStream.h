@@ -0,0 +1,329 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+#include "minorGems/common.h"
+
+
+#ifndef BUFFERED_INPUT_STREAM_CLASS_INCLUDED
+#define BUFFERED_INPUT_STREAM_CLASS_INCLUDED
+
+#include "InputStream.h"
+
+#include <string.h>
+
+
+
+/**
+ * Input stream that reads ahead from another stream into a buffer, so
+ * that small reads (single bytes, protocol lines) don't each reach the
+ * underlying stream.  For a SocketStream, that's one receive call per
+ * buffer-full instead of one per read.
+ *
+ * Because it reads ahead, all reads must go through this stream once it
+ * has been used.  Data buffered here is gone from the underlying stream.
+ *
+ * @author Jason Rohrer
+ */
+class BufferedInputStream : public InputStream {
+
+	public:
+
+		/**
+		 * Constructs a stream.
+		 *
+		 * @param inStream the stream to read from.
+		 *   Not destroyed when this stream is destroyed.
+		 * @param inBufferSize how much to read ahead.  Buffer grows
+		 *   beyond this if readUntil needs more room.
+		 *   Defaults to 64 KiB.
+		 */
+		BufferedInputStream( InputStream *inStream,
+                             int inBufferSize = 65536 );
+
+		virtual ~BufferedInputStream();
+
+
+        // implements the InputStream interface
+        // like underlying stream, only returns less than inNumBytes at
+        // end of stream or on error (or timeout, for streams that have
+        // them)
+		virtual long read( unsigned char *inBuffer, long inNumBytes );
+
+        // returns buffered bytes if there are any, without reading
+		virtual long readAvailable( unsigned char *inBuffer,
+                                    long inMaxBytes );
+
+
+
+        /**
+         * Gets the next byte without removing it from the stream.
+         *
+         * @return 1 on success, or the underlying stream's error result.
+         */
+        long peek( unsigned char *outByte );
+
+
+
+        /**
+         * Reads up to and including the first occurrence of a delimiter.
+         *
+         * @param inDelimiter the \0-terminated delimiter to look for.
+         * @param inMaxBytes the most to read, including delimiter.
+         *
+         * @return the bytes read, including delimiter, as a
+         *   \0-terminated string, or NULL on stream error or if
+         *   delimiter not found within inMaxBytes (in which case the
+         *   inMaxBytes already buffered are dropped).
+         *   Must be destroyed by caller if non-NULL.
+         */
+        char *readUntil( const char *inDelimiter, int inMaxBytes );
+
+
+
+        // number of bytes read ahead and waiting in buffer
+        int getNumBuffered();
+
+
+	protected:
+        InputStream *mStream;
+
+        unsigned char *mBuffer;
+        int mBufferSize;
+
+        // buffered data is mBuffer[ mStart ] up to mBuffer[ mEnd - 1 ]
+        int mStart;
+        int mEnd;
+
+
+        // reads more into buffer, moving buffered data to start of
+        // buffer first, and growing it to hold inMinSize bytes
+        // returns number read, or error from underlying stream
+        long fill( int inMinSize );
+	};
+
+
+
+inline BufferedInputStream::BufferedInputStream( InputStream *inStream,
+                                                 int inBufferSize )
+        : mStream( inStream ),
+          mBuffer( new unsigned char[ inBufferSize ] ),
+          mBufferSize( inBufferSize ),
+          mStart( 0 ), mEnd( 0 ) {
+    }
+
+
+
+inline BufferedInputStream::~BufferedInputStream() {
+    delete [] mBuffer;
+    }
+
+
+
+inline int BufferedInputStream::getNumBuffered() {
+    return mEnd - mStart;
+    }
+
+
+
+inline long BufferedInputStream::fill( int inMinSize ) {
+    int numBuffered = mEnd - mStart;
+
+    if( inMinSize > mBufferSize ) {
+        int newSize = mBufferSize * 2;
+        if( newSize < inMinSize ) {
+            newSize = inMinSize;
+            }
+
+        unsigned char *newBuffer = new unsigned char[ newSize ];
+        memcpy( newBuffer, &( mBuffer[ mStart ] ), numBuffered );
+
+        delete [] mBuffer;
+        mBuffer = newBuffer;
+        mBufferSize = newSize;
+        }
+    else if( mStart > 0 ) {
+        memmove( mBuffer, &( mBuffer[ mStart ] ), numBuffered );
+        }
+
+    mStart = 0;
+    mEnd = numBuffered;
+
+    long numRead = mStream->readAvailable( &( mBuffer[ mEnd ] ),
+                                           mBufferSize - mEnd );
+
+    if( numRead > 0 ) {
+        mEnd += numRead;
+        }
+    else {
+        setNewLastErrorConst( "Reading underlying stream failed." );
+        }
+
+    return numRead;
+    }
+
+
+
+inline long BufferedInputStream::read( unsigned char *inBuffer,
+                                       long inNumBytes ) {
+    long numCopied = 0;
+
+    while( numCopied < inNumBytes ) {
+        int numBuffered = mEnd - mStart;
+
+        if( numBuffered > 0 ) {
+            long numToCopy = inNumBytes - numCopied;
+            if( numToCopy > numBuffered ) {
+                numToCopy = numBuffered;
+                }
+
+            memcpy( &( inBuffer[ numCopied ] ), &( mBuffer[ mStart ] ),
+                    numToCopy );
+            mStart += numToCopy;
+            numCopied += numToCopy;
+            }
+        else if( inNumBytes - numCopied >= mBufferSize ) {
+            // big read, skip buffer
+            long numRead = mStream->read( &( inBuffer[ numCopied ] ),
+                                          inNumBytes - numCopied );
+            if( numRead <= 0 ) {
+                if( numCopied > 0 ) {
+                    return numCopied;
+                    }
+                return numRead;
+                }
+            numCopied += numRead;
+            }
+        else {
+            long numRead = fill( 0 );
+
+            if( numRead <= 0 ) {
+                if( numCopied > 0 ) {
+                    return numCopied;
+                    }
+                return numRead;
+                }
+            }
+        }
+
+    return numCopied;
+    }
+
+
+
+inline long BufferedInputStream::readAvailable( unsigned char *inBuffer,
+                                                long inMaxBytes ) {
+    if( inMaxBytes < 1 ) {
+        return 0;
+        }
+
+    if( mEnd == mStart ) {
+        long numRead = fill( 0 );
+
+        if( numRead <= 0 ) {
+            return numRead;
+            }
+        }
+
+    long numToCopy = mEnd - mStart;
+    if( numToCopy > inMaxBytes ) {
+        numToCopy = inMaxBytes;
+        }
+
+    memcpy( inBuffer, &( mBuffer[ mStart ] ), numToCopy );
+    mStart += numToCopy;
+
+    return numToCopy;
+    }
+
+
+
+inline long BufferedInputStream::peek( unsigned char *outByte ) {
+    if( mEnd == mStart ) {
+        long numRead = fill( 0 );
+
+        if( numRead <= 0 ) {
+            return numRead;
+            }
+        }
+
+    *outByte = mBuffer[ mStart ];
+    return 1;
+    }
+
+
+
+inline char *BufferedInputStream::readUntil( const char *inDelimiter,
+                                             int inMaxBytes ) {
+    int delimiterLength = strlen( inDelimiter );
+
+    if( delimiterLength == 0 ) {
+        return NULL;
+        }
+
+    unsigned char firstByte = (unsigned char)( inDelimiter[0] );
+
+    // offset from mStart where search resumes, so that bytes already
+    // searched aren't searched again after each fill
+    int searchOffset = 0;
+
+    while( true ) {
+        int numBuffered = mEnd - mStart;
+
+        // only search as far as limit allows
+        int searchEnd = numBuffered;
+        if( searchEnd > inMaxBytes ) {
+            searchEnd = inMaxBytes;
+            }
+
+        const unsigned char *bufferStart = &( mBuffer[ mStart ] );
+
+        while( searchOffset + delimiterLength <= searchEnd ) {
+            const unsigned char *candidate =
+                (const unsigned char *)memchr(
+                    &( bufferStart[ searchOffset ] ), firstByte,
+                    searchEnd - delimiterLength + 1 - searchOffset );
+
+            if( candidate == NULL ) {
+                searchOffset = searchEnd - delimiterLength + 1;
+                break;
+                }
+
+            if( memcmp( candidate, inDelimiter, delimiterLength ) == 0 ) {
+                int length =
+                    (int)( candidate - bufferStart ) + delimiterLength;
+
+                char *result = new char[ length + 1 ];
+                memcpy( result, bufferStart, length );
+                result[ length ] = '\0';
+
+                mStart += length;
+
+                return result;
+                }
+
+            searchOffset = (int)( candidate - bufferStart ) + 1;
+            }
+
+        if( numBuffered >= inMaxBytes ) {
+            // limit reached without finding delimiter
+            mStart += inMaxBytes;
+            return NULL;
+            }
+
+        // search continues at same offset from mStart, which fill
+        // may move
+        long numRead = fill( inMaxBytes );
+
+        if( numRead <= 0 ) {
+            return NULL;
+            }
+        }
+    }
+
+
+
+#endif
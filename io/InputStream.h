@@ -24,6 +24,10 @@
  *
  * 2004-May-9   Jason Rohrer
  * Added support for shorts.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Added readAvailable, for buffered readers.
+ * Fixed readShort reading 4 bytes into its 2-byte buffer.
  */
 
 #include "minorGems/common.h"
@@ -64,6 +68,24 @@ class InputStream : public Stream {
 
 
 
+        /**
+         * Reads at least one byte, and up to inMaxBytes, without waiting
+         * for more once some are available.
+         *
+         * For filling buffers (see BufferedInputStream), where read would
+         * block until the whole buffer arrived.
+         *
+         * The default reads one byte.  Streams that can do better
+         * override it.
+         *
+         * @return the number of bytes read, or -1 for a stream error.
+         *   Streams may return their own error codes from read here too.
+         */
+        virtual long readAvailable( unsigned char *inBuffer,
+                                    long inMaxBytes );
+
+
+
         /**
          * Reads a byte from this stream.
          *
@@ -149,6 +171,16 @@ inline long InputStream::readByte( unsigned char *outByte ) {
 
 
 
+inline long InputStream::readAvailable( unsigned char *inBuffer,
+                                        long inMaxBytes ) {
+    if( inMaxBytes < 1 ) {
+        return 0;
+        }
+    return read( inBuffer, 1 );
+    }
+
+
+
 inline long InputStream::readDouble( double *outDouble ) {
 	int numBytes = read( mDoubleBuffer, 8 );
 	*outDouble = TypeIO::bytesToDouble( mDoubleBuffer );
@@ -168,7 +200,7 @@ inline long InputStream::readLong( long *outLong ) {
 
 
 inline long InputStream::readShort( short *outShort ) {
-	int numBytes = read( mShortBuffer, 4 );
+	int numBytes = read( mShortBuffer, 2 );
 	*outShort = TypeIO::bytesToShort( mShortBuffer );
 	
 	return numBytes;
@@ -5,7 +5,12 @@
  * Created.
  *
  * 2001-February-20		Jason Rohrer
- * Added a missing return value. 
+ * Added a missing return value.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Switched to a ring buffer, so writes don't allocate and reads don't
+ * shift buffer lists.
+ * Added zero-copy peek/commit functions and optional blocking mode.
  */
 
 #include "minorGems/common.h"
@@ -18,7 +23,8 @@
 #include "minorGems/io/InputStream.h"
 #include "minorGems/io/OutputStream.h"
 
-#include "minorGems/util/SimpleVector.h"
+#include "minorGems/system/MutexLock.h"
+#include "minorGems/system/BinarySemaphore.h"
 
 #include <string.h>
 
@@ -26,151 +32,513 @@
  * An input/output stream that can server as a pipe between
  * two components that read from and write to streams.
  *
- * Buffered internally to prevent blocking, so is compatible
- * with non-threaded components.  Note, however, that
- * ever buffer written to the stream is copied internally, 
- * so max memory usage is doubled.
+ * Data is held in a ring buffer whose size is a power of two.
  *
+ * By default, the buffer grows as needed so that writes never block, so
+ * is compatible with non-threaded components.  In this mode, reads
+ * return what is available (see read), and the stream
  * IS NOT THREAD-SAFE!
  *
+ * In blocking mode, the stream is a pipe between one writing thread
+ * and one reading thread.  The buffer keeps its starting size, writes
+ * wait for space, and reads wait for data until closeWrite is called.
+ *
  * @author Jason Rohrer
- */ 
+ */
 class PipedStream : public InputStream, public OutputStream {
 
 	public:
-		
+
 		/**
 		 * Constructs a PipedStream.
+		 *
+		 * @param inBlocking true to make a thread-safe stream with
+		 *   blocking reads and writes.  Defaults to false.
+		 * @param inBufferSize the starting buffer size, rounded up to
+		 *   a power of two.  In blocking mode, the buffer stays this
+		 *   size.  Defaults to 4096.
 		 */
-		PipedStream();
-		
+		PipedStream( char inBlocking = false, long inBufferSize = 4096 );
+
 		/**
-		 * Destroys any pending unread buffers.
+		 * Destroys any pending unread data.
 		 */
 		~PipedStream();
-		
-		
-		
-		
+
+
+
+
 		// implements the InputStream interface
+		// in non-blocking mode, returns the number of bytes read,
+		// which is less than inNumBytes if not enough are available
+		// in blocking mode, waits for inNumBytes, returning fewer only
+		// after closeWrite
 		long read( unsigned char *inBuffer, long inNumBytes );
-		
-		
+
+		// returns what is available, waiting for at least one byte
+		// in blocking mode
+		long readAvailable( unsigned char *inBuffer, long inMaxBytes );
+
+
 		// implements the OutputStream interface
+		// in blocking mode, returns -1 after closeWrite
 		long write( unsigned char *inBuffer, long inNumBytes );
-		
-		
+
+
+
+		/**
+		 * Gets the next contiguous block of buffered data, without
+		 * copying it or removing it from the stream.
+		 *
+		 * There may be more data after this block, where the
+		 * ring buffer wraps.
+		 *
+		 * In blocking mode, waits for at least one byte.
+		 *
+		 * @param outNumBytes pointer to where the block length should
+		 *   be returned.
+		 *
+		 * @return the block, or NULL if there is no data (in blocking
+		 *   mode, no data after closeWrite).
+		 *   Valid until commitRead (and, in non-blocking mode, until
+		 *   the next write).
+		 */
+		unsigned char *peekRead( long *outNumBytes );
+
+		/**
+		 * Removes data returned by peekRead from the stream.
+		 *
+		 * @param inNumBytes how much to remove, at most outNumBytes
+		 *   from peekRead.
+		 */
+		void commitRead( long inNumBytes );
+
+
+		/**
+		 * Gets the next contiguous block of free buffer space, for
+		 * writing without an extra copy.
+		 *
+		 * In non-blocking mode, grows buffer if it is full.
+		 * In blocking mode, waits for at least one free byte.
+		 *
+		 * @param outNumBytes pointer to where the block length should
+		 *   be returned.
+		 *
+		 * @return the block, or NULL in blocking mode after closeWrite.
+		 *   Valid until commitWrite.
+		 */
+		unsigned char *peekWrite( long *outNumBytes );
+
+		/**
+		 * Adds data written into the block returned by peekWrite
+		 * to the stream.
+		 *
+		 * @param inNumBytes how much was written, at most outNumBytes
+		 *   from peekWrite.
+		 */
+		void commitWrite( long inNumBytes );
+
+
+		/**
+		 * Marks the end of the written data.  In blocking mode,
+		 * wakes a waiting reader, and later reads return what is left
+		 * without waiting.
+		 */
+		void closeWrite();
+
+
+		// number of bytes waiting to be read
+		long getNumAvailable();
+
+
 	protected:
-		SimpleVector<unsigned char *> *mBuffers;	
-		SimpleVector<long> *mBufferSizes;
-		
-		long mCurrentBufferIndex;
-		
-	};		
+		unsigned char *mBuffer;
+
+		// always a power of two
+		long mBufferSize;
+
+		long mReadIndex;
+		long mNumBytes;
+
+		char mWriteClosed;
+
+		// only used in blocking mode, NULL otherwise
+		MutexLock *mLock;
+		BinarySemaphore *mDataSemaphore;
+		BinarySemaphore *mSpaceSemaphore;
+
+
+		void lock();
+		void unlock();
+
+		// in blocking mode, waits (with lock held) until data is
+		// available or writing is closed
+		void waitForData();
+
+		// in blocking mode, waits (with lock held) until space is
+		// available or writing is closed
+		// in non-blocking mode, grows buffer to fit inNumBytes more
+		void waitForSpace( long inNumBytes );
+
+		long getWriteIndex();
+
+		// copies up to inMaxBytes out of buffer and removes them,
+		// returning number copied
+		// lock must be held
+		long copyOut( unsigned char *inBuffer, long inMaxBytes );
+
+		// copies up to inMaxBytes into free space,
+		// returning number copied
+		// lock must be held
+		long copyIn( unsigned char *inBuffer, long inMaxBytes );
+
+	};
+
+
+
+inline PipedStream::PipedStream( char inBlocking, long inBufferSize )
+	: mReadIndex( 0 ), mNumBytes( 0 ),
+	  mWriteClosed( false ),
+	  mLock( NULL ), mDataSemaphore( NULL ), mSpaceSemaphore( NULL ) {
 
+	mBufferSize = 1;
+	while( mBufferSize < inBufferSize ) {
+		mBufferSize *= 2;
+		}
 
+	mBuffer = new unsigned char[ mBufferSize ];
 
-inline PipedStream::PipedStream()
-	: mBuffers( new SimpleVector<unsigned char*>() ),
-	mBufferSizes( new SimpleVector<long>() ),
-	mCurrentBufferIndex( 0 ) {
-	
+	if( inBlocking ) {
+		mLock = new MutexLock();
+		mDataSemaphore = new BinarySemaphore();
+		mSpaceSemaphore = new BinarySemaphore();
+		}
 	}
 
-		
+
 
 inline PipedStream::~PipedStream() {
-	int numRemaining = mBuffers->size();
-	for( int i=0; i<numRemaining; i++ ) {
-		unsigned char *buffer = *( mBuffers->getElement( i ) );
-		
-		delete [] buffer;
+	delete [] mBuffer;
+
+	if( mLock != NULL ) {
+		delete mLock;
+		delete mDataSemaphore;
+		delete mSpaceSemaphore;
+		}
+	}
+
+
+
+inline void PipedStream::lock() {
+	if( mLock != NULL ) {
+		mLock->lock();
+		}
+	}
+
+
+
+inline void PipedStream::unlock() {
+	if( mLock != NULL ) {
+		mLock->unlock();
+		}
+	}
+
+
+
+inline void PipedStream::waitForData() {
+	if( mLock == NULL ) {
+		return;
+		}
+
+	while( mNumBytes == 0 && ! mWriteClosed ) {
+		mLock->unlock();
+		mDataSemaphore->wait();
+		mLock->lock();
+		}
+	}
+
+
+
+inline void PipedStream::waitForSpace( long inNumBytes ) {
+	if( mLock != NULL ) {
+		while( mNumBytes == mBufferSize && ! mWriteClosed ) {
+			mLock->unlock();
+			mSpaceSemaphore->wait();
+			mLock->lock();
+			}
+		return;
+		}
+
+	if( mNumBytes + inNumBytes <= mBufferSize ) {
+		return;
+		}
+
+	long newSize = mBufferSize;
+	while( newSize < mNumBytes + inNumBytes ) {
+		newSize *= 2;
+		}
+
+	unsigned char *newBuffer = new unsigned char[ newSize ];
+
+	// unwrap data to start of new buffer
+	long numCopied = copyOut( newBuffer, mNumBytes );
+
+	delete [] mBuffer;
+	mBuffer = newBuffer;
+	mBufferSize = newSize;
+	mReadIndex = 0;
+	mNumBytes = numCopied;
+	}
+
+
+
+inline long PipedStream::getWriteIndex() {
+	return ( mReadIndex + mNumBytes ) & ( mBufferSize - 1 );
+	}
+
+
+
+inline long PipedStream::copyOut( unsigned char *inBuffer,
+								  long inMaxBytes ) {
+	long numToCopy = mNumBytes;
+	if( numToCopy > inMaxBytes ) {
+		numToCopy = inMaxBytes;
+		}
+
+	// up to end of buffer, then wrapped part
+	long firstPart = mBufferSize - mReadIndex;
+	if( firstPart > numToCopy ) {
+		firstPart = numToCopy;
+		}
+
+	memcpy( inBuffer, &( mBuffer[ mReadIndex ] ), firstPart );
+	memcpy( &( inBuffer[ firstPart ] ), mBuffer, numToCopy - firstPart );
+
+	mReadIndex = ( mReadIndex + numToCopy ) & ( mBufferSize - 1 );
+	mNumBytes -= numToCopy;
+
+	return numToCopy;
+	}
+
+
+
+inline long PipedStream::copyIn( unsigned char *inBuffer,
+								 long inMaxBytes ) {
+	long numToCopy = mBufferSize - mNumBytes;
+	if( numToCopy > inMaxBytes ) {
+		numToCopy = inMaxBytes;
 		}
-	delete mBuffers;
-	delete mBufferSizes;
+
+	long writeIndex = getWriteIndex();
+
+	long firstPart = mBufferSize - writeIndex;
+	if( firstPart > numToCopy ) {
+		firstPart = numToCopy;
+		}
+
+	memcpy( &( mBuffer[ writeIndex ] ), inBuffer, firstPart );
+	memcpy( mBuffer, &( inBuffer[ firstPart ] ), numToCopy - firstPart );
+
+	mNumBytes += numToCopy;
+
+	return numToCopy;
 	}
-		
-		
+
+
 
 inline long PipedStream::read( unsigned char *inBuffer, long inNumBytes ) {
-	if( mBuffers->size() == 0 ) {
-		// none read, since no buffers available
+	lock();
+
+	long numRead = 0;
+
+	while( numRead < inNumBytes ) {
+		waitForData();
+
+		if( mNumBytes == 0 ) {
+			break;
+			}
+
+		numRead += copyOut( &( inBuffer[ numRead ] ), inNumBytes - numRead );
+
+		if( mSpaceSemaphore != NULL ) {
+			mSpaceSemaphore->signal();
+			}
+		}
+
+	unlock();
+
+	if( numRead == 0 && inNumBytes > 0 ) {
+		// none read, since no data available
 		InputStream::
 			setNewLastErrorConst( "No data available on piped stream read." );
-		return 0;
-		}
-	else {
-		
-		unsigned char *currentBuffer = *( mBuffers->getElement( 0 ) );
-		long currentBufferSize = *( mBufferSizes->getElement( 0 ) ); 
-
-		long outputIndex = 0;
-
-		while( outputIndex < inNumBytes ) {
-			long bytesRemaining = inNumBytes - outputIndex;
-
-			long bytesRemainingInCurrent = currentBufferSize - mCurrentBufferIndex;
-
-			// if current buffer isn't big enough to fill output
-			if( bytesRemaining >= bytesRemainingInCurrent ) {
-				// copy all of current buffer into inBuffer
-				memcpy( &( inBuffer[outputIndex] ), 
-					&( currentBuffer[mCurrentBufferIndex] ), 
-					bytesRemainingInCurrent );
-
-				outputIndex += bytesRemainingInCurrent;
-
-				// delete the current buffer
-				mBuffers->deleteElement( 0 );
-				mBufferSizes->deleteElement( 0 );
-				delete [] currentBuffer;
-				
-				mCurrentBufferIndex = 0;
-				
-				if( outputIndex != inNumBytes && mBuffers->size() == 0 ) {
-					// partial read, since no more buffers available
-					InputStream::setNewLastErrorConst( 
-						"Partial data available on piped stream read." );
-					return outputIndex;
-					}
-				if( mBuffers->size() != 0 ) {
-					// get the new current buffer 
-					currentBuffer = *( mBuffers->getElement( 0 ) );
-					currentBufferSize = *( mBufferSizes->getElement( 0 ) );
-					}
-				}
-			else {
-				// current buffer is bigger
-				memcpy( &( inBuffer[outputIndex] ), 
-					&( currentBuffer[mCurrentBufferIndex] ), 
-					bytesRemaining );
-				
-				mCurrentBufferIndex += bytesRemaining;
-				outputIndex += bytesRemaining;
-				}
-
-			} // end while
-		
-		// if we made it out of the while loop, we read all bytes
-		return inNumBytes;
-		
-		} // end else
-	}
-	
-		
-		
+		}
+	else if( numRead < inNumBytes ) {
+		// partial read
+		InputStream::setNewLastErrorConst(
+			"Partial data available on piped stream read." );
+		}
+
+	return numRead;
+	}
+
+
+
+inline long PipedStream::readAvailable( unsigned char *inBuffer,
+										long inMaxBytes ) {
+	lock();
+
+	waitForData();
+
+	long numRead = copyOut( inBuffer, inMaxBytes );
+
+	if( numRead > 0 && mSpaceSemaphore != NULL ) {
+		mSpaceSemaphore->signal();
+		}
+
+	unlock();
+
+	return numRead;
+	}
+
+
+
 inline long PipedStream::write( unsigned char *inBuffer, long inNumBytes ) {
-	// add a copy of the buffer to the vector of buffers
-	unsigned char *copy = new unsigned char[ inNumBytes ];
-	
-	memcpy( copy, inBuffer, inNumBytes );
-	
-	mBuffers->push_back( copy );
-	mBufferSizes->push_back( inNumBytes );
-	
+	lock();
+
+	long numWritten = 0;
+
+	while( numWritten < inNumBytes ) {
+		waitForSpace( inNumBytes - numWritten );
+
+		if( mWriteClosed && mLock != NULL ) {
+			unlock();
+			OutputStream::setNewLastErrorConst(
+				"Write to closed piped stream." );
+			return -1;
+			}
+
+		numWritten += copyIn( &( inBuffer[ numWritten ] ),
+							  inNumBytes - numWritten );
+
+		if( mDataSemaphore != NULL ) {
+			mDataSemaphore->signal();
+			}
+		}
+
+	unlock();
+
 	return inNumBytes;
 	}
-	
-	
-	
+
+
+
+inline unsigned char *PipedStream::peekRead( long *outNumBytes ) {
+	lock();
+
+	waitForData();
+
+	long numBytes = mBufferSize - mReadIndex;
+	if( numBytes > mNumBytes ) {
+		numBytes = mNumBytes;
+		}
+
+	unsigned char *block = &( mBuffer[ mReadIndex ] );
+
+	unlock();
+
+	*outNumBytes = numBytes;
+
+	if( numBytes == 0 ) {
+		return NULL;
+		}
+	return block;
+	}
+
+
+
+inline void PipedStream::commitRead( long inNumBytes ) {
+	lock();
+
+	mReadIndex = ( mReadIndex + inNumBytes ) & ( mBufferSize - 1 );
+	mNumBytes -= inNumBytes;
+
+	if( mSpaceSemaphore != NULL ) {
+		mSpaceSemaphore->signal();
+		}
+
+	unlock();
+	}
+
+
+
+inline unsigned char *PipedStream::peekWrite( long *outNumBytes ) {
+	lock();
+
+	waitForSpace( 1 );
+
+	if( mWriteClosed && mLock != NULL ) {
+		unlock();
+		*outNumBytes = 0;
+		return NULL;
+		}
+
+	long writeIndex = getWriteIndex();
+
+	// up to end of buffer, or up to read index if write index
+	// has wrapped
+	long numBytes = mBufferSize - writeIndex;
+	if( numBytes > mBufferSize - mNumBytes ) {
+		numBytes = mBufferSize - mNumBytes;
+		}
+
+	unsigned char *block = &( mBuffer[ writeIndex ] );
+
+	unlock();
+
+	*outNumBytes = numBytes;
+	return block;
+	}
+
+
+
+inline void PipedStream::commitWrite( long inNumBytes ) {
+	lock();
+
+	mNumBytes += inNumBytes;
+
+	if( mDataSemaphore != NULL ) {
+		mDataSemaphore->signal();
+		}
+
+	unlock();
+	}
+
+
+
+inline void PipedStream::closeWrite() {
+	lock();
+
+	mWriteClosed = true;
+
+	if( mLock != NULL ) {
+		// wake any waiters
+		mDataSemaphore->signal();
+		mSpaceSemaphore->signal();
+		}
+
+	unlock();
+	}
+
+
+
+inline long PipedStream::getNumAvailable() {
+	lock();
+	long numBytes = mNumBytes;
+	unlock();
+
+	return numBytes;
+	}
+
+
+
 #endif
@@ -0,0 +1,109 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+#include "minorGems/common.h"
+
+
+#ifndef SERIAL_READER_CLASS_INCLUDED
+#define SERIAL_READER_CLASS_INCLUDED
+
+#include "InputStream.h"
+#include "TypeIO.h"
+
+
+
+/**
+ * Input stream that adds reading of double arrays in one underlying read,
+ * converted in place, for deserializing data written with
+ * SerialWriter::writeDoubles (or with writeDouble in a loop).
+ *
+ * Other reads pass straight through to the underlying stream.  Nothing is
+ * read ahead, so the underlying stream can be used again after
+ * deserializing.  For buffered reads of many small fields, wrap the
+ * underlying stream in a BufferedInputStream first.
+ *
+ * @author Jason Rohrer
+ */
+class SerialReader : public InputStream {
+
+	public:
+
+		/**
+		 * Constructs a reader.
+		 *
+		 * @param inStream the stream to read from.
+		 *   Not destroyed when this reader is destroyed.
+		 */
+		SerialReader( InputStream *inStream );
+
+
+		// implements the InputStream interface
+		virtual long read( unsigned char *inBuffer, long inNumBytes );
+
+		virtual long readAvailable( unsigned char *inBuffer,
+									long inMaxBytes );
+
+
+
+		/**
+		 * Reads an array of doubles, in the same format as
+		 * readDouble.
+		 *
+		 * @param outDoubles array where inNumDoubles doubles will be
+		 *   returned.
+		 *
+		 * @return the number of bytes read, or the underlying stream's
+		 *   error result.  Less than 8 * inNumDoubles if the stream
+		 *   ended early, in which case outDoubles is undefined.
+		 */
+		long readDoubles( double *outDoubles, int inNumDoubles );
+
+
+	protected:
+		InputStream *mStream;
+	};
+
+
+
+inline SerialReader::SerialReader( InputStream *inStream )
+		: mStream( inStream ) {
+	}
+
+
+
+inline long SerialReader::read( unsigned char *inBuffer, long inNumBytes ) {
+	return mStream->read( inBuffer, inNumBytes );
+	}
+
+
+
+inline long SerialReader::readAvailable( unsigned char *inBuffer,
+										 long inMaxBytes ) {
+	return mStream->readAvailable( inBuffer, inMaxBytes );
+	}
+
+
+
+inline long SerialReader::readDoubles( double *outDoubles,
+									   int inNumDoubles ) {
+	long numBytes = inNumDoubles * 8;
+
+	// read raw bytes right into double array
+	long numRead = mStream->read( (unsigned char *)outDoubles, numBytes );
+
+	if( numRead == numBytes ) {
+		// convert in place
+		TypeIO::bytesToDoubles( (unsigned char *)outDoubles,
+								inNumDoubles, outDoubles );
+		}
+
+	return numRead;
+	}
+
+
+
+#endif
@@ -0,0 +1,207 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+#include "minorGems/common.h"
+
+
+#ifndef SERIAL_WRITER_CLASS_INCLUDED
+#define SERIAL_WRITER_CLASS_INCLUDED
+
+#include "OutputStream.h"
+#include "TypeIO.h"
+
+#include <string.h>
+
+
+
+/**
+ * Output stream that collects small writes in a buffer and passes them to
+ * another stream in large blocks.
+ *
+ * For serializing objects with many fields (Primitive3D, Object3D)
+ * to streams where each write is costly, like sockets:
+ *
+ *   SerialWriter writer( stream );
+ *   object->serialize( &writer );
+ *   writer.flush();
+ *
+ * Also adds writing of double arrays in one conversion.
+ *
+ * @author Jason Rohrer
+ */
+class SerialWriter : public OutputStream {
+
+	public:
+
+		/**
+		 * Constructs a writer.
+		 *
+		 * @param inStream the stream to write to.
+		 *   Not destroyed when this writer is destroyed.
+		 * @param inBufferSize the size of blocks passed to inStream.
+		 *   Defaults to 4096.
+		 */
+		SerialWriter( OutputStream *inStream, int inBufferSize = 4096 );
+
+		// flushes
+		virtual ~SerialWriter();
+
+
+		// implements the OutputStream interface
+		// returns inNumBytes, or -1 if an earlier flush failed
+		virtual long write( unsigned char *inBuffer, long inNumBytes );
+
+
+
+		/**
+		 * Writes an array of doubles, in the same format as
+		 * writeDouble.
+		 *
+		 * @return the number of bytes written, or -1 for a stream error.
+		 */
+		long writeDoubles( const double *inDoubles, int inNumDoubles );
+
+
+
+		/**
+		 * Passes buffered data to the underlying stream.
+		 *
+		 * @return true on success, or false if this or any earlier
+		 *   write to the underlying stream failed.
+		 */
+		char flush();
+
+
+	protected:
+		OutputStream *mStream;
+
+		unsigned char *mBuffer;
+		int mBufferSize;
+		int mNumBuffered;
+
+		char mError;
+	};
+
+
+
+inline SerialWriter::SerialWriter( OutputStream *inStream,
+								   int inBufferSize )
+		: mStream( inStream ),
+		  mBuffer( new unsigned char[ inBufferSize ] ),
+		  mBufferSize( inBufferSize ),
+		  mNumBuffered( 0 ),
+		  mError( false ) {
+	}
+
+
+
+inline SerialWriter::~SerialWriter() {
+	flush();
+
+	delete [] mBuffer;
+	}
+
+
+
+inline char SerialWriter::flush() {
+	if( mNumBuffered > 0 && ! mError ) {
+		long numWritten = mStream->write( mBuffer, mNumBuffered );
+
+		if( numWritten != mNumBuffered ) {
+			mError = true;
+			setNewLastErrorConst( "Writing underlying stream failed." );
+			}
+		}
+
+	mNumBuffered = 0;
+
+	return ! mError;
+	}
+
+
+
+inline long SerialWriter::write( unsigned char *inBuffer,
+								 long inNumBytes ) {
+	if( mError ) {
+		return -1;
+		}
+
+	if( mNumBuffered + inNumBytes > mBufferSize ) {
+		flush();
+
+		if( inNumBytes >= mBufferSize ) {
+			// big write, skip buffer
+			if( ! mError &&
+				mStream->write( inBuffer, inNumBytes ) != inNumBytes ) {
+				mError = true;
+				setNewLastErrorConst( "Writing underlying stream failed." );
+				}
+
+			if( mError ) {
+				return -1;
+				}
+			return inNumBytes;
+			}
+		}
+
+	memcpy( &( mBuffer[ mNumBuffered ] ), inBuffer, inNumBytes );
+	mNumBuffered += inNumBytes;
+
+	return inNumBytes;
+	}
+
+
+
+inline long SerialWriter::writeDoubles( const double *inDoubles,
+										int inNumDoubles ) {
+	if( mError ) {
+		return -1;
+		}
+
+	// convert straight into buffer, a buffer-full at a time
+	int maxPerBlock = mBufferSize / 8;
+
+	if( maxPerBlock < 1 ) {
+		// buffer too small to convert into
+		for( int i=0; i<inNumDoubles; i++ ) {
+			if( writeDouble( inDoubles[i] ) != 8 ) {
+				return -1;
+				}
+			}
+		return inNumDoubles * 8;
+		}
+
+	int numDone = 0;
+
+	while( numDone < inNumDoubles ) {
+		int numFree = ( mBufferSize - mNumBuffered ) / 8;
+
+		if( numFree == 0 ) {
+			if( ! flush() ) {
+				return -1;
+				}
+			numFree = maxPerBlock;
+			}
+
+		int numToConvert = inNumDoubles - numDone;
+		if( numToConvert > numFree ) {
+			numToConvert = numFree;
+			}
+
+		TypeIO::doublesToBytes( &( inDoubles[ numDone ] ), numToConvert,
+								&( mBuffer[ mNumBuffered ] ) );
+
+		mNumBuffered += numToConvert * 8;
+		numDone += numToConvert;
+		}
+
+	return inNumDoubles * 8;
+	}
+
+
+
+#endif
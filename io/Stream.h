@@ -13,6 +13,9 @@
  *
  * 2011-March-9    Jason Rohrer
  * Removed Fortify inclusion.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Fixed read past end of string in setNewLastErrorConst.
  */
 
 #include "minorGems/common.h"
@@ -133,8 +136,7 @@ inline void Stream::setNewLastErrorConst( const char *inString ) {
 		length++;
 		}
 	
-	// add one more to length to accommodate '\0' terminination
-	length++;
+	// length includes '\0' termination
 	
 	if( mLastError != NULL ) {
 		delete [] mLastError;
@@ -10,6 +10,9 @@
  *
  * 2004-May-9   Jason Rohrer
  * Added support for shorts.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Added array functions for doubles.
  */
 
 #include "minorGems/common.h"
@@ -18,6 +21,11 @@
 #ifndef TYPE_IO_INCLUDED
 #define TYPE_IO_INCLUDED
 
+#include "minorGems/system/endian.h"
+
+#include <stdint.h>
+#include <string.h>
+
 /**
  * Interfaces for platform-independent type input and output.
  *
@@ -97,6 +105,32 @@ class TypeIO {
 		 * @return the double represented by the bytes.
 		 */
 		static double bytesToDouble( unsigned char *inBytes );
+
+
+        /**
+		 * Converts an array of doubles to bytes, in the same format
+         * as doubleToBytes.
+		 *
+		 * @param inDoubles the doubles to convert.
+		 * @param inNumDoubles the number of doubles.
+		 * @param outBytes an array of 8 * inNumDoubles bytes where the
+         *   converted data will be returned.
+		 */
+		static void doublesToBytes( const double *inDoubles,
+                                    int inNumDoubles,
+                                    unsigned char *outBytes );
+
+
+        /**
+		 * Converts bytes from doublesToBytes back to doubles.
+		 *
+		 * @param inBytes an array of 8 * inNumDoubles bytes.
+		 * @param inNumDoubles the number of doubles.
+		 * @param outDoubles an array where the doubles will be returned.
+		 */
+		static void bytesToDoubles( const unsigned char *inBytes,
+                                    int inNumDoubles,
+                                    double *outDoubles );
 		
 	};		
 
@@ -137,5 +171,59 @@ inline short TypeIO::bytesToShort( unsigned char *inBytes ) {
 	}
 
 
+
+// doubles are IEEE 754 on every platform we support, so only byte order
+// differs, and these can be implemented here, unlike doubleToBytes
+// the loops are simple enough for compilers to turn into vector byte
+// swaps
+
+inline uint64_t typeIOToBigEndian64( uint64_t inValue ) {
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+    return 
+        ( inValue >> 56 ) |
+        ( ( inValue >> 40 ) & 0x000000000000FF00ULL ) |
+        ( ( inValue >> 24 ) & 0x0000000000FF0000ULL ) |
+        ( ( inValue >> 8 )  & 0x00000000FF000000ULL ) |
+        ( ( inValue << 8 )  & 0x000000FF00000000ULL ) |
+        ( ( inValue << 24 ) & 0x0000FF0000000000ULL ) |
+        ( ( inValue << 40 ) & 0x00FF000000000000ULL ) |
+        ( inValue << 56 );
+#else
+    return inValue;
+#endif
+    }
+
+
+
+inline void TypeIO::doublesToBytes( const double *inDoubles,
+                                    int inNumDoubles,
+                                    unsigned char *outBytes ) {
+    for( int i=0; i<inNumDoubles; i++ ) {
+        uint64_t bits;
+        memcpy( &bits, &( inDoubles[i] ), 8 );
+        
+        bits = typeIOToBigEndian64( bits );
+        
+        memcpy( &( outBytes[ i * 8 ] ), &bits, 8 );
+        }
+    }
+
+
+
+inline void TypeIO::bytesToDoubles( const unsigned char *inBytes,
+                                    int inNumDoubles,
+                                    double *outDoubles ) {
+    for( int i=0; i<inNumDoubles; i++ ) {
+        uint64_t bits;
+        memcpy( &bits, &( inBytes[ i * 8 ] ), 8 );
+        
+        // same swap both ways
+        bits = typeIOToBigEndian64( bits );
+        
+        memcpy( &( outDoubles[i] ), &bits, 8 );
+        }
+    }
+
+
 	
 #endif
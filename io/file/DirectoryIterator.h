@@ -0,0 +1,267 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+
+
+#include "minorGems/common.h"
+
+
+
+#ifndef DIRECTORY_ITERATOR_INCLUDED
+#define DIRECTORY_ITERATOR_INCLUDED
+
+#include <sys/stat.h>
+#include <string.h>
+
+#include <dirent.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#endif
+
+
+
+/**
+ * Steps through the entries of one directory without allocating anything
+ * per entry, for scanning large directories.
+ *
+ * Entry types come straight from the directory listing where the
+ * platform provides them (d_type), so telling files from subdirectories
+ * usually costs no stat call.  Sizes, and types the listing doesn't give
+ * (symlinks, some filesystems), are looked up with one stat, only when
+ * asked for.
+ *
+ * Example:
+ *
+ *   DirectoryIterator it( "objects" );
+ *   while( it.next() ) {
+ *       if( ! it.isDirectory() ) {
+ *           printf( "%s %ld\n", it.getName(), it.getSize() );
+ *           }
+ *       }
+ *
+ * Order of entries is the order the filesystem returns them in.
+ *
+ * @author Jason Rohrer.
+ */
+class DirectoryIterator {
+
+    public:
+
+
+        /**
+         * Opens a directory.
+         *
+         * @param inDirectoryPath the directory's path.
+         *   Must be destroyed by caller if non-const.
+         */
+        DirectoryIterator( const char *inDirectoryPath );
+
+
+        ~DirectoryIterator();
+
+
+        // false if directory could not be opened
+        char isOpen();
+
+
+
+        /**
+         * Steps to the next entry, skipping "." and "..".
+         *
+         * @return true if there is an entry, or false at end of
+         *   directory.
+         */
+        char next();
+
+
+
+        // name of current entry
+        // valid until next call to next
+        // Must NOT be destroyed by caller.
+        const char *getName();
+
+        int getNameLength();
+
+
+        // true if current entry is a directory (or a link to one)
+        char isDirectory();
+
+
+        // size of current entry in bytes, or 0 if it can't be found
+        long getSize();
+
+
+    protected:
+
+        DIR *mDirectory;
+
+        struct dirent *mEntry;
+        int mNameLength;
+
+        // for stat fallback, where entry can't be stat'ed relative to
+        // directory handle
+        char *mPathBuffer;
+        int mPathBufferSize;
+        int mDirectoryPathLength;
+
+        // stat of current entry, done on demand
+        char mStatDone;
+        char mStatOK;
+        struct stat mStat;
+
+        void statEntry();
+    };
+
+
+
+inline DirectoryIterator::DirectoryIterator( const char *inDirectoryPath )
+        : mDirectory( opendir( inDirectoryPath ) ),
+          mEntry( NULL ), mNameLength( 0 ),
+          mPathBuffer( NULL ), mPathBufferSize( 0 ),
+          mDirectoryPathLength( 0 ),
+          mStatDone( false ), mStatOK( false ) {
+
+    #ifdef _WIN32
+    // path prefix for stat calls, "dir/"
+    mDirectoryPathLength = strlen( inDirectoryPath );
+
+    mPathBufferSize = mDirectoryPathLength + 256;
+    mPathBuffer = new char[ mPathBufferSize ];
+
+    memcpy( mPathBuffer, inDirectoryPath, mDirectoryPathLength );
+    mPathBuffer[ mDirectoryPathLength ] = '/';
+    mDirectoryPathLength ++;
+    #endif
+    }
+
+
+
+inline DirectoryIterator::~DirectoryIterator() {
+    if( mDirectory != NULL ) {
+        closedir( mDirectory );
+        }
+
+    if( mPathBuffer != NULL ) {
+        delete [] mPathBuffer;
+        }
+    }
+
+
+
+inline char DirectoryIterator::isOpen() {
+    return ( mDirectory != NULL );
+    }
+
+
+
+inline char DirectoryIterator::next() {
+    if( mDirectory == NULL ) {
+        return false;
+        }
+
+    mStatDone = false;
+
+    while( true ) {
+        mEntry = readdir( mDirectory );
+
+        if( mEntry == NULL ) {
+            return false;
+            }
+
+        const char *name = mEntry->d_name;
+
+        // skip parentdir and thisdir
+        if( name[0] == '.' &&
+            ( name[1] == '\0' ||
+              ( name[1] == '.' && name[2] == '\0' ) ) ) {
+            continue;
+            }
+
+        mNameLength = strlen( name );
+        return true;
+        }
+    }
+
+
+
+inline const char *DirectoryIterator::getName() {
+    return mEntry->d_name;
+    }
+
+
+
+inline int DirectoryIterator::getNameLength() {
+    return mNameLength;
+    }
+
+
+
+inline void DirectoryIterator::statEntry() {
+    if( mStatDone ) {
+        return;
+        }
+    mStatDone = true;
+
+    #ifdef _WIN32
+        int neededSize = mDirectoryPathLength + mNameLength + 1;
+
+        if( neededSize > mPathBufferSize ) {
+            char *newBuffer = new char[ neededSize ];
+            memcpy( newBuffer, mPathBuffer, mDirectoryPathLength );
+
+            delete [] mPathBuffer;
+            mPathBuffer = newBuffer;
+            mPathBufferSize = neededSize;
+            }
+
+        memcpy( &( mPathBuffer[ mDirectoryPathLength ] ), mEntry->d_name,
+                mNameLength + 1 );
+
+        mStatOK = ( stat( mPathBuffer, &mStat ) == 0 );
+    #else
+        // relative to open directory, so kernel doesn't walk directory
+        // path again for each entry
+        mStatOK = ( fstatat( dirfd( mDirectory ), mEntry->d_name,
+                             &mStat, 0 ) == 0 );
+    #endif
+    }
+
+
+
+inline char DirectoryIterator::isDirectory() {
+    #ifdef DT_DIR
+    if( mEntry->d_type == DT_DIR ) {
+        return true;
+        }
+    if( mEntry->d_type != DT_UNKNOWN && mEntry->d_type != DT_LNK ) {
+        return false;
+        }
+    #endif
+
+    statEntry();
+
+    if( ! mStatOK ) {
+        return false;
+        }
+    return S_ISDIR( mStat.st_mode );
+    }
+
+
+
+inline long DirectoryIterator::getSize() {
+    statEntry();
+
+    if( ! mStatOK ) {
+        return 0;
+        }
+    return mStat.st_size;
+    }
+
+
+
+#endif
@@ -95,6 +95,20 @@
  *
  * 2017-August-8    Jason Rohrer
  * Function for getting alphabetically sorted child files.
+ *
+ * 2026-October-14    Jason Rohrer
+ * Function for mapping file contents into memory instead of copying them.
+ *
+ * 2026-October-15    Jason Rohrer
+ * Child file listing through DirectoryIterator, with child path built once
+ * per directory and entry types from listing instead of a stat per child.
+ * Sorting compares names in place instead of duplicating them.
+ * Recursive listing can walk subdirectories in parallel on a ThreadPool.
+ * Copying done in kernel where possible (copy_file_range, then sendfile),
+ * otherwise in large blocks that stop at short reads.  Contents compared
+ * in large blocks, without reading both files into memory.
+ * Full file name built with one allocation, from path's cached string.
+ * Sorted listing uses sortArray with an inlined name comparison.
  */
 
 
@@ -113,7 +127,19 @@
 
 #include <dirent.h>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#endif
+
+#ifdef __linux__
+#include <unistd.h>
+#include <errno.h>
+#include <sys/syscall.h>
+#include <sys/sendfile.h>
+#endif
+
 #include "Path.h"
+#include "DirectoryIterator.h"
 
 #include "minorGems/util/SimpleVector.h"
 #include "minorGems/util/stringUtils.h"
@@ -121,6 +147,14 @@
 
 
 
+// see MappedFileContents.h, included below
+class MappedFileContents;
+
+// see ThreadPool.h, included below
+class ThreadPool;
+
+
+
 /**
  * File interface.  Provides access to information about a
  * file.
@@ -184,6 +218,20 @@ class File {
 		 *    Must be destroyed by caller if non-NULL.
 		 */
 		File **getChildFiles( int *outNumFiles );
+
+
+        /**
+         * Same as getChildFiles, but also returns whether each child is a
+         * directory, taken from directory listing where possible (much
+         * cheaper than calling isDirectory on each child).
+         *
+         * @param outIsDirectory pointer to where an array of
+         *   outNumFiles flags should be returned, or NULL if
+         *   return value is NULL.
+         *   Array must be destroyed by caller if non-NULL.
+         */
+        File **getChildFiles( int *outNumFiles, char **outIsDirectory );
+
         
         // sorted in alphabetical order
         File **getChildFilesSorted( int *outNumFiles );
@@ -206,6 +254,20 @@ class File {
 		 *    Must be destroyed by caller if non-NULL.
 		 */
 		File **getChildFilesRecursive( int inDepthLimit, int *outNumFiles );
+
+
+        /**
+         * Same as getChildFilesRecursive, but walks each subdirectory of
+         * this directory as a separate task on a thread pool.
+         *
+         * Results are in the same order as getChildFilesRecursive.
+         *
+         * @param inPool the pool to run on, or NULL to use the shared
+         *   pool.
+         *   Must be destroyed by caller if non-NULL.
+         */
+        File **getChildFilesRecursive( int inDepthLimit, int *outNumFiles,
+                                       ThreadPool *inPool );
         
         
 
@@ -289,13 +351,16 @@ class File {
 		 *   If it exists, it will be overwritten.
 		 *   If it does not exist, it will be created.
 		 *   Must be destroyed by caller.
-		 * @param inBlockSize the block size to use when copying.
-		 *   Defaults to blocks of 5000 bytes.
+		 * @param inBlockSize the block size to use when copying, if
+		 *   data can't be copied by the kernel directly between files
+		 *   (copy_file_range or sendfile on Linux).
+		 *   Defaults to blocks of 256 KiB.
 		 */
-		void copy( File *inDestination, long inBlockSize = 5000 );
+		void copy( File *inDestination, long inBlockSize = 262144 );
         
 
         // returns true if file contents match, false otherwise
+        // compares in large blocks, stopping at first difference
         char contentsMatches( File *inOtherFile );
         
 		
@@ -363,6 +428,20 @@ class File {
                                          char inTextMode = false );
 
 
+        
+        /**
+         * Maps the contents of this file into memory, read-only.
+         *
+         * Avoids the heap copy made by readFileContents, which makes it
+         * cheaper for large files that are parsed once and thrown away.
+         * Contents are binary (no line end conversion).
+         *
+         * @return the mapped contents, or NULL if file cannot be mapped.
+         *   Must be destroyed by caller, which unmaps the file.
+         */
+        MappedFileContents *mapContents();
+
+
 
         /**
          * Writes a string to this file.
@@ -418,6 +497,39 @@ class File {
                                      SimpleVector<File *> *inResultVector );
 
 
+        // path to this directory's children, as needed by their File
+        // objects
+        // Must be destroyed by caller.
+        Path *getChildPath();
+
+
+        // sortArray comparator of File* by name
+        struct NameLess {
+                bool operator()( File *inA, File *inB ) const {
+                    return strcmp( inA->mName, inB->mName ) < 0;
+                    }
+            };
+
+
+        // ThreadPoolRangeFunction over children in a parallel recursive
+        // listing
+        static void getSubtreesRange( void *inContext,
+                                      int inStart, int inEnd );
+
+
+        // tells OS that file will be read front to back, so it can read
+        // ahead further than usual
+        static void adviseSequentialRead( FILE *inFile );
+
+
+        // copies rest of inFrom into inTo, from their current positions,
+        // without passing data through user space
+        // returns true if copied to end of inFrom, or false if kernel
+        // can't copy between these files (caller should copy rest itself,
+        // from positions left behind)
+        // always false except on Linux
+        static char kernelCopyRest( int inFrom, int inTo );
+
         
 	};		
 
@@ -491,131 +603,96 @@ inline char File::isDirectory() {
 
 
 
-inline File **File::getChildFiles( int *outNumFiles ) {
+inline Path *File::getChildPath() {
+    if( mPath != NULL ) {
+        return mPath->append( mName );
+        }
 
-	int length;
-	char *stringName = getFullFileName( &length );
-	
-	DIR *directory = opendir( stringName );
-	
-	if( directory != NULL ) {
+    if( Path::isRoot( mName ) ) {
+        // use name as a string path
+        return new Path( mName );
+        }
 
-		SimpleVector< File* > *fileVector = new SimpleVector< File* >();
-		
-		struct dirent *entry = readdir( directory );
+    char **folderPathArray = new char*[1];
+    folderPathArray[0] = mName;
 
-		if( entry == NULL ) {
-			delete fileVector;
+    // a non-absolute path to this directory's contents
+    int numSteps = 1;
+    char absolute = false;
+    Path *newPath = new Path( folderPathArray, numSteps, absolute );
 
-			closedir( directory );
-			
-			delete [] stringName;
+    delete [] folderPathArray;
 
-			*outNumFiles = 0;
-			return NULL;
-			}
+    return newPath;
+    }
 
-		
-		while( entry != NULL ) {
-			// skip parentdir and thisdir files, if they occur
-			if( strcmp( entry->d_name, "." ) &&
-				strcmp( entry->d_name, ".." ) ) {
-				
-				Path *newPath;
 
-				if( mPath != NULL ) {
-					newPath = mPath->append( mName );
-					}
-				else {
 
-                    if( Path::isRoot( mName ) ) {
-                        // use name as a string path
-                        newPath = new Path( mName );
-                        }
-                    else {
-                        char **folderPathArray = new char*[1];
-                        folderPathArray[0] = mName;
-				
-                        // a non-absolute path to this directory's contents
-                        int numSteps = 1;
-                        char absolute = false;
-                        newPath =
-                            new Path( folderPathArray, numSteps,
-                                      absolute );
-                        
-                        delete [] folderPathArray;
-                        }
-                    }
+inline File **File::getChildFiles( int *outNumFiles ) {
+    return getChildFiles( outNumFiles, NULL );
+    }
 
-				// safe to pass d_name in directly because it is copied
-				// internally by the constructor
-							
-				fileVector->push_back(
-					new File( newPath,
-							  entry->d_name,
-							  strlen( entry->d_name ) ) );
-				}
-			
-			entry = readdir( directory );
-			}
-
-		// now we have a vector full of this directory's files
-		int vectorSize = fileVector->size();
-
-		*outNumFiles = vectorSize;
-		
-		if( vectorSize == 0 ) {
-			delete fileVector;
-		
-			closedir( directory );
 
-			delete [] stringName;
-		
-			return NULL;
-			}
-		else {
-			File **returnFiles = new File *[vectorSize];
-			for( int i=0; i<vectorSize; i++ ) {
-				returnFiles[i] = *( fileVector->getElement( i ) );
-				}
-		
-			delete fileVector;
-		
-			closedir( directory );
 
-			delete [] stringName;
-		
-			return returnFiles;
-			}
-		}
-	else {
-		delete [] stringName;
+inline File **File::getChildFiles( int *outNumFiles,
+                                   char **outIsDirectory ) {
 
-		*outNumFiles = 0;
-		return NULL;
-		}
-	
+    if( outIsDirectory != NULL ) {
+        *outIsDirectory = NULL;
+        }
+    *outNumFiles = 0;
 
-	
-	}
+    char *stringName = getFullFileName();
+    
+    DirectoryIterator directory( stringName );
 
+    delete [] stringName;
 
+    if( ! directory.isOpen() ) {
+        return NULL;
+        }
 
+    SimpleVector< File* > fileVector;
+    SimpleVector< char > isDirectoryVector;
 
-static int fileNameCompare(const void *inA, const void * inB ) {
-    
-    File *a = *( (File**)inA );
-    File *b = *( (File**)inB );
+    // built once, and copied for each child
+    Path *childPath = NULL;
 
-    char *nameA = a->getFileName();
-    char *nameB = b->getFileName();
-    
-    int result = strcmp( nameA, nameB );
+    while( directory.next() ) {
+        if( childPath == NULL ) {
+            childPath = getChildPath();
+            }
 
-    delete [] nameA;
-    delete [] nameB;
-    
-    return result;
+        // safe to pass name in directly because it is copied
+        // internally by the constructor
+        fileVector.push_back(
+            new File( childPath->copy(),
+                      directory.getName(),
+                      directory.getNameLength() ) );
+
+        if( outIsDirectory != NULL ) {
+            isDirectoryVector.push_back( directory.isDirectory() );
+            }
+        }
+
+    if( childPath != NULL ) {
+        delete childPath;
+        }
+
+    // now we have a vector full of this directory's files
+    int vectorSize = fileVector.size();
+
+    if( vectorSize == 0 ) {
+        return NULL;
+        }
+
+    *outNumFiles = vectorSize;
+
+    if( outIsDirectory != NULL ) {
+        *outIsDirectory = isDirectoryVector.getElementArray();
+        }
+
+    return fileVector.getElementArray();
     }
 
 
@@ -624,8 +701,9 @@ static int fileNameCompare(const void *inA, const void * inB ) {
 inline File **File::getChildFilesSorted( int *outNumFiles ) {
     File **result = getChildFiles( outNumFiles );
     
-
-    qsort( result, *outNumFiles, sizeof(File*), fileNameCompare );
+    if( result != NULL ) {
+        sortArray( result, *outNumFiles, NameLess() );
+        }
 
     return result;
     }
@@ -669,7 +747,8 @@ inline void File::getChildFilesRecursive(
 
     // get our child files
     int numChildren;
-    File **childFiles = getChildFiles( &numChildren );
+    char *childIsDirectory;
+    File **childFiles = getChildFiles( &numChildren, &childIsDirectory );
 
     if( childFiles != NULL ) {
 
@@ -683,7 +762,7 @@ inline void File::getChildFilesRecursive(
             // add it to results vector
             inResultVector->push_back( child );
             
-            if( child->isDirectory() ) {
+            if( childIsDirectory[i] ) {
                 // skip recursion if we have hit our depth limit
                 if( inDepthLimit > 0 ) {
                     // recurse into this subdirectory
@@ -694,6 +773,7 @@ inline void File::getChildFilesRecursive(
             }
 
         delete [] childFiles;
+        delete [] childIsDirectory;
         }
     }
 
@@ -860,38 +940,113 @@ inline File *File::copy() {
 
 
 
-inline void File::copy( File *inDestination, long inBlockSize ) {
-	char *thisFileName = getFullFileName();
-	char *destinationFileName = inDestination->getFullFileName();
+inline void File::adviseSequentialRead( FILE *inFile ) {
+    #ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise( fileno( inFile ), 0, 0, POSIX_FADV_SEQUENTIAL );
+    #endif
+    }
 
-	FILE *thisFile = fopen( thisFileName, "rb" );
-	FILE *destinationFile = fopen( destinationFileName, "wb" );
 
-	long length = getLength();
 
-	long bytesCopied = 0;
+inline char File::kernelCopyRest( int inFrom, int inTo ) {
+    #ifdef __linux__
+    
+    // larger chunks are clamped by kernel anyway
+    size_t chunk = 1 << 30;
+
+    #ifdef SYS_copy_file_range
+    while( true ) {
+        long result = syscall( SYS_copy_file_range, inFrom, NULL,
+                               inTo, NULL, chunk, 0 );
+        if( result == 0 ) {
+            return true;
+            }
+        if( result < 0 ) {
+            if( errno == EINTR ) {
+                continue;
+                }
+            // ENOSYS on old kernels, EXDEV across filesystems on some,
+            // EINVAL for special files
+            break;
+            }
+        }
+    #endif
 
-	char *buffer = new char[ inBlockSize ];
-	
-	while( bytesCopied < length ) {
+    while( true ) {
+        ssize_t result = sendfile( inTo, inFrom, NULL, chunk );
+        
+        if( result == 0 ) {
+            return true;
+            }
+        if( result < 0 ) {
+            if( errno == EINTR ) {
+                continue;
+                }
+            return false;
+            }
+        }
+    
+    #else
+    return false;
+    #endif
+    }
 
-		long bytesToCopy = inBlockSize;
 
-		// end of file case
-		if( length - bytesCopied < bytesToCopy ) {
-			bytesToCopy = length - bytesCopied;
-			}
 
-		fread( buffer, 1, bytesToCopy, thisFile );
-		fwrite( buffer, 1, bytesToCopy, destinationFile );
-		
-		bytesCopied += bytesToCopy;
-		}
+inline void File::copy( File *inDestination, long inBlockSize ) {
+	char *thisFileName = getFullFileName();
+	char *destinationFileName = inDestination->getFullFileName();
 
-	fclose( thisFile );
-	fclose( destinationFile );
+	FILE *thisFile = fopen( thisFileName, "rb" );
+	FILE *destinationFile = NULL;
+
+    if( thisFile != NULL ) {
+        destinationFile = fopen( destinationFileName, "wb" );
+        }
+    
+    if( thisFile != NULL && destinationFile != NULL ) {
+        
+        // nothing read or written through stdio yet, so descriptor
+        // positions are the stream positions
+        char done = kernelCopyRest( fileno( thisFile ), 
+                                    fileno( destinationFile ) );
+        
+        if( ! done ) {
+            adviseSequentialRead( thisFile );
+            
+            if( inBlockSize < 1 ) {
+                inBlockSize = 262144;
+                }
+            
+            char *buffer = new char[ inBlockSize ];
+	
+            while( true ) {
+                size_t numRead = fread( buffer, 1, inBlockSize, thisFile );
+                
+                if( numRead > 0 ) {
+                    if( fwrite( buffer, 1, numRead, destinationFile ) 
+                        != numRead ) {
+                        break;
+                        }
+                    }
+                
+                if( numRead < (size_t)inBlockSize ) {
+                    // end of file or read error
+                    break;
+                    }
+                }
+            
+            delete [] buffer;
+            }
+        }
+    
+    if( thisFile != NULL ) {
+        fclose( thisFile );
+        }
+    if( destinationFile != NULL ) {
+        fclose( destinationFile );
+        }
 
-	delete [] buffer;
 	delete [] thisFileName;
 	delete [] destinationFileName;	
 	}
@@ -911,34 +1066,61 @@ inline char File::contentsMatches( File *inOtherFile ) {
         return false;
         }
     
-    int lenA;
-    unsigned char *contA = readFileContents( &lenA );
-
-    int lenB;
-    unsigned char *contB = inOtherFile->readFileContents( &lenB );
+    char *nameA = getFullFileName();
+    char *nameB = inOtherFile->getFullFileName();
+    
+    FILE *fileA = fopen( nameA, "rb" );
+    FILE *fileB = fopen( nameB, "rb" );
 
+    delete [] nameA;
+    delete [] nameB;
     
+
     char match = false;
     
-    if( contA != NULL && contB != NULL && lenA == lenB ) {
+    if( fileA != NULL && fileB != NULL ) {
+        adviseSequentialRead( fileA );
+        adviseSequentialRead( fileB );
+        
+        // read straight into our blocks, not through stdio buffers
+        setvbuf( fileA, NULL, _IONBF, 0 );
+        setvbuf( fileB, NULL, _IONBF, 0 );
+
+        int blockSize = 262144;
+        
+        unsigned char *blockA = new unsigned char[ blockSize ];
+        unsigned char *blockB = new unsigned char[ blockSize ];
         
         match = true;
         
-        for( int i=0; i<lenA; i++ ) {
-            if( contA[i] != contB[i] ) {
+        while( match ) {
+            size_t numA = fread( blockA, 1, blockSize, fileA );
+            size_t numB = fread( blockB, 1, blockSize, fileB );
+            
+            if( numA != numB || 
+                memcmp( blockA, blockB, numA ) != 0 ) {
                 match = false;
+                }
+            else if( numA < (size_t)blockSize ) {
+                // end of both
+                
+                if( ferror( fileA ) || ferror( fileB ) ) {
+                    match = false;
+                    }
                 break;
                 }
             }
+
+        delete [] blockA;
+        delete [] blockB;
         }
 
-    if( contA != NULL ) {
-        delete [] contA;
+    if( fileA != NULL ) {
+        fclose( fileA );
         }
-    if( contB != NULL ) {
-        delete [] contB;
+    if( fileB != NULL ) {
+        fclose( fileB );
         }
-    
 
     return match;
     }
@@ -961,27 +1143,21 @@ inline char *File::getFileName( int *outLength ) {
 inline char *File::getFullFileName( int *outLength ) {
 	int length = mNameLength;
 
-    int pathLength = 0;
-	char *path = NULL;
 	if( mPath != NULL ) {
-		path = mPath->getPathString( &pathLength );
-	
-		length += pathLength;
+		length += mPath->getPathStringLength();
 		}
 		
 	// extra character for '\0' termination	
 	char *returnString = new char[ length + 1 ];
 	
-	if( path != NULL ) {
-		memcpy( returnString, path, pathLength );
-		memcpy( &( returnString[pathLength] ), mName, mNameLength );
-		
-		delete [] path;
-		}
-	else {
-		// no path, so copy the name directly in
-		memcpy( returnString, mName, mNameLength );
+    char *nameStart = returnString;
+    
+	if( mPath != NULL ) {
+        // path written straight in, no intermediate string
+		nameStart = mPath->appendTo( returnString );
 		}
+
+    memcpy( nameStart, mName, mNameLength );
 	
 	// terminate the string
 	returnString[ length ] = '\0';
@@ -1121,6 +1297,8 @@ inline char File::writeToFile( unsigned char *inData, int inLength ) {
 
 
 #include "Directory.h"
+#include "MappedFileContents.h"
+#include "minorGems/system/ThreadPool.h"
 
 
 
@@ -1135,4 +1313,92 @@ inline char File::makeDirectory() {
 
 
 
+inline MappedFileContents *File::mapContents() {
+    char *fileName = getFullFileName();
+
+    MappedFileContents *contents = new MappedFileContents( fileName );
+
+    delete [] fileName;
+
+    if( ! contents->isMapped() ) {
+        delete contents;
+        return NULL;
+        }
+
+    return contents;
+    }
+
+
+
+// shared by getSubtreesRange calls in one parallel recursive listing
+typedef struct FileSubtreesJob {
+        File **children;
+        char *childIsDirectory;
+        int depthLimit;
+
+        // one result vector per child
+        SimpleVector<File *> *subtrees;
+    } FileSubtreesJob;
+
+
+
+inline void File::getSubtreesRange( void *inContext,
+                                    int inStart, int inEnd ) {
+    FileSubtreesJob *job = (FileSubtreesJob *)inContext;
+
+    for( int i=inStart; i<inEnd; i++ ) {
+        if( job->childIsDirectory[i] ) {
+            job->children[i]->getChildFilesRecursive(
+                job->depthLimit, &( job->subtrees[i] ) );
+            }
+        }
+    }
+
+
+
+inline File **File::getChildFilesRecursive( int inDepthLimit,
+                                            int *outNumFiles,
+                                            ThreadPool *inPool ) {
+    int numChildren;
+    char *childIsDirectory;
+    File **childFiles = getChildFiles( &numChildren, &childIsDirectory );
+
+    if( childFiles == NULL ) {
+        *outNumFiles = 0;
+        return NULL;
+        }
+
+    SimpleVector<File *> *subtrees = new SimpleVector<File *>[ numChildren ];
+
+    if( inDepthLimit > 0 ) {
+        if( inPool == NULL ) {
+            inPool = ThreadPool::getSharedPool();
+            }
+
+        FileSubtreesJob job = { childFiles, childIsDirectory,
+                                inDepthLimit - 1, subtrees };
+
+        inPool->parallelFor( getSubtreesRange, &job, numChildren );
+        }
+
+
+    // each child followed by its subtree, same as sequential order
+    SimpleVector<File *> resultVector;
+
+    for( int i=0; i<numChildren; i++ ) {
+        resultVector.push_back( childFiles[i] );
+
+        resultVector.push_back_other( &( subtrees[i] ) );
+        }
+
+    delete [] subtrees;
+    delete [] childFiles;
+    delete [] childIsDirectory;
+
+    *outNumFiles = resultVector.size();
+    return resultVector.getElementArray();
+    }
+
+
+
 #endif
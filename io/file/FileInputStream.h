@@ -20,6 +20,11 @@
  *
  * 2011-April-15   Jason Rohrer
  * Fixed compile order issue.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Added readAvailable.
+ * Optional large read buffer, with sequential readahead hint to OS.
+ * Opens and reads counted in StartupTimeline.
  */
 
 #include "minorGems/common.h"
@@ -32,8 +37,16 @@
 
 #include "minorGems/io/InputStream.h"
 
+#ifdef STARTUP_TIMELINE
+#include "minorGems/system/StartupTimeline.h"
+#endif
+
 #include <stdio.h>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#endif
+
 /**
  * File implementation of an InputStream.
  *
@@ -51,8 +64,15 @@ class FileInputStream : public InputStream {
 		 *   inFile is NOT destroyed when this class is destroyed.
          * @param inTextMode true to open the file as text, false as binary.
          *   Defaults to false.
+         * @param inBufferSize size of read buffer, for streaming through
+         *   large files, or 0 to use the C library's default buffer.
+         *   If non-zero, buffer is page-aligned, and OS is told that file
+         *   will be read sequentially (so it can read further ahead).
+         *   Reads larger than buffer go straight to file.
+         *   Defaults to 0.
 		 */
-		FileInputStream( File *inFile, char inTextMode = false );
+		FileInputStream( File *inFile, char inTextMode = false,
+                         int inBufferSize = 0 );
 		
 		
 		/**
@@ -73,31 +93,78 @@ class FileInputStream : public InputStream {
 		
 		// implementst InputStream interface
 		virtual long read( unsigned char *inBuffer, long inNumBytes );
+
+        // file reads never wait, so this is the same as read
+        virtual long readAvailable( unsigned char *inBuffer,
+                                    long inMaxBytes ) {
+            return read( inBuffer, inMaxBytes );
+            }
 		
 	private:
 		File *mFile;
 		
 		FILE *mUnderlyingFile;
+
+        // start of allocation holding aligned buffer, or NULL
+        unsigned char *mBufferAllocation;
 	};		
 
 
 
 
-inline FileInputStream::FileInputStream( File *inFile, char inTextMode ) 
-	: mFile( inFile ) {
+inline FileInputStream::FileInputStream( File *inFile, char inTextMode,
+                                         int inBufferSize ) 
+	: mFile( inFile ), mBufferAllocation( NULL ) {
 	
 	int fileNameLength;
 	
 	char *fileName = mFile->getFullFileName( &fileNameLength );
 	
+    const char *mode = "rb";
+    
     if( inTextMode ) {
-        mUnderlyingFile = fopen( fileName, "r" );
+        mode = "r";
         }
-    else {
-        mUnderlyingFile = fopen( fileName, "rb" );
+
+    #ifdef _WIN32
+    if( inBufferSize > 0 ) {
+        // FILE_FLAG_SEQUENTIAL_SCAN
+        if( inTextMode ) {
+            mode = "rS";
+            }
+        else {
+            mode = "rbS";
+            }
         }
+    #endif
+
+    mUnderlyingFile = fopen( fileName, mode );
     
+
+    if( mUnderlyingFile != NULL && inBufferSize > 0 ) {
+        int alignment = 4096;
+        
+        mBufferAllocation = new unsigned char[ inBufferSize + alignment ];
+        
+        unsigned char *buffer = 
+            &( mBufferAllocation[ alignment - 
+                                  ( (size_t)mBufferAllocation % 
+                                    alignment ) ] );
+        
+        setvbuf( mUnderlyingFile, (char *)buffer, _IOFBF, inBufferSize );
+        
+        #ifdef POSIX_FADV_SEQUENTIAL
+        posix_fadvise( fileno( mUnderlyingFile ), 0, 0,
+                       POSIX_FADV_SEQUENTIAL );
+        #endif
+        }
 	
+    #ifdef STARTUP_TIMELINE
+    if( mUnderlyingFile != NULL ) {
+        StartupTimeline::noteFileOpened();
+        }
+    #endif
+
 	if( mUnderlyingFile == NULL ) {
 		// file open failed.
 		
@@ -115,6 +182,11 @@ inline FileInputStream::~FileInputStream() {
 	if( mUnderlyingFile != NULL ) {
 		fclose( mUnderlyingFile );
 		}
+
+    // after close, which can still use buffer
+    if( mBufferAllocation != NULL ) {
+        delete [] mBufferAllocation;
+        }
 	}
 
 
@@ -132,6 +204,10 @@ inline long FileInputStream::read(
 	
 		long numRead = fread( inBuffer, 1, inNumBytes, mUnderlyingFile );
 
+        #ifdef STARTUP_TIMELINE
+        StartupTimeline::noteBytesRead( numRead );
+        #endif
+
 		if( numRead < inNumBytes ) {
 
 			int fileNameLength;
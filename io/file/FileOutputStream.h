@@ -17,6 +17,9 @@
  *
  * 2010-April-6   Jason Rohrer
  * Fixed memory leak.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Optional large, aligned write buffer.
  */
 
 #include "minorGems/common.h"
@@ -50,8 +53,12 @@ class FileOutputStream : public OutputStream {
 		 * @param inAppend set to true to append to file.  If
 		 *   file does not exist, file is still created.  Defaults
 		 *   to false.
+		 * @param inBufferSize size of page-aligned write buffer, for
+		 *   writing large files in big blocks, or 0 to use the C
+		 *   library's default buffer.  Defaults to 0.
 		 */
-		FileOutputStream( File *inFile, char inAppend = false );
+		FileOutputStream( File *inFile, char inAppend = false,
+                          int inBufferSize = 0 );
 		
 		
 		/**
@@ -77,14 +84,17 @@ class FileOutputStream : public OutputStream {
 		File *mFile;
 		
 		FILE *mUnderlyingFile;
+
+        // start of allocation holding aligned buffer, or NULL
+        unsigned char *mBufferAllocation;
 	};		
 
 
 
 
 inline FileOutputStream::FileOutputStream( File *inFile, 
-	char inAppend ) 
-	: mFile( inFile ) {
+	char inAppend, int inBufferSize ) 
+	: mFile( inFile ), mBufferAllocation( NULL ) {
 	
 	int fileNameLength;
 	
@@ -96,6 +106,19 @@ inline FileOutputStream::FileOutputStream( File *inFile,
 	else {
 		mUnderlyingFile = fopen( fileName, "wb" );
 		}
+
+    if( mUnderlyingFile != NULL && inBufferSize > 0 ) {
+        int alignment = 4096;
+        
+        mBufferAllocation = new unsigned char[ inBufferSize + alignment ];
+        
+        unsigned char *buffer = 
+            &( mBufferAllocation[ alignment - 
+                                  ( (size_t)mBufferAllocation % 
+                                    alignment ) ] );
+        
+        setvbuf( mUnderlyingFile, (char *)buffer, _IOFBF, inBufferSize );
+        }
 		
 	if( mUnderlyingFile == NULL ) {
 		// file open failed.
@@ -114,6 +137,11 @@ inline FileOutputStream::~FileOutputStream() {
 	if( mUnderlyingFile != NULL ) {
 		fclose( mUnderlyingFile );
 		}	
+
+    // after close, which flushes buffer
+    if( mBufferAllocation != NULL ) {
+        delete [] mBufferAllocation;
+        }
 	}
 
 
@@ -0,0 +1,93 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14   Jason Rohrer
+ * Created.
+ */
+
+
+
+#include "minorGems/common.h"
+
+
+
+#ifndef MAPPED_FILE_CONTENTS_INCLUDED
+#define MAPPED_FILE_CONTENTS_INCLUDED
+
+
+
+/**
+ * A read-only view of a whole file, mapped into memory instead of
+ * copied into a heap buffer.
+ *
+ * Pages are pulled in by the OS as they are touched, so large files that
+ * are only scanned (or only partly read) cost no up-front copy.
+ *
+ * The file is unmapped when this object is destroyed, so pointers
+ * returned by getData must not be used after that.
+ *
+ * Usually obtained through File::mapContents.
+ *
+ * Implementation is platform-dependent.
+ *
+ * @author Jason Rohrer.
+ */
+class MappedFileContents {
+
+    public:
+
+
+        /**
+         * Maps a file.
+         *
+         * @param inFullFileName the file's full path.
+         *   Must be destroyed by caller if non-const.
+         */
+        MappedFileContents( const char *inFullFileName );
+
+
+        // unmaps file
+        ~MappedFileContents();
+
+
+        // true if file was mapped successfully
+        // (an empty file maps successfully, with a length of 0)
+        char isMapped() {
+            return mMapped;
+            }
+
+
+        /**
+         * Gets the file contents.
+         *
+         * @return the mapped bytes, or NULL if mapping failed.
+         *   Read-only, and valid only as long as this object exists.
+         *   Must NOT be destroyed by caller.
+         */
+        const unsigned char *getData() {
+            return mData;
+            }
+
+
+        // number of bytes returned by getData
+        int getLength() {
+            return mLength;
+            }
+
+
+    protected:
+
+        char mMapped;
+
+        const unsigned char *mData;
+        int mLength;
+
+        // platform-dependent handle for the mapping (file mapping object
+        // on Win32, unused elsewhere)
+        void *mMappingHandle;
+
+    };
+
+
+
+#endif
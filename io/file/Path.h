@@ -52,6 +52,11 @@
  *
  * 2011-March-9    Jason Rohrer
  * Removed Fortify inclusion.
+ *
+ * 2026-October-15    Jason Rohrer
+ * Path string rendered once and kept, in a reference-counted block shared
+ * by copies and truncations, with steps as offsets into it.
+ * Added getPathStringLength and non-allocating appendTo.
  */
 
 #include "minorGems/common.h"
@@ -67,6 +72,7 @@
 
 
 #include "minorGems/util/stringUtils.h"
+#include "minorGems/system/atomicOps.h"
 
 
 
@@ -85,6 +91,11 @@
  * full path:
  *   temp/files/test.txt
  *
+ * The path string is built once, at construction, and shared (read-only)
+ * between a path and its copies and truncations, so copying a path, or
+ * getting its string, doesn't rebuild it step by step.  Paths that share
+ * a string can be used and destroyed by different threads.
+ *
  * @author Jason Rohrer
  */ 
 class Path {
@@ -150,6 +161,26 @@ class Path {
 		 *   be destroyed by the caller.
 		 */
 		char *getPathStringTerminated();
+
+
+
+        // length of path string returned by getPathString
+        int getPathStringLength();
+
+
+
+        /**
+         * Writes the platform-dependent path string into a buffer,
+         * without allocating anything.
+         *
+         * @param inBuffer the buffer to write into, with room for at least
+         *   getPathStringLength() characters.
+         *   Must be destroyed by caller.
+         *
+         * @return pointer just past the written path in inBuffer, where a
+         *   file name could be written next.  Not \0-terminated.
+         */
+        char *appendTo( char *inBuffer );
 		
 		
 		/**
@@ -279,44 +310,179 @@ class Path {
 
         
 	private:
-		char **mPathSteps;
+
+        // rendered path, shared by paths built from it
+        // read-only once built
+        struct PathData {
+                volatile int refCount;
+
+                // root (if absolute), then each step followed by a
+                // delimeter
+                char *string;
+
+                // offset in string just past each step (at its delimeter)
+                int *stepEnds;
+            };
+        
+        PathData *mData;
+
+        // may be fewer than in mData, for a truncated path
 		int mNumSteps;
-		int *mStepLength;
+        
+        // length of this path's prefix of mData's string
+        int mLength;
+        int mRootLength;
 		char mAbsolute;
 
-        // the root string of this path, if it is absolute
-        char *mRootString;
+
+        // shares inData, or leaves data to be allocated if inData NULL
+        Path( PathData *inData, int inNumSteps, char inAbsolute,
+              int inRootLength );
+
+        
+        // makes a new data block for this path (starting with ref count 1)
+        // with room for inLength characters and inNumSteps steps, and
+        // sets mLength and mNumSteps
+        void allocateData( int inLength, int inNumSteps );
+        
+
+        // builds data from root and steps
+        // inRoot ignored if not absolute
+        // inRoot NULL for default root
+        void buildData( const char *inRoot,
+                        char **inPathSteps, int *inStepLengths );
+
+        
+        void releaseData();
+        
+
+        int getStepStart( int inStep );
 	};		
 
 
 
-inline Path::Path( char **inPathSteps, int inNumSteps,
-				   char inAbsolute, char *inRootString ) 
-	: mNumSteps( inNumSteps ), mAbsolute( inAbsolute ),
-      mRootString( NULL ) {
+inline void Path::allocateData( int inLength, int inNumSteps ) {
+    mData = new PathData;
+    mData->refCount = 1;
+    mData->string = new char[ inLength ];
+    mData->stepEnds = new int[ inNumSteps ];
+    
+    mLength = inLength;
+    mNumSteps = inNumSteps;
+    }
+
 
-    if( inRootString != NULL ) {
-        mRootString = stringDuplicate( inRootString );
+
+inline void Path::buildData( const char *inRoot,
+                             char **inPathSteps, int *inStepLengths ) {
+    char *defaultRoot = NULL;
+    
+    mRootLength = 0;
+    if( mAbsolute ) {
+        if( inRoot != NULL ) {
+            mRootLength = strlen( inRoot );
+            }
+        else {
+            defaultRoot = getAbsoluteRoot( &mRootLength );
+            inRoot = defaultRoot;
+            }
         }
+
+    // step string plus delimeter after each
+    int length = mRootLength;
+    for( int i=0; i<mNumSteps; i++ ) {
+        length += inStepLengths[i] + 1;
+        }
+
+    allocateData( length, mNumSteps );
+
+    char *string = mData->string;
     
-	// copy the path steps
-	
-	mPathSteps = new char*[ mNumSteps ];
-	mStepLength = new int[ mNumSteps ];
+    if( mRootLength > 0 ) {
+        memcpy( string, inRoot, mRootLength );
+        }
+    int index = mRootLength;
+
+    char delimeter = getDelimeter();
+    
+    for( int i=0; i<mNumSteps; i++ ) {
+        memcpy( &( string[index] ), inPathSteps[i], inStepLengths[i] );
+        index += inStepLengths[i];
+
+        mData->stepEnds[i] = index;
+        
+        string[index] = delimeter;
+        index++;
+        }
+
+    if( defaultRoot != NULL ) {
+        delete [] defaultRoot;
+        }
+    }
+
+
+
+inline void Path::releaseData() {
+    if( atomicFetchAdd( &( mData->refCount ), -1 ) == 1 ) {
+        delete [] mData->string;
+        delete [] mData->stepEnds;
+        delete mData;
+        }
+    mData = NULL;
+    }
+
+
+
+inline int Path::getStepStart( int inStep ) {
+    if( inStep == 0 ) {
+        return mRootLength;
+        }
+    // skip delimeter after previous step
+    return mData->stepEnds[ inStep - 1 ] + 1;
+    }
+
+
+
+inline Path::Path( char **inPathSteps, int inNumSteps,
+				   char inAbsolute, char *inRootString ) 
+	: mNumSteps( inNumSteps ), mAbsolute( inAbsolute ) {
+    
+	int *stepLengths = new int[ mNumSteps ];
 	
 	for( int i=0; i<mNumSteps; i++ ) {
-		int stepLength = strlen( inPathSteps[i] );
-		
-		mPathSteps[i] = new char[ stepLength + 1 ];
-		memcpy( mPathSteps[i], inPathSteps[i], stepLength + 1 );
-
-		mStepLength[i] = stepLength;
+		stepLengths[i] = strlen( inPathSteps[i] );
 		}
-	
+
+    buildData( inRootString, inPathSteps, stepLengths );
+
+    delete [] stepLengths;
 	}
 
 
 
+inline Path::Path( PathData *inData, int inNumSteps, char inAbsolute,
+                   int inRootLength )
+        : mData( inData ), mNumSteps( inNumSteps ),
+          mRootLength( inRootLength ), mAbsolute( inAbsolute ) {
+
+    if( mData == NULL ) {
+        // caller will allocate
+        mLength = 0;
+        }
+    else if( mNumSteps > 0 ) {
+        mLength = mData->stepEnds[ mNumSteps - 1 ] + 1;
+        }
+    else {
+        mLength = mRootLength;
+        }
+
+    if( mData != NULL ) {
+        atomicFetchAdd( &( mData->refCount ), 1 );
+        }
+    }
+
+
+
 inline Path::Path( const char *inPathString ) {
     mAbsolute = isAbsolute( inPathString );
 
@@ -325,171 +491,102 @@ inline Path::Path( const char *inPathString ) {
     
     char delimeter = getDelimeter();
 
-    char *delimString = new char[ 2 ];
-    delimString[0] = delimeter;
-    delimString[1] = '\0';
-        
-
+    char *rootString = NULL;
     char *pathRootSkipped;
     
     if( !mAbsolute ) {
-        mRootString = NULL;
         pathRootSkipped = pathStringCopy;
         }
     else {
         // root occurs at start of path string
 
-        mRootString = extractRoot( inPathString );
-        pathRootSkipped = &( pathStringCopy[ strlen( mRootString ) ] );
+        rootString = extractRoot( inPathString );
+        pathRootSkipped = &( pathStringCopy[ strlen( rootString ) ] );
         }
 
     
     // remove any trailing delimeters, if they exist
-    while( pathRootSkipped[ strlen( pathRootSkipped ) - 1 ] == delimeter ) {
-        pathRootSkipped[ strlen( pathRootSkipped ) - 1 ] = '\0';
-        }
+    int remainingLength = strlen( pathRootSkipped );
     
-    char *currentDelimPointer = strstr( pathRootSkipped, delimString );
-
-    if( currentDelimPointer != NULL ) {
+    while( remainingLength > 0 &&
+           pathRootSkipped[ remainingLength - 1 ] == delimeter ) {
+        remainingLength--;
+        pathRootSkipped[ remainingLength ] = '\0';
+        }
 
-        // first, count the delimeters
+    
+    // each delimeter separates two steps
+    mNumSteps = 0;
+    if( remainingLength > 0 ) {
+        mNumSteps = 1;
         
-        int delimCount = 0;
-        while( currentDelimPointer != NULL ) {
-            if( strlen( currentDelimPointer ) > 1 ) {
-                // don't count tail end delimeters
-                delimCount++;
+        for( int i=0; i<remainingLength; i++ ) {
+            if( pathRootSkipped[i] == delimeter ) {
+                mNumSteps++;
                 }
-            currentDelimPointer = strstr( &( currentDelimPointer[1] ),
-                                          delimString );
             }
+        }
 
-        
-        // no delimeter at end of path
-        mNumSteps = delimCount + 1;
-       
-        mPathSteps = new char*[ mNumSteps ];
-        mStepLength = new int[ mNumSteps ];
-        
-        
-        // now extract the chars between delimeters as path steps
-        currentDelimPointer = strstr( pathRootSkipped, delimString );
-
-        int stepIndex = 0;
-
-        currentDelimPointer[0] = '\0';
+    char **steps = new char*[ mNumSteps ];
+    int *stepLengths = new int[ mNumSteps ];
 
-        mPathSteps[ stepIndex ] = stringDuplicate( pathRootSkipped );
-        mStepLength[ stepIndex ] = strlen( mPathSteps[ stepIndex ] );
-        stepIndex++;
-        
-        while( currentDelimPointer != NULL ) {
+    // terminate each step in place
+    char *stepStart = pathRootSkipped;
+    
+    for( int i=0; i<mNumSteps; i++ ) {
+        char *stepEnd = strchr( stepStart, delimeter );
 
-            char *nextDelimPointer = strstr( &( currentDelimPointer[1] ),
-                                             delimString );
-            
-            if( nextDelimPointer != NULL ) {
-                nextDelimPointer[0] = '\0';
-                }
-            
-            mPathSteps[ stepIndex ] =
-                stringDuplicate( &( currentDelimPointer[1] ) );
-            mStepLength[ stepIndex ] = strlen( mPathSteps[ stepIndex ] );
-            
-            stepIndex++;
-            
-            currentDelimPointer = nextDelimPointer;
+        if( stepEnd != NULL ) {
+            stepEnd[0] = '\0';
             }
         
-        }
-    else {
-        // no delimeters
-        
-        if( strlen( pathRootSkipped ) > 0 ) {
-            mNumSteps = 1;
-            mPathSteps = new char*[1];
-            mPathSteps[0] = stringDuplicate( pathRootSkipped );
-            
-            mStepLength = new int[1];
-            
-            mStepLength[0] = strlen( mPathSteps[0] );
-            }
-        else {
-            // path with root only
-            mNumSteps = 0;
-            mPathSteps = new char*[0];
-            mStepLength = new int[0];
+        steps[i] = stepStart;
+        stepLengths[i] = strlen( stepStart );
+
+        if( stepEnd != NULL ) {
+            stepStart = &( stepEnd[1] );
             }
         }
 
-    delete [] delimString;
+    buildData( rootString, steps, stepLengths );
+
+    delete [] steps;
+    delete [] stepLengths;
 
+    if( rootString != NULL ) {
+        delete [] rootString;
+        }
+    
     delete [] pathStringCopy;
     }
 
 
 		
 inline Path::~Path() {
-	// delete each step
-	for( int i=0; i<mNumSteps; i++ ) {
-		delete [] mPathSteps[i];
-		}
-	delete [] mPathSteps;
-
-	delete [] mStepLength;
-
-    if( mRootString != NULL ) {
-        delete [] mRootString;
-        }
+    releaseData();
 	}
 	
 
 
-inline char *Path::getPathString( int *outLength ) {
-	int length = 0;
-	// length = sum( length each step string + 1 )
-	// ( + 1 is for the delimeter that occurs after each step string )
-    int i;
-    for( i=0; i<mNumSteps; i++ ) {
-        length += mStepLength[i] + 1;
-		}
-	// if absolute, we need to add in the length of the root
-	char *rootString = NULL;
-	int rootLength = 0;
-	if( mAbsolute ) {
-        if( mRootString != NULL ) {
-            rootString = stringDuplicate( mRootString );
-            rootLength = strlen( mRootString );
-            }
-        else {
-            rootString = getAbsoluteRoot( &rootLength );
-            }
-		length += rootLength;
-		}
+inline int Path::getPathStringLength() {
+    return mLength;
+    }
 
-	char *returnString = new char[ length ];
-	int index = 0;
-	
-	if( rootString != NULL ) {
-		// write root into string
-		memcpy( &( returnString[index] ), rootString, rootLength );
-		index += rootLength;
-		
-		delete [] rootString;
-		}
-	
-	char delimeter = getDelimeter();
-	
-	// write each step into the string
-	for( i=0; i<mNumSteps; i++ ) {
-		memcpy( &( returnString[index] ), mPathSteps[i], mStepLength[i] );
-		index += mStepLength[i];
-		returnString[ index ] = delimeter;
-		index++;
-		}
+
+
+inline char *Path::appendTo( char *inBuffer ) {
+    memcpy( inBuffer, mData->string, mLength );
+    return &( inBuffer[ mLength ] );
+    }
+
+
+
+inline char *Path::getPathString( int *outLength ) {
+	char *returnString = new char[ mLength ];
+    
+    appendTo( returnString );
 		
-	*outLength = length;
+	*outLength = mLength;
 	
 	return returnString;
 	}
@@ -497,50 +594,42 @@ inline char *Path::getPathString( int *outLength ) {
 
 
 inline char *Path::getPathStringTerminated() {
-	int length;
-
-	char *pathString = getPathString( &length );
-
-	char *delimitedPathString = new char[ length + 1 ];
-	memcpy( delimitedPathString, pathString, length );
+	char *returnString = new char[ mLength + 1 ];
 
-	delimitedPathString[ length ] = '\0';
+    appendTo( returnString )[0] = '\0';
 
-
-	delete [] pathString;
-
-	return delimitedPathString;
+	return returnString;
 	}
 
 
 
 inline Path *Path::copy() {
-
-	// the steps will be copied internally
-	return new Path( mPathSteps, mNumSteps, mAbsolute, mRootString );
+	// share our string
+	return new Path( mData, mNumSteps, mAbsolute, mRootLength );
 	}
 
 
 
 inline Path *Path::append( const char *inStepString ) {
-	char **newPathSteps = new char*[ mNumSteps + 1 ];
-
-	// shallow copy, since the strings themselves
-	// are copied in the Path constructor below
-	for( int i=0; i<mNumSteps; i++ ) {
-		newPathSteps[i] = mPathSteps[i];
-		}
-
-	// append final step
-	newPathSteps[ mNumSteps ] = (char*)inStepString;
-
-	Path *newPath = new Path( newPathSteps, mNumSteps + 1, mAbsolute,
-                              mRootString );
-
-	// shallow delete, because of shallow copy above
-	delete [] newPathSteps;
+    int stepLength = strlen( inStepString );
+    
+    // can't share our string, since it may be followed by other steps
+    Path *newPath = new Path( NULL, 0, mAbsolute, mRootLength );
+    newPath->allocateData( mLength + stepLength + 1, mNumSteps + 1 );
 
-	
+    char *string = newPath->mData->string;
+    
+    // our path, then new step
+    char *stepStart = appendTo( string );
+    memcpy( stepStart, inStepString, stepLength );
+    
+    memcpy( newPath->mData->stepEnds, mData->stepEnds,
+            mNumSteps * sizeof( int ) );
+    
+    newPath->mData->stepEnds[ mNumSteps ] = mLength + stepLength;
+    
+    string[ mLength + stepLength ] = getDelimeter();
+    
 	return newPath;
 	}
 
@@ -554,39 +643,32 @@ inline Path *Path::truncate() {
     else if( mNumSteps < 1 ) {
         return NULL;
         }
-    
-    char **newPathSteps = new char*[ mNumSteps ];
 
-	// shallow copy, since the strings themselves
-	// are copied in the Path constructor below
-	for( int i=0; i<mNumSteps-1; i++ ) {
-		newPathSteps[i] = mPathSteps[i];
-		}
-
-	Path *newPath = new Path( newPathSteps, mNumSteps - 1, mAbsolute,
-                              mRootString );
-
-	// shallow delete, because of shallow copy above
-	delete [] newPathSteps;
-
-	
-	return newPath;
+    // prefix of our string
+	return new Path( mData, mNumSteps - 1, mAbsolute, mRootLength );
 	}
 
 
 
 inline char *Path::getLastStep() {
     if( mNumSteps >= 1 ) {
-        return stringDuplicate( mPathSteps[ mNumSteps - 1 ] );
+        int start = getStepStart( mNumSteps - 1 );
+        int length = mData->stepEnds[ mNumSteps - 1 ] - start;
+
+        char *step = new char[ length + 1 ];
+        memcpy( step, &( mData->string[ start ] ), length );
+        step[ length ] = '\0';
+        
+        return step;
         }
     else {
         if( mAbsolute ) {
-            if( mRootString != NULL ) {
-                return stringDuplicate( mRootString );
-                }
-            else {
-                return getAbsoluteRootString();
-                }
+            // root only
+            char *root = new char[ mRootLength + 1 ];
+            memcpy( root, mData->string, mRootLength );
+            root[ mRootLength ] = '\0';
+            
+            return root;
             }
         else {
             // no path steps and not absolute...
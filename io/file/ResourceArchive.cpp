@@ -0,0 +1,507 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+
+
+#include "ResourceArchive.h"
+#include "MappedFileContents.h"
+
+#include "minorGems/formats/encodingUtils.h"
+#include "minorGems/util/stringUtils.h"
+
+#include <string.h>
+
+
+
+#define HEADER_LENGTH 20
+#define RECORD_LENGTH 32
+
+#define FLAG_COMPRESSED 1
+
+
+
+static unsigned int readUInt( const unsigned char *inBytes ) {
+    return
+        (unsigned int)inBytes[0] |
+        (unsigned int)inBytes[1] << 8 |
+        (unsigned int)inBytes[2] << 16 |
+        (unsigned int)inBytes[3] << 24;
+    }
+
+
+
+static void writeUInt( unsigned int inValue, unsigned char *outBytes ) {
+    outBytes[0] = (unsigned char)( inValue & 0xFF );
+    outBytes[1] = (unsigned char)( ( inValue >> 8 ) & 0xFF );
+    outBytes[2] = (unsigned char)( ( inValue >> 16 ) & 0xFF );
+    outBytes[3] = (unsigned char)( ( inValue >> 24 ) & 0xFF );
+    }
+
+
+
+// path with leading "./" steps skipped
+static const char *skipDotSteps( const char *inPath ) {
+    while( inPath[0] == '.' && ( inPath[1] == '/' || inPath[1] == '\\' ) ) {
+        inPath = &( inPath[2] );
+        }
+    return inPath;
+    }
+
+
+
+static char normalizeSeparator( char inC ) {
+    if( inC == '\\' ) {
+        return '/';
+        }
+    return inC;
+    }
+
+
+
+unsigned int ResourceArchive::hashPath( const char *inPath, int inLength ) {
+    // FNV-1a
+    unsigned int h = 2166136261U;
+
+    for( int i=0; i<inLength; i++ ) {
+        h ^= (unsigned char)normalizeSeparator( inPath[i] );
+        h *= 16777619U;
+        }
+    return h;
+    }
+
+
+
+ResourceArchive::ResourceArchive( const char *inArchiveFileName )
+        : mContents( new MappedFileContents( inArchiveFileName ) ),
+          mData( NULL ),
+          mNumEntries( 0 ), mNumBuckets( 0 ),
+          mBuckets( NULL ), mEntries( NULL ) {
+
+    if( ! mContents->isMapped() ) {
+        return;
+        }
+
+    const unsigned char *data = mContents->getData();
+    int length = mContents->getLength();
+
+    if( length < HEADER_LENGTH ||
+        memcmp( data, "MGRA", 4 ) != 0 ||
+        readUInt( &( data[4] ) ) != 1 ) {
+        return;
+        }
+
+    unsigned int numEntries = readUInt( &( data[8] ) );
+    unsigned int numBuckets = readUInt( &( data[12] ) );
+    unsigned int indexOffset = readUInt( &( data[16] ) );
+
+    // bucket count must be a power of 2, and tables must fit in file
+    if( numBuckets == 0 ||
+        ( numBuckets & ( numBuckets - 1 ) ) != 0 ||
+        numBuckets > (unsigned int)length ||
+        numEntries > (unsigned int)length ||
+        indexOffset > (unsigned int)length ||
+        (unsigned long long)numBuckets * 4 +
+        (unsigned long long)numEntries * RECORD_LENGTH >
+        (unsigned long long)( length - indexOffset ) ) {
+        return;
+        }
+
+    mNumEntries = numEntries;
+    mNumBuckets = numBuckets;
+    mBuckets = &( data[ indexOffset ] );
+    mEntries = &( mBuckets[ numBuckets * 4 ] );
+
+    if( ! validate( length ) ) {
+        mNumEntries = 0;
+        mNumBuckets = 0;
+        return;
+        }
+
+    mData = data;
+    }
+
+
+
+ResourceArchive::~ResourceArchive() {
+    delete mContents;
+    }
+
+
+
+char ResourceArchive::isOpen() {
+    return ( mData != NULL );
+    }
+
+
+
+int ResourceArchive::getNumEntries() {
+    return mNumEntries;
+    }
+
+
+
+char ResourceArchive::validate( int inFileLength ) {
+    unsigned int fileLength = (unsigned int)inFileLength;
+
+    for( int b=0; b<mNumBuckets; b++ ) {
+        if( readUInt( &( mBuckets[ b * 4 ] ) ) > (unsigned int)mNumEntries ) {
+            return false;
+            }
+        }
+
+    for( int i=0; i<mNumEntries; i++ ) {
+        const unsigned char *r = &( mEntries[ i * RECORD_LENGTH ] );
+
+        unsigned int next = readUInt( &( r[4] ) );
+        unsigned int pathOffset = readUInt( &( r[8] ) );
+        unsigned int pathLength = readUInt( &( r[12] ) );
+        unsigned int dataOffset = readUInt( &( r[16] ) );
+        unsigned int storedLength = readUInt( &( r[20] ) );
+        unsigned int rawLength = readUInt( &( r[24] ) );
+        unsigned int flags = readUInt( &( r[28] ) );
+
+        // chains only run forward, so they can't loop
+        if( ( next != 0 && next <= (unsigned int)( i + 1 ) ) ||
+            next > (unsigned int)mNumEntries ||
+            pathOffset > fileLength ||
+            pathLength > fileLength - pathOffset ||
+            dataOffset > fileLength ||
+            storedLength > fileLength - dataOffset ||
+            rawLength > 0x7FFFFFFE ||
+            ( ! ( flags & FLAG_COMPRESSED ) && storedLength != rawLength ) ) {
+            return false;
+            }
+        }
+
+    return true;
+    }
+
+
+
+const unsigned char *ResourceArchive::findEntry( const char *inPath ) {
+    if( mData == NULL ) {
+        return NULL;
+        }
+
+    inPath = skipDotSteps( inPath );
+    int pathLength = strlen( inPath );
+
+    unsigned int hash = hashPath( inPath, pathLength );
+
+    unsigned int entryNumber =
+        readUInt( &( mBuckets[ ( hash & ( mNumBuckets - 1 ) ) * 4 ] ) );
+
+    while( entryNumber != 0 ) {
+        const unsigned char *r = &( mEntries[ ( entryNumber - 1 ) *
+                                              RECORD_LENGTH ] );
+
+        if( readUInt( r ) == hash &&
+            readUInt( &( r[12] ) ) == (unsigned int)pathLength ) {
+
+            const char *entryPath =
+                (const char *)&( mData[ readUInt( &( r[8] ) ) ] );
+
+            char match = true;
+            for( int i=0; i<pathLength && match; i++ ) {
+                match =
+                    ( normalizeSeparator( inPath[i] ) == entryPath[i] );
+                }
+
+            if( match ) {
+                return r;
+                }
+            }
+
+        entryNumber = readUInt( &( r[4] ) );
+        }
+
+    return NULL;
+    }
+
+
+
+char ResourceArchive::hasEntry( const char *inPath ) {
+    return ( findEntry( inPath ) != NULL );
+    }
+
+
+
+unsigned char *ResourceArchive::readResource( const char *inPath,
+                                              int *outLength ) {
+    const unsigned char *r = findEntry( inPath );
+
+    if( r == NULL ) {
+        return NULL;
+        }
+
+    const unsigned char *storedData = &( mData[ readUInt( &( r[16] ) ) ] );
+    int storedLength = readUInt( &( r[20] ) );
+    int rawLength = readUInt( &( r[24] ) );
+
+    unsigned char *result;
+
+    if( readUInt( &( r[28] ) ) & FLAG_COMPRESSED ) {
+        unsigned char *raw =
+            zipDecompress( (unsigned char *)storedData, storedLength,
+                           rawLength );
+
+        if( raw == NULL ) {
+            printf( "Resource archive entry corrupt: %s\n", inPath );
+            return NULL;
+            }
+
+        // copy to make room for terminator
+        result = new unsigned char[ rawLength + 1 ];
+        memcpy( result, raw, rawLength );
+
+        delete [] raw;
+        }
+    else {
+        result = new unsigned char[ rawLength + 1 ];
+        memcpy( result, storedData, rawLength );
+        }
+
+    result[ rawLength ] = '\0';
+
+    *outLength = rawLength;
+    return result;
+    }
+
+
+
+const unsigned char *ResourceArchive::getStoredResource( const char *inPath,
+                                                         int *outLength ) {
+    const unsigned char *r = findEntry( inPath );
+
+    if( r == NULL || ( readUInt( &( r[28] ) ) & FLAG_COMPRESSED ) ) {
+        return NULL;
+        }
+
+    *outLength = readUInt( &( r[24] ) );
+    return &( mData[ readUInt( &( r[16] ) ) ] );
+    }
+
+
+
+
+ResourceArchiveWriter::ResourceArchiveWriter( const char *inArchiveFileName )
+        : mFile( fopen( inArchiveFileName, "wb" ) ),
+          mOK( true ),
+          mDataEnd( HEADER_LENGTH ) {
+
+    if( mFile == NULL ) {
+        mOK = false;
+        return;
+        }
+
+    // header filled in by finish
+    unsigned char header[ HEADER_LENGTH ];
+    memset( header, 0, HEADER_LENGTH );
+
+    if( fwrite( header, 1, HEADER_LENGTH, mFile ) != HEADER_LENGTH ) {
+        mOK = false;
+        }
+    }
+
+
+
+ResourceArchiveWriter::~ResourceArchiveWriter() {
+    if( mFile != NULL ) {
+        fclose( mFile );
+        }
+
+    for( int i=0; i<mPaths.size(); i++ ) {
+        delete [] mPaths.getElementDirect( i );
+        }
+    }
+
+
+
+char ResourceArchiveWriter::isOK() {
+    return mOK;
+    }
+
+
+
+char ResourceArchiveWriter::addEntry( const char *inPath,
+                                      unsigned char *inData, int inLength,
+                                      char inCompress ) {
+    if( ! mOK ) {
+        return false;
+        }
+
+    char *path = stringDuplicate( skipDotSteps( inPath ) );
+    int pathLength = strlen( path );
+
+    for( int i=0; i<pathLength; i++ ) {
+        path[i] = normalizeSeparator( path[i] );
+        }
+
+    if( mPathIndex.contains( path ) ) {
+        printf( "Duplicate resource archive path: %s\n", path );
+        delete [] path;
+        return false;
+        }
+
+
+    unsigned char *compressed = NULL;
+    int compressedLength = 0;
+
+    if( inCompress && inLength > 0 ) {
+        compressed = zipCompress( inData, inLength, &compressedLength );
+
+        if( compressed != NULL &&
+            compressedLength > inLength - inLength / 8 ) {
+            // not worth giving up zero-copy reads
+            delete [] compressed;
+            compressed = NULL;
+            }
+        }
+
+    unsigned char *storedData = inData;
+    int storedLength = inLength;
+    unsigned int flags = 0;
+
+    if( compressed != NULL ) {
+        storedData = compressed;
+        storedLength = compressedLength;
+        flags = FLAG_COMPRESSED;
+        }
+
+    if( (unsigned long long)mDataEnd + storedLength > 0x7FFFFFFF ) {
+        printf( "Resource archive too large at %s\n", path );
+        mOK = false;
+        }
+    else if( storedLength > 0 &&
+             fwrite( storedData, 1, storedLength, mFile ) !=
+             (unsigned int)storedLength ) {
+        mOK = false;
+        }
+
+    if( compressed != NULL ) {
+        delete [] compressed;
+        }
+
+    if( ! mOK ) {
+        delete [] path;
+        return false;
+        }
+
+    mPathIndex.insert( path, mPaths.size() );
+    mPaths.push_back( path );
+
+    mRecords.push_back( ResourceArchive::hashPath( path, pathLength ) );
+    mRecords.push_back( mDataEnd );
+    mRecords.push_back( storedLength );
+    mRecords.push_back( inLength );
+    mRecords.push_back( flags );
+
+    mDataEnd += storedLength;
+
+    return true;
+    }
+
+
+
+char ResourceArchiveWriter::finish() {
+    if( ! mOK || mFile == NULL ) {
+        return false;
+        }
+
+    int numEntries = mPaths.size();
+
+    // about one entry per bucket
+    unsigned int numBuckets = 1;
+    while( numBuckets < (unsigned int)numEntries ) {
+        numBuckets *= 2;
+        }
+
+    unsigned int indexOffset = mDataEnd;
+    unsigned int pathsOffset =
+        indexOffset + numBuckets * 4 + numEntries * RECORD_LENGTH;
+
+    unsigned int *bucketHeads = new unsigned int[ numBuckets ];
+    memset( bucketHeads, 0, numBuckets * sizeof( unsigned int ) );
+
+    unsigned int *next = new unsigned int[ numEntries ];
+
+    // build chains back to front, so that each chain runs forward
+    // through entry numbers
+    for( int i=numEntries-1; i>=0; i-- ) {
+        unsigned int hash = mRecords.getElementDirect( i * 5 );
+        unsigned int b = hash & ( numBuckets - 1 );
+
+        next[i] = bucketHeads[b];
+        bucketHeads[b] = i + 1;
+        }
+
+
+    int indexLength = pathsOffset - indexOffset;
+    unsigned char *index = new unsigned char[ indexLength ];
+
+    for( unsigned int b=0; b<numBuckets; b++ ) {
+        writeUInt( bucketHeads[b], &( index[ b * 4 ] ) );
+        }
+
+    unsigned int pathOffset = pathsOffset;
+
+    for( int i=0; i<numEntries; i++ ) {
+        unsigned char *r = &( index[ numBuckets * 4 + i * RECORD_LENGTH ] );
+
+        int pathLength = strlen( mPaths.getElementDirect( i ) );
+
+        writeUInt( mRecords.getElementDirect( i * 5 ), r );
+        writeUInt( next[i], &( r[4] ) );
+        writeUInt( pathOffset, &( r[8] ) );
+        writeUInt( pathLength, &( r[12] ) );
+        writeUInt( mRecords.getElementDirect( i * 5 + 1 ), &( r[16] ) );
+        writeUInt( mRecords.getElementDirect( i * 5 + 2 ), &( r[20] ) );
+        writeUInt( mRecords.getElementDirect( i * 5 + 3 ), &( r[24] ) );
+        writeUInt( mRecords.getElementDirect( i * 5 + 4 ), &( r[28] ) );
+
+        pathOffset += pathLength;
+        }
+
+    delete [] bucketHeads;
+    delete [] next;
+
+    if( fwrite( index, 1, indexLength, mFile ) != (unsigned int)indexLength ) {
+        mOK = false;
+        }
+    delete [] index;
+
+    for( int i=0; i<numEntries && mOK; i++ ) {
+        char *path = mPaths.getElementDirect( i );
+        int pathLength = strlen( path );
+
+        if( fwrite( path, 1, pathLength, mFile ) !=
+            (unsigned int)pathLength ) {
+            mOK = false;
+            }
+        }
+
+
+    unsigned char header[ HEADER_LENGTH ];
+    memcpy( header, "MGRA", 4 );
+    writeUInt( 1, &( header[4] ) );
+    writeUInt( numEntries, &( header[8] ) );
+    writeUInt( numBuckets, &( header[12] ) );
+    writeUInt( indexOffset, &( header[16] ) );
+
+    if( mOK &&
+        ( fseek( mFile, 0, SEEK_SET ) != 0 ||
+          fwrite( header, 1, HEADER_LENGTH, mFile ) != HEADER_LENGTH ) ) {
+        mOK = false;
+        }
+
+    if( fclose( mFile ) != 0 ) {
+        mOK = false;
+        }
+    mFile = NULL;
+
+    return mOK;
+    }
@@ -0,0 +1,222 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+
+
+#include "minorGems/common.h"
+
+
+
+#ifndef RESOURCE_ARCHIVE_INCLUDED
+#define RESOURCE_ARCHIVE_INCLUDED
+
+
+#include "ResourceSource.h"
+
+#include "minorGems/util/SimpleVector.h"
+#include "minorGems/util/HashMap.h"
+
+#include <stdio.h>
+
+
+
+class MappedFileContents;
+
+
+
+/**
+ * Read-only archive of many resource files packed into one, so that
+ * loading them doesn't cost a file open (and filesystem metadata
+ * lookups) each.
+ *
+ * The archive is memory-mapped, and found through a hashed path index in
+ * constant time.  Each entry is either stored as-is or zip-compressed.
+ *
+ * Archives are built with ResourceArchiveWriter (see
+ * minorGems/game/resourcePacker for a command-line tool).
+ *
+ *
+ * Format (all integers are 32-bit, little-endian):
+ *
+ *   header:    "MGRA", version (1), number of entries, number of hash
+ *              buckets (a power of 2), offset of index
+ *   data:      entry contents, back to back
+ *   index:     one entry number + 1 for each bucket (0 if empty), then for
+ *              each entry:  path hash, next entry number + 1 in bucket
+ *              (0 at end), path offset, path length, data offset, stored
+ *              length, raw length, flags (1 if compressed), then all
+ *              paths, back to back
+ *
+ * Offsets are from the start of the file.
+ *
+ * @author Jason Rohrer.
+ */
+class ResourceArchive : public ResourceSource {
+
+    public:
+
+
+        /**
+         * Opens an archive.
+         *
+         * @param inArchiveFileName the archive's full path.
+         *   Must be destroyed by caller if non-const.
+         */
+        ResourceArchive( const char *inArchiveFileName );
+
+
+        virtual ~ResourceArchive();
+
+
+        // false if file missing or not a valid archive
+        char isOpen();
+
+
+        int getNumEntries();
+
+
+        // true if archive contains a resource
+        char hasEntry( const char *inPath );
+
+
+        // implements ResourceSource interface
+        // thread-safe
+        virtual unsigned char *readResource( const char *inPath,
+                                             int *outLength );
+
+
+
+        /**
+         * Gets a stored (uncompressed) resource without copying it.
+         *
+         * @param inPath the resource's relative path.
+         *   Must be destroyed by caller if non-const.
+         * @param outLength pointer to where the resource's length in
+         *   bytes should be returned.
+         *
+         * @return the resource's bytes in the mapped archive, or NULL
+         *   if not found or if resource is compressed (use readResource
+         *   then).
+         *   Valid as long as this archive is open.  Not \0-terminated.
+         *   Must NOT be destroyed by caller.
+         */
+        const unsigned char *getStoredResource( const char *inPath,
+                                                int *outLength );
+
+
+
+        // hash used by path index (32-bit FNV-1a), over path with '/'
+        // separators
+        static unsigned int hashPath( const char *inPath, int inLength );
+
+
+    protected:
+
+        MappedFileContents *mContents;
+
+        const unsigned char *mData;
+
+        int mNumEntries;
+        int mNumBuckets;
+
+        const unsigned char *mBuckets;
+        const unsigned char *mEntries;
+
+
+        // returns start of entry record, or NULL if not found
+        const unsigned char *findEntry( const char *inPath );
+
+        // checks that all entry records point inside the archive
+        char validate( int inFileLength );
+    };
+
+
+
+/**
+ * Builds a ResourceArchive file.
+ *
+ * Entry data is written to the file as entries are added, so only the
+ * paths are held in memory.
+ *
+ *   ResourceArchiveWriter w( "resources.pack" );
+ *   w.addEntry( "graphics/font.tga", data, length, true );
+ *   ...
+ *   w.finish();
+ */
+class ResourceArchiveWriter {
+
+    public:
+
+
+        /**
+         * Starts writing an archive.
+         *
+         * @param inArchiveFileName the file to write.  Overwritten if
+         *   it exists.
+         *   Must be destroyed by caller if non-const.
+         */
+        ResourceArchiveWriter( const char *inArchiveFileName );
+
+
+        // closes archive without finishing it, if finish not called
+        ~ResourceArchiveWriter();
+
+
+        // false if file could not be opened, or if a write has failed
+        char isOK();
+
+
+
+        /**
+         * Adds an entry.
+         *
+         * @param inPath the entry's relative path.  '\' separators are
+         *   converted to '/'.
+         *   Must be destroyed by caller if non-const.
+         * @param inData the entry's contents.
+         *   Must be destroyed by caller.
+         * @param inLength the length of inData.
+         * @param inCompress true to zip-compress entry.  Entries that
+         *   shrink by less than 1/8 are stored anyway, since stored
+         *   entries can be read without copying.
+         *
+         * @return true on success, or false on write error or
+         *   duplicate path.
+         */
+        char addEntry( const char *inPath,
+                       unsigned char *inData, int inLength,
+                       char inCompress );
+
+
+
+        /**
+         * Writes index and closes archive.
+         *
+         * @return true on success.
+         */
+        char finish();
+
+
+    protected:
+
+        FILE *mFile;
+        char mOK;
+
+        unsigned int mDataEnd;
+
+        // each path, and for each entry:  hash, data offset, stored
+        // length, raw length, flags
+        SimpleVector<char *> mPaths;
+        SimpleVector<unsigned int> mRecords;
+
+        // to catch duplicates
+        HashMap<const char*, int> mPathIndex;
+    };
+
+
+
+#endif
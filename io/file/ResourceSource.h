@@ -0,0 +1,59 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+
+
+#include "minorGems/common.h"
+
+
+
+#ifndef RESOURCE_SOURCE_INCLUDED
+#define RESOURCE_SOURCE_INCLUDED
+
+
+
+/**
+ * Interface for places, other than loose files on disk, that game
+ * resources can be read from by path (like a ResourceArchive).
+ *
+ * Lets loaders (SettingsManager, for example) consult a source without
+ * linking against its implementation.
+ *
+ * @author Jason Rohrer.
+ */
+class ResourceSource {
+
+    public:
+
+        virtual ~ResourceSource() {
+            }
+
+
+        /**
+         * Reads a resource.
+         *
+         * Must be safe to call from multiple threads at once.
+         *
+         * @param inPath the resource's relative path, with '/' (or '\')
+         *   separators, like "graphics/font.tga".
+         *   Must be destroyed by caller if non-const.
+         * @param outLength pointer to where the resource's length in
+         *   bytes should be returned.
+         *
+         * @return the resource's contents, or NULL if not found.
+         *   Followed by an extra \0 byte (not counted in outLength), so
+         *   text resources can be used as strings.
+         *   Must be destroyed by caller if non-NULL.
+         */
+        virtual unsigned char *readResource( const char *inPath,
+                                             int *outLength ) = 0;
+
+    };
+
+
+
+#endif
@@ -0,0 +1,90 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14   Jason Rohrer
+ * Created.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Opens counted in StartupTimeline.
+ */
+
+
+
+#include "minorGems/io/file/MappedFileContents.h"
+
+#ifdef STARTUP_TIMELINE
+#include "minorGems/system/StartupTimeline.h"
+#endif
+
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+
+
+// non-NULL data for empty files, which can't be mapped
+static const unsigned char emptyContents[1] = { 0 };
+
+
+
+MappedFileContents::MappedFileContents( const char *inFullFileName )
+        : mMapped( false ), mData( NULL ), mLength( 0 ),
+          mMappingHandle( NULL ) {
+
+    int fd = open( inFullFileName, O_RDONLY );
+
+    if( fd == -1 ) {
+        return;
+        }
+
+    #ifdef STARTUP_TIMELINE
+    // bytes aren't counted, since pages are only read as they are touched
+    StartupTimeline::noteFileOpened();
+    #endif
+
+    struct stat fileInfo;
+
+    if( fstat( fd, &fileInfo ) == -1 ||
+        ! S_ISREG( fileInfo.st_mode ) ||
+        fileInfo.st_size > 0x7FFFFFFF ) {
+        close( fd );
+        return;
+        }
+
+    mLength = (int)fileInfo.st_size;
+
+    if( mLength == 0 ) {
+        close( fd );
+
+        mData = emptyContents;
+        mMapped = true;
+        return;
+        }
+
+    void *address = mmap( NULL, mLength, PROT_READ, MAP_PRIVATE, fd, 0 );
+
+    // mapping holds its own reference to the file
+    close( fd );
+
+    if( address == MAP_FAILED ) {
+        mLength = 0;
+        return;
+        }
+
+    // most callers read contents front to back
+    madvise( address, mLength, MADV_SEQUENTIAL );
+
+    mData = (const unsigned char *)address;
+    mMapped = true;
+    }
+
+
+
+MappedFileContents::~MappedFileContents() {
+    if( mMapped && mLength > 0 ) {
+        munmap( (void *)mData, mLength );
+        }
+    }
@@ -0,0 +1,97 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14   Jason Rohrer
+ * Created.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Opens counted in StartupTimeline.
+ */
+
+
+
+#include "minorGems/io/file/MappedFileContents.h"
+
+#ifdef STARTUP_TIMELINE
+#include "minorGems/system/StartupTimeline.h"
+#endif
+
+
+
+#include <windows.h>
+
+
+
+// non-NULL data for empty files, which can't be mapped
+static const unsigned char emptyContents[1] = { 0 };
+
+
+
+MappedFileContents::MappedFileContents( const char *inFullFileName )
+        : mMapped( false ), mData( NULL ), mLength( 0 ),
+          mMappingHandle( NULL ) {
+
+    HANDLE file = CreateFileA( inFullFileName, GENERIC_READ,
+                               FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                               FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+
+    if( file == INVALID_HANDLE_VALUE ) {
+        return;
+        }
+
+    #ifdef STARTUP_TIMELINE
+    // bytes aren't counted, since pages are only read as they are touched
+    StartupTimeline::noteFileOpened();
+    #endif
+
+    LARGE_INTEGER size;
+
+    if( ! GetFileSizeEx( file, &size ) ||
+        size.QuadPart > 0x7FFFFFFF ) {
+        CloseHandle( file );
+        return;
+        }
+
+    mLength = (int)size.QuadPart;
+
+    if( mLength == 0 ) {
+        // CreateFileMapping fails on empty files
+        CloseHandle( file );
+
+        mData = emptyContents;
+        mMapped = true;
+        return;
+        }
+
+    HANDLE mapping = CreateFileMappingA( file, NULL, PAGE_READONLY,
+                                         0, 0, NULL );
+
+    // mapping holds its own reference to the file
+    CloseHandle( file );
+
+    if( mapping == NULL ) {
+        mLength = 0;
+        return;
+        }
+
+    void *address = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+
+    if( address == NULL ) {
+        CloseHandle( mapping );
+        mLength = 0;
+        return;
+        }
+
+    mMappingHandle = (void *)mapping;
+    mData = (const unsigned char *)address;
+    mMapped = true;
+    }
+
+
+
+MappedFileContents::~MappedFileContents() {
+    if( mMapped && mLength > 0 ) {
+        UnmapViewOfFile( (LPCVOID)mData );
+        CloseHandle( (HANDLE)mMappingHandle );
+        }
+    }
@@ -13,6 +13,9 @@
  *
  * 2002-October-13   Jason Rohrer
  * Re-added mkdir wrapper function, since both CW4 and VC++ need it.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Filled in d_type.
  */
 
 
@@ -128,6 +131,8 @@ struct dirent *readdir(DIR *dir)
         {
             result         = &dir->result;
             result->d_name = dir->info.name;
+            result->d_type =
+                ( dir->info.attrib & _A_SUBDIR ) ? DT_DIR : DT_REG;
         }
     }
     else
@@ -13,6 +13,10 @@
  *
  * 2002-October-13   Jason Rohrer
  * Re-added mkdir wrapper function, since both CW4 and VC++ need it.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Added d_type, filled from find data, so directories can be told apart
+ * without a stat per entry.
  */
 
 #include "minorGems/common.h"
@@ -43,8 +47,15 @@ typedef struct DIR DIR;
 struct dirent
 {
     char *d_name;
+    unsigned char d_type;
 };
 
+/* d_type values, as on POSIX systems that have them */
+#define DT_UNKNOWN  0
+#define DT_DIR      4
+#define DT_REG      8
+#define DT_LNK      10
+
 DIR           *opendir(const char *);
 int           closedir(DIR *);
 struct dirent *readdir(DIR *);
@@ -0,0 +1,397 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+
+
+#include "SerialLineReader.h"
+
+#include "minorGems/system/Thread.h"
+#include "minorGems/system/Time.h"
+
+
+#include <string.h>
+
+
+
+// how often the reader thread checks for stop while the port is idle
+#define READ_TIMEOUT_MS 100
+
+
+
+SerialLineListener::~SerialLineListener() {
+    }
+
+
+
+class SerialLineReaderThread : public Thread {
+
+    public:
+
+        SerialLineReaderThread( SerialLineReader *inReader )
+                : mReader( inReader ) {
+            }
+
+        ~SerialLineReaderThread() {
+            join();
+            }
+
+        void run() {
+            mReader->readLoop();
+            }
+
+    protected:
+        SerialLineReader *mReader;
+    };
+
+
+
+SerialLineReader::SerialLineReader( SerialPort *inPort,
+                                    SerialLineListener *inListener,
+                                    int inBufferSize )
+        : mPort( inPort ), mListener( inListener ),
+          mRingSize( inBufferSize ),
+          mRingStart( 0 ), mRingUsed( 0 ), mCompleteUsed( 0 ),
+          mNumLinesReady( 0 ), mNumDroppedLines( 0 ),
+          mPortFinished( false ), mStopping( false ),
+          mReaderWaiting( false ),
+          mSkippingLine( false ),
+          mHeldLine( NULL ), mHeldLength( 0 ), mHeldRingLength( 0 ),
+          mWrapBuffer( NULL ), mWrapBufferSize( 0 ) {
+
+    if( mRingSize < 2 ) {
+        mRingSize = 2;
+        }
+
+    mRing = new char[ mRingSize ];
+
+    mThread = new SerialLineReaderThread( this );
+    mThread->start();
+    }
+
+
+
+SerialLineReader::~SerialLineReader() {
+    mLock.lock();
+    mStopping = true;
+    mLock.unlock();
+
+    mSpaceSemaphore.signal();
+
+    // joins
+    delete mThread;
+
+    delete [] mRing;
+
+    if( mWrapBuffer != NULL ) {
+        delete [] mWrapBuffer;
+        }
+    }
+
+
+
+void SerialLineReader::readLoop() {
+
+    while( true ) {
+
+        mLock.lock();
+
+        if( mStopping ) {
+            mLock.unlock();
+            return;
+            }
+
+        int writeIndex = ( mRingStart + mRingUsed ) % mRingSize;
+        int space = mRingSize - mRingUsed;
+
+        if( space > 0 && writeIndex + space > mRingSize ) {
+            // only read up to end of ring, and wrap next time
+            space = mRingSize - writeIndex;
+            }
+
+        if( space == 0 ) {
+            if( mCompleteUsed == 0 ) {
+                // ring holds part of one line that's too long
+                // drop it, and the rest of it as it comes in
+                mRingStart = 0;
+                mRingUsed = 0;
+                mNumDroppedLines++;
+                mSkippingLine = true;
+
+                mLock.unlock();
+                continue;
+                }
+
+            mReaderWaiting = true;
+            mLock.unlock();
+
+            mSpaceSemaphore.wait( READ_TIMEOUT_MS );
+            continue;
+            }
+
+        mLock.unlock();
+
+
+        // only this thread writes past mRingUsed, so no lock needed
+        char *readStart = &( mRing[ writeIndex ] );
+
+        int numRead = mPort->readAvailable( readStart, space,
+                                            READ_TIMEOUT_MS );
+
+        if( numRead < 0 ) {
+            mLock.lock();
+            mPortFinished = true;
+            mLock.unlock();
+
+            mLineSemaphore.signal();
+
+            if( mListener != NULL ) {
+                mListener->linesReady();
+                }
+            return;
+            }
+
+        if( numRead == 0 ) {
+            continue;
+            }
+
+
+        if( mSkippingLine ) {
+            char *end = (char *)memchr( readStart, '\n', numRead );
+
+            if( end == NULL ) {
+                continue;
+                }
+
+            mSkippingLine = false;
+
+            // keep what follows end of dropped line, at same spot
+            int numKept = numRead - (int)( end + 1 - readStart );
+
+            memmove( readStart, end + 1, numKept );
+            numRead = numKept;
+            }
+
+
+        // find line ends in new data, keeping last one
+        int numNewLines = 0;
+        char *lastEnd = NULL;
+
+        char *scan = readStart;
+        int numLeft = numRead;
+
+        while( numLeft > 0 ) {
+            char *end = (char *)memchr( scan, '\n', numLeft );
+
+            if( end == NULL ) {
+                break;
+                }
+
+            numNewLines++;
+            lastEnd = end;
+
+            numLeft -= (int)( end + 1 - scan );
+            scan = end + 1;
+            }
+
+
+        mLock.lock();
+
+        // new data starts at end of used data
+        int newDataOffset = mRingUsed;
+
+        mRingUsed += numRead;
+
+        char wasEmpty = ( mNumLinesReady == 0 );
+
+        if( numNewLines > 0 ) {
+            mCompleteUsed = newDataOffset + (int)( lastEnd + 1 - readStart );
+            mNumLinesReady += numNewLines;
+            }
+
+        mLock.unlock();
+
+        if( wasEmpty && numNewLines > 0 ) {
+            mLineSemaphore.signal();
+
+            if( mListener != NULL ) {
+                mListener->linesReady();
+                }
+            }
+        }
+    }
+
+
+
+char *SerialLineReader::getNextLine( int *outLength ) {
+    if( mHeldLine != NULL ) {
+        if( outLength != NULL ) {
+            *outLength = mHeldLength;
+            }
+        return mHeldLine;
+        }
+
+    mLock.lock();
+
+    if( mNumLinesReady == 0 ) {
+        mLock.unlock();
+        return NULL;
+        }
+
+    int start = mRingStart;
+    int completeUsed = mCompleteUsed;
+
+    mLock.unlock();
+
+
+    // complete lines aren't touched by reader thread, so no lock needed
+
+    int firstPartLength = mRingSize - start;
+    if( firstPartLength > completeUsed ) {
+        firstPartLength = completeUsed;
+        }
+
+    char *line = &( mRing[ start ] );
+    int length;
+
+    char *end = (char *)memchr( line, '\n', firstPartLength );
+
+    if( end != NULL ) {
+        length = (int)( end - line );
+        *end = '\0';
+        }
+    else {
+        // wraps around end of ring
+        end = (char *)memchr( mRing, '\n', completeUsed - firstPartLength );
+
+        int secondPartLength = (int)( end - mRing );
+
+        length = firstPartLength + secondPartLength;
+
+        if( mWrapBufferSize < length + 1 ) {
+            if( mWrapBuffer != NULL ) {
+                delete [] mWrapBuffer;
+                }
+            mWrapBufferSize = length + 1;
+            mWrapBuffer = new char[ mWrapBufferSize ];
+            }
+
+        memcpy( mWrapBuffer, line, firstPartLength );
+        memcpy( &( mWrapBuffer[ firstPartLength ] ), mRing,
+                secondPartLength );
+        mWrapBuffer[ length ] = '\0';
+
+        line = mWrapBuffer;
+        }
+
+    mHeldRingLength = length + 1;
+
+    if( length > 0 && line[ length - 1 ] == '\r' ) {
+        length--;
+        line[ length ] = '\0';
+        }
+
+    mHeldLine = line;
+    mHeldLength = length;
+
+    if( outLength != NULL ) {
+        *outLength = length;
+        }
+    return line;
+    }
+
+
+
+void SerialLineReader::releaseLine() {
+    if( mHeldLine == NULL ) {
+        return;
+        }
+
+    mHeldLine = NULL;
+
+    mLock.lock();
+
+    mRingStart = ( mRingStart + mHeldRingLength ) % mRingSize;
+    mRingUsed -= mHeldRingLength;
+    mCompleteUsed -= mHeldRingLength;
+    mNumLinesReady--;
+
+    char readerWaiting = mReaderWaiting;
+    mReaderWaiting = false;
+
+    mLock.unlock();
+
+    if( readerWaiting ) {
+        mSpaceSemaphore.signal();
+        }
+    }
+
+
+
+int SerialLineReader::getNumLinesReady() {
+    mLock.lock();
+    int numReady = mNumLinesReady;
+    mLock.unlock();
+
+    return numReady;
+    }
+
+
+
+char SerialLineReader::waitForLine( int inTimeoutMS ) {
+    double startTime = Time::getMonotonicTime();
+
+    while( true ) {
+        mLock.lock();
+        int numReady = mNumLinesReady;
+        char finished = mPortFinished;
+        mLock.unlock();
+
+        if( numReady > 0 ) {
+            return true;
+            }
+        if( finished ) {
+            return false;
+            }
+
+        int waitMS = inTimeoutMS;
+
+        if( inTimeoutMS >= 0 ) {
+            int passedMS =
+                (int)( ( Time::getMonotonicTime() - startTime ) * 1000 );
+
+            waitMS = inTimeoutMS - passedMS;
+
+            if( waitMS <= 0 ) {
+                return false;
+                }
+            }
+
+        // may be left over from an earlier batch of lines, so check again
+        // after it wakes us
+        mLineSemaphore.wait( waitMS );
+        }
+    }
+
+
+
+char SerialLineReader::isPortFinished() {
+    mLock.lock();
+    char finished = mPortFinished;
+    mLock.unlock();
+
+    return finished;
+    }
+
+
+
+int SerialLineReader::getNumDroppedLines() {
+    mLock.lock();
+    int numDropped = mNumDroppedLines;
+    mLock.unlock();
+
+    return numDropped;
+    }
@@ -0,0 +1,215 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+
+
+#ifndef SERIAL_LINE_READER_INCLUDED
+#define SERIAL_LINE_READER_INCLUDED
+
+
+
+#include "minorGems/io/serialPort/SerialPort.h"
+#include "minorGems/system/MutexLock.h"
+#include "minorGems/system/BinarySemaphore.h"
+
+
+
+#define SERIAL_LINE_READER_BUFFER_SIZE 65536
+
+
+
+/**
+ * Notified by a SerialLineReader when lines are ready.
+ */
+class SerialLineListener {
+
+    public:
+
+        virtual ~SerialLineListener();
+
+
+        /**
+         * Called from the reader's thread when lines become ready after
+         * none were, and when the port reaches an error or end of input.
+         *
+         * Must not block, and must not call back into the reader.
+         * Usually just wakes whatever thread takes lines.
+         */
+        virtual void linesReady() = 0;
+    };
+
+
+
+class SerialLineReaderThread;
+
+
+
+/**
+ * Reads lines from a SerialPort on a background thread.
+ *
+ * The thread pulls in as much as the port has with each read, into a
+ * ring buffer, and finds line ends with memchr.  Lines are handed out as
+ * views into the ring, so there's no allocation or copy per line (except
+ * for a line that wraps around the end of the ring, which is copied into
+ * a buffer that is reused).
+ *
+ * Lines are taken by one thread at a time, with getNextLine and
+ * releaseLine.  That thread can poll getNumLinesReady, block with
+ * waitForLine, or be woken by a SerialLineListener.
+ *
+ * If lines aren't taken fast enough and the ring fills up, the reader
+ * thread stops reading until there is room, so the port's own buffer
+ * takes up the slack.  A single line too long for the ring is dropped.
+ *
+ * @author Jason Rohrer
+ */
+class SerialLineReader {
+
+    public:
+
+
+        /**
+         * Constructs a reader and starts its thread.
+         *
+         * @param inPort the port to read from.
+         *   Must not be read from by anyone else while this reader exists.
+         *   Destroyed by caller after this reader is destroyed.
+         * @param inListener the listener to notify, or NULL.
+         *   Defaults to NULL.
+         *   Destroyed by caller after this reader is destroyed.
+         * @param inBufferSize the size of the ring buffer, in bytes.
+         *   Defaults to SERIAL_LINE_READER_BUFFER_SIZE.
+         */
+        SerialLineReader( SerialPort *inPort,
+                          SerialLineListener *inListener = NULL,
+                          int inBufferSize = SERIAL_LINE_READER_BUFFER_SIZE );
+
+
+        // stops and joins the thread
+        ~SerialLineReader();
+
+
+
+        /**
+         * Gets the next line, without waiting.
+         *
+         * Calling again before releaseLine returns the same line.
+         *
+         * @param outLength pointer to where the line's length should be
+         *   returned, or NULL.  Defaults to NULL.
+         *
+         * @return the line as a \0-terminated string, with end of line
+         *   characters removed, or NULL if no line is ready.
+         *   Valid until releaseLine is called.
+         *   Must NOT be destroyed by caller.
+         */
+        char *getNextLine( int *outLength = NULL );
+
+
+        // frees the space for the line returned by getNextLine
+        void releaseLine();
+
+
+
+        /**
+         * Gets the number of complete lines waiting.
+         *
+         * Includes any line returned by getNextLine and not yet released.
+         */
+        int getNumLinesReady();
+
+
+        /**
+         * Waits for a line to be ready.
+         *
+         * @param inTimeoutMS the most time to wait, in milliseconds,
+         *   or -1 to wait forever.
+         *
+         * @return true if a line is ready, or false on timeout or if
+         *   the port is finished and all lines have been taken.
+         */
+        char waitForLine( int inTimeoutMS );
+
+
+        /**
+         * Gets whether the port has reached an error or end of input.
+         *
+         * Lines read before then can still be taken.
+         */
+        char isPortFinished();
+
+
+        // gets the number of lines dropped for being too long for the ring
+        int getNumDroppedLines();
+
+
+
+    protected:
+
+        friend class SerialLineReaderThread;
+
+
+        SerialPort *mPort;
+        SerialLineListener *mListener;
+
+
+        // protects values below, up to reader-only ones
+        MutexLock mLock;
+
+        char *mRing;
+        int mRingSize;
+
+        // start of the unreleased data
+        int mRingStart;
+        // bytes of data in the ring
+        int mRingUsed;
+        // bytes of data at start that form complete lines
+        int mCompleteUsed;
+
+        int mNumLinesReady;
+        int mNumDroppedLines;
+
+        char mPortFinished;
+        char mStopping;
+
+        // true while reader thread waits for room in the ring
+        char mReaderWaiting;
+
+
+        // signaled when lines become ready
+        BinarySemaphore mLineSemaphore;
+
+        // signaled when room is freed while reader thread waits for it
+        BinarySemaphore mSpaceSemaphore;
+
+
+        // reader-only
+        // true while skipping the rest of a line that was too long
+        char mSkippingLine;
+
+
+        // taker-only
+        char *mHeldLine;
+        int mHeldLength;
+        // bytes of ring used by mHeldLine, including line end
+        int mHeldRingLength;
+
+        // for lines that wrap around end of ring
+        char *mWrapBuffer;
+        int mWrapBufferSize;
+
+
+        SerialLineReaderThread *mThread;
+
+
+        // run by reader thread
+        void readLoop();
+    };
+
+
+
+#endif
@@ -6,6 +6,9 @@
  *
  * 2003-April-4   Jason Rohrer
  * Added function for dumping the read buffer.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Added function for reading whatever is available, for SerialLineReader.
  */
 
 
@@ -80,6 +83,27 @@ class SerialPort {
 
 
 
+        /**
+         * Reads whatever characters are available, waiting for at least
+         * one.
+         *
+         * Unlike receiveLine, doesn't split lines or allocate, so it can
+         * pull in many lines per call (see SerialLineReader).
+         *
+         * @param outBuffer the buffer to read into.
+         *   Must be destroyed by caller.
+         * @param inMaxLength the most characters to read.
+         * @param inTimeoutMS the most time to wait for a character, in
+         *   milliseconds.
+         *
+         * @return the number of characters read, 0 on timeout, or -1 for
+         *   a port error (or end of input).
+         */
+        int readAvailable( char *outBuffer, int inMaxLength,
+                           int inTimeoutMS );
+
+
+
         /**
          * Discards all characters in the receive buffer, including
          * unread characters.
@@ -3,6 +3,10 @@
  *
  * 2003-March-28   Jason Rohrer
  * Created.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Added readAvailable.  Fixed receiveLine never returning NULL at end of
+ * file.
  */
 
 
@@ -52,11 +56,12 @@ char *SerialPort::receiveLine() {
         // read up to first newline
         int index = 0;
 
-        char lastCharRead = (char)getc( file );
+        int lastCharRead = getc( file );
 
-        while( lastCharRead != '\n' && index < 499 ) {
-            buffer[index] = lastCharRead;
-            lastCharRead = (char)getc( file );
+        while( lastCharRead != '\n' && lastCharRead != EOF &&
+               index < 499 ) {
+            buffer[index] = (char)lastCharRead;
+            lastCharRead = getc( file );
             index++;    
             }
 
@@ -82,7 +87,20 @@ char *SerialPort::receiveLine() {
 
 
 
+int SerialPort::readAvailable( char *outBuffer, int inMaxLength,
+                               int inTimeoutMS ) {
+    if( mNativeObjectPointer != NULL ) {
+        FILE *file = (FILE *)mNativeObjectPointer;
 
+        int numRead = fread( outBuffer, 1, inMaxLength, file );
 
-
-
+        if( numRead == 0 ) {
+            // end of file
+            return -1;
+            }
+        return numRead;
+        }
+    else {
+        return -1;
+        }
+    }
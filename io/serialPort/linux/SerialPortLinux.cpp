@@ -6,6 +6,9 @@
  *
  * 2003-April-4   Jason Rohrer
  * Added function for dumping the read buffer.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Added readAvailable.
  */
 
 
@@ -26,6 +29,8 @@
 #include <termios.h>
 #include <stdio.h>
 #include <unistd.h>
+#include <poll.h>
+#include <errno.h>
 // baudrate settings are defined in <asm/termbits.h>, which is
 // included by <termios.h>
 
@@ -255,6 +260,53 @@ char *SerialPort::receiveLine() {
 
 
 
+int SerialPort::readAvailable( char *outBuffer, int inMaxLength,
+                               int inTimeoutMS ) {
+    if( mNativeObjectPointer != NULL ) {
+        LinuxSerialPortObject *serialPortObject =
+            (LinuxSerialPortObject *)mNativeObjectPointer;
+        int fileHandle = serialPortObject->mFileHandle;
+
+        struct pollfd pollEntry;
+        pollEntry.fd = fileHandle;
+        pollEntry.events = POLLIN;
+        pollEntry.revents = 0;
+
+        int pollResult = poll( &pollEntry, 1, inTimeoutMS );
+
+        if( pollResult == 0 ) {
+            return 0;
+            }
+        if( pollResult < 0 ) {
+            if( errno == EINTR ) {
+                return 0;
+                }
+            return -1;
+            }
+
+        // in canonical mode, this returns at most one line, but returns
+        // all of it
+        int numRead = read( fileHandle, outBuffer, inMaxLength );
+
+        if( numRead < 0 ) {
+            if( errno == EINTR || errno == EAGAIN ) {
+                return 0;
+                }
+            return -1;
+            }
+        if( numRead == 0 ) {
+            // hang-up
+            return -1;
+            }
+        return numRead;
+        }
+    else {
+        return -1;
+        }
+    }
+
+
+
 void SerialPort::dumpReceiveBuffer() {
    if( mNativeObjectPointer != NULL ) {
        LinuxSerialPortObject *serialPortObject =
@@ -0,0 +1,203 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+/**
+ * Checks that SerialLineReader hands out every line in order, including
+ * lines that wrap around the end of its ring, CRLF lines, and lines
+ * too long for the ring (which are dropped), and compares its speed
+ * against receiveLine.
+ *
+ * Uses SerialPortFromFile, which reads gpscap.txt in place of a port,
+ * so this writes gpscap.txt in the current directory.
+ *
+ * Compile from above the minorGems directory with:
+ *   g++ -O2 -I. minorGems/io/serialPort/testSerialLineReader.cpp
+ *     minorGems/io/serialPort/SerialLineReader.cpp
+ *     minorGems/io/serialPort/SerialPortFromFile.cpp
+ *     minorGems/system/linux/[A-Z]*.cpp
+ *     minorGems/system/unix/TimeUnix.cpp minorGems/util/stringUtils.cpp
+ *     -lpthread -o testSerialLineReader
+ */
+
+#include "SerialLineReader.h"
+
+#include "minorGems/system/Time.h"
+
+#include <stdio.h>
+#include <string.h>
+
+
+
+static int numBad = 0;
+
+
+
+class CountingListener : public SerialLineListener {
+    public:
+        CountingListener()
+                : mCount( 0 ) {
+            }
+
+        void linesReady() {
+            mLock.lock();
+            mCount++;
+            mLock.unlock();
+            }
+
+        int getCount() {
+            mLock.lock();
+            int count = mCount;
+            mLock.unlock();
+            return count;
+            }
+
+    protected:
+        MutexLock mLock;
+        int mCount;
+    };
+
+
+
+// line i is "line i" followed by i%50 x's
+static void makeLine( int inIndex, char *outLine ) {
+    int length = sprintf( outLine, "line %d ", inIndex );
+
+    int numX = inIndex % 50;
+
+    memset( &( outLine[ length ] ), 'x', numX );
+    outLine[ length + numX ] = '\0';
+    }
+
+
+
+int main() {
+
+    int numLines = 200000;
+
+    char line[100];
+
+    FILE *file = fopen( "gpscap.txt", "w" );
+
+    for( int i=0; i<numLines; i++ ) {
+        makeLine( i, line );
+
+        if( i % 1000 == 7 ) {
+            // too long for the small ring below
+            for( int j=0; j<300; j++ ) {
+                fputc( 'L', file );
+                }
+            fputc( '\n', file );
+            }
+
+        if( i % 3 == 0 ) {
+            fprintf( file, "%s\r\n", line );
+            }
+        else {
+            fprintf( file, "%s\n", line );
+            }
+        }
+    fclose( file );
+
+
+    // small ring, so lines wrap often and long lines are dropped
+    int ringSizes[2] = { 256, SERIAL_LINE_READER_BUFFER_SIZE };
+
+    for( int r=0; r<2; r++ ) {
+        SerialPort port( 4800, SerialPort::PARITY_NONE, 8, 1 );
+        CountingListener listener;
+
+        double startTime = Time::getMonotonicTime();
+
+        SerialLineReader reader( &port, &listener, ringSizes[r] );
+
+        int nextLine = 0;
+        int numLong = 0;
+
+        while( reader.waitForLine( -1 ) ) {
+            int length;
+            char *readLine = reader.getNextLine( &length );
+
+            if( readLine[0] == 'L' ) {
+                numLong++;
+                }
+            else {
+                makeLine( nextLine, line );
+
+                if( strcmp( line, readLine ) != 0 ||
+                    length != (int)strlen( line ) ) {
+                    if( numBad < 10 ) {
+                        printf( "Expected '%s', got '%s'\n",
+                                line, readLine );
+                        }
+                    numBad++;
+                    }
+                nextLine++;
+                }
+
+            reader.releaseLine();
+            }
+
+        double time = Time::getMonotonicTime() - startTime;
+
+        if( nextLine != numLines ) {
+            printf( "Got %d lines, expected %d\n", nextLine, numLines );
+            numBad++;
+            }
+
+        int expectedLong = ( numLines + 992 ) / 1000;
+
+        if( r == 0 ) {
+            if( reader.getNumDroppedLines() != expectedLong ||
+                numLong != 0 ) {
+                printf( "Dropped %d long lines, got %d, expected %d "
+                        "dropped\n", reader.getNumDroppedLines(), numLong,
+                        expectedLong );
+                numBad++;
+                }
+            }
+        else if( numLong != expectedLong ) {
+            printf( "Got %d long lines, expected %d\n",
+                    numLong, expectedLong );
+            numBad++;
+            }
+
+        if( ! reader.isPortFinished() || listener.getCount() == 0 ) {
+            printf( "Port not finished, or listener not called\n" );
+            numBad++;
+            }
+
+        printf( "%d byte ring:  %d lines in %.3f s\n",
+                ringSizes[r], nextLine + numLong, time );
+        }
+
+
+    // receiveLine, for comparison
+    SerialPort port( 4800, SerialPort::PARITY_NONE, 8, 1 );
+
+    double startTime = Time::getMonotonicTime();
+
+    int numReceived = 0;
+    char *receivedLine = port.receiveLine();
+    while( receivedLine != NULL ) {
+        numReceived++;
+        delete [] receivedLine;
+        receivedLine = port.receiveLine();
+        }
+
+    printf( "receiveLine:  %d lines in %.3f s\n",
+            numReceived, Time::getMonotonicTime() - startTime );
+
+
+    remove( "gpscap.txt" );
+
+    if( numBad == 0 ) {
+        printf( "All tests passed\n" );
+        return 0;
+        }
+    printf( "%d failures\n", numBad );
+    return 1;
+    }
@@ -3,6 +3,9 @@
  *
  * 2003-April-4   Jason Rohrer
  * Added function for dumping the read buffer.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Added setReadTimeout.
  */
 
 //=============================================================================
@@ -321,6 +324,47 @@ return *this;
 } // end COMPort::setBlockingMode (..)
 
 
+//----------------------------------------------------------------------------
+COMPort& COMPort::setReadTimeout ( unsigned long inMilliseconds )
+{
+
+COMMTIMEOUTS commTimeout;
+if ( !GetCommTimeouts ( (HANDLE(thePortHandle))
+                      , &commTimeout
+                      )
+   )
+{
+   throw runtime_error ("COMPort: failed to retrieve timeouts.");
+} // endif
+
+// with both of these MAXDWORD, a read returns what is buffered, or
+// waits up to the constant for one character (constant can't be 0
+// or MAXDWORD here)
+if ( inMilliseconds < 1 )
+{
+   inMilliseconds = 1;
+}
+else if ( inMilliseconds >= MAXDWORD )
+{
+   inMilliseconds = MAXDWORD - 1;
+} // endifelse
+
+commTimeout.ReadIntervalTimeout = MAXDWORD;
+commTimeout.ReadTotalTimeoutMultiplier = MAXDWORD;
+commTimeout.ReadTotalTimeoutConstant = inMilliseconds;
+
+if ( !SetCommTimeouts ( (HANDLE(thePortHandle))
+                      , &commTimeout
+                      )
+   )
+{
+   throw runtime_error ("COMPort: failed to modify timeouts.");
+} // endif
+
+return *this;
+} // end COMPort::setReadTimeout (..)
+
+
 //-----------------------------------------------------------------------------
 COMPort & COMPort::setHandshaking ( bool inHandshaking )
 {
@@ -3,6 +3,9 @@
  *
  * 2003-April-4   Jason Rohrer
  * Added function for dumping the read buffer.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Added setReadTimeout.
  */
 
 //=============================================================================
@@ -131,6 +134,10 @@ public:
                              , unsigned long inReadConstant = 0
                              );
 
+    // reads return right away with whatever characters are buffered,
+    // or wait up to inMilliseconds for the first one
+    COMPort& setReadTimeout ( unsigned long inMilliseconds );
+
 protected:
 
 private:
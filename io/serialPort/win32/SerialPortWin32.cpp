@@ -9,6 +9,9 @@
  *
  * 2003-April-4   Jason Rohrer
  * Added function for dumping the read buffer.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Added readAvailable.
  */
 
 
@@ -183,6 +186,27 @@ char *SerialPort::receiveLine() {
 
 
 
+int SerialPort::readAvailable( char *outBuffer, int inMaxLength,
+                               int inTimeoutMS ) {
+    if( mNativeObjectPointer != NULL ) {
+        COMPort *port = (COMPort *)mNativeObjectPointer;
+
+        try {
+            port->setReadTimeout( inTimeoutMS );
+
+            return (int)( port->read( (void *)outBuffer, inMaxLength ) );
+            }
+        catch( ... ) {
+            return -1;
+            }
+        }
+    else {
+        return -1;
+        }
+    }
+
+
+
 void SerialPort::dumpReceiveBuffer() {
     if( mNativeObjectPointer != NULL ) {
         COMPort *port = (COMPort *)mNativeObjectPointer;
@@ -4,6 +4,12 @@
  * 2002-May-25    Jason Rohrer
  * Created.
  * Changed to remove extra zeros when subtracting.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Changed to 32-bit limbs, added in place along with the arithmetic
+ * instead of through flipped byte copies.  Added multiply (Karatsuba),
+ * divide (Knuth's algorithm D), mod, and modPow (Montgomery for odd
+ * moduli).
  */
 
 
@@ -17,441 +23,881 @@
 
 
 
-BigInt::BigInt( int inSign, int inNumBytes, unsigned char *inBytes )
-    : mSign( inSign ), mNumBytes( inNumBytes ),
-      mBytes( new unsigned char[ inNumBytes ] ) {
-          
-    memcpy( mBytes, inBytes, mNumBytes );
+// below this many limbs, schoolbook multiplication is faster
+#define KARATSUBA_THRESHOLD 32
+
+// bits of exponent handled per multiply in modPow
+#define MOD_POW_WINDOW_BITS 4
+
+
+
+// magnitude helpers work on little endian limb arrays
+
+
+
+// -1, 0, or 1, comparing a to b
+static int magCompare( const uint32_t *inA, int inNumA,
+                       const uint32_t *inB, int inNumB ) {
+    if( inNumA != inNumB ) {
+        return ( inNumA > inNumB ) ? 1 : -1;
+        }
+    for( int i=inNumA-1; i>=0; i-- ) {
+        if( inA[i] != inB[i] ) {
+            return ( inA[i] > inB[i] ) ? 1 : -1;
+            }
+        }
+    return 0;
     }
 
 
 
-BigInt::BigInt( int inInt ) {
-    if( inInt > 0 ) {
-        mSign = 1;
+// r = a + b, writing inNumA limbs, inNumA >= inNumB
+// r can be a or b
+// returns the carry out
+static uint32_t magAdd( uint32_t *outR,
+                        const uint32_t *inA, int inNumA,
+                        const uint32_t *inB, int inNumB ) {
+    uint64_t carry = 0;
+
+    int i;
+    for( i=0; i<inNumB; i++ ) {
+        carry += (uint64_t)inA[i] + inB[i];
+        outR[i] = (uint32_t)carry;
+        carry >>= 32;
         }
-    else if( inInt == 0 ) {
-        mSign = 0;
+    for( ; i<inNumA; i++ ) {
+        carry += inA[i];
+        outR[i] = (uint32_t)carry;
+        carry >>= 32;
         }
-    else {
-        mSign = -1;
+    return (uint32_t)carry;
+    }
+
+
 
-        // flip sign so conversion works
-        inInt *= -1;
+// r = a - b, writing inNumA limbs, a >= b
+// r can be a or b
+static void magSubtract( uint32_t *outR,
+                         const uint32_t *inA, int inNumA,
+                         const uint32_t *inB, int inNumB ) {
+    int64_t borrow = 0;
+
+    int i;
+    for( i=0; i<inNumB; i++ ) {
+        int64_t diff = (int64_t)inA[i] - inB[i] - borrow;
+        outR[i] = (uint32_t)diff;
+        borrow = ( diff < 0 ) ? 1 : 0;
         }
+    for( ; i<inNumA; i++ ) {
+        int64_t diff = (int64_t)inA[i] - borrow;
+        outR[i] = (uint32_t)diff;
+        borrow = ( diff < 0 ) ? 1 : 0;
+        }
+    }
+
+
 
-    mNumBytes = 4;
-    int bytesToSkip = 0;
-    
-    
-    int baseFactor = 1;
+// r[ inOffset... ] += b, carrying as far as needed within inNumR limbs
+static void magAddAt( uint32_t *ioR, int inNumR, int inOffset,
+                      const uint32_t *inB, int inNumB ) {
+    uint64_t carry = 0;
 
-    mBytes = new unsigned char[ 4 ];
-    
     int i;
-    for( i=mNumBytes-1; i>=mNumBytes-4; i-- ) {
-        mBytes[i] = 0xFF & ( inInt / baseFactor );        
-        
-        baseFactor *= 256;        
-        }
-
-    if( mBytes[0] == 0 ) {
-        bytesToSkip++;
-        if( mBytes[1] == 0 ) {
-            bytesToSkip++;
-            if( mBytes[2] == 0 ) {
-                bytesToSkip++;
-                if( mBytes[3] == 0 ) {
-                    bytesToSkip++;
-                    }
-                }
-            }
+    for( i=0; i<inNumB && inOffset + i < inNumR; i++ ) {
+        carry += (uint64_t)ioR[ inOffset + i ] + inB[i];
+        ioR[ inOffset + i ] = (uint32_t)carry;
+        carry >>= 32;
+        }
+    for( i += inOffset; carry != 0 && i < inNumR; i++ ) {
+        carry += ioR[i];
+        ioR[i] = (uint32_t)carry;
+        carry >>= 32;
         }
+    }
+
 
-    mNumBytes -= bytesToSkip;
 
-    unsigned char *temp = new unsigned char[ mNumBytes ];
-    
-    memcpy( temp, &( mBytes[ bytesToSkip ] ), mNumBytes );
+// r = a * b, writing inNumA + inNumB limbs, r not a or b
+static void magMultiplySchoolbook( uint32_t *outR,
+                                   const uint32_t *inA, int inNumA,
+                                   const uint32_t *inB, int inNumB ) {
+    memset( outR, 0, ( inNumA + inNumB ) * sizeof( uint32_t ) );
 
-    delete [] mBytes;
+    for( int i=0; i<inNumA; i++ ) {
+        uint64_t a = inA[i];
+        uint64_t carry = 0;
 
-    mBytes = temp;
+        uint32_t *row = &( outR[i] );
+
+        for( int j=0; j<inNumB; j++ ) {
+            carry += a * inB[j] + row[j];
+            row[j] = (uint32_t)carry;
+            carry >>= 32;
+            }
+        row[ inNumB ] = (uint32_t)carry;
+        }
     }
 
 
 
-BigInt::~BigInt() {
-    delete [] mBytes;
+// r = a * b for two inNum-limb numbers, writing 2 * inNum limbs,
+// r not a or b
+static void magMultiplyKaratsuba( uint32_t *outR,
+                                  const uint32_t *inA, const uint32_t *inB,
+                                  int inNum ) {
+    if( inNum < KARATSUBA_THRESHOLD ) {
+        magMultiplySchoolbook( outR, inA, inNum, inB, inNum );
+        return;
+        }
+
+    // a = a1 * base^low + a0
+    int low = inNum / 2;
+    int high = inNum - low;
+
+    // z0 = a0 * b0 and z2 = a1 * b1 go straight into place
+    magMultiplyKaratsuba( outR, inA, inB, low );
+    magMultiplyKaratsuba( &( outR[ 2 * low ] ), &( inA[low] ), &( inB[low] ),
+                          high );
+
+    // z1 = ( a0 + a1 )( b0 + b1 ) - z0 - z2
+    int sumLength = high + 1;
+
+    uint32_t *sumA = new uint32_t[ 4 * sumLength ];
+    uint32_t *sumB = &( sumA[ sumLength ] );
+    uint32_t *z1 = &( sumA[ 2 * sumLength ] );
+
+    sumA[high] = magAdd( sumA, &( inA[low] ), high, inA, low );
+    sumB[high] = magAdd( sumB, &( inB[low] ), high, inB, low );
+
+    magMultiplyKaratsuba( z1, sumA, sumB, sumLength );
+
+    magSubtract( z1, z1, 2 * sumLength, outR, 2 * low );
+    magSubtract( z1, z1, 2 * sumLength, &( outR[ 2 * low ] ), 2 * high );
+
+    magAddAt( outR, 2 * inNum, low, z1, 2 * sumLength );
+
+    delete [] sumA;
     }
 
 
 
-BigInt *BigInt::add( BigInt *inOtherInt ) {
-    //char *stringA = convertToHexString();
-    //char *stringB = inOtherInt->convertToHexString();
-    //printf( "Adding %s to %s\n", stringA, stringB );
-    //delete [] stringA;
-    //delete [] stringB;
-    
-    if( mSign == 0 && inOtherInt->mSign == 0 ) {
-        return getZero();
+// r = a * b, writing inNumA + inNumB limbs, r not a or b
+static void magMultiply( uint32_t *outR,
+                         const uint32_t *inA, int inNumA,
+                         const uint32_t *inB, int inNumB ) {
+    if( inNumA < inNumB ) {
+        magMultiply( outR, inB, inNumB, inA, inNumA );
+        return;
         }
-    else if( mSign == 0 && inOtherInt->mSign != 0 ) {
-        return inOtherInt->copy();
+
+    if( inNumB < KARATSUBA_THRESHOLD ) {
+        magMultiplySchoolbook( outR, inA, inNumA, inB, inNumB );
+        return;
         }
-    else if( mSign != 0 && inOtherInt->mSign == 0 ) {
-        return copy();
+
+    if( inNumA == inNumB ) {
+        magMultiplyKaratsuba( outR, inA, inB, inNumA );
+        return;
         }
-    else if( mSign == -1 && inOtherInt->mSign == -1 ) {
-        // adding two negatives
 
-        // add them as positives, then flip sign of result
+    // unbalanced:  multiply b by each b-sized chunk of a
+    memset( outR, 0, ( inNumA + inNumB ) * sizeof( uint32_t ) );
 
-        BigInt *copyA = copy();
-        BigInt *copyB = inOtherInt->copy();
+    uint32_t *product = new uint32_t[ 2 * inNumB ];
 
-        copyA->mSign = 1;
-        copyB->mSign = 1;
+    for( int offset=0; offset<inNumA; offset += inNumB ) {
+        int chunk = inNumA - offset;
+        if( chunk > inNumB ) {
+            chunk = inNumB;
+            }
+
+        magMultiply( product, &( inA[offset] ), chunk, inB, inNumB );
+        magAddAt( outR, inNumA + inNumB, offset, product, chunk + inNumB );
+        }
+
+    delete [] product;
+    }
 
-        BigInt *result = copyA->add( copyB );
 
-        delete copyA;
-        delete copyB;
 
-        result->mSign = -1;
-        
-        return result;        
+static int countLeadingZeros( uint32_t inX ) {
+    int n = 0;
+    while( n < 32 && ( inX & 0x80000000 ) == 0 ) {
+        inX <<= 1;
+        n++;
         }
-    else if( mSign == 1 && inOtherInt->mSign == -1 ) {
+    return n;
+    }
 
-        // flip other sign and subtract
-        BigInt *copy = inOtherInt->copy();
-        copy->mSign = 1;
 
-        BigInt *result = subtract( copy );
 
-        delete copy;
+// q = u / v and r = u % v, using algorithm D from Knuth's
+// "Seminumerical Algorithms" (as laid out in Hacker's Delight)
+// inNumU >= inNumV >= 1, v has no high zero limb
+// q gets inNumU - inNumV + 1 limbs, r gets inNumV limbs (either can be NULL)
+static void magDivide( uint32_t *outQ, uint32_t *outR,
+                       const uint32_t *inU, int inNumU,
+                       const uint32_t *inV, int inNumV ) {
+    int i, j;
 
-        return result;
+    if( inNumV == 1 ) {
+        uint64_t divisor = inV[0];
+        uint64_t remainder = 0;
+
+        for( j=inNumU-1; j>=0; j-- ) {
+            uint64_t value = ( remainder << 32 ) | inU[j];
+            if( outQ != NULL ) {
+                outQ[j] = (uint32_t)( value / divisor );
+                }
+            remainder = value % divisor;
+            }
+        if( outR != NULL ) {
+            outR[0] = (uint32_t)remainder;
+            }
+        return;
         }
-    else if( mSign == -1  && inOtherInt->mSign == 1 ) {
-        // flip our sign and subtract
-        BigInt *copy = this->copy();
-        copy->mSign = 1;
 
-        
-        BigInt *result = inOtherInt->subtract( copy );
+    // normalize so the divisor's high bit is set
+    int shift = countLeadingZeros( inV[ inNumV - 1 ] );
 
-        delete copy;
+    uint32_t *vn = new uint32_t[ inNumV + inNumU + 1 ];
+    uint32_t *un = &( vn[ inNumV ] );
 
-        return result;        
+    for( i=inNumV-1; i>0; i-- ) {
+        vn[i] = ( inV[i] << shift ) |
+            (uint32_t)( (uint64_t)inV[ i - 1 ] >> ( 32 - shift ) );
         }
-    else {
-        // both this int and arg int are positive
+    vn[0] = inV[0] << shift;
 
-        
-        int maxLength = mNumBytes;
-        if( maxLength < inOtherInt->mNumBytes ) {
-            maxLength = inOtherInt->mNumBytes;
-            }
+    un[ inNumU ] = (uint32_t)( (uint64_t)inU[ inNumU - 1 ] >> ( 32 - shift ) );
+    for( i=inNumU-1; i>0; i-- ) {
+        un[i] = ( inU[i] << shift ) |
+            (uint32_t)( (uint64_t)inU[ i - 1 ] >> ( 32 - shift ) );
+        }
+    un[0] = inU[0] << shift;
 
-        // leave room for carry
-        unsigned char *result = new unsigned char[ maxLength + 1 ];
 
-        // flip to little-endian order to make adding easier
-        BigInt *intA = flipByteOrder();
-        BigInt *intB = inOtherInt->flipByteOrder();
-        
-        int sum = 0;
-        
-        for( int i=0; i<maxLength; i++ ) {
+    uint64_t base = (uint64_t)1 << 32;
+    uint64_t topV = vn[ inNumV - 1 ];
+    uint64_t nextV = vn[ inNumV - 2 ];
+
+    for( j=inNumU-inNumV; j>=0; j-- ) {
+        // estimate this quotient limb from the top two limbs
+        uint64_t top = ( (uint64_t)un[ j + inNumV ] << 32 ) |
+            un[ j + inNumV - 1 ];
 
-            int byteA = 0;
-            int byteB = 0;
+        uint64_t qhat = top / topV;
+        uint64_t rhat = top - qhat * topV;
 
-            if( i < intA->mNumBytes ) {
-                byteA = intA->mBytes[i];
+        while( qhat >= base ||
+               qhat * nextV > ( ( rhat << 32 ) | un[ j + inNumV - 2 ] ) ) {
+            qhat--;
+            rhat += topV;
+            if( rhat >= base ) {
+                break;
                 }
-            if( i < intB->mNumBytes ) {
-                byteB = intB->mBytes[i];
+            }
+
+        // multiply and subtract
+        int64_t borrow = 0;
+        int64_t t;
+        for( i=0; i<inNumV; i++ ) {
+            uint64_t p = qhat * vn[i];
+            t = (int64_t)un[ i + j ] - borrow - (int64_t)( p & 0xFFFFFFFF );
+            un[ i + j ] = (uint32_t)t;
+            borrow = (int64_t)( p >> 32 ) - ( t >> 32 );
+            }
+        t = (int64_t)un[ j + inNumV ] - borrow;
+        un[ j + inNumV ] = (uint32_t)t;
+
+        if( t < 0 ) {
+            // estimate was one too high, add back
+            qhat--;
+            uint64_t carry = 0;
+            for( i=0; i<inNumV; i++ ) {
+                carry += (uint64_t)un[ i + j ] + vn[i];
+                un[ i + j ] = (uint32_t)carry;
+                carry >>= 32;
                 }
+            un[ j + inNumV ] += (uint32_t)carry;
+            }
 
-            // add in high-order bits from last sum
-            sum = byteA + byteB + ( sum >> 8 );
+        if( outQ != NULL ) {
+            outQ[j] = (uint32_t)qhat;
+            }
+        }
 
-            // truncate to low-order bits
-            result[i] = (unsigned char)sum;
+    if( outR != NULL ) {
+        // unnormalize
+        for( i=0; i<inNumV-1; i++ ) {
+            outR[i] = ( un[i] >> shift ) |
+                (uint32_t)( ( (uint64_t)un[ i + 1 ] << ( 32 - shift ) ) );
             }
+        outR[ inNumV - 1 ] = un[ inNumV - 1 ] >> shift;
+        }
+
+    delete [] vn;
+    }
+
+
 
-        // stick remaining carry into last byte
-        result[maxLength] = (unsigned char)( sum >> 8 );
+// Montgomery product r = a * b / base^inNum mod m, for a, b < m
+// ioScratch has inNum + 2 limbs, r can be a or b
+// inMInverse is -1/m mod base
+static void montgomeryMultiply( uint32_t *outR,
+                                const uint32_t *inA, const uint32_t *inB,
+                                const uint32_t *inM, int inNum,
+                                uint32_t inMInverse, uint32_t *ioScratch ) {
+    uint32_t *t = ioScratch;
+    memset( t, 0, ( inNum + 2 ) * sizeof( uint32_t ) );
 
-        BigInt *resultInt;
-        
-        if( result[maxLength] == 0 ) {
-            // result array will be copied skipping carry byte 
-            resultInt = new BigInt( 1, maxLength, result );
+    for( int i=0; i<inNum; i++ ) {
+        uint64_t b = inB[i];
+        uint64_t carry = 0;
+
+        int j;
+        for( j=0; j<inNum; j++ ) {
+            carry += t[j] + inA[j] * b;
+            t[j] = (uint32_t)carry;
+            carry >>= 32;
             }
-        else {
-            // keep carry byte
-            resultInt = new BigInt( 1, maxLength + 1, result );
+        carry += t[ inNum ];
+        t[ inNum ] = (uint32_t)carry;
+        t[ inNum + 1 ] = (uint32_t)( carry >> 32 );
+
+        // add a multiple of m that clears the low limb, then shift down
+        uint64_t q = (uint32_t)( t[0] * inMInverse );
+
+        carry = ( t[0] + q * inM[0] ) >> 32;
+        for( j=1; j<inNum; j++ ) {
+            carry += t[j] + q * inM[j];
+            t[ j - 1 ] = (uint32_t)carry;
+            carry >>= 32;
             }
+        carry += t[ inNum ];
+        t[ inNum - 1 ] = (uint32_t)carry;
+        t[ inNum ] = t[ inNum + 1 ] + (uint32_t)( carry >> 32 );
+        }
 
-        BigInt *flippedResult = resultInt->flipByteOrder();
+    if( t[ inNum ] != 0 || magCompare( t, inNum, inM, inNum ) >= 0 ) {
+        magSubtract( t, t, inNum + 1, inM, inNum );
+        }
+
+    memcpy( outR, t, inNum * sizeof( uint32_t ) );
+    }
 
-        
-        delete intA;
-        delete intB;
-        delete resultInt;
-        delete [] result;
 
-        
-        return flippedResult;
-        }
 
+BigInt::BigInt()
+    : mSign( 0 ), mNumLimbs( 0 ), mLimbs( NULL ), mCapacity( 0 ) {
     }
 
 
 
-BigInt *BigInt::subtract( BigInt *inOtherInt ) {
-    //char *stringA = convertToHexString();
-    //char *stringB = inOtherInt->convertToHexString();
-    //printf( "Subtracting %s from %s\n", stringB, stringA );
-    //delete [] stringA;
-    //delete [] stringB;
+BigInt::BigInt( int inSign, int inNumBytes, unsigned char *inBytes )
+    : mSign( inSign ), mNumLimbs( 0 ), mLimbs( NULL ), mCapacity( 0 ) {
 
-    if( mSign == 0 && inOtherInt->mSign == 0 ) {
-        return getZero();
+    ensureCapacity( ( inNumBytes + 3 ) / 4 );
+
+    mNumLimbs = ( inNumBytes + 3 ) / 4;
+    for( int i=0; i<mNumLimbs; i++ ) {
+        mLimbs[i] = 0;
         }
-    else if( mSign != 0 && inOtherInt->mSign == 0 ) {
-        return copy();
+
+    for( int i=0; i<inNumBytes; i++ ) {
+        // bytes are big endian
+        int bytePosition = inNumBytes - 1 - i;
+
+        mLimbs[ bytePosition / 4 ] |=
+            (uint32_t)inBytes[i] << ( 8 * ( bytePosition % 4 ) );
         }
-    else if( mSign == 0 && inOtherInt->mSign != 0 ) {
-        BigInt *copy = inOtherInt->copy();
-        // flip sign
-        copy->mSign = -( copy->mSign );
-        return copy;
+
+    normalize();
+    }
+
+
+
+BigInt::BigInt( int inInt )
+    : mSign( 0 ), mNumLimbs( 0 ), mLimbs( NULL ), mCapacity( 0 ) {
+
+    ensureCapacity( 1 );
+    mLimbs[0] = 0;
+
+    if( inInt > 0 ) {
+        mSign = 1;
+        mLimbs[0] = (uint32_t)inInt;
         }
-    else if( isEqualTo( inOtherInt ) ) {
-        return getZero();
+    else if( inInt < 0 ) {
+        mSign = -1;
+        // works for the most negative int too
+        mLimbs[0] = 0 - (uint32_t)inInt;
         }
-    else if( inOtherInt->mSign == -1 ) {
-        // flip sign and add
-        BigInt *copy = inOtherInt->copy();
-        copy->mSign = 1;
 
-        BigInt *result = add( copy );
+    mNumLimbs = 1;
+    normalize();
+    }
 
-        delete copy;
-        
-        return result;
+
+
+BigInt::~BigInt() {
+    if( mLimbs != NULL ) {
+        delete [] mLimbs;
         }
-    else if( mSign == -1 ) {
+    }
 
-        // flip our sign and add
-        BigInt *copy = this->copy();
-        copy->mSign = 1;
 
-        BigInt *result = inOtherInt->add( copy );
 
-        delete copy;
+void BigInt::ensureCapacity( int inNumLimbs ) {
+    if( inNumLimbs <= mCapacity ) {
+        return;
+        }
 
-        // flip sign of result
-        result->mSign = -1;
+    uint32_t *newLimbs = new uint32_t[ inNumLimbs ];
 
-        return result;
+    if( mLimbs != NULL ) {
+        memcpy( newLimbs, mLimbs, mNumLimbs * sizeof( uint32_t ) );
+        delete [] mLimbs;
         }
-    else if( isLessThan( inOtherInt ) ) {
-        // trying to subtract a larger number
-        
-        // flip subtraction order, then flip sign of result
 
-        BigInt *result = inOtherInt->subtract( this );
+    mLimbs = newLimbs;
+    mCapacity = inNumLimbs;
+    }
 
-        result->mSign = -( result->mSign );
 
-        return result;
+
+void BigInt::normalize() {
+    while( mNumLimbs > 0 && mLimbs[ mNumLimbs - 1 ] == 0 ) {
+        mNumLimbs--;
         }
-    else {
-        // we're subtracting a smaller positive number from
-        // a larger positive number
+    if( mNumLimbs == 0 ) {
+        mSign = 0;
+        }
+    }
+
 
-        int maxLength = mNumBytes;
-        if( maxLength < inOtherInt->mNumBytes ) {
-            maxLength = inOtherInt->mNumBytes;
-            }
 
-        // result cannot be longer than the larger number
-        unsigned char *result = new unsigned char[ maxLength ];
+void BigInt::setValue( BigInt *inOtherInt ) {
+    if( inOtherInt == this ) {
+        return;
+        }
 
-        // flip to little-endian order to make subtracting easier
-        BigInt *intA = this->flipByteOrder();
-        BigInt *intB = inOtherInt->flipByteOrder();
-        
-        
-        int borrow = 0;
+    ensureCapacity( inOtherInt->mNumLimbs );
 
-        for( int i=0; i<maxLength; i++ ) {
+    if( inOtherInt->mNumLimbs > 0 ) {
+        memcpy( mLimbs, inOtherInt->mLimbs,
+                inOtherInt->mNumLimbs * sizeof( uint32_t ) );
+        }
 
-            int byteA = 0;
-            int byteB = 0;
+    mNumLimbs = inOtherInt->mNumLimbs;
+    mSign = inOtherInt->mSign;
+    }
 
-            if( i < intA->mNumBytes ) {
-                byteA = intA->mBytes[i];
-                }
-            if( i < intB->mNumBytes ) {
-                byteB = intB->mBytes[i];
-                }
-            
-            int diff = byteA - byteB - borrow;
 
-            // compute next borrow
-            borrow = 0;
-            while( diff < 0 ) {
-                borrow++;
 
-                diff += 256;
-                }
-            result[i] = (unsigned char)diff;
+void BigInt::addSignedInPlace( BigInt *inOtherInt, char inNegateOther ) {
+    int otherSign = inOtherInt->mSign;
+    if( inNegateOther ) {
+        otherSign = -otherSign;
+        }
+
+    if( otherSign == 0 ) {
+        return;
+        }
+
+    if( mSign == 0 ) {
+        setValue( inOtherInt );
+        mSign = otherSign;
+        return;
+        }
+
+    int otherNumLimbs = inOtherInt->mNumLimbs;
+
+    if( mSign == otherSign ) {
+        // magnitudes add
+        int maxLength = mNumLimbs;
+        if( maxLength < otherNumLimbs ) {
+            maxLength = otherNumLimbs;
             }
 
-        BigInt *resultInt;
-        
-        if( borrow == 0 ) {
+        // leave room for carry
+        ensureCapacity( maxLength + 1 );
 
-            // skip any trailing 0 bytes
-            int bytesToSkip = 0;
-            int index = maxLength - 1;
-            while( index >= 0 && result[index] == 0 ) {
-                bytesToSkip ++;
-                index--;
-                }
+        for( int i=mNumLimbs; i<maxLength; i++ ) {
+            mLimbs[i] = 0;
+            }
+
+        mLimbs[ maxLength ] = magAdd( mLimbs, mLimbs, maxLength,
+                                      inOtherInt->mLimbs, otherNumLimbs );
+        mNumLimbs = maxLength + 1;
+        }
+    else {
+        // magnitudes subtract, smaller from larger
+        int comparison = magCompare( mLimbs, mNumLimbs,
+                                     inOtherInt->mLimbs, otherNumLimbs );
 
-            // result array will be copied skipping borrow byte
-            // and skipping any trailing 0 bytes
-            resultInt = new BigInt( true, maxLength - bytesToSkip, result );
+        if( comparison == 0 ) {
+            mNumLimbs = 0;
+            }
+        else if( comparison > 0 ) {
+            magSubtract( mLimbs, mLimbs, mNumLimbs,
+                         inOtherInt->mLimbs, otherNumLimbs );
             }
         else {
-            printf( "Error:  final borrow not zero:  %d\n", borrow );
-            resultInt = getZero();
+            ensureCapacity( otherNumLimbs );
+
+            magSubtract( mLimbs, inOtherInt->mLimbs, otherNumLimbs,
+                         mLimbs, mNumLimbs );
+            mNumLimbs = otherNumLimbs;
+            mSign = otherSign;
             }
+        }
 
-        BigInt *flippedResult = resultInt->flipByteOrder();
+    normalize();
+    }
 
-        
-        delete intA;
-        delete intB;
-        delete resultInt;
-        delete [] result;
 
-        
-        return flippedResult;
-        }
+
+void BigInt::addInPlace( BigInt *inOtherInt ) {
+    addSignedInPlace( inOtherInt, false );
     }
 
 
 
-char BigInt::isLessThan( BigInt *inOtherInt ) {
-    if( mSign > inOtherInt->mSign ) {
-        return false;
-        }
-    else if( mSign < inOtherInt->mSign ) {
-        return true;
+void BigInt::subtractInPlace( BigInt *inOtherInt ) {
+    addSignedInPlace( inOtherInt, true );
+    }
+
+
+
+BigInt *BigInt::add( BigInt *inOtherInt ) {
+    BigInt *result = copy();
+    result->addInPlace( inOtherInt );
+    return result;
+    }
+
+
+
+BigInt *BigInt::subtract( BigInt *inOtherInt ) {
+    BigInt *result = copy();
+    result->subtractInPlace( inOtherInt );
+    return result;
+    }
+
+
+
+BigInt *BigInt::multiply( BigInt *inOtherInt ) {
+    BigInt *result = new BigInt();
+
+    if( mSign == 0 || inOtherInt->mSign == 0 ) {
+        return result;
         }
-    else {
-        // signs are equal
 
-        if( mSign == 0 ) {
-            return false;
-            }
-        else if( mSign == -1 && mNumBytes > inOtherInt->mNumBytes ) {
-            return true;
-            }
-        else if( mSign == 1 && mNumBytes > inOtherInt->mNumBytes ) {
-            return false;
-            }
-        else if( mSign == 1 && mNumBytes < inOtherInt->mNumBytes ) {
-            return true;
-            }
-        else if( mSign == -1 && mNumBytes < inOtherInt->mNumBytes ) {
-            return false;
+    int numLimbs = mNumLimbs + inOtherInt->mNumLimbs;
+    result->ensureCapacity( numLimbs );
+
+    magMultiply( result->mLimbs, mLimbs, mNumLimbs,
+                 inOtherInt->mLimbs, inOtherInt->mNumLimbs );
+
+    result->mNumLimbs = numLimbs;
+    result->mSign = mSign * inOtherInt->mSign;
+    result->normalize();
+
+    return result;
+    }
+
+
+
+void BigInt::multiplyInPlace( BigInt *inOtherInt ) {
+    BigInt *product = multiply( inOtherInt );
+
+    // take the product's storage
+    uint32_t *oldLimbs = mLimbs;
+
+    mLimbs = product->mLimbs;
+    mNumLimbs = product->mNumLimbs;
+    mCapacity = product->mCapacity;
+    mSign = product->mSign;
+
+    product->mLimbs = oldLimbs;
+    delete product;
+    }
+
+
+
+BigInt *BigInt::divide( BigInt *inOtherInt, BigInt **outRemainder ) {
+    BigInt *quotient = new BigInt();
+
+    if( inOtherInt->mSign == 0 ) {
+        printf( "Error:  BigInt division by zero\n" );
+
+        if( outRemainder != NULL ) {
+            *outRemainder = getZero();
             }
-        else if( isEqualTo( inOtherInt ) ) {
-            return false;
+        return quotient;
+        }
+
+    if( magCompare( mLimbs, mNumLimbs,
+                    inOtherInt->mLimbs, inOtherInt->mNumLimbs ) < 0 ) {
+        // quotient is zero
+        if( outRemainder != NULL ) {
+            *outRemainder = copy();
             }
-        else {
-            // numbers are the same length but are not equal
-
-            // start with high-order bytes
-            for( int i=0; i<mNumBytes; i++ ) {
-                if( mBytes[i] > inOtherInt->mBytes[i] ) {
-                    if( mSign == 1 ) {
-                        return false;
-                        }
-                    else {
-                        return true;
-                        }
-                    }
-                else if ( mBytes[i] < inOtherInt->mBytes[i] ) {
-                    if( mSign == 1 ) {
-                        return true;
-                        }
-                    else {
-                        return false;
-                        }
-                    }                
-                }
+        return quotient;
+        }
 
-            // if we made it here, the numbers are equal...
-            // but we tested for equality above:  must be an error
-            printf( "Error:  equality test in isLessThan failed\n" );
+    int numQuotientLimbs = mNumLimbs - inOtherInt->mNumLimbs + 1;
+    quotient->ensureCapacity( numQuotientLimbs );
 
-            return false;
-            }
-        
+    BigInt *remainder = NULL;
+    uint32_t *remainderLimbs = NULL;
+
+    if( outRemainder != NULL ) {
+        remainder = new BigInt();
+        remainder->ensureCapacity( inOtherInt->mNumLimbs );
+        remainderLimbs = remainder->mLimbs;
+        }
+
+    magDivide( quotient->mLimbs, remainderLimbs, mLimbs, mNumLimbs,
+               inOtherInt->mLimbs, inOtherInt->mNumLimbs );
+
+    quotient->mNumLimbs = numQuotientLimbs;
+    quotient->mSign = mSign * inOtherInt->mSign;
+    quotient->normalize();
+
+    if( remainder != NULL ) {
+        remainder->mNumLimbs = inOtherInt->mNumLimbs;
+        remainder->mSign = mSign;
+        remainder->normalize();
+
+        *outRemainder = remainder;
         }
+
+    return quotient;
     }
 
 
 
-char BigInt::isEqualTo( BigInt *inOtherInt ) {
+BigInt *BigInt::mod( BigInt *inModulus ) {
+    BigInt *remainder;
 
-    if( mSign != inOtherInt->mSign ) {
-        return false;
+    BigInt *quotient = divide( inModulus, &remainder );
+    delete quotient;
+
+    if( remainder->mSign < 0 ) {
+        remainder->addInPlace( inModulus );
+        }
+
+    return remainder;
+    }
+
+
+
+BigInt *BigInt::modPow( BigInt *inExponent, BigInt *inModulus ) {
+    if( inModulus->mSign <= 0 || inExponent->mSign < 0 ) {
+        printf( "Error:  BigInt modPow needs a positive modulus and "
+                "a non-negative exponent\n" );
+        return getZero();
         }
-    else if( mNumBytes != inOtherInt->mNumBytes ) {
-        return false;
+
+    BigInt *one = new BigInt( 1 );
+
+    if( inModulus->isEqualTo( one ) ) {
+        delete one;
+        return getZero();
         }
-    else {
-        // same length, same sign
-        
-        for( int i=0; i<mNumBytes; i++ ) {
-            if( mBytes[i] != inOtherInt->mBytes[i] ) {
-                // mismatch found
-                return false;
+
+    BigInt *base = mod( inModulus );
+
+    int numExponentBits = inExponent->getNumBits();
+
+    int i;
+
+
+    if( ( inModulus->mLimbs[0] & 1 ) == 0 ) {
+        // even modulus, multiply and divide by the modulus each step
+        BigInt *result = one;
+        BigInt *remainder;
+        BigInt *quotient;
+
+        for( i=numExponentBits-1; i>=0; i-- ) {
+            result->multiplyInPlace( result );
+            quotient = result->divide( inModulus, &remainder );
+            delete quotient;
+            delete result;
+            result = remainder;
+
+            if( ( inExponent->mLimbs[ i / 32 ] >> ( i % 32 ) ) & 1 ) {
+                result->multiplyInPlace( base );
+                quotient = result->divide( inModulus, &remainder );
+                delete quotient;
+                delete result;
+                result = remainder;
+                }
+            }
+
+        delete base;
+        return result;
+        }
+
+
+    // odd modulus, in Montgomery form
+    uint32_t *m = inModulus->mLimbs;
+    int n = inModulus->mNumLimbs;
+
+    // -1/m mod 2^32 by Newton's method, each step doubling correct bits
+    uint32_t inverse = 1;
+    for( i=0; i<5; i++ ) {
+        inverse *= 2 - m[0] * inverse;
+        }
+    uint32_t mInverse = 0 - inverse;
+
+    // base^2n mod m, for converting into Montgomery form
+    BigInt *r2 = new BigInt();
+    r2->ensureCapacity( 2 * n + 1 );
+    memset( r2->mLimbs, 0, ( 2 * n + 1 ) * sizeof( uint32_t ) );
+    r2->mLimbs[ 2 * n ] = 1;
+    r2->mNumLimbs = 2 * n + 1;
+    r2->mSign = 1;
+
+    BigInt *r2ModM = r2->mod( inModulus );
+    delete r2;
+
+    // all values padded to n limbs
+    int tableSize = 1 << MOD_POW_WINDOW_BITS;
+
+    uint32_t *block = new uint32_t[ n * ( tableSize + 4 ) + n + 2 ];
+    uint32_t *table = block;
+    uint32_t *result = &( block[ n * tableSize ] );
+    uint32_t *paddedR2 = &( block[ n * ( tableSize + 1 ) ] );
+    uint32_t *paddedBase = &( block[ n * ( tableSize + 2 ) ] );
+    uint32_t *paddedOne = &( block[ n * ( tableSize + 3 ) ] );
+    uint32_t *scratch = &( block[ n * ( tableSize + 4 ) ] );
+
+    memset( paddedR2, 0, 3 * n * sizeof( uint32_t ) );
+    memcpy( paddedR2, r2ModM->mLimbs, r2ModM->mNumLimbs * sizeof( uint32_t ) );
+    memcpy( paddedBase, base->mLimbs, base->mNumLimbs * sizeof( uint32_t ) );
+    paddedOne[0] = 1;
+
+    delete r2ModM;
+    delete base;
+    delete one;
+
+    // table[k] = base^k in Montgomery form
+    montgomeryMultiply( &( table[0] ), paddedOne, paddedR2, m, n, mInverse,
+                        scratch );
+    montgomeryMultiply( &( table[n] ), paddedBase, paddedR2, m, n, mInverse,
+                        scratch );
+    for( i=2; i<tableSize; i++ ) {
+        montgomeryMultiply( &( table[ i * n ] ), &( table[ ( i - 1 ) * n ] ),
+                            &( table[n] ), m, n, mInverse, scratch );
+        }
+
+    memcpy( result, table, n * sizeof( uint32_t ) );
+
+
+    // fixed windows, from the top
+    int numWindows =
+        ( numExponentBits + MOD_POW_WINDOW_BITS - 1 ) / MOD_POW_WINDOW_BITS;
+
+    for( int w=numWindows-1; w>=0; w-- ) {
+        int window = 0;
+
+        for( int b=MOD_POW_WINDOW_BITS-1; b>=0; b-- ) {
+            int bit = w * MOD_POW_WINDOW_BITS + b;
+
+            montgomeryMultiply( result, result, result, m, n, mInverse,
+                                scratch );
+
+            window <<= 1;
+            if( bit < numExponentBits ) {
+                window |= ( inExponent->mLimbs[ bit / 32 ] >> ( bit % 32 ) )
+                    & 1;
                 }
-            
             }
 
-        // no mismatch found
-        return true;
+        if( window != 0 ) {
+            montgomeryMultiply( result, result, &( table[ window * n ] ),
+                                m, n, mInverse, scratch );
+            }
         }
 
+    // out of Montgomery form
+    montgomeryMultiply( result, result, paddedOne, m, n, mInverse, scratch );
+
+
+    BigInt *resultInt = new BigInt();
+    resultInt->ensureCapacity( n );
+    memcpy( resultInt->mLimbs, result, n * sizeof( uint32_t ) );
+    resultInt->mNumLimbs = n;
+    resultInt->mSign = 1;
+    resultInt->normalize();
+
+    delete [] block;
+
+    return resultInt;
+    }
+
+
+
+char BigInt::isLessThan( BigInt *inOtherInt ) {
+    if( mSign != inOtherInt->mSign ) {
+        return mSign < inOtherInt->mSign;
+        }
+
+    int comparison = magCompare( mLimbs, mNumLimbs,
+                                 inOtherInt->mLimbs, inOtherInt->mNumLimbs );
+
+    // larger magnitude is smaller when negative
+    return mSign * comparison < 0;
+    }
+
+
+
+char BigInt::isEqualTo( BigInt *inOtherInt ) {
+    return mSign == inOtherInt->mSign &&
+        magCompare( mLimbs, mNumLimbs,
+                    inOtherInt->mLimbs, inOtherInt->mNumLimbs ) == 0;
     }
 
 
 
 BigInt *BigInt::copy() {
-    return new BigInt( mSign, mNumBytes, mBytes );
+    BigInt *result = new BigInt();
+    result->setValue( this );
+    return result;
     }
 
 
 
 BigInt *BigInt::getZero() {
-    unsigned char bytes[0];
-    
-    return new BigInt( 0, 0, bytes );
+    return new BigInt();
+    }
+
+
+
+int BigInt::getNumBits() {
+    if( mNumLimbs == 0 ) {
+        return 0;
+        }
+    return 32 * mNumLimbs - countLeadingZeros( mLimbs[ mNumLimbs - 1 ] );
+    }
+
+
+
+unsigned char *BigInt::getBytes( int *outNumBytes ) {
+    int numBytes = ( getNumBits() + 7 ) / 8;
+
+    unsigned char *bytes = new unsigned char[ numBytes ];
+
+    for( int i=0; i<numBytes; i++ ) {
+        int bytePosition = numBytes - 1 - i;
+
+        bytes[i] = (unsigned char)(
+            mLimbs[ bytePosition / 4 ] >> ( 8 * ( bytePosition % 4 ) ) );
+        }
+
+    *outNumBytes = numBytes;
+    return bytes;
     }
 
 
@@ -461,7 +907,7 @@ char *BigInt::convertToDecimalString() {
 
     char *tempString = new char[4];
 
-    
+
     char *resultString = new char[ mNumBytes * 3 + 1 ];
 
     int stringIndex = 0;
@@ -471,27 +917,27 @@ char *BigInt::convertToDecimalString() {
         unsigned char currentByte = mBytes[i];
 
         // pad with zeros
-        
+
         char *firstZero = "";
-        char *secondZero = "";            
-        
+        char *secondZero = "";
+
         if( currentByte < 100 ) {
             firstZero = "0";
-            
+
             if( currentByte < 10 ) {
                 secondZero = "0";
                 }
             }
-        
+
         sprintf( tempString, "%s%s%d", firstZero, secondZero, currentByte );
 
-        memcpy( &( resultString[ stringIndex ] ), tempString, 3 );        
+        memcpy( &( resultString[ stringIndex ] ), tempString, 3 );
 
         stringIndex += 3;
         }
 
     resultString[ mNumBytes * 3 ] = '\0';
-    
+
     delete [] tempString;
 
     return resultString;
@@ -505,17 +951,20 @@ char *BigInt::convertToHexString() {
         return stringDuplicate( "0" );
         }
     else {
-        char *resultHexString = new char[ mNumBytes * 2 + 1 + 1 ];
+        int numBytes;
+        unsigned char *bytes = getBytes( &numBytes );
+
+        char *resultHexString = new char[ numBytes * 2 + 1 + 1 ];
         int hexStringIndex = 0;
 
         if( mSign == -1 ) {
             resultHexString[0] = '-';
             hexStringIndex++;
             }
-    
-        for( int i=0; i<mNumBytes; i++ ) {
 
-            unsigned char currentByte = mBytes[ i ];
+        for( int i=0; i<numBytes; i++ ) {
+
+            unsigned char currentByte = bytes[ i ];
 
             int highBits = 0xF & ( currentByte >> 4 );
             int lowBits = 0xF & ( currentByte );
@@ -528,47 +977,21 @@ char *BigInt::convertToHexString() {
             }
 
         resultHexString[ hexStringIndex ] = '\0';
-    
-        return resultHexString;
-        }
-    }
-
-
-
-int BigInt::convertToInt() {
-
-    int result = 0;
 
-    int baseFactor = 1;
-    
-    for( int i=mNumBytes-1; i>=mNumBytes-4; i-- ) {
+        delete [] bytes;
 
-        if( i >=0 ) {
-            result += mBytes[i] * baseFactor;            
-            }
-        
-        baseFactor *= 256;        
+        return resultHexString;
         }
-
-    return mSign * result;    
     }
 
 
 
-BigInt *BigInt::flipByteOrder() {
-    BigInt *returnInt = copy();
-
-    unsigned char *newBytes = returnInt->mBytes;
-
-    int newIndex = mNumBytes - 1;
-    
-    for( int i=0; i<mNumBytes; i++ ) {
-        newBytes[ newIndex ] = mBytes[ i ];
-
-        newIndex--;
+int BigInt::convertToInt() {
+    if( mNumLimbs == 0 ) {
+        return 0;
         }
 
-    return returnInt;
+    return mSign * (int)( mLimbs[0] );
     }
 
 
@@ -607,4 +1030,3 @@ char BigInt::fourBitIntToHex( int inInt ) {
 
     return outChar[0];
     }
-
@@ -4,6 +4,11 @@
  * 2002-May-25    Jason Rohrer
  * Created.
  * Made getZero static.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Changed to store the magnitude in 32-bit limbs.  Added in-place
+ * operations, Karatsuba multiplication, division, and modular
+ * exponentiation.
  */
 
 
@@ -12,6 +17,10 @@
 #define BIG_INT_INCLUDED
 
 
+#include <stdint.h>
+#include <stddef.h>
+
+
 
 /**
  * A multi-byte integer representation.
@@ -24,24 +33,24 @@
 class BigInt {
 
 
-        
+
     public:
 
 
-        
+
         /**
          * Constructs an integer.
          *
          * @param inSign the sign of this integer:
          *   -1 if negative, +1 if positive, and 0 if zero.
          * @param inNumBytes the number of bytes in this integer.
-         * @param inBytes the bytes for this integer.
+         * @param inBytes the bytes for this integer, in big endian order.
          *   Copied internally, so must be destroyed by caller.
          */
         BigInt( int inSign, int inNumBytes, unsigned char *inBytes );
 
 
-        
+
         /**
          * Constructs an integer from a 32-bit int.
          *
@@ -52,8 +61,8 @@ class BigInt {
 
 
         ~BigInt();
-        
-        
+
+
 
         /**
          * Adds an integer to this integer.
@@ -66,7 +75,7 @@ class BigInt {
          */
         BigInt *add( BigInt *inOtherInt );
 
-        
+
 
         /**
          * Subtracts an integer from this integer.
@@ -81,6 +90,110 @@ class BigInt {
 
 
 
+        /**
+         * Multiplies this integer by another integer.
+         *
+         * Uses Karatsuba multiplication for large integers.
+         *
+         * @praram inOtherInt the int to multiply by.
+         *   Must be destroyed by caller.
+         *
+         * @return a newly allocated integer containing the product.
+         *   Must be destroyed by caller.
+         */
+        BigInt *multiply( BigInt *inOtherInt );
+
+
+
+        /**
+         * Divides this integer by another integer, rounding toward zero.
+         *
+         * @praram inOtherInt the int to divide by.  Must not be zero.
+         *   Must be destroyed by caller.
+         * @param outRemainder pointer to where the remainder, with the
+         *   sign of this integer, should be returned, or NULL to
+         *   discard it.  Must be destroyed by caller.
+         *
+         * @return a newly allocated integer containing the quotient,
+         *   or zero if inOtherInt is zero.
+         *   Must be destroyed by caller.
+         */
+        BigInt *divide( BigInt *inOtherInt, BigInt **outRemainder = NULL );
+
+
+
+        /**
+         * Gets this integer modulo a positive integer.
+         *
+         * @praram inModulus the modulus.  Must be positive.
+         *   Must be destroyed by caller.
+         *
+         * @return a newly allocated integer in [0, inModulus).
+         *   Must be destroyed by caller.
+         */
+        BigInt *mod( BigInt *inModulus );
+
+
+
+        /**
+         * Raises this integer to a power modulo a positive integer.
+         *
+         * Odd moduli (as in key math) use Montgomery multiplication.
+         *
+         * @praram inExponent the exponent.  Must not be negative.
+         *   Must be destroyed by caller.
+         * @praram inModulus the modulus.  Must be positive.
+         *   Must be destroyed by caller.
+         *
+         * @return a newly allocated integer in [0, inModulus), or zero
+         *   if the exponent or modulus is out of range.
+         *   Must be destroyed by caller.
+         */
+        BigInt *modPow( BigInt *inExponent, BigInt *inModulus );
+
+
+
+        /**
+         * Adds an integer to this integer in place.
+         *
+         * @praram inOtherInt the int to add.  Can be this integer.
+         *   Must be destroyed by caller.
+         */
+        void addInPlace( BigInt *inOtherInt );
+
+
+
+        /**
+         * Subtracts an integer from this integer in place.
+         *
+         * @praram inOtherInt the int to subtract.  Can be this integer.
+         *   Must be destroyed by caller.
+         */
+        void subtractInPlace( BigInt *inOtherInt );
+
+
+
+        /**
+         * Multiplies this integer by another integer in place.
+         *
+         * @praram inOtherInt the int to multiply by.  Can be this integer.
+         *   Must be destroyed by caller.
+         */
+        void multiplyInPlace( BigInt *inOtherInt );
+
+
+
+        /**
+         * Sets this integer to the value of another integer, reusing
+         * this integer's storage when it is large enough.
+         *
+         * @praram inOtherInt the int to copy.
+         *   Must be destroyed by caller.
+         */
+        void setValue( BigInt *inOtherInt );
+
+
+
         /**
          * Gets whether this integer is less than another integer.
          *
@@ -88,7 +201,7 @@ class BigInt {
          *   Must be destroyed by caller.
          *
          * @return true if this integer is less than the other.
-         */        
+         */
         char isLessThan( BigInt *inOtherInt );
 
 
@@ -125,6 +238,29 @@ class BigInt {
 
 
 
+        /**
+         * Gets the magnitude of this integer as bytes.
+         *
+         * @param outNumBytes pointer to where the number of bytes
+         *   should be returned.  0 for zero.
+         *
+         * @return the bytes in big endian order, with no leading zero
+         *   bytes.  Must be destroyed by caller.
+         */
+        unsigned char *getBytes( int *outNumBytes );
+
+
+
+        /**
+         * Gets the number of bits in the magnitude of this integer.
+         *
+         * @return the position of the highest set bit plus one, or 0
+         *   for zero.
+         */
+        int getNumBits();
+
+
+
         /**
          * Converts this integer to a decimal string.
          *
@@ -133,7 +269,7 @@ class BigInt {
          */
         //char *convertToDecimalString();
 
-        
+
 
         /**
          * Converts this integer to a hex string.
@@ -152,34 +288,46 @@ class BigInt {
          * bits will be discarded, though the sign will be preserved.
          */
         int convertToInt();
-        
-        
-        
+
+
+
         /**
          * -1 if negative, +1 if positive, and 0 if zero.
          */
         int mSign;
-        
-        int mNumBytes;
+
+        int mNumLimbs;
 
         /**
-         * Integer is stored in big endian byte order.
+         * Magnitude, stored as 32-bit limbs with the lowest first.
+         * Never has high zero limbs, so zero has no limbs.
          */
-        unsigned char *mBytes;
+        uint32_t *mLimbs;
+
 
 
-        
     protected:
 
 
-        
-        /**
-         * Flips the byte order of this integer.
-         *
-         * @return a newly allocated integer containing the flipped version.
-         *   Must be destroyed by caller.
-         */ 
-        BigInt *flipByteOrder();
+
+        // allocated limbs, at least mNumLimbs
+        int mCapacity;
+
+
+        // constructs a zero with no limbs allocated
+        BigInt();
+
+
+        // makes room for at least inNumLimbs limbs, keeping the value
+        void ensureCapacity( int inNumLimbs );
+
+
+        // drops high zero limbs and fixes the sign for zero
+        void normalize();
+
+
+        // adds (or subtracts, if inNegateOther) another integer in place
+        void addSignedInPlace( BigInt *inOtherInt, char inNegateOther );
 
 
 
@@ -193,11 +341,10 @@ class BigInt {
          */
         char fourBitIntToHex( int inInt );
 
-        
-        
+
+
     };
 
 
 
 #endif
-
@@ -0,0 +1,600 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+
+
+#ifndef COMPILED_EXPRESSION_INCLUDED
+#define COMPILED_EXPRESSION_INCLUDED
+
+#include <math.h>
+#include <stdio.h>
+
+#include "Expression.h"
+#include "Variable.h"
+#include "VariableExpression.h"
+#include "ConstantExpression.h"
+#include "FixedConstantExpression.h"
+#include "InvertExpression.h"
+#include "NegateExpression.h"
+#include "PowerExpression.h"
+#include "ProductExpression.h"
+#include "SumExpression.h"
+#include "SinExpression.h"
+#include "CosExpression.h"
+#include "TanExpression.h"
+#include "LnExpression.h"
+#include "SqrtExpression.h"
+#include "ComparisonExpression.h"
+#include "BinaryLogicExpression.h"
+#include "MultiConstantArgumentExpression.h"
+
+#include "minorGems/util/SimpleVector.h"
+
+
+
+// points evaluated together by each instruction
+#define COMPILED_EXPRESSION_BLOCK 256
+
+
+
+enum CompiledExpressionOp {
+    compiledConstant,
+    // a variable bound to an array of values
+    compiledBoundVariable,
+    // any other variable, read through getValue() for each point
+    compiledUnboundVariable,
+    compiledNegate,
+    compiledInvert,
+    compiledSin,
+    compiledCos,
+    compiledTan,
+    compiledLn,
+    compiledSqrt,
+    compiledSum,
+    compiledProduct,
+    compiledPower,
+    compiledGreaterThan,
+    compiledLessThan,
+    compiledGreaterThanOrEqualTo,
+    compiledLessThanOrEqualTo,
+    compiledEqualTo,
+    compiledNotEqualTo,
+    compiledAnd,
+    compiledOr,
+    compiledXor,
+    // an expression type we don't know, evaluated with evaluate()
+    // after setting the bound variables for each point
+    compiledTree
+    };
+
+
+
+typedef struct CompiledExpressionInstruction {
+        CompiledExpressionOp op;
+
+        // registers
+        int dest;
+        int argA;
+        int argB;
+
+        // for compiledConstant
+        double constant;
+
+        // bound variable index for compiledBoundVariable
+        int variableIndex;
+
+        // for compiledUnboundVariable
+        Variable *variable;
+
+        // for compiledTree
+        Expression *tree;
+    } CompiledExpressionInstruction;
+
+
+
+/**
+ * An expression flattened into register bytecode, for evaluating the
+ * same expression at many points.
+ *
+ * Each instruction runs over a block of points at once, so there is
+ * one dispatch per node per block instead of a virtual evaluate() per
+ * node per point.  Results match evaluate() exactly, since each node
+ * does the same double operation in the same order.
+ *
+ * The expression is read when compiled.  Recompile after changing
+ * it (for example, after mutating a constant).
+ *
+ * @author Jason Rohrer
+ */
+class CompiledExpression {
+
+    public:
+
+
+
+        /**
+         * Compiles an expression.
+         *
+         * @param inExpression the expression to compile.
+         *   Must be destroyed by caller after this class is destroyed
+         *   (unknown expression types are still evaluated through it).
+         * @param inNumVariables the number of bound variables.
+         * @param inVariables the variables whose values will be passed
+         *   to evaluate().  Other variables in the expression are read
+         *   with getValue().  Array and variables must be destroyed
+         *   by caller after this class is destroyed.
+         */
+        CompiledExpression( Expression *inExpression,
+                            int inNumVariables, Variable **inVariables );
+
+        ~CompiledExpression();
+
+
+
+        /**
+         * Evaluates the expression at many points.
+         *
+         * @param inVariableValues values for each bound variable, indexed
+         *   as inVariableValues[variable][point].  Must be destroyed
+         *   by caller.
+         * @param inNumPoints the number of points.
+         * @param outResults array where the result for each point
+         *   should be returned.  Must be destroyed by caller.
+         */
+        void evaluate( double **inVariableValues, int inNumPoints,
+                       double *outResults );
+
+
+
+        /**
+         * Gets the number of instructions in the compiled expression.
+         *
+         * @return the number of instructions.
+         */
+        int getNumInstructions();
+
+
+
+    protected:
+
+        int mNumVariables;
+        Variable **mVariables;
+
+        SimpleVector<CompiledExpressionInstruction> mInstructions;
+
+        int mNumRegisters;
+
+        // mNumRegisters blocks of COMPILED_EXPRESSION_BLOCK
+        double *mRegisters;
+
+        // true if a compiledTree instruction needs bound variables set
+        char mSetsVariables;
+
+
+
+        // compiles inExpression so that its value ends up in
+        // register inDest, using only registers at or above inDest
+        void compile( Expression *inExpression, int inDest );
+
+
+        // true if inExpression depends on no variables or unknown
+        // expression types, so it can be evaluated once while compiling
+        char isConstant( Expression *inExpression );
+
+
+        // gets the op for a known expression, or compiledTree
+        CompiledExpressionOp getOp( Expression *inExpression );
+
+
+        void addInstruction( CompiledExpressionOp inOp, int inDest,
+                             int inArgA, int inArgB );
+
+    };
+
+
+
+inline CompiledExpression::CompiledExpression( Expression *inExpression,
+                                               int inNumVariables,
+                                               Variable **inVariables )
+    : mNumVariables( inNumVariables ), mVariables( inVariables ),
+      mNumRegisters( 1 ), mSetsVariables( false ) {
+
+    compile( inExpression, 0 );
+
+    mRegisters = new double[ mNumRegisters * COMPILED_EXPRESSION_BLOCK ];
+    }
+
+
+
+inline CompiledExpression::~CompiledExpression() {
+    delete [] mRegisters;
+    }
+
+
+
+inline int CompiledExpression::getNumInstructions() {
+    return mInstructions.size();
+    }
+
+
+
+inline CompiledExpressionOp CompiledExpression::getOp(
+    Expression *inExpression ) {
+
+    long id = inExpression->getID();
+
+    // note that we can't use switch/case here because
+    // staticGetID doesn't return a constant
+    if( id == ConstantExpression::staticGetID() ||
+        id == FixedConstantExpression::staticGetID() ) {
+        return compiledConstant;
+        }
+    else if( id == VariableExpression::staticGetID() ) {
+        return compiledUnboundVariable;
+        }
+    else if( id == NegateExpression::staticGetID() ) {
+        return compiledNegate;
+        }
+    else if( id == InvertExpression::staticGetID() ) {
+        return compiledInvert;
+        }
+    else if( id == SinExpression::staticGetID() ) {
+        return compiledSin;
+        }
+    else if( id == CosExpression::staticGetID() ) {
+        return compiledCos;
+        }
+    else if( id == TanExpression::staticGetID() ) {
+        return compiledTan;
+        }
+    else if( id == LnExpression::staticGetID() ) {
+        return compiledLn;
+        }
+    else if( id == SqrtExpression::staticGetID() ) {
+        return compiledSqrt;
+        }
+    else if( id == SumExpression::staticGetID() ) {
+        return compiledSum;
+        }
+    else if( id == ProductExpression::staticGetID() ) {
+        return compiledProduct;
+        }
+    else if( id == PowerExpression::staticGetID() ) {
+        return compiledPower;
+        }
+    else if( id == ComparisonExpression::staticGetID() ) {
+        ComparisonExpression *c = (ComparisonExpression *)inExpression;
+
+        switch( c->getComparison() ) {
+            case ComparisonExpression::GREATER_THAN:
+                return compiledGreaterThan;
+            case ComparisonExpression::LESS_THAN:
+                return compiledLessThan;
+            case ComparisonExpression::GREATER_THAN_OR_EQUAL_TO:
+                return compiledGreaterThanOrEqualTo;
+            case ComparisonExpression::LESS_THAN_OR_EQUAL_TO:
+                return compiledLessThanOrEqualTo;
+            case ComparisonExpression::EQUAL_TO:
+                return compiledEqualTo;
+            case ComparisonExpression::NOT_EQUAL_TO:
+                return compiledNotEqualTo;
+            }
+        }
+    else if( id == BinaryLogicExpression::staticGetID() ) {
+        BinaryLogicExpression *b = (BinaryLogicExpression *)inExpression;
+
+        switch( b->getLogicOperation() ) {
+            case BinaryLogicExpression::LOGIC_AND:
+                return compiledAnd;
+            case BinaryLogicExpression::LOGIC_OR:
+                return compiledOr;
+            case BinaryLogicExpression::LOGIC_XOR:
+                return compiledXor;
+            }
+        }
+
+    return compiledTree;
+    }
+
+
+
+inline char CompiledExpression::isConstant( Expression *inExpression ) {
+    CompiledExpressionOp op = getOp( inExpression );
+
+    if( op == compiledConstant ) {
+        return true;
+        }
+    if( op == compiledUnboundVariable || op == compiledTree ) {
+        return false;
+        }
+
+    int numArgs = inExpression->getNumArguments();
+    for( int i=0; i<numArgs; i++ ) {
+        if( ! isConstant( inExpression->getArgument( i ) ) ) {
+            return false;
+            }
+        }
+    return true;
+    }
+
+
+
+inline void CompiledExpression::addInstruction( CompiledExpressionOp inOp,
+                                                int inDest,
+                                                int inArgA, int inArgB ) {
+    CompiledExpressionInstruction i;
+    i.op = inOp;
+    i.dest = inDest;
+    i.argA = inArgA;
+    i.argB = inArgB;
+    i.constant = 0;
+    i.variableIndex = -1;
+    i.variable = NULL;
+    i.tree = NULL;
+
+    mInstructions.push_back( i );
+    }
+
+
+
+inline void CompiledExpression::compile( Expression *inExpression,
+                                         int inDest ) {
+
+    if( inDest + 1 > mNumRegisters ) {
+        mNumRegisters = inDest + 1;
+        }
+
+
+    if( inExpression->getID() ==
+        MultiConstantArgumentExpression::staticGetID() ) {
+
+        MultiConstantArgumentExpression *m =
+            (MultiConstantArgumentExpression *)inExpression;
+
+        compile( m->getWrappedExpression(), inDest );
+        return;
+        }
+
+
+    CompiledExpressionOp op = getOp( inExpression );
+
+    if( op != compiledTree && isConstant( inExpression ) ) {
+        // the same operations evaluate() would do at every point,
+        // done once
+        addInstruction( compiledConstant, inDest, -1, -1 );
+        mInstructions.getElement( mInstructions.size() - 1 )->constant =
+            inExpression->evaluate();
+        return;
+        }
+
+
+    if( op == compiledUnboundVariable ) {
+        Variable *v = ( (VariableExpression *)inExpression )->getVariable();
+
+        addInstruction( compiledUnboundVariable, inDest, -1, -1 );
+        CompiledExpressionInstruction *i =
+            mInstructions.getElement( mInstructions.size() - 1 );
+        i->variable = v;
+
+        for( int b=0; b<mNumVariables; b++ ) {
+            if( mVariables[b] == v ) {
+                i->op = compiledBoundVariable;
+                i->variableIndex = b;
+                break;
+                }
+            }
+        return;
+        }
+
+    if( op == compiledTree ) {
+        addInstruction( compiledTree, inDest, -1, -1 );
+        mInstructions.getElement( mInstructions.size() - 1 )->tree =
+            inExpression;
+
+        if( mNumVariables > 0 ) {
+            mSetsVariables = true;
+            }
+        return;
+        }
+
+
+    // arguments in order, as evaluate() reads them
+    int numArgs = inExpression->getNumArguments();
+
+    if( numArgs == 1 ) {
+        compile( inExpression->getArgument( 0 ), inDest );
+
+        addInstruction( op, inDest, inDest, -1 );
+        }
+    else {
+        compile( inExpression->getArgument( 0 ), inDest );
+        compile( inExpression->getArgument( 1 ), inDest + 1 );
+
+        addInstruction( op, inDest, inDest, inDest + 1 );
+        }
+    }
+
+
+
+inline void CompiledExpression::evaluate( double **inVariableValues,
+                                          int inNumPoints,
+                                          double *outResults ) {
+
+    int numInstructions = mInstructions.size();
+    CompiledExpressionInstruction *instructions =
+        mInstructions.getElementArray();
+
+
+    for( int start=0; start<inNumPoints;
+         start += COMPILED_EXPRESSION_BLOCK ) {
+
+        int n = inNumPoints - start;
+        if( n > COMPILED_EXPRESSION_BLOCK ) {
+            n = COMPILED_EXPRESSION_BLOCK;
+            }
+
+        for( int s=0; s<numInstructions; s++ ) {
+            CompiledExpressionInstruction *inst = &( instructions[s] );
+
+            double *d = &( mRegisters[ inst->dest *
+                                       COMPILED_EXPRESSION_BLOCK ] );
+            double *a = NULL;
+            double *b = NULL;
+
+            if( inst->argA >= 0 ) {
+                a = &( mRegisters[ inst->argA *
+                                   COMPILED_EXPRESSION_BLOCK ] );
+                }
+            if( inst->argB >= 0 ) {
+                b = &( mRegisters[ inst->argB *
+                                   COMPILED_EXPRESSION_BLOCK ] );
+                }
+
+            int p;
+
+            switch( inst->op ) {
+                case compiledConstant: {
+                    double c = inst->constant;
+                    for( p=0; p<n; p++ ) {
+                        d[p] = c;
+                        }
+                    }
+                    break;
+                case compiledBoundVariable: {
+                    double *values =
+                        &( inVariableValues[ inst->variableIndex ][ start ] );
+                    for( p=0; p<n; p++ ) {
+                        d[p] = values[p];
+                        }
+                    }
+                    break;
+                case compiledUnboundVariable:
+                    for( p=0; p<n; p++ ) {
+                        d[p] = inst->variable->getValue();
+                        }
+                    break;
+                case compiledNegate:
+                    for( p=0; p<n; p++ ) {
+                        d[p] = -( a[p] );
+                        }
+                    break;
+                case compiledInvert:
+                    for( p=0; p<n; p++ ) {
+                        d[p] = 1 / ( a[p] );
+                        }
+                    break;
+                case compiledSin:
+                    for( p=0; p<n; p++ ) {
+                        d[p] = sin( a[p] );
+                        }
+                    break;
+                case compiledCos:
+                    for( p=0; p<n; p++ ) {
+                        d[p] = cos( a[p] );
+                        }
+                    break;
+                case compiledTan:
+                    for( p=0; p<n; p++ ) {
+                        d[p] = tan( a[p] );
+                        }
+                    break;
+                case compiledLn:
+                    for( p=0; p<n; p++ ) {
+                        d[p] = log( a[p] );
+                        }
+                    break;
+                case compiledSqrt:
+                    for( p=0; p<n; p++ ) {
+                        d[p] = sqrt( a[p] );
+                        }
+                    break;
+                case compiledSum:
+                    for( p=0; p<n; p++ ) {
+                        d[p] = a[p] + b[p];
+                        }
+                    break;
+                case compiledProduct:
+                    for( p=0; p<n; p++ ) {
+                        d[p] = a[p] * b[p];
+                        }
+                    break;
+                case compiledPower:
+                    for( p=0; p<n; p++ ) {
+                        d[p] = pow( a[p], b[p] );
+                        }
+                    break;
+                case compiledGreaterThan:
+                    for( p=0; p<n; p++ ) {
+                        d[p] = ( a[p] > b[p] ) ? 1 : 0;
+                        }
+                    break;
+                case compiledLessThan:
+                    for( p=0; p<n; p++ ) {
+                        d[p] = ( a[p] < b[p] ) ? 1 : 0;
+                        }
+                    break;
+                case compiledGreaterThanOrEqualTo:
+                    for( p=0; p<n; p++ ) {
+                        d[p] = ( a[p] >= b[p] ) ? 1 : 0;
+                        }
+                    break;
+                case compiledLessThanOrEqualTo:
+                    for( p=0; p<n; p++ ) {
+                        d[p] = ( a[p] <= b[p] ) ? 1 : 0;
+                        }
+                    break;
+                case compiledEqualTo:
+                    for( p=0; p<n; p++ ) {
+                        d[p] = ( a[p] == b[p] ) ? 1 : 0;
+                        }
+                    break;
+                case compiledNotEqualTo:
+                    for( p=0; p<n; p++ ) {
+                        d[p] = ( a[p] != b[p] ) ? 1 : 0;
+                        }
+                    break;
+                case compiledAnd:
+                    for( p=0; p<n; p++ ) {
+                        d[p] = ( a[p] > 0 && b[p] > 0 ) ? 1 : 0;
+                        }
+                    break;
+                case compiledOr:
+                    for( p=0; p<n; p++ ) {
+                        d[p] = ( a[p] > 0 || b[p] > 0 ) ? 1 : 0;
+                        }
+                    break;
+                case compiledXor:
+                    for( p=0; p<n; p++ ) {
+                        // as in BinaryLogicExpression, so NaN matches too
+                        d[p] = ( ( a[p] > 0 && b[p] <= 0 ) ||
+                                 ( a[p] <= 0 && b[p] > 0 ) ) ? 1 : 0;
+                        }
+                    break;
+                case compiledTree:
+                    for( p=0; p<n; p++ ) {
+                        if( mSetsVariables ) {
+                            for( int v=0; v<mNumVariables; v++ ) {
+                                mVariables[v]->setValue(
+                                    inVariableValues[v][ start + p ] );
+                                }
+                            }
+                        d[p] = inst->tree->evaluate();
+                        }
+                    break;
+                }
+            }
+
+        double *result = mRegisters;
+        for( int p=0; p<n; p++ ) {
+            outResults[ start + p ] = result[p];
+            }
+        }
+    }
+
+
+
+#endif
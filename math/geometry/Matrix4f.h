@@ -0,0 +1,224 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+
+
+#ifndef MATRIX_4F_INCLUDED
+#define MATRIX_4F_INCLUDED
+
+
+#include <string.h>
+
+#include "Vector3DBatch.h"
+
+
+
+/**
+ * 4x4 float matrix for transforming batches of vectors stored as
+ * x, y and z arrays (see Vector3DBatch.h).
+ *
+ * Same layout and conventions as Transform3D:  row-major, and applied
+ * to column vectors, so the last column holds the translation.
+ *
+ * @author Jason Rohrer
+ */
+class Matrix4f {
+
+    public:
+
+        // identity
+        Matrix4f();
+        
+        
+        // from 16 row-major doubles, as returned by Transform3D::getMatrix
+        Matrix4f( double *inRowMajor );
+        
+        
+        /**
+         * Multiplies this matrix by another, this = inOther * this, so
+         * applying the result applies this matrix and then inOther
+         * (as in Transform3D::transform).
+         */
+        void multiply( Matrix4f *inOther );
+        
+        
+        /**
+         * Transforms points in place.
+         *
+         * @param ioX, ioY, ioZ the coordinates of each point.
+         * @param inNumVectors the number of points.
+         */
+        void applyBatch( float *ioX, float *ioY, float *ioZ, 
+                         int inNumVectors );
+        
+        
+        /**
+         * Transforms directions (like normals) in place, skipping the
+         * translation.
+         */
+        void applyNoTranslationBatch( float *ioX, float *ioY, float *ioZ, 
+                                      int inNumVectors );
+
+
+        float m[4][4];
+        
+        
+    protected:
+        
+        void transformBatch( float *ioX, float *ioY, float *ioZ, 
+                             int inNumVectors, char inTranslate );
+    };
+
+
+
+inline Matrix4f::Matrix4f() {
+    for( int y=0; y<4; y++ ) {
+        for( int x=0; x<4; x++ ) {
+            m[y][x] = ( x == y ) ? 1.0f : 0.0f;
+            }
+        }
+    }
+
+
+
+inline Matrix4f::Matrix4f( double *inRowMajor ) {
+    for( int y=0; y<4; y++ ) {
+        for( int x=0; x<4; x++ ) {
+            m[y][x] = (float)( inRowMajor[ y * 4 + x ] );
+            }
+        }
+    }
+
+
+
+inline void Matrix4f::multiply( Matrix4f *inOther ) {
+    float destM[4][4];
+    
+    for( int dY=0; dY<4; dY++ ) {
+        for( int dX=0; dX<4; dX++ ) {
+            destM[dY][dX] = 0;
+            for( int i=0; i<4; i++ ) {
+                destM[dY][dX] += inOther->m[dY][i] * m[i][dX];
+                }
+            }
+        }
+    
+    memcpy( m, destM, 16 * sizeof( float ) );
+    }
+
+
+
+inline void Matrix4f::applyBatch( float *ioX, float *ioY, float *ioZ, 
+                                  int inNumVectors ) {
+    transformBatch( ioX, ioY, ioZ, inNumVectors, true );
+    }
+
+
+
+inline void Matrix4f::applyNoTranslationBatch( float *ioX, float *ioY, 
+                                               float *ioZ, 
+                                               int inNumVectors ) {
+    transformBatch( ioX, ioY, ioZ, inNumVectors, false );
+    }
+
+
+
+inline void Matrix4f::transformBatch( float *ioX, float *ioY, float *ioZ, 
+                                      int inNumVectors, char inTranslate ) {
+    
+    float tX = 0, tY = 0, tZ = 0;
+    if( inTranslate ) {
+        tX = m[0][3];
+        tY = m[1][3];
+        tZ = m[2][3];
+        }
+    
+    int i = 0;
+
+#if defined( VECTOR_3D_BATCH_SSE2 )
+
+    __m128 m00 = _mm_set1_ps( m[0][0] );
+    __m128 m01 = _mm_set1_ps( m[0][1] );
+    __m128 m02 = _mm_set1_ps( m[0][2] );
+    __m128 m10 = _mm_set1_ps( m[1][0] );
+    __m128 m11 = _mm_set1_ps( m[1][1] );
+    __m128 m12 = _mm_set1_ps( m[1][2] );
+    __m128 m20 = _mm_set1_ps( m[2][0] );
+    __m128 m21 = _mm_set1_ps( m[2][1] );
+    __m128 m22 = _mm_set1_ps( m[2][2] );
+    
+    __m128 vX = _mm_set1_ps( tX );
+    __m128 vY = _mm_set1_ps( tY );
+    __m128 vZ = _mm_set1_ps( tZ );
+    
+    for( ; i + 4 <= inNumVectors; i += 4 ) {
+        __m128 x = _mm_loadu_ps( ioX + i );
+        __m128 y = _mm_loadu_ps( ioY + i );
+        __m128 z = _mm_loadu_ps( ioZ + i );
+        
+        _mm_storeu_ps( ioX + i,
+                       _mm_add_ps( _mm_add_ps( _mm_mul_ps( m00, x ), 
+                                               _mm_mul_ps( m01, y ) ),
+                                   _mm_add_ps( _mm_mul_ps( m02, z ), 
+                                               vX ) ) );
+        _mm_storeu_ps( ioY + i,
+                       _mm_add_ps( _mm_add_ps( _mm_mul_ps( m10, x ), 
+                                               _mm_mul_ps( m11, y ) ),
+                                   _mm_add_ps( _mm_mul_ps( m12, z ), 
+                                               vY ) ) );
+        _mm_storeu_ps( ioZ + i,
+                       _mm_add_ps( _mm_add_ps( _mm_mul_ps( m20, x ), 
+                                               _mm_mul_ps( m21, y ) ),
+                                   _mm_add_ps( _mm_mul_ps( m22, z ), 
+                                               vZ ) ) );
+        }
+
+#elif defined( VECTOR_3D_BATCH_NEON )
+
+    for( ; i + 4 <= inNumVectors; i += 4 ) {
+        float32x4_t x = vld1q_f32( ioX + i );
+        float32x4_t y = vld1q_f32( ioY + i );
+        float32x4_t z = vld1q_f32( ioZ + i );
+        
+        float32x4_t outX = vdupq_n_f32( tX );
+        outX = vmlaq_n_f32( outX, x, m[0][0] );
+        outX = vmlaq_n_f32( outX, y, m[0][1] );
+        outX = vmlaq_n_f32( outX, z, m[0][2] );
+
+        float32x4_t outY = vdupq_n_f32( tY );
+        outY = vmlaq_n_f32( outY, x, m[1][0] );
+        outY = vmlaq_n_f32( outY, y, m[1][1] );
+        outY = vmlaq_n_f32( outY, z, m[1][2] );
+
+        float32x4_t outZ = vdupq_n_f32( tZ );
+        outZ = vmlaq_n_f32( outZ, x, m[2][0] );
+        outZ = vmlaq_n_f32( outZ, y, m[2][1] );
+        outZ = vmlaq_n_f32( outZ, z, m[2][2] );
+        
+        vst1q_f32( ioX + i, outX );
+        vst1q_f32( ioY + i, outY );
+        vst1q_f32( ioZ + i, outZ );
+        }
+
+#endif
+
+    // scalar tail (or all vectors if no vector unit), summed in the
+    // same order as the SSE2 path
+    for( ; i < inNumVectors; i++ ) {
+        float x = ioX[i];
+        float y = ioY[i];
+        float z = ioZ[i];
+        
+        ioX[i] = ( m[0][0] * x + m[0][1] * y ) + ( m[0][2] * z + tX );
+        ioY[i] = ( m[1][0] * x + m[1][1] * y ) + ( m[1][2] * z + tY );
+        ioZ[i] = ( m[2][0] * x + m[2][1] * y ) + ( m[2][2] * z + tZ );
+        }
+    }
+
+
+
+#endif
@@ -7,6 +7,10 @@
  *
  * 2001-February-3		Jason Rohrer
  * Updated serialization code to use new interfaces.    
+ *
+ * 2026-October-15		Jason Rohrer
+ * Added batch versions of apply for arrays of float coordinates.
+ * Serialization uses one stream call instead of sixteen.
  */
  
  
@@ -20,6 +24,7 @@
 
 #include "Vector3D.h"
 #include "Angle3D.h"
+#include "Matrix4f.h"
  
 /**
  * An affine transformation in 3D. 
@@ -111,6 +116,27 @@ class Transform3D : public Serializable {
 		void applyNoTranslation( Vector3D *inTarget );
 		
 		
+		/**
+		 * Transforms many points at once, stored as arrays of x, y and z
+		 * coordinates (see Vector3DBatch.h).  Much faster than calling
+		 * apply on each point, and works in float precision.
+		 *
+		 * @param ioX, ioY, ioZ the coordinates of each point,
+		 *   modified directly.  Must be destroyed by caller.
+		 * @param inNumVectors the number of points.
+		 */
+		void applyBatch( float *ioX, float *ioY, float *ioZ, 
+						 int inNumVectors );
+		
+		
+		/**
+		 * Like applyBatch, but skips the translation part of the
+		 * transform, as in applyNoTranslation.
+		 */
+		void applyNoTranslationBatch( float *ioX, float *ioY, float *ioZ, 
+									  int inNumVectors );
+		
+		
 		/**
 		 * Gets the transformation matrix underlying this transform.
 		 *
@@ -288,6 +314,23 @@ inline void Transform3D::applyNoTranslation( Vector3D *inTarget ) {
 
 
 
+inline void Transform3D::applyBatch( float *ioX, float *ioY, float *ioZ, 
+									   int inNumVectors ) {
+	Matrix4f matrix( getMatrix() );
+	matrix.applyBatch( ioX, ioY, ioZ, inNumVectors );
+	}
+
+
+
+inline void Transform3D::applyNoTranslationBatch( float *ioX, float *ioY, 
+												  float *ioZ, 
+												  int inNumVectors ) {
+	Matrix4f matrix( getMatrix() );
+	matrix.applyNoTranslationBatch( ioX, ioY, ioZ, inNumVectors );
+	}
+
+
+
 inline void Transform3D::multiply( double inMatrix[][4] ) {
 	double destM[4][4];
 	
@@ -327,26 +370,23 @@ inline void Transform3D::print() {
 		
 			
 inline int Transform3D::serialize( OutputStream *inOutputStream ) {
-	int numBytes = 0;
-	
-	for( int y=0; y<4; y++ ) {
-		for( int x=0; x<4; x++ ) {
-			numBytes += inOutputStream->writeDouble( mMatrix[y][x] );
-			}
-		}
+	unsigned char bytes[ 16 * 8 ];
 
-	return numBytes;
+	// row by row, same format as writeDouble for each element
+	TypeIO::doublesToBytes( &( mMatrix[0][0] ), 16, bytes );
+
+	return inOutputStream->write( bytes, 16 * 8 );
 	}
 	
 	
 	
 inline int Transform3D::deserialize( InputStream *inInputStream ) {
-	int numBytes = 0;
-	
-	for( int y=0; y<4; y++ ) {
-		for( int x=0; x<4; x++ ) {
-			numBytes += inInputStream->readDouble( &( mMatrix[y][x] ) );
-			}
+	unsigned char bytes[ 16 * 8 ];
+
+	int numBytes = inInputStream->read( bytes, 16 * 8 );
+
+	if( numBytes == 16 * 8 ) {
+		TypeIO::bytesToDoubles( bytes, 16, &( mMatrix[0][0] ) );
 		}
 
 	return numBytes;
@@ -58,6 +58,9 @@
  *
  * 2006-August-6		Jason Rohrer
  * Added a no-arg constructor.
+ *
+ * 2026-October-15		Jason Rohrer
+ * Serialization uses one stream call instead of three.
  */
  
  
@@ -759,23 +762,30 @@ inline void Vector3D::print() {
 
 
 inline int Vector3D::serialize( OutputStream *inOutputStream ) {
-	int numBytes = 0;
-	
-	numBytes += inOutputStream->writeDouble( mX );
-	numBytes += inOutputStream->writeDouble( mY );
-	numBytes += inOutputStream->writeDouble( mZ );
+	double values[3] = { mX, mY, mZ };
+	unsigned char bytes[24];
+
+	// same format as three writeDouble calls
+	TypeIO::doublesToBytes( values, 3, bytes );
 	
-	return numBytes;
+	return inOutputStream->write( bytes, 24 );
 	}
 	
 	
 	
 inline int Vector3D::deserialize( InputStream *inInputStream ) {
-	int numBytes = 0;
-	
-	numBytes += inInputStream->readDouble( &( mX ) );
-	numBytes += inInputStream->readDouble( &( mY ) );
-	numBytes += inInputStream->readDouble( &( mZ ) );
+	unsigned char bytes[24];
+
+	int numBytes = inInputStream->read( bytes, 24 );
+
+	if( numBytes == 24 ) {
+		double values[3];
+		TypeIO::bytesToDoubles( bytes, 3, values );
+
+		mX = values[0];
+		mY = values[1];
+		mZ = values[2];
+		}
 	
 	return numBytes;
 	}
@@ -0,0 +1,162 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+
+
+#ifndef VECTOR_3D_BATCH_INCLUDED
+#define VECTOR_3D_BATCH_INCLUDED
+
+
+#include <math.h>
+
+#include "Vector3D.h"
+
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || \
+    ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+    #define VECTOR_3D_BATCH_SSE2
+    #include <emmintrin.h>
+#elif defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+    #define VECTOR_3D_BATCH_NEON
+    #include <arm_neon.h>
+#endif
+
+
+
+// Functions for many vectors at once, stored as separate x, y and z
+// arrays of floats (structure of arrays), which vector units can work
+// through four at a time.
+//
+// See Matrix4f for transforming them.
+
+
+
+// copies inNumVectors Vector3Ds into x, y and z arrays
+inline void vector3DToBatch( Vector3D **inVectors, int inNumVectors,
+                             float *outX, float *outY, float *outZ ) {
+    for( int i=0; i<inNumVectors; i++ ) {
+        Vector3D *v = inVectors[i];
+        outX[i] = (float)( v->mX );
+        outY[i] = (float)( v->mY );
+        outZ[i] = (float)( v->mZ );
+        }
+    }
+
+
+
+// scales each vector to length 1, like Vector3D::normalize
+inline void normalizeBatch( float *ioX, float *ioY, float *ioZ,
+                            int inNumVectors ) {
+    int i = 0;
+
+#if defined( VECTOR_3D_BATCH_SSE2 )
+
+    __m128 one = _mm_set1_ps( 1.0f );
+    
+    for( ; i + 4 <= inNumVectors; i += 4 ) {
+        __m128 x = _mm_loadu_ps( ioX + i );
+        __m128 y = _mm_loadu_ps( ioY + i );
+        __m128 z = _mm_loadu_ps( ioZ + i );
+
+        __m128 lengthSquared = _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, x ),
+                                                       _mm_mul_ps( y, y ) ),
+                                           _mm_mul_ps( z, z ) );
+        
+        // full precision, rather than the 12-bit _mm_rsqrt_ps
+        __m128 invLength = _mm_div_ps( one, _mm_sqrt_ps( lengthSquared ) );
+        
+        _mm_storeu_ps( ioX + i, _mm_mul_ps( x, invLength ) );
+        _mm_storeu_ps( ioY + i, _mm_mul_ps( y, invLength ) );
+        _mm_storeu_ps( ioZ + i, _mm_mul_ps( z, invLength ) );
+        }
+
+#elif defined( VECTOR_3D_BATCH_NEON )
+
+    for( ; i + 4 <= inNumVectors; i += 4 ) {
+        float32x4_t x = vld1q_f32( ioX + i );
+        float32x4_t y = vld1q_f32( ioY + i );
+        float32x4_t z = vld1q_f32( ioZ + i );
+        
+        float32x4_t lengthSquared = vmlaq_f32( vmlaq_f32( vmulq_f32( x, x ),
+                                                          y, y ),
+                                               z, z );
+        
+        // estimate, then two Newton steps for about full float precision
+        // (no vector square root on 32-bit ARM)
+        float32x4_t invLength = vrsqrteq_f32( lengthSquared );
+        invLength = vmulq_f32( 
+            invLength, 
+            vrsqrtsq_f32( vmulq_f32( lengthSquared, invLength ), 
+                          invLength ) );
+        invLength = vmulq_f32( 
+            invLength, 
+            vrsqrtsq_f32( vmulq_f32( lengthSquared, invLength ), 
+                          invLength ) );
+        
+        vst1q_f32( ioX + i, vmulq_f32( x, invLength ) );
+        vst1q_f32( ioY + i, vmulq_f32( y, invLength ) );
+        vst1q_f32( ioZ + i, vmulq_f32( z, invLength ) );
+        }
+
+#endif
+
+    // scalar tail (or all vectors if no vector unit)
+    for( ; i < inNumVectors; i++ ) {
+        float invLength = 1.0f / sqrtf( ioX[i] * ioX[i] + 
+                                        ioY[i] * ioY[i] + 
+                                        ioZ[i] * ioZ[i] );
+        ioX[i] *= invLength;
+        ioY[i] *= invLength;
+        ioZ[i] *= invLength;
+        }
+    }
+
+
+// dot product of each vector with one fixed vector (for example, a
+// light direction)
+inline void dotBatch( float *inX, float *inY, float *inZ,
+                      float inOtherX, float inOtherY, float inOtherZ,
+                      int inNumVectors, float *outDots ) {
+    int i = 0;
+
+#if defined( VECTOR_3D_BATCH_SSE2 )
+    __m128 otherX = _mm_set1_ps( inOtherX );
+    __m128 otherY = _mm_set1_ps( inOtherY );
+    __m128 otherZ = _mm_set1_ps( inOtherZ );
+
+    for( ; i + 4 <= inNumVectors; i += 4 ) {
+        __m128 dot = _mm_add_ps( 
+            _mm_add_ps( _mm_mul_ps( _mm_loadu_ps( inX + i ), otherX ),
+                        _mm_mul_ps( _mm_loadu_ps( inY + i ), otherY ) ),
+            _mm_mul_ps( _mm_loadu_ps( inZ + i ), otherZ ) );
+        
+        _mm_storeu_ps( outDots + i, dot );
+        }
+#elif defined( VECTOR_3D_BATCH_NEON )
+    float32x4_t otherX = vdupq_n_f32( inOtherX );
+    float32x4_t otherY = vdupq_n_f32( inOtherY );
+    float32x4_t otherZ = vdupq_n_f32( inOtherZ );
+
+    for( ; i + 4 <= inNumVectors; i += 4 ) {
+        float32x4_t dot = vmulq_f32( vld1q_f32( inX + i ), otherX );
+        dot = vmlaq_f32( dot, vld1q_f32( inY + i ), otherY );
+        dot = vmlaq_f32( dot, vld1q_f32( inZ + i ), otherZ );
+        
+        vst1q_f32( outDots + i, dot );
+        }
+#endif
+
+    // scalar tail (or all vectors if no vector unit)
+    for( ; i < inNumVectors; i++ ) {
+        outDots[i] = inX[i] * inOtherX + inY[i] * inOtherY + 
+            inZ[i] * inOtherZ;
+        }
+    }
+
+
+
+#endif
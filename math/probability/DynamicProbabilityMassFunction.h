@@ -0,0 +1,288 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+
+
+#ifndef DYNAMIC_PROBABILITY_MASS_FUNCTION_INCLUDED
+#define DYNAMIC_PROBABILITY_MASS_FUNCTION_INCLUDED
+
+
+#include "ProbabilityMassFunction.h"
+
+
+
+
+/**
+ * A ProbabilityMassFunction for distributions that change between most
+ * samples.
+ *
+ * Keeps weights in a Fenwick tree (binary indexed tree) instead of an
+ * alias table, so addElement, setProbability, and sampleElement all take
+ * O(log n) time.  removeElement shifts the indices of later elements, so
+ * it leaves the tree to be rebuilt (in linear time) on the next sample.
+ *
+ * @author Jason Rohrer
+ */
+class DynamicProbabilityMassFunction : public ProbabilityMassFunction {
+
+	public:
+
+
+
+		// same as ProbabilityMassFunction constructors
+		DynamicProbabilityMassFunction( RandomSource *inRandSource );
+
+		DynamicProbabilityMassFunction( RandomSource *inRandSource,
+										int inNumElements,
+										double *inProbabilities );
+
+
+
+		// overrides these from ProbabilityMassFunction
+
+		virtual int addElement( double inProbability );
+
+		virtual void removeElement( int inIndex );
+
+		virtual void setProbability( int inIndex,
+									 double inProbability );
+
+		virtual int sampleElement();
+
+
+
+	protected:
+
+		// 1-based, with unused 0 element
+		// element i holds sum of weights in (i - lowbit(i), i]
+		SimpleVector< double > mTree;
+
+		// true if tree must be rebuilt before next sample
+		char mTreeStale;
+
+		// largest power of 2 <= tree size
+		int mTreeTopStep;
+
+
+
+		// overrides ProbabilityMassFunction::normalize, which changes
+		// every weight
+		virtual void normalize();
+
+
+		// sum of weights of first inCount elements
+		double getPrefixSum( int inCount );
+
+		void addToTree( int inIndex, double inDelta );
+
+		void buildTree();
+
+		void updateTopStep();
+
+
+	};
+
+
+
+inline DynamicProbabilityMassFunction::DynamicProbabilityMassFunction(
+	RandomSource *inRandSource )
+	: ProbabilityMassFunction( inRandSource ),
+	  mTreeStale( true ),
+	  mTreeTopStep( 0 ) {
+	}
+
+
+
+inline DynamicProbabilityMassFunction::DynamicProbabilityMassFunction(
+	RandomSource *inRandSource,
+	int inNumElements, double *inProbabilities )
+	: ProbabilityMassFunction( inRandSource,
+							   inNumElements, inProbabilities ),
+	  mTreeStale( true ),
+	  mTreeTopStep( 0 ) {
+	}
+
+
+
+inline int DynamicProbabilityMassFunction::addElement(
+	double inProbability ) {
+
+	int result = ProbabilityMassFunction::addElement( inProbability );
+
+	if( ! mTreeStale ) {
+		// new node covers (k - lowbit(k), k], of which only new weight
+		// isn't in the tree yet
+		int k = mProbabilityVector->size();
+		int lowBit = k & ( -k );
+
+		double weight = mProbabilityVector->getElementDirect( k - 1 );
+
+		mTree.push_back( weight +
+						 getPrefixSum( k - 1 ) -
+						 getPrefixSum( k - lowBit ) );
+
+		updateTopStep();
+		}
+
+	return result;
+	}
+
+
+
+inline void DynamicProbabilityMassFunction::removeElement(
+	int inIndex ) {
+
+	ProbabilityMassFunction::removeElement( inIndex );
+
+	mTreeStale = true;
+	}
+
+
+
+inline void DynamicProbabilityMassFunction::setProbability(
+	int inIndex, double inProbability ) {
+
+	double oldWeight = 0;
+
+	if( inIndex >= 0 && inIndex < mProbabilityVector->size() ) {
+		oldWeight = mProbabilityVector->getElementDirect( inIndex );
+		}
+
+	ProbabilityMassFunction::setProbability( inIndex, inProbability );
+
+	if( ! mTreeStale &&
+		inIndex >= 0 && inIndex < mProbabilityVector->size() ) {
+
+		addToTree( inIndex,
+				   mProbabilityVector->getElementDirect( inIndex ) -
+				   oldWeight );
+		}
+	}
+
+
+
+inline int DynamicProbabilityMassFunction::sampleElement() {
+
+	int numValues = mProbabilityVector->size();
+
+	if( numValues == 0 ) {
+		return 0;
+		}
+
+	if( mTreeStale ) {
+		buildTree();
+		}
+
+	double *tree = mTree.getElementFast( 0 );
+
+	// walk down to the first element whose prefix sum reaches target,
+	// same as walking the CDF
+	double target = mRandSource->getRandomDouble() *
+		getPrefixSum( numValues );
+
+	int position = 0;
+
+	for( int step = mTreeTopStep; step > 0; step >>= 1 ) {
+		int next = position + step;
+
+		if( next <= numValues && tree[next] < target ) {
+			position = next;
+			target -= tree[next];
+			}
+		}
+
+	// rounding can push past the end
+	if( position >= numValues ) {
+		position = numValues - 1;
+		}
+
+	return position;
+	}
+
+
+
+inline void DynamicProbabilityMassFunction::normalize() {
+	ProbabilityMassFunction::normalize();
+
+	mTreeStale = true;
+	}
+
+
+
+inline double DynamicProbabilityMassFunction::getPrefixSum( int inCount ) {
+	double *tree = mTree.getElementFast( 0 );
+
+	double sum = 0;
+
+	for( int i=inCount; i>0; i -= i & ( -i ) ) {
+		sum += tree[i];
+		}
+
+	return sum;
+	}
+
+
+
+inline void DynamicProbabilityMassFunction::addToTree( int inIndex,
+													   double inDelta ) {
+	double *tree = mTree.getElementFast( 0 );
+
+	int size = mProbabilityVector->size();
+
+	for( int i=inIndex + 1; i<=size; i += i & ( -i ) ) {
+		tree[i] += inDelta;
+		}
+	}
+
+
+
+inline void DynamicProbabilityMassFunction::buildTree() {
+	int size = mProbabilityVector->size();
+
+	mTree.deleteAll();
+	mTree.push_back( 0 );
+
+	for( int i=0; i<size; i++ ) {
+		mTree.push_back( mProbabilityVector->getElementDirect( i ) );
+		}
+
+	// push each node's sum up to its parent, in linear time
+	double *tree = mTree.getElementFast( 0 );
+
+	for( int i=1; i<=size; i++ ) {
+		int parent = i + ( i & ( -i ) );
+
+		if( parent <= size ) {
+			tree[parent] += tree[i];
+			}
+		}
+
+	updateTopStep();
+
+	mTreeStale = false;
+	}
+
+
+
+inline void DynamicProbabilityMassFunction::updateTopStep() {
+	int size = mProbabilityVector->size();
+
+	if( mTreeTopStep == 0 ) {
+		mTreeTopStep = 1;
+		}
+
+	while( mTreeTopStep * 2 <= size ) {
+		mTreeTopStep *= 2;
+		}
+	while( mTreeTopStep > size ) {
+		mTreeTopStep /= 2;
+		}
+	}
+
+
+
+#endif
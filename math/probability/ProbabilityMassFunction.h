@@ -16,6 +16,11 @@
  * 2011-February-3   Jason Rohrer
  * Added check to deal with rounding errors or 0-length probability 
  * distributions.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Stores weights instead of normalizing on every change.  Samples in
+ * constant time from an alias table, rebuilt on the next sample after
+ * changes.
  */
 
 
@@ -34,6 +39,14 @@
  * A discrete probability distribution.
  * All probabilities are constrained to sum to 1.
  *
+ * Internally, elements have weights that aren't kept normalized, so
+ * changes take constant time.  Sampling uses an alias table (Vose's
+ * method), built in linear time on the first sample after a batch of
+ * changes, after which each sample takes constant time.
+ *
+ * For a distribution that changes between most samples, see
+ * DynamicProbabilityMassFunction.
+ *
  * @author Jason Rohrer
  */
 class ProbabilityMassFunction {
@@ -164,8 +177,22 @@ class ProbabilityMassFunction {
 	protected:
 		RandomSource *mRandSource;
 		
+		// element weights
+		// probability of an element is its weight over mWeightSum
 		SimpleVector< double > *mProbabilityVector;
 
+		// kept up to date as weights change
+		double mWeightSum;
+
+
+		// true if alias table must be rebuilt before next sample
+		char mAliasTableStale;
+
+		// for each element's column, the chance of taking the element
+		// itself instead of its alias
+		SimpleVector< double > mAliasThresholds;
+		SimpleVector< int > mAliases;
+		
 
 
 		/**
@@ -176,13 +203,21 @@ class ProbabilityMassFunction {
 		
 
 		/**
-		 * Gets the net sum of this probability distribution.
+		 * Gets the net sum of this probability distribution's weights.
 		 *
-		 * @return the sum of this distribution.
+		 * @return the sum of the weights, recomputed.
 		 */
 		virtual double getProbabilitySum();
 
 
+
+		// normalizes if weights have drifted near the limits of double
+		// (each add or set scales weights by the sum)
+		void checkWeightScale();
+
+
+		void buildAliasTable();
+
 		
 	};
 
@@ -191,7 +226,9 @@ class ProbabilityMassFunction {
 inline ProbabilityMassFunction::ProbabilityMassFunction(
 	RandomSource *inRandSource )
 	: mRandSource( inRandSource ),
-	  mProbabilityVector( new SimpleVector< double >() ) {
+	  mProbabilityVector( new SimpleVector< double >() ),
+	  mWeightSum( 0 ),
+	  mAliasTableStale( true ) {
 	}
 
 
@@ -200,7 +237,9 @@ inline ProbabilityMassFunction::ProbabilityMassFunction(
 	RandomSource *inRandSource,
 	int inNumElements, double *inProbabilities )
 	: mRandSource( inRandSource ),
-	  mProbabilityVector( new SimpleVector< double >( inNumElements ) ){
+	  mProbabilityVector( new SimpleVector< double >( inNumElements ) ),
+	  mWeightSum( 0 ),
+	  mAliasTableStale( true ) {
 
 	for( int i=0; i<inNumElements; i++ ) {
 		mProbabilityVector->push_back( inProbabilities[i] );
@@ -222,9 +261,20 @@ inline ProbabilityMassFunction::~ProbabilityMassFunction() {
 inline int ProbabilityMassFunction::addElement(
 	double inProbability ) {
 
-	mProbabilityVector->push_back( inProbability );
+	// scaling by current sum gives the same result as adding 
+	// inProbability to normalized probabilities and normalizing again
+	double weight = inProbability;
+	
+	if( mWeightSum > 0 ) {
+		weight *= mWeightSum;
+		}
 
-	normalize();
+	mProbabilityVector->push_back( weight );
+	mWeightSum += weight;
+
+	mAliasTableStale = true;
+
+	checkWeightScale();
 	
 	return mProbabilityVector->size();
 	}
@@ -234,9 +284,18 @@ inline int ProbabilityMassFunction::addElement(
 inline void ProbabilityMassFunction::removeElement(
 	int inIndex ) {
 
-	mProbabilityVector->deleteElement( (int)inIndex );
+	if( inIndex >= 0 && inIndex < mProbabilityVector->size() ) {
+		mWeightSum -= mProbabilityVector->getElementDirect( inIndex );
+		
+		mProbabilityVector->deleteElement( inIndex );
+
+		if( mProbabilityVector->size() == 0 ) {
+			// clear any rounding error
+			mWeightSum = 0;
+			}
 
-	normalize();	
+		mAliasTableStale = true;
+		}
 	}
 
 
@@ -244,8 +303,9 @@ inline void ProbabilityMassFunction::removeElement(
 inline double ProbabilityMassFunction::getProbability(
 	int inIndex ) {
 
-	if( inIndex >= 0 && inIndex < mProbabilityVector->size() ) {
-		return *( mProbabilityVector->getElement( inIndex ) );
+	if( inIndex >= 0 && inIndex < mProbabilityVector->size() &&
+		mWeightSum > 0 ) {
+		return *( mProbabilityVector->getElement( inIndex ) ) / mWeightSum;
 		}
 	else {
 		return 0;
@@ -258,8 +318,21 @@ inline void ProbabilityMassFunction::setProbability( int inIndex,
 													 double inProbability ) {
 
 	if( inIndex >= 0 && inIndex < mProbabilityVector->size() ) {
-		*( mProbabilityVector->getElement( inIndex ) ) = inProbability;
-		normalize();
+		double *weight = mProbabilityVector->getElement( inIndex );
+
+		// as for addElement, scale by current sum
+		double newWeight = inProbability;
+		
+		if( mWeightSum > 0 ) {
+			newWeight *= mWeightSum;
+			}
+
+		mWeightSum += newWeight - *weight;
+		*weight = newWeight;
+
+		mAliasTableStale = true;
+
+		checkWeightScale();
 		}
 	}
 
@@ -267,35 +340,116 @@ inline void ProbabilityMassFunction::setProbability( int inIndex,
 
 inline int ProbabilityMassFunction::sampleElement() {
 
-	double randVal = mRandSource->getRandomDouble();
+	int numValues = mProbabilityVector->size();
+
+	if( numValues == 0 ) {
+		return 0;
+		}
+
+	if( mAliasTableStale ) {
+		buildAliasTable();
+		}
+
+	// pick a column, then the element or its alias
+	int column = mRandSource->getRandomBoundedInt( 0, numValues - 1 );
+
+	if( mRandSource->getRandomDouble() < 
+		mAliasThresholds.getElementDirectFast( column ) ) {
+		return column;
+		}
+	else {
+		return mAliases.getElementDirectFast( column );
+		}
+	}
+
+
+
+inline void ProbabilityMassFunction::buildAliasTable() {
+
+	int numValues = mProbabilityVector->size();
+
+	// recompute sum exactly, since it drifts as weights change
+	mWeightSum = getProbabilitySum();
+
+	mAliasThresholds.deleteAll();
+	mAliases.deleteAll();
+
+	// each column holds an average weight
+	double scale = 0;
+	if( mWeightSum > 0 ) {
+		scale = numValues / mWeightSum;
+		}
+
+	SimpleVector< int > small;
+	SimpleVector< int > large;
 	
-	// compute a running CDF value until we surpass randVal
-	double currentCDFVal = 0;
-	int currentIndex = -1;
+	for( int i=0; i<numValues; i++ ) {
+		double scaled = mProbabilityVector->getElementDirect( i ) * scale;
+		
+		mAliasThresholds.push_back( scaled );
+		mAliases.push_back( i );
+
+		if( scaled < 1 ) {
+			small.push_back( i );
+			}
+		else {
+			large.push_back( i );
+			}
+		}
+
+	double *thresholds = mAliasThresholds.getElementFast( 0 );
+	int *aliases = mAliases.getElementFast( 0 );
+
+	// fill each small column up with part of a large one
+	int lastLarge = -1;
 	
-    int numValues = mProbabilityVector->size();
-    
+	while( small.size() > 0 && large.size() > 0 ) {
+		int s = small.getLastElementDirect();
+		small.deleteLastElement();
 
-	while( currentCDFVal < randVal && 
-           currentIndex < numValues - 1 ) {
-		
-        currentIndex++;
+		int l = large.getLastElementDirect();
+		lastLarge = l;
 
-		double currentProb =
-			*( mProbabilityVector->getElement( currentIndex ) );
+		aliases[s] = l;
 
-		currentCDFVal += currentProb;
+		thresholds[l] = ( thresholds[l] + thresholds[s] ) - 1;
+
+		if( thresholds[l] < 1 ) {
+			large.deleteLastElement();
+			small.push_back( l );
+			}
 		}
-	// when we exit the while loop, we are at the index of the
-	// element whose probability pushed the CDF past randVal
 
-	
-	if( currentIndex == -1 ) {
-		// randVal was 0
-		return 0;
+	// what's left is full, up to rounding error
+	for( int i=0; i<large.size(); i++ ) {
+		thresholds[ large.getElementDirect( i ) ] = 1;
 		}
-	else {
-		return currentIndex;
+	for( int i=0; i<small.size(); i++ ) {
+		int s = small.getElementDirect( i );
+		
+		if( mProbabilityVector->getElementDirect( s ) > 0 || 
+			lastLarge == -1 ) {
+			thresholds[s] = 1;
+			}
+		else {
+			// never let rounding error make a 0-weight element sampleable
+			thresholds[s] = 0;
+			aliases[s] = lastLarge;
+			}
+		}
+
+	mAliasTableStale = false;
+
+	small.deleteAll();
+	large.deleteAll();
+	}
+
+
+
+inline void ProbabilityMassFunction::checkWeightScale() {
+	if( mWeightSum > 1e100 || 
+		( mWeightSum > 0 && mWeightSum < 1e-100 ) ) {
+		normalize();
 		}
 	}
 
@@ -309,7 +463,7 @@ inline double ProbabilityMassFunction::getMinimumProbability() {
 	
 	for( int i=0; i<numElements; i++ ) {
 
-		double prob = *( mProbabilityVector->getElement( i ) );
+		double prob = getProbability( i );
 
 		if( prob < minValue ) {
 			minValue = prob;
@@ -325,7 +479,7 @@ inline void ProbabilityMassFunction::normalize() {
 
 	double currentSum = getProbabilitySum();
 
-	if( currentSum != 1 ) {
+	if( currentSum != 1 && currentSum > 0 ) {
 		double invCurrentSum = 1.0 / currentSum;
 
 		int numElements = mProbabilityVector->size();
@@ -338,6 +492,10 @@ inline void ProbabilityMassFunction::normalize() {
 			}
 
 		}
+
+	mWeightSum = getProbabilitySum();
+	
+	mAliasTableStale = true;
 	}
 
 
@@ -361,7 +519,7 @@ inline void ProbabilityMassFunction::print() {
 	int numElements = mProbabilityVector->size();
 
 	for( int i=0; i<numElements; i++ ) {
-		double prob = *( mProbabilityVector->getElement( i ) );
+		double prob = getProbability( i );
 
 		printf( "%lf ", prob );
 		}
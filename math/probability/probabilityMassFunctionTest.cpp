@@ -0,0 +1,253 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+/**
+ * Checks that ProbabilityMassFunction and DynamicProbabilityMassFunction
+ * give the same probabilities as normalizing after every change, that
+ * their samples follow those probabilities (and never pick 0-probability
+ * elements), and times sampling against a linear CDF walk.
+ *
+ * Compile from above the minorGems directory with:
+ *   g++ -O2 -I. minorGems/math/probability/probabilityMassFunctionTest.cpp
+ *     minorGems/system/unix/TimeUnix.cpp -o probabilityMassFunctionTest
+ */
+
+#include "ProbabilityMassFunction.h"
+#include "DynamicProbabilityMassFunction.h"
+
+#include "minorGems/system/Time.h"
+
+#include <stdio.h>
+#include <math.h>
+
+// uses Time and fmod without including them
+#include "minorGems/util/random/StdRandomSource.h"
+
+
+
+static int numBad = 0;
+
+
+
+// normalizes after every change, like ProbabilityMassFunction used to
+class ReferencePMF {
+	public:
+
+		void add( double inProbability ) {
+			mValues.push_back( inProbability );
+			normalize();
+			}
+
+		void remove( int inIndex ) {
+			mValues.deleteElement( inIndex );
+			normalize();
+			}
+
+		void set( int inIndex, double inProbability ) {
+			*( mValues.getElement( inIndex ) ) = inProbability;
+			normalize();
+			}
+
+		int sample( double inRandVal ) {
+			double cdf = 0;
+			int index = -1;
+			while( cdf < inRandVal && index < mValues.size() - 1 ) {
+				index++;
+				cdf += mValues.getElementDirect( index );
+				}
+			if( index == -1 ) {
+				return 0;
+				}
+			return index;
+			}
+
+		void normalize() {
+			double sum = 0;
+			for( int i=0; i<mValues.size(); i++ ) {
+				sum += mValues.getElementDirect( i );
+				}
+			if( sum > 0 ) {
+				for( int i=0; i<mValues.size(); i++ ) {
+					*( mValues.getElement( i ) ) /= sum;
+					}
+				}
+			}
+
+		SimpleVector<double> mValues;
+	};
+
+
+
+static void checkProbabilities( ProbabilityMassFunction *inPMF,
+								ReferencePMF *inReference,
+								const char *inWhat ) {
+	for( int i=0; i<inReference->mValues.size(); i++ ) {
+		double expected = inReference->mValues.getElementDirect( i );
+		double got = inPMF->getProbability( i );
+
+		if( fabs( expected - got ) > 1e-9 * ( expected + 1e-9 ) + 1e-12 ) {
+			printf( "%s: element %d has probability %g, expected %g\n",
+					inWhat, i, got, expected );
+			numBad++;
+			return;
+			}
+		}
+	}
+
+
+
+// checks sample counts against probabilities, within 5 standard
+// deviations, and that 0-probability elements are never sampled
+static void checkSamples( ProbabilityMassFunction *inPMF, int inNumElements,
+						  int inNumSamples, const char *inWhat ) {
+	int *counts = new int[ inNumElements ];
+	for( int i=0; i<inNumElements; i++ ) {
+		counts[i] = 0;
+		}
+
+	for( int s=0; s<inNumSamples; s++ ) {
+		counts[ inPMF->sampleElement() ]++;
+		}
+
+	for( int i=0; i<inNumElements; i++ ) {
+		double p = inPMF->getProbability( i );
+		double expected = p * inNumSamples;
+		double sigma = sqrt( inNumSamples * p * ( 1 - p ) );
+
+		if( ( p == 0 && counts[i] != 0 ) ||
+			fabs( counts[i] - expected ) > 5 * sigma + 2 ) {
+			printf( "%s: element %d sampled %d times, expected %.1f\n",
+					inWhat, i, counts[i], expected );
+			numBad++;
+			break;
+			}
+		}
+
+	delete [] counts;
+	}
+
+
+
+int main() {
+	StdRandomSource randSource( 1 );
+
+
+	// same probabilities as normalizing after every change
+	ProbabilityMassFunction pmf( &randSource );
+	DynamicProbabilityMassFunction dynamicPMF( &randSource );
+	ReferencePMF reference;
+
+	for( int t=0; t<3000; t++ ) {
+		int op = randSource.getRandomBoundedInt( 0, 3 );
+		int size = reference.mValues.size();
+
+		if( op <= 1 || size < 2 ) {
+			double p = randSource.getRandomDouble();
+			if( t % 7 == 0 ) {
+				p = 0;
+				}
+			pmf.addElement( p );
+			dynamicPMF.addElement( p );
+			reference.add( p );
+			}
+		else if( op == 2 ) {
+			int index = randSource.getRandomBoundedInt( 0, size - 1 );
+			double p = randSource.getRandomDouble();
+			pmf.setProbability( index, p );
+			dynamicPMF.setProbability( index, p );
+			reference.set( index, p );
+			}
+		else {
+			int index = randSource.getRandomBoundedInt( 0, size - 1 );
+			pmf.removeElement( index );
+			dynamicPMF.removeElement( index );
+			reference.remove( index );
+			}
+
+		if( t % 100 == 0 ) {
+			// samples in between, so dynamic tree is updated in place
+			// from then on
+			pmf.sampleElement();
+			dynamicPMF.sampleElement();
+			}
+		}
+	checkProbabilities( &pmf, &reference, "Alias" );
+	checkProbabilities( &dynamicPMF, &reference, "Dynamic" );
+
+	int numElements = reference.mValues.size();
+
+	checkSamples( &pmf, numElements, 2000000, "Alias" );
+	checkSamples( &dynamicPMF, numElements, 2000000, "Dynamic" );
+
+
+	// skewed distribution, where alias table has many small columns
+	double skewed[5] = { 1000, 1, 0, 1, 0.001 };
+	ProbabilityMassFunction skewedPMF( &randSource, 5, skewed );
+	checkSamples( &skewedPMF, 5, 2000000, "Skewed alias" );
+	DynamicProbabilityMassFunction skewedDynamic( &randSource, 5, skewed );
+	checkSamples( &skewedDynamic, 5, 2000000, "Skewed dynamic" );
+
+
+	// timing with a table of a few thousand entries
+	int tableSize = 5000;
+	int numSamples = 1000000;
+
+	ProbabilityMassFunction timePMF( &randSource );
+	DynamicProbabilityMassFunction timeDynamic( &randSource );
+	ReferencePMF timeReference;
+
+	for( int i=0; i<tableSize; i++ ) {
+		double p = randSource.getRandomDouble();
+		timePMF.addElement( p );
+		timeDynamic.addElement( p );
+		timeReference.mValues.push_back( p );
+		}
+	timeReference.normalize();
+
+	unsigned int checksum = 0;
+
+	double startTime = Time::getMonotonicTime();
+	for( int s=0; s<numSamples; s++ ) {
+		checksum += timeReference.sample( randSource.getRandomDouble() );
+		}
+	double walkTime = Time::getMonotonicTime() - startTime;
+
+	startTime = Time::getMonotonicTime();
+	for( int s=0; s<numSamples; s++ ) {
+		checksum += timePMF.sampleElement();
+		}
+	double aliasTime = Time::getMonotonicTime() - startTime;
+
+	startTime = Time::getMonotonicTime();
+	for( int s=0; s<numSamples; s++ ) {
+		checksum += timeDynamic.sampleElement();
+		}
+	double dynamicTime = Time::getMonotonicTime() - startTime;
+
+	// changing one element before every sample
+	startTime = Time::getMonotonicTime();
+	for( int s=0; s<numSamples / 10; s++ ) {
+		timeDynamic.setProbability( s % tableSize,
+									randSource.getRandomDouble() * 0.001 );
+		checksum += timeDynamic.sampleElement();
+		}
+	double changingTime = 10 * ( Time::getMonotonicTime() - startTime );
+
+	printf( "%d samples from %d elements (checksum %u):\n"
+			"  CDF walk %.3f s, alias %.3f s, dynamic %.3f s, "
+			"dynamic with a change per sample %.3f s\n",
+			numSamples, tableSize, checksum,
+			walkTime, aliasTime, dynamicTime, changingTime );
+
+
+	if( numBad == 0 ) {
+		printf( "All tests passed\n" );
+		return 0;
+		}
+	printf( "%d failures\n", numBad );
+	return 1;
+	}
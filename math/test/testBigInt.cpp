@@ -3,13 +3,290 @@
  *
  * 2002-May-25    Jason Rohrer
  * Created.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Added multiply, divide, and modPow tests, and 2048-bit benchmarks.
  */
 
 
 
 #include "minorGems/math/BigInt.h"
+#include "minorGems/system/Time.h"
 
 #include <stdio.h>
+#include <stdlib.h>
+
+
+
+// a positive integer with inNumBits random bits, top bit set
+BigInt *randomBigInt( int inNumBits ) {
+    int numBytes = ( inNumBits + 7 ) / 8;
+    unsigned char *bytes = new unsigned char[ numBytes ];
+
+    for( int i=0; i<numBytes; i++ ) {
+        bytes[i] = (unsigned char)( rand() & 0xFF );
+        }
+
+    int topBits = inNumBits - 8 * ( numBytes - 1 );
+    bytes[0] &= (unsigned char)( 0xFF >> ( 8 - topBits ) );
+    bytes[0] |= (unsigned char)( 1 << ( topBits - 1 ) );
+
+    BigInt *result = new BigInt( 1, numBytes, bytes );
+    delete [] bytes;
+
+    return result;
+    }
+
+
+
+// 2^inPower - 1
+BigInt *mersenne( int inPower ) {
+    int numBytes = ( inPower + 7 ) / 8;
+    unsigned char *bytes = new unsigned char[ numBytes ];
+
+    for( int i=0; i<numBytes; i++ ) {
+        bytes[i] = 0xFF;
+        }
+    bytes[0] = (unsigned char)( 0xFF >> ( 8 * numBytes - inPower ) );
+
+    BigInt *result = new BigInt( 1, numBytes, bytes );
+    delete [] bytes;
+
+    return result;
+    }
+
+
+
+// square and multiply, reducing with divide, as a check on modPow
+BigInt *slowModPow( BigInt *inBase, BigInt *inExponent, BigInt *inModulus ) {
+    BigInt *result = new BigInt( 1 );
+
+    for( int i=inExponent->getNumBits()-1; i>=0; i-- ) {
+        BigInt *square = result->multiply( result );
+        delete result;
+        result = square->mod( inModulus );
+        delete square;
+
+        if( ( inExponent->mLimbs[ i / 32 ] >> ( i % 32 ) ) & 1 ) {
+            BigInt *product = result->multiply( inBase );
+            delete result;
+            result = product->mod( inModulus );
+            delete product;
+            }
+        }
+
+    return result;
+    }
+
+
+
+// returns true on failure
+char testLargeOperations() {
+    char failed = false;
+
+    printf( "Testing multiply and divide at sizes up to 8192 bits ...\n" );
+
+    int sizes[] = { 31, 64, 500, 1024, 1025, 2048, 3000, 8192 };
+    int numSizes = sizeof( sizes ) / sizeof( int );
+
+    for( int s=0; s<numSizes && !failed; s++ ) {
+        for( int t=0; t<numSizes && !failed; t++ ) {
+
+            BigInt *a = randomBigInt( sizes[s] );
+            BigInt *b = randomBigInt( sizes[t] );
+            BigInt *c = randomBigInt( sizes[t] / 2 + 1 );
+
+            // ( a + b )^2 = a^2 + 2ab + b^2
+            BigInt *sum = a->add( b );
+            BigInt *left = sum->multiply( sum );
+
+            BigInt *right = a->multiply( a );
+            BigInt *ab = a->multiply( b );
+            right->addInPlace( ab );
+            right->addInPlace( ab );
+            BigInt *bSquared = b->multiply( b );
+            right->addInPlace( bSquared );
+
+            if( ! left->isEqualTo( right ) ) {
+                printf( "square test failed for %d, %d bits\n",
+                        sizes[s], sizes[t] );
+                failed = true;
+                }
+
+            // ( ab + c ) / b = a, remainder c, when c < b
+            BigInt *dividend = ab->add( c );
+            BigInt *remainder;
+            BigInt *quotient = dividend->divide( b, &remainder );
+
+            if( ! quotient->isEqualTo( a ) || ! remainder->isEqualTo( c ) ) {
+                printf( "divide test failed for %d, %d bits\n",
+                        sizes[s], sizes[t] );
+                failed = true;
+                }
+
+            // truncating division of negatives
+            dividend->mSign = -1;
+            BigInt *negQuotient = dividend->divide( b );
+            negQuotient->addInPlace( a );
+            if( negQuotient->mSign != 0 ) {
+                printf( "negative divide test failed for %d, %d bits\n",
+                        sizes[s], sizes[t] );
+                failed = true;
+                }
+
+            delete a;
+            delete b;
+            delete c;
+            delete sum;
+            delete left;
+            delete right;
+            delete ab;
+            delete bSquared;
+            delete dividend;
+            delete remainder;
+            delete quotient;
+            delete negQuotient;
+            }
+        }
+
+
+    printf( "Testing modPow ...\n" );
+
+    // Fermat:  a^(p-1) mod p = 1 for the Mersenne prime p = 2^2203 - 1
+    BigInt *p = mersenne( 2203 );
+    BigInt *one = new BigInt( 1 );
+    BigInt *pMinusOne = p->subtract( one );
+
+    for( int i=0; i<3 && !failed; i++ ) {
+        BigInt *a = randomBigInt( 2000 );
+        BigInt *result = a->modPow( pMinusOne, p );
+
+        if( ! result->isEqualTo( one ) ) {
+            printf( "Fermat test failed\n" );
+            failed = true;
+            }
+        delete a;
+        delete result;
+        }
+
+    delete p;
+    delete pMinusOne;
+
+    // odd (Montgomery) and even moduli against square and multiply
+    for( int i=0; i<20 && !failed; i++ ) {
+        BigInt *base = randomBigInt( 1 + rand() % 700 );
+        BigInt *exponent = randomBigInt( 1 + rand() % 100 );
+        BigInt *modulus = randomBigInt( 2 + rand() % 600 );
+
+        if( i % 2 == 0 ) {
+            modulus->mLimbs[0] |= 1;
+            }
+        else {
+            modulus->mLimbs[0] &= ~1u;
+            }
+
+        BigInt *fast = base->modPow( exponent, modulus );
+        BigInt *slow = slowModPow( base, exponent, modulus );
+
+        if( ! fast->isEqualTo( slow ) ) {
+            printf( "modPow test failed (%s modulus)\n",
+                    ( i % 2 == 0 ) ? "odd" : "even" );
+            failed = true;
+            }
+
+        delete base;
+        delete exponent;
+        delete modulus;
+        delete fast;
+        delete slow;
+        }
+
+    delete one;
+
+    return failed;
+    }
+
+
+
+void runBenchmarks() {
+    int numBits = 2048;
+
+    printf( "Benchmarks at %d bits:\n", numBits );
+
+    BigInt *a = randomBigInt( numBits );
+    BigInt *b = randomBigInt( numBits );
+    BigInt *m = randomBigInt( numBits );
+    m->mLimbs[0] |= 1;
+
+    BigInt *exponent = new BigInt( 65537 );
+    BigInt *fullExponent = randomBigInt( numBits );
+
+    BigInt *accumulator = a->copy();
+
+    int reps = 200000;
+    double start = Time::getCurrentTime();
+    for( int i=0; i<reps; i++ ) {
+        accumulator->addInPlace( b );
+        }
+    double seconds = Time::getCurrentTime() - start;
+    printf( "  addInPlace:  %.0f per second\n", reps / seconds );
+
+    reps = 50000;
+    start = Time::getCurrentTime();
+    for( int i=0; i<reps; i++ ) {
+        BigInt *sum = a->add( b );
+        delete sum;
+        }
+    seconds = Time::getCurrentTime() - start;
+    printf( "  add:         %.0f per second\n", reps / seconds );
+
+    reps = 20000;
+    start = Time::getCurrentTime();
+    for( int i=0; i<reps; i++ ) {
+        BigInt *product = a->multiply( b );
+        delete product;
+        }
+    seconds = Time::getCurrentTime() - start;
+    printf( "  multiply:    %.0f per second\n", reps / seconds );
+
+    BigInt *product = a->multiply( b );
+
+    reps = 20000;
+    start = Time::getCurrentTime();
+    for( int i=0; i<reps; i++ ) {
+        BigInt *r = product->mod( m );
+        delete r;
+        }
+    seconds = Time::getCurrentTime() - start;
+    printf( "  mod:         %.0f per second\n", reps / seconds );
+
+    reps = 2000;
+    start = Time::getCurrentTime();
+    for( int i=0; i<reps; i++ ) {
+        BigInt *r = a->modPow( exponent, m );
+        delete r;
+        }
+    seconds = Time::getCurrentTime() - start;
+    printf( "  modPow, e = 65537:     %.0f per second\n", reps / seconds );
+
+    reps = 20;
+    start = Time::getCurrentTime();
+    for( int i=0; i<reps; i++ ) {
+        BigInt *r = a->modPow( fullExponent, m );
+        delete r;
+        }
+    seconds = Time::getCurrentTime() - start;
+    printf( "  modPow, %d-bit e:    %.1f per second\n", numBits,
+            reps / seconds );
+
+    delete a;
+    delete b;
+    delete m;
+    delete exponent;
+    delete fullExponent;
+    delete accumulator;
+    delete product;
+    }
 
 
 
@@ -125,8 +402,14 @@ int main() {
         delete intI;
         }
 
+    if( !failed ) {
+        failed = testLargeOperations();
+        }
+
     if( !failed ) {
         printf( "test passed\n" );
+
+        runBenchmarks();
         }
 
     return 0;
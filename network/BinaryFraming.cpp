@@ -0,0 +1,445 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+
+
+#include "BinaryFraming.h"
+
+
+#include <string.h>
+
+
+
+int writeVarUInt( uint64_t inValue, unsigned char *outBytes ) {
+    int numBytes = 0;
+
+    // 7 bits at a time, low bits first, high bit set on all but last
+    while( inValue >= 0x80 ) {
+        outBytes[ numBytes++ ] = (unsigned char)( inValue | 0x80 );
+        inValue >>= 7;
+        }
+    outBytes[ numBytes++ ] = (unsigned char)inValue;
+
+    return numBytes;
+    }
+
+
+
+int readVarUInt( const unsigned char *inBytes, int inNumBytes,
+                 uint64_t *outValue ) {
+    uint64_t value = 0;
+
+    for( int i=0; i<BINARY_FRAMING_MAX_VARINT_LENGTH; i++ ) {
+        if( i >= inNumBytes ) {
+            return 0;
+            }
+
+        unsigned char b = inBytes[i];
+
+        value |= (uint64_t)( b & 0x7F ) << ( 7 * i );
+
+        if( ( b & 0x80 ) == 0 ) {
+            *outValue = value;
+            return i + 1;
+            }
+        }
+
+    // too long
+    return -1;
+    }
+
+
+
+static inline uint64_t zigzagEncode( int64_t inValue ) {
+    return ( (uint64_t)inValue << 1 ) ^ (uint64_t)( inValue >> 63 );
+    }
+
+
+static inline int64_t zigzagDecode( uint64_t inValue ) {
+    return (int64_t)( inValue >> 1 ) ^ -(int64_t)( inValue & 1 );
+    }
+
+
+
+BinaryMessageWriter::BinaryMessageWriter( int inInitialCapacity )
+        : mCapacity( inInitialCapacity + BINARY_FRAMING_MAX_VARINT_LENGTH ),
+          mEnd( BINARY_FRAMING_MAX_VARINT_LENGTH ) {
+
+    mBuffer = new unsigned char[ mCapacity ];
+    }
+
+
+
+BinaryMessageWriter::~BinaryMessageWriter() {
+    delete [] mBuffer;
+    }
+
+
+
+void BinaryMessageWriter::reset() {
+    mEnd = BINARY_FRAMING_MAX_VARINT_LENGTH;
+    }
+
+
+
+void BinaryMessageWriter::ensureRoom( int inNumBytes ) {
+    if( mEnd + inNumBytes <= mCapacity ) {
+        return;
+        }
+
+    int newCapacity = 2 * mCapacity;
+    if( newCapacity < mEnd + inNumBytes ) {
+        newCapacity = mEnd + inNumBytes;
+        }
+
+    unsigned char *newBuffer = new unsigned char[ newCapacity ];
+    memcpy( newBuffer, mBuffer, mEnd );
+
+    delete [] mBuffer;
+    mBuffer = newBuffer;
+    mCapacity = newCapacity;
+    }
+
+
+
+void BinaryMessageWriter::putUInt( uint64_t inValue ) {
+    ensureRoom( BINARY_FRAMING_MAX_VARINT_LENGTH );
+
+    mEnd += writeVarUInt( inValue, &( mBuffer[ mEnd ] ) );
+    }
+
+
+
+void BinaryMessageWriter::putInt( int64_t inValue ) {
+    putUInt( zigzagEncode( inValue ) );
+    }
+
+
+
+void BinaryMessageWriter::putByte( unsigned char inValue ) {
+    ensureRoom( 1 );
+
+    mBuffer[ mEnd++ ] = inValue;
+    }
+
+
+
+void BinaryMessageWriter::putFloat( float inValue ) {
+    uint32_t bits;
+    memcpy( &bits, &inValue, 4 );
+
+    ensureRoom( 4 );
+
+    for( int i=0; i<4; i++ ) {
+        mBuffer[ mEnd++ ] = (unsigned char)( bits >> ( 8 * i ) );
+        }
+    }
+
+
+
+void BinaryMessageWriter::putDouble( double inValue ) {
+    uint64_t bits;
+    memcpy( &bits, &inValue, 8 );
+
+    ensureRoom( 8 );
+
+    for( int i=0; i<8; i++ ) {
+        mBuffer[ mEnd++ ] = (unsigned char)( bits >> ( 8 * i ) );
+        }
+    }
+
+
+
+void BinaryMessageWriter::putBytes( const unsigned char *inBytes,
+                                    int inLength ) {
+    putUInt( (uint64_t)inLength );
+
+    ensureRoom( inLength );
+
+    memcpy( &( mBuffer[ mEnd ] ), inBytes, inLength );
+    mEnd += inLength;
+    }
+
+
+
+void BinaryMessageWriter::putString( const char *inString ) {
+    putBytes( (const unsigned char *)inString, strlen( inString ) );
+    }
+
+
+
+int BinaryMessageWriter::getPayloadLength() {
+    return mEnd - BINARY_FRAMING_MAX_VARINT_LENGTH;
+    }
+
+
+
+unsigned char *BinaryMessageWriter::getFrame( int *outFrameLength ) {
+    int payloadLength = getPayloadLength();
+
+    unsigned char header[ BINARY_FRAMING_MAX_VARINT_LENGTH ];
+    int headerLength = writeVarUInt( (uint64_t)payloadLength, header );
+
+    // right before payload
+    int frameStart = BINARY_FRAMING_MAX_VARINT_LENGTH - headerLength;
+
+    memcpy( &( mBuffer[ frameStart ] ), header, headerLength );
+
+    *outFrameLength = headerLength + payloadLength;
+
+    return &( mBuffer[ frameStart ] );
+    }
+
+
+
+BinaryMessageReader::BinaryMessageReader( const unsigned char *inPayload,
+                                          int inLength )
+        : mPayload( inPayload ), mLength( inLength ), mPosition( 0 ),
+          mFailed( false ) {
+    }
+
+
+
+char BinaryMessageReader::haveBytes( int inNumBytes ) {
+    if( mFailed ) {
+        return false;
+        }
+    if( inNumBytes < 0 || inNumBytes > mLength - mPosition ) {
+        mFailed = true;
+        return false;
+        }
+    return true;
+    }
+
+
+
+uint64_t BinaryMessageReader::getUInt() {
+    if( mFailed ) {
+        return 0;
+        }
+
+    uint64_t value;
+    int numRead = readVarUInt( &( mPayload[ mPosition ] ),
+                               mLength - mPosition, &value );
+
+    if( numRead <= 0 ) {
+        mFailed = true;
+        return 0;
+        }
+
+    mPosition += numRead;
+    return value;
+    }
+
+
+
+int64_t BinaryMessageReader::getInt() {
+    return zigzagDecode( getUInt() );
+    }
+
+
+
+unsigned char BinaryMessageReader::getByte() {
+    if( ! haveBytes( 1 ) ) {
+        return 0;
+        }
+    return mPayload[ mPosition++ ];
+    }
+
+
+
+float BinaryMessageReader::getFloat() {
+    if( ! haveBytes( 4 ) ) {
+        return 0;
+        }
+
+    uint32_t bits = 0;
+    for( int i=0; i<4; i++ ) {
+        bits |= (uint32_t)mPayload[ mPosition++ ] << ( 8 * i );
+        }
+
+    float value;
+    memcpy( &value, &bits, 4 );
+    return value;
+    }
+
+
+
+double BinaryMessageReader::getDouble() {
+    if( ! haveBytes( 8 ) ) {
+        return 0;
+        }
+
+    uint64_t bits = 0;
+    for( int i=0; i<8; i++ ) {
+        bits |= (uint64_t)mPayload[ mPosition++ ] << ( 8 * i );
+        }
+
+    double value;
+    memcpy( &value, &bits, 8 );
+    return value;
+    }
+
+
+
+const unsigned char *BinaryMessageReader::getBytes( int *outLength ) {
+    uint64_t length = getUInt();
+
+    if( mFailed || length > (uint64_t)( mLength - mPosition ) ) {
+        mFailed = true;
+        *outLength = 0;
+        return NULL;
+        }
+
+    const unsigned char *bytes = &( mPayload[ mPosition ] );
+
+    mPosition += (int)length;
+    *outLength = (int)length;
+
+    return bytes;
+    }
+
+
+
+char *BinaryMessageReader::getString() {
+    int length;
+    const unsigned char *bytes = getBytes( &length );
+
+    if( bytes == NULL ) {
+        return NULL;
+        }
+
+    char *string = new char[ length + 1 ];
+    memcpy( string, bytes, length );
+    string[ length ] = '\0';
+
+    return string;
+    }
+
+
+
+char BinaryMessageReader::hasFailed() {
+    return mFailed;
+    }
+
+
+
+int BinaryMessageReader::getNumBytesLeft() {
+    return mLength - mPosition;
+    }
+
+
+
+BinaryFrameReceiver::BinaryFrameReceiver( int inMaxFrameLength )
+        : mMaxFrameLength( inMaxFrameLength ),
+          mBuffer( NULL ), mCapacity( 0 ),
+          mStart( 0 ), mEnd( 0 ),
+          mCorrupt( false ) {
+    }
+
+
+
+BinaryFrameReceiver::~BinaryFrameReceiver() {
+    if( mBuffer != NULL ) {
+        delete [] mBuffer;
+        }
+    }
+
+
+
+unsigned char *BinaryFrameReceiver::getReceiveSpace( int inMinBytes,
+                                                     int *outNumBytes ) {
+    int numWaiting = mEnd - mStart;
+
+    if( mStart > 0 ) {
+        // only part of a frame is left waiting, so this moves little
+        memmove( mBuffer, &( mBuffer[ mStart ] ), numWaiting );
+        mStart = 0;
+        mEnd = numWaiting;
+        }
+
+    if( mCapacity - mEnd < inMinBytes ) {
+        int newCapacity = 2 * mCapacity;
+        if( newCapacity < mEnd + inMinBytes ) {
+            newCapacity = mEnd + inMinBytes;
+            }
+
+        unsigned char *newBuffer = new unsigned char[ newCapacity ];
+
+        if( mBuffer != NULL ) {
+            memcpy( newBuffer, mBuffer, mEnd );
+            delete [] mBuffer;
+            }
+
+        mBuffer = newBuffer;
+        mCapacity = newCapacity;
+        }
+
+    *outNumBytes = mCapacity - mEnd;
+
+    return &( mBuffer[ mEnd ] );
+    }
+
+
+
+void BinaryFrameReceiver::commitReceived( int inNumBytes ) {
+    mEnd += inNumBytes;
+    }
+
+
+
+void BinaryFrameReceiver::feed( const unsigned char *inBytes,
+                                int inNumBytes ) {
+    int numBytes;
+    unsigned char *space = getReceiveSpace( inNumBytes, &numBytes );
+
+    memcpy( space, inBytes, inNumBytes );
+    commitReceived( inNumBytes );
+    }
+
+
+
+int BinaryFrameReceiver::nextFrame( const unsigned char **outPayload,
+                                    int *outLength ) {
+    if( mCorrupt ) {
+        return -1;
+        }
+    if( mStart == mEnd ) {
+        return 0;
+        }
+
+    uint64_t length;
+    int headerLength = readVarUInt( &( mBuffer[ mStart ] ), mEnd - mStart,
+                                    &length );
+
+    if( headerLength == 0 ) {
+        return 0;
+        }
+
+    if( headerLength < 0 || length > (uint64_t)mMaxFrameLength ) {
+        mCorrupt = true;
+        return -1;
+        }
+
+    if( (uint64_t)( mEnd - mStart - headerLength ) < length ) {
+        // rest of payload not here yet
+        return 0;
+        }
+
+    *outPayload = &( mBuffer[ mStart + headerLength ] );
+    *outLength = (int)length;
+
+    mStart += headerLength + (int)length;
+
+    return 1;
+    }
+
+
+
+int BinaryFrameReceiver::getNumBytesWaiting() {
+    return mEnd - mStart;
+    }
@@ -0,0 +1,347 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+#include "minorGems/common.h"
+
+
+
+#ifndef BINARY_FRAMING_INCLUDED
+#define BINARY_FRAMING_INCLUDED
+
+
+#include "minorGems/network/Socket.h"
+
+#include <stdint.h>
+
+
+
+/**
+ * Optional binary framing for connections that otherwise speak a
+ * #-terminated text protocol, for high-rate messages (like map and
+ * position updates) that shouldn't pay for ASCII parsing and a byte-by-byte
+ * search for the terminator.
+ *
+ * A frame is a varint payload length followed by the payload.  Payload
+ * fields are written and read in an order both sides agree on, with no
+ * tags:  unsigned and signed (zigzag) varints, fixed-size little-endian
+ * floats and doubles, and length-prefixed byte strings.
+ *
+ * Negotiated per connection:  one side sends BINARY_FRAMING_OFFER as a
+ * text message.  A side that understands it replies with
+ * BINARY_FRAMING_ACCEPT and sends frames from then on, and the offering
+ * side does the same once it reads the accept.  A side that doesn't
+ * understand the offer treats it like any unknown message, and the
+ * connection stays text.
+ *
+ * Any bytes read past the accept by a text reader (like
+ * BufferedInputStream) are the start of the first frame, and should be
+ * handed to BinaryFrameReceiver::feed.
+ */
+
+
+#define BINARY_FRAMING_OFFER "BINARY_FRAMING 1#"
+#define BINARY_FRAMING_ACCEPT "BINARY_FRAMING_OK 1#"
+
+
+// longest varint, for 64-bit values
+#define BINARY_FRAMING_MAX_VARINT_LENGTH 10
+
+
+
+/**
+ * Writes a varint.
+ *
+ * @param inValue the value.
+ * @param outBytes where value should be written.  Must have room for
+ *   BINARY_FRAMING_MAX_VARINT_LENGTH bytes.
+ *
+ * @return the number of bytes written.
+ */
+int writeVarUInt( uint64_t inValue, unsigned char *outBytes );
+
+
+/**
+ * Reads a varint.
+ *
+ * @param inBytes the bytes to read from.
+ * @param inNumBytes the number of bytes available.
+ * @param outValue pointer to where value should be returned.
+ *
+ * @return the number of bytes read, 0 if inBytes ends before the varint
+ *   does, or -1 if the varint is longer than any 64-bit value.
+ */
+int readVarUInt( const unsigned char *inBytes, int inNumBytes,
+                 uint64_t *outValue );
+
+
+
+/**
+ * Builds one message, and frames it for sending.
+ *
+ * Re-use one writer (see reset) for a stream of messages, so its buffer
+ * is only allocated once.
+ */
+class BinaryMessageWriter {
+
+    public:
+
+        BinaryMessageWriter( int inInitialCapacity = 256 );
+
+        ~BinaryMessageWriter();
+
+
+        // empties message, keeping buffer
+        void reset();
+
+
+        void putUInt( uint64_t inValue );
+
+        // zigzag encoded, so small negative values are short too
+        void putInt( int64_t inValue );
+
+        void putByte( unsigned char inValue );
+
+        void putFloat( float inValue );
+
+        void putDouble( double inValue );
+
+
+        // length-prefixed
+        // inBytes destroyed by caller
+        void putBytes( const unsigned char *inBytes, int inLength );
+
+        // length-prefixed, no terminating \0
+        // inString destroyed by caller if non-const
+        void putString( const char *inString );
+
+
+        int getPayloadLength();
+
+
+        /**
+         * Gets the framed message (length prefix and payload), in place,
+         * ready to send.
+         *
+         * @param outFrameLength pointer to where length of frame should
+         *   be returned.
+         *
+         * @return the frame.  Must NOT be destroyed by caller.
+         *   Valid until the next put or reset.
+         */
+        unsigned char *getFrame( int *outFrameLength );
+
+
+    protected:
+
+        // payload starts BINARY_FRAMING_MAX_VARINT_LENGTH bytes in,
+        // leaving room for getFrame to put length prefix right before it
+        unsigned char *mBuffer;
+        int mCapacity;
+        int mEnd;
+
+        // makes room for inNumBytes more at mEnd
+        void ensureRoom( int inNumBytes );
+    };
+
+
+
+/**
+ * Reads fields from one message's payload, in place.
+ *
+ * Reading past the end of the payload, or a malformed varint, marks the
+ * reader as failed, and all reads after that return 0 (or NULL).  So a
+ * message can be read in full and checked once at the end.
+ */
+class BinaryMessageReader {
+
+    public:
+
+        /**
+         * @param inPayload the payload.  Must be destroyed by caller after
+         *   this reader is done.
+         * @param inLength the length of the payload.
+         */
+        BinaryMessageReader( const unsigned char *inPayload, int inLength );
+
+
+        uint64_t getUInt();
+
+        int64_t getInt();
+
+        unsigned char getByte();
+
+        float getFloat();
+
+        double getDouble();
+
+
+        /**
+         * Gets a length-prefixed byte string, in place.
+         *
+         * @param outLength pointer to where length should be returned.
+         *
+         * @return pointer into payload, or NULL on failure.
+         *   Must NOT be destroyed by caller.
+         */
+        const unsigned char *getBytes( int *outLength );
+
+
+        /**
+         * Gets a length-prefixed string.
+         *
+         * @return a newly allocated \0-terminated string, or NULL on
+         *   failure.
+         *   Must be destroyed by caller if non-NULL.
+         */
+        char *getString();
+
+
+        char hasFailed();
+
+        int getNumBytesLeft();
+
+
+    protected:
+
+        const unsigned char *mPayload;
+        int mLength;
+        int mPosition;
+
+        char mFailed;
+
+        // checks that inNumBytes are left, failing if not
+        char haveBytes( int inNumBytes );
+    };
+
+
+
+/**
+ * Per-connection receive buffer that splits received bytes into frames.
+ *
+ * Bytes are received straight into the buffer, and frames are returned
+ * as pointers into it, so payloads are never copied.
+ *
+ * Usage with the game socket API:
+ *   int space;
+ *   unsigned char *buffer = receiver.getReceiveSpace( 4096, &space );
+ *   int numRead = readFromSocket( handle, buffer, space );
+ *   if( numRead > 0 ) {
+ *       receiver.commitReceived( numRead );
+ *       }
+ *   const unsigned char *payload;
+ *   int length;
+ *   while( receiver.nextFrame( &payload, &length ) == 1 ) {
+ *       BinaryMessageReader reader( payload, length );
+ *       ...
+ *       }
+ */
+class BinaryFrameReceiver {
+
+    public:
+
+        /**
+         * @param inMaxFrameLength the longest payload to accept.  A
+         *   longer length prefix is treated as a protocol error, rather
+         *   than a reason to allocate that much.  Defaults to 1 MiB.
+         */
+        BinaryFrameReceiver( int inMaxFrameLength = 1048576 );
+
+        ~BinaryFrameReceiver();
+
+
+        /**
+         * Gets space at the end of the buffer to receive into.
+         *
+         * Invalidates frames returned by nextFrame.
+         *
+         * @param inMinBytes the least space wanted.
+         * @param outNumBytes pointer to where amount of space (at least
+         *   inMinBytes) should be returned.
+         *
+         * @return the space.  Must NOT be destroyed by caller.
+         */
+        unsigned char *getReceiveSpace( int inMinBytes, int *outNumBytes );
+
+
+        // marks inNumBytes of receive space as filled
+        void commitReceived( int inNumBytes );
+
+
+        // copies bytes in, like receiving them
+        // inBytes destroyed by caller
+        void feed( const unsigned char *inBytes, int inNumBytes );
+
+
+        /**
+         * Receives whatever is waiting on a socket, without blocking.
+         *
+         * @param inSock the socket.  Must be destroyed by caller.
+         *
+         * @return the number of bytes received (maybe 0), or -1 on a
+         *   socket error.
+         */
+        int receiveFrom( Socket *inSock );
+
+
+        /**
+         * Gets the next complete frame's payload, in place.
+         *
+         * @param outPayload pointer to where payload should be returned.
+         *   Must NOT be destroyed by caller.  Valid until next
+         *   getReceiveSpace, feed, or receiveFrom.
+         * @param outLength pointer to where payload length should be
+         *   returned.
+         *
+         * @return 1 if a frame was returned, 0 if more bytes are needed,
+         *   or -1 if the stream is corrupt (bad or too-long length
+         *   prefix), after which the connection should be dropped.
+         */
+        int nextFrame( const unsigned char **outPayload, int *outLength );
+
+
+        // bytes received but not yet returned as frames
+        int getNumBytesWaiting();
+
+
+    protected:
+
+        int mMaxFrameLength;
+
+        unsigned char *mBuffer;
+        int mCapacity;
+
+        // waiting bytes are mBuffer[ mStart, mEnd )
+        int mStart;
+        int mEnd;
+
+        char mCorrupt;
+    };
+
+
+
+inline int BinaryFrameReceiver::receiveFrom( Socket *inSock ) {
+    int numBytes;
+    unsigned char *space = getReceiveSpace( 4096, &numBytes );
+
+    int numRead = inSock->receive( space, numBytes, 0 );
+
+    if( numRead == -2 ) {
+        // would block
+        return 0;
+        }
+    if( numRead < 0 ) {
+        return -1;
+        }
+
+    commitReceived( numRead );
+
+    return numRead;
+    }
+
+
+
+#endif
@@ -0,0 +1,429 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14   Jason Rohrer
+ * Created.
+ */
+
+
+
+#include "HostLookupPool.h"
+
+#include "minorGems/system/Thread.h"
+#include "minorGems/system/Time.h"
+#include "minorGems/util/stringUtils.h"
+
+
+
+// enough to overlap a burst of lookups without a crowd of threads
+#define HOST_LOOKUP_NUM_THREADS 4
+
+// oldest entries are dropped past this
+#define HOST_LOOKUP_MAX_CACHED 256
+
+
+
+class HostLookupWorker : public Thread {
+
+    public:
+
+        HostLookupWorker() {
+            start();
+            }
+
+        ~HostLookupWorker() {
+            join();
+            }
+
+
+        void run() {
+            HostLookupRequest *request;
+
+            while( ( request = HostLookupPool::getNextRequest() ) != NULL ) {
+
+                HostAddress *result =
+                    request->mAddress->getNumericalAddress();
+
+                HostLookupPool::finishRequest( request, result );
+
+                if( result != NULL ) {
+                    delete result;
+                    }
+                }
+            }
+
+    };
+
+
+
+typedef struct HostLookupCacheRecord {
+        // lower case
+        char *name;
+
+        // NULL for failed lookup
+        char *numericalName;
+
+        double expireTime;
+    } HostLookupCacheRecord;
+
+
+// protected by HostLookupPool::sLock
+static SimpleVector<HostLookupCacheRecord> cache;
+
+
+
+MutexLock HostLookupPool::sLock;
+
+BinarySemaphore HostLookupPool::sRequestSemaphore;
+
+SimpleVector<HostLookupRequest *> HostLookupPool::sPending;
+
+SimpleVector<HostLookupWorker *> HostLookupPool::sWorkers;
+
+char HostLookupPool::sStopping = false;
+
+int HostLookupPool::sCacheSeconds = 60;
+int HostLookupPool::sFailedCacheSeconds = 10;
+
+
+
+
+HostLookupRequest::HostLookupRequest( HostAddress *inAddress )
+        : mAddress( inAddress->copy() ), mResult( NULL ), mDone( false ),
+          mRefCount( 2 ) {
+    }
+
+
+
+HostLookupRequest::~HostLookupRequest() {
+    delete mAddress;
+
+    if( mResult != NULL ) {
+        delete mResult;
+        }
+    }
+
+
+
+char HostLookupRequest::isLookupDone() {
+    mLock.lock();
+    char done = mDone;
+    mLock.unlock();
+
+    return done;
+    }
+
+
+
+void HostLookupRequest::waitForLookup() {
+    if( isLookupDone() ) {
+        return;
+        }
+
+    mDoneSemaphore.wait();
+
+    // leave signaled for any later waits
+    mDoneSemaphore.signal();
+    }
+
+
+
+HostAddress *HostLookupRequest::getResult() {
+    mLock.lock();
+    HostAddress *result = NULL;
+
+    if( mResult != NULL ) {
+        result = mResult->copy();
+        }
+
+    mLock.unlock();
+
+    return result;
+    }
+
+
+
+void HostLookupRequest::release() {
+    mLock.lock();
+    mRefCount--;
+    int refCount = mRefCount;
+    mLock.unlock();
+
+    if( refCount == 0 ) {
+        delete this;
+        }
+    }
+
+
+
+void HostLookupRequest::finish( HostAddress *inResult ) {
+    mLock.lock();
+
+    if( inResult != NULL ) {
+        mResult = inResult->copy();
+        }
+    mDone = true;
+
+    mLock.unlock();
+
+    mDoneSemaphore.signal();
+
+    release();
+    }
+
+
+
+
+static void deleteCacheRecord( HostLookupCacheRecord *inRecord ) {
+    delete [] inRecord->name;
+
+    if( inRecord->numericalName != NULL ) {
+        delete [] inRecord->numericalName;
+        }
+    }
+
+
+
+char HostLookupPool::getCached( HostAddress *inAddress,
+                                HostAddress **outResult ) {
+
+    char *name = stringToLowerCase( inAddress->mAddressString );
+
+    double currentTime = Time::getCurrentTime();
+
+    char found = false;
+
+    for( int i=0; i<cache.size(); i++ ) {
+        HostLookupCacheRecord *r = cache.getElement( i );
+
+        if( r->expireTime < currentTime ) {
+            deleteCacheRecord( r );
+            cache.deleteElement( i );
+            i--;
+            continue;
+            }
+
+        if( strcmp( r->name, name ) == 0 ) {
+            found = true;
+
+            *outResult = NULL;
+
+            if( r->numericalName != NULL ) {
+                *outResult =
+                    new HostAddress( stringDuplicate( r->numericalName ),
+                                     inAddress->mPort );
+                }
+            break;
+            }
+        }
+
+    delete [] name;
+
+    return found;
+    }
+
+
+
+void HostLookupPool::startWorkers() {
+    if( sWorkers.size() > 0 ) {
+        return;
+        }
+
+    for( int i=0; i<HOST_LOOKUP_NUM_THREADS; i++ ) {
+        sWorkers.push_back( new HostLookupWorker() );
+        }
+    }
+
+
+
+HostLookupRequest *HostLookupPool::submit( HostAddress *inAddress ) {
+    HostLookupRequest *request = new HostLookupRequest( inAddress );
+
+    if( inAddress->isNumerical() ) {
+        request->finish( inAddress );
+        return request;
+        }
+
+
+    sLock.lock();
+
+    HostAddress *cachedResult;
+
+    if( getCached( inAddress, &cachedResult ) ) {
+        sLock.unlock();
+
+        request->finish( cachedResult );
+
+        if( cachedResult != NULL ) {
+            delete cachedResult;
+            }
+        return request;
+        }
+
+    startWorkers();
+
+    sPending.push_back( request );
+
+    sLock.unlock();
+
+    sRequestSemaphore.signal();
+
+    return request;
+    }
+
+
+
+HostAddress *HostLookupPool::lookup( HostAddress *inAddress ) {
+    HostLookupRequest *request = submit( inAddress );
+
+    request->waitForLookup();
+
+    HostAddress *result = request->getResult();
+
+    request->release();
+
+    return result;
+    }
+
+
+
+HostLookupRequest *HostLookupPool::getNextRequest() {
+    while( true ) {
+        sRequestSemaphore.wait();
+
+        sLock.lock();
+
+        if( sStopping ) {
+            sLock.unlock();
+
+            // pass stop on to next worker
+            sRequestSemaphore.signal();
+            return NULL;
+            }
+
+        if( sPending.size() > 0 ) {
+            HostLookupRequest *request = sPending.getElementDirect( 0 );
+            sPending.deleteElement( 0 );
+
+            if( sPending.size() > 0 ) {
+                // wake another worker for the rest
+                sRequestSemaphore.signal();
+                }
+
+            sLock.unlock();
+            return request;
+            }
+
+        // else a left-over signal
+        sLock.unlock();
+        }
+    }
+
+
+
+void HostLookupPool::finishRequest( HostLookupRequest *inRequest,
+                                    HostAddress *inResult ) {
+
+    sLock.lock();
+
+    int lifetime = sCacheSeconds;
+    if( inResult == NULL ) {
+        lifetime = sFailedCacheSeconds;
+        }
+
+    if( lifetime > 0 ) {
+        char *name =
+            stringToLowerCase( inRequest->mAddress->mAddressString );
+
+        // replace any record left by another request for same name
+        for( int i=0; i<cache.size(); i++ ) {
+            HostLookupCacheRecord *r = cache.getElement( i );
+
+            if( strcmp( r->name, name ) == 0 ) {
+                deleteCacheRecord( r );
+                cache.deleteElement( i );
+                break;
+                }
+            }
+
+        if( cache.size() >= HOST_LOOKUP_MAX_CACHED ) {
+            deleteCacheRecord( cache.getElement( 0 ) );
+            cache.deleteElement( 0 );
+            }
+
+        HostLookupCacheRecord r;
+        r.name = name;
+        r.numericalName = NULL;
+
+        if( inResult != NULL ) {
+            r.numericalName = stringDuplicate( inResult->mAddressString );
+            }
+
+        r.expireTime = Time::getCurrentTime() + lifetime;
+
+        cache.push_back( r );
+        }
+
+    sLock.unlock();
+
+    inRequest->finish( inResult );
+    }
+
+
+
+void HostLookupPool::setCacheLifetimes( int inSeconds,
+                                        int inFailedSeconds ) {
+    sLock.lock();
+    sCacheSeconds = inSeconds;
+    sFailedCacheSeconds = inFailedSeconds;
+    sLock.unlock();
+    }
+
+
+
+void HostLookupPool::clearCache() {
+    sLock.lock();
+
+    for( int i=0; i<cache.size(); i++ ) {
+        deleteCacheRecord( cache.getElement( i ) );
+        }
+    cache.deleteAll();
+
+    sLock.unlock();
+    }
+
+
+
+void HostLookupPool::shutdown() {
+    sLock.lock();
+    sStopping = true;
+
+    int numWorkers = sWorkers.size();
+
+    sLock.unlock();
+
+
+    // each worker passes this on before exiting
+    sRequestSemaphore.signal();
+
+    // destructors join
+    for( int i=0; i<numWorkers; i++ ) {
+        delete sWorkers.getElementDirect( i );
+        }
+
+
+    sLock.lock();
+
+    sWorkers.deleteAll();
+
+    for( int i=0; i<sPending.size(); i++ ) {
+        sPending.getElementDirect( i )->finish( NULL );
+        }
+    sPending.deleteAll();
+
+    sStopping = false;
+
+    sLock.unlock();
+
+    clearCache();
+    }
@@ -0,0 +1,221 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14   Jason Rohrer
+ * Created.
+ */
+
+
+
+#ifndef HOST_LOOKUP_POOL_INCLUDED
+#define HOST_LOOKUP_POOL_INCLUDED
+
+
+#include "minorGems/network/HostAddress.h"
+#include "minorGems/system/MutexLock.h"
+#include "minorGems/system/BinarySemaphore.h"
+#include "minorGems/util/SimpleVector.h"
+
+
+class HostLookupWorker;
+
+
+/**
+ * A pending lookup submitted to HostLookupPool.
+ *
+ * Thread-safe.
+ *
+ * @author Jason Rohrer
+ */
+class HostLookupRequest {
+
+    public:
+
+        /**
+         * Returns true if lookup done.
+         */
+        char isLookupDone();
+
+
+
+        /**
+         * Blocks until lookup is done.
+         */
+        void waitForLookup();
+
+
+
+        /**
+         * Returns numerical address result, or NULL if lookup failed
+         * (or is not done yet).
+         *
+         * Must be destroyed by caller if non-NULL.
+         */
+        HostAddress *getResult();
+
+
+
+        /**
+         * Called by submitter when done with this request, in place of
+         * delete.  Request may still be pending, in which case its
+         * result is thrown away when done (but still cached).
+         */
+        void release();
+
+
+
+    protected:
+
+        friend class HostLookupPool;
+        friend class HostLookupWorker;
+
+
+        // copies inAddress
+        HostLookupRequest( HostAddress *inAddress );
+
+        ~HostLookupRequest();
+
+
+        // sets result (which is copied), marks done, and drops the
+        // pool's reference
+        void finish( HostAddress *inResult );
+
+
+        HostAddress *mAddress;
+
+        HostAddress *mResult;
+
+        char mDone;
+
+        // one for submitter, one for pool while pending
+        int mRefCount;
+
+        MutexLock mLock;
+
+        BinarySemaphore mDoneSemaphore;
+
+    };
+
+
+
+/**
+ * Shared pool of threads that look up host names, with a cache of
+ * recent results.
+ *
+ * Replaces a thread (or a blocking, locked lookup) per name, so that a
+ * burst of lookups at startup runs a few at a time instead of one at a
+ * time, and repeated lookups of the same host are answered immediately.
+ *
+ * Threads are started on first use.
+ *
+ * The platform resolver (getaddrinfo) doesn't report record TTLs, so
+ * cached results expire after a fixed lifetime instead (see
+ * setCacheLifetimes).  System-level resolver caches still honor the
+ * real TTLs underneath.
+ *
+ * All functions are thread-safe.
+ *
+ * @author Jason Rohrer
+ */
+class HostLookupPool {
+
+    public:
+
+
+        /**
+         * Starts a lookup.
+         *
+         * @param inAddress the address to lookup.  Destroyed by caller,
+         *   copied internally.
+         *
+         * @return a request, which must be released by caller with
+         *   HostLookupRequest::release.
+         *   Already done if inAddress is numerical or was in cache.
+         */
+        static HostLookupRequest *submit( HostAddress *inAddress );
+
+
+
+        /**
+         * Looks up an address through the pool, blocking until done.
+         *
+         * @param inAddress the address to lookup.  Destroyed by caller.
+         *
+         * @return numerical address, or NULL if lookup failed.
+         *   Must be destroyed by caller if non-NULL.
+         */
+        static HostAddress *lookup( HostAddress *inAddress );
+
+
+
+        /**
+         * Sets how long results are cached.
+         *
+         * @param inSeconds lifetime of successful lookups.  Defaults
+         *   to 60.  0 disables caching.
+         * @param inFailedSeconds lifetime of failed lookups.  Defaults
+         *   to 10.
+         */
+        static void setCacheLifetimes( int inSeconds, int inFailedSeconds );
+
+
+
+        // empties the cache
+        static void clearCache();
+
+
+
+        /**
+         * Stops and joins pool threads and empties the cache.
+         *
+         * Requests still pending are finished as failed.
+         * Pool restarts if used again.
+         */
+        static void shutdown();
+
+
+
+    protected:
+
+        friend class HostLookupWorker;
+
+
+        // returns NULL when worker should exit
+        static HostLookupRequest *getNextRequest();
+
+        // caches and finishes request
+        static void finishRequest( HostLookupRequest *inRequest,
+                                   HostAddress *inResult );
+
+
+        // must be called with sLock locked
+        static void startWorkers();
+
+        // must be called with sLock locked
+        // returns true if found, with outResult set to a copy of the
+        // cached result (or NULL for cached failure)
+        static char getCached( HostAddress *inAddress,
+                               HostAddress **outResult );
+
+
+        static MutexLock sLock;
+
+        // wakes one worker, which passes it on if more requests are
+        // pending (a BinarySemaphore can't count several signals, and
+        // our Semaphore loses wake-ups with several threads waiting)
+        static BinarySemaphore sRequestSemaphore;
+
+        static SimpleVector<HostLookupRequest *> sPending;
+
+        static SimpleVector<HostLookupWorker *> sWorkers;
+
+        static char sStopping;
+
+        static int sCacheSeconds;
+        static int sFailedCacheSeconds;
+
+    };
+
+
+
+#endif
@@ -6,6 +6,11 @@
  *
  * 2004-January-27		Jason Rohrer
  * Changed to support externally-specified file name prefixes.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Data copied into a ring buffer and written by a background thread, so
+ * logging doesn't change socket timing.
+ * One log with timestamped, direction-marked records, rotated by size.
  */
 
 #include "minorGems/common.h"
@@ -17,22 +22,60 @@
 #include "SocketStream.h"
 
 #include "minorGems/util/stringUtils.h"
+#include "minorGems/system/Thread.h"
+#include "minorGems/system/MutexLock.h"
+#include "minorGems/system/BinarySemaphore.h"
+#include "minorGems/system/Time.h"
 
 
 #include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+
+
+// default ring buffer size, in bytes
+#define LOGGING_SOCKET_STREAM_RING_SIZE 1048576
+
+// longest that logged data waits in the ring
+#define LOGGING_SOCKET_STREAM_FLUSH_MS 200
+
+
+
+// precedes each chunk of data in the ring
+typedef struct LoggedChunkHeader {
+        char inbound;
+        time_t time;
+        unsigned long milliseconds;
+        long length;
+    } LoggedChunkHeader;
+
+
+
+class LoggingSocketStreamWriter;
 
 
 
 /**
  * A SocketStream that logs inbound and outbound data.
  *
+ * Reads and writes only copy data into an in-memory ring buffer.  A
+ * background thread writes the ring out to <prefix>.log, with each chunk
+ * of data preceded by a line like:
+ *
+ *   2026-10-15 12:34:56.789 in 42 bytes
+ *
+ * and followed by a newline.  If the ring fills up (because the disk
+ * can't keep up), data is dropped rather than slowing the socket, and a
+ * line noting how much was dropped is logged in its place.
+ *
  * @author Jason Rohrer
- */ 
+ */
 class LoggingSocketStream : public SocketStream {
 
     public:
-        
-        
+
+
         /**
          * Constructs a SocketStream.
          *
@@ -40,42 +83,123 @@ class LoggingSocketStream : public SocketStream {
          *   inSocket is NOT destroyed when the stream is destroyed.
          * @param inEnableInboundLog set to true to enable inbound logging.
          * @param inEnableOutboundLog set to true to enable outbound logging.
-         * @param inLogSizeLimit the size limit of each log (both inbound
-         *   and outbound), in bytes.
-         *   Logging will stop after inLogSizeLimit bytes have been
-         *   written to each log.
+         * @param inLogSizeLimit the size limit of the log, in bytes.
+         *   When the log reaches this size, it is moved to <prefix>.log.1
+         *   (replacing any older one) and a new log is started, so at most
+         *   twice this much is kept on disk.
          * @param inLogNamePrefix a string that will be used to name
-         *   the log files (appending .in and .out for the two logs).
+         *   the log file (appending .log).
          *   Should be unique.
          *   Must be destroyed by caller.
+         * @param inRingSize the size of the ring buffer, in bytes.
+         *   Defaults to LOGGING_SOCKET_STREAM_RING_SIZE.
          */
         LoggingSocketStream( Socket *inSocket, char inEnableInboundLog,
                              char inEnableOutboundLog,
                              unsigned long inLogSizeLimit,
-                             char *inLogNamePrefix );
+                             char *inLogNamePrefix,
+                             int inRingSize =
+                             LOGGING_SOCKET_STREAM_RING_SIZE );
 
-        
+
+        // writes everything still in the ring before returning
         virtual ~LoggingSocketStream();
-        
-        
-        
+
+
+
         // overrides the SocketStream implementations
 
         long read( unsigned char *inBuffer, long inNumBytes );
 
+        long readAvailable( unsigned char *inBuffer, long inMaxBytes );
+
         long write( unsigned char *inBuffer, long inNumBytes );
-        
-        
+
+
     protected:
+
+        friend class LoggingSocketStreamWriter;
+
         char mEnableInboundLog;
         char mEnableOutboundLog;
         unsigned long mLogSizeLimit;
-        FILE *mInboundLogFile;
-        FILE *mOutboundLogFile;
-        unsigned long mInboundSizeSoFar;
-        unsigned long mOutboundSizeSoFar;
-        
-    };        
+
+        char *mLogFileName;
+        char *mOldLogFileName;
+
+
+        // protects ring, and values below up to writer-only ones
+        MutexLock mRingLock;
+
+        unsigned char *mRing;
+        int mRingSize;
+        int mRingStart;
+        int mRingUsed;
+
+        // data that didn't fit in ring since writer last took it
+        unsigned long mDroppedBytes;
+
+        // true if writer has been woken since it last took ring
+        char mWakeSent;
+
+        char mStopping;
+
+        BinarySemaphore mWakeSemaphore;
+
+        LoggingSocketStreamWriter *mWriter;
+
+
+        // for writer thread only
+        FILE *mLogFile;
+        unsigned long mLogFileSize;
+        unsigned char *mWriteBuffer;
+
+
+        // copies a chunk into the ring, or counts it as dropped
+        void logData( char inInbound, unsigned char *inData, long inLength );
+
+        // copies into ring at end of used part, wrapping around
+        // mRingLock must be locked
+        void copyIntoRing( void *inData, int inLength );
+
+
+        // runs writer thread until stopped
+        void writerLoop();
+
+        // takes and writes everything in ring
+        void writeRing();
+
+        // writes bytes to log, rotating it if it's full
+        void writeToLog( const void *inData, int inLength );
+
+        void rotateLog();
+    };
+
+
+
+class LoggingSocketStreamWriter : public Thread {
+
+    public:
+
+        LoggingSocketStreamWriter( LoggingSocketStream *inStream )
+                : mStream( inStream ) {
+            start();
+            }
+
+        ~LoggingSocketStreamWriter() {
+            join();
+            }
+
+
+        void run() {
+            mStream->writerLoop();
+            }
+
+
+    protected:
+
+        LoggingSocketStream *mStream;
+    };
 
 
 
@@ -84,45 +208,271 @@ inline LoggingSocketStream::LoggingSocketStream(
     char inEnableInboundLog,
     char inEnableOutboundLog,
     unsigned long inLogSizeLimit,
-    char *inLogNamePrefix ) 
+    char *inLogNamePrefix,
+    int inRingSize )
     : SocketStream( inSocket ),
       mEnableInboundLog( inEnableInboundLog ),
       mEnableOutboundLog( inEnableOutboundLog ),
       mLogSizeLimit( inLogSizeLimit ),
-      mInboundLogFile( NULL ),
-      mOutboundLogFile( NULL ),
-      mInboundSizeSoFar( 0 ),
-      mOutboundSizeSoFar( 0 ) {
+      mLogFileName( NULL ),
+      mOldLogFileName( NULL ),
+      mRing( NULL ),
+      mRingSize( inRingSize ),
+      mRingStart( 0 ),
+      mRingUsed( 0 ),
+      mDroppedBytes( 0 ),
+      mWakeSent( false ),
+      mStopping( false ),
+      mWriter( NULL ),
+      mLogFile( NULL ),
+      mLogFileSize( 0 ),
+      mWriteBuffer( NULL ) {
+
+    if( ! mEnableInboundLog && ! mEnableOutboundLog ) {
+        return;
+        }
 
-    if( mEnableInboundLog ) {
-        char *inboundFileName = autoSprintf( "%s.in", inLogNamePrefix );
+    mLogFileName = autoSprintf( "%s.log", inLogNamePrefix );
+    mOldLogFileName = autoSprintf( "%s.log.1", inLogNamePrefix );
 
-        mInboundLogFile = fopen( inboundFileName, "wb" );
+    mLogFile = fopen( mLogFileName, "wb" );
 
-        delete [] inboundFileName;
+    if( mLogFile == NULL ) {
+        return;
         }
-    if( mEnableOutboundLog ) {
 
-        char *outboundFileName = autoSprintf( "%s.out", inLogNamePrefix );
+    mRing = new unsigned char[ mRingSize ];
+    mWriteBuffer = new unsigned char[ mRingSize ];
 
-        mOutboundLogFile = fopen( outboundFileName, "wb" );
-        
-        delete [] outboundFileName;
-        }
-    
+    mWriter = new LoggingSocketStreamWriter( this );
     }
 
 
 
 inline LoggingSocketStream::~LoggingSocketStream() {
-    if( mInboundLogFile != NULL ) {
-        fclose( mInboundLogFile );
-        mInboundLogFile = NULL;
+    if( mWriter != NULL ) {
+        mRingLock.lock();
+        mStopping = true;
+        mRingLock.unlock();
+
+        mWakeSemaphore.signal();
+
+        // joins, after writer drains ring
+        delete mWriter;
+        mWriter = NULL;
+        }
+
+    if( mLogFile != NULL ) {
+        fclose( mLogFile );
+        mLogFile = NULL;
+        }
+
+    if( mRing != NULL ) {
+        delete [] mRing;
+        delete [] mWriteBuffer;
+        }
+    if( mLogFileName != NULL ) {
+        delete [] mLogFileName;
+        delete [] mOldLogFileName;
+        }
+    }
+
+
+
+inline void LoggingSocketStream::copyIntoRing( void *inData, int inLength ) {
+    int end = ( mRingStart + mRingUsed ) % mRingSize;
+
+    int firstPart = mRingSize - end;
+    if( firstPart > inLength ) {
+        firstPart = inLength;
+        }
+
+    memcpy( &( mRing[ end ] ), inData, firstPart );
+
+    if( firstPart < inLength ) {
+        memcpy( mRing, &( ( (unsigned char *)inData )[ firstPart ] ),
+                inLength - firstPart );
+        }
+
+    mRingUsed += inLength;
+    }
+
+
+
+inline void LoggingSocketStream::logData( char inInbound,
+                                          unsigned char *inData,
+                                          long inLength ) {
+    if( mWriter == NULL || inLength <= 0 ) {
+        return;
+        }
+
+    LoggedChunkHeader header;
+    header.inbound = inInbound;
+    header.length = inLength;
+
+    timeSec_t seconds;
+    Time::getCurrentTime( &seconds, &( header.milliseconds ) );
+    header.time = time( NULL );
+
+
+    int totalLength = sizeof( header ) + inLength;
+
+    char wake = false;
+
+    mRingLock.lock();
+
+    if( mRingUsed + totalLength <= mRingSize ) {
+        copyIntoRing( &header, sizeof( header ) );
+        copyIntoRing( inData, inLength );
+        }
+    else {
+        mDroppedBytes += inLength;
+        }
+
+    // wake writer early once half full
+    if( ! mWakeSent && mRingUsed > mRingSize / 2 ) {
+        mWakeSent = true;
+        wake = true;
+        }
+
+    mRingLock.unlock();
+
+    if( wake ) {
+        mWakeSemaphore.signal();
+        }
+    }
+
+
+
+inline void LoggingSocketStream::writerLoop() {
+    while( true ) {
+        mWakeSemaphore.wait( LOGGING_SOCKET_STREAM_FLUSH_MS );
+
+        mRingLock.lock();
+        char stopping = mStopping;
+        mRingLock.unlock();
+
+        // if stopping, stream isn't being used anymore, so this gets
+        // everything
+        writeRing();
+
+        if( stopping ) {
+            return;
+            }
+        }
+    }
+
+
+
+inline void LoggingSocketStream::writeRing() {
+    mRingLock.lock();
+
+    int used = mRingUsed;
+
+    int firstPart = mRingSize - mRingStart;
+    if( firstPart > used ) {
+        firstPart = used;
+        }
+    memcpy( mWriteBuffer, &( mRing[ mRingStart ] ), firstPart );
+    memcpy( &( mWriteBuffer[ firstPart ] ), mRing, used - firstPart );
+
+    mRingStart = 0;
+    mRingUsed = 0;
+
+    unsigned long dropped = mDroppedBytes;
+    mDroppedBytes = 0;
+
+    mWakeSent = false;
+
+    mRingLock.unlock();
+
+
+    if( mLogFile == NULL ) {
+        return;
+        }
+
+
+    int pos = 0;
+
+    while( pos < used ) {
+        LoggedChunkHeader header;
+        memcpy( &header, &( mWriteBuffer[ pos ] ), sizeof( header ) );
+        pos += sizeof( header );
+
+        struct tm timeStruct;
+
+        #ifdef WIN_32
+        localtime_s( &timeStruct, &( header.time ) );
+        #else
+        localtime_r( &( header.time ), &timeStruct );
+        #endif
+
+        char dateString[ 32 ];
+        strftime( dateString, sizeof( dateString ), "%Y-%m-%d %H:%M:%S",
+                  &timeStruct );
+
+        const char *direction = "out";
+        if( header.inbound ) {
+            direction = "in";
+            }
+
+        char line[ 96 ];
+        int lineLength = snprintf( line, sizeof( line ),
+                                   "%s.%03lu %s %ld bytes\n",
+                                   dateString, header.milliseconds,
+                                   direction, header.length );
+
+        writeToLog( line, lineLength );
+        writeToLog( &( mWriteBuffer[ pos ] ), header.length );
+        writeToLog( "\n", 1 );
+
+        pos += header.length;
+        }
+
+    if( dropped > 0 ) {
+        char line[ 96 ];
+        int lineLength = snprintf( line, sizeof( line ),
+                                   "dropped %lu bytes (log buffer full)\n",
+                                   dropped );
+        writeToLog( line, lineLength );
+        }
+
+    if( mLogFile != NULL ) {
+        fflush( mLogFile );
+        }
+    }
+
+
+
+inline void LoggingSocketStream::writeToLog( const void *inData,
+                                             int inLength ) {
+    if( mLogFile == NULL ) {
+        return;
         }
-    if( mOutboundLogFile != NULL ) {
-        fclose( mOutboundLogFile );
-        mOutboundLogFile = NULL;
+
+    if( mLogFileSize > 0 && mLogFileSize + inLength > mLogSizeLimit ) {
+        rotateLog();
+
+        if( mLogFile == NULL ) {
+            return;
+            }
         }
+
+    fwrite( inData, 1, inLength, mLogFile );
+    mLogFileSize += inLength;
+    }
+
+
+
+inline void LoggingSocketStream::rotateLog() {
+    fclose( mLogFile );
+
+    // rename fails on Windows if destination exists
+    remove( mOldLogFileName );
+    rename( mLogFileName, mOldLogFileName );
+
+    mLogFile = fopen( mLogFileName, "wb" );
+    mLogFileSize = 0;
     }
 
 
@@ -131,51 +481,40 @@ inline long LoggingSocketStream::read( unsigned char *inBuffer,
                                        long inNumBytes ) {
     long returnVal = SocketStream::read( inBuffer, inNumBytes );
 
-    if( mEnableInboundLog &&
-        mInboundSizeSoFar < mLogSizeLimit &&
-        returnVal == inNumBytes ) {
+    if( mEnableInboundLog ) {
+        logData( true, inBuffer, returnVal );
+        }
 
-        int numToLog = inNumBytes;
-        if( mInboundSizeSoFar + numToLog > mLogSizeLimit ) {
-            numToLog = mLogSizeLimit - mInboundSizeSoFar;
-            }
-        
-        if( mInboundLogFile != NULL ) {
-            fwrite( inBuffer, 1, numToLog, mInboundLogFile );
-            fflush( mInboundLogFile );
-            }
-        mInboundSizeSoFar += numToLog;
+    return returnVal;
+    }
+
+
+
+inline long LoggingSocketStream::readAvailable( unsigned char *inBuffer,
+                                                long inMaxBytes ) {
+    long returnVal = SocketStream::readAvailable( inBuffer, inMaxBytes );
+
+    if( mEnableInboundLog ) {
+        logData( true, inBuffer, returnVal );
         }
-    
-    return returnVal;    
+
+    return returnVal;
     }
-        
-        
+
+
 
 inline long LoggingSocketStream::write( unsigned char *inBuffer,
                                         long inNumBytes ) {
 
     long returnVal = SocketStream::write( inBuffer, inNumBytes );
-        
-    if( mEnableOutboundLog &&
-        mOutboundSizeSoFar < mLogSizeLimit &&
-        returnVal == inNumBytes ) {
-
-        int numToLog = inNumBytes;
-        if( mOutboundSizeSoFar + numToLog > mLogSizeLimit ) {
-            numToLog = mLogSizeLimit - mOutboundSizeSoFar;
-            }
-        
-        if( mOutboundLogFile != NULL ) {
-            fwrite( inBuffer, 1, numToLog, mOutboundLogFile );
-            fflush( mOutboundLogFile );
-            }
-        mOutboundSizeSoFar += numToLog;
+
+    if( mEnableOutboundLog ) {
+        logData( false, inBuffer, returnVal );
         }
-    
-    return returnVal;    
+
+    return returnVal;
     }
-    
-    
-    
+
+
+
 #endif
@@ -9,6 +9,10 @@
  *
  * 2009-February-14   Jason Rohrer
  * Changed to copy inAddress internally.
+ *
+ * 2026-October-14   Jason Rohrer
+ * Changed to submit to HostLookupPool instead of running a thread per
+ * lookup.
  */
 
 
@@ -16,59 +20,21 @@
 
 
 LookupThread::LookupThread( HostAddress *inAddress )
-        : mAddress( inAddress->copy() ), mNumericalAddress( NULL ),
-          mLookupDone( false ) {
-
-    start();
+        : mRequest( HostLookupPool::submit( inAddress ) ) {
     }
 
 
 LookupThread::~LookupThread() {
-    join();
-    
-    delete mAddress;
-    
-    if( mNumericalAddress != NULL ) {
-        delete mNumericalAddress;
-        }
+    mRequest->release();
     }
 
 
 char LookupThread::isLookupDone() {
-    mLock.lock();
-    char done = mLookupDone;
-    mLock.unlock();
-    
-    return done;
+    return mRequest->isLookupDone();
     }
 
 
 
 HostAddress *LookupThread::getResult() {
-    mLock.lock();
-    HostAddress *result = NULL;
-    
-    if( mNumericalAddress != NULL ) {
-        result = mNumericalAddress->copy();
-        }
-    
-    mLock.unlock();
-    
-
-    return result;
-    }
-
-
-
-void LookupThread::run() {
-    
-    HostAddress *numAddress = mAddress->getNumericalAddress();
-    
-
-    mLock.lock();        
-    mLookupDone = true;
-    mNumericalAddress = numAddress;
-    mLock.unlock();
-
-    setFinished();
+    return mRequest->getResult();
     }
@@ -9,6 +9,10 @@
  *
  * 2009-February-14   Jason Rohrer
  * Changed to copy inAddress internally.
+ *
+ * 2026-October-14   Jason Rohrer
+ * Changed to submit to HostLookupPool instead of running a thread per
+ * lookup.
  */
 
 
@@ -16,23 +20,24 @@
 #ifndef LOOKUP_THREAD_CLASS_INCLUDED
 #define LOOKUP_THREAD_CLASS_INCLUDED
 
-#include "minorGems/system/FinishedSignalThread.h"
-#include "minorGems/system/MutexLock.h"
-
 #include "minorGems/network/HostAddress.h"
+#include "minorGems/network/HostLookupPool.h"
 
 
 
 /**
- * Thread that performs DNS lookup on a host name.
+ * Performs DNS lookup on a host name.
+ *
+ * No longer a thread of its own (name kept for existing callers), but a
+ * wrapper for a request handled by the shared HostLookupPool.
  *
  * @author Jason Rohrer
  */
-class LookupThread : public FinishedSignalThread {
+class LookupThread {
 	
 	public:
 		/**
-         * Constructs and starts a lookup thread.
+         * Constructs and starts a lookup.
          *
 		 * @param inAddress the address to lookup.  Destroyed by caller,
          *   copied internally.
@@ -40,7 +45,7 @@ class LookupThread : public FinishedSignalThread {
 		LookupThread( HostAddress *inAddress );
         
         
-        // joins and destroys this thread
+        // does not block, even if lookup still pending
         ~LookupThread();
         
 		
@@ -60,20 +65,9 @@ class LookupThread : public FinishedSignalThread {
         HostAddress *getResult();
 
         
-
-		// override the run method from Thread
-		void run();
 	
 	private:
-        MutexLock mLock;
-        
-        HostAddress *mAddress;
-        
-        HostAddress *mNumericalAddress;
-        
-        char mLookupDone;
-                
-        
+        HostLookupRequest *mRequest;
         
 	};
 
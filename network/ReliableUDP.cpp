@@ -0,0 +1,1201 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+
+
+#include "ReliableUDP.h"
+
+#include "minorGems/system/Time.h"
+
+#include <string.h>
+
+
+
+// wait this long for more messages to piggyback an ack on before sending
+// one by itself
+#define ACK_DELAY 0.005
+
+// send something at least this often, so peer doesn't time out
+#define KEEP_ALIVE_INTERVAL 1.0
+
+// packets acked after a packet that make it count as lost
+#define REORDER_THRESHOLD 3
+
+#define MIN_RETRANSMIT_TIMEOUT 0.05
+#define MAX_RETRANSMIT_TIMEOUT 10.0
+
+#define MIN_CONGESTION_WINDOW ( 2 * RELIABLE_UDP_MAX_PACKET_LENGTH )
+#define INITIAL_CONGESTION_WINDOW ( 4 * RELIABLE_UDP_MAX_PACKET_LENGTH )
+
+// pace at a bit more than cwnd per round trip, so pacing doesn't limit
+// throughput on its own
+#define PACING_GAIN 1.25
+
+// how far ahead of its pacing time a packet may go, so a burst of
+// packets can go out in one update instead of one per update
+#define PACING_QUANTUM 0.002
+
+// datagrams per batch send or receive
+#define ENDPOINT_BATCH_SIZE 64
+
+
+
+static void writeUInt16( unsigned char *outBytes, uint16_t inValue ) {
+    outBytes[0] = (unsigned char)( inValue );
+    outBytes[1] = (unsigned char)( inValue >> 8 );
+    }
+
+
+static void writeUInt32( unsigned char *outBytes, uint32_t inValue ) {
+    for( int i=0; i<4; i++ ) {
+        outBytes[i] = (unsigned char)( inValue >> ( 8 * i ) );
+        }
+    }
+
+
+static uint16_t readUInt16( const unsigned char *inBytes ) {
+    return (uint16_t)( inBytes[0] | ( inBytes[1] << 8 ) );
+    }
+
+
+static uint32_t readUInt32( const unsigned char *inBytes ) {
+    uint32_t value = 0;
+    for( int i=0; i<4; i++ ) {
+        value |= (uint32_t)inBytes[i] << ( 8 * i );
+        }
+    return value;
+    }
+
+
+
+// how far inA is after inB, with wrap-around (negative if before)
+static int sequenceDiff( uint16_t inA, uint16_t inB ) {
+    return (int16_t)( (uint16_t)( inA - inB ) );
+    }
+
+
+
+static char hasProtocolID( const unsigned char *inData, int inLength,
+                           uint32_t inProtocolID ) {
+    return inLength >= RELIABLE_UDP_PACKET_HEADER_LENGTH &&
+        readUInt32( inData ) == inProtocolID;
+    }
+
+
+
+ReliableUDPConnection::ReliableUDPConnection(
+    struct UDPAddress *inAddress,
+    uint32_t inProtocolID,
+    int inNumChannels,
+    ReliableUDPChannelType *inChannelTypes,
+    double inTime )
+        : mProtocolID( inProtocolID ),
+          mNumChannels( inNumChannels ),
+          mNextDelivery( 0 ),
+          mNextSequence( 0 ),
+          mOldestInFlight( 0 ),
+          mLargestAcked( 0 ),
+          mAnyAcked( false ),
+          mBytesInFlight( 0 ),
+          mLatestReceived( 0 ),
+          mReceivedBits( 0 ),
+          mAnyReceived( false ),
+          mAckPending( false ),
+          mAckPendingTime( inTime ),
+          mLastReceiveTime( inTime ),
+          mLastSendTime( inTime ),
+          mSmoothedRTT( 0.1 ),
+          mRTTVariance( 0.05 ),
+          mHaveRTTSample( false ),
+          mTimeoutBackoff( 1 ),
+          mCongestionWindow( INITIAL_CONGESTION_WINDOW ),
+          mSlowStartThreshold( 1e9 ),
+          mRecoveryStartTime( inTime - 1 ),
+          mPacingNextTime( inTime ),
+          mNumPacketsSent( 0 ),
+          mNumPacketsLost( 0 ),
+          mLastLossCheckTime( inTime ),
+          mNextReliableChannel( 0 ) {
+
+    mAddress = *inAddress;
+
+    if( mNumChannels > RELIABLE_UDP_MAX_CHANNELS ) {
+        mNumChannels = RELIABLE_UDP_MAX_CHANNELS;
+        }
+
+    for( int c=0; c<mNumChannels; c++ ) {
+        ReliableUDPChannel *channel = &( mChannels[c] );
+
+        channel->type = inChannelTypes[c];
+        channel->nextSendID = 0;
+        channel->receiveBaseID = 0;
+        channel->receivedAny = false;
+        channel->receiveWindow = NULL;
+
+        if( channel->type != RELIABLE_UDP_UNRELIABLE_SEQUENCED ) {
+            channel->receiveWindow =
+                new ReliableUDPMessage[ RELIABLE_UDP_MESSAGE_WINDOW ];
+
+            for( int i=0; i<RELIABLE_UDP_MESSAGE_WINDOW; i++ ) {
+                channel->receiveWindow[i].data = NULL;
+                channel->receiveWindow[i].done = false;
+                }
+            }
+        }
+
+    for( int i=0; i<RELIABLE_UDP_PACKET_WINDOW; i++ ) {
+        mSentPackets[i].sequence = 0;
+        mSentPackets[i].inFlight = false;
+        // nothing to ack until sent
+        mSentPackets[i].acked = true;
+        }
+    }
+
+
+
+ReliableUDPConnection::~ReliableUDPConnection() {
+    for( int c=0; c<mNumChannels; c++ ) {
+        ReliableUDPChannel *channel = &( mChannels[c] );
+
+        for( int i=0; i<channel->sendQueue.size(); i++ ) {
+            unsigned char *data =
+                channel->sendQueue.getElement( i )->data;
+            if( data != NULL ) {
+                delete [] data;
+                }
+            }
+
+        if( channel->receiveWindow != NULL ) {
+            for( int i=0; i<RELIABLE_UDP_MESSAGE_WINDOW; i++ ) {
+                if( channel->receiveWindow[i].data != NULL ) {
+                    delete [] channel->receiveWindow[i].data;
+                    }
+                }
+            delete [] channel->receiveWindow;
+            }
+        }
+
+    for( int i=mNextDelivery; i<mDeliveries.size(); i++ ) {
+        delete [] mDeliveries.getElement( i )->data;
+        }
+    }
+
+
+
+struct UDPAddress *ReliableUDPConnection::getAddress() {
+    return &mAddress;
+    }
+
+
+
+char ReliableUDPConnection::send( int inChannel, const unsigned char *inData,
+                                  int inLength ) {
+    if( inChannel < 0 || inChannel >= mNumChannels ||
+        inLength < 0 || inLength > RELIABLE_UDP_MAX_MESSAGE_LENGTH ) {
+        return false;
+        }
+
+    ReliableUDPChannel *channel = &( mChannels[ inChannel ] );
+
+    if( channel->type == RELIABLE_UDP_UNRELIABLE_SEQUENCED &&
+        channel->sendQueue.size() >= RELIABLE_UDP_MESSAGE_WINDOW ) {
+        // can't keep up, and only newest ones matter
+        delete [] channel->sendQueue.getElement( 0 )->data;
+        channel->sendQueue.deleteElement( 0 );
+        }
+
+    ReliableUDPMessage m;
+    m.id = channel->nextSendID++;
+    m.data = new unsigned char[ inLength ];
+    memcpy( m.data, inData, inLength );
+    m.length = inLength;
+    m.done = false;
+    m.needsSend = true;
+
+    channel->sendQueue.push_back( m );
+
+    return true;
+    }
+
+
+
+unsigned char *ReliableUDPConnection::receiveMessage( int *outChannel,
+                                                      int *outLength ) {
+    if( mNextDelivery >= mDeliveries.size() ) {
+        return NULL;
+        }
+
+    ReliableUDPDelivery d = mDeliveries.getElementDirect( mNextDelivery );
+    mNextDelivery++;
+
+    if( mNextDelivery == mDeliveries.size() ) {
+        // all taken, reuse space
+        mDeliveries.deleteAll();
+        mNextDelivery = 0;
+        }
+
+    *outChannel = d.channel;
+    *outLength = d.length;
+    return d.data;
+    }
+
+
+
+void ReliableUDPConnection::deliver( int inChannel, unsigned char *inData,
+                                     int inLength ) {
+    ReliableUDPDelivery d = { inChannel, inData, inLength };
+    mDeliveries.push_back( d );
+    }
+
+
+
+static unsigned char *copyBytes( const unsigned char *inData, int inLength ) {
+    unsigned char *copy = new unsigned char[ inLength ];
+    memcpy( copy, inData, inLength );
+    return copy;
+    }
+
+
+
+void ReliableUDPConnection::handleMessage( int inChannel, uint16_t inID,
+                                           const unsigned char *inData,
+                                           int inLength ) {
+    ReliableUDPChannel *channel = &( mChannels[ inChannel ] );
+
+    if( channel->type == RELIABLE_UDP_UNRELIABLE_SEQUENCED ) {
+        if( ! channel->receivedAny ||
+            sequenceDiff( inID, channel->receiveBaseID ) > 0 ) {
+
+            channel->receivedAny = true;
+            channel->receiveBaseID = inID;
+            deliver( inChannel, copyBytes( inData, inLength ), inLength );
+            }
+        // else older than one already delivered
+        return;
+        }
+
+
+    uint16_t ahead = (uint16_t)( inID - channel->receiveBaseID );
+
+    if( ahead >= RELIABLE_UDP_MESSAGE_WINDOW ) {
+        // either already delivered (a resend whose ack was lost), or
+        // too far ahead to hold (sender will resend)
+        return;
+        }
+
+    ReliableUDPMessage *slot =
+        &( channel->receiveWindow[ inID % RELIABLE_UDP_MESSAGE_WINDOW ] );
+
+    if( slot->done ) {
+        // duplicate
+        return;
+        }
+
+
+    if( channel->type == RELIABLE_UDP_RELIABLE_UNORDERED ) {
+        deliver( inChannel, copyBytes( inData, inLength ), inLength );
+
+        slot->done = true;
+        }
+    else if( ahead > 0 ) {
+        // hold until ones before it arrive
+        slot->id = inID;
+        slot->data = copyBytes( inData, inLength );
+        slot->length = inLength;
+        slot->done = true;
+        return;
+        }
+    else {
+        deliver( inChannel, copyBytes( inData, inLength ), inLength );
+        slot->done = true;
+        }
+
+
+    // slide window past everything received in order
+    while( true ) {
+        ReliableUDPMessage *base =
+            &( channel->receiveWindow[ channel->receiveBaseID %
+                                       RELIABLE_UDP_MESSAGE_WINDOW ] );
+        if( ! base->done ) {
+            break;
+            }
+
+        if( base->data != NULL ) {
+            // held ordered message, now in order
+            deliver( inChannel, base->data, base->length );
+            base->data = NULL;
+            }
+        base->done = false;
+        channel->receiveBaseID++;
+        }
+    }
+
+
+
+char ReliableUDPConnection::receivePacket( const unsigned char *inData,
+                                           int inLength, double inTime ) {
+    if( ! hasProtocolID( inData, inLength, mProtocolID ) ) {
+        return false;
+        }
+
+    uint16_t sequence = readUInt16( &( inData[4] ) );
+    unsigned char flags = inData[6];
+    uint16_t ack = readUInt16( &( inData[7] ) );
+    uint32_t ackBits = readUInt32( &( inData[9] ) );
+
+
+    // check all messages before using any
+    int numMessages = 0;
+    int position = RELIABLE_UDP_PACKET_HEADER_LENGTH;
+
+    while( position < inLength ) {
+        if( inLength - position < RELIABLE_UDP_MESSAGE_HEADER_LENGTH ) {
+            return false;
+            }
+        int channel = inData[ position ];
+        int length = readUInt16( &( inData[ position + 3 ] ) );
+
+        position += RELIABLE_UDP_MESSAGE_HEADER_LENGTH;
+
+        if( channel >= mNumChannels || length > inLength - position ) {
+            return false;
+            }
+        position += length;
+        numMessages++;
+        }
+
+
+    mLastReceiveTime = inTime;
+
+    // remember sequence number, for acks
+    if( ! mAnyReceived ) {
+        mAnyReceived = true;
+        mLatestReceived = sequence;
+        mReceivedBits = 0;
+        }
+    else {
+        int diff = sequenceDiff( sequence, mLatestReceived );
+
+        if( diff > 0 ) {
+            if( diff < 32 ) {
+                mReceivedBits = ( mReceivedBits << diff ) |
+                    ( (uint32_t)1 << ( diff - 1 ) );
+                }
+            else if( diff == 32 ) {
+                mReceivedBits = (uint32_t)1 << 31;
+                }
+            else {
+                mReceivedBits = 0;
+                }
+            mLatestReceived = sequence;
+            }
+        else if( diff < 0 && diff >= -32 ) {
+            mReceivedBits |= (uint32_t)1 << ( -diff - 1 );
+            }
+        }
+
+
+    if( flags & 1 ) {
+        processAck( ack, ackBits, inTime );
+        }
+
+
+    position = RELIABLE_UDP_PACKET_HEADER_LENGTH;
+
+    for( int i=0; i<numMessages; i++ ) {
+        int channel = inData[ position ];
+        uint16_t id = readUInt16( &( inData[ position + 1 ] ) );
+        int length = readUInt16( &( inData[ position + 3 ] ) );
+
+        position += RELIABLE_UDP_MESSAGE_HEADER_LENGTH;
+
+        handleMessage( channel, id, &( inData[ position ] ), length );
+
+        position += length;
+        }
+
+    if( numMessages > 0 && ! mAckPending ) {
+        // acks themselves aren't acked, so peer doesn't ack our acks
+        mAckPending = true;
+        mAckPendingTime = inTime;
+        }
+
+    return true;
+    }
+
+
+
+double ReliableUDPConnection::getRetransmitTimeout() {
+    double timeout = mSmoothedRTT + 4 * mRTTVariance + ACK_DELAY;
+
+    if( timeout < MIN_RETRANSMIT_TIMEOUT ) {
+        timeout = MIN_RETRANSMIT_TIMEOUT;
+        }
+
+    timeout *= mTimeoutBackoff;
+
+    if( timeout > MAX_RETRANSMIT_TIMEOUT ) {
+        timeout = MAX_RETRANSMIT_TIMEOUT;
+        }
+    return timeout;
+    }
+
+
+
+void ReliableUDPConnection::messageAcked( ReliableUDPMessageRef inRef ) {
+    ReliableUDPChannel *channel = &( mChannels[ inRef.channel ] );
+
+    int queueSize = channel->sendQueue.size();
+
+    if( queueSize == 0 ) {
+        return;
+        }
+
+    uint16_t index = (uint16_t)(
+        inRef.id - channel->sendQueue.getElement( 0 )->id );
+
+    if( index >= queueSize ) {
+        // acked and removed already
+        return;
+        }
+
+    ReliableUDPMessage *m = channel->sendQueue.getElement( index );
+
+    if( m->done ) {
+        return;
+        }
+
+    m->done = true;
+    m->needsSend = false;
+    delete [] m->data;
+    m->data = NULL;
+
+
+    int numDone = 0;
+    while( numDone < queueSize &&
+           channel->sendQueue.getElement( numDone )->done ) {
+        numDone++;
+        }
+
+    if( numDone > 0 ) {
+        channel->sendQueue.deleteStartElements( numDone );
+        }
+    }
+
+
+
+void ReliableUDPConnection::packetAcked( ReliableUDPSentPacket *inPacket,
+                                         double inTime ) {
+    if( inPacket->inFlight ) {
+        // only grow window if we were using it, or it grows without
+        // limit while we send less than it allows
+        char windowLimited = ( 2 * mBytesInFlight >= mCongestionWindow );
+
+        inPacket->inFlight = false;
+        mBytesInFlight -= inPacket->length;
+
+        // don't grow window for packets sent before the last loss
+        if( windowLimited && inPacket->sendTime > mRecoveryStartTime ) {
+            if( mCongestionWindow < mSlowStartThreshold ) {
+                mCongestionWindow += inPacket->length;
+                }
+            else {
+                mCongestionWindow +=
+                    (double)RELIABLE_UDP_MAX_PACKET_LENGTH *
+                    inPacket->length / mCongestionWindow;
+                }
+            }
+        }
+
+    inPacket->acked = true;
+
+    // a packet we counted as lost might still have arrived, and acking
+    // its messages now saves resending them
+    for( int i=0; i<inPacket->reliableMessages.size(); i++ ) {
+        messageAcked( inPacket->reliableMessages.getElementDirect( i ) );
+        }
+    }
+
+
+
+void ReliableUDPConnection::packetLost( ReliableUDPSentPacket *inPacket,
+                                        double inTime, char inByTimeout ) {
+    inPacket->inFlight = false;
+    mBytesInFlight -= inPacket->length;
+    mNumPacketsLost++;
+
+    for( int i=0; i<inPacket->reliableMessages.size(); i++ ) {
+        ReliableUDPMessageRef ref =
+            inPacket->reliableMessages.getElementDirect( i );
+
+        ReliableUDPChannel *channel = &( mChannels[ ref.channel ] );
+
+        if( channel->sendQueue.size() == 0 ) {
+            continue;
+            }
+
+        uint16_t index = (uint16_t)(
+            ref.id - channel->sendQueue.getElement( 0 )->id );
+
+        if( index < channel->sendQueue.size() ) {
+            ReliableUDPMessage *m = channel->sendQueue.getElement( index );
+            if( ! m->done ) {
+                m->needsSend = true;
+                }
+            }
+        }
+
+    // one cut per round trip, no matter how many packets were lost in it
+    if( inPacket->sendTime > mRecoveryStartTime ) {
+        mSlowStartThreshold = mCongestionWindow / 2;
+        if( mSlowStartThreshold < MIN_CONGESTION_WINDOW ) {
+            mSlowStartThreshold = MIN_CONGESTION_WINDOW;
+            }
+        mCongestionWindow = mSlowStartThreshold;
+        mRecoveryStartTime = inTime;
+        }
+
+    if( inByTimeout && mTimeoutBackoff < 16 ) {
+        mTimeoutBackoff *= 2;
+        }
+    }
+
+
+
+void ReliableUDPConnection::processAck( uint16_t inAck, uint32_t inAckBits,
+                                        double inTime ) {
+
+    if( ! mAnyAcked || sequenceDiff( inAck, mLargestAcked ) > 0 ) {
+        mAnyAcked = true;
+        mLargestAcked = inAck;
+        }
+
+    for( int i=-1; i<32; i++ ) {
+        uint16_t sequence = inAck;
+
+        if( i >= 0 ) {
+            if( ! ( inAckBits & ( (uint32_t)1 << i ) ) ) {
+                continue;
+                }
+            sequence = (uint16_t)( inAck - 1 - i );
+            }
+
+        ReliableUDPSentPacket *packet =
+            &( mSentPackets[ sequence % RELIABLE_UDP_PACKET_WINDOW ] );
+
+        if( packet->sequence != sequence || packet->acked ) {
+            continue;
+            }
+
+        if( i == -1 && packet->inFlight ) {
+            // newest ack gives a round trip sample, if not a resend
+            double sample = inTime - packet->sendTime;
+
+            if( ! mHaveRTTSample ) {
+                mSmoothedRTT = sample;
+                mRTTVariance = sample / 2;
+                mHaveRTTSample = true;
+                }
+            else {
+                double error = mSmoothedRTT - sample;
+                if( error < 0 ) {
+                    error = -error;
+                    }
+                mRTTVariance = 0.75 * mRTTVariance + 0.25 * error;
+                mSmoothedRTT = 0.875 * mSmoothedRTT + 0.125 * sample;
+                }
+            }
+
+        mTimeoutBackoff = 1;
+
+        packetAcked( packet, inTime );
+        }
+
+    detectLosses( inTime );
+    }
+
+
+
+void ReliableUDPConnection::detectLosses( double inTime ) {
+    mLastLossCheckTime = inTime;
+
+    double timeout = getRetransmitTimeout();
+
+    for( uint16_t sequence = mOldestInFlight; sequence != mNextSequence;
+         sequence++ ) {
+
+        ReliableUDPSentPacket *packet =
+            &( mSentPackets[ sequence % RELIABLE_UDP_PACKET_WINDOW ] );
+
+        if( ! packet->inFlight ) {
+            continue;
+            }
+
+        if( mAnyAcked &&
+            sequenceDiff( mLargestAcked, sequence ) >= REORDER_THRESHOLD ) {
+            packetLost( packet, inTime, false );
+            }
+        else if( inTime - packet->sendTime > timeout ) {
+            packetLost( packet, inTime, true );
+            }
+        else {
+            // later ones were sent later, and are before largest acked
+            // only if this one is
+            break;
+            }
+        }
+
+    while( mOldestInFlight != mNextSequence &&
+           ! mSentPackets[ mOldestInFlight %
+                           RELIABLE_UDP_PACKET_WINDOW ].inFlight ) {
+        mOldestInFlight++;
+        }
+    }
+
+
+
+char ReliableUDPConnection::haveDataToSend() {
+    for( int c=0; c<mNumChannels; c++ ) {
+        ReliableUDPChannel *channel = &( mChannels[c] );
+
+        int size = channel->sendQueue.size();
+
+        if( channel->type == RELIABLE_UDP_UNRELIABLE_SEQUENCED ) {
+            if( size > 0 ) {
+                return true;
+                }
+            continue;
+            }
+
+        // can't send past receiver's window
+        if( size > RELIABLE_UDP_MESSAGE_WINDOW ) {
+            size = RELIABLE_UDP_MESSAGE_WINDOW;
+            }
+
+        for( int i=0; i<size; i++ ) {
+            if( channel->sendQueue.getElement( i )->needsSend ) {
+                return true;
+                }
+            }
+        }
+    return false;
+    }
+
+
+
+char ReliableUDPConnection::canSendData( double inTime ) {
+    return mBytesInFlight < mCongestionWindow &&
+        inTime >= mPacingNextTime - PACING_QUANTUM;
+    }
+
+
+
+int ReliableUDPConnection::writeHeader( unsigned char *outPacket ) {
+    writeUInt32( outPacket, mProtocolID );
+    writeUInt16( &( outPacket[4] ), mNextSequence );
+
+    if( mAnyReceived ) {
+        outPacket[6] = 1;
+        writeUInt16( &( outPacket[7] ), mLatestReceived );
+        writeUInt32( &( outPacket[9] ), mReceivedBits );
+        }
+    else {
+        outPacket[6] = 0;
+        writeUInt16( &( outPacket[7] ), 0 );
+        writeUInt32( &( outPacket[9] ), 0 );
+        }
+
+    return RELIABLE_UDP_PACKET_HEADER_LENGTH;
+    }
+
+
+
+int ReliableUDPConnection::getPacketToSend( unsigned char *outPacket,
+                                            double inTime ) {
+    if( inTime > mLastLossCheckTime ) {
+        detectLosses( inTime );
+        }
+
+    ReliableUDPSentPacket *packet =
+        &( mSentPackets[ mNextSequence % RELIABLE_UDP_PACKET_WINDOW ] );
+
+    if( packet->inFlight ) {
+        // unacked for a whole window of packets
+        packetLost( packet, inTime, true );
+        }
+
+    packet->sequence = mNextSequence;
+    packet->inFlight = false;
+    packet->acked = false;
+    packet->reliableMessages.deleteAll();
+
+
+    int length = 0;
+
+    if( haveDataToSend() && canSendData( inTime ) ) {
+        length = writeHeader( outPacket );
+
+        int numMessages = 0;
+        char full = false;
+
+        // unreliable channels first, since their messages are only
+        // useful while fresh, then reliable channels, starting with a
+        // different one each packet so none is starved
+        int order[ RELIABLE_UDP_MAX_CHANNELS ];
+        int numOrdered = 0;
+
+        int reliableChannels[ RELIABLE_UDP_MAX_CHANNELS ];
+        int numReliable = 0;
+
+        for( int c=0; c<mNumChannels; c++ ) {
+            if( mChannels[c].type == RELIABLE_UDP_UNRELIABLE_SEQUENCED ) {
+                order[ numOrdered++ ] = c;
+                }
+            else {
+                reliableChannels[ numReliable++ ] = c;
+                }
+            }
+        for( int k=0; k<numReliable; k++ ) {
+            order[ numOrdered++ ] =
+                reliableChannels[ ( k + mNextReliableChannel ) %
+                                  numReliable ];
+            }
+        mNextReliableChannel++;
+        if( mNextReliableChannel >= numReliable ) {
+            mNextReliableChannel = 0;
+            }
+
+
+        for( int o=0; o<numOrdered && ! full; o++ ) {
+            int c = order[o];
+
+            ReliableUDPChannel *channel = &( mChannels[c] );
+
+            int size = channel->sendQueue.size();
+            char reliable =
+                ( channel->type != RELIABLE_UDP_UNRELIABLE_SEQUENCED );
+
+            if( reliable && size > RELIABLE_UDP_MESSAGE_WINDOW ) {
+                size = RELIABLE_UDP_MESSAGE_WINDOW;
+                }
+
+            int numSent = 0;
+
+            for( int i=0; i<size; i++ ) {
+                ReliableUDPMessage *m = channel->sendQueue.getElement( i );
+
+                if( ! m->needsSend ) {
+                    continue;
+                    }
+
+                if( length + RELIABLE_UDP_MESSAGE_HEADER_LENGTH + m->length
+                    > RELIABLE_UDP_MAX_PACKET_LENGTH ) {
+                    full = true;
+                    break;
+                    }
+
+                outPacket[ length ] = (unsigned char)c;
+                writeUInt16( &( outPacket[ length + 1 ] ), m->id );
+                writeUInt16( &( outPacket[ length + 3 ] ),
+                             (uint16_t)m->length );
+                length += RELIABLE_UDP_MESSAGE_HEADER_LENGTH;
+
+                memcpy( &( outPacket[ length ] ), m->data, m->length );
+                length += m->length;
+
+                m->needsSend = false;
+                numMessages++;
+                numSent++;
+
+                if( reliable ) {
+                    ReliableUDPMessageRef ref = { c, m->id };
+                    packet->reliableMessages.push_back( ref );
+                    }
+                }
+
+            if( ! reliable && numSent > 0 ) {
+                // sent once and forgotten, always from front of queue
+                for( int i=0; i<numSent; i++ ) {
+                    delete [] channel->sendQueue.getElement( i )->data;
+                    }
+                channel->sendQueue.deleteStartElements( numSent );
+                }
+            }
+
+        if( numMessages > 0 ) {
+            packet->inFlight = true;
+            packet->sendTime = inTime;
+            packet->length = length;
+
+            mBytesInFlight += length;
+
+
+            double rtt = mSmoothedRTT;
+            if( rtt < 0.001 ) {
+                rtt = 0.001;
+                }
+            double rate = PACING_GAIN * mCongestionWindow / rtt;
+
+            if( mPacingNextTime < inTime ) {
+                mPacingNextTime = inTime;
+                }
+            mPacingNextTime += length / rate;
+            }
+        else {
+            length = 0;
+            }
+        }
+
+
+    if( length == 0 ) {
+        char ackDue =
+            mAckPending && inTime >= mAckPendingTime + ACK_DELAY;
+        char keepAliveDue =
+            inTime >= mLastSendTime + KEEP_ALIVE_INTERVAL;
+
+        if( ! ackDue && ! keepAliveDue ) {
+            return 0;
+            }
+
+        // not tracked, since acks aren't acked
+        length = writeHeader( outPacket );
+        }
+
+
+    mNextSequence++;
+    mNumPacketsSent++;
+
+    mAckPending = false;
+    mLastSendTime = inTime;
+
+    return length;
+    }
+
+
+
+double ReliableUDPConnection::getNextUpdateTime( double inTime ) {
+    double next = mLastSendTime + KEEP_ALIVE_INTERVAL;
+
+    if( mAckPending && mAckPendingTime + ACK_DELAY < next ) {
+        next = mAckPendingTime + ACK_DELAY;
+        }
+
+    if( mBytesInFlight < mCongestionWindow && haveDataToSend() ) {
+        double pacingTime = mPacingNextTime - PACING_QUANTUM;
+        if( pacingTime < next ) {
+            next = pacingTime;
+            }
+        }
+
+    // oldest packet in flight times out first
+    for( uint16_t sequence = mOldestInFlight; sequence != mNextSequence;
+         sequence++ ) {
+
+        ReliableUDPSentPacket *packet =
+            &( mSentPackets[ sequence % RELIABLE_UDP_PACKET_WINDOW ] );
+
+        if( packet->inFlight ) {
+            double lossTime = packet->sendTime + getRetransmitTimeout();
+            if( lossTime < next ) {
+                next = lossTime;
+                }
+            break;
+            }
+        }
+
+    if( next < inTime ) {
+        next = inTime;
+        }
+    return next;
+    }
+
+
+
+char ReliableUDPConnection::isTimedOut( double inTime ) {
+    return inTime - mLastReceiveTime > RELIABLE_UDP_TIMEOUT_SECONDS;
+    }
+
+
+
+double ReliableUDPConnection::getRoundTripTime() {
+    return mSmoothedRTT;
+    }
+
+
+
+int ReliableUDPConnection::getCongestionWindow() {
+    return (int)mCongestionWindow;
+    }
+
+
+
+int ReliableUDPConnection::getBytesInFlight() {
+    return mBytesInFlight;
+    }
+
+
+
+int ReliableUDPConnection::getNumPacketsSent() {
+    return mNumPacketsSent;
+    }
+
+
+
+int ReliableUDPConnection::getNumPacketsLost() {
+    return mNumPacketsLost;
+    }
+
+
+
+int ReliableUDPConnection::getNumReliableMessagesPending() {
+    int count = 0;
+
+    for( int c=0; c<mNumChannels; c++ ) {
+        ReliableUDPChannel *channel = &( mChannels[c] );
+
+        if( channel->type == RELIABLE_UDP_UNRELIABLE_SEQUENCED ) {
+            continue;
+            }
+        for( int i=0; i<channel->sendQueue.size(); i++ ) {
+            if( ! channel->sendQueue.getElement( i )->done ) {
+                count++;
+                }
+            }
+        }
+    return count;
+    }
+
+
+
+
+ReliableUDPEndpoint::ReliableUDPEndpoint(
+    SocketUDP *inSocket, uint32_t inProtocolID,
+    int inNumChannels,
+    ReliableUDPChannelType *inChannelTypes,
+    char inAcceptConnections )
+        : mSocket( inSocket ),
+          mProtocolID( inProtocolID ),
+          mNumChannels( inNumChannels ),
+          mAcceptConnections( inAcceptConnections ) {
+
+    if( mNumChannels > RELIABLE_UDP_MAX_CHANNELS ) {
+        mNumChannels = RELIABLE_UDP_MAX_CHANNELS;
+        }
+    memcpy( mChannelTypes, inChannelTypes,
+            mNumChannels * sizeof( ReliableUDPChannelType ) );
+
+    mNumPacketBuffers = ENDPOINT_BATCH_SIZE;
+    mPackets = new struct UDPPacket[ mNumPacketBuffers ];
+
+    for( int i=0; i<mNumPacketBuffers; i++ ) {
+        mPackets[i].mData = new unsigned char[ RELIABLE_UDP_MAX_PACKET_LENGTH ];
+        mPackets[i].mCapacity = RELIABLE_UDP_MAX_PACKET_LENGTH;
+        mPackets[i].mLength = 0;
+        }
+    }
+
+
+
+ReliableUDPEndpoint::~ReliableUDPEndpoint() {
+    for( int i=0; i<mConnections.size(); i++ ) {
+        delete mConnections.getElementDirect( i );
+        }
+
+    for( int i=0; i<mNumPacketBuffers; i++ ) {
+        delete [] mPackets[i].mData;
+        }
+    delete [] mPackets;
+    }
+
+
+
+ReliableUDPConnection *ReliableUDPEndpoint::makeConnection(
+    struct UDPAddress *inAddress ) {
+
+    ReliableUDPConnection *connection =
+        new ReliableUDPConnection( inAddress, mProtocolID,
+                                   mNumChannels, mChannelTypes,
+                                   Time::getMonotonicTime() );
+    mConnections.push_back( connection );
+
+    return connection;
+    }
+
+
+
+ReliableUDPConnection *ReliableUDPEndpoint::findConnection(
+    struct UDPAddress *inAddress ) {
+
+    for( int i=0; i<mConnections.size(); i++ ) {
+        ReliableUDPConnection *connection =
+            mConnections.getElementDirect( i );
+
+        if( SocketUDP::compare( connection->getAddress(), inAddress ) ) {
+            return connection;
+            }
+        }
+    return NULL;
+    }
+
+
+
+ReliableUDPConnection *ReliableUDPEndpoint::connect(
+    struct UDPAddress *inAddress ) {
+
+    ReliableUDPConnection *connection = findConnection( inAddress );
+
+    if( connection == NULL ) {
+        connection = makeConnection( inAddress );
+        }
+    return connection;
+    }
+
+
+
+void ReliableUDPEndpoint::disconnect( ReliableUDPConnection *inConnection ) {
+    mConnections.deleteElementEqualTo( inConnection );
+    mNewConnections.deleteElementEqualTo( inConnection );
+
+    delete inConnection;
+    }
+
+
+
+ReliableUDPConnection *ReliableUDPEndpoint::getNewConnection() {
+    if( mNewConnections.size() == 0 ) {
+        return NULL;
+        }
+
+    ReliableUDPConnection *connection =
+        mNewConnections.getElementDirect( 0 );
+    mNewConnections.deleteElement( 0 );
+
+    return connection;
+    }
+
+
+
+int ReliableUDPEndpoint::receive() {
+    int numReceived = 0;
+
+    while( true ) {
+        int numPackets = mSocket->receiveBatch( mPackets, mNumPacketBuffers,
+                                                0 );
+        if( numPackets == -2 ) {
+            // nothing more waiting
+            break;
+            }
+        if( numPackets < 0 ) {
+            return -1;
+            }
+
+        double time = Time::getMonotonicTime();
+
+        for( int i=0; i<numPackets; i++ ) {
+            struct UDPPacket *p = &( mPackets[i] );
+
+            ReliableUDPConnection *connection =
+                findConnection( &( p->mAddress ) );
+
+            if( connection == NULL ) {
+                if( ! mAcceptConnections ||
+                    ! hasProtocolID( p->mData, p->mLength, mProtocolID ) ) {
+                    continue;
+                    }
+                connection = makeConnection( &( p->mAddress ) );
+                mNewConnections.push_back( connection );
+                }
+
+            connection->receivePacket( p->mData, p->mLength, time );
+            }
+
+        numReceived += numPackets;
+
+        if( numPackets < mNumPacketBuffers ) {
+            break;
+            }
+        }
+
+    return numReceived;
+    }
+
+
+
+char ReliableUDPEndpoint::update() {
+    double time = Time::getMonotonicTime();
+
+    int numQueued = 0;
+
+    for( int c=0; c<mConnections.size(); c++ ) {
+        ReliableUDPConnection *connection = mConnections.getElementDirect( c );
+
+        while( true ) {
+            struct UDPPacket *p = &( mPackets[ numQueued ] );
+
+            p->mLength = connection->getPacketToSend( p->mData, time );
+
+            if( p->mLength == 0 ) {
+                break;
+                }
+            p->mAddress = *( connection->getAddress() );
+            numQueued++;
+
+            if( numQueued == mNumPacketBuffers ) {
+                // any that the socket doesn't take are treated like
+                // packets lost on the way
+                if( mSocket->sendBatch( mPackets, numQueued ) == -1 ) {
+                    return false;
+                    }
+                numQueued = 0;
+                }
+            }
+        }
+
+    if( numQueued > 0 &&
+        mSocket->sendBatch( mPackets, numQueued ) == -1 ) {
+        return false;
+        }
+    return true;
+    }
+
+
+
+int ReliableUDPEndpoint::getMSUntilNextUpdate() {
+    if( mConnections.size() == 0 ) {
+        return -1;
+        }
+
+    double time = Time::getMonotonicTime();
+    double next = time + KEEP_ALIVE_INTERVAL;
+
+    for( int c=0; c<mConnections.size(); c++ ) {
+        double t =
+            mConnections.getElementDirect( c )->getNextUpdateTime( time );
+        if( t < next ) {
+            next = t;
+            }
+        }
+
+    // round up, so we don't wake up just before it's time
+    int ms = (int)( ( next - time ) * 1000 + 0.999 );
+    if( ms < 0 ) {
+        ms = 0;
+        }
+    return ms;
+    }
+
+
+
+int ReliableUDPEndpoint::getNumConnections() {
+    return mConnections.size();
+    }
+
+
+
+ReliableUDPConnection *ReliableUDPEndpoint::getConnection( int inIndex ) {
+    return mConnections.getElementDirect( inIndex );
+    }
@@ -0,0 +1,497 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+#include "minorGems/common.h"
+
+
+
+#ifndef RELIABLE_UDP_INCLUDED
+#define RELIABLE_UDP_INCLUDED
+
+
+#include "minorGems/network/SocketUDP.h"
+#include "minorGems/util/SimpleVector.h"
+
+#include <stdint.h>
+
+
+
+/**
+ * Message channels over UDP, without TCP's head-of-line blocking:  a lost
+ * packet only holds up later messages on its own reliable-ordered
+ * channel, and unreliable messages (like position updates) are never
+ * held up or resent at all.
+ *
+ * Packet layout (little-endian):
+ *   uint32 protocol ID, uint16 sequence number, uint8 flags (bit 0 set
+ *   if acks follow), uint16 latest sequence number received, uint32 bits
+ *   for the 32 sequence numbers before that (bit i set if latest - 1 - i
+ *   was received), then messages, each:  uint8 channel, uint16 message
+ *   ID, uint16 length, payload.
+ *
+ * Every packet acks the last 33 packets received, so acks survive
+ * losses.  Reliable messages are tracked by the packets that carried
+ * them, and only the messages in a lost packet are resent (repacked into
+ * new packets, with new sequence numbers).  A packet counts as lost once
+ * 3 later packets are acked, or after a retransmit timeout based on the
+ * measured round trip time.
+ *
+ * Sending is congestion-controlled like TCP Reno (slow start, then
+ * additive increase, halving on loss), and packets are paced out over a
+ * round trip instead of sent in bursts.  Acks and keep-alives are not
+ * congestion-controlled.
+ *
+ * Messages must fit in one packet (RELIABLE_UDP_MAX_MESSAGE_LENGTH).
+ * There's no handshake:  a connection is just a peer address and shared
+ * protocol ID, so this doesn't protect against spoofed packets.
+ */
+
+
+// kept below common path MTUs (IPv6 minimum is 1280) to avoid
+// fragmentation
+#define RELIABLE_UDP_MAX_PACKET_LENGTH 1200
+
+#define RELIABLE_UDP_PACKET_HEADER_LENGTH 13
+#define RELIABLE_UDP_MESSAGE_HEADER_LENGTH 5
+
+#define RELIABLE_UDP_MAX_MESSAGE_LENGTH \
+    ( RELIABLE_UDP_MAX_PACKET_LENGTH - RELIABLE_UDP_PACKET_HEADER_LENGTH - \
+      RELIABLE_UDP_MESSAGE_HEADER_LENGTH )
+
+#define RELIABLE_UDP_MAX_CHANNELS 16
+
+// most reliable messages in flight per channel, and most out-of-order
+// messages held per channel by receiver
+#define RELIABLE_UDP_MESSAGE_WINDOW 256
+
+// sent packets remembered for acks (a power of 2)
+#define RELIABLE_UDP_PACKET_WINDOW 1024
+
+// connection times out after this long without a packet
+#define RELIABLE_UDP_TIMEOUT_SECONDS 10.0
+
+
+
+enum ReliableUDPChannelType {
+    // every message arrives, in the order sent
+    RELIABLE_UDP_RELIABLE_ORDERED = 0,
+
+    // every message arrives once, as soon as it can
+    RELIABLE_UDP_RELIABLE_UNORDERED,
+
+    // messages may be lost, and ones that arrive after a newer one are
+    // dropped, so only the latest state is ever delivered
+    RELIABLE_UDP_UNRELIABLE_SEQUENCED
+    };
+
+
+
+// message being sent, or held for delivery
+typedef struct ReliableUDPMessage {
+        uint16_t id;
+
+        unsigned char *data;
+        int length;
+
+        // sending:  acked, and can be dropped when all before it are
+        // receiving:  slot in window is filled
+        char done;
+
+        // sending:  not sent yet, or sent in a packet that was lost
+        char needsSend;
+    } ReliableUDPMessage;
+
+
+// a reliable message carried by a sent packet
+typedef struct ReliableUDPMessageRef {
+        int channel;
+        uint16_t id;
+    } ReliableUDPMessageRef;
+
+
+typedef struct ReliableUDPSentPacket {
+        uint16_t sequence;
+
+        // sent, and not yet acked or lost
+        char inFlight;
+
+        // acked, maybe after being counted as lost
+        char acked;
+
+        double sendTime;
+        int length;
+
+        SimpleVector<ReliableUDPMessageRef> reliableMessages;
+    } ReliableUDPSentPacket;
+
+
+typedef struct ReliableUDPChannel {
+        ReliableUDPChannelType type;
+
+        // sending
+        uint16_t nextSendID;
+        // oldest first, starting at the oldest unacked (reliable), or
+        // not yet sent (unreliable)
+        SimpleVector<ReliableUDPMessage> sendQueue;
+
+        // receiving
+        // reliable:  next ID not yet received in order
+        // unreliable:  newest ID delivered
+        uint16_t receiveBaseID;
+        char receivedAny;
+        // reliable:  RELIABLE_UDP_MESSAGE_WINDOW slots, indexed by ID
+        ReliableUDPMessage *receiveWindow;
+    } ReliableUDPChannel;
+
+
+typedef struct ReliableUDPDelivery {
+        int channel;
+        unsigned char *data;
+        int length;
+    } ReliableUDPDelivery;
+
+
+
+/**
+ * One side of a connection, independent of any socket:  messages go in
+ * with send and come out with receiveMessage, and datagrams go out with
+ * getPacketToSend and come in with receivePacket.
+ *
+ * Times are in seconds, from any monotonic clock (like
+ * Time::getMonotonicTime).
+ *
+ * Not thread-safe.
+ */
+class ReliableUDPConnection {
+
+    public:
+
+        /**
+         * Constructs a connection.
+         *
+         * @param inAddress the peer's address.  Destroyed by caller.
+         * @param inProtocolID ID that both sides use, and that packets
+         *   must start with.
+         * @param inNumChannels the number of channels.  At most
+         *   RELIABLE_UDP_MAX_CHANNELS.
+         * @param inChannelTypes the type of each channel.  Both sides
+         *   must use the same channels.  Destroyed by caller.
+         * @param inTime the current time.
+         */
+        ReliableUDPConnection( struct UDPAddress *inAddress,
+                               uint32_t inProtocolID,
+                               int inNumChannels,
+                               ReliableUDPChannelType *inChannelTypes,
+                               double inTime );
+
+        ~ReliableUDPConnection();
+
+
+        struct UDPAddress *getAddress();
+
+
+        /**
+         * Queues a message for sending.
+         *
+         * @param inChannel the channel.
+         * @param inData the message.  Destroyed by caller.
+         * @param inLength the message length.  At most
+         *   RELIABLE_UDP_MAX_MESSAGE_LENGTH.
+         *
+         * @return true if queued, or false if message is too long or
+         *   channel is invalid.
+         */
+        char send( int inChannel, const unsigned char *inData,
+                   int inLength );
+
+
+        /**
+         * Gets the next message delivered by the connection.
+         *
+         * @param outChannel pointer to where channel should be returned.
+         * @param outLength pointer to where length should be returned.
+         *
+         * @return the message, or NULL if none are waiting.
+         *   Must be destroyed by caller if non-NULL.
+         */
+        unsigned char *receiveMessage( int *outChannel, int *outLength );
+
+
+        /**
+         * Processes a datagram received from the peer.
+         *
+         * @param inData the datagram.  Destroyed by caller.
+         * @param inLength the length of the datagram.
+         * @param inTime the current time.
+         *
+         * @return true if datagram was accepted, or false if it was
+         *   malformed or had the wrong protocol ID.
+         */
+        char receivePacket( const unsigned char *inData, int inLength,
+                            double inTime );
+
+
+        /**
+         * Gets the next datagram to send to the peer, if one should be
+         * sent now.  Call repeatedly until it returns 0.
+         *
+         * @param outPacket where datagram should be written.  Must have
+         *   room for RELIABLE_UDP_MAX_PACKET_LENGTH bytes.
+         * @param inTime the current time.
+         *
+         * @return the length of the datagram, or 0 if nothing should be
+         *   sent now.
+         */
+        int getPacketToSend( unsigned char *outPacket, double inTime );
+
+
+        /**
+         * Gets when getPacketToSend should next be called, assuming no
+         * more messages are sent or packets received before then.
+         *
+         * @param inTime the current time.
+         *
+         * @return the time, no earlier than inTime.
+         */
+        double getNextUpdateTime( double inTime );
+
+
+        // true if nothing has been heard from the peer for
+        // RELIABLE_UDP_TIMEOUT_SECONDS
+        char isTimedOut( double inTime );
+
+
+        // smoothed round trip time, in seconds
+        double getRoundTripTime();
+
+        // congestion window, in bytes
+        int getCongestionWindow();
+
+        int getBytesInFlight();
+
+        int getNumPacketsSent();
+        int getNumPacketsLost();
+
+        // reliable messages queued or in flight, on all channels
+        int getNumReliableMessagesPending();
+
+
+    protected:
+
+        struct UDPAddress mAddress;
+        uint32_t mProtocolID;
+
+        int mNumChannels;
+        ReliableUDPChannel mChannels[ RELIABLE_UDP_MAX_CHANNELS ];
+
+        SimpleVector<ReliableUDPDelivery> mDeliveries;
+        int mNextDelivery;
+
+
+        // sent packets, indexed by sequence number
+        ReliableUDPSentPacket mSentPackets[ RELIABLE_UDP_PACKET_WINDOW ];
+
+        uint16_t mNextSequence;
+
+        // oldest sequence number that may still be in flight
+        uint16_t mOldestInFlight;
+
+        // newest sequence number that peer has acked
+        uint16_t mLargestAcked;
+        char mAnyAcked;
+
+        int mBytesInFlight;
+
+
+        // acks to send
+        uint16_t mLatestReceived;
+        uint32_t mReceivedBits;
+        char mAnyReceived;
+        char mAckPending;
+        double mAckPendingTime;
+
+        double mLastReceiveTime;
+        double mLastSendTime;
+
+
+        // round trip estimate
+        double mSmoothedRTT;
+        double mRTTVariance;
+        char mHaveRTTSample;
+        // doubled for each retransmit timeout without an ack
+        int mTimeoutBackoff;
+
+
+        // congestion control
+        double mCongestionWindow;
+        double mSlowStartThreshold;
+        // losses of packets sent before this are part of the same event
+        double mRecoveryStartTime;
+        double mPacingNextTime;
+
+
+        int mNumPacketsSent;
+        int mNumPacketsLost;
+
+        double mLastLossCheckTime;
+
+        // reliable channel to start filling next packet from
+        int mNextReliableChannel;
+
+
+        double getRetransmitTimeout();
+
+        void messageAcked( ReliableUDPMessageRef inRef );
+
+        void packetAcked( ReliableUDPSentPacket *inPacket, double inTime );
+
+        void packetLost( ReliableUDPSentPacket *inPacket, double inTime,
+                         char inByTimeout );
+
+        void processAck( uint16_t inAck, uint32_t inAckBits,
+                         double inTime );
+
+        // marks packets lost by ack gaps or by timeout
+        void detectLosses( double inTime );
+
+        void handleMessage( int inChannel, uint16_t inID,
+                            const unsigned char *inData, int inLength );
+
+        void deliver( int inChannel, unsigned char *inData, int inLength );
+
+        // true if a message with data is waiting to be sent
+        char haveDataToSend();
+
+        // true if congestion window and pacing allow a data packet now
+        char canSendData( double inTime );
+
+        // header with acks, for next packet, returns length
+        int writeHeader( unsigned char *outPacket );
+    };
+
+
+
+/**
+ * Runs ReliableUDPConnections over a SocketUDP.
+ *
+ * Typical use, along with other sockets on a SocketPoll:
+ *   poll.addSocketUDP( &udpSocket );
+ *   while( running ) {
+ *       SocketOrServer *ready =
+ *           poll.wait( endpoint.getMSUntilNextUpdate() );
+ *       if( ready != NULL && ready->udp == &udpSocket ) {
+ *           endpoint.receive();
+ *           }
+ *       (read messages from connections, and send new ones)
+ *       endpoint.update();
+ *       }
+ *
+ * Not thread-safe.
+ */
+class ReliableUDPEndpoint {
+
+    public:
+
+        /**
+         * Constructs an endpoint.
+         *
+         * @param inSocket the socket to use.  Destroyed by caller after
+         *   this endpoint is destroyed.
+         * @param inProtocolID ID that both sides use, to ignore stray
+         *   packets.
+         * @param inNumChannels the number of channels.
+         * @param inChannelTypes the type of each channel.  Destroyed by
+         *   caller.
+         * @param inAcceptConnections true to make connections for packets
+         *   from unknown addresses (see getNewConnection).
+         */
+        ReliableUDPEndpoint( SocketUDP *inSocket, uint32_t inProtocolID,
+                             int inNumChannels,
+                             ReliableUDPChannelType *inChannelTypes,
+                             char inAcceptConnections );
+
+        // destroys all connections
+        ~ReliableUDPEndpoint();
+
+
+        /**
+         * Makes a connection to a peer.
+         *
+         * @param inAddress the address.  Destroyed by caller.
+         *
+         * @return the connection.  Destroyed by this endpoint.
+         */
+        ReliableUDPConnection *connect( struct UDPAddress *inAddress );
+
+
+        // destroys a connection
+        void disconnect( ReliableUDPConnection *inConnection );
+
+
+        /**
+         * Gets the next connection made for an unknown peer by receive.
+         *
+         * @return the connection, or NULL.  Destroyed by this endpoint.
+         */
+        ReliableUDPConnection *getNewConnection();
+
+
+        /**
+         * Receives all waiting datagrams, without blocking, and passes
+         * them to their connections.
+         *
+         * @return the number of datagrams received, or -1 on a socket
+         *   error.
+         */
+        int receive();
+
+
+        /**
+         * Sends what each connection has ready (queued messages, acks,
+         * retransmits, keep-alives).
+         *
+         * @return false on a socket error.
+         */
+        char update();
+
+
+        // milliseconds until update should next be called, for
+        // SocketPoll::wait
+        int getMSUntilNextUpdate();
+
+
+        int getNumConnections();
+        ReliableUDPConnection *getConnection( int inIndex );
+
+
+    protected:
+
+        SocketUDP *mSocket;
+        uint32_t mProtocolID;
+
+        int mNumChannels;
+        ReliableUDPChannelType mChannelTypes[ RELIABLE_UDP_MAX_CHANNELS ];
+
+        char mAcceptConnections;
+
+        SimpleVector<ReliableUDPConnection *> mConnections;
+        SimpleVector<ReliableUDPConnection *> mNewConnections;
+
+        // for batch sends and receives
+        struct UDPPacket *mPackets;
+        int mNumPacketBuffers;
+
+        ReliableUDPConnection *findConnection(
+            struct UDPAddress *inAddress );
+
+        ReliableUDPConnection *makeConnection(
+            struct UDPAddress *inAddress );
+    };
+
+
+
+#endif
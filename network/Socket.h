@@ -48,6 +48,12 @@
  * 2018-November-8  Jason Rohrer
  * Keeping socketID allocated on heap is a 17-year-old idea that was never
  * necessary, and is asking for trouble.  Make it an int on all platforms.
+ *
+ * 2026-October-14  Jason Rohrer
+ * Added scatter-gather sendv and a send queue for batching small messages.
+ * Send queue is now a ring buffer, with non-blocking sendOrQueue and
+ * high/low water mark callbacks for back-pressure.
+ * Added sendFile.
  */
 
 
@@ -62,6 +68,26 @@
 
 #include "minorGems/network/HostAddress.h"
 #include "minorGems/system/Time.h"
+#include "minorGems/util/ByteRingBuffer.h"
+#include <stdio.h>
+
+
+
+// one piece of data for Socket::sendv
+typedef struct SocketBuffer {
+        unsigned char *data;
+        int length;
+    } SocketBuffer;
+
+
+class Socket;
+
+// called when a socket's send queue grows past its high water mark
+// (inAboveHighWater true), and again when it drains back below its low
+// water mark (inAboveHighWater false)
+typedef void (*SocketSendQueueCallback)( Socket *inSocket,
+                                         char inAboveHighWater,
+                                         void *inExtraArg );
 
 
 
@@ -159,6 +185,126 @@ class Socket {
 		int send( unsigned char *inBuffer, int inNumBytes,
                   char inAllowedToBlock = true,
                   char inAllowDelay = true );
+
+
+        /**
+         * Sends several buffers through this socket as if they were one,
+         * in one system call, without copying them together first
+         * (for example, a message header and its body).
+         *
+         * Parameters and return value are the same as for send, with
+         * inBuffers destroyed by caller.
+         *
+         * As with send, fewer bytes than requested may be sent, in which
+         * case the caller must send the rest, starting partway through
+         * one of the buffers.
+         */
+        int sendv( SocketBuffer *inBuffers, int inNumBuffers,
+                   char inAllowedToBlock = true,
+                   char inAllowDelay = true );
+
+
+
+        /**
+         * Sends part of a file through this socket, blocking until all
+         * of it is sent.
+         *
+         * Uses sendfile where available, so the data goes straight from
+         * the file to the socket without being copied through our
+         * memory.
+         *
+         * @param inFile the open file.  Closed by caller.  Its read
+         *   position is left unspecified.
+         * @param inOffset where in the file to start.
+         * @param inNumBytes how much of the file to send.
+         *
+         * @return the number of bytes sent, or -1 for a socket or
+         *   file error.
+         */
+        long sendFile( FILE *inFile, long inOffset, long inNumBytes );
+
+
+
+        /**
+         * Adds bytes to this socket's send queue, to be sent by the next
+         * flushSendQueue call.
+         *
+         * For producing many small messages (for example, during one
+         * server tick) and then sending them all with one system call.
+         *
+         * @param inBuffer the bytes to queue.
+         *   Copied internally, destroyed by caller.
+         * @param inNumBytes the number of bytes to queue.
+         */
+        void queueSend( unsigned char *inBuffer, int inNumBytes );
+
+
+        /**
+         * Sends bytes without ever blocking or dropping any.
+         *
+         * If nothing is already queued, sends what the socket will take
+         * right now, then queues the rest.  Otherwise, queues all of it
+         * behind what is already queued, keeping order.
+         *
+         * Queued bytes go out with later flushSendQueue calls (for example,
+         * when SocketPoll reports the socket as write-ready, see
+         * SocketPoll::drainSendQueue).
+         *
+         * @param inBuffer the bytes to send.
+         *   Destroyed by caller.
+         * @param inNumBytes the number of bytes to send.
+         * @param inAllowDelay same as for send.
+         *
+         * @return the number of bytes still queued, or -1 for a socket
+         *   error.
+         */
+        int sendOrQueue( unsigned char *inBuffer, int inNumBytes,
+                         char inAllowDelay = true );
+
+        
+        /**
+         * Sends as much of the send queue as possible.
+         *
+         * Whatever isn't sent stays queued, ahead of anything queued
+         * later.
+         *
+         * @param inAllowedToBlock set to true to block until all of the
+         *   queue is sent.
+         *   Defaults to false.
+         * @param inAllowDelay same as for send.
+         *
+         * @return the number of bytes still queued, or -1 for a socket
+         *   error.
+         */
+        int flushSendQueue( char inAllowedToBlock = false,
+                            char inAllowDelay = true );
+
+
+        // number of bytes waiting to be sent by flushSendQueue
+        int getSendQueueSize();
+
+
+        /**
+         * Sets up back-pressure notification for the send queue.
+         *
+         * inCallback is called once when the queue grows beyond
+         * inHighWaterBytes, and then once when it drains to
+         * inLowWaterBytes or less, so a server can stop producing data for
+         * a slow client until it catches up.
+         *
+         * @param inCallback the function to call, or NULL to stop calling.
+         * @param inExtraArg passed through to inCallback.
+         */
+        void setSendQueueWaterMarks( int inHighWaterBytes,
+                                     int inLowWaterBytes,
+                                     SocketSendQueueCallback inCallback,
+                                     void *inExtraArg = NULL );
+
+
+        // true if send queue has passed high water mark and not yet
+        // drained to low water mark
+        char isSendQueueAboveHighWater();
+        
 		
 		
 		/**
@@ -282,6 +428,21 @@ class Socket {
         char mConnected;
         
         char mIsConnectionBroken;
+
+        ByteRingBuffer mSendQueue;
+
+        int mSendQueueHighWater;
+        int mSendQueueLowWater;
+
+        SocketSendQueueCallback mSendQueueCallback;
+        void *mSendQueueCallbackArg;
+
+        char mSendQueueAboveHighWater;
+
+
+        // checks queue size against water marks, calling callback if
+        // it crossed one
+        void checkSendQueueWaterMarks();
         
 
         // toggle Nagle algorithm (inValue=1 turns it off)
@@ -293,8 +454,140 @@ class Socket {
 
 
 inline Socket::Socket()
-    : mConnected( true ), mIsConnectionBroken( false ) {
+    : mConnected( true ), mIsConnectionBroken( false ),
+      mSendQueueHighWater( -1 ), mSendQueueLowWater( -1 ),
+      mSendQueueCallback( NULL ), mSendQueueCallbackArg( NULL ),
+      mSendQueueAboveHighWater( false ) {
+
+    }
+
+
+
+inline void Socket::checkSendQueueWaterMarks() {
+    if( mSendQueueCallback == NULL ) {
+        return;
+        }
+    
+    int size = mSendQueue.size();
+
+    if( ! mSendQueueAboveHighWater ) {
+        if( size > mSendQueueHighWater ) {
+            mSendQueueAboveHighWater = true;
+            mSendQueueCallback( this, true, mSendQueueCallbackArg );
+            }
+        }
+    else if( size <= mSendQueueLowWater ) {
+        mSendQueueAboveHighWater = false;
+        mSendQueueCallback( this, false, mSendQueueCallbackArg );
+        }
+    }
+
+
+
+inline void Socket::setSendQueueWaterMarks( 
+    int inHighWaterBytes, int inLowWaterBytes,
+    SocketSendQueueCallback inCallback, void *inExtraArg ) {
+
+    mSendQueueHighWater = inHighWaterBytes;
+    mSendQueueLowWater = inLowWaterBytes;
+    mSendQueueCallback = inCallback;
+    mSendQueueCallbackArg = inExtraArg;
+    mSendQueueAboveHighWater = false;
+
+    checkSendQueueWaterMarks();
+    }
+
+
+
+inline char Socket::isSendQueueAboveHighWater() {
+    return mSendQueueAboveHighWater;
+    }
+
+
+
+inline void Socket::queueSend( unsigned char *inBuffer, int inNumBytes ) {
+    mSendQueue.write( inBuffer, inNumBytes );
+
+    checkSendQueueWaterMarks();
+    }
+
+
+
+inline int Socket::getSendQueueSize() {
+    return mSendQueue.size();
+    }
+
+
+
+inline int Socket::flushSendQueue( char inAllowedToBlock, 
+                                   char inAllowDelay ) {
+    
+    while( mSendQueue.size() > 0 ) {
+        
+        // queue may wrap around end of ring, but sendv takes both pieces
+        // in one call
+        unsigned char *spans[2];
+        int lengths[2];
+        
+        int numSpans = mSendQueue.getReadSpans( spans, lengths );
+
+        SocketBuffer b[2];
+
+        for( int i=0; i<numSpans; i++ ) {
+            b[i].data = spans[i];
+            b[i].length = lengths[i];
+            }
+        
+        int numSent = sendv( b, numSpans, inAllowedToBlock, inAllowDelay );
+        
+        if( numSent == -1 ) {
+            return -1;
+            }
+        if( numSent <= 0 ) {
+            // would block
+            break;
+            }
+        
+        mSendQueue.consume( numSent );
+
+        if( ! inAllowedToBlock ) {
+            // took what it could, don't ask again until later 
+            break;
+            }
+        }
+
+    checkSendQueueWaterMarks();
+    
+    return mSendQueue.size();
+    }
+
+
+
+inline int Socket::sendOrQueue( unsigned char *inBuffer, int inNumBytes,
+                                char inAllowDelay ) {
+    
+    if( mSendQueue.size() == 0 ) {
+        SocketBuffer b;
+        b.data = inBuffer;
+        b.length = inNumBytes;
+        
+        int numSent = sendv( &b, 1, false, inAllowDelay );
+
+        if( numSent == -1 ) {
+            return -1;
+            }
+        if( numSent < 0 ) {
+            // would block
+            numSent = 0;
+            }
+
+        inBuffer = &( inBuffer[ numSent ] );
+        inNumBytes -= numSent;
+        }
+    
+    queueSend( inBuffer, inNumBytes );
 
+    return mSendQueue.size();
     }
 
 
@@ -45,7 +45,7 @@ class SocketClient {
          * If inAddress is not in numerical format (in other words, if it
          * requires a DNS lookup before connection), this function may block
          * even if non-blocking mode is specified.
-         * Consider using LookupThread to lookup the address before
+         * Consider using HostLookupPool to lookup the address before
          * calling this function.
 		 *
 		 * @param inAddress the host to connect to.  Must be destroyed
@@ -3,12 +3,491 @@
  *
  * 2004-December-13   Jason Rohrer
  * Created.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Sockets kept in a hash map instead of a list.
+ * Optional poller threads that watch sockets with SocketPoll and call
+ * handlers when they are ready.
  */
 
 
 
 #include "SocketManager.h"
 
+#include "minorGems/system/Thread.h"
+#include "minorGems/system/Semaphore.h"
+
+
+#ifdef WIN_32
+#include <winsock.h>
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#endif
+
+
+
+#ifdef _MSC_VER
+    #define SOCKET_MANAGER_THREAD_LOCAL __declspec( thread )
+#else
+    #define SOCKET_MANAGER_THREAD_LOCAL __thread
+#endif
+
+
+// most ready sockets handled per SocketPoll::wait call
+#define SOCKET_POLLER_MAX_READY 64
+
+
+
+struct SocketRegistration {
+        // one is NULL
+        Socket *sock;
+        SocketServer *server;
+
+        SocketHandler *handler;
+
+        SocketPoller *poller;
+
+        // set once unwatched, so no more handler calls are made
+        char removed;
+    };
+
+
+
+enum SocketPollChangeType {
+    SOCKET_POLL_CHANGE_ADD,
+    SOCKET_POLL_CHANGE_FLAGS,
+    SOCKET_POLL_CHANGE_REMOVE,
+    SOCKET_POLL_CHANGE_STOP
+    };
+
+
+typedef struct SocketPollChange {
+        SocketPollChangeType type;
+        SocketRegistration *registration;
+        int flags;
+
+        // removal number that a thread is waiting for, or 0 if none
+        int removalTicket;
+    } SocketPollChange;
+
+
+
+/**
+ * Thread that owns a SocketPoll and calls handlers for ready sockets.
+ *
+ * SocketPoll isn't thread-safe, so other threads queue changes for this
+ * thread to make between waits, and wake it up by writing to a socket
+ * pair that it also watches.
+ */
+class SocketPoller : public Thread {
+
+    public:
+
+        SocketPoller();
+
+        ~SocketPoller();
+
+
+        // false if wake-up socket pair couldn't be made
+        char isValid();
+
+
+        // can be called from any thread
+        void queueChange( SocketPollChange inChange );
+
+
+        // queues a removal, and blocks until it is made
+        // must not be called from this poller's thread
+        void removeAndWait( SocketRegistration *inRegistration );
+
+
+        // removes a registration right away
+        // must only be called from this poller's thread
+        void removeNow( SocketRegistration *inRegistration );
+
+
+        void run();
+
+
+    protected:
+
+        SocketPoll mPoll;
+
+        // protects everything below
+        MutexLock mLock;
+
+        SimpleVector<SocketPollChange> mChanges;
+
+        Socket *mWakeReader;
+        Socket *mWakeWriter;
+
+        // true if a wake-up byte has been sent since last drained
+        char mWakePending;
+
+        int mNumRemovalsQueued;
+        int mNumRemovalsMade;
+
+        // threads in removeAndWait, all woken when removals are made
+        int mNumRemovalWaiters;
+        Semaphore mRemovalsMade;
+
+
+        // must be called with mLock locked
+        void wakeLocked();
+
+        // returns true if stopped
+        char applyChanges();
+    };
+
+
+
+static SOCKET_MANAGER_THREAD_LOCAL SocketPoller *currentPoller = NULL;
+
+
+
+// connected pair of sockets that only this process uses
+static char makeSocketPair( Socket **outA, Socket **outB ) {
+
+    if( ! Socket::isFrameworkInitialized() ) {
+        if( Socket::initSocketFramework() == -1 ) {
+            return false;
+            }
+        }
+
+    #ifdef WIN_32
+    // no socketpair on Windows, so connect through loopback instead
+
+    SOCKET listener = socket( AF_INET, SOCK_STREAM, 0 );
+
+    if( listener == INVALID_SOCKET ) {
+        return false;
+        }
+
+    struct sockaddr_in address;
+    memset( &address, 0, sizeof( address ) );
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+    // any free port
+    address.sin_port = 0;
+
+    int addressLength = sizeof( address );
+
+    SOCKET a = INVALID_SOCKET;
+    SOCKET b = INVALID_SOCKET;
+
+    if( bind( listener, (struct sockaddr *)&address,
+              sizeof( address ) ) == 0 &&
+        getsockname( listener, (struct sockaddr *)&address,
+                     &addressLength ) == 0 &&
+        listen( listener, 1 ) == 0 ) {
+
+        a = socket( AF_INET, SOCK_STREAM, 0 );
+
+        if( a != INVALID_SOCKET &&
+            connect( a, (struct sockaddr *)&address,
+                     sizeof( address ) ) == 0 ) {
+
+            b = accept( listener, NULL, NULL );
+            }
+        }
+
+    closesocket( listener );
+
+    if( b == INVALID_SOCKET ) {
+        if( a != INVALID_SOCKET ) {
+            closesocket( a );
+            }
+        return false;
+        }
+
+    int ids[2] = { (int)a, (int)b };
+
+    #else
+
+    int ids[2];
+
+    if( socketpair( AF_UNIX, SOCK_STREAM, 0, ids ) != 0 ) {
+        return false;
+        }
+
+    #endif
+
+    *outA = new Socket();
+    ( *outA )->mNativeSocketID = ids[0];
+
+    *outB = new Socket();
+    ( *outB )->mNativeSocketID = ids[1];
+
+    return true;
+    }
+
+
+
+SocketPoller::SocketPoller()
+    : mWakeReader( NULL ), mWakeWriter( NULL ),
+      mWakePending( false ),
+      mNumRemovalsQueued( 0 ), mNumRemovalsMade( 0 ),
+      mNumRemovalWaiters( 0 ), mRemovalsMade( 0 ) {
+
+    if( makeSocketPair( &mWakeReader, &mWakeWriter ) ) {
+        // NULL other data marks wake-up socket
+        if( ! mPoll.addSocket( mWakeReader, NULL ) ) {
+            delete mWakeReader;
+            delete mWakeWriter;
+            mWakeReader = NULL;
+            mWakeWriter = NULL;
+            }
+        }
+    }
+
+
+
+SocketPoller::~SocketPoller() {
+    if( mWakeReader != NULL ) {
+        mPoll.removeSocket( mWakeReader );
+        delete mWakeReader;
+        delete mWakeWriter;
+        }
+    }
+
+
+
+char SocketPoller::isValid() {
+    return ( mWakeReader != NULL );
+    }
+
+
+
+void SocketPoller::wakeLocked() {
+    if( currentPoller == this ) {
+        // changes are made before next wait anyway
+        return;
+        }
+
+    if( ! mWakePending ) {
+        unsigned char wakeByte = 1;
+
+        // if the pair's buffer is full, there's a wake-up waiting already
+        mWakeWriter->send( &wakeByte, 1, false );
+        mWakePending = true;
+        }
+    }
+
+
+
+void SocketPoller::queueChange( SocketPollChange inChange ) {
+    mLock.lock();
+
+    mChanges.push_back( inChange );
+    wakeLocked();
+
+    mLock.unlock();
+    }
+
+
+
+void SocketPoller::removeAndWait( SocketRegistration *inRegistration ) {
+    mLock.lock();
+
+    mNumRemovalsQueued++;
+    int ticket = mNumRemovalsQueued;
+
+    SocketPollChange change = { SOCKET_POLL_CHANGE_REMOVE, inRegistration,
+                                0, ticket };
+    mChanges.push_back( change );
+    wakeLocked();
+
+    while( mNumRemovalsMade < ticket ) {
+        mNumRemovalWaiters++;
+        mLock.unlock();
+
+        // signaled once per waiter each time removals are made, so
+        // this may wake up for an earlier removal and need to go around
+        // again
+        mRemovalsMade.wait();
+
+        mLock.lock();
+        mNumRemovalWaiters--;
+        }
+
+    mLock.unlock();
+    }
+
+
+
+void SocketPoller::removeNow( SocketRegistration *inRegistration ) {
+    // remove from poll while socket still exists, since caller may be
+    // about to destroy it
+    if( inRegistration->sock != NULL ) {
+        mPoll.removeSocket( inRegistration->sock );
+        }
+    else {
+        mPoll.removeSocketServer( inRegistration->server );
+        }
+
+    inRegistration->removed = true;
+
+    // registration may still be in current batch of ready sockets, or
+    // in queued changes, so destroy it later, after those
+    SocketPollChange change = { SOCKET_POLL_CHANGE_REMOVE, inRegistration,
+                                0, 0 };
+    queueChange( change );
+    }
+
+
+
+char SocketPoller::applyChanges() {
+    mLock.lock();
+
+    SimpleVector<SocketPollChange> changes;
+    changes.push_back_other( &mChanges );
+    mChanges.deleteAll();
+
+    mWakePending = false;
+
+    mLock.unlock();
+
+
+    char stopped = false;
+    int lastTicket = 0;
+
+    for( int i=0; i<changes.size(); i++ ) {
+        SocketPollChange *c = changes.getElement( i );
+        SocketRegistration *r = c->registration;
+
+        switch( c->type ) {
+            case SOCKET_POLL_CHANGE_ADD:
+                if( r->removed ) {
+                    // removed from a handler before it was ever added
+                    break;
+                    }
+                if( r->sock != NULL ) {
+                    mPoll.addSocket( r->sock, (void *)r, c->flags );
+                    }
+                else {
+                    mPoll.addSocketServer( r->server, (void *)r );
+                    }
+                break;
+            case SOCKET_POLL_CHANGE_FLAGS:
+                if( ! r->removed ) {
+                    mPoll.setSocketFlags( r->sock, c->flags );
+                    }
+                break;
+            case SOCKET_POLL_CHANGE_REMOVE:
+                // no-op if already removed by removeNow
+                if( r->sock != NULL ) {
+                    mPoll.removeSocket( r->sock );
+                    }
+                else {
+                    mPoll.removeSocketServer( r->server );
+                    }
+                delete r;
+
+                if( c->removalTicket > lastTicket ) {
+                    lastTicket = c->removalTicket;
+                    }
+                break;
+            case SOCKET_POLL_CHANGE_STOP:
+                stopped = true;
+                break;
+            }
+        }
+
+
+    if( lastTicket > 0 ) {
+        mLock.lock();
+
+        mNumRemovalsMade = lastTicket;
+        int numWaiters = mNumRemovalWaiters;
+
+        mLock.unlock();
+
+        for( int i=0; i<numWaiters; i++ ) {
+            mRemovalsMade.signal();
+            }
+        }
+
+    return stopped;
+    }
+
+
+
+void SocketPoller::run() {
+    currentPoller = this;
+
+    SocketOrServer *ready[ SOCKET_POLLER_MAX_READY ];
+
+    // copied out of ready, since handlers can remove sockets (destroying
+    // their SocketOrServer) while the rest of the batch is handled
+    SocketRegistration *readyRegistrations[ SOCKET_POLLER_MAX_READY ];
+    char readReady[ SOCKET_POLLER_MAX_READY ];
+    char writeReady[ SOCKET_POLLER_MAX_READY ];
+
+    unsigned char drainBuffer[ 64 ];
+
+    while( ! applyChanges() ) {
+
+        int numReady = mPoll.wait( ready, SOCKET_POLLER_MAX_READY, -1 );
+
+        for( int i=0; i<numReady; i++ ) {
+            readyRegistrations[i] =
+                (SocketRegistration *)( ready[i]->otherData );
+            readReady[i] = ready[i]->readReady;
+            writeReady[i] = ready[i]->writeReady;
+            }
+
+        for( int i=0; i<numReady; i++ ) {
+            SocketRegistration *r = readyRegistrations[i];
+
+            if( r == NULL ) {
+                // wake-up, changes are applied at top of loop
+                mWakeReader->receive( drainBuffer, sizeof( drainBuffer ),
+                                      0 );
+                continue;
+                }
+
+            if( r->removed ) {
+                continue;
+                }
+
+            char keepWatching;
+
+            if( r->sock != NULL ) {
+                keepWatching = r->handler->socketReady( r->sock,
+                                                        readReady[i],
+                                                        writeReady[i] );
+                }
+            else {
+                keepWatching = r->handler->serverReady( r->server );
+                }
+
+            if( ! keepWatching && ! r->removed ) {
+                if( r->sock != NULL ) {
+                    SocketManager::unwatchSocket( r->sock );
+                    }
+                else {
+                    SocketManager::unwatchServer( r->server );
+                    }
+                }
+            }
+        }
+
+    currentPoller = NULL;
+    }
+
+
+
+SocketHandler::~SocketHandler() {
+    }
+
+
+
+char SocketHandler::serverReady( SocketServer *inServer ) {
+    return false;
+    }
+
+
 
 
 // static initialization
@@ -18,19 +497,28 @@ SocketManagerDataWrapper SocketManager::mDataWrapper;
 
 SocketManagerDataWrapper::SocketManagerDataWrapper()
     : mLock( new MutexLock() ),
-      mSocketVector( new SimpleVector<Socket *>() ) {
+      mSockets( new HashMap<Socket *, char>() ),
+      mPollers( new SimpleVector<SocketPoller *>() ),
+      mNextPoller( 0 ),
+      mRegistrations( new HashMap<void *, SocketRegistration *>() ) {
 
     }
 
 
 
 SocketManagerDataWrapper::~SocketManagerDataWrapper() {
-    int numSockets = mSocketVector->size();
+    // stop pollers before destroying sockets they might be watching
+    SocketManager::stopPollers();
 
-    for( int i=0; i<numSockets; i++ ) {
-        delete *( mSocketVector->getElement( i ) );
+    delete mPollers;
+    delete mRegistrations;
+
+    for( int i=0; i<mSockets->getNumSlots(); i++ ) {
+        if( mSockets->isSlotFilled( i ) ) {
+            delete mSockets->getSlotKey( i );
+            }
         }
-    delete mSocketVector;
+    delete mSockets;
 
     delete mLock;
     }
@@ -40,13 +528,11 @@ SocketManagerDataWrapper::~SocketManagerDataWrapper() {
 void SocketManager::addSocket( Socket *inSocket ) {
 
     MutexLock *lock = mDataWrapper.mLock;
-    SimpleVector<Socket *> *socketVector = mDataWrapper.mSocketVector;
 
-    
     lock->lock();
 
-    socketVector->push_back( inSocket );
-    
+    mDataWrapper.mSockets->insert( inSocket, true );
+
     lock->unlock();
     }
 
@@ -55,49 +541,252 @@ void SocketManager::addSocket( Socket *inSocket ) {
 void SocketManager::breakConnection( Socket *inSocket ) {
 
     MutexLock *lock = mDataWrapper.mLock;
-    SimpleVector<Socket *> *socketVector = mDataWrapper.mSocketVector;
 
     lock->lock();
 
-    int numSockets = socketVector->size();
-    char found = false;
-    
-    for( int i=0; i<numSockets && !found; i++ ) { 
+    if( mDataWrapper.mSockets->contains( inSocket ) ) {
+        inSocket->breakConnection();
+        }
+
+    lock->unlock();
+    }
+
+
+
+void SocketManager::destroySocket( Socket *inSocket ) {
+
+    // no more handler calls once this returns
+    unwatch( inSocket );
+
+
+    MutexLock *lock = mDataWrapper.mLock;
+
+    lock->lock();
+
+    if( mDataWrapper.mSockets->remove( inSocket ) ) {
+        delete inSocket;
+        }
 
-        Socket *currentSocket = *( socketVector->getElement( i ) );
+    lock->unlock();
+    }
+
+
+
+char SocketManager::startPollers( int inNumThreads ) {
+
+    MutexLock *lock = mDataWrapper.mLock;
+
+    lock->lock();
+
+    if( mDataWrapper.mPollers->size() > 0 || inNumThreads < 1 ) {
+        lock->unlock();
+        return false;
+        }
 
-        if( currentSocket == inSocket ) {
-            currentSocket->breakConnection();
-            found = true;
+    SimpleVector<SocketPoller *> *pollers = mDataWrapper.mPollers;
+
+    for( int i=0; i<inNumThreads; i++ ) {
+        SocketPoller *p = new SocketPoller();
+
+        if( ! p->isValid() ) {
+            delete p;
+
+            // stop ones already started
+            for( int j=0; j<pollers->size(); j++ ) {
+                SocketPoller *started = pollers->getElementDirect( j );
+
+                SocketPollChange stop = { SOCKET_POLL_CHANGE_STOP, NULL,
+                                          0, 0 };
+                started->queueChange( stop );
+                started->join();
+                delete started;
+                }
+            pollers->deleteAll();
+
+            lock->unlock();
+            return false;
             }
+
+        p->start();
+        pollers->push_back( p );
         }
-    
+
+    mDataWrapper.mNextPoller = 0;
+
     lock->unlock();
+    return true;
     }
 
 
 
-void SocketManager::destroySocket( Socket *inSocket ) {
+void SocketManager::stopPollers() {
 
     MutexLock *lock = mDataWrapper.mLock;
-    SimpleVector<Socket *> *socketVector = mDataWrapper.mSocketVector;
 
     lock->lock();
 
-    int numSockets = socketVector->size();
-    char found = false;
-    
-    for( int i=0; i<numSockets && !found; i++ ) { 
+    // later calls won't find these, so there's no one left to wait on
+    // them once lock is released
+    SimpleVector<SocketPoller *> pollers;
+    pollers.push_back_other( mDataWrapper.mPollers );
+    mDataWrapper.mPollers->deleteAll();
 
-        Socket *currentSocket = *( socketVector->getElement( i ) );
+    SimpleVector<SocketRegistration *> registrations;
 
-        if( currentSocket == inSocket ) {
-            delete currentSocket;
-            socketVector->deleteElement( i );
-            
-            found = true;
+    HashMap<void *, SocketRegistration *> *map = mDataWrapper.mRegistrations;
+
+    for( int i=0; i<map->getNumSlots(); i++ ) {
+        if( map->isSlotFilled( i ) ) {
+            registrations.push_back( *( map->getSlotValue( i ) ) );
             }
         }
-    
+    map->deleteAll();
+
     lock->unlock();
+
+
+    for( int i=0; i<pollers.size(); i++ ) {
+        SocketPoller *p = pollers.getElementDirect( i );
+
+        SocketPollChange stop = { SOCKET_POLL_CHANGE_STOP, NULL, 0, 0 };
+        p->queueChange( stop );
+        p->join();
+        delete p;
+        }
+
+    for( int i=0; i<registrations.size(); i++ ) {
+        delete registrations.getElementDirect( i );
+        }
+    }
+
+
+
+char SocketManager::watch( Socket *inSocket, SocketServer *inServer,
+                           SocketHandler *inHandler, int inFlags ) {
+
+    MutexLock *lock = mDataWrapper.mLock;
+
+    lock->lock();
+
+    SimpleVector<SocketPoller *> *pollers = mDataWrapper.mPollers;
+
+    void *key = (void *)inSocket;
+    if( inSocket == NULL ) {
+        key = (void *)inServer;
+        }
+
+    if( pollers->size() == 0 ||
+        mDataWrapper.mRegistrations->contains( key ) ) {
+        lock->unlock();
+        return false;
+        }
+
+    if( inSocket != NULL ) {
+        mDataWrapper.mSockets->insert( inSocket, true );
+        }
+
+
+    // spread sockets across pollers
+    if( mDataWrapper.mNextPoller >= pollers->size() ) {
+        mDataWrapper.mNextPoller = 0;
+        }
+    SocketPoller *p = pollers->getElementDirect( mDataWrapper.mNextPoller );
+    mDataWrapper.mNextPoller++;
+
+
+    SocketRegistration *r = new SocketRegistration;
+    r->sock = inSocket;
+    r->server = inServer;
+    r->handler = inHandler;
+    r->poller = p;
+    r->removed = false;
+
+    mDataWrapper.mRegistrations->insert( key, r );
+
+    SocketPollChange change = { SOCKET_POLL_CHANGE_ADD, r, inFlags, 0 };
+    p->queueChange( change );
+
+    lock->unlock();
+    return true;
+    }
+
+
+
+void SocketManager::unwatch( void *inSocketOrServer ) {
+
+    MutexLock *lock = mDataWrapper.mLock;
+
+    lock->lock();
+
+    SocketRegistration *r = NULL;
+
+    if( ! mDataWrapper.mRegistrations->lookup( inSocketOrServer, &r ) ) {
+        lock->unlock();
+        return;
+        }
+
+    mDataWrapper.mRegistrations->remove( inSocketOrServer );
+
+    lock->unlock();
+
+
+    SocketPoller *p = r->poller;
+
+    if( currentPoller == p ) {
+        // from one of p's handlers
+        p->removeNow( r );
+        }
+    else {
+        // handler calls can go on until p gets to the removal, which is
+        // after any call in progress finishes
+        p->removeAndWait( r );
+        }
+    }
+
+
+
+char SocketManager::watchSocket( Socket *inSocket, SocketHandler *inHandler,
+                                 int inFlags ) {
+    return watch( inSocket, NULL, inHandler, inFlags );
+    }
+
+
+
+char SocketManager::setWatchFlags( Socket *inSocket, int inFlags ) {
+
+    MutexLock *lock = mDataWrapper.mLock;
+
+    lock->lock();
+
+    SocketRegistration *r = NULL;
+
+    char found = mDataWrapper.mRegistrations->lookup( (void *)inSocket, &r );
+
+    if( found ) {
+        SocketPollChange change = { SOCKET_POLL_CHANGE_FLAGS, r, inFlags, 0 };
+        r->poller->queueChange( change );
+        }
+
+    lock->unlock();
+
+    return found;
+    }
+
+
+
+void SocketManager::unwatchSocket( Socket *inSocket ) {
+    unwatch( (void *)inSocket );
+    }
+
+
+
+char SocketManager::watchServer( SocketServer *inServer,
+                                 SocketHandler *inHandler ) {
+    return watch( NULL, inServer, inHandler, 0 );
+    }
+
+
+
+void SocketManager::unwatchServer( SocketServer *inServer ) {
+    unwatch( (void *)inServer );
     }
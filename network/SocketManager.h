@@ -3,6 +3,11 @@
  *
  * 2004-December-13   Jason Rohrer
  * Created.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Sockets kept in a hash map instead of a list.
+ * Optional poller threads that watch sockets with SocketPoll and call
+ * handlers when they are ready.
  */
 
 
@@ -13,8 +18,63 @@
 
 
 #include "minorGems/network/Socket.h"
+#include "minorGems/network/SocketServer.h"
+#include "minorGems/network/SocketPoll.h"
 #include "minorGems/system/MutexLock.h"
 #include "minorGems/util/SimpleVector.h"
+#include "minorGems/util/HashMap.h"
+
+
+
+/**
+ * Handles sockets (and socket servers) watched by SocketManager.
+ *
+ * Handler calls come from SocketManager's poller threads.  Calls for one
+ * socket always come from the same thread, one at a time, but calls for
+ * different sockets can come from several threads at once.
+ *
+ * Handlers must not block, since other sockets on the same poller thread
+ * wait while a handler runs.
+ */
+class SocketHandler {
+
+    public:
+
+        virtual ~SocketHandler();
+
+
+        /**
+         * Called when a watched socket is ready.
+         *
+         * @param inSocket the socket.
+         * @param inReadReady true if data can be read (or an error or
+         *   hang-up can be found by reading).
+         * @param inWriteReady true if data can be sent without blocking
+         *   (only if watched with SOCKET_POLL_WRITE).
+         *
+         * @return true to keep watching inSocket, or false to stop (same
+         *   as calling SocketManager::unwatchSocket).
+         */
+        virtual char socketReady( Socket *inSocket,
+                                  char inReadReady, char inWriteReady ) = 0;
+
+
+        /**
+         * Called when a watched server has a connection to accept.
+         *
+         * Default stops watching, so handlers that watch servers must
+         * override it.
+         *
+         * @return true to keep watching inServer, or false to stop.
+         */
+        virtual char serverReady( SocketServer *inServer );
+    };
+
+
+
+// defined in SocketManager.cpp
+class SocketPoller;
+typedef struct SocketRegistration SocketRegistration;
 
 
 
@@ -26,13 +86,20 @@ class SocketManagerDataWrapper {
     public:
 
         SocketManagerDataWrapper();
-        
+
         ~SocketManagerDataWrapper();
 
 
         MutexLock *mLock;
-        SimpleVector<Socket *> *mSocketVector;
 
+        // values unused
+        HashMap<Socket *, char> *mSockets;
+
+        SimpleVector<SocketPoller *> *mPollers;
+        int mNextPoller;
+
+        // watched sockets and servers, by pointer
+        HashMap<void *, SocketRegistration *> *mRegistrations;
     };
 
 
@@ -41,13 +108,17 @@ class SocketManagerDataWrapper {
  * A class that ensures thread-safe socket shutdown and destruction.
  *
  * Useful if a thread needs to break a socket that another thread is using.
+ *
+ * Can also run a few poller threads, each with a SocketPoll, that call
+ * SocketHandlers when sockets are ready, so that a server can handle
+ * thousands of sockets without a thread for each one.
  */
 class SocketManager {
 
     public:
 
 
-        
+
         /**
          * Adds a socket to this manager.
          *
@@ -56,7 +127,7 @@ class SocketManager {
          */
         static void addSocket( Socket *inSocket );
 
-        
+
 
         /**
          * Breaks the connection (both directions) associated with a socket.
@@ -68,21 +139,116 @@ class SocketManager {
         static void breakConnection( Socket *inSocket );
 
 
-        
+
         /**
          * Destroys a socket and removes it from this manager.
          *
+         * Stops watching the socket first, if it is watched.
+         *
          * @param inSocket the socket to destroy.
          */
         static void destroySocket( Socket *inSocket );
 
 
-        
+
+        /**
+         * Starts poller threads.
+         *
+         * Watched sockets are spread across the threads, so handlers for
+         * different sockets can run in parallel.
+         *
+         * @param inNumThreads the number of threads.  Defaults to 1.
+         *
+         * @return true on success, or false if already started or if a
+         *   thread's SocketPoll couldn't be set up.
+         */
+        static char startPollers( int inNumThreads = 1 );
+
+
+        /**
+         * Stops and joins poller threads, and stops watching all sockets
+         * and servers (sockets stay in this manager).
+         *
+         * Must not be called from a handler, or while other threads are
+         * still watching or unwatching.
+         */
+        static void stopPollers();
+
+
+
+        /**
+         * Watches a socket, calling a handler when it is ready.
+         *
+         * The socket is added to this manager if it isn't already.
+         *
+         * Can be called from any thread, including from handlers.
+         *
+         * @param inSocket the socket to watch.
+         *   Will be destroyed by this manager.
+         * @param inHandler the handler to call.
+         *   Destroyed by caller after inSocket is no longer watched.
+         * @param inFlags SOCKET_POLL_ flags, as for SocketPoll::addSocket.
+         *   Defaults to 0 (watch for reading).
+         *
+         * @return true on success, or false if pollers aren't started or
+         *   inSocket is already watched.
+         */
+        static char watchSocket( Socket *inSocket, SocketHandler *inHandler,
+                                 int inFlags = 0 );
+
+
+        /**
+         * Changes what is watched for on a socket.
+         *
+         * Takes effect before the socket's poller thread next waits.
+         *
+         * @return false if inSocket isn't watched.
+         */
+        static char setWatchFlags( Socket *inSocket, int inFlags );
+
+
+        /**
+         * Stops watching a socket.
+         *
+         * When called from outside of a handler, blocks until the socket's
+         * poller thread has finished any handler call for it.  From a
+         * handler, takes effect right away.  Either way, there are no
+         * handler calls for inSocket after this returns.
+         *
+         * @param inSocket the socket to stop watching.
+         */
+        static void unwatchSocket( Socket *inSocket );
+
+
+
+        /**
+         * Watches a socket server, calling a handler's serverReady when
+         * a connection is waiting.
+         *
+         * The server is not destroyed by this manager.
+         *
+         * @return true on success, or false if pollers aren't started or
+         *   inServer is already watched.
+         */
+        static char watchServer( SocketServer *inServer,
+                                 SocketHandler *inHandler );
+
+
+        // same as unwatchSocket, for servers
+        static void unwatchServer( SocketServer *inServer );
+
+
+
     private:
 
         // allocated statically to ensure destruction on program termination
         static SocketManagerDataWrapper mDataWrapper;
 
+
+        static char watch( Socket *inSocket, SocketServer *inServer,
+                           SocketHandler *inHandler, int inFlags );
+
+        static void unwatch( void *inSocketOrServer );
     };
 
 
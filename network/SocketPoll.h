@@ -1,22 +1,57 @@
 
 #include "Socket.h"
 #include "SocketServer.h"
+#include "SocketUDP.h"
+
+#include "minorGems/system/TimerWheel.h"
 
 
 typedef struct SocketOrServer {
-        // if false, then is server
+        // if false, then is server or UDP socket
         char isSocket;
         
-        // unused pointer is NULL
+        // unused pointers are NULL
         Socket *sock;
         SocketServer *server;
+        SocketUDP *udp;
 
         void *otherData;
+
+        // SOCKET_POLL_ flags this socket was added with
+        int flags;
+
+        // what was ready when last returned by wait
+        // (errors and hang-ups count as read-ready, since reading is
+        //  how they are discovered)
+        char readReady;
+        char writeReady;
         
     } SocketOrServer;
 
 
 
+// flags for addSocket and setSocketFlags
+enum SocketPollFlags {
+    // also watch for room to write (for sending queued data without
+    // blocking)
+    SOCKET_POLL_WRITE = 1,
+
+    // only report a socket when it becomes ready, not every time wait
+    // is called while it is still ready
+    // caller must then read (or write) until the socket would block,
+    // or it may not be reported again
+    // (only supported by the epoll implementation, others behave as
+    //  if this flag were not set)
+    SOCKET_POLL_EDGE_TRIGGERED = 2,
+
+    // don't watch for data to read (for pausing a socket whose data can't
+    // be handled yet, while still watching it for writing)
+    // errors and hang-ups may still be reported as read-ready
+    SOCKET_POLL_NO_READ = 4
+    };
+
+
+
 
 // watches a bunch of open sockets and socket servers for activity, and
 // returns ones that need attention
@@ -38,9 +73,19 @@ class SocketPoll {
 
         // watch for data ready to be read
         //
+        // inFlags are SOCKET_POLL_ flags OR'd together
+        //
         // returns true on success, false on failure
         char addSocket( Socket *inSock, 
-                        void *inOtherData = NULL );
+                        void *inOtherData = NULL,
+                        int inFlags = 0 );
+
+        // changes what is watched for on a socket that has been added
+        // (for example, to watch for writing only while there is
+        //  queued data to send)
+        //
+        // returns true on success, false on failure
+        char setSocketFlags( Socket *inSock, int inFlags );
         
         // watch for incomming connections ready to be accepted
         //
@@ -48,9 +93,16 @@ class SocketPoll {
         char addSocketServer( SocketServer *inServer, 
                               void *inOtherData = NULL );
 
+        // watch for datagrams ready to be received
+        //
+        // returns true on success, false on failure
+        char addSocketUDP( SocketUDP *inSock, 
+                           void *inOtherData = NULL );
+
 
         void removeSocket( Socket *inSock );
         void removeSocketServer( SocketServer *inServer );
+        void removeSocketUDP( SocketUDP *inSock );
 
         
         // waits for next event, and returns socket or server that
@@ -60,6 +112,40 @@ class SocketPoll {
         //
         // -1 for no timeout
         SocketOrServer *wait( int inTimeoutMS = -1 );
+
+
+        // waits for events, and returns as many sockets or servers that
+        // need attention as are ready (up to inMax), all at once
+        //
+        // outReady must have room for inMax pointers
+        //
+        // returns number returned in outReady, or 0 on timeout
+        //
+        // -1 for no timeout
+        int wait( SocketOrServer **outReady, int inMax, 
+                  int inTimeoutMS = -1 );
+
+
+        // same as above, but also wakes up in time for inTimers, and
+        // fires the timers that are due before returning
+        //
+        // returns 0 on timeout, or when woken only to fire timers
+        int waitWithTimers( SocketOrServer **outReady, int inMax,
+                            TimerWheel *inTimers,
+                            int inTimeoutMS = -1 );
+
+
+        // sends what it can from a socket's send queue without blocking
+        // (see Socket::sendOrQueue), and watches the socket for
+        // write-readiness only while bytes remain queued
+        //
+        // call when wait reports inSocket as write-ready, and after
+        // queueing data on a socket that had nothing queued
+        //
+        // does nothing for servers
+        //
+        // returns false on socket error
+        char drainSendQueue( SocketOrServer *inSocket );
         
         
         // used by platform-specific implementations
@@ -81,3 +167,41 @@ class SocketPoll {
     };
 
 
+
+inline int SocketPoll::waitWithTimers( SocketOrServer **outReady, 
+                                       int inMax,
+                                       TimerWheel *inTimers,
+                                       int inTimeoutMS ) {
+
+    int numReady = wait( outReady, inMax,
+                         inTimers->getMSUntilNext( inTimeoutMS ) );
+
+    inTimers->runExpired();
+
+    return numReady;
+    }
+
+
+
+inline char SocketPoll::drainSendQueue( SocketOrServer *inSocket ) {
+    if( ! inSocket->isSocket ) {
+        return true;
+        }
+    
+    int numLeft = inSocket->sock->flushSendQueue( false );
+
+    if( numLeft == -1 ) {
+        return false;
+        }
+    
+    char wantWrite = ( numLeft > 0 );
+    char watchingWrite = ( ( inSocket->flags & SOCKET_POLL_WRITE ) != 0 );
+    
+    if( wantWrite != watchingWrite ) {
+        // only a system call when queue becomes empty or non-empty
+        return setSocketFlags( inSocket->sock,
+                               inSocket->flags ^ SOCKET_POLL_WRITE );
+        }
+    
+    return true;
+    }
@@ -13,6 +13,10 @@
  * 2018-November-8  Jason Rohrer
  * Keeping socketID allocated on heap is a 17-year-old idea that was never
  * necessary, and is asking for trouble.  Make it an int on all platforms.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Added listening socket options:  port sharing between servers, deferred
+ * accept, and TCP Fast Open.
  */
 
 #include "minorGems/common.h"
@@ -46,8 +50,27 @@ class SocketServer {
 		 * @param inPort the port to listen on.
 		 * @param inMaxQueuedConnections the number of connection requests 
 		 *   that will be queued before further requests are refused.
+		 * @param inSharePort true to let several SocketServers (each made
+		 *   with this flag) listen on the same port at once, with the
+		 *   kernel spreading incoming connections between them
+		 *   (SO_REUSEPORT).  Lets each of several acceptor threads have
+		 *   its own server, instead of all waiting on one queue.
+		 *   Only on Linux 3.9 and later (see isPortSharingSupported).
+		 *   Defaults to false.
+		 * @param inDeferAcceptSeconds if greater than 0, connections
+		 *   are only accepted once the client has sent data, or after this
+		 *   many seconds (TCP_DEFER_ACCEPT), so acceptors aren't woken for
+		 *   clients that connect and say nothing.  Linux only.
+		 *   Defaults to 0.
+		 * @param inFastOpenQueueLength if greater than 0, clients may send
+		 *   data with their connection request (TCP Fast Open), and this
+		 *   many such requests can be pending at once.  Linux only.
+		 *   Defaults to 0.
 		 */
-		SocketServer( int inPort, int inMaxQueuedConnections );
+		SocketServer( int inPort, int inMaxQueuedConnections,
+                      char inSharePort = false,
+                      int inDeferAcceptSeconds = 0,
+                      int inFastOpenQueueLength = 0 );
 		
 
         
@@ -74,6 +97,11 @@ class SocketServer {
                                   char *outTimedOut = NULL );
 		
 
+
+        // true if inSharePort works on this platform
+        static char isPortSharingSupported();
+        
+
 		
 		/**
 		 * Used by platform-specific implementations.
@@ -20,6 +20,9 @@
  *
  * 2004-January-27   Jason Rohrer
  * Made functions virtual to support subclassing.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Added readAvailable.
  */
 
 
@@ -86,6 +89,11 @@ class SocketStream : public InputStream, public OutputStream {
         
         // in addition, -2 is returned if the read times out.
 		virtual long read( unsigned char *inBuffer, long inNumBytes );
+
+        // returns whatever has arrived, up to inMaxBytes, waiting (up to
+        // read timeout) only if nothing has
+        virtual long readAvailable( unsigned char *inBuffer,
+                                    long inMaxBytes );
 		
 		
 		// implements the OutputStream interface
@@ -138,6 +146,41 @@ inline long SocketStream::read( unsigned char *inBuffer, long inNumBytes ) {
 		
 		
 
+inline long SocketStream::readAvailable( unsigned char *inBuffer,
+                                         long inMaxBytes ) {
+    if( inMaxBytes < 1 ) {
+        return 0;
+        }
+
+    if( mReadTimeout != -1 ) {
+        // with a timeout, receive already returns what is available
+        return read( inBuffer, inMaxBytes );
+        }
+
+    // without one, receive waits for all bytes, so wait for first byte
+    // only, and then take whatever else is there without waiting
+    long numReceived = read( inBuffer, 1 );
+    
+    if( numReceived != 1 || inMaxBytes == 1 ) {
+        return numReceived;
+        }
+    
+    int numMore = mSocket->receive( &( inBuffer[1] ), inMaxBytes - 1, 0 );
+    
+    if( numMore == -1 ) {
+        // error after first byte, which the next read will see again
+        return 1;
+        }
+    else if( numMore < 0 ) {
+        // timed out, nothing more available
+        return 1;
+        }
+    
+    return 1 + numMore;
+    }
+		
+		
+
 inline long SocketStream::write( unsigned char *inBuffer, long inNumBytes ) {
     long numTotalSent = 0;
 
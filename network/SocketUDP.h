@@ -9,6 +9,12 @@
  *
  * 2004-November-9   Jason Rohrer
  * Added functions for comparing and copying UDPAddresses.
+ *
+ * 2026-October-14   Jason Rohrer
+ * Added batch send and receive into caller-supplied packet arrays.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Added access to native socket ID, for SocketPoll.
  */
 
 
@@ -29,6 +35,26 @@ struct UDPAddress {
 
 
 
+/**
+ * One datagram for batch sends and receives, with caller-allocated data.
+ */
+struct UDPPacket {
+        // where packet goes (send), or where it came from (receive)
+        struct UDPAddress mAddress;
+
+        // caller's buffer
+        unsigned char *mData;
+
+        // bytes to send, or bytes received
+        int mLength;
+
+        // size of mData, for receiving
+        // longer datagrams are cut off at this length
+        int mCapacity;
+    };
+
+
+
 
 /**
  * Network socket that can be used as an endpoint for sending and receiving
@@ -159,6 +185,50 @@ class SocketUDP {
                      unsigned char **outData,                     
                      long inTimeout = -1 );
 
+
+
+        /**
+         * Sends many datagrams at once (with one system call per batch of
+         * 64 where the platform supports it).
+         *
+         * @param inPackets the datagrams to send, using their mAddress,
+         *   mData, and mLength.
+         *   Destroyed by caller.
+         * @param inNumPackets the number of packets.
+         *
+         * @return the number of packets sent (those at the start of
+         *   inPackets), or -1 if the first one failed.
+         */
+        int sendBatch( struct UDPPacket *inPackets, int inNumPackets );
+
+
+
+        /**
+         * Receives many datagrams at once, without allocating anything.
+         *
+         * Waits (up to the timeout) for the first datagram, and then
+         * takes any others that are already waiting, up to inMaxPackets.
+         *
+         * @param inPackets array of packets with mData and mCapacity set.
+         *   mAddress and mLength are filled in for received packets.
+         *   Destroyed by caller.
+         * @param inMaxPackets the size of inPackets.
+         * @param inTimeout same as for receive.
+         *
+         * @return the number of packets received (at the start of
+         *   inPackets), -1 for a socket error, or -2 for a timeout.
+         */
+        int receiveBatch( struct UDPPacket *inPackets, int inMaxPackets,
+                          long inTimeout = -1 );
+
+        
+        
+        /**
+         * Gets the underlying socket descriptor, for watching this socket
+         * with SocketPoll.
+         */
+        int getNativeSocketID();
+
         
         
         /**
@@ -185,6 +255,13 @@ inline char SocketUDP::compare( struct UDPAddress *inFirst,
 
 
 
+inline int SocketUDP::getNativeSocketID() {
+    // the unix implementation (also used on win32) wraps one descriptor
+    return ( (int *)mNativeObjectPointer )[0];
+    }
+
+
+
 inline struct UDPAddress *SocketUDP::copy( struct UDPAddress *inAddress ) {
     struct UDPAddress *returnAddress = new struct UDPAddress;
 
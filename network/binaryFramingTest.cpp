@@ -0,0 +1,376 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+/**
+ * Checks BinaryFraming round trips (varints at every length, random
+ * messages split into random-sized chunks, corrupt and too-long length
+ * prefixes), and times parsing position updates from frames against
+ * parsing the same updates from #-terminated text.
+ */
+
+
+#include "minorGems/network/BinaryFraming.h"
+#include "minorGems/util/SimpleVector.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+
+static int numBad = 0;
+
+
+
+static double seconds() {
+    return (double)clock() / CLOCKS_PER_SEC;
+    }
+
+
+
+static uint64_t randomUInt() {
+    // random bit length, so all varint lengths come up
+    uint64_t x = ( (uint64_t)rand() << 33 ) ^ ( (uint64_t)rand() << 11 ) ^
+        (uint64_t)rand();
+
+    int bits = rand() % 65;
+    if( bits < 64 ) {
+        x &= ( (uint64_t)1 << bits ) - 1;
+        }
+    return x;
+    }
+
+
+
+// message with one of each field, from inSeed
+static void writeMessage( BinaryMessageWriter *inWriter, int inSeed ) {
+    srand( inSeed );
+
+    inWriter->reset();
+
+    inWriter->putUInt( randomUInt() );
+    inWriter->putInt( (int64_t)randomUInt() );
+    inWriter->putInt( - ( rand() % 100 ) );
+    inWriter->putByte( (unsigned char)rand() );
+    inWriter->putFloat( rand() / 7.0f );
+    inWriter->putDouble( rand() / 13.0 );
+
+    char string[ 300 ];
+    int length = rand() % 300;
+    for( int i=0; i<length; i++ ) {
+        string[i] = (char)( 'a' + rand() % 26 );
+        }
+    string[ length ] = '\0';
+    inWriter->putString( string );
+    }
+
+
+
+static char checkMessage( const unsigned char *inPayload, int inLength,
+                          int inSeed ) {
+    srand( inSeed );
+
+    BinaryMessageReader reader( inPayload, inLength );
+
+    char good = true;
+
+    if( reader.getUInt() != randomUInt() ) good = false;
+    if( reader.getInt() != (int64_t)randomUInt() ) good = false;
+    if( reader.getInt() != - ( rand() % 100 ) ) good = false;
+    if( reader.getByte() != (unsigned char)rand() ) good = false;
+    if( reader.getFloat() != rand() / 7.0f ) good = false;
+    if( reader.getDouble() != rand() / 13.0 ) good = false;
+
+    int length = rand() % 300;
+    char *string = reader.getString();
+
+    if( string == NULL || (int)strlen( string ) != length ) {
+        good = false;
+        }
+    else {
+        for( int i=0; i<length; i++ ) {
+            if( string[i] != (char)( 'a' + rand() % 26 ) ) {
+                good = false;
+                }
+            }
+        }
+    if( string != NULL ) {
+        delete [] string;
+        }
+
+    if( reader.hasFailed() || reader.getNumBytesLeft() != 0 ) {
+        good = false;
+        }
+
+    return good;
+    }
+
+
+
+int main() {
+
+    // varints at every bit length
+    for( int bits=0; bits<=64; bits++ ) {
+        uint64_t values[3];
+        values[0] = ( bits == 64 ) ? ~(uint64_t)0 : ( (uint64_t)1 << bits );
+        values[1] = values[0] - 1;
+        values[2] = values[0] + 1;
+
+        for( int v=0; v<3; v++ ) {
+            unsigned char bytes[ BINARY_FRAMING_MAX_VARINT_LENGTH ];
+            int numWritten = writeVarUInt( values[v], bytes );
+
+            uint64_t readValue = 0;
+            int numRead = readVarUInt( bytes, numWritten, &readValue );
+
+            if( numRead != numWritten || readValue != values[v] ||
+                readVarUInt( bytes, numWritten - 1, &readValue ) != 0 ) {
+                printf( "Varint round trip of %llu failed\n",
+                        (unsigned long long)values[v] );
+                numBad++;
+                }
+            }
+        }
+
+    unsigned char tooLong[ 11 ];
+    memset( tooLong, 0x80, 11 );
+    uint64_t value;
+    if( readVarUInt( tooLong, 11, &value ) != -1 ) {
+        printf( "Over-long varint accepted\n" );
+        numBad++;
+        }
+
+
+    // signed values stay short near zero
+    BinaryMessageWriter writer;
+    writer.putInt( -1 );
+    writer.putInt( 63 );
+    writer.putInt( -64 );
+    if( writer.getPayloadLength() != 3 ) {
+        printf( "Zigzag small values took %d bytes\n",
+                writer.getPayloadLength() );
+        numBad++;
+        }
+
+
+    // random messages through one stream, in random-sized chunks
+    int numMessages = 2000;
+
+    SimpleVector<unsigned char> stream;
+    for( int m=0; m<numMessages; m++ ) {
+        writeMessage( &writer, m );
+
+        int frameLength;
+        unsigned char *frame = writer.getFrame( &frameLength );
+        stream.appendArray( frame, frameLength );
+        }
+
+    int streamLength = stream.size();
+    unsigned char *streamBytes = stream.getElementArray();
+
+    for( int trial=0; trial<20; trial++ ) {
+        BinaryFrameReceiver receiver;
+
+        int position = 0;
+        int numReceived = 0;
+
+        srand( 1000 + trial );
+
+        // alternate feeding and receiving straight into buffer
+        while( position < streamLength ) {
+            int chunk = 1 + rand() % ( trial < 10 ? 16 : 5000 );
+            if( chunk > streamLength - position ) {
+                chunk = streamLength - position;
+                }
+
+            if( rand() % 2 == 0 ) {
+                receiver.feed( &( streamBytes[ position ] ), chunk );
+                }
+            else {
+                int space;
+                unsigned char *buffer =
+                    receiver.getReceiveSpace( chunk, &space );
+                if( space < chunk ) {
+                    printf( "Receive space too small\n" );
+                    numBad++;
+                    }
+                memcpy( buffer, &( streamBytes[ position ] ), chunk );
+                receiver.commitReceived( chunk );
+                }
+            position += chunk;
+
+            const unsigned char *payload;
+            int length;
+            int result;
+            while( ( result = receiver.nextFrame( &payload, &length ) )
+                   == 1 ) {
+                // checkMessage reseeds, so save our place
+                int nextSeed = rand();
+
+                if( ! checkMessage( payload, length, numReceived ) ) {
+                    printf( "Message %d wrong (trial %d)\n",
+                            numReceived, trial );
+                    numBad++;
+                    }
+                numReceived++;
+
+                srand( nextSeed );
+                }
+            if( result == -1 ) {
+                printf( "Stream reported corrupt\n" );
+                numBad++;
+                break;
+                }
+            }
+
+        if( numReceived != numMessages ||
+            receiver.getNumBytesWaiting() != 0 ) {
+            printf( "Received %d of %d messages (trial %d)\n",
+                    numReceived, numMessages, trial );
+            numBad++;
+            }
+        }
+    delete [] streamBytes;
+
+
+    // reading past end fails, and stays failed
+    writer.reset();
+    writer.putUInt( 5 );
+    int frameLength;
+    unsigned char *frame = writer.getFrame( &frameLength );
+
+    BinaryMessageReader shortReader( &( frame[1] ), frameLength - 1 );
+    shortReader.getUInt();
+    shortReader.getDouble();
+    int bytesLength;
+    if( ! shortReader.hasFailed() ||
+        shortReader.getUInt() != 0 ||
+        shortReader.getBytes( &bytesLength ) != NULL ) {
+        printf( "Reading past end didn't fail\n" );
+        numBad++;
+        }
+
+    // byte string length past end of payload
+    unsigned char badString[] = { 100, 'a', 'b' };
+    BinaryMessageReader badStringReader( badString, 3 );
+    if( badStringReader.getString() != NULL ||
+        ! badStringReader.hasFailed() ) {
+        printf( "Overlong byte string accepted\n" );
+        numBad++;
+        }
+
+
+    // too-long and corrupt length prefixes
+    BinaryFrameReceiver smallReceiver( 100 );
+    unsigned char hugePrefix[ 3 ];
+    writeVarUInt( 101, hugePrefix );
+    smallReceiver.feed( hugePrefix, 1 );
+
+    const unsigned char *payload;
+    int length;
+    if( smallReceiver.nextFrame( &payload, &length ) != -1 ) {
+        printf( "Over-long frame accepted\n" );
+        numBad++;
+        }
+
+    BinaryFrameReceiver corruptReceiver;
+    corruptReceiver.feed( tooLong, 11 );
+    if( corruptReceiver.nextFrame( &payload, &length ) != -1 ||
+        corruptReceiver.nextFrame( &payload, &length ) != -1 ) {
+        printf( "Corrupt prefix accepted\n" );
+        numBad++;
+        }
+
+
+    // timing, position updates (id x y) as text vs frames
+    int numUpdates = 1000000;
+
+    SimpleVector<char> text;
+    SimpleVector<unsigned char> binary;
+
+    srand( 7 );
+    long expectedSum = 0;
+    for( int u=0; u<numUpdates; u++ ) {
+        int id = rand() % 100000;
+        int x = rand() % 2000 - 1000;
+        int y = rand() % 2000 - 1000;
+        expectedSum += id + x + y;
+
+        char line[ 64 ];
+        int lineLength = snprintf( line, sizeof( line ),
+                                   "PU %d %d %d#", id, x, y );
+        text.appendArray( line, lineLength );
+
+        writer.reset();
+        writer.putUInt( id );
+        writer.putInt( x );
+        writer.putInt( y );
+        frame = writer.getFrame( &frameLength );
+        binary.appendArray( frame, frameLength );
+        }
+    text.push_back( '\0' );
+
+    char *textBytes = text.getElementArray();
+    unsigned char *binaryBytes = binary.getElementArray();
+    int binaryLength = binary.size();
+
+
+    double startTime = seconds();
+
+    long textSum = 0;
+    char *message = textBytes;
+    char *end;
+    while( ( end = strchr( message, '#' ) ) != NULL ) {
+        *end = '\0';
+        int id, x, y;
+        if( sscanf( message, "PU %d %d %d", &id, &x, &y ) == 3 ) {
+            textSum += id + x + y;
+            }
+        message = end + 1;
+        }
+    double textTime = seconds() - startTime;
+
+
+    startTime = seconds();
+
+    BinaryFrameReceiver receiver( 100 );
+    receiver.feed( binaryBytes, binaryLength );
+
+    long binarySum = 0;
+    while( receiver.nextFrame( &payload, &length ) == 1 ) {
+        BinaryMessageReader reader( payload, length );
+        int id = (int)reader.getUInt();
+        int x = (int)reader.getInt();
+        int y = (int)reader.getInt();
+        if( ! reader.hasFailed() ) {
+            binarySum += id + x + y;
+            }
+        }
+    double binaryTime = seconds() - startTime;
+
+    if( textSum != expectedSum || binarySum != expectedSum ) {
+        printf( "Parsed updates disagree\n" );
+        numBad++;
+        }
+
+    printf( "%d position updates:  text %d bytes in %.3f s, "
+            "frames %d bytes in %.3f s\n",
+            numUpdates, text.size() - 1, textTime,
+            binaryLength, binaryTime );
+
+    delete [] textBytes;
+    delete [] binaryBytes;
+
+
+    if( numBad == 0 ) {
+        printf( "All tests passed\n" );
+        return 0;
+        }
+    printf( "%d failures\n", numBad );
+    return 1;
+    }
@@ -38,12 +38,15 @@
  *
  * 2010-April-23   Jason Rohrer
  * ifa->if_addr can be NULL.
+ *
+ * 2026-October-14   Jason Rohrer
+ * Switched from gethostbyname to thread-safe getaddrinfo, so lookups no
+ * longer wait on each other.  Added IPv6 results and numerical addresses.
  */
 
 
 
 #include "minorGems/network/HostAddress.h"
-#include "minorGems/network/NetworkFunctionLocks.h"
 #include "minorGems/util/stringUtils.h"
 
 #include <unistd.h>
@@ -131,40 +134,53 @@ HostAddress *HostAddress::getNumericalAddress() {
         }
 
 
-    // need to use two function locks here
+    // unlike gethostbyname, getaddrinfo is thread-safe, so no lock needed
+    struct addrinfo hints;
+    memset( &hints, 0, sizeof( hints ) );
+
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    struct addrinfo *results;
+
+    if( getaddrinfo( mAddressString, NULL, &hints, &results ) != 0 ) {
+        return NULL;
+        }
 
-    // first, lock for gethostbyname
-    NetworkFunctionLocks::mGetHostByNameLock.lock();
-    struct hostent *host = gethostbyname( mAddressString );
 
-    if (host != NULL) {
+    // our sockets are IPv4, so prefer an IPv4 result if there is one
+    struct addrinfo *chosen = NULL;
 
-        // this line adapted from the
-        // Unix Socket FAQ
-        struct in_addr *inetAddress = (struct in_addr *) *host->h_addr_list;
+    for( struct addrinfo *r = results; r != NULL; r = r->ai_next ) {
+        if( r->ai_family == AF_INET ) {
+            chosen = r;
+            break;
+            }
+        else if( chosen == NULL && r->ai_family == AF_INET6 ) {
+            chosen = r;
+            }
+        }
 
 
-        // now lock for inet_ntoa
-        NetworkFunctionLocks::mInet_ntoaLock.lock();
-        // the returned string is statically allocated, so copy it
-        char *inetAddressString = stringDuplicate( inet_ntoa( *inetAddress ) );
+    char buffer[ NI_MAXHOST ];
 
-        NetworkFunctionLocks::mInet_ntoaLock.unlock();
+    char found = false;
 
-        
-        // done with returned hostent now, so unlock first lock
-        NetworkFunctionLocks::mGetHostByNameLock.unlock();
-        
-        return new HostAddress( inetAddressString, mPort );
+    if( chosen != NULL &&
+        getnameinfo( chosen->ai_addr, chosen->ai_addrlen,
+                     buffer, sizeof( buffer ), NULL, 0,
+                     NI_NUMERICHOST ) == 0 ) {
+        found = true;
         }
-    else {
 
-        // unlock first lock before returning
-        NetworkFunctionLocks::mGetHostByNameLock.unlock();
-        
-        return NULL;
+    freeaddrinfo( results );
+
+
+    if( found ) {
+        return new HostAddress( stringDuplicate( buffer ), mPort );
         }
 
+    return NULL;
     }
 
 
@@ -176,13 +192,18 @@ char HostAddress::isNumerical() {
     int isValid = inet_aton( mAddressString, &addressStruct );
 
 
-    if( isValid == 0 ) {
-        return false;
+    if( isValid != 0 ) {
+        return true;
         }
-    else {
+
+    struct in6_addr address6Struct;
+
+    if( inet_pton( AF_INET6, mAddressString, &address6Struct ) == 1 ) {
         return true;
         }
 
+    return false;
+
     }
 
 
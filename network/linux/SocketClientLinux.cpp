@@ -59,12 +59,15 @@
  *
  * 2010-January-26  Jason Rohrer
  * Fixed socklen_t on later versions of MacOSX.
+ *
+ * 2026-October-14   Jason Rohrer
+ * Host name lookups now go through HostLookupPool and its cache.
  */
 
 
 
 #include "minorGems/network/SocketClient.h"
-#include "minorGems/network/NetworkFunctionLocks.h"
+#include "minorGems/network/HostLookupPool.h"
 #include "minorGems/system/MutexLock.h"
 
 
@@ -222,8 +225,6 @@ Socket *SocketClient::connectToServer( HostAddress *inAddress,
           Result must be destroyed by caller.
 Adapted from the Unix Socket FAQ		  */
 struct in_addr *nameToAddress( char *inAddress ) {
-	struct hostent *host;
-    
     static struct in_addr saddr;
     struct in_addr *copiedSaddr = new struct in_addr;
 
@@ -242,22 +243,21 @@ struct in_addr *nameToAddress( char *inAddress ) {
 		}
 
 
-    // must keep this locked until we are done copying the in_addr out
-    // of the returned hostent
-    NetworkFunctionLocks::mGetHostByNameLock.lock();
+    // shared with other lookups, and cached
+    HostAddress address( stringDuplicate( inAddress ), 0 );
 
     char hostFound = false;
-    host = gethostbyname( inAddress );
-    if( host != NULL ) {
-        
-        memcpy( copiedSaddr,
-                *host->h_addr_list,
-                sizeof( struct in_addr ) );
-        
-        hostFound = true;
-        }
 
-    NetworkFunctionLocks::mGetHostByNameLock.unlock();
+    HostAddress *result = HostLookupPool::lookup( &address );
+
+    if( result != NULL ) {
+        // fails for IPv6 results, which our IPv4 sockets can't use
+        if( inet_aton( result->mAddressString, copiedSaddr ) != 0 ) {
+            hostFound = true;
+            }
+
+        delete result;
+        }
 
 
     
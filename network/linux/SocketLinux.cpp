@@ -83,6 +83,10 @@
  * 2019-January-24  Jason Rohrer
  * Don't need to do select at all on receive if timeout 0 (using MSG_DONTWAIT
  * anyway).  select was found to be a hotspot with profiler.
+ *
+ * 2026-October-14  Jason Rohrer
+ * Added sendv using sendmsg.
+ * Added sendFile using sendfile on Linux.
  */
 
 
@@ -94,6 +98,7 @@
 
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/errno.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
@@ -107,6 +112,18 @@
 #include <unistd.h>
 #include <signal.h>
 #include <errno.h>
+#include <limits.h>
+
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#endif
+
+
+
+#ifndef IOV_MAX
+// POSIX minimum
+#define IOV_MAX 16
+#endif
 
 
 
@@ -295,6 +312,150 @@ int Socket::send( unsigned char *inBuffer, int inNumBytes,
     }
 		
 		
+int Socket::sendv( SocketBuffer *inBuffers, int inNumBuffers,
+                   char inAllowedToBlock,
+                   char inAllowDelay ) {
+
+    if( inNumBuffers > IOV_MAX ) {
+        // caller sees a partial send and sends the rest later
+        inNumBuffers = IOV_MAX;
+        }
+    
+    // enough for most calls without touching the heap
+    struct iovec stackVectors[ 32 ];
+
+    struct iovec *vectors = stackVectors;
+
+    if( inNumBuffers > 32 ) {
+        vectors = new struct iovec[ inNumBuffers ];
+        }
+
+    for( int i=0; i<inNumBuffers; i++ ) {
+        vectors[i].iov_base = (void *)( inBuffers[i].data );
+        vectors[i].iov_len = inBuffers[i].length;
+        }
+
+    struct msghdr message;
+    memset( &message, 0, sizeof( message ) );
+
+    message.msg_iov = vectors;
+    message.msg_iovlen = inNumBuffers;
+
+
+    // MSG_DONTWAIT instead of toggling blocking mode with fcntl, which
+    // costs two extra system calls per send
+    int flags = 0;
+    
+    if( ! inAllowedToBlock ) {
+        flags = MSG_DONTWAIT;
+        }
+    
+    if( ! inAllowDelay ) {
+        // turn nodelay on
+        setNoDelay( 1 );
+        }
+
+    int returnValue = sendmsg( mNativeSocketID, &message, flags );
+
+    if( ! inAllowDelay ) {
+        // turn nodelay back off
+        setNoDelay( 0 );
+        }
+
+    if( vectors != stackVectors ) {
+        delete [] vectors;
+        }
+    
+    if( returnValue == -1 && ! inAllowedToBlock &&
+        ( errno == EAGAIN || errno == EWOULDBLOCK ) ) {
+        return -2;
+        }
+    return returnValue;
+    }
+		
+		
+		
+long Socket::sendFile( FILE *inFile, long inOffset, long inNumBytes ) {
+#if defined(__linux__)
+    // kernel copies file straight to socket
+    off_t offset = inOffset;
+    
+    long numSentDirect = 0;
+
+    // no delay, since whole file is handed over at once
+    setNoDelay( 1 );
+
+    while( numSentDirect < inNumBytes ) {
+        ssize_t result = sendfile( mNativeSocketID, fileno( inFile ),
+                                   &offset, inNumBytes - numSentDirect );
+        
+        if( result == -1 && errno == EINTR ) {
+            continue;
+            }
+        
+        if( result == -1 && numSentDirect == 0 && 
+            ( errno == EINVAL || errno == ENOSYS ) ) {
+            // file type not supported by sendfile, copy instead
+            break;
+            }
+        
+        if( result <= 0 ) {
+            setNoDelay( 0 );
+            return -1;
+            }
+        
+        numSentDirect += result;
+        }
+
+    setNoDelay( 0 );
+    
+    if( numSentDirect == inNumBytes ) {
+        return numSentDirect;
+        }
+#endif
+
+    if( fseek( inFile, inOffset, SEEK_SET ) != 0 ) {
+        return -1;
+        }
+
+    unsigned char buffer[ 16384 ];
+    
+    long numSent = 0;
+    
+    while( numSent < inNumBytes ) {
+        long numToRead = inNumBytes - numSent;
+        
+        if( numToRead > (long)sizeof( buffer ) ) {
+            numToRead = sizeof( buffer );
+            }
+        
+        int numRead = fread( buffer, 1, numToRead, inFile );
+        
+        if( numRead <= 0 ) {
+            return -1;
+            }
+        
+        int pos = 0;
+        
+        while( pos < numRead ) {
+            // no delay, since whole file is handed over at once
+            int result = send( &( buffer[pos] ), numRead - pos, 
+                               true, false );
+            
+            if( result <= 0 ) {
+                return -1;
+                }
+            pos += result;
+            }
+        
+        numSent += numRead;
+        }
+    
+    return numSent;
+    }
+
+
+
 int Socket::receive( unsigned char *inBuffer, int inNumBytes,
 	long inTimeout ) {
 	
@@ -6,6 +6,39 @@
 
 
 
+// events to register for a socket added with inFlags
+static unsigned int getSocketEvents( int inFlags ) {
+    // errors and hang-ups are always reported
+    unsigned int events = EPOLLERR | EPOLLHUP;
+
+    if( ! ( inFlags & SOCKET_POLL_NO_READ ) ) {
+        events |= EPOLLIN | EPOLLPRI;
+        }
+    if( inFlags & SOCKET_POLL_WRITE ) {
+        events |= EPOLLOUT;
+        }
+    if( inFlags & SOCKET_POLL_EDGE_TRIGGERED ) {
+        events |= EPOLLET;
+        }
+    return events;
+    }
+
+
+
+// fills in what's ready on s from returned epoll events
+static SocketOrServer *markReady( struct epoll_event *inEvent ) {
+    SocketOrServer *s = (SocketOrServer *)( inEvent->data.ptr );
+
+    s->readReady = 
+        ( inEvent->events & ( EPOLLIN | EPOLLPRI | EPOLLERR | EPOLLHUP ) )
+        != 0;
+    s->writeReady = ( inEvent->events & EPOLLOUT ) != 0;
+
+    return s;
+    }
+
+
+
 SocketPoll::SocketPoll() {
     int *epollStorage = new int[1];
 
@@ -38,7 +71,8 @@ SocketPoll::~SocketPoll() {
 
 
 
-char SocketPoll::addSocket( Socket *inSock, void *inOtherData ) {
+char SocketPoll::addSocket( Socket *inSock, void *inOtherData, 
+                            int inFlags ) {
 
     int *epollStorage = (int *)( mNativeObjectPointer );
 	int epollHandle = epollStorage[0];
@@ -57,13 +91,17 @@ char SocketPoll::addSocket( Socket *inSock, void *inOtherData ) {
     s->isSocket = true;
     s->sock = inSock;
     s->server = NULL;
+    s->udp = NULL;
     s->otherData = inOtherData;
+    s->flags = inFlags;
+    s->readReady = false;
+    s->writeReady = false;
     
     mWatchedList.push_back( s );
     
 
     struct epoll_event ev;
-    ev.events = EPOLLIN | EPOLLPRI | EPOLLERR | EPOLLHUP;
+    ev.events = getSocketEvents( inFlags );
     // clear entire union to suppress valgrind uninit errors on platforms
     // with 32-bit pointers
     ev.data.u64 = 0;
@@ -101,7 +139,11 @@ char SocketPoll::addSocketServer( SocketServer *inServer, void *inOtherData ) {
     s->isSocket = false;
     s->sock = NULL;
     s->server = inServer;
+    s->udp = NULL;
     s->otherData = inOtherData;
+    s->flags = 0;
+    s->readReady = false;
+    s->writeReady = false;
     
     mWatchedList.push_back( s );
     
@@ -125,6 +167,80 @@ char SocketPoll::addSocketServer( SocketServer *inServer, void *inOtherData ) {
 
 
 
+char SocketPoll::addSocketUDP( SocketUDP *inSock, void *inOtherData ) {
+    int *epollStorage = (int *)( mNativeObjectPointer );
+    int epollHandle = epollStorage[0];
+
+    if( epollHandle == -1 ) {
+        return false;
+        }
+    
+
+	int socketID = inSock->getNativeSocketID();
+
+
+
+    SocketOrServer *s = new SocketOrServer;
+    
+    s->isSocket = false;
+    s->sock = NULL;
+    s->server = NULL;
+    s->udp = inSock;
+    s->otherData = inOtherData;
+    s->flags = 0;
+    s->readReady = false;
+    s->writeReady = false;
+    
+    mWatchedList.push_back( s );
+    
+
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.u64 = 0;
+    ev.data.ptr = s;
+
+    int result = epoll_ctl( epollHandle, EPOLL_CTL_ADD, socketID, &ev );
+
+    if( result == 0 ) {
+        return true;
+        }
+    return false;    
+    }
+
+
+
+char SocketPoll::setSocketFlags( Socket *inSock, int inFlags ) {
+    int *epollStorage = (int *)( mNativeObjectPointer );
+    int epollHandle = epollStorage[0];
+
+    if( epollHandle == -1 ) {
+        return false;
+        }
+
+    for( int i=0; i<mWatchedList.size(); i++ ) {
+        SocketOrServer *s = *( mWatchedList.getElement( i ) );
+        if( s->sock == inSock ) {
+            
+            struct epoll_event ev;
+            ev.events = getSocketEvents( inFlags );
+            ev.data.u64 = 0;
+            ev.data.ptr = s;
+
+            int result = epoll_ctl( epollHandle, EPOLL_CTL_MOD, 
+                                    inSock->mNativeSocketID, &ev );
+            
+            if( result == 0 ) {
+                s->flags = inFlags;
+                return true;
+                }
+            return false;
+            }
+        }
+    return false;
+    }
+
+
+
 void SocketPoll::removeSocket( Socket *inSock ) {
     int *epollStorage = (int *)( mNativeObjectPointer );
     int epollHandle = epollStorage[0];
@@ -179,6 +295,34 @@ void SocketPoll::removeSocketServer( SocketServer *inServer ) {
 
 
 
+void SocketPoll::removeSocketUDP( SocketUDP *inSock ) {
+    int *epollStorage = (int *)( mNativeObjectPointer );
+    int epollHandle = epollStorage[0];
+
+    if( epollHandle == -1 ) {
+        return;
+        }
+
+	int socketID = inSock->getNativeSocketID();
+
+
+
+    for( int i=0; i<mWatchedList.size(); i++ ) {
+        SocketOrServer *s = *( mWatchedList.getElement( i ) );
+        if( s->udp == inSock ) {
+            struct epoll_event ev;
+            
+            epoll_ctl( epollHandle, EPOLL_CTL_DEL, socketID, &ev );
+
+            delete s;
+            mWatchedList.deleteElement( i );
+            return;
+            }
+        }
+    }
+
+
+
 
 SocketOrServer *SocketPoll::wait( int inTimeoutMS ) {
     int *epollStorage = (int *)( mNativeObjectPointer );
@@ -197,6 +341,45 @@ SocketOrServer *SocketPoll::wait( int inTimeoutMS ) {
     
     // else we have an event!
     
-    return (SocketOrServer *)( returnedEvents[0].data.ptr );
+    return markReady( &( returnedEvents[0] ) );
+    }
+
+
+
+int SocketPoll::wait( SocketOrServer **outReady, int inMax, 
+                      int inTimeoutMS ) {
+    int *epollStorage = (int *)( mNativeObjectPointer );
+    int epollHandle = epollStorage[0];
+
+    if( inMax <= 0 ) {
+        return 0;
+        }
+
+    // enough for most calls without touching the heap
+    struct epoll_event stackEvents[ 256 ];
+    
+    struct epoll_event *returnedEvents = stackEvents;
+
+    if( inMax > 256 ) {
+        returnedEvents = new struct epoll_event[ inMax ];
+        }
+    
+
+    int numEvents = epoll_wait( epollHandle, returnedEvents, inMax, 
+                                inTimeoutMS );
+
+    // negative on error, treated same as timeout
+    for( int i=0; i<numEvents; i++ ) {
+        outReady[i] = markReady( &( returnedEvents[i] ) );
+        }
+
+    if( returnedEvents != stackEvents ) {
+        delete [] returnedEvents;
+        }
+
+    if( numEvents < 0 ) {
+        return 0;
+        }
+    return numEvents;
     }
 
@@ -47,6 +47,13 @@
  *
  * 2010-January-26  Jason Rohrer
  * Fixed socklen_t on later versions of MacOSX.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Listening socket is non-blocking, so accept never hangs when another
+ * thread took the connection first.  Added port sharing, deferred accept,
+ * and TCP Fast Open options.  Accepted sockets are close-on-exec, using
+ * accept4 on Linux.  Waits with poll instead of select on Linux, since
+ * select can't watch descriptors past FD_SETSIZE.
  */
 
 
@@ -59,7 +66,10 @@
 #include <unistd.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
 
 
 
@@ -88,7 +98,34 @@ typedef int socklen_t;
 
 
 
-SocketServer::SocketServer( int inPort, int inMaxQueuedConnections ) {
+// sets an int socket option, printing a warning on failure
+static void setIntOption( int inSocketID, int inLevel, int inOption,
+                          int inValue, const char *inName ) {
+    int error = setsockopt( inSocketID, inLevel, inOption,
+                            &inValue, sizeof( inValue ) );
+    if( error == -1 ) {
+        printf( "Failed to set %s on listening socket\n", inName );
+        }
+    }
+
+
+
+char SocketServer::isPortSharingSupported() {
+#if defined( __linux__ ) && defined( SO_REUSEPORT )
+    return true;
+#else
+    // BSD has SO_REUSEPORT, but doesn't spread connections between
+    // sockets, so all go to one server
+    return false;
+#endif
+    }
+
+
+
+SocketServer::SocketServer( int inPort, int inMaxQueuedConnections,
+                            char inSharePort,
+                            int inDeferAcceptSeconds,
+                            int inFastOpenQueueLength ) {
 	int error = 0;
 	
 	if( !Socket::isFrameworkInitialized() ) {
@@ -105,7 +142,20 @@ SocketServer::SocketServer( int inPort, int inMaxQueuedConnections ) {
 		}
 	
 	// create the socket
+    // non-blocking, so that an accept after a wake-up can't hang if the
+    // connection was reset, or taken by another thread, in between
+#if defined( SOCK_NONBLOCK ) && defined( SOCK_CLOEXEC )
+	mNativeSocketID = socket( AF_INET, 
+                              SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 
+                              0 );
+#else
 	mNativeSocketID = socket( AF_INET, SOCK_STREAM, 0 );
+    
+    if( mNativeSocketID != -1 ) {
+        fcntl( mNativeSocketID, F_SETFL, O_NONBLOCK );
+        fcntl( mNativeSocketID, F_SETFD, FD_CLOEXEC );
+        }
+#endif
 	
 	int sockID = mNativeSocketID;
 	
@@ -134,7 +184,17 @@ SocketServer::SocketServer( int inPort, int inMaxQueuedConnections ) {
 		exit( 1 );
 		}
 	
-    	
+
+    if( inSharePort ) {
+        // must be set before bind, on every socket sharing the port
+#ifdef SO_REUSEPORT
+        setIntOption( sockID, SOL_SOCKET, SO_REUSEPORT, 1, "SO_REUSEPORT" );
+#else
+        printf( "Port sharing not supported on this platform\n" );
+#endif
+        }
+    
+
 	// bind socket to the port
     struct sockaddr_in address;
 	
@@ -149,6 +209,25 @@ SocketServer::SocketServer( int inPort, int inMaxQueuedConnections ) {
 		exit( 1 );
 		}
 	
+
+    if( inDeferAcceptSeconds > 0 ) {
+#ifdef TCP_DEFER_ACCEPT
+        setIntOption( sockID, IPPROTO_TCP, TCP_DEFER_ACCEPT, 
+                      inDeferAcceptSeconds, "TCP_DEFER_ACCEPT" );
+#else
+        printf( "Deferred accept not supported on this platform\n" );
+#endif
+        }
+    
+    if( inFastOpenQueueLength > 0 ) {
+#if defined( __linux__ ) && defined( TCP_FASTOPEN )
+        setIntOption( sockID, IPPROTO_TCP, TCP_FASTOPEN, 
+                      inFastOpenQueueLength, "TCP_FASTOPEN" );
+#else
+        printf( "TCP Fast Open not supported on this platform\n" );
+#endif
+        }
+
 	
 	// start listening for connections
 	error = listen( sockID, inMaxQueuedConnections );
@@ -164,8 +243,55 @@ SocketServer::SocketServer( int inPort, int inMaxQueuedConnections ) {
 SocketServer::~SocketServer() {
     close( mNativeSocketID );
     }
-	
-	
+
+
+
+// waits until listening socket is readable
+// returns 1 if readable, 0 on timeout, or -1 on error
+static int waitForConnection( int inSocketID, long inTimeoutInMilliseconds ) {
+
+#ifndef BSD
+    struct pollfd pollSet;
+    pollSet.fd = inSocketID;
+    pollSet.events = POLLIN;
+    pollSet.revents = 0;
+
+    int timeout = inTimeoutInMilliseconds;
+    
+    return poll( &pollSet, 1, timeout );
+#else
+    // this found in the Linux man page for select,
+    // but idea (which originally used poll) was found
+    // in the Unix Socket FAQ
+    fd_set rfds;
+    struct timeval tv;
+    struct timeval *tvPointer = NULL;
+        
+    // insert our socket descriptor into this set
+    FD_ZERO( &rfds );
+    FD_SET( inSocketID, &rfds );
+
+    if( inTimeoutInMilliseconds != -1 ) {
+        // convert our timeout into the structure's format
+        tv.tv_sec = inTimeoutInMilliseconds / 1000;
+        tv.tv_usec = ( inTimeoutInMilliseconds % 1000 ) * 1000 ;
+        tvPointer = &tv;
+        }
+    
+    return select( inSocketID + 1, &rfds, NULL, NULL, tvPointer );
+#endif
+    }
+
+
+
+static long getMilliseconds() {
+    struct timeval tv;
+    gettimeofday( &tv, NULL );
+    
+    return tv.tv_sec * 1000L + tv.tv_usec / 1000;
+    }
+
+
 	
 Socket *SocketServer::acceptConnection( long inTimeoutInMilliseconds,
                                         char *outTimedOut ) {
@@ -178,27 +304,70 @@ Socket *SocketServer::acceptConnection( long inTimeoutInMilliseconds,
         *outTimedOut = false;
         }
 
+    long startTime = 0;
+    if( inTimeoutInMilliseconds > 0 ) {
+        startTime = getMilliseconds();
+        }
     
-    if( inTimeoutInMilliseconds != -1 ) {
-        // if we have a timeout specified, select before accepting
-
-        // this found in the Linux man page for select,
-        // but idea (which originally used poll) was found
-        // in the Unix Socket FAQ
-        fd_set rfds;
-        struct timeval tv;
-        int retval;
+
+    // try accept first, since during a burst of connections one is 
+    // usually already waiting
+    while( true ) {
+        
+#if defined( __linux__ ) && defined( SOCK_CLOEXEC )
+        // accepted socket stays blocking, like Socket expects, but 
+        // shouldn't leak into child processes
+        int acceptedID = accept4( socketID, NULL, NULL, SOCK_CLOEXEC );
+#else
+        int acceptedID = accept( socketID, NULL, NULL );
+#endif
+        
+        if( acceptedID != -1 ) {
+#if !( defined( __linux__ ) && defined( SOCK_CLOEXEC ) )
+            // BSD accepted sockets inherit non-blocking flag from 
+            // listening socket
+            fcntl( acceptedID, F_SETFL, 0 );
+            fcntl( acceptedID, F_SETFD, FD_CLOEXEC );
+#endif
+            Socket *acceptedSocket = new Socket();
+            acceptedSocket->mNativeSocketID = acceptedID;
+	
+            //printf( "Connection received.\n" );
+        
+            return acceptedSocket;
+            }
+        
+        if( errno == EINTR || errno == ECONNABORTED ) {
+            // client gave up before we got to it, try next one
+            continue;
+            }
+        
+        if( errno != EAGAIN && errno != EWOULDBLOCK ) {
+            printf( "Failed to accept a network connection.\n" );
+            return NULL;
+            }
         
-        // insert our socket descriptor into this set
-        FD_ZERO( &rfds );
-        FD_SET( socketID, &rfds );
 
-        // convert our timeout into the structure's format
-        tv.tv_sec = inTimeoutInMilliseconds / 1000;
-        tv.tv_usec = ( inTimeoutInMilliseconds % 1000 ) * 1000 ;
+        // nothing waiting
+        
+        long timeLeft = inTimeoutInMilliseconds;
+        
+        if( inTimeoutInMilliseconds > 0 ) {
+            timeLeft = 
+                inTimeoutInMilliseconds - ( getMilliseconds() - startTime );
+            
+            if( timeLeft < 0 ) {
+                timeLeft = 0;
+                }
+            }
+        
+        int result = 0;
+        
+        if( timeLeft != 0 ) {
+            result = waitForConnection( socketID, timeLeft );
+            }
         
-        retval = select( socketID + 1, &rfds, NULL, NULL, &tv );
-        if( retval == 0 ) {
+        if( result == 0 ) {
             // timeout
             if( outTimedOut != NULL ) {
                 *outTimedOut = true;
@@ -206,37 +375,12 @@ Socket *SocketServer::acceptConnection( long inTimeoutInMilliseconds,
 
             return NULL;
             }
-
         
-        }
-    
-    
-    int acceptedID = accept( socketID, NULL, NULL );
-
-    if( acceptedID == -1 ) {
-		printf( "Failed to accept a network connection.\n" );
-		return NULL;
-		}
-    else {
-
-        Socket *acceptedSocket = new Socket();
-        acceptedSocket->mNativeSocketID = acceptedID;
-	
-        //printf( "Connection received.\n" );
+        if( result == -1 && errno != EINTR ) {
+            printf( "Failed to accept a network connection.\n" );
+            return NULL;
+            }
         
-        return acceptedSocket;
+        // readable (or interrupted), try accept again
         }
-	}	
-
-
-
-
-
-
-
-
-
-
-
-
-
+	}
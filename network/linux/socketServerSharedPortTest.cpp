@@ -0,0 +1,176 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+/**
+ * Connect storm against several acceptor threads, each with its own
+ * SocketServer sharing one port, to check that the kernel spreads
+ * connections between them and to time how fast they are all accepted.
+ *
+ * Usage:  socketServerSharedPortTest port [numAcceptors] [numConnections]
+ *   Defaults to 4 acceptors and 2000 connections.
+ *
+ * With 1 acceptor, the port isn't shared, for comparison.
+ */
+
+
+#include "minorGems/network/Socket.h"
+#include "minorGems/network/SocketServer.h"
+#include "minorGems/system/Thread.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+
+
+static double getSeconds() {
+    struct timeval tv;
+    gettimeofday( &tv, NULL );
+    return tv.tv_sec + tv.tv_usec / 1000000.0;
+    }
+
+
+
+class AcceptorThread : public Thread {
+    public:
+        
+        AcceptorThread( SocketServer *inServer )
+                : mServer( inServer ), mNumAccepted( 0 ), mStop( false ) {
+            }
+        
+        virtual void run() {
+            while( ! mStop ) {
+                char timedOut;
+                Socket *sock = mServer->acceptConnection( 100, &timedOut );
+                
+                if( sock != NULL ) {
+                    mNumAccepted++;
+                    delete sock;
+                    }
+                }
+            }
+        
+        SocketServer *mServer;
+        volatile int mNumAccepted;
+        volatile char mStop;
+    };
+
+
+
+void usage( char *inAppName );
+
+
+
+int main( int inNumArgs, char **inArgs ) {
+
+    if( inNumArgs < 2 ) {
+        usage( inArgs[0] );
+        }
+
+    int port;
+    int numAcceptors = 4;
+    int numConnections = 2000;
+
+    if( sscanf( inArgs[1], "%d", &port ) != 1 ) {
+        usage( inArgs[0] );
+        }
+    if( inNumArgs > 2 ) {
+        sscanf( inArgs[2], "%d", &numAcceptors );
+        }
+    if( inNumArgs > 3 ) {
+        sscanf( inArgs[3], "%d", &numConnections );
+        }
+
+    char share = ( numAcceptors > 1 );
+    
+    if( share && ! SocketServer::isPortSharingSupported() ) {
+        printf( "Port sharing not supported here, using 1 acceptor\n" );
+        share = false;
+        numAcceptors = 1;
+        }
+    
+
+    AcceptorThread **acceptors = new AcceptorThread*[ numAcceptors ];
+    
+    for( int i=0; i<numAcceptors; i++ ) {
+        acceptors[i] = new AcceptorThread( 
+            new SocketServer( port, 1000, share ) );
+        acceptors[i]->start();
+        }
+    
+
+    struct sockaddr_in address;
+    memset( &address, 0, sizeof( address ) );
+    address.sin_family = AF_INET;
+    address.sin_port = htons( port );
+    address.sin_addr.s_addr = inet_addr( "127.0.0.1" );
+
+    double startTime = getSeconds();
+    
+    int numConnected = 0;
+    
+    for( int i=0; i<numConnections; i++ ) {
+        int sockID = socket( AF_INET, SOCK_STREAM, 0 );
+        
+        if( connect( sockID, (struct sockaddr *)&address, 
+                     sizeof( address ) ) == 0 ) {
+            numConnected++;
+            }
+        close( sockID );
+        }
+    
+    int numAccepted = 0;
+    
+    // give acceptors up to 5 seconds to catch up
+    while( getSeconds() - startTime < 5 ) {
+        numAccepted = 0;
+        for( int i=0; i<numAcceptors; i++ ) {
+            numAccepted += acceptors[i]->mNumAccepted;
+            }
+        if( numAccepted >= numConnected ) {
+            break;
+            }
+        usleep( 1000 );
+        }
+    
+    double totalTime = getSeconds() - startTime;
+    
+    printf( "%d connected, %d accepted in %.3f s (%.0f/s)\n",
+            numConnected, numAccepted, totalTime, numAccepted / totalTime );
+
+    for( int i=0; i<numAcceptors; i++ ) {
+        printf( "  acceptor %d:  %d\n", i, acceptors[i]->mNumAccepted );
+        
+        acceptors[i]->mStop = true;
+        }
+    
+    for( int i=0; i<numAcceptors; i++ ) {
+        acceptors[i]->join();
+        delete acceptors[i]->mServer;
+        delete acceptors[i];
+        }
+    delete [] acceptors;
+    
+    if( numAccepted != numConnected ) {
+        return 1;
+        }
+    return 0;
+    }
+
+
+    
+void usage( char *inAppName ) {
+    printf( "Usage:\n" );
+    printf( "    %s port_number [num_acceptors] [num_connections]\n", 
+            inAppName );
+    exit( 1 );
+    }
@@ -6,6 +6,10 @@
  *
  * 2003-August-14   Jason Rohrer
  * Changed to output message history to file.
+ *
+ * 2026-October-14   Jason Rohrer
+ * Replaced linear search of history with a rotating pair of Bloom
+ * filters and a small exact window of recent IDs.
  */
 
 
@@ -16,32 +20,230 @@
 
 #include <time.h>
 #include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+
+
+// 64-bit FNV-1a, then mixed (MurmurHash3 finalizer), since FNV leaves
+// the high bits of short, similar IDs poorly mixed
+static uint64_t hashID( const char *inID ) {
+    uint64_t hash = 14695981039346656037ULL;
+
+    for( int i=0; inID[i] != '\0'; i++ ) {
+        hash ^= (unsigned char)( inID[i] );
+        hash *= 1099511628211ULL;
+        }
+    
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDULL;
+    hash ^= hash >> 33;
+    hash *= 0xC4CEB9FE1A85EC53ULL;
+    hash ^= hash >> 33;
+
+    return hash;
+    }
 
 
 
-DuplicateMessageDetector::DuplicateMessageDetector( int inMessageHistorySize )
+static char isPrime( uint64_t inX ) {
+    if( inX < 2 ) {
+        return false;
+        }
+    
+    for( uint64_t d = 2; d * d <= inX; d++ ) {
+        if( inX % d == 0 ) {
+            return false;
+            }
+        }
+    
+    return true;
+    }
+
+
+
+DuplicateMessageDetector::DuplicateMessageDetector( int inMessageHistorySize,
+                                                    double inFalsePositiveRate )
     : mMaxHistorySize( inMessageHistorySize ),
       mLock( new MutexLock() ),
-      mSeenIDs( new SimpleVector<char *>() ),
+      mActiveFilter( 0 ),
+      mActiveCount( 0 ),
+      mWindowCount( 0 ),
+      mWindowNextPos( 0 ),
       mTotalMessageCount( 0 ),
       mHistoryOutputFile( NULL ) {
 
+    if( mMaxHistorySize < 1 ) {
+        mMaxHistorySize = 1;
+        }
+    
+    // both filters are checked, so each gets half the rate
+    double filterRate = inFalsePositiveRate / 2;
+    
+    if( filterRate <= 0 || filterRate >= 1 ) {
+        filterRate = 0.00005;
+        }
+    
+    // optimal size and hash count for a Bloom filter
+    double bitsPerID = - log( filterRate ) / ( log( 2.0 ) * log( 2.0 ) );
+
+    mFilterBits = (uint64_t)( bitsPerID * mMaxHistorySize ) + 64;
+    
+    // prime, so that probe steps (see isInFilter) share no factor with
+    // the size
+    while( ! isPrime( mFilterBits ) ) {
+        mFilterBits++;
+        }
+    
+    mNumHashes = (int)( bitsPerID * log( 2.0 ) + 0.5 );
+    
+    if( mNumHashes < 1 ) {
+        mNumHashes = 1;
+        }
+
+    for( int f=0; f<2; f++ ) {
+        mFilters[f] = new unsigned char[ ( mFilterBits + 7 ) / 8 ];
+        memset( mFilters[f], 0, ( mFilterBits + 7 ) / 8 );
+        }
+    
+
+    mWindowSize = DUPLICATE_MESSAGE_WINDOW_SIZE;
+    
+    if( mWindowSize > mMaxHistorySize ) {
+        mWindowSize = mMaxHistorySize;
+        }
+    
+    mWindowHashes = new uint64_t[ mWindowSize ];
+    mWindowNext = new int[ mWindowSize ];
+    
+    // power of 2, at least twice window size, for short chains
+    int numBuckets = 1;
+    while( numBuckets < 2 * mWindowSize ) {
+        numBuckets *= 2;
+        }
+    
+    mWindowBucketMask = numBuckets - 1;
+    mWindowBuckets = new int[ numBuckets ];
+    
+    for( int i=0; i<numBuckets; i++ ) {
+        mWindowBuckets[i] = -1;
+        }
+    
+
     mHistoryOutputFile = fopen( "messageHistory.log", "w" );
     }
 
 
 
 DuplicateMessageDetector::~DuplicateMessageDetector() {
-    int numIDs = mSeenIDs->size();
+    delete [] mFilters[0];
+    delete [] mFilters[1];
 
-    for( int i=0; i<numIDs; i++ ) {
-        delete [] *( mSeenIDs->getElement( i ) );
-        }
-    delete mSeenIDs;
+    delete [] mWindowHashes;
+    delete [] mWindowNext;
+    delete [] mWindowBuckets;
 
     delete mLock;
 
-    fclose( mHistoryOutputFile );
+    if( mHistoryOutputFile != NULL ) {
+        fclose( mHistoryOutputFile );
+        }
+    }
+
+
+
+char DuplicateMessageDetector::isInWindow( uint64_t inHash ) {
+    int i = mWindowBuckets[ inHash & mWindowBucketMask ];
+    
+    while( i != -1 ) {
+        if( mWindowHashes[i] == inHash ) {
+            return true;
+            }
+        i = mWindowNext[i];
+        }
+    
+    return false;
+    }
+
+
+
+void DuplicateMessageDetector::addToWindow( uint64_t inHash ) {
+    int pos = mWindowNextPos;
+    
+    if( mWindowCount == mWindowSize ) {
+        // unlink oldest, which is in this slot
+        int *link = 
+            &( mWindowBuckets[ mWindowHashes[pos] & mWindowBucketMask ] );
+        
+        while( *link != pos ) {
+            link = &( mWindowNext[ *link ] );
+            }
+        *link = mWindowNext[pos];
+        }
+    else {
+        mWindowCount++;
+        }
+    
+    mWindowHashes[pos] = inHash;
+    
+    int *bucket = &( mWindowBuckets[ inHash & mWindowBucketMask ] );
+    
+    mWindowNext[pos] = *bucket;
+    *bucket = pos;
+    
+    mWindowNextPos = ( pos + 1 ) % mWindowSize;
+    }
+
+
+
+// bit positions come from the two halves of the 64-bit hash by enhanced
+// double hashing (step grows by i each probe), since plain h1 + i * h2
+// gives correlated probes and several times the expected false positive
+// rate once we have many hashes in a small filter
+
+char DuplicateMessageDetector::isInFilter( int inFilter, uint64_t inHash ) {
+    unsigned char *filter = mFilters[ inFilter ];
+    
+    uint64_t bit = ( inHash & 0xFFFFFFFF ) % mFilterBits;
+    uint64_t step = ( inHash >> 32 ) % mFilterBits;
+    
+    for( int i=0; i<mNumHashes; i++ ) {
+        
+        if( ( filter[ bit >> 3 ] & ( 1 << ( bit & 7 ) ) ) == 0 ) {
+            return false;
+            }
+
+        bit = ( bit + step ) % mFilterBits;
+        step = ( step + i + 1 ) % mFilterBits;
+        }
+    
+    return true;
+    }
+
+
+
+void DuplicateMessageDetector::addToActiveFilter( uint64_t inHash ) {
+    if( mActiveCount >= mMaxHistorySize ) {
+        // forget oldest filter's IDs
+        mActiveFilter = 1 - mActiveFilter;
+        memset( mFilters[ mActiveFilter ], 0, ( mFilterBits + 7 ) / 8 );
+        mActiveCount = 0;
+        }
+    
+    unsigned char *filter = mFilters[ mActiveFilter ];
+    
+    uint64_t bit = ( inHash & 0xFFFFFFFF ) % mFilterBits;
+    uint64_t step = ( inHash >> 32 ) % mFilterBits;
+    
+    for( int i=0; i<mNumHashes; i++ ) {
+        
+        filter[ bit >> 3 ] |= (unsigned char)( 1 << ( bit & 7 ) );
+
+        bit = ( bit + step ) % mFilterBits;
+        step = ( step + i + 1 ) % mFilterBits;
+        }
+    
+    mActiveCount++;
     }
 
 
@@ -51,22 +253,27 @@ char DuplicateMessageDetector::checkIfMessageSeen( char *inMessageUniqueID ) {
 
     mTotalMessageCount++;
     
-    int numIDs = mSeenIDs->size();
+    uint64_t hash = hashID( inMessageUniqueID );
 
-    char matchSeen = false;
-    for( int i=0; i<numIDs && !matchSeen; i++ ) {
+    // recent IDs are already in a filter
+    char matchSeen = isInWindow( hash );
 
-        char *otherID = *( mSeenIDs->getElement( i ) ); 
+    if( ! matchSeen ) {
+        char inActiveFilter = isInFilter( mActiveFilter, hash );
+        
+        matchSeen = inActiveFilter || isInFilter( 1 - mActiveFilter, hash );
 
-        if( strcmp( otherID, inMessageUniqueID ) == 0 ) {
-            // match
-
-            // push the ID back to the end of the queue
-            mSeenIDs->deleteElement( i );
-            mSeenIDs->push_back( otherID );
-            matchSeen = true;
+        if( ! matchSeen ) {
+            addToWindow( hash );
+            }
+        
+        // as before, a seen ID is moved to the front of the history, so
+        // that IDs that keep arriving are never forgotten
+        if( ! inActiveFilter ) {
+            addToActiveFilter( hash );
             }
         }
+    
 
     if( mHistoryOutputFile != NULL ) {
         fprintf( mHistoryOutputFile,
@@ -74,37 +281,18 @@ char DuplicateMessageDetector::checkIfMessageSeen( char *inMessageUniqueID ) {
                  mTotalMessageCount,
                  (int)( time( NULL ) ),
                  inMessageUniqueID );
-        }
-    
-    
-    if( !matchSeen ) {
-
-        // add the message
-        mSeenIDs->push_back( stringDuplicate( inMessageUniqueID ) );
 
-        // make sure history not too long
-        if( mSeenIDs->size() > mMaxHistorySize ) {
-            delete [] *( mSeenIDs->getElement( 0 ) );
-            mSeenIDs->deleteElement( 0 );
-            }
-
-        if( mHistoryOutputFile != NULL ) {
+        if( !matchSeen ) {
             fprintf( mHistoryOutputFile, "\n" );
             }
-        }
-    else {
-        // add duplicate tag
-        if( mHistoryOutputFile != NULL ) {
+        else {
+            // add duplicate tag
             fprintf( mHistoryOutputFile, " D\n" );
             }
-        }
-
-    if( mHistoryOutputFile != NULL ) {
+        
         fflush( mHistoryOutputFile );
         }
     
     mLock->unlock();    
     return matchSeen;    
     }
-
-
@@ -6,6 +6,10 @@
  *
  * 2003-August-14   Jason Rohrer
  * Changed to output message history to file.
+ *
+ * 2026-October-14   Jason Rohrer
+ * Replaced linear search of history with a rotating pair of Bloom
+ * filters and a small exact window of recent IDs.
  */
 
 
@@ -21,6 +25,12 @@
 
 
 #include <stdio.h>
+#include <stdint.h>
+
+
+
+// most recent IDs remembered exactly
+#define DUPLICATE_MESSAGE_WINDOW_SIZE 1024
 
 
 
@@ -28,6 +38,20 @@
  * Class that detects duplicates of past messages so that they can be
  * discarded.
  *
+ * Each check takes constant time, and memory is fixed when constructed,
+ * so the history can hold millions of IDs.
+ *
+ * IDs go into a pair of Bloom filters, each holding up to the history
+ * size.  When the newer one fills, the older one is cleared and takes
+ * its place, so between one and two history sizes of IDs are
+ * remembered.  A Bloom filter can mistake a new ID for one seen before
+ * (at a rate set when constructed), but never the other way around.
+ *
+ * The most recent IDs are also remembered exactly in a small hash set,
+ * so that duplicates arriving soon after, the common case when a
+ * message floods through a mesh, are found without touching the
+ * filters.
+ *
  * @author Jason Rohrer
  */
 class DuplicateMessageDetector {
@@ -43,8 +67,12 @@ class DuplicateMessageDetector {
          * @param inMessageHistorySize the number of message IDs to
          *   maintain in our history.
          *   Defaults to 1000.
+         * @param inFalsePositiveRate the highest rate at which new messages
+         *   can be reported as seen before.
+         *   Defaults to 0.0001.
          */        
-        DuplicateMessageDetector( int inMessageHistorySize = 1000 );
+        DuplicateMessageDetector( int inMessageHistorySize = 1000,
+                                  double inFalsePositiveRate = 0.0001 );
 
         ~DuplicateMessageDetector();
 
@@ -67,7 +95,35 @@ class DuplicateMessageDetector {
 
         int mMaxHistorySize;
         MutexLock *mLock;
-        SimpleVector<char *> *mSeenIDs;
+
+
+        // IDs are added to mFilters[ mActiveFilter ] until it holds
+        // mMaxHistorySize, then the other is cleared and becomes active
+        unsigned char *mFilters[2];
+        uint64_t mFilterBits;
+        int mNumHashes;
+
+        int mActiveFilter;
+        int mActiveCount;
+
+        
+        // ring of ID hashes, oldest replaced first
+        uint64_t *mWindowHashes;
+        int mWindowSize;
+        int mWindowCount;
+        int mWindowNextPos;
+
+        // chained hash table indexing into ring, -1 for end of chain
+        int *mWindowBuckets;
+        int mWindowBucketMask;
+        int *mWindowNext;
+        
+
+        char isInWindow( uint64_t inHash );
+        void addToWindow( uint64_t inHash );
+
+        char isInFilter( int inFilter, uint64_t inHash );
+        void addToActiveFilter( uint64_t inHash );
         
 
         int mTotalMessageCount;
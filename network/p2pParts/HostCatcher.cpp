@@ -17,19 +17,43 @@
  * Changed to convert to numerical form before comparing against host list.
  * Changed getHost to return hosts in random order.
  * Added a getOrderedHost function that returns hosts in linear order.
+ *
+ * 2026-October-14   Jason Rohrer
+ * Replaced linear host list with hashed, scored records and a heap of
+ * when each host is next due.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Removed hosts taken out of due queue by handle.  No more stale entries
+ * or queue rebuilds.
+ * New records start zeroed.
  */
 
 
 
 #include "minorGems/network/p2pParts/HostCatcher.h"
 #include "minorGems/util/stringUtils.h"
+#include "minorGems/system/Time.h"
+
+// StdRandomSource.h needs Time.h and math.h included before it
+#include <math.h>
 #include "minorGems/util/random/StdRandomSource.h"
 
 
 
+// round trip at which a host's score is halved
+#define HOST_CATCHER_RTT_SCALE_SECONDS 0.25
+
+// age since added at which a host's score is halved
+#define HOST_CATCHER_AGE_SCALE_SECONDS 3600
+
+// hosts compared when picking one to evict
+#define HOST_CATCHER_EVICTION_SAMPLES 8
+
+
+
 HostCatcher::HostCatcher( int inMaxListSize )
     : mMaxListSize( inMaxListSize ),
-      mHostVector( new SimpleVector<HostAddress *>() ),
+      mPass( 0 ),
       mLock( new MutexLock() ),
       mRandSource( new StdRandomSource() ) {
     
@@ -40,94 +64,225 @@ HostCatcher::HostCatcher( int inMaxListSize )
 HostCatcher::~HostCatcher() {
     mLock->lock();
     
-    int numHosts = mHostVector->size();
-
-    for( int i=0; i<numHosts; i++ ) {
-        delete *( mHostVector->getElement( i ) );
+    for( int i=0; i<mLiveSlots.size(); i++ ) {
+        HostCatcherRecord *r = 
+            mRecords.getElementFast( mLiveSlots.getElementDirectFast( i ) );
+        
+        delete r->address;
+        delete [] r->key;
         }
 
-    delete mHostVector;
-    
     mLock->unlock();
 
     delete mLock;
     delete mRandSource;
     }
 
+
+
+HostAddress *HostCatcher::getNumerical( HostAddress *inHost ) {
+    if( inHost->isNumerical() ) {
+        return inHost->copy();
+        }
     
+    return inHost->getNumericalAddress();
+    }
 
-void HostCatcher::addHost( HostAddress * inHost ) {
+
+
+static char *makeKey( HostAddress *inNumericalHost ) {
+    return autoSprintf( "%s:%d", inNumericalHost->mAddressString,
+                        inNumericalHost->mPort );
+    }
+
+
+
+int HostCatcher::findSlot( HostAddress *inHost ) {
+    char *key = makeKey( inHost );
+    
+    int slot = -1;
+    mSlotsByKey.lookup( key, &slot );
     
+    delete [] key;
 
-    // convert to numerical form once and for all here
-    // (to avoid converting over and over in equals checks below)
-    HostAddress *numericalAddress = inHost->getNumericalAddress();
+    return slot;
+    }
 
-    if( numericalAddress != NULL ) {
 
-        mLock->lock();
-        
-        // make sure this host doesn't already exist in our list
-        char exists = false;
+
+void HostCatcher::removeSlot( int inSlot ) {
+    HostCatcherRecord *r = mRecords.getElementFast( inSlot );
+
+    mSlotsByKey.remove( r->key );
+
+    delete r->address;
+    delete [] r->key;
+    r->address = NULL;
+    r->key = NULL;
+
+    if( r->queueHandle != -1 ) {
+        mDueQueue.remove( r->queueHandle );
+        r->queueHandle = -1;
+        }
+
+    // fill hole in live list with last live slot
+    int lastSlot = mLiveSlots.getElementDirectFast( mLiveSlots.size() - 1 );
     
-        int numHosts = mHostVector->size();
+    *( mLiveSlots.getElementFast( r->liveIndex ) ) = lastSlot;
+    mRecords.getElementFast( lastSlot )->liveIndex = r->liveIndex;
     
-        for( int i=0; i<numHosts; i++ ) {
-            HostAddress *otherHost =  *( mHostVector->getElement( i ) );
+    mLiveSlots.deleteElement( mLiveSlots.size() - 1 );
 
-            if( otherHost->equals( numericalAddress ) ) {
-                exists = true;
-                // jump out of loop
-                i = numHosts;
-                }
-            }
+    mFreeSlots.push_back( inSlot );
+    }
+
+
+
+double HostCatcher::getScore( HostCatcherRecord *inRecord,
+                              double inCurrentTime ) {
     
+    // never tried counts as even odds
+    double score = ( inRecord->successes + 1.0 ) /
+        ( inRecord->successes + inRecord->failures + 2.0 );
     
+    if( inRecord->roundTripSeconds >= 0 ) {
+        score /= 1 + inRecord->roundTripSeconds / 
+            HOST_CATCHER_RTT_SCALE_SECONDS;
+        }
     
-        if( !exists ) {
-            mHostVector->push_back( numericalAddress->copy() );
-            }
-        
+    double age = inCurrentTime - inRecord->lastSeenTime;
     
-        while( mHostVector->size() > mMaxListSize ) {
-            // remove first host from queue
-            HostAddress *host = *( mHostVector->getElement( 0 ) );
-            mHostVector->deleteElement( 0 );
-            delete host;
-            }
+    if( age > 0 ) {
+        score /= 1 + age / HOST_CATCHER_AGE_SCALE_SECONDS;
+        }
     
-        mLock->unlock();
+    return score;
+    }
+
+
+
+void HostCatcher::queueSlot( int inSlot ) {
+    HostCatcherRecord *r = mRecords.getElementFast( inSlot );
+
+    r->queueHandle = mDueQueue.insert( inSlot, r->pass );
+    }
 
-        delete numericalAddress;
+
+
+int HostCatcher::takeDueSlot() {
+    if( mDueQueue.size() == 0 ) {
+        return -1;
         }
+    
+    int slot = mDueQueue.removeMin();
+
+    mRecords.getElementFast( slot )->queueHandle = -1;
+    
+    return slot;
     }
 
 
 
-HostAddress * HostCatcher::getHostOrdered(  ) {
+void HostCatcher::requeueReturnedSlot( int inSlot, double inCurrentTime ) {
+    HostCatcherRecord *r = mRecords.getElementFast( inSlot );
 
-    mLock->lock();
+    mPass = r->pass;
     
-    int numHosts = mHostVector->size();
+    r->pass += 1 / getScore( r, inCurrentTime );
 
-    if( numHosts == 0 ) {
-        mLock->unlock();
-        return NULL;
-        }
+    queueSlot( inSlot );
+    }
 
-    // remove first host from queue
-    HostAddress *host = *( mHostVector->getElement( 0 ) );
-    mHostVector->deleteElement( 0 );
 
-    // add host to end of queue
-    mHostVector->push_back( host );
 
-    HostAddress *hostCopy = host->copy();
+void HostCatcher::evictHost( double inCurrentTime ) {
+    int worstSlot = -1;
+    double worstScore = 2;
 
+    for( int i=0; i<HOST_CATCHER_EVICTION_SAMPLES; i++ ) {
+        int slot = mLiveSlots.getElementDirectFast(
+            mRandSource->getRandomBoundedInt( 0, mLiveSlots.size() - 1 ) );
+
+        double score = getScore( mRecords.getElementFast( slot ),
+                                 inCurrentTime );
+        
+        if( score < worstScore ) {
+            worstScore = score;
+            worstSlot = slot;
+            }
+        }
     
-    mLock->unlock();
+    removeSlot( worstSlot );
+    }
+
     
-    return hostCopy;   
+
+void HostCatcher::addHost( HostAddress * inHost ) {
+    
+
+    // convert to numerical form once and for all here
+    HostAddress *numericalAddress = getNumerical( inHost );
+
+    if( numericalAddress != NULL ) {
+
+        mLock->lock();
+        
+        double currentTime = Time::getCurrentTime();
+        
+        int slot = findSlot( numericalAddress );
+        
+        if( slot != -1 ) {
+            // hearing of it again keeps it fresh
+            HostCatcherRecord *r = mRecords.getElementFast( slot );
+
+            r->lastSeenTime = currentTime;
+            
+            delete numericalAddress;
+            }
+        else if( mMaxListSize > 0 ) {
+
+            while( mLiveSlots.size() >= mMaxListSize ) {
+                evictHost( currentTime );
+                }
+        
+            if( mFreeSlots.size() > 0 ) {
+                slot = mFreeSlots.getElementDirectFast( 
+                    mFreeSlots.size() - 1 );
+                mFreeSlots.deleteElement( mFreeSlots.size() - 1 );
+                }
+            else {
+                HostCatcherRecord blank = HostCatcherRecord();
+                blank.queueHandle = -1;
+                
+                mRecords.push_back( blank );
+                slot = mRecords.size() - 1;
+                }
+            
+            HostCatcherRecord *r = mRecords.getElementFast( slot );
+            
+            r->address = numericalAddress;
+            r->key = makeKey( numericalAddress );
+            r->successes = 0;
+            r->failures = 0;
+            r->roundTripSeconds = -1;
+            r->lastSeenTime = currentTime;
+
+            // due after hosts already due
+            r->pass = mPass;
+            
+            r->liveIndex = mLiveSlots.size();
+            mLiveSlots.push_back( slot );
+
+            mSlotsByKey.insert( r->key, slot );
+
+            queueSlot( slot );
+            }
+        else {
+            delete numericalAddress;
+            }
+    
+        mLock->unlock();
+        }
     }
 
 
@@ -136,22 +291,16 @@ HostAddress * HostCatcher::getHost(  ) {
 
     mLock->lock();
     
-    int numHosts = mHostVector->size();
-
-    if( numHosts == 0 ) {
+    int slot = takeDueSlot();
+    
+    if( slot == -1 ) {
         mLock->unlock();
         return NULL;
         }
 
-    // remove random host from queue
-    int index = mRandSource->getRandomBoundedInt( 0, numHosts - 1 ); 
-    HostAddress *host = *( mHostVector->getElement( index ) );
-    mHostVector->deleteElement( index );
-
-    // add host to end of queue
-    mHostVector->push_back( host );
+    requeueReturnedSlot( slot, Time::getCurrentTime() );
 
-    HostAddress *hostCopy = host->copy();
+    HostAddress *hostCopy = mRecords.getElementFast( slot )->address->copy();
 
     
     mLock->unlock();
@@ -165,81 +314,58 @@ SimpleVector<HostAddress *> *HostCatcher::getHostList(
     int inMaxHostCount,
     HostAddress *inSkipHost ) {
 
-    HostAddress *hostToSkip;
+    HostAddress *hostToSkip = NULL;
 
     if( inSkipHost != NULL ) {
-        hostToSkip = inSkipHost->copy();
-        }
-    else {
-        // don't skip any host
-        // create a dummy host that won't match any other valid hosts
-        // make sure dummy is in numerical form to avoid DNS lookups
-        hostToSkip = new HostAddress( stringDuplicate( "1.1.1.1" ), 1 );
+        hostToSkip = getNumerical( inSkipHost );
         }
-             
     
     SimpleVector<HostAddress *> *collectedHosts =
         new SimpleVector<HostAddress *>();
 
-    char repeat = false;
-    int numCollected = 0;
-
-    // This function assumes that getHostOrdered() draws
-    // hosts in order with no repetition except when we have
-    // exhausted the host supply.
-
-    // Note that this will not be true when other threads
-    // have getHostOrdered() (or getHost) calls interleaved with ours, but this
-    // should be a rare case.  It will simply result
-    // in a smaller host list being returned.
-
-    HostAddress *firstHost = getHostOrdered();
-
-    if( firstHost == NULL ) {
-        // the catcher is empty
-
+    
+    mLock->lock();
+    
+    int skipSlot = -1;
+    
+    if( hostToSkip != NULL ) {
+        skipSlot = findSlot( hostToSkip );
         delete hostToSkip;
-
-        // an empty host list
-        return collectedHosts;       
         }
     
+    // taking each host off the heap means no repeats
+    SimpleVector<int> takenSlots;
+    
+    while( collectedHosts->size() < inMaxHostCount ) {
+        int slot = takeDueSlot();
 
-    if( ! hostToSkip->equals( firstHost ) ) {
-        collectedHosts->push_back( firstHost );
-        numCollected++;
-        }
+        if( slot == -1 ) {
+            break;
+            }
 
+        takenSlots.push_back( slot );
+        
+        if( slot != skipSlot ) {
+            collectedHosts->push_back( 
+                mRecords.getElementFast( slot )->address->copy() );
+            }
+        }
     
-    while( numCollected < inMaxHostCount && !repeat ) {
-
-        HostAddress *nextHost = getHostOrdered();
+    double currentTime = Time::getCurrentTime();
 
-        if( nextHost->equals( firstHost ) ) {
-            delete nextHost;
-            repeat = true;
+    for( int i=0; i<takenSlots.size(); i++ ) {
+        int slot = takenSlots.getElementDirectFast( i );
+        
+        if( slot != skipSlot ) {
+            requeueReturnedSlot( slot, currentTime );
             }
         else {
-            if( ! hostToSkip->equals( nextHost ) ) {
-                collectedHosts->push_back( nextHost );
-                numCollected++;
-                }
-            else {
-                delete nextHost;
-                }
+            // keeps its turn
+            queueSlot( slot );
             }
-        
         }
-
-
-    if( hostToSkip->equals( firstHost ) ) {
-        // we didn't include firstHost in our collectedHosts, so
-        // we must delete it.
-        delete firstHost;
-        }
-
-    
-    delete hostToSkip;
+        
+    mLock->unlock();
 
     return collectedHosts;
     }
@@ -257,40 +383,62 @@ void HostCatcher::addHostList( SimpleVector<HostAddress *> * inHostList ) {
 
 
 void HostCatcher::noteHostBad( HostAddress * inHost ) {
+    HostAddress *numericalAddress = getNumerical( inHost );
+
+    if( numericalAddress == NULL ) {
+        return;
+        }
+    
     mLock->lock();
     
-    // make sure this host already exists in our list
-    char exists = false;
-
-    HostAddress *foundHost = NULL;
+    int slot = findSlot( numericalAddress );
     
-    int numHosts = mHostVector->size();
+    if( slot != -1 ) {
+        removeSlot( slot );
+        }
 
-    for( int i=0; i<numHosts; i++ ) {
-        HostAddress *otherHost =  *( mHostVector->getElement( i ) );
+    mLock->unlock();
 
-        if( otherHost->equals( inHost ) ) {
-            exists = true;
+    delete numericalAddress;
+    }
 
-            // delete the host that we've found
-            mHostVector->deleteElement( i );
 
-            foundHost = otherHost;
-            
-            // jump out of loop
-            i = numHosts;
-            }
-        }
 
+void HostCatcher::noteHostResult( HostAddress *inHost, char inSuccess,
+                                  double inRoundTripSeconds ) {
+    HostAddress *numericalAddress = getNumerical( inHost );
+
+    if( numericalAddress == NULL ) {
+        return;
+        }
+    
+    mLock->lock();
     
-    if( exists ) {
-        delete foundHost;
-        //mHostVector->push_back( foundHost );
+    int slot = findSlot( numericalAddress );
+    
+    if( slot != -1 ) {
+        HostCatcherRecord *r = mRecords.getElementFast( slot );
+        
+        if( inSuccess ) {
+            r->successes++;
+            }
+        else {
+            r->failures++;
+            }
+        
+        if( inRoundTripSeconds >= 0 ) {
+            if( r->roundTripSeconds < 0 ) {
+                r->roundTripSeconds = inRoundTripSeconds;
+                }
+            else {
+                r->roundTripSeconds = 
+                    0.75 * r->roundTripSeconds + 0.25 * inRoundTripSeconds;
+                }
+            }
+        // takes effect at its next turn
         }
 
     mLock->unlock();
-    }
-    
-
-
 
+    delete numericalAddress;
+    }
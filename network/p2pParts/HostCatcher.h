@@ -7,6 +7,15 @@
  * 2004-December-20   Jason Rohrer
  * Changed getHost to return hosts in random order.
  * Added a getOrderedHost function that returns hosts in linear order.
+ *
+ * 2026-October-14   Jason Rohrer
+ * Replaced linear host list with hashed, scored records and a heap of
+ * when each host is next due, so that no call walks the whole list.
+ * Added noteHostResult.  getHost no longer picks at random.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Due queue is an IndexedMinPriorityQueue, so removed hosts are taken
+ * out of it directly instead of leaving stale entries behind.
  */
 
 
@@ -20,14 +29,52 @@
 
 
 #include "minorGems/util/SimpleVector.h"
+#include "minorGems/util/HashMap.h"
+#include "minorGems/util/IndexedMinPriorityQueue.h"
 #include "minorGems/util/random/RandomSource.h"
 #include "minorGems/system/MutexLock.h"
 
 
 
+typedef struct HostCatcherRecord {
+        // numerical form, or NULL if record is free
+        HostAddress *address;
+
+        // address:port, as used in HostCatcher::mSlotsByKey
+        char *key;
+
+        int successes;
+        int failures;
+
+        // smoothed, or -1 if never measured
+        double roundTripSeconds;
+
+        double lastSeenTime;
+
+        // turn number when host is next due (see HostCatcher::mPass)
+        double pass;
+
+        // handle in HostCatcher::mDueQueue, or -1 if not queued
+        int queueHandle;
+
+        // position in HostCatcher::mLiveSlots
+        int liveIndex;
+    } HostCatcherRecord;
+
+
+
 /**
  * Manages a collection of hosts.
  *
+ * Each host is scored by its success rate, round trip time, and how
+ * recently it was added (see noteHostResult and addHost).  Hosts take
+ * turns by stride scheduling:  each time a host is returned, its next
+ * turn is pushed back by one over its score.  So a host's share of turns
+ * is proportional to its score, and every host still gets turns.
+ *
+ * Hosts are found by hashing their numerical address, and kept in a heap
+ * by next turn, so all calls take O(log n) time (amortized) for n hosts.
+ *
  * @author Jason Rohrer
  */
 class HostCatcher {
@@ -67,7 +114,7 @@ class HostCatcher {
          * Gets a "fresh" host from this catcher.
          *
          * The returned host is "fresh" in that it has not
-         * been returned by this call in a while.
+         * been returned by this call (or in a host list) in a while.
          *
          * Thread safe.
          *
@@ -127,32 +174,77 @@ class HostCatcher {
 
 
 
+        /**
+         * Tells this catcher how a connection to a host went, for
+         * scoring.  Hosts not in this catcher are ignored.
+         *
+         * Thread safe.
+         *
+         * @param inHost the host.
+         *   Must be destroyed by caller.
+         * @param inSuccess true if the connection worked.
+         * @param inRoundTripSeconds a measured round trip time, or -1 if
+         *   none.  Defaults to -1.
+         */
+        void noteHostResult( HostAddress *inHost, char inSuccess,
+                             double inRoundTripSeconds = -1 );
+
+
+
     protected:
 
         int mMaxListSize;
-        
-        SimpleVector<HostAddress *> *mHostVector;
 
+        // indexed by slot, never shrinks
+        SimpleVector<HostCatcherRecord> mRecords;
+
+        SimpleVector<int> mFreeSlots;
+
+        // slots in use, in no order, for picking eviction candidates
+        SimpleVector<int> mLiveSlots;
+
+        HashMap<char *, int> mSlotsByKey;
+
+        // slots by pass
+        IndexedMinPriorityQueue<int> mDueQueue;
+
+        // pass of the host returned most recently
+        double mPass;
+        
         MutexLock *mLock;
 
         RandomSource *mRandSource;
-        
-        /**
-         * Gets a "fresh" host from this catcher, walking through the host
-         * list in order.
-         *
-         * The returned host is "fresh" in that it has not
-         * been returned by this call in a while.
-         *
-         * Thread safe.
-         *
-         * @return a host, or NULL if there are no hosts.
-         *   Must be destroyed by caller if non-NULL.
-         */
-        HostAddress *getHostOrdered();
 
-        
-        
+
+
+        // the rest must be called with mLock locked
+
+        // returns slot of host, or -1 if not present
+        // inHost must be numerical
+        int findSlot( HostAddress *inHost );
+
+        // numerical copy of inHost, or NULL if lookup fails
+        // destroyed by caller
+        HostAddress *getNumerical( HostAddress *inHost );
+
+        void removeSlot( int inSlot );
+
+        // score of a record in (0, 1], higher is better
+        double getScore( HostCatcherRecord *inRecord, double inCurrentTime );
+
+        // inserts into mDueQueue
+        // slot must not be queued
+        void queueSlot( int inSlot );
+
+        // pops next due host, or returns -1 if none
+        int takeDueSlot();
+
+        // moves a host taken by takeDueSlot to its next turn
+        void requeueReturnedSlot( int inSlot, double inCurrentTime );
+
+        // removes a poorly scored host to make room
+        void evictHost( double inCurrentTime );
+
     };
 
 
@@ -12,6 +12,13 @@
  *
  * 2005-April-15   Jason Rohrer
  * Changed to use updated Thread interface.
+ *
+ * 2026-October-14   Jason Rohrer
+ * Switched to TokenBucket, shared with ConnectionPermissionHandler.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Switched to monotonic time, so clock changes don't stall or burst
+ * messages.
  */
 
 
@@ -29,16 +36,7 @@ MessagePerSecondLimiter::MessagePerSecondLimiter( double inLimitPerSecond )
       mTransmitLock( new MutexLock() ),
       mLimitPerSecond( inLimitPerSecond ) {
 
-    if( mLimitPerSecond != -1 ) {
-        mMillisecondsBetweenMessages = (int)( 1000 / mLimitPerSecond );
-        }
-    else {
-        mMillisecondsBetweenMessages = 0;
-        }
-    
-    Time::getCurrentTime( &mSecondTimeOfLastMessage,
-                          &mMillisecondTimeOfLastMessage );
-    
+    mBucket.reset( 1, Time::getMonotonicTime() );
     }
 
 
@@ -53,15 +51,6 @@ MessagePerSecondLimiter::~MessagePerSecondLimiter() {
 void MessagePerSecondLimiter::setLimit( double inLimitPerSecond ) {
     mLock->lock();
     mLimitPerSecond = inLimitPerSecond;
-
-    if( mLimitPerSecond != -1 ) {
-        mMillisecondsBetweenMessages = (int)( 1000 / mLimitPerSecond );
-        }
-    else {
-        mMillisecondsBetweenMessages = 0;
-        }
-
-
     mLock->unlock();
     }
 
@@ -86,44 +75,37 @@ void MessagePerSecondLimiter::messageTransmitted() {
     // called while we touch the variables)
     mLock->lock();
 
-
-    unsigned long millisecondsSinceLastMessage =
-        Time::getMillisecondsSince( mSecondTimeOfLastMessage,
-                                    mMillisecondTimeOfLastMessage );
-
-    
-    if( millisecondsSinceLastMessage < mMillisecondsBetweenMessages ) {
-        // this message is coming too soon after last message
+    if( mLimitPerSecond != -1 ) {
         
-        // sleep
-        unsigned long sleepTime =
-            mMillisecondsBetweenMessages -
-            millisecondsSinceLastMessage;
-
-        // unlock main lock befor sleeping so that settings can be changed
-        mLock->unlock();
+        double waitSeconds = 
+            mBucket.getWaitSeconds( mLimitPerSecond, 1, 
+                                    Time::getMonotonicTime() );
         
-        Thread::staticSleep( sleepTime );
-
-        // relock
-        mLock->lock();
+        if( waitSeconds > 0 ) {
+            // this message is coming too soon after last message
+            
+            // unlock main lock befor sleeping so that settings can be 
+            // changed
+            mLock->unlock();
+            
+            Thread::staticSleep( (unsigned long)( waitSeconds * 1000 ) );
+            
+            // relock
+            mLock->lock();
+            }
+        
+        if( mLimitPerSecond != -1 ) {
+            // refill for time slept, then take this message's token,
+            // even if sleep was cut short by rounding (a small debt
+            // that the next message waits out)
+            mBucket.getWaitSeconds( mLimitPerSecond, 1, 
+                                    Time::getMonotonicTime() );
+            mBucket.mTokens -= 1;
+            }
         }
 
-
-    Time::getCurrentTime( &mSecondTimeOfLastMessage,
-                          &mMillisecondTimeOfLastMessage );
     mLock->unlock();
 
     
     mTransmitLock->unlock();
     }
-
-
-
-
-
-
-
-
-
-
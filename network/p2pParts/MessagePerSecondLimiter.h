@@ -9,6 +9,9 @@
  *
  * 2004-January-2   Jason Rohrer
  * Added seprate mutex for transmission function to prevent UI freeze.
+ *
+ * 2026-October-14   Jason Rohrer
+ * Switched to TokenBucket, shared with ConnectionPermissionHandler.
  */
 
 
@@ -19,6 +22,7 @@
 
 
 #include "minorGems/system/MutexLock.h"
+#include "minorGems/util/TokenBucket.h"
 
 
 
@@ -90,10 +94,9 @@ class MessagePerSecondLimiter {
         MutexLock *mTransmitLock;
         
         double mLimitPerSecond;
-        unsigned long  mMillisecondsBetweenMessages;
 
-        unsigned long mSecondTimeOfLastMessage;
-        unsigned long mMillisecondTimeOfLastMessage;
+        // holds at most one message, so messages are evenly spaced
+        TokenBucket mBucket;
 
 
         
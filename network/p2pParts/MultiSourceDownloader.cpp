@@ -9,12 +9,25 @@
  *
  * 2004-December-4   Jason Rohrer
  * Fixed bug in source indexing.
+ *
+ * 2026-October-14   Jason Rohrer
+ * Fetch from all sources at once, with several requests per source,
+ * an endgame that duplicates tail chunks, per-chunk digest checks, and
+ * throughput tracking to keep slow sources off the tail.
  */
 
 
 
 #include "MultiSourceDownloader.h"
 
+#include "minorGems/system/Thread.h"
+#include "minorGems/system/MutexLock.h"
+#include "minorGems/system/BinarySemaphore.h"
+#include "minorGems/system/Time.h"
+#include "minorGems/util/SimpleVector.h"
+#include "minorGems/util/stringUtils.h"
+#include "minorGems/crypto/hashes/sha1.h"
+
 
 #include <stdio.h>
 
@@ -25,6 +38,363 @@ int MULTISOURCE_DOWNLOAD_CANCELED = 2;
 
 
 
+// requests in flight at once from each source
+#define MULTISOURCE_REQUESTS_PER_SOURCE 2
+
+// sources slower than this fraction of the fastest one leave the last
+// unstarted chunks to faster sources
+#define MULTISOURCE_SLOW_FRACTION 0.5
+
+// how long a worker with nothing to fetch waits before looking again
+#define MULTISOURCE_IDLE_SLEEP_MS 10
+
+
+
+/**
+ * State shared by the fetching threads of one download.
+ *
+ * Protected by mLock.
+ */
+class MultiSourceDownload {
+
+    public:
+
+        void *mFileDescriptor;
+        unsigned long mFileSize;
+        unsigned long mChunkSize;
+        unsigned long mNumChunks;
+        void **mFileSources;
+        unsigned char * (*mChunkGetter)(
+            void *, void *, unsigned long, unsigned long );
+        char **mChunkDigests;
+        
+        FILE *mOutputFile;
+        
+
+        MutexLock mLock;
+
+        // signaled whenever a chunk lands or a worker exits
+        BinarySemaphore mEventSemaphore;
+
+        
+        char *mChunkDone;
+        
+        // number of workers fetching each chunk
+        int *mChunkFetchers;
+
+        // when first fetch of chunk started, or -1
+        double *mChunkStartTimes;
+
+        // chunks before this have all been started once
+        unsigned long mNextFreshChunk;
+
+        // chunks whose only fetches failed
+        SimpleVector<unsigned long> mReturnedChunks;
+        
+
+        int mNumSources;
+
+        char *mSourceFailed;
+        
+        // smoothed bytes per second, or -1 if not yet measured
+        double *mSourceThroughputs;
+        
+
+        // workers of source s are s * MULTISOURCE_REQUESTS_PER_SOURCE
+        // and up
+        int mNumWorkers;
+
+        // chunk each worker is fetching, or -1
+        long *mWorkerChunks;
+
+        int mNumLiveWorkers;
+
+        
+        unsigned long mNumChunksDone;
+        unsigned long mBytesSoFar;
+
+        char mWriteFailed;
+
+        // set on cancel, write failure, or completion
+        char mStopped;
+
+
+        
+        unsigned long getChunkLength( unsigned long inChunk ) {
+            if( inChunk == mNumChunks - 1 &&
+                mFileSize % mChunkSize != 0 ) {
+                // partial chunk
+                return mFileSize % mChunkSize;
+                }
+            return mChunkSize;
+            }
+
+        
+        // true if another worker of inSource is fetching inChunk
+        char isSourceFetching( int inSource, unsigned long inChunk ) {
+            int firstWorker = inSource * MULTISOURCE_REQUESTS_PER_SOURCE;
+
+            for( int w=firstWorker; 
+                 w < firstWorker + MULTISOURCE_REQUESTS_PER_SOURCE; w++ ) {
+                if( mWorkerChunks[w] == (long)inChunk ) {
+                    return true;
+                    }
+                }
+            return false;
+            }
+
+
+        char isSourceSlow( int inSource ) {
+            double throughput = mSourceThroughputs[ inSource ];
+            
+            if( throughput < 0 ) {
+                return false;
+                }
+            
+            for( int s=0; s<mNumSources; s++ ) {
+                if( ! mSourceFailed[s] &&
+                    mSourceThroughputs[s] * MULTISOURCE_SLOW_FRACTION > 
+                    throughput ) {
+                    return true;
+                    }
+                }
+            return false;
+            }
+
+
+        /**
+         * Picks the next chunk for a worker of inSource to fetch.
+         *
+         * @param outCanExit set to true if inSource will never have
+         *   anything more to fetch.
+         *
+         * @return the chunk, or -1 if none right now.
+         */
+        long pickChunk( int inSource, char *outCanExit ) {
+            *outCanExit = false;
+            
+            // first, chunks dropped by failed sources
+            while( mReturnedChunks.size() > 0 ) {
+                int last = mReturnedChunks.size() - 1;
+                
+                unsigned long chunk = 
+                    mReturnedChunks.getElementDirectFast( last );
+                mReturnedChunks.deleteElement( last );
+                
+                if( ! mChunkDone[ chunk ] && mChunkFetchers[ chunk ] == 0 ) {
+                    return chunk;
+                    }
+                }
+            
+            // then chunks in order, though slow sources leave the last
+            // few for faster ones
+            if( mNextFreshChunk < mNumChunks ) {
+                
+                if( mNumChunks - mNextFreshChunk > 
+                    (unsigned long)mNumLiveWorkers ||
+                    ! isSourceSlow( inSource ) ) {
+                    
+                    unsigned long chunk = mNextFreshChunk;
+                    mNextFreshChunk++;
+                    return chunk;
+                    }
+                }
+            else if( ! isSourceSlow( inSource ) ) {
+                // endgame:  help with the chunk in flight the longest
+                // (slow sources don't, since we wait for every fetch to
+                // return before finishing)
+                long oldestChunk = -1;
+                
+                for( int w=0; w<mNumWorkers; w++ ) {
+                    long chunk = mWorkerChunks[w];
+
+                    if( chunk == -1 || mChunkDone[ chunk ] ||
+                        isSourceFetching( inSource, chunk ) ) {
+                        continue;
+                        }
+                    
+                    if( oldestChunk == -1 ||
+                        mChunkStartTimes[ chunk ] < 
+                        mChunkStartTimes[ oldestChunk ] ) {
+                        oldestChunk = chunk;
+                        }
+                    }
+                
+                if( oldestChunk != -1 ) {
+                    return oldestChunk;
+                    }
+                
+                // can only get more work later if this source's own
+                // fetches fail, and then it is dropped anyway
+                *outCanExit = true;
+                }
+            // else slow sources wait, in case faster ones fail
+            
+            return -1;
+            }
+        
+    };
+
+
+
+class MultiSourceWorker : public Thread {
+
+    public:
+
+        MultiSourceWorker( MultiSourceDownload *inDownload, int inSource,
+                           int inIndex )
+                : mDownload( inDownload ), mSource( inSource ),
+                  mIndex( inIndex ) {
+            start();
+            }
+
+        ~MultiSourceWorker() {
+            join();
+            }
+
+        void run();
+
+
+    protected:
+
+        MultiSourceDownload *mDownload;
+        
+        int mSource;
+
+        // index in MultiSourceDownload::mWorkerChunks
+        int mIndex;
+
+    };
+
+
+
+void MultiSourceWorker::run() {
+    MultiSourceDownload *d = mDownload;
+
+    void *source = d->mFileSources[ mSource ];
+    
+    d->mLock.lock();
+
+    while( ! d->mStopped && ! d->mSourceFailed[ mSource ] ) {
+
+        char canExit;
+        long chunk = d->pickChunk( mSource, &canExit );
+
+        if( chunk == -1 ) {
+            if( canExit ) {
+                break;
+                }
+
+            d->mLock.unlock();
+            Thread::staticSleep( MULTISOURCE_IDLE_SLEEP_MS );
+            d->mLock.lock();
+            continue;
+            }
+
+        double startTime = Time::getCurrentTime();
+
+        d->mWorkerChunks[ mIndex ] = chunk;
+        d->mChunkFetchers[ chunk ] ++;
+
+        if( d->mChunkStartTimes[ chunk ] < 0 ) {
+            d->mChunkStartTimes[ chunk ] = startTime;
+            }
+        
+        unsigned long chunkLength = d->getChunkLength( chunk );
+        
+        d->mLock.unlock();
+
+        
+        unsigned char *chunkData =
+            d->mChunkGetter( source, d->mFileDescriptor, 
+                             chunk, chunkLength );
+
+        char good = ( chunkData != NULL );
+        
+        if( good && d->mChunkDigests != NULL ) {
+            char *digest = computeSHA1Digest( chunkData, chunkLength );
+            
+            if( stringCompareIgnoreCase( 
+                    digest, d->mChunkDigests[ chunk ] ) != 0 ) {
+                good = false;
+                }
+            delete [] digest;
+            }
+        
+        double fetchTime = Time::getCurrentTime() - startTime;
+
+        
+        d->mLock.lock();
+
+        d->mWorkerChunks[ mIndex ] = -1;
+        d->mChunkFetchers[ chunk ] --;
+
+        if( good ) {
+            if( fetchTime > 0 ) {
+                double throughput = chunkLength / fetchTime;
+                
+                if( d->mSourceThroughputs[ mSource ] < 0 ) {
+                    d->mSourceThroughputs[ mSource ] = throughput;
+                    }
+                else {
+                    d->mSourceThroughputs[ mSource ] = 
+                        0.5 * d->mSourceThroughputs[ mSource ] + 
+                        0.5 * throughput;
+                    }
+                }
+            
+            // another copy may have landed first
+            if( ! d->mChunkDone[ chunk ] ) {
+
+                if( fseek( d->mOutputFile, chunk * d->mChunkSize,
+                           SEEK_SET ) != 0 ||
+                    fwrite( chunkData, 1, chunkLength, d->mOutputFile ) 
+                    != chunkLength ) {
+                    
+                    d->mWriteFailed = true;
+                    d->mStopped = true;
+                    }
+                else {
+                    d->mChunkDone[ chunk ] = true;
+                    d->mNumChunksDone++;
+                    d->mBytesSoFar += chunkLength;
+
+                    if( d->mNumChunksDone == d->mNumChunks ) {
+                        // stop any duplicate fetches from starting more
+                        d->mStopped = true;
+                        }
+                    }
+                }
+            }
+        else {
+            // drop this source
+            d->mSourceFailed[ mSource ] = true;
+            
+            if( ! d->mChunkDone[ chunk ] && d->mChunkFetchers[ chunk ] == 0 ) {
+                d->mReturnedChunks.push_back( chunk );
+                }
+            }
+
+        if( chunkData != NULL ) {
+            delete [] chunkData;
+            }
+
+        d->mLock.unlock();
+        
+        d->mEventSemaphore.signal();
+        
+        d->mLock.lock();
+        }
+
+    d->mNumLiveWorkers--;
+
+    d->mLock.unlock();
+
+    d->mEventSemaphore.signal();
+    }
+
+
+
 void multiSourceGetFile( void *inFileDescriptor,
                          unsigned long inFileSize,
                          unsigned long inChunkSize,
@@ -35,7 +405,8 @@ void multiSourceGetFile( void *inFileDescriptor,
                          char (*inDownloadProgressHandler)(
                              int, unsigned long, void * ),
                          void *inProgressHandlerExtraArgument,
-                         char *inDestinationPath ) {
+                         char *inDestinationPath,
+                         char **inChunkDigests ) {
 
     FILE *outputFile = fopen( inDestinationPath, "wb" );
 
@@ -46,91 +417,144 @@ void multiSourceGetFile( void *inFileDescriptor,
         return;
         }
 
-    
-    // for now, just fetch chunks in linear order, using each file source
-    // until it fails
-    char failed = false;
-    char canceled = false;
-
-    unsigned long chunksSoFar = 0;
     unsigned long numChunks = inFileSize / inChunkSize;
     if( inFileSize % inChunkSize != 0 ) {
         // extra partial chunk
         numChunks++;
         }
 
-    unsigned long bytesSoFar = 0;
+    if( numChunks == 0 ) {
+        fclose( outputFile );
+        return;
+        }
+    
+
+    MultiSourceDownload d;
 
-    int sourceIndex = 0;
+    d.mFileDescriptor = inFileDescriptor;
+    d.mFileSize = inFileSize;
+    d.mChunkSize = inChunkSize;
+    d.mNumChunks = numChunks;
+    d.mFileSources = inFileSources;
+    d.mChunkGetter = inChunkGetter;
+    d.mChunkDigests = inChunkDigests;
+    d.mOutputFile = outputFile;
 
-    while( sourceIndex < inNumSources &&
-           !failed &&
-           !canceled &&
-           chunksSoFar < numChunks ) {
+    d.mChunkDone = new char[ numChunks ];
+    d.mChunkFetchers = new int[ numChunks ];
+    d.mChunkStartTimes = new double[ numChunks ];
+    
+    for( unsigned long c=0; c<numChunks; c++ ) {
+        d.mChunkDone[c] = false;
+        d.mChunkFetchers[c] = 0;
+        d.mChunkStartTimes[c] = -1;
+        }
+    d.mNextFreshChunk = 0;
+    
+    d.mNumSources = inNumSources;
+    d.mSourceFailed = new char[ inNumSources ];
+    d.mSourceThroughputs = new double[ inNumSources ];
+
+    for( int s=0; s<inNumSources; s++ ) {
+        d.mSourceFailed[s] = false;
+        d.mSourceThroughputs[s] = -1;
+        }
+    
+    d.mNumWorkers = inNumSources * MULTISOURCE_REQUESTS_PER_SOURCE;
+    d.mWorkerChunks = new long[ d.mNumWorkers ];
+
+    for( int w=0; w<d.mNumWorkers; w++ ) {
+        d.mWorkerChunks[w] = -1;
+        }
+    d.mNumLiveWorkers = d.mNumWorkers;
+    
+    d.mNumChunksDone = 0;
+    d.mBytesSoFar = 0;
+    d.mWriteFailed = false;
+    d.mStopped = false;
+
+    
+    SimpleVector<MultiSourceWorker *> workers;
+
+    for( int w=0; w<d.mNumWorkers; w++ ) {
+        workers.push_back( 
+            new MultiSourceWorker( &d, w / MULTISOURCE_REQUESTS_PER_SOURCE,
+                                   w ) );
+        }
+    
+
+    unsigned long bytesReported = 0;
+    
+    while( true ) {
+        
+        d.mLock.lock();
+
+        unsigned long bytesSoFar = d.mBytesSoFar;
+        char done = ( d.mNumChunksDone == numChunks );
+        char writeFailed = d.mWriteFailed;
+        int numLiveWorkers = d.mNumLiveWorkers;
         
-        void *source = inFileSources[ sourceIndex ];
+        d.mLock.unlock();
 
-        unsigned long chunkSize = inChunkSize;
         
-        if( chunksSoFar * inChunkSize + chunkSize > inFileSize ) {
-            // partial chunk
-            chunkSize = inFileSize - chunksSoFar * inChunkSize;
+        if( writeFailed ) {
+            // failed to write to file, so download cannot continue
+            inDownloadProgressHandler( MULTISOURCE_DOWNLOAD_FAILED,
+                                       bytesSoFar,
+                                       inProgressHandlerExtraArgument );
+            break;
             }
+        
+        if( bytesSoFar != bytesReported ) {
+            bytesReported = bytesSoFar;
 
-        unsigned char *chunkData =
-            inChunkGetter(
-                source, inFileDescriptor, chunksSoFar, chunkSize );
+            char shouldContinue =
+                inDownloadProgressHandler(
+                    MULTISOURCE_DOWNLOAD_IN_PROGRESS,
+                    bytesSoFar,
+                    inProgressHandlerExtraArgument );
 
-        if( chunkData != NULL ) {
-            chunksSoFar += 1;
-            
-            bytesSoFar += chunkSize;
-            unsigned long numWritten =
-                fwrite( chunkData, 1, chunkSize, outputFile );
-
-            if( numWritten == chunkSize ) {
-                char shouldContinue =
-                    inDownloadProgressHandler(
-                        MULTISOURCE_DOWNLOAD_IN_PROGRESS,
-                        bytesSoFar,
-                        inProgressHandlerExtraArgument );
-
-                if( !shouldContinue ) {
-                    canceled = true;
-
-                    // call handler last time
-                    inDownloadProgressHandler(
-                        MULTISOURCE_DOWNLOAD_CANCELED,
-                        bytesSoFar,
-                        inProgressHandlerExtraArgument );
-                    }
+            if( !shouldContinue ) {
+                d.mLock.lock();
+                d.mStopped = true;
+                d.mLock.unlock();
+                
+                // call handler last time
+                inDownloadProgressHandler(
+                    MULTISOURCE_DOWNLOAD_CANCELED,
+                    bytesSoFar,
+                    inProgressHandlerExtraArgument );
+                break;
                 }
-            else {
-                // failed to write to file, so download cannot continue
-                inDownloadProgressHandler( MULTISOURCE_DOWNLOAD_FAILED,
-                                           bytesSoFar,
-                                           inProgressHandlerExtraArgument );
-                failed = true;
-                }
-            delete [] chunkData;
             }
-        else {
-            // else go on to the next host
-            sourceIndex ++;
+        
+        if( done ) {
+            break;
+            }
+        
+        if( numLiveWorkers == 0 ) {
+            // we ran out of sources (another type of failure)
+            inDownloadProgressHandler( MULTISOURCE_DOWNLOAD_FAILED,
+                                       bytesSoFar,
+                                       inProgressHandlerExtraArgument );
+            break;
             }
+        
+        d.mEventSemaphore.wait();
         }
+    
 
-    // check if we got here because we ran out of hosts (another type of
-    // failure
-    if( !failed && !canceled &&
-        chunksSoFar < numChunks ) {
-
-        inDownloadProgressHandler( MULTISOURCE_DOWNLOAD_FAILED,
-                                   bytesSoFar,
-                                   inProgressHandlerExtraArgument );
+    // destructors join
+    for( int w=0; w<workers.size(); w++ ) {
+        delete workers.getElementDirect( w );
         }
     
+    delete [] d.mChunkDone;
+    delete [] d.mChunkFetchers;
+    delete [] d.mChunkStartTimes;
+    delete [] d.mSourceFailed;
+    delete [] d.mSourceThroughputs;
+    delete [] d.mWorkerChunks;
+
     fclose( outputFile );    
     }
-
-
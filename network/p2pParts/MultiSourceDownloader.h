@@ -6,6 +6,9 @@
  *
  * 2004-November-23   Jason Rohrer
  * Fixed compile errors caused by multiple definitions.
+ *
+ * 2026-October-14   Jason Rohrer
+ * Added chunk digests.  Documented concurrent scheduling.
  */
 
 
@@ -14,6 +17,9 @@
 #define MULTISOURCE_DOWNLOADER_INCLUDED
 
 
+#include <stddef.h>
+
+
 
 /**
  * Abstract API for multi-source downloads.
@@ -32,6 +38,20 @@ extern int MULTISOURCE_DOWNLOAD_CANCELED;
 /**
  * Gets a file from multiple sources.
  *
+ * Chunks are fetched from all sources at once, with a few requests in
+ * flight per source (each in its own thread), so inChunkGetter must be
+ * thread-safe.  Faster sources end up fetching more chunks.  Near the
+ * end, idle sources fetch duplicates of chunks still in flight elsewhere,
+ * and whichever copy lands first is used, so a slow source can't hold up
+ * the tail of the download.  Sources much slower than the fastest one
+ * don't start the last few chunks.
+ *
+ * A source is dropped when it fails to return a chunk (or returns one
+ * that doesn't match its digest), and its chunks go to the others.
+ *
+ * The progress handler is called from the calling thread.  After a
+ * cancel, this call waits for chunk fetches already started to return.
+ *
  * @param inFileDescriptor abstract pointer to a file descriptor that can
  *   be used by inChunkGetter to identify a file.
  *   Must be destroyed by caller.
@@ -63,6 +83,10 @@ extern int MULTISOURCE_DOWNLOAD_CANCELED;
  *   Must be destroyed by caller.
  * @param inDestinationPath the path to save the file to.
  *   Must be destroyed by caller.
+ * @param inChunkDigests array of hex-encoded SHA1 digests, one for
+ *   each chunk, to check chunks against as they arrive, or NULL to not
+ *   check chunks.  Defaults to NULL.
+ *   Array and digests must be destroyed by caller.
  */
 void multiSourceGetFile( void *inFileDescriptor,
                          unsigned long inFileSize,
@@ -74,7 +98,8 @@ void multiSourceGetFile( void *inFileDescriptor,
                          char (*inDownloadProgressHandler)(
                              int, unsigned long, void * ),
                          void *inProgressHandlerExtraArgument,
-                         char *inDestinationPath );
+                         char *inDestinationPath,
+                         char **inChunkDigests = NULL );
 
 
 
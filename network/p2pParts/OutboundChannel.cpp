@@ -18,29 +18,53 @@
  *
  * 2004-December-12   Jason Rohrer
  * Added a queue size parameter.
+ *
+ * 2026-October-14   Jason Rohrer
+ * Added priority levels with weighted fair sending, coalesced writes,
+ * a byte limit on queues, and a latency histogram.
  */
 
 
 
 #include "minorGems/network/p2pParts/OutboundChannel.h"
 
+#include "minorGems/system/Time.h"
+#include "minorGems/util/stringUtils.h"
+
+
+
+// bytes added to the lowest level's deficit each round, doubled for
+// each level above
+#define OUTBOUND_CHANNEL_QUANTUM 1024
+
 
 
 OutboundChannel::OutboundChannel( OutputStream *inOutputStream,
                                   HostAddress *inHost,
                                   MessagePerSecondLimiter *inLimiter,
-                                  unsigned long inQueueSize )
+                                  unsigned long inQueueSize,
+                                  int inMaxQueueBytes )
     : mLock( new MutexLock() ), mMessageReadySemaphore( new Semaphore() ),
       mStream( inOutputStream ),
       mHost( inHost ),
       mLimiter( inLimiter ),
       mConnectionBroken( false ), mThreadStopped( false ),
-      mMessageQueue( new SimpleVector<char*>() ),
-      mHighPriorityMessageQueue( new SimpleVector<char*>() ),
+      mRoundLevel( OUTBOUND_CHANNEL_NUM_PRIORITIES - 1 ),
+      mRoundLevelCharged( false ),
       mMaxQueueSize( inQueueSize ),
+      mMaxQueueBytes( inMaxQueueBytes ),
       mDroppedMessageCount( 0 ),
       mSentMessageCount( 0 ) {
     
+    for( int p=0; p<OUTBOUND_CHANNEL_NUM_PRIORITIES; p++ ) {
+        mQueueHeads[p] = 0;
+        mQueueBytes[p] = 0;
+        mDeficits[p] = 0;
+        }
+
+    for( int b=0; b<OUTBOUND_CHANNEL_LATENCY_BUCKETS; b++ ) {
+        mLatencyCounts[b] = 0;
+        }
 
     // start our thread
     start();
@@ -67,21 +91,13 @@ OutboundChannel::~OutboundChannel() {
     delete mMessageReadySemaphore;
     
     // clear the queues
-    int numMessages = mMessageQueue->size();
-    int i;
-    for( i=0; i<numMessages; i++ ) {
-        char *message = *( mMessageQueue->getElement( i ) );
-        delete [] message;
-        }
-    delete mMessageQueue;
-
-    numMessages = mHighPriorityMessageQueue->size();
-    for( i=0; i<numMessages; i++ ) {
-        char *message = *( mHighPriorityMessageQueue->getElement( i ) );
-        delete [] message;
+    for( int p=0; p<OUTBOUND_CHANNEL_NUM_PRIORITIES; p++ ) {
+        int numMessages = mQueues[p].size();
+        
+        for( int i=mQueueHeads[p]; i<numMessages; i++ ) {
+            delete [] mQueues[p].getElementFast( i )->text;
+            }
         }
-    delete mHighPriorityMessageQueue;
-
     
 
     delete mHost;
@@ -90,10 +106,58 @@ OutboundChannel::~OutboundChannel() {
 
     delete mLock;
     }
+
+
+
+int OutboundChannel::getQueueLength( int inLevel ) {
+    return mQueues[ inLevel ].size() - mQueueHeads[ inLevel ];
+    }
+
+
+
+OutboundMessage OutboundChannel::takeMessage( int inLevel ) {
+    SimpleVector<OutboundMessage> *queue = &( mQueues[ inLevel ] );
+
+    OutboundMessage message = 
+        queue->getElementDirectFast( mQueueHeads[ inLevel ] );
+
+    mQueueHeads[ inLevel ] ++;
+    mQueueBytes[ inLevel ] -= message.length;
+
+    // taken messages are dropped from the front in bulk, so taking one
+    // doesn't shift the rest every time
+    if( mQueueHeads[ inLevel ] == queue->size() ) {
+        queue->deleteAll();
+        mQueueHeads[ inLevel ] = 0;
+        }
+    else if( mQueueHeads[ inLevel ] > 32 &&
+             mQueueHeads[ inLevel ] * 2 > queue->size() ) {
+        queue->deleteStartElements( mQueueHeads[ inLevel ] );
+        mQueueHeads[ inLevel ] = 0;
+        }
+    
+    return message;
+    }
     
 
 
 char OutboundChannel::sendMessage( char * inMessage, int inPriority ) {
+    
+    int level = inPriority;
+    
+    if( level < 0 ) {
+        level = 0;
+        }
+    else if( level >= OUTBOUND_CHANNEL_NUM_PRIORITIES ) {
+        level = OUTBOUND_CHANNEL_NUM_PRIORITIES - 1;
+        }
+    
+    OutboundMessage message;
+    message.length = strlen( inMessage );
+    message.text = stringDuplicate( inMessage );
+    message.queueTime = Time::getCurrentTime();
+    
+
     mLock->lock();
 
 
@@ -101,32 +165,25 @@ char OutboundChannel::sendMessage( char * inMessage, int inPriority ) {
     
     if( !mConnectionBroken ) {
         // add it to the queue
-        SimpleVector<char *> *queueToUse;
-
-        if( inPriority <=0 ) {
-            queueToUse = mMessageQueue;
-            }
-        else {
-            queueToUse = mHighPriorityMessageQueue;
-            }
-
+        mQueues[ level ].push_back( message );
+        mQueueBytes[ level ] += message.length;
         
-        queueToUse->push_back( stringDuplicate( inMessage ) );
         sent = true;
 
-        if( queueToUse->size() > mMaxQueueSize ) {
-            // the queue is over-full
-            // drop the oldest message
+        // if the queue is over-full, drop the oldest messages
+        while( getQueueLength( level ) > 1 &&
+               ( getQueueLength( level ) > mMaxQueueSize ||
+                 mQueueBytes[ level ] > mMaxQueueBytes ) ) {
 
-            char *message = *( queueToUse->getElement( 0 ) );
-            queueToUse->deleteElement( 0 );
-            delete [] message;
+            delete [] takeMessage( level ).text;
 
             mDroppedMessageCount++;
             }
         }
     else {
         // channel no longer working
+        delete [] message.text;
+        
         sent = false;
         }
         
@@ -166,7 +223,23 @@ int OutboundChannel::getSentMessageCount() {
 
 int OutboundChannel::getQueuedMessageCount() {
     mLock->lock();
-    int count = mMessageQueue->size() + mHighPriorityMessageQueue->size();
+    int count = 0;
+    for( int p=0; p<OUTBOUND_CHANNEL_NUM_PRIORITIES; p++ ) {
+        count += getQueueLength( p );
+        }
+    mLock->unlock();
+
+    return count;
+    }
+
+
+
+int OutboundChannel::getQueuedByteCount() {
+    mLock->lock();
+    int count = 0;
+    for( int p=0; p<OUTBOUND_CHANNEL_NUM_PRIORITIES; p++ ) {
+        count += mQueueBytes[p];
+        }
     mLock->unlock();
 
     return count;
@@ -184,72 +257,170 @@ int OutboundChannel::getDroppedMessageCount() {
 
 
 
+void OutboundChannel::getLatencyHistogram( int *outCounts ) {
+    mLock->lock();
+    for( int b=0; b<OUTBOUND_CHANNEL_LATENCY_BUCKETS; b++ ) {
+        outCounts[b] = mLatencyCounts[b];
+        }
+    mLock->unlock();
+    }
+
+
+
+void OutboundChannel::takeBatch( SimpleVector<OutboundMessage> *outBatch,
+                                 int inMaxBytes ) {
+    int batchBytes = 0;
+
+    int numQueued = 0;
+    for( int p=0; p<OUTBOUND_CHANNEL_NUM_PRIORITIES; p++ ) {
+        numQueued += getQueueLength( p );
+        }
+    
+    // every round adds to deficits, so a level holding a message too big
+    // for its deficit gets to send after enough rounds
+    while( numQueued > 0 ) {
+        int p = mRoundLevel;
+        
+        if( getQueueLength( p ) == 0 ) {
+            // idle levels don't save up a share
+            mDeficits[p] = 0;
+            }
+        else {
+            if( ! mRoundLevelCharged ) {
+                mDeficits[p] += OUTBOUND_CHANNEL_QUANTUM << p;
+                mRoundLevelCharged = true;
+                }
+
+            while( getQueueLength( p ) > 0 ) {
+                int length = 
+                    mQueues[p].getElementFast( mQueueHeads[p] )->length;
+                
+                if( length > mDeficits[p] ) {
+                    // wait for a later round
+                    break;
+                    }
+                
+                if( outBatch->size() > 0 &&
+                    ( inMaxBytes == -1 || 
+                      batchBytes + length > inMaxBytes ) ) {
+                    // batch full, resume with this level next time
+                    return;
+                    }
+                
+                outBatch->push_back( takeMessage( p ) );
+                mDeficits[p] -= length;
+                batchBytes += length;
+                numQueued--;
+                }
+        
+            if( getQueueLength( p ) == 0 ) {
+                mDeficits[p] = 0;
+                }
+            }
+        
+        // rounds go from highest level down
+        mRoundLevel--;
+        if( mRoundLevel < 0 ) {
+            mRoundLevel = OUTBOUND_CHANNEL_NUM_PRIORITIES - 1;
+            }
+        mRoundLevelCharged = false;
+        }
+    }
+
+
+
 void OutboundChannel::run() {
     mLock->lock();
     char stopped = mThreadStopped;
     mLock->unlock();
 
+    SimpleVector<OutboundMessage> batch;
+    SimpleVector<unsigned char> buffer;
+    
     while( !stopped ) {
 
-
-        // get a message from the queue, checking high priority queue first
-        char *message = NULL;
+        // coalesced writes would bunch up messages that the limiter
+        // is supposed to space out
+        int maxBytes = OUTBOUND_CHANNEL_MAX_WRITE_BYTES;
+        
+        if( mLimiter->getLimit() != -1 ) {
+            maxBytes = -1;
+            }
+        
 
         mLock->lock();
 
-        if( mHighPriorityMessageQueue->size() >= 1 ) {
-            message = *( mHighPriorityMessageQueue->getElement( 0 ) );
-            mHighPriorityMessageQueue->deleteElement( 0 );             
-            }        
-        else if( mMessageQueue->size() >= 1 ) {
-            message = *( mMessageQueue->getElement( 0 ) );
-            mMessageQueue->deleteElement( 0 );            
-            }
-
+        takeBatch( &batch, maxBytes );
+        
         mLock->unlock();
 
         // note that we're unlocked during the send, so messages
         // can be freely added to the queue without blocking while we send
-        // this message
+        // these messages
         
-        if( message != NULL ) {
+        if( batch.size() > 0 ) {
 
             // obey the limit
             // we will block here if message rate is too high
-            mLimiter->messageTransmitted();
-                        
-            int bytesSent = mStream->writeString( message );
-
-            int messageLength = strlen( message );
-    
-            delete [] message;
-
+            for( int i=0; i<batch.size(); i++ ) {
+                mLimiter->messageTransmitted();
+                }
 
-            char sent;
+            buffer.deleteAll();
             
-            if( bytesSent == messageLength ) {
-                sent = true;
-
-                mLock->lock();
-                mSentMessageCount++;
-                mLock->unlock();
+            for( int i=0; i<batch.size(); i++ ) {
+                OutboundMessage *message = batch.getElementFast( i );
+                
+                buffer.appendArray( (unsigned char *)( message->text ),
+                                    message->length );
                 }
-            else {
-                sent = false;
+            
+            long bytesSent = 0;
+            
+            if( buffer.size() > 0 ) {
+                bytesSent = mStream->write( buffer.getElementFast( 0 ),
+                                            buffer.size() );
                 }
+            
+            double sendTime = Time::getCurrentTime();
+            
 
-
-            if( !sent ) {
+            mLock->lock();
+
+            if( bytesSent == buffer.size() ) {
+                mSentMessageCount += batch.size();
+
+                for( int i=0; i<batch.size(); i++ ) {
+                    double waitMS = 
+                        1000 * ( sendTime - 
+                                 batch.getElementFast( i )->queueTime );
+                    
+                    int bucket = 0;
+                    int bucketLimit = 1;
+                    
+                    while( waitMS >= bucketLimit && 
+                           bucket < OUTBOUND_CHANNEL_LATENCY_BUCKETS - 1 ) {
+                        bucket++;
+                        bucketLimit *= 2;
+                        }
+                    
+                    mLatencyCounts[ bucket ] ++;
+                    }
+                }
+            else {
                 // connection is broken
                 // stop this thread
-                
-                mLock->lock();
-
                 mConnectionBroken = true;
                 mThreadStopped = true;
+                }
+            
+            mLock->unlock();
+            
 
-                mLock->unlock();
+            for( int i=0; i<batch.size(); i++ ) {
+                delete [] batch.getElementFast( i )->text;
                 }
+            batch.deleteAll();
             }
         else {
             // no messages in the queue.
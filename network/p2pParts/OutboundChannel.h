@@ -15,6 +15,10 @@
  *
  * 2004-December-12   Jason Rohrer
  * Added a queue size parameter.
+ *
+ * 2026-October-14   Jason Rohrer
+ * Added priority levels with weighted fair sending, coalesced writes,
+ * a byte limit on queues, and a latency histogram.
  */
 
 
@@ -40,9 +44,39 @@
 
 
 
+// priorities above this all share the top level
+#define OUTBOUND_CHANNEL_NUM_PRIORITIES 4
+
+// most bytes coalesced into one write
+#define OUTBOUND_CHANNEL_MAX_WRITE_BYTES 16384
+
+// see getLatencyHistogram
+#define OUTBOUND_CHANNEL_LATENCY_BUCKETS 16
+
+
+
+typedef struct OutboundMessage {
+        char *text;
+        int length;
+
+        // when sendMessage was called
+        double queueTime;
+    } OutboundMessage;
+
+
+
 /**
  * A channel that can send messages to a receiving host.
  *
+ * Each priority level has its own queue.  Levels share the stream by
+ * deficit round robin over bytes, with each level getting twice the
+ * share of the one below it, so that high priority messages go first
+ * without starving default ones.
+ *
+ * Messages waiting when the sending thread wakes are coalesced into
+ * one write (unless a message limit is set, in which case messages are
+ * written one at a time, as the limiter spaces them).
+ *
  * NOTE:
  * None of the member functions are safe to call if this class has been
  * destroyed.  Since the application-specific channel manager class can
@@ -67,11 +101,17 @@ class OutboundChannel : public Thread {
          *   Will be destroyed when this class is destroyed.
          * @param inLimiter the limiter for outbound messages.
          *   Must be destroyed by caller after this class is destroyed.
-         * @param inQueueSize the size of the send queue.  Defaults to 50.
+         * @param inQueueSize the most messages held in each priority
+         *   level's queue.  Defaults to 50.
+         * @param inMaxQueueBytes the most bytes held in each priority
+         *   level's queue.  Defaults to 65536.
+         *   When either limit is passed, the oldest messages at that
+         *   level are dropped (though the newest is always kept).
          */
         OutboundChannel( OutputStream *inOutputStream, HostAddress *inHost,
                          MessagePerSecondLimiter *inLimiter,
-                         unsigned long inQueueSize = 50 );
+                         unsigned long inQueueSize = 50,
+                         int inMaxQueueBytes = 65536 );
 
 
 
@@ -95,7 +135,8 @@ class OutboundChannel : public Thread {
          * @param inPriority the priority of this message.
          *   Values less than or equal to 0 indicate default priority,
          *   while positive values suggest higher priority.
-         *   Granularity of prioritization is implementation dependent.
+         *   Values 1 through OUTBOUND_CHANNEL_NUM_PRIORITIES - 1 are
+         *   separate levels, and higher values share the top level.
          *   Defaults to 0.
          *
          * @return true if the channel is still functioning properly,
@@ -149,6 +190,18 @@ class OutboundChannel : public Thread {
 
 
 
+        /**
+         * Gets the number of bytes in messages currently queued for this
+         * channel.
+         *
+         * Thread safe.
+         *
+         * @return the number of queued bytes.
+         */
+        int getQueuedByteCount();
+
+
+
         /**
          * Gets the number of outbound messages that have been dropped
          * by this channel.
@@ -159,6 +212,21 @@ class OutboundChannel : public Thread {
          */
         int getDroppedMessageCount();
 
+
+
+        /**
+         * Gets counts of sent messages by how long they waited, from
+         * sendMessage until written to the stream.
+         *
+         * Thread safe.
+         *
+         * @param outCounts array of OUTBOUND_CHANNEL_LATENCY_BUCKETS
+         *   where counts are returned.  Bucket 0 counts waits under 1 ms,
+         *   and bucket i counts waits from 2^(i-1) up to 2^i ms.  The
+         *   last bucket also counts all longer waits.
+         */
+        void getLatencyHistogram( int *outCounts );
+
         
 
         // implements the Thread interface
@@ -183,15 +251,46 @@ class OutboundChannel : public Thread {
         char mThreadStopped;
 
 
-        SimpleVector<char*> *mMessageQueue;
-        SimpleVector<char*> *mHighPriorityMessageQueue;
+        // messages before mQueueHeads[p] in mQueues[p] are already taken
+        SimpleVector<OutboundMessage> mQueues[
+            OUTBOUND_CHANNEL_NUM_PRIORITIES ];
+        int mQueueHeads[ OUTBOUND_CHANNEL_NUM_PRIORITIES ];
+
+        int mQueueBytes[ OUTBOUND_CHANNEL_NUM_PRIORITIES ];
+
+        // bytes each level may still send this round (sending thread only)
+        int mDeficits[ OUTBOUND_CHANNEL_NUM_PRIORITIES ];
+
+        // level whose turn it is, and whether it has had its quantum
+        // for this turn (sending thread only)
+        int mRoundLevel;
+        char mRoundLevelCharged;
 
 
         int mMaxQueueSize;
+
+        int mMaxQueueBytes;
         
         int mDroppedMessageCount;
 
         int mSentMessageCount;
+
+        int mLatencyCounts[ OUTBOUND_CHANNEL_LATENCY_BUCKETS ];
+
+
+
+        // must be called with mLock locked
+        int getQueueLength( int inLevel );
+
+        // must be called with mLock locked
+        // removes oldest message from a level and returns it
+        OutboundMessage takeMessage( int inLevel );
+
+        // must be called with mLock locked
+        // takes messages into outBatch by weighted round robin, up to
+        // inMaxBytes (or one message, if inMaxBytes is -1)
+        void takeBatch( SimpleVector<OutboundMessage> *outBatch,
+                        int inMaxBytes );
         
     };
 
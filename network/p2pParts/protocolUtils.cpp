@@ -6,6 +6,9 @@
  *
  * 2003-August-22   Jason Rohrer
  * Added function for getting a token after reading.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Added BufferedInputStream versions, which don't read byte-by-byte.
  */
 
 
@@ -85,23 +88,34 @@ char *readStreamUpToTag( InputStream *inInputStream,
 
 
 
-char *readStreamUpToTagAndGetToken( InputStream *inInputStream,
-                                    char *inTag, int inMaxCharsToRead,
-                                    int inTokenNumber ) {
+char *readStreamUpToTag( BufferedInputStream *inInputStream,
+                         char *inTag,
+                         int inMaxCharsToRead ) {
 
-    // read the string
-    char *readString = readStreamUpToTag( inInputStream,
-                                          inTag,
-                                          inMaxCharsToRead );
+    char *readString = inInputStream->readUntil( inTag, inMaxCharsToRead );
 
     if( readString == NULL ) {
-        return NULL;
+        char *message = autoSprintf(
+            "Failed to find end tag \"%s\" within %d characters\n",
+            inTag, inMaxCharsToRead );
+        
+        AppLog::info( "readStreamUpToTag", message );
+
+        delete [] message;
         }
 
+    return readString;
+    }
+
+
+
+// gets a token from a read string, destroying the string
+static char *getReadToken( char *inReadString, int inTokenNumber ) {
+
     SimpleVector<char *> *readTokens =
-        tokenizeString( readString );
+        tokenizeString( inReadString );
 
-    delete [] readString;
+    delete [] inReadString;
 
     
     // second token should be their key
@@ -118,6 +132,8 @@ char *readStreamUpToTagAndGetToken( InputStream *inInputStream,
             inTokenNumber, numTokens );
         
         AppLog::error( "readStreamUpToTagAndGetToken", message );
+
+        delete [] message;
         }
 
     
@@ -130,3 +146,38 @@ char *readStreamUpToTagAndGetToken( InputStream *inInputStream,
     // will be NULL if not enough tokens read
     return selectedToken;
     }
+
+
+
+char *readStreamUpToTagAndGetToken( InputStream *inInputStream,
+                                    char *inTag, int inMaxCharsToRead,
+                                    int inTokenNumber ) {
+
+    // read the string
+    char *readString = readStreamUpToTag( inInputStream,
+                                          inTag,
+                                          inMaxCharsToRead );
+
+    if( readString == NULL ) {
+        return NULL;
+        }
+
+    return getReadToken( readString, inTokenNumber );
+    }
+
+
+
+char *readStreamUpToTagAndGetToken( BufferedInputStream *inInputStream,
+                                    char *inTag, int inMaxCharsToRead,
+                                    int inTokenNumber ) {
+
+    char *readString = readStreamUpToTag( inInputStream,
+                                          inTag,
+                                          inMaxCharsToRead );
+
+    if( readString == NULL ) {
+        return NULL;
+        }
+
+    return getReadToken( readString, inTokenNumber );
+    }
@@ -6,6 +6,9 @@
  *
  * 2003-August-22   Jason Rohrer
  * Added function for getting a token after reading.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Added BufferedInputStream versions, which don't read byte-by-byte.
  */
 
 
@@ -17,6 +20,7 @@
 
 #include "minorGems/io/InputStream.h"
 #include "minorGems/io/OutputStream.h"
+#include "minorGems/io/BufferedInputStream.h"
 
 
 
@@ -48,6 +52,17 @@ char *readStreamUpToTag( InputStream *inInputStream,
 
 
 
+/**
+ * Same, but reads buffered blocks instead of single bytes.
+ *
+ * Data past the tag stays buffered in inInputStream, so later reads
+ * must go through it too.
+ */
+char *readStreamUpToTag( BufferedInputStream *inInputStream,
+                         char *inTag, int inMaxCharsToRead );
+
+
+
 
 /**
  * Reads from a stream up to (and including) the
@@ -74,4 +89,13 @@ char *readStreamUpToTagAndGetToken( InputStream *inInputStream,
 
 
 
+/**
+ * Same, but reads buffered blocks instead of single bytes.
+ */
+char *readStreamUpToTagAndGetToken( BufferedInputStream *inInputStream,
+                                    char *inTag, int inMaxCharsToRead,
+                                    int inTokenNumber );
+
+
+
 #endif
@@ -0,0 +1,466 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+/**
+ * Checks ReliableUDPConnection over a simulated link that loses,
+ * duplicates, delays, and reorders packets:  reliable-ordered messages
+ * must all arrive in order, reliable-unordered ones must all arrive once,
+ * and unreliable-sequenced ones must never go backward.  Prints delivery
+ * latency per channel type, to show that losses don't hold up unreliable
+ * messages.
+ *
+ * Then sends messages between two ReliableUDPEndpoints over loopback,
+ * waiting on a SocketPoll.
+ */
+
+
+#include "minorGems/network/ReliableUDP.h"
+#include "minorGems/network/SocketPoll.h"
+#include "minorGems/system/Time.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+
+static int numBad = 0;
+
+
+enum {
+    ORDERED_CHANNEL = 0,
+    UNORDERED_CHANNEL,
+    SEQUENCED_CHANNEL
+    };
+
+static ReliableUDPChannelType channelTypes[3] = {
+    RELIABLE_UDP_RELIABLE_ORDERED,
+    RELIABLE_UDP_RELIABLE_UNORDERED,
+    RELIABLE_UDP_UNRELIABLE_SEQUENCED };
+
+
+
+typedef struct InTransit {
+        double arrivalTime;
+        // 0 for A to B, 1 for B to A
+        int direction;
+        unsigned char data[ RELIABLE_UDP_MAX_PACKET_LENGTH ];
+        int length;
+    } InTransit;
+
+
+
+// message body:  int index, double send time, padding
+static int makeMessage( unsigned char *outData, int inIndex, double inTime,
+                        int inPadding ) {
+    memcpy( outData, &inIndex, sizeof( int ) );
+    memcpy( &( outData[ sizeof( int ) ] ), &inTime, sizeof( double ) );
+
+    int length = sizeof( int ) + sizeof( double ) + inPadding;
+    memset( &( outData[ sizeof( int ) + sizeof( double ) ] ), inIndex & 0xFF,
+            inPadding );
+    return length;
+    }
+
+
+
+// inPerTick reliable messages of each kind every 10 ms, with a
+// sequenced one
+static void simulate( double inLossRate, double inDuplicateRate,
+                      double inLatency, double inJitter, int inPerTick ) {
+
+    struct UDPAddress address = { 0, 0 };
+
+    double time = 0;
+
+    ReliableUDPConnection a( &address, 0xC0FFEE, 3, channelTypes, time );
+    ReliableUDPConnection b( &address, 0xC0FFEE, 3, channelTypes, time );
+
+    SimpleVector<InTransit *> transit;
+
+    int numReliable = 1000;
+
+    int nextOrderedToReceive = 0;
+    char *unorderedReceived = new char[ numReliable ];
+    memset( unorderedReceived, 0, numReliable );
+    int numUnorderedReceived = 0;
+
+    int numSequencedSent = 0;
+    int numSequencedReceived = 0;
+    int lastSequenced = -1;
+
+    double latencySum[3] = { 0, 0, 0 };
+    double latencyMax[3] = { 0, 0, 0 };
+    int latencyCount[3] = { 0, 0, 0 };
+
+    int numOrderedSent = 0;
+    int numUnorderedSent = 0;
+
+    unsigned char message[ 512 ];
+    unsigned char packet[ RELIABLE_UDP_MAX_PACKET_LENGTH ];
+
+    double step = 0.001;
+    double endTime = 60;
+
+    // same random link every run
+    srand( 17 );
+
+    while( time < endTime &&
+           ( nextOrderedToReceive < numReliable ||
+             numUnorderedReceived < numReliable ) ) {
+
+        // send some of each, every 10 ms
+        if( (int)( time / step ) % 10 == 0 ) {
+            for( int i=0; i<inPerTick && numOrderedSent < numReliable;
+                 i++ ) {
+                int length = makeMessage( message, numOrderedSent, time,
+                                          rand() % 100 );
+                a.send( ORDERED_CHANNEL, message, length );
+                numOrderedSent++;
+                }
+            for( int i=0; i<inPerTick && numUnorderedSent < numReliable;
+                 i++ ) {
+                int length = makeMessage( message, numUnorderedSent, time,
+                                          rand() % 100 );
+                a.send( UNORDERED_CHANNEL, message, length );
+                numUnorderedSent++;
+                }
+
+            int length = makeMessage( message, numSequencedSent, time, 20 );
+            a.send( SEQUENCED_CHANNEL, message, length );
+            numSequencedSent++;
+            }
+
+
+        // both sides send
+        for( int d=0; d<2; d++ ) {
+            ReliableUDPConnection *from = ( d == 0 ) ? &a : &b;
+
+            int length;
+            while( ( length = from->getPacketToSend( packet, time ) ) > 0 ) {
+
+                if( (double)rand() / RAND_MAX < inLossRate ) {
+                    continue;
+                    }
+
+                int copies = 1;
+                if( (double)rand() / RAND_MAX < inDuplicateRate ) {
+                    copies = 2;
+                    }
+
+                for( int c=0; c<copies; c++ ) {
+                    InTransit *t = new InTransit;
+                    t->arrivalTime = time + inLatency +
+                        inJitter * rand() / RAND_MAX;
+                    t->direction = d;
+                    memcpy( t->data, packet, length );
+                    t->length = length;
+                    transit.push_back( t );
+                    }
+                }
+            }
+
+        time += step;
+
+
+        // deliver what's arrived, in any order
+        for( int i=0; i<transit.size(); i++ ) {
+            InTransit *t = transit.getElementDirect( i );
+
+            if( t->arrivalTime <= time ) {
+                ReliableUDPConnection *to = ( t->direction == 0 ) ? &b : &a;
+
+                if( ! to->receivePacket( t->data, t->length, time ) ) {
+                    printf( "Good packet rejected\n" );
+                    numBad++;
+                    }
+                delete t;
+                transit.deleteElement( i );
+                i--;
+                }
+            }
+
+
+        int channel;
+        int length;
+        unsigned char *data;
+        while( ( data = b.receiveMessage( &channel, &length ) ) != NULL ) {
+            int index;
+            double sendTime;
+            memcpy( &index, data, sizeof( int ) );
+            memcpy( &sendTime, &( data[ sizeof( int ) ] ), sizeof( double ) );
+
+            double latency = time - sendTime;
+            latencySum[ channel ] += latency;
+            latencyCount[ channel ]++;
+            if( latency > latencyMax[ channel ] ) {
+                latencyMax[ channel ] = latency;
+                }
+
+            for( int i=sizeof( int ) + sizeof( double ); i<length; i++ ) {
+                if( data[i] != ( index & 0xFF ) ) {
+                    printf( "Message %d corrupted\n", index );
+                    numBad++;
+                    break;
+                    }
+                }
+
+            if( channel == ORDERED_CHANNEL ) {
+                if( index != nextOrderedToReceive ) {
+                    printf( "Ordered message %d arrived, expected %d\n",
+                            index, nextOrderedToReceive );
+                    numBad++;
+                    }
+                nextOrderedToReceive = index + 1;
+                }
+            else if( channel == UNORDERED_CHANNEL ) {
+                if( unorderedReceived[ index ] ) {
+                    printf( "Unordered message %d arrived twice\n", index );
+                    numBad++;
+                    }
+                else {
+                    unorderedReceived[ index ] = true;
+                    numUnorderedReceived++;
+                    }
+                }
+            else {
+                if( index <= lastSequenced ) {
+                    printf( "Sequenced message %d arrived after %d\n",
+                            index, lastSequenced );
+                    numBad++;
+                    }
+                lastSequenced = index;
+                numSequencedReceived++;
+                }
+            delete [] data;
+            }
+        }
+
+
+    if( nextOrderedToReceive != numReliable ||
+        numUnorderedReceived != numReliable ) {
+        printf( "Only %d ordered and %d unordered of %d arrived\n",
+                nextOrderedToReceive, numUnorderedReceived, numReliable );
+        numBad++;
+        }
+
+    printf( "Loss %2.0f%%, duplicates %2.0f%%, latency %3.0f-%3.0f ms:  "
+            "done in %.2f s, %d packets sent, %d counted lost, "
+            "RTT %.0f ms\n",
+            inLossRate * 100, inDuplicateRate * 100,
+            inLatency * 1000, ( inLatency + inJitter ) * 1000,
+            time, a.getNumPacketsSent(), a.getNumPacketsLost(),
+            a.getRoundTripTime() * 1000 );
+
+    const char *names[3] = { "ordered", "unordered", "sequenced" };
+    for( int c=0; c<3; c++ ) {
+        printf( "    %-9s  mean latency %4.0f ms, max %4.0f ms",
+                names[c],
+                1000 * latencySum[c] / ( latencyCount[c] + 1e-9 ),
+                1000 * latencyMax[c] );
+        if( c == SEQUENCED_CHANNEL ) {
+            printf( ", %d of %d arrived", numSequencedReceived,
+                    numSequencedSent );
+            }
+        printf( "\n" );
+        }
+
+    if( inLossRate == 0 && inDuplicateRate == 0 && inJitter == 0 &&
+        a.getNumPacketsLost() != 0 ) {
+        printf( "Packets counted lost on perfect link\n" );
+        numBad++;
+        }
+
+    for( int i=0; i<transit.size(); i++ ) {
+        delete transit.getElementDirect( i );
+        }
+    delete [] unorderedReceived;
+    }
+
+
+
+static void checkMalformed() {
+    struct UDPAddress address = { 0, 0 };
+    ReliableUDPConnection a( &address, 1, 3, channelTypes, 0 );
+    ReliableUDPConnection b( &address, 2, 3, channelTypes, 0 );
+
+    unsigned char message[4] = { 1, 2, 3, 4 };
+    a.send( ORDERED_CHANNEL, message, 4 );
+
+    unsigned char packet[ RELIABLE_UDP_MAX_PACKET_LENGTH ];
+    int length = a.getPacketToSend( packet, 0 );
+
+    if( length <= 0 ) {
+        printf( "Nothing to send\n" );
+        numBad++;
+        return;
+        }
+
+    // wrong protocol ID
+    if( b.receivePacket( packet, length, 0 ) ) {
+        printf( "Wrong protocol accepted\n" );
+        numBad++;
+        }
+
+    ReliableUDPConnection c( &address, 1, 3, channelTypes, 0 );
+
+    // cut off, and bad channel
+    unsigned char badPacket[ RELIABLE_UDP_MAX_PACKET_LENGTH ];
+    memcpy( badPacket, packet, length );
+    badPacket[ RELIABLE_UDP_PACKET_HEADER_LENGTH ] = 9;
+
+    if( c.receivePacket( packet, length - 1, 0 ) ||
+        c.receivePacket( badPacket, length, 0 ) ||
+        c.receivePacket( packet, 5, 0 ) ) {
+        printf( "Malformed packet accepted\n" );
+        numBad++;
+        }
+
+    int channel;
+    unsigned char *data = c.receiveMessage( &channel, &length );
+    if( data != NULL ) {
+        printf( "Message delivered from malformed packet\n" );
+        numBad++;
+        delete [] data;
+        }
+
+    if( a.send( 7, message, 4 ) ||
+        a.send( 0, message, RELIABLE_UDP_MAX_MESSAGE_LENGTH + 1 ) ) {
+        printf( "Bad send accepted\n" );
+        numBad++;
+        }
+    }
+
+
+
+static void loopback() {
+    Socket::initSocketFramework();
+
+    unsigned short portA = 20000 + rand() % 20000;
+    unsigned short portB = portA + 1;
+
+    SocketUDP socketA( portA );
+    SocketUDP socketB( portB );
+
+    ReliableUDPEndpoint endpointA( &socketA, 77, 3, channelTypes, false );
+    ReliableUDPEndpoint endpointB( &socketB, 77, 3, channelTypes, true );
+
+    struct UDPAddress *addressB = SocketUDP::makeAddress( "127.0.0.1",
+                                                          portB );
+    ReliableUDPConnection *toB = endpointA.connect( addressB );
+    delete addressB;
+
+    SocketPoll poll;
+    poll.addSocketUDP( &socketA );
+    poll.addSocketUDP( &socketB );
+
+    int numMessages = 20000;
+    int numSent = 0;
+    int numReceived = 0;
+
+    ReliableUDPConnection *fromA = NULL;
+
+    unsigned char message[ 100 ];
+
+    double startTime = Time::getMonotonicTime();
+
+    while( numReceived < numMessages &&
+           Time::getMonotonicTime() - startTime < 30 ) {
+
+        // keep a few thousand queued
+        while( numSent < numMessages &&
+               toB->getNumReliableMessagesPending() < 2000 ) {
+            int length = makeMessage( message, numSent, 0, 50 );
+            toB->send( ORDERED_CHANNEL, message, length );
+            numSent++;
+            }
+
+        int timeout = endpointA.getMSUntilNextUpdate();
+        int timeoutB = endpointB.getMSUntilNextUpdate();
+        if( timeoutB != -1 && timeoutB < timeout ) {
+            timeout = timeoutB;
+            }
+
+        SocketOrServer *ready[2];
+        int numReady = poll.wait( ready, 2, timeout );
+
+        for( int i=0; i<numReady; i++ ) {
+            if( ready[i]->udp == &socketA ) {
+                endpointA.receive();
+                }
+            else if( ready[i]->udp == &socketB ) {
+                endpointB.receive();
+                }
+            else {
+                printf( "Poll returned unknown socket\n" );
+                numBad++;
+                }
+            }
+
+        ReliableUDPConnection *newConnection = endpointB.getNewConnection();
+        if( newConnection != NULL ) {
+            fromA = newConnection;
+            }
+
+        if( fromA != NULL ) {
+            int channel;
+            int length;
+            unsigned char *data;
+            while( ( data = fromA->receiveMessage( &channel, &length ) )
+                   != NULL ) {
+                int index;
+                memcpy( &index, data, sizeof( int ) );
+                if( index != numReceived ) {
+                    printf( "Loopback got %d, expected %d\n",
+                            index, numReceived );
+                    numBad++;
+                    }
+                numReceived = index + 1;
+                delete [] data;
+                }
+            }
+
+        endpointA.update();
+        endpointB.update();
+        }
+
+    double totalTime = Time::getMonotonicTime() - startTime;
+
+    if( numReceived != numMessages || endpointB.getNumConnections() != 1 ) {
+        printf( "Loopback delivered %d of %d\n", numReceived, numMessages );
+        numBad++;
+        }
+
+    printf( "Loopback:  %d 62-byte ordered messages in %.3f s, "
+            "%d packets sent, %d counted lost, cwnd %d bytes\n",
+            numReceived, totalTime, toB->getNumPacketsSent(),
+            toB->getNumPacketsLost(), toB->getCongestionWindow() );
+
+    poll.removeSocketUDP( &socketA );
+    poll.removeSocketUDP( &socketB );
+    }
+
+
+
+int main() {
+
+    checkMalformed();
+
+    simulate( 0, 0, 0.030, 0, 5 );
+    simulate( 0.05, 0.02, 0.030, 0.020, 2 );
+    simulate( 0.20, 0.05, 0.050, 0.050, 1 );
+
+    loopback();
+
+
+    if( numBad == 0 ) {
+        printf( "All tests passed\n" );
+        return 0;
+        }
+    printf( "%d failures\n", numBad );
+    return 1;
+    }
@@ -0,0 +1,165 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14   Jason Rohrer
+ * Created.
+ */
+
+/**
+ * Measures how long SocketPoll::wait takes to report one ready socket
+ * while thousands of others sit idle.
+ *
+ * Unix-like platforms only (uses socketpair).  Link with whichever
+ * SocketPoll implementation is to be measured (see
+ * socketPollBenchmarkCompile).
+ *
+ * Usage:  socketPollBenchmark [numSockets ...]
+ *   Defaults to 1000 5000 10000.
+ *
+ * The select-based SocketPollUnix can't handle descriptors at or above
+ * FD_SETSIZE (usually 1024), so only give it counts below about 500.
+ */
+
+
+#include "minorGems/network/SocketPoll.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+
+
+static double getSeconds() {
+    struct timeval tv;
+    gettimeofday( &tv, NULL );
+    return tv.tv_sec + tv.tv_usec / 1000000.0;
+    }
+
+
+
+static void runBenchmark( int inNumSockets ) {
+    SocketPoll poll;
+
+    Socket **watched = new Socket*[ inNumSockets ];
+    int *otherEnds = new int[ inNumSockets ];
+
+    int numMade = 0;
+
+    for( int i=0; i<inNumSockets; i++ ) {
+        int pair[2];
+
+        if( socketpair( AF_UNIX, SOCK_STREAM, 0, pair ) != 0 ) {
+            break;
+            }
+
+        watched[i] = new Socket();
+        watched[i]->mNativeSocketID = pair[0];
+        otherEnds[i] = pair[1];
+
+        poll.addSocket( watched[i], (void *)( &( otherEnds[i] ) ) );
+        numMade++;
+        }
+
+    if( numMade < inNumSockets ) {
+        printf( "Only made %d of %d socket pairs (descriptor limit?)\n",
+                numMade, inNumSockets );
+        }
+
+
+    int numWakeups = 2000;
+
+    double totalTime = 0;
+    double maxTime = 0;
+    int numMissed = 0;
+
+    SocketOrServer *ready[ 64 ];
+
+    unsigned int x = 12345;
+
+    for( int w=0; w<numWakeups; w++ ) {
+        x = x * 1103515245U + 12345U;
+        int pick = ( x >> 8 ) % numMade;
+
+        unsigned char byte = 1;
+
+        double startTime = getSeconds();
+
+        if( write( otherEnds[pick], &byte, 1 ) != 1 ) {
+            numMissed++;
+            continue;
+            }
+
+        int numReady = poll.wait( ready, 64, 1000 );
+
+        double time = getSeconds() - startTime;
+
+        totalTime += time;
+        if( time > maxTime ) {
+            maxTime = time;
+            }
+
+        char found = false;
+
+        for( int r=0; r<numReady; r++ ) {
+            if( ready[r]->sock == watched[pick] ) {
+                found = true;
+                }
+            }
+
+        if( ! found ) {
+            numMissed++;
+            }
+
+        // drain, so it isn't reported again
+        if( read( watched[pick]->mNativeSocketID, &byte, 1 ) != 1 ) {
+            numMissed++;
+            }
+        }
+
+    printf( "%6d sockets:  mean wakeup %7.2f us, max %8.2f us, "
+            "%d missed\n",
+            numMade,
+            1000000 * totalTime / numWakeups,
+            1000000 * maxTime,
+            numMissed );
+
+
+    for( int i=0; i<numMade; i++ ) {
+        poll.removeSocket( watched[i] );
+        delete watched[i];
+        close( otherEnds[i] );
+        }
+
+    delete [] watched;
+    delete [] otherEnds;
+    }
+
+
+
+int main( int inNumArgs, char **inArgs ) {
+
+    // two descriptors per pair
+    struct rlimit limit;
+    if( getrlimit( RLIMIT_NOFILE, &limit ) == 0 ) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit( RLIMIT_NOFILE, &limit );
+        }
+
+
+    if( inNumArgs > 1 ) {
+        for( int i=1; i<inNumArgs; i++ ) {
+            runBenchmark( atoi( inArgs[i] ) );
+            }
+        }
+    else {
+        runBenchmark( 1000 );
+        runBenchmark( 5000 );
+        runBenchmark( 10000 );
+        }
+
+    return 0;
+    }
@@ -0,0 +1,386 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14   Jason Rohrer
+ * Created.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Support for SOCKET_POLL_NO_READ.
+ * Support for watching SocketUDP.
+ */
+
+
+// implementation of SocketPoll for MacOS and the BSDs, using kqueue,
+// which has no FD_SETSIZE limit, and only returns sockets that are ready
+// instead of scanning all of them
+
+
+#include "minorGems/network/SocketPoll.h"
+
+#include <sys/types.h>
+#include <sys/event.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+
+
+// applies one change to kqueue for s
+static char changeFilter( int inQueue, int inSocketID, short inFilter,
+                          unsigned short inKqueueFlags, SocketOrServer *s ) {
+    struct kevent change;
+
+    EV_SET( &change, inSocketID, inFilter, inKqueueFlags, 0, 0, (void *)s );
+
+    int result = kevent( inQueue, &change, 1, NULL, 0, NULL );
+
+    return ( result != -1 );
+    }
+
+
+
+// sets read and write filters on a socket to match inFlags
+static char setFilters( int inQueue, int inSocketID, int inFlags,
+                        int inOldFlags, SocketOrServer *s ) {
+    unsigned short triggerFlag = 0;
+
+    if( inFlags & SOCKET_POLL_EDGE_TRIGGERED ) {
+        triggerFlag = EV_CLEAR;
+        }
+
+    unsigned short readEnableFlag = EV_ENABLE;
+
+    if( inFlags & SOCKET_POLL_NO_READ ) {
+        // keep filter, but don't report it
+        readEnableFlag = EV_DISABLE;
+        }
+
+    // adding again replaces flags of existing filter
+    if( ! changeFilter( inQueue, inSocketID, EVFILT_READ,
+                        EV_ADD | readEnableFlag | triggerFlag, s ) ) {
+        return false;
+        }
+
+    if( inFlags & SOCKET_POLL_WRITE ) {
+        return changeFilter( inQueue, inSocketID, EVFILT_WRITE,
+                             EV_ADD | EV_ENABLE | triggerFlag, s );
+        }
+    else if( inOldFlags & SOCKET_POLL_WRITE ) {
+        return changeFilter( inQueue, inSocketID, EVFILT_WRITE,
+                             EV_DELETE, s );
+        }
+
+    return true;
+    }
+
+
+
+// makes timespec for a millisecond timeout, or returns NULL for -1
+static struct timespec *getTimeout( int inTimeoutMS,
+                                    struct timespec *inStorage ) {
+    if( inTimeoutMS < 0 ) {
+        return NULL;
+        }
+    inStorage->tv_sec = inTimeoutMS / 1000;
+    inStorage->tv_nsec = ( inTimeoutMS % 1000 ) * 1000000;
+    return inStorage;
+    }
+
+
+
+
+SocketPoll::SocketPoll() {
+    int *queueStorage = new int[1];
+
+    queueStorage[0] = kqueue();
+
+	mNativeObjectPointer = (void *)queueStorage;
+
+    mNextSocketOrServer = 0;
+    }
+
+
+
+SocketPoll::~SocketPoll() {
+    int *queueStorage = (int *)( mNativeObjectPointer );
+	int queueHandle = queueStorage[0];
+
+    if( queueHandle != -1 ) {
+        close( queueHandle );
+        }
+
+    delete [] queueStorage;
+
+    for( int i=0; i<mWatchedList.size(); i++ ) {
+        SocketOrServer *s = *( mWatchedList.getElement( i ) );
+        delete s;
+        }
+    }
+
+
+
+
+char SocketPoll::addSocket( Socket *inSock, void *inOtherData,
+                            int inFlags ) {
+
+    int *queueStorage = (int *)( mNativeObjectPointer );
+	int queueHandle = queueStorage[0];
+
+    if( queueHandle == -1 ) {
+        return false;
+        }
+
+
+    SocketOrServer *s = new SocketOrServer;
+
+    s->isSocket = true;
+    s->sock = inSock;
+    s->server = NULL;
+    s->udp = NULL;
+    s->otherData = inOtherData;
+    s->flags = inFlags;
+    s->readReady = false;
+    s->writeReady = false;
+
+    mWatchedList.push_back( s );
+
+    return setFilters( queueHandle, inSock->mNativeSocketID, inFlags, 0, s );
+    }
+
+
+
+
+
+char SocketPoll::addSocketServer( SocketServer *inServer, void *inOtherData ) {
+    int *queueStorage = (int *)( mNativeObjectPointer );
+	int queueHandle = queueStorage[0];
+
+    if( queueHandle == -1 ) {
+        return false;
+        }
+
+
+    SocketOrServer *s = new SocketOrServer;
+
+    s->isSocket = false;
+    s->sock = NULL;
+    s->server = inServer;
+    s->udp = NULL;
+    s->otherData = inOtherData;
+    s->flags = 0;
+    s->readReady = false;
+    s->writeReady = false;
+
+    mWatchedList.push_back( s );
+
+    // listening socket reports read-ready when a connection can be accepted
+    return setFilters( queueHandle, inServer->mNativeSocketID, 0, 0, s );
+    }
+
+
+char SocketPoll::addSocketUDP( SocketUDP *inSock, void *inOtherData ) {
+    int *queueStorage = (int *)( mNativeObjectPointer );
+	int queueHandle = queueStorage[0];
+
+    if( queueHandle == -1 ) {
+        return false;
+        }
+
+
+    SocketOrServer *s = new SocketOrServer;
+
+    s->isSocket = false;
+    s->sock = NULL;
+    s->server = NULL;
+    s->udp = inSock;
+    s->otherData = inOtherData;
+    s->flags = 0;
+    s->readReady = false;
+    s->writeReady = false;
+
+    mWatchedList.push_back( s );
+
+    return setFilters( queueHandle, inSock->getNativeSocketID(), 0, 0, s );
+    }
+
+
+
+char SocketPoll::setSocketFlags( Socket *inSock, int inFlags ) {
+    int *queueStorage = (int *)( mNativeObjectPointer );
+	int queueHandle = queueStorage[0];
+
+    if( queueHandle == -1 ) {
+        return false;
+        }
+
+    for( int i=0; i<mWatchedList.size(); i++ ) {
+        SocketOrServer *s = *( mWatchedList.getElement( i ) );
+        if( s->sock == inSock ) {
+
+            char result = setFilters( queueHandle, inSock->mNativeSocketID,
+                                      inFlags, s->flags, s );
+
+            if( result ) {
+                s->flags = inFlags;
+                }
+            return result;
+            }
+        }
+    return false;
+    }
+
+
+
+void SocketPoll::removeSocket( Socket *inSock ) {
+    int *queueStorage = (int *)( mNativeObjectPointer );
+	int queueHandle = queueStorage[0];
+
+    if( queueHandle == -1 ) {
+        return;
+        }
+
+	int socketID = inSock->mNativeSocketID;
+
+
+    for( int i=0; i<mWatchedList.size(); i++ ) {
+        SocketOrServer *s = *( mWatchedList.getElement( i ) );
+        if( s->sock == inSock ) {
+
+            changeFilter( queueHandle, socketID, EVFILT_READ, EV_DELETE, s );
+
+            if( s->flags & SOCKET_POLL_WRITE ) {
+                changeFilter( queueHandle, socketID, EVFILT_WRITE,
+                              EV_DELETE, s );
+                }
+
+            delete s;
+            mWatchedList.deleteElement( i );
+            return;
+            }
+        }
+    }
+
+
+
+void SocketPoll::removeSocketServer( SocketServer *inServer ) {
+    int *queueStorage = (int *)( mNativeObjectPointer );
+	int queueHandle = queueStorage[0];
+
+    if( queueHandle == -1 ) {
+        return;
+        }
+
+	int socketID = inServer->mNativeSocketID;
+
+
+    for( int i=0; i<mWatchedList.size(); i++ ) {
+        SocketOrServer *s = *( mWatchedList.getElement( i ) );
+        if( s->server == inServer ) {
+
+            changeFilter( queueHandle, socketID, EVFILT_READ, EV_DELETE, s );
+
+            delete s;
+            mWatchedList.deleteElement( i );
+            return;
+            }
+        }
+    }
+
+
+
+void SocketPoll::removeSocketUDP( SocketUDP *inSock ) {
+    int *queueStorage = (int *)( mNativeObjectPointer );
+	int queueHandle = queueStorage[0];
+
+    if( queueHandle == -1 ) {
+        return;
+        }
+
+	int socketID = inSock->getNativeSocketID();
+
+
+    for( int i=0; i<mWatchedList.size(); i++ ) {
+        SocketOrServer *s = *( mWatchedList.getElement( i ) );
+        if( s->udp == inSock ) {
+
+            changeFilter( queueHandle, socketID, EVFILT_READ, EV_DELETE, s );
+
+            delete s;
+            mWatchedList.deleteElement( i );
+            return;
+            }
+        }
+    }
+
+
+
+
+SocketOrServer *SocketPoll::wait( int inTimeoutMS ) {
+    SocketOrServer *result;
+
+    if( wait( &result, 1, inTimeoutMS ) == 0 ) {
+        return NULL;
+        }
+
+    return result;
+    }
+
+
+
+int SocketPoll::wait( SocketOrServer **outReady, int inMax,
+                      int inTimeoutMS ) {
+    int *queueStorage = (int *)( mNativeObjectPointer );
+	int queueHandle = queueStorage[0];
+
+    if( queueHandle == -1 || inMax <= 0 ) {
+        return 0;
+        }
+
+    // enough for most calls without touching the heap
+    struct kevent stackEvents[ 256 ];
+
+    struct kevent *returnedEvents = stackEvents;
+
+    if( inMax > 256 ) {
+        returnedEvents = new struct kevent[ inMax ];
+        }
+
+    struct timespec timeout;
+
+    int numEvents = kevent( queueHandle, NULL, 0, returnedEvents, inMax,
+                            getTimeout( inTimeoutMS, &timeout ) );
+
+    // unlike epoll, read and write readiness come back as separate
+    // events, so a socket can show up twice
+
+    for( int i=0; i<numEvents; i++ ) {
+        SocketOrServer *s = (SocketOrServer *)( returnedEvents[i].udata );
+        s->readReady = false;
+        s->writeReady = false;
+        }
+
+    int numReady = 0;
+
+    for( int i=0; i<numEvents; i++ ) {
+        SocketOrServer *s = (SocketOrServer *)( returnedEvents[i].udata );
+
+        if( ! s->readReady && ! s->writeReady ) {
+            // first time seen in this batch
+            outReady[ numReady ] = s;
+            numReady++;
+            }
+
+        // errors and EOF come back on the read filter
+        if( returnedEvents[i].filter == EVFILT_WRITE ) {
+            s->writeReady = true;
+            }
+        else {
+            s->readReady = true;
+            }
+        }
+
+    if( returnedEvents != stackEvents ) {
+        delete [] returnedEvents;
+        }
+
+    return numReady;
+    }
@@ -19,6 +19,7 @@
 // Anyone who is running a serious, high performance server will be 
 // doing it on Linux and will be able to take advantage of the better
 // implementation in SocketPollLinux
+// (or SocketPollKqueue on MacOS/BSD, or SocketPollWin32 on Windows)
 
 // This implementation breaks select calls up into batches, selects one
 // batch at a time, and returns as soon as an event in any batch is ready
@@ -69,14 +70,19 @@ SocketPoll::~SocketPoll() {
 
 
 
-char SocketPoll::addSocket( Socket *inSock, void *inOtherData ) {
+char SocketPoll::addSocket( Socket *inSock, void *inOtherData, 
+                            int inFlags ) {
 
     SocketOrServer *s = new SocketOrServer;
     
     s->isSocket = true;
     s->sock = inSock;
     s->server = NULL;
+    s->udp = NULL;
     s->otherData = inOtherData;
+    s->flags = inFlags;
+    s->readReady = false;
+    s->writeReady = false;
     
     mWatchedList.push_back( s );
     
@@ -93,7 +99,11 @@ char SocketPoll::addSocketServer( SocketServer *inServer, void *inOtherData ) {
     s->isSocket = false;
     s->sock = NULL;
     s->server = inServer;
+    s->udp = NULL;
     s->otherData = inOtherData;
+    s->flags = 0;
+    s->readReady = false;
+    s->writeReady = false;
     
     mWatchedList.push_back( s );
     
@@ -102,6 +112,40 @@ char SocketPoll::addSocketServer( SocketServer *inServer, void *inOtherData ) {
 
 
 
+char SocketPoll::addSocketUDP( SocketUDP *inSock, void *inOtherData ) {
+    
+    SocketOrServer *s = new SocketOrServer;
+    
+    s->isSocket = false;
+    s->sock = NULL;
+    s->server = NULL;
+    s->udp = inSock;
+    s->otherData = inOtherData;
+    s->flags = 0;
+    s->readReady = false;
+    s->writeReady = false;
+    
+    mWatchedList.push_back( s );
+    
+    return true;
+    }
+
+
+
+
+char SocketPoll::setSocketFlags( Socket *inSock, int inFlags ) {
+
+    for( int i=0; i<mWatchedList.size(); i++ ) {
+        SocketOrServer *s = *( mWatchedList.getElement( i ) );
+        if( s->sock == inSock ) {
+            s->flags = inFlags;
+            return true;
+            }
+        }
+    return false;
+    }
+
+
 
 void SocketPoll::removeSocket( Socket *inSock ) {
 
@@ -109,6 +153,9 @@ void SocketPoll::removeSocket( Socket *inSock ) {
         SocketOrServer *s = *( mWatchedList.getElement( i ) );
         if( s->sock == inSock ) {
 
+            // don't return it later if it was found ready already
+            mReadyList.deleteElementEqualTo( s );
+
             delete s;
             mWatchedList.deleteElement( i );
             return;
@@ -123,6 +170,25 @@ void SocketPoll::removeSocketServer( SocketServer *inServer ) {
         SocketOrServer *s = *( mWatchedList.getElement( i ) );
         if( s->server == inServer ) {
             
+            mReadyList.deleteElementEqualTo( s );
+
+            delete s;
+            mWatchedList.deleteElement( i );
+            return;
+            }
+        }
+    }
+
+
+
+void SocketPoll::removeSocketUDP( SocketUDP *inSock ) {
+
+    for( int i=0; i<mWatchedList.size(); i++ ) {
+        SocketOrServer *s = *( mWatchedList.getElement( i ) );
+        if( s->udp == inSock ) {
+            
+            mReadyList.deleteElementEqualTo( s );
+
             delete s;
             mWatchedList.deleteElement( i );
             return;
@@ -150,27 +216,26 @@ SocketOrServer *SocketPoll::wait( int inTimeoutMS ) {
         mNextSocketOrServer = 0;
         }
 
-    int endPoint = mNextSocketOrServer - 1;
-
-    if( endPoint < 0 ) {
-        endPoint = mWatchedList.size();
-        }
+    // check each one exactly once, in a full circle from where we left off
+    int numLeft = mWatchedList.size();
     
 
     // select on batches of at most FD_SETSIZE, and add any that
     // are ready to our ready list
-    while( mNextSocketOrServer != endPoint ) {
+    while( numLeft > 0 ) {
 
         SimpleVector<SocketOrServer *> checkList;
         SimpleVector<int> checkIDList;
 
         fd_set fdr;
+        fd_set fdw;
 
         FD_ZERO( &fdr );
+        FD_ZERO( &fdw );
 
         int maxSocketID = 0;
 
-        for( int i=0; i<FD_SETSIZE && mNextSocketOrServer != endPoint; i++ ) {
+        for( int i=0; i<FD_SETSIZE && numLeft > 0; i++ ) {
             
             SocketOrServer *s = 
                 mWatchedList.getElementDirect( mNextSocketOrServer );
@@ -183,25 +248,33 @@ SocketOrServer *SocketPoll::wait( int inTimeoutMS ) {
             if( s->isSocket ) {
                 socketID = s->sock->mNativeSocketID;
                 }
+            else if( s->udp != NULL ) {
+                socketID = s->udp->getNativeSocketID();
+                }
             else {
                 socketID = s->server->mNativeSocketID;
                 }
 
             checkIDList.push_back( socketID );
 
-            FD_SET( socketID, &fdr );
+            if( ! ( s->flags & SOCKET_POLL_NO_READ ) ) {
+                FD_SET( socketID, &fdr );
+                }
+
+            if( s->flags & SOCKET_POLL_WRITE ) {
+                FD_SET( socketID, &fdw );
+                }
             
             if( socketID > maxSocketID ) {
                 maxSocketID = socketID;
                 }
 
             mNextSocketOrServer++;
+            numLeft--;
 
-            if( mNextSocketOrServer != endPoint ) {    
-                // wrap around
-                if( mNextSocketOrServer >= mWatchedList.size() ) {
-                    mNextSocketOrServer = 0;
-                    }
+            // wrap around
+            if( mNextSocketOrServer >= mWatchedList.size() ) {
+                mNextSocketOrServer = 0;
                 }
             
             }
@@ -211,7 +284,7 @@ SocketOrServer *SocketPoll::wait( int inTimeoutMS ) {
         
         struct timeval *tvPointer = NULL;
         
-        if( mNextSocketOrServer == endPoint ) {
+        if( numLeft == 0 ) {
 
             if( inTimeoutMS != -1 ) {
                 
@@ -253,7 +326,7 @@ SocketOrServer *SocketPoll::wait( int inTimeoutMS ) {
             }
         
 
-        int ret = select( maxSocketID + 1, &fdr, NULL, NULL, tvPointer );
+        int ret = select( maxSocketID + 1, &fdr, &fdw, NULL, tvPointer );
 
         if( ret > 0 ) {
             
@@ -263,9 +336,18 @@ SocketOrServer *SocketPoll::wait( int inTimeoutMS ) {
             
             for( int i=0; i<numChecked; i++ ) {
                 
-                if( FD_ISSET( checkIDList.getElementDirect( i ), &fdr ) ) {
+                int socketID = checkIDList.getElementDirect( i );
+
+                char readReady = ( FD_ISSET( socketID, &fdr ) != 0 );
+                char writeReady = ( FD_ISSET( socketID, &fdw ) != 0 );
+                
+                if( readReady || writeReady ) {
+                    SocketOrServer *s = checkList.getElementDirect( i );
                     
-                    mReadyList.push_back( checkList.getElementDirect( i ) );
+                    s->readReady = readReady;
+                    s->writeReady = writeReady;
+
+                    mReadyList.push_back( s );
                     }
                 }
 
@@ -294,3 +376,37 @@ SocketOrServer *SocketPoll::wait( int inTimeoutMS ) {
     return NULL;
     }
 
+
+
+int SocketPoll::wait( SocketOrServer **outReady, int inMax, 
+                      int inTimeoutMS ) {
+    if( inMax <= 0 ) {
+        return 0;
+        }
+
+    // first one may block, and leaves the rest of its batch queued
+    SocketOrServer *first = wait( inTimeoutMS );
+    
+    if( first == NULL ) {
+        return 0;
+        }
+    
+    outReady[0] = first;
+    
+    int numReady = 1;
+    
+    int numQueued = mReadyList.size();
+    
+    if( numQueued > inMax - numReady ) {
+        numQueued = inMax - numReady;
+        }
+    
+    for( int i=0; i<numQueued; i++ ) {
+        outReady[ numReady ] = mReadyList.getElementDirect( i );
+        numReady++;
+        }
+
+    mReadyList.deleteStartElements( numQueued );
+
+    return numReady;
+    }
@@ -10,6 +10,9 @@
  *
  * 2004-December-7   Jason Rohrer
  * Fixed a bug in the evaluation of wait return codes.
+ *
+ * 2026-October-14   Jason Rohrer
+ * Added batch send and receive, using sendmmsg and recvmmsg on Linux.
  */
 
 
@@ -58,6 +61,16 @@
 #endif
 
 
+#if defined( __linux__ ) && defined( MSG_WAITFORONE )
+    // sendmmsg and recvmmsg available (glibc 2.14 and later)
+    #define USE_MMSG
+#endif
+
+
+// packets handled per system call by batch functions
+#define UDP_BATCH_SIZE 64
+
+
 
 
 // prototypes
@@ -245,6 +258,224 @@ int SocketUDP::receive( struct UDPAddress **outAddress,
     }
 
 
+static void packAddress( struct UDPAddress *inAddress,
+                         struct sockaddr_in *outAddress ) {
+    memset( outAddress, 0, sizeof( struct sockaddr_in ) );
+
+    outAddress->sin_family = AF_INET;
+    outAddress->sin_port = inAddress->mPort;
+    outAddress->sin_addr.s_addr = inAddress->mIPAddress;
+    }
+
+
+
+static void unpackAddress( struct sockaddr_in *inAddress,
+                           struct UDPAddress *outAddress ) {
+    outAddress->mPort = inAddress->sin_port;
+    outAddress->mIPAddress = inAddress->sin_addr.s_addr;
+    }
+
+
+
+int SocketUDP::sendBatch( struct UDPPacket *inPackets, int inNumPackets ) {
+
+    // unwrap our native object
+    int *socketIDArray = (int *)( mNativeObjectPointer );
+	int socketID = socketIDArray[0];
+
+    int numSent = 0;
+
+#ifdef USE_MMSG
+
+    struct mmsghdr messages[ UDP_BATCH_SIZE ];
+    struct iovec vectors[ UDP_BATCH_SIZE ];
+    struct sockaddr_in addresses[ UDP_BATCH_SIZE ];
+
+    while( numSent < inNumPackets ) {
+        int batchSize = inNumPackets - numSent;
+
+        if( batchSize > UDP_BATCH_SIZE ) {
+            batchSize = UDP_BATCH_SIZE;
+            }
+
+        memset( messages, 0, batchSize * sizeof( struct mmsghdr ) );
+
+        for( int i=0; i<batchSize; i++ ) {
+            struct UDPPacket *p = &( inPackets[ numSent + i ] );
+
+            packAddress( &( p->mAddress ), &( addresses[i] ) );
+
+            vectors[i].iov_base = (void *)( p->mData );
+            vectors[i].iov_len = p->mLength;
+
+            messages[i].msg_hdr.msg_name = (void *)&( addresses[i] );
+            messages[i].msg_hdr.msg_namelen = sizeof( struct sockaddr_in );
+            messages[i].msg_hdr.msg_iov = &( vectors[i] );
+            messages[i].msg_hdr.msg_iovlen = 1;
+            }
+
+        int result = sendmmsg( socketID, messages, batchSize, 0 );
+
+        if( result <= 0 ) {
+            break;
+            }
+
+        numSent += result;
+
+        if( result < batchSize ) {
+            // send buffer full, or error on next packet
+            break;
+            }
+        }
+
+#else
+
+    for( ; numSent < inNumPackets; numSent++ ) {
+        struct UDPPacket *p = &( inPackets[ numSent ] );
+
+        struct sockaddr_in toAddress;
+        packAddress( &( p->mAddress ), &toAddress );
+
+        int result = sendto( socketID, (char *)( p->mData ), p->mLength, 0,
+                             (struct sockaddr *)( &toAddress ),
+                             sizeof( toAddress ) );
+        if( result < 0 ) {
+            break;
+            }
+        }
+
+#endif
+
+    if( numSent == 0 && inNumPackets > 0 ) {
+        return -1;
+        }
+
+    return numSent;
+    }
+
+
+
+int SocketUDP::receiveBatch( struct UDPPacket *inPackets, int inMaxPackets,
+                             long inTimeout ) {
+
+    // unwrap our native object
+    int *socketIDArray = (int *)( mNativeObjectPointer );
+	int socketID = socketIDArray[0];
+
+
+    if( inMaxPackets <= 0 ) {
+        return 0;
+        }
+
+    if( inTimeout != -1 ) {
+        int waitValue = waitForIncomingData( socketID, inTimeout );
+
+        // timed out or saw an error while waiting
+        if( waitValue == -1 || waitValue == -2 ) {
+            return waitValue;
+            }
+
+        // else we have data waiting
+        }
+
+
+    int numReceived = 0;
+
+#ifdef USE_MMSG
+
+    struct mmsghdr messages[ UDP_BATCH_SIZE ];
+    struct iovec vectors[ UDP_BATCH_SIZE ];
+    struct sockaddr_in addresses[ UDP_BATCH_SIZE ];
+
+    // block for first packet only (in case of infinite timeout),
+    // then take only what's already waiting
+    int flags = MSG_WAITFORONE;
+
+    while( numReceived < inMaxPackets ) {
+        int batchSize = inMaxPackets - numReceived;
+
+        if( batchSize > UDP_BATCH_SIZE ) {
+            batchSize = UDP_BATCH_SIZE;
+            }
+
+        memset( messages, 0, batchSize * sizeof( struct mmsghdr ) );
+
+        for( int i=0; i<batchSize; i++ ) {
+            struct UDPPacket *p = &( inPackets[ numReceived + i ] );
+
+            vectors[i].iov_base = (void *)( p->mData );
+            vectors[i].iov_len = p->mCapacity;
+
+            messages[i].msg_hdr.msg_name = (void *)&( addresses[i] );
+            messages[i].msg_hdr.msg_namelen = sizeof( struct sockaddr_in );
+            messages[i].msg_hdr.msg_iov = &( vectors[i] );
+            messages[i].msg_hdr.msg_iovlen = 1;
+            }
+
+        int result = recvmmsg( socketID, messages, batchSize, flags, NULL );
+
+        if( result <= 0 ) {
+            break;
+            }
+
+        for( int i=0; i<result; i++ ) {
+            struct UDPPacket *p = &( inPackets[ numReceived + i ] );
+
+            p->mLength = messages[i].msg_len;
+            unpackAddress( &( addresses[i] ), &( p->mAddress ) );
+            }
+
+        numReceived += result;
+
+        if( result < batchSize ) {
+            // no more waiting
+            break;
+            }
+
+        flags = MSG_DONTWAIT;
+        }
+
+#else
+
+    while( numReceived < inMaxPackets ) {
+
+        if( numReceived > 0 &&
+            waitForIncomingData( socketID, 0 ) != 1 ) {
+            // no more waiting
+            break;
+            }
+
+        struct UDPPacket *p = &( inPackets[ numReceived ] );
+
+        struct sockaddr_in fromAddress;
+        socklen_t fromAddressLength = sizeof( fromAddress );
+
+        int result = recvfrom( socketID, (char *)( p->mData ),
+                               p->mCapacity, 0,
+                               (struct sockaddr *)( &fromAddress ),
+                               &fromAddressLength );
+
+        if( result < 0 ) {
+            break;
+            }
+
+        p->mLength = result;
+        unpackAddress( &fromAddress, &( p->mAddress ) );
+
+        numReceived++;
+        }
+
+#endif
+
+    if( numReceived == 0 ) {
+        return -1;
+        }
+
+    return numReceived;
+    }
+
+
+
 /* socket timing code adapted from gnut, by Josh Pieper */
 /* Josh Pieper, (c) 2000 */
 /* This file is distributed under the GPL, see file COPYING for details */
@@ -12,6 +12,10 @@
  *
  * 2010-May-14    Jason Rohrer
  * String parameters as const to fix warnings.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Non-blocking versions that run on background threads.
+ * Gateway remembered across runs so discovery can be skipped.
  */
 
 
@@ -27,91 +31,291 @@
 
 
 #include "minorGems/util/stringUtils.h"
+#include "minorGems/util/SimpleVector.h"
+#include "minorGems/util/SettingsManager.h"
 #include "minorGems/util/log/AppLog.h"
+#include "minorGems/system/Thread.h"
+#include "minorGems/system/MutexLock.h"
+#include "minorGems/system/Time.h"
+
+
+
+// root description URL of gateway found during this run, or NULL
+static char *gatewayURL = NULL;
+
+// held while finding a gateway, so that jobs started together share one
+// discovery
+static MutexLock gatewayLock;
+
+// Time::getMonotonicTime of when last discovery finished, or -1
+static double lastDiscoveryTime = -1;
+
 
 
-static int getIGDURL( int inTimeoutMS, 
-                      struct UPNPUrls *urls,
-                      struct IGDdatas *data,
-                      char *lanIPAddr,
-                      int lanIPLength ) {
+// fetches a gateway's description and checks that it answers as a
+// connected IGD
+// returns true on success, in which case urls must be freed by caller
+static char tryGateway( const char *inURL,
+                        struct UPNPUrls *urls,
+                        struct IGDdatas *data,
+                        char *lanIPAddr,
+                        int lanIPLength,
+                        char *outExternalIP ) {
+    
+    if( ! UPNP_GetIGDFromUrl( inURL, urls, data, 
+                              lanIPAddr, lanIPLength ) ) {
+        return false;
+        }
+    
+    // devices that aren't IGDs have no connection service
+    if( urls->controlURL != NULL && data->servicetype[0] != '\0' ) {
+        
+        int result = UPNP_GetExternalIPAddress( urls->controlURL,
+                                                data->servicetype,
+                                                outExternalIP );
+        
+        if( result == UPNPCOMMAND_SUCCESS &&
+            outExternalIP[0] != '\0' ) {
+            return true;
+            }
+        }
+    
+    FreeUPNPUrls( urls );
+    return false;
+    }
+
+
+
+// finds a connected gateway, trying remembered ones before discovery
+// inSavedURL is from settings, or NULL
+// inStartTime is Time::getMonotonicTime from when caller started
+// (a discovery finished since then is trusted, even if it failed)
+// *outURL set to newly allocated URL of gateway found, or NULL on failure
+// returns true on success, in which case urls must be freed by caller
+static char getIGDURL( int inTimeoutMS,
+                       const char *inSavedURL,
+                       double inStartTime,
+                       struct UPNPUrls *urls,
+                       struct IGDdatas *data,
+                       char *lanIPAddr,
+                       int lanIPLength,
+                       char *outExternalIP,
+                       char **outURL ) {
+
+    *outURL = NULL;
+    
+    gatewayLock.lock();
+
+    const char *rememberedURL = gatewayURL;
+    
+    if( rememberedURL == NULL ) {
+        rememberedURL = inSavedURL;
+        }
+    
+    if( rememberedURL != NULL ) {
+        AppLog::info( "Trying remembered UPNP Gateway\n" );
+        
+        if( tryGateway( rememberedURL, urls, data, lanIPAddr, lanIPLength,
+                        outExternalIP ) ) {
+            
+            *outURL = stringDuplicate( rememberedURL );
+            
+            if( gatewayURL == NULL ) {
+                gatewayURL = stringDuplicate( rememberedURL );
+                }
+            
+            gatewayLock.unlock();
+            return true;
+            }
+        
+        AppLog::info( "Remembered UPNP Gateway not found\n" );
+        }
+    
+    if( lastDiscoveryTime >= inStartTime ) {
+        // another job discovered while this one waited
+        AppLog::error( "No connected UPNP Gateway Device found\n" );
+        gatewayLock.unlock();
+        return false;
+        }
+    
 
     AppLog::info( "Trying to do UPNP discover\n" );
     struct UPNPDev *devList = upnpDiscover( inTimeoutMS, NULL, NULL, 0 );
 
     if( devList == NULL ) {
         AppLog::error( "UPNP discovery failed\n" );
-        return -1;
+        lastDiscoveryTime = Time::getMonotonicTime();
+        gatewayLock.unlock();
+        return false;
         }    
 
     AppLog::info( "Checking UPNP dev list for a Gateway\n" );
     
-    int result = 
-        UPNP_GetValidIGD( devList, urls, data, 
-                          lanIPAddr, lanIPLength );
+    for( struct UPNPDev *dev = devList; dev != NULL; dev = dev->pNext ) {
+        
+        if( tryGateway( dev->descURL, urls, data, lanIPAddr, lanIPLength,
+                        outExternalIP ) ) {
+            
+            *outURL = stringDuplicate( dev->descURL );
+            break;
+            }
+        }
 
     freeUPNPDevlist( devList );
+    
+    lastDiscoveryTime = Time::getMonotonicTime();
+    
+    
+    if( gatewayURL != NULL ) {
+        delete [] gatewayURL;
+        gatewayURL = NULL;
+        }
+    
+    if( *outURL == NULL ) {
+        AppLog::error( "No connected UPNP Gateway Device found\n" );
+        gatewayLock.unlock();
+        return false;
+        }
+    
+    gatewayURL = stringDuplicate( *outURL );
+
+    gatewayLock.unlock();
+    return true;
+    }
+
+
+
+static const char *gatewaySettingName = "upnpGatewayURL";
+
+
+
+class PortMappingJob : public Thread {
+    public:
+        
+        // inDescription NULL to unmap
+        PortMappingJob( int inPort, const char *inDescription,
+                        int inTimeoutMS );
+        
+        ~PortMappingJob();
+        
+        
+        // can be called directly, to block until done
+        void run();
+        
+        
+        // saves gateway found, if it's new
+        // must be called on thread that started job
+        void saveGateway();
         
 
-    if( result != 0 ) {
-        if( result != 1 ) {
-            AppLog::error( "No connected UPNP Gateway Device found\n" );
-            }
+        int mHandle;
+        
+        int mPort;
+        char *mDescription;
+        int mTimeoutMS;
+        
+        char *mSavedURL;
+        double mStartTime;
+
+        // set by run
+        int mResult;
+        char *mExternalIP;
+        char *mFoundURL;
+
+        // true once run is done, protected by jobLock
+        char mDone;
+    };
+
+
+
+static MutexLock jobLock;
+
+static SimpleVector<PortMappingJob *> jobs;
+
+static int nextHandle = 0;
+
+
+
+PortMappingJob::PortMappingJob( int inPort, const char *inDescription,
+                                int inTimeoutMS )
+        : mHandle( -1 ), mPort( inPort ), mDescription( NULL ),
+          mTimeoutMS( inTimeoutMS ),
+          mResult( -1 ), mExternalIP( NULL ), mFoundURL( NULL ),
+          mDone( false ) {
+    
+    if( inDescription != NULL ) {
+        mDescription = stringDuplicate( inDescription );
         }
-    else {
-        AppLog::error( "No UPNP Gateway Device found\n" );
+
+    mStartTime = Time::getMonotonicTime();
+
+    mSavedURL = SettingsManager::getStringSetting( gatewaySettingName );
+    
+    if( mSavedURL != NULL && mSavedURL[0] == '\0' ) {
+        delete [] mSavedURL;
+        mSavedURL = NULL;
         }
+    }
 
-    return result;
+
+
+PortMappingJob::~PortMappingJob() {
+    if( mDescription != NULL ) {
+        delete [] mDescription;
+        }
+    if( mSavedURL != NULL ) {
+        delete [] mSavedURL;
+        }
+    if( mExternalIP != NULL ) {
+        delete [] mExternalIP;
+        }
+    if( mFoundURL != NULL ) {
+        delete [] mFoundURL;
+        }
     }
 
 
 
-int mapPort( int inPort, const char *inDescription,
-             int inTimeoutMS,
-             char **outExternalIP ) {
+void PortMappingJob::saveGateway() {
+    if( mFoundURL != NULL &&
+        ( mSavedURL == NULL || strcmp( mFoundURL, mSavedURL ) != 0 ) ) {
+        
+        SettingsManager::setSetting( gatewaySettingName, mFoundURL );
+        
+        if( mSavedURL != NULL ) {
+            delete [] mSavedURL;
+            }
+        mSavedURL = stringDuplicate( mFoundURL );
+        }
+    }
+
 
-    *outExternalIP = NULL;
-    int returnVal = -1;
 
+void PortMappingJob::run() {
 
     struct UPNPUrls urls;
     struct IGDdatas data;
 
     char lanIPAddr[16];
+    char externalIPAddress[16];
 
-    int result = getIGDURL( inTimeoutMS, 
-                            &urls, &data, 
-                            lanIPAddr, 16 );
-
-    if( result > 0 ) {
+    int returnVal = -1;
+    
+    
+    if( getIGDURL( mTimeoutMS, mSavedURL, mStartTime,
+                   &urls, &data, 
+                   lanIPAddr, 16,
+                   externalIPAddress, &mFoundURL ) ) {
         
-        if( result == 1 ) {
-            
-            
-            char externalIPAddress[16];
-            
-
-            int result = UPNP_GetExternalIPAddress( urls.controlURL,
-                                       data.servicetype,
-                                       externalIPAddress );
-            
-            if( result == UPNPCOMMAND_SUCCESS &&
-                externalIPAddress[0] != '\0' ) {
-                
-                *outExternalIP = stringDuplicate( externalIPAddress );
-                }
-            else {
-                AppLog::error( "GetExternalIPAddress failed.\n" );
-                *outExternalIP = NULL;
-                }
+        char *port = autoSprintf( "%d", mPort );
+        
+        if( mDescription != NULL ) {
+            mExternalIP = stringDuplicate( externalIPAddress );
             
-            char *port = autoSprintf( "%d", inPort );            
-	
-            result = 
+            int result = 
                 UPNP_AddPortMapping( urls.controlURL, data.servicetype,
                                      port, port, lanIPAddr,
-                                     inDescription, "TCP", NULL );
+                                     mDescription, "TCP", NULL );
             if( result != UPNPCOMMAND_SUCCESS ) {
                 
                 AppLog::getLog()->logPrintf( 
@@ -124,39 +328,8 @@ int mapPort( int inPort, const char *inDescription,
                 AppLog::info( "AddPortMapping success\n" ); 
                 returnVal = 1;
                 }
-
-            delete [] port;
             }
-    
-        FreeUPNPUrls( &urls );
-        }
-    
-
-    return returnVal;
-    }
-
-
-
-int unmapPort( int inPort, int inTimeoutMS ) {
-    int returnVal = -1;
-
-    
-    struct UPNPUrls urls;
-    struct IGDdatas data;
-
-    char lanIPAddr[16];
-    
-    int result = getIGDURL( inTimeoutMS, 
-                            &urls, &data, 
-                            lanIPAddr, 16 );
-    
-    if( result > 0 ) {
-        
-        if( result == 1 ) {
-            
-            
-            char *port = autoSprintf( "%d", inPort );            
-	
+        else {
             int result =
                 UPNP_DeletePortMapping( urls.controlURL, data.servicetype,
                                         port, "TCP", NULL );
@@ -173,14 +346,163 @@ int unmapPort( int inPort, int inTimeoutMS ) {
                 AppLog::info( "DeletePortMapping success\n" );
                 returnVal = 1;
                 }
-
-            delete [] port;
             }
+        
+        delete [] port;
     
         FreeUPNPUrls( &urls );
         }
     
+    
+    jobLock.lock();
+    
+    mResult = returnVal;
+    mDone = true;
+
+    jobLock.unlock();
+    }
+
+
+
+int mapPort( int inPort, const char *inDescription,
+             int inTimeoutMS,
+             char **outExternalIP ) {
+
+    PortMappingJob job( inPort, inDescription, inTimeoutMS );
+    
+    job.run();
+    job.saveGateway();
+    
+    *outExternalIP = job.mExternalIP;
+    job.mExternalIP = NULL;
+
+    return job.mResult;
+    }
+
+
+
+int unmapPort( int inPort, int inTimeoutMS ) {
+    
+    PortMappingJob job( inPort, NULL, inTimeoutMS );
+    
+    job.run();
+    job.saveGateway();
+
+    return job.mResult;
+    }
+
+
+
+static int startJob( PortMappingJob *inJob ) {
+    jobLock.lock();
+    
+    inJob->mHandle = nextHandle;
+    nextHandle++;
+    
+    jobs.push_back( inJob );
+    
+    jobLock.unlock();
+    
+    inJob->start();
+
+    return inJob->mHandle;
+    }
+
+
+
+int startMapPort( int inPort, const char *inDescription,
+                  int inTimeoutMS ) {
+    return startJob( new PortMappingJob( inPort, inDescription, 
+                                         inTimeoutMS ) );
+    }
+
+
+
+int startUnmapPort( int inPort, int inTimeoutMS ) {
+    return startJob( new PortMappingJob( inPort, NULL, inTimeoutMS ) );
+    }
+
+
+
+// must be called with jobLock locked
+static PortMappingJob *findJob( int inHandle ) {
+    for( int i=0; i<jobs.size(); i++ ) {
+        PortMappingJob *job = jobs.getElementDirect( i );
+        
+        if( job->mHandle == inHandle ) {
+            return job;
+            }
+        }
+    return NULL;
+    }
+
+
+
+int stepPortMapping( int inHandle ) {
+    jobLock.lock();
+    
+    PortMappingJob *job = findJob( inHandle );
+    
+    int result = -1;
+    char done = false;
+    
+    if( job != NULL ) {
+        done = job->mDone;
+        
+        if( done ) {
+            result = job->mResult;
+            }
+        else {
+            result = 0;
+            }
+        }
+
+    jobLock.unlock();
+    
+    if( done ) {
+        // done, so job thread no longer touches these
+        job->saveGateway();
+        }
 
-    return returnVal;
+    return result;
     }
 
+
+
+char *getPortMappingExternalIP( int inHandle ) {
+    jobLock.lock();
+    
+    PortMappingJob *job = findJob( inHandle );
+    
+    char *ip = NULL;
+    
+    if( job != NULL && job->mDone && job->mExternalIP != NULL ) {
+        ip = stringDuplicate( job->mExternalIP );
+        }
+
+    jobLock.unlock();
+
+    return ip;
+    }
+
+
+
+void clearPortMapping( int inHandle ) {
+    jobLock.lock();
+    
+    PortMappingJob *job = findJob( inHandle );
+    
+    if( job != NULL ) {
+        jobs.deleteElementEqualTo( job );
+        }
+    
+    jobLock.unlock();
+    
+    if( job != NULL ) {
+        job->join();
+        
+        job->saveGateway();
+        
+        delete job;
+        }
+    }
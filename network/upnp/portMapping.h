@@ -6,6 +6,10 @@
  *
  * 2010-May-14    Jason Rohrer
  * String parameters as const to fix warnings.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Non-blocking versions that run on background threads.
+ * Gateway remembered across runs so discovery can be skipped.
  */
 
 #ifndef PORT_MAPPING_INCLUDED
@@ -13,9 +17,17 @@
 
 
 
+// The gateway found is remembered, both for the rest of this run and in
+// the upnpGatewayURL setting (through SettingsManager) for later runs.
+// If the remembered gateway still answers, discovery is skipped.
+
+
+
 /**
  * Maps a port on a UPNP Gateway Device (discovers it first).
  *
+ * Blocks until done, which can take inTimeoutMS or more.
+ *
  * @param inPort the port to map.
  * @param inDescription the application description to log on the gateway.
  * @param inTimeoutMS timeout to use for UPNP discovery process.
@@ -32,7 +44,7 @@ int mapPort( int inPort, const char *inDescription,
 
 
 /**
- * Maps a port on a UPNP Gateway Device (discovers it first).
+ * Unmaps a port on a UPNP Gateway Device (discovers it first).
  *
  * @param inPort the port to close on the gateway.
  * @param inTimeoutMS timeout to use for UPNP discovery process.
@@ -43,5 +55,40 @@ int unmapPort( int inPort, int inTimeoutMS );
 
 
 
+// Non-blocking versions of the above, each run on its own thread, so
+// several ports can be mapped at once.
+// Settings are only read and written by the calling thread (in start and
+// step calls).
+
+// same parameters as mapPort
+// returns unique int handle for port mapping, always > -1
+int startMapPort( int inPort, const char *inDescription,
+                  int inTimeoutMS );
+
+// same parameters as unmapPort
+// returns unique int handle for port mapping, always > -1
+int startUnmapPort( int inPort, int inTimeoutMS );
+
+
+// checks whether a mapping or unmapping is done, without blocking
+// return 1 if done and successful
+// return -1 if done and failed
+// return 0 if still in progress
+int stepPortMapping( int inHandle );
+
+
+// gets the gateway's external IP, after startMapPort is done (even if the
+// mapping itself failed)
+// returns NULL if not known
+// result destroyed by caller
+char *getPortMappingExternalIP( int inHandle );
+
+
+// frees resources associated with a port mapping
+// if not done, this blocks until it is
+void clearPortMapping( int inHandle );
+
+
+
 
 #endif
@@ -26,6 +26,17 @@
  *
  * 2014-January-13    Jason Rohrer
  * Fixed hexEncode for URLs to work with actual reserved list.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Table-driven encode and decode, with versions that write into caller
+ * buffers.  Decode accepts lowercase hex, and keeps a % that isn't
+ * followed by two hex digits instead of reading past the end.
+ * Single-pass argument parsing into spans.  extractArgument matches
+ * whole names, and old functions allocate only their result.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Encode and decode tables are constant, instead of built on first use,
+ * where a thread building them could race with one already decoding.
  */
 
 
@@ -33,8 +44,6 @@
 #include "URLUtils.h"
 
 #include "minorGems/util/stringUtils.h"
-#include "minorGems/util/SimpleVector.h"
-#include "minorGems/formats/encodingUtils.h"
 
 #include <string.h>
 
@@ -107,252 +116,305 @@ char *URLUtils::getRootRelativePath( char *inURL ) {
 
 
 
-char *URLUtils::urlDecode( char *inString ) {
-
-    // first run through string and replace any + characters with spaces
+static const char *urlHexDigits = "0123456789ABCDEF";
+
+// maps characters to hex digit values, -1 for non-hex characters
+static const signed char urlHexValues[256] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+     0,  1,  2,  3,  4,  5,  6,  7,  8,  9, -1, -1, -1, -1, -1, -1,
+    -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 };
 
-    char *workingString = stringDuplicate( inString );
+/*
+  true for characters that urlEncode leaves alone, the unreserved
+  characters from RFC 3986:
+  
+  A-Z  a-z  0-9  -  _  .  ~
+  
+  Everything else must be percent-encoded, except that, to match
+  application/x-www-form-urlencoded, we encode spaces as '+'
+*/
+static const char urlUnreserved[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 0,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0,
+    0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 1,
+    0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 1, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+
+
+int URLUtils::urlDecodeInto( const char *inString, int inLength,
+                             char *outBuffer ) {
+    const unsigned char *in = (const unsigned char *)inString;
+    
+    int outLength = 0;
+    int i = 0;
     
-    char *plusLocation = strstr( workingString, "+" );
-    while( plusLocation != NULL ) {
-        plusLocation[0] = ' ';
-        plusLocation = strstr( plusLocation, "+" );
+    while( i < inLength ) {
+        unsigned char c = in[i];
+        
+        if( c == '+' ) {
+            // historical web form encoding of space
+            outBuffer[ outLength++ ] = ' ';
+            i++;
+            }
+        else if( c == '%' && i + 2 < inLength &&
+                 urlHexValues[ in[ i + 1 ] ] != -1 &&
+                 urlHexValues[ in[ i + 2 ] ] != -1 ) {
+            
+            outBuffer[ outLength++ ] = 
+                (char)( ( urlHexValues[ in[ i + 1 ] ] << 4 ) |
+                        urlHexValues[ in[ i + 2 ] ] );
+            i += 3;
+            }
+        else {
+            outBuffer[ outLength++ ] = (char)c;
+            i++;
+            }
         }
-
     
-	int stringLength = strlen( workingString );
-
-	char *returnString = new char[ stringLength + 1 ];
-
-	int stringIndex = 0;
-	int returnStringIndex = 0;
-
-	while( stringIndex < stringLength + 1 ) {
-
-		if( workingString[ stringIndex ] != '%' ) {
-			// not a hex representation
-			returnString[ returnStringIndex ] = workingString[ stringIndex ];
-			stringIndex++;
-			returnStringIndex++;
-			}
-		else {
-			// the start of hex
-			char twoChars[2];
-			twoChars[0] = workingString[ stringIndex + 1 ];
-			twoChars[1]= workingString[ stringIndex + 2 ];
-
-			char summedChar = 0;
-
-			for( int i=0; i<2; i++ ) {
-				int shiftAmount = 4 * ( 1 - i );
-				switch( twoChars[i] ) {
-					case '0':
-						summedChar += 0x0 << shiftAmount;
-						break;
-					case '1':
-						summedChar += 0x1 << shiftAmount;
-						break;
-					case '2':
-						summedChar += 0x2 << shiftAmount;
-						break;
-					case '3':
-						summedChar += 0x3 << shiftAmount;
-						break;
-					case '4':
-						summedChar += 0x4 << shiftAmount;
-						break;
-					case '5':
-						summedChar += 0x5 << shiftAmount;
-						break;
-					case '6':
-						summedChar += 0x6 << shiftAmount;
-						break;
-					case '7':
-						summedChar += 0x7 << shiftAmount;
-						break;
-					case '8':
-						summedChar += 0x8 << shiftAmount;
-						break;
-					case '9':
-						summedChar += 0x9 << shiftAmount;
-						break;
-					case 'A':
-						summedChar += 0xA << shiftAmount;
-						break;
-					case 'B':
-						summedChar += 0xB << shiftAmount;
-						break;
-					case 'C':
-						summedChar += 0xC << shiftAmount;
-						break;
-					case 'D':
-						summedChar += 0xD << shiftAmount;
-						break;
-					case 'E':
-						summedChar += 0xE << shiftAmount;
-						break;
-					case 'F':
-						summedChar += 0xF << shiftAmount;
-						break;
-					default:
-						break;
-					}
-
-				}
-
-			returnString[ returnStringIndex ] = summedChar;
-			stringIndex += 3;
-			returnStringIndex++;			
-			}
-		}
-    
-    delete [] workingString;
-
-    // trim the return string
-    workingString = returnString;
-    returnString = stringDuplicate( workingString );
-    delete [] workingString;
-
-    
-	return returnString;
-	}
+    outBuffer[ outLength ] = '\0';
+    
+    return outLength;
+    }
 
 
 
-char *URLUtils::urlEncode( char *inString ) {
+int URLUtils::urlEncodeInto( const char *inString, int inLength,
+                             char *outBuffer, int inBufferSize ) {
+    const unsigned char *in = (const unsigned char *)inString;
     
-    /*
-      Unreserved characters from RFC 3986
-      
-      Everything else must be percent-encoded
-      
-      A  B  C  D  E  F  G  H  I  J  K  L  M  N  O  P  Q  R  S
-      T  U  V  W  X  Y  Z
-      a  b  c  d  e  f  g  h  i  j  k  l  m  n  o  p  q  r  s
-      t  u  v  w  x  y  z
-      0  1  2  3  4  5  6  7  8  9  -  _  .  ~
-      
-      To match application/x-www-form-urlencoded, we also encode ~ and
-      encode spaces as '+'
-    */
-
-
-    SimpleVector<char> *returnStringVector = new SimpleVector<char>();
-
-
-    int stringLength = strlen( inString );
-
-    int i;
-    for( i=0; i<stringLength; i++ ) {
-
-        char c = inString[i];
-
-        if( ( c >= 'A' && c <= 'Z' )
-            ||
-            ( c >= 'a' && c <= 'z' )
-            ||
-            ( c >= '0' && c <= '9' )
-            ||
-            c == '-'
-            ||
-            c == '_'
-            ||
-            c == '~'
-            ||
-            c == '.' ) {
-            // unreserved
-            returnStringVector->push_back( c );
-            }
-        else if( c == ' ' ) {
-            // historical web form encoding of space as +
-            returnStringVector->push_back( '+' );
+    int outLength = 0;
+
+    for( int i=0; i<inLength; i++ ) {
+        unsigned char c = in[i];
+        
+        if( urlUnreserved[c] || c == ' ' ) {
+            if( outLength + 1 >= inBufferSize ) {
+                return -1;
+                }
+            
+            if( c == ' ' ) {
+                outBuffer[ outLength++ ] = '+';
+                }
+            else {
+                outBuffer[ outLength++ ] = (char)c;
+                }
             }
         else {
-            // reserved to be replaced with percent-encoding
-            returnStringVector->push_back( '%' );
-
-            char *hexEncoding = hexEncode( (unsigned char *)( &c ), 1 );
+            // reserved, replaced with percent-encoding
+            if( outLength + 3 >= inBufferSize ) {
+                return -1;
+                }
             
-            returnStringVector->appendElementString( hexEncoding );
-            delete [] hexEncoding;
+            outBuffer[ outLength++ ] = '%';
+            outBuffer[ outLength++ ] = urlHexDigits[ c >> 4 ];
+            outBuffer[ outLength++ ] = urlHexDigits[ c & 0x0F ];
             }
         }
     
+    outBuffer[ outLength ] = '\0';
+    
+    return outLength;
+    }
 
-    int numChars = returnStringVector->size();
-    char *returnString = new char[ numChars + 1 ];
 
-    for( i=0; i<numChars; i++ ) {
-        returnString[i] = *( returnStringVector->getElement( i ) );
-        }
 
-    returnString[ numChars ] = '\0';
+char *URLUtils::urlDecode( char *inString ) {
+    int length = strlen( inString );
+
+    // decoding never lengthens
+    char *returnString = new char[ length + 1 ];
 
-    delete returnStringVector;
+    urlDecodeInto( inString, length, returnString );
 
     return returnString;
     }
 
 
 
-char *URLUtils::extractArgument( char *inHaystack,
-                                 char *inArgName ) {
+char *URLUtils::urlEncode( char *inString ) {
+    int length = strlen( inString );
+
+    // count first, so result is allocated once at its exact size
+    int encodedLength = 0;
 
-    char *argNameWithEquals = new char[ strlen( inArgName ) + 2 ];
+    for( int i=0; i<length; i++ ) {
+        unsigned char c = (unsigned char)( inString[i] );
+        
+        if( urlUnreserved[c] || c == ' ' ) {
+            encodedLength += 1;
+            }
+        else {
+            encodedLength += 3;
+            }
+        }
 
-    sprintf( argNameWithEquals, "%s%s",
-             inArgName, "=" );
+    char *returnString = new char[ encodedLength + 1 ];
 
-    char *haystackCopy = stringDuplicate( inHaystack );
+    urlEncodeInto( inString, length, returnString, encodedLength + 1 );
     
-    char *pointerToArgStart = strstr( haystackCopy, argNameWithEquals );
+    return returnString;
+    }
+
+
+
+// fills outArg with argument starting at *ioPosition, and moves 
+// *ioPosition past it
+// returns false at end of string
+// empty arguments (from && or a trailing &) are skipped
+static char nextArgument( const char **ioPosition, URLArgument *outArg ) {
+    const char *p = *ioPosition;
+
+    while( *p == '&' ) {
+        p++;
+        }
+
+    if( *p == '\0' ) {
+        *ioPosition = p;
+        return false;
+        }
     
-    if( pointerToArgStart == NULL ) {
-        delete [] haystackCopy;
-        delete [] argNameWithEquals;
-        return NULL;
+    outArg->name = p;
+    outArg->value = NULL;
+    outArg->valueLength = 0;
+    
+    while( *p != '&' && *p != '\0' ) {
+        if( *p == '=' && outArg->value == NULL ) {
+            outArg->nameLength = (int)( p - outArg->name );
+            outArg->value = p + 1;
+            }
+        p++;
+        }
+    
+    if( outArg->value == NULL ) {
+        outArg->nameLength = (int)( p - outArg->name );
         }
     else {
-        char *pointerToArgEnd = strstr( pointerToArgStart, "&" );
-        if( pointerToArgEnd != NULL ) {
-            // terminate string at arg end
-            pointerToArgEnd[0] = '\0';
-            }
-        // else entire remainder of string is argument
+        outArg->valueLength = (int)( p - outArg->value );
+        }
+    
+    *ioPosition = p;
+    return true;
+    }
+
 
-        char *pointerToArgValue =
-            &( pointerToArgStart[ strlen( argNameWithEquals ) ] );
 
+// skips through a ? that comes before the first =
+static const char *findArgumentsStart( const char *inQuery ) {
+    for( const char *c = inQuery; *c != '\0' && *c != '='; c++ ) {
+        if( *c == '?' ) {
+            return c + 1;
+            }
+        }
+    return inQuery;
+    }
 
-        // trim string
-        char *returnString = stringDuplicate( pointerToArgValue );
 
-        
-        delete [] argNameWithEquals;
-        delete [] haystackCopy;
-        return returnString;
+
+int URLUtils::parseArguments( const char *inQuery,
+                              URLArgument *outArgs, int inMaxArgs ) {
+    const char *p = findArgumentsStart( inQuery );
+    
+    int numArgs = 0;
+    URLArgument arg;
+    
+    while( nextArgument( &p, &arg ) ) {
+        if( numArgs < inMaxArgs ) {
+            outArgs[ numArgs ] = arg;
+            }
+        numArgs++;
         }
     
+    return numArgs;
     }
 
 
 
-char *URLUtils::extractArgumentRemoveHex( char *inHaystack,
-                                          char *inArgName ) {
-    char *extractedArg = extractArgument( inHaystack, inArgName );
-
-    if( extractedArg != NULL ) {
+char URLUtils::findArgument( const char *inQuery, const char *inArgName,
+                             URLArgument *outArg ) {
+    const char *p = findArgumentsStart( inQuery );
+    
+    int nameLength = strlen( inArgName );
+    
+    while( *p != '\0' ) {
+        // only look at whole argument if name matches, and otherwise
+        // jump to next & (strchr is much faster than stepping through)
+        if( strncmp( p, inArgName, nameLength ) == 0 &&
+            ( p[ nameLength ] == '=' || p[ nameLength ] == '&' ||
+              p[ nameLength ] == '\0' ) ) {
+            
+            return nextArgument( &p, outArg );
+            }
+        
+        p = strchr( p, '&' );
+        
+        if( p == NULL ) {
+            break;
+            }
+        p++;
+        }
+    
+    return false;
+    }
 
-        char *convertedArg = URLUtils::urlDecode( extractedArg );
 
-        delete [] extractedArg;
 
-        return convertedArg;
-        }
-    else {
+char *URLUtils::extractArgument( char *inHaystack,
+                                 char *inArgName ) {
+    URLArgument arg;
+    
+    if( ! findArgument( inHaystack, inArgName, &arg ) || 
+        arg.value == NULL ) {
         return NULL;
         }
+    
+    char *returnString = new char[ arg.valueLength + 1 ];
+    
+    memcpy( returnString, arg.value, arg.valueLength );
+    returnString[ arg.valueLength ] = '\0';
+    
+    return returnString;
     }
 
 
 
+char *URLUtils::extractArgumentRemoveHex( char *inHaystack,
+                                          char *inArgName ) {
+    URLArgument arg;
+    
+    if( ! findArgument( inHaystack, inArgName, &arg ) || 
+        arg.value == NULL ) {
+        return NULL;
+        }
+    
+    // decoding never lengthens
+    char *returnString = new char[ arg.valueLength + 1 ];
+    
+    urlDecodeInto( arg.value, arg.valueLength, returnString );
+    
+    return returnString;
+    }
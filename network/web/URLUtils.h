@@ -12,6 +12,10 @@
  *
  * 2014-January-13    Jason Rohrer
  * Changed url-encoding function names to not conflict with hexEncode/decode.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Added versions of encode and decode that write into caller buffers, and
+ * single-pass argument parsing into spans.
  */
 
 #include "minorGems/common.h"
@@ -22,6 +26,22 @@
 
 
 
+/**
+ * One name=value argument from a query string, as spans of the string
+ * it was parsed from (not \0-terminated, and still url-encoded).
+ *
+ * An argument with no = has a NULL value, of length 0.
+ */
+typedef struct URLArgument {
+        const char *name;
+        int nameLength;
+        
+        const char *value;
+        int valueLength;
+    } URLArgument;
+
+
+
 /**
  * Utilities for handling URLS.
  *
@@ -100,14 +120,71 @@ class URLUtils {
 
 
 
+        /**
+         * Same as urlDecode, but decodes inLength characters into a
+         * caller buffer, which needs room for inLength + 1 characters.
+         *
+         * % not followed by two hex digits is kept as-is.
+         *
+         * @return the length of the decoded string, which is
+         *   \0-terminated in outBuffer.
+         */
+        static int urlDecodeInto( const char *inString, int inLength,
+                                  char *outBuffer );
+
+
+
+        /**
+         * Same as urlEncode, but encodes inLength characters into a
+         * caller buffer of inBufferSize characters.  3 * inLength + 1 is
+         * always enough.
+         *
+         * @return the length of the encoded string, which is
+         *   \0-terminated in outBuffer, or -1 if buffer is too small.
+         */
+        static int urlEncodeInto( const char *inString, int inLength,
+                                  char *outBuffer, int inBufferSize );
+
+
+
+        /**
+         * Splits a query string into arguments in one pass, without
+         * copying.
+         *
+         * Arguments are separated by &.  If a ? comes before the first =,
+         * everything through the ? is skipped, so a full URL or request
+         * path can be passed in.
+         *
+         * @param inQuery the \0-terminated string to parse.
+         * @param outArgs array to fill with arguments, in order.
+         * @param inMaxArgs the size of outArgs.
+         *
+         * @return the number of arguments in inQuery, which can be more
+         *   than inMaxArgs (only the first inMaxArgs are filled in).
+         */
+        static int parseArguments( const char *inQuery,
+                                   URLArgument *outArgs, int inMaxArgs );
+
+
+
+        /**
+         * Finds the first argument with a given name, without copying.
+         *
+         * @return true if found.
+         */
+        static char findArgument( const char *inQuery, 
+                                  const char *inArgName,
+                                  URLArgument *outArg );
+
+
+
         /**
          * Extracts the value from an argument of the form:
          * name=value&   or
          * name=value[string_end]
          *
-         * Note that if name is the suffix of an argument with a longer name
-         * the longer-named argument's value may be returned.  Thus,
-         * argument names should not be suffixes of eachother.
+         * Arguments are found as in parseArguments, and names must match
+         * exactly.
          *
          * All parameters must be destroyed by caller.
          *
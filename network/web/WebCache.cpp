@@ -0,0 +1,408 @@
+#include "WebCache.h"
+
+#include "minorGems/io/file/File.h"
+#include "minorGems/util/stringUtils.h"
+#include "minorGems/crypto/hashes/sha1.h"
+
+#include <stdio.h>
+
+
+
+static const char *indexFileName = "index.txt";
+
+
+
+WebCache::WebCache( const char *inDirPath, int inMaxBytes )
+        : mDirPath( stringDuplicate( inDirPath ) ),
+          mMaxBytes( inMaxBytes ),
+          mTotalBytes( 0 ),
+          mIndexChanged( false ),
+          mEntries( 64 ),
+          mFileUses( 64 ) {
+
+    File dir( NULL, mDirPath );
+
+    if( ! dir.exists() ) {
+        if( ! dir.makeDirectory() ) {
+            printf( "Error:  WebCache failed to make directory %s\n",
+                    mDirPath );
+            }
+        }
+
+    loadIndex();
+    removeUnusedFiles();
+
+    // limit may have shrunk since last run
+    prune();
+    }
+
+
+
+WebCache::~WebCache() {
+    saveIndex();
+
+    for( int i=0; i<mEntries.getNumSlots(); i++ ) {
+        if( mEntries.isSlotFilled( i ) ) {
+            WebCacheEntry *e = *( mEntries.getSlotValue( i ) );
+
+            delete [] e->hash;
+            if( e->eTag != NULL ) {
+                delete [] e->eTag;
+                }
+            delete e;
+            }
+        }
+    mEntries.deleteAll();
+    mFileUses.deleteAll();
+
+    delete [] mDirPath;
+    }
+
+
+
+char *WebCache::getFilePath( const char *inFileName ) {
+    return autoSprintf( "%s/%s", mDirPath, inFileName );
+    }
+
+
+
+void WebCache::loadIndex() {
+    char *indexPath = getFilePath( indexFileName );
+
+    File indexFile( NULL, indexPath );
+
+    delete [] indexPath;
+
+    if( ! indexFile.exists() ) {
+        return;
+        }
+
+    char *contents = indexFile.readFileContents();
+
+    if( contents == NULL ) {
+        return;
+        }
+
+    int numLines;
+    char **lines = split( contents, "\n", &numLines );
+
+    delete [] contents;
+
+    for( int i=0; i<numLines; i++ ) {
+        // lastUseTime expireTime size hash url eTag
+        // eTag is - if none, and is rest of line, because it may
+        // contain spaces
+        double lastUseTime, expireTime;
+        int size;
+        char hash[41];
+        char url[2048];
+        int eTagStart = -1;
+
+        int numRead = sscanf( lines[i], "%lf %lf %d %40s %2047s %n",
+                              &lastUseTime, &expireTime, &size,
+                              hash, url, &eTagStart );
+
+        if( numRead == 5 && eTagStart != -1 &&
+            strlen( hash ) == 40 && size >= 0 &&
+            ! mEntries.contains( url ) ) {
+
+            WebCacheEntry *e = new WebCacheEntry;
+
+            e->hash = stringDuplicate( hash );
+            e->size = size;
+            e->expireTime = expireTime;
+            e->lastUseTime = lastUseTime;
+
+            char *eTag = &( lines[i][ eTagStart ] );
+
+            if( strcmp( eTag, "-" ) == 0 || strlen( eTag ) == 0 ) {
+                e->eTag = NULL;
+                }
+            else {
+                e->eTag = stringDuplicate( eTag );
+                }
+
+            mEntries.insert( url, e );
+            addFileUse( e->hash, e->size );
+            }
+
+        delete [] lines[i];
+        }
+    delete [] lines;
+    }
+
+
+
+void WebCache::saveIndex() {
+    if( ! mIndexChanged ) {
+        return;
+        }
+
+    SimpleVector<char> indexText;
+
+    for( int i=0; i<mEntries.getNumSlots(); i++ ) {
+        if( mEntries.isSlotFilled( i ) ) {
+            WebCacheEntry *e = *( mEntries.getSlotValue( i ) );
+
+            const char *eTag = e->eTag;
+            if( eTag == NULL ) {
+                eTag = "-";
+                }
+
+            char *line = autoSprintf( "%.0f %.0f %d %s %s %s\n",
+                                      e->lastUseTime, e->expireTime,
+                                      e->size, e->hash,
+                                      mEntries.getSlotKey( i ), eTag );
+            indexText.appendElementString( line );
+            delete [] line;
+            }
+        }
+
+    char *text = indexText.getElementString();
+
+    char *indexPath = getFilePath( indexFileName );
+
+    File indexFile( NULL, indexPath );
+
+    if( indexFile.writeToFile( text ) ) {
+        mIndexChanged = false;
+        }
+    else {
+        printf( "Error:  WebCache failed to write index %s\n", indexPath );
+        }
+
+    delete [] indexPath;
+    delete [] text;
+    }
+
+
+
+void WebCache::removeUnusedFiles() {
+    File dir( NULL, mDirPath );
+
+    if( ! dir.exists() || ! dir.isDirectory() ) {
+        return;
+        }
+
+    int numChildren;
+    File **children = dir.getChildFiles( &numChildren );
+
+    for( int i=0; i<numChildren; i++ ) {
+        char *name = children[i]->getFileName();
+
+        if( strcmp( name, indexFileName ) != 0 &&
+            ! mFileUses.contains( name ) ) {
+            // left behind by a run that ended before saving index
+            children[i]->remove();
+            }
+
+        delete [] name;
+        delete children[i];
+        }
+    delete [] children;
+    }
+
+
+
+void WebCache::addFileUse( const char *inHash, int inSize ) {
+    int uses = 0;
+    mFileUses.lookup( inHash, &uses );
+
+    if( uses == 0 ) {
+        mTotalBytes += inSize;
+        }
+
+    mFileUses.insert( inHash, uses + 1 );
+    }
+
+
+
+void WebCache::removeEntry( const char *inURL, WebCacheEntry *inEntry ) {
+    int uses = 0;
+    mFileUses.lookup( inEntry->hash, &uses );
+
+    if( uses <= 1 ) {
+        mFileUses.remove( inEntry->hash );
+        mTotalBytes -= inEntry->size;
+
+        char *path = getFilePath( inEntry->hash );
+        File f( NULL, path );
+        f.remove();
+        delete [] path;
+        }
+    else {
+        mFileUses.insert( inEntry->hash, uses - 1 );
+        }
+
+    delete [] inEntry->hash;
+    if( inEntry->eTag != NULL ) {
+        delete [] inEntry->eTag;
+        }
+    delete inEntry;
+
+    // last, because inURL may be map's own copy of key
+    mEntries.remove( inURL );
+
+    mIndexChanged = true;
+    }
+
+
+
+void WebCache::prune() {
+    while( mTotalBytes > mMaxBytes && mEntries.size() > 0 ) {
+        int oldestSlot = -1;
+        timeSec_t oldestTime = 0;
+
+        for( int i=0; i<mEntries.getNumSlots(); i++ ) {
+            if( mEntries.isSlotFilled( i ) ) {
+                WebCacheEntry *e = *( mEntries.getSlotValue( i ) );
+
+                if( oldestSlot == -1 || e->lastUseTime < oldestTime ) {
+                    oldestSlot = i;
+                    oldestTime = e->lastUseTime;
+                    }
+                }
+            }
+
+        removeEntry( mEntries.getSlotKey( oldestSlot ),
+                     *( mEntries.getSlotValue( oldestSlot ) ) );
+        }
+    }
+
+
+
+char *WebCache::lookup( const char *inURL, char *outFresh,
+                        char **outETag ) {
+    WebCacheEntry *e = NULL;
+
+    if( ! mEntries.lookup( inURL, &e ) ) {
+        return NULL;
+        }
+
+    timeSec_t currentTime = Time::timeSec();
+
+    e->lastUseTime = currentTime;
+    mIndexChanged = true;
+
+    *outFresh = ( currentTime < e->expireTime );
+
+    *outETag = NULL;
+    if( e->eTag != NULL ) {
+        *outETag = stringDuplicate( e->eTag );
+        }
+
+    return getFilePath( e->hash );
+    }
+
+
+
+char WebCache::store( const char *inURL, unsigned char *inBody, int inSize,
+                      const char *inETag, int inMaxAgeSeconds ) {
+
+    WebCacheEntry *e = NULL;
+    mEntries.lookup( inURL, &e );
+
+    if( inSize > mMaxBytes / 4 ) {
+        // too big, but any older body is out of date
+        if( e != NULL ) {
+            removeEntry( inURL, e );
+            saveIndex();
+            }
+        return false;
+        }
+
+    char *hash = computeSHA1Digest( inBody, inSize );
+
+    if( e != NULL && strcmp( e->hash, hash ) == 0 ) {
+        // same body as before
+        delete [] hash;
+        }
+    else {
+        if( e != NULL ) {
+            removeEntry( inURL, e );
+            }
+
+        if( ! mFileUses.contains( hash ) ) {
+            char *path = getFilePath( hash );
+            File f( NULL, path );
+
+            char written = f.writeToFile( inBody, inSize );
+
+            delete [] path;
+
+            if( ! written ) {
+                printf( "Error:  WebCache failed to write body for %s\n",
+                        inURL );
+                delete [] hash;
+                saveIndex();
+                return false;
+                }
+            }
+
+        addFileUse( hash, inSize );
+
+        e = new WebCacheEntry;
+        e->hash = hash;
+        e->size = inSize;
+        e->eTag = NULL;
+
+        mEntries.insert( inURL, e );
+        }
+
+    if( e->eTag != NULL ) {
+        delete [] e->eTag;
+        e->eTag = NULL;
+        }
+    if( inETag != NULL ) {
+        e->eTag = stringDuplicate( inETag );
+        }
+
+    timeSec_t currentTime = Time::timeSec();
+
+    e->expireTime = currentTime + inMaxAgeSeconds;
+    e->lastUseTime = currentTime;
+
+    mIndexChanged = true;
+
+    prune();
+    saveIndex();
+
+    return true;
+    }
+
+
+
+void WebCache::refresh( const char *inURL, int inMaxAgeSeconds ) {
+    WebCacheEntry *e = NULL;
+
+    if( mEntries.lookup( inURL, &e ) ) {
+        timeSec_t currentTime = Time::timeSec();
+
+        e->expireTime = currentTime + inMaxAgeSeconds;
+        e->lastUseTime = currentTime;
+        mIndexChanged = true;
+        }
+    }
+
+
+
+void WebCache::remove( const char *inURL ) {
+    WebCacheEntry *e = NULL;
+
+    if( mEntries.lookup( inURL, &e ) ) {
+        removeEntry( inURL, e );
+        saveIndex();
+        }
+    }
+
+
+
+int WebCache::getNumEntries() {
+    return mEntries.size();
+    }
+
+
+
+int WebCache::getTotalBytes() {
+    return mTotalBytes;
+    }
@@ -0,0 +1,130 @@
+#ifndef WEB_CACHE_INCLUDED
+#define WEB_CACHE_INCLUDED
+
+
+#include "minorGems/util/SimpleVector.h"
+#include "minorGems/util/HashMap.h"
+#include "minorGems/system/Time.h"
+
+
+
+// disk cache of web response bodies, by URL
+//
+// Bodies are stored in one directory, each in a file named by the SHA1 of
+// its contents, so URLs that return the same body share a file.  An index
+// file in the same directory lists each URL with its body's SHA1, ETag,
+// and freshness expiry time.
+//
+// When total body size passes a limit, least recently used URLs are
+// dropped until it fits again.
+//
+// The cache only decides what to keep and where it is.  Callers send
+// requests (with If-None-Match for stale entries that have an ETag),
+// and read cached bodies from the returned file paths.
+//
+// Not thread-safe.
+class WebCache {
+
+
+    public:
+
+        // inDirPath is directory for bodies and index, created if needed
+        // inMaxBytes is limit on total body size
+        WebCache( const char *inDirPath, int inMaxBytes );
+
+
+        // saves index
+        ~WebCache();
+
+
+        // gets path to cached body file for a URL, or NULL if not cached
+        // outFresh set to true if body can be used without checking
+        //   with server
+        // outETag set to ETag to check a stale body with, or NULL if none
+        // path and ETag destroyed by caller
+        // counts as a use of the URL, for pruning
+        char *lookup( const char *inURL, char *outFresh, char **outETag );
+
+
+        // stores a response body for a URL, replacing any older one
+        // inETag can be NULL
+        // inMaxAgeSeconds is how long body stays fresh, 0 to check
+        //   with server on every use
+        // bodies bigger than a quarter of size limit aren't stored
+        // returns true if stored
+        char store( const char *inURL, unsigned char *inBody, int inSize,
+                    const char *inETag, int inMaxAgeSeconds );
+
+
+        // server said (with 304) that cached body for URL is still current
+        void refresh( const char *inURL, int inMaxAgeSeconds );
+
+
+        // drops URL from cache, for example if its file can't be read
+        void remove( const char *inURL );
+
+
+        // writes index file, if anything changed since last save
+        // called by store and by destructor, but not by lookup and
+        // refresh, so a crash only loses use times and expiry updates
+        void saveIndex();
+
+
+        int getNumEntries();
+
+        // total size of body files
+        int getTotalBytes();
+
+
+    protected:
+
+        typedef struct WebCacheEntry {
+                // hex SHA1 of body, which is body file name
+                char *hash;
+
+                int size;
+
+                // NULL if none
+                char *eTag;
+
+                timeSec_t expireTime;
+                timeSec_t lastUseTime;
+            } WebCacheEntry;
+
+
+        char *mDirPath;
+
+        int mMaxBytes;
+
+        int mTotalBytes;
+
+        char mIndexChanged;
+
+        // by URL
+        HashMap<const char*, WebCacheEntry*> mEntries;
+
+        // number of entries using each body file, by hash
+        HashMap<const char*, int> mFileUses;
+
+
+        char *getFilePath( const char *inFileName );
+
+        void loadIndex();
+
+        // deletes body files that no entry uses
+        void removeUnusedFiles();
+
+        // adds a use of an existing body file to counts
+        void addFileUse( const char *inHash, int inSize );
+
+        // removes entry from map and destroys it, deleting its file if no
+        // other entry uses it
+        void removeEntry( const char *inURL, WebCacheEntry *inEntry );
+
+        // drops least recently used entries until within size limit
+        void prune();
+    };
+
+
+
+#endif
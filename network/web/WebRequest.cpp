@@ -7,6 +7,244 @@
 
 #include "minorGems/system/Time.h"
 
+#include <stdlib.h>
+
+
+
+// connections kept open after a complete response, for reuse
+typedef struct IdleConnection {
+        Socket *sock;
+        HostAddress *address;
+        double idleStartTime;
+    } IdleConnection;
+
+
+static SimpleVector<IdleConnection> idleConnections;
+
+static int maxIdlePerHost = 4;
+static int maxIdleTotal = 16;
+
+// servers close idle connections on their own, often after 5-60 seconds
+static double maxIdleSeconds = 30;
+
+
+
+static void closeIdleConnection( int inIndex ) {
+    IdleConnection *c = idleConnections.getElement( inIndex );
+    
+    delete c->sock;
+    delete c->address;
+
+    idleConnections.deleteElement( inIndex );
+    }
+
+
+
+static void closeExpiredIdleConnections() {
+    double currentTime = Time::getCurrentTime();
+    
+    for( int i=0; i<idleConnections.size(); i++ ) {
+        IdleConnection *c = idleConnections.getElement( i );
+
+        if( currentTime - c->idleStartTime > maxIdleSeconds ) {
+            closeIdleConnection( i );
+            i--;
+            }
+        }
+    }
+
+
+
+static char isSameHost( HostAddress *inA, HostAddress *inB ) {
+    return ( inA->mPort == inB->mPort &&
+             strcmp( inA->mAddressString, inB->mAddressString ) == 0 );
+    }
+
+
+
+// returns NULL if none open to inAddress
+static Socket *takeIdleConnection( HostAddress *inAddress ) {
+    closeExpiredIdleConnections();
+
+    // most recently used is least likely to have been closed by server
+    for( int i=idleConnections.size() - 1; i>=0; i-- ) {
+        IdleConnection *c = idleConnections.getElement( i );
+
+        if( ! isSameHost( c->address, inAddress ) ) {
+            continue;
+            }
+
+        Socket *sock = c->sock;
+        
+        // anything readable on an idle connection means server closed it
+        // (or sent junk), either way it's unusable
+        unsigned char probe;
+
+        if( sock->receive( &probe, 1, 0 ) != -2 ) {
+            closeIdleConnection( i );
+            continue;
+            }
+
+        delete c->address;
+        idleConnections.deleteElement( i );
+
+        return sock;
+        }
+
+    return NULL;
+    }
+
+
+
+static void returnIdleConnection( Socket *inSock, HostAddress *inAddress ) {
+    if( maxIdlePerHost <= 0 || maxIdleTotal <= 0 ) {
+        delete inSock;
+        return;
+        }
+
+    closeExpiredIdleConnections();
+
+    int hostCount = 0;
+    int oldestForHost = -1;
+    
+    for( int i=0; i<idleConnections.size(); i++ ) {
+        IdleConnection *c = idleConnections.getElement( i );
+
+        if( isSameHost( c->address, inAddress ) ) {
+            if( oldestForHost == -1 ) {
+                oldestForHost = i;
+                }
+            hostCount++;
+            }
+        }
+
+    if( hostCount >= maxIdlePerHost ) {
+        closeIdleConnection( oldestForHost );
+        }
+
+    if( idleConnections.size() >= maxIdleTotal ) {
+        closeIdleConnection( 0 );
+        }
+    
+    IdleConnection c = { inSock, inAddress->copy(), Time::getCurrentTime() };
+    
+    idleConnections.push_back( c );
+    }
+
+
+
+void WebRequest::setIdleConnectionLimits( int inMaxPerHost, int inMaxTotal,
+                                          double inIdleSeconds ) {
+    maxIdlePerHost = inMaxPerHost;
+    maxIdleTotal = inMaxTotal;
+    maxIdleSeconds = inIdleSeconds;
+
+    // enforce new limits on what's already open
+    while( idleConnections.size() > 0 &&
+           ( idleConnections.size() > maxIdleTotal ||
+             maxIdlePerHost <= 0 ) ) {
+        closeIdleConnection( 0 );
+        }
+    
+    closeExpiredIdleConnections();
+    }
+
+
+
+void WebRequest::closeIdleConnections() {
+    while( idleConnections.size() > 0 ) {
+        closeIdleConnection( 0 );
+        }
+    }
+
+
+
+// times of recent completed requests, in a ring
+#define NUM_LATENCY_SAMPLES 256
+
+static double latencySamples[ NUM_LATENCY_SAMPLES ];
+static int numLatencySamples = 0;
+static int nextLatencySample = 0;
+
+static int numReusedConnections = 0;
+static int numNewConnections = 0;
+
+
+static void recordLatency( double inSeconds, char inReusedConnection ) {
+    latencySamples[ nextLatencySample ] = inSeconds;
+    
+    nextLatencySample = ( nextLatencySample + 1 ) % NUM_LATENCY_SAMPLES;
+    
+    if( numLatencySamples < NUM_LATENCY_SAMPLES ) {
+        numLatencySamples++;
+        }
+
+    if( inReusedConnection ) {
+        numReusedConnections++;
+        }
+    else {
+        numNewConnections++;
+        }
+    }
+
+
+
+static int compareDoubles( const void *inA, const void *inB ) {
+    double a = *( (double *)inA );
+    double b = *( (double *)inB );
+
+    if( a < b ) {
+        return -1;
+        }
+    if( a > b ) {
+        return 1;
+        }
+    return 0;
+    }
+
+
+
+double WebRequest::getLatencyPercentile( double inFraction ) {
+    if( numLatencySamples == 0 ) {
+        return -1;
+        }
+
+    double sorted[ NUM_LATENCY_SAMPLES ];
+    memcpy( sorted, latencySamples, numLatencySamples * sizeof( double ) );
+
+    qsort( sorted, numLatencySamples, sizeof( double ), compareDoubles );
+
+    int index = (int)( inFraction * ( numLatencySamples - 1 ) + 0.5 );
+
+    if( index < 0 ) {
+        index = 0;
+        }
+    if( index >= numLatencySamples ) {
+        index = numLatencySamples - 1;
+        }
+
+    return sorted[ index ];
+    }
+
+
+
+void WebRequest::getConnectionCounts( int *outReused, int *outNew ) {
+    *outReused = numReusedConnections;
+    *outNew = numNewConnections;
+    }
+
+
+
+void WebRequest::clearLatencyStats() {
+    numLatencySamples = 0;
+    nextLatencySample = 0;
+    numReusedConnections = 0;
+    numNewConnections = 0;
+    }
+
+
+
+
 
 
 WebRequest::WebRequest( const char *inMethod, const char *inURL,
@@ -15,7 +253,17 @@ WebRequest::WebRequest( const char *inMethod, const char *inURL,
         : mError( false ), mURL( stringDuplicate( inURL ) ),
           mRequest( NULL ), mRequestPosition( -1 ),
           mResultReady( false ), mResult( NULL ),
-          mSock( NULL ), mRequestStartTime( Time::getCurrentTime() ),
+          mSock( NULL ),
+          mCanReuseConnection( false ), mReusedConnection( false ),
+          mNoResponseBody( false ), mConnectionClosed( false ),
+          mHeaderLength( -1 ), mHeaderSearchPosition( 0 ),
+          mStatusCode( 0 ), mContentLength( -1 ),
+          mChunked( false ), mKeepAlive( false ),
+          mChunkParsePosition( 0 ), mChunkRemaining( -1 ),
+          mSink( NULL ), mNumBytesReceived( 0 ), mNumBodyBytesStreamed( 0 ),
+          mRangeRequested( false ),
+          mETag( NULL ), mCacheMaxAge( -1 ), mNoStore( false ),
+          mRequestStartTime( Time::getCurrentTime() ),
           mRequestTimeoutSeconds( inTimeoutSeconds ) {
         
     
@@ -108,12 +356,18 @@ WebRequest::WebRequest( const char *inMethod, const char *inURL,
 
 
 
-    mLookupThread = NULL;
+    if( strcmp( inMethod, "GET" ) == 0 ||
+        strcmp( inMethod, "HEAD" ) == 0 ) {
+        mCanReuseConnection = true;
+        }
     
+    if( strcmp( inMethod, "HEAD" ) == 0 ) {
+        mNoResponseBody = true;
+        }
+
 
-    
     // launch right into name lookup
-    mLookupThread = new LookupThread( mSuppliedAddress );
+    mLookupRequest = HostLookupPool::submit( mSuppliedAddress );
     
 
     mSock = NULL;
@@ -125,10 +379,18 @@ WebRequest::WebRequest( const char *inMethod, const char *inURL,
     tempStream.writeString( inMethod );
     tempStream.writeString( " " );
     tempStream.writeString( getPath );
-    tempStream.writeString( " HTTP/1.0\r\n" );
+    tempStream.writeString( " HTTP/1.1\r\n" );
     tempStream.writeString( "Host: " );
     tempStream.writeString( requestHostNameCopy );
     tempStream.writeString( "\r\n" );
+
+    if( maxIdlePerHost > 0 ) {
+        // 1.1 default, but some proxies want to see it
+        tempStream.writeString( "Connection: keep-alive\r\n" );
+        }
+    else {
+        tempStream.writeString( "Connection: close\r\n" );
+        }
         
     if( inBody != NULL ) {
         char *lengthString = autoSprintf( "Content-Length: %d\r\n",
@@ -160,10 +422,8 @@ WebRequest::WebRequest( const char *inMethod, const char *inURL,
 WebRequest::~WebRequest() {
 
 
-    if( mLookupThread != NULL ) {    
-        // this might block
-        delete mLookupThread;
-        }
+    // doesn't block, even if lookup still pending
+    mLookupRequest->release();
     
     delete mSuppliedAddress;
     
@@ -186,6 +446,10 @@ WebRequest::~WebRequest() {
     if( mResult != NULL ) {
         delete [] mResult;
         }
+
+    if( mETag != NULL ) {
+        delete [] mETag;
+        }
     }
 
 
@@ -195,6 +459,10 @@ int WebRequest::step() {
         return -1;
         }
 
+    if( mResultReady ) {
+        return 1;
+        }
+
     if( mRequestTimeoutSeconds != -1 &&
         Time::getCurrentTime() - mRequestStartTime >= mRequestTimeoutSeconds ) {
         // timed out
@@ -211,26 +479,33 @@ int WebRequest::step() {
     if( mSock == NULL ) {
         
 
-        // we know mLookupThread is not NULL if we get here
-        if( mLookupThread->isLookupDone() ) {
+        if( mLookupRequest->isLookupDone() ) {
         
 
             mError = true;
 
-            mNumericalAddress = mLookupThread->getResult();
+            if( mNumericalAddress == NULL ) {
+                mNumericalAddress = mLookupRequest->getResult();
+                }
             
 
             if( mNumericalAddress != NULL ) {
                 
+                if( mCanReuseConnection ) {
+                    mSock = takeIdleConnection( mNumericalAddress );
+                    }
 
-    
-                // use timeout of 0 for non-blocking
-                // will be set to true if we time out while connecting
-                char timedOut;
+                mReusedConnection = ( mSock != NULL );
+
+                if( mSock == NULL ) {
+                    // use timeout of 0 for non-blocking
+                    // will be set to true if we time out while connecting
+                    char timedOut;
                 
-                mSock = SocketClient::connectToServer( mNumericalAddress,
-                                                       0,
-                                                       &timedOut );
+                    mSock = SocketClient::connectToServer( mNumericalAddress,
+                                                           0,
+                                                           &timedOut );
+                    }
                 
                 if( mSock != NULL ) {
                     
@@ -293,6 +568,13 @@ int WebRequest::step() {
                                        // non-blocking
                                        false );
             if( numSent == -1 ) {
+
+                if( mReusedConnection && mRequestPosition == 0 ) {
+                    // pooled connection was closed by server while idle
+                    retryOnNewConnection();
+                    return 0;
+                    }
+
                 mError = true;
                 
                 printf( "Error:  "
@@ -314,9 +596,6 @@ int WebRequest::step() {
             // in practice, it's never ready that fast
             return 0;
             }
-        else if( mResultReady ) {
-            return 1;
-            }
         else {
             
             // done sending request
@@ -330,13 +609,24 @@ int WebRequest::step() {
             // keep reading as long as we get full buffers
             int numRead = bufferLength;
             
+            int parseResult = 0;
+            
             while( numRead > 0 ) {
                 
                 numRead = mSock->receive( buffer, bufferLength, 0 );
                 
                 if( numRead > 0 ) {
-                    for( int i=0; i<numRead; i++ ) {
-                        mResponse.push_back( buffer[i] );
+                    mResponse.push_back( (char *)buffer, numRead );
+                    mNumBytesReceived += numRead;
+
+                    if( mSink != NULL ) {
+                        // pass each piece on right away, so body never
+                        // piles up in mResponse
+                        parseResult = parseAndStream();
+
+                        if( parseResult != 0 ) {
+                            break;
+                            }
                         }
                     }
                 }
@@ -346,92 +636,610 @@ int WebRequest::step() {
             
 
             if( numRead == -1 ) {
-                // connection closed, done done receiving result
+                mConnectionClosed = true;
+                }
 
-                // process it
+
+            if( parseResult == 0 ) {
+                parseResult = parseAndStream();
+                }
+            
+            if( parseResult == -2 ) {
+                mError = true;
                 
+                printf( "Error:  "
+                        "WebRequest response sink failed for URL:  %s\n",
+                        mURL );
+                return -1;
+                }
+
+            if( parseResult == 1 ) {
+                return finishResponse();
+                }
+            else if( parseResult == -1 ) {
+                mError = true;
+
                 char *responseString = mResponse.getElementString();
-                int responseLength = mResponse.size();
                 
-                if( stringLocateIgnoreCase( responseString, "404 Not Found" ) 
-                    != NULL ) {
-                    
-                    mError = true;
-                    delete [] responseString;
+                printf( "Error:  "
+                        "WebRequest got badly formatted response:\n%s\n",
+                        responseString );
+                
+                delete [] responseString;
+                
+                return -1;
+                }
+            
+            if( mConnectionClosed ) {
 
-                    printf( "Error:  "
-                            "WebRequest got 404 Not Found error for URL:  %s",
-                            mURL );
-                    
-                    return -1;
+                if( mReusedConnection && mNumBytesReceived == 0 ) {
+                    // pooled connection was closed by server while idle,
+                    // before request arrived
+                    retryOnNewConnection();
+                    return 0;
+                    }
+                
+                if( mHeaderLength != -1 &&
+                    ! mChunked && mContentLength == -1 ) {
+                    // no length given, so body ends when connection closes
+                    return finishResponse();
                     }
+                
+                mError = true;
+
+                char *responseString = mResponse.getElementString();
+
+                printf( "Error:  "
+                        "WebRequest got badly formatted response:\n%s\n",
+                        responseString );
 
-                const char *contentStartString = "\r\n\r\n";
+                delete [] responseString;
                 
-                char *contentStart = strstr( responseString, 
-                                             contentStartString );
+                return -1;
+                }
+
+            // still receiving response
+            return 0;
+            }
+        }
+
+
+
+    // should never get here
+    // count it as error
+    
+    printf( "Error:  "
+            "WebRequest got out of expected case tree\n" );
+
+    return -1;
+    }
+
+
+
+void WebRequest::retryOnNewConnection() {
+    delete mSock;
+    mSock = NULL;
+
+    // don't take another pooled one, which might be just as stale
+    mCanReuseConnection = false;
+    mReusedConnection = false;
+    
+    mRequestPosition = 0;
+    mConnectionClosed = false;
+    mNumBytesReceived = 0;
+    
+    mResponse.deleteAll();
+    }
+
+
+
+// finds first occurrence of inString in inBuffer at or after inStart,
+// or returns -1
+static int findInBuffer( SimpleVector<char> *inBuffer, int inStart,
+                         const char *inString ) {
+    int stringLength = strlen( inString );
+    
+    int limit = inBuffer->size() - stringLength;
+
+    char *data = inBuffer->getElementFast( 0 );
+    
+    for( int i=inStart; i<=limit; i++ ) {
+        if( memcmp( &( data[i] ), inString, stringLength ) == 0 ) {
+            return i;
+            }
+        }
+
+    return -1;
+    }
+
+
+
+int WebRequest::parseHeader() {
+    int headerEnd = findInBuffer( &mResponse, mHeaderSearchPosition,
+                                  "\r\n\r\n" );
+    
+    if( headerEnd == -1 ) {
+        // resume search where this one left off next time
+        mHeaderSearchPosition = mResponse.size() - 3;
+        
+        if( mHeaderSearchPosition < 0 ) {
+            mHeaderSearchPosition = 0;
+            }
+        return 0;
+        }
+
+    mHeaderLength = headerEnd + 4;
+
+
+    char *headerString = new char[ mHeaderLength + 1 ];
+    memcpy( headerString, mResponse.getElementFast( 0 ), mHeaderLength );
+    headerString[ mHeaderLength ] = '\0';
+
+    char *lowerHeader = stringToLowerCase( headerString );
+
+    
+    int majorVersion, minorVersion;
+    
+    int numRead = sscanf( lowerHeader, "http/%d.%d %d",
+                          &majorVersion, &minorVersion, &mStatusCode );
+
+    if( numRead != 3 ) {
+        delete [] lowerHeader;
+        delete [] headerString;
+        return -1;
+        }
+
+    // 1.1 defaults to keep-alive, 1.0 to close
+    mKeepAlive = ( majorVersion > 1 ||
+                   ( majorVersion == 1 && minorVersion >= 1 ) );
+    
+    
+    delete [] lowerHeader;
+    
+    // split original, because ETag values are case-sensitive
+    int numLines;
+    char **originalLines = split( headerString, "\r\n", &numLines );
+
+    delete [] headerString;
+    
+    // skip status line
+    delete [] originalLines[0];
+
+    for( int i=1; i<numLines; i++ ) {
+        char *originalLine = originalLines[i];
+        char *line = stringToLowerCase( originalLine );
+        
+        if( strstr( line, "content-length:" ) == line ) {
+            sscanf( &( line[ strlen( "content-length:" ) ] ),
+                    "%d", &mContentLength );
+            }
+        else if( strstr( line, "transfer-encoding:" ) == line ) {
+            if( strstr( line, "chunked" ) != NULL ) {
+                mChunked = true;
+                }
+            }
+        else if( strstr( line, "connection:" ) == line ) {
+            if( strstr( line, "close" ) != NULL ) {
+                mKeepAlive = false;
+                }
+            else if( strstr( line, "keep-alive" ) != NULL ) {
+                mKeepAlive = true;
+                }
+            }
+        else if( strstr( line, "cache-control:" ) == line ) {
+            char *maxAge = strstr( line, "max-age=" );
             
-                if( contentStart != NULL ) {
-                    // skip start string
-                    char *content =
-                        &( contentStart[ strlen( contentStartString ) ] );
+            if( maxAge != NULL ) {
+                sscanf( &( maxAge[ strlen( "max-age=" ) ] ),
+                        "%d", &mCacheMaxAge );
+                }
+            if( strstr( line, "no-cache" ) != NULL ) {
+                mCacheMaxAge = 0;
+                }
+            if( strstr( line, "no-store" ) != NULL ) {
+                mNoStore = true;
+                }
+            }
+        else if( strstr( line, "etag:" ) == line ) {
+            if( mETag != NULL ) {
+                delete [] mETag;
+                }
+            mETag = trimWhitespace( 
+                &( originalLine[ strlen( "etag:" ) ] ) );
+            }
+        
+        delete [] line;
+        delete [] originalLine;
+        }
+    delete [] originalLines;
+
 
+    if( mStatusCode == 204 || mStatusCode == 304 ) {
+        mNoResponseBody = true;
+        }
 
-                    // pointer arithmetic:
-                    // ugly, but we don't know that result does not contain
-                    // \0, so we can't use streln to find result length
-                    int resultLength =
-                        responseLength
-                        - strlen( contentStartString )
-                        - (int)( contentStart - responseString );
+    if( mChunked ) {
+        // chunking overrides any length given
+        mContentLength = -1;
+        
+        mChunkParsePosition = mHeaderLength;
+        mChunkRemaining = -1;
+        }
 
-                    mResultSize = resultLength;
-                    
-                    mResult = new char[ resultLength + 1 ];
-                    memcpy( mResult,
-                            content, resultLength );
+    return 1;
+    }
 
-                    mResult[ resultLength ] = '\0';
-                    mResultReady = true;
-                    
-                    delete [] responseString;
+
+
+int WebRequest::parseChunks() {
+    while( true ) {
+        
+        if( mChunkRemaining == -1 ) {
+            // expecting chunk size line
+            
+            int lineEnd = findInBuffer( &mResponse, mChunkParsePosition,
+                                        "\r\n" );
+            if( lineEnd == -1 ) {
+                return 0;
+                }
+
+            // size in hex, possibly followed by ;extensions
+            int lineLength = lineEnd - mChunkParsePosition;
+            
+            char *sizeLine = new char[ lineLength + 1 ];
+            memcpy( sizeLine, mResponse.getElementFast( mChunkParsePosition ),
+                    lineLength );
+            sizeLine[ lineLength ] = '\0';
+
+            unsigned int chunkSize;
+            int numRead = sscanf( sizeLine, "%x", &chunkSize );
+            
+            delete [] sizeLine;
+
+            if( numRead != 1 || chunkSize > 0x7FFFFFFF ) {
+                return -1;
+                }
+
+            if( chunkSize == 0 ) {
+                // last chunk, followed by optional trailer lines and
+                // a blank line
+                
+                int trailerStart = lineEnd + 2;
+                
+                if( mResponse.size() >= trailerStart + 2 &&
+                    memcmp( mResponse.getElementFast( trailerStart ),
+                            "\r\n", 2 ) == 0 ) {
+                    mChunkParsePosition = trailerStart + 2;
                     return 1;
                     }
-                else {
-                    mError = true;
 
-                    printf( "Error:  "
-                            "WebRequest got badly formatted response:\n%s\n",
-                            responseString );
-
-                    delete [] responseString;
-                    
-                    return -1;
+                int trailerEnd = findInBuffer( &mResponse, trailerStart,
+                                               "\r\n\r\n" );
+                if( trailerEnd == -1 ) {
+                    return 0;
                     }
+                
+                mChunkParsePosition = trailerEnd + 4;
+                return 1;
                 }
-            else {
-                // still receiving response
+            
+            mChunkRemaining = (int)chunkSize;
+            mChunkParsePosition = lineEnd + 2;
+            }
+        else if( mChunkRemaining == -2 ) {
+            // expecting line end after chunk data
+            
+            if( mResponse.size() < mChunkParsePosition + 2 ) {
                 return 0;
                 }
+            if( memcmp( mResponse.getElementFast( mChunkParsePosition ),
+                        "\r\n", 2 ) != 0 ) {
+                return -1;
+                }
+            mChunkParsePosition += 2;
+            mChunkRemaining = -1;
+            }
+        else {
+            int numAvailable = mResponse.size() - mChunkParsePosition;
+
+            if( numAvailable == 0 ) {
+                return 0;
+                }
+
+            int numToTake = mChunkRemaining;
+            if( numToTake > numAvailable ) {
+                numToTake = numAvailable;
+                }
             
+            mChunkedBody.push_back( 
+                mResponse.getElementFast( mChunkParsePosition ), numToTake );
+
+            mChunkParsePosition += numToTake;
+            mChunkRemaining -= numToTake;
+
+            if( mChunkRemaining == 0 ) {
+                mChunkRemaining = -2;
+                }
             }
         }
+    }
 
 
 
-    // should never get here
-    // count it as error
+int WebRequest::parseResponse() {
+    if( mHeaderLength == -1 ) {
+        int headerResult = parseHeader();
+        
+        if( headerResult != 1 ) {
+            return headerResult;
+            }
+        }
+
+    if( mNoResponseBody ) {
+        return 1;
+        }
     
-    printf( "Error:  "
-            "WebRequest got out of expected case tree\n" );
+    if( mChunked ) {
+        return parseChunks();
+        }
 
-    return -1;
+    if( mContentLength != -1 ) {
+        if( mNumBodyBytesStreamed + mResponse.size() - mHeaderLength
+            >= mContentLength ) {
+            return 1;
+            }
+        }
+    
+    // else body ends when connection closes
+    return 0;
+    }
+
+
+
+char WebRequest::streamBody() {
+    if( mChunked ) {
+        if( mChunkedBody.size() > 0 ) {
+            if( ! mSink->write( 
+                    (unsigned char *)mChunkedBody.getElementFast( 0 ),
+                    mChunkedBody.size() ) ) {
+                return false;
+                }
+            mNumBodyBytesStreamed += mChunkedBody.size();
+            mChunkedBody.deleteAll();
+            }
+        
+        // drop header and decoded chunks, keep any partial chunk
+        mResponse.deleteStartElements( mChunkParsePosition );
+        mChunkParsePosition = 0;
+        mHeaderLength = 0;
+        return true;
+        }
+
+    if( mNoResponseBody ) {
+        return true;
+        }
+    
+    int numAvailable = mResponse.size() - mHeaderLength;
+
+    if( mContentLength != -1 &&
+        numAvailable > mContentLength - mNumBodyBytesStreamed ) {
+        numAvailable = mContentLength - mNumBodyBytesStreamed;
+        }
+
+    if( numAvailable > 0 ) {
+        if( ! mSink->write( 
+                (unsigned char *)mResponse.getElementFast( mHeaderLength ),
+                numAvailable ) ) {
+            return false;
+            }
+        mNumBodyBytesStreamed += numAvailable;
+        }
+
+    mResponse.deleteStartElements( mHeaderLength + numAvailable );
+    mHeaderLength = 0;
+    
+    return true;
+    }
+
+
+
+int WebRequest::parseAndStream() {
+    int parseResult = parseResponse();
+
+    if( parseResult != -1 &&
+        mSink != NULL && mHeaderLength != -1 &&
+        ! isErrorStatus() ) {
+        
+        if( ! streamBody() ) {
+            return -2;
+            }
+        }
+
+    return parseResult;
+    }
+
+
+
+int WebRequest::finishResponse() {
+    
+    if( mStatusCode == 404 ) {
+        mError = true;
+        
+        printf( "Error:  "
+                "WebRequest got 404 Not Found error for URL:  %s",
+                mURL );
+        
+        return -1;
+        }
+
+    if( isErrorStatus() ) {
+        mError = true;
+        
+        printf( "Error:  "
+                "WebRequest got status %d for range request for URL:  %s",
+                mStatusCode, mURL );
+        
+        return -1;
+        }
+
+    
+    char *content;
+    int resultLength;
+    
+    // end of response in mResponse, where anything unexpected would start
+    int responseEnd;
+
+    if( mSink != NULL ) {
+        // already passed on by streamBody
+        content = NULL;
+        resultLength = 0;
+
+        if( mChunked ) {
+            responseEnd = mChunkParsePosition;
+            }
+        else {
+            responseEnd = mHeaderLength;
+            }
+        }
+    else if( mChunked ) {
+        content = mChunkedBody.getElementFast( 0 );
+        resultLength = mChunkedBody.size();
+        responseEnd = mChunkParsePosition;
+        }
+    else {
+        content = mResponse.getElementFast( mHeaderLength );
+        
+        if( mNoResponseBody ) {
+            resultLength = 0;
+            }
+        else if( mContentLength != -1 ) {
+            resultLength = mContentLength;
+            }
+        else {
+            resultLength = mResponse.size() - mHeaderLength;
+            }
+        
+        responseEnd = mHeaderLength + resultLength;
+        }
+    
+
+    mResultSize = resultLength;
+    
+    mResult = new char[ resultLength + 1 ];
+    
+    if( resultLength > 0 ) {
+        memcpy( mResult, content, resultLength );
+        }
+    
+    mResult[ resultLength ] = '\0';
+    mResultReady = true;
+
+
+    if( mKeepAlive && ! mConnectionClosed &&
+        responseEnd == mResponse.size() ) {
+        
+        returnIdleConnection( mSock, mNumericalAddress );
+        mSock = NULL;
+        }
+
+    recordLatency( Time::getCurrentTime() - mRequestStartTime,
+                   mReusedConnection );
+    
+    return 1;
     }
 
 
 
 int WebRequest::getProgressSize() {
-    return mResponse.size();
+    return mNumBytesReceived;
+    }
+
+
+
+void WebRequest::setResponseSink( WebResponseSink *inSink ) {
+    mSink = inSink;
+    }
+
+
+
+void WebRequest::setRange( int inFirstByte, int inLastByte ) {
+    if( mRequestPosition != 0 ) {
+        return;
+        }
+    
+    char *value = autoSprintf( "bytes=%d-%d", inFirstByte, inLastByte );
+    
+    addHeader( "Range", value );
+    
+    delete [] value;
+    
+    mRangeRequested = true;
+    }
+
+
+
+void WebRequest::addHeader( const char *inName, const char *inValue ) {
+    char *requestLineEnd = strstr( mRequest, "\r\n" );
+    
+    if( requestLineEnd == NULL || mRequestPosition != 0 ) {
+        return;
+        }
+    
+    // insert header right after request line
+    requestLineEnd[0] = '\0';
+    
+    char *newRequest = autoSprintf( "%s\r\n%s: %s\r\n%s",
+                                    mRequest, inName, inValue,
+                                    &( requestLineEnd[2] ) );
+    delete [] mRequest;
+    mRequest = newRequest;
+    }
+
+
+
+int WebRequest::getStatusCode() {
+    if( mHeaderLength == -1 ) {
+        return 0;
+        }
+    return mStatusCode;
+    }
+
+
+
+char *WebRequest::getETag() {
+    if( mETag == NULL ) {
+        return NULL;
+        }
+    return stringDuplicate( mETag );
+    }
+
+
+
+int WebRequest::getCacheMaxAge() {
+    return mCacheMaxAge;
+    }
+
+
+
+char WebRequest::isNoStore() {
+    return mNoStore;
+    }
+
+
+
+char WebRequest::isErrorStatus() {
+    if( mStatusCode == 404 ) {
+        return true;
+        }
+    
+    // 200 means server ignored range and is sending whole body,
+    // which caller can check for with getStatusCode
+    if( mRangeRequested && 
+        mStatusCode != 206 && mStatusCode != 200 ) {
+        return true;
+        }
+    
+    return false;
     }
 
 
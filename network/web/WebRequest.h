@@ -4,11 +4,20 @@
 
 #include "minorGems/network/Socket.h"
 #include "minorGems/network/HostAddress.h"
-#include "minorGems/network/LookupThread.h"
+#include "minorGems/network/HostLookupPool.h"
+#include "minorGems/network/web/WebResponseSink.h"
 
 
 
 // a non-blocking web request
+//
+// Uses HTTP/1.1 keep-alive.  When a response is complete, its connection
+// is kept in a pool of idle connections shared by all WebRequests, and
+// later requests to the same host:port (or proxy) reuse it instead of
+// connecting again.
+//
+// WebRequests and the connection pool are not thread-safe, and should all
+// be used from the same thread.
 class WebRequest {
         
 
@@ -52,8 +61,75 @@ class WebRequest {
 
         // gets the response body as bytes
         unsigned char *getResult( int *outSize );
+
+
+        // streams response body to inSink as it arrives, instead of
+        // saving it for getResult (which then returns an empty result)
+        // must be called before first step
+        // inSink destroyed by caller after this request
+        void setResponseSink( WebResponseSink *inSink );
+
+
+        // asks for only bytes inFirstByte through inLastByte (inclusive)
+        // of the response body, with an HTTP Range header
+        // must be called before first step
+        // a server that doesn't support ranges sends the whole body with
+        // status 200 instead of 206 (see getStatusCode), and any other
+        // status is treated as an error
+        void setRange( int inFirstByte, int inLastByte );
+
+
+        // adds a header line (like "If-None-Match") to the request
+        // must be called before first step
+        void addHeader( const char *inName, const char *inValue );
+
+
+        // HTTP status code of response, or 0 if response header not
+        // received yet
+        int getStatusCode();
+
+
+        // caching information from response header, valid once
+        // getStatusCode is non-zero
+
+        // ETag of response body, or NULL if none
+        // destroyed by caller
+        char *getETag();
         
+        // seconds response can be reused without asking server again,
+        // from Cache-Control max-age (0 for no-cache), or -1 if not given
+        int getCacheMaxAge();
+
+        // true if Cache-Control says not to store response
+        char isNoStore();
+
+
+
+        // limits on connections kept in pool
+        // inMaxPerHost and inMaxTotal default to 4 and 16, 0 disables
+        // keep-alive
+        // idle connections are closed after inIdleSeconds (default 30)
+        static void setIdleConnectionLimits( int inMaxPerHost,
+                                             int inMaxTotal,
+                                             double inIdleSeconds );
         
+        // closes all pooled connections (call at shutdown)
+        static void closeIdleConnections();
+
+        
+        // gets a percentile of time taken, in seconds, from construction to
+        // result ready, over recently completed requests
+        // inFraction in [0,1], for example 0.5 for median, 0.99 for p99
+        // returns -1 if no requests completed yet
+        static double getLatencyPercentile( double inFraction );
+
+        // number of completed requests that reused a pooled connection,
+        // and that needed a new connection
+        static void getConnectionCounts( int *outReused, int *outNew );
+
+        static void clearLatencyStats();
+        
+
 
     protected:
         char mError;
@@ -74,10 +150,81 @@ class WebRequest {
 
         HostAddress *mSuppliedAddress;
         HostAddress *mNumericalAddress;
-        LookupThread *mLookupThread;
+        HostLookupRequest *mLookupRequest;
         
         Socket *mSock;
 
+        // GET and HEAD can be re-sent if a pooled connection turns out
+        // to be closed, so only they take connections from pool
+        char mCanReuseConnection;
+        char mReusedConnection;
+
+        char mNoResponseBody;
+
+        char mConnectionClosed;
+
+
+        // -1 until full response header received
+        int mHeaderLength;
+        int mHeaderSearchPosition;
+
+        int mStatusCode;
+
+        // -1 if not specified
+        int mContentLength;
+
+        char mChunked;
+        char mKeepAlive;
+
+        // position in mResponse of next chunk to decode
+        int mChunkParsePosition;
+
+        // bytes left in current chunk, or -1 if expecting chunk size line,
+        // or -2 if expecting line end after chunk data
+        int mChunkRemaining;
+
+        SimpleVector<char> mChunkedBody;
+
+        WebResponseSink *mSink;
+
+        int mNumBytesReceived;
+        
+        // body bytes passed to mSink and removed from mResponse
+        int mNumBodyBytesStreamed;
+
+        char mRangeRequested;
+
+        // NULL if none
+        char *mETag;
+        int mCacheMaxAge;
+        char mNoStore;
+
+        // true for 404, or unexpected status for range request
+        char isErrorStatus();
+        
+
+        // returns 1 if complete response received, 0 if not yet, or -1 on
+        // badly formatted response
+        int parseResponse();
+
+        int parseHeader();
+
+        int parseChunks();
+
+        // parseResponse followed by streamBody, if streaming
+        // returns -2 if sink fails
+        int parseAndStream();
+
+        // passes body received so far to mSink
+        // returns false if sink fails
+        char streamBody();
+
+        // returns 1 if done, -1 on error
+        int finishResponse();
+
+        // after pooled connection found closed
+        void retryOnNewConnection();
+
         double mRequestStartTime;
         double mRequestTimeoutSeconds;
     };
@@ -0,0 +1,179 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14   Jason Rohrer
+ * Created.
+ */
+
+#include "minorGems/common.h"
+
+
+
+#ifndef WEB_RESPONSE_SINK_INCLUDED
+#define WEB_RESPONSE_SINK_INCLUDED
+
+
+#include <stdio.h>
+
+#include "minorGems/crypto/hashes/sha1.h"
+#include "minorGems/formats/encodingUtils.h"
+#include "minorGems/formats/ZipStream.h"
+#include "minorGems/util/SimpleVector.h"
+
+
+
+/**
+ * Receives a web response body piece by piece as it downloads, so that
+ * a large body never has to be held in memory all at once.
+ *
+ * See WebRequest::setResponseSink.
+ *
+ * @author Jason Rohrer
+ */
+class WebResponseSink {
+
+    public:
+
+        virtual ~WebResponseSink() {
+            }
+
+
+        /**
+         * Takes the next piece of the body.
+         *
+         * @param inData the data, destroyed by caller.
+         * @param inLength the length of inData.
+         *
+         * @return true to continue, or false to fail the request.
+         */
+        virtual char write( const unsigned char *inData, int inLength ) = 0;
+
+    };
+
+
+
+/**
+ * Writes body to an open file.
+ */
+class FileResponseSink : public WebResponseSink {
+
+    public:
+
+        // inFile closed by caller
+        FileResponseSink( FILE *inFile )
+                : mFile( inFile ) {
+            }
+
+
+        virtual char write( const unsigned char *inData, int inLength ) {
+            return ( (int)fwrite( inData, 1, inLength, mFile ) == inLength );
+            }
+
+
+    protected:
+
+        FILE *mFile;
+
+    };
+
+
+
+/**
+ * Computes SHA1 of body.
+ */
+class SHA1ResponseSink : public WebResponseSink {
+
+    public:
+
+        SHA1ResponseSink() {
+            SHA1_Init( &mContext );
+            }
+
+
+        virtual char write( const unsigned char *inData, int inLength ) {
+            SHA1_Update( &mContext, inData, inLength );
+            return true;
+            }
+
+
+        // digest of all data so far, as hex, destroyed by caller
+        // sink must not be written to after this call
+        char *getDigest() {
+            unsigned char digest[ SHA1_DIGEST_LENGTH ];
+
+            SHA1_Final( digest, &mContext );
+
+            return hexEncode( digest, SHA1_DIGEST_LENGTH );
+            }
+
+
+    protected:
+
+        SHA_CTX mContext;
+
+    };
+
+
+
+/**
+ * Decompresses a zlib body and passes it on to another sink.
+ */
+class ZipResponseSink : public WebResponseSink {
+
+    public:
+
+        /**
+         * @param inDestination where decompressed data goes, destroyed
+         *   by caller after this sink.
+         * @param inMaxOutputLength most decompressed data to accept
+         *   before failing, or -1 for no limit.
+         */
+        ZipResponseSink( WebResponseSink *inDestination,
+                         int inMaxOutputLength = -1 )
+                : mDestination( inDestination ),
+                  mOutputLeft( inMaxOutputLength ) {
+            }
+
+
+        virtual char write( const unsigned char *inData, int inLength ) {
+            mOutput.deleteAll();
+
+            if( ! mDecompressor.decompress( inData, inLength, &mOutput,
+                                            mOutputLeft ) ) {
+                return false;
+                }
+
+            if( mOutputLeft != -1 ) {
+                mOutputLeft -= mOutput.size();
+                }
+
+            if( mOutput.size() == 0 ) {
+                return true;
+                }
+
+            return mDestination->write( mOutput.getElementFast( 0 ),
+                                        mOutput.size() );
+            }
+
+
+        // true if entire zlib stream received
+        char isFinished() {
+            return mDecompressor.isFinished();
+            }
+
+
+    protected:
+
+        WebResponseSink *mDestination;
+
+        int mOutputLeft;
+
+        ZipDecompressor mDecompressor;
+
+        SimpleVector<unsigned char> mOutput;
+
+    };
+
+
+
+#endif
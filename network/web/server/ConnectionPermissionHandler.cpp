@@ -13,6 +13,9 @@
  *
  * 2003-September-5   Jason Rohrer
  * Moved into minorGems.
+ *
+ * 2026-October-14   Jason Rohrer
+ * Added per-host connection and request rate limits.
  */
 
 
@@ -23,6 +26,8 @@
 
 #include "minorGems/io/file/File.h"
 
+#include "minorGems/system/Time.h"
+
 #include "minorGems/util/SettingsManager.h"
 
 
@@ -56,6 +61,40 @@ ConnectionPermissionHandler::ConnectionPermissionHandler() {
         }
 
     delete addressVector;
+
+
+    for( int i=0; i<CONNECTION_PERMISSION_NUM_RATE_SLOTS; i++ ) {
+        mRateRecords[i].key = 0;
+        }
+    
+    setRateLimits( 
+        SettingsManager::getDoubleSetting( "webConnectionsPerSecond", -1.0 ),
+        SettingsManager::getDoubleSetting( "webConnectionBurst", 10.0 ),
+        SettingsManager::getDoubleSetting( "webRequestsPerSecond", -1.0 ),
+        SettingsManager::getDoubleSetting( "webRequestBurst", 50.0 ) );
+    }
+
+
+
+void ConnectionPermissionHandler::setRateLimits( 
+    double inConnectionsPerSecond,
+    double inConnectionBurst,
+    double inRequestsPerSecond,
+    double inRequestBurst ) {
+    
+    mRateLock.lock();
+    
+    mConnectionsPerSecond = inConnectionsPerSecond;
+    mConnectionBurst = inConnectionBurst;
+    mRequestsPerSecond = inRequestsPerSecond;
+    mRequestBurst = inRequestBurst;
+
+    // forget old hosts, since their buckets may hold more than new bursts
+    for( int i=0; i<CONNECTION_PERMISSION_NUM_RATE_SLOTS; i++ ) {
+        mRateRecords[i].key = 0;
+        }
+    
+    mRateLock.unlock();
     }
 
 
@@ -142,3 +181,108 @@ char ConnectionPermissionHandler::isPermitted( HostAddress *inAddress ) {
     }
 
 
+
+char ConnectionPermissionHandler::isConnectionRateOK( 
+    HostAddress *inAddress ) {
+    
+    return takeRateToken( inAddress, false );
+    }
+
+
+
+char ConnectionPermissionHandler::isRequestRateOK( HostAddress *inAddress ) {
+    return takeRateToken( inAddress, true );
+    }
+
+
+
+char ConnectionPermissionHandler::takeRateToken( HostAddress *inAddress,
+                                                 char inRequest ) {
+    mRateLock.lock();
+    
+    double rate = mConnectionsPerSecond;
+    double burst = mConnectionBurst;
+    
+    if( inRequest ) {
+        rate = mRequestsPerSecond;
+        burst = mRequestBurst;
+        }
+    
+    if( rate == -1 ) {
+        mRateLock.unlock();
+        return true;
+        }
+    
+
+    // FNV-1a hash of address string
+    unsigned int key = 2166136261U;
+
+    const char *addressString = inAddress->mAddressString;
+    
+    for( int i=0; addressString[i] != '\0'; i++ ) {
+        key ^= (unsigned char)( addressString[i] );
+        key *= 16777619U;
+        }
+    
+    if( key == 0 ) {
+        // reserved for empty slots
+        key = 1;
+        }
+    
+
+    double currentTime = Time::getCurrentTime();
+    
+    HostRateRecord *record = NULL;
+    HostRateRecord *stalest = NULL;
+    double stalestTime = 0;
+    
+    for( int p=0; p<CONNECTION_PERMISSION_MAX_RATE_PROBES; p++ ) {
+        HostRateRecord *r = 
+            &( mRateRecords[ ( key + p ) & 
+                             ( CONNECTION_PERMISSION_NUM_RATE_SLOTS - 1 ) ] );
+        
+        if( r->key == key ) {
+            record = r;
+            break;
+            }
+        
+        if( r->key == 0 ) {
+            // slots are never emptied one at a time, so host can't be
+            // further along
+            stalest = r;
+            break;
+            }
+        
+        double lastTime = r->connections.mLastTime;
+        if( r->requests.mLastTime > lastTime ) {
+            lastTime = r->requests.mLastTime;
+            }
+        
+        if( stalest == NULL || lastTime < stalestTime ) {
+            stalest = r;
+            stalestTime = lastTime;
+            }
+        }
+    
+    if( record == NULL ) {
+        // new host takes an empty slot, or replaces stalest
+        record = stalest;
+        
+        record->key = key;
+        record->connections.reset( mConnectionBurst, currentTime );
+        record->requests.reset( mRequestBurst, currentTime );
+        }
+    
+    char allowed;
+    
+    if( inRequest ) {
+        allowed = record->requests.take( rate, burst, currentTime );
+        }
+    else {
+        allowed = record->connections.take( rate, burst, currentTime );
+        }
+    
+    mRateLock.unlock();
+    
+    return allowed;
+    }
@@ -12,6 +12,9 @@
  *
  * 2003-September-5   Jason Rohrer
  * Moved into minorGems.
+ *
+ * 2026-October-14   Jason Rohrer
+ * Added per-host connection and request rate limits.
  */
 
 
@@ -23,7 +26,10 @@
 
 #include "minorGems/network/HostAddress.h"
 
+#include "minorGems/system/MutexLock.h"
+
 #include "minorGems/util/SimpleVector.h"
+#include "minorGems/util/TokenBucket.h"
 
 
 #include <string.h>
@@ -31,9 +37,41 @@
 
 
 
+// hosts tracked for rate limits, a power of 2
+#define CONNECTION_PERMISSION_NUM_RATE_SLOTS 1024
+
+// slots looked at for a host before the stalest is replaced
+#define CONNECTION_PERMISSION_MAX_RATE_PROBES 8
+
+
+typedef struct HostRateRecord {
+        // hash of host's numerical address, 0 for empty slot
+        unsigned int key;
+
+        TokenBucket connections;
+        TokenBucket requests;
+    } HostRateRecord;
+
+
+
 /**
  * A class that handles permissions for received connections.
  *
+ * Hosts are allowed from the allowedWebHosts setting, and can also be
+ * limited to a rate of new connections and of requests, each a token
+ * bucket so that short bursts are still allowed.
+ *
+ * Recently seen hosts are kept in a small fixed-size hash table, so each
+ * rate check takes constant time and space no matter how many hosts
+ * connect.  When the table is crowded, the host seen least recently is
+ * forgotten (and starts again with a full bucket if it returns).
+ *
+ * Rate limits are off unless set with setRateLimits or with the
+ * webConnectionsPerSecond, webConnectionBurst, webRequestsPerSecond and
+ * webRequestBurst settings.
+ *
+ * Thread-safe.
+ *
  * @author Jason Rohrer.
  */
 class ConnectionPermissionHandler {
@@ -65,6 +103,47 @@ class ConnectionPermissionHandler {
         char isPermitted( HostAddress *inAddress );
 
 
+
+        /**
+         * Counts a new connection against its host's rate limit.
+         *
+         * @param inAddress the numerical address of the host connecting.
+         *   Must be destroyed by caller.
+         *
+         * @return true if within limit.
+         */
+        char isConnectionRateOK( HostAddress *inAddress );
+
+        
+
+        /**
+         * Counts a request against its host's rate limit.
+         *
+         * @param inAddress the numerical address of the host.
+         *   Must be destroyed by caller.
+         *
+         * @return true if within limit.
+         */
+        char isRequestRateOK( HostAddress *inAddress );
+
+
+
+        /**
+         * Sets per-host rate limits.
+         *
+         * @param inConnectionsPerSecond new connections allowed per
+         *   second, or -1 for no limit.
+         * @param inConnectionBurst most new connections allowed at once.
+         * @param inRequestsPerSecond requests allowed per second, or
+         *   -1 for no limit.
+         * @param inRequestBurst most requests allowed at once.
+         */
+        void setRateLimits( double inConnectionsPerSecond,
+                            double inConnectionBurst,
+                            double inRequestsPerSecond,
+                            double inRequestBurst );
+
+
         
     private:
 
@@ -73,6 +152,20 @@ class ConnectionPermissionHandler {
 
         SimpleVector<char *> *mPermittedPatterns;
 
+
+        MutexLock mRateLock;
+        
+        double mConnectionsPerSecond;
+        double mConnectionBurst;
+        double mRequestsPerSecond;
+        double mRequestBurst;
+        
+        HostRateRecord mRateRecords[ CONNECTION_PERMISSION_NUM_RATE_SLOTS ];
+
+
+        // takes a connection or request token for a host
+        char takeRateToken( HostAddress *inAddress, char inRequest );
+
         
     };
 
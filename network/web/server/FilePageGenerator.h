@@ -0,0 +1,137 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14   Jason Rohrer
+ * Created.
+ */
+
+
+
+#ifndef FILE_PAGE_GENERATOR_INCLUDED
+#define FILE_PAGE_GENERATOR_INCLUDED
+
+
+
+#include "PageGenerator.h"
+
+#include "minorGems/network/web/MimeTyper.h"
+#include "minorGems/util/stringUtils.h"
+
+#include <string.h>
+
+
+
+/**
+ * Serves the files under a directory, with mime types from MimeTyper.
+ *
+ * Query strings are ignored, "/" is served as "/index.html", and paths
+ * containing ".." are refused.
+ *
+ * @author Jason Rohrer
+ */
+class FilePageGenerator : public PageGenerator {
+
+    public:
+
+
+        
+        /**
+         * Constructs a generator.
+         *
+         * @param inRootPath the directory to serve, without a trailing
+         *   slash.  Destroyed by caller.
+         * @param inCacheMaxAge max age sent to browsers, in seconds.
+         *   Defaults to 0.
+         * @param inMimeConfigFileName passed to MimeTyper.  Defaults to
+         *   NULL.
+         */
+        FilePageGenerator( const char *inRootPath, int inCacheMaxAge = 0,
+                           char *inMimeConfigFileName = NULL )
+                : mRootPath( stringDuplicate( inRootPath ) ),
+                  mCacheMaxAge( inCacheMaxAge ),
+                  mMimeTyper( inMimeConfigFileName ) {
+            }
+
+
+        
+        virtual ~FilePageGenerator() {
+            delete [] mRootPath;
+            }
+
+
+
+        // implements the PageGenerator interface
+
+        
+        virtual char *getFilePath( char *inGetRequestPath ) {
+            if( strstr( inGetRequestPath, ".." ) != NULL ) {
+                // the root directory itself, which is never sent (not a 
+                // regular file), so the request gets "not found"
+                return stringDuplicate( mRootPath );
+                }
+            
+            char *path = stringDuplicate( inGetRequestPath );
+            
+            char *query = strstr( path, "?" );
+            if( query != NULL ) {
+                query[0] = '\0';
+                }
+            
+            char *filePath;
+            
+            if( strcmp( path, "/" ) == 0 ) {
+                filePath = autoSprintf( "%s/index.html", mRootPath );
+                }
+            else {
+                filePath = autoSprintf( "%s%s", mRootPath, path );
+                }
+            
+            delete [] path;
+            
+            return filePath;
+            }
+
+
+        
+        virtual void generatePage( char *inGetRequestPath,
+                                   OutputStream *inOutputStream ) {
+            // never called, since all pages have a file path
+            }
+        
+
+
+        virtual char *getMimeType( char *inGetRequestPath ) {
+            char *filePath = getFilePath( inGetRequestPath );
+            
+            char *mimeType = mMimeTyper.getFileNameMimeType( filePath );
+            
+            delete [] filePath;
+            
+            if( mimeType == NULL ) {
+                mimeType = stringDuplicate( "application/octet-stream" );
+                }
+            
+            return mimeType;
+            }
+
+        
+
+        virtual int getCacheMaxAge( char *inGetRequestPath ) {
+            return mCacheMaxAge;
+            }
+
+
+
+    protected:
+
+        char *mRootPath;
+        
+        int mCacheMaxAge;
+
+        MimeTyper mMimeTyper;
+
+    };
+
+
+
+#endif
@@ -0,0 +1,153 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+
+
+#ifndef METRICS_PAGE_GENERATOR_INCLUDED
+#define METRICS_PAGE_GENERATOR_INCLUDED
+
+
+
+#include "PageGenerator.h"
+
+#include "minorGems/util/Metrics.h"
+#include "minorGems/util/stringUtils.h"
+
+#include <string.h>
+
+
+
+/**
+ * Serves a MetricsRegistry in the Prometheus text format, so a server can
+ * be scraped without parsing its logs.
+ *
+ * Other paths can be passed on to another generator, so metrics can share
+ * a WebServer with the pages it already serves:
+ *   new WebServer( port,
+ *                  new MetricsPageGenerator(
+ *                      NULL, new FilePageGenerator( "www" ) ) );
+ *
+ * Metrics pages are never cached.
+ *
+ * @author Jason Rohrer
+ */
+class MetricsPageGenerator : public PageGenerator {
+
+    public:
+
+
+
+        /**
+         * Constructs a generator.
+         *
+         * @param inRegistry the metrics to serve, or NULL for
+         *   MetricsRegistry::getGlobal().  Destroyed by caller.
+         * @param inOtherPages generator for paths other than inPath, or
+         *   NULL to serve metrics at every path.  Destroyed when this
+         *   class is destroyed.
+         * @param inPath the path to serve metrics at, without query.
+         *   Defaults to "/metrics".  Destroyed by caller.
+         */
+        MetricsPageGenerator( MetricsRegistry *inRegistry = NULL,
+                              PageGenerator *inOtherPages = NULL,
+                              const char *inPath = "/metrics" )
+                : mRegistry( inRegistry ),
+                  mOtherPages( inOtherPages ),
+                  mPath( stringDuplicate( inPath ) ) {
+
+            if( mRegistry == NULL ) {
+                mRegistry = MetricsRegistry::getGlobal();
+                }
+            }
+
+
+
+        virtual ~MetricsPageGenerator() {
+            if( mOtherPages != NULL ) {
+                delete mOtherPages;
+                }
+            delete [] mPath;
+            }
+
+
+
+        // implements the PageGenerator interface
+
+
+        virtual void generatePage( char *inGetRequestPath,
+                                   OutputStream *inOutputStream ) {
+            if( ! isMetricsPath( inGetRequestPath ) ) {
+                mOtherPages->generatePage( inGetRequestPath,
+                                           inOutputStream );
+                return;
+                }
+
+            char *text = mRegistry->getText();
+
+            inOutputStream->writeString( text );
+
+            delete [] text;
+            }
+
+
+
+        virtual char *getMimeType( char *inGetRequestPath ) {
+            if( ! isMetricsPath( inGetRequestPath ) ) {
+                return mOtherPages->getMimeType( inGetRequestPath );
+                }
+
+            return stringDuplicate( "text/plain; version=0.0.4" );
+            }
+
+
+
+        virtual int getCacheMaxAge( char *inGetRequestPath ) {
+            if( ! isMetricsPath( inGetRequestPath ) ) {
+                return mOtherPages->getCacheMaxAge( inGetRequestPath );
+                }
+            return 0;
+            }
+
+
+
+        virtual char *getFilePath( char *inGetRequestPath ) {
+            if( ! isMetricsPath( inGetRequestPath ) ) {
+                return mOtherPages->getFilePath( inGetRequestPath );
+                }
+            return NULL;
+            }
+
+
+
+    protected:
+
+        MetricsRegistry *mRegistry;
+
+        PageGenerator *mOtherPages;
+
+        char *mPath;
+
+
+
+        char isMetricsPath( char *inGetRequestPath ) {
+            if( mOtherPages == NULL ) {
+                return true;
+                }
+
+            // ignore query string
+            int pathLength = strlen( mPath );
+
+            return strncmp( inGetRequestPath, mPath, pathLength ) == 0 &&
+                ( inGetRequestPath[ pathLength ] == '\0' ||
+                  inGetRequestPath[ pathLength ] == '?' );
+            }
+
+    };
+
+
+
+#endif
@@ -0,0 +1,138 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14   Jason Rohrer
+ * Created.
+ */
+
+
+
+#include "PageCache.h"
+
+#include "minorGems/system/Time.h"
+#include "minorGems/util/stringUtils.h"
+
+#include <string.h>
+
+
+
+PageCache::PageCache( int inMaxBytes )
+        : mMaxBytes( inMaxBytes ), mTotalBytes( 0 ) {
+    }
+
+
+
+PageCache::~PageCache() {
+    clear();
+    }
+
+
+
+void PageCache::deleteEntry( int inIndex ) {
+    PageCacheEntry *e = mEntries.getElement( inIndex );
+    
+    mTotalBytes -= e->length;
+
+    delete [] e->path;
+    delete [] e->body;
+    delete [] e->mimeType;
+    delete [] e->eTag;
+
+    mEntries.deleteElement( inIndex );
+    }
+
+
+
+char PageCache::get( const char *inPath,
+                     unsigned char **outBody, int *outLength,
+                     char **outMimeType, char **outETag ) {
+    mLock.lock();
+    
+    double currentTime = Time::getCurrentTime();
+    
+    for( int i=0; i<mEntries.size(); i++ ) {
+        PageCacheEntry *e = mEntries.getElement( i );
+        
+        if( strcmp( e->path, inPath ) != 0 ) {
+            continue;
+            }
+        
+        if( e->expireTime < currentTime ) {
+            deleteEntry( i );
+            break;
+            }
+        
+        *outLength = e->length;
+        *outBody = new unsigned char[ e->length ];
+        memcpy( *outBody, e->body, e->length );
+
+        *outMimeType = stringDuplicate( e->mimeType );
+        *outETag = stringDuplicate( e->eTag );
+        
+        // now most recently used
+        PageCacheEntry entry = *e;
+        mEntries.deleteElement( i );
+        mEntries.push_back( entry );
+        
+        mLock.unlock();
+        return true;
+        }
+    
+    mLock.unlock();
+    return false;
+    }
+
+
+
+void PageCache::put( const char *inPath,
+                     unsigned char *inBody, int inLength,
+                     const char *inMimeType, const char *inETag,
+                     int inLifetimeSeconds ) {
+
+    if( inLength > mMaxBytes / 4 ) {
+        return;
+        }
+    
+    mLock.lock();
+    
+    for( int i=0; i<mEntries.size(); i++ ) {
+        if( strcmp( mEntries.getElement( i )->path, inPath ) == 0 ) {
+            deleteEntry( i );
+            break;
+            }
+        }
+    
+    while( mEntries.size() > 0 && mTotalBytes + inLength > mMaxBytes ) {
+        deleteEntry( 0 );
+        }
+    
+    PageCacheEntry e;
+    
+    e.path = stringDuplicate( inPath );
+    
+    e.body = new unsigned char[ inLength ];
+    memcpy( e.body, inBody, inLength );
+    e.length = inLength;
+    
+    e.mimeType = stringDuplicate( inMimeType );
+    e.eTag = stringDuplicate( inETag );
+
+    e.expireTime = Time::getCurrentTime() + inLifetimeSeconds;
+    
+    mEntries.push_back( e );
+    mTotalBytes += inLength;
+    
+    mLock.unlock();
+    }
+
+
+
+void PageCache::clear() {
+    mLock.lock();
+    
+    while( mEntries.size() > 0 ) {
+        deleteEntry( mEntries.size() - 1 );
+        }
+    
+    mLock.unlock();
+    }
@@ -0,0 +1,113 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14   Jason Rohrer
+ * Created.
+ */
+
+
+
+#ifndef PAGE_CACHE_INCLUDED
+#define PAGE_CACHE_INCLUDED
+
+
+#include "minorGems/system/MutexLock.h"
+#include "minorGems/util/SimpleVector.h"
+
+
+
+typedef struct PageCacheEntry {
+        char *path;
+        
+        unsigned char *body;
+        int length;
+
+        char *mimeType;
+        char *eTag;
+        
+        double expireTime;
+    } PageCacheEntry;
+
+
+
+/**
+ * Cache of generated pages for WebServer, so that hot pages aren't
+ * generated again for every request.
+ *
+ * Least recently used pages are dropped to stay within a size limit.
+ *
+ * Thread-safe.
+ *
+ * @author Jason Rohrer
+ */
+class PageCache {
+
+    public:
+
+        /**
+         * @param inMaxBytes the most page data to hold.
+         *   Defaults to 4 MiB.
+         */
+        PageCache( int inMaxBytes = 4194304 );
+
+        ~PageCache();
+
+
+        
+        /**
+         * Gets a cached page.
+         *
+         * @param inPath the request path.  Destroyed by caller.
+         * @param outBody, outLength, outMimeType, outETag where copies
+         *   of the page and its mime type and ETag are returned.
+         *   Destroyed by caller.
+         *
+         * @return true if a page that hasn't expired was found.
+         */
+        char get( const char *inPath,
+                  unsigned char **outBody, int *outLength,
+                  char **outMimeType, char **outETag );
+
+
+        
+        /**
+         * Adds a page, replacing any older page for the same path.
+         *
+         * Pages larger than a quarter of the cache are not added.
+         *
+         * @param inPath, inBody, inMimeType, inETag the page.
+         *   Destroyed by caller (copied internally).
+         * @param inLifetimeSeconds how long the page can be served from
+         *   cache.
+         */
+        void put( const char *inPath,
+                  unsigned char *inBody, int inLength,
+                  const char *inMimeType, const char *inETag,
+                  int inLifetimeSeconds );
+
+
+        
+        // drops all pages
+        void clear();
+
+
+
+    protected:
+
+        MutexLock mLock;
+
+        // least recently used first
+        SimpleVector<PageCacheEntry> mEntries;
+
+        int mMaxBytes;
+        int mTotalBytes;
+
+
+        // must be called with mLock locked
+        void deleteEntry( int inIndex );
+
+    };
+
+
+
+#endif
@@ -21,6 +21,12 @@
  *
  * 2003-September-5   Jason Rohrer
  * Moved into minorGems.
+ *
+ * 2026-October-14   Jason Rohrer
+ * Added getFilePath for pages served straight from files.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Added isStreamed and isCompressible for streamed pages.
  */
 
 
@@ -88,6 +94,79 @@ class PageGenerator {
         virtual int getCacheMaxAge( char *inGetRequestPath ) {
             return 0;
             }
+
+
+
+        /**
+         * Gets the file to send for a given path, for pages that are
+         * just the contents of a file.
+         *
+         * WebServer then sends the file itself (with sendfile, where
+         * available), and generatePage isn't called.
+         * If the file can't be opened, or isn't a regular file, a
+         * "not found" page is sent.
+         *
+         * Defaults to NULL (all pages generated).
+         *
+         * @param inGetRequestPath the path specified
+         *   by the get request.
+         *   Must be destroyed by caller if non-const.
+         *
+         * @return the file path, or NULL to generate the page.
+         *   Must be destroyed by caller if non-NULL.
+         */
+        virtual char *getFilePath( char *inGetRequestPath ) {
+            return NULL;
+            }
+
+
+
+        /**
+         * Gets whether a page should be streamed to the client as
+         * generatePage writes it, instead of generated whole first.
+         *
+         * For big pages (long listings, status dumps), since streamed
+         * pages are never held in memory whole, and their first bytes go
+         * out as soon as they are written.  They are sent with chunked
+         * transfer encoding (or, to HTTP/1.0 clients, ended by closing
+         * the connection), and without an ETag or caching.
+         *
+         * Writes to a streamed page's stream block while the client
+         * catches up, and return -1 once the client has gone, so a
+         * generator can stop early.
+         *
+         * Defaults to false.
+         *
+         * @param inGetRequestPath the path specified
+         *   by the get request.
+         *   Must be destroyed by caller if non-const.
+         *
+         * @return true to stream the page.
+         */
+        virtual char isStreamed( char *inGetRequestPath ) {
+            return false;
+            }
+
+
+
+        /**
+         * Gets whether a streamed page should be gzipped for clients
+         * that accept it.
+         *
+         * Worth it for text, but not for data that is already
+         * compressed (like images).
+         *
+         * Defaults to false.
+         *
+         * @param inGetRequestPath the path specified
+         *   by the get request.
+         *   Must be destroyed by caller if non-const.
+         *
+         * @return true to gzip the page.
+         */
+        virtual char isCompressible( char *inGetRequestPath ) {
+            return false;
+            }
         
         
     };
@@ -34,21 +34,52 @@
  *
  * 2003-September-5   Jason Rohrer
  * Moved into minorGems.
+ *
+ * 2026-October-14   Jason Rohrer
+ * Split permission check and response out so that WebServer worker pool
+ * can share them.
+ * Changed to HTTP/1.1 with keep-alive.  Added Content-Length, ETags and
+ * 304 responses.  Files from PageGenerator::getFilePath sent with
+ * Socket::sendFile.  Generated pages cached in PageCache.
+ * Fixed missing status line on bad request page, and overflow of not
+ * found page buffer with long file name.
+ * Added per-host connection and request rate limits.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Generated pages are hashed and sent from StringBufferOutputStream
+ * chunks, without copying into one array unless they are cached.
+ * Requests counted and timed in the global MetricsRegistry.
+ * Added pages streamed through ResponseStream as they are generated,
+ * with chunked transfer encoding and optional gzip.
  */
 
 
 
 #include "RequestHandlingThread.h"
+#include "ResponseStream.h"
+
+#include "minorGems/crypto/hashes/sha1.h"
+#include "minorGems/system/Time.h"
+#include "minorGems/util/Metrics.h"
+#include "minorGems/util/StringBufferOutputStream.h"
+#include "minorGems/util/stringUtils.h"
+#include "minorGems/formats/encodingUtils.h"
+
+#include <stdlib.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 
 
 
 RequestHandlingThread::RequestHandlingThread(
     Socket *inSocket, PageGenerator *inGenerator,
-    ConnectionPermissionHandler *inConnectionPermissionHandler )
+    ConnectionPermissionHandler *inConnectionPermissionHandler,
+    PageCache *inCache )
     : mSocket( inSocket ),
       mGenerator( inGenerator ),
       mConnectionPermissionHandler( inConnectionPermissionHandler ),
+      mCache( inCache ),
       mDoneLock( new MutexLock() ), mDone( false ) {
 
     }
@@ -75,12 +106,13 @@ char RequestHandlingThread::isDone() {
 
     // example HTTP request and response
     /*
-      GET /images/title_homepage4.gif HTTP/1.0
+      GET /images/title_homepage4.gif HTTP/1.1
+      Host: www.google.com
 
-      HTTP/1.0 200 OK
+      HTTP/1.1 200 OK
       Date: Fri, 11 May 2001 18:05:08 GMT
       Server: GWS/1.10
-      Connection: close
+      Connection: keep-alive
       Expires: Sun, 17 Jan 2038 19:14:07 GMT
       Content-Length: 7963
       Content-Type: image/gif
@@ -92,13 +124,7 @@ char RequestHandlingThread::isDone() {
 
 void RequestHandlingThread::run() {
 
-    HostAddress *receivedAddress = mSocket->getRemoteHostAddress();
-
-    if( receivedAddress == NULL ) {
-        
-        printf( "Failed to obtain host address, so "
-                "refusing web connection.\n" );
-        
+    if( ! isPermitted( mSocket, mConnectionPermissionHandler ) ) {
         // refuse
         delete mSocket;
 
@@ -110,220 +136,773 @@ void RequestHandlingThread::run() {
 
         return;
         }
+    
+
+    HostAddress *remoteAddress = mSocket->getRemoteHostAddress();
+    
+    SimpleVector<char> received;
+
+    unsigned char *readBuffer =
+        new unsigned char[ REQUEST_HANDLING_THREAD_BUFFER_SIZE ];
+
+    char keepAlive = true;
+    
+    while( keepAlive ) {
+        char *request = takeRequest( &received );
+
+        if( request == NULL ) {
+            if( received.size() > 
+                REQUEST_HANDLING_THREAD_MAX_REQUEST_LENGTH ) {
+                
+                sendBadRequest( mSocket );
+                break;
+                }
+            
+            int numRead = 
+                mSocket->receive( 
+                    readBuffer, REQUEST_HANDLING_THREAD_BUFFER_SIZE,
+                    REQUEST_HANDLING_THREAD_KEEP_ALIVE_SECONDS * 1000 );
+            
+            if( numRead <= 0 ) {
+                // closed, or idle too long
+                break;
+                }
+            
+            received.appendArray( (char*)readBuffer, numRead );
+            continue;
+            }
+        
+        if( isRequestPermitted( remoteAddress, mSocket,
+                                mConnectionPermissionHandler ) ) {
+            keepAlive = respond( request, mSocket, mGenerator, mCache );
+            }
+        else {
+            keepAlive = false;
+            }
+        
+        delete [] request;
+        }
+
+    delete [] readBuffer;
+
+    if( remoteAddress != NULL ) {
+        delete remoteAddress;
+        }
+
+    delete mSocket;
+
+    
+    // flag that we're done
+    mDoneLock->lock();
+    mDone = true;
+    mDoneLock->unlock();
+    }
+
+
+
+char RequestHandlingThread::isPermitted( 
+    Socket *inSocket,
+    ConnectionPermissionHandler *inConnectionPermissionHandler ) {
+    
+    HostAddress *receivedAddress = inSocket->getRemoteHostAddress();
+
+    if( receivedAddress == NULL ) {
+        
+        printf( "Failed to obtain host address, so "
+                "refusing web connection.\n" );
+        
+        return false;
+        }
     else if(
-        ! mConnectionPermissionHandler->isPermitted( receivedAddress ) ) { 
+        ! inConnectionPermissionHandler->isPermitted( receivedAddress ) ) { 
 
         printf( "Refusing web connection from:  " );
         receivedAddress->print();
         printf( "\n" );
 
-        
-        // not permitted
-        delete mSocket;
+        delete receivedAddress;
 
+        return false;
+        }
+    
+    else if( ! inConnectionPermissionHandler->isConnectionRateOK( 
+                 receivedAddress ) ) {
+        
+        // not printed, since an abusive host would flood output
         delete receivedAddress;
         
-        // flag that we're done
-        mDoneLock->lock();
-        mDone = true;
-        mDoneLock->unlock();
-
-        return;
+        sendTooManyRequests( inSocket, false );
+        
+        return false;
         }
     
     // else permitted
     delete receivedAddress;
+
+    return true;
+    }
+
+
+
+char RequestHandlingThread::isRequestPermitted(
+    HostAddress *inAddress, Socket *inSocket,
+    ConnectionPermissionHandler *inConnectionPermissionHandler ) {
+
+    if( inAddress == NULL || 
+        inConnectionPermissionHandler->isRequestRateOK( inAddress ) ) {
+        return true;
+        }
     
+    sendTooManyRequests( inSocket, true );
+    
+    return false;
+    }
 
-    int maxLength = 5000;
+
+
+void RequestHandlingThread::sendTooManyRequests( Socket *inSocket,
+                                                 char inAllowedToBlock ) {
+    const char *response = 
+        "HTTP/1.1 429 Too Many Requests\r\n"
+        "Retry-After: 1\r\n"
+        "Content-Length: 0\r\n"
+        "Connection: close\r\n\r\n";
+    
+    inSocket->send( (unsigned char *)response, strlen( response ),
+                    inAllowedToBlock, false );
+    }
+
+
+
+char *RequestHandlingThread::takeRequest( SimpleVector<char> *ioBuffer ) {
+    int size = ioBuffer->size();
+
+    if( size < 4 ) {
+        return NULL;
+        }
     
+    char *data = ioBuffer->getElementFast( 0 );
     
-    // first, receive the request and parse it
+    for( int i=0; i <= size - 4; i++ ) {
+        if( memcmp( &( data[i] ), "\r\n\r\n", 4 ) == 0 ) {
+            int length = i + 4;
+            
+            char *request = new char[ length + 1 ];
+            
+            memcpy( request, data, length );
+            request[ length ] = '\0';
+            
+            ioBuffer->deleteStartElements( length );
+            
+            return request;
+            }
+        }
     
+    return NULL;
+    }
 
-    SocketStream *sockStream = new SocketStream( mSocket );
 
-    int requestBufferLength = maxLength;
-    char *requestBuffer = new char[requestBufferLength];
-    int requestBufferIndex = 0;
-        
-    // read until we see two \r\n 's in a row
-    unsigned char *charRead = new unsigned char[1];
-    charRead[0] = 0;
-    char requestDone = false;
 
-    char error = false;
+// gets the value of a header line in a request, or NULL if missing
+// result destroyed by caller if non-NULL
+static char *getHeaderValue( char *inRequest, const char *inName ) {
+    
+    // skip request line
+    char *line = strstr( inRequest, "\r\n" );
     
-    // _we_ actually only care about the first line of
-    // the request, but we need to read the entire request
-    // to make the other host happy
-    char firstLineDone = false;
-    int numRead = 0;
+    while( line != NULL ) {
+        line = &( line[2] );
+        
+        char *lineEnd = strstr( line, "\r\n" );
+        
+        if( lineEnd == NULL ) {
+            return NULL;
+            }
+        
+        char *colon = strstr( line, ":" );
+        
+        if( colon != NULL && colon < lineEnd ) {
+            char *name = stringDuplicate( line );
+            name[ colon - line ] = '\0';
+            
+            char found = ( stringCompareIgnoreCase( name, inName ) == 0 );
+            
+            delete [] name;
 
-    while( !requestDone && !error ) {
-        while( charRead[0] != 13 && !error ) {
-            numRead = sockStream->read( charRead, 1 );
-                            
-            if( !firstLineDone ) {
-                if( numRead != 1 ) {
-                    error = true;
-                    sendBadRequest( sockStream );
-                    }
-                // read data into our buffer
-                else if( requestBufferIndex < requestBufferLength ) {
-                    requestBuffer[ requestBufferIndex ] =
-                        charRead[0];
-                    requestBufferIndex++;
-
-                    if( charRead[0] == 13 ) {
-                        firstLineDone = true;
-                        }
+            if( found ) {
+                char *valueStart = &( colon[1] );
+                
+                while( valueStart < lineEnd && 
+                       ( valueStart[0] == ' ' || valueStart[0] == '\t' ) ) {
+                    valueStart = &( valueStart[1] );
                     }
-                else {
-                    error = true;
-                    sendBadRequest( sockStream );
+                
+                int valueLength = lineEnd - valueStart;
+                
+                while( valueLength > 0 && 
+                       ( valueStart[ valueLength - 1 ] == ' ' ||
+                         valueStart[ valueLength - 1 ] == '\t' ) ) {
+                    valueLength --;
                     }
+                
+                char *value = new char[ valueLength + 1 ];
+                memcpy( value, valueStart, valueLength );
+                value[ valueLength ] = '\0';
+                
+                return value;
                 }
             }
-        if( !error ) {
-            // look for rest of double \r\n
-            // this will effectively skip other lines in the request,
-            // since we don't care about them
-            numRead = sockStream->read( charRead, 1 );
+        
+        line = lineEnd;
+        }
+    
+    return NULL;
+    }
 
-            if( charRead[0] == 10 && numRead == 1 ) {
 
-                numRead = sockStream->read( charRead, 1 );
-                if( charRead[0] == 13 && numRead == 1  ) {
 
-                    numRead = sockStream->read( charRead, 1 );
-                    if( charRead[0] == 10 && numRead == 1 ) {
-                        requestDone = true;
-                        }
-                    }
-                }
+// true if inETag is in the value of an If-None-Match header
+static char isETagMatch( char *inIfNoneMatch, char *inETag ) {
+    if( inIfNoneMatch == NULL ) {
+        return false;
+        }
+    
+    return ( strcmp( inIfNoneMatch, "*" ) == 0 ||
+             strstr( inIfNoneMatch, inETag ) != NULL );
+    }
 
-            if( numRead != 1 ) {
-                error = true;
-                sendBadRequest( sockStream );
-                }
-            }
+
+
+// response header for a page
+// inMimeType, inETag, and inExtraHeaders NULL and inContentLength -1 to 
+// omit them
+// inExtraHeaders are whole lines, each ending with \r\n
+static char *getResponseHeader( const char *inStatus, int inCacheSeconds,
+                                const char *inMimeType, 
+                                long inContentLength,
+                                const char *inETag, 
+                                const char *inExtraHeaders,
+                                char inKeepAlive ) {
+    
+    SimpleVector<char> header;
+    
+    char *line = autoSprintf( "HTTP/1.1 %s\r\n", inStatus );
+    header.appendElementString( line );
+    delete [] line;
+    
+    if( inCacheSeconds == 0 ) {
+        header.appendElementString( "cache-control: no-cache\r\n" );
+        }
+    else {
+        line = autoSprintf( "cache-control: private, max-age=%d\r\n",
+                            inCacheSeconds );
+        header.appendElementString( line );
+        delete [] line;
+        }
+    
+    if( inMimeType != NULL ) {
+        line = autoSprintf( "Content-Type: %s\r\n", inMimeType );
+        header.appendElementString( line );
+        delete [] line;
+        }
+    
+    if( inContentLength != -1 ) {
+        line = autoSprintf( "Content-Length: %ld\r\n", inContentLength );
+        header.appendElementString( line );
+        delete [] line;
+        }
+    
+    if( inETag != NULL ) {
+        line = autoSprintf( "ETag: %s\r\n", inETag );
+        header.appendElementString( line );
+        delete [] line;
+        }
+    
+    if( inExtraHeaders != NULL ) {
+        header.appendElementString( inExtraHeaders );
         }
 
-    // \0 terminate the request buffer
-    if( requestBufferIndex < requestBufferLength ) {
-        requestBuffer[ requestBufferIndex ] = '\0';
+    if( inKeepAlive ) {
+        header.appendElementString( "Connection: keep-alive\r\n\r\n" );
         }
     else {
-        requestBuffer[ requestBufferLength - 1 ] = '\0';
+        header.appendElementString( "Connection: close\r\n\r\n" );
         }
     
-    if( !error ) {
-        // at this point, we have received the entire
-        // request, and stored the most important part in
-        // requestBuffer
+    return header.getElementString();
+    }
 
 
-        // if maxLength = 500,
-        // formatString = "%499s"
-        // used to limit length of scanned string 
-        char *formatString = new char[ 20 ];
-        sprintf( formatString, "%%%ds", maxLength - 1 );
-        
-        
-        // the second string scanned from the buffer should
-        // be the file path requested
+
+// request metrics, shared by all handlers
+static MetricsCounter *requestsTotal = 
+    MetricsRegistry::getGlobal()->getCounter( 
+        "minorgems_web_requests_total", 
+        "HTTP requests handled by WebServer." );
+
+static MetricsGauge *requestsInFlight = 
+    MetricsRegistry::getGlobal()->getGauge( 
+        "minorgems_web_requests_in_flight", 
+        "HTTP requests being handled by WebServer right now." );
+
+static double requestSecondsBounds[] = 
+    { 0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1, 5 };
+
+static MetricsHistogram *requestSeconds = 
+    MetricsRegistry::getGlobal()->getHistogram( 
+        "minorgems_web_request_seconds", 
+        "Time to parse a request and send its response.",
+        requestSecondsBounds, 
+        sizeof( requestSecondsBounds ) / sizeof( double ) );
+
+
+
+static void endRequestMetrics( double inStartTime ) {
+    requestSeconds->observe( Time::getMonotonicTime() - inStartTime );
+    requestsInFlight->add( -1 );
+    }
+
+
+
+char RequestHandlingThread::respond( char *inRequest,
+                                     Socket *inSocket,
+                                     PageGenerator *inGenerator,
+                                     PageCache *inCache ) {
+    
+    requestsTotal->increment();
+    requestsInFlight->add( 1 );
+    
+    double startTime = Time::getMonotonicTime();
+
+    int maxLength = 5000;
+
+    // used to limit length of scanned strings
+    char *formatString = autoSprintf( "%%15s %%%ds %%15s", maxLength - 1 );
+    
+    char method[16];
+    char version[16];
+    char *filePathBuffer = new char[ maxLength ];
+    
+    int numRead = sscanf( inRequest, formatString, 
+                          method, filePathBuffer, version );
+    
+    delete [] formatString;
+    
+    char headOnly = ( strcmp( method, "HEAD" ) == 0 );
+    
+    if( numRead < 2 || ( strcmp( method, "GET" ) != 0 && ! headOnly ) ) {
+        // an invalid request
+        sendBadRequest( inSocket );
+
+        delete [] filePathBuffer;
         
-        char *filePathBuffer = new char[ maxLength ];
-        int numRead = sscanf( requestBuffer, formatString, filePathBuffer );
+        endRequestMetrics( startTime );
+        return false;
+        }
 
-        if( numRead != 1 || strcmp( filePathBuffer, "GET" ) != 0 ) {
-            // an invalid request
-            error = true;
-            sendBadRequest( sockStream );
-            }
-        else {
-            // a proper GET request
 
-            // skip the GET and read the file name
-            numRead = sscanf( &( requestBuffer[3] ),
-                              formatString, filePathBuffer );
+    // HTTP/1.1 connections stay open unless client asks otherwise,
+    // HTTP/1.0 only if client asks
+    char keepAlive = false;
+    
+    char *connection = getHeaderValue( inRequest, "Connection" );
+    
+    if( numRead == 3 && strcmp( version, "HTTP/1.1" ) == 0 ) {
+        keepAlive = 
+            ( connection == NULL || 
+              stringLocateIgnoreCase( connection, "close" ) == NULL );
+        }
+    else if( numRead == 3 && strcmp( version, "HTTP/1.0" ) == 0 ) {
+        keepAlive = 
+            ( connection != NULL && 
+              stringLocateIgnoreCase( connection, "keep-alive" ) != NULL );
+        }
+    
+    if( connection != NULL ) {
+        delete [] connection;
+        }
+    
+
+    // chunked transfer encoding is HTTP/1.1 only
+    char chunked = ( numRead == 3 && strcmp( version, "HTTP/1.1" ) == 0 );
+    
+
+    char *ifNoneMatch = getHeaderValue( inRequest, "If-None-Match" );
+    
+    int cacheSeconds = inGenerator->getCacheMaxAge( filePathBuffer );
+    
+    char sent;
+
+    char *filePath = inGenerator->getFilePath( filePathBuffer );
+    
+    if( filePath != NULL ) {
+        sent = sendFilePage( inSocket, inGenerator, filePathBuffer, 
+                             filePath, ifNoneMatch, cacheSeconds, 
+                             headOnly, keepAlive );
+        delete [] filePath;
+        }
+    else if( inGenerator->isStreamed( filePathBuffer ) ) {
+        // without chunks, end of body is marked by closing connection
+        if( ! chunked ) {
+            keepAlive = false;
+            }
         
-            if( numRead != 1 ) {
-                error = true;
-                sendBadRequest( sockStream );
-                }
+        char *acceptEncoding = getHeaderValue( inRequest, 
+                                               "Accept-Encoding" );
+        
+        sent = sendStreamedPage( inSocket, inGenerator, filePathBuffer,
+                                 acceptEncoding, headOnly, chunked,
+                                 keepAlive );
+        
+        if( acceptEncoding != NULL ) {
+            delete [] acceptEncoding;
             }
+        }
+    else {
+        sent = sendGeneratedPage( inSocket, inGenerator, inCache,
+                                  filePathBuffer, ifNoneMatch, 
+                                  cacheSeconds, headOnly, keepAlive );
+        }
+    
+    if( ifNoneMatch != NULL ) {
+        delete [] ifNoneMatch;
+        }
+    
+    delete [] filePathBuffer;
+
+    endRequestMetrics( startTime );
+
+    return sent && keepAlive;
+    }
+
+
+
+char RequestHandlingThread::sendFilePage( Socket *inSocket,
+                                          PageGenerator *inGenerator,
+                                          char *inPath, char *inFilePath,
+                                          char *inIfNoneMatch,
+                                          int inCacheSeconds,
+                                          char inHeadOnly,
+                                          char inKeepAlive ) {
+    FILE *file = NULL;
+    
+    struct stat fileInfo;
+    
+    if( stat( inFilePath, &fileInfo ) == 0 &&
+        ( fileInfo.st_mode & S_IFMT ) == S_IFREG ) {
         
-        delete [] requestBuffer;
-        delete [] charRead;
+        file = fopen( inFilePath, "rb" );
+        }
+    
+    if( file == NULL ) {
+        return sendNotFoundPage( inSocket, inPath, inKeepAlive );
+        }
+    
+    long length = (long)( fileInfo.st_size );
 
+    char *eTag = autoSprintf( "\"%lx-%lx\"", 
+                              length, (long)( fileInfo.st_mtime ) );
+    
+    char *header;
+    char notModified = isETagMatch( inIfNoneMatch, eTag );
 
-        delete [] formatString;
+    if( notModified ) {
+        header = getResponseHeader( "304 Not Modified", inCacheSeconds,
+                                    NULL, -1, eTag, NULL, 
+                                    inKeepAlive );
+        }
+    else {
+        char *mimeType = inGenerator->getMimeType( inPath );
         
-        if( !error ) {
-            // now we have the requested file string
-            sockStream->writeString(
-                "HTTP/1.0 200 OK\r\n" );
+        header = getResponseHeader( "200 OK", inCacheSeconds,
+                                    mimeType, length, eTag, NULL, 
+                                    inKeepAlive );
+        delete [] mimeType;
+        }
 
+    delete [] eTag;
+    
+    SocketBuffer headerBuffer = { (unsigned char*)header, 
+                                  (int)strlen( header ) };
+    
+    char sent = sendAll( inSocket, &headerBuffer, 1 );
+    
+    delete [] header;
+    
+    if( sent && ! notModified && ! inHeadOnly ) {
+        sent = ( inSocket->sendFile( file, 0, length ) == length );
+        }
+    
+    fclose( file );
+    
+    return sent;
+    }
+
+
+
+char RequestHandlingThread::sendGeneratedPage( Socket *inSocket,
+                                               PageGenerator *inGenerator,
+                                               PageCache *inCache,
+                                               char *inPath,
+                                               char *inIfNoneMatch,
+                                               int inCacheSeconds,
+                                               char inHeadOnly,
+                                               char inKeepAlive ) {
+    // NULL if page is sent from pageStream's chunks
+    unsigned char *body = NULL;
+    int length;
+    char *mimeType;
+    char *eTag;
+    
+    StringBufferOutputStream *pageStream = NULL;
+    
+    char useCache = ( inCache != NULL && inCacheSeconds > 0 );
+    
+    if( ! useCache || 
+        ! inCache->get( inPath, &body, &length, &mimeType, &eTag ) ) {
+
+        // generate whole page first, so we know its length and ETag
+        pageStream = new StringBufferOutputStream();
+        
+        inGenerator->generatePage( inPath, pageStream );
+        
+        length = pageStream->getNumBytes();
+        
+        mimeType = inGenerator->getMimeType( inPath );
+        
+        // hash chunks in place
+        SHA_CTX context;
+        SHA1_Init( &context );
+        
+        int numChunks = pageStream->getNumChunks();
+        
+        for( int i=0; i<numChunks; i++ ) {
+            int chunkLength;
+            unsigned char *chunk = pageStream->getChunk( i, &chunkLength );
             
-            int cacheSeconds = mGenerator->getCacheMaxAge( filePathBuffer );
+            SHA1_Update( &context, chunk, chunkLength );
+            }
+        
+        unsigned char digest[ SHA1_DIGEST_LENGTH ];
+        SHA1_Final( digest, &context );
+        
+        char *digestHex = hexEncode( digest, SHA1_DIGEST_LENGTH );
+        eTag = autoSprintf( "\"%s\"", digestHex );
+        delete [] digestHex;
+        
+        if( useCache ) {
+            // cache needs page in one array
+            body = pageStream->getBytes( &length );
             
-            if( cacheSeconds == 0 ) {
-                sockStream->writeString( "cache-control: no-cache\r\n" );
-                }
-            else {
-                char *cacheString = autoSprintf( 
-                    "cache-control: private, max-age=%d\r\n",
-                    cacheSeconds );
-                
-                sockStream->writeString( cacheString );
+            inCache->put( inPath, body, length, mimeType, eTag, 
+                          inCacheSeconds );
+            }
+        }
+    
+    
+    int maxBuffers = 2;
+    if( body == NULL ) {
+        maxBuffers = 1 + pageStream->getNumChunks();
+        }
+    
+    SocketBuffer *buffers = new SocketBuffer[ maxBuffers ];
+    int numBuffers = 1;
+    
+    char *header;
+
+    char sendBody = false;
+    
+    if( isETagMatch( inIfNoneMatch, eTag ) ) {
+        header = getResponseHeader( "304 Not Modified", inCacheSeconds,
+                                    NULL, -1, eTag, NULL, 
+                                    inKeepAlive );
+        }
+    else {
+        header = getResponseHeader( "200 OK", inCacheSeconds,
+                                    mimeType, length, eTag, NULL, 
+                                    inKeepAlive );
+        
+        sendBody = ! inHeadOnly;
+        }
+    
+    buffers[0].data = (unsigned char*)header;
+    buffers[0].length = strlen( header );
+    
+    if( sendBody ) {
+        if( body != NULL ) {
+            buffers[1].data = body;
+            buffers[1].length = length;
+            numBuffers = 2;
+            }
+        else {
+            // scatter-gather send straight from chunks
+            for( int i=0; i<pageStream->getNumChunks(); i++ ) {
+                SocketBuffer *b = &( buffers[ numBuffers ] );
                 
-                delete [] cacheString;
+                b->data = pageStream->getChunk( i, &( b->length ) );
+                numBuffers++;
                 }
-            
+            }
+        }
+    
+    char sent = sendAll( inSocket, buffers, numBuffers );
+    
+    delete [] buffers;
+    delete [] header;
+    if( body != NULL ) {
+        delete [] body;
+        }
+    if( pageStream != NULL ) {
+        delete pageStream;
+        }
+    delete [] mimeType;
+    delete [] eTag;
+    
+    return sent;
+    }
 
-            char *mimeType = mGenerator->getMimeType( filePathBuffer );
 
-            sockStream->writeString( "Content-Type: " );
-            sockStream->writeString( mimeType );
-            sockStream->writeString( "\r\n" );
-            
-            delete [] mimeType;
 
-            // even if the client requests a keep-alive, we force a close
-            sockStream->writeString( "Connection: close" );
-            
-            // finish header
-            sockStream->writeString( "\r\n\r\n" );
-            
-            // pass it to our page generator, which will send the content
-            mGenerator->generatePage( filePathBuffer, sockStream );
+// true if an Accept-Encoding header value accepts gzip
+static char isGzipAccepted( char *inAcceptEncoding ) {
+    if( inAcceptEncoding == NULL ) {
+        return false;
+        }
+    
+    char *gzip = stringLocateIgnoreCase( inAcceptEncoding, "gzip" );
+    
+    if( gzip == NULL ) {
+        return false;
+        }
+    
+    // refused with a zero quality value, like "gzip;q=0"
+    char *next = &( gzip[4] );
+    
+    while( next[0] == ' ' ) {
+        next = &( next[1] );
+        }
+    
+    if( next[0] == ';' ) {
+        char *q = strstr( next, "q=" );
+        char *comma = strstr( next, "," );
+        
+        if( q != NULL && ( comma == NULL || q < comma ) &&
+            atof( &( q[2] ) ) <= 0 ) {
+            return false;
             }
+        }
+    
+    return true;
+    }
+
+
 
-        delete [] filePathBuffer;  
+char RequestHandlingThread::sendStreamedPage( Socket *inSocket,
+                                              PageGenerator *inGenerator,
+                                              char *inPath,
+                                              char *inAcceptEncoding,
+                                              char inHeadOnly,
+                                              char inChunked,
+                                              char inKeepAlive ) {
+    
+    char compressible = inGenerator->isCompressible( inPath );
+    
+    char gzip = compressible && isGzipAccepted( inAcceptEncoding );
+    
+    SimpleVector<char> extraHeaders;
+    
+    if( inChunked ) {
+        extraHeaders.appendElementString( 
+            "Transfer-Encoding: chunked\r\n" );
+        }
+    if( gzip ) {
+        extraHeaders.appendElementString( "Content-Encoding: gzip\r\n" );
+        }
+    if( compressible ) {
+        // response differs depending on what client accepts
+        extraHeaders.appendElementString( "Vary: Accept-Encoding\r\n" );
+        }
+    
+    char *extraHeadersString = extraHeaders.getElementString();
+    
+    char *mimeType = inGenerator->getMimeType( inPath );
+    
+    // streamed pages may change as they are generated, so never cached
+    char *header = getResponseHeader( "200 OK", 0, mimeType, -1, NULL,
+                                      extraHeadersString, inKeepAlive );
+    
+    delete [] mimeType;
+    delete [] extraHeadersString;
+    
+    char sent;
+    
+    if( inHeadOnly ) {
+        SocketBuffer headerBuffer = { (unsigned char*)header, 
+                                      (int)strlen( header ) };
+    
+        sent = sendAll( inSocket, &headerBuffer, 1 );
         }
     else {
-        delete [] requestBuffer;
-        delete [] charRead;
+        ResponseStream stream( inSocket, header, inChunked, gzip );
+        
+        inGenerator->generatePage( inPath, &stream );
+        
+        sent = stream.finish();
         }
-
     
-    delete sockStream;
-    delete mSocket;
+    delete [] header;
+    
+    return sent;
+    }
 
+
+
+char RequestHandlingThread::sendAll( Socket *inSocket,
+                                     SocketBuffer *inBuffers, 
+                                     int inNumBuffers ) {
+    int first = 0;
     
-    // flag that we're done
-    mDoneLock->lock();
-    mDone = true;
-    mDoneLock->unlock();
+    while( true ) {
+        while( first < inNumBuffers && inBuffers[ first ].length == 0 ) {
+            first++;
+            }
+        
+        if( first == inNumBuffers ) {
+            return true;
+            }
+
+        // no delay, since whole response is handed over at once
+        int numSent = inSocket->sendv( &( inBuffers[ first ] ), 
+                                       inNumBuffers - first,
+                                       true, false );
+        
+        if( numSent <= 0 ) {
+            return false;
+            }
+        
+        // skip past what was sent
+        while( numSent > 0 ) {
+            SocketBuffer *b = &( inBuffers[ first ] );
+            
+            if( numSent >= b->length ) {
+                numSent -= b->length;
+                first++;
+                }
+            else {
+                b->data = &( b->data[ numSent ] );
+                b->length -= numSent;
+                numSent = 0;
+                }
+            }
+        }
     }
 
 
 
-void RequestHandlingThread::sendNotFoundPage(
-    SocketStream *inStream,
-    char *inFileName ) {
+char RequestHandlingThread::sendNotFoundPage(
+    Socket *inSocket,
+    char *inFileName,
+    char inKeepAlive ) {
 
     // example "not found" response
     /*
@@ -341,31 +920,47 @@ void RequestHandlingThread::sendNotFoundPage(
       The requested URL /fjfj was not found on this server.
       </BODY></HTML>
     */
-    char *buffer = new char[500];
+    char *body;
 
     if( inFileName != NULL ) {
-        sprintf( buffer,
-                 "HTTP/1.0 404 Not Found\r\n\r\n<HTML>"
-                 "<BODY><H1>404 Not Found</H1>The requested file "
-                 "<b>%s</b> was not found</BODY></HTML>\r\n",
-                 inFileName );
+        body = autoSprintf( "<HTML>"
+                            "<BODY><H1>404 Not Found</H1>The requested file "
+                            "<b>%s</b> was not found</BODY></HTML>\r\n",
+                            inFileName );
         }
     else {
-        sprintf( buffer,
-                 "HTTP/1.0 404 Not Found\r\n\r\n<HTML>"
-                 "<BODY><H1>404 Not Found</H1>The requested "
-                 "file was not found</BODY></HTML>\r\n" );
+        body = stringDuplicate( "<HTML>"
+                                "<BODY><H1>404 Not Found</H1>The requested "
+                                "file was not found</BODY></HTML>\r\n" );
         }
 
-    inStream->write( (unsigned char *)buffer, strlen( buffer ) );
-
-    delete [] buffer;
+    const char *connection = "close";
+    if( inKeepAlive ) {
+        connection = "keep-alive";
+        }
+    
+    char *header = autoSprintf( "HTTP/1.1 404 Not Found\r\n"
+                                "Content-Type: text/html\r\n"
+                                "Content-Length: %d\r\n"
+                                "Connection: %s\r\n\r\n",
+                                (int)strlen( body ), connection );
+
+    SocketBuffer buffers[2] = { 
+        { (unsigned char *)header, (int)strlen( header ) },
+        { (unsigned char *)body, (int)strlen( body ) } };
+    
+    char sent = sendAll( inSocket, buffers, 2 );
+    
+    delete [] header;
+    delete [] body;
+    
+    return sent;
     }
 
 
 
 void RequestHandlingThread::sendBadRequest(
-    SocketStream *inStream ) {
+    Socket *inSocket ) {
 
     // exampl "bad request" response
     /*
@@ -375,16 +970,24 @@ void RequestHandlingThread::sendBadRequest(
       </BODY></HTML>
     */
 
-    char *buffer = new char[500];
+    const char *body = 
+        "<HTML><BODY><H1>400 Bad Request</H1>"
+        "Your client has issued a malformed or illegal request."
+        "</BODY></HTML>\r\n";
 
-    sprintf( buffer,
-             "<HTML><BODY><H1>400 Bad Request</H1>"
-             "Your client has issued a malformed or illegal request."
-             "</BODY></HTML>\r\n" );
-
-    inStream->write( (unsigned char *)buffer, strlen( buffer ) );
-
-    delete [] buffer;
+    char *header = autoSprintf( "HTTP/1.1 400 Bad Request\r\n"
+                                "Content-Type: text/html\r\n"
+                                "Content-Length: %d\r\n"
+                                "Connection: close\r\n\r\n",
+                                (int)strlen( body ) );
+    
+    SocketBuffer buffers[2] = { 
+        { (unsigned char *)header, (int)strlen( header ) },
+        { (unsigned char *)body, (int)strlen( body ) } };
+    
+    sendAll( inSocket, buffers, 2 );
+    
+    delete [] header;
     }
 
 
@@ -12,6 +12,14 @@
  *
  * 2003-September-5   Jason Rohrer
  * Moved into minorGems.
+ *
+ * 2026-October-14   Jason Rohrer
+ * Added static isPermitted and respond for WebServer worker pool.
+ * Added keep-alive, files sent with sendfile, and PageCache.
+ * Added isRequestPermitted for request rate limits.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Added streamed pages.  Made sendAll public for ResponseStream.
  */
 
 
@@ -21,6 +29,7 @@
 
 #include "PageGenerator.h"
 #include "ConnectionPermissionHandler.h"
+#include "PageCache.h"
 
 
 #include "minorGems/io/file/File.h"
@@ -32,6 +41,8 @@
 #include "minorGems/system/Thread.h"
 #include "minorGems/system/MutexLock.h"
 
+#include "minorGems/util/SimpleVector.h"
+
 #include <string.h>
 #include <stdio.h>
 
@@ -39,9 +50,20 @@
 
 #define REQUEST_HANDLING_THREAD_BUFFER_SIZE 4096
 
+// connections are closed after this long without a new request
+#define REQUEST_HANDLING_THREAD_KEEP_ALIVE_SECONDS 15
+
+// requests longer than this are refused
+#define REQUEST_HANDLING_THREAD_MAX_REQUEST_LENGTH 65536
+
+
+
 /**
  * Request handler for WebServer.
  *
+ * Speaks HTTP/1.1, keeping connections open for more requests unless
+ * the client asks otherwise.
+ *
  * @author Jason Rohrer.
  */
 class RequestHandlingThread : public Thread {
@@ -63,11 +85,14 @@ class RequestHandlingThread : public Thread {
          * @param inConnectionPermissionHandler the class that will
          *   grant connection permissions
          *   Is not destroyed by this class.
+         * @param inCache cache for generated pages, or NULL.
+         *   Is not destroyed by this class.
          */
         RequestHandlingThread(
             Socket *inSocket,
             PageGenerator *inGenerator,
-            ConnectionPermissionHandler *inConnectionPermissionHandler);
+            ConnectionPermissionHandler *inConnectionPermissionHandler,
+            PageCache *inCache = NULL );
 
 
         
@@ -98,12 +123,112 @@ class RequestHandlingThread : public Thread {
         // implements the Thread interface
         virtual void run();
 
+
+
+        /**
+         * Checks whether a connection is permitted, printing why not.
+         *
+         * A connection over its host's rate limit is sent
+         * 429 Too Many Requests (without blocking).
+         *
+         * @param inSocket the connection.  Destroyed by caller.
+         * @param inConnectionPermissionHandler the class that will
+         *   grant connection permissions.  Destroyed by caller.
+         *
+         * @return true if permitted.
+         */
+        static char isPermitted(
+            Socket *inSocket,
+            ConnectionPermissionHandler *inConnectionPermissionHandler );
+
+
+
+        /**
+         * Checks a request against its host's rate limit, sending
+         * 429 Too Many Requests if over.
+         *
+         * @param inAddress the connection's remote address, or NULL if
+         *   unknown (always permitted).  Destroyed by caller.
+         * @param inSocket the connection.  Destroyed by caller.
+         * @param inConnectionPermissionHandler the class that will
+         *   grant connection permissions.  Destroyed by caller.
+         *
+         * @return true if permitted.  If not, the connection should
+         *   be closed.
+         */
+        static char isRequestPermitted(
+            HostAddress *inAddress, Socket *inSocket,
+            ConnectionPermissionHandler *inConnectionPermissionHandler );
+
+        
+
+        /**
+         * Takes the next whole request header from the front of a
+         * buffer of received data.
+         *
+         * @param ioBuffer the received data.  The request is removed,
+         *   leaving any data received after it.  Destroyed by caller.
+         *
+         * @return the request, \0-terminated, or NULL if a whole
+         *   request header hasn't been received yet.
+         *   Destroyed by caller if non-NULL.
+         */
+        static char *takeRequest( SimpleVector<char> *ioBuffer );
+        
+
+
+        /**
+         * Sends the response to a request that has already been received.
+         *
+         * GET and HEAD are supported.
+         *
+         * Responses to generated pages carry an ETag (from the page's
+         * SHA1), and files an ETag from their size and modification
+         * time, so that a repeated request with a matching If-None-Match
+         * gets 304 Not Modified with no body.
+         *
+         * Generated pages with a cache max age are also kept in inCache
+         * for that long.
+         *
+         * Pages that PageGenerator::isStreamed are instead sent as they
+         * are generated, through a ResponseStream.
+         *
+         * @param inRequest the request, \0-terminated.  Destroyed by
+         *   caller.
+         * @param inSocket the socket to send the response to.
+         *   Destroyed by caller.
+         * @param inGenerator the class that will generate the
+         *   page content.  Destroyed by caller.
+         * @param inCache cache for generated pages, or NULL.
+         *   Destroyed by caller.
+         *
+         * @return true if the connection can be kept open for another
+         *   request.
+         */
+        static char respond( char *inRequest, Socket *inSocket,
+                             PageGenerator *inGenerator,
+                             PageCache *inCache );
+
+        
+        /**
+         * Sends all of several buffers, blocking.
+         *
+         * @param inSocket the socket to send to.  Destroyed by caller.
+         * @param inBuffers the buffers, which are advanced past what is
+         *   sent.  Destroyed by caller.
+         * @param inNumBuffers the number of buffers.
+         *
+         * @return true on success.
+         */
+        static char sendAll( Socket *inSocket,
+                             SocketBuffer *inBuffers, int inNumBuffers );
         
         
     private:
         Socket *mSocket;
         PageGenerator *mGenerator;
         ConnectionPermissionHandler *mConnectionPermissionHandler;
+        PageCache *mCache;
         
         MutexLock *mDoneLock;
         char mDone;
@@ -113,21 +238,62 @@ class RequestHandlingThread : public Thread {
         /**
          * Sends an HTTP "not found" message with a "not found" web page.
          *
-         * @param inStream the stream to send the not found page to.
+         * @param inSocket the socket to send the not found page to.
          * @param inFileName the name of the requested file,
          *   or NULL.
+         * @param inKeepAlive true to leave the connection open.
+         *
+         * @return true if sent.
          */
-        void sendNotFoundPage( SocketStream *inStream,
-                               char *inFileName );
+        static char sendNotFoundPage( Socket *inSocket,
+                                      char *inFileName,
+                                      char inKeepAlive );
 
         
         
+        // sends 429 Too Many Requests
+        static void sendTooManyRequests( Socket *inSocket, 
+                                         char inAllowedToBlock );
+
+
+
         /**
          * Sends a "bad request" web page.
          *
-         * @param inStream the stream to send the page to.
+         * @param inSocket the socket to send the page to.
          */
-        void sendBadRequest( SocketStream *inStream );
+        static void sendBadRequest( Socket *inSocket );
+
+
+
+        // these send a page, returning true if sent
+        
+        static char sendFilePage( Socket *inSocket,
+                                  PageGenerator *inGenerator,
+                                  char *inPath, char *inFilePath,
+                                  char *inIfNoneMatch,
+                                  int inCacheSeconds,
+                                  char inHeadOnly,
+                                  char inKeepAlive );
+
+        static char sendGeneratedPage( Socket *inSocket,
+                                       PageGenerator *inGenerator,
+                                       PageCache *inCache,
+                                       char *inPath,
+                                       char *inIfNoneMatch,
+                                       int inCacheSeconds,
+                                       char inHeadOnly,
+                                       char inKeepAlive );
+
+
+        
+        static char sendStreamedPage( Socket *inSocket,
+                                      PageGenerator *inGenerator,
+                                      char *inPath,
+                                      char *inAcceptEncoding,
+                                      char inHeadOnly,
+                                      char inChunked,
+                                      char inKeepAlive );
 
         
         
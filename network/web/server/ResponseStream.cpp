@@ -0,0 +1,229 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+
+
+#include "ResponseStream.h"
+#include "RequestHandlingThread.h"
+
+#include "minorGems/util/stringUtils.h"
+
+
+// miniz's zlib names are macros that would clash with ours
+#define MINIZ_NO_ZLIB_COMPATIBLE_NAMES
+
+// only the declarations, miniz.c itself is compiled into encodingUtils
+#include "minorGems/formats/miniz.h"
+
+
+
+// gzip member header:  magic, deflate, no flags, no modification time,
+// no extra flags, unknown OS
+static unsigned char gzipHeader[10] =
+    { 0x1F, 0x8B, 8, 0, 0, 0, 0, 0, 0, 0xFF };
+
+
+
+ResponseStream::ResponseStream( Socket *inSocket, const char *inHeader,
+                                char inChunked, char inGzip )
+        : mSocket( inSocket ),
+          mHeader( stringDuplicate( inHeader ) ),
+          mChunked( inChunked ),
+          mCompressor( NULL ),
+          mCRC( MZ_CRC32_INIT ),
+          mUncompressedLength( 0 ),
+          mFailed( false ) {
+
+    if( inGzip ) {
+        // level 1 is more than twice as fast as the default, and
+        // pages are usually text that compresses well anyway
+        mCompressor = new ZipCompressor( 1, ZIP_DEFAULT_STRATEGY,
+                                         NULL, 0, true );
+
+        mBuffer.push_back( gzipHeader, sizeof( gzipHeader ) );
+        }
+    }
+
+
+
+ResponseStream::~ResponseStream() {
+    if( mHeader != NULL ) {
+        delete [] mHeader;
+        }
+    if( mCompressor != NULL ) {
+        delete mCompressor;
+        }
+    }
+
+
+
+long ResponseStream::write( unsigned char *inBuffer, long inNumBytes ) {
+    if( mFailed ) {
+        return -1;
+        }
+
+    if( mCompressor == NULL ) {
+        if( mBuffer.size() + inNumBytes < RESPONSE_STREAM_CHUNK_SIZE ) {
+            mBuffer.push_back( inBuffer, (int)inNumBytes );
+            }
+        // big enough for a chunk, send without copying
+        else if( ! sendChunk( inBuffer, (int)inNumBytes, false ) ) {
+            return -1;
+            }
+
+        return inNumBytes;
+        }
+
+
+    // feed compressor a chunk at a time, so that its output never
+    // piles up past a chunk or so
+    long numLeft = inNumBytes;
+    unsigned char *data = inBuffer;
+
+    while( numLeft > 0 ) {
+        int length = RESPONSE_STREAM_CHUNK_SIZE;
+        if( numLeft < length ) {
+            length = (int)numLeft;
+            }
+
+        mCRC = mz_crc32( mCRC, data, length );
+        mUncompressedLength += length;
+
+        if( ! mCompressor->compress( data, length, &mBuffer ) ) {
+            mFailed = true;
+            return -1;
+            }
+
+        if( mBuffer.size() >= RESPONSE_STREAM_CHUNK_SIZE &&
+            ! sendChunk( NULL, 0, false ) ) {
+            return -1;
+            }
+
+        data = &( data[ length ] );
+        numLeft -= length;
+        }
+
+    return inNumBytes;
+    }
+
+
+
+char ResponseStream::flush() {
+    if( mFailed ) {
+        return false;
+        }
+
+    if( mCompressor != NULL &&
+        ! mCompressor->compress( NULL, 0, &mBuffer, ZIP_SYNC_FLUSH ) ) {
+        mFailed = true;
+        return false;
+        }
+
+    return sendChunk( NULL, 0, false );
+    }
+
+
+
+char ResponseStream::finish() {
+    if( mFailed ) {
+        return false;
+        }
+
+    if( mCompressor != NULL ) {
+        if( ! mCompressor->finish( &mBuffer ) ) {
+            mFailed = true;
+            return false;
+            }
+
+        // trailer:  CRC-32 and length mod 2^32, little-endian
+        unsigned long trailerValues[2] = { mCRC, mUncompressedLength };
+
+        for( int v=0; v<2; v++ ) {
+            for( int b=0; b<4; b++ ) {
+                mBuffer.push_back(
+                    (unsigned char)( ( trailerValues[v] >> ( 8 * b ) )
+                                     & 0xFF ) );
+                }
+            }
+        }
+
+    return sendChunk( NULL, 0, true );
+    }
+
+
+
+char ResponseStream::sendChunk( unsigned char *inData, int inLength,
+                                char inLast ) {
+    if( mFailed ) {
+        return false;
+        }
+
+    int chunkLength = mBuffer.size() + inLength;
+
+    // header, chunk size line, buffered data, inData, chunk end,
+    // body end
+    SocketBuffer buffers[6];
+    int numBuffers = 0;
+
+    if( mHeader != NULL ) {
+        buffers[ numBuffers ].data = (unsigned char *)mHeader;
+        buffers[ numBuffers ].length = strlen( mHeader );
+        numBuffers++;
+        }
+
+    // an empty chunk would end a chunked body
+    char chunkSizeLine[20];
+
+    if( mChunked && chunkLength > 0 ) {
+        sprintf( chunkSizeLine, "%x\r\n", chunkLength );
+
+        buffers[ numBuffers ].data = (unsigned char *)chunkSizeLine;
+        buffers[ numBuffers ].length = strlen( chunkSizeLine );
+        numBuffers++;
+        }
+
+    if( mBuffer.size() > 0 ) {
+        buffers[ numBuffers ].data = mBuffer.getElementFast( 0 );
+        buffers[ numBuffers ].length = mBuffer.size();
+        numBuffers++;
+        }
+
+    if( inLength > 0 ) {
+        buffers[ numBuffers ].data = inData;
+        buffers[ numBuffers ].length = inLength;
+        numBuffers++;
+        }
+
+    if( mChunked && chunkLength > 0 ) {
+        buffers[ numBuffers ].data = (unsigned char *)"\r\n";
+        buffers[ numBuffers ].length = 2;
+        numBuffers++;
+        }
+
+    if( mChunked && inLast ) {
+        buffers[ numBuffers ].data = (unsigned char *)"0\r\n\r\n";
+        buffers[ numBuffers ].length = 5;
+        numBuffers++;
+        }
+
+    char sent = RequestHandlingThread::sendAll( mSocket,
+                                                buffers, numBuffers );
+
+    if( mHeader != NULL ) {
+        delete [] mHeader;
+        mHeader = NULL;
+        }
+
+    // keep vector's space for next chunk
+    mBuffer.shrink( 0 );
+
+    if( ! sent ) {
+        mFailed = true;
+        }
+
+    return sent;
+    }
@@ -0,0 +1,117 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+
+
+#ifndef RESPONSE_STREAM_INCLUDED
+#define RESPONSE_STREAM_INCLUDED
+
+
+#include "minorGems/io/OutputStream.h"
+#include "minorGems/network/Socket.h"
+#include "minorGems/formats/ZipStream.h"
+#include "minorGems/util/SimpleVector.h"
+
+
+
+// body data is sent in chunks of about this size
+#define RESPONSE_STREAM_CHUNK_SIZE 16384
+
+
+
+/**
+ * Stream that sends a response body straight to a connection as it is
+ * written, for pages streamed by WebServer (see
+ * PageGenerator::isStreamed).
+ *
+ * Written data is gathered into chunks of about
+ * RESPONSE_STREAM_CHUNK_SIZE, so memory use doesn't grow with the size of
+ * the body.  Chunks are sent with blocking sends, so a generator that
+ * writes faster than the client reads is held back by the connection.
+ *
+ * The body can be framed with HTTP/1.1 chunked transfer encoding, or, for
+ * HTTP/1.0 clients, sent as-is and ended by closing the connection.  It
+ * can also be gzipped on the fly.
+ *
+ * After a send fails, writes return -1 without sending anything, so that
+ * long generators can stop early.
+ *
+ * @author Jason Rohrer
+ */
+class ResponseStream : public OutputStream {
+
+    public:
+
+        /**
+         * Constructs a stream.
+         *
+         * @param inSocket the connection to send to.
+         *   Destroyed by caller after this stream.
+         * @param inHeader the response header, sent along with the
+         *   first chunk of the body.  Copied internally, destroyed by
+         *   caller.
+         * @param inChunked true to use chunked transfer encoding.
+         * @param inGzip true to gzip the body.
+         */
+        ResponseStream( Socket *inSocket, const char *inHeader,
+                        char inChunked, char inGzip );
+
+        virtual ~ResponseStream();
+
+
+        /**
+         * Sends anything still buffered, and ends the body.
+         *
+         * Must be called once, after the last write.
+         *
+         * @return true if the whole response was sent.
+         */
+        char finish();
+
+
+        /**
+         * Sends what has been written so far without waiting to fill a
+         * chunk, for generators that pause between parts of a page.
+         *
+         * @return true on success.
+         */
+        char flush();
+
+
+        // implements the OutputStream interface
+        virtual long write( unsigned char *inBuffer, long inNumBytes );
+
+
+    protected:
+
+        Socket *mSocket;
+
+        char *mHeader;
+
+        char mChunked;
+
+        // NULL if not gzipped
+        ZipCompressor *mCompressor;
+        unsigned long mCRC;
+        unsigned long mUncompressedLength;
+
+        // body data not yet sent (compressed, if gzipped)
+        SimpleVector<unsigned char> mBuffer;
+
+        char mFailed;
+
+
+        // sends mBuffer followed by inData as one chunk, along with
+        // the header, if not yet sent, and the end of the body if
+        // inLast is true
+        char sendChunk( unsigned char *inData, int inLength, char inLast );
+
+    };
+
+
+
+#endif
@@ -19,6 +19,11 @@
  *
  * 2003-September-5   Jason Rohrer
  * Moved into minorGems.
+ *
+ * 2026-October-14   Jason Rohrer
+ * Added worker pool mode.
+ * Added keep-alive and PageCache.
+ * Added request rate limits.
  */
 
 
@@ -26,19 +31,228 @@
 #include "WebServer.h"
 
 
+#include "minorGems/network/SocketPoll.h"
+#include "minorGems/system/Time.h"
 #include "minorGems/util/log/AppLog.h"
 
 
 
-WebServer::WebServer( int inPort, PageGenerator *inGenerator )
+// new connections that don't send a whole request in this time are 
+// closed (kept-alive connections get 
+// REQUEST_HANDLING_THREAD_KEEP_ALIVE_SECONDS)
+#define WEB_SERVER_REQUEST_TIMEOUT_SECONDS 30
+
+// in worker pool mode, how long a worker waits for the next request on 
+// a kept-alive connection before handing it back to the poll thread
+// (a busy client sends it right away, and this saves the round trip
+// through the poll thread)
+#define WEB_SERVER_KEEP_ALIVE_LINGER_MS 5
+
+
+
+class WebServerWorker : public Thread {
+
+    public:
+
+        WebServerWorker( WebServer *inServer )
+                : mServer( inServer ) {
+            start();
+            }
+
+        ~WebServerWorker() {
+            join();
+            }
+
+
+        void run() {
+            WebServerJob job;
+
+            unsigned char *readBuffer = 
+                new unsigned char[ REQUEST_HANDLING_THREAD_BUFFER_SIZE ];
+
+            while( mServer->getNextJob( &job ) ) {
+                
+                char *request = job.request;
+                
+                HostAddress *remoteAddress = 
+                    job.sock->getRemoteHostAddress();
+
+                char keepAlive = true;
+
+                while( keepAlive && request != NULL ) {
+                    keepAlive = 
+                        RequestHandlingThread::isRequestPermitted(
+                            remoteAddress, job.sock, 
+                            mServer->mConnectionPermissionHandler );
+                    
+                    if( keepAlive ) {
+                        keepAlive = RequestHandlingThread::respond( 
+                            request, job.sock, mServer->mPageGenerator,
+                            &( mServer->mPageCache ) );
+                        }
+                
+                    delete [] request;
+                    request = NULL;
+                    
+                    if( ! keepAlive ) {
+                        break;
+                        }
+                    
+                    request = 
+                        RequestHandlingThread::takeRequest( job.received );
+                    
+                    if( request == NULL ) {
+                        int numRead = job.sock->receive( 
+                            readBuffer, REQUEST_HANDLING_THREAD_BUFFER_SIZE,
+                            WEB_SERVER_KEEP_ALIVE_LINGER_MS );
+                        
+                        if( numRead == -2 ) {
+                            // client quiet, let poll thread watch it
+                            break;
+                            }
+                        if( numRead <= 0 ) {
+                            keepAlive = false;
+                            break;
+                            }
+                        
+                        job.received->appendArray( (char*)readBuffer, 
+                                                   numRead );
+                        
+                        request = RequestHandlingThread::takeRequest( 
+                            job.received );
+                        
+                        if( request == NULL ) {
+                            // only part of it, poll thread gets rest
+                            break;
+                            }
+                        }
+                    }
+
+                if( remoteAddress != NULL ) {
+                    delete remoteAddress;
+                    }
+                
+                if( keepAlive ) {
+                    mServer->returnConnection( job.sock, job.received );
+                    }
+                else {
+                    delete job.sock;
+                    delete job.received;
+                    }
+                }
+            
+            delete [] readBuffer;
+            }
+
+
+    protected:
+        
+        WebServer *mServer;
+        
+    };
+
+
+
+// a connection whose request is still being read
+class WebServerConnection {
+    public:
+        
+        // takes ownership of inReceived if non-NULL
+        WebServerConnection( Socket *inSocket, 
+                             SimpleVector<char> *inReceived = NULL,
+                             int inTimeoutSeconds = 
+                                 WEB_SERVER_REQUEST_TIMEOUT_SECONDS )
+                : mSocket( inSocket ),
+                  mReceived( inReceived ),
+                  mStartTime( Time::getCurrentTime() ),
+                  mTimeoutSeconds( inTimeoutSeconds ) {
+            
+            if( mReceived == NULL ) {
+                mReceived = new SimpleVector<char>();
+                }
+            }
+
+        ~WebServerConnection() {
+            if( mReceived != NULL ) {
+                delete mReceived;
+                }
+            }
+
+        
+        // returns 1 if whole request read, -1 on error, 0 if more to come
+        int readAvailable() {
+            unsigned char buffer[ REQUEST_HANDLING_THREAD_BUFFER_SIZE ];
+            
+            while( true ) {
+                int numRead = mSocket->receive( buffer, sizeof( buffer ), 0 );
+            
+                if( numRead == -2 ) {
+                    return 0;
+                    }
+                if( numRead <= 0 ) {
+                    return -1;
+                    }
+                
+                int oldSize = mReceived->size();
+                
+                mReceived->appendArray( (char*)buffer, numRead );
+                
+                // look for blank line at end of header, which may
+                // straddle what we had before
+                int searchStart = oldSize - 3;
+                if( searchStart < 0 ) {
+                    searchStart = 0;
+                    }
+                
+                char *received = mReceived->getElementFast( 0 );
+                
+                for( int i=searchStart; i <= mReceived->size() - 4; i++ ) {
+                    if( memcmp( &( received[i] ), "\r\n\r\n", 4 ) == 0 ) {
+                        return 1;
+                        }
+                    }
+                
+                if( mReceived->size() > 
+                    REQUEST_HANDLING_THREAD_MAX_REQUEST_LENGTH ) {
+                    return -1;
+                    }
+                }
+            }
+
+        
+        Socket *mSocket;
+        
+        SimpleVector<char> *mReceived;
+        
+        double mStartTime;
+        int mTimeoutSeconds;
+    };
+
+
+
+
+WebServer::WebServer( int inPort, PageGenerator *inGenerator,
+                      int inNumWorkerThreads, int inMaxQueuedRequests )
     : mPortNumber( inPort ), mMaxQueuedConnections( 100 ),
-      mThreadHandler( new ThreadHandlingThread() ),
+      mThreadHandler( NULL ),
       mPageGenerator( inGenerator ),
-      mConnectionPermissionHandler( new ConnectionPermissionHandler() ) {
+      mConnectionPermissionHandler( new ConnectionPermissionHandler() ),
+      mNumWorkerThreads( inNumWorkerThreads ),
+      mMaxQueuedRequests( inMaxQueuedRequests ),
+      mWorkersStopping( false ) {
 
     
     mServer = new SocketServer( mPortNumber, mMaxQueuedConnections );
 
+    if( mNumWorkerThreads > 0 ) {
+        for( int i=0; i<mNumWorkerThreads; i++ ) {
+            mWorkers.push_back( new WebServerWorker( this ) );
+            }
+        }
+    else {
+        mThreadHandler = new ThreadHandlingThread();
+        }
+    
     this->start();
     }
 
@@ -50,7 +264,37 @@ WebServer::~WebServer() {
 
     delete mServer;
     
-    delete mThreadHandler;
+    if( mThreadHandler != NULL ) {
+        delete mThreadHandler;
+        }
+    
+
+    mQueueLock.lock();
+    mWorkersStopping = true;
+    mQueueLock.unlock();
+    
+    // each worker passes this on before exiting
+    mQueueSemaphore.signal();
+    
+    // destructors join
+    for( int i=0; i<mWorkers.size(); i++ ) {
+        delete mWorkers.getElementDirect( i );
+        }
+    
+    for( int i=0; i<mQueue.size(); i++ ) {
+        WebServerJob *job = mQueue.getElement( i );
+        
+        delete job->sock;
+        delete [] job->request;
+        delete job->received;
+        }
+
+    for( int i=0; i<mReturned.size(); i++ ) {
+        WebServerJob *job = mReturned.getElement( i );
+        
+        delete job->sock;
+        delete job->received;
+        }
     
     delete mPageGenerator;
 
@@ -71,6 +315,12 @@ void WebServer::run() {
 
     delete [] logMessage;
 
+    
+    if( mNumWorkerThreads > 0 ) {
+        runWorkerPool();
+        return;
+        }
+    
 
     char acceptFailed = false;
     
@@ -98,7 +348,8 @@ void WebServer::run() {
         
             RequestHandlingThread *thread =
                 new RequestHandlingThread( sock, mPageGenerator,
-                                           mConnectionPermissionHandler );
+                                           mConnectionPermissionHandler,
+                                           &mPageCache );
             
             thread->start();
             
@@ -114,3 +365,229 @@ void WebServer::run() {
         }
     
     }
+
+
+
+void WebServer::runWorkerPool() {
+    
+    SocketPoll poll;
+
+    poll.addSocketServer( mServer );
+    
+    SimpleVector<WebServerConnection*> connections;
+    
+    double lastTimeoutCheckTime = Time::getCurrentTime();
+    
+    SocketOrServer *ready[ 64 ];
+    
+
+    while( !isStopped() ) {
+        
+        // watch kept-alive connections handed back by workers
+        mQueueLock.lock();
+        
+        for( int i=0; i<mReturned.size(); i++ ) {
+            WebServerJob *job = mReturned.getElement( i );
+            
+            WebServerConnection *connection = 
+                new WebServerConnection( 
+                    job->sock, job->received,
+                    REQUEST_HANDLING_THREAD_KEEP_ALIVE_SECONDS );
+            
+            connections.push_back( connection );
+            poll.addSocket( job->sock, connection );
+            }
+        mReturned.deleteAll();
+
+        mQueueLock.unlock();
+        
+
+        // 10 ms
+        // short, so that handed-back connections are watched again soon
+        int numReady = poll.wait( ready, 64, 10 );
+
+        for( int r=0; r<numReady; r++ ) {
+            
+            if( ! ready[r]->isSocket ) {
+                // accept all that are waiting
+                while( true ) {
+                    char timedOut;
+                
+                    Socket *sock = 
+                        mServer->acceptConnection( 0, &timedOut );
+                
+                    if( sock == NULL ) {
+                        if( ! timedOut ) {
+                            AppLog::error( 
+                                "WebServer", 
+                                "Accepting a connection failed." );
+                            }
+                        break;
+                        }
+
+                    if( ! RequestHandlingThread::isPermitted( 
+                            sock, mConnectionPermissionHandler ) ) {
+                        delete sock;
+                        continue;
+                        }
+                
+                    WebServerConnection *connection = 
+                        new WebServerConnection( sock );
+                
+                    connections.push_back( connection );
+                    poll.addSocket( sock, connection );
+                    }
+                continue;
+                }
+            
+            
+            WebServerConnection *connection = 
+                (WebServerConnection *)( ready[r]->otherData );
+            
+            int result = connection->readAvailable();
+            
+            if( result == 0 ) {
+                continue;
+                }
+            
+            poll.removeSocket( connection->mSocket );
+            connections.deleteElementEqualTo( connection );
+            
+            if( result == 1 ) {
+                char *request = 
+                    RequestHandlingThread::takeRequest( 
+                        connection->mReceived );
+                
+                if( queueJob( connection->mSocket, request,
+                              connection->mReceived ) ) {
+                    // job owns it now
+                    connection->mReceived = NULL;
+                    }
+                else {
+                    AppLog::warning( "WebServer", 
+                                     "Request queue full, refusing." );
+                    
+                    const char *busy = 
+                        "HTTP/1.0 503 Service Unavailable\r\n"
+                        "Connection: close\r\n\r\n";
+                    
+                    connection->mSocket->send( (unsigned char *)busy, 
+                                               strlen( busy ), 
+                                               false, false );
+                    delete connection->mSocket;
+                    delete [] request;
+                    }
+                }
+            else {
+                delete connection->mSocket;
+                }
+            
+            delete connection;
+            }
+
+
+        double curTime = Time::getCurrentTime();
+        
+        if( curTime - lastTimeoutCheckTime > 1 ) {
+            lastTimeoutCheckTime = curTime;
+            
+            for( int i=0; i<connections.size(); i++ ) {
+                WebServerConnection *connection = 
+                    connections.getElementDirect( i );
+                
+                if( curTime - connection->mStartTime > 
+                    connection->mTimeoutSeconds ) {
+                    
+                    poll.removeSocket( connection->mSocket );
+                    delete connection->mSocket;
+                    delete connection;
+                    
+                    connections.deleteElement( i );
+                    i--;
+                    }
+                }
+            }
+        }
+    
+
+    AppLog::info( "WebServer", "Received stop signal." );
+    
+    for( int i=0; i<connections.size(); i++ ) {
+        WebServerConnection *connection = connections.getElementDirect( i );
+        
+        poll.removeSocket( connection->mSocket );
+        delete connection->mSocket;
+        delete connection;
+        }
+    
+    poll.removeSocketServer( mServer );
+    }
+
+
+
+char WebServer::queueJob( Socket *inSocket, char *inRequest,
+                          SimpleVector<char> *inReceived ) {
+    mQueueLock.lock();
+    
+    if( mQueue.size() >= mMaxQueuedRequests ) {
+        mQueueLock.unlock();
+        return false;
+        }
+    
+    WebServerJob job = { inSocket, inRequest, inReceived };
+    
+    mQueue.push_back( job );
+    
+    mQueueLock.unlock();
+
+    mQueueSemaphore.signal();
+    
+    return true;
+    }
+
+
+
+void WebServer::returnConnection( Socket *inSocket, 
+                                  SimpleVector<char> *inReceived ) {
+    mQueueLock.lock();
+    
+    WebServerJob job = { inSocket, NULL, inReceived };
+    
+    mReturned.push_back( job );
+    
+    mQueueLock.unlock();
+    }
+
+
+
+char WebServer::getNextJob( WebServerJob *outJob ) {
+    while( true ) {
+        mQueueSemaphore.wait();
+        
+        mQueueLock.lock();
+        
+        if( mWorkersStopping ) {
+            mQueueLock.unlock();
+            
+            // pass stop on to next worker
+            mQueueSemaphore.signal();
+            return false;
+            }
+        
+        if( mQueue.size() > 0 ) {
+            *outJob = mQueue.getElementDirect( 0 );
+            mQueue.deleteElement( 0 );
+            
+            if( mQueue.size() > 0 ) {
+                // wake another worker for the rest
+                mQueueSemaphore.signal();
+                }
+            
+            mQueueLock.unlock();
+            return true;
+            }
+        
+        // else a left-over signal
+        mQueueLock.unlock();
+        }
+    }
@@ -15,6 +15,11 @@
  *
  * 2003-September-5   Jason Rohrer
  * Moved into minorGems.
+ *
+ * 2026-October-14   Jason Rohrer
+ * Added worker pool mode.
+ * Added keep-alive and PageCache.
+ * Added request rate limits.
  */
 
 
@@ -25,6 +30,7 @@
 
 #include "PageGenerator.h"
 #include "ConnectionPermissionHandler.h"
+#include "PageCache.h"
 
 #include "minorGems/network/Socket.h"
 #include "minorGems/network/SocketServer.h"
@@ -34,6 +40,10 @@
 #include "ThreadHandlingThread.h"
 
 #include "minorGems/system/StopSignalThread.h"
+#include "minorGems/system/MutexLock.h"
+#include "minorGems/system/BinarySemaphore.h"
+
+#include "minorGems/util/SimpleVector.h"
 
 
 
@@ -41,9 +51,43 @@
 #include <stdio.h>
 
 
+class WebServerWorker;
+
+
+typedef struct WebServerJob {
+        Socket *sock;
+        
+        // NULL for a kept-alive connection handed back to be watched
+        char *request;
+
+        // data received after request
+        SimpleVector<char> *received;
+    } WebServerJob;
+
+
+
 /**
  * A class that implements a basic web server.
  *
+ * By default, each connection gets its own thread.
+ *
+ * In worker pool mode, one thread watches all connections with a
+ * SocketPoll, reading requests without blocking, and a fixed number of
+ * worker threads send the responses.  Requests that arrive while the
+ * queue of requests waiting for a worker is full are answered with
+ * 503 Service Unavailable.  This avoids a thread (and its stack) per
+ * connection under many concurrent requests.
+ *
+ * Either way, connections are kept alive for more requests (see
+ * RequestHandlingThread), and PageGenerator::generatePage may be called
+ * from several threads at once.
+ *
+ * Generated pages with a cache max age are cached in memory (up to
+ * 4 MiB of them) and served from there until they expire.
+ *
+ * Hosts over the connection or request rate limits of
+ * ConnectionPermissionHandler are sent 429 Too Many Requests.
+ *
  * @author Jason Rohrer.
  */
 class WebServer : public StopSignalThread {
@@ -60,8 +104,15 @@ class WebServer : public StopSignalThread {
          * @param inPort the port to listen on.
          * @param inGenerator the class to use for generating pages.
          *   Will be destroyed when this class is destroyed.
+         * @param inNumWorkerThreads the number of worker threads for
+         *   worker pool mode, or 0 for a thread per connection.
+         *   Defaults to 0.
+         * @param inMaxQueuedRequests in worker pool mode, the most
+         *   requests that can wait for a worker.  Defaults to 100.
          */
-        WebServer( int inPort, PageGenerator *inGenerator );
+        WebServer( int inPort, PageGenerator *inGenerator,
+                   int inNumWorkerThreads = 0,
+                   int inMaxQueuedRequests = 100 );
 
 
 
@@ -79,14 +130,59 @@ class WebServer : public StopSignalThread {
         
     private:
 
+        friend class WebServerWorker;
+        
+        
         int mPortNumber;
         int mMaxQueuedConnections;
 
         SocketServer *mServer;
+
+        // NULL in worker pool mode
         ThreadHandlingThread *mThreadHandler;
 
         PageGenerator *mPageGenerator;
         ConnectionPermissionHandler *mConnectionPermissionHandler;
+
+        PageCache mPageCache;
+
+
+        // worker pool mode
+        int mNumWorkerThreads;
+        int mMaxQueuedRequests;
+        
+        SimpleVector<WebServerWorker*> mWorkers;
+
+        // protected by mQueueLock
+        SimpleVector<WebServerJob> mQueue;
+        char mWorkersStopping;
+        
+        MutexLock mQueueLock;
+
+        // wakes one worker, which passes it on if more jobs are waiting
+        BinarySemaphore mQueueSemaphore;
+
+        // kept-alive connections to be watched again by the poll thread
+        // protected by mQueueLock
+        SimpleVector<WebServerJob> mReturned;
+        
+
+        // accepts connections and reads requests for workers
+        void runWorkerPool();
+
+        // takes ownership of inSocket, inRequest and inReceived, or 
+        // returns false if queue full
+        char queueJob( Socket *inSocket, char *inRequest,
+                       SimpleVector<char> *inReceived );
+
+        // takes ownership of inSocket and inReceived, for a 
+        // kept-alive connection waiting for its next request
+        void returnConnection( Socket *inSocket, 
+                               SimpleVector<char> *inReceived );
+
+        // blocks until a job is waiting
+        // returns false when worker should exit
+        char getNextJob( WebServerJob *outJob );
     };
 
 
@@ -29,12 +29,15 @@
  *
  * 2009-October-5   Jason Rohrer
  * Fixed bug when connect timeout not used.
+ *
+ * 2026-October-14   Jason Rohrer
+ * Host name lookups now go through HostLookupPool and its cache.
  */
 
 
 
 #include "minorGems/network/SocketClient.h"
-#include "minorGems/network/NetworkFunctionLocks.h"
+#include "minorGems/network/HostLookupPool.h"
 #include "minorGems/system/MutexLock.h"
 
 #include <Winsock.h>
@@ -173,8 +176,6 @@ Socket *SocketClient::connectToServer( HostAddress *inAddress,
           Result must be destroyed by caller.
 Adapted from the Unix Socket FAQ		  */
 struct in_addr *nameToAddress( char *inAddress ) {
-	struct hostent *host;
-
     static struct in_addr saddr;
     struct in_addr *copiedSaddr = new struct in_addr;
     
@@ -188,22 +189,23 @@ struct in_addr *nameToAddress( char *inAddress ) {
         return copiedSaddr;
 		}
 
-    // must keep this locked until we are done copying the in_addr out
-    // of the returned hostent
-    NetworkFunctionLocks::mGetHostByNameLock.lock();
+    // shared with other lookups, and cached
+    HostAddress address( stringDuplicate( inAddress ), 0 );
 
     char hostFound = false;
-    host = gethostbyname( inAddress );
-    if( host != NULL ) {
-        
-        memcpy( copiedSaddr,
-                *host->h_addr_list,
-                sizeof( struct in_addr ) );
-        
-        hostFound = true;
-        }
 
-    NetworkFunctionLocks::mGetHostByNameLock.unlock();
+    HostAddress *result = HostLookupPool::lookup( &address );
+
+    if( result != NULL ) {
+        // fails for IPv6 results, which our IPv4 sockets can't use
+        copiedSaddr->s_addr = inet_addr( result->mAddressString );
+
+        if( copiedSaddr->s_addr != INADDR_NONE ) {
+            hostFound = true;
+            }
+
+        delete result;
+        }
 
 
     
@@ -0,0 +1,319 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14   Jason Rohrer
+ * Created.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Support for SOCKET_POLL_NO_READ.
+ * Support for watching SocketUDP.
+ */
+
+
+// implementation of SocketPoll for Windows Vista and later, using WSAPoll
+//
+// Unlike select, WSAPoll takes an array of any length, so there is no
+// FD_SETSIZE limit and no need to rebuild fd_sets on every call.  The array
+// is kept in the same order as mWatchedList, and only changed when sockets
+// are added or removed.
+//
+// WSAPoll reports readiness level-triggered only, so
+// SOCKET_POLL_EDGE_TRIGGERED is ignored.
+//
+// (IOCP would avoid the scan over all sockets, but it completes operations
+//  instead of reporting readiness, which doesn't fit this interface.)
+
+
+// WSAPoll is only declared for Vista and later
+#if !defined( _WIN32_WINNT ) || _WIN32_WINNT < 0x0600
+#undef _WIN32_WINNT
+#define _WIN32_WINNT 0x0600
+#endif
+
+#include <winsock2.h>
+#include <windows.h>
+
+
+#include "minorGems/network/SocketPoll.h"
+
+
+
+static SHORT getPollEvents( int inFlags ) {
+    // WSAPoll fails with WSAEINVAL if POLLPRI is requested, and reports
+    // errors and hang-ups without being asked
+    SHORT events = 0;
+
+    if( ! ( inFlags & SOCKET_POLL_NO_READ ) ) {
+        events |= POLLRDNORM;
+        }
+
+    if( inFlags & SOCKET_POLL_WRITE ) {
+        events |= POLLWRNORM;
+        }
+    return events;
+    }
+
+
+
+static SimpleVector<WSAPOLLFD> *getPollList( SocketPoll *inPoll ) {
+    return (SimpleVector<WSAPOLLFD> *)( inPoll->mNativeObjectPointer );
+    }
+
+
+
+SocketPoll::SocketPoll() {
+	mNativeObjectPointer = (void *)( new SimpleVector<WSAPOLLFD>() );
+
+    mNextSocketOrServer = 0;
+    }
+
+
+
+SocketPoll::~SocketPoll() {
+    delete getPollList( this );
+
+    for( int i=0; i<mWatchedList.size(); i++ ) {
+        SocketOrServer *s = *( mWatchedList.getElement( i ) );
+        delete s;
+        }
+    }
+
+
+
+
+char SocketPoll::addSocket( Socket *inSock, void *inOtherData,
+                            int inFlags ) {
+
+    SocketOrServer *s = new SocketOrServer;
+
+    s->isSocket = true;
+    s->sock = inSock;
+    s->server = NULL;
+    s->udp = NULL;
+    s->otherData = inOtherData;
+    s->flags = inFlags;
+    s->readReady = false;
+    s->writeReady = false;
+
+    mWatchedList.push_back( s );
+
+    WSAPOLLFD p;
+    p.fd = (SOCKET)( inSock->mNativeSocketID );
+    p.events = getPollEvents( inFlags );
+    p.revents = 0;
+
+    getPollList( this )->push_back( p );
+
+    return true;
+    }
+
+
+
+
+char SocketPoll::addSocketServer( SocketServer *inServer, void *inOtherData ) {
+
+    SocketOrServer *s = new SocketOrServer;
+
+    s->isSocket = false;
+    s->sock = NULL;
+    s->server = inServer;
+    s->udp = NULL;
+    s->otherData = inOtherData;
+    s->flags = 0;
+    s->readReady = false;
+    s->writeReady = false;
+
+    mWatchedList.push_back( s );
+
+    // pending connections are reported as POLLRDNORM
+    WSAPOLLFD p;
+    p.fd = (SOCKET)( inServer->mNativeSocketID );
+    p.events = getPollEvents( 0 );
+    p.revents = 0;
+
+    getPollList( this )->push_back( p );
+
+    return true;
+    }
+
+
+char SocketPoll::addSocketUDP( SocketUDP *inSock, void *inOtherData ) {
+
+    SocketOrServer *s = new SocketOrServer;
+
+    s->isSocket = false;
+    s->sock = NULL;
+    s->server = NULL;
+    s->udp = inSock;
+    s->otherData = inOtherData;
+    s->flags = 0;
+    s->readReady = false;
+    s->writeReady = false;
+
+    mWatchedList.push_back( s );
+
+    WSAPOLLFD p;
+    p.fd = (SOCKET)( inSock->getNativeSocketID() );
+    p.events = getPollEvents( 0 );
+    p.revents = 0;
+
+    getPollList( this )->push_back( p );
+
+    return true;
+    }
+
+
+
+char SocketPoll::setSocketFlags( Socket *inSock, int inFlags ) {
+
+    for( int i=0; i<mWatchedList.size(); i++ ) {
+        SocketOrServer *s = *( mWatchedList.getElement( i ) );
+        if( s->sock == inSock ) {
+            s->flags = inFlags;
+
+            getPollList( this )->getElement( i )->events =
+                getPollEvents( inFlags );
+            return true;
+            }
+        }
+    return false;
+    }
+
+
+
+void SocketPoll::removeSocket( Socket *inSock ) {
+
+    for( int i=0; i<mWatchedList.size(); i++ ) {
+        SocketOrServer *s = *( mWatchedList.getElement( i ) );
+        if( s->sock == inSock ) {
+
+            // don't return it later if it was found ready already
+            mReadyList.deleteElementEqualTo( s );
+
+            delete s;
+            mWatchedList.deleteElement( i );
+            getPollList( this )->deleteElement( i );
+            return;
+            }
+        }
+    }
+
+
+void SocketPoll::removeSocketServer( SocketServer *inServer ) {
+
+    for( int i=0; i<mWatchedList.size(); i++ ) {
+        SocketOrServer *s = *( mWatchedList.getElement( i ) );
+        if( s->server == inServer ) {
+
+            mReadyList.deleteElementEqualTo( s );
+
+            delete s;
+            mWatchedList.deleteElement( i );
+            getPollList( this )->deleteElement( i );
+            return;
+            }
+        }
+    }
+
+
+void SocketPoll::removeSocketUDP( SocketUDP *inSock ) {
+
+    for( int i=0; i<mWatchedList.size(); i++ ) {
+        SocketOrServer *s = *( mWatchedList.getElement( i ) );
+        if( s->udp == inSock ) {
+
+            mReadyList.deleteElementEqualTo( s );
+
+            delete s;
+            mWatchedList.deleteElement( i );
+            getPollList( this )->deleteElement( i );
+            return;
+            }
+        }
+    }
+
+
+
+
+SocketOrServer *SocketPoll::wait( int inTimeoutMS ) {
+    SocketOrServer *result;
+
+    if( wait( &result, 1, inTimeoutMS ) == 0 ) {
+        return NULL;
+        }
+
+    return result;
+    }
+
+
+
+int SocketPoll::wait( SocketOrServer **outReady, int inMax,
+                      int inTimeoutMS ) {
+    if( inMax <= 0 ) {
+        return 0;
+        }
+
+    int numReady = 0;
+
+    // hand out ones left over from last WSAPoll call before polling again,
+    // so that sockets late in the list aren't starved by small inMax
+    if( mReadyList.size() > 0 ) {
+        numReady = mReadyList.size();
+
+        if( numReady > inMax ) {
+            numReady = inMax;
+            }
+
+        for( int i=0; i<numReady; i++ ) {
+            outReady[i] = mReadyList.getElementDirect( i );
+            }
+        mReadyList.deleteStartElements( numReady );
+
+        return numReady;
+        }
+
+
+    SimpleVector<WSAPOLLFD> *pollList = getPollList( this );
+
+    int numWatched = pollList->size();
+
+    if( numWatched == 0 ) {
+        // WSAPoll fails on an empty array
+        return 0;
+        }
+
+    WSAPOLLFD *pollArray = pollList->getElementFast( 0 );
+
+    int numEvents = WSAPoll( pollArray, (ULONG)numWatched, inTimeoutMS );
+
+    if( numEvents <= 0 ) {
+        // timeout or error
+        return 0;
+        }
+
+
+    for( int i=0; i<numWatched && numEvents > 0; i++ ) {
+        SHORT revents = pollArray[i].revents;
+
+        if( revents != 0 ) {
+            numEvents--;
+
+            SocketOrServer *s = mWatchedList.getElementDirect( i );
+
+            s->readReady =
+                ( revents & ( POLLRDNORM | POLLERR | POLLHUP | POLLNVAL ) )
+                != 0;
+            s->writeReady = ( revents & POLLWRNORM ) != 0;
+
+            if( numReady < inMax ) {
+                outReady[ numReady ] = s;
+                numReady++;
+                }
+            else {
+                mReadyList.push_back( s );
+                }
+            }
+        }
+
+    return numReady;
+    }
@@ -20,6 +20,9 @@
  *
  * 2013-January-25  Jason Rohrer
  * Fixed signing inconsistencies.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Accepts new listening socket options, which Windows doesn't support.
  */
 
 
@@ -38,7 +41,17 @@ union sock {
 
 
 
-SocketServer::SocketServer( int inPort, int inMaxQueuedConnections ) {
+char SocketServer::isPortSharingSupported() {
+    return false;
+    }
+
+
+
+// port sharing, deferred accept, and TCP Fast Open are ignored
+SocketServer::SocketServer( int inPort, int inMaxQueuedConnections,
+                            char inSharePort,
+                            int inDeferAcceptSeconds,
+                            int inFastOpenQueueLength ) {
 	int error = 0;
 	
 	if( !Socket::isFrameworkInitialized() ) {
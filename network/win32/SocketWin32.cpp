@@ -85,6 +85,10 @@
  *
  * 2018-November-8  Jason Rohrer
  * Be careful that value passed into FD_SET is in range.
+ *
+ * 2026-October-14  Jason Rohrer
+ * Added sendv.
+ * Added sendFile (copying through a buffer).
  */
 
 
@@ -278,6 +282,91 @@ int Socket::send( unsigned char *inBuffer, int inNumBytes,
 		
 		
 		
+int Socket::sendv( SocketBuffer *inBuffers, int inNumBuffers,
+                   char inAllowedToBlock,
+                   char inAllowDelay ) {
+
+    if( inNumBuffers == 1 ) {
+        return send( inBuffers[0].data, inBuffers[0].length,
+                     inAllowedToBlock, inAllowDelay );
+        }
+
+    // WSASend is only in winsock2, so gather into one buffer instead,
+    // still only one send call
+    int totalLength = 0;
+    for( int i=0; i<inNumBuffers; i++ ) {
+        totalLength += inBuffers[i].length;
+        }
+
+    unsigned char stackBuffer[ 4096 ];
+
+    unsigned char *buffer = stackBuffer;
+
+    if( totalLength > 4096 ) {
+        buffer = new unsigned char[ totalLength ];
+        }
+
+    int pos = 0;
+    for( int i=0; i<inNumBuffers; i++ ) {
+        memcpy( &( buffer[pos] ), inBuffers[i].data, inBuffers[i].length );
+        pos += inBuffers[i].length;
+        }
+
+    int result = send( buffer, totalLength, inAllowedToBlock, inAllowDelay );
+
+    if( buffer != stackBuffer ) {
+        delete [] buffer;
+        }
+    
+    return result;
+    }
+		
+		
+		
+long Socket::sendFile( FILE *inFile, long inOffset, long inNumBytes ) {
+
+    if( fseek( inFile, inOffset, SEEK_SET ) != 0 ) {
+        return -1;
+        }
+
+    unsigned char buffer[ 16384 ];
+    
+    long numSent = 0;
+    
+    while( numSent < inNumBytes ) {
+        long numToRead = inNumBytes - numSent;
+        
+        if( numToRead > (long)sizeof( buffer ) ) {
+            numToRead = sizeof( buffer );
+            }
+        
+        int numRead = fread( buffer, 1, numToRead, inFile );
+        
+        if( numRead <= 0 ) {
+            return -1;
+            }
+        
+        int pos = 0;
+        
+        while( pos < numRead ) {
+            // no delay, since whole file is handed over at once
+            int result = send( &( buffer[pos] ), numRead - pos, 
+                               true, false );
+            
+            if( result <= 0 ) {
+                return -1;
+                }
+            pos += result;
+            }
+        
+        numSent += numRead;
+        }
+    
+    return numSent;
+    }
+
+
+
 int Socket::receive( unsigned char *inBuffer, int inNumBytes,
 	long inTimeout ) {
 	
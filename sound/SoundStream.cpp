@@ -0,0 +1,293 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+
+
+#include "SoundStream.h"
+
+#include "minorGems/sound/formats/aiff.h"
+#include "minorGems/sound/soundSpriteMixer.h"
+#include "minorGems/system/atomicOps.h"
+#include "minorGems/util/log/AppLog.h"
+
+
+
+// enough for the COMM chunk and any chunks between it and SSND
+#define SOUND_STREAM_HEADER_BYTES 4096
+
+
+
+SoundStream::SoundStream( const char *inFilePath, char inLoop )
+        : mFile( NULL ),
+          mNumSamples( 0 ), mSampleRate( 0 ), mDataStartByte( 0 ),
+          mLoop( inLoop ),
+          mNextFileSample( 0 ), mReadAll( false ),
+          mFileBytes( NULL ),
+          mChunksRead( 0 ), mChunksMixed( 0 ),
+          mFinished( false ),
+          mChunkPosition( 0 ) {
+
+    for( int c=0; c<SOUND_STREAM_NUM_CHUNKS; c++ ) {
+        mChunks[c] = NULL;
+        mChunkLengths[c] = 0;
+        mChunkIsLast[c] = false;
+        }
+
+    FILE *file = fopen( inFilePath, "rb" );
+
+    if( file == NULL ) {
+        AppLog::errorF( "Failed to open sound stream file %s", inFilePath );
+        return;
+        }
+
+    unsigned char header[ SOUND_STREAM_HEADER_BYTES ];
+
+    int numHeaderBytes =
+        (int)fread( header, 1, SOUND_STREAM_HEADER_BYTES, file );
+
+    if( ! readMono16AIFFHeader( header, numHeaderBytes,
+                                &mNumSamples, &mSampleRate,
+                                &mDataStartByte ) ) {
+        AppLog::errorF( "Failed to parse AIFF header of sound stream "
+                        "file %s", inFilePath );
+        fclose( file );
+        return;
+        }
+
+    mFile = file;
+
+    mFileBytes = new unsigned char[ SOUND_STREAM_CHUNK_SAMPLES * 2 ];
+
+    for( int c=0; c<SOUND_STREAM_NUM_CHUNKS; c++ ) {
+        mChunks[c] = new int16_t[ SOUND_STREAM_CHUNK_SAMPLES ];
+        }
+
+    rewind();
+    }
+
+
+
+SoundStream::~SoundStream() {
+    if( mFile != NULL ) {
+        fclose( mFile );
+        }
+    if( mFileBytes != NULL ) {
+        delete [] mFileBytes;
+        }
+    for( int c=0; c<SOUND_STREAM_NUM_CHUNKS; c++ ) {
+        if( mChunks[c] != NULL ) {
+            delete [] mChunks[c];
+            }
+        }
+    }
+
+
+
+char SoundStream::isOpen() {
+    return ( mFile != NULL );
+    }
+
+
+
+int SoundStream::getSampleRate() {
+    return mSampleRate;
+    }
+
+
+
+int SoundStream::getNumSamples() {
+    return mNumSamples;
+    }
+
+
+
+int SoundStream::mix( float inVolumeL, float inVolumeR,
+                      float *ioMixL, float *ioMixR,
+                      int inNumToFill ) {
+    int numFilled = 0;
+
+    while( numFilled < inNumToFill && ! mFinished ) {
+        int mixed = mChunksMixed;
+
+        if( mixed == atomicLoad( &mChunksRead ) ) {
+            // reading has fallen behind
+            break;
+            }
+
+        int c = mixed % SOUND_STREAM_NUM_CHUNKS;
+
+        numFilled += mixSoundSpriteSamples( mChunks[c], mChunkLengths[c],
+                                            &mChunkPosition,
+                                            inVolumeL, inVolumeR,
+                                            &( ioMixL[ numFilled ] ),
+                                            &( ioMixR[ numFilled ] ),
+                                            inNumToFill - numFilled );
+
+        if( mChunkPosition >= mChunkLengths[c] ) {
+            // done with this chunk, give it back
+            if( mChunkIsLast[c] ) {
+                atomicStore( &mFinished, true );
+                }
+
+            mChunkPosition = 0;
+            atomicStore( &mChunksMixed, mixed + 1 );
+            }
+        }
+
+    return numFilled;
+    }
+
+
+
+char SoundStream::isFinished() {
+    return atomicLoad( &mFinished );
+    }
+
+
+
+char SoundStream::fillChunks() {
+    if( mFile == NULL ) {
+        return false;
+        }
+
+    char filledAny = false;
+
+    while( ! mReadAll &&
+           mChunksRead - atomicLoad( &mChunksMixed ) <
+           SOUND_STREAM_NUM_CHUNKS ) {
+
+        int c = mChunksRead % SOUND_STREAM_NUM_CHUNKS;
+
+        int numToRead = mNumSamples - mNextFileSample;
+        if( numToRead > SOUND_STREAM_CHUNK_SAMPLES ) {
+            numToRead = SOUND_STREAM_CHUNK_SAMPLES;
+            }
+
+        int numRead =
+            (int)fread( mFileBytes, 2, numToRead, mFile );
+
+        int16_t *chunk = mChunks[c];
+        unsigned char *bytes = mFileBytes;
+
+        // big endian
+        for( int i=0; i<numRead; i++ ) {
+            chunk[i] = (int16_t)( ( bytes[0] << 8 ) | bytes[1] );
+            bytes += 2;
+            }
+
+        mNextFileSample += numRead;
+
+        char isLast = false;
+
+        if( numRead < numToRead ) {
+            AppLog::error( "Sound stream file ended early" );
+            mReadAll = true;
+            isLast = true;
+            }
+        else if( mNextFileSample >= mNumSamples ) {
+            if( mLoop && mNumSamples > 0 ) {
+                fseek( mFile, mDataStartByte, SEEK_SET );
+                mNextFileSample = 0;
+                }
+            else {
+                mReadAll = true;
+                isLast = true;
+                }
+            }
+
+        mChunkLengths[c] = numRead;
+        mChunkIsLast[c] = isLast;
+
+        // hand chunk over to mixing side
+        atomicStore( &mChunksRead, mChunksRead + 1 );
+
+        filledAny = true;
+        }
+
+    return filledAny;
+    }
+
+
+
+void SoundStream::rewind() {
+    if( mFile == NULL ) {
+        return;
+        }
+
+    fseek( mFile, mDataStartByte, SEEK_SET );
+
+    mNextFileSample = 0;
+    mReadAll = false;
+
+    atomicStore( &mChunksRead, 0 );
+    atomicStore( &mChunksMixed, 0 );
+    atomicStore( &mFinished, false );
+
+    mChunkPosition = 0;
+    }
+
+
+
+
+SoundStreamReader::SoundStreamReader() {
+    start();
+    }
+
+
+
+SoundStreamReader::~SoundStreamReader() {
+    stop();
+    join();
+    }
+
+
+
+void SoundStreamReader::addStream( SoundStream *inStream ) {
+    mLock.lock();
+
+    inStream->rewind();
+    inStream->fillChunks();
+
+    mStreams.push_back( inStream );
+
+    mLock.unlock();
+    }
+
+
+
+void SoundStreamReader::removeStream( SoundStream *inStream ) {
+    mLock.lock();
+    mStreams.deleteElementEqualTo( inStream );
+    mLock.unlock();
+    }
+
+
+
+void SoundStreamReader::rewindStream( SoundStream *inStream ) {
+    mLock.lock();
+
+    inStream->rewind();
+    inStream->fillChunks();
+
+    mLock.unlock();
+    }
+
+
+
+void SoundStreamReader::run() {
+    while( ! isStopped() ) {
+        mLock.lock();
+
+        for( int i=0; i<mStreams.size(); i++ ) {
+            mStreams.getElementDirect( i )->fillChunks();
+            }
+
+        mLock.unlock();
+
+        sleep( SOUND_STREAM_READ_INTERVAL_MS );
+        }
+    }
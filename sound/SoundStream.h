@@ -0,0 +1,212 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+
+
+#ifndef SOUND_STREAM_INCLUDED
+#define SOUND_STREAM_INCLUDED
+
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "minorGems/system/StopSignalThread.h"
+#include "minorGems/system/MutexLock.h"
+#include "minorGems/util/SimpleVector.h"
+
+
+
+// chunks in each stream's ring
+#define SOUND_STREAM_NUM_CHUNKS 4
+
+// samples per chunk, about 0.4 seconds at 22050 Hz
+#define SOUND_STREAM_CHUNK_SAMPLES 8192
+
+// how often SoundStreamReader checks for room in rings
+#define SOUND_STREAM_READ_INTERVAL_MS 20
+
+
+
+/**
+ * A mono 16-bit AIFF file played from disk a chunk at a time, so only
+ * a few chunks of it are in memory at once, instead of all of it.
+ *
+ * A SoundStreamReader thread reads chunks into a ring ahead of playback,
+ * and the audio thread mixes them out of the ring.  The two sides
+ * hand chunks back and forth with atomic counters, so mixing never
+ * waits on a lock or the disk.  If reading falls behind, mixing outputs
+ * nothing until it catches up.
+ *
+ * @author Jason Rohrer
+ */
+class SoundStream {
+
+    public:
+
+        /**
+         * Opens a stream.  Check isOpen afterward.
+         *
+         * @param inFilePath the path to the AIFF file.
+         *   Must be destroyed by caller.
+         * @param inLoop true to start over at the beginning after the
+         *   end, forever.
+         */
+        SoundStream( const char *inFilePath, char inLoop );
+
+        // must not be in a SoundStreamReader, or being mixed
+        ~SoundStream();
+
+
+        char isOpen();
+
+        int getSampleRate();
+
+        int getNumSamples();
+
+
+
+        /**
+         * Mixes the stream's next samples into float accumulation
+         * buffers.
+         *
+         * Only one thread at a time (the audio thread) can mix.
+         *
+         * @param inVolumeL, inVolumeR the per-channel gains.
+         * @param ioMixL, ioMixR the accumulation buffers to add into.
+         * @param inNumToFill the number of output samples wanted.
+         *
+         * @return the number of output samples filled, which is less
+         *   than inNumToFill if the stream ended or reading fell behind.
+         */
+        int mix( float inVolumeL, float inVolumeR,
+                 float *ioMixL, float *ioMixR,
+                 int inNumToFill );
+
+
+        // true once every sample has been mixed
+        // never true for looping streams
+        char isFinished();
+
+
+
+        /**
+         * Reads chunks into the ring until it is full or the file
+         * ends.
+         *
+         * Only one thread at a time can fill.
+         *
+         * @return true if any chunks were read.
+         */
+        char fillChunks();
+
+
+        /**
+         * Goes back to the beginning.
+         *
+         * Must not be called while the stream is being mixed or filled.
+         */
+        void rewind();
+
+
+
+    protected:
+
+        FILE *mFile;
+
+        int mNumSamples;
+        int mSampleRate;
+        int mDataStartByte;
+
+        char mLoop;
+
+
+        // reading side
+        // next sample in file to read
+        int mNextFileSample;
+
+        // no more chunks to read
+        char mReadAll;
+
+        unsigned char *mFileBytes;
+
+
+        // shared
+        int16_t *mChunks[ SOUND_STREAM_NUM_CHUNKS ];
+        int mChunkLengths[ SOUND_STREAM_NUM_CHUNKS ];
+        char mChunkIsLast[ SOUND_STREAM_NUM_CHUNKS ];
+
+        // chunk i is in ring slot ( i % SOUND_STREAM_NUM_CHUNKS )
+        // reading side adds chunks, mixing side takes them back
+        volatile int mChunksRead;
+        volatile int mChunksMixed;
+
+        volatile int mFinished;
+
+
+        // mixing side
+        // next sample in the oldest chunk in the ring
+        int mChunkPosition;
+
+    };
+
+
+
+/**
+ * Thread that keeps the rings of a set of streams full, checking every
+ * SOUND_STREAM_READ_INTERVAL_MS.
+ *
+ * @author Jason Rohrer
+ */
+class SoundStreamReader : public StopSignalThread {
+
+    public:
+
+        // starts the thread
+        SoundStreamReader();
+
+        // stops the thread
+        // does not destroy the streams
+        ~SoundStreamReader();
+
+
+        /**
+         * Adds a stream, which is rewound and has its ring filled before
+         * this call returns, so it can be played right away.
+         *
+         * @param inStream the stream to add.
+         *   Must be destroyed by caller after it is removed.
+         */
+        void addStream( SoundStream *inStream );
+
+
+        // after this returns, the stream is no longer being filled
+        void removeStream( SoundStream *inStream );
+
+
+        /**
+         * Rewinds a stream that was added, and fills its ring before
+         * returning.
+         *
+         * Stream must not be being mixed.
+         */
+        void rewindStream( SoundStream *inStream );
+
+
+        virtual void run();
+
+
+    protected:
+
+        MutexLock mLock;
+
+        SimpleVector<SoundStream *> mStreams;
+
+    };
+
+
+
+#endif
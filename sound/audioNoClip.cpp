@@ -4,6 +4,16 @@
 #include <stdio.h>
 
 
+#if defined( __SSE2__ ) || defined( _M_X64 ) || \
+    ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+    #define AUDIO_NO_CLIP_SSE2
+    #include <emmintrin.h>
+#elif defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+    #define AUDIO_NO_CLIP_NEON
+    #include <arm_neon.h>
+#endif
+
+
 
 
 
@@ -23,13 +33,19 @@ NoClip resetAudioNoClip( double inMaxVolume, int inHoldTimeInSamples,
     
     a.currentHoldTime = 0;
 
+    a.gainDecayPerSample = 0;
+
     return a;
     }
 
 
 
-void audioNoClip( NoClip *inC,
-                  double *inSamplesL, double *inSamplesR, int inNumSamples ) {
+// templated so that double and float mixing buffers share one implementation
+template <class SampleType>
+static void audioNoClipInternal( NoClip *inC,
+                                 SampleType *inSamplesL, 
+                                 SampleType *inSamplesR, 
+                                 int inNumSamples ) {
     
     for( int i=0; i<inNumSamples; i++ ) {
         
@@ -100,3 +116,492 @@ void audioNoClip( NoClip *inC,
     
     }
 
+
+
+void audioNoClip( NoClip *inC,
+                  double *inSamplesL, double *inSamplesR, int inNumSamples ) {
+    audioNoClipInternal( inC, inSamplesL, inSamplesR, inNumSamples );
+    }
+
+
+
+void audioNoClip( NoClip *inC,
+                  float *inSamplesL, float *inSamplesR, int inNumSamples ) {
+    audioNoClipInternal( inC, inSamplesL, inSamplesR, inNumSamples );
+    }
+
+
+
+// largest absolute value in either channel
+static float noClipPeak( float *inSamplesL, float *inSamplesR, 
+                         int inNumSamples ) {
+    int i = 0;
+    float peak = 0;
+
+#if defined( AUDIO_NO_CLIP_SSE2 )
+
+    __m128 signMask = _mm_set1_ps( -0.0f );
+    __m128 peak4 = _mm_setzero_ps();
+
+    for( ; i + 4 <= inNumSamples; i += 4 ) {
+        __m128 l = _mm_andnot_ps( signMask, _mm_loadu_ps( inSamplesL + i ) );
+        __m128 r = _mm_andnot_ps( signMask, _mm_loadu_ps( inSamplesR + i ) );
+        
+        peak4 = _mm_max_ps( peak4, _mm_max_ps( l, r ) );
+        }
+
+    // fold lanes together
+    peak4 = _mm_max_ps( peak4, _mm_movehl_ps( peak4, peak4 ) );
+    peak4 = _mm_max_ss( peak4, 
+                        _mm_shuffle_ps( peak4, peak4, 
+                                        _MM_SHUFFLE( 1, 1, 1, 1 ) ) );
+    peak = _mm_cvtss_f32( peak4 );
+
+#elif defined( AUDIO_NO_CLIP_NEON )
+
+    float32x4_t peak4 = vdupq_n_f32( 0 );
+
+    for( ; i + 4 <= inNumSamples; i += 4 ) {
+        peak4 = vmaxq_f32( peak4, 
+                           vmaxq_f32( vabsq_f32( vld1q_f32( inSamplesL + i ) ),
+                                      vabsq_f32( vld1q_f32( inSamplesR + i ) 
+                                                 ) ) );
+        }
+
+    float32x2_t peak2 = vpmax_f32( vget_low_f32( peak4 ), 
+                                   vget_high_f32( peak4 ) );
+    peak = vget_lane_f32( vpmax_f32( peak2, peak2 ), 0 );
+
+#endif
+
+    for( ; i < inNumSamples; i++ ) {
+        float l = fabsf( inSamplesL[i] );
+        float r = fabsf( inSamplesR[i] );
+        
+        if( l > peak ) {
+            peak = l;
+            }
+        if( r > peak ) {
+            peak = r;
+            }
+        }
+
+    return peak;
+    }
+
+
+
+// steps hold and release once for a whole run with peak inPeak,
+// leaving inC->gain low enough for that peak
+static void noClipStepRun( NoClip *inC, double inPeak, int inNumSamples ) {
+    
+    if( inC->gain == 1.0 && inPeak <= inC->maxVolume ) {
+        return;
+        }
+
+    double runDecay = inC->gainDecayPerSample * inNumSamples;
+    
+    if( inC->gain != 1.0 
+        && 
+        ( inC->gain + runDecay ) * inPeak <= inC->maxVolume ) {
+        
+        inC->currentHoldTime += inNumSamples;
+        
+        if( inC->currentHoldTime > inC->holdTime ) {
+            inC->gain += runDecay;
+            
+            if( inC->gain > 1.0 ) {
+                inC->gain = 1.0;
+                }
+            }
+        }
+    else if( inPeak * inC->gain > inC->maxVolume ) {
+        // new peak
+        inC->currentHoldTime = 0;
+        
+        inC->gain = inC->maxVolume / inPeak;
+        
+        inC->gainDecayPerSample = ( 1.0 - inC->gain ) / inC->decayTime;
+        }
+    else {
+        // hit old peak again, continue holding
+        inC->currentHoldTime = 0;
+        }
+    }
+
+
+
+// multiplies a run by a gain ramping from just after inStartGain to
+// exactly inEndGain on the last sample
+static void noClipRampRun( float *ioSamplesL, float *ioSamplesR,
+                           int inNumSamples,
+                           float inStartGain, float inEndGain ) {
+
+    float gainStep = ( inEndGain - inStartGain ) / inNumSamples;
+    
+    int i = 0;
+
+#if defined( AUDIO_NO_CLIP_SSE2 )
+
+    __m128 start = _mm_set1_ps( inStartGain );
+    __m128 step = _mm_set1_ps( gainStep );
+    __m128 index = _mm_setr_ps( 1, 2, 3, 4 );
+    __m128 four = _mm_set1_ps( 4 );
+
+    for( ; i + 4 <= inNumSamples; i += 4 ) {
+        __m128 gain = _mm_add_ps( start, _mm_mul_ps( step, index ) );
+        
+        _mm_storeu_ps( ioSamplesL + i, 
+                       _mm_mul_ps( _mm_loadu_ps( ioSamplesL + i ), gain ) );
+        _mm_storeu_ps( ioSamplesR + i, 
+                       _mm_mul_ps( _mm_loadu_ps( ioSamplesR + i ), gain ) );
+
+        index = _mm_add_ps( index, four );
+        }
+
+#elif defined( AUDIO_NO_CLIP_NEON )
+
+    float indexInit[4] = { 1, 2, 3, 4 };
+    
+    float32x4_t start = vdupq_n_f32( inStartGain );
+    float32x4_t index = vld1q_f32( indexInit );
+    float32x4_t four = vdupq_n_f32( 4 );
+
+    for( ; i + 4 <= inNumSamples; i += 4 ) {
+        float32x4_t gain = vmlaq_n_f32( start, index, gainStep );
+        
+        vst1q_f32( ioSamplesL + i, vmulq_f32( vld1q_f32( ioSamplesL + i ), 
+                                              gain ) );
+        vst1q_f32( ioSamplesR + i, vmulq_f32( vld1q_f32( ioSamplesR + i ), 
+                                              gain ) );
+
+        index = vaddq_f32( index, four );
+        }
+
+#endif
+
+    for( ; i < inNumSamples; i++ ) {
+        float gain = inStartGain + gainStep * ( i + 1 );
+        
+        ioSamplesL[i] *= gain;
+        ioSamplesR[i] *= gain;
+        }
+    }
+
+
+
+static inline short noClipToS16( float inValue ) {
+    if( inValue >= 32767.0f ) {
+        return 32767;
+        }
+    if( inValue <= -32768.0f ) {
+        return -32768;
+        }
+    return (short)lrintf( inValue );
+    }
+
+
+
+// same ramp as noClipRampRun, but writes 16-bit output instead
+static void noClipRampRunToS16LE( float *inSamplesL, float *inSamplesR,
+                                  unsigned char *outBytes,
+                                  int inNumSamples,
+                                  float inStartGain, float inEndGain ) {
+
+    float gainStep = ( inEndGain - inStartGain ) / inNumSamples;
+    
+    int i = 0;
+
+#if defined( AUDIO_NO_CLIP_SSE2 )
+
+    __m128 start = _mm_set1_ps( inStartGain );
+    __m128 step = _mm_set1_ps( gainStep );
+    __m128 indexA = _mm_setr_ps( 1, 2, 3, 4 );
+    __m128 indexB = _mm_setr_ps( 5, 6, 7, 8 );
+    __m128 eight = _mm_set1_ps( 8 );
+
+    // 8 sample pairs per step
+    for( ; i + 8 <= inNumSamples; i += 8 ) {
+        __m128 gainA = _mm_add_ps( start, _mm_mul_ps( step, indexA ) );
+        __m128 gainB = _mm_add_ps( start, _mm_mul_ps( step, indexB ) );
+        
+        // round to nearest, like lrintf, then narrow with saturation
+        __m128i l = _mm_packs_epi32( 
+            _mm_cvtps_epi32( _mm_mul_ps( _mm_loadu_ps( inSamplesL + i ), 
+                                         gainA ) ),
+            _mm_cvtps_epi32( _mm_mul_ps( _mm_loadu_ps( inSamplesL + i + 4 ), 
+                                         gainB ) ) );
+        __m128i r = _mm_packs_epi32( 
+            _mm_cvtps_epi32( _mm_mul_ps( _mm_loadu_ps( inSamplesR + i ), 
+                                         gainA ) ),
+            _mm_cvtps_epi32( _mm_mul_ps( _mm_loadu_ps( inSamplesR + i + 4 ), 
+                                         gainB ) ) );
+        
+        __m128i *out = (__m128i *)&( outBytes[ i * 4 ] );
+        _mm_storeu_si128( out, _mm_unpacklo_epi16( l, r ) );
+        _mm_storeu_si128( out + 1, _mm_unpackhi_epi16( l, r ) );
+
+        indexA = _mm_add_ps( indexA, eight );
+        indexB = _mm_add_ps( indexB, eight );
+        }
+
+#elif defined( AUDIO_NO_CLIP_NEON ) && defined( __aarch64__ ) && \
+    ! defined( __ARM_BIG_ENDIAN )
+
+    float indexInit[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    
+    float32x4_t start = vdupq_n_f32( inStartGain );
+    float32x4_t indexA = vld1q_f32( indexInit );
+    float32x4_t indexB = vld1q_f32( indexInit + 4 );
+    float32x4_t eight = vdupq_n_f32( 8 );
+
+    for( ; i + 8 <= inNumSamples; i += 8 ) {
+        float32x4_t gainA = vmlaq_n_f32( start, indexA, gainStep );
+        float32x4_t gainB = vmlaq_n_f32( start, indexB, gainStep );
+        
+        int16x8x2_t lr;
+        lr.val[0] = vcombine_s16( 
+            vqmovn_s32( vcvtnq_s32_f32( 
+                            vmulq_f32( vld1q_f32( inSamplesL + i ), 
+                                       gainA ) ) ),
+            vqmovn_s32( vcvtnq_s32_f32( 
+                            vmulq_f32( vld1q_f32( inSamplesL + i + 4 ), 
+                                       gainB ) ) ) );
+        lr.val[1] = vcombine_s16( 
+            vqmovn_s32( vcvtnq_s32_f32( 
+                            vmulq_f32( vld1q_f32( inSamplesR + i ), 
+                                       gainA ) ) ),
+            vqmovn_s32( vcvtnq_s32_f32( 
+                            vmulq_f32( vld1q_f32( inSamplesR + i + 4 ), 
+                                       gainB ) ) ) );
+
+        // interleaving store
+        vst2q_s16( (int16_t *)&( outBytes[ i * 4 ] ), lr );
+        
+        indexA = vaddq_f32( indexA, eight );
+        indexB = vaddq_f32( indexB, eight );
+        }
+
+#endif
+
+    for( ; i < inNumSamples; i++ ) {
+        float gain = inStartGain + gainStep * ( i + 1 );
+        
+        short l = noClipToS16( inSamplesL[i] * gain );
+        short r = noClipToS16( inSamplesR[i] * gain );
+        
+        unsigned char *out = &( outBytes[ i * 4 ] );
+        
+        out[0] = (unsigned char)( l & 0xFF );
+        out[1] = (unsigned char)( ( l >> 8 ) & 0xFF );
+        out[2] = (unsigned char)( r & 0xFF );
+        out[3] = (unsigned char)( ( r >> 8 ) & 0xFF );
+        }
+    }
+
+
+
+static inline float noClipToUnit( float inValue ) {
+    if( inValue > 1.0f ) {
+        return 1.0f;
+        }
+    if( inValue < -1.0f ) {
+        return -1.0f;
+        }
+    return inValue;
+    }
+
+
+
+// same ramp as noClipRampRun, but writes interleaved float output instead
+static void noClipRampRunToF32( float *inSamplesL, float *inSamplesR,
+                                float *outSamples,
+                                int inNumSamples,
+                                float inStartGain, float inEndGain ) {
+
+    float gainStep = ( inEndGain - inStartGain ) / inNumSamples;
+    
+    int i = 0;
+
+#if defined( AUDIO_NO_CLIP_SSE2 )
+
+    __m128 start = _mm_set1_ps( inStartGain );
+    __m128 step = _mm_set1_ps( gainStep );
+    __m128 index = _mm_setr_ps( 1, 2, 3, 4 );
+    __m128 four = _mm_set1_ps( 4 );
+    __m128 one = _mm_set1_ps( 1 );
+    __m128 minusOne = _mm_set1_ps( -1 );
+
+    for( ; i + 4 <= inNumSamples; i += 4 ) {
+        __m128 gain = _mm_add_ps( start, _mm_mul_ps( step, index ) );
+        
+        __m128 l = _mm_min_ps( one, _mm_max_ps( minusOne,
+            _mm_mul_ps( _mm_loadu_ps( inSamplesL + i ), gain ) ) );
+        __m128 r = _mm_min_ps( one, _mm_max_ps( minusOne,
+            _mm_mul_ps( _mm_loadu_ps( inSamplesR + i ), gain ) ) );
+        
+        float *out = &( outSamples[ i * 2 ] );
+        _mm_storeu_ps( out, _mm_unpacklo_ps( l, r ) );
+        _mm_storeu_ps( out + 4, _mm_unpackhi_ps( l, r ) );
+
+        index = _mm_add_ps( index, four );
+        }
+
+#elif defined( AUDIO_NO_CLIP_NEON )
+
+    float indexInit[4] = { 1, 2, 3, 4 };
+    
+    float32x4_t start = vdupq_n_f32( inStartGain );
+    float32x4_t index = vld1q_f32( indexInit );
+    float32x4_t four = vdupq_n_f32( 4 );
+    float32x4_t one = vdupq_n_f32( 1 );
+    float32x4_t minusOne = vdupq_n_f32( -1 );
+
+    for( ; i + 4 <= inNumSamples; i += 4 ) {
+        float32x4_t gain = vmlaq_n_f32( start, index, gainStep );
+        
+        float32x4x2_t lr;
+        lr.val[0] = vminq_f32( one, vmaxq_f32( minusOne, 
+            vmulq_f32( vld1q_f32( inSamplesL + i ), gain ) ) );
+        lr.val[1] = vminq_f32( one, vmaxq_f32( minusOne, 
+            vmulq_f32( vld1q_f32( inSamplesR + i ), gain ) ) );
+        
+        // interleaving store
+        vst2q_f32( &( outSamples[ i * 2 ] ), lr );
+
+        index = vaddq_f32( index, four );
+        }
+
+#endif
+
+    for( ; i < inNumSamples; i++ ) {
+        float gain = inStartGain + gainStep * ( i + 1 );
+        
+        outSamples[ i * 2 ] = noClipToUnit( inSamplesL[i] * gain );
+        outSamples[ i * 2 + 1 ] = noClipToUnit( inSamplesR[i] * gain );
+        }
+    }
+
+
+
+// outBytes and outSamples NULL to apply gain to float buffers in place
+// inOutputScale multiplies gain for output only
+static void audioNoClipBlockInternal( NoClip *inC,
+                                      float *inSamplesL, float *inSamplesR,
+                                      unsigned char *outBytes,
+                                      float *outSamples,
+                                      float inOutputScale,
+                                      int inNumSamples ) {
+    if( inNumSamples <= 0 ) {
+        return;
+        }
+    
+    // each run's gain ramps from the gain at the end of the previous run
+    // to the lower of its own gain and the next run's gain, so it never
+    // goes above what either run needs
+    
+    double startGain = inC->gain;
+    
+    int runLength = NO_CLIP_BLOCK_SIZE;
+    if( runLength > inNumSamples ) {
+        runLength = inNumSamples;
+        }
+    
+    noClipStepRun( inC, 
+                   noClipPeak( inSamplesL, inSamplesR, runLength ), 
+                   runLength );
+    
+    double runGain = inC->gain;
+    
+    if( runGain < startGain ) {
+        startGain = runGain;
+        }
+    
+    for( int runStart = 0; runStart < inNumSamples; 
+         runStart += NO_CLIP_BLOCK_SIZE ) {
+        
+        runLength = inNumSamples - runStart;
+        if( runLength > NO_CLIP_BLOCK_SIZE ) {
+            runLength = NO_CLIP_BLOCK_SIZE;
+            }
+
+        double endGain = runGain;
+        
+        int nextStart = runStart + runLength;
+
+        if( nextStart < inNumSamples ) {
+            int nextLength = inNumSamples - nextStart;
+            if( nextLength > NO_CLIP_BLOCK_SIZE ) {
+                nextLength = NO_CLIP_BLOCK_SIZE;
+                }
+
+            // look ahead
+            noClipStepRun( inC, 
+                           noClipPeak( &( inSamplesL[ nextStart ] ),
+                                       &( inSamplesR[ nextStart ] ),
+                                       nextLength ),
+                           nextLength );
+            
+            if( inC->gain < endGain ) {
+                endGain = inC->gain;
+                }
+            }
+        
+        if( outBytes != NULL ) {
+            noClipRampRunToS16LE( &( inSamplesL[ runStart ] ), 
+                                  &( inSamplesR[ runStart ] ),
+                                  &( outBytes[ runStart * 4 ] ),
+                                  runLength,
+                                  (float)startGain * inOutputScale, 
+                                  (float)endGain * inOutputScale );
+            }
+        else if( outSamples != NULL ) {
+            noClipRampRunToF32( &( inSamplesL[ runStart ] ), 
+                                &( inSamplesR[ runStart ] ),
+                                &( outSamples[ runStart * 2 ] ),
+                                runLength,
+                                (float)startGain * inOutputScale, 
+                                (float)endGain * inOutputScale );
+            }
+        else if( startGain != 1.0 || endGain != 1.0 ) {
+            noClipRampRun( &( inSamplesL[ runStart ] ), 
+                           &( inSamplesR[ runStart ] ),
+                           runLength,
+                           (float)startGain, (float)endGain );
+            }
+        
+        startGain = endGain;
+        runGain = inC->gain;
+        }
+    }
+
+
+
+void audioNoClipBlock( NoClip *inC,
+                       float *inSamplesL, float *inSamplesR, 
+                       int inNumSamples ) {
+    audioNoClipBlockInternal( inC, inSamplesL, inSamplesR, NULL, NULL, 1,
+                              inNumSamples );
+    }
+
+
+
+void audioNoClipBlockToS16LE( NoClip *inC,
+                              float *inSamplesL, float *inSamplesR,
+                              unsigned char *outBytes,
+                              int inNumSamples,
+                              float inOutputScale ) {
+    audioNoClipBlockInternal( inC, inSamplesL, inSamplesR, outBytes, NULL,
+                              inOutputScale, inNumSamples );
+    }
+
+
+
+void audioNoClipBlockToF32( NoClip *inC,
+                            float *inSamplesL, float *inSamplesR,
+                            float *outSamples,
+                            int inNumSamples,
+                            float inOutputScale ) {
+    audioNoClipBlockInternal( inC, inSamplesL, inSamplesR, NULL, outSamples,
+                              inOutputScale, inNumSamples );
+    }
@@ -28,4 +28,47 @@ void audioNoClip( NoClip *inC,
                   double *inSamplesL, double *inSamplesR, int inNumSamples );
 
 
-
+// same, for float mixing buffers
+void audioNoClip( NoClip *inC,
+                  float *inSamplesL, float *inSamplesR, int inNumSamples );
+
+
+
+// run length for the block versions below
+#define NO_CLIP_BLOCK_SIZE 32
+
+
+// Block version for float mixing buffers, with look-ahead.
+//
+// Finds the peak of each run of NO_CLIP_BLOCK_SIZE samples, applies the
+// same hold and release rules once per run, and ramps gain linearly across
+// each run so that it is already down by the time a louder run arrives.
+// Look-ahead only works within a buffer, so a peak right at the start of
+// a buffer still gets a sudden gain drop, like the per-sample version.
+//
+// Peak finding and gain ramps use SSE2 or NEON where available.
+void audioNoClipBlock( NoClip *inC,
+                       float *inSamplesL, float *inSamplesR, 
+                       int inNumSamples );
+
+
+// same, but leaves float buffers alone and writes the result to outBytes
+// as interleaved, little-endian, 16-bit stereo (4 bytes per sample pair),
+// saturating anything still outside the 16-bit range
+//
+// inOutputScale multiplies output samples only, so buffers limited to
+// a max volume of 1.0 can be written with a scale of 32767
+void audioNoClipBlockToS16LE( NoClip *inC,
+                              float *inSamplesL, float *inSamplesR,
+                              unsigned char *outBytes,
+                              int inNumSamples,
+                              float inOutputScale = 1.0f );
+
+
+// same, but writes interleaved float stereo (2 floats per sample pair)
+// to outSamples, saturating anything still outside [-1,1]
+void audioNoClipBlockToF32( NoClip *inC,
+                            float *inSamplesL, float *inSamplesR,
+                            float *outSamples,
+                            int inNumSamples,
+                            float inOutputScale = 1.0f );
@@ -3,6 +3,9 @@
  *
  * 2004-July-22   Jason Rohrer
  * Created.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Added in-place process function.  Filters a block at a time.
  */
 
 
@@ -38,37 +41,70 @@ ReverbSoundFilter::~ReverbSoundFilter() {
 
 SoundSamples *ReverbSoundFilter::filterSamples( SoundSamples *inSamples ) {
 
-    unsigned long delaySize = mDelayBuffer->mSampleCount;
-
-    unsigned long numSamples = inSamples->mSampleCount;
-
     // pass the input through to the output
     SoundSamples *outputSamples = new SoundSamples( inSamples );
 
+    process( outputSamples->mLeftChannel, outputSamples->mRightChannel,
+             (int)( outputSamples->mSampleCount ) );
+
+    return outputSamples;    
+    }
+
+
+
+void ReverbSoundFilter::process( float *ioLeft, float *ioRight,
+                                 int inNumSamples ) {
+
+    unsigned long delaySize = mDelayBuffer->mSampleCount;
+
+    if( delaySize == 0 ) {
+        return;
+        }
 
-    for( unsigned long i=0; i<numSamples; i++ ) {
+    float gain = (float)mGain;
+    
+    int i = 0;
+    
+    while( i < inNumSamples ) {
+        
+        // go as far as we can before wrapping around the delay buffer
+        unsigned long numToEnd = delaySize - mDelayBufferPosition;
 
+        int n = inNumSamples - i;
+        if( (unsigned long)n > numToEnd ) {
+            n = (int)numToEnd;
+            }
+        
+        float *left = &( ioLeft[i] );
+        float *right = &( ioRight[i] );
+        float *delayLeft = 
+            &( mDelayBuffer->mLeftChannel[ mDelayBufferPosition ] );
+        float *delayRight = 
+            &( mDelayBuffer->mRightChannel[ mDelayBufferPosition ] );
+        
+        int j;
         
         // add in reverb from the buffer to our output
-        outputSamples->mLeftChannel[i] +=
-            mDelayBuffer->mLeftChannel[ mDelayBufferPosition ];
-        outputSamples->mRightChannel[i] +=
-            mDelayBuffer->mRightChannel[ mDelayBufferPosition ]; 
-
+        for( j=0; j<n; j++ ) {
+            left[j] += delayLeft[j];
+            right[j] += delayRight[j];
+            }
+        
         // save our gained output in the delay buffer
-        mDelayBuffer->mLeftChannel[ mDelayBufferPosition ] =
-            mGain * coeffFilter( outputSamples->mLeftChannel[i], 
-                                 &mLowPassStateL );
-        mDelayBuffer->mRightChannel[ mDelayBufferPosition ] =
-            mGain * coeffFilter( outputSamples->mRightChannel[i],
-                                 &mLowPassStateR );
+        // each delay sample is read above before it is overwritten here
+        coeffFilterStereoBlock( left, right, delayLeft, delayRight, n,
+                                &mLowPassStateL, &mLowPassStateR );
         
-        // step through delay buffer, wrapping around at end
-        mDelayBufferPosition++;
+        for( j=0; j<n; j++ ) {
+            delayLeft[j] *= gain;
+            delayRight[j] *= gain;
+            }
+
+        i += n;
+        
+        mDelayBufferPosition += n;
         if( mDelayBufferPosition >= delaySize ) {
             mDelayBufferPosition = 0;
             }
         }
-
-    return outputSamples;    
     }
@@ -3,6 +3,9 @@
  *
  * 2004-July-22   Jason Rohrer
  * Created.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Added in-place process function.  Filters a block at a time.
  */
 
 
@@ -48,6 +51,11 @@ class ReverbSoundFilter : public SoundFilter {
         // implements the SoundFilter interface
         virtual SoundSamples *filterSamples( SoundSamples *inSamples );
 
+
+        // overrides the default implementation, without allocating
+        virtual void process( float *ioLeft, float *ioRight,
+                              int inNumSamples );
+
         
 
     private:
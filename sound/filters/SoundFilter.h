@@ -3,6 +3,9 @@
  *
  * 2004-July-22   Jason Rohrer
  * Created.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Added in-place process function for filtering without allocation.
  */
 
 
@@ -14,6 +17,8 @@
 
 #include "SoundSamples.h"
 
+#include <string.h>
+
 
 
 /**
@@ -40,6 +45,25 @@ class SoundFilter {
 
 
 
+        /**
+         * Filters a block of sound samples in place.
+         *
+         * Filters that override this keep all the state they need
+         * from block to block, so they can run in a real-time audio
+         * callback.  The default implementation goes through
+         * filterSamples, which allocates.
+         *
+         * @param ioLeft the left channel samples to filter.
+         *   Must be destroyed by caller.
+         * @param ioRight the right channel samples to filter.
+         *   Must be destroyed by caller.
+         * @param inNumSamples the number of samples in each channel.
+         */
+        virtual void process( float *ioLeft, float *ioRight,
+                              int inNumSamples );
+
+
+
         // virtual destructor to ensure proper destruction of classes that
         // implement this interface
         virtual ~SoundFilter();
@@ -57,4 +81,25 @@ inline SoundFilter::~SoundFilter() {
 
 
 
+inline void SoundFilter::process( float *ioLeft, float *ioRight,
+                                  int inNumSamples ) {
+    
+    // wrap our buffers without copying them
+    SoundSamples wrapper( inNumSamples, ioLeft, ioRight );
+    
+    SoundSamples *filtered = filterSamples( &wrapper );
+    
+    memcpy( ioLeft, filtered->mLeftChannel, inNumSamples * sizeof( float ) );
+    memcpy( ioRight, filtered->mRightChannel, 
+            inNumSamples * sizeof( float ) );
+    
+    delete filtered;
+    
+    // so wrapper doesn't destroy them
+    wrapper.mLeftChannel = NULL;
+    wrapper.mRightChannel = NULL;
+    }
+
+
+
 #endif
@@ -0,0 +1,108 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+
+
+#ifndef SOUND_FILTER_CHAIN_INCLUDED
+#define SOUND_FILTER_CHAIN_INCLUDED
+
+
+
+#include "SoundFilter.h"
+
+#include "minorGems/util/SimpleVector.h"
+
+
+
+/**
+ * A filter that runs sound through a series of other filters in order.
+ *
+ * process passes the same buffers through each filter in turn, so a
+ * chain of filters that override process allocates nothing.
+ *
+ * @author Jason Rohrer
+ */
+class SoundFilterChain : public SoundFilter {
+
+
+
+    public:
+
+
+
+        // destroys the filters in the chain
+        virtual ~SoundFilterChain();
+
+
+
+        /**
+         * Adds a filter to the end of the chain.
+         *
+         * @param inFilter the filter to add.
+         *   Will be destroyed when this class is destroyed.
+         */
+        void addFilter( SoundFilter *inFilter );
+
+
+
+        // implements the SoundFilter interface
+        virtual SoundSamples *filterSamples( SoundSamples *inSamples );
+
+
+        // overrides the default implementation
+        virtual void process( float *ioLeft, float *ioRight,
+                              int inNumSamples );
+
+
+
+    private:
+
+        SimpleVector<SoundFilter *> mFilters;
+
+    };
+
+
+
+inline SoundFilterChain::~SoundFilterChain() {
+    for( int i=0; i<mFilters.size(); i++ ) {
+        delete *( mFilters.getElement( i ) );
+        }
+    }
+
+
+
+inline void SoundFilterChain::addFilter( SoundFilter *inFilter ) {
+    mFilters.push_back( inFilter );
+    }
+
+
+
+inline SoundSamples *SoundFilterChain::filterSamples(
+    SoundSamples *inSamples ) {
+
+    SoundSamples *outputSamples = new SoundSamples( inSamples );
+
+    process( outputSamples->mLeftChannel, outputSamples->mRightChannel,
+             (int)( outputSamples->mSampleCount ) );
+
+    return outputSamples;
+    }
+
+
+
+inline void SoundFilterChain::process( float *ioLeft, float *ioRight,
+                                       int inNumSamples ) {
+    for( int i=0; i<mFilters.size(); i++ ) {
+        SoundFilter *filter = *( mFilters.getElement( i ) );
+
+        filter->process( ioLeft, ioRight, inNumSamples );
+        }
+    }
+
+
+
+#endif
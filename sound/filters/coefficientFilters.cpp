@@ -4,6 +4,17 @@
 #include <math.h>
 
 
+#if defined( __SSE2__ ) || defined( _M_X64 ) || \
+    ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+    #define COEFF_FILTER_SSE2
+    #include <emmintrin.h>
+#elif defined( __aarch64__ )
+    // double-precision NEON only exists on 64-bit ARM
+    #define COEFF_FILTER_NEON
+    #include <arm_neon.h>
+#endif
+
+
 
 double coeffFilter( double inSample, CoeffFilterState *s ) {
     double nextOut = 
@@ -20,6 +31,169 @@ double coeffFilter( double inSample, CoeffFilterState *s ) {
     }
 
 
+void coeffFilterBlock( float *inSamples, float *outSamples, int inNumSamples,
+                       CoeffFilterState *s ) {
+    // keep state in locals so it can stay in registers
+    double a1 = s->a1;
+    double a2 = s->a2;
+    double a3 = s->a3;
+    double b1 = s->b1;
+    double b2 = s->b2;
+    
+    double in0 = s->lastIn[0];
+    double in1 = s->lastIn[1];
+    double out0 = s->lastOut[0];
+    double out1 = s->lastOut[1];
+    
+    for( int i=0; i<inNumSamples; i++ ) {
+        double inSample = inSamples[i];
+        
+        double nextOut = 
+            a1 * inSample + a2 * in0 + a3 * in1 - b1 * out0 - b2 * out1;
+        
+        in1 = in0;
+        in0 = inSample;
+        out1 = out0;
+        out0 = nextOut;
+        
+        outSamples[i] = (float)nextOut;
+        }
+    
+    s->lastIn[0] = in0;
+    s->lastIn[1] = in1;
+    s->lastOut[0] = out0;
+    s->lastOut[1] = out1;
+    }
+
+
+
+void coeffFilterStereoBlock( float *inLeft, float *inRight,
+                             float *outLeft, float *outRight,
+                             int inNumSamples,
+                             CoeffFilterState *inLeftState,
+                             CoeffFilterState *inRightState ) {
+    
+    CoeffFilterState *l = inLeftState;
+    CoeffFilterState *r = inRightState;
+    
+#if defined( COEFF_FILTER_SSE2 )
+    
+    // each filter is recursive, so samples can't be done in parallel,
+    // but the two channels can:  left in the low lane, right in the high
+    __m128d a1 = _mm_set_pd( r->a1, l->a1 );
+    __m128d a2 = _mm_set_pd( r->a2, l->a2 );
+    __m128d a3 = _mm_set_pd( r->a3, l->a3 );
+    __m128d b1 = _mm_set_pd( r->b1, l->b1 );
+    __m128d b2 = _mm_set_pd( r->b2, l->b2 );
+    
+    __m128d in0 = _mm_set_pd( r->lastIn[0], l->lastIn[0] );
+    __m128d in1 = _mm_set_pd( r->lastIn[1], l->lastIn[1] );
+    __m128d out0 = _mm_set_pd( r->lastOut[0], l->lastOut[0] );
+    __m128d out1 = _mm_set_pd( r->lastOut[1], l->lastOut[1] );
+    
+    for( int i=0; i<inNumSamples; i++ ) {
+        __m128d inSample = _mm_set_pd( inRight[i], inLeft[i] );
+
+        // same order of operations as coeffFilter
+        __m128d nextOut = 
+            _mm_sub_pd(
+                _mm_sub_pd(
+                    _mm_add_pd(
+                        _mm_add_pd( _mm_mul_pd( a1, inSample ),
+                                    _mm_mul_pd( a2, in0 ) ),
+                        _mm_mul_pd( a3, in1 ) ),
+                    _mm_mul_pd( b1, out0 ) ),
+                _mm_mul_pd( b2, out1 ) );
+        
+        in1 = in0;
+        in0 = inSample;
+        out1 = out0;
+        out0 = nextOut;
+        
+        outLeft[i] = (float)_mm_cvtsd_f64( nextOut );
+        outRight[i] = (float)_mm_cvtsd_f64( 
+            _mm_unpackhi_pd( nextOut, nextOut ) );
+        }
+    
+    double lanes[2];
+    
+    _mm_storeu_pd( lanes, in0 );
+    l->lastIn[0] = lanes[0];
+    r->lastIn[0] = lanes[1];
+    _mm_storeu_pd( lanes, in1 );
+    l->lastIn[1] = lanes[0];
+    r->lastIn[1] = lanes[1];
+    _mm_storeu_pd( lanes, out0 );
+    l->lastOut[0] = lanes[0];
+    r->lastOut[0] = lanes[1];
+    _mm_storeu_pd( lanes, out1 );
+    l->lastOut[1] = lanes[0];
+    r->lastOut[1] = lanes[1];
+
+#elif defined( COEFF_FILTER_NEON )
+    
+    double lanes[2];
+    
+    #define COEFF_FILTER_PAIR( field ) \
+        ( lanes[0] = l->field, lanes[1] = r->field, vld1q_f64( lanes ) )
+    
+    float64x2_t a1 = COEFF_FILTER_PAIR( a1 );
+    float64x2_t a2 = COEFF_FILTER_PAIR( a2 );
+    float64x2_t a3 = COEFF_FILTER_PAIR( a3 );
+    float64x2_t b1 = COEFF_FILTER_PAIR( b1 );
+    float64x2_t b2 = COEFF_FILTER_PAIR( b2 );
+    
+    float64x2_t in0 = COEFF_FILTER_PAIR( lastIn[0] );
+    float64x2_t in1 = COEFF_FILTER_PAIR( lastIn[1] );
+    float64x2_t out0 = COEFF_FILTER_PAIR( lastOut[0] );
+    float64x2_t out1 = COEFF_FILTER_PAIR( lastOut[1] );
+    
+    #undef COEFF_FILTER_PAIR
+    
+    for( int i=0; i<inNumSamples; i++ ) {
+        lanes[0] = inLeft[i];
+        lanes[1] = inRight[i];
+        float64x2_t inSample = vld1q_f64( lanes );
+        
+        // separate multiplies and adds (not fused), as in coeffFilter
+        float64x2_t nextOut = 
+            vsubq_f64(
+                vsubq_f64(
+                    vaddq_f64(
+                        vaddq_f64( vmulq_f64( a1, inSample ),
+                                   vmulq_f64( a2, in0 ) ),
+                        vmulq_f64( a3, in1 ) ),
+                    vmulq_f64( b1, out0 ) ),
+                vmulq_f64( b2, out1 ) );
+        
+        in1 = in0;
+        in0 = inSample;
+        out1 = out0;
+        out0 = nextOut;
+        
+        outLeft[i] = (float)vgetq_lane_f64( nextOut, 0 );
+        outRight[i] = (float)vgetq_lane_f64( nextOut, 1 );
+        }
+    
+    l->lastIn[0] = vgetq_lane_f64( in0, 0 );
+    r->lastIn[0] = vgetq_lane_f64( in0, 1 );
+    l->lastIn[1] = vgetq_lane_f64( in1, 0 );
+    r->lastIn[1] = vgetq_lane_f64( in1, 1 );
+    l->lastOut[0] = vgetq_lane_f64( out0, 0 );
+    r->lastOut[0] = vgetq_lane_f64( out0, 1 );
+    l->lastOut[1] = vgetq_lane_f64( out1, 0 );
+    r->lastOut[1] = vgetq_lane_f64( out1, 1 );
+
+#else
+    
+    coeffFilterBlock( inLeft, outLeft, inNumSamples, l );
+    coeffFilterBlock( inRight, outRight, inNumSamples, r );
+
+#endif
+    }
+
+
+
 void resetCoeffFilter( CoeffFilterState *s ) {
     for( int i=0; i<2; i++ ) {
         s->lastIn[i] = 0;
@@ -2,6 +2,10 @@
 // http://www.musicdsp.org/archive.php?classid=3#243
 // Posted by Patrice Tarrabia
 
+#ifndef COEFFICIENT_FILTERS_INCLUDED
+#define COEFFICIENT_FILTERS_INCLUDED
+
+
 typedef struct CoeffFilterState {
         double a1, a2, a3, b1, b2;
 
@@ -16,6 +20,22 @@ typedef struct CoeffFilterState {
 double coeffFilter( double inSample, CoeffFilterState *s );
 
 
+// filters a block of samples, which can be done in place
+// (inSamples == outSamples)
+void coeffFilterBlock( float *inSamples, float *outSamples, int inNumSamples,
+                       CoeffFilterState *s );
+
+
+// filters a block of samples on two channels at once, each through its
+// own state, which can be done in place
+// with SSE2, matches coeffFilterBlock on each channel exactly
+void coeffFilterStereoBlock( float *inLeft, float *inRight,
+                             float *outLeft, float *outRight,
+                             int inNumSamples,
+                             CoeffFilterState *inLeftState,
+                             CoeffFilterState *inRightState );
+
+
 // zeros out filter's buffers to prepare it for new audio
 void resetCoeffFilter( CoeffFilterState *s );
 
@@ -27,3 +47,7 @@ CoeffFilterState initHighPass( double inCutoffFreq, int inSampleRate,
 
 CoeffFilterState initLowPass( double inCutoffFreq, int inSampleRate,
                               double inRez );
+
+
+
+#endif
@@ -100,50 +100,47 @@ unsigned char *getAIFFHeader( int inNumChannels, int inSampleSizeInBits,
 
 
 
-int16_t *readMono16AIFFData( unsigned char *inData, int inNumBytes,
-                             int *outNumSamples, int *outSampleRate ) {
+char readMono16AIFFHeader( unsigned char *inData, int inNumBytes,
+                           int *outNumSamples, int *outSampleRate,
+                           int *outDataStartByte ) {
 
     // at least 54 bytes if both COMM and SSND chunks are present
     if( inNumBytes < 54 ) {
         printf( "AIFF not long enough for header\n" );
-        return NULL;
+        return false;
         }
     
     // byte 20 and 21 are num channels
 
     if( inData[20] != 0 || inData[21] != 1 ) {
         printf( "AIFF not mono\n" );
-        return NULL;
+        return false;
         }
     
     if( inData[26] != 0 || inData[27] != 16 ) {
         printf( "AIFF not 16-bit\n" );
-        return NULL;
+        return false;
         }
     
 
-    int numSamples =
+    *outNumSamples =
         inData[22] << 24 |
         inData[23] << 16 |
         inData[24] << 8 |
         inData[25];
 
 
-    int sampleRate =
+    *outSampleRate =
         inData[30] << 8 |
         inData[31];
     
-    if( outSampleRate != NULL ) {
-        *outSampleRate = sampleRate;
-        }
-
 
     int lookForSSNDByte = 38;
 
     // there may be other chunks before SSND chunk
     // walk forward until SSND is encountered
 
-    while( lookForSSNDByte < inNumBytes &&
+    while( lookForSSNDByte + 3 < inNumBytes &&
            ( inData[lookForSSNDByte] != 'S' ||
              inData[lookForSSNDByte + 1] != 'S' ||
              inData[lookForSSNDByte + 2] != 'N' ||
@@ -152,18 +149,39 @@ int16_t *readMono16AIFFData( unsigned char *inData, int inNumBytes,
         }
 
 
-    if( lookForSSNDByte >= inNumBytes ) {
+    if( lookForSSNDByte + 3 >= inNumBytes ) {
         printf( "SSND chunk not found in AIFF inData\n" );
-        return NULL;
+        return false;
         }
 
     // else lookForSSNDByte is at start of SSND
 
     // skip to data part of SSND chunk (skip header)
     
-    int sampleStartByte = lookForSSNDByte + 16;
-                        
+    *outDataStartByte = lookForSSNDByte + 16;
+
+    return true;
+    }
+
+
+
+int16_t *readMono16AIFFData( unsigned char *inData, int inNumBytes,
+                             int *outNumSamples, int *outSampleRate ) {
+
+    int numSamples;
+    int sampleRate;
+    int sampleStartByte;
     
+    if( ! readMono16AIFFHeader( inData, inNumBytes, &numSamples, &sampleRate,
+                                &sampleStartByte ) ) {
+        return NULL;
+        }
+    
+    if( outSampleRate != NULL ) {
+        *outSampleRate = sampleRate;
+        }
+
+                        
     int numBytes = numSamples * 2;
                         
     if( inNumBytes < sampleStartByte + numBytes ) {
@@ -3,6 +3,9 @@
  *
  * 2004-May-9   Jason Rohrer
  * Created.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Added readMono16AIFFHeader for reading sample data separately.
  */
 
 
@@ -41,4 +44,27 @@ int16_t *readMono16AIFFData( unsigned char *inData, int inNumBytes,
                              int *outSampleRate = NULL );
 
 
+
+/**
+ * Parses the header of a mono 16-bit AIFF file, for reading its samples
+ * separately (for example, in chunks as they are needed).
+ *
+ * @param inData the start of the file, at least through the start of
+ *   the SSND chunk.
+ * @param inNumBytes the number of bytes in inData.
+ * @param outNumSamples pointer to where the number of samples should
+ *   be returned.
+ * @param outSampleRate pointer to where the sample rate should be
+ *   returned.
+ * @param outDataStartByte pointer to where the offset of the first
+ *   sample in the file should be returned.  Samples are big endian.
+ *
+ * @return true on success, or false if inData is not the start of a
+ *   mono 16-bit AIFF file.
+ */
+char readMono16AIFFHeader( unsigned char *inData, int inNumBytes,
+                           int *outNumSamples, int *outSampleRate,
+                           int *outDataStartByte );
+
+
 #endif
@@ -0,0 +1,258 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14   Jason Rohrer
+ * Created.
+ */
+
+
+#include "soundSpriteMixer.h"
+
+#include <math.h>
+
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || \
+    ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+    #define SOUND_SPRITE_MIXER_SSE2
+    #include <emmintrin.h>
+#elif defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+    #define SOUND_SPRITE_MIXER_NEON
+    #include <arm_neon.h>
+#endif
+
+
+
+// 1 / 2^32, for turning low phase bits into a blend weight
+static const float phaseFractionScale = 1.0f / 4294967296.0f;
+
+
+
+uint64_t getSoundSpritePhaseStep( double inRate ) {
+    if( inRate <= 0 ) {
+        return 0;
+        }
+    return (uint64_t)llrint( inRate * (double)SOUND_SPRITE_PHASE_ONE );
+    }
+
+
+
+int mixSoundSpriteSamples( const int16_t *inSamples, int inNumSamples,
+                           int *ioSamplesPlayed,
+                           float inVolumeL, float inVolumeR,
+                           float *ioMixL, float *ioMixR,
+                           int inNumToFill ) {
+
+    int samplesPlayed = *ioSamplesPlayed;
+
+    int numToMix = inNumSamples - samplesPlayed;
+
+    if( numToMix > inNumToFill ) {
+        numToMix = inNumToFill;
+        }
+    if( numToMix <= 0 ) {
+        return 0;
+        }
+
+    const int16_t *source = &( inSamples[ samplesPlayed ] );
+
+    int i = 0;
+
+#if defined( SOUND_SPRITE_MIXER_SSE2 )
+
+    __m128 volL = _mm_set1_ps( inVolumeL );
+    __m128 volR = _mm_set1_ps( inVolumeR );
+
+    // 8 samples per step
+    for( ; i + 8 <= numToMix; i += 8 ) {
+        __m128i s16 = _mm_loadu_si128( (const __m128i *)( source + i ) );
+
+        // sign-extend to 32 bits by unpacking into high halves and
+        // shifting back down
+        __m128i lo32 = _mm_srai_epi32( _mm_unpacklo_epi16( s16, s16 ), 16 );
+        __m128i hi32 = _mm_srai_epi32( _mm_unpackhi_epi16( s16, s16 ), 16 );
+
+        __m128 lo = _mm_cvtepi32_ps( lo32 );
+        __m128 hi = _mm_cvtepi32_ps( hi32 );
+
+        _mm_storeu_ps( ioMixL + i,
+                       _mm_add_ps( _mm_loadu_ps( ioMixL + i ),
+                                   _mm_mul_ps( lo, volL ) ) );
+        _mm_storeu_ps( ioMixL + i + 4,
+                       _mm_add_ps( _mm_loadu_ps( ioMixL + i + 4 ),
+                                   _mm_mul_ps( hi, volL ) ) );
+        _mm_storeu_ps( ioMixR + i,
+                       _mm_add_ps( _mm_loadu_ps( ioMixR + i ),
+                                   _mm_mul_ps( lo, volR ) ) );
+        _mm_storeu_ps( ioMixR + i + 4,
+                       _mm_add_ps( _mm_loadu_ps( ioMixR + i + 4 ),
+                                   _mm_mul_ps( hi, volR ) ) );
+        }
+
+#elif defined( SOUND_SPRITE_MIXER_NEON )
+
+    float32x4_t volL = vdupq_n_f32( inVolumeL );
+    float32x4_t volR = vdupq_n_f32( inVolumeR );
+
+    for( ; i + 8 <= numToMix; i += 8 ) {
+        int16x8_t s16 = vld1q_s16( source + i );
+
+        float32x4_t lo = vcvtq_f32_s32( vmovl_s16( vget_low_s16( s16 ) ) );
+        float32x4_t hi = vcvtq_f32_s32( vmovl_s16( vget_high_s16( s16 ) ) );
+
+        vst1q_f32( ioMixL + i, vmlaq_f32( vld1q_f32( ioMixL + i ),
+                                          lo, volL ) );
+        vst1q_f32( ioMixL + i + 4, vmlaq_f32( vld1q_f32( ioMixL + i + 4 ),
+                                              hi, volL ) );
+        vst1q_f32( ioMixR + i, vmlaq_f32( vld1q_f32( ioMixR + i ),
+                                          lo, volR ) );
+        vst1q_f32( ioMixR + i + 4, vmlaq_f32( vld1q_f32( ioMixR + i + 4 ),
+                                              hi, volR ) );
+        }
+
+#endif
+
+    // scalar tail (or whole buffer if no vector unit)
+    for( ; i < numToMix; i++ ) {
+        float sample = source[i];
+
+        ioMixL[i] += inVolumeL * sample;
+        ioMixR[i] += inVolumeR * sample;
+        }
+
+    *ioSamplesPlayed = samplesPlayed + numToMix;
+
+    return numToMix;
+    }
+
+
+
+int mixSoundSpriteSamplesResampled( const int16_t *inSamples,
+                                    int inNumSamples,
+                                    uint64_t *ioPhase, uint64_t inPhaseStep,
+                                    float inVolumeL, float inVolumeR,
+                                    float *ioMixL, float *ioMixR,
+                                    int inNumToFill ) {
+
+    if( inNumSamples < 2 || inPhaseStep == 0 ) {
+        return 0;
+        }
+
+    // phase must stay below the last sample so that sample b exists
+    uint64_t phaseLimit =
+        (uint64_t)( inNumSamples - 1 ) << SOUND_SPRITE_PHASE_BITS;
+
+    uint64_t phase = *ioPhase;
+
+    int filled = 0;
+
+
+#if defined( SOUND_SPRITE_MIXER_SSE2 ) || defined( SOUND_SPRITE_MIXER_NEON )
+
+    // 4 output samples per step
+    // sample fetches are scalar (no gather), but the blend and accumulate
+    // are done 4-wide
+
+    uint64_t step4 = inPhaseStep * 4;
+
+    while( filled + 4 <= inNumToFill &&
+           phase + 3 * inPhaseStep < phaseLimit ) {
+
+        float a[4];
+        float b[4];
+        float w[4];
+
+        uint64_t p = phase;
+        for( int j=0; j<4; j++ ) {
+            int index = getSoundSpritePhaseIndex( p );
+            a[j] = inSamples[ index ];
+            b[j] = inSamples[ index + 1 ];
+            w[j] = (float)(uint32_t)p * phaseFractionScale;
+            p += inPhaseStep;
+            }
+
+    #if defined( SOUND_SPRITE_MIXER_SSE2 )
+        __m128 va = _mm_loadu_ps( a );
+        __m128 vb = _mm_loadu_ps( b );
+        __m128 vw = _mm_loadu_ps( w );
+
+        __m128 blend = _mm_add_ps( va, _mm_mul_ps( _mm_sub_ps( vb, va ),
+                                                   vw ) );
+
+        _mm_storeu_ps( ioMixL + filled,
+                       _mm_add_ps( _mm_loadu_ps( ioMixL + filled ),
+                                   _mm_mul_ps( blend,
+                                               _mm_set1_ps( inVolumeL ) ) ) );
+        _mm_storeu_ps( ioMixR + filled,
+                       _mm_add_ps( _mm_loadu_ps( ioMixR + filled ),
+                                   _mm_mul_ps( blend,
+                                               _mm_set1_ps( inVolumeR ) ) ) );
+    #else
+        float32x4_t va = vld1q_f32( a );
+        float32x4_t vb = vld1q_f32( b );
+        float32x4_t vw = vld1q_f32( w );
+
+        float32x4_t blend = vmlaq_f32( va, vsubq_f32( vb, va ), vw );
+
+        vst1q_f32( ioMixL + filled,
+                   vmlaq_f32( vld1q_f32( ioMixL + filled ),
+                              blend, vdupq_n_f32( inVolumeL ) ) );
+        vst1q_f32( ioMixR + filled,
+                   vmlaq_f32( vld1q_f32( ioMixR + filled ),
+                              blend, vdupq_n_f32( inVolumeR ) ) );
+    #endif
+
+        filled += 4;
+        phase += step4;
+        }
+
+#endif
+
+    while( filled < inNumToFill && phase < phaseLimit ) {
+        int index = getSoundSpritePhaseIndex( phase );
+
+        float sampleA = inSamples[ index ];
+        float sampleB = inSamples[ index + 1 ];
+
+        float bWeight = (float)(uint32_t)phase * phaseFractionScale;
+
+        float sampleBlend = sampleA + ( sampleB - sampleA ) * bWeight;
+
+        ioMixL[ filled ] += inVolumeL * sampleBlend;
+        ioMixR[ filled ] += inVolumeR * sampleBlend;
+
+        filled ++;
+        phase += inPhaseStep;
+        }
+
+    *ioPhase = phase;
+
+    return filled;
+    }
+
+
+
+void scaleSoundSpriteMix( float *ioMixL, float *ioMixR, int inNumSamples,
+                          float inGain ) {
+    int i = 0;
+
+#if defined( SOUND_SPRITE_MIXER_SSE2 )
+    __m128 gain = _mm_set1_ps( inGain );
+
+    for( ; i + 4 <= inNumSamples; i += 4 ) {
+        _mm_storeu_ps( ioMixL + i,
+                       _mm_mul_ps( _mm_loadu_ps( ioMixL + i ), gain ) );
+        _mm_storeu_ps( ioMixR + i,
+                       _mm_mul_ps( _mm_loadu_ps( ioMixR + i ), gain ) );
+        }
+#elif defined( SOUND_SPRITE_MIXER_NEON )
+    for( ; i + 4 <= inNumSamples; i += 4 ) {
+        vst1q_f32( ioMixL + i, vmulq_n_f32( vld1q_f32( ioMixL + i ), inGain ) );
+        vst1q_f32( ioMixR + i, vmulq_n_f32( vld1q_f32( ioMixR + i ), inGain ) );
+        }
+#endif
+
+    for( ; i < inNumSamples; i++ ) {
+        ioMixL[i] *= inGain;
+        ioMixR[i] *= inGain;
+        }
+    }
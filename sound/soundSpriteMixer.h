@@ -0,0 +1,96 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14   Jason Rohrer
+ * Created.  Vectorized replacement for scalar mixing loop in gameSDL.
+ */
+
+
+
+#ifndef SOUND_SPRITE_MIXER_INCLUDED
+#define SOUND_SPRITE_MIXER_INCLUDED
+
+
+#include <stdint.h>
+
+
+
+// sample positions during variable-rate playback are tracked as 32.32
+// fixed-point phase values (integer sample index in the high 32 bits,
+// fractional position in the low 32 bits)
+#define SOUND_SPRITE_PHASE_BITS 32
+
+#define SOUND_SPRITE_PHASE_ONE ( (uint64_t)1 << SOUND_SPRITE_PHASE_BITS )
+
+
+
+// converts a playback rate (1.0 is normal speed) into a per-output-sample
+// phase step
+uint64_t getSoundSpritePhaseStep( double inRate );
+
+
+// integer sample index of a phase value
+inline int getSoundSpritePhaseIndex( uint64_t inPhase ) {
+    return (int)( inPhase >> SOUND_SPRITE_PHASE_BITS );
+    }
+
+
+
+/**
+ * Mixes int16 samples at normal rate into float accumulation buffers.
+ *
+ * Uses SSE2 or NEON where available, with a scalar fallback.
+ *
+ * @param inSamples the source samples.
+ * @param inNumSamples the total number of source samples.
+ * @param ioSamplesPlayed pointer to index of next source sample to play.
+ *   Advanced by the number of samples mixed.
+ * @param inVolumeL, inVolumeR the per-channel gains.
+ * @param ioMixL, ioMixR the accumulation buffers to add into.
+ * @param inNumToFill the number of output samples wanted.
+ *
+ * @return the number of output samples filled, which may be less than
+ *   inNumToFill if the source ran out.
+ */
+int mixSoundSpriteSamples( const int16_t *inSamples, int inNumSamples,
+                           int *ioSamplesPlayed,
+                           float inVolumeL, float inVolumeR,
+                           float *ioMixL, float *ioMixR,
+                           int inNumToFill );
+
+
+
+/**
+ * Mixes int16 samples at a variable rate into float accumulation buffers,
+ * linearly interpolating between neighboring source samples.
+ *
+ * Playback stops once the phase reaches the last source sample (the last
+ * sample is never mixed, because it has no right-hand neighbor).
+ *
+ * @param inSamples the source samples.
+ * @param inNumSamples the total number of source samples.
+ * @param ioPhase pointer to 32.32 fixed-point position of next sample.
+ *   Advanced by inPhaseStep for each sample mixed.
+ * @param inPhaseStep the phase step, from getSoundSpritePhaseStep.
+ * @param inVolumeL, inVolumeR the per-channel gains.
+ * @param ioMixL, ioMixR the accumulation buffers to add into.
+ * @param inNumToFill the number of output samples wanted.
+ *
+ * @return the number of output samples filled.
+ */
+int mixSoundSpriteSamplesResampled( const int16_t *inSamples,
+                                    int inNumSamples,
+                                    uint64_t *ioPhase, uint64_t inPhaseStep,
+                                    float inVolumeL, float inVolumeR,
+                                    float *ioMixL, float *ioMixR,
+                                    int inNumToFill );
+
+
+
+// multiplies both channels of a buffer by a constant gain
+void scaleSoundSpriteMix( float *ioMixL, float *ioMixR, int inNumSamples,
+                          float inGain );
+
+
+
+#endif
@@ -7,6 +7,10 @@
  *
  * 2005-January-9    Jason Rohrer
  * Changed to sleep on a semaphore to allow sleep to be interrupted.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Added runThread, which runs threads on a capped set of reused worker
+ * threads instead of starting a new OS thread for each.
  */
 
 
@@ -15,11 +19,47 @@
 
 
 
-FinishedSignalThreadManager::FinishedSignalThreadManager()
+class FinishedSignalThreadWorker : public Thread {
+
+    public:
+
+        FinishedSignalThreadWorker( FinishedSignalThreadManager *inManager )
+                : mManager( inManager ) {
+            start();
+            }
+
+        ~FinishedSignalThreadWorker() {
+            join();
+            }
+
+
+        void run() {
+            mManager->workerLoop();
+            }
+
+
+    protected:
+
+        FinishedSignalThreadManager *mManager;
+
+    };
+
+
+
+FinishedSignalThreadManager::FinishedSignalThreadManager(
+    int inMaxPooledThreads )
     : mLock( new MutexLock() ),
       mThreadVector( new SimpleVector<FinishedSignalThread *>() ),
       mStopSignal( false ),
-      mSleepSemaphore( new BinarySemaphore() ) {
+      mSleepSemaphore( new BinarySemaphore() ),
+      mMaxPooledThreads( inMaxPooledThreads ),
+      mNumIdleWorkers( 0 ),
+      mNextPending( 0 ),
+      mPendingSemaphore( 0 ) {
+
+    if( mMaxPooledThreads < 1 ) {
+        mMaxPooledThreads = 1;
+        }
 
     this->start();
     }
@@ -36,6 +76,21 @@ FinishedSignalThreadManager::~FinishedSignalThreadManager() {
     
     this->join();
 
+
+    // one extra signal for each worker, which it only gets once nothing
+    // is pending
+    int numWorkers = mWorkers.size();
+
+    for( int i=0; i<numWorkers; i++ ) {
+        mPendingSemaphore.signal();
+        }
+
+    // workers run any pending threads before they stop
+    for( int i=0; i<numWorkers; i++ ) {
+        delete mWorkers.getElementDirect( i );
+        }
+    
+
     mLock->lock();
 
     // destroy all remaining threads
@@ -67,6 +122,76 @@ void FinishedSignalThreadManager::addThread(
 
 
 
+void FinishedSignalThreadManager::runThread(
+    FinishedSignalThread *inThread ) {
+
+    mLock->lock();
+
+    mPending.push_back( inThread );
+
+    int numWaiting = mPending.size() - mNextPending;
+
+    if( numWaiting > mNumIdleWorkers &&
+        mWorkers.size() < mMaxPooledThreads ) {
+
+        // counted as idle until it takes a thread
+        mNumIdleWorkers++;
+        mWorkers.push_back( new FinishedSignalThreadWorker( this ) );
+        }
+
+    mLock->unlock();
+
+    mPendingSemaphore.signal();
+    }
+
+
+
+void FinishedSignalThreadManager::workerLoop() {
+
+    while( true ) {
+        mPendingSemaphore.wait();
+
+        mLock->lock();
+
+        if( mNextPending == mPending.size() ) {
+            // each runThread signal comes after its thread is pending,
+            // so this is a stop signal
+            mLock->unlock();
+            return;
+            }
+
+        FinishedSignalThread *thread =
+            mPending.getElementDirect( mNextPending );
+        mNextPending++;
+
+        if( mNextPending == mPending.size() ) {
+            mPending.deleteAll();
+            mNextPending = 0;
+            }
+        else if( mNextPending > 64 && mNextPending * 2 > mPending.size() ) {
+            // compact now and then, so taking stays cheap
+            mPending.deleteStartElements( mNextPending );
+            mNextPending = 0;
+            }
+
+        mNumIdleWorkers--;
+
+        mLock->unlock();
+
+
+        thread->run();
+
+        delete thread;
+
+
+        mLock->lock();
+        mNumIdleWorkers++;
+        mLock->unlock();
+        }
+    }
+
+
+
 void FinishedSignalThreadManager::run() {
     
     char stopped;
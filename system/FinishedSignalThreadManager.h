@@ -7,6 +7,10 @@
  *
  * 2005-January-9    Jason Rohrer
  * Changed to sleep on a semaphore to allow sleep to be interrupted.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Added runThread, which runs threads on a capped set of reused worker
+ * threads instead of starting a new OS thread for each.
  */
 
 
@@ -22,12 +26,26 @@
 #include "minorGems/system/Thread.h"
 #include "minorGems/system/MutexLock.h"
 #include "minorGems/system/BinarySemaphore.h"
+#include "minorGems/system/Semaphore.h"
+
+
+
+// default cap on threads used by runThread
+#define FINISHED_SIGNAL_THREAD_MANAGER_MAX_POOLED 32
+
+
+
+class FinishedSignalThreadWorker;
 
 
 
 /**
  * A thread that manages the destruction of FinishedSignalThreads.
  *
+ * Threads can either be started by the caller and passed to addThread,
+ * or passed to runThread to run on one of a set of worker threads that
+ * are kept around and reused.
+ *
  * @author Jason Rohrer.
  */
 class FinishedSignalThreadManager : public Thread {
@@ -38,13 +56,22 @@ class FinishedSignalThreadManager : public Thread {
         
         /**
          * Constructs and starts this manager.
+         *
+         * @param inMaxPooledThreads the most threads passed to runThread
+         *   that can run at once.  Defaults to
+         *   FINISHED_SIGNAL_THREAD_MANAGER_MAX_POOLED.
          */
-        FinishedSignalThreadManager();
+        FinishedSignalThreadManager(
+            int inMaxPooledThreads =
+            FINISHED_SIGNAL_THREAD_MANAGER_MAX_POOLED );
 
 
         
         /**
          * Stops and destroys this manager.
+         *
+         * Threads passed to runThread that haven't run yet are run before
+         * this returns.
          */
         ~FinishedSignalThreadManager();
 
@@ -58,6 +85,20 @@ class FinishedSignalThreadManager : public Thread {
          */
         void addThread( FinishedSignalThread *inThread );
 
+
+
+        /**
+         * Runs a thread's run method on a reused worker thread.
+         *
+         * Workers are started as needed, up to inMaxPooledThreads, and
+         * then kept for later calls.  If all are busy, inThread waits in
+         * a queue until one is free.
+         *
+         * @param inThread the thread to run.  Must not have been started.
+         *   Destroyed by this class as soon as its run method returns.
+         */
+        void runThread( FinishedSignalThread *inThread );
+
         
 
         // implements the Thread interface
@@ -73,6 +114,27 @@ class FinishedSignalThreadManager : public Thread {
         char mStopSignal;
 
         BinarySemaphore *mSleepSemaphore;
+
+
+        friend class FinishedSignalThreadWorker;
+
+        // protected by mLock
+        int mMaxPooledThreads;
+        SimpleVector<FinishedSignalThreadWorker *> mWorkers;
+        int mNumIdleWorkers;
+
+        // waiting for a worker, oldest first, with entries before
+        // mNextPending already taken
+        SimpleVector<FinishedSignalThread *> mPending;
+        int mNextPending;
+
+        // signaled once for each runThread call, and once for each
+        // worker when stopping
+        Semaphore mPendingSemaphore;
+
+
+        // runs worker until stopped
+        void workerLoop();
         
     };
 
@@ -13,6 +13,9 @@
  *
  * 2011-March-9    Jason Rohrer
  * Removed Fortify inclusion.
+ *
+ * 2026-October-14   Jason Rohrer
+ * Added optional lock names and contention profiling.
  */
 
 
@@ -21,6 +24,8 @@
 #define MUTEX_LOCK_CLASS_INCLUDED
 
 
+#include <stddef.h>
+
 
 
 
@@ -32,6 +37,11 @@
  *   separately for each platform (in the mac/ linux/ and win32/ 
  *   subdirectories).
  *
+ * Built with MUTEX_LOCK_PROFILING defined (for all of minorGems), each
+ * lock records how long threads wait for it, how long it is held, and
+ * how often it was contended, and logProfile dumps these stats.
+ * See MutexLockProfile.cpp.
+ *
  * @author Jason Rohrer
  */
 class MutexLock {
@@ -39,9 +49,13 @@ class MutexLock {
 	public:
 		
 		/**
-		 * Constructs a mutex lock;
+		 * Constructs a mutex lock.
+		 *
+		 * @param inName the name to report this lock under when
+		 *   profiling, or NULL to report it as unnamed.  Must be a
+		 *   string constant (not copied).  Defaults to NULL.
 		 */
-		MutexLock();
+		MutexLock( const char *inName = NULL );
 		
 		~MutexLock();
 		
@@ -58,6 +72,16 @@ class MutexLock {
 		void unlock();
 
 
+		
+		/**
+		 * Logs profiling stats for all locks through AppLog, grouped
+		 * by name, longest total wait first.
+		 *
+		 * Does nothing unless built with MUTEX_LOCK_PROFILING defined.
+		 */
+		static void logProfile();
+		
+
 	private:
 	
 		/**
@@ -65,6 +89,9 @@ class MutexLock {
 		 */		
 		void *mNativeObjectPointer;
 
+		// stats record, or NULL when not profiling
+		void *mProfile;
+
 	};
 
 
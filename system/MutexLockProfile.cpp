@@ -0,0 +1,393 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14   Jason Rohrer
+ * Created.
+ */
+
+#include "minorGems/common.h"
+
+
+
+#include "minorGems/system/MutexLock.h"
+
+
+/**
+ * Lock contention profiling, shared by all platform-specific MutexLock
+ * implementations.
+ *
+ * To use, define MUTEX_LOCK_PROFILING for the whole build (including
+ * MutexLock${PLATFORM}.cpp), give locks of interest names, and call
+ * MutexLock::logProfile, perhaps once at exit.  For example, in a game
+ * build, set LOCK_PROFILE_FLAG in Makefile.common.
+ *
+ * Costs two clock reads per lock/unlock, so totals include a bit of
+ * profiling overhead.
+ */
+
+
+
+#ifndef MUTEX_LOCK_PROFILING
+
+
+void MutexLock::logProfile() {
+	}
+
+
+#else
+
+
+
+#include "minorGems/system/MutexLockProfile.h"
+#include "minorGems/system/atomicOps.h"
+#include "minorGems/util/log/AppLog.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <time.h>
+	#include <sched.h>
+#endif
+
+
+
+typedef struct MutexLockStats {
+		int lockCount;
+		int contendedCount;
+
+		double totalWaitTime;
+		double maxWaitTime;
+
+		double totalHoldTime;
+		double maxHoldTime;
+	} MutexLockStats;
+
+
+
+typedef struct MutexLockProfileRecord {
+		// never NULL
+		const char *name;
+
+		MutexLockStats stats;
+
+		// for hold time
+		double lockedTime;
+
+		// >1 when locked again by holder (Win32 locks are recursive)
+		int lockDepth;
+
+		MutexLockProfileRecord *next;
+		MutexLockProfileRecord *previous;
+	} MutexLockProfileRecord;
+
+
+
+// these are all protected by registryLock
+// they are plain zero-initialized data, since static MutexLocks are
+// constructed (and destroyed) in no particular order with respect to
+// other statics
+
+// we can't use a MutexLock for this, since constructing one uses it
+static volatile int registryLock = 0;
+
+// records of existing locks, most recent first
+static MutexLockProfileRecord *liveRecords = NULL;
+
+// one per name, holding stats merged from destroyed locks
+static MutexLockProfileRecord *destroyedRecords = NULL;
+
+
+
+static void lockRegistry() {
+	while( atomicExchange( &registryLock, 1 ) != 0 ) {
+		// only held briefly, but holder may be switched out
+		#ifdef _WIN32
+			SwitchToThread();
+		#else
+			sched_yield();
+		#endif
+		}
+	}
+
+
+
+static void unlockRegistry() {
+	atomicStore( &registryLock, 0 );
+	}
+
+
+
+static void addStats( MutexLockStats *inTo, MutexLockStats *inFrom ) {
+	inTo->lockCount += inFrom->lockCount;
+	inTo->contendedCount += inFrom->contendedCount;
+
+	inTo->totalWaitTime += inFrom->totalWaitTime;
+	inTo->totalHoldTime += inFrom->totalHoldTime;
+
+	if( inFrom->maxWaitTime > inTo->maxWaitTime ) {
+		inTo->maxWaitTime = inFrom->maxWaitTime;
+		}
+	if( inFrom->maxHoldTime > inTo->maxHoldTime ) {
+		inTo->maxHoldTime = inFrom->maxHoldTime;
+		}
+	}
+
+
+
+void *mutexLockProfileCreate( const char *inName ) {
+	// malloc instead of new, as with MutexLock itself, since
+	// debugMemory uses a MutexLock
+	MutexLockProfileRecord *r =
+		(MutexLockProfileRecord *)malloc( sizeof( MutexLockProfileRecord ) );
+
+	memset( r, 0, sizeof( MutexLockProfileRecord ) );
+
+	r->name = inName;
+
+	if( r->name == NULL ) {
+		r->name = "unnamed";
+		}
+
+	lockRegistry();
+
+	r->next = liveRecords;
+	if( liveRecords != NULL ) {
+		liveRecords->previous = r;
+		}
+	liveRecords = r;
+
+	unlockRegistry();
+
+	return r;
+	}
+
+
+
+void mutexLockProfileDestroy( void *inProfile ) {
+	MutexLockProfileRecord *r = (MutexLockProfileRecord *)inProfile;
+
+	lockRegistry();
+
+	if( r->previous != NULL ) {
+		r->previous->next = r->next;
+		}
+	else {
+		liveRecords = r->next;
+		}
+	if( r->next != NULL ) {
+		r->next->previous = r->previous;
+		}
+
+
+	MutexLockProfileRecord *destroyed = destroyedRecords;
+
+	while( destroyed != NULL && strcmp( destroyed->name, r->name ) != 0 ) {
+		destroyed = destroyed->next;
+		}
+
+	if( destroyed != NULL ) {
+		addStats( &( destroyed->stats ), &( r->stats ) );
+		free( r );
+		}
+	else {
+		// keep this one as the record for its name
+		r->previous = NULL;
+		r->next = destroyedRecords;
+		destroyedRecords = r;
+		}
+
+	unlockRegistry();
+	}
+
+
+
+double mutexLockProfileTime() {
+	#ifdef _WIN32
+		static double secondsPerCount = 0;
+
+		LARGE_INTEGER count;
+
+		if( secondsPerCount == 0 ) {
+			LARGE_INTEGER frequency;
+			QueryPerformanceFrequency( &frequency );
+
+			secondsPerCount = 1.0 / (double)( frequency.QuadPart );
+			}
+
+		QueryPerformanceCounter( &count );
+
+		return (double)( count.QuadPart ) * secondsPerCount;
+	#else
+		struct timespec now;
+		clock_gettime( CLOCK_MONOTONIC, &now );
+
+		return now.tv_sec + now.tv_nsec / 1000000000.0;
+	#endif
+	}
+
+
+
+void mutexLockProfileLocked( void *inProfile, double inWaitStartTime ) {
+	MutexLockProfileRecord *r = (MutexLockProfileRecord *)inProfile;
+
+	r->lockDepth++;
+
+	if( r->lockDepth > 1 ) {
+		return;
+		}
+
+	r->lockedTime = mutexLockProfileTime();
+
+	r->stats.lockCount++;
+
+	if( inWaitStartTime != -1 ) {
+		r->stats.contendedCount++;
+
+		double waitTime = r->lockedTime - inWaitStartTime;
+
+		r->stats.totalWaitTime += waitTime;
+
+		if( waitTime > r->stats.maxWaitTime ) {
+			r->stats.maxWaitTime = waitTime;
+			}
+		}
+	}
+
+
+
+void mutexLockProfileUnlocking( void *inProfile ) {
+	MutexLockProfileRecord *r = (MutexLockProfileRecord *)inProfile;
+
+	r->lockDepth--;
+
+	if( r->lockDepth > 0 ) {
+		return;
+		}
+
+	double holdTime = mutexLockProfileTime() - r->lockedTime;
+
+	r->stats.totalHoldTime += holdTime;
+
+	if( holdTime > r->stats.maxHoldTime ) {
+		r->stats.maxHoldTime = holdTime;
+		}
+	}
+
+
+
+typedef struct MutexLockNameStats {
+		const char *name;
+		int numLocks;
+		MutexLockStats stats;
+	} MutexLockNameStats;
+
+
+
+// adds inRecord to entry for its name in inTable, making a new entry
+// if needed
+static void addToTable( MutexLockNameStats *inTable, int *ioNumEntries,
+						MutexLockProfileRecord *inRecord,
+						int inNumLocks ) {
+
+	for( int i=0; i<*ioNumEntries; i++ ) {
+		if( strcmp( inTable[i].name, inRecord->name ) == 0 ) {
+			addStats( &( inTable[i].stats ), &( inRecord->stats ) );
+			inTable[i].numLocks += inNumLocks;
+			return;
+			}
+		}
+
+	MutexLockNameStats *e = &( inTable[ *ioNumEntries ] );
+
+	e->name = inRecord->name;
+	e->numLocks = inNumLocks;
+	e->stats = inRecord->stats;
+
+	(*ioNumEntries)++;
+	}
+
+
+
+void MutexLock::logProfile() {
+
+	// gather into table without logging, since logging locks too
+
+	lockRegistry();
+
+	int numLive = 0;
+	int numDestroyedNames = 0;
+
+	MutexLockProfileRecord *r;
+
+	for( r = liveRecords; r != NULL; r = r->next ) {
+		numLive++;
+		}
+	for( r = destroyedRecords; r != NULL; r = r->next ) {
+		numDestroyedNames++;
+		}
+
+	int maxEntries = numLive + numDestroyedNames;
+
+	MutexLockNameStats *table =
+		(MutexLockNameStats *)malloc(
+			sizeof( MutexLockNameStats ) * ( maxEntries + 1 ) );
+
+	int numEntries = 0;
+
+	// live lock stats can change as we read them, so numbers for busy
+	// locks may be slightly off
+	for( r = liveRecords; r != NULL; r = r->next ) {
+		addToTable( table, &numEntries, r, 1 );
+		}
+	for( r = destroyedRecords; r != NULL; r = r->next ) {
+		// count of destroyed locks isn't kept
+		addToTable( table, &numEntries, r, 0 );
+		}
+
+	unlockRegistry();
+
+
+	// longest total wait first
+	for( int i=1; i<numEntries; i++ ) {
+		MutexLockNameStats e = table[i];
+
+		int j = i - 1;
+		while( j >= 0 &&
+			   table[j].stats.totalWaitTime < e.stats.totalWaitTime ) {
+			table[ j + 1 ] = table[j];
+			j--;
+			}
+		table[ j + 1 ] = e;
+		}
+
+
+	AppLog::infoF( "MutexLock profile, %d names, %d locks alive:\n",
+				   numEntries, numLive );
+
+	for( int i=0; i<numEntries; i++ ) {
+		MutexLockNameStats *e = &( table[i] );
+
+		if( e->stats.lockCount == 0 ) {
+			continue;
+			}
+
+		AppLog::infoF(
+			"  %-24s alive %4d, locked %9d, contended %7d (%5.2f%%), "
+			"wait %9.3f ms (max %7.3f), hold %9.3f ms (max %7.3f)\n",
+			e->name, e->numLocks,
+			e->stats.lockCount, e->stats.contendedCount,
+			100.0 * e->stats.contendedCount / e->stats.lockCount,
+			1000 * e->stats.totalWaitTime, 1000 * e->stats.maxWaitTime,
+			1000 * e->stats.totalHoldTime, 1000 * e->stats.maxHoldTime );
+		}
+
+	free( table );
+	}
+
+
+
+#endif
@@ -0,0 +1,53 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14   Jason Rohrer
+ * Created.
+ */
+
+
+
+#ifndef MUTEX_LOCK_PROFILE_INCLUDED
+#define MUTEX_LOCK_PROFILE_INCLUDED
+
+
+
+/**
+ * Hooks used by the platform-specific MutexLock implementations in
+ * builds with MUTEX_LOCK_PROFILING defined.  Not for use elsewhere.
+ *
+ * Stats in a record are only changed by the thread holding its lock,
+ * so they need no locking of their own.
+ *
+ * @author Jason Rohrer
+ */
+
+
+
+// returns a new stats record for a lock
+// inName is a string constant, or NULL
+void *mutexLockProfileCreate( const char *inName );
+
+
+// merges record's stats into those of any destroyed locks with the same
+// name, and destroys it
+void mutexLockProfileDestroy( void *inProfile );
+
+
+// current time in seconds, with better than microsecond resolution
+// where the platform allows
+double mutexLockProfileTime();
+
+
+// called by thread just after it acquires the lock
+// inWaitStartTime is when it started waiting, or -1 if the lock was
+// free (not contended)
+void mutexLockProfileLocked( void *inProfile, double inWaitStartTime );
+
+
+// called by thread holding the lock just before it releases it
+void mutexLockProfileUnlocking( void *inProfile );
+
+
+
+#endif
@@ -0,0 +1,188 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14   Jason Rohrer
+ * Created.
+ */
+
+#include "minorGems/common.h"
+
+
+
+#ifndef READ_WRITE_LOCK_INCLUDED
+#define READ_WRITE_LOCK_INCLUDED
+
+
+#include "minorGems/system/Semaphore.h"
+#include "minorGems/system/atomicOps.h"
+
+
+
+// state word packs three counts of up to 1023 threads each
+#define RW_LOCK_COUNT_BITS 10
+#define RW_LOCK_COUNT_MASK ( ( 1 << RW_LOCK_COUNT_BITS ) - 1 )
+
+// threads holding read lock
+#define RW_LOCK_READERS_SHIFT 0
+// threads waiting for read lock
+#define RW_LOCK_WAITING_READERS_SHIFT RW_LOCK_COUNT_BITS
+// threads holding or waiting for write lock
+#define RW_LOCK_WRITERS_SHIFT ( 2 * RW_LOCK_COUNT_BITS )
+
+#define RW_LOCK_GET_COUNT( inState, inShift ) \
+    ( ( ( inState ) >> ( inShift ) ) & RW_LOCK_COUNT_MASK )
+
+
+
+/**
+ * Lock that any number of readers can hold at once, or one writer.
+ *
+ * For tables read far more often than written.  Taking or releasing
+ * either side uncontended is one atomic operation, and threads only
+ * sleep (on a Semaphore) when they actually must wait.
+ *
+ * Writers take priority:  once a writer is waiting, new readers wait
+ * behind it, so a steady stream of readers can't starve writers.
+ *
+ * Not recursive.  A thread holding the read lock must not lock again
+ * (for reading or writing), since a waiting writer would deadlock it.
+ *
+ * At most 1023 threads can use one lock at once.
+ *
+ * Platform-independent.
+ *
+ * @author Jason Rohrer
+ */
+class ReadWriteLock {
+
+    public:
+
+        ReadWriteLock();
+
+
+        // blocks while a writer holds or waits for the lock
+        void lockRead();
+
+        void unlockRead();
+
+
+        // blocks while anyone else holds the lock
+        void lockWrite();
+
+        void unlockWrite();
+
+
+    protected:
+
+        volatile int mState;
+
+        // readers waiting for a writer to finish
+        Semaphore mReadSemaphore;
+
+        // writers waiting for readers or another writer to finish
+        Semaphore mWriteSemaphore;
+
+    };
+
+
+
+inline ReadWriteLock::ReadWriteLock()
+        : mState( 0 ) {
+    }
+
+
+
+inline void ReadWriteLock::lockRead() {
+    char mustWait;
+
+    // retry if state changed under us
+    while( true ) {
+        int oldState = atomicLoad( &mState );
+        int newState;
+
+        mustWait = ( RW_LOCK_GET_COUNT( oldState, RW_LOCK_WRITERS_SHIFT )
+                     > 0 );
+
+        if( mustWait ) {
+            newState = oldState + ( 1 << RW_LOCK_WAITING_READERS_SHIFT );
+            }
+        else {
+            newState = oldState + ( 1 << RW_LOCK_READERS_SHIFT );
+            }
+
+        if( atomicCompareExchange( &mState, oldState, newState ) ) {
+            break;
+            }
+        }
+
+    if( mustWait ) {
+        // last writer counts us as a reader before waking us
+        mReadSemaphore.wait();
+        }
+    }
+
+
+
+inline void ReadWriteLock::unlockRead() {
+    int oldState =
+        atomicFetchAdd( &mState, -( 1 << RW_LOCK_READERS_SHIFT ) );
+
+    if( RW_LOCK_GET_COUNT( oldState, RW_LOCK_READERS_SHIFT ) == 1 &&
+        RW_LOCK_GET_COUNT( oldState, RW_LOCK_WRITERS_SHIFT ) > 0 ) {
+        // last reader out, let a waiting writer in
+        mWriteSemaphore.signal();
+        }
+    }
+
+
+
+inline void ReadWriteLock::lockWrite() {
+    int oldState = atomicFetchAdd( &mState, 1 << RW_LOCK_WRITERS_SHIFT );
+
+    if( RW_LOCK_GET_COUNT( oldState, RW_LOCK_READERS_SHIFT ) > 0 ||
+        RW_LOCK_GET_COUNT( oldState, RW_LOCK_WRITERS_SHIFT ) > 0 ) {
+        // last reader out, or writer before us, signals us
+        mWriteSemaphore.wait();
+        }
+    }
+
+
+
+inline void ReadWriteLock::unlockWrite() {
+    int oldState;
+    int waitingReaders;
+
+    // retry if state changed under us
+    while( true ) {
+        oldState = atomicLoad( &mState );
+
+        int newState = oldState - ( 1 << RW_LOCK_WRITERS_SHIFT );
+
+        waitingReaders =
+            RW_LOCK_GET_COUNT( oldState, RW_LOCK_WAITING_READERS_SHIFT );
+
+        if( waitingReaders > 0 ) {
+            // readers that waited for us go next, ahead of any other
+            // writers, so that writers can't starve readers either
+            newState -= waitingReaders << RW_LOCK_WAITING_READERS_SHIFT;
+            newState += waitingReaders << RW_LOCK_READERS_SHIFT;
+            }
+
+        if( atomicCompareExchange( &mState, oldState, newState ) ) {
+            break;
+            }
+        }
+
+    if( waitingReaders > 0 ) {
+        for( int i=0; i<waitingReaders; i++ ) {
+            mReadSemaphore.signal();
+            }
+        }
+    else if( RW_LOCK_GET_COUNT( oldState, RW_LOCK_WRITERS_SHIFT ) > 1 ) {
+        mWriteSemaphore.signal();
+        }
+    }
+
+
+
+#endif
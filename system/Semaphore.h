@@ -21,6 +21,10 @@
  *
  * 2004-January-9   Jason Rohrer
  * Fixed a preprocessor error.
+ *
+ * 2026-October-14   Jason Rohrer
+ * Replaced mutex semaphore with an atomic counter, so that signal and
+ * wait only touch the blocking semaphore when a thread must sleep.
  */
 
 #include "minorGems/common.h" 
@@ -32,14 +36,21 @@
 
 #include "MutexLock.h"
 #include "BinarySemaphore.h"
+#include "atomicOps.h"
+
+
+// tries at taking a signal before registering as a waiter
+#define SEMAPHORE_SPIN_COUNT 50
 
 
 /**
  * General semaphore with an unbounded value.
  *
- * This class uses BinarySemaphores to implement general semaphores,
- * so it relies on platform-specific BinarySemaphore implementations, 
- * but this class itself is platform-independent.
+ * The value is an atomic counter, which goes negative while threads are
+ * waiting.  A wait that finds the value positive, or a signal with no
+ * thread waiting, is a single atomic operation.  Only sleeping and waking
+ * use the (platform-specific) BinarySemaphore, but this class itself is
+ * platform-independent.
  *
  * @author Jason Rohrer
  */
@@ -66,6 +77,7 @@ class Semaphore {
          *
          * @param inTimeoutInMilliseconds the maximum time to wait in
          *   milliseconds, or -1 to wait forever.  Defaults to -1.
+         *   (Can run over when several threads are waiting at once.)
          *
          * @return 1 if the semaphore was signaled, or 0 if it timed out.
 		 */
@@ -89,113 +101,155 @@ class Semaphore {
 
 	private:
 		
-		// starts at 0
-		int mSemaphoreValue;
-		
-		// mutex semaphore starts at 1
-		BinarySemaphore *mMutexSemaphore;
-		// blocking semaphore starts at 0
+		// number of signals available, or minus the number of waiters
+		volatile int mSemaphoreValue;
+
+		// signals owed to waiters that haven't picked them up yet
+		// protected by mWakeLock
+		int mNumWakeups;
+
+		MutexLock *mWakeLock;
+
+		// signaled once per wake-up, though several signals can merge
+		// into one, so a waiter that picks up a wake-up passes the signal
+		// on if more are owed
 		BinarySemaphore *mBlockingSemaphore;
+
+
+		// takes a signal without waiting, if one is available
+		char tryWait();
+
+		// waits for a wake-up owed by signal
+		// returns 1 if one was picked up, or 0 on timeout
+		int waitForWakeup( int inTimeoutInMilliseconds );
 	};
 
 
 
 inline Semaphore::Semaphore( int inStartingValue )
 	: mSemaphoreValue( inStartingValue ), 
-	mMutexSemaphore( new BinarySemaphore() ),
-	mBlockingSemaphore(  new BinarySemaphore() ) {
+	  mNumWakeups( 0 ),
+	  mWakeLock( new MutexLock() ),
+	  mBlockingSemaphore(  new BinarySemaphore() ) {
 	
-	// increment the mutex semaphore to 1
-	mMutexSemaphore->signal();
 	}
 	
 	
 	
 inline Semaphore::~Semaphore() {
-	delete mMutexSemaphore;
+	delete mWakeLock;
 	delete mBlockingSemaphore;
 	}
-	
-	
-	
-inline int Semaphore::wait( int inTimeoutInMilliseconds ) {
-    int returnValue;
-    // this implementation copied from _Operating System Concepts_, p. 172
-	
-	// lock the mutex
-	mMutexSemaphore->wait();
-	// decrement the semaphore
-	mSemaphoreValue--;
-	if( mSemaphoreValue < 0 ) {
-		// we should block
-		
-		// release the mutex
-		mMutexSemaphore->signal();
-		
-		// block
-		returnValue = mBlockingSemaphore->wait( inTimeoutInMilliseconds );
 
-        if( returnValue != 1 ) {
-            // timed out
 
-            // increment the semaphore, since we never got signaled
-            // lock the mutex
-            mMutexSemaphore->wait();
-            mSemaphoreValue++;
 
-            // we will unlock the mutex below
-            }
+inline char Semaphore::tryWait() {
+	int value = atomicLoad( &mSemaphoreValue );
+
+	if( value > 0 && 
+		atomicCompareExchange( &mSemaphoreValue, value, value - 1 ) ) {
+		return true;
 		}
-    else {
-        returnValue = 1;
-        }
-	
-	// release the mutex
-	// ( if we were signaled, then the signaller left the mutex locked )
-    // ( if we timed out, then we re-locked the mutex above )
-	mMutexSemaphore->signal();
+	return false;
+	}
+
+
 
-    return returnValue;
+inline int Semaphore::waitForWakeup( int inTimeoutInMilliseconds ) {
+	while( true ) {
+		mWakeLock->lock();
+
+		if( mNumWakeups > 0 ) {
+			mNumWakeups--;
+			char moreOwed = ( mNumWakeups > 0 );
+			
+			mWakeLock->unlock();
+
+			if( moreOwed ) {
+				mBlockingSemaphore->signal();
+				}
+			return 1;
+			}
+
+		mWakeLock->unlock();
+
+		if( mBlockingSemaphore->wait( inTimeoutInMilliseconds ) != 1 ) {
+			// timed out, but a wake-up may have arrived just now
+			mWakeLock->lock();
+
+			int result = 0;
+			
+			if( mNumWakeups > 0 ) {
+				mNumWakeups--;
+				result = 1;
+				}
+			
+			mWakeLock->unlock();
+
+			return result;
+			}
+		// else check for wake-up again (another waiter may have
+		// picked it up first)
+		}
 	}
 	
 	
 	
-inline char Semaphore::willBlock() {
-	char returnValue = false;
+inline int Semaphore::wait( int inTimeoutInMilliseconds ) {
+
+	for( int i=0; i<SEMAPHORE_SPIN_COUNT; i++ ) {
+		if( tryWait() ) {
+			return 1;
+			}
+		}
+
+	if( atomicFetchAdd( &mSemaphoreValue, -1 ) > 0 ) {
+		return 1;
+		}
+
+	// else we're counted as a waiter
 	
-	// lock the mutex
-	mMutexSemaphore->wait();
+	if( waitForWakeup( inTimeoutInMilliseconds ) ) {
+		return 1;
+		}
 
-	// check if we will block
-	if( mSemaphoreValue <= 0 ) {
-		returnValue = true;
+	// timed out, so stop being counted as a waiter... unless a signal
+	// has already counted us, in which case its wake-up is on the way
+	while( true ) {
+		int value = atomicLoad( &mSemaphoreValue );
+
+		if( value < 0 ) {
+			if( atomicCompareExchange( &mSemaphoreValue, 
+									   value, value + 1 ) ) {
+				return 0;
+				}
+			}
+		else {
+			waitForWakeup( -1 );
+			return 1;
+			}
 		}
+	}
 	
-	// release the mutex
-	mMutexSemaphore->signal();
 	
-	return returnValue;
+	
+inline char Semaphore::willBlock() {
+	return ( atomicLoad( &mSemaphoreValue ) <= 0 );
 	}
 	
 	
 	
 inline void Semaphore::signal() {
-	// lock the mutex
-	mMutexSemaphore->wait();
-	// increment the semaphore
-	mSemaphoreValue++;
-	if( mSemaphoreValue <= 0 ) {
+	if( atomicFetchAdd( &mSemaphoreValue, 1 ) < 0 ) {
 		// we need to wake up a waiting thread
+		mWakeLock->lock();
+		mNumWakeups++;
+		mWakeLock->unlock();
+
 		mBlockingSemaphore->signal();
-		// let the waiting thread unlock the mutex
-		}
-	else {
-		// no threads are waiting, so we need to unlock the mutex
-		mMutexSemaphore->signal();
 		}
 	}
 	
 	
 	
-
 #endif
@@ -0,0 +1,369 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+#include "minorGems/common.h"
+
+
+
+#include "minorGems/system/StartupTimeline.h"
+
+
+/**
+ * Startup phases in a fixed table, with read counters shared by all
+ * threads.
+ *
+ * A phase's counts are the difference between the counters when it began
+ * and ended, which is why they include nested phases and reads from
+ * other threads.
+ */
+
+
+
+#ifndef STARTUP_TIMELINE
+
+
+void StartupTimeline::beginPhase( const char *inName ) {
+    }
+
+void StartupTimeline::endPhase() {
+    }
+
+void StartupTimeline::noteFileOpened() {
+    }
+
+void StartupTimeline::noteBytesRead( long inNumBytes ) {
+    }
+
+void StartupTimeline::noteSettingRead() {
+    }
+
+char StartupTimeline::isRecording() {
+    return false;
+    }
+
+void StartupTimeline::finish( const char *inTraceFileName ) {
+    }
+
+
+#else
+
+
+
+#include "minorGems/system/atomicOps.h"
+#include "minorGems/system/Time.h"
+#include "minorGems/util/log/AppLog.h"
+
+#include <stdio.h>
+
+
+
+// phases past this many are counted but not recorded
+#define MAX_PHASES 256
+
+#define MAX_DEPTH 32
+
+
+
+typedef struct StartupPhase {
+        const char *name;
+
+        int depth;
+
+        // seconds since timelineEpoch
+        double startTime;
+        double endTime;
+
+        int startFiles;
+        int endFiles;
+
+        int64_t startBytes;
+        int64_t endBytes;
+
+        int startSettings;
+        int endSettings;
+    } StartupPhase;
+
+
+
+// these are only touched by the thread running phases
+static StartupPhase phases[ MAX_PHASES ];
+static int numPhases = 0;
+static int numDroppedPhases = 0;
+
+// indices into phases, -1 for dropped ones
+static int openPhases[ MAX_DEPTH ];
+static int numOpenPhases = 0;
+
+
+// these are counted from any thread
+static volatile int recording = 1;
+
+static volatile int filesOpened = 0;
+static volatile int64_t bytesRead = 0;
+static volatile int settingsRead = 0;
+
+
+// static construction is as close to program start as we can get
+static double timelineEpoch = Time::getMonotonicTime();
+
+
+static double getTimelineTime() {
+    return Time::getMonotonicTime() - timelineEpoch;
+    }
+
+
+
+void StartupTimeline::beginPhase( const char *inName ) {
+    if( ! atomicLoad( &recording ) ) {
+        return;
+        }
+
+    int index = -1;
+
+    if( numPhases < MAX_PHASES ) {
+        index = numPhases;
+        numPhases++;
+
+        StartupPhase *p = &( phases[ index ] );
+
+        p->name = inName;
+        p->depth = numOpenPhases;
+        p->startTime = getTimelineTime();
+        p->endTime = p->startTime;
+
+        p->startFiles = atomicLoad( &filesOpened );
+        p->startBytes = atomicLoad64( &bytesRead );
+        p->startSettings = atomicLoad( &settingsRead );
+
+        p->endFiles = p->startFiles;
+        p->endBytes = p->startBytes;
+        p->endSettings = p->startSettings;
+        }
+    else {
+        numDroppedPhases++;
+        }
+
+    if( numOpenPhases < MAX_DEPTH ) {
+        openPhases[ numOpenPhases ] = index;
+        }
+    // deeper phases are kept track of, but can't be ended
+    numOpenPhases++;
+    }
+
+
+
+void StartupTimeline::endPhase() {
+    if( ! atomicLoad( &recording ) || numOpenPhases == 0 ) {
+        return;
+        }
+
+    numOpenPhases--;
+
+    if( numOpenPhases >= MAX_DEPTH ) {
+        return;
+        }
+
+    int index = openPhases[ numOpenPhases ];
+
+    if( index == -1 ) {
+        return;
+        }
+
+    StartupPhase *p = &( phases[ index ] );
+
+    p->endTime = getTimelineTime();
+
+    p->endFiles = atomicLoad( &filesOpened );
+    p->endBytes = atomicLoad64( &bytesRead );
+    p->endSettings = atomicLoad( &settingsRead );
+    }
+
+
+
+void StartupTimeline::noteFileOpened() {
+    if( atomicLoad( &recording ) ) {
+        atomicFetchAdd( &filesOpened, 1 );
+        }
+    }
+
+
+
+void StartupTimeline::noteBytesRead( long inNumBytes ) {
+    if( inNumBytes > 0 && atomicLoad( &recording ) ) {
+        atomicFetchAdd64( &bytesRead, inNumBytes );
+        }
+    }
+
+
+
+void StartupTimeline::noteSettingRead() {
+    if( atomicLoad( &recording ) ) {
+        atomicFetchAdd( &settingsRead, 1 );
+        }
+    }
+
+
+
+char StartupTimeline::isRecording() {
+    return atomicLoad( &recording );
+    }
+
+
+
+static void writeJSONString( FILE *inFile, const char *inString ) {
+    fputc( '"', inFile );
+
+    for( const char *c = inString; *c != '\0'; c++ ) {
+        if( *c == '"' || *c == '\\' ) {
+            fputc( '\\', inFile );
+            fputc( *c, inFile );
+            }
+        else if( (unsigned char)( *c ) < 0x20 ) {
+            fprintf( inFile, "\\u%04x", (unsigned char)( *c ) );
+            }
+        else {
+            fputc( *c, inFile );
+            }
+        }
+
+    fputc( '"', inFile );
+    }
+
+
+
+static char writeTrace( const char *inFileName, double inEndTime ) {
+    FILE *file = fopen( inFileName, "w" );
+
+    if( file == NULL ) {
+        AppLog::errorF( "StartupTimeline:  failed to open %s for writing",
+                        inFileName );
+        return false;
+        }
+
+    fprintf( file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n" );
+
+    fprintf( file,
+             "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,"
+             "\"args\":{\"name\":\"startup\"}}" );
+
+    for( int i=0; i<numPhases; i++ ) {
+        StartupPhase *p = &( phases[i] );
+
+        fprintf( file, ",\n{\"name\":" );
+        writeJSONString( file, p->name );
+        fprintf( file,
+                 ",\"ph\":\"X\",\"pid\":1,\"tid\":1,"
+                 "\"ts\":%.3f,\"dur\":%.3f,"
+                 "\"args\":{\"files\":%d,\"bytes\":%lld,\"settings\":%d}}",
+                 1000000 * p->startTime,
+                 1000000 * ( p->endTime - p->startTime ),
+                 p->endFiles - p->startFiles,
+                 (long long)( p->endBytes - p->startBytes ),
+                 p->endSettings - p->startSettings );
+        }
+
+    fprintf( file,
+             ",\n{\"name\":\"finish\",\"ph\":\"i\",\"s\":\"g\","
+             "\"pid\":1,\"tid\":1,\"ts\":%.3f}",
+             1000000 * inEndTime );
+
+    fprintf( file, "\n]}\n" );
+
+    char success = ( ferror( file ) == 0 );
+
+    if( fclose( file ) != 0 ) {
+        success = false;
+        }
+
+    if( ! success ) {
+        AppLog::errorF( "StartupTimeline:  failed to write %s",
+                        inFileName );
+        }
+
+    return success;
+    }
+
+
+
+void StartupTimeline::finish( const char *inTraceFileName ) {
+    if( ! atomicLoad( &recording ) ) {
+        return;
+        }
+
+    while( numOpenPhases > 0 ) {
+        endPhase();
+        }
+
+    double endTime = getTimelineTime();
+
+    int totalFiles = atomicLoad( &filesOpened );
+    int64_t totalBytes = atomicLoad64( &bytesRead );
+    int totalSettings = atomicLoad( &settingsRead );
+
+    atomicStore( &recording, 0 );
+
+
+    AppLog::infoF( "Startup timeline:  %.1f ms, %d files opened, "
+                   "%.1f KiB read, %d settings read",
+                   1000 * endTime, totalFiles, totalBytes / 1024.0,
+                   totalSettings );
+
+    AppLog::infoF( "  %-32s %9s %9s %6s %10s %8s",
+                   "phase", "start ms", "ms", "files", "KiB",
+                   "settings" );
+
+    // what top-level phases don't cover
+    double outsideTime = endTime;
+    int outsideFiles = totalFiles;
+    int64_t outsideBytes = totalBytes;
+    int outsideSettings = totalSettings;
+
+    for( int i=0; i<numPhases; i++ ) {
+        StartupPhase *p = &( phases[i] );
+
+        double time = p->endTime - p->startTime;
+        int files = p->endFiles - p->startFiles;
+        int64_t bytes = p->endBytes - p->startBytes;
+        int settings = p->endSettings - p->startSettings;
+
+        if( p->depth == 0 ) {
+            outsideTime -= time;
+            outsideFiles -= files;
+            outsideBytes -= bytes;
+            outsideSettings -= settings;
+            }
+
+        // indent name by depth
+        char name[33];
+        int indent = 2 * p->depth;
+        if( indent > 16 ) {
+            indent = 16;
+            }
+        snprintf( name, sizeof( name ), "%*s%s", indent, "", p->name );
+
+        AppLog::infoF( "  %-32s %9.1f %9.1f %6d %10.1f %8d",
+                       name, 1000 * p->startTime, 1000 * time,
+                       files, bytes / 1024.0, settings );
+        }
+
+    AppLog::infoF( "  %-32s %9s %9.1f %6d %10.1f %8d",
+                   "(outside phases)", "", 1000 * outsideTime,
+                   outsideFiles, outsideBytes / 1024.0, outsideSettings );
+
+    if( numDroppedPhases > 0 ) {
+        AppLog::infoF( "  (%d more phases not recorded)",
+                       numDroppedPhases );
+        }
+
+    if( inTraceFileName != NULL ) {
+        writeTrace( inTraceFileName, endTime );
+        }
+    }
+
+
+
+#endif
@@ -0,0 +1,138 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+#include "minorGems/common.h"
+
+
+
+#ifndef STARTUP_TIMELINE_INCLUDED
+#define STARTUP_TIMELINE_INCLUDED
+
+
+
+/**
+ * Timeline of startup phases, with the files and settings read in each,
+ * reported once per launch.
+ *
+ * Usage:
+ *
+ *   StartupTimeline::beginPhase( "sound" );
+ *   ...
+ *   StartupTimeline::endPhase();
+ *
+ * or, for a phase that is a whole scope:
+ *
+ *   STARTUP_PHASE( "fonts" );
+ *
+ * Phases nest, and each records its start, duration, and the number of
+ * files opened, bytes read, and settings read while it was open:
+ *
+ *   files      opened with FileInputStream (and so File::readFileContents)
+ *              or mapped with MappedFileContents
+ *   bytes      read through FileInputStream (mapped files are paged in as
+ *              they are touched, so their bytes aren't counted)
+ *   settings   SettingsManager lookups that went to disk (cache misses),
+ *              including settings with no file
+ *
+ * These are counted on all threads (so reads by background loaders show
+ * up in whatever phase the main thread is in), and counts include nested
+ * phases.
+ *
+ * Phases must be begun and ended on one thread.  Times are from when the
+ * program started (static construction).
+ *
+ * finish ends recording, logs the report through AppLog, and writes the
+ * phases as a Chrome trace (JSON, viewable in chrome://tracing or
+ * Perfetto).
+ *
+ * Only built in when STARTUP_TIMELINE is defined for the whole build (in
+ * a game build, STARTUP_TIMELINE_FLAG in Makefile.common, on by
+ * default).  Otherwise, the macro expands to nothing, and the
+ * StartupTimeline functions do nothing.
+ *
+ * @author Jason Rohrer
+ */
+class StartupTimeline {
+
+    public:
+
+        // inName is a string constant
+        static void beginPhase( const char *inName );
+
+        // ends most recently begun phase
+        static void endPhase();
+
+
+        // count reads for the open phases
+        // called by FileInputStream, MappedFileContents, and
+        // SettingsManager
+        static void noteFileOpened();
+        static void noteBytesRead( long inNumBytes );
+        static void noteSettingRead();
+
+
+        // true until finish is called
+        static char isRecording();
+
+
+        /**
+         * Ends recording, ending any phases still open, then logs the
+         * report and writes the trace.
+         *
+         * Later calls do nothing.
+         *
+         * @param inTraceFileName file to write the trace to, or NULL
+         *   to only log the report.
+         */
+        static void finish( const char *inTraceFileName );
+
+    };
+
+
+
+#ifdef STARTUP_TIMELINE
+
+
+// used by STARTUP_PHASE, not for use elsewhere
+class StartupTimelineScope {
+
+    public:
+
+        // inName is a string constant
+        StartupTimelineScope( const char *inName ) {
+            StartupTimeline::beginPhase( inName );
+            }
+
+        ~StartupTimelineScope() {
+            StartupTimeline::endPhase();
+            }
+
+    };
+
+
+
+#define STARTUP_TIMELINE_CONCAT2( inA, inB ) inA##inB
+#define STARTUP_TIMELINE_CONCAT( inA, inB ) \
+    STARTUP_TIMELINE_CONCAT2( inA, inB )
+
+
+#define STARTUP_PHASE( inName ) \
+    StartupTimelineScope \
+        STARTUP_TIMELINE_CONCAT( startupTimelineScope, __LINE__ )( inName )
+
+
+#else
+
+
+#define STARTUP_PHASE( inName )
+
+
+#endif
+
+
+
+#endif
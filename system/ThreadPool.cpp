@@ -0,0 +1,483 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14   Jason Rohrer
+ * Created.
+ */
+
+
+
+#include "ThreadPool.h"
+
+#include "minorGems/system/atomicOps.h"
+
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <unistd.h>
+#endif
+
+
+
+// parallelFor aims for this many ranges per thread, so that threads
+// finishing early can take more
+#define THREAD_POOL_RANGES_PER_THREAD 4
+
+// how often a thread waiting on a handle checks for tasks to help with
+#define THREAD_POOL_WAIT_POLL_MS 1
+
+
+
+class ThreadPoolWorker : public Thread {
+
+    public:
+
+        ThreadPoolWorker( ThreadPool *inPool, int inQueue )
+                : mPool( inPool ), mQueue( inQueue ) {
+            start();
+            }
+
+        ~ThreadPoolWorker() {
+            join();
+            }
+
+
+        void run() {
+            mPool->workerLoop( mQueue );
+            }
+
+
+    protected:
+
+        ThreadPool *mPool;
+
+        int mQueue;
+
+    };
+
+
+
+MutexLock ThreadPool::sSharedLock;
+
+ThreadPool *ThreadPool::sSharedPool = NULL;
+
+
+
+
+ThreadPoolHandle::ThreadPoolHandle( ThreadPool *inPool,
+                                    ThreadPoolTask *inTask )
+        : mPool( inPool ), mTask( inTask ), mDone( false ),
+          mRefCount( 2 ) {
+    }
+
+
+
+ThreadPoolHandle::~ThreadPoolHandle() {
+    }
+
+
+
+char ThreadPoolHandle::isDone() {
+    mLock.lock();
+    char done = mDone;
+    mLock.unlock();
+
+    return done;
+    }
+
+
+
+void ThreadPoolHandle::wait() {
+    while( ! isDone() ) {
+
+        if( mPool->runOneTask() ) {
+            continue;
+            }
+
+        if( mDoneSemaphore.wait( THREAD_POOL_WAIT_POLL_MS ) ) {
+            // leave signaled for any later waits
+            mDoneSemaphore.signal();
+            }
+        }
+    }
+
+
+
+void ThreadPoolHandle::release() {
+    mLock.lock();
+    mRefCount--;
+    int refCount = mRefCount;
+    mLock.unlock();
+
+    if( refCount == 0 ) {
+        delete this;
+        }
+    }
+
+
+
+void ThreadPoolHandle::runTask() {
+    mTask->run();
+
+    delete mTask;
+    mTask = NULL;
+
+    mLock.lock();
+    mDone = true;
+    mLock.unlock();
+
+    mDoneSemaphore.signal();
+
+    release();
+    }
+
+
+
+
+ThreadPool::ThreadPool( int inNumThreads )
+        : mNumThreads( inNumThreads ),
+          mNextQueue( 0 ), mNumQueued( 0 ), mStopping( false ) {
+
+    if( mNumThreads < 1 ) {
+        mNumThreads = getNumCores();
+        }
+
+    mQueues = new TaskQueue[ mNumThreads ];
+
+    for( int i=0; i<mNumThreads; i++ ) {
+        mQueues[i].head = 0;
+        }
+
+    for( int i=0; i<mNumThreads; i++ ) {
+        mWorkers.push_back( new ThreadPoolWorker( this, i ) );
+        }
+    }
+
+
+
+ThreadPool::~ThreadPool() {
+    atomicStore( &mStopping, true );
+
+    // each worker passes this on before exiting
+    mWorkSemaphore.signal();
+
+    // destructors join
+    for( int i=0; i<mWorkers.size(); i++ ) {
+        delete mWorkers.getElementDirect( i );
+        }
+
+    delete [] mQueues;
+    }
+
+
+
+int ThreadPool::getNumThreads() {
+    return mNumThreads;
+    }
+
+
+
+ThreadPoolHandle *ThreadPool::submit( ThreadPoolTask *inTask ) {
+    ThreadPoolHandle *handle = new ThreadPoolHandle( this, inTask );
+
+    unsigned int next = (unsigned int)atomicFetchAdd( &mNextQueue, 1 );
+
+    TaskQueue *queue = &( mQueues[ next % mNumThreads ] );
+
+    queue->lock.lock();
+    queue->tasks.push_back( handle );
+    queue->lock.unlock();
+
+    atomicFetchAdd( &mNumQueued, 1 );
+
+    mWorkSemaphore.signal();
+
+    return handle;
+    }
+
+
+
+ThreadPoolHandle *ThreadPool::takeTask( int inQueue ) {
+
+    if( inQueue != -1 ) {
+        TaskQueue *queue = &( mQueues[ inQueue ] );
+
+        queue->lock.lock();
+
+        if( queue->tasks.size() > queue->head ) {
+            int last = queue->tasks.size() - 1;
+
+            ThreadPoolHandle *handle = queue->tasks.getElementDirect( last );
+            queue->tasks.deleteElement( last );
+
+            if( queue->tasks.size() == queue->head ) {
+                queue->tasks.deleteAll();
+                queue->head = 0;
+                }
+
+            queue->lock.unlock();
+
+            atomicFetchAdd( &mNumQueued, -1 );
+            return handle;
+            }
+
+        queue->lock.unlock();
+        }
+
+
+    // steal oldest task from another queue
+    for( int i=1; i<=mNumThreads; i++ ) {
+        int q = ( inQueue + i ) % mNumThreads;
+
+        if( q < 0 ) {
+            q += mNumThreads;
+            }
+
+        if( q == inQueue ) {
+            continue;
+            }
+
+        TaskQueue *queue = &( mQueues[ q ] );
+
+        queue->lock.lock();
+
+        if( queue->tasks.size() > queue->head ) {
+            ThreadPoolHandle *handle =
+                queue->tasks.getElementDirect( queue->head );
+            queue->head++;
+
+            // taken tasks are dropped from the front in bulk
+            if( queue->head == queue->tasks.size() ) {
+                queue->tasks.deleteAll();
+                queue->head = 0;
+                }
+            else if( queue->head > 32 &&
+                     queue->head * 2 > queue->tasks.size() ) {
+                queue->tasks.deleteStartElements( queue->head );
+                queue->head = 0;
+                }
+
+            queue->lock.unlock();
+
+            atomicFetchAdd( &mNumQueued, -1 );
+            return handle;
+            }
+
+        queue->lock.unlock();
+        }
+
+    return NULL;
+    }
+
+
+
+char ThreadPool::runOneTask() {
+    if( atomicLoad( &mNumQueued ) <= 0 ) {
+        return false;
+        }
+
+    ThreadPoolHandle *handle = takeTask( -1 );
+
+    if( handle == NULL ) {
+        return false;
+        }
+
+    handle->runTask();
+    return true;
+    }
+
+
+
+void ThreadPool::workerLoop( int inQueue ) {
+    while( true ) {
+        ThreadPoolHandle *handle = takeTask( inQueue );
+
+        if( handle != NULL ) {
+            if( atomicLoad( &mNumQueued ) > 0 ) {
+                // wake another thread for the rest
+                mWorkSemaphore.signal();
+                }
+
+            handle->runTask();
+            continue;
+            }
+
+        if( atomicLoad( &mStopping ) ) {
+            // pass stop on to next thread
+            mWorkSemaphore.signal();
+            return;
+            }
+
+        mWorkSemaphore.wait();
+        }
+    }
+
+
+
+typedef struct ParallelForJob {
+        ThreadPoolRangeFunction function;
+        void *context;
+        int numItems;
+        int rangeSize;
+        int numRanges;
+
+        volatile int nextRange;
+    } ParallelForJob;
+
+
+
+static void runRanges( ParallelForJob *inJob ) {
+    int r;
+
+    while( ( r = atomicFetchAdd( &( inJob->nextRange ), 1 ) )
+           < inJob->numRanges ) {
+
+        int start = r * inJob->rangeSize;
+        int end = start + inJob->rangeSize;
+
+        if( end > inJob->numItems ) {
+            end = inJob->numItems;
+            }
+
+        inJob->function( inJob->context, start, end );
+        }
+    }
+
+
+
+class ParallelForTask : public ThreadPoolTask {
+
+    public:
+
+        ParallelForTask( ParallelForJob *inJob )
+                : mJob( inJob ) {
+            }
+
+        void run() {
+            runRanges( mJob );
+            }
+
+    protected:
+
+        ParallelForJob *mJob;
+
+    };
+
+
+
+void ThreadPool::parallelFor( ThreadPoolRangeFunction inFunction,
+                              void *inContext,
+                              int inNumItems,
+                              int inMinItemsPerRange ) {
+
+    if( inNumItems <= 0 ) {
+        return;
+        }
+
+    if( inMinItemsPerRange < 1 ) {
+        inMinItemsPerRange = 1;
+        }
+
+    int targetRanges = mNumThreads * THREAD_POOL_RANGES_PER_THREAD;
+
+    int rangeSize = ( inNumItems + targetRanges - 1 ) / targetRanges;
+
+    if( rangeSize < inMinItemsPerRange ) {
+        rangeSize = inMinItemsPerRange;
+        }
+
+    int numRanges = ( inNumItems + rangeSize - 1 ) / rangeSize;
+
+    if( numRanges <= 1 ) {
+        inFunction( inContext, 0, inNumItems );
+        return;
+        }
+
+
+    ParallelForJob job;
+    job.function = inFunction;
+    job.context = inContext;
+    job.numItems = inNumItems;
+    job.rangeSize = rangeSize;
+    job.numRanges = numRanges;
+    job.nextRange = 0;
+
+    // calling thread is one of the helpers
+    int numHelpers = numRanges - 1;
+
+    if( numHelpers > mNumThreads ) {
+        numHelpers = mNumThreads;
+        }
+
+    ThreadPoolHandle **handles = new ThreadPoolHandle*[ numHelpers ];
+
+    for( int i=0; i<numHelpers; i++ ) {
+        handles[i] = submit( new ParallelForTask( &job ) );
+        }
+
+    runRanges( &job );
+
+    // helpers not started yet are run here by wait
+    for( int i=0; i<numHelpers; i++ ) {
+        handles[i]->wait();
+        handles[i]->release();
+        }
+
+    delete [] handles;
+    }
+
+
+
+ThreadPool *ThreadPool::getSharedPool() {
+    sSharedLock.lock();
+
+    if( sSharedPool == NULL ) {
+        sSharedPool = new ThreadPool();
+        }
+
+    ThreadPool *pool = sSharedPool;
+
+    sSharedLock.unlock();
+
+    return pool;
+    }
+
+
+
+void ThreadPool::shutdownSharedPool() {
+    sSharedLock.lock();
+
+    if( sSharedPool != NULL ) {
+        delete sSharedPool;
+        sSharedPool = NULL;
+        }
+
+    sSharedLock.unlock();
+    }
+
+
+
+int ThreadPool::getNumCores() {
+    static int numCores = 0;
+
+    if( numCores == 0 ) {
+        int count;
+
+        #ifdef _WIN32
+            SYSTEM_INFO info;
+            GetSystemInfo( &info );
+            count = info.dwNumberOfProcessors;
+        #else
+            count = (int)sysconf( _SC_NPROCESSORS_ONLN );
+        #endif
+
+        if( count < 1 ) {
+            count = 1;
+            }
+
+        numCores = count;
+        }
+
+    return numCores;
+    }
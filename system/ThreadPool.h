@@ -0,0 +1,269 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14   Jason Rohrer
+ * Created.
+ */
+
+#include "minorGems/common.h"
+
+
+
+#ifndef THREAD_POOL_INCLUDED
+#define THREAD_POOL_INCLUDED
+
+
+#include "minorGems/system/Thread.h"
+#include "minorGems/system/MutexLock.h"
+#include "minorGems/system/BinarySemaphore.h"
+#include "minorGems/util/SimpleVector.h"
+
+
+
+class ThreadPool;
+class ThreadPoolWorker;
+
+
+
+/**
+ * A unit of work for a ThreadPool.
+ *
+ * Subclass and override run, like Thread.
+ */
+class ThreadPoolTask {
+
+    public:
+
+        virtual ~ThreadPoolTask() {
+            }
+
+        virtual void run() = 0;
+
+    };
+
+
+
+/**
+ * Completion handle for a task submitted to a ThreadPool.
+ *
+ * Thread-safe.
+ *
+ * @author Jason Rohrer
+ */
+class ThreadPoolHandle {
+
+    public:
+
+        // true if task has finished running
+        char isDone();
+
+
+        /**
+         * Blocks until task has finished running.
+         *
+         * While waiting, the calling thread runs other queued tasks from
+         * the same pool, so tasks can wait on tasks they submit without
+         * tying up a pool thread (or deadlocking a small pool).
+         */
+        void wait();
+
+
+        /**
+         * Called by submitter when done with this handle, in place of
+         * delete.  Task may still be pending, in which case it still
+         * runs.
+         */
+        void release();
+
+
+    protected:
+
+        friend class ThreadPool;
+
+
+        ThreadPoolHandle( ThreadPool *inPool, ThreadPoolTask *inTask );
+
+        ~ThreadPoolHandle();
+
+
+        // runs and destroys task, marks done, and drops the pool's
+        // reference
+        void runTask();
+
+
+        ThreadPool *mPool;
+
+        ThreadPoolTask *mTask;
+
+        char mDone;
+
+        // one for submitter, one for pool while pending
+        int mRefCount;
+
+        MutexLock mLock;
+
+        BinarySemaphore mDoneSemaphore;
+
+    };
+
+
+
+// processes items [inStart, inEnd) of a parallelFor
+typedef void (*ThreadPoolRangeFunction)( void *inContext,
+                                         int inStart, int inEnd );
+
+
+
+/**
+ * Fixed set of threads that run submitted tasks.
+ *
+ * Each thread has its own queue of tasks.  Submitted tasks are spread
+ * across the queues, and a thread whose queue runs dry takes tasks from
+ * the front of the others' queues (work stealing), so one slow task
+ * doesn't leave others waiting behind it while threads sit idle.
+ *
+ * For sharing one pool of (number of cores) threads across subsystems,
+ * see getSharedPool.
+ *
+ * All functions are thread-safe.
+ *
+ * @author Jason Rohrer
+ */
+class ThreadPool {
+
+    public:
+
+        /**
+         * Constructs a pool and starts its threads.
+         *
+         * @param inNumThreads the number of threads, or -1 for one per
+         *   core.  Defaults to -1.
+         */
+        ThreadPool( int inNumThreads = -1 );
+
+
+        /**
+         * Finishes all queued tasks, then stops and joins pool threads.
+         *
+         * Handles not yet released must not be used afterward.
+         */
+        ~ThreadPool();
+
+
+
+        /**
+         * Queues a task.
+         *
+         * @param inTask the task to run.  Destroyed by the pool after
+         *   it runs.
+         *
+         * @return a handle, which must be released by caller with
+         *   ThreadPoolHandle::release.
+         */
+        ThreadPoolHandle *submit( ThreadPoolTask *inTask );
+
+
+
+        /**
+         * Runs inFunction over [0, inNumItems) in ranges spread across
+         * the pool, and returns once all ranges are done.
+         *
+         * The calling thread takes ranges too.  Ranges are handed out
+         * as threads become free, so uneven items balance out.
+         *
+         * @param inFunction the function to run on each range.
+         * @param inContext passed to inFunction.
+         * @param inNumItems the number of items.
+         * @param inMinItemsPerRange the smallest range worth handing to
+         *   another thread.  Defaults to 1.
+         */
+        void parallelFor( ThreadPoolRangeFunction inFunction,
+                          void *inContext,
+                          int inNumItems,
+                          int inMinItemsPerRange = 1 );
+
+
+
+        int getNumThreads();
+
+
+
+        /**
+         * Runs one queued task on the calling thread, if there is one.
+         *
+         * @return true if a task was run.
+         */
+        char runOneTask();
+
+
+
+        /**
+         * Gets a pool with one thread per core, created on first call,
+         * and shared by all callers.
+         *
+         * Must not be destroyed by caller.  Stopped by shutdownSharedPool.
+         */
+        static ThreadPool *getSharedPool();
+
+
+        // destroys the shared pool (if any), which is re-created if used
+        // again
+        static void shutdownSharedPool();
+
+
+
+        // number of cores on this machine, at least 1
+        static int getNumCores();
+
+
+
+    protected:
+
+        friend class ThreadPoolWorker;
+
+
+        typedef struct TaskQueue {
+                MutexLock lock;
+
+                // oldest first, with entries before head already taken
+                SimpleVector<ThreadPoolHandle *> tasks;
+                int head;
+            } TaskQueue;
+
+
+        int mNumThreads;
+
+        TaskQueue *mQueues;
+
+        SimpleVector<ThreadPoolWorker *> mWorkers;
+
+        // spreads submits across queues
+        volatile int mNextQueue;
+
+        // tasks queued but not yet taken
+        volatile int mNumQueued;
+
+        volatile int mStopping;
+
+        // wakes one idle thread, which passes it on if more tasks are
+        // queued (as with HostLookupPool)
+        BinarySemaphore mWorkSemaphore;
+
+
+        static MutexLock sSharedLock;
+        static ThreadPool *sSharedPool;
+
+
+        // takes from back of own queue (most recent, still warm in cache)
+        // or else steals from front of another
+        // returns NULL if all empty
+        ThreadPoolHandle *takeTask( int inQueue );
+
+        // runs worker inQueue until stopped
+        void workerLoop( int inQueue );
+
+    };
+
+
+
+#endif
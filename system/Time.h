@@ -9,6 +9,11 @@
  *
  * 2005-February-10		Jason Rohrer
  * Added function to get time in floating point format.
+ *
+ * 2026-October-15		Jason Rohrer
+ * Added high-resolution monotonic time, for measuring intervals.
+ * Added integer nanosecond monotonic time, and cached times that hot
+ * paths can read without a clock call.
  */
 
 #include "minorGems/common.h"
@@ -17,6 +22,7 @@
 #include <time.h>
 #include <stdio.h>
 #include <math.h>
+#include <stdint.h>
 
 
 
@@ -125,6 +131,58 @@ class Time {
          */
         static double getCurrentTime();
 
+
+
+        /**
+         * Gets the time in fractional seconds from an arbitrary starting
+         * point, with the highest resolution available (microseconds or
+         * better on most platforms).
+         *
+         * Unlike getCurrentTime, never jumps when the system clock is
+         * changed, so it is only good for measuring intervals.
+         *
+         * @return the current monotonic time in seconds.
+         */
+        static double getMonotonicTime();
+
+
+
+        /**
+         * Same as getMonotonicTime, but in integer nanoseconds, which
+         * don't lose precision as the count grows.
+         *
+         * Resolution is still whatever the platform supports.
+         *
+         * @return the current monotonic time in nanoseconds.
+         */
+        static int64_t getMonotonicNanoseconds();
+
+
+
+        /**
+         * Updates the cached times returned by getCachedMonotonicTime and
+         * getCachedTimeSec.
+         *
+         * Meant to be called once per frame or tick, by one thread (the
+         * game loop calls it at the start of each frame).
+         */
+        static void updateCachedTime();
+
+
+        /**
+         * Gets getMonotonicTime, as of the last updateCachedTime call.
+         *
+         * Costs a memory read, so it suits hot paths that need many
+         * timestamps per frame but not their exact times.
+         *
+         * Updates cached times first if they have never been updated.
+         */
+        static double getCachedMonotonicTime();
+
+
+        // same as above, for timeSec
+        static timeSec_t getCachedTimeSec();
+
         
 
 		/**
@@ -146,6 +204,10 @@ class Time {
         
         static char sEpochTimeSet;
         static time_t sEpochTime;
+
+        static volatile char sCachedTimeSet;
+        static volatile double sCachedMonotonicTime;
+        static volatile timeSec_t sCachedTimeSec;
         
         static void setEpochTime();
 
@@ -175,6 +237,33 @@ inline timeSec_t Time::timeSec() {
         
 
 
+inline void Time::updateCachedTime() {
+    sCachedMonotonicTime = getMonotonicTime();
+    sCachedTimeSec = timeSec();
+    sCachedTimeSet = true;
+    }
+
+
+
+inline double Time::getCachedMonotonicTime() {
+    if( ! sCachedTimeSet ) {
+        updateCachedTime();
+        }
+    return sCachedMonotonicTime;
+    }
+
+
+
+inline timeSec_t Time::getCachedTimeSec() {
+    if( ! sCachedTimeSet ) {
+        updateCachedTime();
+        }
+    return sCachedTimeSec;
+    }
+
+
+
+
 inline timeSec_t Time::normalize( time_t inTime ) {
     
     if( ! sEpochTimeSet ) {
@@ -0,0 +1,399 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+
+#include "TimerWheel.h"
+
+#include "minorGems/system/Time.h"
+
+
+#include <stdio.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+
+
+#define LEVEL_MASK ( TIMER_WHEEL_LEVEL_SIZE - 1 )
+
+
+
+// index of lowest set bit, inBits must be non-zero
+static int lowestBit( uint64_t inBits ) {
+#if defined( __GNUC__ )
+    return __builtin_ctzll( inBits );
+#elif defined( _MSC_VER ) && defined( _WIN64 )
+    unsigned long index;
+    _BitScanForward64( &index, inBits );
+    return (int)index;
+#else
+    int index = 0;
+    while( ( inBits & 1 ) == 0 ) {
+        inBits >>= 1;
+        index++;
+        }
+    return index;
+#endif
+    }
+
+
+
+TimerWheelTimer::TimerWheelTimer()
+        : mWheel( NULL ), mPrev( NULL ), mNext( NULL ),
+          mDueTick( 0 ), mLevel( 0 ), mSlot( 0 ) {
+    }
+
+
+
+TimerWheelTimer::~TimerWheelTimer() {
+    if( mWheel != NULL ) {
+        mWheel->cancel( this );
+        }
+    }
+
+
+
+char TimerWheelTimer::isScheduled() {
+    return ( mWheel != NULL );
+    }
+
+
+
+TimerWheel::TimerWheel( int inTickMS )
+        : mTickNanoseconds( (int64_t)inTickMS * 1000000 ),
+          mNumScheduled( 0 ) {
+
+    if( mTickNanoseconds <= 0 ) {
+        mTickNanoseconds = 1000000;
+        }
+
+    for( int l=0; l<TIMER_WHEEL_NUM_LEVELS; l++ ) {
+        for( int s=0; s<TIMER_WHEEL_LEVEL_SIZE; s++ ) {
+            mSlots[l][s] = NULL;
+            }
+        mOccupied[l] = 0;
+        }
+
+    mCurrentTick = getNowTick();
+    }
+
+
+
+TimerWheel::~TimerWheel() {
+    for( int l=0; l<TIMER_WHEEL_NUM_LEVELS; l++ ) {
+        for( int s=0; s<TIMER_WHEEL_LEVEL_SIZE; s++ ) {
+            TimerWheelTimer *t = mSlots[l][s];
+
+            while( t != NULL ) {
+                TimerWheelTimer *next = t->mNext;
+
+                t->mWheel = NULL;
+                t->mPrev = NULL;
+                t->mNext = NULL;
+
+                t = next;
+                }
+            }
+        }
+    }
+
+
+
+int64_t TimerWheel::getNowTick() {
+    return Time::getMonotonicNanoseconds() / mTickNanoseconds;
+    }
+
+
+
+void TimerWheel::place( TimerWheelTimer *inTimer ) {
+    int64_t ticksAway = inTimer->mDueTick - mCurrentTick;
+
+    int64_t placeTick = inTimer->mDueTick;
+
+    int level = 0;
+
+    while( level < TIMER_WHEEL_NUM_LEVELS - 1 &&
+           ticksAway >= ( (int64_t)1 <<
+                          ( TIMER_WHEEL_LEVEL_BITS * ( level + 1 ) ) ) ) {
+        level++;
+        }
+
+    int64_t wheelSpan =
+        (int64_t)1 << ( TIMER_WHEEL_LEVEL_BITS * TIMER_WHEEL_NUM_LEVELS );
+
+    if( ticksAway >= wheelSpan ) {
+        // park in furthest slot, and re-place when it comes around
+        placeTick = mCurrentTick + wheelSpan - 1;
+        }
+
+    int slot = (int)( ( placeTick >> ( TIMER_WHEEL_LEVEL_BITS * level ) )
+                      & LEVEL_MASK );
+
+    TimerWheelTimer *head = mSlots[level][slot];
+
+    inTimer->mPrev = NULL;
+    inTimer->mNext = head;
+
+    if( head != NULL ) {
+        head->mPrev = inTimer;
+        }
+
+    mSlots[level][slot] = inTimer;
+    mOccupied[level] |= ( (uint64_t)1 << slot );
+
+    inTimer->mLevel = level;
+    inTimer->mSlot = slot;
+    }
+
+
+
+void TimerWheel::unlink( TimerWheelTimer *inTimer ) {
+    if( inTimer->mPrev != NULL ) {
+        inTimer->mPrev->mNext = inTimer->mNext;
+        }
+    else {
+        mSlots[ inTimer->mLevel ][ inTimer->mSlot ] = inTimer->mNext;
+
+        if( inTimer->mNext == NULL ) {
+            mOccupied[ inTimer->mLevel ] &=
+                ~( (uint64_t)1 << inTimer->mSlot );
+            }
+        }
+
+    if( inTimer->mNext != NULL ) {
+        inTimer->mNext->mPrev = inTimer->mPrev;
+        }
+
+    inTimer->mPrev = NULL;
+    inTimer->mNext = NULL;
+    }
+
+
+
+void TimerWheel::schedule( TimerWheelTimer *inTimer, int inDelayMS ) {
+    if( inTimer->mWheel != NULL ) {
+        inTimer->mWheel->cancel( inTimer );
+        }
+
+    if( inDelayMS < 0 ) {
+        inDelayMS = 0;
+        }
+
+    int64_t dueNanoseconds =
+        Time::getMonotonicNanoseconds() + (int64_t)inDelayMS * 1000000;
+
+    // round up, so it's never early
+    int64_t dueTick =
+        ( dueNanoseconds + mTickNanoseconds - 1 ) / mTickNanoseconds;
+
+    if( dueTick < mCurrentTick ) {
+        dueTick = mCurrentTick;
+        }
+
+    inTimer->mDueTick = dueTick;
+    inTimer->mWheel = this;
+
+    place( inTimer );
+
+    mNumScheduled++;
+    }
+
+
+
+void TimerWheel::cancel( TimerWheelTimer *inTimer ) {
+    if( inTimer->mWheel != this ) {
+        return;
+        }
+
+    unlink( inTimer );
+
+    inTimer->mWheel = NULL;
+
+    mNumScheduled--;
+    }
+
+
+
+int TimerWheel::processTick() {
+    int64_t tick = mCurrentTick;
+
+    // move timers down from higher-level slots that start at this tick
+    for( int l=1; l<TIMER_WHEEL_NUM_LEVELS; l++ ) {
+        int shift = TIMER_WHEEL_LEVEL_BITS * l;
+
+        if( ( tick & ( ( (int64_t)1 << shift ) - 1 ) ) != 0 ) {
+            break;
+            }
+
+        int slot = (int)( ( tick >> shift ) & LEVEL_MASK );
+
+        TimerWheelTimer *t = mSlots[l][slot];
+
+        mSlots[l][slot] = NULL;
+        mOccupied[l] &= ~( (uint64_t)1 << slot );
+
+        while( t != NULL ) {
+            TimerWheelTimer *next = t->mNext;
+            place( t );
+            t = next;
+            }
+        }
+
+
+    int slot = (int)( tick & LEVEL_MASK );
+
+    // timers scheduled by fire calls are due next tick or later, and
+    // are never fired during this tick
+    mCurrentTick++;
+
+    int numFired = 0;
+
+    // fire calls can cancel other timers in this slot, so take one at a
+    // time
+    while( mSlots[0][slot] != NULL ) {
+        TimerWheelTimer *t = mSlots[0][slot];
+
+        if( t->mDueTick > tick ) {
+            // scheduled by a fire call into this slot's next turn
+            // (rest of list is older, and due now, so look past it)
+            TimerWheelTimer *due = t->mNext;
+
+            while( due != NULL && due->mDueTick > tick ) {
+                due = due->mNext;
+                }
+
+            if( due == NULL ) {
+                break;
+                }
+            t = due;
+            }
+
+        cancel( t );
+
+        t->fire();
+        numFired++;
+        }
+
+    return numFired;
+    }
+
+
+
+int TimerWheel::runExpired() {
+    int64_t nowTick = getNowTick();
+
+    int numFired = 0;
+
+    while( mCurrentTick <= nowTick ) {
+
+        if( mNumScheduled == 0 ) {
+            mCurrentTick = nowTick + 1;
+            break;
+            }
+
+        if( ( mCurrentTick & LEVEL_MASK ) != 0 ) {
+            // no higher-level slots start until next multiple of level
+            // size, so skip straight to next occupied level 0 slot
+            // before then
+            int slot = (int)( mCurrentTick & LEVEL_MASK );
+
+            uint64_t rest = mOccupied[0] >> slot;
+
+            int64_t nextTick;
+
+            if( rest != 0 ) {
+                nextTick = mCurrentTick + lowestBit( rest );
+                }
+            else {
+                nextTick = mCurrentTick + ( TIMER_WHEEL_LEVEL_SIZE - slot );
+                }
+
+            if( nextTick > nowTick + 1 ) {
+                nextTick = nowTick + 1;
+                }
+
+            if( nextTick != mCurrentTick ) {
+                mCurrentTick = nextTick;
+                continue;
+                }
+            }
+
+        numFired += processTick();
+        }
+
+    return numFired;
+    }
+
+
+
+int TimerWheel::getMSUntilNext( int inMaxMS ) {
+    if( mNumScheduled == 0 ) {
+        return inMaxMS;
+        }
+
+    int slot = (int)( mCurrentTick & LEVEL_MASK );
+
+    // past end of this level 0 turn, when higher levels move down
+    int64_t nextTick = mCurrentTick + ( TIMER_WHEEL_LEVEL_SIZE - slot );
+
+    if( slot == 0 ) {
+        char higherOccupied = false;
+
+        for( int l=1; l<TIMER_WHEEL_NUM_LEVELS; l++ ) {
+            if( mOccupied[l] != 0 ) {
+                higherOccupied = true;
+                }
+            }
+
+        if( higherOccupied ) {
+            nextTick = mCurrentTick;
+            }
+        }
+
+    if( mOccupied[0] != 0 ) {
+        // rotate so current slot is bit 0
+        uint64_t rotated = mOccupied[0] >> slot;
+
+        if( slot != 0 ) {
+            rotated |= mOccupied[0] << ( TIMER_WHEEL_LEVEL_SIZE - slot );
+            }
+
+        int64_t occupiedTick = mCurrentTick + lowestBit( rotated );
+
+        if( occupiedTick < nextTick ) {
+            nextTick = occupiedTick;
+            }
+        }
+
+
+    // tick is processed once clock reaches its start
+    int64_t waitNanoseconds =
+        nextTick * mTickNanoseconds - Time::getMonotonicNanoseconds();
+
+    if( waitNanoseconds <= 0 ) {
+        return 0;
+        }
+
+    int64_t waitMS = ( waitNanoseconds + 999999 ) / 1000000;
+
+    if( inMaxMS >= 0 && waitMS > inMaxMS ) {
+        return inMaxMS;
+        }
+
+    if( waitMS > 0x7FFFFFFF ) {
+        waitMS = 0x7FFFFFFF;
+        }
+
+    return (int)waitMS;
+    }
+
+
+
+int TimerWheel::getNumScheduled() {
+    return mNumScheduled;
+    }
@@ -0,0 +1,178 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+#include "minorGems/common.h"
+
+
+
+#ifndef TIMER_WHEEL_INCLUDED
+#define TIMER_WHEEL_INCLUDED
+
+
+#include <stdint.h>
+
+
+
+// slots per level, as a power of 2
+#define TIMER_WHEEL_LEVEL_BITS 6
+#define TIMER_WHEEL_LEVEL_SIZE ( 1 << TIMER_WHEEL_LEVEL_BITS )
+
+// with 6 bits per level, 4 levels cover 2^24 ticks (46 hours at 10 ms
+// ticks), and timers beyond that are parked in last slot and re-placed
+#define TIMER_WHEEL_NUM_LEVELS 4
+
+
+
+class TimerWheel;
+
+
+
+/**
+ * A timer for a TimerWheel.
+ *
+ * Subclass and override fire.  Owned by caller, who must cancel it (or
+ * let it fire) before destroying it.
+ */
+class TimerWheelTimer {
+
+    public:
+
+        TimerWheelTimer();
+
+        // cancels, if scheduled
+        virtual ~TimerWheelTimer();
+
+
+        // called by TimerWheel::runExpired once this timer is due
+        // can schedule or cancel any timer, including this one, or
+        // destroy this one
+        virtual void fire() = 0;
+
+
+        char isScheduled();
+
+
+    protected:
+
+        friend class TimerWheel;
+
+        TimerWheel *mWheel;
+
+        // in the list for a slot
+        TimerWheelTimer *mPrev;
+        TimerWheelTimer *mNext;
+
+        int64_t mDueTick;
+
+        int mLevel;
+        int mSlot;
+    };
+
+
+
+/**
+ * Hierarchical timer wheel, for managing many timeouts at once.
+ *
+ * Scheduling and canceling are O(1), no matter how many timers are
+ * scheduled.  Time is counted in ticks (of inTickMS each), and a timer
+ * fires in the first runExpired call at or after its due tick, so
+ * timers can fire up to one tick late, never early.
+ *
+ * Level 0 has a slot per tick.  Each higher level has slots that are
+ * TIMER_WHEEL_LEVEL_SIZE times longer, and a timer moves down a level
+ * each time the wheel reaches its slot, until it reaches level 0.
+ *
+ * Not thread-safe.  Meant to be owned by one thread, such as one that
+ * loops on SocketPoll::waitWithTimers.
+ *
+ * @author Jason Rohrer
+ */
+class TimerWheel {
+
+    public:
+
+        /**
+         * @param inTickMS the length of a tick, in milliseconds.
+         *   Defaults to 10.
+         */
+        TimerWheel( int inTickMS = 10 );
+
+        // unschedules any timers left, without firing them
+        ~TimerWheel();
+
+
+        /**
+         * Schedules a timer, replacing any time it was scheduled for.
+         *
+         * @param inTimer the timer.  Destroyed by caller.
+         * @param inDelayMS how long from now to fire, in milliseconds.
+         */
+        void schedule( TimerWheelTimer *inTimer, int inDelayMS );
+
+
+        // does nothing if inTimer isn't scheduled
+        void cancel( TimerWheelTimer *inTimer );
+
+
+        /**
+         * Fires all timers that are due.
+         *
+         * @return the number of timers fired.
+         */
+        int runExpired();
+
+
+        /**
+         * Gets how long until the next runExpired call might have a
+         * timer to fire.
+         *
+         * May be earlier than the next timer is due, when the wheel needs
+         * to move timers down a level, but is never later.
+         *
+         * @param inMaxMS the most to return, or -1 for no limit.
+         *
+         * @return milliseconds, or inMaxMS if no timers are scheduled.
+         */
+        int getMSUntilNext( int inMaxMS = -1 );
+
+
+        int getNumScheduled();
+
+
+    protected:
+
+        int64_t mTickNanoseconds;
+
+        // all ticks before this are processed
+        int64_t mCurrentTick;
+
+        int mNumScheduled;
+
+        // each slot is a list of timers
+        TimerWheelTimer *mSlots[ TIMER_WHEEL_NUM_LEVELS ]
+                               [ TIMER_WHEEL_LEVEL_SIZE ];
+
+        // bit set for each non-empty slot
+        uint64_t mOccupied[ TIMER_WHEEL_NUM_LEVELS ];
+
+
+        // tick the clock is at now
+        int64_t getNowTick();
+
+        // puts a timer in the slot for its due tick
+        void place( TimerWheelTimer *inTimer );
+
+        void unlink( TimerWheelTimer *inTimer );
+
+        // processes one tick, firing its timers
+        // returns number fired
+        int processTick();
+    };
+
+
+
+#endif
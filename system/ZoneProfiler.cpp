@@ -0,0 +1,521 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+#include "minorGems/common.h"
+
+
+
+#include "minorGems/system/ZoneProfiler.h"
+
+
+/**
+ * Per-thread zone record rings, frame marks, and their export.
+ *
+ * Each thread gets its own ring on its first zone.  Rings are never
+ * destroyed, so records from threads that have exited can still be
+ * exported.  Costs two clock reads per zone.
+ */
+
+
+
+#ifndef ZONE_PROFILING
+
+
+void ZoneProfiler::setThreadName( const char *inName ) {
+    }
+
+void ZoneProfiler::nextFrame() {
+    }
+
+char ZoneProfiler::writeChromeTrace( const char *inFileName ) {
+    return false;
+    }
+
+void ZoneProfiler::logProfile() {
+    }
+
+
+#else
+
+
+
+#include "minorGems/system/atomicOps.h"
+#include "minorGems/util/SimpleVector.h"
+#include "minorGems/util/log/AppLog.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <time.h>
+    #include <sched.h>
+#endif
+
+
+#ifdef _MSC_VER
+    #define ZONE_THREAD_LOCAL __declspec( thread )
+#else
+    #define ZONE_THREAD_LOCAL __thread
+#endif
+
+
+
+// power of 2
+// 32 bytes each, so 2 MiB per thread
+#define RECORDS_PER_THREAD 65536
+
+// power of 2
+#define FRAMES_KEPT 16384
+
+
+
+typedef struct ZoneRecord {
+        const char *name;
+
+        // seconds since profilerEpoch
+        double startTime;
+        double duration;
+
+        int frame;
+    } ZoneRecord;
+
+
+
+typedef struct ZoneThreadBuffer {
+        // number in traces, starting at 1
+        int threadNumber;
+
+        const char *threadName;
+
+        // only written by owning thread
+        // wraps from 2 * RECORDS_PER_THREAD back to RECORDS_PER_THREAD,
+        // so it never overflows, but stays above RECORDS_PER_THREAD once
+        // ring is full
+        volatile int numWritten;
+
+        ZoneRecord records[ RECORDS_PER_THREAD ];
+
+        ZoneThreadBuffer *next;
+    } ZoneThreadBuffer;
+
+
+
+static ZONE_THREAD_LOCAL ZoneThreadBuffer *threadBuffer = NULL;
+
+
+// these are protected by registryLock
+// plain data, since zones can run during static construction and
+// destruction
+
+// spins, as in MutexLockProfile
+static volatile int registryLock = 0;
+
+// newest first
+static ZoneThreadBuffer *allBuffers = NULL;
+
+static int numThreadBuffers = 0;
+
+
+// frame marks are only written by thread calling nextFrame
+// wraps like ZoneThreadBuffer::numWritten
+static volatile int numFramesMarked = 0;
+
+static double frameStartTimes[ FRAMES_KEPT ];
+
+// frame number of zones that start now
+static volatile int currentFrame = 0;
+
+
+
+static double getAbsoluteTime() {
+    #ifdef _WIN32
+        static double secondsPerCount = 0;
+
+        LARGE_INTEGER count;
+
+        if( secondsPerCount == 0 ) {
+            LARGE_INTEGER frequency;
+            QueryPerformanceFrequency( &frequency );
+
+            secondsPerCount = 1.0 / (double)( frequency.QuadPart );
+            }
+
+        QueryPerformanceCounter( &count );
+
+        return (double)( count.QuadPart ) * secondsPerCount;
+    #else
+        struct timespec now;
+        clock_gettime( CLOCK_MONOTONIC, &now );
+
+        return now.tv_sec + now.tv_nsec / 1000000000.0;
+    #endif
+    }
+
+
+// keeps exported time stamps small
+static double profilerEpoch = getAbsoluteTime();
+
+
+static double getProfilerTime() {
+    return getAbsoluteTime() - profilerEpoch;
+    }
+
+
+
+static void lockRegistry() {
+    while( atomicExchange( &registryLock, 1 ) != 0 ) {
+        #ifdef _WIN32
+            SwitchToThread();
+        #else
+            sched_yield();
+        #endif
+        }
+    }
+
+
+
+static void unlockRegistry() {
+    atomicStore( &registryLock, 0 );
+    }
+
+
+
+static ZoneThreadBuffer *getThreadBuffer() {
+    ZoneThreadBuffer *b = threadBuffer;
+
+    if( b != NULL ) {
+        return b;
+        }
+
+    // malloc, since debugMemory can't be used here
+    b = (ZoneThreadBuffer *)malloc( sizeof( ZoneThreadBuffer ) );
+
+    b->threadName = NULL;
+    b->numWritten = 0;
+
+    lockRegistry();
+
+    numThreadBuffers++;
+    b->threadNumber = numThreadBuffers;
+
+    b->next = allBuffers;
+    allBuffers = b;
+
+    unlockRegistry();
+
+    threadBuffer = b;
+
+    return b;
+    }
+
+
+
+// gets range of kept entries in a ring, oldest first
+// entries are at ( outFirst + i ) % inRingSize for i in [0, outCount)
+static void getKeptRange( int inNumWritten, int inRingSize,
+                          int *outFirst, int *outCount ) {
+    if( inNumWritten <= inRingSize ) {
+        *outFirst = 0;
+        *outCount = inNumWritten;
+        }
+    else {
+        *outFirst = inNumWritten & ( inRingSize - 1 );
+        *outCount = inRingSize;
+        }
+    }
+
+
+
+static int nextWriteCount( int inNumWritten, int inRingSize ) {
+    int n = inNumWritten + 1;
+
+    if( n == 2 * inRingSize ) {
+        n = inRingSize;
+        }
+    return n;
+    }
+
+
+
+ZoneProfilerScope::ZoneProfilerScope( const char *inName )
+        : mName( inName ),
+          mFrame( currentFrame ),
+          mStartTime( getProfilerTime() ) {
+    }
+
+
+
+ZoneProfilerScope::~ZoneProfilerScope() {
+    double endTime = getProfilerTime();
+
+    ZoneThreadBuffer *b = getThreadBuffer();
+
+    int n = b->numWritten;
+
+    ZoneRecord *r = &( b->records[ n & ( RECORDS_PER_THREAD - 1 ) ] );
+
+    r->name = mName;
+    r->startTime = mStartTime;
+    r->duration = endTime - mStartTime;
+    r->frame = mFrame;
+
+    // publish record to exporter
+    atomicStore( &( b->numWritten ),
+                 nextWriteCount( n, RECORDS_PER_THREAD ) );
+    }
+
+
+
+void ZoneProfiler::setThreadName( const char *inName ) {
+    getThreadBuffer()->threadName = inName;
+    }
+
+
+
+void ZoneProfiler::nextFrame() {
+    int n = numFramesMarked;
+
+    frameStartTimes[ n & ( FRAMES_KEPT - 1 ) ] = getProfilerTime();
+
+    atomicStore( &numFramesMarked, nextWriteCount( n, FRAMES_KEPT ) );
+
+    atomicFetchAdd( &currentFrame, 1 );
+    }
+
+
+
+// returns first frame number still in frame mark ring
+static int getFirstKeptFrame( int *outFirstIndex, int *outCount ) {
+    int numWritten = atomicLoad( &numFramesMarked );
+    int frame = atomicLoad( &currentFrame );
+
+    getKeptRange( numWritten, FRAMES_KEPT, outFirstIndex, outCount );
+
+    return frame - *outCount;
+    }
+
+
+
+static void writeJSONString( FILE *inFile, const char *inString ) {
+    fputc( '"', inFile );
+
+    for( const char *c = inString; *c != '\0'; c++ ) {
+        if( *c == '"' || *c == '\\' ) {
+            fputc( '\\', inFile );
+            fputc( *c, inFile );
+            }
+        else if( (unsigned char)( *c ) < 0x20 ) {
+            fprintf( inFile, "\\u%04x", (unsigned char)( *c ) );
+            }
+        else {
+            fputc( *c, inFile );
+            }
+        }
+
+    fputc( '"', inFile );
+    }
+
+
+
+// snapshot of buffer list, so that export doesn't hold registry lock
+// while writing
+static ZoneThreadBuffer *getAllBuffers() {
+    lockRegistry();
+    ZoneThreadBuffer *b = allBuffers;
+    unlockRegistry();
+
+    return b;
+    }
+
+
+
+char ZoneProfiler::writeChromeTrace( const char *inFileName ) {
+    FILE *file = fopen( inFileName, "w" );
+
+    if( file == NULL ) {
+        AppLog::errorF( "ZoneProfiler:  failed to open %s for writing\n",
+                        inFileName );
+        return false;
+        }
+
+    fprintf( file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n" );
+
+    // metadata for process, so every event after it can start with comma
+    fprintf( file,
+             "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,"
+             "\"args\":{\"name\":\"game\"}}" );
+
+    int numRecords = 0;
+
+    for( ZoneThreadBuffer *b = getAllBuffers(); b != NULL; b = b->next ) {
+
+        if( b->threadName != NULL ) {
+            fprintf( file,
+                     ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                     "\"tid\":%d,\"args\":{\"name\":", b->threadNumber );
+            writeJSONString( file, b->threadName );
+            fprintf( file, "}}" );
+            }
+
+        int first, count;
+        getKeptRange( atomicLoad( &( b->numWritten ) ), RECORDS_PER_THREAD,
+                      &first, &count );
+
+        for( int i=0; i<count; i++ ) {
+            ZoneRecord *r =
+                &( b->records[ ( first + i ) & ( RECORDS_PER_THREAD - 1 ) ] );
+
+            fprintf( file, ",\n{\"name\":" );
+            writeJSONString( file, r->name );
+            fprintf( file,
+                     ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+                     "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%d}}",
+                     b->threadNumber,
+                     1000000 * r->startTime, 1000000 * r->duration,
+                     r->frame );
+            }
+
+        numRecords += count;
+        }
+
+
+    int firstIndex, numFrames;
+    int frame = getFirstKeptFrame( &firstIndex, &numFrames );
+
+    for( int i=0; i<numFrames; i++ ) {
+        double t = frameStartTimes[ ( firstIndex + i ) & ( FRAMES_KEPT - 1 ) ];
+
+        fprintf( file,
+                 ",\n{\"name\":\"frame %d\",\"ph\":\"i\",\"s\":\"g\","
+                 "\"pid\":1,\"tid\":0,\"ts\":%.3f}",
+                 frame + i + 1, 1000000 * t );
+        }
+
+    fprintf( file, "\n]}\n" );
+
+    char success = ( ferror( file ) == 0 );
+
+    if( fclose( file ) != 0 ) {
+        success = false;
+        }
+
+    if( success ) {
+        AppLog::infoF( "ZoneProfiler:  wrote %d zones and %d frames to %s\n",
+                       numRecords, numFrames, inFileName );
+        }
+    else {
+        AppLog::errorF( "ZoneProfiler:  failed to write %s\n", inFileName );
+        }
+
+    return success;
+    }
+
+
+
+typedef struct ZoneNameStats {
+        const char *name;
+        int count;
+        double totalTime;
+        double maxTime;
+
+        int firstFrame;
+        int lastFrame;
+    } ZoneNameStats;
+
+
+
+void ZoneProfiler::logProfile() {
+
+    SimpleVector<ZoneNameStats> table;
+
+    for( ZoneThreadBuffer *b = getAllBuffers(); b != NULL; b = b->next ) {
+
+        int first, count;
+        getKeptRange( atomicLoad( &( b->numWritten ) ), RECORDS_PER_THREAD,
+                      &first, &count );
+
+        for( int i=0; i<count; i++ ) {
+            ZoneRecord *r =
+                &( b->records[ ( first + i ) & ( RECORDS_PER_THREAD - 1 ) ] );
+
+            ZoneNameStats *e = NULL;
+
+            for( int j=0; j<table.size(); j++ ) {
+                ZoneNameStats *other = table.getElement( j );
+
+                if( other->name == r->name ||
+                    strcmp( other->name, r->name ) == 0 ) {
+                    e = other;
+                    break;
+                    }
+                }
+
+            if( e == NULL ) {
+                ZoneNameStats newEntry = { r->name, 0, 0, 0,
+                                           r->frame, r->frame };
+                table.push_back( newEntry );
+                e = table.getElement( table.size() - 1 );
+                }
+
+            e->count++;
+            e->totalTime += r->duration;
+
+            if( r->duration > e->maxTime ) {
+                e->maxTime = r->duration;
+                }
+            if( r->frame < e->firstFrame ) {
+                e->firstFrame = r->frame;
+                }
+            if( r->frame > e->lastFrame ) {
+                e->lastFrame = r->frame;
+                }
+            }
+        }
+
+
+    // longest total time first
+    ZoneNameStats *entries = table.getElementArray();
+    int numEntries = table.size();
+
+    for( int i=1; i<numEntries; i++ ) {
+        ZoneNameStats e = entries[i];
+
+        int j = i - 1;
+        while( j >= 0 && entries[j].totalTime < e.totalTime ) {
+            entries[ j + 1 ] = entries[j];
+            j--;
+            }
+        entries[ j + 1 ] = e;
+        }
+
+
+    AppLog::infoF( "Zone profile (kept records only, times include "
+                   "nested zones), %d zones:\n", numEntries );
+
+    for( int i=0; i<numEntries; i++ ) {
+        ZoneNameStats *e = &( entries[i] );
+
+        int numFrames = e->lastFrame - e->firstFrame + 1;
+
+        AppLog::infoF(
+            "  %-24s calls %9d (%7.2f/frame), total %10.3f ms "
+            "(%7.3f ms/frame), mean %8.3f ms, max %8.3f ms\n",
+            e->name, e->count, e->count / (double)numFrames,
+            1000 * e->totalTime, 1000 * e->totalTime / numFrames,
+            1000 * e->totalTime / e->count, 1000 * e->maxTime );
+        }
+
+    delete [] entries;
+    }
+
+
+
+#endif
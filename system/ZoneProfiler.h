@@ -0,0 +1,128 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+#include "minorGems/common.h"
+
+
+
+#ifndef ZONE_PROFILER_INCLUDED
+#define ZONE_PROFILER_INCLUDED
+
+
+
+/**
+ * Scoped timing of hot code regions, frame by frame.
+ *
+ * Usage:
+ *
+ *   void drawFrame( char inUpdate ) {
+ *       PROFILE_ZONE( "drawFrame" );
+ *       ...
+ *       }
+ *
+ * Each zone records its start and duration when it goes out of scope.
+ * Zones nest naturally.  Records go into a fixed-size ring owned by the
+ * recording thread, so recording takes no lock, and only the newest
+ * records are kept.
+ *
+ * PROFILE_FRAME() marks the start of a new frame, and each record is
+ * tagged with the frame it started in.
+ *
+ * Only built in when ZONE_PROFILING is defined for the whole build (in a
+ * game build, set ZONE_PROFILE_FLAG in Makefile.common).  Otherwise, the
+ * macros expand to nothing, and the ZoneProfiler functions do nothing.
+ *
+ * @author Jason Rohrer
+ */
+class ZoneProfiler {
+
+    public:
+
+        // names calling thread in exported traces
+        // inName is a string constant
+        static void setThreadName( const char *inName );
+
+
+        // starts the next frame
+        static void nextFrame();
+
+
+        /**
+         * Writes all kept records as a Chrome trace (JSON, viewable in
+         * chrome://tracing or Perfetto).
+         *
+         * Best called when recording threads are idle (at exit, for
+         * example).  Records written while exporting may be missing or
+         * inconsistent.
+         *
+         * @return true on success.
+         */
+        static char writeChromeTrace( const char *inFileName );
+
+
+        // logs per-zone call counts and times, plus per-frame averages,
+        // through AppLog
+        static void logProfile();
+
+    };
+
+
+
+#ifdef ZONE_PROFILING
+
+
+// used by PROFILE_ZONE, not for use elsewhere
+class ZoneProfilerScope {
+
+    public:
+
+        // inName is a string constant
+        ZoneProfilerScope( const char *inName );
+
+        ~ZoneProfilerScope();
+
+
+    protected:
+
+        const char *mName;
+
+        int mFrame;
+
+        double mStartTime;
+
+    };
+
+
+
+#define ZONE_PROFILER_CONCAT2( inA, inB ) inA##inB
+#define ZONE_PROFILER_CONCAT( inA, inB ) ZONE_PROFILER_CONCAT2( inA, inB )
+
+
+#define PROFILE_ZONE( inName ) \
+    ZoneProfilerScope ZONE_PROFILER_CONCAT( zoneProfilerScope, __LINE__ )( \
+        inName )
+
+#define PROFILE_FRAME() ZoneProfiler::nextFrame()
+
+#define PROFILE_THREAD_NAME( inName ) ZoneProfiler::setThreadName( inName )
+
+
+#else
+
+
+#define PROFILE_ZONE( inName )
+
+#define PROFILE_FRAME()
+
+#define PROFILE_THREAD_NAME( inName )
+
+
+#endif
+
+
+
+#endif
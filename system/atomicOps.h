@@ -0,0 +1,221 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14		Jason Rohrer
+ * Created.
+ * Added pointer exchange and compare-exchange.
+ *
+ * 2026-October-15		Jason Rohrer
+ * Added cache line size, for padding.
+ * Added 64-bit load, store, add and compare-exchange.
+ */
+
+
+
+#ifndef ATOMIC_OPS_INCLUDED
+#define ATOMIC_OPS_INCLUDED
+
+
+
+/**
+ * Minimal set of atomic operations on ints (32- and 64-bit) and pointers,
+ * for lock-free structures shared between exactly the threads that need
+ * them.
+ *
+ * Uses GCC/clang __atomic builtins, or Interlocked functions on MSVC.
+ *
+ * Loads are acquire, stores are release, read-modify-write operations
+ * are fully ordered.
+ *
+ * @author Jason Rohrer
+ */
+
+
+
+// for padding apart values written by different threads, so that they
+// don't share a cache line (false sharing)
+// a full line of padding between two values separates them no matter
+// how the enclosing object is aligned
+#define ATOMIC_CACHE_LINE_SIZE 64
+
+
+
+#include <stdint.h>
+
+
+
+#if defined( _MSC_VER )
+
+#include <windows.h>
+
+
+inline int atomicLoad( volatile int *inValue ) {
+    int v = *inValue;
+    MemoryBarrier();
+    return v;
+    }
+
+
+inline void atomicStore( volatile int *inValue, int inNewValue ) {
+    MemoryBarrier();
+    *inValue = inNewValue;
+    }
+
+
+// returns the value from before the add
+inline int atomicFetchAdd( volatile int *inValue, int inAmount ) {
+    return InterlockedExchangeAdd( (volatile LONG *)inValue, inAmount );
+    }
+
+
+// returns the value from before the exchange
+inline int atomicExchange( volatile int *inValue, int inNewValue ) {
+    return InterlockedExchange( (volatile LONG *)inValue, inNewValue );
+    }
+
+
+// returns true if *inValue was inExpected and has been replaced
+inline char atomicCompareExchange( volatile int *inValue, int inExpected,
+                                   int inNewValue ) {
+    return InterlockedCompareExchange( (volatile LONG *)inValue,
+                                       inNewValue, inExpected )
+        == inExpected;
+    }
+
+
+// returns the pointer from before the exchange
+inline void *atomicExchangePointer( void * volatile *inPointer,
+                                    void *inNewValue ) {
+    return InterlockedExchangePointer( (PVOID volatile *)inPointer,
+                                       inNewValue );
+    }
+
+
+// returns true if *inPointer was inExpected and has been replaced
+inline char atomicCompareExchangePointer( void * volatile *inPointer,
+                                          void *inExpected,
+                                          void *inNewValue ) {
+    return InterlockedCompareExchangePointer( (PVOID volatile *)inPointer,
+                                              inNewValue, inExpected )
+        == inExpected;
+    }
+
+
+// 64-bit versions, atomic even on 32-bit platforms
+
+inline int64_t atomicLoad64( volatile int64_t *inValue ) {
+    // plain 64-bit reads can tear on 32-bit platforms
+    return InterlockedCompareExchange64( (volatile LONG64 *)inValue, 0, 0 );
+    }
+
+
+inline void atomicStore64( volatile int64_t *inValue, int64_t inNewValue ) {
+    InterlockedExchange64( (volatile LONG64 *)inValue, inNewValue );
+    }
+
+
+// returns the value from before the add
+inline int64_t atomicFetchAdd64( volatile int64_t *inValue,
+                                 int64_t inAmount ) {
+    return InterlockedExchangeAdd64( (volatile LONG64 *)inValue, inAmount );
+    }
+
+
+// returns true if *inValue was inExpected and has been replaced
+inline char atomicCompareExchange64( volatile int64_t *inValue,
+                                     int64_t inExpected,
+                                     int64_t inNewValue ) {
+    return InterlockedCompareExchange64( (volatile LONG64 *)inValue,
+                                         inNewValue, inExpected )
+        == inExpected;
+    }
+
+
+#else
+
+
+inline int atomicLoad( volatile int *inValue ) {
+    return __atomic_load_n( inValue, __ATOMIC_ACQUIRE );
+    }
+
+
+inline void atomicStore( volatile int *inValue, int inNewValue ) {
+    __atomic_store_n( inValue, inNewValue, __ATOMIC_RELEASE );
+    }
+
+
+// returns the value from before the add
+inline int atomicFetchAdd( volatile int *inValue, int inAmount ) {
+    return __atomic_fetch_add( inValue, inAmount, __ATOMIC_SEQ_CST );
+    }
+
+
+// returns the value from before the exchange
+inline int atomicExchange( volatile int *inValue, int inNewValue ) {
+    return __atomic_exchange_n( inValue, inNewValue, __ATOMIC_SEQ_CST );
+    }
+
+
+// returns true if *inValue was inExpected and has been replaced
+inline char atomicCompareExchange( volatile int *inValue, int inExpected,
+                                   int inNewValue ) {
+    return __atomic_compare_exchange_n( inValue, &inExpected, inNewValue,
+                                        false,
+                                        __ATOMIC_SEQ_CST,
+                                        __ATOMIC_SEQ_CST );
+    }
+
+
+// returns the pointer from before the exchange
+inline void *atomicExchangePointer( void * volatile *inPointer,
+                                    void *inNewValue ) {
+    return __atomic_exchange_n( inPointer, inNewValue, __ATOMIC_SEQ_CST );
+    }
+
+
+// returns true if *inPointer was inExpected and has been replaced
+inline char atomicCompareExchangePointer( void * volatile *inPointer,
+                                          void *inExpected,
+                                          void *inNewValue ) {
+    return __atomic_compare_exchange_n( inPointer, &inExpected, inNewValue,
+                                        false,
+                                        __ATOMIC_SEQ_CST,
+                                        __ATOMIC_SEQ_CST );
+    }
+
+
+// 64-bit versions, atomic even on 32-bit platforms
+
+inline int64_t atomicLoad64( volatile int64_t *inValue ) {
+    return __atomic_load_n( inValue, __ATOMIC_ACQUIRE );
+    }
+
+
+inline void atomicStore64( volatile int64_t *inValue, int64_t inNewValue ) {
+    __atomic_store_n( inValue, inNewValue, __ATOMIC_RELEASE );
+    }
+
+
+// returns the value from before the add
+inline int64_t atomicFetchAdd64( volatile int64_t *inValue,
+                                 int64_t inAmount ) {
+    return __atomic_fetch_add( inValue, inAmount, __ATOMIC_SEQ_CST );
+    }
+
+
+// returns true if *inValue was inExpected and has been replaced
+inline char atomicCompareExchange64( volatile int64_t *inValue,
+                                     int64_t inExpected,
+                                     int64_t inNewValue ) {
+    return __atomic_compare_exchange_n( inValue, &inExpected, inNewValue,
+                                        false,
+                                        __ATOMIC_SEQ_CST,
+                                        __ATOMIC_SEQ_CST );
+    }
+
+
+#endif
+
+
+
+#endif
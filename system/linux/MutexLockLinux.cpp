@@ -9,6 +9,11 @@
  * since MemoryTrack uses a mutex lock.
  * Changed to use malloc instead of new internally to work with debugMemory.
  * Made use of mNativeObjectPointer a bit cleaner.
+ *
+ * 2026-October-14   Jason Rohrer
+ * On Linux, replaced pthread mutex with a spin-then-futex lock that only
+ * enters the kernel when contended.
+ * Added lock names and profiling hooks.
  */
 
 #include "minorGems/common.h"
@@ -16,20 +21,162 @@
 
 
 #include <minorGems/system/MutexLock.h>
-#include <pthread.h>
 #include <stdlib.h>
 
+#ifdef MUTEX_LOCK_PROFILING
+	#include <minorGems/system/MutexLockProfile.h>
+#endif
+
 /**
  * Linux-specific implementation of the MutexLock class member functions.
  *
- * May also be compatible with other POSIX-like systems.
+ * May also be compatible with other POSIX-like systems, where it falls
+ * back to a pthread mutex.
  *
  * To compile:
  * g++ -lpthread
  */
 
 
-MutexLock::MutexLock() {
+
+#ifdef __linux__
+
+
+#include <minorGems/system/atomicOps.h>
+
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+
+/*
+ * Lock word is 0 when unlocked, 1 when locked, and 2 when locked with
+ * threads (maybe) sleeping on it, as in Drepper's "Futexes Are Tricky".
+ *
+ * An uncontended lock/unlock is one atomic operation each, with no
+ * system call.
+ */
+
+
+// tries before sleeping, since most critical sections here are short
+#define MUTEX_LOCK_SPIN_COUNT 100
+
+
+
+static void futexWait( volatile int *inWord, int inValue ) {
+    syscall( SYS_futex, (int *)inWord, FUTEX_WAIT_PRIVATE, inValue,
+             NULL, NULL, 0 );
+    }
+
+
+static void futexWakeOne( volatile int *inWord ) {
+    syscall( SYS_futex, (int *)inWord, FUTEX_WAKE_PRIVATE, 1,
+             NULL, NULL, 0 );
+    }
+
+
+static inline void spinPause() {
+    #if defined( __i386__ ) || defined( __x86_64__ )
+        __builtin_ia32_pause();
+    #endif
+    }
+
+
+
+// all but the first try of lock
+static void lockContended( volatile int *inWord ) {
+	// holder will likely be done soon
+	for( int i=0; i<MUTEX_LOCK_SPIN_COUNT; i++ ) {
+		spinPause();
+
+		if( atomicLoad( inWord ) == 0 && 
+			atomicCompareExchange( inWord, 0, 1 ) ) {
+			return;
+			}
+		}
+
+	// mark contended and sleep until we get it
+	// (we don't know whether others are still sleeping when we do get
+	// it, so we take it as contended, and unlock will wake one)
+	while( atomicExchange( inWord, 2 ) != 0 ) {
+		futexWait( inWord, 2 );
+		}
+	}
+
+
+
+MutexLock::MutexLock( const char *inName ) {
+	// allocate lock word on the heap
+	mNativeObjectPointer = malloc( sizeof( int ) );
+
+	*( (volatile int *)mNativeObjectPointer ) = 0;
+
+	#ifdef MUTEX_LOCK_PROFILING
+		mProfile = mutexLockProfileCreate( inName );
+	#else
+		mProfile = NULL;
+	#endif
+	}
+
+
+
+MutexLock::~MutexLock() {
+	#ifdef MUTEX_LOCK_PROFILING
+		mutexLockProfileDestroy( mProfile );
+	#endif
+
+	free( mNativeObjectPointer );
+	}
+
+
+
+void MutexLock::lock() {
+	volatile int *word = (volatile int *)mNativeObjectPointer;
+
+	if( atomicCompareExchange( word, 0, 1 ) ) {
+		// fast path
+		#ifdef MUTEX_LOCK_PROFILING
+			mutexLockProfileLocked( mProfile, -1 );
+		#endif
+		return;
+		}
+
+	#ifdef MUTEX_LOCK_PROFILING
+		double waitStartTime = mutexLockProfileTime();
+	#endif
+
+	lockContended( word );
+
+	#ifdef MUTEX_LOCK_PROFILING
+		mutexLockProfileLocked( mProfile, waitStartTime );
+	#endif
+	}
+
+
+
+void MutexLock::unlock() {
+	volatile int *word = (volatile int *)mNativeObjectPointer;
+
+	#ifdef MUTEX_LOCK_PROFILING
+		mutexLockProfileUnlocking( mProfile );
+	#endif
+
+	if( atomicExchange( word, 0 ) == 2 ) {
+		// someone may be sleeping
+		futexWakeOne( word );
+		}
+	}
+
+
+
+#else
+
+
+#include <pthread.h>
+
+
+
+MutexLock::MutexLock( const char *inName ) {
 	// allocate a mutex structure on the heap
 	mNativeObjectPointer = malloc( sizeof( pthread_mutex_t ) );
 	
@@ -39,11 +186,21 @@ MutexLock::MutexLock() {
 	
 	// init the mutex
 	pthread_mutex_init( mutexPointer, NULL );
+
+	#ifdef MUTEX_LOCK_PROFILING
+		mProfile = mutexLockProfileCreate( inName );
+	#else
+		mProfile = NULL;
+	#endif
 	}
 
 
 
 MutexLock::~MutexLock() {
+	#ifdef MUTEX_LOCK_PROFILING
+		mutexLockProfileDestroy( mProfile );
+	#endif
+
 	// get a pointer to the mutex
 	pthread_mutex_t *mutexPointer = 
 		(pthread_mutex_t *)mNativeObjectPointer;
@@ -62,7 +219,19 @@ void MutexLock::lock() {
 	pthread_mutex_t *mutexPointer = 
 		(pthread_mutex_t *)mNativeObjectPointer;
 	
+	#ifdef MUTEX_LOCK_PROFILING
+		if( pthread_mutex_trylock( mutexPointer ) == 0 ) {
+			mutexLockProfileLocked( mProfile, -1 );
+			return;
+			}
+		double waitStartTime = mutexLockProfileTime();
+	#endif
+
 	pthread_mutex_lock( mutexPointer );
+
+	#ifdef MUTEX_LOCK_PROFILING
+		mutexLockProfileLocked( mProfile, waitStartTime );
+	#endif
 	}
 
 
@@ -72,5 +241,13 @@ void MutexLock::unlock() {
 	pthread_mutex_t *mutexPointer = 
 		(pthread_mutex_t *)mNativeObjectPointer;
 	
+	#ifdef MUTEX_LOCK_PROFILING
+		mutexLockProfileUnlocking( mProfile );
+	#endif
+
 	pthread_mutex_unlock( mutexPointer );
 	}
+
+
+
+#endif
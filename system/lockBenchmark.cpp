@@ -0,0 +1,293 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14   Jason Rohrer
+ * Created.
+ */
+
+/**
+ * Measures uncontended MutexLock lock/unlock, Semaphore signal/wait, and
+ * ReadWriteLock cost, then checks all three under contention (a shared
+ * counter guarded by the lock, a pair of threads ping-ponging through
+ * semaphores, and readers checking a pair of values that a writer
+ * updates together).
+ *
+ * Compile from above the minorGems directory with:
+ *   g++ -O2 -I. minorGems/system/lockBenchmark.cpp
+ *     minorGems/system/linux/[A-Z]*.cpp
+ *     minorGems/system/unix/TimeUnix.cpp -lpthread -o lockBenchmark
+ */
+
+#include "Thread.h"
+#include "MutexLock.h"
+#include "Semaphore.h"
+#include "BinarySemaphore.h"
+#include "ReadWriteLock.h"
+#include "Time.h"
+
+#include <stdio.h>
+
+
+
+#define NUM_UNCONTENDED 10000000
+#define NUM_CONTENDED 1000000
+#define NUM_PING_PONGS 100000
+#define NUM_COUNTER_THREADS 4
+#define NUM_READER_THREADS 3
+
+
+
+static MutexLock counterLock;
+static int counter = 0;
+
+
+class CounterThread : public Thread {
+    public:
+        void run() {
+            for( int i=0; i<NUM_CONTENDED; i++ ) {
+                counterLock.lock();
+                counter++;
+                counterLock.unlock();
+                }
+            }
+    };
+
+
+
+static Semaphore pingSemaphore;
+static Semaphore pongSemaphore;
+
+
+class PongThread : public Thread {
+    public:
+        void run() {
+            for( int i=0; i<NUM_PING_PONGS; i++ ) {
+                pingSemaphore.wait();
+                pongSemaphore.signal();
+                }
+            }
+    };
+
+
+
+static ReadWriteLock pairLock;
+static int pairA = 0;
+static int pairB = 0;
+
+
+class PairReaderThread : public Thread {
+    public:
+        PairReaderThread()
+                : mNumMismatched( 0 ) {
+            }
+
+        void run() {
+            for( int i=0; i<NUM_CONTENDED; i++ ) {
+                pairLock.lockRead();
+                if( pairA != pairB ) {
+                    mNumMismatched++;
+                    }
+                pairLock.unlockRead();
+                }
+            }
+
+        int mNumMismatched;
+    };
+
+
+class PairWriterThread : public Thread {
+    public:
+        void run() {
+            for( int i=0; i<NUM_CONTENDED / 10; i++ ) {
+                pairLock.lockWrite();
+                pairA++;
+                pairB++;
+                pairLock.unlockWrite();
+                }
+            }
+    };
+
+
+
+// sits waiting while uncontended costs are measured, since libc may
+// skip atomic operations entirely while a process has only one thread
+class IdleThread : public Thread {
+    public:
+        void run() {
+            mStopSemaphore.wait();
+            }
+
+        BinarySemaphore mStopSemaphore;
+    };
+
+
+
+int main() {
+
+    IdleThread idle;
+    idle.start();
+
+    MutexLock lock;
+
+    double startTime = Time::getCurrentTime();
+
+    for( int i=0; i<NUM_UNCONTENDED; i++ ) {
+        lock.lock();
+        lock.unlock();
+        }
+
+    double time = Time::getCurrentTime() - startTime;
+
+    printf( "Uncontended lock/unlock:    %6.2f ns\n",
+            1000000000 * time / NUM_UNCONTENDED );
+
+
+    Semaphore semaphore;
+
+    startTime = Time::getCurrentTime();
+
+    for( int i=0; i<NUM_UNCONTENDED; i++ ) {
+        semaphore.signal();
+        semaphore.wait();
+        }
+
+    time = Time::getCurrentTime() - startTime;
+
+    printf( "Uncontended signal/wait:    %6.2f ns\n",
+            1000000000 * time / NUM_UNCONTENDED );
+
+
+    ReadWriteLock rwLock;
+
+    startTime = Time::getCurrentTime();
+
+    for( int i=0; i<NUM_UNCONTENDED; i++ ) {
+        rwLock.lockRead();
+        rwLock.unlockRead();
+        }
+
+    time = Time::getCurrentTime() - startTime;
+
+    printf( "Uncontended read lock:      %6.2f ns\n",
+            1000000000 * time / NUM_UNCONTENDED );
+
+    startTime = Time::getCurrentTime();
+
+    for( int i=0; i<NUM_UNCONTENDED; i++ ) {
+        rwLock.lockWrite();
+        rwLock.unlockWrite();
+        }
+
+    time = Time::getCurrentTime() - startTime;
+
+    printf( "Uncontended write lock:     %6.2f ns\n",
+            1000000000 * time / NUM_UNCONTENDED );
+
+
+    int numTimedOut = 0;
+
+    startTime = Time::getCurrentTime();
+
+    for( int i=0; i<20; i++ ) {
+        if( semaphore.wait( 5 ) == 0 ) {
+            numTimedOut++;
+            }
+        }
+
+    time = Time::getCurrentTime() - startTime;
+
+    printf( "Timed waits:  %d of 20 timed out, %.1f ms each\n",
+            numTimedOut, 1000 * time / 20 );
+
+    // a signal after timeouts should still be taken by the next wait
+    semaphore.signal();
+    if( semaphore.willBlock() || semaphore.wait( 0 ) != 1 ) {
+        printf( "FAILED:  signal after timed waits was lost\n" );
+        return 1;
+        }
+
+
+
+    idle.mStopSemaphore.signal();
+    idle.join();
+
+
+    CounterThread *threads[ NUM_COUNTER_THREADS ];
+
+    startTime = Time::getCurrentTime();
+
+    for( int i=0; i<NUM_COUNTER_THREADS; i++ ) {
+        threads[i] = new CounterThread();
+        threads[i]->start();
+        }
+    for( int i=0; i<NUM_COUNTER_THREADS; i++ ) {
+        threads[i]->join();
+        delete threads[i];
+        }
+
+    time = Time::getCurrentTime() - startTime;
+
+    printf( "Contended lock/unlock (%d threads):  %6.2f ns, count %s\n",
+            NUM_COUNTER_THREADS,
+            1000000000 * time / ( NUM_CONTENDED * NUM_COUNTER_THREADS ),
+            ( counter == NUM_CONTENDED * NUM_COUNTER_THREADS )
+                ? "correct" : "WRONG" );
+
+
+    PongThread pong;
+    pong.start();
+
+    startTime = Time::getCurrentTime();
+
+    for( int i=0; i<NUM_PING_PONGS; i++ ) {
+        pingSemaphore.signal();
+        pongSemaphore.wait();
+        }
+
+    time = Time::getCurrentTime() - startTime;
+
+    pong.join();
+
+    printf( "Ping-pong round trip:       %6.2f us\n",
+            1000000 * time / NUM_PING_PONGS );
+
+
+    PairReaderThread *readers[ NUM_READER_THREADS ];
+    PairWriterThread writer;
+
+    startTime = Time::getCurrentTime();
+
+    writer.start();
+    for( int i=0; i<NUM_READER_THREADS; i++ ) {
+        readers[i] = new PairReaderThread();
+        readers[i]->start();
+        }
+
+    int numMismatched = 0;
+
+    for( int i=0; i<NUM_READER_THREADS; i++ ) {
+        readers[i]->join();
+        numMismatched += readers[i]->mNumMismatched;
+        delete readers[i];
+        }
+    writer.join();
+
+    time = Time::getCurrentTime() - startTime;
+
+    printf( "Read/write mix (%d readers, 1 writer):  %6.2f ns, "
+            "%d torn reads, final pair %s\n",
+            NUM_READER_THREADS,
+            1000000000 * time /
+                ( NUM_CONTENDED * NUM_READER_THREADS + NUM_CONTENDED / 10 ),
+            numMismatched,
+            ( pairA == NUM_CONTENDED / 10 && pairB == pairA )
+                ? "correct" : "WRONG" );
+
+
+    if( counter != NUM_CONTENDED * NUM_COUNTER_THREADS ||
+        numMismatched != 0 || pairA != NUM_CONTENDED / 10 ) {
+        return 1;
+        }
+
+    return 0;
+    }
@@ -0,0 +1,258 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+/**
+ * Runs nested startup phases that read files (directly, mapped, from a
+ * background thread) and settings, checks the counts written to
+ * startupTimelineTest.json, and times the cost of counting a read.
+ *
+ * Compile from above the minorGems directory with:
+ *   g++ -O2 -DSTARTUP_TIMELINE -I. minorGems/system/startupTimelineTest.cpp
+ *     minorGems/system/StartupTimeline.cpp minorGems/util/log/AppLog.cpp
+ *     minorGems/util/log/Log.cpp minorGems/util/log/PrintLog.cpp
+ *     minorGems/util/printUtils.cpp minorGems/util/stringUtils.cpp
+ *     minorGems/util/SettingsManager.cpp minorGems/crypto/hashes/sha1.cpp
+ *     minorGems/formats/encodingUtils.cpp
+ *     minorGems/io/file/linux/PathLinux.cpp
+ *     minorGems/io/file/unix/MappedFileContentsUnix.cpp
+ *     minorGems/system/MutexLockProfile.cpp
+ *     minorGems/system/linux/[A-Z]*.cpp
+ *     minorGems/system/unix/TimeUnix.cpp -lpthread -o startupTimelineTest
+ */
+
+#include "StartupTimeline.h"
+#include "Thread.h"
+#include "Time.h"
+
+#include "minorGems/io/file/File.h"
+#include "minorGems/util/SettingsManager.h"
+#include "minorGems/util/stringUtils.h"
+#include "minorGems/util/log/AppLog.h"
+#include "minorGems/util/log/PrintLog.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+
+
+#define NUM_FILES 4
+#define FILE_LENGTH 10000
+#define NUM_TIMED_READS 10000000
+
+
+static int numBad = 0;
+
+
+
+static void writeTestFile( const char *inName, int inLength ) {
+    unsigned char *data = new unsigned char[ inLength ];
+    memset( data, 'x', inLength );
+
+    File f( NULL, inName );
+    f.writeToFile( data, inLength );
+
+    delete [] data;
+    }
+
+
+
+static void readTestFile( const char *inName ) {
+    File f( NULL, inName );
+
+    int length;
+    unsigned char *data = f.readFileContents( &length );
+
+    if( data != NULL ) {
+        delete [] data;
+        }
+    }
+
+
+
+class ReaderThread : public Thread {
+
+    public:
+
+        ReaderThread() {
+            start();
+            }
+
+        ~ReaderThread() {
+            join();
+            }
+
+        virtual void run() {
+            readTestFile( "startupTimelineTest_bg.dat" );
+            }
+    };
+
+
+
+// checks that trace has a phase with these counts
+static void checkPhase( const char *inTrace, const char *inName,
+                        int inFiles, int inBytes, int inSettings ) {
+
+    char *nameString = autoSprintf( "{\"name\":\"%s\"", inName );
+    char *countString =
+        autoSprintf( "\"args\":{\"files\":%d,\"bytes\":%d,\"settings\":%d}",
+                     inFiles, inBytes, inSettings );
+
+    const char *phase = strstr( inTrace, nameString );
+
+    if( phase == NULL ) {
+        printf( "Phase %s missing from trace\n", inName );
+        numBad++;
+        }
+    else {
+        const char *lineEnd = strstr( phase, "\n" );
+        const char *counts = strstr( phase, countString );
+
+        if( counts == NULL || ( lineEnd != NULL && counts > lineEnd ) ) {
+            printf( "Phase %s should have %s\n", inName, countString );
+            numBad++;
+            }
+        }
+
+    delete [] nameString;
+    delete [] countString;
+    }
+
+
+
+int main() {
+    AppLog::setLog( new PrintLog() );
+
+    mkdir( "startupTimelineTestSettings", 0755 );
+    SettingsManager::setDirectoryName( "startupTimelineTestSettings" );
+
+    // written before any phase, so not counted in one
+    char **fileNames = new char*[ NUM_FILES ];
+    for( int i=0; i<NUM_FILES; i++ ) {
+        fileNames[i] = autoSprintf( "startupTimelineTest_%d.dat", i );
+        writeTestFile( fileNames[i], FILE_LENGTH );
+        }
+    writeTestFile( "startupTimelineTest_bg.dat", 3000 );
+    writeTestFile( "startupTimelineTest_map.dat", 5000 );
+
+    SettingsManager::setSetting( "startupTimelineTestA", 5 );
+    SettingsManager::clearCache();
+
+
+    // counted outside phases
+    double startTime = Time::getCurrentTime();
+    for( int i=0; i<NUM_TIMED_READS; i++ ) {
+        StartupTimeline::noteBytesRead( 1 );
+        }
+    double noteTime = ( Time::getCurrentTime() - startTime ) /
+        NUM_TIMED_READS;
+
+    printf( "%.1f ns per counted read\n", noteTime * 1000000000 );
+
+
+    StartupTimeline::beginPhase( "outer" );
+
+    StartupTimeline::beginPhase( "readFiles" );
+    for( int i=0; i<NUM_FILES; i++ ) {
+        readTestFile( fileNames[i] );
+        }
+
+    // a missing file isn't counted
+    readTestFile( "startupTimelineTest_missing.dat" );
+    StartupTimeline::endPhase();
+
+    {
+        STARTUP_PHASE( "mapFile" );
+
+        File f( NULL, "startupTimelineTest_map.dat" );
+        MappedFileContents *contents = f.mapContents();
+
+        if( contents == NULL ) {
+            printf( "Mapping failed\n" );
+            numBad++;
+            }
+        else {
+            delete contents;
+            }
+        }
+
+    StartupTimeline::beginPhase( "settings" );
+    // one file read, one miss, and one cache hit (not counted)
+    SettingsManager::getIntSetting( "startupTimelineTestA", 0 );
+    SettingsManager::getIntSetting( "startupTimelineTestMissing", 0 );
+    SettingsManager::getIntSetting( "startupTimelineTestA", 0 );
+    StartupTimeline::endPhase();
+
+    StartupTimeline::beginPhase( "background" );
+    delete new ReaderThread();
+    // left open, ended by finish
+    StartupTimeline::beginPhase( "unended" );
+
+
+    StartupTimeline::finish( "startupTimelineTest.json" );
+
+    if( StartupTimeline::isRecording() ) {
+        printf( "Still recording after finish\n" );
+        numBad++;
+        }
+
+    // ignored
+    StartupTimeline::beginPhase( "late" );
+    StartupTimeline::endPhase();
+    StartupTimeline::finish( "startupTimelineTest.json" );
+
+
+    File traceFile( NULL, "startupTimelineTest.json" );
+    char *trace = traceFile.readFileContents();
+
+    if( trace == NULL ) {
+        printf( "Trace missing\n" );
+        numBad++;
+        }
+    else {
+        // setting file is a few bytes ("5")
+        File settingFile( NULL,
+                          "startupTimelineTestSettings/"
+                          "startupTimelineTestA.ini" );
+        int settingBytes = settingFile.getLength();
+
+        checkPhase( trace, "readFiles", NUM_FILES, NUM_FILES * FILE_LENGTH,
+                    0 );
+        checkPhase( trace, "mapFile", 1, 0, 0 );
+        checkPhase( trace, "settings", 1, settingBytes, 2 );
+        checkPhase( trace, "background", 1, 3000, 0 );
+        checkPhase( trace, "unended", 0, 0, 0 );
+        checkPhase( trace, "outer", NUM_FILES + 3,
+                    NUM_FILES * FILE_LENGTH + settingBytes + 3000, 2 );
+
+        if( strstr( trace, "\"late\"" ) != NULL ) {
+            printf( "Phase after finish recorded\n" );
+            numBad++;
+            }
+
+        delete [] trace;
+        }
+
+
+    for( int i=0; i<NUM_FILES; i++ ) {
+        remove( fileNames[i] );
+        delete [] fileNames[i];
+        }
+    delete [] fileNames;
+
+    remove( "startupTimelineTest_bg.dat" );
+    remove( "startupTimelineTest_map.dat" );
+
+
+    if( numBad == 0 ) {
+        printf( "All tests passed\n" );
+        return 0;
+        }
+
+    printf( "%d failures\n", numBad );
+    return 1;
+    }
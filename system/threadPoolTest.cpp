@@ -0,0 +1,167 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14   Jason Rohrer
+ * Created.
+ */
+
+/**
+ * Checks that ThreadPool runs every task and every parallelFor item once,
+ * including parallelFor calls nested inside tasks on a one-thread pool,
+ * and compares task overhead against a thread per task.
+ *
+ * Compile from above the minorGems directory with:
+ *   g++ -O2 -I. minorGems/system/threadPoolTest.cpp
+ *     minorGems/system/ThreadPool.cpp minorGems/system/linux/[A-Z]*.cpp
+ *     minorGems/system/unix/TimeUnix.cpp -lpthread -o threadPoolTest
+ */
+ 
+#include "ThreadPool.h"
+#include "Time.h"
+#include "atomicOps.h"
+
+#include <stdio.h>
+
+
+
+static volatile int taskCount = 0;
+
+
+class CountingTask : public ThreadPoolTask {
+    public:
+        void run() {
+            atomicFetchAdd( &taskCount, 1 );
+            }
+    };
+
+
+class CountingThread : public Thread {
+    public:
+        void run() {
+            atomicFetchAdd( &taskCount, 1 );
+            }
+    };
+
+
+
+#define NUM_ITEMS 100000
+
+static volatile int itemCounts[ NUM_ITEMS ];
+
+
+static void countRange( void *inContext, int inStart, int inEnd ) {
+    for( int i=inStart; i<inEnd; i++ ) {
+        atomicFetchAdd( &( itemCounts[i] ), 1 );
+        }
+    }
+
+
+
+class NestedTask : public ThreadPoolTask {
+    public:
+        NestedTask( ThreadPool *inPool )
+                : mPool( inPool ) {
+            }
+
+        void run() {
+            mPool->parallelFor( countRange, NULL, NUM_ITEMS, 100 );
+            }
+
+    protected:
+        ThreadPool *mPool;
+    };
+
+
+
+static char checkItemCounts( int inExpected ) {
+    for( int i=0; i<NUM_ITEMS; i++ ) {
+        if( itemCounts[i] != inExpected ) {
+            printf( "Item %d counted %d times, expected %d\n",
+                    i, itemCounts[i], inExpected );
+            return false;
+            }
+        }
+    return true;
+    }
+
+
+
+int main() {
+    char failed = false;
+    
+    ThreadPool pool;
+
+    printf( "Pool has %d threads\n", pool.getNumThreads() );
+    
+
+    int numTasks = 100000;
+    
+    ThreadPoolHandle **handles = new ThreadPoolHandle*[ numTasks ];
+
+    double startTime = Time::getCurrentTime();
+
+    for( int i=0; i<numTasks; i++ ) {
+        handles[i] = pool.submit( new CountingTask() );
+        }
+    for( int i=0; i<numTasks; i++ ) {
+        handles[i]->wait();
+        handles[i]->release();
+        }
+    
+    printf( "Pool:  %.2f us per task\n",
+            1000000 * ( Time::getCurrentTime() - startTime ) / numTasks );
+
+    delete [] handles;
+
+    if( taskCount != numTasks ) {
+        printf( "Ran %d of %d tasks\n", taskCount, numTasks );
+        failed = true;
+        }
+    
+    
+    int numThreads = 5000;
+    
+    startTime = Time::getCurrentTime();
+
+    for( int i=0; i<numThreads; i++ ) {
+        CountingThread thread;
+        thread.start();
+        thread.join();
+        }
+    
+    printf( "Thread per task:  %.2f us per task\n",
+            1000000 * ( Time::getCurrentTime() - startTime ) / numThreads );
+
+    
+    pool.parallelFor( countRange, NULL, NUM_ITEMS, 100 );
+
+    if( ! checkItemCounts( 1 ) ) {
+        failed = true;
+        }
+    
+
+    // one thread, so nested waits must run tasks themselves
+    ThreadPool smallPool( 1 );
+
+    ThreadPoolHandle *nested[4];
+    for( int i=0; i<4; i++ ) {
+        nested[i] = smallPool.submit( new NestedTask( &smallPool ) );
+        }
+    for( int i=0; i<4; i++ ) {
+        nested[i]->wait();
+        nested[i]->release();
+        }
+
+    if( ! checkItemCounts( 5 ) ) {
+        failed = true;
+        }
+    
+
+    if( failed ) {
+        printf( "FAILED\n" );
+        return 1;
+        }
+    
+    printf( "OK\n" );
+    return 0;
+    }
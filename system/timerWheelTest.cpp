@@ -0,0 +1,223 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+/**
+ * Checks that TimerWheel fires every timer once, never early, including
+ * timers canceled or rescheduled from fire calls and timers long enough
+ * to move down through the levels, and times schedule and cancel calls.
+ *
+ * Compile from above the minorGems directory with:
+ *   g++ -O2 -I. minorGems/system/timerWheelTest.cpp
+ *     minorGems/system/TimerWheel.cpp
+ *     minorGems/system/linux/[A-Z]*.cpp
+ *     minorGems/system/unix/TimeUnix.cpp -lpthread -o timerWheelTest
+ */
+ 
+#include "TimerWheel.h"
+#include "Time.h"
+#include "Thread.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+
+
+static int numBad = 0;
+
+
+class TestTimer : public TimerWheelTimer {
+    public:
+        TestTimer()
+                : mFireCount( 0 ), mDueNanoseconds( 0 ),
+                  mLateNanoseconds( 0 ), mDelayMS( 0 ),
+                  mWheel( NULL ), mToCancel( NULL ), mRescheduleCount( 0 ) {
+            }
+
+
+        void start( TimerWheel *inWheel, int inDelayMS ) {
+            mWheel = inWheel;
+            mDueNanoseconds = Time::getMonotonicNanoseconds() +
+                (int64_t)inDelayMS * 1000000;
+            mDelayMS = inDelayMS;
+            inWheel->schedule( this, inDelayMS );
+            }
+
+
+        void fire() {
+            int64_t now = Time::getMonotonicNanoseconds();
+
+            if( now < mDueNanoseconds ) {
+                printf( "Timer fired %d us early\n",
+                        (int)( ( mDueNanoseconds - now ) / 1000 ) );
+                numBad++;
+                }
+            mLateNanoseconds = now - mDueNanoseconds;
+
+            mFireCount++;
+
+            if( mToCancel != NULL ) {
+                mWheel->cancel( mToCancel );
+                }
+
+            if( mRescheduleCount > 0 ) {
+                mRescheduleCount--;
+                start( mWheel, mDelayMS );
+                }
+            }
+
+
+        int mFireCount;
+        int64_t mDueNanoseconds;
+        int64_t mLateNanoseconds;
+        int mDelayMS;
+
+        TimerWheel *mWheel;
+
+        // canceled when this fires
+        TimerWheelTimer *mToCancel;
+
+        // times to reschedule from fire
+        int mRescheduleCount;
+    };
+
+
+
+static void runUntilEmpty( TimerWheel *inWheel ) {
+    while( inWheel->getNumScheduled() > 0 ) {
+        int waitMS = inWheel->getMSUntilNext( 100 );
+        if( waitMS > 0 ) {
+            Thread::staticSleep( waitMS );
+            }
+        inWheel->runExpired();
+        }
+    }
+
+
+
+int main() {
+
+    TimerWheel wheel( 1 );
+    
+    // many random short delays, some canceled, some canceling others
+    int numTimers = 5000;
+    TestTimer *timers = new TestTimer[ numTimers ];
+    
+    srand( 1 );
+    
+    for( int i=0; i<numTimers; i++ ) {
+        timers[i].start( &wheel, rand() % 300 );
+        }
+
+    for( int i=0; i<numTimers; i+=10 ) {
+        wheel.cancel( &( timers[i] ) );
+        }
+    
+    // canceled by an earlier timer with same due time
+    timers[1].mToCancel = &( timers[3] );
+    timers[1].start( &wheel, 50 );
+    timers[3].start( &wheel, 50 );
+
+    timers[5].mRescheduleCount = 3;
+    timers[5].start( &wheel, 20 );
+
+    runUntilEmpty( &wheel );
+
+    int64_t maxLate = 0;
+    for( int i=0; i<numTimers; i++ ) {
+        int expected = 1;
+        if( i % 10 == 0 || i == 3 ) {
+            expected = 0;
+            }
+        if( i == 5 ) {
+            expected = 4;
+            }
+        if( i == 3 && timers[3].mFireCount == 1 ) {
+            // timers 1 and 3 are due in same tick, in either order
+            expected = 1;
+            }
+        if( timers[i].mFireCount != expected ) {
+            printf( "Timer %d fired %d times, expected %d\n", 
+                    i, timers[i].mFireCount, expected );
+            numBad++;
+            }
+        if( timers[i].mLateNanoseconds > maxLate ) {
+            maxLate = timers[i].mLateNanoseconds;
+            }
+        }
+    printf( "Short timers done, latest fired %.2f ms late\n",
+            maxLate / 1000000.0 );
+
+    delete [] timers;
+
+
+    // long delays, with few ms ticks, move down through levels
+    TimerWheel coarseWheel( 1 );
+    
+    TestTimer longTimers[4];
+    int longDelays[4] = { 63, 64, 700, 4100 };
+    
+    for( int i=0; i<4; i++ ) {
+        longTimers[i].start( &coarseWheel, longDelays[i] );
+        }
+    
+    runUntilEmpty( &coarseWheel );
+
+    for( int i=0; i<4; i++ ) {
+        if( longTimers[i].mFireCount != 1 ) {
+            printf( "Long timer %d fired %d times\n", 
+                    i, longTimers[i].mFireCount );
+            numBad++;
+            }
+        printf( "%d ms timer fired %.2f ms late\n", longDelays[i],
+                longTimers[i].mLateNanoseconds / 1000000.0 );
+        }
+
+
+    // far beyond wheel span is parked, then counted down
+    TimerWheel farWheel( 1 );
+    TestTimer farTimer;
+    farTimer.start( &farWheel, 2000000000 );
+    farWheel.runExpired();
+    if( farTimer.mFireCount != 0 || ! farTimer.isScheduled() ) {
+        printf( "Far timer not kept scheduled\n" );
+        numBad++;
+        }
+    
+
+    // schedule and cancel cost with many timers scheduled
+    int numBench = 1000000;
+    TestTimer *benchTimers = new TestTimer[ numBench ];
+    
+    TimerWheel benchWheel( 10 );
+
+    int64_t startNS = Time::getMonotonicNanoseconds();
+    for( int i=0; i<numBench; i++ ) {
+        benchWheel.schedule( &( benchTimers[i] ),
+                             (int)( ( (int64_t)i * 7919 ) % 600000 ) );
+        }
+    int64_t scheduleNS = Time::getMonotonicNanoseconds() - startNS;
+
+    startNS = Time::getMonotonicNanoseconds();
+    for( int i=0; i<numBench; i++ ) {
+        benchWheel.cancel( &( benchTimers[i] ) );
+        }
+    int64_t cancelNS = Time::getMonotonicNanoseconds() - startNS;
+
+    printf( "%d timers: %.1f ns per schedule, %.1f ns per cancel\n",
+            numBench, 
+            (double)scheduleNS / numBench, (double)cancelNS / numBench );
+
+    delete [] benchTimers;
+
+    
+    if( numBad == 0 ) {
+        printf( "All tests passed\n" );
+        return 0;
+        }
+    printf( "%d failures\n", numBad );
+    return 1;
+    }
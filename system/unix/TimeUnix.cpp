@@ -8,6 +8,10 @@
  * Added include of time.h so that FreeBSD compile will work.
  * Changed to use newer gettimeofday that should work on all unix platforms.
  * Fixed a conversion bug.
+ *
+ * 2026-October-15		Jason Rohrer
+ * Added high-resolution monotonic time.
+ * Added nanosecond monotonic time (mach_absolute_time on Mac).
  */
 
 
@@ -22,12 +26,20 @@
 
 #include <stdio.h>
 
+#ifdef __APPLE__
+#include <mach/mach_time.h>
+#endif
+
 
 char Time::sEpochTimeSet = false;
 
 // C standard says that -1 is a valid time_t value
 time_t Time::sEpochTime = (time_t)( -1 );
 
+volatile char Time::sCachedTimeSet = false;
+volatile double Time::sCachedMonotonicTime = 0;
+volatile timeSec_t Time::sCachedTimeSec = 0;
+
 
 void Time::getCurrentTime( timeSec_t *outSeconds,
 						   unsigned long *outMilliseconds ) {
@@ -44,3 +56,36 @@ void Time::getCurrentTime( timeSec_t *outSeconds,
 	}
 
 
+
+double Time::getMonotonicTime() {
+    struct timespec now;
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    
+    return now.tv_sec + now.tv_nsec / 1000000000.0;
+    }
+
+
+
+int64_t Time::getMonotonicNanoseconds() {
+#ifdef __APPLE__
+    static mach_timebase_info_data_t timebase = { 0, 0 };
+
+    if( timebase.denom == 0 ) {
+        mach_timebase_info( &timebase );
+        }
+
+    uint64_t ticks = mach_absolute_time();
+
+    // split to avoid overflowing when numer is large
+    uint64_t whole = ticks / timebase.denom;
+    uint64_t remainder = ticks % timebase.denom;
+
+    return (int64_t)( whole * timebase.numer +
+                      remainder * timebase.numer / timebase.denom );
+#else
+    struct timespec now;
+    clock_gettime( CLOCK_MONOTONIC, &now );
+
+    return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+#endif
+    }
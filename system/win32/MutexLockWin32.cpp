@@ -16,6 +16,11 @@
  * Changed to use malloc instead of new internally to work with debugMemory.
  * Made use of mNativeObjectPointer a bit cleaner.
  * Fixed a few bugs with new use of mNativeObjectPointer.
+ *
+ * 2026-October-14   Jason Rohrer
+ * Replaced kernel mutex with a spinning critical section, which only
+ * enters the kernel when contended.
+ * Added lock names and profiling hooks.
  */
 
 #include "minorGems/common.h"
@@ -27,6 +32,10 @@
 #include <windows.h>
 #include <stdlib.h>
 
+#ifdef MUTEX_LOCK_PROFILING
+	#include "minorGems/system/MutexLockProfile.h"
+#endif
+
 
 
 /**
@@ -34,48 +43,75 @@
  */
 
 
-MutexLock::MutexLock() {
-	// allocate a handle on the heap
-	mNativeObjectPointer = malloc( sizeof( HANDLE ) );
+// tries before sleeping, since most critical sections here are short
+#define MUTEX_LOCK_SPIN_COUNT 4000
+
+
+
+MutexLock::MutexLock( const char *inName ) {
+	// allocate a critical section on the heap
+	mNativeObjectPointer = malloc( sizeof( CRITICAL_SECTION ) );
 	
-	// retrieve handle from the heap
-	HANDLE *mutexPointer = (HANDLE *)mNativeObjectPointer;
+	CRITICAL_SECTION *sectionPointer = 
+		(CRITICAL_SECTION *)mNativeObjectPointer;
 	
-	// create the mutex
-	*mutexPointer = CreateMutex(
-		(LPSECURITY_ATTRIBUTES) NULL,	//  no attributes
-  		(BOOL) false,			// not initially locked
-  		(LPCTSTR) NULL );		// no name
+	// spins on multi-processor machines before waiting in kernel
+	InitializeCriticalSectionAndSpinCount( sectionPointer, 
+										   MUTEX_LOCK_SPIN_COUNT );
+
+	#ifdef MUTEX_LOCK_PROFILING
+		mProfile = mutexLockProfileCreate( inName );
+	#else
+		mProfile = NULL;
+	#endif
 	}
 
 
 
 MutexLock::~MutexLock() {
-	// retrieve handle from the heap
-	HANDLE *mutexPointer = (HANDLE *)mNativeObjectPointer;
+	#ifdef MUTEX_LOCK_PROFILING
+		mutexLockProfileDestroy( mProfile );
+	#endif
+
+	CRITICAL_SECTION *sectionPointer = 
+		(CRITICAL_SECTION *)mNativeObjectPointer;
 	  
-	// destroy the mutex	
-	CloseHandle( *mutexPointer );
+	DeleteCriticalSection( sectionPointer );
 	
-	// de-allocate the mutex structure from the heap
-	free( mutexPointer );
+	// de-allocate the critical section from the heap
+	free( sectionPointer );
 	}
 
 
 
 void MutexLock::lock() {
-	// retrieve handle from the heap
-	HANDLE *mutexPointer = (HANDLE *)mNativeObjectPointer;
+	CRITICAL_SECTION *sectionPointer = 
+		(CRITICAL_SECTION *)mNativeObjectPointer;
 	
-	WaitForSingleObject( *mutexPointer, INFINITE );
+	#ifdef MUTEX_LOCK_PROFILING
+		if( TryEnterCriticalSection( sectionPointer ) ) {
+			mutexLockProfileLocked( mProfile, -1 );
+			return;
+			}
+		double waitStartTime = mutexLockProfileTime();
+	#endif
+
+	EnterCriticalSection( sectionPointer );
+
+	#ifdef MUTEX_LOCK_PROFILING
+		mutexLockProfileLocked( mProfile, waitStartTime );
+	#endif
 	}
 
 
 
 void MutexLock::unlock() {
-	// retrieve handle from the heap
-	HANDLE *mutexPointer = (HANDLE *)mNativeObjectPointer;
+	CRITICAL_SECTION *sectionPointer = 
+		(CRITICAL_SECTION *)mNativeObjectPointer;
 	
-	ReleaseMutex( *mutexPointer );
-	}
+	#ifdef MUTEX_LOCK_PROFILING
+		mutexLockProfileUnlocking( mProfile );
+	#endif
 
+	LeaveCriticalSection( sectionPointer );
+	}
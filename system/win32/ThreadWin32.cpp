@@ -17,6 +17,10 @@
  *
  * 2005-January-22   Jason Rohrer
  * Added a static sleep function.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Fixed CloseHandle on a garbage handle when a thread is never started
+ * (as with FinishedSignalThreadManager's pooled threads).
  */
  
 #include "minorGems/system/Thread.h"
@@ -42,7 +46,10 @@ DWORD WINAPI win32ThreadFunction( void * );
 
 Thread::Thread() {
 	// allocate a handle on the heap
-	mNativeObjectPointer = (void *)( new HANDLE[1] );
+	HANDLE *threadPointer = new HANDLE[1];
+	threadPointer[0] = NULL;
+	
+	mNativeObjectPointer = (void *)threadPointer;
 	}
 
 
@@ -52,7 +59,9 @@ Thread::~Thread() {
 	HANDLE *threadPointer = (HANDLE *)mNativeObjectPointer;
 
     // close the handle to ensure that the thread resources are freed
-    CloseHandle( threadPointer[0] );
+    if( threadPointer[0] != NULL ) {
+        CloseHandle( threadPointer[0] );
+        }
     
     // de-allocate the thread handle from the heap
 	delete [] threadPointer;
@@ -14,6 +14,10 @@
  * Fixed bug in second/millisecond callibration.
  * Fixed bug in win32 time to ANSI time translation.
  * Fixed daylight savings time bug.
+ *
+ * 2026-October-15		Jason Rohrer
+ * Added high-resolution monotonic time.
+ * Added nanosecond monotonic time.
  */
 
 
@@ -30,6 +34,10 @@ char Time::sEpochTimeSet = false;
 // C standard says that -1 is a valid time_t value
 time_t Time::sEpochTime = (time_t)( -1 );
 
+volatile char Time::sCachedTimeSet = false;
+volatile double Time::sCachedMonotonicTime = 0;
+volatile timeSec_t Time::sCachedTimeSec = 0;
+
 
 
 /**
@@ -81,3 +89,41 @@ void Time::getCurrentTime( timeSec_t *outSeconds,
 	}
 
 
+
+double Time::getMonotonicTime() {
+    static double secondsPerCount = 0;
+
+    if( secondsPerCount == 0 ) {
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency( &frequency );
+        
+        secondsPerCount = 1.0 / (double)( frequency.QuadPart );
+        }
+
+    LARGE_INTEGER count;
+    QueryPerformanceCounter( &count );
+    
+    return (double)( count.QuadPart ) * secondsPerCount;
+    }
+
+
+
+int64_t Time::getMonotonicNanoseconds() {
+    static int64_t countsPerSecond = 0;
+
+    if( countsPerSecond == 0 ) {
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency( &frequency );
+
+        countsPerSecond = frequency.QuadPart;
+        }
+
+    LARGE_INTEGER count;
+    QueryPerformanceCounter( &count );
+
+    // split to avoid overflowing count * 10^9
+    int64_t whole = count.QuadPart / countsPerSecond;
+    int64_t remainder = count.QuadPart % countsPerSecond;
+
+    return whole * 1000000000 + remainder * 1000000000 / countsPerSecond;
+    }
@@ -0,0 +1,151 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+/**
+ * Records nested zones from several threads across frames, overflows
+ * one thread's ring while measuring the cost of one zone, and writes
+ * zoneProfilerTest.json.
+ *
+ * Compile from above the minorGems directory with:
+ *   g++ -O2 -DZONE_PROFILING -I. minorGems/system/zoneProfilerTest.cpp
+ *     minorGems/system/ZoneProfiler.cpp minorGems/util/log/AppLog.cpp
+ *     minorGems/util/log/Log.cpp minorGems/util/log/PrintLog.cpp
+ *     minorGems/util/printUtils.cpp minorGems/util/stringUtils.cpp
+ *     minorGems/system/MutexLockProfile.cpp
+ *     minorGems/system/linux/[A-Z]*.cpp
+ *     minorGems/system/unix/TimeUnix.cpp -lpthread -o zoneProfilerTest
+ */
+
+#include "ZoneProfiler.h"
+#include "Thread.h"
+#include "Time.h"
+
+#include "minorGems/util/log/AppLog.h"
+#include "minorGems/util/log/PrintLog.h"
+
+#include <stdio.h>
+
+
+
+#define NUM_THREADS 3
+#define NUM_FRAMES 100
+#define NUM_TIMED_ZONES 10000000
+
+
+
+static volatile int sink = 0;
+
+
+static void spin( int inCount ) {
+    for( int i=0; i<inCount; i++ ) {
+        sink += i;
+        }
+    }
+
+
+
+class ZoneThread : public Thread {
+
+    public:
+
+        ZoneThread( const char *inName )
+                : mName( inName ) {
+            start();
+            }
+
+        ~ZoneThread() {
+            join();
+            }
+
+        virtual void run() {
+            PROFILE_THREAD_NAME( mName );
+
+            for( int i=0; i<NUM_FRAMES; i++ ) {
+                PROFILE_ZONE( "outer" );
+                spin( 10000 );
+                {
+                    PROFILE_ZONE( "inner" );
+                    spin( 50000 );
+                    }
+                }
+            }
+
+    protected:
+        const char *mName;
+    };
+
+
+
+class TimedZoneThread : public Thread {
+
+    public:
+
+        TimedZoneThread() {
+            start();
+            }
+
+        ~TimedZoneThread() {
+            join();
+            }
+
+        virtual void run() {
+            PROFILE_THREAD_NAME( "timed" );
+
+            // overflows this thread's ring many times over
+            double startTime = Time::getCurrentTime();
+
+            for( int i=0; i<NUM_TIMED_ZONES; i++ ) {
+                PROFILE_ZONE( "timed" );
+                }
+
+            double zoneTime = ( Time::getCurrentTime() - startTime ) /
+                NUM_TIMED_ZONES;
+
+            printf( "%.1f ns per zone\n", zoneTime * 1000000000 );
+            }
+    };
+
+
+
+int main() {
+    AppLog::setLog( new PrintLog() );
+
+    PROFILE_THREAD_NAME( "main" );
+
+    const char *names[ NUM_THREADS ] = { "worker A", "worker B", "worker C" };
+    ZoneThread *threads[ NUM_THREADS ];
+
+    for( int t=0; t<NUM_THREADS; t++ ) {
+        threads[t] = new ZoneThread( names[t] );
+        }
+
+    for( int i=0; i<NUM_FRAMES; i++ ) {
+        PROFILE_FRAME();
+        PROFILE_ZONE( "frame" );
+        spin( 10000 );
+        {
+            PROFILE_ZONE( "draw" );
+            spin( 20000 );
+            }
+        }
+
+    for( int t=0; t<NUM_THREADS; t++ ) {
+        delete threads[t];
+        }
+
+    delete new TimedZoneThread();
+
+
+    ZoneProfiler::logProfile();
+
+    if( ! ZoneProfiler::writeChromeTrace( "zoneProfilerTest.json" ) ) {
+        printf( "FAILED to write trace\n" );
+        return 1;
+        }
+
+    return 0;
+    }
@@ -9,6 +9,9 @@
 *	Created 11-7-99
 *	Mods:	
 *		Jason Rohrer	11-8-99		Changed to use GraphicBuffer object as screen buffer
+*		Jason Rohrer	2026-October-15	Kept history in a min/max pyramid, so that
+*										long histories draw in time bounded by width.
+*										Rendering deferred from addPoint to draw.
 *
 */
 
@@ -59,40 +62,193 @@ Plot::Plot( int x, int y, int w, int h, Color bordC, Color bC, Color lnC ) {
 		}
 	
 	
-	plotVals = new float[innerWide];
+	columnMin = new float[innerWide];
+	columnMax = new float[innerWide];
 	
-	for( int i=0; i<innerWide; i++ ) {
-		plotVals[i] = 0;
+	for( int k=0; k<PLOT_NUM_LEVELS; k++ ) {
+		levelStart[k] = 0;
+		pendingHalf[k] = false;
 		}
 	
+	numPoints = 0;
+	visiblePoints = innerWide;
+	
+	// image starts empty, as prepared above
+	dirty = false;
 	}
 	
 Plot::~Plot() {
 	delete [] imageMap;
 	delete [] mapYOffset;
-	delete [] plotVals;
+	delete [] columnMin;
+	delete [] columnMax;
 	}
 	
 	
 	
 void Plot::addPoint( float p ) {
 
-	// scroll plot vals
-	//memmove( (void *)plotVals, (void *)(&(plotVals[1])), sizeof(float) * innerWide );
-	for( int i=0; i<innerWide-1; i++ ) {
-		plotVals[i] = plotVals[i+1];
+	levelMin[0].push_back( p );
+	numPoints++;
+
+	// carry up the pyramid, completing an entry at each level where
+	//   this point ends a run
+	float lo = p;
+	float hi = p;
+	
+	for( int k=1; k<PLOT_NUM_LEVELS; k++ ) {
+		if( !pendingHalf[k] ) {
+			pendingMin[k] = lo;
+			pendingMax[k] = hi;
+			pendingHalf[k] = true;
+			break;
+			}
+		
+		if( pendingMin[k] < lo ) lo = pendingMin[k];
+		if( pendingMax[k] > hi ) hi = pendingMax[k];
+		pendingHalf[k] = false;
+		
+		levelMin[k].push_back( lo );
+		levelMax[k].push_back( hi );
+		}
+	
+	// discard in batches, so it is O(1) amortized
+	if( visiblePoints > 0 &&
+		numPoints - levelStart[0] > 2 * visiblePoints ) {
+		discardOld();
 		}
+	
+	dirty = true;
+	}
+
 
 
-	// add new
-	plotVals[innerWide-1] = p;
+void Plot::setVisiblePoints( unsigned long num ) {
+	visiblePoints = num;
+	dirty = true;
+	}
 
 
-	float largest = 0;	
-	// find largest
-	for( int i=0; i<innerWide; i++ ) {
-		if( largest < plotVals[i] ) {
-			largest = plotVals[i];
+
+void Plot::discardOld() {
+	if( numPoints <= visiblePoints ) {
+		return;
+		}
+	
+	unsigned long firstKept = numPoints - visiblePoints;
+	
+	for( int k=0; k<PLOT_NUM_LEVELS; k++ ) {
+		// first entry that starts at or after firstKept
+		unsigned long firstEntry = ( firstKept + ( 1UL << k ) - 1 ) >> k;
+		
+		if( firstEntry <= levelStart[k] ) {
+			continue;
+			}
+		
+		unsigned long numToDiscard = firstEntry - levelStart[k];
+		unsigned long numStored = levelMin[k].size();
+		
+		if( numToDiscard > numStored ) {
+			numToDiscard = numStored;
+			}
+		
+		levelMin[k].deleteStartElements( numToDiscard );
+		if( k > 0 ) {
+			levelMax[k].deleteStartElements( numToDiscard );
+			}
+		levelStart[k] += numToDiscard;
+		}
+	}
+
+
+
+void Plot::getRange( unsigned long start, unsigned long end,
+					 float *outMin, float *outMax ) {
+	
+	float lo = levelMin[0].getElementDirect( start - levelStart[0] );
+	float hi = lo;
+	
+	// cover the range with the largest aligned runs that fit, which
+	//   takes O(log) entries from the levels matching its length
+	while( start < end ) {
+		int k = 0;
+		
+		while( k + 1 < PLOT_NUM_LEVELS ) {
+			unsigned long runLength = 2UL << k;
+			
+			if( ( start & ( runLength - 1 ) ) != 0 ||
+				end - start < runLength ) {
+				break;
+				}
+			
+			unsigned long entry = start >> ( k + 1 );
+			
+			if( entry < levelStart[k+1] ||
+				entry - levelStart[k+1] >=
+					(unsigned long)levelMin[k+1].size() ) {
+				// discarded, or not complete yet
+				break;
+				}
+			k++;
+			}
+		
+		unsigned long entry = ( start >> k ) - levelStart[k];
+		
+		float entryMin = levelMin[k].getElementDirect( entry );
+		float entryMax = entryMin;
+		if( k > 0 ) {
+			entryMax = levelMax[k].getElementDirect( entry );
+			}
+		
+		if( entryMin < lo ) lo = entryMin;
+		if( entryMax > hi ) hi = entryMax;
+		
+		start += 1UL << k;
+		}
+	
+	*outMin = lo;
+	*outMax = hi;
+	}
+
+
+
+void Plot::render() {
+	
+	// span the visible points, or everything, but at least one point
+	//   per column, so a short history fills in from the right
+	unsigned long span = visiblePoints;
+	if( span == 0 ) {
+		span = numPoints;
+		}
+	if( span < (unsigned long)innerWide ) {
+		span = innerWide;
+		}
+	
+	// index of the point at the left edge, negative before the first
+	long long first = (long long)numPoints - (long long)span;
+	
+	float largest = 0;
+	
+	for( int c=0; c<innerWide; c++ ) {
+		long long start = first + (long long)c * span / innerWide;
+		long long end = first + (long long)( c + 1 ) * span / innerWide;
+		
+		if( start < (long long)levelStart[0] ) {
+			start = levelStart[0];
+			}
+		
+		if( end <= start ) {
+			// missing points plot as 0
+			columnMin[c] = 0;
+			columnMax[c] = 0;
+			}
+		else {
+			getRange( start, end, &( columnMin[c] ), &( columnMax[c] ) );
+			}
+		
+		// find largest
+		if( largest < columnMax[c] ) {
+			largest = columnMax[c];
 			}
 		}
 	
@@ -111,21 +267,25 @@ void Plot::addPoint( float p ) {
 			}
 		}
 	
-	// now plot line
+	// now plot line, as a vertical run from max to min in each column
 	for( int x=borderWide; x<wide-borderWide; x++ ) {
 		
-		int y = (int)(plotVals[x-borderWide] * invLargest * innerHigh);
-		y = innerHigh - y;
-		if( y > innerHigh + borderWide ) y = innerHigh + borderWide -1;
-		if( y < borderWide ) y = borderWide;
+		int yRange[2];
+		float values[2] = { columnMax[x-borderWide], columnMin[x-borderWide] };
 		
-		imageMap[ mapYOffset[y] + x ] = lineC.composite;			// line		
-		}
-
-
-/*	for( int x=0; x<innerWide; x++) {
-		int y = innerHigh - (int)(plotVals[x] * innerHigh);
-		imageMap[ mapYOffset[y] + x ] = lineC.composite;
+		for( int i=0; i<2; i++ ) {
+			int y = (int)(values[i] * invLargest * innerHigh);
+			y = innerHigh - y;
+			if( y > innerHigh + borderWide ) y = innerHigh + borderWide -1;
+			if( y < borderWide ) y = borderWide;
+			
+			yRange[i] = y;
+			}
+		
+		for( int y=yRange[0]; y<=yRange[1]; y++ ) {
+			imageMap[ mapYOffset[y] + x ] = lineC.composite;			// line		
+			}
 		}
-*/	
-	}
\ No newline at end of file
+	
+	dirty = false;
+	}
@@ -9,6 +9,9 @@
 *	Created 11-7-99
 *	Mods:	
 *		Jason Rohrer	11-8-99		Changed to use GraphicBuffer object as screen buffer
+*		Jason Rohrer	2026-October-15	Kept history in a min/max pyramid, so that
+*										long histories draw in time bounded by width.
+*										Rendering deferred from addPoint to draw.
 *
 */
 
@@ -22,6 +25,13 @@
 #include "Color.h"
 #include "GraphicBuffer.h"
 
+#include "minorGems/util/SimpleVector.h"
+
+
+// enough levels for 2^31 points
+#define PLOT_NUM_LEVELS 32
+
+
 class Plot {
 
 	public:
@@ -31,8 +41,18 @@ class Plot {
 		~Plot();
 		
 		// add a point to the right of plot, cause plot to scroll left 
+		// O(1) amortized, whatever the length of the history
 		void addPoint( float p );
 		
+		// set how many of the most recent points the plot spans, or 0 to
+		//   span every point added so far
+		// each column shows the min and max of its points, so drawing time
+		//   depends on plot size, not on the number of points
+		// defaults to one point per column
+		// points older than the span are discarded (unless it is 0), so
+		//   widening the span shows older points only as they arrive
+		void setVisiblePoints( unsigned long num );
+		
 		// draw plot into a graphic buffer
 		void draw( GraphicBuffer &buff );
 		
@@ -63,7 +83,40 @@ class Plot {
 		static const int borderWide = 2;
 	
 		
-		float *plotVals;		// values of plot line
+		// history, as a min/max pyramid:  level 0 holds the points
+		//   themselves, and level k holds the min and max of each run of
+		//   2^k points starting at a multiple of 2^k
+		// level 0 uses only levelMin
+		SimpleVector<float> levelMin[ PLOT_NUM_LEVELS ];
+		SimpleVector<float> levelMax[ PLOT_NUM_LEVELS ];
+		
+		// index of first entry kept at each level (older ones discarded)
+		unsigned long levelStart[ PLOT_NUM_LEVELS ];
+		
+		// min and max of the first half of the next entry at each level,
+		//   if the first half has been seen
+		float pendingMin[ PLOT_NUM_LEVELS ];
+		float pendingMax[ PLOT_NUM_LEVELS ];
+		char pendingHalf[ PLOT_NUM_LEVELS ];
+		
+		unsigned long numPoints;		// points added so far
+		unsigned long visiblePoints;
+		
+		float *columnMin;		// per-column range, filled by render
+		float *columnMax;
+		
+		char dirty;		// points added since last render
+		
+		
+		// finds min and max of points [start, end), which must be kept
+		void getRange( unsigned long start, unsigned long end,
+					   float *outMin, float *outMax );
+		
+		// discards points older than the visible span
+		void discardOld();
+		
+		// draws the line into imageMap
+		void render();
 
 	};
 
@@ -71,6 +124,9 @@ class Plot {
 
 
 inline void Plot::draw( GraphicBuffer &buff ) {
+	if( dirty ) {
+		render();
+		}
 	buff.drawImage(imageMap, mapYOffset, startX, startY, wide, high);
 	}	
 
@@ -0,0 +1,254 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14   Jason Rohrer
+ * Created.
+ */
+
+#include "minorGems/common.h"
+
+
+
+#ifndef BYTE_RING_BUFFER_INCLUDED
+#define BYTE_RING_BUFFER_INCLUDED
+
+
+#include <string.h>
+
+
+
+/**
+ * FIFO of bytes in a circular buffer that grows as needed.
+ *
+ * Unlike a SimpleVector used as a queue, removing bytes from the front
+ * never moves the rest, so partially draining a large backlog is cheap.
+ *
+ * No memory is allocated until the first write.
+ *
+ * Not thread-safe (see LockFreeRingBuffer for that).
+ *
+ * @author Jason Rohrer
+ */
+class ByteRingBuffer {
+
+	public:
+
+		ByteRingBuffer();
+
+		~ByteRingBuffer();
+
+
+		// adds bytes at the end
+		void write( const unsigned char *inData, int inLength );
+
+
+		// number of bytes waiting to be read
+		int size();
+
+
+		/**
+		 * Gets the waiting bytes in place, without copying them.
+		 *
+		 * They may wrap around the end of the buffer, so up to two
+		 * pieces are returned, in order.
+		 *
+		 * @param outSpans array of 2 where start of each piece is
+		 *   returned.
+		 * @param outLengths array of 2 where length of each piece is
+		 *   returned.
+		 *
+		 * @return the number of pieces (0, 1, or 2).
+		 *   Valid only until the next write.
+		 */
+		int getReadSpans( unsigned char **outSpans, int *outLengths );
+
+
+		/**
+		 * Copies bytes out of the front and removes them.
+		 *
+		 * @return the number of bytes read (at most inMaxLength).
+		 */
+		int read( unsigned char *outData, int inMaxLength );
+
+
+		// removes inLength bytes from front (or all bytes, if fewer)
+		void consume( int inLength );
+
+
+		// removes all bytes, keeping allocated space for re-use
+		void clear();
+
+
+
+	protected:
+
+		unsigned char *mBuffer;
+
+		// always 0 or a power of 2
+		int mCapacity;
+
+		int mReadPos;
+
+		int mSize;
+
+
+		// makes room for at least inCapacity bytes
+		void grow( int inCapacity );
+
+
+	private:
+
+		// not copyable
+		ByteRingBuffer( const ByteRingBuffer &inCopy );
+		ByteRingBuffer & operator = ( const ByteRingBuffer &inOther );
+
+	};
+
+
+
+inline ByteRingBuffer::ByteRingBuffer()
+		: mBuffer( NULL ), mCapacity( 0 ), mReadPos( 0 ), mSize( 0 ) {
+	}
+
+
+
+inline ByteRingBuffer::~ByteRingBuffer() {
+	if( mBuffer != NULL ) {
+		delete [] mBuffer;
+		}
+	}
+
+
+
+inline void ByteRingBuffer::grow( int inCapacity ) {
+	int newCapacity = mCapacity;
+
+	if( newCapacity == 0 ) {
+		newCapacity = 4096;
+		}
+
+	while( newCapacity < inCapacity ) {
+		newCapacity *= 2;
+		}
+
+	unsigned char *newBuffer = new unsigned char[ newCapacity ];
+
+	int oldSize = mSize;
+
+	// unwrap into start of new buffer
+	read( newBuffer, oldSize );
+
+	if( mBuffer != NULL ) {
+		delete [] mBuffer;
+		}
+
+	mBuffer = newBuffer;
+	mCapacity = newCapacity;
+	mReadPos = 0;
+	mSize = oldSize;
+	}
+
+
+
+inline void ByteRingBuffer::write( const unsigned char *inData,
+								   int inLength ) {
+	if( inLength <= 0 ) {
+		return;
+		}
+
+	if( mSize + inLength > mCapacity ) {
+		grow( mSize + inLength );
+		}
+
+	int writePos = ( mReadPos + mSize ) & ( mCapacity - 1 );
+
+	int firstLength = mCapacity - writePos;
+
+	if( firstLength > inLength ) {
+		firstLength = inLength;
+		}
+
+	memcpy( &( mBuffer[ writePos ] ), inData, firstLength );
+	memcpy( mBuffer, &( inData[ firstLength ] ), inLength - firstLength );
+
+	mSize += inLength;
+	}
+
+
+
+inline int ByteRingBuffer::size() {
+	return mSize;
+	}
+
+
+
+inline int ByteRingBuffer::getReadSpans( unsigned char **outSpans,
+										 int *outLengths ) {
+	if( mSize == 0 ) {
+		return 0;
+		}
+
+	int firstLength = mCapacity - mReadPos;
+
+	if( firstLength >= mSize ) {
+		outSpans[0] = &( mBuffer[ mReadPos ] );
+		outLengths[0] = mSize;
+		return 1;
+		}
+
+	outSpans[0] = &( mBuffer[ mReadPos ] );
+	outLengths[0] = firstLength;
+
+	outSpans[1] = mBuffer;
+	outLengths[1] = mSize - firstLength;
+	return 2;
+	}
+
+
+
+inline int ByteRingBuffer::read( unsigned char *outData, int inMaxLength ) {
+	unsigned char *spans[2];
+	int lengths[2];
+
+	int numSpans = getReadSpans( spans, lengths );
+
+	int numRead = 0;
+
+	for( int i=0; i<numSpans && numRead < inMaxLength; i++ ) {
+		int length = lengths[i];
+
+		if( length > inMaxLength - numRead ) {
+			length = inMaxLength - numRead;
+			}
+
+		memcpy( &( outData[ numRead ] ), spans[i], length );
+		numRead += length;
+		}
+
+	consume( numRead );
+
+	return numRead;
+	}
+
+
+
+inline void ByteRingBuffer::consume( int inLength ) {
+	if( inLength >= mSize ) {
+		clear();
+		return;
+		}
+
+	mReadPos = ( mReadPos + inLength ) & ( mCapacity - 1 );
+	mSize -= inLength;
+	}
+
+
+
+inline void ByteRingBuffer::clear() {
+	mReadPos = 0;
+	mSize = 0;
+	}
+
+
+
+#endif
@@ -0,0 +1,294 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+#include "minorGems/common.h"
+
+
+
+#include "minorGems/util/FrameArena.h"
+#include "minorGems/util/stringUtils.h"
+#include "minorGems/system/atomicOps.h"
+
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <sched.h>
+#endif
+
+
+#ifdef _MSC_VER
+    #define FRAME_ARENA_THREAD_LOCAL __declspec( thread )
+#else
+    #define FRAME_ARENA_THREAD_LOCAL __thread
+#endif
+
+
+
+#define FRAME_ARENA_ALIGNMENT 16
+
+
+// visual studio doesn't have va_copy (see stringUtils.cpp)
+#ifndef va_copy
+    #define va_copy( dest, src ) ( dest = src )
+#endif
+
+
+static int alignUp( int inNumBytes ) {
+    return ( inNumBytes + FRAME_ARENA_ALIGNMENT - 1 ) &
+        ~( FRAME_ARENA_ALIGNMENT - 1 );
+    }
+
+
+
+FrameArena::FrameArena( int inBlockSize )
+        : mBlockSize( alignUp( inBlockSize ) ),
+          mBytesInFullBlocks( 0 ),
+          mPeakBytesUsed( 0 ),
+          mNextThreadArena( NULL ) {
+
+    mBlocks = makeBlock( mBlockSize );
+    }
+
+
+
+FrameArena::~FrameArena() {
+    while( mBlocks != NULL ) {
+        FrameArenaBlock *next = mBlocks->next;
+
+        delete [] mBlocks->bytes;
+        delete mBlocks;
+
+        mBlocks = next;
+        }
+    }
+
+
+
+FrameArenaBlock *FrameArena::makeBlock( int inSize ) {
+    FrameArenaBlock *b = new FrameArenaBlock;
+
+    // extra room to align start, since new [] only promises alignment
+    // for the largest basic type
+    b->bytes = new char[ inSize + FRAME_ARENA_ALIGNMENT ];
+    b->next = NULL;
+
+    int misalignment =
+        (int)( (size_t)( b->bytes ) & ( FRAME_ARENA_ALIGNMENT - 1 ) );
+
+    if( misalignment != 0 ) {
+        b->start = FRAME_ARENA_ALIGNMENT - misalignment;
+        }
+    else {
+        b->start = 0;
+        }
+
+    b->used = b->start;
+    b->size = b->start + inSize;
+
+    return b;
+    }
+
+
+
+void *FrameArena::allocate( int inNumBytes ) {
+    int size = alignUp( inNumBytes );
+
+    if( mBlocks->used + size > mBlocks->size ) {
+        // chain on an overflow block, big enough even for huge requests
+        int blockSize = mBlockSize;
+        if( size > blockSize ) {
+            blockSize = size;
+            }
+
+        FrameArenaBlock *b = makeBlock( blockSize );
+
+        mBytesInFullBlocks += mBlocks->used - mBlocks->start;
+
+        b->next = mBlocks;
+        mBlocks = b;
+        }
+
+    void *result = &( mBlocks->bytes[ mBlocks->used ] );
+
+    mBlocks->used += size;
+
+    int used = getBytesUsed();
+    if( used > mPeakBytesUsed ) {
+        mPeakBytesUsed = used;
+        }
+
+    return result;
+    }
+
+
+
+char *FrameArena::printString( const char *inFormatString, ... ) {
+    va_list argList;
+    va_start( argList, inFormatString );
+
+    char *result = vprintString( inFormatString, argList );
+
+    va_end( argList );
+
+    return result;
+    }
+
+
+
+char *FrameArena::vprintString( const char *inFormatString,
+                                va_list inArgList ) {
+
+    // print straight into free space of current block, which is usually
+    // enough, and only claim what the string used
+    char *freeSpace = &( mBlocks->bytes[ mBlocks->used ] );
+    int freeSize = mBlocks->size - mBlocks->used;
+
+    va_list argListCopy;
+    va_copy( argListCopy, inArgList );
+
+    int length = vautoSprintfInto( freeSpace, freeSize,
+                                   inFormatString, argListCopy );
+
+    va_end( argListCopy );
+
+    if( length < freeSize ) {
+        return (char *)allocate( length + 1 );
+        }
+
+    char *result = (char *)allocate( length + 1 );
+
+    vautoSprintfInto( result, length + 1, inFormatString, inArgList );
+
+    return result;
+    }
+
+
+
+void FrameArena::reset() {
+    if( mBlocks->next != NULL ) {
+        // last frame overflowed
+        // replace chain with one block that would have held it all
+        int totalUsed = getBytesUsed();
+
+        while( mBlocks != NULL ) {
+            FrameArenaBlock *next = mBlocks->next;
+
+            delete [] mBlocks->bytes;
+            delete mBlocks;
+
+            mBlocks = next;
+            }
+
+        mBlockSize = alignUp( totalUsed );
+        mBlocks = makeBlock( mBlockSize );
+        }
+    else {
+        mBlocks->used = mBlocks->start;
+        }
+
+    mBytesInFullBlocks = 0;
+    }
+
+
+
+int FrameArena::getBytesUsed() {
+    return mBytesInFullBlocks + mBlocks->used - mBlocks->start;
+    }
+
+
+
+int FrameArena::getPeakBytesUsed() {
+    return mPeakBytesUsed;
+    }
+
+
+
+static FRAME_ARENA_THREAD_LOCAL FrameArena *threadArena = NULL;
+
+
+// protects allThreadArenas
+// spins, as in MutexLockProfile
+static volatile int threadArenasLock = 0;
+
+static FrameArena *allThreadArenas = NULL;
+
+
+
+static void lockThreadArenas() {
+    while( atomicExchange( &threadArenasLock, 1 ) != 0 ) {
+        #ifdef _WIN32
+            SwitchToThread();
+        #else
+            sched_yield();
+        #endif
+        }
+    }
+
+
+
+static void unlockThreadArenas() {
+    atomicStore( &threadArenasLock, 0 );
+    }
+
+
+
+FrameArena *FrameArena::getThreadArena() {
+    FrameArena *a = threadArena;
+
+    if( a != NULL ) {
+        return a;
+        }
+
+    a = new FrameArena();
+
+    lockThreadArenas();
+
+    a->mNextThreadArena = allThreadArenas;
+    allThreadArenas = a;
+
+    unlockThreadArenas();
+
+    threadArena = a;
+
+    return a;
+    }
+
+
+
+void FrameArena::destroyThreadArenas() {
+    lockThreadArenas();
+
+    FrameArena *a = allThreadArenas;
+    allThreadArenas = NULL;
+
+    unlockThreadArenas();
+
+    while( a != NULL ) {
+        FrameArena *next = a->mNextThreadArena;
+        delete a;
+        a = next;
+        }
+
+    // other threads' pointers are dangling now, but they've promised
+    // not to use them
+    threadArena = NULL;
+    }
+
+
+
+char *frameSprintf( const char *inFormatString, ... ) {
+    va_list argList;
+    va_start( argList, inFormatString );
+
+    char *result =
+        FrameArena::getThreadArena()->vprintString( inFormatString, argList );
+
+    va_end( argList );
+
+    return result;
+    }
@@ -0,0 +1,163 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+#include "minorGems/common.h"
+
+
+
+#ifndef FRAME_ARENA_INCLUDED
+#define FRAME_ARENA_INCLUDED
+
+
+#include <stdarg.h>
+
+
+
+typedef struct FrameArenaBlock {
+        char *bytes;
+
+        // offsets into bytes
+        // allocations go from start (first aligned byte) up to size
+        int start;
+        int used;
+        int size;
+
+        struct FrameArenaBlock *next;
+    } FrameArenaBlock;
+
+
+
+/**
+ * Bump allocator for temporaries that only need to live until the end of
+ * the current frame.
+ *
+ * Allocation is a pointer bump, and nothing is freed individually:  reset
+ * forgets everything at once.  When a block fills up, another block is
+ * chained on.  After a frame that needed more than one block, reset
+ * replaces the chain with a single block big enough for that frame, so
+ * steady-state frames make no heap calls at all.
+ *
+ * Each thread can have its own arena through getThreadArena.  The game
+ * loop resets the main thread's arena after each frame is drawn.  Other
+ * threads that use theirs must reset it themselves.
+ *
+ * Usage:
+ *   FrameArena *arena = FrameArena::getThreadArena();
+ *   float *verts = arena->allocateArray<float>( numCoords );
+ *   char *label = frameSprintf( "%d FPS", fps );
+ *   // no delete for either
+ *
+ * Not thread-safe (each arena belongs to one thread).
+ *
+ * @author Jason Rohrer
+ */
+class FrameArena {
+
+    public:
+
+        /**
+         * @param inBlockSize size of first block, and smallest size of
+         *   overflow blocks.  Defaults to 64 KiB.
+         */
+        FrameArena( int inBlockSize = 65536 );
+
+        ~FrameArena();
+
+
+        /**
+         * Allocates memory that stays valid until the next reset.
+         *
+         * @param inNumBytes the number of bytes needed.
+         *
+         * @return 16-byte aligned memory.  Must NOT be destroyed by caller.
+         */
+        void *allocate( int inNumBytes );
+
+
+        // allocates an array of inNumElements, which are not constructed
+        // (for plain data only)
+        template <class Type>
+        Type *allocateArray( int inNumElements ) {
+            return (Type *)allocate( inNumElements * (int)sizeof( Type ) );
+            }
+
+
+        /**
+         * Like autoSprintf, but the string is in arena memory.
+         *
+         * @return the \0-terminated string.  Must NOT be destroyed by
+         *   caller.
+         */
+        char *printString( const char *inFormatString, ... );
+
+        // same as above, but takes a va_list directly
+        char *vprintString( const char *inFormatString, va_list inArgList );
+
+
+        /**
+         * Forgets all allocations, making their memory available again.
+         */
+        void reset();
+
+
+        // bytes handed out since last reset
+        int getBytesUsed();
+
+        // most bytes handed out between any two resets
+        int getPeakBytesUsed();
+
+
+        /**
+         * Gets the calling thread's arena, creating it on first call.
+         */
+        static FrameArena *getThreadArena();
+
+
+        /**
+         * Destroys all arenas made by getThreadArena.
+         *
+         * Only call when no other thread will use its arena again (at
+         * exit).
+         */
+        static void destroyThreadArenas();
+
+
+    protected:
+
+        int mBlockSize;
+
+        // block being allocated from, with the rest of the chain after it
+        FrameArenaBlock *mBlocks;
+
+        // in blocks other than mBlocks
+        int mBytesInFullBlocks;
+
+        int mPeakBytesUsed;
+
+        // chain of arenas from getThreadArena
+        FrameArena *mNextThreadArena;
+
+
+        static FrameArenaBlock *makeBlock( int inSize );
+
+    };
+
+
+
+/**
+ * Same as FrameArena::printString on the calling thread's arena, for
+ * per-frame strings (labels, HUD text) that would otherwise be
+ * autoSprintf'd and deleted every frame.
+ *
+ * @return the \0-terminated string, valid until the thread's arena is
+ *   reset.  Must NOT be destroyed by caller.
+ */
+char *frameSprintf( const char *inFormatString, ... );
+
+
+
+#endif
@@ -0,0 +1,517 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14	Jason Rohrer
+ * Created.  O(1) replacement for linear SimpleVector lookups.
+ */
+
+#include "minorGems/common.h"
+
+
+
+#ifndef HASH_MAP_INCLUDED
+#define HASH_MAP_INCLUDED
+
+
+#include <string.h>
+
+
+
+/**
+ * How HashMap hashes, compares, and stores keys of a given type.
+ *
+ * The default hashes the key's raw bytes and compares with ==, which works
+ * for numbers, pointers, and enums.  Structs with padding need their own
+ * specialization.
+ *
+ * copyKey is called once when a new key is inserted, and freeKey when it
+ * is removed, so a map can own its keys.  Lookups never copy.
+ */
+template <class KeyType>
+struct HashMapKeyTraits {
+
+        static unsigned int hash( KeyType inKey ) {
+            // FNV-1a
+            const unsigned char *bytes = (const unsigned char *)&inKey;
+
+            unsigned int h = 2166136261U;
+            for( unsigned int i=0; i<sizeof( KeyType ); i++ ) {
+                h ^= bytes[i];
+                h *= 16777619U;
+                }
+            return h;
+            }
+
+        static char equal( KeyType inA, KeyType inB ) {
+            return inA == inB;
+            }
+
+        static KeyType copyKey( KeyType inKey ) {
+            return inKey;
+            }
+
+        static void freeKey( KeyType ) {
+            }
+    };
+
+
+
+// integer keys (handles, IDs) are common enough to get a cheaper mix
+template <>
+inline unsigned int HashMapKeyTraits<int>::hash( int inKey ) {
+    unsigned int h = (unsigned int)inKey;
+
+    // from murmur3 finalizer
+    h ^= h >> 16;
+    h *= 0x85EBCA6BU;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35U;
+    h ^= h >> 16;
+    return h;
+    }
+
+
+
+/**
+ * C-string keys, compared by contents.
+ *
+ * The map keeps its own copy of each inserted key (destroyed when removed),
+ * so callers can pass stack or temporary strings.  Lookups use the
+ * caller's string directly, without duplicating it.
+ */
+struct HashMapStringKeyTraits {
+
+        static unsigned int hash( const char *inKey ) {
+            // FNV-1a
+            unsigned int h = 2166136261U;
+            for( const unsigned char *c = (const unsigned char *)inKey;
+                 *c != '\0'; c++ ) {
+                h ^= *c;
+                h *= 16777619U;
+                }
+            return h;
+            }
+
+        static char equal( const char *inA, const char *inB ) {
+            return strcmp( inA, inB ) == 0;
+            }
+
+        static const char *copyKey( const char *inKey ) {
+            char *copy = new char[ strlen( inKey ) + 1 ];
+            strcpy( copy, inKey );
+            return copy;
+            }
+
+        static void freeKey( const char *inKey ) {
+            delete [] inKey;
+            }
+    };
+
+
+template <>
+struct HashMapKeyTraits<const char*> : public HashMapStringKeyTraits {
+    };
+
+
+template <>
+struct HashMapKeyTraits<char*> {
+
+        static unsigned int hash( char *inKey ) {
+            return HashMapStringKeyTraits::hash( inKey );
+            }
+
+        static char equal( char *inA, char *inB ) {
+            return HashMapStringKeyTraits::equal( inA, inB );
+            }
+
+        static char *copyKey( char *inKey ) {
+            return (char *)HashMapStringKeyTraits::copyKey( inKey );
+            }
+
+        static void freeKey( char *inKey ) {
+            delete [] inKey;
+            }
+    };
+
+
+
+
+/**
+ * Hash map with open addressing (linear probing) in one contiguous
+ * slot array.
+ *
+ * Grows by doubling, keeping at most 3/4 of the slots filled.  Removal
+ * shifts later entries back instead of leaving tombstones, so lookups stay
+ * short even after lots of churn.
+ *
+ * Values are copied in and out like SimpleVector elements, and are not
+ * destroyed by the map (a map of pointers must have them destroyed by the
+ * caller).
+ *
+ * Keys and values need default constructors and assignment.
+ *
+ * Not thread-safe.
+ *
+ * For string keys, use HashMap<const char*, ValueType> (or char*).
+ *
+ * @author Jason Rohrer
+ */
+template <class KeyType, class ValueType>
+class HashMap {
+
+	public:
+
+		/**
+		 * Constructs an empty map.
+		 *
+		 * @param inSizeEstimate the number of entries expected.
+		 *   Defaults to 8.
+		 */
+		HashMap( int inSizeEstimate = 8 );
+
+		~HashMap();
+
+
+		/**
+		 * Adds an entry, or replaces the value if inKey is already
+		 * present.
+		 */
+		void insert( KeyType inKey, ValueType inValue );
+
+
+		/**
+		 * Looks up the value for a key.
+		 *
+		 * @return a pointer to the stored value, or NULL if not found.
+		 *   Valid only until the next insert or remove.
+		 *   Must NOT be destroyed by caller.
+		 */
+		ValueType *lookupPointer( KeyType inKey );
+
+
+		/**
+		 * Looks up the value for a key.
+		 *
+		 * @param outValue where value should be returned.
+		 *   Left alone if key not found.
+		 *
+		 * @return true if found.
+		 */
+		char lookup( KeyType inKey, ValueType *outValue );
+
+
+		char contains( KeyType inKey );
+
+
+		/**
+		 * Removes the entry for a key.
+		 *
+		 * @return true if an entry was removed.
+		 */
+		char remove( KeyType inKey );
+
+
+		int size();
+
+
+		// removes all entries, keeping allocated space
+		void deleteAll();
+
+
+
+		// For walking through all entries (in no particular order).
+		// Slots that are not filled must be skipped.
+		// Inserting or removing while walking changes slot positions.
+		int getNumSlots();
+
+		char isSlotFilled( int inSlot );
+
+		KeyType getSlotKey( int inSlot );
+
+		ValueType *getSlotValue( int inSlot );
+
+
+
+	protected:
+
+		typedef struct HashMapSlot {
+				KeyType key;
+				ValueType value;
+
+				// saved so growing and removal don't re-hash, and so
+				// mismatched keys are usually skipped without a compare
+				unsigned int hash;
+
+				char filled;
+			} HashMapSlot;
+
+
+		HashMapSlot *mSlots;
+
+		// always a power of 2
+		int mNumSlots;
+
+		int mNumFilled;
+
+
+		// slot holding inKey, or -1 if not found
+		int findSlot( KeyType inKey, unsigned int inHash );
+
+		void resize( int inNewNumSlots );
+
+
+	private:
+
+		// not copyable (would share owned keys)
+		HashMap( const HashMap &inCopy );
+		HashMap & operator = ( const HashMap &inOther );
+
+	};
+
+
+
+template <class KeyType, class ValueType>
+inline HashMap<KeyType, ValueType>::HashMap( int inSizeEstimate )
+		: mNumFilled( 0 ) {
+
+	mNumSlots = 8;
+
+	while( mNumSlots * 3 < inSizeEstimate * 4 ) {
+		mNumSlots *= 2;
+		}
+
+	mSlots = new HashMapSlot[ mNumSlots ];
+
+	for( int i=0; i<mNumSlots; i++ ) {
+		mSlots[i].filled = false;
+		}
+	}
+
+
+
+template <class KeyType, class ValueType>
+inline HashMap<KeyType, ValueType>::~HashMap() {
+	deleteAll();
+
+	delete [] mSlots;
+	}
+
+
+
+template <class KeyType, class ValueType>
+inline int HashMap<KeyType, ValueType>::findSlot( KeyType inKey,
+                                                  unsigned int inHash ) {
+	int mask = mNumSlots - 1;
+
+	int i = inHash & mask;
+
+	// never full, so this always hits an empty slot eventually
+	while( mSlots[i].filled ) {
+		if( mSlots[i].hash == inHash &&
+			HashMapKeyTraits<KeyType>::equal( mSlots[i].key, inKey ) ) {
+			return i;
+			}
+		i = ( i + 1 ) & mask;
+		}
+
+	return -1;
+	}
+
+
+
+template <class KeyType, class ValueType>
+inline void HashMap<KeyType, ValueType>::resize( int inNewNumSlots ) {
+	HashMapSlot *oldSlots = mSlots;
+	int oldNumSlots = mNumSlots;
+
+	mSlots = new HashMapSlot[ inNewNumSlots ];
+	mNumSlots = inNewNumSlots;
+
+	for( int i=0; i<mNumSlots; i++ ) {
+		mSlots[i].filled = false;
+		}
+
+	int mask = mNumSlots - 1;
+
+	for( int i=0; i<oldNumSlots; i++ ) {
+		if( oldSlots[i].filled ) {
+			int j = oldSlots[i].hash & mask;
+
+			while( mSlots[j].filled ) {
+				j = ( j + 1 ) & mask;
+				}
+
+			// keys move over as-is, still owned by map
+			mSlots[j] = oldSlots[i];
+			}
+		}
+
+	delete [] oldSlots;
+	}
+
+
+
+template <class KeyType, class ValueType>
+inline void HashMap<KeyType, ValueType>::insert( KeyType inKey,
+                                                 ValueType inValue ) {
+	unsigned int hash = HashMapKeyTraits<KeyType>::hash( inKey );
+
+	int i = findSlot( inKey, hash );
+
+	if( i != -1 ) {
+		mSlots[i].value = inValue;
+		return;
+		}
+
+	if( ( mNumFilled + 1 ) * 4 > mNumSlots * 3 ) {
+		resize( mNumSlots * 2 );
+		}
+
+	int mask = mNumSlots - 1;
+
+	i = hash & mask;
+	while( mSlots[i].filled ) {
+		i = ( i + 1 ) & mask;
+		}
+
+	mSlots[i].key = HashMapKeyTraits<KeyType>::copyKey( inKey );
+	mSlots[i].value = inValue;
+	mSlots[i].hash = hash;
+	mSlots[i].filled = true;
+
+	mNumFilled++;
+	}
+
+
+
+template <class KeyType, class ValueType>
+inline ValueType *HashMap<KeyType, ValueType>::lookupPointer(
+	KeyType inKey ) {
+
+	int i = findSlot( inKey, HashMapKeyTraits<KeyType>::hash( inKey ) );
+
+	if( i == -1 ) {
+		return NULL;
+		}
+	return &( mSlots[i].value );
+	}
+
+
+
+template <class KeyType, class ValueType>
+inline char HashMap<KeyType, ValueType>::lookup( KeyType inKey,
+                                                 ValueType *outValue ) {
+	ValueType *value = lookupPointer( inKey );
+
+	if( value == NULL ) {
+		return false;
+		}
+
+	*outValue = *value;
+	return true;
+	}
+
+
+
+template <class KeyType, class ValueType>
+inline char HashMap<KeyType, ValueType>::contains( KeyType inKey ) {
+	return lookupPointer( inKey ) != NULL;
+	}
+
+
+
+template <class KeyType, class ValueType>
+inline char HashMap<KeyType, ValueType>::remove( KeyType inKey ) {
+	int i = findSlot( inKey, HashMapKeyTraits<KeyType>::hash( inKey ) );
+
+	if( i == -1 ) {
+		return false;
+		}
+
+	HashMapKeyTraits<KeyType>::freeKey( mSlots[i].key );
+
+	mNumFilled--;
+
+	// shift back any following entries that would no longer be reachable
+	// across the hole
+	int mask = mNumSlots - 1;
+
+	int hole = i;
+	int j = i;
+
+	while( true ) {
+		j = ( j + 1 ) & mask;
+
+		if( ! mSlots[j].filled ) {
+			break;
+			}
+
+		int home = mSlots[j].hash & mask;
+
+		// probe distances, allowing for wrap-around
+		int distFromHome = ( j - home ) & mask;
+		int distFromHole = ( j - hole ) & mask;
+
+		if( distFromHome >= distFromHole ) {
+			// hole is on j's probe path, move j into it
+			mSlots[hole] = mSlots[j];
+			hole = j;
+			}
+		}
+
+	mSlots[hole].filled = false;
+
+	return true;
+	}
+
+
+
+template <class KeyType, class ValueType>
+inline int HashMap<KeyType, ValueType>::size() {
+	return mNumFilled;
+	}
+
+
+
+template <class KeyType, class ValueType>
+inline void HashMap<KeyType, ValueType>::deleteAll() {
+	for( int i=0; i<mNumSlots; i++ ) {
+		if( mSlots[i].filled ) {
+			HashMapKeyTraits<KeyType>::freeKey( mSlots[i].key );
+			mSlots[i].filled = false;
+			}
+		}
+	mNumFilled = 0;
+	}
+
+
+
+template <class KeyType, class ValueType>
+inline int HashMap<KeyType, ValueType>::getNumSlots() {
+	return mNumSlots;
+	}
+
+
+
+template <class KeyType, class ValueType>
+inline char HashMap<KeyType, ValueType>::isSlotFilled( int inSlot ) {
+	return mSlots[inSlot].filled;
+	}
+
+
+
+template <class KeyType, class ValueType>
+inline KeyType HashMap<KeyType, ValueType>::getSlotKey( int inSlot ) {
+	return mSlots[inSlot].key;
+	}
+
+
+
+template <class KeyType, class ValueType>
+inline ValueType *HashMap<KeyType, ValueType>::getSlotValue( int inSlot ) {
+	return &( mSlots[inSlot].value );
+	}
+
+
+
+#endif
@@ -0,0 +1,377 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+
+
+#ifndef INDEXED_MIN_PRIORITY_QUEUE_INCLUDED
+#define INDEXED_MIN_PRIORITY_QUEUE_INCLUDED
+
+
+
+#include "minorGems/util/SimpleVector.h"
+
+
+
+// Priority queue, like MinPriorityQueue, that also lets a queued element's
+// priority be changed, or the element be removed, through a handle
+// returned when it is inserted.
+//
+// So searches (like A*) can lower a node's priority in place instead of
+// pushing a duplicate and skipping stale entries as they come up.
+
+// Implemented with a D-ary heap (4 children per node by default, which
+// is shallower than a binary heap and keeps each node's children in one
+// or two cache lines), giving the following worst case running times for
+// a queue with n elements:
+
+// Insert:  O(log n)
+// Check min:  O(1)
+// Remove min:  O(D log n)
+// Decrease priority:  O(log n)
+// Change priority or remove by handle:  O(D log n)
+// Insert n elements at once (insertAll):  O(n)
+
+// Each heap entry holds its value, priority, and handle together, so
+// walking the heap touches one array.  Values are copied as the heap is
+// reordered, so Type should be small (an index or pointer).
+
+// Handles are small non-negative ints, reused after their element leaves
+// the queue.
+template <class Type, int D = 4>
+class IndexedMinPriorityQueue {
+    public:
+
+        int size() {
+            return mHeap.size();
+            }
+
+
+        // invalidates all handles
+        void clear() {
+            mHeap.deleteAll();
+            mPosition.deleteAll();
+            mFreeHandles.deleteAll();
+            }
+
+
+
+        // returns handle of inserted element, valid until element
+        // leaves queue
+        int insert( Type inValue, double inPriority ) {
+            int handle = getFreeHandle();
+
+            Entry e = { inPriority, handle, inValue };
+
+            // hole at bottom of heap
+            mHeap.push_back( e );
+            *( mPosition.getElementFast( handle ) ) = mHeap.size() - 1;
+
+            bubbleUp( mHeap.size() - 1 );
+
+            return handle;
+            }
+
+
+
+        // inserts many elements at once, building heap bottom-up in
+        // linear time
+        // outHandles, if not NULL, gets inNumElements handles, in
+        // the order of inValues
+        void insertAll( Type *inValues, double *inPriorities,
+                        int inNumElements, int *outHandles = NULL ) {
+
+            for( int i=0; i<inNumElements; i++ ) {
+                int handle = getFreeHandle();
+
+                Entry e = { inPriorities[i], handle, inValues[i] };
+
+                mHeap.push_back( e );
+                *( mPosition.getElementFast( handle ) ) = mHeap.size() - 1;
+
+                if( outHandles != NULL ) {
+                    outHandles[i] = handle;
+                    }
+                }
+
+            heapify();
+            }
+
+
+
+        double checkMinPriority() {
+            if( mHeap.size() > 0 ) {
+                return mHeap.getElementFast( 0 )->priority;
+                }
+            else {
+                return 0;
+                }
+            }
+
+
+
+        // outHandle, if not NULL, gets the handle the element had
+        Type removeMin( int *outHandle = NULL ) {
+            if( mHeap.size() == 0 ) {
+                if( outHandle != NULL ) {
+                    *outHandle = -1;
+                    }
+                Type t = Type();
+                return t;
+                }
+
+            Entry *root = mHeap.getElementFast( 0 );
+
+            Type returnValue = root->value;
+
+            if( outHandle != NULL ) {
+                *outHandle = root->handle;
+                }
+
+            removeAt( 0 );
+
+            return returnValue;
+            }
+
+
+
+        // true if handle belongs to an element in the queue
+        char isQueued( int inHandle ) {
+            return inHandle >= 0 && inHandle < mPosition.size() &&
+                mPosition.getElementDirectFast( inHandle ) != -1;
+            }
+
+
+        // handle must be queued
+        double getPriority( int inHandle ) {
+            return getEntry( inHandle )->priority;
+            }
+
+
+        // handle must be queued
+        Type getValue( int inHandle ) {
+            return getEntry( inHandle )->value;
+            }
+
+
+
+        // lowers priority of a queued element
+        // does nothing if inNewPriority is not lower
+        void decreasePriority( int inHandle, double inNewPriority ) {
+            Entry *e = getEntry( inHandle );
+
+            if( inNewPriority < e->priority ) {
+                e->priority = inNewPriority;
+                bubbleUp( mPosition.getElementDirectFast( inHandle ) );
+                }
+            }
+
+
+
+        // sets priority of a queued element, up or down
+        void changePriority( int inHandle, double inNewPriority ) {
+            Entry *e = getEntry( inHandle );
+
+            double oldPriority = e->priority;
+
+            e->priority = inNewPriority;
+
+            int index = mPosition.getElementDirectFast( inHandle );
+
+            if( inNewPriority < oldPriority ) {
+                bubbleUp( index );
+                }
+            else {
+                bubbleDown( index );
+                }
+            }
+
+
+
+        // removes a queued element
+        // returns false if handle not queued
+        char remove( int inHandle ) {
+            if( ! isQueued( inHandle ) ) {
+                return false;
+                }
+
+            removeAt( mPosition.getElementDirectFast( inHandle ) );
+            return true;
+            }
+
+
+
+    protected:
+
+        typedef struct Entry {
+                double priority;
+                int handle;
+                Type value;
+            } Entry;
+
+
+        SimpleVector<Entry> mHeap;
+
+        // heap index of each handle's entry, or -1 if handle free
+        SimpleVector<int> mPosition;
+
+        SimpleVector<int> mFreeHandles;
+
+
+
+        int getFreeHandle() {
+            int numFree = mFreeHandles.size();
+
+            if( numFree > 0 ) {
+                int handle = mFreeHandles.getElementDirectFast( numFree - 1 );
+                mFreeHandles.deleteElement( numFree - 1 );
+                return handle;
+                }
+
+            mPosition.push_back( -1 );
+            return mPosition.size() - 1;
+            }
+
+
+
+        Entry *getEntry( int inHandle ) {
+            return mHeap.getElementFast(
+                mPosition.getElementDirectFast( inHandle ) );
+            }
+
+
+
+        // puts e at heap index inIndex
+        void place( Entry inE, int inIndex ) {
+            *( mHeap.getElementFast( inIndex ) ) = inE;
+            *( mPosition.getElementFast( inE.handle ) ) = inIndex;
+            }
+
+
+
+        void removeAt( int inIndex ) {
+            int handle = mHeap.getElementFast( inIndex )->handle;
+
+            *( mPosition.getElementFast( handle ) ) = -1;
+            mFreeHandles.push_back( handle );
+
+            int lastIndex = mHeap.size() - 1;
+
+            if( inIndex != lastIndex ) {
+                // last element fills hole, then moves whichever way
+                // it needs to
+                Entry last = mHeap.getElementDirectFast( lastIndex );
+                double removedPriority =
+                    mHeap.getElementFast( inIndex )->priority;
+
+                place( last, inIndex );
+
+                mHeap.deleteElement( lastIndex );
+
+                if( last.priority < removedPriority ) {
+                    bubbleUp( inIndex );
+                    }
+                else {
+                    bubbleDown( inIndex );
+                    }
+                }
+            else {
+                mHeap.deleteElement( lastIndex );
+                }
+            }
+
+
+
+        // moves entry at inIndex up to where it belongs
+        // moves a hole up, instead of swapping at each level
+        void bubbleUp( int inIndex ) {
+            Entry e = mHeap.getElementDirectFast( inIndex );
+
+            while( inIndex > 0 ) {
+                int parent = ( inIndex - 1 ) / D;
+
+                Entry *parentE = mHeap.getElementFast( parent );
+
+                if( ! ( e.priority < parentE->priority ) ) {
+                    break;
+                    }
+
+                // parent moves down into hole
+                place( *parentE, inIndex );
+
+                inIndex = parent;
+                }
+
+            place( e, inIndex );
+            }
+
+
+
+        // moves entry at inIndex down to where it belongs
+        void bubbleDown( int inIndex ) {
+            int num = mHeap.size();
+
+            Entry e = mHeap.getElementDirectFast( inIndex );
+
+            while( true ) {
+                int firstChild = D * inIndex + 1;
+
+                if( firstChild >= num ) {
+                    break;
+                    }
+
+                int endChild = firstChild + D;
+                if( endChild > num ) {
+                    endChild = num;
+                    }
+
+                int smallestChild = firstChild;
+                double smallestChildP =
+                    mHeap.getElementFast( firstChild )->priority;
+
+                for( int c=firstChild + 1; c<endChild; c++ ) {
+                    double p = mHeap.getElementFast( c )->priority;
+
+                    if( p < smallestChildP ) {
+                        smallestChild = c;
+                        smallestChildP = p;
+                        }
+                    }
+
+                if( ! ( smallestChildP < e.priority ) ) {
+                    break;
+                    }
+
+                // child moves up into hole
+                place( mHeap.getElementDirectFast( smallestChild ),
+                       inIndex );
+
+                inIndex = smallestChild;
+                }
+
+            place( e, inIndex );
+            }
+
+
+
+        // restores heap order over whole heap, bottom-up
+        void heapify() {
+            int num = mHeap.size();
+
+            if( num < 2 ) {
+                return;
+                }
+
+            for( int i = ( num - 2 ) / D; i >= 0; i-- ) {
+                bubbleDown( i );
+                }
+            }
+
+    };
+
+
+
+#endif
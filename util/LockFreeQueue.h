@@ -0,0 +1,235 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15	Jason Rohrer
+ * Created.  Multi-producer, multi-consumer cousin of LockFreeRingBuffer.
+ */
+
+#include "minorGems/common.h"
+
+
+
+#ifndef LOCK_FREE_QUEUE_INCLUDED
+#define LOCK_FREE_QUEUE_INCLUDED
+
+
+#include "minorGems/system/atomicOps.h"
+
+
+
+/**
+ * Bounded queue with no locks that any number of threads may push to
+ * and pop from at once.
+ *
+ * Neither call ever blocks or allocates:  push fails when the queue is
+ * full, and pop fails when it is empty.  Elements are copied by value.
+ *
+ * For exactly one producer and one consumer, LockFreeRingBuffer is
+ * cheaper.
+ *
+ * Based on Dmitry Vyukov's bounded MPMC queue:  each slot carries a
+ * sequence number that says whether it is ready to be written or read
+ * for a given position, so producers (and consumers) only contend on
+ * claiming a position, and a claimed slot is filled without further
+ * synchronization.
+ *
+ * @author Jason Rohrer
+ */
+template <class Type>
+class LockFreeQueue {
+
+	public:
+
+		/**
+		 * Constructs a queue.
+		 *
+		 * @param inSize the maximum number of elements that can be
+		 *   waiting in the queue at once.  Rounded up to a power of 2.
+		 */
+		LockFreeQueue( int inSize );
+
+		~LockFreeQueue();
+
+
+		/**
+		 * Adds an element.  Any thread.
+		 *
+		 * @return true on success, or false if queue is full.
+		 */
+		char push( Type inElement );
+
+
+		/**
+		 * Removes the oldest element.  Any thread.
+		 *
+		 * @param outElement pointer to where element should be returned.
+		 *
+		 * @return true on success, or false if queue is empty.
+		 */
+		char pop( Type *outElement );
+
+
+		// size after rounding
+		int getCapacity();
+
+
+	private:
+
+		typedef struct Slot {
+				// position this slot is ready to be written for, or
+				// position + 1 once written and ready to be read
+				volatile int sequence;
+
+				Type element;
+			} Slot;
+
+		int mMask;
+
+		Slot *mSlots;
+
+		char mPadA[ ATOMIC_CACHE_LINE_SIZE ];
+
+		// next position to write, claimed by producers
+		volatile int mPushPosition;
+
+		char mPadB[ ATOMIC_CACHE_LINE_SIZE ];
+
+		// next position to read, claimed by consumers
+		volatile int mPopPosition;
+
+		char mPadC[ ATOMIC_CACHE_LINE_SIZE ];
+
+
+		// positions count up forever and wrap around, so they are
+		// compared by signed difference of wrapped (unsigned) values
+		static int positionDifference( int inA, int inB ) {
+			return (int)( (unsigned int)inA - (unsigned int)inB );
+			}
+
+		static int positionPlus( int inPosition, int inAmount ) {
+			return (int)( (unsigned int)inPosition +
+						  (unsigned int)inAmount );
+			}
+	};
+
+
+
+template <class Type>
+inline LockFreeQueue<Type>::LockFreeQueue( int inSize )
+		: mPushPosition( 0 ), mPopPosition( 0 ) {
+
+	int numSlots = 2;
+	while( numSlots < inSize ) {
+		numSlots *= 2;
+		}
+
+	mMask = numSlots - 1;
+
+	mSlots = new Slot[ numSlots ];
+
+	for( int i=0; i<numSlots; i++ ) {
+		mSlots[i].sequence = i;
+		}
+	}
+
+
+
+template <class Type>
+inline LockFreeQueue<Type>::~LockFreeQueue() {
+	delete [] mSlots;
+	}
+
+
+
+template <class Type>
+inline int LockFreeQueue<Type>::getCapacity() {
+	return mMask + 1;
+	}
+
+
+
+template <class Type>
+inline char LockFreeQueue<Type>::push( Type inElement ) {
+	int position = atomicLoad( &mPushPosition );
+
+	Slot *slot;
+
+	while( true ) {
+		slot = &( mSlots[ position & mMask ] );
+
+		int difference =
+			positionDifference( atomicLoad( &( slot->sequence ) ),
+								position );
+
+		if( difference == 0 ) {
+			// slot free for this position, try to claim it
+			if( atomicCompareExchange( &mPushPosition, position,
+									   positionPlus( position, 1 ) ) ) {
+				break;
+				}
+			// another producer got it
+			position = atomicLoad( &mPushPosition );
+			}
+		else if( difference < 0 ) {
+			// slot still holds element from one lap ago, not yet popped
+			return false;
+			}
+		else {
+			// another producer claimed it and moved on
+			position = atomicLoad( &mPushPosition );
+			}
+		}
+
+	slot->element = inElement;
+
+	// release:  element is visible before slot is marked readable
+	atomicStore( &( slot->sequence ), positionPlus( position, 1 ) );
+
+	return true;
+	}
+
+
+
+template <class Type>
+inline char LockFreeQueue<Type>::pop( Type *outElement ) {
+	int position = atomicLoad( &mPopPosition );
+
+	Slot *slot;
+
+	while( true ) {
+		slot = &( mSlots[ position & mMask ] );
+
+		int difference =
+			positionDifference( atomicLoad( &( slot->sequence ) ),
+								positionPlus( position, 1 ) );
+
+		if( difference == 0 ) {
+			// slot written for this position, try to claim it
+			if( atomicCompareExchange( &mPopPosition, position,
+									   positionPlus( position, 1 ) ) ) {
+				break;
+				}
+			position = atomicLoad( &mPopPosition );
+			}
+		else if( difference < 0 ) {
+			// not written yet
+			return false;
+			}
+		else {
+			// another consumer claimed it and moved on
+			position = atomicLoad( &mPopPosition );
+			}
+		}
+
+	*outElement = slot->element;
+
+	// release:  slot free for producers of next lap only after we've
+	// copied element out
+	atomicStore( &( slot->sequence ), positionPlus( position, mMask + 1 ) );
+
+	return true;
+	}
+
+
+
+#endif
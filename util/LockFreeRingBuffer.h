@@ -0,0 +1,307 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14	Jason Rohrer
+ * Created.  Lock-free cousin of CircularBuffer.
+ *
+ * 2026-October-15	Jason Rohrer
+ * Producer and consumer indices padded onto separate cache lines, and
+ * each side keeps a copy of the other's index, re-read only when the
+ * buffer looks full (or empty).
+ *
+ * 2026-October-15	Jason Rohrer
+ * pushMany and popMany, for moving blocks of samples with one index
+ * update.
+ */
+
+#include "minorGems/common.h"
+
+
+
+#ifndef LOCK_FREE_RING_BUFFER_INCLUDED
+#define LOCK_FREE_RING_BUFFER_INCLUDED
+
+
+#include "minorGems/system/atomicOps.h"
+
+
+
+/**
+ * Single-producer, single-consumer ring buffer with no locks.
+ *
+ * Exactly one thread may call push, and exactly one (other) thread may
+ * call pop.  Neither call ever blocks or allocates, which makes this
+ * suitable for feeding real-time threads (like an audio callback).
+ *
+ * Unlike CircularBuffer, elements are copied by value, and push/pop
+ * fail instead of waiting when the buffer is full/empty.
+ *
+ * For several producers or consumers, use LockFreeQueue.
+ *
+ * @author Jason Rohrer
+ */
+template <class Type>
+class LockFreeRingBuffer {
+
+	public:
+
+		/**
+		 * Constructs a buffer.
+		 *
+		 * @param inSize the maximum number of elements that can be
+		 *   waiting in the buffer at once.
+		 */
+		LockFreeRingBuffer( int inSize );
+
+		~LockFreeRingBuffer();
+
+
+		/**
+		 * Adds an element.  Producer thread only.
+		 *
+		 * @return true on success, or false if buffer is full.
+		 */
+		char push( Type inElement );
+
+
+		/**
+		 * Removes the oldest element.  Consumer thread only.
+		 *
+		 * @param outElement pointer to where element should be returned.
+		 *
+		 * @return true on success, or false if buffer is empty.
+		 */
+		char pop( Type *outElement );
+
+
+		/**
+		 * Adds as many elements from an array as fit.  Producer thread
+		 * only.
+		 *
+		 * @param inElements the elements to add, in order.
+		 *   Must be destroyed by caller.
+		 * @param inNumElements the number of elements.
+		 *
+		 * @return the number added, from the start of inElements.
+		 */
+		int pushMany( const Type *inElements, int inNumElements );
+
+
+		/**
+		 * Removes up to inMaxElements of the oldest elements.  Consumer
+		 * thread only.
+		 *
+		 * @param outElements array where elements should be returned.
+		 *   Must be destroyed by caller.
+		 * @param inMaxElements the size of outElements.
+		 *
+		 * @return the number removed, which is 0 if buffer is empty.
+		 */
+		int popMany( Type *outElements, int inMaxElements );
+
+
+		// approximate when called while other thread is running
+		char isEmpty();
+
+
+	private:
+
+		// one slot is always left empty to tell full from empty
+		int mNumSlots;
+
+		Type *mElements;
+
+		char mPadA[ ATOMIC_CACHE_LINE_SIZE ];
+
+		// producer's line
+
+		// written only by producer
+		volatile int mWriteIndex;
+
+		// producer's last look at mReadIndex, which can only have moved
+		// forward since (freeing more room)
+		int mCachedReadIndex;
+
+		char mPadB[ ATOMIC_CACHE_LINE_SIZE ];
+
+		// consumer's line
+
+		// written only by consumer
+		volatile int mReadIndex;
+
+		// consumer's last look at mWriteIndex
+		int mCachedWriteIndex;
+
+		char mPadC[ ATOMIC_CACHE_LINE_SIZE ];
+	};
+
+
+
+template <class Type>
+inline LockFreeRingBuffer<Type>::LockFreeRingBuffer( int inSize )
+		: mNumSlots( inSize + 1 ), mElements( new Type[ inSize + 1 ] ),
+		  mWriteIndex( 0 ), mCachedReadIndex( 0 ),
+		  mReadIndex( 0 ), mCachedWriteIndex( 0 ) {
+	}
+
+
+
+template <class Type>
+inline LockFreeRingBuffer<Type>::~LockFreeRingBuffer() {
+	delete [] mElements;
+	}
+
+
+
+template <class Type>
+inline char LockFreeRingBuffer<Type>::push( Type inElement ) {
+	// we own the write index, so a plain read is fine
+	int writeIndex = mWriteIndex;
+
+	int nextWriteIndex = writeIndex + 1;
+	if( nextWriteIndex == mNumSlots ) {
+		nextWriteIndex = 0;
+		}
+
+	if( nextWriteIndex == mCachedReadIndex ) {
+		// looks full, see if consumer has moved on
+		mCachedReadIndex = atomicLoad( &mReadIndex );
+
+		if( nextWriteIndex == mCachedReadIndex ) {
+			// full
+			return false;
+			}
+		}
+
+	mElements[ writeIndex ] = inElement;
+
+	// release:  element is visible before new index
+	atomicStore( &mWriteIndex, nextWriteIndex );
+
+	return true;
+	}
+
+
+
+template <class Type>
+inline char LockFreeRingBuffer<Type>::pop( Type *outElement ) {
+	int readIndex = mReadIndex;
+
+	if( readIndex == mCachedWriteIndex ) {
+		// looks empty, see if producer has added more
+		mCachedWriteIndex = atomicLoad( &mWriteIndex );
+
+		if( readIndex == mCachedWriteIndex ) {
+			// empty
+			return false;
+			}
+		}
+
+	*outElement = mElements[ readIndex ];
+
+	int nextReadIndex = readIndex + 1;
+	if( nextReadIndex == mNumSlots ) {
+		nextReadIndex = 0;
+		}
+
+	// release:  slot is free for producer only after we've copied it out
+	atomicStore( &mReadIndex, nextReadIndex );
+
+	return true;
+	}
+
+
+
+template <class Type>
+inline int LockFreeRingBuffer<Type>::pushMany( const Type *inElements,
+											   int inNumElements ) {
+	int writeIndex = mWriteIndex;
+
+	// slots free, leaving the one that's always empty
+	int numFree = mCachedReadIndex - writeIndex - 1;
+	if( numFree < 0 ) {
+		numFree += mNumSlots;
+		}
+
+	if( numFree < inNumElements ) {
+		mCachedReadIndex = atomicLoad( &mReadIndex );
+
+		numFree = mCachedReadIndex - writeIndex - 1;
+		if( numFree < 0 ) {
+			numFree += mNumSlots;
+			}
+		}
+
+	int numToPush = inNumElements;
+	if( numToPush > numFree ) {
+		numToPush = numFree;
+		}
+
+	for( int i=0; i<numToPush; i++ ) {
+		mElements[ writeIndex ] = inElements[i];
+
+		writeIndex++;
+		if( writeIndex == mNumSlots ) {
+			writeIndex = 0;
+			}
+		}
+
+	if( numToPush > 0 ) {
+		atomicStore( &mWriteIndex, writeIndex );
+		}
+
+	return numToPush;
+	}
+
+
+
+template <class Type>
+inline int LockFreeRingBuffer<Type>::popMany( Type *outElements,
+											  int inMaxElements ) {
+	int readIndex = mReadIndex;
+
+	int numWaiting = mCachedWriteIndex - readIndex;
+	if( numWaiting < 0 ) {
+		numWaiting += mNumSlots;
+		}
+
+	if( numWaiting < inMaxElements ) {
+		mCachedWriteIndex = atomicLoad( &mWriteIndex );
+
+		numWaiting = mCachedWriteIndex - readIndex;
+		if( numWaiting < 0 ) {
+			numWaiting += mNumSlots;
+			}
+		}
+
+	int numToPop = inMaxElements;
+	if( numToPop > numWaiting ) {
+		numToPop = numWaiting;
+		}
+
+	for( int i=0; i<numToPop; i++ ) {
+		outElements[i] = mElements[ readIndex ];
+
+		readIndex++;
+		if( readIndex == mNumSlots ) {
+			readIndex = 0;
+			}
+		}
+
+	if( numToPop > 0 ) {
+		atomicStore( &mReadIndex, readIndex );
+		}
+
+	return numToPop;
+	}
+
+
+
+template <class Type>
+inline char LockFreeRingBuffer<Type>::isEmpty() {
+	return atomicLoad( &mReadIndex ) == atomicLoad( &mWriteIndex );
+	}
+
+
+
+#endif
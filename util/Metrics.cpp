@@ -0,0 +1,417 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+
+
+#include "Metrics.h"
+
+#include "minorGems/util/stringUtils.h"
+
+#include <float.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+
+MetricsHistogram::MetricsHistogram( const double *inUpperBounds,
+                                    int inNumBounds )
+        : mNumBounds( inNumBounds ),
+          mUpperBounds( new double[ inNumBounds ] ),
+          mBucketCounts( new int64_t[ inNumBounds + 1 ] ),
+          mCount( 0 ) {
+
+    memcpy( mUpperBounds, inUpperBounds, inNumBounds * sizeof( double ) );
+
+    for( int i=0; i<=inNumBounds; i++ ) {
+        mBucketCounts[i] = 0;
+        }
+
+    double zero = 0;
+    int64_t zeroBits;
+    memcpy( &zeroBits, &zero, 8 );
+    mSumBits = zeroBits;
+    }
+
+
+
+MetricsHistogram::~MetricsHistogram() {
+    delete [] mUpperBounds;
+    delete [] (int64_t *)mBucketCounts;
+    }
+
+
+
+void MetricsHistogram::observe( double inValue ) {
+    // few buckets, so a linear search beats a binary one
+    int b = 0;
+    while( b < mNumBounds && inValue > mUpperBounds[b] ) {
+        b++;
+        }
+
+    atomicFetchAdd64( &( mBucketCounts[b] ), 1 );
+    atomicFetchAdd64( &mCount, 1 );
+
+
+    int64_t oldBits = atomicLoad64( &mSumBits );
+
+    while( true ) {
+        double sum;
+        memcpy( &sum, &oldBits, 8 );
+        sum += inValue;
+
+        int64_t newBits;
+        memcpy( &newBits, &sum, 8 );
+
+        if( atomicCompareExchange64( &mSumBits, oldBits, newBits ) ) {
+            break;
+            }
+        oldBits = atomicLoad64( &mSumBits );
+        }
+    }
+
+
+
+double MetricsHistogram::getSum() {
+    int64_t bits = atomicLoad64( &mSumBits );
+
+    double sum;
+    memcpy( &sum, &bits, 8 );
+    return sum;
+    }
+
+
+
+MetricsRegistry::MetricsRegistry()
+        : mLock( "MetricsRegistry" ) {
+    }
+
+
+
+MetricsRegistry::~MetricsRegistry() {
+    for( int i=0; i<mEntries.size(); i++ ) {
+        MetricsEntry *e = mEntries.getElement( i );
+
+        delete [] e->name;
+        delete [] e->help;
+
+        if( e->counter != NULL ) {
+            delete e->counter;
+            }
+        if( e->gauge != NULL ) {
+            delete e->gauge;
+            }
+        if( e->histogram != NULL ) {
+            delete e->histogram;
+            }
+        }
+    }
+
+
+
+MetricsRegistry *MetricsRegistry::getGlobal() {
+    // made on first use, so metrics can be registered from static
+    // initializers in any order
+    static MetricsRegistry *global = new MetricsRegistry();
+
+    return global;
+    }
+
+
+
+MetricsEntry *MetricsRegistry::findEntry( const char *inName ) {
+    for( int i=0; i<mEntries.size(); i++ ) {
+        MetricsEntry *e = mEntries.getElement( i );
+
+        if( strcmp( e->name, inName ) == 0 ) {
+            return e;
+            }
+        }
+    return NULL;
+    }
+
+
+
+MetricsEntry *MetricsRegistry::addEntry( const char *inName,
+                                         const char *inHelp,
+                                         MetricsType inType ) {
+    MetricsEntry e;
+    e.name = stringDuplicate( inName );
+    e.help = stringDuplicate( inHelp );
+    e.type = inType;
+    e.counter = NULL;
+    e.gauge = NULL;
+    e.histogram = NULL;
+    e.function = NULL;
+    e.functionData = NULL;
+
+    mEntries.push_back( e );
+
+    return mEntries.getElement( mEntries.size() - 1 );
+    }
+
+
+
+static const char *getTypeName( MetricsType inType ) {
+    switch( inType ) {
+        case metricsCounter:
+            return "counter";
+        case metricsHistogram:
+            return "histogram";
+        default:
+            return "gauge";
+        }
+    }
+
+
+
+MetricsEntry *MetricsRegistry::getEntry( const char *inName,
+                                         const char *inHelp,
+                                         MetricsType inType ) {
+    MetricsEntry *e = findEntry( inName );
+
+    if( e == NULL ) {
+        return addEntry( inName, inHelp, inType );
+        }
+
+    if( e->type != inType ) {
+        printf( "Metric %s already registered as a %s\n",
+                inName, getTypeName( e->type ) );
+        return NULL;
+        }
+
+    return e;
+    }
+
+
+
+MetricsCounter *MetricsRegistry::getCounter( const char *inName,
+                                             const char *inHelp ) {
+    mLock.lock();
+
+    MetricsCounter *counter = NULL;
+
+    MetricsEntry *e = getEntry( inName, inHelp, metricsCounter );
+
+    if( e != NULL ) {
+        if( e->counter == NULL ) {
+            e->counter = new MetricsCounter();
+            }
+        counter = e->counter;
+        }
+
+    mLock.unlock();
+
+    return counter;
+    }
+
+
+
+MetricsGauge *MetricsRegistry::getGauge( const char *inName,
+                                         const char *inHelp ) {
+    mLock.lock();
+
+    MetricsGauge *gauge = NULL;
+
+    MetricsEntry *e = getEntry( inName, inHelp, metricsGauge );
+
+    if( e != NULL ) {
+        if( e->gauge == NULL ) {
+            e->gauge = new MetricsGauge();
+            }
+        gauge = e->gauge;
+        }
+
+    mLock.unlock();
+
+    return gauge;
+    }
+
+
+
+MetricsHistogram *MetricsRegistry::getHistogram( const char *inName,
+                                                 const char *inHelp,
+                                                 const double *inUpperBounds,
+                                                 int inNumBounds ) {
+    mLock.lock();
+
+    MetricsHistogram *histogram = NULL;
+
+    MetricsEntry *e = getEntry( inName, inHelp, metricsHistogram );
+
+    if( e != NULL ) {
+        if( e->histogram == NULL ) {
+            e->histogram = new MetricsHistogram( inUpperBounds,
+                                                 inNumBounds );
+            }
+        histogram = e->histogram;
+        }
+
+    mLock.unlock();
+
+    return histogram;
+    }
+
+
+
+char MetricsRegistry::addGaugeFunction( const char *inName,
+                                        const char *inHelp,
+                                        MetricsGaugeFunction inFunction,
+                                        void *inData ) {
+    mLock.lock();
+
+    MetricsEntry *e = getEntry( inName, inHelp, metricsGaugeFunction );
+
+    if( e != NULL ) {
+        e->function = inFunction;
+        e->functionData = inData;
+        }
+
+    mLock.unlock();
+
+    return ( e != NULL );
+    }
+
+
+
+void MetricsRegistry::removeGaugeFunction( const char *inName ) {
+    mLock.lock();
+
+    for( int i=0; i<mEntries.size(); i++ ) {
+        MetricsEntry *e = mEntries.getElement( i );
+
+        if( e->type == metricsGaugeFunction &&
+            strcmp( e->name, inName ) == 0 ) {
+
+            delete [] e->name;
+            delete [] e->help;
+            mEntries.deleteElement( i );
+            break;
+            }
+        }
+
+    mLock.unlock();
+    }
+
+
+
+// shortest of %.15g and %.17g that reads back as the same double, and
+// Prometheus spellings of infinities and NaN
+static void appendNumber( SimpleVector<char> *inText, double inValue ) {
+    char buffer[ 64 ];
+
+    if( inValue != inValue ) {
+        strcpy( buffer, "NaN" );
+        }
+    else if( inValue > DBL_MAX ) {
+        strcpy( buffer, "+Inf" );
+        }
+    else if( inValue < -DBL_MAX ) {
+        strcpy( buffer, "-Inf" );
+        }
+    else {
+        // bounds like 0.005 stay readable
+        snprintf( buffer, sizeof( buffer ), "%.15g", inValue );
+
+        if( strtod( buffer, NULL ) != inValue ) {
+            snprintf( buffer, sizeof( buffer ), "%.17g", inValue );
+            }
+        }
+
+    inText->appendElementString( buffer );
+    }
+
+
+
+static void appendInt( SimpleVector<char> *inText, int64_t inValue ) {
+    char buffer[ 32 ];
+    snprintf( buffer, sizeof( buffer ), "%lld", (long long)inValue );
+
+    inText->appendElementString( buffer );
+    }
+
+
+
+char *MetricsRegistry::getText() {
+    SimpleVector<char> text;
+
+    mLock.lock();
+
+    for( int i=0; i<mEntries.size(); i++ ) {
+        MetricsEntry *e = mEntries.getElement( i );
+
+        text.appendElementString( "# HELP " );
+        text.appendElementString( e->name );
+        text.push_back( ' ' );
+        text.appendElementString( e->help );
+        text.appendElementString( "\n# TYPE " );
+        text.appendElementString( e->name );
+        text.push_back( ' ' );
+        text.appendElementString( getTypeName( e->type ) );
+        text.push_back( '\n' );
+
+        switch( e->type ) {
+            case metricsCounter:
+                text.appendElementString( e->name );
+                text.push_back( ' ' );
+                appendInt( &text, e->counter->get() );
+                text.push_back( '\n' );
+                break;
+            case metricsGauge:
+                text.appendElementString( e->name );
+                text.push_back( ' ' );
+                appendInt( &text, e->gauge->get() );
+                text.push_back( '\n' );
+                break;
+            case metricsGaugeFunction:
+                text.appendElementString( e->name );
+                text.push_back( ' ' );
+                appendNumber( &text, e->function( e->functionData ) );
+                text.push_back( '\n' );
+                break;
+            case metricsHistogram: {
+                MetricsHistogram *h = e->histogram;
+
+                // buckets are cumulative in the text format
+                int64_t cumulative = 0;
+
+                for( int b=0; b<=h->getNumBounds(); b++ ) {
+                    cumulative += h->getBucketCount( b );
+
+                    text.appendElementString( e->name );
+                    text.appendElementString( "_bucket{le=\"" );
+                    if( b < h->getNumBounds() ) {
+                        appendNumber( &text, h->getUpperBound( b ) );
+                        }
+                    else {
+                        text.appendElementString( "+Inf" );
+                        }
+                    text.appendElementString( "\"} " );
+                    appendInt( &text, cumulative );
+                    text.push_back( '\n' );
+                    }
+
+                text.appendElementString( e->name );
+                text.appendElementString( "_sum " );
+                appendNumber( &text, h->getSum() );
+                text.push_back( '\n' );
+
+                // +Inf bucket and count must agree, even if observations
+                // landed while we were reading
+                text.appendElementString( e->name );
+                text.appendElementString( "_count " );
+                appendInt( &text, cumulative );
+                text.push_back( '\n' );
+                break;
+                }
+            }
+        }
+
+    mLock.unlock();
+
+    return text.getElementString();
+    }
@@ -0,0 +1,302 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+#include "minorGems/common.h"
+
+
+
+#ifndef METRICS_INCLUDED
+#define METRICS_INCLUDED
+
+
+#include "minorGems/system/MutexLock.h"
+#include "minorGems/system/atomicOps.h"
+#include "minorGems/util/SimpleVector.h"
+
+
+
+/**
+ * Count that only goes up (requests served, bytes sent).
+ *
+ * Updates are single atomic adds, safe from any thread.
+ */
+class MetricsCounter {
+
+    public:
+
+        MetricsCounter()
+                : mValue( 0 ) {
+            }
+
+
+        void increment( int64_t inAmount = 1 ) {
+            atomicFetchAdd64( &mValue, inAmount );
+            }
+
+
+        int64_t get() {
+            return atomicLoad64( &mValue );
+            }
+
+
+    protected:
+
+        volatile int64_t mValue;
+
+    };
+
+
+
+/**
+ * Value that goes up and down (requests in flight, queue depth).
+ *
+ * Updates are single atomic operations, safe from any thread.
+ */
+class MetricsGauge {
+
+    public:
+
+        MetricsGauge()
+                : mValue( 0 ) {
+            }
+
+
+        void set( int64_t inValue ) {
+            atomicStore64( &mValue, inValue );
+            }
+
+
+        void add( int64_t inAmount ) {
+            atomicFetchAdd64( &mValue, inAmount );
+            }
+
+
+        int64_t get() {
+            return atomicLoad64( &mValue );
+            }
+
+
+    protected:
+
+        volatile int64_t mValue;
+
+    };
+
+
+
+/**
+ * Distribution of observed values (request times, frame times) in fixed
+ * buckets.
+ *
+ * Observing is lock-free:  one atomic add for the bucket, one for the
+ * count, and a compare-exchange loop for the sum.  A reader racing with
+ * observers may see a count, sum and buckets that are off by the
+ * observations in progress.
+ */
+class MetricsHistogram {
+
+    public:
+
+        /**
+         * @param inUpperBounds upper bound of each bucket, increasing.
+         *   Destroyed by caller.  Values above the last bound are only
+         *   counted in the implicit +Inf bucket.
+         * @param inNumBounds the number of bounds.
+         */
+        MetricsHistogram( const double *inUpperBounds, int inNumBounds );
+
+        ~MetricsHistogram();
+
+
+        void observe( double inValue );
+
+
+        int getNumBounds() {
+            return mNumBounds;
+            }
+
+        double getUpperBound( int inIndex ) {
+            return mUpperBounds[ inIndex ];
+            }
+
+        // not cumulative
+        // inIndex of getNumBounds() is the bucket above the last bound
+        int64_t getBucketCount( int inIndex ) {
+            return atomicLoad64( &( mBucketCounts[ inIndex ] ) );
+            }
+
+        int64_t getCount() {
+            return atomicLoad64( &mCount );
+            }
+
+        double getSum();
+
+
+    protected:
+
+        int mNumBounds;
+        double *mUpperBounds;
+
+        // mNumBounds + 1 buckets
+        volatile int64_t *mBucketCounts;
+
+        volatile int64_t mCount;
+
+        // bits of a double
+        volatile int64_t mSumBits;
+
+    };
+
+
+
+// computes a gauge's value when metrics are read
+typedef double (*MetricsGaugeFunction)( void *inData );
+
+
+
+enum MetricsType {
+    metricsCounter,
+    metricsGauge,
+    metricsGaugeFunction,
+    metricsHistogram
+    };
+
+
+
+typedef struct MetricsEntry {
+        char *name;
+        char *help;
+        MetricsType type;
+
+        // one of these, depending on type
+        MetricsCounter *counter;
+        MetricsGauge *gauge;
+        MetricsHistogram *histogram;
+        MetricsGaugeFunction function;
+        void *functionData;
+    } MetricsEntry;
+
+
+
+/**
+ * Named counters, gauges and histograms that subsystems register into,
+ * printed together in the Prometheus text exposition format.
+ *
+ * Registration and printing take a lock.  Updates don't:  callers keep
+ * the returned pointer (in a static, or a member) and update through it.
+ *
+ * Usage:
+ *   static MetricsCounter *sent =
+ *       MetricsRegistry::getGlobal()->getCounter(
+ *           "mygame_messages_sent_total", "Messages sent to clients." );
+ *   sent->increment();
+ *
+ * Names must be valid Prometheus names ([a-zA-Z_:][a-zA-Z0-9_:]*).
+ *
+ * @author Jason Rohrer
+ */
+class MetricsRegistry {
+
+    public:
+
+        MetricsRegistry();
+
+        ~MetricsRegistry();
+
+
+        /**
+         * Registry shared by the whole program, served by
+         * MetricsPageGenerator by default.
+         *
+         * Never destroyed.
+         */
+        static MetricsRegistry *getGlobal();
+
+
+        /**
+         * Gets a metric, creating it the first time its name is used.
+         *
+         * Getting an existing name as a different type is a programming
+         * error:  it is printed, and NULL is returned.
+         *
+         * @param inName the name.  Destroyed by caller.
+         * @param inHelp one-line description.  Destroyed by caller.
+         *
+         * @return the metric.  Destroyed by this registry.
+         */
+        MetricsCounter *getCounter( const char *inName, const char *inHelp );
+
+        MetricsGauge *getGauge( const char *inName, const char *inHelp );
+
+        /**
+         * @param inUpperBounds bucket bounds, ignored if histogram exists
+         *   already.  Destroyed by caller.
+         */
+        MetricsHistogram *getHistogram( const char *inName,
+                                        const char *inHelp,
+                                        const double *inUpperBounds,
+                                        int inNumBounds );
+
+
+        /**
+         * Adds a gauge whose value is computed whenever metrics are read,
+         * for values that a subsystem already keeps (a queue's length,
+         * a count of loaded sprites).
+         *
+         * inFunction is called with the registry locked, from whichever
+         * thread reads the metrics, so it must be thread-safe.
+         *
+         * Replaces any function gauge with the same name.
+         *
+         * @return true on success, or false if inName is in use by
+         *   another type.
+         */
+        char addGaugeFunction( const char *inName, const char *inHelp,
+                               MetricsGaugeFunction inFunction,
+                               void *inData );
+
+        /**
+         * Removes a function gauge, for when its data is destroyed.
+         */
+        void removeGaugeFunction( const char *inName );
+
+
+        /**
+         * Gets all metrics in the Prometheus text format, in
+         * registration order.
+         *
+         * @return the text.  Destroyed by caller.
+         */
+        char *getText();
+
+
+    protected:
+
+        MutexLock mLock;
+
+        SimpleVector<MetricsEntry> mEntries;
+
+
+        // returns NULL if not found
+        // lock must be held
+        MetricsEntry *findEntry( const char *inName );
+
+        // lock must be held
+        MetricsEntry *addEntry( const char *inName, const char *inHelp,
+                                MetricsType inType );
+
+        // returns NULL and prints an error if entry exists with another
+        // type
+        // lock must be held
+        MetricsEntry *getEntry( const char *inName, const char *inHelp,
+                                MetricsType inType );
+
+    };
+
+
+
+#endif
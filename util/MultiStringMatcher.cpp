@@ -0,0 +1,383 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+
+
+#include "MultiStringMatcher.h"
+
+#include "minorGems/util/stringUtils.h"
+
+
+#include <string.h>
+
+
+
+MultiStringMatcher::MultiStringMatcher( char inIgnoreCase )
+        : mIgnoreCase( inIgnoreCase ), mCompiled( false ),
+          mNumColumns( 0 ), mNumStates( 0 ),
+          mNext( NULL ), mOutput( NULL ), mOutputLink( NULL ) {
+    }
+
+
+
+MultiStringMatcher::~MultiStringMatcher() {
+    freeTable();
+    mPatterns.deallocateStringElements();
+    }
+
+
+
+void MultiStringMatcher::freeTable() {
+    if( mNext != NULL ) {
+        delete [] mNext;
+        delete [] mOutput;
+        delete [] mOutputLink;
+
+        mNext = NULL;
+        mOutput = NULL;
+        mOutputLink = NULL;
+        }
+    mCompiled = false;
+    }
+
+
+
+int MultiStringMatcher::addPattern( const char *inPattern ) {
+    int length = strlen( inPattern );
+
+    if( length == 0 ) {
+        return -1;
+        }
+
+    mPatterns.push_back( stringDuplicate( inPattern ) );
+    mPatternLengths.push_back( length );
+
+    freeTable();
+
+    return mPatterns.size() - 1;
+    }
+
+
+
+void MultiStringMatcher::addWordList( const char *inWordList ) {
+    const char *lineStart = inWordList;
+
+    while( *lineStart != '\0' ) {
+        const char *lineEnd = lineStart;
+
+        while( *lineEnd != '\0' && *lineEnd != '\n' ) {
+            lineEnd++;
+            }
+
+        // trim
+        const char *start = lineStart;
+        const char *end = lineEnd;
+
+        while( start < end && isspace( (unsigned char)*start ) ) {
+            start++;
+            }
+        while( end > start && isspace( (unsigned char)end[-1] ) ) {
+            end--;
+            }
+
+        if( end > start ) {
+            int length = end - start;
+
+            char *pattern = new char[ length + 1 ];
+            memcpy( pattern, start, length );
+            pattern[ length ] = '\0';
+
+            addPattern( pattern );
+
+            delete [] pattern;
+            }
+
+        lineStart = lineEnd;
+        if( *lineStart == '\n' ) {
+            lineStart++;
+            }
+        }
+    }
+
+
+
+int MultiStringMatcher::getNumPatterns() {
+    return mPatterns.size();
+    }
+
+
+
+const char *MultiStringMatcher::getPattern( int inPatternIndex ) {
+    return mPatterns.getElementDirect( inPatternIndex );
+    }
+
+
+
+void MultiStringMatcher::compile() {
+    if( mCompiled ) {
+        return;
+        }
+
+    int numPatterns = mPatterns.size();
+
+
+    // a column for each distinct pattern character
+    // upper-case letters share lower-case columns when ignoring case,
+    // so text needs no folding when matched
+    memset( mColumn, 0, sizeof( mColumn ) );
+    mNumColumns = 1;
+
+    int maxStates = 1;
+
+    for( int p=0; p<numPatterns; p++ ) {
+        const unsigned char *pattern =
+            (const unsigned char *)mPatterns.getElementDirect( p );
+
+        int length = mPatternLengths.getElementDirect( p );
+        maxStates += length;
+
+        for( int i=0; i<length; i++ ) {
+            unsigned char c = pattern[i];
+
+            if( mIgnoreCase && c >= 'A' && c <= 'Z' ) {
+                c |= 0x20;
+                }
+            if( mColumn[c] == 0 ) {
+                mColumn[c] = mNumColumns;
+                mNumColumns++;
+                }
+            }
+        }
+
+    if( mIgnoreCase ) {
+        for( int c='A'; c<='Z'; c++ ) {
+            mColumn[c] = mColumn[ c | 0x20 ];
+            }
+        }
+
+
+    // trie of patterns, with -1 for missing edges
+    int *next = new int[ maxStates * mNumColumns ];
+    int *output = new int[ maxStates ];
+
+    for( int i=0; i<maxStates * mNumColumns; i++ ) {
+        next[i] = -1;
+        }
+    for( int s=0; s<maxStates; s++ ) {
+        output[s] = -1;
+        }
+
+    int numStates = 1;
+
+    for( int p=0; p<numPatterns; p++ ) {
+        const unsigned char *pattern =
+            (const unsigned char *)mPatterns.getElementDirect( p );
+
+        int length = mPatternLengths.getElementDirect( p );
+
+        int state = 0;
+
+        for( int i=0; i<length; i++ ) {
+            int *edge = &( next[ state * mNumColumns +
+                                 mColumn[ pattern[i] ] ] );
+            if( *edge == -1 ) {
+                *edge = numStates;
+                numStates++;
+                }
+            state = *edge;
+            }
+
+        // duplicates keep first index
+        if( output[ state ] == -1 ) {
+            output[ state ] = p;
+            }
+        }
+
+
+    // breadth-first, so each state's failure state (its longest proper
+    // suffix that is also a prefix) is finished before its children,
+    // and missing edges can be filled in from the failure state's edges
+    mNumStates = numStates;
+
+    mNext = new int[ numStates * mNumColumns ];
+    mOutput = new int[ numStates ];
+    mOutputLink = new int[ numStates ];
+
+    memcpy( mNext, next, numStates * mNumColumns * sizeof( int ) );
+    memcpy( mOutput, output, numStates * sizeof( int ) );
+
+    delete [] next;
+    delete [] output;
+
+    int *failure = new int[ numStates ];
+    int *queue = new int[ numStates ];
+    int queueStart = 0;
+    int queueEnd = 0;
+
+    failure[0] = 0;
+    mOutputLink[0] = -1;
+
+    for( int c=0; c<mNumColumns; c++ ) {
+        int child = mNext[c];
+
+        if( child == -1 ) {
+            mNext[c] = 0;
+            }
+        else {
+            failure[ child ] = 0;
+            mOutputLink[ child ] = -1;
+            queue[ queueEnd++ ] = child;
+            }
+        }
+
+    while( queueStart < queueEnd ) {
+        int state = queue[ queueStart++ ];
+
+        int *edges = &( mNext[ state * mNumColumns ] );
+        int *failureEdges = &( mNext[ failure[ state ] * mNumColumns ] );
+
+        for( int c=0; c<mNumColumns; c++ ) {
+            int child = edges[c];
+
+            if( child == -1 ) {
+                edges[c] = failureEdges[c];
+                }
+            else {
+                int childFailure = failureEdges[c];
+
+                failure[ child ] = childFailure;
+
+                if( mOutput[ childFailure ] != -1 ) {
+                    mOutputLink[ child ] = childFailure;
+                    }
+                else {
+                    mOutputLink[ child ] = mOutputLink[ childFailure ];
+                    }
+
+                queue[ queueEnd++ ] = child;
+                }
+            }
+        }
+
+    delete [] failure;
+    delete [] queue;
+
+    mCompiled = true;
+    }
+
+
+
+int MultiStringMatcher::longestOutput( int inState ) {
+    int pattern = mOutput[ inState ];
+
+    if( pattern == -1 && mOutputLink[ inState ] != -1 ) {
+        pattern = mOutput[ mOutputLink[ inState ] ];
+        }
+    return pattern;
+    }
+
+
+
+char *MultiStringMatcher::locate( const char *inText, int *outPatternIndex ) {
+    compile();
+
+    const unsigned char *text = (const unsigned char *)inText;
+
+    int state = 0;
+
+    for( int i=0; text[i] != '\0'; i++ ) {
+        state = mNext[ state * mNumColumns + mColumn[ text[i] ] ];
+
+        int pattern = longestOutput( state );
+
+        if( pattern != -1 ) {
+            if( outPatternIndex != NULL ) {
+                *outPatternIndex = pattern;
+                }
+
+            int start = i + 1 - mPatternLengths.getElementDirect( pattern );
+
+            return (char *)&( inText[ start ] );
+            }
+        }
+
+    return NULL;
+    }
+
+
+
+char MultiStringMatcher::containsAny( const char *inText ) {
+    return ( locate( inText ) != NULL );
+    }
+
+
+
+int MultiStringMatcher::findAll(
+    const char *inText, SimpleVector<MultiStringMatch> *outMatches ) {
+
+    compile();
+
+    const unsigned char *text = (const unsigned char *)inText;
+
+    int numFound = 0;
+    int state = 0;
+
+    for( int i=0; text[i] != '\0'; i++ ) {
+        state = mNext[ state * mNumColumns + mColumn[ text[i] ] ];
+
+        // this state's pattern, then shorter ones ending here
+        int matchState = state;
+
+        if( mOutput[ matchState ] == -1 ) {
+            matchState = mOutputLink[ matchState ];
+            }
+
+        while( matchState != -1 ) {
+            MultiStringMatch m;
+            m.patternIndex = mOutput[ matchState ];
+            m.length = mPatternLengths.getElementDirect( m.patternIndex );
+            m.start = i + 1 - m.length;
+
+            outMatches->push_back( m );
+            numFound++;
+
+            matchState = mOutputLink[ matchState ];
+            }
+        }
+
+    return numFound;
+    }
+
+
+
+char *MultiStringMatcher::maskMatches( const char *inText,
+                                       char inMaskChar ) {
+    compile();
+
+    char *result = stringDuplicate( inText );
+
+    const unsigned char *text = (const unsigned char *)inText;
+
+    int state = 0;
+
+    for( int i=0; text[i] != '\0'; i++ ) {
+        state = mNext[ state * mNumColumns + mColumn[ text[i] ] ];
+
+        // shorter patterns ending here are inside the longest one
+        int pattern = longestOutput( state );
+
+        if( pattern != -1 ) {
+            int start = i + 1 - mPatternLengths.getElementDirect( pattern );
+
+            for( int j=start; j<=i; j++ ) {
+                result[j] = inMaskChar;
+                }
+            }
+        }
+
+    return result;
+    }
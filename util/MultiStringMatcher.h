@@ -0,0 +1,187 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+#include "minorGems/common.h"
+
+
+
+#ifndef MULTI_STRING_MATCHER_INCLUDED
+#define MULTI_STRING_MATCHER_INCLUDED
+
+
+#include "minorGems/util/SimpleVector.h"
+
+
+
+typedef struct MultiStringMatch {
+        // offset of match in text
+        int start;
+        int length;
+
+        int patternIndex;
+    } MultiStringMatch;
+
+SIMPLE_VECTOR_TRIVIAL_TYPE( MultiStringMatch )
+
+
+
+/**
+ * Finds any of a set of patterns in a string in one pass, however many
+ * patterns there are (an Aho-Corasick automaton).
+ *
+ * Meant for things like filtering chat messages against a word list,
+ * where calling stringLocateIgnoreCase once per pattern costs a pass over
+ * the message for each.
+ *
+ * Patterns are compiled into a table with one row per pattern prefix
+ * and one column per distinct pattern character, so matching costs one
+ * table lookup per text character.
+ *
+ * Usage:
+ *   MultiStringMatcher filter;
+ *   filter.addWordList( wordListFileContents );
+ *   char *clean = filter.maskMatches( message );
+ *
+ * Patterns are compiled on the first search after they change.  Searching
+ * doesn't change the matcher, so once compiled (see compile), one matcher
+ * can be searched from several threads.
+ *
+ * @author Jason Rohrer
+ */
+class MultiStringMatcher {
+
+	public:
+
+		/**
+		 * @param inIgnoreCase true to match ASCII letters in either
+		 *   case.  Defaults to true.
+		 */
+		MultiStringMatcher( char inIgnoreCase = true );
+
+		~MultiStringMatcher();
+
+
+		/**
+		 * Adds a pattern.
+		 *
+		 * @param inPattern the pattern.  Empty patterns are ignored.
+		 *   Must be destroyed by caller if non-const.
+		 *
+		 * @return the pattern's index, or -1 if it was empty.
+		 */
+		int addPattern( const char *inPattern );
+
+
+		/**
+		 * Adds one pattern per line, trimmed of whitespace, skipping
+		 * blank lines.  Lines can hold phrases with inner spaces.
+		 *
+		 * @param inWordList the list.
+		 *   Must be destroyed by caller if non-const.
+		 */
+		void addWordList( const char *inWordList );
+
+
+		int getNumPatterns();
+
+		// Must NOT be destroyed by caller
+		const char *getPattern( int inPatternIndex );
+
+
+		// builds matching table now, rather than on first search
+		void compile();
+
+
+
+		/**
+		 * Finds the match that ends earliest in a string, and, of those,
+		 * the longest.
+		 *
+		 * @param inText the \0-terminated string to search.
+		 *   Must be destroyed by caller if non-const.
+		 * @param outPatternIndex pointer to where the matching pattern's
+		 *   index should be returned, or NULL.
+		 *
+		 * @return pointer into inText where the match starts, or NULL if
+		 *   no pattern is found.
+		 */
+		char *locate( const char *inText, int *outPatternIndex = NULL );
+
+
+		char containsAny( const char *inText );
+
+
+		/**
+		 * Finds every occurrence of every pattern, including overlapping
+		 * ones, in order of where they end.
+		 *
+		 * @param inText the \0-terminated string to search.
+		 *   Must be destroyed by caller if non-const.
+		 * @param outMatches vector to add matches to.
+		 *   Must be destroyed by caller.
+		 *
+		 * @return the number of matches added.
+		 */
+		int findAll( const char *inText,
+					 SimpleVector<MultiStringMatch> *outMatches );
+
+
+		/**
+		 * Gets a copy of a string with every character that is part of a
+		 * match replaced.
+		 *
+		 * @param inText the \0-terminated string.
+		 *   Must be destroyed by caller if non-const.
+		 * @param inMaskChar the replacement character.  Defaults to '*'.
+		 *
+		 * @return a newly allocated string.
+		 *   Must be destroyed by caller.
+		 */
+		char *maskMatches( const char *inText, char inMaskChar = '*' );
+
+
+
+	protected:
+
+		char mIgnoreCase;
+
+		SimpleVector<char *> mPatterns;
+		SimpleVector<int> mPatternLengths;
+
+		char mCompiled;
+
+
+		// column of each (case-folded) text character
+		// column 0 is for characters in no pattern
+		int mColumn[ 256 ];
+
+		int mNumColumns;
+
+		int mNumStates;
+
+		// mNumStates x mNumColumns, next state for each state and column,
+		// with failures already followed, so matching never backtracks
+		// state 0 is the empty prefix
+		int *mNext;
+
+		// longest pattern ending at each state, or -1
+		int *mOutput;
+
+		// nearest shorter suffix state with an output, or -1,
+		// for finding all patterns that end at one place
+		int *mOutputLink;
+
+
+		void freeTable();
+
+		// longest pattern that ends at a state, or -1
+		int longestOutput( int inState );
+	};
+
+
+
+#endif
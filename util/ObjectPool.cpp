@@ -0,0 +1,268 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+#include "minorGems/common.h"
+
+
+
+#include "minorGems/util/ObjectPool.h"
+#include "minorGems/system/atomicOps.h"
+
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <sched.h>
+#endif
+
+
+#ifdef _MSC_VER
+    #define OBJECT_POOL_THREAD_LOCAL __declspec( thread )
+#else
+    #define OBJECT_POOL_THREAD_LOCAL __thread
+#endif
+
+
+
+// each thread's cache for each pool, indexed by mCacheIndex
+// indices are never reused, so entries for destroyed pools are never
+// looked at again
+static OBJECT_POOL_THREAD_LOCAL
+ObjectPoolThreadCache *threadCaches[ OBJECT_POOL_MAX_CACHED_POOLS ];
+
+static volatile int nextCacheIndex = 0;
+
+
+
+// chain through the first word of each free slot
+static inline void *getNext( void *inSlot ) {
+    return *( (void **)inSlot );
+    }
+
+static inline void setNext( void *inSlot, void *inNext ) {
+    *( (void **)inSlot ) = inNext;
+    }
+
+
+
+ObjectPoolBase::ObjectPoolBase( int inSlotSize, int inObjectsPerSlab,
+                                char inThreadCaches )
+        : mSlotSize( inSlotSize ), mObjectsPerSlab( inObjectsPerSlab ),
+          mLock( 0 ),
+          mFreeList( NULL ), mSlabs( NULL ),
+          mNumSlabs( 0 ), mNumLive( 0 ),
+          mCacheIndex( -1 ),
+          mCaches( NULL ) {
+
+    if( inThreadCaches ) {
+        int index = atomicFetchAdd( &nextCacheIndex, 1 );
+
+        if( index < OBJECT_POOL_MAX_CACHED_POOLS ) {
+            mCacheIndex = index;
+            }
+        }
+    }
+
+
+
+ObjectPoolBase::~ObjectPoolBase() {
+    while( mSlabs != NULL ) {
+        void *next = getNext( mSlabs );
+
+        // allocated as raw bytes, so no destructors run here
+        delete [] (unsigned char *)mSlabs;
+
+        mSlabs = next;
+        }
+
+    while( mCaches != NULL ) {
+        ObjectPoolThreadCache *next = mCaches->next;
+        delete mCaches;
+        mCaches = next;
+        }
+
+    if( mCacheIndex != -1 ) {
+        // at least this thread won't see it again
+        threadCaches[ mCacheIndex ] = NULL;
+        }
+    }
+
+
+
+// spins, as in MutexLockProfile
+void ObjectPoolBase::lock() {
+    while( atomicExchange( &mLock, 1 ) != 0 ) {
+        #ifdef _WIN32
+            SwitchToThread();
+        #else
+            sched_yield();
+        #endif
+        }
+    }
+
+
+
+void ObjectPoolBase::unlock() {
+    atomicStore( &mLock, 0 );
+    }
+
+
+
+void ObjectPoolBase::addSlab() {
+    // one extra slot at the start for chaining
+    // (new[] returns memory aligned for any type)
+    unsigned char *slab =
+        new unsigned char[ mSlotSize * ( mObjectsPerSlab + 1 ) ];
+
+    setNext( slab, mSlabs );
+    mSlabs = slab;
+    mNumSlabs++;
+
+    // chain in reverse, so that slots come off the free list in address
+    // order
+    for( int i=mObjectsPerSlab; i>=1; i-- ) {
+        void *slot = &( slab[ i * mSlotSize ] );
+
+        setNext( slot, mFreeList );
+        mFreeList = slot;
+        }
+    }
+
+
+
+void *ObjectPoolBase::popShared() {
+    if( mFreeList == NULL ) {
+        addSlab();
+        }
+
+    void *slot = mFreeList;
+    mFreeList = getNext( slot );
+
+    return slot;
+    }
+
+
+
+ObjectPoolThreadCache *ObjectPoolBase::getThreadCache() {
+    ObjectPoolThreadCache *cache = threadCaches[ mCacheIndex ];
+
+    if( cache == NULL ) {
+        cache = new ObjectPoolThreadCache;
+        cache->numSlots = 0;
+
+        lock();
+        cache->next = mCaches;
+        mCaches = cache;
+        unlock();
+
+        threadCaches[ mCacheIndex ] = cache;
+        }
+
+    return cache;
+    }
+
+
+
+void *ObjectPoolBase::allocateSlot() {
+    if( mCacheIndex == -1 ) {
+        lock();
+        void *slot = popShared();
+        mNumLive++;
+        unlock();
+
+        return slot;
+        }
+
+
+    ObjectPoolThreadCache *cache = getThreadCache();
+
+    if( cache->numSlots == 0 ) {
+        // refill half, leaving room for releases before next trip to
+        // shared list
+        lock();
+
+        for( int i=0; i<OBJECT_POOL_CACHE_SIZE / 2; i++ ) {
+            cache->slots[ cache->numSlots ] = popShared();
+            cache->numSlots++;
+            }
+        mNumLive += OBJECT_POOL_CACHE_SIZE / 2;
+
+        unlock();
+        }
+
+    cache->numSlots--;
+
+    return cache->slots[ cache->numSlots ];
+    }
+
+
+
+void ObjectPoolBase::releaseSlot( void *inSlot ) {
+    if( mCacheIndex == -1 ) {
+        lock();
+        setNext( inSlot, mFreeList );
+        mFreeList = inSlot;
+        mNumLive--;
+        unlock();
+
+        return;
+        }
+
+
+    ObjectPoolThreadCache *cache = getThreadCache();
+
+    if( cache->numSlots == OBJECT_POOL_CACHE_SIZE ) {
+        // give half back, so a thread that only releases (objects made
+        // on another thread) doesn't hoard them
+        lock();
+
+        for( int i=0; i<OBJECT_POOL_CACHE_SIZE / 2; i++ ) {
+            cache->numSlots--;
+
+            void *slot = cache->slots[ cache->numSlots ];
+
+            setNext( slot, mFreeList );
+            mFreeList = slot;
+            }
+        mNumLive -= OBJECT_POOL_CACHE_SIZE / 2;
+
+        unlock();
+        }
+
+    cache->slots[ cache->numSlots ] = inSlot;
+    cache->numSlots++;
+    }
+
+
+
+int ObjectPoolBase::getNumLive() {
+    lock();
+
+    // slots sitting in thread caches were counted as live when they
+    // left the shared list
+    int numLive = mNumLive;
+
+    ObjectPoolThreadCache *cache = mCaches;
+    while( cache != NULL ) {
+        numLive -= cache->numSlots;
+        cache = cache->next;
+        }
+
+    unlock();
+
+    return numLive;
+    }
+
+
+
+int ObjectPoolBase::getNumSlots() {
+    lock();
+    int numSlots = mNumSlabs * mObjectsPerSlab;
+    unlock();
+
+    return numSlots;
+    }
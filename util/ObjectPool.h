@@ -0,0 +1,187 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+#include "minorGems/common.h"
+
+
+
+#ifndef OBJECT_POOL_INCLUDED
+#define OBJECT_POOL_INCLUDED
+
+
+#include <new>
+
+
+
+// slots each thread keeps for itself, per pool
+#define OBJECT_POOL_CACHE_SIZE 64
+
+// pools made after this many with thread caches get none (they still
+// work, but every call takes the shared lock)
+#define OBJECT_POOL_MAX_CACHED_POOLS 256
+
+
+
+typedef struct ObjectPoolThreadCache {
+        void *slots[ OBJECT_POOL_CACHE_SIZE ];
+        int numSlots;
+
+        // all caches made for one pool, so the pool can free them
+        struct ObjectPoolThreadCache *next;
+    } ObjectPoolThreadCache;
+
+
+
+/**
+ * Size-agnostic part of ObjectPool.  Use ObjectPool instead.
+ */
+class ObjectPoolBase {
+
+    public:
+
+        ObjectPoolBase( int inSlotSize, int inObjectsPerSlab,
+                        char inThreadCaches );
+
+        ~ObjectPoolBase();
+
+
+        void *allocateSlot();
+
+        void releaseSlot( void *inSlot );
+
+
+        // slots handed out and not yet released, from any thread
+        // only exact while no other thread is using the pool
+        int getNumLive();
+
+        // total slots in all slabs
+        int getNumSlots();
+
+
+    protected:
+
+        int mSlotSize;
+        int mObjectsPerSlab;
+
+        // protects everything below
+        volatile int mLock;
+
+        // free slots hold a pointer to the next free slot
+        void *mFreeList;
+
+        // start of each slab, chained through its first slot
+        void *mSlabs;
+
+        int mNumSlabs;
+        int mNumLive;
+
+        // index into each thread's cache table, or -1 for no caches
+        int mCacheIndex;
+
+        ObjectPoolThreadCache *mCaches;
+
+
+        void lock();
+        void unlock();
+
+        // mLock must be held
+        void addSlab();
+
+        // mLock must be held
+        void *popShared();
+
+        ObjectPoolThreadCache *getThreadCache();
+
+
+        // not copyable
+        ObjectPoolBase( const ObjectPoolBase &inCopy );
+        ObjectPoolBase & operator = ( const ObjectPoolBase &inOther );
+    };
+
+
+
+/**
+ * Thread-safe version of PoolAllocator:  fixed-size storage for lots of
+ * small objects of one type, carved from slabs so that objects made
+ * together sit together in memory, and recycled through a free list.
+ *
+ * Objects can be allocated on one thread and released on another.
+ *
+ * With thread caches on, each thread keeps up to OBJECT_POOL_CACHE_SIZE
+ * free slots of its own and only takes the pool's lock to move half a
+ * cache's worth at a time, so steady-state allocate/release pairs on a
+ * thread never contend.  Slots sitting in a thread's cache when that
+ * thread exits are not reused until the pool is destroyed.
+ *
+ * Slabs are only returned to the heap when the pool is destroyed, so any
+ * objects still allocated then are simply forgotten (their destructors are
+ * NOT called).  No thread may use the pool while it is being destroyed.
+ *
+ * For a pool that only one thread touches, PoolAllocator is simpler and
+ * a little faster.
+ *
+ * Usage:
+ *   static ObjectPool<Thing> thingPool;
+ *   Thing *t = new( thingPool.allocate() ) Thing( ... );
+ *   ...
+ *   thingPool.destroy( t );
+ *
+ * @author Jason Rohrer
+ */
+template <class Type>
+class ObjectPool : public ObjectPoolBase {
+
+    public:
+
+        /**
+         * Constructs a pool.
+         *
+         * @param inObjectsPerSlab how many objects each slab allocated
+         *   from the heap holds.
+         *   Defaults to 256.
+         * @param inThreadCaches true to give each thread its own cache of
+         *   free slots.
+         *   Defaults to true.
+         */
+        ObjectPool( int inObjectsPerSlab = 256, char inThreadCaches = true )
+                : ObjectPoolBase( sizeof( ObjectPoolSlot ), inObjectsPerSlab,
+                                  inThreadCaches ) {
+            }
+
+
+        // gets uninitialized storage for one Type
+        void *allocate() {
+            return allocateSlot();
+            }
+
+        // returns storage from allocate without destroying anything in it
+        void release( void *inStorage ) {
+            releaseSlot( inStorage );
+            }
+
+        // calls destructor and releases storage
+        void destroy( Type *inObject ) {
+            inObject->~Type();
+            releaseSlot( (void *)inObject );
+            }
+
+
+    protected:
+
+        // only used for its size
+        typedef union ObjectPoolSlot {
+                void *nextFree;
+                unsigned char storage[ sizeof( Type ) ];
+
+                // so slots are aligned for doubles on 32-bit platforms
+                double alignment;
+            } ObjectPoolSlot;
+    };
+
+
+
+#endif
@@ -0,0 +1,161 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14	Jason Rohrer
+ * Created.
+ */
+
+#include "minorGems/common.h"
+
+
+
+#ifndef POOL_ALLOCATOR_INCLUDED
+#define POOL_ALLOCATOR_INCLUDED
+
+
+#include <new>
+#include <stddef.h>
+
+
+
+/**
+ * Hands out fixed-size storage for lots of small objects of one type,
+ * carved from large blocks instead of one heap allocation per object.
+ *
+ * Released objects go on a free list and are reused first.  Blocks are
+ * only returned to the heap when the pool is destroyed, so any objects
+ * still allocated then are simply forgotten (their destructors are NOT
+ * called).
+ *
+ * Not thread-safe.
+ *
+ * Usage:
+ *   Thing *t = new( pool.allocate() ) Thing( ... );
+ *   ...
+ *   pool.destroy( t );
+ *
+ * @author Jason Rohrer
+ */
+template <class Type>
+class PoolAllocator {
+
+	public:
+
+		/**
+		 * Constructs a pool.
+		 *
+		 * @param inObjectsPerBlock how many objects each block allocated
+		 *   from the heap holds.
+		 *   Defaults to 256.
+		 */
+		PoolAllocator( int inObjectsPerBlock = 256 );
+
+		~PoolAllocator();
+
+
+		// gets uninitialized storage for one Type
+		void *allocate();
+
+		// returns storage from allocate without destroying anything in it
+		void release( void *inStorage );
+
+		// calls destructor and releases storage
+		void destroy( Type *inObject );
+
+
+	private:
+
+		// free slots hold a pointer to the next free slot
+		typedef union PoolSlot {
+				union PoolSlot *nextFree;
+				unsigned char storage[ sizeof( Type ) ];
+
+				// so slots are aligned for doubles on 32-bit platforms
+				double alignment;
+			} PoolSlot;
+
+
+		int mObjectsPerBlock;
+
+		PoolSlot *mFreeList;
+
+		// start of each block, chained through its first slot
+		PoolSlot *mBlocks;
+
+
+		// not copyable
+		PoolAllocator( const PoolAllocator &inCopy );
+		PoolAllocator & operator = ( const PoolAllocator &inOther );
+	};
+
+
+
+template <class Type>
+inline PoolAllocator<Type>::PoolAllocator( int inObjectsPerBlock )
+		: mObjectsPerBlock( inObjectsPerBlock ),
+		  mFreeList( NULL ), mBlocks( NULL ) {
+	}
+
+
+
+template <class Type>
+inline PoolAllocator<Type>::~PoolAllocator() {
+	while( mBlocks != NULL ) {
+		PoolSlot *next = mBlocks->nextFree;
+
+		// allocated as raw bytes, so no destructors run here
+		delete [] (unsigned char *)mBlocks;
+
+		mBlocks = next;
+		}
+	}
+
+
+
+template <class Type>
+inline void *PoolAllocator<Type>::allocate() {
+	if( mFreeList == NULL ) {
+		// new block, with one extra slot at the start for chaining
+		// (new[] returns memory aligned for any type)
+		PoolSlot *block =
+			(PoolSlot *)( new unsigned char[
+							  sizeof( PoolSlot ) *
+							  ( mObjectsPerBlock + 1 ) ] );
+
+		block[0].nextFree = mBlocks;
+		mBlocks = block;
+
+		for( int i=1; i<=mObjectsPerBlock; i++ ) {
+			block[i].nextFree = mFreeList;
+			mFreeList = &( block[i] );
+			}
+		}
+
+	PoolSlot *slot = mFreeList;
+	mFreeList = slot->nextFree;
+
+	return (void *)slot;
+	}
+
+
+
+template <class Type>
+inline void PoolAllocator<Type>::release( void *inStorage ) {
+	PoolSlot *slot = (PoolSlot *)inStorage;
+
+	slot->nextFree = mFreeList;
+	mFreeList = slot;
+	}
+
+
+
+template <class Type>
+inline void PoolAllocator<Type>::destroy( Type *inObject ) {
+	inObject->~Type();
+
+	release( (void *)inObject );
+	}
+
+
+
+#endif
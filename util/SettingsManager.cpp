@@ -45,6 +45,16 @@
  * 2020-March-3    Jason Rohrer
  * Setting double settings (printing them to file) now uses %f format specifier,
  * since %lf doesn't seem to work on mingw, and %f is correct.
+ *
+ * 2026-October-14    Jason Rohrer
+ * In-memory cache of setting contents, rechecked against file stamps.
+ *
+ * 2026-October-15    Jason Rohrer
+ * Defaults source (like a ResourceArchive) for settings with no file.
+ * Settings directory path kept, and file names built in one allocation.
+ * Optional write-behind, with writes coalesced and flushed by a background
+ * thread.  Files written to a temporary file and renamed into place.
+ * Settings read from disk counted in StartupTimeline.
  */
 
 
@@ -57,6 +67,12 @@
 #include "minorGems/io/file/Path.h"
 
 #include "minorGems/crypto/hashes/sha1.h"
+#include "minorGems/system/Time.h"
+#include "minorGems/system/Thread.h"
+
+#ifdef STARTUP_TIMELINE
+#include "minorGems/system/StartupTimeline.h"
+#endif
 
 
 
@@ -67,9 +83,124 @@ char SettingsManager::mHashingOn = false;
 
 
 
+// what a setting's files looked like when cached
+typedef struct SettingsFileStamp {
+        timeSec_t modTime;
+        long length;
+        
+        // only checked when hashing on
+        timeSec_t hashModTime;
+        long hashLength;
+    } SettingsFileStamp;
+
+
+
+struct SettingsCacheEntry {
+        // NULL if setting missing (or hash didn't match)
+        char *contents;
+        
+        // tokenized contents, made on first use
+        SimpleVector<char*> *tokens;
+        
+        SettingsFileStamp stamp;
+        
+        double lastCheckTime;
+    };
+
+
+
+struct SettingsPendingWrite {
+        char *name;
+        char *value;
+
+        // when the first unwritten change was made
+        double firstSetTime;
+
+        double dueTime;
+    };
+
+
+
+static void freePendingWrite( SettingsPendingWrite *inWrite ) {
+    delete [] inWrite->name;
+    delete [] inWrite->value;
+    delete inWrite;
+    }
+
+
+
+class SettingsWriterThread : public Thread {
+
+    public:
+
+        SettingsWriterThread() {
+            start();
+            }
+
+        ~SettingsWriterThread() {
+            join();
+            }
+
+
+        void run() {
+            SettingsManager::writerLoop();
+            }
+
+    };
+
+
+
+static void freeCacheEntry( SettingsCacheEntry *inEntry ) {
+    if( inEntry->contents != NULL ) {
+        delete [] inEntry->contents;
+        }
+    if( inEntry->tokens != NULL ) {
+        inEntry->tokens->deallocateStringElements();
+        delete inEntry->tokens;
+        }
+    delete inEntry;
+    }
+
+
+
+static void stampFile( const char *inFileName, 
+                       timeSec_t *outModTime, long *outLength ) {
+    File file( NULL, inFileName );
+    
+    if( file.exists() ) {
+        *outModTime = file.getModificationTime();
+        *outLength = file.getLength();
+        }
+    else {
+        *outModTime = 0;
+        *outLength = -1;
+        }
+    }
+
+
+
+static char sameStamp( SettingsFileStamp *inA, SettingsFileStamp *inB ) {
+    return 
+        inA->modTime == inB->modTime &&
+        inA->length == inB->length &&
+        inA->hashModTime == inB->hashModTime &&
+        inA->hashLength == inB->hashLength;
+    }
+
+
+
 void SettingsManager::setDirectoryName( const char *inName ) {
+    // pending settings belong in old directory
+    flushAll();
+    
     delete [] mStaticMembers.mDirectoryName;
     mStaticMembers.mDirectoryName = stringDuplicate( inName );
+
+    delete mStaticMembers.mDirectoryPath;
+    mStaticMembers.mDirectoryPath = 
+        SettingsManagerStaticMembers::makeDirectoryPath( inName );
+    
+    clearCache();
     }
 
 
@@ -81,8 +212,13 @@ char *SettingsManager::getDirectoryName() {
 
 
 void SettingsManager::setHashSalt( const char *inSalt ) {
+    flushAll();
+    
     delete [] mStaticMembers.mHashSalt;
     mStaticMembers.mHashSalt = stringDuplicate( inSalt );
+
+    // cached hash checks no longer valid
+    clearCache();
     }
 
 
@@ -94,7 +230,131 @@ char *SettingsManager::getHashSalt() {
 
 
 void SettingsManager::setHashingOn( char inOn ) {
+    flushAll();
+    
     mHashingOn = inOn;
+
+    clearCache();
+    }
+
+
+
+void SettingsManager::setCacheRecheckInterval( double inSeconds ) {
+    mStaticMembers.mCacheLock.lock();
+    mStaticMembers.mCacheRecheckInterval = inSeconds;
+    mStaticMembers.mCacheLock.unlock();
+    
+    if( inSeconds < 0 ) {
+        clearCache();
+        }
+    }
+
+
+
+void SettingsManager::clearCache() {
+    mStaticMembers.mCacheLock.lock();
+    
+    HashMap<const char*, SettingsCacheEntry*> *cache = 
+        &( mStaticMembers.mCache );
+    
+    for( int i=0; i<cache->getNumSlots(); i++ ) {
+        if( cache->isSlotFilled( i ) ) {
+            freeCacheEntry( *( cache->getSlotValue( i ) ) );
+            }
+        }
+    cache->deleteAll();
+    
+    mStaticMembers.mCacheLock.unlock();
+    }
+
+
+
+void SettingsManager::uncacheSetting( const char *inSettingName ) {
+    mStaticMembers.mCacheLock.lock();
+    
+    SettingsCacheEntry *entry;
+    
+    if( mStaticMembers.mCache.lookup( inSettingName, &entry ) ) {
+        freeCacheEntry( entry );
+        mStaticMembers.mCache.remove( inSettingName );
+        }
+
+    mStaticMembers.mCacheLock.unlock();
+    }
+
+
+
+static void stampSetting( const char *inFileName, const char *inHashFileName,
+                          SettingsFileStamp *outStamp ) {
+    stampFile( inFileName, &( outStamp->modTime ), &( outStamp->length ) );
+
+    outStamp->hashModTime = 0;
+    outStamp->hashLength = -1;
+    
+    if( inHashFileName != NULL ) {
+        stampFile( inHashFileName, 
+                   &( outStamp->hashModTime ), &( outStamp->hashLength ) );
+        }
+    }
+
+
+
+SettingsCacheEntry *SettingsManager::getCacheEntry( 
+    const char *inSettingName ) {
+    
+    if( mStaticMembers.mCacheRecheckInterval < 0 ) {
+        return NULL;
+        }
+    
+    SettingsCacheEntry *entry = NULL;
+    mStaticMembers.mCache.lookup( inSettingName, &entry );
+    
+    double curTime = Time::getCurrentTime();
+    
+    if( entry != NULL && 
+        curTime - entry->lastCheckTime < 
+        mStaticMembers.mCacheRecheckInterval ) {
+        // fresh enough
+        return entry;
+        }
+    
+
+    char *fileName = getSettingsFileName( inSettingName );
+    char *hashFileName = NULL;
+    if( mHashingOn ) {
+        hashFileName = getSettingsFileName( inSettingName, "hash" );
+        }
+    
+    SettingsFileStamp stamp;
+    stampSetting( fileName, hashFileName, &stamp );
+    
+    delete [] fileName;
+    if( hashFileName != NULL ) {
+        delete [] hashFileName;
+        }
+    
+
+    if( entry != NULL ) {
+        entry->lastCheckTime = curTime;
+
+        if( sameStamp( &stamp, &( entry->stamp ) ) ) {
+            return entry;
+            }
+        
+        // changed on disk
+        freeCacheEntry( entry );
+        mStaticMembers.mCache.remove( inSettingName );
+        }
+    
+    entry = new SettingsCacheEntry;
+    entry->contents = readSettingContents( inSettingName );
+    entry->tokens = NULL;
+    entry->stamp = stamp;
+    entry->lastCheckTime = curTime;
+    
+    mStaticMembers.mCache.insert( inSettingName, entry );
+    
+    return entry;
     }
 
 
@@ -103,6 +363,35 @@ void SettingsManager::setHashingOn( char inOn ) {
 SimpleVector<char *> *SettingsManager::getSetting( 
     const char *inSettingName ) {
 
+    mStaticMembers.mCacheLock.lock();
+    
+    SettingsCacheEntry *entry = getCacheEntry( inSettingName );
+    
+    if( entry != NULL ) {
+        SimpleVector<char *> *returnVector = new SimpleVector<char*>();
+        
+        if( entry->contents != NULL ) {
+            if( entry->tokens == NULL ) {
+                entry->tokens = tokenizeString( entry->contents );
+                }
+            
+            int numTokens = entry->tokens->size();
+            
+            for( int i=0; i<numTokens; i++ ) {
+                returnVector->push_back( 
+                    stringDuplicate( 
+                        entry->tokens->getElementDirectFast( i ) ) );
+                }
+            }
+        
+        mStaticMembers.mCacheLock.unlock();
+        
+        return returnVector;
+        }
+    
+    mStaticMembers.mCacheLock.unlock();
+    
+
     char *fileContents = getSettingContents( inSettingName );
     
     if( fileContents == NULL ) {
@@ -214,15 +503,78 @@ SimpleVector<double> *SettingsManager::getDoubleSettingMulti(
 
 
 char *SettingsManager::getSettingContents( const char *inSettingName ) {
+    
+    mStaticMembers.mCacheLock.lock();
+    
+    SettingsCacheEntry *entry = getCacheEntry( inSettingName );
+    
+    if( entry != NULL ) {
+        char *contents = NULL;
+        
+        if( entry->contents != NULL ) {
+            contents = stringDuplicate( entry->contents );
+            }
+        
+        mStaticMembers.mCacheLock.unlock();
+        
+        return contents;
+        }
+    
+    mStaticMembers.mCacheLock.unlock();
+    
+    return readSettingContents( inSettingName );
+    }
 
-    char *fileName = getSettingsFileName( inSettingName );
-    File *settingsFile = new File( NULL, fileName );
 
-    delete [] fileName;
+
+void SettingsManager::setDefaultsSource( ResourceSource *inSource ) {
+    mStaticMembers.mCacheLock.lock();
+    
+    mStaticMembers.mDefaultsSource = inSource;
+    
+    mStaticMembers.mCacheLock.unlock();
+
+    // cached misses may now be found
+    clearCache();
+    }
+
+
+
+char *SettingsManager::readSettingsFile( const char *inFileName ) {
+    File file( NULL, inFileName );
+    
+    char *contents = file.readFileContents();
+
+    if( contents == NULL && mStaticMembers.mDefaultsSource != NULL ) {
+        int length;
+        contents = (char *)
+            mStaticMembers.mDefaultsSource->readResource( inFileName, 
+                                                          &length );
+        }
+
+    return contents;
+    }
+
+
+
+char *SettingsManager::readSettingContents( const char *inSettingName ) {
+
+    // file is out of date until written
+    char *pendingValue = getPendingValue( inSettingName );
+    
+    if( pendingValue != NULL ) {
+        return pendingValue;
+        }
     
-    char *fileContents = settingsFile->readFileContents();
+    #ifdef STARTUP_TIMELINE
+    StartupTimeline::noteSettingRead();
+    #endif
+
+    char *fileName = getSettingsFileName( inSettingName );
 
-    delete settingsFile;
+    char *fileContents = readSettingsFile( fileName );
+
+    delete [] fileName;
 
     
     if( fileContents == NULL ) {
@@ -233,13 +585,9 @@ char *SettingsManager::getSettingContents( const char *inSettingName ) {
         
         char *hashFileName = getSettingsFileName( inSettingName, "hash" );
         
-        File *hashFile = new File( NULL, hashFileName );
+        char *savedHash = readSettingsFile( hashFileName );
         
         delete [] hashFileName;
-        
-        char *savedHash = hashFile->readFileContents();
-        
-        delete hashFile;
 
         if( savedHash == NULL ) {
             printf( "Hash missing for setting %s\n", inSettingName );
@@ -293,6 +641,31 @@ char *SettingsManager::getSettingContents( const char *inSettingName,
 char *SettingsManager::getStringSetting( const char *inSettingName ) {
     char *value = NULL;
     
+    mStaticMembers.mCacheLock.lock();
+    
+    SettingsCacheEntry *entry = getCacheEntry( inSettingName );
+    
+    if( entry != NULL ) {
+        // only first token needed, don't copy the rest
+        if( entry->contents != NULL ) {
+            if( entry->tokens == NULL ) {
+                entry->tokens = tokenizeString( entry->contents );
+                }
+            
+            if( entry->tokens->size() >= 1 ) {
+                value = stringDuplicate( 
+                    entry->tokens->getElementDirectFast( 0 ) );
+                }
+            }
+        
+        mStaticMembers.mCacheLock.unlock();
+        
+        return value;
+        }
+    
+    mStaticMembers.mCacheLock.unlock();
+    
+
     SimpleVector<char *> *settingsVector = getSetting( inSettingName );
 
     int numStrings = settingsVector->size(); 
@@ -496,11 +869,198 @@ void SettingsManager::setSetting( const char *inSettingName,
 void SettingsManager::setSetting( const char *inSettingName,
                                   const char *inSettingValue ) {
 
+    mStaticMembers.mPendingLock.lock();
+    
+    double delay = mStaticMembers.mWriteDelay;
+    
+    if( delay > 0 ) {
+        double curTime = Time::getMonotonicTime();
+        
+        SimpleVector<SettingsPendingWrite*> *pending = 
+            &( mStaticMembers.mPendingWrites );
+        
+        SettingsPendingWrite *write = NULL;
+        
+        for( int i=0; i<pending->size(); i++ ) {
+            SettingsPendingWrite *w = pending->getElementDirectFast( i );
+            
+            if( strcmp( w->name, inSettingName ) == 0 ) {
+                write = w;
+                break;
+                }
+            }
+        
+        if( write != NULL ) {
+            // coalesce, only newest value written
+            delete [] write->value;
+            write->value = stringDuplicate( inSettingValue );
+            }
+        else {
+            write = new SettingsPendingWrite;
+            write->name = stringDuplicate( inSettingName );
+            write->value = stringDuplicate( inSettingValue );
+            write->firstSetTime = curTime;
+            
+            pending->push_back( write );
+            }
+
+        // wait until setting stops changing, but not forever
+        write->dueTime = curTime + delay;
+        
+        if( write->dueTime > write->firstSetTime + 2 * delay ) {
+            write->dueTime = write->firstSetTime + 2 * delay;
+            }
+        
+        if( mStaticMembers.mWriter == NULL ) {
+            mStaticMembers.mWriter = new SettingsWriterThread();
+            }
+        
+        mStaticMembers.mPendingLock.unlock();
+        
+        mStaticMembers.mWakeSemaphore.signal();
+        
+
+        // reads see new value right away
+        mStaticMembers.mCacheLock.lock();
+        cacheSetting( inSettingName, inSettingValue );
+        mStaticMembers.mCacheLock.unlock();
+        
+        return;
+        }
+    
+    mStaticMembers.mPendingLock.unlock();
+    
+
+    char written = writeSettingFiles( inSettingName, inSettingValue );
+    
+    mStaticMembers.mCacheLock.lock();
+    
+    if( written ) {
+        // write through to cache, so next read doesn't touch file
+        cacheSetting( inSettingName, inSettingValue );
+        mStaticMembers.mCacheLock.unlock();
+        }
+    else {
+        mStaticMembers.mCacheLock.unlock();
+        
+        // don't know what's on disk now
+        uncacheSetting( inSettingName );
+        }
+    }
+
+
+
+void SettingsManager::cacheSetting( const char *inSettingName,
+                                    const char *inValue ) {
+    
+    if( mStaticMembers.mCacheRecheckInterval < 0 ) {
+        return;
+        }
+    
+    SettingsCacheEntry *entry = NULL;
+    mStaticMembers.mCache.lookup( inSettingName, &entry );
+    
+    if( entry == NULL ) {
+        if( inValue == NULL ) {
+            // nothing to restamp
+            return;
+            }
+        
+        entry = new SettingsCacheEntry;
+        entry->contents = NULL;
+        entry->tokens = NULL;
+        
+        mStaticMembers.mCache.insert( inSettingName, entry );
+        }
+    
+    if( inValue != NULL ) {
+        if( entry->contents != NULL ) {
+            delete [] entry->contents;
+            }
+        entry->contents = stringDuplicate( inValue );
+        
+        if( entry->tokens != NULL ) {
+            entry->tokens->deallocateStringElements();
+            delete entry->tokens;
+            entry->tokens = NULL;
+            }
+        }
+    
+    char *fileName = getSettingsFileName( inSettingName );
+    char *hashFileName = NULL;
+    if( mHashingOn ) {
+        hashFileName = getSettingsFileName( inSettingName, "hash" );
+        }
+    
+    // while a write is pending, this is the stamp of the old file,
+    // which still matches until the new one is written and restamped
+    stampSetting( fileName, hashFileName, &( entry->stamp ) );
+    entry->lastCheckTime = Time::getCurrentTime();
+    
+    delete [] fileName;
+    if( hashFileName != NULL ) {
+        delete [] hashFileName;
+        }
+    }
+
+
+
+// writes to inFileName.tmp, then renames it over inFileName
+static char writeFileAtomic( const char *inFileName, 
+                             const char *inContents ) {
+    
+    char *tempFileName = autoSprintf( "%s.tmp", inFileName );
+    
+    FILE *file = fopen( tempFileName, "w" );
+    
+    if( file == NULL ) {
+        delete [] tempFileName;
+        return false;
+        }
+    
+    fprintf( file, "%s", inContents );
+    
+    char error = ferror( file );
+    
+    if( fclose( file ) != 0 ) {
+        error = true;
+        }
+    
+    if( error ) {
+        printf( "Failed to write settings file %s\n", tempFileName );
+        
+        remove( tempFileName );
+        delete [] tempFileName;
+        return false;
+        }
+    
+    if( rename( tempFileName, inFileName ) != 0 ) {
+        // Windows won't rename over an existing file
+        remove( inFileName );
+        
+        if( rename( tempFileName, inFileName ) != 0 ) {
+            printf( "Failed to replace settings file %s\n", inFileName );
+            
+            remove( tempFileName );
+            delete [] tempFileName;
+            return false;
+            }
+        }
+    
+    delete [] tempFileName;
+    return true;
+    }
+
+
+
+char SettingsManager::writeSettingFiles( const char *inSettingName,
+                                         const char *inValue ) {
+    
     if( mHashingOn ) {
         
         // compute hash
         char *stringToHash = autoSprintf( "%s%s",
-                                          inSettingValue,
+                                          inValue,
                                           mStaticMembers.mHashSalt );
 
         char *hash = computeSHA1Digest( stringToHash );
@@ -508,35 +1068,172 @@ void SettingsManager::setSetting( const char *inSettingName,
         delete [] stringToHash;
         
         char *hashFileName = getSettingsFileName( inSettingName, "hash" );
+        
+        writeFileAtomic( hashFileName, hash );
+        
+        delete [] hashFileName;
+        delete [] hash;
+        }
+    
+    
+    char *fileName = getSettingsFileName( inSettingName );
+    
+    char written = writeFileAtomic( fileName, inValue );
     
-        FILE *file = fopen( hashFileName, "w" );
+    delete [] fileName;
+    
+    return written;
+    }
 
-        delete [] hashFileName;
 
-        if( file != NULL ) {
-            fprintf( file, "%s", hash );
-            
-            fclose( file );
+
+char *SettingsManager::getPendingValue( const char *inSettingName ) {
+    char *value = NULL;
+    
+    mStaticMembers.mPendingLock.lock();
+    
+    SimpleVector<SettingsPendingWrite*> *pending = 
+        &( mStaticMembers.mPendingWrites );
+    
+    for( int i=0; i<pending->size(); i++ ) {
+        SettingsPendingWrite *w = pending->getElementDirectFast( i );
+        
+        if( strcmp( w->name, inSettingName ) == 0 ) {
+            value = stringDuplicate( w->value );
+            break;
+            }
+        }
+    
+    mStaticMembers.mPendingLock.unlock();
+    
+    return value;
+    }
+
+
+
+void SettingsManager::writePending( char inOnlyDue, 
+                                    const char *inSettingName ) {
+    
+    mStaticMembers.mWriteLock.lock();
+    
+
+    // take writes out of list, so setSetting isn't blocked on disk
+    SimpleVector<SettingsPendingWrite*> toWrite;
+    
+    mStaticMembers.mPendingLock.lock();
+    
+    SimpleVector<SettingsPendingWrite*> *pending = 
+        &( mStaticMembers.mPendingWrites );
+    
+    double curTime = Time::getMonotonicTime();
+    
+    for( int i=0; i<pending->size(); i++ ) {
+        SettingsPendingWrite *w = pending->getElementDirectFast( i );
+        
+        if( inOnlyDue && w->dueTime > curTime ) {
+            continue;
+            }
+        if( inSettingName != NULL && strcmp( w->name, inSettingName ) != 0 ) {
+            continue;
             }
         
-        delete [] hash;
+        toWrite.push_back( w );
+        pending->deleteElement( i );
+        i--;
+        }
+    
+    mStaticMembers.mPendingLock.unlock();
+    
+
+    for( int i=0; i<toWrite.size(); i++ ) {
+        SettingsPendingWrite *w = toWrite.getElementDirectFast( i );
+        
+        char written = writeSettingFiles( w->name, w->value );
+        
+        if( written ) {
+            // new file now matches cached contents
+            mStaticMembers.mCacheLock.lock();
+            cacheSetting( w->name, NULL );
+            mStaticMembers.mCacheLock.unlock();
+            }
+        else {
+            uncacheSetting( w->name );
+            }
+        
+        freePendingWrite( w );
         }
     
+    mStaticMembers.mWriteLock.unlock();
+    }
 
 
 
-    FILE *file = getSettingsFile( inSettingName, "w" );
+void SettingsManager::writerLoop() {
     
-    if( file != NULL ) {
+    while( true ) {
+        
+        mStaticMembers.mPendingLock.lock();
+        
+        if( mStaticMembers.mStopping ) {
+            mStaticMembers.mPendingLock.unlock();
+            return;
+            }
+        
+        // sleep until next due write, or until woken by a new one
+        int waitMS = -1;
+        
+        SimpleVector<SettingsPendingWrite*> *pending = 
+            &( mStaticMembers.mPendingWrites );
+        
+        if( pending->size() > 0 ) {
+            double nextDueTime = pending->getElementDirectFast( 0 )->dueTime;
+            
+            for( int i=1; i<pending->size(); i++ ) {
+                double dueTime = pending->getElementDirectFast( i )->dueTime;
+                if( dueTime < nextDueTime ) {
+                    nextDueTime = dueTime;
+                    }
+                }
+            
+            double wait = nextDueTime - Time::getMonotonicTime();
+            
+            if( wait < 0 ) {
+                wait = 0;
+                }
+            
+            // round up, so we don't wake just before it's due
+            waitMS = (int)( wait * 1000 ) + 1;
+            }
+        
+        mStaticMembers.mPendingLock.unlock();
         
-        fprintf( file, "%s", inSettingValue );
         
-        fclose( file );
+        mStaticMembers.mWakeSemaphore.wait( waitMS );
+        
+        writePending( true );
         }
     }
 
 
 
+void SettingsManager::setWriteDelay( double inSeconds ) {
+    mStaticMembers.mPendingLock.lock();
+    mStaticMembers.mWriteDelay = inSeconds;
+    mStaticMembers.mPendingLock.unlock();
+    
+    if( inSeconds <= 0 ) {
+        flushAll();
+        }
+    }
+
+
+
+void SettingsManager::flushAll() {
+    writePending( false );
+    }
+
+
+
 void SettingsManager::setSetting( const char *inSettingName,
                                   float inSettingValue ) {
 
@@ -590,6 +1287,12 @@ void SettingsManager::setSetting( const char *inSettingName,
 
 FILE *SettingsManager::getSettingsFile( const char *inSettingName,
                                         const char *inReadWriteFlags ) {
+    // caller should see latest value in file
+    writePending( false, inSettingName );
+    
+    // caller may change file without us seeing contents
+    uncacheSetting( inSettingName );
+    
     char *fullFileName = getSettingsFileName( inSettingName );
     
     FILE *file = fopen( fullFileName, inReadWriteFlags );
@@ -609,44 +1312,69 @@ char *SettingsManager::getSettingsFileName( const char *inSettingName ) {
 
 char *SettingsManager::getSettingsFileName( const char *inSettingName,
                                             const char *inExtension ) {
-    char **pathSteps = new char*[1];
-
-    pathSteps[0] = mStaticMembers.mDirectoryName;
-
-    char *fileName = new char[ strlen( inSettingName ) 
-                               + strlen( inExtension )
-                               + 2 ];
+    Path *path = mStaticMembers.mDirectoryPath;
+    
+    char *fullFileName = new char[ path->getPathStringLength()
+                                   + strlen( inSettingName ) 
+                                   + strlen( inExtension )
+                                   + 2 ];
 
-    sprintf( fileName, "%s.%s", inSettingName, inExtension );
+    char *nameStart = path->appendTo( fullFileName );
     
-    File *settingsFile = new File( new Path( pathSteps, 1, false ),
-                                   fileName );
+    sprintf( nameStart, "%s.%s", inSettingName, inExtension );
+
+    return fullFileName;
+    }
 
-    delete [] fileName;
 
-    // pathSteps copied internally by Path constructor
-    delete [] pathSteps;
-    
 
-    char *fullFileName = settingsFile->getFullFileName();
+Path *SettingsManagerStaticMembers::makeDirectoryPath( 
+    const char *inDirectoryName ) {
     
-    delete settingsFile;
+    char *pathSteps[1] = { (char *)inDirectoryName };
 
-    return fullFileName;
+    return new Path( pathSteps, 1, false );
     }
 
 
 
 SettingsManagerStaticMembers::SettingsManagerStaticMembers()
     : mDirectoryName( stringDuplicate( "settings" ) ),
-      mHashSalt( stringDuplicate( "default_salt" ) ) {
+      mHashSalt( stringDuplicate( "default_salt" ) ),
+      mCacheRecheckInterval( 1.0 ),
+      mDefaultsSource( NULL ),
+      mWriteDelay( 0 ),
+      mStopping( false ),
+      mWriter( NULL ) {
     
+    mDirectoryPath = makeDirectoryPath( mDirectoryName );
     }
 
 
 
 SettingsManagerStaticMembers::~SettingsManagerStaticMembers() {
+    if( mWriter != NULL ) {
+        mPendingLock.lock();
+        mStopping = true;
+        mPendingLock.unlock();
+        
+        mWakeSemaphore.signal();
+        
+        delete mWriter;
+        mWriter = NULL;
+        }
+    
+    // in case caller didn't flush before exit
+    SettingsManager::writePending( false );
+    
     delete [] mDirectoryName;
+    delete mDirectoryPath;
     delete [] mHashSalt;
+
+    for( int i=0; i<mCache.getNumSlots(); i++ ) {
+        if( mCache.isSlotFilled( i ) ) {
+            freeCacheEntry( *( mCache.getSlotValue( i ) ) );
+            }
+        }
     }
 
@@ -44,6 +44,15 @@
  *
  * 2019-March-15    Jason Rohrer
  * Support for returning list of ints from setting.
+ *
+ * 2026-October-14    Jason Rohrer
+ * In-memory cache of setting contents, rechecked against file stamps.
+ *
+ * 2026-October-15    Jason Rohrer
+ * Defaults source (like a ResourceArchive) for settings with no file.
+ * Settings directory path kept in static members.
+ * Optional write-behind, with writes coalesced and flushed by a background
+ * thread, and files replaced by rename.
  */
 
 #include "minorGems/common.h"
@@ -56,10 +65,14 @@
 
 
 #include "minorGems/util/SimpleVector.h"
+#include "minorGems/util/HashMap.h"
 #include "minorGems/system/MutexLock.h"
+#include "minorGems/system/BinarySemaphore.h"
 
 #include "minorGems/system/Time.h"
 
+#include "minorGems/io/file/ResourceSource.h"
+
 #include <stdio.h>
 
 
@@ -67,6 +80,13 @@
 // utility class for dealing with static member dealocation
 class SettingsManagerStaticMembers;
 
+class Path;
+
+typedef struct SettingsCacheEntry SettingsCacheEntry;
+typedef struct SettingsPendingWrite SettingsPendingWrite;
+
+class SettingsWriterThread;
+
 
 
 /**
@@ -133,6 +153,69 @@ class SettingsManager {
         static void setHashingOn( char inOn );
 
 
+
+        /**
+         * Sets how often cached settings are checked against their files.
+         *
+         * Settings are kept in memory after their first read, and
+         * setSetting updates the cache as it writes.  Files changed by
+         * something else are noticed (by modification time and length)
+         * when an entry is older than this interval.
+         *
+         * @param inSeconds the interval.  0 checks on every read (still
+         *   skipping the read itself when the file is unchanged).
+         *   Negative turns caching off.  Defaults to 1 second.
+         */
+        static void setCacheRecheckInterval( double inSeconds );
+
+
+        // forgets all cached settings
+        static void clearCache();
+
+
+
+        /**
+         * Sets where to look for settings that have no file in the
+         * settings directory, like a ResourceArchive holding a game's
+         * default settings.  Files on disk always take precedence.
+         *
+         * The source is passed each settings file name (for example,
+         * "settings/fullscreen.ini"), and the same for hash files when
+         * hashing is on.
+         *
+         * @param inSource the source, or NULL for none.  Defaults to NULL.
+         *   Must be destroyed by caller after it is no longer set here.
+         */
+        static void setDefaultsSource( ResourceSource *inSource );
+
+
+
+        /**
+         * Sets how long setSetting calls wait before writing to disk.
+         *
+         * With a delay, setSetting only updates memory (reads see the new
+         * value right away), and a background thread writes the files
+         * once a setting has gone unchanged for the delay, so a burst of
+         * sets (like dragging a slider) costs one write.  A setting that
+         * keeps changing is still written at most twice the delay after
+         * its first unwritten change.
+         *
+         * Either way, files are written to a temporary file that is then
+         * renamed over the old one, so a crash never leaves half a file.
+         *
+         * Call flushAll before exit when using a delay.
+         *
+         * @param inSeconds the delay, or 0 to write before setSetting
+         *   returns.  Defaults to 0.
+         */
+        static void setWriteDelay( double inSeconds );
+
+
+        // writes all settings still waiting for their delay
+        static void flushAll();
+
+
+
         
         /**
          * Gets a setting, tokenized by whitespace into separate strings.
@@ -370,7 +453,8 @@ class SettingsManager {
         
     protected:
 
-
+        friend class SettingsWriterThread;
+        friend class SettingsManagerStaticMembers;
         
         static SettingsManagerStaticMembers mStaticMembers;
 
@@ -405,6 +489,45 @@ class SettingsManager {
          */
         static char *getSettingsFileName( const char *inSettingName,
                                           const char *inExtension );
+
+
+        // reads setting file (and checks hash), bypassing cache
+        static char *readSettingContents( const char *inSettingName );
+
+        // reads one file, trying defaults source if file missing
+        // returns NULL if not found in either
+        static char *readSettingsFile( const char *inFileName );
+
+        // gets up-to-date cache entry, loading or reloading file as needed
+        // must be called with mStaticMembers.mCacheLock held
+        // returns NULL if caching is off
+        static SettingsCacheEntry *getCacheEntry( const char *inSettingName );
+
+        // drops one cached setting
+        static void uncacheSetting( const char *inSettingName );
+
+        // sets cached contents and file stamp, if caching is on
+        // inValue NULL to only restamp an existing entry
+        // must be called with mStaticMembers.mCacheLock held
+        static void cacheSetting( const char *inSettingName,
+                                  const char *inValue );
+
+        // writes setting and hash files, each through a temporary file
+        // returns true on success
+        static char writeSettingFiles( const char *inSettingName,
+                                       const char *inValue );
+
+        // copy of a setting's value still waiting to be written,
+        // or NULL if none
+        static char *getPendingValue( const char *inSettingName );
+
+        // writes pending settings that are due (or all, if inOnlyDue is
+        // false), or only inSettingName's if non-NULL
+        static void writePending( char inOnlyDue, 
+                                  const char *inSettingName = NULL );
+
+        // runs writer thread until stopped
+        static void writerLoop();
         
     };
 
@@ -428,8 +551,33 @@ class SettingsManagerStaticMembers {
         ~SettingsManagerStaticMembers();
         
         char *mDirectoryName;
+
+        // mDirectoryName as a path, for building file names
+        Path *mDirectoryPath;
+        static Path *makeDirectoryPath( const char *inDirectoryName );
+        
         char *mHashSalt;
         
+        MutexLock mCacheLock;
+        HashMap<const char*, SettingsCacheEntry*> mCache;
+        double mCacheRecheckInterval;
+
+        ResourceSource *mDefaultsSource;
+
+
+        // held while taking and writing pending settings, so that an
+        // older value is never written after a newer one
+        MutexLock mWriteLock;
+
+        MutexLock mPendingLock;
+        SimpleVector<SettingsPendingWrite*> mPendingWrites;
+        double mWriteDelay;
+        char mStopping;
+
+        BinarySemaphore mWakeSemaphore;
+        
+        // started on first delayed write
+        SettingsWriterThread *mWriter;
 
 
     };
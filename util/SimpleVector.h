@@ -51,6 +51,12 @@
 *		Jason Rohrer	7-12-2018	push_middle function.
 *		Jason Rohrer	5-10-2019	getElementDirectFast function.
 *		Jason Rohrer	11-21-2023	getMatchingStringIndex function.
+*		Jason Rohrer	10-14-2026	Inline-capacity InlineSimpleVector subclass,
+*									configurable growth factor, and block
+*									copies for trivially-copyable types.
+*		Jason Rohrer	10-15-2026	In-place sort, stable sort, binary search,
+*									and sorted insert, templated on a
+*									comparator.
 */
 
 #include "minorGems/common.h"
@@ -66,6 +72,96 @@
 
 const int defaultStartSize = 2;
 
+const float defaultGrowthFactor = 2.0f;
+
+
+
+/**
+ * Whether a type can be copied around with memcpy/memmove instead of
+ * element-by-element assignment (no copy constructor, assignment operator,
+ * or destructor that matters).
+ *
+ * True for built-in types and pointers.  Plain structs can opt in with
+ * SIMPLE_VECTOR_TRIVIAL_TYPE( StructName ) at file scope.
+ */
+template <class Type>
+struct SimpleVectorTrivialType {
+        enum { value = false };
+    };
+
+template <class Type>
+struct SimpleVectorTrivialType<Type*> {
+        enum { value = true };
+    };
+
+
+#define SIMPLE_VECTOR_TRIVIAL_TYPE( inType ) \
+    template <> \
+    struct SimpleVectorTrivialType<inType> { \
+            enum { value = true }; \
+        };
+
+
+SIMPLE_VECTOR_TRIVIAL_TYPE( char )
+SIMPLE_VECTOR_TRIVIAL_TYPE( signed char )
+SIMPLE_VECTOR_TRIVIAL_TYPE( unsigned char )
+SIMPLE_VECTOR_TRIVIAL_TYPE( short )
+SIMPLE_VECTOR_TRIVIAL_TYPE( unsigned short )
+SIMPLE_VECTOR_TRIVIAL_TYPE( int )
+SIMPLE_VECTOR_TRIVIAL_TYPE( unsigned int )
+SIMPLE_VECTOR_TRIVIAL_TYPE( long )
+SIMPLE_VECTOR_TRIVIAL_TYPE( unsigned long )
+SIMPLE_VECTOR_TRIVIAL_TYPE( long long )
+SIMPLE_VECTOR_TRIVIAL_TYPE( unsigned long long )
+SIMPLE_VECTOR_TRIVIAL_TYPE( float )
+SIMPLE_VECTOR_TRIVIAL_TYPE( double )
+SIMPLE_VECTOR_TRIVIAL_TYPE( bool )
+
+
+
+/**
+ * Comparators for sorting and searching.
+ *
+ * A comparator is anything that can be called as inLess( a, b ) to return
+ * true if a sorts before b.  Passing a function object (rather than a
+ * function pointer, like qsort) lets the compiler inline the comparison.
+ */
+template <class Type>
+struct SimpleVectorLess {
+        bool operator()( const Type &inA, const Type &inB ) const {
+            return inA < inB;
+            }
+    };
+
+
+// for c-strings, by strcmp
+struct SimpleVectorStringLess {
+        bool operator()( const char *inA, const char *inB ) const {
+            return strcmp( inA, inB ) < 0;
+            }
+    };
+
+
+
+/**
+ * Sorts an array in place (introsort:  quicksort, switching to heapsort
+ * if partitions go badly, and insertion sort for short ranges).
+ * Not stable.  O( n log n ) worst case.
+ */
+template <class Type, class Less>
+void sortArray( Type *inArray, int inLength, Less inLess );
+
+
+/**
+ * Sorts an array, keeping equal elements in their original order
+ * (merge sort).  Allocates a buffer the size of the array.
+ */
+template <class Type, class Less>
+void stableSortArray( Type *inArray, int inLength, Less inLess );
+
+
+
+
 template <class Type>
 class SimpleVector {
 	public:
@@ -241,6 +337,17 @@ class SimpleVector {
         
 
 
+        /**
+         * Sets how much the vector grows by each time it runs out of room.
+         * Defaults to 2 (doubling).
+         *
+         * @param inFactor the multiplier for the allocated size.
+         *   Values at or below 1 still grow by at least one element.
+         */
+        void setGrowthFactor( float inFactor );
+        
+
+
 
         /**
 		 * For vectors of char* elements (c-strings).
@@ -273,7 +380,88 @@ class SimpleVector {
 
 
 
+        /**
+         * Sorts elements in place with sortArray (not stable).
+         *
+         * @param inLess the comparator (see SimpleVectorLess).
+         *   Defaults to the < operator, which compares addresses for
+         *   c-strings, so pass SimpleVectorStringLess for those.
+         */
+        template <class Less>
+        void sort( Less inLess );
+        
+        void sort();
+
+
+        // sorts with stableSortArray, keeping equal elements in order
+        template <class Less>
+        void stableSort( Less inLess );
+        
+        void stableSort();
+
+
+
+        // For vectors sorted by the same comparator (default <).
+
+        /**
+         * Gets the index of the first element that does not sort before
+         * inValue, or size() if all do.
+         */
+        template <class Less>
+        int lowerBound( Type inValue, Less inLess );
+        
+        int lowerBound( Type inValue );
+
+
+        // index of first element that sorts after inValue, or size()
+        template <class Less>
+        int upperBound( Type inValue, Less inLess );
+        
+        int upperBound( Type inValue );
+
+        
+        // index of an element equal to inValue (neither sorts before the
+        // other), or -1 if none.  O( log n ), unlike getElementIndex.
+        template <class Less>
+        int binarySearch( Type inValue, Less inLess );
+        
+        int binarySearch( Type inValue );
+
+
+        /**
+         * Inserts an element, keeping the vector sorted.  Goes after
+         * elements equal to it.
+         *
+         * @return the index the element was inserted at.
+         */
+        template <class Less>
+        int insertSorted( Type inValue, Less inLess );
+        
+        int insertSorted( Type inValue );
+
+
+
 	protected:
+        
+        // for subclasses that provide their own storage for small sizes
+        // inInlineElements is used until the vector outgrows it, and
+        // must outlive this vector
+        SimpleVector( Type *inInlineElements, int inInlineSize );
+        
+
+        // grows allocated space to at least inNeededSize
+        void expandElements( int inNeededSize );
+        
+        // frees elements, unless they are in the inline storage
+        void freeElements();
+        
+
+        // copies with memcpy when Type is trivial
+        static void copyElements( Type *inDest, const Type *inSource,
+                                  int inCount );
+        
+
+
 		Type *elements;
 		int numFilledElements;
 		int maxSize;
@@ -282,12 +470,67 @@ class SimpleVector {
 
         char printExpansionMessage;
         const char *vectorName;
+
+        // NULL if no inline storage
+        Type *inlineElements;
+        int inlineSize;
+        
+        float growthFactor;
 		};
+
+
+
+/**
+ * A SimpleVector that keeps up to inInlineSize elements inside itself,
+ * only touching the heap once it grows beyond that.
+ *
+ * Meant for small, short-lived vectors (locals, per-frame scratch lists).
+ * Can be passed anywhere a SimpleVector<Type>* is expected.
+ */
+template <class Type, int inInlineSize>
+class InlineSimpleVector : public SimpleVector<Type> {
+    public:
+        
+        InlineSimpleVector()
+                : SimpleVector<Type>( mInlineStorage, inInlineSize ) {
+            }
+        
+
+        InlineSimpleVector( const SimpleVector<Type> &inCopy )
+                : SimpleVector<Type>( mInlineStorage, inInlineSize ) {
+            SimpleVector<Type>::operator=( inCopy );
+            }
+
+
+        InlineSimpleVector( const InlineSimpleVector &inCopy )
+                : SimpleVector<Type>( mInlineStorage, inInlineSize ) {
+            SimpleVector<Type>::operator=( inCopy );
+            }
+        
+
+        // the default assignment operator would copy the other vector's
+        // storage array over ours
+        InlineSimpleVector & operator = ( const SimpleVector<Type> &inOther ) {
+            SimpleVector<Type>::operator=( inOther );
+            return *this;
+            }
+
+        InlineSimpleVector & operator = ( const InlineSimpleVector &inOther ) {
+            SimpleVector<Type>::operator=( inOther );
+            return *this;
+            }
+        
+
+    protected:
+        
+        Type mInlineStorage[ inInlineSize ];
+    };
 		
 		
 template <class Type>		
 inline SimpleVector<Type>::SimpleVector()
-		: vectorName( "" ) {
+		: vectorName( "" ), inlineElements( NULL ), inlineSize( 0 ),
+          growthFactor( defaultGrowthFactor ) {
 	elements = new Type[defaultStartSize];
 	numFilledElements = 0;
 	maxSize = defaultStartSize;
@@ -298,7 +541,8 @@ inline SimpleVector<Type>::SimpleVector()
 
 template <class Type>
 inline SimpleVector<Type>::SimpleVector(int sizeEstimate)
-		: vectorName( "" ) {
+		: vectorName( "" ), inlineElements( NULL ), inlineSize( 0 ),
+          growthFactor( defaultGrowthFactor ) {
 	elements = new Type[sizeEstimate];
 	numFilledElements = 0;
 	maxSize = sizeEstimate;
@@ -306,14 +550,94 @@ inline SimpleVector<Type>::SimpleVector(int sizeEstimate)
     
     printExpansionMessage = false;
     }
+
+
+template <class Type>
+inline SimpleVector<Type>::SimpleVector( Type *inInlineElements, 
+                                         int inInlineSize )
+		: elements( inInlineElements ), numFilledElements( 0 ),
+          maxSize( inInlineSize ), minSize( inInlineSize ),
+          printExpansionMessage( false ), vectorName( "" ),
+          inlineElements( inInlineElements ), inlineSize( inInlineSize ),
+          growthFactor( defaultGrowthFactor ) {
+    }
+
 	
 template <class Type>	
 inline SimpleVector<Type>::~SimpleVector() {
-	delete [] elements;
+	freeElements();
 	}	
 
 
 
+template <class Type>	
+inline void SimpleVector<Type>::freeElements() {
+    if( elements != inlineElements ) {
+        delete [] elements;
+        }
+	}
+
+
+
+template <class Type>	
+inline void SimpleVector<Type>::copyElements( Type *inDest, 
+                                              const Type *inSource,
+                                              int inCount ) {
+    if( SimpleVectorTrivialType<Type>::value ) {
+        memcpy( (void *)inDest, (const void *)inSource, 
+                sizeof( Type ) * inCount );
+        }
+    else {
+        // must use element-by-element assignment to invoke 
+        // assignment operators
+        for( int i=0; i<inCount; i++ ) {
+            inDest[i] = inSource[i];
+            }
+        }
+    }
+
+
+
+template <class Type>	
+inline void SimpleVector<Type>::expandElements( int inNeededSize ) {
+    if( inNeededSize <= maxSize ) {
+        return;
+        }
+    
+    int newMaxSize = maxSize;
+    
+    while( newMaxSize < inNeededSize ) {
+        int grownSize = (int)( newMaxSize * growthFactor );
+        
+        if( grownSize <= newMaxSize ) {
+            grownSize = newMaxSize + 1;
+            }
+        newMaxSize = grownSize;
+        }
+
+    if( printExpansionMessage ) {
+        printf( "SimpleVector \"%s\" is expanding itself from %d to %d"
+                " max elements\n", vectorName, maxSize, newMaxSize );
+        }
+    
+    // NOTE:  for non-trivial types, memcpy does not work here, because 
+    // it does not invoke copy constructors on elements.
+    // And then "delete []" below causes destructors to be invoked
+    //  on old elements, which are shallow copies of new objects.
+    
+    Type *newAlloc = new Type[newMaxSize];
+
+    copyElements( newAlloc, elements, numFilledElements );
+    
+    // delete old space
+    freeElements();
+    
+    elements = newAlloc;
+    maxSize = newMaxSize;	
+    }
+
+
+
 // copy constructor
 template <class Type>
 inline SimpleVector<Type>::SimpleVector( const SimpleVector<Type> &inCopy )
@@ -321,17 +645,16 @@ inline SimpleVector<Type>::SimpleVector( const SimpleVector<Type> &inCopy )
           numFilledElements( inCopy.numFilledElements ),
           maxSize( inCopy.maxSize ), minSize( inCopy.minSize ),
           printExpansionMessage( inCopy.printExpansionMessage ),
-          vectorName( inCopy.vectorName ) {
+          vectorName( inCopy.vectorName ),
+          // copy never shares the other vector's inline storage
+          inlineElements( NULL ), inlineSize( 0 ),
+          growthFactor( inCopy.growthFactor ) {
     
-    // if these objects contain pointers to stack, etc, this is not 
+    // if these objects contain pointers to stack, etc, memcpy is not 
     // going to work (not a deep copy)
     // because it won't invoke the copy constructors of the objects!
-    //memcpy( elements, inCopy.elements, sizeof( Type ) * numFilledElements );
-    
-    for( int i=0; i<inCopy.numFilledElements; i++ ) {
-        elements[i] = inCopy.elements[i];
-        }
-
+    // (copyElements only uses it for trivial types)
+    copyElements( elements, inCopy.elements, numFilledElements );
     }
 
 
@@ -346,21 +669,33 @@ inline SimpleVector<Type> & SimpleVector<Type>::operator = (
     // avoid self-assignment
     if( this != &inOther )  {
         
+        if( inlineElements != NULL && 
+            inOther.numFilledElements <= inlineSize ) {
+            // fits in our inline storage, no allocation needed
+            copyElements( inlineElements, inOther.elements, 
+                          inOther.numFilledElements );
+            freeElements();
+            
+            elements = inlineElements;
+            numFilledElements = inOther.numFilledElements;
+            maxSize = inlineSize;
+            minSize = inlineSize;
+            
+            return *this;
+            }
+        
+
         // 1: allocate new memory and copy the elements
         Type *newElements = new Type[ inOther.maxSize ];
 
-        // again, memcpy doesn't work here, because it doesn't invoke
-        // copy constructor on contained object
-        /*memcpy( newElements, inOther.elements, 
-                sizeof( Type ) * inOther.numFilledElements );
-        */
-        for( int i=0; i<inOther.numFilledElements; i++ ) {
-            newElements[i] = inOther.elements[i];
-            }
+        // again, memcpy doesn't work here for non-trivial types, because 
+        // it doesn't invoke copy constructor on contained object
+        copyElements( newElements, inOther.elements, 
+                      inOther.numFilledElements );
 
 
         // 2: deallocate old memory
-        delete [] elements;
+        freeElements();
  
         // 3: assign the new memory to the object
         elements = newElements;
@@ -446,8 +781,16 @@ inline bool SimpleVector<Type>::deleteElement(int index) {
             */
 
 
-            for( int i=index+1; i<numFilledElements; i++ ) {
-                elements[i - 1] = elements[i];
+            if( SimpleVectorTrivialType<Type>::value ) {
+                // no shallow copy problems for trivial types
+                memmove( (void *)&( elements[index] ), 
+                         (const void *)&( elements[index+1] ),
+                         sizeof( Type ) * ( numFilledElements - (index+1) ) );
+                }
+            else {
+                for( int i=index+1; i<numFilledElements; i++ ) {
+                    elements[i - 1] = elements[i];
+                    }
                 }
 			}
 			
@@ -590,9 +933,17 @@ template <class Type>
 inline void SimpleVector<Type>::deleteAll() {
 	numFilledElements = 0;
 	if( maxSize > minSize ) {		// free memory if vector has grown
-		delete [] elements;
-		elements = new Type[minSize];	// reallocate an empty vector
-		maxSize = minSize;
+		freeElements();
+        
+        if( inlineElements != NULL ) {
+            // back to inline storage
+            elements = inlineElements;
+            maxSize = inlineSize;
+            }
+        else {
+            elements = new Type[minSize];	// reallocate an empty vector
+            maxSize = minSize;
+            }
 		}
 	}
 
@@ -604,41 +955,8 @@ inline void SimpleVector<Type>::push_back(Type x)	{
 		numFilledElements++;
 		}
 	else {					// need to allocate more space for vector
-
-		int newMaxSize = maxSize << 1;		// double size
-		
-        if( printExpansionMessage ) {
-            printf( "SimpleVector \"%s\" is expanding itself from %d to %d"
-                    " max elements\n", vectorName, maxSize, newMaxSize );
-            }
-
-
-        // NOTE:  memcpy does not work here, because it does not invoke
-        // copy constructors on elements.
-        // And then "delete []" below causes destructors to be invoked
-        //  on old elements, which are shallow copies of new objects.
-
-        Type *newAlloc = new Type[newMaxSize];
-        /*
-		unsigned int sizeOfElement = sizeof(Type);
-		unsigned int numBytesToMove = sizeOfElement*(numFilledElements);
-		
-
-		// move into new space
-		memcpy((void *)newAlloc, (void *) elements, numBytesToMove);
-		*/
-
-        // must use element-by-element assignment to invoke constructors
-        for( int i=0; i<numFilledElements; i++ ) {
-            newAlloc[i] = elements[i];
-            }
         
-
-		// delete old space
-		delete [] elements;
-		
-		elements = newAlloc;
-		maxSize = newMaxSize;	
+        expandElements( numFilledElements + 1 );
 		
 		elements[numFilledElements] = x;
 		numFilledElements++;	
@@ -672,10 +990,7 @@ inline void SimpleVector<Type>::push_middle( Type x, int inNumBefore )	{
 
 template <class Type>
 inline void SimpleVector<Type>::push_back(Type *inArray, int inLength)	{
-    
-    for( int i=0; i<inLength; i++ ) {
-        push_back( inArray[i] );
-        }
+    appendArray( inArray, inLength );
     }
 
 
@@ -683,6 +998,8 @@ template <class Type>
 inline void SimpleVector<Type>::push_back_other(
     SimpleVector<Type> *inOtherVector ) {
     
+    expandElements( numFilledElements + inOtherVector->size() );
+
     for( int i=0; i<inOtherVector->size(); i++ ) {
         push_back( inOtherVector->getElementDirect( i ) );
         }
@@ -694,19 +1011,10 @@ template <class Type>
 inline Type *SimpleVector<Type>::getElementArray() {
     Type *newAlloc = new Type[ numFilledElements ];
 
-    // shallow copy not good enough!
-    /*
-    unsigned int sizeOfElement = sizeof( Type );
-    unsigned int numBytesToCopy = sizeOfElement * numFilledElements;
-    
-    // copy into new space
-    //memcpy( (void *)newAlloc, (void *)elements, numBytesToCopy );
-    */
-
-    // use assignment to ensure that constructors are invoked on element copies
-    for( int i=0; i<numFilledElements; i++ ) {
-        newAlloc[i] = elements[i];
-        }
+    // shallow copy not good enough for non-trivial types!
+    // copyElements uses assignment for those, to ensure that constructors 
+    // are invoked on element copies
+    copyElements( newAlloc, elements, numFilledElements );
 
     return newAlloc;
     }
@@ -749,11 +1057,19 @@ inline void SimpleVector<char>::setElementString( const char *inString ) {
 
 template <class Type>
 inline void SimpleVector<Type>::appendArray( Type *inArray, int inSize ) {
-    // slow but correct
+    // grow once, not once per element
+    expandElements( numFilledElements + inSize );
     
-    for( int i=0; i<inSize; i++ ) {
-        push_back( inArray[i] );
-        }
+    copyElements( &( elements[ numFilledElements ] ), inArray, inSize );
+    
+    numFilledElements += inSize;
+    }
+
+
+
+template <class Type>
+inline void SimpleVector<Type>::setGrowthFactor( float inFactor ) {
+    growthFactor = inFactor;
     }
 
 
@@ -810,4 +1126,379 @@ inline int SimpleVector<char*>::getMatchingStringIndex( char *inString ) {
 
 
 
+template <class Type, class Less>
+inline void simpleVectorInsertionSort( Type *inArray, int inStart, int inEnd,
+                                       Less &inLess ) {
+    for( int i=inStart + 1; i<inEnd; i++ ) {
+        
+        if( inLess( inArray[i], inArray[ i - 1 ] ) ) {
+            Type x = inArray[i];
+            
+            int j = i;
+            do {
+                inArray[j] = inArray[ j - 1 ];
+                j--;
+                } while( j > inStart && inLess( x, inArray[ j - 1 ] ) );
+            
+            inArray[j] = x;
+            }
+        }
+    }
+
+
+
+template <class Type, class Less>
+inline void simpleVectorSiftDown( Type *inHeap, int inRoot, int inLength,
+                                  Less &inLess ) {
+    Type x = inHeap[ inRoot ];
+    
+    int i = inRoot;
+    
+    while( true ) {
+        int child = 2 * i + 1;
+        
+        if( child >= inLength ) {
+            break;
+            }
+        if( child + 1 < inLength && 
+            inLess( inHeap[ child ], inHeap[ child + 1 ] ) ) {
+            child++;
+            }
+        if( ! inLess( x, inHeap[ child ] ) ) {
+            break;
+            }
+        inHeap[i] = inHeap[ child ];
+        i = child;
+        }
+    
+    inHeap[i] = x;
+    }
+
+
+
+template <class Type, class Less>
+inline void simpleVectorHeapSort( Type *inArray, int inLength, 
+                                  Less &inLess ) {
+    
+    for( int i=inLength / 2 - 1; i>=0; i-- ) {
+        simpleVectorSiftDown( inArray, i, inLength, inLess );
+        }
+    
+    for( int end=inLength - 1; end > 0; end-- ) {
+        Type temp = inArray[0];
+        inArray[0] = inArray[ end ];
+        inArray[ end ] = temp;
+        
+        simpleVectorSiftDown( inArray, 0, end, inLess );
+        }
+    }
+
+
+
+template <class Type>
+inline void simpleVectorSwap( Type *inArray, int inA, int inB ) {
+    Type temp = inArray[ inA ];
+    inArray[ inA ] = inArray[ inB ];
+    inArray[ inB ] = temp;
+    }
+
+
+
+// sorts [inStart,inEnd), giving up on quicksort after inDepthLimit
+// levels of bad partitions
+template <class Type, class Less>
+void simpleVectorIntroSort( Type *inArray, int inStart, int inEnd,
+                            int inDepthLimit, Less &inLess ) {
+    
+    while( inEnd - inStart > 16 ) {
+        
+        if( inDepthLimit == 0 ) {
+            simpleVectorHeapSort( &( inArray[ inStart ] ), inEnd - inStart, 
+                                  inLess );
+            return;
+            }
+        inDepthLimit--;
+        
+
+        // median of first, middle, and last as pivot, moved to start
+        // leaves an element no smaller than pivot at end, which stops
+        // the upward scan below without a bounds check
+        int mid = inStart + ( inEnd - inStart ) / 2;
+        int last = inEnd - 1;
+        
+        if( inLess( inArray[ mid ], inArray[ inStart ] ) ) {
+            simpleVectorSwap( inArray, mid, inStart );
+            }
+        if( inLess( inArray[ last ], inArray[ mid ] ) ) {
+            simpleVectorSwap( inArray, last, mid );
+            
+            if( inLess( inArray[ mid ], inArray[ inStart ] ) ) {
+                simpleVectorSwap( inArray, mid, inStart );
+                }
+            }
+        simpleVectorSwap( inArray, inStart, mid );
+        
+        Type pivot = inArray[ inStart ];
+        
+
+        // Hoare partition, stopping on equal elements from both sides
+        // so that runs of equal keys still split evenly
+        int i = inStart;
+        int j = inEnd;
+        
+        while( true ) {
+            do {
+                i++;
+                } while( inLess( inArray[i], pivot ) );
+            
+            do {
+                j--;
+                } while( inLess( pivot, inArray[j] ) );
+            
+            if( i >= j ) {
+                break;
+                }
+            simpleVectorSwap( inArray, i, j );
+            }
+        
+        simpleVectorSwap( inArray, inStart, j );
+        
+
+        // recurse into smaller side, loop on larger, 
+        // so stack depth stays O( log n )
+        if( j - inStart < inEnd - ( j + 1 ) ) {
+            simpleVectorIntroSort( inArray, inStart, j, inDepthLimit, 
+                                   inLess );
+            inStart = j + 1;
+            }
+        else {
+            simpleVectorIntroSort( inArray, j + 1, inEnd, inDepthLimit, 
+                                   inLess );
+            inEnd = j;
+            }
+        }
+    
+    simpleVectorInsertionSort( inArray, inStart, inEnd, inLess );
+    }
+
+
+
+template <class Type, class Less>
+inline void sortArray( Type *inArray, int inLength, Less inLess ) {
+    int depthLimit = 0;
+    for( int n = inLength; n > 1; n >>= 1 ) {
+        depthLimit += 2;
+        }
+    
+    simpleVectorIntroSort( inArray, 0, inLength, depthLimit, inLess );
+    }
+
+
+
+template <class Type, class Less>
+void stableSortArray( Type *inArray, int inLength, Less inLess ) {
+    
+    int runLength = 32;
+    
+    for( int start=0; start<inLength; start += runLength ) {
+        int end = start + runLength;
+        if( end > inLength ) {
+            end = inLength;
+            }
+        simpleVectorInsertionSort( inArray, start, end, inLess );
+        }
+    
+    if( inLength <= runLength ) {
+        return;
+        }
+    
+
+    // merge pairs of runs back and forth between array and buffer
+    Type *buffer = new Type[ inLength ];
+    
+    Type *from = inArray;
+    Type *to = buffer;
+    
+    for( int width = runLength; width < inLength; width *= 2 ) {
+        
+        for( int start=0; start<inLength; start += 2 * width ) {
+            int mid = start + width;
+            int end = start + 2 * width;
+            
+            if( mid > inLength ) {
+                mid = inLength;
+                }
+            if( end > inLength ) {
+                end = inLength;
+                }
+            
+            int a = start;
+            int b = mid;
+            int out = start;
+            
+            while( a < mid && b < end ) {
+                // take from right only if strictly before, for stability
+                if( inLess( from[b], from[a] ) ) {
+                    to[ out++ ] = from[ b++ ];
+                    }
+                else {
+                    to[ out++ ] = from[ a++ ];
+                    }
+                }
+            while( a < mid ) {
+                to[ out++ ] = from[ a++ ];
+                }
+            while( b < end ) {
+                to[ out++ ] = from[ b++ ];
+                }
+            }
+        
+        Type *temp = from;
+        from = to;
+        to = temp;
+        }
+    
+    if( from != inArray ) {
+        if( SimpleVectorTrivialType<Type>::value ) {
+            memcpy( (void*)inArray, (void*)from, inLength * sizeof( Type ) );
+            }
+        else {
+            for( int i=0; i<inLength; i++ ) {
+                inArray[i] = from[i];
+                }
+            }
+        }
+    
+    delete [] buffer;
+    }
+
+
+
+template <class Type>
+template <class Less>
+inline void SimpleVector<Type>::sort( Less inLess ) {
+    sortArray( elements, numFilledElements, inLess );
+    }
+
+
+
+template <class Type>
+inline void SimpleVector<Type>::sort() {
+    sort( SimpleVectorLess<Type>() );
+    }
+
+
+
+template <class Type>
+template <class Less>
+inline void SimpleVector<Type>::stableSort( Less inLess ) {
+    stableSortArray( elements, numFilledElements, inLess );
+    }
+
+
+
+template <class Type>
+inline void SimpleVector<Type>::stableSort() {
+    stableSort( SimpleVectorLess<Type>() );
+    }
+
+
+
+template <class Type>
+template <class Less>
+inline int SimpleVector<Type>::lowerBound( Type inValue, Less inLess ) {
+    int low = 0;
+    int high = numFilledElements;
+    
+    while( low < high ) {
+        int mid = low + ( high - low ) / 2;
+        
+        if( inLess( elements[ mid ], inValue ) ) {
+            low = mid + 1;
+            }
+        else {
+            high = mid;
+            }
+        }
+    return low;
+    }
+
+
+
+template <class Type>
+inline int SimpleVector<Type>::lowerBound( Type inValue ) {
+    return lowerBound( inValue, SimpleVectorLess<Type>() );
+    }
+
+
+
+template <class Type>
+template <class Less>
+inline int SimpleVector<Type>::upperBound( Type inValue, Less inLess ) {
+    int low = 0;
+    int high = numFilledElements;
+    
+    while( low < high ) {
+        int mid = low + ( high - low ) / 2;
+        
+        if( inLess( inValue, elements[ mid ] ) ) {
+            high = mid;
+            }
+        else {
+            low = mid + 1;
+            }
+        }
+    return low;
+    }
+
+
+
+template <class Type>
+inline int SimpleVector<Type>::upperBound( Type inValue ) {
+    return upperBound( inValue, SimpleVectorLess<Type>() );
+    }
+
+
+
+template <class Type>
+template <class Less>
+inline int SimpleVector<Type>::binarySearch( Type inValue, Less inLess ) {
+    int i = lowerBound( inValue, inLess );
+    
+    if( i < numFilledElements && ! inLess( inValue, elements[i] ) ) {
+        return i;
+        }
+    return -1;
+    }
+
+
+
+template <class Type>
+inline int SimpleVector<Type>::binarySearch( Type inValue ) {
+    return binarySearch( inValue, SimpleVectorLess<Type>() );
+    }
+
+
+
+template <class Type>
+template <class Less>
+inline int SimpleVector<Type>::insertSorted( Type inValue, Less inLess ) {
+    int i = upperBound( inValue, inLess );
+    
+    push_middle( inValue, i );
+    
+    return i;
+    }
+
+
+
+template <class Type>
+inline int SimpleVector<Type>::insertSorted( Type inValue ) {
+    return insertSorted( inValue, SimpleVectorLess<Type>() );
+    }
+
+
+
+
+
 #endif
@@ -6,16 +6,34 @@
  *
  * 2004-May-9  Jason Rohrer
  * Added function for getting data as a byte array.
+ *
+ * 2026-October-14  Jason Rohrer
+ * Write appends whole buffer at once instead of byte by byte.
+ *
+ * 2026-October-15  Jason Rohrer
+ * Stores data in a list of chunks, so written data is never moved.
+ * getString copies with memcpy instead of byte by byte.
  */
 
 
 
 #include "minorGems/util/StringBufferOutputStream.h"
 
+#include <string.h>
+
+
+
+// first chunk is small, since many streams only hold a short string
+#define FIRST_CHUNK_SIZE 256
+
+// chunks double in size up to this, after which growth is linear
+#define MAX_CHUNK_SIZE 1048576
+
 
 
 StringBufferOutputStream::StringBufferOutputStream()
-    : mCharacterVector( new SimpleVector<unsigned char>() ) {
+    : mLastChunkSize( 0 ),
+      mNumBytes( 0 ) {
 
     }
 
@@ -23,21 +41,34 @@ StringBufferOutputStream::StringBufferOutputStream()
 
 StringBufferOutputStream::~StringBufferOutputStream() {
 
-    delete mCharacterVector;
+    for( int i=0; i<mChunks.size(); i++ ) {
+        delete [] mChunks.getElementDirect( i );
+        }
     }
 
 
 
-char *StringBufferOutputStream::getString() {
+void StringBufferOutputStream::copyChunks( unsigned char *outBytes ) {
+    int numCopied = 0;
+    
+    for( int i=0; i<mChunks.size(); i++ ) {
+        int length = mChunkLengths.getElementDirect( i );
+        
+        memcpy( &( outBytes[ numCopied ] ), mChunks.getElementDirect( i ),
+                length );
+        numCopied += length;
+        }
+    }
 
-    int numChars = mCharacterVector->size();
 
-    char *returnArray = new char[ numChars + 1 ];
 
-    for( int i=0; i<numChars; i++ ) {
-        returnArray[i] = (char)( *( mCharacterVector->getElement( i ) ) );
-        }
-    returnArray[ numChars ] = '\0';
+char *StringBufferOutputStream::getString() {
+
+    char *returnArray = new char[ mNumBytes + 1 ];
+
+    copyChunks( (unsigned char *)returnArray );
+    
+    returnArray[ mNumBytes ] = '\0';
 
     return returnArray;
     }
@@ -45,9 +76,34 @@ char *StringBufferOutputStream::getString() {
 
 
 unsigned char *StringBufferOutputStream::getBytes( int *outNumBytes ) {
-    *outNumBytes = mCharacterVector->size();
+    *outNumBytes = mNumBytes;
+
+    unsigned char *returnArray = new unsigned char[ mNumBytes ];
 
-    return mCharacterVector->getElementArray();
+    copyChunks( returnArray );
+    
+    return returnArray;
+    }
+
+
+
+int StringBufferOutputStream::getNumBytes() {
+    return mNumBytes;
+    }
+
+
+
+int StringBufferOutputStream::getNumChunks() {
+    return mChunks.size();
+    }
+
+
+
+unsigned char *StringBufferOutputStream::getChunk( int inIndex,
+                                                   int *outLength ) {
+    *outLength = mChunkLengths.getElementDirect( inIndex );
+    
+    return mChunks.getElementDirect( inIndex );
     }
 
 
@@ -55,10 +111,57 @@ unsigned char *StringBufferOutputStream::getBytes( int *outNumBytes ) {
 long StringBufferOutputStream::write( unsigned char *inBuffer,
                                       long inNumBytes ) {
 
-    for( int i=0; i<inNumBytes; i++ ) {
-        mCharacterVector->push_back( inBuffer[ i ] );
+    int numLeft = (int)inNumBytes;
+    
+    while( numLeft > 0 ) {
+        int numChunks = mChunks.size();
+        
+        int lastLength = 0;
+        if( numChunks > 0 ) {
+            lastLength = mChunkLengths.getElementDirect( numChunks - 1 );
+            }
+        
+        int numFree = mLastChunkSize - lastLength;
+        
+        if( numFree == 0 ) {
+            // start a new chunk, big enough for rest of this write
+            int newSize = FIRST_CHUNK_SIZE;
+            
+            if( numChunks > 0 ) {
+                newSize = mLastChunkSize * 2;
+                
+                if( newSize > MAX_CHUNK_SIZE ) {
+                    newSize = MAX_CHUNK_SIZE;
+                    }
+                }
+            
+            if( newSize < numLeft ) {
+                newSize = numLeft;
+                }
+            
+            mChunks.push_back( new unsigned char[ newSize ] );
+            mChunkLengths.push_back( 0 );
+            mLastChunkSize = newSize;
+            
+            numChunks++;
+            lastLength = 0;
+            numFree = newSize;
+            }
+        
+        int numToCopy = numLeft;
+        if( numToCopy > numFree ) {
+            numToCopy = numFree;
+            }
+        
+        memcpy( &( mChunks.getElementDirect( numChunks - 1 )[ lastLength ] ),
+                &( inBuffer[ inNumBytes - numLeft ] ), numToCopy );
+        
+        *( mChunkLengths.getElement( numChunks - 1 ) ) = 
+            lastLength + numToCopy;
+        
+        numLeft -= numToCopy;
+        mNumBytes += numToCopy;
         }
     
     return inNumBytes;
     }
-
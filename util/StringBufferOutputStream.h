@@ -6,6 +6,10 @@
  *
  * 2004-May-9  Jason Rohrer
  * Added function for getting data as a byte array.
+ *
+ * 2026-October-15  Jason Rohrer
+ * Stores data in a list of chunks, so written data is never moved.
+ * Added functions for getting chunks without copying.
  */
 
 #include "minorGems/common.h"
@@ -25,6 +29,11 @@
 /**
  * An output stream that fills a string buffer.
  *
+ * Data is kept in a list of chunks that grow in size as more is written,
+ * so writing never moves data that is already buffered.  Chunks can be
+ * read in place (for example, to send with Socket::sendv), and data is
+ * only copied into one array by getString and getBytes.
+ *
  * @author Jason Rohrer
  */ 
 class StringBufferOutputStream : public OutputStream {
@@ -65,6 +74,37 @@ class StringBufferOutputStream : public OutputStream {
         unsigned char *getBytes( int *outNumBytes );
 
 
+
+        // gets the number of bytes written to this stream
+        int getNumBytes();
+
+
+
+        /**
+         * Gets the data written to this stream, in place, as a series of
+         * chunks.
+         *
+         * @return the number of chunks.
+         */
+        int getNumChunks();
+
+
+        /**
+         * Gets one chunk of written data.
+         *
+         * @param inIndex the chunk number, in [0, getNumChunks() - 1].
+         * @param outLength pointer to where the chunk length should be
+         *   returned.  The last chunk grows with later writes, but
+         *   the others do not.
+         *
+         * @return the chunk data.  Stays valid until this stream is
+         *   destroyed.  Destroyed by this stream.
+         */
+        unsigned char *getChunk( int inIndex, int *outLength );
+
+
+
+
         
 		// implements the OutputStream interface
 		long write( unsigned char *inBuffer, long inNumBytes );
@@ -75,7 +115,19 @@ class StringBufferOutputStream : public OutputStream {
 
 
         
-        SimpleVector<unsigned char> *mCharacterVector;
+        SimpleVector<unsigned char *> mChunks;
+
+        // amount of data in each chunk
+        SimpleVector<int> mChunkLengths;
+
+        // space allocated for last chunk
+        int mLastChunkSize;
+
+        int mNumBytes;
+
+
+        // copies data from chunks into an array of getNumBytes() bytes
+        void copyChunks( unsigned char *outBytes );
 
 
         
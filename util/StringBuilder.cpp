@@ -0,0 +1,123 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14   Jason Rohrer
+ * Created.
+ */
+
+
+
+#include "StringBuilder.h"
+
+
+#include <stdio.h>
+
+
+
+// visual studio doesn't have va_copy
+#ifndef va_copy
+    #define va_copy( dest, src ) ( dest = src )
+#endif
+
+
+
+StringBuilder::StringBuilder()
+        : mBuffer( mInline ), mLength( 0 ), mCapacity( INLINE_CAPACITY ) {
+    mInline[0] = '\0';
+    }
+
+
+
+StringBuilder::~StringBuilder() {
+    if( mBuffer != mInline ) {
+        delete [] mBuffer;
+        }
+    }
+
+
+
+void StringBuilder::appendInt( int inInt ) {
+    // enough for sign and 10 digits
+    char digits[12];
+
+    // print backwards from end
+    int i = 11;
+    
+    // unsigned, so INT_MIN negates correctly
+    unsigned int value = (unsigned int)inInt;
+    
+    if( inInt < 0 ) {
+        value = 0U - value;
+        }
+
+    do {
+        i--;
+        digits[i] = (char)( '0' + value % 10 );
+        value /= 10;
+        } while( value > 0 );
+
+    if( inInt < 0 ) {
+        i--;
+        digits[i] = '-';
+        }
+
+    append( &( digits[i] ), 11 - i );
+    }
+
+
+
+void StringBuilder::appendFormat( const char *inFormatString, ... ) {
+    va_list argList;
+    va_start( argList, inFormatString );
+    
+    vappendFormat( inFormatString, argList );
+    
+    va_end( argList );
+    }
+
+
+
+void StringBuilder::vappendFormat( const char *inFormatString, 
+                                   va_list inArgList ) {
+    
+    while( true ) {
+        int room = mCapacity - mLength;
+        
+        va_list argListCopy;
+        va_copy( argListCopy, inArgList );
+
+        int stringLength = 
+            vsnprintf( &( mBuffer[ mLength ] ), room, 
+                       inFormatString, argListCopy );
+        
+        va_end( argListCopy );
+
+        if( stringLength >= 0 && stringLength < room ) {
+            // fit, printed straight into place
+            mLength += stringLength;
+            return;
+            }
+        
+        // vsnprintf may have written a partial string, cut it back off
+        mBuffer[ mLength ] = '\0';
+
+        if( stringLength >= 0 ) {
+            // C99, we know exactly what's needed
+            reserve( mLength + stringLength );
+            }
+        else {
+            // old ANSI (or buggy MinGW) vsnprintf, -1 means too small
+            reserve( mCapacity * 2 );
+            }
+        }
+    }
+
+
+
+char *StringBuilder::getNewString() {
+    char *returnString = new char[ mLength + 1 ];
+
+    memcpy( returnString, mBuffer, mLength + 1 );
+
+    return returnString;
+    }
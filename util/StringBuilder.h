@@ -0,0 +1,211 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14   Jason Rohrer
+ * Created.
+ */
+
+#include "minorGems/common.h"
+
+
+
+#ifndef STRING_BUILDER_INCLUDED
+#define STRING_BUILDER_INCLUDED
+
+
+#include <stdarg.h>
+#include <string.h>
+
+
+
+/**
+ * Builds up a \0-terminated string in place.
+ *
+ * Short strings live in a buffer inside the builder itself, so a builder
+ * on the stack assembles most messages without touching the heap.  Longer
+ * strings spill into a heap buffer that grows by doubling.
+ *
+ * Unlike chains of autoSprintf and concatonate, no intermediate strings
+ * are allocated:  each append writes straight onto the end.
+ *
+ * Usage:
+ *   StringBuilder b;
+ *   b.appendFormat( "MX\n%d %d", x, y );
+ *   b.append( "#" );
+ *   sendMessage( b.getString(), b.getLength() );
+ *
+ * Not thread-safe.
+ *
+ * @author Jason Rohrer
+ */
+class StringBuilder {
+
+	public:
+
+		StringBuilder();
+
+		~StringBuilder();
+
+
+		// appends a \0-terminated string
+		void append( const char *inString );
+
+		// appends the first inLength characters of inString
+		void append( const char *inString, int inLength );
+
+		void appendChar( char inChar );
+
+		void appendInt( int inInt );
+
+
+		// appends printf-style formatted output
+		void appendFormat( const char *inFormatString, ... );
+
+		// same as above, but takes a va_list directly
+		void vappendFormat( const char *inFormatString, va_list inArgList );
+
+
+		/**
+		 * Gets the string built so far.
+		 *
+		 * @return the \0-terminated string.
+		 *   Valid only until the next append, clear, or destruction.
+		 *   Must NOT be destroyed by caller.
+		 */
+		const char *getString();
+
+
+		int getLength();
+
+
+		/**
+		 * Gets a copy of the string built so far, sized to fit.
+		 *
+		 * @return a newly allocated string.
+		 *   Must be destroyed by caller.
+		 */
+		char *getNewString();
+
+
+		// shortens string to inLength characters (if it is longer)
+		void truncate( int inLength );
+
+
+		// empties string, keeping allocated space for re-use
+		void clear();
+
+
+		// makes sure at least inLength characters fit without growing
+		void reserve( int inLength );
+
+
+
+	protected:
+
+		enum { INLINE_CAPACITY = 256 };
+
+		char mInline[ INLINE_CAPACITY ];
+
+		// either mInline or a heap buffer
+		char *mBuffer;
+
+		// not counting terminating \0
+		int mLength;
+
+		// including room for terminating \0
+		int mCapacity;
+
+
+	private:
+
+		// not copyable (would share heap buffer)
+		StringBuilder( const StringBuilder &inCopy );
+		StringBuilder & operator = ( const StringBuilder &inOther );
+
+	};
+
+
+
+inline void StringBuilder::reserve( int inLength ) {
+	if( inLength + 1 <= mCapacity ) {
+		return;
+		}
+
+	int newCapacity = mCapacity;
+
+	while( newCapacity < inLength + 1 ) {
+		newCapacity *= 2;
+		}
+
+	char *newBuffer = new char[ newCapacity ];
+
+	memcpy( newBuffer, mBuffer, mLength + 1 );
+
+	if( mBuffer != mInline ) {
+		delete [] mBuffer;
+		}
+
+	mBuffer = newBuffer;
+	mCapacity = newCapacity;
+	}
+
+
+
+inline void StringBuilder::append( const char *inString, int inLength ) {
+	reserve( mLength + inLength );
+
+	memcpy( &( mBuffer[ mLength ] ), inString, inLength );
+
+	mLength += inLength;
+	mBuffer[ mLength ] = '\0';
+	}
+
+
+
+inline void StringBuilder::append( const char *inString ) {
+	append( inString, strlen( inString ) );
+	}
+
+
+
+inline void StringBuilder::appendChar( char inChar ) {
+	if( mLength + 2 > mCapacity ) {
+		reserve( mLength + 1 );
+		}
+
+	mBuffer[ mLength ] = inChar;
+
+	mLength++;
+	mBuffer[ mLength ] = '\0';
+	}
+
+
+
+inline const char *StringBuilder::getString() {
+	return mBuffer;
+	}
+
+
+
+inline int StringBuilder::getLength() {
+	return mLength;
+	}
+
+
+
+inline void StringBuilder::truncate( int inLength ) {
+	if( inLength < mLength ) {
+		mLength = inLength;
+		mBuffer[ mLength ] = '\0';
+		}
+	}
+
+
+
+inline void StringBuilder::clear() {
+	truncate( 0 );
+	}
+
+
+
+#endif
@@ -1,14 +1,13 @@
 #include "StringTree.h"
 
 #include "minorGems/util/SimpleVector.h"
+#include "minorGems/util/HashMap.h"
+#include "minorGems/util/PoolAllocator.h"
 #include "minorGems/util/stringUtils.h"
 
 
 #include <stdio.h>
 
-// for platform-independent ptr -> unsigned int casting
-#include <stdint.h>
-
 
 
 typedef struct valueHolder {
@@ -17,90 +16,16 @@ typedef struct valueHolder {
     } valueHolder;
 
 
-#define B 2000
-
-class ValueHashTable {
-    public:
-        
-        ~ValueHashTable();
-        
-        void insert( valueHolder *inHolder );
-        
-        void remove( valueHolder *inHolder );
-        
-        valueHolder *lookup( void *inValue );
-
-    protected:
-        
-        SimpleVector<valueHolder *> mBins[B];
-        
-    };
-
-
-
-ValueHashTable::~ValueHashTable() {
-    for( int b=0; b<B; b++ ) {
-        SimpleVector<valueHolder *> *v = &( mBins[b] );
-        
-        int numHits = v->size();
-        
-        for( int i=0; i<numHits; i++ ) {
-            delete *( v->getElement( i ) );
-            }
-        }
-    }
-
-        
-        
-void ValueHashTable::insert( valueHolder *inHolder ) {
-    int b = (uintptr_t)( inHolder->value ) % B;
-    
-    mBins[b].push_back( inHolder );
-    }
-
-
-
-void ValueHashTable::remove( valueHolder *inHolder ) {
-    int b = (uintptr_t)( inHolder->value ) % B;
-    
-    mBins[b].deleteElementEqualTo( inHolder );
-    }
-
-
-        
-valueHolder *ValueHashTable::lookup( void *inValue ) {
-    int b = (uintptr_t)( inValue ) % B;
-    
-    SimpleVector<valueHolder *> *v = &( mBins[b] );
-    
-    int numHits = v->size();
-    
-    for( int i=0; i<numHits; i++ ) {
-        valueHolder *holder = *( v->getElement( i ) );
-
-        if( holder->value == inValue ) {
-            return holder;
-            }
-        }
-
-    return NULL;
-    }
-
-
-
-
-
-
 
 class StringTreeNode {
     public:
-        StringTreeNode( char inChar, StringTreeNode *inParent );
+        StringTreeNode( char inChar, StringTreeNode *inParent,
+                        StringTreeStorage *inStorage );
         
         ~StringTreeNode();
         
 
-        void insert( const char *inString, void *inValue,
-                     ValueHashTable *inHashTable );
+        void insert( const char *inString, void *inValue );
         
 
         // removes value at this node, and recursively deletes upward if
@@ -135,7 +60,9 @@ class StringTreeNode {
         void print();
         
         char mChar;
-        SimpleVector<valueHolder*> mValues;
+        
+        // most nodes hold no values or only a few
+        InlineSimpleVector<valueHolder*, 2> mValues;
         
         StringTreeNode *mParent;
         
@@ -147,37 +74,63 @@ class StringTreeNode {
         
         void removeChild( StringTreeNode *inChild );
         
+        // new node from pool
+        StringTreeNode *makeNode( char inChar );
         
+        StringTreeStorage *mStorage;
     };
 
 
 
-StringTreeNode::StringTreeNode( char inChar, StringTreeNode *inParent )
+// everything a tree allocates in bulk
+class StringTreeStorage {
+    public:
+        
+        // holders for each value, indexed by value pointer
+        HashMap<void *, valueHolder *> mValueIndex;
+        
+        PoolAllocator<valueHolder> mHolderPool;
+        
+        PoolAllocator<StringTreeNode> mNodePool;
+    };
+
+
+
+
+StringTreeNode::StringTreeNode( char inChar, StringTreeNode *inParent,
+                                StringTreeStorage *inStorage )
         : mChar( inChar ),
-          mParent( inParent ), mLeft( NULL ), mDown( NULL), mRight( NULL ) {
+          mParent( inParent ), mLeft( NULL ), mDown( NULL), mRight( NULL ),
+          mStorage( inStorage ) {
     }
 
 
         
 StringTreeNode::~StringTreeNode() {
     if( mLeft != NULL ) {
-        delete mLeft;
+        mStorage->mNodePool.destroy( mLeft );
         }
     if( mDown != NULL ) {
-        delete mDown;
+        mStorage->mNodePool.destroy( mDown );
         }
     if( mRight != NULL ) {
-        delete mRight;
+        mStorage->mNodePool.destroy( mRight );
         }
     }
 
 
 
+StringTreeNode *StringTreeNode::makeNode( char inChar ) {
+    return new( mStorage->mNodePool.allocate() ) 
+        StringTreeNode( inChar, this, mStorage );
+    }
+
+
+
 extern void printResourceRecord( void *inR );
 
 
-void StringTreeNode::insert( const char *inString, void *inValue,
-                             ValueHashTable *inHashTable ) {
+void StringTreeNode::insert( const char *inString, void *inValue ) {
     
     if( inString[0] == mChar ) {
         // match
@@ -185,13 +138,13 @@ void StringTreeNode::insert( const char *inString, void *inValue,
         if( inString[1] == '\0' ) {
 
             // ends here
-            valueHolder *v = inHashTable->lookup( inValue );
+            valueHolder *v;
             
-            if( v == NULL ) {
-                v = new valueHolder;
+            if( ! mStorage->mValueIndex.lookup( inValue, &v ) ) {
+                v = new( mStorage->mHolderPool.allocate() ) valueHolder;
                 v->value = inValue;
                 v->mark = false;
-                inHashTable->insert( v );
+                mStorage->mValueIndex.insert( inValue, v );
                 }
             
             mValues.push_back( v );
@@ -201,10 +154,10 @@ void StringTreeNode::insert( const char *inString, void *inValue,
             
             if( mDown == NULL ) {
                 // create it
-                mDown = new StringTreeNode( inString[1], this );
+                mDown = makeNode( inString[1] );
                 }
             
-            mDown->insert( &( inString[1] ), inValue, inHashTable );
+            mDown->insert( &( inString[1] ), inValue );
             }
         }
     else {
@@ -213,18 +166,18 @@ void StringTreeNode::insert( const char *inString, void *inValue,
         if( inString[0] < mChar ) {
             // left    
             if( mLeft == NULL ) {
-                mLeft = new StringTreeNode( inString[0], this );
+                mLeft = makeNode( inString[0] );
                 }
             
-            mLeft->insert( inString, inValue, inHashTable );
+            mLeft->insert( inString, inValue );
             }
         else if( inString[0] > mChar ) {
             // right    
             if( mRight == NULL ) {
-                mRight = new StringTreeNode( inString[0], this );
+                mRight = makeNode( inString[0] );
                 }
             
-            mRight->insert( inString, inValue, inHashTable );
+            mRight->insert( inString, inValue );
             }
         }
     }
@@ -263,15 +216,15 @@ void StringTreeNode::remove( valueHolder *inHolder ) {
 void StringTreeNode::removeChild( StringTreeNode *inChild ) {
 
     if( mLeft == inChild ) {
-        delete mLeft;
+        mStorage->mNodePool.destroy( mLeft );
         mLeft = NULL;
         }
     if( mDown == inChild ) {
-        delete mDown;
+        mStorage->mNodePool.destroy( mDown );
         mDown = NULL;
         }
     if( mRight == inChild ) {
-        delete mRight;
+        mStorage->mNodePool.destroy( mRight );
         mRight = NULL;
         }
     
@@ -515,22 +468,24 @@ void StringTreeNode::print() {
 
 StringTree::StringTree()
         : mTreeRoot( NULL ),
-          mHashTable( new ValueHashTable ) {
+          mStorage( new StringTreeStorage ) {
     }
 
         
 StringTree::~StringTree() {
     if( mTreeRoot != NULL ) {
-        delete mTreeRoot;
+        mStorage->mNodePool.destroy( mTreeRoot );
         }
-    delete mHashTable;
+    // holders are plain structs, freed along with their pool
+    delete mStorage;
     }
 
         
 
 void StringTree::insert( const char *inString, void *inValue ) {
     if( mTreeRoot == NULL ) {
-        mTreeRoot = new StringTreeNode( inString[0], NULL );
+        mTreeRoot = new( mStorage->mNodePool.allocate() ) 
+            StringTreeNode( inString[0], NULL, mStorage );
         }
     
 
@@ -539,7 +494,7 @@ void StringTree::insert( const char *inString, void *inValue ) {
 
     
     for( int i=0; i<numChars; i++ ) {    
-        mTreeRoot->insert( &( inString[i] ), inValue, mHashTable );
+        mTreeRoot->insert( &( inString[i] ), inValue );
         }
     
     /*
@@ -556,9 +511,9 @@ void StringTree::remove( const char *inString, void *inValue ) {
         return;
         }
 
-    valueHolder *holder = mHashTable->lookup( inValue );
+    valueHolder *holder;
     
-    if( holder != NULL ) {
+    if( mStorage->mValueIndex.lookup( inValue, &holder ) ) {
         
     
         // search for all suffixes to find nodes that hold our value
@@ -573,13 +528,13 @@ void StringTree::remove( const char *inString, void *inValue ) {
                 matchNode->remove( holder );
                 }
             }
-        mHashTable->remove( holder );
+        mStorage->mValueIndex.remove( inValue );
 
-        delete holder;
+        mStorage->mHolderPool.release( holder );
         }
 
     if( mTreeRoot->isEmpty() ) {
-        delete mTreeRoot;
+        mStorage->mNodePool.destroy( mTreeRoot );
         mTreeRoot = NULL;
         }
     
@@ -1,7 +1,7 @@
 
 
 class StringTreeNode;
-class ValueHashTable;
+class StringTreeStorage;
 
 
 
@@ -35,5 +35,6 @@ class StringTree {
         
         StringTreeNode *mTreeRoot;
         
-        ValueHashTable *mHashTable;
+        // node and value storage, and value index
+        StringTreeStorage *mStorage;
     };
@@ -0,0 +1,107 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14   Jason Rohrer
+ * Created.
+ */
+
+
+
+#ifndef TOKEN_BUCKET_INCLUDED
+#define TOKEN_BUCKET_INCLUDED
+
+
+
+/**
+ * Token bucket rate limit.
+ *
+ * Tokens build up at a steady rate, to at most a burst size, and each
+ * event takes one, so events can come in bursts but not exceed the rate
+ * on average.
+ *
+ * The rate and burst size are passed in to each call, rather than
+ * stored, so that a large table of buckets sharing one limit stays
+ * small.  Times are in seconds (see Time::getCurrentTime).
+ *
+ * Not thread-safe.
+ *
+ * @author Jason Rohrer
+ */
+class TokenBucket {
+
+    public:
+
+
+        // fills bucket to inBurst tokens
+        void reset( double inBurst, double inCurrentTime ) {
+            mTokens = inBurst;
+            mLastTime = inCurrentTime;
+            }
+        
+
+        
+        /**
+         * Takes a token, if one is available.
+         *
+         * @return true if token taken, or false if event should be
+         *   limited.
+         */
+        char take( double inRatePerSecond, double inBurst,
+                   double inCurrentTime ) {
+            refill( inRatePerSecond, inBurst, inCurrentTime );
+            
+            if( mTokens < 1 ) {
+                return false;
+                }
+            
+            mTokens -= 1;
+            return true;
+            }
+
+        
+
+        // seconds until a token is available, or 0 if one is now
+        double getWaitSeconds( double inRatePerSecond, double inBurst,
+                               double inCurrentTime ) {
+            refill( inRatePerSecond, inBurst, inCurrentTime );
+            
+            if( mTokens >= 1 ) {
+                return 0;
+                }
+            
+            return ( 1 - mTokens ) / inRatePerSecond;
+            }
+        
+        
+
+        double mTokens;
+
+        // when mTokens was last brought up to date
+        double mLastTime;
+
+        
+
+    protected:
+
+        void refill( double inRatePerSecond, double inBurst,
+                     double inCurrentTime ) {
+            
+            double elapsed = inCurrentTime - mLastTime;
+
+            // ignore clock stepping backward
+            if( elapsed > 0 ) {
+                mTokens += elapsed * inRatePerSecond;
+                }
+            
+            if( mTokens > inBurst ) {
+                mTokens = inBurst;
+                }
+            
+            mLastTime = inCurrentTime;
+            }
+        
+    };
+
+
+
+#endif
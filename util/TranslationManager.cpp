@@ -18,6 +18,9 @@
  *
  * 2015-May-12    Jason Rohrer
  * Support for alternate languages that add keys to a language.
+ *
+ * 2026-October-14    Jason Rohrer
+ * Hashed lookup, key handles, and loading languages in the background.
  */
 
 #include "TranslationManager.h"
@@ -25,6 +28,175 @@
 #include <stdio.h>
 
 #include "minorGems/io/file/File.h"
+#include "minorGems/system/Thread.h"
+#include "minorGems/system/atomicOps.h"
+
+
+
+// one language's strings, by key
+class TranslationTable {
+    public:
+        
+        ~TranslationTable();
+        
+        // parses language file contents
+        // keys already in table keep their current strings
+        void addData( const char *inData );
+
+        // takes strings from inOther for keys missing here
+        // (inOther keeps the rest)
+        void addMissingFrom( TranslationTable *inOther );
+        
+        // NULL if no string for key
+        const char *lookup( const char *inKey );
+        
+
+        // strings by TranslationManager key handle, bound on first use
+        // NULL if key has no string in this table
+        SimpleVector<const char*> mByHandle;
+        
+    protected:
+        
+        // strings owned by table
+        HashMap<const char*, char*> mStrings;
+    };
+
+
+
+TranslationTable::~TranslationTable() {
+    for( int i=0; i<mStrings.getNumSlots(); i++ ) {
+        if( mStrings.isSlotFilled( i ) ) {
+            char *string = *( mStrings.getSlotValue( i ) );
+            
+            if( string != NULL ) {
+                delete [] string;
+                }
+            }
+        }
+    }
+
+
+
+void TranslationTable::addMissingFrom( TranslationTable *inOther ) {
+    HashMap<const char*, char*> *other = &( inOther->mStrings );
+    
+    for( int i=0; i<other->getNumSlots(); i++ ) {
+        if( other->isSlotFilled( i ) ) {
+            const char *key = other->getSlotKey( i );
+            char **string = other->getSlotValue( i );
+            
+            if( *string != NULL && ! mStrings.contains( key ) ) {
+                mStrings.insert( key, *string );
+                
+                // ours now
+                *string = NULL;
+                }
+            }
+        }
+    
+    // some handles may now have strings
+    mByHandle.deleteAll();
+    }
+
+
+
+const char *TranslationTable::lookup( const char *inKey ) {
+    char *string = NULL;
+    
+    mStrings.lookup( inKey, &string );
+    
+    return string;
+    }
+
+
+
+// reads a language file
+// returns NULL if file can't be read
+static TranslationTable *readLanguageFile( const char *inDirectoryName,
+                                           const char *inLanguageName ) {
+    TranslationTable *table = NULL;
+    
+    File *directoryFile = new File( NULL, inDirectoryName );
+
+    if( directoryFile->exists() && directoryFile->isDirectory() ) {
+
+        char *languageFileName = autoSprintf( "%s.txt", inLanguageName );
+        
+        File *languageFile = directoryFile->getChildFile( languageFileName );
+
+        delete [] languageFileName;
+
+
+        if( languageFile != NULL ) {
+
+
+            char *languageData = languageFile->readFileContents();
+            
+            if( languageData != NULL ) {
+                
+                table = new TranslationTable;
+                table->addData( languageData );
+                
+                delete [] languageData;
+                }
+            delete languageFile;
+            }
+        }
+
+    delete directoryFile;
+
+    return table;
+    }
+
+
+
+class TranslationLoaderThread : public Thread {
+    public:
+        
+        // starts loading right away
+        TranslationLoaderThread( const char *inDirectoryName,
+                                 const char *inLanguageName,
+                                 char inClearOldKeys,
+                                 volatile int *inDoneFlag )
+                : mDirectoryName( stringDuplicate( inDirectoryName ) ),
+                  mLanguageName( stringDuplicate( inLanguageName ) ),
+                  mClearOldKeys( inClearOldKeys ),
+                  mTable( NULL ),
+                  mDoneFlag( inDoneFlag ) {
+            start();
+            }
+        
+
+        // must be joined first
+        ~TranslationLoaderThread() {
+            delete [] mDirectoryName;
+            delete [] mLanguageName;
+            
+            if( mTable != NULL ) {
+                delete mTable;
+                }
+            }
+        
+
+        virtual void run() {
+            mTable = readLanguageFile( mDirectoryName, mLanguageName );
+            
+            atomicStore( mDoneFlag, 1 );
+            }
+        
+
+        char *mDirectoryName;
+        char *mLanguageName;
+        char mClearOldKeys;
+
+        // NULL if file couldn't be read
+        // taken over by whoever swaps it in
+        TranslationTable *mTable;
+        
+    protected:
+        volatile int *mDoneFlag;
+    };
+
 
 
 
@@ -114,50 +286,147 @@ void TranslationManager::setLanguageData( const char *inData,
 
 
 
+void TranslationManager::setLanguageInBackground( const char *inLanguageName,
+                                                  char inClearOldKeys ) {
+    mStaticMembers.finishLoading();
+    
+    mStaticMembers.mLoaderThread = 
+        new TranslationLoaderThread( mStaticMembers.mDirectoryName,
+                                     inLanguageName, inClearOldKeys,
+                                     &( mStaticMembers.mLoadedTableReady ) );
+    }
+
+
+
+char TranslationManager::isLanguageLoading() {
+    mStaticMembers.checkLoadedTable();
+    
+    return ( mStaticMembers.mLoaderThread != NULL );
+    }
+
+
+
 const char *TranslationManager::translate( const char *inTranslationKey ) {
+    return translateHandle( getKeyHandle( inTranslationKey ) );
+    }
 
-    char *translatedString = NULL;
 
-    SimpleVector<char *> *keys =
-        mStaticMembers.mTranslationKeys;
 
-    SimpleVector<char *> *naturalLanguageStrings =
-        mStaticMembers.mNaturalLanguageStrings;
+int TranslationManager::getKeyHandle( const char *inTranslationKey ) {
+    return mStaticMembers.getKeyHandle( inTranslationKey );
+    }
 
-    
-    if( keys != NULL ) {
-        int numKeys = keys->size();
 
-        for( int i=0; i<numKeys && translatedString == NULL; i++ ) {
 
-            if( strcmp( inTranslationKey, *( keys->getElement( i ) ) ) == 0 ) {
-                // keys match
-                translatedString =
-                    *( naturalLanguageStrings->getElement( i ) );
-                }
-            }
+const char *TranslationManager::translateHandle( int inKeyHandle ) {
+    mStaticMembers.checkLoadedTable();
+    
+    SimpleVector<char *> *handleKeys = &( mStaticMembers.mHandleKeys );
+    
+    if( inKeyHandle < 0 || inKeyHandle >= handleKeys->size() ) {
+        return "";
         }
-
+    
+    TranslationTable *table = mStaticMembers.mTable;
+    
+    SimpleVector<const char*> *byHandle = &( table->mByHandle );
+    
+    // bind any handles this table hasn't seen yet
+    while( byHandle->size() <= inKeyHandle ) {
+        byHandle->push_back( 
+            table->lookup( 
+                handleKeys->getElementDirectFast( byHandle->size() ) ) );
+        }
+    
+    const char *translatedString = 
+        byHandle->getElementDirectFast( inKeyHandle );
     
     if( translatedString == NULL ) {
         // no translation exists
 
         // the translation for this key is the key itself
+        // (our own copy, so caller can destroy theirs)
+        translatedString = handleKeys->getElementDirectFast( inKeyHandle );
+        }
 
-        // add it to our translation table
+    return translatedString;
+    }
 
-        char *key = stringDuplicate( inTranslationKey );
-        char *value = stringDuplicate( inTranslationKey );
 
-        keys->push_back( key );
-        naturalLanguageStrings->push_back( value );
 
-        // thus, we return a value from our table, just as if a translation
-        // had existed for this string
-        translatedString = value;
+int TranslationManagerStaticMembers::getKeyHandle( const char *inKey ) {
+    int handle;
+    
+    if( mKeyHandles.lookup( inKey, &handle ) ) {
+        return handle;
         }
+    
+    handle = mHandleKeys.size();
+    
+    mHandleKeys.push_back( stringDuplicate( inKey ) );
+    mKeyHandles.insert( inKey, handle );
+    
+    return handle;
+    }
 
-    return translatedString;
+
+
+// takes ownership of inTable, which can't be NULL
+static void installTable( TranslationTable **inOutCurrentTable,
+                          TranslationTable *inTable, char inClearOldKeys ) {
+    
+    if( inClearOldKeys || *inOutCurrentTable == NULL ) {
+        if( *inOutCurrentTable != NULL ) {
+            delete *inOutCurrentTable;
+            }
+        *inOutCurrentTable = inTable;
+        }
+    else {
+        // old keys win
+        ( *inOutCurrentTable )->addMissingFrom( inTable );
+        delete inTable;
+        }
+    }
+
+
+
+void TranslationManagerStaticMembers::finishLoading() {
+    if( mLoaderThread == NULL ) {
+        return;
+        }
+
+    mLoaderThread->join();
+    
+    TranslationTable *table = mLoaderThread->mTable;
+    mLoaderThread->mTable = NULL;
+    
+    if( table == NULL ) {
+        // failed to open file...
+        table = new TranslationTable;
+        }
+    
+    if( mLoaderThread->mClearOldKeys ) {
+        if( mLanguageName != NULL ) {
+            delete [] mLanguageName;
+            }
+        mLanguageName = stringDuplicate( mLoaderThread->mLanguageName );
+        }
+    
+    installTable( &mTable, table, mLoaderThread->mClearOldKeys );
+    
+    delete mLoaderThread;
+    mLoaderThread = NULL;
+    
+    mLoadedTableReady = 0;
+    }
+
+
+
+void TranslationManagerStaticMembers::checkLoadedTable() {
+    if( mLoaderThread != NULL && atomicLoad( &mLoadedTableReady ) ) {
+        // done, so this won't block
+        finishLoading();
+        }
     }
 
 
@@ -165,8 +434,9 @@ const char *TranslationManager::translate( const char *inTranslationKey ) {
 TranslationManagerStaticMembers::TranslationManagerStaticMembers()
     : mDirectoryName( NULL ),
       mLanguageName( NULL ),
-      mTranslationKeys( NULL ),
-      mNaturalLanguageStrings( NULL ) {
+      mTable( NULL ),
+      mLoaderThread( NULL ),
+      mLoadedTableReady( 0 ) {
 
     // default
     setDirectoryAndLanguage( "languages", "English", true );
@@ -183,26 +453,14 @@ TranslationManagerStaticMembers::~TranslationManagerStaticMembers() {
         delete [] mLanguageName;
         }
 
-    if( mTranslationKeys != NULL ) {
-        int numKeys = mTranslationKeys->size();
+    finishLoading();
 
-        for( int i=0; i<numKeys; i++ ) {
-            delete [] *( mTranslationKeys->getElement( i ) );
-            }
-        delete mTranslationKeys;
-        mTranslationKeys = NULL;
-        }
-
-    if( mNaturalLanguageStrings != NULL ) {
-        int numKeys = mNaturalLanguageStrings->size();
-
-        for( int i=0; i<numKeys; i++ ) {
-            delete [] *( mNaturalLanguageStrings->getElement( i ) );
-            }
-        delete mNaturalLanguageStrings;
-        mNaturalLanguageStrings = NULL;
+    if( mTable != NULL ) {
+        delete mTable;
+        mTable = NULL;
         }
-
+    
+    mHandleKeys.deallocateStringElements();
     }
 
 
@@ -212,6 +470,9 @@ void TranslationManagerStaticMembers::setDirectoryAndLanguage(
     const char *inLanguageName,
     char inClearOldKeys ) {
 
+    // a load still running would otherwise replace this language later
+    finishLoading();
+
     // save temp copies first to allow caller to pass our own members in to us
     char *tempDirectoryName = stringDuplicate( inDirectoryName );
     
@@ -235,48 +496,20 @@ void TranslationManagerStaticMembers::setDirectoryAndLanguage(
         }
 
 
-    char dataSet = false;
-    
-
-    File *directoryFile = new File( NULL, mDirectoryName );
-
-    if( directoryFile->exists() && directoryFile->isDirectory() ) {
-
-        char *languageFileName = autoSprintf( "%s.txt", newLanguageName );
-        
-        File *languageFile = directoryFile->getChildFile( languageFileName );
-
-        delete [] languageFileName;
-
-
-        if( languageFile != NULL ) {
-
-
-            char *languageData = languageFile->readFileContents();
-            
-            if( languageData != NULL ) {
-                
-                dataSet = true;
-
-                setTranslationData( languageData, inClearOldKeys );
-                delete [] languageData;
-                }
-            delete languageFile;
-            }
-        }
-
-    delete directoryFile;
+    TranslationTable *table = readLanguageFile( mDirectoryName, 
+                                                newLanguageName );
     
     delete [] newLanguageName;
     
     
-    if( !dataSet ) {
+    if( table == NULL ) {
         // failed to open file...
         
-        // set blank data to ensure that vectors are created
-        setTranslationData( "", inClearOldKeys );
+        // set blank table to ensure that we have one
+        table = new TranslationTable;
         }
     
+    installTable( &mTable, table, inClearOldKeys );
     }
 
 
@@ -291,35 +524,17 @@ void TranslationManagerStaticMembers::setTranslationData(
     const char *inData,
     char inClearOldKeys ) {
     
-    if( inClearOldKeys ) {
-        
-        // clear the old translation table
-        if( mTranslationKeys != NULL ) {
-            int numKeys = mTranslationKeys->size();
-            
-            for( int i=0; i<numKeys; i++ ) {
-                delete [] *( mTranslationKeys->getElement( i ) );
-                }
-            delete mTranslationKeys;
-            mTranslationKeys = NULL;
-            }
-        
-        if( mNaturalLanguageStrings != NULL ) {
-            int numKeys = mNaturalLanguageStrings->size();
-            
-            for( int i=0; i<numKeys; i++ ) {
-                delete [] *( mNaturalLanguageStrings->getElement( i ) );
-                }
-            delete mNaturalLanguageStrings;
-            mNaturalLanguageStrings = NULL;
-            }
-        }
-    
-    if( mTranslationKeys == NULL ) {
-        mTranslationKeys = new SimpleVector<char *>();
-        mNaturalLanguageStrings = new SimpleVector<char *>();
-        }
-    
+    finishLoading();
+
+    TranslationTable *table = new TranslationTable;
+    table->addData( inData );
+
+    installTable( &mTable, table, inClearOldKeys );
+    }
+
+
+
+void TranslationTable::addData( const char *inData ) {
     
     // now read in the translation table
 
@@ -357,27 +572,12 @@ void TranslationManagerStaticMembers::setTranslationData(
                     
                     // only insert strings for keys that don't
                     // already exist
-                    char keyExists = false;
-                    
-                    char *trimmedKey = stringDuplicate( key );
-
-                    for( int i=0; i<mTranslationKeys->size(); i++ ) {
-                        if( strcmp( *(mTranslationKeys->getElement(i) ),
-                                    trimmedKey ) == 0 ) {
-                            keyExists = true;
-                            break;
-                            }
-                        }
-                    
-                    if( !keyExists ) {
+                    if( ! mStrings.contains( key ) ) {
                         
-                        // trim the key and string and save them
-                        mTranslationKeys->push_back( trimmedKey );
-                        mNaturalLanguageStrings->push_back(
-                            stringDuplicate( naturalLanguageString ) );
-                        }
-                    else {
-                        delete [] trimmedKey;
+                        // trim the string and save it
+                        // (map keeps its own copy of key)
+                        mStrings.insert( 
+                            key, stringDuplicate( naturalLanguageString ) );
                         }
                     }
                 else {
@@ -16,6 +16,9 @@
  *
  * 2015-May-12    Jason Rohrer
  * Support for alternate languages that add keys to a language.
+ *
+ * 2026-October-14    Jason Rohrer
+ * Hashed lookup, key handles, and loading languages in the background.
  */
 
 #include "minorGems/common.h"
@@ -28,12 +31,16 @@
 
 
 #include "minorGems/util/SimpleVector.h"
+#include "minorGems/util/HashMap.h"
 
 
 
 // utility class for dealing with static member dealocation
 class TranslationManagerStaticMembers;
 
+class TranslationTable;
+class TranslationLoaderThread;
+
 
 
 /**
@@ -112,6 +119,28 @@ class TranslationManager {
                                      char inClearOldKeys = true );
         
 
+
+        /**
+         * Same as setLanguage, but reads and parses the language file on
+         * a separate thread.
+         *
+         * The old language stays in use until loading finishes, and the
+         * new one takes over on the next translate call after that.
+         * A second call while one is loading waits for the first.
+         *
+         * @param inLanguageName the name of the language.
+         *   Must be destroyed by caller.
+         * @param inClearOldKeys same as for setLanguage.
+         */
+        static void setLanguageInBackground( const char *inLanguageName,
+                                             char inClearOldKeys = true );
+
+
+        // true if a setLanguageInBackground load has not been swapped in
+        // yet
+        static char isLanguageLoading();
+        
+
         
         
         /**
@@ -144,6 +173,30 @@ class TranslationManager {
          */
         static const char *translate( const char *inTranslationKey );
 
+
+
+        /**
+         * Gets a handle for a key, for repeated translation without
+         * hashing or comparing the key string each time.
+         *
+         * Handles stay valid for the whole run, across language changes.
+         *
+         * @param inTranslationKey the translation key string.
+         *   Must be destroyed by caller if non-const.
+         *
+         * @return the handle.
+         */
+        static int getKeyHandle( const char *inTranslationKey );
+        
+
+        /**
+         * Same as translate, but takes a handle from getKeyHandle.
+         *
+         * @return the translated string, or "" for an invalid handle.
+         *   Must NOT be destroyed by caller.
+         */
+        static const char *translateHandle( int inKeyHandle );
+
         
         
     protected:
@@ -201,9 +254,30 @@ class TranslationManagerStaticMembers {
         char *mDirectoryName;
         char *mLanguageName;
         
-        // vectors mapping keys to strings
-        SimpleVector<char *> *mTranslationKeys;
-        SimpleVector<char *> *mNaturalLanguageStrings;
+        // swaps in table from background load, if it's done
+        void checkLoadedTable();
+
+        // waits for any background load, and swaps it in
+        void finishLoading();
+        
+        // for getKeyHandle
+        int getKeyHandle( const char *inKey );
+        
+        
+        // every key ever translated or loaded, by handle
+        // handles never change once assigned
+        HashMap<const char*, int> mKeyHandles;
+        SimpleVector<char *> mHandleKeys;
+        
+        
+        // current language
+        TranslationTable *mTable;
+        
+
+        TranslationLoaderThread *mLoaderThread;
+        
+        // set by loader thread when its table can be swapped in
+        volatile int mLoadedTableReady;
 
 
     };
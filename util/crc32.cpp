@@ -1,3 +1,16 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14   Jason Rohrer
+ * Slice-by-8 tables, hardware paths, and incremental crc32Update.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Slice tables published with release/acquire ordering, so that weakly
+ * ordered CPUs can't see the flag before the tables.
+ */
+
+
+
 /*-
  *  COPYRIGHT (C) 1986 Gary S. Brown.  You may use this program, or
  *  code or tables extracted from it, as desired without restriction.
@@ -42,6 +55,34 @@
 
 
 
+#include "crc32.h"
+
+#include "minorGems/system/atomicOps.h"
+
+
+#include <string.h>
+#include <stdint.h>
+
+
+#if defined( __ARM_FEATURE_CRC32 )
+    // ARMv8 has instructions for exactly this polynomial
+    #define CRC32_ARM
+    #include <arm_acle.h>
+#elif ( defined( __GNUC__ ) || defined( __clang__ ) ) && \
+      ( defined( __x86_64__ ) || defined( __i386__ ) )
+    // carry-less multiply folding, picked at run time since most builds
+    // don't target CPUs that are guaranteed to have PCLMULQDQ
+    // (note that the SSE4.2 crc32 instruction is CRC-32C, a different
+    //  polynomial, so no use here)
+    #define CRC32_PCLMUL
+    #include <cpuid.h>
+    #include <emmintrin.h>
+    #include <smmintrin.h>
+    #include <wmmintrin.h>
+#endif
+
+
+
 static unsigned int crc32Table[] = {
 	0x00000000, 0x77073096, 0xee0e612c, 0x990951ba, 0x076dc419, 0x706af48f,
 	0xe963a535, 0x9e6495a3,	0x0edb8832, 0x79dcb8a4, 0xe0d5e91e, 0x97d2d988,
@@ -90,19 +131,283 @@ static unsigned int crc32Table[] = {
 
 
 
-unsigned int crc32( const unsigned char *inData, 
-                    int inDataLength ) {
-	
-    const unsigned char *p;
-    unsigned int crc = 0;
+// crc32Table extended to slice-by-8:
+// sliceTables[k][b] is the CRC of byte b followed by k zero bytes
+static unsigned int sliceTables[8][256];
+
+// set, with release ordering, once sliceTables are written
+static volatile int sliceTablesReady = 0;
+
+
+static void makeSliceTables() {
+    for( int b=0; b<256; b++ ) {
+        sliceTables[0][b] = crc32Table[b];
+        }
+    for( int k=1; k<8; k++ ) {
+        for( int b=0; b<256; b++ ) {
+            unsigned int c = sliceTables[k-1][b];
+            sliceTables[k][b] = crc32Table[ c & 0xFF ] ^ ( c >> 8 );
+            }
+        }
+
+    // a thread that saw the flag unset may be rebuilding at the same
+    // time, but it only ever stores these same final values
+    atomicStore( &sliceTablesReady, 1 );
+    }
+
+
+
+// all of these work on the internal (inverted) CRC register
+
+
+static unsigned int crc32Bytes( unsigned int inCRC,
+                                const unsigned char *inData,
+                                int inDataLength ) {
+    while( inDataLength-- ) {
+        inCRC = crc32Table[ ( inCRC ^ *inData++ ) & 0xFF ] ^ ( inCRC >> 8 );
+        }
+    return inCRC;
+    }
+
+
+
+static unsigned int crc32Slice8( unsigned int inCRC,
+                                 const unsigned char *inData,
+                                 int inDataLength ) {
+    if( ! atomicLoad( &sliceTablesReady ) ) {
+        makeSliceTables();
+        }
+
+    while( inDataLength >= 8 ) {
+        // assemble from bytes, so it works at any alignment and byte order
+        unsigned int a = inCRC ^ 
+            ( (unsigned int)inData[0] |
+              (unsigned int)inData[1] << 8 |
+              (unsigned int)inData[2] << 16 |
+              (unsigned int)inData[3] << 24 );
+        
+        inCRC = 
+            sliceTables[7][ a & 0xFF ] ^
+            sliceTables[6][ ( a >> 8 ) & 0xFF ] ^
+            sliceTables[5][ ( a >> 16 ) & 0xFF ] ^
+            sliceTables[4][ a >> 24 ] ^
+            sliceTables[3][ inData[4] ] ^
+            sliceTables[2][ inData[5] ] ^
+            sliceTables[1][ inData[6] ] ^
+            sliceTables[0][ inData[7] ];
+        
+        inData += 8;
+        inDataLength -= 8;
+        }
+
+    return crc32Bytes( inCRC, inData, inDataLength );
+    }
+
+
+
+#ifdef CRC32_ARM
+
+static unsigned int crc32ARM( unsigned int inCRC,
+                              const unsigned char *inData,
+                              int inDataLength ) {
+    while( inDataLength >= 8 ) {
+        uint64_t word;
+        memcpy( &word, inData, 8 );
+
+        inCRC = __crc32d( inCRC, word );
+        
+        inData += 8;
+        inDataLength -= 8;
+        }
+    while( inDataLength-- ) {
+        inCRC = __crc32b( inCRC, *inData++ );
+        }
+    return inCRC;
+    }
+
+#endif
+
+
+
+#ifdef CRC32_PCLMUL
+
+// -1 until checked
+static int hasPCLMUL = -1;
+
+
+static char checkPCLMUL() {
+    unsigned int eax, ebx, ecx, edx;
+    
+    int found = 0;
+
+    if( __get_cpuid( 1, &eax, &ebx, &ecx, &edx ) ) {
+        // PCLMULQDQ and SSE4.1
+        if( ( ecx & ( 1 << 1 ) ) && ( ecx & ( 1 << 19 ) ) ) {
+            found = 1;
+            }
+        }
+    hasPCLMUL = found;
+
+    return found;
+    }
+
+
+
+/**
+ * Folds 16-byte blocks with carry-less multiplies, then Barrett-reduces
+ * down to 32 bits.
+ *
+ * From Gopal et al., "Fast CRC Computation for Generic Polynomials Using
+ * PCLMULQDQ Instruction" (Intel, 2009), with the bit-reflected constants
+ * for this polynomial given at the end of the paper.
+ *
+ * inDataLength must be at least 64 and a multiple of 16.
+ */
+__attribute__(( target( "pclmul,sse4.1" ) ))
+static unsigned int crc32PCLMUL( unsigned int inCRC,
+                                 const unsigned char *inData,
+                                 int inDataLength ) {
+
+    const __m128i k1k2 = _mm_set_epi64x( 0x01c6e41596LL, 0x0154442bd4LL );
+    const __m128i k3k4 = _mm_set_epi64x( 0x00ccaa009eLL, 0x01751997d0LL );
+    const __m128i k5k0 = _mm_set_epi64x( 0, 0x0163cd6124LL );
+    const __m128i poly = _mm_set_epi64x( 0x01f7011641LL, 0x01db710641LL );
+
+    __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+
+    // four lanes of 16 bytes each
+    x1 = _mm_loadu_si128( (const __m128i *)( inData ) );
+    x2 = _mm_loadu_si128( (const __m128i *)( inData + 16 ) );
+    x3 = _mm_loadu_si128( (const __m128i *)( inData + 32 ) );
+    x4 = _mm_loadu_si128( (const __m128i *)( inData + 48 ) );
+
+    x1 = _mm_xor_si128( x1, _mm_cvtsi32_si128( (int)inCRC ) );
+
+    x0 = k1k2;
+
+    inData += 64;
+    inDataLength -= 64;
+
+    // fold 64 bytes at a time into the four lanes
+    while( inDataLength >= 64 ) {
+        x5 = _mm_clmulepi64_si128( x1, x0, 0x00 );
+        x6 = _mm_clmulepi64_si128( x2, x0, 0x00 );
+        x7 = _mm_clmulepi64_si128( x3, x0, 0x00 );
+        x8 = _mm_clmulepi64_si128( x4, x0, 0x00 );
+
+        x1 = _mm_clmulepi64_si128( x1, x0, 0x11 );
+        x2 = _mm_clmulepi64_si128( x2, x0, 0x11 );
+        x3 = _mm_clmulepi64_si128( x3, x0, 0x11 );
+        x4 = _mm_clmulepi64_si128( x4, x0, 0x11 );
+
+        y5 = _mm_loadu_si128( (const __m128i *)( inData ) );
+        y6 = _mm_loadu_si128( (const __m128i *)( inData + 16 ) );
+        y7 = _mm_loadu_si128( (const __m128i *)( inData + 32 ) );
+        y8 = _mm_loadu_si128( (const __m128i *)( inData + 48 ) );
+
+        x1 = _mm_xor_si128( _mm_xor_si128( x1, x5 ), y5 );
+        x2 = _mm_xor_si128( _mm_xor_si128( x2, x6 ), y6 );
+        x3 = _mm_xor_si128( _mm_xor_si128( x3, x7 ), y7 );
+        x4 = _mm_xor_si128( _mm_xor_si128( x4, x8 ), y8 );
+
+        inData += 64;
+        inDataLength -= 64;
+        }
+
+    // fold lanes down into one
+    x0 = k3k4;
+
+    x5 = _mm_clmulepi64_si128( x1, x0, 0x00 );
+    x1 = _mm_clmulepi64_si128( x1, x0, 0x11 );
+    x1 = _mm_xor_si128( _mm_xor_si128( x1, x2 ), x5 );
+
+    x5 = _mm_clmulepi64_si128( x1, x0, 0x00 );
+    x1 = _mm_clmulepi64_si128( x1, x0, 0x11 );
+    x1 = _mm_xor_si128( _mm_xor_si128( x1, x3 ), x5 );
+
+    x5 = _mm_clmulepi64_si128( x1, x0, 0x00 );
+    x1 = _mm_clmulepi64_si128( x1, x0, 0x11 );
+    x1 = _mm_xor_si128( _mm_xor_si128( x1, x4 ), x5 );
+
+    // remaining 16-byte blocks
+    while( inDataLength >= 16 ) {
+        x2 = _mm_loadu_si128( (const __m128i *)inData );
+
+        x5 = _mm_clmulepi64_si128( x1, x0, 0x00 );
+        x1 = _mm_clmulepi64_si128( x1, x0, 0x11 );
+        x1 = _mm_xor_si128( _mm_xor_si128( x1, x2 ), x5 );
+
+        inData += 16;
+        inDataLength -= 16;
+        }
+
+    // 128 bits down to 64
+    x2 = _mm_clmulepi64_si128( x1, x0, 0x10 );
+    x3 = _mm_setr_epi32( ~0, 0, ~0, 0 );
+    x1 = _mm_srli_si128( x1, 8 );
+    x1 = _mm_xor_si128( x1, x2 );
+
+    x0 = k5k0;
+
+    x2 = _mm_srli_si128( x1, 4 );
+    x1 = _mm_and_si128( x1, x3 );
+    x1 = _mm_clmulepi64_si128( x1, x0, 0x00 );
+    x1 = _mm_xor_si128( x1, x2 );
+
+    // Barrett reduction to 32 bits
+    x0 = poly;
+
+    x2 = _mm_and_si128( x1, x3 );
+    x2 = _mm_clmulepi64_si128( x2, x0, 0x10 );
+    x2 = _mm_and_si128( x2, x3 );
+    x2 = _mm_clmulepi64_si128( x2, x0, 0x00 );
+    x1 = _mm_xor_si128( x1, x2 );
+
+    return (unsigned int)_mm_extract_epi32( x1, 1 );
+    }
+
+#endif
+
+
+
+unsigned int crc32Update( unsigned int inCRC,
+                          const unsigned char *inData,
+                          int inDataLength ) {
     
+    unsigned int crc = inCRC ^ ~0U;
 
-	p = inData;
-	crc = crc ^ ~0U;
+#if defined( CRC32_ARM )
 
-	while( inDataLength-- ) {
-		crc = crc32Table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    crc = crc32ARM( crc, inData, inDataLength );
+
+#else
+
+    #ifdef CRC32_PCLMUL
+    
+    // folding setup only pays off for longer runs
+    if( inDataLength >= 256 && 
+        ( hasPCLMUL == 1 || ( hasPCLMUL == -1 && checkPCLMUL() ) ) ) {
+        
+        int blockLength = inDataLength & ~15;
+        
+        crc = crc32PCLMUL( crc, inData, blockLength );
+
+        inData += blockLength;
+        inDataLength -= blockLength;
         }
     
+    #endif
+
+    crc = crc32Slice8( crc, inData, inDataLength );
+
+#endif
+
     return crc ^ ~0U;
     }
+
+
+
+unsigned int crc32( const unsigned char *inData, 
+                    int inDataLength ) {
+    return crc32Update( 0, inData, inDataLength );
+    }
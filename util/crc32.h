@@ -1,4 +1,42 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14   Jason Rohrer
+ * Added include guard and incremental crc32Update.
+ */
 
+#ifndef CRC32_INCLUDED
+#define CRC32_INCLUDED
 
+
+
+/**
+ * Computes the standard CRC-32 (as used by zlib, PNG, and zip) of a block
+ * of data.
+ *
+ * Uses hardware instructions where the CPU has them (carry-less multiply
+ * on x86, CRC instructions on ARMv8), and slice-by-8 tables otherwise.
+ */
 unsigned int crc32( const unsigned char *inData, 
                     int inDataLength );
+
+
+
+/**
+ * Continues a CRC-32 over more data, for data that arrives in pieces.
+ *
+ * Start with 0 and pass in the result from the previous piece:
+ *
+ * unsigned int crc = 0;
+ * crc = crc32Update( crc, firstPart, firstLength );
+ * crc = crc32Update( crc, secondPart, secondLength );
+ *
+ * Gives the same result as crc32 on all of the data at once.
+ */
+unsigned int crc32Update( unsigned int inCRC,
+                          const unsigned char *inData,
+                          int inDataLength );
+
+
+
+#endif
@@ -11,6 +11,11 @@
  * 2004-January-16    Jason Rohrer
  * Switched to use minorGems platform-independed mutexes.
  * Changed to use simpler fopen call to open report.
+ *
+ * 2026-October-15    Jason Rohrer
+ * Added a sampling mode (LT_SAMPLE_BYTES) that records about 1 in N bytes
+ * allocated, with periodic live-heap profiles (LT_DUMP_SECONDS).
+ * Sizes are printed with %zu.
  */
 
 
@@ -40,6 +45,7 @@
 #include <stdlib.h>
 #include <ctype.h>
 #include <errno.h>
+#include <math.h>
 
 
 
@@ -130,10 +136,31 @@ typedef unsigned long magic_t;
  */
 #define INITIALSIZE 32768
 
+
+
+/*
+ * Sampling mode state, kept per thread so that the unsampled path needs
+ * no lock.
+ *
+ * Bytes left before the next sampled allocation, and the state of a
+ * xorshift generator for drawing sample intervals (0 until the thread's
+ * first allocation).
+ *
+ * initial-exec TLS avoids a __tls_get_addr call on each access, and
+ * works for a preloaded LeakTracer.so.
+ */
+static __thread long bytesUntilSample
+    __attribute__((tls_model("initial-exec"))) = 0;
+static __thread unsigned long long sampleRandomState
+    __attribute__((tls_model("initial-exec"))) = 0;
+
 static class LeakTracer {
 	struct Leak {
 		const void *addr;
 		size_t      size;
+		// size scaled up for allocations that sampling mode skipped
+		// (same as size when not sampling)
+		size_t      estimatedSize;
 		const void *allocAddr;
 		bool        type;
         int stackTraceSize;
@@ -152,6 +179,22 @@ public:
 	unsigned long totalAllocations; // total number of allocations. stats.
 	unsigned int  abortOn;  // resons to abort program (see abortReason_t)
 
+	/**
+	 * Sampling mode:  mean bytes allocated between recorded allocations,
+	 * or 0 to record all of them.  Recorded (sampled) allocations
+	 * are the only ones in the leaks array.
+	 */
+	long sampleBytes;
+	long sampledLiveBytes;    // estimated, from live samples
+	long sampledMaxLiveBytes;
+	
+	// seconds between live-heap profile dumps, or 0 for none
+	int dumpSeconds;
+	time_t nextDumpTime;
+	int numDumps;
+
+	char reportFilename[256];
+
 	/**
 	 * Have we been initialized yet?  We depend on this being
 	 * false before constructor has been called!  
@@ -206,7 +249,23 @@ public:
 		leaks = 0;
 		leakHash = 0;
 
-		char uniqFilename[256];
+		sampleBytes = 0;
+		sampledLiveBytes = 0;
+		sampledMaxLiveBytes = 0;
+		dumpSeconds = 0;
+		numDumps = 0;
+		
+		if (getenv("LT_SAMPLE_BYTES")) {
+			sampleBytes = atol(getenv("LT_SAMPLE_BYTES"));
+			if (sampleBytes < 0)
+				sampleBytes = 0;
+		}
+		if (getenv("LT_DUMP_SECONDS")) {
+			dumpSeconds = atoi(getenv("LT_DUMP_SECONDS"));
+		}
+		nextDumpTime = time(NULL) + dumpSeconds;
+
+		char *uniqFilename = reportFilename;
 		const char *filename = getenv("LEAKTRACE_FILE") ? : "leak.out";
 		struct stat dummy;
 		if (stat(filename, &dummy) == 0) {
@@ -254,8 +313,19 @@ public:
 		leakHash = (int*) LT_MALLOC(SOME_PRIME * sizeof(int));
 		memset ((void*) leakHash, 0x00, SOME_PRIME * sizeof(int));
 
+		if (sampleBytes > 0) {
+			// no padding, fill, or checks, which would touch every
+			// allocation
+			fprintf (report, "# sampling 1 in %ld bytes allocated; "
+				 "sizes are estimates\n", sampleBytes);
+			if (dumpSeconds > 0) {
+				fprintf (report, "# live heap profile every %d seconds "
+					 "in %s.heap.N\n", dumpSeconds, uniqFilename);
+			}
+		}
+		else {
 #ifdef MAGIC
-		fprintf (report, "# memory overrun protection of %d Bytes "
+		fprintf (report, "# memory overrun protection of %zu Bytes "
 			 "with magic 0x%4lX\n", 
 			 SAVESIZE, MAGIC);
 #endif
@@ -269,6 +339,7 @@ public:
 		fprintf (report, "# sweeping deleted memory with 0x%2X\n",
 			 MEMCLEAN);
 #endif
+		}
 		if (getenv("LT_ABORTREASON")) {
 			abortOn = atoi(getenv("LT_ABORTREASON"));
 		}
@@ -305,12 +376,38 @@ public:
 	void *registerAlloc(size_t size, bool type);
 	void  registerFree (void *p, bool type);
 
+	/**
+	 * sampling mode versions, called by the above.
+	 */
+	void *registerSampledAlloc(size_t size, bool type, 
+				   const void *allocAddr);
+	void  registerSampledFree (void *p, bool type, const void *freeAddr);
+
+	/**
+	 * index of an unused spot in the leaks array, growing it if needed.
+	 * Must be called with mutex locked.
+	 */
+	int  findFreeSpot();
+
+	// draws the bytes until the next sample for the calling thread
+	long nextSampleInterval();
+
+	// writes an L line for each live sampled allocation
+	void writeSampledLeaks(FILE *inFile);
+
+	/**
+	 * write the live sampled allocations to a new
+	 * <report>.heap.N file.  Must be called with mutex locked.
+	 */
+	void writeHeapProfile();
+
 	/**
 	 * write a hexdump of the given area.
 	 */
 	void  hexdump(const unsigned char* area, int size);
 
     void addStackTraceToReport( Leak inLeak );
+    void addStackTrace( FILE *inFile, Leak *inLeak );
         
 	
 	/**
@@ -352,10 +449,13 @@ void* LeakTracer::registerAlloc (size_t size, bool type) {
 	//	fprintf(stderr, "LeakTracer::registerAlloc()\n");
 
 	if (destroyed) {
-		fprintf(stderr, "Oops, registerAlloc called after destruction of LeakTracer (size=%d)\n", size);
+		fprintf(stderr, "Oops, registerAlloc called after destruction of LeakTracer (size=%zu)\n", size);
 		return LT_MALLOC(size);
 	}
 
+	if (sampleBytes > 0)
+		return registerSampledAlloc(size, type, 
+					    __builtin_return_address(1));
 
 	void *p = LT_MALLOC(size + SAVESIZE);
 	// Need to call the new-handler
@@ -392,28 +492,35 @@ void* LeakTracer::registerAlloc (size_t size, bool type) {
 	if (currentAllocated > maxAllocated)
 		maxAllocated = currentAllocated;
 	
-	for (;;) {
-		for (int i = firstFreeSpot; i < leaksCount; i++)
-			if (leaks[i].addr == NULL) {
-				leaks[i].addr = p;
-				leaks[i].size = size;
-				leaks[i].type = type;
-				leaks[i].allocAddr=__builtin_return_address(1);
+	int i = findFreeSpot();
+
+	leaks[i].addr = p;
+	leaks[i].size = size;
+	leaks[i].estimatedSize = size;
+	leaks[i].type = type;
+	leaks[i].allocAddr=__builtin_return_address(1);
 #ifndef NO_STACK_TRACE
-                leaks[i].stackTraceSize =
-                        backtrace( leaks[i].stackTraceAddresses,
-                                   RECORDED_STACK_SIZE );                
+	leaks[i].stackTraceSize =
+		backtrace( leaks[i].stackTraceAddresses,
+			   RECORDED_STACK_SIZE );                
 #endif
-                firstFreeSpot = i+1;
-				// allow to lookup our index fast.
-				int *hashPos = &leakHash[ ADDR_HASH(p) ];
-				leaks[i].nextBucket = *hashPos;
-				*hashPos = i;
+	// allow to lookup our index fast.
+	int *hashPos = &leakHash[ ADDR_HASH(p) ];
+	leaks[i].nextBucket = *hashPos;
+	*hashPos = i;
 #ifdef THREAD_SAVE
-				//pthread_mutex_unlock(&mutex);
-                mutex.unlock();
+	//pthread_mutex_unlock(&mutex);
+	mutex.unlock();
 #endif
-				return p;
+	return p;
+}
+
+int LeakTracer::findFreeSpot() {
+	for (;;) {
+		for (int i = firstFreeSpot; i < leaksCount; i++)
+			if (leaks[i].addr == NULL) {
+				firstFreeSpot = i+1;
+				return i;
 			}
 		
 		// Allocate a bigger array
@@ -437,6 +544,233 @@ void* LeakTracer::registerAlloc (size_t size, bool type) {
 	}
 }
 
+
+
+long LeakTracer::nextSampleInterval() {
+    // xorshift64*
+    sampleRandomState ^= sampleRandomState >> 12;
+    sampleRandomState ^= sampleRandomState << 25;
+    sampleRandomState ^= sampleRandomState >> 27;
+    unsigned long long r = sampleRandomState * 2685821657736338717ULL;
+    
+    // uniform in (0,1]
+    double u = ( (r >> 11) + 1 ) * ( 1.0 / 9007199254740992.0 );
+    
+    // exponential gaps make sampling a Poisson process over bytes
+    // allocated, so each byte is equally likely to be sampled no
+    // matter how allocations are sized or ordered
+    double interval = -log( u ) * sampleBytes;
+    
+    if( interval < 1 ) {
+        return 1;
+        }
+    return (long)interval;
+    }
+
+
+
+void *LeakTracer::registerSampledAlloc(size_t size, bool type,
+                                       const void *allocAddr) {
+    void *p = LT_MALLOC(size);
+    // Need to call the new-handler
+    if (!p) {
+        fprintf(report, "LeakTracer malloc %m\n");
+        _exit (1);
+        }
+    
+    bytesUntilSample -= (long)size;
+    
+    if( bytesUntilSample > 0 ) {
+        // common case, not sampled
+        return p;
+        }
+    
+    if( sampleRandomState == 0 ) {
+        // first allocation on this thread, so no interval drawn yet
+        sampleRandomState = 
+            (unsigned long long)time( NULL ) * 0x9E3779B97F4A7C15ULL ^
+            (unsigned long)&bytesUntilSample;
+        if( sampleRandomState == 0 ) {
+            sampleRandomState = 1;
+            }
+        bytesUntilSample = nextSampleInterval() - (long)size;
+        
+        if( bytesUntilSample > 0 ) {
+            return p;
+            }
+        }
+    
+    bytesUntilSample = nextSampleInterval();
+    
+    // Each byte is sampled with probability 1/sampleBytes, so an
+    // allocation is sampled with probability 1 - e^(-size/sampleBytes).
+    // Scaling by its inverse makes the sum over samples an unbiased
+    // estimate of live bytes.
+    size_t estimatedSize = size;
+    if( size > 0 ) {
+        estimatedSize = (size_t)( 
+            size / ( 1 - exp( - (double)size / sampleBytes ) ) );
+        }
+
+    // stack captured outside of lock
+    int stackTraceSize = 0;
+    // +1 so not zero-length without stack traces
+    void *stackTraceAddresses[ RECORDED_STACK_SIZE + 1 ];
+#ifndef NO_STACK_TRACE
+    stackTraceSize = backtrace( stackTraceAddresses, RECORDED_STACK_SIZE );
+#endif
+
+#ifdef THREAD_SAVE
+    mutex.lock();
+#endif
+
+    ++newCount;
+    ++totalAllocations;
+    sampledLiveBytes += estimatedSize;
+    if( sampledLiveBytes > sampledMaxLiveBytes ) {
+        sampledMaxLiveBytes = sampledLiveBytes;
+        }
+    
+    int i = findFreeSpot();
+
+    leaks[i].addr = p;
+    leaks[i].size = size;
+    leaks[i].estimatedSize = estimatedSize;
+    leaks[i].type = type;
+    leaks[i].allocAddr = allocAddr;
+    leaks[i].stackTraceSize = stackTraceSize;
+    memcpy( leaks[i].stackTraceAddresses, stackTraceAddresses,
+            stackTraceSize * sizeof( void* ) );
+
+    int *hashPos = &leakHash[ ADDR_HASH(p) ];
+    leaks[i].nextBucket = *hashPos;
+    // read without lock by registerSampledFree
+    __atomic_store_n( hashPos, i, __ATOMIC_RELAXED );
+
+    if( dumpSeconds > 0 ) {
+        // only checked here, so unsampled allocations never call time()
+        time_t t = time( NULL );
+        if( t >= nextDumpTime ) {
+            writeHeapProfile();
+            nextDumpTime = t + dumpSeconds;
+            }
+        }
+    
+#ifdef THREAD_SAVE
+    mutex.unlock();
+#endif
+    return p;
+    }
+
+
+
+void LeakTracer::registerSampledFree(void *p, bool type,
+                                     const void *freeAddr) {
+    int *lastPointer = &leakHash[ ADDR_HASH(p) ];
+
+    // An empty bucket means p wasn't sampled, which is the common case,
+    // and needs no lock.  If p was sampled, recording it happened
+    // before p was handed to whoever is now freeing it, so this
+    // read can't miss it.
+    if( __atomic_load_n( lastPointer, __ATOMIC_RELAXED ) == 0 ) {
+        LT_FREE(p);
+        return;
+        }
+
+#ifdef THREAD_SAVE
+    mutex.lock();
+#endif
+
+    int i = *lastPointer;
+
+    while (i != 0 && leaks[i].addr != p) {
+        lastPointer = &leaks[i].nextBucket;
+        i = *lastPointer;
+        }
+
+    if( i != 0 ) {
+        // detach
+        __atomic_store_n( lastPointer, leaks[i].nextBucket, 
+                          __ATOMIC_RELAXED );
+        newCount--;
+        leaks[i].addr = NULL;
+        sampledLiveBytes -= leaks[i].estimatedSize;
+        if (i < firstFreeSpot)
+            firstFreeSpot = i;
+
+        if (leaks[i].type != type) {
+            fprintf(report, 
+                    "S %10p %10p  ",
+                    leaks[i].allocAddr,
+                    freeAddr );
+            
+            addStackTraceToReport( leaks[i] );
+            
+            fprintf(report, 
+                    "# new%s but delete%s "
+                    "; size %zu\n",
+                    ((!type) ? "[]" : " normal"),
+                    ((type) ? "[]" : " normal"),
+                    leaks[i].size );
+            
+            progAbort( NEW_DELETE_MISMATCH );
+            }
+        }
+    // else shares a bucket with a sampled allocation, but wasn't sampled
+    // (deletes of non-allocated pointers can't be told apart from
+    // unsampled ones, so aren't reported)
+
+#ifdef THREAD_SAVE
+    mutex.unlock();
+#endif
+
+    LT_FREE(p);
+    }
+
+
+
+void LeakTracer::writeSampledLeaks(FILE *inFile) {
+    for (int i = 0; i <  leaksCount; i++)
+        if (leaks[i].addr != NULL) {
+            fprintf(inFile, "L %10p   %9ld",
+                    leaks[i].allocAddr,
+                    (long) leaks[i].estimatedSize );
+            
+            addStackTrace( inFile, &( leaks[i] ) );
+            
+            fprintf( inFile, "  # %p, %ld bytes sampled\n",
+                     leaks[i].addr, (long) leaks[i].size );
+            }
+    }
+
+
+
+void LeakTracer::writeHeapProfile() {
+    char filename[300];
+    sprintf( filename, "%s.heap.%d", reportFilename, numDumps );
+    numDumps++;
+    
+    FILE *file = fopen( filename, "w" );
+    if( file == NULL ) {
+        fprintf( report, "# cannot open %s\n", filename );
+        fflush( report );
+        return;
+        }
+    
+    time_t t = time(NULL);
+    fprintf( file, "# live heap profile %d, %s", numDumps - 1, ctime(&t) );
+    fprintf( file, "# sampling 1 in %ld bytes allocated; "
+             "sizes are estimates\n", sampleBytes );
+    
+    writeSampledLeaks( file );
+    
+    fprintf( file, "# estimated live %ld Bytes, max %ld Bytes\n", 
+             sampledLiveBytes, sampledMaxLiveBytes );
+    fclose( file );
+    }
+
+
+
 void LeakTracer::hexdump(const unsigned char* area, int size) {
 	fprintf(report, "# ");
 	for (int j=0; j < size ; ++j) {
@@ -455,15 +789,20 @@ void LeakTracer::hexdump(const unsigned char* area, int size) {
 
 
 void LeakTracer::addStackTraceToReport( Leak inLeak ) {
+        addStackTrace( report, &inLeak );
+    }
+
+
+void LeakTracer::addStackTrace( FILE *inFile, Leak *inLeak ) {
 #ifndef NO_STACK_TRACE
-        fprintf( report, "    S|" );
-        for( int s=0; s<inLeak.stackTraceSize; s++ ) {
-                fprintf( report, "%p", inLeak.stackTraceAddresses[s] );
-                if( s < inLeak.stackTraceSize - 1 ) {
-                        fprintf( report, "|" );
+        fprintf( inFile, "    S|" );
+        for( int s=0; s<inLeak->stackTraceSize; s++ ) {
+                fprintf( inFile, "%p", inLeak->stackTraceAddresses[s] );
+                if( s < inLeak->stackTraceSize - 1 ) {
+                        fprintf( inFile, "|" );
                     }
                 else {
-                        fprintf( report, " " );
+                        fprintf( inFile, " " );
                     }
             }
 #endif
@@ -482,6 +821,11 @@ void LeakTracer::registerFree (void *p, bool type) {
 		return;
 	}
 
+	if (sampleBytes > 0) {
+		registerSampledFree(p, type, __builtin_return_address(1));
+		return;
+	}
+
 #ifdef THREAD_SAVE
 	//pthread_mutex_lock(&mutex);
     mutex.lock();
@@ -512,7 +856,7 @@ void LeakTracer::registerFree (void *p, bool type) {
             
             fprintf(report, 
 				"# new%s but delete%s "
-				"; size %d\n",
+				"; size %zu\n",
 				((!type) ? "[]" : " normal"),
 				((type) ? "[]" : " normal"),
 				leaks[i].size );
@@ -529,10 +873,10 @@ void LeakTracer::registerFree (void *p, bool type) {
             addStackTraceToReport( leaks[i] );
             
             fprintf(report, "# memory overwritten beyond allocated"
-				" %d bytes\n",
+				" %zu bytes\n",
 				leaks[i].size);
 
-			fprintf(report, "# %d byte beyond area:\n",
+			fprintf(report, "# %zu byte beyond area:\n",
 				SAVESIZE);
 			hexdump((unsigned char*)p+leaks[i].size,
 				SAVESIZE);
@@ -571,6 +915,19 @@ void LeakTracer::registerFree (void *p, bool type) {
 void LeakTracer::writeLeakReport() {
 	initialize();
 
+	if (sampleBytes > 0) {
+		if (newCount > 0) {
+			fprintf(report, "# LeakReport (sampled)\n");
+		}
+		writeSampledLeaks(report);
+		fprintf(report, "# sampled allocations: %6ld ; estimated "
+			"max. mem used %ld kBytes\n", totalAllocations, 
+			sampledMaxLiveBytes / 1024);
+		fprintf(report, "# estimated leak %ld Bytes from %d samples\n",
+			sampledLiveBytes, newCount);
+		return;
+	}
+
 	if (newCount > 0) {
 		fprintf(report, "# LeakReport\n");
 		fprintf(report, "# %10s | %9s ",
@@ -659,6 +1016,9 @@ char *strdup( const char *inString ) {
 struct mallinfo mallinfo() {
     struct mallinfo mi;
     mi.uordblks = leakTracer.currentAllocated;
+    if( leakTracer.sampleBytes > 0 ) {
+        mi.uordblks = leakTracer.sampledLiveBytes;
+        }
     return mi;
     }
 
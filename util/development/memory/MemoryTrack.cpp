@@ -26,6 +26,12 @@
  *
  * 2002-October-20  Jason Rohrer
  * Removed file and line arguments from deallocation calls.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Replaced global list and lock with sharded hash tables.
+ * Added allocation sites, keyed by return address, with per-thread counts.
+ * Added heap snapshots and snapshot diffs.
+ * Fixed pointer printing on 64-bit platforms.
  */
 
 
@@ -34,24 +40,376 @@
 
 
 #include "minorGems/util/development/memory/MemoryTrack.h"
+#include "minorGems/system/atomicOps.h"
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <assert.h>
+#include <string.h>
+#include <stdint.h>
 
 
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <sched.h>
+#endif
+
+
+#ifdef _MSC_VER
+    #define MEMORY_TRACK_THREAD_LOCAL __declspec( thread )
+#else
+    #define MEMORY_TRACK_THREAD_LOCAL __thread
+#endif
+
+
+
+// all power of 2
+
+#define NUM_SHARDS 64
+
+#define INITIAL_SHARD_SLOTS 1024
+
+// allocations from sites past this many are counted together in site 0
+#define MAX_SITES 8192
+
+#define SITE_CACHE_SIZE 1024
+
+
+#define SNAPSHOTS_KEPT 64
+
+
+
+typedef struct LiveAllocation {
+        // NULL if slot empty
+        void *pointer;
+        unsigned int size;
+        int type;
+        int site;
+    } LiveAllocation;
+
+
+
+// open addressing, linear probing, at most half full
+typedef struct Shard {
+        volatile int lock;
+
+        // NULL until first allocation
+        LiveAllocation *slots;
+        int numSlots;
+        int numFilled;
+    } Shard;
+
+
+// plain data, so it's usable during static construction and destruction
+static Shard shards[ NUM_SHARDS ];
+
+
+
+typedef struct AllocationSite {
+        void *address;
+        const char *fileName;
+        int lineNumber;
+    } AllocationSite;
+
+
+// these are protected by siteLock
+
+static volatile int siteLock = 0;
+
+// site 0 stands for all sites that didn't fit
+static AllocationSite sites[ MAX_SITES ];
+static int numSites = 1;
+
+// site index by address, 0 for empty slot
+static int siteTable[ MAX_SITES * 2 ];
+
+
+
+// cumulative, so that live counts and counts between snapshots are both
+// differences
+typedef struct SiteCounts {
+        int allocations;
+        int deallocations;
+        long long bytesAllocated;
+        long long bytesDeallocated;
+    } SiteCounts;
+
 
-int MemoryTrackStaticInitCounter::mCount = 0;
 
-MutexLock *MemoryTrack::mLock;
+// one per thread, only written by its thread
+// never destroyed, so counts from threads that have exited are kept
+typedef struct ThreadCounts {
+        SiteCounts counts[ MAX_SITES ];
 
-AllocationList *MemoryTrack::mListHead;
+        // direct mapped, site address to site index
+        void *cacheAddresses[ SITE_CACHE_SIZE ];
+        int cacheSites[ SITE_CACHE_SIZE ];
+
+        struct ThreadCounts *next;
+    } ThreadCounts;
+
+
+static MEMORY_TRACK_THREAD_LOCAL ThreadCounts *threadCounts = NULL;
+
+
+// these are protected by registryLock
+
+static volatile int registryLock = 0;
+
+static ThreadCounts *allThreadCounts = NULL;
+
+
+
+typedef struct Snapshot {
+        int id;
+
+        int numSites;
+
+        // summed over all threads, one per site
+        // NULL if unused
+        SiteCounts *counts;
+    } Snapshot;
+
+
+// protected by registryLock
+static Snapshot snapshots[ SNAPSHOTS_KEPT ];
+static int numSnapshotsTaken = 0;
+
+
+
+int MemoryTrackStaticInitCounter::mCount = 0;
 
 char MemoryTrack::mTracking = false;
 
-int MemoryTrack::mTotalAllocationSize = 0;
-int MemoryTrack::mTotalDeallocationSize = 0;
-int MemoryTrack::mNumberOfAllocations = 0;
+
+
+// spins, as in MutexLockProfile
+static void spinLock( volatile int *inLock ) {
+    while( atomicExchange( inLock, 1 ) != 0 ) {
+        #ifdef _WIN32
+            SwitchToThread();
+        #else
+            sched_yield();
+        #endif
+        }
+    }
+
+
+
+static void spinUnlock( volatile int *inLock ) {
+    atomicStore( inLock, 0 );
+    }
+
+
+
+static unsigned int hashPointer( void *inPointer ) {
+    // low bits are mostly alignment
+    unsigned long long x = (uintptr_t)inPointer >> 4;
+
+    x *= 0x9E3779B97F4A7C15ULL;
+
+    return (unsigned int)( x >> 32 );
+    }
+
+
+
+// low bits of hash pick shard, the rest pick slot
+static Shard *getShard( unsigned int inHash ) {
+    return &( shards[ inHash & ( NUM_SHARDS - 1 ) ] );
+    }
+
+
+
+static int getHomeSlot( Shard *inShard, unsigned int inHash ) {
+    return ( inHash / NUM_SHARDS ) & ( inShard->numSlots - 1 );
+    }
+
+
+
+static void insertIntoSlots( Shard *inShard, LiveAllocation *inAllocation ) {
+    int mask = inShard->numSlots - 1;
+
+    int i = getHomeSlot( inShard, hashPointer( inAllocation->pointer ) );
+
+    while( inShard->slots[i].pointer != NULL &&
+           inShard->slots[i].pointer != inAllocation->pointer ) {
+        i = ( i + 1 ) & mask;
+        }
+
+    if( inShard->slots[i].pointer == NULL ) {
+        inShard->numFilled++;
+        }
+    // else an untracked free let this address be handed out again,
+    // replace stale record
+
+    inShard->slots[i] = *inAllocation;
+    }
+
+
+
+// shard must be locked
+static void addToShard( Shard *inShard, LiveAllocation *inAllocation ) {
+    if( inShard->slots == NULL ) {
+        inShard->numSlots = INITIAL_SHARD_SLOTS;
+        inShard->numFilled = 0;
+        inShard->slots = (LiveAllocation *)
+            calloc( inShard->numSlots, sizeof( LiveAllocation ) );
+        }
+    else if( ( inShard->numFilled + 1 ) * 2 > inShard->numSlots ) {
+        LiveAllocation *oldSlots = inShard->slots;
+        int oldNumSlots = inShard->numSlots;
+
+        inShard->numSlots *= 2;
+        inShard->numFilled = 0;
+        inShard->slots = (LiveAllocation *)
+            calloc( inShard->numSlots, sizeof( LiveAllocation ) );
+
+        for( int i=0; i<oldNumSlots; i++ ) {
+            if( oldSlots[i].pointer != NULL ) {
+                insertIntoSlots( inShard, &( oldSlots[i] ) );
+                }
+            }
+        free( oldSlots );
+        }
+
+    insertIntoSlots( inShard, inAllocation );
+    }
+
+
+
+// shard must be locked
+// returns true if found, filling outAllocation
+static char removeFromShard( Shard *inShard, void *inPointer,
+                             LiveAllocation *outAllocation ) {
+    // NULL marks empty slots
+    if( inShard->slots == NULL || inPointer == NULL ) {
+        return false;
+        }
+
+    int mask = inShard->numSlots - 1;
+
+    int i = getHomeSlot( inShard, hashPointer( inPointer ) );
+
+    while( inShard->slots[i].pointer != inPointer ) {
+        if( inShard->slots[i].pointer == NULL ) {
+            return false;
+            }
+        i = ( i + 1 ) & mask;
+        }
+
+    *outAllocation = inShard->slots[i];
+
+    // shift later entries of the same probe run back, so no tombstones
+    // are needed
+    int j = i;
+    while( true ) {
+        j = ( j + 1 ) & mask;
+
+        if( inShard->slots[j].pointer == NULL ) {
+            break;
+            }
+
+        int k = getHomeSlot( inShard,
+                             hashPointer( inShard->slots[j].pointer ) );
+
+        // entry at j can stay if its home is cyclically in (i, j]
+        char canStay;
+        if( i <= j ) {
+            canStay = ( i < k && k <= j );
+            }
+        else {
+            canStay = ( i < k || k <= j );
+            }
+
+        if( ! canStay ) {
+            inShard->slots[i] = inShard->slots[j];
+            i = j;
+            }
+        }
+
+    inShard->slots[i].pointer = NULL;
+    inShard->numFilled--;
+
+    return true;
+    }
+
+
+
+static ThreadCounts *getThreadCounts() {
+    ThreadCounts *t = threadCounts;
+
+    if( t != NULL ) {
+        return t;
+        }
+
+    t = (ThreadCounts *)calloc( 1, sizeof( ThreadCounts ) );
+
+    spinLock( &registryLock );
+
+    t->next = allThreadCounts;
+    allThreadCounts = t;
+
+    spinUnlock( &registryLock );
+
+    threadCounts = t;
+
+    return t;
+    }
+
+
+
+static int lookUpSite( void *inAddress,
+                       const char *inFileName, int inLineNumber ) {
+    spinLock( &siteLock );
+
+    int mask = MAX_SITES * 2 - 1;
+
+    int i = hashPointer( inAddress ) & mask;
+
+    int site = 0;
+
+    while( siteTable[i] != 0 ) {
+        if( sites[ siteTable[i] ].address == inAddress ) {
+            site = siteTable[i];
+            break;
+            }
+        i = ( i + 1 ) & mask;
+        }
+
+    if( site == 0 && numSites < MAX_SITES ) {
+        site = numSites;
+        numSites++;
+
+        sites[ site ].address = inAddress;
+        sites[ site ].fileName = inFileName;
+        sites[ site ].lineNumber = inLineNumber;
+
+        siteTable[i] = site;
+        }
+
+    spinUnlock( &siteLock );
+
+    return site;
+    }
+
+
+
+static int getSite( ThreadCounts *inCounts, void *inAddress,
+                    const char *inFileName, int inLineNumber ) {
+
+    int c = ( hashPointer( inAddress ) >> 8 ) & ( SITE_CACHE_SIZE - 1 );
+
+    if( inCounts->cacheAddresses[c] == inAddress ) {
+        return inCounts->cacheSites[c];
+        }
+
+    int site = lookUpSite( inAddress, inFileName, inLineNumber );
+
+    inCounts->cacheAddresses[c] = inAddress;
+    inCounts->cacheSites[c] = site;
+
+    return site;
+    }
 
 
 
@@ -59,50 +417,44 @@ void MemoryTrack::addAllocation( void *inPointer,
                                  unsigned int inAllocationSize,
                                  int inAllocationType,
                                  const char *inFileName,
-                                 int inLineNumber ) {
-
-    mLock->lock();
+                                 int inLineNumber,
+                                 void *inSiteAddress ) {
 
     if( !mTracking ) {
-        printf( "Tracking off on allocation (0x%x) [%d bytes] %s:%d.\n",
-                (unsigned int)inPointer,
+        printf( "Tracking off on allocation (%p) [%d bytes] %s:%d.\n",
+                inPointer,
                 inAllocationSize,
                 inFileName, inLineNumber );
+        return;
+        }
 
-        mLock->unlock();
+    if( inPointer == NULL ) {
+        // failed malloc, nothing to track
         return;
         }
-    
 
-    // insert after head of list
-    AllocationList *element =
-        (AllocationList *)malloc( sizeof( AllocationList ) );
-    element->mPrevious = (void *)mListHead;
-    element->mNext = mListHead->mNext;
+    ThreadCounts *t = getThreadCounts();
 
-    mListHead->mNext = (void *)element;
+    LiveAllocation a;
+    a.pointer = inPointer;
+    a.size = inAllocationSize;
+    a.type = inAllocationType;
+    a.site = getSite( t, inSiteAddress, inFileName, inLineNumber );
 
+    unsigned int hash = hashPointer( inPointer );
 
-    AllocationList *nextElement = (AllocationList *)( element->mNext );
-    if( nextElement != NULL ) {
-        nextElement->mPrevious = (void *)element;
-        }
-    
-    element->mPointer = inPointer;
-    element->mAllocationSize = inAllocationSize;
-    element->mAllocationType = inAllocationType;
-    element->mFileName = inFileName;
-    element->mLineNumber = inLineNumber;
+    Shard *shard = getShard( hash );
 
+    spinLock( &( shard->lock ) );
+    addToShard( shard, &a );
+    spinUnlock( &( shard->lock ) );
 
-    mTotalAllocationSize += inAllocationSize;
+    SiteCounts *counts = &( t->counts[ a.site ] );
+    counts->allocations ++;
+    counts->bytesAllocated += inAllocationSize;
 
-    mNumberOfAllocations ++;
-    
     // wipe this block of memory
     clearMemory( inPointer, inAllocationSize );
-    
-    mLock->unlock();
     }
 
 
@@ -110,168 +462,346 @@ void MemoryTrack::addAllocation( void *inPointer,
 int MemoryTrack::addDeallocation( void *inPointer,
                                   int inDeallocationType ) {
 
-    mLock->lock();
-
     if( inPointer == NULL ) {
-        printf( "NULL pointer (0x%x) deallocated\n",
-                (unsigned int)inPointer );
+        printf( "NULL pointer (%p) deallocated\n", inPointer );
         }
 
-    
-    if( inPointer == (void *)mLock ) {
-        // we're seeing the deallocation of our own static lock as
-        // the system exits
-        // ignore it
-        mLock->unlock();
+    if( !mTracking ) {
+        printf( "Tracking off on deallocation (%p)\n", inPointer );
         return 0;
         }
-    
-    if( !mTracking ) {
-        printf( "Tracking off on deallocation (0x%x)\n",
-                (unsigned int)inPointer );
-        mLock->unlock();
+
+
+    Shard *shard = getShard( hashPointer( inPointer ) );
+
+    LiveAllocation a;
+
+    spinLock( &( shard->lock ) );
+    char found = removeFromShard( shard, inPointer, &a );
+    spinUnlock( &( shard->lock ) );
+
+    if( !found ) {
+        // not found (delete of unallocated memory)
+        printf( "Attempt to deallocate (%p) unallocated memory\n",
+                inPointer );
+        return 1;
+        }
+
+    // counted whether or not types match
+    SiteCounts *counts = &( getThreadCounts()->counts[ a.site ] );
+    counts->deallocations ++;
+    counts->bytesDeallocated += a.size;
+
+
+    if( a.type == inDeallocationType ) {
+        // found and types match
+
+        // wipe this block of memory
+        clearMemory( inPointer, a.size );
         return 0;
         }
+    else {
+        // allocation types don't match
 
-    
-
-    AllocationList *element = (AllocationList *)( mListHead->mNext );
-
-    while( element != NULL ) {
-        
-        void *pointer = element->mPointer;
-        
-        if( pointer == inPointer ) {
-
-            unsigned int allocationSize = element->mAllocationSize;
-            int allocationType = element->mAllocationType;
-            const char *allocFileName = element->mFileName;            
-            int allocLineNumber = element->mLineNumber;
-            
-            // remove from list, whether or not types match
-            AllocationList *previousElement =
-                (AllocationList *)( element->mPrevious );
-            AllocationList *nextElement =
-                (AllocationList *)( element->mNext );
-            
-            // patch list
-            previousElement->mNext = (void *)( nextElement );
-
-            if( nextElement != NULL ) {
-                nextElement->mPrevious = (void *)( previousElement );
-                }
-            
-            free( element );
-            
-            mTotalDeallocationSize += allocationSize;
-            
-            
-            if( allocationType == inDeallocationType ) {
-                // found and types match
-                mLock->unlock();
-
-                // wipe this block of memory
-                clearMemory( inPointer, allocationSize );
-                return 0;
-                }
-            else {
-                // allocation types don't match
-                
-                printf( "Attempt to deallocate (0x%x) [%d bytes] with wrong"
-                        " delete form\n"
-                        "    %s:%d (location of original allocation)\n",
-                        (unsigned int)inPointer,
-                        allocationSize,
-                        allocFileName, allocLineNumber );
-
-                mLock->unlock();
-                
-                return 2;
-                }
-            
-            }
+        // sites are never changed once added
+        printf( "Attempt to deallocate (%p) [%d bytes] with wrong"
+                " delete form\n"
+                "    %s:%d (location of original allocation)\n",
+                inPointer,
+                a.size,
+                sites[ a.site ].fileName, sites[ a.site ].lineNumber );
+
+        return 2;
+        }
+    }
+
+
+
+// sums counts of all threads into outCounts, which has MAX_SITES entries
+// registryLock must be held
+// other threads keep counting while we read, so sums are a close
+// approximation of one instant, not an exact one
+static void sumThreadCounts( SiteCounts *outCounts, int inNumSites ) {
+    memset( outCounts, 0, inNumSites * sizeof( SiteCounts ) );
+
+    ThreadCounts *t = allThreadCounts;
 
-        element = (AllocationList *)( element->mNext );
+    while( t != NULL ) {
+        for( int s=0; s<inNumSites; s++ ) {
+            SiteCounts *c = &( t->counts[s] );
+
+            outCounts[s].allocations += c->allocations;
+            outCounts[s].deallocations += c->deallocations;
+            outCounts[s].bytesAllocated += c->bytesAllocated;
+            outCounts[s].bytesDeallocated += c->bytesDeallocated;
+            }
+        t = t->next;
         }
+    }
+
+
 
-    // not found (delete of unallocated memory)
-    printf( "Attempt to deallocate (0x%x) unallocated memory\n",
-            (unsigned int)inPointer );
+static int getNumSites() {
+    spinLock( &siteLock );
+    int n = numSites;
+    spinUnlock( &siteLock );
 
-    mLock->unlock();
-    
-    return 1;
+    return n;
     }
 
 
 
 void MemoryTrack::printLeaks() {
-    mLock->lock();
+    int n = getNumSites();
 
-    printf( "\n\n---- debugMemory report ----\n" );
-    
-    printf( "Number of Allocations:  %d\n", mNumberOfAllocations );
-    printf( "Total allocations:      %d bytes\n", mTotalAllocationSize );
-    printf( "Total deallocations:    %d bytes\n", mTotalDeallocationSize );
-    
-    int leakEstimate = mTotalAllocationSize - mTotalDeallocationSize;
+    SiteCounts *totals = (SiteCounts *)malloc( n * sizeof( SiteCounts ) );
 
+    spinLock( &registryLock );
+    sumThreadCounts( totals, n );
+    spinUnlock( &registryLock );
 
-    
-    AllocationList *element = (AllocationList *)( mListHead->mNext );
+    int numberOfAllocations = 0;
+    long long totalAllocationSize = 0;
+    long long totalDeallocationSize = 0;
 
-    if( element == NULL ) {
-        printf( "No leaks detected.\n" );
-        }
-    else {
-        printf( "Leaks detected:\n" );
+    for( int s=0; s<n; s++ ) {
+        numberOfAllocations += totals[s].allocations;
+        totalAllocationSize += totals[s].bytesAllocated;
+        totalDeallocationSize += totals[s].bytesDeallocated;
         }
 
-    int leakSum = 0;
-    while( element != NULL ) {
-    
-        printf( "Not deallocated (0x%x) [%d bytes]\n"
-                "    %s:%d (location of original allocation)\n",
-                (unsigned int)( element->mPointer ),
-                element->mAllocationSize,
-                element->mFileName,
-                element->mLineNumber );
+    free( totals );
+
+
+    printf( "\n\n---- debugMemory report ----\n" );
+
+    printf( "Number of Allocations:  %d\n", numberOfAllocations );
+    printf( "Total allocations:      %lld bytes\n", totalAllocationSize );
+    printf( "Total deallocations:    %lld bytes\n", totalDeallocationSize );
+
+    long long leakEstimate = totalAllocationSize - totalDeallocationSize;
+
+
+    char anyLeaks = false;
+    long long leakSum = 0;
+
+    for( int i=0; i<NUM_SHARDS; i++ ) {
+        Shard *shard = &( shards[i] );
+
+        spinLock( &( shard->lock ) );
+
+        for( int j=0; j<shard->numSlots; j++ ) {
+            LiveAllocation *a = &( shard->slots[j] );
+
+            if( a->pointer == NULL ) {
+                continue;
+                }
+
+            if( !anyLeaks ) {
+                printf( "Leaks detected:\n" );
+                anyLeaks = true;
+                }
+
+            printf( "Not deallocated (%p) [%d bytes]\n"
+                    "    %s:%d (location of original allocation)\n",
+                    a->pointer,
+                    a->size,
+                    sites[ a->site ].fileName,
+                    sites[ a->site ].lineNumber );
+
+            leakSum += a->size;
+            }
 
-        leakSum += element->mAllocationSize;
-        
-        element = (AllocationList *)( element->mNext );
+        spinUnlock( &( shard->lock ) );
         }
 
-    
+    if( !anyLeaks ) {
+        printf( "No leaks detected.\n" );
+        }
+
+
     if( leakSum != leakEstimate ) {
         printf( "Warning:  Leak sum does not equal leak estimate.\n" );
         }
 
-    
-    printf( "Leaked memory:          %d bytes\n", leakSum );
-    
+
+    printf( "Leaked memory:          %lld bytes\n", leakSum );
+
     printf( "---- END debugMemory report ----\n\n" );
+    }
+
+
+
+int MemoryTrack::takeSnapshot() {
+    if( !mTracking ) {
+        return -1;
+        }
+
+    int n = getNumSites();
+
+    SiteCounts *counts = (SiteCounts *)malloc( n * sizeof( SiteCounts ) );
+
+    spinLock( &registryLock );
+
+    sumThreadCounts( counts, n );
+
+    int id = numSnapshotsTaken;
+    numSnapshotsTaken++;
 
-    
-    mLock->unlock();
+    Snapshot *s = &( snapshots[ id % SNAPSHOTS_KEPT ] );
+
+    if( s->counts != NULL ) {
+        free( s->counts );
+        }
+    s->id = id;
+    s->numSites = n;
+    s->counts = counts;
+
+    spinUnlock( &registryLock );
+
+    return id;
     }
 
 
 
-void MemoryTrack::clearMemory( void *inPointer, unsigned int inSize ) {
+typedef struct SiteDiff {
+        int site;
+        int allocations;
+        long long bytesAllocated;
+        int liveChange;
+        long long liveBytesChange;
+    } SiteDiff;
+
+
+
+static int compareSiteDiffs( const void *inA, const void *inB ) {
+    const SiteDiff *a = (const SiteDiff *)inA;
+    const SiteDiff *b = (const SiteDiff *)inB;
+
+    // most allocations first
+    if( a->allocations != b->allocations ) {
+        return ( a->allocations > b->allocations ) ? -1 : 1;
+        }
+    if( a->bytesAllocated != b->bytesAllocated ) {
+        return ( a->bytesAllocated > b->bytesAllocated ) ? -1 : 1;
+        }
+    return a->site - b->site;
+    }
 
-    unsigned char *charArray = (unsigned char *)inPointer;
 
-    for( unsigned int i=0; i<inSize; i++ ) {
-        charArray[i] = (unsigned char)0xAA;
+
+// registryLock must be held
+static Snapshot *findSnapshot( int inID ) {
+    if( inID < 0 ) {
+        return NULL;
         }
 
+    Snapshot *s = &( snapshots[ inID % SNAPSHOTS_KEPT ] );
+
+    if( s->counts == NULL || s->id != inID ) {
+        return NULL;
+        }
+    return s;
     }
 
 
 
-#endif
+char MemoryTrack::writeSnapshotDiff( int inOlderSnapshot,
+                                     int inNewerSnapshot,
+                                     const char *inFileName ) {
 
+    spinLock( &registryLock );
 
+    Snapshot *older = findSnapshot( inOlderSnapshot );
+    Snapshot *newer = findSnapshot( inNewerSnapshot );
+
+    if( older == NULL || newer == NULL ) {
+        spinUnlock( &registryLock );
+        return false;
+        }
 
+    // sites are only ever added, so newer has at least as many
+    int n = newer->numSites;
 
+    SiteDiff *diffs = (SiteDiff *)malloc( n * sizeof( SiteDiff ) );
+    int numDiffs = 0;
+
+    for( int s=0; s<n; s++ ) {
+        SiteCounts *b = &( newer->counts[s] );
+
+        SiteCounts zero = { 0, 0, 0, 0 };
+        SiteCounts *a = &zero;
+
+        if( s < older->numSites ) {
+            a = &( older->counts[s] );
+            }
+
+        SiteDiff d;
+        d.site = s;
+        d.allocations = b->allocations - a->allocations;
+        d.bytesAllocated = b->bytesAllocated - a->bytesAllocated;
+        d.liveChange =
+            ( b->allocations - b->deallocations ) -
+            ( a->allocations - a->deallocations );
+        d.liveBytesChange =
+            ( b->bytesAllocated - b->bytesDeallocated ) -
+            ( a->bytesAllocated - a->bytesDeallocated );
+
+        if( d.allocations != 0 || d.liveChange != 0 ||
+            d.liveBytesChange != 0 ) {
+            diffs[ numDiffs ] = d;
+            numDiffs++;
+            }
+        }
+
+    spinUnlock( &registryLock );
+
+
+    qsort( diffs, numDiffs, sizeof( SiteDiff ), compareSiteDiffs );
+
+
+    FILE *file = fopen( inFileName, "w" );
+
+    if( file == NULL ) {
+        free( diffs );
+        return false;
+        }
+
+    fprintf( file, "site,file,line,allocations,bytesAllocated,"
+             "liveChange,liveBytesChange\n" );
+
+    for( int i=0; i<numDiffs; i++ ) {
+        SiteDiff *d = &( diffs[i] );
+
+        // sites are never changed once added
+        AllocationSite *site = &( sites[ d->site ] );
+
+        if( d->site == 0 ) {
+            fprintf( file, "other,,," );
+            }
+        else {
+            fprintf( file, "%p,%s,%d,",
+                     site->address, site->fileName, site->lineNumber );
+            }
+
+        fprintf( file, "%d,%lld,%d,%lld\n",
+                 d->allocations, d->bytesAllocated,
+                 d->liveChange, d->liveBytesChange );
+        }
+
+    fclose( file );
+
+    free( diffs );
+
+    return true;
+    }
+
+
+
+void MemoryTrack::clearMemory( void *inPointer, unsigned int inSize ) {
+    memset( inPointer, 0xAA, inSize );
+    }
+
+
+
+#endif
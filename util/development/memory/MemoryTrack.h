@@ -18,6 +18,11 @@
  *
  * 2002-October-20  Jason Rohrer
  * Removed file and line arguments from deallocation calls.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Replaced global list and lock with sharded hash tables.
+ * Added allocation sites, keyed by return address, with per-thread counts.
+ * Added heap snapshots and snapshot diffs.
  */
 
 
@@ -27,7 +32,6 @@
 
 
 
-#include "minorGems/system/MutexLock.h"
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -37,59 +41,53 @@
 
 
 
-/**
- * Linked list of memory allocations.
- *
- * @author Jason Rohrer
- */
-typedef struct {
-        
-        void *mPrevious;
-        void *mNext;
-
-        void *mPointer;
-        unsigned int mAllocationSize;
-        int mAllocationType;
-        const char *mFileName;
-        int mLineNumber;
-        
-    } AllocationList;
-
-
-
 /**
  * Class that tracks memory allocations and deallocations.
  *
+ * Live allocations are kept in hash tables sharded by address, each
+ * shard with its own spin lock, so threads rarely wait on each other.
+ *
+ * Each allocation is charged to its allocation site (the code address
+ * that called new), and per-site counts are kept separately by each
+ * thread, so counting needs no shared writes.  Snapshots sum these counts,
+ * and diffs between two snapshots show which sites allocated, and how
+ * much, in between (for finding per-frame allocation churn).
+ *
+ * All internal storage is malloc'd, since new and delete lead back here.
+ *
  * @author Jason Rohrer
  */
 class MemoryTrack {
 
 
-        
+
     public:
 
-        
-        
+
+
         /**
          * Adds an allocation to this tracker and clears the allocated
          * memory block.
          *
          * @param inPointer a pointer to the allocated memory.
+         * @param inAllocationSize the size of the allocation in bytes.
          * @param inAllocationType the type of allocation,
          *   either SINGLE_ALLOCATION or ARRAY_ALLOCATION.
-         * @param inAllocationSize the size of the allocation in bytes.
          * @param inFileName the name of the source file in which the
          *   allocation took place.
          * @param inLineNumber the line number in the source file
          *   on which the allocation took place.
+         * @param inSiteAddress the code address that made the allocation,
+         *   which allocations are grouped by.
          */
         static void addAllocation( void *inPointer,
                                    unsigned int inAllocationSize,
                                    int inAllocationType,
                                    const char *inFileName,
-                                   int inLineNumber );
-        
-        
+                                   int inLineNumber,
+                                   void *inSiteAddress );
+
+
 
         /**
          * Adds a deallocation to this tracker and clears the block
@@ -115,29 +113,49 @@ class MemoryTrack {
          * been deallocated).
          */
         static void printLeaks();
-        
 
-        
-        // these are public so initializer can get to them
 
-        static MutexLock *mLock;
 
-        // dummy place holder for list head
-        static AllocationList *mListHead;
+        /**
+         * Records current per-site allocation counts.
+         *
+         * Only the most recent 64 snapshots are kept.
+         *
+         * @return an ID for the snapshot, or -1 if tracking is off.
+         */
+        static int takeSnapshot();
+
+
+
+        /**
+         * Writes the difference between two snapshots as CSV, one row
+         * per allocation site, sites that allocated the most in between
+         * first.
+         *
+         * Columns are site address, file, line, allocations and bytes
+         * allocated in between, and change in live allocations and live
+         * bytes.
+         *
+         * @param inOlderSnapshot, inNewerSnapshot IDs from takeSnapshot.
+         * @param inFileName the file to write.
+         * @return true on success, false if either snapshot is
+         *   no longer kept or the file can't be written.
+         */
+        static char writeSnapshotDiff( int inOlderSnapshot,
+                                       int inNewerSnapshot,
+                                       const char *inFileName );
+
+
+
+        // public so initializer can get to it
 
         // true if we're tracking
         static char mTracking;
-        
-        static int mTotalAllocationSize;
 
-        static int mTotalDeallocationSize;
-
-        static int mNumberOfAllocations;
-        
     protected:
 
 
-        
+
         /**
          * Clears memory so that reading from it will not produce
          * anything useful.  Good for checking for reads to memory that
@@ -149,53 +167,43 @@ class MemoryTrack {
         static void clearMemory( void *inPointer, unsigned int inSize );
 
 
-        
+
     };
 
 
 
 /**
- * Class that initializes MemoryTrack's static members.
+ * Class that turns MemoryTrack on and off.
  *
  * *All* files that use MemoryTrack will instantiate a static
  * instance of this class (see static instance below).
  *
  * This class counts how many static instantiations have happened so
- * far, making sure to init/destroy MemoryTrack's static members only once.
+ * far, making sure to start and stop tracking only once.
+ *
+ * MemoryTrack's own state is plain static data, set up on first use, so
+ * it's ready no matter which static constructor runs first.
  *
  * Adapted from:
  * http://www.hlrs.de/organization/par/services/tools/docu/kcc/
  *       tutorials/static_initialization.html
  */
 class MemoryTrackStaticInitCounter {
-    
+
 
     public:
 
 
-        
+
         MemoryTrackStaticInitCounter() {
             if( mCount == 0 ) {
-                // allocate static members
-                MemoryTrack::mLock = new MutexLock();
-
-                MemoryTrack::mListHead =
-                    (AllocationList *)
-                        malloc( sizeof( AllocationList ) );
-                MemoryTrack::mListHead->mPrevious = NULL;
-                MemoryTrack::mListHead->mNext = NULL;
-
-                MemoryTrack::mTotalAllocationSize = 0;
-                MemoryTrack::mTotalDeallocationSize = 0;
-                MemoryTrack::mNumberOfAllocations = 0;
-                
                 MemoryTrack::mTracking = true;
                 }
             mCount++;
             }
 
 
-        
+
         ~MemoryTrackStaticInitCounter() {
             mCount--;
             if( mCount == 0 ) {
@@ -205,17 +213,14 @@ class MemoryTrackStaticInitCounter {
                 MemoryTrack::printLeaks();
 
                 MemoryTrack::mTracking = false;
-                // deallocate static members
-                free( MemoryTrack::mListHead );
-                delete MemoryTrack::mLock;
                 }
             }
 
-        
+
     private:
-        // only allocate/deallocate when mCount == 0
+        // only start/stop when mCount == 0
         static int mCount;
-        
+
     };
 
 
@@ -226,5 +231,3 @@ static MemoryTrackStaticInitCounter memoryTrackInitializer;
 
 
 #endif
-
-
@@ -16,6 +16,9 @@
  * 2002-October-20  Jason Rohrer
  * Removed delete macro trick that was causing crashes in tinyxml.
  * Removed function that was no longer being used.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Passed return address to MemoryTrack as allocation site.
  */
 
 
@@ -31,8 +34,16 @@
 #include "stdio.h"
 
 
+#ifdef _MSC_VER
+    #include <intrin.h>
+    #define DEBUG_MEMORY_RETURN_ADDRESS() _ReturnAddress()
+#else
+    #define DEBUG_MEMORY_RETURN_ADDRESS() __builtin_return_address( 0 )
+#endif
+
+
 
-void *debugMemoryNew( unsigned int inSize,
+void *debugMemoryNew( size_t inSize,
                       const char *inFileName, int inLine ) {
 
     
@@ -40,17 +51,18 @@ void *debugMemoryNew( unsigned int inSize,
 
     MemoryTrack::addAllocation( allocatedPointer, inSize,
                                 SINGLE_ALLOCATION,
-                                inFileName, inLine );
+                                inFileName, inLine,
+                                DEBUG_MEMORY_RETURN_ADDRESS() );
     
     return allocatedPointer;    
     }
 
 
 
-void *debugMemoryNewArray( unsigned int inSize,
+void *debugMemoryNewArray( size_t inSize,
                            const char *inFileName, int inLine ) {
 
-    unsigned int mallocSize = inSize;
+    size_t mallocSize = inSize;
     if( inSize == 0 ) {
         // always allocate at least one byte to circumvent differences
         // between malloc and new[] on some platforms
@@ -63,7 +75,8 @@ void *debugMemoryNewArray( unsigned int inSize,
 
     MemoryTrack::addAllocation( allocatedPointer, inSize,
                                 ARRAY_ALLOCATION,
-                                inFileName, inLine );
+                                inFileName, inLine,
+                                DEBUG_MEMORY_RETURN_ADDRESS() );
     
     return allocatedPointer;    
     }
@@ -9,6 +9,10 @@
  *
  * 2002-October-20  Jason Rohrer
  * Removed delete macro trick that was causing crashes in tinyxml.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Fixed new operators to take size_t, as required on 64-bit platforms.
+ * Forced new operators inline, so each allocation site has its own address.
  */
 
 
@@ -22,13 +26,18 @@
 
 #include "minorGems/util/development/memory/MemoryTrack.h"
 
+#include <stddef.h>
+
 
 
 // internal function prototypes
-void *debugMemoryNew( unsigned int inSize,
+// these charge the allocation to the code address they return to, which
+// is the new expression itself, since the operators below are always
+// inlined
+void *debugMemoryNew( size_t inSize,
                       const char *inFileName, int inLine );
 
-void *debugMemoryNewArray( unsigned int inSize,
+void *debugMemoryNewArray( size_t inSize,
                            const char *inFileName, int inLine );
 
 void debugMemoryDelete( void *inPointer );
@@ -39,6 +48,12 @@ void debugMemoryDeleteArray( void *inPointer );
 
 // overrided primitive operators... must be inline?
 
+#ifdef _MSC_VER
+    #define DEBUG_MEMORY_FORCE_INLINE __forceinline
+#else
+    #define DEBUG_MEMORY_FORCE_INLINE inline __attribute__((always_inline))
+#endif
+
 
 
 /**
@@ -49,8 +64,9 @@ void debugMemoryDeleteArray( void *inPointer );
  *   occurred.
  * @param inLine the line in the source file where the allocation occurred.
  */
-inline void *operator new( unsigned int inSize,
-                           const char *inFileName, int inLine ) {
+DEBUG_MEMORY_FORCE_INLINE void *operator new( size_t inSize,
+                                              const char *inFileName,
+                                              int inLine ) {
     return debugMemoryNew( inSize, inFileName, inLine );
     }
 
@@ -64,8 +80,9 @@ inline void *operator new( unsigned int inSize,
  *   occurred.
  * @param inLine the line in the source file where the allocation occurred.
  */
-inline void * operator new [] ( unsigned int inSize,
-                                const char *inFileName, int inLine ) {
+DEBUG_MEMORY_FORCE_INLINE void * operator new [] ( size_t inSize,
+                                                   const char *inFileName,
+                                                   int inLine ) {
 
     return debugMemoryNewArray( inSize, inFileName, inLine );
     }
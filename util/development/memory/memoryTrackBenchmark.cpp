@@ -0,0 +1,125 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+/**
+ * Measures new/delete cost with MemoryTrack on, from one thread and from
+ * several at once, each thread keeping a pool of live blocks so that the
+ * tracker holds a realistic number of allocations.  Then writes the
+ * snapshot diff of one simulated frame to memoryChurn.csv.
+ *
+ * Compile from above the minorGems directory with:
+ *   g++ -O2 -DDEBUG_MEMORY -I.
+ *     minorGems/util/development/memory/memoryTrackBenchmark.cpp
+ *     minorGems/util/development/memory/debugMemory.cpp
+ *     minorGems/util/development/memory/MemoryTrack.cpp
+ *     minorGems/system/linux/ThreadLinux.cpp
+ *     minorGems/system/linux/MutexLockLinux.cpp
+ *     minorGems/system/unix/TimeUnix.cpp -lpthread -o memoryTrackBenchmark
+ */
+
+#include "minorGems/util/development/memory/debugMemory.h"
+
+#include "minorGems/system/Thread.h"
+#include "minorGems/system/Time.h"
+
+#include <stdio.h>
+
+
+
+#define NUM_OPERATIONS 1000000
+#define LIVE_BLOCKS_PER_THREAD 1024
+#define NUM_THREADS 4
+
+
+
+static void churn( int inNumOperations ) {
+    char *blocks[ LIVE_BLOCKS_PER_THREAD ];
+
+    for( int i=0; i<LIVE_BLOCKS_PER_THREAD; i++ ) {
+        blocks[i] = new char[ 16 + i % 64 ];
+        }
+
+    for( int i=0; i<inNumOperations; i++ ) {
+        // replace oldest
+        int b = i % LIVE_BLOCKS_PER_THREAD;
+
+        delete [] blocks[b];
+        blocks[b] = new char[ 16 + i % 64 ];
+        }
+
+    for( int i=0; i<LIVE_BLOCKS_PER_THREAD; i++ ) {
+        delete [] blocks[i];
+        }
+    }
+
+
+
+class ChurnThread : public Thread {
+    public:
+        virtual void run() {
+            churn( NUM_OPERATIONS );
+            }
+    };
+
+
+
+static void simulateFrame() {
+    // per-frame garbage, all freed before frame ends
+    for( int i=0; i<100; i++ ) {
+        int *temp = new int[ 32 ];
+        delete [] temp;
+        }
+
+    // one leak per frame
+    new char[ 8 ];
+    }
+
+
+
+int main() {
+
+    double startTime = Time::getCurrentTime();
+
+    churn( NUM_OPERATIONS );
+
+    double singleTime = Time::getCurrentTime() - startTime;
+
+    printf( "1 thread:   %.0f ns per new/delete pair\n",
+            1000000000 * singleTime / NUM_OPERATIONS );
+
+
+    ChurnThread threads[ NUM_THREADS ];
+
+    startTime = Time::getCurrentTime();
+
+    for( int i=0; i<NUM_THREADS; i++ ) {
+        threads[i].start();
+        }
+    for( int i=0; i<NUM_THREADS; i++ ) {
+        threads[i].join();
+        }
+
+    double multiTime = Time::getCurrentTime() - startTime;
+
+    printf( "%d threads:  %.0f ns per new/delete pair (wall clock, "
+            "all threads)\n",
+            NUM_THREADS,
+            1000000000 * multiTime / ( NUM_THREADS * NUM_OPERATIONS ) );
+
+
+    int before = MemoryTrack::takeSnapshot();
+
+    simulateFrame();
+
+    int after = MemoryTrack::takeSnapshot();
+
+    if( MemoryTrack::writeSnapshotDiff( before, after, "memoryChurn.csv" ) ) {
+        printf( "Frame allocation diff written to memoryChurn.csv\n" );
+        }
+
+    return 0;
+    }
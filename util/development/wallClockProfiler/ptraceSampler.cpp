@@ -0,0 +1,332 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+
+#include "ptraceSampler.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <dirent.h>
+#include <signal.h>
+#include <sys/ptrace.h>
+#include <sys/wait.h>
+
+#include <libunwind-ptrace.h>
+
+
+
+// deeper stacks are cut off at this many frames
+#define MAX_STACK_DEPTH 256
+
+
+
+typedef struct TracedThread {
+        int tid;
+
+        char name[32];
+
+        // libunwind's per-thread ptrace state, made on first unwind
+        void *unwindInfo;
+
+        // set while stopped for a sample
+        char stopped;
+
+        // signal that arrived instead of our interrupt, to be delivered
+        // when we resume thread
+        int pendingSignal;
+    } TracedThread;
+
+
+
+static int tracedPID = -1;
+
+static SimpleVector<TracedThread> tracedThreads;
+
+static unw_addr_space_t addressSpace;
+
+
+
+static void readThreadName( int inTID, char *outName, int inMaxLength ) {
+    char path[64];
+    snprintf( path, sizeof( path ), "/proc/%d/task/%d/comm",
+              tracedPID, inTID );
+
+    outName[0] = '\0';
+
+    FILE *f = fopen( path, "r" );
+
+    if( f != NULL ) {
+        if( fgets( outName, inMaxLength, f ) != NULL ) {
+            char *newline = strchr( outName, '\n' );
+            if( newline != NULL ) {
+                newline[0] = '\0';
+                }
+            }
+        fclose( f );
+        }
+    }
+
+
+
+static TracedThread *findThread( int inTID ) {
+    for( int i=0; i<tracedThreads.size(); i++ ) {
+        TracedThread *t = tracedThreads.getElement( i );
+        if( t->tid == inTID ) {
+            return t;
+            }
+        }
+    return NULL;
+    }
+
+
+
+// attaches to any threads not yet traced
+// PTRACE_SEIZE leaves thread running, and lets us stop it later with
+// PTRACE_INTERRUPT, without sending it a signal
+static void attachNewThreads() {
+    char path[64];
+    snprintf( path, sizeof( path ), "/proc/%d/task", tracedPID );
+
+    DIR *dir = opendir( path );
+
+    if( dir == NULL ) {
+        return;
+        }
+
+    struct dirent *entry;
+
+    while( ( entry = readdir( dir ) ) != NULL ) {
+        int tid;
+
+        if( sscanf( entry->d_name, "%d", &tid ) != 1 ||
+            findThread( tid ) != NULL ) {
+            continue;
+            }
+
+        if( ptrace( PTRACE_SEIZE, tid, NULL, NULL ) != 0 ) {
+            // thread may have just exited
+            continue;
+            }
+
+        TracedThread t;
+        t.tid = tid;
+        readThreadName( tid, t.name, sizeof( t.name ) );
+        t.unwindInfo = NULL;
+        t.stopped = false;
+        t.pendingSignal = 0;
+
+        tracedThreads.push_back( t );
+        }
+
+    closedir( dir );
+    }
+
+
+
+static void forgetThread( int inIndex ) {
+    TracedThread *t = tracedThreads.getElement( inIndex );
+
+    if( t->unwindInfo != NULL ) {
+        _UPT_destroy( t->unwindInfo );
+        }
+    tracedThreads.deleteElement( inIndex );
+    }
+
+
+
+char ptraceSamplerAttach( int inPID ) {
+    tracedPID = inPID;
+
+    addressSpace = unw_create_addr_space( &_UPT_accessors, 0 );
+
+    if( addressSpace == NULL ) {
+        printf( "Failed to create libunwind address space\n" );
+        return false;
+        }
+
+    // unwind info for each code address is looked up once and kept
+    unw_set_caching_policy( addressSpace, UNW_CACHE_GLOBAL );
+
+    attachNewThreads();
+
+    if( findThread( inPID ) == NULL ) {
+        printf( "Failed to attach to PID %d with ptrace:  %s\n",
+                inPID, strerror( errno ) );
+        return false;
+        }
+
+    return true;
+    }
+
+
+
+// interrupts all threads and waits until each has stopped or exited
+// threads that exited are left with stopped false
+//
+// waits on any thread rather than each in turn:  when process exits, the
+// main thread's exit isn't reported until every other thread's exit has
+// been collected, so waiting on it first would hang
+static void stopAllThreads() {
+    int numWaiting = 0;
+
+    for( int i=0; i<tracedThreads.size(); i++ ) {
+        TracedThread *t = tracedThreads.getElement( i );
+
+        t->stopped = false;
+        t->pendingSignal = 0;
+
+        if( ptrace( PTRACE_INTERRUPT, t->tid, NULL, NULL ) == 0 ) {
+            numWaiting++;
+            }
+        }
+
+    while( numWaiting > 0 ) {
+        int status;
+
+        int tid = waitpid( -1, &status, __WALL );
+
+        if( tid == -1 ) {
+            if( errno == EINTR ) {
+                continue;
+                }
+            // nothing left to wait for
+            break;
+            }
+
+        TracedThread *t = findThread( tid );
+
+        if( t == NULL || t->stopped ) {
+            // not ours, or a stop we already counted
+            continue;
+            }
+
+        if( WIFEXITED( status ) || WIFSIGNALED( status ) ) {
+            numWaiting--;
+            }
+        else if( WIFSTOPPED( status ) ) {
+            t->stopped = true;
+            numWaiting--;
+
+            if( ( status >> 16 ) != PTRACE_EVENT_STOP ) {
+                // a real signal got there first
+                // we sample here, and our interrupt stays queued, to
+                // stop thread again soon after it's resumed, which a
+                // later sample will consume
+                t->pendingSignal = WSTOPSIG( status );
+                }
+            }
+        }
+    }
+
+
+
+static void unwindThread( TracedThread *inThread,
+                          SimpleVector<SampledStack> *outStacks ) {
+    if( inThread->unwindInfo == NULL ) {
+        inThread->unwindInfo = _UPT_create( inThread->tid );
+
+        if( inThread->unwindInfo == NULL ) {
+            return;
+            }
+        }
+
+    unw_cursor_t cursor;
+
+    if( unw_init_remote( &cursor, addressSpace,
+                         inThread->unwindInfo ) < 0 ) {
+        return;
+        }
+
+    SampledStack stack;
+    stack.threadID = inThread->tid;
+    stack.threadName = inThread->name;
+
+    outStacks->push_back( stack );
+
+    SimpleVector<void*> *addresses =
+        &( outStacks->getElement( outStacks->size() - 1 )->addresses );
+
+    do {
+        unw_word_t ip;
+
+        if( unw_get_reg( &cursor, UNW_REG_IP, &ip ) < 0 || ip == 0 ) {
+            break;
+            }
+
+        if( addresses->size() > 0 ) {
+            // return address, which may be first instruction of next
+            // source line
+            ip--;
+            }
+
+        addresses->push_back( (void*)ip );
+        }
+    while( addresses->size() < MAX_STACK_DEPTH &&
+           unw_step( &cursor ) > 0 );
+    }
+
+
+
+char ptraceSamplerSample( SimpleVector<SampledStack> *outStacks ) {
+    attachNewThreads();
+
+
+    // stop all first, so stacks are a consistent snapshot
+    stopAllThreads();
+
+
+    char mainAlive = false;
+
+    for( int i=0; i<tracedThreads.size(); i++ ) {
+        TracedThread *t = tracedThreads.getElement( i );
+
+        if( ! t->stopped ) {
+            // exited
+            forgetThread( i );
+            i--;
+            continue;
+            }
+
+        if( t->tid == tracedPID ) {
+            mainAlive = true;
+            }
+
+        unwindThread( t, outStacks );
+
+        ptrace( PTRACE_CONT, t->tid, NULL,
+                (void*)(long)( t->pendingSignal ) );
+        }
+
+    return mainAlive;
+    }
+
+
+
+void ptraceSamplerDetach() {
+    // threads must be stopped to detach
+    stopAllThreads();
+
+    for( int i=0; i<tracedThreads.size(); i++ ) {
+        TracedThread *t = tracedThreads.getElement( i );
+
+        if( t->stopped ) {
+            ptrace( PTRACE_DETACH, t->tid, NULL,
+                    (void*)(long)( t->pendingSignal ) );
+            }
+        }
+
+    while( tracedThreads.size() > 0 ) {
+        forgetThread( tracedThreads.size() - 1 );
+        }
+
+    if( addressSpace != NULL ) {
+        unw_destroy_addr_space( addressSpace );
+        addressSpace = NULL;
+        }
+    }
@@ -0,0 +1,63 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+
+
+#ifndef PTRACE_SAMPLER_INCLUDED
+#define PTRACE_SAMPLER_INCLUDED
+
+
+#include "minorGems/util/SimpleVector.h"
+
+
+
+/**
+ * Stack sampling through ptrace and libunwind, with no debugger in the
+ * loop.
+ *
+ * Every thread of the target is stopped for each sample, whether it is
+ * running or blocked, so samples keep wall-clock semantics:  time spent
+ * sleeping, waiting on locks, or in system calls shows up too.
+ *
+ * Linux only.  Needs libunwind (libunwind-dev), and permission to trace
+ * the target (same user, with ptrace_scope allowing it, or root).
+ */
+
+
+
+typedef struct SampledStack {
+        int threadID;
+
+        // from /proc, NOT destroyed by receiver
+        const char *threadName;
+
+        // innermost first
+        // for all but innermost, address is just inside call instruction
+        // (one before return address), so it maps to call's source line
+        SimpleVector<void*> addresses;
+    } SampledStack;
+
+
+
+// attaches to all current threads of process
+// returns true on success
+char ptraceSamplerAttach( int inPID );
+
+
+// stops all threads of process, records a stack for each, and resumes them
+// threads started since last sample are attached first
+// stacks added to end of outStacks
+// returns false if process has exited
+char ptraceSamplerSample( SimpleVector<SampledStack> *outStacks );
+
+
+// detaches from any threads still alive, leaving process running
+void ptraceSamplerDetach();
+
+
+
+#endif
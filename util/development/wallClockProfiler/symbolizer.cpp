@@ -0,0 +1,338 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+
+#include "symbolizer.h"
+
+#include "minorGems/util/SimpleVector.h"
+#include "minorGems/util/stringUtils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+
+typedef struct Mapping {
+        unsigned long start;
+        unsigned long end;
+
+        // offset of start in file
+        unsigned long fileOffset;
+
+        // file path, or [vdso] and the like
+        char *path;
+
+        // true for shared objects and position-independent executables,
+        // where addr2line wants addresses relative to load address
+        char relocatable;
+    } Mapping;
+
+
+
+static SimpleVector<Mapping> mappings;
+
+
+
+static char isRelocatable( const char *inPath ) {
+    FILE *f = fopen( inPath, "rb" );
+
+    if( f == NULL ) {
+        return true;
+        }
+
+    unsigned char header[18];
+
+    int numRead = fread( header, 1, 18, f );
+    fclose( f );
+
+    if( numRead != 18 || memcmp( header, "\177ELF", 4 ) != 0 ) {
+        return true;
+        }
+
+    // e_type, little endian:  ET_EXEC is 2, ET_DYN is 3
+    int type = header[16] | ( header[17] << 8 );
+
+    return ( type != 2 );
+    }
+
+
+
+// returns -1 if not found
+static int findMapping( void *inAddress ) {
+    unsigned long a = (unsigned long)inAddress;
+
+    // newest first, in case an address range was reused by a later load
+    for( int i=mappings.size()-1; i>=0; i-- ) {
+        Mapping *m = mappings.getElement( i );
+
+        if( a >= m->start && a < m->end ) {
+            return i;
+            }
+        }
+    return -1;
+    }
+
+
+
+void symbolizerReadMaps( int inPID ) {
+    char *path = autoSprintf( "/proc/%d/maps", inPID );
+
+    FILE *f = fopen( path, "r" );
+
+    delete [] path;
+
+    if( f == NULL ) {
+        return;
+        }
+
+    char line[4096];
+
+    while( fgets( line, sizeof( line ), f ) != NULL ) {
+        unsigned long start, end, offset;
+        char perms[8];
+        int pathStart = 0;
+
+        if( sscanf( line, "%lx-%lx %7s %lx %*s %*d %n",
+                    &start, &end, perms, &offset, &pathStart ) < 4 ||
+            perms[2] != 'x' ) {
+            continue;
+            }
+
+        char *mapPath = &( line[ pathStart ] );
+
+        char *newline = strchr( mapPath, '\n' );
+        if( newline != NULL ) {
+            newline[0] = '\0';
+            }
+
+        char seen = false;
+
+        for( int i=0; i<mappings.size(); i++ ) {
+            Mapping *m = mappings.getElement( i );
+
+            if( m->start == start && m->end == end &&
+                strcmp( m->path, mapPath ) == 0 ) {
+                seen = true;
+                break;
+                }
+            }
+
+        if( seen ) {
+            continue;
+            }
+
+        Mapping m;
+        m.start = start;
+        m.end = end;
+        m.fileOffset = offset;
+
+        if( mapPath[0] == '\0' ) {
+            m.path = stringDuplicate( "[anonymous]" );
+            }
+        else {
+            m.path = stringDuplicate( mapPath );
+            }
+
+        m.relocatable = isRelocatable( m.path );
+
+        mappings.push_back( m );
+        }
+
+    fclose( f );
+    }
+
+
+
+char symbolizerKnowsAddress( void *inAddress ) {
+    return ( findMapping( inAddress ) != -1 );
+    }
+
+
+
+static unsigned long getModuleAddress( Mapping *inMapping, void *inAddress ) {
+    unsigned long a = (unsigned long)inAddress;
+
+    if( inMapping->relocatable ) {
+        return a - inMapping->start + inMapping->fileOffset;
+        }
+    return a;
+    }
+
+
+
+// runs addr2line once for all addresses in one module
+// inIndices are indices into inAddresses (and outputs) of those addresses
+static void lookupInModule( Mapping *inMapping,
+                            SimpleVector<int> *inIndices,
+                            void **inAddresses,
+                            char **outFuncNames, char **outFileNames,
+                            int *outLineNums ) {
+
+    if( inMapping->path[0] != '/' ) {
+        // [vdso] and such have no file to read
+        return;
+        }
+
+    char inName[] = "/tmp/wcAddressesXXXXXX";
+    char outName[] = "/tmp/wcSymbolsXXXXXX";
+
+    int inFD = mkstemp( inName );
+    int outFD = mkstemp( outName );
+
+    if( inFD == -1 || outFD == -1 ) {
+        printf( "Failed to make temp files for addr2line\n" );
+        if( inFD != -1 ) {
+            close( inFD );
+            unlink( inName );
+            }
+        if( outFD != -1 ) {
+            close( outFD );
+            unlink( outName );
+            }
+        return;
+        }
+
+    close( outFD );
+
+    FILE *inFile = fdopen( inFD, "w" );
+
+    for( int i=0; i<inIndices->size(); i++ ) {
+        int index = inIndices->getElementDirect( i );
+
+        fprintf( inFile, "%lx\n",
+                 getModuleAddress( inMapping, inAddresses[ index ] ) );
+        }
+    fclose( inFile );
+
+
+    char *command = autoSprintf( "addr2line -C -f -e '%s' < %s > %s",
+                                 inMapping->path, inName, outName );
+
+    int result = system( command );
+
+    delete [] command;
+
+    if( result != 0 ) {
+        printf( "addr2line failed for %s\n", inMapping->path );
+        }
+    else {
+        FILE *outFile = fopen( outName, "r" );
+
+        if( outFile != NULL ) {
+            // two lines per address, function and then file:line
+            char funcLine[4096];
+            char fileLine[4096];
+
+            for( int i=0; i<inIndices->size(); i++ ) {
+                if( fgets( funcLine, sizeof( funcLine ), outFile ) == NULL ||
+                    fgets( fileLine, sizeof( fileLine ), outFile ) == NULL ) {
+                    break;
+                    }
+
+                int index = inIndices->getElementDirect( i );
+
+                char *newline = strchr( funcLine, '\n' );
+                if( newline != NULL ) {
+                    newline[0] = '\0';
+                    }
+
+                if( strcmp( funcLine, "??" ) != 0 ) {
+                    delete [] outFuncNames[ index ];
+                    outFuncNames[ index ] = stringDuplicate( funcLine );
+                    }
+
+                // file:line, maybe followed by " (discriminator N)"
+                char *colon = strrchr( fileLine, ':' );
+                char *space = strchr( fileLine, ' ' );
+                if( space != NULL && colon != NULL && space > colon ) {
+                    space[0] = '\0';
+                    colon = strrchr( fileLine, ':' );
+                    }
+
+                if( colon != NULL && fileLine[0] != '?' ) {
+                    colon[0] = '\0';
+
+                    int lineNum = -1;
+                    sscanf( &( colon[1] ), "%d", &lineNum );
+
+                    if( lineNum > 0 ) {
+                        delete [] outFileNames[ index ];
+                        outFileNames[ index ] = stringDuplicate( fileLine );
+                        outLineNums[ index ] = lineNum;
+                        }
+                    }
+                }
+            fclose( outFile );
+            }
+        }
+
+    unlink( inName );
+    unlink( outName );
+    }
+
+
+
+void symbolizerLookup( int inNumAddresses, void **inAddresses,
+                       char **outFuncNames, char **outFileNames,
+                       int *outLineNums ) {
+
+    // addresses of each mapping, by mapping index
+    SimpleVector<int> *mappingAddresses =
+        new SimpleVector<int>[ mappings.size() ];
+
+    for( int i=0; i<inNumAddresses; i++ ) {
+        int mapIndex = findMapping( inAddresses[i] );
+
+        // defaults, replaced by anything addr2line finds
+        if( mapIndex != -1 ) {
+            Mapping *m = mappings.getElement( mapIndex );
+
+            const char *moduleName = strrchr( m->path, '/' );
+
+            if( moduleName != NULL ) {
+                moduleName = &( moduleName[1] );
+                }
+            else {
+                moduleName = m->path;
+                }
+
+            outFuncNames[i] =
+                autoSprintf( "%s+0x%lx", moduleName,
+                             getModuleAddress( m, inAddresses[i] ) );
+
+            mappingAddresses[ mapIndex ].push_back( i );
+            }
+        else {
+            outFuncNames[i] = autoSprintf( "%p", inAddresses[i] );
+            }
+
+        outFileNames[i] = stringDuplicate( "" );
+        outLineNums[i] = -1;
+        }
+
+
+    for( int i=0; i<mappings.size(); i++ ) {
+        if( mappingAddresses[i].size() > 0 ) {
+            lookupInModule( mappings.getElement( i ), &( mappingAddresses[i] ),
+                            inAddresses,
+                            outFuncNames, outFileNames, outLineNums );
+            }
+        }
+
+    delete [] mappingAddresses;
+    }
+
+
+
+void symbolizerFree() {
+    for( int i=0; i<mappings.size(); i++ ) {
+        delete [] mappings.getElement( i )->path;
+        }
+    mappings.deleteAll();
+    }
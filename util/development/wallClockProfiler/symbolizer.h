@@ -0,0 +1,48 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+
+
+#ifndef SYMBOLIZER_INCLUDED
+#define SYMBOLIZER_INCLUDED
+
+
+
+/**
+ * Maps raw code addresses from a sampled process to function, file, and
+ * line, using the process's memory map and addr2line (from binutils).
+ *
+ * Addresses are looked up in one batch per module at the end, so none of
+ * this slows down sampling.
+ */
+
+
+
+// reads executable mappings of process from /proc, adding any not seen
+// before (mappings of unloaded libraries are kept, for older samples)
+// call once while attached, and again whenever symbolizerKnowsAddress
+// says no, since code may have been loaded since
+void symbolizerReadMaps( int inPID );
+
+
+char symbolizerKnowsAddress( void *inAddress );
+
+
+// looks up inNumAddresses addresses
+// every output string is newly allocated and destroyed by caller
+// outFuncNames get module+offset when no symbol is known, outFileNames
+// get "" and outLineNums -1 when no line is known
+void symbolizerLookup( int inNumAddresses, void **inAddresses,
+                       char **outFuncNames, char **outFileNames,
+                       int *outLineNums );
+
+
+void symbolizerFree();
+
+
+
+#endif
@@ -3,24 +3,35 @@
 #include <unistd.h>
 #include <signal.h>
 #include <fcntl.h>
+#include <errno.h>
 #include <sys/prctl.h>
+#include <sys/wait.h>
 
 #include <time.h>
 
 
 #include "minorGems/util/stringUtils.h"
 #include "minorGems/util/SimpleVector.h"
+#include "minorGems/util/HashMap.h"
+
+#include "ptraceSampler.h"
+#include "symbolizer.h"
 
 
 static void usage() {
     printf( "\nDirect call usage:\n\n"
-            "    wallClockProfiler samples_per_sec ./myProgram\n\n" );
+            "    wallClockProfiler [-gdb] samples_per_sec ./myProgram\n\n" );
     printf( "Attach to existing process (may require root):\n\n"
-            "    wallClockProfiler samples_per_sec ./myProgram pid "
+            "    wallClockProfiler [-gdb] samples_per_sec ./myProgram pid "
             "[detatch_sec]\n\n" );
     printf( "detatch_sec is the (optional) number of seconds before detatching and\n"
             "ending profiling (or -1 to stay attached forever, default)\n\n" );
-    
+    printf( "By default, all threads are sampled directly with ptrace and\n"
+            "libunwind.  -gdb samples through gdb instead (much slower,\n"
+            "and only the interrupted thread).\n\n" );
+    printf( "Besides the report, folded stacks for flame graph tools are\n"
+            "written to wcFolded.txt\n\n" );
+
     exit( 1 );
     }
 
@@ -47,15 +58,15 @@ char programExited = false;
 static int fillBufferWithResponse() {
     int readSoFar = 0;
     while( true ) {
-        int numRead = 
+        int numRead =
             read( inPipe, &( readBuff[readSoFar] ), 4095 - readSoFar );
-        
+
         if( numRead > 0 ) {
-            
+
             readSoFar += numRead;
-            
+
             readBuff[ readSoFar ] = '\0';
-        
+
             if( strstr( readBuff, "(gdb)" ) != NULL ) {
                 // read full response
                 return readSoFar;
@@ -76,7 +87,7 @@ static void checkProgramExited() {
 
 static void printGDBResponse() {
     int numRead = fillBufferWithResponse();
-    
+
     if( numRead > 0 ) {
         checkProgramExited();
         printf( "\n\nRead from GDB:  %s", readBuff );
@@ -87,7 +98,7 @@ static void printGDBResponse() {
 
 static void printGDBResponseToFile( FILE *inFile ) {
     int numRead = fillBufferWithResponse();
-    
+
     if( numRead > 0 ) {
         checkProgramExited();
         fprintf( inFile, "\n\nRead from GDB:  %s", readBuff );
@@ -113,29 +124,22 @@ typedef struct StackFrame{
 
 
 typedef struct Stack {
+        char *threadName;
+        // innermost first
         SimpleVector<StackFrame> frames;
         int sampleCount;
     } Stack;
 
-    
+
 
 
 SimpleVector<Stack> stackLog;
 
 
+// maps thread name and frame addresses of each logged stack to its
+// index in stackLog
+HashMap<char*, int> stackLogIndex;
 
-static char stackCompare( Stack *inA, Stack *inB ) {
-    if( inA->frames.size() != inB->frames.size() ) {
-        return false;
-        }
-    for( int i=0; i<inA->frames.size(); i++ ) {
-        if( inA->frames.getElementDirect( i ).address !=
-            inB->frames.getElementDirect( i ).address ) {
-            return false;
-            }    
-        }
-    return true;
-    }
 
 
 static void freeStack( Stack *inStack ) {
@@ -145,35 +149,68 @@ static void freeStack( Stack *inStack ) {
         delete [] f.fileName;
         }
     inStack->frames.deleteAll();
+    delete [] inStack->threadName;
+    }
+
+
+
+// takes ownership of inStack's contents
+static void addStack( Stack *inStack ) {
+    SimpleVector<char> keyChars;
+
+    keyChars.appendElementString( inStack->threadName );
+
+    for( int i=0; i<inStack->frames.size(); i++ ) {
+        char addressString[32];
+        snprintf( addressString, sizeof( addressString ), " %p",
+                  inStack->frames.getElement( i )->address );
+        keyChars.appendElementString( addressString );
+        }
+
+    char *key = keyChars.getElementString();
+
+    int *index = stackLogIndex.lookupPointer( key );
+
+    if( index != NULL ) {
+        stackLog.getElement( *index )->sampleCount++;
+        freeStack( inStack );
+        }
+    else {
+        inStack->sampleCount = 1;
+        stackLogIndex.insert( key, stackLog.size() );
+        stackLog.push_back( *inStack );
+        }
+
+    delete [] key;
     }
 
 
-    
+
 
 static StackFrame parseFrame( char *inFrameString ) {
     StackFrame newF;
-    
+
     char *openPos = strstr( inFrameString, "{" );
-    
+
     if( openPos == NULL ) {
         printf( "Error parsing stack frame:  %s\n", inFrameString );
         exit( 1 );
         }
     openPos = &( openPos[1] );
-    
+
     char *closePos = strstr( openPos, "}" );
-    
+
     if( closePos == NULL ) {
         printf( "Error parsing stack frame:  %s\n", inFrameString );
         exit( 1 );
         }
     closePos[0] ='\0';
-    
+
     int numVals;
     char **vals = split( openPos, ",", &numVals );
-    
+
     void *address = NULL;
-    
+
     for( int i=0; i<numVals; i++ ) {
         if( strstr( vals[i], "addr=" ) == vals[i] ) {
             sscanf( vals[i], "addr=\"%p\"", &address );
@@ -185,7 +222,7 @@ static StackFrame parseFrame( char *inFrameString ) {
     newF.lineNum = -1;
     newF.funcName = NULL;
     newF.fileName = NULL;
-    
+
     for( int i=0; i<numVals; i++ ) {
         if( strstr( vals[i], "func=" ) == vals[i] ) {
             newF.funcName = new char[ 500 ];
@@ -199,14 +236,14 @@ static StackFrame parseFrame( char *inFrameString ) {
             sscanf( vals[i], "line=\"%d\"", &newF.lineNum );
             }
         }
-    
+
     if( newF.fileName == NULL ) {
         newF.fileName = stringDuplicate( "" );
         }
     if( newF.funcName == NULL ) {
         newF.funcName = stringDuplicate( "" );
         }
-    
+
     char *quotePos = strstr( newF.fileName, "\"" );
     if( quotePos != NULL ) {
         quotePos[0] ='\0';
@@ -229,106 +266,78 @@ static StackFrame parseFrame( char *inFrameString ) {
 
 static void logGDBStackResponse() {
     int numRead = fillBufferWithResponse();
-    
+
     if( numRead == 0 ) {
         return;
         }
-    
+
 
     checkProgramExited();
-        
+
     if( programExited ) {
         return;
         }
-    
+
     const char *stackStartMarker = ",stack=[";
-    
+
     char *stackStartPos = strstr( readBuff, ",stack=[" );
-        
+
     if( stackStartPos == NULL ) {
         return;
         }
-    
+
     char *stackStart = &( stackStartPos[ strlen( stackStartMarker ) ] );
-    
+
     char *closeBracket = strstr( stackStart, "]\n" );
-    
+
     if( closeBracket == NULL ) {
         return;
         }
-    
+
     // terminate at close
     closeBracket[0] = '\0';
-    
+
     const char *frameMarker = "frame=";
-    
+
     if( strstr( stackStart, frameMarker ) != stackStart ) {
         return;
         }
-    
+
     // skip first
     stackStart = &( stackStart[ strlen( frameMarker ) ] );
-    
+
     int numFrames;
     char **frames = split( stackStart, frameMarker, &numFrames );
 
     Stack thisStack;
-    thisStack.sampleCount = 1;
+    // gdb only reports the thread that took the SIGINT
+    thisStack.threadName = stringDuplicate( "interrupted" );
     for( int i=0; i<numFrames; i++ ) {
         thisStack.frames.push_back( parseFrame( frames[i] ) );
         delete [] frames[i];
         }
     delete [] frames;
 
-    
-    char match = false;
-    for( int i=0; i<stackLog.size(); i++ ) {
-        Stack *inOld = stackLog.getElement( i );
-        
-        if( stackCompare( inOld, &thisStack ) ) {
-            match = true;
-            inOld->sampleCount++;
-            break;
-            }
-        }
-    
-    if( match ) {
-        freeStack( &thisStack );
-        }
-    else {
-        stackLog.push_back( thisStack );
-        }
+    addStack( &thisStack );
     }
 
 
 
-
-
-int main( int inNumArgs, char **inArgs ) {
-    
-    if( inNumArgs != 3 && inNumArgs != 4 && inNumArgs != 5 ) {
-        usage();
-        }
-    
-    int samplesPerSecond = 100;
-    
-    sscanf( inArgs[1], "%d", &samplesPerSecond );
-    
-
-
+// returns number of samples taken
+static int gdbSample( int inSamplesPerSecond, int inNumArgs, char **inArgs ) {
     int readPipe[2];
     int writePipe[2];
-    
+
     pipe( readPipe );
     pipe( writePipe );
-    
-    
+
+
 
     int childPID = fork();
-    
+
     if( childPID == -1 ) {
         printf( "Failed to fork\n" );
-        return 1;
+        exit( 1 );
         }
     else if( childPID == 0 ) {
         // child
@@ -336,16 +345,12 @@ int main( int inNumArgs, char **inArgs ) {
         dup2( readPipe[1], STDOUT_FILENO );
         dup2( readPipe[1], STDERR_FILENO );
 
-        while( false && true ) {
-            printf( "test\n" );
-            }
-        
         //ask kernel to deliver SIGTERM in case the parent dies
         prctl( PR_SET_PDEATHSIG, SIGTERM );
-        
+
         if( inNumArgs == 4 || inNumArgs == 5 ) {
             // attatch to PID
-            execlp( "gdb", "gdb", "-nx", "--interpreter=mi", 
+            execlp( "gdb", "gdb", "-nx", "--interpreter=mi",
                     inArgs[2], inArgs[3], NULL );
             }
         else {
@@ -353,94 +358,92 @@ int main( int inNumArgs, char **inArgs ) {
             }
         exit( 0 );
         }
-    
+
     // else parent
     printf( "Forked GDB child on PID=%d\n", childPID );
-    
-    
+
+
     //close unused pipe ends
     close( writePipe[0] );
     close( readPipe[1] );
-    
+
     inPipe = readPipe[0];
     outPipe = writePipe[1];
 
     fcntl( inPipe, F_SETFL, O_NONBLOCK );
 
     skipGDBResponse();
-    
+
 
     if( inNumArgs == 3 ) {
         printf( "\n\nStarting gdb program with 'run', "
                 "redirecting program output to wcOut.tx\n" );
-        
+
         sendCommand( "run > wcOut.txt" );
         }
     else {
         printf( "\n\nResuming attached gdb program with '-exec-continue'\n" );
-        
+
         sendCommand( "-exec-continue" );
         }
-    
+
     usleep( 100000 );
 
     skipGDBResponse();
-    
+
     printf( "Debugging program '%s'\n", inArgs[2] );
 
-    char rawProgramName[100];
-    
     char *endOfPath = strrchr( inArgs[2], '/' );
 
     char *progName = inArgs[2];
-    
+
     if( endOfPath != NULL ) {
         progName = &( endOfPath[1] );
         }
-    
-    char *pidCall = autoSprintf( "pidof %s", progName );\
+
+    char *pidCall = autoSprintf( "pidof %s", progName );
 
     FILE *pidPipe = popen( pidCall, "r" );
-    
+
     delete [] pidCall;
-    
+
     if( pidPipe == NULL ) {
         printf( "Failed to open pipe to pidof to get debugged app pid\n" );
-        return 1;
+        exit( 1 );
         }
 
     int pid = -1;
-    
+
     // if there are multiple GDP procs, they are printed in newest-first order
     // this will get the pid of the latest one (our GDB child)
     int numRead = fscanf( pidPipe, "%d", &pid );
-    
+
     pclose( pidPipe );
 
     if( numRead != 1 ) {
         printf( "Failed to read PID of debugged app\n" );
-        return 1;
+        exit( 1 );
         }
-    
+
     printf( "PID of debugged process = %d\n", pid );
-    
+
 
     printf( "Sampling stack while program runs...\n" );
 
-    
+
     int numSamples = 0;
-    
 
-    int usPerSample = 1000000 / samplesPerSecond;
-    
+
+    int usPerSample = 1000000 / inSamplesPerSecond;
+
 
     printf( "Sampling %d times per second, for %d usec between samples\n",
-            samplesPerSecond, usPerSample );
-    
+            inSamplesPerSecond, usPerSample );
+
     time_t startTime = time( NULL );
-    
+
     int detatchSeconds = -1;
-    
+
     if( inNumArgs == 5 ) {
         sscanf( inArgs[4], "%d", &detatchSeconds );
         }
@@ -448,28 +451,27 @@ int main( int inNumArgs, char **inArgs ) {
         printf( "Will detatch automatically after %d seconds\n",
                 detatchSeconds );
         }
-    
+
 
     while( !programExited &&
            ( detatchSeconds == -1 ||
              time( NULL ) < startTime + detatchSeconds ) ) {
         usleep( usPerSample );
-    
+
         // interrupt
         kill( pid, SIGINT );
         numSamples++;
-        
+
         skipGDBResponse();
-        
+
 
         // sample stack
         sendCommand( "-stack-list-frames" );
-        //skipGDBResponse();
         logGDBStackResponse();
-        
-        
+
+
         // continue running
-        
+
         sendCommand( "-exec-continue" );
         skipGDBResponse();
         }
@@ -482,59 +484,495 @@ int main( int inNumArgs, char **inArgs ) {
         kill( pid, SIGINT );
         sendCommand( "-gdb-exit" );
         }
-    
+
+    return numSamples;
+    }
+
+
+
+// each unique address sampled, mapped to index in uniqueAddresses
+HashMap<void*, int> uniqueAddressIndex;
+SimpleVector<void*> uniqueAddresses;
+
+
+
+static void logSampledStack( int inPID, SampledStack *inStack ) {
+    Stack thisStack;
+    thisStack.threadName = stringDuplicate( inStack->threadName );
+
+    for( int i=0; i<inStack->addresses.size(); i++ ) {
+        void *address = inStack->addresses.getElementDirect( i );
+
+        if( ! uniqueAddressIndex.contains( address ) ) {
+
+            if( ! symbolizerKnowsAddress( address ) ) {
+                // a library loaded since we last looked
+                symbolizerReadMaps( inPID );
+                }
+
+            uniqueAddressIndex.insert( address, uniqueAddresses.size() );
+            uniqueAddresses.push_back( address );
+            }
+
+        // names filled in by symbolizeStacks, once sampling is done
+        StackFrame f;
+        f.address = address;
+        f.funcName = NULL;
+        f.fileName = NULL;
+        f.lineNum = -1;
+
+        thisStack.frames.push_back( f );
+        }
+
+    addStack( &thisStack );
+    }
+
+
+
+static void symbolizeStacks() {
+    int numAddresses = uniqueAddresses.size();
+
+    printf( "Looking up symbols for %d unique addresses...\n",
+            numAddresses );
+
+    char **funcNames = new char*[ numAddresses ];
+    char **fileNames = new char*[ numAddresses ];
+    int *lineNums = new int[ numAddresses ];
+
+    void **addresses = uniqueAddresses.getElementArray();
+
+    symbolizerLookup( numAddresses, addresses,
+                      funcNames, fileNames, lineNums );
+
+    delete [] addresses;
+
+    for( int i=0; i<stackLog.size(); i++ ) {
+        Stack *s = stackLog.getElement( i );
+
+        for( int j=0; j<s->frames.size(); j++ ) {
+            StackFrame *f = s->frames.getElement( j );
+
+            int a = -1;
+            uniqueAddressIndex.lookup( f->address, &a );
+
+            f->funcName = stringDuplicate( funcNames[a] );
+            f->fileName = stringDuplicate( fileNames[a] );
+            f->lineNum = lineNums[a];
+            }
+        }
+
+    for( int i=0; i<numAddresses; i++ ) {
+        delete [] funcNames[i];
+        delete [] fileNames[i];
+        }
+    delete [] funcNames;
+    delete [] fileNames;
+    delete [] lineNums;
+    }
+
+
+
+// returns number of samples taken
+// every thread is recorded in each sample
+static int ptraceSample( int inSamplesPerSecond,
+                         int inNumArgs, char **inArgs ) {
+    int pid = -1;
+
+    if( inNumArgs == 3 ) {
+        // exec closes this pipe, telling us the program is in place,
+        // and we're not attaching to a copy of ourself
+        int execPipe[2];
+        pipe( execPipe );
+        fcntl( execPipe[1], F_SETFD, FD_CLOEXEC );
+
+        pid = fork();
+
+        if( pid == -1 ) {
+            printf( "Failed to fork\n" );
+            exit( 1 );
+            }
+        else if( pid == 0 ) {
+            // child
+            close( execPipe[0] );
+
+            //ask kernel to deliver SIGTERM in case the parent dies
+            prctl( PR_SET_PDEATHSIG, SIGTERM );
+
+            int outFD = open( "wcOut.txt", O_WRONLY | O_CREAT | O_TRUNC,
+                              0644 );
+            if( outFD != -1 ) {
+                dup2( outFD, STDOUT_FILENO );
+                close( outFD );
+                }
+
+            execlp( inArgs[2], inArgs[2], NULL );
+
+            printf( "Failed to run %s\n", inArgs[2] );
+            exit( 1 );
+            }
+
+        close( execPipe[1] );
+
+        char c;
+        while( read( execPipe[0], &c, 1 ) == -1 && errno == EINTR ) {
+            }
+        close( execPipe[0] );
+
+        printf( "Started program '%s' on PID=%d, "
+                "redirecting program output to wcOut.txt\n", inArgs[2], pid );
+        }
+    else {
+        sscanf( inArgs[3], "%d", &pid );
+
+        printf( "Attaching to program '%s' on PID=%d\n", inArgs[2], pid );
+        }
+
+
+    if( ! ptraceSamplerAttach( pid ) ) {
+        exit( 1 );
+        }
+
+    symbolizerReadMaps( pid );
+
+
+    int detatchSeconds = -1;
+
+    if( inNumArgs == 5 ) {
+        sscanf( inArgs[4], "%d", &detatchSeconds );
+        }
+    if( detatchSeconds != -1 ) {
+        printf( "Will detatch automatically after %d seconds\n",
+                detatchSeconds );
+        }
+
+    long nsPerSample = 1000000000L / inSamplesPerSecond;
+
+    printf( "Sampling all threads %d times per second\n",
+            inSamplesPerSecond );
+
+
+    int numSamples = 0;
+
+    // total time threads spent stopped for sampling
+    double stoppedSeconds = 0;
+
+    struct timespec startTime;
+    clock_gettime( CLOCK_MONOTONIC, &startTime );
+
+    // absolute schedule, so time spent sampling doesn't skew the rate
+    struct timespec nextTime = startTime;
+
+    char exited = false;
+
+    SimpleVector<SampledStack> stacks;
+
+    while( true ) {
+        nextTime.tv_nsec += nsPerSample;
+        while( nextTime.tv_nsec >= 1000000000L ) {
+            nextTime.tv_nsec -= 1000000000L;
+            nextTime.tv_sec ++;
+            }
+
+        while( clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME,
+                                &nextTime, NULL ) == EINTR ) {
+            }
+
+        struct timespec sampleStart;
+        clock_gettime( CLOCK_MONOTONIC, &sampleStart );
+
+        if( detatchSeconds != -1 &&
+            sampleStart.tv_sec >= startTime.tv_sec + detatchSeconds ) {
+            break;
+            }
+
+        if( sampleStart.tv_sec > nextTime.tv_sec + 1 ) {
+            // fell far behind (profiler itself descheduled?),
+            // don't burst to catch up
+            nextTime = sampleStart;
+            }
+
+        stacks.deleteAll();
+
+        if( ! ptraceSamplerSample( &stacks ) ) {
+            exited = true;
+            break;
+            }
+
+        struct timespec sampleEnd;
+        clock_gettime( CLOCK_MONOTONIC, &sampleEnd );
+
+        stoppedSeconds +=
+            ( sampleEnd.tv_sec - sampleStart.tv_sec ) +
+            ( sampleEnd.tv_nsec - sampleStart.tv_nsec ) / 1000000000.0;
+
+        numSamples++;
+
+        for( int i=0; i<stacks.size(); i++ ) {
+            logSampledStack( pid, stacks.getElement( i ) );
+            }
+        }
+
+    if( exited ) {
+        printf( "Program exited\n" );
+
+        // reap our child, and exits of any threads we traced
+        while( waitpid( -1, NULL, __WALL ) > 0 ) {
+            }
+        }
+    else {
+        printf( "Detatching from program\n" );
+        ptraceSamplerDetach();
+        }
+
+    if( numSamples > 0 ) {
+        printf( "Average time program was stopped per sample:  %.1f usec\n",
+                1000000 * stoppedSeconds / numSamples );
+        }
+
+    symbolizeStacks();
+
+    symbolizerFree();
+
+    return numSamples;
+    }
+
+
+
+
+typedef struct CallTreeNode {
+        const char *funcName;
+        int sampleCount;
+        SimpleVector<struct CallTreeNode *> children;
+    } CallTreeNode;
+
+
+
+static CallTreeNode *getChild( CallTreeNode *inParent,
+                               const char *inFuncName ) {
+    for( int i=0; i<inParent->children.size(); i++ ) {
+        CallTreeNode *c = inParent->children.getElementDirect( i );
+
+        if( strcmp( c->funcName, inFuncName ) == 0 ) {
+            return c;
+            }
+        }
+
+    CallTreeNode *c = new CallTreeNode;
+    c->funcName = inFuncName;
+    c->sampleCount = 0;
+    inParent->children.push_back( c );
+
+    return c;
+    }
+
+
+
+// prints children of node, most samples first, skipping those below
+// inMinCount
+static void printCallTree( CallTreeNode *inNode, int inDepth,
+                           int inNumSamples, int inMinCount ) {
+    SimpleVector<CallTreeNode *> remaining( inNode->children );
+
+    while( remaining.size() > 0 ) {
+        int maxInd = 0;
+        for( int i=1; i<remaining.size(); i++ ) {
+            if( remaining.getElementDirect( i )->sampleCount >
+                remaining.getElementDirect( maxInd )->sampleCount ) {
+                maxInd = i;
+                }
+            }
+        CallTreeNode *c = remaining.getElementDirect( maxInd );
+        remaining.deleteElement( maxInd );
+
+        if( c->sampleCount < inMinCount ) {
+            // rest are smaller still
+            break;
+            }
+
+        printf( "%7.3f%%  %*s%s\n",
+                100 * c->sampleCount / (float)inNumSamples,
+                inDepth * 2, "", c->funcName );
+
+        printCallTree( c, inDepth + 1, inNumSamples, inMinCount );
+        }
+    }
+
+
+
+static void freeCallTree( CallTreeNode *inNode ) {
+    for( int i=0; i<inNode->children.size(); i++ ) {
+        freeCallTree( inNode->children.getElementDirect( i ) );
+        }
+    delete inNode;
+    }
+
+
+
+// one tree for all stacks, with thread names as the top level
+// function names point into stackLog
+static void printCallTreeReport( int inNumSamples ) {
+    CallTreeNode *root = new CallTreeNode;
+    root->funcName = "";
+    root->sampleCount = 0;
+
+    for( int i=0; i<stackLog.size(); i++ ) {
+        Stack *s = stackLog.getElement( i );
+
+        CallTreeNode *node = getChild( root, s->threadName );
+        node->sampleCount += s->sampleCount;
+
+        // outermost first
+        for( int j=s->frames.size() - 1; j>=0; j-- ) {
+            node = getChild( node, s->frames.getElement( j )->funcName );
+            node->sampleCount += s->sampleCount;
+            }
+        }
+
+    // skip anything under 0.5% of wall-clock time
+    int minCount = inNumSamples / 200;
+    if( minCount < 1 ) {
+        minCount = 1;
+        }
+
+    printf( "\n\n\nCall tree (percent of wall-clock time spent in each "
+            "function\nand its callees, by thread, "
+            "entries under 0.5%% hidden):\n\n" );
+
+    printCallTree( root, 0, inNumSamples, minCount );
+
+    freeCallTree( root );
+    }
+
+
+
+// one line per unique stack, as "thread;outer;...;inner count", which
+// flamegraph.pl and speedscope read directly
+static void writeFoldedStacks( const char *inFileName ) {
+    FILE *f = fopen( inFileName, "w" );
+
+    if( f == NULL ) {
+        printf( "Failed to open %s for writing\n", inFileName );
+        return;
+        }
+
+    for( int i=0; i<stackLog.size(); i++ ) {
+        Stack *s = stackLog.getElement( i );
+
+        fprintf( f, "%s", s->threadName );
+
+        for( int j=s->frames.size() - 1; j>=0; j-- ) {
+            fprintf( f, ";%s", s->frames.getElement( j )->funcName );
+            }
+        fprintf( f, " %d\n", s->sampleCount );
+        }
+
+    fclose( f );
+
+    printf( "Folded stacks written to %s\n", inFileName );
+    }
+
+
+
+int main( int inNumArgs, char **inArgs ) {
+
+    char useGDB = false;
+
+    if( inNumArgs > 1 && strcmp( inArgs[1], "-gdb" ) == 0 ) {
+        useGDB = true;
+        // rest of args as if flag wasn't there
+        inArgs = &( inArgs[1] );
+        inNumArgs--;
+        }
+
+    if( inNumArgs != 3 && inNumArgs != 4 && inNumArgs != 5 ) {
+        usage();
+        }
+
+    int samplesPerSecond = 100;
+
+    sscanf( inArgs[1], "%d", &samplesPerSecond );
+
+    if( samplesPerSecond < 1 ) {
+        usage();
+        }
+
+    int numSamples;
+
+    if( useGDB ) {
+        numSamples = gdbSample( samplesPerSecond, inNumArgs, inArgs );
+        }
+    else {
+        numSamples = ptraceSample( samplesPerSecond, inNumArgs, inArgs );
+        }
+
     printf( "%d stack samples taken\n", numSamples );
 
     printf( "%d unique stacks sampled\n", stackLog.size() );
-    
-    
+
+    if( numSamples == 0 ) {
+        return 0;
+        }
+
+
+    printCallTreeReport( numSamples );
+
+    writeFoldedStacks( "wcFolded.txt" );
+
+
     // simple insertion sort
     SimpleVector<Stack> sortedStacks;
-    
+
     while( stackLog.size() > 0 ) {
         int max = 0;
         Stack maxStack;
         int maxInd = -1;
         for( int i=0; i<stackLog.size(); i++ ) {
             Stack s = stackLog.getElementDirect( i );
-            
+
             if( s.sampleCount > max ) {
                 maxStack = s;
                 max = s.sampleCount;
                 maxInd = i;
                 }
-            }  
+            }
         sortedStacks.push_back( maxStack );
         stackLog.deleteElement( maxInd );
         }
-    
+
     printf( "\n\n\nReport:\n\n" );
-    
+
     for( int i=0; i<sortedStacks.size(); i++ ) {
         Stack s = sortedStacks.getElementDirect( i );
-        printf( "%6.3f%% =====================================\n"
-                "      %3d: %s   (at %s:%d)\n", 
+
+        if( s.frames.size() == 0 ) {
+            freeStack( &s );
+            continue;
+            }
+
+        printf( "%6.3f%% ===================================== [%s]\n"
+                "      %3d: %s   (at %s:%d)\n",
                 100 * s.sampleCount / (float )numSamples,
+                s.threadName,
                 1,
-                s.frames.getElement( 0 )->funcName, 
-                s.frames.getElement( 0 )->fileName, 
+                s.frames.getElement( 0 )->funcName,
+                s.frames.getElement( 0 )->fileName,
                 s.frames.getElement( 0 )->lineNum );
         // print stack for context below
         for( int j=1; j<s.frames.size(); j++ ) {
             StackFrame f = s.frames.getElementDirect( j );
-            printf( "      %3d: %s   (at %s:%d)\n", 
+            printf( "      %3d: %s   (at %s:%d)\n",
                     j + 1,
-                    f.funcName, 
-                    f.fileName, 
+                    f.funcName,
+                    f.fileName,
                     f.lineNum );
             }
         printf( "\n\n" );
 
         freeStack( &s );
         }
-    
 
 
-    
+    stackLogIndex.deleteAll();
+
     return 0;
     }
@@ -0,0 +1,173 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+/**
+ * Checks FrameArena alignment, overflow chaining, growth on reset, and
+ * string printing, then compares a frame's worth of small temporaries
+ * against new/delete.
+ *
+ * Compile from above the minorGems directory with:
+ *   g++ -O2 -I. minorGems/util/frameArenaTest.cpp
+ *     minorGems/util/FrameArena.cpp minorGems/util/stringUtils.cpp
+ *     minorGems/system/unix/TimeUnix.cpp -o frameArenaTest
+ */
+
+#include "FrameArena.h"
+#include "stringUtils.h"
+#include "minorGems/system/Time.h"
+
+#include <stdio.h>
+#include <string.h>
+
+
+
+#define NUM_FRAMES 1000
+#define TEMPS_PER_FRAME 1000
+
+
+
+static int numFailed = 0;
+
+static void check( char inCondition, const char *inDescription ) {
+    if( ! inCondition ) {
+        printf( "FAILED:  %s\n", inDescription );
+        numFailed++;
+        }
+    }
+
+
+
+int main() {
+
+    FrameArena arena( 1024 );
+
+    char *a = (char *)arena.allocate( 3 );
+    char *b = (char *)arena.allocate( 5 );
+
+    check( ( (size_t)a & 15 ) == 0 && ( (size_t)b & 15 ) == 0,
+           "allocations 16-byte aligned" );
+    check( b - a == 16, "small allocations packed" );
+
+
+    // more than one block's worth
+    for( int i=0; i<100; i++ ) {
+        memset( arena.allocate( 100 ), i, 100 );
+        }
+
+    int used = arena.getBytesUsed();
+
+    check( used == 32 + 100 * 112, "bytes used counted across blocks" );
+
+    char *big = (char *)arena.allocate( 5000 );
+    memset( big, 1, 5000 );
+
+    arena.reset();
+
+    check( arena.getBytesUsed() == 0, "reset forgets everything" );
+
+    // should fit in one block now
+    for( int i=0; i<100; i++ ) {
+        arena.allocate( 100 );
+        }
+    char *afterGrowth = (char *)arena.allocate( 5000 );
+    char *first = (char *)arena.allocate( 1 );
+
+    check( first > afterGrowth, "grown block holds whole frame" );
+
+    arena.reset();
+
+
+    char *s = arena.printString( "%d %s", 42, "frames" );
+    check( strcmp( s, "42 frames" ) == 0, "printString" );
+
+    char *next = (char *)arena.allocate( 1 );
+    check( next == s + 16, "printString claims only what it used" );
+
+    char longString[3000];
+    memset( longString, 'x', sizeof( longString ) - 1 );
+    longString[ sizeof( longString ) - 1 ] = '\0';
+
+    // doesn't fit in what's left
+    char *l = arena.printString( "[%s]", longString );
+    check( strlen( l ) == sizeof( longString ) + 1 &&
+           l[0] == '[' && l[ sizeof( longString ) ] == ']',
+           "printString past end of block" );
+
+    char *f = frameSprintf( "%.1f", 2.5 );
+    check( strcmp( f, "2.5" ) == 0, "frameSprintf" );
+
+
+    // timing, TEMPS_PER_FRAME small buffers per frame
+    double startTime = Time::getCurrentTime();
+
+    for( int f=0; f<NUM_FRAMES; f++ ) {
+        for( int i=0; i<TEMPS_PER_FRAME; i++ ) {
+            float *temp = new float[ 8 + i % 64 ];
+            temp[0] = i;
+            delete [] temp;
+            }
+        }
+
+    double newTime = Time::getCurrentTime() - startTime;
+
+    FrameArena *threadArena = FrameArena::getThreadArena();
+
+    startTime = Time::getCurrentTime();
+
+    for( int f=0; f<NUM_FRAMES; f++ ) {
+        for( int i=0; i<TEMPS_PER_FRAME; i++ ) {
+            float *temp = threadArena->allocateArray<float>( 8 + i % 64 );
+            temp[0] = i;
+            }
+        threadArena->reset();
+        }
+
+    double arenaTime = Time::getCurrentTime() - startTime;
+
+    printf( "new/delete:  %.1f ns per temporary\n",
+            1000000000 * newTime / ( NUM_FRAMES * TEMPS_PER_FRAME ) );
+    printf( "FrameArena:  %.1f ns per temporary (peak %d bytes per frame)\n",
+            1000000000 * arenaTime / ( NUM_FRAMES * TEMPS_PER_FRAME ),
+            threadArena->getPeakBytesUsed() );
+
+
+    startTime = Time::getCurrentTime();
+
+    for( int f=0; f<NUM_FRAMES; f++ ) {
+        for( int i=0; i<100; i++ ) {
+            char *label = autoSprintf( "score %d", i );
+            delete [] label;
+            }
+        }
+
+    double autoTime = Time::getCurrentTime() - startTime;
+
+    startTime = Time::getCurrentTime();
+
+    for( int f=0; f<NUM_FRAMES; f++ ) {
+        for( int i=0; i<100; i++ ) {
+            frameSprintf( "score %d", i );
+            }
+        threadArena->reset();
+        }
+
+    double frameTime = Time::getCurrentTime() - startTime;
+
+    printf( "autoSprintf:   %.1f ns per string\n",
+            1000000000 * autoTime / ( NUM_FRAMES * 100 ) );
+    printf( "frameSprintf:  %.1f ns per string\n",
+            1000000000 * frameTime / ( NUM_FRAMES * 100 ) );
+
+    FrameArena::destroyThreadArenas();
+
+
+    if( numFailed == 0 ) {
+        printf( "All checks passed\n" );
+        return 0;
+        }
+    return 1;
+    }
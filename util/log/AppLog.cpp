@@ -13,6 +13,10 @@
  *
  * 2011-February-16    Jason Rohrer
  * Flag to print next log message to std out.
+ *
+ * 2026-October-14   Jason Rohrer
+ * Level checked before calling into log, so that disabled levels cost
+ * almost nothing.
  */
 
 
@@ -27,6 +31,11 @@
 // wrap our static member in a statically allocated class
 LogPointerWrapper AppLog::mLogPointerWrapper( new PrintLog );
 
+// higher than any level, so that nothing is dropped here until level set
+// (a constant, since Log's level constants may not be initialized yet
+// during static init)
+int AppLog::mLoggingLevel = 1000;
+
 
 
 LogPointerWrapper::LogPointerWrapper( Log *inLog )
@@ -45,6 +54,10 @@ LogPointerWrapper::~LogPointerWrapper() {
 
 
 void AppLog::criticalError( const char *inString ) {
+    if( Log::CRITICAL_ERROR_LEVEL > mLoggingLevel ) {
+        return;
+        }
+
     mLogPointerWrapper.mLog->logString(
         Log::CRITICAL_ERROR_LEVEL, inString );
     }
@@ -52,6 +65,10 @@ void AppLog::criticalError( const char *inString ) {
 
 
 void AppLog::criticalErrorF( const char *inFormatString, ... ) {
+    if( Log::CRITICAL_ERROR_LEVEL > mLoggingLevel ) {
+        return;
+        }
+
     va_list argList;
     va_start( argList, inFormatString );
 
@@ -65,6 +82,10 @@ void AppLog::criticalErrorF( const char *inFormatString, ... ) {
 
 void AppLog::criticalError( const char *inLoggerName, 
                             const char *inFormatString, ... ) {
+    if( Log::CRITICAL_ERROR_LEVEL > mLoggingLevel ) {
+        return;
+        }
+
     va_list argList;
     va_start( argList, inFormatString );
 
@@ -77,12 +98,20 @@ void AppLog::criticalError( const char *inLoggerName,
 
 
 void AppLog::error( const char *inString ) {
+    if( Log::ERROR_LEVEL > mLoggingLevel ) {
+        return;
+        }
+
     mLogPointerWrapper.mLog->logString( Log::ERROR_LEVEL, inString );
     }
 
 
 
 void AppLog::errorF( const char *inFormatString, ... ) {
+    if( Log::ERROR_LEVEL > mLoggingLevel ) {
+        return;
+        }
+
     va_list argList;
     va_start( argList, inFormatString );
 
@@ -96,6 +125,10 @@ void AppLog::errorF( const char *inFormatString, ... ) {
 
 void AppLog::error( const char *inLoggerName, 
                     const char *inFormatString, ... ) {
+    if( Log::ERROR_LEVEL > mLoggingLevel ) {
+        return;
+        }
+
     va_list argList;
     va_start( argList, inFormatString );
 
@@ -108,12 +141,20 @@ void AppLog::error( const char *inLoggerName,
 
 
 void AppLog::warning( const char *inString ) {
+    if( Log::WARNING_LEVEL > mLoggingLevel ) {
+        return;
+        }
+
     mLogPointerWrapper.mLog->logString( Log::WARNING_LEVEL, inString );
     }
 
 
 
 void AppLog::warningF( const char *inFormatString, ... ) {
+    if( Log::WARNING_LEVEL > mLoggingLevel ) {
+        return;
+        }
+
     va_list argList;
     va_start( argList, inFormatString );
 
@@ -127,6 +168,10 @@ void AppLog::warningF( const char *inFormatString, ... ) {
 
 void AppLog::warning( const char *inLoggerName, 
                       const char *inFormatString, ... ) {
+    if( Log::WARNING_LEVEL > mLoggingLevel ) {
+        return;
+        }
+
     va_list argList;
     va_start( argList, inFormatString );
 
@@ -139,12 +184,20 @@ void AppLog::warning( const char *inLoggerName,
 
 
 void AppLog::info( const char *inString ) {
+    if( Log::INFO_LEVEL > mLoggingLevel ) {
+        return;
+        }
+
     mLogPointerWrapper.mLog->logString( Log::INFO_LEVEL, inString );
     }
 
 
 
 void AppLog::infoF( const char *inFormatString, ... ) {
+    if( Log::INFO_LEVEL > mLoggingLevel ) {
+        return;
+        }
+
     va_list argList;
     va_start( argList, inFormatString );
 
@@ -158,6 +211,10 @@ void AppLog::infoF( const char *inFormatString, ... ) {
 
 void AppLog::info( const char *inLoggerName, 
                    const char *inFormatString, ... ) {
+    if( Log::INFO_LEVEL > mLoggingLevel ) {
+        return;
+        }
+
     va_list argList;
     va_start( argList, inFormatString );
 
@@ -170,12 +227,20 @@ void AppLog::info( const char *inLoggerName,
 
 
 void AppLog::detail( const char *inString ) {
+    if( Log::DETAIL_LEVEL > mLoggingLevel ) {
+        return;
+        }
+
     mLogPointerWrapper.mLog->logString( Log::DETAIL_LEVEL, inString );
     }
 
 
 
 void AppLog::detailF( const char *inFormatString, ... ) {
+    if( Log::DETAIL_LEVEL > mLoggingLevel ) {
+        return;
+        }
+
     va_list argList;
     va_start( argList, inFormatString );
 
@@ -189,6 +254,10 @@ void AppLog::detailF( const char *inFormatString, ... ) {
 
 void AppLog::detail( const char *inLoggerName, 
                      const char *inFormatString, ... ) {
+    if( Log::DETAIL_LEVEL > mLoggingLevel ) {
+        return;
+        }
+
     va_list argList;
     va_start( argList, inFormatString );
 
@@ -201,12 +270,20 @@ void AppLog::detail( const char *inLoggerName,
 
 
 void AppLog::trace( const char *inString ) {
+    if( Log::TRACE_LEVEL > mLoggingLevel ) {
+        return;
+        }
+
     mLogPointerWrapper.mLog->logString( Log::TRACE_LEVEL, inString );
     }
 
 
 
 void AppLog::traceF( const char *inFormatString, ... ) {
+    if( Log::TRACE_LEVEL > mLoggingLevel ) {
+        return;
+        }
+
     va_list argList;
     va_start( argList, inFormatString );
 
@@ -220,6 +297,10 @@ void AppLog::traceF( const char *inFormatString, ... ) {
 
 void AppLog::trace( const char *inLoggerName, 
                     const char *inFormatString, ... ) {
+    if( Log::TRACE_LEVEL > mLoggingLevel ) {
+        return;
+        }
+
     va_list argList;
     va_start( argList, inFormatString );
 
@@ -264,6 +345,7 @@ Log *AppLog::getLog() {
 
 void AppLog::setLoggingLevel( int inLevel ) {
     mLogPointerWrapper.mLog->setLoggingLevel( inLevel );
+    mLoggingLevel = inLevel;
     }
 
 
@@ -13,6 +13,9 @@
  *
  * 2011-February-16    Jason Rohrer
  * Flag to print next log message to std out.
+ *
+ * 2026-October-14   Jason Rohrer
+ * Cached logging level, checked before calling into log.
  */
 
 #include "minorGems/common.h"
@@ -146,6 +149,12 @@ class AppLog {
         // are destroyed at program termination
         //static Log *mLog;
         static LogPointerWrapper mLogPointerWrapper;
+
+        // copy of current log's level, so that calls for disabled
+        // levels return before any formatting (or virtual call)
+        // only kept up to date when level set through setLoggingLevel or
+        // setLog
+        static int mLoggingLevel;
         
     };
 
@@ -0,0 +1,326 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14   Jason Rohrer
+ * Created.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Error and critical error messages are written before the call returns.
+ */
+
+
+#include "AsyncFileLog.h"
+
+#include "minorGems/system/Thread.h"
+#include "minorGems/system/atomicOps.h"
+
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+
+
+
+// writer is woken early once this many messages are waiting
+#define ASYNC_LOG_WAKE_COUNT 256
+
+// messages that fit are formatted without a heap allocation for the
+// formatting itself
+#define ASYNC_LOG_STACK_BUFFER_SIZE 512
+
+
+
+// visual studio doesn't have va_copy
+// (see PrintLog.cpp)
+#ifndef va_copy
+    #define va_copy( dest, src ) ( dest = src )
+#endif
+
+
+
+// allocated as one block, with name and text following the struct
+struct AsyncLogMessage {
+        AsyncLogMessage *next;
+
+        int level;
+
+        time_t time;
+        unsigned long milliseconds;
+
+        // 0 to not print, 1 to print whole message, 2 to print just text
+        char printOut;
+
+        char *loggerName;
+        char *text;
+    };
+
+
+
+class AsyncFileLogWriter : public Thread {
+
+    public:
+
+        AsyncFileLogWriter( AsyncFileLog *inLog )
+                : mLog( inLog ) {
+            start();
+            }
+
+        ~AsyncFileLogWriter() {
+            join();
+            }
+
+
+        void run() {
+            mLog->writerLoop();
+            }
+
+
+    protected:
+
+        AsyncFileLog *mLog;
+
+    };
+
+
+
+AsyncFileLog::AsyncFileLog( const char *inFileName,
+                            unsigned long inSecondsBetweenBackups,
+                            int inFlushIntervalMS )
+        : FileLog( inFileName, inSecondsBetweenBackups ),
+          mQueue( NULL ), mNumQueued( 0 ), mStopping( false ),
+          mFlushIntervalMS( inFlushIntervalMS ),
+          mLastDateTime( 0 ) {
+
+    mLastDateString[0] = '\0';
+
+    mWriter = new AsyncFileLogWriter( this );
+    }
+
+
+
+AsyncFileLog::~AsyncFileLog() {
+    atomicStore( &mStopping, true );
+    mWakeSemaphore.signal();
+
+    // joins, after writer drains queue
+    delete mWriter;
+    }
+
+
+
+void AsyncFileLog::logStringV( const char *inLoggerName,
+                               int inLevel,
+                               const char *inFormatString,
+                               va_list inArgList ) {
+
+    // unlocked read, as in PrintLog, so that disabled levels cost
+    // nothing more than this check
+    if( inLevel > mLoggingLevel ) {
+        return;
+        }
+
+
+    char stackBuffer[ ASYNC_LOG_STACK_BUFFER_SIZE ];
+    char *heapBuffer = NULL;
+
+    char *text = stackBuffer;
+
+    va_list listCopy;
+    va_copy( listCopy, inArgList );
+
+    int textLength = vsnprintf( stackBuffer, ASYNC_LOG_STACK_BUFFER_SIZE,
+                                inFormatString, listCopy );
+    va_end( listCopy );
+
+    if( textLength < 0 || textLength >= ASYNC_LOG_STACK_BUFFER_SIZE ) {
+        // too long (or vsnprintf doesn't report needed length)
+        heapBuffer = generatePlainMessage( inFormatString, inArgList );
+        text = heapBuffer;
+        textLength = strlen( heapBuffer );
+        }
+
+    int nameLength = strlen( inLoggerName );
+
+
+    char *block = new char[ sizeof( AsyncLogMessage ) +
+                            nameLength + 1 + textLength + 1 ];
+
+    AsyncLogMessage *message = (AsyncLogMessage *)block;
+
+    message->loggerName = &( block[ sizeof( AsyncLogMessage ) ] );
+    message->text = &( message->loggerName[ nameLength + 1 ] );
+
+    memcpy( message->loggerName, inLoggerName, nameLength + 1 );
+    memcpy( message->text, text, textLength + 1 );
+
+    if( heapBuffer != NULL ) {
+        delete [] heapBuffer;
+        }
+
+    message->level = inLevel;
+
+    timeSec_t seconds;
+    Time::getCurrentTime( &seconds, &( message->milliseconds ) );
+    message->time = time( NULL );
+
+
+    // unlocked, as in FileLog, these are only changed by rare, simple
+    // settings calls
+    message->printOut = 0;
+
+    if( mPrintOutNextMessage ) {
+        message->printOut = 1;
+        mPrintOutNextMessage = false;
+        }
+    else if( mPrintAllMessages ) {
+        message->printOut = 2;
+        }
+
+
+    // push onto front
+    // writer only ever takes the whole queue, so there's no ABA problem
+    while( true ) {
+        AsyncLogMessage *oldQueue = mQueue;
+        message->next = oldQueue;
+
+        if( atomicCompareExchangePointer( (void * volatile *)&mQueue,
+                                          oldQueue, message ) ) {
+            break;
+            }
+        }
+
+    int numQueued = atomicFetchAdd( &mNumQueued, 1 ) + 1;
+
+    if( inLevel <= Log::ERROR_LEVEL ) {
+        // write it (and everything before it) ourselves, so that it
+        // isn't lost if the process crashes right after
+        writeQueued();
+        }
+    else if( numQueued == ASYNC_LOG_WAKE_COUNT ) {
+        mWakeSemaphore.signal();
+        }
+    }
+
+
+
+void AsyncFileLog::writerLoop() {
+    while( true ) {
+        mWakeSemaphore.wait( mFlushIntervalMS );
+
+        char stopping = atomicLoad( &mStopping );
+
+        writeQueued();
+
+        if( stopping ) {
+            // anything pushed after we saw the stop flag
+            writeQueued();
+            return;
+            }
+        }
+    }
+
+
+
+char AsyncFileLog::writeQueued() {
+    // taken under the lock too, so that a batch taken later can't be
+    // written before one taken earlier
+    mWriteLock.lock();
+
+    AsyncLogMessage *newestFirst =
+        (AsyncLogMessage *)atomicExchangePointer(
+            (void * volatile *)&mQueue, NULL );
+
+    if( newestFirst == NULL ) {
+        mWriteLock.unlock();
+        return false;
+        }
+
+
+    // reverse to oldest first
+    AsyncLogMessage *oldestFirst = NULL;
+    int numTaken = 0;
+
+    while( newestFirst != NULL ) {
+        AsyncLogMessage *next = newestFirst->next;
+
+        newestFirst->next = oldestFirst;
+        oldestFirst = newestFirst;
+
+        newestFirst = next;
+        numTaken++;
+        }
+
+    atomicFetchAdd( &mNumQueued, -numTaken );
+
+
+    while( oldestFirst != NULL ) {
+        AsyncLogMessage *next = oldestFirst->next;
+
+        writeMessage( oldestFirst );
+
+        delete [] (char *)oldestFirst;
+
+        oldestFirst = next;
+        }
+
+
+    if( mLogFile != NULL ) {
+        fflush( mLogFile );
+
+        if( Time::timeSec() - mTimeOfLastBackup > mSecondsBetweenBackups ) {
+            makeBackup();
+            }
+        }
+
+    mWriteLock.unlock();
+
+    return true;
+    }
+
+
+
+void AsyncFileLog::writeMessage( AsyncLogMessage *inMessage ) {
+
+    if( inMessage->time != mLastDateTime || mLastDateString[0] == '\0' ) {
+
+        // lock around ctime call, since it returns a static buffer
+        // (as in PrintLog)
+        mLock->lock();
+
+        strncpy( mLastDateString, ctime( &( inMessage->time ) ),
+                 sizeof( mLastDateString ) - 1 );
+
+        mLock->unlock();
+
+        mLastDateString[ sizeof( mLastDateString ) - 1 ] = '\0';
+
+        // this date string ends with a newline...
+        // get rid of it
+        int dateLength = strlen( mLastDateString );
+        if( dateLength > 0 &&
+            mLastDateString[ dateLength - 1 ] == '\n' ) {
+            mLastDateString[ dateLength - 1 ] = '\0';
+            }
+
+        mLastDateTime = inMessage->time;
+        }
+
+
+    // same format as PrintLog::generateLogMessage
+    if( mLogFile != NULL ) {
+        fprintf( mLogFile, "L%d | %s (%ld ms) | %s | %s\n",
+                 inMessage->level, mLastDateString,
+                 inMessage->milliseconds,
+                 inMessage->loggerName, inMessage->text );
+        }
+
+    if( inMessage->printOut == 1 ) {
+        printf( "L%d | %s (%ld ms) | %s | %s\n",
+                inMessage->level, mLastDateString,
+                inMessage->milliseconds,
+                inMessage->loggerName, inMessage->text );
+        }
+    else if( inMessage->printOut == 2 ) {
+        printf( "%s\n", inMessage->text );
+        }
+    }
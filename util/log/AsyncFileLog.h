@@ -0,0 +1,133 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14   Jason Rohrer
+ * Created.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Error and critical error messages are written before the call returns.
+ */
+
+
+#include "minorGems/common.h"
+
+
+
+#ifndef ASYNC_FILE_LOG_INCLUDED
+#define ASYNC_FILE_LOG_INCLUDED
+
+
+
+#include "FileLog.h"
+
+#include "minorGems/system/BinarySemaphore.h"
+#include "minorGems/system/MutexLock.h"
+
+#include <time.h>
+
+
+
+class AsyncFileLogWriter;
+
+typedef struct AsyncLogMessage AsyncLogMessage;
+
+
+
+/**
+ * A FileLog that writes from a background thread, so that logging
+ * threads never wait on disk.
+ *
+ * A logging call formats its message (in a stack buffer, if it fits)
+ * and pushes it onto a lock-free queue, without taking any lock.  The
+ * writer thread takes everything queued at once, writes it as one batch,
+ * and flushes, every inFlushIntervalMS or sooner when many messages are
+ * waiting.
+ *
+ * Error and critical error messages are different:  the logging thread
+ * writes and flushes them itself, along with everything queued before
+ * them, before the call returns.  The last messages before a crash are
+ * usually the ones needed most, and these are never left in the queue.
+ *
+ * Non-error messages still queued when the process crashes are lost,
+ * which is at most inFlushIntervalMS worth.
+ *
+ * Everything queued is written when the log is destroyed.
+ *
+ * @author Jason Rohrer
+ */
+class AsyncFileLog : public FileLog {
+
+    public:
+
+
+        /**
+         * Constructs a log and starts its writer thread.
+         *
+         * @param inFileName the name of the file to write log messages to.
+         *   Must be destroyed by caller.
+         * @param inSecondsBetweenBackups see FileLog.  Defaults to 3600.
+         * @param inFlushIntervalMS the longest a message can wait to be
+         *   written.  Defaults to 100.
+         */
+        AsyncFileLog( const char *inFileName,
+                      unsigned long inSecondsBetweenBackups = 3600,
+                      int inFlushIntervalMS = 100 );
+
+
+        // writes all queued messages before returning
+        virtual ~AsyncFileLog();
+
+
+
+        // overrides FileLog::logStringV
+        virtual void logStringV( const char *inLoggerName,
+                                 int inLevel, const char* inFormatString,
+                                 va_list inArgList );
+
+
+
+    protected:
+
+        friend class AsyncFileLogWriter;
+
+
+        // newest first
+        AsyncLogMessage * volatile mQueue;
+
+        // pushed since writer last took the queue
+        volatile int mNumQueued;
+
+        volatile int mStopping;
+
+        int mFlushIntervalMS;
+
+        BinarySemaphore mWakeSemaphore;
+
+        AsyncFileLogWriter *mWriter;
+
+        // held while a batch is taken and written, by the writer thread
+        // or by a thread logging an error, so batches stay in order
+        MutexLock mWriteLock;
+
+
+        // guarded by mWriteLock
+        // date string reused for all messages within the same second
+        time_t mLastDateTime;
+        char mLastDateString[ 64 ];
+
+
+        // runs writer thread until stopped
+        void writerLoop();
+
+        // takes and writes everything queued
+        // returns true if anything was written
+        char writeQueued();
+
+        // writes one message, without flushing
+        void writeMessage( AsyncLogMessage *inMessage );
+
+    };
+
+
+
+#endif
@@ -0,0 +1,586 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14   Jason Rohrer
+ * Created.
+ */
+
+
+#include "BinaryTraceLog.h"
+#include "binaryTraceFormat.h"
+
+#include "minorGems/system/Thread.h"
+#include "minorGems/system/atomicOps.h"
+
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdint.h>
+
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <sys/time.h>
+#endif
+
+
+
+// records are built on the stack, so this bounds message size
+#define TRACE_MAX_RECORD_SIZE 4096
+
+// longer %s arguments are cut off
+#define TRACE_MAX_STRING_ARG 1024
+
+// fits in record's u8 argument count
+#define TRACE_MAX_ARGS 255
+
+
+
+// visual studio doesn't have va_copy
+// (see PrintLog.cpp)
+#ifndef va_copy
+    #define va_copy( dest, src ) ( dest = src )
+#endif
+
+
+
+class BinaryTraceLogWriter : public Thread {
+
+    public:
+
+        BinaryTraceLogWriter( BinaryTraceLog *inLog )
+                : mLog( inLog ) {
+            start();
+            }
+
+        ~BinaryTraceLogWriter() {
+            join();
+            }
+
+
+        void run() {
+            mLog->writerLoop();
+            }
+
+
+    protected:
+
+        BinaryTraceLog *mLog;
+
+    };
+
+
+
+// records aren't aligned, so multi-byte values are copied in and out
+
+static void putU16( unsigned char *inDest, int inValue ) {
+    uint16_t v = (uint16_t)inValue;
+    memcpy( inDest, &v, 2 );
+    }
+
+
+static int getU16( unsigned char *inSource ) {
+    uint16_t v;
+    memcpy( &v, inSource, 2 );
+    return v;
+    }
+
+
+static void putU32( unsigned char *inDest, int inValue ) {
+    uint32_t v = (uint32_t)inValue;
+    memcpy( inDest, &v, 4 );
+    }
+
+
+
+// microseconds since the epoch
+// (Time::getCurrentTime only has millisecond resolution)
+static int64_t getTraceTime() {
+    #ifdef _WIN32
+        FILETIME fileTime;
+        GetSystemTimeAsFileTime( &fileTime );
+
+        // 100 ns ticks since 1601
+        uint64_t ticks =
+            ( (uint64_t)fileTime.dwHighDateTime << 32 ) |
+            fileTime.dwLowDateTime;
+
+        return (int64_t)( ( ticks - 116444736000000000ULL ) / 10 );
+    #else
+        struct timeval now;
+        gettimeofday( &now, NULL );
+
+        return (int64_t)now.tv_sec * 1000000 + now.tv_usec;
+    #endif
+    }
+
+
+
+// encodes arguments for inFormatString after record header
+// returns total record length, or -1 if format takes an argument type
+// that can't be recorded
+static int encodeArgs( unsigned char *inRecord,
+                       const char *inFormatString, va_list inArgList ) {
+
+    unsigned char *p = &( inRecord[ TRACE_RECORD_HEADER_SIZE ] );
+    unsigned char *end = &( inRecord[ TRACE_MAX_RECORD_SIZE ] );
+
+    int numArgs = 0;
+
+    TraceConversion c;
+    const char *next = inFormatString;
+
+    while( ( next = nextTraceConversion( next, &c ) ) != NULL ) {
+
+        if( c.argType == TRACE_TYPE_NONE ) {
+            continue;
+            }
+
+        // stars, then value
+        if( numArgs + c.numStars + 1 > TRACE_MAX_ARGS ||
+            end - p < 5 * ( c.numStars + 1 ) + 4 ) {
+            // too many to record
+            // formatter shows what's missing
+            break;
+            }
+
+        for( int s=0; s<c.numStars; s++ ) {
+            int star = va_arg( inArgList, int );
+            *( p++ ) = TRACE_ARG_INT;
+            memcpy( p, &star, 4 );
+            p += 4;
+            numArgs++;
+            }
+
+        switch( c.argType ) {
+            case TRACE_TYPE_INT: {
+                int v = va_arg( inArgList, int );
+                *( p++ ) = TRACE_ARG_INT;
+                memcpy( p, &v, 4 );
+                p += 4;
+                break;
+                }
+            case TRACE_TYPE_LONG:
+            case TRACE_TYPE_LONG_LONG:
+            case TRACE_TYPE_SIZE: {
+                int64_t v;
+                if( c.argType == TRACE_TYPE_LONG ) {
+                    v = va_arg( inArgList, long );
+                    }
+                else if( c.argType == TRACE_TYPE_LONG_LONG ) {
+                    v = va_arg( inArgList, long long );
+                    }
+                else {
+                    v = (int64_t)va_arg( inArgList, size_t );
+                    }
+                *( p++ ) = TRACE_ARG_INT64;
+                memcpy( p, &v, 8 );
+                p += 8;
+                break;
+                }
+            case TRACE_TYPE_DOUBLE:
+            case TRACE_TYPE_LONG_DOUBLE: {
+                double v;
+                if( c.argType == TRACE_TYPE_DOUBLE ) {
+                    v = va_arg( inArgList, double );
+                    }
+                else {
+                    v = (double)va_arg( inArgList, long double );
+                    }
+                *( p++ ) = TRACE_ARG_DOUBLE;
+                memcpy( p, &v, 8 );
+                p += 8;
+                break;
+                }
+            case TRACE_TYPE_POINTER:
+            case TRACE_TYPE_COUNT_POINTER: {
+                // %n is never written through, just skipped
+                uint64_t v = (uint64_t)(uintptr_t)va_arg( inArgList, void* );
+                *( p++ ) = TRACE_ARG_POINTER;
+                memcpy( p, &v, 8 );
+                p += 8;
+                break;
+                }
+            case TRACE_TYPE_STRING: {
+                const char *s = va_arg( inArgList, const char* );
+                if( s == NULL ) {
+                    s = "(null)";
+                    }
+
+                int length = strlen( s );
+
+                if( length > TRACE_MAX_STRING_ARG ) {
+                    length = TRACE_MAX_STRING_ARG;
+                    }
+                if( length > end - p - 3 ) {
+                    length = end - p - 3;
+                    }
+
+                *( p++ ) = TRACE_ARG_STRING;
+                putU16( p, length );
+                p += 2;
+                memcpy( p, s, length );
+                p += length;
+                break;
+                }
+            default:
+                return -1;
+            }
+
+        numArgs++;
+        }
+
+
+    inRecord[7] = (unsigned char)numArgs;
+
+    return p - inRecord;
+    }
+
+
+
+BinaryTraceLog::BinaryTraceLog( Log *inTextLog,
+                                const char *inTraceFileName,
+                                int inRingBytes,
+                                int inBinaryLevel,
+                                int inFlushIntervalMS )
+        : mTextLog( inTextLog ),
+          mBinaryLevel( inBinaryLevel ),
+          mRingLock( "BinaryTraceLog" ),
+          mRingSize( inRingBytes ),
+          mWriteOffset( 0 ), mOldestOffset( 0 ), mWrapped( false ),
+          mDirtyStart( 0 ), mDirtyLength( 0 ),
+          mNextStringID( 0 ),
+          mStopping( false ),
+          mFlushIntervalMS( inFlushIntervalMS ) {
+
+    // ring must hold a few of the largest records, so a new one never
+    // wraps onto itself
+    if( mRingSize < 4 * TRACE_MAX_RECORD_SIZE ) {
+        mRingSize = 4 * TRACE_MAX_RECORD_SIZE;
+        }
+
+    mRing = new unsigned char[ mRingSize ];
+    mFlushBuffer = new unsigned char[ mRingSize ];
+
+    memset( mRing, 0, mRingSize );
+
+
+    mTraceFile = fopen( inTraceFileName, "wb" );
+
+    char *stringFileName = new char[ strlen( inTraceFileName ) +
+                                     strlen( TRACE_STRINGS_SUFFIX ) + 1 ];
+    strcpy( stringFileName, inTraceFileName );
+    strcat( stringFileName, TRACE_STRINGS_SUFFIX );
+
+    mStringFile = fopen( stringFileName, "wb" );
+
+    delete [] stringFileName;
+
+
+    if( mTraceFile == NULL || mStringFile == NULL ) {
+        mTextLog->logString( "BinaryTraceLog", Log::ERROR_LEVEL,
+                             "Failed to open trace file %s",
+                             inTraceFileName );
+        }
+
+    mWriter = new BinaryTraceLogWriter( this );
+    }
+
+
+
+BinaryTraceLog::~BinaryTraceLog() {
+    atomicStore( &mStopping, true );
+    mWakeSemaphore.signal();
+
+    // joins, after final flush
+    delete mWriter;
+
+    if( mTraceFile != NULL ) {
+        fclose( mTraceFile );
+        }
+    if( mStringFile != NULL ) {
+        fclose( mStringFile );
+        }
+
+    delete [] mRing;
+    delete [] mFlushBuffer;
+
+    delete mTextLog;
+    }
+
+
+
+void BinaryTraceLog::setLoggingLevel( int inLevel ) {
+    PrintLog::setLoggingLevel( inLevel );
+    mTextLog->setLoggingLevel( inLevel );
+    }
+
+
+
+void BinaryTraceLog::logStringV( const char *inLoggerName,
+                                 int inLevel,
+                                 const char *inFormatString,
+                                 va_list inArgList ) {
+
+    // unlocked read, as in PrintLog
+    if( inLevel > mLoggingLevel ) {
+        return;
+        }
+
+
+    int length = -1;
+
+    unsigned char record[ TRACE_MAX_RECORD_SIZE ];
+
+    if( inLevel >= mBinaryLevel &&
+        mTraceFile != NULL && mStringFile != NULL ) {
+
+        va_list listCopy;
+        va_copy( listCopy, inArgList );
+
+        length = encodeArgs( record, inFormatString, listCopy );
+
+        va_end( listCopy );
+        }
+
+
+    if( length != -1 ) {
+        record[6] = (unsigned char)inLevel;
+
+        int64_t time = getTraceTime();
+        memcpy( &( record[8] ), &time, 8 );
+
+        putU16( record, length );
+
+
+        mRingLock.lock();
+
+        int formatID = getStringID( inFormatString );
+        int nameID = getStringID( inLoggerName );
+
+        if( formatID != -1 && nameID != -1 ) {
+            putU16( &( record[2] ), formatID );
+            putU16( &( record[4] ), nameID );
+
+            addRecord( record, length );
+            }
+        else {
+            length = -1;
+            }
+
+        mRingLock.unlock();
+        }
+
+
+    if( length == -1 ) {
+        // not recorded in binary
+
+        // unlocked, as in FileLog, these are only changed by rare, simple
+        // settings calls
+        if( mPrintOutNextMessage ) {
+            mTextLog->printOutNextMessage();
+            mPrintOutNextMessage = false;
+            }
+        mTextLog->printAllMessages( mPrintAllMessages );
+
+        mTextLog->logStringV( inLoggerName, inLevel,
+                              inFormatString, inArgList );
+        }
+    }
+
+
+
+int BinaryTraceLog::getStringID( const char *inString ) {
+    int id;
+
+    if( mStringIDs.lookup( inString, &id ) ) {
+        return id;
+        }
+
+    if( mNextStringID > TRACE_MAX_STRING_ID ) {
+        return -1;
+        }
+
+    id = mNextStringID;
+    mNextStringID++;
+
+    mStringIDs.insert( inString, id );
+
+
+    int length = strlen( inString );
+    if( length > 0xFFFF ) {
+        length = 0xFFFF;
+        }
+
+    unsigned char header[4];
+    putU16( header, id );
+    putU16( &( header[2] ), length );
+
+    mPendingStrings.push_back( header, 4 );
+    mPendingStrings.push_back( (unsigned char *)inString, length );
+
+    return id;
+    }
+
+
+
+void BinaryTraceLog::addRecord( unsigned char *inRecord, int inLength ) {
+
+    if( mWriteOffset + inLength > mRingSize ) {
+        // doesn't fit before end, wrap
+
+        if( mRingSize - mWriteOffset >= 2 ) {
+            putU16( &( mRing[ mWriteOffset ] ), 0 );
+            }
+
+        // whole tail is dirty, though only the marker changed
+        int tailLength = mRingSize - mWriteOffset;
+
+        if( mDirtyLength == 0 ) {
+            mDirtyStart = mWriteOffset;
+            }
+        mDirtyLength += tailLength;
+
+        // anything that was left between here and the end is now
+        // unreachable, so oldest remaining record is at start of ring
+        mWrapped = true;
+        mOldestOffset = 0;
+
+        mWriteOffset = 0;
+        }
+
+
+    int end = mWriteOffset + inLength;
+
+    // drop old records that we're overwriting
+    while( mWrapped &&
+           mOldestOffset >= mWriteOffset && mOldestOffset < end ) {
+
+        int oldLength = 0;
+
+        if( mRingSize - mOldestOffset >= 2 ) {
+            oldLength = getU16( &( mRing[ mOldestOffset ] ) );
+            }
+
+        if( oldLength == 0 ) {
+            // past end marker, nothing older remains
+            mWrapped = false;
+            mOldestOffset = 0;
+            }
+        else {
+            mOldestOffset += oldLength;
+
+            if( mOldestOffset >= mRingSize ) {
+                mWrapped = false;
+                mOldestOffset = 0;
+                }
+            }
+        }
+
+
+    memcpy( &( mRing[ mWriteOffset ] ), inRecord, inLength );
+
+    if( mDirtyLength == 0 ) {
+        mDirtyStart = mWriteOffset;
+        }
+    mDirtyLength += inLength;
+
+    if( mDirtyLength > mRingSize ) {
+        // writer fell a whole ring behind
+        mDirtyStart = 0;
+        mDirtyLength = mRingSize;
+        }
+
+    mWriteOffset = end;
+    }
+
+
+
+void BinaryTraceLog::writerLoop() {
+    while( true ) {
+        mWakeSemaphore.wait( mFlushIntervalMS );
+
+        char stopping = atomicLoad( &mStopping );
+
+        flush();
+
+        if( stopping ) {
+            return;
+            }
+        }
+    }
+
+
+
+void BinaryTraceLog::flush() {
+
+    if( mTraceFile == NULL || mStringFile == NULL ) {
+        return;
+        }
+
+
+    // take everything new under lock, and write it without
+
+    mRingLock.lock();
+
+    int numStringBytes = mPendingStrings.size();
+    unsigned char *stringBytes = NULL;
+
+    if( numStringBytes > 0 ) {
+        stringBytes = mPendingStrings.getElementArray();
+        mPendingStrings.deleteAll();
+        }
+
+    int dirtyStart = mDirtyStart;
+    int dirtyLength = mDirtyLength;
+
+    // dirty region may wrap around end of ring
+    int firstLength = dirtyLength;
+    if( dirtyStart + firstLength > mRingSize ) {
+        firstLength = mRingSize - dirtyStart;
+        }
+    int secondLength = dirtyLength - firstLength;
+
+    memcpy( mFlushBuffer, &( mRing[ dirtyStart ] ), firstLength );
+    memcpy( &( mFlushBuffer[ firstLength ] ), mRing, secondLength );
+
+    mDirtyLength = 0;
+
+    unsigned char header[ TRACE_HEADER_SIZE ];
+    memset( header, 0, TRACE_HEADER_SIZE );
+
+    memcpy( header, TRACE_FILE_MAGIC, TRACE_FILE_MAGIC_LENGTH );
+    putU32( &( header[8] ), mRingSize );
+    putU32( &( header[12] ), mWriteOffset );
+    putU32( &( header[16] ), mOldestOffset );
+    putU32( &( header[20] ), mWrapped );
+
+    mRingLock.unlock();
+
+
+    // strings first, so trace file never refers to missing ones
+    if( stringBytes != NULL ) {
+        fwrite( stringBytes, 1, numStringBytes, mStringFile );
+        fflush( mStringFile );
+
+        delete [] stringBytes;
+        }
+
+    if( dirtyLength > 0 ) {
+        fseek( mTraceFile, TRACE_HEADER_SIZE + dirtyStart, SEEK_SET );
+        fwrite( mFlushBuffer, 1, firstLength, mTraceFile );
+
+        if( secondLength > 0 ) {
+            fseek( mTraceFile, TRACE_HEADER_SIZE, SEEK_SET );
+            fwrite( &( mFlushBuffer[ firstLength ] ), 1, secondLength,
+                    mTraceFile );
+            }
+        }
+
+    fseek( mTraceFile, 0, SEEK_SET );
+    fwrite( header, 1, TRACE_HEADER_SIZE, mTraceFile );
+
+    fflush( mTraceFile );
+    }
@@ -0,0 +1,173 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14   Jason Rohrer
+ * Created.
+ */
+
+
+#include "minorGems/common.h"
+
+
+
+#ifndef BINARY_TRACE_LOG_INCLUDED
+#define BINARY_TRACE_LOG_INCLUDED
+
+
+
+#include "PrintLog.h"
+
+#include "minorGems/system/MutexLock.h"
+#include "minorGems/system/BinarySemaphore.h"
+#include "minorGems/util/HashMap.h"
+#include "minorGems/util/SimpleVector.h"
+
+#include <stdio.h>
+
+
+
+class BinaryTraceLogWriter;
+
+
+
+/**
+ * A log that records high-frequency messages in binary, without
+ * formatting them, so trace logging can stay on under real load.
+ *
+ * Messages at inBinaryLevel and above (by default, just trace messages)
+ * are stored as a format string ID, a logger name ID, a microsecond
+ * timestamp, and the raw argument values, in a fixed-size ring that
+ * keeps the newest inRingBytes worth of records.  A writer thread copies
+ * new records to the trace file every inFlushIntervalMS.  Each format
+ * string and logger name is written once, to a separate string file, the
+ * first time it's seen.
+ *
+ * All other messages go to inTextLog, formatted as usual.
+ *
+ * Run the traceFormatter tool on the trace file to render it as text
+ * (see binaryTraceFormat.h for the file format).
+ *
+ * Format strings are looked up by contents, so they need not be
+ * literals.  Strings passed as %s arguments are copied into the record
+ * (up to 1024 bytes each).  If more than TRACE_MAX_STRING_ID distinct
+ * format strings are seen, messages with new ones go to inTextLog.
+ *
+ * @author Jason Rohrer
+ */
+class BinaryTraceLog : public PrintLog {
+
+    public:
+
+
+        /**
+         * Constructs a log, creating (or replacing) the trace file, and
+         * starts its writer thread.
+         *
+         * @param inTextLog log for messages below inBinaryLevel.
+         *   Destroyed by this class.
+         * @param inTraceFileName name of trace file.  The string file is
+         *   this name plus TRACE_STRINGS_SUFFIX.
+         *   Must be destroyed by caller.
+         * @param inRingBytes size of ring, and of trace file (plus
+         *   header).  Defaults to 4 MiB.
+         * @param inBinaryLevel lowest level (highest number) recorded in
+         *   binary.  Defaults to Log::TRACE_LEVEL.
+         * @param inFlushIntervalMS how often new records are written to
+         *   the trace file.  Defaults to 100.
+         */
+        BinaryTraceLog( Log *inTextLog,
+                        const char *inTraceFileName,
+                        int inRingBytes = 4 * 1024 * 1024,
+                        int inBinaryLevel = Log::TRACE_LEVEL,
+                        int inFlushIntervalMS = 100 );
+
+
+        // writes all recorded messages before returning
+        virtual ~BinaryTraceLog();
+
+
+
+        // sets level for inTextLog too
+        virtual void setLoggingLevel( int inLevel );
+
+
+        // overrides PrintLog::logStringV
+        virtual void logStringV( const char *inLoggerName,
+                                 int inLevel, const char* inFormatString,
+                                 va_list inArgList );
+
+
+
+    protected:
+
+        friend class BinaryTraceLogWriter;
+
+
+        Log *mTextLog;
+
+        int mBinaryLevel;
+
+        FILE *mTraceFile;
+        FILE *mStringFile;
+
+
+        // protects everything below, except where noted
+        MutexLock mRingLock;
+
+        unsigned char *mRing;
+        int mRingSize;
+
+        // just past newest record
+        int mWriteOffset;
+
+        // oldest record, once ring has wrapped
+        int mOldestOffset;
+        char mWrapped;
+
+        // region written since last flush, starting at mDirtyStart
+        // and possibly wrapping around end of ring
+        int mDirtyStart;
+        int mDirtyLength;
+
+        // format strings and logger names, by contents
+        HashMap<const char*, int> mStringIDs;
+        int mNextStringID;
+
+        // string file records not yet written
+        SimpleVector<unsigned char> mPendingStrings;
+
+
+        // for writer thread only
+        // copy of ring, taken under mRingLock, written without it
+        unsigned char *mFlushBuffer;
+
+        volatile int mStopping;
+
+        int mFlushIntervalMS;
+
+        BinarySemaphore mWakeSemaphore;
+
+        BinaryTraceLogWriter *mWriter;
+
+
+        // gets ID for a string, assigning one if it's new
+        // returns -1 if out of IDs
+        // mRingLock must be held
+        int getStringID( const char *inString );
+
+        // copies a record into ring
+        // mRingLock must be held
+        void addRecord( unsigned char *inRecord, int inLength );
+
+
+        // runs writer thread until stopped
+        void writerLoop();
+
+        // writes new strings and records to files
+        void flush();
+
+    };
+
+
+
+#endif
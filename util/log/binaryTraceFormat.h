@@ -0,0 +1,300 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14   Jason Rohrer
+ * Created.
+ */
+
+
+
+#ifndef BINARY_TRACE_FORMAT_INCLUDED
+#define BINARY_TRACE_FORMAT_INCLUDED
+
+
+#include <stddef.h>
+
+
+
+/**
+ * File format shared by BinaryTraceLog and the traceFormatter tool.
+ *
+ * All numbers are in the writing machine's byte order, so traces are
+ * formatted on the same kind of machine that wrote them.
+ *
+ *
+ * Trace file:
+ *
+ *   header:
+ *     8 bytes   TRACE_FILE_MAGIC
+ *     u32       ring size in bytes
+ *     u32       write offset (just past newest record)
+ *     u32       offset of oldest record, if ring has wrapped
+ *     u32       1 if ring has wrapped, else 0
+ *     8 bytes   reserved
+ *
+ *   ring, right after header, holding records back to back:
+ *     u16       record length, including this field
+ *               (0 marks unused space at end of ring, skip to start)
+ *     u16       format string ID
+ *     u16       logger name ID
+ *     u8        level
+ *     u8        number of arguments stored
+ *     i64       time, in microseconds since the epoch
+ *     arguments, each one tag byte followed by its value
+ *
+ *   Records never straddle the end of the ring.  Space left at the end
+ *   too small for a length field is also unused.
+ *
+ *
+ * String file (trace file name plus TRACE_STRINGS_SUFFIX), appended to
+ * as new format strings and logger names are seen:
+ *     u16       ID
+ *     u16       length
+ *     bytes     string (no terminating \0)
+ */
+
+
+#define TRACE_FILE_MAGIC          "MGTRACE1"
+#define TRACE_FILE_MAGIC_LENGTH   8
+
+#define TRACE_HEADER_SIZE         32
+
+#define TRACE_RECORD_HEADER_SIZE  16
+
+#define TRACE_STRINGS_SUFFIX      ".strings"
+
+// IDs run from 0 through this
+#define TRACE_MAX_STRING_ID       65534
+
+
+
+// argument tags
+
+// 4 bytes (also used for * widths and precisions)
+#define TRACE_ARG_INT       'i'
+// 8 bytes (long, long long, size_t, and so on)
+#define TRACE_ARG_INT64     'q'
+// 8 bytes (long double is stored as double)
+#define TRACE_ARG_DOUBLE    'd'
+// 8 bytes
+#define TRACE_ARG_POINTER   'p'
+// u16 length, then bytes (NULL stored as "(null)")
+#define TRACE_ARG_STRING    's'
+
+
+
+// C types that printf conversions take
+enum TraceArgType {
+    TRACE_TYPE_NONE = 0,
+    TRACE_TYPE_INT,
+    TRACE_TYPE_LONG,
+    TRACE_TYPE_LONG_LONG,
+    TRACE_TYPE_SIZE,
+    TRACE_TYPE_DOUBLE,
+    TRACE_TYPE_LONG_DOUBLE,
+    TRACE_TYPE_STRING,
+    TRACE_TYPE_POINTER,
+    // %n, which takes a pointer but is never written through
+    TRACE_TYPE_COUNT_POINTER
+    };
+
+
+
+typedef struct TraceConversion {
+        // the % that starts it
+        const char *start;
+
+        // just past conversion character
+        const char *end;
+
+        // the conversion character, or '%' for %%
+        char conversion;
+
+        // count of * widths or precisions (each an int argument, taken
+        // before the value)
+        int numStars;
+
+        TraceArgType argType;
+
+        // flags, width, and precision, without length modifier
+        const char *specStart;
+        const char *specEnd;
+    } TraceConversion;
+
+
+
+/**
+ * Finds the next conversion in a printf format string.
+ *
+ * @param inFormat where to start looking.
+ * @param outConversion filled in with conversion found.
+ *
+ * @return inFormat position just past conversion, or NULL if there are
+ *   no more conversions.
+ */
+inline const char *nextTraceConversion( const char *inFormat,
+                                        TraceConversion *outConversion ) {
+
+    const char *p = inFormat;
+
+    while( *p != '\0' && *p != '%' ) {
+        p++;
+        }
+
+    if( *p == '\0' ) {
+        return NULL;
+        }
+
+    outConversion->start = p;
+    outConversion->numStars = 0;
+    outConversion->argType = TRACE_TYPE_NONE;
+
+    p++;
+
+    outConversion->specStart = p;
+
+    // flags
+    while( *p == '-' || *p == '+' || *p == ' ' || *p == '#' ||
+           *p == '0' || *p == '\'' ) {
+        p++;
+        }
+
+    // width
+    if( *p == '*' ) {
+        outConversion->numStars++;
+        p++;
+        }
+    else {
+        while( *p >= '0' && *p <= '9' ) {
+            p++;
+            }
+        }
+
+    // precision
+    if( *p == '.' ) {
+        p++;
+
+        if( *p == '*' ) {
+            outConversion->numStars++;
+            p++;
+            }
+        else {
+            while( *p >= '0' && *p <= '9' ) {
+                p++;
+                }
+            }
+        }
+
+    outConversion->specEnd = p;
+
+
+    // length
+    int numLongs = 0;
+    char longDouble = false;
+    char isSize = false;
+
+    while( *p == 'h' || *p == 'l' || *p == 'L' || *p == 'q' ||
+           *p == 'j' || *p == 'z' || *p == 't' || *p == 'I' ) {
+
+        switch( *p ) {
+            case 'l':
+                numLongs++;
+                break;
+            case 'L':
+                longDouble = true;
+                break;
+            case 'q':
+            case 'j':
+                numLongs = 2;
+                break;
+            case 'z':
+            case 't':
+            case 'I':
+                isSize = true;
+                break;
+            }
+        p++;
+
+        // MSVC's I64 and I32
+        if( p[-1] == 'I' &&
+            ( ( p[0] == '6' && p[1] == '4' ) ||
+              ( p[0] == '3' && p[1] == '2' ) ) ) {
+            if( p[0] == '6' ) {
+                numLongs = 2;
+                isSize = false;
+                }
+            p += 2;
+            }
+        }
+
+    outConversion->conversion = *p;
+
+    if( *p == '\0' ) {
+        // format ends mid-conversion
+        outConversion->end = p;
+        outConversion->numStars = 0;
+        return p;
+        }
+
+    outConversion->end = p + 1;
+
+
+    switch( *p ) {
+        case 'd':
+        case 'i':
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+            if( isSize ) {
+                outConversion->argType = TRACE_TYPE_SIZE;
+                }
+            else if( numLongs >= 2 ) {
+                outConversion->argType = TRACE_TYPE_LONG_LONG;
+                }
+            else if( numLongs == 1 ) {
+                outConversion->argType = TRACE_TYPE_LONG;
+                }
+            else {
+                outConversion->argType = TRACE_TYPE_INT;
+                }
+            break;
+        case 'c':
+            outConversion->argType = TRACE_TYPE_INT;
+            break;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            if( longDouble ) {
+                outConversion->argType = TRACE_TYPE_LONG_DOUBLE;
+                }
+            else {
+                outConversion->argType = TRACE_TYPE_DOUBLE;
+                }
+            break;
+        case 's':
+            outConversion->argType = TRACE_TYPE_STRING;
+            break;
+        case 'p':
+            outConversion->argType = TRACE_TYPE_POINTER;
+            break;
+        case 'n':
+            outConversion->argType = TRACE_TYPE_COUNT_POINTER;
+            break;
+        default:
+            // %% or unknown, takes nothing
+            outConversion->numStars = 0;
+            break;
+        }
+
+    return outConversion->end;
+    }
+
+
+
+#endif
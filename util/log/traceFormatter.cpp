@@ -0,0 +1,496 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14   Jason Rohrer
+ * Created.
+ */
+
+
+/**
+ * Renders a BinaryTraceLog trace file as text, oldest record first, in
+ * the same line format as PrintLog.
+ *
+ * Usage:
+ *   traceFormatter trace_file [string_file]
+ *
+ * string_file defaults to trace_file plus TRACE_STRINGS_SUFFIX.
+ *
+ * Build with:
+ *   make traceFormatter
+ */
+
+
+#include "minorGems/util/log/binaryTraceFormat.h"
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <time.h>
+
+
+
+// indexed by ID, NULL for unknown IDs
+static char *strings[ TRACE_MAX_STRING_ID + 1 ];
+
+
+
+static int getU16( unsigned char *inSource ) {
+    uint16_t v;
+    memcpy( &v, inSource, 2 );
+    return v;
+    }
+
+
+static int getU32( unsigned char *inSource ) {
+    uint32_t v;
+    memcpy( &v, inSource, 4 );
+    return v;
+    }
+
+
+
+static const char *getString( int inID ) {
+    if( strings[ inID ] == NULL ) {
+        return "(unknown string)";
+        }
+    return strings[ inID ];
+    }
+
+
+
+// returns false on failure
+static char readStrings( const char *inFileName ) {
+    FILE *f = fopen( inFileName, "rb" );
+
+    if( f == NULL ) {
+        printf( "Failed to open string file %s\n", inFileName );
+        return false;
+        }
+
+    unsigned char header[4];
+
+    while( fread( header, 1, 4, f ) == 4 ) {
+        int id = getU16( header );
+        int length = getU16( &( header[2] ) );
+
+        char *s = new char[ length + 1 ];
+
+        if( (int)fread( s, 1, length, f ) != length ) {
+            // cut off mid-string by a crash
+            delete [] s;
+            break;
+            }
+        s[ length ] = '\0';
+
+        if( strings[ id ] != NULL ) {
+            delete [] strings[ id ];
+            }
+        strings[ id ] = s;
+        }
+
+    fclose( f );
+
+    return true;
+    }
+
+
+
+// reads one argument value with inTag from record
+// returns pointer past it, or NULL if record doesn't hold it
+static unsigned char *getArg( unsigned char *inArg, unsigned char *inEnd,
+                              char inTag ) {
+    if( inArg >= inEnd || *inArg != inTag ) {
+        return NULL;
+        }
+
+    switch( inTag ) {
+        case TRACE_ARG_INT:
+            return ( inEnd - inArg >= 5 ) ? inArg + 5 : NULL;
+        case TRACE_ARG_INT64:
+        case TRACE_ARG_DOUBLE:
+        case TRACE_ARG_POINTER:
+            return ( inEnd - inArg >= 9 ) ? inArg + 9 : NULL;
+        case TRACE_ARG_STRING:
+            if( inEnd - inArg < 3 ) {
+                return NULL;
+                }
+            if( inEnd - inArg < 3 + getU16( &( inArg[1] ) ) ) {
+                return NULL;
+                }
+            return inArg + 3 + getU16( &( inArg[1] ) );
+        }
+
+    return NULL;
+    }
+
+
+
+// appends to outText, cutting off silently when it's full
+static void appendText( char *outText, int inTextSize, int *ioUsed,
+                        const char *inFormatString, ... ) {
+
+    if( *ioUsed >= inTextSize - 1 ) {
+        return;
+        }
+
+    va_list argList;
+    va_start( argList, inFormatString );
+
+    int n = vsnprintf( &( outText[ *ioUsed ] ), inTextSize - *ioUsed,
+                       inFormatString, argList );
+
+    va_end( argList );
+
+    if( n > 0 ) {
+        *ioUsed += n;
+        }
+    if( *ioUsed > inTextSize - 1 ) {
+        // vsnprintf reports length it would have written
+        *ioUsed = inTextSize - 1;
+        }
+    }
+
+
+
+// renders message text of a record into outText
+static void renderMessage( const char *inFormat,
+                           unsigned char *inArgs, unsigned char *inEnd,
+                           char *outText, int inTextSize ) {
+
+    int used = 0;
+
+    outText[0] = '\0';
+
+    unsigned char *arg = inArgs;
+    char missing = false;
+
+    TraceConversion c;
+    const char *last = inFormat;
+    const char *next;
+
+    while( ( next = nextTraceConversion( last, &c ) ) != NULL ) {
+
+        // literal text before conversion
+        appendText( outText, inTextSize, &used,
+                    "%.*s", (int)( c.start - last ), last );
+
+        last = next;
+
+        if( c.conversion == '%' ) {
+            appendText( outText, inTextSize, &used, "%%" );
+            continue;
+            }
+        if( c.argType == TRACE_TYPE_NONE ) {
+            // unknown conversion, show as is
+            appendText( outText, inTextSize, &used,
+                        "%.*s", (int)( c.end - c.start ), c.start );
+            continue;
+            }
+
+        if( missing ) {
+            appendText( outText, inTextSize, &used, "(?)" );
+            continue;
+            }
+
+
+        // rebuild spec with recorded * values filled in, and with
+        // length modifier matching the recorded type
+        char spec[ 64 ];
+        int specLength = 0;
+
+        spec[ specLength++ ] = '%';
+
+        for( const char *s = c.specStart;
+             s < c.specEnd && specLength < 40; s++ ) {
+
+            if( *s == '*' ) {
+                unsigned char *nextArg =
+                    getArg( arg, inEnd, TRACE_ARG_INT );
+                if( nextArg == NULL ) {
+                    missing = true;
+                    break;
+                    }
+                int32_t star;
+                memcpy( &star, &( arg[1] ), 4 );
+                arg = nextArg;
+
+                specLength += snprintf( &( spec[ specLength ] ),
+                                        sizeof( spec ) - specLength,
+                                        "%d", (int)star );
+                }
+            else {
+                spec[ specLength++ ] = *s;
+                }
+            }
+
+        if( missing ) {
+            appendText( outText, inTextSize, &used, "(?)" );
+            continue;
+            }
+
+
+        spec[ specLength ] = '\0';
+
+        char tag;
+        int stringPrecision = -1;
+
+        switch( c.argType ) {
+            case TRACE_TYPE_INT:
+                tag = TRACE_ARG_INT;
+                break;
+            case TRACE_TYPE_LONG:
+            case TRACE_TYPE_LONG_LONG:
+            case TRACE_TYPE_SIZE:
+                tag = TRACE_ARG_INT64;
+                spec[ specLength++ ] = 'l';
+                spec[ specLength++ ] = 'l';
+                break;
+            case TRACE_TYPE_DOUBLE:
+            case TRACE_TYPE_LONG_DOUBLE:
+                tag = TRACE_ARG_DOUBLE;
+                break;
+            case TRACE_TYPE_STRING: {
+                tag = TRACE_ARG_STRING;
+
+                // apply any precision ourselves, since string isn't
+                // \0-terminated in record
+                char *dot = (char *)memchr( spec, '.', specLength );
+                if( dot != NULL ) {
+                    stringPrecision = atoi( &( dot[1] ) );
+                    specLength = dot - spec;
+                    }
+                spec[ specLength++ ] = '.';
+                spec[ specLength++ ] = '*';
+                break;
+                }
+            default:
+                tag = TRACE_ARG_POINTER;
+                break;
+            }
+
+        spec[ specLength++ ] = c.conversion;
+        spec[ specLength ] = '\0';
+
+
+        unsigned char *nextArg = getArg( arg, inEnd, tag );
+
+        if( nextArg == NULL ) {
+            missing = true;
+            appendText( outText, inTextSize, &used, "(?)" );
+            continue;
+            }
+
+        unsigned char *value = &( arg[1] );
+        arg = nextArg;
+
+        switch( tag ) {
+            case TRACE_ARG_INT: {
+                int32_t v;
+                memcpy( &v, value, 4 );
+                appendText( outText, inTextSize, &used, spec, (int)v );
+                break;
+                }
+            case TRACE_ARG_INT64: {
+                int64_t v;
+                memcpy( &v, value, 8 );
+                appendText( outText, inTextSize, &used, spec, (long long)v );
+                break;
+                }
+            case TRACE_ARG_DOUBLE: {
+                double v;
+                memcpy( &v, value, 8 );
+                appendText( outText, inTextSize, &used, spec, v );
+                break;
+                }
+            case TRACE_ARG_STRING: {
+                int length = getU16( value );
+
+                if( stringPrecision >= 0 && stringPrecision < length ) {
+                    length = stringPrecision;
+                    }
+                appendText( outText, inTextSize, &used,
+                            spec, length, (char *)&( value[2] ) );
+                break;
+                }
+            case TRACE_ARG_POINTER: {
+                if( c.argType == TRACE_TYPE_COUNT_POINTER ) {
+                    // %n prints nothing
+                    break;
+                    }
+                uint64_t v;
+                memcpy( &v, value, 8 );
+                appendText( outText, inTextSize, &used,
+                            "%p", (void *)(uintptr_t)v );
+                break;
+                }
+            }
+        }
+
+    // text after last conversion
+    appendText( outText, inTextSize, &used, "%s", last );
+    }
+
+
+
+// prints one record
+// returns false if record is damaged
+static char printRecord( unsigned char *inRecord, int inLength ) {
+    if( inLength < TRACE_RECORD_HEADER_SIZE ) {
+        return false;
+        }
+
+    int formatID = getU16( &( inRecord[2] ) );
+    int nameID = getU16( &( inRecord[4] ) );
+    int level = inRecord[6];
+
+    int64_t microseconds;
+    memcpy( &microseconds, &( inRecord[8] ), 8 );
+
+    time_t seconds = (time_t)( microseconds / 1000000 );
+    int fraction = (int)( microseconds % 1000000 );
+
+    char dateString[ 64 ];
+    strncpy( dateString, ctime( &seconds ), sizeof( dateString ) - 1 );
+    dateString[ sizeof( dateString ) - 1 ] = '\0';
+
+    // this date string ends with a newline...
+    // get rid of it
+    int dateLength = strlen( dateString );
+    if( dateLength > 0 && dateString[ dateLength - 1 ] == '\n' ) {
+        dateString[ dateLength - 1 ] = '\0';
+        }
+
+
+    char text[ 8192 ];
+
+    renderMessage( getString( formatID ),
+                   &( inRecord[ TRACE_RECORD_HEADER_SIZE ] ),
+                   &( inRecord[ inLength ] ),
+                   text, sizeof( text ) );
+
+    // same as PrintLog, but with microseconds
+    printf( "L%d | %s (%d.%03d ms) | %s | %s\n",
+            level, dateString, fraction / 1000, fraction % 1000,
+            getString( nameID ), text );
+
+    return true;
+    }
+
+
+
+// prints records from inStart up to inEnd, or to end marker
+// returns false if a damaged record was hit
+static char printRecords( unsigned char *inRing, int inRingSize,
+                          int inStart, int inEnd ) {
+    int pos = inStart;
+
+    while( pos < inEnd && inRingSize - pos >= 2 ) {
+        int length = getU16( &( inRing[ pos ] ) );
+
+        if( length == 0 ) {
+            // end marker
+            return true;
+            }
+
+        if( length < TRACE_RECORD_HEADER_SIZE || pos + length > inRingSize ) {
+            printf( "Damaged record at offset %d\n", pos );
+            return false;
+            }
+
+        printRecord( &( inRing[ pos ] ), length );
+
+        pos += length;
+        }
+
+    return true;
+    }
+
+
+
+int main( int inNumArgs, char **inArgs ) {
+
+    if( inNumArgs != 2 && inNumArgs != 3 ) {
+        printf( "Usage:\n  %s trace_file [string_file]\n", inArgs[0] );
+        return 1;
+        }
+
+    const char *traceFileName = inArgs[1];
+
+    char *stringFileName;
+
+    if( inNumArgs == 3 ) {
+        stringFileName = new char[ strlen( inArgs[2] ) + 1 ];
+        strcpy( stringFileName, inArgs[2] );
+        }
+    else {
+        stringFileName = new char[ strlen( traceFileName ) +
+                                   strlen( TRACE_STRINGS_SUFFIX ) + 1 ];
+        strcpy( stringFileName, traceFileName );
+        strcat( stringFileName, TRACE_STRINGS_SUFFIX );
+        }
+
+    memset( strings, 0, sizeof( strings ) );
+
+    char stringsRead = readStrings( stringFileName );
+
+    delete [] stringFileName;
+
+    if( ! stringsRead ) {
+        return 1;
+        }
+
+
+    FILE *f = fopen( traceFileName, "rb" );
+
+    if( f == NULL ) {
+        printf( "Failed to open trace file %s\n", traceFileName );
+        return 1;
+        }
+
+    unsigned char header[ TRACE_HEADER_SIZE ];
+
+    if( fread( header, 1, TRACE_HEADER_SIZE, f ) != TRACE_HEADER_SIZE ||
+        memcmp( header, TRACE_FILE_MAGIC, TRACE_FILE_MAGIC_LENGTH ) != 0 ) {
+        printf( "%s is not a trace file\n", traceFileName );
+        fclose( f );
+        return 1;
+        }
+
+    int ringSize = getU32( &( header[8] ) );
+    int writeOffset = getU32( &( header[12] ) );
+    int oldestOffset = getU32( &( header[16] ) );
+    int wrapped = getU32( &( header[20] ) );
+
+    if( ringSize <= 0 || writeOffset > ringSize || oldestOffset > ringSize ) {
+        printf( "%s has a damaged header\n", traceFileName );
+        fclose( f );
+        return 1;
+        }
+
+    // parts of ring never written aren't in file
+    unsigned char *ring = new unsigned char[ ringSize ];
+    memset( ring, 0, ringSize );
+
+    fread( ring, 1, ringSize, f );
+    fclose( f );
+
+
+    if( wrapped ) {
+        printRecords( ring, ringSize, oldestOffset, ringSize );
+        }
+    printRecords( ring, ringSize, 0, writeOffset );
+
+
+    delete [] ring;
+
+    for( int i=0; i<=TRACE_MAX_STRING_ID; i++ ) {
+        if( strings[i] != NULL ) {
+            delete [] strings[i];
+            }
+        }
+
+    return 0;
+    }
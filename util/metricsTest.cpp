@@ -0,0 +1,209 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+/**
+ * Checks MetricsRegistry counts under contention from several threads,
+ * get-or-create and type clashes, function gauges, and the text format,
+ * then times counter increments against a MutexLock-guarded count.
+ *
+ * Compile from above the minorGems directory with:
+ *   g++ -O2 -I. minorGems/util/metricsTest.cpp minorGems/util/Metrics.cpp
+ *     minorGems/util/stringUtils.cpp minorGems/system/linux/[A-Z]*.cpp
+ *     minorGems/system/unix/TimeUnix.cpp -lpthread -o metricsTest
+ */
+
+#include "Metrics.h"
+#include "minorGems/system/Thread.h"
+#include "minorGems/system/Time.h"
+
+#include <stdio.h>
+#include <string.h>
+
+
+
+#define NUM_THREADS 4
+#define NUM_PER_THREAD 1000000
+
+
+
+static int numBad = 0;
+
+
+static MetricsRegistry registry;
+
+static MetricsCounter *counter;
+static MetricsGauge *gauge;
+static MetricsHistogram *histogram;
+
+static double bounds[] = { 1, 10, 100 };
+
+
+
+class UpdateThread : public Thread {
+    public:
+        void run() {
+            for( int i=0; i<NUM_PER_THREAD; i++ ) {
+                counter->increment();
+                }
+            // 0.5 is exact, so the sum has no rounding
+            for( int i=0; i<NUM_PER_THREAD / 10; i++ ) {
+                gauge->add( 1 );
+                histogram->observe( 0.5 * ( i % 4 ) * 100 );
+                gauge->add( -1 );
+                }
+            }
+    };
+
+
+
+static MutexLock lockedLock;
+static int64_t lockedCount = 0;
+
+
+class LockedThread : public Thread {
+    public:
+        void run() {
+            for( int i=0; i<NUM_PER_THREAD; i++ ) {
+                lockedLock.lock();
+                lockedCount++;
+                lockedLock.unlock();
+                }
+            }
+    };
+
+
+
+static double getFortyTwo( void *inData ) {
+    return *( (double *)inData );
+    }
+
+
+
+static void checkContains( const char *inText, const char *inLine ) {
+    if( strstr( inText, inLine ) == NULL ) {
+        printf( "Text missing line:  %s\n", inLine );
+        numBad++;
+        }
+    }
+
+
+
+int main() {
+
+    counter = registry.getCounter( "test_total", "Test counter." );
+    gauge = registry.getGauge( "test_in_flight", "Test gauge." );
+    histogram = registry.getHistogram( "test_seconds", "Test histogram.",
+                                       bounds, 3 );
+
+    // same name gets same metric, other type gets nothing
+    if( registry.getCounter( "test_total", "Again." ) != counter ||
+        registry.getGauge( "test_total", "Wrong type." ) != NULL ) {
+        printf( "Get-or-create by name failed\n" );
+        numBad++;
+        }
+
+
+    double startTime = Time::getMonotonicTime();
+
+    UpdateThread threads[ NUM_THREADS ];
+    for( int t=0; t<NUM_THREADS; t++ ) {
+        threads[t].start();
+        }
+    for( int t=0; t<NUM_THREADS; t++ ) {
+        threads[t].join();
+        }
+
+    double atomicTime = Time::getMonotonicTime() - startTime;
+
+
+    startTime = Time::getMonotonicTime();
+
+    LockedThread lockedThreads[ NUM_THREADS ];
+    for( int t=0; t<NUM_THREADS; t++ ) {
+        lockedThreads[t].start();
+        }
+    for( int t=0; t<NUM_THREADS; t++ ) {
+        lockedThreads[t].join();
+        }
+
+    double lockedTime = Time::getMonotonicTime() - startTime;
+
+
+    int64_t total = (int64_t)NUM_THREADS * NUM_PER_THREAD;
+    int64_t numObserved = total / 10;
+
+    if( counter->get() != total || gauge->get() != 0 ||
+        lockedCount != total ) {
+        printf( "Counter %lld, gauge %lld after threads\n",
+                (long long)counter->get(), (long long)gauge->get() );
+        numBad++;
+        }
+
+    // values 0, 50, 100, 150 in turn
+    if( histogram->getCount() != numObserved ||
+        histogram->getBucketCount( 0 ) != numObserved / 4 ||
+        histogram->getBucketCount( 1 ) != 0 ||
+        histogram->getBucketCount( 2 ) != numObserved / 2 ||
+        histogram->getBucketCount( 3 ) != numObserved / 4 ||
+        histogram->getSum() != 75.0 * numObserved ) {
+        printf( "Histogram wrong after threads\n" );
+        numBad++;
+        }
+
+
+    double fortyTwo = 42.5;
+    if( ! registry.addGaugeFunction( "test_function", "Test function.",
+                                     getFortyTwo, &fortyTwo ) ||
+        registry.addGaugeFunction( "test_seconds", "Wrong type.",
+                                   getFortyTwo, &fortyTwo ) ) {
+        printf( "addGaugeFunction failed\n" );
+        numBad++;
+        }
+
+
+    char *text = registry.getText();
+
+    checkContains( text, "# HELP test_total Test counter.\n"
+                   "# TYPE test_total counter\n"
+                   "test_total 4000000\n" );
+    checkContains( text, "# TYPE test_in_flight gauge\n"
+                   "test_in_flight 0\n" );
+    checkContains( text, "# TYPE test_seconds histogram\n"
+                   "test_seconds_bucket{le=\"1\"} 100000\n"
+                   "test_seconds_bucket{le=\"10\"} 100000\n"
+                   "test_seconds_bucket{le=\"100\"} 300000\n"
+                   "test_seconds_bucket{le=\"+Inf\"} 400000\n"
+                   "test_seconds_sum 30000000\n"
+                   "test_seconds_count 400000\n" );
+    checkContains( text, "# TYPE test_function gauge\n"
+                   "test_function 42.5\n" );
+    delete [] text;
+
+
+    registry.removeGaugeFunction( "test_function" );
+
+    text = registry.getText();
+    if( strstr( text, "test_function" ) != NULL ) {
+        printf( "Function gauge not removed\n" );
+        numBad++;
+        }
+    delete [] text;
+
+
+    printf( "%d threads x %d increments:  MetricsCounter %.3f s "
+            "(plus a tenth as many histogram and gauge updates), "
+            "MutexLock count %.3f s\n",
+            NUM_THREADS, NUM_PER_THREAD, atomicTime, lockedTime );
+
+
+    if( numBad == 0 ) {
+        printf( "All tests passed\n" );
+        return 0;
+        }
+    printf( "%d failures\n", numBad );
+    return 1;
+    }
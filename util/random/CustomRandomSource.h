@@ -9,6 +9,9 @@
  *
  * 2014-June-6    Jason Rohrer
  * Moved shared functionality into RandomSourc32 base class.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Added a fillRand32 that inlines genRand32.
  */
 
 
@@ -52,6 +55,10 @@ class CustomRandomSource : public RandomSource32 {
         void reseed( unsigned int inSeed );
 
 
+        // overrides the default implementation
+        virtual void fillRand32( unsigned int *outValues, int inNumValues );
+
+
 
     protected:
 
@@ -151,4 +158,14 @@ inline unsigned int CustomRandomSource::genRand32() {
     }
 
 
+inline void CustomRandomSource::fillRand32( unsigned int *outValues, 
+                                            int inNumValues ) {
+    for( int i=0; i<inNumValues; i++ ) {
+        // qualified, so not a virtual call
+        outValues[i] = CustomRandomSource::genRand32();
+        }
+    }
+
+
+
 #endif
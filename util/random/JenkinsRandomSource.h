@@ -3,6 +3,9 @@
  *
  * 2014-June-6    Jason Rohrer
  * Created.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Added a fillRand32 that inlines genRand32.
  */
 
 
@@ -44,6 +47,10 @@ class JenkinsRandomSource : public RandomSource32 {
         void reseed( unsigned int inSeed );
 
 
+        // overrides the default implementation
+        virtual void fillRand32( unsigned int *outValues, int inNumValues );
+
+
 
     protected:
 
@@ -100,4 +107,14 @@ inline unsigned int JenkinsRandomSource::genRand32() {
 
 
 
+inline void JenkinsRandomSource::fillRand32( unsigned int *outValues, 
+                                             int inNumValues ) {
+    for( int i=0; i<inNumValues; i++ ) {
+        // qualified, so not a virtual call
+        outValues[i] = JenkinsRandomSource::genRand32();
+        }
+    }
+
+
+
 #endif
@@ -10,12 +10,25 @@
 *	Mods:	
 *		Jason Rohrer	12-20-2000	Changed genFractalNoise2d function to make
 *									it less blocky.
+*		Jason Rohrer	10-15-2026	Added genFractalNoise2dTiled.
 *
 */
 
 
 #include "Noise.h"
 
+#include "minorGems/system/ThreadPool.h"
+
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || \
+    ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+    #define NOISE_SSE2
+    #include <emmintrin.h>
+#elif defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+    #define NOISE_NEON
+    #include <arm_neon.h>
+#endif
+
 
 // fills 2d image with ARGB noise
 void genRandNoise2d(unsigned long *buff, int buffHigh, int buffWide) {
@@ -309,4 +322,297 @@ void genFractalNoise( double *inBuffer, int inWidth, int inMaxFrequency,
 		delete [] blockValues;
 		}
 	
-	}	
+	}
+
+
+
+
+// pixels on a side of each tile that genFractalNoise2dTiled fills
+// with all octaves before moving on
+#define NOISE_TILE_SIZE 64
+
+
+
+// murmur3 finalizer
+static inline unsigned int noiseMix( unsigned int inX ) {
+	inX ^= inX >> 16;
+	inX *= 0x85ebca6bU;
+	inX ^= inX >> 13;
+	inX *= 0xc2b2ae35U;
+	inX ^= inX >> 16;
+	return inX;
+	}
+
+
+
+// random value in [-1,1] at a lattice point
+static inline float noiseLatticeValue( int inX, int inY,
+	unsigned int inOctaveSeed ) {
+	
+	unsigned int h = noiseMix( inOctaveSeed ^ (unsigned int)inX * 0x8da6b343U );
+	h = noiseMix( h ^ (unsigned int)inY * 0xd8163841U );
+	
+	// top 24 bits, which a float holds exactly
+	return (float)( h >> 8 ) * ( 2.0f / 16777216.0f ) - 1.0f;
+	}
+
+
+
+// lattice cell and smoothed position within it, per pixel column or row,
+// for one octave
+typedef struct NoiseAxisTable {
+		int *cells;
+		float *weights;
+	} NoiseAxisTable;
+
+
+
+static void fillNoiseAxisTable( NoiseAxisTable *inTable, int inLength,
+	double inCellSize ) {
+	
+	inTable->cells = new int[ inLength ];
+	inTable->weights = new float[ inLength ];
+	
+	double invCellSize = 1.0 / inCellSize;
+	
+	for( int i=0; i<inLength; i++ ) {
+		double u = i * invCellSize;
+		double cell = floor( u );
+		double f = u - cell;
+		
+		inTable->cells[i] = (int)cell;
+		// smoothstep, so slopes match across cell edges
+		inTable->weights[i] = (float)( f * f * ( 3 - 2 * f ) );
+		}
+	}
+
+
+
+typedef struct NoiseTileJob {
+		float *buffer;
+		int width, height;
+		int numTilesWide;
+		
+		int numOctaves;
+		NoiseAxisTable *xTables;
+		NoiseAxisTable *yTables;
+		float *amplitudes;
+		unsigned int *octaveSeeds;
+	} NoiseTileJob;
+
+
+
+// fills outRow[0..inNumX) with lattice row inY interpolated across
+// columns [inStartX, inStartX+inNumX)
+static void interpolateNoiseRow( NoiseAxisTable *inXTable, int inStartX,
+	int inNumX, int inY, unsigned int inOctaveSeed, float *outRow ) {
+	
+	int *cells = &( inXTable->cells[ inStartX ] );
+	float *weights = &( inXTable->weights[ inStartX ] );
+	
+	int firstCell = cells[0];
+	int numCells = cells[ inNumX - 1 ] - firstCell + 2;
+	
+	// cells are at least a pixel wide, so a tile row spans at most
+	// NOISE_TILE_SIZE + 1 of them
+	float values[ NOISE_TILE_SIZE + 2 ];
+	
+	for( int c=0; c<numCells; c++ ) {
+		values[c] = noiseLatticeValue( firstCell + c, inY, inOctaveSeed );
+		}
+	
+	for( int x=0; x<inNumX; x++ ) {
+		float *v = &( values[ cells[x] - firstCell ] );
+		outRow[x] = v[0] + ( v[1] - v[0] ) * weights[x];
+		}
+	}
+
+
+
+// outRow[x] += inA * inRowA[x] + inB * ( inRowB[x] - inRowA[x] )
+static void accumulateNoiseRow( float *ioRow, float *inRowA, float *inRowB,
+	int inNumX, float inA, float inB ) {
+	
+	int x = 0;
+
+#if defined( NOISE_SSE2 )
+	
+	__m128 a = _mm_set1_ps( inA );
+	__m128 b = _mm_set1_ps( inB );
+	
+	for( ; x + 4 <= inNumX; x += 4 ) {
+		__m128 rowA = _mm_loadu_ps( inRowA + x );
+		__m128 rowB = _mm_loadu_ps( inRowB + x );
+		
+		__m128 sum = _mm_add_ps(
+			_mm_mul_ps( a, rowA ),
+			_mm_mul_ps( b, _mm_sub_ps( rowB, rowA ) ) );
+		
+		_mm_storeu_ps( ioRow + x, _mm_add_ps( _mm_loadu_ps( ioRow + x ), 
+											  sum ) );
+		}
+
+#elif defined( NOISE_NEON )
+	
+	float32x4_t a = vdupq_n_f32( inA );
+	float32x4_t b = vdupq_n_f32( inB );
+	
+	for( ; x + 4 <= inNumX; x += 4 ) {
+		float32x4_t rowA = vld1q_f32( inRowA + x );
+		float32x4_t rowB = vld1q_f32( inRowB + x );
+		
+		float32x4_t sum = vaddq_f32(
+			vmulq_f32( a, rowA ),
+			vmulq_f32( b, vsubq_f32( rowB, rowA ) ) );
+		
+		vst1q_f32( ioRow + x, vaddq_f32( vld1q_f32( ioRow + x ), sum ) );
+		}
+
+#endif
+	
+	for( ; x<inNumX; x++ ) {
+		ioRow[x] += inA * inRowA[x] + inB * ( inRowB[x] - inRowA[x] );
+		}
+	}
+
+
+
+static void fillNoiseTiles( void *inContext, int inStart, int inEnd ) {
+	NoiseTileJob *job = (NoiseTileJob *)inContext;
+	
+	// interpolated lattice rows above and below the current pixel row
+	float rowStore[2][ NOISE_TILE_SIZE ];
+	
+	for( int t=inStart; t<inEnd; t++ ) {
+		int startX = ( t % job->numTilesWide ) * NOISE_TILE_SIZE;
+		int startY = ( t / job->numTilesWide ) * NOISE_TILE_SIZE;
+		
+		int numX = job->width - startX;
+		if( numX > NOISE_TILE_SIZE ) {
+			numX = NOISE_TILE_SIZE;
+			}
+		int numY = job->height - startY;
+		if( numY > NOISE_TILE_SIZE ) {
+			numY = NOISE_TILE_SIZE;
+			}
+		
+		int y;
+		for( y=startY; y<startY + numY; y++ ) {
+			float *row = &( job->buffer[ y * job->width + startX ] );
+			for( int x=0; x<numX; x++ ) {
+				row[x] = 0.5f;
+				}
+			}
+		
+		for( int o=0; o<job->numOctaves; o++ ) {
+			NoiseAxisTable *yTable = &( job->yTables[o] );
+			unsigned int seed = job->octaveSeeds[o];
+			float amplitude = job->amplitudes[o];
+			
+			float *rowA = rowStore[0];
+			float *rowB = rowStore[1];
+			
+			// never a cell we could be on, or the one before it
+			int currentCell = yTable->cells[ startY ] - 2;
+			
+			for( y=startY; y<startY + numY; y++ ) {
+				int cell = yTable->cells[y];
+				
+				if( cell != currentCell ) {
+					if( cell == currentCell + 1 ) {
+						// reuse the row below as the new row above
+						float *temp = rowA;
+						rowA = rowB;
+						rowB = temp;
+						}
+					else {
+						interpolateNoiseRow( &( job->xTables[o] ), startX,
+											 numX, cell, seed, rowA );
+						}
+					interpolateNoiseRow( &( job->xTables[o] ), startX,
+										 numX, cell + 1, seed, rowB );
+					currentCell = cell;
+					}
+				
+				accumulateNoiseRow( 
+					&( job->buffer[ y * job->width + startX ] ),
+					rowA, rowB, numX,
+					amplitude, amplitude * yTable->weights[y] );
+				}
+			}
+		}
+	}
+
+
+
+void genFractalNoise2dTiled( float *outBuffer, int inWidth, int inHeight,
+	double inCellSize, int inNumOctaves, double inPersistence,
+	unsigned int inSeed, ThreadPool *inPool ) {
+	
+	if( inWidth <= 0 || inHeight <= 0 ) {
+		return;
+		}
+	
+	int numOctaves = 0;
+	double cellSize = inCellSize;
+	while( numOctaves < inNumOctaves && cellSize >= 1.0 ) {
+		numOctaves++;
+		cellSize *= 0.5;
+		}
+	
+	NoiseTileJob job;
+	job.buffer = outBuffer;
+	job.width = inWidth;
+	job.height = inHeight;
+	job.numTilesWide = ( inWidth + NOISE_TILE_SIZE - 1 ) / NOISE_TILE_SIZE;
+	job.numOctaves = numOctaves;
+	job.xTables = new NoiseAxisTable[ numOctaves ];
+	job.yTables = new NoiseAxisTable[ numOctaves ];
+	job.amplitudes = new float[ numOctaves ];
+	job.octaveSeeds = new unsigned int[ numOctaves ];
+	
+	double amplitudeSum = 0;
+	double amplitude = 1;
+	cellSize = inCellSize;
+	
+	int o;
+	for( o=0; o<numOctaves; o++ ) {
+		fillNoiseAxisTable( &( job.xTables[o] ), inWidth, cellSize );
+		fillNoiseAxisTable( &( job.yTables[o] ), inHeight, cellSize );
+		
+		job.amplitudes[o] = (float)amplitude;
+		job.octaveSeeds[o] = noiseMix( inSeed + o * 0x9e3779b9U );
+		
+		amplitudeSum += amplitude;
+		amplitude *= inPersistence;
+		cellSize *= 0.5;
+		}
+	
+	// scale so the sum of octaves stays in [-0.5,0.5]
+	for( o=0; o<numOctaves; o++ ) {
+		job.amplitudes[o] = (float)( 0.5 * job.amplitudes[o] / amplitudeSum );
+		}
+	
+	
+	ThreadPool *pool = inPool;
+	if( pool == NULL ) {
+		pool = ThreadPool::getSharedPool();
+		}
+	
+	int numTilesHigh = ( inHeight + NOISE_TILE_SIZE - 1 ) / NOISE_TILE_SIZE;
+	
+	pool->parallelFor( fillNoiseTiles, &job, 
+					   job.numTilesWide * numTilesHigh );
+	
+	
+	for( o=0; o<numOctaves; o++ ) {
+		delete [] job.xTables[o].cells;
+		delete [] job.xTables[o].weights;
+		delete [] job.yTables[o].cells;
+		delete [] job.yTables[o].weights;
+		}
+	delete [] job.xTables;
+	delete [] job.yTables;
+	delete [] job.amplitudes;
+	delete [] job.octaveSeeds;
+	}
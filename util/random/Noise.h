@@ -10,6 +10,7 @@
 *	Mods:
 *		Jason Rohrer	12-20-2000	Added a fractal noise function
 *									that fills a double array.
+*		Jason Rohrer	10-15-2026	Added genFractalNoise2dTiled.
 *
 */
 
@@ -27,6 +28,9 @@
 #include "RandomSource.h"
 
 
+class ThreadPool;
+
+
 
 
 // fills 2d image with RGBA noise
@@ -86,4 +90,35 @@ void genFractalNoise2d( double *inBuffer, int inWidth, int inMaxFrequency,
 void genFractalNoise( double *inBuffer, int inWidth, int inMaxFrequency,
 	double inFPower, char inInterpolate, RandomSource *inRandSource );
 
+
+/**
+ * Fills a 2d array with fractal value noise, smoothly interpolated
+ * between random values on a lattice, summed over octaves that each
+ * halve the lattice cell size.
+ *
+ * The array is split into tiles that are filled in parallel, each with
+ * all octaves in one pass.  Lattice values are hashed from the seed and
+ * lattice position, so the result depends only on the parameters, not
+ * on how many threads fill it.
+ *
+ * Needs ThreadPool.cpp.
+ *
+ * @param outBuffer a pre-allocated buffer of inWidth * inHeight values
+ *   to fill, row by row.  Values are in [0,1], with a mean of 0.5.
+ * @param inWidth the width of the 2d array.  Need not be a power of 2.
+ * @param inHeight the height of the 2d array.
+ * @param inCellSize the lattice cell size of the first octave, in
+ *   pixels.
+ * @param inNumOctaves the number of octaves to sum.  Octaves with cells
+ *   smaller than a pixel are skipped.
+ * @param inPersistence the amplitude of each octave relative to the
+ *   previous one.  0.5 gives 1/f noise.
+ * @param inSeed the seed.
+ * @param inPool the pool to fill tiles with, or NULL to use
+ *   ThreadPool::getSharedPool().  Defaults to NULL.
+ */
+void genFractalNoise2dTiled( float *outBuffer, int inWidth, int inHeight,
+	double inCellSize, int inNumOctaves, double inPersistence,
+	unsigned int inSeed, ThreadPool *inPool = NULL );
+
 #endif
@@ -0,0 +1,364 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+
+
+#ifndef PHILOX_RANDOM_SOURCE_INCLUDED
+#define PHILOX_RANDOM_SOURCE_INCLUDED
+
+#include "RandomSource32.h"
+
+#include "minorGems/system/Time.h"
+
+#include <math.h>
+#include <limits.h>
+#include <stdint.h>
+
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || \
+    ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+    #define PHILOX_RANDOM_SOURCE_SSE2
+    #include <emmintrin.h>
+#elif defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+    #define PHILOX_RANDOM_SOURCE_NEON
+    #include <arm_neon.h>
+#endif
+
+
+
+/**
+ * Implementation of RandomSource based on the Philox4x32-10
+ * counter-based generator from Salmon et al., "Parallel Random Numbers:
+ * As Easy as 1, 2, 3":
+ *
+ * http://www.thesalmons.org/john/random123/
+ *
+ * Value i of a stream is a pure function of (seed, stream, i), so
+ * generators can jump to any position, and threads that each use their
+ * own stream number with a shared seed get independent, reproducible
+ * sequences no matter how work is split between them.
+ *
+ * fillRand32 computes four blocks of four values at once with SSE2 or
+ * NEON, when available.
+ */
+class PhiloxRandomSource : public RandomSource32 {
+
+    public:
+
+        // seeds itself with current time, using stream 0
+        PhiloxRandomSource();
+
+        // specify the seed and, optionally, the stream
+        PhiloxRandomSource( unsigned int inSeed, unsigned int inStream = 0 );
+
+
+        // keeps the stream and goes back to the start of it
+        void reseed( unsigned int inSeed );
+
+
+        // switches to another stream, going back to the start of it
+        void setStream( unsigned int inStream );
+
+
+        // number of values drawn from the current stream so far
+        uint64_t getPosition();
+
+        // skips forward or back, so the next value drawn is value
+        // inPosition of the stream
+        void setPosition( uint64_t inPosition );
+
+
+        // overrides the default implementation
+        virtual void fillRand32( unsigned int *outValues, int inNumValues );
+
+
+
+    protected:
+
+
+        uint32_t mKey[2];
+
+        // index of the next block of four values to compute
+        uint64_t mBlock;
+
+        // values left over from the last block, from mBufferIndex up
+        uint32_t mBuffer[4];
+        int mBufferIndex;
+
+
+        // computes block inBlock into outValues
+        void computeBlock( uint64_t inBlock, uint32_t *outValues );
+
+
+        // implements this core function
+        // returns next number and updates state
+        virtual unsigned int genRand32();
+
+    };
+
+
+
+#define PHILOX_M0 0xD2511F53U
+#define PHILOX_M1 0xCD9E8D57U
+#define PHILOX_W0 0x9E3779B9U
+#define PHILOX_W1 0xBB67AE85U
+
+#define PHILOX_ROUNDS 10
+
+
+
+
+inline PhiloxRandomSource::PhiloxRandomSource() {
+    mKey[1] = 0;
+    reseed( (unsigned int)fmod( Time::timeSec(), UINT_MAX ) );
+    }
+
+
+
+inline PhiloxRandomSource::PhiloxRandomSource( unsigned int inSeed,
+                                               unsigned int inStream ) {
+    mKey[1] = inStream;
+    reseed( inSeed );
+    }
+
+
+
+inline void PhiloxRandomSource::reseed( unsigned int inSeed ) {
+    mKey[0] = inSeed;
+    setPosition( 0 );
+    }
+
+
+
+inline void PhiloxRandomSource::setStream( unsigned int inStream ) {
+    mKey[1] = inStream;
+    setPosition( 0 );
+    }
+
+
+
+inline uint64_t PhiloxRandomSource::getPosition() {
+    // mBlock is one past the buffered block
+    return mBlock * 4 - (uint64_t)( 4 - mBufferIndex );
+    }
+
+
+
+inline void PhiloxRandomSource::setPosition( uint64_t inPosition ) {
+    mBlock = inPosition / 4;
+    mBufferIndex = 4;
+
+    int skip = (int)( inPosition % 4 );
+
+    if( skip > 0 ) {
+        computeBlock( mBlock, mBuffer );
+        mBlock++;
+        mBufferIndex = skip;
+        }
+    }
+
+
+
+inline void PhiloxRandomSource::computeBlock( uint64_t inBlock,
+                                              uint32_t *outValues ) {
+    uint32_t c0 = (uint32_t)inBlock;
+    uint32_t c1 = (uint32_t)( inBlock >> 32 );
+    uint32_t c2 = 0;
+    uint32_t c3 = 0;
+
+    uint32_t k0 = mKey[0];
+    uint32_t k1 = mKey[1];
+
+    for( int r=0; r<PHILOX_ROUNDS; r++ ) {
+        uint64_t p0 = (uint64_t)PHILOX_M0 * c0;
+        uint64_t p1 = (uint64_t)PHILOX_M1 * c2;
+
+        uint32_t hi0 = (uint32_t)( p0 >> 32 );
+        uint32_t lo0 = (uint32_t)p0;
+        uint32_t hi1 = (uint32_t)( p1 >> 32 );
+        uint32_t lo1 = (uint32_t)p1;
+
+        c0 = hi1 ^ c1 ^ k0;
+        c1 = lo1;
+        c2 = hi0 ^ c3 ^ k1;
+        c3 = lo0;
+
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+        }
+
+    outValues[0] = c0;
+    outValues[1] = c1;
+    outValues[2] = c2;
+    outValues[3] = c3;
+    }
+
+
+
+inline unsigned int PhiloxRandomSource::genRand32() {
+    if( mBufferIndex == 4 ) {
+        computeBlock( mBlock, mBuffer );
+        mBlock++;
+        mBufferIndex = 0;
+        }
+
+    return mBuffer[ mBufferIndex++ ];
+    }
+
+
+
+#if defined( PHILOX_RANDOM_SOURCE_SSE2 )
+
+// low and high 32 bits of each lane of inA times a constant,
+// four lanes at once
+inline void philoxMulHiLo4( __m128i inA, __m128i inM,
+                            __m128i *outHi, __m128i *outLo ) {
+    // products of lanes 0, 2 and of lanes 1, 3, as 64-bit values
+    __m128i p02 = _mm_mul_epu32( inA, inM );
+    __m128i p13 = _mm_mul_epu32( _mm_srli_epi64( inA, 32 ), inM );
+
+    *outLo = _mm_unpacklo_epi32(
+        _mm_shuffle_epi32( p02, _MM_SHUFFLE( 0, 0, 2, 0 ) ),
+        _mm_shuffle_epi32( p13, _MM_SHUFFLE( 0, 0, 2, 0 ) ) );
+
+    *outHi = _mm_unpacklo_epi32(
+        _mm_shuffle_epi32( p02, _MM_SHUFFLE( 0, 0, 3, 1 ) ),
+        _mm_shuffle_epi32( p13, _MM_SHUFFLE( 0, 0, 3, 1 ) ) );
+    }
+
+#endif
+
+
+
+inline void PhiloxRandomSource::fillRand32( unsigned int *outValues,
+                                            int inNumValues ) {
+    int i = 0;
+
+    // use up values left over from genRand32 or a previous fill
+    while( mBufferIndex < 4 && i < inNumValues ) {
+        outValues[ i++ ] = mBuffer[ mBufferIndex++ ];
+        }
+
+
+#if defined( PHILOX_RANDOM_SOURCE_SSE2 ) || \
+    defined( PHILOX_RANDOM_SOURCE_NEON )
+
+    // four blocks at a time, one block per lane, each counter word in
+    // its own vector
+    for( ; i + 16 <= inNumValues; i += 16 ) {
+        uint32_t lowCounters[4], highCounters[4];
+
+        for( int b=0; b<4; b++ ) {
+            lowCounters[b] = (uint32_t)( mBlock + b );
+            highCounters[b] = (uint32_t)( ( mBlock + b ) >> 32 );
+            }
+        mBlock += 4;
+
+        uint32_t k0 = mKey[0];
+        uint32_t k1 = mKey[1];
+
+    #if defined( PHILOX_RANDOM_SOURCE_SSE2 )
+
+        __m128i m0 = _mm_set1_epi32( (int)PHILOX_M0 );
+        __m128i m1 = _mm_set1_epi32( (int)PHILOX_M1 );
+
+        __m128i c0 = _mm_loadu_si128( (__m128i *)lowCounters );
+        __m128i c1 = _mm_loadu_si128( (__m128i *)highCounters );
+        __m128i c2 = _mm_setzero_si128();
+        __m128i c3 = _mm_setzero_si128();
+
+        for( int r=0; r<PHILOX_ROUNDS; r++ ) {
+            __m128i hi0, lo0, hi1, lo1;
+            philoxMulHiLo4( c0, m0, &hi0, &lo0 );
+            philoxMulHiLo4( c2, m1, &hi1, &lo1 );
+
+            c0 = _mm_xor_si128( _mm_xor_si128( hi1, c1 ),
+                                _mm_set1_epi32( (int)k0 ) );
+            c1 = lo1;
+            c2 = _mm_xor_si128( _mm_xor_si128( hi0, c3 ),
+                                _mm_set1_epi32( (int)k1 ) );
+            c3 = lo0;
+
+            k0 += PHILOX_W0;
+            k1 += PHILOX_W1;
+            }
+
+        // transpose so each block's four values are together
+        __m128i t0 = _mm_unpacklo_epi32( c0, c1 );
+        __m128i t1 = _mm_unpacklo_epi32( c2, c3 );
+        __m128i t2 = _mm_unpackhi_epi32( c0, c1 );
+        __m128i t3 = _mm_unpackhi_epi32( c2, c3 );
+
+        __m128i *out = (__m128i *)&( outValues[i] );
+        _mm_storeu_si128( out, _mm_unpacklo_epi64( t0, t1 ) );
+        _mm_storeu_si128( out + 1, _mm_unpackhi_epi64( t0, t1 ) );
+        _mm_storeu_si128( out + 2, _mm_unpacklo_epi64( t2, t3 ) );
+        _mm_storeu_si128( out + 3, _mm_unpackhi_epi64( t2, t3 ) );
+
+    #else
+
+        uint32x2_t m0 = vdup_n_u32( PHILOX_M0 );
+        uint32x2_t m1 = vdup_n_u32( PHILOX_M1 );
+
+        uint32x4_t c0 = vld1q_u32( lowCounters );
+        uint32x4_t c1 = vld1q_u32( highCounters );
+        uint32x4_t c2 = vdupq_n_u32( 0 );
+        uint32x4_t c3 = vdupq_n_u32( 0 );
+
+        for( int r=0; r<PHILOX_ROUNDS; r++ ) {
+            uint64x2_t p0Low = vmull_u32( vget_low_u32( c0 ), m0 );
+            uint64x2_t p0High = vmull_u32( vget_high_u32( c0 ), m0 );
+            uint64x2_t p1Low = vmull_u32( vget_low_u32( c2 ), m1 );
+            uint64x2_t p1High = vmull_u32( vget_high_u32( c2 ), m1 );
+
+            uint32x4_t hi0 = vcombine_u32( vshrn_n_u64( p0Low, 32 ),
+                                           vshrn_n_u64( p0High, 32 ) );
+            uint32x4_t lo0 = vcombine_u32( vmovn_u64( p0Low ),
+                                           vmovn_u64( p0High ) );
+            uint32x4_t hi1 = vcombine_u32( vshrn_n_u64( p1Low, 32 ),
+                                           vshrn_n_u64( p1High, 32 ) );
+            uint32x4_t lo1 = vcombine_u32( vmovn_u64( p1Low ),
+                                           vmovn_u64( p1High ) );
+
+            c0 = veorq_u32( veorq_u32( hi1, c1 ), vdupq_n_u32( k0 ) );
+            c1 = lo1;
+            c2 = veorq_u32( veorq_u32( hi0, c3 ), vdupq_n_u32( k1 ) );
+            c3 = lo0;
+
+            k0 += PHILOX_W0;
+            k1 += PHILOX_W1;
+            }
+
+        // interleaving store puts each block's four values together
+        uint32x4x4_t blocks;
+        blocks.val[0] = c0;
+        blocks.val[1] = c1;
+        blocks.val[2] = c2;
+        blocks.val[3] = c3;
+
+        vst4q_u32( (uint32_t *)&( outValues[i] ), blocks );
+
+    #endif
+        }
+
+#endif
+
+
+    for( ; i + 4 <= inNumValues; i += 4 ) {
+        computeBlock( mBlock, (uint32_t *)&( outValues[i] ) );
+        mBlock++;
+        }
+
+    // leave the rest of a partial block for next time
+    while( i < inNumValues ) {
+        outValues[ i++ ] = genRand32();
+        }
+    }
+
+
+
+#endif
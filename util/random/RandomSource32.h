@@ -3,6 +3,9 @@
  *
  * 2014-June-6    Jason Rohrer
  * Created.
+ *
+ * 2026-October-15   Jason Rohrer
+ * Added fillRand32 and fillRandDouble for drawing many values at once.
  */
 
 
@@ -38,6 +41,33 @@ class RandomSource32 : public RandomSource {
                                        double inRangeEnd );
         char getRandomBoolean();
 
+
+
+        /**
+         * Fills an array with the next values of getRandomInt(),
+         * with one virtual call instead of one per value.
+         *
+         * Draws the same values, in the same order, as calling
+         * getRandomInt() inNumValues times.
+         *
+         * @param outValues the array to fill.  Must be destroyed by caller.
+         * @param inNumValues the number of values to draw.
+         */
+        virtual void fillRand32( unsigned int *outValues, int inNumValues );
+
+
+
+        /**
+         * Fills an array with the next values of getRandomDouble().
+         *
+         * Draws the same values, in the same order, as calling
+         * getRandomDouble() inNumValues times.
+         *
+         * @param outValues the array to fill.  Must be destroyed by caller.
+         * @param inNumValues the number of values to draw.
+         */
+        void fillRandDouble( double *outValues, int inNumValues );
+
         
     protected:
         double mInvMAXPlusOne; //  1 / ( MAX + 1 )
@@ -52,6 +82,11 @@ class RandomSource32 : public RandomSource {
 
 
 
+// values drawn per fillRand32 call in fillRandDouble
+#define RANDOM_SOURCE_32_FILL_CHUNK 256
+
+
+
 inline RandomSource32::RandomSource32() {
     MAX = 4294967295U;
     invMAX = (float)1.0 / ((float)MAX);
@@ -132,4 +167,39 @@ inline char RandomSource32::getRandomBoolean() {
     }
 
 
+
+// subclasses override this with a loop that calls their own genRand32
+// directly, so it can be inlined
+inline void RandomSource32::fillRand32( unsigned int *outValues,
+                                        int inNumValues ) {
+    for( int i=0; i<inNumValues; i++ ) {
+        outValues[i] = genRand32();
+        }
+    }
+
+
+
+inline void RandomSource32::fillRandDouble( double *outValues,
+                                            int inNumValues ) {
+    unsigned int chunk[ RANDOM_SOURCE_32_FILL_CHUNK ];
+    
+    for( int start=0; start<inNumValues; 
+         start += RANDOM_SOURCE_32_FILL_CHUNK ) {
+        
+        int n = inNumValues - start;
+        if( n > RANDOM_SOURCE_32_FILL_CHUNK ) {
+            n = RANDOM_SOURCE_32_FILL_CHUNK;
+            }
+        
+        fillRand32( chunk, n );
+        
+        double *out = &( outValues[ start ] );
+        for( int i=0; i<n; i++ ) {
+            // as in getRandomDouble
+            out[i] = (double)( chunk[i] ) * invDMAX;
+            }
+        }
+    }
+
+
 #endif
@@ -225,12 +225,14 @@ void testRandom( RandomSource *inSource ) {
 #include "CustomRandomSource.h"
 #include "StdRandomSource.h"
 #include "JenkinsRandomSource.h"
+#include "PhiloxRandomSource.h"
 
 int main() {
     
     JenkinsRandomSource randSource( 11234258 );
     //CustomRandomSource randSource( 11234258 );
     //StdRandomSource randSource( 11 );
+    //PhiloxRandomSource randSource( 11234258 );
     
     testRandom( &randSource );
     
@@ -1,4 +1,32 @@
 
 g++ -o infiniteLoop infiniteLoop.cpp
 
-g++ -o timedTest timedTest.cpp
\ No newline at end of file
+g++ -o timedTest timedTest.cpp
+
+# stress and soak test (Linux sources; see stressTest.cpp for usage)
+MG=../..
+
+g++ -O2 -I${MG}/.. -o stressTest stressTest.cpp \
+  ${MG}/system/linux/ThreadLinux.cpp ${MG}/system/linux/MutexLockLinux.cpp \
+  ${MG}/system/linux/BinarySemaphoreLinux.cpp \
+  ${MG}/system/StopSignalThread.cpp ${MG}/system/unix/TimeUnix.cpp \
+  ${MG}/network/linux/SocketPollLinux.cpp ${MG}/network/linux/SocketLinux.cpp \
+  ${MG}/network/linux/SocketClientLinux.cpp \
+  ${MG}/network/linux/SocketServerLinux.cpp \
+  ${MG}/network/linux/HostAddressLinux.cpp \
+  ${MG}/network/NetworkFunctionLocks.cpp ${MG}/network/HostLookupPool.cpp \
+  ${MG}/network/LookupThread.cpp ${MG}/network/web/WebRequest.cpp \
+  ${MG}/network/web/server/WebServer.cpp \
+  ${MG}/network/web/server/RequestHandlingThread.cpp \
+  ${MG}/network/web/server/ThreadHandlingThread.cpp \
+  ${MG}/network/web/server/ConnectionPermissionHandler.cpp \
+  ${MG}/network/web/server/PageCache.cpp \
+  ${MG}/network/web/server/ResponseStream.cpp \
+  ${MG}/util/log/AsyncFileLog.cpp ${MG}/util/log/FileLog.cpp \
+  ${MG}/util/log/PrintLog.cpp ${MG}/util/log/Log.cpp ${MG}/util/log/AppLog.cpp \
+  ${MG}/util/SettingsManager.cpp ${MG}/util/Metrics.cpp \
+  ${MG}/util/stringUtils.cpp ${MG}/util/StringBufferOutputStream.cpp \
+  ${MG}/util/printUtils.cpp ${MG}/io/file/linux/PathLinux.cpp \
+  ${MG}/crypto/hashes/sha1.cpp ${MG}/formats/encodingUtils.cpp \
+  ${MG}/formats/ZipStream.cpp \
+  -lpthread
@@ -6,6 +6,13 @@ echo
 time ./timedTest 12323230500
 
 
+echo
+echo "Running stress test for one minute:"
+echo
+
+./stressTest -seconds 60
+
+
 echo
 echo "Running infinite loop:"
 echo
@@ -0,0 +1,1290 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+/**
+ * Concurrency stress and soak test for the threading, networking, and
+ * logging layers.  Hammers them from many threads, for minutes or hours,
+ * reporting throughput and latency percentiles as it goes, and watching
+ * for threads that stop making progress.
+ *
+ * Tests:
+ *   mutex      threads increment a shared counter under one MutexLock,
+ *              checked against their own counts at the end
+ *   semaphore  pairs of threads ping-pong through two Semaphores
+ *   poll       threads send a byte over their own socketpair to one
+ *              SocketPoll thread, which echoes it back
+ *   web        a WebServer on localhost (settings kept in
+ *              stressTestSettings), and one thread stepping many
+ *              WebRequests against it at once (WebRequest's idle
+ *              connection pool isn't thread-safe, so requests are
+ *              stepped from one thread, like the game does)
+ *   log        threads log through one AsyncFileLog, in bursts
+ *
+ * Each report line gives, for the interval since the last report,
+ * operations per second and latency percentiles in microseconds.
+ * Latencies are binned (8 bins per doubling), so percentiles are the
+ * upper edge of their bin, within 12%.
+ *
+ * Each worker thread stamps the time of its last finished (or failed)
+ * operation.  A worker whose stamp is older than the stall time is
+ * reported as stalled (and again when it recovers).  If every worker of a test is
+ * stalled, the test is assumed deadlocked:  the stalled workers are
+ * listed and the process exits with status 2, without trying to join
+ * them.  Exit status is 1 if any errors or check failures were seen.
+ *
+ * Ctrl-C ends the run early, with the summary.
+ *
+ * Unix-like platforms only (uses socketpair).
+ *
+ * Usage:  stressTest [options] [test ...]
+ *   Runs all tests if none are named.
+ *   -seconds N         run length (default 60)
+ *   -threads N         worker threads per test, or requests in flight
+ *                      for the web test (default 4)
+ *   -report N          seconds between reports (default 10)
+ *   -stall N           seconds without progress before a worker is
+ *                      reported as stalled (default 10)
+ *   -port N            port for the web test (default 18123)
+ *   -serverThreads N   WebServer worker threads, or 0 for a thread per
+ *                      connection (default 4)
+ *   -logBurst N        messages each log thread writes per millisecond
+ *                      (default 10)
+ *
+ * For example, a two-hour soak:
+ *   stressTest -seconds 7200 -threads 16 -report 60
+ *
+ * Compile with makeTests.sh.
+ */
+
+
+#include "minorGems/system/Thread.h"
+#include "minorGems/system/MutexLock.h"
+#include "minorGems/system/Semaphore.h"
+#include "minorGems/system/Time.h"
+#include "minorGems/system/atomicOps.h"
+
+#include "minorGems/network/SocketPoll.h"
+#include "minorGems/network/web/WebRequest.h"
+#include "minorGems/network/web/server/WebServer.h"
+#include "minorGems/network/web/server/PageGenerator.h"
+
+#include "minorGems/util/log/AsyncFileLog.h"
+#include "minorGems/util/SimpleVector.h"
+#include "minorGems/util/stringUtils.h"
+#include "minorGems/util/SettingsManager.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+
+
+
+// latency bins:  exact below 16 ns, then 8 per doubling
+#define NUM_LATENCY_BINS 488
+
+
+static int getLatencyBin( int64_t inNS ) {
+    if( inNS < 16 ) {
+        if( inNS < 0 ) {
+            return 0;
+            }
+        return (int)inNS;
+        }
+
+    int highBit = 63 - __builtin_clzll( (unsigned long long)inNS );
+    int sub = (int)( ( inNS >> ( highBit - 3 ) ) & 7 );
+
+    return 16 + ( highBit - 4 ) * 8 + sub;
+    }
+
+
+// lowest latency that lands in a bin
+static int64_t getLatencyBinStart( int inBin ) {
+    if( inBin < 16 ) {
+        return inBin;
+        }
+
+    int highBit = ( inBin - 16 ) / 8 + 4;
+    int sub = ( inBin - 16 ) % 8;
+
+    return (int64_t)( 8 + sub ) << ( highBit - 3 );
+    }
+
+
+
+// set from the SIGINT handler
+static volatile sig_atomic_t interrupted = 0;
+
+static void handleInterrupt( int inSignal ) {
+    interrupted = 1;
+    }
+
+
+
+/**
+ * A thread that does timed operations until stopped.
+ */
+class StressWorker : public Thread {
+
+    public:
+
+        StressWorker()
+            : mNumErrors( 0 ), mLastProgressNS( 0 ),
+              mStopping( 0 ), mStalled( false ) {
+
+            for( int i=0; i<NUM_LATENCY_BINS; i++ ) {
+                mBinCounts[i] = 0;
+                }
+            mLastProgressNS = Time::getMonotonicNanoseconds();
+            }
+
+
+        // asks run to return after the current operation
+        void requestStop() {
+            atomicStore( &mStopping, 1 );
+            }
+
+
+        virtual void run() {
+            atomicStore64( &mLastProgressNS,
+                           Time::getMonotonicNanoseconds() );
+
+            while( ! atomicLoad( &mStopping ) ) {
+                doWork();
+                }
+            }
+
+
+        // the rest are read by the reporting thread
+
+        // one count per latency bin, written only by this thread
+        volatile int64_t mBinCounts[ NUM_LATENCY_BINS ];
+
+        volatile int64_t mNumErrors;
+
+        // keep the progress stamp, written after every operation, off
+        // the lines other threads read and write
+        char mPadA[ ATOMIC_CACHE_LINE_SIZE ];
+        volatile int64_t mLastProgressNS;
+        char mPadB[ ATOMIC_CACHE_LINE_SIZE ];
+
+        volatile int mStopping;
+
+        // watchdog's state, touched only by the reporting thread
+        char mStalled;
+
+
+    protected:
+
+        // does one or more operations, calling recordOperation or
+        // recordError for each
+        virtual void doWork() = 0;
+
+
+        // only called by this thread
+        void recordOperation( int64_t inStartNS ) {
+            int64_t now = Time::getMonotonicNanoseconds();
+
+            volatile int64_t *count =
+                &( mBinCounts[ getLatencyBin( now - inStartNS ) ] );
+
+            // only this thread writes, so no need for an atomic add
+            atomicStore64( count, atomicLoad64( count ) + 1 );
+
+            atomicStore64( &mLastProgressNS, now );
+            }
+
+
+        // a failed operation still shows this thread isn't stuck
+        void recordError() {
+            atomicStore64( &mNumErrors, atomicLoad64( &mNumErrors ) + 1 );
+
+            atomicStore64( &mLastProgressNS,
+                           Time::getMonotonicNanoseconds() );
+            }
+
+    };
+
+
+
+/**
+ * A set of workers exercising one component.
+ */
+class StressTest {
+
+    public:
+
+        StressTest( const char *inName )
+            : mName( inName ), mNumBadChecks( 0 ) {
+
+            for( int i=0; i<NUM_LATENCY_BINS; i++ ) {
+                mLastBinCounts[i] = 0;
+                }
+            mLastNumErrors = 0;
+            }
+
+
+        virtual ~StressTest() {
+            for( int i=0; i<mWorkers.size(); i++ ) {
+                delete mWorkers.getElementDirect( i );
+                }
+            }
+
+
+        virtual void start() {
+            for( int i=0; i<mWorkers.size(); i++ ) {
+                mWorkers.getElementDirect( i )->start();
+                }
+            }
+
+
+        // asks workers to stop after their current operations
+        void requestStop() {
+            for( int i=0; i<mWorkers.size(); i++ ) {
+                mWorkers.getElementDirect( i )->requestStop();
+                }
+            }
+
+
+        // stops and joins workers, then anything they depend on
+        virtual void stop() {
+            requestStop();
+
+            for( int i=0; i<mWorkers.size(); i++ ) {
+                mWorkers.getElementDirect( i )->join();
+                }
+            }
+
+
+        // checks results after stop, adding to mNumBadChecks
+        virtual void check() {
+            }
+
+
+        // adds up the workers' current latency bins and error counts
+        void getTotals( int64_t *outBinCounts, int64_t *outNumErrors ) {
+            for( int b=0; b<NUM_LATENCY_BINS; b++ ) {
+                outBinCounts[b] = 0;
+                }
+            *outNumErrors = 0;
+
+            for( int i=0; i<mWorkers.size(); i++ ) {
+                StressWorker *w = mWorkers.getElementDirect( i );
+
+                for( int b=0; b<NUM_LATENCY_BINS; b++ ) {
+                    outBinCounts[b] +=
+                        atomicLoad64( &( w->mBinCounts[b] ) );
+                    }
+                *outNumErrors += atomicLoad64( &( w->mNumErrors ) );
+                }
+            }
+
+
+        const char *mName;
+
+        SimpleVector<StressWorker*> mWorkers;
+
+        // totals at last report
+        int64_t mLastBinCounts[ NUM_LATENCY_BINS ];
+        int64_t mLastNumErrors;
+
+        int mNumBadChecks;
+
+    };
+
+
+
+// mutex
+
+class MutexWorker : public StressWorker {
+
+    public:
+
+        MutexWorker( MutexLock *inLock, int64_t *inSharedCount )
+            : mOwnCount( 0 ),
+              mLock( inLock ), mSharedCount( inSharedCount ) {
+            }
+
+
+        int64_t mOwnCount;
+
+
+    protected:
+
+        MutexLock *mLock;
+        int64_t *mSharedCount;
+
+
+        virtual void doWork() {
+            int64_t startNS = Time::getMonotonicNanoseconds();
+
+            mLock->lock();
+            // a read and a write apart, so lost exclusion shows up
+            // as a lost increment
+            int64_t count = *mSharedCount;
+            *mSharedCount = count + 1;
+            mLock->unlock();
+
+            mOwnCount++;
+
+            recordOperation( startNS );
+            }
+
+    };
+
+
+
+class MutexTest : public StressTest {
+
+    public:
+
+        MutexTest( int inNumThreads )
+            : StressTest( "mutex" ), mSharedCount( 0 ) {
+
+            for( int i=0; i<inNumThreads; i++ ) {
+                mWorkers.push_back(
+                    new MutexWorker( &mLock, &mSharedCount ) );
+                }
+            }
+
+
+        virtual void check() {
+            int64_t total = 0;
+
+            for( int i=0; i<mWorkers.size(); i++ ) {
+                total += ( (MutexWorker*)mWorkers.getElementDirect( i ) )->
+                    mOwnCount;
+                }
+
+            if( total != mSharedCount ) {
+                printf( "mutex:  shared count %lld, but threads counted "
+                        "%lld\n",
+                        (long long)mSharedCount, (long long)total );
+                mNumBadChecks++;
+                }
+            }
+
+
+    protected:
+
+        MutexLock mLock;
+        int64_t mSharedCount;
+
+    };
+
+
+
+// semaphore
+
+class SemaphoreWorker : public StressWorker {
+
+    public:
+
+        SemaphoreWorker( Semaphore *inPing, Semaphore *inPong )
+            : mPing( inPing ), mPong( inPong ),
+              mWaiting( false ), mStartNS( 0 ) {
+            }
+
+
+    protected:
+
+        Semaphore *mPing;
+        Semaphore *mPong;
+
+        char mWaiting;
+        int64_t mStartNS;
+
+
+        virtual void doWork() {
+            if( ! mWaiting ) {
+                mStartNS = Time::getMonotonicNanoseconds();
+                mPing->signal();
+                mWaiting = true;
+                }
+
+            // time out now and then, to notice stop requests
+            if( mPong->wait( 100 ) ) {
+                mWaiting = false;
+                recordOperation( mStartNS );
+                }
+            }
+
+    };
+
+
+
+// answers a SemaphoreWorker
+class SemaphoreEchoThread : public Thread {
+
+    public:
+
+        SemaphoreEchoThread( Semaphore *inPing, Semaphore *inPong )
+            : mStopping( 0 ), mPing( inPing ), mPong( inPong ) {
+            }
+
+
+        virtual void run() {
+            while( ! atomicLoad( &mStopping ) ) {
+                if( mPing->wait( 100 ) ) {
+                    mPong->signal();
+                    }
+                }
+            }
+
+
+        volatile int mStopping;
+
+
+    protected:
+
+        Semaphore *mPing;
+        Semaphore *mPong;
+
+    };
+
+
+
+class SemaphoreTest : public StressTest {
+
+    public:
+
+        SemaphoreTest( int inNumThreads )
+            : StressTest( "semaphore" ) {
+
+            for( int i=0; i<inNumThreads; i++ ) {
+                Semaphore *ping = new Semaphore();
+                Semaphore *pong = new Semaphore();
+
+                mSemaphores.push_back( ping );
+                mSemaphores.push_back( pong );
+
+                mWorkers.push_back( new SemaphoreWorker( ping, pong ) );
+                mEchoThreads.push_back(
+                    new SemaphoreEchoThread( ping, pong ) );
+                }
+            }
+
+
+        virtual ~SemaphoreTest() {
+            for( int i=0; i<mEchoThreads.size(); i++ ) {
+                delete mEchoThreads.getElementDirect( i );
+                }
+            for( int i=0; i<mSemaphores.size(); i++ ) {
+                delete mSemaphores.getElementDirect( i );
+                }
+            }
+
+
+        virtual void start() {
+            for( int i=0; i<mEchoThreads.size(); i++ ) {
+                mEchoThreads.getElementDirect( i )->start();
+                }
+            StressTest::start();
+            }
+
+
+        virtual void stop() {
+            StressTest::stop();
+
+            for( int i=0; i<mEchoThreads.size(); i++ ) {
+                atomicStore( &( mEchoThreads.getElementDirect( i )->
+                                mStopping ), 1 );
+                }
+            for( int i=0; i<mEchoThreads.size(); i++ ) {
+                mEchoThreads.getElementDirect( i )->join();
+                }
+            }
+
+
+    protected:
+
+        SimpleVector<SemaphoreEchoThread*> mEchoThreads;
+        SimpleVector<Semaphore*> mSemaphores;
+
+    };
+
+
+
+// poll
+
+class PollWorker : public StressWorker {
+
+    public:
+
+        // inSocket is this worker's end of a socketpair
+        PollWorker( int inSocket )
+            : mSocket( inSocket ), mNextByte( 0 ) {
+            }
+
+
+    protected:
+
+        int mSocket;
+        unsigned char mNextByte;
+
+
+        virtual void doWork() {
+            int64_t startNS = Time::getMonotonicNanoseconds();
+
+            unsigned char byte = mNextByte;
+            mNextByte++;
+
+            if( write( mSocket, &byte, 1 ) != 1 ) {
+                recordError();
+                Thread::staticSleep( 100 );
+                return;
+                }
+
+            // blocks forever if the poll thread misses our byte,
+            // which the watchdog reports
+            unsigned char echo;
+            if( read( mSocket, &echo, 1 ) != 1 || echo != byte ) {
+                recordError();
+                return;
+                }
+
+            recordOperation( startNS );
+            }
+
+    };
+
+
+
+// echoes everything sent to its watched sockets
+class PollThread : public Thread {
+
+    public:
+
+        PollThread( SocketPoll *inPoll )
+            : mStopping( 0 ), mNumErrors( 0 ), mPoll( inPoll ) {
+            }
+
+
+        virtual void run() {
+            SocketOrServer *ready[ 64 ];
+            unsigned char buffer[ 64 ];
+
+            while( ! atomicLoad( &mStopping ) ) {
+                int numReady = mPoll->wait( ready, 64, 100 );
+
+                for( int r=0; r<numReady; r++ ) {
+                    int sock = ready[r]->sock->mNativeSocketID;
+
+                    int numRead = read( sock, buffer, sizeof( buffer ) );
+
+                    if( numRead <= 0 ||
+                        write( sock, buffer, numRead ) != numRead ) {
+                        mNumErrors++;
+                        }
+                    }
+                }
+            }
+
+
+        volatile int mStopping;
+
+        // only read after join
+        int mNumErrors;
+
+
+    protected:
+
+        SocketPoll *mPoll;
+
+    };
+
+
+
+class PollTest : public StressTest {
+
+    public:
+
+        PollTest( int inNumThreads )
+            : StressTest( "poll" ), mPollThread( &mPoll ) {
+
+            for( int i=0; i<inNumThreads; i++ ) {
+                int pair[2];
+
+                if( socketpair( AF_UNIX, SOCK_STREAM, 0, pair ) != 0 ) {
+                    printf( "poll:  socketpair failed, running with %d "
+                            "threads\n", i );
+                    break;
+                    }
+
+                Socket *watched = new Socket();
+                watched->mNativeSocketID = pair[0];
+
+                mWatched.push_back( watched );
+                mOtherEnds.push_back( pair[1] );
+
+                mPoll.addSocket( watched, NULL );
+
+                mWorkers.push_back( new PollWorker( pair[1] ) );
+                }
+            }
+
+
+        virtual ~PollTest() {
+            for( int i=0; i<mWatched.size(); i++ ) {
+                Socket *watched = mWatched.getElementDirect( i );
+
+                mPoll.removeSocket( watched );
+                // closes our end
+                delete watched;
+
+                close( mOtherEnds.getElementDirect( i ) );
+                }
+            }
+
+
+        virtual void start() {
+            mPollThread.start();
+            StressTest::start();
+            }
+
+
+        virtual void stop() {
+            StressTest::stop();
+
+            atomicStore( &( mPollThread.mStopping ), 1 );
+            mPollThread.join();
+            }
+
+
+        virtual void check() {
+            if( mPollThread.mNumErrors > 0 ) {
+                printf( "poll:  %d read or write errors in poll thread\n",
+                        mPollThread.mNumErrors );
+                mNumBadChecks++;
+                }
+            }
+
+
+    protected:
+
+        SocketPoll mPoll;
+        PollThread mPollThread;
+
+        SimpleVector<Socket*> mWatched;
+        SimpleVector<int> mOtherEnds;
+
+    };
+
+
+
+// web
+
+static const char *stressPageBody =
+    "stressTest page, long enough to take more than one small read:  "
+    "0123456789012345678901234567890123456789012345678901234567890123"
+    "0123456789012345678901234567890123456789012345678901234567890123"
+    "0123456789012345678901234567890123456789012345678901234567890123\n";
+
+
+
+class StressPageGenerator : public PageGenerator {
+
+    public:
+
+        virtual void generatePage( char *inGetRequestPath,
+                                   OutputStream *inOutputStream ) {
+            inOutputStream->writeString( (char *)stressPageBody );
+            }
+
+
+        virtual char *getMimeType( char *inGetRequestPath ) {
+            return stringDuplicate( "text/plain" );
+            }
+
+    };
+
+
+
+class WebWorker : public StressWorker {
+
+    public:
+
+        WebWorker( int inPort, int inNumInFlight )
+            : mNumInFlight( inNumInFlight ),
+              mRequests( new WebRequest*[ inNumInFlight ] ),
+              mStartNS( new int64_t[ inNumInFlight ] ) {
+
+            mURL = autoSprintf( "http://127.0.0.1:%d/stress", inPort );
+
+            for( int i=0; i<mNumInFlight; i++ ) {
+                mRequests[i] = NULL;
+                mStartNS[i] = 0;
+                }
+            }
+
+
+        virtual ~WebWorker() {
+            for( int i=0; i<mNumInFlight; i++ ) {
+                if( mRequests[i] != NULL ) {
+                    delete mRequests[i];
+                    }
+                }
+            delete [] mRequests;
+            delete [] mStartNS;
+            delete [] mURL;
+            }
+
+
+    protected:
+
+        int mNumInFlight;
+        WebRequest **mRequests;
+        int64_t *mStartNS;
+
+        char *mURL;
+
+
+        virtual void doWork() {
+            char anyDone = false;
+
+            for( int i=0; i<mNumInFlight; i++ ) {
+                if( mRequests[i] == NULL ) {
+                    mStartNS[i] = Time::getMonotonicNanoseconds();
+                    mRequests[i] = new WebRequest( "GET", mURL, NULL );
+                    }
+
+                int result = mRequests[i]->step();
+
+                if( result == 0 ) {
+                    continue;
+                    }
+
+                if( result == 1 ) {
+                    char *page = mRequests[i]->getResult();
+
+                    if( page != NULL &&
+                        strcmp( page, stressPageBody ) == 0 ) {
+                        recordOperation( mStartNS[i] );
+                        }
+                    else {
+                        recordError();
+                        }
+
+                    if( page != NULL ) {
+                        delete [] page;
+                        }
+                    }
+                else {
+                    recordError();
+                    }
+
+                delete mRequests[i];
+                mRequests[i] = NULL;
+                anyDone = true;
+                }
+
+            if( ! anyDone ) {
+                // steps don't block, so don't spin against the server
+                Thread::staticSleep( 1 );
+                }
+            }
+
+    };
+
+
+
+class WebTest : public StressTest {
+
+    public:
+
+        WebTest( int inNumInFlight, int inPort, int inNumServerThreads )
+            : StressTest( "web" ) {
+
+            // the server only answers hosts listed in its settings
+            mkdir( "stressTestSettings", 0755 );
+            SettingsManager::setDirectoryName( "stressTestSettings" );
+            SettingsManager::setSetting( "allowedWebHosts", "127.0.0.*" );
+
+            mServer = new WebServer( inPort, new StressPageGenerator(),
+                                     inNumServerThreads );
+
+            // let every request in flight keep its connection
+            WebRequest::setIdleConnectionLimits( inNumInFlight,
+                                                 inNumInFlight, 30 );
+
+            mWorkers.push_back( new WebWorker( inPort, inNumInFlight ) );
+            }
+
+
+        virtual ~WebTest() {
+            if( mServer != NULL ) {
+                delete mServer;
+                }
+            }
+
+
+        virtual void stop() {
+            StressTest::stop();
+
+            int reused, made;
+            WebRequest::getConnectionCounts( &reused, &made );
+
+            printf( "web:  %d connections made, %d reused\n",
+                    made, reused );
+
+            WebRequest::closeIdleConnections();
+
+            // destruction stops and joins
+            delete mServer;
+            mServer = NULL;
+            }
+
+
+    protected:
+
+        WebServer *mServer;
+
+    };
+
+
+
+// log
+
+class LogWorker : public StressWorker {
+
+    public:
+
+        LogWorker( Log *inLog, int inID, int inBurst )
+            : mLog( inLog ), mID( inID ), mBurst( inBurst ),
+              mNumLogged( 0 ) {
+            }
+
+
+    protected:
+
+        Log *mLog;
+        int mID;
+        int mBurst;
+        int mNumLogged;
+
+
+        virtual void doWork() {
+            for( int i=0; i<mBurst; i++ ) {
+                int64_t startNS = Time::getMonotonicNanoseconds();
+
+                mLog->logString( "stressTest", Log::INFO_LEVEL,
+                                 "thread %d message %d", mID, mNumLogged );
+                mNumLogged++;
+
+                recordOperation( startNS );
+                }
+
+            // bounded rate, so an hours-long run doesn't fill the disk
+            Thread::staticSleep( 1 );
+            }
+
+    };
+
+
+
+class LogTest : public StressTest {
+
+    public:
+
+        LogTest( int inNumThreads, int inBurst )
+            : StressTest( "log" ),
+              // replace the backup every minute, to bound disk use
+              mLog( new AsyncFileLog( "stressTest.log", 60 ) ) {
+
+            mLog->setLoggingLevel( Log::INFO_LEVEL );
+
+            for( int i=0; i<inNumThreads; i++ ) {
+                mWorkers.push_back( new LogWorker( mLog, i, inBurst ) );
+                }
+            }
+
+
+        virtual ~LogTest() {
+            if( mLog != NULL ) {
+                delete mLog;
+                }
+            }
+
+
+        virtual void stop() {
+            StressTest::stop();
+
+            // writes anything still queued
+            delete mLog;
+            mLog = NULL;
+            }
+
+
+    protected:
+
+        AsyncFileLog *mLog;
+
+    };
+
+
+
+// reporting
+
+static double getLatencyPercentileMicroseconds( int64_t *inBinCounts,
+                                                int64_t inTotal,
+                                                double inFraction ) {
+    if( inTotal == 0 ) {
+        return 0;
+        }
+
+    int64_t target = (int64_t)( inFraction * inTotal );
+    if( target >= inTotal ) {
+        target = inTotal - 1;
+        }
+
+    int64_t seen = 0;
+    for( int b=0; b<NUM_LATENCY_BINS; b++ ) {
+        seen += inBinCounts[b];
+
+        if( seen > target ) {
+            // upper edge of bin
+            return getLatencyBinStart( b + 1 ) / 1000.0;
+            }
+        }
+
+    return getLatencyBinStart( NUM_LATENCY_BINS ) / 1000.0;
+    }
+
+
+
+static void printReportHeader() {
+    printf( "%8s  %-9s  %10s  %9s  %9s  %9s  %9s  %9s  %7s\n",
+            "seconds", "test", "ops/sec", "p50 us", "p90 us", "p99 us",
+            "p99.9 us", "max us", "errors" );
+    }
+
+
+
+static void printReportLine( double inSeconds, const char *inName,
+                             int64_t *inBinCounts, double inInterval,
+                             int64_t inNumErrors ) {
+    int64_t total = 0;
+    int maxBin = -1;
+
+    for( int b=0; b<NUM_LATENCY_BINS; b++ ) {
+        total += inBinCounts[b];
+        if( inBinCounts[b] > 0 ) {
+            maxBin = b;
+            }
+        }
+
+    printf( "%8.0f  %-9s  %10.0f  %9.2f  %9.2f  %9.2f  %9.2f  %9.2f  %7lld\n",
+            inSeconds, inName,
+            inInterval > 0 ? total / inInterval : 0,
+            getLatencyPercentileMicroseconds( inBinCounts, total, 0.5 ),
+            getLatencyPercentileMicroseconds( inBinCounts, total, 0.9 ),
+            getLatencyPercentileMicroseconds( inBinCounts, total, 0.99 ),
+            getLatencyPercentileMicroseconds( inBinCounts, total, 0.999 ),
+            maxBin < 0 ? 0 : getLatencyBinStart( maxBin + 1 ) / 1000.0,
+            (long long)inNumErrors );
+    }
+
+
+
+// prints one interval line for a test
+static void reportInterval( StressTest *inTest, double inSeconds,
+                            double inInterval ) {
+    int64_t binCounts[ NUM_LATENCY_BINS ];
+    int64_t numErrors;
+
+    inTest->getTotals( binCounts, &numErrors );
+
+    int64_t intervalCounts[ NUM_LATENCY_BINS ];
+
+    for( int b=0; b<NUM_LATENCY_BINS; b++ ) {
+        intervalCounts[b] = binCounts[b] - inTest->mLastBinCounts[b];
+        inTest->mLastBinCounts[b] = binCounts[b];
+        }
+
+    printReportLine( inSeconds, inTest->mName, intervalCounts, inInterval,
+                     numErrors - inTest->mLastNumErrors );
+
+    inTest->mLastNumErrors = numErrors;
+    }
+
+
+
+// watchdog:  reports workers that have stalled or recovered
+// returns true if every worker in the test is stalled
+static char checkForStalls( StressTest *inTest, double inSeconds,
+                            int64_t inStallNS ) {
+    int64_t now = Time::getMonotonicNanoseconds();
+
+    int numStalled = 0;
+
+    for( int i=0; i<inTest->mWorkers.size(); i++ ) {
+        StressWorker *w = inTest->mWorkers.getElementDirect( i );
+
+        int64_t idleNS = now - atomicLoad64( &( w->mLastProgressNS ) );
+
+        if( idleNS > inStallNS ) {
+            if( ! w->mStalled ) {
+                printf( "%8.0f  %-9s  STALL:  worker %d has made no "
+                        "progress for %.1f seconds\n",
+                        inSeconds, inTest->mName, i, idleNS / 1.0e9 );
+                w->mStalled = true;
+                }
+            numStalled++;
+            }
+        else if( w->mStalled ) {
+            printf( "%8.0f  %-9s  worker %d recovered\n",
+                    inSeconds, inTest->mName, i );
+            w->mStalled = false;
+            }
+        }
+
+    return ( numStalled > 0 && numStalled == inTest->mWorkers.size() );
+    }
+
+
+
+static void usage() {
+    printf( "Usage:  stressTest [options] [test ...]\n"
+            "Tests:  mutex semaphore poll web log (default all)\n"
+            "Options:\n"
+            "  -seconds N         run length (default 60)\n"
+            "  -threads N         threads per test, or web requests in "
+            "flight (default 4)\n"
+            "  -report N          seconds between reports (default 10)\n"
+            "  -stall N           seconds without progress before a "
+            "worker is stalled\n"
+            "                     (default 10)\n"
+            "  -port N            web test port (default 18123)\n"
+            "  -serverThreads N   WebServer worker threads, 0 for thread "
+            "per connection\n"
+            "                     (default 4)\n"
+            "  -logBurst N        messages per log thread per millisecond "
+            "(default 10)\n" );
+    }
+
+
+
+int main( int inNumArgs, char **inArgs ) {
+
+    double runSeconds = 60;
+    int numThreads = 4;
+    double reportSeconds = 10;
+    double stallSeconds = 10;
+    int port = 18123;
+    int numServerThreads = 4;
+    int logBurst = 10;
+
+    SimpleVector<const char*> testNames;
+
+    for( int i=1; i<inNumArgs; i++ ) {
+        const char *arg = inArgs[i];
+
+        if( arg[0] != '-' ) {
+            testNames.push_back( arg );
+            continue;
+            }
+
+        if( i + 1 >= inNumArgs ) {
+            usage();
+            return 1;
+            }
+
+        const char *value = inArgs[ ++i ];
+
+        if( strcmp( arg, "-seconds" ) == 0 ) {
+            runSeconds = atof( value );
+            }
+        else if( strcmp( arg, "-threads" ) == 0 ) {
+            numThreads = atoi( value );
+            }
+        else if( strcmp( arg, "-report" ) == 0 ) {
+            reportSeconds = atof( value );
+            }
+        else if( strcmp( arg, "-stall" ) == 0 ) {
+            stallSeconds = atof( value );
+            }
+        else if( strcmp( arg, "-port" ) == 0 ) {
+            port = atoi( value );
+            }
+        else if( strcmp( arg, "-serverThreads" ) == 0 ) {
+            numServerThreads = atoi( value );
+            }
+        else if( strcmp( arg, "-logBurst" ) == 0 ) {
+            logBurst = atoi( value );
+            }
+        else {
+            usage();
+            return 1;
+            }
+        }
+
+    if( numThreads < 1 || reportSeconds <= 0 || stallSeconds <= 0 ) {
+        usage();
+        return 1;
+        }
+
+
+    const char *allNames[] = { "mutex", "semaphore", "poll", "web", "log" };
+
+    if( testNames.size() == 0 ) {
+        for( int i=0; i<5; i++ ) {
+            testNames.push_back( allNames[i] );
+            }
+        }
+
+
+    // a server closing a connection mid-send shouldn't kill us
+    signal( SIGPIPE, SIG_IGN );
+    signal( SIGINT, handleInterrupt );
+
+
+    SimpleVector<StressTest*> tests;
+
+    for( int i=0; i<testNames.size(); i++ ) {
+        const char *name = testNames.getElementDirect( i );
+
+        if( strcmp( name, "mutex" ) == 0 ) {
+            tests.push_back( new MutexTest( numThreads ) );
+            }
+        else if( strcmp( name, "semaphore" ) == 0 ) {
+            tests.push_back( new SemaphoreTest( numThreads ) );
+            }
+        else if( strcmp( name, "poll" ) == 0 ) {
+            tests.push_back( new PollTest( numThreads ) );
+            }
+        else if( strcmp( name, "web" ) == 0 ) {
+            tests.push_back( new WebTest( numThreads, port,
+                                          numServerThreads ) );
+            }
+        else if( strcmp( name, "log" ) == 0 ) {
+            tests.push_back( new LogTest( numThreads, logBurst ) );
+            }
+        else {
+            printf( "Unknown test:  %s\n", name );
+            usage();
+            return 1;
+            }
+        }
+
+
+    printf( "Running %d test(s) for %.0f seconds, %d threads each\n\n",
+            tests.size(), runSeconds, numThreads );
+
+    for( int i=0; i<tests.size(); i++ ) {
+        tests.getElementDirect( i )->start();
+        }
+
+    printReportHeader();
+
+
+    int64_t stallNS = (int64_t)( stallSeconds * 1.0e9 );
+
+    double startTime = Time::getMonotonicTime();
+    double lastReportTime = startTime;
+
+    char deadlocked = false;
+
+    while( ! interrupted && ! deadlocked ) {
+        double now = Time::getMonotonicTime();
+
+        if( now - startTime >= runSeconds ) {
+            break;
+            }
+
+        // watch for stalls more often than we report
+        for( int i=0; i<tests.size(); i++ ) {
+            StressTest *test = tests.getElementDirect( i );
+
+            if( checkForStalls( test, now - startTime, stallNS ) ) {
+                printf( "%8.0f  %-9s  DEADLOCK?  all %d workers are "
+                        "stalled\n",
+                        now - startTime, test->mName,
+                        test->mWorkers.size() );
+                deadlocked = true;
+                }
+            }
+
+        if( now - lastReportTime >= reportSeconds ) {
+            for( int i=0; i<tests.size(); i++ ) {
+                reportInterval( tests.getElementDirect( i ),
+                                now - startTime, now - lastReportTime );
+                }
+            fflush( stdout );
+
+            lastReportTime = now;
+            }
+
+        Thread::staticSleep( 100 );
+        }
+
+
+    if( deadlocked ) {
+        // stalled workers can't be joined
+        fflush( stdout );
+        _exit( 2 );
+        }
+
+
+    // stop everything at once, so that totals cover the same time
+    for( int i=0; i<tests.size(); i++ ) {
+        tests.getElementDirect( i )->requestStop();
+        }
+
+    // last partial interval
+    double endTime = Time::getMonotonicTime();
+    if( endTime - lastReportTime > 0.5 ) {
+        for( int i=0; i<tests.size(); i++ ) {
+            reportInterval( tests.getElementDirect( i ),
+                            endTime - startTime, endTime - lastReportTime );
+            }
+        }
+
+    printf( "\n" );
+
+    for( int i=0; i<tests.size(); i++ ) {
+        tests.getElementDirect( i )->stop();
+        }
+
+
+    printf( "\nTotals:\n" );
+    printReportHeader();
+
+    int numBad = 0;
+
+    for( int i=0; i<tests.size(); i++ ) {
+        StressTest *test = tests.getElementDirect( i );
+
+        test->check();
+
+        int64_t binCounts[ NUM_LATENCY_BINS ];
+        int64_t numErrors;
+
+        test->getTotals( binCounts, &numErrors );
+
+        printReportLine( endTime - startTime, test->mName, binCounts,
+                         endTime - startTime, numErrors );
+
+        if( numErrors > 0 || test->mNumBadChecks > 0 ) {
+            numBad++;
+            }
+
+        delete test;
+        }
+
+
+    if( numBad == 0 ) {
+        printf( "\nAll tests passed\n" );
+        return 0;
+        }
+    printf( "\n%d test(s) had errors\n", numBad );
+    return 1;
+    }
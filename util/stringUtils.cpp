@@ -44,6 +44,16 @@
  *
  * 2018-July-19    Jason Rohrer
  * 2x faster in-place tokenizeString implementation.
+ *
+ * 2026-October-14    Jason Rohrer
+ * join, concatonate, and replaceAll allocate their result only once.
+ * Added autoSprintfInto for formatting into caller storage.
+ * Added StringView tokenizing and splitting that does not copy tokens.
+ *
+ * 2026-October-15    Jason Rohrer
+ * Case-insensitive locate and compare no longer copy their arguments.
+ * Locate scans 16 characters at a time with SSE2 or NEON.
+ * stringViewToInt fails on numbers outside int range.
  */
 
 
@@ -52,6 +62,21 @@
 
 
 #include <stdlib.h>
+#include <limits.h>
+
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || \
+    ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+    #define STRING_UTILS_SSE2
+    #include <emmintrin.h>
+#elif defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+    #define STRING_UTILS_NEON
+    #include <arm_neon.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 
 
@@ -86,30 +111,174 @@ char *stringToUpperCase( const char *inString  ) {
 
 
 
+// ASCII lower case, same as tolower in the C locale
+static inline unsigned char foldCase( unsigned char inC ) {
+    if( (unsigned char)( inC - 'A' ) < 26 ) {
+        return inC | 0x20;
+        }
+    return inC;
+    }
+
+
+
+// true if inLength characters match, ignoring case
+static inline char foldedEqual( const char *inA, const char *inB,
+                                int inLength ) {
+    for( int i=0; i<inLength; i++ ) {
+        if( foldCase( inA[i] ) != foldCase( inB[i] ) ) {
+            return false;
+            }
+        }
+    return true;
+    }
+
+
+
+#if defined( STRING_UTILS_SSE2 ) || defined( STRING_UTILS_NEON )
+
+// index of lowest set bit, inBits must be non-zero
+static inline int lowestBit( unsigned int inBits ) {
+#if defined( __GNUC__ )
+    return __builtin_ctz( inBits );
+#elif defined( _MSC_VER )
+    unsigned long index;
+    _BitScanForward( &index, inBits );
+    return (int)index;
+#else
+    int index = 0;
+    while( ( inBits & 1 ) == 0 ) {
+        inBits >>= 1;
+        index++;
+        }
+    return index;
+#endif
+    }
+
+#endif
+
+
+
 char *stringLocateIgnoreCase( const char *inHaystack,
                               const char *inNeedle ) {
 
-    char *lowerHaystack = stringToLowerCase( inHaystack );
-    char *lowerNeedle = stringToLowerCase( inNeedle );
-
-    char *matchPointer = strstr( lowerHaystack, lowerNeedle );
+    int needleLength = strlen( inNeedle );
+    
+    if( needleLength == 0 ) {
+        // like strstr
+        return (char*)inHaystack;
+        }
+    
+    int haystackLength = strlen( inHaystack );
 
-    char *returnString = NULL;
+    // last place a match could start
+    int lastStart = haystackLength - needleLength;
     
-    if( matchPointer != NULL ) {
+    unsigned char first = foldCase( inNeedle[0] );
+    unsigned char last = foldCase( inNeedle[ needleLength - 1 ] );
 
-        unsigned int matchRemainderLength = strlen( matchPointer );
+    int i = 0;
+    
 
-        unsigned int haystackIndex = 
-            strlen( inHaystack ) -  matchRemainderLength;
+#if defined( STRING_UTILS_SSE2 ) || defined( STRING_UTILS_NEON )
+
+    // Candidates are where both the first and last needle characters
+    // match, checked for 16 starting places at once.
+    // For a lower-case letter L, ( c | 0x20 ) == L only when c is L or
+    // its upper case, so OR-ing in 0x20 folds case exactly for that
+    // letter.  Other characters must match as they are.
+    unsigned char firstFold = 
+        ( (unsigned char)( first - 'a' ) < 26 ) ? 0x20 : 0;
+    unsigned char lastFold = 
+        ( (unsigned char)( last - 'a' ) < 26 ) ? 0x20 : 0;
     
-        returnString =  (char*)( &( inHaystack[ haystackIndex ] ) );
+    // inner characters, since first and last already match
+    const char *needleMiddle = &( inNeedle[1] );
+    int middleLength = needleLength - 2;
+    if( middleLength < 0 ) {
+        middleLength = 0;
         }
+    
+#ifdef STRING_UTILS_SSE2
+    __m128i firstTarget = _mm_set1_epi8( (char)first );
+    __m128i lastTarget = _mm_set1_epi8( (char)last );
+    __m128i firstFoldBits = _mm_set1_epi8( (char)firstFold );
+    __m128i lastFoldBits = _mm_set1_epi8( (char)lastFold );
+#else
+    uint8x16_t firstTarget = vdupq_n_u8( first );
+    uint8x16_t lastTarget = vdupq_n_u8( last );
+    uint8x16_t firstFoldBits = vdupq_n_u8( firstFold );
+    uint8x16_t lastFoldBits = vdupq_n_u8( lastFold );
+#endif
 
-    delete [] lowerHaystack;
-    delete [] lowerNeedle;
+    // blocks stay inside haystack:  the last block ends at
+    // lastStart + 15 + needleLength - 1 < haystackLength
+    for( ; i + 15 <= lastStart; i += 16 ) {
+        const char *blockStart = &( inHaystack[i] );
+        
+#ifdef STRING_UTILS_SSE2
+        __m128i firstBlock = _mm_loadu_si128( (const __m128i *)blockStart );
+        __m128i lastBlock = _mm_loadu_si128( 
+            (const __m128i *)( blockStart + needleLength - 1 ) );
+        
+        __m128i hits = _mm_and_si128(
+            _mm_cmpeq_epi8( _mm_or_si128( firstBlock, firstFoldBits ),
+                            firstTarget ),
+            _mm_cmpeq_epi8( _mm_or_si128( lastBlock, lastFoldBits ),
+                            lastTarget ) );
+        
+        unsigned int mask = _mm_movemask_epi8( hits );
+#else
+        uint8x16_t firstBlock = vld1q_u8( (const uint8_t *)blockStart );
+        uint8x16_t lastBlock = vld1q_u8( 
+            (const uint8_t *)( blockStart + needleLength - 1 ) );
+        
+        uint8x16_t hits = vandq_u8(
+            vceqq_u8( vorrq_u8( firstBlock, firstFoldBits ), firstTarget ),
+            vceqq_u8( vorrq_u8( lastBlock, lastFoldBits ), lastTarget ) );
 
-    return returnString;
+        // no movemask on NEON, so check halves before looking at bytes
+        uint64x2_t halves = vreinterpretq_u64_u8( hits );
+        
+        unsigned int mask = 0;
+        
+        if( ( vgetq_lane_u64( halves, 0 ) | vgetq_lane_u64( halves, 1 ) )
+            != 0 ) {
+            
+            uint8_t hitBytes[16];
+            vst1q_u8( hitBytes, hits );
+            
+            for( int b=0; b<16; b++ ) {
+                mask |= (unsigned int)( hitBytes[b] & 1 ) << b;
+                }
+            }
+#endif
+        
+        while( mask != 0 ) {
+            int offset = lowestBit( mask );
+            
+            if( foldedEqual( &( blockStart[ offset + 1 ] ), needleMiddle,
+                             middleLength ) ) {
+                return (char*)&( blockStart[ offset ] );
+                }
+            
+            // clear lowest bit
+            mask &= mask - 1;
+            }
+        }
+
+#endif
+    
+
+    // remaining starting places one at a time
+    for( ; i <= lastStart; i++ ) {
+        if( foldCase( inHaystack[i] ) == first &&
+            foldedEqual( &( inHaystack[i] ), inNeedle, needleLength ) ) {
+            
+            return (char*)&( inHaystack[i] );
+            }
+        }
+    
+    return NULL;
     }
 
 
@@ -117,15 +286,20 @@ char *stringLocateIgnoreCase( const char *inHaystack,
 int stringCompareIgnoreCase( const char *inStringA,
                              const char *inStringB ) {
 
-    char *lowerA = stringToLowerCase( inStringA );
-    char *lowerB = stringToLowerCase( inStringB );
-
-    int returnVal = strcmp( lowerA, lowerB );
-
-    delete [] lowerB;
-    delete [] lowerA;
+    const unsigned char *a = (const unsigned char *)inStringA;
+    const unsigned char *b = (const unsigned char *)inStringB;
+    
+    while( true ) {
+        unsigned char foldedA = foldCase( *a );
+        unsigned char foldedB = foldCase( *b );
 
-    return returnVal;
+        if( foldedA != foldedB || foldedA == '\0' ) {
+            // same sign as strcmp of lower-case copies
+            return (int)foldedA - (int)foldedB;
+            }
+        a++;
+        b++;
+        }
     }
 
 
@@ -189,16 +363,37 @@ char **split( const char *inString, const char *inSeparator,
 
 
 char *join( char **inStrings, int inNumParts, const char *inGlue ) {
-    SimpleVector<char> result;
+    if( inNumParts <= 0 ) {
+        return stringDuplicate( "" );
+        }
+
+    // size it all first, so result is allocated once and filled in place
+    unsigned int glueLength = strlen( inGlue );
 
-    for( int i=0; i<inNumParts - 1; i++ ) {
-        result.appendElementString( inStrings[i] );
-        result.appendElementString( inGlue );
+    unsigned int totalLength = glueLength * ( inNumParts - 1 );
+
+    for( int i=0; i<inNumParts; i++ ) {
+        totalLength += strlen( inStrings[i] );
         }
-    // no glue after last string
-    result.appendElementString( inStrings[ inNumParts - 1 ] );
 
-    char *returnString = result.getElementString();
+    char *returnString = new char[ totalLength + 1 ];
+
+    char *end = returnString;
+
+    for( int i=0; i<inNumParts; i++ ) {
+        if( i > 0 ) {
+            // no glue before first string
+            memcpy( end, inGlue, glueLength );
+            end += glueLength;
+            }
+        
+        unsigned int partLength = strlen( inStrings[i] );
+
+        memcpy( end, inStrings[i], partLength );
+        end += partLength;
+        }
+
+    *end = '\0';
 
     return returnString;
     }
@@ -206,15 +401,15 @@ char *join( char **inStrings, int inNumParts, const char *inGlue ) {
 
 
 char *concatonate( const char *inStringA, const char *inStringB ) {
-    char **tempArray = new char*[2];
-    tempArray[ 0 ] = (char *)inStringA;
-    tempArray[ 1 ] = (char *)inStringB;
+    unsigned int lengthA = strlen( inStringA );
+    unsigned int lengthB = strlen( inStringB );
 
-    char *result = join( tempArray, 2, "" );
+    char *returnString = new char[ lengthA + lengthB + 1 ];
 
-    delete [] tempArray;
+    memcpy( returnString, inStringA, lengthA );
+    memcpy( &( returnString[ lengthA ] ), inStringB, lengthB + 1 );
 
-    return result;
+    return returnString;
     }
     
 
@@ -276,36 +471,61 @@ char *replaceAll( const char *inHaystack, const char *inTarget,
                   const char *inSubstitute,
                   char *outFound ) {
 
-    // repeatedly replace once until replacing fails
+    unsigned int targetLength = strlen( inTarget );
+
+    if( targetLength == 0 ) {
+        // nothing to find
+        *outFound = false;
+        return stringDuplicate( inHaystack );
+        }
     
-    char lastFound = true;
-    char atLeastOneFound = false;
-    char *returnString = stringDuplicate( inHaystack );
+    // count occurrences first, so result is allocated once instead of
+    // once per replacement
+    int numFound = 0;
 
-    int skip = 0;
+    const char *match = strstr( inHaystack, inTarget );
     
-    while( lastFound ) {
-        
-        int nextSkip;
-        
-        char *nextReturnString =
-            replaceOnce( returnString, inTarget, inSubstitute, &lastFound,
-                         skip, &nextSkip );
+    while( match != NULL ) {
+        numFound++;
+        match = strstr( &( match[ targetLength ] ), inTarget );
+        }
+
+    if( numFound == 0 ) {
+        *outFound = false;
+        return stringDuplicate( inHaystack );
+        }
 
-        skip = nextSkip;
+    *outFound = true;
 
-        delete [] returnString;
+    unsigned int substituteLength = strlen( inSubstitute );
+
+    char *returnString = new char[ strlen( inHaystack ) 
+                                   - numFound * targetLength
+                                   + numFound * substituteLength + 1 ];
+    
+    char *end = returnString;
+    const char *haystackPosition = inHaystack;
+
+    match = strstr( haystackPosition, inTarget );
+    
+    while( match != NULL ) {
+        unsigned int skippedLength = match - haystackPosition;
         
-        returnString = nextReturnString;
+        memcpy( end, haystackPosition, skippedLength );
+        end += skippedLength;
 
-        if( lastFound ) {
-            atLeastOneFound = true;
-            }
+        memcpy( end, inSubstitute, substituteLength );
+        end += substituteLength;
+
+        haystackPosition = &( match[ targetLength ] );
+        
+        match = strstr( haystackPosition, inTarget );
         }
 
-    *outFound = atLeastOneFound;
+    // rest of haystack, along with \0
+    strcpy( end, haystackPosition );
     
-    return returnString;    
+    return returnString;
     }
 
 
@@ -455,6 +675,217 @@ SimpleVector<char *> *tokenizeStringInPlace( char *inString ) {
 
 
 
+char nextToken( const char **inOutStringPointer, StringView *outToken ) {
+    const unsigned char *c = (const unsigned char *)*inOutStringPointer;
+
+    // same separators as tokenizeString:  everything at or below space
+    while( *c != '\0' && *c <= ' ' ) {
+        c++;
+        }
+
+    if( *c == '\0' ) {
+        *inOutStringPointer = (const char *)c;
+        return false;
+        }
+    
+    const unsigned char *tokenStart = c;
+    
+    while( *c > ' ' ) {
+        c++;
+        }
+    
+    outToken->start = (const char *)tokenStart;
+    outToken->length = c - tokenStart;
+    
+    *inOutStringPointer = (const char *)c;
+
+    return true;
+    }
+
+
+
+int tokenizeStringViews( const char *inString, 
+                         SimpleVector<StringView> *outTokens ) {
+    int numAdded = 0;
+    
+    StringView token;
+    
+    while( nextToken( &inString, &token ) ) {
+        outTokens->push_back( token );
+        numAdded++;
+        }
+    
+    return numAdded;
+    }
+
+
+
+char nextSplitPart( const char **inOutStringPointer, const char *inSeparator,
+                    StringView *outPart ) {
+    const char *partStart = *inOutStringPointer;
+
+    if( partStart == NULL ) {
+        return false;
+        }
+
+    outPart->start = partStart;
+
+    const char *foundSeparator = NULL;
+
+    if( inSeparator[0] != '\0' ) {
+        foundSeparator = strstr( partStart, inSeparator );
+        }
+    
+    if( foundSeparator == NULL ) {
+        // last part, even if it is empty
+        outPart->length = strlen( partStart );
+        *inOutStringPointer = NULL;
+        }
+    else {
+        outPart->length = foundSeparator - partStart;
+        *inOutStringPointer = &( foundSeparator[ strlen( inSeparator ) ] );
+        }
+    
+    return true;
+    }
+
+
+
+int splitViews( const char *inString, const char *inSeparator,
+                SimpleVector<StringView> *outParts ) {
+    int numAdded = 0;
+    
+    StringView part;
+    
+    while( nextSplitPart( &inString, inSeparator, &part ) ) {
+        outParts->push_back( part );
+        numAdded++;
+        }
+    
+    return numAdded;
+    }
+
+
+
+char stringViewEquals( StringView inView, const char *inString ) {
+    return strncmp( inView.start, inString, inView.length ) == 0 &&
+        inString[ inView.length ] == '\0';
+    }
+
+
+
+char *stringViewDuplicate( StringView inView ) {
+    char *returnString = new char[ inView.length + 1 ];
+    
+    memcpy( returnString, inView.start, inView.length );
+    returnString[ inView.length ] = '\0';
+
+    return returnString;
+    }
+
+
+
+int stringViewToInt( StringView inView, char *outSuccess ) {
+    const char *c = inView.start;
+    const char *end = &( inView.start[ inView.length ] );
+    
+    char negative = false;
+    
+    if( c < end && ( *c == '-' || *c == '+' ) ) {
+        negative = ( *c == '-' );
+        c++;
+        }
+    
+    if( c == end ) {
+        if( outSuccess != NULL ) {
+            *outSuccess = false;
+            }
+        return 0;
+        }
+    
+    // accumulate unsigned, so INT_MIN doesn't overflow
+    unsigned int value = 0;
+    
+    // magnitude of INT_MIN is one more than INT_MAX
+    unsigned int limit = (unsigned int)INT_MAX;
+    if( negative ) {
+        limit += 1;
+        }
+    
+    while( c < end ) {
+        if( *c < '0' || *c > '9' ) {
+            if( outSuccess != NULL ) {
+                *outSuccess = false;
+                }
+            return 0;
+            }
+        
+        unsigned int digit = (unsigned int)( *c - '0' );
+        
+        if( value > ( limit - digit ) / 10 ) {
+            // out of int range
+            if( outSuccess != NULL ) {
+                *outSuccess = false;
+                }
+            return 0;
+            }
+        
+        value = value * 10 + digit;
+        c++;
+        }
+    
+    if( outSuccess != NULL ) {
+        *outSuccess = true;
+        }
+
+    if( negative ) {
+        return (int)( 0U - value );
+        }
+    return (int)value;
+    }
+
+
+
+double stringViewToDouble( StringView inView, char *outSuccess ) {
+    
+    // view isn't terminated, and strtod might read past its end,
+    // so parse a terminated copy
+    // (on the stack unless the number is absurdly long)
+    char stackBuffer[64];
+    char *buffer = stackBuffer;
+    
+    if( inView.length >= (int)sizeof( stackBuffer ) ) {
+        buffer = new char[ inView.length + 1 ];
+        }
+
+    memcpy( buffer, inView.start, inView.length );
+    buffer[ inView.length ] = '\0';
+
+    char *parseEnd;
+    double value = strtod( buffer, &parseEnd );
+    
+    char success = 
+        ( inView.length > 0 && parseEnd == &( buffer[ inView.length ] ) );
+
+    if( buffer != stackBuffer ) {
+        delete [] buffer;
+        }
+
+    if( outSuccess != NULL ) {
+        *outSuccess = success;
+        }
+    
+    if( ! success ) {
+        return 0;
+        }
+    return value;
+    }
+
+
+
+
+
+
 char *trimWhitespace( char *inString ) {
     
     // trim start
@@ -622,6 +1053,60 @@ char *vautoSprintf( const char* inFormatString, va_list inArgList ) {
 
 
 
+int autoSprintfInto( char *outBuffer, int inBufferSize,
+                     const char* inFormatString, ... ) {
+    va_list argList;
+    va_start( argList, inFormatString );
+    
+    int result = 
+        vautoSprintfInto( outBuffer, inBufferSize, inFormatString, argList );
+    
+    va_end( argList );
+    
+    return result;
+    }
+
+
+
+int vautoSprintfInto( char *outBuffer, int inBufferSize,
+                      const char* inFormatString, va_list inArgList ) {
+    
+    va_list argListCopy;
+    va_copy( argListCopy, inArgList );
+    
+    int stringLength =
+        vsnprintf( outBuffer, inBufferSize, inFormatString, argListCopy );
+    
+    va_end( argListCopy );
+
+    if( stringLength == -1 || stringLength == inBufferSize ) {
+        // old ANSI or buggy MinGW vsnprintf (see vautoSprintf above)
+        // doesn't tell us the full length, or might not have written the \0
+
+        // rare, just have vautoSprintf find the size
+        char *fullString = vautoSprintf( inFormatString, inArgList );
+        
+        stringLength = strlen( fullString );
+
+        if( inBufferSize > 0 ) {
+            int copyLength = stringLength;
+
+            if( copyLength > inBufferSize - 1 ) {
+                copyLength = inBufferSize - 1;
+                }
+            memcpy( outBuffer, fullString, copyLength );
+            outBuffer[ copyLength ] = '\0';
+            }
+        
+        delete [] fullString;
+        }
+    
+    return stringLength;
+    }
+
+
+
+
 int scanIntAndSkip( char **inOutStringPointer,
                     char *outSuccess ) {
 
@@ -63,6 +63,13 @@
  *
  * 2018-July-19    Jason Rohrer
  * tokenizeStringInPlace is 3x faster.
+ *
+ * 2026-October-14    Jason Rohrer
+ * Added autoSprintfInto for formatting into caller storage.
+ * Added StringView tokenizing and splitting that does not copy tokens.
+ *
+ * 2026-October-15    Jason Rohrer
+ * Case-insensitive locate and compare no longer allocate.
  */
 
 
@@ -135,7 +142,11 @@ char *stringToUpperCase( const char *inString  );
 
 
 /**
- * Searches for the first occurrence of one string in another.
+ * Searches for the first occurrence of one string in another, ignoring
+ * the case of ASCII letters (like tolower in the C locale).
+ *
+ * Allocates nothing.  To search for many strings at once, see
+ * MultiStringMatcher.
  *
  * @param inHaystack the \0-terminated string to search in.
  *   Must be destroyed by caller if non-const.
@@ -151,7 +162,8 @@ char *stringLocateIgnoreCase( const char *inHaystack,
 
 
 /**
- * Compares two strings, ignoring case.
+ * Compares two strings, ignoring the case of ASCII letters.
+ * Allocates nothing.
  *
  * @param inStringA the first \0-terminated string.
  *   Must be destroyed by caller if non-const.
@@ -342,6 +354,117 @@ SimpleVector<char *> *tokenizeStringInPlace( char *inString );
 
 
 
+/**
+ * A span of characters inside some other string, NOT \0-terminated.
+ *
+ * Views are only valid as long as the string they point into.
+ */
+typedef struct StringView {
+        const char *start;
+        int length;
+    } StringView;
+
+SIMPLE_VECTOR_TRIVIAL_TYPE( StringView )
+
+
+
+/**
+ * Gets the next whitespace-separated token from a string, without copying
+ * or modifying anything.
+ *
+ * Separators are the same as for tokenizeString.
+ *
+ * Example:
+ *
+ * const char *next = message;
+ * StringView token;
+ *
+ * while( nextToken( &next, &token ) ) {
+ *     ...
+ *     }
+ *
+ * @param inOutStringPointer pointer to a pointer into a \0-terminated
+ *   string.  The pointed-to pointer is advanced past the token.
+ * @param outToken where the token should be returned.
+ *
+ * @return true if a token was found, or false at the end of the string.
+ */
+char nextToken( const char **inOutStringPointer, StringView *outToken );
+
+
+/**
+ * Finds all whitespace-separated tokens in a string, without copying them.
+ *
+ * Appends to outTokens, which callers can clear and re-use across
+ * messages so that nothing is allocated per token.
+ *
+ * @return the number of tokens added.
+ */
+int tokenizeStringViews( const char *inString, 
+                         SimpleVector<StringView> *outTokens );
+
+
+
+/**
+ * Gets the next part of a string split around a separator string,
+ * without copying or modifying anything.
+ *
+ * Parts follow the same rules as split (empty parts are returned for
+ * leading, trailing, and repeated separators).
+ *
+ * @param inOutStringPointer pointer to a pointer into a \0-terminated
+ *   string.  The pointed-to pointer is advanced past the part, and set
+ *   to NULL after the last part.
+ * @param inSeparator the separator string.
+ * @param outPart where the part should be returned.
+ *
+ * @return true if a part was found, or false if *inOutStringPointer was
+ *   already NULL.
+ */
+char nextSplitPart( const char **inOutStringPointer, const char *inSeparator,
+                    StringView *outPart );
+
+
+/**
+ * Splits a string around a separator string, without copying the parts.
+ *
+ * Appends to outParts.
+ *
+ * @return the number of parts added (always at least 1).
+ */
+int splitViews( const char *inString, const char *inSeparator,
+                SimpleVector<StringView> *outParts );
+
+
+
+// true if view has exactly the same characters as inString
+char stringViewEquals( StringView inView, const char *inString );
+
+
+// returns a newly allocated, \0-terminated copy of a view's characters
+// must be destroyed by caller
+char *stringViewDuplicate( StringView inView );
+
+
+
+/**
+ * Parses a decimal integer (with optional sign) that fills a whole view.
+ *
+ * @param outSuccess optional pointer to where success flag should be
+ *   returned, or NULL.  Parsing fails if the view is empty, has any
+ *   non-digit characters, or holds a number outside the range of int.
+ *
+ * @return the parsed integer, or 0 on failure.
+ */
+int stringViewToInt( StringView inView, char *outSuccess = NULL );
+
+
+// same as above, but parses a floating point number like strtod
+double stringViewToDouble( StringView inView, char *outSuccess = NULL );
+
+
+
+
 /**
  * Trim whitespace characters from the start and end of a string.
  *
@@ -378,6 +501,35 @@ char *vautoSprintf( const char* inFormatString, va_list inArgList );
 
 
 
+/**
+ * Prints formatted data elements into a caller-supplied buffer, without
+ * allocating anything (in the common case).
+ *
+ * Like C99 snprintf:  output is cut short (but still \0-terminated) if
+ * it doesn't fit, and the full length is returned either way, so the
+ * caller can check for truncation and retry with a bigger buffer.
+ *
+ * For building up longer strings piece by piece, see StringBuilder.
+ *
+ * @param outBuffer where the \0-terminated string should be printed.
+ * @param inBufferSize the size of outBuffer, including room for the \0.
+ * @param inFormatString the format string to print from.
+ * @param variable argument list data values to fill in the format string
+ *   with (uses same conventions as printf).
+ *
+ * @return the length of the full printed string, not counting the \0.
+ *   If this is inBufferSize or more, the output was truncated.
+ */
+int autoSprintfInto( char *outBuffer, int inBufferSize,
+                     const char* inFormatString, ... );
+
+
+// same as above, but takes a va_list directly
+int vautoSprintfInto( char *outBuffer, int inBufferSize,
+                      const char* inFormatString, va_list inArgList );
+
+
+
 /**
  * Fast scanning of a series of integers from a string that are separated
  * by single characters.
@@ -0,0 +1,120 @@
+/*
+ * Modification History
+ *
+ * 2026-October-14   Jason Rohrer
+ * Created.
+ */
+
+/**
+ * Checks crc32 against a plain bit-at-a-time CRC, and measures its
+ * throughput.
+ */
+
+
+#include "minorGems/util/crc32.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+
+
+static unsigned int bitwiseCRC32( const unsigned char *inData, int inLength ) {
+    unsigned int crc = ~0U;
+    
+    for( int i=0; i<inLength; i++ ) {
+        crc ^= inData[i];
+        for( int b=0; b<8; b++ ) {
+            crc = ( crc >> 1 ) ^ ( 0xEDB88320U & ( 0U - ( crc & 1 ) ) );
+            }
+        }
+    return crc ^ ~0U;
+    }
+
+
+
+static double getSeconds() {
+    return (double)clock() / CLOCKS_PER_SEC;
+    }
+
+
+
+int main() {
+    int bufferLength = 1 << 24;
+    
+    unsigned char *buffer = new unsigned char[ bufferLength ];
+    
+    unsigned int x = 12345;
+    for( int i=0; i<bufferLength; i++ ) {
+        x = x * 1103515245U + 12345U;
+        buffer[i] = (unsigned char)( x >> 16 );
+        }
+    
+
+    int failures = 0;
+
+    if( crc32( (const unsigned char *)"123456789", 9 ) != 0xCBF43926U ) {
+        printf( "Check value wrong\n" );
+        failures++;
+        }
+
+    // all alignments and lots of lengths, in one piece and in two
+    for( int offset=0; offset<16; offset++ ) {
+        for( int length=0; length<2000; length += 1 + length / 8 ) {
+            
+            unsigned int expected = 
+                bitwiseCRC32( &( buffer[offset] ), length );
+
+            if( crc32( &( buffer[offset] ), length ) != expected ) {
+                printf( "Mismatch at offset %d, length %d\n", 
+                        offset, length );
+                failures++;
+                }
+            
+            int split = length / 3;
+            
+            unsigned int crc = crc32Update( 0, &( buffer[offset] ), split );
+            crc = crc32Update( crc, &( buffer[offset + split] ), 
+                               length - split );
+
+            if( crc != expected ) {
+                printf( "Incremental mismatch at offset %d, length %d\n", 
+                        offset, length );
+                failures++;
+                }
+            }
+        }
+    
+
+    int blockLengths[4] = { 64, 4096, 65536, bufferLength };
+
+    for( int b=0; b<4; b++ ) {
+        int numRuns = ( 1 << 30 ) / blockLengths[b];
+
+        unsigned int sum = 0;
+        
+        double startTime = getSeconds();
+        
+        for( int r=0; r<numRuns; r++ ) {
+            int offset = 
+                ( r * blockLengths[b] ) % ( bufferLength - blockLengths[b] + 1 );
+            
+            sum += crc32( &( buffer[offset] ), blockLengths[b] );
+            }
+        
+        double seconds = getSeconds() - startTime;
+        
+        printf( "%9d byte blocks:  %.2f GB/s  (%08X)\n", blockLengths[b],
+                (double)numRuns * blockLengths[b] / seconds / 1e9, sum );
+        }
+
+    delete [] buffer;
+    
+    if( failures > 0 ) {
+        printf( "%d failures\n", failures );
+        return 1;
+        }
+    
+    printf( "All checks passed\n" );
+    return 0;
+    }
@@ -0,0 +1,268 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+/**
+ * Checks SettingsManager write-behind:  reads see new values right away,
+ * bursts of sets are coalesced into one write, writes happen after the
+ * delay (and no later than twice the delay for a setting that keeps
+ * changing), flushAll and getSettingsFile write pending values, and no
+ * temporary files are left behind.  Also times a burst of sets with and
+ * without a delay.
+ *
+ * Run from an empty directory; makes and removes settingsWriteBehindTest/.
+ */
+
+
+#include "minorGems/util/SettingsManager.h"
+#include "minorGems/util/stringUtils.h"
+#include "minorGems/io/file/File.h"
+#include "minorGems/system/Thread.h"
+#include "minorGems/system/Time.h"
+
+#include <stdio.h>
+#include <string.h>
+
+
+
+#define DIR_NAME "settingsWriteBehindTest"
+
+
+static int numBad = 0;
+
+
+
+// contents of a setting's file, or NULL if it doesn't exist
+static char *readFile( const char *inSettingName,
+                       const char *inExtension = "ini" ) {
+    char *name = autoSprintf( DIR_NAME "/%s.%s", inSettingName, inExtension );
+
+    File file( NULL, name );
+    delete [] name;
+
+    return file.readFileContents();
+    }
+
+
+
+static void checkFile( const char *inSettingName, const char *inExpected,
+                       const char *inWhat ) {
+    char *contents = readFile( inSettingName );
+
+    if( inExpected == NULL ) {
+        if( contents != NULL ) {
+            printf( "%s: %s.ini holds '%s', expected no file\n",
+                    inWhat, inSettingName, contents );
+            numBad++;
+            delete [] contents;
+            }
+        return;
+        }
+
+    if( contents == NULL ) {
+        printf( "%s: %s.ini missing, expected '%s'\n",
+                inWhat, inSettingName, inExpected );
+        numBad++;
+        return;
+        }
+
+    if( strcmp( contents, inExpected ) != 0 ) {
+        printf( "%s: %s.ini holds '%s', expected '%s'\n",
+                inWhat, inSettingName, contents, inExpected );
+        numBad++;
+        }
+    delete [] contents;
+    }
+
+
+
+static void checkInt( const char *inSettingName, int inExpected,
+                      const char *inWhat ) {
+    int value = SettingsManager::getIntSetting( inSettingName, -1 );
+
+    if( value != inExpected ) {
+        printf( "%s: read %d from %s, expected %d\n",
+                inWhat, value, inSettingName, inExpected );
+        numBad++;
+        }
+    }
+
+
+
+static void removeAll() {
+    File dir( NULL, DIR_NAME );
+
+    if( ! dir.exists() ) {
+        return;
+        }
+
+    int numChildren;
+    File **children = dir.getChildFiles( &numChildren );
+
+    for( int i=0; i<numChildren; i++ ) {
+        char *name = children[i]->getFileName();
+
+        if( strstr( name, ".tmp" ) != NULL ) {
+            printf( "Temporary file %s left behind\n", name );
+            numBad++;
+            }
+        delete [] name;
+
+        children[i]->remove();
+        delete children[i];
+        }
+    delete [] children;
+
+    dir.remove();
+    }
+
+
+
+int main() {
+    removeAll();
+
+    File dir( NULL, DIR_NAME );
+    dir.makeDirectory();
+
+    SettingsManager::setDirectoryName( DIR_NAME );
+
+
+    // no delay:  written before set returns
+    SettingsManager::setSetting( "sync", 5 );
+    checkFile( "sync", "5", "No delay" );
+    checkInt( "sync", 5, "No delay" );
+
+    SettingsManager::setSetting( "sync", 6 );
+    checkFile( "sync", "6", "No delay replace" );
+
+
+    SettingsManager::setWriteDelay( 0.2 );
+
+    // burst of sets, one write
+    for( int i=0; i<=100; i++ ) {
+        SettingsManager::setSetting( "burst", i );
+        }
+    checkInt( "burst", 100, "Burst read" );
+    checkFile( "burst", NULL, "Burst before delay" );
+
+    Thread::staticSleep( 400 );
+    checkFile( "burst", "100", "Burst after delay" );
+    checkInt( "burst", 100, "Burst read after write" );
+
+
+    // keeps changing, still written by twice the delay
+    double startTime = Time::getMonotonicTime();
+    int lastValue = 0;
+    char writtenInTime = false;
+
+    while( Time::getMonotonicTime() - startTime < 0.8 ) {
+        SettingsManager::setSetting( "slider", ++lastValue );
+        Thread::staticSleep( 20 );
+
+        char *contents = readFile( "slider" );
+        if( contents != NULL ) {
+            if( Time::getMonotonicTime() - startTime < 0.5 ) {
+                writtenInTime = true;
+                }
+            delete [] contents;
+            }
+        }
+    if( ! writtenInTime ) {
+        printf( "Changing setting not written within twice the delay\n" );
+        numBad++;
+        }
+
+
+    // explicit flush
+    SettingsManager::setSetting( "flushed", "hello" );
+    checkFile( "flushed", NULL, "Before flushAll" );
+    SettingsManager::flushAll();
+    checkFile( "flushed", "hello", "After flushAll" );
+    char *sliderString = autoSprintf( "%d", lastValue );
+    checkFile( "slider", sliderString, "Slider flushed" );
+    delete [] sliderString;
+
+
+    // direct file access sees pending value
+    SettingsManager::setSetting( "direct", 42 );
+    FILE *f = SettingsManager::getSettingsFile( "direct", "r" );
+    int directValue = -1;
+    if( f != NULL ) {
+        fscanf( f, "%d", &directValue );
+        fclose( f );
+        }
+    if( directValue != 42 ) {
+        printf( "getSettingsFile read %d, expected 42\n", directValue );
+        numBad++;
+        }
+
+
+    // cache off, still reads pending value
+    SettingsManager::setCacheRecheckInterval( -1 );
+    SettingsManager::setSetting( "uncached", 7 );
+    checkInt( "uncached", 7, "Uncached pending" );
+    SettingsManager::setCacheRecheckInterval( 1 );
+
+
+    // hashing, written with hash after the delay
+    SettingsManager::setHashSalt( "test_salt" );
+    SettingsManager::setHashingOn( true );
+
+    SettingsManager::setSetting( "hashed", 9 );
+    checkInt( "hashed", 9, "Hashed pending" );
+
+    SettingsManager::flushAll();
+    SettingsManager::clearCache();
+    checkInt( "hashed", 9, "Hashed after write" );
+
+    char *hash = readFile( "hashed", "hash" );
+    if( hash == NULL ) {
+        printf( "Hash file missing\n" );
+        numBad++;
+        }
+    else {
+        delete [] hash;
+        }
+    SettingsManager::setHashingOn( false );
+
+
+    // timing, burst of sets like a slider drag
+    int numSets = 1000;
+
+    SettingsManager::setWriteDelay( 0 );
+
+    startTime = Time::getMonotonicTime();
+    for( int i=0; i<numSets; i++ ) {
+        SettingsManager::setSetting( "timed", i );
+        }
+    double syncTime = Time::getMonotonicTime() - startTime;
+
+    SettingsManager::setWriteDelay( 0.5 );
+
+    startTime = Time::getMonotonicTime();
+    for( int i=0; i<numSets; i++ ) {
+        SettingsManager::setSetting( "timed", i );
+        }
+    double delayedTime = Time::getMonotonicTime() - startTime;
+
+    SettingsManager::flushAll();
+    char *timedString = autoSprintf( "%d", numSets - 1 );
+    checkFile( "timed", timedString, "Timed flushed" );
+    delete [] timedString;
+
+    printf( "%d sets of one setting:  %.4f s written each time, "
+            "%.4f s coalesced\n", numSets, syncTime, delayedTime );
+
+
+    removeAll();
+
+    if( numBad == 0 ) {
+        printf( "All tests passed\n" );
+        return 0;
+        }
+    printf( "%d failures\n", numBad );
+    return 1;
+    }
@@ -0,0 +1,339 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+/**
+ * Checks stringLocateIgnoreCase and stringCompareIgnoreCase against
+ * lower-casing copies (the old way), checks MultiStringMatcher against a
+ * search for each pattern, and times filtering messages against a word
+ * list each way.
+ */
+
+
+#include "minorGems/util/stringUtils.h"
+#include "minorGems/util/MultiStringMatcher.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+
+static int numBad = 0;
+
+
+
+static char *oldLocate( const char *inHaystack, const char *inNeedle ) {
+    char *lowerHaystack = stringToLowerCase( inHaystack );
+    char *lowerNeedle = stringToLowerCase( inNeedle );
+
+    char *match = strstr( lowerHaystack, lowerNeedle );
+
+    char *result = NULL;
+    if( match != NULL ) {
+        result = (char*)&( inHaystack[ match - lowerHaystack ] );
+        }
+
+    delete [] lowerHaystack;
+    delete [] lowerNeedle;
+
+    return result;
+    }
+
+
+
+static int sign( int inX ) {
+    return ( inX > 0 ) - ( inX < 0 );
+    }
+
+
+
+static int oldCompare( const char *inA, const char *inB ) {
+    char *lowerA = stringToLowerCase( inA );
+    char *lowerB = stringToLowerCase( inB );
+
+    int result = strcmp( lowerA, lowerB );
+
+    delete [] lowerA;
+    delete [] lowerB;
+
+    return result;
+    }
+
+
+
+// small alphabet, so random strings match often
+static void randomString( char *outString, int inLength ) {
+    const char *alphabet = "aAbBcC@`[{ \xe9";
+
+    int alphabetLength = strlen( alphabet );
+
+    for( int i=0; i<inLength; i++ ) {
+        outString[i] = alphabet[ rand() % alphabetLength ];
+        }
+    outString[ inLength ] = '\0';
+    }
+
+
+
+static void randomWord( char *outString, int inLength ) {
+    for( int i=0; i<inLength; i++ ) {
+        outString[i] = (char)( 'a' + rand() % 26 );
+        if( rand() % 4 == 0 ) {
+            outString[i] = (char)toupper( outString[i] );
+            }
+        }
+    outString[ inLength ] = '\0';
+    }
+
+
+
+static double seconds() {
+    return (double)clock() / CLOCKS_PER_SEC;
+    }
+
+
+
+int main() {
+    srand( 12 );
+
+    char haystack[ 200 ];
+    char needle[ 20 ];
+
+
+    // single-string functions against old versions
+    for( int t=0; t<200000; t++ ) {
+        randomString( haystack, rand() % 120 );
+        randomString( needle, rand() % 6 );
+
+        if( oldLocate( haystack, needle ) !=
+            stringLocateIgnoreCase( haystack, needle ) ) {
+            printf( "Locate '%s' in '%s' differs\n", needle, haystack );
+            numBad++;
+            break;
+            }
+
+        if( sign( oldCompare( haystack, needle ) ) !=
+            sign( stringCompareIgnoreCase( haystack, needle ) ) ||
+            sign( oldCompare( needle, needle ) ) !=
+            sign( stringCompareIgnoreCase( needle, needle ) ) ) {
+            printf( "Compare '%s' to '%s' differs\n", needle, haystack );
+            numBad++;
+            break;
+            }
+        }
+
+    if( stringLocateIgnoreCase( "Connection: Keep-Alive", "keep-alive" )
+        == NULL ||
+        stringCompareIgnoreCase( "Content-Length", "content-length" )
+        != 0 ) {
+        printf( "Header checks failed\n" );
+        numBad++;
+        }
+
+
+    // matcher against searching for each pattern
+    for( int t=0; t<2000; t++ ) {
+        MultiStringMatcher matcher;
+
+        int numPatterns = 1 + rand() % 8;
+        for( int p=0; p<numPatterns; p++ ) {
+            randomString( needle, 1 + rand() % 4 );
+            matcher.addPattern( needle );
+            }
+
+        randomString( haystack, rand() % 60 );
+
+        // expected:  all matches, and which one ends first
+        int expectedCount = 0;
+        int firstEnd = -1;
+
+        for( int p=0; p<numPatterns; p++ ) {
+            const char *pattern = matcher.getPattern( p );
+            int length = strlen( pattern );
+
+            const char *start = haystack;
+            char *match;
+            while( ( match = stringLocateIgnoreCase( start, pattern ) )
+                   != NULL ) {
+                expectedCount++;
+
+                int end = ( match - haystack ) + length;
+                if( firstEnd == -1 || end < firstEnd ) {
+                    firstEnd = end;
+                    }
+                start = match + 1;
+                }
+            }
+
+        SimpleVector<MultiStringMatch> matches;
+        int count = matcher.findAll( haystack, &matches );
+
+        // duplicate patterns are reported once
+        int numDistinct = 0;
+        for( int p=0; p<numPatterns; p++ ) {
+            char duplicate = false;
+            for( int q=0; q<p; q++ ) {
+                if( stringCompareIgnoreCase( matcher.getPattern( p ),
+                                             matcher.getPattern( q ) )
+                    == 0 ) {
+                    duplicate = true;
+                    }
+                }
+            if( ! duplicate ) {
+                numDistinct++;
+                }
+            }
+
+        char allChecked = ( numDistinct == numPatterns );
+
+        if( allChecked && count != expectedCount ) {
+            printf( "findAll got %d matches, expected %d\n",
+                    count, expectedCount );
+            numBad++;
+            break;
+            }
+
+        for( int m=0; m<matches.size(); m++ ) {
+            MultiStringMatch match = matches.getElementDirect( m );
+            const char *pattern = matcher.getPattern( match.patternIndex );
+
+            if( match.length != (int)strlen( pattern ) ||
+                stringLocateIgnoreCase( &( haystack[ match.start ] ),
+                                        pattern ) !=
+                &( haystack[ match.start ] ) ) {
+                printf( "Bad match of '%s' at %d in '%s'\n",
+                        pattern, match.start, haystack );
+                numBad++;
+                break;
+                }
+            }
+
+        int patternIndex = -1;
+        char *first = matcher.locate( haystack, &patternIndex );
+
+        if( ( first == NULL ) != ( firstEnd == -1 ) ||
+            ( first != NULL &&
+              ( first - haystack ) +
+              (int)strlen( matcher.getPattern( patternIndex ) )
+              != firstEnd ) ) {
+            printf( "locate didn't find earliest-ending match in '%s'\n",
+                    haystack );
+            numBad++;
+            break;
+            }
+        }
+
+
+    MultiStringMatcher filter;
+    filter.addWordList( "  darn \n\nHeck\r\nfoo bar\n" );
+
+    if( filter.getNumPatterns() != 3 ||
+        strcmp( filter.getPattern( 2 ), "foo bar" ) != 0 ) {
+        printf( "Word list read wrong\n" );
+        numBad++;
+        }
+
+    char *masked = filter.maskMatches( "Oh DARN it, heckfoo Foo Bar!" );
+    if( strcmp( masked, "Oh **** it, ****foo *******!" ) != 0 ) {
+        printf( "Masked to '%s'\n", masked );
+        numBad++;
+        }
+    delete [] masked;
+
+    MultiStringMatcher caseSensitive( false );
+    caseSensitive.addPattern( "Heck" );
+    if( caseSensitive.containsAny( "heck" ) ||
+        ! caseSensitive.containsAny( "oh Heck" ) ) {
+        printf( "Case-sensitive matching wrong\n" );
+        numBad++;
+        }
+
+
+    // timing, a word list against chat-length messages
+    int numWords = 500;
+    int numMessages = 2000;
+
+    SimpleVector<char *> words;
+    MultiStringMatcher wordMatcher;
+
+    for( int w=0; w<numWords; w++ ) {
+        char word[ 12 ];
+        randomWord( word, 4 + rand() % 6 );
+        words.push_back( stringDuplicate( word ) );
+        wordMatcher.addPattern( word );
+        }
+    wordMatcher.compile();
+
+    char **messages = new char*[ numMessages ];
+    for( int m=0; m<numMessages; m++ ) {
+        messages[m] = new char[ 81 ];
+        randomWord( messages[m], 80 );
+        }
+
+    int oldFound = 0;
+    double startTime = seconds();
+    for( int m=0; m<numMessages; m++ ) {
+        for( int w=0; w<numWords; w++ ) {
+            if( oldLocate( messages[m], words.getElementDirect( w ) )
+                != NULL ) {
+                oldFound++;
+                break;
+                }
+            }
+        }
+    double oldTime = seconds() - startTime;
+
+    int newFound = 0;
+    startTime = seconds();
+    for( int m=0; m<numMessages; m++ ) {
+        for( int w=0; w<numWords; w++ ) {
+            if( stringLocateIgnoreCase( messages[m],
+                                        words.getElementDirect( w ) )
+                != NULL ) {
+                newFound++;
+                break;
+                }
+            }
+        }
+    double newTime = seconds() - startTime;
+
+    int matcherFound = 0;
+    startTime = seconds();
+    for( int m=0; m<numMessages; m++ ) {
+        if( wordMatcher.containsAny( messages[m] ) ) {
+            matcherFound++;
+            }
+        }
+    double matcherTime = seconds() - startTime;
+
+    if( oldFound != newFound || oldFound != matcherFound ) {
+        printf( "Filters disagree:  %d, %d, %d messages matched\n",
+                oldFound, newFound, matcherFound );
+        numBad++;
+        }
+
+    printf( "%d 80-character messages against %d words "
+            "(%d messages matched):\n"
+            "  copying locate %.3f s, locate %.3f s, matcher %.4f s\n",
+            numMessages, numWords, matcherFound,
+            oldTime, newTime, matcherTime );
+
+    for( int m=0; m<numMessages; m++ ) {
+        delete [] messages[m];
+        }
+    delete [] messages;
+    words.deallocateStringElements();
+
+
+    if( numBad == 0 ) {
+        printf( "All tests passed\n" );
+        return 0;
+        }
+    printf( "%d failures\n", numBad );
+    return 1;
+    }
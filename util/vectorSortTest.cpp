@@ -0,0 +1,305 @@
+/*
+ * Modification History
+ *
+ * 2026-October-15   Jason Rohrer
+ * Created.
+ */
+
+/**
+ * Checks SimpleVector sort, stableSort, lowerBound, upperBound,
+ * binarySearch, and insertSorted against simple reference versions on
+ * random, sorted, reversed, and few-distinct-key inputs, then times sort
+ * against qsort and binarySearch against getElementIndex.
+ *
+ * Compile from above the minorGems directory with:
+ *   g++ -O2 -I. minorGems/util/vectorSortTest.cpp
+ *     minorGems/system/unix/TimeUnix.cpp -o vectorSortTest
+ */
+
+#include "SimpleVector.h"
+#include "minorGems/system/Time.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+
+
+static int numBad = 0;
+
+
+
+typedef struct Keyed {
+        int key;
+        // original position, for checking stability
+        int order;
+    } Keyed;
+
+SIMPLE_VECTOR_TRIVIAL_TYPE( Keyed )
+
+
+struct KeyLess {
+        bool operator()( const Keyed &inA, const Keyed &inB ) const {
+            return inA.key < inB.key;
+            }
+    };
+
+
+struct Greater {
+        bool operator()( int inA, int inB ) const {
+            return inA > inB;
+            }
+    };
+
+
+
+static int compareInts( const void *inA, const void *inB ) {
+    int a = *( (const int *)inA );
+    int b = *( (const int *)inB );
+
+    return ( a > b ) - ( a < b );
+    }
+
+
+
+// inKind 0 random, 1 sorted, 2 reversed, 3 few distinct keys,
+// 4 sorted with a few swaps
+static void fill( SimpleVector<int> *outVector, int inLength, int inKind ) {
+    outVector->deleteAll();
+
+    for( int i=0; i<inLength; i++ ) {
+        int x = rand();
+
+        switch( inKind ) {
+            case 1:
+                x = i;
+                break;
+            case 2:
+                x = inLength - i;
+                break;
+            case 3:
+                x = rand() % 4;
+                break;
+            }
+        outVector->push_back( x );
+        }
+
+    if( inKind == 4 ) {
+        for( int i=0; i<inLength; i++ ) {
+            *( outVector->getElementFast( i ) ) = i;
+            }
+        for( int s=0; s<3 && inLength > 1; s++ ) {
+            outVector->swap( rand() % inLength, rand() % inLength );
+            }
+        }
+    }
+
+
+
+static void checkSorts( int inLength, int inKind ) {
+    SimpleVector<int> v;
+    fill( &v, inLength, inKind );
+
+    SimpleVector<int> expected = v;
+    if( inLength > 0 ) {
+        qsort( expected.getElementFast( 0 ), inLength, sizeof( int ),
+               compareInts );
+        }
+
+    SimpleVector<int> sorted = v;
+    sorted.sort();
+
+    SimpleVector<int> stable = v;
+    stable.stableSort();
+
+    SimpleVector<int> descending = v;
+    descending.sort( Greater() );
+
+    for( int i=0; i<inLength; i++ ) {
+        int e = expected.getElementDirect( i );
+
+        if( sorted.getElementDirect( i ) != e ||
+            stable.getElementDirect( i ) != e ||
+            descending.getElementDirect( inLength - 1 - i ) != e ) {
+            printf( "Sort of %d elements (kind %d) wrong at %d\n",
+                    inLength, inKind, i );
+            numBad++;
+            return;
+            }
+        }
+
+
+    // stability, with keys that repeat a lot
+    SimpleVector<Keyed> keyed;
+    for( int i=0; i<inLength; i++ ) {
+        Keyed k = { v.getElementDirect( i ) % 16, i };
+        keyed.push_back( k );
+        }
+    keyed.stableSort( KeyLess() );
+
+    for( int i=1; i<inLength; i++ ) {
+        Keyed a = keyed.getElementDirect( i - 1 );
+        Keyed b = keyed.getElementDirect( i );
+
+        if( a.key > b.key || ( a.key == b.key && a.order > b.order ) ) {
+            printf( "Stable sort of %d elements (kind %d) unstable at %d\n",
+                    inLength, inKind, i );
+            numBad++;
+            return;
+            }
+        }
+
+
+    // searches against linear scans
+    for( int t=0; t<20; t++ ) {
+        int x;
+        if( inLength > 0 && t % 2 == 0 ) {
+            x = sorted.getElementDirect( rand() % inLength );
+            }
+        else {
+            x = rand() % ( inLength + 10 ) - 5;
+            }
+
+        int lower = 0;
+        while( lower < inLength && sorted.getElementDirect( lower ) < x ) {
+            lower++;
+            }
+        int upper = lower;
+        while( upper < inLength && sorted.getElementDirect( upper ) == x ) {
+            upper++;
+            }
+
+        int found = sorted.binarySearch( x );
+
+        if( sorted.lowerBound( x ) != lower ||
+            sorted.upperBound( x ) != upper ||
+            ( lower == upper && found != -1 ) ||
+            ( lower < upper && ( found < lower || found >= upper ) ) ) {
+            printf( "Search for %d in %d elements (kind %d) wrong\n",
+                    x, inLength, inKind );
+            numBad++;
+            return;
+            }
+        }
+    }
+
+
+
+int main() {
+    srand( 4 );
+
+    int lengths[] = { 0, 1, 2, 3, 16, 17, 33, 100, 1000, 5000 };
+
+    for( int l=0; l<10; l++ ) {
+        for( int kind=0; kind<5; kind++ ) {
+            checkSorts( lengths[l], kind );
+            }
+        }
+
+
+    // sorted insert keeps order, and goes after equal keys
+    SimpleVector<Keyed> inserted;
+    for( int i=0; i<500; i++ ) {
+        Keyed k = { rand() % 50, i };
+        inserted.insertSorted( k, KeyLess() );
+        }
+    for( int i=1; i<inserted.size(); i++ ) {
+        Keyed a = inserted.getElementDirect( i - 1 );
+        Keyed b = inserted.getElementDirect( i );
+
+        if( a.key > b.key || ( a.key == b.key && a.order > b.order ) ) {
+            printf( "insertSorted out of order at %d\n", i );
+            numBad++;
+            break;
+            }
+        }
+
+
+    // c-strings
+    SimpleVector<char *> words;
+    const char *list[] = { "pear", "apple", "fig", "banana", "cherry" };
+    for( int i=0; i<5; i++ ) {
+        words.push_back( (char *)list[i] );
+        }
+    words.sort( SimpleVectorStringLess() );
+
+    if( strcmp( words.getElementDirect( 0 ), "apple" ) != 0 ||
+        strcmp( words.getElementDirect( 4 ), "pear" ) != 0 ||
+        words.binarySearch( (char *)"fig", SimpleVectorStringLess() ) != 3 ||
+        words.binarySearch( (char *)"grape", SimpleVectorStringLess() )
+        != -1 ) {
+        printf( "String sort or search wrong\n" );
+        numBad++;
+        }
+
+
+    // timing
+    int n = 1000000;
+
+    SimpleVector<int> big;
+    fill( &big, n, 0 );
+
+    SimpleVector<int> copy = big;
+
+    double startTime = Time::getMonotonicTime();
+    qsort( copy.getElementFast( 0 ), n, sizeof( int ), compareInts );
+    double qsortTime = Time::getMonotonicTime() - startTime;
+
+    copy = big;
+    startTime = Time::getMonotonicTime();
+    copy.sort();
+    double sortTime = Time::getMonotonicTime() - startTime;
+
+    copy = big;
+    startTime = Time::getMonotonicTime();
+    copy.stableSort();
+    double stableTime = Time::getMonotonicTime() - startTime;
+
+
+    int numLookups = 2000;
+    int lookupSize = 10000;
+
+    SimpleVector<int> table;
+    for( int i=0; i<lookupSize; i++ ) {
+        table.push_back( i * 3 );
+        }
+
+    int linearFound = 0;
+    startTime = Time::getMonotonicTime();
+    for( int i=0; i<numLookups; i++ ) {
+        if( table.getElementIndex( ( i * 7919 ) % ( 3 * lookupSize ) )
+            != -1 ) {
+            linearFound++;
+            }
+        }
+    double linearTime = Time::getMonotonicTime() - startTime;
+
+    int binaryFound = 0;
+    startTime = Time::getMonotonicTime();
+    for( int i=0; i<numLookups; i++ ) {
+        if( table.binarySearch( ( i * 7919 ) % ( 3 * lookupSize ) )
+            != -1 ) {
+            binaryFound++;
+            }
+        }
+    double binaryTime = Time::getMonotonicTime() - startTime;
+
+    if( linearFound != binaryFound ) {
+        printf( "Lookups disagree:  %d vs %d found\n",
+                linearFound, binaryFound );
+        numBad++;
+        }
+
+    printf( "Sorting %d random ints:  qsort %.3f s, sort %.3f s, "
+            "stableSort %.3f s\n", n, qsortTime, sortTime, stableTime );
+    printf( "%d lookups in %d sorted ints:  getElementIndex %.4f s, "
+            "binarySearch %.5f s\n",
+            numLookups, lookupSize, linearTime, binaryTime );
+
+
+    if( numBad == 0 ) {
+        printf( "All tests passed\n" );
+        return 0;
+        }
+    printf( "%d failures\n", numBad );
+    return 1;
+    }